@@ -33,6 +33,7 @@ struct spdk_dd_opts {
 	int64_t		io_unit_size;
 	int64_t		io_unit_count;
 	uint32_t	queue_depth;
+	uint32_t	num_jobs;
 	bool		aio;
 	bool		sparse;
 };
@@ -40,6 +41,7 @@ struct spdk_dd_opts {
 static struct spdk_dd_opts g_opts = {
 	.io_unit_size = 4096,
 	.queue_depth = 2,
+	.num_jobs = 1,
 };
 
 enum dd_submit_type {
@@ -226,9 +228,8 @@ dd_show_progress(bool finish)
 	uint64_t milliseconds;
 	uint64_t size, tmp_size;
 
-	size = g_job.incremental_bytes;
-
-	g_job.incremental_bytes = 0;
+	/* Copy jobs running on other threads add to incremental_bytes concurrently */
+	size = __atomic_exchange_n(&g_job.incremental_bytes, 0, __ATOMIC_RELAXED);
 	g_job.total_bytes += size;
 
 	if (finish) {
@@ -1051,6 +1052,467 @@ dd_register_buffers(void)
 }
 #endif
 
+/* Minimum size of the interleaved stripes copied by each worker with --jobs */
+#define DD_STRIPE_MIN_SIZE (1024 * 1024)
+
+struct dd_worker;
+
+struct dd_worker_io {
+	struct dd_worker		*worker;
+	uint64_t			offset;
+	uint64_t			length;
+	void				*buf;
+	STAILQ_ENTRY(dd_worker_io)	link;
+};
+
+/*
+ * With --jobs, the copy range is split into stripes handed out round-robin to
+ * the workers, so that each of them sees a similar share of data and holes.
+ * Every worker runs on its own thread with its own channels, queue depth and
+ * buffers.
+ */
+struct dd_worker {
+	uint32_t			idx;
+	struct spdk_thread		*thread;
+	struct spdk_io_channel		*input_ch;
+	struct spdk_io_channel		*output_ch;
+	struct dd_worker_io		*ios;
+
+	/* Input offset of the next I/O and end of the stripe it belongs to */
+	uint64_t			pos;
+	uint64_t			stripe_end;
+
+	/* End of the data extent containing pos, only used with --sparse */
+	uint64_t			data_end;
+	bool				seeking;
+	STAILQ_HEAD(, dd_worker_io)	seek_queue;
+
+	/* I/Os with nothing left to do, the worker exits once all of them are */
+	uint32_t			idle;
+	int				rc;
+};
+
+static struct dd_worker *g_workers;
+static uint32_t g_num_workers;
+static uint32_t g_workers_running;
+static struct spdk_thread *g_app_thread;
+static uint64_t g_stripe_size;
+static uint64_t g_copy_start;
+static uint64_t g_copy_end;
+static bool g_copy_offload;
+
+static void dd_worker_next(struct dd_worker_io *io);
+static void dd_worker_seek(struct dd_worker *worker);
+
+/* Move the worker to the first offset of its own stripes at or after offset */
+static void
+dd_worker_set_pos(struct dd_worker *worker, uint64_t offset)
+{
+	uint64_t stripe, skip;
+
+	stripe = (offset - g_copy_start) / g_stripe_size;
+	skip = (worker->idx + g_num_workers - stripe % g_num_workers) % g_num_workers;
+	if (skip != 0) {
+		stripe += skip;
+		offset = g_copy_start + stripe * g_stripe_size;
+	}
+
+	worker->pos = spdk_min(offset, g_copy_end);
+	worker->stripe_end = spdk_min(g_copy_start + (stripe + 1) * g_stripe_size, g_copy_end);
+}
+
+static void
+dd_worker_exited(void *ctx)
+{
+	struct dd_worker *worker = ctx;
+
+	if (worker->rc != 0 && g_error == 0) {
+		g_error = worker->rc;
+	}
+
+	assert(g_workers_running > 0);
+	if (--g_workers_running > 0) {
+		return;
+	}
+
+	if (g_error == 0) {
+		dd_show_progress(true);
+		printf("\n\n");
+	}
+	dd_exit(g_error);
+}
+
+static void
+dd_worker_finish(struct dd_worker *worker)
+{
+	uint32_t i;
+
+	if (worker->ios != NULL) {
+		for (i = 0; i < g_opts.queue_depth; i++) {
+			spdk_free(worker->ios[i].buf);
+		}
+		free(worker->ios);
+		worker->ios = NULL;
+	}
+
+	if (worker->input_ch != NULL) {
+		spdk_put_io_channel(worker->input_ch);
+	}
+	if (worker->output_ch != NULL) {
+		spdk_put_io_channel(worker->output_ch);
+	}
+
+	spdk_thread_exit(worker->thread);
+	spdk_thread_send_msg(g_app_thread, dd_worker_exited, worker);
+}
+
+static void
+dd_worker_put_idle(struct dd_worker_io *io)
+{
+	struct dd_worker *worker = io->worker;
+
+	assert(worker->idle < g_opts.queue_depth);
+	if (++worker->idle == g_opts.queue_depth) {
+		dd_worker_finish(worker);
+	}
+}
+
+static void
+dd_worker_fail(struct dd_worker *worker, int rc)
+{
+	if (worker->rc == 0) {
+		SPDK_ERRLOG("Copy job %" PRIu32 " failed: %s\n", worker->idx, spdk_strerror(-rc));
+		worker->rc = rc;
+	}
+}
+
+static void
+_dd_worker_write_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dd_worker_io *io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (success) {
+		__atomic_fetch_add(&g_job.incremental_bytes, io->length, __ATOMIC_RELAXED);
+	} else {
+		dd_worker_fail(io->worker, -EIO);
+	}
+
+	dd_worker_next(io);
+}
+
+static uint64_t
+dd_worker_output_offset(struct dd_worker_io *io)
+{
+	return g_opts.output_offset * g_opts.io_unit_size + io->offset - g_copy_start;
+}
+
+static void
+dd_worker_write(struct dd_worker_io *io)
+{
+	struct dd_worker *worker = io->worker;
+	int rc;
+
+	if (worker->rc != 0 || g_interrupt) {
+		dd_worker_next(io);
+		return;
+	}
+
+	rc = spdk_bdev_write(g_job.output.u.bdev.desc, worker->output_ch, io->buf,
+			     dd_worker_output_offset(io), io->length, _dd_worker_write_done, io);
+	if (rc != 0) {
+		dd_worker_fail(worker, rc);
+		dd_worker_next(io);
+	}
+}
+
+static void
+_dd_worker_read_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dd_worker_io *io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		dd_worker_fail(io->worker, -EIO);
+		dd_worker_next(io);
+		return;
+	}
+
+	dd_worker_write(io);
+}
+
+static void
+dd_worker_submit(struct dd_worker_io *io)
+{
+	struct dd_worker *worker = io->worker;
+	uint32_t block_size = g_job.input.block_size;
+	int rc;
+
+	if (g_copy_offload) {
+		rc = spdk_bdev_copy_blocks(g_job.output.u.bdev.desc, worker->output_ch,
+					   dd_worker_output_offset(io) / block_size,
+					   io->offset / block_size, io->length / block_size,
+					   _dd_worker_write_done, io);
+	} else {
+		rc = spdk_bdev_read(g_job.input.u.bdev.desc, worker->input_ch, io->buf,
+				    io->offset, io->length, _dd_worker_read_done, io);
+	}
+
+	if (rc != 0) {
+		dd_worker_fail(worker, rc);
+		dd_worker_next(io);
+	}
+}
+
+static void
+dd_worker_next(struct dd_worker_io *io)
+{
+	struct dd_worker *worker = io->worker;
+
+	if (worker->rc != 0 || g_interrupt || worker->pos >= g_copy_end) {
+		dd_worker_put_idle(io);
+		return;
+	}
+
+	if (worker->pos >= worker->data_end) {
+		/* The I/O is resubmitted once the next data extent is found */
+		STAILQ_INSERT_TAIL(&worker->seek_queue, io, link);
+		if (!worker->seeking) {
+			dd_worker_seek(worker);
+		}
+		return;
+	}
+
+	io->offset = worker->pos;
+	io->length = spdk_min((uint64_t)g_opts.io_unit_size, worker->stripe_end - worker->pos);
+	io->length = spdk_min(io->length, worker->data_end - worker->pos);
+
+	worker->pos += io->length;
+	if (worker->pos >= worker->stripe_end) {
+		dd_worker_set_pos(worker, worker->pos);
+	}
+
+	dd_worker_submit(io);
+}
+
+static void
+dd_worker_seek_done(struct dd_worker *worker, int rc)
+{
+	STAILQ_HEAD(, dd_worker_io) ios = STAILQ_HEAD_INITIALIZER(ios);
+	struct dd_worker_io *io;
+
+	worker->seeking = false;
+	if (rc != 0) {
+		dd_worker_fail(worker, rc);
+	}
+
+	STAILQ_CONCAT(&ios, &worker->seek_queue);
+	while ((io = STAILQ_FIRST(&ios)) != NULL) {
+		STAILQ_REMOVE_HEAD(&ios, link);
+		dd_worker_next(io);
+	}
+}
+
+static void
+_dd_worker_seek_hole_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dd_worker *worker = cb_arg;
+	uint64_t offset_blocks = spdk_bdev_io_get_seek_offset(bdev_io);
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		dd_worker_seek_done(worker, -EIO);
+		return;
+	}
+
+	if (offset_blocks == UINT64_MAX) {
+		worker->data_end = g_copy_end;
+	} else if (offset_blocks * g_job.input.block_size <= worker->pos) {
+		/* The stripe we moved to starts with a hole, look for data again */
+		dd_worker_seek(worker);
+		return;
+	} else {
+		worker->data_end = spdk_min(offset_blocks * g_job.input.block_size, g_copy_end);
+	}
+
+	dd_worker_seek_done(worker, 0);
+}
+
+static void
+_dd_worker_seek_data_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dd_worker *worker = cb_arg;
+	uint64_t offset_blocks = spdk_bdev_io_get_seek_offset(bdev_io);
+	int rc;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		dd_worker_seek_done(worker, -EIO);
+		return;
+	}
+
+	if (offset_blocks == UINT64_MAX || offset_blocks * g_job.input.block_size >= g_copy_end) {
+		/* Only holes are left */
+		worker->pos = g_copy_end;
+		dd_worker_seek_done(worker, 0);
+		return;
+	}
+
+	if (offset_blocks * g_job.input.block_size > worker->pos) {
+		dd_worker_set_pos(worker, offset_blocks * g_job.input.block_size);
+		if (worker->pos >= g_copy_end) {
+			dd_worker_seek_done(worker, 0);
+			return;
+		}
+	}
+
+	rc = spdk_bdev_seek_hole(g_job.input.u.bdev.desc, worker->input_ch,
+				 worker->pos / g_job.input.block_size,
+				 _dd_worker_seek_hole_done, worker);
+	if (rc != 0) {
+		dd_worker_seek_done(worker, rc);
+	}
+}
+
+static void
+dd_worker_seek(struct dd_worker *worker)
+{
+	int rc;
+
+	worker->seeking = true;
+	rc = spdk_bdev_seek_data(g_job.input.u.bdev.desc, worker->input_ch,
+				 worker->pos / g_job.input.block_size,
+				 _dd_worker_seek_data_done, worker);
+	if (rc != 0) {
+		dd_worker_seek_done(worker, rc);
+	}
+}
+
+static void
+dd_worker_start(void *ctx)
+{
+	struct dd_worker *worker = ctx;
+	int socket_id = spdk_env_get_socket_id(spdk_env_get_current_core());
+	uint32_t i;
+
+	worker->input_ch = spdk_bdev_get_io_channel(g_job.input.u.bdev.desc);
+	worker->output_ch = spdk_bdev_get_io_channel(g_job.output.u.bdev.desc);
+	worker->ios = calloc(g_opts.queue_depth, sizeof(struct dd_worker_io));
+	if (worker->input_ch == NULL || worker->output_ch == NULL || worker->ios == NULL) {
+		dd_worker_fail(worker, -ENOMEM);
+		dd_worker_finish(worker);
+		return;
+	}
+
+	for (i = 0; i < g_opts.queue_depth; i++) {
+		worker->ios[i].worker = worker;
+		if (g_copy_offload) {
+			continue;
+		}
+
+		/* Keep the buffers local to the reactor running this worker */
+		worker->ios[i].buf = spdk_malloc(g_opts.io_unit_size, 0x1000, NULL, socket_id,
+						 SPDK_MALLOC_DMA);
+		if (worker->ios[i].buf == NULL) {
+			SPDK_ERRLOG("%s - try smaller block size value\n", strerror(ENOMEM));
+			dd_worker_fail(worker, -ENOMEM);
+			dd_worker_finish(worker);
+			return;
+		}
+	}
+
+	for (i = 0; i < g_opts.queue_depth; i++) {
+		dd_worker_next(&worker->ios[i]);
+	}
+}
+
+static void
+dd_run_workers(void)
+{
+	struct spdk_cpuset cpumask;
+	struct dd_worker *worker;
+	char name[32];
+	uint64_t num_stripes;
+	uint32_t core, i;
+
+	if (!g_opts.input_bdev || !g_opts.output_bdev) {
+		SPDK_ERRLOG("--jobs may be used only with --ib and --ob\n");
+		dd_exit(-EINVAL);
+		return;
+	}
+
+	if (g_job.input.block_size != g_job.output.block_size) {
+		SPDK_ERRLOG("--jobs requires equal input (%d) and output (%d) native block size\n",
+			    g_job.input.block_size, g_job.output.block_size);
+		dd_exit(-EINVAL);
+		return;
+	}
+
+	/* Offload the copy when the source and destination are the same bdev */
+	if (g_job.input.u.bdev.bdev == g_job.output.u.bdev.bdev &&
+	    spdk_bdev_io_type_supported(g_job.input.u.bdev.bdev, SPDK_BDEV_IO_TYPE_COPY)) {
+		SPDK_NOTICELOG("Using copy offload of %s\n", g_opts.input_bdev);
+		g_copy_offload = true;
+	}
+
+	g_copy_start = g_opts.input_offset * g_opts.io_unit_size;
+	g_copy_end = g_copy_start + g_job.copy_size;
+	g_stripe_size = spdk_max((uint64_t)g_opts.io_unit_size * g_opts.queue_depth,
+				 DD_STRIPE_MIN_SIZE);
+	g_stripe_size = SPDK_CEIL_DIV(g_stripe_size, g_opts.io_unit_size) * g_opts.io_unit_size;
+	num_stripes = SPDK_CEIL_DIV(g_job.copy_size, g_stripe_size);
+	g_num_workers = spdk_max(1, spdk_min(g_opts.num_jobs, num_stripes));
+
+	g_workers = calloc(g_num_workers, sizeof(struct dd_worker));
+	if (g_workers == NULL) {
+		SPDK_ERRLOG("%s\n", strerror(ENOMEM));
+		dd_exit(-ENOMEM);
+		return;
+	}
+
+	g_app_thread = spdk_get_thread();
+	clock_gettime(CLOCK_REALTIME, &g_job.start_time);
+	g_job.status_poller = SPDK_POLLER_REGISTER(dd_status_poller, NULL,
+			      STATUS_POLLER_PERIOD_SEC * SPDK_SEC_TO_USEC);
+
+	/* Spread the workers over the reactors */
+	core = spdk_env_get_first_core();
+	for (i = 0; i < g_num_workers; i++) {
+		worker = &g_workers[i];
+		worker->idx = i;
+		worker->data_end = g_opts.sparse ? 0 : UINT64_MAX;
+		STAILQ_INIT(&worker->seek_queue);
+		dd_worker_set_pos(worker, g_copy_start);
+
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, core, true);
+		snprintf(name, sizeof(name), "dd_job%" PRIu32, i);
+		worker->thread = spdk_thread_create(name, &cpumask);
+		if (worker->thread == NULL) {
+			SPDK_ERRLOG("Could not create thread for copy job %" PRIu32 "\n", i);
+			g_error = -ENOMEM;
+			g_interrupt = true;
+			break;
+		}
+
+		g_workers_running++;
+		spdk_thread_send_msg(worker->thread, dd_worker_start, worker);
+
+		core = spdk_env_get_next_core(core);
+		if (core == UINT32_MAX) {
+			core = spdk_env_get_first_core();
+		}
+	}
+
+	if (g_workers_running == 0) {
+		dd_exit(g_error);
+	}
+}
+
 static void
 dd_run(void *arg1)
 {
@@ -1155,6 +1617,11 @@ dd_run(void *arg1)
 		return;
 	}
 
+	if (g_opts.num_jobs > 1) {
+		dd_run_workers();
+		return;
+	}
+
 	g_job.ios = calloc(g_opts.queue_depth, sizeof(struct dd_io));
 	if (g_job.ios == NULL) {
 		SPDK_ERRLOG("%s\n", strerror(ENOMEM));
@@ -1244,6 +1711,7 @@ enum dd_cmdline_opts {
 	DD_OPTION_COUNT,
 	DD_OPTION_AIO,
 	DD_OPTION_SPARSE,
+	DD_OPTION_JOBS,
 };
 
 static struct option g_cmdline_opts[] = {
@@ -1325,6 +1793,12 @@ static struct option g_cmdline_opts[] = {
 		.flag = NULL,
 		.val = DD_OPTION_SPARSE,
 	},
+	{
+		.name = "jobs",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = DD_OPTION_JOBS,
+	},
 	{
 		.name = NULL
 	}
@@ -1347,6 +1821,9 @@ usage(void)
 	printf(" --seek Skip this many I/O units at start of output. (default: 0)\n");
 	printf(" --aio Force usage of AIO. (by default io_uring is used if available)\n");
 	printf(" --sparse Enable hole skipping in input target\n");
+	printf(" --jobs Number of parallel copy jobs, spread over the reactors given with -m.\n");
+	printf("        Each job uses its own queue depth and buffers. Requires --ib and --ob.\n");
+	printf("        (default: %" PRIu32 ")\n", g_opts.num_jobs);
 	printf(" Available iflag and oflag values:\n");
 	printf("  append - append mode\n");
 	printf("  direct - use direct I/O for data\n");
@@ -1402,6 +1879,9 @@ parse_args(int argc, char *argv)
 	case DD_OPTION_SPARSE:
 		g_opts.sparse = true;
 		break;
+	case DD_OPTION_JOBS:
+		g_opts.num_jobs = spdk_strtol(optarg, 10);
+		break;
 	default:
 		usage();
 		return 1;
@@ -1443,6 +1923,8 @@ dd_free(void)
 
 		free(g_job.ios);
 	}
+
+	free(g_workers);
 }
 
 int
@@ -1499,6 +1981,12 @@ main(int argc, char **argv)
 		goto end;
 	}
 
+	if ((int32_t)g_opts.num_jobs <= 0) {
+		SPDK_ERRLOG("Invalid --jobs value\n");
+		rc = EINVAL;
+		goto end;
+	}
+
 	if (g_opts.output_file == NULL && g_opts.output_file_flags != NULL) {
 		SPDK_ERRLOG("--oflags may be used only with --of\n");
 		rc = EINVAL;
@@ -4,6 +4,10 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/app_stats.h"
+#include "spdk/barrier.h"
+#include "spdk/base64.h"
+#include "spdk/histogram_data.h"
 #include "spdk/jsonrpc.h"
 #include "spdk/rpc.h"
 #include "spdk/event.h"
@@ -29,6 +33,8 @@
 #define RPC_MAX_THREADS 1024
 #define RPC_MAX_POLLERS 1024
 #define RPC_MAX_CORES 255
+#define RPC_MAX_BDEVS 1024
+#define RPC_MAX_SUBSYSTEMS 1024
 #define MAX_THREAD_NAME 128
 #define MAX_POLLER_NAME 128
 #define MAX_THREADS 4096
@@ -42,7 +48,7 @@
 #define TABS_LOCATION_COL 0
 #define TABS_DATA_START_ROW 3
 #define TABS_DATA_START_COL 2
-#define TABS_COL_COUNT 10
+#define TABS_COL_COUNT 11
 #define MENU_WIN_HEIGHT 3
 #define MENU_WIN_SPACING 4
 #define MENU_WIN_LOCATION_COL 0
@@ -71,7 +77,7 @@
 #define CORE_WIN_FIRST_COL 16
 #define CORE_WIN_WIDTH 48
 #define CORE_WIN_HEIGHT 11
-#define POLLER_WIN_HEIGHT 8
+#define POLLER_WIN_HEIGHT 10
 #define POLLER_WIN_WIDTH 64
 #define POLLER_WIN_FIRST_COL 14
 #define FIRST_DATA_ROW 7
@@ -80,11 +86,22 @@
 #define SCHEDULER_WIN_HEIGHT 7
 #define SCHEDULER_WIN_FIRST_COL 2
 #define MAX_SCHEDULER_PERIOD_STR_LEN 10
+#define MAX_BDEV_NAME_LEN 26
+#define MAX_NQN_LEN 40
+#define MAX_NS_COUNT_STR_LEN 12
+#define MAX_IOPS_STR_LEN 12
+#define MAX_BW_STR_LEN 13
+#define MAX_LAT_STR_LEN 16
+#define HISTORY_LEN 24
+#define MAX_HISTORY_STR_LEN (HISTORY_LEN + 2)
+#define STATS_SHM_MAX_RETRIES 1000
 
 enum tabs {
 	THREADS_TAB,
 	POLLERS_TAB,
 	CORES_TAB,
+	BDEVS_TAB,
+	SUBSYSTEMS_TAB,
 	NUMBER_OF_TABS,
 };
 
@@ -108,6 +125,7 @@ enum column_pollers_type {
 	COL_POLLERS_RUN_COUNTER,
 	COL_POLLERS_PERIOD,
 	COL_POLLERS_BUSY_COUNT,
+	COL_POLLERS_MAX_RUN,
 	COL_POLLERS_NONE = 255,
 };
 
@@ -121,9 +139,47 @@ enum column_cores_type {
 	COL_CORES_INTR,
 	COL_CORES_CPU_USAGE,
 	COL_CORES_STATUS,
+	COL_CORES_HISTORY,
 	COL_CORES_NONE = 255,
 };
 
+enum column_bdevs_type {
+	COL_BDEVS_NAME,
+	COL_BDEVS_READ_IOPS,
+	COL_BDEVS_WRITE_IOPS,
+	COL_BDEVS_READ_BW,
+	COL_BDEVS_WRITE_BW,
+	COL_BDEVS_READ_LAT,
+	COL_BDEVS_WRITE_LAT,
+	COL_BDEVS_HISTORY,
+	COL_BDEVS_NONE = 255,
+};
+
+enum column_subsystems_type {
+	COL_SUBSYSTEMS_NQN,
+	COL_SUBSYSTEMS_NAMESPACES,
+	COL_SUBSYSTEMS_READ_IOPS,
+	COL_SUBSYSTEMS_WRITE_IOPS,
+	COL_SUBSYSTEMS_READ_BW,
+	COL_SUBSYSTEMS_WRITE_BW,
+	COL_SUBSYSTEMS_READ_LAT,
+	COL_SUBSYSTEMS_WRITE_LAT,
+	COL_SUBSYSTEMS_HISTORY,
+	COL_SUBSYSTEMS_NONE = 255,
+};
+
+/* I/O statistics columns, shared by the bdevs and subsystems tabs in this order */
+enum io_stat_type {
+	IO_STAT_READ_IOPS,
+	IO_STAT_WRITE_IOPS,
+	IO_STAT_READ_BW,
+	IO_STAT_WRITE_BW,
+	IO_STAT_READ_LAT,
+	IO_STAT_WRITE_LAT,
+	IO_STAT_HISTORY,
+	IO_STAT_COUNT,
+};
+
 enum spdk_poller_type {
 	SPDK_ACTIVE_POLLER,
 	SPDK_TIMED_POLLER,
@@ -146,12 +202,20 @@ struct run_counter_history {
 	TAILQ_ENTRY(run_counter_history) link;
 };
 
+/* Last samples of a value, the most recent one at the end */
+struct sample_history {
+	uint64_t values[HISTORY_LEN];
+	uint32_t count;
+};
+
 uint8_t g_sleep_time = 1;
 uint16_t g_selected_row;
 uint16_t g_max_selected_row;
 uint64_t g_tick_rate;
 const char *poller_type_str[SPDK_POLLER_TYPES_COUNT] = {"Active", "Timed", "Paused"};
-const char *g_tab_title[NUMBER_OF_TABS] = {"[1] THREADS", "[2] POLLERS", "[3] CORES"};
+const char *g_tab_title[NUMBER_OF_TABS] = {"[1] THREADS", "[2] POLLERS", "[3] CORES", "[4] BDEVS",
+					  "[5] SUBSYSTEMS"
+					 };
 struct spdk_jsonrpc_client *g_rpc_client;
 static TAILQ_HEAD(, run_counter_history) g_run_counter_history = TAILQ_HEAD_INITIALIZER(
 			g_run_counter_history);
@@ -160,11 +224,27 @@ PANEL *g_panels[NUMBER_OF_TABS];
 uint16_t g_max_row, g_max_col;
 uint16_t g_data_win_size, g_max_data_rows;
 uint32_t g_last_threads_count, g_last_pollers_count, g_last_cores_count;
-uint8_t g_current_sort_col[NUMBER_OF_TABS] = {COL_THREADS_NAME, COL_POLLERS_NAME, COL_CORES_CORE};
-uint8_t g_current_sort_col2[NUMBER_OF_TABS] = {COL_THREADS_NONE, COL_POLLERS_NONE, COL_CORES_NONE};
+uint32_t g_last_bdevs_count, g_last_subsystems_count;
+uint8_t g_current_sort_col[NUMBER_OF_TABS] = {COL_THREADS_NAME, COL_POLLERS_NAME, COL_CORES_CORE,
+					      COL_BDEVS_NAME, COL_SUBSYSTEMS_NQN
+					     };
+uint8_t g_current_sort_col2[NUMBER_OF_TABS] = {COL_THREADS_NONE, COL_POLLERS_NONE, COL_CORES_NONE,
+					       COL_BDEVS_NONE, COL_SUBSYSTEMS_NONE
+					      };
 bool g_interval_data = true;
 bool g_quit_app = false;
 pthread_mutex_t g_thread_lock;
+/* Statistics shared memory of the application, NULL if the RPCs are used instead */
+struct spdk_app_stats *g_app_stats;
+bool g_disable_stats_shm;
+/* Tab displayed by the main thread, so that the data thread only fetches what's needed */
+uint8_t g_active_tab = THREADS_TAB;
+/* Set while a pop-up listing the pollers is displayed */
+bool g_pollers_needed;
+/* CPU usage history of each core, indexed by lcore */
+struct sample_history g_cores_history[SPDK_CPUSET_SIZE];
+/* Timestamps of the last two bdev statistics samples */
+uint64_t g_bdevs_ticks, g_bdevs_last_ticks;
 static struct col_desc g_col_desc[NUMBER_OF_TABS][TABS_COL_COUNT] = {
 	{	{.name = "Thread name", .max_data_string = MAX_THREAD_NAME_LEN},
 		{.name = "Core", .max_data_string = MAX_CORE_STR_LEN},
@@ -183,6 +263,7 @@ static struct col_desc g_col_desc[NUMBER_OF_TABS][TABS_COL_COUNT] = {
 		{.name = "Run count", .max_data_string = MAX_POLLER_RUN_COUNT},
 		{.name = "Period [us]", .max_data_string = MAX_PERIOD_STR_LEN},
 		{.name = "Status (busy count)", .max_data_string = MAX_POLLER_IND_STR_LEN},
+		{.name = "Max run [us]", .max_data_string = MAX_TIME_STR_LEN},
 		{.name = (char *)NULL}
 	},
 	{	{.name = "Core", .max_data_string = MAX_CORE_STR_LEN},
@@ -194,6 +275,28 @@ static struct col_desc g_col_desc[NUMBER_OF_TABS][TABS_COL_COUNT] = {
 		{.name = "Intr", .max_data_string = MAX_INTR_LEN},
 		{.name = "CPU %", .max_data_string = MAX_CPU_STR_LEN},
 		{.name = "Status", .max_data_string = MAX_STATUS_IND_STR_LEN},
+		{.name = "CPU history", .max_data_string = MAX_HISTORY_STR_LEN},
+		{.name = (char *)NULL}
+	},
+	{	{.name = "Bdev name", .max_data_string = MAX_BDEV_NAME_LEN},
+		{.name = "Read IOPS", .max_data_string = MAX_IOPS_STR_LEN},
+		{.name = "Write IOPS", .max_data_string = MAX_IOPS_STR_LEN},
+		{.name = "Read MiB/s", .max_data_string = MAX_BW_STR_LEN},
+		{.name = "Write MiB/s", .max_data_string = MAX_BW_STR_LEN},
+		{.name = "Read lat [us]", .max_data_string = MAX_LAT_STR_LEN},
+		{.name = "Write lat [us]", .max_data_string = MAX_LAT_STR_LEN},
+		{.name = "IOPS history", .max_data_string = MAX_HISTORY_STR_LEN},
+		{.name = (char *)NULL}
+	},
+	{	{.name = "Subsystem NQN", .max_data_string = MAX_NQN_LEN},
+		{.name = "Namespaces", .max_data_string = MAX_NS_COUNT_STR_LEN},
+		{.name = "Read IOPS", .max_data_string = MAX_IOPS_STR_LEN},
+		{.name = "Write IOPS", .max_data_string = MAX_IOPS_STR_LEN},
+		{.name = "Read MiB/s", .max_data_string = MAX_BW_STR_LEN},
+		{.name = "Write MiB/s", .max_data_string = MAX_BW_STR_LEN},
+		{.name = "Read lat [us]", .max_data_string = MAX_LAT_STR_LEN},
+		{.name = "Write lat [us]", .max_data_string = MAX_LAT_STR_LEN},
+		{.name = "IOPS history", .max_data_string = MAX_HISTORY_STR_LEN},
 		{.name = (char *)NULL}
 	}
 };
@@ -220,6 +323,10 @@ struct rpc_poller_info {
 	uint64_t run_count;
 	uint64_t busy_count;
 	uint64_t period_ticks;
+	uint64_t max_run_ticks;
+	uint64_t slow_run_count;
+	/* 99th percentile of the execution time, 0 if the poller has no histogram */
+	uint64_t p99_run_ticks;
 	enum spdk_poller_type type;
 	char thread_name[MAX_THREAD_NAME];
 	uint64_t thread_id;
@@ -255,10 +362,44 @@ struct rpc_scheduler {
 	uint64_t scheduler_period;
 };
 
+struct io_stat {
+	uint64_t bytes_read;
+	uint64_t num_read_ops;
+	uint64_t bytes_written;
+	uint64_t num_write_ops;
+	uint64_t read_latency_ticks;
+	uint64_t write_latency_ticks;
+};
+
+struct rpc_bdev_info {
+	char *name;
+	struct io_stat stat;
+	struct io_stat last_stat;
+	struct sample_history iops_history;
+};
+
+struct rpc_subsystem_namespaces {
+	size_t count;
+	char **bdev_names;
+};
+
+struct rpc_subsystem_info {
+	char *nqn;
+	struct rpc_subsystem_namespaces namespaces;
+	/* Sum of the statistics of the namespaces' bdevs */
+	struct io_stat stat;
+	struct io_stat last_stat;
+	struct sample_history iops_history;
+};
+
 struct rpc_thread_info g_threads_info[RPC_MAX_THREADS];
 struct rpc_poller_info g_pollers_info[RPC_MAX_POLLERS];
 struct rpc_core_info g_cores_info[RPC_MAX_CORES];
+struct rpc_bdev_info g_bdevs_info[RPC_MAX_BDEVS];
+struct rpc_subsystem_info g_subsystems_info[RPC_MAX_SUBSYSTEMS];
 struct rpc_scheduler g_scheduler_info;
+/* Snapshot of the threads from the statistics shared memory */
+static struct spdk_app_stats_thread g_stats_threads[SPDK_APP_STATS_MAX_THREADS];
 
 static void
 init_str_len(void)
@@ -351,6 +492,76 @@ free_rpc_core_info(struct rpc_core_info *core_info, size_t size)
 	}
 }
 
+struct rpc_poller_histogram {
+	char *histogram;
+	uint32_t bucket_shift;
+	uint64_t tsc_rate;
+};
+
+static const struct spdk_json_object_decoder rpc_poller_histogram_decoders[] = {
+	{"histogram", offsetof(struct rpc_poller_histogram, histogram), spdk_json_decode_string},
+	{"bucket_shift", offsetof(struct rpc_poller_histogram, bucket_shift), spdk_json_decode_uint32},
+	{"tsc_rate", offsetof(struct rpc_poller_histogram, tsc_rate), spdk_json_decode_uint64},
+};
+
+struct poller_percentile {
+	uint64_t ticks;
+};
+
+static void
+get_poller_percentile(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		      uint64_t total, uint64_t so_far)
+{
+	struct poller_percentile *percentile = ctx;
+
+	if (percentile->ticks == 0 && count != 0 && so_far * 100 >= total * 99) {
+		percentile->ticks = end;
+	}
+}
+
+/* Decode the execution time histogram of a poller into its 99th percentile */
+static int
+rpc_decode_poller_histogram(const struct spdk_json_val *val, void *out)
+{
+	uint64_t *p99_run_ticks = out;
+	struct rpc_poller_histogram req = {};
+	struct spdk_histogram_data data = {}, *histogram = &data;
+	struct poller_percentile percentile = {};
+	size_t len;
+	int rc;
+
+	rc = spdk_json_decode_object(val, rpc_poller_histogram_decoders,
+				     SPDK_COUNTOF(rpc_poller_histogram_decoders), &req);
+	if (rc) {
+		goto end;
+	}
+
+	if (req.bucket_shift == 0 || req.bucket_shift >= 32) {
+		rc = -EINVAL;
+		goto end;
+	}
+
+	histogram->bucket_shift = req.bucket_shift;
+	histogram->bucket = malloc(spdk_base64_get_decoded_len(strlen(req.histogram)));
+	if (histogram->bucket == NULL) {
+		rc = -ENOMEM;
+		goto end;
+	}
+
+	rc = spdk_base64_decode(histogram->bucket, &len, req.histogram);
+	if (rc || len != SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t)) {
+		rc = -EINVAL;
+		goto end;
+	}
+
+	spdk_histogram_data_iterate(histogram, get_poller_percentile, &percentile);
+	*p99_run_ticks = percentile.ticks;
+end:
+	free(histogram->bucket);
+	free(req.histogram);
+	return rc;
+}
+
 static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"name", offsetof(struct rpc_poller_info, name), spdk_json_decode_string},
 	{"state", offsetof(struct rpc_poller_info, state), spdk_json_decode_string},
@@ -358,6 +569,9 @@ static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"run_count", offsetof(struct rpc_poller_info, run_count), spdk_json_decode_uint64},
 	{"busy_count", offsetof(struct rpc_poller_info, busy_count), spdk_json_decode_uint64},
 	{"period_ticks", offsetof(struct rpc_poller_info, period_ticks), spdk_json_decode_uint64, true},
+	{"max_run_ticks", offsetof(struct rpc_poller_info, max_run_ticks), spdk_json_decode_uint64, true},
+	{"slow_run_count", offsetof(struct rpc_poller_info, slow_run_count), spdk_json_decode_uint64, true},
+	{"run_time_histogram", offsetof(struct rpc_poller_info, p99_run_ticks), rpc_decode_poller_histogram, true},
 };
 
 static int
@@ -709,6 +923,146 @@ store_last_counters(uint64_t poller_id, uint64_t thread_id, uint64_t last_run_co
 	TAILQ_INSERT_TAIL(&g_run_counter_history, history, link);
 }
 
+static void
+sample_history_add(struct sample_history *history, uint64_t value)
+{
+	memmove(&history->values[0], &history->values[1],
+		sizeof(history->values) - sizeof(history->values[0]));
+	history->values[HISTORY_LEN - 1] = value;
+	history->count = spdk_min(history->count + 1, HISTORY_LEN);
+}
+
+/* Copy an entry of the statistics shared memory, retrying while it's being updated */
+static bool
+stats_shm_copy(void *dst, const void *src, const uint64_t *seq, size_t size)
+{
+	uint64_t start;
+	int i;
+
+	for (i = 0; i < STATS_SHM_MAX_RETRIES; i++) {
+		start = *(volatile const uint64_t *)seq;
+		spdk_smp_rmb();
+		memcpy(dst, src, size);
+		spdk_smp_rmb();
+		if (!(start & 1) && start == *(volatile const uint64_t *)seq) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Take a snapshot of the threads from the statistics shared memory */
+static uint32_t
+get_stats_shm_threads(void)
+{
+	struct spdk_app_stats_thread *entry;
+	uint32_t i, count = 0;
+
+	for (i = 0; i < SPDK_APP_STATS_MAX_THREADS; i++) {
+		entry = &g_app_stats->threads[i];
+		if (*(volatile uint64_t *)&entry->id == 0) {
+			continue;
+		}
+
+		if (!stats_shm_copy(&g_stats_threads[count], entry, &entry->seq, sizeof(*entry)) ||
+		    g_stats_threads[count].id == 0) {
+			continue;
+		}
+
+		g_stats_threads[count].name[SPDK_APP_STATS_NAME_LEN - 1] = '\0';
+		g_stats_threads[count].cpumask[SPDK_APP_STATS_CPUMASK_LEN - 1] = '\0';
+		count++;
+	}
+
+	return count;
+}
+
+static int
+get_thread_data_shm(struct rpc_thread_info *thread_info, uint64_t *threads_count)
+{
+	struct spdk_app_stats_thread *entry;
+	uint32_t i, j, count;
+
+	count = spdk_min(get_stats_shm_threads(), RPC_MAX_THREADS);
+	for (i = 0; i < count; i++) {
+		entry = &g_stats_threads[i];
+		thread_info[i].name = strdup(entry->name);
+		thread_info[i].cpumask = strdup(entry->cpumask);
+		if (thread_info[i].name == NULL || thread_info[i].cpumask == NULL) {
+			for (j = 0; j <= i; j++) {
+				free_rpc_threads_stats(&thread_info[j]);
+			}
+			return -ENOMEM;
+		}
+
+		thread_info[i].id = entry->id;
+		thread_info[i].busy = entry->busy_tsc;
+		thread_info[i].idle = entry->idle_tsc;
+		thread_info[i].active_pollers_count = entry->active_pollers_count;
+		thread_info[i].timed_pollers_count = entry->timed_pollers_count;
+		thread_info[i].paused_pollers_count = entry->paused_pollers_count;
+	}
+
+	*threads_count = count;
+
+	return 0;
+}
+
+static int
+get_cores_data_shm(struct rpc_core_info *cores_info, uint32_t *cores_count)
+{
+	struct spdk_app_stats_reactor reactor;
+	struct spdk_app_stats_reactor *entry;
+	struct rpc_core_threads *threads;
+	struct rpc_core_thread_info *thread;
+	uint32_t i, j, num_threads, count = 0;
+
+	num_threads = get_stats_shm_threads();
+
+	for (i = 0; i < SPDK_APP_STATS_MAX_REACTORS && count < RPC_MAX_CORES; i++) {
+		entry = &g_app_stats->reactors[i];
+		if (!stats_shm_copy(&reactor, entry, &entry->seq, sizeof(reactor)) ||
+		    !reactor.valid) {
+			continue;
+		}
+
+		cores_info[count].lcore = reactor.lcore;
+		cores_info[count].busy = reactor.busy_tsc;
+		cores_info[count].idle = reactor.idle_tsc;
+		cores_info[count].in_interrupt = reactor.in_interrupt;
+
+		threads = &cores_info[count].threads;
+		threads->thread = calloc(num_threads, sizeof(struct rpc_core_thread_info));
+		if (threads->thread == NULL && num_threads != 0) {
+			free_rpc_core_info(cores_info, count);
+			return -ENOMEM;
+		}
+		count++;
+
+		for (j = 0; j < num_threads; j++) {
+			if (g_stats_threads[j].lcore != reactor.lcore) {
+				continue;
+			}
+
+			thread = &threads->thread[threads->threads_count++];
+			thread->name = strdup(g_stats_threads[j].name);
+			thread->cpumask = strdup(g_stats_threads[j].cpumask);
+			if (thread->name == NULL || thread->cpumask == NULL) {
+				free_rpc_core_info(cores_info, count);
+				return -ENOMEM;
+			}
+			thread->id = g_stats_threads[j].id;
+			thread->elapsed = reactor.tsc > g_stats_threads[j].tsc_start ?
+					  reactor.tsc - g_stats_threads[j].tsc_start : 0;
+		}
+	}
+
+	*cores_count = count;
+
+	return 0;
+}
+
 static int
 get_thread_data(void)
 {
@@ -718,19 +1072,27 @@ get_thread_data(void)
 	uint64_t i, j, k, current_threads_count = 0;
 	int rc = 0;
 
-	rc = rpc_send_req("thread_get_stats", &json_resp);
-	if (rc) {
-		return rc;
-	}
-
-	/* Decode json */
 	memset(thread_info, 0, sizeof(struct rpc_thread_info) * RPC_MAX_THREADS);
-	if (rpc_decode_threads_array(json_resp->result, thread_info, &current_threads_count)) {
-		rc = -EINVAL;
-		for (i = 0; i < current_threads_count; i++) {
-			free_rpc_threads_stats(&thread_info[i]);
+	if (g_app_stats != NULL) {
+		rc = get_thread_data_shm(thread_info, &current_threads_count);
+		if (rc) {
+			return rc;
+		}
+	} else {
+		rc = rpc_send_req("thread_get_stats", &json_resp);
+		if (rc) {
+			return rc;
+		}
+
+		/* Decode json */
+		if (rpc_decode_threads_array(json_resp->result, thread_info,
+					     &current_threads_count)) {
+			rc = -EINVAL;
+			for (i = 0; i < current_threads_count; i++) {
+				free_rpc_threads_stats(&thread_info[i]);
+			}
+			goto end;
 		}
-		goto end;
 	}
 
 	pthread_mutex_lock(&g_thread_lock);
@@ -854,6 +1216,10 @@ subsort_pollers(enum column_pollers_type sort_column, const void *p1, const void
 			}
 		}
 		break;
+	case COL_POLLERS_MAX_RUN:
+		count1 = poller1->max_run_ticks;
+		count2 = poller2->max_run_ticks;
+		break;
 	case COL_POLLERS_NONE:
 	default:
 		return 0;
@@ -1016,18 +1382,27 @@ get_cores_data(void)
 	uint64_t i, j, k;
 	uint32_t current_cores_count;
 	struct rpc_core_info cores_info[RPC_MAX_CORES];
+	uint64_t busy_period, idle_period;
 	int rc = 0;
 
-	rc = rpc_send_req("framework_get_reactors", &json_resp);
-	if (rc) {
-		return rc;
-	}
-
-	/* Decode json */
 	memset(cores_info, 0, sizeof(struct rpc_core_info) * RPC_MAX_CORES);
-	if (rpc_decode_cores_array(json_resp->result, cores_info, &current_cores_count)) {
-		rc = -EINVAL;
-		goto end;
+	if (g_app_stats != NULL) {
+		rc = get_cores_data_shm(cores_info, &current_cores_count);
+		if (rc) {
+			return rc;
+		}
+	} else {
+		rc = rpc_send_req("framework_get_reactors", &json_resp);
+		if (rc) {
+			return rc;
+		}
+
+		/* Decode json */
+		if (rpc_decode_cores_array(json_resp->result, cores_info, &current_cores_count)) {
+			rc = -EINVAL;
+			spdk_jsonrpc_client_free_response(json_resp);
+			return rc;
+		}
 	}
 
 	pthread_mutex_lock(&g_thread_lock);
@@ -1038,6 +1413,13 @@ get_cores_data(void)
 				cores_info[i].last_idle = g_cores_info[j].idle;
 			}
 		}
+
+		if (cores_info[i].lcore < SPDK_COUNTOF(g_cores_history)) {
+			busy_period = cores_info[i].busy - cores_info[i].last_busy;
+			idle_period = cores_info[i].idle - cores_info[i].last_idle;
+			sample_history_add(&g_cores_history[cores_info[i].lcore],
+					   get_cpu_usage(busy_period, idle_period));
+		}
 	}
 
 	/* Free old cores values before allocating memory for new ones */
@@ -1070,7 +1452,6 @@ get_cores_data(void)
 
 	qsort(&g_cores_info, g_last_cores_count, sizeof(struct rpc_core_info), sort_cores);
 
-end:
 	pthread_mutex_unlock(&g_thread_lock);
 	spdk_jsonrpc_client_free_response(json_resp);
 	return rc;
@@ -1105,6 +1486,419 @@ get_scheduler_data(void)
 	return rc;
 }
 
+static uint64_t
+get_io_stat_value(const struct io_stat *stat, const struct io_stat *last, enum io_stat_type type)
+{
+	uint64_t ops;
+
+	switch (type) {
+	case IO_STAT_READ_IOPS:
+		return stat->num_read_ops - last->num_read_ops;
+	case IO_STAT_WRITE_IOPS:
+		return stat->num_write_ops - last->num_write_ops;
+	case IO_STAT_READ_BW:
+		return stat->bytes_read - last->bytes_read;
+	case IO_STAT_WRITE_BW:
+		return stat->bytes_written - last->bytes_written;
+	case IO_STAT_READ_LAT:
+		ops = stat->num_read_ops - last->num_read_ops;
+		return ops ? (stat->read_latency_ticks - last->read_latency_ticks) / ops : 0;
+	case IO_STAT_WRITE_LAT:
+		ops = stat->num_write_ops - last->num_write_ops;
+		return ops ? (stat->write_latency_ticks - last->write_latency_ticks) / ops : 0;
+	case IO_STAT_HISTORY:
+	default:
+		return stat->num_read_ops - last->num_read_ops +
+		       stat->num_write_ops - last->num_write_ops;
+	}
+}
+
+static void
+get_io_stat_str(const struct io_stat *stat, const struct io_stat *last, enum io_stat_type type,
+		char *str, size_t len)
+{
+	uint64_t interval = g_bdevs_ticks - g_bdevs_last_ticks;
+	uint64_t value = get_io_stat_value(stat, last, type);
+
+	if (interval == 0) {
+		snprintf(str, len, "n/a");
+		return;
+	}
+
+	switch (type) {
+	case IO_STAT_READ_IOPS:
+	case IO_STAT_WRITE_IOPS:
+		snprintf(str, len, "%" PRIu64, value * g_tick_rate / interval);
+		break;
+	case IO_STAT_READ_BW:
+	case IO_STAT_WRITE_BW:
+		snprintf(str, len, "%.2f",
+			 (double)value * g_tick_rate / interval / (1024 * 1024));
+		break;
+	case IO_STAT_READ_LAT:
+	case IO_STAT_WRITE_LAT:
+		snprintf(str, len, "%.2f", (double)value * SPDK_SEC_TO_USEC / g_tick_rate);
+		break;
+	default:
+		str[0] = '\0';
+		break;
+	}
+}
+
+/* Draw the last samples scaled to the maximum (or the largest sample if max is 0) */
+static void
+get_history_str(const struct sample_history *history, uint64_t max, char *str)
+{
+	const char levels[] = " .:-=+*#";
+	const uint64_t num_levels = sizeof(levels) - 1;
+	uint64_t i, level, value;
+
+	if (max == 0) {
+		for (i = 0; i < HISTORY_LEN; i++) {
+			max = spdk_max(max, history->values[i]);
+		}
+	}
+
+	for (i = 0; i < HISTORY_LEN; i++) {
+		value = history->values[i];
+		if (i < HISTORY_LEN - history->count || value == 0 || max == 0) {
+			level = 0;
+		} else {
+			level = spdk_min(1 + value * (num_levels - 2) / max, num_levels - 1);
+		}
+		str[i] = levels[level];
+	}
+	str[HISTORY_LEN] = '\0';
+}
+
+static int
+subsort_io_stat(enum io_stat_type type, const struct io_stat *stat1, const struct io_stat *last1,
+		const struct io_stat *stat2, const struct io_stat *last2)
+{
+	uint64_t count1, count2;
+
+	count1 = get_io_stat_value(stat1, last1, type);
+	count2 = get_io_stat_value(stat2, last2, type);
+
+	if (count2 > count1) {
+		return 1;
+	} else if (count2 < count1) {
+		return -1;
+	} else {
+		return 0;
+	}
+}
+
+static int
+subsort_bdevs(enum column_bdevs_type sort_column, const void *p1, const void *p2)
+{
+	const struct rpc_bdev_info *bdev1 = p1;
+	const struct rpc_bdev_info *bdev2 = p2;
+
+	switch (sort_column) {
+	case COL_BDEVS_NAME:
+		return strcmp(bdev1->name, bdev2->name);
+	case COL_BDEVS_NONE:
+		return 0;
+	default:
+		return subsort_io_stat(sort_column - COL_BDEVS_READ_IOPS,
+				       &bdev1->stat, &bdev1->last_stat,
+				       &bdev2->stat, &bdev2->last_stat);
+	}
+}
+
+static int
+sort_bdevs(const void *p1, const void *p2)
+{
+	int res;
+
+	res = subsort_bdevs(g_current_sort_col[BDEVS_TAB], p1, p2);
+	if (res == 0) {
+		res = subsort_bdevs(g_current_sort_col2[BDEVS_TAB], p1, p2);
+	}
+	return res;
+}
+
+static int
+subsort_subsystems(enum column_subsystems_type sort_column, const void *p1, const void *p2)
+{
+	const struct rpc_subsystem_info *subsystem1 = p1;
+	const struct rpc_subsystem_info *subsystem2 = p2;
+
+	switch (sort_column) {
+	case COL_SUBSYSTEMS_NQN:
+		return strcmp(subsystem1->nqn, subsystem2->nqn);
+	case COL_SUBSYSTEMS_NAMESPACES:
+		if (subsystem2->namespaces.count > subsystem1->namespaces.count) {
+			return 1;
+		} else if (subsystem2->namespaces.count < subsystem1->namespaces.count) {
+			return -1;
+		}
+		return 0;
+	case COL_SUBSYSTEMS_NONE:
+		return 0;
+	default:
+		return subsort_io_stat(sort_column - COL_SUBSYSTEMS_READ_IOPS,
+				       &subsystem1->stat, &subsystem1->last_stat,
+				       &subsystem2->stat, &subsystem2->last_stat);
+	}
+}
+
+static int
+sort_subsystems(const void *p1, const void *p2)
+{
+	int res;
+
+	res = subsort_subsystems(g_current_sort_col[SUBSYSTEMS_TAB], p1, p2);
+	if (res == 0) {
+		res = subsort_subsystems(g_current_sort_col2[SUBSYSTEMS_TAB], p1, p2);
+	}
+	return res;
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_iostat_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_info, name), spdk_json_decode_string},
+	{"bytes_read", offsetof(struct rpc_bdev_info, stat.bytes_read), spdk_json_decode_uint64},
+	{"num_read_ops", offsetof(struct rpc_bdev_info, stat.num_read_ops), spdk_json_decode_uint64},
+	{"bytes_written", offsetof(struct rpc_bdev_info, stat.bytes_written), spdk_json_decode_uint64},
+	{"num_write_ops", offsetof(struct rpc_bdev_info, stat.num_write_ops), spdk_json_decode_uint64},
+	{"read_latency_ticks", offsetof(struct rpc_bdev_info, stat.read_latency_ticks), spdk_json_decode_uint64},
+	{"write_latency_ticks", offsetof(struct rpc_bdev_info, stat.write_latency_ticks), spdk_json_decode_uint64},
+};
+
+static int
+rpc_decode_bdev_iostat_object(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object_relaxed(val, rpc_bdev_iostat_decoders,
+					       SPDK_COUNTOF(rpc_bdev_iostat_decoders), out);
+}
+
+static void
+free_rpc_bdevs(struct rpc_bdev_info *bdevs, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		free(bdevs[i].name);
+		bdevs[i].name = NULL;
+	}
+}
+
+static int
+get_bdevs_data(void)
+{
+	struct spdk_jsonrpc_client_response *json_resp = NULL;
+	struct spdk_json_val *bdevs_val;
+	struct rpc_bdev_info *bdevs, *bdev;
+	uint64_t ticks = 0, ops;
+	size_t i, j, count = 0;
+	int rc;
+
+	const struct spdk_json_object_decoder rpc_ticks_decoder[] = {
+		{"ticks", 0, spdk_json_decode_uint64}
+	};
+
+	bdevs = calloc(RPC_MAX_BDEVS, sizeof(*bdevs));
+	if (bdevs == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = rpc_send_req("bdev_get_iostat", &json_resp);
+	if (rc) {
+		goto end;
+	}
+
+	if (spdk_json_decode_object_relaxed(json_resp->result, rpc_ticks_decoder,
+					    SPDK_COUNTOF(rpc_ticks_decoder), &ticks) ||
+	    spdk_json_find_array(json_resp->result, "bdevs", NULL, &bdevs_val) ||
+	    spdk_json_decode_array(bdevs_val, rpc_decode_bdev_iostat_object, bdevs, RPC_MAX_BDEVS,
+				   &count, sizeof(*bdevs))) {
+		free_rpc_bdevs(bdevs, RPC_MAX_BDEVS);
+		rc = -EINVAL;
+		goto end;
+	}
+
+	pthread_mutex_lock(&g_thread_lock);
+
+	for (i = 0; i < count; i++) {
+		bdev = &bdevs[i];
+		/* New bdevs don't have any rate until the next sample */
+		bdev->last_stat = bdev->stat;
+		for (j = 0; j < g_last_bdevs_count; j++) {
+			if (strcmp(bdev->name, g_bdevs_info[j].name) == 0) {
+				bdev->last_stat = g_bdevs_info[j].stat;
+				bdev->iops_history = g_bdevs_info[j].iops_history;
+				break;
+			}
+		}
+	}
+
+	free_rpc_bdevs(g_bdevs_info, g_last_bdevs_count);
+	memcpy(g_bdevs_info, bdevs, sizeof(*bdevs) * count);
+	g_last_bdevs_count = count;
+	g_bdevs_last_ticks = g_bdevs_ticks != 0 ? g_bdevs_ticks : ticks;
+	g_bdevs_ticks = ticks;
+
+	for (i = 0; i < count && g_bdevs_ticks != g_bdevs_last_ticks; i++) {
+		bdev = &g_bdevs_info[i];
+		ops = get_io_stat_value(&bdev->stat, &bdev->last_stat, IO_STAT_HISTORY);
+		sample_history_add(&bdev->iops_history,
+				   ops * g_tick_rate / (g_bdevs_ticks - g_bdevs_last_ticks));
+	}
+
+	qsort(g_bdevs_info, g_last_bdevs_count, sizeof(struct rpc_bdev_info), sort_bdevs);
+
+	pthread_mutex_unlock(&g_thread_lock);
+
+end:
+	spdk_jsonrpc_client_free_response(json_resp);
+	free(bdevs);
+	return rc;
+}
+
+static const struct spdk_json_object_decoder rpc_namespace_decoders[] = {
+	{"bdev_name", 0, spdk_json_decode_string},
+};
+
+static int
+rpc_decode_namespace_object(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object_relaxed(val, rpc_namespace_decoders,
+					       SPDK_COUNTOF(rpc_namespace_decoders), out);
+}
+
+static int
+rpc_decode_subsystem_namespaces(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_subsystem_namespaces *namespaces = out;
+	/* Upper bound of the number of namespaces */
+	size_t max_count = spdk_json_val_len(val);
+
+	namespaces->bdev_names = calloc(max_count, sizeof(char *));
+	if (namespaces->bdev_names == NULL) {
+		return -ENOMEM;
+	}
+
+	return spdk_json_decode_array(val, rpc_decode_namespace_object, namespaces->bdev_names,
+				      max_count, &namespaces->count, sizeof(char *));
+}
+
+static const struct spdk_json_object_decoder rpc_subsystem_decoders[] = {
+	{"nqn", offsetof(struct rpc_subsystem_info, nqn), spdk_json_decode_string},
+	{"namespaces", offsetof(struct rpc_subsystem_info, namespaces), rpc_decode_subsystem_namespaces, true},
+};
+
+static int
+rpc_decode_subsystem_object(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object_relaxed(val, rpc_subsystem_decoders,
+					       SPDK_COUNTOF(rpc_subsystem_decoders), out);
+}
+
+static void
+free_rpc_subsystems(struct rpc_subsystem_info *subsystems, size_t count)
+{
+	size_t i, j;
+
+	for (i = 0; i < count; i++) {
+		free(subsystems[i].nqn);
+		subsystems[i].nqn = NULL;
+		if (subsystems[i].namespaces.bdev_names != NULL) {
+			for (j = 0; j < subsystems[i].namespaces.count; j++) {
+				free(subsystems[i].namespaces.bdev_names[j]);
+			}
+			free(subsystems[i].namespaces.bdev_names);
+			subsystems[i].namespaces.bdev_names = NULL;
+		}
+	}
+}
+
+static void
+io_stat_add(struct io_stat *stat, const struct io_stat *add)
+{
+	stat->bytes_read += add->bytes_read;
+	stat->num_read_ops += add->num_read_ops;
+	stat->bytes_written += add->bytes_written;
+	stat->num_write_ops += add->num_write_ops;
+	stat->read_latency_ticks += add->read_latency_ticks;
+	stat->write_latency_ticks += add->write_latency_ticks;
+}
+
+/* Subsystems' statistics are the sums of their namespaces' bdevs, so get_bdevs_data()
+ * has to be called first. */
+static int
+get_subsystems_data(void)
+{
+	struct spdk_jsonrpc_client_response *json_resp = NULL;
+	struct rpc_subsystem_info *subsystems, *subsystem;
+	struct rpc_bdev_info *bdev;
+	size_t i, j, k, count = 0;
+	uint64_t ops;
+	int rc;
+
+	subsystems = calloc(RPC_MAX_SUBSYSTEMS, sizeof(*subsystems));
+	if (subsystems == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = rpc_send_req("nvmf_get_subsystems", &json_resp);
+	if (rc) {
+		goto end;
+	}
+
+	if (spdk_json_decode_array(json_resp->result, rpc_decode_subsystem_object, subsystems,
+				   RPC_MAX_SUBSYSTEMS, &count, sizeof(*subsystems))) {
+		free_rpc_subsystems(subsystems, RPC_MAX_SUBSYSTEMS);
+		rc = -EINVAL;
+		goto end;
+	}
+
+	pthread_mutex_lock(&g_thread_lock);
+
+	for (i = 0; i < count; i++) {
+		subsystem = &subsystems[i];
+
+		for (j = 0; j < subsystem->namespaces.count; j++) {
+			for (k = 0; k < g_last_bdevs_count; k++) {
+				bdev = &g_bdevs_info[k];
+				if (strcmp(subsystem->namespaces.bdev_names[j], bdev->name) == 0) {
+					io_stat_add(&subsystem->stat, &bdev->stat);
+					io_stat_add(&subsystem->last_stat, &bdev->last_stat);
+					break;
+				}
+			}
+		}
+
+		for (j = 0; j < g_last_subsystems_count; j++) {
+			if (strcmp(subsystem->nqn, g_subsystems_info[j].nqn) == 0) {
+				subsystem->iops_history = g_subsystems_info[j].iops_history;
+				break;
+			}
+		}
+
+		if (g_bdevs_ticks != g_bdevs_last_ticks) {
+			ops = get_io_stat_value(&subsystem->stat, &subsystem->last_stat,
+						IO_STAT_HISTORY);
+			sample_history_add(&subsystem->iops_history,
+					   ops * g_tick_rate / (g_bdevs_ticks - g_bdevs_last_ticks));
+		}
+	}
+
+	free_rpc_subsystems(g_subsystems_info, g_last_subsystems_count);
+	memcpy(g_subsystems_info, subsystems, sizeof(*subsystems) * count);
+	g_last_subsystems_count = count;
+
+	qsort(g_subsystems_info, g_last_subsystems_count, sizeof(struct rpc_subsystem_info),
+	      sort_subsystems);
+
+	pthread_mutex_unlock(&g_thread_lock);
+
+end:
+	spdk_jsonrpc_client_free_response(json_resp);
+	free(subsystems);
+	return rc;
+}
+
 enum str_alignment {
 	ALIGN_LEFT,
 	ALIGN_RIGHT,
@@ -1168,7 +1962,7 @@ draw_menu_win(void)
 	wbkgd(g_menu_win, COLOR_PAIR(2));
 	box(g_menu_win, 0, 0);
 	print_max_len(g_menu_win, 1, 1, 0, ALIGN_LEFT,
-		      "  [q] Quit  |  [1-3][Tab] Switch tab  |  [PgUp] Previous page  |  [PgDown] Next page  |  [Enter] Item details  |  [h] Help");
+		      "  [q] Quit  |  [1-5][Tab] Switch tab  |  [PgUp] Previous page  |  [PgDown] Next page  |  [Enter] Item details  |  [h] Help");
 }
 
 static void
@@ -1185,12 +1979,29 @@ draw_tab_win(enum tabs tab)
 	print_max_len(g_tab_win[tab], 1, col, 0, ALIGN_LEFT, g_tab_title[tab]);
 }
 
+/* Get the column at which the header of a given column is drawn */
+static uint16_t
+get_col_offset(struct col_desc *col_desc, int col_index)
+{
+	uint16_t offset = 1;
+	int j;
+
+	for (j = col_index; j != 0; j--) {
+		if (!col_desc[j - 1].disabled) {
+			offset += col_desc[j - 1].max_data_string;
+			offset += col_desc[j - 1].name_len % 2 + 1;
+		}
+	}
+
+	return offset;
+}
+
 static void
 draw_tabs(enum tabs tab_index, uint8_t sort_col, uint8_t sort_col2)
 {
 	struct col_desc *col_desc = g_col_desc[tab_index];
 	WINDOW *tab = g_tabs[tab_index];
-	int i, j;
+	int i;
 	uint16_t offset, draw_offset;
 	uint16_t tab_height = g_max_row - MENU_WIN_HEIGHT - TAB_WIN_HEIGHT - 3;
 
@@ -1199,13 +2010,7 @@ draw_tabs(enum tabs tab_index, uint8_t sort_col, uint8_t sort_col2)
 			continue;
 		}
 
-		offset = 1;
-		for (j = i; j != 0; j--) {
-			if (!col_desc[j - 1].disabled) {
-				offset += col_desc[j - 1].max_data_string;
-				offset += col_desc[j - 1].name_len % 2 + 1;
-			}
-		}
+		offset = get_col_offset(col_desc, i);
 
 		draw_offset = offset + (col_desc[i].max_data_string / 2) - (col_desc[i].name_len / 2);
 
@@ -1270,6 +2075,10 @@ resize_interface(enum tabs tab)
 static void
 switch_tab(enum tabs tab)
 {
+	pthread_mutex_lock(&g_thread_lock);
+	g_active_tab = tab;
+	pthread_mutex_unlock(&g_thread_lock);
+
 	wclear(g_tabs[tab]);
 	draw_tabs(tab, g_current_sort_col[tab], g_current_sort_col2[tab]);
 	top_panel(g_panels[tab]);
@@ -1469,7 +2278,7 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 	uint64_t last_run_counter, last_busy_counter;
 	uint16_t col = TABS_DATA_START_COL;
 	char run_count[MAX_POLLER_RUN_COUNT], period_ticks[MAX_PERIOD_STR_LEN],
-	     status[MAX_POLLER_IND_STR_LEN];
+	     status[MAX_POLLER_IND_STR_LEN], max_run[MAX_TIME_STR_LEN];
 
 	last_busy_counter = get_last_busy_counter(g_pollers_info[current_row].id,
 			    g_pollers_info[current_row].thread_id);
@@ -1558,6 +2367,17 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 				wattroff(g_tabs[POLLERS_TAB], COLOR_PAIR(9));
 			}
 		}
+		col += col_desc[COL_POLLERS_BUSY_COUNT].max_data_string + 2;
+	}
+
+	if (!col_desc[COL_POLLERS_MAX_RUN].disabled) {
+		/* The execution time is only measured while enabled by thread_set_poller_timing */
+		if (g_pollers_info[current_row].max_run_ticks != 0) {
+			get_time_str(g_pollers_info[current_row].max_run_ticks, max_run);
+			print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
+				      col_desc[COL_POLLERS_MAX_RUN].max_data_string, ALIGN_RIGHT,
+				      max_run);
+		}
 	}
 }
 
@@ -1609,7 +2429,8 @@ draw_core_tab_row(uint64_t current_row, uint8_t item_index)
 	char core[MAX_CORE_STR_LEN], threads_number[MAX_THREAD_COUNT_STR_LEN],  cpu_usage[MAX_CPU_STR_LEN],
 	     pollers_number[MAX_POLLER_COUNT_STR_LEN], idle_time[MAX_TIME_STR_LEN],
 	     busy_time[MAX_TIME_STR_LEN], core_freq[MAX_CORE_FREQ_STR_LEN],
-	     in_interrupt[MAX_INTR_LEN], *status_str;
+	     in_interrupt[MAX_INTR_LEN], history[MAX_HISTORY_STR_LEN], *status_str;
+	uint32_t lcore;
 
 	snprintf(threads_number, MAX_THREAD_COUNT_STR_LEN, "%ld",
 		 g_cores_info[current_row].threads.threads_count);
@@ -1707,6 +2528,20 @@ draw_core_tab_row(uint64_t current_row, uint8_t item_index)
 		print_max_len(g_tabs[CORES_TAB], TABS_DATA_START_ROW + item_index, col,
 			      col_desc[COL_CORES_STATUS].max_data_string, ALIGN_RIGHT, status_str);
 		wattroff(g_tabs[CORES_TAB], color_attr);
+		col += col_desc[COL_CORES_STATUS].max_data_string + 1;
+	}
+
+	if (!col_desc[COL_CORES_HISTORY].disabled) {
+		lcore = g_cores_info[current_row].lcore;
+		if (lcore < SPDK_COUNTOF(g_cores_history)) {
+			/* CPU usage is stored in hundredths of a percent */
+			get_history_str(&g_cores_history[lcore], 10000, history);
+		} else {
+			history[0] = '\0';
+		}
+		print_max_len(g_tabs[CORES_TAB], TABS_DATA_START_ROW + item_index,
+			      get_col_offset(col_desc, COL_CORES_HISTORY),
+			      col_desc[COL_CORES_HISTORY].max_data_string, ALIGN_LEFT, history);
 	}
 }
 
@@ -1739,11 +2574,134 @@ refresh_cores_tab(uint8_t current_page)
 	return max_pages;
 }
 
+static void
+draw_io_stat_cols(WINDOW *win, uint8_t item_index, struct col_desc *col_desc, int first_col,
+		  const struct io_stat *stat, const struct io_stat *last_stat,
+		  const struct sample_history *history)
+{
+	char str[spdk_max(MAX_LAT_STR_LEN, MAX_HISTORY_STR_LEN)];
+	int i;
+
+	for (i = 0; i < IO_STAT_COUNT; i++) {
+		if (col_desc[first_col + i].disabled) {
+			continue;
+		}
+
+		if (i == IO_STAT_HISTORY) {
+			get_history_str(history, 0, str);
+		} else {
+			get_io_stat_str(stat, last_stat, i, str, sizeof(str));
+		}
+		print_max_len(win, TABS_DATA_START_ROW + item_index,
+			      get_col_offset(col_desc, first_col + i),
+			      col_desc[first_col + i].max_data_string,
+			      i == IO_STAT_HISTORY ? ALIGN_LEFT : ALIGN_RIGHT, str);
+	}
+}
+
+static void
+draw_bdev_tab_row(uint64_t current_row, uint8_t item_index)
+{
+	struct col_desc *col_desc = g_col_desc[BDEVS_TAB];
+	struct rpc_bdev_info *bdev = &g_bdevs_info[current_row];
+
+	if (!col_desc[COL_BDEVS_NAME].disabled) {
+		print_max_len(g_tabs[BDEVS_TAB], TABS_DATA_START_ROW + item_index,
+			      TABS_DATA_START_COL, col_desc[COL_BDEVS_NAME].max_data_string,
+			      ALIGN_LEFT, bdev->name);
+	}
+
+	draw_io_stat_cols(g_tabs[BDEVS_TAB], item_index, col_desc, COL_BDEVS_READ_IOPS, &bdev->stat,
+			  &bdev->last_stat, &bdev->iops_history);
+}
+
+static void
+draw_subsystem_tab_row(uint64_t current_row, uint8_t item_index)
+{
+	struct col_desc *col_desc = g_col_desc[SUBSYSTEMS_TAB];
+	struct rpc_subsystem_info *subsystem = &g_subsystems_info[current_row];
+	char ns_count[MAX_NS_COUNT_STR_LEN];
+
+	if (!col_desc[COL_SUBSYSTEMS_NQN].disabled) {
+		print_max_len(g_tabs[SUBSYSTEMS_TAB], TABS_DATA_START_ROW + item_index,
+			      TABS_DATA_START_COL, col_desc[COL_SUBSYSTEMS_NQN].max_data_string,
+			      ALIGN_LEFT, subsystem->nqn);
+	}
+
+	if (!col_desc[COL_SUBSYSTEMS_NAMESPACES].disabled) {
+		snprintf(ns_count, sizeof(ns_count), "%zu", subsystem->namespaces.count);
+		print_max_len(g_tabs[SUBSYSTEMS_TAB], TABS_DATA_START_ROW + item_index,
+			      get_col_offset(col_desc, COL_SUBSYSTEMS_NAMESPACES),
+			      col_desc[COL_SUBSYSTEMS_NAMESPACES].max_data_string, ALIGN_RIGHT,
+			      ns_count);
+	}
+
+	draw_io_stat_cols(g_tabs[SUBSYSTEMS_TAB], item_index, col_desc, COL_SUBSYSTEMS_READ_IOPS,
+			  &subsystem->stat, &subsystem->last_stat, &subsystem->iops_history);
+}
+
+static uint8_t
+refresh_list_tab(enum tabs tab, uint64_t count, void (*draw_row)(uint64_t, uint8_t),
+		 uint8_t current_page)
+{
+	uint64_t i, j;
+	uint16_t empty_col = 0;
+	uint8_t max_pages, item_index;
+
+	max_pages = (count + g_max_data_rows - 1) / g_max_data_rows;
+
+	for (i = current_page * g_max_data_rows;
+	     i < (uint64_t)((current_page + 1) * g_max_data_rows);
+	     i++) {
+		item_index = i - (current_page * g_max_data_rows);
+
+		/* When number of items decreases, this will print spaces in places
+		 * where non existent items were previously displayed. */
+		if (i >= count) {
+			for (j = 1; j < (uint64_t)g_max_col - 1; j++) {
+				mvwprintw(g_tabs[tab], item_index + TABS_DATA_START_ROW, j, " ");
+			}
+
+			empty_col++;
+			continue;
+		}
+
+		draw_row_background(item_index, tab);
+		draw_row(i, item_index);
+
+		if (item_index == g_selected_row) {
+			wattroff(g_tabs[tab], COLOR_PAIR(2));
+		}
+	}
+
+	g_max_selected_row = i - current_page * g_max_data_rows - 1 - empty_col;
+
+	return max_pages;
+}
+
+static uint8_t
+refresh_bdevs_tab(uint8_t current_page)
+{
+	return refresh_list_tab(BDEVS_TAB, g_last_bdevs_count, draw_bdev_tab_row, current_page);
+}
+
+static uint8_t
+refresh_subsystems_tab(uint8_t current_page)
+{
+	return refresh_list_tab(SUBSYSTEMS_TAB, g_last_subsystems_count, draw_subsystem_tab_row,
+				current_page);
+}
+
 static uint8_t
 refresh_tab(enum tabs tab, uint8_t current_page)
 {
-	uint8_t (*refresh_function[NUMBER_OF_TABS])(uint8_t current_page) = {refresh_threads_tab, refresh_pollers_tab, refresh_cores_tab};
-	int color_pair[NUMBER_OF_TABS] = {COLOR_PAIR(2), COLOR_PAIR(2), COLOR_PAIR(2)};
+	uint8_t (*refresh_function[NUMBER_OF_TABS])(uint8_t current_page) = {
+		refresh_threads_tab, refresh_pollers_tab, refresh_cores_tab, refresh_bdevs_tab,
+		refresh_subsystems_tab
+	};
+	int color_pair[NUMBER_OF_TABS] = {COLOR_PAIR(2), COLOR_PAIR(2), COLOR_PAIR(2), COLOR_PAIR(2),
+					  COLOR_PAIR(2)
+					 };
 	int i;
 	uint8_t max_pages = 0;
 
@@ -2477,9 +3435,15 @@ display_thread(uint64_t thread_id, uint8_t current_page, uint8_t active_tab,
 
 	memset(&thread_info, 0, sizeof(thread_info));
 
+	/* The pollers aren't fetched periodically when the statistics are read from shared memory */
+	pthread_mutex_lock(&g_thread_lock);
+	g_pollers_needed = true;
+	pthread_mutex_unlock(&g_thread_lock);
+
 	while (!stop_loop) {
 		pthread_mutex_lock(&g_thread_lock);
 		if (get_single_thread_info(thread_id, &thread_info)) {
+			g_pollers_needed = false;
 			pthread_mutex_unlock(&g_thread_lock);
 			free(thread_info.name);
 			free(thread_info.cpumask);
@@ -2560,6 +3524,10 @@ display_thread(uint64_t thread_id, uint8_t current_page, uint8_t active_tab,
 		thread_info.cpumask = NULL;
 	}
 
+	pthread_mutex_lock(&g_thread_lock);
+	g_pollers_needed = false;
+	pthread_mutex_unlock(&g_thread_lock);
+
 	del_panel(thread_panel);
 	delwin(thread_win);
 }
@@ -2715,7 +3683,7 @@ static void
 draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 {
 	uint64_t last_run_counter, last_busy_counter, busy_count;
-	char poller_period[MAX_TIME_STR_LEN];
+	char poller_period[MAX_TIME_STR_LEN], run_time[MAX_TIME_STR_LEN];
 
 	box(poller_win, 0, 0);
 
@@ -2762,6 +3730,23 @@ draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH - 7, "Status:", COLOR_PAIR(5));
 		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH + 6, "Idle", COLOR_PAIR(7));
 	}
+	mvwhline(poller_win, 7, 1, ACS_HLINE, POLLER_WIN_WIDTH - 2);
+
+	print_left(poller_win, 8, 2, POLLER_WIN_WIDTH, "Max run:              P99 run:",
+		   COLOR_PAIR(5));
+	if (poller_info->max_run_ticks != 0) {
+		get_time_str(poller_info->max_run_ticks, run_time);
+		mvwprintw(poller_win, 8, POLLER_WIN_FIRST_COL, "%s us", run_time);
+	} else {
+		mvwprintw(poller_win, 8, POLLER_WIN_FIRST_COL, "%s", "N/A");
+	}
+	if (poller_info->p99_run_ticks != 0) {
+		get_time_str(poller_info->p99_run_ticks, run_time);
+		mvwprintw(poller_win, 8, POLLER_WIN_FIRST_COL + 23, "%s us (%" PRIu64 " slow)",
+			  run_time, poller_info->slow_run_count);
+	} else {
+		mvwprintw(poller_win, 8, POLLER_WIN_FIRST_COL + 23, "%s", "N/A");
+	}
 
 	wnoutrefresh(poller_win);
 }
@@ -2959,6 +3944,8 @@ data_thread_routine(void *arg)
 {
 	int rc;
 	uint64_t refresh_rate;
+	uint8_t active_tab;
+	bool pollers_needed;
 
 	while (1) {
 		pthread_mutex_lock(&g_thread_lock);
@@ -2973,6 +3960,11 @@ data_thread_routine(void *arg)
 		} else {
 			refresh_rate = g_sleep_time * SPDK_SEC_TO_USEC;
 		}
+		active_tab = g_active_tab;
+		/* Listing the pollers requires an RPC, so when the rest is read from shared
+		 * memory, only do that if they're displayed. */
+		pollers_needed = g_app_stats == NULL || g_pollers_needed ||
+				 active_tab == POLLERS_TAB;
 		pthread_mutex_unlock(&g_thread_lock);
 
 		/* Get data from RPC for each object type.
@@ -2986,10 +3978,27 @@ data_thread_routine(void *arg)
 			print_bottom_message("ERROR occurred while getting threads data");
 		}
 
-		rc = get_pollers_data();
-		if (rc) {
-			print_bottom_message("ERROR occurred while getting pollers data");
+		if (pollers_needed) {
+			rc = get_pollers_data();
+			if (rc) {
+				print_bottom_message("ERROR occurred while getting pollers data");
+			}
 		}
+
+		if (active_tab == BDEVS_TAB || active_tab == SUBSYSTEMS_TAB) {
+			rc = get_bdevs_data();
+			if (rc) {
+				print_bottom_message("ERROR occurred while getting bdevs data");
+			}
+		}
+
+		if (active_tab == SUBSYSTEMS_TAB) {
+			rc = get_subsystems_data();
+			if (rc) {
+				print_bottom_message("ERROR occurred while getting subsystems data");
+			}
+		}
+
 		rc = get_scheduler_data();
 		if (rc) {
 			print_bottom_message("ERROR occurred while getting scheduler data");
@@ -3033,7 +4042,7 @@ help_window_display(void)
 	print_left(help_win, ++row, col,  HELP_WIN_WIDTH,
 		   "[Tab] Next tab	- switch to next tab", COLOR_PAIR(10));
 	print_left(help_win, ++row, col,  HELP_WIN_WIDTH,
-		   "[1-3] Select tab	- switch to THREADS, POLLERS or CORES tab", COLOR_PAIR(10));
+		   "[1-5] Select tab	- switch to the tab with given number", COLOR_PAIR(10));
 	print_left(help_win, ++row, col,  HELP_WIN_WIDTH,
 		   "[PgUp] Previous page	- scroll up to previous page", COLOR_PAIR(10));
 	print_left(help_win, ++row, col,  HELP_WIN_WIDTH,
@@ -3172,6 +4181,8 @@ show_stats(pthread_t *data_thread)
 		case '1':
 		case '2':
 		case '3':
+		case '4':
+		case '5':
 			active_tab = c - '1';
 			current_page = 0;
 			g_selected_row = 0;
@@ -3277,6 +4288,8 @@ show_stats(pthread_t *data_thread)
 		free_rpc_threads_stats(&g_threads_info[i]);
 	}
 	free_rpc_core_info(g_cores_info, g_last_cores_count);
+	free_rpc_bdevs(g_bdevs_info, g_last_bdevs_count);
+	free_rpc_subsystems(g_subsystems_info, g_last_subsystems_count);
 	free_rpc_scheduler(&g_scheduler_info);
 }
 
@@ -3319,6 +4332,9 @@ finish(int sig)
 	/* End ncurses mode */
 	endwin();
 	spdk_jsonrpc_client_close(g_rpc_client);
+	if (g_app_stats != NULL) {
+		munmap(g_app_stats, sizeof(*g_app_stats));
+	}
 	exit(0);
 }
 
@@ -3361,6 +4377,8 @@ usage(const char *program_name)
 	printf("\n");
 	printf("options:\n");
 	printf(" -r <path>  RPC connect address (default: /var/tmp/spdk.sock)\n");
+	printf(" -R         get the reactors and threads statistics through RPCs\n");
+	printf("            instead of shared memory\n");
 	printf(" -h         show this usage\n");
 }
 
@@ -3386,6 +4404,40 @@ rpc_decode_tick_rate(struct spdk_json_val *val, uint64_t *tick_rate)
 	return rc;
 }
 
+static void
+open_stats_shm(struct spdk_json_val *val)
+{
+	const struct spdk_json_object_decoder rpc_stats_shm_decoder[] = {
+		{"stats_shm_name", 0, spdk_json_decode_string, true}
+	};
+	char *shm_name = NULL;
+	void *addr;
+	int fd;
+
+	if (spdk_json_decode_object_relaxed(val, rpc_stats_shm_decoder,
+					    SPDK_COUNTOF(rpc_stats_shm_decoder), &shm_name) ||
+	    shm_name == NULL) {
+		goto end;
+	}
+
+	/* The shared memory isn't accessible when connected to a remote application, the RPCs
+	 * are used then. */
+	fd = shm_open(shm_name, O_RDONLY, 0);
+	if (fd < 0) {
+		goto end;
+	}
+
+	addr = mmap(NULL, sizeof(struct spdk_app_stats), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		goto end;
+	}
+
+	g_app_stats = addr;
+end:
+	free(shm_name);
+}
+
 static int
 wait_init(pthread_t *data_thread)
 {
@@ -3430,6 +4482,10 @@ wait_init(pthread_t *data_thread)
 		return -EINVAL;
 	}
 
+	if (!g_disable_stats_shm) {
+		open_stats_shm(json_resp->result);
+	}
+
 	spdk_jsonrpc_client_free_response(json_resp);
 
 	g_tick_rate = tick_rate;
@@ -3468,11 +4524,14 @@ main(int argc, char **argv)
 	char *socket = SPDK_DEFAULT_RPC_ADDR;
 	pthread_t data_thread;
 
-	while ((op = getopt(argc, argv, "r:h")) != -1) {
+	while ((op = getopt(argc, argv, "r:Rh")) != -1) {
 		switch (op) {
 		case 'r':
 			socket = optarg;
 			break;
+		case 'R':
+			g_disable_stats_shm = true;
+			break;
 		default:
 			usage(argv[0]);
 			return op == 'h' ? 0 : 1;
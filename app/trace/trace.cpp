@@ -10,7 +10,10 @@
 #include "spdk/string.h"
 #include "spdk/util.h"
 
+#include <algorithm>
 #include <map>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include "spdk/trace_parser.h"
@@ -22,6 +25,23 @@ static const struct spdk_trace_flags *g_flags;
 static struct spdk_json_write_ctx *g_json;
 static bool g_print_tsc = false;
 
+/* Request-flow analysis */
+struct flow_event {
+	uint64_t	tsc;
+	uint64_t	object;
+	uint16_t	tpoint_id;
+	uint16_t	lcore;
+};
+
+typedef std::vector<uint64_t> latency_list;
+
+static bool g_analyze = false;
+static FILE *g_export_file;
+static std::vector<flow_event> g_flow_events;
+/* Object (see flow_object_key()) tied to the object it was submitted on behalf of */
+static std::map<uint64_t, uint64_t> g_flow_parents;
+static std::map<std::string, latency_list> g_flow_stages;
+
 /* This is a bit ugly, but we don't want to include env_dpdk in the app, while spdk_util, which we
  * do need, uses some of the functions implemented there.  We're not actually using the functions
  * that depend on those, so just define them as no-ops to allow the app to link.
@@ -318,6 +338,221 @@ print_json(void *cb_ctx, const void *data, size_t size)
 	return 0;
 }
 
+static uint64_t
+flow_object_key(uint8_t object_type, uint64_t object_index)
+{
+	return ((uint64_t)object_type << 56) | (object_index & ((1ULL << 56) - 1));
+}
+
+static void
+flow_add_event(struct spdk_trace_parser_entry *entry)
+{
+	const struct spdk_trace_tpoint *d = &g_flags->tpoint[entry->entry->tpoint_id];
+	flow_event event;
+
+	if (d->object_type == OBJECT_NONE || entry->object_index == UINT64_MAX) {
+		return;
+	}
+
+	event.tsc = entry->entry->tsc;
+	event.object = flow_object_key(d->object_type, entry->object_index);
+	event.tpoint_id = entry->entry->tpoint_id;
+	event.lcore = entry->lcore;
+	g_flow_events.push_back(event);
+
+	/* Related objects link the layers of a request, e.g. a bdev_io to the NVMe-oF request
+	 * that submitted it.
+	 */
+	if (entry->related_type != OBJECT_NONE && entry->related_index != UINT64_MAX) {
+		g_flow_parents.emplace(event.object,
+				       flow_object_key(entry->related_type, entry->related_index));
+	}
+}
+
+static uint64_t
+flow_get_root(uint64_t object)
+{
+	std::map<uint64_t, uint64_t>::iterator it;
+	int depth;
+
+	/* Limit the depth in case the relations form a cycle */
+	for (depth = 0; depth < 16; depth++) {
+		it = g_flow_parents.find(object);
+		if (it == g_flow_parents.end() || it->second == object) {
+			break;
+		}
+		object = it->second;
+	}
+
+	return object;
+}
+
+static std::string
+flow_object_name(uint64_t object)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "%c%" PRIu64, g_flags->object[object >> 56].id_prefix,
+		 (uint64_t)(object & ((1ULL << 56) - 1)));
+
+	return name;
+}
+
+static void
+flow_export_event(const char *phase, const char *name, uint64_t root, const flow_event &event,
+		  uint64_t tsc_offset)
+{
+	spdk_json_write_object_begin(g_json);
+	spdk_json_write_named_string(g_json, "ph", phase);
+	spdk_json_write_named_string(g_json, "name", name);
+	spdk_json_write_named_string(g_json, "cat", "request");
+	spdk_json_write_named_string_fmt(g_json, "id", "0x%" PRIx64, root);
+	spdk_json_write_named_double(g_json, "ts", get_us_from_tsc(event.tsc - tsc_offset,
+				     g_flags->tsc_rate));
+	spdk_json_write_named_uint32(g_json, "pid", 0);
+	spdk_json_write_named_uint32(g_json, "tid", event.lcore);
+	spdk_json_write_object_end(g_json);
+}
+
+/* Emit each request as an async slice, with a nested slice for each of its objects and an
+ * instant event for each of the tracepoints (Trace Event Format, as used by Chrome and Perfetto).
+ */
+static void
+flow_export_request(uint64_t root, const std::vector<flow_event> &events, uint64_t tsc_offset)
+{
+	std::map<uint64_t, std::pair<size_t, size_t>> spans;
+	std::map<uint64_t, std::pair<size_t, size_t>>::iterator it;
+	std::string name;
+	size_t i;
+
+	for (i = 0; i < events.size(); i++) {
+		it = spans.find(events[i].object);
+		if (it == spans.end()) {
+			spans.emplace(events[i].object, std::make_pair(i, i));
+		} else {
+			it->second.second = i;
+		}
+	}
+
+	for (it = spans.begin(); it != spans.end(); it++) {
+		name = flow_object_name(it->first);
+		flow_export_event("b", name.c_str(), root, events[it->second.first], tsc_offset);
+		flow_export_event("e", name.c_str(), root, events[it->second.second], tsc_offset);
+	}
+
+	for (i = 0; i < events.size(); i++) {
+		flow_export_event("n", g_flags->tpoint[events[i].tpoint_id].name, root, events[i],
+				  tsc_offset);
+	}
+}
+
+static int
+flow_export_write(void *cb_ctx, const void *data, size_t size)
+{
+	if (fwrite(data, 1, size, g_export_file) != size) {
+		fprintf(stderr, "%s: failed to write the trace export: %s\n", g_exe_name,
+			spdk_strerror(errno));
+		abort();
+	}
+
+	return 0;
+}
+
+static void
+flow_print_stage(const std::string &name, latency_list &latencies)
+{
+	uint64_t tsc_rate = g_flags->tsc_rate;
+	uint64_t buckets[64] = {}, sum = 0, us;
+	size_t i, count = latencies.size();
+	int bucket, last = 0;
+
+	std::sort(latencies.begin(), latencies.end());
+	for (i = 0; i < count; i++) {
+		sum += latencies[i];
+		us = latencies[i] * SPDK_SEC_TO_USEC / tsc_rate;
+		bucket = us == 0 ? 0 : spdk_u64log2(us) + 1;
+		buckets[bucket]++;
+		last = spdk_max(last, bucket);
+	}
+
+	printf("%s\n", name.c_str());
+	printf("  count: %zu avg: %.3f min: %.3f p50: %.3f p99: %.3f p99.9: %.3f max: %.3f (us)\n",
+	       count, get_us_from_tsc(sum / count, tsc_rate),
+	       get_us_from_tsc(latencies[0], tsc_rate),
+	       get_us_from_tsc(latencies[count / 2], tsc_rate),
+	       get_us_from_tsc(latencies[count * 99 / 100], tsc_rate),
+	       get_us_from_tsc(latencies[count * 999 / 1000], tsc_rate),
+	       get_us_from_tsc(latencies[count - 1], tsc_rate));
+
+	for (bucket = 0; bucket <= last; bucket++) {
+		if (bucket == 0) {
+			printf("  %10s < %-8u us: %10" PRIu64 "\n", "", 1, buckets[bucket]);
+		} else {
+			printf("  %10" PRIu64 " - %-8" PRIu64 " us: %10" PRIu64 "\n",
+			       (uint64_t)1 << (bucket - 1), ((uint64_t)1 << bucket) - 1,
+			       buckets[bucket]);
+		}
+	}
+}
+
+/* Stitch the events of each request across the layers and break its latency down into stages,
+ * each one spanning two consecutive tracepoints of the request.
+ */
+static void
+flow_analyze(uint64_t tsc_offset)
+{
+	std::map<uint64_t, std::vector<flow_event>> requests;
+	std::map<uint64_t, std::vector<flow_event>>::iterator it;
+	std::map<std::string, latency_list>::iterator stage;
+	std::string name;
+	size_t i;
+
+	for (i = 0; i < g_flow_events.size(); i++) {
+		requests[flow_get_root(g_flow_events[i].object)].push_back(g_flow_events[i]);
+	}
+
+	if (g_export_file != NULL) {
+		g_json = spdk_json_write_begin(flow_export_write, NULL, 0);
+		if (g_json == NULL) {
+			fprintf(stderr, "Failed to allocate JSON write context\n");
+			exit(1);
+		}
+		spdk_json_write_object_begin(g_json);
+		spdk_json_write_named_string(g_json, "displayTimeUnit", "ns");
+		spdk_json_write_named_array_begin(g_json, "traceEvents");
+	}
+
+	for (it = requests.begin(); it != requests.end(); it++) {
+		std::vector<flow_event> &events = it->second;
+
+		/* The events are already sorted by tsc, as that's the order they're parsed in */
+		for (i = 1; i < events.size(); i++) {
+			name = std::string(g_flags->tpoint[events[i - 1].tpoint_id].name) + " -> " +
+			       g_flags->tpoint[events[i].tpoint_id].name;
+			g_flow_stages[name].push_back(events[i].tsc - events[i - 1].tsc);
+		}
+		if (events.size() > 1) {
+			g_flow_stages["total"].push_back(events.back().tsc - events.front().tsc);
+		}
+
+		if (g_json != NULL) {
+			flow_export_request(it->first, events, tsc_offset);
+		}
+	}
+
+	if (g_json != NULL) {
+		spdk_json_write_array_end(g_json);
+		spdk_json_write_object_end(g_json);
+		spdk_json_write_end(g_json);
+		g_json = NULL;
+	}
+
+	printf("Analyzed %zu requests\n", requests.size());
+	for (stage = g_flow_stages.begin(); stage != g_flow_stages.end(); stage++) {
+		flow_print_stage(stage->first, stage->second);
+	}
+}
+
 static void
 usage(void)
 {
@@ -334,6 +569,10 @@ usage(void)
 	fprintf(stderr, "                 '-f' to specify a tracepoint file name\n");
 	fprintf(stderr, "                      (-s and -f are mutually exclusive)\n");
 	fprintf(stderr, "                 '-j' to use JSON to format the output\n");
+	fprintf(stderr, "                 '-a' to stitch the events of each request across\n");
+	fprintf(stderr, "                      the layers and print the latency of its stages\n");
+	fprintf(stderr, "                 '-o' to export the requests as a Chrome/Perfetto\n");
+	fprintf(stderr, "                      trace JSON file (implies -a)\n");
 }
 
 int
@@ -345,13 +584,14 @@ main(int argc, char **argv)
 	uint64_t			tsc_offset, entry_count;
 	const char			*app_name = NULL;
 	const char			*file_name = NULL;
+	const char			*export_name = NULL;
 	int				op, i;
 	char				shm_name[64];
 	int				shm_id = -1, shm_pid = -1;
 	bool				json = false;
 
 	g_exe_name = argv[0];
-	while ((op = getopt(argc, argv, "c:f:i:jp:s:t")) != -1) {
+	while ((op = getopt(argc, argv, "ac:f:i:jo:p:s:t")) != -1) {
 		switch (op) {
 		case 'c':
 			lcore = atoi(optarg);
@@ -380,6 +620,13 @@ main(int argc, char **argv)
 		case 'j':
 			json = true;
 			break;
+		case 'a':
+			g_analyze = true;
+			break;
+		case 'o':
+			g_analyze = true;
+			export_name = optarg;
+			break;
 		default:
 			usage();
 			exit(1);
@@ -398,6 +645,21 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (json && g_analyze) {
+		fprintf(stderr, "-j can't be used with -a or -o\n");
+		usage();
+		exit(1);
+	}
+
+	if (export_name != NULL) {
+		g_export_file = fopen(export_name, "w");
+		if (g_export_file == NULL) {
+			fprintf(stderr, "Could not open %s: %s\n", export_name,
+				spdk_strerror(errno));
+			exit(1);
+		}
+	}
+
 	if (json) {
 		g_json = spdk_json_write_begin(print_json, NULL, 0);
 		if (g_json == NULL) {
@@ -447,9 +709,20 @@ main(int argc, char **argv)
 		if (entry.entry->tsc < tsc_offset) {
 			continue;
 		}
+		if (g_analyze) {
+			flow_add_event(&entry);
+			continue;
+		}
 		process_event(&entry, g_flags->tsc_rate, tsc_offset);
 	}
 
+	if (g_analyze) {
+		flow_analyze(tsc_offset);
+		if (g_export_file != NULL) {
+			fclose(g_export_file);
+		}
+	}
+
 	if (g_json != NULL) {
 		spdk_json_write_array_end(g_json);
 		spdk_json_write_object_end(g_json);
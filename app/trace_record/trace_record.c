@@ -19,6 +19,7 @@ static int g_verbose = 1;
 static uint64_t g_tsc_rate;
 static uint64_t g_utsc_rate;
 static bool g_shutdown = false;
+static bool g_lossless = false;
 static uint64_t g_histories_size;
 
 struct lcore_trace_record_ctx {
@@ -28,15 +29,19 @@ struct lcore_trace_record_ctx {
 	struct spdk_trace_history *in_history;
 	struct spdk_trace_history *out_history;
 
-	/* Recorded next entry index in record */
-	uint64_t rec_next_entry;
+	/* Offset of the next byte to record */
+	uint64_t rec_next_offset;
+	bool started;
 
 	/* Record tsc for report */
 	uint64_t first_entry_tsc;
 	uint64_t last_entry_tsc;
 
-	/* Total number of entries in lcore trace file */
-	uint64_t num_entries;
+	/* Total number of bytes in lcore trace file */
+	uint64_t num_bytes;
+
+	/* Number of dropped trace records already reported */
+	uint64_t num_dropped;
 };
 
 struct aggr_trace_record_ctx {
@@ -51,9 +56,10 @@ static int
 input_trace_file_mmap(struct aggr_trace_record_ctx *ctx, const char *shm_name)
 {
 	void *history_ptr;
+	uint64_t next_offset, buffer_size;
 	int i;
 
-	ctx->shm_fd = shm_open(shm_name, O_RDONLY, 0);
+	ctx->shm_fd = shm_open(shm_name, g_lossless ? O_RDWR : O_RDONLY, 0);
 	if (ctx->shm_fd < 0) {
 		fprintf(stderr, "Could not open %s.\n", shm_name);
 		return -1;
@@ -86,7 +92,9 @@ input_trace_file_mmap(struct aggr_trace_record_ctx *ctx, const char *shm_name)
 	/* Remap the entire trace file */
 	g_histories_size = spdk_get_trace_histories_size(ctx->trace_histories);
 	munmap(history_ptr, sizeof(struct spdk_trace_histories));
-	history_ptr = mmap(NULL, g_histories_size, PROT_READ, MAP_SHARED, ctx->shm_fd, 0);
+	/* The consumer's position needs to be published in lossless mode */
+	history_ptr = mmap(NULL, g_histories_size, PROT_READ | (g_lossless ? PROT_WRITE : 0),
+			   MAP_SHARED, ctx->shm_fd, 0);
 	if (history_ptr == MAP_FAILED) {
 		fprintf(stderr, "Could not remmap shm %s.\n", shm_name);
 		close(ctx->shm_fd);
@@ -101,9 +109,19 @@ input_trace_file_mmap(struct aggr_trace_record_ctx *ctx, const char *shm_name)
 		ctx->lcore_ports[i].in_history = history;
 		ctx->lcore_ports[i].valid = (history != NULL);
 
+		if (history != NULL && g_lossless) {
+			/* Start from the eldest entry that's still present in the buffer */
+			buffer_size = spdk_get_trace_history_buffer_size(history);
+			next_offset = history->next_offset;
+			history->consumer_offset = next_offset - spdk_min(next_offset, buffer_size);
+			ctx->lcore_ports[i].num_dropped = history->num_dropped;
+			spdk_smp_wmb();
+			history->consumer_attached = 1;
+		}
+
 		if (g_verbose && history) {
-			printf("Number of trace entries for lcore (%d): %ju\n", i,
-			       history->num_entries);
+			printf("Size of trace buffer for lcore (%d): %ju\n", i,
+			       spdk_get_trace_history_buffer_size(history));
 		}
 	}
 
@@ -255,183 +273,140 @@ cont_read(int fildes, void *buf, size_t nbyte)
 	return nbyte;
 }
 
-static int
-lcore_trace_last_entry_idx(struct spdk_trace_history *in_history, int cir_next_idx)
-{
-	int last_idx;
-
-	if (cir_next_idx == 0) {
-		last_idx = in_history->num_entries - 1;
-	} else {
-		last_idx = cir_next_idx - 1;
-	}
-
-	return last_idx;
-}
-
-static int
-circular_buffer_padding_backward(int fd, struct spdk_trace_history *in_history,
-				 int cir_start, int cir_end)
-{
-	int rc;
-
-	if (cir_end <= cir_start) {
-		fprintf(stderr, "Wrong using of circular_buffer_padding_back\n");
-		return -1;
-	}
-
-	rc = cont_write(fd, &in_history->entries[cir_start],
-			sizeof(struct spdk_trace_entry) * (cir_end - cir_start));
-	if (rc < 0) {
-		fprintf(stderr, "Failed to append entries into lcore file\n");
-		return rc;
-	}
-
-	return 0;
-}
+static const uint8_t g_zero_frame[SPDK_TRACE_FRAME_SIZE];
 
 static int
-circular_buffer_padding_across(int fd, struct spdk_trace_history *in_history,
-			       int cir_start, int cir_end)
+circular_buffer_copy(int fd, struct spdk_trace_history *in_history, uint64_t start, uint64_t end)
 {
+	uint64_t buffer_size = spdk_get_trace_history_buffer_size(in_history);
+	uint64_t cir_start = start & (buffer_size - 1);
+	uint64_t len;
 	int rc;
-	int num_entries = in_history->num_entries;
-
-	if (cir_end > cir_start) {
-		fprintf(stderr, "Wrong using of circular_buffer_padding_across\n");
-		return -1;
-	}
 
-	rc = cont_write(fd, &in_history->entries[cir_start],
-			sizeof(struct spdk_trace_entry) * (num_entries - cir_start));
-	if (rc < 0) {
-		fprintf(stderr, "Failed to append entries into lcore file backward\n");
-		return rc;
-	}
-
-	if (cir_end == 0) {
-		return 0;
-	}
+	while (start < end) {
+		/* Copy up to the end of the circular buffer at once */
+		len = spdk_min(end - start, buffer_size - cir_start);
+		rc = cont_write(fd, &in_history->data[cir_start], len);
+		if (rc < 0) {
+			fprintf(stderr, "Failed to append trace records into lcore file\n");
+			return rc;
+		}
 
-	rc = cont_write(fd, &in_history->entries[0], sizeof(struct spdk_trace_entry) * cir_end);
-	if (rc < 0) {
-		fprintf(stderr, "Failed to append entries into lcore file forward\n");
-		return rc;
+		start += len;
+		cir_start = 0;
 	}
 
 	return 0;
 }
 
-static int
-circular_buffer_padding_all(int fd, struct spdk_trace_history *in_history,
-			    int cir_end)
-{
-	return circular_buffer_padding_across(fd, in_history, cir_end, cir_end);
-}
-
 static int
 lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
 {
 	struct spdk_trace_history	*in_history = lcore_port->in_history;
-	uint64_t			rec_next_entry = lcore_port->rec_next_entry;
-	uint64_t			rec_num_entries = lcore_port->num_entries;
-	int				fd = lcore_port->fd;
-	uint64_t			shm_next_entry;
-	uint64_t			num_cir_entries;
-	uint64_t			shm_cir_next;
-	uint64_t			rec_cir_next;
+	uint64_t			rec_next_offset = lcore_port->rec_next_offset;
+	uint64_t			rec_num_bytes = lcore_port->num_bytes;
+	uint64_t			buffer_size, frame_size, padding;
+	uint64_t			shm_next_offset;
 	int				rc;
-	int				last_idx;
 
-	shm_next_entry = in_history->next_entry;
+	shm_next_offset = in_history->next_offset;
 
-	/* Ensure all entries of spdk_trace_history are latest to next_entry */
+	/* Ensure all records of spdk_trace_history are latest to next_offset */
 	spdk_smp_rmb();
 
-	if (shm_next_entry == rec_next_entry) {
+	if (shm_next_offset == rec_next_offset) {
 		/* There is no update */
 		return 0;
-	} else if (shm_next_entry < rec_next_entry) {
+	} else if (shm_next_offset < rec_next_offset) {
 		/* Error branch */
 		fprintf(stderr, "Trace porting error in lcore %d, trace rollback occurs.\n", in_history->lcore);
-		fprintf(stderr, "shm_next_entry is %ju, record_next_entry is %ju.\n", shm_next_entry,
-			rec_next_entry);
+		fprintf(stderr, "shm_next_offset is %ju, record_next_offset is %ju.\n",
+			shm_next_offset, rec_next_offset);
 		return -1;
 	}
 
-	num_cir_entries = in_history->num_entries;
-	shm_cir_next = shm_next_entry & (num_cir_entries - 1);
-
-	/* Record first entry's tsc and corresponding entries when recording first time. */
-	if (lcore_port->first_entry_tsc == 0) {
-		if (shm_next_entry < num_cir_entries) {
-			/* Updates haven't been across circular buffer yet.
-			 * The first entry in shared memory is the eldest one.
-			 */
-			lcore_port->first_entry_tsc = in_history->entries[0].tsc;
+	buffer_size = spdk_get_trace_history_buffer_size(in_history);
+	frame_size = in_history->frame_size;
 
-			lcore_port->num_entries += shm_cir_next;
-			rc = circular_buffer_padding_backward(fd, in_history, 0, shm_cir_next);
-		} else {
-			/* Updates have already been across circular buffer.
-			 * The eldest entry in shared memory is pointed by shm_cir_next.
-			 */
-			lcore_port->first_entry_tsc = in_history->entries[shm_cir_next].tsc;
-
-			lcore_port->num_entries += num_cir_entries;
-			rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
+	if (!lcore_port->started) {
+		/* Start from the eldest frame that's still present in the buffer, so that the lcore
+		 * file starts at a frame boundary.
+		 */
+		rec_next_offset = 0;
+		if (shm_next_offset > buffer_size) {
+			rec_next_offset = spdk_divide_round_up(shm_next_offset - buffer_size,
+							       frame_size) * frame_size;
 		}
-
-		goto out;
-	}
-
-	if (shm_next_entry - rec_next_entry > num_cir_entries) {
-		/* There must be missed updates */
-		fprintf(stderr, "Trace-record missed %ju trace entries\n",
-			shm_next_entry - rec_next_entry - num_cir_entries);
-
-		lcore_port->num_entries += num_cir_entries;
-		rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
-	} else if (shm_next_entry - rec_next_entry == num_cir_entries) {
-		/* All circular buffer is updated */
-		lcore_port->num_entries += num_cir_entries;
-		rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
-	} else {
-		/* Part of circular buffer is updated */
-		rec_cir_next = rec_next_entry & (num_cir_entries - 1);
-
-		if (shm_cir_next > rec_cir_next) {
-			/* Updates are not across circular buffer */
-			lcore_port->num_entries += shm_cir_next - rec_cir_next;
-			rc = circular_buffer_padding_backward(fd, in_history, rec_cir_next, shm_cir_next);
-		} else {
-			/* Updates are across circular buffer */
-			lcore_port->num_entries += num_cir_entries - rec_cir_next + shm_cir_next;
-			rc = circular_buffer_padding_across(fd, in_history, rec_cir_next, shm_cir_next);
+		lcore_port->first_entry_tsc = in_history->last_tsc;
+		lcore_port->started = true;
+	} else if (shm_next_offset - rec_next_offset > buffer_size) {
+		/* There must be missed updates.  Fill the rest of the current frame with zeroes
+		 * (marking it as unused), so that the records that follow are still aligned to
+		 * the frames in the lcore file.
+		 */
+		padding = (frame_size - (rec_next_offset & (frame_size - 1))) & (frame_size - 1);
+		rc = cont_write(lcore_port->fd, g_zero_frame, padding);
+		if (rc < 0) {
+			fprintf(stderr, "Failed to pad lcore file\n");
+			return rc;
 		}
+		lcore_port->num_bytes += padding;
+
+		rec_next_offset = spdk_divide_round_up(shm_next_offset - buffer_size,
+						       frame_size) * frame_size;
+		fprintf(stderr, "Trace-record missed %ju bytes of trace records\n",
+			rec_next_offset - lcore_port->rec_next_offset - padding);
 	}
 
-out:
+	rc = circular_buffer_copy(lcore_port->fd, in_history, rec_next_offset, shm_next_offset);
 	if (rc) {
 		return rc;
 	}
+	lcore_port->num_bytes += shm_next_offset - rec_next_offset;
 
 	if (g_verbose) {
-		printf("Append %ju trace_entry for lcore %d\n", lcore_port->num_entries - rec_num_entries,
-		       in_history->lcore);
+		printf("Append %ju bytes of trace records for lcore %d\n",
+		       lcore_port->num_bytes - rec_num_bytes, in_history->lcore);
 	}
 
 	/* Update tpoint_count info */
 	memcpy(lcore_port->out_history, lcore_port->in_history, sizeof(struct spdk_trace_history));
 
-	/* Update last_entry_tsc to align with appended entries */
-	last_idx = lcore_trace_last_entry_idx(in_history, shm_cir_next);
-	lcore_port->last_entry_tsc = in_history->entries[last_idx].tsc;
-	lcore_port->rec_next_entry = shm_next_entry;
+	lcore_port->last_entry_tsc = in_history->last_tsc;
+	lcore_port->rec_next_offset = shm_next_offset;
+
+	if (g_lossless) {
+		/* Let the producer reuse the data that was just recorded */
+		__atomic_store_n(&in_history->consumer_offset, shm_next_offset, __ATOMIC_RELEASE);
+		if (in_history->num_dropped != lcore_port->num_dropped) {
+			fprintf(stderr, "Trace-record dropped %ju trace records in lcore %d\n",
+				in_history->num_dropped - lcore_port->num_dropped,
+				in_history->lcore);
+			lcore_port->num_dropped = in_history->num_dropped;
+		}
+	}
 
 	return rc;
 }
 
+static void
+lcore_trace_detach(struct aggr_trace_record_ctx *ctx)
+{
+	struct lcore_trace_record_ctx *lcore_port;
+	int i;
+
+	if (!g_lossless) {
+		return;
+	}
+
+	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
+		lcore_port = &ctx->lcore_ports[i];
+		if (lcore_port->valid) {
+			lcore_port->in_history->consumer_attached = 0;
+		}
+	}
+}
+
 static int
 trace_files_aggregate(struct aggr_trace_record_ctx *ctx)
 {
@@ -468,7 +443,9 @@ trace_files_aggregate(struct aggr_trace_record_ctx *ctx)
 		lcore_port = &ctx->lcore_ports[i];
 		if (lcore_port->valid) {
 			lcore_offsets[i] = current_offset;
-			current_offset += spdk_get_trace_history_size(lcore_port->num_entries);
+			current_offset += spdk_get_trace_history_size(
+						  spdk_divide_round_up(lcore_port->num_bytes,
+								  sizeof(struct spdk_trace_entry)));
 		} else {
 			lcore_offsets[i] = 0;
 		}
@@ -489,14 +466,21 @@ trace_files_aggregate(struct aggr_trace_record_ctx *ctx)
 			continue;
 		}
 
-		lcore_port->out_history->num_entries = lcore_port->num_entries;
+		/* The records are no longer stored in a circular buffer, the first one starts
+		 * at the beginning of the buffer and they're followed by zero padding.
+		 */
+		lcore_port->out_history->num_entries = spdk_divide_round_up(lcore_port->num_bytes,
+						       sizeof(struct spdk_trace_entry));
+		lcore_port->out_history->next_offset = lcore_port->num_bytes;
+		lcore_port->out_history->consumer_attached = 0;
+		lcore_port->out_history->consumer_offset = 0;
 		rc = cont_write(ctx->out_fd, lcore_port->out_history, sizeof(struct spdk_trace_history));
 		if (rc < 0) {
 			fprintf(stderr, "Failed to write lcore trace header into trace file\n");
 			goto out;
 		}
 
-		/* Move file offset to the start of trace_entries */
+		/* Move file offset to the start of trace records */
 		rc = lseek(lcore_port->fd, 0, SEEK_SET);
 		if (rc != 0) {
 			fprintf(stderr, "Failed to lseek lcore trace file\n");
@@ -508,20 +492,30 @@ trace_files_aggregate(struct aggr_trace_record_ctx *ctx)
 			len_sum += len;
 			rc = cont_write(ctx->out_fd, copy_buff, len);
 			if (rc != len) {
-				fprintf(stderr, "Failed to write lcore trace entries into trace file\n");
+				fprintf(stderr, "Failed to write lcore trace records\n");
 				goto out;
 			}
 		}
 
-		/* Clear rc so that the last cont_write() doesn't get interpreted as a failure. */
-		rc = 0;
+		if (len_sum != lcore_port->num_bytes) {
+			fprintf(stderr, "Len of lcore trace file doesn't match its size\n");
+			rc = -1;
+			goto out;
+		}
 
-		if (len_sum != lcore_port->num_entries * sizeof(struct spdk_trace_entry)) {
-			fprintf(stderr, "Len of lcore trace file doesn't match number of entries for lcore\n");
+		memset(copy_buff, 0, sizeof(struct spdk_trace_entry));
+		rc = cont_write(ctx->out_fd, copy_buff, lcore_port->out_history->num_entries *
+				sizeof(struct spdk_trace_entry) - len_sum);
+		if (rc < 0) {
+			fprintf(stderr, "Failed to pad lcore trace records in trace file\n");
+			goto out;
 		}
+
+		/* Clear rc so that the last cont_write() doesn't get interpreted as a failure. */
+		rc = 0;
 	}
 
-	printf("All lcores trace entries are aggregated into trace file %s\n", ctx->out_file);
+	printf("All lcores trace records are aggregated into trace file %s\n", ctx->out_file);
 
 out:
 	close(ctx->out_fd);
@@ -575,6 +569,8 @@ usage(void)
 	printf("                 '-p' to specify the trace PID\n");
 	printf("                      (one of -i or -p must be specified)\n");
 	printf("                 '-f' to specify output trace file name\n");
+	printf("                 '-l' to make the traced process drop new trace\n");
+	printf("                      entries instead of overwriting unrecorded ones\n");
 	printf("                 '-h' to print usage information\n");
 }
 
@@ -592,11 +588,14 @@ main(int argc, char **argv)
 	struct lcore_trace_record_ctx	*lcore_port;
 
 	g_exe_name = argv[0];
-	while ((op = getopt(argc, argv, "f:i:p:qs:h")) != -1) {
+	while ((op = getopt(argc, argv, "f:i:lp:qs:h")) != -1) {
 		switch (op) {
 		case 'i':
 			shm_id = spdk_strtol(optarg, 10);
 			break;
+		case 'l':
+			g_lossless = true;
+			break;
 		case 'p':
 			shm_pid = spdk_strtol(optarg, 10);
 			break;
@@ -672,6 +671,7 @@ main(int argc, char **argv)
 		}
 	}
 
+	lcore_trace_detach(&ctx);
 	if (rc) {
 		exit(1);
 	}
@@ -687,14 +687,17 @@ main(int argc, char **argv)
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		lcore_port = &ctx.lcore_ports[i];
 
-		if (lcore_port->num_entries == 0) {
+		if (lcore_port->num_bytes == 0) {
 			continue;
 		}
 
-		printf("Port %ju trace entries for lcore (%d) in %ju usec\n",
-		       lcore_port->num_entries, i,
+		printf("Port %ju bytes of trace records for lcore (%d) in %ju usec\n",
+		       lcore_port->num_bytes, i,
 		       (lcore_port->last_entry_tsc - lcore_port->first_entry_tsc) / g_utsc_rate);
-
+		if (lcore_port->in_history->num_dropped != 0) {
+			printf("Dropped %ju trace records for lcore (%d)\n",
+			       lcore_port->in_history->num_dropped, i);
+		}
 	}
 
 	munmap(ctx.trace_histories, g_histories_size);
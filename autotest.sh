@@ -175,6 +175,7 @@ if [ $SPDK_RUN_FUNCTIONAL_TEST -eq 1 ]; then
 	if [ $SPDK_TEST_BLOCKDEV -eq 1 ]; then
 		run_test "blockdev_general" $rootdir/test/bdev/blockdev.sh
 		run_test "bdev_raid" $rootdir/test/bdev/bdev_raid.sh
+		run_test "bdev_shm" $rootdir/test/bdev/bdev_shm.sh
 		run_test "bdevperf_config" $rootdir/test/bdev/bdevperf/test_config.sh
 		if [[ $(uname -s) == Linux ]]; then
 			run_test "reactor_set_interrupt" $rootdir/test/interrupt/reactor_set_interrupt.sh
@@ -262,6 +263,7 @@ if [ $SPDK_RUN_FUNCTIONAL_TEST -eq 1 ]; then
 		run_test "blobfs" $rootdir/test/blobfs/blobfs.sh
 		run_test "hello_blob" $SPDK_EXAMPLE_DIR/hello_blob \
 			examples/blob/hello_world/hello_blob.json
+		run_test "blob_perf" $SPDK_EXAMPLE_DIR/blob_perf -c examples/blob/perf/blob_perf.json
 	fi
 
 	if [ $SPDK_TEST_NVMF -eq 1 ]; then
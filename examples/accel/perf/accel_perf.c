@@ -11,17 +11,25 @@
 #include "spdk/string.h"
 #include "spdk/accel.h"
 #include "spdk/crc32.h"
+#include "spdk/histogram_data.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
 
 #define DATA_PATTERN 0x5a
 #define ALIGN_4K 0x1000
 #define COMP_BUF_PAD_PERCENTAGE 1.1L
+#define MAX_SEQUENCE_LEN 8
+#define MAX_XFER_SIZES 16
 
 static uint64_t	g_tsc_rate;
 static uint64_t g_tsc_end;
 static int g_rc;
 static int g_xfer_size_bytes = 4096;
+/* When more than one transfer size is given, each operation picks one of them at random and
+ * g_xfer_size_bytes holds the largest one, which is what the task buffers are sized for.
+ */
+static uint32_t g_xfer_sizes[MAX_XFER_SIZES];
+static uint32_t g_num_xfer_sizes = 0;
 static int g_queue_depth = 32;
 /* g_allocate_depth indicates how many tasks we allocate per worker. It will
  * be at least as much as the queue depth.
@@ -37,6 +45,11 @@ static uint32_t g_xor_src_count = 2;
 static bool g_verify = false;
 static const char *g_workload_type = NULL;
 static enum spdk_accel_opcode g_workload_selection;
+/* A comma separated workload (e.g. "fill,copy,crc32c") is run as an accel sequence */
+static bool g_sequence = false;
+static enum spdk_accel_opcode g_seq_ops[MAX_SEQUENCE_LEN];
+static uint32_t g_seq_len = 0;
+static const char *g_module_name = NULL;
 static struct worker_thread *g_workers = NULL;
 static int g_num_workers = 0;
 static char *g_cd_file_in_name = NULL;
@@ -82,12 +95,19 @@ struct ap_task {
 	struct ap_compress_seg *cur_seg;
 	struct worker_thread	*worker;
 	int			expected_status; /* used for the compare operation */
+	uint32_t		xfer_size;
+	uint64_t		submit_tsc;
+	/* sequence workload */
+	struct iovec		seq_iovs[MAX_SEQUENCE_LEN * 2];
+	uint32_t		seq_crcs[MAX_SEQUENCE_LEN];
+	void			*seq_buf;
 	TAILQ_ENTRY(ap_task)	link;
 };
 
 struct worker_thread {
 	struct spdk_io_channel		*ch;
 	struct spdk_accel_opcode_stats	stats;
+	struct spdk_histogram_data	*histogram;
 	uint64_t			xfer_failed;
 	uint64_t			injected_miscompares;
 	uint64_t			current_queue_depth;
@@ -104,22 +124,44 @@ struct worker_thread {
 };
 
 static void
-dump_user_config(void)
+dump_module_names(void)
 {
 	const char *module_name = NULL;
+	uint32_t i;
 	int rc;
 
-	rc = spdk_accel_get_opc_module_name(g_workload_selection, &module_name);
-	if (rc) {
-		printf("error getting module name (%d)\n", rc);
+	if (!g_sequence) {
+		rc = spdk_accel_get_opc_module_name(g_workload_selection, &module_name);
+		if (rc) {
+			printf("error getting module name (%d)\n", rc);
+		}
+		printf("Module:         %s\n", module_name);
+		return;
 	}
 
+	/* One module per operation of the sequence, in the same order */
+	printf("Module:         ");
+	for (i = 0; i < g_seq_len; i++) {
+		rc = spdk_accel_get_opc_module_name(g_seq_ops[i], &module_name);
+		printf("%s%s", i == 0 ? "" : ",", rc == 0 ? module_name : "error");
+	}
+	printf("\n");
+}
+
+static void
+dump_user_config(void)
+{
+	uint32_t i;
+
 	printf("\nSPDK Configuration:\n");
 	printf("Core mask:      %s\n\n", g_opts.reactor_mask);
 	printf("Accel Perf Configuration:\n");
 	printf("Workload Type:  %s\n", g_workload_type);
-	if (g_workload_selection == SPDK_ACCEL_OPC_CRC32C ||
-	    g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C) {
+	if (g_sequence) {
+		printf("CRC-32C seed:   %u\n", g_crc32c_seed);
+		printf("Fill pattern:   0x%x\n", g_fill_pattern);
+	} else if (g_workload_selection == SPDK_ACCEL_OPC_CRC32C ||
+		   g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C) {
 		printf("CRC-32C seed:   %u\n", g_crc32c_seed);
 	} else if (g_workload_selection == SPDK_ACCEL_OPC_FILL) {
 		printf("Fill pattern:   0x%x\n", g_fill_pattern);
@@ -131,11 +173,17 @@ dump_user_config(void)
 	if (g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C) {
 		printf("Vector size:    %u bytes\n", g_xfer_size_bytes);
 		printf("Transfer size:  %u bytes\n", g_xfer_size_bytes * g_chained_count);
+	} else if (g_num_xfer_sizes > 1) {
+		printf("Transfer size:  ");
+		for (i = 0; i < g_num_xfer_sizes; i++) {
+			printf("%s%u", i == 0 ? "" : ",", g_xfer_sizes[i]);
+		}
+		printf(" bytes\n");
 	} else {
 		printf("Transfer size:  %u bytes\n", g_xfer_size_bytes);
 	}
 	printf("vector count    %u\n", g_chained_count);
-	printf("Module:         %s\n", module_name);
+	dump_module_names();
 	if (g_workload_selection == SPDK_ACCEL_OPC_COMPRESS ||
 	    g_workload_selection == SPDK_ACCEL_OPC_DECOMPRESS) {
 		printf("File Name:      %s\n", g_cd_file_in_name);
@@ -157,8 +205,13 @@ usage(void)
 	printf("\t[-T number of threads per core\n");
 	printf("\t[-n number of channels]\n");
 	printf("\t[-o transfer size in bytes (default: 4KiB. For compress/decompress, 0 means the input file size)]\n");
+	printf("\t\tFor copy, fill, compare, dualcast, xor and sequences, a comma separated list\n");
+	printf("\t\tof sizes may be given; each operation then picks one of them at random.\n");
 	printf("\t[-t time in seconds]\n");
 	printf("\t[-w workload type must be one of these: copy, fill, crc32c, copy_crc32c, compare, compress, decompress, dualcast, xor\n");
+	printf("\t\tor a comma separated list of copy, fill and crc32c (e.g. fill,copy,crc32c)\n");
+	printf("\t\tto run them as an accel sequence\n");
+	printf("\t[-M name of the accel module to assign the workload's operations to]\n");
 	printf("\t[-l for compress/decompress workloads, name of uncompressed input file\n");
 	printf("\t[-s for crc32c workload, use this seed value (default 0)\n");
 	printf("\t[-P for compare workload, percentage of operations that should miscompare (percent, default 0)\n");
@@ -169,6 +222,79 @@ usage(void)
 	printf("\t\tCan be used to spread operations across a wider range of memory.\n");
 }
 
+static int
+parse_xfer_sizes(const char *arg)
+{
+	char *str, *tok, *sp = NULL;
+	long size;
+	int rc = 0;
+
+	str = strdup(arg);
+	if (str == NULL) {
+		return -ENOMEM;
+	}
+
+	g_num_xfer_sizes = 0;
+	g_xfer_size_bytes = 0;
+	for (tok = strtok_r(str, ",", &sp); tok != NULL; tok = strtok_r(NULL, ",", &sp)) {
+		size = spdk_strtol(tok, 10);
+		if (size < 0 || size > UINT32_MAX) {
+			fprintf(stderr, "Invalid transfer size: %s\n", tok);
+			rc = -EINVAL;
+			break;
+		}
+		if (g_num_xfer_sizes == MAX_XFER_SIZES) {
+			fprintf(stderr, "At most %d transfer sizes can be specified\n",
+				MAX_XFER_SIZES);
+			rc = -EINVAL;
+			break;
+		}
+		g_xfer_sizes[g_num_xfer_sizes++] = size;
+		g_xfer_size_bytes = spdk_max(g_xfer_size_bytes, (int)size);
+	}
+
+	free(str);
+	return rc;
+}
+
+static int
+parse_sequence(const char *arg)
+{
+	char *str, *tok, *sp = NULL;
+	enum spdk_accel_opcode opcode;
+	int rc = 0;
+
+	str = strdup(arg);
+	if (str == NULL) {
+		return -ENOMEM;
+	}
+
+	g_seq_len = 0;
+	for (tok = strtok_r(str, ",", &sp); tok != NULL; tok = strtok_r(NULL, ",", &sp)) {
+		if (!strcmp(tok, "copy")) {
+			opcode = SPDK_ACCEL_OPC_COPY;
+		} else if (!strcmp(tok, "fill")) {
+			opcode = SPDK_ACCEL_OPC_FILL;
+		} else if (!strcmp(tok, "crc32c")) {
+			opcode = SPDK_ACCEL_OPC_CRC32C;
+		} else {
+			fprintf(stderr, "Unsupported sequence operation: %s\n", tok);
+			rc = -EINVAL;
+			break;
+		}
+		if (g_seq_len == MAX_SEQUENCE_LEN) {
+			fprintf(stderr, "At most %d operations can be chained\n", MAX_SEQUENCE_LEN);
+			rc = -EINVAL;
+			break;
+		}
+		g_seq_ops[g_seq_len++] = opcode;
+	}
+
+	free(str);
+	g_sequence = true;
+	return rc;
+}
+
 static int
 parse_args(int argc, char *argv)
 {
@@ -179,7 +305,6 @@ parse_args(int argc, char *argv)
 	case 'C':
 	case 'f':
 	case 'T':
-	case 'o':
 	case 'P':
 	case 'q':
 	case 's':
@@ -213,7 +338,13 @@ parse_args(int argc, char *argv)
 		g_threads_per_core = argval;
 		break;
 	case 'o':
-		g_xfer_size_bytes = argval;
+		if (parse_xfer_sizes(optarg)) {
+			usage();
+			return 1;
+		}
+		break;
+	case 'M':
+		g_module_name = optarg;
 		break;
 	case 'P':
 		g_fail_percent_goal = argval;
@@ -235,7 +366,14 @@ parse_args(int argc, char *argv)
 		break;
 	case 'w':
 		g_workload_type = optarg;
-		if (!strcmp(g_workload_type, "copy")) {
+		if (strchr(g_workload_type, ',') != NULL) {
+			if (parse_sequence(g_workload_type)) {
+				usage();
+				return 1;
+			}
+			/* The buffers of a sequence are laid out the same way as for copy */
+			g_workload_selection = SPDK_ACCEL_OPC_COPY;
+		} else if (!strcmp(g_workload_type, "copy")) {
 			g_workload_selection = SPDK_ACCEL_OPC_COPY;
 		} else if (!strcmp(g_workload_type, "fill")) {
 			g_workload_selection = SPDK_ACCEL_OPC_FILL;
@@ -272,8 +410,11 @@ unregister_worker(void *arg1)
 {
 	struct worker_thread *worker = arg1;
 
-	spdk_accel_get_opcode_stats(worker->ch, worker->workload,
-				    &worker->stats, sizeof(worker->stats));
+	/* Operations of a sequence are accounted for by accel_done() */
+	if (!g_sequence) {
+		spdk_accel_get_opcode_stats(worker->ch, worker->workload,
+					    &worker->stats, sizeof(worker->stats));
+	}
 	free(worker->task_base);
 	spdk_put_io_channel(worker->ch);
 	spdk_thread_exit(spdk_get_thread());
@@ -417,7 +558,7 @@ _get_task_data_bufs(struct ap_task *task)
 	}
 
 	/* For dualcast 2 buffers are needed for the operation.  */
-	if (g_workload_selection == SPDK_ACCEL_OPC_DUALCAST ||
+	if (g_workload_selection == SPDK_ACCEL_OPC_DUALCAST || g_sequence ||
 	    (g_workload_selection == SPDK_ACCEL_OPC_XOR && g_verify)) {
 		task->dst2 = spdk_dma_zmalloc(g_xfer_size_bytes, align, NULL);
 		if (task->dst2 == NULL) {
@@ -446,6 +587,78 @@ _get_task(struct worker_thread *worker)
 	return task;
 }
 
+static inline uint32_t
+_get_xfer_size(void)
+{
+	if (g_num_xfer_sizes > 1) {
+		return g_xfer_sizes[rand() % g_num_xfer_sizes];
+	}
+
+	return g_xfer_size_bytes;
+}
+
+/* Build the sequence of operations requested by the workload and execute it.  The source
+ * buffer is never modified: the first copy or fill moves the data into dst and subsequent
+ * copies alternate between dst and dst2, so the result always ends up in task->seq_buf.
+ */
+static int
+_submit_sequence(struct worker_thread *worker, struct ap_task *task)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct iovec *src_iov, *dst_iov;
+	void *cur = task->src, *next;
+	uint32_t i;
+	int rc = 0;
+
+	for (i = 0; i < g_seq_len; i++) {
+		src_iov = &task->seq_iovs[i * 2];
+		dst_iov = &task->seq_iovs[i * 2 + 1];
+
+		switch (g_seq_ops[i]) {
+		case SPDK_ACCEL_OPC_COPY:
+			next = cur == task->dst ? task->dst2 : task->dst;
+			src_iov->iov_base = cur;
+			src_iov->iov_len = task->xfer_size;
+			dst_iov->iov_base = next;
+			dst_iov->iov_len = task->xfer_size;
+			rc = spdk_accel_append_copy(&seq, worker->ch, dst_iov, 1, NULL, NULL,
+						    src_iov, 1, NULL, NULL, 0, NULL, NULL);
+			cur = next;
+			break;
+		case SPDK_ACCEL_OPC_FILL:
+			if (cur == task->src) {
+				cur = task->dst;
+			}
+			rc = spdk_accel_append_fill(&seq, worker->ch, cur, task->xfer_size,
+						    NULL, NULL, g_fill_pattern, 0, NULL, NULL);
+			break;
+		case SPDK_ACCEL_OPC_CRC32C:
+			src_iov->iov_base = cur;
+			src_iov->iov_len = task->xfer_size;
+			rc = spdk_accel_append_crc32c(&seq, worker->ch, &task->seq_crcs[i],
+						      src_iov, 1, NULL, NULL, g_crc32c_seed,
+						      NULL, NULL);
+			break;
+		default:
+			assert(false);
+			rc = -EINVAL;
+			break;
+		}
+
+		if (rc != 0) {
+			if (seq != NULL) {
+				spdk_accel_sequence_abort(seq);
+			}
+			return rc;
+		}
+	}
+
+	task->seq_buf = cur;
+	spdk_accel_sequence_finish(seq, accel_done, task);
+
+	return 0;
+}
+
 /* Submit one operation using the same ap task that just completed. */
 static void
 _submit_single(struct worker_thread *worker, struct ap_task *task)
@@ -456,15 +669,27 @@ _submit_single(struct worker_thread *worker, struct ap_task *task)
 
 	assert(worker);
 
+	task->xfer_size = _get_xfer_size();
+	task->submit_tsc = spdk_get_ticks();
+
+	if (g_sequence) {
+		worker->current_queue_depth++;
+		rc = _submit_sequence(worker, task);
+		if (rc) {
+			accel_done(task, rc);
+		}
+		return;
+	}
+
 	switch (worker->workload) {
 	case SPDK_ACCEL_OPC_COPY:
 		rc = spdk_accel_submit_copy(worker->ch, task->dst, task->src,
-					    g_xfer_size_bytes, flags, accel_done, task);
+					    task->xfer_size, flags, accel_done, task);
 		break;
 	case SPDK_ACCEL_OPC_FILL:
 		/* For fill use the first byte of the task->dst buffer */
 		rc = spdk_accel_submit_fill(worker->ch, task->dst, *(uint8_t *)task->src,
-					    g_xfer_size_bytes, flags, accel_done, task);
+					    task->xfer_size, flags, accel_done, task);
 		break;
 	case SPDK_ACCEL_OPC_CRC32C:
 		rc = spdk_accel_submit_crc32cv(worker->ch, &task->crc_dst,
@@ -485,11 +710,11 @@ _submit_single(struct worker_thread *worker, struct ap_task *task)
 			*(uint8_t *)task->dst = DATA_PATTERN;
 		}
 		rc = spdk_accel_submit_compare(worker->ch, task->dst, task->src,
-					       g_xfer_size_bytes, accel_done, task);
+					       task->xfer_size, accel_done, task);
 		break;
 	case SPDK_ACCEL_OPC_DUALCAST:
 		rc = spdk_accel_submit_dualcast(worker->ch, task->dst, task->dst2,
-						task->src, g_xfer_size_bytes, flags, accel_done, task);
+						task->src, task->xfer_size, flags, accel_done, task);
 		break;
 	case SPDK_ACCEL_OPC_COMPRESS:
 		task->src_iovs = task->cur_seg->uncompressed_iovs;
@@ -506,7 +731,7 @@ _submit_single(struct worker_thread *worker, struct ap_task *task)
 		break;
 	case SPDK_ACCEL_OPC_XOR:
 		rc = spdk_accel_submit_xor(worker->ch, task->dst, task->sources, g_xor_src_count,
-					   g_xfer_size_bytes, accel_done, task);
+					   task->xfer_size, accel_done, task);
 		break;
 	default:
 		assert(false);
@@ -550,7 +775,8 @@ _free_task_buffers(struct ap_task *task)
 	}
 
 	spdk_dma_free(task->dst);
-	if (g_workload_selection == SPDK_ACCEL_OPC_DUALCAST || g_workload_selection == SPDK_ACCEL_OPC_XOR) {
+	if (g_workload_selection == SPDK_ACCEL_OPC_DUALCAST || g_sequence ||
+	    g_workload_selection == SPDK_ACCEL_OPC_XOR) {
 		spdk_dma_free(task->dst2);
 	}
 }
@@ -577,6 +803,67 @@ _vector_memcmp(void *_dst, struct iovec *src_src_iovs, uint32_t iovcnt)
 	return 0;
 }
 
+static bool
+_buf_is_filled(const uint8_t *buf, uint8_t pattern, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != pattern) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static uint32_t
+_filled_buf_crc32c(uint8_t pattern, uint32_t len)
+{
+	uint8_t buf[512];
+	uint32_t crc = ~g_crc32c_seed, n;
+
+	memset(buf, pattern, sizeof(buf));
+	while (len > 0) {
+		n = spdk_min(len, sizeof(buf));
+		crc = spdk_crc32c_update(buf, n, crc);
+		len -= n;
+	}
+
+	return crc;
+}
+
+/* The data flowing through a sequence is always uniform: the source pattern until the first
+ * fill and the fill pattern afterwards, which makes the expected results easy to compute.
+ */
+static void
+_verify_sequence(struct worker_thread *worker, struct ap_task *task)
+{
+	uint8_t pattern = DATA_PATTERN;
+	uint32_t i;
+
+	for (i = 0; i < g_seq_len; i++) {
+		switch (g_seq_ops[i]) {
+		case SPDK_ACCEL_OPC_FILL:
+			pattern = g_fill_pattern;
+			break;
+		case SPDK_ACCEL_OPC_CRC32C:
+			if (task->seq_crcs[i] != _filled_buf_crc32c(pattern, task->xfer_size)) {
+				SPDK_NOTICELOG("CRC-32C miscompare\n");
+				worker->xfer_failed++;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (!_buf_is_filled(task->seq_buf, pattern, task->xfer_size)) {
+		SPDK_NOTICELOG("Data miscompare\n");
+		worker->xfer_failed++;
+	}
+}
+
 static int _worker_stop(void *arg);
 
 static void
@@ -589,7 +876,17 @@ accel_done(void *arg1, int status)
 	assert(worker);
 	assert(worker->current_queue_depth > 0);
 
-	if (g_verify && status == 0) {
+	spdk_histogram_data_tally(worker->histogram, spdk_get_ticks() - task->submit_tsc);
+
+	if (g_sequence) {
+		if (status == 0) {
+			worker->stats.executed++;
+			worker->stats.num_bytes += task->xfer_size;
+			if (g_verify) {
+				_verify_sequence(worker, task);
+			}
+		}
+	} else if (g_verify && status == 0) {
 		switch (worker->workload) {
 		case SPDK_ACCEL_OPC_COPY_CRC32C:
 			sw_crc32c = spdk_crc32c_iov_update(task->src_iovs, task->src_iovcnt, ~g_crc32c_seed);
@@ -610,23 +907,23 @@ accel_done(void *arg1, int status)
 			}
 			break;
 		case SPDK_ACCEL_OPC_COPY:
-			if (memcmp(task->src, task->dst, g_xfer_size_bytes)) {
+			if (memcmp(task->src, task->dst, task->xfer_size)) {
 				SPDK_NOTICELOG("Data miscompare\n");
 				worker->xfer_failed++;
 			}
 			break;
 		case SPDK_ACCEL_OPC_DUALCAST:
-			if (memcmp(task->src, task->dst, g_xfer_size_bytes)) {
+			if (memcmp(task->src, task->dst, task->xfer_size)) {
 				SPDK_NOTICELOG("Data miscompare, first destination\n");
 				worker->xfer_failed++;
 			}
-			if (memcmp(task->src, task->dst2, g_xfer_size_bytes)) {
+			if (memcmp(task->src, task->dst2, task->xfer_size)) {
 				SPDK_NOTICELOG("Data miscompare, second destination\n");
 				worker->xfer_failed++;
 			}
 			break;
 		case SPDK_ACCEL_OPC_FILL:
-			if (memcmp(task->dst, task->src, g_xfer_size_bytes)) {
+			if (memcmp(task->dst, task->src, task->xfer_size)) {
 				SPDK_NOTICELOG("Data miscompare\n");
 				worker->xfer_failed++;
 			}
@@ -643,9 +940,9 @@ accel_done(void *arg1, int status)
 			break;
 		case SPDK_ACCEL_OPC_XOR:
 			if (spdk_xor_gen(task->dst2, task->sources, g_xor_src_count,
-					 g_xfer_size_bytes) != 0) {
+					 task->xfer_size) != 0) {
 				SPDK_ERRLOG("Failed to generate xor for verification\n");
-			} else if (memcmp(task->dst, task->dst2, g_xfer_size_bytes)) {
+			} else if (memcmp(task->dst, task->dst2, task->xfer_size)) {
 				SPDK_NOTICELOG("Data miscompare\n");
 				worker->xfer_failed++;
 			}
@@ -685,10 +982,71 @@ accel_done(void *arg1, int status)
 	}
 }
 
+struct latency_percentile {
+	double		percentile;
+	uint64_t	value;
+};
+
+static void
+get_percentile_latency(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		       uint64_t total, uint64_t so_far)
+{
+	struct latency_percentile *latency_percentile = ctx;
+
+	if (count == 0 || latency_percentile->value != 0) {
+		return;
+	}
+
+	if ((double)so_far / total >= latency_percentile->percentile) {
+		latency_percentile->value = end;
+	}
+}
+
+static double
+get_histogram_percentile_us(struct spdk_histogram_data *histogram, double percentile)
+{
+	struct latency_percentile latency_percentile = { .percentile = percentile };
+
+	spdk_histogram_data_iterate(histogram, get_percentile_latency, &latency_percentile);
+
+	return (double)latency_percentile.value * SPDK_SEC_TO_USEC / g_tsc_rate;
+}
+
+static void
+dump_latency(void)
+{
+	struct spdk_histogram_data *histogram;
+	struct worker_thread *worker;
+	static const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	uint32_t i;
+
+	histogram = spdk_histogram_data_alloc();
+	if (histogram == NULL) {
+		fprintf(stderr, "Unable to allocate latency histogram\n");
+		return;
+	}
+
+	for (worker = g_workers; worker != NULL; worker = worker->next) {
+		if (worker->histogram != NULL) {
+			spdk_histogram_data_merge(histogram, worker->histogram);
+		}
+	}
+
+	printf("Latency:");
+	for (i = 0; i < SPDK_COUNTOF(percentiles); i++) {
+		printf("%s p%g %.2f us", i == 0 ? "" : ",", percentiles[i] * 100,
+		       get_histogram_percentile_us(histogram, percentiles[i]));
+	}
+	printf("\n\n");
+
+	spdk_histogram_data_free(histogram);
+}
+
 static int
 dump_result(void)
 {
 	uint64_t total_completed = 0;
+	uint64_t total_bytes = 0;
 	uint64_t total_failed = 0;
 	uint64_t total_miscompared = 0;
 	uint64_t total_xfer_per_sec, total_bw_in_MiBps;
@@ -703,6 +1061,7 @@ dump_result(void)
 				       (g_time_in_sec * 1024 * 1024);
 
 		total_completed += worker->stats.executed;
+		total_bytes += worker->stats.num_bytes;
 		total_failed += worker->xfer_failed;
 		total_miscompared += worker->injected_miscompares;
 
@@ -716,13 +1075,14 @@ dump_result(void)
 	}
 
 	total_xfer_per_sec = total_completed / g_time_in_sec;
-	total_bw_in_MiBps = (total_completed * g_xfer_size_bytes) /
-			    (g_time_in_sec * 1024 * 1024);
+	total_bw_in_MiBps = total_bytes / (g_time_in_sec * 1024 * 1024);
 
 	printf("=========================================================================\n");
 	printf("Total:%15" PRIu64 "/s%9" PRIu64 " MiB/s%6" PRIu64 " %11" PRIu64"\n\n",
 	       total_xfer_per_sec, total_bw_in_MiBps, total_failed, total_miscompared);
 
+	dump_latency();
+
 	return total_failed ? 1 : 0;
 }
 
@@ -804,6 +1164,12 @@ _init_thread(void *arg1)
 
 	TAILQ_INIT(&worker->tasks_pool);
 
+	worker->histogram = spdk_histogram_data_alloc();
+	if (worker->histogram == NULL) {
+		fprintf(stderr, "Unable to allocate latency histogram\n");
+		goto error;
+	}
+
 	worker->task_base = calloc(num_tasks, sizeof(struct ap_task));
 	if (worker->task_base == NULL) {
 		fprintf(stderr, "Could not allocate task base.\n");
@@ -1143,13 +1509,14 @@ int
 main(int argc, char **argv)
 {
 	struct worker_thread *worker, *tmp;
+	uint32_t i;
 
 	pthread_mutex_init(&g_workers_lock, NULL);
 	spdk_app_opts_init(&g_opts, sizeof(g_opts));
 	g_opts.name = "accel_perf";
 	g_opts.reactor_mask = "0x1";
 	g_opts.shutdown_cb = shutdown_cb;
-	if (spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:P:f:T:l:x:", NULL, parse_args,
+	if (spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:M:P:f:T:l:x:", NULL, parse_args,
 				usage) != SPDK_APP_PARSE_ARGS_SUCCESS) {
 		g_rc = -1;
 		goto cleanup;
@@ -1194,6 +1561,39 @@ main(int argc, char **argv)
 		goto cleanup;
 	}
 
+	if (g_num_xfer_sizes > 1 && !g_sequence &&
+	    (g_workload_selection == SPDK_ACCEL_OPC_CRC32C ||
+	     g_workload_selection == SPDK_ACCEL_OPC_COPY_CRC32C ||
+	     g_workload_selection == SPDK_ACCEL_OPC_COMPRESS ||
+	     g_workload_selection == SPDK_ACCEL_OPC_DECOMPRESS)) {
+		fprintf(stdout, "multiple transfer sizes are not supported by the %s workload\n",
+			g_workload_type);
+		usage();
+		g_rc = -1;
+		goto cleanup;
+	}
+
+	if (g_sequence && g_seq_len == 0) {
+		usage();
+		g_rc = -1;
+		goto cleanup;
+	}
+
+	if (g_module_name != NULL) {
+		/* Assignments have to be made before the accel framework is initialized */
+		if (g_sequence) {
+			for (i = 0; i < g_seq_len && g_rc == 0; i++) {
+				g_rc = spdk_accel_assign_opc(g_seq_ops[i], g_module_name);
+			}
+		} else {
+			g_rc = spdk_accel_assign_opc(g_workload_selection, g_module_name);
+		}
+		if (g_rc) {
+			fprintf(stderr, "Unable to assign operations to module %s\n", g_module_name);
+			goto cleanup;
+		}
+	}
+
 	g_rc = spdk_app_start(&g_opts, accel_perf_prep, NULL);
 	if (g_rc) {
 		SPDK_ERRLOG("ERROR starting application\n");
@@ -1204,6 +1604,7 @@ main(int argc, char **argv)
 	worker = g_workers;
 	while (worker) {
 		tmp = worker->next;
+		spdk_histogram_data_free(worker->histogram);
 		free(worker);
 		worker = tmp;
 	}
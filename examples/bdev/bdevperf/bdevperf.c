@@ -19,11 +19,16 @@
 #include "spdk/bit_array.h"
 #include "spdk/conf.h"
 #include "spdk/zipf.h"
+#include "spdk/workload.h"
 #include "spdk/histogram_data.h"
 
 #define BDEVPERF_CONFIG_MAX_FILENAME 1024
 #define BDEVPERF_CONFIG_UNDEFINED -1
 #define BDEVPERF_CONFIG_ERROR -2
+/* Length of each step of the latency target search */
+#define BDEVPERF_SLO_STEP_USEC SPDK_SEC_TO_USEC
+/* The latency target search ends when the rate is known to within this fraction */
+#define BDEVPERF_SLO_SEARCH_PRECISION 0.02
 
 struct bdevperf_task {
 	struct iovec			iov;
@@ -34,6 +39,8 @@ struct bdevperf_task {
 	uint64_t			offset_blocks;
 	struct bdevperf_task		*task_to_abort;
 	enum spdk_bdev_io_type		io_type;
+	/* time at which the I/O arrived in open-loop mode */
+	uint64_t			arrival_tsc;
 	TAILQ_ENTRY(bdevperf_task)	link;
 	struct spdk_bdev_io_wait_entry	bdev_io_wait;
 };
@@ -69,7 +76,17 @@ static int g_timeout_in_sec;
 static struct spdk_conf *g_bdevperf_conf = NULL;
 static const char *g_bdevperf_conf_file = NULL;
 static double g_zipf_theta;
+static const char *g_workload_spec;
 static bool g_random_map = false;
+static uint64_t g_arrival_rate = 0;
+static uint64_t g_slo_p99_usec = 0;
+
+enum bdevperf_arrival {
+	BDEVPERF_ARRIVAL_POISSON = 0,
+	BDEVPERF_ARRIVAL_FIXED,
+};
+
+static enum bdevperf_arrival g_arrival = BDEVPERF_ARRIVAL_POISSON;
 
 static struct spdk_cpuset g_all_cpuset;
 static struct spdk_poller *g_perf_timer = NULL;
@@ -110,6 +127,11 @@ struct latency_info {
 	uint64_t	total;
 };
 
+struct latency_percentile {
+	double		percentile;
+	uint64_t	value;
+};
+
 struct bdevperf_job {
 	char				*name;
 	struct spdk_bdev		*bdev;
@@ -149,12 +171,25 @@ struct bdevperf_job {
 	struct spdk_poller		*reset_timer;
 	struct spdk_bit_array		*outstanding;
 	struct spdk_zipf		*zipf;
+	struct spdk_workload		*workload;
 	TAILQ_HEAD(, bdevperf_task)	task_list;
 	uint64_t			run_time_in_usec;
 
 	/* keep channel's histogram data before being destroyed */
 	struct spdk_histogram_data	*histogram;
 	struct spdk_bit_array		*random_map;
+
+	/* Open-loop mode: I/O arrives at arrival_rate per second instead of being
+	 * resubmitted on completion, queue_depth is the maximum number of I/O in flight. */
+	uint64_t			arrival_rate;
+	uint64_t			next_arrival_tsc;
+	int				open_loop_inflight;
+	uint64_t			queue_tsc;
+	struct spdk_poller		*arrival_poller;
+	/* latency from the arrival of the I/O, including the time it waited to be submitted */
+	struct spdk_histogram_data	*open_loop_histogram;
+	/* same as above, for the current step of the latency target search */
+	struct spdk_histogram_data	*step_histogram;
 };
 
 struct spdk_bdevperf {
@@ -217,6 +252,21 @@ struct bdevperf_aggregate_stats {
 
 static struct bdevperf_aggregate_stats g_stats = {.min_latency = (double)UINT64_MAX};
 
+/* Binary search of the highest arrival rate per job meeting the p99 latency target */
+struct bdevperf_slo_search {
+	uint64_t			low;
+	uint64_t			high;
+	uint64_t			rate;
+	uint64_t			p99_tsc;
+	uint32_t			steps;
+	bool				msg_active;
+	bool				done;
+	struct spdk_poller		*poller;
+	struct spdk_histogram_data	*histogram;
+};
+
+static struct bdevperf_slo_search g_slo_search;
+
 struct lcore_thread {
 	struct spdk_thread		*thread;
 	uint32_t			lcore;
@@ -275,6 +325,31 @@ get_avg_latency(void *ctx, uint64_t start, uint64_t end, uint64_t count,
 	}
 }
 
+static void
+get_percentile_latency(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		       uint64_t total, uint64_t so_far)
+{
+	struct latency_percentile *latency_percentile = ctx;
+
+	if (count == 0 || latency_percentile->value != 0) {
+		return;
+	}
+
+	if ((double)so_far / total >= latency_percentile->percentile) {
+		latency_percentile->value = end;
+	}
+}
+
+static uint64_t
+get_histogram_percentile(struct spdk_histogram_data *histogram, double percentile)
+{
+	struct latency_percentile latency_percentile = { .percentile = percentile };
+
+	spdk_histogram_data_iterate(histogram, get_percentile_latency, &latency_percentile);
+
+	return latency_percentile.value;
+}
+
 static void
 performance_dump_job(struct bdevperf_aggregate_stats *stats, struct bdevperf_job *job)
 {
@@ -464,9 +539,12 @@ static void
 bdevperf_job_free(struct bdevperf_job *job)
 {
 	spdk_histogram_data_free(job->histogram);
+	spdk_histogram_data_free(job->open_loop_histogram);
+	spdk_histogram_data_free(job->step_histogram);
 	spdk_bit_array_free(&job->outstanding);
 	spdk_bit_array_free(&job->random_map);
 	spdk_zipf_free(&job->zipf);
+	spdk_workload_free(&job->workload);
 	free(job->name);
 	free(job);
 }
@@ -516,6 +594,61 @@ print_bucket(void *ctx, uint64_t start, uint64_t end, uint64_t count,
 	       so_far_pct, count);
 }
 
+static const double g_open_loop_percentiles[] = {
+	0.50,
+	0.99,
+	0.999,
+	0.9999,
+	1.0,
+};
+
+static void
+bdevperf_open_loop_dump(void)
+{
+	struct bdevperf_job *job;
+	uint64_t tsc_rate, total_io;
+	uint32_t num_jobs = 0, i;
+	double queue_latency, latency;
+
+	tsc_rate = spdk_get_ticks_hz();
+
+	printf("\n%*s\n", 107, "Open-loop latency including queue time(us)");
+	printf("\r %-*s: %10s %10s %10s %10s %10s %10s %10s\n",
+	       28, "Device Information", "Target", "Queue", "p50", "p99", "p99.9", "p99.99", "max");
+
+	TAILQ_FOREACH(job, &g_bdevperf.jobs, link) {
+		total_io = job->io_completed + job->io_failed;
+		queue_latency = 0.0;
+		if (total_io != 0) {
+			queue_latency = (double)job->queue_tsc / total_io * SPDK_SEC_TO_USEC / tsc_rate;
+		}
+
+		printf("\r %-28s: %10" PRIu64 " %10.2f", job->name, job->arrival_rate, queue_latency);
+		for (i = 0; i < SPDK_COUNTOF(g_open_loop_percentiles); i++) {
+			latency = (double)get_histogram_percentile(job->open_loop_histogram,
+					g_open_loop_percentiles[i]) * SPDK_SEC_TO_USEC / tsc_rate;
+			printf(" %10.2f", latency);
+		}
+		printf("\n");
+
+		num_jobs++;
+	}
+
+	if (g_slo_p99_usec == 0) {
+		return;
+	}
+
+	printf("\n p99 latency target of %" PRIu64 "us after %" PRIu32 " steps: ",
+	       g_slo_p99_usec, g_slo_search.steps);
+	if (g_slo_search.low == 0) {
+		printf("not met at any tested rate\n");
+	} else {
+		printf("met at %" PRIu64 " IO/s per job, %" PRIu64 " IO/s in total%s\n",
+		       g_slo_search.low, g_slo_search.low * num_jobs,
+		       g_slo_search.done ? "" : " (search did not converge, increase -t)");
+	}
+}
+
 static void
 bdevperf_test_done(void *ctx)
 {
@@ -535,6 +668,13 @@ bdevperf_test_done(void *ctx)
 		}
 	}
 
+	spdk_poller_unregister(&g_slo_search.poller);
+	if (g_slo_search.msg_active) {
+		/* Wait for the jobs to finish reporting the current step */
+		spdk_thread_send_msg(spdk_get_thread(), bdevperf_test_done, NULL);
+		return;
+	}
+
 	if (g_show_performance_real_time) {
 		spdk_poller_unregister(&g_perf_timer);
 	}
@@ -568,6 +708,10 @@ bdevperf_test_done(void *ctx)
 	}
 	printf(" %10.2f %10.2f %10.2f\n", average_latency, g_stats.min_latency, g_stats.max_latency);
 
+	if (g_arrival_rate != 0) {
+		bdevperf_open_loop_dump();
+	}
+
 	fflush(stdout);
 
 	if (g_latency_display_level == 0 || g_stats.total_io_completed == 0) {
@@ -679,7 +823,8 @@ bdevperf_end_task(struct bdevperf_task *task)
 	struct bdevperf_job     *job = task->job;
 
 	TAILQ_INSERT_TAIL(&job->task_list, task, link);
-	if (job->is_draining) {
+	/* In open-loop mode the arrival poller empties the job once it sees it draining */
+	if (job->is_draining && job->arrival_poller == NULL) {
 		if (job->current_queue_depth == 0) {
 			bdevperf_job_empty(job);
 		}
@@ -718,7 +863,7 @@ bdevperf_job_drain_timer(void *ctx)
 	struct bdevperf_job *job = ctx;
 
 	bdevperf_job_drain(ctx);
-	if (job->current_queue_depth == 0) {
+	if (job->current_queue_depth == 0 && job->arrival_poller == NULL) {
 		bdevperf_job_empty(job);
 	}
 
@@ -800,6 +945,7 @@ bdevperf_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 	int			iovcnt;
 	bool			md_check;
 	uint64_t		offset_in_ios;
+	uint64_t		latency_tsc;
 	int			rc;
 
 	job = task->job;
@@ -867,6 +1013,18 @@ bdevperf_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 
 	spdk_bdev_free_io(bdev_io);
 
+	if (job->arrival_rate != 0) {
+		/* In open-loop mode the next I/O is submitted by the arrival poller */
+		latency_tsc = spdk_get_ticks() - task->arrival_tsc;
+		spdk_histogram_data_tally(job->open_loop_histogram, latency_tsc);
+		if (job->step_histogram != NULL) {
+			spdk_histogram_data_tally(job->step_histogram, latency_tsc);
+		}
+		job->open_loop_inflight--;
+		bdevperf_end_task(task);
+		return;
+	}
+
 	/*
 	 * is_draining indicates when time has expired for the test run
 	 * and we are just waiting for the previously submitted I/O
@@ -1128,11 +1286,15 @@ bdevperf_job_get_task(struct bdevperf_job *job)
 static void
 bdevperf_submit_single(struct bdevperf_job *job, struct bdevperf_task *task)
 {
+	struct spdk_workload_io io;
 	uint64_t offset_in_ios;
 	uint64_t rand_value;
 	uint32_t first_clear;
 
-	if (job->zipf) {
+	if (job->workload) {
+		spdk_workload_next(job->workload, &io);
+		offset_in_ios = io.offset;
+	} else if (job->zipf) {
 		offset_in_ios = spdk_zipf_generate(job->zipf);
 	} else if (job->is_random) {
 		/* RAND_MAX is only INT32_MAX, so use 2 calls to rand_r to
@@ -1214,8 +1376,9 @@ bdevperf_submit_single(struct bdevperf_job *job, struct bdevperf_task *task)
 		task->io_type = SPDK_BDEV_IO_TYPE_UNMAP;
 	} else if (job->write_zeroes) {
 		task->io_type = SPDK_BDEV_IO_TYPE_WRITE_ZEROES;
-	} else if ((job->rw_percentage == 100) ||
-		   (job->rw_percentage != 0 && ((rand_r(&job->seed) % 100) < job->rw_percentage))) {
+	} else if (job->workload != NULL ? io.is_read :
+		   (job->rw_percentage == 100 ||
+		    (job->rw_percentage != 0 && (rand_r(&job->seed) % 100) < job->rw_percentage))) {
 		task->io_type = SPDK_BDEV_IO_TYPE_READ;
 	} else {
 		if (g_zcopy) {
@@ -1298,6 +1461,54 @@ bdevperf_timeout_cb(void *cb_arg, struct spdk_bdev_io *bdev_io)
 	bdevperf_submit_task(task);
 }
 
+static uint64_t
+bdevperf_job_get_interarrival_tsc(struct bdevperf_job *job)
+{
+	double mean_tsc, u;
+
+	mean_tsc = (double)spdk_get_ticks_hz() / job->arrival_rate;
+	if (g_arrival == BDEVPERF_ARRIVAL_FIXED) {
+		return (uint64_t)(mean_tsc + 0.5);
+	}
+
+	/* Exponentially distributed inter-arrival times give a Poisson arrival process */
+	u = (double)rand_r(&job->seed) / ((double)RAND_MAX + 1.0);
+
+	return (uint64_t)(-log(1.0 - u) * mean_tsc + 0.5);
+}
+
+static int
+bdevperf_job_arrival_poll(void *ctx)
+{
+	struct bdevperf_job *job = ctx;
+	struct bdevperf_task *task;
+	uint64_t now;
+	int count = 0;
+
+	if (job->is_draining) {
+		spdk_poller_unregister(&job->arrival_poller);
+		if (job->current_queue_depth == 0) {
+			bdevperf_job_empty(job);
+		}
+		return SPDK_POLLER_BUSY;
+	}
+
+	/* I/O that arrived while queue_depth I/O were in flight keeps its arrival time, so the time
+	 * it waited to be submitted is included in its latency. */
+	now = spdk_get_ticks();
+	while (job->next_arrival_tsc <= now && job->open_loop_inflight < job->queue_depth) {
+		task = bdevperf_job_get_task(job);
+		task->arrival_tsc = job->next_arrival_tsc;
+		job->next_arrival_tsc += bdevperf_job_get_interarrival_tsc(job);
+		job->queue_tsc += now - task->arrival_tsc;
+		job->open_loop_inflight++;
+		bdevperf_submit_single(job, task);
+		count++;
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static void
 bdevperf_job_run(void *ctx)
 {
@@ -1317,6 +1528,12 @@ bdevperf_job_run(void *ctx)
 
 	spdk_bdev_set_timeout(job->bdev_desc, g_timeout_in_sec, bdevperf_timeout_cb, job);
 
+	if (job->arrival_rate != 0) {
+		job->next_arrival_tsc = spdk_get_ticks();
+		job->arrival_poller = SPDK_POLLER_REGISTER(bdevperf_job_arrival_poll, job, 0);
+		return;
+	}
+
 	for (i = 0; i < job->queue_depth; i++) {
 		task = bdevperf_job_get_task(job);
 		bdevperf_submit_single(job, task);
@@ -1402,6 +1619,131 @@ performance_statistics_thread(void *arg)
 	return -1;
 }
 
+static void
+bdevperf_slo_search_msg_done(void *ctx)
+{
+	g_slo_search.msg_active = false;
+}
+
+static void
+_bdevperf_job_set_rate(void *ctx)
+{
+	struct bdevperf_job *job = ctx;
+
+	if (!job->is_draining) {
+		/* Start the step at the new rate without the backlog of the previous one */
+		job->arrival_rate = g_slo_search.rate;
+		job->next_arrival_tsc = spdk_get_ticks();
+		spdk_histogram_data_reset(job->step_histogram);
+	}
+
+	job = TAILQ_NEXT(job, link);
+	if (job == NULL) {
+		spdk_thread_send_msg(g_main_thread, bdevperf_slo_search_msg_done, NULL);
+	} else {
+		spdk_thread_send_msg(job->thread, _bdevperf_job_set_rate, job);
+	}
+}
+
+static void _bdevperf_job_drain(void *ctx);
+
+static void
+bdevperf_slo_search_update(void *ctx)
+{
+	struct bdevperf_job *job;
+	uint64_t p99_usec;
+
+	if (g_slo_search.done) {
+		g_slo_search.msg_active = false;
+		return;
+	}
+
+	g_slo_search.steps++;
+	g_slo_search.p99_tsc = get_histogram_percentile(g_slo_search.histogram, 0.99);
+	p99_usec = g_slo_search.p99_tsc * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+
+	if (g_slo_search.p99_tsc != 0 && p99_usec <= g_slo_p99_usec) {
+		g_slo_search.low = g_slo_search.rate;
+	} else {
+		g_slo_search.high = g_slo_search.rate;
+	}
+
+	printf("Step %" PRIu32 ": %" PRIu64 " IO/s per job, p99 latency %" PRIu64 "us\n",
+	       g_slo_search.steps, g_slo_search.rate, p99_usec);
+
+	if (g_slo_search.high - g_slo_search.low <=
+	    (uint64_t)(g_slo_search.high * BDEVPERF_SLO_SEARCH_PRECISION)) {
+		/* The rate is known precisely enough, stop the test */
+		g_slo_search.done = true;
+		g_slo_search.msg_active = false;
+		spdk_poller_unregister(&g_slo_search.poller);
+		TAILQ_FOREACH(job, &g_bdevperf.jobs, link) {
+			spdk_thread_send_msg(job->thread, _bdevperf_job_drain, job);
+		}
+		return;
+	}
+
+	g_slo_search.rate = (g_slo_search.low + g_slo_search.high) / 2;
+	job = TAILQ_FIRST(&g_bdevperf.jobs);
+	spdk_thread_send_msg(job->thread, _bdevperf_job_set_rate, job);
+}
+
+static void
+_bdevperf_slo_search_collect(void *ctx)
+{
+	struct bdevperf_job *job = ctx;
+
+	spdk_histogram_data_merge(g_slo_search.histogram, job->step_histogram);
+
+	/* This assumes the jobs list is static after start up time, as in _performance_dump(). */
+	job = TAILQ_NEXT(job, link);
+	if (job == NULL) {
+		spdk_thread_send_msg(g_main_thread, bdevperf_slo_search_update, NULL);
+	} else {
+		spdk_thread_send_msg(job->thread, _bdevperf_slo_search_collect, job);
+	}
+}
+
+static int
+bdevperf_slo_search_step(void *ctx)
+{
+	struct bdevperf_job *job;
+
+	if (g_slo_search.msg_active) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	job = TAILQ_FIRST(&g_bdevperf.jobs);
+	if (job == NULL) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	g_slo_search.msg_active = true;
+	spdk_histogram_data_reset(g_slo_search.histogram);
+	spdk_thread_send_msg(job->thread, _bdevperf_slo_search_collect, job);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bdevperf_slo_search_start(void)
+{
+	struct spdk_histogram_data *histogram = g_slo_search.histogram;
+
+	/* The histogram is kept across the tests started with perform_tests RPC */
+	memset(&g_slo_search, 0, sizeof(g_slo_search));
+	g_slo_search.histogram = histogram;
+
+	/* The search starts at the rate given with -I, which is also its upper bound */
+	g_slo_search.high = g_arrival_rate;
+	g_slo_search.rate = g_arrival_rate;
+	g_slo_search.poller = SPDK_POLLER_REGISTER(bdevperf_slo_search_step, NULL,
+			      BDEVPERF_SLO_STEP_USEC);
+
+	printf("Searching for the highest rate with p99 latency of at most %" PRIu64 "us\n",
+	       g_slo_p99_usec);
+}
+
 static void
 bdevperf_test(void)
 {
@@ -1421,6 +1763,10 @@ bdevperf_test(void)
 						    g_show_performance_period_in_usec);
 	}
 
+	if (g_slo_p99_usec != 0) {
+		bdevperf_slo_search_start();
+	}
+
 	/* Iterate jobs to start all I/O */
 	TAILQ_FOREACH(job, &g_bdevperf.jobs, link) {
 		g_bdevperf.running_jobs++;
@@ -1719,6 +2065,24 @@ bdevperf_construct_job(struct spdk_bdev *bdev, struct job_config *config,
 		job->zipf = spdk_zipf_create(job->size_in_ios, g_zipf_theta, 0);
 	}
 
+	/* The workload replaces the offsets and directions of I/O, so it's not used with verify */
+	if (g_workload_spec != NULL && !job->verify) {
+		struct spdk_workload_opts workload_opts = {
+			.range = job->size_in_ios,
+			.unit_size = job->buf_size,
+			.read_percentage = spdk_max(job->rw_percentage, 0),
+			.seed = rand(),
+		};
+
+		job->workload = spdk_workload_create(g_workload_spec, &workload_opts);
+		if (job->workload == NULL) {
+			SPDK_ERRLOG("Could not create workload %s for bdev %s\n", g_workload_spec,
+				    spdk_bdev_get_name(bdev));
+			bdevperf_job_free(job);
+			return -EINVAL;
+		}
+	}
+
 	if (job->verify) {
 		if (job->size_in_ios >= UINT32_MAX) {
 			SPDK_ERRLOG("Due to constraints of verify operation, the job storage capacity is too large\n");
@@ -1748,6 +2112,25 @@ bdevperf_construct_job(struct spdk_bdev *bdev, struct job_config *config,
 		return -ENOMEM;
 	}
 
+	job->arrival_rate = g_arrival_rate;
+	if (job->arrival_rate != 0) {
+		job->open_loop_histogram = spdk_histogram_data_alloc();
+		if (job->open_loop_histogram == NULL) {
+			fprintf(stderr, "Failed to allocate histogram\n");
+			bdevperf_job_free(job);
+			return -ENOMEM;
+		}
+	}
+
+	if (g_slo_p99_usec != 0) {
+		job->step_histogram = spdk_histogram_data_alloc();
+		if (job->step_histogram == NULL) {
+			fprintf(stderr, "Failed to allocate histogram\n");
+			bdevperf_job_free(job);
+			return -ENOMEM;
+		}
+	}
+
 	TAILQ_INIT(&job->task_list);
 
 	if (g_random_map) {
@@ -2471,6 +2854,21 @@ bdevperf_parse_arg(int ch, char *arg)
 			fprintf(stderr, "Illegal zipf theta value %s\n", optarg);
 			return -EINVAL;
 		}
+	} else if (ch == 'G') {
+		struct spdk_workload_opts workload_opts = {
+			.range = 1,
+			.unit_size = 512,
+		};
+		struct spdk_workload *workload;
+
+		/* Validate the specification, the generators are created per job */
+		workload = spdk_workload_create(optarg, &workload_opts);
+		if (workload == NULL) {
+			fprintf(stderr, "Illegal workload %s\n", optarg);
+			return -EINVAL;
+		}
+		spdk_workload_free(&workload);
+		g_workload_spec = optarg;
 	} else if (ch == 'l') {
 		g_latency_display_level++;
 	} else if (ch == 'D') {
@@ -2479,6 +2877,15 @@ bdevperf_parse_arg(int ch, char *arg)
 		g_one_thread_per_lcore = true;
 	} else if (ch == 'J') {
 		g_rpc_log_file_name = optarg;
+	} else if (ch == 'a') {
+		if (!strcmp(optarg, "poisson")) {
+			g_arrival = BDEVPERF_ARRIVAL_POISSON;
+		} else if (!strcmp(optarg, "fixed")) {
+			g_arrival = BDEVPERF_ARRIVAL_FIXED;
+		} else {
+			fprintf(stderr, "Illegal arrival distribution %s\n", optarg);
+			return -EINVAL;
+		}
 	} else {
 		tmp = spdk_strtoll(optarg, 10);
 		if (tmp < 0) {
@@ -2513,6 +2920,12 @@ bdevperf_parse_arg(int ch, char *arg)
 			g_show_performance_real_time = 1;
 			g_show_performance_period_in_usec = tmp * SPDK_SEC_TO_USEC;
 			break;
+		case 'I':
+			g_arrival_rate = tmp;
+			break;
+		case 'Y':
+			g_slo_p99_usec = tmp;
+			break;
 		default:
 			return -EINVAL;
 		}
@@ -2537,6 +2950,8 @@ bdevperf_usage(void)
 	printf(" -T <bdev>                 bdev to run against. Default: all available bdevs.\n");
 	printf(" -f                        continue processing I/O even after failures\n");
 	printf(" -F <zipf theta>           use zipf distribution for random I/O\n");
+	printf(" -G <workload>             generate the offsets and directions of I/O from a workload\n");
+	printf("\t\t(e.g. zipf:1.2,rw=0-10:100 or replay:<trace file>, not used with verify)\n");
 	printf(" -Z                        enable using zcopy bdev API for read or write I/O\n");
 	printf(" -z                        start bdevperf, but wait for RPC to start tests\n");
 	printf(" -X                        abort timed out I/O\n");
@@ -2546,12 +2961,18 @@ bdevperf_usage(void)
 	printf(" -D                        use a random map for picking offsets not previously read or written (for all jobs)\n");
 	printf(" -E                        share per lcore thread among jobs. Available only if -j is not used.\n");
 	printf(" -J                        File name to open with append mode and log JSON RPC calls.\n");
+	printf(" -I <rate>                 open-loop mode, submit I/O at <rate> IO/s per job instead of keeping -q I/O in flight\n");
+	printf("\t\t(-q is the maximum number of I/O in flight, latency includes the time I/O waited to be submitted)\n");
+	printf(" -a <distribution>         inter-arrival times of the open-loop mode, must be one of (poisson, fixed), default: poisson\n");
+	printf(" -Y <latency>              search for the highest open-loop rate with p99 latency of at most <latency> us\n");
+	printf("\t\t(-I is the upper bound of the search, each step of the search takes 1 second)\n");
 }
 
 static void
 bdevperf_fini(void)
 {
 	free_job_config();
+	spdk_histogram_data_free(g_slo_search.histogram);
 
 	if (g_rpc_log_file != NULL) {
 		fclose(g_rpc_log_file);
@@ -2605,6 +3026,19 @@ verify_test_params(struct spdk_app_opts *opts)
 		return 1;
 	}
 
+	if (g_slo_p99_usec > 0) {
+		if (g_arrival_rate == 0) {
+			fprintf(stderr, "-Y option must be specified with -I option\n");
+			return 1;
+		}
+
+		g_slo_search.histogram = spdk_histogram_data_alloc();
+		if (g_slo_search.histogram == NULL) {
+			fprintf(stderr, "Failed to allocate histogram\n");
+			return 1;
+		}
+	}
+
 	if (g_io_size > SPDK_BDEV_LARGE_BUF_MAX_SIZE) {
 		printf("I/O size of %d is greater than zero copy threshold (%d).\n",
 		       g_io_size, SPDK_BDEV_LARGE_BUF_MAX_SIZE);
@@ -2687,7 +3121,7 @@ main(int argc, char **argv)
 	opts.rpc_addr = NULL;
 	opts.shutdown_cb = spdk_bdevperf_shutdown_cb;
 
-	if ((rc = spdk_app_parse_args(argc, argv, &opts, "Zzfq:o:t:w:k:CEF:J:M:P:S:T:Xlj:D", NULL,
+	if ((rc = spdk_app_parse_args(argc, argv, &opts, "Zzfq:o:t:w:k:CEF:G:J:M:P:S:T:Xlj:DI:Y:a:", NULL,
 				      bdevperf_parse_arg, bdevperf_usage)) !=
 	    SPDK_APP_PARSE_ARGS_SUCCESS) {
 		return rc;
@@ -946,12 +946,11 @@ spdk_fio_getevents(struct thread_data *td, unsigned int min,
 		   unsigned int max, const struct timespec *t)
 {
 	struct spdk_fio_thread *fio_thread = td->io_ops_data;
-	struct timespec t0, t1;
-	uint64_t timeout = 0;
+	uint64_t deadline = 0;
 
 	if (t) {
-		timeout = t->tv_sec * SPDK_SEC_TO_NSEC + t->tv_nsec;
-		clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+		deadline = spdk_get_ticks() + t->tv_sec * spdk_get_ticks_hz() +
+			   t->tv_nsec * spdk_get_ticks_hz() / SPDK_SEC_TO_NSEC;
 	}
 
 	fio_thread->iocq_count = 0;
@@ -963,13 +962,8 @@ spdk_fio_getevents(struct thread_data *td, unsigned int min,
 			return fio_thread->iocq_count;
 		}
 
-		if (t) {
-			clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-			uint64_t elapse = ((t1.tv_sec - t0.tv_sec) * SPDK_SEC_TO_NSEC)
-					  + t1.tv_nsec - t0.tv_nsec;
-			if (elapse > timeout) {
-				break;
-			}
+		if (deadline != 0 && spdk_get_ticks() > deadline) {
+			break;
 		}
 	}
 
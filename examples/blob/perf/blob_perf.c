@@ -0,0 +1,850 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Blobstore benchmark. It runs a fixed sequence of phases over a set of blobs
+ * and reports the rate and latency of each one:
+ *
+ *  create, open, resize, sync_md, snapshot, clone, close, delete, delete_snapshot:
+ *	metadata operations, one per blob (two for delete: the clone and the blob),
+ *	issued from the metadata thread with up to -q operations in flight.
+ *  alloc:
+ *	first write to each cluster of the thin provisioned blobs, which allocates it.
+ *  cow:
+ *	first write to each cluster of the same blobs after they were snapshotted,
+ *	which copies the cluster from the snapshot.
+ *
+ * The data phases run on a thread per core, each writing to its share of the
+ * blobs with up to -q writes in flight, and are reported per core.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/blob.h"
+#include "spdk/blob_bdev.h"
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/histogram_data.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+
+struct perf_blob {
+	spdk_blob_id		id;
+	spdk_blob_id		snapshot_id;
+	spdk_blob_id		clone_id;
+	struct spdk_blob	*blob;
+};
+
+struct perf_op {
+	uint32_t		index;
+	uint64_t		submit_tsc;
+	struct perf_worker	*worker;
+	TAILQ_ENTRY(perf_op)	link;
+};
+
+struct perf_stats {
+	uint64_t			num_ops;
+	uint64_t			total_tsc;
+	uint64_t			max_tsc;
+	struct spdk_histogram_data	*histogram;
+};
+
+struct perf_worker {
+	uint32_t			core;
+	uint32_t			index;
+	struct spdk_thread		*thread;
+	struct spdk_io_channel		*channel;
+	void				*buf;
+	struct perf_op			*ops;
+	TAILQ_HEAD(, perf_op)		free_ops;
+	uint32_t			outstanding;
+	bool				in_submit;
+	/* Next blob and cluster to write */
+	uint32_t			next_blob;
+	uint64_t			next_cluster;
+	uint64_t			start_tsc;
+	uint64_t			end_tsc;
+	struct perf_stats		stats;
+	TAILQ_ENTRY(perf_worker)	link;
+};
+
+struct perf_phase {
+	const char	*name;
+	/* Metadata operations per blob, 0 for the data phases */
+	uint32_t	ops_per_blob;
+	void		(*submit)(struct perf_op *op);
+};
+
+static void md_create(struct perf_op *op);
+static void md_open(struct perf_op *op);
+static void md_resize(struct perf_op *op);
+static void md_sync(struct perf_op *op);
+static void md_snapshot(struct perf_op *op);
+static void md_clone(struct perf_op *op);
+static void md_close(struct perf_op *op);
+static void md_delete(struct perf_op *op);
+static void md_delete_snapshot(struct perf_op *op);
+
+static const struct perf_phase g_phases[] = {
+	{ "create", 1, md_create },
+	{ "open", 1, md_open },
+	{ "resize", 1, md_resize },
+	{ "sync_md", 1, md_sync },
+	{ "alloc", 0, NULL },
+	{ "snapshot", 1, md_snapshot },
+	{ "cow", 0, NULL },
+	{ "clone", 1, md_clone },
+	{ "close", 1, md_close },
+	{ "delete", 2, md_delete },
+	{ "delete_snapshot", 1, md_delete_snapshot },
+};
+
+static const char *g_bdev_name = "Malloc0";
+static uint32_t g_num_blobs = 128;
+static uint64_t g_blob_clusters = 4;
+static uint32_t g_queue_depth = 32;
+static uint32_t g_cluster_size = 64 * 1024;
+
+static struct spdk_app_opts g_opts = {};
+static uint64_t g_tsc_rate;
+static int g_rc;
+static struct spdk_blob_store *g_bs;
+static uint64_t g_io_units_per_cluster;
+static struct perf_blob *g_blobs;
+static TAILQ_HEAD(, perf_worker) g_workers = TAILQ_HEAD_INITIALIZER(g_workers);
+static uint32_t g_num_workers;
+static uint32_t g_num_workers_done;
+static struct spdk_thread *g_main_thread;
+
+static struct {
+	const struct perf_phase	*phase;
+	uint32_t		num_ops;
+	uint32_t		next;
+	uint32_t		outstanding;
+	bool			in_submit;
+	uint64_t		start_tsc;
+	struct perf_op		*ops;
+	struct perf_stats	stats;
+} g_md;
+
+static void run_phase(uint32_t phase_index);
+static void perf_done(void);
+
+static void
+usage(void)
+{
+	printf("blob_perf options:\n");
+	printf("\t[-b name of the bdev to create the blobstore on (default: Malloc0)]\n");
+	printf("\t[-N number of blobs (default: 128)]\n");
+	printf("\t[-S size of each blob in clusters (default: 4)]\n");
+	printf("\t[-C cluster size in bytes (default: 65536)]\n");
+	printf("\t[-q operations in flight, for the metadata phases and per core for the data\n");
+	printf("\t    phases (default: 32)]\n");
+}
+
+static int
+parse_args(int ch, char *arg)
+{
+	long long val;
+
+	if (ch == 'b') {
+		g_bdev_name = arg;
+		return 0;
+	}
+
+	val = spdk_strtoll(arg, 10);
+	if (val <= 0) {
+		fprintf(stderr, "Invalid value for -%c: %s\n", ch, arg);
+		return -EINVAL;
+	}
+
+	switch (ch) {
+	case 'N':
+		g_num_blobs = spdk_min(val, UINT32_MAX / 2);
+		break;
+	case 'S':
+		g_blob_clusters = val;
+		break;
+	case 'C':
+		g_cluster_size = spdk_min(val, UINT32_MAX);
+		break;
+	case 'q':
+		g_queue_depth = spdk_min(val, UINT32_MAX);
+		break;
+	default:
+		usage();
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+stats_init(struct perf_stats *stats)
+{
+	stats->histogram = spdk_histogram_data_alloc();
+	if (stats->histogram == NULL) {
+		fprintf(stderr, "Unable to allocate latency histogram\n");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+stats_reset(struct perf_stats *stats)
+{
+	stats->num_ops = 0;
+	stats->total_tsc = 0;
+	stats->max_tsc = 0;
+	spdk_histogram_data_reset(stats->histogram);
+}
+
+static void
+stats_tally(struct perf_stats *stats, uint64_t submit_tsc)
+{
+	uint64_t tsc = spdk_get_ticks() - submit_tsc;
+
+	stats->num_ops++;
+	stats->total_tsc += tsc;
+	stats->max_tsc = spdk_max(stats->max_tsc, tsc);
+	spdk_histogram_data_tally(stats->histogram, tsc);
+}
+
+static void
+stats_merge(struct perf_stats *dst, const struct perf_stats *src)
+{
+	dst->num_ops += src->num_ops;
+	dst->total_tsc += src->total_tsc;
+	dst->max_tsc = spdk_max(dst->max_tsc, src->max_tsc);
+	spdk_histogram_data_merge(dst->histogram, src->histogram);
+}
+
+struct latency_percentile {
+	double		percentile;
+	uint64_t	value;
+};
+
+static void
+get_percentile_latency(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		       uint64_t total, uint64_t so_far)
+{
+	struct latency_percentile *latency_percentile = ctx;
+
+	if (count == 0 || latency_percentile->value != 0) {
+		return;
+	}
+
+	if ((double)so_far / total >= latency_percentile->percentile) {
+		latency_percentile->value = end;
+	}
+}
+
+static double
+tsc_to_us(uint64_t tsc)
+{
+	return (double)tsc * SPDK_SEC_TO_USEC / g_tsc_rate;
+}
+
+static double
+get_histogram_percentile_us(struct spdk_histogram_data *histogram, double percentile)
+{
+	struct latency_percentile latency_percentile = { .percentile = percentile };
+
+	spdk_histogram_data_iterate(histogram, get_percentile_latency, &latency_percentile);
+
+	return tsc_to_us(latency_percentile.value);
+}
+
+static void
+print_header(void)
+{
+	printf("Blobstore on %s: %"PRIu64" KiB clusters, %"PRIu64" B io units, %u blobs of %"PRIu64
+	       " clusters, queue depth %u, %u cores\n", g_bdev_name,
+	       spdk_bs_get_cluster_size(g_bs) / 1024, spdk_bs_get_io_unit_size(g_bs), g_num_blobs,
+	       g_blob_clusters, g_queue_depth, g_num_workers);
+	printf("Operations are blobs for the metadata phases and clusters for the data "
+	       "phases.\n\n");
+	printf("%-16s %-6s %10s %12s %10s %10s %10s %10s %10s\n", "Phase", "Core", "Ops", "Ops/s",
+	       "MiB/s", "Avg us", "p50 us", "p99 us", "Max us");
+	fflush(stdout);
+}
+
+static void
+print_stats(const char *name, const char *core, const struct perf_stats *stats,
+	    uint64_t elapsed_tsc, bool data)
+{
+	double seconds = (double)spdk_max(elapsed_tsc, 1) / g_tsc_rate;
+	double ops_per_sec = stats->num_ops / seconds;
+	double mib_per_sec = 0;
+
+	if (data) {
+		mib_per_sec = ops_per_sec * spdk_bs_get_cluster_size(g_bs) / (1024 * 1024);
+	}
+
+	printf("%-16s %-6s %10"PRIu64" %12.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", name, core,
+	       stats->num_ops, ops_per_sec, mib_per_sec,
+	       stats->num_ops ? tsc_to_us(stats->total_tsc) / stats->num_ops : 0,
+	       get_histogram_percentile_us(stats->histogram, 0.5),
+	       get_histogram_percentile_us(stats->histogram, 0.99), tsc_to_us(stats->max_tsc));
+	fflush(stdout);
+}
+
+/* Metadata phases, run on the main thread */
+
+static void md_kick(void);
+
+static void
+md_op_done(struct perf_op *op, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "%s of blob %u failed: %s\n", g_md.phase->name, op->index,
+			spdk_strerror(-bserrno));
+		g_rc = bserrno;
+	} else {
+		stats_tally(&g_md.stats, op->submit_tsc);
+	}
+
+	g_md.outstanding--;
+	md_kick();
+}
+
+static void
+md_op_complete(void *cb_arg, int bserrno)
+{
+	md_op_done(cb_arg, bserrno);
+}
+
+static void
+md_create_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	struct perf_op *op = cb_arg;
+
+	g_blobs[op->index].id = blobid;
+	md_op_done(op, bserrno);
+}
+
+static void
+md_create(struct perf_op *op)
+{
+	struct spdk_blob_opts opts;
+
+	spdk_blob_opts_init(&opts, sizeof(opts));
+	opts.thin_provision = true;
+	spdk_bs_create_blob_ext(g_bs, &opts, md_create_complete, op);
+}
+
+static void
+md_open_complete(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct perf_op *op = cb_arg;
+
+	g_blobs[op->index].blob = blob;
+	md_op_done(op, bserrno);
+}
+
+static void
+md_open(struct perf_op *op)
+{
+	spdk_bs_open_blob(g_bs, g_blobs[op->index].id, md_open_complete, op);
+}
+
+static void
+md_resize(struct perf_op *op)
+{
+	spdk_blob_resize(g_blobs[op->index].blob, g_blob_clusters, md_op_complete, op);
+}
+
+static void
+md_sync(struct perf_op *op)
+{
+	spdk_blob_sync_md(g_blobs[op->index].blob, md_op_complete, op);
+}
+
+static void
+md_snapshot_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	struct perf_op *op = cb_arg;
+
+	g_blobs[op->index].snapshot_id = blobid;
+	md_op_done(op, bserrno);
+}
+
+static void
+md_snapshot(struct perf_op *op)
+{
+	spdk_bs_create_snapshot(g_bs, g_blobs[op->index].id, NULL, md_snapshot_complete, op);
+}
+
+static void
+md_clone_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	struct perf_op *op = cb_arg;
+
+	g_blobs[op->index].clone_id = blobid;
+	md_op_done(op, bserrno);
+}
+
+static void
+md_clone(struct perf_op *op)
+{
+	spdk_bs_create_clone(g_bs, g_blobs[op->index].snapshot_id, NULL, md_clone_complete, op);
+}
+
+static void
+md_close(struct perf_op *op)
+{
+	struct spdk_blob *blob = g_blobs[op->index].blob;
+
+	g_blobs[op->index].blob = NULL;
+	spdk_blob_close(blob, md_op_complete, op);
+}
+
+static void
+md_delete(struct perf_op *op)
+{
+	struct perf_blob *blob = &g_blobs[op->index / 2];
+
+	spdk_bs_delete_blob(g_bs, op->index % 2 ? blob->id : blob->clone_id, md_op_complete, op);
+}
+
+/* The snapshots are deleted in their own phase, once they don't have any clones anymore */
+static void
+md_delete_snapshot(struct perf_op *op)
+{
+	spdk_bs_delete_blob(g_bs, g_blobs[op->index].snapshot_id, md_op_complete, op);
+}
+
+static void
+md_kick(void)
+{
+	struct perf_op *op;
+
+	/* Operations completing inline are picked up by the outer loop */
+	if (g_md.in_submit) {
+		return;
+	}
+
+	g_md.in_submit = true;
+	while (g_rc == 0 && g_md.next < g_md.num_ops && g_md.outstanding < g_queue_depth) {
+		op = &g_md.ops[g_md.next];
+		op->index = g_md.next++;
+		op->submit_tsc = spdk_get_ticks();
+		g_md.outstanding++;
+		g_md.phase->submit(op);
+	}
+	g_md.in_submit = false;
+
+	if (g_md.outstanding > 0 || (g_rc == 0 && g_md.next < g_md.num_ops)) {
+		return;
+	}
+
+	print_stats(g_md.phase->name, "-", &g_md.stats, spdk_get_ticks() - g_md.start_tsc, false);
+	if (g_rc != 0) {
+		perf_done();
+		return;
+	}
+
+	run_phase(g_md.phase - g_phases + 1);
+}
+
+static void
+md_phase_start(const struct perf_phase *phase)
+{
+	g_md.phase = phase;
+	g_md.num_ops = g_num_blobs * phase->ops_per_blob;
+	g_md.next = 0;
+	stats_reset(&g_md.stats);
+	g_md.start_tsc = spdk_get_ticks();
+	md_kick();
+}
+
+/* Data phases, run on a thread per core */
+
+static const struct perf_phase *g_data_phase;
+static uint64_t g_data_start_tsc;
+
+static void worker_kick(struct perf_worker *worker);
+
+static void
+worker_write_complete(void *cb_arg, int bserrno)
+{
+	struct perf_op *op = cb_arg;
+	struct perf_worker *worker = op->worker;
+
+	if (bserrno != 0) {
+		fprintf(stderr, "%s write on core %u failed: %s\n", g_data_phase->name,
+			worker->core, spdk_strerror(-bserrno));
+		g_rc = bserrno;
+	} else {
+		stats_tally(&worker->stats, op->submit_tsc);
+	}
+
+	worker->outstanding--;
+	TAILQ_INSERT_HEAD(&worker->free_ops, op, link);
+	worker_kick(worker);
+}
+
+static void
+data_phase_done(void *ctx)
+{
+	struct perf_stats total = {};
+	struct perf_worker *worker;
+	uint64_t end_tsc = 0;
+	char core[16];
+
+	if (++g_num_workers_done < g_num_workers) {
+		return;
+	}
+
+	if (stats_init(&total) != 0) {
+		g_rc = -ENOMEM;
+		perf_done();
+		return;
+	}
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		snprintf(core, sizeof(core), "%u", worker->core);
+		print_stats(g_data_phase->name, core, &worker->stats,
+			    worker->end_tsc - worker->start_tsc, true);
+		stats_merge(&total, &worker->stats);
+		end_tsc = spdk_max(end_tsc, worker->end_tsc);
+	}
+
+	if (g_num_workers > 1) {
+		print_stats(g_data_phase->name, "total", &total, end_tsc - g_data_start_tsc, true);
+	}
+	spdk_histogram_data_free(total.histogram);
+
+	if (g_rc != 0) {
+		perf_done();
+		return;
+	}
+
+	run_phase(g_data_phase - g_phases + 1);
+}
+
+static void
+worker_kick(struct perf_worker *worker)
+{
+	struct perf_blob *blob;
+	struct perf_op *op;
+
+	if (worker->in_submit) {
+		return;
+	}
+
+	worker->in_submit = true;
+	while (g_rc == 0 && worker->next_blob < g_num_blobs && !TAILQ_EMPTY(&worker->free_ops)) {
+		op = TAILQ_FIRST(&worker->free_ops);
+		TAILQ_REMOVE(&worker->free_ops, op, link);
+
+		blob = &g_blobs[worker->next_blob];
+		op->submit_tsc = spdk_get_ticks();
+		worker->outstanding++;
+		spdk_blob_io_write(blob->blob, worker->channel, worker->buf,
+				   worker->next_cluster * g_io_units_per_cluster, 1,
+				   worker_write_complete, op);
+
+		if (++worker->next_cluster == g_blob_clusters) {
+			worker->next_cluster = 0;
+			worker->next_blob += g_num_workers;
+		}
+	}
+	worker->in_submit = false;
+
+	if (worker->outstanding > 0 || (g_rc == 0 && worker->next_blob < g_num_blobs)) {
+		return;
+	}
+
+	worker->end_tsc = spdk_get_ticks();
+	spdk_thread_send_msg(g_main_thread, data_phase_done, NULL);
+}
+
+static void
+worker_run(void *ctx)
+{
+	struct perf_worker *worker = ctx;
+
+	worker->next_blob = worker->index;
+	worker->next_cluster = 0;
+	worker->start_tsc = spdk_get_ticks();
+	worker_kick(worker);
+}
+
+static void
+data_phase_start(const struct perf_phase *phase)
+{
+	struct perf_worker *worker;
+
+	g_data_phase = phase;
+	g_num_workers_done = 0;
+	g_data_start_tsc = spdk_get_ticks();
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		stats_reset(&worker->stats);
+		spdk_thread_send_msg(worker->thread, worker_run, worker);
+	}
+}
+
+static void
+run_phase(uint32_t phase_index)
+{
+	const struct perf_phase *phase;
+
+	if (phase_index == SPDK_COUNTOF(g_phases)) {
+		perf_done();
+		return;
+	}
+
+	phase = &g_phases[phase_index];
+	if (phase->ops_per_blob != 0) {
+		md_phase_start(phase);
+	} else {
+		data_phase_start(phase);
+	}
+}
+
+/* Setup and teardown */
+
+static void
+unload_complete(void *cb_arg, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to unload the blobstore: %s\n", spdk_strerror(-bserrno));
+		if (g_rc == 0) {
+			g_rc = bserrno;
+		}
+	}
+
+	spdk_app_stop(g_rc);
+}
+
+static void
+worker_exited(void *ctx)
+{
+	if (++g_num_workers_done < g_num_workers) {
+		return;
+	}
+
+	spdk_bs_unload(g_bs, unload_complete, NULL);
+}
+
+static void
+worker_exit(void *ctx)
+{
+	struct perf_worker *worker = ctx;
+
+	if (worker->channel != NULL) {
+		spdk_bs_free_io_channel(worker->channel);
+	}
+	spdk_free(worker->buf);
+	spdk_thread_exit(worker->thread);
+	spdk_thread_send_msg(g_main_thread, worker_exited, NULL);
+}
+
+static void
+perf_done(void)
+{
+	struct perf_worker *worker;
+
+	g_num_workers_done = 0;
+	if (g_num_workers == 0) {
+		spdk_bs_unload(g_bs, unload_complete, NULL);
+		return;
+	}
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		spdk_thread_send_msg(worker->thread, worker_exit, worker);
+	}
+}
+
+static void
+worker_started(void *ctx)
+{
+	if (++g_num_workers_done < g_num_workers) {
+		return;
+	}
+
+	if (g_rc != 0) {
+		perf_done();
+		return;
+	}
+
+	print_header();
+	run_phase(0);
+}
+
+static void
+worker_start(void *ctx)
+{
+	struct perf_worker *worker = ctx;
+
+	worker->channel = spdk_bs_alloc_io_channel(g_bs);
+	worker->buf = spdk_zmalloc(spdk_bs_get_io_unit_size(g_bs), 0x1000, NULL,
+				   SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (worker->channel == NULL || worker->buf == NULL) {
+		fprintf(stderr, "Unable to allocate the I/O resources of core %u\n", worker->core);
+		g_rc = -ENOMEM;
+	}
+
+	spdk_thread_send_msg(g_main_thread, worker_started, NULL);
+}
+
+static int
+create_workers(void)
+{
+	struct spdk_cpuset cpumask;
+	struct perf_worker *worker;
+	char thread_name[32];
+	uint32_t i, j;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		worker = calloc(1, sizeof(*worker));
+		if (worker == NULL) {
+			return -ENOMEM;
+		}
+
+		worker->core = i;
+		worker->index = g_num_workers;
+		TAILQ_INIT(&worker->free_ops);
+		worker->ops = calloc(g_queue_depth, sizeof(*worker->ops));
+		if (worker->ops == NULL || stats_init(&worker->stats) != 0) {
+			goto err;
+		}
+
+		for (j = 0; j < g_queue_depth; j++) {
+			worker->ops[j].worker = worker;
+			TAILQ_INSERT_TAIL(&worker->free_ops, &worker->ops[j], link);
+		}
+
+		snprintf(thread_name, sizeof(thread_name), "blob_perf_%u", i);
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, i, true);
+		worker->thread = spdk_thread_create(thread_name, &cpumask);
+		if (worker->thread == NULL) {
+			goto err;
+		}
+
+		/* Only the workers with a thread are on the list */
+		TAILQ_INSERT_TAIL(&g_workers, worker, link);
+		g_num_workers++;
+	}
+
+	return 0;
+err:
+	spdk_histogram_data_free(worker->stats.histogram);
+	free(worker->ops);
+	free(worker);
+	return -ENOMEM;
+}
+
+static void
+bs_init_complete(void *cb_arg, struct spdk_blob_store *bs, int bserrno)
+{
+	struct perf_worker *worker;
+	uint64_t needed_clusters;
+
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to initialize the blobstore on %s: %s\n", g_bdev_name,
+			spdk_strerror(-bserrno));
+		spdk_app_stop(bserrno);
+		return;
+	}
+
+	g_bs = bs;
+	g_io_units_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_io_unit_size(bs);
+
+	/* The blobs and their snapshots are fully allocated by the alloc and cow phases */
+	needed_clusters = 2 * g_num_blobs * g_blob_clusters;
+	if (needed_clusters > spdk_bs_free_cluster_count(bs)) {
+		fprintf(stderr, "%"PRIu64" clusters are needed but only %"PRIu64" are free on %s\n",
+			needed_clusters, spdk_bs_free_cluster_count(bs), g_bdev_name);
+		g_rc = -ENOSPC;
+		perf_done();
+		return;
+	}
+
+	g_md.ops = calloc(2 * g_num_blobs, sizeof(*g_md.ops));
+	g_blobs = calloc(g_num_blobs, sizeof(*g_blobs));
+	if (g_md.ops == NULL || g_blobs == NULL || stats_init(&g_md.stats) != 0) {
+		fprintf(stderr, "Unable to allocate memory\n");
+		g_rc = -ENOMEM;
+		perf_done();
+		return;
+	}
+
+	g_rc = create_workers();
+	if (g_rc != 0) {
+		fprintf(stderr, "Unable to create the worker threads\n");
+		perf_done();
+		return;
+	}
+
+	g_num_workers_done = 0;
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		spdk_thread_send_msg(worker->thread, worker_start, worker);
+	}
+}
+
+static void
+base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void *event_ctx)
+{
+	SPDK_WARNLOG("Unsupported bdev event: type %d\n", type);
+}
+
+static void
+blob_perf_start(void *arg)
+{
+	struct spdk_bs_dev *bs_dev = NULL;
+	struct spdk_bs_opts opts;
+	int rc;
+
+	g_main_thread = spdk_get_thread();
+	g_tsc_rate = spdk_get_ticks_hz();
+
+	rc = spdk_bdev_create_bs_dev_ext(g_bdev_name, base_bdev_event_cb, NULL, &bs_dev);
+	if (rc != 0) {
+		fprintf(stderr, "Could not open bdev %s: %s\n", g_bdev_name, spdk_strerror(-rc));
+		spdk_app_stop(rc);
+		return;
+	}
+
+	spdk_bs_opts_init(&opts, sizeof(opts));
+	opts.cluster_sz = g_cluster_size;
+	spdk_bs_init(bs_dev, &opts, bs_init_complete, NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct perf_worker *worker, *tmp;
+	int rc;
+
+	spdk_app_opts_init(&g_opts, sizeof(g_opts));
+	g_opts.name = "blob_perf";
+	g_opts.reactor_mask = "0x1";
+	rc = spdk_app_parse_args(argc, argv, &g_opts, "b:q:C:N:S:", NULL, parse_args, usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc == SPDK_APP_PARSE_ARGS_HELP ? 0 : 1;
+	}
+
+	rc = spdk_app_start(&g_opts, blob_perf_start, NULL);
+	if (rc != 0) {
+		fprintf(stderr, "blob_perf failed: %s\n", spdk_strerror(abs(rc)));
+	}
+
+	TAILQ_FOREACH_SAFE(worker, &g_workers, link, tmp) {
+		spdk_histogram_data_free(worker->stats.histogram);
+		free(worker->ops);
+		free(worker);
+	}
+	spdk_histogram_data_free(g_md.stats.histogram);
+	free(g_md.ops);
+	free(g_blobs);
+
+	spdk_app_fini();
+	return rc;
+}
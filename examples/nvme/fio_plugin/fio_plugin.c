@@ -71,6 +71,7 @@ struct spdk_fio_options {
 	int	initial_zone_reset;
 	int	zone_append;
 	int	print_qid_mappings;
+	int	enable_poll_group;
 	char	*log_flags;
 };
 
@@ -118,6 +119,8 @@ struct spdk_fio_qpair {
 	 * this is valid only if nvme_pi_enabled is true.
 	 */
 	bool				md_start;
+	/* Number of I/O submitted and not completed yet on this qpair */
+	uint32_t			outstanding;
 	TAILQ_ENTRY(spdk_fio_qpair)	link;
 	struct spdk_fio_ctrlr		*fio_ctrlr;
 };
@@ -127,6 +130,7 @@ struct spdk_fio_thread {
 
 	TAILQ_HEAD(, spdk_fio_qpair)	fio_qpair;
 	struct spdk_fio_qpair		*fio_qpair_current;	/* the current fio_qpair to be handled. */
+	struct spdk_nvme_poll_group	*group;		/* polls all the qpairs, if enabled */
 
 	struct io_u			**iocq;		/* io completion queue */
 	unsigned int			iocq_count;	/* number of iocq entries filled by last getevents */
@@ -616,6 +620,14 @@ spdk_fio_setup(struct thread_data *td)
 	}
 	pthread_mutex_unlock(&g_mutex);
 
+	if (fio_options->enable_poll_group) {
+		fio_thread->group = spdk_nvme_poll_group_create(fio_thread, NULL);
+		if (fio_thread->group == NULL) {
+			SPDK_ERRLOG("Failed to create poll group\n");
+			return 1;
+		}
+	}
+
 	for_each_file(td, f, i) {
 		memset(&trid, 0, sizeof(trid));
 
@@ -690,7 +702,9 @@ spdk_fio_open(struct thread_data *td, struct fio_file *f)
 	struct spdk_fio_qpair *fio_qpair = f->engine_data;
 	struct spdk_fio_ctrlr *fio_ctrlr = fio_qpair->fio_ctrlr;
 	struct spdk_fio_options *fio_options = td->eo;
+	struct spdk_fio_thread *fio_thread = td->io_ops_data;
 	struct spdk_nvme_io_qpair_opts	qpopts;
+	int rc;
 
 	assert(fio_qpair->qpair == NULL);
 	spdk_nvme_ctrlr_get_default_io_qpair_opts(fio_ctrlr->ctrlr, &qpopts, sizeof(qpopts));
@@ -698,6 +712,8 @@ spdk_fio_open(struct thread_data *td, struct fio_file *f)
 	if (fio_options->enable_wrr) {
 		qpopts.qprio = fio_options->wrr_priority;
 	}
+	/* A qpair has to be added to a poll group before it is connected */
+	qpopts.create_only = fio_thread->group != NULL;
 
 	fio_qpair->qpair = spdk_nvme_ctrlr_alloc_io_qpair(fio_ctrlr->ctrlr, &qpopts, sizeof(qpopts));
 	if (!fio_qpair->qpair) {
@@ -707,6 +723,20 @@ spdk_fio_open(struct thread_data *td, struct fio_file *f)
 		return -1;
 	}
 
+	if (fio_thread->group != NULL) {
+		rc = spdk_nvme_poll_group_add(fio_thread->group, fio_qpair->qpair);
+		if (rc == 0) {
+			rc = spdk_nvme_ctrlr_connect_io_qpair(fio_ctrlr->ctrlr, fio_qpair->qpair);
+		}
+		if (rc != 0) {
+			SPDK_ERRLOG("Cannot connect nvme io_qpair: %s\n", spdk_strerror(-rc));
+			spdk_nvme_ctrlr_free_io_qpair(fio_qpair->qpair);
+			fio_qpair->qpair = NULL;
+			g_error = true;
+			return -1;
+		}
+	}
+
 	if (fio_options->print_qid_mappings == 1) {
 		log_info("job %s: %s qid %d\n", td->o.name, f->file_name,
 			 spdk_nvme_qpair_get_id(fio_qpair->qpair));
@@ -968,6 +998,8 @@ spdk_fio_completion_cb(void *ctx, const struct spdk_nvme_cpl *cpl)
 		fio_req->io->error = EIO;
 	}
 
+	assert(fio_qpair->outstanding > 0);
+	fio_qpair->outstanding--;
 	assert(fio_thread->iocq_count < fio_thread->iocq_size);
 	fio_thread->iocq[fio_thread->iocq_count++] = fio_req->io;
 }
@@ -1148,6 +1180,7 @@ spdk_fio_queue(struct thread_data *td, struct io_u *io_u)
 		return FIO_Q_COMPLETED;
 	}
 
+	fio_qpair->outstanding++;
 	return FIO_Q_QUEUED;
 }
 
@@ -1161,22 +1194,59 @@ spdk_fio_event(struct thread_data *td, int event)
 	return fio_thread->iocq[event];
 }
 
+static void
+spdk_fio_disconnected_qpair_cb(struct spdk_nvme_qpair *qpair, void *poll_group_ctx)
+{
+	SPDK_ERRLOG("qpair %d disconnected\n", spdk_nvme_qpair_get_id(qpair));
+}
+
+static int
+spdk_fio_getevents_group(struct spdk_fio_thread *fio_thread, unsigned int min,
+			 unsigned int max, uint64_t deadline)
+{
+	int64_t rc;
+
+	for (;;) {
+		/* A single call polls every qpair, sharing the transport's polling among them */
+		rc = spdk_nvme_poll_group_process_completions(fio_thread->group,
+				max - fio_thread->iocq_count,
+				spdk_fio_disconnected_qpair_cb);
+		if (rc < 0) {
+			SPDK_ERRLOG("Failed to poll completions: %s\n", spdk_strerror(-rc));
+			break;
+		}
+
+		if (fio_thread->iocq_count >= min) {
+			break;
+		}
+
+		if (deadline != 0 && spdk_get_ticks() > deadline) {
+			break;
+		}
+	}
+
+	return fio_thread->iocq_count;
+}
+
 static int
 spdk_fio_getevents(struct thread_data *td, unsigned int min,
 		   unsigned int max, const struct timespec *t)
 {
 	struct spdk_fio_thread *fio_thread = td->io_ops_data;
 	struct spdk_fio_qpair *fio_qpair = NULL;
-	struct timespec t0, t1;
-	uint64_t timeout = 0;
+	uint64_t deadline = 0;
 
 	if (t) {
-		timeout = t->tv_sec * 1000000000L + t->tv_nsec;
-		clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+		deadline = spdk_get_ticks() + t->tv_sec * spdk_get_ticks_hz() +
+			   t->tv_nsec * spdk_get_ticks_hz() / SPDK_SEC_TO_NSEC;
 	}
 
 	fio_thread->iocq_count = 0;
 
+	if (fio_thread->group != NULL) {
+		return spdk_fio_getevents_group(fio_thread, min, max, deadline);
+	}
+
 	/* fetch the next qpair */
 	if (fio_thread->fio_qpair_current) {
 		fio_qpair = TAILQ_NEXT(fio_thread->fio_qpair_current, link);
@@ -1192,7 +1262,8 @@ spdk_fio_getevents(struct thread_data *td, unsigned int min,
 			 * We can be called while spdk_fio_open()s are still
 			 * ongoing, in which case, ->qpair can still be NULL.
 			 */
-			if (fio_qpair->qpair == NULL) {
+			if (fio_qpair->qpair == NULL || fio_qpair->outstanding == 0) {
+				/* Don't poll qpairs fio didn't submit anything to */
 				fio_qpair = TAILQ_NEXT(fio_qpair, link);
 				continue;
 			}
@@ -1208,15 +1279,8 @@ spdk_fio_getevents(struct thread_data *td, unsigned int min,
 			fio_qpair = TAILQ_NEXT(fio_qpair, link);
 		}
 
-		if (t) {
-			uint64_t elapse;
-
-			clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-			elapse = ((t1.tv_sec - t0.tv_sec) * 1000000000L)
-				 + t1.tv_nsec - t0.tv_nsec;
-			if (elapse > timeout) {
-				break;
-			}
+		if (deadline != 0 && spdk_get_ticks() > deadline) {
+			break;
 		}
 	}
 
@@ -1522,6 +1586,10 @@ spdk_fio_cleanup(struct thread_data *td)
 		free(fio_qpair);
 	}
 
+	if (fio_thread->group != NULL) {
+		spdk_nvme_poll_group_destroy(fio_thread->group);
+	}
+
 	free(fio_thread->iocq);
 	free(fio_thread);
 
@@ -1776,6 +1844,16 @@ static struct fio_option options[] = {
 		.category	= FIO_OPT_C_ENGINE,
 		.group		= FIO_OPT_G_INVALID,
 	},
+	{
+		.name		= "enable_poll_group",
+		.lname		= "Enable poll group",
+		.type		= FIO_OPT_INT,
+		.off1		= offsetof(struct spdk_fio_options, enable_poll_group),
+		.def		= "0",
+		.help		= "Poll the qpairs of a job with a poll group (0=disable, 1=enable)",
+		.category	= FIO_OPT_C_ENGINE,
+		.group		= FIO_OPT_G_INVALID,
+	},
 	{
 		.name		= "log_flags",
 		.lname		= "log_flags",
@@ -24,6 +24,7 @@
 #include "spdk/likely.h"
 #include "spdk/sock.h"
 #include "spdk/zipf.h"
+#include "spdk/workload.h"
 #include "spdk/nvmf.h"
 
 #ifdef SPDK_CONFIG_URING
@@ -86,6 +87,8 @@ struct ns_entry {
 	bool			pi_loc;
 	enum spdk_nvme_pi_type	pi_type;
 	uint32_t		io_flags;
+	/* NUMA node of the controller, SPDK_ENV_SOCKET_ID_ANY if unknown */
+	int			socket_id;
 	char			name[1024];
 };
 
@@ -120,6 +123,9 @@ struct ns_worker_stats {
 	uint64_t		idle_tsc;
 	uint64_t		last_busy_tsc;
 	uint64_t		last_idle_tsc;
+	/* Software overhead: ticks spent submitting I/O and processing completions */
+	uint64_t		submit_tsc;
+	uint64_t		poll_tsc;
 };
 
 struct ns_worker_ctx {
@@ -127,6 +133,7 @@ struct ns_worker_ctx {
 	struct ns_worker_stats	stats;
 	uint64_t		current_queue_depth;
 	uint64_t		offset_in_ios;
+	struct spdk_workload	*workload;
 	bool			is_draining;
 
 	union {
@@ -254,6 +261,7 @@ static uint32_t g_keep_alive_timeout_in_ms = 10000;
 static bool g_continue_on_error = false;
 static uint32_t g_quiet_count = 1;
 static double g_zipf_theta;
+static const char *g_workload_spec;
 /* Set default io_queue_size to UINT16_MAX, NVMe driver will then reduce this
  * to MQES to maximize the io_queue_size as much as possible.
  */
@@ -439,6 +447,30 @@ nvme_perf_allocate_iovs(struct perf_task *task, void *buf, uint32_t length)
 	return 0;
 }
 
+/*
+ * Allocate the task buffers on the NUMA node of the controller if it is known,
+ * so that the device DMA doesn't cross the interconnect, or on the node of the
+ * core running the worker otherwise.
+ */
+static void *
+perf_dma_zmalloc(struct perf_task *task, size_t size)
+{
+	int socket_id = task->ns_ctx->entry->socket_id;
+	void *buf;
+
+	if (socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+		socket_id = spdk_env_get_socket_id(spdk_env_get_current_core());
+	}
+
+	buf = spdk_dma_zmalloc_socket(size, g_io_align, NULL, socket_id);
+	if (buf == NULL) {
+		/* The local node may be out of hugepages, fall back to any node */
+		buf = spdk_dma_zmalloc(size, g_io_align, NULL);
+	}
+
+	return buf;
+}
+
 #ifdef SPDK_CONFIG_URING
 
 static void
@@ -454,7 +486,7 @@ uring_setup_payload(struct perf_task *task, uint8_t pattern)
 	task->iovcnt = 1;
 
 	iov = &task->iovs[0];
-	iov->iov_base = spdk_dma_zmalloc(g_io_size_bytes, g_io_align, NULL);
+	iov->iov_base = perf_dma_zmalloc(task, g_io_size_bytes);
 	iov->iov_len = g_io_size_bytes;
 	if (iov->iov_base == NULL) {
 		fprintf(stderr, "spdk_dma_zmalloc() for task->iovs[0].iov_base failed\n");
@@ -580,7 +612,7 @@ aio_setup_payload(struct perf_task *task, uint8_t pattern)
 	task->iovcnt = 1;
 
 	iov = &task->iovs[0];
-	iov->iov_base = spdk_dma_zmalloc(g_io_size_bytes, g_io_align, NULL);
+	iov->iov_base = perf_dma_zmalloc(task, g_io_size_bytes);
 	iov->iov_len = g_io_size_bytes;
 	if (iov->iov_base == NULL) {
 		fprintf(stderr, "spdk_dma_zmalloc() for task->iovs[0].iov_base failed\n");
@@ -766,6 +798,7 @@ register_file(const char *path)
 		entry->u.aio.fd = fd;
 #endif
 	}
+	entry->socket_id = SPDK_ENV_SOCKET_ID_ANY;
 	entry->size_in_ios = size / g_io_size_bytes;
 	entry->io_size_blocks = g_io_size_bytes / blklen;
 
@@ -813,7 +846,7 @@ nvme_setup_payload(struct perf_task *task, uint8_t pattern)
 	 * it's same with g_io_size_bytes for namespace without metadata.
 	 */
 	max_io_size_bytes = g_io_size_bytes + g_max_io_md_size * g_max_io_size_blocks;
-	buf = spdk_dma_zmalloc(max_io_size_bytes, g_io_align, NULL);
+	buf = perf_dma_zmalloc(task, max_io_size_bytes);
 	if (buf == NULL) {
 		fprintf(stderr, "task->buf spdk_dma_zmalloc failed\n");
 		exit(1);
@@ -829,7 +862,7 @@ nvme_setup_payload(struct perf_task *task, uint8_t pattern)
 
 	max_io_md_size = g_max_io_md_size * g_max_io_size_blocks;
 	if (max_io_md_size != 0) {
-		task->md_iov.iov_base = spdk_dma_zmalloc(max_io_md_size, g_io_align, NULL);
+		task->md_iov.iov_base = perf_dma_zmalloc(task, max_io_md_size);
 		task->md_iov.iov_len = max_io_md_size;
 		if (task->md_iov.iov_base == NULL) {
 			fprintf(stderr, "task->md_buf spdk_dma_zmalloc failed\n");
@@ -1245,6 +1278,7 @@ register_ns(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
 {
 	struct ns_entry *entry;
 	const struct spdk_nvme_ctrlr_data *cdata;
+	struct spdk_pci_device *pci_dev;
 	uint32_t max_xfer_size, entries, sector_size;
 	uint64_t ns_size;
 	struct spdk_nvme_io_qpair_opts opts;
@@ -1299,6 +1333,11 @@ register_ns(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
 	entry->fn_table = &nvme_fn_table;
 	entry->u.nvme.ctrlr = ctrlr;
 	entry->u.nvme.ns = ns;
+	entry->socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	pci_dev = spdk_nvme_ctrlr_get_pci_device(ctrlr);
+	if (pci_dev != NULL) {
+		entry->socket_id = spdk_pci_device_get_socket_id(pci_dev);
+	}
 	entry->num_io_requests = entries * spdk_divide_round_up(g_queue_depth, g_nr_io_queues_per_ns);
 
 	entry->size_in_ios = ns_size / g_io_size_bytes;
@@ -1461,6 +1500,7 @@ register_ctrlr(struct spdk_nvme_ctrlr *ctrlr, struct trid_entry *trid_entry)
 static inline void
 submit_single_io(struct perf_task *task)
 {
+	struct spdk_workload_io	io;
 	uint64_t		offset_in_ios;
 	int			rc;
 	struct ns_worker_ctx	*ns_ctx = task->ns_ctx;
@@ -1468,7 +1508,10 @@ submit_single_io(struct perf_task *task)
 
 	assert(!ns_ctx->is_draining);
 
-	if (entry->zipf) {
+	if (ns_ctx->workload) {
+		spdk_workload_next(ns_ctx->workload, &io);
+		offset_in_ios = io.offset;
+	} else if (entry->zipf) {
 		offset_in_ios = spdk_zipf_generate(entry->zipf);
 	} else if (g_is_random) {
 		offset_in_ios = rand_r(&entry->seed) % entry->size_in_ios;
@@ -1481,14 +1524,17 @@ submit_single_io(struct perf_task *task)
 
 	task->submit_tsc = spdk_get_ticks();
 
-	if ((g_rw_percentage == 100) ||
-	    (g_rw_percentage != 0 && ((rand_r(&entry->seed) % 100) < g_rw_percentage))) {
+	if (ns_ctx->workload) {
+		task->is_read = io.is_read;
+	} else if ((g_rw_percentage == 100) ||
+		   (g_rw_percentage != 0 && ((rand_r(&entry->seed) % 100) < g_rw_percentage))) {
 		task->is_read = true;
 	} else {
 		task->is_read = false;
 	}
 
 	rc = entry->fn_table->submit_io(task, ns_ctx, entry, offset_in_ios);
+	ns_ctx->stats.submit_tsc += spdk_get_ticks() - task->submit_tsc;
 
 	if (spdk_unlikely(rc != 0)) {
 		if (g_continue_on_error) {
@@ -1594,9 +1640,8 @@ allocate_task(struct ns_worker_ctx *ns_ctx, int queue_depth)
 		exit(1);
 	}
 
-	ns_ctx->entry->fn_table->setup_payload(task, queue_depth % 8 + 1);
-
 	task->ns_ctx = ns_ctx;
+	ns_ctx->entry->fn_table->setup_payload(task, queue_depth % 8 + 1);
 
 	return task;
 }
@@ -1766,6 +1811,7 @@ work_fn(void *arg)
 
 			if (check_rc > 0) {
 				ns_ctx->stats.busy_tsc += check_now - ns_ctx->stats.last_tsc;
+				ns_ctx->stats.poll_tsc += spdk_get_ticks() - check_now;
 			} else {
 				ns_ctx->stats.idle_tsc += check_now - ns_ctx->stats.last_tsc;
 			}
@@ -1905,6 +1951,8 @@ usage(char *program_name)
 	printf("\t\t Example: -e 'PRACT=0,PRCHK=GUARD|REFTAG|APPTAG'\n");
 	printf("\t\t          -e 'PRACT=1,PRCHK=GUARD'\n");
 	printf("\t-F, --zipf <theta> use zipf distribution for random I/O\n");
+	printf("\t--workload <spec> generate the offsets and directions of I/O from a workload\n");
+	printf("\t\t(e.g. zipf:1.2,rw=0-10:100 or replay:<trace file>)\n");
 #ifdef SPDK_CONFIG_URING
 	printf("\t-R, --enable-uring enable using liburing to drive kernel devices (Default: libaio)\n");
 #endif
@@ -1992,6 +2040,55 @@ print_bucket(void *ctx, uint64_t start, uint64_t end, uint64_t count,
 	       so_far_pct, count);
 }
 
+/*
+ * Report the ticks each core spends submitting I/O and processing completions.
+ * A core whose IOPS get close to what this overhead allows is CPU bound, adding
+ * cores or devices to it won't help.
+ */
+static void
+print_core_overhead(void)
+{
+	struct worker_thread	*worker;
+	struct ns_worker_ctx	*ns_ctx;
+	uint64_t io_submitted, io_completed, submit_tsc, poll_tsc, busy_tsc, idle_tsc;
+	double submit_cycles, complete_cycles, io_per_second, max_io_per_second, busy;
+
+	printf("%-35s %10s %10s %10s %10s %10s\n", "Software overhead (cycles/IO)",
+	       "IOPS", "Busy(%)", "Submit", "Complete", "Max IOPS");
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		io_submitted = io_completed = submit_tsc = poll_tsc = busy_tsc = idle_tsc = 0;
+		TAILQ_FOREACH(ns_ctx, &worker->ns_ctx, link) {
+			io_submitted += ns_ctx->stats.io_submitted;
+			io_completed += ns_ctx->stats.io_completed;
+			submit_tsc += ns_ctx->stats.submit_tsc;
+			poll_tsc += ns_ctx->stats.poll_tsc;
+			busy_tsc += ns_ctx->stats.busy_tsc;
+			idle_tsc += ns_ctx->stats.idle_tsc;
+		}
+
+		if (io_submitted == 0 || io_completed == 0) {
+			continue;
+		}
+
+		/* Completion processing resubmits I/O, don't count that twice */
+		submit_cycles = (double)submit_tsc / io_submitted;
+		complete_cycles = 0;
+		if (poll_tsc > submit_tsc) {
+			complete_cycles = (double)(poll_tsc - submit_tsc) / io_completed;
+		}
+		io_per_second = (double)io_completed * 1000 * 1000 / g_elapsed_time_in_usec;
+		max_io_per_second = g_tsc_rate / spdk_max(submit_cycles + complete_cycles, 1);
+		busy = busy_tsc + idle_tsc != 0 ? (double)busy_tsc / (busy_tsc + idle_tsc) * 100 : 0;
+
+		printf("Core %-3u on NUMA node %-13u %10.2f %10.2f %10.0f %10.0f %10.2f\n",
+		       worker->lcore, spdk_env_get_socket_id(worker->lcore), io_per_second, busy,
+		       submit_cycles, complete_cycles, max_io_per_second);
+	}
+
+	printf("\n");
+}
+
 static void
 print_performance(void)
 {
@@ -2061,6 +2158,7 @@ print_performance(void)
 		       max_strlen + 13, "Total", total_io_per_second, total_mb_per_second,
 		       sum_ave_latency, min_latency_so_far, max_latency_so_far);
 		printf("\n");
+		print_core_overhead();
 	}
 
 	if (g_latency_sw_tracking_level == 0 || total_io_completed == 0) {
@@ -2469,6 +2567,8 @@ static const struct option g_perf_cmdline_opts[] = {
 	{"rdma-srq-size", required_argument, NULL, PERF_RDMA_SRQ_SIZE},
 #define PERF_USE_EVERY_CORE	269
 	{"use-every-core", no_argument, NULL, PERF_USE_EVERY_CORE},
+#define PERF_WORKLOAD		270
+	{"workload", required_argument, NULL, PERF_WORKLOAD},
 	/* Should be the last element */
 	{0, 0, 0, 0}
 };
@@ -2483,6 +2583,8 @@ parse_args(int argc, char **argv, struct spdk_env_opts *env_opts)
 	char *endptr;
 	bool ssl_used = false;
 	char *sock_impl = "posix";
+	struct spdk_workload_opts workload_opts = { .range = 1, .unit_size = 512 };
+	struct spdk_workload *workload;
 
 	while ((op = getopt_long(argc, argv, PERF_GETOPT_SHORT, g_perf_cmdline_opts, &long_idx)) != -1) {
 		switch (op) {
@@ -2588,6 +2690,16 @@ parse_args(int argc, char **argv, struct spdk_env_opts *env_opts)
 				return 1;
 			}
 			break;
+		case PERF_WORKLOAD:
+			/* Validate the specification, the generators are created per worker */
+			workload = spdk_workload_create(optarg, &workload_opts);
+			if (workload == NULL) {
+				fprintf(stderr, "Illegal workload %s\n", optarg);
+				return 1;
+			}
+			spdk_workload_free(&workload);
+			g_workload_spec = optarg;
+			break;
 		case PERF_ALLOWED_PCI_ADDR:
 			if (add_allowed_pci_device(optarg, env_opts)) {
 				usage(argv[0]);
@@ -2891,6 +3003,7 @@ unregister_workers(void)
 		TAILQ_FOREACH_SAFE(ns_ctx, &worker->ns_ctx, link, tmp_ns_ctx) {
 			TAILQ_REMOVE(&worker->ns_ctx, ns_ctx, link);
 			spdk_histogram_data_free(ns_ctx->histogram);
+			spdk_workload_free(&ns_ctx->workload);
 			free(ns_ctx);
 		}
 
@@ -3043,8 +3156,34 @@ allocate_ns_worker(struct ns_entry *entry, struct worker_thread *worker)
 	}
 
 	printf("Associating %s with lcore %d\n", entry->name, worker->lcore);
+	if (entry->socket_id != SPDK_ENV_SOCKET_ID_ANY &&
+	    entry->socket_id != (int)spdk_env_get_socket_id(worker->lcore)) {
+		printf("WARNING: lcore %d on NUMA node %u drives %s attached to NUMA node %d\n",
+		       worker->lcore, spdk_env_get_socket_id(worker->lcore), entry->name,
+		       entry->socket_id);
+		g_warn = true;
+	}
 	ns_ctx->stats.min_tsc = UINT64_MAX;
 	ns_ctx->entry = entry;
+
+	/* Workload generators aren't thread safe, so each worker gets its own */
+	if (g_workload_spec != NULL) {
+		struct spdk_workload_opts workload_opts = {
+			.range = entry->size_in_ios,
+			.unit_size = g_io_size_bytes,
+			.read_percentage = g_rw_percentage,
+			.seed = rand(),
+		};
+
+		ns_ctx->workload = spdk_workload_create(g_workload_spec, &workload_opts);
+		if (ns_ctx->workload == NULL) {
+			fprintf(stderr, "Could not create workload %s for %s\n", g_workload_spec,
+				entry->name);
+			free(ns_ctx);
+			return -1;
+		}
+	}
+
 	ns_ctx->histogram = spdk_histogram_data_alloc();
 	TAILQ_INSERT_TAIL(&worker->ns_ctx, ns_ctx, link);
 
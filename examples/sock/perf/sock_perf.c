@@ -0,0 +1,1008 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Socket benchmark. The server (-S) echoes the messages it receives back to the client. The
+ * client opens -C connections on each of its cores, keeps -q messages in flight on each of
+ * them and measures the time until the echo of each message is fully received.
+ *
+ * Each core runs its own sock group, so the system calls per message reported from the group
+ * statistics show how well the sock implementation and its options batch the traffic.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/histogram_data.h"
+#include "spdk/hexlify.h"
+#include "spdk/log.h"
+#include "spdk/nvmf.h"
+#include "spdk/sock.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+
+#define ACCEPT_POLL_PERIOD_US	1000
+#define MAX_RECV_BUF_SIZE	(1024 * 1024)
+
+struct perf_req {
+	struct spdk_sock_request	sock_req;
+	/* Must immediately follow sock_req, see SPDK_SOCK_REQUEST_IOV() */
+	struct iovec			iov;
+	struct perf_conn		*conn;
+	void				*buf;
+	uint64_t			submit_tsc;
+	bool				write_done;
+	bool				echo_done;
+	TAILQ_ENTRY(perf_req)		link;
+};
+
+struct perf_conn {
+	struct perf_worker		*worker;
+	struct spdk_sock		*sock;
+	struct perf_req			*reqs;
+	/* Client: the messages waiting for their echo, in the order they were sent */
+	TAILQ_HEAD(, perf_req)		inflight;
+	/* Server: the message being received */
+	uint32_t			recv_index;
+	/* Bytes received of the current message */
+	uint32_t			recv_offset;
+	uint32_t			outstanding;
+	bool				in_group;
+	bool				failed;
+	/* Server: the reads stopped because all the messages were waiting to be echoed */
+	bool				recv_blocked;
+	TAILQ_ENTRY(perf_conn)		link;
+};
+
+struct perf_worker {
+	uint32_t			core;
+	struct spdk_thread		*thread;
+	struct spdk_sock_group		*group;
+	struct spdk_poller		*poller;
+	TAILQ_HEAD(, perf_conn)		conns;
+	uint32_t			num_conns;
+	void				*send_buf;
+	void				*recv_buf;
+	bool				stopping;
+	uint64_t			start_tsc;
+	uint64_t			end_tsc;
+	uint64_t			num_msgs;
+	uint64_t			total_tsc;
+	uint64_t			max_tsc;
+	struct spdk_histogram_data	*histogram;
+	struct spdk_sock_group_stats	stats;
+	TAILQ_ENTRY(perf_worker)	link;
+};
+
+static char *g_host = "127.0.0.1";
+static int g_port = 12345;
+static const char *g_sock_impl_name;
+static bool g_is_server;
+static uint32_t g_msg_size = 4096;
+static uint32_t g_conns_per_core = 1;
+static uint32_t g_queue_depth = 1;
+static int g_time_in_sec = 10;
+static bool g_zcopy;
+static bool g_ktls;
+static int g_tls_version;
+static bool g_disable_recv_pipe;
+static bool g_quickack;
+static uint32_t g_sock_buf_size;
+static uint8_t g_psk_key[SPDK_TLS_PSK_MAX_LEN];
+static uint32_t g_psk_key_size;
+static char *g_psk_identity;
+
+static struct spdk_app_opts g_opts = {};
+static uint64_t g_tsc_rate;
+static uint64_t g_tsc_end;
+static uint32_t g_recv_buf_size;
+static bool g_shutdown;
+static int g_rc;
+static struct spdk_thread *g_main_thread;
+static TAILQ_HEAD(, perf_worker) g_workers = TAILQ_HEAD_INITIALIZER(g_workers);
+static uint32_t g_num_workers;
+static uint32_t g_num_workers_done;
+static struct perf_worker *g_next_worker;
+static struct spdk_sock *g_listen_sock;
+static struct spdk_poller *g_accept_poller;
+
+static void
+usage(void)
+{
+	printf("sock_perf options:\n");
+	printf("\t[-S start in server mode]\n");
+	printf("\t[-H host address (default: 127.0.0.1)]\n");
+	printf("\t[-P port number (default: 12345)]\n");
+	printf("\t[-N socket implementation, e.g. posix, uring or ssl]\n");
+	printf("\t[-o message size in bytes (default: 4096), must be the same on both sides]\n");
+	printf("\t[-C connections per core (default: 1, client only)]\n");
+	printf("\t[-q messages in flight per connection (default: 1). The server needs at least\n");
+	printf("\t    as many to not limit the client]\n");
+	printf("\t[-t time in seconds (default: 10, client only)]\n");
+	printf("\t[-b size of the socket send and receive buffers]\n");
+	printf("\t[-D disable the receive pipe]\n");
+	printf("\t[-Q enable quick ACK]\n");
+	printf("\t[-z disable zero copy send (default)]\n");
+	printf("\t[-Z enable zero copy send]\n");
+	printf("\t[-k disable kTLS (default)]\n");
+	printf("\t[-K enable kTLS]\n");
+	printf("\t[-T TLS version, e.g. 12 or 13]\n");
+	printf("\t[-E PSK in hexadecimal digits, e.g. 1234567890ABCDEF (ssl only)]\n");
+	printf("\t[-I PSK identity, e.g. psk.spdk.io (ssl only)]\n");
+}
+
+static int
+parse_args(int ch, char *arg)
+{
+	char *unhexlified;
+	long val = 0;
+
+	switch (ch) {
+	case 'b':
+	case 'C':
+	case 'o':
+	case 'P':
+	case 'q':
+	case 't':
+	case 'T':
+		val = spdk_strtol(arg, 10);
+		if (val <= 0) {
+			fprintf(stderr, "Invalid value for -%c: %s\n", ch, arg);
+			return -EINVAL;
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch (ch) {
+	case 'b':
+		g_sock_buf_size = val;
+		break;
+	case 'C':
+		g_conns_per_core = val;
+		break;
+	case 'D':
+		g_disable_recv_pipe = true;
+		break;
+	case 'E':
+		g_psk_key_size = strlen(arg) / 2;
+		if (g_psk_key_size > SPDK_TLS_PSK_MAX_LEN) {
+			fprintf(stderr, "Invalid PSK: too long (%"PRIu32")\n", g_psk_key_size);
+			return -EINVAL;
+		}
+		unhexlified = spdk_unhexlify(arg);
+		if (unhexlified == NULL) {
+			fprintf(stderr, "Invalid PSK: not in a hex format\n");
+			return -EINVAL;
+		}
+		memcpy(g_psk_key, unhexlified, g_psk_key_size);
+		free(unhexlified);
+		break;
+	case 'H':
+		g_host = arg;
+		break;
+	case 'I':
+		g_psk_identity = arg;
+		break;
+	case 'k':
+		g_ktls = false;
+		break;
+	case 'K':
+		g_ktls = true;
+		break;
+	case 'N':
+		g_sock_impl_name = arg;
+		break;
+	case 'o':
+		g_msg_size = val;
+		break;
+	case 'P':
+		g_port = val;
+		break;
+	case 'q':
+		g_queue_depth = val;
+		break;
+	case 'Q':
+		g_quickack = true;
+		break;
+	case 'S':
+		g_is_server = true;
+		break;
+	case 't':
+		g_time_in_sec = val;
+		break;
+	case 'T':
+		g_tls_version = val;
+		break;
+	case 'z':
+		g_zcopy = false;
+		break;
+	case 'Z':
+		g_zcopy = true;
+		break;
+	default:
+		usage();
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+perf_get_sock_opts(struct spdk_sock_opts *opts, struct spdk_sock_impl_opts *impl_opts)
+{
+	size_t impl_opts_size = sizeof(*impl_opts);
+
+	spdk_sock_impl_get_opts(g_sock_impl_name, impl_opts, &impl_opts_size);
+	impl_opts->enable_recv_pipe = !g_disable_recv_pipe;
+	impl_opts->enable_quickack = g_quickack;
+	if (g_sock_buf_size != 0) {
+		impl_opts->recv_buf_size = g_sock_buf_size;
+		impl_opts->send_buf_size = g_sock_buf_size;
+	}
+	impl_opts->enable_ktls = g_ktls;
+	impl_opts->tls_version = g_tls_version;
+	impl_opts->tls_cipher_suites = "TLS_AES_128_GCM_SHA256";
+	impl_opts->psk_identity = g_psk_identity;
+	impl_opts->psk_key = g_psk_key;
+	impl_opts->psk_key_size = g_psk_key_size;
+
+	opts->opts_size = sizeof(*opts);
+	spdk_sock_get_default_opts(opts);
+	opts->zcopy = g_zcopy;
+	opts->impl_opts = impl_opts;
+	opts->impl_opts_size = sizeof(*impl_opts);
+}
+
+/* Statistics */
+
+struct latency_percentile {
+	double		percentile;
+	uint64_t	value;
+};
+
+static void
+get_percentile_latency(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		       uint64_t total, uint64_t so_far)
+{
+	struct latency_percentile *latency_percentile = ctx;
+
+	if (count == 0 || latency_percentile->value != 0) {
+		return;
+	}
+
+	if ((double)so_far / total >= latency_percentile->percentile) {
+		latency_percentile->value = end;
+	}
+}
+
+static double
+tsc_to_us(uint64_t tsc)
+{
+	return (double)tsc * SPDK_SEC_TO_USEC / g_tsc_rate;
+}
+
+static double
+get_histogram_percentile_us(struct spdk_histogram_data *histogram, double percentile)
+{
+	struct latency_percentile latency_percentile = { .percentile = percentile };
+
+	spdk_histogram_data_iterate(histogram, get_percentile_latency, &latency_percentile);
+
+	return tsc_to_us(latency_percentile.value);
+}
+
+static void
+print_worker_stats(const char *core, const struct perf_worker *worker, uint64_t elapsed_tsc)
+{
+	double seconds = (double)spdk_max(elapsed_tsc, 1) / g_tsc_rate;
+	double msgs = spdk_max(worker->num_msgs, 1);
+
+	if (g_is_server) {
+		printf("%-6s %6u %12"PRIu64" %12.2f %12.2f %12"PRIu64"\n", core, worker->num_conns,
+		       worker->num_msgs, worker->stats.send_calls / msgs,
+		       worker->stats.recv_calls / msgs, worker->stats.zcopy_notifications);
+		return;
+	}
+
+	printf("%-6s %6u %12.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", core,
+	       worker->num_conns, worker->num_msgs / seconds,
+	       worker->num_msgs * g_msg_size / seconds / (1024 * 1024),
+	       worker->num_msgs ? tsc_to_us(worker->total_tsc) / worker->num_msgs : 0,
+	       get_histogram_percentile_us(worker->histogram, 0.5),
+	       get_histogram_percentile_us(worker->histogram, 0.99),
+	       get_histogram_percentile_us(worker->histogram, 0.999),
+	       tsc_to_us(worker->max_tsc), worker->stats.send_calls / msgs,
+	       worker->stats.recv_calls / msgs);
+}
+
+static void
+print_stats(void)
+{
+	struct perf_worker *worker, total = {};
+	uint64_t start_tsc = UINT64_MAX, end_tsc = 0;
+	char core[16];
+
+	total.histogram = spdk_histogram_data_alloc();
+	if (total.histogram == NULL) {
+		fprintf(stderr, "Unable to allocate latency histogram\n");
+		return;
+	}
+
+	printf("\n%s on %s:%d with sock_impl %s, %u B messages, %u in flight per connection\n",
+	       g_is_server ? "Server" : "Client", g_host, g_port, g_sock_impl_name, g_msg_size,
+	       g_queue_depth);
+	if (g_is_server) {
+		printf("%-6s %6s %12s %12s %12s %12s\n", "Core", "Conns", "Msgs", "Sends/msg",
+		       "Recvs/msg", "Zcopy notif");
+	} else {
+		printf("%-6s %6s %12s %10s %10s %10s %10s %10s %10s %10s %10s\n", "Core", "Conns",
+		       "Msgs/s", "MiB/s", "Avg us", "p50 us", "p99 us", "p99.9 us", "Max us",
+		       "Sends/msg", "Recvs/msg");
+	}
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		snprintf(core, sizeof(core), "%u", worker->core);
+		print_worker_stats(core, worker, worker->end_tsc - worker->start_tsc);
+
+		total.num_conns += worker->num_conns;
+		total.num_msgs += worker->num_msgs;
+		total.total_tsc += worker->total_tsc;
+		total.max_tsc = spdk_max(total.max_tsc, worker->max_tsc);
+		total.stats.send_calls += worker->stats.send_calls;
+		total.stats.recv_calls += worker->stats.recv_calls;
+		total.stats.zcopy_notifications += worker->stats.zcopy_notifications;
+		spdk_histogram_data_merge(total.histogram, worker->histogram);
+		start_tsc = spdk_min(start_tsc, worker->start_tsc);
+		end_tsc = spdk_max(end_tsc, worker->end_tsc);
+	}
+
+	if (g_num_workers > 1) {
+		print_worker_stats("total", &total, end_tsc - start_tsc);
+	}
+	fflush(stdout);
+
+	spdk_histogram_data_free(total.histogram);
+}
+
+/* Connections */
+
+static void client_write_complete(void *cb_arg, int err);
+static void server_write_complete(void *cb_arg, int err);
+
+static void
+conn_close(struct perf_conn *conn)
+{
+	if (conn->in_group) {
+		spdk_sock_group_remove_sock(conn->worker->group, conn->sock);
+		conn->in_group = false;
+	}
+
+	/* Any write still queued completes with an error here */
+	spdk_sock_close(&conn->sock);
+}
+
+static void
+conn_free(struct perf_conn *conn)
+{
+	uint32_t i;
+
+	if (conn->reqs != NULL && g_is_server) {
+		for (i = 0; i < g_queue_depth; i++) {
+			free(conn->reqs[i].buf);
+		}
+	}
+	free(conn->reqs);
+	free(conn);
+}
+
+static struct perf_conn *
+conn_alloc(struct spdk_sock *sock)
+{
+	struct perf_conn *conn;
+	struct perf_req *req;
+	uint32_t i;
+
+	conn = calloc(1, sizeof(*conn));
+	if (conn == NULL) {
+		return NULL;
+	}
+
+	conn->sock = sock;
+	TAILQ_INIT(&conn->inflight);
+	conn->reqs = calloc(g_queue_depth, sizeof(*conn->reqs));
+	if (conn->reqs == NULL) {
+		conn_free(conn);
+		return NULL;
+	}
+
+	for (i = 0; i < g_queue_depth; i++) {
+		req = &conn->reqs[i];
+		req->conn = conn;
+		req->write_done = true;
+		req->echo_done = true;
+		req->sock_req.cb_fn = g_is_server ? server_write_complete : client_write_complete;
+		req->sock_req.cb_arg = req;
+		req->sock_req.iovcnt = 1;
+		req->iov.iov_len = g_msg_size;
+		if (g_is_server) {
+			req->buf = malloc(g_msg_size);
+			if (req->buf == NULL) {
+				conn_free(conn);
+				return NULL;
+			}
+			req->iov.iov_base = req->buf;
+		}
+	}
+
+	return conn;
+}
+
+/* Client */
+
+static void
+client_submit(struct perf_req *req)
+{
+	struct perf_conn *conn = req->conn;
+
+	req->write_done = false;
+	req->echo_done = false;
+	req->submit_tsc = spdk_get_ticks();
+	TAILQ_INSERT_TAIL(&conn->inflight, req, link);
+	conn->outstanding++;
+	spdk_sock_writev_async(conn->sock, &req->sock_req);
+}
+
+/* A message is sent again once its write completed and its echo was received */
+static void
+client_req_done(struct perf_req *req)
+{
+	struct perf_conn *conn = req->conn;
+
+	if (!req->write_done || !req->echo_done) {
+		return;
+	}
+
+	conn->outstanding--;
+	if (!conn->worker->stopping && !conn->failed) {
+		client_submit(req);
+	}
+}
+
+static void
+client_conn_fail(struct perf_conn *conn, const char *msg)
+{
+	struct perf_req *req;
+
+	if (conn->failed) {
+		return;
+	}
+
+	if (!conn->worker->stopping) {
+		fprintf(stderr, "Connection on core %u failed: %s\n", conn->worker->core, msg);
+		g_rc = -EIO;
+	}
+
+	conn->failed = true;
+	if (conn->in_group) {
+		spdk_sock_group_remove_sock(conn->worker->group, conn->sock);
+		conn->in_group = false;
+	}
+
+	/* The echoes won't come anymore */
+	while ((req = TAILQ_FIRST(&conn->inflight)) != NULL) {
+		TAILQ_REMOVE(&conn->inflight, req, link);
+		req->echo_done = true;
+		client_req_done(req);
+	}
+}
+
+static void
+client_write_complete(void *cb_arg, int err)
+{
+	struct perf_req *req = cb_arg;
+
+	if (err != 0) {
+		client_conn_fail(req->conn, spdk_strerror(-err));
+	}
+
+	req->write_done = true;
+	client_req_done(req);
+}
+
+static void
+client_conn_recv(void *ctx, struct spdk_sock_group *group, struct spdk_sock *sock)
+{
+	struct perf_conn *conn = ctx;
+	struct perf_worker *worker = conn->worker;
+	struct perf_req *req;
+	uint64_t now, tsc;
+	ssize_t rc;
+
+	rc = spdk_sock_recv(sock, worker->recv_buf, g_recv_buf_size);
+	if (rc <= 0) {
+		if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return;
+		}
+		client_conn_fail(conn, rc == 0 ? "closed by the server" : spdk_strerror(errno));
+		return;
+	}
+
+	now = spdk_get_ticks();
+	conn->recv_offset += rc;
+	while (conn->recv_offset >= g_msg_size) {
+		conn->recv_offset -= g_msg_size;
+		req = TAILQ_FIRST(&conn->inflight);
+		if (req == NULL) {
+			client_conn_fail(conn, "received more data than was sent");
+			return;
+		}
+
+		TAILQ_REMOVE(&conn->inflight, req, link);
+		tsc = now - req->submit_tsc;
+		worker->num_msgs++;
+		worker->total_tsc += tsc;
+		worker->max_tsc = spdk_max(worker->max_tsc, tsc);
+		spdk_histogram_data_tally(worker->histogram, tsc);
+
+		req->echo_done = true;
+		client_req_done(req);
+	}
+}
+
+static int
+client_connect(struct perf_worker *worker)
+{
+	struct spdk_sock_impl_opts impl_opts;
+	struct spdk_sock_opts opts;
+	struct spdk_sock *sock;
+	struct perf_conn *conn;
+	uint32_t i, j;
+	int rc;
+
+	perf_get_sock_opts(&opts, &impl_opts);
+	for (i = 0; i < g_conns_per_core; i++) {
+		sock = spdk_sock_connect_ext(g_host, g_port, g_sock_impl_name, &opts);
+		if (sock == NULL) {
+			fprintf(stderr, "Failed to connect to %s:%d: %s\n", g_host, g_port,
+				spdk_strerror(errno));
+			return -errno;
+		}
+
+		conn = conn_alloc(sock);
+		if (conn == NULL) {
+			spdk_sock_close(&sock);
+			return -ENOMEM;
+		}
+
+		conn->worker = worker;
+		for (j = 0; j < g_queue_depth; j++) {
+			conn->reqs[j].iov.iov_base = worker->send_buf;
+		}
+		TAILQ_INSERT_TAIL(&worker->conns, conn, link);
+		worker->num_conns++;
+
+		rc = spdk_sock_group_add_sock(worker->group, sock, client_conn_recv, conn);
+		if (rc != 0) {
+			fprintf(stderr, "Failed to add a connection to the sock group\n");
+			return rc;
+		}
+		conn->in_group = true;
+	}
+
+	return 0;
+}
+
+/* Server */
+
+static void
+server_write_complete(void *cb_arg, int err)
+{
+	struct perf_req *req = cb_arg;
+
+	req->write_done = true;
+	req->conn->outstanding--;
+}
+
+static void
+server_conn_recv(void *ctx, struct spdk_sock_group *group, struct spdk_sock *sock)
+{
+	struct perf_conn *conn = ctx;
+	struct perf_worker *worker = conn->worker;
+	struct perf_req *req;
+	ssize_t rc;
+
+	while (true) {
+		req = &conn->reqs[conn->recv_index];
+		if (!req->write_done) {
+			conn->recv_blocked = true;
+			return;
+		}
+
+		rc = spdk_sock_recv(sock, (uint8_t *)req->buf + conn->recv_offset,
+				    g_msg_size - conn->recv_offset);
+		if (rc <= 0) {
+			if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				return;
+			}
+
+			/* The client is gone */
+			TAILQ_REMOVE(&worker->conns, conn, link);
+			conn_close(conn);
+			conn_free(conn);
+			return;
+		}
+
+		conn->recv_offset += rc;
+		if (conn->recv_offset < g_msg_size) {
+			continue;
+		}
+
+		conn->recv_offset = 0;
+		conn->recv_index = (conn->recv_index + 1) % g_queue_depth;
+		worker->num_msgs++;
+		req->write_done = false;
+		conn->outstanding++;
+		spdk_sock_writev_async(sock, &req->sock_req);
+	}
+}
+
+static void
+server_add_conn(void *ctx)
+{
+	struct perf_conn *conn = ctx;
+	struct perf_worker *worker = conn->worker;
+	int rc;
+
+	TAILQ_INSERT_TAIL(&worker->conns, conn, link);
+	worker->num_conns++;
+	if (worker->start_tsc == 0) {
+		worker->start_tsc = spdk_get_ticks();
+	}
+
+	rc = spdk_sock_group_add_sock(worker->group, conn->sock, server_conn_recv, conn);
+	if (rc != 0) {
+		fprintf(stderr, "Failed to add a connection to the sock group\n");
+		TAILQ_REMOVE(&worker->conns, conn, link);
+		conn_close(conn);
+		conn_free(conn);
+		return;
+	}
+	conn->in_group = true;
+}
+
+static int
+server_accept_poll(void *arg)
+{
+	struct perf_conn *conn;
+	struct spdk_sock *sock;
+	int count = 0;
+
+	while ((sock = spdk_sock_accept(g_listen_sock)) != NULL) {
+		conn = conn_alloc(sock);
+		if (conn == NULL) {
+			fprintf(stderr, "Unable to allocate a connection\n");
+			spdk_sock_close(&sock);
+			continue;
+		}
+
+		/* The connections are spread over the cores in turn */
+		conn->worker = g_next_worker;
+		g_next_worker = TAILQ_NEXT(g_next_worker, link);
+		if (g_next_worker == NULL) {
+			g_next_worker = TAILQ_FIRST(&g_workers);
+		}
+
+		spdk_thread_send_msg(conn->worker->thread, server_add_conn, conn);
+		count++;
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static int
+server_listen(void)
+{
+	struct spdk_sock_impl_opts impl_opts;
+	struct spdk_sock_opts opts;
+
+	perf_get_sock_opts(&opts, &impl_opts);
+	g_listen_sock = spdk_sock_listen_ext(g_host, g_port, g_sock_impl_name, &opts);
+	if (g_listen_sock == NULL) {
+		fprintf(stderr, "Failed to listen on %s:%d: %s\n", g_host, g_port,
+			spdk_strerror(errno));
+		return -errno;
+	}
+
+	g_next_worker = TAILQ_FIRST(&g_workers);
+	g_accept_poller = SPDK_POLLER_REGISTER(server_accept_poll, NULL, ACCEPT_POLL_PERIOD_US);
+	printf("Listening on %s:%d with sock_impl %s\n", g_host, g_port, g_sock_impl_name);
+	fflush(stdout);
+
+	return 0;
+}
+
+/* Workers */
+
+static void
+worker_exited(void *ctx)
+{
+	if (++g_num_workers_done < g_num_workers) {
+		return;
+	}
+
+	print_stats();
+	spdk_app_stop(g_rc);
+}
+
+static void
+worker_exit(void *ctx)
+{
+	struct perf_worker *worker = ctx;
+	struct perf_conn *conn;
+
+	if (worker->end_tsc == 0) {
+		worker->end_tsc = spdk_get_ticks();
+	}
+
+	if (worker->group != NULL) {
+		spdk_sock_group_get_stats(worker->group, &worker->stats);
+	}
+
+	while ((conn = TAILQ_FIRST(&worker->conns)) != NULL) {
+		TAILQ_REMOVE(&worker->conns, conn, link);
+		conn_close(conn);
+		conn_free(conn);
+	}
+
+	spdk_poller_unregister(&worker->poller);
+	spdk_sock_group_close(&worker->group);
+	spdk_thread_exit(worker->thread);
+	spdk_thread_send_msg(g_main_thread, worker_exited, NULL);
+}
+
+static bool
+client_drained(struct perf_worker *worker)
+{
+	struct perf_conn *conn;
+
+	TAILQ_FOREACH(conn, &worker->conns, link) {
+		if (conn->outstanding > 0 && !conn->failed) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+server_resume_recv(struct perf_worker *worker)
+{
+	struct perf_conn *conn, *tmp;
+	int count = 0;
+
+	/* Not done from the write completions, as the connection may get closed while reading */
+	TAILQ_FOREACH_SAFE(conn, &worker->conns, link, tmp) {
+		if (conn->recv_blocked && conn->reqs[conn->recv_index].write_done) {
+			conn->recv_blocked = false;
+			server_conn_recv(conn, worker->group, conn->sock);
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static int
+worker_poll(void *arg)
+{
+	struct perf_worker *worker = arg;
+	int rc;
+
+	rc = spdk_sock_group_poll(worker->group);
+	if (rc < 0) {
+		fprintf(stderr, "Failed to poll the sock group of core %u\n", worker->core);
+	}
+
+	if (g_is_server) {
+		rc += server_resume_recv(worker);
+		return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+	}
+
+	if (!worker->stopping && (g_shutdown || spdk_get_ticks() >= g_tsc_end)) {
+		worker->stopping = true;
+	}
+
+	/* Let the messages in flight complete before closing the connections */
+	if (worker->stopping && client_drained(worker)) {
+		worker->end_tsc = spdk_get_ticks();
+		spdk_poller_unregister(&worker->poller);
+		worker_exit(worker);
+		return SPDK_POLLER_BUSY;
+	}
+
+	return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+worker_run(void *ctx)
+{
+	struct perf_worker *worker = ctx;
+	struct perf_conn *conn;
+	uint32_t i;
+
+	worker->start_tsc = spdk_get_ticks();
+	TAILQ_FOREACH(conn, &worker->conns, link) {
+		for (i = 0; i < g_queue_depth; i++) {
+			client_submit(&conn->reqs[i]);
+		}
+	}
+}
+
+static void
+worker_started(void *ctx)
+{
+	struct perf_worker *worker;
+
+	if (++g_num_workers_done < g_num_workers) {
+		return;
+	}
+
+	g_num_workers_done = 0;
+	if (g_rc != 0) {
+		TAILQ_FOREACH(worker, &g_workers, link) {
+			spdk_thread_send_msg(worker->thread, worker_exit, worker);
+		}
+		return;
+	}
+
+	if (g_is_server) {
+		g_rc = server_listen();
+		if (g_rc != 0) {
+			spdk_app_start_shutdown();
+		}
+		return;
+	}
+
+	printf("Running for %d seconds...\n", g_time_in_sec);
+	fflush(stdout);
+	g_tsc_end = spdk_get_ticks() + g_time_in_sec * g_tsc_rate;
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		spdk_thread_send_msg(worker->thread, worker_run, worker);
+	}
+}
+
+static void
+worker_start(void *ctx)
+{
+	struct perf_worker *worker = ctx;
+	int rc = 0;
+
+	worker->group = spdk_sock_group_create(NULL);
+	worker->histogram = spdk_histogram_data_alloc();
+	worker->send_buf = calloc(1, g_msg_size);
+	worker->recv_buf = malloc(g_recv_buf_size);
+	if (worker->group == NULL || worker->histogram == NULL || worker->send_buf == NULL ||
+	    worker->recv_buf == NULL) {
+		fprintf(stderr, "Unable to allocate the resources of core %u\n", worker->core);
+		rc = -ENOMEM;
+	} else if (!g_is_server) {
+		rc = client_connect(worker);
+	}
+
+	if (rc != 0) {
+		g_rc = rc;
+	} else {
+		worker->poller = SPDK_POLLER_REGISTER(worker_poll, worker, 0);
+	}
+
+	spdk_thread_send_msg(g_main_thread, worker_started, NULL);
+}
+
+static void
+sock_perf_start(void *arg)
+{
+	struct spdk_cpuset cpumask;
+	struct perf_worker *worker;
+	char thread_name[32];
+	uint32_t i;
+
+	g_main_thread = spdk_get_thread();
+	g_tsc_rate = spdk_get_ticks_hz();
+	g_recv_buf_size = spdk_max(g_msg_size, spdk_min((uint64_t)g_msg_size * g_queue_depth,
+				   MAX_RECV_BUF_SIZE));
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		worker = calloc(1, sizeof(*worker));
+		if (worker == NULL) {
+			fprintf(stderr, "Unable to allocate memory\n");
+			break;
+		}
+
+		worker->core = i;
+		TAILQ_INIT(&worker->conns);
+		snprintf(thread_name, sizeof(thread_name), "sock_perf_%u", i);
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, i, true);
+		worker->thread = spdk_thread_create(thread_name, &cpumask);
+		if (worker->thread == NULL) {
+			fprintf(stderr, "Unable to create a thread on core %u\n", i);
+			free(worker);
+			break;
+		}
+
+		TAILQ_INSERT_TAIL(&g_workers, worker, link);
+		g_num_workers++;
+	}
+
+	if (g_num_workers == 0) {
+		spdk_app_stop(-ENOMEM);
+		return;
+	}
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		spdk_thread_send_msg(worker->thread, worker_start, worker);
+	}
+}
+
+static void
+sock_perf_shutdown_cb(void)
+{
+	struct perf_worker *worker;
+
+	/* The clients stop on their own once they see it */
+	g_shutdown = true;
+	if (!g_is_server) {
+		return;
+	}
+
+	spdk_poller_unregister(&g_accept_poller);
+	spdk_sock_close(&g_listen_sock);
+	g_num_workers_done = 0;
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		spdk_thread_send_msg(worker->thread, worker_exit, worker);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	struct perf_worker *worker, *tmp;
+	int rc;
+
+	spdk_app_opts_init(&g_opts, sizeof(g_opts));
+	g_opts.name = "sock_perf";
+	g_opts.reactor_mask = "0x1";
+	g_opts.shutdown_cb = sock_perf_shutdown_cb;
+	rc = spdk_app_parse_args(argc, argv, &g_opts, "b:C:DE:H:I:kKN:o:P:q:QSt:T:zZ", NULL,
+				 parse_args, usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc == SPDK_APP_PARSE_ARGS_HELP ? 0 : 1;
+	}
+
+	if (g_sock_impl_name == NULL) {
+		g_sock_impl_name = spdk_sock_get_default_impl();
+		if (g_sock_impl_name == NULL) {
+			fprintf(stderr, "No sock implementations available\n");
+			return 1;
+		}
+	}
+
+	rc = spdk_app_start(&g_opts, sock_perf_start, NULL);
+	if (rc != 0) {
+		fprintf(stderr, "sock_perf failed: %s\n", spdk_strerror(abs(rc)));
+	}
+
+	TAILQ_FOREACH_SAFE(worker, &g_workers, link, tmp) {
+		spdk_histogram_data_free(worker->histogram);
+		free(worker->send_buf);
+		free(worker->recv_buf);
+		free(worker);
+	}
+
+	spdk_app_fini();
+	return rc;
+}
@@ -0,0 +1,623 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/config.h"
+#include "spdk/base64.h"
+#include "spdk/bit_array.h"
+#include "spdk/crc16.h"
+#include "spdk/crc32.h"
+#include "spdk/crc64.h"
+#include "spdk/dif.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/xor.h"
+
+/*
+ * Measures the ns/op and GB/s of the lib/util kernels for a range of buffer sizes and
+ * alignments.  The implementation of each kernel is picked when SPDK is built, so the variant
+ * column names the one compiled in (ISA-L, SIMD or table driven).  Where a kernel has a portable
+ * fallback it is measured too, from a plain scalar implementation next to the library one.
+ */
+
+#ifdef SPDK_CONFIG_ISAL
+#define CRC32C_VARIANT	"isal"
+#define CRC16_VARIANT	"isal"
+#define XOR_VARIANT	"isal"
+#else
+#if defined(__x86_64__) && defined(__SSE4_2__)
+#define CRC32C_VARIANT	"sse4.2"
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32C_VARIANT	"armcrc"
+#else
+#define CRC32C_VARIANT	"table"
+#endif
+#define CRC16_VARIANT	"table"
+#if defined(__AVX512F__)
+#define XOR_VARIANT	"avx512"
+#elif defined(__AVX2__)
+#define XOR_VARIANT	"avx2"
+#else
+#define XOR_VARIANT	"vec64"
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32_VARIANT	"armcrc"
+#else
+#define CRC32_VARIANT	"table"
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+#define BASE64_VARIANT	"sve"
+#elif defined(__aarch64__)
+#define BASE64_VARIANT	"neon"
+#else
+#define BASE64_VARIANT	"scalar"
+#endif
+
+#define BUF_ALIGN		64
+#define NUM_SOURCES		4
+#define DIF_DATA_BLOCK_SIZE	512
+#define MAX_LIST_ENTRIES	32
+
+#define CRC32C_POLY_REFLECT	0x82f63b78u
+#define CRC16_T10DIF_POLY	0x8bb7u
+
+static const size_t g_default_sizes[] = { 64, 512, 4096, 65536, 1048576 };
+static const size_t g_default_aligns[] = { 0, 1 };
+
+static size_t g_sizes[MAX_LIST_ENTRIES];
+static int g_num_sizes;
+static size_t g_aligns[MAX_LIST_ENTRIES];
+static int g_num_aligns;
+static uint64_t g_time_in_nsec = 100 * (SPDK_SEC_TO_NSEC / 1000);
+static const char *g_filter;
+
+/* Buffers of the current case, offset by its alignment */
+static uint8_t *g_base_src[NUM_SOURCES];
+static uint8_t *g_base_dst;
+static uint8_t *g_base_enc;
+static uint8_t *g_src[NUM_SOURCES];
+static uint8_t *g_dst;
+static char *g_enc;
+static size_t g_len;
+
+static struct spdk_dif_ctx g_dif_ctx;
+static struct spdk_bit_array *g_bit_array;
+static uint32_t g_crc32c_table[256];
+static uint16_t g_crc16_table[256];
+static volatile uint64_t g_sink;
+
+struct perf_kernel {
+	const char	*name;
+	const char	*variant;
+	/* Number of g_len sized buffers processed by each run */
+	int		num_bufs;
+	int		(*prepare)(void);
+	void		(*run)(void);
+	void		(*cleanup)(void);
+};
+
+static uint64_t
+get_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * SPDK_SEC_TO_NSEC + ts.tv_nsec;
+}
+
+static void
+scalar_init(void)
+{
+	uint32_t crc32;
+	uint16_t crc16;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc32 = i;
+		crc16 = i << 8;
+		for (j = 0; j < 8; j++) {
+			crc32 = (crc32 >> 1) ^ ((crc32 & 1) ? CRC32C_POLY_REFLECT : 0);
+			crc16 = (crc16 << 1) ^ ((crc16 & 0x8000) ? CRC16_T10DIF_POLY : 0);
+		}
+		g_crc32c_table[i] = crc32;
+		g_crc16_table[i] = crc16;
+	}
+}
+
+static uint32_t
+scalar_crc32c(const uint8_t *buf, size_t len, uint32_t crc)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		crc = (crc >> 8) ^ g_crc32c_table[(crc ^ buf[i]) & 0xff];
+	}
+
+	return crc;
+}
+
+static uint16_t
+scalar_crc16(const uint8_t *buf, size_t len, uint16_t crc)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		crc = (crc << 8) ^ g_crc16_table[((crc >> 8) ^ buf[i]) & 0xff];
+	}
+
+	return crc;
+}
+
+static void
+scalar_xor(uint8_t *dst, uint8_t **srcs, int n, size_t len)
+{
+	uint64_t w, v;
+	size_t off;
+	int i;
+
+	for (off = 0; off + sizeof(w) <= len; off += sizeof(w)) {
+		memcpy(&w, srcs[0] + off, sizeof(w));
+		for (i = 1; i < n; i++) {
+			memcpy(&v, srcs[i] + off, sizeof(v));
+			w ^= v;
+		}
+		memcpy(dst + off, &w, sizeof(w));
+	}
+
+	for (; off < len; off++) {
+		dst[off] = srcs[0][off];
+		for (i = 1; i < n; i++) {
+			dst[off] ^= srcs[i][off];
+		}
+	}
+}
+
+static void
+run_crc32c(void)
+{
+	g_sink += spdk_crc32c_update(g_src[0], g_len, ~0U);
+}
+
+static void
+run_crc32c_scalar(void)
+{
+	g_sink += scalar_crc32c(g_src[0], g_len, ~0U);
+}
+
+static void
+run_crc32c_multi(void)
+{
+	const void *bufs[NUM_SOURCES];
+	size_t lens[NUM_SOURCES];
+	uint32_t crcs[NUM_SOURCES];
+	int i;
+
+	for (i = 0; i < NUM_SOURCES; i++) {
+		bufs[i] = g_src[i];
+		lens[i] = g_len;
+		crcs[i] = ~0U;
+	}
+
+	spdk_crc32c_update_multi(bufs, lens, crcs, NUM_SOURCES);
+	g_sink += crcs[0];
+}
+
+static void
+run_crc32_ieee(void)
+{
+	g_sink += spdk_crc32_ieee_update(g_src[0], g_len, ~0U);
+}
+
+static void
+run_crc16(void)
+{
+	g_sink += spdk_crc16_t10dif(0, g_src[0], g_len);
+}
+
+static void
+run_crc16_scalar(void)
+{
+	g_sink += scalar_crc16(g_src[0], g_len, 0);
+}
+
+static void
+run_crc16_copy(void)
+{
+	g_sink += spdk_crc16_t10dif_copy(0, g_dst, g_src[0], g_len);
+}
+
+static void
+run_crc64(void)
+{
+	g_sink += spdk_crc64_nvme(g_src[0], g_len, 0);
+}
+
+static void
+run_xor(void)
+{
+	spdk_xor_gen(g_dst, (void **)g_src, NUM_SOURCES, g_len);
+}
+
+static void
+run_xor_scalar(void)
+{
+	scalar_xor(g_dst, g_src, NUM_SOURCES, g_len);
+}
+
+static void
+run_pq(void)
+{
+	spdk_xor_gen_pq(g_dst, g_dst + g_len, (void **)g_src, NUM_SOURCES, g_len);
+}
+
+static void
+run_base64_encode(void)
+{
+	spdk_base64_encode((char *)g_dst, g_src[0], g_len);
+}
+
+static int
+prepare_base64_decode(void)
+{
+	return spdk_base64_encode(g_enc, g_src[0], g_len);
+}
+
+static void
+run_base64_decode(void)
+{
+	size_t len;
+
+	spdk_base64_decode(g_dst, &len, g_enc);
+	g_sink += len;
+}
+
+static int
+prepare_bit_array(void)
+{
+	uint32_t i, num_bits = g_len * 8;
+
+	g_bit_array = spdk_bit_array_create(num_bits);
+	if (g_bit_array == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Every other bit is set, so that the whole array is scanned bit by bit */
+	for (i = 0; i < num_bits; i += 2) {
+		spdk_bit_array_set(g_bit_array, i);
+	}
+
+	return 0;
+}
+
+static void
+run_bit_array_count(void)
+{
+	g_sink += spdk_bit_array_count_set(g_bit_array);
+}
+
+static void
+cleanup_bit_array(void)
+{
+	spdk_bit_array_free(&g_bit_array);
+}
+
+static int
+prepare_dif(enum spdk_dif_pi_format pi_format, uint32_t md_size)
+{
+	struct spdk_dif_ctx_init_ext_opts opts = {};
+
+	if (g_len < DIF_DATA_BLOCK_SIZE) {
+		return -ENOTSUP;
+	}
+
+	opts.size = SPDK_SIZEOF(&opts, dif_pi_format);
+	opts.dif_pi_format = pi_format;
+
+	return spdk_dif_ctx_init(&g_dif_ctx, DIF_DATA_BLOCK_SIZE + md_size, md_size, true, false,
+				 SPDK_DIF_TYPE1,
+				 SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_REFTAG_CHECK,
+				 0, 0, 0, 0, 0, &opts);
+}
+
+static int
+prepare_dif16(void)
+{
+	return prepare_dif(SPDK_DIF_PI_FORMAT_16, 8);
+}
+
+static int
+prepare_dif32(void)
+{
+	return prepare_dif(SPDK_DIF_PI_FORMAT_32, 16);
+}
+
+static void
+run_dif_generate(void)
+{
+	struct iovec iov;
+	uint32_t num_blocks = g_len / DIF_DATA_BLOCK_SIZE;
+
+	iov.iov_base = g_dst;
+	iov.iov_len = num_blocks * g_dif_ctx.block_size;
+
+	spdk_dif_generate(&iov, 1, num_blocks, &g_dif_ctx);
+}
+
+static int
+prepare_dif16_verify(void)
+{
+	int rc;
+
+	rc = prepare_dif16();
+	if (rc == 0) {
+		run_dif_generate();
+	}
+
+	return rc;
+}
+
+static void
+run_dif_verify(void)
+{
+	struct spdk_dif_error err_blk;
+	struct iovec iov;
+	uint32_t num_blocks = g_len / DIF_DATA_BLOCK_SIZE;
+	int rc;
+
+	iov.iov_base = g_dst;
+	iov.iov_len = num_blocks * g_dif_ctx.block_size;
+
+	rc = spdk_dif_verify(&iov, 1, num_blocks, &g_dif_ctx, &err_blk);
+	assert(rc == 0);
+	g_sink += rc;
+}
+
+static const struct perf_kernel g_kernels[] = {
+	{ "crc32c", CRC32C_VARIANT, 1, NULL, run_crc32c },
+	{ "crc32c", "scalar", 1, NULL, run_crc32c_scalar },
+	{ "crc32c_multi", CRC32C_VARIANT, NUM_SOURCES, NULL, run_crc32c_multi },
+	{ "crc32_ieee", CRC32_VARIANT, 1, NULL, run_crc32_ieee },
+	{ "crc16_t10dif", CRC16_VARIANT, 1, NULL, run_crc16 },
+	{ "crc16_t10dif", "scalar", 1, NULL, run_crc16_scalar },
+	{ "crc16_t10dif_copy", CRC16_VARIANT, 1, NULL, run_crc16_copy },
+	{ "crc64_nvme", "table", 1, NULL, run_crc64 },
+	{ "xor_gen", XOR_VARIANT, NUM_SOURCES, NULL, run_xor },
+	{ "xor_gen", "scalar", NUM_SOURCES, NULL, run_xor_scalar },
+	{ "xor_gen_pq", XOR_VARIANT, NUM_SOURCES, NULL, run_pq },
+	{ "base64_encode", BASE64_VARIANT, 1, NULL, run_base64_encode },
+	{ "base64_decode", BASE64_VARIANT, 1, prepare_base64_decode, run_base64_decode },
+	{
+		"bit_array_count", "scalar", 1, prepare_bit_array, run_bit_array_count,
+		cleanup_bit_array
+	},
+	{ "dif_generate_pi16", CRC16_VARIANT, 1, prepare_dif16, run_dif_generate },
+	{ "dif_verify_pi16", CRC16_VARIANT, 1, prepare_dif16_verify, run_dif_verify },
+	{ "dif_generate_pi32", CRC32C_VARIANT, 1, prepare_dif32, run_dif_generate },
+};
+
+/* Check the scalar baselines against the library before timing them */
+static int
+verify_scalar(void)
+{
+	uint8_t *srcs[NUM_SOURCES];
+	size_t len = 4096 + 3;
+	int i;
+
+	if (scalar_crc32c(g_base_src[0] + 1, len, ~0U) !=
+	    spdk_crc32c_update(g_base_src[0] + 1, len, ~0U)) {
+		fprintf(stderr, "crc32c scalar baseline mismatch\n");
+		return -EIO;
+	}
+
+	if (scalar_crc16(g_base_src[0] + 1, len, 0) !=
+	    spdk_crc16_t10dif(0, g_base_src[0] + 1, len)) {
+		fprintf(stderr, "crc16_t10dif scalar baseline mismatch\n");
+		return -EIO;
+	}
+
+	for (i = 0; i < NUM_SOURCES; i++) {
+		srcs[i] = g_base_src[i];
+	}
+
+	scalar_xor(g_base_enc, srcs, NUM_SOURCES, len);
+	spdk_xor_gen(g_base_dst, (void **)srcs, NUM_SOURCES, len);
+	if (memcmp(g_base_enc, g_base_dst, len) != 0) {
+		fprintf(stderr, "xor_gen scalar baseline mismatch\n");
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static void
+run_case(const struct perf_kernel *kernel, size_t len, size_t align)
+{
+	uint64_t start, elapsed, ops = 0, batch = 1, i;
+	int j, rc;
+
+	for (j = 0; j < NUM_SOURCES; j++) {
+		g_src[j] = g_base_src[j] + align;
+	}
+	g_dst = g_base_dst + align;
+	g_enc = (char *)g_base_enc + align;
+	g_len = len;
+
+	if (kernel->prepare != NULL) {
+		rc = kernel->prepare();
+		if (rc != 0) {
+			return;
+		}
+	}
+
+	/* Warm up the caches, then double the batch until the run time is reached */
+	kernel->run();
+
+	start = get_nsec();
+	do {
+		for (i = 0; i < batch; i++) {
+			kernel->run();
+		}
+		ops += batch;
+		batch *= 2;
+		elapsed = get_nsec() - start;
+	} while (elapsed < g_time_in_nsec);
+
+	if (kernel->cleanup != NULL) {
+		kernel->cleanup();
+	}
+
+	printf("%-20s %-8s %9zu %5zu %12.1f %9.2f\n", kernel->name, kernel->variant, len, align,
+	       (double)elapsed / ops, (double)ops * len * kernel->num_bufs / elapsed);
+}
+
+static int
+parse_list(char *arg, size_t *list, int *count)
+{
+	char *tok, *saveptr = NULL;
+	long val;
+
+	*count = 0;
+	for (tok = strtok_r(arg, ",", &saveptr); tok != NULL; tok = strtok_r(NULL, ",", &saveptr)) {
+		val = spdk_strtol(tok, 10);
+		if (val < 0 || *count == MAX_LIST_ENTRIES) {
+			return -EINVAL;
+		}
+		list[(*count)++] = val;
+	}
+
+	return *count > 0 ? 0 : -EINVAL;
+}
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("options:\n");
+	printf(" -a <list>              comma separated buffer alignment offsets in bytes"
+	       " (default: 0,1)\n");
+	printf(" -k <name>              only run the kernels whose name contains <name>\n");
+	printf(" -s <list>              comma separated buffer sizes in bytes"
+	       " (default: 64,512,4096,65536,1048576)\n");
+	printf(" -t <msec>              run time of each case in milliseconds (default: 100)\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	size_t max_size = 0, max_align = 0, size;
+	int i, j, k, op, rc = 0;
+	long val;
+
+	memcpy(g_sizes, g_default_sizes, sizeof(g_default_sizes));
+	g_num_sizes = SPDK_COUNTOF(g_default_sizes);
+	memcpy(g_aligns, g_default_aligns, sizeof(g_default_aligns));
+	g_num_aligns = SPDK_COUNTOF(g_default_aligns);
+
+	while ((op = getopt(argc, argv, "a:hk:s:t:")) != -1) {
+		switch (op) {
+		case 'a':
+			rc = parse_list(optarg, g_aligns, &g_num_aligns);
+			break;
+		case 'k':
+			g_filter = optarg;
+			break;
+		case 's':
+			rc = parse_list(optarg, g_sizes, &g_num_sizes);
+			break;
+		case 't':
+			val = spdk_strtol(optarg, 10);
+			if (val <= 0) {
+				rc = -EINVAL;
+				break;
+			}
+			g_time_in_nsec = val * (SPDK_SEC_TO_NSEC / 1000);
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+
+		if (rc != 0) {
+			fprintf(stderr, "Invalid value for the option %c\n", op);
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < g_num_sizes; i++) {
+		if (g_sizes[i] == 0 || g_sizes[i] > UINT32_MAX / 8) {
+			fprintf(stderr, "Invalid buffer size %zu\n", g_sizes[i]);
+			return 1;
+		}
+		max_size = spdk_max(max_size, g_sizes[i]);
+	}
+
+	for (i = 0; i < g_num_aligns; i++) {
+		max_align = spdk_max(max_align, g_aligns[i]);
+	}
+
+	/* The destination holds two parity buffers, an encoded string or DIF protected blocks */
+	size = spdk_max(2 * max_size, 4096 + 3) + max_align + BUF_ALIGN;
+	for (i = 0; i < NUM_SOURCES; i++) {
+		g_base_src[i] = aligned_alloc(BUF_ALIGN, SPDK_ALIGN_CEIL(size, BUF_ALIGN));
+	}
+	g_base_dst = aligned_alloc(BUF_ALIGN, SPDK_ALIGN_CEIL(size, BUF_ALIGN));
+	g_base_enc = aligned_alloc(BUF_ALIGN, SPDK_ALIGN_CEIL(size, BUF_ALIGN));
+
+	for (i = 0; i < NUM_SOURCES; i++) {
+		if (g_base_src[i] == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		for (j = 0; j < (int)size; j++) {
+			g_base_src[i][j] = rand();
+		}
+	}
+
+	if (g_base_dst == NULL || g_base_enc == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	scalar_init();
+	rc = verify_scalar();
+	if (rc != 0) {
+		goto out;
+	}
+
+	printf("%-20s %-8s %9s %5s %12s %9s\n", "Kernel", "Variant", "Size", "Align", "ns/op",
+	       "GB/s");
+
+	for (k = 0; k < (int)SPDK_COUNTOF(g_kernels); k++) {
+		if (g_filter != NULL && strstr(g_kernels[k].name, g_filter) == NULL) {
+			continue;
+		}
+
+		for (i = 0; i < g_num_sizes; i++) {
+			for (j = 0; j < g_num_aligns; j++) {
+				run_case(&g_kernels[k], g_sizes[i], g_aligns[j]);
+			}
+		}
+	}
+
+out:
+	if (rc == -ENOMEM) {
+		fprintf(stderr, "Failed to allocate the buffers\n");
+	}
+
+	for (i = 0; i < NUM_SOURCES; i++) {
+		free(g_base_src[i]);
+	}
+	free(g_base_dst);
+	free(g_base_enc);
+
+	return rc == 0 ? 0 : 1;
+}
@@ -24,6 +24,9 @@ extern "C" {
 /** Data Encryption Key identifier */
 struct spdk_accel_crypto_key;
 
+struct spdk_dif_ctx;
+struct spdk_dif_error;
+
 struct spdk_accel_crypto_key_create_param {
 	char *cipher;	/**< Cipher to be used for crypto operations */
 	char *hex_key;	/**< Hexlified key */
@@ -44,7 +47,13 @@ enum spdk_accel_opcode {
 	SPDK_ACCEL_OPC_ENCRYPT		= 8,
 	SPDK_ACCEL_OPC_DECRYPT		= 9,
 	SPDK_ACCEL_OPC_XOR		= 10,
-	SPDK_ACCEL_OPC_LAST		= 11,
+	SPDK_ACCEL_OPC_DIF_VERIFY	= 11,
+	SPDK_ACCEL_OPC_DIF_GENERATE	= 12,
+	SPDK_ACCEL_OPC_DIF_GENERATE_COPY	= 13,
+	/* Encryption followed by a crc32c of the encrypted data.  It isn't submitted directly,
+	 * but is the result of fusing an encrypt with a crc32c in a sequence. */
+	SPDK_ACCEL_OPC_ENCRYPT_CRC32C	= 14,
+	SPDK_ACCEL_OPC_LAST		= 15,
 };
 
 enum spdk_accel_cipher {
@@ -114,6 +123,19 @@ int spdk_accel_crypto_key_destroy(struct spdk_accel_crypto_key *key);
  */
 struct spdk_accel_crypto_key *spdk_accel_crypto_key_get(const char *name);
 
+/**
+ * Load the hardware state of a crypto key ahead of its first use.  Modules with a limited number
+ * of hardware key slots bind keys on first use and release the least recently used ones when
+ * running out of slots.  Prefetching a key, e.g. when a volume using it is opened, avoids paying
+ * the binding cost on the I/O path.  It's a no-op for modules binding their keys at creation.
+ *
+ * Must be called from an SPDK thread.
+ *
+ * \param key Key to prefetch.
+ * eturn 0 on success, negated errno on error.
+ */
+int spdk_accel_crypto_key_prefetch(struct spdk_accel_crypto_key *key);
+
 /**
  * Submit a copy request.
  *
@@ -321,6 +343,68 @@ int spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_i
 int spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
 			  uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Submit a DIF verify request.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array which stores the extended LBA payload (data and interleaved
+ * metadata) to verify.
+ * \param iovcnt The size of the io vectors.
+ * \param num_blocks Number of data blocks to verify.
+ * \param ctx DIF context. Must remain valid until the operation completes.
+ * \param err DIF error information, filled in when the verification fails.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_verify(struct spdk_io_channel *ch,
+				 struct iovec *iovs, size_t iovcnt, uint32_t num_blocks,
+				 const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err,
+				 spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a DIF generate request. The protection information is written in place into the
+ * metadata of each block.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array which stores the extended LBA payload.
+ * \param iovcnt The size of the io vectors.
+ * \param num_blocks Number of data blocks to generate the protection information for.
+ * \param ctx DIF context. Must remain valid until the operation completes.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_generate(struct spdk_io_channel *ch,
+				   struct iovec *iovs, size_t iovcnt, uint32_t num_blocks,
+				   const struct spdk_dif_ctx *ctx,
+				   spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a DIF generate and copy request. The data blocks are copied from the source to the
+ * destination buffer, which has room for the interleaved metadata, and the protection
+ * information is generated along the way.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param dst_iovs The io vector array which will store the extended LBA payload.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array which stores the data blocks without metadata.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param num_blocks Number of data blocks to copy.
+ * \param ctx DIF context. Must remain valid until the operation completes.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_generate_copy(struct spdk_io_channel *ch,
+					struct iovec *dst_iovs, size_t dst_iovcnt,
+					struct iovec *src_iovs, size_t src_iovcnt,
+					uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+					spdk_accel_completion_cb cb_fn, void *cb_arg);
+
 /** Object grouping multiple accel operations to be executed at the same point in time */
 struct spdk_accel_sequence;
 
@@ -379,6 +463,35 @@ int spdk_accel_append_fill(struct spdk_accel_sequence **seq, struct spdk_io_chan
 			   struct spdk_memory_domain *domain, void *domain_ctx, uint8_t pattern,
 			   int flags, spdk_accel_step_cb cb_fn, void *cb_arg);
 
+/**
+ * Append a compress operation to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param dst_iovs Destination I/O vector array.
+ * \param dst_iovcnt Size of the `dst_iovs` array.
+ * \param dst_domain Memory domain to which the destination buffers belong.
+ * \param dst_domain_ctx Destination buffer domain context.
+ * \param src_iovs Source I/O vector array.
+ * \param src_iovcnt Size of the `src_iovs` array.
+ * \param src_domain Memory domain to which the source buffers belong.
+ * \param src_domain_ctx Source buffer domain context.
+ * \param output_size The size of the compressed data (may be NULL if not desired).  It is
+ * valid once the step callback of this operation is executed.
+ * \param flags Accel operation flags.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_compress(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			       struct iovec *dst_iovs, size_t dst_iovcnt,
+			       struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			       struct iovec *src_iovs, size_t src_iovcnt,
+			       struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			       uint32_t *output_size, int flags,
+			       spdk_accel_step_cb cb_fn, void *cb_arg);
+
 /**
  * Append a decompress operation to a sequence.
  *
@@ -501,6 +614,104 @@ int spdk_accel_append_crc32c(struct spdk_accel_sequence **seq, struct spdk_io_ch
 			     struct spdk_memory_domain *domain, void *domain_ctx,
 			     uint32_t seed, spdk_accel_step_cb cb_fn, void *cb_arg);
 
+/**
+ * Append an xor operation to a sequence.  The source buffers are regular virtual memory buffers,
+ * only the destination buffer can belong to a memory domain.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param dst_iovs Destination I/O vector array.  Only a single element is currently supported.
+ * \param dst_iovcnt Size of the `dst_iovs` array.
+ * \param dst_domain Memory domain to which the destination buffer belongs.
+ * \param dst_domain_ctx Destination buffer domain context.
+ * \param sources Array of source buffers, each of them `dst_iovs[0].iov_len` bytes long.
+ * \param nsrcs Number of source buffers in the array.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_xor(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			  void **sources, uint32_t nsrcs, spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a DIF verify operation to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param iovs I/O vector array describing the extended LBA payload.
+ * \param iovcnt Size of the `iovs` array.
+ * \param domain Memory domain to which the buffers belong.
+ * \param domain_ctx Buffer domain context.
+ * \param num_blocks Number of data blocks to verify.
+ * \param ctx DIF context. Must remain valid until the operation completes.
+ * \param err DIF error information, filled in when the verification fails.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_dif_verify(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+				 struct iovec *iovs, size_t iovcnt,
+				 struct spdk_memory_domain *domain, void *domain_ctx,
+				 uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				 struct spdk_dif_error *err, spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a DIF generate operation to a sequence.  The protection information is generated in
+ * place, so the buffers must be accessible by the accel modules, i.e. `domain` can only be NULL
+ * or the accel memory domain.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param iovs I/O vector array describing the extended LBA payload.
+ * \param iovcnt Size of the `iovs` array.
+ * \param domain Memory domain to which the buffers belong.
+ * \param domain_ctx Buffer domain context.
+ * \param num_blocks Number of data blocks to generate the protection information for.
+ * \param ctx DIF context. Must remain valid until the operation completes.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_dif_generate(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+				   struct iovec *iovs, size_t iovcnt,
+				   struct spdk_memory_domain *domain, void *domain_ctx,
+				   uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				   spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a DIF generate and copy operation to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param dst_iovs Destination I/O vector array, which will store the extended LBA payload.
+ * \param dst_iovcnt Size of the `dst_iovs` array.
+ * \param dst_domain Memory domain to which the destination buffers belong.
+ * \param dst_domain_ctx Destination buffer domain context.
+ * \param src_iovs Source I/O vector array, storing the data blocks without metadata.
+ * \param src_iovcnt Size of the `src_iovs` array.
+ * \param src_domain Memory domain to which the source buffers belong.
+ * \param src_domain_ctx Source buffer domain context.
+ * \param num_blocks Number of data blocks to copy.
+ * \param ctx DIF context. Must remain valid until the operation completes.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_dif_generate_copy(struct spdk_accel_sequence **seq,
+					struct spdk_io_channel *ch,
+					struct iovec *dst_iovs, size_t dst_iovcnt,
+					struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+					struct iovec *src_iovs, size_t src_iovcnt,
+					struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+					uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+					spdk_accel_step_cb cb_fn, void *cb_arg);
+
 /**
  * Finish a sequence and execute all its operations. After the completion callback is executed, the
  * sequence object is automatically freed.
@@ -644,6 +855,29 @@ int spdk_accel_get_opc_module_name(enum spdk_accel_opcode opcode, const char **m
  */
 int spdk_accel_assign_opc(enum spdk_accel_opcode opcode, const char *name);
 
+/**
+ * Route some of the operations of an opcode to modules other than the one assigned to it.
+ *
+ * Operations smaller than `small_threshold` bytes are executed by `small_module`, which is
+ * useful for offload engines that are slower than the CPU for small buffers.  Once `spill_qd`
+ * operations are outstanding on the assigned module of a channel, further operations are
+ * executed by `spill_module` until the queue drains.  Routing isn't allowed for encrypt and
+ * decrypt, as crypto keys are bound to a single module.
+ *
+ * \param opcode Accel Framework Opcode enum value.
+ * \param small_module Name of the module executing small operations.  NULL to disable.
+ * \param small_threshold Size (in bytes) below which operations are executed by `small_module`.
+ * \param spill_module Name of the module executing the spillover operations.  NULL to disable.
+ * \param spill_qd Number of operations outstanding on the assigned module (per channel) above
+ * which operations are executed by `spill_module`.
+ *
+ * \return 0 on success, -EINVAL for invalid parameters or if the framework has started,
+ * -ENOMEM if memory couldn't be allocated.
+ */
+int spdk_accel_assign_opc_route(enum spdk_accel_opcode opcode, const char *small_module,
+				uint64_t small_threshold, const char *spill_module,
+				uint32_t spill_qd);
+
 struct spdk_json_write_ctx;
 
 /**
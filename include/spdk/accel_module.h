@@ -50,6 +50,15 @@ struct spdk_accel_crypto_key {
 	struct spdk_accel_module_if *module_if;			/**< Accel module the key belongs to */
 	struct spdk_accel_crypto_key_create_param param;	/**< User input parameters */
 	TAILQ_ENTRY(spdk_accel_crypto_key) link;
+	/** Hardware key slot state, managed by the accel framework */
+	struct {
+		/* Number of tasks using the key, which prevent it from being unbound */
+		uint32_t				outstanding;
+		bool					bound;
+		/* Set when the key is used, cleared when passed over for eviction */
+		bool					referenced;
+		TAILQ_ENTRY(spdk_accel_crypto_key)	link;
+	} slot;
 };
 
 /**
@@ -115,6 +124,11 @@ struct spdk_accel_task {
 		uint32_t			seed;
 		uint64_t			fill_pattern;
 		struct spdk_accel_crypto_key	*crypto_key;
+		struct {
+			const struct spdk_dif_ctx	*ctx;
+			struct spdk_dif_error		*err;
+			uint32_t			num_blocks;
+		} dif;
 	};
 	union {
 		uint32_t		*crc_dst;
@@ -122,8 +136,15 @@ struct spdk_accel_task {
 		uint32_t		block_size; /* for crypto op */
 	};
 	uint64_t			iv; /* Initialization vector (tweak) for crypto op */
+	/* Destination and seed of the crc32c fused with a crypto op (e.g. encrypt_crc32c) */
+	uint32_t			*fused_crc_dst;
+	uint32_t			fused_seed;
+	/* Tick count at submission, used by the accel framework to track module latency */
+	uint64_t			submit_tsc;
 	/* Uses enum spdk_accel_opcode */
 	uint8_t				op_code;
+	/* Module route the task was submitted to, internal to the accel framework */
+	uint8_t				route;
 	int16_t				status;
 	int				flags;
 	TAILQ_ENTRY(spdk_accel_task)	link;
@@ -190,6 +211,22 @@ struct spdk_accel_module_if {
 	/** Free any resources associated with `key` allocated during `crypto_key_init()`. */
 	void (*crypto_key_deinit)(struct spdk_accel_crypto_key *key);
 
+	/**
+	 * Load the hardware state of a key (e.g. device sessions), so that it can be used by
+	 * tasks.  Modules with a limited number of such resources implement it, along with
+	 * `crypto_key_unbind()` and `crypto_get_max_bound_keys()`, and only prepare the software
+	 * state in `crypto_key_init()`.  The accel framework then binds keys on first use and
+	 * unbinds the least recently used idle ones once the limit is reached.  Can be called
+	 * from any thread.
+	 */
+	int (*crypto_key_bind)(struct spdk_accel_crypto_key *key);
+
+	/** Release the hardware state loaded by `crypto_key_bind()`. */
+	void (*crypto_key_unbind)(struct spdk_accel_crypto_key *key);
+
+	/** Returns the number of keys that can be bound at the same time. */
+	uint32_t (*crypto_get_max_bound_keys)(void);
+
 	/**
 	 * Returns true if given tweak mode is supported. If module doesn't implement that function it shall support SIMPLE LBA mode.
 	 */
@@ -212,6 +249,19 @@ struct spdk_accel_module_if {
 	 */
 	int (*get_memory_domains)(struct spdk_memory_domain **domains, int num_domains);
 
+	/**
+	 * Checks whether the module can access buffers described by a memory domain natively, so
+	 * that they don't need to be pulled into / pushed from a bounce buffer.  Only used for
+	 * modules that don't support memory domains through `get_memory_domains`.  If NULL, buffers
+	 * in all memory domains are bounced.  Tasks using such buffers are submitted with their
+	 * `src_domain`/`dst_domain` set.
+	 *
+	 * \param domain Memory domain.
+	 *
+	 * \return true if the module can access the buffers of the memory domain, false otherwise.
+	 */
+	bool (*can_access_memory_domain)(struct spdk_memory_domain *domain);
+
 	/**
 	 * Returns information/constraints for a given operation.  If unimplemented, it is assumed
 	 * that the module doens't have any constraints to execute any operation.
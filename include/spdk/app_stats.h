@@ -0,0 +1,72 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/** \file
+ * Layout of the shared memory with the reactor and thread statistics exported by
+ * the SPDK applications, for the monitoring tools (e.g. spdk_top) to read them
+ * without issuing any RPCs.
+ */
+
+#ifndef SPDK_APP_STATS_H
+#define SPDK_APP_STATS_H
+
+#include "spdk/stdinc.h"
+#include "spdk/cpuset.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPDK_APP_STATS_MAX_REACTORS	SPDK_CPUSET_SIZE
+#define SPDK_APP_STATS_MAX_THREADS	1024
+#define SPDK_APP_STATS_NAME_LEN		128
+#define SPDK_APP_STATS_CPUMASK_LEN	(SPDK_CPUSET_SIZE / 4 + 1)
+
+/*
+ * Each entry is updated by a single reactor.  Its sequence number is odd while the
+ * entry is being updated, so readers have to retry copying it until they see the
+ * same, even number before and after the copy.
+ */
+struct spdk_app_stats_reactor {
+	uint64_t	seq;
+	uint32_t	lcore;
+	/* Set once the reactor starts updating its statistics */
+	bool		valid;
+	bool		in_interrupt;
+	uint64_t	busy_tsc;
+	uint64_t	idle_tsc;
+	/* Tick of the last update */
+	uint64_t	tsc;
+};
+
+struct spdk_app_stats_thread {
+	uint64_t	seq;
+	/* ID of the thread, 0 if the entry is unused */
+	uint64_t	id;
+	uint32_t	lcore;
+	char		name[SPDK_APP_STATS_NAME_LEN];
+	char		cpumask[SPDK_APP_STATS_CPUMASK_LEN];
+	uint64_t	busy_tsc;
+	uint64_t	idle_tsc;
+	uint64_t	active_pollers_count;
+	uint64_t	timed_pollers_count;
+	uint64_t	paused_pollers_count;
+	/* Tick at which the thread was scheduled on its current reactor */
+	uint64_t	tsc_start;
+};
+
+struct spdk_app_stats {
+	uint64_t			tsc_rate;
+	/* Update period of the entries */
+	uint64_t			period_us;
+	struct spdk_app_stats_reactor	reactors[SPDK_APP_STATS_MAX_REACTORS];
+	struct spdk_app_stats_thread	threads[SPDK_APP_STATS_MAX_THREADS];
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_APP_STATS_H */
@@ -175,6 +175,12 @@ struct spdk_bdev_io_stat {
 	uint64_t max_copy_latency_ticks;
 	uint64_t min_copy_latency_ticks;
 	uint64_t ticks_rate;
+	/* Number of reads and writes merged into preceding requests */
+	uint64_t num_merged_ops;
+	/* Number of times the bdev module completed an I/O with NOMEM status */
+	uint64_t num_nomem_ios;
+	/* Number of resubmissions of I/O queued after NOMEM status */
+	uint64_t num_nomem_retries;
 
 	/* This data structure is privately defined in the bdev library.
 	 * This data structure is only used by the bdev_get_iostat RPC now.
@@ -200,8 +206,22 @@ struct spdk_bdev_opts {
 	 */
 	size_t opts_size;
 
-	/* Hole at bytes 24-31. */
-	uint8_t reserved[8];
+	/**
+	 * Submit rate limited I/O on the thread of the channel, taking quota from the
+	 * bdev's QoS in batches, instead of sending all I/O to the QoS thread.
+	 * I/O is only sent to the QoS thread when the quota of the current timeslice
+	 * has run out. Not used for bdevs in a QoS group.
+	 */
+	bool qos_distributed;
+
+	/* Hole at bytes 25-27. */
+	uint8_t reserved25[3];
+
+	/**
+	 * Maximum number of examinations each bdev module runs at the same time. Further
+	 * examine_disk calls are deferred until one of them completes. 0 means no limit.
+	 */
+	uint32_t examine_max_in_progress;
 } __attribute__((packed));
 SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 32, "Incorrect size");
 
@@ -606,6 +626,77 @@ void spdk_bdev_get_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits);
 void spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 				   void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
 
+/**
+ * Create a QoS group. The rate limits of a QoS group are shared by all bdevs
+ * added to it, on top of their own rate limits.
+ *
+ * \param name Name of the QoS group.
+ * \param limits Pointer to the QoS rate limits array which holding the limits,
+ * in the same units as for spdk_bdev_set_qos_rate_limits(). 0 means unlimited.
+ * \param burst_ms Time in milliseconds for which unused rate can accumulate, i.e.
+ * the burst size of the token buckets. Values below one timeslice (1ms) are rounded up.
+ * \return 0 on success, -EEXIST if the group already exists, -EINVAL if no limits
+ * are given, -ENOMEM on memory allocation failure.
+ *
+ * The limits are ordered based on the @ref spdk_bdev_qos_rate_limit_type enum.
+ */
+int spdk_bdev_qos_group_create(const char *name, uint64_t *limits, uint32_t burst_ms);
+
+/**
+ * Delete a QoS group.
+ *
+ * \param name Name of the QoS group.
+ * \return 0 on success, -ENODEV if the group does not exist, -EBUSY if bdevs
+ * are still in the group.
+ */
+int spdk_bdev_qos_group_delete(const char *name);
+
+/**
+ * Add a bdev to a QoS group.
+ *
+ * I/O up to the minimum rates given for the bdev are issued even if the group
+ * has run out of its shared rate, so that other bdevs of the group can't starve it.
+ *
+ * \param group_name Name of the QoS group.
+ * \param bdev Block device.
+ * \param min_limits Pointer to the array of rates guaranteed to the bdev, in the
+ * same units as for spdk_bdev_set_qos_rate_limits(). 0 means no guarantee.
+ * \param cb_fn Callback function to be called when the bdev has been added.
+ * \param cb_arg Argument to pass to cb_fn.
+ *
+ * The limits are ordered based on the @ref spdk_bdev_qos_rate_limit_type enum.
+ */
+void spdk_bdev_qos_group_add_bdev(const char *group_name, struct spdk_bdev *bdev,
+				  uint64_t *min_limits,
+				  void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
+
+/**
+ * Remove a bdev from its QoS group.
+ *
+ * \param bdev Block device.
+ * \param cb_fn Callback function to be called when the bdev has been removed.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_qos_group_remove_bdev(struct spdk_bdev *bdev,
+				     void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
+
+/**
+ * Enable or disable merging of adjacent reads and writes on a bdev.
+ *
+ * A read or write submitted on a channel that already has I/O outstanding may be held for up
+ * to hold_us microseconds, so that LBA-contiguous requests of the same type can be submitted
+ * to the bdev module as a single request.  Requests with separate metadata, memory domains or
+ * accel sequences are never merged, and nothing is merged on bdevs with QoS rate limits.
+ *
+ * \param bdev Block device.
+ * \param hold_us Maximum time in microseconds a request may be held. 0 disables merging.
+ * \param max_size_kb Maximum size of a merged request in KiB. 0 means the default of 128 KiB.
+ * \param cb_fn Callback function to be called once all channels of the bdev are updated.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_set_io_merge(struct spdk_bdev *bdev, uint64_t hold_us, uint32_t max_size_kb,
+			    void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
+
 /**
  * Get minimum I/O buffer address alignment for a bdev.
  *
@@ -849,6 +940,26 @@ struct spdk_io_channel *spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc);
  */
 void *spdk_bdev_get_module_ctx(struct spdk_bdev_desc *desc);
 
+/**
+ * Start batching the I/O submitted on the specified I/O channel.
+ *
+ * Reads and writes reaching the bdev module through this channel are held until
+ * spdk_bdev_submit_batch() is called, and then passed to the module all at once, so
+ * that it can notify the device only once for all of them.  Other requests are
+ * submitted right away.  Batches are meant to be short, e.g. the I/O submitted during
+ * a single poll, and are also submitted whenever they grow large enough.
+ *
+ * \param ch I/O channel obtained by spdk_bdev_get_io_channel().
+ */
+void spdk_bdev_start_batch(struct spdk_io_channel *ch);
+
+/**
+ * Submit the I/O held since spdk_bdev_start_batch() and stop batching.
+ *
+ * \param ch I/O channel passed to spdk_bdev_start_batch().
+ */
+void spdk_bdev_submit_batch(struct spdk_io_channel *ch);
+
 /**
  * \defgroup bdev_io_submit_functions bdev I/O Submit Functions
  *
@@ -1895,6 +2006,17 @@ void spdk_bdev_get_io_stat(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 void spdk_bdev_get_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat,
 			       spdk_bdev_get_device_stat_cb cb, void *cb_arg);
 
+/**
+ * Return I/O statistics for this bdev immediately.  The statistics of each channel are read
+ * directly from the calling thread, without sending messages to the threads of the channels.
+ *
+ * Must be called from an SPDK thread.
+ *
+ * \param bdev Block device to query.
+ * \param stat Structure for aggregating collected statistics.
+ */
+void spdk_bdev_read_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat);
+
 /**
  * Get the status of bdev_io as an NVMe status code and command specific
  * completion queue value.
@@ -2007,6 +2129,54 @@ void spdk_bdev_histogram_get(struct spdk_bdev *bdev, struct spdk_histogram_data
 			     spdk_bdev_histogram_data_cb cb_fn,
 			     void *cb_arg);
 
+/** I/O size classes of the histograms split by I/O type and size. */
+enum spdk_bdev_histogram_size_class {
+	/** I/O up to 4KiB, as well as I/O without a data range (e.g. resets) */
+	SPDK_BDEV_HISTOGRAM_SIZE_4K = 0,
+	/** I/O larger than 4KiB, up to 16KiB */
+	SPDK_BDEV_HISTOGRAM_SIZE_16K,
+	/** I/O larger than 16KiB, up to 128KiB */
+	SPDK_BDEV_HISTOGRAM_SIZE_128K,
+	/** I/O larger than 128KiB */
+	SPDK_BDEV_HISTOGRAM_SIZE_LARGE,
+	SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES /* Keep last */
+};
+
+/** Number of histograms kept when splitting them by I/O type and size. */
+#define SPDK_BDEV_HISTOGRAM_NUM_SPLIT \
+	(SPDK_BDEV_NUM_IO_TYPES * SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES)
+
+/**
+ * Get aggregated histogram data from a bdev, split by I/O type and size class. Histograms
+ * are only collected while enabled through spdk_bdev_histogram_enable().
+ *
+ * The histograms array has SPDK_BDEV_HISTOGRAM_NUM_SPLIT entries, the histogram of a given
+ * I/O type and size class being at index io_type * SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES +
+ * size_class. Entries must be either NULL or point to a histogram that the data is merged
+ * into. Histograms of the classes with collected data are allocated for NULL entries, so
+ * the caller needs to free them with spdk_histogram_data_free(), even when the operation
+ * fails. Entries left NULL have no data.
+ *
+ * \param bdev Block device.
+ * \param histograms Array of histograms for aggregated data.
+ * \param cb_fn Callback function to be called once the data is collected.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_histogram_get_split(struct spdk_bdev *bdev,
+				   struct spdk_histogram_data **histograms,
+				   spdk_bdev_histogram_status_cb cb_fn, void *cb_arg);
+
+/**
+ * Reset the histogram data collected on a bdev, both the aggregated data and the data
+ * split by I/O type and size class. Histograms stay enabled.
+ *
+ * \param bdev Block device.
+ * \param cb_fn Callback function to be called once the data is reset.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_histogram_reset(struct spdk_bdev *bdev, spdk_bdev_histogram_status_cb cb_fn,
+			       void *cb_arg);
+
 /**
  * Get histogram data of the specified channel for a bdev. The histogram passed to cb_fn
  * is only valid during the execution of cb_fn. Referencing the histogram after cb_fn
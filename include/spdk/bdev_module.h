@@ -24,6 +24,8 @@
 #include "spdk/util.h"
 #include "spdk/uuid.h"
 
+struct spdk_metrics_group;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -147,7 +149,7 @@ struct spdk_bdev_module {
 	 */
 	struct __bdev_module_internal_fields {
 		/**
-		 * Protects action_in_progress and quiesced_ranges.
+		 * Protects action_in_progress, the examine counters and quiesced_ranges.
 		 * Take no locks while holding this one.
 		 */
 		struct spdk_spinlock spinlock;
@@ -160,6 +162,18 @@ struct spdk_bdev_module {
 		 */
 		uint32_t action_in_progress;
 
+		/** Count of examinations in progress, deferred ones excluded. */
+		uint32_t examine_in_progress;
+
+		/** Count of examine_config and examine_disk calls. */
+		uint64_t examine_count;
+
+		/** Ticks spent with at least one examination in progress. */
+		uint64_t examine_busy_tsc;
+
+		/** Tick at which examine_in_progress last became non-zero. */
+		uint64_t examine_start_tsc;
+
 		/**
 		 * List of quiesced lba ranges in all bdevs of this module.
 		 */
@@ -367,6 +381,18 @@ struct spdk_bdev_fn_table {
 
 	/** Check if bdev can handle spdk_accel_sequence to handle I/O of specific type. */
 	bool (*accel_sequence_supported)(void *ctx, enum spdk_bdev_io_type type);
+
+	/**
+	 * Process a batch of reads and writes submitted on the same channel through
+	 * spdk_bdev_submit_batch(). Optional - may be NULL, in which case submit_request is
+	 * called for each of them.
+	 *
+	 * It allows the backend to notify the device only once for the whole batch. Requests
+	 * failed with SPDK_BDEV_IO_STATUS_NOMEM are retried in the order of their completion,
+	 * so the ones not accepted should be completed starting from the last one.
+	 */
+	void (*submit_request_batch)(struct spdk_io_channel *ch, struct spdk_bdev_io **bdev_ios,
+				     uint32_t num_ios);
 };
 
 /** bdev I/O completion status */
@@ -624,6 +650,15 @@ struct spdk_bdev {
 		/** True if the state of the QoS is being modified */
 		bool qos_mod_in_progress;
 
+		/**
+		 * Maximum time in microseconds reads and writes are held to be merged with
+		 * adjacent ones, 0 if merging is disabled. See spdk_bdev_set_io_merge().
+		 */
+		uint64_t merge_hold_us;
+
+		/** Maximum size of a merged request in KiB */
+		uint32_t merge_max_size_kb;
+
 		/**
 		 * SPDK spinlock protecting many of the internal fields of this structure. If
 		 * multiple locks need to be held, the following order must be used:
@@ -715,6 +750,12 @@ struct spdk_bdev {
 		/** accumulated I/O statistics for previously deleted channels of this bdev */
 		struct spdk_bdev_io_stat *stat;
 
+		/** metrics of this bdev, NULL if the metrics aren't enabled */
+		struct spdk_metrics_group *metrics;
+
+		/** channels of this bdev, used to read their I/O statistics directly */
+		TAILQ_HEAD(, spdk_bdev_channel) channels;
+
 		/** true if tracking the queue_depth of a device is in progress */
 		bool	qd_poll_in_progress;
 
@@ -722,9 +763,12 @@ struct spdk_bdev {
 		bool	histogram_enabled;
 		bool	histogram_in_progress;
 
-		/** Currently locked ranges for this bdev.  Used to populate new channels. */
+		/** Currently locked ranges for this bdev. */
 		lba_range_tailq_t locked_ranges;
 
+		/** Trees of the locked ranges, looked up by the channels when submitting writes */
+		struct spdk_bdev_lba_locks *lba_locks;
+
 		/** Pending locked ranges for this bdev.  These ranges are not currently
 		 *  locked due to overlapping with another locked range.
 		 */
@@ -774,9 +818,6 @@ struct spdk_bdev_io {
 	/** A single iovec element for use by this bdev_io. */
 	struct iovec iov;
 
-	/** Array of iovecs used for I/O splitting. */
-	struct iovec child_iov[SPDK_BDEV_IO_NUM_CHILD_IOV];
-
 	union {
 		struct {
 			/** For SG buffer cases, array of iovecs to transfer. */
@@ -785,11 +826,6 @@ struct spdk_bdev_io {
 			/** For SG buffer cases, number of iovecs in iovec array. */
 			int iovcnt;
 
-			/** For fused operations such as COMPARE_AND_WRITE, array of iovecs
-			 *  for the second operation.
-			 */
-			struct iovec *fused_iovs;
-
 			/** Number of iovecs in fused_iovs. */
 			int fused_iovcnt;
 
@@ -809,6 +845,11 @@ struct spdk_bdev_io {
 			/* Sequence of accel operations */
 			struct spdk_accel_sequence *accel_sequence;
 
+			/** For fused operations such as COMPARE_AND_WRITE, array of iovecs
+			 *  for the second operation.
+			 */
+			struct iovec *fused_iovs;
+
 			/** stored user callback in case we split the I/O and use a temporary callback */
 			spdk_bdev_io_completion_cb stored_user_cb;
 
@@ -920,6 +961,35 @@ struct spdk_bdev_io {
 		/** Current tsc at submit time. Used to calculate latency at completion. */
 		uint64_t submit_tsc;
 
+		/**
+		 * Set to true while the bdev module submit_request function is in progress.
+		 *
+		 * This is used to decide whether spdk_bdev_io_complete() can complete the I/O directly
+		 * or if completion must be deferred via an event.
+		 */
+		bool in_submit_request;
+
+		/** Status for the IO */
+		int8_t status;
+
+		/** Indicates whether the IO is split */
+		bool split;
+
+		/** Retry state (resubmit, re-pull, re-push, etc.) */
+		uint8_t retry_state;
+
+		/** Index of the NUMA socket's bdev_io pool this bdev_io belongs to */
+		uint8_t pool_idx;
+
+		/** Indicates that the IO is associated with an accel sequence */
+		bool has_accel_sequence;
+
+		/** True if the IO was built by the bdev layer by merging adjacent reads or writes */
+		bool merged;
+
+		/** LBA lock shards and epoch slot this write is accounted on, if any */
+		uint8_t lba_lock;
+
 		/** Error information from a device */
 		union {
 			struct {
@@ -945,38 +1015,35 @@ struct spdk_bdev_io {
 			int aio_result;
 		} error;
 
-		/**
-		 * Set to true while the bdev module submit_request function is in progress.
-		 *
-		 * This is used to decide whether spdk_bdev_io_complete() can complete the I/O directly
-		 * or if completion must be deferred via an event.
-		 */
-		bool in_submit_request;
+		/** Entry to the list io_submitted of struct spdk_bdev_channel */
+		TAILQ_ENTRY(spdk_bdev_io) ch_link;
 
-		/** Status for the IO */
-		int8_t status;
+		/** Memory domain and its context passed by the user in ext API */
+		struct spdk_memory_domain *memory_domain;
+		void *memory_domain_ctx;
 
-		/** Indicates whether the IO is split */
-		bool split;
+		/* Sequence of accel operations passed by the user */
+		struct spdk_accel_sequence *accel_sequence;
 
-		/** Retry state (resubmit, re-pull, re-push, etc.) */
-		uint8_t retry_state;
+		/** Original submission of an I/O forwarded by spdk_bdev_io_forward_blocks() */
+		struct {
+			/** The bdev the I/O was submitted to, NULL if the I/O isn't forwarded */
+			struct spdk_bdev *bdev;
 
-		/** Indicates that the IO is associated with an accel sequence */
-		bool has_accel_sequence;
+			/** The bdev I/O channel the I/O was submitted on */
+			struct spdk_bdev_channel *ch;
+
+			/** Offset added to offset_blocks when forwarding */
+			uint64_t offset_blocks;
+		} forward;
 
 		/** bdev allocated memory associated with this request */
 		void *buf;
 
-		/** requested size of the buffer associated with this I/O */
-		uint64_t buf_len;
-
 		/** if the request is double buffered, store original request iovs here */
-		struct iovec  bounce_iov;
-		struct iovec  bounce_md_iov;
-		struct iovec  orig_md_iov;
 		struct iovec *orig_iovs;
 		int           orig_iovcnt;
+		struct iovec  orig_md_iov;
 
 		/** Callback for when the aux buf is allocated */
 		spdk_bdev_io_get_aux_buf_cb get_aux_buf_cb;
@@ -984,6 +1051,14 @@ struct spdk_bdev_io {
 		/** Callback for when buf is allocated */
 		spdk_bdev_io_get_buf_cb get_buf_cb;
 
+		/** Data transfer completion callback */
+		void (*data_transfer_cpl)(void *ctx, int rc);
+
+		/*
+		 * The fields above are accessed on every I/O, the ones below only when the I/O is
+		 * queued or its buffers are allocated or bounced by the bdev layer.
+		 */
+
 		/**
 		 * Queue entry used in several cases:
 		 *  1. IOs awaiting retry due to NOMEM status,
@@ -994,29 +1069,26 @@ struct spdk_bdev_io {
 		 */
 		TAILQ_ENTRY(spdk_bdev_io) link;
 
+		/** requested size of the buffer associated with this I/O */
+		uint64_t buf_len;
+
+		/** Bounce buffers used when the request is double buffered */
+		struct iovec  bounce_iov;
+		struct iovec  bounce_md_iov;
+
 		/** Entry to the list need_buf of struct spdk_bdev. */
 		STAILQ_ENTRY(spdk_bdev_io) buf_link;
 
-		/** Entry to the list io_submitted of struct spdk_bdev_channel */
-		TAILQ_ENTRY(spdk_bdev_io) ch_link;
-
 		/** iobuf queue entry */
 		struct spdk_iobuf_entry iobuf;
 
 		/** Enables queuing parent I/O when no bdev_ios available for split children. */
 		struct spdk_bdev_io_wait_entry waitq_entry;
-
-		/** Memory domain and its context passed by the user in ext API */
-		struct spdk_memory_domain *memory_domain;
-		void *memory_domain_ctx;
-
-		/* Sequence of accel operations passed by the user */
-		struct spdk_accel_sequence *accel_sequence;
-
-		/** Data transfer completion callback */
-		void (*data_transfer_cpl)(void *ctx, int rc);
 	} internal;
 
+	/** Array of iovecs used for I/O splitting. */
+	struct iovec child_iov[SPDK_BDEV_IO_NUM_CHILD_IOV];
+
 	/**
 	 * Per I/O context for use by the bdev module.
 	 */
@@ -1025,6 +1097,15 @@ struct spdk_bdev_io {
 	/* No members may be added after driver_ctx! */
 };
 
+/*
+ * Keep the fields that are accessed on every I/O close together: the ones used by bdev modules
+ * within the first two cache lines and the bdev layer's own within the following four.
+ */
+SPDK_STATIC_ASSERT(offsetof(struct spdk_bdev_io, u.bdev.accel_sequence) + sizeof(void *) <=
+		   2 * SPDK_CACHE_LINE_SIZE, "bdev_io fast path fields exceed two cache lines");
+SPDK_STATIC_ASSERT(offsetof(struct spdk_bdev_io, internal.link) <= 6 * SPDK_CACHE_LINE_SIZE,
+		   "bdev_io internal fast path fields exceed six cache lines");
+
 /**
  * Register a new bdev.
  *
@@ -1267,6 +1348,32 @@ void spdk_bdev_io_complete_scsi_status(struct spdk_bdev_io *bdev_io, enum spdk_s
  */
 void spdk_bdev_io_complete_aio_status(struct spdk_bdev_io *bdev_io, int aio_result);
 
+/**
+ * Forward a bdev_io to another bdev without allocating a new bdev_io for it.
+ *
+ * The I/O is remapped by adding offset_blocks to its starting block and passed directly to
+ * the module of the bdev described by desc, so only modules that don't need to do anything
+ * else with the I/O (e.g. partitions) can use this.  Once the target module completes the I/O,
+ * it's remapped back and completed on the bdev it was originally submitted to.
+ *
+ * Forwarding is only done for reads, writes, write zeroes, unmaps and flushes without DIF,
+ * memory domains or accel sequences and only if the target channel can take the I/O right
+ * away, i.e. it isn't under QoS, reset, locked LBA ranges or NOMEM retries and the I/O doesn't
+ * need to be split.  Otherwise, the bdev_io is left unchanged and the caller is expected to
+ * submit a new I/O to the target bdev instead.
+ *
+ * \param desc Descriptor of the bdev to forward the I/O to.
+ * \param ch I/O channel of the bdev to forward the I/O to.  It has to be on the same thread
+ * as the channel the I/O was submitted on.
+ * \param bdev_io I/O to forward.
+ * \param offset_blocks Number of blocks to add to the I/O's starting block.
+ *
+ * \return 0 if the I/O was forwarded, -ENOTSUP if it can't be, -EAGAIN if it can't be
+ * forwarded at the moment.
+ */
+int spdk_bdev_io_forward_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+				struct spdk_bdev_io *bdev_io, uint64_t offset_blocks);
+
 /**
  * Get a thread that given bdev_io was submitted on.
  *
@@ -105,6 +105,32 @@ int spdk_bit_array_set(struct spdk_bit_array *ba, uint32_t bit_index);
  */
 void spdk_bit_array_clear(struct spdk_bit_array *ba, uint32_t bit_index);
 
+/**
+ * Set (to 1) a range of bits in the bit array.
+ *
+ * \param ba Bit array to set the bits.
+ * \param start_bit_index The index of the first bit to set.
+ * \param num_bits Number of bits to set.
+ *
+ * \return 0 on success, negative errno on failure. If the range extends beyond the end of
+ * the bit array, -EINVAL is returned and no bit is set.
+ */
+int spdk_bit_array_set_range(struct spdk_bit_array *ba, uint32_t start_bit_index,
+			     uint32_t num_bits);
+
+/**
+ * Clear (to 0) a range of bits in the bit array.
+ *
+ * The part of the range beyond the end of the bit array is ignored, since bits
+ * beyond the end of the bit array are implicitly 0.
+ *
+ * \param ba Bit array to clear the bits.
+ * \param start_bit_index The index of the first bit to clear.
+ * \param num_bits Number of bits to clear.
+ */
+void spdk_bit_array_clear_range(struct spdk_bit_array *ba, uint32_t start_bit_index,
+				uint32_t num_bits);
+
 /**
  * Find the index of the first set bit in the array.
  *
@@ -127,6 +153,19 @@ uint32_t spdk_bit_array_find_first_set(const struct spdk_bit_array *ba, uint32_t
  */
 uint32_t spdk_bit_array_find_first_clear(const struct spdk_bit_array *ba, uint32_t start_bit_index);
 
+/**
+ * Find the index of the first range of consecutive cleared bits in the array.
+ *
+ * \param ba The bit array to search.
+ * \param start_bit_index The bit index from which to start searching (0 to start
+ * from the beginning of the array).
+ * \param num_bits Number of consecutive cleared bits to find. Must be greater than 0.
+ *
+ * \return the index of the first bit of the range. If no such range exists, returns UINT32_MAX.
+ */
+uint32_t spdk_bit_array_find_first_clear_range(const struct spdk_bit_array *ba,
+		uint32_t start_bit_index, uint32_t num_bits);
+
 /**
  * Count the number of set bits in the array.
  *
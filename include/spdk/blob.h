@@ -302,8 +302,22 @@ struct spdk_bs_opts {
 	 * Context to pass with esnap_bs_dev_create.
 	 */
 	void *esnap_ctx;
+
+	/**
+	 * Time in microseconds during which the metadata updates caused by allocating clusters
+	 * to thin provisioned blobs are collected, so that they're written as a group.  All the
+	 * clusters inserted into a blob within that time are persisted by a single metadata
+	 * update.  0 disables the group commit, which is the default.
+	 */
+	uint32_t md_commit_window_us;
+
+	/**
+	 * Number of collected metadata updates, after which the group is committed without
+	 * waiting for md_commit_window_us to pass.  0 means no limit.
+	 */
+	uint32_t md_commit_max_pending;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 96, "Incorrect size");
 
 /**
  * Initialize a spdk_bs_opts structure to the default blobstore option values.
@@ -515,6 +529,56 @@ uint64_t spdk_blob_get_next_allocated_io_unit(struct spdk_blob *blob, uint64_t o
  */
 uint64_t spdk_blob_get_next_unallocated_io_unit(struct spdk_blob *blob, uint64_t offset);
 
+/**
+ * Translate a range of io_units of a blob to the blobstore device.
+ *
+ * This only succeeds if the whole range lies within a single cluster allocated to the blob
+ * and I/O to the blob isn't frozen, in which case reads and writes of the range may be
+ * submitted straight to the blobstore device instead of through spdk_blob_io_readv() and
+ * spdk_blob_io_writev().  The translation is only valid until the calling thread returns to
+ * its poller loop, as the cluster may be released or I/O frozen afterwards.
+ *
+ * \param blob Blob to translate the range of.
+ * \param channel I/O channel of the blobstore, used by the calling thread.
+ * \param io_unit Offset of the range in io_units from the beginning of the blob.
+ * \param length Length of the range in io_units.
+ * \param dev_channel Set to the blobstore device's channel of the calling thread.
+ * \param lba Set to the LBA of the blobstore device the range starts at.
+ *
+ * \return 0 on success, -ENOENT if the range isn't backed by a single allocated cluster,
+ * -EBUSY if I/O to the blob is frozen.
+ */
+int spdk_blob_io_get_dev_lba(struct spdk_blob *blob, struct spdk_io_channel *channel,
+			     uint64_t io_unit, uint64_t length,
+			     struct spdk_io_channel **dev_channel, uint64_t *lba);
+
+/** Range of io_units of a blob */
+struct spdk_blob_extent {
+	/** Offset in io_units from the beginning of the blob */
+	uint64_t offset;
+	/** Length in io_units */
+	uint64_t length;
+};
+
+/**
+ * Get the extents of a blob that may differ from one of its ancestors, e.g. to back up only the
+ * data changed since an older snapshot in the same chain.  These are the clusters allocated by
+ * the blob or by any of the blobs between it and the ancestor.  The extents are returned in
+ * chunks, the next one starting at the end of the last extent returned.
+ *
+ * \param blob Blob struct to query.
+ * \param base_id ID of the ancestor to compare with, SPDK_BLOBID_INVALID to get all the extents
+ * allocated in the chain of the blob.
+ * \param offset Offset in io_units from the beginning of the blob to start from.
+ * \param extents Array filled with the extents found.
+ * \param num_extents Size of the extents array on input, number of extents found on output.  No
+ * extents are found once the end of the blob is reached.
+ *
+ * \return 0 on success, -EINVAL if base_id is not an ancestor of the blob.
+ */
+int spdk_blob_get_changed_extents(struct spdk_blob *blob, spdk_blob_id base_id, uint64_t offset,
+				  struct spdk_blob_extent *extents, uint32_t *num_extents);
+
 struct spdk_blob_xattr_opts {
 	/* Number of attributes */
 	size_t	count;
@@ -761,6 +825,42 @@ void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 void spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 				  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Limit the rate at which spdk_bs_inflate_blob(), spdk_bs_blob_decouple_parent() and
+ * spdk_bs_blob_shallow_copy() copy clusters, so that they don't take over the bandwidth of the
+ * device.  Applies to each of the
+ * operations separately, including the ones already in progress.
+ *
+ * \param bs blobstore.
+ * \param clusters_per_sec Maximum number of clusters copied per second by a single operation,
+ * 0 to remove the limit.
+ */
+void spdk_bs_set_copy_rate_limit(struct spdk_blob_store *bs, uint64_t clusters_per_sec);
+
+/**
+ * Copy the clusters of a read only blob, e.g. a snapshot, to an external device.  Only the
+ * clusters allocated by the blob or by its ancestors up to base_id are copied, each of them to
+ * the same offset of the device as in the blob, so that a chain of blobs can be copied
+ * incrementally, one snapshot at a time.
+ *
+ * The copies are limited by spdk_bs_set_copy_rate_limit().
+ *
+ * \param bs blobstore.
+ * \param channel IO channel used to read the blob.
+ * \param blobid The id of the blob to copy.
+ * \param base_id The id of the ancestor whose clusters are not copied, SPDK_BLOBID_INVALID to
+ * copy the clusters allocated in the whole chain of the blob.
+ * \param ext_dev The device to copy the blob to.  Its block size must divide the io unit size of
+ * the blobstore and it must be at least as large as the blob.
+ * \param queue_depth Maximum number of clusters copied in parallel, up to 32.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			       spdk_blob_id blobid, spdk_blob_id base_id,
+			       struct spdk_bs_dev *ext_dev, uint32_t queue_depth,
+			       spdk_blob_op_complete cb_fn, void *cb_arg);
+
 struct spdk_blob_open_opts {
 	enum blob_clear_method  clear_method;
 
@@ -1147,6 +1247,32 @@ void spdk_blob_set_esnap_bs_dev(struct spdk_blob *blob, struct spdk_bs_dev *back
  */
 struct spdk_bs_dev *spdk_blob_get_esnap_bs_dev(const struct spdk_blob *blob);
 
+/**
+ * Set the size of the read cache shared by the devices created with
+ * spdk_bs_esnap_cache_dev_create().  Lowering the size evicts the least recently used data.
+ *
+ * \param size Size of the cache in bytes, 0 disables caching.
+ */
+void spdk_bs_esnap_cache_set_size(uint64_t size);
+
+/**
+ * Create a device caching the reads of an external snapshot device.  The cache is shared by all
+ * the devices created with the same esnap_id, so that the clones of an external snapshot don't
+ * read the same data from it multiple times.  Reads of the same data missing from the cache are
+ * coalesced into a single read of the external snapshot device.
+ *
+ * \param back_dev External snapshot device, destroyed along with the created device.
+ * \param esnap_id ID of the external snapshot, e.g. as passed to the esnap_bs_dev_create()
+ * callback.
+ * \param id_len The size in bytes of the data referenced by esnap_id.
+ * \param dev Upon success, the created device.
+ *
+ * \return 0 on success, -EINVAL if back_dev's block size doesn't allow caching, -ENOMEM if
+ * memory couldn't be allocated.
+ */
+int spdk_bs_esnap_cache_dev_create(struct spdk_bs_dev *back_dev, const void *esnap_id,
+				   uint32_t id_len, struct spdk_bs_dev **dev);
+
 /**
  * Determine if the blob is degraded. A degraded blob cannot perform IO.
  *
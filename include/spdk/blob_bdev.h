@@ -77,6 +77,18 @@ int spdk_bdev_create_bs_dev(const char *bdev_name, bool write,
  */
 int spdk_bs_bdev_claim(struct spdk_bs_dev *bs_dev, struct spdk_bdev_module *module);
 
+/**
+ * Get the descriptor of the bdev a blobstore block device was created from.
+ *
+ * The descriptor may be used to submit I/O to the bdev directly, on the channels of bs_dev,
+ * e.g. as returned by spdk_blob_io_get_dev_lba().  It remains owned by bs_dev.
+ *
+ * \param bs_dev Blobstore block device.
+ *
+ * \return the bdev descriptor, or NULL if bs_dev wasn't created with spdk_bdev_create_bs_dev().
+ */
+struct spdk_bdev_desc *spdk_bs_bdev_get_desc(struct spdk_bs_dev *bs_dev);
+
 #ifdef __cplusplus
 }
 #endif
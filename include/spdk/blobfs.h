@@ -89,6 +89,15 @@ typedef void (*fs_request_fn)(void *arg);
  */
 typedef void (*fs_send_request_fn)(fs_request_fn fn, void *arg);
 
+/**
+ * Function for sending data path request to one of the I/O shards.
+ *
+ * \param shard Index of the shard the request must be executed on.
+ * \param fn A pointer to the request function.
+ * \param arg Argument to the request function.
+ */
+typedef void (*fs_send_io_request_fn)(uint32_t shard, fs_request_fn fn, void *arg);
+
 /**
  * Initialize a spdk_blobfs_opts structure to the default option values.
  *
@@ -139,6 +148,23 @@ void spdk_fs_load(struct spdk_bs_dev *dev, fs_send_request_fn send_request_fn,
  */
 void spdk_fs_unload(struct spdk_filesystem *fs, spdk_fs_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Spread the data path of the synchronous API over several threads.
+ *
+ * Each file is assigned to one of the shards, and the reads and read-ahead of the
+ * synchronous API for that file are executed on the thread serving its shard rather
+ * than on the main dispatch thread, which still handles the metadata operations.
+ * Every shard must be served by a single SPDK thread which holds a channel allocated
+ * with spdk_fs_alloc_io_channel() for as long as the shards are in use. This should be
+ * called right after the filesystem is loaded, before any file is opened.
+ *
+ * \param fs Blobstore filesystem.
+ * \param num_shards Number of shards, 0 to execute everything on the main dispatch thread.
+ * \param send_io_request_fn The function for sending request to a shard.
+ */
+void spdk_fs_set_io_shards(struct spdk_filesystem *fs, uint32_t num_shards,
+			   fs_send_io_request_fn send_io_request_fn);
+
 /**
  * Allocate an I/O channel for asynchronous operations.
  *
@@ -348,6 +374,33 @@ int spdk_fs_set_cache_size(uint64_t size_in_mb);
  */
 uint64_t spdk_fs_get_cache_size(void);
 
+/**
+ * Statistics of the blobstore filesystem cache.
+ */
+struct spdk_fs_cache_stats {
+	/** Number of cache buffer sized chunks read from the cache. */
+	uint64_t hits;
+
+	/** Number of cache buffer sized chunks read from the blobstore. */
+	uint64_t misses;
+
+	/** Number of cache buffers filled by read-ahead. */
+	uint64_t readahead;
+
+	/** Number of cache buffers filled by read-ahead and then read. */
+	uint64_t readahead_hits;
+
+	/** Number of cache buffers freed to make room in the cache. */
+	uint64_t reclaimed;
+};
+
+/**
+ * Get the statistics of the cache shared by all the blobstore filesystems.
+ *
+ * \param stats Filled with the statistics accumulated since the application started.
+ */
+void spdk_fs_get_cache_stats(struct spdk_fs_cache_stats *stats);
+
 #define SPDK_FILE_PRIORITY_LOW	0 /* default */
 #define SPDK_FILE_PRIORITY_HIGH	1
 
@@ -0,0 +1,103 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/**
+ * \file
+ * Coroutines executed on SPDK threads
+ *
+ * Coroutines allow writing asynchronous control paths sequentially.  A coroutine runs on the
+ * SPDK thread it was started on, using its own stack.  Instead of passing a continuation to an
+ * asynchronous operation, it passes spdk_coroutine_wake_cb() along with itself and calls
+ * spdk_coroutine_await(), which suspends it until the operation completes:
+ *
+ *     rc = spdk_blob_sync_md(blob, spdk_coroutine_wake_cb, spdk_coroutine_get_current());
+ *     rc = spdk_coroutine_await();
+ *
+ * Suspended coroutines are resumed through the thread's message queue, so they never run
+ * from within the completion callback of the operation they're waiting for.
+ */
+
+#ifndef SPDK_COROUTINE_H
+#define SPDK_COROUTINE_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct spdk_coroutine;
+
+/**
+ * Function executed by a coroutine.
+ *
+ * \param ctx Context passed to spdk_coroutine_start().
+ */
+typedef void (*spdk_coroutine_fn)(void *ctx);
+
+/** Size of the stack of each coroutine */
+#define SPDK_COROUTINE_STACK_SIZE (64 * 1024)
+
+/**
+ * Start a coroutine on the current SPDK thread.
+ *
+ * The coroutine starts executing immediately and this function returns once it finishes or
+ * suspends itself for the first time.  Its stack is taken from a pool shared by all threads.
+ *
+ * \param fn Function to execute.
+ * \param ctx Context passed to fn.
+ *
+ * \return 0 on success, -EINVAL if not called from an SPDK thread, -ENOMEM if the coroutine
+ * couldn't be allocated.
+ */
+int spdk_coroutine_start(spdk_coroutine_fn fn, void *ctx);
+
+/**
+ * Get the coroutine that is currently executing.
+ *
+ * \return the current coroutine or NULL if not called from a coroutine.
+ */
+struct spdk_coroutine *spdk_coroutine_get_current(void);
+
+/**
+ * Suspend the current coroutine until spdk_coroutine_wake() is called.
+ *
+ * Must be called from a coroutine.
+ *
+ * \return status passed to spdk_coroutine_wake().
+ */
+int spdk_coroutine_await(void);
+
+/**
+ * Wake up a coroutine suspended in spdk_coroutine_await().  The coroutine is resumed from its
+ * thread's message queue.  Can be called from any thread, also before the coroutine suspends
+ * itself, e.g. if an operation completes immediately, but only once per each call to
+ * spdk_coroutine_await().
+ *
+ * \param co Coroutine to wake up.
+ * \param status Status to return from spdk_coroutine_await().
+ */
+void spdk_coroutine_wake(struct spdk_coroutine *co, int status);
+
+/**
+ * Completion callback waking up a coroutine, matching the signature of most of the SPDK
+ * completion callbacks, e.g. spdk_blob_op_complete.
+ *
+ * \param cb_arg Coroutine to wake up.
+ * \param status Status to return from spdk_coroutine_await().
+ */
+void spdk_coroutine_wake_cb(void *cb_arg, int status);
+
+/**
+ * Suspend the current coroutine, allowing the other messages and pollers of its thread to
+ * execute, and resume it afterwards.  Must be called from a coroutine.
+ */
+void spdk_coroutine_yield(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_COROUTINE_H */
@@ -50,6 +50,19 @@ uint32_t spdk_crc32c_update(const void *buf, size_t len, uint32_t crc);
  */
 uint32_t spdk_crc32c_iov_update(struct iovec *iov, int iovcnt, uint32_t crc32c);
 
+/**
+ * Calculate partial CRC-32C checksums of several independent data buffers.
+ *
+ * The buffers are checksummed in parallel lanes, which is considerably faster than
+ * updating each checksum in turn when the buffers are small.
+ *
+ * \param bufs Array of count data buffers to checksum.
+ * \param lens Array of count buffer lengths in bytes.
+ * \param crcs Array of count previous CRC-32C values, updated in place.
+ * \param count Number of buffers.
+ */
+void spdk_crc32c_update_multi(const void **bufs, const size_t *lens, uint32_t *crcs, int count);
+
 /**
  * Calculate a CRC-32C checksum, for NVMe Protection Information
  *
@@ -647,6 +647,25 @@ bool spdk_iommu_is_enabled(void);
  */
 uint64_t spdk_vtophys(const void *buf, uint64_t *size);
 
+/**
+ * Get the physical addresses of the pages spanned by a buffer, e.g. to build an NVMe PRP list.
+ *
+ * The first address is the one of buf itself, each following one is the address of the next
+ * page_size boundary within the buffer. Physically contiguous regions are translated only once.
+ *
+ * \param buf A pointer to a buffer.
+ * \param len Length of the buffer.
+ * \param page_size Size of the pages, a power of two not larger than 2MB.
+ * \param paddrs Array filled with the physical addresses.
+ * \param count Number of entries in paddrs.
+ *
+ * \return the number of addresses stored, which is less than the number of pages spanned by the
+ * buffer if paddrs is too small or a part of the buffer can't be translated, -EFAULT if the
+ * beginning of the buffer can't be translated or -EINVAL if page_size is invalid.
+ */
+int spdk_vtophys_pages(const void *buf, uint64_t len, uint64_t page_size, uint64_t *paddrs,
+		       uint32_t count);
+
 struct spdk_pci_addr {
 	uint32_t			domain;
 	uint8_t				bus;
@@ -856,6 +875,41 @@ int spdk_pci_device_disable_interrupt(struct spdk_pci_device *dev);
  */
 int spdk_pci_device_get_interrupt_efd(struct spdk_pci_device *dev);
 
+/**
+ * Enable multiple PCI device interrupt vectors. (Experimental)
+ *
+ * Vector 0 is still signaled on the event file descriptor returned by
+ * spdk_pci_device_get_interrupt_efd(), vectors 1 to efd_count each get their own event
+ * file descriptor. Only supported for devices bound to vfio with MSI-X or MSI.
+ *
+ * \param dev PCI device.
+ * \param efd_count Number of interrupt vectors in addition to vector 0.
+ *
+ * \return 0 on success, negative value on error.
+ */
+int spdk_pci_device_enable_interrupts(struct spdk_pci_device *dev, uint32_t efd_count);
+
+/**
+ * Disable the PCI device interrupt vectors enabled with spdk_pci_device_enable_interrupts().
+ * (Experimental)
+ *
+ * \param dev PCI device.
+ *
+ * \return 0 on success, negative value on error.
+ */
+int spdk_pci_device_disable_interrupts(struct spdk_pci_device *dev);
+
+/**
+ * Get the event file descriptor associated with a PCI device interrupt vector.
+ * (Experimental)
+ *
+ * \param dev PCI device.
+ * \param index Interrupt vector, 0 is the same as spdk_pci_device_get_interrupt_efd().
+ *
+ * \return Event file descriptor on success, negative value on error.
+ */
+int spdk_pci_device_get_interrupt_efd_by_index(struct spdk_pci_device *dev, uint32_t index);
+
 /**
  * Get the domain of a PCI device.
  *
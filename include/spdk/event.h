@@ -178,8 +178,15 @@ struct spdk_app_opts {
 	 * If non-NULL, a pointer to JSON RPC log file.
 	 */
 	FILE *rpc_log_file;
+
+	/**
+	 * Maximum number of JSON config entries executed at the same time.
+	 *
+	 * Default is 1, the entries are executed one after another.
+	 */
+	uint32_t json_config_max_parallel;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 236, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 240, "Incorrect size");
 
 /**
  * Initialize the default value of opts
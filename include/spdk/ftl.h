@@ -54,6 +54,16 @@ enum ftl_stats_type {
 	FTL_STATS_TYPE_MAX,
 };
 
+/* Policies of picking the bands to be garbage collected */
+enum spdk_ftl_gc_policy {
+	/* Pick the bands with the most invalid blocks */
+	SPDK_FTL_GC_POLICY_GREEDY = 0,
+	/* Weigh the space reclaimed against the cost of moving the valid blocks, favoring
+	 * bands which haven't been written for a long time (the data left is likely cold) */
+	SPDK_FTL_GC_POLICY_COST_BENEFIT,
+	SPDK_FTL_GC_POLICY_MAX,
+};
+
 struct ftl_stats {
 	/* Number of times write limits were triggered by FTL writers
 	 * (gc and compaction) dependent on number of free bands. GC starts at
@@ -69,6 +79,28 @@ struct ftl_stats {
 	uint64_t		io_activity_total;
 
 	struct ftl_stats_entry	entries[FTL_STATS_TYPE_MAX];
+
+	/* Garbage collection victims picked by the configured policy */
+	struct {
+		/* See spdk_ftl_gc_policy enum for possible values */
+		uint32_t	policy;
+		/* Number of bands picked for relocation */
+		uint64_t	bands;
+		/* Number of valid blocks left in these bands at the time they were picked */
+		uint64_t	valid_blocks;
+	} gc;
+
+	/* L2P cache page lookups */
+	struct {
+		/* Number of pages found in the cache (including ones still being loaded) */
+		uint64_t	hits;
+		/* Number of pages which had to be loaded */
+		uint64_t	misses;
+		/* Number of pages loaded ahead of sequential accesses */
+		uint64_t	prefetches;
+		/* Number of prefetched pages which were accessed afterwards */
+		uint64_t	prefetch_hits;
+	} l2p_cache;
 };
 
 typedef void (*spdk_ftl_stats_fn)(struct ftl_stats *stats, void *cb_arg);
@@ -111,8 +143,8 @@ struct spdk_ftl_conf {
 		uint32_t			chunk_free_target;
 	} nv_cache;
 
-	/* Hole at bytes 0x60 - 0x67. */
-	uint8_t					reserved[4];
+	/* Policy of picking bands for garbage collection, see spdk_ftl_gc_policy enum */
+	uint32_t				gc_policy;
 
 	/* Name of base block device (zoned or non-zoned) */
 	char					*base_bdev;
@@ -123,8 +155,11 @@ struct spdk_ftl_conf {
 	/* Enable fast shutdown path */
 	bool					fast_shutdown;
 
-	/* Hole at bytes 0x79 - 0x7f. */
-	uint8_t					reserved2[7];
+	/* Write full, aligned transfers directly to the base device, bypassing the NV cache */
+	bool					nv_cache_bypass;
+
+	/* Hole at bytes 0x7a - 0x7f. */
+	uint8_t					reserved2[6];
 
 	/*
 	 * The size of spdk_ftl_conf according to the caller of this library is used for ABI
@@ -236,6 +271,24 @@ int spdk_ftl_conf_copy(struct spdk_ftl_conf *dst, const struct spdk_ftl_conf *sr
  */
 void spdk_ftl_conf_deinit(struct spdk_ftl_conf *conf);
 
+/**
+ * Get the name of a garbage collection policy.
+ *
+ * \param policy Garbage collection policy.
+ *
+ * \return Name of the policy or NULL if the policy is invalid.
+ */
+const char *spdk_ftl_gc_policy_get_name(enum spdk_ftl_gc_policy policy);
+
+/**
+ * Get a garbage collection policy by its name.
+ *
+ * \param name Name of the policy ("greedy" or "cost_benefit").
+ *
+ * \return Garbage collection policy or SPDK_FTL_GC_POLICY_MAX if the name is unknown.
+ */
+enum spdk_ftl_gc_policy spdk_ftl_gc_policy_from_name(const char *name);
+
 /**
  * Initialize FTL configuration structure with default values.
  *
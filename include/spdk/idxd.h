@@ -19,6 +19,8 @@ extern "C" {
 
 #include "spdk/env.h"
 
+struct spdk_dif_ctx;
+
 /* The following flags control the behavior of I/O operations to IDXD. These flags
  * are often mapped to DSA specification values to ensure they have a unique value,
  * but do not necessarily correspond 1:1 with the hardware-defined flags.
@@ -253,6 +255,63 @@ int spdk_idxd_submit_copy_crc32c(struct spdk_idxd_io_channel *chan,
 				 uint32_t seed, uint32_t *crc_dst, int flags,
 				 spdk_idxd_req_cb cb_fn, void *cb_arg);
 
+/**
+ * Build and submit a DIF check request.
+ *
+ * This function will build the DIF check descriptors and then immediately submit
+ * by writing to the proper device portal.  Only 8 bytes of interleaved metadata holding
+ * a 16-bit guard are supported, with a data block size of 512, 520, 4096 or 4104 bytes.
+ * Each element of siov must hold a whole number of blocks.
+ *
+ * \param chan IDXD channel to submit request.
+ * \param siov Source iovec describing the extended LBA payload.
+ * \param siovcnt Number of elements in siov
+ * \param num_blocks Number of blocks to check.
+ * \param ctx DIF context.
+ * \param flags Flags, optional flags that can vary per operation.
+ * \param cb_fn Callback function which will be called when the request is complete.
+ * A DIF error is reported with -EIO.
+ * \param cb_arg Opaque value which will be passed back as the cb_arg parameter
+ * in the completion callback.
+ *
+ * \return 0 on success, -EOPNOTSUPP if the DIF format or the buffer layout can't be
+ * handled by the device, other negative errno on failure.
+ */
+int spdk_idxd_submit_dif_check(struct spdk_idxd_io_channel *chan,
+			       struct iovec *siov, size_t siovcnt,
+			       uint32_t num_blocks, const struct spdk_dif_ctx *ctx, int flags,
+			       spdk_idxd_req_cb cb_fn, void *cb_arg);
+
+/**
+ * Build and submit a DIF insert request.
+ *
+ * This function will build the DIF insert descriptors and then immediately submit
+ * by writing to the proper device portal.  The data blocks are copied from siov to diov,
+ * followed by the generated protection information.  The same DIF formats as for
+ * spdk_idxd_submit_dif_check() are supported and the DIF context has to enable the guard,
+ * application tag and reference tag.
+ *
+ * \param chan IDXD channel to submit request.
+ * \param diov Destination iovec, receiving the extended LBA payload.
+ * \param diovcnt Number of elements in diov
+ * \param siov Source iovec, holding the data blocks.
+ * \param siovcnt Number of elements in siov
+ * \param num_blocks Number of blocks to copy.
+ * \param ctx DIF context.
+ * \param flags Flags, optional flags that can vary per operation.
+ * \param cb_fn Callback function which will be called when the request is complete.
+ * \param cb_arg Opaque value which will be passed back as the cb_arg parameter
+ * in the completion callback.
+ *
+ * \return 0 on success, -EOPNOTSUPP if the DIF format or the buffer layout can't be
+ * handled by the device, other negative errno on failure.
+ */
+int spdk_idxd_submit_dif_insert(struct spdk_idxd_io_channel *chan,
+				struct iovec *diov, size_t diovcnt,
+				struct iovec *siov, size_t siovcnt,
+				uint32_t num_blocks, const struct spdk_dif_ctx *ctx, int flags,
+				spdk_idxd_req_cb cb_fn, void *cb_arg);
+
 /**
  * Build and submit an IAA memory compress request.
  *
@@ -277,6 +336,112 @@ int spdk_idxd_submit_compress(struct spdk_idxd_io_channel *chan,
 			      struct iovec *siov, uint32_t siovcnt, uint32_t *output_size,
 			      int flags, spdk_idxd_req_cb cb_fn, void *cb_arg);
 
+/** Number of literal/length symbols in a deflate Huffman table */
+#define SPDK_IDXD_HUFFMAN_LL_SYMBOLS	286
+/** Number of distance symbols in a deflate Huffman table */
+#define SPDK_IDXD_HUFFMAN_D_SYMBOLS	30
+
+/**
+ * Number of occurrences of each deflate symbol in some data, as gathered by
+ * spdk_idxd_submit_compress_stats().
+ */
+struct spdk_idxd_huffman_histogram {
+	uint32_t ll[SPDK_IDXD_HUFFMAN_LL_SYMBOLS];
+	uint32_t d[SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+};
+
+/**
+ * Huffman table used by IAA to compress data with a dynamic deflate block.
+ */
+struct spdk_idxd_huffman_table;
+
+/**
+ * Allocate a Huffman table.  The table must be built with
+ * spdk_idxd_huffman_table_build() before it can be used for compression.
+ *
+ * \return Pointer to the table, or NULL on failure.
+ */
+struct spdk_idxd_huffman_table *spdk_idxd_huffman_table_alloc(void);
+
+/**
+ * Free a Huffman table.
+ *
+ * \param table Table to free.
+ */
+void spdk_idxd_huffman_table_free(struct spdk_idxd_huffman_table *table);
+
+/**
+ * Build a Huffman table suited to compress data with the given symbol distribution.
+ *
+ * \param table Table to build.
+ * \param hist Histogram of the data.
+ * \param complete Assign a code to every symbol, even the ones not present in the
+ * histogram.  This must be set if the table is going to be used to compress data other
+ * than the one the histogram was gathered from (canned table).
+ *
+ * \return 0 on success, -EINVAL if the deflate block header describing the table doesn't
+ * fit in the space provided by the hardware.
+ */
+int spdk_idxd_huffman_table_build(struct spdk_idxd_huffman_table *table,
+				  const struct spdk_idxd_huffman_histogram *hist, bool complete);
+
+/**
+ * Get the histogram written to a table by spdk_idxd_submit_compress_stats().
+ *
+ * \param table Table passed to spdk_idxd_submit_compress_stats().
+ * \param hist Histogram to fill.
+ */
+void spdk_idxd_huffman_table_get_histogram(const struct spdk_idxd_huffman_table *table,
+		struct spdk_idxd_huffman_histogram *hist);
+
+/**
+ * Build and submit an IAA request gathering the statistics of the deflate symbols
+ * in the source data, without producing any output.  This is the first pass of a
+ * two-pass dynamic Huffman compression.  Once the request completes successfully,
+ * the histogram can be retrieved using spdk_idxd_huffman_table_get_histogram().
+ *
+ * \param chan IDXD channel to submit request.
+ * \param siov Source iovec
+ * \param siovcnt Number of elements in siov
+ * \param table Table to write the histogram to.  It must not be in use by any other
+ * request until this request is completed.
+ * \param flags Flags, optional flags that can vary per operation.
+ * \param cb_fn Callback function which will be called when the request is complete.
+ * \param cb_arg Opaque value which will be passed back as the arg parameter in
+ * the completion callback.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_idxd_submit_compress_stats(struct spdk_idxd_io_channel *chan,
+				    struct iovec *siov, uint32_t siovcnt,
+				    struct spdk_idxd_huffman_table *table,
+				    int flags, spdk_idxd_req_cb cb_fn, void *cb_arg);
+
+/**
+ * Build and submit an IAA memory compress request using a Huffman table built by
+ * spdk_idxd_huffman_table_build().  The data is written as a single dynamic deflate
+ * block, so it can be decompressed without the table.
+ *
+ * \param chan IDXD channel to submit request.
+ * \param dst Destination to write the compressed data to.
+ * \param nbytes Length in bytes. The dst buffer should be large enough to hold the compressed data.
+ * \param siov Source iovec
+ * \param siovcnt Number of elements in siov
+ * \param output_size The size of the compressed data
+ * \param table Huffman table to use.  If NULL, the fixed Huffman table is used.
+ * \param flags Flags, optional flags that can vary per operation.
+ * \param cb_fn Callback function which will be called when the request is complete.
+ * \param cb_arg Opaque value which will be passed back as the arg parameter in
+ * the completion callback.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_idxd_submit_compress_table(struct spdk_idxd_io_channel *chan,
+				    void *dst, uint64_t nbytes,
+				    struct iovec *siov, uint32_t siovcnt, uint32_t *output_size,
+				    const struct spdk_idxd_huffman_table *table,
+				    int flags, spdk_idxd_req_cb cb_fn, void *cb_arg);
+
 /**
  * Build and submit an IAA memory decompress request.
  *
@@ -327,6 +492,25 @@ int spdk_idxd_submit_raw_desc(struct spdk_idxd_io_channel *chan,
  */
 int spdk_idxd_process_events(struct spdk_idxd_io_channel *chan);
 
+/**
+ * Submit the descriptors gathered in the channel's open batch.
+ *
+ * Requests submitted on a channel are collected into a single batch descriptor,
+ * which is written to the device portal once it fills up, when
+ * spdk_idxd_process_events() is called, or when this function is called.
+ * Callers that submit requests from outside of their completion poller can use
+ * it to avoid waiting for the next call to spdk_idxd_process_events().
+ *
+ * On a shared work queue, descriptors the device rejected because the queue was
+ * full are resubmitted first.
+ *
+ * \param chan IDXD channel to flush.
+ * \return number of requests submitted to the device, or -EBUSY if there were
+ * no resources to submit the batch, in which case it is kept open and retried
+ * on the next flush.
+ */
+int spdk_idxd_flush(struct spdk_idxd_io_channel *chan);
+
 /**
  * Returns an IDXD channel for a given IDXD device.
  *
@@ -342,6 +526,16 @@ struct spdk_idxd_io_channel *spdk_idxd_get_channel(struct spdk_idxd_device *idxd
  */
 void spdk_idxd_put_channel(struct spdk_idxd_io_channel *chan);
 
+/**
+ * Check whether an IDXD channel has requests that have not completed yet.
+ *
+ * A channel may only be released with spdk_idxd_put_channel() once this returns false.
+ *
+ * \param chan IDXD channel to check.
+ * \return true if requests are outstanding or gathered in an open batch, false otherwise.
+ */
+bool spdk_idxd_has_outstanding(struct spdk_idxd_io_channel *chan);
+
 #ifdef __cplusplus
 }
 #endif
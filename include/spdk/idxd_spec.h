@@ -39,6 +39,8 @@ extern "C" {
 #define IDXD_FLAG_CRC_READ_CRC_SEED	(1 << 16)
 
 #define IAA_FLAG_RD_SRC2_AECS		(1 << 16)
+#define IAA_FLAG_WR_SRC2_AECS_COMPL	(1 << 18)
+#define IAA_COMP_STATS_MODE		(1 << 0)
 #define IAA_COMP_FLUSH_OUTPUT		(1 << 1)
 #define IAA_COMP_APPEND_EOB		(1 << 2)
 #define IAA_COMP_FLAGS			(IAA_COMP_FLUSH_OUTPUT | IAA_COMP_APPEND_EOB)
@@ -51,6 +53,31 @@ extern "C" {
 					IAA_DECOMP_CHECK_FOR_EOB | \
 					IAA_DECOMP_STOP_ON_EOB)
 
+#define IDXD_DIF_FLAG_INVERT_CRC_RESULT			(1 << 3)
+#define IDXD_DIF_FLAG_INVERT_CRC_SEED			(1 << 2)
+#define IDXD_DIF_FLAG_DIF_BLOCK_SIZE_512		0x0
+#define IDXD_DIF_FLAG_DIF_BLOCK_SIZE_520		0x1
+#define IDXD_DIF_FLAG_DIF_BLOCK_SIZE_4096		0x2
+#define IDXD_DIF_FLAG_DIF_BLOCK_SIZE_4104		0x3
+
+#define IDXD_DIF_SOURCE_FLAG_REF_TAG_TYPE		(1 << 7)
+#define IDXD_DIF_SOURCE_FLAG_REF_TAG_CHECK_DISABLE	(1 << 6)
+#define IDXD_DIF_SOURCE_FLAG_GUARD_CHECK_DISABLE	(1 << 5)
+#define IDXD_DIF_SOURCE_FLAG_APP_TAG_TYPE		(1 << 4)
+#define IDXD_DIF_SOURCE_FLAG_APP_TAG_F_DETECT		(1 << 3)
+#define IDXD_DIF_SOURCE_FLAG_APP_AND_REF_TAG_F_DETECT	(1 << 2)
+#define IDXD_DIF_SOURCE_FLAG_ALL_F_DETECT		(1 << 1)
+#define IDXD_DIF_SOURCE_FLAG_ENABLE_ALL_F_DETECT_ERR	(1 << 0)
+
+#define IDXD_DIF_DEST_FLAG_REF_TAG_TYPE			(1 << 7)
+#define IDXD_DIF_DEST_FLAG_REF_TAG_PASS			(1 << 6)
+#define IDXD_DIF_DEST_FLAG_GUARD_PASS			(1 << 5)
+#define IDXD_DIF_DEST_FLAG_APP_TAG_TYPE			(1 << 4)
+#define IDXD_DIF_DEST_FLAG_APP_TAG_PASS			(1 << 3)
+
+/* Size of the protection information handled by the DIF operations */
+#define IDXD_DIF_PI_SIZE				8
+
 /*
  * IDXD is a family of devices, DSA and IAA.
  */
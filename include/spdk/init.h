@@ -86,6 +86,24 @@ void spdk_subsystem_init_from_json_config(const char *json_config_file, const ch
 		spdk_subsystem_init_fn cb_fn, void *cb_arg,
 		bool stop_on_error);
 
+/**
+ * Like spdk_subsystem_init_from_json_config, but allow executing up to max_parallel config
+ * entries at the same time. Entries of a subsystem that refer to different objects (e.g. bdevs
+ * or NVMe-oF subsystems with different names) run concurrently, the others keep the order from
+ * the config file. Subsystems are still configured one after another.
+ *
+ * \param json_config_file Path to a JSON config file.
+ * \param rpc_addr Path to a unix domain socket to send configuration RPCs to.
+ * \param max_parallel Maximum number of config entries executed at the same time. 0 or 1 loads
+ * the entries in sequence.
+ * \param cb_fn Function called when the process is complete.
+ * \param cb_arg User context passed to cb_fn.
+ * \param stop_on_error Whether to stop initialization if one of the JSON RPCs fails.
+ */
+void spdk_subsystem_init_from_json_config_ext(const char *json_config_file, const char *rpc_addr,
+		uint32_t max_parallel, spdk_subsystem_init_fn cb_fn, void *cb_arg,
+		bool stop_on_error);
+
 typedef void (*spdk_subsystem_fini_fn)(void *ctx);
 
 /**
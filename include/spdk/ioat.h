@@ -109,6 +109,32 @@ int spdk_ioat_build_copy(struct spdk_ioat_chan *chan,
 			 void *cb_arg, spdk_ioat_req_cb cb_fn,
 			 void *dst, const void *src, uint64_t nbytes);
 
+/**
+ * Build a DMA engine memory copy request between two scatter-gather lists.
+ *
+ * This function will build a chain of descriptors in the channel's ring, one
+ * for each physically contiguous piece of the source and destination buffers,
+ * and the callback will be called once all of them are complete.  The caller
+ * must also explicitly call spdk_ioat_flush to submit the descriptors, possibly
+ * after building additional descriptors.
+ *
+ * \param chan I/OAT channel to build request.
+ * \param cb_arg Opaque value which will be passed back as the arg parameter in
+ * the completion callback.
+ * \param cb_fn Callback function which will be called when the request is complete.
+ * \param diov Destination I/O vector.
+ * \param diovcnt Number of elements in diov.
+ * \param siov Source I/O vector. Must describe the same number of bytes as diov.
+ * \param siovcnt Number of elements in siov.
+ *
+ * \return 0 on success, -ENOMEM if the ring doesn't have enough free descriptors,
+ * or another negative errno on failure.
+ */
+int spdk_ioat_build_copyv(struct spdk_ioat_chan *chan,
+			  void *cb_arg, spdk_ioat_req_cb cb_fn,
+			  struct iovec *diov, uint32_t diovcnt,
+			  struct iovec *siov, uint32_t siovcnt);
+
 /**
  * Build and submit a DMA engine memory copy request.
  *
@@ -171,6 +171,26 @@ struct spdk_json_write_ctx *spdk_jsonrpc_begin_result(struct spdk_jsonrpc_reques
  */
 void spdk_jsonrpc_end_result(struct spdk_jsonrpc_request *request, struct spdk_json_write_ctx *w);
 
+/**
+ * Send the part of a response written so far.
+ *
+ * Handlers producing large results can call this function between parts of
+ * the result to have them sent while the rest is being written, instead of
+ * building the whole response in memory. The flushed data is sent by the
+ * server poll, so the handler must yield for the data to make progress.
+ * spdk_jsonrpc_end_result() still has to be called to complete the response.
+ *
+ * \param request Request whose response is being written.
+ *
+ * \return 0 on success, or negated errno code:
+ *  -EAGAIN too much data is waiting to be sent. The data was queued, but the
+ *          handler should yield and call this function again before writing more.
+ *  -ENOTCONN the connection was closed. The handler should stop writing the result
+ *            and call spdk_jsonrpc_end_result().
+ *  -ENOMEM failed to allocate memory for the data.
+ */
+int spdk_jsonrpc_flush(struct spdk_jsonrpc_request *request);
+
 /**
  * Complete a JSON-RPC response and write bool result.
  *
@@ -373,6 +373,34 @@ void spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void
  */
 void spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Decouple all the clones of a snapshot but one, so that the snapshot can be deleted by moving its
+ * clusters to the remaining clone, without copying them.  The clone sharing the most clusters with
+ * the snapshot is kept, while the clusters shared with the other clones are copied to them, one
+ * clone at a time.
+ *
+ * \param snapshot Handle to the snapshot lvol
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_decouple_clones(struct spdk_lvol *snapshot, spdk_lvol_op_complete cb_fn,
+			       void *cb_arg);
+
+/**
+ * Copy the clusters of a read only lvol to an external device, see spdk_bs_blob_shallow_copy().
+ *
+ * \param lvol Handle to the read only lvol, e.g. a snapshot
+ * \param base Handle to an older snapshot in the chain of lvol whose clusters were already
+ * copied, NULL to copy all the clusters allocated in the chain
+ * \param ext_dev The device to copy the lvol to
+ * \param queue_depth Maximum number of clusters copied in parallel
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_lvol *base,
+			    struct spdk_bs_dev *ext_dev, uint32_t queue_depth,
+			    spdk_lvol_op_complete cb_fn, void *cb_arg);
+
 /**
  * Determine if an lvol is degraded. A degraded lvol cannot perform IO.
  *
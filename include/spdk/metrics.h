@@ -0,0 +1,180 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/** \file
+ * Metrics exported in the OpenMetrics text format
+ *
+ * The libraries register groups of metrics sharing the same label (e.g. all the metrics of a
+ * bdev, labeled with its name) and update them from their I/O paths.  Each group keeps one
+ * slot of values per core, so that the updates are neither locked nor contended.  The slots
+ * are summed up when the metrics are rendered, on request of a scraper connected to the
+ * exporter thread.
+ *
+ * The functions registering and updating the metrics are part of the util library, so that any
+ * library can be instrumented without depending on the metrics library.  They forward to a
+ * provider, which the metrics library sets when the metrics are enabled.
+ */
+
+#ifndef SPDK_METRICS_H
+#define SPDK_METRICS_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of buckets of a histogram, not counting the implicit +Inf bucket */
+#define SPDK_METRICS_MAX_BUCKETS	32
+
+enum spdk_metric_type {
+	/** Monotonically increasing value, exported with a "_total" suffix */
+	SPDK_METRIC_TYPE_COUNTER,
+	/** Value that can go up and down */
+	SPDK_METRIC_TYPE_GAUGE,
+	/** Distribution of the observed values */
+	SPDK_METRIC_TYPE_HISTOGRAM,
+};
+
+/**
+ * Description of a metric.  The descriptions are expected to be static: they're referenced,
+ * not copied, by the groups using them.
+ */
+struct spdk_metric_desc {
+	/** Name of the metric family, e.g. "spdk_bdev_read_ops" */
+	const char		*name;
+	/** Description of the metric, exported as its HELP */
+	const char		*help;
+	enum spdk_metric_type	type;
+	/** Histograms only: upper bounds of the buckets, in increasing order */
+	const uint64_t		*buckets;
+	/** Histograms only: number of entries of the buckets array */
+	uint32_t		num_buckets;
+};
+
+struct spdk_metrics_group;
+
+/** Implementation of the metrics, see spdk_metrics_set_provider() */
+struct spdk_metrics_provider {
+	struct spdk_metrics_group *(*group_register)(const struct spdk_metric_desc *descs,
+			uint32_t num_descs, const char *label_name, const char *label_value);
+	void (*group_unregister)(struct spdk_metrics_group *group);
+	void (*counter_add)(struct spdk_metrics_group *group, uint32_t idx, uint64_t value);
+	void (*gauge_add)(struct spdk_metrics_group *group, uint32_t idx, int64_t value);
+	void (*histogram_observe)(struct spdk_metrics_group *group, uint32_t idx, uint64_t value);
+};
+
+/**
+ * Set the provider implementing the metrics.  Until a provider is set,
+ * spdk_metrics_group_register() doesn't register anything.  The provider can't be changed
+ * once set.
+ *
+ * \param provider Provider of the metrics.  It is referenced, not copied.
+ */
+void spdk_metrics_set_provider(const struct spdk_metrics_provider *provider);
+
+/**
+ * Enable the metrics, setting the metrics library as their provider.  Until this is called,
+ * spdk_metrics_group_register() doesn't register anything, so that the libraries don't pay for
+ * the metrics that nobody will scrape.  This is expected to be called before the libraries are
+ * initialized.
+ */
+void spdk_metrics_enable(void);
+
+/**
+ * Check whether the metrics are enabled.
+ *
+ * \return true if a metrics provider is set, false otherwise.
+ */
+bool spdk_metrics_enabled(void);
+
+/**
+ * Register a group of metrics.  All the groups registered with the same descriptions are
+ * exported as the same metric families, and have to use different label values.
+ *
+ * \note This function is thread safe.
+ *
+ * \param descs Descriptions of the metrics of the group.
+ * \param num_descs Number of entries of the descs array.
+ * \param label_name Name of the label identifying the group, e.g. "bdev".  May be NULL
+ * for a group without label.
+ * \param label_value Value of the label, e.g. the name of the bdev.
+ *
+ * \return The group, or NULL if the metrics aren't enabled or the group couldn't be allocated.
+ */
+struct spdk_metrics_group *spdk_metrics_group_register(const struct spdk_metric_desc *descs,
+		uint32_t num_descs, const char *label_name, const char *label_value);
+
+/**
+ * Unregister a group of metrics.  The group must not be updated anymore.
+ *
+ * \note This function is thread safe.
+ *
+ * \param group Group to unregister.  May be NULL.
+ */
+void spdk_metrics_group_unregister(struct spdk_metrics_group *group);
+
+/**
+ * Add a value to a counter.
+ *
+ * \param group Group of the counter.
+ * \param idx Index of the counter in the descriptions of the group.
+ * \param value Value to add.
+ */
+void spdk_metrics_counter_add(struct spdk_metrics_group *group, uint32_t idx, uint64_t value);
+
+/**
+ * Add a (possibly negative) value to a gauge.  A gauge may be incremented and decremented
+ * from different cores.
+ *
+ * \param group Group of the gauge.
+ * \param idx Index of the gauge in the descriptions of the group.
+ * \param value Value to add.
+ */
+void spdk_metrics_gauge_add(struct spdk_metrics_group *group, uint32_t idx, int64_t value);
+
+/**
+ * Add an observation to a histogram.
+ *
+ * \param group Group of the histogram.
+ * \param idx Index of the histogram in the descriptions of the group.
+ * \param value Observed value.
+ */
+void spdk_metrics_histogram_observe(struct spdk_metrics_group *group, uint32_t idx,
+				    uint64_t value);
+
+/**
+ * Render all the registered metrics in the OpenMetrics text format, terminated by "# EOF".
+ *
+ * \note This function is thread safe.
+ *
+ * \param buf Set to the rendered metrics, to be released with free().
+ * \param len Set to the length of the rendered metrics, not counting the terminating NUL.
+ *
+ * \return 0 on success, -ENOMEM if the buffer couldn't be allocated.
+ */
+int spdk_metrics_render(char **buf, size_t *len);
+
+/**
+ * Start the thread serving the metrics over HTTP, at the "/metrics" path.  The thread isn't
+ * an SPDK thread and doesn't run on the reactors' cores.
+ *
+ * \param address IP address to listen on.
+ * \param port TCP port to listen on.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_metrics_exporter_start(const char *address, uint16_t port);
+
+/**
+ * Stop the thread serving the metrics, if started.
+ */
+void spdk_metrics_exporter_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_METRICS_H */
@@ -10,6 +10,9 @@
 #ifndef SPDK_NBD_H_
 #define SPDK_NBD_H_
 
+#include "spdk/stdinc.h"
+#include "spdk/assert.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,6 +55,39 @@ typedef void (*spdk_nbd_start_cb)(void *cb_arg, struct spdk_nbd_disk *nbd,
 void spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		    spdk_nbd_start_cb cb_fn, void *cb_arg);
 
+struct spdk_nbd_start_opts {
+	/**
+	 * The size of this structure according to the caller of this library is used for ABI
+	 * compatibility. The library uses this field to know how many fields in this structure are
+	 * valid. And the library will populate any remaining fields with default values.
+	 * New added fields should be put at the end of the struct.
+	 */
+	size_t opts_size;
+
+	/**
+	 * Number of connections (sockets) between the kernel and the network block device.
+	 * Each of them is served by its own SPDK thread, spread over the cores. The kernel
+	 * distributes the requests over its hardware queues, one per connection. 0 means 1.
+	 */
+	uint32_t num_connections;
+
+	uint8_t reserved[4];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nbd_start_opts) == 16, "Incorrect size");
+
+/**
+ * Start a network block device backed by the bdev.
+ *
+ * \param bdev_name Name of bdev exposed as a network block device.
+ * \param nbd_path Path to the registered network block device.
+ * \param opts Options for the network block device, NULL for the defaults.
+ * \param cb_fn Callback to be always called.
+ * \param cb_arg Passed to cb_fn.
+ */
+void spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path,
+			const struct spdk_nbd_start_opts *opts,
+			spdk_nbd_start_cb cb_fn, void *cb_arg);
+
 /**
  * Stop the running network block device safely.
  *
@@ -60,8 +60,16 @@ struct spdk_nvme_ctrlr_opts {
 	 */
 	bool no_shn_notification;
 
-	/* Hole at bytes 6-7. */
-	uint8_t	reserved6[2];
+	/**
+	 * Enable interrupts for the I/O qpairs, see spdk_nvme_qpair_get_fd() and
+	 * spdk_nvme_poll_group_get_fd(). Only supported by the PCIe transport for devices bound
+	 * to vfio with MSI-X. The option is cleared if the interrupts could not be enabled.
+	 * (Experimental)
+	 */
+	bool enable_interrupts;
+
+	/* Hole at byte 7. */
+	uint8_t	reserved7[1];
 
 	/**
 	 * Type of arbitration mechanism
@@ -1578,8 +1586,18 @@ struct spdk_nvme_io_qpair_opts {
 		bool delay_pcie_doorbell;
 	};
 
-	/* Hole at bytes 13-15. */
-	uint8_t reserved13[3];
+	/**
+	 * Place the submission queue of this qpair in the controller memory buffer. If the
+	 * controller does not support SQs in the CMB, or there isn't enough CMB space left,
+	 * the SQ is silently allocated in host memory instead. Use spdk_nvme_qpair_is_sq_in_cmb()
+	 * to find out where it ended up. Only valid for PCIe controllers.
+	 *
+	 * Defaults to the use_cmb_sqs controller option.
+	 */
+	bool use_cmb_sq;
+
+	/* Hole at bytes 14-15. */
+	uint8_t reserved14[2];
 
 	/**
 	 * These fields allow specifying the memory buffers for the submission and/or
@@ -1622,10 +1640,52 @@ struct spdk_nvme_io_qpair_opts {
 	 */
 	bool async_mode;
 
-	/* Hole at bytes 66-71. */
-	uint8_t reserved66[6];
+	/**
+	 * When delay_cmd_submit is set, ring the submission queue doorbell as soon as this
+	 * many commands are waiting for it, instead of only in
+	 * spdk_nvme_qpair_process_completions(). 0 (default) means no limit.
+	 *
+	 * This only applies to PCIe transport.
+	 */
+	uint16_t sq_doorbell_batch;
+
+	/**
+	 * Only write the completion queue head doorbell once this many completions were
+	 * processed since the last write, or when the queue pair has no more completions.
+	 * The value is capped by the number of completions processed per poll. 0 (default)
+	 * writes the doorbell in every poll that processed completions.
+	 *
+	 * This only applies to PCIe transport.
+	 */
+	uint16_t cq_doorbell_batch;
+
+	/**
+	 * Number of connections the qpair is striped across. The returned qpair then stands
+	 * for num_connections queues, each with its own connection to the controller, and
+	 * I/O submitted to it is spread over the connected queues in a round-robin fashion.
+	 * The queues are connected, disconnected, added to a poll group and freed together
+	 * with the returned qpair. 0 or 1 (default) creates a single queue.
+	 *
+	 * This only applies to fabrics transports.
+	 */
+	uint16_t num_connections;
+
+	/**
+	 * Number of requests reserved for the children of I/Os that need to be split, e.g. on
+	 * the maximum transfer size or stripe boundaries. When non-zero, children are only taken
+	 * from this reserve instead of from the io_queue_requests pool, and a split I/O fails
+	 * with -ENOMEM up front if the reserve cannot cover all of its children. 0 (default)
+	 * takes children from io_queue_requests.
+	 */
+	uint32_t io_queue_child_requests;
+
+	/**
+	 * Size of the submission ring used by spdk_nvme_qpair_send_msg() to let other threads
+	 * share this qpair. 0 (default) doesn't create the ring.
+	 */
+	uint32_t submit_ring_size;
 };
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_io_qpair_opts) == 72, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_io_qpair_opts) == 80, "Incorrect size");
 
 /**
  * Get the default options for I/O qpair creation for a specific NVMe controller.
@@ -2692,6 +2752,47 @@ int spdk_nvme_poll_group_add(struct spdk_nvme_poll_group *group, struct spdk_nvm
  */
 int spdk_nvme_poll_group_remove(struct spdk_nvme_poll_group *group, struct spdk_nvme_qpair *qpair);
 
+/**
+ * Get a file descriptor that becomes readable when any of the qpairs in the poll group,
+ * which have an interrupt, has new completions. The file descriptor can be added to an
+ * spdk_fd_group, whose callback should then call spdk_nvme_poll_group_wait().
+ *
+ * Qpairs without an interrupt (see spdk_nvme_qpair_get_fd()) are still processed in
+ * spdk_nvme_poll_group_wait(), but never wake the file descriptor up.
+ *
+ * \param group The group.
+ *
+ * \return File descriptor on success, negated errno on failure.
+ */
+int spdk_nvme_poll_group_get_fd(struct spdk_nvme_poll_group *group);
+
+/**
+ * Acknowledge the interrupts that made the file descriptor returned by
+ * spdk_nvme_poll_group_get_fd() readable, and process the completions of all the qpairs
+ * in the group.
+ *
+ * If hybrid polling was enabled with spdk_nvme_poll_group_set_hybrid_poll(), keep polling
+ * the group until no completion was found for that long, to save the interrupt latency for
+ * back-to-back I/O.
+ *
+ * \param group The group.
+ * \param disconnected_qpair_cb A callback function of type spdk_nvme_disconnected_qpair_cb.
+ *
+ * \return Number of completions processed on success, negated errno on failure.
+ */
+int64_t spdk_nvme_poll_group_wait(struct spdk_nvme_poll_group *group,
+				  spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb);
+
+/**
+ * Set how long spdk_nvme_poll_group_wait() keeps polling the group after the last completion
+ * before returning, so that the caller goes back to wait for an interrupt.
+ *
+ * \param group The group.
+ * \param hybrid_poll_us Polling window in microseconds, 0 (default) disables hybrid polling.
+ */
+void spdk_nvme_poll_group_set_hybrid_poll(struct spdk_nvme_poll_group *group,
+		uint32_t hybrid_poll_us);
+
 /**
  * Destroy an empty poll group.
  *
@@ -3905,6 +4006,29 @@ void spdk_nvme_qpair_print_completion(struct spdk_nvme_qpair *qpair,
  */
 uint16_t spdk_nvme_qpair_get_id(struct spdk_nvme_qpair *qpair);
 
+/**
+ * Check whether the submission queue of the specified qpair was placed in the controller
+ * memory buffer.
+ *
+ * \param qpair Pointer to the NVMe queue pair.
+ * \return true if the SQ resides in the CMB, false if it resides in host memory or the qpair
+ * does not belong to a PCIe controller.
+ */
+bool spdk_nvme_qpair_is_sq_in_cmb(struct spdk_nvme_qpair *qpair);
+
+/**
+ * Get the event file descriptor signaled by the completion interrupt of the specified qpair.
+ *
+ * The controller must have been attached with the enable_interrupts option. The file
+ * descriptor is only valid in the primary process.
+ *
+ * \param qpair Pointer to the NVMe I/O queue pair.
+ * \return Event file descriptor on success, negated errno on failure. -ENOTSUP if the qpair
+ * has no interrupt, e.g. because it is the admin queue, the transport doesn't support
+ * interrupts or there are not enough interrupt vectors.
+ */
+int spdk_nvme_qpair_get_fd(struct spdk_nvme_qpair *qpair);
+
 /**
  * Gets the number of outstanding requests for the specified qpair.
  *
@@ -3919,6 +4043,97 @@ uint16_t spdk_nvme_qpair_get_id(struct spdk_nvme_qpair *qpair);
  */
 uint32_t spdk_nvme_qpair_get_num_outstanding_reqs(struct spdk_nvme_qpair *qpair);
 
+/**
+ * Function executed by the thread processing the completions of a shared qpair.
+ *
+ * \param qpair The qpair the message was sent to.
+ * \param ctx Context passed with the message.
+ */
+typedef void (*spdk_nvme_qpair_msg_fn)(struct spdk_nvme_qpair *qpair, void *ctx);
+
+/**
+ * Message sent to a shared qpair. It is owned by the caller and must stay valid until
+ * its function was called.
+ */
+struct spdk_nvme_qpair_msg {
+	spdk_nvme_qpair_msg_fn			fn;
+	void					*ctx;
+};
+
+/**
+ * Send a message to a qpair created with a non-zero submit_ring_size.
+ *
+ * This function is thread safe and lock free. The message is queued in the multi-producer,
+ * single-consumer submission ring of the qpair, and its function is called by the thread
+ * processing the qpair completions, either with spdk_nvme_qpair_process_completions() or
+ * through the poll group of the qpair. This lets several threads share one qpair: the
+ * function submits the I/O, whose completion callback then also runs on the polling thread.
+ *
+ * \param qpair The shared qpair.
+ * \param msg Message to send.
+ *
+ * \return 0 on success, -ENOTSUP if the qpair has no submission ring, -ENOMEM if the ring
+ * is full.
+ */
+int spdk_nvme_qpair_send_msg(struct spdk_nvme_qpair *qpair, struct spdk_nvme_qpair_msg *msg);
+
+struct spdk_histogram_data;
+
+/**
+ * Classes of I/O commands tracked by separate latency histograms.
+ */
+enum spdk_nvme_latency_io_type {
+	/** Read commands */
+	SPDK_NVME_LATENCY_IO_READ = 0,
+
+	/** Write commands */
+	SPDK_NVME_LATENCY_IO_WRITE,
+
+	/** All other commands carrying a namespace ID */
+	SPDK_NVME_LATENCY_IO_OTHER,
+
+	SPDK_NVME_LATENCY_IO_NUM_TYPES,
+};
+
+/**
+ * Start tracking the latency of the commands completed on an I/O qpair.
+ *
+ * The latency of each command is measured in ticks from its submission to the qpair until its
+ * completion is processed, and is tallied in a histogram per namespace and per
+ * spdk_nvme_latency_io_type. Requests split by the driver are accounted once. The latency
+ * added above the driver is therefore not included.
+ *
+ * Tracking already enabled is left unchanged.
+ *
+ * \param qpair The I/O qpair.
+ *
+ * eturn 0 on success, -EINVAL for an admin qpair, -ENOMEM if memory could not be allocated.
+ */
+int spdk_nvme_qpair_enable_latency_tracking(struct spdk_nvme_qpair *qpair);
+
+/**
+ * Stop tracking the latency of the commands completed on an I/O qpair and free its histograms.
+ *
+ * \param qpair The I/O qpair.
+ */
+void spdk_nvme_qpair_disable_latency_tracking(struct spdk_nvme_qpair *qpair);
+
+/**
+ * Get the latency histogram of a namespace for one type of command.
+ *
+ * The histogram is owned by the qpair and updated when its completions are processed, so it
+ * must only be read from the thread polling the qpair.
+ *
+ * \param qpair The I/O qpair.
+ * \param nsid Namespace ID.
+ * \param type Type of the commands.
+ *
+ * eturn the histogram, in ticks, or NULL if latency tracking is disabled or no command of
+ * this type completed yet.
+ */
+const struct spdk_histogram_data *spdk_nvme_qpair_get_latency_histogram(
+	struct spdk_nvme_qpair *qpair, uint32_t nsid, enum spdk_nvme_latency_io_type type);
+
 /**
  * \brief Prints (SPDK_NOTICELOG) the contents of an NVMe submission queue entry (command).
  *
@@ -4193,6 +4408,8 @@ struct spdk_nvme_transport_ops {
 	int (*ctrlr_ready)(struct spdk_nvme_ctrlr *ctrlr);
 
 	volatile struct spdk_nvme_registers *(*ctrlr_get_registers)(struct spdk_nvme_ctrlr *ctrlr);
+
+	int (*qpair_get_fd)(struct spdk_nvme_qpair *qpair);
 };
 
 /**
@@ -4225,8 +4442,17 @@ struct spdk_nvme_transport_opts {
 	 */
 	uint32_t rdma_srq_size;
 
-	/* Hole at bytes 4-7. */
-	uint8_t reserved4[4];
+	/**
+	 * It is used for TCP transport.
+	 *
+	 * Receive the data of I/O qpairs directly into the buffers of the requests instead of
+	 * staging it in the receive pipe of the socket. This removes a copy of each C2H payload,
+	 * but costs an extra system call per PDU, so it pays off for large reads.
+	 */
+	bool tcp_zcopy_recv;
+
+	/* Hole at bytes 5-7. */
+	uint8_t reserved5[3];
 
 	/**
 	 * The size of spdk_nvme_transport_opts according to the caller of this library is used for ABI
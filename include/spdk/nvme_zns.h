@@ -392,6 +392,232 @@ int spdk_nvme_zns_ext_report_zones(struct spdk_nvme_ns *ns, struct spdk_nvme_qpa
 				   enum spdk_nvme_zns_zra_report_opts report_opts, bool partial_report,
 				   spdk_nvme_cmd_cb cb_fn, void *cb_arg);
 
+/**
+ * Zone manager.
+ *
+ * Caches the state and write pointer of every zone of a Zoned Namespace, so that they
+ * don't have to be queried with zone reports, and submits zone appends and zone
+ * management commands through a single I/O qpair. Appends to a zone that already has
+ * the maximum number of append commands outstanding are queued and merged into one
+ * larger command when one of them completes. Appends and explicit opens that would
+ * exceed the open or active zone limits of the namespace are rejected instead of
+ * letting the controller fail them.
+ *
+ * A zone manager is not thread safe, it must be used from the thread that owns its qpair.
+ */
+struct spdk_nvme_zns_zone_mgr;
+
+/**
+ * Zone manager options.
+ */
+struct spdk_nvme_zns_zone_mgr_opts {
+	/**
+	 * The size of spdk_nvme_zns_zone_mgr_opts according to the caller of this library is used
+	 * for ABI compatibility. The library uses this field to know how many fields in this
+	 * structure are valid. And the library will populate any remaining fields with default
+	 * values.
+	 */
+	size_t opts_size;
+
+	/**
+	 * Maximum number of appends and zone management commands queued or outstanding at
+	 * once. The qpair should have at least as many I/O requests. Default is 256.
+	 */
+	uint32_t max_requests;
+
+	/**
+	 * Maximum number of append commands outstanding to a single zone. Appends beyond that
+	 * are queued and merged into a single command. Default is 4.
+	 */
+	uint32_t max_zone_inflight;
+
+	/**
+	 * Maximum number of open zones to allow. 0 (the default) uses the limit of the namespace.
+	 */
+	uint32_t max_open_zones;
+
+	/**
+	 * Maximum number of active zones to allow. 0 (the default) uses the limit of the
+	 * namespace.
+	 */
+	uint32_t max_active_zones;
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_zone_mgr_opts) == 24, "Incorrect size");
+
+/**
+ * Zone information cached by a zone manager.
+ */
+struct spdk_nvme_zns_zone_info {
+	/** Zone Start LBA */
+	uint64_t zslba;
+
+	/** Write pointer, accounting for the appends that have completed */
+	uint64_t write_pointer;
+
+	/** Zone capacity, in number of LBAs */
+	uint64_t capacity;
+
+	/** Number of LBAs of the appends queued or outstanding to the zone */
+	uint64_t pending_lbas;
+
+	/** Zone state */
+	enum spdk_nvme_zns_zone_state state;
+};
+
+/**
+ * Callback for spdk_nvme_zns_zone_mgr_refresh().
+ *
+ * \param cb_arg Argument passed to spdk_nvme_zns_zone_mgr_refresh().
+ * \param rc 0 if the zone information was refreshed, negated errno otherwise.
+ */
+typedef void (*spdk_nvme_zns_zone_mgr_refresh_cb)(void *cb_arg, int rc);
+
+/**
+ * Get the default options of a zone manager.
+ *
+ * \param opts Options to fill with the default values.
+ * \param opts_size Must be set to sizeof(struct spdk_nvme_zns_zone_mgr_opts).
+ */
+void spdk_nvme_zns_zone_mgr_get_default_opts(struct spdk_nvme_zns_zone_mgr_opts *opts,
+		size_t opts_size);
+
+/**
+ * Create a zone manager for a Zoned Namespace.
+ *
+ * The zone information is not valid until spdk_nvme_zns_zone_mgr_refresh() completes.
+ * Namespaces formatted with metadata in a separate buffer are not supported.
+ *
+ * \param ns Zoned Namespace.
+ * \param qpair I/O qpair used to submit the commands.
+ * \param opts Options, or NULL to use the default ones.
+ *
+ * \return the zone manager, or NULL on failure.
+ */
+struct spdk_nvme_zns_zone_mgr *spdk_nvme_zns_zone_mgr_create(struct spdk_nvme_ns *ns,
+		struct spdk_nvme_qpair *qpair, const struct spdk_nvme_zns_zone_mgr_opts *opts);
+
+/**
+ * Free a zone manager.
+ *
+ * \param mgr Zone manager.
+ *
+ * \return 0 on success, -EBUSY if commands are still queued or outstanding.
+ */
+int spdk_nvme_zns_zone_mgr_free(struct spdk_nvme_zns_zone_mgr *mgr);
+
+/**
+ * Read the state and write pointer of all zones from the controller.
+ *
+ * This has to be called once after the zone manager was created, and can be called again
+ * to resynchronize the cache, e.g. after a command failed.
+ *
+ * \param mgr Zone manager.
+ * \param cb_fn Callback invoked once all zones were reported.
+ * \param cb_arg Argument passed to the callback.
+ *
+ * \return 0 on success, -EBUSY if commands are queued or outstanding, -ENOMEM if the
+ * report could not be submitted.
+ */
+int spdk_nvme_zns_zone_mgr_refresh(struct spdk_nvme_zns_zone_mgr *mgr,
+				   spdk_nvme_zns_zone_mgr_refresh_cb cb_fn, void *cb_arg);
+
+/**
+ * Get the cached information of a zone.
+ *
+ * \param mgr Zone manager.
+ * \param zslba Zone Start LBA of the zone.
+ * \param info Filled with the zone information.
+ *
+ * \return 0 on success, -EINVAL if zslba isn't the start of a zone or the zone information
+ * hasn't been read yet.
+ */
+int spdk_nvme_zns_zone_mgr_get_zone_info(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+		struct spdk_nvme_zns_zone_info *info);
+
+/**
+ * Append data to a zone through a zone manager.
+ *
+ * The data is written by a zone append command, possibly merged with other appends to
+ * the same zone. As for spdk_nvme_zns_zone_append(), the LBA the data was written to is
+ * returned in cdw0 (lower 32 bits) and cdw1 (upper 32 bits) of the completion.
+ *
+ * \param mgr Zone manager.
+ * \param buffer Virtual address pointer to the data payload buffer.
+ * \param zslba Zone Start LBA of the zone that we are appending to.
+ * \param lba_count Length (in sectors) for the zone append operation.
+ * \param cb_fn Callback function to invoke when the I/O is completed.
+ * \param cb_arg Argument to pass to the callback function.
+ * \param io_flags Set flags, defined by the SPDK_NVME_IO_FLAGS_* entries in
+ * spdk/nvme_spec.h, for this I/O. Only appends with the same flags are merged.
+ *
+ * \return 0 if successfully submitted or queued, negated errnos on the following error
+ * conditions:
+ * -EINVAL: The request is malformed or the zone is not writable.
+ * -ENOSPC: The remaining capacity of the zone is too small.
+ * -EBUSY: The zone would have to be opened, but the open or active zone limit was reached.
+ * -ENOMEM: The request cannot be allocated.
+ * -ENXIO: The qpair is failed at the transport level.
+ */
+int spdk_nvme_zns_zone_mgr_append(struct spdk_nvme_zns_zone_mgr *mgr, void *buffer,
+				  uint64_t zslba, uint32_t lba_count,
+				  spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags);
+
+/**
+ * Submit a Open Zone operation through a zone manager.
+ *
+ * \param mgr Zone manager.
+ * \param zslba Zone Start LBA of the zone to open.
+ * \param cb_fn Callback function invoked when the command completes.
+ * \param cb_arg Argument passed to callback function.
+ *
+ * \return 0 on success, -EBUSY if the open or active zone limit was reached. Negated
+ * errno on other failures.
+ */
+int spdk_nvme_zns_zone_mgr_open_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				     spdk_nvme_cmd_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a Close Zone operation through a zone manager.
+ *
+ * \param mgr Zone manager.
+ * \param zslba Zone Start LBA of the zone to close.
+ * \param cb_fn Callback function invoked when the command completes.
+ * \param cb_arg Argument passed to callback function.
+ *
+ * \return 0 on success, -EBUSY if appends to the zone are queued or outstanding. Negated
+ * errno on other failures.
+ */
+int spdk_nvme_zns_zone_mgr_close_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				      spdk_nvme_cmd_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a Finish Zone operation through a zone manager.
+ *
+ * \param mgr Zone manager.
+ * \param zslba Zone Start LBA of the zone to finish.
+ * \param cb_fn Callback function invoked when the command completes.
+ * \param cb_arg Argument passed to callback function.
+ *
+ * \return 0 on success, -EBUSY if appends to the zone are queued or outstanding. Negated
+ * errno on other failures.
+ */
+int spdk_nvme_zns_zone_mgr_finish_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				       spdk_nvme_cmd_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a Reset Zone operation through a zone manager.
+ *
+ * \param mgr Zone manager.
+ * \param zslba Zone Start LBA of the zone to reset.
+ * \param cb_fn Callback function invoked when the command completes.
+ * \param cb_arg Argument passed to callback function.
+ *
+ * \return 0 on success, -EBUSY if appends to the zone are queued or outstanding. Negated
+ * errno on other failures.
+ */
+int spdk_nvme_zns_zone_mgr_reset_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				      spdk_nvme_cmd_cb cb_fn, void *cb_arg);
+
 #ifdef __cplusplus
 }
 #endif
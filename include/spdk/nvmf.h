@@ -836,10 +836,26 @@ struct spdk_nvmf_ns_opts {
 	 */
 	uint32_t anagrpid;
 
-	/* Hole at bytes 60-63. */
-	uint8_t reserved60[4];
+	/**
+	 * Maximum number of I/O commands outstanding to this namespace on each poll group.
+	 *
+	 * Commands above the limit are completed with a retryable status instead of being
+	 * queued. Set to 0 for no limit.
+	 */
+	uint32_t max_io_outstanding;
+
+	/**
+	 * Target I/O latency of this namespace in microseconds.
+	 *
+	 * When the observed latency exceeds the target, the number of commands admitted to
+	 * the namespace is reduced until the latency recovers. Set to 0 to disable.
+	 */
+	uint32_t latency_target_us;
+
+	/* Hole at bytes 68-71. */
+	uint8_t reserved68[4];
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ns_opts) == 64, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ns_opts) == 72, "Incorrect size");
 
 /**
  * Get default namespace creation options.
@@ -850,9 +866,11 @@ SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ns_opts) == 64, "Incorrect size");
 void spdk_nvmf_ns_opts_get_defaults(struct spdk_nvmf_ns_opts *opts, size_t opts_size);
 
 /**
- * Add a namespace to a subsystems in the PAUSED or INACTIVE states.
+ * Add a namespace to a subsystem.
  *
- * May only be performed on subsystems in the PAUSED or INACTIVE states.
+ * May only be performed on subsystems in the PAUSED, INACTIVE or ACTIVE states.  An ACTIVE
+ * subsystem doesn't need to be paused: its poll groups start serving the namespace (and notify
+ * the connected hosts) asynchronously, after this function returns.
  *
  * \param subsystem Subsystem to add namespace to.
  * \param bdev_name Block device name to add as a namespace.
@@ -18,6 +18,8 @@
 #include "spdk/nvmf_spec.h"
 #include "spdk/memory.h"
 
+struct spdk_metrics_group;
+
 #define SPDK_NVMF_MAX_SGL_ENTRIES	16
 
 /* The maximum number of buffers per request */
@@ -102,6 +104,8 @@ struct spdk_nvmf_request {
 	struct spdk_poller		*poller;
 	struct spdk_bdev_io		*zcopy_bdev_io; /* Contains the bdev_io when using ZCOPY */
 	enum spdk_nvmf_zcopy_phase	zcopy_phase;
+	/* Time the request was admitted to its namespace, only set with a latency target */
+	uint64_t			admit_tsc;
 
 	TAILQ_ENTRY(spdk_nvmf_request)	link;
 };
@@ -170,6 +174,9 @@ struct spdk_nvmf_poll_group {
 	/* Statistics */
 	struct spdk_nvmf_poll_group_stat		stat;
 
+	/* Metrics mirroring the statistics, NULL if the metrics aren't enabled */
+	struct spdk_metrics_group			*metrics;
+
 	spdk_nvmf_poll_group_destroy_done_fn		destroy_cb_fn;
 	void						*destroy_cb_arg;
 
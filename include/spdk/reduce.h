@@ -124,7 +124,9 @@ const struct spdk_uuid *spdk_reduce_vol_get_uuid(struct spdk_reduce_vol *vol);
  * \param backing_dev Structure describing the backing device to use for the new volume.
  * \param pm_file_dir Directory to use for creation of the persistent memory file to
  *                    use for the new volume.  This function will append the UUID as
- *		      the filename to create in this directory.
+ *		      the filename to create in this directory.  If NULL, the volume's
+ *		      metadata is stored at the end of the backing device instead, with
+ *		      a copy of it kept in memory.
  * \param cb_fn Callback function to signal completion of the initialization process.
  * \param cb_arg Argument to pass to the callback function.
  */
@@ -19,6 +19,7 @@ extern "C" {
 
 struct spdk_governor_capabilities {
 	bool priority; /* Core with higher base frequency */
+	uint32_t max_freq; /* Maximum frequency of the core, including turbo, 0 if unknown */
 };
 
 /**
@@ -149,6 +150,11 @@ struct spdk_scheduler_thread_info {
 	struct spdk_thread_stats total_stats;
 	/* stats during the last scheduling period */
 	struct spdk_thread_stats current_stats;
+	/* burst stats during the last scheduling period */
+	struct spdk_thread_burst_stats burst_stats;
+	enum spdk_thread_latency_class latency_class;
+	/* preferred NUMA socket of the thread, SPDK_ENV_SOCKET_ID_ANY if none */
+	int32_t numa_affinity;
 };
 
 /**
@@ -188,6 +188,21 @@ struct spdk_sock_impl_opts {
 	 * example: "TLS_AES_256_GCM_SHA384:TLS_AES_128_GCM_SHA256"
 	 */
 	const char *tls_cipher_suites;
+
+	/**
+	 * Time in microseconds the kernel busy polls the receive queue of the sockets for new
+	 * packets (SO_BUSY_POLL and SO_PREFER_BUSY_POLL), instead of waiting for the interrupts.
+	 * 0 disables busy polling.  Busy polling only applies to a sock group if all its sockets
+	 * come from the same NIC queue, so it should be used with enable_placement_id set to
+	 * PLACEMENT_NAPI.  Used by posix and uring socket modules.
+	 */
+	uint32_t busy_poll_usecs;
+
+	/**
+	 * Maximum number of packets processed by each busy poll (SO_BUSY_POLL_BUDGET), 0 uses the
+	 * kernel's default.  Used by posix and uring socket modules.
+	 */
+	uint32_t busy_poll_budget;
 };
 
 /**
@@ -557,6 +572,44 @@ int spdk_sock_group_remove_sock(struct spdk_sock_group *group, struct spdk_sock
  */
 int spdk_sock_group_provide_buf(struct spdk_sock_group *group, void *buf, size_t len, void *ctx);
 
+/**
+ * Statistics of the data sent and received by the sockets of a group.
+ */
+struct spdk_sock_group_stats {
+	/** Number of system calls (or io_uring operations) that sent data. */
+	uint64_t send_calls;
+
+	/** Number of bytes sent by these calls. */
+	uint64_t bytes_sent;
+
+	/** Number of zero copy completion notifications read from the error queues. */
+	uint64_t zcopy_notifications;
+
+	/** Number of requests completed by these notifications. */
+	uint64_t zcopy_completed_reqs;
+
+	/** Number of bytes sent with the TLS records built by the kernel or the NIC. */
+	uint64_t ktls_bytes_sent;
+
+	/** Number of bytes received with the TLS records decrypted by the kernel or the NIC. */
+	uint64_t ktls_bytes_received;
+
+	/** Number of system calls (or io_uring operations) that received data. */
+	uint64_t recv_calls;
+
+	/** Number of bytes received by these calls. */
+	uint64_t bytes_received;
+};
+
+/**
+ * Get the statistics of the data sent and received by the sockets of a group, summed up across
+ * the socket implementations used by the group.
+ *
+ * \param group Group to get the statistics of.
+ * \param stats Filled with the statistics.
+ */
+void spdk_sock_group_get_stats(struct spdk_sock_group *group, struct spdk_sock_group_stats *stats);
+
 /**
  * Poll incoming events for each registered socket.
  *
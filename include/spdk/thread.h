@@ -215,6 +215,37 @@ int spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
  */
 void spdk_thread_lib_fini(void);
 
+/**
+ * Keep track of the timed pollers of each thread in a hierarchical timing wheel instead of
+ * a red-black tree.  Scheduling and expiring a poller then takes constant time, which benefits
+ * threads running a large number of timed pollers, at the cost of rounding the expiration time
+ * up to a microsecond.  Must be called prior to initializing the threading library and is reset
+ * by spdk_thread_lib_fini().
+ *
+ * \return 0 on success, -EBUSY if the threading library is already initialized.
+ */
+int spdk_thread_lib_enable_timer_wheel(void);
+
+/**
+ * Enable or disable collecting a histogram of the execution time of each poller.  The
+ * histogram of a poller is allocated the first time it runs while histograms are enabled and
+ * is kept until the poller is unregistered.  Measuring the execution time adds two reads of
+ * the timestamp counter to each poller run.  Can be called at any time and is reset by
+ * spdk_thread_lib_fini().
+ *
+ * \param enable True to enable, false to disable.
+ */
+void spdk_thread_lib_enable_poller_histograms(bool enable);
+
+/**
+ * Set the execution time of a poller above which a warning naming the poller is logged and
+ * its slow run counter is incremented.  One slow poller delays all other pollers and messages
+ * of its thread.  Can be called at any time and is reset by spdk_thread_lib_fini().
+ *
+ * \param threshold_us Threshold in microseconds, 0 to disable the watchdog.
+ */
+void spdk_thread_lib_set_poller_watchdog(uint64_t threshold_us);
+
 /**
  * Creates a new SPDK thread object.
  *
@@ -394,6 +425,9 @@ int spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now
  * would expire. Timed pollers are pollers for which
  * period_microseconds is greater than 0.
  *
+ * If the timer wheel is enabled, the returned value might be earlier than the expiration of
+ * any poller, as pollers far in the future need to be moved down the wheel first.
+ *
  * \param thread The thread to check poller expiration times on
  *
  * \return Number of ticks. If no timed pollers, return 0.
@@ -495,6 +529,80 @@ int spdk_thread_get_stats(struct spdk_thread_stats *stats);
  */
 uint64_t spdk_thread_get_last_tsc(struct spdk_thread *thread);
 
+/**
+ * Statistics about the bursts of work of a thread.  A busy run is a sequence of consecutive
+ * iterations of spdk_thread_poll() that did some work.
+ */
+struct spdk_thread_burst_stats {
+	/** Number of busy runs that ended */
+	uint64_t busy_runs;
+	/** 99th percentile of the length of busy runs in ticks, rounded up to a power of two */
+	uint64_t busy_run_p99_tsc;
+	/** Number of messages executed */
+	uint64_t msg_count;
+};
+
+/**
+ * Get the burst statistics of a thread collected since the previous call to this function
+ * and start collecting them anew.  Meant to be called by the scheduler once per scheduling
+ * period, from the core the thread is running on.
+ *
+ * \param thread Thread to query.
+ * \param stats Statistics of the thread.
+ */
+void spdk_thread_collect_burst_stats(struct spdk_thread *thread,
+				     struct spdk_thread_burst_stats *stats);
+
+/**
+ * Latency class of a thread, which schedulers may use to decide which threads can share a core.
+ */
+enum spdk_thread_latency_class {
+	/** The thread can share its core with any other thread */
+	SPDK_THREAD_LATENCY_CLASS_DEFAULT = 0,
+	/**
+	 * The thread is sensitive to being delayed by other threads on its core, so it shouldn't
+	 * share it with other latency sensitive threads or threads doing work in long bursts.
+	 */
+	SPDK_THREAD_LATENCY_CLASS_SENSITIVE,
+};
+
+/**
+ * Declare the latency class of a thread.
+ *
+ * \param thread Thread to modify.
+ * \param latency_class Latency class of the thread.
+ */
+void spdk_thread_set_latency_class(struct spdk_thread *thread,
+				   enum spdk_thread_latency_class latency_class);
+
+/**
+ * Get the latency class of a thread.
+ *
+ * \param thread Thread to query.
+ *
+ * \return latency class of the thread, SPDK_THREAD_LATENCY_CLASS_DEFAULT unless declared
+ * otherwise.
+ */
+enum spdk_thread_latency_class spdk_thread_get_latency_class(struct spdk_thread *thread);
+
+/**
+ * Declare the NUMA socket a thread should preferably run on, e.g. the socket of the devices it
+ * does I/O to.  Schedulers may use it to avoid moving the thread to cores on other sockets.
+ *
+ * \param thread Thread to modify.
+ * \param socket_id Preferred socket ID, or SPDK_ENV_SOCKET_ID_ANY to clear the affinity.
+ */
+void spdk_thread_set_numa_affinity(struct spdk_thread *thread, int32_t socket_id);
+
+/**
+ * Get the NUMA socket a thread should preferably run on.
+ *
+ * \param thread Thread to query.
+ *
+ * \return preferred socket ID of the thread, SPDK_ENV_SOCKET_ID_ANY unless declared otherwise.
+ */
+int32_t spdk_thread_get_numa_affinity(struct spdk_thread *thread);
+
 /**
  * Send a message to the given thread.
  *
@@ -511,6 +619,72 @@ uint64_t spdk_thread_get_last_tsc(struct spdk_thread *thread);
  */
 int spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx);
 
+/**
+ * Send a message which can be executed by any thread.
+ *
+ * The message is queued on the given thread, but if that thread falls behind, it might be
+ * stolen and executed by another thread which is idle.  Therefore, `fn` can't rely on the thread
+ * it's executed on, e.g. it can't use any I/O channels or pollers, and must be safe to execute
+ * concurrently with other messages sent to the same thread.  It's meant for self-contained work
+ * items, such as verifying checksums or parsing metadata.
+ *
+ * \param thread The target thread.
+ * \param fn This function will be called on the given thread or on another idle thread.
+ * \param ctx This context will be passed to fn when called.
+ *
+ * \return 0 on success
+ * \return -ENOMEM if the message could not be allocated
+ * \return -EIO if the message could not be sent to the destination thread
+ */
+int spdk_thread_send_stealable_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx);
+
+/**
+ * Message embedded in a caller's structure, which can be sent to a thread without allocating
+ * a message from the global pool.  All of its fields are internal and are initialized by
+ * spdk_thread_send_msg_embedded().
+ */
+struct spdk_thread_msg {
+	spdk_msg_fn			fn;
+	void				*arg;
+	bool				embedded;
+
+	SLIST_ENTRY(spdk_thread_msg)	link;
+};
+
+/**
+ * Send a message embedded in a caller-owned structure to the given thread.
+ *
+ * Same as spdk_thread_send_msg(), except that the message isn't allocated, so sending it can't
+ * fail due to the message pool being exhausted.  The message must stay valid until `fn` starts
+ * executing and it cannot be sent again before that.  It's safe to reuse or free the message
+ * from within `fn`.
+ *
+ * \param thread The target thread.
+ * \param msg Message to send.
+ * \param fn This function will be called on the given thread.
+ * \param ctx This context will be passed to fn when called.
+ *
+ * \return 0 on success
+ * \return -EIO if the message could not be sent to the destination thread
+ */
+int spdk_thread_send_msg_embedded(const struct spdk_thread *thread, struct spdk_thread_msg *msg,
+				  spdk_msg_fn fn, void *ctx);
+
+/** Maximum number of messages that can be executed in a single batch */
+#define SPDK_THREAD_MAX_MSG_BATCH_SIZE 64
+
+/**
+ * Set the maximum number of messages executed by a thread each time it's polled.  Larger
+ * batches amortize the cost of dequeuing messages, while smaller ones reduce the latency of
+ * the thread's pollers.  Defaults to 8.
+ *
+ * \param thread The thread to configure.
+ * \param batch_size Number of messages, between 1 and SPDK_THREAD_MAX_MSG_BATCH_SIZE.
+ *
+ * \return 0 on success, -EINVAL if the batch size is out of range.
+ */
+int spdk_thread_set_msg_batch_size(struct spdk_thread *thread, uint32_t batch_size);
+
 /**
  * Send a message to the given thread. Only one critical message can be outstanding at the same
  * time. It's intended to use this function in any cases that might interrupt the execution of the
@@ -982,6 +1156,12 @@ void spdk_spin_unlock(struct spdk_spinlock *sspin);
  */
 bool spdk_spin_held(struct spdk_spinlock *sspin);
 
+/** Maximum number of medium buffer size classes in between the small and large ones */
+#define SPDK_IOBUF_MAX_MEDIUM_POOLS	4
+
+/**
+ * The pool counts are split evenly across the NUMA nodes of the cores the app is running on.
+ */
 struct spdk_iobuf_opts {
 	/** Maximum number of small buffers */
 	uint64_t small_pool_count;
@@ -991,9 +1171,20 @@ struct spdk_iobuf_opts {
 	uint32_t small_bufsize;
 	/** Size of a single large buffer */
 	uint32_t large_bufsize;
+	/**
+	 * Maximum number of buffers of each medium size class.  A zero count disables the class
+	 * and all of the classes following it.
+	 */
+	uint64_t medium_pool_count[SPDK_IOBUF_MAX_MEDIUM_POOLS];
+	/**
+	 * Size of a single buffer of each medium size class.  The sizes must be in ascending order,
+	 * larger than small_bufsize and smaller than large_bufsize.
+	 */
+	uint32_t medium_bufsize[SPDK_IOBUF_MAX_MEDIUM_POOLS];
 };
 
 struct spdk_iobuf_entry;
+struct spdk_iobuf_pool_stats;
 
 typedef void (*spdk_iobuf_get_cb)(struct spdk_iobuf_entry *entry, void *buf);
 
@@ -1002,6 +1193,10 @@ struct spdk_iobuf_entry {
 	spdk_iobuf_get_cb		cb_fn;
 	const void			*module;
 	STAILQ_ENTRY(spdk_iobuf_entry)	stailq;
+	/** Statistics of the pool the buffer was requested from */
+	struct spdk_iobuf_pool_stats	*stats;
+	/** Tick count at which the entry was queued */
+	uint64_t			tsc;
 };
 
 
@@ -1012,6 +1207,25 @@ struct spdk_iobuf_buffer {
 typedef STAILQ_HEAD(, spdk_iobuf_entry) spdk_iobuf_entry_stailq_t;
 typedef STAILQ_HEAD(, spdk_iobuf_buffer) spdk_iobuf_buffer_stailq_t;
 
+struct spdk_iobuf_pool_stats {
+	/** Number of buffers retrieved from the channel's cache */
+	uint64_t	cache;
+	/** Number of buffers retrieved from the global pool */
+	uint64_t	main;
+	/** Number of requests that had to wait for a buffer */
+	uint64_t	retry;
+	/** Number of buffers retrieved from the pool of a remote NUMA node */
+	uint64_t	remote;
+	/**
+	 * Number of buffers retrieved minus the number of buffers released.  A single channel's
+	 * value may wrap around if the buffers are released through another channel, but the
+	 * per-module sum reported by `spdk_iobuf_get_stats()` is the number of buffers it holds.
+	 */
+	uint64_t	outstanding;
+	/** Total number of ticks the requests spent waiting for a buffer */
+	uint64_t	wait_ticks;
+};
+
 struct spdk_iobuf_pool {
 	/** Buffer pool */
 	struct spdk_ring		*pool;
@@ -1025,6 +1239,8 @@ struct spdk_iobuf_pool {
 	spdk_iobuf_entry_stailq_t	*queue;
 	/** Buffer size */
 	uint32_t			bufsize;
+	/** Statistics */
+	struct spdk_iobuf_pool_stats	stats;
 };
 
 /** iobuf channel */
@@ -1033,10 +1249,30 @@ struct spdk_iobuf_channel {
 	struct spdk_iobuf_pool		small;
 	/** Large buffer memory pool */
 	struct spdk_iobuf_pool		large;
+	/** Medium buffer memory pools, in ascending order of their buffer size */
+	struct spdk_iobuf_pool		medium[SPDK_IOBUF_MAX_MEDIUM_POOLS];
+	/** Number of medium buffer memory pools */
+	uint32_t			num_medium;
 	/** Module pointer */
 	const void			*module;
 	/** Parent IO channel */
 	struct spdk_io_channel		*parent;
+	/** Link on the parent IO channel's list of channels */
+	TAILQ_ENTRY(spdk_iobuf_channel)	tailq;
+};
+
+/** iobuf statistics of a single module */
+struct spdk_iobuf_module_stats {
+	/** Name of the module */
+	const char			*module;
+	/** Small buffer pool statistics */
+	struct spdk_iobuf_pool_stats	small_pool;
+	/** Large buffer pool statistics */
+	struct spdk_iobuf_pool_stats	large_pool;
+	/** Medium buffer pool statistics */
+	struct spdk_iobuf_pool_stats	medium_pool[SPDK_IOBUF_MAX_MEDIUM_POOLS];
+	/** Number of medium buffer pools */
+	uint32_t			num_medium;
 };
 
 /**
@@ -1072,6 +1308,20 @@ int spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts);
  */
 void spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts);
 
+/**
+ * Get the memory regions backing the iobuf pools.  The pools are partitioned across the NUMA
+ * nodes of the cores the app is running on.  For each node, the small pool region is stored
+ * first, followed by the large pool region and the medium pool regions, in ascending order of
+ * their buffer size.  The regions are valid from `spdk_iobuf_initialize()` until
+ * `spdk_iobuf_finish()`.
+ *
+ * \param iovs Array to fill in with the regions.
+ * \param iovcnt Number of elements in the array.
+ *
+ * \return Number of regions stored in the array.
+ */
+int spdk_iobuf_get_pool_regions(struct iovec *iovs, int iovcnt);
+
 /**
  * Register a module as an iobuf pool user.  Only registered users can request buffers from the
  * iobuf pool.
@@ -1092,12 +1342,14 @@ int spdk_iobuf_register_module(const char *name);
 int spdk_iobuf_unregister_module(const char *name);
 
 /**
- * Initialize an iobuf channel.
+ * Initialize an iobuf channel.  The channel uses the pools of the NUMA node local to the calling
+ * thread and only falls back to the other nodes once they're exhausted.
  *
  * \param ch iobuf channel to initialize.
  * \param name Name of the module registered via `spdk_iobuf_register_module()`.
  * \param small_cache_size Number of small buffers to be cached by this channel.
- * \param large_cache_size Number of large buffers to be cached by this channel.
+ * \param large_cache_size Number of large buffers to be cached by this channel.  The same number
+ *                         of buffers is cached from each of the medium pools.
  *
  * \return 0 on success, negative errno otherwise.
  */
@@ -1140,8 +1392,9 @@ void spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_ent
 			    uint64_t len);
 
 /**
- * Get a buffer from the iobuf pool.  If no buffers are available, the request is queued until a
- * buffer is released.
+ * Get a buffer from the iobuf pool.  The buffer is taken from the pool with the smallest buffer
+ * size that fits `len`.  If no buffers are available, the request is queued until a buffer is
+ * released.
  *
  * \param ch iobuf channel.
  * \param len Length of the buffer to retrieve.  The user is responsible for making sure the length
@@ -1165,6 +1418,26 @@ void *spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len, struct spdk_io
  */
 void spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len);
 
+/**
+ * Function to be called once the iobuf statistics are gathered.
+ *
+ * \param modules Statistics of each registered module.
+ * \param num_modules Number of elements in the `modules` array.
+ * \param cb_arg Argument passed to `spdk_iobuf_get_stats()`.
+ */
+typedef void (*spdk_iobuf_get_stats_cb)(struct spdk_iobuf_module_stats *modules,
+					uint32_t num_modules, void *cb_arg);
+
+/**
+ * Gather the per-module buffer pool statistics, summed up over all of their channels.
+ *
+ * \param cb_fn Callback to be executed once the statistics are gathered.
+ * \param cb_arg Argument passed to `cb_fn`.
+ *
+ * \return 0 on success, negative errno otherwise.
+ */
+int spdk_iobuf_get_stats(spdk_iobuf_get_stats_cb cb_fn, void *cb_arg);
+
 #ifdef __cplusplus
 }
 #endif
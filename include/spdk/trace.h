@@ -29,14 +29,21 @@ struct spdk_trace_entry {
 	uint8_t		args[8];
 };
 
-struct spdk_trace_entry_buffer {
-	uint64_t	tsc;
-	uint16_t	tpoint_id;
-	uint8_t		data[22];
-};
-
-SPDK_STATIC_ASSERT(sizeof(struct spdk_trace_entry_buffer) == sizeof(struct spdk_trace_entry),
-		   "Invalid size of trace entry buffer");
+/**
+ * Trace records are stored in a compact, variable-length format.  The circular buffer of each
+ * trace history is split into frames of SPDK_TRACE_FRAME_SIZE bytes (or the size of the buffer,
+ * if it's smaller) and a record never crosses a frame boundary, so that a reader can start
+ * decoding at any of them.  Each record consists of the following fields, encoded as unsigned
+ * LEB128 varints:
+ *  - tpoint_id + 1 (a zero byte instead means that the rest of the frame is unused),
+ *  - zigzag-encoded tsc delta from the previous record in the same frame (or the absolute tsc
+ *    for the first record of a frame),
+ *  - poller_id, size, and object_id,
+ *  - the arguments, as defined by the tracepoint's description: integers and pointers are
+ *    stored as varints, while strings are stored as their length followed by the characters
+ *    (without the NULL terminator).
+ */
+#define SPDK_TRACE_FRAME_SIZE	4096
 
 /* If type changes from a uint8_t, change this value. */
 #define SPDK_TRACE_MAX_OWNER (UCHAR_MAX + 1)
@@ -90,7 +97,11 @@ struct spdk_trace_history {
 	/** Logical core number associated with this structure instance. */
 	int				lcore;
 
-	/** Number of trace_entries contained in each trace_history. */
+	/**
+	 * Size of the circular buffer expressed in the number of spdk_trace_entry
+	 *  structures it could hold.  With the compact encoding, it typically holds
+	 *  several times more trace records.
+	 */
 	uint64_t			num_entries;
 
 	/**
@@ -100,16 +111,39 @@ struct spdk_trace_history {
 	 */
 	uint64_t			tpoint_count[SPDK_TRACE_MAX_TPOINT_ID];
 
-	/** Index to next spdk_trace_entry to fill. */
-	uint64_t			next_entry;
+	/**
+	 * Total number of bytes written to the circular buffer, i.e. the offset of the next
+	 *  trace record to fill.  It only grows, so it needs to be wrapped to the size of the
+	 *  buffer to get its position.
+	 */
+	uint64_t			next_offset;
+
+	/** Size of the frames the circular buffer is split into (see SPDK_TRACE_FRAME_SIZE). */
+	uint64_t			frame_size;
+
+	/** tsc of the last trace record, which the tsc of the next one is encoded against. */
+	uint64_t			last_tsc;
+
+	/**
+	 * Set by a consumer (e.g. spdk_trace_record) that wants to read all records without
+	 *  losing any of them.  While it's set, the producer never overwrites data that hasn't
+	 *  been consumed yet (i.e. past consumer_offset) and drops new records instead.
+	 */
+	uint64_t			consumer_attached;
+
+	/** Offset of the next byte to be read by the consumer. */
+	uint64_t			consumer_offset;
+
+	/** Number of trace records dropped, because the consumer didn't keep up. */
+	uint64_t			num_dropped;
 
 	/**
-	 * Circular buffer of spdk_trace_entry structures for tracing
-	 *  tpoints on this core.  Debug tool spdk_trace reads this
-	 *  buffer from shared memory to post-process the tpoint entries and
-	 *  display in a human-readable format.
+	 * Circular buffer of encoded trace records for tracing tpoints on
+	 *  this core.  Debug tool spdk_trace reads this buffer from shared
+	 *  memory to post-process the trace records and display them in a
+	 *  human-readable format.
 	 */
-	struct spdk_trace_entry		entries[0];
+	uint8_t				data[0];
 };
 
 #define SPDK_TRACE_MAX_LCORE		128
@@ -148,6 +182,12 @@ spdk_get_trace_history_size(uint64_t num_entries)
 	return sizeof(struct spdk_trace_history) + num_entries * sizeof(struct spdk_trace_entry);
 }
 
+static inline uint64_t
+spdk_get_trace_history_buffer_size(const struct spdk_trace_history *history)
+{
+	return history->num_entries * sizeof(struct spdk_trace_entry);
+}
+
 static inline uint64_t
 spdk_get_trace_histories_size(struct spdk_trace_histories *trace_histories)
 {
@@ -277,11 +317,94 @@ void spdk_trace_clear_tpoint_group_mask(uint64_t tpoint_group_mask);
  * the given shared memory to post-process the tpoint entries and display in a
  * human-readable format.
  *
+ * Aside from a trace history for each lcore, up to num_threads histories are
+ * reserved for threads not running on any of the lcores (e.g. threads created
+ * by the application or non-reactor SPDK threads).  These are placed in the
+ * unused lcore slots, starting from the last one, and are claimed by the threads
+ * the first time they record a trace (or call spdk_trace_register_user_thread()).
+ *
  * \param shm_name Name of shared memory.
  * \param num_entries Number of trace entries per lcore.
+ * \param num_threads Number of trace histories to reserve for non-lcore threads.
  * \return 0 on success, else non-zero indicates a failure.
  */
-int spdk_trace_init(const char *shm_name, uint64_t num_entries);
+int spdk_trace_init(const char *shm_name, uint64_t num_entries, uint32_t num_threads);
+
+/**
+ * Claim a trace history for the calling thread, which doesn't run on any of the
+ * lcores.  It's done automatically when such thread records its first trace, so
+ * this only needs to be called to know upfront whether its traces will be kept.
+ * The history is released when the thread exits.
+ *
+ * \return 0 on success, -ENOENT if tracing isn't initialized, -EINVAL if the
+ * calling thread runs on an lcore, -ENOMEM if there are no free histories left.
+ */
+int spdk_trace_register_user_thread(void);
+
+/**
+ * Release the trace history claimed by the calling thread, making it available
+ * to other threads.
+ *
+ * \return 0 on success, -ENOENT if the calling thread doesn't own a history.
+ */
+int spdk_trace_unregister_user_thread(void);
+
+/**
+ * Set the trace sampling rate.  Only the traces of 1 in rate objects (e.g. requests) are recorded,
+ * while the rest are skipped.  The decision is based on the hash of the object's ID, so all
+ * traces of a sampled object are recorded.  Tracepoints not tied to any object type are always
+ * recorded.
+ *
+ * \param rate Sampling rate.  0 and 1 disable sampling.
+ */
+void spdk_trace_set_sample_rate(uint32_t rate);
+
+/**
+ * Get the trace sampling rate.
+ *
+ * \return Sampling rate, 1 if sampling is disabled.
+ */
+uint32_t spdk_trace_get_sample_rate(void);
+
+/**
+ * Configure tail-based trace capture.  Once a request takes longer than latency_us to
+ * complete, the current contents of the trace histories are written to a file named
+ * "<path>.<index>", which can be read by spdk_trace in the same way as the output of
+ * spdk_trace_record.  At most one capture is written at a time and no more than one per second.
+ *
+ * \param latency_us Latency threshold in microseconds, 0 disables the capture.
+ * \param path Prefix of the capture file names.  Ignored if latency_us is 0.
+ *
+ * \return 0 on success, -EINVAL if the path is invalid.
+ */
+int spdk_trace_set_capture_trigger(uint64_t latency_us, const char *path);
+
+/**
+ * Write the current contents of the trace histories to a capture file (see
+ * spdk_trace_set_capture_trigger()).  The file is written asynchronously.
+ *
+ * \return 0 if the capture was started, -ENOENT if tracing or capture isn't configured, -EBUSY
+ * if another capture is in progress, -EAGAIN if the last one was started less than a second
+ * ago, or another negative errno if the capture couldn't be started.
+ */
+int spdk_trace_capture(void);
+
+/* Latency threshold (in ticks) triggering a trace capture, 0 if disabled */
+extern uint64_t g_trace_capture_threshold;
+
+/**
+ * Check the latency of a completed request and capture the traces if it exceeds the threshold
+ * set by spdk_trace_set_capture_trigger().
+ *
+ * \param latency_ticks Latency of the request in ticks.
+ */
+static inline void
+spdk_trace_check_latency(uint64_t latency_ticks)
+{
+	if (g_trace_capture_threshold != 0 && latency_ticks >= g_trace_capture_threshold) {
+		spdk_trace_capture();
+	}
+}
 
 /**
  * Unmap global trace memory structs.
@@ -0,0 +1,117 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/** \file
+ * I/O workload generator
+ *
+ * Generates the offsets, sizes and directions of the I/O of a benchmark, following an access
+ * distribution described by a workload specification string:
+ *
+ *   <distribution>[,rw=<start>-<end>:<read percentage>]...
+ *
+ * with <distribution> one of:
+ *
+ *   uniform                uniformly random offsets
+ *   seq[:<jump>]           sequential offsets, jumping to a random offset with a probability
+ *                          of <jump> percent
+ *   zipf:<theta>           zipf distribution of the offsets
+ *   pareto:<h>             pareto distribution, <h> of the range receives 1 - <h> of the accesses
+ *   hotcold:<hot>/<access> <hot> percent of the range receives <access> percent of the accesses
+ *   replay:<path>          replay the I/O of a trace file
+ *
+ * Each rw= element sets the read percentage of the offsets in [<start>, <end>) percent of the
+ * range, in place of the default one.
+ *
+ * A trace file has one I/O per line, formatted as "<op> <sector> <sectors>", with <op> containing
+ * R for reads or W for writes, and the offset and size given in 512-byte sectors. This is the
+ * format printed by `blkparse -f "%d %S %n\n"`, and other traces, such as the I/O recorded by
+ * spdk_trace, can be converted to it. Other lines are skipped. The trace is replayed in a loop.
+ */
+
+#ifndef SPDK_WORKLOAD_H
+#define SPDK_WORKLOAD_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct spdk_workload;
+
+struct spdk_workload_opts {
+	/** Number of units I/O is generated in, e.g. the number of I/O size blocks of a bdev */
+	uint64_t	range;
+
+	/** Size of a unit in bytes, used to convert the offsets and sizes of a trace */
+	uint32_t	unit_size;
+
+	/** Percentage of reads, unless set for a region or given by a trace */
+	uint32_t	read_percentage;
+
+	/** Seed value for the random number generator */
+	uint32_t	seed;
+};
+
+/** An I/O generated by a workload */
+struct spdk_workload_io {
+	/** Offset, in units, in [0, range) */
+	uint64_t	offset;
+
+	/** Size, in units, offset + size doesn't exceed range */
+	uint64_t	size;
+
+	bool		is_read;
+};
+
+/**
+ * Create a workload generator.
+ *
+ * \param spec Workload specification, see the description of this file.
+ * \param opts Options of the workload generator.
+ *
+ * \return a pointer to the new workload generator, or NULL if the specification is invalid,
+ * the trace to replay couldn't be loaded, or the memory couldn't be allocated.
+ */
+struct spdk_workload *spdk_workload_create(const char *spec,
+		const struct spdk_workload_opts *opts);
+
+/**
+ * Free a workload generator and set the pointer to NULL.
+ *
+ * \param workloadp Workload generator to free.
+ */
+void spdk_workload_free(struct spdk_workload **workloadp);
+
+/**
+ * Add an I/O size to the size distribution of a workload.
+ *
+ * The size of each I/O is picked among the added ones, proportionally to their weight. Without
+ * any size added, all I/O is 1 unit. The sizes of a replayed trace take precedence.
+ *
+ * \param workload Workload generator.
+ * \param size I/O size, in units.
+ * \param weight Relative weight of this size.
+ *
+ * \return 0 on success, -EINVAL if size or weight is 0 or the size exceeds the range, -ENOSPC if
+ * too many sizes were added.
+ */
+int spdk_workload_add_size(struct spdk_workload *workload, uint64_t size, uint32_t weight);
+
+/**
+ * Generate the next I/O of a workload.
+ *
+ * A workload generator must not be used by multiple threads at the same time.
+ *
+ * \param workload Workload generator.
+ * \param io Filled with the generated I/O.
+ */
+void spdk_workload_next(struct spdk_workload *workload, struct spdk_workload_io *io);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
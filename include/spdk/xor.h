@@ -28,6 +28,35 @@ extern "C" {
  */
 int spdk_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len);
 
+/**
+ * Generate P (XOR) and Q (Reed-Solomon syndrome) parity from multiple source
+ * buffers, as used by RAID 6.
+ *
+ * Q is calculated over GF(2^8) with the generator {02} and the polynomial 0x11d.
+ *
+ * \param p Destination buffer for P parity.
+ * \param q Destination buffer for Q parity.
+ * \param sources Array of source buffers.
+ * \param n Number of source buffers in the array.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_xor_gen_pq(void *p, void *q, void **sources, uint32_t n, uint32_t len);
+
+/**
+ * Recover up to two lost buffers of a stripe protected with P and Q parity.
+ *
+ * \param bufs Array of n + 2 buffers: n data buffers followed by P and Q. The
+ * lost buffers are overwritten with the recovered data.
+ * \param n Number of data buffers.
+ * \param lost1 Index in bufs of the first lost buffer.
+ * \param lost2 Index in bufs of the second lost buffer. Must be greater than lost1.
+ * To recover a single buffer, pass the index of Q (n + 1), which is recalculated.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_xor_recover_pq(void **bufs, uint32_t n, uint32_t lost1, uint32_t lost2, uint32_t len);
+
 /**
  * Get the optimal buffer alignment for XOR functions.
  *
@@ -37,6 +37,8 @@ struct spdk_lw_thread {
 	uint64_t			tsc_start;
 	uint32_t                        lcore;
 	bool				resched;
+	/* Index of the thread's entry in the statistics shared memory, UINT32_MAX if none */
+	uint32_t			stats_idx;
 	/* stats over a lifetime of a thread */
 	struct spdk_thread_stats	total_stats;
 	/* stats during the last scheduling period */
@@ -67,6 +69,8 @@ struct spdk_reactor {
 
 	struct spdk_ring				*events;
 	int						events_fd;
+	/* Set once events_fd is notified, until the reactor acknowledges the notification */
+	bool						events_notified;
 
 	/* The last known rusage values */
 	struct rusage					rusage;
@@ -75,6 +79,9 @@ struct spdk_reactor {
 	uint64_t					busy_tsc;
 	uint64_t					idle_tsc;
 
+	/* Tick of the last update of the statistics shared memory */
+	uint64_t					last_stats_update;
+
 	/* Each bit of cpuset indicates whether a reactor probably requires event notification */
 	struct spdk_cpuset				notify_cpuset;
 	/* Indicate whether this reactor currently runs in interrupt */
@@ -96,6 +103,23 @@ void spdk_reactors_stop(void *arg1);
 
 struct spdk_reactor *spdk_reactor_get(uint32_t lcore);
 
+/**
+ * Export the reactor and thread statistics in a shared memory (described in
+ * spdk/app_stats.h), periodically updated by each reactor.
+ *
+ * \param shm_name Name of the shared memory to create.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_reactors_stats_init(const char *shm_name);
+
+/**
+ * Get the name of the statistics shared memory.
+ *
+ * \return name of the shared memory or NULL if the statistics aren't exported.
+ */
+const char *spdk_reactors_get_stats_shm_name(void);
+
 extern bool g_scheduling_in_progress;
 
 /**
@@ -128,6 +152,22 @@ void spdk_for_each_reactor(spdk_event_fn fn, void *arg1, void *arg2, spdk_event_
 int spdk_reactor_set_interrupt_mode(uint32_t lcore, bool new_in_interrupt,
 				    spdk_reactor_set_interrupt_mode_cb cb_fn, void *cb_arg);
 
+/**
+ * Set the time reactors in interrupt mode keep polling their file descriptors without blocking
+ * before going to sleep.  Spinning avoids the wakeup latency of the notifications arriving
+ * during that time, at the cost of CPU usage.
+ *
+ * \param spin_time_us Spin time in microseconds, 0 to disable spinning.
+ */
+void spdk_reactors_set_interrupt_spin_time(uint32_t spin_time_us);
+
+/**
+ * Get the time reactors in interrupt mode spin before going to sleep.
+ *
+ * \return Spin time in microseconds.
+ */
+uint32_t spdk_reactors_get_interrupt_spin_time(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -66,6 +66,10 @@ struct spdk_sock_group_impl {
 	struct spdk_sock_group			*group;
 	TAILQ_HEAD(, spdk_sock)			socks;
 	STAILQ_ENTRY(spdk_sock_group_impl)	link;
+	/* Updated by the socket modules */
+	struct spdk_sock_group_stats		stats;
+	/* Statistics already added to the metrics of the implementation */
+	struct spdk_sock_group_stats		metrics_stats;
 };
 
 struct spdk_sock_map {
@@ -112,6 +116,11 @@ struct spdk_net_impl {
 	int (*get_opts)(struct spdk_sock_impl_opts *opts, size_t *len);
 	int (*set_opts)(const struct spdk_sock_impl_opts *opts, size_t len);
 
+	/* Metrics of the groups of this implementation, registered with the first group */
+	struct spdk_metrics_group *metrics;
+	/* Number of groups of this implementation, protected by the metrics mutex */
+	uint32_t metrics_groups;
+
 	STAILQ_ENTRY(spdk_net_impl) link;
 };
 
@@ -184,6 +193,43 @@ spdk_sock_request_put(struct spdk_sock *sock, struct spdk_sock_request *req, int
 	return spdk_sock_request_complete(sock, req, err);
 }
 
+/*
+ * Complete the pending requests written by the zero copy sendmsg calls having indexes in
+ * [first, last].  A single notification from the error queue covers a range of sendmsg
+ * calls, so the pending requests are walked once for the whole range.  The requests that were
+ * sent without zero copy are completed as well, unless they wait behind a zero copy request
+ * that is still in flight.
+ *
+ * Returns the number of completed requests or a negative value if the socket was closed.
+ */
+static inline int
+spdk_sock_complete_zcopy_reqs(struct spdk_sock *sock, uint32_t first, uint32_t last)
+{
+	struct spdk_sock_request *req, *treq;
+	bool in_flight = false;
+	int rc, count = 0;
+
+	TAILQ_FOREACH_SAFE(req, &sock->pending_reqs, internal.link, treq) {
+		if (req->internal.is_zcopy) {
+			/* The range may wrap around */
+			if ((uint32_t)(req->internal.offset - first) > (uint32_t)(last - first)) {
+				in_flight = true;
+				continue;
+			}
+		} else if (in_flight) {
+			continue;
+		}
+
+		rc = spdk_sock_request_put(sock, req, 0);
+		if (rc < 0) {
+			return rc;
+		}
+		count++;
+	}
+
+	return count;
+}
+
 static inline int
 spdk_sock_abort_requests(struct spdk_sock *sock)
 {
@@ -340,6 +386,12 @@ spdk_sock_get_placement_id(int fd, enum spdk_placement_mode mode, int *placement
 			SPDK_ERRLOG("getsockopt() failed: %s\n", strerror(errno));
 			assert(false);
 		}
+
+		/* The socket hasn't received anything through a NAPI context (e.g. loopback).
+		 * Don't put all such sockets in the same group. */
+		if (mode == PLACEMENT_NAPI && *placement_id == 0) {
+			*placement_id = -1;
+		}
 #endif
 		break;
 	}
@@ -360,6 +412,43 @@ spdk_sock_get_placement_id(int fd, enum spdk_placement_mode mode, int *placement
 	}
 }
 
+static inline void
+spdk_sock_set_busy_poll(int fd, const struct spdk_sock_impl_opts *opts)
+{
+#if defined(SO_BUSY_POLL)
+	int val, rc;
+
+	if (opts->busy_poll_usecs == 0) {
+		return;
+	}
+
+	val = opts->busy_poll_usecs;
+	rc = setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val));
+	if (rc != 0) {
+		/* Values above net.core.busy_read need CAP_NET_ADMIN */
+		SPDK_WARNLOG("Failed to set SO_BUSY_POLL: %s\n", strerror(errno));
+		return;
+	}
+
+#if defined(SO_PREFER_BUSY_POLL)
+	val = 1;
+	rc = setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &val, sizeof(val));
+	if (rc != 0) {
+		SPDK_WARNLOG("Failed to set SO_PREFER_BUSY_POLL: %s\n", strerror(errno));
+	}
+#endif
+#if defined(SO_BUSY_POLL_BUDGET)
+	if (opts->busy_poll_budget != 0) {
+		val = opts->busy_poll_budget;
+		rc = setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &val, sizeof(val));
+		if (rc != 0) {
+			SPDK_WARNLOG("Failed to set SO_BUSY_POLL_BUDGET: %s\n", strerror(errno));
+		}
+	}
+#endif
+#endif
+}
+
 /**
  * Insert a group into the placement map.
  * If the group is already in the map, take a reference.
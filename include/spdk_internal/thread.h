@@ -10,10 +10,14 @@
 #include "spdk/thread.h"
 
 struct spdk_poller;
+struct spdk_histogram_data;
 
 struct spdk_poller_stats {
 	uint64_t	run_count;
 	uint64_t	busy_count;
+	/* Only tracked while poller histograms or the poller watchdog are enabled */
+	uint64_t	max_run_tsc;
+	uint64_t	slow_run_count;
 };
 
 struct io_device;
@@ -24,6 +28,8 @@ uint64_t spdk_poller_get_id(struct spdk_poller *poller);
 const char *spdk_poller_get_state_str(struct spdk_poller *poller);
 uint64_t spdk_poller_get_period_ticks(struct spdk_poller *poller);
 void spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stats);
+/* Returns NULL if the poller hasn't run while poller histograms were enabled */
+const struct spdk_histogram_data *spdk_poller_get_histogram(struct spdk_poller *poller);
 
 const char *spdk_io_channel_get_io_device_name(struct spdk_io_channel *ch);
 int spdk_io_channel_get_ref_count(struct spdk_io_channel *ch);
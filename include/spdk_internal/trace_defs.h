@@ -94,6 +94,9 @@
 #define TRACE_RDMA_QP_STATE_CHANGE					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0xF)
 #define TRACE_RDMA_QP_DISCONNECT					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x10)
 #define TRACE_RDMA_QP_DESTROY						SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x11)
+#define TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_START			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x12)
+#define TRACE_RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x13)
+#define TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_RELEASE			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x14)
 
 /* Thread tracepoint definitions */
 #define TRACE_THREAD_IOCH_GET		SPDK_TPOINT_ID(TRACE_GROUP_THREAD, 0x0)
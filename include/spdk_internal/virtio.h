@@ -139,6 +139,15 @@ struct virtqueue {
 	/** Thread that's polling this queue. */
 	struct spdk_thread *owner_thread;
 
+	/** Number of additional users sharing this queue with its owner. */
+	uint32_t shared_cnt;
+
+	/**
+	 * Serializes the users of a queue shared via virtio_dev_find_and_share_queue().
+	 * The library itself never takes it.
+	 */
+	pthread_spinlock_t lock;
+
 	uint16_t req_start;
 	uint16_t req_end;
 	uint16_t reqs_finished;
@@ -301,6 +310,22 @@ int virtio_dev_acquire_queue(struct virtio_dev *vdev, uint16_t index);
  */
 int32_t virtio_dev_find_and_acquire_queue(struct virtio_dev *vdev, uint16_t start_index);
 
+/**
+ * Share an already acquired queue with the current thread.  The queue with the fewest users
+ * in range from *start_index* (inclusive) up to vdev->max_queues (exclusive) is picked.  This
+ * is meant to be used when all queues are acquired already.  All users of a shared queue need
+ * to serialize their accesses with its lock, and the queue stays acquired until all of them
+ * release it.
+ *
+ * This function is thread-safe.
+ *
+ * \param vdev vhost device
+ * \param start_index virtqueue index to start looking from
+ * \return index of the shared queue or -1 in case no acquired queue in given range
+ * has been found
+ */
+int32_t virtio_dev_find_and_share_queue(struct virtio_dev *vdev, uint16_t start_index);
+
 /**
  * Get thread that acquired given virtqueue.
  *
@@ -325,9 +350,9 @@ struct spdk_thread *virtio_dev_queue_get_thread(struct virtio_dev *vdev, uint16_
 bool virtio_dev_queue_is_acquired(struct virtio_dev *vdev, uint16_t index);
 
 /**
- * Release previously acquired queue.
+ * Release previously acquired or shared queue.
  *
- * This function must be called from the thread that acquired the queue.
+ * This function must be called from the thread that acquired or shared the queue.
  *
  * \param vdev vhost device
  * \param index index of virtqueue to release
@@ -14,9 +14,11 @@
 #include "spdk/env.h"
 #include "spdk/likely.h"
 #include "spdk/log.h"
+#include "spdk/metrics.h"
 #include "spdk/thread.h"
 #include "spdk/json.h"
 #include "spdk/crc32.h"
+#include "spdk/dif.h"
 #include "spdk/util.h"
 #include "spdk/hexlify.h"
 
@@ -40,6 +42,17 @@
 struct accel_module {
 	struct spdk_accel_module_if	*module;
 	bool				supports_memory_domains;
+	struct spdk_accel_module_if	*small_module;
+	uint64_t			small_threshold;
+	struct spdk_accel_module_if	*spill_module;
+	uint32_t			spill_qd;
+};
+
+struct accel_opc_route {
+	char				*small_module;
+	uint64_t			small_threshold;
+	char				*spill_module;
+	uint32_t			spill_qd;
 };
 
 /* Largest context size for all accel modules */
@@ -58,10 +71,14 @@ static TAILQ_HEAD(, spdk_accel_module_if) spdk_accel_module_list =
 /* Crypto keyring */
 static TAILQ_HEAD(, spdk_accel_crypto_key) g_keyring = TAILQ_HEAD_INITIALIZER(g_keyring);
 static struct spdk_spinlock g_keyring_spin;
+/* Keys bound to hardware key slots, the next eviction candidate first */
+static TAILQ_HEAD(, spdk_accel_crypto_key) g_bound_keys = TAILQ_HEAD_INITIALIZER(g_bound_keys);
+static struct accel_crypto_key_slot_stats g_key_slot_stats;
 
 /* Global array mapping capabilities to modules */
 static struct accel_module g_modules_opc[SPDK_ACCEL_OPC_LAST] = {};
 static char *g_modules_opc_override[SPDK_ACCEL_OPC_LAST] = {};
+static struct accel_opc_route *g_modules_opc_route[SPDK_ACCEL_OPC_LAST] = {};
 TAILQ_HEAD(, spdk_accel_driver) g_accel_drivers = TAILQ_HEAD_INITIALIZER(g_accel_drivers);
 static struct spdk_accel_driver *g_accel_driver;
 static struct spdk_accel_opts g_opts = {
@@ -74,9 +91,31 @@ static struct spdk_accel_opts g_opts = {
 static struct accel_stats g_stats;
 static struct spdk_spinlock g_stats_lock;
 
+enum accel_metric {
+	ACCEL_METRIC_EXECUTED,
+	ACCEL_METRIC_FAILED,
+	ACCEL_METRIC_BYTES,
+};
+
+static const struct spdk_metric_desc g_accel_metrics_descs[] = {
+	[ACCEL_METRIC_EXECUTED] = {
+		"spdk_accel_executed", "Operations executed", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[ACCEL_METRIC_FAILED] = {
+		"spdk_accel_failed", "Operations that failed", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[ACCEL_METRIC_BYTES] = {
+		"spdk_accel_bytes", "Bytes processed", SPDK_METRIC_TYPE_COUNTER,
+	},
+};
+
+/* Metrics of each opcode, NULL if the metrics aren't enabled */
+static struct spdk_metrics_group *g_accel_metrics[SPDK_ACCEL_OPC_LAST];
+
 static const char *g_opcode_strings[SPDK_ACCEL_OPC_LAST] = {
 	"copy", "fill", "dualcast", "compare", "crc32c", "copy_crc32c",
-	"compress", "decompress", "encrypt", "decrypt", "xor"
+	"compress", "decompress", "encrypt", "decrypt", "xor",
+	"dif_verify", "dif_generate", "dif_generate_copy", "encrypt_crc32c"
 };
 
 enum accel_sequence_state {
@@ -138,6 +177,10 @@ struct accel_buffer {
 
 struct accel_io_channel {
 	struct spdk_io_channel			*module_ch[SPDK_ACCEL_OPC_LAST];
+	struct spdk_io_channel			*small_ch[SPDK_ACCEL_OPC_LAST];
+	struct spdk_io_channel			*spill_ch[SPDK_ACCEL_OPC_LAST];
+	/* Number of tasks outstanding on the primary module of each opcode */
+	uint32_t				outstanding[SPDK_ACCEL_OPC_LAST];
 	struct spdk_io_channel			*driver_channel;
 	void					*task_pool_base;
 	struct spdk_accel_sequence		*seq_pool_base;
@@ -243,6 +286,47 @@ _accel_get_opc_name(enum spdk_accel_opcode opcode, const char **opcode_name)
 	return rc;
 }
 
+const char *
+_accel_get_route_name(enum accel_route route)
+{
+	switch (route) {
+	case ACCEL_ROUTE_PRIMARY:
+		return "primary";
+	case ACCEL_ROUTE_SMALL:
+		return "small";
+	case ACCEL_ROUTE_SPILL:
+		return "spill";
+	default:
+		return NULL;
+	}
+}
+
+const char *
+_accel_get_route_module_name(enum spdk_accel_opcode opcode, enum accel_route route)
+{
+	struct spdk_accel_module_if *module;
+
+	if (opcode >= SPDK_ACCEL_OPC_LAST) {
+		return NULL;
+	}
+
+	switch (route) {
+	case ACCEL_ROUTE_PRIMARY:
+		module = g_modules_opc[opcode].module;
+		break;
+	case ACCEL_ROUTE_SMALL:
+		module = g_modules_opc[opcode].small_module;
+		break;
+	case ACCEL_ROUTE_SPILL:
+		module = g_modules_opc[opcode].spill_module;
+		break;
+	default:
+		return NULL;
+	}
+
+	return module != NULL ? module->name : NULL;
+}
+
 int
 spdk_accel_assign_opc(enum spdk_accel_opcode opcode, const char *name)
 {
@@ -269,12 +353,226 @@ spdk_accel_assign_opc(enum spdk_accel_opcode opcode, const char *name)
 	return 0;
 }
 
+static void
+accel_opc_route_free(struct accel_opc_route *route)
+{
+	if (route == NULL) {
+		return;
+	}
+
+	free(route->small_module);
+	free(route->spill_module);
+	free(route);
+}
+
+int
+spdk_accel_assign_opc_route(enum spdk_accel_opcode opcode, const char *small_module,
+			    uint64_t small_threshold, const char *spill_module, uint32_t spill_qd)
+{
+	struct accel_opc_route *route;
+
+	if (g_modules_started == true) {
+		/* we don't allow re-assignment once things have started */
+		return -EINVAL;
+	}
+
+	if (opcode >= SPDK_ACCEL_OPC_LAST) {
+		/* invalid opcode */
+		return -EINVAL;
+	}
+
+	/* Crypto keys are created by a specific module, so they can't be routed elsewhere */
+	if (opcode == SPDK_ACCEL_OPC_ENCRYPT || opcode == SPDK_ACCEL_OPC_DECRYPT ||
+	    opcode == SPDK_ACCEL_OPC_ENCRYPT_CRC32C) {
+		return -EINVAL;
+	}
+
+	if ((small_module != NULL && small_threshold == 0) ||
+	    (spill_module != NULL && spill_qd == 0)) {
+		return -EINVAL;
+	}
+
+	route = calloc(1, sizeof(*route));
+	if (route == NULL) {
+		return -ENOMEM;
+	}
+
+	if (small_module != NULL) {
+		route->small_module = strdup(small_module);
+		if (route->small_module == NULL) {
+			accel_opc_route_free(route);
+			return -ENOMEM;
+		}
+		route->small_threshold = small_threshold;
+	}
+
+	if (spill_module != NULL) {
+		route->spill_module = strdup(spill_module);
+		if (route->spill_module == NULL) {
+			accel_opc_route_free(route);
+			return -ENOMEM;
+		}
+		route->spill_qd = spill_qd;
+	}
+
+	/* module selection will be validated after the framework starts. */
+	accel_opc_route_free(g_modules_opc_route[opcode]);
+	if (route->small_module == NULL && route->spill_module == NULL) {
+		/* Nothing to route, simply clear the previous routing */
+		accel_opc_route_free(route);
+		route = NULL;
+	}
+	g_modules_opc_route[opcode] = route;
+
+	return 0;
+}
+
+static inline bool
+accel_task_uses_key_slot(struct spdk_accel_task *task)
+{
+	switch (task->op_code) {
+	case SPDK_ACCEL_OPC_ENCRYPT:
+	case SPDK_ACCEL_OPC_DECRYPT:
+	case SPDK_ACCEL_OPC_ENCRYPT_CRC32C:
+		return task->crypto_key != NULL && task->crypto_key->module_if != NULL &&
+		       task->crypto_key->module_if->crypto_key_bind != NULL;
+	default:
+		return false;
+	}
+}
+
+static void
+accel_crypto_key_unbind(struct spdk_accel_crypto_key *key)
+{
+	assert(spdk_spin_held(&g_keyring_spin));
+
+	__atomic_store_n(&key->slot.bound, false, __ATOMIC_SEQ_CST);
+	TAILQ_REMOVE(&g_bound_keys, key, slot.link);
+	g_key_slot_stats.num_bound--;
+	key->module_if->crypto_key_unbind(key);
+}
+
+/*
+ * Unbind the least recently used key that isn't used by any task.  Keys used since they were
+ * last passed over get a second chance, so that the I/O path only needs to set a flag instead of
+ * reordering the list under the lock.
+ */
+static bool
+accel_crypto_key_evict(void)
+{
+	struct spdk_accel_crypto_key *key;
+	uint32_t i;
+
+	for (i = 0; i < 2 * g_key_slot_stats.num_bound; i++) {
+		key = TAILQ_FIRST(&g_bound_keys);
+		TAILQ_REMOVE(&g_bound_keys, key, slot.link);
+		TAILQ_INSERT_TAIL(&g_bound_keys, key, slot.link);
+
+		if (__atomic_load_n(&key->slot.referenced, __ATOMIC_RELAXED)) {
+			__atomic_store_n(&key->slot.referenced, false, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		/* Either a task acquiring the key sees it unbound, or its reference is seen here */
+		__atomic_store_n(&key->slot.bound, false, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&key->slot.outstanding, __ATOMIC_SEQ_CST) != 0) {
+			__atomic_store_n(&key->slot.bound, true, __ATOMIC_SEQ_CST);
+			continue;
+		}
+
+		accel_crypto_key_unbind(key);
+		g_key_slot_stats.evictions++;
+		return true;
+	}
+
+	return false;
+}
+
+static int
+accel_crypto_key_bind(struct spdk_accel_crypto_key *key)
+{
+	struct spdk_accel_module_if *module = key->module_if;
+	int rc;
+
+	assert(spdk_spin_held(&g_keyring_spin));
+	assert(module->crypto_key_unbind && module->crypto_get_max_bound_keys);
+
+	if (key->slot.bound) {
+		return 0;
+	}
+
+	/* If all bound keys are in use, still try to bind it, the module might have the resources */
+	if (g_key_slot_stats.num_bound >= module->crypto_get_max_bound_keys()) {
+		accel_crypto_key_evict();
+	}
+
+	rc = module->crypto_key_bind(key);
+	if (rc != 0) {
+		SPDK_DEBUGLOG(accel, "Failed to bind crypto key %s: %d\n", key->param.key_name, rc);
+		g_key_slot_stats.bind_failures++;
+		return rc;
+	}
+
+	TAILQ_INSERT_TAIL(&g_bound_keys, key, slot.link);
+	g_key_slot_stats.num_bound++;
+	__atomic_store_n(&key->slot.bound, true, __ATOMIC_SEQ_CST);
+
+	return 0;
+}
+
+static inline void
+accel_crypto_key_release(struct spdk_accel_crypto_key *key)
+{
+	assert(key->slot.outstanding > 0);
+	__atomic_fetch_sub(&key->slot.outstanding, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Make sure the key is bound for the duration of a task */
+static inline int
+accel_crypto_key_acquire(struct accel_io_channel *accel_ch, struct spdk_accel_crypto_key *key)
+{
+	int rc;
+
+	__atomic_fetch_add(&key->slot.outstanding, 1, __ATOMIC_SEQ_CST);
+	if (spdk_likely(__atomic_load_n(&key->slot.bound, __ATOMIC_SEQ_CST))) {
+		/* Avoid writing to the shared cache line if the flag is already set */
+		if (!__atomic_load_n(&key->slot.referenced, __ATOMIC_RELAXED)) {
+			__atomic_store_n(&key->slot.referenced, true, __ATOMIC_RELAXED);
+		}
+		accel_ch->stats.crypto_key_hits++;
+		return 0;
+	}
+
+	accel_ch->stats.crypto_key_misses++;
+	spdk_spin_lock(&g_keyring_spin);
+	rc = accel_crypto_key_bind(key);
+	spdk_spin_unlock(&g_keyring_spin);
+	if (spdk_unlikely(rc != 0)) {
+		accel_crypto_key_release(key);
+	}
+
+	return rc;
+}
+
+static void
+accel_update_metrics(struct spdk_accel_task *task, int status)
+{
+	struct spdk_metrics_group *metrics = g_accel_metrics[task->op_code];
+
+	spdk_metrics_counter_add(metrics, ACCEL_METRIC_EXECUTED, 1);
+	spdk_metrics_counter_add(metrics, ACCEL_METRIC_BYTES, task->nbytes);
+	if (status != 0) {
+		spdk_metrics_counter_add(metrics, ACCEL_METRIC_FAILED, 1);
+	}
+}
+
 void
 spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 {
 	struct accel_io_channel *accel_ch = accel_task->accel_ch;
 	spdk_accel_completion_cb	cb_fn = accel_task->cb_fn;
 	void				*cb_arg = accel_task->cb_arg;
+	struct accel_route_stats	*route_stats;
 
 	/* We should put the accel_task into the list firstly in order to avoid
 	 * the accel task list is exhausted when there is recursive call to
@@ -288,6 +586,22 @@ spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 	if (spdk_unlikely(status != 0)) {
 		accel_update_task_stats(accel_ch, accel_task, failed, 1);
 	}
+	if (spdk_unlikely(g_accel_metrics[accel_task->op_code] != NULL)) {
+		accel_update_metrics(accel_task, status);
+	}
+	if (spdk_likely(accel_task->route != ACCEL_ROUTE_NONE)) {
+		route_stats = &accel_ch->stats.operations[accel_task->op_code].routes[accel_task->route];
+		route_stats->executed++;
+		route_stats->latency_ticks += spdk_get_ticks() - accel_task->submit_tsc;
+		if (accel_task->route == ACCEL_ROUTE_PRIMARY) {
+			assert(accel_ch->outstanding[accel_task->op_code] > 0);
+			accel_ch->outstanding[accel_task->op_code]--;
+		}
+		if (spdk_unlikely(accel_task_uses_key_slot(accel_task))) {
+			accel_crypto_key_release(accel_task->crypto_key);
+		}
+		accel_task->route = ACCEL_ROUTE_NONE;
+	}
 
 	cb_fn(cb_arg, status);
 }
@@ -311,6 +625,7 @@ _get_task(struct accel_io_channel *accel_ch, spdk_accel_completion_cb cb_fn, voi
 	accel_task->accel_ch = accel_ch;
 	accel_task->s.iovs = NULL;
 	accel_task->d.iovs = NULL;
+	accel_task->route = ACCEL_ROUTE_NONE;
 
 	return accel_task;
 }
@@ -318,13 +633,50 @@ _get_task(struct accel_io_channel *accel_ch, spdk_accel_completion_cb cb_fn, voi
 static inline int
 accel_submit_task(struct accel_io_channel *accel_ch, struct spdk_accel_task *task)
 {
+	struct accel_module *opc = &g_modules_opc[task->op_code];
 	struct spdk_io_channel *module_ch = accel_ch->module_ch[task->op_code];
-	struct spdk_accel_module_if *module = g_modules_opc[task->op_code].module;
+	struct spdk_accel_module_if *module = opc->module;
 	int rc;
 
+	if (spdk_unlikely(accel_task_uses_key_slot(task))) {
+		rc = accel_crypto_key_acquire(accel_ch, task->crypto_key);
+		if (spdk_unlikely(rc != 0)) {
+			accel_update_task_stats(accel_ch, task, failed, 1);
+			/* Tasks that are part of a sequence are released along with it */
+			if (task->seq == NULL) {
+				TAILQ_INSERT_HEAD(&accel_ch->task_pool, task, link);
+			}
+			return rc;
+		}
+	}
+
+	task->route = ACCEL_ROUTE_PRIMARY;
+	if (spdk_unlikely(opc->small_module != NULL) && task->nbytes < opc->small_threshold) {
+		module = opc->small_module;
+		module_ch = accel_ch->small_ch[task->op_code];
+		task->route = ACCEL_ROUTE_SMALL;
+	} else if (spdk_unlikely(opc->spill_module != NULL) &&
+		   accel_ch->outstanding[task->op_code] >= opc->spill_qd) {
+		module = opc->spill_module;
+		module_ch = accel_ch->spill_ch[task->op_code];
+		task->route = ACCEL_ROUTE_SPILL;
+	}
+
+	if (task->route == ACCEL_ROUTE_PRIMARY) {
+		accel_ch->outstanding[task->op_code]++;
+	}
+
+	task->submit_tsc = spdk_get_ticks();
 	rc = module->submit_tasks(module_ch, task);
 	if (spdk_unlikely(rc != 0)) {
 		accel_update_task_stats(accel_ch, task, failed, 1);
+		if (task->route == ACCEL_ROUTE_PRIMARY) {
+			accel_ch->outstanding[task->op_code]--;
+		}
+		if (spdk_unlikely(accel_task_uses_key_slot(task))) {
+			accel_crypto_key_release(task->crypto_key);
+		}
+		task->route = ACCEL_ROUTE_NONE;
 	}
 
 	return rc;
@@ -781,6 +1133,91 @@ spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uin
 	return accel_submit_task(accel_ch, accel_task);
 }
 
+int
+spdk_accel_submit_dif_verify(struct spdk_io_channel *ch,
+			     struct iovec *iovs, size_t iovcnt, uint32_t num_blocks,
+			     const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err,
+			     spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (spdk_unlikely(accel_task == NULL)) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = err;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->nbytes = num_blocks * ctx->block_size;
+	accel_task->op_code = SPDK_ACCEL_OPC_DIF_VERIFY;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dif_generate(struct spdk_io_channel *ch,
+			       struct iovec *iovs, size_t iovcnt, uint32_t num_blocks,
+			       const struct spdk_dif_ctx *ctx,
+			       spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (spdk_unlikely(accel_task == NULL)) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->nbytes = num_blocks * ctx->block_size;
+	accel_task->op_code = SPDK_ACCEL_OPC_DIF_GENERATE;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dif_generate_copy(struct spdk_io_channel *ch,
+				    struct iovec *dst_iovs, size_t dst_iovcnt,
+				    struct iovec *src_iovs, size_t src_iovcnt,
+				    uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				    spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (spdk_unlikely(accel_task == NULL)) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = src_iovs;
+	accel_task->s.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->nbytes = num_blocks * (ctx->block_size - ctx->md_size);
+	accel_task->op_code = SPDK_ACCEL_OPC_DIF_GENERATE_COPY;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
 static inline struct accel_buffer *
 accel_get_buf(struct accel_io_channel *ch, uint64_t len)
 {
@@ -966,6 +1403,55 @@ spdk_accel_append_fill(struct spdk_accel_sequence **pseq, struct spdk_io_channel
 	return 0;
 }
 
+int
+spdk_accel_append_compress(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			   struct iovec *dst_iovs, size_t dst_iovcnt,
+			   struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			   struct iovec *src_iovs, size_t src_iovcnt,
+			   struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			   uint32_t *output_size, int flags,
+			   spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->output_size = output_size;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
+	task->flags = flags;
+	task->op_code = SPDK_ACCEL_OPC_COMPRESS;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
 int
 spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
 			     struct iovec *dst_iovs, size_t dst_iovcnt,
@@ -995,19 +1481,219 @@ spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_c
 		return -ENOMEM;
 	}
 
-	/* TODO: support output_size for chaining */
-	task->output_size = NULL;
+	/* TODO: support output_size for chaining */
+	task->output_size = NULL;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
+	task->flags = flags;
+	task->op_code = SPDK_ACCEL_OPC_DECOMPRESS;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			  uint64_t iv, uint32_t block_size, int flags,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	assert(dst_iovs && dst_iovcnt && src_iovs && src_iovcnt && key && block_size);
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->crypto_key = key;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
+	task->iv = iv;
+	task->block_size = block_size;
+	task->flags = flags;
+	task->op_code = SPDK_ACCEL_OPC_ENCRYPT;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			  uint64_t iv, uint32_t block_size, int flags,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	assert(dst_iovs && dst_iovcnt && src_iovs && src_iovcnt && key && block_size);
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->crypto_key = key;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
+	task->iv = iv;
+	task->block_size = block_size;
+	task->flags = flags;
+	task->op_code = SPDK_ACCEL_OPC_DECRYPT;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			 uint32_t *dst, struct iovec *iovs, uint32_t iovcnt,
+			 struct spdk_memory_domain *domain, void *domain_ctx,
+			 uint32_t seed, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->s.iovs = iovs;
+	task->s.iovcnt = iovcnt;
+	task->src_domain = domain;
+	task->src_domain_ctx = domain_ctx;
+	task->nbytes = accel_get_iovlen(iovs, iovcnt);
+	task->crc_dst = dst;
+	task->seed = seed;
+	task->op_code = SPDK_ACCEL_OPC_CRC32C;
+	task->dst_domain = NULL;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_xor(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+		      struct iovec *dst_iovs, uint32_t dst_iovcnt,
+		      struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+		      void **sources, uint32_t nsrcs, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (spdk_unlikely(dst_iovcnt != 1)) {
+		return -EINVAL;
+	}
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	/* The sources share the union with the src iovecs, so the src domain must stay NULL to
+	 * prevent the sequence from trying to pull or bounce them */
+	task->nsrcs.srcs = sources;
+	task->nsrcs.cnt = nsrcs;
+	task->src_domain = NULL;
 	task->dst_domain = dst_domain;
 	task->dst_domain_ctx = dst_domain_ctx;
 	task->d.iovs = dst_iovs;
 	task->d.iovcnt = dst_iovcnt;
-	task->src_domain = src_domain;
-	task->src_domain_ctx = src_domain_ctx;
-	task->s.iovs = src_iovs;
-	task->s.iovcnt = src_iovcnt;
-	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
-	task->flags = flags;
-	task->op_code = SPDK_ACCEL_OPC_DECOMPRESS;
+	task->nbytes = dst_iovs[0].iov_len;
+	task->op_code = SPDK_ACCEL_OPC_XOR;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -1016,21 +1702,16 @@ spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_c
 }
 
 int
-spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
-			  struct spdk_accel_crypto_key *key,
-			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
-			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
-			  struct iovec *src_iovs, uint32_t src_iovcnt,
-			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
-			  uint64_t iv, uint32_t block_size, int flags,
-			  spdk_accel_step_cb cb_fn, void *cb_arg)
+spdk_accel_append_dif_verify(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			     struct iovec *iovs, size_t iovcnt,
+			     struct spdk_memory_domain *domain, void *domain_ctx,
+			     uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			     struct spdk_dif_error *err, spdk_accel_step_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *task;
 	struct spdk_accel_sequence *seq = *pseq;
 
-	assert(dst_iovs && dst_iovcnt && src_iovs && src_iovcnt && key && block_size);
-
 	if (seq == NULL) {
 		seq = accel_sequence_get(accel_ch);
 		if (spdk_unlikely(seq == NULL)) {
@@ -1048,20 +1729,16 @@ spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 		return -ENOMEM;
 	}
 
-	task->crypto_key = key;
-	task->src_domain = src_domain;
-	task->src_domain_ctx = src_domain_ctx;
-	task->s.iovs = src_iovs;
-	task->s.iovcnt = src_iovcnt;
-	task->dst_domain = dst_domain;
-	task->dst_domain_ctx = dst_domain_ctx;
-	task->d.iovs = dst_iovs;
-	task->d.iovcnt = dst_iovcnt;
-	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
-	task->iv = iv;
-	task->block_size = block_size;
-	task->flags = flags;
-	task->op_code = SPDK_ACCEL_OPC_ENCRYPT;
+	task->s.iovs = iovs;
+	task->s.iovcnt = iovcnt;
+	task->src_domain = domain;
+	task->src_domain_ctx = domain_ctx;
+	task->dif.ctx = ctx;
+	task->dif.err = err;
+	task->dif.num_blocks = num_blocks;
+	task->nbytes = num_blocks * ctx->block_size;
+	task->op_code = SPDK_ACCEL_OPC_DIF_VERIFY;
+	task->dst_domain = NULL;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -1070,20 +1747,21 @@ spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 }
 
 int
-spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
-			  struct spdk_accel_crypto_key *key,
-			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
-			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
-			  struct iovec *src_iovs, uint32_t src_iovcnt,
-			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
-			  uint64_t iv, uint32_t block_size, int flags,
-			  spdk_accel_step_cb cb_fn, void *cb_arg)
+spdk_accel_append_dif_generate(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			       struct iovec *iovs, size_t iovcnt,
+			       struct spdk_memory_domain *domain, void *domain_ctx,
+			       uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			       spdk_accel_step_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *task;
 	struct spdk_accel_sequence *seq = *pseq;
 
-	assert(dst_iovs && dst_iovcnt && src_iovs && src_iovcnt && key && block_size);
+	/* The PI is generated in place, so the result would be lost in a bounce buffer */
+	if (domain != NULL && domain != g_accel_domain) {
+		SPDK_ERRLOG("DIF generate doesn't support external memory domains\n");
+		return -EINVAL;
+	}
 
 	if (seq == NULL) {
 		seq = accel_sequence_get(accel_ch);
@@ -1102,20 +1780,15 @@ spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 		return -ENOMEM;
 	}
 
-	task->crypto_key = key;
-	task->src_domain = src_domain;
-	task->src_domain_ctx = src_domain_ctx;
-	task->s.iovs = src_iovs;
-	task->s.iovcnt = src_iovcnt;
-	task->dst_domain = dst_domain;
-	task->dst_domain_ctx = dst_domain_ctx;
-	task->d.iovs = dst_iovs;
-	task->d.iovcnt = dst_iovcnt;
-	task->nbytes = accel_get_iovlen(src_iovs, src_iovcnt);
-	task->iv = iv;
-	task->block_size = block_size;
-	task->flags = flags;
-	task->op_code = SPDK_ACCEL_OPC_DECRYPT;
+	task->s.iovs = iovs;
+	task->s.iovcnt = iovcnt;
+	task->src_domain = domain;
+	task->src_domain_ctx = domain_ctx;
+	task->dif.ctx = ctx;
+	task->dif.num_blocks = num_blocks;
+	task->nbytes = num_blocks * ctx->block_size;
+	task->op_code = SPDK_ACCEL_OPC_DIF_GENERATE;
+	task->dst_domain = NULL;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -1124,10 +1797,13 @@ spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 }
 
 int
-spdk_accel_append_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
-			 uint32_t *dst, struct iovec *iovs, uint32_t iovcnt,
-			 struct spdk_memory_domain *domain, void *domain_ctx,
-			 uint32_t seed, spdk_accel_step_cb cb_fn, void *cb_arg)
+spdk_accel_append_dif_generate_copy(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+				    struct iovec *dst_iovs, size_t dst_iovcnt,
+				    struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+				    struct iovec *src_iovs, size_t src_iovcnt,
+				    struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+				    uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				    spdk_accel_step_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *task;
@@ -1150,15 +1826,18 @@ spdk_accel_append_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_chann
 		return -ENOMEM;
 	}
 
-	task->s.iovs = iovs;
-	task->s.iovcnt = iovcnt;
-	task->src_domain = domain;
-	task->src_domain_ctx = domain_ctx;
-	task->nbytes = accel_get_iovlen(iovs, iovcnt);
-	task->crc_dst = dst;
-	task->seed = seed;
-	task->op_code = SPDK_ACCEL_OPC_CRC32C;
-	task->dst_domain = NULL;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->dif.ctx = ctx;
+	task->dif.num_blocks = num_blocks;
+	task->nbytes = num_blocks * (ctx->block_size - ctx->md_size);
+	task->op_code = SPDK_ACCEL_OPC_DIF_GENERATE_COPY;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -1455,12 +2134,45 @@ accel_iobuf_get_dst_bounce_cb(struct spdk_iobuf_entry *entry, void *buf)
 	accel_process_sequence(accel_buf->seq);
 }
 
+static bool
+accel_module_can_access_domain(struct spdk_accel_module_if *module,
+			       struct spdk_memory_domain *domain)
+{
+	if (module->can_access_memory_domain == NULL) {
+		return false;
+	}
+
+	return module->can_access_memory_domain(domain);
+}
+
+/* Checks whether all modules an opcode is routed to can access a memory domain natively */
+static bool
+accel_opcode_can_access_domain(enum spdk_accel_opcode opcode, struct spdk_memory_domain *domain)
+{
+	struct accel_module *module = &g_modules_opc[opcode];
+
+	if (!accel_module_can_access_domain(module->module, domain)) {
+		return false;
+	}
+	if (module->small_module != NULL &&
+	    !accel_module_can_access_domain(module->small_module, domain)) {
+		return false;
+	}
+	if (module->spill_module != NULL &&
+	    !accel_module_can_access_domain(module->spill_module, domain)) {
+		return false;
+	}
+
+	return true;
+}
+
 static int
 accel_sequence_check_bouncebuf(struct spdk_accel_sequence *seq, struct spdk_accel_task *task)
 {
 	struct accel_buffer *buf;
 
-	if (task->src_domain != NULL) {
+	if (task->src_domain != NULL &&
+	    !accel_opcode_can_access_domain(task->op_code, task->src_domain)) {
 		/* By the time we're here, accel buffers should have been allocated */
 		assert(task->src_domain != g_accel_domain);
 
@@ -1479,7 +2191,8 @@ accel_sequence_check_bouncebuf(struct spdk_accel_sequence *seq, struct spdk_acce
 					&task->src_domain, &task->src_domain_ctx, buf);
 	}
 
-	if (task->dst_domain != NULL) {
+	if (task->dst_domain != NULL &&
+	    !accel_opcode_can_access_domain(task->op_code, task->dst_domain)) {
 		/* By the time we're here, accel buffers should have been allocated */
 		assert(task->dst_domain != g_accel_domain);
 
@@ -1527,6 +2240,10 @@ accel_task_pull_data(struct spdk_accel_sequence *seq, struct spdk_accel_task *ta
 	assert(task->bounce.s.orig_domain != g_accel_domain);
 	assert(!g_modules_opc[task->op_code].supports_memory_domains);
 
+	accel_update_task_stats(seq->ch, task, num_bounce_bufs, 1);
+	accel_update_task_stats(seq->ch, task, bounce_bytes,
+				accel_get_iovlen(task->s.iovs, task->s.iovcnt));
+
 	rc = spdk_memory_domain_pull_data(task->bounce.s.orig_domain,
 					  task->bounce.s.orig_domain_ctx,
 					  task->bounce.s.orig_iovs, task->bounce.s.orig_iovcnt,
@@ -1564,6 +2281,10 @@ accel_task_push_data(struct spdk_accel_sequence *seq, struct spdk_accel_task *ta
 	assert(task->bounce.d.orig_domain != g_accel_domain);
 	assert(!g_modules_opc[task->op_code].supports_memory_domains);
 
+	accel_update_task_stats(seq->ch, task, num_bounce_bufs, 1);
+	accel_update_task_stats(seq->ch, task, bounce_bytes,
+				accel_get_iovlen(task->d.iovs, task->d.iovcnt));
+
 	rc = spdk_memory_domain_push_data(task->bounce.d.orig_domain,
 					  task->bounce.d.orig_domain_ctx,
 					  task->bounce.d.orig_iovs, task->bounce.d.orig_iovcnt,
@@ -1799,10 +2520,19 @@ accel_task_set_dstbuf(struct spdk_accel_task *task, struct spdk_accel_task *next
 	struct spdk_accel_task *prev;
 
 	switch (task->op_code) {
+	case SPDK_ACCEL_OPC_XOR:
+		/* xor can only write to a single buffer */
+		if (next->d.iovcnt != 1) {
+			return false;
+		}
+	/* Fall through */
+	case SPDK_ACCEL_OPC_COMPRESS:
 	case SPDK_ACCEL_OPC_DECOMPRESS:
 	case SPDK_ACCEL_OPC_FILL:
 	case SPDK_ACCEL_OPC_ENCRYPT:
 	case SPDK_ACCEL_OPC_DECRYPT:
+	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
+	case SPDK_ACCEL_OPC_ENCRYPT_CRC32C:
 		if (task->dst_domain != next->src_domain) {
 			return false;
 		}
@@ -1824,13 +2554,17 @@ accel_task_set_dstbuf(struct spdk_accel_task *task, struct spdk_accel_task *next
 					next->s.iovs, next->s.iovcnt)) {
 			return false;
 		}
-		/* We can only change crc32's buffer if we can change previous task's buffer */
+		/* We can only change crc32's buffer if we can change previous task's buffer.  If
+		 * that's not possible, fuse the crc32 with the copy into a single copy_crc32c
+		 * operation instead. */
 		prev = TAILQ_PREV(task, accel_sequence_tasks, seq_link);
-		if (prev == NULL) {
-			return false;
-		}
-		if (!accel_task_set_dstbuf(prev, next)) {
-			return false;
+		if (prev == NULL || !accel_task_set_dstbuf(prev, next)) {
+			task->d.iovs = next->d.iovs;
+			task->d.iovcnt = next->d.iovcnt;
+			task->dst_domain = next->dst_domain;
+			task->dst_domain_ctx = next->dst_domain_ctx;
+			task->op_code = SPDK_ACCEL_OPC_COPY_CRC32C;
+			break;
 		}
 		task->s.iovs = next->d.iovs;
 		task->s.iovcnt = next->d.iovcnt;
@@ -1857,11 +2591,13 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 		 * change the src of the operation after fill (which in turn could also be a fill).
 		 * So, for the sake of simplicity, skip this type of operations for now.
 		 */
-		if (next->op_code != SPDK_ACCEL_OPC_DECOMPRESS &&
+		if (next->op_code != SPDK_ACCEL_OPC_COMPRESS &&
+		    next->op_code != SPDK_ACCEL_OPC_DECOMPRESS &&
 		    next->op_code != SPDK_ACCEL_OPC_COPY &&
 		    next->op_code != SPDK_ACCEL_OPC_ENCRYPT &&
 		    next->op_code != SPDK_ACCEL_OPC_DECRYPT &&
-		    next->op_code != SPDK_ACCEL_OPC_CRC32C) {
+		    next->op_code != SPDK_ACCEL_OPC_CRC32C &&
+		    next->op_code != SPDK_ACCEL_OPC_DIF_GENERATE_COPY) {
 			break;
 		}
 		if (task->dst_domain != next->src_domain) {
@@ -1878,11 +2614,15 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 		TAILQ_REMOVE(&seq->tasks, task, seq_link);
 		TAILQ_INSERT_TAIL(&seq->completed, task, seq_link);
 		break;
+	case SPDK_ACCEL_OPC_COMPRESS:
 	case SPDK_ACCEL_OPC_DECOMPRESS:
 	case SPDK_ACCEL_OPC_FILL:
 	case SPDK_ACCEL_OPC_ENCRYPT:
 	case SPDK_ACCEL_OPC_DECRYPT:
 	case SPDK_ACCEL_OPC_CRC32C:
+	case SPDK_ACCEL_OPC_XOR:
+	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
+	case SPDK_ACCEL_OPC_ENCRYPT_CRC32C:
 		/* We can only merge tasks when one of them is a copy */
 		if (next->op_code != SPDK_ACCEL_OPC_COPY) {
 			break;
@@ -1896,12 +2636,52 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 		TAILQ_REMOVE(&seq->tasks, next, seq_link);
 		TAILQ_INSERT_TAIL(&seq->completed, next, seq_link);
 		break;
+	case SPDK_ACCEL_OPC_COPY_CRC32C:
+	case SPDK_ACCEL_OPC_DIF_VERIFY:
+	case SPDK_ACCEL_OPC_DIF_GENERATE:
+		/* These operations either work in place or are the result of fusing a crc32c with a
+		 * copy, so there's nothing to merge */
+		break;
 	default:
 		assert(0 && "bad opcode");
 		break;
 	}
 }
 
+static void
+accel_sequence_fuse_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_task *task,
+			  struct spdk_accel_task **next_task)
+{
+	struct spdk_accel_task *next = *next_task;
+
+	switch (task->op_code) {
+	case SPDK_ACCEL_OPC_ENCRYPT:
+		/* Only fuse the operations if the module doing the encryption can also checksum the
+		 * encrypted data in the same pass */
+		if (next->op_code != SPDK_ACCEL_OPC_CRC32C ||
+		    g_modules_opc[SPDK_ACCEL_OPC_ENCRYPT_CRC32C].module !=
+		    g_modules_opc[SPDK_ACCEL_OPC_ENCRYPT].module) {
+			break;
+		}
+		if (task->dst_domain != next->src_domain) {
+			break;
+		}
+		if (!accel_compare_iovs(task->d.iovs, task->d.iovcnt,
+					next->s.iovs, next->s.iovcnt)) {
+			break;
+		}
+		task->fused_crc_dst = next->crc_dst;
+		task->fused_seed = next->seed;
+		task->op_code = SPDK_ACCEL_OPC_ENCRYPT_CRC32C;
+		*next_task = TAILQ_NEXT(next, seq_link);
+		TAILQ_REMOVE(&seq->tasks, next, seq_link);
+		TAILQ_INSERT_TAIL(&seq->completed, next, seq_link);
+		break;
+	default:
+		break;
+	}
+}
+
 void
 spdk_accel_sequence_finish(struct spdk_accel_sequence *seq,
 			   spdk_accel_completion_cb cb_fn, void *cb_arg)
@@ -1916,6 +2696,14 @@ spdk_accel_sequence_finish(struct spdk_accel_sequence *seq,
 		accel_sequence_merge_tasks(seq, task, &next);
 	}
 
+	/* Then fuse the operations that a module can execute in a single pass over the data */
+	TAILQ_FOREACH_SAFE(task, &seq->tasks, seq_link, next) {
+		if (next == NULL) {
+			break;
+		}
+		accel_sequence_fuse_tasks(seq, task, &next);
+	}
+
 	seq->cb_fn = cb_fn;
 	seq->cb_arg = cb_arg;
 
@@ -2281,6 +3069,9 @@ spdk_accel_crypto_key_destroy(struct spdk_accel_crypto_key *key)
 		return -ENOENT;
 	}
 	TAILQ_REMOVE(&g_keyring, key, link);
+	if (key->slot.bound) {
+		accel_crypto_key_unbind(key);
+	}
 	spdk_spin_unlock(&g_keyring_spin);
 
 	accel_crypto_key_destroy_unsafe(key);
@@ -2300,6 +3091,51 @@ spdk_accel_crypto_key_get(const char *name)
 	return key;
 }
 
+int
+spdk_accel_crypto_key_prefetch(struct spdk_accel_crypto_key *key)
+{
+	int rc = 0;
+
+	if (!key || !key->module_if) {
+		return -EINVAL;
+	}
+
+	if (!key->module_if->crypto_key_bind ||
+	    __atomic_load_n(&key->slot.bound, __ATOMIC_SEQ_CST)) {
+		return 0;
+	}
+
+	spdk_spin_lock(&g_keyring_spin);
+	if (!key->slot.bound) {
+		g_key_slot_stats.prefetches++;
+		rc = accel_crypto_key_bind(key);
+		if (rc == 0) {
+			/* Keep it around until the first task gets to use it */
+			key->slot.referenced = true;
+		}
+	}
+	spdk_spin_unlock(&g_keyring_spin);
+
+	return rc;
+}
+
+bool
+accel_crypto_key_get_slot_stats(struct accel_crypto_key_slot_stats *stats)
+{
+	struct spdk_accel_module_if *module = g_modules_opc[SPDK_ACCEL_OPC_ENCRYPT].module;
+
+	if (!module || !module->crypto_key_bind) {
+		return false;
+	}
+
+	spdk_spin_lock(&g_keyring_spin);
+	*stats = g_key_slot_stats;
+	spdk_spin_unlock(&g_keyring_spin);
+	stats->max_bound = module->crypto_get_max_bound_keys();
+
+	return true;
+}
+
 /* Helper function when accel modules register with the framework. */
 void
 spdk_accel_module_list_add(struct spdk_accel_module_if *accel_module)
@@ -2379,6 +3215,27 @@ accel_create_channel(void *io_device, void *ctx_buf)
 			SPDK_ERRLOG("Module %s failed to get io channel\n", g_modules_opc[i].module->name);
 			goto err;
 		}
+		if (g_modules_opc[i].small_module != NULL) {
+			accel_ch->small_ch[i] = g_modules_opc[i].small_module->get_io_channel();
+			if (accel_ch->small_ch[i] == NULL) {
+				SPDK_ERRLOG("Module %s failed to get io channel\n",
+					    g_modules_opc[i].small_module->name);
+				spdk_put_io_channel(accel_ch->module_ch[i]);
+				goto err;
+			}
+		}
+		if (g_modules_opc[i].spill_module != NULL) {
+			accel_ch->spill_ch[i] = g_modules_opc[i].spill_module->get_io_channel();
+			if (accel_ch->spill_ch[i] == NULL) {
+				SPDK_ERRLOG("Module %s failed to get io channel\n",
+					    g_modules_opc[i].spill_module->name);
+				if (accel_ch->small_ch[i] != NULL) {
+					spdk_put_io_channel(accel_ch->small_ch[i]);
+				}
+				spdk_put_io_channel(accel_ch->module_ch[i]);
+				goto err;
+			}
+		}
 	}
 
 	if (g_accel_driver != NULL) {
@@ -2403,6 +3260,12 @@ err:
 	}
 	for (j = 0; j < i; j++) {
 		spdk_put_io_channel(accel_ch->module_ch[j]);
+		if (accel_ch->small_ch[j] != NULL) {
+			spdk_put_io_channel(accel_ch->small_ch[j]);
+		}
+		if (accel_ch->spill_ch[j] != NULL) {
+			spdk_put_io_channel(accel_ch->spill_ch[j]);
+		}
 	}
 	free(accel_ch->task_pool_base);
 	free(accel_ch->seq_pool_base);
@@ -2414,14 +3277,24 @@ err:
 static void
 accel_add_stats(struct accel_stats *total, struct accel_stats *stats)
 {
-	int i;
+	int i, j;
 
 	total->sequence_executed += stats->sequence_executed;
 	total->sequence_failed += stats->sequence_failed;
+	total->crypto_key_hits += stats->crypto_key_hits;
+	total->crypto_key_misses += stats->crypto_key_misses;
 	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
 		total->operations[i].executed += stats->operations[i].executed;
 		total->operations[i].failed += stats->operations[i].failed;
 		total->operations[i].num_bytes += stats->operations[i].num_bytes;
+		total->operations[i].num_bounce_bufs += stats->operations[i].num_bounce_bufs;
+		total->operations[i].bounce_bytes += stats->operations[i].bounce_bytes;
+		for (j = ACCEL_ROUTE_PRIMARY; j < ACCEL_ROUTE_COUNT; ++j) {
+			total->operations[i].routes[j].executed +=
+				stats->operations[i].routes[j].executed;
+			total->operations[i].routes[j].latency_ticks +=
+				stats->operations[i].routes[j].latency_ticks;
+		}
 	}
 }
 
@@ -2442,6 +3315,14 @@ accel_destroy_channel(void *io_device, void *ctx_buf)
 		assert(accel_ch->module_ch[i] != NULL);
 		spdk_put_io_channel(accel_ch->module_ch[i]);
 		accel_ch->module_ch[i] = NULL;
+		if (accel_ch->small_ch[i] != NULL) {
+			spdk_put_io_channel(accel_ch->small_ch[i]);
+			accel_ch->small_ch[i] = NULL;
+		}
+		if (accel_ch->spill_ch[i] != NULL) {
+			spdk_put_io_channel(accel_ch->spill_ch[i]);
+			accel_ch->spill_ch[i] = NULL;
+		}
 	}
 
 	/* Update global stats to make sure channel's stats aren't lost after a channel is gone */
@@ -2482,15 +3363,78 @@ accel_module_initialize(void)
 	return rc;
 }
 
+static bool
+accel_module_supports_memory_domains(struct spdk_accel_module_if *module_if)
+{
+	if (module_if->get_memory_domains == NULL) {
+		return false;
+	}
+
+	return module_if->get_memory_domains(NULL, 0) > 0;
+}
+
 static void
 accel_module_init_opcode(enum spdk_accel_opcode opcode)
 {
 	struct accel_module *module = &g_modules_opc[opcode];
-	struct spdk_accel_module_if *module_if = module->module;
 
-	if (module_if->get_memory_domains != NULL) {
-		module->supports_memory_domains = module_if->get_memory_domains(NULL, 0) > 0;
+	/* Bounce buffers are used unless all modules the opcode is routed to support memory
+	 * domains */
+	module->supports_memory_domains = accel_module_supports_memory_domains(module->module);
+	if (module->small_module != NULL) {
+		module->supports_memory_domains &=
+			accel_module_supports_memory_domains(module->small_module);
+	}
+	if (module->spill_module != NULL) {
+		module->supports_memory_domains &=
+			accel_module_supports_memory_domains(module->spill_module);
+	}
+}
+
+static struct spdk_accel_module_if *
+accel_find_route_module(enum spdk_accel_opcode opcode, const char *name)
+{
+	struct spdk_accel_module_if *accel_module;
+
+	accel_module = _module_find_by_name(name);
+	if (accel_module == NULL) {
+		SPDK_ERRLOG("Invalid module name of %s\n", name);
+		return NULL;
+	}
+	if (accel_module->supports_opcode(opcode) == false) {
+		SPDK_ERRLOG("Module %s does not support op code %d\n", accel_module->name, opcode);
+		return NULL;
+	}
+
+	return accel_module;
+}
+
+static int
+accel_module_init_route(enum spdk_accel_opcode opcode)
+{
+	struct accel_opc_route *route = g_modules_opc_route[opcode];
+	struct accel_module *module = &g_modules_opc[opcode];
+
+	if (route == NULL) {
+		return 0;
+	}
+
+	if (route->small_module != NULL) {
+		module->small_module = accel_find_route_module(opcode, route->small_module);
+		if (module->small_module == NULL) {
+			return -EINVAL;
+		}
+		module->small_threshold = route->small_threshold;
+	}
+	if (route->spill_module != NULL) {
+		module->spill_module = accel_find_route_module(opcode, route->spill_module);
+		if (module->spill_module == NULL) {
+			return -EINVAL;
+		}
+		module->spill_qd = route->spill_qd;
 	}
+
+	return 0;
 }
 
 int
@@ -2561,7 +3505,14 @@ spdk_accel_initialize(void)
 
 	for (op = 0; op < SPDK_ACCEL_OPC_LAST; op++) {
 		assert(g_modules_opc[op].module != NULL);
+		rc = accel_module_init_route(op);
+		if (rc != 0) {
+			return rc;
+		}
 		accel_module_init_opcode(op);
+		g_accel_metrics[op] = spdk_metrics_group_register(g_accel_metrics_descs,
+				      SPDK_COUNTOF(g_accel_metrics_descs),
+				      "opcode", g_opcode_strings[op]);
 	}
 
 	rc = spdk_iobuf_register_module("accel");
@@ -2596,6 +3547,26 @@ accel_write_overridden_opc(struct spdk_json_write_ctx *w, const char *opc_str,
 	spdk_json_write_object_end(w);
 }
 
+static void
+accel_write_opc_route(struct spdk_json_write_ctx *w, const char *opc_str,
+		      struct accel_opc_route *route)
+{
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "accel_assign_opc_route");
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "opname", opc_str);
+	if (route->small_module != NULL) {
+		spdk_json_write_named_string(w, "small_module", route->small_module);
+		spdk_json_write_named_uint64(w, "small_threshold", route->small_threshold);
+	}
+	if (route->spill_module != NULL) {
+		spdk_json_write_named_string(w, "spill_module", route->spill_module);
+		spdk_json_write_named_uint32(w, "spill_qd", route->spill_qd);
+	}
+	spdk_json_write_object_end(w);
+	spdk_json_write_object_end(w);
+}
+
 static void
 __accel_crypto_key_dump_param(struct spdk_json_write_ctx *w, struct spdk_accel_crypto_key *key)
 {
@@ -2686,6 +3657,9 @@ spdk_accel_write_config_json(struct spdk_json_write_ctx *w)
 		if (g_modules_opc_override[i]) {
 			accel_write_overridden_opc(w, g_opcode_strings[i], g_modules_opc_override[i]);
 		}
+		if (g_modules_opc_route[i]) {
+			accel_write_opc_route(w, g_opcode_strings[i], g_modules_opc_route[i]);
+		}
 	}
 
 	_accel_crypto_keys_write_config_json(w, true);
@@ -2728,6 +3702,9 @@ accel_io_device_unregister_cb(void *io_device)
 
 	spdk_spin_lock(&g_keyring_spin);
 	TAILQ_FOREACH_SAFE(key, &g_keyring, link, key_tmp) {
+		if (key->slot.bound) {
+			accel_crypto_key_unbind(key);
+		}
 		accel_crypto_key_destroy_unsafe(key);
 	}
 	spdk_spin_unlock(&g_keyring_spin);
@@ -2737,7 +3714,11 @@ accel_io_device_unregister_cb(void *io_device)
 			free(g_modules_opc_override[op]);
 			g_modules_opc_override[op] = NULL;
 		}
-		g_modules_opc[op].module = NULL;
+		accel_opc_route_free(g_modules_opc_route[op]);
+		g_modules_opc_route[op] = NULL;
+		memset(&g_modules_opc[op], 0, sizeof(g_modules_opc[op]));
+		spdk_metrics_group_unregister(g_accel_metrics[op]);
+		g_accel_metrics[op] = NULL;
 	}
 
 	spdk_accel_module_finish();
@@ -2890,26 +3871,47 @@ spdk_accel_get_opcode_stats(struct spdk_io_channel *ch, enum spdk_accel_opcode o
 #undef SET_FIELD
 }
 
+static uint8_t
+accel_module_get_buf_align(struct spdk_accel_module_if *module, enum spdk_accel_opcode opcode,
+			   const struct spdk_accel_operation_exec_ctx *ctx)
+{
+	struct spdk_accel_opcode_info modinfo = {};
+
+	if (module->get_operation_info != NULL) {
+		module->get_operation_info(opcode, ctx, &modinfo);
+	}
+
+	return modinfo.required_alignment;
+}
+
 uint8_t
 spdk_accel_get_buf_align(enum spdk_accel_opcode opcode,
 			 const struct spdk_accel_operation_exec_ctx *ctx)
 {
-	struct spdk_accel_module_if *module = g_modules_opc[opcode].module;
-	struct spdk_accel_opcode_info modinfo = {}, drvinfo = {};
+	struct accel_module *module = &g_modules_opc[opcode];
+	struct spdk_accel_opcode_info drvinfo = {};
+	uint8_t alignment;
 
 	if (g_accel_driver != NULL && g_accel_driver->get_operation_info != NULL) {
 		g_accel_driver->get_operation_info(opcode, ctx, &drvinfo);
 	}
 
-	if (module->get_operation_info != NULL) {
-		module->get_operation_info(opcode, ctx, &modinfo);
+	alignment = accel_module_get_buf_align(module->module, opcode, ctx);
+	/* Buffers need to satisfy all the modules an operation might be routed to */
+	if (module->small_module != NULL) {
+		alignment = spdk_max(alignment,
+				     accel_module_get_buf_align(module->small_module, opcode, ctx));
+	}
+	if (module->spill_module != NULL) {
+		alignment = spdk_max(alignment,
+				     accel_module_get_buf_align(module->spill_module, opcode, ctx));
 	}
 
 	/* If a driver is set, it'll execute most of the operations, while the rest will usually
 	 * fall back to accel_sw, which doesn't have any alignment requiremenets.  However, to be
 	 * extra safe, return the max(driver, module) if a driver delegates some operations to a
 	 * hardware module. */
-	return spdk_max(modinfo.required_alignment, drvinfo.required_alignment);
+	return spdk_max(alignment, drvinfo.required_alignment);
 }
 
 SPDK_LOG_REGISTER_COMPONENT(accel)
@@ -22,24 +22,59 @@ struct module_info {
 	uint32_t num_ops;
 };
 
+enum accel_route {
+	/* Task wasn't submitted to a module (e.g. executed by a driver) */
+	ACCEL_ROUTE_NONE,
+	/* Module assigned to the opcode */
+	ACCEL_ROUTE_PRIMARY,
+	/* Module executing operations below the size threshold */
+	ACCEL_ROUTE_SMALL,
+	/* Module executing operations once the primary module's queue is full */
+	ACCEL_ROUTE_SPILL,
+	ACCEL_ROUTE_COUNT,
+};
+
+struct accel_route_stats {
+	uint64_t executed;
+	uint64_t latency_ticks;
+};
+
 struct accel_operation_stats {
 	uint64_t executed;
 	uint64_t failed;
 	uint64_t num_bytes;
+	uint64_t num_bounce_bufs;
+	uint64_t bounce_bytes;
+	struct accel_route_stats routes[ACCEL_ROUTE_COUNT];
 };
 
 struct accel_stats {
 	struct accel_operation_stats	operations[SPDK_ACCEL_OPC_LAST];
 	uint64_t			sequence_executed;
 	uint64_t			sequence_failed;
+	/* Crypto tasks whose key was already bound to a hardware key slot */
+	uint64_t			crypto_key_hits;
+	uint64_t			crypto_key_misses;
+};
+
+struct accel_crypto_key_slot_stats {
+	uint32_t max_bound;
+	uint32_t num_bound;
+	uint64_t evictions;
+	uint64_t prefetches;
+	uint64_t bind_failures;
 };
 
 typedef void (*_accel_for_each_module_fn)(struct module_info *info);
 void _accel_for_each_module(struct module_info *info, _accel_for_each_module_fn fn);
 int _accel_get_opc_name(enum spdk_accel_opcode opcode, const char **opcode_name);
+const char *_accel_get_route_name(enum accel_route route);
+const char *_accel_get_route_module_name(enum spdk_accel_opcode opcode, enum accel_route route);
 void _accel_crypto_key_dump_param(struct spdk_json_write_ctx *w, struct spdk_accel_crypto_key *key);
 void _accel_crypto_keys_dump_param(struct spdk_json_write_ctx *w);
 typedef void (*accel_get_stats_cb)(struct accel_stats *stats, void *cb_arg);
 int accel_get_stats(accel_get_stats_cb cb_fn, void *cb_arg);
+/* Returns false if the crypto module doesn't use hardware key slots */
+bool accel_crypto_key_get_slot_stats(struct accel_crypto_key_slot_stats *stats);
 
 #endif
@@ -175,6 +175,92 @@ cleanup:
 }
 SPDK_RPC_REGISTER("accel_assign_opc", rpc_accel_assign_opc, SPDK_RPC_STARTUP)
 
+struct rpc_accel_assign_opc_route {
+	char *opname;
+	char *small_module;
+	uint64_t small_threshold;
+	char *spill_module;
+	uint32_t spill_qd;
+};
+
+static const struct spdk_json_object_decoder rpc_accel_assign_opc_route_decoders[] = {
+	{"opname", offsetof(struct rpc_accel_assign_opc_route, opname), spdk_json_decode_string},
+	{
+		"small_module", offsetof(struct rpc_accel_assign_opc_route, small_module),
+		spdk_json_decode_string, true
+	},
+	{
+		"small_threshold", offsetof(struct rpc_accel_assign_opc_route, small_threshold),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"spill_module", offsetof(struct rpc_accel_assign_opc_route, spill_module),
+		spdk_json_decode_string, true
+	},
+	{
+		"spill_qd", offsetof(struct rpc_accel_assign_opc_route, spill_qd),
+		spdk_json_decode_uint32, true
+	},
+};
+
+static void
+free_accel_assign_opc_route(struct rpc_accel_assign_opc_route *r)
+{
+	free(r->opname);
+	free(r->small_module);
+	free(r->spill_module);
+}
+
+static void
+rpc_accel_assign_opc_route(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_accel_assign_opc_route req = {};
+	const char *opcode_str;
+	enum spdk_accel_opcode opcode;
+	bool found = false;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_accel_assign_opc_route_decoders,
+				    SPDK_COUNTOF(rpc_accel_assign_opc_route_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(accel, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	for (opcode = 0; opcode < SPDK_ACCEL_OPC_LAST; opcode++) {
+		rc = _accel_get_opc_name(opcode, &opcode_str);
+		assert(!rc);
+		if (strcmp(opcode_str, req.opname) == 0) {
+			found = true;
+			break;
+		}
+	}
+
+	if (found == false) {
+		SPDK_DEBUGLOG(accel, "Invalid operation name\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid operation name");
+		goto cleanup;
+	}
+
+	rc = spdk_accel_assign_opc_route(opcode, req.small_module, req.small_threshold,
+					 req.spill_module, req.spill_qd);
+	if (rc) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "error routing opcode");
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_accel_assign_opc_route(&req);
+}
+SPDK_RPC_REGISTER("accel_assign_opc_route", rpc_accel_assign_opc_route, SPDK_RPC_STARTUP)
+
 struct rpc_accel_crypto_key_create {
 	struct spdk_accel_crypto_key_create_param param;
 };
@@ -417,12 +503,15 @@ rpc_accel_get_stats_done(struct accel_stats *stats, void *cb_arg)
 {
 	struct spdk_jsonrpc_request *request = cb_arg;
 	struct spdk_json_write_ctx *w;
+	struct accel_route_stats *route_stats;
+	struct accel_crypto_key_slot_stats slot_stats;
 	const char *name, *module_name;
-	int i, rc;
+	int i, j, rc;
 
 	w = spdk_jsonrpc_begin_result(request);
 	spdk_json_write_object_begin(w);
 
+	spdk_json_write_named_uint64(w, "tick_rate", spdk_get_ticks_hz());
 	spdk_json_write_named_uint64(w, "sequence_executed", stats->sequence_executed);
 	spdk_json_write_named_uint64(w, "sequence_failed", stats->sequence_failed);
 	spdk_json_write_named_array_begin(w, "operations");
@@ -441,10 +530,41 @@ rpc_accel_get_stats_done(struct accel_stats *stats, void *cb_arg)
 		spdk_json_write_named_uint64(w, "executed", stats->operations[i].executed);
 		spdk_json_write_named_uint64(w, "failed", stats->operations[i].failed);
 		spdk_json_write_named_uint64(w, "num_bytes", stats->operations[i].num_bytes);
+		spdk_json_write_named_uint64(w, "num_bounce_bufs",
+					     stats->operations[i].num_bounce_bufs);
+		spdk_json_write_named_uint64(w, "bounce_bytes", stats->operations[i].bounce_bytes);
+		spdk_json_write_named_array_begin(w, "modules");
+		for (j = ACCEL_ROUTE_PRIMARY; j < ACCEL_ROUTE_COUNT; ++j) {
+			route_stats = &stats->operations[i].routes[j];
+			module_name = _accel_get_route_module_name(i, j);
+			if (module_name == NULL || route_stats->executed == 0) {
+				continue;
+			}
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_string(w, "module_name", module_name);
+			spdk_json_write_named_string(w, "route", _accel_get_route_name(j));
+			spdk_json_write_named_uint64(w, "executed", route_stats->executed);
+			spdk_json_write_named_uint64(w, "latency_ticks",
+						     route_stats->latency_ticks);
+			spdk_json_write_object_end(w);
+		}
+		spdk_json_write_array_end(w);
 		spdk_json_write_object_end(w);
 	}
 	spdk_json_write_array_end(w);
 
+	if (accel_crypto_key_get_slot_stats(&slot_stats)) {
+		spdk_json_write_named_object_begin(w, "crypto_key_slots");
+		spdk_json_write_named_uint32(w, "max_bound", slot_stats.max_bound);
+		spdk_json_write_named_uint32(w, "num_bound", slot_stats.num_bound);
+		spdk_json_write_named_uint64(w, "hits", stats->crypto_key_hits);
+		spdk_json_write_named_uint64(w, "misses", stats->crypto_key_misses);
+		spdk_json_write_named_uint64(w, "evictions", slot_stats.evictions);
+		spdk_json_write_named_uint64(w, "prefetches", slot_stats.prefetches);
+		spdk_json_write_named_uint64(w, "bind_failures", slot_stats.bind_failures);
+		spdk_json_write_object_end(w);
+	}
+
 	spdk_json_write_object_end(w);
 	spdk_jsonrpc_end_result(request, w);
 }
@@ -15,6 +15,7 @@
 #include "spdk/thread.h"
 #include "spdk/json.h"
 #include "spdk/crc32.h"
+#include "spdk/dif.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
 
@@ -28,6 +29,9 @@
 /* Per the AES-XTS spec, the size of data unit cannot be bigger than 2^20 blocks, 128b each block */
 #define ACCEL_AES_XTS_MAX_BLOCK_SIZE (1 << 24)
 
+/* Max number of CRC-32C tasks checksummed together */
+#define ACCEL_SW_CRC32C_BATCH_SIZE 16
+
 struct sw_accel_io_channel {
 	/* for ISAL */
 #ifdef SPDK_CONFIG_ISAL
@@ -36,6 +40,8 @@ struct sw_accel_io_channel {
 #endif
 	struct spdk_poller		*completion_poller;
 	TAILQ_HEAD(, spdk_accel_task)	tasks_to_complete;
+	/* CRC-32C tasks waiting to be checksummed together in the completion poller */
+	TAILQ_HEAD(, spdk_accel_task)	crc32c_tasks;
 };
 
 typedef void (*sw_accel_crypto_op)(uint8_t *k2, uint8_t *k1, uint8_t *tweak, uint64_t lba_size,
@@ -77,6 +83,10 @@ sw_accel_supports_opcode(enum spdk_accel_opcode opc)
 	case SPDK_ACCEL_OPC_ENCRYPT:
 	case SPDK_ACCEL_OPC_DECRYPT:
 	case SPDK_ACCEL_OPC_XOR:
+	case SPDK_ACCEL_OPC_DIF_VERIFY:
+	case SPDK_ACCEL_OPC_DIF_GENERATE:
+	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
+	case SPDK_ACCEL_OPC_ENCRYPT_CRC32C:
 		return true;
 	default:
 		return false;
@@ -153,9 +163,57 @@ _sw_accel_fill(struct iovec *iovs, uint32_t iovcnt, uint8_t fill)
 }
 
 static void
-_sw_accel_crc32cv(uint32_t *crc_dst, struct iovec *iov, uint32_t iovcnt, uint32_t seed)
+_sw_accel_crc32c_tasks(struct sw_accel_io_channel *sw_ch)
 {
-	*crc_dst = spdk_crc32c_iov_update(iov, iovcnt, ~seed);
+	struct spdk_accel_task *tasks[ACCEL_SW_CRC32C_BATCH_SIZE];
+	uint32_t crcs[ACCEL_SW_CRC32C_BATCH_SIZE], lane_crcs[ACCEL_SW_CRC32C_BATCH_SIZE];
+	uint32_t lanes[ACCEL_SW_CRC32C_BATCH_SIZE];
+	const void *bufs[ACCEL_SW_CRC32C_BATCH_SIZE];
+	size_t lens[ACCEL_SW_CRC32C_BATCH_SIZE];
+	struct spdk_accel_task *accel_task;
+	uint32_t i, iov, num_tasks, num_lanes;
+
+	while (!TAILQ_EMPTY(&sw_ch->crc32c_tasks)) {
+		num_tasks = 0;
+		while (num_tasks < ACCEL_SW_CRC32C_BATCH_SIZE &&
+		       (accel_task = TAILQ_FIRST(&sw_ch->crc32c_tasks)) != NULL) {
+			TAILQ_REMOVE(&sw_ch->crc32c_tasks, accel_task, link);
+			crcs[num_tasks] = ~accel_task->seed;
+			tasks[num_tasks++] = accel_task;
+		}
+
+		/* Go through the tasks' buffers one iovec at a time, so that the tasks still share
+		 * the lanes when they're made up of several iovecs.
+		 */
+		for (iov = 0;; iov++) {
+			num_lanes = 0;
+			for (i = 0; i < num_tasks; i++) {
+				accel_task = tasks[i];
+				if (iov >= accel_task->s.iovcnt) {
+					continue;
+				}
+
+				bufs[num_lanes] = accel_task->s.iovs[iov].iov_base;
+				lens[num_lanes] = accel_task->s.iovs[iov].iov_len;
+				lane_crcs[num_lanes] = crcs[i];
+				lanes[num_lanes++] = i;
+			}
+
+			if (num_lanes == 0) {
+				break;
+			}
+
+			spdk_crc32c_update_multi(bufs, lens, lane_crcs, num_lanes);
+			for (i = 0; i < num_lanes; i++) {
+				crcs[lanes[i]] = lane_crcs[i];
+			}
+		}
+
+		for (i = 0; i < num_tasks; i++) {
+			*tasks[i]->crc_dst = crcs[i];
+			_add_to_comp_list(sw_ch, tasks[i], 0);
+		}
+	}
 }
 
 static int
@@ -432,6 +490,30 @@ _sw_accel_decrypt(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *acc
 	return _sw_accel_crypto_operation(accel_task, key, key_data->decrypt);
 }
 
+static int
+_sw_accel_encrypt_crc32c(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	int rc;
+
+	rc = _sw_accel_encrypt(sw_ch, accel_task);
+	if (spdk_unlikely(rc != 0)) {
+		return rc;
+	}
+
+	/* Checksum the encrypted data while it's still in the cache */
+	if (accel_task->d.iovcnt) {
+		*accel_task->fused_crc_dst = spdk_crc32c_iov_update(accel_task->d.iovs,
+					     accel_task->d.iovcnt,
+					     ~accel_task->fused_seed);
+	} else {
+		*accel_task->fused_crc_dst = spdk_crc32c_iov_update(accel_task->s.iovs,
+					     accel_task->s.iovcnt,
+					     ~accel_task->fused_seed);
+	}
+
+	return 0;
+}
+
 static int
 _sw_accel_xor(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
 {
@@ -441,6 +523,40 @@ _sw_accel_xor(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_t
 			    accel_task->d.iovs[0].iov_len);
 }
 
+/*
+ * The guard computation of spdk_dif_*() is done by the ISA-L CRC functions when SPDK is built
+ * with ISA-L, which pick the PCLMULQDQ/AVX-512 implementation supported by the CPU at runtime.
+ */
+static int
+_sw_accel_dif_verify(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_verify(accel_task->s.iovs,
+			       accel_task->s.iovcnt,
+			       accel_task->dif.num_blocks,
+			       accel_task->dif.ctx,
+			       accel_task->dif.err);
+}
+
+static int
+_sw_accel_dif_generate(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_generate(accel_task->s.iovs,
+				 accel_task->s.iovcnt,
+				 accel_task->dif.num_blocks,
+				 accel_task->dif.ctx);
+}
+
+static int
+_sw_accel_dif_generate_copy(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_generate_copy(accel_task->s.iovs,
+				      accel_task->s.iovcnt,
+				      accel_task->d.iovs,
+				      accel_task->d.iovcnt,
+				      accel_task->dif.num_blocks,
+				      accel_task->dif.ctx);
+}
+
 static int
 sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_task)
 {
@@ -449,6 +565,8 @@ sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_
 	int rc = 0;
 
 	do {
+		rc = 0;
+
 		switch (accel_task->op_code) {
 		case SPDK_ACCEL_OPC_COPY:
 			_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
@@ -468,14 +586,18 @@ sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_
 					       accel_task->s2.iovs, accel_task->s2.iovcnt);
 			break;
 		case SPDK_ACCEL_OPC_CRC32C:
-			_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs, accel_task->s.iovcnt, accel_task->seed);
-			break;
+			/* Checksummed together with the other CRC-32C tasks in the poller */
+			tmp = TAILQ_NEXT(accel_task, link);
+			TAILQ_INSERT_TAIL(&sw_ch->crc32c_tasks, accel_task, link);
+			accel_task = tmp;
+			continue;
 		case SPDK_ACCEL_OPC_COPY_CRC32C:
 			_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
 					    accel_task->s.iovs, accel_task->s.iovcnt);
-			_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs,
-					  accel_task->s.iovcnt, accel_task->seed);
-			break;
+			tmp = TAILQ_NEXT(accel_task, link);
+			TAILQ_INSERT_TAIL(&sw_ch->crc32c_tasks, accel_task, link);
+			accel_task = tmp;
+			continue;
 		case SPDK_ACCEL_OPC_COMPRESS:
 			rc = _sw_accel_compress(sw_ch, accel_task);
 			break;
@@ -491,6 +613,18 @@ sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_
 		case SPDK_ACCEL_OPC_DECRYPT:
 			rc = _sw_accel_decrypt(sw_ch, accel_task);
 			break;
+		case SPDK_ACCEL_OPC_ENCRYPT_CRC32C:
+			rc = _sw_accel_encrypt_crc32c(sw_ch, accel_task);
+			break;
+		case SPDK_ACCEL_OPC_DIF_VERIFY:
+			rc = _sw_accel_dif_verify(sw_ch, accel_task);
+			break;
+		case SPDK_ACCEL_OPC_DIF_GENERATE:
+			rc = _sw_accel_dif_generate(sw_ch, accel_task);
+			break;
+		case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
+			rc = _sw_accel_dif_generate_copy(sw_ch, accel_task);
+			break;
 		default:
 			assert(false);
 			break;
@@ -513,6 +647,8 @@ accel_comp_poll(void *arg)
 	TAILQ_HEAD(, spdk_accel_task)	tasks_to_complete;
 	struct spdk_accel_task		*accel_task;
 
+	_sw_accel_crc32c_tasks(sw_ch);
+
 	if (TAILQ_EMPTY(&sw_ch->tasks_to_complete)) {
 		return SPDK_POLLER_IDLE;
 	}
@@ -534,6 +670,7 @@ sw_accel_create_cb(void *io_device, void *ctx_buf)
 	struct sw_accel_io_channel *sw_ch = ctx_buf;
 
 	TAILQ_INIT(&sw_ch->tasks_to_complete);
+	TAILQ_INIT(&sw_ch->crc32c_tasks);
 	sw_ch->completion_poller = SPDK_POLLER_REGISTER(accel_comp_poll, sw_ch, 0);
 
 #ifdef SPDK_CONFIG_ISAL
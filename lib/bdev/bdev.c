@@ -9,10 +9,12 @@
 #include "spdk/bdev.h"
 
 #include "spdk/accel.h"
+#include "spdk/barrier.h"
 #include "spdk/config.h"
 #include "spdk/env.h"
 #include "spdk/thread.h"
 #include "spdk/likely.h"
+#include "spdk/metrics.h"
 #include "spdk/queue.h"
 #include "spdk/nvme_spec.h"
 #include "spdk/scsi_spec.h"
@@ -37,12 +39,15 @@ int __itt_init_ittlib(const char *, __itt_group_id);
 
 #define SPDK_BDEV_IO_POOL_SIZE			(64 * 1024 - 1)
 #define SPDK_BDEV_IO_CACHE_SIZE			256
+#define SPDK_BDEV_IO_POOL_MAX_SOCKETS		8
 #define SPDK_BDEV_AUTO_EXAMINE			true
+#define SPDK_BDEV_EXAMINE_MAX_IN_PROGRESS	32
 #define BUF_SMALL_POOL_SIZE			8191
 #define BUF_LARGE_POOL_SIZE			1023
 #define BUF_SMALL_CACHE_SIZE			128
 #define BUF_LARGE_CACHE_SIZE			16
 #define NOMEM_THRESHOLD_COUNT			8
+#define NOMEM_RETRY_PERIOD_US			1000
 
 #define SPDK_BDEV_QOS_TIMESLICE_IN_USEC		1000
 #define SPDK_BDEV_QOS_MIN_IO_PER_TIMESLICE	1
@@ -50,6 +55,7 @@ int __itt_init_ittlib(const char *, __itt_group_id);
 #define SPDK_BDEV_QOS_MIN_IOS_PER_SEC		1000
 #define SPDK_BDEV_QOS_MIN_BYTES_PER_SEC		(1024 * 1024)
 #define SPDK_BDEV_QOS_LIMIT_NOT_DEFINED		UINT64_MAX
+#define SPDK_BDEV_QOS_DISTRIBUTED_BATCH_SHIFT	3
 #define SPDK_BDEV_IO_POLL_INTERVAL_IN_MSEC	1000
 
 /* The maximum number of children requests for a UNMAP or WRITE ZEROES command
@@ -81,6 +87,10 @@ static const char *qos_rpc_type[] = {"rw_ios_per_sec",
 				     "rw_mbytes_per_sec", "r_mbytes_per_sec", "w_mbytes_per_sec"
 				    };
 
+static const char *qos_min_rpc_type[] = {"min_rw_ios_per_sec", "min_rw_mbytes_per_sec",
+					 "min_r_mbytes_per_sec", "min_w_mbytes_per_sec"
+					};
+
 TAILQ_HEAD(spdk_bdev_list, spdk_bdev);
 
 RB_HEAD(bdev_name_tree, spdk_bdev_name);
@@ -93,8 +103,22 @@ bdev_name_cmp(struct spdk_bdev_name *name1, struct spdk_bdev_name *name2)
 
 RB_GENERATE_STATIC(bdev_name_tree, spdk_bdev_name, node, bdev_name_cmp);
 
+/*
+ * bdev_io pool of a NUMA socket. Each thread fills its bdev_io cache from the pool of
+ * its socket and only takes bdev_ios from the pools of other sockets when it is empty.
+ */
+struct spdk_bdev_io_pool {
+	struct spdk_mempool *mempool;
+	uint32_t socket_id;
+	uint32_t size;
+
+	/* Number of times a bdev_io was requested while the pool was empty */
+	uint64_t exhausted;
+};
+
 struct spdk_bdev_mgr {
-	struct spdk_mempool *bdev_io_pool;
+	struct spdk_bdev_io_pool bdev_io_pools[SPDK_BDEV_IO_POOL_MAX_SOCKETS];
+	uint32_t num_bdev_io_pools;
 
 	void *zero_buffer;
 
@@ -110,6 +134,11 @@ struct spdk_bdev_mgr {
 
 	TAILQ_HEAD(, spdk_bdev_open_async_ctx) async_bdev_opens;
 
+	TAILQ_HEAD(, spdk_bdev_qos_group) qos_groups;
+
+	TAILQ_HEAD(, spdk_bdev_examine_pending) examine_pending;
+	bool examine_pending_scheduled;
+
 #ifdef SPDK_CONFIG_VTUNE
 	__itt_domain	*domain;
 #endif
@@ -122,6 +151,8 @@ static struct spdk_bdev_mgr g_bdev_mgr = {
 	.init_complete = false,
 	.module_init_complete = false,
 	.async_bdev_opens = TAILQ_HEAD_INITIALIZER(g_bdev_mgr.async_bdev_opens),
+	.qos_groups = TAILQ_HEAD_INITIALIZER(g_bdev_mgr.qos_groups),
+	.examine_pending = TAILQ_HEAD_INITIALIZER(g_bdev_mgr.examine_pending),
 };
 
 static void
@@ -146,10 +177,119 @@ struct lba_range {
 	TAILQ_ENTRY(lba_range)		tailq_module;
 };
 
+/*
+ * The locked ranges of a bdev are kept in trees shared by all of its channels, so that taking a
+ * lock doesn't have to visit every channel.  The LBA space is cut in regions that are spread
+ * over a few shards, each with its own tree and lock.  The channels count their outstanding
+ * writes per shard and per lock epoch: a new lock waits for a new epoch to start and then only
+ * for the writes of the previous epoch to the shards that it covers.  Most bdevs are never
+ * locked, so the writes are only accounted once a bdev is first locked.  That lock has the
+ * channels account the writes that they have outstanding then.
+ */
+#define BDEV_LBA_LOCK_SHARDS		8
+#define BDEV_LBA_LOCK_REGION_SHIFT	12
+
+/*
+ * A set of shards is encoded as the first shard and the number of consecutive shards minus one.
+ * spdk_bdev_io.internal.lba_lock also holds the epoch slot a write was accounted on.
+ */
+#define BDEV_LBA_LOCK_FIRST_MASK	0x07
+#define BDEV_LBA_LOCK_COUNT_SHIFT	3
+#define BDEV_LBA_LOCK_ALL_SHARDS	((BDEV_LBA_LOCK_SHARDS - 1) << BDEV_LBA_LOCK_COUNT_SHIFT)
+#define BDEV_LBA_LOCK_SHARDS_MASK	0x3f
+#define BDEV_LBA_LOCK_SLOT		0x40
+#define BDEV_LBA_LOCK_ACCOUNTED		0x80
+
+SPDK_STATIC_ASSERT(BDEV_LBA_LOCK_SHARDS - 1 == BDEV_LBA_LOCK_FIRST_MASK, "Incorrect shard mask");
+
+struct lba_range_node {
+	struct lba_range		*range;
+	RB_ENTRY(lba_range_node)	node;
+};
+
+RB_HEAD(lba_range_tree, lba_range_node);
+
+static int
+lba_range_node_cmp(struct lba_range_node *node1, struct lba_range_node *node2)
+{
+	/* Locked ranges never overlap each other, so their offsets are enough to order them */
+	if (node1->range->offset < node2->range->offset) {
+		return -1;
+	}
+
+	return node1->range->offset > node2->range->offset;
+}
+
+RB_GENERATE_STATIC(lba_range_tree, lba_range_node, node, lba_range_node_cmp);
+
+struct bdev_lba_lock_shard {
+	struct spdk_spinlock		spinlock;
+	struct lba_range_tree		ranges;
+} __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
+
+struct locked_lba_range_ctx;
+
+struct spdk_bdev_lba_locks {
+	/* Number of ranges in the trees, the trees are only looked up when it isn't 0 */
+	uint32_t			num_ranges;
+
+	/* Lock epoch, its lowest bit selects the counters new writes are accounted on */
+	uint32_t			epoch;
+
+	/* Set by the first lock of the bdev, writes aren't accounted before */
+	bool				accounting;
+
+	/* Set once all the channels account their writes, protected by the bdev's spinlock */
+	bool				accounted;
+
+	/* Locks waiting for the channels to account their writes */
+	STAILQ_HEAD(, locked_lba_range_ctx) accounting_waiters;
+
+	struct bdev_lba_lock_shard	shards[BDEV_LBA_LOCK_SHARDS];
+};
+
+static struct spdk_bdev_lba_locks *
+bdev_lba_locks_alloc(void)
+{
+	struct spdk_bdev_lba_locks *locks;
+	int i;
+
+	if (posix_memalign((void **)&locks, SPDK_CACHE_LINE_SIZE, sizeof(*locks)) != 0) {
+		return NULL;
+	}
+
+	memset(locks, 0, sizeof(*locks));
+	STAILQ_INIT(&locks->accounting_waiters);
+	for (i = 0; i < BDEV_LBA_LOCK_SHARDS; i++) {
+		spdk_spin_init(&locks->shards[i].spinlock);
+		RB_INIT(&locks->shards[i].ranges);
+	}
+
+	return locks;
+}
+
+static void
+bdev_lba_locks_free(struct spdk_bdev_lba_locks *locks)
+{
+	int i;
+
+	if (locks == NULL) {
+		return;
+	}
+
+	for (i = 0; i < BDEV_LBA_LOCK_SHARDS; i++) {
+		assert(RB_EMPTY(&locks->shards[i].ranges));
+		spdk_spin_destroy(&locks->shards[i].spinlock);
+	}
+	free(locks);
+}
+
 static struct spdk_bdev_opts	g_bdev_opts = {
 	.bdev_io_pool_size = SPDK_BDEV_IO_POOL_SIZE,
 	.bdev_io_cache_size = SPDK_BDEV_IO_CACHE_SIZE,
 	.bdev_auto_examine = SPDK_BDEV_AUTO_EXAMINE,
+	.qos_distributed = false,
+	.examine_max_in_progress = SPDK_BDEV_EXAMINE_MAX_IN_PROGRESS,
 };
 
 static spdk_bdev_init_cb	g_init_cb_fn = NULL;
@@ -204,6 +344,47 @@ struct spdk_bdev_qos {
 
 	/** Poller that processes queued I/O commands each time slice. */
 	struct spdk_poller *poller;
+
+	/**
+	 * Channels take quota from rate_limits in batches and submit I/O on their own
+	 * thread. Only I/O which can't get quota is sent to the QoS thread.
+	 */
+	bool distributed;
+
+	/** QoS group whose rate limits this bdev shares with other bdevs, if any. */
+	struct spdk_bdev_qos_group *group;
+
+	/** Rate this bdev is allowed to use even when its QoS group runs out of tokens. */
+	struct spdk_bdev_qos_limit min_guarantees[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+};
+
+/*
+ * Rate limits shared by several bdevs. Each limit is a token bucket refilled every
+ * timeslice, which can hold up to burst_timeslices worth of tokens, so that bdevs
+ * that were idle may briefly go above the rate.
+ */
+struct spdk_bdev_qos_group {
+	char *name;
+
+	/** Shared rate limits. remaining_this_timeslice holds the tokens in the bucket. */
+	struct spdk_bdev_qos_limit rate_limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+
+	/** Number of timeslices worth of tokens a bucket can accumulate. */
+	uint32_t burst_timeslices;
+
+	/** Number of bdevs in the group. */
+	uint32_t num_bdevs;
+
+	/** Size of a timeslice in tsc ticks. */
+	uint64_t timeslice_size;
+
+	/** Timestamp of start of last timeslice. */
+	uint64_t last_timeslice;
+
+	/** Protects the buckets, which are shared by the QoS threads of all member bdevs. */
+	struct spdk_spinlock lock;
+
+	TAILQ_ENTRY(spdk_bdev_qos_group) link;
 };
 
 struct spdk_bdev_mgmt_channel {
@@ -218,6 +399,9 @@ struct spdk_bdev_mgmt_channel {
 	uint32_t	per_thread_cache_count;
 	uint32_t	bdev_io_cache_size;
 
+	/* Index of the bdev_io pool of this thread's NUMA socket */
+	uint32_t	bdev_io_pool_idx;
+
 	struct spdk_iobuf_channel iobuf;
 
 	TAILQ_HEAD(, spdk_bdev_shared_resource)	shared_resources;
@@ -240,16 +424,20 @@ struct spdk_bdev_shared_resource {
 	uint64_t		io_outstanding;
 
 	/*
-	 * Queue of IO awaiting retry because of a previous NOMEM status returned
-	 *  on this channel.
+	 * Bdev channels with I/O awaiting retry because of a previous NOMEM status returned
+	 *  on this channel.  Their I/O are retried round-robin, so that a single saturated bdev
+	 *  doesn't hold back the others.
 	 */
-	bdev_io_tailq_t		nomem_io;
+	TAILQ_HEAD(, spdk_bdev_channel) nomem_channels;
 
 	/*
 	 * Threshold which io_outstanding must drop to before retrying nomem_io.
 	 */
 	uint64_t		nomem_threshold;
 
+	/* Retries nomem_io when there's no outstanding I/O whose completion could do it */
+	struct spdk_poller	*nomem_poller;
+
 	/* I/O channel allocated by a bdev module */
 	struct spdk_io_channel	*shared_ch;
 
@@ -261,6 +449,14 @@ struct spdk_bdev_shared_resource {
 
 #define BDEV_CH_RESET_IN_PROGRESS	(1 << 0)
 #define BDEV_CH_QOS_ENABLED		(1 << 1)
+#define BDEV_CH_MERGE_ENABLED		(1 << 2)
+#define BDEV_CH_BATCHING		(1 << 3)
+
+/* Maximum number of requests held in a batch before it gets submitted */
+#define BDEV_BATCH_MAX_IOS		32
+
+/* Default maximum size of a request built by merging adjacent reads or writes */
+#define BDEV_MERGE_DEFAULT_MAX_SIZE_KB	128
 
 struct spdk_bdev_channel {
 	struct spdk_bdev	*bdev;
@@ -276,6 +472,15 @@ struct spdk_bdev_channel {
 
 	struct spdk_bdev_io_stat *stat;
 
+	/*
+	 * Sequence counter of stat, odd while the channel's thread is updating it.  It allows
+	 * reading the statistics from other threads without sending messages to this one.
+	 */
+	uint32_t		stat_seq;
+
+	/* Link in the bdev's list of channels, protected by the bdev's spinlock */
+	TAILQ_ENTRY(spdk_bdev_channel) stat_link;
+
 	/*
 	 * Count of I/O submitted to the underlying dev module through this channel
 	 * and waiting for completion.
@@ -299,10 +504,23 @@ struct spdk_bdev_channel {
 	/* List of I/Os doing memory domain pull/push */
 	bdev_io_tailq_t		io_memory_domain;
 
+	/* Queue of I/O awaiting retry because of a previous NOMEM status */
+	bdev_io_tailq_t		nomem_io;
+
+	/* Link in the shared resource's nomem_channels, valid while nomem_io isn't empty */
+	TAILQ_ENTRY(spdk_bdev_channel) nomem_link;
+
 	uint32_t		flags;
 
 	struct spdk_histogram_data *histogram;
 
+	/*
+	 * Histograms split by I/O type and size class, indexed by bdev_split_histogram_idx().
+	 * Allocated along with the histogram above, while each of the histograms is only
+	 * allocated once an I/O of its class completes.
+	 */
+	struct spdk_histogram_data **split_histograms;
+
 #ifdef SPDK_CONFIG_VTUNE
 	uint64_t		start_tsc;
 	uint64_t		interval_tsc;
@@ -312,7 +530,41 @@ struct spdk_bdev_channel {
 
 	bdev_io_tailq_t		queued_resets;
 
-	lba_range_tailq_t	locked_ranges;
+	/*
+	 * Writes outstanding on each LBA lock shard, for both lock epoch slots.  They're only
+	 * updated by the channel's thread and read by the threads taking locks.
+	 */
+	uint32_t		lba_lock_io[2][BDEV_LBA_LOCK_SHARDS];
+
+	/*
+	 * Set while I/O are queued on io_locked.  The channel then holds a reference to itself,
+	 * so that unlocks can send it messages to resubmit them.
+	 */
+	bool			io_locked_waiting;
+
+	/* Messages sent by unlocks to resubmit io_locked and not processed yet */
+	uint32_t		io_locked_retries;
+
+	/* Quota taken from the QoS rate limits in distributed mode, valid for one timeslice */
+	int64_t			qos_quota[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	uint64_t		qos_quota_timeslice;
+
+	/* LBA-contiguous reads or writes held to be submitted as a single request */
+	struct {
+		bdev_io_tailq_t		queue;
+		uint64_t		offset_blocks;
+		uint64_t		num_blocks;
+		int			iovcnt;
+		uint64_t		max_blocks;
+		/* Submits the held requests once per the maximum hold time */
+		struct spdk_poller	*poller;
+	} merge;
+
+	/* Reads and writes held between spdk_bdev_start_batch() and spdk_bdev_submit_batch() */
+	struct {
+		struct spdk_bdev_io	*ios[BDEV_BATCH_MAX_IOS];
+		uint32_t		num_ios;
+	} batch;
 };
 
 struct media_event_entry {
@@ -348,6 +600,7 @@ struct spdk_bdev_desc {
 };
 
 struct spdk_bdev_iostat_ctx {
+	struct spdk_bdev *bdev;
 	struct spdk_bdev_io_stat *stat;
 	spdk_bdev_get_device_stat_cb cb;
 	void *cb_arg;
@@ -357,6 +610,8 @@ struct set_qos_limit_ctx {
 	void (*cb_fn)(void *cb_arg, int status);
 	void *cb_arg;
 	struct spdk_bdev *bdev;
+	struct spdk_bdev_qos_group *group;
+	uint64_t min_limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
 };
 
 struct spdk_bdev_channel_iter {
@@ -395,6 +650,10 @@ static int bdev_write_zero_buffer(struct spdk_bdev_io *bdev_io);
 static void bdev_enable_qos_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
 				struct spdk_io_channel *ch, void *_ctx);
 static void bdev_enable_qos_done(struct spdk_bdev *bdev, void *_ctx, int status);
+static void bdev_qos_get_limits(const struct spdk_bdev_qos_limit *rate_limits, uint64_t *limits);
+static uint32_t bdev_qos_group_get_burst_ms(const struct spdk_bdev_qos_group *group);
+static void bdev_qos_group_put(struct spdk_bdev_qos_group *group);
+static void bdev_qos_groups_free(void);
 
 static int bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				     struct iovec *iov, int iovcnt, void *md_buf, uint64_t offset_blocks,
@@ -409,6 +668,8 @@ static int bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_i
 				      struct spdk_accel_sequence *seq,
 				      spdk_bdev_io_completion_cb cb, void *cb_arg);
 
+static inline void bdev_io_lba_lock_put(struct spdk_bdev_io *bdev_io);
+
 static int bdev_lock_lba_range(struct spdk_bdev_desc *desc, struct spdk_io_channel *_ch,
 			       uint64_t offset, uint64_t length,
 			       lock_range_cb cb_fn, void *cb_arg);
@@ -418,6 +679,8 @@ static int bdev_unlock_lba_range(struct spdk_bdev_desc *desc, struct spdk_io_cha
 				 lock_range_cb cb_fn, void *cb_arg);
 
 static bool bdev_abort_queued_io(bdev_io_tailq_t *queue, struct spdk_bdev_io *bio_to_abort);
+static bool bdev_channel_abort_nomem_io(struct spdk_bdev_channel *ch,
+					struct spdk_bdev_io *bio_to_abort);
 static bool bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *ch, struct spdk_bdev_io *bio_to_abort);
 
 static bool claim_type_is_v2(enum spdk_bdev_claim_type type);
@@ -453,6 +716,8 @@ spdk_bdev_get_opts(struct spdk_bdev_opts *opts, size_t opts_size)
 	SET_FIELD(bdev_io_pool_size);
 	SET_FIELD(bdev_io_cache_size);
 	SET_FIELD(bdev_auto_examine);
+	SET_FIELD(qos_distributed);
+	SET_FIELD(examine_max_in_progress);
 
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
@@ -498,6 +763,8 @@ spdk_bdev_set_opts(struct spdk_bdev_opts *opts)
 	SET_FIELD(bdev_io_pool_size);
 	SET_FIELD(bdev_io_cache_size);
 	SET_FIELD(bdev_auto_examine);
+	SET_FIELD(qos_distributed);
+	SET_FIELD(examine_max_in_progress);
 
 	g_bdev_opts.opts_size = opts->opts_size;
 
@@ -664,6 +931,140 @@ bdev_ok_to_examine(struct spdk_bdev *bdev)
 	}
 }
 
+/* An examine_disk call deferred because its module has too many examinations in progress */
+struct spdk_bdev_examine_pending {
+	struct spdk_bdev_module			*module;
+	/* Keeps the bdev from being deleted until it's examined */
+	struct spdk_bdev_desc			*desc;
+	TAILQ_ENTRY(spdk_bdev_examine_pending)	link;
+};
+
+static int bdev_desc_alloc(struct spdk_bdev *bdev, spdk_bdev_event_cb_t event_cb,
+			   void *event_ctx, struct spdk_bdev_desc **_desc);
+static void bdev_desc_free(struct spdk_bdev_desc *desc);
+static int bdev_open(struct spdk_bdev *bdev, bool write, struct spdk_bdev_desc *desc);
+static void _tmp_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void *ctx);
+
+/* Must be called with module->internal.spinlock held */
+static inline bool
+bdev_module_examine_full(struct spdk_bdev_module *module)
+{
+	return g_bdev_opts.examine_max_in_progress != 0 &&
+	       module->internal.examine_in_progress >= g_bdev_opts.examine_max_in_progress;
+}
+
+/* Must be called with module->internal.spinlock held */
+static void
+bdev_module_examine_start(struct spdk_bdev_module *module)
+{
+	if (module->internal.examine_in_progress++ == 0) {
+		module->internal.examine_start_tsc = spdk_get_ticks();
+	}
+	module->internal.examine_count++;
+}
+
+static void
+bdev_examine_pending_dispatch(void *ctx)
+{
+	TAILQ_HEAD(, spdk_bdev_examine_pending) ready = TAILQ_HEAD_INITIALIZER(ready);
+	struct spdk_bdev_examine_pending *pending, *tmp;
+	struct spdk_bdev_module *module;
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	g_bdev_mgr.examine_pending_scheduled = false;
+	TAILQ_FOREACH_SAFE(pending, &g_bdev_mgr.examine_pending, link, tmp) {
+		module = pending->module;
+		spdk_spin_lock(&module->internal.spinlock);
+		if (bdev_module_examine_full(module)) {
+			spdk_spin_unlock(&module->internal.spinlock);
+			continue;
+		}
+		bdev_module_examine_start(module);
+		spdk_spin_unlock(&module->internal.spinlock);
+
+		TAILQ_REMOVE(&g_bdev_mgr.examine_pending, pending, link);
+		TAILQ_INSERT_TAIL(&ready, pending, link);
+	}
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	while ((pending = TAILQ_FIRST(&ready)) != NULL) {
+		TAILQ_REMOVE(&ready, pending, link);
+		pending->module->examine_disk(spdk_bdev_desc_get_bdev(pending->desc));
+		spdk_bdev_close(pending->desc);
+		free(pending);
+	}
+}
+
+static void
+bdev_examine_pending_schedule(void)
+{
+	bool schedule;
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	schedule = !TAILQ_EMPTY(&g_bdev_mgr.examine_pending) &&
+		   !g_bdev_mgr.examine_pending_scheduled;
+	if (schedule) {
+		g_bdev_mgr.examine_pending_scheduled = true;
+	}
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	/* Examine callbacks are always called on the app thread */
+	if (schedule) {
+		spdk_thread_send_msg(spdk_thread_get_app_thread(), bdev_examine_pending_dispatch,
+				     NULL);
+	}
+}
+
+/* Must be called without holding any lock */
+static void
+bdev_module_examine_disk(struct spdk_bdev_module *module, struct spdk_bdev *bdev)
+{
+	struct spdk_bdev_examine_pending *pending;
+
+	spdk_spin_lock(&module->internal.spinlock);
+	module->internal.action_in_progress++;
+	if (!bdev_module_examine_full(module)) {
+		bdev_module_examine_start(module);
+		spdk_spin_unlock(&module->internal.spinlock);
+		module->examine_disk(bdev);
+		return;
+	}
+	spdk_spin_unlock(&module->internal.spinlock);
+
+	pending = calloc(1, sizeof(*pending));
+	if (pending == NULL) {
+		goto examine;
+	}
+
+	if (bdev_desc_alloc(bdev, _tmp_bdev_event_cb, NULL, &pending->desc) != 0) {
+		free(pending);
+		goto examine;
+	}
+
+	if (bdev_open(bdev, false, pending->desc) != 0) {
+		bdev_desc_free(pending->desc);
+		free(pending);
+		goto examine;
+	}
+
+	/* The examination stays accounted in action_in_progress while it's deferred */
+	pending->module = module;
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	TAILQ_INSERT_TAIL(&g_bdev_mgr.examine_pending, pending, link);
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	/* An examination may have completed since the module was found full */
+	bdev_examine_pending_schedule();
+	return;
+
+examine:
+	/* Better to exceed the limit than to skip the examination */
+	spdk_spin_lock(&module->internal.spinlock);
+	bdev_module_examine_start(module);
+	spdk_spin_unlock(&module->internal.spinlock);
+	module->examine_disk(bdev);
+}
+
 static void
 bdev_examine(struct spdk_bdev *bdev)
 {
@@ -680,6 +1081,7 @@ bdev_examine(struct spdk_bdev *bdev)
 			spdk_spin_lock(&module->internal.spinlock);
 			action = module->internal.action_in_progress;
 			module->internal.action_in_progress++;
+			bdev_module_examine_start(module);
 			spdk_spin_unlock(&module->internal.spinlock);
 			module->examine_config(bdev);
 			if (action != module->internal.action_in_progress) {
@@ -696,11 +1098,8 @@ bdev_examine(struct spdk_bdev *bdev)
 		/* Examine by all bdev modules */
 		TAILQ_FOREACH(module, &g_bdev_mgr.bdev_modules, internal.tailq) {
 			if (module->examine_disk) {
-				spdk_spin_lock(&module->internal.spinlock);
-				module->internal.action_in_progress++;
-				spdk_spin_unlock(&module->internal.spinlock);
 				spdk_spin_unlock(&bdev->internal.spinlock);
-				module->examine_disk(bdev);
+				bdev_module_examine_disk(module, bdev);
 				spdk_spin_lock(&bdev->internal.spinlock);
 			}
 		}
@@ -709,11 +1108,8 @@ bdev_examine(struct spdk_bdev *bdev)
 		/* Examine by the one bdev module with a v1 claim */
 		module = bdev->internal.claim.v1.module;
 		if (module->examine_disk) {
-			spdk_spin_lock(&module->internal.spinlock);
-			module->internal.action_in_progress++;
-			spdk_spin_unlock(&module->internal.spinlock);
 			spdk_spin_unlock(&bdev->internal.spinlock);
-			module->examine_disk(bdev);
+			bdev_module_examine_disk(module, bdev);
 			return;
 		}
 		break;
@@ -739,13 +1135,9 @@ bdev_examine(struct spdk_bdev *bdev)
 				continue;
 			}
 
-			spdk_spin_lock(&module->internal.spinlock);
-			module->internal.action_in_progress++;
-			spdk_spin_unlock(&module->internal.spinlock);
-
 			/* Call examine_disk without holding internal.spinlock. */
 			spdk_spin_unlock(&bdev->internal.spinlock);
-			module->examine_disk(bdev);
+			bdev_module_examine_disk(module, bdev);
 			spdk_spin_lock(&bdev->internal.spinlock);
 		}
 
@@ -825,6 +1217,52 @@ bdev_examine_allowlist_config_json(struct spdk_json_write_ctx *w)
 	}
 }
 
+void
+bdev_examine_stats_dump_json(struct spdk_json_write_ctx *w)
+{
+	struct spdk_bdev_module *module;
+	struct spdk_bdev_examine_pending *pending;
+	uint64_t examine_count, busy_tsc;
+	uint32_t in_progress, deferred;
+
+	spdk_json_write_array_begin(w);
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	TAILQ_FOREACH(module, &g_bdev_mgr.bdev_modules, internal.tailq) {
+		if (module->examine_config == NULL && module->examine_disk == NULL) {
+			continue;
+		}
+
+		deferred = 0;
+		TAILQ_FOREACH(pending, &g_bdev_mgr.examine_pending, link) {
+			if (pending->module == module) {
+				deferred++;
+			}
+		}
+
+		spdk_spin_lock(&module->internal.spinlock);
+		examine_count = module->internal.examine_count;
+		in_progress = module->internal.examine_in_progress;
+		busy_tsc = module->internal.examine_busy_tsc;
+		if (in_progress > 0) {
+			busy_tsc += spdk_get_ticks() - module->internal.examine_start_tsc;
+		}
+		spdk_spin_unlock(&module->internal.spinlock);
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "module_name", module->name);
+		spdk_json_write_named_uint64(w, "examine_count", examine_count);
+		spdk_json_write_named_uint32(w, "examine_in_progress", in_progress);
+		spdk_json_write_named_uint32(w, "examine_deferred", deferred);
+		spdk_json_write_named_uint64(w, "examine_time_us",
+					     busy_tsc * SPDK_SEC_TO_USEC / spdk_get_ticks_hz());
+		spdk_json_write_object_end(w);
+	}
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	spdk_json_write_array_end(w);
+}
+
 struct spdk_bdev *
 spdk_bdev_first(void)
 {
@@ -906,9 +1344,48 @@ bdev_io_use_accel_sequence(struct spdk_bdev_io *bdev_io)
 }
 
 static inline void
-bdev_queue_nomem_io_head(struct spdk_bdev_shared_resource *shared_resource,
-			 struct spdk_bdev_io *bdev_io, enum bdev_io_retry_state state)
+bdev_channel_stat_update_begin(struct spdk_bdev_channel *ch)
+{
+	__atomic_store_n(&ch->stat_seq, ch->stat_seq + 1, __ATOMIC_RELAXED);
+	spdk_smp_wmb();
+}
+
+static inline void
+bdev_channel_stat_update_end(struct spdk_bdev_channel *ch)
+{
+	spdk_smp_wmb();
+	__atomic_store_n(&ch->stat_seq, ch->stat_seq + 1, __ATOMIC_RELAXED);
+}
+
+static int
+bdev_no_mem_poller(void *ctx)
+{
+	struct spdk_bdev_shared_resource *shared_resource = ctx;
+	struct spdk_bdev_channel *bdev_ch;
+
+	spdk_poller_unregister(&shared_resource->nomem_poller);
+
+	bdev_ch = TAILQ_FIRST(&shared_resource->nomem_channels);
+	if (bdev_ch != NULL) {
+		bdev_ch_retry_io(bdev_ch);
+	}
+
+	/* Retrying might have registered the poller again already */
+	if (!TAILQ_EMPTY(&shared_resource->nomem_channels) &&
+	    shared_resource->io_outstanding == 0 && shared_resource->nomem_poller == NULL) {
+		shared_resource->nomem_poller = SPDK_POLLER_REGISTER(bdev_no_mem_poller,
+						shared_resource, NOMEM_RETRY_PERIOD_US);
+	}
+
+	return SPDK_POLLER_BUSY;
+}
+
+static inline void
+bdev_queue_nomem_io_head(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io,
+			 enum bdev_io_retry_state state)
 {
+	struct spdk_bdev_shared_resource *shared_resource = bdev_ch->shared_resource;
+
 	/* Wait for some of the outstanding I/O to complete before we retry any of the nomem_io.
 	 * Normally we will wait for NOMEM_THRESHOLD_COUNT I/O to complete but for low queue depth
 	 * channels we will instead wait for half to complete.
@@ -918,20 +1395,29 @@ bdev_queue_nomem_io_head(struct spdk_bdev_shared_resource *shared_resource,
 
 	assert(state != BDEV_IO_RETRY_STATE_INVALID);
 	bdev_io->internal.retry_state = state;
-	TAILQ_INSERT_HEAD(&shared_resource->nomem_io, bdev_io, internal.link);
+	if (TAILQ_EMPTY(&bdev_ch->nomem_io)) {
+		TAILQ_INSERT_TAIL(&shared_resource->nomem_channels, bdev_ch, nomem_link);
+	}
+	TAILQ_INSERT_HEAD(&bdev_ch->nomem_io, bdev_io, internal.link);
+
+	/* Without any outstanding I/O, no completion is going to retry the nomem_io */
+	if (shared_resource->io_outstanding == 0 && shared_resource->nomem_poller == NULL) {
+		shared_resource->nomem_poller = SPDK_POLLER_REGISTER(bdev_no_mem_poller,
+						shared_resource, NOMEM_RETRY_PERIOD_US);
+	}
 }
 
 static inline void
-bdev_queue_nomem_io_tail(struct spdk_bdev_shared_resource *shared_resource,
-			 struct spdk_bdev_io *bdev_io, enum bdev_io_retry_state state)
+bdev_queue_nomem_io_tail(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io,
+			 enum bdev_io_retry_state state)
 {
 	/* We only queue IOs at the end of the nomem_io queue if they're submitted by the user while
 	 * the queue isn't empty, so we don't need to update the nomem_threshold here */
-	assert(!TAILQ_EMPTY(&shared_resource->nomem_io));
+	assert(!TAILQ_EMPTY(&bdev_ch->nomem_io));
 
 	assert(state != BDEV_IO_RETRY_STATE_INVALID);
 	bdev_io->internal.retry_state = state;
-	TAILQ_INSERT_TAIL(&shared_resource->nomem_io, bdev_io, internal.link);
+	TAILQ_INSERT_TAIL(&bdev_ch->nomem_io, bdev_io, internal.link);
 }
 
 void
@@ -1047,7 +1533,7 @@ bdev_io_exec_sequence_cb(void *ctx, int status)
 	TAILQ_REMOVE(&bdev_io->internal.ch->io_accel_exec, bdev_io, internal.link);
 	bdev_io_decrement_outstanding(ch, ch->shared_resource);
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_io))) {
+	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_channels))) {
 		bdev_ch_retry_io(ch);
 	}
 
@@ -1117,7 +1603,7 @@ bdev_io_pull_md_buf_done(void *ctx, int status)
 	TAILQ_REMOVE(&ch->io_memory_domain, bdev_io, internal.link);
 	bdev_io_decrement_outstanding(ch, ch->shared_resource);
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_io))) {
+	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_channels))) {
 		bdev_ch_retry_io(ch);
 	}
 
@@ -1159,7 +1645,7 @@ bdev_io_pull_md_buf(struct spdk_bdev_io *bdev_io)
 	}
 
 	if (spdk_unlikely(rc == -ENOMEM)) {
-		bdev_queue_nomem_io_head(ch->shared_resource, bdev_io, BDEV_IO_RETRY_STATE_PULL_MD);
+		bdev_queue_nomem_io_head(ch, bdev_io, BDEV_IO_RETRY_STATE_PULL_MD);
 	} else {
 		assert(bdev_io->internal.data_transfer_cpl);
 		bdev_io->internal.data_transfer_cpl(bdev_io, rc);
@@ -1228,7 +1714,7 @@ bdev_io_pull_data_done_and_track(void *ctx, int status)
 	TAILQ_REMOVE(&ch->io_memory_domain, bdev_io, internal.link);
 	bdev_io_decrement_outstanding(ch, ch->shared_resource);
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_io))) {
+	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_channels))) {
 		bdev_ch_retry_io(ch);
 	}
 
@@ -1304,7 +1790,7 @@ bdev_io_pull_data(struct spdk_bdev_io *bdev_io)
 	}
 
 	if (spdk_unlikely(rc == -ENOMEM)) {
-		bdev_queue_nomem_io_head(ch->shared_resource, bdev_io, BDEV_IO_RETRY_STATE_PULL);
+		bdev_queue_nomem_io_head(ch, bdev_io, BDEV_IO_RETRY_STATE_PULL);
 	} else {
 		bdev_io_pull_data_done(bdev_io, rc);
 	}
@@ -1314,7 +1800,7 @@ static void
 _bdev_io_pull_bounce_data_buf(struct spdk_bdev_io *bdev_io, void *buf, size_t len,
 			      bdev_copy_bounce_buffer_cpl cpl_cb)
 {
-	struct spdk_bdev_shared_resource *shared_resource = bdev_io->internal.ch->shared_resource;
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
 
 	bdev_io->internal.data_transfer_cpl = cpl_cb;
 	/* save original iovec */
@@ -1327,8 +1813,8 @@ _bdev_io_pull_bounce_data_buf(struct spdk_bdev_io *bdev_io, void *buf, size_t le
 	bdev_io->u.bdev.iovs[0].iov_base = buf;
 	bdev_io->u.bdev.iovs[0].iov_len = len;
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&shared_resource->nomem_io))) {
-		bdev_queue_nomem_io_tail(shared_resource, bdev_io, BDEV_IO_RETRY_STATE_PULL);
+	if (spdk_unlikely(!TAILQ_EMPTY(&ch->nomem_io))) {
+		bdev_queue_nomem_io_tail(ch, bdev_io, BDEV_IO_RETRY_STATE_PULL);
 	} else {
 		bdev_io_pull_data(bdev_io);
 	}
@@ -1432,9 +1918,10 @@ bdev_ch_resubmit_io(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev
 }
 
 static void
-bdev_ch_retry_io(struct spdk_bdev_channel *bdev_ch)
+bdev_ch_retry_io(struct spdk_bdev_channel *_bdev_ch)
 {
-	struct spdk_bdev_shared_resource *shared_resource = bdev_ch->shared_resource;
+	struct spdk_bdev_shared_resource *shared_resource = _bdev_ch->shared_resource;
+	struct spdk_bdev_channel *bdev_ch;
 	struct spdk_bdev_io *bdev_io;
 
 	if (shared_resource->io_outstanding > shared_resource->nomem_threshold) {
@@ -1449,9 +1936,19 @@ bdev_ch_retry_io(struct spdk_bdev_channel *bdev_ch)
 		return;
 	}
 
-	while (!TAILQ_EMPTY(&shared_resource->nomem_io)) {
-		bdev_io = TAILQ_FIRST(&shared_resource->nomem_io);
-		TAILQ_REMOVE(&shared_resource->nomem_io, bdev_io, internal.link);
+	while (!TAILQ_EMPTY(&shared_resource->nomem_channels)) {
+		/* Take a single I/O from each bdev channel in turn */
+		bdev_ch = TAILQ_FIRST(&shared_resource->nomem_channels);
+		TAILQ_REMOVE(&shared_resource->nomem_channels, bdev_ch, nomem_link);
+		bdev_io = TAILQ_FIRST(&bdev_ch->nomem_io);
+		TAILQ_REMOVE(&bdev_ch->nomem_io, bdev_io, internal.link);
+		if (!TAILQ_EMPTY(&bdev_ch->nomem_io)) {
+			TAILQ_INSERT_TAIL(&shared_resource->nomem_channels, bdev_ch, nomem_link);
+		}
+
+		bdev_channel_stat_update_begin(bdev_ch);
+		bdev_ch->stat->num_nomem_retries++;
+		bdev_channel_stat_update_end(bdev_ch);
 
 		switch (bdev_io->internal.retry_state) {
 		case BDEV_IO_RETRY_STATE_SUBMIT:
@@ -1474,12 +1971,14 @@ bdev_ch_retry_io(struct spdk_bdev_channel *bdev_ch)
 			break;
 		}
 
-		if (bdev_io == TAILQ_FIRST(&shared_resource->nomem_io)) {
+		if (bdev_io == TAILQ_FIRST(&bdev_ch->nomem_io)) {
 			/* This IO completed again with NOMEM status, so break the loop and
 			 * don't try anymore.  Note that a bdev_io that fails with NOMEM
-			 * always gets requeued at the front of the list, to maintain
-			 * ordering.
+			 * always gets requeued at the front of its channel's list, to
+			 * maintain ordering.  Its channel keeps its turn for the next retry.
 			 */
+			TAILQ_REMOVE(&shared_resource->nomem_channels, bdev_ch, nomem_link);
+			TAILQ_INSERT_HEAD(&shared_resource->nomem_channels, bdev_ch, nomem_link);
 			break;
 		}
 	}
@@ -1493,7 +1992,10 @@ _bdev_io_handle_no_mem(struct spdk_bdev_io *bdev_io, enum bdev_io_retry_state st
 
 	if (spdk_unlikely(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_NOMEM)) {
 		bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
-		bdev_queue_nomem_io_head(shared_resource, bdev_io, state);
+		bdev_channel_stat_update_begin(bdev_ch);
+		bdev_ch->stat->num_nomem_ios++;
+		bdev_channel_stat_update_end(bdev_ch);
+		bdev_queue_nomem_io_head(bdev_ch, bdev_io, state);
 
 		/* If bdev module completed an I/O that has an accel sequence with NOMEM status, the
 		 * ownership of that sequence is transferred back to the bdev layer, so we need to
@@ -1508,7 +2010,7 @@ _bdev_io_handle_no_mem(struct spdk_bdev_io *bdev_io, enum bdev_io_retry_state st
 		return true;
 	}
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&shared_resource->nomem_io))) {
+	if (spdk_unlikely(!TAILQ_EMPTY(&shared_resource->nomem_channels))) {
 		bdev_ch_retry_io(bdev_ch);
 	}
 
@@ -1529,7 +2031,7 @@ _bdev_io_complete_push_bounce_done(void *ctx, int rc)
 	 */
 	bdev_io_put_buf(bdev_io);
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_io))) {
+	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_channels))) {
 		bdev_ch_retry_io(ch);
 	}
 
@@ -1546,7 +2048,7 @@ bdev_io_push_bounce_md_buf_done(void *ctx, int rc)
 	TAILQ_REMOVE(&ch->io_memory_domain, bdev_io, internal.link);
 	bdev_io_decrement_outstanding(ch, ch->shared_resource);
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_io))) {
+	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_channels))) {
 		bdev_ch_retry_io(ch);
 	}
 
@@ -1595,7 +2097,7 @@ bdev_io_push_bounce_md_buf(struct spdk_bdev_io *bdev_io)
 	}
 
 	if (spdk_unlikely(rc == -ENOMEM)) {
-		bdev_queue_nomem_io_head(ch->shared_resource, bdev_io, BDEV_IO_RETRY_STATE_PUSH_MD);
+		bdev_queue_nomem_io_head(ch, bdev_io, BDEV_IO_RETRY_STATE_PUSH_MD);
 	} else {
 		assert(bdev_io->internal.data_transfer_cpl);
 		bdev_io->internal.data_transfer_cpl(bdev_io, rc);
@@ -1630,7 +2132,7 @@ bdev_io_push_bounce_data_done_and_track(void *ctx, int status)
 	TAILQ_REMOVE(&ch->io_memory_domain, bdev_io, internal.link);
 	bdev_io_decrement_outstanding(ch, ch->shared_resource);
 
-	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_io))) {
+	if (spdk_unlikely(!TAILQ_EMPTY(&ch->shared_resource->nomem_channels))) {
 		bdev_ch_retry_io(ch);
 	}
 
@@ -1680,7 +2182,7 @@ bdev_io_push_bounce_data(struct spdk_bdev_io *bdev_io)
 	}
 
 	if (spdk_unlikely(rc == -ENOMEM)) {
-		bdev_queue_nomem_io_head(ch->shared_resource, bdev_io, BDEV_IO_RETRY_STATE_PUSH);
+		bdev_queue_nomem_io_head(ch, bdev_io, BDEV_IO_RETRY_STATE_PUSH);
 	} else {
 		bdev_io_push_bounce_data_done(bdev_io, rc);
 	}
@@ -1822,14 +2324,44 @@ bdev_qos_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 
 	spdk_bdev_get_qos_rate_limits(bdev, limits);
 
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (limits[i] > 0) {
+			break;
+		}
+	}
+
+	/* The bdev may have QoS enabled only because it belongs to a QoS group */
+	if (i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_set_qos_limit");
+
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "name", bdev->name);
+		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+			if (limits[i] > 0) {
+				spdk_json_write_named_uint64(w, qos_rpc_type[i], limits[i]);
+			}
+		}
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+
+	if (qos->group == NULL) {
+		return;
+	}
+
+	bdev_qos_get_limits(qos->min_guarantees, limits);
+
 	spdk_json_write_object_begin(w);
-	spdk_json_write_named_string(w, "method", "bdev_set_qos_limit");
+	spdk_json_write_named_string(w, "method", "bdev_qos_group_add_bdev");
 
 	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "group_name", qos->group->name);
 	spdk_json_write_named_string(w, "name", bdev->name);
 	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 		if (limits[i] > 0) {
-			spdk_json_write_named_uint64(w, qos_rpc_type[i], limits[i]);
+			spdk_json_write_named_uint64(w, qos_min_rpc_type[i], limits[i]);
 		}
 	}
 	spdk_json_write_object_end(w);
@@ -1837,8 +2369,54 @@ bdev_qos_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 	spdk_json_write_object_end(w);
 }
 
-void
-spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
+static void
+bdev_io_merge_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	if (bdev->internal.merge_hold_us == 0) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "bdev_set_io_merge");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "name", bdev->name);
+	spdk_json_write_named_uint64(w, "hold_us", bdev->internal.merge_hold_us);
+	spdk_json_write_named_uint32(w, "max_size_kb", bdev->internal.merge_max_size_kb);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
+static void
+bdev_qos_groups_config_json(struct spdk_json_write_ctx *w)
+{
+	struct spdk_bdev_qos_group *group;
+	uint64_t limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	int i;
+
+	TAILQ_FOREACH(group, &g_bdev_mgr.qos_groups, link) {
+		bdev_qos_get_limits(group->rate_limits, limits);
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_qos_group_create");
+
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "name", group->name);
+		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+			if (limits[i] > 0) {
+				spdk_json_write_named_uint64(w, qos_rpc_type[i], limits[i]);
+			}
+		}
+		spdk_json_write_named_uint32(w, "burst_ms", bdev_qos_group_get_burst_ms(group));
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+}
+
+void
+spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 {
 	struct spdk_bdev_module *bdev_module;
 	struct spdk_bdev *bdev;
@@ -1853,6 +2431,9 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_uint32(w, "bdev_io_pool_size", g_bdev_opts.bdev_io_pool_size);
 	spdk_json_write_named_uint32(w, "bdev_io_cache_size", g_bdev_opts.bdev_io_cache_size);
 	spdk_json_write_named_bool(w, "bdev_auto_examine", g_bdev_opts.bdev_auto_examine);
+	spdk_json_write_named_bool(w, "qos_distributed", g_bdev_opts.qos_distributed);
+	spdk_json_write_named_uint32(w, "examine_max_in_progress",
+				     g_bdev_opts.examine_max_in_progress);
 	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 
@@ -1866,12 +2447,15 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 
 	spdk_spin_lock(&g_bdev_mgr.spinlock);
 
+	bdev_qos_groups_config_json(w);
+
 	TAILQ_FOREACH(bdev, &g_bdev_mgr.bdevs, internal.link) {
 		if (bdev->fn_table->write_config_json) {
 			bdev->fn_table->write_config_json(bdev, w);
 		}
 
 		bdev_qos_config_json(bdev, w);
+		bdev_io_merge_config_json(bdev, w);
 	}
 
 	spdk_spin_unlock(&g_bdev_mgr.spinlock);
@@ -1884,6 +2468,65 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_array_end(w);
 }
 
+static struct spdk_bdev_io *
+bdev_io_pool_get(uint32_t pool_idx)
+{
+	struct spdk_bdev_io_pool *pool = &g_bdev_mgr.bdev_io_pools[pool_idx];
+	struct spdk_bdev_io *bdev_io;
+	uint32_t i;
+
+	bdev_io = spdk_mempool_get(pool->mempool);
+	if (spdk_likely(bdev_io != NULL)) {
+		bdev_io->internal.pool_idx = pool_idx;
+		return bdev_io;
+	}
+
+	__atomic_fetch_add(&pool->exhausted, 1, __ATOMIC_RELAXED);
+
+	/* Fall back to the pools of the other sockets */
+	for (i = 0; i < g_bdev_mgr.num_bdev_io_pools; i++) {
+		if (i == pool_idx) {
+			continue;
+		}
+
+		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pools[i].mempool);
+		if (bdev_io != NULL) {
+			bdev_io->internal.pool_idx = i;
+			return bdev_io;
+		}
+	}
+
+	return NULL;
+}
+
+static inline void
+bdev_io_pool_put(struct spdk_bdev_io *bdev_io)
+{
+	assert(bdev_io->internal.pool_idx < g_bdev_mgr.num_bdev_io_pools);
+
+	spdk_mempool_put(g_bdev_mgr.bdev_io_pools[bdev_io->internal.pool_idx].mempool, (void *)bdev_io);
+}
+
+static uint32_t
+bdev_io_pool_get_local_idx(void)
+{
+	uint32_t core = spdk_env_get_current_core();
+	uint32_t socket_id, i;
+
+	if (core == SPDK_ENV_LCORE_ID_ANY) {
+		return 0;
+	}
+
+	socket_id = spdk_env_get_socket_id(core);
+	for (i = 0; i < g_bdev_mgr.num_bdev_io_pools; i++) {
+		if (g_bdev_mgr.bdev_io_pools[i].socket_id == socket_id) {
+			return i;
+		}
+	}
+
+	return 0;
+}
+
 static void
 bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
 {
@@ -1896,7 +2539,7 @@ bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
 		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
 		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
 		ch->per_thread_cache_count--;
-		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
+		bdev_io_pool_put(bdev_io);
 	}
 
 	assert(ch->per_thread_cache_count == 0);
@@ -1918,11 +2561,12 @@ bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 
 	STAILQ_INIT(&ch->per_thread_cache);
 	ch->bdev_io_cache_size = g_bdev_opts.bdev_io_cache_size;
+	ch->bdev_io_pool_idx = bdev_io_pool_get_local_idx();
 
 	/* Pre-populate bdev_io cache to ensure this thread cannot be starved. */
 	ch->per_thread_cache_count = 0;
 	for (i = 0; i < ch->bdev_io_cache_size; i++) {
-		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
+		bdev_io = bdev_io_pool_get(ch->bdev_io_pool_idx);
 		if (bdev_io == NULL) {
 			SPDK_ERRLOG("You need to increase bdev_io_pool_size using bdev_set_options RPC.\n");
 			assert(false);
@@ -2027,6 +2671,15 @@ spdk_bdev_module_init_done(struct spdk_bdev_module *module)
 void
 spdk_bdev_module_examine_done(struct spdk_bdev_module *module)
 {
+	spdk_spin_lock(&module->internal.spinlock);
+	assert(module->internal.examine_in_progress > 0);
+	if (--module->internal.examine_in_progress == 0) {
+		module->internal.examine_busy_tsc += spdk_get_ticks() -
+						     module->internal.examine_start_tsc;
+	}
+	spdk_spin_unlock(&module->internal.spinlock);
+
+	bdev_examine_pending_schedule();
 	bdev_module_action_done(module);
 }
 
@@ -2074,11 +2727,112 @@ bdev_modules_init(void)
 	return 0;
 }
 
+static int
+bdev_io_pools_create(void)
+{
+	uint32_t socket_ids[SPDK_BDEV_IO_POOL_MAX_SOCKETS];
+	uint32_t num_sockets = 0, core, socket_id, i;
+	struct spdk_bdev_io_pool *pool;
+	char mempool_name[32];
+
+	SPDK_ENV_FOREACH_CORE(core) {
+		socket_id = spdk_env_get_socket_id(core);
+		if (socket_id == (uint32_t)SPDK_ENV_SOCKET_ID_ANY) {
+			continue;
+		}
+
+		for (i = 0; i < num_sockets; i++) {
+			if (socket_ids[i] == socket_id) {
+				break;
+			}
+		}
+
+		if (i == num_sockets && num_sockets < SPDK_BDEV_IO_POOL_MAX_SOCKETS) {
+			socket_ids[num_sockets++] = socket_id;
+		}
+	}
+
+	if (num_sockets == 0) {
+		socket_ids[num_sockets++] = (uint32_t)SPDK_ENV_SOCKET_ID_ANY;
+	}
+
+	assert(g_bdev_mgr.num_bdev_io_pools == 0);
+
+	for (i = 0; i < num_sockets; i++) {
+		pool = &g_bdev_mgr.bdev_io_pools[i];
+
+		pool->socket_id = socket_ids[i];
+		pool->size = g_bdev_opts.bdev_io_pool_size / num_sockets +
+			     (i < g_bdev_opts.bdev_io_pool_size % num_sockets ? 1 : 0);
+		pool->exhausted = 0;
+
+		if (num_sockets == 1) {
+			snprintf(mempool_name, sizeof(mempool_name), "bdev_io_%d", getpid());
+		} else {
+			snprintf(mempool_name, sizeof(mempool_name), "bdev_io_%d_%u", getpid(), pool->socket_id);
+		}
+
+		pool->mempool = spdk_mempool_create(mempool_name, pool->size,
+						    sizeof(struct spdk_bdev_io) +
+						    bdev_module_get_max_ctx_size(),
+						    0,
+						    (int)pool->socket_id);
+		if (pool->mempool == NULL) {
+			return -ENOMEM;
+		}
+
+		g_bdev_mgr.num_bdev_io_pools++;
+	}
+
+	return 0;
+}
+
+static void
+bdev_io_pools_free(void)
+{
+	struct spdk_bdev_io_pool *pool;
+	uint32_t i;
+
+	for (i = 0; i < g_bdev_mgr.num_bdev_io_pools; i++) {
+		pool = &g_bdev_mgr.bdev_io_pools[i];
+
+		if (spdk_mempool_count(pool->mempool) != pool->size) {
+			SPDK_ERRLOG("bdev IO pool count is %zu but should be %u\n",
+				    spdk_mempool_count(pool->mempool), pool->size);
+		}
+
+		spdk_mempool_free(pool->mempool);
+		pool->mempool = NULL;
+	}
+
+	g_bdev_mgr.num_bdev_io_pools = 0;
+}
+
+void
+bdev_io_pools_dump_json(struct spdk_json_write_ctx *w)
+{
+	struct spdk_bdev_io_pool *pool;
+	uint32_t i;
+
+	spdk_json_write_named_array_begin(w, "bdev_io_pools");
+	for (i = 0; i < g_bdev_mgr.num_bdev_io_pools; i++) {
+		pool = &g_bdev_mgr.bdev_io_pools[i];
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_int32(w, "socket_id", (int32_t)pool->socket_id);
+		spdk_json_write_named_uint32(w, "size", pool->size);
+		spdk_json_write_named_uint64(w, "available", spdk_mempool_count(pool->mempool));
+		spdk_json_write_named_uint64(w, "exhausted",
+					     __atomic_load_n(&pool->exhausted, __ATOMIC_RELAXED));
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+}
+
 void
 spdk_bdev_initialize(spdk_bdev_init_cb cb_fn, void *cb_arg)
 {
 	int rc = 0;
-	char mempool_name[32];
 
 	assert(cb_fn != NULL);
 
@@ -2088,8 +2842,6 @@ spdk_bdev_initialize(spdk_bdev_init_cb cb_fn, void *cb_arg)
 	spdk_notify_type_register("bdev_register");
 	spdk_notify_type_register("bdev_unregister");
 
-	snprintf(mempool_name, sizeof(mempool_name), "bdev_io_%d", getpid());
-
 	rc = spdk_iobuf_register_module("bdev");
 	if (rc != 0) {
 		SPDK_ERRLOG("could not register bdev iobuf module: %s\n", spdk_strerror(-rc));
@@ -2097,14 +2849,8 @@ spdk_bdev_initialize(spdk_bdev_init_cb cb_fn, void *cb_arg)
 		return;
 	}
 
-	g_bdev_mgr.bdev_io_pool = spdk_mempool_create(mempool_name,
-				  g_bdev_opts.bdev_io_pool_size,
-				  sizeof(struct spdk_bdev_io) +
-				  bdev_module_get_max_ctx_size(),
-				  0,
-				  SPDK_ENV_SOCKET_ID_ANY);
-
-	if (g_bdev_mgr.bdev_io_pool == NULL) {
+	rc = bdev_io_pools_create();
+	if (rc != 0) {
 		SPDK_ERRLOG("could not allocate spdk_bdev_io pool\n");
 		bdev_init_complete(-1);
 		return;
@@ -2143,20 +2889,14 @@ bdev_mgr_unregister_cb(void *io_device)
 {
 	spdk_bdev_fini_cb cb_fn = g_fini_cb_fn;
 
-	if (g_bdev_mgr.bdev_io_pool) {
-		if (spdk_mempool_count(g_bdev_mgr.bdev_io_pool) != g_bdev_opts.bdev_io_pool_size) {
-			SPDK_ERRLOG("bdev IO pool count is %zu but should be %u\n",
-				    spdk_mempool_count(g_bdev_mgr.bdev_io_pool),
-				    g_bdev_opts.bdev_io_pool_size);
-		}
-
-		spdk_mempool_free(g_bdev_mgr.bdev_io_pool);
-	}
+	bdev_io_pools_free();
 
 	spdk_free(g_bdev_mgr.zero_buffer);
 
 	bdev_examine_allowlist_free();
 
+	bdev_qos_groups_free();
+
 	cb_fn(g_fini_cb_arg);
 	g_fini_cb_fn = NULL;
 	g_fini_cb_arg = NULL;
@@ -2381,7 +3121,7 @@ bdev_channel_get_io(struct spdk_bdev_channel *channel)
 		 */
 		bdev_io = NULL;
 	} else {
-		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
+		bdev_io = bdev_io_pool_get(ch->bdev_io_pool_idx);
 	}
 
 	return bdev_io;
@@ -2414,7 +3154,7 @@ spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
 	} else {
 		/* We should never have a full cache with entries on the io wait queue. */
 		assert(TAILQ_EMPTY(&ch->io_wait_queue));
-		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
+		bdev_io_pool_put(bdev_io);
 	}
 }
 
@@ -2569,33 +3309,33 @@ bdev_qos_w_bps_update_quota(struct spdk_bdev_qos_limit *limit, struct spdk_bdev_
 }
 
 static void
-bdev_qos_set_ops(struct spdk_bdev_qos *qos)
+bdev_qos_set_ops(struct spdk_bdev_qos_limit *rate_limits)
 {
 	int i;
 
 	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
-		if (qos->rate_limits[i].limit == SPDK_BDEV_QOS_LIMIT_NOT_DEFINED) {
-			qos->rate_limits[i].queue_io = NULL;
-			qos->rate_limits[i].update_quota = NULL;
+		if (rate_limits[i].limit == SPDK_BDEV_QOS_LIMIT_NOT_DEFINED) {
+			rate_limits[i].queue_io = NULL;
+			rate_limits[i].update_quota = NULL;
 			continue;
 		}
 
 		switch (i) {
 		case SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT:
-			qos->rate_limits[i].queue_io = bdev_qos_rw_queue_io;
-			qos->rate_limits[i].update_quota = bdev_qos_rw_iops_update_quota;
+			rate_limits[i].queue_io = bdev_qos_rw_queue_io;
+			rate_limits[i].update_quota = bdev_qos_rw_iops_update_quota;
 			break;
 		case SPDK_BDEV_QOS_RW_BPS_RATE_LIMIT:
-			qos->rate_limits[i].queue_io = bdev_qos_rw_queue_io;
-			qos->rate_limits[i].update_quota = bdev_qos_rw_bps_update_quota;
+			rate_limits[i].queue_io = bdev_qos_rw_queue_io;
+			rate_limits[i].update_quota = bdev_qos_rw_bps_update_quota;
 			break;
 		case SPDK_BDEV_QOS_R_BPS_RATE_LIMIT:
-			qos->rate_limits[i].queue_io = bdev_qos_r_queue_io;
-			qos->rate_limits[i].update_quota = bdev_qos_r_bps_update_quota;
+			rate_limits[i].queue_io = bdev_qos_r_queue_io;
+			rate_limits[i].update_quota = bdev_qos_r_bps_update_quota;
 			break;
 		case SPDK_BDEV_QOS_W_BPS_RATE_LIMIT:
-			qos->rate_limits[i].queue_io = bdev_qos_w_queue_io;
-			qos->rate_limits[i].update_quota = bdev_qos_w_bps_update_quota;
+			rate_limits[i].queue_io = bdev_qos_w_queue_io;
+			rate_limits[i].update_quota = bdev_qos_w_bps_update_quota;
 			break;
 		default:
 			break;
@@ -2614,6 +3354,53 @@ _bdev_io_complete_in_submit(struct spdk_bdev_channel *bdev_ch,
 	bdev_io->internal.in_submit_request = false;
 }
 
+static void
+bdev_channel_submit_batch(struct spdk_bdev_channel *bdev_ch)
+{
+	struct spdk_bdev *bdev = bdev_ch->bdev;
+	struct spdk_bdev_io *ios[BDEV_BATCH_MAX_IOS];
+	uint32_t i, num_ios = bdev_ch->batch.num_ios;
+
+	/* Completions might start another batch, so work on a copy */
+	memcpy(ios, bdev_ch->batch.ios, num_ios * sizeof(ios[0]));
+	bdev_ch->batch.num_ios = 0;
+
+	if (bdev->fn_table->submit_request_batch != NULL && num_ios > 1 &&
+	    TAILQ_EMPTY(&bdev_ch->nomem_io)) {
+		for (i = 0; i < num_ios; i++) {
+			bdev_io_increment_outstanding(bdev_ch, bdev_ch->shared_resource);
+			ios[i]->internal.in_submit_request = true;
+		}
+		bdev->fn_table->submit_request_batch(bdev_ch->channel, ios, num_ios);
+		for (i = 0; i < num_ios; i++) {
+			ios[i]->internal.in_submit_request = false;
+		}
+		return;
+	}
+
+	for (i = 0; i < num_ios; i++) {
+		/* Stay behind the I/O that hit NOMEM, including the ones from this batch */
+		if (spdk_unlikely(!TAILQ_EMPTY(&bdev_ch->nomem_io))) {
+			bdev_queue_nomem_io_tail(bdev_ch, ios[i], BDEV_IO_RETRY_STATE_SUBMIT);
+			continue;
+		}
+
+		bdev_io_increment_outstanding(bdev_ch, bdev_ch->shared_resource);
+		ios[i]->internal.in_submit_request = true;
+		bdev_submit_request(bdev, bdev_ch->channel, ios[i]);
+		ios[i]->internal.in_submit_request = false;
+	}
+}
+
+static inline bool
+bdev_io_can_batch(struct spdk_bdev_io *bdev_io)
+{
+	/* The ownership of accel sequences is passed to the module by bdev_submit_request() */
+	return (bdev_io->type == SPDK_BDEV_IO_TYPE_READ ||
+		bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) &&
+	       bdev_io->u.bdev.accel_sequence == NULL;
+}
+
 static inline void
 bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io)
 {
@@ -2625,7 +3412,7 @@ bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_i
 		struct spdk_bdev_mgmt_channel *mgmt_channel = shared_resource->mgmt_ch;
 		struct spdk_bdev_io *bio_to_abort = bdev_io->u.abort.bio_to_abort;
 
-		if (bdev_abort_queued_io(&shared_resource->nomem_io, bio_to_abort) ||
+		if (bdev_channel_abort_nomem_io(bdev_ch, bio_to_abort) ||
 		    bdev_abort_buf_io(mgmt_channel, bio_to_abort)) {
 			_bdev_io_complete_in_submit(bdev_ch, bdev_io,
 						    SPDK_BDEV_IO_STATUS_SUCCESS);
@@ -2642,14 +3429,175 @@ bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_i
 		return;
 	}
 
-	if (spdk_likely(TAILQ_EMPTY(&shared_resource->nomem_io))) {
+	if (spdk_unlikely(bdev_ch->flags & BDEV_CH_BATCHING) && bdev_io_can_batch(bdev_io) &&
+	    TAILQ_EMPTY(&bdev_ch->nomem_io)) {
+		bdev_ch->batch.ios[bdev_ch->batch.num_ios++] = bdev_io;
+		if (bdev_ch->batch.num_ios == BDEV_BATCH_MAX_IOS) {
+			bdev_channel_submit_batch(bdev_ch);
+		}
+		return;
+	}
+
+	if (spdk_likely(TAILQ_EMPTY(&bdev_ch->nomem_io))) {
 		bdev_io_increment_outstanding(bdev_ch, shared_resource);
 		bdev_io->internal.in_submit_request = true;
 		bdev_submit_request(bdev, ch, bdev_io);
 		bdev_io->internal.in_submit_request = false;
 	} else {
-		bdev_queue_nomem_io_tail(shared_resource, bdev_io, BDEV_IO_RETRY_STATE_SUBMIT);
+		bdev_queue_nomem_io_tail(bdev_ch, bdev_io, BDEV_IO_RETRY_STATE_SUBMIT);
+	}
+}
+
+static uint64_t
+bdev_qos_get_io_cost(enum spdk_bdev_qos_rate_limit_type type, struct spdk_bdev_io *bdev_io)
+{
+	switch (type) {
+	case SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT:
+		return 1;
+	case SPDK_BDEV_QOS_RW_BPS_RATE_LIMIT:
+		return bdev_get_io_size_in_byte(bdev_io);
+	case SPDK_BDEV_QOS_R_BPS_RATE_LIMIT:
+		return bdev_is_read_io(bdev_io) ? bdev_get_io_size_in_byte(bdev_io) : 0;
+	case SPDK_BDEV_QOS_W_BPS_RATE_LIMIT:
+		return bdev_is_read_io(bdev_io) ? 0 : bdev_get_io_size_in_byte(bdev_io);
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Take the quota for an I/O from the quota cached in the channel, refilling the cache
+ * from the QoS rate limits in batches.  Can be called from any thread of the bdev in
+ * distributed mode, so rate_limits are only updated atomically there.
+ */
+static bool
+bdev_qos_channel_get_quota(struct spdk_bdev_channel *ch, struct spdk_bdev_qos *qos,
+			   struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_qos_limit *limit;
+	uint64_t cost[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	uint64_t timeslice;
+	int64_t remaining, quota;
+	int i;
+
+	timeslice = __atomic_load_n(&qos->last_timeslice, __ATOMIC_RELAXED);
+	if (ch->qos_quota_timeslice != timeslice) {
+		/* Quota left over from the previous timeslice is dropped */
+		memset(ch->qos_quota, 0, sizeof(ch->qos_quota));
+		ch->qos_quota_timeslice = timeslice;
+	}
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = &qos->rate_limits[i];
+		cost[i] = 0;
+		if (limit->max_per_timeslice == 0) {
+			continue;
+		}
+
+		cost[i] = bdev_qos_get_io_cost(i, bdev_io);
+		if (cost[i] == 0 || ch->qos_quota[i] >= (int64_t)cost[i]) {
+			continue;
+		}
+
+		quota = limit->max_per_timeslice >> SPDK_BDEV_QOS_DISTRIBUTED_BATCH_SHIFT;
+		quota = spdk_max(quota, (int64_t)cost[i] - ch->qos_quota[i]);
+		remaining = __atomic_load_n(&limit->remaining_this_timeslice, __ATOMIC_RELAXED);
+		do {
+			/* Like in the non-distributed mode, the last I/O may overrun the limit */
+			if (remaining <= 0) {
+				return false;
+			}
+		} while (!__atomic_compare_exchange_n(&limit->remaining_this_timeslice, &remaining,
+						      remaining - quota, true,
+						      __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+		ch->qos_quota[i] += quota;
+	}
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		ch->qos_quota[i] -= cost[i];
+	}
+
+	return true;
+}
+
+static void
+bdev_qos_group_refill(struct spdk_bdev_qos_group *group, uint64_t now)
+{
+	struct spdk_bdev_qos_limit *limit;
+	uint64_t num_timeslices;
+	int64_t max_tokens;
+	int i;
+
+	assert(spdk_spin_held(&group->lock));
+
+	if (now < (group->last_timeslice + group->timeslice_size)) {
+		return;
+	}
+
+	num_timeslices = (now - group->last_timeslice) / group->timeslice_size;
+	group->last_timeslice += num_timeslices * group->timeslice_size;
+	num_timeslices = spdk_min(num_timeslices, group->burst_timeslices);
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = &group->rate_limits[i];
+		if (limit->max_per_timeslice == 0) {
+			continue;
+		}
+
+		/* Unlike the per-bdev limits, unused tokens are kept up to the burst size. */
+		max_tokens = (int64_t)limit->max_per_timeslice * group->burst_timeslices;
+		limit->remaining_this_timeslice += num_timeslices * limit->max_per_timeslice;
+		limit->remaining_this_timeslice = spdk_min(limit->remaining_this_timeslice,
+						    max_tokens);
+	}
+}
+
+static bool
+bdev_qos_group_queue_io(struct spdk_bdev_qos *qos, struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_qos_group *group = qos->group;
+	struct spdk_bdev_qos_limit *limit, *min_guarantee;
+	int i;
+
+	spdk_spin_lock(&group->lock);
+	bdev_qos_group_refill(group, spdk_get_ticks());
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = &group->rate_limits[i];
+		min_guarantee = &qos->min_guarantees[i];
+
+		if (!limit->queue_io || limit->queue_io(limit, bdev_io) == false) {
+			continue;
+		}
+
+		/*
+		 * The group is out of tokens, but the I/O may still be issued from the rate
+		 * guaranteed to this bdev.  This keeps other bdevs of the group from starving it.
+		 */
+		if (!min_guarantee->queue_io ||
+		    min_guarantee->queue_io(min_guarantee, bdev_io) == true) {
+			spdk_spin_unlock(&group->lock);
+			return true;
+		}
+	}
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = &group->rate_limits[i];
+		if (limit->update_quota) {
+			limit->update_quota(limit, bdev_io);
+		}
 	}
+	spdk_spin_unlock(&group->lock);
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		min_guarantee = &qos->min_guarantees[i];
+		if (min_guarantee->update_quota) {
+			min_guarantee->update_quota(min_guarantee, bdev_io);
+		}
+	}
+
+	return false;
 }
 
 static bool
@@ -2658,6 +3606,10 @@ bdev_qos_queue_io(struct spdk_bdev_qos *qos, struct spdk_bdev_io *bdev_io)
 	int i;
 
 	if (bdev_qos_io_to_limit(bdev_io) == true) {
+		if (qos->distributed) {
+			return !bdev_qos_channel_get_quota(qos->ch, qos, bdev_io);
+		}
+
 		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 			if (!qos->rate_limits[i].queue_io) {
 				continue;
@@ -2668,6 +3620,9 @@ bdev_qos_queue_io(struct spdk_bdev_qos *qos, struct spdk_bdev_io *bdev_io)
 				return true;
 			}
 		}
+		if (qos->group != NULL && bdev_qos_group_queue_io(qos, bdev_io) == true) {
+			return true;
+		}
 		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 			if (!qos->rate_limits[i].update_quota) {
 				continue;
@@ -2963,6 +3918,7 @@ bdev_io_split_submit(struct spdk_bdev_io *bdev_io, struct iovec *iov, int iovcnt
 			if (bdev_io->u.bdev.split_outstanding == 0) {
 				spdk_trace_record(TRACE_BDEV_IO_DONE, 0, 0, (uintptr_t)bdev_io, bdev_io->internal.caller_ctx);
 				TAILQ_REMOVE(&bdev_io->internal.ch->io_submitted, bdev_io, internal.ch_link);
+				bdev_io_lba_lock_put(bdev_io);
 				bdev_io->internal.cb(bdev_io, false, bdev_io->internal.caller_ctx);
 			}
 		}
@@ -3086,6 +4042,7 @@ _bdev_rw_split(void *_bdev_io)
 								bdev_io->internal.status = SPDK_BDEV_IO_STATUS_FAILED;
 								spdk_trace_record(TRACE_BDEV_IO_DONE, 0, 0, (uintptr_t)bdev_io, bdev_io->internal.caller_ctx);
 								TAILQ_REMOVE(&bdev_io->internal.ch->io_submitted, bdev_io, internal.ch_link);
+								bdev_io_lba_lock_put(bdev_io);
 								bdev_io->internal.cb(bdev_io, false, bdev_io->internal.caller_ctx);
 							}
 
@@ -3241,6 +4198,7 @@ bdev_io_split_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 		assert(parent_io->internal.cb != bdev_io_split_done);
 		spdk_trace_record(TRACE_BDEV_IO_DONE, 0, 0, (uintptr_t)parent_io, bdev_io->internal.caller_ctx);
 		TAILQ_REMOVE(&parent_io->internal.ch->io_submitted, parent_io, internal.ch_link);
+		bdev_io_lba_lock_put(parent_io);
 
 		if (spdk_likely(parent_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS)) {
 			if (bdev_io_needs_sequence_exec(parent_io->internal.desc, parent_io)) {
@@ -3332,22 +4290,244 @@ bdev_rw_split_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 	_bdev_rw_split(bdev_io);
 }
 
-/* Explicitly mark this inline, since it's used as a function pointer and otherwise won't
- *  be inlined, at least on some compilers.
- */
-static inline void
-_bdev_io_submit(void *ctx)
-{
-	struct spdk_bdev_io *bdev_io = ctx;
-	struct spdk_bdev *bdev = bdev_io->bdev;
-	struct spdk_bdev_channel *bdev_ch = bdev_io->internal.ch;
+static void bdev_io_merge_done(struct spdk_bdev_io *merge_io, bool success, void *cb_arg);
 
-	if (spdk_likely(bdev_ch->flags == 0)) {
-		bdev_io_do_submit(bdev_ch, bdev_io);
-		return;
+static inline int
+bdev_merge_max_iovcnt(struct spdk_bdev *bdev)
+{
+	if (bdev->max_num_segments == 0) {
+		return SPDK_BDEV_IO_NUM_CHILD_IOV;
 	}
 
-	if (bdev_ch->flags & BDEV_CH_RESET_IN_PROGRESS) {
+	return spdk_min(bdev->max_num_segments, SPDK_BDEV_IO_NUM_CHILD_IOV);
+}
+
+static bool
+bdev_io_can_merge(struct spdk_bdev_io *bdev_io)
+{
+	if (bdev_io->type != SPDK_BDEV_IO_TYPE_READ && bdev_io->type != SPDK_BDEV_IO_TYPE_WRITE) {
+		return false;
+	}
+
+	if (bdev_io->bdev->split_on_write_unit) {
+		return false;
+	}
+
+	/* Reads without a buffer get one from the module, bounce buffers and accel sequences need
+	 * to be handled separately for each request when it completes.
+	 */
+	return bdev_io->u.bdev.iovs[0].iov_base != NULL &&
+	       bdev_io->u.bdev.md_buf == NULL &&
+	       bdev_io->u.bdev.memory_domain == NULL &&
+	       bdev_io->internal.orig_iovcnt == 0 &&
+	       !bdev_io->internal.has_accel_sequence;
+}
+
+static bool
+bdev_channel_merge_adjacent(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev *bdev = ch->bdev;
+	struct spdk_bdev_io *first = TAILQ_FIRST(&ch->merge.queue);
+	uint64_t num_blocks = ch->merge.num_blocks + bdev_io->u.bdev.num_blocks;
+
+	if (bdev_io->type != first->type || bdev_io->internal.desc != first->internal.desc ||
+	    bdev_io->u.bdev.offset_blocks != ch->merge.offset_blocks + ch->merge.num_blocks) {
+		return false;
+	}
+
+	if (num_blocks > ch->merge.max_blocks ||
+	    ch->merge.iovcnt + bdev_io->u.bdev.iovcnt > bdev_merge_max_iovcnt(bdev)) {
+		return false;
+	}
+
+	/* The merged request must not need to be split again */
+	if (bdev->split_on_optimal_io_boundary &&
+	    ch->merge.offset_blocks / bdev->optimal_io_boundary !=
+	    (ch->merge.offset_blocks + num_blocks - 1) / bdev->optimal_io_boundary) {
+		return false;
+	}
+
+	return true;
+}
+
+/* Take a consistent snapshot of the channel's statistics from any thread */
+static void
+bdev_channel_read_stat(struct spdk_bdev_channel *ch, struct spdk_bdev_io_stat *stat)
+{
+	uint32_t seq;
+
+	do {
+		seq = __atomic_load_n(&ch->stat_seq, __ATOMIC_ACQUIRE);
+		if (seq & 1) {
+			/* The update in progress takes only a few instructions */
+			continue;
+		}
+		memcpy(stat, ch->stat, offsetof(struct spdk_bdev_io_stat, io_error));
+		spdk_smp_rmb();
+	} while ((seq & 1) || __atomic_load_n(&ch->stat_seq, __ATOMIC_RELAXED) != seq);
+
+	stat->io_error = NULL;
+}
+
+static void
+bdev_channel_merge_flush(struct spdk_bdev_channel *ch)
+{
+	struct spdk_bdev_io *bdev_io, *merge_io = NULL;
+	bdev_io_tailq_t queue;
+	uint64_t num_blocks = ch->merge.num_blocks, num_merged = 0;
+	int iovcnt = 0;
+
+	if (TAILQ_EMPTY(&ch->merge.queue)) {
+		return;
+	}
+
+	TAILQ_INIT(&queue);
+	TAILQ_SWAP(&queue, &ch->merge.queue, spdk_bdev_io, internal.link);
+	ch->merge.num_blocks = 0;
+	ch->merge.iovcnt = 0;
+
+	bdev_io = TAILQ_FIRST(&queue);
+	if (TAILQ_NEXT(bdev_io, internal.link) != NULL) {
+		merge_io = bdev_channel_get_io(ch);
+	}
+
+	if (merge_io == NULL) {
+		/* Either there's nothing to merge or we ran out of spdk_bdev_io to merge into */
+		while ((bdev_io = TAILQ_FIRST(&queue)) != NULL) {
+			TAILQ_REMOVE(&queue, bdev_io, internal.link);
+			bdev_io_do_submit(ch, bdev_io);
+		}
+		return;
+	}
+
+	TAILQ_FOREACH(bdev_io, &queue, internal.link) {
+		memcpy(&merge_io->child_iov[iovcnt], bdev_io->u.bdev.iovs,
+		       bdev_io->u.bdev.iovcnt * sizeof(struct iovec));
+		iovcnt += bdev_io->u.bdev.iovcnt;
+		num_merged++;
+	}
+
+	/* The merged requests stay linked through internal.link, starting from the first one,
+	 * which is passed as the merged request's cb_arg.
+	 */
+	bdev_io = TAILQ_FIRST(&queue);
+	merge_io->internal.ch = ch;
+	merge_io->internal.desc = bdev_io->internal.desc;
+	merge_io->type = bdev_io->type;
+	merge_io->u.bdev = bdev_io->u.bdev;
+	merge_io->u.bdev.iovs = merge_io->child_iov;
+	merge_io->u.bdev.iovcnt = iovcnt;
+	merge_io->u.bdev.num_blocks = num_blocks;
+	bdev_io_init(merge_io, ch->bdev, bdev_io, bdev_io_merge_done);
+	merge_io->internal.merged = true;
+	assert(!merge_io->internal.split);
+
+	bdev_channel_stat_update_begin(ch);
+	ch->stat->num_merged_ops += num_merged - 1;
+	bdev_channel_stat_update_end(ch);
+
+	TAILQ_INSERT_TAIL(&ch->io_submitted, merge_io, internal.ch_link);
+	merge_io->internal.submit_tsc = spdk_get_ticks();
+	spdk_trace_record_tsc(merge_io->internal.submit_tsc, TRACE_BDEV_IO_START, 0, 0,
+			      (uintptr_t)merge_io, (uint64_t)merge_io->type, bdev_io,
+			      merge_io->u.bdev.offset_blocks, merge_io->u.bdev.num_blocks,
+			      spdk_bdev_get_name(ch->bdev));
+
+	bdev_io_do_submit(ch, merge_io);
+}
+
+static void
+bdev_io_merge_submit(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	if (!bdev_io_can_merge(bdev_io)) {
+		/* Keep the order of the requests by submitting the held ones first */
+		bdev_channel_merge_flush(ch);
+		bdev_io_do_submit(ch, bdev_io);
+		return;
+	}
+
+	if (!TAILQ_EMPTY(&ch->merge.queue) && !bdev_channel_merge_adjacent(ch, bdev_io)) {
+		bdev_channel_merge_flush(ch);
+	}
+
+	if (TAILQ_EMPTY(&ch->merge.queue)) {
+		if (ch->io_outstanding == 0) {
+			/* Don't add latency if there's nothing in flight to wait for */
+			bdev_io_do_submit(ch, bdev_io);
+			return;
+		}
+		ch->merge.offset_blocks = bdev_io->u.bdev.offset_blocks;
+	}
+
+	TAILQ_INSERT_TAIL(&ch->merge.queue, bdev_io, internal.link);
+	ch->merge.num_blocks += bdev_io->u.bdev.num_blocks;
+	ch->merge.iovcnt += bdev_io->u.bdev.iovcnt;
+
+	if (ch->merge.num_blocks >= ch->merge.max_blocks ||
+	    ch->merge.iovcnt >= bdev_merge_max_iovcnt(ch->bdev)) {
+		bdev_channel_merge_flush(ch);
+	}
+}
+
+static int
+bdev_channel_merge_poll(void *ctx)
+{
+	struct spdk_bdev_channel *ch = ctx;
+
+	if (TAILQ_EMPTY(&ch->merge.queue)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	bdev_channel_merge_flush(ch);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static int
+bdev_channel_update_merge(struct spdk_bdev_channel *ch)
+{
+	struct spdk_bdev *bdev = ch->bdev;
+	uint64_t max_blocks;
+
+	bdev_channel_merge_flush(ch);
+	spdk_poller_unregister(&ch->merge.poller);
+	ch->flags &= ~BDEV_CH_MERGE_ENABLED;
+
+	if (bdev->internal.merge_hold_us == 0) {
+		return 0;
+	}
+
+	max_blocks = (uint64_t)bdev->internal.merge_max_size_kb * 1024 / bdev->blocklen;
+	ch->merge.max_blocks = spdk_max(max_blocks, 1);
+
+	ch->merge.poller = SPDK_POLLER_REGISTER(bdev_channel_merge_poll, ch,
+						bdev->internal.merge_hold_us);
+	if (ch->merge.poller == NULL) {
+		SPDK_ERRLOG("Could not register the merge poller\n");
+		return -ENOMEM;
+	}
+
+	ch->flags |= BDEV_CH_MERGE_ENABLED;
+
+	return 0;
+}
+
+/* Explicitly mark this inline, since it's used as a function pointer and otherwise won't
+ *  be inlined, at least on some compilers.
+ */
+static inline void
+_bdev_io_submit(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	struct spdk_bdev_channel *bdev_ch = bdev_io->internal.ch;
+
+	if (spdk_likely(bdev_ch->flags == 0)) {
+		bdev_io_do_submit(bdev_ch, bdev_io);
+		return;
+	}
+
+	if (bdev_ch->flags & BDEV_CH_RESET_IN_PROGRESS) {
 		_bdev_io_complete_in_submit(bdev_ch, bdev_io, SPDK_BDEV_IO_STATUS_ABORTED);
 	} else if (bdev_ch->flags & BDEV_CH_QOS_ENABLED) {
 		if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_ABORT) &&
@@ -3357,6 +4537,10 @@ _bdev_io_submit(void *ctx)
 			TAILQ_INSERT_TAIL(&bdev->internal.qos->queued, bdev_io, internal.link);
 			bdev_qos_io_submit(bdev_ch, bdev->internal.qos);
 		}
+	} else if (bdev_ch->flags & BDEV_CH_MERGE_ENABLED) {
+		bdev_io_merge_submit(bdev_ch, bdev_io);
+	} else if (bdev_ch->flags & BDEV_CH_BATCHING) {
+		bdev_io_do_submit(bdev_ch, bdev_io);
 	} else {
 		SPDK_ERRLOG("unknown bdev_ch flag %x found\n", bdev_ch->flags);
 		_bdev_io_complete_in_submit(bdev_ch, bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
@@ -3420,6 +4604,211 @@ bdev_io_range_is_locked(struct spdk_bdev_io *bdev_io, struct lba_range *range)
 	}
 }
 
+static inline uint8_t
+bdev_lba_lock_shards(uint64_t offset, uint64_t length)
+{
+	uint64_t first_region = offset >> BDEV_LBA_LOCK_REGION_SHIFT;
+	uint64_t last_region = (offset + spdk_max(length, 1) - 1) >> BDEV_LBA_LOCK_REGION_SHIFT;
+	uint64_t count = spdk_min(last_region - first_region + 1, BDEV_LBA_LOCK_SHARDS);
+
+	return (first_region & BDEV_LBA_LOCK_FIRST_MASK) |
+	       ((count - 1) << BDEV_LBA_LOCK_COUNT_SHIFT);
+}
+
+static inline uint8_t
+bdev_lba_lock_shard_count(uint8_t shards)
+{
+	return ((shards & BDEV_LBA_LOCK_SHARDS_MASK) >> BDEV_LBA_LOCK_COUNT_SHIFT) + 1;
+}
+
+static inline uint8_t
+bdev_lba_lock_shard(uint8_t shards, uint8_t i)
+{
+	return ((shards & BDEV_LBA_LOCK_FIRST_MASK) + i) & BDEV_LBA_LOCK_FIRST_MASK;
+}
+
+/* Returns the LBA lock shards covered by the I/O, or 0 if locked ranges don't apply to it */
+static inline uint8_t
+bdev_io_lba_lock_shards(struct spdk_bdev_io *bdev_io)
+{
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_NVME_IO:
+	case SPDK_BDEV_IO_TYPE_NVME_IO_MD:
+		return BDEV_LBA_LOCK_ALL_SHARDS | BDEV_LBA_LOCK_ACCOUNTED;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		return bdev_lba_lock_shards(bdev_io->u.bdev.offset_blocks,
+					    bdev_io->u.bdev.num_blocks) | BDEV_LBA_LOCK_ACCOUNTED;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * The counters of a channel are only updated on its thread, the locks just read them, so they
+ * don't need atomic read-modify-writes.
+ */
+static inline void
+bdev_ch_lba_lock_account(struct spdk_bdev_channel *ch, uint8_t lba_lock, int32_t delta)
+{
+	uint32_t *counters = ch->lba_lock_io[(lba_lock & BDEV_LBA_LOCK_SLOT) ? 1 : 0];
+	uint32_t *counter;
+	uint8_t i;
+
+	for (i = 0; i < bdev_lba_lock_shard_count(lba_lock); i++) {
+		counter = &counters[bdev_lba_lock_shard(lba_lock, i)];
+		__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + delta,
+				 __ATOMIC_RELAXED);
+	}
+}
+
+static inline uint8_t
+bdev_lba_lock_slot(uint8_t lba_lock, uint32_t epoch)
+{
+	return (lba_lock & ~BDEV_LBA_LOCK_SLOT) | ((epoch & 1) ? BDEV_LBA_LOCK_SLOT : 0);
+}
+
+/*
+ * Queue the I/O on io_locked if it overlaps with one of the locked ranges.  This is done under
+ * the lock of the shard where the range was found, so that the unlock of that range, which
+ * removes it under the same lock, sees the channel waiting.
+ */
+static bool
+bdev_ch_queue_locked_io(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io,
+			uint8_t shards)
+{
+	struct spdk_bdev_lba_locks *locks = ch->bdev->internal.lba_locks;
+	struct bdev_lba_lock_shard *shard;
+	struct lba_range_node *node, find = {};
+	struct lba_range end = {};
+	uint64_t io_offset;
+	bool locked = false, get_ref = false;
+	uint8_t i;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_NVME_IO ||
+	    bdev_io->type == SPDK_BDEV_IO_TYPE_NVME_IO_MD) {
+		io_offset = 0;
+		end.offset = UINT64_MAX;
+	} else {
+		io_offset = bdev_io->u.bdev.offset_blocks;
+		end.offset = io_offset + bdev_io->u.bdev.num_blocks;
+	}
+	find.range = &end;
+
+	for (i = 0; i < bdev_lba_lock_shard_count(shards) && !locked; i++) {
+		shard = &locks->shards[bdev_lba_lock_shard(shards, i)];
+
+		spdk_spin_lock(&shard->spinlock);
+		/* Walk back from the last range starting before the end of the I/O */
+		node = RB_NFIND(lba_range_tree, &shard->ranges, &find);
+		if (node != NULL) {
+			node = RB_PREV(lba_range_tree, &shard->ranges, node);
+		} else {
+			node = RB_MAX(lba_range_tree, &shard->ranges);
+		}
+		for (; node != NULL && node->range->offset + node->range->length > io_offset;
+		     node = RB_PREV(lba_range_tree, &shard->ranges, node)) {
+			if (bdev_io_range_is_locked(bdev_io, node->range)) {
+				TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
+				if (!ch->io_locked_waiting) {
+					__atomic_store_n(&ch->io_locked_waiting, true,
+							 __ATOMIC_SEQ_CST);
+					get_ref = true;
+				}
+				locked = true;
+				break;
+			}
+		}
+		spdk_spin_unlock(&shard->spinlock);
+	}
+
+	if (get_ref) {
+		spdk_get_io_channel(__bdev_to_io_dev(ch->bdev));
+	}
+
+	return locked;
+}
+
+/*
+ * Account a write on its LBA lock shards, unless it overlaps with a locked range, in which case
+ * it's queued until that range is unlocked.  The write is accounted before looking at the locked
+ * ranges, so a lock either finds it in its counters or is seen by it.
+ */
+static bool
+bdev_io_lba_lock_wait(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_lba_locks *locks = ch->bdev->internal.lba_locks;
+	uint8_t lba_lock;
+	uint32_t epoch;
+
+	/* A write submitted before the first lock saw it is accounted by that lock */
+	if (spdk_likely(!__atomic_load_n(&locks->accounting, __ATOMIC_RELAXED))) {
+		return false;
+	}
+
+	lba_lock = bdev_io_lba_lock_shards(bdev_io);
+	if (lba_lock == 0) {
+		return false;
+	}
+
+	/* Make sure the write is accounted on the slot of an epoch that was current meanwhile */
+	while (true) {
+		epoch = __atomic_load_n(&locks->epoch, __ATOMIC_ACQUIRE);
+		lba_lock = bdev_lba_lock_slot(lba_lock, epoch);
+		bdev_ch_lba_lock_account(ch, lba_lock, 1);
+		/* Pairs with the fence of the locks reading the counters */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (spdk_likely(__atomic_load_n(&locks->epoch, __ATOMIC_RELAXED) == epoch)) {
+			break;
+		}
+		bdev_ch_lba_lock_account(ch, lba_lock, -1);
+	}
+
+	if (spdk_likely(__atomic_load_n(&locks->num_ranges, __ATOMIC_RELAXED) == 0) ||
+	    !bdev_ch_queue_locked_io(ch, bdev_io, lba_lock)) {
+		bdev_io->internal.lba_lock = lba_lock;
+		return false;
+	}
+
+	bdev_ch_lba_lock_account(ch, lba_lock, -1);
+	return true;
+}
+
+static inline void
+bdev_io_lba_lock_put(struct spdk_bdev_io *bdev_io)
+{
+	if (bdev_io->internal.lba_lock & BDEV_LBA_LOCK_ACCOUNTED) {
+		bdev_ch_lba_lock_account(bdev_io->internal.ch, bdev_io->internal.lba_lock, -1);
+		bdev_io->internal.lba_lock = 0;
+	}
+}
+
+static bool
+bdev_qos_submit_distributed(struct spdk_bdev_channel *ch, struct spdk_bdev_qos *qos,
+			    struct spdk_bdev_io *bdev_io)
+{
+	if (!qos->distributed || (ch->flags & BDEV_CH_RESET_IN_PROGRESS)) {
+		return false;
+	}
+
+	/* Aborts have to look for the I/O to abort in the QoS queue */
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_ABORT) {
+		return false;
+	}
+
+	if (bdev_qos_io_to_limit(bdev_io) == true &&
+	    !bdev_qos_channel_get_quota(ch, qos, bdev_io)) {
+		return false;
+	}
+
+	bdev_io_do_submit(ch, bdev_io);
+
+	return true;
+}
+
 void
 bdev_io_submit(struct spdk_bdev_io *bdev_io)
 {
@@ -3430,15 +4819,8 @@ bdev_io_submit(struct spdk_bdev_io *bdev_io)
 	assert(thread != NULL);
 	assert(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
 
-	if (!TAILQ_EMPTY(&ch->locked_ranges)) {
-		struct lba_range *range;
-
-		TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-			if (bdev_io_range_is_locked(bdev_io, range)) {
-				TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
-				return;
-			}
-		}
+	if (spdk_unlikely(bdev_io_lba_lock_wait(ch, bdev_io))) {
+		return;
 	}
 
 	TAILQ_INSERT_TAIL(&ch->io_submitted, bdev_io, internal.ch_link);
@@ -3457,6 +4839,8 @@ bdev_io_submit(struct spdk_bdev_io *bdev_io)
 	if (ch->flags & BDEV_CH_QOS_ENABLED) {
 		if ((thread == bdev->internal.qos->thread) || !bdev->internal.qos->thread) {
 			_bdev_io_submit(bdev_io);
+		} else if (bdev_qos_submit_distributed(ch, bdev->internal.qos, bdev_io)) {
+			return;
 		} else {
 			bdev_io->internal.io_submit_ch = ch;
 			bdev_io->internal.ch = bdev->internal.qos->ch;
@@ -3557,6 +4941,9 @@ bdev_io_init(struct spdk_bdev_io *bdev_io,
 	bdev_io->internal.split = bdev_io_should_split(bdev_io);
 	bdev_io->internal.accel_sequence = NULL;
 	bdev_io->internal.has_accel_sequence = false;
+	bdev_io->internal.merged = false;
+	bdev_io->internal.lba_lock = 0;
+	bdev_io->internal.forward.bdev = NULL;
 }
 
 static bool
@@ -3603,27 +4990,34 @@ spdk_bdev_dump_info_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 }
 
 static void
-bdev_qos_update_max_quota_per_timeslice(struct spdk_bdev_qos *qos)
+bdev_qos_limits_update_max_quota_per_timeslice(struct spdk_bdev_qos_limit *rate_limits)
 {
 	uint32_t max_per_timeslice = 0;
 	int i;
 
 	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
-		if (qos->rate_limits[i].limit == SPDK_BDEV_QOS_LIMIT_NOT_DEFINED) {
-			qos->rate_limits[i].max_per_timeslice = 0;
+		if (rate_limits[i].limit == SPDK_BDEV_QOS_LIMIT_NOT_DEFINED) {
+			rate_limits[i].max_per_timeslice = 0;
 			continue;
 		}
 
-		max_per_timeslice = qos->rate_limits[i].limit *
+		max_per_timeslice = rate_limits[i].limit *
 				    SPDK_BDEV_QOS_TIMESLICE_IN_USEC / SPDK_SEC_TO_USEC;
 
-		qos->rate_limits[i].max_per_timeslice = spdk_max(max_per_timeslice,
-							qos->rate_limits[i].min_per_timeslice);
+		rate_limits[i].max_per_timeslice = spdk_max(max_per_timeslice,
+						   rate_limits[i].min_per_timeslice);
 
-		qos->rate_limits[i].remaining_this_timeslice = qos->rate_limits[i].max_per_timeslice;
+		rate_limits[i].remaining_this_timeslice = rate_limits[i].max_per_timeslice;
 	}
 
-	bdev_qos_set_ops(qos);
+	bdev_qos_set_ops(rate_limits);
+}
+
+static void
+bdev_qos_update_max_quota_per_timeslice(struct spdk_bdev_qos *qos)
+{
+	bdev_qos_limits_update_max_quota_per_timeslice(qos->rate_limits);
+	bdev_qos_limits_update_max_quota_per_timeslice(qos->min_guarantees);
 }
 
 static int
@@ -3631,6 +5025,8 @@ bdev_channel_poll_qos(void *arg)
 {
 	struct spdk_bdev_qos *qos = arg;
 	uint64_t now = spdk_get_ticks();
+	uint64_t last_timeslice;
+	int64_t remaining;
 	int i;
 
 	if (now < (qos->last_timeslice + qos->timeslice_size)) {
@@ -3648,54 +5044,97 @@ bdev_channel_poll_qos(void *arg)
 		 * timeslice. remaining_this_timeslice is signed, so if it's negative
 		 * here, we'll account for the overrun so that the next timeslice will
 		 * be appropriately reduced.
+		 * In distributed mode other threads take quota concurrently, hence the
+		 * atomic operations on rate_limits.
 		 */
-		if (qos->rate_limits[i].remaining_this_timeslice > 0) {
-			qos->rate_limits[i].remaining_this_timeslice = 0;
+		remaining = __atomic_load_n(&qos->rate_limits[i].remaining_this_timeslice,
+					    __ATOMIC_RELAXED);
+		while (remaining > 0 &&
+		       !__atomic_compare_exchange_n(&qos->rate_limits[i].remaining_this_timeslice,
+						    &remaining, 0, true,
+						    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+		if (qos->min_guarantees[i].remaining_this_timeslice > 0) {
+			qos->min_guarantees[i].remaining_this_timeslice = 0;
 		}
 	}
 
-	while (now >= (qos->last_timeslice + qos->timeslice_size)) {
-		qos->last_timeslice += qos->timeslice_size;
+	last_timeslice = qos->last_timeslice;
+	while (now >= (last_timeslice + qos->timeslice_size)) {
+		last_timeslice += qos->timeslice_size;
 		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
-			qos->rate_limits[i].remaining_this_timeslice +=
-				qos->rate_limits[i].max_per_timeslice;
+			__atomic_fetch_add(&qos->rate_limits[i].remaining_this_timeslice,
+					   qos->rate_limits[i].max_per_timeslice, __ATOMIC_RELAXED);
+			qos->min_guarantees[i].remaining_this_timeslice +=
+				qos->min_guarantees[i].max_per_timeslice;
 		}
 	}
+	/* Channels drop their cached quota when they see the new timeslice */
+	__atomic_store_n(&qos->last_timeslice, last_timeslice, __ATOMIC_RELAXED);
 
 	return bdev_qos_io_submit(qos->ch, qos);
 }
 
+static void
+bdev_channel_free_histograms(struct spdk_bdev_channel *ch)
+{
+	int i;
+
+	if (ch->split_histograms != NULL) {
+		for (i = 0; i < SPDK_BDEV_HISTOGRAM_NUM_SPLIT; i++) {
+			spdk_histogram_data_free(ch->split_histograms[i]);
+		}
+		free(ch->split_histograms);
+		ch->split_histograms = NULL;
+	}
+
+	spdk_histogram_data_free(ch->histogram);
+	ch->histogram = NULL;
+}
+
+static int
+bdev_channel_alloc_histograms(struct spdk_bdev_channel *ch)
+{
+	ch->histogram = spdk_histogram_data_alloc();
+	ch->split_histograms = calloc(SPDK_BDEV_HISTOGRAM_NUM_SPLIT,
+				      sizeof(*ch->split_histograms));
+	if (ch->histogram == NULL || ch->split_histograms == NULL) {
+		bdev_channel_free_histograms(ch);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
 static void
 bdev_channel_destroy_resource(struct spdk_bdev_channel *ch)
 {
 	struct spdk_bdev_shared_resource *shared_resource;
-	struct lba_range *range;
 
 	bdev_free_io_stat(ch->stat);
 #ifdef SPDK_CONFIG_VTUNE
 	bdev_free_io_stat(ch->prev_stat);
 #endif
 
-	while (!TAILQ_EMPTY(&ch->locked_ranges)) {
-		range = TAILQ_FIRST(&ch->locked_ranges);
-		TAILQ_REMOVE(&ch->locked_ranges, range, tailq);
-		free(range);
-	}
-
+	spdk_poller_unregister(&ch->merge.poller);
 	spdk_put_io_channel(ch->channel);
 	spdk_put_io_channel(ch->accel_channel);
 
 	shared_resource = ch->shared_resource;
 
 	assert(TAILQ_EMPTY(&ch->io_locked));
+	assert(TAILQ_EMPTY(&ch->merge.queue));
 	assert(TAILQ_EMPTY(&ch->io_submitted));
 	assert(TAILQ_EMPTY(&ch->io_accel_exec));
 	assert(TAILQ_EMPTY(&ch->io_memory_domain));
+	assert(TAILQ_EMPTY(&ch->nomem_io));
+	assert(ch->batch.num_ios == 0);
 	assert(ch->io_outstanding == 0);
 	assert(shared_resource->ref > 0);
 	shared_resource->ref--;
 	if (shared_resource->ref == 0) {
 		assert(shared_resource->io_outstanding == 0);
+		assert(TAILQ_EMPTY(&shared_resource->nomem_channels));
+		spdk_poller_unregister(&shared_resource->nomem_poller);
 		TAILQ_REMOVE(&shared_resource->mgmt_ch->shared_resources, shared_resource, link);
 		spdk_put_io_channel(spdk_io_channel_from_ctx(shared_resource->mgmt_ch));
 		free(shared_resource);
@@ -3741,8 +5180,13 @@ bdev_enable_qos(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch)
 				if (qos->rate_limits[i].limit == 0) {
 					qos->rate_limits[i].limit = SPDK_BDEV_QOS_LIMIT_NOT_DEFINED;
 				}
+				if (qos->min_guarantees[i].limit == 0) {
+					qos->min_guarantees[i].limit = SPDK_BDEV_QOS_LIMIT_NOT_DEFINED;
+				}
 			}
 			bdev_qos_update_max_quota_per_timeslice(qos);
+			/* QoS groups are only accounted for on the QoS thread */
+			qos->distributed = g_bdev_opts.qos_distributed && qos->group == NULL;
 			qos->timeslice_size =
 				SPDK_BDEV_QOS_TIMESLICE_IN_USEC * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
 			qos->last_timeslice = spdk_get_ticks();
@@ -3895,7 +5339,6 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	struct spdk_io_channel		*mgmt_io_ch;
 	struct spdk_bdev_mgmt_channel	*mgmt_ch;
 	struct spdk_bdev_shared_resource *shared_resource;
-	struct lba_range		*range;
 
 	ch->bdev = bdev;
 	ch->channel = bdev->fn_table->get_io_channel(bdev->ctxt);
@@ -3914,8 +5357,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 
 	assert(ch->histogram == NULL);
 	if (bdev->internal.histogram_enabled) {
-		ch->histogram = spdk_histogram_data_alloc();
-		if (ch->histogram == NULL) {
+		if (bdev_channel_alloc_histograms(ch) != 0) {
 			SPDK_ERRLOG("Could not allocate histogram\n");
 		}
 	}
@@ -3947,7 +5389,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 
 		shared_resource->mgmt_ch = mgmt_ch;
 		shared_resource->io_outstanding = 0;
-		TAILQ_INIT(&shared_resource->nomem_io);
+		TAILQ_INIT(&shared_resource->nomem_channels);
 		shared_resource->nomem_threshold = 0;
 		shared_resource->shared_ch = ch->channel;
 		shared_resource->ref = 1;
@@ -3956,7 +5398,9 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 
 	ch->io_outstanding = 0;
 	TAILQ_INIT(&ch->queued_resets);
-	TAILQ_INIT(&ch->locked_ranges);
+	memset(ch->lba_lock_io, 0, sizeof(ch->lba_lock_io));
+	ch->io_locked_waiting = false;
+	ch->io_locked_retries = 0;
 	ch->flags = 0;
 	ch->shared_resource = shared_resource;
 
@@ -3964,6 +5408,8 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	TAILQ_INIT(&ch->io_locked);
 	TAILQ_INIT(&ch->io_accel_exec);
 	TAILQ_INIT(&ch->io_memory_domain);
+	TAILQ_INIT(&ch->nomem_io);
+	TAILQ_INIT(&ch->merge.queue);
 
 	ch->stat = bdev_alloc_io_stat(false);
 	if (ch->stat == NULL) {
@@ -3973,6 +5419,11 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 
 	ch->stat->ticks_rate = spdk_get_ticks_hz();
 
+	if (bdev->internal.merge_hold_us != 0 && bdev_channel_update_merge(ch) != 0) {
+		bdev_channel_destroy_resource(ch);
+		return -1;
+	}
+
 #ifdef SPDK_CONFIG_VTUNE
 	{
 		char *name;
@@ -3997,21 +5448,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	spdk_spin_lock(&bdev->internal.spinlock);
 	bdev_enable_qos(bdev, ch);
 
-	TAILQ_FOREACH(range, &bdev->internal.locked_ranges, tailq) {
-		struct lba_range *new_range;
-
-		new_range = calloc(1, sizeof(*new_range));
-		if (new_range == NULL) {
-			spdk_spin_unlock(&bdev->internal.spinlock);
-			bdev_channel_destroy_resource(ch);
-			return -1;
-		}
-		new_range->length = range->length;
-		new_range->offset = range->offset;
-		new_range->locked_ctx = range->locked_ctx;
-		TAILQ_INSERT_TAIL(&ch->locked_ranges, new_range, tailq);
-	}
-
+	TAILQ_INSERT_TAIL(&bdev->internal.channels, ch, stat_link);
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
 	return 0;
@@ -4041,8 +5478,14 @@ bdev_abort_all_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry
 static void
 bdev_abort_all_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_channel *ch)
 {
+	uint32_t i;
+
 	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
 				  bdev_abort_all_buf_io_cb, ch);
+	for (i = 0; i < mgmt_ch->iobuf.num_medium; i++) {
+		spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.medium[i],
+					  bdev_abort_all_buf_io_cb, ch);
+	}
 	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
 				  bdev_abort_all_buf_io_cb, ch);
 }
@@ -4073,6 +5516,14 @@ bdev_abort_all_queued_io(bdev_io_tailq_t *queue, struct spdk_bdev_channel *ch)
 	}
 }
 
+static void
+bdev_channel_abort_merge_queue(struct spdk_bdev_channel *ch)
+{
+	bdev_abort_all_queued_io(&ch->merge.queue, ch);
+	ch->merge.num_blocks = 0;
+	ch->merge.iovcnt = 0;
+}
+
 static bool
 bdev_abort_queued_io(bdev_io_tailq_t *queue, struct spdk_bdev_io *bio_to_abort)
 {
@@ -4089,6 +5540,41 @@ bdev_abort_queued_io(bdev_io_tailq_t *queue, struct spdk_bdev_io *bio_to_abort)
 	return false;
 }
 
+static void
+bdev_channel_abort_all_nomem_io(struct spdk_bdev_channel *ch)
+{
+	bdev_io_tailq_t queue;
+
+	if (TAILQ_EMPTY(&ch->nomem_io)) {
+		return;
+	}
+
+	/* Take the I/O off the channel first, so that completing them doesn't retry the rest */
+	TAILQ_REMOVE(&ch->shared_resource->nomem_channels, ch, nomem_link);
+	TAILQ_INIT(&queue);
+	TAILQ_SWAP(&ch->nomem_io, &queue, spdk_bdev_io, internal.link);
+	bdev_abort_all_queued_io(&queue, ch);
+}
+
+static bool
+bdev_channel_abort_nomem_io(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bio_to_abort)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	TAILQ_FOREACH(bdev_io, &ch->nomem_io, internal.link) {
+		if (bdev_io == bio_to_abort) {
+			TAILQ_REMOVE(&ch->nomem_io, bio_to_abort, internal.link);
+			if (TAILQ_EMPTY(&ch->nomem_io)) {
+				TAILQ_REMOVE(&ch->shared_resource->nomem_channels, ch, nomem_link);
+			}
+			spdk_bdev_io_complete(bio_to_abort, SPDK_BDEV_IO_STATUS_ABORTED);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static int
 bdev_abort_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entry, void *cb_ctx)
 {
@@ -4109,6 +5595,7 @@ bdev_abort_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *ent
 static bool
 bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_io *bio_to_abort)
 {
+	uint32_t i;
 	int rc;
 
 	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
@@ -4117,6 +5604,14 @@ bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_io *b
 		return true;
 	}
 
+	for (i = 0; i < mgmt_ch->iobuf.num_medium; i++) {
+		rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.medium[i],
+					       bdev_abort_buf_io_cb, bio_to_abort);
+		if (rc == 1) {
+			return true;
+		}
+	}
+
 	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
 				       bdev_abort_buf_io_cb, bio_to_abort);
 	return rc == 1;
@@ -4176,6 +5671,8 @@ bdev_qos_destroy(struct spdk_bdev *bdev)
 		new_qos->rate_limits[i].remaining_this_timeslice = 0;
 		new_qos->rate_limits[i].min_per_timeslice = 0;
 		new_qos->rate_limits[i].max_per_timeslice = 0;
+		new_qos->min_guarantees[i].remaining_this_timeslice = 0;
+		new_qos->min_guarantees[i].max_per_timeslice = 0;
 	}
 
 	bdev->internal.qos = new_qos;
@@ -4204,6 +5701,9 @@ spdk_bdev_add_io_stat(struct spdk_bdev_io_stat *total, struct spdk_bdev_io_stat
 	total->num_unmap_ops += add->num_unmap_ops;
 	total->bytes_copied += add->bytes_copied;
 	total->num_copy_ops += add->num_copy_ops;
+	total->num_merged_ops += add->num_merged_ops;
+	total->num_nomem_ios += add->num_nomem_ios;
+	total->num_nomem_retries += add->num_nomem_retries;
 	total->read_latency_ticks += add->read_latency_ticks;
 	total->write_latency_ticks += add->write_latency_ticks;
 	total->unmap_latency_ticks += add->unmap_latency_ticks;
@@ -4269,6 +5769,9 @@ spdk_bdev_reset_io_stat(struct spdk_bdev_io_stat *stat, enum spdk_bdev_reset_sta
 	stat->num_unmap_ops = 0;
 	stat->bytes_copied = 0;
 	stat->num_copy_ops = 0;
+	stat->num_merged_ops = 0;
+	stat->num_nomem_ios = 0;
+	stat->num_nomem_retries = 0;
 	stat->read_latency_ticks = 0;
 	stat->write_latency_ticks = 0;
 	stat->unmap_latency_ticks = 0;
@@ -4326,6 +5829,9 @@ spdk_bdev_dump_io_stat_json(struct spdk_bdev_io_stat *stat, struct spdk_json_wri
 	spdk_json_write_named_uint64(w, "num_unmap_ops", stat->num_unmap_ops);
 	spdk_json_write_named_uint64(w, "bytes_copied", stat->bytes_copied);
 	spdk_json_write_named_uint64(w, "num_copy_ops", stat->num_copy_ops);
+	spdk_json_write_named_uint64(w, "num_merged_ops", stat->num_merged_ops);
+	spdk_json_write_named_uint64(w, "num_nomem_ios", stat->num_nomem_ios);
+	spdk_json_write_named_uint64(w, "num_nomem_retries", stat->num_nomem_retries);
 	spdk_json_write_named_uint64(w, "read_latency_ticks", stat->read_latency_ticks);
 	spdk_json_write_named_uint64(w, "max_read_latency_ticks", stat->max_read_latency_ticks);
 	spdk_json_write_named_uint64(w, "min_read_latency_ticks",
@@ -4365,8 +5871,9 @@ bdev_channel_abort_queued_ios(struct spdk_bdev_channel *ch)
 	struct spdk_bdev_shared_resource *shared_resource = ch->shared_resource;
 	struct spdk_bdev_mgmt_channel *mgmt_ch = shared_resource->mgmt_ch;
 
-	bdev_abort_all_queued_io(&shared_resource->nomem_io, ch);
+	bdev_channel_abort_all_nomem_io(ch);
 	bdev_abort_all_buf_io(mgmt_ch, ch);
+	bdev_channel_abort_merge_queue(ch);
 }
 
 static void
@@ -4380,18 +5887,20 @@ bdev_channel_destroy(void *io_device, void *ctx_buf)
 	spdk_trace_record(TRACE_BDEV_IOCH_DESTROY, 0, 0, 0, ch->bdev->name,
 			  spdk_thread_get_id(spdk_io_channel_get_thread(ch->channel)));
 
-	/* This channel is going away, so add its statistics into the bdev so that they don't get lost. */
+	/* This channel is going away, so add its statistics into the bdev so that they don't get
+	 * lost.  It's removed from the list under the same lock, so readers never miss nor double
+	 * count them.
+	 */
 	spdk_spin_lock(&ch->bdev->internal.spinlock);
 	spdk_bdev_add_io_stat(ch->bdev->internal.stat, ch->stat);
+	TAILQ_REMOVE(&ch->bdev->internal.channels, ch, stat_link);
 	spdk_spin_unlock(&ch->bdev->internal.spinlock);
 
 	bdev_abort_all_queued_io(&ch->queued_resets, ch);
 
 	bdev_channel_abort_queued_ios(ch);
 
-	if (ch->histogram) {
-		spdk_histogram_data_free(ch->histogram);
-	}
+	bdev_channel_free_histograms(ch);
 
 	bdev_channel_destroy_resource(ch);
 }
@@ -4531,6 +6040,26 @@ spdk_bdev_get_module_ctx(struct spdk_bdev_desc *desc)
 	return ctx;
 }
 
+void
+spdk_bdev_start_batch(struct spdk_io_channel *ch)
+{
+	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+
+	assert(!(bdev_ch->flags & BDEV_CH_BATCHING));
+	bdev_ch->flags |= BDEV_CH_BATCHING;
+}
+
+void
+spdk_bdev_submit_batch(struct spdk_io_channel *ch)
+{
+	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+
+	bdev_ch->flags &= ~BDEV_CH_BATCHING;
+	if (bdev_ch->batch.num_ios > 0) {
+		bdev_channel_submit_batch(bdev_ch);
+	}
+}
+
 const char *
 spdk_bdev_get_module_name(const struct spdk_bdev *bdev)
 {
@@ -4582,22 +6111,11 @@ spdk_bdev_get_qos_rpc_type(enum spdk_bdev_qos_rate_limit_type type)
 void
 spdk_bdev_get_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits)
 {
-	int i;
-
 	memset(limits, 0, sizeof(*limits) * SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES);
 
 	spdk_spin_lock(&bdev->internal.spinlock);
 	if (bdev->internal.qos) {
-		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
-			if (bdev->internal.qos->rate_limits[i].limit !=
-			    SPDK_BDEV_QOS_LIMIT_NOT_DEFINED) {
-				limits[i] = bdev->internal.qos->rate_limits[i].limit;
-				if (bdev_qos_is_iops_rate_limit(i) == false) {
-					/* Change from Byte to Megabyte which is user visible. */
-					limits[i] = limits[i] / 1024 / 1024;
-				}
-			}
-		}
+		bdev_qos_get_limits(bdev->internal.qos->rate_limits, limits);
 	}
 	spdk_spin_unlock(&bdev->internal.spinlock);
 }
@@ -6269,9 +7787,10 @@ bdev_reset_freeze_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bd
 		spdk_spin_unlock(&channel->bdev->internal.spinlock);
 	}
 
-	bdev_abort_all_queued_io(&shared_resource->nomem_io, channel);
+	bdev_channel_abort_all_nomem_io(channel);
 	bdev_abort_all_buf_io(mgmt_channel, channel);
 	bdev_abort_all_queued_io(&tmp_queued, channel);
+	bdev_channel_abort_merge_queue(channel);
 
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
@@ -6349,25 +7868,35 @@ spdk_bdev_get_io_stat(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 	bdev_get_io_stat(stat, channel->stat);
 }
 
-static void
-bdev_get_device_stat_done(struct spdk_bdev *bdev, void *_ctx, int status)
+void
+spdk_bdev_read_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat)
 {
-	struct spdk_bdev_iostat_ctx *bdev_iostat_ctx = _ctx;
+	struct spdk_bdev_channel *ch;
+	struct spdk_bdev_io_stat ch_stat;
 
-	bdev_iostat_ctx->cb(bdev, bdev_iostat_ctx->stat,
-			    bdev_iostat_ctx->cb_arg, 0);
-	free(bdev_iostat_ctx);
+	assert(bdev != NULL);
+	assert(stat != NULL);
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	/* Start with the statistics from previously deleted channels. */
+	bdev_get_io_stat(stat, bdev->internal.stat);
+
+	/* Then add the statistics from each existing channel, without messaging their threads. */
+	TAILQ_FOREACH(ch, &bdev->internal.channels, stat_link) {
+		bdev_channel_read_stat(ch, &ch_stat);
+		spdk_bdev_add_io_stat(stat, &ch_stat);
+	}
+	spdk_spin_unlock(&bdev->internal.spinlock);
 }
 
 static void
-bdev_get_each_channel_stat(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
-			   struct spdk_io_channel *ch, void *_ctx)
+bdev_get_device_stat_done(void *_ctx)
 {
 	struct spdk_bdev_iostat_ctx *bdev_iostat_ctx = _ctx;
-	struct spdk_bdev_channel *channel = __io_ch_to_bdev_ch(ch);
 
-	spdk_bdev_add_io_stat(bdev_iostat_ctx->stat, channel->stat);
-	spdk_bdev_for_each_channel_continue(i, 0);
+	bdev_iostat_ctx->cb(bdev_iostat_ctx->bdev, bdev_iostat_ctx->stat,
+			    bdev_iostat_ctx->cb_arg, 0);
+	free(bdev_iostat_ctx);
 }
 
 void
@@ -6375,6 +7904,7 @@ spdk_bdev_get_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat
 			  spdk_bdev_get_device_stat_cb cb, void *cb_arg)
 {
 	struct spdk_bdev_iostat_ctx *bdev_iostat_ctx;
+	int rc;
 
 	assert(bdev != NULL);
 	assert(stat != NULL);
@@ -6387,18 +7917,19 @@ spdk_bdev_get_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat
 		return;
 	}
 
+	bdev_iostat_ctx->bdev = bdev;
 	bdev_iostat_ctx->stat = stat;
 	bdev_iostat_ctx->cb = cb;
 	bdev_iostat_ctx->cb_arg = cb_arg;
 
-	/* Start with the statistics from previously deleted channels. */
-	spdk_spin_lock(&bdev->internal.spinlock);
-	bdev_get_io_stat(bdev_iostat_ctx->stat, bdev->internal.stat);
-	spdk_spin_unlock(&bdev->internal.spinlock);
+	spdk_bdev_read_device_stat(bdev, stat);
 
-	/* Then iterate and add the statistics from each existing channel. */
-	spdk_bdev_for_each_channel(bdev, bdev_get_each_channel_stat, bdev_iostat_ctx,
-				   bdev_get_device_stat_done);
+	/* Keep the callback asynchronous */
+	rc = spdk_thread_send_msg(spdk_get_thread(), bdev_get_device_stat_done, bdev_iostat_ctx);
+	if (rc != 0) {
+		free(bdev_iostat_ctx);
+		cb(bdev, stat, cb_arg, rc);
+	}
 }
 
 struct bdev_iostat_reset_ctx {
@@ -6424,7 +7955,9 @@ bdev_reset_each_channel_stat(struct spdk_bdev_channel_iter *i, struct spdk_bdev
 	struct bdev_iostat_reset_ctx *ctx = _ctx;
 	struct spdk_bdev_channel *channel = __io_ch_to_bdev_ch(ch);
 
+	bdev_channel_stat_update_begin(channel);
 	spdk_bdev_reset_io_stat(channel->stat, ctx->mode);
+	bdev_channel_stat_update_end(channel);
 
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
@@ -6843,6 +8376,148 @@ spdk_bdev_queue_io_wait(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 	return 0;
 }
 
+static inline int
+bdev_split_histogram_idx(enum spdk_bdev_io_type io_type,
+			 enum spdk_bdev_histogram_size_class size_class)
+{
+	return io_type * SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES + size_class;
+}
+
+static enum spdk_bdev_histogram_size_class
+bdev_io_get_size_class(struct spdk_bdev_io *bdev_io)
+{
+	uint64_t size;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+	case SPDK_BDEV_IO_TYPE_COMPARE:
+	case SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		size = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+		break;
+	default:
+		/* I/O without a data range, e.g. resets or passthru commands */
+		return SPDK_BDEV_HISTOGRAM_SIZE_4K;
+	}
+
+	if (size <= 4 * 1024) {
+		return SPDK_BDEV_HISTOGRAM_SIZE_4K;
+	} else if (size <= 16 * 1024) {
+		return SPDK_BDEV_HISTOGRAM_SIZE_16K;
+	} else if (size <= 128 * 1024) {
+		return SPDK_BDEV_HISTOGRAM_SIZE_128K;
+	}
+
+	return SPDK_BDEV_HISTOGRAM_SIZE_LARGE;
+}
+
+static void
+bdev_io_tally_split_histogram(struct spdk_bdev_io *bdev_io, uint64_t tsc_diff)
+{
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+	struct spdk_histogram_data **histogram;
+
+	histogram = &ch->split_histograms[bdev_split_histogram_idx(bdev_io->type,
+					  bdev_io_get_size_class(bdev_io))];
+	if (spdk_unlikely(*histogram == NULL)) {
+		*histogram = spdk_histogram_data_alloc();
+		if (*histogram == NULL) {
+			/* Only the split view loses this sample, the aggregated one still has it */
+			return;
+		}
+	}
+
+	spdk_histogram_data_tally(*histogram, tsc_diff);
+}
+
+enum bdev_metric {
+	BDEV_METRIC_READ_OPS,
+	BDEV_METRIC_READ_BYTES,
+	BDEV_METRIC_WRITE_OPS,
+	BDEV_METRIC_WRITE_BYTES,
+	BDEV_METRIC_UNMAP_OPS,
+	BDEV_METRIC_UNMAP_BYTES,
+	BDEV_METRIC_IO_ERRORS,
+	BDEV_METRIC_READ_LATENCY,
+	BDEV_METRIC_WRITE_LATENCY,
+};
+
+static const uint64_t g_bdev_latency_buckets_us[] = {
+	10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 100000, 1000000,
+};
+
+static const struct spdk_metric_desc g_bdev_metrics[] = {
+	[BDEV_METRIC_READ_OPS] = {
+		"spdk_bdev_read_ops", "Read operations completed", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[BDEV_METRIC_READ_BYTES] = {
+		"spdk_bdev_read_bytes", "Bytes read", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[BDEV_METRIC_WRITE_OPS] = {
+		"spdk_bdev_write_ops", "Write operations completed", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[BDEV_METRIC_WRITE_BYTES] = {
+		"spdk_bdev_write_bytes", "Bytes written", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[BDEV_METRIC_UNMAP_OPS] = {
+		"spdk_bdev_unmap_ops", "Unmap operations completed", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[BDEV_METRIC_UNMAP_BYTES] = {
+		"spdk_bdev_unmap_bytes", "Bytes unmapped", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[BDEV_METRIC_IO_ERRORS] = {
+		"spdk_bdev_io_errors", "I/O operations completed with an error",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+	[BDEV_METRIC_READ_LATENCY] = {
+		"spdk_bdev_read_latency_us", "Latency of the read operations in microseconds",
+		SPDK_METRIC_TYPE_HISTOGRAM, g_bdev_latency_buckets_us,
+		SPDK_COUNTOF(g_bdev_latency_buckets_us),
+	},
+	[BDEV_METRIC_WRITE_LATENCY] = {
+		"spdk_bdev_write_latency_us", "Latency of the write operations in microseconds",
+		SPDK_METRIC_TYPE_HISTOGRAM, g_bdev_latency_buckets_us,
+		SPDK_COUNTOF(g_bdev_latency_buckets_us),
+	},
+};
+
+static void
+bdev_io_update_metrics(struct spdk_bdev_io *bdev_io, uint64_t tsc_diff)
+{
+	struct spdk_metrics_group *metrics = bdev_io->bdev->internal.metrics;
+	uint64_t num_bytes = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+	uint64_t latency_us = tsc_diff * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+
+	if (bdev_io->internal.status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		spdk_metrics_counter_add(metrics, BDEV_METRIC_IO_ERRORS, 1);
+		return;
+	}
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		spdk_metrics_counter_add(metrics, BDEV_METRIC_READ_OPS, 1);
+		spdk_metrics_counter_add(metrics, BDEV_METRIC_READ_BYTES, num_bytes);
+		spdk_metrics_histogram_observe(metrics, BDEV_METRIC_READ_LATENCY, latency_us);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		spdk_metrics_counter_add(metrics, BDEV_METRIC_WRITE_OPS, 1);
+		spdk_metrics_counter_add(metrics, BDEV_METRIC_WRITE_BYTES, num_bytes);
+		spdk_metrics_histogram_observe(metrics, BDEV_METRIC_WRITE_LATENCY, latency_us);
+		break;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		spdk_metrics_counter_add(metrics, BDEV_METRIC_UNMAP_OPS, 1);
+		spdk_metrics_counter_add(metrics, BDEV_METRIC_UNMAP_BYTES, num_bytes);
+		break;
+	default:
+		break;
+	}
+}
+
 static inline void
 bdev_io_update_io_stat(struct spdk_bdev_io *bdev_io, uint64_t tsc_diff)
 {
@@ -6851,7 +8526,12 @@ bdev_io_update_io_stat(struct spdk_bdev_io *bdev_io, uint64_t tsc_diff)
 	uint64_t num_blocks = bdev_io->u.bdev.num_blocks;
 	uint32_t blocklen = bdev_io->bdev->blocklen;
 
+	if (spdk_unlikely(bdev_io->bdev->internal.metrics != NULL)) {
+		bdev_io_update_metrics(bdev_io, tsc_diff);
+	}
+
 	if (spdk_likely(io_status == SPDK_BDEV_IO_STATUS_SUCCESS)) {
+		bdev_channel_stat_update_begin(bdev_io->internal.ch);
 		switch (bdev_io->type) {
 		case SPDK_BDEV_IO_TYPE_READ:
 			io_stat->bytes_read += num_blocks * blocklen;
@@ -6926,6 +8606,7 @@ bdev_io_update_io_stat(struct spdk_bdev_io *bdev_io, uint64_t tsc_diff)
 		default:
 			break;
 		}
+		bdev_channel_stat_update_end(bdev_io->internal.ch);
 	} else if (io_status <= SPDK_BDEV_IO_STATUS_FAILED && io_status >= SPDK_MIN_BDEV_IO_STATUS) {
 		io_stat = bdev_io->bdev->internal.stat;
 		assert(io_stat->io_error != NULL);
@@ -6997,15 +8678,41 @@ bdev_io_complete(void *ctx)
 			      bdev_io->internal.caller_ctx);
 
 	TAILQ_REMOVE(&bdev_ch->io_submitted, bdev_io, internal.ch_link);
+	bdev_io_lba_lock_put(bdev_io);
+
+	if (spdk_unlikely(bdev_io->internal.merged)) {
+		/* Each of the merged requests accounts for itself */
+		_bdev_io_complete(bdev_io);
+		return;
+	}
 
 	if (bdev_io->internal.ch->histogram) {
 		spdk_histogram_data_tally(bdev_io->internal.ch->histogram, tsc_diff);
+		bdev_io_tally_split_histogram(bdev_io, tsc_diff);
 	}
 
+	spdk_trace_check_latency(tsc_diff);
 	bdev_io_update_io_stat(bdev_io, tsc_diff);
 	_bdev_io_complete(bdev_io);
 }
 
+static void
+bdev_io_merge_done(struct spdk_bdev_io *merge_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *bdev_io = cb_arg, *next;
+
+	while (bdev_io != NULL) {
+		next = TAILQ_NEXT(bdev_io, internal.link);
+		bdev_io->internal.status = merge_io->internal.status;
+		memcpy(&bdev_io->internal.error, &merge_io->internal.error,
+		       sizeof(bdev_io->internal.error));
+		bdev_io_complete(bdev_io);
+		bdev_io = next;
+	}
+
+	spdk_bdev_free_io(merge_io);
+}
+
 /* The difference between this function and bdev_io_complete() is that this should be called to
  * complete IOs that haven't been submitted via bdev_io_submit(), as they weren't added onto the
  * io_submitted list and don't have submit_tsc updated.
@@ -7078,21 +8785,102 @@ bdev_io_complete_sequence_cb(void *ctx, int status)
 	bdev_io_complete(bdev_io);
 }
 
+int
+spdk_bdev_io_forward_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct spdk_bdev_io *bdev_io, uint64_t offset_blocks)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+	struct spdk_bdev *orig_bdev = bdev_io->bdev;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		if (bdev_io->u.bdev.memory_domain != NULL ||
+		    bdev_io->u.bdev.accel_sequence != NULL) {
+			return -ENOTSUP;
+		}
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	/* The reference tags of protection information depend on the starting block */
+	if (bdev->blocklen != orig_bdev->blocklen || bdev->md_len != orig_bdev->md_len ||
+	    orig_bdev->dif_type != SPDK_DIF_DISABLE || bdev->split_on_write_unit ||
+	    !bdev_io_type_supported(bdev, bdev_io->type)) {
+		return -ENOTSUP;
+	}
+
+	if (bdev_io->internal.forward.bdev != NULL || bdev_ch->flags != 0 ||
+	    !TAILQ_EMPTY(&bdev_ch->nomem_io) ||
+	    __atomic_load_n(&bdev->internal.lba_locks->num_ranges, __ATOMIC_SEQ_CST) != 0) {
+		return -EAGAIN;
+	}
+
+	bdev_io->bdev = bdev;
+	bdev_io->u.bdev.offset_blocks += offset_blocks;
+	if (bdev_io_should_split(bdev_io)) {
+		bdev_io->bdev = orig_bdev;
+		bdev_io->u.bdev.offset_blocks -= offset_blocks;
+		return -ENOTSUP;
+	}
+
+	bdev_io->internal.forward.bdev = orig_bdev;
+	bdev_io->internal.forward.ch = bdev_io->internal.ch;
+	bdev_io->internal.forward.offset_blocks = offset_blocks;
+	bdev_io->internal.ch = bdev_ch;
+
+	bdev_io_increment_outstanding(bdev_ch, bdev_ch->shared_resource);
+	bdev_submit_request(bdev, bdev_ch->channel, bdev_io);
+
+	return 0;
+}
+
+/* Account for a forwarded I/O on the bdev it was forwarded to and move it back to its own bdev */
+static void
+bdev_io_forward_complete(struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_channel *bdev_ch = bdev_io->internal.ch;
+
+	bdev_io_decrement_outstanding(bdev_ch, bdev_ch->shared_resource);
+	if (bdev_io->internal.status != SPDK_BDEV_IO_STATUS_NOMEM) {
+		bdev_io_update_io_stat(bdev_io, spdk_get_ticks() - bdev_io->internal.submit_tsc);
+	}
+
+	bdev_io->bdev = bdev_io->internal.forward.bdev;
+	bdev_io->internal.ch = bdev_io->internal.forward.ch;
+	bdev_io->u.bdev.offset_blocks -= bdev_io->internal.forward.offset_blocks;
+	bdev_io->internal.forward.bdev = NULL;
+}
+
 void
 spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
 {
-	struct spdk_bdev *bdev = bdev_io->bdev;
-	struct spdk_bdev_channel *bdev_ch = bdev_io->internal.ch;
-	struct spdk_bdev_shared_resource *shared_resource = bdev_ch->shared_resource;
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_channel *bdev_ch;
+	struct spdk_bdev_shared_resource *shared_resource;
 
 	if (bdev_io->internal.status != SPDK_BDEV_IO_STATUS_PENDING) {
 		SPDK_ERRLOG("Unexpected completion on IO from %s module, status was %s\n",
-			    spdk_bdev_get_module_name(bdev),
+			    spdk_bdev_get_module_name(bdev_io->bdev),
 			    bdev_io_status_get_string(bdev_io->internal.status));
 		assert(false);
 	}
 	bdev_io->internal.status = status;
 
+	if (spdk_unlikely(bdev_io->internal.forward.bdev != NULL)) {
+		bdev_io_forward_complete(bdev_io);
+	}
+
+	bdev = bdev_io->bdev;
+	bdev_ch = bdev_io->internal.ch;
+	shared_resource = bdev_ch->shared_resource;
+
 	if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_RESET)) {
 		bool unlock_channels = false;
 
@@ -7388,6 +9176,14 @@ bdev_register(struct spdk_bdev *bdev)
 		return -ENOMEM;
 	}
 
+	bdev->internal.lba_locks = bdev_lba_locks_alloc();
+	if (!bdev->internal.lba_locks) {
+		SPDK_ERRLOG("Unable to allocate LBA range locks structure.\n");
+		bdev_free_io_stat(bdev->internal.stat);
+		free(bdev_name);
+		return -ENOMEM;
+	}
+
 	bdev->internal.status = SPDK_BDEV_STATUS_READY;
 	bdev->internal.measured_queue_depth = UINT64_MAX;
 	bdev->internal.claim_type = SPDK_BDEV_CLAIM_NONE;
@@ -7396,12 +9192,14 @@ bdev_register(struct spdk_bdev *bdev)
 	bdev->internal.qos = NULL;
 
 	TAILQ_INIT(&bdev->internal.open_descs);
+	TAILQ_INIT(&bdev->internal.channels);
 	TAILQ_INIT(&bdev->internal.locked_ranges);
 	TAILQ_INIT(&bdev->internal.pending_locked_ranges);
 	TAILQ_INIT(&bdev->aliases);
 
 	ret = bdev_name_add(&bdev->internal.bdev_name, bdev, bdev->name);
 	if (ret != 0) {
+		bdev_lba_locks_free(bdev->internal.lba_locks);
 		bdev_free_io_stat(bdev->internal.stat);
 		free(bdev_name);
 		return ret;
@@ -7420,6 +9218,7 @@ bdev_register(struct spdk_bdev *bdev)
 		if (ret != 0) {
 			SPDK_ERRLOG("Unable to add uuid:%s alias for bdev %s\n", uuid, bdev->name);
 			bdev_name_del(&bdev->internal.bdev_name);
+			bdev_lba_locks_free(bdev->internal.lba_locks);
 			bdev_free_io_stat(bdev->internal.stat);
 			free(bdev_name);
 			return ret;
@@ -7473,6 +9272,9 @@ bdev_register(struct spdk_bdev *bdev)
 
 	spdk_spin_init(&bdev->internal.spinlock);
 
+	bdev->internal.metrics = spdk_metrics_group_register(g_bdev_metrics,
+				 SPDK_COUNTOF(g_bdev_metrics), "bdev", bdev->name);
+
 	SPDK_DEBUGLOG(bdev, "Inserting bdev %s into list\n", bdev->name);
 	TAILQ_INSERT_TAIL(&g_bdev_mgr.bdevs, bdev, internal.link);
 
@@ -7498,8 +9300,15 @@ bdev_destroy_cb(void *io_device)
 	cb_arg = bdev->internal.unregister_ctx;
 
 	spdk_spin_destroy(&bdev->internal.spinlock);
+	if (bdev->internal.qos != NULL && bdev->internal.qos->group != NULL) {
+		bdev_qos_group_put(bdev->internal.qos->group);
+	}
 	free(bdev->internal.qos);
+	bdev_lba_locks_free(bdev->internal.lba_locks);
+	bdev->internal.lba_locks = NULL;
 	bdev_free_io_stat(bdev->internal.stat);
+	spdk_metrics_group_unregister(bdev->internal.metrics);
+	bdev->internal.metrics = NULL;
 
 	rc = bdev->fn_table->destruct(bdev->ctxt);
 	if (rc < 0) {
@@ -8989,25 +10798,18 @@ bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits)
 	}
 }
 
-void
-spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
-			      void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+static void
+bdev_qos_convert_limits(uint64_t *limits)
 {
-	struct set_qos_limit_ctx	*ctx;
-	uint32_t			limit_set_complement;
-	uint64_t			min_limit_per_sec;
-	int				i;
-	bool				disable_rate_limit = true;
+	uint32_t	limit_set_complement;
+	uint64_t	min_limit_per_sec;
+	int		i;
 
 	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 		if (limits[i] == SPDK_BDEV_QOS_LIMIT_NOT_DEFINED) {
 			continue;
 		}
 
-		if (limits[i] > 0) {
-			disable_rate_limit = false;
-		}
-
 		if (bdev_qos_is_iops_rate_limit(i) == true) {
 			min_limit_per_sec = SPDK_BDEV_QOS_MIN_IOS_PER_SEC;
 		} else {
@@ -9024,6 +10826,40 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 			SPDK_ERRLOG("Round up the rate limit to %" PRIu64 "\n", limits[i]);
 		}
 	}
+}
+
+static void
+bdev_qos_get_limits(const struct spdk_bdev_qos_limit *rate_limits, uint64_t *limits)
+{
+	int i;
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limits[i] = 0;
+		if (rate_limits[i].limit != SPDK_BDEV_QOS_LIMIT_NOT_DEFINED) {
+			limits[i] = rate_limits[i].limit;
+			if (bdev_qos_is_iops_rate_limit(i) == false) {
+				/* Change from Byte to Megabyte which is user visible. */
+				limits[i] = limits[i] / 1024 / 1024;
+			}
+		}
+	}
+}
+
+void
+spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
+			      void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct set_qos_limit_ctx	*ctx;
+	int				i;
+	bool				disable_rate_limit = true;
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (limits[i] != SPDK_BDEV_QOS_LIMIT_NOT_DEFINED && limits[i] > 0) {
+			disable_rate_limit = false;
+		}
+	}
+
+	bdev_qos_convert_limits(limits);
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -9045,6 +10881,11 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 	bdev->internal.qos_mod_in_progress = true;
 
 	if (disable_rate_limit == true && bdev->internal.qos) {
+		/* Members of a QoS group need the QoS channel even without limits of their own */
+		if (bdev->internal.qos->group != NULL) {
+			disable_rate_limit = false;
+		}
+
 		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 			if (limits[i] == SPDK_BDEV_QOS_LIMIT_NOT_DEFINED &&
 			    (bdev->internal.qos->rate_limits[i].limit > 0 &&
@@ -9097,17 +10938,428 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 	spdk_spin_unlock(&bdev->internal.spinlock);
 }
 
-struct spdk_bdev_histogram_ctx {
-	spdk_bdev_histogram_status_cb cb_fn;
-	void *cb_arg;
-	struct spdk_bdev *bdev;
-	int status;
-};
+static struct spdk_bdev_qos_group *
+bdev_qos_group_find(const char *name)
+{
+	struct spdk_bdev_qos_group *group;
+
+	assert(spdk_spin_held(&g_bdev_mgr.spinlock));
+
+	TAILQ_FOREACH(group, &g_bdev_mgr.qos_groups, link) {
+		if (strcmp(group->name, name) == 0) {
+			return group;
+		}
+	}
+
+	return NULL;
+}
 
 static void
-bdev_histogram_disable_channel_cb(struct spdk_bdev *bdev, void *_ctx, int status)
+bdev_qos_group_free(struct spdk_bdev_qos_group *group)
 {
-	struct spdk_bdev_histogram_ctx *ctx = _ctx;
+	spdk_spin_destroy(&group->lock);
+	free(group->name);
+	free(group);
+}
+
+static void
+bdev_qos_groups_free(void)
+{
+	struct spdk_bdev_qos_group *group;
+
+	while (!TAILQ_EMPTY(&g_bdev_mgr.qos_groups)) {
+		group = TAILQ_FIRST(&g_bdev_mgr.qos_groups);
+		assert(group->num_bdevs == 0);
+		TAILQ_REMOVE(&g_bdev_mgr.qos_groups, group, link);
+		bdev_qos_group_free(group);
+	}
+}
+
+static void
+bdev_qos_group_get(struct spdk_bdev_qos_group *group)
+{
+	spdk_spin_lock(&group->lock);
+	group->num_bdevs++;
+	spdk_spin_unlock(&group->lock);
+}
+
+static void
+bdev_qos_group_put(struct spdk_bdev_qos_group *group)
+{
+	spdk_spin_lock(&group->lock);
+	assert(group->num_bdevs > 0);
+	group->num_bdevs--;
+	spdk_spin_unlock(&group->lock);
+}
+
+static uint32_t
+bdev_qos_group_get_burst_ms(const struct spdk_bdev_qos_group *group)
+{
+	return group->burst_timeslices * SPDK_BDEV_QOS_TIMESLICE_IN_USEC / 1000;
+}
+
+int
+spdk_bdev_qos_group_create(const char *name, uint64_t *limits, uint32_t burst_ms)
+{
+	struct spdk_bdev_qos_group *group;
+	int i;
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (limits[i] != SPDK_BDEV_QOS_LIMIT_NOT_DEFINED && limits[i] > 0) {
+			break;
+		}
+	}
+	if (i == SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES) {
+		SPDK_ERRLOG("No rate limits specified for QoS group %s\n", name);
+		return -EINVAL;
+	}
+
+	group = calloc(1, sizeof(*group));
+	if (group == NULL) {
+		return -ENOMEM;
+	}
+
+	group->name = strdup(name);
+	if (group->name == NULL) {
+		free(group);
+		return -ENOMEM;
+	}
+
+	bdev_qos_convert_limits(limits);
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		group->rate_limits[i].limit = limits[i];
+		if (limits[i] == 0) {
+			group->rate_limits[i].limit = SPDK_BDEV_QOS_LIMIT_NOT_DEFINED;
+		}
+
+		if (bdev_qos_is_iops_rate_limit(i) == true) {
+			group->rate_limits[i].min_per_timeslice =
+				SPDK_BDEV_QOS_MIN_IO_PER_TIMESLICE;
+		} else {
+			group->rate_limits[i].min_per_timeslice =
+				SPDK_BDEV_QOS_MIN_BYTE_PER_TIMESLICE;
+		}
+	}
+	bdev_qos_limits_update_max_quota_per_timeslice(group->rate_limits);
+
+	group->burst_timeslices = spdk_max((uint64_t)burst_ms * 1000 /
+					   SPDK_BDEV_QOS_TIMESLICE_IN_USEC, 1);
+	group->timeslice_size =
+		SPDK_BDEV_QOS_TIMESLICE_IN_USEC * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	group->last_timeslice = spdk_get_ticks();
+	spdk_spin_init(&group->lock);
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	if (bdev_qos_group_find(name) != NULL) {
+		spdk_spin_unlock(&g_bdev_mgr.spinlock);
+		SPDK_ERRLOG("QoS group %s already exists\n", name);
+		bdev_qos_group_free(group);
+		return -EEXIST;
+	}
+	TAILQ_INSERT_TAIL(&g_bdev_mgr.qos_groups, group, link);
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	return 0;
+}
+
+int
+spdk_bdev_qos_group_delete(const char *name)
+{
+	struct spdk_bdev_qos_group *group;
+	uint32_t num_bdevs;
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	group = bdev_qos_group_find(name);
+	if (group == NULL) {
+		spdk_spin_unlock(&g_bdev_mgr.spinlock);
+		return -ENODEV;
+	}
+
+	spdk_spin_lock(&group->lock);
+	num_bdevs = group->num_bdevs;
+	spdk_spin_unlock(&group->lock);
+
+	if (num_bdevs > 0) {
+		spdk_spin_unlock(&g_bdev_mgr.spinlock);
+		SPDK_ERRLOG("QoS group %s still has %" PRIu32 " bdevs\n", name, num_bdevs);
+		return -EBUSY;
+	}
+
+	TAILQ_REMOVE(&g_bdev_mgr.qos_groups, group, link);
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	bdev_qos_group_free(group);
+
+	return 0;
+}
+
+static void
+bdev_qos_set_group(struct spdk_bdev_qos *qos, struct spdk_bdev_qos_group *group,
+		   const uint64_t *min_limits)
+{
+	int i;
+
+	qos->group = group;
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		qos->min_guarantees[i].limit = SPDK_BDEV_QOS_LIMIT_NOT_DEFINED;
+		if (group != NULL && min_limits[i] != SPDK_BDEV_QOS_LIMIT_NOT_DEFINED &&
+		    min_limits[i] > 0) {
+			qos->min_guarantees[i].limit = min_limits[i];
+		}
+	}
+}
+
+static void
+bdev_qos_group_add_bdev_msg(void *cb_arg)
+{
+	struct set_qos_limit_ctx *ctx = cb_arg;
+	struct spdk_bdev *bdev = ctx->bdev;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev_qos_set_group(bdev->internal.qos, ctx->group, ctx->min_limits);
+	bdev_qos_update_max_quota_per_timeslice(bdev->internal.qos);
+	bdev->internal.qos->distributed = false;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	bdev_set_qos_limit_done(ctx, 0);
+}
+
+void
+spdk_bdev_qos_group_add_bdev(const char *group_name, struct spdk_bdev *bdev,
+			     uint64_t *min_limits,
+			     void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct set_qos_limit_ctx	*ctx;
+	struct spdk_bdev_qos_group	*group;
+	int				i;
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	group = bdev_qos_group_find(group_name);
+	if (group != NULL) {
+		bdev_qos_group_get(group);
+	}
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	if (group == NULL) {
+		SPDK_ERRLOG("QoS group %s not found\n", group_name);
+		cb_fn(cb_arg, -ENODEV);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		bdev_qos_group_put(group);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	bdev_qos_convert_limits(min_limits);
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->bdev = bdev;
+	ctx->group = group;
+	memcpy(ctx->min_limits, min_limits, sizeof(ctx->min_limits));
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (bdev->internal.qos_mod_in_progress) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		bdev_qos_group_put(group);
+		free(ctx);
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+
+	if (bdev->internal.qos != NULL && bdev->internal.qos->group != NULL) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		SPDK_ERRLOG("Bdev %s is already in QoS group %s\n", bdev->name,
+			    bdev->internal.qos->group->name);
+		bdev_qos_group_put(group);
+		free(ctx);
+		cb_fn(cb_arg, -EBUSY);
+		return;
+	}
+	bdev->internal.qos_mod_in_progress = true;
+
+	if (bdev->internal.qos == NULL) {
+		bdev->internal.qos = calloc(1, sizeof(*bdev->internal.qos));
+		if (!bdev->internal.qos) {
+			spdk_spin_unlock(&bdev->internal.spinlock);
+			SPDK_ERRLOG("Unable to allocate memory for QoS tracking\n");
+			bdev_qos_group_put(group);
+			bdev_set_qos_limit_done(ctx, -ENOMEM);
+			return;
+		}
+
+		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+			bdev->internal.qos->rate_limits[i].limit = SPDK_BDEV_QOS_LIMIT_NOT_DEFINED;
+		}
+	}
+
+	if (bdev->internal.qos->thread == NULL) {
+		/* Enabling */
+		bdev_qos_set_group(bdev->internal.qos, group, ctx->min_limits);
+
+		spdk_bdev_for_each_channel(bdev, bdev_enable_qos_msg, ctx,
+					   bdev_enable_qos_done);
+	} else {
+		/* Updating */
+		spdk_thread_send_msg(bdev->internal.qos->thread,
+				     bdev_qos_group_add_bdev_msg, ctx);
+	}
+
+	spdk_spin_unlock(&bdev->internal.spinlock);
+}
+
+static void
+bdev_qos_group_remove_bdev_done(struct set_qos_limit_ctx *ctx)
+{
+	struct spdk_bdev *bdev = ctx->bdev;
+	uint64_t limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	int i;
+
+	bdev_qos_group_put(ctx->group);
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev_qos_get_limits(bdev->internal.qos->rate_limits, limits);
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (limits[i] > 0) {
+			break;
+		}
+	}
+
+	if (i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		bdev_set_qos_limit_done(ctx, 0);
+		return;
+	}
+
+	/* The bdev has no rate limits left on its own, so disable QoS altogether */
+	spdk_bdev_for_each_channel(bdev, bdev_disable_qos_msg, ctx,
+				   bdev_disable_qos_msg_done);
+	spdk_spin_unlock(&bdev->internal.spinlock);
+}
+
+static void
+bdev_qos_group_remove_bdev_msg(void *cb_arg)
+{
+	struct set_qos_limit_ctx *ctx = cb_arg;
+	struct spdk_bdev *bdev = ctx->bdev;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev_qos_set_group(bdev->internal.qos, NULL, NULL);
+	bdev_qos_update_max_quota_per_timeslice(bdev->internal.qos);
+	bdev->internal.qos->distributed = g_bdev_opts.qos_distributed;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	bdev_qos_group_remove_bdev_done(ctx);
+}
+
+void
+spdk_bdev_qos_group_remove_bdev(struct spdk_bdev *bdev,
+				void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct set_qos_limit_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->bdev = bdev;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (bdev->internal.qos_mod_in_progress) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		free(ctx);
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+
+	if (bdev->internal.qos == NULL || bdev->internal.qos->group == NULL) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		free(ctx);
+		cb_fn(cb_arg, -ENOENT);
+		return;
+	}
+	bdev->internal.qos_mod_in_progress = true;
+	ctx->group = bdev->internal.qos->group;
+
+	if (bdev->internal.qos->thread == NULL) {
+		bdev_qos_set_group(bdev->internal.qos, NULL, NULL);
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		bdev_qos_group_remove_bdev_done(ctx);
+		return;
+	}
+
+	spdk_thread_send_msg(bdev->internal.qos->thread,
+			     bdev_qos_group_remove_bdev_msg, ctx);
+	spdk_spin_unlock(&bdev->internal.spinlock);
+}
+
+void
+bdev_qos_groups_dump_json(struct spdk_json_write_ctx *w)
+{
+	struct spdk_bdev_qos_group *group;
+	struct spdk_bdev *bdev;
+	uint64_t limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	int i;
+
+	spdk_json_write_array_begin(w);
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	TAILQ_FOREACH(group, &g_bdev_mgr.qos_groups, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "name", group->name);
+
+		bdev_qos_get_limits(group->rate_limits, limits);
+		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+			spdk_json_write_named_uint64(w, qos_rpc_type[i], limits[i]);
+		}
+		spdk_json_write_named_uint32(w, "burst_ms", bdev_qos_group_get_burst_ms(group));
+
+		spdk_json_write_named_array_begin(w, "bdevs");
+		TAILQ_FOREACH(bdev, &g_bdev_mgr.bdevs, internal.link) {
+			spdk_spin_lock(&bdev->internal.spinlock);
+			if (bdev->internal.qos == NULL || bdev->internal.qos->group != group) {
+				spdk_spin_unlock(&bdev->internal.spinlock);
+				continue;
+			}
+
+			bdev_qos_get_limits(bdev->internal.qos->min_guarantees, limits);
+			spdk_spin_unlock(&bdev->internal.spinlock);
+
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_string(w, "name", bdev->name);
+			for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+				spdk_json_write_named_uint64(w, qos_min_rpc_type[i], limits[i]);
+			}
+			spdk_json_write_object_end(w);
+		}
+		spdk_json_write_array_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	spdk_json_write_array_end(w);
+}
+
+struct spdk_bdev_histogram_ctx {
+	spdk_bdev_histogram_status_cb cb_fn;
+	void *cb_arg;
+	struct spdk_bdev *bdev;
+	int status;
+};
+
+static void
+bdev_histogram_disable_channel_cb(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct spdk_bdev_histogram_ctx *ctx = _ctx;
 
 	spdk_spin_lock(&ctx->bdev->internal.spinlock);
 	ctx->bdev->internal.histogram_in_progress = false;
@@ -9122,10 +11374,7 @@ bdev_histogram_disable_channel(struct spdk_bdev_channel_iter *i, struct spdk_bde
 {
 	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
 
-	if (ch->histogram != NULL) {
-		spdk_histogram_data_free(ch->histogram);
-		ch->histogram = NULL;
-	}
+	bdev_channel_free_histograms(ch);
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
 
@@ -9156,10 +11405,7 @@ bdev_histogram_enable_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev
 	int status = 0;
 
 	if (ch->histogram == NULL) {
-		ch->histogram = spdk_histogram_data_alloc();
-		if (ch->histogram == NULL) {
-			status = -ENOMEM;
-		}
+		status = bdev_channel_alloc_histograms(ch);
 	}
 
 	spdk_bdev_for_each_channel_continue(i, status);
@@ -9205,6 +11451,54 @@ spdk_bdev_histogram_enable(struct spdk_bdev *bdev, spdk_bdev_histogram_status_cb
 	}
 }
 
+struct spdk_bdev_set_io_merge_ctx {
+	void (*cb_fn)(void *cb_arg, int status);
+	void *cb_arg;
+};
+
+static void
+bdev_set_io_merge_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+			  struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+
+	spdk_bdev_for_each_channel_continue(i, bdev_channel_update_merge(ch));
+}
+
+static void
+bdev_set_io_merge_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct spdk_bdev_set_io_merge_ctx *ctx = _ctx;
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+void
+spdk_bdev_set_io_merge(struct spdk_bdev *bdev, uint64_t hold_us, uint32_t max_size_kb,
+		       void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct spdk_bdev_set_io_merge_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	/* The channels pick up the latest parameters, so concurrent updates end up consistent */
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev->internal.merge_hold_us = hold_us;
+	bdev->internal.merge_max_size_kb = max_size_kb != 0 ? max_size_kb :
+					   BDEV_MERGE_DEFAULT_MAX_SIZE_KB;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	spdk_bdev_for_each_channel(bdev, bdev_set_io_merge_channel, ctx, bdev_set_io_merge_done);
+}
+
 struct spdk_bdev_histogram_data_ctx {
 	spdk_bdev_histogram_data_cb cb_fn;
 	void *cb_arg;
@@ -9262,6 +11556,115 @@ spdk_bdev_histogram_get(struct spdk_bdev *bdev, struct spdk_histogram_data *hist
 				   bdev_histogram_get_channel_cb);
 }
 
+struct spdk_bdev_split_histogram_ctx {
+	spdk_bdev_histogram_status_cb cb_fn;
+	void *cb_arg;
+	/** merged histogram data from all channels, allocated on demand */
+	struct spdk_histogram_data **histograms;
+};
+
+static void
+bdev_histogram_status_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct spdk_bdev_split_histogram_ctx *ctx = _ctx;
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+static void
+bdev_histogram_get_split_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				 struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	struct spdk_bdev_split_histogram_ctx *ctx = _ctx;
+	int idx;
+
+	if (ch->split_histograms == NULL) {
+		spdk_bdev_for_each_channel_continue(i, -EFAULT);
+		return;
+	}
+
+	for (idx = 0; idx < SPDK_BDEV_HISTOGRAM_NUM_SPLIT; idx++) {
+		if (ch->split_histograms[idx] == NULL) {
+			continue;
+		}
+
+		if (ctx->histograms[idx] == NULL) {
+			ctx->histograms[idx] = spdk_histogram_data_alloc();
+			if (ctx->histograms[idx] == NULL) {
+				spdk_bdev_for_each_channel_continue(i, -ENOMEM);
+				return;
+			}
+		}
+
+		spdk_histogram_data_merge(ctx->histograms[idx], ch->split_histograms[idx]);
+	}
+
+	spdk_bdev_for_each_channel_continue(i, 0);
+}
+
+void
+spdk_bdev_histogram_get_split(struct spdk_bdev *bdev, struct spdk_histogram_data **histograms,
+			      spdk_bdev_histogram_status_cb cb_fn, void *cb_arg)
+{
+	struct spdk_bdev_split_histogram_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->histograms = histograms;
+
+	spdk_bdev_for_each_channel(bdev, bdev_histogram_get_split_channel, ctx,
+				   bdev_histogram_status_done);
+}
+
+static void
+bdev_histogram_reset_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+			     struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	int idx;
+
+	if (ch->histogram != NULL) {
+		spdk_histogram_data_reset(ch->histogram);
+	}
+
+	if (ch->split_histograms != NULL) {
+		for (idx = 0; idx < SPDK_BDEV_HISTOGRAM_NUM_SPLIT; idx++) {
+			if (ch->split_histograms[idx] != NULL) {
+				spdk_histogram_data_reset(ch->split_histograms[idx]);
+			}
+		}
+	}
+
+	spdk_bdev_for_each_channel_continue(i, 0);
+}
+
+void
+spdk_bdev_histogram_reset(struct spdk_bdev *bdev, spdk_bdev_histogram_status_cb cb_fn,
+			  void *cb_arg)
+{
+	struct spdk_bdev_split_histogram_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_bdev_for_each_channel(bdev, bdev_histogram_reset_channel, ctx,
+				   bdev_histogram_status_done);
+}
+
 void
 spdk_bdev_channel_get_histogram(struct spdk_io_channel *ch, spdk_bdev_histogram_data_cb cb_fn,
 				void *cb_arg)
@@ -9362,141 +11765,223 @@ spdk_bdev_notify_media_management(struct spdk_bdev *bdev)
 
 struct locked_lba_range_ctx {
 	struct lba_range		range;
-	struct lba_range		*current_range;
-	struct lba_range		*owner_range;
+	/* Nodes of the range in the trees of the shards it covers */
+	struct lba_range_node		nodes[BDEV_LBA_LOCK_SHARDS];
+	/* Shards covered by the range */
+	uint8_t				shards;
+	/* Lock epoch when the range started to wait for the writes */
+	uint32_t			epoch;
 	struct spdk_poller		*poller;
 	lock_range_cb			cb_fn;
 	void				*cb_arg;
+	STAILQ_ENTRY(locked_lba_range_ctx) accounting_link;
 };
 
 static void
-bdev_lock_error_cleanup_cb(struct spdk_bdev *bdev, void *_ctx, int status)
+bdev_lba_locks_insert(struct spdk_bdev_lba_locks *locks, struct locked_lba_range_ctx *ctx)
 {
-	struct locked_lba_range_ctx *ctx = _ctx;
+	struct bdev_lba_lock_shard *shard;
+	struct lba_range_node *node;
+	uint8_t i;
 
-	ctx->cb_fn(&ctx->range, ctx->cb_arg, -ENOMEM);
-	free(ctx);
-}
+	ctx->shards = bdev_lba_lock_shards(ctx->range.offset, ctx->range.length);
+	for (i = 0; i < bdev_lba_lock_shard_count(ctx->shards); i++) {
+		shard = &locks->shards[bdev_lba_lock_shard(ctx->shards, i)];
+		node = &ctx->nodes[i];
+		node->range = &ctx->range;
 
-static void bdev_unlock_lba_range_get_channel(struct spdk_bdev_channel_iter *i,
-		struct spdk_bdev *bdev, struct spdk_io_channel *ch, void *_ctx);
+		spdk_spin_lock(&shard->spinlock);
+		node = RB_INSERT(lba_range_tree, &shard->ranges, node);
+		spdk_spin_unlock(&shard->spinlock);
+		assert(node == NULL);
+	}
+
+	/* New writes overlapping the range are queued from now on */
+	__atomic_fetch_add(&locks->num_ranges, 1, __ATOMIC_SEQ_CST);
+}
 
 static void
-bdev_lock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
+bdev_lba_locks_remove(struct spdk_bdev_lba_locks *locks, struct locked_lba_range_ctx *ctx)
+{
+	struct bdev_lba_lock_shard *shard;
+	uint8_t i;
+
+	for (i = 0; i < bdev_lba_lock_shard_count(ctx->shards); i++) {
+		shard = &locks->shards[bdev_lba_lock_shard(ctx->shards, i)];
+
+		spdk_spin_lock(&shard->spinlock);
+		RB_REMOVE(lba_range_tree, &shard->ranges, &ctx->nodes[i]);
+		spdk_spin_unlock(&shard->spinlock);
+	}
+
+	__atomic_fetch_sub(&locks->num_ranges, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Check that no channel has writes accounted on the specified epoch slot of the shards */
+static bool
+bdev_lba_locks_io_drained(struct spdk_bdev *bdev, int slot, uint8_t shards)
+{
+	struct spdk_bdev_channel *ch;
+	bool drained = true;
+	uint8_t i;
+
+	/* Pairs with the fence of the writes accounting themselves */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	TAILQ_FOREACH(ch, &bdev->internal.channels, stat_link) {
+		for (i = 0; i < bdev_lba_lock_shard_count(shards); i++) {
+			if (__atomic_load_n(&ch->lba_lock_io[slot][bdev_lba_lock_shard(shards, i)],
+					    __ATOMIC_RELAXED) != 0) {
+				drained = false;
+				goto out;
+			}
+		}
+	}
+out:
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	return drained;
+}
+
+static int
+bdev_lock_lba_range_check_io(void *_ctx)
 {
 	struct locked_lba_range_ctx *ctx = _ctx;
+	struct spdk_bdev *bdev = ctx->range.bdev;
+	struct spdk_bdev_lba_locks *locks = bdev->internal.lba_locks;
+	uint32_t epoch;
 
-	if (status == -ENOMEM) {
-		/* One of the channels could not allocate a range object.
-		 * So we have to go back and clean up any ranges that were
-		 * allocated successfully before we return error status to
-		 * the caller.  We can reuse the unlock function to do that
-		 * clean up.
+	/* The range is now in the trees, so no new write can be submitted to it.  But the
+	 * writes submitted before it was inserted may still be outstanding.  They're all
+	 * accounted on the epoch that was current then, or on an older one.
+	 */
+	epoch = __atomic_load_n(&locks->epoch, __ATOMIC_SEQ_CST);
+	if (epoch == ctx->epoch) {
+		/* Start a new epoch for the new writes.  Its slot is reused from the epoch before
+		 * the current one, which has to be drained on all the shards first.
 		 */
-		spdk_bdev_for_each_channel(bdev, bdev_unlock_lba_range_get_channel, ctx,
-					   bdev_lock_error_cleanup_cb);
-		return;
+		if (!bdev_lba_locks_io_drained(bdev, (epoch + 1) & 1, BDEV_LBA_LOCK_ALL_SHARDS)) {
+			return SPDK_POLLER_IDLE;
+		}
+		__atomic_compare_exchange_n(&locks->epoch, &epoch, epoch + 1, false,
+					    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+		epoch = __atomic_load_n(&locks->epoch, __ATOMIC_SEQ_CST);
 	}
 
-	/* All channels have locked this range and no I/O overlapping the range
-	 * are outstanding!  Set the owner_ch for the range object for the
-	 * locking channel, so that this channel will know that it is allowed
-	 * to write to this range.
-	 */
-	if (ctx->owner_range != NULL) {
-		ctx->owner_range->owner_ch = ctx->range.owner_ch;
+	/* If yet another epoch was started, its slot was drained on all the shards already */
+	if (epoch - ctx->epoch == 1 &&
+	    !bdev_lba_locks_io_drained(bdev, ctx->epoch & 1, ctx->shards)) {
+		return SPDK_POLLER_IDLE;
 	}
 
-	ctx->cb_fn(&ctx->range, ctx->cb_arg, status);
+	spdk_poller_unregister(&ctx->poller);
+
+	/* No write overlapping this range is outstanding anymore!  Note that the range's
+	 * owner_ch was set when locking, so that channel is allowed to write to it.
+	 */
+	ctx->cb_fn(&ctx->range, ctx->cb_arg, 0);
 
 	/* Don't free the ctx here.  Its range is in the bdev's global list of
 	 * locked ranges still, and will be removed and freed when this range
 	 * is later unlocked.
 	 */
+	return SPDK_POLLER_BUSY;
 }
 
-static int
-bdev_lock_lba_range_check_io(void *_i)
+static void
+bdev_lock_lba_range_wait_io(void *_ctx)
+{
+	struct locked_lba_range_ctx *ctx = _ctx;
+	struct spdk_bdev_lba_locks *locks = ctx->range.bdev->internal.lba_locks;
+
+	assert(spdk_get_thread() == ctx->range.owner_thread);
+
+	ctx->epoch = __atomic_load_n(&locks->epoch, __ATOMIC_ACQUIRE);
+	ctx->poller = SPDK_POLLER_REGISTER(bdev_lock_lba_range_check_io, ctx, 0);
+}
+
+/* Account the writes that the channel submitted before it saw the first lock of the bdev */
+static void
+bdev_ch_lba_lock_account_submitted(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				   struct spdk_io_channel *_ch, void *_ctx)
 {
-	struct spdk_bdev_channel_iter *i = _i;
-	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i->i);
 	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct locked_lba_range_ctx *ctx = i->ctx;
-	struct lba_range *range = ctx->current_range;
+	struct spdk_bdev_lba_locks *locks = _ctx;
 	struct spdk_bdev_io *bdev_io;
+	uint32_t epoch;
+	uint8_t lba_lock;
 
-	spdk_poller_unregister(&ctx->poller);
+	/* No lock waits for writes yet, so the epoch doesn't change meanwhile */
+	epoch = __atomic_load_n(&locks->epoch, __ATOMIC_ACQUIRE);
 
-	/* The range is now in the locked_ranges, so no new IO can be submitted to this
-	 * range.  But we need to wait until any outstanding IO overlapping with this range
-	 * are completed.
-	 */
 	TAILQ_FOREACH(bdev_io, &ch->io_submitted, internal.ch_link) {
-		if (bdev_io_range_is_locked(bdev_io, range)) {
-			ctx->poller = SPDK_POLLER_REGISTER(bdev_lock_lba_range_check_io, i, 100);
-			return SPDK_POLLER_BUSY;
+		if (bdev_io->internal.lba_lock != 0) {
+			continue;
+		}
+
+		lba_lock = bdev_io_lba_lock_shards(bdev_io);
+		if (lba_lock != 0) {
+			lba_lock = bdev_lba_lock_slot(lba_lock, epoch);
+			bdev_ch_lba_lock_account(ch, lba_lock, 1);
+			bdev_io->internal.lba_lock = lba_lock;
 		}
 	}
 
 	spdk_bdev_for_each_channel_continue(i, 0);
-	return SPDK_POLLER_BUSY;
 }
 
 static void
-bdev_lock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
-				struct spdk_io_channel *_ch, void *_ctx)
+bdev_lba_locks_accounted(struct spdk_bdev *bdev, void *_ctx, int status)
 {
-	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct locked_lba_range_ctx *ctx = _ctx;
-	struct lba_range *range;
+	struct spdk_bdev_lba_locks *locks = _ctx;
+	STAILQ_HEAD(, locked_lba_range_ctx) waiters;
+	struct locked_lba_range_ctx *ctx;
 
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-		if (range->length == ctx->range.length &&
-		    range->offset == ctx->range.offset &&
-		    range->locked_ctx == ctx->range.locked_ctx) {
-			/* This range already exists on this channel, so don't add
-			 * it again.  This can happen when a new channel is created
-			 * while the for_each_channel operation is in progress.
-			 * Do not check for outstanding I/O in that case, since the
-			 * range was locked before any I/O could be submitted to the
-			 * new channel.
-			 */
-			spdk_bdev_for_each_channel_continue(i, 0);
-			return;
-		}
-	}
+	STAILQ_INIT(&waiters);
 
-	range = calloc(1, sizeof(*range));
-	if (range == NULL) {
-		spdk_bdev_for_each_channel_continue(i, -ENOMEM);
-		return;
-	}
+	spdk_spin_lock(&bdev->internal.spinlock);
+	locks->accounted = true;
+	STAILQ_SWAP(&waiters, &locks->accounting_waiters, locked_lba_range_ctx);
+	spdk_spin_unlock(&bdev->internal.spinlock);
 
-	range->length = ctx->range.length;
-	range->offset = ctx->range.offset;
-	range->locked_ctx = ctx->range.locked_ctx;
-	ctx->current_range = range;
-	if (ctx->range.owner_ch == ch) {
-		/* This is the range object for the channel that will hold
-		 * the lock.  Store it in the ctx object so that we can easily
-		 * set its owner_ch after the lock is finally acquired.
-		 */
-		ctx->owner_range = range;
+	while ((ctx = STAILQ_FIRST(&waiters)) != NULL) {
+		STAILQ_REMOVE_HEAD(&waiters, accounting_link);
+		spdk_thread_send_msg(ctx->range.owner_thread, bdev_lock_lba_range_wait_io, ctx);
 	}
-	TAILQ_INSERT_TAIL(&ch->locked_ranges, range, tailq);
-	bdev_lock_lba_range_check_io(i);
 }
 
 static void
 bdev_lock_lba_range_ctx(struct spdk_bdev *bdev, struct locked_lba_range_ctx *ctx)
 {
+	struct spdk_bdev_lba_locks *locks = bdev->internal.lba_locks;
+	bool wait = false, start = false;
+
 	assert(spdk_get_thread() == ctx->range.owner_thread);
 	assert(ctx->range.owner_ch == NULL ||
 	       spdk_io_channel_get_thread(ctx->range.owner_ch->channel) == ctx->range.owner_thread);
 
-	/* We will add a copy of this range to each channel now. */
-	spdk_bdev_for_each_channel(bdev, bdev_lock_lba_range_get_channel, ctx,
-				   bdev_lock_lba_range_cb);
+	bdev_lba_locks_insert(locks, ctx);
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (spdk_unlikely(!locks->accounted)) {
+		STAILQ_INSERT_TAIL(&locks->accounting_waiters, ctx, accounting_link);
+		wait = true;
+		start = !locks->accounting;
+		__atomic_store_n(&locks->accounting, true, __ATOMIC_SEQ_CST);
+	}
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	if (spdk_unlikely(wait)) {
+		/* The writes submitted before the channels see the flag have to be accounted */
+		if (start) {
+			spdk_bdev_for_each_channel(bdev, bdev_ch_lba_lock_account_submitted, locks,
+						   bdev_lba_locks_accounted);
+		}
+		return;
+	}
+
+	bdev_lock_lba_range_wait_io(ctx);
 }
 
 static bool
@@ -9518,6 +12003,7 @@ _bdev_lock_lba_range(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch,
 		     lock_range_cb cb_fn, void *cb_arg)
 {
 	struct locked_lba_range_ctx *ctx;
+	bool pending;
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -9534,7 +12020,8 @@ _bdev_lock_lba_range(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch,
 	ctx->cb_arg = cb_arg;
 
 	spdk_spin_lock(&bdev->internal.spinlock);
-	if (bdev_lba_range_overlaps_tailq(&ctx->range, &bdev->internal.locked_ranges)) {
+	pending = bdev_lba_range_overlaps_tailq(&ctx->range, &bdev->internal.locked_ranges);
+	if (pending) {
 		/* There is an active lock overlapping with this range.
 		 * Put it on the pending list until this range no
 		 * longer overlaps with another.
@@ -9542,9 +12029,12 @@ _bdev_lock_lba_range(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch,
 		TAILQ_INSERT_TAIL(&bdev->internal.pending_locked_ranges, &ctx->range, tailq);
 	} else {
 		TAILQ_INSERT_TAIL(&bdev->internal.locked_ranges, &ctx->range, tailq);
-		bdev_lock_lba_range_ctx(bdev, ctx);
 	}
 	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	if (!pending) {
+		bdev_lock_lba_range_ctx(bdev, ctx);
+	}
 	return 0;
 }
 
@@ -9573,9 +12063,10 @@ bdev_lock_lba_range_ctx_msg(void *_ctx)
 }
 
 static void
-bdev_unlock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
+bdev_unlock_lba_range_done(void *_ctx)
 {
 	struct locked_lba_range_ctx *ctx = _ctx;
+	struct spdk_bdev *bdev = ctx->range.bdev;
 	struct locked_lba_range_ctx *pending_ctx;
 	struct lba_range *range, *tmp;
 
@@ -9597,38 +12088,23 @@ bdev_unlock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
 	}
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
-	ctx->cb_fn(&ctx->range, ctx->cb_arg, status);
+	ctx->cb_fn(&ctx->range, ctx->cb_arg, 0);
 	free(ctx);
 }
 
 static void
-bdev_unlock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
-				  struct spdk_io_channel *_ch, void *_ctx)
+bdev_ch_retry_locked_io(void *_ch)
 {
-	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct locked_lba_range_ctx *ctx = _ctx;
+	struct spdk_bdev_channel *ch = _ch;
+	struct spdk_bdev *bdev = ch->bdev;
 	TAILQ_HEAD(, spdk_bdev_io) io_locked;
 	struct spdk_bdev_io *bdev_io;
-	struct lba_range *range;
-
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-		if (ctx->range.offset == range->offset &&
-		    ctx->range.length == range->length &&
-		    ctx->range.locked_ctx == range->locked_ctx) {
-			TAILQ_REMOVE(&ch->locked_ranges, range, tailq);
-			free(range);
-			break;
-		}
-	}
+	bool put_ref;
 
-	/* Note: we should almost always be able to assert that the range specified
-	 * was found.  But there are some very rare corner cases where a new channel
-	 * gets created simultaneously with a range unlock, where this function
-	 * would execute on that new channel and wouldn't have the range.
-	 * We also use this to clean up range allocations when a later allocation
-	 * fails in the locking path.
-	 * So we can't actually assert() here.
-	 */
+	spdk_spin_lock(&bdev->internal.spinlock);
+	assert(ch->io_locked_retries > 0);
+	ch->io_locked_retries--;
+	spdk_spin_unlock(&bdev->internal.spinlock);
 
 	/* Swap the locked IO into a temporary list, and then try to submit them again.
 	 * We could hyper-optimize this to only resubmit locked I/O that overlap
@@ -9643,7 +12119,18 @@ bdev_unlock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_
 		bdev_io_submit(bdev_io);
 	}
 
-	spdk_bdev_for_each_channel_continue(i, 0);
+	/* Drop the channel's reference once nothing can send it a message anymore */
+	spdk_spin_lock(&bdev->internal.spinlock);
+	put_ref = ch->io_locked_waiting && TAILQ_EMPTY(&ch->io_locked) &&
+		  ch->io_locked_retries == 0;
+	if (put_ref) {
+		__atomic_store_n(&ch->io_locked_waiting, false, __ATOMIC_SEQ_CST);
+	}
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	if (put_ref) {
+		spdk_put_io_channel(spdk_io_channel_from_ctx(ch));
+	}
 }
 
 static int
@@ -9651,13 +12138,14 @@ _bdev_unlock_lba_range(struct spdk_bdev *bdev, uint64_t offset, uint64_t length,
 		       lock_range_cb cb_fn, void *cb_arg)
 {
 	struct locked_lba_range_ctx *ctx;
+	struct spdk_bdev_channel *ch;
+	struct spdk_thread *thread;
 	struct lba_range *range;
 
 	spdk_spin_lock(&bdev->internal.spinlock);
 	/* To start the unlock the process, we find the range in the bdev's locked_ranges
-	 * and remove it. This ensures new channels don't inherit the locked range.
-	 * Then we will send a message to each channel to remove the range from its
-	 * per-channel list.
+	 * and remove it, so that no pending range is started because of it until it's
+	 * removed from the trees as well.
 	 */
 	TAILQ_FOREACH(range, &bdev->internal.locked_ranges, tailq) {
 		if (range->offset == offset && range->length == length &&
@@ -9674,11 +12162,27 @@ _bdev_unlock_lba_range(struct spdk_bdev *bdev, uint64_t offset, uint64_t length,
 	ctx = SPDK_CONTAINEROF(range, struct locked_lba_range_ctx, range);
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
+	assert(ctx->poller == NULL);
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
-	spdk_bdev_for_each_channel(bdev, bdev_unlock_lba_range_get_channel, ctx,
-				   bdev_unlock_lba_range_cb);
+	bdev_lba_locks_remove(bdev->internal.lba_locks, ctx);
+
+	/* Only the channels with I/O queued on a locked range have to resubmit them.  A channel
+	 * queuing I/O on this range did so before it was removed from the trees above, so it's
+	 * seen waiting here.
+	 */
+	spdk_spin_lock(&bdev->internal.spinlock);
+	TAILQ_FOREACH(ch, &bdev->internal.channels, stat_link) {
+		if (__atomic_load_n(&ch->io_locked_waiting, __ATOMIC_SEQ_CST)) {
+			ch->io_locked_retries++;
+			thread = spdk_io_channel_get_thread(spdk_io_channel_from_ctx(ch));
+			spdk_thread_send_msg(thread, bdev_ch_retry_locked_io, ch);
+		}
+	}
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	spdk_thread_send_msg(spdk_get_thread(), bdev_unlock_lba_range_done, ctx);
 	return 0;
 }
 
@@ -9689,19 +12193,23 @@ bdev_unlock_lba_range(struct spdk_bdev_desc *desc, struct spdk_io_channel *_ch,
 {
 	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
 	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	struct locked_lba_range_ctx *ctx;
 	struct lba_range *range;
 	bool range_found = false;
 
 	/* Let's make sure the specified channel actually has a lock on
 	 * the specified range.  Note that the range must match exactly.
 	 */
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
+	spdk_spin_lock(&bdev->internal.spinlock);
+	TAILQ_FOREACH(range, &bdev->internal.locked_ranges, tailq) {
+		ctx = SPDK_CONTAINEROF(range, struct locked_lba_range_ctx, range);
 		if (range->offset == offset && range->length == length &&
-		    range->owner_ch == ch && range->locked_ctx == cb_arg) {
+		    range->owner_ch == ch && range->locked_ctx == cb_arg && ctx->poller == NULL) {
 			range_found = true;
 			break;
 		}
 	}
+	spdk_spin_unlock(&bdev->internal.spinlock);
 
 	if (!range_found) {
 		return -EINVAL;
@@ -13,6 +13,7 @@
 struct spdk_bdev;
 struct spdk_bdev_io;
 struct spdk_bdev_channel;
+struct spdk_json_write_ctx;
 
 struct spdk_bdev_io *bdev_channel_get_io(struct spdk_bdev_channel *channel);
 
@@ -31,4 +32,10 @@ typedef void (*bdev_reset_device_stat_cb)(struct spdk_bdev *bdev, void *cb_arg,
 void bdev_reset_device_stat(struct spdk_bdev *bdev, enum spdk_bdev_reset_stat_mode mode,
 			    bdev_reset_device_stat_cb cb, void *cb_arg);
 
+void bdev_io_pools_dump_json(struct spdk_json_write_ctx *w);
+
+void bdev_qos_groups_dump_json(struct spdk_json_write_ctx *w);
+
+void bdev_examine_stats_dump_json(struct spdk_json_write_ctx *w);
+
 #endif /* SPDK_BDEV_INTERNAL_H */
@@ -27,12 +27,16 @@ struct spdk_rpc_set_bdev_opts {
 	uint32_t bdev_io_pool_size;
 	uint32_t bdev_io_cache_size;
 	bool bdev_auto_examine;
+	bool qos_distributed;
+	uint32_t examine_max_in_progress;
 };
 
 static const struct spdk_json_object_decoder rpc_set_bdev_opts_decoders[] = {
 	{"bdev_io_pool_size", offsetof(struct spdk_rpc_set_bdev_opts, bdev_io_pool_size), spdk_json_decode_uint32, true},
 	{"bdev_io_cache_size", offsetof(struct spdk_rpc_set_bdev_opts, bdev_io_cache_size), spdk_json_decode_uint32, true},
 	{"bdev_auto_examine", offsetof(struct spdk_rpc_set_bdev_opts, bdev_auto_examine), spdk_json_decode_bool, true},
+	{"qos_distributed", offsetof(struct spdk_rpc_set_bdev_opts, qos_distributed), spdk_json_decode_bool, true},
+	{"examine_max_in_progress", offsetof(struct spdk_rpc_set_bdev_opts, examine_max_in_progress), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -45,6 +49,8 @@ rpc_bdev_set_options(struct spdk_jsonrpc_request *request, const struct spdk_jso
 	rpc_opts.bdev_io_pool_size = UINT32_MAX;
 	rpc_opts.bdev_io_cache_size = UINT32_MAX;
 	rpc_opts.bdev_auto_examine = true;
+	rpc_opts.qos_distributed = false;
+	rpc_opts.examine_max_in_progress = UINT32_MAX;
 
 	if (params != NULL) {
 		if (spdk_json_decode_object(params, rpc_set_bdev_opts_decoders,
@@ -64,6 +70,10 @@ rpc_bdev_set_options(struct spdk_jsonrpc_request *request, const struct spdk_jso
 		bdev_opts.bdev_io_cache_size = rpc_opts.bdev_io_cache_size;
 	}
 	bdev_opts.bdev_auto_examine = rpc_opts.bdev_auto_examine;
+	bdev_opts.qos_distributed = rpc_opts.qos_distributed;
+	if (rpc_opts.examine_max_in_progress != UINT32_MAX) {
+		bdev_opts.examine_max_in_progress = rpc_opts.examine_max_in_progress;
+	}
 
 	rc = spdk_bdev_set_opts(&bdev_opts);
 
@@ -105,6 +115,24 @@ rpc_bdev_wait_for_examine(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("bdev_wait_for_examine", rpc_bdev_wait_for_examine, SPDK_RPC_RUNTIME)
 
+static void
+rpc_bdev_get_examine_stats(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct spdk_json_write_ctx *w;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "bdev_get_examine_stats requires no parameters");
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	bdev_examine_stats_dump_json(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+SPDK_RPC_REGISTER("bdev_get_examine_stats", rpc_bdev_get_examine_stats, SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_examine {
 	char *name;
 };
@@ -153,6 +181,7 @@ struct rpc_get_iostat_ctx {
 	int rc;
 	struct spdk_jsonrpc_request *request;
 	struct spdk_json_write_ctx *w;
+	struct spdk_bdev_io_stat *stat;
 	bool per_channel;
 };
 
@@ -170,6 +199,7 @@ rpc_get_iostat_started(struct rpc_get_iostat_ctx *rpc_ctx)
 	spdk_json_write_object_begin(rpc_ctx->w);
 	spdk_json_write_named_uint64(rpc_ctx->w, "tick_rate", spdk_get_ticks_hz());
 	spdk_json_write_named_uint64(rpc_ctx->w, "ticks", spdk_get_ticks());
+	bdev_io_pools_dump_json(rpc_ctx->w);
 }
 
 static void
@@ -191,6 +221,7 @@ rpc_get_iostat_done(struct rpc_get_iostat_ctx *rpc_ctx)
 						 spdk_strerror(-rpc_ctx->rc));
 	}
 
+	bdev_free_io_stat(rpc_ctx->stat);
 	free(rpc_ctx);
 }
 
@@ -220,28 +251,20 @@ bdev_iostat_ctx_free(struct bdev_get_iostat_ctx *ctx)
 	free(ctx);
 }
 
-static void
-bdev_get_iostat_done(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat,
-		     void *cb_arg, int rc)
+/* The statistics are read directly from the channels, so all bdevs are dumped in one pass */
+static int
+bdev_get_iostat(void *ctx, struct spdk_bdev *bdev)
 {
-	struct bdev_get_iostat_ctx *bdev_ctx = cb_arg;
-	struct rpc_get_iostat_ctx *rpc_ctx = bdev_ctx->rpc_ctx;
+	struct rpc_get_iostat_ctx *rpc_ctx = ctx;
 	struct spdk_json_write_ctx *w = rpc_ctx->w;
 
-	if (rc != 0 || rpc_ctx->rc != 0) {
-		if (rpc_ctx->rc == 0) {
-			rpc_ctx->rc = rc;
-		}
-		goto done;
-	}
-
-	assert(stat == bdev_ctx->stat);
+	spdk_bdev_read_device_stat(bdev, rpc_ctx->stat);
 
 	spdk_json_write_object_begin(w);
 
 	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(bdev));
 
-	spdk_bdev_dump_io_stat_json(stat, w);
+	spdk_bdev_dump_io_stat_json(rpc_ctx->stat, w);
 
 	if (spdk_bdev_get_qd_sampling_period(bdev)) {
 		spdk_json_write_named_uint64(w, "queue_depth_polling_period",
@@ -263,38 +286,6 @@ bdev_get_iostat_done(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat,
 
 	spdk_json_write_object_end(w);
 
-done:
-	rpc_get_iostat_done(rpc_ctx);
-
-	spdk_bdev_close(bdev_ctx->desc);
-	bdev_iostat_ctx_free(bdev_ctx);
-}
-
-static int
-bdev_get_iostat(void *ctx, struct spdk_bdev *bdev)
-{
-	struct rpc_get_iostat_ctx *rpc_ctx = ctx;
-	struct bdev_get_iostat_ctx *bdev_ctx;
-	int rc;
-
-	bdev_ctx = bdev_iostat_ctx_alloc(true);
-	if (bdev_ctx == NULL) {
-		SPDK_ERRLOG("Failed to allocate bdev_iostat_ctx struct\n");
-		return -ENOMEM;
-	}
-
-	rc = spdk_bdev_open_ext(spdk_bdev_get_name(bdev), false, dummy_bdev_event_cb, NULL,
-				&bdev_ctx->desc);
-	if (rc != 0) {
-		bdev_iostat_ctx_free(bdev_ctx);
-		SPDK_ERRLOG("Failed to open bdev\n");
-		return rc;
-	}
-
-	rpc_ctx->bdev_count++;
-	bdev_ctx->rpc_ctx = rpc_ctx;
-	spdk_bdev_get_device_stat(bdev, bdev_ctx->stat, bdev_get_iostat_done, bdev_ctx);
-
 	return 0;
 }
 
@@ -400,55 +391,59 @@ rpc_bdev_get_iostat(struct spdk_jsonrpc_request *request,
 	rpc_ctx->request = request;
 	rpc_ctx->per_channel = req.per_channel;
 
-	if (desc != NULL) {
+	if (req.per_channel) {
 		bdev = spdk_bdev_desc_get_bdev(desc);
 
-		bdev_ctx = bdev_iostat_ctx_alloc(req.per_channel == false);
+		bdev_ctx = bdev_iostat_ctx_alloc(false);
 		if (bdev_ctx == NULL) {
 			SPDK_ERRLOG("Failed to allocate bdev_iostat_ctx struct\n");
 			rpc_ctx->rc = -ENOMEM;
 
 			spdk_bdev_close(desc);
-		} else {
-			bdev_ctx->desc = desc;
-
-			rpc_ctx->bdev_count++;
-			bdev_ctx->rpc_ctx = rpc_ctx;
-			if (req.per_channel == false) {
-				spdk_bdev_get_device_stat(bdev, bdev_ctx->stat, bdev_get_iostat_done,
-							  bdev_ctx);
-			} else {
-				/* If per_channel is true, there is no failure after here and
-				 * we have to start RPC response before executing
-				 * spdk_bdev_for_each_channel().
-				 */
-				rpc_get_iostat_started(rpc_ctx);
-				spdk_json_write_named_string(rpc_ctx->w, "name", spdk_bdev_get_name(bdev));
-				spdk_json_write_named_array_begin(rpc_ctx->w, "channels");
-
-				spdk_bdev_for_each_channel(bdev,
-							   bdev_get_per_channel_stat,
-							   bdev_ctx,
-							   bdev_get_per_channel_stat_done);
-
-				rpc_get_iostat_done(rpc_ctx);
-				return;
-			}
-		}
-	} else {
-		rc = spdk_for_each_bdev(rpc_ctx, bdev_get_iostat);
-		if (rc != 0 && rpc_ctx->rc == 0) {
-			rpc_ctx->rc = rc;
+			rpc_get_iostat_done(rpc_ctx);
+			return;
 		}
-	}
 
-	if (rpc_ctx->rc == 0) {
-		/* We want to fail the RPC for all failures. If per_channel is false,
-		 * it is enough to defer starting RPC response until it is ensured that
-		 * all spdk_bdev_for_each_channel() calls will succeed or there is no bdev.
+		bdev_ctx->desc = desc;
+
+		rpc_ctx->bdev_count++;
+		bdev_ctx->rpc_ctx = rpc_ctx;
+
+		/* There is no failure after here and we have to start RPC response before
+		 * executing spdk_bdev_for_each_channel().
 		 */
 		rpc_get_iostat_started(rpc_ctx);
-		spdk_json_write_named_array_begin(rpc_ctx->w, "bdevs");
+		spdk_json_write_named_string(rpc_ctx->w, "name", spdk_bdev_get_name(bdev));
+		spdk_json_write_named_array_begin(rpc_ctx->w, "channels");
+
+		spdk_bdev_for_each_channel(bdev,
+					   bdev_get_per_channel_stat,
+					   bdev_ctx,
+					   bdev_get_per_channel_stat_done);
+
+		rpc_get_iostat_done(rpc_ctx);
+		return;
+	}
+
+	rpc_ctx->stat = bdev_alloc_io_stat(true);
+	if (rpc_ctx->stat == NULL) {
+		SPDK_ERRLOG("Failed to allocate I/O statistics\n");
+		rpc_ctx->rc = -ENOMEM;
+		if (desc != NULL) {
+			spdk_bdev_close(desc);
+		}
+		rpc_get_iostat_done(rpc_ctx);
+		return;
+	}
+
+	rpc_get_iostat_started(rpc_ctx);
+	spdk_json_write_named_array_begin(rpc_ctx->w, "bdevs");
+
+	if (desc != NULL) {
+		bdev_get_iostat(rpc_ctx, spdk_bdev_desc_get_bdev(desc));
+		spdk_bdev_close(desc);
+	} else {
+		spdk_for_each_bdev(rpc_ctx, bdev_get_iostat);
 	}
 
 	rpc_get_iostat_done(rpc_ctx);
@@ -815,13 +810,119 @@ rpc_bdev_get_bdev_cb(struct spdk_bdev_desc *desc, int rc, void *cb_arg)
 	}
 }
 
+/* Number of bdevs written between flushes of the bdev_get_bdevs response */
+#define RPC_BDEV_GET_BDEVS_BATCH	64
+
+struct rpc_bdev_get_bdevs_iter {
+	struct spdk_jsonrpc_request	*request;
+	struct spdk_json_write_ctx	*w;
+	struct spdk_poller		*poller;
+	/* Names of the bdevs that existed when the request was received */
+	char				**names;
+	size_t				num_names;
+	size_t				max_names;
+	size_t				next;
+};
+
+static void
+free_rpc_bdev_get_bdevs_iter(struct rpc_bdev_get_bdevs_iter *iter)
+{
+	size_t i;
+
+	for (i = 0; i < iter->num_names; i++) {
+		free(iter->names[i]);
+	}
+
+	free(iter->names);
+	free(iter);
+}
+
+static int
+rpc_bdev_get_bdevs_collect(void *ctx, struct spdk_bdev *bdev)
+{
+	struct rpc_bdev_get_bdevs_iter *iter = ctx;
+	char **names;
+
+	if (iter->num_names == iter->max_names) {
+		iter->max_names = spdk_max(iter->max_names * 2, RPC_BDEV_GET_BDEVS_BATCH);
+		names = realloc(iter->names, iter->max_names * sizeof(*names));
+		if (names == NULL) {
+			return -ENOMEM;
+		}
+
+		iter->names = names;
+	}
+
+	iter->names[iter->num_names] = strdup(spdk_bdev_get_name(bdev));
+	if (iter->names[iter->num_names] == NULL) {
+		return -ENOMEM;
+	}
+
+	iter->num_names++;
+
+	return 0;
+}
+
+/* Returns true once all the bdevs have been written */
+static bool
+rpc_bdev_get_bdevs_write(struct rpc_bdev_get_bdevs_iter *iter, size_t count)
+{
+	struct spdk_bdev_desc *desc;
+	size_t end = spdk_min(iter->next + count, iter->num_names);
+
+	for (; iter->next < end; iter->next++) {
+		/* Skip the bdevs deleted since the request was received */
+		if (spdk_bdev_open_ext(iter->names[iter->next], false, dummy_bdev_event_cb, NULL,
+				       &desc) != 0) {
+			continue;
+		}
+
+		rpc_dump_bdev_info(iter->w, spdk_bdev_desc_get_bdev(desc));
+		spdk_bdev_close(desc);
+	}
+
+	return iter->next == iter->num_names;
+}
+
+static void
+rpc_bdev_get_bdevs_end(struct rpc_bdev_get_bdevs_iter *iter)
+{
+	spdk_json_write_array_end(iter->w);
+	spdk_jsonrpc_end_result(iter->request, iter->w);
+
+	spdk_poller_unregister(&iter->poller);
+	free_rpc_bdev_get_bdevs_iter(iter);
+}
+
+static int
+rpc_bdev_get_bdevs_poll(void *ctx)
+{
+	struct rpc_bdev_get_bdevs_iter *iter = ctx;
+	int rc;
+
+	rc = spdk_jsonrpc_flush(iter->request);
+	if (rc == -EAGAIN) {
+		/* Wait for the client to receive the data sent so far */
+		return SPDK_POLLER_IDLE;
+	}
+
+	if (rc == 0 && !rpc_bdev_get_bdevs_write(iter, RPC_BDEV_GET_BDEVS_BATCH)) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	/* All the bdevs were written or the rest of the response can't be sent anyway */
+	rpc_bdev_get_bdevs_end(iter);
+
+	return SPDK_POLLER_BUSY;
+}
+
 static void
 rpc_bdev_get_bdevs(struct spdk_jsonrpc_request *request,
 		   const struct spdk_json_val *params)
 {
 	struct rpc_bdev_get_bdevs req = {};
 	struct spdk_bdev_open_async_opts opts = {};
-	struct spdk_json_write_ctx *w;
+	struct rpc_bdev_get_bdevs_iter *iter;
 	int rc;
 
 	if (params && spdk_json_decode_object(params, rpc_bdev_get_bdevs_decoders,
@@ -851,14 +952,34 @@ rpc_bdev_get_bdevs(struct spdk_jsonrpc_request *request,
 
 	free_rpc_bdev_get_bdevs(&req);
 
-	w = spdk_jsonrpc_begin_result(request);
-	spdk_json_write_array_begin(w);
+	iter = calloc(1, sizeof(*iter));
+	if (iter == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		return;
+	}
 
-	spdk_for_each_bdev(w, rpc_dump_bdev_info);
+	rc = spdk_for_each_bdev(iter, rpc_bdev_get_bdevs_collect);
+	if (rc != 0) {
+		free_rpc_bdev_get_bdevs_iter(iter);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
 
-	spdk_json_write_array_end(w);
+	iter->request = request;
+	iter->w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(iter->w);
 
-	spdk_jsonrpc_end_result(request, w);
+	if (rpc_bdev_get_bdevs_write(iter, RPC_BDEV_GET_BDEVS_BATCH)) {
+		rpc_bdev_get_bdevs_end(iter);
+		return;
+	}
+
+	/* Long lists are sent in batches, so that the app thread isn't blocked for too long */
+	iter->poller = SPDK_POLLER_REGISTER(rpc_bdev_get_bdevs_poll, iter, 0);
+	if (iter->poller == NULL) {
+		rpc_bdev_get_bdevs_write(iter, iter->num_names);
+		rpc_bdev_get_bdevs_end(iter);
+	}
 }
 SPDK_RPC_REGISTER("bdev_get_bdevs", rpc_bdev_get_bdevs, SPDK_RPC_RUNTIME)
 
@@ -1012,6 +1133,323 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_set_qos_limit", rpc_bdev_set_qos_limit, SPDK_RPC_RUNTIME)
 
+struct rpc_bdev_qos_group_create {
+	char		*name;
+	uint64_t	limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	uint32_t	burst_ms;
+};
+
+static void
+free_rpc_bdev_qos_group_create(struct rpc_bdev_qos_group_create *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_qos_group_create_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_qos_group_create, name), spdk_json_decode_string},
+	{
+		"rw_ios_per_sec", offsetof(struct rpc_bdev_qos_group_create,
+					   limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"rw_mbytes_per_sec", offsetof(struct rpc_bdev_qos_group_create,
+					      limits[SPDK_BDEV_QOS_RW_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"r_mbytes_per_sec", offsetof(struct rpc_bdev_qos_group_create,
+					     limits[SPDK_BDEV_QOS_R_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"w_mbytes_per_sec", offsetof(struct rpc_bdev_qos_group_create,
+					     limits[SPDK_BDEV_QOS_W_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{"burst_ms", offsetof(struct rpc_bdev_qos_group_create, burst_ms), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_bdev_qos_group_create(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_qos_group_create req = {
+		.limits = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX},
+		.burst_ms = 1,
+	};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_qos_group_create_decoders,
+				    SPDK_COUNTOF(rpc_bdev_qos_group_create_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_qos_group_create(req.name, req.limits, req.burst_ms);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_bdev_qos_group_create(&req);
+}
+SPDK_RPC_REGISTER("bdev_qos_group_create", rpc_bdev_qos_group_create, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_qos_group_delete {
+	char *name;
+};
+
+static void
+free_rpc_bdev_qos_group_delete(struct rpc_bdev_qos_group_delete *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_qos_group_delete_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_qos_group_delete, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_qos_group_delete(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_qos_group_delete req = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_qos_group_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_qos_group_delete_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_qos_group_delete(req.name);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_bdev_qos_group_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_qos_group_delete", rpc_bdev_qos_group_delete, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_qos_group_add_bdev {
+	char		*group_name;
+	char		*name;
+	uint64_t	min_limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+};
+
+static void
+free_rpc_bdev_qos_group_add_bdev(struct rpc_bdev_qos_group_add_bdev *r)
+{
+	free(r->group_name);
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_qos_group_add_bdev_decoders[] = {
+	{"group_name", offsetof(struct rpc_bdev_qos_group_add_bdev, group_name), spdk_json_decode_string},
+	{"name", offsetof(struct rpc_bdev_qos_group_add_bdev, name), spdk_json_decode_string},
+	{
+		"min_rw_ios_per_sec", offsetof(struct rpc_bdev_qos_group_add_bdev,
+					       min_limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"min_rw_mbytes_per_sec", offsetof(struct rpc_bdev_qos_group_add_bdev,
+						  min_limits[SPDK_BDEV_QOS_RW_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"min_r_mbytes_per_sec", offsetof(struct rpc_bdev_qos_group_add_bdev,
+						 min_limits[SPDK_BDEV_QOS_R_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"min_w_mbytes_per_sec", offsetof(struct rpc_bdev_qos_group_add_bdev,
+						 min_limits[SPDK_BDEV_QOS_W_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+};
+
+static void
+rpc_bdev_qos_group_add_bdev(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_qos_group_add_bdev req = {
+		.min_limits = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX},
+	};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_qos_group_add_bdev_decoders,
+				    SPDK_COUNTOF(rpc_bdev_qos_group_add_bdev_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to open bdev '%s': %d\n", req.name, rc);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_qos_group_add_bdev(req.group_name, spdk_bdev_desc_get_bdev(desc), req.min_limits,
+				     rpc_bdev_set_qos_limit_complete, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_qos_group_add_bdev(&req);
+}
+SPDK_RPC_REGISTER("bdev_qos_group_add_bdev", rpc_bdev_qos_group_add_bdev, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_qos_group_remove_bdev {
+	char *name;
+};
+
+static void
+free_rpc_bdev_qos_group_remove_bdev(struct rpc_bdev_qos_group_remove_bdev *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_qos_group_remove_bdev_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_qos_group_remove_bdev, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_qos_group_remove_bdev(struct spdk_jsonrpc_request *request,
+			       const struct spdk_json_val *params)
+{
+	struct rpc_bdev_qos_group_remove_bdev req = {};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_qos_group_remove_bdev_decoders,
+				    SPDK_COUNTOF(rpc_bdev_qos_group_remove_bdev_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to open bdev '%s': %d\n", req.name, rc);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_qos_group_remove_bdev(spdk_bdev_desc_get_bdev(desc),
+					rpc_bdev_set_qos_limit_complete, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_qos_group_remove_bdev(&req);
+}
+SPDK_RPC_REGISTER("bdev_qos_group_remove_bdev", rpc_bdev_qos_group_remove_bdev, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_get_qos_groups(struct spdk_jsonrpc_request *request,
+			const struct spdk_json_val *params)
+{
+	struct spdk_json_write_ctx *w;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "bdev_get_qos_groups requires no parameters");
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	bdev_qos_groups_dump_json(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+SPDK_RPC_REGISTER("bdev_get_qos_groups", rpc_bdev_get_qos_groups, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_set_io_merge {
+	char *name;
+	uint64_t hold_us;
+	uint32_t max_size_kb;
+};
+
+static void
+free_rpc_bdev_set_io_merge(struct rpc_bdev_set_io_merge *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_set_io_merge_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_set_io_merge, name), spdk_json_decode_string},
+	{"hold_us", offsetof(struct rpc_bdev_set_io_merge, hold_us), spdk_json_decode_uint64},
+	{
+		"max_size_kb", offsetof(struct rpc_bdev_set_io_merge, max_size_kb),
+		spdk_json_decode_uint32, true
+	},
+};
+
+static void
+rpc_bdev_set_io_merge_cb(void *cb_arg, int status)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (status == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, status, spdk_strerror(-status));
+	}
+}
+
+static void
+rpc_bdev_set_io_merge(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_set_io_merge req = {};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_set_io_merge_decoders,
+				    SPDK_COUNTOF(rpc_bdev_set_io_merge_decoders), &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_set_io_merge(spdk_bdev_desc_get_bdev(desc), req.hold_us, req.max_size_kb,
+			       rpc_bdev_set_io_merge_cb, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_set_io_merge(&req);
+}
+SPDK_RPC_REGISTER("bdev_set_io_merge", rpc_bdev_set_io_merge, SPDK_RPC_RUNTIME)
+
 /* SPDK_RPC_ENABLE_BDEV_HISTOGRAM */
 
 struct rpc_bdev_enable_histogram_request {
@@ -1180,3 +1618,187 @@ cleanup:
 }
 
 SPDK_RPC_REGISTER("bdev_get_histogram", rpc_bdev_get_histogram, SPDK_RPC_RUNTIME)
+
+/* SPDK_RPC_GET_BDEV_SPLIT_HISTOGRAM */
+
+static const char *const g_rpc_io_type_names[SPDK_BDEV_NUM_IO_TYPES] = {
+	[SPDK_BDEV_IO_TYPE_INVALID] = "invalid",
+	[SPDK_BDEV_IO_TYPE_READ] = "read",
+	[SPDK_BDEV_IO_TYPE_WRITE] = "write",
+	[SPDK_BDEV_IO_TYPE_UNMAP] = "unmap",
+	[SPDK_BDEV_IO_TYPE_FLUSH] = "flush",
+	[SPDK_BDEV_IO_TYPE_RESET] = "reset",
+	[SPDK_BDEV_IO_TYPE_NVME_ADMIN] = "nvme_admin",
+	[SPDK_BDEV_IO_TYPE_NVME_IO] = "nvme_io",
+	[SPDK_BDEV_IO_TYPE_NVME_IO_MD] = "nvme_io_md",
+	[SPDK_BDEV_IO_TYPE_WRITE_ZEROES] = "write_zeroes",
+	[SPDK_BDEV_IO_TYPE_ZCOPY] = "zcopy",
+	[SPDK_BDEV_IO_TYPE_GET_ZONE_INFO] = "get_zone_info",
+	[SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT] = "zone_management",
+	[SPDK_BDEV_IO_TYPE_ZONE_APPEND] = "zone_append",
+	[SPDK_BDEV_IO_TYPE_COMPARE] = "compare",
+	[SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE] = "compare_and_write",
+	[SPDK_BDEV_IO_TYPE_ABORT] = "abort",
+	[SPDK_BDEV_IO_TYPE_SEEK_HOLE] = "seek_hole",
+	[SPDK_BDEV_IO_TYPE_SEEK_DATA] = "seek_data",
+	[SPDK_BDEV_IO_TYPE_COPY] = "copy",
+};
+
+static const char *const g_rpc_histogram_size_class_names[] = {
+	[SPDK_BDEV_HISTOGRAM_SIZE_4K] = "4k",
+	[SPDK_BDEV_HISTOGRAM_SIZE_16K] = "16k",
+	[SPDK_BDEV_HISTOGRAM_SIZE_128K] = "128k",
+	[SPDK_BDEV_HISTOGRAM_SIZE_LARGE] = "large",
+};
+SPDK_STATIC_ASSERT(SPDK_COUNTOF(g_rpc_histogram_size_class_names) ==
+		   SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES, "Incorrect size");
+
+struct rpc_bdev_split_histogram_ctx {
+	struct spdk_jsonrpc_request *request;
+	struct spdk_histogram_data *histograms[SPDK_BDEV_HISTOGRAM_NUM_SPLIT];
+};
+
+static void
+rpc_bdev_split_histogram_done(void *cb_arg, int status)
+{
+	struct rpc_bdev_split_histogram_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+	struct spdk_histogram_data *histogram;
+	char *encoded_histogram;
+	size_t src_len;
+	int i, io_type, size_class;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-status));
+		goto cleanup;
+	}
+
+	/* All histograms have the same number of buckets, so a single buffer fits any of them */
+	histogram = spdk_histogram_data_alloc();
+	if (histogram == NULL) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	encoded_histogram = malloc(spdk_base64_get_encoded_strlen(src_len) + 1);
+	if (encoded_histogram == NULL) {
+		spdk_histogram_data_free(histogram);
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(ctx->request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+	spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+	spdk_json_write_named_array_begin(w, "histograms");
+	for (i = 0; i < SPDK_BDEV_HISTOGRAM_NUM_SPLIT; i++) {
+		if (ctx->histograms[i] == NULL) {
+			continue;
+		}
+
+		spdk_base64_encode(encoded_histogram, ctx->histograms[i]->bucket, src_len);
+		spdk_json_write_object_begin(w);
+		io_type = i / SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES;
+		size_class = i % SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES;
+		spdk_json_write_named_string(w, "io_type", g_rpc_io_type_names[io_type]);
+		spdk_json_write_named_string(w, "size_class",
+					     g_rpc_histogram_size_class_names[size_class]);
+		spdk_json_write_named_string(w, "histogram", encoded_histogram);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(ctx->request, w);
+
+	free(encoded_histogram);
+	spdk_histogram_data_free(histogram);
+cleanup:
+	for (i = 0; i < SPDK_BDEV_HISTOGRAM_NUM_SPLIT; i++) {
+		spdk_histogram_data_free(ctx->histograms[i]);
+	}
+	free(ctx);
+}
+
+static void
+rpc_bdev_get_split_histogram(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_get_histogram_request req = {NULL};
+	struct rpc_bdev_split_histogram_ctx *ctx;
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_get_histogram_request_decoders,
+				    SPDK_COUNTOF(rpc_bdev_get_histogram_request_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_bdev_close(desc);
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	ctx->request = request;
+	spdk_bdev_histogram_get_split(spdk_bdev_desc_get_bdev(desc), ctx->histograms,
+				      rpc_bdev_split_histogram_done, ctx);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_get_histogram_request(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_get_split_histogram", rpc_bdev_get_split_histogram, SPDK_RPC_RUNTIME)
+
+/* SPDK_RPC_RESET_BDEV_HISTOGRAM */
+
+static void
+rpc_bdev_reset_histogram(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_get_histogram_request req = {NULL};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_get_histogram_request_decoders,
+				    SPDK_COUNTOF(rpc_bdev_get_histogram_request_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_histogram_reset(spdk_bdev_desc_get_bdev(desc), bdev_histogram_status_cb,
+				  request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_get_histogram_request(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_reset_histogram", rpc_bdev_reset_histogram, SPDK_RPC_RUNTIME)
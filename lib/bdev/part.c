@@ -302,6 +302,17 @@ spdk_bdev_part_submit_request_ext(struct spdk_bdev_part_channel *ch, struct spdk
 	uint64_t offset, remapped_offset, remapped_src_offset;
 	int rc = 0;
 
+	/* Without a user callback, there's nothing to be done on completion, so try to pass the
+	 * I/O straight to the base bdev instead of allocating a child I/O for it.
+	 */
+	if (cb == NULL) {
+		rc = spdk_bdev_io_forward_blocks(base_desc, base_ch, bdev_io,
+						 part->internal.offset_blocks);
+		if (rc == 0) {
+			return 0;
+		}
+	}
+
 	bdev_io->u.bdev.stored_user_cb = cb;
 
 	offset = bdev_io->u.bdev.offset_blocks;
@@ -30,6 +30,9 @@ static void blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
 static void blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 		uint64_t cluster, uint32_t extent, struct spdk_blob_md_page *page,
 		spdk_blob_op_complete cb_fn, void *cb_arg);
+static void blob_free_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
+		uint64_t cluster, struct spdk_blob_md_page *page,
+		spdk_blob_op_complete cb_fn, void *cb_arg);
 
 static int blob_set_xattr(struct spdk_blob *blob, const char *name, const void *value,
 			  uint16_t value_len, bool internal);
@@ -74,6 +77,14 @@ blob_id_cmp(struct spdk_blob *blob1, struct spdk_blob *blob2)
 
 RB_GENERATE_STATIC(spdk_blob_tree, spdk_blob, link, blob_id_cmp);
 
+static int
+blob_list_id_cmp(struct spdk_blob_list *entry1, struct spdk_blob_list *entry2)
+{
+	return (entry1->id < entry2->id ? -1 : entry1->id > entry2->id);
+}
+
+RB_GENERATE_STATIC(spdk_blob_list_tree, spdk_blob_list, node, blob_list_id_cmp);
+
 static void
 blob_verify_md_op(struct spdk_blob *blob)
 {
@@ -85,15 +96,19 @@ blob_verify_md_op(struct spdk_blob *blob)
 static struct spdk_blob_list *
 bs_get_snapshot_entry(struct spdk_blob_store *bs, spdk_blob_id blobid)
 {
-	struct spdk_blob_list *snapshot_entry = NULL;
+	struct spdk_blob_list find = {};
 
-	TAILQ_FOREACH(snapshot_entry, &bs->snapshots, link) {
-		if (snapshot_entry->id == blobid) {
-			break;
-		}
-	}
+	find.id = blobid;
+	return RB_FIND(spdk_blob_list_tree, &bs->snapshots, &find);
+}
 
-	return snapshot_entry;
+static struct spdk_blob_list *
+bs_get_clone_entry(struct spdk_blob_store *bs, spdk_blob_id blobid)
+{
+	struct spdk_blob_list find = {};
+
+	find.id = blobid;
+	return RB_FIND(spdk_blob_list_tree, &bs->clones, &find);
 }
 
 static void
@@ -148,6 +163,49 @@ bs_release_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
 	bs->num_free_clusters++;
 }
 
+/* Claim a batch of consecutive free clusters for the channel */
+static void
+bs_channel_reserve_clusters(struct spdk_bs_channel *ch)
+{
+	struct spdk_blob_store *bs = ch->bs;
+	uint64_t count;
+	uint32_t cluster_num;
+
+	assert(ch->reserved_head == ch->reserved_count);
+
+	ch->reserved_head = 0;
+	ch->reserved_count = 0;
+
+	spdk_spin_lock(&bs->used_lock);
+	/* Don't let reservations hold on to the last free clusters */
+	count = spdk_min(BS_CHANNEL_RESERVED_CLUSTERS,
+			 bs->num_free_clusters / BS_CHANNEL_RESERVATION_RATIO);
+	while (ch->reserved_count < count) {
+		cluster_num = bs_claim_cluster(bs);
+		if (cluster_num == UINT32_MAX) {
+			break;
+		}
+		ch->reserved_clusters[ch->reserved_count++] = cluster_num;
+	}
+	__atomic_fetch_add(&bs->num_reserved_clusters, ch->reserved_count, __ATOMIC_RELAXED);
+	spdk_spin_unlock(&bs->used_lock);
+}
+
+/* Return the clusters the channel didn't use */
+static void
+bs_channel_release_clusters(struct spdk_bs_channel *ch)
+{
+	struct spdk_blob_store *bs = ch->bs;
+
+	assert(spdk_spin_held(&bs->used_lock));
+
+	__atomic_fetch_sub(&bs->num_reserved_clusters, ch->reserved_count - ch->reserved_head,
+			   __ATOMIC_RELAXED);
+	while (ch->reserved_head < ch->reserved_count) {
+		bs_release_cluster(bs, ch->reserved_clusters[ch->reserved_head++]);
+	}
+}
+
 static int
 blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster)
 {
@@ -163,6 +221,21 @@ blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t clust
 	return 0;
 }
 
+static int
+blob_free_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster)
+{
+	blob_verify_md_op(blob);
+
+	if (cluster_num >= blob->active.num_clusters ||
+	    blob->active.clusters[cluster_num] != bs_cluster_to_lba(blob->bs, cluster) ||
+	    blob->parent_id != SPDK_BLOBID_INVALID) {
+		return -ENOENT;
+	}
+
+	blob->active.clusters[cluster_num] = 0;
+	return 0;
+}
+
 static int
 bs_allocate_cluster(struct spdk_blob *blob, uint32_t cluster_num,
 		    uint64_t *cluster, uint32_t *lowest_free_md_page, bool update_map)
@@ -767,6 +840,7 @@ blob_parse_page(const struct spdk_blob_md_page *page, struct spdk_blob *blob)
 			unsigned int					i;
 			unsigned int					cluster_count = 0;
 			size_t						cluster_idx_length;
+			uint64_t					start, end;
 
 			if (blob->extent_rle_found) {
 				/* This means that Extent RLE is present in MD,
@@ -795,34 +869,26 @@ blob_parse_page(const struct spdk_blob_md_page *page, struct spdk_blob *blob)
 				return -EINVAL;
 			}
 
-			/* When reading extent pages sequentially starting cluster idx should match
-			 * current size of a blob.
-			 * If changed to batch reading, this check shall be removed. */
-			if (desc_extent->start_cluster_idx != blob->active.num_clusters) {
+			/* Extent pages are read in batches and can be parsed in any order.  The
+			 * cluster array is already sized for the whole blob, so each extent page has
+			 * to cover exactly the clusters of its position in the extent table. */
+			start = desc_extent->start_cluster_idx;
+			end = spdk_min(start + SPDK_EXTENTS_PER_EP, blob->active.num_clusters);
+			if (start % SPDK_EXTENTS_PER_EP != 0 || start >= end ||
+			    cluster_count != end - start) {
 				return -EINVAL;
 			}
 
-			tmp = realloc(blob->active.clusters,
-				      (cluster_count + blob->active.num_clusters) * sizeof(*blob->active.clusters));
-			if (tmp == NULL) {
-				return -ENOMEM;
-			}
-			blob->active.clusters = tmp;
-			blob->active.cluster_array_size = (cluster_count + blob->active.num_clusters);
-
-			for (i = 0; i < cluster_idx_length / sizeof(desc_extent->cluster_idx[0]); i++) {
-				if (desc_extent->cluster_idx[i] != 0) {
-					blob->active.clusters[blob->active.num_clusters++] = bs_cluster_to_lba(blob->bs,
-							desc_extent->cluster_idx[i]);
-				} else if (spdk_blob_is_thin_provisioned(blob)) {
-					blob->active.clusters[blob->active.num_clusters++] = 0;
-				} else {
-					return -EINVAL;
+			for (i = 0; i < cluster_count; i++) {
+				if (desc_extent->cluster_idx[i] == 0) {
+					if (!spdk_blob_is_thin_provisioned(blob)) {
+						return -EINVAL;
+					}
+					continue;
 				}
+				blob->active.clusters[start + i] = bs_cluster_to_lba(blob->bs,
+								   desc_extent->cluster_idx[i]);
 			}
-			assert(desc_extent->start_cluster_idx + cluster_count == blob->active.num_clusters);
-			assert(blob->remaining_clusters_in_et >= cluster_count);
-			blob->remaining_clusters_in_et -= cluster_count;
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR) {
 			int rc;
 
@@ -1340,6 +1406,9 @@ blob_serialize(const struct spdk_blob *blob, struct spdk_blob_md_page **pages,
 	return rc;
 }
 
+/* Maximum number of extent pages read at once when loading a blob */
+#define BLOB_LOAD_EXTENT_PAGES_BATCH	32
+
 struct spdk_blob_load_ctx {
 	struct spdk_blob		*blob;
 
@@ -1494,17 +1563,16 @@ blob_load_backing_dev(spdk_bs_sequence_t *seq, void *cb_arg)
 	blob_load_final(ctx, 0);
 }
 
+static void blob_load_extent_pages(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx);
+
 static void
-blob_load_cpl_extents_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+blob_load_extent_pages_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_load_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
 	struct spdk_blob_md_page	*page;
-	uint64_t			i;
+	uint32_t			i;
 	uint32_t			crc;
-	uint64_t			lba;
-	void				*tmp;
-	uint64_t			sz;
 
 	if (bserrno) {
 		SPDK_ERRLOG("Extent page read failed: %d\n", bserrno);
@@ -1512,18 +1580,8 @@ blob_load_cpl_extents_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		return;
 	}
 
-	if (ctx->pages == NULL) {
-		/* First iteration of this function, allocate buffer for single EXTENT_PAGE */
-		ctx->pages = spdk_zmalloc(SPDK_BS_PAGE_SIZE, 0,
-					  NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-		if (!ctx->pages) {
-			blob_load_final(ctx, -ENOMEM);
-			return;
-		}
-		ctx->num_pages = 1;
-		ctx->next_extent_page = 0;
-	} else {
-		page = &ctx->pages[0];
+	for (i = 0; i < ctx->num_pages; i++) {
+		page = &ctx->pages[i];
 		crc = blob_md_page_calc_crc(page);
 		if (crc != page->crc) {
 			blob_load_final(ctx, -EINVAL);
@@ -1542,42 +1600,81 @@ blob_load_cpl_extents_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		}
 	}
 
-	for (i = ctx->next_extent_page; i < blob->active.num_extent_pages; i++) {
-		if (blob->active.extent_pages[i] != 0) {
-			/* Extent page was allocated, read and parse it. */
-			lba = bs_md_page_to_lba(blob->bs, blob->active.extent_pages[i]);
-			ctx->next_extent_page = i + 1;
-
-			bs_sequence_read_dev(seq, &ctx->pages[0], lba,
-					     bs_byte_to_lba(blob->bs, SPDK_BS_PAGE_SIZE),
-					     blob_load_cpl_extents_cpl, ctx);
-			return;
-		} else {
-			/* Thin provisioned blobs can point to unallocated extent pages.
-			 * In this case blob size should be increased by up to the amount left in remaining_clusters_in_et. */
+	blob_load_extent_pages(seq, ctx);
+}
 
-			sz = spdk_min(blob->remaining_clusters_in_et, SPDK_EXTENTS_PER_EP);
-			blob->active.num_clusters += sz;
-			blob->remaining_clusters_in_et -= sz;
+/* Read the next batch of allocated extent pages.  Clusters of the unallocated ones are left
+ * zeroed in the cluster array, which is already sized for the whole blob. */
+static void
+blob_load_extent_pages(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx)
+{
+	struct spdk_blob	*blob = ctx->blob;
+	spdk_bs_batch_t		*batch = NULL;
+	uint64_t		lba;
+	uint32_t		i;
 
+	ctx->num_pages = 0;
+	for (i = ctx->next_extent_page; i < blob->active.num_extent_pages; i++) {
+		if (ctx->num_pages == BLOB_LOAD_EXTENT_PAGES_BATCH) {
+			break;
+		}
+		if (blob->active.extent_pages[i] == 0) {
 			assert(spdk_blob_is_thin_provisioned(blob));
-			assert(i + 1 < blob->active.num_extent_pages || blob->remaining_clusters_in_et == 0);
+			continue;
+		}
 
-			tmp = realloc(blob->active.clusters, blob->active.num_clusters * sizeof(*blob->active.clusters));
-			if (tmp == NULL) {
-				blob_load_final(ctx, -ENOMEM);
-				return;
-			}
-			memset(tmp + sizeof(*blob->active.clusters) * blob->active.cluster_array_size, 0,
-			       sizeof(*blob->active.clusters) * (blob->active.num_clusters - blob->active.cluster_array_size));
-			blob->active.clusters = tmp;
-			blob->active.cluster_array_size = blob->active.num_clusters;
+		if (batch == NULL) {
+			batch = bs_sequence_to_batch(seq, blob_load_extent_pages_cpl, ctx);
 		}
+		lba = bs_md_page_to_lba(blob->bs, blob->active.extent_pages[i]);
+		bs_batch_read_dev(batch, &ctx->pages[ctx->num_pages++], lba,
+				  bs_byte_to_lba(blob->bs, SPDK_BS_PAGE_SIZE));
+	}
+	ctx->next_extent_page = i;
+
+	if (batch != NULL) {
+		bs_batch_close(batch);
+		return;
 	}
 
 	blob_load_backing_dev(seq, ctx);
 }
 
+static void
+blob_load_extents(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx)
+{
+	struct spdk_blob	*blob = ctx->blob;
+	uint64_t		num_clusters = blob->remaining_clusters_in_et;
+	uint64_t		num_extent_pages;
+
+	num_extent_pages = spdk_divide_round_up(num_clusters, SPDK_EXTENTS_PER_EP);
+	if (blob->active.num_extent_pages != num_extent_pages) {
+		blob_load_final(ctx, -EINVAL);
+		return;
+	}
+
+	/* Size the cluster array once, instead of growing it with each extent page */
+	if (num_clusters > 0) {
+		blob->active.clusters = calloc(num_clusters, sizeof(*blob->active.clusters));
+		if (blob->active.clusters == NULL) {
+			blob_load_final(ctx, -ENOMEM);
+			return;
+		}
+	}
+	blob->active.num_clusters = num_clusters;
+	blob->active.cluster_array_size = num_clusters;
+
+	ctx->pages = spdk_zmalloc(SPDK_BS_PAGE_SIZE * BLOB_LOAD_EXTENT_PAGES_BATCH, 0,
+				  NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->pages) {
+		blob_load_final(ctx, -ENOMEM);
+		return;
+	}
+	ctx->next_extent_page = 0;
+
+	blob_load_extent_pages(seq, ctx);
+}
+
 static void
 blob_load_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
@@ -1661,7 +1758,7 @@ blob_load_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	ctx->pages = NULL;
 
 	if (blob->extent_table_found) {
-		blob_load_cpl_extents_cpl(seq, ctx, 0);
+		blob_load_extents(seq, ctx);
 	} else {
 		blob_load_backing_dev(seq, ctx);
 	}
@@ -2518,7 +2615,6 @@ blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
 		}
 	}
 
-	spdk_free(ctx->buf);
 	free(ctx);
 }
 
@@ -2603,6 +2699,69 @@ blob_copy(struct spdk_blob_copy_cluster_ctx *ctx, spdk_bs_user_op_t *op, uint64_
 			     blob_write_copy_cpl, ctx);
 }
 
+/* Allocate a cluster for a write on the channel, using the clusters it reserved if possible */
+static int
+bs_channel_allocate_cluster(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+			    uint32_t cluster_num, uint64_t *cluster, uint32_t *extent_page)
+{
+	struct spdk_blob_store *bs = blob->bs;
+	int rc;
+
+	/* Extent pages aren't reserved, so if one is needed, it has to be claimed under the lock */
+	if (!blob->use_extent_table || *bs_cluster_to_extent_page(blob, cluster_num) != 0) {
+		if (ch->reserved_head == ch->reserved_count) {
+			bs_channel_reserve_clusters(ch);
+		}
+		if (ch->reserved_head < ch->reserved_count) {
+			*cluster = ch->reserved_clusters[ch->reserved_head++];
+			__atomic_fetch_sub(&bs->num_reserved_clusters, 1, __ATOMIC_RELAXED);
+			SPDK_DEBUGLOG(blob, "Claiming reserved cluster %" PRIu64 " for blob 0x%"
+				      PRIx64 "\n", *cluster, blob->id);
+			return 0;
+		}
+	}
+
+	spdk_spin_lock(&bs->used_lock);
+	rc = bs_allocate_cluster(blob, cluster_num, cluster, extent_page, false);
+	spdk_spin_unlock(&bs->used_lock);
+
+	return rc;
+}
+
+/* Check if the user op overwrites the whole cluster, in which case its previous contents don't
+ * need to be copied. */
+static bool
+bs_user_op_overwrites_cluster(struct spdk_blob *blob, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_user_op_args *args = &op->u.user_op;
+	uint64_t io_units_per_cluster = bs_io_units_per_cluster(blob);
+
+	if (args->type != SPDK_BLOB_WRITE && args->type != SPDK_BLOB_WRITEV) {
+		return false;
+	}
+
+	return args->offset % io_units_per_cluster == 0 && args->length == io_units_per_cluster;
+}
+
+static void *
+bs_channel_get_cow_buf(struct spdk_bs_channel *ch, struct spdk_blob *blob)
+{
+	uint32_t align = blob->back_bs_dev->blocklen;
+
+	/* Esnap devices may have a larger block size than the buffer was aligned to */
+	if (ch->cow_buf != NULL && (uintptr_t)ch->cow_buf % align != 0) {
+		spdk_free(ch->cow_buf);
+		ch->cow_buf = NULL;
+	}
+
+	if (ch->cow_buf == NULL) {
+		ch->cow_buf = spdk_malloc(blob->bs->cluster_sz, align, NULL,
+					  SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	}
+
+	return ch->cow_buf;
+}
+
 static void
 bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 			     struct spdk_io_channel *_ch,
@@ -2615,6 +2774,7 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	uint32_t cluster_number;
 	bool is_zeroes;
 	bool can_copy;
+	bool need_copy;
 	uint64_t copy_src_lba;
 	int rc;
 
@@ -2652,9 +2812,10 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	is_zeroes = blob->back_bs_dev->is_zeroes(blob->back_bs_dev,
 			bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
 			bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz));
-	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes && !can_copy) {
-		ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->back_bs_dev->blocklen,
-				       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	need_copy = blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes &&
+		    !bs_user_op_overwrites_cluster(blob, op);
+	if (need_copy && !can_copy) {
+		ctx->buf = bs_channel_get_cow_buf(ch, blob);
 		if (!ctx->buf) {
 			SPDK_ERRLOG("DMA allocation for cluster of size = %" PRIu32 " failed.\n",
 				    blob->bs->cluster_sz);
@@ -2664,12 +2825,9 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 		}
 	}
 
-	spdk_spin_lock(&blob->bs->used_lock);
-	rc = bs_allocate_cluster(blob, cluster_number, &ctx->new_cluster, &ctx->new_extent_page,
-				 false);
-	spdk_spin_unlock(&blob->bs->used_lock);
+	rc = bs_channel_allocate_cluster(ch, blob, cluster_number, &ctx->new_cluster,
+					 &ctx->new_extent_page);
 	if (rc != 0) {
-		spdk_free(ctx->buf);
 		free(ctx);
 		bs_user_op_abort(op, rc);
 		return;
@@ -2684,7 +2842,6 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 		spdk_spin_lock(&blob->bs->used_lock);
 		bs_release_cluster(blob->bs, ctx->new_cluster);
 		spdk_spin_unlock(&blob->bs->used_lock);
-		spdk_free(ctx->buf);
 		free(ctx);
 		bs_user_op_abort(op, -ENOMEM);
 		return;
@@ -2693,7 +2850,7 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	/* Queue the user op to block other incoming operations */
 	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
 
-	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes) {
+	if (need_copy) {
 		if (can_copy) {
 			blob_copy(ctx, op, copy_src_lba);
 		} else {
@@ -2884,6 +3041,98 @@ blob_request_submit_op_split(struct spdk_io_channel *ch, struct spdk_blob *blob,
 	blob_request_submit_op_split_next(ctx, 0);
 }
 
+/* Clusters of thin provisioned blobs are released once they're unmapped as a whole, unless
+ * reading them would then fall through to a snapshot instead of returning zeroes. */
+static bool
+blob_unmap_can_free_cluster(struct spdk_blob *blob, uint64_t offset, uint64_t length)
+{
+	uint64_t io_units_per_cluster = bs_io_units_per_cluster(blob);
+
+	if (!spdk_blob_is_thin_provisioned(blob) || blob->parent_id != SPDK_BLOBID_INVALID) {
+		return false;
+	}
+
+	return offset % io_units_per_cluster == 0 && length == io_units_per_cluster;
+}
+
+struct blob_unmap_cluster_ctx {
+	struct spdk_blob		*blob;
+	uint32_t			cluster_num;
+	uint64_t			cluster;
+	struct spdk_blob_md_page	*page;
+	spdk_blob_op_complete		cb_fn;
+	void				*cb_arg;
+};
+
+static void
+blob_unmap_free_cluster_cpl(void *cb_arg, int bserrno)
+{
+	struct blob_unmap_cluster_ctx *ctx = cb_arg;
+
+	ctx->cb_fn(ctx->cb_arg, bserrno);
+	spdk_free(ctx->page);
+	free(ctx);
+}
+
+static void
+blob_unmap_cluster_cpl(void *cb_arg, int bserrno)
+{
+	struct blob_unmap_cluster_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		blob_unmap_free_cluster_cpl(ctx, bserrno);
+		return;
+	}
+
+	blob_free_cluster_on_md_thread(ctx->blob, ctx->cluster_num, ctx->cluster, ctx->page,
+				       blob_unmap_free_cluster_cpl, ctx);
+}
+
+static void
+blob_unmap_free_cluster(struct spdk_io_channel *_ch, struct spdk_blob *blob, uint64_t offset,
+			uint64_t lba, uint64_t lba_count, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct blob_unmap_cluster_ctx *ctx;
+	struct spdk_bs_cpl cpl;
+	spdk_bs_batch_t *batch;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->blob = blob;
+	ctx->cluster_num = bs_io_unit_to_cluster_number(blob, offset);
+	ctx->cluster = bs_lba_to_cluster(blob->bs, lba);
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	if (blob->use_extent_table) {
+		/* Buffer for the update of the extent page */
+		ctx->page = spdk_zmalloc(SPDK_BS_PAGE_SIZE, 0, NULL, SPDK_ENV_SOCKET_ID_ANY,
+					 SPDK_MALLOC_DMA);
+		if (ctx->page == NULL) {
+			free(ctx);
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+	}
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = blob_unmap_cluster_cpl;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	batch = bs_batch_open(_ch, &cpl, blob);
+	if (!batch) {
+		blob_unmap_free_cluster_cpl(ctx, -ENOMEM);
+		return;
+	}
+
+	bs_batch_unmap_dev(batch, lba, lba_count);
+	bs_batch_close(batch);
+}
+
 static void
 blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blob,
 			      void *payload, uint64_t offset, uint64_t length,
@@ -2980,6 +3229,11 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 	case SPDK_BLOB_UNMAP: {
 		spdk_bs_batch_t *batch;
 
+		if (is_allocated && blob_unmap_can_free_cluster(blob, offset, length)) {
+			blob_unmap_free_cluster(_ch, blob, offset, lba, lba_count, cb_fn, cb_arg);
+			return;
+		}
+
 		batch = bs_batch_open(_ch, &cpl, blob);
 		if (!batch) {
 			cb_fn(cb_arg, -ENOMEM);
@@ -3287,20 +3541,11 @@ blob_get_snapshot_and_clone_entries(struct spdk_blob *blob,
 		return;
 	}
 
-	TAILQ_FOREACH(*snapshot_entry, &blob->bs->snapshots, link) {
-		if ((*snapshot_entry)->id == blob->parent_id) {
-			break;
-		}
-	}
-
+	*snapshot_entry = bs_get_snapshot_entry(blob->bs, blob->parent_id);
 	if (*snapshot_entry != NULL) {
-		TAILQ_FOREACH(*clone_entry, &(*snapshot_entry)->clones, link) {
-			if ((*clone_entry)->id == blob->id) {
-				break;
-			}
-		}
-
+		*clone_entry = bs_get_clone_entry(blob->bs, blob->id);
 		assert(*clone_entry != NULL);
+		assert((*clone_entry)->parent == *snapshot_entry);
 	}
 }
 
@@ -3349,6 +3594,10 @@ bs_channel_create(void *io_device, void *ctx_buf)
 	TAILQ_INIT(&channel->queued_io);
 	RB_INIT(&channel->esnap_channels);
 
+	spdk_spin_lock(&bs->used_lock);
+	TAILQ_INSERT_TAIL(&bs->channels, channel, link);
+	spdk_spin_unlock(&bs->used_lock);
+
 	return 0;
 }
 
@@ -3372,8 +3621,14 @@ bs_channel_destroy(void *io_device, void *ctx_buf)
 
 	blob_esnap_destroy_bs_channel(channel);
 
+	spdk_spin_lock(&channel->bs->used_lock);
+	bs_channel_release_clusters(channel);
+	TAILQ_REMOVE(&channel->bs->channels, channel, link);
+	spdk_spin_unlock(&channel->bs->used_lock);
+
 	free(channel->req_mem);
 	spdk_free(channel->new_cluster_page);
+	spdk_free(channel->cow_buf);
 	channel->dev->destroy_channel(channel->dev, channel->dev_channel);
 }
 
@@ -3430,13 +3685,18 @@ bs_blob_list_add(struct spdk_blob *blob)
 		}
 		snapshot_entry->id = snapshot_id;
 		TAILQ_INIT(&snapshot_entry->clones);
-		TAILQ_INSERT_TAIL(&blob->bs->snapshots, snapshot_entry, link);
+		RB_INSERT(spdk_blob_list_tree, &blob->bs->snapshots, snapshot_entry);
 	} else {
-		TAILQ_FOREACH(clone_entry, &snapshot_entry->clones, link) {
-			if (clone_entry->id == blob->id) {
-				break;
-			}
-		}
+		clone_entry = bs_get_clone_entry(blob->bs, blob->id);
+	}
+
+	if (clone_entry != NULL && clone_entry->parent != snapshot_entry) {
+		/* The clone was moved to a different snapshot */
+		TAILQ_REMOVE(&clone_entry->parent->clones, clone_entry, link);
+		clone_entry->parent->clone_count--;
+		TAILQ_INSERT_TAIL(&snapshot_entry->clones, clone_entry, link);
+		clone_entry->parent = snapshot_entry;
+		snapshot_entry->clone_count++;
 	}
 
 	if (clone_entry == NULL) {
@@ -3446,8 +3706,10 @@ bs_blob_list_add(struct spdk_blob *blob)
 			return -ENOMEM;
 		}
 		clone_entry->id = blob->id;
+		clone_entry->parent = snapshot_entry;
 		TAILQ_INIT(&clone_entry->clones);
 		TAILQ_INSERT_TAIL(&snapshot_entry->clones, clone_entry, link);
+		RB_INSERT(spdk_blob_list_tree, &blob->bs->clones, clone_entry);
 		snapshot_entry->clone_count++;
 	}
 
@@ -3468,6 +3730,7 @@ bs_blob_list_remove(struct spdk_blob *blob)
 
 	blob->parent_id = SPDK_BLOBID_INVALID;
 	TAILQ_REMOVE(&snapshot_entry->clones, clone_entry, link);
+	RB_REMOVE(spdk_blob_list_tree, &blob->bs->clones, clone_entry);
 	free(clone_entry);
 
 	snapshot_entry->clone_count--;
@@ -3481,12 +3744,13 @@ bs_blob_list_free(struct spdk_blob_store *bs)
 	struct spdk_blob_list *clone_entry;
 	struct spdk_blob_list *clone_entry_tmp;
 
-	TAILQ_FOREACH_SAFE(snapshot_entry, &bs->snapshots, link, snapshot_entry_tmp) {
+	RB_FOREACH_SAFE(snapshot_entry, spdk_blob_list_tree, &bs->snapshots, snapshot_entry_tmp) {
 		TAILQ_FOREACH_SAFE(clone_entry, &snapshot_entry->clones, link, clone_entry_tmp) {
 			TAILQ_REMOVE(&snapshot_entry->clones, clone_entry, link);
+			RB_REMOVE(spdk_blob_list_tree, &bs->clones, clone_entry);
 			free(clone_entry);
 		}
-		TAILQ_REMOVE(&bs->snapshots, snapshot_entry, link);
+		RB_REMOVE(spdk_blob_list_tree, &bs->snapshots, snapshot_entry);
 		free(snapshot_entry);
 	}
 
@@ -3498,6 +3762,8 @@ bs_free(struct spdk_blob_store *bs)
 {
 	bs_blob_list_free(bs);
 
+	assert(TAILQ_EMPTY(&bs->md_commit_pending));
+	spdk_poller_unregister(&bs->md_commit_poller);
 	bs_unregister_md_thread(bs);
 	spdk_io_device_unregister(bs, bs_dev_destroy);
 }
@@ -3542,6 +3808,8 @@ spdk_bs_opts_init(struct spdk_bs_opts *opts, size_t opts_size)
 	SET_FIELD(force_recover, false);
 	SET_FIELD(esnap_bs_dev_create, NULL);
 	SET_FIELD(esnap_ctx, NULL);
+	SET_FIELD(md_commit_window_us, 0);
+	SET_FIELD(md_commit_max_pending, 0);
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -3640,7 +3908,8 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	}
 
 	RB_INIT(&bs->open_blobs);
-	TAILQ_INIT(&bs->snapshots);
+	RB_INIT(&bs->snapshots);
+	RB_INIT(&bs->clones);
 	bs->dev = dev;
 	bs->md_thread = spdk_get_thread();
 	assert(bs->md_thread != NULL);
@@ -3671,6 +3940,9 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	memcpy(&bs->bstype, &opts->bstype, sizeof(opts->bstype));
 	bs->esnap_bs_dev_create = opts->esnap_bs_dev_create;
 	bs->esnap_ctx = opts->esnap_ctx;
+	bs->md_commit_window_us = opts->md_commit_window_us;
+	bs->md_commit_max_pending = opts->md_commit_max_pending;
+	TAILQ_INIT(&bs->md_commit_pending);
 
 	/* The metadata is assumed to be at least 1 page */
 	bs->used_md_pages = spdk_bit_array_create(1);
@@ -3678,6 +3950,7 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	bs->open_blobids = spdk_bit_array_create(0);
 
 	spdk_spin_init(&bs->used_lock);
+	TAILQ_INIT(&bs->channels);
 
 	spdk_io_device_register(bs, bs_channel_create, bs_channel_destroy,
 				sizeof(struct spdk_bs_channel), "blobstore");
@@ -3730,7 +4003,9 @@ static void
 bs_write_used_clusters(spdk_bs_sequence_t *seq, void *arg, spdk_bs_sequence_cpl cb_fn)
 {
 	struct spdk_bs_load_ctx	*ctx = arg;
+	struct spdk_bs_channel	*ch;
 	uint64_t	mask_size, lba, lba_count;
+	uint32_t	i, cluster_num;
 
 	/* Write out the used clusters mask */
 	mask_size = ctx->super->used_cluster_mask_len * SPDK_BS_PAGE_SIZE;
@@ -3750,7 +4025,17 @@ bs_write_used_clusters(spdk_bs_sequence_t *seq, void *arg, spdk_bs_sequence_cpl
 	 */
 	if (ctx->bs->used_clusters) {
 		assert(ctx->mask->length == spdk_bit_pool_capacity(ctx->bs->used_clusters));
+		spdk_spin_lock(&ctx->bs->used_lock);
 		spdk_bit_pool_store_mask(ctx->bs->used_clusters, ctx->mask->mask);
+		/* Clusters reserved by channels aren't used by any blob.  With all blobs closed,
+		 * channels can't consume them anymore. */
+		TAILQ_FOREACH(ch, &ctx->bs->channels, link) {
+			for (i = ch->reserved_head; i < ch->reserved_count; i++) {
+				cluster_num = ch->reserved_clusters[i];
+				ctx->mask->mask[cluster_num / 8] &= ~(1U << (cluster_num % 8));
+			}
+		}
+		spdk_spin_unlock(&ctx->bs->used_lock);
 	} else {
 		assert(ctx->mask->length == spdk_bit_array_capacity(ctx->used_clusters));
 		spdk_bit_array_store_mask(ctx->used_clusters, ctx->mask->mask);
@@ -4427,7 +4712,6 @@ static void
 bs_load_replay_md_chain_cpl(struct spdk_bs_load_ctx *ctx)
 {
 	uint64_t num_md_clusters;
-	uint64_t i;
 
 	ctx->in_page_chain = false;
 
@@ -4442,9 +4726,7 @@ bs_load_replay_md_chain_cpl(struct spdk_bs_load_ctx *ctx)
 		/* Claim all of the clusters used by the metadata */
 		num_md_clusters = spdk_divide_round_up(
 					  ctx->super->md_start + ctx->super->md_len, ctx->bs->pages_per_cluster);
-		for (i = 0; i < num_md_clusters; i++) {
-			spdk_bit_array_set(ctx->used_clusters, i);
-		}
+		spdk_bit_array_set_range(ctx->used_clusters, 0, num_md_clusters);
 		ctx->bs->num_free_clusters -= num_md_clusters;
 		spdk_free(ctx->page);
 		bs_load_write_used_md(ctx);
@@ -4749,12 +5031,14 @@ bs_opts_copy(struct spdk_bs_opts *src, struct spdk_bs_opts *dst)
 	SET_FIELD(force_recover);
 	SET_FIELD(esnap_bs_dev_create);
 	SET_FIELD(esnap_ctx);
+	SET_FIELD(md_commit_window_us);
+	SET_FIELD(md_commit_max_pending);
 
 	dst->opts_size = src->opts_size;
 
 	/* You should not remove this statement, but need to update the assert statement
 	 * if you add a new field, and also add a corresponding SET_FIELD statement */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 96, "Incorrect size");
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -5241,7 +5525,6 @@ spdk_bs_init(struct spdk_bs_dev *dev, struct spdk_bs_opts *o,
 	uint64_t		num_md_pages;
 	uint64_t		num_md_clusters;
 	uint64_t		max_used_cluster_mask_len;
-	uint32_t		i;
 	struct spdk_bs_opts	opts = {};
 	int			rc;
 	uint64_t		lba, lba_count;
@@ -5391,9 +5674,7 @@ spdk_bs_init(struct spdk_bs_dev *dev, struct spdk_bs_opts *o,
 		return;
 	}
 	/* Claim all of the clusters used by the metadata */
-	for (i = 0; i < num_md_clusters; i++) {
-		spdk_bit_array_set(ctx->used_clusters, i);
-	}
+	spdk_bit_array_set_range(ctx->used_clusters, 0, num_md_clusters);
 
 	bs->num_free_clusters -= num_md_clusters;
 	bs->total_data_clusters = bs->num_free_clusters;
@@ -5790,7 +6071,7 @@ spdk_bs_get_io_unit_size(struct spdk_blob_store *bs)
 uint64_t
 spdk_bs_free_cluster_count(struct spdk_blob_store *bs)
 {
-	return bs->num_free_clusters;
+	return bs->num_free_clusters + __atomic_load_n(&bs->num_reserved_clusters, __ATOMIC_RELAXED);
 }
 
 uint64_t
@@ -5879,32 +6160,142 @@ spdk_blob_get_next_unallocated_io_unit(struct spdk_blob *blob, uint64_t offset)
 	return blob_find_io_unit(blob, offset, false);
 }
 
-/* START spdk_bs_create_blob */
-
-static void
-bs_create_blob_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+int
+spdk_blob_io_get_dev_lba(struct spdk_blob *blob, struct spdk_io_channel *channel,
+			 uint64_t io_unit, uint64_t length,
+			 struct spdk_io_channel **dev_channel, uint64_t *lba)
 {
-	struct spdk_blob *blob = cb_arg;
-	uint32_t page_idx = bs_blobid_to_page(blob->id);
+	struct spdk_bs_channel *bs_channel = spdk_io_channel_get_ctx(channel);
 
-	if (bserrno != 0) {
-		spdk_spin_lock(&blob->bs->used_lock);
-		spdk_bit_array_clear(blob->bs->used_blobids, page_idx);
-		bs_release_md_page(blob->bs, page_idx);
-		spdk_spin_unlock(&blob->bs->used_lock);
+	if (spdk_unlikely(blob->frozen_refcnt != 0)) {
+		return -EBUSY;
 	}
 
-	blob_free(blob);
+	if (length == 0 ||
+	    io_unit + length > bs_cluster_to_lba(blob->bs, blob->active.num_clusters) ||
+	    length > bs_num_io_units_to_cluster_boundary(blob, io_unit) ||
+	    !bs_io_unit_is_allocated(blob, io_unit)) {
+		return -ENOENT;
+	}
 
-	bs_sequence_finish(seq, bserrno);
+	*dev_channel = bs_channel->dev_channel;
+	*lba = bs_blob_io_unit_to_lba(blob, io_unit);
+
+	return 0;
 }
 
-static int
-blob_set_xattrs(struct spdk_blob *blob, const struct spdk_blob_xattr_opts *xattrs,
-		bool internal)
+static struct spdk_blob *
+blob_get_parent_blob(struct spdk_blob *blob)
 {
-	uint64_t i;
-	size_t value_len = 0;
+	if (blob->parent_id == SPDK_BLOBID_INVALID ||
+	    blob->parent_id == SPDK_BLOBID_EXTERNAL_SNAPSHOT) {
+		return NULL;
+	}
+
+	return ((struct spdk_blob_bs_dev *)blob->back_bs_dev)->blob;
+}
+
+/* Returns true if the cluster was written by a blob in the chain between blob and base_id */
+static bool
+blob_cluster_is_changed(struct spdk_blob *blob, spdk_blob_id base_id, uint64_t cluster)
+{
+	for (; blob != NULL && blob->id != base_id; blob = blob_get_parent_blob(blob)) {
+		if (cluster >= blob->active.num_clusters) {
+			/* Reads as zeroes, which the base doesn't necessarily do */
+			return true;
+		}
+		if (blob->active.clusters[cluster] != 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Returns true if base_id is the blob itself, one of its ancestors or SPDK_BLOBID_INVALID */
+static bool
+blob_has_ancestor(struct spdk_blob *blob, spdk_blob_id base_id)
+{
+	if (base_id == SPDK_BLOBID_INVALID) {
+		return true;
+	}
+
+	for (; blob != NULL; blob = blob_get_parent_blob(blob)) {
+		if (blob->id == base_id) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int
+spdk_blob_get_changed_extents(struct spdk_blob *blob, spdk_blob_id base_id, uint64_t offset,
+			      struct spdk_blob_extent *extents, uint32_t *num_extents)
+{
+	struct spdk_blob_extent *extent = NULL;
+	uint64_t io_units_per_cluster = bs_io_units_per_cluster(blob);
+	uint64_t num_io_units = spdk_blob_get_num_io_units(blob);
+	uint64_t cluster, end;
+	uint32_t count = 0;
+
+	if (!blob_has_ancestor(blob, base_id)) {
+		return -EINVAL;
+	}
+
+	for (; offset < num_io_units; offset = end) {
+		cluster = offset / io_units_per_cluster;
+		end = spdk_min((cluster + 1) * io_units_per_cluster, num_io_units);
+
+		if (!blob_cluster_is_changed(blob, base_id, cluster)) {
+			continue;
+		}
+
+		if (extent != NULL && extent->offset + extent->length == offset) {
+			extent->length += end - offset;
+			continue;
+		}
+
+		if (count == *num_extents) {
+			break;
+		}
+
+		extent = &extents[count++];
+		extent->offset = offset;
+		extent->length = end - offset;
+	}
+
+	*num_extents = count;
+
+	return 0;
+}
+
+/* START spdk_bs_create_blob */
+
+static void
+bs_create_blob_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob *blob = cb_arg;
+	uint32_t page_idx = bs_blobid_to_page(blob->id);
+
+	if (bserrno != 0) {
+		spdk_spin_lock(&blob->bs->used_lock);
+		spdk_bit_array_clear(blob->bs->used_blobids, page_idx);
+		bs_release_md_page(blob->bs, page_idx);
+		spdk_spin_unlock(&blob->bs->used_lock);
+	}
+
+	blob_free(blob);
+
+	bs_sequence_finish(seq, bserrno);
+}
+
+static int
+blob_set_xattrs(struct spdk_blob *blob, const struct spdk_blob_xattr_opts *xattrs,
+		bool internal)
+{
+	uint64_t i;
+	size_t value_len = 0;
 	int rc;
 	const void *value = NULL;
 	if (xattrs->count > 0 && xattrs->get_value == NULL) {
@@ -6105,6 +6496,10 @@ struct spdk_clone_snapshot_ctx {
 	 * thin-provisioning. Otherwise only decouple parent and keep clone thin. */
 	bool allocate_all;
 
+	/* Copies of clusters are paced according to the blobstore's copy_rate_limit */
+	uint64_t next_copy_tsc;
+	struct spdk_poller *copy_poller;
+
 	struct {
 		spdk_blob_id id;
 		struct spdk_blob *blob;
@@ -6766,6 +7161,50 @@ bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool alloc
 	return (allocate_all || b->blob->active.clusters[cluster] != 0);
 }
 
+static void bs_inflate_blob_touch_next(void *cb_arg, int bserrno);
+
+static int
+bs_inflate_blob_resume(void *cb_arg)
+{
+	struct spdk_clone_snapshot_ctx *ctx = cb_arg;
+
+	spdk_poller_unregister(&ctx->copy_poller);
+	bs_inflate_blob_touch_next(ctx, 0);
+
+	return SPDK_POLLER_BUSY;
+}
+
+/*
+ * Returns true if copying the next cluster needs to be delayed to keep within the blobstore's
+ * copy_rate_limit, in which case the poller calling resume_fn is registered.
+ */
+static bool
+bs_copy_throttle(struct spdk_blob_store *bs, uint64_t *next_copy_tsc, struct spdk_poller **poller,
+		 spdk_poller_fn resume_fn, void *ctx)
+{
+	uint64_t limit = bs->copy_rate_limit;
+	uint64_t now, delay_us, hz = spdk_get_ticks_hz();
+
+	if (limit == 0) {
+		return false;
+	}
+
+	now = spdk_get_ticks();
+	if (now < *next_copy_tsc) {
+		delay_us = (*next_copy_tsc - now) * SPDK_SEC_TO_USEC / hz;
+		*poller = spdk_poller_register(resume_fn, ctx, delay_us);
+		if (*poller != NULL) {
+			return true;
+		}
+		/* Rather copy the cluster right away than fail the whole operation */
+		now = *next_copy_tsc;
+	}
+
+	*next_copy_tsc = now + hz / limit;
+
+	return false;
+}
+
 static void
 bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
 {
@@ -6787,6 +7226,11 @@ bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
 	}
 
 	if (ctx->cluster < _blob->active.num_clusters) {
+		if (bs_copy_throttle(_blob->bs, &ctx->next_copy_tsc, &ctx->copy_poller,
+				     bs_inflate_blob_resume, ctx)) {
+			return;
+		}
+
 		offset = bs_cluster_to_lba(_blob->bs, ctx->cluster);
 
 		/* We may safely increment a cluster before copying */
@@ -6882,6 +7326,12 @@ bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 	bs_inflate_blob_touch_next(ctx, 0);
 }
 
+void
+spdk_bs_set_copy_rate_limit(struct spdk_blob_store *bs, uint64_t clusters_per_sec)
+{
+	bs->copy_rate_limit = clusters_per_sec;
+}
+
 static void
 bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 		spdk_blob_id blobid, bool allocate_all, spdk_blob_op_complete cb_fn, void *cb_arg)
@@ -6918,6 +7368,266 @@ spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel
 }
 /* END spdk_bs_inflate_blob */
 
+/* START spdk_bs_blob_shallow_copy */
+
+/* Maximum number of clusters copied in parallel by a shallow copy */
+#define BS_SHALLOW_COPY_MAX_QUEUE_DEPTH	32
+
+struct bs_shallow_copy_ctx;
+
+struct bs_shallow_copy_task {
+	struct bs_shallow_copy_ctx	*ctx;
+	struct spdk_bs_dev_cb_args	cb_args;
+	void				*buf;
+	uint64_t			cluster;
+	bool				busy;
+};
+
+struct bs_shallow_copy_ctx {
+	struct spdk_blob_store		*bs;
+	struct spdk_io_channel		*channel;
+	struct spdk_blob		*blob;
+	spdk_blob_id			base_id;
+	struct spdk_bs_dev		*ext_dev;
+	struct spdk_io_channel		*ext_channel;
+	spdk_blob_op_complete		cb_fn;
+	void				*cb_arg;
+	int				bserrno;
+
+	/* Next cluster to check whether it needs to be copied */
+	uint64_t			cluster;
+	uint32_t			outstanding;
+	/* Set while new copies are submitted, so that completions don't submit more themselves */
+	bool				submitting;
+	uint64_t			next_copy_tsc;
+	struct spdk_poller		*copy_poller;
+
+	uint32_t			queue_depth;
+	struct bs_shallow_copy_task	tasks[];
+};
+
+static void
+bs_shallow_copy_close_cpl(void *cb_arg, int bserrno)
+{
+	struct bs_shallow_copy_ctx *ctx = cb_arg;
+
+	ctx->cb_fn(ctx->cb_arg, ctx->bserrno != 0 ? ctx->bserrno : bserrno);
+	free(ctx);
+}
+
+static void
+bs_shallow_copy_finish(struct bs_shallow_copy_ctx *ctx)
+{
+	uint32_t i;
+
+	if (ctx->ext_channel != NULL) {
+		ctx->ext_dev->destroy_channel(ctx->ext_dev, ctx->ext_channel);
+	}
+
+	for (i = 0; i < ctx->queue_depth; i++) {
+		spdk_free(ctx->tasks[i].buf);
+	}
+
+	spdk_blob_close(ctx->blob, bs_shallow_copy_close_cpl, ctx);
+}
+
+static void bs_shallow_copy_submit(struct bs_shallow_copy_ctx *ctx);
+
+static int
+bs_shallow_copy_resume(void *cb_arg)
+{
+	struct bs_shallow_copy_ctx *ctx = cb_arg;
+
+	spdk_poller_unregister(&ctx->copy_poller);
+	bs_shallow_copy_submit(ctx);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bs_shallow_copy_task_done(struct bs_shallow_copy_task *task, int bserrno)
+{
+	struct bs_shallow_copy_ctx *ctx = task->ctx;
+
+	if (bserrno != 0 && ctx->bserrno == 0) {
+		SPDK_ERRLOG("Failed to copy cluster %" PRIu64 " of blob 0x%" PRIx64 ": %d\n",
+			    task->cluster, ctx->blob->id, bserrno);
+		ctx->bserrno = bserrno;
+	}
+
+	task->busy = false;
+	ctx->outstanding--;
+
+	if (!ctx->submitting && ctx->copy_poller == NULL) {
+		bs_shallow_copy_submit(ctx);
+	}
+}
+
+static void
+bs_shallow_copy_write_cpl(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	bs_shallow_copy_task_done(cb_arg, bserrno);
+}
+
+static void
+bs_shallow_copy_read_cpl(void *cb_arg, int bserrno)
+{
+	struct bs_shallow_copy_task *task = cb_arg;
+	struct bs_shallow_copy_ctx *ctx = task->ctx;
+	struct spdk_bs_dev *ext_dev = ctx->ext_dev;
+	uint64_t lba, lba_count;
+
+	if (bserrno != 0) {
+		bs_shallow_copy_task_done(task, bserrno);
+		return;
+	}
+
+	lba = task->cluster * ctx->bs->cluster_sz / ext_dev->blocklen;
+	lba_count = ctx->bs->cluster_sz / ext_dev->blocklen;
+
+	task->cb_args.cb_fn = bs_shallow_copy_write_cpl;
+	task->cb_args.channel = ctx->ext_channel;
+	task->cb_args.cb_arg = task;
+	ext_dev->write(ext_dev, ctx->ext_channel, task->buf, lba, lba_count, &task->cb_args);
+}
+
+static void
+bs_shallow_copy_submit(struct bs_shallow_copy_ctx *ctx)
+{
+	struct spdk_blob *blob = ctx->blob;
+	struct bs_shallow_copy_task *task = NULL;
+	uint64_t cluster_io_units = bs_io_units_per_cluster(blob);
+	uint32_t i;
+
+	ctx->submitting = true;
+	while (ctx->bserrno == 0 && ctx->outstanding < ctx->queue_depth) {
+		while (ctx->cluster < blob->active.num_clusters &&
+		       !blob_cluster_is_changed(blob, ctx->base_id, ctx->cluster)) {
+			ctx->cluster++;
+		}
+
+		if (ctx->cluster == blob->active.num_clusters) {
+			break;
+		}
+
+		if (bs_copy_throttle(ctx->bs, &ctx->next_copy_tsc, &ctx->copy_poller,
+				     bs_shallow_copy_resume, ctx)) {
+			ctx->submitting = false;
+			return;
+		}
+
+		for (i = 0; i < ctx->queue_depth; i++) {
+			if (!ctx->tasks[i].busy) {
+				task = &ctx->tasks[i];
+				break;
+			}
+		}
+		assert(task != NULL);
+
+		task->busy = true;
+		task->cluster = ctx->cluster++;
+		ctx->outstanding++;
+		spdk_blob_io_read(blob, ctx->channel, task->buf, task->cluster * cluster_io_units,
+				  cluster_io_units, bs_shallow_copy_read_cpl, task);
+	}
+	ctx->submitting = false;
+
+	if (ctx->outstanding == 0) {
+		bs_shallow_copy_finish(ctx);
+	}
+}
+
+static void
+bs_shallow_copy_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct bs_shallow_copy_ctx *ctx = cb_arg;
+	struct spdk_bs_dev *ext_dev = ctx->ext_dev;
+	uint64_t size;
+	uint32_t i;
+
+	if (bserrno != 0) {
+		ctx->cb_fn(ctx->cb_arg, bserrno);
+		free(ctx);
+		return;
+	}
+
+	ctx->blob = blob;
+
+	if (!spdk_blob_is_read_only(blob)) {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 " must be read only to be copied\n", blob->id);
+		ctx->bserrno = -EPERM;
+		bs_shallow_copy_finish(ctx);
+		return;
+	}
+
+	if (!blob_has_ancestor(blob, ctx->base_id)) {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 " is not an ancestor of blob 0x%" PRIx64 "\n",
+			    ctx->base_id, blob->id);
+		ctx->bserrno = -EINVAL;
+		bs_shallow_copy_finish(ctx);
+		return;
+	}
+
+	size = spdk_blob_get_num_clusters(blob) * ctx->bs->cluster_sz;
+	if (ctx->bs->io_unit_size % ext_dev->blocklen != 0 ||
+	    ext_dev->blockcnt * ext_dev->blocklen < size) {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 " doesn't fit the external device\n", blob->id);
+		ctx->bserrno = -EINVAL;
+		bs_shallow_copy_finish(ctx);
+		return;
+	}
+
+	ctx->ext_channel = ext_dev->create_channel(ext_dev);
+	if (ctx->ext_channel == NULL) {
+		ctx->bserrno = -ENOMEM;
+		bs_shallow_copy_finish(ctx);
+		return;
+	}
+
+	for (i = 0; i < ctx->queue_depth; i++) {
+		ctx->tasks[i].ctx = ctx;
+		ctx->tasks[i].buf = spdk_malloc(ctx->bs->cluster_sz, ctx->bs->io_unit_size, NULL,
+						SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+		if (ctx->tasks[i].buf == NULL) {
+			ctx->bserrno = -ENOMEM;
+			bs_shallow_copy_finish(ctx);
+			return;
+		}
+	}
+
+	bs_shallow_copy_submit(ctx);
+}
+
+void
+spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			  spdk_blob_id blobid, spdk_blob_id base_id, struct spdk_bs_dev *ext_dev,
+			  uint32_t queue_depth, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct bs_shallow_copy_ctx *ctx;
+
+	if (queue_depth == 0 || queue_depth > BS_SHALLOW_COPY_MAX_QUEUE_DEPTH) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx) + queue_depth * sizeof(ctx->tasks[0]));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->bs = bs;
+	ctx->channel = channel;
+	ctx->base_id = base_id;
+	ctx->ext_dev = ext_dev;
+	ctx->queue_depth = queue_depth;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_bs_open_blob(bs, blobid, bs_shallow_copy_open_cpl, ctx);
+}
+/* END spdk_bs_blob_shallow_copy */
+
 /* START spdk_blob_resize */
 struct spdk_bs_resize_ctx {
 	spdk_blob_op_complete cb_fn;
@@ -7154,6 +7864,7 @@ delete_snapshot_sync_snapshot_cpl(void *cb_arg, int bserrno)
 	case SPDK_BLOBID_INVALID:
 	case SPDK_BLOBID_EXTERNAL_SNAPSHOT:
 		/* No parent snapshot - just remove clone entry */
+		RB_REMOVE(spdk_blob_list_tree, &ctx->snapshot->bs->clones, clone_entry);
 		free(clone_entry);
 		break;
 	default:
@@ -7168,7 +7879,9 @@ delete_snapshot_sync_snapshot_cpl(void *cb_arg, int bserrno)
 
 		/* Switch clone entry in parent snapshot */
 		TAILQ_INSERT_TAIL(&parent_snapshot_entry->clones, clone_entry, link);
+		clone_entry->parent = parent_snapshot_entry;
 		TAILQ_REMOVE(&parent_snapshot_entry->clones, snapshot_clone_entry, link);
+		RB_REMOVE(spdk_blob_list_tree, &ctx->snapshot->bs->clones, snapshot_clone_entry);
 		free(snapshot_clone_entry);
 	}
 
@@ -7447,7 +8160,7 @@ bs_delete_blob_finish(void *cb_arg, struct spdk_blob *blob, int bserrno)
 	/* Remove snapshot from the list */
 	snapshot_entry = bs_get_snapshot_entry(blob->bs, blob->id);
 	if (snapshot_entry != NULL) {
-		TAILQ_REMOVE(&blob->bs->snapshots, snapshot_entry, link);
+		RB_REMOVE(spdk_blob_list_tree, &blob->bs->snapshots, snapshot_entry);
 		free(snapshot_entry);
 	}
 
@@ -7812,6 +8525,11 @@ struct spdk_blob_insert_cluster_ctx {
 	int			rc;
 	spdk_blob_op_complete	cb_fn;
 	void			*cb_arg;
+	/* Set for the single insertion writing each extent page of a group commit */
+	bool			write_extent_page;
+	/* The cluster is removed from the blob instead of being inserted */
+	bool			free_cluster;
+	TAILQ_ENTRY(spdk_blob_insert_cluster_ctx) link;
 };
 
 static void
@@ -7823,12 +8541,33 @@ blob_insert_cluster_msg_cpl(void *arg)
 	free(ctx);
 }
 
+/* Release a cluster removed from a blob, once the metadata no longer references it */
+static void
+blob_free_cluster_persisted(struct spdk_blob_insert_cluster_ctx *ctx)
+{
+	struct spdk_blob_store *bs = ctx->blob->bs;
+	uint64_t *cluster_lba = &ctx->blob->active.clusters[ctx->cluster_num];
+
+	if (ctx->rc != 0 && *cluster_lba == 0) {
+		/* The metadata still references the cluster, so keep it in the blob */
+		*cluster_lba = bs_cluster_to_lba(bs, ctx->cluster);
+		return;
+	}
+
+	spdk_spin_lock(&bs->used_lock);
+	bs_release_cluster(bs, ctx->cluster);
+	spdk_spin_unlock(&bs->used_lock);
+}
+
 static void
 blob_insert_cluster_msg_cb(void *arg, int bserrno)
 {
 	struct spdk_blob_insert_cluster_ctx *ctx = arg;
 
 	ctx->rc = bserrno;
+	if (ctx->free_cluster) {
+		blob_free_cluster_persisted(ctx);
+	}
 	spdk_thread_send_msg(ctx->thread, blob_insert_cluster_msg_cpl, ctx);
 }
 
@@ -7917,17 +8656,10 @@ blob_write_extent_page(struct spdk_blob *blob, uint32_t extent, uint64_t cluster
 }
 
 static void
-blob_insert_cluster_msg(void *arg)
+blob_insert_cluster_persist(struct spdk_blob_insert_cluster_ctx *ctx)
 {
-	struct spdk_blob_insert_cluster_ctx *ctx = arg;
 	uint32_t *extent_page;
 
-	ctx->rc = blob_insert_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
-	if (ctx->rc != 0) {
-		spdk_thread_send_msg(ctx->thread, blob_insert_cluster_msg_cpl, ctx);
-		return;
-	}
-
 	if (ctx->blob->use_extent_table == false) {
 		/* Extent table is not used, proceed with sync of md that will only use extents_rle. */
 		ctx->blob->state = SPDK_BLOB_STATE_DIRTY;
@@ -7961,6 +8693,197 @@ blob_insert_cluster_msg(void *arg)
 	}
 }
 
+/* Clusters inserted into a single blob, whose metadata is committed together */
+struct blob_md_commit_group {
+	struct spdk_blob	*blob;
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) inserts;
+	uint32_t		outstanding;
+	int			rc;
+};
+
+static void
+blob_md_commit_done(void *cb_arg, int bserrno)
+{
+	struct blob_md_commit_group *group = cb_arg;
+	struct spdk_blob_insert_cluster_ctx *ctx;
+
+	while ((ctx = TAILQ_FIRST(&group->inserts)) != NULL) {
+		TAILQ_REMOVE(&group->inserts, ctx, link);
+		blob_insert_cluster_msg_cb(ctx, bserrno);
+	}
+
+	free(group);
+}
+
+static void
+blob_md_commit_extent_page_cpl(void *cb_arg, int bserrno)
+{
+	struct blob_md_commit_group *group = cb_arg;
+	struct spdk_blob_insert_cluster_ctx *ctx;
+	uint32_t *extent_page;
+	bool sync_md = false;
+
+	if (bserrno != 0 && group->rc == 0) {
+		group->rc = bserrno;
+	}
+
+	if (--group->outstanding > 0) {
+		return;
+	}
+
+	if (group->rc != 0) {
+		blob_md_commit_done(group, group->rc);
+		return;
+	}
+
+	/* New extent pages are only referenced from the extent table once they're written */
+	TAILQ_FOREACH(ctx, &group->inserts, link) {
+		if (ctx->write_extent_page && ctx->extent_page != 0) {
+			extent_page = bs_cluster_to_extent_page(group->blob, ctx->cluster_num);
+			*extent_page = ctx->extent_page;
+			sync_md = true;
+		}
+	}
+
+	if (!sync_md) {
+		blob_md_commit_done(group, 0);
+		return;
+	}
+
+	group->blob->state = SPDK_BLOB_STATE_DIRTY;
+	blob_sync_md(group->blob, blob_md_commit_done, group);
+}
+
+static void
+blob_md_commit_group_start(struct blob_md_commit_group *group)
+{
+	struct spdk_blob *blob = group->blob;
+	struct spdk_blob_store *bs = blob->bs;
+	struct spdk_blob_insert_cluster_ctx *ctx, *prev;
+	uint32_t *extent_page;
+
+	if (blob->use_extent_table == false) {
+		blob->state = SPDK_BLOB_STATE_DIRTY;
+		blob_sync_md(blob, blob_md_commit_done, group);
+		return;
+	}
+
+	/* Extent pages are serialized with all the clusters inserted so far, so each of them
+	 * only needs to be written once, no matter how many insertions it received. */
+	group->outstanding = 1;
+	TAILQ_FOREACH(ctx, &group->inserts, link) {
+		extent_page = bs_cluster_to_extent_page(blob, ctx->cluster_num);
+		prev = TAILQ_FIRST(&group->inserts);
+		for (; prev != ctx; prev = TAILQ_NEXT(prev, link)) {
+			if (prev->write_extent_page &&
+			    bs_cluster_to_extent_page(blob, prev->cluster_num) == extent_page) {
+				break;
+			}
+		}
+
+		if ((*extent_page != 0 || prev != ctx) && ctx->extent_page != 0) {
+			spdk_spin_lock(&bs->used_lock);
+			assert(spdk_bit_array_get(bs->used_md_pages, ctx->extent_page) == true);
+			bs_release_md_page(bs, ctx->extent_page);
+			spdk_spin_unlock(&bs->used_lock);
+			ctx->extent_page = 0;
+		}
+		if (prev != ctx) {
+			continue;
+		}
+
+		assert(*extent_page != 0 || ctx->extent_page != 0);
+		ctx->write_extent_page = true;
+		group->outstanding++;
+		blob_write_extent_page(blob, *extent_page != 0 ? *extent_page : ctx->extent_page,
+				       ctx->cluster_num, ctx->page, blob_md_commit_extent_page_cpl,
+				       group);
+	}
+
+	blob_md_commit_extent_page_cpl(group, 0);
+}
+
+static void
+bs_md_commit_flush(struct spdk_blob_store *bs)
+{
+	struct spdk_blob_insert_cluster_ctx *ctx, *tmp;
+	struct blob_md_commit_group *group;
+
+	spdk_poller_unregister(&bs->md_commit_poller);
+	bs->md_commit_num_pending = 0;
+
+	while ((ctx = TAILQ_FIRST(&bs->md_commit_pending)) != NULL) {
+		group = calloc(1, sizeof(*group));
+		if (group == NULL) {
+			/* Fall back to persisting the insertions one by one */
+			TAILQ_REMOVE(&bs->md_commit_pending, ctx, link);
+			blob_insert_cluster_persist(ctx);
+			continue;
+		}
+
+		group->blob = ctx->blob;
+		TAILQ_INIT(&group->inserts);
+		TAILQ_FOREACH_SAFE(ctx, &bs->md_commit_pending, link, tmp) {
+			if (ctx->blob == group->blob) {
+				TAILQ_REMOVE(&bs->md_commit_pending, ctx, link);
+				TAILQ_INSERT_TAIL(&group->inserts, ctx, link);
+			}
+		}
+
+		blob_md_commit_group_start(group);
+	}
+}
+
+static int
+bs_md_commit_poll(void *arg)
+{
+	bs_md_commit_flush(arg);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+blob_insert_cluster_msg(void *arg)
+{
+	struct spdk_blob_insert_cluster_ctx *ctx = arg;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+
+	if (ctx->free_cluster) {
+		ctx->rc = blob_free_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
+		if (ctx->rc == -ENOENT) {
+			/* The cluster was already removed from the blob, e.g. moved to a snapshot */
+			ctx->rc = 0;
+		}
+	} else {
+		ctx->rc = blob_insert_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
+	}
+	if (ctx->rc != 0) {
+		spdk_thread_send_msg(ctx->thread, blob_insert_cluster_msg_cpl, ctx);
+		return;
+	}
+
+	if (bs->md_commit_window_us == 0) {
+		blob_insert_cluster_persist(ctx);
+		return;
+	}
+
+	/* The cluster is already visible in the blob, only persisting it is deferred */
+	TAILQ_INSERT_TAIL(&bs->md_commit_pending, ctx, link);
+	bs->md_commit_num_pending++;
+	if (bs->md_commit_num_pending == bs->md_commit_max_pending) {
+		bs_md_commit_flush(bs);
+		return;
+	}
+
+	if (bs->md_commit_poller == NULL) {
+		bs->md_commit_poller = SPDK_POLLER_REGISTER(bs_md_commit_poll, bs,
+				       bs->md_commit_window_us);
+		if (bs->md_commit_poller == NULL) {
+			bs_md_commit_flush(bs);
+		}
+	}
+}
+
 static void
 blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 				 uint64_t cluster, uint32_t extent_page, struct spdk_blob_md_page *page,
@@ -7986,6 +8909,33 @@ blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 	spdk_thread_send_msg(blob->bs->md_thread, blob_insert_cluster_msg, ctx);
 }
 
+/* Remove a cluster from a blob and persist the metadata through the same path as insertions,
+ * including their group commit.  The cluster is released once the metadata is persisted. */
+static void
+blob_free_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
+			       uint64_t cluster, struct spdk_blob_md_page *page,
+			       spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_insert_cluster_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->thread = spdk_get_thread();
+	ctx->blob = blob;
+	ctx->cluster_num = cluster_num;
+	ctx->cluster = cluster;
+	ctx->page = page;
+	ctx->free_cluster = true;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_thread_send_msg(blob->bs->md_thread, blob_insert_cluster_msg, ctx);
+}
+
 /* START spdk_blob_close */
 
 static void
@@ -8523,18 +9473,14 @@ blob_update_clear_method(struct spdk_blob *blob)
 spdk_blob_id
 spdk_blob_get_parent_snapshot(struct spdk_blob_store *bs, spdk_blob_id blob_id)
 {
-	struct spdk_blob_list *snapshot_entry = NULL;
-	struct spdk_blob_list *clone_entry = NULL;
+	struct spdk_blob_list *clone_entry;
 
-	TAILQ_FOREACH(snapshot_entry, &bs->snapshots, link) {
-		TAILQ_FOREACH(clone_entry, &snapshot_entry->clones, link) {
-			if (clone_entry->id == blob_id) {
-				return snapshot_entry->id;
-			}
-		}
+	clone_entry = bs_get_clone_entry(bs, blob_id);
+	if (clone_entry == NULL) {
+		return SPDK_BLOBID_INVALID;
 	}
 
-	return SPDK_BLOBID_INVALID;
+	return clone_entry->parent->id;
 }
 
 int
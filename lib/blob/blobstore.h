@@ -96,6 +96,10 @@ struct spdk_blob_list {
 	size_t clone_count;
 	TAILQ_HEAD(, spdk_blob_list) clones;
 	TAILQ_ENTRY(spdk_blob_list) link;
+	/* Snapshot entry a clone entry belongs to */
+	struct spdk_blob_list *parent;
+	/* Node in bs->snapshots for snapshot entries and in bs->clones for clone entries */
+	RB_ENTRY(spdk_blob_list) node;
 };
 
 struct spdk_blob {
@@ -145,8 +149,8 @@ struct spdk_blob {
 	TAILQ_HEAD(, spdk_blob_persist_ctx) pending_persists;
 	TAILQ_HEAD(, spdk_blob_persist_ctx) persists_to_complete;
 
-	/* Number of data clusters retrieved from extent table,
-	 * that many have to be read from extent pages. */
+	/* Number of data clusters retrieved from extent table, the cluster array is sized
+	 * for that many before the extent pages are read. */
 	uint64_t	remaining_clusters_in_et;
 };
 
@@ -172,6 +176,9 @@ struct spdk_blob_store {
 	uint64_t			total_clusters;
 	uint64_t			total_data_clusters;
 	uint64_t			num_free_clusters;	/* Protected by used_lock */
+	/* Clusters claimed by channels, but not allocated to any blob yet */
+	uint64_t			num_reserved_clusters;
+	TAILQ_HEAD(, spdk_bs_channel)	channels;		/* Protected by used_lock */
 	uint64_t			pages_per_cluster;
 	uint8_t				pages_per_cluster_shift;
 	uint32_t			io_unit_size;
@@ -183,7 +190,10 @@ struct spdk_blob_store {
 	int				unload_err;
 
 	RB_HEAD(spdk_blob_tree, spdk_blob) open_blobs;
-	TAILQ_HEAD(, spdk_blob_list)	snapshots;
+	/* Snapshots and clones indexed by blob ID, so that looking up the relations of a blob
+	 * doesn't depend on the number of snapshots in the blobstore */
+	RB_HEAD(spdk_blob_list_tree, spdk_blob_list) snapshots;
+	struct spdk_blob_list_tree	clones;
 
 	bool				clean;
 
@@ -197,8 +207,23 @@ struct spdk_blob_store {
 	uint32_t			esnap_channels_unloading;
 	spdk_bs_op_complete		esnap_unload_cb_fn;
 	void				*esnap_unload_cb_arg;
+
+	/* Cluster insertions waiting on md_thread for the group commit of their metadata */
+	uint32_t			md_commit_window_us;
+	uint32_t			md_commit_max_pending;
+	uint32_t			md_commit_num_pending;
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) md_commit_pending;
+	struct spdk_poller		*md_commit_poller;
+
+	/* Maximum number of clusters copied per second by inflate and decouple, 0 if unlimited */
+	uint64_t			copy_rate_limit;
 };
 
+/* Maximum number of clusters reserved at once by a channel */
+#define BS_CHANNEL_RESERVED_CLUSTERS	16
+/* Clusters are only reserved while over 1/N of the blobstore is free */
+#define BS_CHANNEL_RESERVATION_RATIO	64
+
 struct spdk_bs_channel {
 	struct spdk_bs_request_set	*req_mem;
 	TAILQ_HEAD(, spdk_bs_request_set) reqs;
@@ -210,6 +235,17 @@ struct spdk_bs_channel {
 
 	/* This page is only used during insert of a new cluster. */
 	struct spdk_blob_md_page	*new_cluster_page;
+	/* Buffer used to copy a cluster on the first write to it, allocated on first use.
+	 * Cluster allocations are serialized on each channel, so a single one is enough. */
+	void				*cow_buf;
+
+	/* Clusters claimed in a batch, so that the first writes to clusters on this channel don't
+	 * contend on bs->used_lock.  Filled under the lock, consumed from the channel's thread
+	 * without it. */
+	uint32_t			reserved_clusters[BS_CHANNEL_RESERVED_CLUSTERS];
+	uint32_t			reserved_head;
+	uint32_t			reserved_count;
+	TAILQ_ENTRY(spdk_bs_channel)	link;
 
 	TAILQ_HEAD(, spdk_bs_request_set) need_cluster_alloc;
 	TAILQ_HEAD(, spdk_bs_request_set) queued_io;
@@ -0,0 +1,674 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation. All rights reserved.
+ */
+
+/*
+ * Read cache for the devices backing esnap clones.  All the clones of the same external snapshot
+ * share its cached data, which is kept in fixed size chunks evicted in LRU order once the cache
+ * reaches its size limit.  Concurrent misses on the same chunk result in a single read from the
+ * backing device.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/blob.h"
+#include "spdk/dma.h"
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/queue.h"
+#include "spdk/thread.h"
+#include "spdk/tree.h"
+#include "spdk/util.h"
+
+#define ESNAP_CACHE_CHUNK_SIZE	(64 * 1024)
+
+struct esnap_cache_read;
+
+/* Part of a read served by a single chunk */
+struct esnap_cache_piece {
+	struct esnap_cache_read		*read;
+	/* Offset of the piece within the read's payload */
+	uint64_t			read_offset;
+	/* Offset of the piece within its chunk */
+	uint32_t			chunk_offset;
+	uint32_t			length;
+	int				rc;
+	TAILQ_ENTRY(esnap_cache_piece)	link;
+};
+
+struct esnap_cache_read {
+	struct spdk_bs_dev_cb_args	*cb_args;
+	struct spdk_thread		*thread;
+	struct iovec			*iov;
+	int				iovcnt;
+	/* Used for reads of a single buffer */
+	struct iovec			payload_iov;
+	uint32_t			outstanding;
+	int				rc;
+	struct esnap_cache_piece	pieces[];
+};
+
+/* Cached data of a single external snapshot */
+struct esnap_cache {
+	void				*id;
+	uint32_t			id_len;
+	uint32_t			ref;
+	TAILQ_ENTRY(esnap_cache)	link;
+};
+
+struct esnap_cache_chunk {
+	struct esnap_cache		*cache;
+	uint64_t			index;
+	void				*buf;
+	uint32_t			length;
+	bool				valid;
+	/* Chunks allocated when the cache is full are freed once the read completes */
+	bool				cached;
+	/* Pieces waiting for the chunk to be read from the backing device */
+	TAILQ_HEAD(, esnap_cache_piece)	waiters;
+	struct spdk_bs_dev_cb_args	cb_args;
+	RB_ENTRY(esnap_cache_chunk)	node;
+	TAILQ_ENTRY(esnap_cache_chunk)	lru;
+};
+
+struct esnap_cache_dev {
+	struct spdk_bs_dev	bs_dev;
+	struct spdk_bs_dev	*back_dev;
+	struct esnap_cache	*cache;
+};
+
+static int
+esnap_cache_chunk_cmp(struct esnap_cache_chunk *c1, struct esnap_cache_chunk *c2)
+{
+	if (c1->cache != c2->cache) {
+		return (uintptr_t)c1->cache < (uintptr_t)c2->cache ? -1 : 1;
+	}
+
+	return c1->index < c2->index ? -1 : c1->index > c2->index;
+}
+
+RB_HEAD(esnap_cache_chunk_tree, esnap_cache_chunk);
+RB_GENERATE_STATIC(esnap_cache_chunk_tree, esnap_cache_chunk, node, esnap_cache_chunk_cmp);
+
+static pthread_mutex_t g_esnap_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static TAILQ_HEAD(, esnap_cache) g_esnap_caches = TAILQ_HEAD_INITIALIZER(g_esnap_caches);
+static struct esnap_cache_chunk_tree g_esnap_cache_chunks = RB_INITIALIZER(&g_esnap_cache_chunks);
+/* Valid chunks, the most recently used first */
+static TAILQ_HEAD(esnap_cache_chunk_lru, esnap_cache_chunk) g_esnap_cache_lru =
+	TAILQ_HEAD_INITIALIZER(g_esnap_cache_lru);
+/* Size limit and memory used by the cached chunks, in bytes */
+static uint64_t g_esnap_cache_size;
+static uint64_t g_esnap_cache_used;
+
+static void
+esnap_cache_chunk_free(struct esnap_cache_chunk *chunk)
+{
+	spdk_free(chunk->buf);
+	free(chunk);
+}
+
+static struct esnap_cache_chunk *
+esnap_cache_chunk_alloc(void)
+{
+	struct esnap_cache_chunk *chunk;
+
+	chunk = calloc(1, sizeof(*chunk));
+	if (chunk == NULL) {
+		return NULL;
+	}
+
+	chunk->buf = spdk_malloc(ESNAP_CACHE_CHUNK_SIZE, 0x1000, NULL, SPDK_ENV_LCORE_ID_ANY,
+				 SPDK_MALLOC_DMA);
+	if (chunk->buf == NULL) {
+		free(chunk);
+		return NULL;
+	}
+
+	return chunk;
+}
+
+/* Remove the least recently used chunk from the cache.  Must be called with the lock held. */
+static struct esnap_cache_chunk *
+esnap_cache_evict(void)
+{
+	struct esnap_cache_chunk *chunk;
+
+	chunk = TAILQ_LAST(&g_esnap_cache_lru, esnap_cache_chunk_lru);
+	if (chunk == NULL) {
+		return NULL;
+	}
+
+	TAILQ_REMOVE(&g_esnap_cache_lru, chunk, lru);
+	RB_REMOVE(esnap_cache_chunk_tree, &g_esnap_cache_chunks, chunk);
+	chunk->valid = false;
+
+	return chunk;
+}
+
+/*
+ * Get a chunk to read the data into, reusing the least recently used one if the cache is full.
+ * Must be called with the lock held.
+ */
+static struct esnap_cache_chunk *
+esnap_cache_chunk_get(void)
+{
+	struct esnap_cache_chunk *chunk = NULL;
+
+	if (g_esnap_cache_used + ESNAP_CACHE_CHUNK_SIZE <= g_esnap_cache_size) {
+		chunk = esnap_cache_chunk_alloc();
+		if (chunk != NULL) {
+			g_esnap_cache_used += ESNAP_CACHE_CHUNK_SIZE;
+			chunk->cached = true;
+			return chunk;
+		}
+	}
+
+	chunk = esnap_cache_evict();
+	if (chunk != NULL) {
+		return chunk;
+	}
+
+	/* Every chunk is being read, so use one outside of the cache */
+	chunk = esnap_cache_chunk_alloc();
+	if (chunk != NULL) {
+		chunk->cached = false;
+	}
+
+	return chunk;
+}
+
+void
+spdk_bs_esnap_cache_set_size(uint64_t size)
+{
+	struct esnap_cache_chunk *chunk;
+
+	pthread_mutex_lock(&g_esnap_cache_lock);
+	g_esnap_cache_size = size;
+	while (g_esnap_cache_used > g_esnap_cache_size) {
+		chunk = esnap_cache_evict();
+		if (chunk == NULL) {
+			/* The chunks being read are released once they complete */
+			break;
+		}
+		g_esnap_cache_used -= ESNAP_CACHE_CHUNK_SIZE;
+		esnap_cache_chunk_free(chunk);
+	}
+	pthread_mutex_unlock(&g_esnap_cache_lock);
+}
+
+static void
+esnap_cache_copy_to_iovs(struct iovec *iov, int iovcnt, uint64_t offset, const void *buf,
+			 uint64_t length)
+{
+	uint64_t len;
+	int i;
+
+	for (i = 0; i < iovcnt && length > 0; i++) {
+		if (offset >= iov[i].iov_len) {
+			offset -= iov[i].iov_len;
+			continue;
+		}
+
+		len = spdk_min(iov[i].iov_len - offset, length);
+		memcpy((uint8_t *)iov[i].iov_base + offset, buf, len);
+		buf = (const uint8_t *)buf + len;
+		length -= len;
+		offset = 0;
+	}
+}
+
+static void
+esnap_cache_piece_copy(struct esnap_cache_piece *piece, struct esnap_cache_chunk *chunk)
+{
+	struct esnap_cache_read *read = piece->read;
+
+	esnap_cache_copy_to_iovs(read->iov, read->iovcnt, piece->read_offset,
+				 (uint8_t *)chunk->buf + piece->chunk_offset, piece->length);
+}
+
+static void
+esnap_cache_read_done(struct esnap_cache_read *read, int rc)
+{
+	assert(read->thread == spdk_get_thread());
+	assert(read->outstanding > 0);
+
+	if (rc != 0) {
+		read->rc = rc;
+	}
+
+	if (--read->outstanding > 0) {
+		return;
+	}
+
+	read->cb_args->cb_fn(read->cb_args->channel, read->cb_args->cb_arg, read->rc);
+	free(read);
+}
+
+static void
+_esnap_cache_piece_done(void *ctx)
+{
+	struct esnap_cache_piece *piece = ctx;
+
+	esnap_cache_read_done(piece->read, piece->rc);
+}
+
+static void
+esnap_cache_piece_done(struct esnap_cache_piece *piece, int rc)
+{
+	struct esnap_cache_read *read = piece->read;
+	int msg_rc;
+
+	if (read->thread == spdk_get_thread()) {
+		esnap_cache_read_done(read, rc);
+		return;
+	}
+
+	/* The chunk was read on behalf of a request from another thread */
+	piece->rc = rc;
+	msg_rc = spdk_thread_send_msg(read->thread, _esnap_cache_piece_done, piece);
+	if (msg_rc != 0) {
+		SPDK_ERRLOG("Failed to complete an esnap cache read on thread %s\n",
+			    spdk_thread_get_name(read->thread));
+		assert(false);
+	}
+}
+
+static void
+esnap_cache_fetch_done(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct esnap_cache_chunk *chunk = cb_arg;
+	struct esnap_cache_piece *piece, *tmp;
+	TAILQ_HEAD(, esnap_cache_piece) waiters = TAILQ_HEAD_INITIALIZER(waiters);
+
+	pthread_mutex_lock(&g_esnap_cache_lock);
+	TAILQ_SWAP(&waiters, &chunk->waiters, esnap_cache_piece, link);
+	if (bserrno == 0) {
+		TAILQ_FOREACH(piece, &waiters, link) {
+			esnap_cache_piece_copy(piece, chunk);
+		}
+	}
+
+	if (!chunk->cached) {
+		esnap_cache_chunk_free(chunk);
+	} else if (bserrno != 0 || g_esnap_cache_used > g_esnap_cache_size) {
+		/* Don't keep failed reads, nor exceed a size that was lowered in the meantime */
+		RB_REMOVE(esnap_cache_chunk_tree, &g_esnap_cache_chunks, chunk);
+		g_esnap_cache_used -= ESNAP_CACHE_CHUNK_SIZE;
+		esnap_cache_chunk_free(chunk);
+	} else {
+		chunk->valid = true;
+		TAILQ_INSERT_HEAD(&g_esnap_cache_lru, chunk, lru);
+	}
+	pthread_mutex_unlock(&g_esnap_cache_lock);
+
+	TAILQ_FOREACH_SAFE(piece, &waiters, link, tmp) {
+		esnap_cache_piece_done(piece, bserrno);
+	}
+}
+
+static void
+esnap_cache_read_piece(struct esnap_cache_dev *cdev, struct spdk_io_channel *channel,
+		       struct esnap_cache_piece *piece, uint64_t index)
+{
+	struct spdk_bs_dev *back_dev = cdev->back_dev;
+	struct esnap_cache_chunk key = { .cache = cdev->cache, .index = index }, *chunk;
+	uint64_t offset, dev_size;
+
+	pthread_mutex_lock(&g_esnap_cache_lock);
+	chunk = RB_FIND(esnap_cache_chunk_tree, &g_esnap_cache_chunks, &key);
+	if (chunk != NULL && chunk->valid) {
+		esnap_cache_piece_copy(piece, chunk);
+		TAILQ_REMOVE(&g_esnap_cache_lru, chunk, lru);
+		TAILQ_INSERT_HEAD(&g_esnap_cache_lru, chunk, lru);
+		pthread_mutex_unlock(&g_esnap_cache_lock);
+		esnap_cache_piece_done(piece, 0);
+		return;
+	}
+
+	if (chunk != NULL) {
+		/* The chunk is already being read */
+		TAILQ_INSERT_TAIL(&chunk->waiters, piece, link);
+		pthread_mutex_unlock(&g_esnap_cache_lock);
+		return;
+	}
+
+	chunk = esnap_cache_chunk_get();
+	if (chunk == NULL) {
+		pthread_mutex_unlock(&g_esnap_cache_lock);
+		esnap_cache_piece_done(piece, -ENOMEM);
+		return;
+	}
+
+	chunk->cache = cdev->cache;
+	chunk->index = index;
+	TAILQ_INIT(&chunk->waiters);
+	TAILQ_INSERT_TAIL(&chunk->waiters, piece, link);
+	if (chunk->cached) {
+		RB_INSERT(esnap_cache_chunk_tree, &g_esnap_cache_chunks, chunk);
+	}
+	pthread_mutex_unlock(&g_esnap_cache_lock);
+
+	/* The last chunk can be shorter if the device's size isn't a multiple of the chunk size */
+	offset = index * ESNAP_CACHE_CHUNK_SIZE;
+	dev_size = back_dev->blockcnt * back_dev->blocklen;
+	chunk->length = spdk_min(ESNAP_CACHE_CHUNK_SIZE, dev_size - offset);
+
+	chunk->cb_args.cb_fn = esnap_cache_fetch_done;
+	chunk->cb_args.channel = channel;
+	chunk->cb_args.cb_arg = chunk;
+	back_dev->read(back_dev, channel, chunk->buf, offset / back_dev->blocklen,
+		       chunk->length / back_dev->blocklen, &chunk->cb_args);
+}
+
+/* Read either into payload or into the iovs, if payload is NULL */
+static void
+esnap_cache_dev_submit(struct esnap_cache_dev *cdev, struct spdk_io_channel *channel,
+		       void *payload, struct iovec *iov, int iovcnt, uint64_t lba,
+		       uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct spdk_bs_dev *back_dev = cdev->back_dev;
+	struct esnap_cache_read *read = NULL;
+	struct esnap_cache_piece *piece;
+	uint64_t offset, end, first, last, i;
+
+	offset = lba * back_dev->blocklen;
+	end = offset + (uint64_t)lba_count * back_dev->blocklen;
+	first = offset / ESNAP_CACHE_CHUNK_SIZE;
+	last = (end - 1) / ESNAP_CACHE_CHUNK_SIZE;
+
+	if (g_esnap_cache_size != 0 && lba_count != 0) {
+		read = calloc(1, sizeof(*read) + (last - first + 1) * sizeof(read->pieces[0]));
+	}
+
+	if (read == NULL) {
+		if (payload != NULL) {
+			back_dev->read(back_dev, channel, payload, lba, lba_count, cb_args);
+		} else {
+			back_dev->readv(back_dev, channel, iov, iovcnt, lba, lba_count, cb_args);
+		}
+		return;
+	}
+
+	read->cb_args = cb_args;
+	read->thread = spdk_get_thread();
+	if (payload != NULL) {
+		read->payload_iov.iov_base = payload;
+		read->payload_iov.iov_len = end - offset;
+		read->iov = &read->payload_iov;
+		read->iovcnt = 1;
+	} else {
+		read->iov = iov;
+		read->iovcnt = iovcnt;
+	}
+	/* Hold an extra reference, so that the read isn't completed while it's being split */
+	read->outstanding = last - first + 2;
+
+	for (i = first; i <= last; i++) {
+		piece = &read->pieces[i - first];
+		piece->read = read;
+		piece->chunk_offset = offset - i * ESNAP_CACHE_CHUNK_SIZE;
+		piece->length = spdk_min(end, (i + 1) * ESNAP_CACHE_CHUNK_SIZE) - offset;
+		piece->read_offset = offset - lba * back_dev->blocklen;
+		offset += piece->length;
+
+		esnap_cache_read_piece(cdev, channel, piece, i);
+	}
+
+	esnap_cache_read_done(read, 0);
+}
+
+static void
+esnap_cache_dev_read(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+		     uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	esnap_cache_dev_submit((struct esnap_cache_dev *)dev, channel, payload, NULL, 0, lba,
+			       lba_count, cb_args);
+}
+
+static void
+esnap_cache_dev_readv(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+		      struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+		      struct spdk_bs_dev_cb_args *cb_args)
+{
+	esnap_cache_dev_submit((struct esnap_cache_dev *)dev, channel, NULL, iov, iovcnt, lba,
+			       lba_count, cb_args);
+}
+
+static void
+esnap_cache_dev_readv_ext(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+			  struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+			  struct spdk_bs_dev_cb_args *cb_args,
+			  struct spdk_blob_ext_io_opts *io_opts)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+	struct spdk_bs_dev *back_dev = cdev->back_dev;
+
+	/* Data in other memory domains can't be copied from the cache */
+	if (io_opts != NULL && io_opts->memory_domain != NULL) {
+		back_dev->readv_ext(back_dev, channel, iov, iovcnt, lba, lba_count, cb_args,
+				    io_opts);
+		return;
+	}
+
+	esnap_cache_dev_readv(dev, channel, iov, iovcnt, lba, lba_count, cb_args);
+}
+
+static void
+esnap_cache_dev_write(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+		      uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -EPERM);
+	assert(false);
+}
+
+static void
+esnap_cache_dev_writev(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+		       struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+		       struct spdk_bs_dev_cb_args *cb_args)
+{
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -EPERM);
+	assert(false);
+}
+
+static void
+esnap_cache_dev_writev_ext(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+			   struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+			   struct spdk_bs_dev_cb_args *cb_args,
+			   struct spdk_blob_ext_io_opts *io_opts)
+{
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -EPERM);
+	assert(false);
+}
+
+static void
+esnap_cache_dev_write_zeroes(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+			     uint64_t lba, uint64_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -EPERM);
+	assert(false);
+}
+
+static void
+esnap_cache_dev_unmap(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+		      uint64_t lba, uint64_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -EPERM);
+	assert(false);
+}
+
+static struct spdk_io_channel *
+esnap_cache_dev_create_channel(struct spdk_bs_dev *dev)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+
+	return cdev->back_dev->create_channel(cdev->back_dev);
+}
+
+static void
+esnap_cache_dev_destroy_channel(struct spdk_bs_dev *dev, struct spdk_io_channel *channel)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+
+	cdev->back_dev->destroy_channel(cdev->back_dev, channel);
+}
+
+static bool
+esnap_cache_dev_is_zeroes(struct spdk_bs_dev *dev, uint64_t lba, uint64_t lba_count)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+
+	return cdev->back_dev->is_zeroes(cdev->back_dev, lba, lba_count);
+}
+
+static bool
+esnap_cache_dev_translate_lba(struct spdk_bs_dev *dev, uint64_t lba, uint64_t *base_lba)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+
+	return cdev->back_dev->translate_lba(cdev->back_dev, lba, base_lba);
+}
+
+static struct spdk_bdev *
+esnap_cache_dev_get_base_bdev(struct spdk_bs_dev *dev)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+
+	return cdev->back_dev->get_base_bdev(cdev->back_dev);
+}
+
+static bool
+esnap_cache_dev_is_degraded(struct spdk_bs_dev *dev)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+
+	return cdev->back_dev->is_degraded != NULL && cdev->back_dev->is_degraded(cdev->back_dev);
+}
+
+static void
+esnap_cache_put(struct esnap_cache *cache)
+{
+	struct esnap_cache_chunk *chunk, *tmp;
+
+	pthread_mutex_lock(&g_esnap_cache_lock);
+	if (--cache->ref > 0) {
+		pthread_mutex_unlock(&g_esnap_cache_lock);
+		return;
+	}
+
+	/* None of the chunks can be in flight, as the devices have no outstanding I/O */
+	TAILQ_FOREACH_SAFE(chunk, &g_esnap_cache_lru, lru, tmp) {
+		if (chunk->cache == cache) {
+			TAILQ_REMOVE(&g_esnap_cache_lru, chunk, lru);
+			RB_REMOVE(esnap_cache_chunk_tree, &g_esnap_cache_chunks, chunk);
+			g_esnap_cache_used -= ESNAP_CACHE_CHUNK_SIZE;
+			esnap_cache_chunk_free(chunk);
+		}
+	}
+	TAILQ_REMOVE(&g_esnap_caches, cache, link);
+	pthread_mutex_unlock(&g_esnap_cache_lock);
+
+	free(cache->id);
+	free(cache);
+}
+
+static struct esnap_cache *
+esnap_cache_get(const void *esnap_id, uint32_t id_len)
+{
+	struct esnap_cache *cache;
+
+	pthread_mutex_lock(&g_esnap_cache_lock);
+	TAILQ_FOREACH(cache, &g_esnap_caches, link) {
+		if (cache->id_len == id_len && memcmp(cache->id, esnap_id, id_len) == 0) {
+			cache->ref++;
+			pthread_mutex_unlock(&g_esnap_cache_lock);
+			return cache;
+		}
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		goto out;
+	}
+
+	cache->id = malloc(id_len);
+	if (cache->id == NULL) {
+		free(cache);
+		cache = NULL;
+		goto out;
+	}
+
+	memcpy(cache->id, esnap_id, id_len);
+	cache->id_len = id_len;
+	cache->ref = 1;
+	TAILQ_INSERT_TAIL(&g_esnap_caches, cache, link);
+out:
+	pthread_mutex_unlock(&g_esnap_cache_lock);
+	return cache;
+}
+
+static void
+esnap_cache_dev_destroy(struct spdk_bs_dev *dev)
+{
+	struct esnap_cache_dev *cdev = (struct esnap_cache_dev *)dev;
+
+	esnap_cache_put(cdev->cache);
+	cdev->back_dev->destroy(cdev->back_dev);
+	free(cdev);
+}
+
+int
+spdk_bs_esnap_cache_dev_create(struct spdk_bs_dev *back_dev, const void *esnap_id,
+			       uint32_t id_len, struct spdk_bs_dev **_dev)
+{
+	struct esnap_cache_dev *cdev;
+	struct spdk_bs_dev *dev;
+
+	if (back_dev->read == NULL || back_dev->readv == NULL ||
+	    ESNAP_CACHE_CHUNK_SIZE % back_dev->blocklen != 0) {
+		SPDK_ERRLOG("Device with block size %" PRIu32 " can't be cached\n",
+			    back_dev->blocklen);
+		return -EINVAL;
+	}
+
+	cdev = calloc(1, sizeof(*cdev));
+	if (cdev == NULL) {
+		return -ENOMEM;
+	}
+
+	cdev->cache = esnap_cache_get(esnap_id, id_len);
+	if (cdev->cache == NULL) {
+		free(cdev);
+		return -ENOMEM;
+	}
+
+	cdev->back_dev = back_dev;
+
+	dev = &cdev->bs_dev;
+	dev->blockcnt = back_dev->blockcnt;
+	dev->blocklen = back_dev->blocklen;
+	dev->create_channel = esnap_cache_dev_create_channel;
+	dev->destroy_channel = esnap_cache_dev_destroy_channel;
+	dev->destroy = esnap_cache_dev_destroy;
+	dev->read = esnap_cache_dev_read;
+	dev->readv = esnap_cache_dev_readv;
+	if (back_dev->readv_ext != NULL) {
+		dev->readv_ext = esnap_cache_dev_readv_ext;
+	}
+	dev->write = esnap_cache_dev_write;
+	dev->writev = esnap_cache_dev_writev;
+	dev->writev_ext = esnap_cache_dev_writev_ext;
+	dev->write_zeroes = esnap_cache_dev_write_zeroes;
+	dev->unmap = esnap_cache_dev_unmap;
+	if (back_dev->is_zeroes != NULL) {
+		dev->is_zeroes = esnap_cache_dev_is_zeroes;
+	}
+	if (back_dev->translate_lba != NULL) {
+		dev->translate_lba = esnap_cache_dev_translate_lba;
+	}
+	if (back_dev->get_base_bdev != NULL) {
+		dev->get_base_bdev = esnap_cache_dev_get_base_bdev;
+	}
+	dev->is_degraded = esnap_cache_dev_is_degraded;
+
+	*_dev = dev;
+	return 0;
+}
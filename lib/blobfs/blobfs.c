@@ -34,7 +34,10 @@ static struct spdk_mempool *g_cache_pool;
 static TAILQ_HEAD(, spdk_file) g_caches = TAILQ_HEAD_INITIALIZER(g_caches);
 static struct spdk_poller *g_cache_pool_mgmt_poller;
 static struct spdk_thread *g_cache_pool_thread;
+static struct spdk_fs_cache_stats g_cache_stats;
 #define BLOBFS_CACHE_POOL_POLL_PERIOD_IN_US 1000ULL
+/* Number of polls of the semaphore before a synchronous caller goes to sleep on it */
+#define BLOBFS_SYNC_SPIN_COUNT 2000
 static int g_fs_count = 0;
 static pthread_mutex_t g_cache_init_lock = PTHREAD_MUTEX_INITIALIZER;
 
@@ -84,6 +87,14 @@ cache_buffer_free(struct cache_buffer *cache_buffer)
 }
 
 #define CACHE_READAHEAD_THRESHOLD	(128 * 1024)
+/* Read-ahead window of a sequentially read file, in cache buffers. It starts at the minimum
+ * and doubles each time the reader consumes a buffer filled by read-ahead.
+ */
+#define CACHE_READAHEAD_MIN_BUFFERS	2
+#define CACHE_READAHEAD_MAX_BUFFERS	16
+
+#define CACHE_STATS_INC(field, count) \
+	__atomic_fetch_add(&g_cache_stats.field, (count), __ATOMIC_RELAXED)
 
 struct spdk_file {
 	struct spdk_filesystem	*fs;
@@ -97,6 +108,9 @@ struct spdk_file {
 	uint64_t		append_pos;
 	uint64_t		seq_byte_count;
 	uint64_t		next_seq_offset;
+	uint32_t		readahead_window;
+	/* End of the range read-ahead was already issued for */
+	uint64_t		readahead_end;
 	uint32_t		priority;
 	TAILQ_ENTRY(spdk_file)	tailq;
 	spdk_blob_id		blobid;
@@ -136,6 +150,11 @@ struct spdk_filesystem {
 	struct {
 		uint32_t		max_ops;
 	} io_target;
+
+	struct {
+		uint32_t		num_shards;
+		fs_send_io_request_fn	send_request;
+	} io_shards;
 };
 
 struct spdk_fs_cb_args {
@@ -184,6 +203,7 @@ struct spdk_fs_cb_args {
 			struct cache_buffer	*cache_buffer;
 			uint64_t		length;
 			uint64_t		offset;
+			struct spdk_io_channel	*io_channel;
 		} readahead;
 		struct {
 			/* offset of the file when the sync request was made */
@@ -569,6 +589,25 @@ __wake_caller(void *arg, int fserrno)
 	sem_post(args->sem);
 }
 
+/*
+ * Wait for a request sent by a synchronous caller. Most of them complete within a few
+ *  microseconds, so poll for a while before paying for a sleep and a wakeup.
+ */
+static void
+fs_channel_wait(struct spdk_fs_channel *channel)
+{
+	uint32_t i;
+
+	for (i = 0; i < BLOBFS_SYNC_SPIN_COUNT; i++) {
+		if (sem_trywait(&channel->sem) == 0) {
+			return;
+		}
+		spdk_pause();
+	}
+
+	sem_wait(&channel->sem);
+}
+
 void
 spdk_fs_init(struct spdk_bs_dev *dev, struct spdk_blobfs_opts *opt,
 	     fs_send_request_fn send_request_fn,
@@ -866,6 +905,14 @@ unload_cb(void *ctx, int bserrno)
 	fs_io_device_unregister(fs);
 }
 
+void
+spdk_fs_set_io_shards(struct spdk_filesystem *fs, uint32_t num_shards,
+		      fs_send_io_request_fn send_io_request_fn)
+{
+	fs->io_shards.num_shards = num_shards;
+	fs->io_shards.send_request = send_io_request_fn;
+}
+
 void
 spdk_fs_unload(struct spdk_filesystem *fs, spdk_fs_op_complete cb_fn, void *cb_arg)
 {
@@ -971,7 +1018,7 @@ spdk_fs_file_stat(struct spdk_filesystem *fs, struct spdk_fs_thread_ctx *ctx,
 	req->args.arg = stat;
 	req->args.sem = &channel->sem;
 	channel->send_request(__file_stat, req);
-	sem_wait(&channel->sem);
+	fs_channel_wait(channel);
 
 	rc = req->args.rc;
 	free_fs_request(req);
@@ -1138,7 +1185,7 @@ spdk_fs_create_file(struct spdk_filesystem *fs, struct spdk_fs_thread_ctx *ctx,
 	args->op.create.name = name;
 	args->sem = &channel->sem;
 	fs->send_request(__fs_create_file, req);
-	sem_wait(&channel->sem);
+	fs_channel_wait(channel);
 	rc = args->rc;
 	free_fs_request(req);
 
@@ -1288,7 +1335,7 @@ spdk_fs_open_file(struct spdk_filesystem *fs, struct spdk_fs_thread_ctx *ctx,
 	args->op.open.flags = flags;
 	args->sem = &channel->sem;
 	fs->send_request(__fs_open_file, req);
-	sem_wait(&channel->sem);
+	fs_channel_wait(channel);
 	rc = args->rc;
 	if (rc == 0) {
 		*file = args->file;
@@ -1437,7 +1484,7 @@ spdk_fs_rename_file(struct spdk_filesystem *fs, struct spdk_fs_thread_ctx *ctx,
 	args->op.rename.new_name = new_name;
 	args->sem = &channel->sem;
 	fs->send_request(__fs_rename_file, req);
-	sem_wait(&channel->sem);
+	fs_channel_wait(channel);
 	rc = args->rc;
 	free_fs_request(req);
 	return rc;
@@ -1543,7 +1590,7 @@ spdk_fs_delete_file(struct spdk_filesystem *fs, struct spdk_fs_thread_ctx *ctx,
 	args->op.delete.name = name;
 	args->sem = &channel->sem;
 	fs->send_request(__fs_delete_file, req);
-	sem_wait(&channel->sem);
+	fs_channel_wait(channel);
 	rc = args->rc;
 	free_fs_request(req);
 
@@ -1695,7 +1742,7 @@ spdk_file_truncate(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 	args->sem = &channel->sem;
 
 	channel->send_request(__truncate, req);
-	sem_wait(&channel->sem);
+	fs_channel_wait(channel);
 	rc = args->rc;
 	free_fs_request(req);
 
@@ -1914,7 +1961,9 @@ spdk_fs_alloc_io_channel(struct spdk_filesystem *fs)
 
 	io_channel = spdk_get_io_channel(&fs->io_target);
 	fs_channel = spdk_io_channel_get_ctx(io_channel);
-	fs_channel->bs_channel = spdk_bs_alloc_io_channel(fs->bs);
+	if (fs_channel->bs_channel == NULL) {
+		fs_channel->bs_channel = spdk_bs_alloc_io_channel(fs->bs);
+	}
 	fs_channel->send_request = __send_request_direct;
 
 	return io_channel;
@@ -1990,6 +2039,16 @@ spdk_fs_get_cache_size(void)
 	return g_fs_cache_size / (1024 * 1024);
 }
 
+void
+spdk_fs_get_cache_stats(struct spdk_fs_cache_stats *stats)
+{
+	stats->hits = __atomic_load_n(&g_cache_stats.hits, __ATOMIC_RELAXED);
+	stats->misses = __atomic_load_n(&g_cache_stats.misses, __ATOMIC_RELAXED);
+	stats->readahead = __atomic_load_n(&g_cache_stats.readahead, __ATOMIC_RELAXED);
+	stats->readahead_hits = __atomic_load_n(&g_cache_stats.readahead_hits, __ATOMIC_RELAXED);
+	stats->reclaimed = __atomic_load_n(&g_cache_stats.reclaimed, __ATOMIC_RELAXED);
+}
+
 static void __file_flush(void *ctx);
 
 /* Try to free some cache buffers from this file.
@@ -2014,7 +2073,8 @@ reclaim_cache_buffers(struct spdk_file *file)
 		pthread_spin_unlock(&file->lock);
 		return -1;
 	}
-	tree_free_buffers(file->tree);
+	CACHE_STATS_INC(reclaimed, tree_free_buffers(file->tree));
+	file->readahead_end = 0;
 
 	TAILQ_REMOVE(&g_caches, file, cache_tailq);
 	/* If not freed, put it in the end of the queue */
@@ -2038,6 +2098,22 @@ _blobfs_cache_pool_reclaim(void *arg)
 		return SPDK_POLLER_IDLE;
 	}
 
+	/* Start with the files being read sequentially, e.g. by a compaction: their buffers are
+	 * only read once and are cheap to get back with read-ahead, while the data cached for
+	 * the other files may still serve point lookups.
+	 */
+	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
+		if (!file->open_for_writing && file->readahead_window != 0) {
+			rc = reclaim_cache_buffers(file);
+			if (rc < 0) {
+				continue;
+			}
+			if (!blobfs_cache_pool_need_reclaim()) {
+				return SPDK_POLLER_BUSY;
+			}
+		}
+	}
+
 	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
 		if (!file->open_for_writing &&
 		    file->priority == SPDK_FILE_PRIORITY_LOW) {
@@ -2344,12 +2420,54 @@ __file_extend_blob(void *_args)
 	spdk_blob_resize(file->blob, args->op.resize.num_clusters, __file_extend_resize_cb, args);
 }
 
+/*
+ * Reads and read-ahead of a file are sent to the thread serving the file's shard, if the
+ *  data path is sharded.  Everything else goes to the main dispatch thread.
+ */
+static void
+file_send_io_request(struct spdk_file *file, fs_request_fn fn, void *arg)
+{
+	struct spdk_filesystem *fs = file->fs;
+
+	if (fs->io_shards.num_shards == 0) {
+		fs->send_request(fn, arg);
+		return;
+	}
+
+	fs->io_shards.send_request(file->blobid % fs->io_shards.num_shards, fn, arg);
+}
+
+/* Channel for the data path requests executed on the current thread */
+static struct spdk_io_channel *
+fs_get_io_channel(struct spdk_filesystem *fs)
+{
+	if (fs->io_shards.num_shards == 0) {
+		return fs->sync_target.sync_io_channel;
+	}
+
+	/* Just takes a reference on the channel held by the shard's thread */
+	return spdk_fs_alloc_io_channel(fs);
+}
+
+static void
+fs_put_io_channel(struct spdk_filesystem *fs, struct spdk_io_channel *channel)
+{
+	if (channel != fs->sync_target.sync_io_channel) {
+		spdk_fs_free_io_channel(channel);
+	}
+}
+
 static void
 __rw_from_file_done(void *ctx, int bserrno)
 {
 	struct spdk_fs_request *req = ctx;
+	struct spdk_fs_cb_args *args = &req->args;
+
+	if (args->op.rw.channel != NULL) {
+		fs_put_io_channel(args->file->fs, args->op.rw.channel);
+	}
 
-	__wake_caller(&req->args, bserrno);
+	__wake_caller(args, bserrno);
 	free_fs_request(req);
 }
 
@@ -2361,7 +2479,8 @@ __rw_from_file(void *ctx)
 	struct spdk_file *file = args->file;
 
 	if (args->op.rw.is_read) {
-		spdk_file_read_async(file, file->fs->sync_target.sync_io_channel, args->iovs[0].iov_base,
+		args->op.rw.channel = fs_get_io_channel(file->fs);
+		spdk_file_read_async(file, args->op.rw.channel, args->iovs[0].iov_base,
 				     args->op.rw.offset, (uint64_t)args->iovs[0].iov_len,
 				     __rw_from_file_done, req);
 	} else {
@@ -2398,7 +2517,11 @@ __send_rw_from_file(struct spdk_file *file, void *payload,
 	args->op.rw.offset = offset;
 	args->op.rw.is_read = is_read;
 	args->rwerrno = &arg->rwerrno;
-	file->fs->send_request(__rw_from_file, req);
+	if (is_read) {
+		file_send_io_request(file, __rw_from_file, req);
+	} else {
+		file->fs->send_request(__rw_from_file, req);
+	}
 	return 0;
 }
 
@@ -2443,7 +2566,7 @@ spdk_file_write(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 		if (rc != 0) {
 			return rc;
 		}
-		sem_wait(&channel->sem);
+		fs_channel_wait(channel);
 		return arg.rwerrno;
 	}
 
@@ -2459,7 +2582,7 @@ spdk_file_write(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 		BLOBFS_TRACE(file, "start resize to %u clusters\n", extend_args.op.resize.num_clusters);
 		pthread_spin_unlock(&file->lock);
 		file->fs->send_request(__file_extend_blob, &extend_args);
-		sem_wait(&channel->sem);
+		fs_channel_wait(channel);
 		if (extend_args.rc) {
 			return extend_args.rc;
 		}
@@ -2529,6 +2652,7 @@ __readahead_done(void *ctx, int bserrno)
 	cache_buffer->in_progress = false;
 	pthread_spin_unlock(&file->lock);
 
+	fs_put_io_channel(file->fs, args->op.readahead.io_channel);
 	free_fs_request(req);
 }
 
@@ -2538,6 +2662,7 @@ __readahead(void *ctx)
 	struct spdk_fs_request *req = ctx;
 	struct spdk_fs_cb_args *args = &req->args;
 	struct spdk_file *file = args->file;
+	struct spdk_fs_channel *channel;
 	uint64_t offset, length, start_lba, num_lba;
 	uint32_t lba_size;
 
@@ -2547,9 +2672,12 @@ __readahead(void *ctx)
 
 	__get_page_parameters(file, offset, length, &start_lba, &lba_size, &num_lba);
 
+	args->op.readahead.io_channel = fs_get_io_channel(file->fs);
+	channel = spdk_io_channel_get_ctx(args->op.readahead.io_channel);
+
 	BLOBFS_TRACE(file, "offset=%jx length=%jx page start=%jx num=%jx\n",
 		     offset, length, start_lba, num_lba);
-	spdk_blob_io_read(file->blob, file->fs->sync_target.sync_fs_channel->bs_channel,
+	spdk_blob_io_read(file->blob, channel->bs_channel,
 			  args->op.readahead.cache_buffer->buf,
 			  start_lba, num_lba, __readahead_done, req);
 }
@@ -2567,7 +2695,6 @@ check_readahead(struct spdk_file *file, uint64_t offset,
 	struct spdk_fs_request *req;
 	struct spdk_fs_cb_args *args;
 
-	offset = __next_cache_buffer_offset(offset);
 	if (tree_find_buffer(file->tree, offset) != NULL || file->length <= offset) {
 		return;
 	}
@@ -2590,12 +2717,37 @@ check_readahead(struct spdk_file *file, uint64_t offset,
 	}
 
 	args->op.readahead.cache_buffer->in_progress = true;
+	args->op.readahead.cache_buffer->readahead = true;
+	CACHE_STATS_INC(readahead, 1);
 	if (file->length < (offset + CACHE_BUFFER_SIZE)) {
 		args->op.readahead.length = file->length & (CACHE_BUFFER_SIZE - 1);
 	} else {
 		args->op.readahead.length = CACHE_BUFFER_SIZE;
 	}
-	file->fs->send_request(__readahead, req);
+	file_send_io_request(file, __readahead, req);
+}
+
+/* Issue read-ahead for the window of buffers following the one containing offset */
+static void
+file_readahead(struct spdk_file *file, uint64_t offset, struct spdk_fs_channel *channel)
+{
+	uint64_t start, end;
+
+	start = __next_cache_buffer_offset(offset);
+	end = start + (uint64_t)file->readahead_window * CACHE_BUFFER_SIZE;
+
+	/* The beginning of the window was already requested by the previous reads */
+	for (offset = spdk_max(start, file->readahead_end); offset < end && offset < file->length;
+	     offset += CACHE_BUFFER_SIZE) {
+		/* Only grow past the minimum window without evicting other cached data */
+		if (offset >= start + CACHE_READAHEAD_MIN_BUFFERS * CACHE_BUFFER_SIZE &&
+		    blobfs_cache_pool_need_reclaim()) {
+			break;
+		}
+		check_readahead(file, offset, channel);
+	}
+
+	file->readahead_end = spdk_max(file->readahead_end, offset);
 }
 
 int64_t
@@ -2626,12 +2778,16 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 
 	if (offset != file->next_seq_offset) {
 		file->seq_byte_count = 0;
+		file->readahead_window = 0;
+		file->readahead_end = 0;
 	}
 	file->seq_byte_count += length;
 	file->next_seq_offset = offset + length;
 	if (file->seq_byte_count >= CACHE_READAHEAD_THRESHOLD) {
-		check_readahead(file, offset, channel);
-		check_readahead(file, offset + CACHE_BUFFER_SIZE, channel);
+		if (file->readahead_window == 0) {
+			file->readahead_window = CACHE_READAHEAD_MIN_BUFFERS;
+		}
+		file_readahead(file, offset, channel);
 	}
 
 	arg.channel = channel;
@@ -2647,6 +2803,7 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 
 		buf = tree_find_filled_buffer(file->tree, offset);
 		if (buf == NULL) {
+			CACHE_STATS_INC(misses, 1);
 			pthread_spin_unlock(&file->lock);
 			ret = __send_rw_from_file(file, payload, offset, length, true, &arg);
 			pthread_spin_lock(&file->lock);
@@ -2654,6 +2811,14 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 				sub_reads++;
 			}
 		} else {
+			CACHE_STATS_INC(hits, 1);
+			if (buf->readahead) {
+				/* Read-ahead is paying off, read further ahead */
+				buf->readahead = false;
+				CACHE_STATS_INC(readahead_hits, 1);
+				file->readahead_window = spdk_min(file->readahead_window * 2,
+								  CACHE_READAHEAD_MAX_BUFFERS);
+			}
 			read_len = length;
 			if ((offset + length) > (buf->offset + buf->bytes_filled)) {
 				read_len = buf->offset + buf->bytes_filled - offset;
@@ -2679,7 +2844,7 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 	}
 	pthread_spin_unlock(&file->lock);
 	while (sub_reads > 0) {
-		sem_wait(&channel->sem);
+		fs_channel_wait(channel);
 		sub_reads--;
 	}
 	if (arg.rwerrno == 0) {
@@ -2747,7 +2912,7 @@ spdk_file_sync(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx)
 
 	args.sem = &channel->sem;
 	_file_sync(file, channel, __wake_caller, &args);
-	sem_wait(&channel->sem);
+	fs_channel_wait(channel);
 
 	return args.rc;
 }
@@ -2858,6 +3023,14 @@ __file_close(void *arg)
 	__file_close_async(file, req);
 }
 
+static void
+__file_close_after_io(void *arg)
+{
+	struct spdk_fs_request *req = arg;
+
+	req->args.file->fs->send_request(__file_close, req);
+}
+
 int
 spdk_file_close(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx)
 {
@@ -2879,8 +3052,15 @@ spdk_file_close(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx)
 	args->sem = &channel->sem;
 	args->fn.file_op = __wake_caller;
 	args->arg = args;
-	channel->send_request(__file_close, req);
-	sem_wait(&channel->sem);
+	if (file->fs->io_shards.num_shards != 0) {
+		/* Go through the file's shard first, so that the read-ahead already sent to it
+		 *  is submitted before the blob gets closed.
+		 */
+		file_send_io_request(file, __file_close_after_io, req);
+	} else {
+		channel->send_request(__file_close, req);
+	}
+	fs_channel_wait(channel);
 
 	return args->rc;
 }
@@ -13,6 +13,8 @@ struct cache_buffer {
 	uint32_t		bytes_filled;
 	uint32_t		bytes_flushed;
 	bool			in_progress;
+	/* Filled by read-ahead and not read yet */
+	bool			readahead;
 };
 
 #define CACHE_BUFFER_SHIFT (18)
@@ -39,7 +41,7 @@ struct cache_tree {
 void cache_buffer_free(struct cache_buffer *cache_buffer);
 
 struct cache_tree *tree_insert_buffer(struct cache_tree *root, struct cache_buffer *buffer);
-void tree_free_buffers(struct cache_tree *tree);
+uint32_t tree_free_buffers(struct cache_tree *tree);
 struct cache_buffer *tree_find_buffer(struct cache_tree *tree, uint64_t offset);
 struct cache_buffer *tree_find_filled_buffer(struct cache_tree *tree, uint64_t offset);
 void tree_remove_buffer(struct cache_tree *tree, struct cache_buffer *buffer);
@@ -116,6 +116,9 @@ static TAILQ_HEAD(spdk_mem_map_head, spdk_mem_map) g_spdk_mem_maps =
 	TAILQ_HEAD_INITIALIZER(g_spdk_mem_maps);
 static pthread_mutex_t g_spdk_mem_map_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Incremented after any translation of any map is changed, invalidates the vtophys caches */
+static uint64_t g_mem_map_generation;
+
 static bool g_legacy_mem;
 
 /*
@@ -597,6 +600,7 @@ spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 		map_1gb = mem_map_get_map_1gb(map, vfn_2mb);
 		if (!map_1gb) {
 			DEBUG_PRINT("could not get %p map\n", (void *)vaddr);
+			__atomic_fetch_add(&g_mem_map_generation, 1, __ATOMIC_RELEASE);
 			return -ENOMEM;
 		}
 
@@ -608,6 +612,9 @@ spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 		vfn_2mb++;
 	}
 
+	/* Only after the translations are updated, so a cache never keeps the old ones */
+	__atomic_fetch_add(&g_mem_map_generation, 1, __ATOMIC_RELEASE);
+
 	return 0;
 }
 
@@ -757,6 +764,18 @@ static TAILQ_HEAD(, spdk_vtophys_pci_device) g_vtophys_pci_devices =
 	TAILQ_HEAD_INITIALIZER(g_vtophys_pci_devices);
 
 static struct spdk_mem_map *g_vtophys_map;
+
+/* Last 2MB page translated by the thread. Consecutive translations of an I/O buffer mostly hit
+ * the same page, so this saves walking the map for each of them. */
+struct vtophys_cache {
+	uint64_t vfn_2mb;
+	uint64_t paddr_2mb;
+	uint64_t generation;
+};
+
+static __thread struct vtophys_cache g_vtophys_cache = {
+	.vfn_2mb = UINT64_MAX,
+};
 static struct spdk_mem_map *g_phys_ref_map;
 
 #if VFIO_ENABLED
@@ -1501,9 +1520,16 @@ vtophys_init(void)
 uint64_t
 spdk_vtophys(const void *buf, uint64_t *size)
 {
-	uint64_t vaddr, paddr_2mb;
+	struct vtophys_cache *cache = &g_vtophys_cache;
+	uint64_t vaddr, paddr_2mb, generation;
 
 	vaddr = (uint64_t)buf;
+	generation = __atomic_load_n(&g_mem_map_generation, __ATOMIC_ACQUIRE);
+	if (spdk_likely(cache->vfn_2mb == vaddr >> SHIFT_2MB && cache->generation == generation &&
+			(size == NULL || *size <= VALUE_2MB - _2MB_OFFSET(vaddr)))) {
+		return cache->paddr_2mb + _2MB_OFFSET(vaddr);
+	}
+
 	paddr_2mb = spdk_mem_map_translate(g_vtophys_map, vaddr, size);
 
 	/*
@@ -1515,9 +1541,44 @@ spdk_vtophys(const void *buf, uint64_t *size)
 	SPDK_STATIC_ASSERT(SPDK_VTOPHYS_ERROR == UINT64_C(-1), "SPDK_VTOPHYS_ERROR should be all 1s");
 	if (paddr_2mb == SPDK_VTOPHYS_ERROR) {
 		return SPDK_VTOPHYS_ERROR;
-	} else {
-		return paddr_2mb + (vaddr & MASK_2MB);
 	}
+
+	cache->vfn_2mb = vaddr >> SHIFT_2MB;
+	cache->paddr_2mb = paddr_2mb;
+	cache->generation = generation;
+
+	return paddr_2mb + (vaddr & MASK_2MB);
+}
+
+int
+spdk_vtophys_pages(const void *buf, uint64_t len, uint64_t page_size, uint64_t *paddrs,
+		   uint32_t count)
+{
+	uint64_t vaddr = (uint64_t)buf, end = vaddr + len, paddr = 0, size = 0, step;
+	uint32_t i;
+
+	if (spdk_unlikely(!spdk_u64_is_pow2(page_size) || page_size > VALUE_2MB)) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < count && vaddr < end; i++) {
+		if (size == 0) {
+			/* Translate the whole physically contiguous region at once */
+			size = end - vaddr;
+			paddr = spdk_vtophys((const void *)vaddr, &size);
+			if (paddr == SPDK_VTOPHYS_ERROR) {
+				return i > 0 ? (int)i : -EFAULT;
+			}
+		}
+
+		paddrs[i] = paddr;
+		step = spdk_min(page_size - (vaddr & (page_size - 1)), size);
+		vaddr += step;
+		paddr += step;
+		size -= step;
+	}
+
+	return i;
 }
 
 int
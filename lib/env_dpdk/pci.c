@@ -811,6 +811,29 @@ spdk_pci_device_get_interrupt_efd(struct spdk_pci_device *dev)
 	return dpdk_pci_device_get_interrupt_efd(dev->dev_handle);
 }
 
+int
+spdk_pci_device_enable_interrupts(struct spdk_pci_device *dev, uint32_t efd_count)
+{
+	/* Devices not backed by DPDK, e.g. behind VMD, have no interrupt handle */
+	if (dev->dev_handle == NULL) {
+		return -ENOTSUP;
+	}
+
+	return dpdk_pci_device_enable_interrupts(dev->dev_handle, efd_count);
+}
+
+int
+spdk_pci_device_disable_interrupts(struct spdk_pci_device *dev)
+{
+	return dpdk_pci_device_disable_interrupts(dev->dev_handle);
+}
+
+int
+spdk_pci_device_get_interrupt_efd_by_index(struct spdk_pci_device *dev, uint32_t index)
+{
+	return dpdk_pci_device_get_interrupt_efd_by_index(dev->dev_handle, index);
+}
+
 uint32_t
 spdk_pci_device_get_domain(struct spdk_pci_device *dev)
 {
@@ -149,6 +149,24 @@ dpdk_pci_device_get_interrupt_efd(struct rte_pci_device *rte_dev)
 	return g_dpdk_fn_table->pci_device_get_interrupt_efd(rte_dev);
 }
 
+int
+dpdk_pci_device_enable_interrupts(struct rte_pci_device *rte_dev, uint32_t efd_count)
+{
+	return g_dpdk_fn_table->pci_device_enable_interrupts(rte_dev, efd_count);
+}
+
+int
+dpdk_pci_device_disable_interrupts(struct rte_pci_device *rte_dev)
+{
+	return g_dpdk_fn_table->pci_device_disable_interrupts(rte_dev);
+}
+
+int
+dpdk_pci_device_get_interrupt_efd_by_index(struct rte_pci_device *rte_dev, uint32_t index)
+{
+	return g_dpdk_fn_table->pci_device_get_interrupt_efd_by_index(rte_dev, index);
+}
+
 int
 dpdk_bus_probe(void)
 {
@@ -48,6 +48,9 @@ struct dpdk_fn_table {
 	int (*pci_device_enable_interrupt)(struct rte_pci_device *rte_dev);
 	int (*pci_device_disable_interrupt)(struct rte_pci_device *rte_dev);
 	int (*pci_device_get_interrupt_efd)(struct rte_pci_device *rte_dev);
+	int (*pci_device_enable_interrupts)(struct rte_pci_device *rte_dev, uint32_t efd_count);
+	int (*pci_device_disable_interrupts)(struct rte_pci_device *rte_dev);
+	int (*pci_device_get_interrupt_efd_by_index)(struct rte_pci_device *rte_dev, uint32_t index);
 	void (*bus_scan)(void);
 	int (*bus_probe)(void);
 	struct rte_devargs *(*device_get_devargs)(struct rte_device *dev);
@@ -75,6 +78,9 @@ int dpdk_pci_driver_register(struct spdk_pci_driver *driver,
 int dpdk_pci_device_enable_interrupt(struct rte_pci_device *rte_dev);
 int dpdk_pci_device_disable_interrupt(struct rte_pci_device *rte_dev);
 int dpdk_pci_device_get_interrupt_efd(struct rte_pci_device *rte_dev);
+int dpdk_pci_device_enable_interrupts(struct rte_pci_device *rte_dev, uint32_t efd_count);
+int dpdk_pci_device_disable_interrupts(struct rte_pci_device *rte_dev);
+int dpdk_pci_device_get_interrupt_efd_by_index(struct rte_pci_device *rte_dev, uint32_t index);
 void dpdk_bus_scan(void);
 int dpdk_bus_probe(void);
 struct rte_devargs *dpdk_device_get_devargs(struct rte_device *dev);
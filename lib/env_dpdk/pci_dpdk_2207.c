@@ -174,6 +174,75 @@ pci_device_get_interrupt_efd_2207(struct rte_pci_device *rte_dev)
 #endif
 }
 
+static int
+pci_device_enable_interrupts_2207(struct rte_pci_device *rte_dev, uint32_t efd_count)
+{
+	struct rte_intr_handle *rte_intr_handle;
+	int rc;
+
+#if RTE_VERSION < RTE_VERSION_NUM(21, 11, 0, 0)
+	rte_intr_handle = &rte_dev->intr_handle;
+	if (rte_intr_handle->type != RTE_INTR_HANDLE_VFIO_MSIX &&
+	    rte_intr_handle->type != RTE_INTR_HANDLE_VFIO_MSI) {
+		return -ENOTSUP;
+	}
+#else
+	rte_intr_handle = rte_dev->intr_handle;
+	if (rte_intr_type_get(rte_intr_handle) != RTE_INTR_HANDLE_VFIO_MSIX &&
+	    rte_intr_type_get(rte_intr_handle) != RTE_INTR_HANDLE_VFIO_MSI) {
+		return -ENOTSUP;
+	}
+#endif
+
+	rc = rte_intr_efd_enable(rte_intr_handle, efd_count);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = rte_intr_enable(rte_intr_handle);
+	if (rc != 0) {
+		rte_intr_efd_disable(rte_intr_handle);
+	}
+
+	return rc;
+}
+
+static int
+pci_device_disable_interrupts_2207(struct rte_pci_device *rte_dev)
+{
+	struct rte_intr_handle *rte_intr_handle;
+	int rc;
+
+#if RTE_VERSION < RTE_VERSION_NUM(21, 11, 0, 0)
+	rte_intr_handle = &rte_dev->intr_handle;
+#else
+	rte_intr_handle = rte_dev->intr_handle;
+#endif
+
+	rc = rte_intr_disable(rte_intr_handle);
+	rte_intr_efd_disable(rte_intr_handle);
+
+	return rc;
+}
+
+static int
+pci_device_get_interrupt_efd_by_index_2207(struct rte_pci_device *rte_dev, uint32_t index)
+{
+	if (index == 0) {
+		return pci_device_get_interrupt_efd_2207(rte_dev);
+	}
+
+	/* Vector 0 is the device fd, the event fds start at vector 1 */
+#if RTE_VERSION < RTE_VERSION_NUM(21, 11, 0, 0)
+	if (index > (uint32_t)rte_dev->intr_handle.nb_efd) {
+		return -EINVAL;
+	}
+	return rte_dev->intr_handle.efds[index - 1];
+#else
+	return rte_intr_efds_index_get(rte_dev->intr_handle, index - 1);
+#endif
+}
+
 static int
 bus_probe_2207(void)
 {
@@ -223,6 +292,9 @@ struct dpdk_fn_table fn_table_2207 = {
 	.pci_device_enable_interrupt	= pci_device_enable_interrupt_2207,
 	.pci_device_disable_interrupt	= pci_device_disable_interrupt_2207,
 	.pci_device_get_interrupt_efd	= pci_device_get_interrupt_efd_2207,
+	.pci_device_enable_interrupts	= pci_device_enable_interrupts_2207,
+	.pci_device_disable_interrupts	= pci_device_disable_interrupts_2207,
+	.pci_device_get_interrupt_efd_by_index	= pci_device_get_interrupt_efd_by_index_2207,
 	.bus_scan			= bus_scan_2207,
 	.bus_probe			= bus_probe_2207,
 	.device_get_devargs		= device_get_devargs_2207,
@@ -184,6 +184,67 @@ pci_device_get_interrupt_efd_2211(struct rte_pci_device *rte_dev)
 #endif
 }
 
+static int
+pci_device_enable_interrupts_2211(struct rte_pci_device *rte_dev, uint32_t efd_count)
+{
+#if RTE_VERSION < RTE_VERSION_NUM(21, 11, 0, 0)
+	assert(false);
+	return -1;
+#else
+	struct rte_intr_handle *rte_intr_handle = rte_dev->intr_handle;
+	int rc;
+
+	if (rte_intr_type_get(rte_intr_handle) != RTE_INTR_HANDLE_VFIO_MSIX &&
+	    rte_intr_type_get(rte_intr_handle) != RTE_INTR_HANDLE_VFIO_MSI) {
+		return -ENOTSUP;
+	}
+
+	rc = rte_intr_efd_enable(rte_intr_handle, efd_count);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = rte_intr_enable(rte_intr_handle);
+	if (rc != 0) {
+		rte_intr_efd_disable(rte_intr_handle);
+	}
+
+	return rc;
+#endif
+}
+
+static int
+pci_device_disable_interrupts_2211(struct rte_pci_device *rte_dev)
+{
+#if RTE_VERSION < RTE_VERSION_NUM(21, 11, 0, 0)
+	assert(false);
+	return -1;
+#else
+	int rc;
+
+	rc = rte_intr_disable(rte_dev->intr_handle);
+	rte_intr_efd_disable(rte_dev->intr_handle);
+
+	return rc;
+#endif
+}
+
+static int
+pci_device_get_interrupt_efd_by_index_2211(struct rte_pci_device *rte_dev, uint32_t index)
+{
+#if RTE_VERSION < RTE_VERSION_NUM(21, 11, 0, 0)
+	assert(false);
+	return -1;
+#else
+	if (index == 0) {
+		return rte_intr_fd_get(rte_dev->intr_handle);
+	}
+
+	/* Vector 0 is the device fd, the event fds start at vector 1 */
+	return rte_intr_efds_index_get(rte_dev->intr_handle, index - 1);
+#endif
+}
+
 static int
 bus_probe_2211(void)
 {
@@ -233,6 +294,9 @@ struct dpdk_fn_table fn_table_2211 = {
 	.pci_device_enable_interrupt	= pci_device_enable_interrupt_2211,
 	.pci_device_disable_interrupt	= pci_device_disable_interrupt_2211,
 	.pci_device_get_interrupt_efd	= pci_device_get_interrupt_efd_2211,
+	.pci_device_enable_interrupts	= pci_device_enable_interrupts_2211,
+	.pci_device_disable_interrupts	= pci_device_disable_interrupts_2211,
+	.pci_device_get_interrupt_efd_by_index	= pci_device_get_interrupt_efd_by_index_2211,
 	.bus_scan			= bus_scan_2211,
 	.bus_probe			= bus_probe_2211,
 	.device_get_devargs		= device_get_devargs_2211,
@@ -292,78 +292,163 @@ env_rmutex_destroy(env_rmutex *rmutex)
 }
 
 /* *** RW SEMAPHORE *** */
+
+/*
+ * OCF takes its metadata locks on the I/O path from SPDK threads, which must never sleep in the
+ * kernel. The reader-writer locks below spin instead of blocking in a futex. A writer waiting
+ * for the readers to drain marks the lock, so that new readers don't starve it.
+ */
+#define ENV_RWLOCK_WRITER	(1u << 31)
+#define ENV_RWLOCK_WAITING	(1u << 30)
+
+typedef struct {
+	uint32_t val;
+} env_spin_rwlock;
+
+static inline void
+env_spin_rwlock_init(env_spin_rwlock *l)
+{
+	__atomic_store_n(&l->val, 0, __ATOMIC_RELAXED);
+}
+
+static inline bool
+env_spin_rwlock_read_trylock(env_spin_rwlock *l)
+{
+	uint32_t val = __atomic_load_n(&l->val, __ATOMIC_RELAXED);
+
+	if (val & (ENV_RWLOCK_WRITER | ENV_RWLOCK_WAITING)) {
+		return false;
+	}
+
+	return __atomic_compare_exchange_n(&l->val, &val, val + 1, false,
+					   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void
+env_spin_rwlock_read_lock(env_spin_rwlock *l)
+{
+	while (!env_spin_rwlock_read_trylock(l)) {
+		spdk_pause();
+	}
+}
+
+static inline void
+env_spin_rwlock_read_unlock(env_spin_rwlock *l)
+{
+	ENV_BUG_ON((__atomic_fetch_sub(&l->val, 1, __ATOMIC_RELEASE) & ~ENV_RWLOCK_WAITING) == 0);
+}
+
+static inline bool
+env_spin_rwlock_write_trylock(env_spin_rwlock *l)
+{
+	uint32_t val = __atomic_load_n(&l->val, __ATOMIC_RELAXED);
+
+	if (val & ~ENV_RWLOCK_WAITING) {
+		return false;
+	}
+
+	return __atomic_compare_exchange_n(&l->val, &val, ENV_RWLOCK_WRITER, false,
+					   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void
+env_spin_rwlock_write_lock(env_spin_rwlock *l)
+{
+	uint32_t val;
+
+	while (!env_spin_rwlock_write_trylock(l)) {
+		val = __atomic_load_n(&l->val, __ATOMIC_RELAXED);
+		if (!(val & ENV_RWLOCK_WAITING)) {
+			__atomic_compare_exchange_n(&l->val, &val, val | ENV_RWLOCK_WAITING, false,
+						    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+		}
+		spdk_pause();
+	}
+}
+
+static inline void
+env_spin_rwlock_write_unlock(env_spin_rwlock *l)
+{
+	ENV_BUG_ON(!(__atomic_fetch_and(&l->val, ~ENV_RWLOCK_WRITER, __ATOMIC_RELEASE) &
+		     ENV_RWLOCK_WRITER));
+}
+
+static inline bool
+env_spin_rwlock_is_locked(env_spin_rwlock *l)
+{
+	return (__atomic_load_n(&l->val, __ATOMIC_RELAXED) & ~ENV_RWLOCK_WAITING) != 0;
+}
+
 typedef struct {
-	pthread_rwlock_t lock;
+	env_spin_rwlock lock;
 } env_rwsem;
 
 static inline int
 env_rwsem_init(env_rwsem *s)
 {
-	return !!pthread_rwlock_init(&s->lock, NULL);
+	env_spin_rwlock_init(&s->lock);
+	return 0;
 }
 
 static inline void
 env_rwsem_up_read(env_rwsem *s)
 {
-	ENV_BUG_ON(pthread_rwlock_unlock(&s->lock));
+	env_spin_rwlock_read_unlock(&s->lock);
 }
 
 static inline void
 env_rwsem_down_read(env_rwsem *s)
 {
-	ENV_BUG_ON(pthread_rwlock_rdlock(&s->lock));
+	env_spin_rwlock_read_lock(&s->lock);
 }
 
 static inline int
 env_rwsem_down_read_trylock(env_rwsem *s)
 {
-	return pthread_rwlock_tryrdlock(&s->lock) ? -OCF_ERR_NO_LOCK : 0;
+	return env_spin_rwlock_read_trylock(&s->lock) ? 0 : -OCF_ERR_NO_LOCK;
 }
 
 static inline void
 env_rwsem_up_write(env_rwsem *s)
 {
-	ENV_BUG_ON(pthread_rwlock_unlock(&s->lock));
+	env_spin_rwlock_write_unlock(&s->lock);
 }
 
 static inline void
 env_rwsem_down_write(env_rwsem *s)
 {
-	ENV_BUG_ON(pthread_rwlock_wrlock(&s->lock));
+	env_spin_rwlock_write_lock(&s->lock);
 }
 
 static inline int
 env_rwsem_down_write_trylock(env_rwsem *s)
 {
-	return pthread_rwlock_trywrlock(&s->lock) ? -OCF_ERR_NO_LOCK : 0;
+	return env_spin_rwlock_write_trylock(&s->lock) ? 0 : -OCF_ERR_NO_LOCK;
 }
 
 static inline int
 env_rwsem_is_locked(env_rwsem *s)
 {
-	if (env_rwsem_down_read_trylock(s) == 0) {
-		env_rwsem_up_read(s);
-		return 0;
-	}
-
-	return 1;
+	return env_spin_rwlock_is_locked(&s->lock);
 }
 
 static inline int
 env_rwsem_down_read_interruptible(env_rwsem *s)
 {
-	return pthread_rwlock_rdlock(&s->lock);
+	env_spin_rwlock_read_lock(&s->lock);
+	return 0;
 }
 static inline int
 env_rwsem_down_write_interruptible(env_rwsem *s)
 {
-	return pthread_rwlock_wrlock(&s->lock);
+	env_spin_rwlock_write_lock(&s->lock);
+	return 0;
 }
 
 static inline int
 env_rwsem_destroy(env_rwsem *s)
 {
-	return pthread_rwlock_destroy(&s->lock);
+	return env_spin_rwlock_is_locked(&s->lock) ? -EBUSY : 0;
 }
 
 /* *** ATOMIC VARIABLES *** */
@@ -631,43 +716,43 @@ env_spinlock_destroy(env_spinlock *l)
 /* *** RW LOCKS *** */
 
 typedef struct {
-	pthread_rwlock_t lock;
+	env_spin_rwlock lock;
 } env_rwlock;
 
 static inline void
 env_rwlock_init(env_rwlock *l)
 {
-	ENV_BUG_ON(pthread_rwlock_init(&l->lock, NULL));
+	env_spin_rwlock_init(&l->lock);
 }
 
 static inline void
 env_rwlock_read_lock(env_rwlock *l)
 {
-	ENV_BUG_ON(pthread_rwlock_rdlock(&l->lock));
+	env_spin_rwlock_read_lock(&l->lock);
 }
 
 static inline void
 env_rwlock_read_unlock(env_rwlock *l)
 {
-	ENV_BUG_ON(pthread_rwlock_unlock(&l->lock));
+	env_spin_rwlock_read_unlock(&l->lock);
 }
 
 static inline void
 env_rwlock_write_lock(env_rwlock *l)
 {
-	ENV_BUG_ON(pthread_rwlock_wrlock(&l->lock));
+	env_spin_rwlock_write_lock(&l->lock);
 }
 
 static inline void
 env_rwlock_write_unlock(env_rwlock *l)
 {
-	ENV_BUG_ON(pthread_rwlock_unlock(&l->lock));
+	env_spin_rwlock_write_unlock(&l->lock);
 }
 
 static inline void
 env_rwlock_destroy(env_rwlock *l)
 {
-	ENV_BUG_ON(pthread_rwlock_destroy(&l->lock));
+	ENV_BUG_ON(env_spin_rwlock_is_locked(&l->lock));
 }
 
 static inline void
@@ -23,6 +23,8 @@
 #define SPDK_APP_DEFAULT_LOG_LEVEL		SPDK_LOG_NOTICE
 #define SPDK_APP_DEFAULT_LOG_PRINT_LEVEL	SPDK_LOG_INFO
 #define SPDK_APP_DEFAULT_NUM_TRACE_ENTRIES	SPDK_DEFAULT_NUM_TRACE_ENTRIES
+/* Number of trace histories reserved for threads running outside of the reactors */
+#define SPDK_APP_NUM_TRACE_USER_THREADS		4
 
 #define SPDK_APP_DPDK_DEFAULT_MEM_SIZE		-1
 #define SPDK_APP_DPDK_DEFAULT_MAIN_CORE		-1
@@ -44,6 +46,7 @@
 struct spdk_app {
 	const char			*json_config_file;
 	bool				json_config_ignore_errors;
+	uint32_t			json_config_max_parallel;
 	bool				stopped;
 	const char			*rpc_addr;
 	const char			**rpc_allowlist;
@@ -141,6 +144,8 @@ static const struct option g_cmdline_options[] = {
 	{"msg-mempool-size",		required_argument,	NULL, MSG_MEMPOOL_SIZE_OPT_IDX},
 #define LCORES_OPT_IDX	271
 	{"lcores",			required_argument,	NULL, LCORES_OPT_IDX},
+#define JSON_MAX_PARALLEL_OPT_IDX	272
+	{"json-max-parallel",		required_argument,	NULL, JSON_MAX_PARALLEL_OPT_IDX},
 };
 
 static void
@@ -242,6 +247,7 @@ spdk_app_opts_init(struct spdk_app_opts *opts, size_t opts_size)
 	SET_FIELD(rpc_allowlist, NULL);
 	SET_FIELD(rpc_log_file, NULL);
 	SET_FIELD(rpc_log_level, SPDK_LOG_DISABLED);
+	SET_FIELD(json_config_max_parallel, 1);
 #undef SET_FIELD
 }
 
@@ -406,7 +412,7 @@ app_setup_trace(struct spdk_app_opts *opts)
 		snprintf(shm_name, sizeof(shm_name), "/%s_trace.pid%d", opts->name, (int)getpid());
 	}
 
-	if (spdk_trace_init(shm_name, opts->num_entries) != 0) {
+	if (spdk_trace_init(shm_name, opts->num_entries, SPDK_APP_NUM_TRACE_USER_THREADS) != 0) {
 		return -1;
 	}
 
@@ -493,6 +499,24 @@ app_setup_trace(struct spdk_app_opts *opts)
 	return 0;
 }
 
+static void
+app_setup_stats(struct spdk_app_opts *opts)
+{
+	char shm_name[64];
+
+	if (opts->shm_id >= 0) {
+		snprintf(shm_name, sizeof(shm_name), "/%s_stats.%d", opts->name, opts->shm_id);
+	} else {
+		snprintf(shm_name, sizeof(shm_name), "/%s_stats.pid%d", opts->name, (int)getpid());
+	}
+
+	/* The statistics are only used by the monitoring tools, so don't fail if they can't be
+	 * exported, the tools fall back to the RPCs then. */
+	if (spdk_reactors_stats_init(shm_name) != 0) {
+		SPDK_WARNLOG("Reactor statistics won't be exported in shared memory\n");
+	}
+}
+
 static void
 bootstrap_fn(void *arg1)
 {
@@ -501,9 +525,9 @@ bootstrap_fn(void *arg1)
 
 	if (g_spdk_app.json_config_file) {
 		g_delay_subsystem_init = false;
-		spdk_subsystem_init_from_json_config(g_spdk_app.json_config_file, g_spdk_app.rpc_addr,
-						     app_start_rpc,
-						     NULL, !g_spdk_app.json_config_ignore_errors);
+		spdk_subsystem_init_from_json_config_ext(g_spdk_app.json_config_file,
+				g_spdk_app.rpc_addr, g_spdk_app.json_config_max_parallel,
+				app_start_rpc, NULL, !g_spdk_app.json_config_ignore_errors);
 	} else {
 		if (!g_delay_subsystem_init) {
 			spdk_subsystem_init(app_start_rpc, NULL);
@@ -567,10 +591,11 @@ app_copy_opts(struct spdk_app_opts *opts, struct spdk_app_opts *opts_user, size_
 	SET_FIELD(vf_token);
 	SET_FIELD(rpc_log_file);
 	SET_FIELD(rpc_log_level);
+	SET_FIELD(json_config_max_parallel);
 
 	/* You should not remove this statement, but need to update the assert statement
 	 * if you add a new field, and also add a corresponding SET_FIELD statement */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 236, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 240, "Incorrect size");
 
 #undef SET_FIELD
 }
@@ -745,6 +770,7 @@ spdk_app_start(struct spdk_app_opts *opts_user, spdk_msg_fn start_fn,
 	memset(&g_spdk_app, 0, sizeof(g_spdk_app));
 	g_spdk_app.json_config_file = opts->json_config_file;
 	g_spdk_app.json_config_ignore_errors = opts->json_config_ignore_errors;
+	g_spdk_app.json_config_max_parallel = opts->json_config_max_parallel;
 	g_spdk_app.rpc_addr = opts->rpc_addr;
 	g_spdk_app.rpc_allowlist = opts->rpc_allowlist;
 	g_spdk_app.rpc_log_file = opts->rpc_log_file;
@@ -813,6 +839,8 @@ spdk_app_start(struct spdk_app_opts *opts_user, spdk_msg_fn start_fn,
 		return 1;
 	}
 
+	app_setup_stats(opts);
+
 	if (!opts->disable_signal_handlers && app_setup_signal_handlers(opts) != 0) {
 		return 1;
 	}
@@ -916,6 +944,10 @@ usage(void (*app_usage)(void))
 	       g_default_opts.json_config_file != NULL ? g_default_opts.json_config_file : "none");
 	printf("     --json-ignore-init-errors\n");
 	printf("                           don't exit on invalid config entry\n");
+	printf("     --json-max-parallel <num>\n");
+	printf("                           max number of config entries executed in parallel\n");
+	printf("                           (default %"PRIu32")\n",
+	       g_default_opts.json_config_max_parallel);
 	printf(" -d, --limit-coredump      do not set max coredump size to RLIM_INFINITY\n");
 	printf(" -g, --single-file-segments\n");
 	printf("                           force creating just one hugetlbfs file\n");
@@ -1141,6 +1173,16 @@ spdk_app_parse_args(int argc, char **argv, struct spdk_app_opts *opts,
 			opts->msg_mempool_size = (size_t)tmp;
 			break;
 
+		case JSON_MAX_PARALLEL_OPT_IDX:
+			tmp = spdk_strtol(optarg, 10);
+			if (tmp <= 0) {
+				SPDK_ERRLOG("Invalid json-max-parallel value %s\n", optarg);
+				goto out;
+			}
+
+			opts->json_config_max_parallel = (uint32_t)tmp;
+			break;
+
 		case NO_PCI_OPT_IDX:
 			opts->no_pci = true;
 			break;
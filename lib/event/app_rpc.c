@@ -5,7 +5,9 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/base64.h"
 #include "spdk/event.h"
+#include "spdk/histogram_data.h"
 #include "spdk/rpc.h"
 #include "spdk/string.h"
 #include "spdk/util.h"
@@ -221,9 +223,36 @@ rpc_thread_get_stats(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("thread_get_stats", rpc_thread_get_stats, SPDK_RPC_RUNTIME)
 
+static void
+rpc_get_poller_histogram(const struct spdk_histogram_data *histogram,
+			 struct spdk_json_write_ctx *w)
+{
+	size_t src_len, dst_len;
+	char *encoded;
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	encoded = malloc(dst_len);
+	if (encoded == NULL) {
+		return;
+	}
+
+	if (spdk_base64_encode(encoded, histogram->bucket, src_len) == 0) {
+		spdk_json_write_named_object_begin(w, "run_time_histogram");
+		spdk_json_write_named_string(w, "histogram", encoded);
+		spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+		spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+		spdk_json_write_object_end(w);
+	}
+
+	free(encoded);
+}
+
 static void
 rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 {
+	const struct spdk_histogram_data *histogram;
 	struct spdk_poller_stats stats;
 	uint64_t period_ticks;
 
@@ -239,6 +268,12 @@ rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 	if (period_ticks) {
 		spdk_json_write_named_uint64(w, "period_ticks", period_ticks);
 	}
+	spdk_json_write_named_uint64(w, "max_run_ticks", stats.max_run_tsc);
+	spdk_json_write_named_uint64(w, "slow_run_count", stats.slow_run_count);
+	histogram = spdk_poller_get_histogram(poller);
+	if (histogram != NULL) {
+		rpc_get_poller_histogram(histogram, w);
+	}
 	spdk_json_write_object_end(w);
 }
 
@@ -292,6 +327,40 @@ rpc_thread_get_pollers(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("thread_get_pollers", rpc_thread_get_pollers, SPDK_RPC_RUNTIME)
 
+struct rpc_poller_timing {
+	bool histograms;
+	uint64_t watchdog_threshold_us;
+};
+
+static const struct spdk_json_object_decoder rpc_poller_timing_decoders[] = {
+	{"histograms", offsetof(struct rpc_poller_timing, histograms), spdk_json_decode_bool},
+	{
+		"watchdog_threshold_us", offsetof(struct rpc_poller_timing, watchdog_threshold_us),
+		spdk_json_decode_uint64, true
+	},
+};
+
+static void
+rpc_thread_set_poller_timing(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_poller_timing req = {};
+
+	if (spdk_json_decode_object(params, rpc_poller_timing_decoders,
+				    SPDK_COUNTOF(rpc_poller_timing_decoders), &req)) {
+		SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		return;
+	}
+
+	spdk_thread_lib_enable_poller_histograms(req.histograms);
+	spdk_thread_lib_set_poller_watchdog(req.watchdog_threshold_us);
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("thread_set_poller_timing", rpc_thread_set_poller_timing, SPDK_RPC_RUNTIME)
+
 static void
 rpc_get_io_channel(struct spdk_io_channel *ch, struct spdk_json_write_ctx *w)
 {
@@ -404,6 +473,7 @@ rpc_framework_get_reactors(struct spdk_jsonrpc_request *request,
 			   const struct spdk_json_val *params)
 {
 	struct rpc_get_stats_ctx *ctx;
+	const char *stats_shm_name;
 
 	if (params) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
@@ -424,6 +494,10 @@ rpc_framework_get_reactors(struct spdk_jsonrpc_request *request,
 
 	spdk_json_write_object_begin(ctx->w);
 	spdk_json_write_named_uint64(ctx->w, "tick_rate", spdk_get_ticks_hz());
+	stats_shm_name = spdk_reactors_get_stats_shm_name();
+	if (stats_shm_name != NULL) {
+		spdk_json_write_named_string(ctx->w, "stats_shm_name", stats_shm_name);
+	}
 	spdk_json_write_named_array_begin(ctx->w, "reactors");
 
 	spdk_for_each_reactor(_rpc_framework_get_reactors, ctx, NULL,
@@ -537,6 +611,38 @@ rpc_framework_get_scheduler(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("framework_get_scheduler", rpc_framework_get_scheduler, SPDK_RPC_RUNTIME)
 
+struct rpc_framework_set_interrupt_spin_time {
+	uint32_t spin_time_us;
+};
+
+static const struct spdk_json_object_decoder rpc_framework_set_interrupt_spin_time_decoders[] = {
+	{
+		"spin_time_us", offsetof(struct rpc_framework_set_interrupt_spin_time, spin_time_us),
+		spdk_json_decode_uint32
+	},
+};
+
+static void
+rpc_framework_set_interrupt_spin_time(struct spdk_jsonrpc_request *request,
+				      const struct spdk_json_val *params)
+{
+	struct rpc_framework_set_interrupt_spin_time req = {};
+
+	if (spdk_json_decode_object(params, rpc_framework_set_interrupt_spin_time_decoders,
+				    SPDK_COUNTOF(rpc_framework_set_interrupt_spin_time_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		return;
+	}
+
+	spdk_reactors_set_interrupt_spin_time(req.spin_time_us);
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("framework_set_interrupt_spin_time", rpc_framework_set_interrupt_spin_time,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
 struct rpc_thread_set_cpumask_ctx {
 	struct spdk_jsonrpc_request *request;
 	struct spdk_cpuset cpumask;
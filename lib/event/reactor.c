@@ -7,8 +7,11 @@
 #include "spdk/likely.h"
 
 #include "spdk_internal/event.h"
+#include "spdk_internal/thread.h"
 #include "spdk_internal/usdt.h"
 
+#include "spdk/app_stats.h"
+#include "spdk/barrier.h"
 #include "spdk/log.h"
 #include "spdk/thread.h"
 #include "spdk/env.h"
@@ -27,6 +30,9 @@
 #endif
 
 #define SPDK_EVENT_BATCH_SIZE		8
+/* Maximum number of event batches executed per notification in interrupt mode */
+#define SPDK_EVENT_INTR_MAX_BATCHES	16
+#define REACTOR_STATS_PERIOD_US		(100 * 1000)
 
 static struct spdk_reactor *g_reactors;
 static uint32_t g_reactor_count;
@@ -35,6 +41,9 @@ static enum spdk_reactor_state	g_reactor_state = SPDK_REACTOR_STATE_UNINITIALIZE
 
 static bool g_framework_context_switch_monitor_enabled = true;
 
+static uint32_t g_reactor_spin_time_us = 0;
+static uint64_t g_reactor_spin_ticks = 0;
+
 static struct spdk_mempool *g_spdk_event_mempool = NULL;
 
 TAILQ_HEAD(, spdk_scheduler) g_scheduler_list
@@ -58,6 +67,12 @@ static void reactor_interrupt_fini(struct spdk_reactor *reactor);
 static pthread_mutex_t g_stopping_reactors_mtx = PTHREAD_MUTEX_INITIALIZER;
 static bool g_stopping_reactors = false;
 
+static struct spdk_app_stats *g_app_stats;
+static char g_app_stats_shm_name[64];
+static uint64_t g_app_stats_period;
+/* Serializes claiming and releasing the thread entries of the statistics shared memory */
+static pthread_mutex_t g_app_stats_mtx = PTHREAD_MUTEX_INITIALIZER;
+
 static struct spdk_scheduler *
 _scheduler_find(const char *name)
 {
@@ -299,6 +314,12 @@ spdk_reactors_fini(void)
 
 	spdk_mempool_free(g_spdk_event_mempool);
 
+	if (g_app_stats != NULL) {
+		munmap(g_app_stats, sizeof(*g_app_stats));
+		shm_unlink(g_app_stats_shm_name);
+		g_app_stats = NULL;
+	}
+
 	free(g_reactors);
 	g_reactors = NULL;
 	free(g_core_infos);
@@ -307,6 +328,31 @@ spdk_reactors_fini(void)
 
 static void _reactor_set_interrupt_mode(void *arg1, void *arg2);
 
+/*
+ * Notify the reactor about new events, unless a notification is already pending, so that a
+ * burst of events only costs a single write to its eventfd.  The flag is cleared by the reactor
+ * after acknowledging the notification and before dequeuing the events.
+ */
+static int
+reactor_notify_events(struct spdk_reactor *reactor)
+{
+	uint64_t notify = 1;
+	int rc;
+
+	if (__atomic_exchange_n(&reactor->events_notified, true, __ATOMIC_SEQ_CST)) {
+		return 0;
+	}
+
+	rc = write(reactor->events_fd, &notify, sizeof(notify));
+	if (rc < 0) {
+		__atomic_store_n(&reactor->events_notified, false, __ATOMIC_SEQ_CST);
+		SPDK_ERRLOG("failed to notify event queue: %s.\n", spdk_strerror(errno));
+		return -errno;
+	}
+
+	return 0;
+}
+
 static void
 _reactor_set_notify_cpuset(void *arg1, void *arg2)
 {
@@ -391,10 +437,7 @@ _reactor_set_interrupt_mode(void *arg1, void *arg2)
 		int rc = 0;
 
 		/* Always trigger spdk_event and resched event in case of race condition */
-		rc = write(target->events_fd, &notify, sizeof(notify));
-		if (rc < 0) {
-			SPDK_ERRLOG("failed to notify event queue: %s.\n", spdk_strerror(errno));
-		}
+		reactor_notify_events(target);
 		rc = write(target->resched_fd, &notify, sizeof(notify));
 		if (rc < 0) {
 			SPDK_ERRLOG("failed to notify reschedule: %s.\n", spdk_strerror(errno));
@@ -514,19 +557,13 @@ spdk_event_call(struct spdk_event *event)
 	 */
 	if (spdk_unlikely(local_reactor == NULL) ||
 	    spdk_unlikely(spdk_cpuset_get_cpu(&local_reactor->notify_cpuset, event->lcore))) {
-		uint64_t notify = 1;
-
-		rc = write(reactor->events_fd, &notify, sizeof(notify));
-		if (rc < 0) {
-			SPDK_ERRLOG("failed to notify event queue: %s.\n", spdk_strerror(errno));
-		}
+		reactor_notify_events(reactor);
 	}
 }
 
 static inline int
-event_queue_run_batch(void *arg)
+_event_queue_run_batch(struct spdk_reactor *reactor)
 {
-	struct spdk_reactor *reactor = arg;
 	size_t count, i;
 	void *events[SPDK_EVENT_BATCH_SIZE];
 	struct spdk_thread *thread;
@@ -541,35 +578,7 @@ event_queue_run_batch(void *arg)
 	memset(events, 0, sizeof(events));
 #endif
 
-	/* Operate event notification if this reactor currently runs in interrupt state */
-	if (spdk_unlikely(reactor->in_interrupt)) {
-		uint64_t notify = 1;
-		int rc;
-
-		/* There may be race between event_acknowledge and another producer's event_notify,
-		 * so event_acknowledge should be applied ahead. And then check for self's event_notify.
-		 * This can avoid event notification missing.
-		 */
-		rc = read(reactor->events_fd, &notify, sizeof(notify));
-		if (rc < 0) {
-			SPDK_ERRLOG("failed to acknowledge event queue: %s.\n", spdk_strerror(errno));
-			return -errno;
-		}
-
-		count = spdk_ring_dequeue(reactor->events, events, SPDK_EVENT_BATCH_SIZE);
-
-		if (spdk_ring_count(reactor->events) != 0) {
-			/* Trigger new notification if there are still events in event-queue waiting for processing. */
-			rc = write(reactor->events_fd, &notify, sizeof(notify));
-			if (rc < 0) {
-				SPDK_ERRLOG("failed to notify event queue: %s.\n", spdk_strerror(errno));
-				return -errno;
-			}
-		}
-	} else {
-		count = spdk_ring_dequeue(reactor->events, events, SPDK_EVENT_BATCH_SIZE);
-	}
-
+	count = spdk_ring_dequeue(reactor->events, events, SPDK_EVENT_BATCH_SIZE);
 	if (count == 0) {
 		return 0;
 	}
@@ -601,6 +610,49 @@ event_queue_run_batch(void *arg)
 	return (int)count;
 }
 
+static inline int
+event_queue_run_batch(void *arg)
+{
+	struct spdk_reactor *reactor = arg;
+	uint64_t notify = 1;
+	int rc, count = 0;
+	uint32_t i;
+
+	if (spdk_likely(!reactor->in_interrupt)) {
+		return _event_queue_run_batch(reactor);
+	}
+
+	/* There may be race between event_acknowledge and another producer's event_notify,
+	 * so event_acknowledge should be applied ahead, followed by allowing the producers to
+	 * notify again.  Only then the events are dequeued, so that an event enqueued after the
+	 * last dequeue always comes with a notification.
+	 */
+	rc = read(reactor->events_fd, &notify, sizeof(notify));
+	if (rc < 0 && errno != EAGAIN) {
+		SPDK_ERRLOG("failed to acknowledge event queue: %s.\n", spdk_strerror(errno));
+		return -errno;
+	}
+	__atomic_store_n(&reactor->events_notified, false, __ATOMIC_SEQ_CST);
+
+	/* Drain the queue rather than waking up again for each batch, within a limit so that the
+	 * threads of the reactor aren't starved.
+	 */
+	for (i = 0; i < SPDK_EVENT_INTR_MAX_BATCHES; i++) {
+		rc = _event_queue_run_batch(reactor);
+		count += rc;
+		if (rc < SPDK_EVENT_BATCH_SIZE) {
+			break;
+		}
+	}
+
+	if (spdk_ring_count(reactor->events) != 0) {
+		/* Trigger new notification if events are still waiting in the event queue. */
+		reactor_notify_events(reactor);
+	}
+
+	return count;
+}
+
 /* 1s */
 #define CONTEXT_SWITCH_MONITOR_PERIOD 1000000
 
@@ -816,6 +868,12 @@ _reactors_scheduler_gather_metrics(void *arg1, void *arg2)
 			core_info->thread_infos[i].thread_id = spdk_thread_get_id(thread);
 			core_info->thread_infos[i].total_stats = lw_thread->total_stats;
 			core_info->thread_infos[i].current_stats = lw_thread->current_stats;
+			spdk_thread_collect_burst_stats(thread,
+							&core_info->thread_infos[i].burst_stats);
+			core_info->thread_infos[i].latency_class =
+				spdk_thread_get_latency_class(thread);
+			core_info->thread_infos[i].numa_affinity =
+				spdk_thread_get_numa_affinity(thread);
 			core_info->threads_count++;
 			assert(core_info->threads_count <= reactor->thread_count);
 			i++;
@@ -840,6 +898,180 @@ _reactors_scheduler_gather_metrics(void *arg1, void *arg2)
 static int _reactor_schedule_thread(struct spdk_thread *thread);
 static uint64_t g_rusage_period;
 
+int
+spdk_reactors_stats_init(const char *shm_name)
+{
+	struct spdk_app_stats *stats;
+	int fd, rc;
+
+	fd = shm_open(shm_name, O_RDWR | O_CREAT, 0600);
+	if (fd < 0) {
+		SPDK_ERRLOG("Could not open stats shm %s: %s\n", shm_name, spdk_strerror(errno));
+		return -errno;
+	}
+
+	if (ftruncate(fd, sizeof(*stats)) != 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Could not truncate stats shm %s: %s\n", shm_name, spdk_strerror(errno));
+		close(fd);
+		shm_unlink(shm_name);
+		return rc;
+	}
+
+	stats = mmap(NULL, sizeof(*stats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	rc = -errno;
+	close(fd);
+	if (stats == MAP_FAILED) {
+		SPDK_ERRLOG("Could not mmap stats shm %s: %s\n", shm_name, spdk_strerror(-rc));
+		shm_unlink(shm_name);
+		return rc;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	stats->tsc_rate = spdk_get_ticks_hz();
+	stats->period_us = REACTOR_STATS_PERIOD_US;
+
+	snprintf(g_app_stats_shm_name, sizeof(g_app_stats_shm_name), "%s", shm_name);
+	g_app_stats_period = REACTOR_STATS_PERIOD_US * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	g_app_stats = stats;
+
+	return 0;
+}
+
+const char *
+spdk_reactors_get_stats_shm_name(void)
+{
+	return g_app_stats != NULL ? g_app_stats_shm_name : NULL;
+}
+
+static struct spdk_app_stats_thread *
+reactor_stats_get_thread(struct spdk_lw_thread *lw_thread)
+{
+	struct spdk_thread *thread = spdk_thread_get_from_ctx(lw_thread);
+	struct spdk_app_stats_thread *entry = NULL;
+	uint32_t i;
+
+	if (spdk_likely(lw_thread->stats_idx != UINT32_MAX)) {
+		return &g_app_stats->threads[lw_thread->stats_idx];
+	}
+
+	pthread_mutex_lock(&g_app_stats_mtx);
+	for (i = 0; i < SPDK_APP_STATS_MAX_THREADS; i++) {
+		if (g_app_stats->threads[i].id == 0) {
+			entry = &g_app_stats->threads[i];
+			entry->seq++;
+			spdk_smp_wmb();
+			entry->id = spdk_thread_get_id(thread);
+			snprintf(entry->name, sizeof(entry->name), "%s",
+				 spdk_thread_get_name(thread));
+			spdk_smp_wmb();
+			entry->seq++;
+			lw_thread->stats_idx = i;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_app_stats_mtx);
+
+	return entry;
+}
+
+static void
+reactor_stats_put_thread(struct spdk_lw_thread *lw_thread)
+{
+	struct spdk_app_stats_thread *entry;
+
+	if (g_app_stats == NULL || lw_thread->stats_idx == UINT32_MAX) {
+		return;
+	}
+
+	entry = &g_app_stats->threads[lw_thread->stats_idx];
+
+	pthread_mutex_lock(&g_app_stats_mtx);
+	entry->seq++;
+	spdk_smp_wmb();
+	entry->id = 0;
+	spdk_smp_wmb();
+	entry->seq++;
+	pthread_mutex_unlock(&g_app_stats_mtx);
+
+	lw_thread->stats_idx = UINT32_MAX;
+}
+
+static void
+reactor_stats_update_thread(struct spdk_lw_thread *lw_thread)
+{
+	struct spdk_thread *thread = spdk_thread_get_from_ctx(lw_thread);
+	struct spdk_app_stats_thread *entry;
+	struct spdk_thread_stats stats = {};
+	struct spdk_cpuset tmp_mask = {};
+	struct spdk_poller *poller;
+	uint64_t active_pollers_count = 0;
+	uint64_t timed_pollers_count = 0;
+	uint64_t paused_pollers_count = 0;
+
+	entry = reactor_stats_get_thread(lw_thread);
+	if (entry == NULL) {
+		return;
+	}
+
+	for (poller = spdk_thread_get_first_active_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_active_poller(poller)) {
+		active_pollers_count++;
+	}
+
+	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_timed_poller(poller)) {
+		timed_pollers_count++;
+	}
+
+	for (poller = spdk_thread_get_first_paused_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_paused_poller(poller)) {
+		paused_pollers_count++;
+	}
+
+	spdk_set_thread(thread);
+	spdk_thread_get_stats(&stats);
+	spdk_set_thread(NULL);
+
+	spdk_cpuset_copy(&tmp_mask, spdk_app_get_core_mask());
+	spdk_cpuset_and(&tmp_mask, spdk_thread_get_cpumask(thread));
+
+	entry->seq++;
+	spdk_smp_wmb();
+	entry->lcore = lw_thread->lcore;
+	snprintf(entry->cpumask, sizeof(entry->cpumask), "%s", spdk_cpuset_fmt(&tmp_mask));
+	entry->busy_tsc = stats.busy_tsc;
+	entry->idle_tsc = stats.idle_tsc;
+	entry->active_pollers_count = active_pollers_count;
+	entry->timed_pollers_count = timed_pollers_count;
+	entry->paused_pollers_count = paused_pollers_count;
+	entry->tsc_start = lw_thread->tsc_start;
+	spdk_smp_wmb();
+	entry->seq++;
+}
+
+static void
+reactor_stats_update(struct spdk_reactor *reactor)
+{
+	struct spdk_app_stats_reactor *entry = &g_app_stats->reactors[reactor->lcore];
+	struct spdk_lw_thread *lw_thread;
+
+	entry->seq++;
+	spdk_smp_wmb();
+	entry->lcore = reactor->lcore;
+	entry->valid = true;
+	entry->in_interrupt = reactor->in_interrupt;
+	entry->busy_tsc = reactor->busy_tsc;
+	entry->idle_tsc = reactor->idle_tsc;
+	entry->tsc = reactor->tsc_last;
+	spdk_smp_wmb();
+	entry->seq++;
+
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		reactor_stats_update_thread(lw_thread);
+	}
+}
+
 static void
 _reactor_remove_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thread *lw_thread)
 {
@@ -867,6 +1099,7 @@ reactor_post_process_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thre
 	if (spdk_unlikely(spdk_thread_is_exited(thread) &&
 			  spdk_thread_is_idle(thread))) {
 		_reactor_remove_lw_thread(reactor, lw_thread);
+		reactor_stats_put_thread(lw_thread);
 		spdk_thread_destroy(thread);
 		return true;
 	}
@@ -885,10 +1118,36 @@ static void
 reactor_interrupt_run(struct spdk_reactor *reactor)
 {
 	int block_timeout = -1; /* _EPOLL_WAIT_FOREVER */
+	uint64_t spin_end;
+
+	/* Keep polling without blocking for a while, so that the notifications arriving soon
+	 * after the last ones don't pay for a wakeup.
+	 */
+	if (g_reactor_spin_ticks > 0) {
+		spin_end = spdk_get_ticks() + g_reactor_spin_ticks;
+		do {
+			if (spdk_fd_group_wait(reactor->fgrp, 0) > 0) {
+				return;
+			}
+		} while (spdk_get_ticks() < spin_end);
+	}
 
 	spdk_fd_group_wait(reactor->fgrp, block_timeout);
 }
 
+void
+spdk_reactors_set_interrupt_spin_time(uint32_t spin_time_us)
+{
+	g_reactor_spin_time_us = spin_time_us;
+	g_reactor_spin_ticks = spin_time_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+}
+
+uint32_t
+spdk_reactors_get_interrupt_spin_time(void)
+{
+	return g_reactor_spin_time_us;
+}
+
 static void
 _reactor_run(struct spdk_reactor *reactor)
 {
@@ -968,6 +1227,12 @@ reactor_run(void *arg)
 			_reactors_scheduler_gather_metrics(NULL, NULL);
 		}
 
+		if (spdk_unlikely(g_app_stats != NULL && reactor->tsc_last >
+				  reactor->last_stats_update + g_app_stats_period)) {
+			reactor_stats_update(reactor);
+			reactor->last_stats_update = reactor->tsc_last;
+		}
+
 		if (g_reactor_state != SPDK_REACTOR_STATE_RUNNING) {
 			break;
 		}
@@ -995,6 +1260,7 @@ reactor_run(void *arg)
 			spdk_set_thread(thread);
 			if (spdk_thread_is_exited(thread)) {
 				_reactor_remove_lw_thread(reactor, lw_thread);
+				reactor_stats_put_thread(lw_thread);
 				spdk_thread_destroy(thread);
 			} else {
 				if (spdk_unlikely(reactor->in_interrupt)) {
@@ -1079,7 +1345,6 @@ _reactors_stop(void *arg1, void *arg2)
 	int rc;
 	struct spdk_reactor *reactor;
 	struct spdk_reactor *local_reactor;
-	uint64_t notify = 1;
 
 	g_reactor_state = SPDK_REACTOR_STATE_EXITING;
 	local_reactor = spdk_reactor_get(spdk_env_get_current_core());
@@ -1092,9 +1357,9 @@ _reactors_stop(void *arg1, void *arg2)
 		if (local_reactor == NULL || spdk_cpuset_get_cpu(&local_reactor->notify_cpuset, i)) {
 			reactor = spdk_reactor_get(i);
 			assert(reactor != NULL);
-			rc = write(reactor->events_fd, &notify, sizeof(notify));
+			rc = reactor_notify_events(reactor);
 			if (rc < 0) {
-				SPDK_ERRLOG("failed to notify event queue for reactor(%u): %s.\n", i, spdk_strerror(errno));
+				SPDK_ERRLOG("failed to notify event queue for reactor(%u)\n", i);
 				continue;
 			}
 		}
@@ -1169,13 +1434,16 @@ _reactor_schedule_thread(struct spdk_thread *thread)
 	uint32_t current_lcore = spdk_env_get_current_core();
 	struct spdk_cpuset polling_cpumask;
 	struct spdk_cpuset valid_cpumask;
+	uint32_t stats_idx;
 
 	cpumask = spdk_thread_get_cpumask(thread);
 
 	lw_thread = spdk_thread_get_ctx(thread);
 	assert(lw_thread != NULL);
 	core = lw_thread->lcore;
+	stats_idx = lw_thread->stats_idx;
 	memset(lw_thread, 0, sizeof(*lw_thread));
+	lw_thread->stats_idx = stats_idx;
 
 	if (current_lcore != SPDK_ENV_LCORE_ID_ANY) {
 		local_reactor = spdk_reactor_get(current_lcore);
@@ -1287,6 +1555,7 @@ reactor_thread_op(struct spdk_thread *thread, enum spdk_thread_op op)
 	case SPDK_THREAD_OP_NEW:
 		lw_thread = spdk_thread_get_ctx(thread);
 		lw_thread->lcore = SPDK_ENV_LCORE_ID_ANY;
+		lw_thread->stats_idx = UINT32_MAX;
 		return _reactor_schedule_thread(thread);
 	case SPDK_THREAD_OP_RESCHED:
 		_reactor_request_thread_reschedule(thread);
@@ -525,6 +525,100 @@ band_cmp(double a_invalidity, double a_wr_cnt,
 	return a_id < b_id;
 }
 
+static uint64_t
+gc_pick_greedy(struct spdk_ftl_dev *dev)
+{
+	double invalidity, max_invalidity = 0.0L;
+	double wr_cnt, max_wr_cnt = 0.0L;
+	uint64_t phys_id = FTL_BAND_PHYS_ID_INVALID;
+	struct ftl_band *band;
+	uint64_t i, band_count;
+
+	band_count = ftl_get_num_bands(dev);
+	for (i = 0; i < band_count; i += dev->num_logical_bands_in_physical) {
+		band = &dev->bands[i];
+
+		/* Calculate entire band physical group invalidity */
+		get_band_phys_info(dev, band->phys_id, &invalidity, &wr_cnt);
+
+		if (invalidity != 0.0L) {
+			if (phys_id == FTL_BAND_PHYS_ID_INVALID ||
+			    band_cmp(invalidity, wr_cnt, max_invalidity, max_wr_cnt,
+				     band->phys_id, phys_id)) {
+				max_wr_cnt = wr_cnt;
+				phys_id = band->phys_id;
+
+				if (invalidity > max_invalidity) {
+					max_invalidity = invalidity;
+				}
+			}
+		}
+	}
+
+	return phys_id;
+}
+
+/* Average number of sequence ids assigned since the relocatable bands of a group were closed */
+static double
+get_band_phys_age(struct spdk_ftl_dev *dev, uint64_t phys_id)
+{
+	struct ftl_band *band;
+	uint64_t band_id = phys_id * dev->num_logical_bands_in_physical;
+	uint64_t count = 0;
+	double age = 0.0L;
+
+	for (; band_id < ftl_get_num_bands(dev); band_id++) {
+		band = &dev->bands[band_id];
+
+		if (phys_id != band->phys_id) {
+			break;
+		}
+
+		if (!is_band_relocateable(band)) {
+			continue;
+		}
+
+		assert(dev->sb->seq_id >= band->md->close_seq_id);
+		age += dev->sb->seq_id - band->md->close_seq_id;
+		count++;
+	}
+
+	return count ? age / count : 0.0L;
+}
+
+static uint64_t
+gc_pick_cost_benefit(struct spdk_ftl_dev *dev)
+{
+	double invalidity, wr_cnt, score, max_score = 0.0L;
+	uint64_t phys_id = FTL_BAND_PHYS_ID_INVALID;
+	struct ftl_band *band;
+	uint64_t i, band_count;
+
+	band_count = ftl_get_num_bands(dev);
+	for (i = 0; i < band_count; i += dev->num_logical_bands_in_physical) {
+		band = &dev->bands[i];
+
+		get_band_phys_info(dev, band->phys_id, &invalidity, &wr_cnt);
+		if (invalidity == 0.0L) {
+			continue;
+		}
+
+		/* Benefit (space reclaimed) times the age of the data, divided by the cost of
+		 * reading the group and writing its valid blocks: (1 - u) * age / (1 + u), where
+		 * u is the utilization.  The age is offset by one, so that the invalidity still
+		 * decides between groups closed just now.  Lower ids win ties.
+		 */
+		score = invalidity * (get_band_phys_age(dev, band->phys_id) + 1.0L) /
+			(2.0L - invalidity);
+		if (phys_id == FTL_BAND_PHYS_ID_INVALID || score > max_score) {
+			max_score = score;
+			phys_id = band->phys_id;
+		}
+	}
+
+	return phys_id;
+}
+
 static void
 band_start_gc(struct spdk_ftl_dev *dev, struct ftl_band *band)
 {
@@ -533,6 +627,9 @@ band_start_gc(struct spdk_ftl_dev *dev, struct ftl_band *band)
 	TAILQ_REMOVE(&dev->shut_bands, band, queue_entry);
 	band->reloc = true;
 
+	dev->stats.gc.bands++;
+	dev->stats.gc.valid_blocks += band->p2l_map.num_valid;
+
 	FTL_DEBUGLOG(dev, "Band to GC, id %u\n", band->id);
 }
 
@@ -570,11 +667,9 @@ ftl_band_reset_gc_iter(struct spdk_ftl_dev *dev)
 struct ftl_band *
 ftl_band_search_next_to_reloc(struct spdk_ftl_dev *dev)
 {
-	double invalidity, max_invalidity = 0.0L;
-	double wr_cnt, max_wr_cnt = 0.0L;
-	uint64_t phys_id = FTL_BAND_PHYS_ID_INVALID;
+	uint64_t phys_id;
 	struct ftl_band *band;
-	uint64_t i, band_count;
+	uint64_t band_count;
 	uint64_t phys_count;
 
 	band = gc_high_priority_band(dev);
@@ -600,24 +695,14 @@ ftl_band_search_next_to_reloc(struct spdk_ftl_dev *dev)
 		return band;
 	}
 
-	for (i = 0; i < band_count; i += phys_count) {
-		band = &dev->bands[i];
-
-		/* Calculate entire band physical group invalidity */
-		get_band_phys_info(dev, band->phys_id, &invalidity, &wr_cnt);
-
-		if (invalidity != 0.0L) {
-			if (phys_id == FTL_BAND_PHYS_ID_INVALID ||
-			    band_cmp(invalidity, wr_cnt, max_invalidity, max_wr_cnt,
-				     band->phys_id, phys_id)) {
-				max_wr_cnt = wr_cnt;
-				phys_id = band->phys_id;
-
-				if (invalidity > max_invalidity) {
-					max_invalidity = invalidity;
-				}
-			}
-		}
+	switch (dev->conf.gc_policy) {
+	case SPDK_FTL_GC_POLICY_COST_BENEFIT:
+		phys_id = gc_pick_cost_benefit(dev);
+		break;
+	case SPDK_FTL_GC_POLICY_GREEDY:
+	default:
+		phys_id = gc_pick_greedy(dev);
+		break;
 	}
 
 	if (FTL_BAND_PHYS_ID_INVALID != phys_id) {
@@ -6,6 +6,7 @@
 #include "spdk/stdinc.h"
 #include "spdk/queue.h"
 #include "spdk/bdev_module.h"
+#include "spdk/bdev_zone.h"
 
 #include "ftl_core.h"
 #include "ftl_band.h"
@@ -21,6 +22,10 @@ write_rq_end(struct spdk_bdev_io *bdev_io, bool success, void *arg)
 				    bdev_io);
 
 	rq->success = success;
+	if (dev->is_zoned && spdk_likely(success)) {
+		/* Appended data is placed by the device, the P2L needs to reflect where it landed */
+		rq->io.addr = spdk_bdev_io_get_append_location(bdev_io);
+	}
 
 	ftl_p2l_ckpt_issue(rq);
 
@@ -35,10 +40,17 @@ ftl_band_rq_bdev_write(void *_rq)
 	struct spdk_ftl_dev *dev = band->dev;
 	int rc;
 
-	rc = spdk_bdev_writev_blocks(dev->base_bdev_desc, dev->base_ioch,
-				     rq->io_vec, rq->io_vec_size,
-				     rq->io.addr, rq->num_blocks,
-				     write_rq_end, rq);
+	if (dev->is_zoned) {
+		rc = spdk_bdev_zone_appendv(dev->base_bdev_desc, dev->base_ioch,
+					    rq->io_vec, rq->io_vec_size,
+					    band->start_addr, rq->num_blocks,
+					    write_rq_end, rq);
+	} else {
+		rc = spdk_bdev_writev_blocks(dev->base_bdev_desc, dev->base_ioch,
+					     rq->io_vec, rq->io_vec_size,
+					     rq->io.addr, rq->num_blocks,
+					     write_rq_end, rq);
+	}
 
 	if (spdk_unlikely(rc)) {
 		if (rc == -ENOMEM) {
@@ -275,11 +287,64 @@ band_open_cb(int status, void *cb_arg)
 	ftl_band_set_state(band, FTL_BAND_STATE_OPEN);
 }
 
+static void
+ftl_band_persist_open_md(struct ftl_band *band)
+{
+	struct ftl_md *md = band->dev->layout.md[FTL_LAYOUT_REGION_TYPE_BAND_MD];
+
+	ftl_md_persist_entry(md, band->id, band->p2l_map.band_dma_md, NULL,
+			     band_open_cb, band, &band->md_persist_entry_ctx);
+}
+
+static void ftl_band_reset_zone(void *_band);
+
+static void
+reset_zone_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct ftl_band *band = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (spdk_unlikely(!success)) {
+#ifdef SPDK_FTL_RETRY_ON_ERROR
+		ftl_band_reset_zone(band);
+		return;
+#else
+		ftl_abort();
+#endif
+	}
+
+	ftl_band_persist_open_md(band);
+}
+
+static void
+ftl_band_reset_zone(void *_band)
+{
+	struct ftl_band *band = _band;
+	struct spdk_ftl_dev *dev = band->dev;
+	int rc;
+
+	rc = spdk_bdev_zone_management(dev->base_bdev_desc, dev->base_ioch, band->start_addr,
+				       SPDK_BDEV_ZONE_RESET, reset_zone_cb, band);
+	if (spdk_unlikely(rc)) {
+		if (rc == -ENOMEM) {
+			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(dev->base_bdev_desc);
+			struct spdk_bdev_io_wait_entry *wait = &band->metadata_rq.io.bdev_io_wait;
+
+			wait->bdev = bdev;
+			wait->cb_fn = ftl_band_reset_zone;
+			wait->cb_arg = band;
+			spdk_bdev_queue_io_wait(bdev, dev->base_ioch, wait);
+		} else {
+			ftl_abort();
+		}
+	}
+}
+
 void
 ftl_band_open(struct ftl_band *band, enum ftl_band_type type)
 {
 	struct spdk_ftl_dev *dev = band->dev;
-	struct ftl_md *md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_BAND_MD];
 	struct ftl_layout_region *region = &dev->layout.region[FTL_LAYOUT_REGION_TYPE_BAND_MD];
 	struct ftl_p2l_map *p2l_map = &band->p2l_map;
 
@@ -299,8 +364,13 @@ ftl_band_open(struct ftl_band *band, enum ftl_band_type type)
 		ftl_abort();
 	}
 
-	ftl_md_persist_entry(md, band->id, p2l_map->band_dma_md, NULL,
-			     band_open_cb, band, &band->md_persist_entry_ctx);
+	if (dev->is_zoned) {
+		/* The zone needs to be rewound before it's written again */
+		ftl_band_reset_zone(band);
+		return;
+	}
+
+	ftl_band_persist_open_md(band);
 }
 
 static void
@@ -407,6 +477,44 @@ ftl_band_free(struct ftl_band *band)
 	/* TODO: The whole band erase code should probably be done here instead */
 }
 
+void
+ftl_band_free_empty(struct spdk_ftl_dev *dev)
+{
+	struct ftl_band *band;
+
+	/*
+	 * The band might have been emptied by a trim which isn't persistent yet, its data would be
+	 * needed to recover the L2P then
+	 */
+	if (spdk_likely(!dev->band_empty) || dev->unmap_qd || dev->halt) {
+		return;
+	}
+
+	TAILQ_FOREACH(band, &dev->shut_bands, queue_entry) {
+		if (!ftl_band_empty(band) || band->reloc || band->owner.cnt || ftl_band_qd(band) ||
+		    FTL_BAND_STATE_CLOSED != band->md->state ||
+		    band->id == dev->sb_shm->gc_info.band_id_high_prio) {
+			continue;
+		}
+
+		/* Freeing the band requires its P2L map, it's released once the band is free */
+		if (ftl_band_alloc_p2l_map(band)) {
+			return;
+		}
+
+		/* There's no valid data to move, so free the band without relocating it */
+		TAILQ_REMOVE(&dev->shut_bands, band, queue_entry);
+		band->reloc = true;
+		FTL_DEBUGLOG(dev, "Freeing empty band, id %u\n", band->id);
+		ftl_band_free(band);
+
+		/* Free one band at a time, the others are picked up by the next calls */
+		return;
+	}
+
+	dev->band_empty = false;
+}
+
 static void
 read_md_cb(struct ftl_basic_rq *brq)
 {
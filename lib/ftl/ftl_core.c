@@ -26,23 +26,36 @@ spdk_ftl_io_size(void)
 	return sizeof(struct ftl_io);
 }
 
+/* Return a read with finished data transfer to the core thread, see ftl_resolve_read() */
+static void
+ftl_read_done(struct ftl_io *io)
+{
+	struct ftl_io_channel *ioch = ftl_io_channel_get_ctx(io->ioch);
+	size_t result  __attribute__((unused));
+
+	result = spdk_ring_enqueue(ioch->read_cq, (void **)&io, 1, NULL);
+	assert(result != 0);
+}
+
 static void
 ftl_io_cmpl_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
 	struct ftl_io *io = cb_arg;
-	struct spdk_ftl_dev *dev = io->dev;
+	struct ftl_io_channel *ioch = ftl_io_channel_get_ctx(io->ioch);
 
-	ftl_stats_bdev_io_completed(dev, FTL_STATS_TYPE_USER, bdev_io);
+	ftl_stats_group_bdev_io_completed(&ioch->read_stats, bdev_io);
 
 	if (spdk_unlikely(!success)) {
 		io->status = -EIO;
 	}
 
-	ftl_trace_completion(dev, io, FTL_TRACE_COMPLETION_DISK);
+	ftl_trace_completion(io->dev, io, FTL_TRACE_COMPLETION_DISK);
 
-	ftl_io_dec_req(io);
+	/* Runs on the IO channel's thread, so the device's inflight counter isn't touched */
+	assert(io->req_cnt > 0);
+	io->req_cnt--;
 	if (ftl_io_done(io)) {
-		ftl_io_complete(io);
+		ftl_read_done(io);
 	}
 
 	spdk_bdev_free_io(bdev_io);
@@ -155,6 +168,10 @@ ftl_invalidate_addr(struct spdk_ftl_dev *dev, ftl_addr addr)
 		assert(p2l_map->num_valid > 0);
 		ftl_bitmap_clear(dev->valid_map, addr);
 		p2l_map->num_valid--;
+
+		if (!p2l_map->num_valid && FTL_BAND_STATE_CLOSED == band->md->state) {
+			dev->band_empty = true;
+		}
 	}
 
 	/* Invalidate open/full band p2l_map entry to keep p2l and l2p
@@ -179,8 +196,7 @@ ftl_get_next_read_addr(struct ftl_io *io, ftl_addr *addr)
 	size_t i;
 	bool addr_cached = false;
 
-	*addr = ftl_l2p_get(dev, ftl_io_current_lba(io));
-	io->map[io->pos] = *addr;
+	*addr = io->map[io->pos];
 
 	/* If the address is invalid, skip it */
 	if (*addr == FTL_ADDR_INVALID) {
@@ -190,7 +206,7 @@ ftl_get_next_read_addr(struct ftl_io *io, ftl_addr *addr)
 	addr_cached = ftl_addr_in_nvc(dev, *addr);
 
 	for (i = 1; i < ftl_io_iovec_len_left(io); ++i) {
-		next_addr = ftl_l2p_get(dev, ftl_io_get_lba(io, io->pos + i));
+		next_addr = io->map[io->pos + i];
 
 		if (next_addr == FTL_ADDR_INVALID) {
 			break;
@@ -207,8 +223,6 @@ ftl_get_next_read_addr(struct ftl_io *io, ftl_addr *addr)
 		if (*addr + i != next_addr) {
 			break;
 		}
-
-		io->map[io->pos + i] = next_addr;
 	}
 
 	return i;
@@ -228,6 +242,7 @@ static void
 ftl_submit_read(struct ftl_io *io)
 {
 	struct spdk_ftl_dev *dev = io->dev;
+	struct ftl_io_channel *ioch = ftl_io_channel_get_ctx(io->ioch);
 	ftl_addr addr;
 	int rc = 0, num_blocks;
 
@@ -247,9 +262,10 @@ ftl_submit_read(struct ftl_io *io)
 		ftl_trace_submission(dev, io, addr, num_blocks);
 
 		if (ftl_addr_in_nvc(dev, addr)) {
-			rc = ftl_nv_cache_read(io, addr, num_blocks, ftl_io_cmpl_cb, io);
+			rc = ftl_nv_cache_read(io, ioch->cache_ioch, addr, num_blocks,
+					       ftl_io_cmpl_cb, io);
 		} else {
-			rc = spdk_bdev_read_blocks(dev->base_bdev_desc, dev->base_ioch,
+			rc = spdk_bdev_read_blocks(dev->base_bdev_desc, ioch->base_ioch,
 						   ftl_io_iovec_addr(io),
 						   addr, num_blocks, ftl_io_cmpl_cb, io);
 		}
@@ -261,10 +277,10 @@ ftl_submit_read(struct ftl_io *io)
 
 				if (ftl_addr_in_nvc(dev, addr)) {
 					bdev = spdk_bdev_desc_get_bdev(dev->nv_cache.bdev_desc);
-					ch = dev->nv_cache.cache_ioch;
+					ch = ioch->cache_ioch;
 				} else {
 					bdev = spdk_bdev_desc_get_bdev(dev->base_bdev_desc);
-					ch = dev->base_ioch;
+					ch = ioch->base_ioch;
 				}
 				io->bdev_io_wait.bdev = bdev;
 				io->bdev_io_wait.cb_fn = _ftl_submit_read;
@@ -276,17 +292,41 @@ ftl_submit_read(struct ftl_io *io)
 			}
 		}
 
-		ftl_io_inc_req(io);
+		io->req_cnt++;
 		ftl_io_advance(io, num_blocks);
 	}
 
 	/* If we didn't have to read anything from the device, */
 	/* complete the request right away */
 	if (ftl_io_done(io)) {
-		ftl_io_complete(io);
+		ftl_read_done(io);
 	}
 }
 
+/*
+ * The L2P is only accessible from the core thread, so the whole read gets translated here. The
+ * data transfer is then submitted and completed on the thread owning the IO channel, using its
+ * own bdev channels, which spreads the bulk of the read path over the submitting threads. The
+ * read comes back to the core thread once it's done, to get verified and unpinned.
+ */
+static void
+ftl_resolve_read(struct ftl_io *io)
+{
+	struct spdk_ftl_dev *dev = io->dev;
+	struct ftl_io_channel *ioch = ftl_io_channel_get_ctx(io->ioch);
+	size_t i, result  __attribute__((unused));
+
+	for (i = 0; i < io->num_blocks; i++) {
+		io->map[i] = ftl_l2p_get(dev, ftl_io_get_lba(io, i));
+	}
+
+	/* Keep the shutdown waiting until the read comes back */
+	dev->num_inflight++;
+
+	result = spdk_ring_enqueue(ioch->read_sq, (void **)&io, 1, NULL);
+	assert(result != 0);
+}
+
 bool
 ftl_needs_reloc(struct spdk_ftl_dev *dev)
 {
@@ -322,7 +362,7 @@ ftl_io_pin_cb(struct spdk_ftl_dev *dev, int status, struct ftl_l2p_pin_ctx *pin_
 	}
 
 	io->flags |= FTL_IO_PINNED;
-	ftl_submit_read(io);
+	ftl_resolve_read(io);
 }
 
 static void
@@ -519,18 +559,22 @@ ftl_io_channel_poll(void *arg)
 	struct ftl_io_channel *ch = arg;
 	void *ios[FTL_IO_QUEUE_BATCH];
 	uint64_t i, count;
+	bool busy;
 
-	count = spdk_ring_dequeue(ch->cq, ios, FTL_IO_QUEUE_BATCH);
-	if (count == 0) {
-		return SPDK_POLLER_IDLE;
+	count = spdk_ring_dequeue(ch->read_sq, ios, FTL_IO_QUEUE_BATCH);
+	for (i = 0; i < count; i++) {
+		ftl_submit_read(ios[i]);
 	}
 
+	busy = count != 0;
+
+	count = spdk_ring_dequeue(ch->cq, ios, FTL_IO_QUEUE_BATCH);
 	for (i = 0; i < count; i++) {
 		struct ftl_io *io = ios[i];
 		io->user_fn(io->cb_ctx, io->status);
 	}
 
-	return SPDK_POLLER_BUSY;
+	return busy || count ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
 static void
@@ -539,6 +583,13 @@ ftl_process_io_channel(struct spdk_ftl_dev *dev, struct ftl_io_channel *ioch)
 	void *ios[FTL_IO_QUEUE_BATCH];
 	size_t count, i;
 
+	count = spdk_ring_dequeue(ioch->read_cq, ios, FTL_IO_QUEUE_BATCH);
+	for (i = 0; i < count; i++) {
+		assert(dev->num_inflight > 0);
+		dev->num_inflight--;
+		ftl_io_complete(ios[i]);
+	}
+
 	count = spdk_ring_dequeue(ioch->sq, ios, FTL_IO_QUEUE_BATCH);
 	if (count == 0) {
 		return;
@@ -550,30 +601,86 @@ ftl_process_io_channel(struct spdk_ftl_dev *dev, struct ftl_io_channel *ioch)
 	}
 }
 
+/* Trims touching more trim metadata blocks persist the whole region instead */
+#define FTL_UNMAP_JOURNAL_MAX_BLOCKS	8
+/* Maximum number of adjacent trims coalesced into one */
+#define FTL_UNMAP_COALESCE_MAX		64
+
+static void
+ftl_process_unmap_complete(struct spdk_ftl_dev *dev, int status)
+{
+	struct ftl_io *io;
+
+	dev->unmap_qd--;
+
+#ifdef SPDK_FTL_RETRY_ON_ERROR
+	if (spdk_unlikely(status)) {
+		/* Requeue the coalesced trims in front of the ones submitted since */
+		TAILQ_CONCAT(&dev->unmap_inflight, &dev->unmap_sq, queue_entry);
+		TAILQ_SWAP(&dev->unmap_inflight, &dev->unmap_sq, ftl_io, queue_entry);
+		return;
+	}
+#endif
+
+	while ((io = TAILQ_FIRST(&dev->unmap_inflight))) {
+		TAILQ_REMOVE(&dev->unmap_inflight, io, queue_entry);
+		if (spdk_unlikely(status)) {
+			io->status = status;
+		}
+		ftl_io_complete(io);
+	}
+}
+
 static void
 ftl_process_unmap_cb(struct spdk_ftl_dev *dev, struct ftl_md *md, int status)
 {
-	struct ftl_io *io = md->owner.cb_ctx;
+	ftl_process_unmap_complete(dev, status);
+}
 
-	io->dev->unmap_qd--;
+static void ftl_persist_unmap_journal(struct spdk_ftl_dev *dev);
+
+static void
+ftl_persist_unmap_journal_cb(int status, void *ctx)
+{
+	struct spdk_ftl_dev *dev = ctx;
 
 	if (spdk_unlikely(status)) {
 #ifdef SPDK_FTL_RETRY_ON_ERROR
-		TAILQ_INSERT_HEAD(&io->dev->unmap_sq, io, queue_entry);
-		return;
+		ftl_md_persist_entry_retry(&dev->unmap_journal.ctx);
 #else
-		io->status = status;
+		ftl_process_unmap_complete(dev, status);
 #endif
+		return;
+	}
+
+	dev->unmap_journal.block++;
+	if (dev->unmap_journal.block < dev->unmap_journal.end) {
+		ftl_persist_unmap_journal(dev);
+	} else {
+		ftl_process_unmap_complete(dev, 0);
 	}
+}
 
-	ftl_io_complete(io);
+/*
+ * Persist only the trim metadata blocks covering the trimmed range. The VSS of each of them
+ * records the whole range, so a partially persisted trim is completed on recovery.
+ */
+static void
+ftl_persist_unmap_journal(struct spdk_ftl_dev *dev)
+{
+	struct ftl_md *md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_TRIM_MD];
+	uint64_t block = dev->unmap_journal.block;
+
+	ftl_md_persist_entry(md, block, (char *)ftl_md_get_buffer(md) + block * FTL_BLOCK_SIZE,
+			     ftl_md_get_vss_buffer(md) + block, ftl_persist_unmap_journal_cb, dev,
+			     &dev->unmap_journal.ctx);
 }
 
 void
 ftl_set_unmap_map(struct spdk_ftl_dev *dev, uint64_t lba, uint64_t num_blocks, uint64_t seq_id)
 {
 	uint64_t first_page, num_pages;
-	uint64_t first_md_block, num_md_blocks, num_pages_in_block;
+	uint64_t first_md_block, last_md_block, num_pages_in_block;
 	uint32_t lbas_in_page = dev->layout.l2p.lbas_in_page;
 	struct ftl_md *md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_TRIM_MD];
 	uint64_t *page = ftl_md_get_buffer(md);
@@ -590,9 +697,9 @@ ftl_set_unmap_map(struct spdk_ftl_dev *dev, uint64_t lba, uint64_t num_blocks, u
 
 	num_pages_in_block = FTL_BLOCK_SIZE / sizeof(*page);
 	first_md_block = first_page / num_pages_in_block;
-	num_md_blocks = spdk_divide_round_up(num_pages, num_pages_in_block);
+	last_md_block = (first_page + num_pages - 1) / num_pages_in_block;
 	page_vss = ftl_md_get_vss_buffer(md) + first_md_block;
-	for (i = first_md_block; i < num_md_blocks; ++i, page_vss++) {
+	for (i = first_md_block; i <= last_md_block; ++i, page_vss++) {
 		page_vss->unmap.start_lba = lba;
 		page_vss->unmap.num_blocks = num_blocks;
 		page_vss->unmap.seq_id = seq_id;
@@ -600,32 +707,64 @@ ftl_set_unmap_map(struct spdk_ftl_dev *dev, uint64_t lba, uint64_t num_blocks, u
 }
 
 static bool
-ftl_process_unmap(struct ftl_io *io)
+ftl_process_unmap(struct spdk_ftl_dev *dev)
 {
-	struct spdk_ftl_dev *dev = io->dev;
 	struct ftl_md *md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_TRIM_MD];
-	uint64_t seq_id;
+	uint32_t lbas_in_page = dev->layout.l2p.lbas_in_page;
+	uint64_t num_pages_in_block = FTL_BLOCK_SIZE / sizeof(uint64_t);
+	uint64_t seq_id, lba, num_blocks;
+	struct ftl_io *io;
+	uint32_t count;
 
 	seq_id = ftl_nv_cache_acquire_trim_seq_id(&dev->nv_cache);
 	if (seq_id == 0) {
 		return false;
 	}
 
+	io = TAILQ_FIRST(&dev->unmap_sq);
+	lba = io->lba;
+	num_blocks = 0;
+
+	/*
+	 * Coalesce the adjacent trims queued one after another (e.g. a discard split by the upper
+	 * layers), so that they're applied and persisted at once
+	 */
+	for (count = 0; io && count < FTL_UNMAP_COALESCE_MAX; count++) {
+		assert(io->type == FTL_IO_UNMAP);
+
+		if (io->lba + io->num_blocks == lba) {
+			lba = io->lba;
+		} else if (io->lba != lba + num_blocks) {
+			break;
+		}
+		num_blocks += io->num_blocks;
+
+		TAILQ_REMOVE(&dev->unmap_sq, io, queue_entry);
+		TAILQ_INSERT_TAIL(&dev->unmap_inflight, io, queue_entry);
+		io = TAILQ_FIRST(&dev->unmap_sq);
+	}
+
 	dev->unmap_in_progress = true;
 	dev->unmap_qd++;
 
-	dev->sb_shm->trim.start_lba = io->lba;
-	dev->sb_shm->trim.num_blocks = io->num_blocks;
+	dev->sb_shm->trim.start_lba = lba;
+	dev->sb_shm->trim.num_blocks = num_blocks;
 	dev->sb_shm->trim.seq_id = seq_id;
 	dev->sb_shm->trim.in_progress = true;
-	ftl_set_unmap_map(dev, io->lba, io->num_blocks, seq_id);
+	ftl_set_unmap_map(dev, lba, num_blocks, seq_id);
 	ftl_debug_inject_unmap_error();
 	dev->sb_shm->trim.in_progress = false;
 
-	md->owner.cb_ctx = io;
-	md->cb = ftl_process_unmap_cb;
+	dev->unmap_journal.block = lba / lbas_in_page / num_pages_in_block;
+	dev->unmap_journal.end = ((lba + num_blocks) / lbas_in_page - 1) / num_pages_in_block + 1;
 
-	ftl_md_persist(md);
+	if (dev->unmap_journal.end - dev->unmap_journal.block > FTL_UNMAP_JOURNAL_MAX_BLOCKS) {
+		md->owner.cb_ctx = dev;
+		md->cb = ftl_process_unmap_cb;
+		ftl_md_persist(md);
+	} else {
+		ftl_persist_unmap_journal(dev);
+	}
 
 	return true;
 }
@@ -651,7 +790,7 @@ ftl_process_io_queue(struct spdk_ftl_dev *dev)
 		io = TAILQ_FIRST(&dev->wr_sq);
 		TAILQ_REMOVE(&dev->wr_sq, io, queue_entry);
 		assert(io->type == FTL_IO_WRITE);
-		if (!ftl_nv_cache_write(io)) {
+		if (!ftl_nv_cache_bypass_write(io) && !ftl_nv_cache_write(io)) {
 			TAILQ_INSERT_HEAD(&dev->wr_sq, io, queue_entry);
 			break;
 		}
@@ -659,19 +798,13 @@ ftl_process_io_queue(struct spdk_ftl_dev *dev)
 	}
 
 	if (!TAILQ_EMPTY(&dev->unmap_sq) && dev->unmap_qd == 0) {
-		io = TAILQ_FIRST(&dev->unmap_sq);
-		TAILQ_REMOVE(&dev->unmap_sq, io, queue_entry);
-		assert(io->type == FTL_IO_UNMAP);
-
 		/*
 		 * Unmap operation requires generating a sequence id for itself, which it gets based on the open chunk
 		 * in nv cache. If there are no open chunks (because we're in the middle of state transition or compaction
 		 * lagged behind), then we need to wait for the nv cache to resolve the situation - it's fine to just put the
 		 * unmap and try again later.
 		 */
-		if (!ftl_process_unmap(io)) {
-			TAILQ_INSERT_HEAD(&dev->unmap_sq, io, queue_entry);
-		} else {
+		if (ftl_process_unmap(dev)) {
 			ftl_add_io_activity(dev);
 		}
 	}
@@ -696,6 +829,7 @@ ftl_core_poller(void *ctx)
 	ftl_writer_run(&dev->writer_user);
 	ftl_writer_run(&dev->writer_gc);
 	ftl_reloc(dev->reloc);
+	ftl_band_free_empty(dev);
 	ftl_nv_cache_process(dev);
 	ftl_l2p_process(dev);
 
@@ -761,22 +895,27 @@ ftl_stats_bdev_io_completed(struct spdk_ftl_dev *dev, enum ftl_stats_type type,
 			    struct spdk_bdev_io *bdev_io)
 {
 	struct ftl_stats_entry *stats_entry = &dev->stats.entries[type];
-	struct ftl_stats_group *stats_group;
-	uint32_t cdw0;
-	int sct;
-	int sc;
 
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
-		stats_group = &stats_entry->read;
+		ftl_stats_group_bdev_io_completed(&stats_entry->read, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
 	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
-		stats_group = &stats_entry->write;
+		ftl_stats_group_bdev_io_completed(&stats_entry->write, bdev_io);
 		break;
 	default:
-		return;
+		break;
 	}
+}
+
+void
+ftl_stats_group_bdev_io_completed(struct ftl_stats_group *stats_group,
+				  struct spdk_bdev_io *bdev_io)
+{
+	uint32_t cdw0;
+	int sct;
+	int sc;
 
 	spdk_bdev_io_get_nvme_status(bdev_io, &cdw0, &sct, &sc);
 
@@ -796,6 +935,16 @@ spdk_ftl_get_io_channel(struct spdk_ftl_dev *dev)
 	return spdk_get_io_channel(dev);
 }
 
+void
+ftl_stats_group_add(struct ftl_stats_group *dst, const struct ftl_stats_group *src)
+{
+	dst->ios += src->ios;
+	dst->blocks += src->blocks;
+	dst->errors.media += src->errors.media;
+	dst->errors.crc += src->errors.crc;
+	dst->errors.other += src->errors.other;
+}
+
 void
 ftl_stats_crc_error(struct spdk_ftl_dev *dev, enum ftl_stats_type type)
 {
@@ -828,7 +977,16 @@ _ftl_get_stats(void *_ctx)
 {
 	struct ftl_get_stats_ctx *stats_ctx = _ctx;
 
+	struct ftl_io_channel *ioch;
+
 	*stats_ctx->stats = stats_ctx->dev->stats;
+	stats_ctx->stats->gc.policy = stats_ctx->dev->conf.gc_policy;
+
+	/* User reads are accounted by the channels they're submitted from */
+	TAILQ_FOREACH(ioch, &stats_ctx->dev->ioch_queue, entry) {
+		ftl_stats_group_add(&stats_ctx->stats->entries[FTL_STATS_TYPE_USER].read,
+				    &ioch->read_stats);
+	}
 
 	if (spdk_thread_send_msg(stats_ctx->thread, _ftl_get_stats_cb, stats_ctx)) {
 		ftl_abort();
@@ -117,6 +117,24 @@ struct spdk_ftl_dev {
 	/* l2p deferred pins list */
 	TAILQ_HEAD(, ftl_l2p_pin_ctx)	l2p_deferred_pins;
 
+	/* Runtime L2P checkpoint, bounding the data replayed by dirty shutdown recovery */
+	struct {
+		enum ftl_l2p_ckpt_state		state;
+
+		/* Sequence ID below which closed bands and chunks don't need to be replayed */
+		uint64_t			seq_id;
+
+		/* Device sequence ID when the last checkpoint was started */
+		uint64_t			dev_seq_id;
+
+		/* Time of the next checkpoint */
+		uint64_t			tsc_next;
+
+		/* Copy of the superblock with the checkpoint, written out by it */
+		struct ftl_superblock		*sb;
+		struct ftl_md_io_entry_ctx	md_ctx;
+	} l2p_ckpt;
+
 	/* Size of the l2p table */
 	uint64_t			num_lbas;
 
@@ -161,12 +179,25 @@ struct spdk_ftl_dev {
 	/* Trim submission queue */
 	TAILQ_HEAD(, ftl_io)		unmap_sq;
 
+	/* Adjacent trims coalesced into the one being persisted */
+	TAILQ_HEAD(, ftl_io)		unmap_inflight;
+
+	/* Range of the trim metadata blocks being persisted by the trim in progress */
+	struct {
+		uint64_t			block;
+		uint64_t			end;
+		struct ftl_md_io_entry_ctx	ctx;
+	} unmap_journal;
+
 	/* Trim valid map */
 	struct ftl_bitmap		*unmap_map;
 	struct ftl_md			*unmap_map_md;
 	size_t				unmap_qd;
 	bool				unmap_in_progress;
 
+	/* Some closed band might have no valid blocks left and can be freed without relocation */
+	bool				band_empty;
+
 	/* Writer for user IOs */
 	struct ftl_writer		writer_user;
 
@@ -209,6 +240,11 @@ void ftl_recover_max_seq(struct spdk_ftl_dev *dev);
 void ftl_stats_bdev_io_completed(struct spdk_ftl_dev *dev, enum ftl_stats_type type,
 				 struct spdk_bdev_io *bdev_io);
 
+void ftl_stats_group_bdev_io_completed(struct ftl_stats_group *stats_group,
+				       struct spdk_bdev_io *bdev_io);
+
+void ftl_stats_group_add(struct ftl_stats_group *dst, const struct ftl_stats_group *src);
+
 void ftl_stats_crc_error(struct spdk_ftl_dev *dev, enum ftl_stats_type type);
 
 int ftl_unmap(struct spdk_ftl_dev *dev, struct ftl_io *io, struct spdk_io_channel *ch,
@@ -214,6 +214,10 @@ ftl_dev_dump_stats(const struct spdk_ftl_dev *dev)
 	FTL_NOTICELOG(dev, "total writes:        %"PRIu64"\n", write_total);
 	FTL_NOTICELOG(dev, "user writes:         %"PRIu64"\n", write_user);
 	FTL_NOTICELOG(dev, "WAF:                 %.4lf\n", waf);
+	FTL_NOTICELOG(dev, "GC policy:           %s\n",
+		      spdk_ftl_gc_policy_get_name(dev->conf.gc_policy));
+	FTL_NOTICELOG(dev, "GC victim bands:     %"PRIu64"\n", dev->stats.gc.bands);
+	FTL_NOTICELOG(dev, "GC victim valid:     %"PRIu64"\n", dev->stats.gc.valid_blocks);
 #ifdef DEBUG
 	FTL_NOTICELOG(dev, "limits:\n");
 	for (i = 0; i < SPDK_FTL_LIMIT_MAX; ++i) {
@@ -52,6 +52,15 @@ struct ftl_io_channel {
 	struct spdk_ring		*sq;
 	/*  Completion queue */
 	struct spdk_ring		*cq;
+	/*  Reads translated by the core thread, with the data transfer to be submitted */
+	struct spdk_ring		*read_sq;
+	/*  Reads with the data transfer done, to be completed on the core thread */
+	struct spdk_ring		*read_cq;
+	/*  Bdev channels used for the reads' data transfers */
+	struct spdk_io_channel		*base_ioch;
+	struct spdk_io_channel		*cache_ioch;
+	/*  Statistics of the reads' data transfers */
+	struct ftl_stats_group		read_stats;
 };
 
 /* General IO descriptor for user requests */
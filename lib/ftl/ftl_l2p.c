@@ -3,6 +3,8 @@
  *   All rights reserved.
  */
 
+#include "spdk/env.h"
+
 #include "ftl_l2p.h"
 #include "ftl_band.h"
 #include "ftl_nv_cache.h"
@@ -17,17 +19,34 @@
 #define FTL_L2P_OP(name)	ftl_l2p_cache_ ## name
 #endif
 
+/* Interval between the runtime L2P checkpoints */
+#define FTL_L2P_CKPT_INTERVAL_SEC	60
 
 int
 ftl_l2p_init(struct spdk_ftl_dev *dev)
 {
+	struct ftl_md *sb_md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_SB];
+
 	TAILQ_INIT(&dev->l2p_deferred_pins);
+
+	dev->l2p_ckpt.sb = spdk_zmalloc(ftl_md_get_buffer_size(sb_md), FTL_BLOCK_SIZE, NULL,
+					SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (!dev->l2p_ckpt.sb) {
+		return -ENOMEM;
+	}
+	dev->l2p_ckpt.state = FTL_L2P_CKPT_IDLE;
+	dev->l2p_ckpt.dev_seq_id = dev->sb->seq_id;
+	dev->l2p_ckpt.tsc_next = spdk_get_ticks() + FTL_L2P_CKPT_INTERVAL_SEC * spdk_get_ticks_hz();
+
 	return FTL_L2P_OP(init)(dev);
 }
 
 void
 ftl_l2p_deinit(struct spdk_ftl_dev *dev)
 {
+	spdk_free(dev->l2p_ckpt.sb);
+	dev->l2p_ckpt.sb = NULL;
+
 	FTL_L2P_OP(deinit)(dev);
 }
 
@@ -99,6 +118,115 @@ ftl_l2p_unmap(struct spdk_ftl_dev *dev, ftl_l2p_cb cb, void *cb_ctx)
 	FTL_L2P_OP(unmap)(dev, cb, cb_ctx);
 }
 
+static void
+l2p_ckpt_persist_cb(int status, void *ctx)
+{
+	struct spdk_ftl_dev *dev = ctx;
+
+	if (status) {
+		FTL_ERRLOG(dev, "L2P checkpoint failed, cannot persist superblock\n");
+	} else {
+		dev->sb->ckpt_seq_id = dev->l2p_ckpt.seq_id;
+		FTL_DEBUGLOG(dev, "L2P checkpoint done, seq id %"PRIu64"\n", dev->l2p_ckpt.seq_id);
+	}
+
+	dev->l2p_ckpt.state = FTL_L2P_CKPT_IDLE;
+}
+
+static void
+l2p_ckpt_flush_cb(struct spdk_ftl_dev *dev, int status, void *ctx)
+{
+	struct ftl_md *md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_SB];
+	struct ftl_superblock *sb = dev->l2p_ckpt.sb;
+
+	if (status || dev->halt) {
+		if (status && status != -ECANCELED) {
+			FTL_ERRLOG(dev, "L2P checkpoint failed, cannot flush L2P\n");
+		}
+		dev->l2p_ckpt.state = FTL_L2P_CKPT_IDLE;
+		return;
+	}
+
+	/* The superblock (e.g. its sequence ID) keeps changing, so persist a consistent copy */
+	memcpy(sb, dev->sb, ftl_md_get_buffer_size(md));
+	sb->ckpt_seq_id = dev->l2p_ckpt.seq_id;
+	sb->header.crc = ftl_superblock_get_crc(sb);
+
+	dev->l2p_ckpt.state = FTL_L2P_CKPT_PERSISTING;
+	ftl_md_persist_entry(md, 0, sb, NULL, l2p_ckpt_persist_cb, dev, &dev->l2p_ckpt.md_ctx);
+}
+
+/*
+ * Get the sequence ID up to which closed bands and chunks don't need to be replayed on top of
+ * the checkpoint.  The P2L maps of open bands and of chunks don't track invalidations, so any of
+ * them could hold stale data, newer than the one in a skipped band.  Each such band and chunk
+ * needs to be opened after all the skipped ones were closed.
+ */
+static uint64_t
+l2p_ckpt_get_seq_id(struct spdk_ftl_dev *dev)
+{
+	struct ftl_nv_cache *nv_cache = &dev->nv_cache;
+	struct ftl_nv_cache_chunk *chunk;
+	struct ftl_band *band;
+	uint64_t seq_id = dev->sb->seq_id;
+	uint64_t i;
+
+	for (i = 0; i < ftl_get_num_bands(dev); i++) {
+		band = &dev->bands[i];
+		if (band->md->state != FTL_BAND_STATE_FREE &&
+		    band->md->state != FTL_BAND_STATE_CLOSED) {
+			seq_id = spdk_min(seq_id, band->md->seq);
+		}
+	}
+
+	for (i = 0; i < nv_cache->chunk_count; i++) {
+		chunk = &nv_cache->chunks[i];
+		if (chunk->md->state != FTL_CHUNK_STATE_FREE) {
+			seq_id = spdk_min(seq_id, chunk->md->seq_id);
+		}
+	}
+
+	return seq_id;
+}
+
+/*
+ * Periodically flushes the dirty L2P pages and records in the superblock which bands and chunks
+ * were closed before, so that dirty shutdown recovery can start from the persisted L2P and only
+ * replay the P2L maps written afterwards.  Updates racing with the flush are always covered by
+ * the replayed bands and chunks.
+ */
+static void
+ftl_l2p_ckpt_process(struct spdk_ftl_dev *dev)
+{
+	uint64_t tsc = spdk_get_ticks();
+	uint64_t seq_id;
+
+	if (spdk_likely(dev->l2p_ckpt.state != FTL_L2P_CKPT_IDLE || tsc < dev->l2p_ckpt.tsc_next)) {
+		return;
+	}
+	dev->l2p_ckpt.tsc_next = tsc + FTL_L2P_CKPT_INTERVAL_SEC * spdk_get_ticks_hz();
+
+	if (dev->halt || dev->unmap_in_progress || dev->sb_shm->trim.in_progress) {
+		/* Unmaps are applied to the L2P pages lazily, wait until they're done */
+		return;
+	}
+
+	if (dev->sb->seq_id == dev->l2p_ckpt.dev_seq_id) {
+		/* No band nor chunk was opened or closed since the last checkpoint */
+		return;
+	}
+
+	seq_id = l2p_ckpt_get_seq_id(dev);
+	if (seq_id <= dev->sb->ckpt_seq_id) {
+		return;
+	}
+
+	dev->l2p_ckpt.dev_seq_id = dev->sb->seq_id;
+	dev->l2p_ckpt.seq_id = seq_id;
+	dev->l2p_ckpt.state = FTL_L2P_CKPT_FLUSHING;
+	FTL_L2P_OP(checkpoint)(dev, l2p_ckpt_flush_cb, NULL);
+}
+
 void
 ftl_l2p_process(struct spdk_ftl_dev *dev)
 {
@@ -111,6 +239,7 @@ ftl_l2p_process(struct spdk_ftl_dev *dev)
 	}
 
 	FTL_L2P_OP(process)(dev);
+	ftl_l2p_ckpt_process(dev);
 }
 
 bool
@@ -120,6 +249,11 @@ ftl_l2p_is_halted(struct spdk_ftl_dev *dev)
 		return false;
 	}
 
+	if (dev->l2p_ckpt.state != FTL_L2P_CKPT_IDLE) {
+		/* Halting the L2P cancels the flush, the superblock write needs to finish though */
+		return false;
+	}
+
 	return FTL_L2P_OP(is_halted)(dev);
 }
 
@@ -243,6 +377,62 @@ ftl_l2p_update_base(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr new_addr, f
 	ftl_invalidate_addr(dev, old_addr);
 }
 
+static uint64_t
+get_addr_seq_id(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr addr)
+{
+	struct ftl_band *band;
+	struct ftl_p2l_map_entry *entry;
+
+	if (addr == FTL_ADDR_INVALID) {
+		return get_trim_seq_id(dev, lba);
+	}
+
+	if (ftl_addr_in_nvc(dev, addr)) {
+		return ftl_nv_cache_get_chunk_from_addr(dev, addr)->md->seq_id;
+	}
+
+	/* The P2L map is only kept for the bands being written, data in the other ones has been
+	 * there for longer than any write in progress */
+	band = ftl_band_from_addr(dev, addr);
+	if (!band->p2l_map.band_map) {
+		return 0;
+	}
+
+	entry = &band->p2l_map.band_map[ftl_band_block_offset_from_addr(band, addr)];
+	return entry->lba == lba ? entry->seq_id : 0;
+}
+
+void
+ftl_l2p_update_bypass(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr new_addr, ftl_addr old_addr,
+		      uint64_t seq_id)
+{
+	ftl_addr current_addr;
+
+	/* Updating L2P for user data written directly to the base device. Unlike compaction and GC,
+	 * the data is newer than the one it replaces, so if the address has changed during IO, the
+	 * one with the higher sequence id is kept, the same way as during dirty shutdown recovery.
+	 */
+	assert(ftl_check_core_thread(dev));
+	assert(new_addr != FTL_ADDR_INVALID);
+	assert(!ftl_addr_in_nvc(dev, new_addr));
+
+	current_addr = ftl_l2p_get(dev, lba);
+
+	if ((current_addr != old_addr || current_addr == FTL_ADDR_INVALID) &&
+	    get_addr_seq_id(dev, lba, current_addr) > seq_id) {
+		ftl_invalidate_addr(dev, new_addr);
+		return;
+	}
+
+	/* DO NOT CHANGE ORDER - START */
+	ftl_band_set_addr(ftl_band_from_addr(dev, new_addr), lba, new_addr);
+	ftl_l2p_set(dev, lba, new_addr);
+	if (current_addr != FTL_ADDR_INVALID) {
+		ftl_invalidate_addr(dev, current_addr);
+	}
+	/* DO NOT CHANGE ORDER - END */
+}
+
 void
 ftl_l2p_pin_complete(struct spdk_ftl_dev *dev, int status, struct ftl_l2p_pin_ctx *pin_ctx)
 {
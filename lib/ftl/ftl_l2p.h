@@ -16,6 +16,14 @@ struct ftl_rq;
 struct ftl_io;
 struct ftl_l2p_pin_ctx;
 
+enum ftl_l2p_ckpt_state {
+	FTL_L2P_CKPT_IDLE,
+	/* Flushing the L2P pages which were dirty when the checkpoint started */
+	FTL_L2P_CKPT_FLUSHING,
+	/* Persisting the superblock with the checkpoint */
+	FTL_L2P_CKPT_PERSISTING,
+};
+
 typedef void (*ftl_l2p_cb)(struct spdk_ftl_dev *dev, int status, void *ctx);
 typedef void (*ftl_l2p_pin_cb)(struct spdk_ftl_dev *dev, int status,
 			       struct ftl_l2p_pin_ctx *pin_ctx);
@@ -53,6 +61,8 @@ void ftl_l2p_update_cache(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr new_a
 			  ftl_addr old_addr);
 void ftl_l2p_update_base(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr new_addr,
 			 ftl_addr old_addr);
+void ftl_l2p_update_bypass(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr new_addr,
+			   ftl_addr old_addr, uint64_t seq_id);
 
 void ftl_l2p_pin_complete(struct spdk_ftl_dev *dev, int status, struct ftl_l2p_pin_ctx *pin_ctx);
 
@@ -46,8 +46,13 @@ struct ftl_l2p_page {
 	uint64_t pin_ref_cnt;
 	struct ftl_l2p_cache_page_io_ctx ctx;
 	bool on_lru_list;
+	/* Page was referenced again after being loaded, it's kept on the protected list */
+	bool hot;
+	/* Page was loaded by prefetch and hasn't been pinned since */
+	bool prefetched;
+	/* Page is being flushed by a checkpoint and is kept resident afterwards */
+	bool ckpt;
 	void *page_buffer;
-	uint64_t ckpt_seq_id;
 	ftl_df_obj_id obj_id;
 };
 
@@ -99,6 +104,32 @@ struct ftl_l2p_cache_process_ctx {
 	uint64_t qd;
 };
 
+/* Number of sequential streams tracked at once, so that interleaved streams (e.g. user IO and
+ * compaction) don't break each other's detection */
+#define FTL_L2P_CACHE_STREAMS		4
+/* Number of consecutive pages pinned by a stream before pages ahead of it are prefetched */
+#define FTL_L2P_CACHE_PREFETCH_TRIGGER	2
+/* Number of pages prefetched ahead of a sequential stream */
+#define FTL_L2P_CACHE_PREFETCH_PAGES	8
+/* Max number of page reads in flight, for which prefetch is still allowed */
+#define FTL_L2P_CACHE_PREFETCH_QD	64
+/* Percentage of resident pages which can be kept on the protected list */
+#define FTL_L2P_CACHE_PROTECTED_RATIO	75
+/* Max number of page writes in flight issued by a checkpoint */
+#define FTL_L2P_CACHE_CKPT_QD		64
+/* Number of pages checked by a checkpoint during a single poll */
+#define FTL_L2P_CACHE_CKPT_SCAN		1024
+
+struct ftl_l2p_cache_stream {
+	/* Last page pinned by the stream */
+	uint64_t last_page;
+	/* Number of consecutive pages pinned */
+	uint64_t length;
+	/* Range of pages left to prefetch */
+	uint64_t prefetch_page;
+	uint64_t prefetch_end;
+};
+
 struct ftl_l2p_cache {
 	struct spdk_ftl_dev *dev;
 	struct ftl_l2p_l1_map_entry *l2_mapping;
@@ -107,7 +138,19 @@ struct ftl_l2p_cache {
 	struct ftl_mempool *l2_ctx_pool;
 	struct ftl_md *l1_md;
 
+	/* Segmented LRU: pages referenced once since being loaded are kept on the probation list,
+	 * which is evicted first, so that scans don't push out the pages which are reused.  Pages
+	 * referenced again are moved to the protected list, whose size is capped, so that pages
+	 * falling off its end get another chance on the probation list.
+	 */
 	TAILQ_HEAD(l2p_lru_list, ftl_l2p_page) lru_list;
+	struct l2p_lru_list protected_list;
+	uint32_t protected_cnt;
+	uint32_t protected_max;
+
+	struct ftl_l2p_cache_stream streams[FTL_L2P_CACHE_STREAMS];
+	uint32_t stream_victim;
+
 	/* TODO: A lot of / and % operations are done on this value, consider adding a shift based field and calculactions instead */
 	uint64_t lbas_in_page;
 	uint64_t num_pages;		/* num pages to hold the entire L2P */
@@ -132,6 +175,18 @@ struct ftl_l2p_cache {
 		struct ftl_l2p_pin_ctx pin_ctx;
 	} lazy_unmap;
 
+	/* Runtime checkpoint, flushes the pages which are dirty when it's started */
+	struct {
+		bool in_progress;
+		/* Next page to check */
+		uint64_t page_no;
+		/* Page writes in flight */
+		uint32_t qd;
+		int status;
+		ftl_l2p_cb cb;
+		void *cb_ctx;
+	} ckpt;
+
 	/* This is a context for a management process */
 	struct ftl_l2p_cache_process_ctx mctx;
 
@@ -155,6 +210,8 @@ static void page_set_end(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
 			 struct ftl_l2p_page_set *page_set);
 static void page_out_io_retry(void *arg);
 static void page_in_io_retry(void *arg);
+static void ftl_l2p_cache_ckpt_finish(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
+				      int status);
 
 static inline void
 ftl_l2p_page_queue_wait_ctx(struct ftl_l2p_page *page,
@@ -187,19 +244,42 @@ ftl_l2p_cache_lru_remove_page(struct ftl_l2p_cache *cache, struct ftl_l2p_page *
 	assert(page);
 	assert(page->on_lru_list);
 
-	TAILQ_REMOVE(&cache->lru_list, page, list_entry);
+	if (page->hot) {
+		assert(cache->protected_cnt > 0);
+		TAILQ_REMOVE(&cache->protected_list, page, list_entry);
+		cache->protected_cnt--;
+	} else {
+		TAILQ_REMOVE(&cache->lru_list, page, list_entry);
+	}
 	page->on_lru_list = false;
 }
 
 static void
 ftl_l2p_cache_lru_add_page(struct ftl_l2p_cache *cache, struct ftl_l2p_page *page)
 {
+	struct ftl_l2p_page *demoted;
+
 	assert(page);
 	assert(!page->on_lru_list);
 
-	TAILQ_INSERT_HEAD(&cache->lru_list, page, list_entry);
+	if (!page->hot) {
+		TAILQ_INSERT_HEAD(&cache->lru_list, page, list_entry);
+		page->on_lru_list = true;
+		return;
+	}
 
+	TAILQ_INSERT_HEAD(&cache->protected_list, page, list_entry);
+	cache->protected_cnt++;
 	page->on_lru_list = true;
+
+	if (cache->protected_cnt > cache->protected_max) {
+		/* Give the coldest protected page another chance on the probation list */
+		demoted = TAILQ_LAST(&cache->protected_list, l2p_lru_list);
+		ftl_l2p_cache_lru_remove_page(cache, demoted);
+		demoted->hot = false;
+		TAILQ_INSERT_HEAD(&cache->lru_list, demoted, list_entry);
+		demoted->on_lru_list = true;
+	}
 }
 
 static void
@@ -239,7 +319,9 @@ ftl_l2p_cache_page_remove(struct ftl_l2p_cache *cache, struct ftl_l2p_page *page
 static inline struct ftl_l2p_page *
 ftl_l2p_cache_get_coldest_page(struct ftl_l2p_cache *cache)
 {
-	return TAILQ_LAST(&cache->lru_list, l2p_lru_list);
+	struct ftl_l2p_page *page = TAILQ_LAST(&cache->lru_list, l2p_lru_list);
+
+	return page ? page : TAILQ_LAST(&cache->protected_list, l2p_lru_list);
 }
 
 static inline struct ftl_l2p_page *
@@ -460,6 +542,8 @@ ftl_l2p_cache_init(struct spdk_ftl_dev *dev)
 
 	TAILQ_INIT(&cache->deferred_page_set_list);
 	TAILQ_INIT(&cache->lru_list);
+	TAILQ_INIT(&cache->protected_list);
+	cache->protected_max = spdk_max(max_resident_pgs * FTL_L2P_CACHE_PROTECTED_RATIO / 100, 1);
 
 	cache->l2_ctx_md = ftl_md_create(dev,
 					 spdk_divide_round_up(max_resident_pgs * SPDK_ALIGN_CEIL(sizeof(struct ftl_l2p_page), 64),
@@ -952,6 +1036,10 @@ ftl_l2p_cache_halt(struct spdk_ftl_dev *dev)
 
 	if (cache->state != L2P_CACHE_SHUTDOWN_DONE) {
 		cache->state = L2P_CACHE_IN_SHUTDOWN;
+		if (cache->ckpt.in_progress && !cache->ckpt.qd) {
+			/* Pages aren't processed anymore, so the checkpoint can't complete */
+			ftl_l2p_cache_ckpt_finish(dev, cache, -ECANCELED);
+		}
 		if (!cache->ios_in_flight && !cache->l2_pgs_evicting) {
 			cache->state = L2P_CACHE_SHUTDOWN_DONE;
 		}
@@ -996,6 +1084,43 @@ ftl_l2p_cache_page_is_pinnable(struct ftl_l2p_page *page)
 	return page->state != L2P_CACHE_PAGE_INIT;
 }
 
+/* Returns true if the pages are a continuation of one of the recent sequential streams */
+static bool
+ftl_l2p_cache_stream_update(struct ftl_l2p_cache *cache, uint64_t start, uint64_t end)
+{
+	struct ftl_l2p_cache_stream *stream = NULL;
+	uint64_t i;
+
+	for (i = 0; i < FTL_L2P_CACHE_STREAMS; i++) {
+		if (start - cache->streams[i].last_page <= 1) {
+			stream = &cache->streams[i];
+			break;
+		}
+	}
+
+	if (!stream) {
+		/* Replace the streams in round robin order */
+		stream = &cache->streams[cache->stream_victim];
+		cache->stream_victim = (cache->stream_victim + 1) % FTL_L2P_CACHE_STREAMS;
+
+		stream->last_page = end;
+		stream->length = end - start + 1;
+		stream->prefetch_page = stream->prefetch_end = 0;
+		return false;
+	}
+
+	stream->length += end - stream->last_page;
+	stream->last_page = end;
+
+	if (stream->length >= FTL_L2P_CACHE_PREFETCH_TRIGGER) {
+		stream->prefetch_page = spdk_max(stream->prefetch_page, end + 1);
+		stream->prefetch_end = spdk_min(end + 1 + FTL_L2P_CACHE_PREFETCH_PAGES,
+						cache->num_pages);
+	}
+
+	return true;
+}
+
 void
 ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 {
@@ -1009,6 +1134,7 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 	uint64_t end = (pin_ctx->lba + pin_ctx->count - 1) / cache->lbas_in_page;
 	uint64_t count = end - start + 1;
 	uint64_t i;
+	bool sequential;
 
 	if (spdk_unlikely(count > L2P_MAX_PAGES_TO_PIN)) {
 		ftl_l2p_pin_complete(dev, -E2BIG, pin_ctx);
@@ -1023,6 +1149,7 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 		return;
 	}
 	ftl_l2p_cache_init_page_set(page_set, pin_ctx);
+	sequential = ftl_l2p_cache_stream_update(cache, start, end);
 
 	struct ftl_l2p_page_wait_ctx *entry = page_set->entry;
 	for (i = start; i <= end; i++, entry++) {
@@ -1037,6 +1164,20 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 		/* Try get page and pin */
 		page = get_l2p_page_by_df_id(cache, i);
 		if (page) {
+			dev->stats.l2p_cache.hits++;
+			if (page->prefetched) {
+				dev->stats.l2p_cache.prefetch_hits++;
+				page->prefetched = false;
+			} else if (!sequential && !page->hot) {
+				/* Referenced again, outside of a scan - protect the page from
+				 * eviction.  It's moved to the protected list once unpinned.
+				 */
+				if (page->on_lru_list) {
+					ftl_l2p_cache_lru_remove_page(cache, page);
+				}
+				page->hot = true;
+			}
+
 			if (ftl_l2p_cache_page_is_pinnable(page)) {
 				/* Page available and we can pin it */
 				page_set->pinned_cnt++;
@@ -1051,6 +1192,7 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 			}
 		} else {
 			/* The page is not in the cache, queue the page_set to page in */
+			dev->stats.l2p_cache.misses++;
 			defer_pin = true;
 		}
 	}
@@ -1229,6 +1371,9 @@ page_in_io_complete(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
 	if (spdk_unlikely(!success)) {
 		ftl_bug(page->on_lru_list);
 		ftl_l2p_cache_page_remove(cache, page);
+	} else if (!page->pin_ref_cnt) {
+		/* Prefetched page nobody's waiting for yet */
+		ftl_l2p_cache_lru_add_page(cache, page);
 	}
 }
 
@@ -1364,6 +1509,42 @@ ftl_l2p_cache_process_page_sets(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *
 	return 0;
 }
 
+static void
+ftl_l2p_cache_process_prefetch(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache)
+{
+	struct ftl_l2p_cache_stream *stream;
+	struct ftl_l2p_page *page;
+	uint64_t i;
+
+	/* Pinning pages has priority over prefetching them */
+	if (!TAILQ_EMPTY(&cache->deferred_page_set_list)) {
+		return;
+	}
+
+	for (i = 0; i < FTL_L2P_CACHE_STREAMS; i++) {
+		stream = &cache->streams[i];
+
+		while (stream->prefetch_page < stream->prefetch_end) {
+			if (cache->l2_pgs_avail <= L2P_MAX_PAGES_TO_PIN ||
+			    cache->ios_in_flight >= FTL_L2P_CACHE_PREFETCH_QD) {
+				return;
+			}
+
+			if (get_l2p_page_by_df_id(cache, stream->prefetch_page)) {
+				stream->prefetch_page++;
+				continue;
+			}
+
+			ftl_add_io_activity(dev);
+
+			page = page_allocate(cache, stream->prefetch_page++);
+			page->prefetched = true;
+			dev->stats.l2p_cache.prefetches++;
+			page_in_io(dev, cache, page);
+		}
+	}
+}
+
 static struct ftl_l2p_page *
 eviction_get_page(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache)
 {
@@ -1395,6 +1576,8 @@ static void
 page_out_io_complete(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
 		     struct ftl_l2p_page *page, bool success)
 {
+	bool ckpt = page->ckpt;
+
 	cache->l2_pgs_evicting--;
 
 	ftl_bug(page->ctx.updates > page->updates);
@@ -1405,7 +1588,16 @@ page_out_io_complete(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
 		page->updates -= page->ctx.updates;
 	}
 
-	if (success && ftl_l2p_cache_page_can_remove(page)) {
+	if (ckpt) {
+		page->ckpt = false;
+		assert(cache->ckpt.qd > 0);
+		cache->ckpt.qd--;
+		if (!success) {
+			cache->ckpt.status = -EIO;
+		}
+	}
+
+	if (success && !ckpt && ftl_l2p_cache_page_can_remove(page)) {
 		ftl_l2p_cache_page_remove(cache, page);
 	} else {
 		if (!page->pin_ref_cnt) {
@@ -1566,6 +1758,78 @@ ftl_l2p_lazy_unmap_process(struct spdk_ftl_dev *dev)
 	ftl_l2p_cache_pin(dev, pin_ctx);
 }
 
+static void
+ftl_l2p_cache_ckpt_finish(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache, int status)
+{
+	cache->ckpt.in_progress = false;
+	cache->ckpt.cb(dev, status, cache->ckpt.cb_ctx);
+}
+
+static void
+ftl_l2p_cache_process_ckpt(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache)
+{
+	struct ftl_l2p_page *page;
+	uint64_t i;
+
+	if (spdk_likely(!cache->ckpt.in_progress)) {
+		return;
+	}
+
+	for (i = 0; i < FTL_L2P_CACHE_CKPT_SCAN; i++) {
+		if (cache->ckpt.page_no == cache->num_pages ||
+		    cache->ckpt.qd == FTL_L2P_CACHE_CKPT_QD) {
+			break;
+		}
+
+		page = get_l2p_page_by_df_id(cache, cache->ckpt.page_no);
+		if (!page || !page->updates || page->state == L2P_CACHE_PAGE_INIT) {
+			/* Page is already persisted */
+			cache->ckpt.page_no++;
+			continue;
+		}
+
+		if (page->state != L2P_CACHE_PAGE_READY) {
+			/* Page is being evicted, check it again once the eviction is done, since it
+			 * could have been updated in the meantime */
+			break;
+		}
+
+		/*
+		 * Pinned pages are flushed too, updates racing with the write are accounted
+		 * for by the page updates counter and are replayed by recovery.
+		 */
+		if (page->on_lru_list) {
+			ftl_l2p_cache_lru_remove_page(cache, page);
+		}
+
+		page->ckpt = true;
+		page->state = L2P_CACHE_PAGE_FLUSHING;
+		page->ctx.updates = page->updates;
+		cache->ckpt.qd++;
+		cache->ckpt.page_no++;
+		page_out_io(dev, cache, page);
+	}
+
+	if (cache->ckpt.page_no == cache->num_pages && !cache->ckpt.qd) {
+		ftl_l2p_cache_ckpt_finish(dev, cache, cache->ckpt.status);
+	}
+}
+
+void
+ftl_l2p_cache_checkpoint(struct spdk_ftl_dev *dev, ftl_l2p_cb cb, void *cb_ctx)
+{
+	struct ftl_l2p_cache *cache = (struct ftl_l2p_cache *)dev->l2p;
+
+	assert(!cache->ckpt.in_progress);
+
+	cache->ckpt.in_progress = true;
+	cache->ckpt.page_no = 0;
+	cache->ckpt.qd = 0;
+	cache->ckpt.status = 0;
+	cache->ckpt.cb = cb;
+	cache->ckpt.cb_ctx = cb_ctx;
+}
+
 void
 ftl_l2p_cache_process(struct spdk_ftl_dev *dev)
 {
@@ -1582,6 +1846,8 @@ ftl_l2p_cache_process(struct spdk_ftl_dev *dev)
 		}
 	}
 
+	ftl_l2p_cache_process_prefetch(dev, cache);
 	ftl_l2p_cache_process_eviction(dev, cache);
+	ftl_l2p_cache_process_ckpt(dev, cache);
 	ftl_l2p_lazy_unmap_process(dev);
 }
@@ -104,6 +104,13 @@ ftl_l2p_flat_persist(struct spdk_ftl_dev *dev, ftl_l2p_cb cb, void *cb_ctx)
 	ftl_md_persist(md);
 }
 
+void
+ftl_l2p_flat_checkpoint(struct spdk_ftl_dev *dev, ftl_l2p_cb cb, void *cb_ctx)
+{
+	/* The metadata is copied out as it's written, any update racing with it is replayed */
+	ftl_l2p_flat_persist(dev, cb, cb_ctx);
+}
+
 static int
 ftl_l2p_flat_init_dram(struct spdk_ftl_dev *dev, struct ftl_l2p_flat *l2p_flat,
 		       size_t l2p_size)
@@ -352,6 +352,23 @@ layout_base_offset(struct spdk_ftl_dev *dev)
 	return addr;
 }
 
+static uint64_t
+setup_layout_base_valid_map(struct spdk_ftl_dev *dev, uint64_t offset)
+{
+	struct ftl_layout *layout = &dev->layout;
+	struct ftl_layout_region *region = &layout->region[FTL_LAYOUT_REGION_TYPE_VALID_MAP];
+
+	region->type = FTL_LAYOUT_REGION_TYPE_VALID_MAP;
+	region->name = "vmap";
+	region->current.version = region->prev.version = 0;
+	region->current.offset = offset;
+	region->current.blocks = blocks_region(dev, spdk_divide_round_up(
+			layout->base.total_blocks + layout->nvc.total_blocks, 8));
+	set_region_bdev_btm(region, dev);
+
+	return offset + region->current.blocks;
+}
+
 static int
 setup_layout_base(struct spdk_ftl_dev *dev)
 {
@@ -371,8 +388,18 @@ setup_layout_base(struct spdk_ftl_dev *dev)
 	 * - superblock
 	 * - data
 	 * - valid map
+	 *
+	 * On zoned devices the metadata needs to be placed in the leading (conventional) zones,
+	 * since it's updated in place, and the data starts at a zone boundary:
+	 * - superblock
+	 * - valid map
+	 * - data
 	 */
 	offset = layout->region[FTL_LAYOUT_REGION_TYPE_SB_BASE].current.blocks;
+	if (dev->is_zoned) {
+		offset = setup_layout_base_valid_map(dev, offset);
+		offset = SPDK_ALIGN_CEIL(offset, ftl_get_num_blocks_in_band(dev));
+	}
 	offset = SPDK_ALIGN_CEIL(offset, data_base_alignment);
 
 	/* Setup data region on base device */
@@ -386,16 +413,9 @@ setup_layout_base(struct spdk_ftl_dev *dev)
 
 	offset += region->current.blocks;
 
-	/* Setup validity map */
-	region = &layout->region[FTL_LAYOUT_REGION_TYPE_VALID_MAP];
-	region->type = FTL_LAYOUT_REGION_TYPE_VALID_MAP;
-	region->name = "vmap";
-	region->current.version = region->prev.version = 0;
-	region->current.offset = offset;
-	region->current.blocks = blocks_region(dev, spdk_divide_round_up(
-			layout->base.total_blocks + layout->nvc.total_blocks, 8));
-	set_region_bdev_btm(region, dev);
-	offset += region->current.blocks;
+	if (!dev->is_zoned) {
+		offset = setup_layout_base_valid_map(dev, offset);
+	}
 
 	/* Checking for underflow */
 	left = layout->base.total_blocks - offset;
@@ -533,6 +553,9 @@ ftl_layout_setup_superblock(struct spdk_ftl_dev *dev)
 #endif
 
 	region->current.blocks = superblock_region_blocks(dev);
+	/* The whole superblock is a single entry, so that it can be persisted from a copy */
+	region->entry_size = region->current.blocks;
+	region->num_entries = 1;
 	region->vss_blksz = 0;
 	region->bdev_desc = dev->nv_cache.bdev_desc;
 	region->ioch = dev->nv_cache.cache_ioch;
@@ -548,6 +571,8 @@ ftl_layout_setup_superblock(struct spdk_ftl_dev *dev)
 	region->prev.version = FTL_SB_VERSION_CURRENT;
 	region->current.offset = 0;
 	region->current.blocks = superblock_region_blocks(dev);
+	region->entry_size = region->current.blocks;
+	region->num_entries = 1;
 	set_region_bdev_btm(region, dev);
 
 	/* Check if SB can be stored at the end of base device */
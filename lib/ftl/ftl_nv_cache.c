@@ -19,6 +19,7 @@
 static inline uint64_t nvc_data_blocks(struct ftl_nv_cache *nv_cache) __attribute__((unused));
 static struct ftl_nv_cache_compactor *compactor_alloc(struct spdk_ftl_dev *dev);
 static void compactor_free(struct spdk_ftl_dev *dev, struct ftl_nv_cache_compactor *compactor);
+static void bypass_write_done(struct ftl_rq *rq);
 static void compaction_process_ftl_done(struct ftl_rq *rq);
 
 static inline const struct ftl_layout_region *
@@ -92,6 +93,7 @@ ftl_nv_cache_init(struct spdk_ftl_dev *dev)
 	struct ftl_nv_cache_chunk *chunk;
 	struct ftl_nv_cache_chunk_md *md;
 	struct ftl_nv_cache_compactor *compactor;
+	struct ftl_rq *rq;
 	uint64_t i, offset;
 
 	nv_cache->halt = true;
@@ -168,7 +170,9 @@ ftl_nv_cache_init(struct spdk_ftl_dev *dev)
 	}
 
 #define FTL_MAX_OPEN_CHUNKS 2
-	nv_cache->p2l_pool = ftl_mempool_create(FTL_MAX_OPEN_CHUNKS,
+/* The maps not used by open chunks let recovery read the tail metadata of more chunks at once */
+#define FTL_NV_CACHE_P2L_MAPS 4
+	nv_cache->p2l_pool = ftl_mempool_create(FTL_NV_CACHE_P2L_MAPS,
 						nv_cache_p2l_map_pool_elem_size(nv_cache),
 						FTL_BLOCK_SIZE,
 						SPDK_ENV_SOCKET_ID_ANY);
@@ -176,8 +180,8 @@ ftl_nv_cache_init(struct spdk_ftl_dev *dev)
 		return -ENOMEM;
 	}
 
-	/* One entry per open chunk */
-	nv_cache->chunk_md_pool = ftl_mempool_create(FTL_MAX_OPEN_CHUNKS,
+	/* One entry per P2L map */
+	nv_cache->chunk_md_pool = ftl_mempool_create(FTL_NV_CACHE_P2L_MAPS,
 				  sizeof(struct ftl_nv_cache_chunk_md),
 				  FTL_BLOCK_SIZE,
 				  SPDK_ENV_SOCKET_ID_ANY);
@@ -199,9 +203,36 @@ ftl_nv_cache_init(struct spdk_ftl_dev *dev)
 
 	nv_cache->throttle.interval_tsc = FTL_NV_CACHE_THROTTLE_INTERVAL_MS *
 					  (spdk_get_ticks_hz() / 1000);
+	nv_cache->compaction_ctrl.compactors_max = FTL_NV_CACHE_NUM_COMPACTORS;
+	nv_cache->compaction_ctrl.read_blocks = UINT64_MAX;
+
+	TAILQ_INIT(&nv_cache->bypass.rq_free);
+	for (i = 0; i < FTL_NV_CACHE_NUM_BYPASS_RQS; i++) {
+		rq = ftl_rq_new(dev, dev->md_size);
+		if (!rq) {
+			FTL_ERRLOG(dev, "Cannot allocate NV cache bypass request\n");
+			return -ENOMEM;
+		}
+
+		rq->owner.cb = bypass_write_done;
+		rq->owner.compaction = true;
+		TAILQ_INSERT_TAIL(&nv_cache->bypass.rq_free, rq, qentry);
+		nv_cache->bypass.rq_free_count++;
+	}
 	nv_cache->chunk_free_target = spdk_divide_round_up(nv_cache->chunk_count *
 				      dev->conf.nv_cache.chunk_free_target,
 				      100);
+
+	nv_cache->temp.num_ranges = spdk_divide_round_up(dev->num_lbas,
+				    FTL_NV_CACHE_TEMP_RANGE_BLOCKS);
+	nv_cache->temp.counters = calloc(nv_cache->temp.num_ranges,
+					 sizeof(nv_cache->temp.counters[0]));
+	if (!nv_cache->temp.counters) {
+		FTL_ERRLOG(dev, "Failed to initialize write temperature counters\n");
+		return -ENOMEM;
+	}
+	nv_cache->temp.aging_interval = dev->num_lbas;
+
 	return 0;
 }
 
@@ -210,6 +241,7 @@ ftl_nv_cache_deinit(struct spdk_ftl_dev *dev)
 {
 	struct ftl_nv_cache *nv_cache = &dev->nv_cache;
 	struct ftl_nv_cache_compactor *compactor;
+	struct ftl_rq *rq;
 
 	while (!TAILQ_EMPTY(&nv_cache->compactor_list)) {
 		compactor = TAILQ_FIRST(&nv_cache->compactor_list);
@@ -218,6 +250,14 @@ ftl_nv_cache_deinit(struct spdk_ftl_dev *dev)
 		compactor_free(dev, compactor);
 	}
 
+	while (!TAILQ_EMPTY(&nv_cache->bypass.rq_free)) {
+		rq = TAILQ_FIRST(&nv_cache->bypass.rq_free);
+		TAILQ_REMOVE(&nv_cache->bypass.rq_free, rq, qentry);
+		nv_cache->bypass.rq_free_count--;
+
+		ftl_rq_del(rq);
+	}
+
 	ftl_mempool_destroy(nv_cache->md_pool);
 	ftl_mempool_destroy(nv_cache->p2l_pool);
 	ftl_mempool_destroy(nv_cache->chunk_md_pool);
@@ -229,6 +269,9 @@ ftl_nv_cache_deinit(struct spdk_ftl_dev *dev)
 
 	free(nv_cache->chunks);
 	nv_cache->chunks = NULL;
+
+	free(nv_cache->temp.counters);
+	nv_cache->temp.counters = NULL;
 }
 
 static uint64_t
@@ -249,6 +292,42 @@ chunk_is_closed(struct ftl_nv_cache_chunk *chunk)
 
 static void ftl_chunk_close(struct ftl_nv_cache_chunk *chunk);
 
+static void
+chunk_skip_free_space(struct ftl_nv_cache *nv_cache, struct ftl_nv_cache_chunk *chunk)
+{
+	uint64_t free_space = chunk_get_free_space(nv_cache, chunk);
+
+	chunk->md->blocks_skipped = free_space;
+	chunk->md->blocks_written += free_space;
+	chunk->md->write_pointer += free_space;
+
+	if (chunk->md->blocks_written == chunk_tail_md_offset(nv_cache)) {
+		ftl_chunk_close(chunk);
+	}
+}
+
+static struct ftl_nv_cache_chunk *
+nv_cache_get_open_chunk(struct ftl_nv_cache *nv_cache)
+{
+	struct ftl_nv_cache_chunk *chunk;
+
+	while ((chunk = TAILQ_FIRST(&nv_cache->chunk_open_list))) {
+		if (chunk->md->state != FTL_CHUNK_STATE_OPEN) {
+			return NULL;
+		}
+
+		if (spdk_likely(chunk->md->seq_id > nv_cache->bypass.seq_id)) {
+			return chunk;
+		}
+
+		/* Data written to the chunk would be older than the one written around the cache */
+		TAILQ_REMOVE(&nv_cache->chunk_open_list, chunk, entry);
+		chunk_skip_free_space(nv_cache, chunk);
+	}
+
+	return NULL;
+}
+
 static uint64_t
 ftl_nv_cache_get_wr_buffer(struct ftl_nv_cache *nv_cache, struct ftl_io *io)
 {
@@ -265,8 +344,8 @@ ftl_nv_cache_get_wr_buffer(struct ftl_nv_cache *nv_cache, struct ftl_io *io)
 		}
 
 		if (!chunk) {
-			chunk = TAILQ_FIRST(&nv_cache->chunk_open_list);
-			if (chunk && chunk->md->state == FTL_CHUNK_STATE_OPEN) {
+			chunk = nv_cache_get_open_chunk(nv_cache);
+			if (chunk) {
 				TAILQ_REMOVE(&nv_cache->chunk_open_list, chunk, entry);
 				nv_cache->chunk_current = chunk;
 			} else {
@@ -297,13 +376,7 @@ ftl_nv_cache_get_wr_buffer(struct ftl_nv_cache *nv_cache, struct ftl_io *io)
 			continue;
 		}
 
-		chunk->md->blocks_skipped = free_space;
-		chunk->md->blocks_written += free_space;
-		chunk->md->write_pointer += free_space;
-
-		if (chunk->md->blocks_written == chunk_tail_md_offset(nv_cache)) {
-			ftl_chunk_close(chunk);
-		}
+		chunk_skip_free_space(nv_cache, chunk);
 	} while (1);
 
 	return address;
@@ -533,6 +606,42 @@ chunk_compaction_advance(struct ftl_nv_cache_chunk *chunk, uint64_t num_blocks)
 	ftl_chunk_free(chunk);
 }
 
+static void
+temp_record_write(struct ftl_nv_cache *nv_cache, uint64_t lba, uint64_t num_blocks)
+{
+	uint64_t end = lba + num_blocks, range, blocks, i;
+	uint16_t *counter;
+
+	while (lba < end) {
+		range = lba / FTL_NV_CACHE_TEMP_RANGE_BLOCKS;
+		blocks = spdk_min(end, (range + 1) * FTL_NV_CACHE_TEMP_RANGE_BLOCKS) - lba;
+		counter = &nv_cache->temp.counters[range];
+		*counter = spdk_min(UINT16_MAX, *counter + blocks);
+		lba += blocks;
+	}
+
+	/* Age the counters, so that they reflect the recent writes */
+	nv_cache->temp.writes += num_blocks;
+	if (nv_cache->temp.writes >= nv_cache->temp.aging_interval) {
+		for (i = 0; i < nv_cache->temp.num_ranges; i++) {
+			nv_cache->temp.counters[i] /= 2;
+		}
+		nv_cache->temp.writes = 0;
+	}
+}
+
+static bool
+temp_is_cold(struct spdk_ftl_dev *dev, uint64_t lba)
+{
+	/* Leave the GC bands to relocation once free bands start running out */
+	if (dev->limit <= SPDK_FTL_LIMIT_HIGH) {
+		return false;
+	}
+
+	return dev->nv_cache.temp.counters[lba / FTL_NV_CACHE_TEMP_RANGE_BLOCKS] <=
+	       FTL_NV_CACHE_TEMP_COLD_MAX;
+}
+
 static bool
 is_compaction_required(struct ftl_nv_cache *nv_cache)
 {
@@ -742,9 +851,8 @@ compaction_submit_read(struct ftl_nv_cache_compactor *compactor, ftl_addr addr,
 }
 
 static void
-compaction_process_pad(struct ftl_nv_cache_compactor *compactor)
+compaction_process_pad(struct ftl_rq *wr)
 {
-	struct ftl_rq *wr = compactor->wr;
 	const uint64_t num_entries = wr->num_blocks;
 	struct ftl_rq_entry *iter;
 
@@ -783,7 +891,7 @@ compaction_process(struct ftl_nv_cache_compactor *compactor)
 	chunk = get_chunk_for_compaction(nv_cache);
 	if (!chunk) {
 		/* No chunks to compact, pad this request */
-		compaction_process_pad(compactor);
+		compaction_process_pad(compactor->wr);
 		ftl_writer_queue_rq(&dev->writer_user, compactor->wr);
 		return;
 	}
@@ -821,6 +929,7 @@ compaction_process(struct ftl_nv_cache_compactor *compactor)
 
 	addr = begin;
 	to_read = spdk_min(to_read, compactor->rd->num_blocks);
+	to_read = spdk_min(to_read, nv_cache->compaction_ctrl.read_blocks);
 
 	/* Read data and metadata from NV cache */
 	rc = compaction_submit_read(compactor, addr, to_read);
@@ -849,6 +958,14 @@ compaction_process_start(struct ftl_nv_cache_compactor *compactor)
 	compaction_process(compactor);
 }
 
+static struct ftl_writer *
+compaction_writer(struct ftl_nv_cache_compactor *compactor, struct ftl_rq *wr)
+{
+	struct spdk_ftl_dev *dev = wr->dev;
+
+	return wr == compactor->wr_cold ? &dev->writer_gc : &dev->writer_user;
+}
+
 static void
 compaction_process_ftl_done(struct ftl_rq *rq)
 {
@@ -863,7 +980,7 @@ compaction_process_ftl_done(struct ftl_rq *rq)
 	if (spdk_unlikely(false == rq->success)) {
 		/* IO error retry writing */
 #ifdef SPDK_FTL_RETRY_ON_ERROR
-		ftl_writer_queue_rq(&dev->writer_user, rq);
+		ftl_writer_queue_rq(compaction_writer(compactor, rq), rq);
 		return;
 #else
 		ftl_abort();
@@ -888,9 +1005,17 @@ compaction_process_ftl_done(struct ftl_rq *rq)
 		addr = ftl_band_next_addr(band, addr, 1);
 	}
 
-	compactor->wr->iter.idx = 0;
+	rq->iter.idx = 0;
 
-	if (is_compaction_required(nv_cache)) {
+	/* The cold request was padded while the other one was being written */
+	if (compactor->wr_cold->iter.idx == compactor->wr_cold->num_blocks) {
+		compactor->cold_wait = 0;
+		ftl_writer_queue_rq(&dev->writer_gc, compactor->wr_cold);
+		return;
+	}
+
+	if (is_compaction_required(nv_cache) &&
+	    nv_cache->compaction_active_count <= nv_cache->compaction_ctrl.compactors_max) {
 		compaction_process(compactor);
 	} else {
 		compactor_deactivate(compactor);
@@ -901,11 +1026,13 @@ static void
 compaction_process_finish_read(struct ftl_nv_cache_compactor *compactor)
 {
 	struct ftl_rq *wr = compactor->wr;
+	struct ftl_rq *wr_cold = compactor->wr_cold;
 	struct ftl_rq *rd = compactor->rd;
 	ftl_addr cache_addr = rd->io.addr;
 	struct ftl_nv_cache_chunk *chunk = rd->owner.priv;
 	struct spdk_ftl_dev *dev;
 	struct ftl_rq_entry *iter;
+	struct ftl_rq *target;
 	union ftl_md_vss *md;
 	ftl_addr current_addr;
 	const uint64_t num_entries = wr->num_blocks;
@@ -918,12 +1045,13 @@ compaction_process_finish_read(struct ftl_nv_cache_compactor *compactor)
 			       struct spdk_ftl_dev, nv_cache);
 
 	assert(wr->iter.idx < num_entries);
+	assert(wr_cold->iter.idx < num_entries);
 	assert(rd->iter.idx < rd->iter.count);
 
 	cache_addr += rd->iter.idx;
-	iter = &wr->entries[wr->iter.idx];
 
-	while (wr->iter.idx < num_entries && rd->iter.idx < rd->iter.count) {
+	while (wr->iter.idx < num_entries && wr_cold->iter.idx < num_entries &&
+	       rd->iter.idx < rd->iter.count) {
 		/* Get metadata */
 		md = rd->entries[rd->iter.idx].io_md;
 		if (md->nv_cache.lba == FTL_LBA_INVALID || md->nv_cache.seq_id != chunk->md->seq_id) {
@@ -935,8 +1063,12 @@ compaction_process_finish_read(struct ftl_nv_cache_compactor *compactor)
 
 		current_addr = ftl_l2p_get(dev, md->nv_cache.lba);
 		if (current_addr == cache_addr) {
+			/* Keep cold data apart from the hot one */
+			target = temp_is_cold(dev, md->nv_cache.lba) ? wr_cold : wr;
+			iter = &target->entries[target->iter.idx];
+
 			/* Swap payload */
-			ftl_rq_swap_payload(wr, wr->iter.idx, rd, rd->iter.idx);
+			ftl_rq_swap_payload(target, target->iter.idx, rd, rd->iter.idx);
 
 			/*
 			 * Address still the same, we may continue to compact it
@@ -949,8 +1081,7 @@ compaction_process_finish_read(struct ftl_nv_cache_compactor *compactor)
 			iter->seq_id = chunk->md->seq_id;
 
 			/* Advance within batch */
-			iter++;
-			wr->iter.idx++;
+			target->iter.idx++;
 		} else {
 			/* This address already invalidated, just omit this block */
 			chunk_compaction_advance(chunk, 1);
@@ -967,6 +1098,17 @@ compaction_process_finish_read(struct ftl_nv_cache_compactor *compactor)
 		 * Request contains data to be placed on FTL, compact it
 		 */
 		ftl_writer_queue_rq(&dev->writer_user, wr);
+
+		/*
+		 * Don't hold the cold data, along with the chunks it comes from, for too long if
+		 * little of it is written
+		 */
+		if (wr_cold->iter.idx && ++compactor->cold_wait >= FTL_NV_CACHE_TEMP_COLD_MAX_WAIT) {
+			compaction_process_pad(wr_cold);
+		}
+	} else if (num_entries == wr_cold->iter.idx) {
+		compactor->cold_wait = 0;
+		ftl_writer_queue_rq(&dev->writer_gc, wr_cold);
 	} else {
 		if (is_compaction_required(compactor->nv_cache)) {
 			compaction_process(compactor);
@@ -984,6 +1126,7 @@ compactor_free(struct spdk_ftl_dev *dev, struct ftl_nv_cache_compactor *compacto
 	}
 
 	ftl_rq_del(compactor->wr);
+	ftl_rq_del(compactor->wr_cold);
 	ftl_rq_del(compactor->rd);
 	free(compactor);
 }
@@ -1004,6 +1147,12 @@ compactor_alloc(struct spdk_ftl_dev *dev)
 		goto error;
 	}
 
+	/* Allocate help request for writing cold data */
+	compactor->wr_cold = ftl_rq_new(dev, dev->md_size);
+	if (!compactor->wr_cold) {
+		goto error;
+	}
+
 	/* Allocate help request for reading */
 	compactor->rd = ftl_rq_new(dev, dev->nv_cache.md_size);
 	if (!compactor->rd) {
@@ -1014,6 +1163,9 @@ compactor_alloc(struct spdk_ftl_dev *dev)
 	compactor->wr->owner.priv = compactor;
 	compactor->wr->owner.cb = compaction_process_ftl_done;
 	compactor->wr->owner.compaction = true;
+	compactor->wr_cold->owner.priv = compactor;
+	compactor->wr_cold->owner.cb = compaction_process_ftl_done;
+	compactor->wr_cold->owner.compaction = true;
 
 	return compactor;
 
@@ -1030,6 +1182,9 @@ ftl_nv_cache_submit_cb_done(struct ftl_io *io)
 	chunk_advance_blocks(nv_cache, io->nv_cache_chunk, io->num_blocks);
 	io->nv_cache_chunk = NULL;
 
+	assert(nv_cache->bypass.user_blocks_inflight >= io->num_blocks);
+	nv_cache->bypass.user_blocks_inflight -= io->num_blocks;
+
 	ftl_mempool_put(nv_cache->md_pool, io->md);
 	ftl_io_complete(io);
 }
@@ -1141,8 +1296,10 @@ ftl_nv_cache_write(struct ftl_io *io)
 	}
 	io->addr = ftl_addr_from_nvc_offset(dev, cache_offset);
 	io->nv_cache_chunk = dev->nv_cache.chunk_current;
+	dev->nv_cache.bypass.user_blocks_inflight += io->num_blocks;
 
 	ftl_nv_cache_fill_md(io);
+	temp_record_write(&dev->nv_cache, io->lba, io->num_blocks);
 	ftl_l2p_pin(io->dev, io->lba, io->num_blocks,
 		    ftl_nv_cache_pin_cb, io,
 		    &io->l2p_pin_ctx);
@@ -1152,16 +1309,148 @@ ftl_nv_cache_write(struct ftl_io *io)
 	return true;
 }
 
+static void
+bypass_rq_put(struct ftl_nv_cache *nv_cache, struct ftl_rq *rq)
+{
+	rq->owner.priv = NULL;
+	TAILQ_INSERT_HEAD(&nv_cache->bypass.rq_free, rq, qentry);
+	nv_cache->bypass.rq_free_count++;
+}
+
+static void
+bypass_write_done(struct ftl_rq *rq)
+{
+	struct spdk_ftl_dev *dev = rq->dev;
+	struct ftl_io *io = rq->owner.priv;
+	struct ftl_band *band = rq->io.band;
+	struct ftl_rq_entry *entry;
+	ftl_addr addr;
+	uint64_t i;
+
+	if (spdk_unlikely(false == rq->success)) {
+		/* IO error retry writing */
+#ifdef SPDK_FTL_RETRY_ON_ERROR
+		ftl_writer_queue_rq(&dev->writer_user, rq);
+		return;
+#else
+		ftl_abort();
+#endif
+	}
+
+	addr = rq->io.addr;
+	for (i = 0, entry = rq->entries; i < rq->num_blocks; i++, entry++) {
+		ftl_l2p_update_bypass(dev, entry->lba, addr, entry->addr, entry->seq_id);
+		addr = ftl_band_next_addr(band, addr, 1);
+	}
+
+	ftl_l2p_unpin(dev, io->lba, io->num_blocks);
+	bypass_rq_put(&dev->nv_cache, rq);
+	ftl_io_complete(io);
+}
+
+static void
+bypass_pin_cb(struct spdk_ftl_dev *dev, int status, struct ftl_l2p_pin_ctx *pin_ctx)
+{
+	struct ftl_rq *rq = pin_ctx->cb_ctx;
+	struct ftl_io *io = rq->owner.priv;
+	uint64_t i;
+
+	if (spdk_unlikely(status != 0)) {
+		/* Retry on the internal L2P fault */
+		FTL_ERRLOG(dev, "Cannot PIN LBA for NV cache bypass write failed at %"PRIx64"\n",
+			   io->lba);
+		io->status = -EAGAIN;
+		bypass_rq_put(&dev->nv_cache, rq);
+		ftl_io_complete(io);
+		return;
+	}
+
+	/* Remember previous l2p mapping to resolve conflicts with the writes completed meanwhile */
+	for (i = 0; i < rq->num_blocks; i++) {
+		rq->entries[i].addr = ftl_l2p_get(dev, rq->entries[i].lba);
+	}
+
+	ftl_writer_queue_rq(&dev->writer_user, rq);
+}
+
+static bool
+bypass_is_possible(struct spdk_ftl_dev *dev, struct ftl_io *io)
+{
+	struct ftl_nv_cache *nv_cache = &dev->nv_cache;
+
+	if (!dev->conf.nv_cache_bypass || nv_cache->halt) {
+		return false;
+	}
+
+	if (io->num_blocks != dev->xfer_size || io->lba % dev->xfer_size) {
+		return false;
+	}
+
+	/*
+	 * The writes to the cache and unmaps in progress are older than the bypassing write, but
+	 * may complete after it, so the L2P wouldn't match the sequence ids seen by the recovery
+	 */
+	if (nv_cache->bypass.user_blocks_inflight || dev->unmap_qd) {
+		return false;
+	}
+
+	return nv_cache->bypass.rq_free_count > 0;
+}
+
+bool
+ftl_nv_cache_bypass_write(struct ftl_io *io)
+{
+	struct spdk_ftl_dev *dev = io->dev;
+	struct ftl_nv_cache *nv_cache = &dev->nv_cache;
+	struct ftl_nv_cache_chunk *chunk;
+	struct ftl_rq *rq;
+	uint64_t i, seq_id;
+
+	if (!bypass_is_possible(dev, io)) {
+		return false;
+	}
+
+	rq = TAILQ_FIRST(&nv_cache->bypass.rq_free);
+	TAILQ_REMOVE(&nv_cache->bypass.rq_free, rq, qentry);
+	nv_cache->bypass.rq_free_count--;
+
+	/*
+	 * The data needs to be newer than anything already written to the cache and older than
+	 * anything written to it later, so close the current chunk and don't use the ones opened
+	 * so far
+	 */
+	chunk = nv_cache->chunk_current;
+	if (chunk) {
+		nv_cache->chunk_current = NULL;
+		if (!chunk_is_closed(chunk)) {
+			chunk_skip_free_space(nv_cache, chunk);
+		}
+	}
+	seq_id = ftl_get_next_seq_id(dev);
+	nv_cache->bypass.seq_id = seq_id;
+
+	spdk_copy_iovs_to_buf(rq->io_payload, rq->num_blocks * FTL_BLOCK_SIZE, io->iov, io->iov_cnt);
+	for (i = 0; i < rq->num_blocks; i++) {
+		rq->entries[i].lba = ftl_io_get_lba(io, i);
+		rq->entries[i].seq_id = seq_id;
+	}
+	rq->owner.priv = io;
+
+	ftl_l2p_pin(dev, io->lba, io->num_blocks, bypass_pin_cb, rq, &io->l2p_pin_ctx);
+
+	return true;
+}
+
 int
-ftl_nv_cache_read(struct ftl_io *io, ftl_addr addr, uint32_t num_blocks,
-		  spdk_bdev_io_completion_cb cb, void *cb_arg)
+ftl_nv_cache_read(struct ftl_io *io, struct spdk_io_channel *ch, ftl_addr addr,
+		  uint32_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg)
 {
 	int rc;
 	struct ftl_nv_cache *nv_cache = &io->dev->nv_cache;
 
 	assert(ftl_addr_in_nvc(io->dev, addr));
 
-	rc = ftl_nv_cache_bdev_read_blocks_with_md(io->dev, nv_cache->bdev_desc, nv_cache->cache_ioch,
+	rc = ftl_nv_cache_bdev_read_blocks_with_md(io->dev, nv_cache->bdev_desc, ch,
 			ftl_io_iovec_addr(io), NULL, ftl_addr_to_nvc_offset(io->dev, addr),
 			num_blocks, cb, cb_arg);
 
@@ -1178,7 +1467,8 @@ ftl_nv_cache_is_halted(struct ftl_nv_cache *nv_cache)
 	}
 
 	TAILQ_FOREACH(compactor, &nv_cache->compactor_list, entry) {
-		if (compactor->rd->iter.idx != 0 || compactor->wr->iter.idx != 0) {
+		if (compactor->rd->iter.idx != 0 || compactor->wr->iter.idx != 0 ||
+		    compactor->wr_cold->iter.idx != 0) {
 			return false;
 		}
 	}
@@ -1187,9 +1477,29 @@ ftl_nv_cache_is_halted(struct ftl_nv_cache *nv_cache)
 		return false;
 	}
 
+	if (nv_cache->bypass.rq_free_count < FTL_NV_CACHE_NUM_BYPASS_RQS) {
+		return false;
+	}
+
 	return true;
 }
 
+static void
+compaction_reset_wr(struct ftl_rq *wr)
+{
+	uint64_t lba;
+	uint64_t i;
+
+	for (i = 0; i < wr->iter.idx; i++) {
+		lba = wr->entries[i].lba;
+		if (lba != FTL_LBA_INVALID) {
+			ftl_l2p_unpin(wr->dev, lba, 1);
+		}
+	}
+
+	wr->iter.idx = 0;
+}
+
 static void
 ftl_nv_cache_compaction_reset(struct ftl_nv_cache_compactor *compactor)
 {
@@ -1208,13 +1518,9 @@ ftl_nv_cache_compaction_reset(struct ftl_nv_cache_compactor *compactor)
 	rd->iter.idx = 0;
 	rd->iter.count = 0;
 
-	for (i = 0; i < wr->iter.idx; i++) {
-		lba = wr->entries[i].lba;
-		assert(lba != FTL_LBA_INVALID);
-		ftl_l2p_unpin(wr->dev, lba, 1);
-	}
-
-	wr->iter.idx = 0;
+	compaction_reset_wr(wr);
+	compaction_reset_wr(compactor->wr_cold);
+	compactor->cold_wait = 0;
 }
 
 void
@@ -1274,6 +1580,63 @@ ftl_nv_cache_set_addr(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr addr)
 	ftl_bitmap_set(dev->valid_map, addr);
 }
 
+static void
+ftl_nv_cache_compaction_ctrl_update(struct ftl_nv_cache *nv_cache)
+{
+	struct spdk_ftl_dev *dev = SPDK_CONTAINEROF(nv_cache, struct spdk_ftl_dev, nv_cache);
+	const double alpha = FTL_NV_CACHE_COMPACTION_CTRL_ALPHA;
+	double err, err_sum, trend, compactor_rate, demand;
+	uint64_t compactors, read_blocks;
+
+	nv_cache->compaction_ctrl.user_rate = alpha * nv_cache->throttle.blocks_submitted +
+					      (1.0 - alpha) * nv_cache->compaction_ctrl.user_rate;
+
+	trend = ((double)nv_cache->chunk_free_count - nv_cache->compaction_ctrl.free_count) /
+		nv_cache->chunk_count;
+	nv_cache->compaction_ctrl.free_trend = alpha * trend +
+					       (1.0 - alpha) * nv_cache->compaction_ctrl.free_trend;
+	nv_cache->compaction_ctrl.free_count = nv_cache->chunk_free_count;
+
+	/* Feed forward: the number of compactors keeping up with the user writes */
+	if (nv_cache->compaction_sma == 0 || nv_cache->compaction_active_count == 0) {
+		demand = FTL_NV_CACHE_NUM_COMPACTORS;
+	} else {
+		compactor_rate = nv_cache->compaction_sma * nv_cache->throttle.interval_tsc /
+				 FTL_BLOCK_SIZE / nv_cache->compaction_active_count;
+		demand = nv_cache->compaction_ctrl.user_rate / compactor_rate;
+	}
+
+	err = ((double)nv_cache->chunk_free_target - nv_cache->chunk_free_count) /
+	      nv_cache->chunk_count;
+	demand += FTL_NV_CACHE_COMPACTION_CTRL_KP * err +
+		  FTL_NV_CACHE_COMPACTION_CTRL_KI * nv_cache->compaction_ctrl.err_sum -
+		  FTL_NV_CACHE_COMPACTION_CTRL_KD * nv_cache->compaction_ctrl.free_trend;
+
+	/* Only accumulate the error while the output isn't saturated */
+	if ((demand < FTL_NV_CACHE_NUM_COMPACTORS || err < 0) && (demand > 0 || err > 0)) {
+		err_sum = nv_cache->compaction_ctrl.err_sum + err;
+		err_sum = spdk_min(err_sum, FTL_NV_CACHE_COMPACTION_CTRL_SUM_MAX);
+		err_sum = spdk_max(err_sum, -FTL_NV_CACHE_COMPACTION_CTRL_SUM_MAX);
+		nv_cache->compaction_ctrl.err_sum = err_sum;
+	}
+
+	if (demand >= 1.0) {
+		compactors = spdk_min(demand, FTL_NV_CACHE_NUM_COMPACTORS);
+		if (compactors < demand && compactors < FTL_NV_CACHE_NUM_COMPACTORS) {
+			compactors++;
+		}
+
+		nv_cache->compaction_ctrl.compactors_max = compactors;
+		nv_cache->compaction_ctrl.read_blocks = UINT64_MAX;
+	} else {
+		demand = spdk_max(demand, FTL_NV_CACHE_COMPACTION_CTRL_READ_MIN);
+		read_blocks = spdk_max(dev->xfer_size * demand, 1);
+
+		nv_cache->compaction_ctrl.compactors_max = 1;
+		nv_cache->compaction_ctrl.read_blocks = read_blocks;
+	}
+}
+
 static void
 ftl_nv_cache_throttle_update(struct ftl_nv_cache *nv_cache)
 {
@@ -1305,7 +1668,9 @@ ftl_nv_cache_process_throttle(struct ftl_nv_cache *nv_cache)
 
 	if (spdk_unlikely(!nv_cache->throttle.start_tsc)) {
 		nv_cache->throttle.start_tsc = tsc;
+		nv_cache->compaction_ctrl.free_count = nv_cache->chunk_free_count;
 	} else if (tsc - nv_cache->throttle.start_tsc >= nv_cache->throttle.interval_tsc) {
+		ftl_nv_cache_compaction_ctrl_update(nv_cache);
 		ftl_nv_cache_throttle_update(nv_cache);
 		nv_cache->throttle.start_tsc = tsc;
 		nv_cache->throttle.blocks_submitted = 0;
@@ -1332,7 +1697,8 @@ ftl_nv_cache_process(struct spdk_ftl_dev *dev)
 		ftl_add_io_activity(dev);
 	}
 
-	if (is_compaction_required(nv_cache) && !TAILQ_EMPTY(&nv_cache->compactor_list)) {
+	if (is_compaction_required(nv_cache) && !TAILQ_EMPTY(&nv_cache->compactor_list) &&
+	    nv_cache->compaction_active_count < nv_cache->compaction_ctrl.compactors_max) {
 		struct ftl_nv_cache_compactor *comp =
 			TAILQ_FIRST(&nv_cache->compactor_list);
 
@@ -2374,8 +2740,8 @@ ftl_nv_cache_acquire_trim_seq_id(struct ftl_nv_cache *nv_cache)
 	uint64_t seq_id, free_space;
 
 	if (!chunk) {
-		chunk = TAILQ_FIRST(&nv_cache->chunk_open_list);
-		if (chunk && chunk->md->state == FTL_CHUNK_STATE_OPEN) {
+		chunk = nv_cache_get_open_chunk(nv_cache);
+		if (chunk) {
 			return chunk->md->seq_id;
 		} else {
 			return 0;
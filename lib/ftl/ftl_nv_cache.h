@@ -28,6 +28,9 @@
 
 #define FTL_NV_CACHE_NUM_COMPACTORS 8
 
+/* Number of requests writing user data directly to the base device, bypassing the cache */
+#define FTL_NV_CACHE_NUM_BYPASS_RQS 4
+
 /*
  * Parameters controlling nv cache write throttling.
  *
@@ -46,6 +49,46 @@
 #define FTL_NV_CACHE_THROTTLE_MODIFIER_MIN	-0.8
 #define FTL_NV_CACHE_THROTTLE_MODIFIER_MAX	0.5
 
+/*
+ * Parameters controlling the compaction parallelism, updated along with the write throttle.
+ *
+ * The number of compactors needed is estimated as:
+ * demand = user_rate / compactor_rate + KP * err + KI * sum(err) - KD * free_trend
+ *
+ * The user write rate and the trend of free chunks are smoothed over the recent intervals, err
+ * is the shortage of free chunks vs the configured target, relative to the number of chunks.
+ * The demand is rounded up to get the number of active compactors, while a demand lower than a
+ * single compactor shrinks the size of the compaction reads.
+ */
+
+/* Weight of the most recent interval in the smoothed user write rate and free chunk trend */
+#define FTL_NV_CACHE_COMPACTION_CTRL_ALPHA	0.25
+/* Proportional, integral and derivative gains, in compactors */
+#define FTL_NV_CACHE_COMPACTION_CTRL_KP		40.0
+#define FTL_NV_CACHE_COMPACTION_CTRL_KI		2.0
+#define FTL_NV_CACHE_COMPACTION_CTRL_KD		200.0
+/* Bounds of the accumulated error, preventing the integral term from winding up */
+#define FTL_NV_CACHE_COMPACTION_CTRL_SUM_MAX	1.0
+/* Smallest fraction of the read buffer used by a compactor */
+#define FTL_NV_CACHE_COMPACTION_CTRL_READ_MIN	0.25
+
+/*
+ * Parameters controlling the separation of hot and cold user data.
+ *
+ * Each range of LBAs has a counter of the blocks written to it, halved every time the whole
+ * device's worth of blocks was written.  Compaction places the blocks of ranges that weren't
+ * rewritten more than about once per two device writes in GC bands, along with the data
+ * relocated by GC, so that cold data doesn't get relocated along with the hot data invalidated
+ * around it.
+ */
+
+/* Number of LBAs sharing a single write counter */
+#define FTL_NV_CACHE_TEMP_RANGE_BLOCKS		256
+/* Ranges with at most this many blocks written are cold */
+#define FTL_NV_CACHE_TEMP_COLD_MAX		FTL_NV_CACHE_TEMP_RANGE_BLOCKS
+/* Number of requests sent to user bands after which a partially filled cold request is padded */
+#define FTL_NV_CACHE_TEMP_COLD_MAX_WAIT		16
+
 struct ftl_nvcache_restore;
 typedef void (*ftl_nv_cache_restore_fn)(struct ftl_nvcache_restore *, int, void *cb_arg);
 
@@ -124,6 +167,10 @@ struct ftl_nv_cache_chunk {
 struct ftl_nv_cache_compactor {
 	struct ftl_nv_cache *nv_cache;
 	struct ftl_rq *wr;
+	/* Request gathering cold data, written to GC bands */
+	struct ftl_rq *wr_cold;
+	/* Number of requests written to user bands while wr_cold was partially filled */
+	uint32_t cold_wait;
 	struct ftl_rq *rd;
 	TAILQ_ENTRY(ftl_nv_cache_compactor) entry;
 	struct spdk_bdev_io_wait_entry bdev_io_wait;
@@ -199,6 +246,15 @@ struct ftl_nv_cache {
 
 	uint64_t chunk_free_target;
 
+	/* Write temperature of LBA ranges */
+	struct {
+		uint16_t *counters;
+		uint64_t num_ranges;
+		/* Blocks written since the counters were last halved */
+		uint64_t writes;
+		uint64_t aging_interval;
+	} temp;
+
 	/* Simple moving average of recent compaction velocity values */
 	double compaction_sma;
 
@@ -217,14 +273,43 @@ struct ftl_nv_cache {
 		uint64_t blocks_submitted;
 		uint64_t blocks_submitted_limit;
 	} throttle;
+
+	/* Compaction parallelism controller */
+	struct {
+		/* Smoothed number of user blocks written per interval */
+		double user_rate;
+		/* Smoothed change of the number of free chunks per interval */
+		double free_trend;
+		uint64_t free_count;
+		/* Accumulated free chunk shortage */
+		double err_sum;
+		/* Max number of active compactors */
+		uint64_t compactors_max;
+		/* Max number of blocks read by a compactor at once */
+		uint64_t read_blocks;
+	} compaction_ctrl;
+
+	/* Writes of full, aligned transfers bypassing the cache */
+	struct {
+		TAILQ_HEAD(, ftl_rq) rq_free;
+		uint64_t rq_free_count;
+		/* Number of user blocks being written to the cache */
+		uint64_t user_blocks_inflight;
+		/*
+		 * Sequence id of the last write bypassing the cache. Chunks opened before it aren't
+		 * used for user writes anymore, as their data would be considered older.
+		 */
+		uint64_t seq_id;
+	} bypass;
 };
 
 int ftl_nv_cache_init(struct spdk_ftl_dev *dev);
 void ftl_nv_cache_deinit(struct spdk_ftl_dev *dev);
 bool ftl_nv_cache_write(struct ftl_io *io);
+bool ftl_nv_cache_bypass_write(struct ftl_io *io);
 void ftl_nv_cache_fill_md(struct ftl_io *io);
-int ftl_nv_cache_read(struct ftl_io *io, ftl_addr addr, uint32_t num_blocks,
-		      spdk_bdev_io_completion_cb cb, void *cb_arg);
+int ftl_nv_cache_read(struct ftl_io *io, struct spdk_io_channel *ch, ftl_addr addr,
+		      uint32_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg);
 bool ftl_nv_cache_throttle(struct spdk_ftl_dev *dev);
 void ftl_nv_cache_process(struct spdk_ftl_dev *dev);
 
@@ -3,6 +3,8 @@
  *   All rights reserved.
  */
 
+#include "spdk/crc32.h"
+
 #include "ftl_sb.h"
 #include "ftl_core.h"
 #include "ftl_layout.h"
@@ -17,6 +19,32 @@ ftl_superblock_check_magic(struct ftl_superblock *sb)
 		return sb->header.magic == FTL_SUPERBLOCK_MAGIC_V2;
 	}
 }
+
+uint32_t
+ftl_superblock_get_crc(struct ftl_superblock *sb)
+{
+	uint32_t crc = 0;
+
+	/* Calculate CRC excluding CRC field in superblock */
+	void *buffer = sb;
+	size_t offset = offsetof(struct ftl_superblock, header.crc);
+	size_t size = offset;
+	crc = spdk_crc32c_update(buffer, size, crc);
+
+	buffer += offset + sizeof(sb->header.crc);
+	if (sb->header.version > FTL_SB_VERSION_2) {
+		/* whole buf for v3 and on: */
+		size = FTL_SUPERBLOCK_SIZE - offset - sizeof(sb->header.crc);
+		crc = spdk_crc32c_update(buffer, size, crc);
+	} else {
+		/* special for sb v2 only: */
+		size = sizeof(struct ftl_superblock_v2) - offset - sizeof(sb->header.crc);
+		sb->header.crc = spdk_crc32c_update(buffer, size, crc);
+	}
+
+	return crc;
+}
+
 bool
 ftl_superblock_md_layout_is_empty(struct ftl_superblock *sb)
 {
@@ -14,6 +14,8 @@ struct spdk_ftl_dev;
 
 bool ftl_superblock_check_magic(struct ftl_superblock *sb);
 
+uint32_t ftl_superblock_get_crc(struct ftl_superblock *sb);
+
 bool ftl_superblock_md_layout_is_empty(struct ftl_superblock *sb);
 
 int ftl_superblock_md_layout_build(struct spdk_ftl_dev *dev);
@@ -171,12 +171,14 @@ decorate_bands(struct spdk_ftl_dev *dev)
 	uint64_t reclaim_unit_num_blocks = BASE_BDEV_RECLAIM_UNIT_SIZE / FTL_BLOCK_SIZE;
 	uint32_t num_logical_in_phys = 2;
 
-	assert(reclaim_unit_num_blocks % num_blocks_in_band == 0);
-
 	num_blocks = spdk_bdev_get_num_blocks(spdk_bdev_desc_get_bdev(dev->base_bdev_desc));
 
-	/* For base bdev bigger than 1TB take reclaim uint size for grouping GC bands */
-	if (num_blocks > (TiB / FTL_BLOCK_SIZE)) {
+	if (dev->is_zoned) {
+		/* Each band is a zone, which is reset independently of the others */
+		num_logical_in_phys = 1;
+	} else if (num_blocks > (TiB / FTL_BLOCK_SIZE)) {
+		/* For base bdev bigger than 1TB take reclaim uint size for grouping GC bands */
+		assert(reclaim_unit_num_blocks % num_blocks_in_band == 0);
 		assert(reclaim_unit_num_blocks < num_blocks);
 		num_logical_in_phys = reclaim_unit_num_blocks / num_blocks_in_band;
 	}
@@ -4,6 +4,7 @@
  */
 
 #include "spdk/bdev_module.h"
+#include "spdk/bdev_zone.h"
 #include "spdk/ftl.h"
 
 #include "ftl_nv_cache.h"
@@ -11,7 +12,9 @@
 #include "ftl_mngt_steps.h"
 #include "ftl_internal.h"
 #include "ftl_core.h"
+#include "ftl_band.h"
 #include "utils/ftl_defs.h"
+#include "utils/ftl_bitmap.h"
 
 #define MINIMUM_CACHE_SIZE_GIB 5
 #define MINIMUM_BASE_SIZE_GIB 20
@@ -44,6 +47,40 @@ base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void
 	}
 }
 
+static int
+ftl_check_zoned_base_bdev(struct spdk_ftl_dev *dev, struct spdk_bdev *bdev)
+{
+	uint32_t max_open_zones = spdk_bdev_get_max_open_zones(bdev);
+
+	if (!spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZONE_APPEND) ||
+	    !spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT)) {
+		FTL_ERRLOG(dev, "Zoned bdev %s doesn't support zone append and management\n",
+			   spdk_bdev_get_name(bdev));
+		return -ENOTSUP;
+	}
+
+	if (spdk_bdev_get_max_zone_append_size(bdev) < dev->xfer_size) {
+		FTL_ERRLOG(dev, "Unsupported max zone append size (%"PRIu32")\n",
+			   spdk_bdev_get_max_zone_append_size(bdev));
+		return -EINVAL;
+	}
+
+	/* Bands need to be aligned to the granularity of the valid map, see setup_layout_base() */
+	if (!dev->num_blocks_in_band || dev->num_blocks_in_band % dev->xfer_size ||
+	    dev->num_blocks_in_band % (8 * ftl_bitmap_buffer_alignment)) {
+		FTL_ERRLOG(dev, "Unsupported zone size (%"PRIu64")\n", dev->num_blocks_in_band);
+		return -EINVAL;
+	}
+
+	if (max_open_zones && max_open_zones < FTL_MAX_OPEN_BANDS) {
+		FTL_ERRLOG(dev, "Zoned bdev %s allows too few open zones (%"PRIu32")\n",
+			   spdk_bdev_get_name(bdev), max_open_zones);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 void
 ftl_mngt_open_base_bdev(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 {
@@ -102,9 +139,11 @@ ftl_mngt_open_base_bdev(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 	dev->is_zoned = spdk_bdev_is_zoned(spdk_bdev_desc_get_bdev(dev->base_bdev_desc));
 
 	if (dev->is_zoned) {
-		/* TODO - current FTL code isn't fully compatible with ZNS drives */
-		FTL_ERRLOG(dev, "Creating FTL on Zoned devices is not supported\n");
-		goto error;
+		/* Each band is mapped onto a single zone */
+		dev->num_blocks_in_band = spdk_bdev_get_zone_size(bdev);
+		if (ftl_check_zoned_base_bdev(dev, bdev)) {
+			goto error;
+		}
 	}
 
 	ftl_mngt_next_step(mngt);
@@ -248,3 +287,167 @@ ftl_mngt_close_cache_bdev(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mng
 
 	ftl_mngt_next_step(mngt);
 }
+
+struct ftl_zone_info_ctx {
+	/* Index of the band whose zone is being queried */
+	uint64_t			id;
+	bool				completed;
+	bool				success;
+	uint64_t			num_zones;
+	struct spdk_bdev_zone_info	info[];
+};
+
+static void
+get_zone_info_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct ftl_mngt_process *mngt = cb_arg;
+	struct ftl_zone_info_ctx *ctx = ftl_mngt_get_step_ctx(mngt);
+
+	spdk_bdev_free_io(bdev_io);
+
+	ctx->completed = true;
+	ctx->success = success;
+	ftl_mngt_continue_step(mngt);
+}
+
+static void
+get_zone_info(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt, uint64_t zone_id)
+{
+	struct ftl_zone_info_ctx *ctx = ftl_mngt_get_step_ctx(mngt);
+	int rc;
+
+	ctx->completed = false;
+	rc = spdk_bdev_get_zone_info(dev->base_bdev_desc, dev->base_ioch, zone_id, ctx->num_zones,
+				     ctx->info, get_zone_info_cb, mngt);
+	if (rc) {
+		FTL_ERRLOG(dev, "Failed to get zone info, rc %d\n", rc);
+		ftl_mngt_fail_step(mngt);
+	}
+}
+
+void
+ftl_mngt_verify_base_zones(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
+{
+	struct ftl_layout_region *region = &dev->layout.region[FTL_LAYOUT_REGION_TYPE_DATA_BASE];
+	struct ftl_zone_info_ctx *ctx = ftl_mngt_get_step_ctx(mngt);
+	uint64_t i, num_md_zones = region->current.offset / ftl_get_num_blocks_in_band(dev);
+	struct spdk_bdev_zone_info *data_zone;
+	size_t ctx_size;
+
+	if (!dev->is_zoned) {
+		ftl_mngt_skip_step(mngt);
+		return;
+	}
+
+	if (!ctx) {
+		/* Query the metadata zones along with the first data zone */
+		ctx_size = sizeof(*ctx) + (num_md_zones + 1) * sizeof(struct spdk_bdev_zone_info);
+		if (ftl_mngt_alloc_step_ctx(mngt, ctx_size)) {
+			ftl_mngt_fail_step(mngt);
+			return;
+		}
+
+		ctx = ftl_mngt_get_step_ctx(mngt);
+		ctx->num_zones = num_md_zones + 1;
+		get_zone_info(dev, mngt, 0);
+		return;
+	}
+
+	if (!ctx->success) {
+		FTL_ERRLOG(dev, "Failed to get base device zone info\n");
+		ftl_mngt_fail_step(mngt);
+		return;
+	}
+
+	/* The metadata is updated in place, so it has to be stored in conventional zones */
+	for (i = 0; i < num_md_zones; i++) {
+		if (ctx->info[i].type != SPDK_BDEV_ZONE_TYPE_CNV) {
+			FTL_ERRLOG(dev, "Base device metadata needs %"PRIu64" conventional zones\n",
+				   num_md_zones);
+			ftl_mngt_fail_step(mngt);
+			return;
+		}
+	}
+
+	data_zone = &ctx->info[num_md_zones];
+	if (data_zone->type != SPDK_BDEV_ZONE_TYPE_SEQWR ||
+	    data_zone->capacity != ftl_get_num_blocks_in_band(dev)) {
+		FTL_ERRLOG(dev, "Unsupported type or capacity (%"PRIu64") of data zones\n",
+			   data_zone->capacity);
+		ftl_mngt_fail_step(mngt);
+		return;
+	}
+
+	ftl_mngt_next_step(mngt);
+}
+
+static bool
+band_needs_zone_sync(struct ftl_band *band)
+{
+	return band->md->state == FTL_BAND_STATE_OPEN || band->md->state == FTL_BAND_STATE_FULL;
+}
+
+void
+ftl_mngt_recovery_sync_band_zones(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
+{
+	struct ftl_zone_info_ctx *ctx = ftl_mngt_get_step_ctx(mngt);
+	struct ftl_band *band;
+	uint64_t offset;
+
+	if (!dev->is_zoned) {
+		ftl_mngt_skip_step(mngt);
+		return;
+	}
+
+	if (!ctx) {
+		if (ftl_mngt_alloc_step_ctx(mngt, sizeof(*ctx) + sizeof(ctx->info[0]))) {
+			ftl_mngt_fail_step(mngt);
+			return;
+		}
+
+		ctx = ftl_mngt_get_step_ctx(mngt);
+		ctx->num_zones = 1;
+	}
+
+	if (ctx->completed) {
+		band = &dev->bands[ctx->id];
+		if (!ctx->success) {
+			FTL_ERRLOG(dev, "Failed to get zone info of band %"PRIu64"\n", ctx->id);
+			ftl_mngt_fail_step(mngt);
+			return;
+		}
+
+		/*
+		 * Appends which completed after the last P2L checkpoint have already moved the write
+		 * pointer. Their data is invalid (not in the P2L), but the band has to continue from
+		 * the write pointer, since the zone can't be written anywhere else.
+		 */
+		offset = ctx->info[0].write_pointer - band->start_addr;
+		if (offset < band->md->iter.offset ||
+		    offset > ftl_get_num_blocks_in_band(dev) - ftl_tail_md_num_blocks(dev)) {
+			FTL_ERRLOG(dev, "Band %"PRIu64" offset %"PRIu64" doesn't match zone "
+				   "write pointer offset %"PRIu64"\n", ctx->id,
+				   band->md->iter.offset, offset);
+			ftl_mngt_fail_step(mngt);
+			return;
+		}
+
+		ftl_band_iter_init(band);
+		ftl_band_iter_set(band, offset);
+		band->md->state = ftl_band_filled(band, offset) ? FTL_BAND_STATE_FULL :
+				  FTL_BAND_STATE_OPEN;
+
+		ctx->completed = false;
+		ctx->id++;
+	}
+
+	for (; ctx->id < ftl_get_num_bands(dev); ctx->id++) {
+		band = &dev->bands[ctx->id];
+		if (band_needs_zone_sync(band)) {
+			get_zone_info(dev, mngt, band->start_addr);
+			return;
+		}
+	}
+
+	ftl_mngt_next_step(mngt);
+}
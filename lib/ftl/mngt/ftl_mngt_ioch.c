@@ -4,6 +4,7 @@
  */
 
 #include "spdk/thread.h"
+#include "spdk/bdev.h"
 
 #include "ftl_core.h"
 #include "ftl_mngt.h"
@@ -39,6 +40,10 @@ io_channel_unregister(void *ctx)
 
 	TAILQ_REMOVE(&dev->ioch_queue, ioch, entry);
 
+	ftl_stats_group_add(&dev->stats.entries[FTL_STATS_TYPE_USER].read, &ioch->read_stats);
+
+	spdk_ring_free(ioch->read_cq);
+	spdk_ring_free(ioch->read_sq);
 	spdk_ring_free(ioch->cq);
 	spdk_ring_free(ioch->sq);
 	ftl_mempool_destroy(ioch->map_pool);
@@ -99,10 +104,38 @@ io_channel_create_cb(void *io_device, void *ctx)
 		goto fail_cq;
 	}
 
+	ioch->read_sq = spdk_ring_create(SPDK_RING_TYPE_SP_SC,
+					 spdk_align64pow2(dev->conf.user_io_pool_size + 1),
+					 SPDK_ENV_SOCKET_ID_ANY);
+	if (!ioch->read_sq) {
+		FTL_ERRLOG(dev, "Failed to create IO channel read submission queue\n");
+		goto fail_sq;
+	}
+
+	ioch->read_cq = spdk_ring_create(SPDK_RING_TYPE_SP_SC,
+					 spdk_align64pow2(dev->conf.user_io_pool_size + 1),
+					 SPDK_ENV_SOCKET_ID_ANY);
+	if (!ioch->read_cq) {
+		FTL_ERRLOG(dev, "Failed to create IO channel read completion queue\n");
+		goto fail_read_sq;
+	}
+
+	ioch->base_ioch = spdk_bdev_get_io_channel(dev->base_bdev_desc);
+	if (!ioch->base_ioch) {
+		FTL_ERRLOG(dev, "Failed to create IO channel's base bdev channel\n");
+		goto fail_read_cq;
+	}
+
+	ioch->cache_ioch = spdk_bdev_get_io_channel(dev->nv_cache.bdev_desc);
+	if (!ioch->cache_ioch) {
+		FTL_ERRLOG(dev, "Failed to create IO channel's cache bdev channel\n");
+		goto fail_base_ioch;
+	}
+
 	ioch->poller = SPDK_POLLER_REGISTER(ftl_io_channel_poll, ioch, 0);
 	if (!ioch->poller) {
 		FTL_ERRLOG(dev, "Failed to register IO channel poller\n");
-		goto fail_sq;
+		goto fail_cache_ioch;
 	}
 
 	if (spdk_thread_send_msg(dev->core_thread, ftl_dev_register_channel, ioch)) {
@@ -115,10 +148,18 @@ io_channel_create_cb(void *io_device, void *ctx)
 
 fail_poller:
 	spdk_poller_unregister(&ioch->poller);
-fail_cq:
-	spdk_ring_free(ioch->cq);
+fail_cache_ioch:
+	spdk_put_io_channel(ioch->cache_ioch);
+fail_base_ioch:
+	spdk_put_io_channel(ioch->base_ioch);
+fail_read_cq:
+	spdk_ring_free(ioch->read_cq);
+fail_read_sq:
+	spdk_ring_free(ioch->read_sq);
 fail_sq:
 	spdk_ring_free(ioch->sq);
+fail_cq:
+	spdk_ring_free(ioch->cq);
 fail_io_pool:
 	ftl_mempool_destroy(ioch->map_pool);
 	free(ioch);
@@ -137,6 +178,8 @@ io_channel_destroy_cb(void *io_device, void *ctx)
 		      spdk_thread_get_name(spdk_get_thread()));
 
 	spdk_poller_unregister(&ioch->poller);
+	spdk_put_io_channel(ioch->cache_ioch);
+	spdk_put_io_channel(ioch->base_ioch);
 	spdk_thread_send_msg(ftl_get_core_thread(dev),
 			     io_channel_unregister, ioch);
 }
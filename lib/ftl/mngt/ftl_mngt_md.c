@@ -244,37 +244,12 @@ ftl_mngt_persist_trim_metadata(struct spdk_ftl_dev *dev, struct ftl_mngt_process
 	persist(dev, mngt, FTL_LAYOUT_REGION_TYPE_TRIM_MD);
 }
 
-static uint32_t
-get_sb_crc(struct ftl_superblock *sb)
-{
-	uint32_t crc = 0;
-
-	/* Calculate CRC excluding CRC field in superblock */
-	void *buffer = sb;
-	size_t offset = offsetof(struct ftl_superblock, header.crc);
-	size_t size = offset;
-	crc = spdk_crc32c_update(buffer, size, crc);
-
-	buffer += offset + sizeof(sb->header.crc);
-	if (sb->header.version > FTL_SB_VERSION_2) {
-		/* whole buf for v3 and on: */
-		size = FTL_SUPERBLOCK_SIZE - offset - sizeof(sb->header.crc);
-		crc = spdk_crc32c_update(buffer, size, crc);
-	} else {
-		/* special for sb v2 only: */
-		size = sizeof(struct ftl_superblock_v2) - offset - sizeof(sb->header.crc);
-		sb->header.crc = spdk_crc32c_update(buffer, size, crc);
-	}
-
-	return crc;
-}
-
 static void
 ftl_mngt_persist_super_block(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 {
 	dev->sb->overprovisioning = dev->conf.overprovisioning;
 	dev->sb->gc_info = dev->sb_shm->gc_info;
-	dev->sb->header.crc = get_sb_crc(dev->sb);
+	dev->sb->header.crc = ftl_superblock_get_crc(dev->sb);
 	persist(dev, mngt, FTL_LAYOUT_REGION_TYPE_SB);
 }
 
@@ -384,7 +359,7 @@ ftl_mngt_init_default_sb(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt
 	sb->md_layout_head.type = FTL_LAYOUT_REGION_TYPE_INVALID;
 	sb->md_layout_head.df_next = FTL_DF_OBJ_ID_INVALID;
 
-	sb->header.crc = get_sb_crc(sb);
+	sb->header.crc = ftl_superblock_get_crc(sb);
 
 	ftl_mngt_next_step(mngt);
 }
@@ -396,7 +371,7 @@ ftl_mngt_set_dirty(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 
 	sb->clean = 0;
 	dev->sb_shm->shm_clean = false;
-	sb->header.crc = get_sb_crc(sb);
+	sb->header.crc = ftl_superblock_get_crc(sb);
 	persist(dev, mngt, FTL_LAYOUT_REGION_TYPE_SB);
 }
 
@@ -407,7 +382,7 @@ ftl_mngt_set_clean(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 
 	sb->clean = 1;
 	dev->sb_shm->shm_clean = false;
-	sb->header.crc = get_sb_crc(sb);
+	sb->header.crc = ftl_superblock_get_crc(sb);
 	persist(dev, mngt, FTL_LAYOUT_REGION_TYPE_SB);
 
 	dev->sb_shm->shm_ready = false;
@@ -420,7 +395,7 @@ ftl_mngt_set_shm_clean(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 
 	sb->clean = 1;
 	dev->sb_shm->shm_clean = true;
-	sb->header.crc = get_sb_crc(sb);
+	sb->header.crc = ftl_superblock_get_crc(sb);
 	ftl_mngt_next_step(mngt);
 }
 
@@ -453,7 +428,7 @@ ftl_mngt_validate_sb(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 		return;
 	}
 
-	if (sb->header.crc != get_sb_crc(sb)) {
+	if (sb->header.crc != ftl_superblock_get_crc(sb)) {
 		FTL_ERRLOG(dev, "Invalid FTL superblock CRC\n");
 		ftl_mngt_fail_step(mngt);
 		return;
@@ -767,6 +742,6 @@ ftl_mngt_restore_md(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 void
 ftl_mngt_persist_superblock(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 {
-	dev->sb->header.crc = get_sb_crc(dev->sb);
+	dev->sb->header.crc = ftl_superblock_get_crc(dev->sb);
 	persist(dev, mngt, FTL_LAYOUT_REGION_TYPE_SB);
 }
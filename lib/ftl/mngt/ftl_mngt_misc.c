@@ -186,6 +186,10 @@ ftl_mngt_finalize_startup(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mng
 	 * the initialization code.
 	 */
 	memset(dev->stats.limits, 0, sizeof(dev->stats.limits));
+
+	/* Chunks left open by a dirty shutdown may be older than the data bypassing the cache */
+	dev->nv_cache.bypass.seq_id = dev->sb->seq_id;
+
 	dev->initialized = 1;
 	dev->sb_shm->shm_ready = true;
 
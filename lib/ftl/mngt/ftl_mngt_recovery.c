@@ -118,7 +118,9 @@ ftl_mngt_recovery_init(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 	FTL_NOTICELOG(dev, "L2P resident size: %"PRIu64"MiB\n", (uint64_t)(l2p_limit / MiB));
 	FTL_NOTICELOG(dev, "Seq ID resident size: %"PRIu64"MiB\n", (uint64_t)(seq_limit / MiB));
 	FTL_NOTICELOG(dev, "Recovery iterations: %"PRIu64"\n", iterations);
-	dev->sb->ckpt_seq_id = 0;
+	if (ftl_fast_recovery(dev)) {
+		dev->sb->ckpt_seq_id = 0;
+	}
 
 	/* Initialize region */
 	ctx->l2p_snippet.region = dev->layout.region[FTL_LAYOUT_REGION_TYPE_L2P];
@@ -327,12 +329,6 @@ ftl_mngt_recovery_iteration_init_seq_ids(struct spdk_ftl_dev *dev, struct ftl_mn
 	uint32_t lbas_in_page = FTL_BLOCK_SIZE / dev->layout.l2p.addr_size;
 	uint64_t lba, lba_off;
 
-	if (dev->sb->ckpt_seq_id) {
-		FTL_ERRLOG(dev, "Checkpoint recovery not supported!\n");
-		ftl_mngt_fail_step(mngt);
-		return;
-	}
-
 	for (lba = ctx->iter.lba_first; lba < ctx->iter.lba_last; lba++) {
 		lba_off = lba - ctx->iter.lba_first;
 		page_id = lba / lbas_in_page;
@@ -344,7 +340,10 @@ ftl_mngt_recovery_iteration_init_seq_ids(struct spdk_ftl_dev *dev, struct ftl_mn
 		trim_seq_id = trim_map[page_id];
 
 		ctx->l2p_snippet.seq_id[lba_off] = trim_seq_id;
-		ftl_addr_store(dev, ctx->l2p_snippet.l2p, lba_off, FTL_ADDR_INVALID);
+		if (!dev->sb->ckpt_seq_id) {
+			ftl_addr_store(dev, ctx->l2p_snippet.l2p, lba_off, FTL_ADDR_INVALID);
+		}
+		/* Otherwise the loaded entry is kept, it's overwritten by any newer replayed data */
 	}
 
 	ftl_mngt_next_step(mngt);
@@ -809,6 +808,58 @@ ftl_mngt_recover_unmap_map(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mn
 	ftl_md_restore(md);
 }
 
+static void
+ftl_mngt_recovery_check_l2p_ckpt(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
+{
+	struct ftl_md *md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_TRIM_MD];
+	uint64_t *trim_map = ftl_md_get_buffer(md);
+	uint64_t num_pages = dev->layout.region[FTL_LAYOUT_REGION_TYPE_L2P].current.blocks;
+	uint64_t ckpt_seq_id = dev->sb->ckpt_seq_id;
+	uint64_t i, num_bands = 0, num_chunks = 0;
+
+	if (ftl_fast_recovery(dev) || !ckpt_seq_id) {
+		ftl_mngt_skip_step(mngt);
+		return;
+	}
+
+	/*
+	 * The L2P pages persisted by the checkpoint don't reflect the unmaps issued after it
+	 * started, so replay everything in such case
+	 */
+	for (i = 0; i < num_pages; i++) {
+		if (trim_map[i] >= ckpt_seq_id) {
+			FTL_NOTICELOG(dev, "Unmap after L2P checkpoint, replaying all the data\n");
+			dev->sb->ckpt_seq_id = 0;
+			ftl_mngt_next_step(mngt);
+			return;
+		}
+	}
+
+	for (i = 0; i < ftl_get_num_bands(dev); i++) {
+		struct ftl_band *band = &dev->bands[i];
+
+		if (band->md->state == FTL_BAND_STATE_FREE) {
+			continue;
+		}
+		if (band->md->state != FTL_BAND_STATE_CLOSED ||
+		    band->md->close_seq_id > ckpt_seq_id) {
+			num_bands++;
+		}
+	}
+
+	for (i = 0; i < dev->nv_cache.chunk_count; i++) {
+		struct ftl_nv_cache_chunk *chunk = &dev->nv_cache.chunks[i];
+
+		if (chunk->recovery && chunk->md->close_seq_id > ckpt_seq_id) {
+			num_chunks++;
+		}
+	}
+
+	FTL_NOTICELOG(dev, "L2P checkpoint seq id: %"PRIu64", bands to replay: %"PRIu64
+		      ", chunks to replay: %"PRIu64"\n", ckpt_seq_id, num_bands, num_chunks);
+	ftl_mngt_next_step(mngt);
+}
+
 static void
 ftl_mngt_recovery_shm_l2p(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 {
@@ -890,6 +941,10 @@ static const struct ftl_mngt_process_desc g_desc_recovery = {
 			.name = "Recover open bands P2L",
 			.action = ftl_mngt_recovery_open_bands_p2l
 		},
+		{
+			.name = "Sync open bands with zones",
+			.action = ftl_mngt_recovery_sync_band_zones
+		},
 		{
 			.name = "Recover chunk state",
 			.action = ftl_mngt_nv_cache_restore_chunk_state
@@ -902,6 +957,10 @@ static const struct ftl_mngt_process_desc g_desc_recovery = {
 			.name = "Recover unmap map",
 			.action = ftl_mngt_recover_unmap_map
 		},
+		{
+			.name = "Check L2P checkpoint",
+			.action = ftl_mngt_recovery_check_l2p_ckpt
+		},
 		{
 			.name = "Recover open chunks P2L",
 			.action = ftl_mngt_nv_cache_recover_open_chunk
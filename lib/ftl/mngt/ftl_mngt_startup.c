@@ -95,6 +95,10 @@ static const struct ftl_mngt_process_desc desc_startup = {
 			.name = "Initialize layout",
 			.action = ftl_mngt_init_layout
 		},
+		{
+			.name = "Verify base device zones",
+			.action = ftl_mngt_verify_base_zones,
+		},
 		{
 			.name = "Verify layout",
 			.action = ftl_mngt_layout_verify,
@@ -14,6 +14,10 @@ void ftl_mngt_open_base_bdev(struct spdk_ftl_dev *dev, struct ftl_mngt_process *
 
 void ftl_mngt_close_base_bdev(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt);
 
+void ftl_mngt_verify_base_zones(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt);
+
+void ftl_mngt_recovery_sync_band_zones(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt);
+
 #ifdef SPDK_FTL_VSS_EMU
 void ftl_mngt_md_init_vss_emu(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt);
 
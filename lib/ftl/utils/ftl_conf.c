@@ -28,8 +28,40 @@ static const struct spdk_ftl_conf g_default_conf = {
 		.chunk_free_target = 5,
 	},
 	.fast_shutdown = true,
+	.gc_policy = SPDK_FTL_GC_POLICY_GREEDY,
 };
 
+static const char *g_gc_policy_names[] = {
+	[SPDK_FTL_GC_POLICY_GREEDY]		= "greedy",
+	[SPDK_FTL_GC_POLICY_COST_BENEFIT]	= "cost_benefit",
+};
+SPDK_STATIC_ASSERT(SPDK_COUNTOF(g_gc_policy_names) == SPDK_FTL_GC_POLICY_MAX,
+		   "Incorrect number of GC policy names");
+
+const char *
+spdk_ftl_gc_policy_get_name(enum spdk_ftl_gc_policy policy)
+{
+	if (policy >= SPDK_FTL_GC_POLICY_MAX) {
+		return NULL;
+	}
+
+	return g_gc_policy_names[policy];
+}
+
+enum spdk_ftl_gc_policy
+spdk_ftl_gc_policy_from_name(const char *name)
+{
+	uint32_t i;
+
+	for (i = 0; i < SPDK_FTL_GC_POLICY_MAX; i++) {
+		if (strcmp(name, g_gc_policy_names[i]) == 0) {
+			return i;
+		}
+	}
+
+	return SPDK_FTL_GC_POLICY_MAX;
+}
+
 void
 spdk_ftl_get_default_conf(struct spdk_ftl_conf *conf, size_t conf_size)
 {
@@ -166,5 +198,9 @@ ftl_conf_is_valid(const struct spdk_ftl_conf *conf)
 		return false;
 	}
 
+	if (conf->gc_policy >= SPDK_FTL_GC_POLICY_MAX) {
+		return false;
+	}
+
 	return true;
 }
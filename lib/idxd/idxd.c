@@ -6,6 +6,7 @@
 #include "spdk/stdinc.h"
 
 #include "spdk/env.h"
+#include "spdk/dif.h"
 #include "spdk/util.h"
 #include "spdk/memory.h"
 #include "spdk/likely.h"
@@ -31,6 +32,45 @@ spdk_idxd_get_socket(struct spdk_idxd_device *idxd)
 	return idxd->socket_id;
 }
 
+static inline void
+_advance_portal(struct spdk_idxd_io_channel *chan)
+{
+	chan->portal_offset = (chan->portal_offset + chan->idxd->chan_per_device * PORTAL_STRIDE) &
+			      PORTAL_MASK;
+}
+
+/* Returns true if the shared WQ accepted the descriptor. */
+static inline bool
+_enqcmd(struct spdk_idxd_io_channel *chan, struct idxd_hw_desc *desc, uint32_t retries)
+{
+	while (enqcmd(chan->portal + chan->portal_offset, desc)) {
+		if (retries-- == 0) {
+			return false;
+		}
+		spdk_pause();
+	}
+
+	_advance_portal(chan);
+
+	return true;
+}
+
+static void
+_submit_deferred(struct spdk_idxd_io_channel *chan)
+{
+	struct idxd_ops *op;
+
+	while (chan->num_deferred > 0) {
+		op = chan->deferred[chan->deferred_head];
+		if (!_enqcmd(chan, op->desc, 0)) {
+			break;
+		}
+
+		chan->deferred_head = (chan->deferred_head + 1) % chan->max_deferred;
+		chan->num_deferred--;
+	}
+}
+
 static inline void
 _submit_to_hw(struct spdk_idxd_io_channel *chan, struct idxd_ops *op)
 {
@@ -41,9 +81,26 @@ _submit_to_hw(struct spdk_idxd_io_channel *chan, struct idxd_ops *op)
 	 * operations begin.
 	 */
 	_spdk_wmb();
-	movdir64b(chan->portal + chan->portal_offset, op->desc);
-	chan->portal_offset = (chan->portal_offset + chan->idxd->chan_per_device * PORTAL_STRIDE) &
-			      PORTAL_MASK;
+	if (spdk_likely(!chan->idxd->shared_wq)) {
+		movdir64b(chan->portal + chan->portal_offset, op->desc);
+		_advance_portal(chan);
+		return;
+	}
+
+	/*
+	 * A shared WQ may be filled up by its other clients.  Rather than spinning on the portal
+	 * until it drains, give up after a few retries and defer the descriptor to the next
+	 * spdk_idxd_process_events() or spdk_idxd_flush().  Anything submitted while there are
+	 * deferred descriptors is queued behind them to keep the submission order.
+	 */
+	if (spdk_likely(chan->num_deferred == 0) &&
+	    _enqcmd(chan, op->desc, IDXD_ENQCMD_MAX_RETRIES)) {
+		return;
+	}
+
+	assert(chan->num_deferred < chan->max_deferred);
+	chan->deferred[(chan->deferred_head + chan->num_deferred) % chan->max_deferred] = op;
+	chan->num_deferred++;
 }
 
 inline static int
@@ -265,6 +322,16 @@ spdk_idxd_get_channel(struct spdk_idxd_device *idxd)
 		goto error;
 	}
 
+	if (idxd->shared_wq) {
+		/* Every descriptor written to the portal comes from ops_pool */
+		chan->deferred = calloc(num_descriptors, sizeof(*chan->deferred));
+		if (chan->deferred == NULL) {
+			SPDK_ERRLOG("Failed to allocate the deferred submission ring\n");
+			goto error;
+		}
+		chan->max_deferred = num_descriptors;
+	}
+
 	if (idxd->type == IDXD_DEV_TYPE_DSA) {
 		comp_rec_size = sizeof(struct dsa_hw_comp_record);
 		if (_dsa_alloc_batches(chan, num_descriptors)) {
@@ -289,6 +356,7 @@ spdk_idxd_get_channel(struct spdk_idxd_device *idxd)
 	return chan;
 
 error:
+	free(chan->deferred);
 	spdk_free(chan->ops_base);
 	chan->ops_base = NULL;
 	spdk_free(chan->desc_base);
@@ -299,6 +367,14 @@ error:
 
 static int idxd_batch_cancel(struct spdk_idxd_io_channel *chan, int status);
 
+bool
+spdk_idxd_has_outstanding(struct spdk_idxd_io_channel *chan)
+{
+	assert(chan != NULL);
+
+	return chan->batch != NULL || !STAILQ_EMPTY(&chan->ops_outstanding);
+}
+
 void
 spdk_idxd_put_channel(struct spdk_idxd_io_channel *chan)
 {
@@ -324,6 +400,7 @@ spdk_idxd_put_channel(struct spdk_idxd_io_channel *chan)
 		spdk_free(batch->user_desc);
 	}
 	free(chan->batch_base);
+	free(chan->deferred);
 	free(chan);
 }
 
@@ -423,6 +500,7 @@ _idxd_prep_command(struct spdk_idxd_io_channel *chan, spdk_idxd_req_cb cb_fn, vo
 	op->batch = NULL;
 	op->parent = NULL;
 	op->count = 1;
+	op->status = 0;
 
 	return 0;
 }
@@ -440,7 +518,7 @@ _idxd_prep_batch_cmd(struct spdk_idxd_io_channel *chan, spdk_idxd_req_cb cb_fn,
 	batch = chan->batch;
 
 	assert(batch != NULL);
-	if (batch->index == DESC_PER_BATCH) {
+	if (batch->index == chan->idxd->batch_size) {
 		return -EBUSY;
 	}
 
@@ -463,6 +541,7 @@ _idxd_prep_batch_cmd(struct spdk_idxd_io_channel *chan, spdk_idxd_req_cb cb_fn,
 	op->batch = batch;
 	op->parent = NULL;
 	op->count = 1;
+	op->status = 0;
 	op->crc_dst = NULL;
 
 	return 0;
@@ -611,7 +690,7 @@ _idxd_flush_batch(struct spdk_idxd_io_channel *chan)
 {
 	int rc;
 
-	if (chan->batch != NULL && chan->batch->index >= DESC_PER_BATCH) {
+	if (chan->batch != NULL && chan->batch->index >= chan->idxd->batch_size) {
 		/* Close out the full batch */
 		rc = idxd_batch_submit(chan, NULL, NULL);
 		if (rc) {
@@ -1150,14 +1229,352 @@ error:
 	return rc;
 }
 
+static int
+idxd_get_dif_flags(const struct spdk_dif_ctx *ctx, uint8_t *flags)
+{
+	if (!ctx->md_interleave || ctx->md_size != IDXD_DIF_PI_SIZE ||
+	    ctx->dif_pi_format != SPDK_DIF_PI_FORMAT_16 || ctx->dif_type == SPDK_DIF_DISABLE) {
+		return -EOPNOTSUPP;
+	}
+
+	/* Partial blocks can't be described to the device */
+	if (ctx->data_offset % (ctx->block_size - ctx->md_size) != 0) {
+		return -EOPNOTSUPP;
+	}
+
+	switch (ctx->block_size - ctx->md_size) {
+	case 512:
+		*flags = IDXD_DIF_FLAG_DIF_BLOCK_SIZE_512;
+		break;
+	case 520:
+		*flags = IDXD_DIF_FLAG_DIF_BLOCK_SIZE_520;
+		break;
+	case 4096:
+		*flags = IDXD_DIF_FLAG_DIF_BLOCK_SIZE_4096;
+		break;
+	case 4104:
+		*flags = IDXD_DIF_FLAG_DIF_BLOCK_SIZE_4104;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	/* The device only seeds the guard with all zeroes or all ones */
+	if (ctx->guard_seed == 0xFFFF) {
+		*flags |= IDXD_DIF_FLAG_INVERT_CRC_SEED;
+	} else if (ctx->guard_seed != 0) {
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+static inline uint32_t
+idxd_get_dif_ref_tag(const struct spdk_dif_ctx *ctx, uint32_t offset_blocks)
+{
+	/* The reference tag stays the same for all the blocks with Type 3 */
+	if (ctx->dif_type == SPDK_DIF_TYPE3) {
+		offset_blocks = 0;
+	}
+
+	return (uint32_t)(ctx->init_ref_tag + ctx->ref_tag_offset + offset_blocks);
+}
+
+int
+spdk_idxd_submit_dif_check(struct spdk_idxd_io_channel *chan,
+			   struct iovec *siov, size_t siovcnt,
+			   uint32_t num_blocks, const struct spdk_dif_ctx *ctx, int flags,
+			   spdk_idxd_req_cb cb_fn, void *cb_arg)
+{
+	struct idxd_hw_desc *desc;
+	struct idxd_ops *first_op, *op;
+	uint64_t src_addr, len, seg_len;
+	uint32_t offset_blocks, seg_blocks;
+	uint8_t dif_flags, src_flags;
+	void *src;
+	size_t i;
+	int rc, count;
+
+	assert(chan != NULL);
+	assert(siov != NULL);
+
+	rc = idxd_get_dif_flags(ctx, &dif_flags);
+	if (rc) {
+		return rc;
+	}
+
+	if (spdk_unlikely(num_blocks == 0)) {
+		return -EINVAL;
+	}
+
+	for (i = 0, len = 0; i < siovcnt; i++) {
+		if (siov[i].iov_len % ctx->block_size != 0) {
+			return -EOPNOTSUPP;
+		}
+		len += siov[i].iov_len;
+	}
+
+	if (len != (uint64_t)num_blocks * ctx->block_size) {
+		return -EINVAL;
+	}
+
+	src_flags = 0;
+	if (!(ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK)) {
+		src_flags |= IDXD_DIF_SOURCE_FLAG_GUARD_CHECK_DISABLE;
+	}
+	if (!(ctx->dif_flags & SPDK_DIF_FLAGS_REFTAG_CHECK)) {
+		src_flags |= IDXD_DIF_SOURCE_FLAG_REF_TAG_CHECK_DISABLE;
+	}
+
+	/* Blocks with an escape tag aren't checked */
+	if (ctx->dif_type == SPDK_DIF_TYPE3) {
+		src_flags |= IDXD_DIF_SOURCE_FLAG_REF_TAG_TYPE;
+		src_flags |= IDXD_DIF_SOURCE_FLAG_APP_AND_REF_TAG_F_DETECT;
+	} else {
+		src_flags |= IDXD_DIF_SOURCE_FLAG_APP_TAG_F_DETECT;
+	}
+
+	rc = _idxd_setup_batch(chan);
+	if (rc) {
+		return rc;
+	}
+
+	count = 0;
+	first_op = NULL;
+	offset_blocks = 0;
+	for (i = 0; i < siovcnt; i++) {
+		len = siov[i].iov_len;
+		src = siov[i].iov_base;
+
+		while (len > 0) {
+			if (first_op == NULL) {
+				rc = _idxd_prep_batch_cmd(chan, cb_fn, cb_arg, flags, &desc, &op);
+				if (rc) {
+					goto error;
+				}
+
+				first_op = op;
+			} else {
+				rc = _idxd_prep_batch_cmd(chan, NULL, NULL, flags, &desc, &op);
+				if (rc) {
+					goto error;
+				}
+
+				first_op->count++;
+				op->parent = first_op;
+			}
+
+			count++;
+
+			seg_len = len;
+			if (chan->pasid_enabled) {
+				src_addr = (uint64_t)src;
+			} else {
+				src_addr = spdk_vtophys(src, &seg_len);
+				if (src_addr == SPDK_VTOPHYS_ERROR) {
+					SPDK_ERRLOG("Error translating address\n");
+					rc = -EFAULT;
+					goto error;
+				}
+			}
+
+			/* Each descriptor has to cover whole blocks */
+			seg_blocks = spdk_min(seg_len, len) / ctx->block_size;
+			if (seg_blocks == 0) {
+				rc = -EOPNOTSUPP;
+				goto error;
+			}
+			seg_len = (uint64_t)seg_blocks * ctx->block_size;
+
+			desc->opcode = IDXD_OPCODE_DIF_CHECK;
+			desc->src_addr = src_addr;
+			desc->xfer_size = seg_len;
+			desc->dif_chk.src_flags = src_flags;
+			desc->dif_chk.flags = dif_flags;
+			desc->dif_chk.ref_tag_seed = idxd_get_dif_ref_tag(ctx, offset_blocks);
+			/* Bits set in the device's mask are ignored, the opposite of apptag_mask */
+			if (ctx->dif_flags & SPDK_DIF_FLAGS_APPTAG_CHECK) {
+				desc->dif_chk.app_tag_mask = ~ctx->apptag_mask;
+			} else {
+				desc->dif_chk.app_tag_mask = 0xFFFF;
+			}
+			desc->dif_chk.app_tag_seed = ctx->app_tag;
+
+			offset_blocks += seg_blocks;
+			len -= seg_len;
+			src += seg_len;
+		}
+	}
+
+	return _idxd_flush_batch(chan);
+
+error:
+	chan->batch->index -= count;
+	return rc;
+}
+
+int
+spdk_idxd_submit_dif_insert(struct spdk_idxd_io_channel *chan,
+			    struct iovec *diov, size_t diovcnt,
+			    struct iovec *siov, size_t siovcnt,
+			    uint32_t num_blocks, const struct spdk_dif_ctx *ctx, int flags,
+			    spdk_idxd_req_cb cb_fn, void *cb_arg)
+{
+	struct idxd_hw_desc *desc;
+	struct idxd_ops *first_op, *op;
+	uint64_t src_addr, dst_addr, src_len, dst_len;
+	uint32_t data_block_size, offset_blocks, seg_blocks;
+	uint32_t check_flags;
+	uint8_t dif_flags, dest_flags;
+	size_t sidx, didx, soff, doff;
+	void *src, *dst;
+	int rc, count;
+
+	assert(chan != NULL);
+	assert(diov != NULL);
+	assert(siov != NULL);
+
+	rc = idxd_get_dif_flags(ctx, &dif_flags);
+	if (rc) {
+		return rc;
+	}
+
+	/* spdk_dif_generate_copy() leaves the fields that aren't enabled untouched, while the
+	 * device always writes the whole protection information */
+	check_flags = SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK |
+		      SPDK_DIF_FLAGS_REFTAG_CHECK;
+	if ((ctx->dif_flags & check_flags) != check_flags) {
+		return -EOPNOTSUPP;
+	}
+
+	if (spdk_unlikely(num_blocks == 0)) {
+		return -EINVAL;
+	}
+
+	data_block_size = ctx->block_size - ctx->md_size;
+	for (sidx = 0, src_len = 0; sidx < siovcnt; sidx++) {
+		if (siov[sidx].iov_len % data_block_size != 0) {
+			return -EOPNOTSUPP;
+		}
+		src_len += siov[sidx].iov_len;
+	}
+
+	for (didx = 0, dst_len = 0; didx < diovcnt; didx++) {
+		if (diov[didx].iov_len % ctx->block_size != 0) {
+			return -EOPNOTSUPP;
+		}
+		dst_len += diov[didx].iov_len;
+	}
+
+	if (src_len != (uint64_t)num_blocks * data_block_size ||
+	    dst_len < (uint64_t)num_blocks * ctx->block_size) {
+		return -EINVAL;
+	}
+
+	dest_flags = 0;
+	if (ctx->dif_type == SPDK_DIF_TYPE3) {
+		dest_flags |= IDXD_DIF_DEST_FLAG_REF_TAG_TYPE;
+	}
+
+	rc = _idxd_setup_batch(chan);
+	if (rc) {
+		return rc;
+	}
+
+	count = 0;
+	first_op = NULL;
+	offset_blocks = 0;
+	sidx = didx = 0;
+	soff = doff = 0;
+	while (offset_blocks < num_blocks) {
+		if (first_op == NULL) {
+			rc = _idxd_prep_batch_cmd(chan, cb_fn, cb_arg, flags, &desc, &op);
+			if (rc) {
+				goto error;
+			}
+
+			first_op = op;
+		} else {
+			rc = _idxd_prep_batch_cmd(chan, NULL, NULL, flags, &desc, &op);
+			if (rc) {
+				goto error;
+			}
+
+			first_op->count++;
+			op->parent = first_op;
+		}
+
+		count++;
+
+		src = (uint8_t *)siov[sidx].iov_base + soff;
+		dst = (uint8_t *)diov[didx].iov_base + doff;
+		seg_blocks = spdk_min((siov[sidx].iov_len - soff) / data_block_size,
+				      (diov[didx].iov_len - doff) / ctx->block_size);
+		seg_blocks = spdk_min(seg_blocks, num_blocks - offset_blocks);
+
+		src_len = (uint64_t)seg_blocks * data_block_size;
+		dst_len = (uint64_t)seg_blocks * ctx->block_size;
+		if (chan->pasid_enabled) {
+			src_addr = (uint64_t)src;
+			dst_addr = (uint64_t)dst;
+		} else {
+			src_addr = spdk_vtophys(src, &src_len);
+			dst_addr = spdk_vtophys(dst, &dst_len);
+			if (src_addr == SPDK_VTOPHYS_ERROR || dst_addr == SPDK_VTOPHYS_ERROR) {
+				SPDK_ERRLOG("Error translating address\n");
+				rc = -EFAULT;
+				goto error;
+			}
+
+			/* Each descriptor has to cover whole blocks */
+			seg_blocks = spdk_min(seg_blocks, spdk_min(src_len / data_block_size,
+					      dst_len / ctx->block_size));
+			if (seg_blocks == 0) {
+				rc = -EOPNOTSUPP;
+				goto error;
+			}
+		}
+
+		desc->opcode = IDXD_OPCODE_DIF_INS;
+		desc->src_addr = src_addr;
+		desc->dst_addr = dst_addr;
+		desc->xfer_size = seg_blocks * data_block_size;
+		desc->dif_ins.dest_flag = dest_flags;
+		desc->dif_ins.flags = dif_flags;
+		desc->dif_ins.ref_tag_seed = idxd_get_dif_ref_tag(ctx, offset_blocks);
+		desc->dif_ins.app_tag_mask = ~ctx->apptag_mask;
+		desc->dif_ins.app_tag_seed = ctx->app_tag;
+		_update_write_flags(chan, desc);
+
+		offset_blocks += seg_blocks;
+		soff += seg_blocks * data_block_size;
+		doff += seg_blocks * ctx->block_size;
+		if (soff == siov[sidx].iov_len) {
+			sidx++;
+			soff = 0;
+		}
+		if (doff == diov[didx].iov_len) {
+			didx++;
+			doff = 0;
+		}
+	}
+
+	return _idxd_flush_batch(chan);
+
+error:
+	chan->batch->index -= count;
+	return rc;
+}
+
 static inline int
 _idxd_submit_compress_single(struct spdk_idxd_io_channel *chan, void *dst, const void *src,
 			     uint64_t nbytes_dst, uint64_t nbytes_src, uint32_t *output_size,
+			     const struct spdk_idxd_huffman_table *table,
 			     int flags, spdk_idxd_req_cb cb_fn, void *cb_arg)
 {
 	struct idxd_hw_desc *desc;
 	struct idxd_ops *op;
-	uint64_t src_addr, dst_addr;
+	uint64_t src_addr, dst_addr, aecs_addr;
 	int rc;
 
 	/* Common prep. */
@@ -1176,6 +1593,15 @@ _idxd_submit_compress_single(struct spdk_idxd_io_channel *chan, void *dst, const
 		goto error;
 	}
 
+	if (table != NULL) {
+		rc = _vtophys(chan, table->aecs, &aecs_addr, sizeof(struct iaa_aecs));
+		if (rc) {
+			goto error;
+		}
+	} else {
+		aecs_addr = chan->idxd->aecs_addr;
+	}
+
 	/* Command specific. */
 	desc->opcode = IDXD_OPCODE_COMPRESS;
 	desc->src1_addr = src_addr;
@@ -1183,7 +1609,7 @@ _idxd_submit_compress_single(struct spdk_idxd_io_channel *chan, void *dst, const
 	desc->src1_size = nbytes_src;
 	desc->iaa.max_dst_size = nbytes_dst;
 	desc->iaa.src2_size = sizeof(struct iaa_aecs);
-	desc->iaa.src2_addr = chan->idxd->aecs_addr;
+	desc->iaa.src2_addr = aecs_addr;
 	desc->flags |= IAA_FLAG_RD_SRC2_AECS;
 	desc->compr_flags = IAA_COMP_FLAGS;
 	op->output_size = output_size;
@@ -1196,10 +1622,11 @@ error:
 }
 
 int
-spdk_idxd_submit_compress(struct spdk_idxd_io_channel *chan,
-			  void *dst, uint64_t nbytes,
-			  struct iovec *siov, uint32_t siovcnt, uint32_t *output_size,
-			  int flags, spdk_idxd_req_cb cb_fn, void *cb_arg)
+spdk_idxd_submit_compress_table(struct spdk_idxd_io_channel *chan,
+				void *dst, uint64_t nbytes,
+				struct iovec *siov, uint32_t siovcnt, uint32_t *output_size,
+				const struct spdk_idxd_huffman_table *table,
+				int flags, spdk_idxd_req_cb cb_fn, void *cb_arg)
 {
 	assert(chan != NULL);
 	assert(dst != NULL);
@@ -1213,12 +1640,74 @@ spdk_idxd_submit_compress(struct spdk_idxd_io_channel *chan,
 
 		return _idxd_submit_compress_single(chan, dst, siov[0].iov_base,
 						    nbytes, siov[0].iov_len,
-						    output_size, flags, cb_fn, cb_arg);
+						    output_size, table, flags, cb_fn, cb_arg);
 	}
 	/* TODO: vectored support */
 	return -EINVAL;
 }
 
+int
+spdk_idxd_submit_compress(struct spdk_idxd_io_channel *chan,
+			  void *dst, uint64_t nbytes,
+			  struct iovec *siov, uint32_t siovcnt, uint32_t *output_size,
+			  int flags, spdk_idxd_req_cb cb_fn, void *cb_arg)
+{
+	return spdk_idxd_submit_compress_table(chan, dst, nbytes, siov, siovcnt, output_size,
+					       NULL, flags, cb_fn, cb_arg);
+}
+
+int
+spdk_idxd_submit_compress_stats(struct spdk_idxd_io_channel *chan,
+				struct iovec *siov, uint32_t siovcnt,
+				struct spdk_idxd_huffman_table *table,
+				int flags, spdk_idxd_req_cb cb_fn, void *cb_arg)
+{
+	struct idxd_hw_desc *desc;
+	struct idxd_ops *op;
+	uint64_t src_addr, aecs_addr;
+	int rc;
+
+	assert(chan != NULL);
+	assert(siov != NULL);
+	assert(table != NULL);
+
+	/* TODO: vectored support */
+	if (siovcnt != 1) {
+		return -EINVAL;
+	}
+
+	/* Common prep. */
+	rc = _idxd_prep_command(chan, cb_fn, cb_arg, flags, &desc, &op);
+	if (rc) {
+		return rc;
+	}
+
+	rc = _vtophys(chan, siov[0].iov_base, &src_addr, siov[0].iov_len);
+	if (rc) {
+		goto error;
+	}
+
+	rc = _vtophys(chan, table->aecs, &aecs_addr, sizeof(struct iaa_aecs));
+	if (rc) {
+		goto error;
+	}
+
+	/* Command specific.  No output is produced, the histogram is written to the AECS. */
+	desc->opcode = IDXD_OPCODE_COMPRESS;
+	desc->src1_addr = src_addr;
+	desc->src1_size = siov[0].iov_len;
+	desc->iaa.src2_size = sizeof(struct iaa_aecs);
+	desc->iaa.src2_addr = aecs_addr;
+	desc->flags |= IAA_FLAG_WR_SRC2_AECS_COMPL;
+	desc->compr_flags = IAA_COMP_STATS_MODE;
+
+	_submit_to_hw(chan, op);
+	return 0;
+error:
+	STAILQ_INSERT_TAIL(&chan->ops_pool, op, link);
+	return rc;
+}
+
 static inline int
 _idxd_submit_decompress_single(struct spdk_idxd_io_channel *chan, void *dst, const void *src,
 			       uint64_t nbytes_dst, uint64_t nbytes, int flags, spdk_idxd_req_cb cb_fn, void *cb_arg)
@@ -1332,13 +1821,17 @@ int
 spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 {
 	struct idxd_ops *op, *tmp, *parent_op;
-	int status = 0;
-	int rc2, rc = 0;
+	int status = 0, op_status;
+	int rc = 0;
 	void *cb_arg;
 	spdk_idxd_req_cb cb_fn;
 
 	assert(chan != NULL);
 
+	if (spdk_unlikely(chan->num_deferred > 0)) {
+		_submit_deferred(chan);
+	}
+
 	STAILQ_FOREACH_SAFE(op, &chan->ops_outstanding, link, tmp) {
 		if (!IDXD_COMPLETION(op->hw.status)) {
 			/*
@@ -1354,9 +1847,17 @@ spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 
 		/* Status is in the same location for both IAA and DSA completion records. */
 		if (spdk_unlikely(IDXD_FAILURE(op->hw.status))) {
-			SPDK_ERRLOG("Completion status 0x%x\n", op->hw.status);
-			status = -EINVAL;
-			_dump_sw_error_reg(chan);
+			if (op->hw.status == DSA_COMP_DIF_ERR &&
+			    (op->desc->opcode == IDXD_OPCODE_DIF_CHECK ||
+			     op->desc->opcode == IDXD_OPCODE_DIF_INS)) {
+				/* A protection information mismatch, not a device error */
+				SPDK_DEBUGLOG(idxd, "DIF error, status 0x%x\n", op->hw.dif_status);
+				status = -EIO;
+			} else {
+				SPDK_ERRLOG("Completion status 0x%x\n", op->hw.status);
+				status = -EINVAL;
+				_dump_sw_error_reg(chan);
+			}
 		}
 
 		switch (op->desc->opcode) {
@@ -1385,10 +1886,20 @@ spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 		/* TODO: WHAT IF THIS FAILED!? */
 		op->hw.status = 0;
 
+		/* Report the first failure of a request split into multiple descriptors, which
+		 * might not be the last one to complete */
+		parent_op = op->parent;
+		if (spdk_unlikely(status != 0)) {
+			if (parent_op != NULL && parent_op->status == 0) {
+				parent_op->status = status;
+			} else if (parent_op == NULL && op->status == 0) {
+				op->status = status;
+			}
+		}
+
 		assert(op->count > 0);
 		op->count--;
 
-		parent_op = op->parent;
 		if (parent_op != NULL) {
 			assert(parent_op->count > 0);
 			parent_op->count--;
@@ -1396,6 +1907,7 @@ spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 			if (parent_op->count == 0) {
 				cb_fn = parent_op->cb_fn;
 				cb_arg = parent_op->cb_arg;
+				op_status = parent_op->status;
 
 				assert(parent_op->batch != NULL);
 
@@ -1410,7 +1922,7 @@ spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 				}
 
 				if (cb_fn) {
-					cb_fn(cb_arg, status);
+					cb_fn(cb_arg, op_status);
 				}
 			}
 		}
@@ -1418,6 +1930,7 @@ spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 		if (op->count == 0) {
 			cb_fn = op->cb_fn;
 			cb_arg = op->cb_arg;
+			op_status = parent_op == NULL ? op->status : status;
 
 			if (op->batch != NULL) {
 				assert(op->batch->refcnt > 0);
@@ -1431,7 +1944,7 @@ spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 			}
 
 			if (cb_fn) {
-				cb_fn(cb_arg, status);
+				cb_fn(cb_arg, op_status);
 			}
 		}
 
@@ -1444,16 +1957,37 @@ spdk_idxd_process_events(struct spdk_idxd_io_channel *chan)
 	}
 
 	/* Submit any built-up batch */
-	if (chan->batch) {
-		rc2 = idxd_batch_submit(chan, NULL, NULL);
-		if (rc2) {
-			assert(rc2 == -EBUSY);
-		}
-	}
+	spdk_idxd_flush(chan);
 
 	return rc;
 }
 
+int
+spdk_idxd_flush(struct spdk_idxd_io_channel *chan)
+{
+	int count, rc;
+
+	assert(chan != NULL);
+
+	if (spdk_unlikely(chan->num_deferred > 0)) {
+		_submit_deferred(chan);
+	}
+
+	if (chan->batch == NULL) {
+		return 0;
+	}
+
+	count = chan->batch->index;
+	rc = idxd_batch_submit(chan, NULL, NULL);
+	if (rc) {
+		/* The batch stays open and will be retried on the next flush. */
+		assert(rc == -EBUSY);
+		return rc;
+	}
+
+	return count;
+}
+
 void
 idxd_impl_register(struct spdk_idxd_impl *impl)
 {
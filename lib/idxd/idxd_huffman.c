@@ -0,0 +1,402 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/util.h"
+
+#include "spdk/log.h"
+
+#include "idxd_internal.h"
+
+/* Limits imposed by RFC-1951 on the lengths of the Huffman codes */
+#define HUFFMAN_MAX_BITS	15
+#define CL_MAX_BITS		7
+#define CL_SYMBOLS		19
+
+/* Code-length code symbols used to run-length encode the code lengths */
+#define CL_REPEAT_PREV		16
+#define CL_REPEAT_ZERO_SHORT	17
+#define CL_REPEAT_ZERO_LONG	18
+
+#define DEFLATE_EOB		256
+#define DEFLATE_BTYPE_DYNAMIC	2
+
+/* Format of the entries of the literal/length and distance tables in the AECS */
+#define AECS_SYM_LEN_SHIFT	15
+#define AECS_SYM_CODE_MASK	0x7fff
+
+#define AECS_OUTPUT_ACCUM_BITS	(SPDK_SIZEOF_MEMBER(struct iaa_aecs, output_accum) * 8)
+
+#define HUFFMAN_MAX_SYMBOLS	SPDK_IDXD_HUFFMAN_LL_SYMBOLS
+
+/* Order in which the code lengths of the code-length code are stored in the header */
+static const uint8_t g_cl_order[CL_SYMBOLS] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+struct huffman_bit_writer {
+	uint8_t		*buf;
+	uint32_t	num_bits;
+	uint32_t	max_bits;
+};
+
+struct huffman_node {
+	uint32_t	freq;
+	uint16_t	sym;
+};
+
+struct spdk_idxd_huffman_table *
+spdk_idxd_huffman_table_alloc(void)
+{
+	struct spdk_idxd_huffman_table *table;
+
+	table = calloc(1, sizeof(*table));
+	if (table == NULL) {
+		return NULL;
+	}
+
+	table->aecs = spdk_zmalloc(sizeof(struct iaa_aecs), 0x20, NULL,
+				   SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (table->aecs == NULL) {
+		SPDK_ERRLOG("Failed to allocate iaa aecs\n");
+		free(table);
+		return NULL;
+	}
+
+	return table;
+}
+
+void
+spdk_idxd_huffman_table_free(struct spdk_idxd_huffman_table *table)
+{
+	if (table == NULL) {
+		return;
+	}
+
+	spdk_free(table->aecs);
+	free(table);
+}
+
+void
+spdk_idxd_huffman_table_get_histogram(const struct spdk_idxd_huffman_table *table,
+				      struct spdk_idxd_huffman_histogram *hist)
+{
+	/* In statistics mode, the hardware writes the histogram in place of the tables */
+	memcpy(hist->ll, table->aecs->ll_sym, sizeof(hist->ll));
+	memcpy(hist->d, table->aecs->d_sym, sizeof(hist->d));
+}
+
+static int
+huffman_node_cmp(const void *_a, const void *_b)
+{
+	const struct huffman_node *a = _a, *b = _b;
+
+	if (a->freq != b->freq) {
+		return a->freq < b->freq ? -1 : 1;
+	}
+
+	return (int)a->sym - (int)b->sym;
+}
+
+/*
+ * Calculate the lengths of the Huffman codes of the symbols with non-zero frequency,
+ * limited to max_bits.  The Huffman tree is built in place (Moffat-Katajainen) and the
+ * codes exceeding the limit are then shortened by moving leaves down the tree until the
+ * Kraft sum is satisfied again.
+ */
+static void
+huffman_build_lengths(const uint32_t *freq, uint32_t num_syms, uint32_t max_bits,
+		      uint8_t *lens)
+{
+	struct huffman_node nodes[HUFFMAN_MAX_SYMBOLS];
+	uint32_t parent[HUFFMAN_MAX_SYMBOLS], bl_count[HUFFMAN_MAX_BITS + 1] = {};
+	uint32_t n = 0, i, leaf, root, next, bits, kraft;
+
+	assert(num_syms <= HUFFMAN_MAX_SYMBOLS && max_bits <= HUFFMAN_MAX_BITS);
+	memset(lens, 0, num_syms);
+
+	for (i = 0; i < num_syms; i++) {
+		if (freq[i] != 0) {
+			nodes[n].freq = freq[i];
+			nodes[n].sym = i;
+			n++;
+		}
+	}
+
+	if (n == 0) {
+		return;
+	} else if (n == 1) {
+		lens[nodes[0].sym] = 1;
+		return;
+	}
+
+	qsort(nodes, n, sizeof(nodes[0]), huffman_node_cmp);
+
+	/* First pass: combine the two lightest nodes, storing the parent of each internal node */
+	leaf = 0;
+	root = 0;
+	for (next = 0; next < n - 1; next++) {
+		uint32_t w;
+
+		if (leaf >= n || (root < next && nodes[root].freq < nodes[leaf].freq)) {
+			w = nodes[root].freq;
+			parent[root++] = next;
+		} else {
+			w = nodes[leaf++].freq;
+		}
+
+		if (leaf >= n || (root < next && nodes[root].freq < nodes[leaf].freq)) {
+			w += nodes[root].freq;
+			parent[root++] = next;
+		} else {
+			w += nodes[leaf++].freq;
+		}
+
+		nodes[next].freq = w;
+	}
+
+	/* Second pass: depth of the internal nodes, the root being the last one */
+	parent[n - 2] = 0;
+	for (i = n - 2; i-- > 0;) {
+		parent[i] = parent[parent[i]] + 1;
+	}
+
+	/* Third pass: number of leaves at each depth */
+	{
+		uint32_t avail = 1, used = 0, depth = 0;
+		int32_t idx = (int32_t)n - 2;
+
+		while (avail > 0) {
+			while (idx >= 0 && parent[idx] == depth) {
+				used++;
+				idx--;
+			}
+			while (avail > used) {
+				bl_count[spdk_min(depth, max_bits)]++;
+				avail--;
+			}
+			avail = 2 * used;
+			depth++;
+			used = 0;
+		}
+	}
+
+	/* Clamping the lengths might have oversubscribed the code, fix up the Kraft sum */
+	kraft = 0;
+	for (bits = 1; bits <= max_bits; bits++) {
+		kraft += bl_count[bits] << (max_bits - bits);
+	}
+	while (kraft > (1u << max_bits)) {
+		bl_count[max_bits]--;
+		for (bits = max_bits - 1; bits > 0; bits--) {
+			if (bl_count[bits] != 0) {
+				bl_count[bits]--;
+				bl_count[bits + 1] += 2;
+				break;
+			}
+		}
+		kraft--;
+	}
+
+	/* The least frequent symbols (sorted first) get the longest codes */
+	i = 0;
+	for (bits = max_bits; bits > 0; bits--) {
+		for (leaf = 0; leaf < bl_count[bits]; leaf++) {
+			lens[nodes[i++].sym] = bits;
+		}
+	}
+	assert(i == n);
+}
+
+/* Assign the canonical codes (most significant bit first) described by the code lengths */
+static void
+huffman_build_codes(const uint8_t *lens, uint32_t num_syms, uint16_t *codes)
+{
+	uint32_t bl_count[HUFFMAN_MAX_BITS + 1] = {}, next_code[HUFFMAN_MAX_BITS + 1];
+	uint32_t i, code = 0;
+
+	for (i = 0; i < num_syms; i++) {
+		bl_count[lens[i]]++;
+	}
+
+	bl_count[0] = 0;
+	for (i = 1; i <= HUFFMAN_MAX_BITS; i++) {
+		code = (code + bl_count[i - 1]) << 1;
+		next_code[i] = code;
+	}
+
+	for (i = 0; i < num_syms; i++) {
+		codes[i] = lens[i] != 0 ? next_code[lens[i]]++ : 0;
+	}
+}
+
+static void
+huffman_write_bits(struct huffman_bit_writer *w, uint32_t value, uint32_t num_bits)
+{
+	uint32_t i;
+
+	for (i = 0; i < num_bits; i++, w->num_bits++) {
+		if (w->num_bits >= w->max_bits) {
+			/* Keep counting, the caller checks for overflow at the end */
+			continue;
+		}
+		if (value & (1u << i)) {
+			w->buf[w->num_bits / 8] |= 1u << (w->num_bits % 8);
+		}
+	}
+}
+
+/* Huffman codes are packed starting with their most significant bit */
+static void
+huffman_write_code(struct huffman_bit_writer *w, uint16_t code, uint8_t len)
+{
+	uint32_t rev = 0, i;
+
+	for (i = 0; i < len; i++) {
+		rev |= ((code >> i) & 1) << (len - 1 - i);
+	}
+
+	huffman_write_bits(w, rev, len);
+}
+
+/*
+ * Run-length encode the code lengths of both codes into code-length code symbols.  The
+ * repeat counts are stored in the upper byte of each entry.  A repetition of the previous
+ * length may cross from the literal/length lengths to the distance lengths.
+ */
+static uint32_t
+huffman_rle_lengths(const uint8_t *lens, uint32_t num_lens, uint16_t *rle)
+{
+	uint32_t i = 0, n = 0, run;
+
+	while (i < num_lens) {
+		for (run = 1; i + run < num_lens && lens[i + run] == lens[i]; run++);
+
+		if (lens[i] == 0 && run >= 3) {
+			run = spdk_min(run, 138);
+			if (run <= 10) {
+				rle[n++] = CL_REPEAT_ZERO_SHORT | ((run - 3) << 8);
+			} else {
+				rle[n++] = CL_REPEAT_ZERO_LONG | ((run - 11) << 8);
+			}
+			i += run;
+		} else if (i > 0 && lens[i] == lens[i - 1] && run >= 3) {
+			run = spdk_min(run, 6);
+			rle[n++] = CL_REPEAT_PREV | ((run - 3) << 8);
+			i += run;
+		} else {
+			rle[n++] = lens[i++];
+		}
+	}
+
+	return n;
+}
+
+int
+spdk_idxd_huffman_table_build(struct spdk_idxd_huffman_table *table,
+			      const struct spdk_idxd_huffman_histogram *hist, bool complete)
+{
+	struct iaa_aecs *aecs = table->aecs;
+	uint32_t ll_freq[SPDK_IDXD_HUFFMAN_LL_SYMBOLS], d_freq[SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+	uint32_t cl_freq[CL_SYMBOLS] = {};
+	uint8_t lens[SPDK_IDXD_HUFFMAN_LL_SYMBOLS + SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+	uint8_t ll_lens[SPDK_IDXD_HUFFMAN_LL_SYMBOLS], d_lens[SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+	uint8_t cl_lens[CL_SYMBOLS];
+	uint16_t ll_codes[SPDK_IDXD_HUFFMAN_LL_SYMBOLS], d_codes[SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+	uint16_t rle[SPDK_IDXD_HUFFMAN_LL_SYMBOLS + SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+	uint16_t cl_codes[CL_SYMBOLS];
+	struct huffman_bit_writer w;
+	uint32_t i, num_ll, num_d, num_cl, num_rle, sym;
+
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_LL_SYMBOLS; i++) {
+		ll_freq[i] = complete ? spdk_max(hist->ll[i], 1) : hist->ll[i];
+	}
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_D_SYMBOLS; i++) {
+		d_freq[i] = complete ? spdk_max(hist->d[i], 1) : hist->d[i];
+	}
+	/* The hardware always terminates the block */
+	ll_freq[DEFLATE_EOB] = spdk_max(ll_freq[DEFLATE_EOB], 1);
+
+	huffman_build_lengths(ll_freq, SPDK_IDXD_HUFFMAN_LL_SYMBOLS, HUFFMAN_MAX_BITS, ll_lens);
+	huffman_build_lengths(d_freq, SPDK_IDXD_HUFFMAN_D_SYMBOLS, HUFFMAN_MAX_BITS, d_lens);
+	huffman_build_codes(ll_lens, SPDK_IDXD_HUFFMAN_LL_SYMBOLS, ll_codes);
+	huffman_build_codes(d_lens, SPDK_IDXD_HUFFMAN_D_SYMBOLS, d_codes);
+
+	for (num_ll = SPDK_IDXD_HUFFMAN_LL_SYMBOLS; ll_lens[num_ll - 1] == 0; num_ll--);
+	for (num_d = SPDK_IDXD_HUFFMAN_D_SYMBOLS; num_d > 1 && d_lens[num_d - 1] == 0; num_d--);
+
+	/* The distance lengths directly follow the used literal/length lengths */
+	memcpy(lens, ll_lens, num_ll);
+	memcpy(&lens[num_ll], d_lens, num_d);
+	num_rle = huffman_rle_lengths(lens, num_ll + num_d, rle);
+
+	for (i = 0; i < num_rle; i++) {
+		cl_freq[rle[i] & 0xff]++;
+	}
+	/* A code-length code with a single symbol would be incomplete, add a dummy one */
+	for (i = 0, sym = 0; i < CL_SYMBOLS; i++) {
+		sym += cl_freq[i] != 0;
+	}
+	if (sym == 1) {
+		cl_freq[cl_freq[0] == 0 ? 0 : 1] = 1;
+	}
+
+	huffman_build_lengths(cl_freq, CL_SYMBOLS, CL_MAX_BITS, cl_lens);
+	huffman_build_codes(cl_lens, CL_SYMBOLS, cl_codes);
+	for (num_cl = CL_SYMBOLS; num_cl > 4 && cl_lens[g_cl_order[num_cl - 1]] == 0; num_cl--);
+
+	/* Now write the header of the dynamic block, to be emitted before the compressed data */
+	memset(aecs, 0, sizeof(*aecs));
+	w.buf = aecs->output_accum;
+	w.num_bits = 0;
+	w.max_bits = AECS_OUTPUT_ACCUM_BITS;
+
+	huffman_write_bits(&w, 1, 1);
+	huffman_write_bits(&w, DEFLATE_BTYPE_DYNAMIC, 2);
+	huffman_write_bits(&w, num_ll - 257, 5);
+	huffman_write_bits(&w, num_d - 1, 5);
+	huffman_write_bits(&w, num_cl - 4, 4);
+	for (i = 0; i < num_cl; i++) {
+		huffman_write_bits(&w, cl_lens[g_cl_order[i]], 3);
+	}
+
+	for (i = 0; i < num_rle; i++) {
+		sym = rle[i] & 0xff;
+		huffman_write_code(&w, cl_codes[sym], cl_lens[sym]);
+		switch (sym) {
+		case CL_REPEAT_PREV:
+			huffman_write_bits(&w, rle[i] >> 8, 2);
+			break;
+		case CL_REPEAT_ZERO_SHORT:
+			huffman_write_bits(&w, rle[i] >> 8, 3);
+			break;
+		case CL_REPEAT_ZERO_LONG:
+			huffman_write_bits(&w, rle[i] >> 8, 7);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (w.num_bits > w.max_bits) {
+		SPDK_DEBUGLOG(idxd, "Dynamic block header too large (%u bits)\n", w.num_bits);
+		memset(aecs, 0, sizeof(*aecs));
+		return -EINVAL;
+	}
+	aecs->num_output_accum_bits = w.num_bits;
+
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_LL_SYMBOLS; i++) {
+		aecs->ll_sym[i] = ((uint32_t)ll_lens[i] << AECS_SYM_LEN_SHIFT) |
+				  (ll_codes[i] & AECS_SYM_CODE_MASK);
+	}
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_D_SYMBOLS; i++) {
+		aecs->d_sym[i] = ((uint32_t)d_lens[i] << AECS_SYM_LEN_SHIFT) |
+				 (d_codes[i] & AECS_SYM_CODE_MASK);
+	}
+
+	return 0;
+}
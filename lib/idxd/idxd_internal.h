@@ -26,6 +26,23 @@ static inline void movdir64b(void *dst, const void *src)
 		     : "d"(src), "a"(dst));
 }
 
+/* Returns true if a shared WQ did not accept the descriptor and it needs to be resubmitted. */
+static inline bool enqcmd(void *dst, const void *src)
+{
+	uint8_t retry;
+
+	asm volatile(".byte 0xf2, 0x0f, 0x38, 0xf8, 0x02\n\t"
+		     "setz %0"
+		     : "=q"(retry), "=m"(*(char *)dst)
+		     : "d"(src), "a"(dst)
+		     : "cc", "memory");
+
+	return retry;
+}
+
+/* ENQCMD retries before a descriptor rejected by a full shared WQ is deferred */
+#define IDXD_ENQCMD_MAX_RETRIES			32
+
 #define IDXD_REGISTER_TIMEOUT_US		50
 #define IDXD_DRAIN_TIMEOUT_US			500000
 
@@ -91,6 +108,15 @@ struct spdk_idxd_io_channel {
 
 	TAILQ_HEAD(, idxd_batch)		batch_pool;
 	void					*batch_base;
+
+	/*
+	 * Ring of descriptors a full shared WQ didn't accept, in submission order. They're
+	 * already on ops_outstanding and are resubmitted before anything else.
+	 */
+	struct idxd_ops				**deferred;
+	uint32_t				deferred_head;
+	uint32_t				num_deferred;
+	uint32_t				max_deferred;
 };
 
 struct pci_dev_id {
@@ -117,6 +143,8 @@ struct idxd_ops {
 	};
 	struct idxd_ops			*parent;
 	uint32_t			count;
+	/* First error reported by any of the descriptors of a request */
+	int				status;
 	STAILQ_ENTRY(idxd_ops)		link;
 };
 SPDK_STATIC_ASSERT(sizeof(struct idxd_ops) == 128, "size mismatch");
@@ -139,14 +167,21 @@ struct spdk_idxd_device {
 	uint32_t			num_channels;
 	uint32_t			total_wq_size;
 	uint32_t			chan_per_device;
+	/* Max number of descriptors in a batch, at most DESC_PER_BATCH */
+	uint32_t			batch_size;
 	pthread_mutex_t			num_channels_lock;
 	bool				pasid_enabled;
+	bool				shared_wq;
 	enum idxd_dev			type;
 	struct iaa_aecs			*aecs;
 	uint64_t			aecs_addr;
 	uint32_t			version;
 };
 
+struct spdk_idxd_huffman_table {
+	struct iaa_aecs			*aecs;
+};
+
 void idxd_impl_register(struct spdk_idxd_impl *impl);
 
 #define SPDK_IDXD_IMPL_REGISTER(name, impl) \
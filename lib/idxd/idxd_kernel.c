@@ -98,6 +98,9 @@ kernel_idxd_probe(void *cb_ctx, spdk_idxd_attach_cb attach_cb, spdk_idxd_probe_c
 
 		kernel_idxd->max_batch_size = accfg_device_get_max_batch_size(device);
 		kernel_idxd->max_xfer_size = accfg_device_get_max_transfer_size(device);
+		/* The kernel may have configured a smaller limit than the one we allocate for */
+		kernel_idxd->idxd.batch_size = spdk_min(kernel_idxd->max_batch_size, DESC_PER_BATCH);
+		kernel_idxd->idxd.batch_size = spdk_max(kernel_idxd->idxd.batch_size, 1);
 		kernel_idxd->idxd.socket_id = accfg_device_get_numa_node(device);
 		kernel_idxd->idxd.impl = &g_kernel_idxd_impl;
 		kernel_idxd->fd = -1;
@@ -121,9 +124,9 @@ kernel_idxd_probe(void *cb_ctx, spdk_idxd_attach_cb attach_cb, spdk_idxd_probe_c
 				continue;
 			}
 
-			/* TODO: For now, only support dedicated WQ */
+			/* Shared WQs are submitted to with ENQCMD, which requires PASID. */
 			mode = accfg_wq_get_mode(wq);
-			if (mode != ACCFG_WQ_DEDICATED) {
+			if (mode == ACCFG_WQ_SHARED && !pasid_enabled) {
 				continue;
 			}
 
@@ -154,6 +157,7 @@ kernel_idxd_probe(void *cb_ctx, spdk_idxd_attach_cb attach_cb, spdk_idxd_probe_c
 			}
 
 			kernel_idxd->wq = wq;
+			kernel_idxd->idxd.shared_wq = (mode == ACCFG_WQ_SHARED);
 
 			/* Since we only use a single WQ, the total size is the size of this WQ */
 			kernel_idxd->idxd.total_wq_size = accfg_wq_get_size(wq);
@@ -42,10 +42,6 @@
  *
  */
 
-struct load_json_config_ctx;
-typedef void (*client_resp_handler)(struct load_json_config_ctx *,
-				    struct spdk_jsonrpc_client_response *);
-
 #define RPC_SOCKET_PATH_MAX SPDK_SIZEOF_MEMBER(struct sockaddr_un, sun_path)
 
 /* 1s connections timeout */
@@ -57,6 +53,52 @@ typedef void (*client_resp_handler)(struct load_json_config_ctx *,
  * So just print WARNLOG every 10s. */
 #define RPC_CLIENT_REQUEST_TIMEOUT_US (10U * 1000 * 1000)
 
+/* Upper limit of config entries executed at the same time, each one uses its own connection */
+#define JSON_CONFIG_MAX_PARALLEL 32
+
+/* Number of config entries searched ahead for ones that can be executed out of order */
+#define JSON_CONFIG_WINDOW_SIZE 64
+
+/* Object names remembered for a single config entry, entries naming more are barriers */
+#define CONFIG_ENTRY_MAX_KEYS 16
+
+enum json_config_phase {
+	JSON_CONFIG_PHASE_PARSE,
+	JSON_CONFIG_PHASE_STARTUP,
+	JSON_CONFIG_PHASE_INIT,
+	JSON_CONFIG_PHASE_RUNTIME,
+	JSON_CONFIG_NUM_PHASES,
+};
+
+/*
+ * Config entry scheduled for execution.
+ *
+ * When more than one connection is used, an entry may run concurrently with the other entries
+ * of the same subsystem as long as they don't refer to the same objects. The objects are
+ * identified by the string values of the entry params (e.g. bdev names or subsystem NQNs).
+ * Entries that don't name an object ("name" or "nqn" param) are barriers: they wait for all
+ * the previous entries and nothing after them starts before they complete.
+ */
+struct load_json_config_entry {
+	char *method;
+	struct spdk_json_val *params;
+	bool barrier;
+	size_t num_keys;
+	const struct spdk_json_val *keys[CONFIG_ENTRY_MAX_KEYS];
+	TAILQ_ENTRY(load_json_config_entry) link;
+};
+
+struct load_json_config_conn {
+	struct spdk_jsonrpc_client *client;
+	bool connected;
+
+	/* Config entry being executed, NULL if the connection is idle. */
+	struct load_json_config_entry *entry;
+
+	/* Timeout for current RPC client action. */
+	uint64_t timeout;
+};
+
 struct load_json_config_ctx {
 	/* Thread used during configuration. */
 	struct spdk_thread *thread;
@@ -74,6 +116,12 @@ struct load_json_config_ctx {
 	struct spdk_json_val *config; /* "config" array */
 	struct spdk_json_val *config_it; /* current config position in "config" array */
 
+	/* Entries read from "config" array but not sent yet, in the config order. */
+	TAILQ_HEAD(, load_json_config_entry) pending;
+	uint32_t num_pending;
+	uint32_t num_inflight;
+	uint32_t window_size;
+
 	/* Current request id we are sending. */
 	uint32_t rpc_request_id;
 
@@ -86,28 +134,93 @@ struct load_json_config_ctx {
 
 	char rpc_socket_path_temp[RPC_SOCKET_PATH_MAX + 1];
 
-	struct spdk_jsonrpc_client *client_conn;
+	struct load_json_config_conn conns[JSON_CONFIG_MAX_PARALLEL];
+	uint32_t num_conns;
 	struct spdk_poller *client_conn_poller;
 
-	client_resp_handler client_resp_cb;
-
-	/* Timeout for current RPC client action. */
+	/* Timeout for connecting the RPC clients. */
 	uint64_t timeout;
+
+	/* Statistics reported once the configuration is loaded. */
+	uint64_t phase_start_tsc;
+	uint64_t phase_tsc[JSON_CONFIG_NUM_PHASES];
+	uint32_t num_entries[JSON_CONFIG_NUM_PHASES];
+	uint32_t max_inflight;
 };
 
 static void app_json_config_load_subsystem(void *_ctx);
 
+static void
+app_json_config_phase_done(struct load_json_config_ctx *ctx, enum json_config_phase phase)
+{
+	uint64_t now = spdk_get_ticks();
+
+	ctx->phase_tsc[phase] = now - ctx->phase_start_tsc;
+	ctx->phase_start_tsc = now;
+}
+
+static double
+tsc_to_ms(uint64_t tsc)
+{
+	return (double)tsc * 1000 / spdk_get_ticks_hz();
+}
+
+static void
+app_json_config_print_stats(struct load_json_config_ctx *ctx)
+{
+	uint64_t total = 0;
+	int i;
+
+	for (i = 0; i < JSON_CONFIG_NUM_PHASES; i++) {
+		total += ctx->phase_tsc[i];
+	}
+
+	SPDK_NOTICELOG("JSON configuration loaded in %.1f ms: parse %.1f ms, startup %.1f ms "
+		       "(%"PRIu32" RPCs), subsystem init %.1f ms, runtime %.1f ms (%"PRIu32" RPCs), "
+		       "up to %"PRIu32" RPCs in parallel\n", tsc_to_ms(total),
+		       tsc_to_ms(ctx->phase_tsc[JSON_CONFIG_PHASE_PARSE]),
+		       tsc_to_ms(ctx->phase_tsc[JSON_CONFIG_PHASE_STARTUP]),
+		       ctx->num_entries[JSON_CONFIG_PHASE_STARTUP],
+		       tsc_to_ms(ctx->phase_tsc[JSON_CONFIG_PHASE_INIT]),
+		       tsc_to_ms(ctx->phase_tsc[JSON_CONFIG_PHASE_RUNTIME]),
+		       ctx->num_entries[JSON_CONFIG_PHASE_RUNTIME], ctx->max_inflight);
+}
+
+static void
+config_entry_free(struct load_json_config_entry *entry)
+{
+	free(entry->method);
+	free(entry);
+}
+
 static void
 app_json_config_load_done(struct load_json_config_ctx *ctx, int rc)
 {
+	struct load_json_config_entry *entry;
+	uint32_t i;
+
 	spdk_poller_unregister(&ctx->client_conn_poller);
-	if (ctx->client_conn != NULL) {
-		spdk_jsonrpc_client_close(ctx->client_conn);
+	for (i = 0; i < ctx->num_conns; i++) {
+		if (ctx->conns[i].client != NULL) {
+			spdk_jsonrpc_client_close(ctx->conns[i].client);
+		}
+		if (ctx->conns[i].entry != NULL) {
+			config_entry_free(ctx->conns[i].entry);
+		}
+	}
+
+	while ((entry = TAILQ_FIRST(&ctx->pending)) != NULL) {
+		TAILQ_REMOVE(&ctx->pending, entry, link);
+		config_entry_free(entry);
 	}
 
 	spdk_rpc_finish();
 
 	SPDK_DEBUG_APP_CFG("Config load finished with rc %d\n", rc);
+	if (rc == 0) {
+		app_json_config_print_stats(ctx);
+	}
+
 	ctx->cb_fn(rc, ctx->cb_arg);
 
 	free(ctx->json_data);
@@ -116,15 +229,15 @@ app_json_config_load_done(struct load_json_config_ctx *ctx, int rc)
 }
 
 static void
-rpc_client_set_timeout(struct load_json_config_ctx *ctx, uint64_t timeout_us)
+rpc_client_set_timeout(uint64_t *timeout, uint64_t timeout_us)
 {
-	ctx->timeout = spdk_get_ticks() + timeout_us * spdk_get_ticks_hz() / (1000 * 1000);
+	*timeout = spdk_get_ticks() + timeout_us * spdk_get_ticks_hz() / (1000 * 1000);
 }
 
 static int
-rpc_client_check_timeout(struct load_json_config_ctx *ctx)
+rpc_client_check_timeout(uint64_t timeout)
 {
-	if (ctx->timeout < spdk_get_ticks()) {
+	if (timeout < spdk_get_ticks()) {
 		SPDK_WARNLOG("RPC client command timeout.\n");
 		return -ETIMEDOUT;
 	}
@@ -151,34 +264,29 @@ json_write_stdout(void *cb_ctx, const void *data, size_t size)
 	return rc == size ? 0 : -1;
 }
 
+/* Returns 1 if the entry executed on the connection has completed, 0 if it's still running */
 static int
-rpc_client_poller(void *arg)
+rpc_client_poll_conn(struct load_json_config_ctx *ctx, struct load_json_config_conn *conn)
 {
-	struct load_json_config_ctx *ctx = arg;
 	struct spdk_jsonrpc_client_response *resp;
-	client_resp_handler cb;
 	int rc;
 
-	assert(spdk_get_thread() == ctx->thread);
-
-	rc = spdk_jsonrpc_client_poll(ctx->client_conn, 0);
+	rc = spdk_jsonrpc_client_poll(conn->client, 0);
 	if (rc == 0) {
-		rc = rpc_client_check_timeout(ctx);
+		rc = rpc_client_check_timeout(conn->timeout);
 		if (rc == -ETIMEDOUT) {
-			rpc_client_set_timeout(ctx, RPC_CLIENT_REQUEST_TIMEOUT_US);
+			SPDK_WARNLOG("Still waiting for '%s'\n", conn->entry->method);
+			rpc_client_set_timeout(&conn->timeout, RPC_CLIENT_REQUEST_TIMEOUT_US);
 			rc = 0;
 		}
 	}
 
-	if (rc == 0) {
-		/* No response yet */
-		return SPDK_POLLER_BUSY;
-	} else if (rc < 0) {
-		app_json_config_load_done(ctx, rc);
-		return SPDK_POLLER_BUSY;
+	if (rc <= 0) {
+		/* No response yet or an error */
+		return rc;
 	}
 
-	resp = spdk_jsonrpc_client_get_response(ctx->client_conn);
+	resp = spdk_jsonrpc_client_get_response(conn->client);
 	assert(resp);
 
 	if (resp->error) {
@@ -187,27 +295,53 @@ rpc_client_poller(void *arg)
 						&buf, SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
 
 		if (w == NULL) {
-			SPDK_ERRLOG("error response: (?)\n");
+			SPDK_ERRLOG("'%s' error response: (?)\n", conn->entry->method);
 		} else {
 			spdk_json_write_val(w, resp->error);
 			spdk_json_write_end(w);
-			SPDK_ERRLOG("error response: \n%s\n", buf.data);
+			SPDK_ERRLOG("'%s' error response: \n%s\n", conn->entry->method, buf.data);
 		}
 	}
 
-	if (resp->error && ctx->stop_on_error) {
-		spdk_jsonrpc_client_free_response(resp);
-		app_json_config_load_done(ctx, -EINVAL);
-	} else {
-		/* We have response so we must have callback for it. */
-		cb = ctx->client_resp_cb;
-		assert(cb != NULL);
+	rc = resp->error && ctx->stop_on_error ? -EINVAL : 1;
+
+	/* Don't care about the response otherwise */
+	spdk_jsonrpc_client_free_response(resp);
+	config_entry_free(conn->entry);
+	conn->entry = NULL;
+	ctx->num_inflight--;
+
+	return rc;
+}
+
+static void app_json_config_load_subsystem_config_entry(void *_ctx);
+
+static int
+rpc_client_poller(void *arg)
+{
+	struct load_json_config_ctx *ctx = arg;
+	uint32_t i, completed = 0;
+	int rc;
 
-		/* Mark we are done with this handler. */
-		ctx->client_resp_cb = NULL;
-		cb(ctx, resp);
+	assert(spdk_get_thread() == ctx->thread);
+
+	for (i = 0; i < ctx->num_conns; i++) {
+		if (ctx->conns[i].entry == NULL) {
+			continue;
+		}
+
+		rc = rpc_client_poll_conn(ctx, &ctx->conns[i]);
+		if (rc < 0) {
+			app_json_config_load_done(ctx, rc);
+			return SPDK_POLLER_BUSY;
+		}
+
+		completed += rc;
 	}
 
+	if (completed > 0) {
+		app_json_config_load_subsystem_config_entry(ctx);
+	}
 
 	return SPDK_POLLER_BUSY;
 }
@@ -216,16 +350,25 @@ static int
 rpc_client_connect_poller(void *_ctx)
 {
 	struct load_json_config_ctx *ctx = _ctx;
+	uint32_t i, connected = 0;
 	int rc;
 
-	rc = spdk_jsonrpc_client_poll(ctx->client_conn, 0);
-	if (rc != -ENOTCONN) {
+	for (i = 0; i < ctx->num_conns; i++) {
+		if (!ctx->conns[i].connected) {
+			rc = spdk_jsonrpc_client_poll(ctx->conns[i].client, 0);
+			ctx->conns[i].connected = rc != -ENOTCONN;
+		}
+
+		connected += ctx->conns[i].connected;
+	}
+
+	if (connected == ctx->num_conns) {
 		/* We are connected. Start regular poller and issue first request */
 		spdk_poller_unregister(&ctx->client_conn_poller);
 		ctx->client_conn_poller = SPDK_POLLER_REGISTER(rpc_client_poller, ctx, 100);
 		app_json_config_load_subsystem(ctx);
 	} else {
-		rc = rpc_client_check_timeout(ctx);
+		rc = rpc_client_check_timeout(ctx->timeout);
 		if (rc) {
 			app_json_config_load_done(ctx, rc);
 		}
@@ -237,16 +380,15 @@ rpc_client_connect_poller(void *_ctx)
 }
 
 static int
-client_send_request(struct load_json_config_ctx *ctx, struct spdk_jsonrpc_client_request *request,
-		    client_resp_handler client_resp_cb)
+client_send_request(struct load_json_config_ctx *ctx, struct load_json_config_conn *conn,
+		    struct spdk_jsonrpc_client_request *request)
 {
 	int rc;
 
 	assert(spdk_get_thread() == ctx->thread);
 
-	ctx->client_resp_cb = client_resp_cb;
-	rpc_client_set_timeout(ctx, RPC_CLIENT_REQUEST_TIMEOUT_US);
-	rc = spdk_jsonrpc_client_send_request(ctx->client_conn, request);
+	rpc_client_set_timeout(&conn->timeout, RPC_CLIENT_REQUEST_TIMEOUT_US);
+	rc = spdk_jsonrpc_client_send_request(conn->client, request);
 
 	if (rc) {
 		SPDK_DEBUG_APP_CFG("Sending request to client failed (%d)\n", rc);
@@ -295,125 +437,311 @@ cap_array_or_null(const struct spdk_json_val *val, void *out)
 	return 0;
 }
 
-struct config_entry {
-	char *method;
-	struct spdk_json_val *params;
+static struct spdk_json_object_decoder jsonrpc_cmd_decoders[] = {
+	{"method", offsetof(struct load_json_config_entry, method), spdk_json_decode_string},
+	{"params", offsetof(struct load_json_config_entry, params), cap_object, true}
 };
 
-static struct spdk_json_object_decoder jsonrpc_cmd_decoders[] = {
-	{"method", offsetof(struct config_entry, method), spdk_json_decode_string},
-	{"params", offsetof(struct config_entry, params), cap_object, true}
+/* Params describing how to reach an object rather than naming it, shared by unrelated entries */
+static const char *const g_config_entry_ignored_keys[] = {
+	"trtype", "adrfam", "traddr", "trsvcid", "hostaddr", "hostsvcid", "multipath",
 };
 
-static void app_json_config_load_subsystem_config_entry(void *_ctx);
+static bool
+config_entry_key_ignored(const struct spdk_json_val *name)
+{
+	size_t i;
+
+	for (i = 0; i < SPDK_COUNTOF(g_config_entry_ignored_keys); i++) {
+		if (spdk_json_strequal(name, g_config_entry_ignored_keys[i])) {
+			return true;
+		}
+	}
+
+	return false;
+}
 
 static void
-app_json_config_load_subsystem_config_entry_next(struct load_json_config_ctx *ctx,
-		struct spdk_jsonrpc_client_response *resp)
+config_entry_get_keys(struct load_json_config_entry *entry)
 {
-	/* Don't care about the response */
-	spdk_jsonrpc_client_free_response(resp);
+	struct spdk_json_val *val, *end;
+	bool named = false;
+	int depth = 0;
 
-	ctx->config_it = spdk_json_next(ctx->config_it);
-	app_json_config_load_subsystem_config_entry(ctx);
+	entry->barrier = true;
+	if (entry->params == NULL) {
+		return;
+	}
+
+	end = entry->params + spdk_json_val_len(entry->params);
+	for (val = entry->params; val < end; val++) {
+		switch (val->type) {
+		case SPDK_JSON_VAL_OBJECT_BEGIN:
+		case SPDK_JSON_VAL_ARRAY_BEGIN:
+			depth++;
+			break;
+		case SPDK_JSON_VAL_OBJECT_END:
+		case SPDK_JSON_VAL_ARRAY_END:
+			depth--;
+			break;
+		case SPDK_JSON_VAL_STRING:
+			if ((val - 1)->type == SPDK_JSON_VAL_NAME) {
+				if (depth == 1 && (spdk_json_strequal(val - 1, "name") ||
+						   spdk_json_strequal(val - 1, "nqn"))) {
+					named = true;
+				}
+				if (config_entry_key_ignored(val - 1)) {
+					break;
+				}
+			}
+			if (val->len == 0) {
+				break;
+			}
+			if (entry->num_keys == CONFIG_ENTRY_MAX_KEYS) {
+				return;
+			}
+			entry->keys[entry->num_keys++] = val;
+			break;
+		default:
+			break;
+		}
+	}
+
+	entry->barrier = !named;
 }
 
-/* Load "config" entry */
-static void
-app_json_config_load_subsystem_config_entry(void *_ctx)
+static bool
+config_entries_conflict(const struct load_json_config_entry *a,
+			const struct load_json_config_entry *b)
 {
-	struct load_json_config_ctx *ctx = _ctx;
-	struct spdk_jsonrpc_client_request *rpc_request;
-	struct spdk_json_write_ctx *w;
-	struct config_entry cfg = {};
-	struct spdk_json_val *params_end;
-	size_t params_len = 0;
+	const struct spdk_json_val *ka, *kb;
+	size_t i, j;
+
+	if (a->barrier || b->barrier) {
+		return true;
+	}
+
+	for (i = 0; i < a->num_keys; i++) {
+		for (j = 0; j < b->num_keys; j++) {
+			ka = a->keys[i];
+			kb = b->keys[j];
+			/* Names of the objects created along with another one start with its
+			 * name (e.g. Nvme0n1 or lvs0/lvol0), so prefixes are conflicts too. */
+			if (memcmp(ka->start, kb->start, spdk_min(ka->len, kb->len)) == 0) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/* Check if the entry has to wait for an entry in progress or one preceding it in the config */
+static bool
+config_entry_blocked(struct load_json_config_ctx *ctx, struct load_json_config_entry *entry)
+{
+	struct load_json_config_entry *prev;
+	uint32_t i;
+
+	for (i = 0; i < ctx->num_conns; i++) {
+		if (ctx->conns[i].entry != NULL &&
+		    config_entries_conflict(ctx->conns[i].entry, entry)) {
+			return true;
+		}
+	}
+
+	TAILQ_FOREACH(prev, &ctx->pending, link) {
+		if (prev == entry) {
+			break;
+		}
+		if (config_entries_conflict(prev, entry)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Decode "config" entry, *_entry is set to NULL if the method is not run in the current state */
+static int
+config_entry_create(struct spdk_json_val *config_it, struct load_json_config_entry **_entry)
+{
+	struct load_json_config_entry *entry;
 	uint32_t state_mask = 0, cur_state_mask, startup_runtime = SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME;
 	int rc;
 
-	if (ctx->config_it == NULL) {
-		SPDK_DEBUG_APP_CFG("Subsystem '%.*s': configuration done.\n", ctx->subsystem_name->len,
-				   (char *)ctx->subsystem_name->start);
-		ctx->subsystems_it = spdk_json_next(ctx->subsystems_it);
-		/* Invoke later to avoid recurrence */
-		spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem, ctx);
-		return;
+	*_entry = NULL;
+	entry = calloc(1, sizeof(*entry));
+	if (entry == NULL) {
+		return -ENOMEM;
 	}
 
-	if (spdk_json_decode_object(ctx->config_it, jsonrpc_cmd_decoders,
-				    SPDK_COUNTOF(jsonrpc_cmd_decoders), &cfg)) {
+	if (spdk_json_decode_object(config_it, jsonrpc_cmd_decoders,
+				    SPDK_COUNTOF(jsonrpc_cmd_decoders), entry)) {
 		SPDK_ERRLOG("Failed to decode config entry\n");
-		app_json_config_load_done(ctx, -EINVAL);
-		goto out;
+		config_entry_free(entry);
+		return -EINVAL;
 	}
 
-	rc = spdk_rpc_get_method_state_mask(cfg.method, &state_mask);
+	rc = spdk_rpc_get_method_state_mask(entry->method, &state_mask);
 	if (rc == -ENOENT) {
-		SPDK_ERRLOG("Method '%s' was not found\n", cfg.method);
-		app_json_config_load_done(ctx, rc);
-		goto out;
+		SPDK_ERRLOG("Method '%s' was not found\n", entry->method);
+		config_entry_free(entry);
+		return rc;
 	}
 	cur_state_mask = spdk_rpc_get_state();
 	if ((state_mask & cur_state_mask) != cur_state_mask) {
-		SPDK_DEBUG_APP_CFG("Method '%s' not allowed -> skipping\n", cfg.method);
-		/* Invoke later to avoid recurrence */
-		ctx->config_it = spdk_json_next(ctx->config_it);
-		spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem_config_entry, ctx);
-		goto out;
+		SPDK_DEBUG_APP_CFG("Method '%s' not allowed -> skipping\n", entry->method);
+		config_entry_free(entry);
+		return 0;
 	}
 	if ((state_mask & startup_runtime) == startup_runtime && cur_state_mask == SPDK_RPC_RUNTIME) {
 		/* Some methods are allowed to be run in both STARTUP and RUNTIME states.
 		 * We should not call such methods twice, so ignore the second attempt in RUNTIME state */
-		SPDK_DEBUG_APP_CFG("Method '%s' has already been run in STARTUP state\n", cfg.method);
-		/* Invoke later to avoid recurrence */
-		ctx->config_it = spdk_json_next(ctx->config_it);
-		spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem_config_entry, ctx);
-		goto out;
+		SPDK_DEBUG_APP_CFG("Method '%s' has already been run in STARTUP state\n",
+				   entry->method);
+		config_entry_free(entry);
+		return 0;
 	}
 
-	SPDK_DEBUG_APP_CFG("\tmethod: %s\n", cfg.method);
+	config_entry_get_keys(entry);
+	*_entry = entry;
 
-	if (cfg.params) {
+	return 0;
+}
+
+/* Send config entry using the given connection */
+static int
+app_json_config_send_entry(struct load_json_config_ctx *ctx, struct load_json_config_conn *conn,
+			   struct load_json_config_entry *entry)
+{
+	struct spdk_jsonrpc_client_request *rpc_request;
+	struct spdk_json_write_ctx *w;
+	struct spdk_json_val *params_end;
+	size_t params_len = 0;
+	int rc;
+
+	SPDK_DEBUG_APP_CFG("\tmethod: %s\n", entry->method);
+
+	if (entry->params) {
 		/* Get _END by skipping params and going back by one element. */
-		params_end = cfg.params + spdk_json_val_len(cfg.params) - 1;
+		params_end = entry->params + spdk_json_val_len(entry->params) - 1;
 
 		/* Need to add one character to include '}' */
-		params_len = params_end->start - cfg.params->start + 1;
+		params_len = params_end->start - entry->params->start + 1;
 
-		SPDK_DEBUG_APP_CFG("\tparams: %.*s\n", (int)params_len, (char *)cfg.params->start);
+		SPDK_DEBUG_APP_CFG("\tparams: %.*s\n", (int)params_len,
+				   (char *)entry->params->start);
 	}
 
 	rpc_request = spdk_jsonrpc_client_create_request();
 	if (!rpc_request) {
-		app_json_config_load_done(ctx, -errno);
-		goto out;
+		return -errno;
 	}
 
-	w = spdk_jsonrpc_begin_request(rpc_request, ctx->rpc_request_id, NULL);
+	w = spdk_jsonrpc_begin_request(rpc_request, ctx->rpc_request_id++, NULL);
 	if (!w) {
 		spdk_jsonrpc_client_free_request(rpc_request);
-		app_json_config_load_done(ctx, -ENOMEM);
-		goto out;
+		return -ENOMEM;
 	}
 
-	spdk_json_write_named_string(w, "method", cfg.method);
+	spdk_json_write_named_string(w, "method", entry->method);
 
-	if (cfg.params) {
+	if (entry->params) {
 		/* No need to parse "params". Just dump the whole content of "params"
 		 * directly into the request and let the remote side verify it. */
 		spdk_json_write_name(w, "params");
-		spdk_json_write_val_raw(w, cfg.params->start, params_len);
+		spdk_json_write_val_raw(w, entry->params->start, params_len);
 	}
 
 	spdk_jsonrpc_end_request(rpc_request, w);
 
-	rc = client_send_request(ctx, rpc_request, app_json_config_load_subsystem_config_entry_next);
+	rc = client_send_request(ctx, conn, rpc_request);
 	if (rc != 0) {
-		app_json_config_load_done(ctx, -rc);
-		goto out;
+		return rc;
+	}
+
+	conn->entry = entry;
+	ctx->num_inflight++;
+	ctx->max_inflight = spdk_max(ctx->max_inflight, ctx->num_inflight);
+
+	return 0;
+}
+
+static struct load_json_config_conn *
+app_json_config_get_idle_conn(struct load_json_config_ctx *ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < ctx->num_conns; i++) {
+		if (ctx->conns[i].entry == NULL) {
+			return &ctx->conns[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Load "config" entries, as many at once as there are idle connections */
+static void
+app_json_config_load_subsystem_config_entry(void *_ctx)
+{
+	struct load_json_config_ctx *ctx = _ctx;
+	struct load_json_config_entry *entry, *tmp;
+	struct load_json_config_conn *conn;
+	enum json_config_phase phase;
+	int rc;
+
+	phase = spdk_rpc_get_state() == SPDK_RPC_STARTUP ?
+		JSON_CONFIG_PHASE_STARTUP : JSON_CONFIG_PHASE_RUNTIME;
+
+	while (ctx->config_it != NULL && ctx->num_pending < ctx->window_size) {
+		rc = config_entry_create(ctx->config_it, &entry);
+		if (rc != 0) {
+			app_json_config_load_done(ctx, rc);
+			return;
+		}
+
+		ctx->config_it = spdk_json_next(ctx->config_it);
+		if (entry != NULL) {
+			TAILQ_INSERT_TAIL(&ctx->pending, entry, link);
+			ctx->num_pending++;
+		}
+	}
+
+	TAILQ_FOREACH_SAFE(entry, &ctx->pending, link, tmp) {
+		conn = app_json_config_get_idle_conn(ctx);
+		if (conn == NULL) {
+			break;
+		}
+
+		if (config_entry_blocked(ctx, entry)) {
+			if (entry->barrier) {
+				/* Nothing past a barrier can be started */
+				break;
+			}
+			continue;
+		}
+
+		TAILQ_REMOVE(&ctx->pending, entry, link);
+		ctx->num_pending--;
+		rc = app_json_config_send_entry(ctx, conn, entry);
+		if (rc != 0) {
+			config_entry_free(entry);
+			app_json_config_load_done(ctx, rc);
+			return;
+		}
+
+		ctx->num_entries[phase]++;
+	}
+
+	if (ctx->config_it == NULL && ctx->num_pending == 0 && ctx->num_inflight == 0) {
+		SPDK_DEBUG_APP_CFG("Subsystem '%.*s': configuration done.\n",
+				   ctx->subsystem_name->len, (char *)ctx->subsystem_name->start);
+		ctx->subsystems_it = spdk_json_next(ctx->subsystems_it);
+		/* Invoke later to avoid recurrence */
+		spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem, ctx);
 	}
-out:
-	free(cfg.method);
 }
 
 static void
@@ -426,6 +754,7 @@ subsystem_init_done(int rc, void *arg1)
 		return;
 	}
 
+	app_json_config_phase_done(ctx, JSON_CONFIG_PHASE_INIT);
 	spdk_rpc_set_state(SPDK_RPC_RUNTIME);
 	/* Another round. This time for RUNTIME methods */
 	SPDK_DEBUG_APP_CFG("'framework_start_init' done - continuing configuration\n");
@@ -459,6 +788,9 @@ static struct spdk_json_object_decoder subsystem_decoders[] = {
  * RUNTIME RPC methods are used. When ctx->subsystems_it became NULL second time it
  * indicate that there is no more subsystems to load. The cb_fn is called to finish
  * configuration.
+ *
+ * Subsystems are always loaded one after another, only the entries within a subsystem
+ * config may be executed concurrently.
  */
 static void
 app_json_config_load_subsystem(void *_ctx)
@@ -468,8 +800,10 @@ app_json_config_load_subsystem(void *_ctx)
 	if (ctx->subsystems_it == NULL) {
 		if (spdk_rpc_get_state() == SPDK_RPC_STARTUP) {
 			SPDK_DEBUG_APP_CFG("No more entries for current state, calling 'framework_start_init'\n");
+			app_json_config_phase_done(ctx, JSON_CONFIG_PHASE_STARTUP);
 			spdk_subsystem_init(subsystem_init_done, ctx);
 		} else {
+			app_json_config_phase_done(ctx, JSON_CONFIG_PHASE_RUNTIME);
 			app_json_config_load_done(ctx, 0);
 		}
 
@@ -558,11 +892,13 @@ err:
 }
 
 void
-spdk_subsystem_init_from_json_config(const char *json_config_file, const char *rpc_addr,
-				     spdk_subsystem_init_fn cb_fn, void *cb_arg,
-				     bool stop_on_error)
+spdk_subsystem_init_from_json_config_ext(const char *json_config_file, const char *rpc_addr,
+					 uint32_t max_parallel, spdk_subsystem_init_fn cb_fn,
+					 void *cb_arg, bool stop_on_error)
 {
 	struct load_json_config_ctx *ctx = calloc(1, sizeof(*ctx));
+	struct load_json_config_conn *conn;
+	uint32_t i;
 	int rc;
 
 	assert(cb_fn);
@@ -575,6 +911,18 @@ spdk_subsystem_init_from_json_config(const char *json_config_file, const char *r
 	ctx->cb_arg = cb_arg;
 	ctx->stop_on_error = stop_on_error;
 	ctx->thread = spdk_get_thread();
+	ctx->phase_start_tsc = spdk_get_ticks();
+	TAILQ_INIT(&ctx->pending);
+
+	if (max_parallel > JSON_CONFIG_MAX_PARALLEL) {
+		SPDK_WARNLOG("Limiting the number of parallel config RPCs to %d\n",
+			     JSON_CONFIG_MAX_PARALLEL);
+		max_parallel = JSON_CONFIG_MAX_PARALLEL;
+	}
+
+	ctx->num_conns = spdk_max(max_parallel, 1);
+	/* Look ahead only when there's a chance to run something out of order */
+	ctx->window_size = ctx->num_conns > 1 ? JSON_CONFIG_WINDOW_SIZE : 1;
 
 	rc = app_json_config_read(json_config_file, ctx);
 	if (rc) {
@@ -605,6 +953,8 @@ spdk_subsystem_init_from_json_config(const char *json_config_file, const char *r
 		goto fail;
 	}
 
+	app_json_config_phase_done(ctx, JSON_CONFIG_PHASE_PARSE);
+
 	/* If rpc_addr is not an Unix socket use default address as prefix. */
 	if (rpc_addr == NULL || rpc_addr[0] != '/') {
 		rpc_addr = SPDK_DEFAULT_RPC_ADDR;
@@ -623,13 +973,16 @@ spdk_subsystem_init_from_json_config(const char *json_config_file, const char *r
 		goto fail;
 	}
 
-	ctx->client_conn = spdk_jsonrpc_client_connect(ctx->rpc_socket_path_temp, AF_UNIX);
-	if (ctx->client_conn == NULL) {
-		SPDK_ERRLOG("Failed to connect to '%s'\n", ctx->rpc_socket_path_temp);
-		goto fail;
+	for (i = 0; i < ctx->num_conns; i++) {
+		conn = &ctx->conns[i];
+		conn->client = spdk_jsonrpc_client_connect(ctx->rpc_socket_path_temp, AF_UNIX);
+		if (conn->client == NULL) {
+			SPDK_ERRLOG("Failed to connect to '%s'\n", ctx->rpc_socket_path_temp);
+			goto fail;
+		}
 	}
 
-	rpc_client_set_timeout(ctx, RPC_CLIENT_CONNECT_TIMEOUT_US);
+	rpc_client_set_timeout(&ctx->timeout, RPC_CLIENT_CONNECT_TIMEOUT_US);
 	ctx->client_conn_poller = SPDK_POLLER_REGISTER(rpc_client_connect_poller, ctx, 100);
 	return;
 
@@ -637,4 +990,13 @@ fail:
 	app_json_config_load_done(ctx, -EINVAL);
 }
 
+void
+spdk_subsystem_init_from_json_config(const char *json_config_file, const char *rpc_addr,
+				     spdk_subsystem_init_fn cb_fn, void *cb_arg,
+				     bool stop_on_error)
+{
+	spdk_subsystem_init_from_json_config_ext(json_config_file, rpc_addr, 1, cb_fn, cb_arg,
+						 stop_on_error);
+}
+
 SPDK_LOG_REGISTER_COMPONENT(app_config)
@@ -575,11 +575,23 @@ int
 spdk_ioat_build_copy(struct spdk_ioat_chan *ioat, void *cb_arg, spdk_ioat_req_cb cb_fn,
 		     void *dst, const void *src, uint64_t nbytes)
 {
-	struct ioat_descriptor	*last_desc;
-	uint64_t	remaining, op_size;
-	uint64_t	vdst, vsrc;
+	struct iovec diov = { .iov_base = dst, .iov_len = nbytes };
+	struct iovec siov = { .iov_base = (void *)src, .iov_len = nbytes };
+
+	return spdk_ioat_build_copyv(ioat, cb_arg, cb_fn, &diov, 1, &siov, 1);
+}
+
+int
+spdk_ioat_build_copyv(struct spdk_ioat_chan *ioat, void *cb_arg, spdk_ioat_req_cb cb_fn,
+		      struct iovec *diov, uint32_t diovcnt, struct iovec *siov, uint32_t siovcnt)
+{
+	struct ioat_descriptor	*last_desc = NULL;
+	struct spdk_ioviter	iter;
+	uint64_t	op_size;
 	uint64_t	pdst_addr, psrc_addr, dst_len, src_len;
 	uint32_t	orig_head;
+	void		*src, *dst;
+	size_t		len;
 
 	if (!ioat) {
 		return -EINVAL;
@@ -587,52 +599,52 @@ spdk_ioat_build_copy(struct spdk_ioat_chan *ioat, void *cb_arg, spdk_ioat_req_cb
 
 	orig_head = ioat->head;
 
-	vdst = (uint64_t)dst;
-	vsrc = (uint64_t)src;
-
-	remaining = nbytes;
-	while (remaining) {
-		src_len = dst_len = remaining;
-
-		psrc_addr = spdk_vtophys((void *)vsrc, &src_len);
-		if (psrc_addr == SPDK_VTOPHYS_ERROR) {
-			return -EINVAL;
-		}
-		pdst_addr = spdk_vtophys((void *)vdst, &dst_len);
-		if (pdst_addr == SPDK_VTOPHYS_ERROR) {
-			return -EINVAL;
-		}
-
-		op_size = spdk_min(dst_len, src_len);
-		op_size = spdk_min(op_size, ioat->max_xfer_size);
-		remaining -= op_size;
-
-		last_desc = ioat_prep_copy(ioat, pdst_addr, psrc_addr, op_size);
-
-		if (remaining == 0 || last_desc == NULL) {
-			break;
+	/*
+	 * Each descriptor covers a physically contiguous piece of both buffers.  Only the last
+	 * one gets the callback, the rest are chained in the ring and submitted together.
+	 */
+	for (len = spdk_ioviter_first(&iter, siov, siovcnt, diov, diovcnt, &src, &dst);
+	     len > 0;
+	     len = spdk_ioviter_next(&iter, &src, &dst)) {
+		while (len > 0) {
+			src_len = dst_len = len;
+
+			psrc_addr = spdk_vtophys(src, &src_len);
+			pdst_addr = spdk_vtophys(dst, &dst_len);
+			if (psrc_addr == SPDK_VTOPHYS_ERROR || pdst_addr == SPDK_VTOPHYS_ERROR) {
+				ioat->head = orig_head;
+				return -EINVAL;
+			}
+
+			op_size = spdk_min(dst_len, src_len);
+			op_size = spdk_min(op_size, ioat->max_xfer_size);
+
+			last_desc = ioat_prep_copy(ioat, pdst_addr, psrc_addr, op_size);
+			if (last_desc == NULL) {
+				/*
+				 * Ran out of descriptors in the ring - reset head to leave things
+				 * as they were in case we managed to fill out any descriptors.
+				 */
+				ioat->head = orig_head;
+				return -ENOMEM;
+			}
+
+			src = (uint8_t *)src + op_size;
+			dst = (uint8_t *)dst + op_size;
+			len -= op_size;
 		}
-
-		vsrc += op_size;
-		vdst += op_size;
-
 	}
+
 	/* Issue null descriptor for null transfer */
-	if (nbytes == 0) {
+	if (last_desc == NULL) {
 		last_desc = ioat_prep_null(ioat);
+		if (last_desc == NULL) {
+			return -ENOMEM;
+		}
 	}
 
-	if (last_desc) {
-		last_desc->callback_fn = cb_fn;
-		last_desc->callback_arg = cb_arg;
-	} else {
-		/*
-		 * Ran out of descriptors in the ring - reset head to leave things as they were
-		 * in case we managed to fill out any descriptors.
-		 */
-		ioat->head = orig_head;
-		return -ENOMEM;
-	}
+	last_desc->callback_fn = cb_fn;
+	last_desc->callback_arg = cb_arg;
 
 	return 0;
 }
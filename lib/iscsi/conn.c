@@ -6,6 +6,7 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/accel.h"
 #include "spdk/endian.h"
 #include "spdk/env.h"
 #include "spdk/likely.h"
@@ -306,6 +307,11 @@ iscsi_conn_free_tasks(struct spdk_iscsi_conn *conn)
 		}
 	}
 
+	/* PDUs can't be freed while accel is still computing their data digests. */
+	if (conn->pending_digest_cnt) {
+		return -1;
+	}
+
 	/* We have to parse conn->write_pdu_list in the end.  In iscsi_conn_free_pdu(),
 	 *  iscsi_conn_handle_queued_datain_tasks() may be called, and
 	 *  iscsi_conn_handle_queued_datain_tasks() will parse conn->queued_datain_tasks
@@ -361,6 +367,7 @@ iscsi_conn_free(struct spdk_iscsi_conn *conn)
 	sess = conn->sess;
 	conn->sess = NULL;
 
+	pthread_mutex_lock(&sess->mutex);
 	for (i = 0; i < sess->connections; i++) {
 		if (sess->conns[i] == conn) {
 			idx = i;
@@ -369,6 +376,7 @@ iscsi_conn_free(struct spdk_iscsi_conn *conn)
 	}
 
 	if (idx < 0) {
+		pthread_mutex_unlock(&sess->mutex);
 		SPDK_ERRLOG("remove conn not found\n");
 	} else {
 		for (i = idx; i < sess->connections - 1; i++) {
@@ -376,6 +384,7 @@ iscsi_conn_free(struct spdk_iscsi_conn *conn)
 		}
 		sess->conns[sess->connections - 1] = NULL;
 		sess->connections--;
+		pthread_mutex_unlock(&sess->mutex);
 
 		if (sess->connections == 0) {
 			/* cleanup last connection */
@@ -1420,6 +1429,110 @@ iscsi_conn_pdu_generic_complete(void *cb_arg)
 {
 }
 
+static void
+_iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
+						&pdu->mapped_length);
+	pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
+	pdu->sock_req.cb_arg = pdu;
+
+	spdk_trace_record(TRACE_ISCSI_FLUSH_WRITEBUF_START, conn->id, pdu->mapped_length, (uintptr_t)pdu,
+			  pdu->sock_req.iovcnt);
+	spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+}
+
+/* Write out the deferred PDUs in order, up to the first one whose data digest is still pending. */
+static void
+iscsi_conn_write_deferred_pdus(struct spdk_iscsi_conn *conn)
+{
+	struct spdk_iscsi_pdu *pdu, *tmp;
+
+	TAILQ_FOREACH_SAFE(pdu, &conn->write_pdu_list, tailq, tmp) {
+		if (conn->deferred_write_cnt == 0 || pdu->digest_in_progress) {
+			break;
+		}
+		if (!pdu->write_deferred) {
+			continue;
+		}
+
+		pdu->write_deferred = false;
+		conn->deferred_write_cnt--;
+		_iscsi_conn_write_pdu(conn, pdu);
+	}
+}
+
+static void
+iscsi_conn_pdu_data_digest_done(void *cb_arg, int status)
+{
+	struct spdk_iscsi_pdu *pdu = cb_arg;
+	struct spdk_iscsi_conn *conn = pdu->conn;
+
+	assert(conn->pending_digest_cnt > 0);
+	conn->pending_digest_cnt--;
+	pdu->digest_in_progress = false;
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Failed to compute the data digest for pdu=%p\n", pdu);
+		conn->state = ISCSI_CONN_STATE_EXITING;
+	}
+
+	/* Deferred PDUs are freed along with the connection. */
+	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
+		return;
+	}
+
+	pdu->crc32c ^= SPDK_CRC32C_XOR;
+	MAKE_DIGEST_WORD(pdu->data_digest, pdu->crc32c);
+
+	iscsi_conn_write_deferred_pdus(conn);
+}
+
+/* The data digest of smaller PDUs is computed inline, as the round trip through accel costs
+ * more than the computation itself.
+ */
+#define ISCSI_DIGEST_ACCEL_THRESHOLD	4096
+
+static int
+iscsi_conn_pdu_submit_data_digest(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	static uint8_t pad[ISCSI_ALIGNMENT - 1];
+	uint32_t data_len = DGET24(pdu->bhs.data_segment_len);
+	uint32_t mod = data_len % ISCSI_ALIGNMENT;
+	int iovcnt = 1, rc;
+
+	if (pdu->dif_insert_or_strip || data_len < ISCSI_DIGEST_ACCEL_THRESHOLD ||
+	    conn->pg == NULL || conn->pg->accel_channel == NULL) {
+		return -ENOTSUP;
+	}
+
+	/* Connections in login phase don't necessarily run on the thread of their poll group. */
+	if (spdk_io_channel_get_thread(conn->pg->accel_channel) != spdk_get_thread()) {
+		return -ENOTSUP;
+	}
+
+	/* pdu->iov is built only once the digest is computed, so borrow it in the meantime. */
+	pdu->iov[0].iov_base = pdu->data;
+	pdu->iov[0].iov_len = data_len;
+	if (mod != 0) {
+		pdu->iov[1].iov_base = pad;
+		pdu->iov[1].iov_len = ISCSI_ALIGNMENT - mod;
+		iovcnt++;
+	}
+
+	pdu->digest_in_progress = true;
+	conn->pending_digest_cnt++;
+
+	rc = spdk_accel_submit_crc32cv(conn->pg->accel_channel, &pdu->crc32c, pdu->iov, iovcnt, 0,
+				       iscsi_conn_pdu_data_digest_done, pdu);
+	if (spdk_unlikely(rc != 0)) {
+		pdu->digest_in_progress = false;
+		conn->pending_digest_cnt--;
+	}
+
+	return rc;
+}
+
 void
 iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 		     iscsi_conn_xfer_complete_cb cb_fn,
@@ -1427,6 +1540,7 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 {
 	uint32_t crc32c;
 	ssize_t rc;
+	bool calc_data_digest = false;
 
 	if (spdk_unlikely(pdu->dif_insert_or_strip)) {
 		rc = iscsi_dif_verify(pdu, &pdu->dif_ctx);
@@ -1444,11 +1558,7 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 			MAKE_DIGEST_WORD(pdu->header_digest, crc32c);
 		}
 
-		/* Data Digest */
-		if (conn->data_digest && DGET24(pdu->bhs.data_segment_len) != 0) {
-			crc32c = iscsi_pdu_calc_data_digest(pdu);
-			MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
-		}
+		calc_data_digest = conn->data_digest && DGET24(pdu->bhs.data_segment_len) != 0;
 	}
 
 	pdu->cb_fn = cb_fn;
@@ -1458,14 +1568,21 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
 		return;
 	}
-	pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
-						&pdu->mapped_length);
-	pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
-	pdu->sock_req.cb_arg = pdu;
 
-	spdk_trace_record(TRACE_ISCSI_FLUSH_WRITEBUF_START, conn->id, pdu->mapped_length, (uintptr_t)pdu,
-			  pdu->sock_req.iovcnt);
-	spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+	/* Data Digest */
+	if (calc_data_digest && iscsi_conn_pdu_submit_data_digest(conn, pdu) != 0) {
+		crc32c = iscsi_pdu_calc_data_digest(pdu);
+		MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+	}
+
+	/* Keep PDUs in order behind the ones still waiting for their data digest. */
+	if (pdu->digest_in_progress || conn->deferred_write_cnt != 0) {
+		pdu->write_deferred = true;
+		conn->deferred_write_cnt++;
+		return;
+	}
+
+	_iscsi_conn_write_pdu(conn, pdu);
 }
 
 static void
@@ -1534,9 +1651,11 @@ iscsi_conn_schedule(struct spdk_iscsi_conn *conn)
 	target = conn->sess->target;
 	pthread_mutex_lock(&target->mutex);
 	target->num_active_conns++;
-	if (target->num_active_conns == 1) {
+	if (target->num_active_conns == 1 || conn->sess->connections > 1) {
 		/**
-		 * This is the only active connection for this target node.
+		 * This is the only active connection for this target node, or an additional
+		 *  connection of a session with multiple connections, which is spread across
+		 *  poll groups to let the session scale beyond a single core.
 		 *  Pick a poll group using round-robin.
 		 */
 		if (g_next_pg == NULL) {
@@ -1548,7 +1667,9 @@ iscsi_conn_schedule(struct spdk_iscsi_conn *conn)
 		g_next_pg = TAILQ_NEXT(g_next_pg, link);
 
 		/* Save the pg in the target node so it can be used for any other connections to this target node. */
-		target->pg = pg;
+		if (target->num_active_conns == 1) {
+			target->pg = pg;
+		}
 	} else {
 		/**
 		 * There are other active connections for this target node.
@@ -140,6 +140,10 @@ struct spdk_iscsi_conn {
 	bool mutual_chap;
 	int32_t chap_group;
 	uint32_t pending_task_cnt;
+	/* Number of PDUs whose data digest is being computed by accel */
+	uint32_t pending_digest_cnt;
+	/* Number of PDUs in write_pdu_list not yet passed to the socket */
+	uint32_t deferred_write_cnt;
 	uint32_t data_out_cnt;
 	uint32_t data_in_cnt;
 
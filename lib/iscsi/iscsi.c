@@ -508,9 +508,48 @@ iscsi_free_sess(struct spdk_iscsi_sess *sess)
 	iscsi_param_free(sess->params);
 	free(sess->conns);
 	spdk_scsi_port_free(&sess->initiator_port);
+	pthread_mutex_destroy(&sess->mutex);
 	spdk_mempool_put(g_iscsi.session_pool, (void *)sess);
 }
 
+/*
+ * Advance ExpCmdSN after receiving a non-immediate command.  With multiple connections
+ *  per session, commands may arrive out of CmdSN order, so ExpCmdSN only moves past
+ *  CmdSNs which have all been received.  Must be called with the session's mutex held.
+ */
+static void
+iscsi_sess_recv_cmd_sn(struct spdk_iscsi_sess *sess, uint32_t cmd_sn)
+{
+	uint32_t idx;
+
+	if (cmd_sn != sess->ExpCmdSN) {
+		if (spdk_sn32_lt(cmd_sn, sess->ExpCmdSN) ||
+		    cmd_sn - sess->ExpCmdSN >= ISCSI_CMDSN_WINDOW_SIZE) {
+			/* Outside of the window, only possible if skipped by ERL 1 and 2 */
+			return;
+		}
+
+		idx = cmd_sn % ISCSI_CMDSN_WINDOW_SIZE;
+		sess->cmdsn_received[idx / 64] |= 1ULL << (idx % 64);
+		return;
+	}
+
+	do {
+		sess->ExpCmdSN++;
+		idx = sess->ExpCmdSN % ISCSI_CMDSN_WINDOW_SIZE;
+		if (!(sess->cmdsn_received[idx / 64] & (1ULL << (idx % 64)))) {
+			break;
+		}
+		sess->cmdsn_received[idx / 64] &= ~(1ULL << (idx % 64));
+	} while (true);
+}
+
+static inline void
+iscsi_sess_inc_max_cmd_sn(struct spdk_iscsi_sess *sess)
+{
+	__atomic_fetch_add(&sess->MaxCmdSN, 1, __ATOMIC_RELAXED);
+}
+
 static int
 create_iscsi_sess(struct spdk_iscsi_conn *conn,
 		  struct spdk_iscsi_tgt_node *target,
@@ -553,6 +592,13 @@ create_iscsi_sess(struct spdk_iscsi_conn *conn,
 		return -ENOMEM;
 	}
 
+	if (pthread_mutex_init(&sess->mutex, NULL) != 0) {
+		free(sess->conns);
+		spdk_mempool_put(g_iscsi.session_pool, (void *)sess);
+		SPDK_ERRLOG("pthread_mutex_init() failed\n");
+		return -ENOMEM;
+	}
+
 	sess->connections = 0;
 
 	sess->conns[sess->connections] = conn;
@@ -704,7 +750,10 @@ append_iscsi_sess(struct spdk_iscsi_conn *conn,
 		return ISCSI_LOGIN_CONN_ADD_FAIL;
 	}
 
+	/* The other connections of the session may be running on different poll groups. */
+	pthread_mutex_lock(&sess->mutex);
 	if (sess->connections >= sess->MaxConnections) {
+		pthread_mutex_unlock(&sess->mutex);
 		/* no slot for connection */
 		SPDK_ERRLOG("too many connections for init port name=%s, tsih=%d, cid=%d\n",
 			    initiator_port_name, tsih, cid);
@@ -714,12 +763,9 @@ append_iscsi_sess(struct spdk_iscsi_conn *conn,
 	SPDK_DEBUGLOG(iscsi, "Connections (tsih %d): %d\n", sess->tsih, sess->connections);
 	conn->sess = sess;
 
-	/*
-	 * TODO: need a mutex or other sync mechanism to protect the session's
-	 *  connection list.
-	 */
 	sess->conns[sess->connections] = conn;
 	sess->connections++;
+	pthread_mutex_unlock(&sess->mutex);
 
 	return 0;
 }
@@ -1749,6 +1795,7 @@ iscsi_op_login_set_conn_info(struct spdk_iscsi_conn *conn,
 		}
 		conn->sess->ExpCmdSN = rsp_pdu->cmd_sn;
 		conn->sess->MaxCmdSN = rsp_pdu->cmd_sn + conn->sess->queue_depth - 1;
+		memset(conn->sess->cmdsn_received, 0, sizeof(conn->sess->cmdsn_received));
 	}
 
 	conn->initiator_port = conn->sess->initiator_port;
@@ -2438,7 +2485,7 @@ iscsi_pdu_payload_op_text(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *p
 	conn->StatSN++;
 
 	if (reqh->immediate == 0) {
-		conn->sess->MaxCmdSN++;
+		iscsi_sess_inc_max_cmd_sn(conn->sess);
 	}
 
 	to_be32(&rsph->exp_cmd_sn, conn->sess->ExpCmdSN);
@@ -2564,7 +2611,7 @@ iscsi_pdu_hdr_op_logout(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu
 		conn->StatSN++;
 
 		if (conn->sess->connections == 1) {
-			conn->sess->MaxCmdSN++;
+			iscsi_sess_inc_max_cmd_sn(conn->sess);
 		}
 
 		to_be32(&rsph->exp_cmd_sn, conn->sess->ExpCmdSN);
@@ -2951,7 +2998,7 @@ iscsi_send_datain(struct spdk_iscsi_conn *conn,
 	}
 
 	if (F_bit && S_bit && !iscsi_task_is_immediate(primary)) {
-		conn->sess->MaxCmdSN++;
+		iscsi_sess_inc_max_cmd_sn(conn->sess);
 	}
 
 	to_be32(&rsph->exp_cmd_sn, conn->sess->ExpCmdSN);
@@ -3166,7 +3213,7 @@ iscsi_task_response(struct spdk_iscsi_conn *conn,
 	conn->StatSN++;
 
 	if (!iscsi_task_is_immediate(primary)) {
-		conn->sess->MaxCmdSN++;
+		iscsi_sess_inc_max_cmd_sn(conn->sess);
 	}
 
 	to_be32(&rsph->exp_cmd_sn, conn->sess->ExpCmdSN);
@@ -3516,7 +3563,7 @@ iscsi_task_mgmt_response(struct spdk_iscsi_conn *conn,
 	conn->StatSN++;
 
 	if (reqh->immediate == 0) {
-		conn->sess->MaxCmdSN++;
+		iscsi_sess_inc_max_cmd_sn(conn->sess);
 	}
 
 	to_be32(&rsph->exp_cmd_sn, conn->sess->ExpCmdSN);
@@ -3813,7 +3860,7 @@ iscsi_pdu_payload_op_nopout(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu
 	conn->StatSN++;
 
 	if (I_bit == 0) {
-		conn->sess->MaxCmdSN++;
+		iscsi_sess_inc_max_cmd_sn(conn->sess);
 	}
 
 	to_be32(&rsph->exp_cmd_sn, conn->sess->ExpCmdSN);
@@ -4422,6 +4469,8 @@ iscsi_update_cmdsn(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
 	pdu->cmd_sn = from_be32(&reqh->cmd_sn);
 
 	I_bit = reqh->immediate;
+
+	pthread_mutex_lock(&sess->mutex);
 	if (I_bit == 0) {
 		if (spdk_sn32_lt(pdu->cmd_sn, sess->ExpCmdSN) ||
 		    spdk_sn32_gt(pdu->cmd_sn, sess->MaxCmdSN)) {
@@ -4433,11 +4482,19 @@ iscsi_update_cmdsn(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
 				if (sess->ErrorRecoveryLevel >= 1) {
 					SPDK_DEBUGLOG(iscsi, "Skip the error in ERL 1 and 2\n");
 				} else {
+					pthread_mutex_unlock(&sess->mutex);
 					return SPDK_PDU_FATAL;
 				}
 			}
 		}
-	} else if (pdu->cmd_sn != sess->ExpCmdSN) {
+	} else if (pdu->cmd_sn != sess->ExpCmdSN &&
+		   /*
+		    * With multiple connections, an immediate command may be ahead of
+		    *  non-immediate commands still in flight on the other connections.
+		    */
+		   (sess->connections == 1 ||
+		    spdk_sn32_lt(pdu->cmd_sn, sess->ExpCmdSN) ||
+		    spdk_sn32_gt(pdu->cmd_sn, sess->MaxCmdSN + 1))) {
 		SPDK_ERRLOG("CmdSN(%u) error ExpCmdSN=%u\n", pdu->cmd_sn, sess->ExpCmdSN);
 
 		if (sess->ErrorRecoveryLevel >= 1) {
@@ -4448,10 +4505,16 @@ iscsi_update_cmdsn(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
 			 *  nopout under heavy load, so do not close the
 			 *  connection in that case.
 			 */
+			pthread_mutex_unlock(&sess->mutex);
 			return SPDK_ISCSI_CONNECTION_FATAL;
 		}
 	}
 
+	if (!I_bit && opcode != ISCSI_OP_SCSI_DATAOUT) {
+		iscsi_sess_recv_cmd_sn(sess, pdu->cmd_sn);
+	}
+	pthread_mutex_unlock(&sess->mutex);
+
 	ExpStatSN = from_be32(&reqh->exp_stat_sn);
 	if (spdk_sn32_gt(ExpStatSN, conn->StatSN)) {
 		SPDK_DEBUGLOG(iscsi, "StatSN(%u) advanced\n", ExpStatSN);
@@ -4462,10 +4525,6 @@ iscsi_update_cmdsn(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
 		remove_acked_pdu(conn, ExpStatSN);
 	}
 
-	if (!I_bit && opcode != ISCSI_OP_SCSI_DATAOUT) {
-		sess->ExpCmdSN++;
-	}
-
 	return 0;
 }
 
@@ -94,6 +94,9 @@
  */
 #define DEFAULT_MAX_QUEUE_DEPTH	64
 
+/* Must be no less than the maximum MaxQueueDepth and a multiple of 64 */
+#define ISCSI_CMDSN_WINDOW_SIZE	256
+
 /** Defines how long we should wait for a logout request when the target
  *   requests logout to the initiator asynchronously.
  */
@@ -163,6 +166,10 @@ struct spdk_iscsi_pdu {
 	uint32_t data_buf_len;
 	uint32_t data_offset;
 	uint32_t crc32c;
+	/* The data digest is being computed by accel */
+	bool digest_in_progress;
+	/* Writing the PDU waits for the data digests of it and preceding PDUs */
+	bool write_deferred;
 	bool dif_insert_or_strip;
 	struct spdk_dif_ctx dif_ctx;
 	struct spdk_iscsi_conn *conn;
@@ -276,8 +283,16 @@ struct spdk_iscsi_sess {
 	bool DataSequenceInOrder;
 	uint32_t ErrorRecoveryLevel;
 
+	/*
+	 * With multiple connections per session, commands of a single session may be
+	 *  received on different poll groups.  ExpCmdSN and the window of commands received
+	 *  ahead of it are protected by the mutex, MaxCmdSN is updated atomically.
+	 */
+	pthread_mutex_t mutex;
 	uint32_t ExpCmdSN;
 	uint32_t MaxCmdSN;
+	/* Commands received with CmdSN > ExpCmdSN, indexed by CmdSN % ISCSI_CMDSN_WINDOW_SIZE */
+	uint64_t cmdsn_received[ISCSI_CMDSN_WINDOW_SIZE / 64];
 
 	uint32_t current_text_itt;
 };
@@ -287,6 +302,7 @@ struct spdk_iscsi_poll_group {
 	struct spdk_poller				*nop_poller;
 	STAILQ_HEAD(connections, spdk_iscsi_conn)	connections;
 	struct spdk_sock_group				*sock_group;
+	struct spdk_io_channel				*accel_channel;
 	TAILQ_ENTRY(spdk_iscsi_poll_group)		link;
 };
 
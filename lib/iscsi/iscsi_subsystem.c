@@ -4,6 +4,7 @@
  *   All rights reserved.
  */
 
+#include "spdk/accel.h"
 #include "spdk/string.h"
 #include "spdk/likely.h"
 
@@ -996,6 +997,12 @@ iscsi_poll_group_create(void *io_device, void *ctx_buf)
 	pg->sock_group = spdk_sock_group_create(NULL);
 	assert(pg->sock_group != NULL);
 
+	/* Data digests are computed inline if accel isn't available. */
+	pg->accel_channel = spdk_accel_get_io_channel();
+	if (pg->accel_channel == NULL) {
+		SPDK_NOTICELOG("No accel channel, data digests will be computed inline\n");
+	}
+
 	pg->poller = SPDK_POLLER_REGISTER(iscsi_poll_group_poll, pg, 0);
 	/* set the period to 1 sec */
 	pg->nop_poller = SPDK_POLLER_REGISTER(iscsi_poll_group_handle_nop, pg, 1000000);
@@ -1017,6 +1024,10 @@ iscsi_poll_group_destroy(void *io_device, void *ctx_buf)
 	spdk_poller_unregister(&pg->poller);
 	spdk_poller_unregister(&pg->nop_poller);
 
+	if (pg->accel_channel != NULL) {
+		spdk_put_io_channel(pg->accel_channel);
+	}
+
 	ch = spdk_io_channel_from_ctx(pg);
 	thread = spdk_io_channel_get_thread(ch);
 
@@ -7,8 +7,199 @@
 
 #include "spdk_internal/utf.h"
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define SPDK_JSON_MAX_NESTING_DEPTH	64
 
+/*
+ * Strings and the whitespace between tokens make up most of a typical configuration file.
+ *  Runs of bytes that don't change the parser's state are skipped a vector at a time,
+ *  json_scan_string() and json_scan_whitespace() return the index of the first byte in
+ *  the vector that needs a closer look, or JSON_SCAN_WIDTH if there is none.
+ */
+#if defined(__AVX2__)
+
+#define JSON_SCAN_WIDTH 32
+
+static inline size_t
+json_scan_first(__m256i match)
+{
+	uint32_t mask = (uint32_t)_mm256_movemask_epi8(match);
+
+	return mask == 0 ? JSON_SCAN_WIDTH : (size_t)__builtin_ctz(mask);
+}
+
+static inline size_t
+json_scan_string(const uint8_t *p)
+{
+	__m256i v = _mm256_loadu_si256((const __m256i *)p);
+	__m256i match;
+
+	/* Quote, backslash, and bytes below 0x20 as signed, i.e. control and non-ASCII characters */
+	match = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+	match = _mm256_or_si256(match, _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+
+	return json_scan_first(match);
+}
+
+static inline size_t
+json_scan_whitespace(const uint8_t *p)
+{
+	__m256i v = _mm256_loadu_si256((const __m256i *)p);
+	__m256i ws;
+
+	ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+			     _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+	ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+	ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+
+	return json_scan_first(_mm256_xor_si256(ws, _mm256_set1_epi8(-1)));
+}
+
+#elif defined(__SSE2__)
+
+#define JSON_SCAN_WIDTH 16
+
+static inline size_t
+json_scan_first(__m128i match)
+{
+	uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+
+	return mask == 0 ? JSON_SCAN_WIDTH : (size_t)__builtin_ctz(mask);
+}
+
+static inline size_t
+json_scan_string(const uint8_t *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	__m128i match;
+
+	/* Quote, backslash, and bytes below 0x20 as signed, i.e. control and non-ASCII characters */
+	match = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+			     _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+	match = _mm_or_si128(match, _mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+
+	return json_scan_first(match);
+}
+
+static inline size_t
+json_scan_whitespace(const uint8_t *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	__m128i ws;
+
+	ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+			  _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	ws = _mm_or_si128(ws, _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+	ws = _mm_or_si128(ws, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+
+	return json_scan_first(_mm_xor_si128(ws, _mm_set1_epi8(-1)));
+}
+
+#elif defined(__aarch64__)
+
+#define JSON_SCAN_WIDTH 16
+
+static inline size_t
+json_scan_first(uint8x16_t match)
+{
+	/* Narrow each byte of the match to 4 bits of a 64-bit mask */
+	uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+					      vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+
+	return mask == 0 ? JSON_SCAN_WIDTH : (size_t)__builtin_ctzll(mask) >> 2;
+}
+
+static inline size_t
+json_scan_string(const uint8_t *p)
+{
+	uint8x16_t v = vld1q_u8(p);
+	uint8x16_t match;
+
+	match = vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\')));
+	match = vorrq_u8(match, vcltq_u8(v, vdupq_n_u8(0x20)));
+	match = vorrq_u8(match, vcgeq_u8(v, vdupq_n_u8(0x80)));
+
+	return json_scan_first(match);
+}
+
+static inline size_t
+json_scan_whitespace(const uint8_t *p)
+{
+	uint8x16_t v = vld1q_u8(p);
+	uint8x16_t ws;
+
+	ws = vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\n')));
+	ws = vorrq_u8(ws, vceqq_u8(v, vdupq_n_u8('\t')));
+	ws = vorrq_u8(ws, vceqq_u8(v, vdupq_n_u8('\r')));
+
+	return json_scan_first(vmvnq_u8(ws));
+}
+
+#endif
+
+static inline bool
+json_plain_char(uint8_t c)
+{
+	return c >= 0x20 && c < 0x80 && c != '"' && c != '\\';
+}
+
+static inline bool
+json_whitespace(uint8_t c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* Number of ASCII characters at start which can be copied to a decoded string as they are */
+static inline size_t
+json_plain_len(const uint8_t *start, const uint8_t *buf_end)
+{
+	const uint8_t *p = start;
+#ifdef JSON_SCAN_WIDTH
+	size_t n;
+
+	while (buf_end - p >= JSON_SCAN_WIDTH) {
+		n = json_scan_string(p);
+		p += n;
+		if (n < JSON_SCAN_WIDTH) {
+			return p - start;
+		}
+	}
+#endif
+	while (p < buf_end && json_plain_char(*p)) {
+		p++;
+	}
+
+	return p - start;
+}
+
+static inline size_t
+json_whitespace_len(const uint8_t *start, const uint8_t *buf_end)
+{
+	const uint8_t *p = start;
+#ifdef JSON_SCAN_WIDTH
+	size_t n;
+
+	while (buf_end - p >= JSON_SCAN_WIDTH) {
+		n = json_scan_whitespace(p);
+		p += n;
+		if (n < JSON_SCAN_WIDTH) {
+			return p - start;
+		}
+	}
+#endif
+	while (p < buf_end && json_whitespace(*p)) {
+		p++;
+	}
+
+	return p - start;
+}
+
 static int
 hex_value(uint8_t c)
 {
@@ -171,6 +362,7 @@ json_decode_string(uint8_t *str_start, uint8_t *buf_end, uint8_t **str_end, uint
 {
 	uint8_t *str = str_start;
 	uint8_t *out = str_start + 1; /* Decode string in place (skip the initial quote) */
+	size_t len;
 	int rc;
 
 	if (buf_end - str_start < 2) {
@@ -188,6 +380,16 @@ json_decode_string(uint8_t *str_start, uint8_t *buf_end, uint8_t **str_end, uint
 	}
 
 	while (str < buf_end) {
+		len = json_plain_len(str, buf_end);
+		if (len > 0) {
+			if (out != str && (flags & SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE)) {
+				memmove(out, str, len);
+			}
+			out += len;
+			str += len;
+			continue;
+		}
+
 		if (str[0] == '"') {
 			/*
 			 * End of string.
@@ -452,7 +654,7 @@ spdk_json_parse(void *json, size_t size, struct spdk_json_val *values, size_t nu
 		case '\r':
 		case '\n':
 			/* Whitespace is allowed between any tokens. */
-			data++;
+			data += json_whitespace_len(data, json_end);
 			break;
 
 		case 't':
@@ -601,15 +803,7 @@ spdk_json_parse(void *json, size_t size, struct spdk_json_val *values, size_t nu
 
 	if (state == STATE_END) {
 		/* Skip trailing whitespace */
-		while (data < json_end) {
-			uint8_t c = *data;
-
-			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-				data++;
-			} else {
-				break;
-			}
-		}
+		data += json_whitespace_len(data, json_end);
 
 		/*
 		 * These asserts are just for sanity checking - they are guaranteed by the allowed
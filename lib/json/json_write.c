@@ -87,6 +87,20 @@ spdk_json_write_end(struct spdk_json_write_ctx *w)
 	return failed ? -1 : 0;
 }
 
+int
+spdk_json_write_flush(struct spdk_json_write_ctx *w)
+{
+	if (w->failed) {
+		return -1;
+	}
+
+	if (w->buf_filled == 0) {
+		return 0;
+	}
+
+	return flush_buf(w);
+}
+
 static inline int
 emit(struct spdk_json_write_ctx *w, const void *data, size_t size)
 {
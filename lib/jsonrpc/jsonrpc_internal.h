@@ -13,13 +13,25 @@
 #include "spdk/log.h"
 
 #define SPDK_JSONRPC_RECV_BUF_SIZE	(32 * 1024)
+#define SPDK_JSONRPC_RECV_BUF_SIZE_MAX	(4 * 1024 * 1024)
 #define SPDK_JSONRPC_SEND_BUF_SIZE_INIT	(32 * 1024)
 #define SPDK_JSONRPC_SEND_BUF_SIZE_MAX	(32 * 1024 * 1024)
+/* Amount of flushed response data waiting to be sent, above which the handler is asked to yield */
+#define SPDK_JSONRPC_STREAM_PENDING_MAX	(4 * 1024 * 1024)
 #define SPDK_JSONRPC_ID_MAX_LEN		128
 #define SPDK_JSONRPC_MAX_CONNS		64
 #define SPDK_JSONRPC_MAX_VALUES		1024
 #define SPDK_JSONRPC_CLIENT_MAX_VALUES		8192
 
+/* Part of a response flushed by spdk_jsonrpc_flush() */
+struct spdk_jsonrpc_send_chunk {
+	uint8_t *buf;
+	size_t len;
+	size_t offset;
+
+	STAILQ_ENTRY(spdk_jsonrpc_send_chunk) link;
+};
+
 struct spdk_jsonrpc_request {
 	struct spdk_jsonrpc_server_conn *conn;
 
@@ -42,6 +54,18 @@ struct spdk_jsonrpc_request {
 
 	struct spdk_json_write_ctx *response;
 
+	/*
+	 * The response is sent in chunks while the handler writes it. The fields below
+	 * are guarded by conn->queue_lock once the request is streaming.
+	 */
+	bool streaming;
+	/* The last chunk has been queued */
+	bool stream_done;
+	/* Number of bytes queued, but not sent yet */
+	size_t stream_pending;
+	size_t stream_total;
+	STAILQ_HEAD(, spdk_jsonrpc_send_chunk) chunks;
+
 	STAILQ_ENTRY(spdk_jsonrpc_request) link;
 };
 
@@ -50,7 +74,8 @@ struct spdk_jsonrpc_server_conn {
 	int sockfd;
 	bool closed;
 	size_t recv_len;
-	uint8_t recv_buf[SPDK_JSONRPC_RECV_BUF_SIZE];
+	size_t recv_buf_size;
+	uint8_t *recv_buf;
 	uint32_t outstanding_requests;
 
 	pthread_spinlock_t queue_lock;
@@ -120,6 +145,13 @@ void jsonrpc_server_handle_error(struct spdk_jsonrpc_request *request, int error
 /* Might be called from any thread */
 void jsonrpc_server_send_response(struct spdk_jsonrpc_request *request);
 
+/*
+ * Queue the data in the request's send buffer as the next chunk of the response.
+ * Returns the number of bytes waiting to be sent or -ENOTCONN if the connection is closed.
+ * Might be called from any thread.
+ */
+ssize_t jsonrpc_server_stream_response(struct spdk_jsonrpc_request *request);
+
 /* jsonrpc_server */
 int jsonrpc_parse_request(struct spdk_jsonrpc_server_conn *conn, const void *json,
 			  size_t size);
@@ -128,6 +128,13 @@ invalid:
 	jsonrpc_server_handle_error(request, SPDK_JSONRPC_ERROR_INVALID_REQUEST);
 }
 
+static bool
+jsonrpc_result_needed(struct spdk_jsonrpc_request *request)
+{
+	/* If there was no ID in request the result is not sent. */
+	return request->id && request->id->type != SPDK_JSON_VAL_NULL;
+}
+
 static int
 jsonrpc_server_write_cb(void *cb_ctx, const void *data, size_t size)
 {
@@ -135,6 +142,18 @@ jsonrpc_server_write_cb(void *cb_ctx, const void *data, size_t size)
 	size_t new_size = request->send_buf_size;
 
 	while (new_size - request->send_len < size) {
+		if (new_size >= SPDK_JSONRPC_SEND_BUF_SIZE_MAX && request->send_len > 0) {
+			/* Send the data written so far instead of growing the buffer any further */
+			if (!jsonrpc_result_needed(request)) {
+				request->send_len = 0;
+			} else if (jsonrpc_server_stream_response(request) < 0) {
+				return -1;
+			}
+
+			new_size = request->send_buf_size;
+			continue;
+		}
+
 		if (new_size >= SPDK_JSONRPC_SEND_BUF_SIZE_MAX) {
 			SPDK_ERRLOG("Send buf exceeded maximum size (%zu)\n",
 				    (size_t)SPDK_JSONRPC_SEND_BUF_SIZE_MAX);
@@ -192,6 +211,7 @@ jsonrpc_parse_request(struct spdk_jsonrpc_server_conn *conn, const void *json, s
 	pthread_spin_unlock(&conn->queue_lock);
 
 	request->conn = conn;
+	STAILQ_INIT(&request->chunks);
 
 	len = end - json;
 	request->recv_buffer = malloc(len + 1);
@@ -320,6 +340,7 @@ jsonrpc_free_request(struct spdk_jsonrpc_request *request)
 {
 	struct spdk_jsonrpc_request *req;
 	struct spdk_jsonrpc_server_conn *conn;
+	struct spdk_jsonrpc_send_chunk *chunk;
 
 	if (!request) {
 		return;
@@ -341,6 +362,13 @@ jsonrpc_free_request(struct spdk_jsonrpc_request *request)
 		}
 		pthread_spin_unlock(&conn->queue_lock);
 	}
+
+	while ((chunk = STAILQ_FIRST(&request->chunks)) != NULL) {
+		STAILQ_REMOVE_HEAD(&request->chunks, link);
+		free(chunk->buf);
+		free(chunk);
+	}
+
 	free(request->recv_buffer);
 	free(request->values);
 	free(request->send_buf);
@@ -350,7 +378,15 @@ jsonrpc_free_request(struct spdk_jsonrpc_request *request)
 void
 jsonrpc_complete_request(struct spdk_jsonrpc_request *request)
 {
-	jsonrpc_log(request->send_buf, "response: ");
+	char summary[64];
+
+	if (request->streaming) {
+		/* The chunks were freed as they were sent */
+		snprintf(summary, sizeof(summary), "(%zu bytes streamed)", request->stream_total);
+		jsonrpc_log(summary, "response: ");
+	} else {
+		jsonrpc_log(request->send_buf, "response: ");
+	}
 
 	jsonrpc_free_request(request);
 }
@@ -371,13 +407,38 @@ spdk_jsonrpc_end_result(struct spdk_jsonrpc_request *request, struct spdk_json_w
 	assert(w == request->response);
 
 	/* If there was no ID in request we skip response. */
-	if (request->id && request->id->type != SPDK_JSON_VAL_NULL) {
+	if (jsonrpc_result_needed(request)) {
 		end_response(request);
 	} else {
 		skip_response(request);
 	}
 }
 
+int
+spdk_jsonrpc_flush(struct spdk_jsonrpc_request *request)
+{
+	ssize_t rc;
+
+	assert(request->response != NULL);
+
+	if (spdk_json_write_flush(request->response) != 0) {
+		return -ENOMEM;
+	}
+
+	if (!jsonrpc_result_needed(request)) {
+		/* The result would be skipped anyway */
+		request->send_len = 0;
+		return 0;
+	}
+
+	rc = jsonrpc_server_stream_response(request);
+	if (rc < 0) {
+		return rc;
+	}
+
+	return rc > SPDK_JSONRPC_STREAM_PENDING_MAX ? -EAGAIN : 0;
+}
+
 void
 spdk_jsonrpc_send_bool_response(struct spdk_jsonrpc_request *request, bool value)
 {
@@ -78,12 +78,34 @@ jsonrpc_server_dequeue_request(struct spdk_jsonrpc_server_conn *conn)
 	return request;
 }
 
+static void
+jsonrpc_server_drop_request(struct spdk_jsonrpc_server_conn *conn,
+			    struct spdk_jsonrpc_request *request)
+{
+	if (request == NULL) {
+		return;
+	}
+
+	pthread_spin_lock(&conn->queue_lock);
+	if (request->streaming && !request->stream_done) {
+		/* The handler is still writing the response. Detach the request from the
+		 * connection, it will be freed once the handler completes the response. */
+		request->conn = NULL;
+		conn->outstanding_requests--;
+		pthread_spin_unlock(&conn->queue_lock);
+		return;
+	}
+	pthread_spin_unlock(&conn->queue_lock);
+
+	jsonrpc_free_request(request);
+}
+
 static void
 jsonrpc_server_free_conn_request(struct spdk_jsonrpc_server_conn *conn)
 {
 	struct spdk_jsonrpc_request *request;
 
-	jsonrpc_free_request(conn->send_request);
+	jsonrpc_server_drop_request(conn, conn->send_request);
 	conn->send_request = NULL ;
 
 	pthread_spin_lock(&conn->queue_lock);
@@ -95,7 +117,7 @@ jsonrpc_server_free_conn_request(struct spdk_jsonrpc_server_conn *conn)
 	pthread_spin_unlock(&conn->queue_lock);
 
 	while ((request = jsonrpc_server_dequeue_request(conn)) != NULL) {
-		jsonrpc_free_request(request);
+		jsonrpc_server_drop_request(conn, request);
 	}
 }
 
@@ -124,6 +146,7 @@ spdk_jsonrpc_server_shutdown(struct spdk_jsonrpc_server *server)
 
 	TAILQ_FOREACH(conn, &server->conns, link) {
 		jsonrpc_server_conn_close(conn);
+		free(conn->recv_buf);
 	}
 
 	free(server);
@@ -138,6 +161,8 @@ jsonrpc_server_conn_remove(struct spdk_jsonrpc_server_conn *conn)
 
 	pthread_spin_destroy(&conn->queue_lock);
 	assert(STAILQ_EMPTY(&conn->send_queue));
+	free(conn->recv_buf);
+	conn->recv_buf = NULL;
 
 	TAILQ_REMOVE(&server->conns, conn, link);
 	TAILQ_INSERT_HEAD(&server->free_conns, conn, link);
@@ -213,6 +238,16 @@ jsonrpc_server_accept(struct spdk_jsonrpc_server *server)
 			return -1;
 		}
 
+		conn->recv_buf_size = SPDK_JSONRPC_RECV_BUF_SIZE;
+		conn->recv_buf = malloc(conn->recv_buf_size);
+		if (conn->recv_buf == NULL) {
+			SPDK_ERRLOG("Unable to allocate receive buffer for socket: %d\n",
+				    conn->sockfd);
+			close(conn->sockfd);
+			pthread_spin_destroy(&conn->queue_lock);
+			return -1;
+		}
+
 		TAILQ_REMOVE(&server->free_conns, conn, link);
 		TAILQ_INSERT_TAIL(&server->conns, conn, link);
 		return 0;
@@ -266,12 +301,46 @@ jsonrpc_server_handle_error(struct spdk_jsonrpc_request *request, int error)
 	spdk_jsonrpc_send_error_response(request, error, msg);
 }
 
+static int
+jsonrpc_server_conn_grow_recv_buf(struct spdk_jsonrpc_server_conn *conn)
+{
+	size_t new_size = conn->recv_buf_size * 2;
+	uint8_t *new_buf;
+
+	if (new_size > SPDK_JSONRPC_RECV_BUF_SIZE_MAX) {
+		SPDK_ERRLOG("Request exceeded maximum size (%zu)\n",
+			    (size_t)SPDK_JSONRPC_RECV_BUF_SIZE_MAX);
+		return -1;
+	}
+
+	new_buf = realloc(conn->recv_buf, new_size);
+	if (new_buf == NULL) {
+		SPDK_ERRLOG("Resizing recv_buf failed (current size %zu, new size %zu)\n",
+			    conn->recv_buf_size, new_size);
+		return -1;
+	}
+
+	conn->recv_buf = new_buf;
+	conn->recv_buf_size = new_size;
+
+	return 0;
+}
+
 static int
 jsonrpc_server_conn_recv(struct spdk_jsonrpc_server_conn *conn)
 {
 	ssize_t rc, offset;
-	size_t recv_avail = SPDK_JSONRPC_RECV_BUF_SIZE - conn->recv_len;
+	size_t recv_avail;
 
+	/* Requests larger than the receive buffer are accumulated until they are complete */
+	if (conn->recv_len == conn->recv_buf_size) {
+		rc = jsonrpc_server_conn_grow_recv_buf(conn);
+		if (rc != 0) {
+			return -1;
+		}
+	}
+
+	recv_avail = conn->recv_buf_size - conn->recv_len;
 	rc = recv(conn->sockfd, conn->recv_buf + conn->recv_len, recv_avail, 0);
 	if (rc == -1) {
 		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
@@ -313,6 +382,75 @@ jsonrpc_server_conn_recv(struct spdk_jsonrpc_server_conn *conn)
 	return 0;
 }
 
+static ssize_t
+jsonrpc_server_queue_chunk(struct spdk_jsonrpc_request *request, bool last)
+{
+	struct spdk_jsonrpc_server_conn *conn = request->conn;
+	struct spdk_jsonrpc_send_chunk *chunk = NULL;
+	uint8_t *new_buf = NULL;
+	ssize_t rc;
+
+	if (conn == NULL) {
+		return -ENOTCONN;
+	}
+
+	if (request->send_len > 0) {
+		chunk = calloc(1, sizeof(*chunk));
+		if (!last) {
+			/* Add extra byte for the null terminator. */
+			new_buf = malloc(SPDK_JSONRPC_SEND_BUF_SIZE_INIT + 1);
+		}
+
+		if (chunk == NULL || (!last && new_buf == NULL)) {
+			SPDK_ERRLOG("Failed to allocate response chunk (%zu bytes)\n",
+				    request->send_len);
+			free(chunk);
+			free(new_buf);
+			if (!last) {
+				return -ENOMEM;
+			}
+			/* Complete the response anyway, the client gets a truncated one */
+			chunk = NULL;
+		} else {
+			chunk->buf = request->send_buf;
+			chunk->len = request->send_len;
+			request->send_buf = new_buf;
+			request->send_buf_size = new_buf != NULL ? SPDK_JSONRPC_SEND_BUF_SIZE_INIT : 0;
+			request->send_len = 0;
+		}
+	}
+
+	pthread_spin_lock(&conn->queue_lock);
+	if (request->conn == NULL) {
+		/* The connection was closed in the meantime */
+		pthread_spin_unlock(&conn->queue_lock);
+		if (chunk != NULL) {
+			free(chunk->buf);
+			free(chunk);
+		}
+		return -ENOTCONN;
+	}
+
+	if (!request->streaming) {
+		/* The response takes its place in the send queue with the first chunk */
+		request->streaming = true;
+		STAILQ_REMOVE(&conn->outstanding_queue, request, spdk_jsonrpc_request, link);
+		STAILQ_INSERT_TAIL(&conn->send_queue, request, link);
+	}
+
+	if (chunk != NULL) {
+		STAILQ_INSERT_TAIL(&request->chunks, chunk, link);
+		request->stream_pending += chunk->len;
+		request->stream_total += chunk->len;
+	}
+
+	request->stream_done = last;
+	rc = request->stream_pending;
+	pthread_spin_unlock(&conn->queue_lock);
+
+	return rc;
+}
+
 void
 jsonrpc_server_send_response(struct spdk_jsonrpc_request *request)
 {
@@ -325,6 +463,15 @@ jsonrpc_server_send_response(struct spdk_jsonrpc_request *request)
 		return;
 	}
 
+	if (request->streaming) {
+		/* The request is already queued, add the rest of the response as the last chunk */
+		if (jsonrpc_server_queue_chunk(request, true) == -ENOTCONN) {
+			SPDK_WARNLOG("Unable to send response: connection closed.\n");
+			jsonrpc_free_request(request);
+		}
+		return;
+	}
+
 	/* Queue the response to be sent */
 	pthread_spin_lock(&conn->queue_lock);
 	STAILQ_REMOVE(&conn->outstanding_queue, request, spdk_jsonrpc_request, link);
@@ -332,6 +479,59 @@ jsonrpc_server_send_response(struct spdk_jsonrpc_request *request)
 	pthread_spin_unlock(&conn->queue_lock);
 }
 
+ssize_t
+jsonrpc_server_stream_response(struct spdk_jsonrpc_request *request)
+{
+	return jsonrpc_server_queue_chunk(request, false);
+}
+
+/*
+ * Send the queued chunks of a streamed response.
+ * Returns 1 once the whole response is sent, 0 if more data is expected and -1 on error.
+ */
+static int
+jsonrpc_server_conn_send_chunks(struct spdk_jsonrpc_server_conn *conn,
+				struct spdk_jsonrpc_request *request)
+{
+	struct spdk_jsonrpc_send_chunk *chunk;
+	bool done;
+	ssize_t rc;
+
+	while (true) {
+		pthread_spin_lock(&conn->queue_lock);
+		chunk = STAILQ_FIRST(&request->chunks);
+		done = request->stream_done;
+		pthread_spin_unlock(&conn->queue_lock);
+
+		if (chunk == NULL) {
+			return done ? 1 : 0;
+		}
+
+		/* The handler only appends chunks, so the first one can be sent without the lock */
+		rc = send(conn->sockfd, chunk->buf + chunk->offset, chunk->len - chunk->offset, 0);
+		if (rc < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				return 0;
+			}
+
+			SPDK_DEBUGLOG(rpc, "send() failed: %s\n", spdk_strerror(errno));
+			return -1;
+		}
+
+		chunk->offset += rc;
+		if (chunk->offset < chunk->len) {
+			return 0;
+		}
+
+		pthread_spin_lock(&conn->queue_lock);
+		STAILQ_REMOVE_HEAD(&request->chunks, link);
+		request->stream_pending -= chunk->len;
+		pthread_spin_unlock(&conn->queue_lock);
+
+		free(chunk->buf);
+		free(chunk);
+	}
+}
 
 static int
 jsonrpc_server_conn_send(struct spdk_jsonrpc_server_conn *conn)
@@ -354,6 +554,17 @@ more:
 		return 0;
 	}
 
+	if (request->streaming) {
+		rc = jsonrpc_server_conn_send_chunks(conn, request);
+		if (rc <= 0) {
+			return rc;
+		}
+
+		conn->send_request = NULL;
+		jsonrpc_complete_request(request);
+		goto more;
+	}
+
 	if (request->send_offset == 0) {
 		/* A byte for the null terminator is included in the send buffer. */
 		request->send_buf[request->send_len] = '\0';
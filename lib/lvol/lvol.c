@@ -1735,6 +1735,212 @@ spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, v
 				     lvol_inflate_cb, req);
 }
 
+static void
+lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
+{
+	struct spdk_lvol_req *req = cb_arg;
+
+	spdk_bs_free_io_channel(req->channel);
+
+	if (lvolerrno < 0) {
+		SPDK_ERRLOG("Could not copy lvol %s: %d\n", req->lvol->unique_id, lvolerrno);
+	}
+
+	req->cb_fn(req->cb_arg, lvolerrno);
+	free(req);
+}
+
+void
+spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_lvol *base,
+		       struct spdk_bs_dev *ext_dev, uint32_t queue_depth,
+		       spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_req *req;
+
+	assert(cb_fn != NULL);
+
+	if (lvol == NULL || ext_dev == NULL) {
+		SPDK_ERRLOG("Lvol or external device does not exist\n");
+		cb_fn(cb_arg, -ENODEV);
+		return;
+	}
+
+	if (base != NULL && base->lvol_store != lvol->lvol_store) {
+		SPDK_ERRLOG("lvol %s: base lvol %s is in a different lvol store\n",
+			    lvol->unique_id, base->unique_id);
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (!req) {
+		SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+	req->lvol = lvol;
+	req->channel = spdk_bs_alloc_io_channel(lvol->lvol_store->blobstore);
+	if (req->channel == NULL) {
+		SPDK_ERRLOG("Cannot alloc io channel for lvol shallow copy request\n");
+		free(req);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	spdk_bs_blob_shallow_copy(lvol->lvol_store->blobstore, req->channel, lvol->blob_id,
+				  base != NULL ? base->blob_id : SPDK_BLOBID_INVALID, ext_dev,
+				  queue_depth, lvol_shallow_copy_cb, req);
+}
+
+struct lvol_decouple_clones_req {
+	spdk_lvol_op_complete	cb_fn;
+	void			*cb_arg;
+	struct spdk_lvol	*snapshot;
+	/* Clones to decouple, the one that is kept isn't included */
+	spdk_blob_id		*ids;
+	size_t			count;
+	size_t			index;
+};
+
+/* Number of the snapshot's clusters not overwritten by the clone, i.e. copied on decoupling it */
+static uint64_t
+lvol_count_shared_clusters(struct spdk_lvol *snapshot, struct spdk_lvol *clone)
+{
+	struct spdk_blob_store *bs = snapshot->lvol_store->blobstore;
+	uint64_t cluster_io_units, offset, unallocated, count = 0;
+
+	cluster_io_units = spdk_bs_get_cluster_size(bs) / spdk_bs_get_io_unit_size(bs);
+
+	offset = spdk_blob_get_next_allocated_io_unit(snapshot->blob, 0);
+	while (offset != UINT64_MAX) {
+		unallocated = spdk_blob_get_next_unallocated_io_unit(clone->blob, offset);
+		if (unallocated == UINT64_MAX) {
+			break;
+		}
+
+		if (unallocated == offset) {
+			count++;
+			offset += cluster_io_units;
+		} else {
+			offset = unallocated;
+		}
+
+		offset = spdk_blob_get_next_allocated_io_unit(snapshot->blob, offset);
+	}
+
+	return count;
+}
+
+static void
+lvol_decouple_next_clone(void *cb_arg, int lvolerrno)
+{
+	struct lvol_decouple_clones_req *req = cb_arg;
+	struct spdk_lvol *clone = NULL;
+
+	if (lvolerrno == 0 && req->index < req->count) {
+		clone = lvs_get_lvol_by_blob_id(req->snapshot->lvol_store, req->ids[req->index++]);
+		if (clone == NULL) {
+			lvolerrno = -ENODEV;
+		}
+	}
+
+	if (clone == NULL) {
+		if (lvolerrno != 0) {
+			SPDK_ERRLOG("lvol %s: could not decouple clones: %d\n",
+				    req->snapshot->unique_id, lvolerrno);
+		}
+		req->cb_fn(req->cb_arg, lvolerrno);
+		free(req->ids);
+		free(req);
+		return;
+	}
+
+	SPDK_INFOLOG(lvol, "lvol %s: decoupling clone %s\n", req->snapshot->unique_id,
+		     clone->unique_id);
+	spdk_lvol_decouple_parent(clone, lvol_decouple_next_clone, req);
+}
+
+void
+spdk_lvol_decouple_clones(struct spdk_lvol *snapshot, spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_store *bs;
+	struct lvol_decouple_clones_req *req;
+	struct spdk_lvol *clone;
+	uint64_t shared, max_shared = 0;
+	size_t i, keep = 0, count = 0;
+	int rc;
+
+	assert(cb_fn != NULL);
+
+	if (snapshot == NULL) {
+		SPDK_ERRLOG("Lvol does not exist\n");
+		cb_fn(cb_arg, -ENODEV);
+		return;
+	}
+
+	bs = snapshot->lvol_store->blobstore;
+	rc = spdk_blob_get_clones(bs, snapshot->blob_id, NULL, &count);
+	if (rc != -ENOMEM || count <= 1) {
+		/* -ENOMEM says count is valid, there is nothing to decouple otherwise */
+		cb_fn(cb_arg, rc == -ENOMEM ? 0 : rc);
+		return;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	req->ids = calloc(count, sizeof(*req->ids));
+	if (req->ids == NULL) {
+		SPDK_ERRLOG("Cannot alloc memory for clone IDs\n");
+		free(req);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	rc = spdk_blob_get_clones(bs, snapshot->blob_id, req->ids, &count);
+	if (rc != 0) {
+		SPDK_ERRLOG("lvol %s: unable to get clone blob IDs: %d\n", snapshot->unique_id, rc);
+		free(req->ids);
+		free(req);
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		clone = lvs_get_lvol_by_blob_id(snapshot->lvol_store, req->ids[i]);
+		if (clone == NULL || spdk_lvol_is_degraded(clone)) {
+			SPDK_ERRLOG("lvol %s: clone with blob id 0x%" PRIx64 " is not available\n",
+				    snapshot->unique_id, req->ids[i]);
+			free(req->ids);
+			free(req);
+			cb_fn(cb_arg, -ENODEV);
+			return;
+		}
+
+		shared = lvol_count_shared_clusters(snapshot, clone);
+		if (shared > max_shared) {
+			max_shared = shared;
+			keep = i;
+		}
+	}
+
+	/* The kept clone takes over the clusters it shares with the snapshot without copying */
+	req->ids[keep] = req->ids[count - 1];
+	req->count = count - 1;
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+	req->snapshot = snapshot;
+
+	lvol_decouple_next_clone(req, 0);
+}
+
 void
 spdk_lvs_grow(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg)
 {
@@ -0,0 +1,287 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+#include "spdk/metrics.h"
+
+#define EXPORTER_BACKLOG		16
+#define EXPORTER_MAX_REQUEST_SIZE	4096
+#define EXPORTER_TIMEOUT_SEC		5
+
+static const char *g_content_type =
+	"application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+static struct {
+	pthread_t	thread;
+	bool		running;
+	int		listen_fd;
+	/* Written to stop the thread */
+	int		stop_fds[2];
+} g_exporter = {
+	.listen_fd = -1,
+	.stop_fds = {-1, -1},
+};
+
+static int
+exporter_send(int fd, const char *buf, size_t len)
+{
+	ssize_t rc;
+
+	while (len > 0) {
+		rc = send(fd, buf, len, MSG_NOSIGNAL);
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -errno;
+		}
+
+		buf += rc;
+		len -= rc;
+	}
+
+	return 0;
+}
+
+static void
+exporter_send_status(int fd, const char *status)
+{
+	char header[256];
+	int len;
+
+	len = snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Length: 0\r\n"
+		       "Connection: close\r\n\r\n", status);
+	exporter_send(fd, header, len);
+}
+
+static void
+exporter_send_metrics(int fd, bool head)
+{
+	char header[256], *buf;
+	size_t len;
+	int rc, hlen;
+
+	rc = spdk_metrics_render(&buf, &len);
+	if (rc != 0) {
+		exporter_send_status(fd, "500 Internal Server Error");
+		return;
+	}
+
+	hlen = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n"
+			"Content-Length: %zu\r\nConnection: close\r\n\r\n", g_content_type, len);
+	rc = exporter_send(fd, header, hlen);
+	if (rc == 0 && !head) {
+		exporter_send(fd, buf, len);
+	}
+
+	free(buf);
+}
+
+static void
+exporter_handle_conn(int fd)
+{
+	struct timeval timeout = { .tv_sec = EXPORTER_TIMEOUT_SEC };
+	char request[EXPORTER_MAX_REQUEST_SIZE], *method, *path, *end;
+	size_t len = 0;
+	ssize_t rc;
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	/* Only the request line matters, the headers are read and ignored */
+	while (len < sizeof(request) - 1) {
+		rc = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+		if (rc < 0 && errno == EINTR) {
+			continue;
+		} else if (rc <= 0) {
+			return;
+		}
+
+		len += rc;
+		request[len] = '\0';
+		if (strstr(request, "\r\n\r\n") != NULL) {
+			break;
+		}
+	}
+
+	request[len] = '\0';
+	method = request;
+	path = strchr(method, ' ');
+	if (path == NULL) {
+		exporter_send_status(fd, "400 Bad Request");
+		return;
+	}
+
+	*path++ = '\0';
+	end = strpbrk(path, " ?\r\n");
+	if (end != NULL) {
+		*end = '\0';
+	}
+
+	if (strcmp(method, "GET") != 0 && strcmp(method, "HEAD") != 0) {
+		exporter_send_status(fd, "405 Method Not Allowed");
+	} else if (strcmp(path, "/metrics") != 0) {
+		exporter_send_status(fd, "404 Not Found");
+	} else {
+		exporter_send_metrics(fd, strcmp(method, "HEAD") == 0);
+	}
+}
+
+static void *
+exporter_thread(void *arg)
+{
+	struct pollfd fds[2] = {
+		{ .fd = g_exporter.listen_fd, .events = POLLIN },
+		{ .fd = g_exporter.stop_fds[0], .events = POLLIN },
+	};
+	int fd, rc;
+
+	/* The thread inherits the CPU mask of the reactor that started it */
+	spdk_unaffinitize_thread();
+
+	while (true) {
+		rc = poll(fds, SPDK_COUNTOF(fds), -1);
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			SPDK_ERRLOG("Failed to poll the metrics exporter socket: %s\n",
+				    spdk_strerror(errno));
+			break;
+		}
+
+		if (fds[1].revents != 0) {
+			break;
+		}
+
+		if (fds[0].revents == 0) {
+			continue;
+		}
+
+		fd = accept(g_exporter.listen_fd, NULL, NULL);
+		if (fd < 0) {
+			continue;
+		}
+
+		exporter_handle_conn(fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+static int
+exporter_listen(const char *address, uint16_t port)
+{
+	struct addrinfo hints = {}, *res, *ai;
+	char service[8];
+	int fd = -1, val = 1, rc;
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+	snprintf(service, sizeof(service), "%"PRIu16, port);
+
+	rc = getaddrinfo(address, service, &hints, &res);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to resolve %s: %s\n", address, gai_strerror(rc));
+		return -EINVAL;
+	}
+
+	rc = -EINVAL;
+	for (ai = res; ai != NULL; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+		if (fd < 0) {
+			rc = -errno;
+			continue;
+		}
+
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+		if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, EXPORTER_BACKLOG) == 0) {
+			break;
+		}
+
+		rc = -errno;
+		close(fd);
+		fd = -1;
+	}
+
+	freeaddrinfo(res);
+	if (fd < 0) {
+		SPDK_ERRLOG("Failed to listen on %s:%"PRIu16": %s\n", address, port,
+			    spdk_strerror(-rc));
+		return rc;
+	}
+
+	return fd;
+}
+
+int
+spdk_metrics_exporter_start(const char *address, uint16_t port)
+{
+	int rc;
+
+	if (g_exporter.running) {
+		return -EALREADY;
+	}
+
+	g_exporter.listen_fd = exporter_listen(address, port);
+	if (g_exporter.listen_fd < 0) {
+		rc = g_exporter.listen_fd;
+		g_exporter.listen_fd = -1;
+		return rc;
+	}
+
+	if (pipe(g_exporter.stop_fds) != 0) {
+		rc = -errno;
+		goto err;
+	}
+
+	rc = pthread_create(&g_exporter.thread, NULL, exporter_thread, NULL);
+	if (rc != 0) {
+		rc = -rc;
+		goto err;
+	}
+
+	pthread_setname_np(g_exporter.thread, "metrics");
+	g_exporter.running = true;
+	SPDK_NOTICELOG("Serving the metrics on %s:%"PRIu16"\n", address, port);
+
+	return 0;
+err:
+	SPDK_ERRLOG("Failed to start the metrics exporter: %s\n", spdk_strerror(-rc));
+	spdk_metrics_exporter_stop();
+	return rc;
+}
+
+void
+spdk_metrics_exporter_stop(void)
+{
+	char c = 0;
+
+	if (g_exporter.running) {
+		if (write(g_exporter.stop_fds[1], &c, sizeof(c)) != sizeof(c)) {
+			SPDK_ERRLOG("Failed to stop the metrics exporter: %s\n", spdk_strerror(errno));
+		}
+		pthread_join(g_exporter.thread, NULL);
+		g_exporter.running = false;
+	}
+
+	if (g_exporter.listen_fd >= 0) {
+		close(g_exporter.listen_fd);
+		g_exporter.listen_fd = -1;
+	}
+
+	if (g_exporter.stop_fds[0] >= 0) {
+		close(g_exporter.stop_fds[0]);
+		close(g_exporter.stop_fds[1]);
+		g_exporter.stop_fds[0] = g_exporter.stop_fds[1] = -1;
+	}
+}
@@ -0,0 +1,484 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/env.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+#include "spdk/queue.h"
+#include "spdk/util.h"
+
+#include "spdk/metrics.h"
+
+#define METRICS_BUF_INITIAL_SIZE	(64 * 1024)
+
+/* All the groups registered with the same descriptions */
+struct metrics_family {
+	const struct spdk_metric_desc		*descs;
+	uint32_t				num_descs;
+	/* Offset of the first value of each metric within a slot */
+	uint32_t				*offsets;
+	/* Number of values of a slot, rounded up to a cache line */
+	uint32_t				slot_size;
+	TAILQ_HEAD(, spdk_metrics_group)	groups;
+	TAILQ_ENTRY(metrics_family)		tailq;
+};
+
+struct spdk_metrics_group {
+	/*
+	 * One slot per core, followed by a slot shared by the threads that don't run on any of
+	 * the cores of the application, which is updated with atomic operations.  A counter or
+	 * a gauge has a single value, a histogram has one value per bucket, followed by the +Inf
+	 * bucket and the sum of the observed values.
+	 */
+	uint64_t				*values;
+	const uint32_t				*offsets;
+	uint32_t				slot_size;
+	struct metrics_family			*family;
+	char					*label_name;
+	char					*label_value;
+	TAILQ_ENTRY(spdk_metrics_group)		tailq;
+};
+
+static struct {
+	/* Set when the metrics are enabled */
+	uint32_t				num_slots;
+	pthread_mutex_t				mutex;
+	TAILQ_HEAD(, metrics_family)		families;
+} g_metrics = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.families = TAILQ_HEAD_INITIALIZER(g_metrics.families),
+};
+
+static uint32_t
+metric_num_values(const struct spdk_metric_desc *desc)
+{
+	switch (desc->type) {
+	case SPDK_METRIC_TYPE_HISTOGRAM:
+		return desc->num_buckets + 2;
+	default:
+		return 1;
+	}
+}
+
+static struct metrics_family *
+metrics_family_get(const struct spdk_metric_desc *descs, uint32_t num_descs)
+{
+	struct metrics_family *family;
+	uint32_t i, num_values = 0;
+
+	TAILQ_FOREACH(family, &g_metrics.families, tailq) {
+		if (family->descs == descs) {
+			assert(family->num_descs == num_descs);
+			return family;
+		}
+	}
+
+	for (i = 0; i < num_descs; i++) {
+		if (descs[i].type == SPDK_METRIC_TYPE_HISTOGRAM &&
+		    descs[i].num_buckets > SPDK_METRICS_MAX_BUCKETS) {
+			SPDK_ERRLOG("Too many buckets for histogram %s: %"PRIu32"\n",
+				    descs[i].name, descs[i].num_buckets);
+			return NULL;
+		}
+	}
+
+	family = calloc(1, sizeof(*family));
+	if (family == NULL) {
+		return NULL;
+	}
+
+	family->offsets = calloc(num_descs, sizeof(*family->offsets));
+	if (family->offsets == NULL) {
+		free(family);
+		return NULL;
+	}
+
+	for (i = 0; i < num_descs; i++) {
+		family->offsets[i] = num_values;
+		num_values += metric_num_values(&descs[i]);
+	}
+
+	family->descs = descs;
+	family->num_descs = num_descs;
+	family->slot_size = SPDK_ALIGN_CEIL(num_values * sizeof(uint64_t),
+					    SPDK_CACHE_LINE_SIZE) / sizeof(uint64_t);
+	TAILQ_INIT(&family->groups);
+	TAILQ_INSERT_TAIL(&g_metrics.families, family, tailq);
+
+	return family;
+}
+
+static void
+metrics_family_put(struct metrics_family *family)
+{
+	if (!TAILQ_EMPTY(&family->groups)) {
+		return;
+	}
+
+	TAILQ_REMOVE(&g_metrics.families, family, tailq);
+	free(family->offsets);
+	free(family);
+}
+
+static void
+metrics_group_free(struct spdk_metrics_group *group)
+{
+	free(group->values);
+	free(group->label_name);
+	free(group->label_value);
+	free(group);
+}
+
+static struct spdk_metrics_group *
+metrics_group_register(const struct spdk_metric_desc *descs, uint32_t num_descs,
+		       const char *label_name, const char *label_value)
+{
+	struct spdk_metrics_group *group;
+	struct metrics_family *family;
+	size_t size;
+
+	group = calloc(1, sizeof(*group));
+	if (group == NULL) {
+		return NULL;
+	}
+
+	if (label_name != NULL) {
+		group->label_name = strdup(label_name);
+		group->label_value = strdup(label_value);
+		if (group->label_name == NULL || group->label_value == NULL) {
+			metrics_group_free(group);
+			return NULL;
+		}
+	}
+
+	pthread_mutex_lock(&g_metrics.mutex);
+	family = metrics_family_get(descs, num_descs);
+	if (family == NULL) {
+		pthread_mutex_unlock(&g_metrics.mutex);
+		metrics_group_free(group);
+		return NULL;
+	}
+
+	size = (size_t)g_metrics.num_slots * family->slot_size * sizeof(uint64_t);
+	if (posix_memalign((void **)&group->values, SPDK_CACHE_LINE_SIZE, size) != 0) {
+		group->values = NULL;
+		metrics_family_put(family);
+		pthread_mutex_unlock(&g_metrics.mutex);
+		metrics_group_free(group);
+		return NULL;
+	}
+
+	memset(group->values, 0, size);
+	group->offsets = family->offsets;
+	group->slot_size = family->slot_size;
+	group->family = family;
+	TAILQ_INSERT_TAIL(&family->groups, group, tailq);
+	pthread_mutex_unlock(&g_metrics.mutex);
+
+	return group;
+}
+
+static void
+metrics_group_unregister(struct spdk_metrics_group *group)
+{
+	pthread_mutex_lock(&g_metrics.mutex);
+	TAILQ_REMOVE(&group->family->groups, group, tailq);
+	metrics_family_put(group->family);
+	pthread_mutex_unlock(&g_metrics.mutex);
+
+	metrics_group_free(group);
+}
+
+/*
+ * Get the values of a metric in the slot of the current core.  Each slot is only written by
+ * the thread running on its core, so the updates don't need to be atomic, except for the
+ * shared slot.
+ */
+static inline uint64_t *
+metrics_get_values(struct spdk_metrics_group *group, uint32_t idx, bool *shared)
+{
+	uint32_t slot = spdk_env_get_current_core();
+
+	*shared = spdk_unlikely(slot >= g_metrics.num_slots - 1);
+	if (*shared) {
+		slot = g_metrics.num_slots - 1;
+	}
+
+	return &group->values[slot * group->slot_size + group->offsets[idx]];
+}
+
+static inline void
+metrics_value_add(uint64_t *value, uint64_t v, bool shared)
+{
+	if (spdk_unlikely(shared)) {
+		__atomic_fetch_add(value, v, __ATOMIC_RELAXED);
+	} else {
+		__atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + v, __ATOMIC_RELAXED);
+	}
+}
+
+static void
+metrics_counter_add(struct spdk_metrics_group *group, uint32_t idx, uint64_t value)
+{
+	uint64_t *values;
+	bool shared;
+
+	assert(group->family->descs[idx].type == SPDK_METRIC_TYPE_COUNTER);
+	values = metrics_get_values(group, idx, &shared);
+	metrics_value_add(&values[0], value, shared);
+}
+
+static void
+metrics_gauge_add(struct spdk_metrics_group *group, uint32_t idx, int64_t value)
+{
+	uint64_t *values;
+	bool shared;
+
+	assert(group->family->descs[idx].type == SPDK_METRIC_TYPE_GAUGE);
+	values = metrics_get_values(group, idx, &shared);
+	/* Gauges are stored as two's complement, so that their slots can be summed up */
+	metrics_value_add(&values[0], (uint64_t)value, shared);
+}
+
+static void
+metrics_histogram_observe(struct spdk_metrics_group *group, uint32_t idx, uint64_t value)
+{
+	const struct spdk_metric_desc *desc = &group->family->descs[idx];
+	uint64_t *values;
+	uint32_t bucket;
+	bool shared;
+
+	assert(desc->type == SPDK_METRIC_TYPE_HISTOGRAM);
+	for (bucket = 0; bucket < desc->num_buckets; bucket++) {
+		if (value <= desc->buckets[bucket]) {
+			break;
+		}
+	}
+
+	values = metrics_get_values(group, idx, &shared);
+	metrics_value_add(&values[bucket], 1, shared);
+	metrics_value_add(&values[desc->num_buckets + 1], value, shared);
+}
+
+static const struct spdk_metrics_provider g_metrics_provider = {
+	.group_register = metrics_group_register,
+	.group_unregister = metrics_group_unregister,
+	.counter_add = metrics_counter_add,
+	.gauge_add = metrics_gauge_add,
+	.histogram_observe = metrics_histogram_observe,
+};
+
+void
+spdk_metrics_enable(void)
+{
+	uint32_t last_core;
+
+	if (g_metrics.num_slots != 0) {
+		return;
+	}
+
+	last_core = spdk_env_get_last_core();
+	g_metrics.num_slots = (last_core == UINT32_MAX ? 0 : last_core + 1) + 1;
+	spdk_metrics_set_provider(&g_metrics_provider);
+}
+
+struct metrics_buf {
+	char	*buf;
+	size_t	len;
+	size_t	size;
+	int	rc;
+};
+
+static void __attribute__((format(printf, 2, 3)))
+metrics_printf(struct metrics_buf *b, const char *fmt, ...)
+{
+	va_list args;
+	size_t size;
+	char *buf;
+	int len;
+
+	while (b->rc == 0) {
+		va_start(args, fmt);
+		len = vsnprintf(b->buf + b->len, b->size - b->len, fmt, args);
+		va_end(args);
+
+		if (len < 0) {
+			b->rc = -EINVAL;
+			return;
+		}
+
+		if ((size_t)len < b->size - b->len) {
+			b->len += len;
+			return;
+		}
+
+		size = spdk_max(b->size * 2, b->len + len + 1);
+		buf = realloc(b->buf, size);
+		if (buf == NULL) {
+			b->rc = -ENOMEM;
+			return;
+		}
+
+		b->buf = buf;
+		b->size = size;
+	}
+}
+
+/* Escape a HELP text or a label value, the latter also escaping the double quotes */
+static void
+metrics_print_escaped(struct metrics_buf *b, const char *str, bool quotes)
+{
+	const char *c;
+
+	for (c = str; *c != '\0'; c++) {
+		if (*c == '\\') {
+			metrics_printf(b, "\\\\");
+		} else if (*c == '\n') {
+			metrics_printf(b, "\\n");
+		} else if (*c == '"' && quotes) {
+			metrics_printf(b, "\\\"");
+		} else {
+			metrics_printf(b, "%c", *c);
+		}
+	}
+}
+
+/* Print the name of a sample, followed by its labels and the opening of its value */
+static void
+metrics_print_sample(struct metrics_buf *b, const struct spdk_metrics_group *group,
+		     const char *name, const char *suffix, const char *le)
+{
+	const char *sep = "";
+
+	metrics_printf(b, "%s%s", name, suffix);
+	if (group->label_name == NULL && le == NULL) {
+		metrics_printf(b, " ");
+		return;
+	}
+
+	metrics_printf(b, "{");
+	if (group->label_name != NULL) {
+		metrics_printf(b, "%s=\"", group->label_name);
+		metrics_print_escaped(b, group->label_value, true);
+		metrics_printf(b, "\"");
+		sep = ",";
+	}
+
+	if (le != NULL) {
+		metrics_printf(b, "%sle=\"%s\"", sep, le);
+	}
+
+	metrics_printf(b, "} ");
+}
+
+static uint64_t
+metrics_sum(const struct spdk_metrics_group *group, uint32_t offset)
+{
+	uint64_t sum = 0;
+	uint32_t slot;
+
+	for (slot = 0; slot < g_metrics.num_slots; slot++) {
+		sum += __atomic_load_n(&group->values[slot * group->slot_size + offset],
+				       __ATOMIC_RELAXED);
+	}
+
+	return sum;
+}
+
+static void
+metrics_print_histogram(struct metrics_buf *b, const struct spdk_metrics_group *group,
+			const struct spdk_metric_desc *desc, uint32_t offset)
+{
+	uint64_t count = 0;
+	char le[32];
+	uint32_t i;
+
+	for (i = 0; i <= desc->num_buckets; i++) {
+		count += metrics_sum(group, offset + i);
+		if (i < desc->num_buckets) {
+			snprintf(le, sizeof(le), "%"PRIu64".0", desc->buckets[i]);
+		} else {
+			snprintf(le, sizeof(le), "+Inf");
+		}
+
+		metrics_print_sample(b, group, desc->name, "_bucket", le);
+		metrics_printf(b, "%"PRIu64"\n", count);
+	}
+
+	metrics_print_sample(b, group, desc->name, "_count", NULL);
+	metrics_printf(b, "%"PRIu64"\n", count);
+	metrics_print_sample(b, group, desc->name, "_sum", NULL);
+	metrics_printf(b, "%"PRIu64"\n", metrics_sum(group, offset + desc->num_buckets + 1));
+}
+
+static void
+metrics_print_family(struct metrics_buf *b, const struct metrics_family *family, uint32_t idx)
+{
+	const struct spdk_metric_desc *desc = &family->descs[idx];
+	const struct spdk_metrics_group *group;
+	uint32_t offset = family->offsets[idx];
+	static const char *types[] = {
+		[SPDK_METRIC_TYPE_COUNTER] = "counter",
+		[SPDK_METRIC_TYPE_GAUGE] = "gauge",
+		[SPDK_METRIC_TYPE_HISTOGRAM] = "histogram",
+	};
+
+	metrics_printf(b, "# TYPE %s %s\n", desc->name, types[desc->type]);
+	metrics_printf(b, "# HELP %s ", desc->name);
+	metrics_print_escaped(b, desc->help, false);
+	metrics_printf(b, "\n");
+
+	TAILQ_FOREACH(group, &family->groups, tailq) {
+		switch (desc->type) {
+		case SPDK_METRIC_TYPE_COUNTER:
+			metrics_print_sample(b, group, desc->name, "_total", NULL);
+			metrics_printf(b, "%"PRIu64"\n", metrics_sum(group, offset));
+			break;
+		case SPDK_METRIC_TYPE_GAUGE:
+			metrics_print_sample(b, group, desc->name, "", NULL);
+			metrics_printf(b, "%"PRId64"\n", (int64_t)metrics_sum(group, offset));
+			break;
+		case SPDK_METRIC_TYPE_HISTOGRAM:
+			metrics_print_histogram(b, group, desc, offset);
+			break;
+		}
+	}
+}
+
+int
+spdk_metrics_render(char **buf, size_t *len)
+{
+	struct metrics_buf b = {};
+	struct metrics_family *family;
+	uint32_t i;
+
+	b.buf = malloc(METRICS_BUF_INITIAL_SIZE);
+	if (b.buf == NULL) {
+		return -ENOMEM;
+	}
+
+	b.size = METRICS_BUF_INITIAL_SIZE;
+	b.buf[0] = '\0';
+
+	pthread_mutex_lock(&g_metrics.mutex);
+	TAILQ_FOREACH(family, &g_metrics.families, tailq) {
+		for (i = 0; i < family->num_descs; i++) {
+			metrics_print_family(&b, family, i);
+		}
+	}
+	pthread_mutex_unlock(&g_metrics.mutex);
+
+	metrics_printf(&b, "# EOF\n");
+	if (b.rc != 0) {
+		free(b.buf);
+		return b.rc;
+	}
+
+	*buf = b.buf;
+	*len = b.len;
+
+	return 0;
+}
@@ -11,6 +11,7 @@
 #include "spdk/nbd.h"
 #include "nbd_internal.h"
 #include "spdk/bdev.h"
+#include "spdk/cpuset.h"
 #include "spdk/endian.h"
 #include "spdk/env.h"
 #include "spdk/likely.h"
@@ -25,6 +26,9 @@
 #define NBD_STOP_BUSY_WAITING_MS	10000
 #define NBD_BUSY_POLLING_INTERVAL_US	20000
 #define NBD_IO_TIMEOUT_S		60
+#define NBD_MAX_CONNECTIONS		64
+#define NBD_RECV_BUF_SIZE		4096
+#define NBD_XMIT_MAX_IOVS		64
 
 enum nbd_io_state_t {
 	/* Receiving or ready to receive nbd request header */
@@ -38,7 +42,7 @@ enum nbd_io_state_t {
 };
 
 struct nbd_io {
-	struct spdk_nbd_disk	*nbd;
+	struct nbd_conn		*conn;
 	enum nbd_io_state_t	state;
 
 	void			*payload;
@@ -59,33 +63,79 @@ struct nbd_io {
 	TAILQ_ENTRY(nbd_io)	tailq;
 };
 
-struct spdk_nbd_disk {
-	struct spdk_bdev	*bdev;
-	struct spdk_bdev_desc	*bdev_desc;
+/*
+ * One socket of the nbd device. After it is started, a connection is only
+ * accessed from its own thread.
+ */
+struct nbd_conn {
+	struct spdk_nbd_disk	*nbd;
+	uint32_t		id;
+	struct spdk_thread	*thread;
+	/* The thread was created for this connection */
+	bool			own_thread;
 	struct spdk_io_channel	*ch;
-	int			dev_fd;
-	char			*nbd_path;
 	int			kernel_sp_fd;
 	int			spdk_sp_fd;
-	struct spdk_poller	*nbd_poller;
+	struct spdk_poller	*poller;
 	struct spdk_interrupt	*intr;
 	bool			interrupt_mode;
+
+	struct nbd_io		*io_in_recv;
+	TAILQ_HEAD(, nbd_io)	received_io_list;
+	TAILQ_HEAD(, nbd_io)	executed_io_list;
+	TAILQ_HEAD(, nbd_io)	processing_io_list;
+
+	/* No more requests are accepted */
+	bool			is_closing;
+	/* The disk was already asked to stop */
+	bool			close_requested;
+	/* The disk is stopping, tear down once all nbd_io are done */
+	bool			is_stopping;
+	/* The socket failed, no response can be transmitted anymore */
+	bool			sock_error;
+	/* count of nbd_io in nbd_conn */
+	int			io_count;
+
+	/* Requests are read from the socket in batches, these are the bytes not parsed yet */
+	uint32_t		recv_head;
+	uint32_t		recv_tail;
+	uint8_t			recv_buf[NBD_RECV_BUF_SIZE];
+};
+
+struct spdk_nbd_start_ctx {
+	struct spdk_nbd_disk	*nbd;
+	spdk_nbd_start_cb	cb_fn;
+	void			*cb_arg;
+	int			rc;
+};
+
+struct spdk_nbd_disk {
+	struct spdk_bdev	*bdev;
+	struct spdk_bdev_desc	*bdev_desc;
+	int			dev_fd;
+	char			*nbd_path;
+	/* The thread which started the disk, the disk is only accessed from it */
+	struct spdk_thread	*thread;
 	uint32_t		buf_align;
 
+	struct nbd_conn		*conns;
+	uint32_t		num_conns;
+	/* Connections which still have to report they are started */
+	uint32_t		num_starting_conns;
+	/* Connections which were started and are not stopped yet */
+	uint32_t		num_running_conns;
+	struct spdk_nbd_start_ctx *start_ctx;
+
 	struct spdk_poller	*retry_poller;
 	int			retry_count;
 	/* Synchronize nbd_start_kernel pthread and nbd_stop */
 	bool			has_nbd_pthread;
 
-	struct nbd_io		*io_in_recv;
-	TAILQ_HEAD(, nbd_io)	received_io_list;
-	TAILQ_HEAD(, nbd_io)	executed_io_list;
-	TAILQ_HEAD(, nbd_io)	processing_io_list;
-
 	bool			is_started;
 	bool			is_closing;
-	/* count of nbd_io in spdk_nbd_disk */
-	int			io_count;
+	/* The connections were asked to stop */
+	bool			is_stopping;
+	bool			is_removed;
 
 	TAILQ_ENTRY(spdk_nbd_disk)	tailq;
 };
@@ -100,8 +150,8 @@ static void *g_fini_cb_arg;
 
 static void _nbd_fini(void *arg1);
 
-static int nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io);
-static int nbd_io_recv_internal(struct spdk_nbd_disk *nbd);
+static int nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io);
+static int nbd_io_recv_internal(struct nbd_conn *conn);
 
 int
 spdk_nbd_init(void)
@@ -210,6 +260,12 @@ nbd_disk_get_bdev_name(struct spdk_nbd_disk *nbd)
 	return spdk_bdev_get_name(nbd->bdev);
 }
 
+uint32_t
+nbd_disk_get_num_connections(struct spdk_nbd_disk *nbd)
+{
+	return nbd->num_conns;
+}
+
 void
 spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 {
@@ -225,6 +281,7 @@ spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_object_begin(w, "params");
 		spdk_json_write_named_string(w, "nbd_device",  nbd_disk_get_nbd_path(nbd));
 		spdk_json_write_named_string(w, "bdev_name", nbd_disk_get_bdev_name(nbd));
+		spdk_json_write_named_uint32(w, "num_connections", nbd->num_conns);
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -245,7 +302,7 @@ nbd_disconnect(struct spdk_nbd_disk *nbd)
 }
 
 static struct nbd_io *
-nbd_get_io(struct spdk_nbd_disk *nbd)
+nbd_get_io(struct nbd_conn *conn)
 {
 	struct nbd_io *io;
 
@@ -254,23 +311,23 @@ nbd_get_io(struct spdk_nbd_disk *nbd)
 		return NULL;
 	}
 
-	io->nbd = nbd;
+	io->conn = conn;
 	to_be32(&io->resp.magic, NBD_REPLY_MAGIC);
 
-	nbd->io_count++;
+	conn->io_count++;
 
 	return io;
 }
 
 static void
-nbd_put_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+nbd_put_io(struct nbd_conn *conn, struct nbd_io *io)
 {
 	if (io->payload) {
 		spdk_free(io->payload);
 	}
 	free(io);
 
-	nbd->io_count--;
+	conn->io_count--;
 }
 
 /*
@@ -281,22 +338,38 @@ nbd_put_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
  *         0 all nbd_io gotten are freed.
  */
 static int
-nbd_cleanup_io(struct spdk_nbd_disk *nbd)
+nbd_cleanup_io(struct nbd_conn *conn)
 {
+	struct nbd_io *io, *io_tmp;
+
 	/* Try to read the remaining nbd commands in the socket */
-	while (nbd_io_recv_internal(nbd) > 0);
+	if (!conn->sock_error) {
+		while (nbd_io_recv_internal(conn) > 0);
+	}
 
 	/* free io_in_recv */
-	if (nbd->io_in_recv != NULL) {
-		nbd_put_io(nbd, nbd->io_in_recv);
-		nbd->io_in_recv = NULL;
+	if (conn->io_in_recv != NULL) {
+		nbd_put_io(conn, conn->io_in_recv);
+		conn->io_in_recv = NULL;
+	}
+
+	/* Nothing can be transmitted over a failed socket */
+	if (conn->sock_error) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			nbd_put_io(conn, io);
+		}
+		TAILQ_FOREACH_SAFE(io, &conn->executed_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+			nbd_put_io(conn, io);
+		}
 	}
 
 	/*
 	 * Some nbd_io may be under executing in bdev.
 	 * Wait for their done operation.
 	 */
-	if (nbd->io_count != 0) {
+	if (conn->io_count != 0) {
 		return 1;
 	}
 
@@ -307,23 +380,23 @@ static int
 _nbd_stop(void *arg)
 {
 	struct spdk_nbd_disk *nbd = arg;
+	struct nbd_conn *conn;
+	uint32_t i;
 
-	if (nbd->nbd_poller) {
-		spdk_poller_unregister(&nbd->nbd_poller);
-	}
+	assert(nbd->num_running_conns == 0);
 
-	if (nbd->intr) {
-		spdk_interrupt_unregister(&nbd->intr);
-	}
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
 
-	if (nbd->spdk_sp_fd >= 0) {
-		close(nbd->spdk_sp_fd);
-		nbd->spdk_sp_fd = -1;
-	}
+		if (conn->spdk_sp_fd >= 0) {
+			close(conn->spdk_sp_fd);
+			conn->spdk_sp_fd = -1;
+		}
 
-	if (nbd->kernel_sp_fd >= 0) {
-		close(nbd->kernel_sp_fd);
-		nbd->kernel_sp_fd = -1;
+		if (conn->kernel_sp_fd >= 0) {
+			close(conn->kernel_sp_fd);
+			conn->kernel_sp_fd = -1;
+		}
 	}
 
 	/* Continue the stop procedure after the exit of nbd_start_kernel pthread */
@@ -359,11 +432,6 @@ _nbd_stop(void *arg)
 		free(nbd->nbd_path);
 	}
 
-	if (nbd->ch) {
-		spdk_put_io_channel(nbd->ch);
-		nbd->ch = NULL;
-	}
-
 	if (nbd->bdev_desc) {
 		spdk_bdev_close(nbd->bdev_desc);
 		nbd->bdev_desc = NULL;
@@ -371,20 +439,102 @@ _nbd_stop(void *arg)
 
 	nbd_disk_unregister(nbd);
 
+	free(nbd->conns);
 	free(nbd);
 
 	return 0;
 }
 
+static void
+nbd_conn_stopped(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	assert(nbd->num_running_conns > 0);
+	if (--nbd->num_running_conns == 0) {
+		_nbd_stop(nbd);
+	}
+}
+
+/* Release the resources of the connection and report back to the disk thread */
+static void
+nbd_conn_teardown(struct nbd_conn *conn)
+{
+	struct spdk_thread *thread = conn->own_thread ? conn->thread : NULL;
+
+	spdk_poller_unregister(&conn->poller);
+	spdk_interrupt_unregister(&conn->intr);
+
+	/* Closing the socket makes the kernel drop this connection */
+	if (conn->spdk_sp_fd >= 0) {
+		close(conn->spdk_sp_fd);
+		conn->spdk_sp_fd = -1;
+	}
+
+	if (conn->ch) {
+		spdk_put_io_channel(conn->ch);
+		conn->ch = NULL;
+	}
+
+	/* The disk may be freed right after this message, conn can't be touched anymore */
+	spdk_thread_send_msg(conn->nbd->thread, nbd_conn_stopped, conn);
+
+	if (thread != NULL) {
+		spdk_thread_exit(thread);
+	}
+}
+
+/*
+ * Stop action should be called only after all nbd_io are executed.
+ * Returns true if the connection was torn down.
+ */
+static bool
+nbd_conn_try_stop(struct nbd_conn *conn)
+{
+	if (nbd_cleanup_io(conn) != 0) {
+		return false;
+	}
+
+	nbd_conn_teardown(conn);
+	return true;
+}
+
+static void nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg);
+
+static void
+nbd_conn_stop(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct nbd_io *io, *io_tmp;
+
+	conn->is_closing = true;
+	conn->is_stopping = true;
+
+	/* The bdev is gone, fail the nbd_io which were not submitted yet */
+	if (conn->nbd->is_removed) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+			nbd_io_done(NULL, false, io);
+		}
+	}
+
+	/* Otherwise the poller retries once the outstanding nbd_io are done */
+	nbd_conn_try_stop(conn);
+}
+
 int
 spdk_nbd_stop(struct spdk_nbd_disk *nbd)
 {
-	int rc = 0;
+	uint32_t i;
 
 	if (nbd == NULL) {
-		return rc;
+		return 0;
 	}
 
+	assert(nbd->thread == spdk_get_thread());
+
 	nbd->is_closing = true;
 
 	/* if nbd is not started, it will continue to call nbd stop later */
@@ -392,16 +542,42 @@ spdk_nbd_stop(struct spdk_nbd_disk *nbd)
 		return 1;
 	}
 
-	/*
-	 * Stop action should be called only after all nbd_io are executed.
-	 */
+	if (nbd->is_stopping) {
+		return 1;
+	}
+	nbd->is_stopping = true;
 
-	rc = nbd_cleanup_io(nbd);
-	if (!rc) {
+	if (nbd->num_running_conns == 0) {
 		_nbd_stop(nbd);
+		return 0;
 	}
 
-	return rc;
+	/* Each connection is stopped on its own thread, the last one frees the disk */
+	for (i = 0; i < nbd->num_conns; i++) {
+		if (nbd->conns[i].thread != NULL) {
+			spdk_thread_send_msg(nbd->conns[i].thread, nbd_conn_stop, &nbd->conns[i]);
+		}
+	}
+
+	return 1;
+}
+
+static void
+nbd_disk_close(void *arg)
+{
+	spdk_nbd_stop(arg);
+}
+
+/* Stop accepting requests and ask the disk to stop all of its connections */
+static void
+nbd_conn_close(struct nbd_conn *conn)
+{
+	conn->is_closing = true;
+
+	if (!conn->close_requested) {
+		conn->close_requested = true;
+		spdk_thread_send_msg(conn->nbd->thread, nbd_disk_close, conn->nbd);
+	}
 }
 
 static int64_t
@@ -427,11 +603,43 @@ nbd_socket_rw(int fd, void *buf, size_t length, bool read_op)
 	}
 }
 
+/*
+ * Read from the socket through the receive buffer, so that a single read() picks
+ * up all the request headers the kernel has queued. Large payloads bypass it.
+ */
+static int64_t
+nbd_conn_recv(struct nbd_conn *conn, void *buf, size_t length)
+{
+	uint32_t avail = conn->recv_tail - conn->recv_head;
+	int64_t rc;
+
+	if (avail == 0) {
+		if (length >= sizeof(conn->recv_buf)) {
+			return nbd_socket_rw(conn->spdk_sp_fd, buf, length, true);
+		}
+
+		rc = nbd_socket_rw(conn->spdk_sp_fd, conn->recv_buf, sizeof(conn->recv_buf), true);
+		if (rc <= 0) {
+			return rc;
+		}
+
+		conn->recv_head = 0;
+		conn->recv_tail = rc;
+		avail = rc;
+	}
+
+	length = spdk_min(length, avail);
+	memcpy(buf, conn->recv_buf + conn->recv_head, length);
+	conn->recv_head += length;
+
+	return length;
+}
+
 static void
 nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
 	struct nbd_io	*io = cb_arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = io->conn;
 
 	if (success) {
 		io->resp.error = 0;
@@ -444,12 +652,12 @@ nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 	/* When there begins to have executed_io, enable socket writable notice in order to
 	 * get it processed in nbd_io_xmit
 	 */
-	if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+	if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
 	}
 
-	TAILQ_REMOVE(&nbd->processing_io_list, io, tailq);
-	TAILQ_INSERT_TAIL(&nbd->executed_io_list, io, tailq);
+	TAILQ_REMOVE(&conn->processing_io_list, io, tailq);
+	TAILQ_INSERT_TAIL(&conn->executed_io_list, io, tailq);
 
 	if (bdev_io != NULL) {
 		spdk_bdev_free_io(bdev_io);
@@ -460,13 +668,13 @@ static void
 nbd_resubmit_io(void *arg)
 {
 	struct nbd_io *io = (struct nbd_io *)arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = io->conn;
 	int rc = 0;
 
-	rc = nbd_submit_bdev_io(nbd, io);
+	rc = nbd_submit_bdev_io(conn, io);
 	if (rc) {
 		SPDK_INFOLOG(nbd, "nbd: io resubmit for dev %s , io_type %d, returned %d.\n",
-			     nbd_disk_get_bdev_name(nbd), from_be32(&io->req.type), rc);
+			     nbd_disk_get_bdev_name(conn->nbd), from_be32(&io->req.type), rc);
 	}
 }
 
@@ -474,13 +682,13 @@ static void
 nbd_queue_io(struct nbd_io *io)
 {
 	int rc;
-	struct spdk_bdev *bdev = io->nbd->bdev;
+	struct spdk_bdev *bdev = io->conn->nbd->bdev;
 
 	io->bdev_io_wait.bdev = bdev;
 	io->bdev_io_wait.cb_fn = nbd_resubmit_io;
 	io->bdev_io_wait.cb_arg = io;
 
-	rc = spdk_bdev_queue_io_wait(bdev, io->nbd->ch, &io->bdev_io_wait);
+	rc = spdk_bdev_queue_io_wait(bdev, io->conn->ch, &io->bdev_io_wait);
 	if (rc != 0) {
 		SPDK_ERRLOG("Queue io failed in nbd_queue_io, rc=%d.\n", rc);
 		nbd_io_done(NULL, false, io);
@@ -488,10 +696,11 @@ nbd_queue_io(struct nbd_io *io)
 }
 
 static int
-nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct spdk_bdev_desc *desc = nbd->bdev_desc;
-	struct spdk_io_channel *ch = nbd->ch;
+	struct spdk_io_channel *ch = conn->ch;
 	int rc = 0;
 
 	switch (from_be32(&io->req.type)) {
@@ -534,17 +743,17 @@ nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 }
 
 static int
-nbd_io_exec(struct spdk_nbd_disk *nbd)
+nbd_io_exec(struct nbd_conn *conn)
 {
 	struct nbd_io *io, *io_tmp;
 	int io_count = 0;
 	int ret = 0;
 
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-			ret = nbd_submit_bdev_io(nbd, io);
+	if (!TAILQ_EMPTY(&conn->received_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+			ret = nbd_submit_bdev_io(conn, io);
 			if (ret < 0) {
 				return ret;
 			}
@@ -556,28 +765,42 @@ nbd_io_exec(struct spdk_nbd_disk *nbd)
 	return io_count;
 }
 
+static void
+nbd_io_received(struct nbd_conn *conn, struct nbd_io *io)
+{
+	io->state = NBD_IO_XMIT_RESP;
+	if (spdk_likely(!conn->is_closing)) {
+		TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
+	} else {
+		TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+		nbd_io_done(NULL, false, io);
+	}
+	conn->io_in_recv = NULL;
+}
+
 static int
-nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
+nbd_io_recv_internal(struct nbd_conn *conn)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct nbd_io *io;
 	int ret = 0;
 	int received = 0;
 
-	if (nbd->io_in_recv == NULL) {
-		nbd->io_in_recv = nbd_get_io(nbd);
-		if (!nbd->io_in_recv) {
+	if (conn->io_in_recv == NULL) {
+		conn->io_in_recv = nbd_get_io(conn);
+		if (!conn->io_in_recv) {
 			return -ENOMEM;
 		}
 	}
 
-	io = nbd->io_in_recv;
+	io = conn->io_in_recv;
 
 	if (io->state == NBD_IO_RECV_REQ) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->req + io->offset,
-				    sizeof(io->req) - io->offset, true);
+		ret = nbd_conn_recv(conn, (char *)&io->req + io->offset,
+				    sizeof(io->req) - io->offset);
 		if (ret < 0) {
-			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			nbd_put_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -591,18 +814,18 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 			/* req magic check */
 			if (from_be32(&io->req.magic) != NBD_REQUEST_MAGIC) {
 				SPDK_ERRLOG("invalid request magic\n");
-				nbd_put_io(nbd, io);
-				nbd->io_in_recv = NULL;
+				nbd_put_io(conn, io);
+				conn->io_in_recv = NULL;
 				return -EINVAL;
 			}
 
 			if (from_be32(&io->req.type) == NBD_CMD_DISC) {
-				nbd->is_closing = true;
-				nbd->io_in_recv = NULL;
-				if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-					spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+				nbd_conn_close(conn);
+				conn->io_in_recv = NULL;
+				if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+					spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
 				}
-				nbd_put_io(nbd, io);
+				nbd_put_io(conn, io);
 				/* After receiving NBD_CMD_DISC, nbd will not receive any new commands */
 				return received;
 			}
@@ -621,8 +844,8 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 							  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 				if (io->payload == NULL) {
 					SPDK_ERRLOG("could not allocate io->payload of size %d\n", io->payload_size);
-					nbd_put_io(nbd, io);
-					nbd->io_in_recv = NULL;
+					nbd_put_io(conn, io);
+					conn->io_in_recv = NULL;
 					return -ENOMEM;
 				}
 			} else {
@@ -633,23 +856,16 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 			if (from_be32(&io->req.type) == NBD_CMD_WRITE) {
 				io->state = NBD_IO_RECV_PAYLOAD;
 			} else {
-				io->state = NBD_IO_XMIT_RESP;
-				if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-					TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
-				} else {
-					TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-					nbd_io_done(NULL, false, io);
-				}
-				nbd->io_in_recv = NULL;
+				nbd_io_received(conn, io);
 			}
 		}
 	}
 
 	if (io->state == NBD_IO_RECV_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset, true);
+		ret = nbd_conn_recv(conn, io->payload + io->offset, io->payload_size - io->offset);
 		if (ret < 0) {
-			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			nbd_put_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -659,14 +875,7 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 		/* request payload is fully received */
 		if (io->offset == io->payload_size) {
 			io->offset = 0;
-			io->state = NBD_IO_XMIT_RESP;
-			if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-				TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
-			} else {
-				TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-				nbd_io_done(NULL, false, io);
-			}
-			nbd->io_in_recv = NULL;
+			nbd_io_received(conn, io);
 		}
 
 	}
@@ -675,24 +884,28 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 }
 
 static int
-nbd_io_recv(struct spdk_nbd_disk *nbd)
+nbd_io_recv(struct nbd_conn *conn)
 {
 	int i, rc, ret = 0;
 
 	/*
 	 * nbd server should not accept request after closing command
 	 */
-	if (nbd->is_closing) {
+	if (conn->is_closing) {
 		return 0;
 	}
 
-	for (i = 0; i < GET_IO_LOOP_COUNT; i++) {
-		rc = nbd_io_recv_internal(nbd);
+	/*
+	 * Requests already in the receive buffer are always parsed, the socket
+	 * won't signal them again in interrupt mode.
+	 */
+	for (i = 0; i < GET_IO_LOOP_COUNT || conn->recv_head != conn->recv_tail; i++) {
+		rc = nbd_io_recv_internal(conn);
 		if (rc < 0) {
 			return rc;
 		}
 		ret += rc;
-		if (nbd->is_closing) {
+		if (rc == 0 || conn->is_closing) {
 			break;
 		}
 	}
@@ -700,117 +913,154 @@ nbd_io_recv(struct spdk_nbd_disk *nbd)
 	return ret;
 }
 
-static int
-nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
+static bool
+nbd_io_has_read_payload(struct nbd_io *io)
 {
-	struct nbd_io *io;
-	int ret = 0;
-	int sent = 0;
-
-	io = TAILQ_FIRST(&nbd->executed_io_list);
-	if (io == NULL) {
-		return 0;
-	}
+	/* transmit payload only when NBD_CMD_READ with no resp error */
+	return from_be32(&io->req.type) == NBD_CMD_READ && io->resp.error == 0;
+}
 
-	/* Remove IO from list now assuming it will be completed.  It will be inserted
-	 *  back to the head if it cannot be completed.  This approach is specifically
-	 *  taken to work around a scan-build use-after-free mischaracterization.
-	 */
-	TAILQ_REMOVE(&nbd->executed_io_list, io, tailq);
+/* Describe what is left to transmit of the nbd_io, returns the number of iovs used */
+static int
+nbd_io_xmit_iovs(struct nbd_io *io, struct iovec *iovs)
+{
+	int iovcnt = 0;
 
 	/* resp error and handler are already set in io_done */
 
 	if (io->state == NBD_IO_XMIT_RESP) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->resp + io->offset,
-				    sizeof(io->resp) - io->offset, false);
-		if (ret <= 0) {
-			goto reinsert;
+		iovs[iovcnt].iov_base = (char *)&io->resp + io->offset;
+		iovs[iovcnt].iov_len = sizeof(io->resp) - io->offset;
+		iovcnt++;
+
+		if (nbd_io_has_read_payload(io)) {
+			iovs[iovcnt].iov_base = io->payload;
+			iovs[iovcnt].iov_len = io->payload_size;
+			iovcnt++;
 		}
+	} else {
+		assert(io->state == NBD_IO_XMIT_PAYLOAD);
+		iovs[iovcnt].iov_base = io->payload + io->offset;
+		iovs[iovcnt].iov_len = io->payload_size - io->offset;
+		iovcnt++;
+	}
 
-		io->offset += ret;
-		sent = ret;
+	return iovcnt;
+}
 
-		/* response is fully transmitted */
-		if (io->offset == sizeof(io->resp)) {
-			io->offset = 0;
+/*
+ * Account the transmitted bytes to the nbd_io, decreasing *sent by the amount it consumed.
+ * Returns true if the nbd_io is fully transmitted.
+ */
+static bool
+nbd_io_xmit_update(struct nbd_io *io, size_t *sent)
+{
+	size_t len;
 
-			/* transmit payload only when NBD_CMD_READ with no resp error */
-			if (from_be32(&io->req.type) != NBD_CMD_READ || io->resp.error != 0) {
-				nbd_put_io(nbd, io);
-				return 0;
-			} else {
-				io->state = NBD_IO_XMIT_PAYLOAD;
-			}
-		}
-	}
+	if (io->state == NBD_IO_XMIT_RESP) {
+		len = spdk_min(*sent, sizeof(io->resp) - io->offset);
+		io->offset += len;
+		*sent -= len;
 
-	if (io->state == NBD_IO_XMIT_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset,
-				    false);
-		if (ret <= 0) {
-			goto reinsert;
+		/* response is not fully transmitted */
+		if (io->offset < sizeof(io->resp)) {
+			return false;
 		}
 
-		io->offset += ret;
-		sent += ret;
-
-		/* read payload is fully transmitted */
-		if (io->offset == io->payload_size) {
-			nbd_put_io(nbd, io);
-			return sent;
+		io->offset = 0;
+		if (!nbd_io_has_read_payload(io)) {
+			return true;
 		}
+
+		io->state = NBD_IO_XMIT_PAYLOAD;
 	}
 
-reinsert:
-	TAILQ_INSERT_HEAD(&nbd->executed_io_list, io, tailq);
-	return ret < 0 ? ret : sent;
+	len = spdk_min(*sent, io->payload_size - io->offset);
+	io->offset += len;
+	*sent -= len;
+
+	/* read payload is fully transmitted */
+	return io->offset == io->payload_size;
 }
 
+/* Transmit the responses of the executed nbd_io, as many of them as possible per writev() */
 static int
-nbd_io_xmit(struct spdk_nbd_disk *nbd)
+nbd_io_xmit(struct nbd_conn *conn)
 {
-	int ret = 0;
-	int rc;
+	struct iovec iovs[NBD_XMIT_MAX_IOVS];
+	struct nbd_io *io;
+	int i, num_ios, iovcnt, ret = 0;
+	ssize_t rc;
+	size_t sent;
+
+	while (!TAILQ_EMPTY(&conn->executed_io_list)) {
+		iovcnt = 0;
+		num_ios = 0;
+		TAILQ_FOREACH(io, &conn->executed_io_list, tailq) {
+			/* Each nbd_io needs at most 2 iovs */
+			if (iovcnt + 2 > NBD_XMIT_MAX_IOVS) {
+				break;
+			}
+			iovcnt += nbd_io_xmit_iovs(io, &iovs[iovcnt]);
+			num_ios++;
+		}
 
-	while (!TAILQ_EMPTY(&nbd->executed_io_list)) {
-		rc = nbd_io_xmit_internal(nbd);
+		rc = writev(conn->spdk_sp_fd, iovs, iovcnt);
 		if (rc < 0) {
-			return rc;
+			if (errno == EAGAIN) {
+				break;
+			}
+			return -errno;
 		}
 
 		ret += rc;
+		sent = rc;
+		for (i = 0; i < num_ios; i++) {
+			io = TAILQ_FIRST(&conn->executed_io_list);
+			if (!nbd_io_xmit_update(io, &sent)) {
+				break;
+			}
+
+			TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+			nbd_put_io(conn, io);
+		}
+
+		/* The socket is full, wait for it to be writable again */
+		if (i < num_ios) {
+			break;
+		}
 	}
 
 	/* When there begins to have no executed_io, disable socket writable notice */
-	if (nbd->interrupt_mode) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN);
+	if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN);
 	}
 
 	return ret;
 }
 
 /**
- * Poll an NBD instance.
+ * Poll an NBD connection.
  *
  * \return 0 on success or negated errno values on error (e.g. connection closed).
  */
 static int
-_nbd_poll(struct spdk_nbd_disk *nbd)
+_nbd_poll(struct nbd_conn *conn)
 {
 	int received, sent, executed;
 
 	/* transmit executed io first */
-	sent = nbd_io_xmit(nbd);
+	sent = nbd_io_xmit(conn);
 	if (sent < 0) {
 		return sent;
 	}
 
-	received = nbd_io_recv(nbd);
+	received = nbd_io_recv(conn);
 	if (received < 0) {
 		return received;
 	}
 
-	executed = nbd_io_exec(nbd);
+	executed = nbd_io_exec(conn);
 	if (executed < 0) {
 		return executed;
 	}
@@ -821,18 +1071,22 @@ _nbd_poll(struct spdk_nbd_disk *nbd)
 static int
 nbd_poll(void *arg)
 {
-	struct spdk_nbd_disk *nbd = arg;
-	int rc;
+	struct nbd_conn *conn = arg;
+	int rc = 0;
 
-	rc = _nbd_poll(nbd);
-	if (rc < 0) {
-		SPDK_INFOLOG(nbd, "nbd_poll() returned %s (%d); closing connection\n",
-			     spdk_strerror(-rc), rc);
-		_nbd_stop(nbd);
-		return SPDK_POLLER_IDLE;
+	if (spdk_likely(!conn->sock_error)) {
+		rc = _nbd_poll(conn);
+		if (rc < 0) {
+			SPDK_INFOLOG(nbd, "nbd_poll() returned %s (%d); closing connection\n",
+				     spdk_strerror(-rc), rc);
+			conn->sock_error = true;
+			nbd_conn_close(conn);
+			rc = 0;
+		}
 	}
-	if (nbd->is_closing) {
-		spdk_nbd_stop(nbd);
+
+	if (conn->is_stopping && nbd_conn_try_stop(conn)) {
+		return SPDK_POLLER_BUSY;
 	}
 
 	return rc == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
@@ -845,7 +1099,7 @@ nbd_start_kernel(void *arg)
 
 	spdk_unaffinitize_thread();
 
-	/* This will block in the kernel until we close the spdk_sp_fd. */
+	/* This will block in the kernel until we close all the spdk_sp_fd. */
 	ioctl(nbd->dev_fd, NBD_DO_IT);
 
 	nbd->has_nbd_pthread = false;
@@ -856,22 +1110,8 @@ nbd_start_kernel(void *arg)
 static void
 nbd_bdev_hot_remove(struct spdk_nbd_disk *nbd)
 {
-	struct nbd_io *io, *io_tmp;
-
-	nbd->is_closing = true;
-	nbd_cleanup_io(nbd);
-
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-		}
-	}
-	if (!TAILQ_EMPTY(&nbd->processing_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->processing_io_list, tailq, io_tmp) {
-			nbd_io_done(NULL, false, io);
-		}
-	}
+	nbd->is_removed = true;
+	spdk_nbd_stop(nbd);
 }
 
 static void
@@ -888,35 +1128,122 @@ nbd_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
 	}
 }
 
-struct spdk_nbd_start_ctx {
-	struct spdk_nbd_disk	*nbd;
-	spdk_nbd_start_cb	cb_fn;
-	void			*cb_arg;
-};
-
 static void
 nbd_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bool interrupt_mode)
 {
-	struct spdk_nbd_disk *nbd = cb_arg;
+	struct nbd_conn *conn = cb_arg;
+
+	conn->interrupt_mode = interrupt_mode;
+}
+
+static void
+nbd_start_done(struct spdk_nbd_disk *nbd)
+{
+	struct spdk_nbd_start_ctx *ctx = nbd->start_ctx;
+
+	nbd->start_ctx = NULL;
+
+	/* nbd will possibly receive stop command while initing */
+	nbd->is_started = true;
+
+	if (ctx->rc != 0) {
+		if (ctx->cb_fn) {
+			ctx->cb_fn(ctx->cb_arg, NULL, ctx->rc);
+		}
+		spdk_nbd_stop(nbd);
+	} else {
+		if (ctx->cb_fn) {
+			ctx->cb_fn(ctx->cb_arg, nbd, 0);
+		}
+		if (nbd->is_closing) {
+			spdk_nbd_stop(nbd);
+		}
+	}
+
+	free(ctx);
+}
+
+static void
+nbd_conn_started(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	if (conn->ch == NULL) {
+		nbd->start_ctx->rc = -ENOMEM;
+	}
 
-	nbd->interrupt_mode = interrupt_mode;
+	assert(nbd->num_starting_conns > 0);
+	if (--nbd->num_starting_conns == 0) {
+		nbd_start_done(nbd);
+	}
+}
+
+static void
+nbd_conn_start(void *arg)
+{
+	struct nbd_conn *conn = arg;
+
+	conn->ch = spdk_bdev_get_io_channel(conn->nbd->bdev_desc);
+	if (conn->ch == NULL) {
+		SPDK_ERRLOG("could not get io channel for connection %u of %s\n", conn->id,
+			    conn->nbd->nbd_path);
+	} else {
+		if (spdk_interrupt_mode_is_enabled()) {
+			conn->intr = SPDK_INTERRUPT_REGISTER(conn->spdk_sp_fd, nbd_poll, conn);
+		}
+
+		conn->poller = SPDK_POLLER_REGISTER(nbd_poll, conn, 0);
+		spdk_poller_register_interrupt(conn->poller, nbd_poller_set_interrupt_mode, conn);
+	}
+
+	spdk_thread_send_msg(conn->nbd->thread, nbd_conn_started, conn);
+}
+
+/* Each of multiple connections gets its own thread, spread over the cores */
+static struct spdk_thread *
+nbd_conn_create_thread(struct nbd_conn *conn)
+{
+	struct spdk_cpuset cpumask;
+	const char *name;
+	char thread_name[32];
+	uint32_t core, i = 0, idx;
+
+	idx = conn->id % spdk_env_get_core_count();
+	SPDK_ENV_FOREACH_CORE(core) {
+		if (i++ == idx) {
+			break;
+		}
+	}
+
+	spdk_cpuset_zero(&cpumask);
+	spdk_cpuset_set_cpu(&cpumask, core, true);
+
+	name = strrchr(conn->nbd->nbd_path, '/');
+	name = name != NULL ? name + 1 : conn->nbd->nbd_path;
+	snprintf(thread_name, sizeof(thread_name), "%s_conn%u", name, conn->id);
+
+	return spdk_thread_create(thread_name, &cpumask);
 }
 
 static void
 nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 {
+	struct spdk_nbd_disk *nbd = ctx->nbd;
+	struct nbd_conn *conn;
 	int		rc;
 	pthread_t	tid;
 	unsigned long	nbd_flags = 0;
+	uint32_t	i;
 
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_BLKSIZE, spdk_bdev_get_block_size(ctx->nbd->bdev));
+	rc = ioctl(nbd->dev_fd, NBD_SET_BLKSIZE, spdk_bdev_get_block_size(nbd->bdev));
 	if (rc == -1) {
 		SPDK_ERRLOG("ioctl(NBD_SET_BLKSIZE) failed: %s\n", spdk_strerror(errno));
 		rc = -errno;
 		goto err;
 	}
 
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SIZE_BLOCKS, spdk_bdev_get_num_blocks(ctx->nbd->bdev));
+	rc = ioctl(nbd->dev_fd, NBD_SET_SIZE_BLOCKS, spdk_bdev_get_num_blocks(nbd->bdev));
 	if (rc == -1) {
 		SPDK_ERRLOG("ioctl(NBD_SET_SIZE_BLOCKS) failed: %s\n", spdk_strerror(errno));
 		rc = -errno;
@@ -924,7 +1251,7 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 	}
 
 #ifdef NBD_SET_TIMEOUT
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_TIMEOUT, NBD_IO_TIMEOUT_S);
+	rc = ioctl(nbd->dev_fd, NBD_SET_TIMEOUT, NBD_IO_TIMEOUT_S);
 	if (rc == -1) {
 		SPDK_ERRLOG("ioctl(NBD_SET_TIMEOUT) failed: %s\n", spdk_strerror(errno));
 		rc = -errno;
@@ -935,18 +1262,27 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 #endif
 
 #ifdef NBD_FLAG_SEND_FLUSH
-	if (spdk_bdev_io_type_supported(ctx->nbd->bdev, SPDK_BDEV_IO_TYPE_FLUSH)) {
+	if (spdk_bdev_io_type_supported(nbd->bdev, SPDK_BDEV_IO_TYPE_FLUSH)) {
 		nbd_flags |= NBD_FLAG_SEND_FLUSH;
 	}
 #endif
 #ifdef NBD_FLAG_SEND_TRIM
-	if (spdk_bdev_io_type_supported(ctx->nbd->bdev, SPDK_BDEV_IO_TYPE_UNMAP)) {
+	if (spdk_bdev_io_type_supported(nbd->bdev, SPDK_BDEV_IO_TYPE_UNMAP)) {
 		nbd_flags |= NBD_FLAG_SEND_TRIM;
 	}
 #endif
+#ifdef NBD_FLAG_CAN_MULTI_CONN
+	/*
+	 * All the connections submit to the same bdev and a flush covers the whole bdev,
+	 * so it also covers the writes completed on the other connections.
+	 */
+	if (nbd->num_conns > 1) {
+		nbd_flags |= NBD_FLAG_CAN_MULTI_CONN;
+	}
+#endif
 
 	if (nbd_flags) {
-		rc = ioctl(ctx->nbd->dev_fd, NBD_SET_FLAGS, nbd_flags);
+		rc = ioctl(nbd->dev_fd, NBD_SET_FLAGS, nbd_flags);
 		if (rc == -1) {
 			SPDK_ERRLOG("ioctl(NBD_SET_FLAGS, 0x%lx) failed: %s\n", nbd_flags, spdk_strerror(errno));
 			rc = -errno;
@@ -954,10 +1290,10 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 		}
 	}
 
-	ctx->nbd->has_nbd_pthread = true;
-	rc = pthread_create(&tid, NULL, nbd_start_kernel, ctx->nbd);
+	nbd->has_nbd_pthread = true;
+	rc = pthread_create(&tid, NULL, nbd_start_kernel, nbd);
 	if (rc != 0) {
-		ctx->nbd->has_nbd_pthread = false;
+		nbd->has_nbd_pthread = false;
 		SPDK_ERRLOG("could not create thread: %s\n", spdk_strerror(rc));
 		rc = -rc;
 		goto err;
@@ -970,25 +1306,38 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 		goto err;
 	}
 
-	if (spdk_interrupt_mode_is_enabled()) {
-		ctx->nbd->intr = SPDK_INTERRUPT_REGISTER(ctx->nbd->spdk_sp_fd, nbd_poll, ctx->nbd);
-	}
+	nbd->start_ctx = ctx;
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
 
-	ctx->nbd->nbd_poller = SPDK_POLLER_REGISTER(nbd_poll, ctx->nbd, 0);
-	spdk_poller_register_interrupt(ctx->nbd->nbd_poller, nbd_poller_set_interrupt_mode, ctx->nbd);
+		if (nbd->num_conns == 1) {
+			conn->thread = nbd->thread;
+		} else {
+			conn->thread = nbd_conn_create_thread(conn);
+			if (conn->thread == NULL) {
+				SPDK_ERRLOG("could not create thread for connection %u of %s\n", i,
+					    nbd->nbd_path);
+				ctx->rc = -ENOMEM;
+				break;
+			}
+			conn->own_thread = true;
+		}
 
-	if (ctx->cb_fn) {
-		ctx->cb_fn(ctx->cb_arg, ctx->nbd, 0);
+		nbd->num_starting_conns++;
+		nbd->num_running_conns++;
+		spdk_thread_send_msg(conn->thread, nbd_conn_start, conn);
 	}
 
-	/* nbd will possibly receive stop command while initing */
-	ctx->nbd->is_started = true;
+	if (nbd->num_starting_conns == 0) {
+		nbd->start_ctx = NULL;
+		rc = ctx->rc;
+		goto err;
+	}
 
-	free(ctx);
 	return;
 
 err:
-	_nbd_stop(ctx->nbd);
+	_nbd_stop(nbd);
 	if (ctx->cb_fn) {
 		ctx->cb_fn(ctx->cb_arg, NULL, rc);
 	}
@@ -999,61 +1348,108 @@ static int
 nbd_enable_kernel(void *arg)
 {
 	struct spdk_nbd_start_ctx *ctx = arg;
+	struct spdk_nbd_disk *nbd = ctx->nbd;
+	uint32_t i;
 	int rc;
 
 	/* Declare device setup by this process */
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SOCK, ctx->nbd->kernel_sp_fd);
+	rc = ioctl(nbd->dev_fd, NBD_SET_SOCK, nbd->conns[0].kernel_sp_fd);
 
 	if (rc) {
 		if (errno == EBUSY) {
-			if (ctx->nbd->retry_poller == NULL) {
-				ctx->nbd->retry_count = NBD_START_BUSY_WAITING_MS * 1000ULL / NBD_BUSY_POLLING_INTERVAL_US;
-				ctx->nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
-							 NBD_BUSY_POLLING_INTERVAL_US);
+			if (nbd->retry_poller == NULL) {
+				nbd->retry_count = NBD_START_BUSY_WAITING_MS * 1000ULL / NBD_BUSY_POLLING_INTERVAL_US;
+				nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
+						    NBD_BUSY_POLLING_INTERVAL_US);
 				return SPDK_POLLER_BUSY;
-			} else if (ctx->nbd->retry_count-- > 0) {
+			} else if (nbd->retry_count-- > 0) {
 				/* Repeatedly unregister and register retry poller to avoid scan-build error */
-				spdk_poller_unregister(&ctx->nbd->retry_poller);
-				ctx->nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
-							 NBD_BUSY_POLLING_INTERVAL_US);
+				spdk_poller_unregister(&nbd->retry_poller);
+				nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
+						    NBD_BUSY_POLLING_INTERVAL_US);
 				return SPDK_POLLER_BUSY;
 			}
 		}
 
 		SPDK_ERRLOG("ioctl(NBD_SET_SOCK) failed: %s\n", spdk_strerror(errno));
-		if (ctx->nbd->retry_poller) {
-			spdk_poller_unregister(&ctx->nbd->retry_poller);
-		}
+		goto err;
+	}
 
-		_nbd_stop(ctx->nbd);
+	if (nbd->retry_poller) {
+		spdk_poller_unregister(&nbd->retry_poller);
+	}
 
-		if (ctx->cb_fn) {
-			ctx->cb_fn(ctx->cb_arg, NULL, -errno);
+	/* The device is ours now, the other connections are added right away */
+	for (i = 1; i < nbd->num_conns; i++) {
+		rc = ioctl(nbd->dev_fd, NBD_SET_SOCK, nbd->conns[i].kernel_sp_fd);
+		if (rc) {
+			SPDK_ERRLOG("ioctl(NBD_SET_SOCK) failed for connection %u: %s\n", i,
+				    spdk_strerror(errno));
+			goto err;
 		}
-
-		free(ctx);
-		return SPDK_POLLER_BUSY;
 	}
 
-	if (ctx->nbd->retry_poller) {
-		spdk_poller_unregister(&ctx->nbd->retry_poller);
+	nbd_start_complete(ctx);
+
+	return SPDK_POLLER_BUSY;
+
+err:
+	rc = -errno;
+	if (nbd->retry_poller) {
+		spdk_poller_unregister(&nbd->retry_poller);
 	}
 
-	nbd_start_complete(ctx);
+	_nbd_stop(nbd);
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->cb_arg, NULL, rc);
+	}
 
+	free(ctx);
 	return SPDK_POLLER_BUSY;
 }
 
 void
 spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	       spdk_nbd_start_cb cb_fn, void *cb_arg)
+{
+	spdk_nbd_start_ext(bdev_name, nbd_path, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path,
+		   const struct spdk_nbd_start_opts *opts,
+		   spdk_nbd_start_cb cb_fn, void *cb_arg)
 {
 	struct spdk_nbd_start_ctx	*ctx = NULL;
 	struct spdk_nbd_disk		*nbd = NULL;
 	struct spdk_bdev		*bdev;
+	struct nbd_conn			*conn;
+	uint32_t			num_conns = 1, i;
 	int				rc;
 	int				sp[2];
 
+	if (opts != NULL) {
+		if (opts->opts_size >= offsetof(struct spdk_nbd_start_opts, num_connections) +
+		    sizeof(opts->num_connections) && opts->num_connections != 0) {
+			num_conns = opts->num_connections;
+		}
+	}
+
+	if (num_conns > NBD_MAX_CONNECTIONS) {
+		SPDK_ERRLOG("at most %u connections are supported\n", NBD_MAX_CONNECTIONS);
+		rc = -EINVAL;
+		goto err;
+	}
+
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+	if (num_conns > 1) {
+		SPDK_ERRLOG("multiple connections are not supported by the nbd headers\n");
+		rc = -ENOTSUP;
+		goto err;
+	}
+#endif
+
 	nbd = calloc(1, sizeof(*nbd));
 	if (nbd == NULL) {
 		rc = -ENOMEM;
@@ -1061,8 +1457,25 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	}
 
 	nbd->dev_fd = -1;
-	nbd->spdk_sp_fd = -1;
-	nbd->kernel_sp_fd = -1;
+	nbd->thread = spdk_get_thread();
+
+	nbd->conns = calloc(num_conns, sizeof(*nbd->conns));
+	if (nbd->conns == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	nbd->num_conns = num_conns;
+	for (i = 0; i < num_conns; i++) {
+		conn = &nbd->conns[i];
+		conn->nbd = nbd;
+		conn->id = i;
+		conn->spdk_sp_fd = -1;
+		conn->kernel_sp_fd = -1;
+		TAILQ_INIT(&conn->received_io_list);
+		TAILQ_INIT(&conn->executed_io_list);
+		TAILQ_INIT(&conn->processing_io_list);
+	}
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -1083,18 +1496,20 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	bdev = spdk_bdev_desc_get_bdev(nbd->bdev_desc);
 	nbd->bdev = bdev;
 
-	nbd->ch = spdk_bdev_get_io_channel(nbd->bdev_desc);
 	nbd->buf_align = spdk_max(spdk_bdev_get_buf_align(bdev), 64);
 
-	rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
-	if (rc != 0) {
-		SPDK_ERRLOG("socketpair failed\n");
-		rc = -errno;
-		goto err;
+	for (i = 0; i < num_conns; i++) {
+		rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
+		if (rc != 0) {
+			SPDK_ERRLOG("socketpair failed\n");
+			rc = -errno;
+			goto err;
+		}
+
+		nbd->conns[i].spdk_sp_fd = sp[0];
+		nbd->conns[i].kernel_sp_fd = sp[1];
 	}
 
-	nbd->spdk_sp_fd = sp[0];
-	nbd->kernel_sp_fd = sp[1];
 	nbd->nbd_path = strdup(nbd_path);
 	if (!nbd->nbd_path) {
 		SPDK_ERRLOG("strdup allocation failure\n");
@@ -1102,10 +1517,6 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	TAILQ_INIT(&nbd->received_io_list);
-	TAILQ_INIT(&nbd->executed_io_list);
-	TAILQ_INIT(&nbd->processing_io_list);
-
 	/* Add nbd_disk to the end of disk list */
 	rc = nbd_disk_register(ctx->nbd);
 	if (rc != 0) {
@@ -1119,8 +1530,8 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s\n",
-		     bdev_name, nbd_path);
+	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s with %u connection(s)\n",
+		     bdev_name, nbd_path, num_conns);
 
 	nbd_enable_kernel(ctx);
 	return;
@@ -16,6 +16,7 @@
 struct rpc_nbd_start_disk {
 	char *bdev_name;
 	char *nbd_device;
+	uint32_t num_connections;
 	/* Used to search one available nbd device */
 	int nbd_idx;
 	bool nbd_idx_specified;
@@ -33,8 +34,25 @@ free_rpc_nbd_start_disk(struct rpc_nbd_start_disk *req)
 static const struct spdk_json_object_decoder rpc_nbd_start_disk_decoders[] = {
 	{"bdev_name", offsetof(struct rpc_nbd_start_disk, bdev_name), spdk_json_decode_string},
 	{"nbd_device", offsetof(struct rpc_nbd_start_disk, nbd_device), spdk_json_decode_string, true},
+	{
+		"num_connections", offsetof(struct rpc_nbd_start_disk, num_connections),
+		spdk_json_decode_uint32, true
+	},
 };
 
+static void rpc_start_nbd_done(void *cb_arg, struct spdk_nbd_disk *nbd, int rc);
+
+static void
+rpc_start_nbd(struct rpc_nbd_start_disk *req)
+{
+	struct spdk_nbd_start_opts opts = {
+		.opts_size = sizeof(opts),
+		.num_connections = req->num_connections,
+	};
+
+	spdk_nbd_start_ext(req->bdev_name, req->nbd_device, &opts, rpc_start_nbd_done, req);
+}
+
 /* Return 0 to indicate the nbd_device might be available,
  * or non-zero to indicate the nbd_device is invalid or in use.
  */
@@ -120,8 +138,7 @@ rpc_start_nbd_done(void *cb_arg, struct spdk_nbd_disk *nbd, int rc)
 
 		req->nbd_device = find_available_nbd_disk(req->nbd_idx, &req->nbd_idx);
 		if (req->nbd_device != NULL) {
-			spdk_nbd_start(req->bdev_name, req->nbd_device,
-				       rpc_start_nbd_done, req);
+			rpc_start_nbd(req);
 			return;
 		}
 
@@ -195,8 +212,7 @@ rpc_nbd_start_disk(struct spdk_jsonrpc_request *request,
 	}
 
 	req->request = request;
-	spdk_nbd_start(req->bdev_name, req->nbd_device,
-		       rpc_start_nbd_done, req);
+	rpc_start_nbd(req);
 
 	return;
 
@@ -319,6 +335,8 @@ rpc_dump_nbd_info(struct spdk_json_write_ctx *w,
 
 	spdk_json_write_named_string(w, "bdev_name", nbd_disk_get_bdev_name(nbd));
 
+	spdk_json_write_named_uint32(w, "num_connections", nbd_disk_get_num_connections(nbd));
+
 	spdk_json_write_object_end(w);
 }
 
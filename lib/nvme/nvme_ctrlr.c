@@ -18,9 +18,6 @@ struct nvme_active_ns_ctx;
 static int nvme_ctrlr_construct_and_submit_aer(struct spdk_nvme_ctrlr *ctrlr,
 		struct nvme_async_event_request *aer);
 static void nvme_ctrlr_identify_active_ns_async(struct nvme_active_ns_ctx *ctx);
-static int nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns);
-static int nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns);
-static int nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns);
 static void nvme_ctrlr_init_cap(struct spdk_nvme_ctrlr *ctrlr);
 static void nvme_ctrlr_set_state(struct spdk_nvme_ctrlr *ctrlr, enum nvme_ctrlr_state state,
 				 uint64_t timeout_in_ms);
@@ -185,6 +182,7 @@ spdk_nvme_ctrlr_get_default_ctrlr_opts(struct spdk_nvme_ctrlr_opts *opts, size_t
 	SET_FIELD(num_io_queues, DEFAULT_MAX_IO_QUEUES);
 	SET_FIELD(use_cmb_sqs, false);
 	SET_FIELD(no_shn_notification, false);
+	SET_FIELD(enable_interrupts, false);
 	SET_FIELD(arb_mechanism, SPDK_NVME_CC_AMS_RR);
 	SET_FIELD(arbitration_burst, 0);
 	SET_FIELD(low_priority_weight, 0);
@@ -322,6 +320,10 @@ spdk_nvme_ctrlr_get_default_io_qpair_opts(struct spdk_nvme_ctrlr *ctrlr,
 		opts->delay_cmd_submit = false;
 	}
 
+	if (FIELD_OK(use_cmb_sq)) {
+		opts->use_cmb_sq = ctrlr->opts.use_cmb_sqs;
+	}
+
 	if (FIELD_OK(sq.vaddr)) {
 		opts->sq.vaddr = NULL;
 	}
@@ -354,6 +356,26 @@ spdk_nvme_ctrlr_get_default_io_qpair_opts(struct spdk_nvme_ctrlr *ctrlr,
 		opts->async_mode = false;
 	}
 
+	if (FIELD_OK(sq_doorbell_batch)) {
+		opts->sq_doorbell_batch = 0;
+	}
+
+	if (FIELD_OK(cq_doorbell_batch)) {
+		opts->cq_doorbell_batch = 0;
+	}
+
+	if (FIELD_OK(io_queue_child_requests)) {
+		opts->io_queue_child_requests = 0;
+	}
+
+	if (FIELD_OK(num_connections)) {
+		opts->num_connections = 1;
+	}
+
+	if (FIELD_OK(submit_ring_size)) {
+		opts->submit_ring_size = 0;
+	}
+
 #undef FIELD_OK
 }
 
@@ -401,6 +423,24 @@ nvme_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr,
 		return NULL;
 	}
 
+	if (opts->io_queue_child_requests != 0 &&
+	    nvme_qpair_init_child_requests(qpair, opts->io_queue_child_requests) != 0) {
+		NVME_CTRLR_ERRLOG(ctrlr, "nvme_qpair_init_child_requests() failed\n");
+		nvme_transport_ctrlr_delete_io_qpair(ctrlr, qpair);
+		spdk_nvme_ctrlr_free_qid(ctrlr, qid);
+		nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
+		return NULL;
+	}
+
+	if (opts->submit_ring_size != 0 &&
+	    nvme_qpair_init_submit_ring(qpair, opts->submit_ring_size) != 0) {
+		NVME_CTRLR_ERRLOG(ctrlr, "nvme_qpair_init_submit_ring() failed\n");
+		nvme_transport_ctrlr_delete_io_qpair(ctrlr, qpair);
+		spdk_nvme_ctrlr_free_qid(ctrlr, qid);
+		nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
+		return NULL;
+	}
+
 	TAILQ_INSERT_TAIL(&ctrlr->active_io_qpairs, qpair, tailq);
 
 	nvme_ctrlr_proc_add_io_qpair(qpair);
@@ -410,6 +450,93 @@ nvme_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr,
 	return qpair;
 }
 
+static void
+nvme_ctrlr_free_io_qpair_stripes(struct spdk_nvme_qpair *qpair)
+{
+	struct spdk_nvme_qpair *stripe;
+
+	while (qpair->num_stripes > 0) {
+		stripe = qpair->stripes[--qpair->num_stripes];
+		stripe->stripe_parent = NULL;
+		stripe->latency = NULL;
+		spdk_nvme_ctrlr_free_io_qpair(stripe);
+	}
+
+	free(qpair->stripes);
+	qpair->stripes = NULL;
+}
+
+static int
+nvme_ctrlr_create_io_qpair_stripes(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair,
+				   const struct spdk_nvme_io_qpair_opts *opts)
+{
+	struct spdk_nvme_io_qpair_opts stripe_opts;
+	struct spdk_nvme_qpair *stripe;
+
+	if (!spdk_nvme_ctrlr_is_fabrics(ctrlr)) {
+		NVME_CTRLR_ERRLOG(ctrlr, "num_connections is only supported by fabrics transports\n");
+		return -ENOTSUP;
+	}
+
+	qpair->stripes = calloc(opts->num_connections - 1, sizeof(*qpair->stripes));
+	if (qpair->stripes == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Children from the arena and messages are only handled by the user's qpair. */
+	stripe_opts = *opts;
+	stripe_opts.num_connections = 1;
+	stripe_opts.io_queue_child_requests = 0;
+	stripe_opts.submit_ring_size = 0;
+
+	while (qpair->num_stripes < opts->num_connections - 1) {
+		stripe = nvme_ctrlr_create_io_qpair(ctrlr, &stripe_opts);
+		if (stripe == NULL) {
+			nvme_ctrlr_free_io_qpair_stripes(qpair);
+			return -ENOMEM;
+		}
+
+		stripe->stripe_parent = qpair;
+		qpair->stripes[qpair->num_stripes++] = stripe;
+	}
+
+	return 0;
+}
+
+/* The connections of a striped qpair are disconnected before the user's qpair, see
+ * nvme_poll_group_disconnected_qpair_cb().
+ */
+static void
+nvme_ctrlr_disconnect_io_qpair_stripes(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
+{
+	uint16_t i;
+
+	for (i = 0; i < qpair->num_stripes; i++) {
+		nvme_transport_ctrlr_disconnect_qpair(ctrlr, qpair->stripes[i]);
+	}
+}
+
+static int
+nvme_ctrlr_connect_io_qpair_stripes(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
+{
+	uint16_t i;
+	int rc;
+
+	for (i = 0; i < qpair->num_stripes; i++) {
+		if (nvme_qpair_get_state(qpair->stripes[i]) != NVME_QPAIR_DISCONNECTED) {
+			continue;
+		}
+
+		rc = nvme_transport_ctrlr_connect_qpair(ctrlr, qpair->stripes[i]);
+		if (rc != 0) {
+			nvme_ctrlr_disconnect_io_qpair_stripes(ctrlr, qpair);
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
 int
 spdk_nvme_ctrlr_connect_io_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
 {
@@ -420,7 +547,10 @@ spdk_nvme_ctrlr_connect_io_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme
 	}
 
 	nvme_robust_mutex_lock(&ctrlr->ctrlr_lock);
-	rc = nvme_transport_ctrlr_connect_qpair(ctrlr, qpair);
+	rc = nvme_ctrlr_connect_io_qpair_stripes(ctrlr, qpair);
+	if (rc == 0) {
+		rc = nvme_transport_ctrlr_connect_qpair(ctrlr, qpair);
+	}
 	nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
 
 	if (ctrlr->quirks & NVME_QUIRK_DELAY_AFTER_QUEUE_ALLOC) {
@@ -436,6 +566,7 @@ spdk_nvme_ctrlr_disconnect_io_qpair(struct spdk_nvme_qpair *qpair)
 	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
 
 	nvme_robust_mutex_lock(&ctrlr->ctrlr_lock);
+	nvme_ctrlr_disconnect_io_qpair_stripes(ctrlr, qpair);
 	nvme_transport_ctrlr_disconnect_qpair(ctrlr, qpair);
 	nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
 }
@@ -488,6 +619,16 @@ spdk_nvme_ctrlr_alloc_io_qpair(struct spdk_nvme_ctrlr *ctrlr,
 
 	qpair = nvme_ctrlr_create_io_qpair(ctrlr, &opts);
 
+	if (qpair != NULL && opts.num_connections > 1) {
+		rc = nvme_ctrlr_create_io_qpair_stripes(ctrlr, qpair, &opts);
+		if (rc != 0) {
+			NVME_CTRLR_ERRLOG(ctrlr, "failed to create %u connections\n", opts.num_connections);
+			spdk_nvme_ctrlr_free_io_qpair(qpair);
+			qpair = NULL;
+			goto unlock;
+		}
+	}
+
 	if (qpair == NULL || opts.create_only == true) {
 		goto unlock;
 	}
@@ -495,6 +636,7 @@ spdk_nvme_ctrlr_alloc_io_qpair(struct spdk_nvme_ctrlr *ctrlr,
 	rc = spdk_nvme_ctrlr_connect_io_qpair(ctrlr, qpair);
 	if (rc != 0) {
 		NVME_CTRLR_ERRLOG(ctrlr, "nvme_transport_ctrlr_connect_io_qpair() failed\n");
+		nvme_ctrlr_free_io_qpair_stripes(qpair);
 		nvme_ctrlr_proc_remove_io_qpair(qpair);
 		TAILQ_REMOVE(&ctrlr->active_io_qpairs, qpair, tailq);
 		spdk_bit_array_set(ctrlr->free_io_qids, qpair->id);
@@ -544,7 +686,10 @@ spdk_nvme_ctrlr_reconnect_io_qpair(struct spdk_nvme_qpair *qpair)
 		goto out;
 	}
 
-	rc = nvme_transport_ctrlr_connect_qpair(ctrlr, qpair);
+	rc = nvme_ctrlr_connect_io_qpair_stripes(ctrlr, qpair);
+	if (rc == 0) {
+		rc = nvme_transport_ctrlr_connect_qpair(ctrlr, qpair);
+	}
 	if (rc) {
 		rc = -EAGAIN;
 		goto out;
@@ -574,6 +719,7 @@ nvme_ctrlr_disconnect_qpair(struct spdk_nvme_qpair *qpair)
 
 	assert(ctrlr != NULL);
 	nvme_robust_mutex_lock(&ctrlr->ctrlr_lock);
+	nvme_ctrlr_disconnect_io_qpair_stripes(ctrlr, qpair);
 	nvme_transport_ctrlr_disconnect_qpair(ctrlr, qpair);
 	nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
 }
@@ -602,6 +748,8 @@ spdk_nvme_ctrlr_free_io_qpair(struct spdk_nvme_qpair *qpair)
 
 	qpair->destroy_in_progress = 1;
 
+	nvme_ctrlr_free_io_qpair_stripes(qpair);
+
 	nvme_transport_ctrlr_disconnect_qpair(ctrlr, qpair);
 
 	if (qpair->poll_group && (qpair->active_proc == nvme_ctrlr_get_current_process(ctrlr))) {
@@ -1432,12 +1580,56 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 	return "unknown";
 };
 
+static void
+nvme_ctrlr_report_init_times(struct spdk_nvme_ctrlr *ctrlr)
+{
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint64_t total_ticks = 0, usec;
+	int state;
+
+	for (state = 0; state < NVME_CTRLR_STATE_COUNT; state++) {
+		if (ctrlr->init_state_ticks[state] == 0) {
+			continue;
+		}
+
+		total_ticks += ctrlr->init_state_ticks[state];
+		usec = ctrlr->init_state_ticks[state] * SPDK_SEC_TO_USEC / ticks_hz;
+		NVME_CTRLR_DEBUGLOG(ctrlr, "init state %s took %" PRIu64 " us\n",
+				    nvme_ctrlr_state_string(state), usec);
+	}
+
+	usec = total_ticks * SPDK_SEC_TO_USEC / ticks_hz;
+	NVME_CTRLR_INFOLOG(ctrlr, "initialization took %" PRIu64 " us (%u active namespaces)\n",
+			   usec, ctrlr->active_ns_count);
+}
+
+static void
+nvme_ctrlr_account_init_state(struct spdk_nvme_ctrlr *ctrlr, enum nvme_ctrlr_state state)
+{
+	uint64_t now_ticks = spdk_get_ticks();
+
+	if (state == NVME_CTRLR_STATE_INIT_DELAY ||
+	    (state == NVME_CTRLR_STATE_INIT && ctrlr->state != NVME_CTRLR_STATE_INIT_DELAY)) {
+		/* (Re)initialization starts, drop the times of the previous one */
+		memset(ctrlr->init_state_ticks, 0, sizeof(ctrlr->init_state_ticks));
+	} else if (ctrlr->init_state_start_tick != 0 &&
+		   ctrlr->state >= 0 && ctrlr->state < NVME_CTRLR_STATE_COUNT) {
+		ctrlr->init_state_ticks[ctrlr->state] += now_ticks - ctrlr->init_state_start_tick;
+	}
+	ctrlr->init_state_start_tick = now_ticks;
+
+	if (state == NVME_CTRLR_STATE_READY && ctrlr->state != NVME_CTRLR_STATE_READY) {
+		nvme_ctrlr_report_init_times(ctrlr);
+	}
+}
+
 static void
 _nvme_ctrlr_set_state(struct spdk_nvme_ctrlr *ctrlr, enum nvme_ctrlr_state state,
 		      uint64_t timeout_in_ms, bool quiet)
 {
 	uint64_t ticks_per_ms, timeout_in_ticks, now_ticks;
 
+	nvme_ctrlr_account_init_state(ctrlr, state);
 	ctrlr->state = state;
 	if (timeout_in_ms == NVME_TIMEOUT_KEEP_EXISTING) {
 		if (!quiet) {
@@ -2471,141 +2663,175 @@ nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 	return 0;
 }
 
+/*
+ * Per-namespace identify commands sent during initialization don't depend on each other.
+ * Keep several of them outstanding instead of waiting out an admin command round trip
+ * for every namespace, which dominates attach time for fabrics controllers with many
+ * namespaces.
+ */
+#define NVME_CTRLR_NS_INIT_MAX_OUTSTANDING	16u
+
+struct nvme_ctrlr_ns_init_phase {
+	/* State the controller waits in while commands are outstanding */
+	enum nvme_ctrlr_state	wait_state;
+	/* State to move to once all active namespaces have been processed */
+	enum nvme_ctrlr_state	next_state;
+	/* Skips namespaces for which it returns false, NULL processes all of them */
+	bool			(*filter_fn)(struct spdk_nvme_ns *ns);
+	int			(*submit_fn)(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns);
+	/* A failed command stops the phase without failing the initialization */
+	bool			ignore_errors;
+};
+
+static uint32_t
+nvme_ctrlr_ns_init_max_outstanding(struct spdk_nvme_ctrlr *ctrlr)
+{
+	/* Leave at least half of the admin queue for AERs, keep alive, etc. */
+	return spdk_max(1u, spdk_min(NVME_CTRLR_NS_INIT_MAX_OUTSTANDING,
+				     (uint32_t)ctrlr->opts.admin_queue_size / 2));
+}
+
 static void
-nvme_ctrlr_identify_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+nvme_ctrlr_ns_init_submit(struct spdk_nvme_ctrlr *ctrlr)
 {
-	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
-	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+	const struct nvme_ctrlr_ns_init_phase *phase = ctrlr->ns_init.phase;
+	uint32_t max_outstanding = nvme_ctrlr_ns_init_max_outstanding(ctrlr);
+	struct spdk_nvme_ns *ns;
 	uint32_t nsid;
 	int rc;
 
-	if (spdk_nvme_cpl_is_error(cpl)) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	/*
+	 * Commands may complete from within submit_fn(). Let the outermost call keep
+	 * filling the pipeline instead of recursing.
+	 */
+	if (ctrlr->ns_init.submitting) {
 		return;
 	}
 
-	nvme_ns_set_identify_data(ns);
+	ctrlr->ns_init.submitting = true;
+	while (ctrlr->ns_init.status == 0 && !ctrlr->ns_init.stopped &&
+	       ctrlr->ns_init.next_nsid != 0 && ctrlr->ns_init.outstanding < max_outstanding) {
+		nsid = ctrlr->ns_init.next_nsid;
+		ctrlr->ns_init.next_nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, nsid);
 
-	/* move on to the next active NS */
-	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_ID_DESCS,
-				     ctrlr->opts.admin_timeout_ms);
+		ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
+		if (ns == NULL || (phase->filter_fn != NULL && !phase->filter_fn(ns))) {
+			continue;
+		}
+
+		ctrlr->ns_init.outstanding++;
+		rc = phase->submit_fn(ctrlr, ns);
+		if (rc != 0) {
+			ctrlr->ns_init.outstanding--;
+			ctrlr->ns_init.status = rc;
+		}
+	}
+	ctrlr->ns_init.submitting = false;
+
+	if (ctrlr->ns_init.outstanding > 0) {
+		/* The admin timeout applies to each command, so restart it on progress. */
+		nvme_ctrlr_set_state_quiet(ctrlr, phase->wait_state, ctrlr->opts.admin_timeout_ms);
 		return;
 	}
-	ns->ctrlr = ctrlr;
-	ns->id = nsid;
 
-	rc = nvme_ctrlr_identify_ns_async(ns);
-	if (rc) {
+	ctrlr->ns_init.phase = NULL;
+	if (ctrlr->ns_init.status != 0) {
 		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	} else {
+		nvme_ctrlr_set_state(ctrlr, phase->next_state, ctrlr->opts.admin_timeout_ms);
 	}
 }
 
-static int
-nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns)
+static void
+nvme_ctrlr_ns_init_complete(struct spdk_nvme_ctrlr *ctrlr, bool success)
 {
-	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
-	struct spdk_nvme_ns_data *nsdata;
+	assert(ctrlr->ns_init.phase != NULL);
+	assert(ctrlr->ns_init.outstanding > 0);
 
-	nsdata = &ns->nsdata;
+	ctrlr->ns_init.outstanding--;
+	if (!success) {
+		if (ctrlr->ns_init.phase->ignore_errors) {
+			ctrlr->ns_init.stopped = true;
+		} else if (ctrlr->ns_init.status == 0) {
+			ctrlr->ns_init.status = -EIO;
+		}
+	}
 
-	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS,
-			     ctrlr->opts.admin_timeout_ms);
-	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id, 0,
-				       nsdata, sizeof(*nsdata),
-				       nvme_ctrlr_identify_ns_async_done, ns);
+	nvme_ctrlr_ns_init_submit(ctrlr);
 }
 
 static int
-nvme_ctrlr_identify_namespaces(struct spdk_nvme_ctrlr *ctrlr)
+nvme_ctrlr_ns_init_start(struct spdk_nvme_ctrlr *ctrlr, const struct nvme_ctrlr_ns_init_phase *phase)
 {
-	uint32_t nsid;
-	struct spdk_nvme_ns *ns;
-	int rc;
+	assert(ctrlr->ns_init.outstanding == 0);
 
-	nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		/* No active NS, move on to the next state */
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_ID_DESCS,
-				     ctrlr->opts.admin_timeout_ms);
-		return 0;
-	}
+	ctrlr->ns_init.phase = phase;
+	ctrlr->ns_init.next_nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
+	ctrlr->ns_init.status = 0;
+	ctrlr->ns_init.stopped = false;
 
-	ns->ctrlr = ctrlr;
-	ns->id = nsid;
+	nvme_ctrlr_set_state(ctrlr, phase->wait_state, ctrlr->opts.admin_timeout_ms);
+	nvme_ctrlr_ns_init_submit(ctrlr);
 
-	rc = nvme_ctrlr_identify_ns_async(ns);
-	if (rc) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	return ctrlr->ns_init.status;
+}
+
+static void
+nvme_ctrlr_identify_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		nvme_ctrlr_ns_init_complete(ns->ctrlr, false);
+		return;
 	}
 
-	return rc;
+	nvme_ns_set_identify_data(ns);
+	nvme_ctrlr_ns_init_complete(ns->ctrlr, true);
 }
 
 static int
-nvme_ctrlr_identify_namespaces_iocs_specific_next(struct spdk_nvme_ctrlr *ctrlr, uint32_t prev_nsid)
+nvme_ctrlr_identify_ns_async(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
 {
-	uint32_t nsid;
-	struct spdk_nvme_ns *ns;
-	int rc;
-
-	if (!prev_nsid) {
-		nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
-	} else {
-		/* move on to the next active NS */
-		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, prev_nsid);
-	}
+	struct spdk_nvme_ns_data *nsdata;
 
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		/* No first/next active NS, move on to the next state */
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES,
-				     ctrlr->opts.admin_timeout_ms);
-		return 0;
-	}
+	ns->ctrlr = ctrlr;
+	nsdata = &ns->nsdata;
 
-	/* loop until we find a ns which has (supported) iocs specific data */
-	while (!nvme_ns_has_supported_iocs_specific_data(ns)) {
-		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
-		ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-		if (ns == NULL) {
-			/* no namespace with (supported) iocs specific data found */
-			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES,
-					     ctrlr->opts.admin_timeout_ms);
-			return 0;
-		}
-	}
+	return nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id, 0,
+				       nsdata, sizeof(*nsdata),
+				       nvme_ctrlr_identify_ns_async_done, ns);
+}
 
-	rc = nvme_ctrlr_identify_ns_iocs_specific_async(ns);
-	if (rc) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
-	}
+static const struct nvme_ctrlr_ns_init_phase g_nvme_ctrlr_identify_ns_phase = {
+	.wait_state = NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS,
+	.next_state = NVME_CTRLR_STATE_IDENTIFY_ID_DESCS,
+	.submit_fn = nvme_ctrlr_identify_ns_async,
+};
 
-	return rc;
+static int
+nvme_ctrlr_identify_namespaces(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return nvme_ctrlr_ns_init_start(ctrlr, &g_nvme_ctrlr_identify_ns_phase);
 }
 
 static void
 nvme_ctrlr_identify_ns_zns_specific_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
 {
 	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
-	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
 
 	if (spdk_nvme_cpl_is_error(cpl)) {
 		nvme_ns_free_zns_specific_data(ns);
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+		nvme_ctrlr_ns_init_complete(ns->ctrlr, false);
 		return;
 	}
 
-	nvme_ctrlr_identify_namespaces_iocs_specific_next(ctrlr, ns->id);
+	nvme_ctrlr_ns_init_complete(ns->ctrlr, true);
 }
 
 static int
-nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns)
+nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
 {
-	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
 	int rc;
 
 	switch (ns->csi) {
@@ -2627,9 +2853,7 @@ nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns)
 		return -ENOMEM;
 	}
 
-	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC,
-			     ctrlr->opts.admin_timeout_ms);
-	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_IOCS, 0, ns->id, ns->csi,
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_NS_IOCS, 0, ns->id, ns->csi,
 				     ns->nsdata_zns, sizeof(*ns->nsdata_zns),
 				     nvme_ctrlr_identify_ns_zns_specific_async_done, ns);
 	if (rc) {
@@ -2639,6 +2863,13 @@ nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns)
 	return rc;
 }
 
+static const struct nvme_ctrlr_ns_init_phase g_nvme_ctrlr_identify_ns_iocs_specific_phase = {
+	.wait_state = NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC,
+	.next_state = NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES,
+	.filter_fn = nvme_ns_has_supported_iocs_specific_data,
+	.submit_fn = nvme_ctrlr_identify_ns_iocs_specific_async,
+};
+
 static int
 nvme_ctrlr_identify_namespaces_iocs_specific(struct spdk_nvme_ctrlr *ctrlr)
 {
@@ -2649,23 +2880,21 @@ nvme_ctrlr_identify_namespaces_iocs_specific(struct spdk_nvme_ctrlr *ctrlr)
 		return 0;
 	}
 
-	return nvme_ctrlr_identify_namespaces_iocs_specific_next(ctrlr, 0);
+	return nvme_ctrlr_ns_init_start(ctrlr, &g_nvme_ctrlr_identify_ns_iocs_specific_phase);
 }
 
 static void
 nvme_ctrlr_identify_id_desc_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
 {
 	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
-	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
-	uint32_t nsid;
-	int rc;
 
 	if (spdk_nvme_cpl_is_error(cpl)) {
 		/*
 		 * Many controllers claim to be compatible with NVMe 1.3, however,
 		 * they do not implement NS ID Desc List. Therefore, instead of setting
 		 * the state to NVME_CTRLR_STATE_ERROR, silently ignore the completion
-		 * error and move on to the next state.
+		 * error and move on to the next state once the outstanding commands
+		 * have completed (see ignore_errors of the phase).
 		 *
 		 * The proper way is to create a new quirk for controllers that violate
 		 * the NVMe 1.3 spec by not supporting NS ID Desc List.
@@ -2673,49 +2902,34 @@ nvme_ctrlr_identify_id_desc_async_done(void *arg, const struct spdk_nvme_cpl *cp
 		 * it is too generic and was added in order to handle controllers that
 		 * violate the NVMe 1.1 spec by not supporting ACTIVE LIST).
 		 */
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
-				     ctrlr->opts.admin_timeout_ms);
+		nvme_ctrlr_ns_init_complete(ns->ctrlr, false);
 		return;
 	}
 
 	nvme_ns_set_id_desc_list_data(ns);
-
-	/* move on to the next active NS */
-	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
-				     ctrlr->opts.admin_timeout_ms);
-		return;
-	}
-
-	rc = nvme_ctrlr_identify_id_desc_async(ns);
-	if (rc) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
-	}
+	nvme_ctrlr_ns_init_complete(ns->ctrlr, true);
 }
 
 static int
-nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns)
+nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
 {
-	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
-
 	memset(ns->id_desc_list, 0, sizeof(ns->id_desc_list));
 
-	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS,
-			     ctrlr->opts.admin_timeout_ms);
-	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST,
+	return nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST,
 				       0, ns->id, 0, ns->id_desc_list, sizeof(ns->id_desc_list),
 				       nvme_ctrlr_identify_id_desc_async_done, ns);
 }
 
+static const struct nvme_ctrlr_ns_init_phase g_nvme_ctrlr_identify_id_desc_phase = {
+	.wait_state = NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS,
+	.next_state = NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
+	.submit_fn = nvme_ctrlr_identify_id_desc_async,
+	.ignore_errors = true,
+};
+
 static int
 nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 {
-	uint32_t nsid;
-	struct spdk_nvme_ns *ns;
-	int rc;
-
 	if ((ctrlr->vs.raw < SPDK_NVME_VERSION(1, 3, 0) &&
 	     !(ctrlr->cap.bits.css & SPDK_NVME_CAP_CSS_IOCS)) ||
 	    (ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS)) {
@@ -2726,21 +2940,7 @@ nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 		return 0;
 	}
 
-	nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		/* No active NS, move on to the next state */
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
-				     ctrlr->opts.admin_timeout_ms);
-		return 0;
-	}
-
-	rc = nvme_ctrlr_identify_id_desc_async(ns);
-	if (rc) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
-	}
-
-	return rc;
+	return nvme_ctrlr_ns_init_start(ctrlr, &g_nvme_ctrlr_identify_id_desc_phase);
 }
 
 static void
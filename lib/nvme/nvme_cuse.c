@@ -19,6 +19,10 @@
 #include "nvme_io_msg.h"
 #include "nvme_cuse.h"
 
+/* Number of threads processing the requests of each device, so that a long running command
+ * doesn't hold back the other ones issued to the same device. */
+#define CUSE_THREADS_PER_DEVICE		4
+
 struct cuse_device {
 	char				dev_name[128];
 	uint32_t			index;
@@ -28,7 +32,8 @@ struct cuse_device {
 	struct spdk_nvme_ctrlr		*ctrlr;		/**< NVMe controller */
 	uint32_t			nsid;		/**< NVMe name space id, or 0 */
 
-	pthread_t			tid;
+	pthread_t			tids[CUSE_THREADS_PER_DEVICE];
+	uint32_t			num_threads;
 	struct fuse_session		*session;
 
 	struct cuse_device		*ctrlr_device;
@@ -56,6 +61,9 @@ struct cuse_io_ctx {
 	int				data_len;
 	int				metadata_len;
 
+	/* Reply with a 64-bit result, for the 64-bit passthru commands */
+	bool				result64;
+
 	fuse_req_t			req;
 };
 
@@ -99,12 +107,19 @@ cuse_nvme_passthru_cmd_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 	struct cuse_io_ctx *ctx = arg;
 	struct iovec out_iov[3];
 	struct spdk_nvme_cpl _cpl;
+	uint64_t result64;
 	int out_iovcnt = 0;
 	uint16_t status_field = cpl->status_raw >> 1; /* Drop out phase bit */
 
 	memcpy(&_cpl, cpl, sizeof(struct spdk_nvme_cpl));
-	out_iov[out_iovcnt].iov_base = &_cpl.cdw0;
-	out_iov[out_iovcnt].iov_len = sizeof(_cpl.cdw0);
+	if (ctx->result64) {
+		result64 = ((uint64_t)_cpl.cdw1 << 32) | _cpl.cdw0;
+		out_iov[out_iovcnt].iov_base = &result64;
+		out_iov[out_iovcnt].iov_len = sizeof(result64);
+	} else {
+		out_iov[out_iovcnt].iov_base = &_cpl.cdw0;
+		out_iov[out_iovcnt].iov_len = sizeof(_cpl.cdw0);
+	}
 	out_iovcnt += 1;
 
 	if (ctx->data_transfer == SPDK_NVME_DATA_CONTROLLER_TO_HOST) {
@@ -144,6 +159,28 @@ cuse_nvme_passthru_cmd_execute(struct spdk_nvme_ctrlr *ctrlr, uint32_t nsid, voi
 	}
 }
 
+static bool
+cuse_nvme_passthru_cmd_is_64(int cmd)
+{
+#ifdef NVME_IOCTL_ADMIN64_CMD
+	return (unsigned int)cmd == NVME_IOCTL_ADMIN64_CMD ||
+	       (unsigned int)cmd == NVME_IOCTL_IO64_CMD;
+#else
+	return false;
+#endif
+}
+
+static bool
+cuse_nvme_passthru_cmd_is_admin(int cmd)
+{
+#ifdef NVME_IOCTL_ADMIN64_CMD
+	if ((unsigned int)cmd == NVME_IOCTL_ADMIN64_CMD) {
+		return true;
+	}
+#endif
+	return (unsigned int)cmd == NVME_IOCTL_ADMIN_CMD;
+}
+
 static void
 cuse_nvme_passthru_cmd_send(fuse_req_t req, struct nvme_passthru_cmd *passthru_cmd,
 			    const void *data, const void *metadata, int cmd)
@@ -161,6 +198,7 @@ cuse_nvme_passthru_cmd_send(fuse_req_t req, struct nvme_passthru_cmd *passthru_c
 
 	ctx->req = req;
 	ctx->data_transfer = spdk_nvme_opc_get_data_transfer(passthru_cmd->opcode);
+	ctx->result64 = cuse_nvme_passthru_cmd_is_64(cmd);
 
 	memset(&ctx->nvme_cmd, 0, sizeof(ctx->nvme_cmd));
 	ctx->nvme_cmd.opc = passthru_cmd->opcode;
@@ -201,7 +239,7 @@ cuse_nvme_passthru_cmd_send(fuse_req_t req, struct nvme_passthru_cmd *passthru_c
 		}
 	}
 
-	if ((unsigned int)cmd != NVME_IOCTL_ADMIN_CMD) {
+	if (!cuse_nvme_passthru_cmd_is_admin(cmd)) {
 		/* Send NS for IO IOCTLs */
 		rv = nvme_io_msg_send(cuse_device->ctrlr, passthru_cmd->nsid, cuse_nvme_passthru_cmd_execute, ctx);
 	} else {
@@ -226,9 +264,17 @@ cuse_nvme_passthru_cmd(fuse_req_t req, int cmd, void *arg,
 	int in_iovcnt = 0, out_iovcnt = 0;
 	const void *dptr = NULL, *mdptr = NULL;
 	enum spdk_nvme_data_transfer data_transfer;
+	/* The 64-bit commands only differ by the size of the result, placed at the end */
+	size_t cmd_size = sizeof(struct nvme_passthru_cmd);
+	size_t result_size = sizeof(uint32_t);
+
+	if (cuse_nvme_passthru_cmd_is_64(cmd)) {
+		cmd_size = sizeof(struct nvme_passthru_cmd64);
+		result_size = sizeof(uint64_t);
+	}
 
 	in_iov[in_iovcnt].iov_base = (void *)arg;
-	in_iov[in_iovcnt].iov_len = sizeof(*passthru_cmd);
+	in_iov[in_iovcnt].iov_len = cmd_size;
 	in_iovcnt += 1;
 	if (in_bufsz == 0) {
 		fuse_reply_ioctl_retry(req, in_iov, in_iovcnt, NULL, out_iovcnt);
@@ -257,8 +303,8 @@ cuse_nvme_passthru_cmd(fuse_req_t req, int cmd, void *arg,
 		return;
 	}
 	/* Always make result field writeable regardless of data transfer bits */
-	out_iov[out_iovcnt].iov_base = &((struct nvme_passthru_cmd *)arg)->result;
-	out_iov[out_iovcnt].iov_len = sizeof(uint32_t);
+	out_iov[out_iovcnt].iov_base = (uint8_t *)arg + cmd_size - result_size;
+	out_iov[out_iovcnt].iov_len = result_size;
 	out_iovcnt += 1;
 
 	if (data_transfer == SPDK_NVME_DATA_CONTROLLER_TO_HOST) {
@@ -291,8 +337,8 @@ cuse_nvme_passthru_cmd(fuse_req_t req, int cmd, void *arg,
 	}
 
 	if (data_transfer == SPDK_NVME_DATA_HOST_TO_CONTROLLER) {
-		dptr = (passthru_cmd->addr == 0) ? NULL : (uint8_t *)in_buf + sizeof(*passthru_cmd);
-		mdptr = (passthru_cmd->metadata == 0) ? NULL : (uint8_t *)in_buf + sizeof(*passthru_cmd) +
+		dptr = (passthru_cmd->addr == 0) ? NULL : (uint8_t *)in_buf + cmd_size;
+		mdptr = (passthru_cmd->metadata == 0) ? NULL : (uint8_t *)in_buf + cmd_size +
 			passthru_cmd->data_len;
 	}
 
@@ -755,6 +801,13 @@ cuse_ctrlr_ioctl(fuse_req_t req, int cmd, void *arg,
 		cuse_nvme_passthru_cmd(req, cmd, arg, fi, flags, in_buf, in_bufsz, out_bufsz);
 		break;
 
+#ifdef NVME_IOCTL_ADMIN64_CMD
+	case NVME_IOCTL_ADMIN64_CMD:
+		SPDK_DEBUGLOG(nvme_cuse, "NVME_IOCTL_ADMIN64_CMD\n");
+		cuse_nvme_passthru_cmd(req, cmd, arg, fi, flags, in_buf, in_bufsz, out_bufsz);
+		break;
+#endif
+
 	case NVME_IOCTL_RESET:
 	case NVME_IOCTL_SUBSYS_RESET:
 		cuse_nvme_reset(req, cmd, arg, fi, flags, in_buf, in_bufsz, out_bufsz);
@@ -797,6 +850,18 @@ cuse_ns_ioctl(fuse_req_t req, int cmd, void *arg,
 		cuse_nvme_passthru_cmd(req, cmd, arg, fi, flags, in_buf, in_bufsz, out_bufsz);
 		break;
 
+#ifdef NVME_IOCTL_ADMIN64_CMD
+	case NVME_IOCTL_ADMIN64_CMD:
+		SPDK_DEBUGLOG(nvme_cuse, "NVME_IOCTL_ADMIN64_CMD\n");
+		cuse_nvme_passthru_cmd(req, cmd, arg, fi, flags, in_buf, in_bufsz, out_bufsz);
+		break;
+
+	case NVME_IOCTL_IO64_CMD:
+		SPDK_DEBUGLOG(nvme_cuse, "NVME_IOCTL_IO64_CMD\n");
+		cuse_nvme_passthru_cmd(req, cmd, arg, fi, flags, in_buf, in_bufsz, out_bufsz);
+		break;
+#endif
+
 	case NVME_IOCTL_ID:
 		SPDK_DEBUGLOG(nvme_cuse, "NVME_IOCTL_ID\n");
 		cuse_getid(req, cmd, arg, fi, flags, in_buf, in_bufsz, out_bufsz);
@@ -859,6 +924,7 @@ cuse_session_create(struct cuse_device *cuse_device)
 	struct cuse_info ci;
 	char devname_arg[128 + 8];
 	const char *dev_info_argv[] = { devname_arg };
+	int fd, flags;
 
 	snprintf(devname_arg, sizeof(devname_arg), "DEVNAME=%s", cuse_device->dev_name);
 
@@ -879,6 +945,17 @@ cuse_session_create(struct cuse_device *cuse_device)
 		SPDK_ERRLOG("Cannot create cuse session\n");
 		return -1;
 	}
+
+	/* Several threads wait for requests on the same fd, so that the ones which lost the race
+	 * for a request go back to polling instead of blocking in read() */
+	fd = fuse_session_fd(cuse_device->session);
+	flags = fcntl(fd, F_GETFL);
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		SPDK_ERRLOG("Cannot make cuse session fd non-blocking\n");
+		cuse_lowlevel_teardown(cuse_device->session);
+		cuse_device->session = NULL;
+		return -1;
+	}
 	SPDK_NOTICELOG("fuse session for device %s created\n", cuse_device->dev_name);
 	return 0;
 }
@@ -908,10 +985,42 @@ cuse_thread(void *arg)
 		}
 	}
 	free(buf.mem);
-	fuse_session_reset(cuse_device->session);
 	pthread_exit(NULL);
 }
 
+static void
+cuse_threads_stop(struct cuse_device *cuse_device)
+{
+	uint32_t i;
+
+	if (cuse_device->session != NULL) {
+		fuse_session_exit(cuse_device->session);
+	}
+	for (i = 0; i < cuse_device->num_threads; i++) {
+		pthread_join(cuse_device->tids[i], NULL);
+	}
+	cuse_device->num_threads = 0;
+}
+
+static int
+cuse_threads_start(struct cuse_device *cuse_device)
+{
+	int rv;
+
+	while (cuse_device->num_threads < CUSE_THREADS_PER_DEVICE) {
+		rv = pthread_create(&cuse_device->tids[cuse_device->num_threads], NULL, cuse_thread,
+				    cuse_device);
+		if (rv != 0) {
+			SPDK_ERRLOG("pthread_create failed\n");
+			cuse_threads_stop(cuse_device);
+			return -rv;
+		}
+		cuse_device->num_threads++;
+	}
+
+	return 0;
+}
+
 static struct cuse_device *nvme_cuse_get_cuse_ns_device(struct spdk_nvme_ctrlr *ctrlr,
 		uint32_t nsid);
 
@@ -950,11 +1059,11 @@ cuse_nvme_ns_start(struct cuse_device *ctrlr_device, uint32_t nsid)
 		free(ns_device);
 		return rv;
 	}
-	rv = pthread_create(&ns_device->tid, NULL, cuse_thread, ns_device);
+	rv = cuse_threads_start(ns_device);
 	if (rv != 0) {
-		SPDK_ERRLOG("pthread_create failed\n");
+		cuse_lowlevel_teardown(ns_device->session);
 		free(ns_device);
-		return -rv;
+		return rv;
 	}
 	TAILQ_INSERT_TAIL(&ctrlr_device->ns_devices, ns_device, tailq);
 
@@ -964,10 +1073,7 @@ cuse_nvme_ns_start(struct cuse_device *ctrlr_device, uint32_t nsid)
 static void
 cuse_nvme_ns_stop(struct cuse_device *ctrlr_device, struct cuse_device *ns_device)
 {
-	if (ns_device->session != NULL) {
-		fuse_session_exit(ns_device->session);
-	}
-	pthread_join(ns_device->tid, NULL);
+	cuse_threads_stop(ns_device);
 	TAILQ_REMOVE(&ctrlr_device->ns_devices, ns_device, tailq);
 	if (ns_device->session != NULL) {
 		cuse_lowlevel_teardown(ns_device->session);
@@ -1048,8 +1154,7 @@ cuse_nvme_ctrlr_stop(struct cuse_device *ctrlr_device)
 
 	assert(TAILQ_EMPTY(&ctrlr_device->ns_devices));
 
-	fuse_session_exit(ctrlr_device->session);
-	pthread_join(ctrlr_device->tid, NULL);
+	cuse_threads_stop(ctrlr_device);
 	TAILQ_REMOVE(&g_ctrlr_ctx_head, ctrlr_device, tailq);
 	spdk_bit_array_clear(g_ctrlr_started, ctrlr_device->index);
 	if (spdk_bit_array_count_set(g_ctrlr_started) == 0) {
@@ -1137,10 +1242,9 @@ nvme_cuse_start(struct spdk_nvme_ctrlr *ctrlr)
 		goto clear_and_free;
 	}
 
-	rv = pthread_create(&ctrlr_device->tid, NULL, cuse_thread, ctrlr_device);
+	rv = cuse_threads_start(ctrlr_device);
 	if (rv != 0) {
-		SPDK_ERRLOG("pthread_create failed\n");
-		rv = -rv;
+		cuse_lowlevel_teardown(ctrlr_device->session);
 		goto clear_and_free;
 	}
 
@@ -270,6 +270,13 @@ struct nvme_error_cmd {
 	TAILQ_ENTRY(nvme_error_cmd)	link;
 };
 
+/* Latency histograms of a qpair, indexed by (nsid - 1) and spdk_nvme_latency_io_type and
+ * allocated on the first completion tallied into them. */
+struct nvme_qpair_latency {
+	uint32_t			num_ns;
+	struct spdk_histogram_data	*histograms[];
+};
+
 struct nvme_request {
 	struct spdk_nvme_cmd		cmd;
 
@@ -281,7 +288,12 @@ struct nvme_request {
 	 * True if the request is in the queued_req list.
 	 */
 	uint8_t				queued : 1;
-	uint8_t				reserved : 6;
+
+	/**
+	 * True if the request was taken from the qpair's child request arena.
+	 */
+	uint8_t				child_arena : 1;
+	uint8_t				reserved : 5;
 
 	/**
 	 * Number of children requests still outstanding for this
@@ -450,12 +462,27 @@ struct spdk_nvme_qpair {
 
 	uint32_t				num_outstanding_reqs;
 
+	/* Number of additional connections I/O is striped across, see num_connections */
+	uint16_t				num_stripes;
+	uint16_t				next_stripe;
+
+	/* Messages from the threads sharing this qpair, see spdk_nvme_qpair_send_msg() */
+	struct spdk_ring			*submit_ring;
+
+	/* Shared with the stripes, see spdk_nvme_qpair_enable_latency_tracking() */
+	struct nvme_qpair_latency		*latency;
+
 	/* request object used only for this qpair's FABRICS/CONNECT command (if needed) */
 	struct nvme_request			*reserved_req;
 
 	STAILQ_HEAD(, nvme_request)		free_req;
 	STAILQ_HEAD(, nvme_request)		queued_req;
 
+	/* Requests reserved for the children of split requests, see io_queue_child_requests */
+	STAILQ_HEAD(, nvme_request)		free_child_req;
+	uint32_t				num_free_child_reqs;
+	uint32_t				num_child_reqs;
+
 	/* List entry for spdk_nvme_transport_poll_group::qpairs */
 	STAILQ_ENTRY(spdk_nvme_qpair)		poll_group_stailq;
 
@@ -485,6 +512,11 @@ struct spdk_nvme_qpair {
 	STAILQ_HEAD(, nvme_request)		aborting_queued_req;
 
 	void					*req_buf;
+	void					*child_req_buf;
+
+	/* The qpairs of the additional connections, or the qpair they belong to */
+	struct spdk_nvme_qpair			**stripes;
+	struct spdk_nvme_qpair			*stripe_parent;
 };
 
 struct spdk_nvme_poll_group {
@@ -492,6 +524,12 @@ struct spdk_nvme_poll_group {
 	struct spdk_nvme_accel_fn_table			accel_fn_table;
 	STAILQ_HEAD(, spdk_nvme_transport_poll_group)	tgroups;
 	bool						in_process_completions;
+	/* Interrupt event fds of the qpairs, created on first use */
+	struct spdk_fd_group				*fgrp;
+	uint64_t					hybrid_poll_ticks;
+	/* Number of qpairs with a submission ring in the group */
+	uint32_t					num_shared_qpairs;
+	spdk_nvme_disconnected_qpair_cb			disconnected_qpair_cb;
 };
 
 struct spdk_nvme_transport_poll_group {
@@ -816,6 +854,8 @@ enum nvme_ctrlr_state {
 	NVME_CTRLR_STATE_DISCONNECTED,
 };
 
+#define NVME_CTRLR_STATE_COUNT		(NVME_CTRLR_STATE_DISCONNECTED + 1)
+
 #define NVME_TIMEOUT_INFINITE		0
 #define NVME_TIMEOUT_KEEP_EXISTING	UINT64_MAX
 
@@ -923,6 +963,20 @@ struct spdk_nvme_ctrlr {
 	int				state;
 	uint64_t			state_timeout_tsc;
 
+	/* Pipelined per-namespace identify commands sent during initialization */
+	struct {
+		const struct nvme_ctrlr_ns_init_phase	*phase;
+		uint32_t				next_nsid;
+		uint32_t				outstanding;
+		int					status;
+		bool					stopped;
+		bool					submitting;
+	} ns_init;
+
+	/* Ticks spent in each initialization state, reported once the controller is ready */
+	uint64_t			init_state_ticks[NVME_CTRLR_STATE_COUNT];
+	uint64_t			init_state_start_tick;
+
 	uint64_t			next_keep_alive_tick;
 	uint64_t			keep_alive_interval_ticks;
 
@@ -1213,6 +1267,11 @@ int nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 		    struct spdk_nvme_ctrlr *ctrlr,
 		    enum spdk_nvme_qprio qprio,
 		    uint32_t num_requests, bool async);
+int	nvme_qpair_init_child_requests(struct spdk_nvme_qpair *qpair, uint32_t num_child_requests);
+int	nvme_qpair_init_submit_ring(struct spdk_nvme_qpair *qpair, uint32_t submit_ring_size);
+int	nvme_qpair_process_msgs(struct spdk_nvme_qpair *qpair);
+bool	nvme_qpair_stripes_disconnected(struct spdk_nvme_qpair *qpair);
+void	nvme_qpair_tally_latency(struct spdk_nvme_qpair *qpair, struct nvme_request *req);
 void	nvme_qpair_deinit(struct spdk_nvme_qpair *qpair);
 void	nvme_qpair_complete_error_reqs(struct spdk_nvme_qpair *qpair);
 int	nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair,
@@ -1328,6 +1387,38 @@ nvme_allocate_request_null(struct spdk_nvme_qpair *qpair, spdk_nvme_cmd_cb cb_fn
 	return nvme_allocate_request_contig(qpair, NULL, 0, cb_fn, cb_arg);
 }
 
+/*
+ * Allocate a request for a child of a split request. If the qpair has a child request arena,
+ * children are only taken from the arena so that splitting cannot starve top-level requests.
+ */
+static inline struct nvme_request *
+nvme_allocate_child_request(struct spdk_nvme_qpair *qpair,
+			    const struct nvme_payload *payload, uint32_t payload_size, uint32_t md_size,
+			    spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct nvme_request *req;
+
+	if (spdk_likely(qpair->child_req_buf == NULL)) {
+		return nvme_allocate_request(qpair, payload, payload_size, md_size, cb_fn, cb_arg);
+	}
+
+	req = STAILQ_FIRST(&qpair->free_child_req);
+	if (req == NULL) {
+		return req;
+	}
+
+	STAILQ_REMOVE_HEAD(&qpair->free_child_req, stailq);
+	qpair->num_free_child_reqs--;
+	qpair->num_outstanding_reqs++;
+
+	memset(req, 0, offsetof(struct nvme_request, payload_size));
+	req->child_arena = 1;
+
+	NVME_INIT_REQUEST(req, cb_fn, cb_arg, *payload, payload_size, md_size);
+
+	return req;
+}
+
 struct nvme_request *nvme_allocate_request_user_copy(struct spdk_nvme_qpair *qpair,
 		void *buffer, uint32_t payload_size,
 		spdk_nvme_cmd_cb cb_fn, void *cb_arg, bool host_to_controller);
@@ -1373,11 +1464,26 @@ nvme_complete_request(spdk_nvme_cmd_cb cb_fn, void *cb_arg, struct spdk_nvme_qpa
 		}
 	}
 
+	if (spdk_unlikely(qpair->latency != NULL)) {
+		nvme_qpair_tally_latency(qpair, req);
+	}
+
 	if (cb_fn) {
 		cb_fn(cb_arg, cpl);
 	}
 }
 
+static inline void
+nvme_qpair_put_free_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	if (spdk_unlikely(req->child_arena)) {
+		STAILQ_INSERT_HEAD(&qpair->free_child_req, req, stailq);
+		qpair->num_free_child_reqs++;
+	} else {
+		STAILQ_INSERT_HEAD(&qpair->free_req, req, stailq);
+	}
+}
+
 static inline void
 nvme_free_request(struct nvme_request *req)
 {
@@ -1389,7 +1495,7 @@ nvme_free_request(struct nvme_request *req)
 	 * saved only for use with a FABRICS/CONNECT command.
 	 */
 	if (spdk_likely(req->qpair->reserved_req != req)) {
-		STAILQ_INSERT_HEAD(&req->qpair->free_req, req, stailq);
+		nvme_qpair_put_free_request(req->qpair, req);
 
 		assert(req->qpair->num_outstanding_reqs > 0);
 		req->qpair->num_outstanding_reqs--;
@@ -1416,7 +1522,7 @@ nvme_qpair_free_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
 	assert(req != NULL);
 	assert(req->num_children == 0);
 
-	STAILQ_INSERT_HEAD(&qpair->free_req, req, stailq);
+	nvme_qpair_put_free_request(qpair, req);
 
 	assert(req->qpair->num_outstanding_reqs > 0);
 	req->qpair->num_outstanding_reqs--;
@@ -1565,6 +1671,7 @@ int nvme_transport_qpair_iterate_requests(struct spdk_nvme_qpair *qpair,
 
 struct spdk_nvme_transport_poll_group *nvme_transport_poll_group_create(
 	const struct spdk_nvme_transport *transport);
+int nvme_transport_qpair_get_fd(struct spdk_nvme_qpair *qpair);
 struct spdk_nvme_transport_poll_group *nvme_transport_qpair_get_optimal_poll_group(
 	const struct spdk_nvme_transport *transport,
 	struct spdk_nvme_qpair *qpair);
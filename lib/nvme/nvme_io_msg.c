@@ -6,7 +6,7 @@
 #include "nvme_internal.h"
 #include "nvme_io_msg.h"
 
-#define SPDK_NVME_MSG_IO_PROCESS_SIZE 8
+#define SPDK_NVME_MSG_IO_PROCESS_SIZE 32
 
 /**
  * Send message to IO queue.
@@ -18,13 +18,9 @@ nvme_io_msg_send(struct spdk_nvme_ctrlr *ctrlr, uint32_t nsid, spdk_nvme_io_msg_
 	int rc;
 	struct spdk_nvme_io_msg *io;
 
-	/* Protect requests ring against preemptive producers */
-	pthread_mutex_lock(&ctrlr->external_io_msgs_lock);
-
 	io = (struct spdk_nvme_io_msg *)calloc(1, sizeof(struct spdk_nvme_io_msg));
 	if (!io) {
 		SPDK_ERRLOG("IO msg allocation failed.");
-		pthread_mutex_unlock(&ctrlr->external_io_msgs_lock);
 		return -ENOMEM;
 	}
 
@@ -33,6 +29,9 @@ nvme_io_msg_send(struct spdk_nvme_ctrlr *ctrlr, uint32_t nsid, spdk_nvme_io_msg_
 	io->fn = fn;
 	io->arg = arg;
 
+	/* Protect requests ring against preemptive producers */
+	pthread_mutex_lock(&ctrlr->external_io_msgs_lock);
+
 	rc = spdk_ring_enqueue(ctrlr->external_io_msgs, (void **)&io, 1, NULL);
 	if (rc != 1) {
 		assert(false);
@@ -63,13 +62,8 @@ nvme_io_msg_process(struct spdk_nvme_ctrlr *ctrlr)
 		return 0;
 	}
 
-	spdk_nvme_qpair_process_completions(ctrlr->external_io_msgs_qpair, 0);
-
 	count = spdk_ring_dequeue(ctrlr->external_io_msgs, requests,
 				  SPDK_NVME_MSG_IO_PROCESS_SIZE);
-	if (count == 0) {
-		return 0;
-	}
 
 	for (i = 0; i < count; i++) {
 		io = requests[i];
@@ -80,6 +74,10 @@ nvme_io_msg_process(struct spdk_nvme_ctrlr *ctrlr)
 		free(io);
 	}
 
+	/* The qpair delays command submission, so the whole batch is submitted here with a single
+	 * doorbell write, along with reaping the completions. */
+	spdk_nvme_qpair_process_completions(ctrlr->external_io_msgs_qpair, 0);
+
 	return count;
 }
 
@@ -101,6 +99,8 @@ int
 nvme_io_msg_ctrlr_register(struct spdk_nvme_ctrlr *ctrlr,
 			   struct nvme_io_msg_producer *io_msg_producer)
 {
+	struct spdk_nvme_io_qpair_opts opts;
+
 	if (io_msg_producer == NULL) {
 		SPDK_ERRLOG("io_msg_producer cannot be NULL\n");
 		return -EINVAL;
@@ -127,7 +127,9 @@ nvme_io_msg_ctrlr_register(struct spdk_nvme_ctrlr *ctrlr,
 		return -ENOMEM;
 	}
 
-	ctrlr->external_io_msgs_qpair = spdk_nvme_ctrlr_alloc_io_qpair(ctrlr, NULL, 0);
+	spdk_nvme_ctrlr_get_default_io_qpair_opts(ctrlr, &opts, sizeof(opts));
+	opts.delay_cmd_submit = true;
+	ctrlr->external_io_msgs_qpair = spdk_nvme_ctrlr_alloc_io_qpair(ctrlr, &opts, sizeof(opts));
 	if (ctrlr->external_io_msgs_qpair == NULL) {
 		SPDK_ERRLOG("spdk_nvme_ctrlr_alloc_io_qpair() failed\n");
 		spdk_ring_free(ctrlr->external_io_msgs);
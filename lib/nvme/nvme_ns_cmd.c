@@ -8,8 +8,8 @@
 
 #include "nvme_internal.h"
 
-static inline struct nvme_request *_nvme_ns_cmd_rw(struct spdk_nvme_ns *ns,
-		struct spdk_nvme_qpair *qpair,
+static inline struct nvme_request *_nvme_ns_cmd_rw_setup(struct spdk_nvme_ns *ns,
+		struct spdk_nvme_qpair *qpair, struct nvme_request *req,
 		const struct nvme_payload *payload, uint32_t payload_offset, uint32_t md_offset,
 		uint64_t lba, uint32_t lba_count, spdk_nvme_cmd_cb cb_fn,
 		void *cb_arg, uint32_t opc, uint32_t io_flags,
@@ -80,10 +80,18 @@ _nvme_add_child_request(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 			uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag, uint32_t cdw13,
 			struct nvme_request *parent, bool check_sgl, int *rc)
 {
+	uint32_t		sector_size = _nvme_get_host_buffer_sector_size(ns, io_flags);
 	struct nvme_request	*child;
 
-	child = _nvme_ns_cmd_rw(ns, qpair, payload, payload_offset, md_offset, lba, lba_count, cb_fn,
-				cb_arg, opc, io_flags, apptag_mask, apptag, cdw13, check_sgl, NULL, rc);
+	child = nvme_allocate_child_request(qpair, payload, lba_count * sector_size,
+					    lba_count * ns->md_size, cb_fn, cb_arg);
+	if (child != NULL) {
+		child = _nvme_ns_cmd_rw_setup(ns, qpair, child, payload, payload_offset, md_offset, lba,
+					      lba_count, cb_fn, cb_arg, opc, io_flags, apptag_mask, apptag,
+					      cdw13, check_sgl, NULL, rc);
+	} else {
+		*rc = -ENOMEM;
+	}
 	if (child == NULL) {
 		nvme_request_free_children(parent);
 		nvme_free_request(parent);
@@ -94,6 +102,19 @@ _nvme_add_child_request(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 	return child;
 }
 
+static inline uint32_t
+_nvme_ns_cmd_split_num_children(uint64_t lba, uint32_t lba_count, uint32_t sectors_per_max_io,
+				uint32_t sector_mask)
+{
+	uint32_t first_lba_count = sectors_per_max_io - (lba & sector_mask);
+
+	if (lba_count <= first_lba_count) {
+		return 1;
+	}
+
+	return 1 + spdk_divide_round_up(lba_count - first_lba_count, sectors_per_max_io);
+}
+
 static struct nvme_request *
 _nvme_ns_cmd_split_request(struct spdk_nvme_ns *ns,
 			   struct spdk_nvme_qpair *qpair,
@@ -108,6 +129,7 @@ _nvme_ns_cmd_split_request(struct spdk_nvme_ns *ns,
 {
 	uint32_t		sector_size = _nvme_get_host_buffer_sector_size(ns, io_flags);
 	uint32_t		remaining_lba_count = lba_count;
+	uint32_t		num_children;
 	struct nvme_request	*child;
 
 	if (spdk_unlikely(accel_sequence != NULL)) {
@@ -116,6 +138,21 @@ _nvme_ns_cmd_split_request(struct spdk_nvme_ns *ns,
 		return NULL;
 	}
 
+	/*
+	 * Make sure the child request arena can take all the children before allocating any of
+	 * them, so that an I/O which cannot be split fully doesn't consume the arena only to be
+	 * torn down again.
+	 */
+	if (qpair->child_req_buf != NULL) {
+		num_children = _nvme_ns_cmd_split_num_children(lba, lba_count, sectors_per_max_io,
+				sector_mask);
+		if (spdk_unlikely(num_children > qpair->num_free_child_reqs)) {
+			*rc = num_children > qpair->num_child_reqs ? -EINVAL : -ENOMEM;
+			nvme_free_request(req);
+			return NULL;
+		}
+	}
+
 	while (remaining_lba_count > 0) {
 		lba_count = sectors_per_max_io - (lba & sector_mask);
 		lba_count = spdk_min(remaining_lba_count, lba_count);
@@ -416,27 +453,19 @@ _nvme_ns_cmd_split_request_sgl(struct spdk_nvme_ns *ns,
 }
 
 static inline struct nvme_request *
-_nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
-		const struct nvme_payload *payload, uint32_t payload_offset, uint32_t md_offset,
-		uint64_t lba, uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t opc,
-		uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag, uint32_t cdw13, bool check_sgl,
-		void *accel_sequence, int *rc)
+_nvme_ns_cmd_rw_setup(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+		      struct nvme_request *req,
+		      const struct nvme_payload *payload, uint32_t payload_offset, uint32_t md_offset,
+		      uint64_t lba, uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t opc,
+		      uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag, uint32_t cdw13,
+		      bool check_sgl, void *accel_sequence, int *rc)
 {
-	struct nvme_request	*req;
-	uint32_t		sector_size = _nvme_get_host_buffer_sector_size(ns, io_flags);
 	uint32_t		sectors_per_max_io = _nvme_get_sectors_per_max_io(ns, io_flags);
 	uint32_t		sectors_per_stripe = ns->sectors_per_stripe;
 
 	assert(rc != NULL);
 	assert(*rc == 0);
 
-	req = nvme_allocate_request(qpair, payload, lba_count * sector_size, lba_count * ns->md_size,
-				    cb_fn, cb_arg);
-	if (req == NULL) {
-		*rc = -ENOMEM;
-		return NULL;
-	}
-
 	req->payload_offset = payload_offset;
 	req->md_offset = md_offset;
 	req->accel_sequence = accel_sequence;
@@ -489,6 +518,31 @@ _nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 	return req;
 }
 
+static inline struct nvme_request *
+_nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+		const struct nvme_payload *payload, uint32_t payload_offset, uint32_t md_offset,
+		uint64_t lba, uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t opc,
+		uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag, uint32_t cdw13, bool check_sgl,
+		void *accel_sequence, int *rc)
+{
+	struct nvme_request	*req;
+	uint32_t		sector_size = _nvme_get_host_buffer_sector_size(ns, io_flags);
+
+	assert(rc != NULL);
+	assert(*rc == 0);
+
+	req = nvme_allocate_request(qpair, payload, lba_count * sector_size, lba_count * ns->md_size,
+				    cb_fn, cb_arg);
+	if (req == NULL) {
+		*rc = -ENOMEM;
+		return NULL;
+	}
+
+	return _nvme_ns_cmd_rw_setup(ns, qpair, req, payload, payload_offset, md_offset, lba, lba_count,
+				     cb_fn, cb_arg, opc, io_flags, apptag_mask, apptag, cdw13, check_sgl,
+				     accel_sequence, rc);
+}
+
 int
 spdk_nvme_ns_cmd_compare(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, void *buffer,
 			 uint64_t lba,
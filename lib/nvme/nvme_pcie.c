@@ -365,6 +365,7 @@ nvme_pcie_ctrlr_map_cmb(struct nvme_pcie_ctrlr *pctrlr)
 	pctrlr->cmb.bar_pa = bar_phys_addr;
 	pctrlr->cmb.size = size;
 	pctrlr->cmb.current_offset = offset;
+	pctrlr->cmb.sqs_supported = cmbsz.bits.sqs;
 
 	if (!cmbsz.bits.sqs) {
 		pctrlr->ctrlr.opts.use_cmb_sqs = false;
@@ -879,6 +880,75 @@ nvme_pcie_ctrlr_scan(struct spdk_nvme_probe_ctx *probe_ctx,
 	}
 }
 
+#define PCI_CAP_LIST_PTR	0x34
+#define PCI_CAP_ID_MSIX		0x11
+
+static uint16_t
+nvme_pcie_ctrlr_get_msix_vectors(struct spdk_pci_device *pci_dev)
+{
+	uint8_t cap_ptr, cap_id;
+	uint16_t msg_ctrl;
+	int i;
+
+	spdk_pci_device_cfg_read8(pci_dev, &cap_ptr, PCI_CAP_LIST_PTR);
+
+	/* Bound the walk in case the capability list is corrupted */
+	for (i = 0; i < 48 && cap_ptr >= 0x40; i++) {
+		cap_ptr &= ~0x3;
+		spdk_pci_device_cfg_read8(pci_dev, &cap_id, cap_ptr);
+		if (cap_id == PCI_CAP_ID_MSIX) {
+			/* Message Control, Table Size is N - 1 */
+			spdk_pci_device_cfg_read16(pci_dev, &msg_ctrl, cap_ptr + 2);
+			return (msg_ctrl & 0x7ff) + 1;
+		}
+		spdk_pci_device_cfg_read8(pci_dev, &cap_ptr, cap_ptr + 1);
+	}
+
+	return 0;
+}
+
+static void
+nvme_pcie_ctrlr_enable_interrupts(struct nvme_pcie_ctrlr *pctrlr)
+{
+	struct spdk_pci_device *pci_dev = pctrlr->devhandle;
+	uint32_t num_vectors;
+	int rc;
+
+	/* Vector 0 is used by the admin queue, which is always polled. */
+	num_vectors = nvme_pcie_ctrlr_get_msix_vectors(pci_dev);
+	if (num_vectors < 2) {
+		SPDK_NOTICELOG("%s: MSI-X not available, I/O qpairs are polled\n",
+			       pctrlr->ctrlr.trid.traddr);
+		pctrlr->ctrlr.opts.enable_interrupts = false;
+		return;
+	}
+
+	num_vectors = spdk_min(num_vectors - 1, pctrlr->ctrlr.opts.num_io_queues);
+	num_vectors = spdk_min(num_vectors, UINT16_MAX);
+
+	rc = spdk_pci_device_enable_interrupts(pci_dev, num_vectors);
+	if (rc != 0) {
+		SPDK_NOTICELOG("%s: failed to enable %u interrupt vectors (%d), I/O qpairs are polled\n",
+			       pctrlr->ctrlr.trid.traddr, num_vectors, rc);
+		pctrlr->ctrlr.opts.enable_interrupts = false;
+		return;
+	}
+
+	pctrlr->num_io_intr_vectors = num_vectors;
+}
+
+static int
+nvme_pcie_qpair_get_fd(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(qpair->ctrlr);
+
+	if (qpair->id > pctrlr->num_io_intr_vectors || !spdk_process_is_primary()) {
+		return -ENOTSUP;
+	}
+
+	return spdk_pci_device_get_interrupt_efd_by_index(pctrlr->devhandle, qpair->id);
+}
+
 static struct spdk_nvme_ctrlr *
 	nvme_pcie_ctrlr_construct(const struct spdk_nvme_transport_id *trid,
 			  const struct spdk_nvme_ctrlr_opts *opts,
@@ -935,6 +1005,10 @@ static struct spdk_nvme_ctrlr *
 	cmd_reg |= 0x404;
 	spdk_pci_device_cfg_write16(pci_dev, cmd_reg, 4);
 
+	if (pctrlr->ctrlr.opts.enable_interrupts) {
+		nvme_pcie_ctrlr_enable_interrupts(pctrlr);
+	}
+
 	if (nvme_ctrlr_get_cap(&pctrlr->ctrlr, &cap)) {
 		SPDK_ERRLOG("get_cap() failed\n");
 		spdk_pci_device_unclaim(pci_dev);
@@ -1015,6 +1089,9 @@ nvme_pcie_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
 	nvme_pcie_ctrlr_free_bars(pctrlr);
 
 	if (devhandle) {
+		if (pctrlr->num_io_intr_vectors != 0) {
+			spdk_pci_device_disable_interrupts(devhandle);
+		}
 		spdk_pci_device_unclaim(devhandle);
 		spdk_pci_device_detach(devhandle);
 	}
@@ -1103,6 +1180,7 @@ const struct spdk_nvme_transport_ops pcie_ops = {
 	.qpair_submit_request = nvme_pcie_qpair_submit_request,
 	.qpair_process_completions = nvme_pcie_qpair_process_completions,
 	.qpair_iterate_requests = nvme_pcie_qpair_iterate_requests,
+	.qpair_get_fd = nvme_pcie_qpair_get_fd,
 	.admin_qpair_abort_aers = nvme_pcie_admin_qpair_abort_aers,
 
 	.poll_group_create = nvme_pcie_poll_group_create,
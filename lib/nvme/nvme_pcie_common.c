@@ -35,6 +35,26 @@ nvme_pcie_vtophys(struct spdk_nvme_ctrlr *ctrlr, const void *buf, uint64_t *size
 	}
 }
 
+static inline int
+nvme_pcie_vtophys_pages(struct spdk_nvme_ctrlr *ctrlr, const void *buf, uint64_t len,
+			uint32_t page_size, uint64_t *paddrs, uint32_t count)
+{
+	uintptr_t addr = (uintptr_t)buf;
+	uint32_t i;
+
+	if (spdk_likely(ctrlr->trid.trtype == SPDK_NVME_TRANSPORT_PCIE)) {
+		return spdk_vtophys_pages(buf, len, page_size, paddrs, count);
+	}
+
+	/* vfio-user address translation with IOVA=VA mode */
+	for (i = 0; i < count && addr < (uintptr_t)buf + len; i++) {
+		paddrs[i] = addr;
+		addr = (addr & ~((uintptr_t)page_size - 1)) + page_size;
+	}
+
+	return i;
+}
+
 int
 nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 {
@@ -43,6 +63,7 @@ nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 
 	/* all head/tail vals are set to 0 */
 	pqpair->last_sq_tail = pqpair->sq_tail = pqpair->sq_head = pqpair->cq_head = 0;
+	pqpair->cq_doorbell_pending = 0;
 
 	/*
 	 * First time through the completion queue, HW will set phase
@@ -60,11 +81,97 @@ nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 }
 
 static void
-nvme_qpair_construct_tracker(struct nvme_tracker *tr, uint16_t cid, uint64_t phys_addr)
+nvme_qpair_construct_tracker(struct nvme_tracker *tr, uint16_t cid)
 {
-	tr->prp_sgl_bus_addr = phys_addr + offsetof(struct nvme_tracker, u.prp);
 	tr->cid = cid;
 	tr->req = NULL;
+	tr->list = NULL;
+}
+
+/*
+ * Add a chunk of PRP/SGL lists to the slab of the qpair. The slab only grows up to one list per
+ *  tracker.
+ */
+static int
+nvme_pcie_qpair_grow_lists(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_pcie_qpair		*pqpair = nvme_pcie_qpair(qpair);
+	struct nvme_tracker_list	*chunk, *list;
+	uint16_t			i, count;
+
+	count = spdk_min(NVME_PCIE_TRACKER_LISTS_PER_CHUNK, pqpair->num_trackers - pqpair->num_lists);
+	if (count == 0) {
+		return -ENOMEM;
+	}
+
+	chunk = spdk_zmalloc(count * sizeof(*chunk), sizeof(*chunk), NULL,
+			     SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+	if (chunk == NULL) {
+		SPDK_ERRLOG("Failed to allocate PRP/SGL lists\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < count; i++) {
+		list = &chunk[i];
+		list->bus_addr = nvme_pcie_vtophys(qpair->ctrlr, list, NULL);
+		if (list->bus_addr == SPDK_VTOPHYS_ERROR) {
+			SPDK_ERRLOG("vtophys(%p) failed\n", list);
+			spdk_free(chunk);
+			return -EFAULT;
+		}
+		list->bus_addr += offsetof(struct nvme_tracker_list, u.prp);
+	}
+
+	for (i = 0; i < count; i++) {
+		STAILQ_INSERT_HEAD(&pqpair->free_lists, &chunk[i], stailq);
+	}
+
+	chunk->next_chunk = pqpair->list_chunks;
+	pqpair->list_chunks = chunk;
+	pqpair->num_lists += count;
+
+	return 0;
+}
+
+static void
+nvme_pcie_qpair_free_lists(struct nvme_pcie_qpair *pqpair)
+{
+	struct nvme_tracker_list *chunk;
+
+	while ((chunk = pqpair->list_chunks) != NULL) {
+		pqpair->list_chunks = chunk->next_chunk;
+		spdk_free(chunk);
+	}
+
+	STAILQ_INIT(&pqpair->free_lists);
+	pqpair->num_lists = 0;
+}
+
+/*
+ * Get the PRP/SGL list of a tracker, taking one from the slab on first use. Submitting a request
+ *  makes sure that a free list is available, and a request uses at most one list.
+ */
+static inline struct nvme_tracker_list *
+nvme_pcie_tracker_get_list(struct spdk_nvme_qpair *qpair, struct nvme_tracker *tr)
+{
+	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
+
+	if (tr->list == NULL) {
+		tr->list = STAILQ_FIRST(&pqpair->free_lists);
+		assert(tr->list != NULL);
+		STAILQ_REMOVE_HEAD(&pqpair->free_lists, stailq);
+	}
+
+	return tr->list;
+}
+
+static inline void
+nvme_pcie_tracker_put_list(struct nvme_pcie_qpair *pqpair, struct nvme_tracker *tr)
+{
+	if (tr->list != NULL) {
+		STAILQ_INSERT_HEAD(&pqpair->free_lists, tr->list, stailq);
+		tr->list = NULL;
+	}
 }
 
 static void *
@@ -84,7 +191,7 @@ nvme_pcie_ctrlr_alloc_cmb(struct spdk_nvme_ctrlr *ctrlr, uint64_t size, uint64_t
 
 	/* CMB may only consume part of the BAR, calculate accordingly */
 	if (addr + size > ((uintptr_t)pctrlr->cmb.bar_va + pctrlr->cmb.size)) {
-		SPDK_ERRLOG("Tried to allocate past valid CMB range!\n");
+		SPDK_DEBUGLOG(nvme, "Tried to allocate past valid CMB range\n");
 		return NULL;
 	}
 	*phys_addr = pctrlr->cmb.bar_pa + addr - (uintptr_t)pctrlr->cmb.bar_va;
@@ -109,8 +216,10 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 	uint32_t                flags = SPDK_MALLOC_DMA;
 	uint64_t		sq_paddr = 0;
 	uint64_t		cq_paddr = 0;
+	bool			use_cmb_sq = ctrlr->opts.use_cmb_sqs;
 
 	if (opts) {
+		use_cmb_sq = opts->use_cmb_sq;
 		pqpair->sq_vaddr = opts->sq.vaddr;
 		pqpair->cq_vaddr = opts->cq.vaddr;
 		sq_paddr = opts->sq.paddr;
@@ -129,6 +238,13 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 	pqpair->max_completions_cap = spdk_min(pqpair->max_completions_cap, NVME_MAX_COMPLETIONS);
 	num_trackers = pqpair->num_entries - pqpair->max_completions_cap;
 
+	/*
+	 * Completions not reported to the controller yet still occupy CQ entries. The CQ has
+	 * max_completions_cap more entries than trackers, so it cannot overflow as long as the
+	 * head doorbell is not held back for more completions than that.
+	 */
+	pqpair->cq_doorbell_batch = spdk_min(pqpair->cq_doorbell_batch, pqpair->max_completions_cap);
+
 	SPDK_INFOLOG(nvme, "max_completions_cap = %" PRIu16 " num_trackers = %" PRIu16 "\n",
 		     pqpair->max_completions_cap, num_trackers);
 
@@ -141,11 +257,14 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 	}
 
 	/* cmd and cpl rings must be aligned on page size boundaries. */
-	if (ctrlr->opts.use_cmb_sqs) {
+	if (use_cmb_sq && pctrlr->cmb.sqs_supported) {
 		pqpair->cmd = nvme_pcie_ctrlr_alloc_cmb(ctrlr, pqpair->num_entries * sizeof(struct spdk_nvme_cmd),
 							page_align, &pqpair->cmd_bus_addr);
 		if (pqpair->cmd != NULL) {
 			pqpair->sq_in_cmb = true;
+		} else {
+			SPDK_INFOLOG(nvme, "No CMB space left for the SQ of qpair %u, using host memory\n",
+				     qpair->id);
 		}
 	}
 
@@ -203,9 +322,8 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 
 	/*
 	 * Reserve space for all of the trackers in a single allocation.
-	 *   struct nvme_tracker must be padded so that its size is already a power of 2.
-	 *   This ensures the PRP list embedded in the nvme_tracker object will not span a
-	 *   4KB boundary, while allowing access to trackers in tr[] via normal array indexing.
+	 *   The trackers only hold the hot per-command state, the PRP lists and SGL segments are
+	 *   taken from a separate slab by the requests that need them.
 	 */
 	pqpair->tr = spdk_zmalloc(num_trackers * sizeof(*tr), sizeof(*tr), NULL,
 				  SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
@@ -219,10 +337,16 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 
 	for (i = 0; i < num_trackers; i++) {
 		tr = &pqpair->tr[i];
-		nvme_qpair_construct_tracker(tr, i, nvme_pcie_vtophys(ctrlr, tr, NULL));
+		nvme_qpair_construct_tracker(tr, i);
 		TAILQ_INSERT_HEAD(&pqpair->free_tr, tr, tq_list);
 	}
 
+	STAILQ_INIT(&pqpair->free_lists);
+	pqpair->num_trackers = num_trackers;
+	if (nvme_pcie_qpair_grow_lists(qpair) != 0) {
+		return -ENOMEM;
+	}
+
 	nvme_pcie_qpair_reset(qpair);
 
 	return 0;
@@ -353,6 +477,10 @@ nvme_pcie_ctrlr_cmd_create_io_cq(struct spdk_nvme_ctrlr *ctrlr,
 	cmd->cdw10_bits.create_io_q.qsize = pqpair->num_entries - 1;
 
 	cmd->cdw11_bits.create_io_cq.pc = 1;
+	if (io_que->id <= nvme_pcie_ctrlr(ctrlr)->num_io_intr_vectors) {
+		cmd->cdw11_bits.create_io_cq.ien = 1;
+		cmd->cdw11_bits.create_io_cq.iv = io_que->id;
+	}
 	cmd->dptr.prp.prp1 = pqpair->cpl_bus_addr;
 
 	return nvme_ctrlr_submit_admin_request(ctrlr, req);
@@ -662,6 +790,16 @@ nvme_pcie_qpair_submit_tracker(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 
 	if (!pqpair->flags.delay_cmd_submit) {
 		nvme_pcie_qpair_ring_sq_doorbell(qpair);
+	} else if (pqpair->sq_doorbell_batch != 0 &&
+		   qpair->last_fuse != SPDK_NVME_IO_FLAGS_FUSE_FIRST) {
+		uint16_t pending = pqpair->sq_tail >= pqpair->last_sq_tail ?
+				   pqpair->sq_tail - pqpair->last_sq_tail :
+				   pqpair->num_entries - pqpair->last_sq_tail + pqpair->sq_tail;
+
+		if (pending >= pqpair->sq_doorbell_batch) {
+			nvme_pcie_qpair_ring_sq_doorbell(qpair);
+			pqpair->last_sq_tail = pqpair->sq_tail;
+		}
 	}
 }
 
@@ -716,6 +854,7 @@ nvme_pcie_qpair_complete_tracker(struct spdk_nvme_qpair *qpair, struct nvme_trac
 		}
 
 		tr->req = NULL;
+		nvme_pcie_tracker_put_list(pqpair, tr);
 
 		TAILQ_INSERT_HEAD(&pqpair->free_tr, tr, tq_list);
 	}
@@ -791,10 +930,16 @@ nvme_pcie_qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr)
 	nvme_pcie_qpair_abort_trackers(qpair, dnr);
 }
 
+/*
+ * Timeouts are checked at a granularity of 1/NVME_PCIE_TIMEOUT_BUCKETS of the timeout, so
+ * requests submitted within the same bucket are checked together.
+ */
+#define NVME_PCIE_TIMEOUT_BUCKETS	16
+
 static void
 nvme_pcie_qpair_check_timeout(struct spdk_nvme_qpair *qpair)
 {
-	uint64_t t02;
+	uint64_t t02, timeout_ticks, bucket_ticks, next_tick;
 	struct nvme_tracker *tr, *tmp;
 	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
 	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
@@ -816,7 +961,21 @@ nvme_pcie_qpair_check_timeout(struct spdk_nvme_qpair *qpair)
 		return;
 	}
 
+	timeout_ticks = nvme_qpair_is_admin_queue(qpair) ?
+			active_proc->timeout_admin_ticks : active_proc->timeout_io_ticks;
 	t02 = spdk_get_ticks();
+
+	/* Nothing outstanding can have timed out before the next check of its bucket is due. */
+	if (spdk_likely(t02 < pqpair->timeout_check_tick &&
+			timeout_ticks == pqpair->timeout_check_ticks)) {
+		return;
+	}
+
+	/*
+	 * Requests submitted from now on can't time out before now + timeout, so that's when the
+	 * next check is due unless an outstanding request times out earlier.
+	 */
+	next_tick = t02 + timeout_ticks;
 	TAILQ_FOREACH_SAFE(tr, &pqpair->outstanding_tr, tq_list, tmp) {
 		assert(tr->req != NULL);
 
@@ -825,9 +984,14 @@ nvme_pcie_qpair_check_timeout(struct spdk_nvme_qpair *qpair)
 			 * The requests are in order, so as soon as one has not timed out,
 			 * stop iterating.
 			 */
+			next_tick = tr->req->submit_tick + timeout_ticks;
 			break;
 		}
 	}
+
+	bucket_ticks = spdk_max(timeout_ticks / NVME_PCIE_TIMEOUT_BUCKETS, 1);
+	pqpair->timeout_check_tick = SPDK_CEIL_DIV(next_tick, bucket_ticks) * bucket_ticks;
+	pqpair->timeout_check_ticks = timeout_ticks;
 }
 
 int32_t
@@ -945,9 +1109,17 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 
 	if (num_completions > 0) {
 		pqpair->stat->completions += num_completions;
-		nvme_pcie_qpair_ring_cq_doorbell(qpair);
+		pqpair->cq_doorbell_pending += num_completions;
+		if (pqpair->cq_doorbell_pending >= pqpair->cq_doorbell_batch) {
+			nvme_pcie_qpair_ring_cq_doorbell(qpair);
+			pqpair->cq_doorbell_pending = 0;
+		}
 	} else {
 		pqpair->stat->idle_polls++;
+		if (spdk_unlikely(pqpair->cq_doorbell_pending != 0)) {
+			nvme_pcie_qpair_ring_cq_doorbell(qpair);
+			pqpair->cq_doorbell_pending = 0;
+		}
 	}
 
 	if (pqpair->flags.delay_cmd_submit) {
@@ -1018,6 +1190,7 @@ nvme_pcie_qpair_destroy(struct spdk_nvme_qpair *qpair)
 	if (pqpair->tr) {
 		spdk_free(pqpair->tr);
 	}
+	nvme_pcie_qpair_free_lists(pqpair);
 
 	nvme_qpair_deinit(qpair);
 
@@ -1038,6 +1211,16 @@ nvme_pcie_qpair_destroy(struct spdk_nvme_qpair *qpair)
 	return 0;
 }
 
+bool
+spdk_nvme_qpair_is_sq_in_cmb(struct spdk_nvme_qpair *qpair)
+{
+	if (qpair->trtype != SPDK_NVME_TRANSPORT_PCIE) {
+		return false;
+	}
+
+	return nvme_pcie_qpair(qpair)->sq_in_cmb;
+}
+
 struct spdk_nvme_qpair *
 nvme_pcie_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr, uint16_t qid,
 				const struct spdk_nvme_io_qpair_opts *opts)
@@ -1056,6 +1239,8 @@ nvme_pcie_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr, uint16_t qid,
 
 	pqpair->num_entries = opts->io_queue_size;
 	pqpair->flags.delay_cmd_submit = opts->delay_cmd_submit;
+	pqpair->sq_doorbell_batch = opts->sq_doorbell_batch;
+	pqpair->cq_doorbell_batch = opts->cq_doorbell_batch;
 
 	qpair = &pqpair->qpair;
 
@@ -1195,14 +1380,17 @@ nvme_pcie_fail_request_bad_vtophys(struct spdk_nvme_qpair *qpair, struct nvme_tr
  * *prp_index will be updated to account for the number of PRP entries used.
  */
 static inline int
-nvme_pcie_prp_list_append(struct spdk_nvme_ctrlr *ctrlr, struct nvme_tracker *tr,
+nvme_pcie_prp_list_append(struct spdk_nvme_qpair *qpair, struct nvme_tracker *tr,
 			  uint32_t *prp_index, void *virt_addr, size_t len,
 			  uint32_t page_size)
 {
+	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
 	struct spdk_nvme_cmd *cmd = &tr->req->cmd;
+	struct nvme_tracker_list *list;
 	uintptr_t page_mask = page_size - 1;
-	uint64_t phys_addr;
-	uint32_t i;
+	uint64_t phys_addr, phys_addrs[NVME_PCIE_PRP_BATCH_SIZE];
+	uint32_t i, j;
+	int count;
 
 	SPDK_DEBUGLOG(nvme, "prp_index:%u virt_addr:%p len:%u\n",
 		      *prp_index, virt_addr, (uint32_t)len);
@@ -1214,52 +1402,65 @@ nvme_pcie_prp_list_append(struct spdk_nvme_ctrlr *ctrlr, struct nvme_tracker *tr
 
 	i = *prp_index;
 	while (len) {
-		uint32_t seg_len;
-
-		/*
-		 * prp_index 0 is stored in prp1, and the rest are stored in the prp[] array,
-		 * so prp_index == count is valid.
-		 */
-		if (spdk_unlikely(i > SPDK_COUNTOF(tr->u.prp))) {
-			SPDK_ERRLOG("out of PRP entries\n");
-			return -EFAULT;
-		}
-
-		phys_addr = nvme_pcie_vtophys(ctrlr, virt_addr, NULL);
-		if (spdk_unlikely(phys_addr == SPDK_VTOPHYS_ERROR)) {
+		/* Translate a batch of pages at once, rather than each page separately */
+		count = nvme_pcie_vtophys_pages(ctrlr, virt_addr, len, page_size, phys_addrs,
+						SPDK_COUNTOF(phys_addrs));
+		if (spdk_unlikely(count <= 0)) {
 			SPDK_ERRLOG("vtophys(%p) failed\n", virt_addr);
 			return -EFAULT;
 		}
 
-		if (i == 0) {
-			SPDK_DEBUGLOG(nvme, "prp1 = %p\n", (void *)phys_addr);
-			cmd->dptr.prp.prp1 = phys_addr;
-			seg_len = page_size - ((uintptr_t)virt_addr & page_mask);
-		} else {
-			if ((phys_addr & page_mask) != 0) {
-				SPDK_ERRLOG("PRP %u not page aligned (%p)\n", i, virt_addr);
+		for (j = 0; j < (uint32_t)count; j++) {
+			uint32_t seg_len;
+
+			/*
+			 * prp_index 0 is stored in prp1, and the rest are stored in the prp[] array,
+			 * so prp_index == count is valid.
+			 */
+			if (spdk_unlikely(i > NVME_MAX_PRP_LIST_ENTRIES)) {
+				SPDK_ERRLOG("out of PRP entries\n");
 				return -EFAULT;
 			}
 
-			SPDK_DEBUGLOG(nvme, "prp[%u] = %p\n", i - 1, (void *)phys_addr);
-			tr->u.prp[i - 1] = phys_addr;
-			seg_len = page_size;
-		}
+			phys_addr = phys_addrs[j];
+			if (i == 0) {
+				SPDK_DEBUGLOG(nvme, "prp1 = %p\n", (void *)phys_addr);
+				cmd->dptr.prp.prp1 = phys_addr;
+				seg_len = page_size - ((uintptr_t)virt_addr & page_mask);
+			} else {
+				if ((phys_addr & page_mask) != 0) {
+					SPDK_ERRLOG("PRP %u not page aligned (%p)\n", i, virt_addr);
+					return -EFAULT;
+				}
+
+				SPDK_DEBUGLOG(nvme, "prp[%u] = %p\n", i - 1, (void *)phys_addr);
+				if (i == 1) {
+					/* Stored in prp2 until a PRP list is needed */
+					cmd->dptr.prp.prp2 = phys_addr;
+				} else {
+					list = nvme_pcie_tracker_get_list(qpair, tr);
+					if (i == 2) {
+						list->u.prp[0] = cmd->dptr.prp.prp2;
+					}
+					list->u.prp[i - 1] = phys_addr;
+				}
+				seg_len = page_size;
+			}
 
-		seg_len = spdk_min(seg_len, len);
-		virt_addr = (uint8_t *)virt_addr + seg_len;
-		len -= seg_len;
-		i++;
+			seg_len = spdk_min(seg_len, len);
+			virt_addr = (uint8_t *)virt_addr + seg_len;
+			len -= seg_len;
+			i++;
+		}
 	}
 
 	cmd->psdt = SPDK_NVME_PSDT_PRP;
 	if (i <= 1) {
 		cmd->dptr.prp.prp2 = 0;
 	} else if (i == 2) {
-		cmd->dptr.prp.prp2 = tr->u.prp[0];
 		SPDK_DEBUGLOG(nvme, "prp2 = %p\n", (void *)cmd->dptr.prp.prp2);
 	} else {
-		cmd->dptr.prp.prp2 = tr->prp_sgl_bus_addr;
+		cmd->dptr.prp.prp2 = tr->list->bus_addr;
 		SPDK_DEBUGLOG(nvme, "prp2 = %p (PRP list)\n", (void *)cmd->dptr.prp.prp2);
 	}
 
@@ -1286,7 +1487,7 @@ nvme_pcie_qpair_build_contig_request(struct spdk_nvme_qpair *qpair, struct nvme_
 	uint32_t prp_index = 0;
 	int rc;
 
-	rc = nvme_pcie_prp_list_append(qpair->ctrlr, tr, &prp_index,
+	rc = nvme_pcie_prp_list_append(qpair, tr, &prp_index,
 				       (uint8_t *)req->payload.contig_or_cb_arg + req->payload_offset,
 				       req->payload_size, qpair->ctrlr->page_size);
 	if (rc) {
@@ -1296,6 +1497,21 @@ nvme_pcie_qpair_build_contig_request(struct spdk_nvme_qpair *qpair, struct nvme_
 	return rc;
 }
 
+/*
+ * The first SGL descriptor is built in SGL1 of the command. Move it to the SGL segment of the
+ *  tracker when a second descriptor is needed, and return where the second one goes.
+ */
+static inline struct spdk_nvme_sgl_descriptor *
+nvme_pcie_tracker_sgl_segment(struct spdk_nvme_qpair *qpair, struct nvme_request *req,
+			      struct nvme_tracker *tr)
+{
+	struct nvme_tracker_list *list = nvme_pcie_tracker_get_list(qpair, tr);
+
+	list->u.sgl[0] = req->cmd.dptr.sgl1;
+
+	return &list->u.sgl[1];
+}
+
 /**
  * Build an SGL describing a physically contiguous payload buffer.
  *
@@ -1315,7 +1531,7 @@ nvme_pcie_qpair_build_contig_hw_sgl_request(struct spdk_nvme_qpair *qpair, struc
 	assert(req->payload_size != 0);
 	assert(nvme_payload_type(&req->payload) == NVME_PAYLOAD_TYPE_CONTIG);
 
-	sgl = tr->u.sgl;
+	sgl = &req->cmd.dptr.sgl1;
 	req->cmd.psdt = SPDK_NVME_PSDT_SGL_MPTR_CONTIG;
 	req->cmd.dptr.sgl1.unkeyed.subtype = 0;
 
@@ -1348,6 +1564,10 @@ nvme_pcie_qpair_build_contig_hw_sgl_request(struct spdk_nvme_qpair *qpair, struc
 		length -= mapping_length;
 		virt_addr += mapping_length;
 
+		if (nseg == 1) {
+			sgl = nvme_pcie_tracker_sgl_segment(qpair, req, tr);
+		}
+
 		sgl->unkeyed.type = SPDK_NVME_SGL_TYPE_DATA_BLOCK;
 		sgl->unkeyed.length = mapping_length;
 		sgl->address = phys_addr;
@@ -1361,18 +1581,15 @@ nvme_pcie_qpair_build_contig_hw_sgl_request(struct spdk_nvme_qpair *qpair, struc
 		/*
 		 * The whole transfer can be described by a single SGL descriptor.
 		 *  Use the special case described by the spec where SGL1's type is Data Block.
-		 *  This means the SGL in the tracker is not used at all, so copy the first (and only)
-		 *  SGL element into SGL1.
+		 *  The descriptor was built in SGL1 and the tracker has no SGL segment at all.
 		 */
 		req->cmd.dptr.sgl1.unkeyed.type = SPDK_NVME_SGL_TYPE_DATA_BLOCK;
-		req->cmd.dptr.sgl1.address = tr->u.sgl[0].address;
-		req->cmd.dptr.sgl1.unkeyed.length = tr->u.sgl[0].unkeyed.length;
 	} else {
 		/* SPDK NVMe driver supports only 1 SGL segment for now, it is enough because
 		 *  NVME_MAX_SGL_DESCRIPTORS * 16 is less than one page.
 		 */
 		req->cmd.dptr.sgl1.unkeyed.type = SPDK_NVME_SGL_TYPE_LAST_SEGMENT;
-		req->cmd.dptr.sgl1.address = tr->prp_sgl_bus_addr;
+		req->cmd.dptr.sgl1.address = tr->list->bus_addr;
 		req->cmd.dptr.sgl1.unkeyed.length = nseg * sizeof(struct spdk_nvme_sgl_descriptor);
 	}
 
@@ -1402,7 +1619,7 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 	assert(req->payload.next_sge_fn != NULL);
 	req->payload.reset_sgl_fn(req->payload.contig_or_cb_arg, req->payload_offset);
 
-	sgl = tr->u.sgl;
+	sgl = &req->cmd.dptr.sgl1;
 	req->cmd.psdt = SPDK_NVME_PSDT_SGL_MPTR_CONTIG;
 	req->cmd.dptr.sgl1.unkeyed.subtype = 0;
 
@@ -1428,6 +1645,10 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 				goto exit;
 			}
 
+			if (nseg == 1) {
+				sgl = nvme_pcie_tracker_sgl_segment(qpair, req, tr);
+			}
+
 			sgl->unkeyed.type = SPDK_NVME_SGL_TYPE_BIT_BUCKET;
 			/* If the SGL describes a destination data buffer, the length of data
 			 * buffer shall be discarded by controller, and the length is included
@@ -1477,6 +1698,10 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 				continue;
 			}
 
+			if (nseg == 1) {
+				sgl = nvme_pcie_tracker_sgl_segment(qpair, req, tr);
+			}
+
 			sgl->unkeyed.type = SPDK_NVME_SGL_TYPE_DATA_BLOCK;
 			sgl->unkeyed.length = length;
 			sgl->address = phys_addr;
@@ -1491,18 +1716,15 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 		/*
 		 * The whole transfer can be described by a single SGL descriptor.
 		 *  Use the special case described by the spec where SGL1's type is Data Block.
-		 *  This means the SGL in the tracker is not used at all, so copy the first (and only)
-		 *  SGL element into SGL1.
+		 *  The descriptor was built in SGL1 and the tracker has no SGL segment at all.
 		 */
 		req->cmd.dptr.sgl1.unkeyed.type = SPDK_NVME_SGL_TYPE_DATA_BLOCK;
-		req->cmd.dptr.sgl1.address = tr->u.sgl[0].address;
-		req->cmd.dptr.sgl1.unkeyed.length = tr->u.sgl[0].unkeyed.length;
 	} else {
 		/* SPDK NVMe driver supports only 1 SGL segment for now, it is enough because
 		 *  NVME_MAX_SGL_DESCRIPTORS * 16 is less than one page.
 		 */
 		req->cmd.dptr.sgl1.unkeyed.type = SPDK_NVME_SGL_TYPE_LAST_SEGMENT;
-		req->cmd.dptr.sgl1.address = tr->prp_sgl_bus_addr;
+		req->cmd.dptr.sgl1.address = tr->list->bus_addr;
 		req->cmd.dptr.sgl1.unkeyed.length = nseg * sizeof(struct spdk_nvme_sgl_descriptor);
 	}
 
@@ -1553,7 +1775,7 @@ nvme_pcie_qpair_build_prps_sgl_request(struct spdk_nvme_qpair *qpair, struct nvm
 		assert((length == remaining_transfer_len) ||
 		       _is_page_aligned((uintptr_t)virt_addr + length, page_size));
 
-		rc = nvme_pcie_prp_list_append(qpair->ctrlr, tr, &prp_index, virt_addr, length, page_size);
+		rc = nvme_pcie_prp_list_append(qpair, tr, &prp_index, virt_addr, length, page_size);
 		if (rc) {
 			nvme_pcie_fail_request_bad_vtophys(qpair, tr);
 			return rc;
@@ -1589,6 +1811,7 @@ nvme_pcie_qpair_build_metadata(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 {
 	void *md_payload;
 	struct nvme_request *req = tr->req;
+	struct nvme_tracker_list *list;
 	uint64_t mapping_length;
 
 	if (req->payload.md) {
@@ -1603,14 +1826,15 @@ nvme_pcie_qpair_build_metadata(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 			assert(req->cmd.psdt == SPDK_NVME_PSDT_SGL_MPTR_CONTIG);
 			req->cmd.psdt = SPDK_NVME_PSDT_SGL_MPTR_SGL;
 
-			tr->meta_sgl.address = nvme_pcie_vtophys(qpair->ctrlr, md_payload, &mapping_length);
-			if (tr->meta_sgl.address == SPDK_VTOPHYS_ERROR || mapping_length != req->md_size) {
+			list = nvme_pcie_tracker_get_list(qpair, tr);
+			list->meta_sgl.address = nvme_pcie_vtophys(qpair->ctrlr, md_payload, &mapping_length);
+			if (list->meta_sgl.address == SPDK_VTOPHYS_ERROR || mapping_length != req->md_size) {
 				goto exit;
 			}
-			tr->meta_sgl.unkeyed.type = SPDK_NVME_SGL_TYPE_DATA_BLOCK;
-			tr->meta_sgl.unkeyed.length = req->md_size;
-			tr->meta_sgl.unkeyed.subtype = 0;
-			req->cmd.mptr = tr->prp_sgl_bus_addr - sizeof(struct spdk_nvme_sgl_descriptor);
+			list->meta_sgl.unkeyed.type = SPDK_NVME_SGL_TYPE_DATA_BLOCK;
+			list->meta_sgl.unkeyed.length = req->md_size;
+			list->meta_sgl.unkeyed.subtype = 0;
+			req->cmd.mptr = list->bus_addr - sizeof(struct spdk_nvme_sgl_descriptor);
 		} else {
 			req->cmd.mptr = nvme_pcie_vtophys(qpair->ctrlr, md_payload, &mapping_length);
 			if (req->cmd.mptr == SPDK_VTOPHYS_ERROR || mapping_length != req->md_size) {
@@ -1651,6 +1875,17 @@ nvme_pcie_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_reques
 		goto exit;
 	}
 
+	/*
+	 * Building the request may need a PRP list or an SGL segment, make sure one is free. If the
+	 *  slab can't grow, fail the request so that the caller retries it, instead of queueing it
+	 *  until a completion resubmits it.
+	 */
+	if (spdk_unlikely(STAILQ_EMPTY(&pqpair->free_lists)) && req->payload_size != 0 &&
+	    nvme_pcie_qpair_grow_lists(qpair) != 0) {
+		rc = -ENOMEM;
+		goto exit;
+	}
+
 	pqpair->stat->submitted_requests++;
 	TAILQ_REMOVE(&pqpair->free_tr, tr, tq_list); /* remove tr from free_tr */
 	TAILQ_INSERT_TAIL(&pqpair->outstanding_tr, tr, tq_list);
@@ -1659,6 +1894,12 @@ nvme_pcie_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_reques
 	tr->cb_arg = req->cb_arg;
 	req->cmd.cid = tr->cid;
 
+	/* A request queued for a while may time out before the next check, reschedule it. */
+	if (spdk_unlikely(req->submit_tick != 0) &&
+	    req->submit_tick + pqpair->timeout_check_ticks < pqpair->timeout_check_tick) {
+		pqpair->timeout_check_tick = 0;
+	}
+
 	if (req->payload_size != 0) {
 		payload_type = nvme_payload_type(&req->payload);
 		/* According to the specification, PRPs shall be used for all
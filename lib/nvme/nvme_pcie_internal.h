@@ -21,6 +21,14 @@
 
 #define NVME_MAX_PRP_LIST_ENTRIES	(503)
 
+/* Number of pages translated at once while building a PRP list, enough for a 128KiB I/O */
+#define NVME_PCIE_PRP_BATCH_SIZE	(33)
+
+/*
+ * Number of PRP/SGL list pages added to the per-qpair list slab at a time.
+ */
+#define NVME_PCIE_TRACKER_LISTS_PER_CHUNK	(16)
+
 /* Minimum admin queue size */
 #define NVME_PCIE_MIN_ADMIN_QUEUE_SIZE	(256)
 
@@ -47,6 +55,9 @@ struct nvme_pcie_ctrlr {
 		/* Current offset of controller memory buffer, relative to start of BAR virt addr */
 		uint64_t current_offset;
 
+		/* Controller supports submission queues in the controller memory buffer */
+		bool sqs_supported;
+
 		void *mem_register_addr;
 		size_t mem_register_size;
 	} cmb;
@@ -74,11 +85,45 @@ struct nvme_pcie_ctrlr {
 	/* Flag to indicate the MMIO register has been remapped */
 	bool is_remapped;
 
+	/* Number of interrupt vectors for I/O qpairs, vector N is used by the qpair with ID N */
+	uint16_t num_io_intr_vectors;
+
 	volatile uint32_t *doorbell_base;
 };
 
 extern __thread struct nvme_pcie_ctrlr *g_thread_mmio_ctrlr;
 
+/*
+ * PRP list or SGL segment of a request, taken from the per-qpair slab only by the requests that
+ *  cannot be described by the PRP/SGL entries of the command itself.
+ */
+struct nvme_tracker_list {
+	/* Don't move, metadata SGL is always contiguous with Data Block SGL */
+	struct spdk_nvme_sgl_descriptor		meta_sgl;
+	union {
+		uint64_t			prp[NVME_MAX_PRP_LIST_ENTRIES];
+		struct spdk_nvme_sgl_descriptor	sgl[NVME_MAX_SGL_DESCRIPTORS];
+	} u;
+
+	/* Bus address of u */
+	uint64_t				bus_addr;
+	STAILQ_ENTRY(nvme_tracker_list)		stailq;
+
+	/* Next chunk of the slab, only valid in the first list of each chunk */
+	struct nvme_tracker_list		*next_chunk;
+
+	uint8_t					reserved[32];
+};
+/*
+ * struct nvme_tracker_list must be exactly 4K so that the prp[] array does not cross a page
+ * boundary and so that there is no padding required to meet alignment requirements.
+ */
+SPDK_STATIC_ASSERT(sizeof(struct nvme_tracker_list) == 4096, "nvme_tracker_list is not 4K");
+SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker_list, u.sgl) & 7) == 0,
+		   "SGL must be Qword aligned");
+SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker_list, meta_sgl) & 7) == 0,
+		   "SGL must be Qword aligned");
+
 struct nvme_tracker {
 	TAILQ_ENTRY(nvme_tracker)       tq_list;
 
@@ -92,22 +137,14 @@ struct nvme_tracker {
 	spdk_nvme_cmd_cb		cb_fn;
 	void				*cb_arg;
 
-	uint64_t			prp_sgl_bus_addr;
-
-	/* Don't move, metadata SGL is always contiguous with Data Block SGL */
-	struct spdk_nvme_sgl_descriptor		meta_sgl;
-	union {
-		uint64_t			prp[NVME_MAX_PRP_LIST_ENTRIES];
-		struct spdk_nvme_sgl_descriptor	sgl[NVME_MAX_SGL_DESCRIPTORS];
-	} u;
+	/* PRP list or SGL segment, NULL if the command describes the whole payload */
+	struct nvme_tracker_list	*list;
+	uint64_t			rsvd2;
 };
 /*
- * struct nvme_tracker must be exactly 4K so that the prp[] array does not cross a page boundary
- * and so that there is no padding required to meet alignment requirements.
+ * struct nvme_tracker is kept to a single cache line so that the array of trackers stays dense.
  */
-SPDK_STATIC_ASSERT(sizeof(struct nvme_tracker) == 4096, "nvme_tracker is not 4K");
-SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker, u.sgl) & 7) == 0, "SGL must be Qword aligned");
-SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker, meta_sgl) & 7) == 0, "SGL must be Qword aligned");
+SPDK_STATIC_ASSERT(sizeof(struct nvme_tracker) == 64, "nvme_tracker is not 64 bytes");
 
 struct nvme_pcie_poll_group {
 	struct spdk_nvme_transport_poll_group group;
@@ -141,6 +178,9 @@ struct nvme_pcie_qpair {
 	/* Array of trackers indexed by command ID. */
 	struct nvme_tracker *tr;
 
+	/* PRP lists and SGL segments not used by any tracker */
+	STAILQ_HEAD(, nvme_tracker_list) free_lists;
+
 	struct spdk_nvme_pcie_stat *stat;
 
 	uint16_t num_entries;
@@ -156,6 +196,12 @@ struct nvme_pcie_qpair {
 	uint16_t cq_head;
 	uint16_t sq_head;
 
+	/* Doorbell coalescing, see spdk_nvme_io_qpair_opts */
+	uint16_t sq_doorbell_batch;
+	uint16_t cq_doorbell_batch;
+	/* Completions processed since the last CQ head doorbell write */
+	uint16_t cq_doorbell_pending;
+
 	struct {
 		uint8_t phase			: 1;
 		uint8_t delay_cmd_submit	: 1;
@@ -185,6 +231,14 @@ struct nvme_pcie_qpair {
 		volatile uint32_t *cq_eventidx;
 	} shadow_doorbell;
 
+	/*
+	 * Outstanding trackers are not checked for timeouts before this tick. It is kept at the
+	 * granularity of a timeout bucket, see nvme_pcie_qpair_check_timeout().
+	 */
+	uint64_t timeout_check_tick;
+	/* Timeout the above was computed for, so that changing it takes effect right away */
+	uint64_t timeout_check_ticks;
+
 	/*
 	 * Fields below this point should not be touched on the normal I/O path.
 	 */
@@ -197,6 +251,11 @@ struct nvme_pcie_qpair {
 
 	struct spdk_nvme_cmd *sq_vaddr;
 	struct spdk_nvme_cpl *cq_vaddr;
+
+	/* Chunks of the PRP/SGL list slab, linked through their first list */
+	struct nvme_tracker_list *list_chunks;
+	uint16_t num_lists;
+	uint16_t num_trackers;
 };
 
 static inline struct nvme_pcie_qpair *
@@ -6,6 +6,8 @@
 
 #include "nvme_internal.h"
 
+#include "spdk/fd_group.h"
+
 struct spdk_nvme_poll_group *
 spdk_nvme_poll_group_create(void *ctx, struct spdk_nvme_accel_fn_table *table)
 {
@@ -75,11 +77,74 @@ spdk_nvme_qpair_get_optimal_poll_group(struct spdk_nvme_qpair *qpair)
 	return tgroup->group;
 }
 
+static int
+nvme_poll_group_create_fd_group(struct spdk_nvme_poll_group *group)
+{
+	if (group->fgrp != NULL) {
+		return 0;
+	}
+
+	return spdk_fd_group_create(&group->fgrp);
+}
+
+static int
+nvme_poll_group_qpair_intr(void *ctx)
+{
+	struct spdk_nvme_qpair *qpair = ctx;
+	uint64_t count;
+	int fd;
+
+	fd = spdk_nvme_qpair_get_fd(qpair);
+	if (fd < 0) {
+		return fd;
+	}
+
+	/* Only clear the eventfd, the completions are processed for the whole group. */
+	if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+static int
+nvme_poll_group_add_qpair_fd(struct spdk_nvme_poll_group *group, struct spdk_nvme_qpair *qpair)
+{
+	int fd, rc;
+
+	fd = spdk_nvme_qpair_get_fd(qpair);
+	if (fd < 0) {
+		return 0;
+	}
+
+	rc = nvme_poll_group_create_fd_group(group);
+	if (rc != 0) {
+		return rc;
+	}
+
+	return SPDK_FD_GROUP_ADD(group->fgrp, fd, nvme_poll_group_qpair_intr, qpair);
+}
+
+static void
+nvme_poll_group_remove_qpair_fd(struct spdk_nvme_poll_group *group, struct spdk_nvme_qpair *qpair)
+{
+	int fd;
+
+	fd = spdk_nvme_qpair_get_fd(qpair);
+	if (fd < 0 || group->fgrp == NULL) {
+		return;
+	}
+
+	spdk_fd_group_remove(group->fgrp, fd);
+}
+
 int
 spdk_nvme_poll_group_add(struct spdk_nvme_poll_group *group, struct spdk_nvme_qpair *qpair)
 {
 	struct spdk_nvme_transport_poll_group *tgroup;
 	const struct spdk_nvme_transport *transport;
+	uint16_t i;
+	int rc;
 
 	if (nvme_qpair_get_state(qpair) != NVME_QPAIR_DISCONNECTED) {
 		return -EINVAL;
@@ -108,7 +173,43 @@ spdk_nvme_poll_group_add(struct spdk_nvme_poll_group *group, struct spdk_nvme_qp
 		}
 	}
 
-	return tgroup ? nvme_transport_poll_group_add(tgroup, qpair) : -ENODEV;
+	if (tgroup == NULL) {
+		return -ENODEV;
+	}
+
+	/* The connections of a striped qpair go first, see nvme_poll_group_disconnected_qpair_cb(). */
+	for (i = 0; i < qpair->num_stripes; i++) {
+		rc = nvme_transport_poll_group_add(tgroup, qpair->stripes[i]);
+		if (rc != 0) {
+			goto err_stripes;
+		}
+	}
+
+	rc = nvme_transport_poll_group_add(tgroup, qpair);
+	if (rc != 0) {
+		goto err_stripes;
+	}
+
+	rc = nvme_poll_group_add_qpair_fd(group, qpair);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to add the interrupt of qpair %u to the poll group\n",
+			    qpair->id);
+		nvme_transport_poll_group_remove(tgroup, qpair);
+		goto err_stripes;
+	}
+
+	if (qpair->submit_ring != NULL) {
+		group->num_shared_qpairs++;
+	}
+
+	return 0;
+
+err_stripes:
+	while (i > 0) {
+		nvme_transport_poll_group_remove(tgroup, qpair->stripes[--i]);
+	}
+
+	return rc;
 }
 
 int
@@ -116,9 +217,27 @@ spdk_nvme_poll_group_remove(struct spdk_nvme_poll_group *group, struct spdk_nvme
 {
 	struct spdk_nvme_transport_poll_group *tgroup;
 
+	uint16_t i;
+	int rc;
+
 	STAILQ_FOREACH(tgroup, &group->tgroups, link) {
 		if (tgroup->transport == qpair->transport) {
-			return nvme_transport_poll_group_remove(tgroup, qpair);
+			rc = nvme_transport_poll_group_remove(tgroup, qpair);
+			if (rc != 0) {
+				return rc;
+			}
+
+			nvme_poll_group_remove_qpair_fd(group, qpair);
+			for (i = 0; i < qpair->num_stripes; i++) {
+				nvme_transport_poll_group_remove(tgroup, qpair->stripes[i]);
+			}
+
+			if (qpair->submit_ring != NULL) {
+				assert(group->num_shared_qpairs > 0);
+				group->num_shared_qpairs--;
+			}
+
+			return 0;
 		}
 	}
 
@@ -137,6 +256,56 @@ nvme_poll_group_disconnect_qpair(struct spdk_nvme_qpair *qpair)
 	return nvme_transport_poll_group_disconnect_qpair(qpair);
 }
 
+/*
+ * The connections of a striped qpair are hidden from the user. A lost connection disconnects
+ * the user's qpair, which is only reported once all of its connections are disconnected, and
+ * after them in the list being iterated, so that the user can free them in the callback.
+ */
+static void
+nvme_poll_group_disconnected_qpair_cb(struct spdk_nvme_qpair *qpair, void *poll_group_ctx)
+{
+	struct spdk_nvme_transport_poll_group *tgroup = qpair->poll_group;
+	struct spdk_nvme_qpair *next;
+
+	if (spdk_unlikely(qpair->stripe_parent != NULL)) {
+		nvme_ctrlr_disconnect_qpair(qpair->stripe_parent);
+		return;
+	}
+
+	if (spdk_unlikely(qpair->num_stripes != 0)) {
+		if (!nvme_qpair_stripes_disconnected(qpair)) {
+			nvme_ctrlr_disconnect_qpair(qpair);
+			return;
+		}
+
+		for (next = STAILQ_NEXT(qpair, poll_group_stailq); next != NULL;
+		     next = STAILQ_NEXT(next, poll_group_stailq)) {
+			if (next->stripe_parent == qpair) {
+				STAILQ_REMOVE(&tgroup->disconnected_qpairs, qpair, spdk_nvme_qpair, poll_group_stailq);
+				STAILQ_INSERT_TAIL(&tgroup->disconnected_qpairs, qpair, poll_group_stailq);
+				return;
+			}
+		}
+	}
+
+	tgroup->group->disconnected_qpair_cb(qpair, poll_group_ctx);
+}
+
+static void
+nvme_poll_group_process_msgs(struct spdk_nvme_poll_group *group)
+{
+	struct spdk_nvme_transport_poll_group *tgroup;
+	struct spdk_nvme_qpair *qpair;
+
+	STAILQ_FOREACH(tgroup, &group->tgroups, link) {
+		STAILQ_FOREACH(qpair, &tgroup->connected_qpairs, poll_group_stailq) {
+			if (qpair->submit_ring != NULL) {
+				nvme_qpair_process_msgs(qpair);
+			}
+		}
+	}
+}
+
 int64_t
 spdk_nvme_poll_group_process_completions(struct spdk_nvme_poll_group *group,
 		uint32_t completions_per_qpair, spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb)
@@ -152,10 +321,15 @@ spdk_nvme_poll_group_process_completions(struct spdk_nvme_poll_group *group,
 		return 0;
 	}
 	group->in_process_completions = true;
+	group->disconnected_qpair_cb = disconnected_qpair_cb;
+
+	if (spdk_unlikely(group->num_shared_qpairs != 0)) {
+		nvme_poll_group_process_msgs(group);
+	}
 
 	STAILQ_FOREACH(tgroup, &group->tgroups, link) {
 		local_completions = nvme_transport_poll_group_process_completions(tgroup, completions_per_qpair,
-				    disconnected_qpair_cb);
+				    nvme_poll_group_disconnected_qpair_cb);
 		if (local_completions < 0 && error_reason == 0) {
 			error_reason = local_completions;
 		} else {
@@ -169,6 +343,57 @@ spdk_nvme_poll_group_process_completions(struct spdk_nvme_poll_group *group,
 	return error_reason ? error_reason : num_completions;
 }
 
+int
+spdk_nvme_poll_group_get_fd(struct spdk_nvme_poll_group *group)
+{
+	int rc;
+
+	rc = nvme_poll_group_create_fd_group(group);
+	if (rc != 0) {
+		return rc;
+	}
+
+	return spdk_fd_group_get_fd(group->fgrp);
+}
+
+int64_t
+spdk_nvme_poll_group_wait(struct spdk_nvme_poll_group *group,
+			  spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb)
+{
+	int64_t num_completions, total_completions = 0;
+	uint64_t poll_end;
+	int rc;
+
+	if (group->fgrp != NULL) {
+		rc = spdk_fd_group_wait(group->fgrp, 0);
+		if (rc < 0) {
+			return rc;
+		}
+	}
+
+	poll_end = spdk_get_ticks() + group->hybrid_poll_ticks;
+	do {
+		num_completions = spdk_nvme_poll_group_process_completions(group, 0,
+				  disconnected_qpair_cb);
+		if (num_completions < 0) {
+			return num_completions;
+		}
+
+		if (num_completions > 0) {
+			total_completions += num_completions;
+			poll_end = spdk_get_ticks() + group->hybrid_poll_ticks;
+		}
+	} while (spdk_get_ticks() < poll_end);
+
+	return total_completions;
+}
+
+void
+spdk_nvme_poll_group_set_hybrid_poll(struct spdk_nvme_poll_group *group, uint32_t hybrid_poll_us)
+{
+	group->hybrid_poll_ticks = hybrid_poll_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+}
+
 int
 spdk_nvme_poll_group_all_connected(struct spdk_nvme_poll_group *group)
 {
@@ -219,6 +444,10 @@ spdk_nvme_poll_group_destroy(struct spdk_nvme_poll_group *group)
 
 	}
 
+	if (group->fgrp != NULL) {
+		spdk_fd_group_destroy(group->fgrp);
+	}
+
 	free(group);
 
 	return 0;
@@ -7,6 +7,7 @@
 #include "nvme_internal.h"
 #include "spdk/nvme_ocssd.h"
 #include "spdk/string.h"
+#include "spdk/histogram_data.h"
 
 #define NVME_CMD_DPTR_STR_SIZE 256
 
@@ -745,6 +746,25 @@ nvme_complete_register_operations(struct spdk_nvme_qpair *qpair)
 	}
 }
 
+static int32_t
+nvme_qpair_process_stripes(struct spdk_nvme_qpair *qpair, uint32_t max_completions,
+			   int32_t num_completions)
+{
+	int32_t rc;
+	uint16_t i;
+
+	for (i = 0; i < qpair->num_stripes; i++) {
+		rc = spdk_nvme_qpair_process_completions(qpair->stripes[i], max_completions);
+		if (rc < 0) {
+			/* A lost connection fails the whole qpair, like its own connection would. */
+			return rc;
+		}
+		num_completions += rc;
+	}
+
+	return num_completions;
+}
+
 int32_t
 spdk_nvme_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_completions)
 {
@@ -788,6 +808,10 @@ spdk_nvme_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 		}
 	}
 
+	if (spdk_unlikely(qpair->submit_ring != NULL)) {
+		nvme_qpair_process_msgs(qpair);
+	}
+
 	qpair->in_completion_context = 1;
 	ret = nvme_transport_qpair_process_completions(qpair, max_completions);
 	if (ret < 0) {
@@ -821,6 +845,11 @@ spdk_nvme_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 		_nvme_qpair_complete_abort_queued_reqs(qpair);
 	}
 
+	/* Poll groups process the connections of a striped qpair on their own. */
+	if (spdk_unlikely(qpair->num_stripes != 0) && qpair->poll_group == NULL && ret >= 0) {
+		ret = nvme_qpair_process_stripes(qpair, max_completions, ret);
+	}
+
 	return ret;
 }
 
@@ -870,6 +899,10 @@ nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 	STAILQ_INIT(&qpair->free_req);
 	STAILQ_INIT(&qpair->queued_req);
 	STAILQ_INIT(&qpair->aborting_queued_req);
+	STAILQ_INIT(&qpair->free_child_req);
+	qpair->num_free_child_reqs = 0;
+	qpair->num_child_reqs = 0;
+	qpair->child_req_buf = NULL;
 	TAILQ_INIT(&qpair->err_cmd_head);
 	STAILQ_INIT(&qpair->err_req_head);
 
@@ -900,6 +933,53 @@ nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 	return 0;
 }
 
+int
+nvme_qpair_init_child_requests(struct spdk_nvme_qpair *qpair, uint32_t num_child_requests)
+{
+	struct nvme_request *req;
+	size_t req_size_padded;
+	uint32_t i;
+
+	assert(qpair->child_req_buf == NULL);
+
+	req_size_padded = (sizeof(struct nvme_request) + 63) & ~(size_t)63;
+
+	qpair->child_req_buf = spdk_zmalloc(req_size_padded * num_child_requests, 64, NULL,
+					    SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+	if (qpair->child_req_buf == NULL) {
+		SPDK_ERRLOG("no memory to allocate qpair(cntlid:0x%x sqid:%d) child_req_buf with %d request\n",
+			    qpair->ctrlr->cntlid, qpair->id, num_child_requests);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_child_requests; i++) {
+		req = (void *)((uintptr_t)qpair->child_req_buf + i * req_size_padded);
+
+		req->qpair = qpair;
+		STAILQ_INSERT_HEAD(&qpair->free_child_req, req, stailq);
+	}
+	qpair->num_free_child_reqs = num_child_requests;
+	qpair->num_child_reqs = num_child_requests;
+
+	return 0;
+}
+
+int
+nvme_qpair_init_submit_ring(struct spdk_nvme_qpair *qpair, uint32_t submit_ring_size)
+{
+	assert(qpair->submit_ring == NULL);
+
+	qpair->submit_ring = spdk_ring_create(SPDK_RING_TYPE_MP_SC, spdk_align32pow2(submit_ring_size),
+					      SPDK_ENV_SOCKET_ID_ANY);
+	if (qpair->submit_ring == NULL) {
+		SPDK_ERRLOG("no memory to allocate qpair(cntlid:0x%x sqid:%d) submit ring with %u entries\n",
+			    qpair->ctrlr->cntlid, qpair->id, submit_ring_size);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
 void
 nvme_qpair_complete_error_reqs(struct spdk_nvme_qpair *qpair)
 {
@@ -929,6 +1009,9 @@ nvme_qpair_deinit(struct spdk_nvme_qpair *qpair)
 	}
 
 	spdk_free(qpair->req_buf);
+	spdk_free(qpair->child_req_buf);
+	spdk_ring_free(qpair->submit_ring);
+	spdk_nvme_qpair_disable_latency_tracking(qpair);
 }
 
 static inline int
@@ -956,6 +1039,10 @@ _nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *r
 	}
 
 	if (req->num_children) {
+		if (spdk_unlikely(qpair->latency != NULL) && req->submit_tick == 0) {
+			req->submit_tick = spdk_get_ticks();
+		}
+
 		/*
 		 * This is a split (parent) request. Submit all of the children but not the parent
 		 * request itself, since the parent is the original unsplit request.
@@ -1015,7 +1102,7 @@ _nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *r
 	}
 
 	/* assign submit_tick before submitting req to specific transport */
-	if (spdk_unlikely(ctrlr->timeout_enabled)) {
+	if (spdk_unlikely(ctrlr->timeout_enabled || qpair->latency != NULL)) {
 		if (req->submit_tick == 0) { /* req submitted for the first time */
 			req->submit_tick = spdk_get_ticks();
 			req->timed_out = false;
@@ -1080,11 +1167,66 @@ error:
 	return rc;
 }
 
+/*
+ * Pick the connection of a striped qpair the request is sent on. The request is moved to
+ * the qpair of that connection, which gives one of its free requests back in exchange so
+ * that the requests of all the connections stay available to the user's qpair.
+ */
+static struct spdk_nvme_qpair *
+nvme_qpair_select_stripe(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	struct spdk_nvme_qpair *stripe;
+	struct nvme_request *free_req;
+	uint16_t i, index;
+
+	/* Fabrics commands belong to their connection and parents are never submitted. */
+	if (req->cmd.opc == SPDK_NVME_OPC_FABRIC || req->num_children != 0 || req->child_arena ||
+	    req->qpair != qpair) {
+		return qpair;
+	}
+
+	for (i = 0; i <= qpair->num_stripes; i++) {
+		index = qpair->next_stripe;
+		qpair->next_stripe = index == qpair->num_stripes ? 0 : index + 1;
+
+		stripe = index == 0 ? qpair : qpair->stripes[index - 1];
+		if (nvme_qpair_get_state(stripe) != NVME_QPAIR_ENABLED) {
+			continue;
+		}
+
+		if (stripe == qpair) {
+			return qpair;
+		}
+
+		free_req = STAILQ_FIRST(&stripe->free_req);
+		if (free_req == NULL) {
+			continue;
+		}
+
+		STAILQ_REMOVE_HEAD(&stripe->free_req, stailq);
+		free_req->qpair = qpair;
+		STAILQ_INSERT_HEAD(&qpair->free_req, free_req, stailq);
+
+		req->qpair = stripe;
+		qpair->num_outstanding_reqs--;
+		stripe->num_outstanding_reqs++;
+
+		return stripe;
+	}
+
+	/* No connection is enabled, queue the request on the user's qpair. */
+	return qpair;
+}
+
 int
 nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
 {
 	int rc;
 
+	if (spdk_unlikely(qpair->num_stripes != 0)) {
+		qpair = nvme_qpair_select_stripe(qpair, req);
+	}
+
 	if (spdk_unlikely(!STAILQ_EMPTY(&qpair->queued_req) && req->num_children == 0)) {
 		/*
 		 * Requests that have no children should be sent to the transport after all
@@ -1219,8 +1361,174 @@ spdk_nvme_qpair_get_id(struct spdk_nvme_qpair *qpair)
 	return qpair->id;
 }
 
+int
+spdk_nvme_qpair_get_fd(struct spdk_nvme_qpair *qpair)
+{
+	if (nvme_qpair_is_admin_queue(qpair)) {
+		return -ENOTSUP;
+	}
+
+	return nvme_transport_qpair_get_fd(qpair);
+}
+
 uint32_t
 spdk_nvme_qpair_get_num_outstanding_reqs(struct spdk_nvme_qpair *qpair)
 {
-	return qpair->num_outstanding_reqs;
+	uint32_t num_outstanding_reqs = qpair->num_outstanding_reqs;
+	uint16_t i;
+
+	for (i = 0; i < qpair->num_stripes; i++) {
+		num_outstanding_reqs += qpair->stripes[i]->num_outstanding_reqs;
+	}
+
+	return num_outstanding_reqs;
+}
+
+int
+spdk_nvme_qpair_send_msg(struct spdk_nvme_qpair *qpair, struct spdk_nvme_qpair_msg *msg)
+{
+	if (qpair->submit_ring == NULL) {
+		return -ENOTSUP;
+	}
+
+	if (spdk_ring_enqueue(qpair->submit_ring, (void **)&msg, 1, NULL) != 1) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+#define NVME_QPAIR_MSG_BATCH_SIZE 32
+
+int
+nvme_qpair_process_msgs(struct spdk_nvme_qpair *qpair)
+{
+	struct spdk_nvme_qpair_msg *msgs[NVME_QPAIR_MSG_BATCH_SIZE];
+	size_t count, i;
+
+	count = spdk_ring_dequeue(qpair->submit_ring, (void **)msgs, NVME_QPAIR_MSG_BATCH_SIZE);
+	for (i = 0; i < count; i++) {
+		msgs[i]->fn(qpair, msgs[i]->ctx);
+	}
+
+	return count;
+}
+
+bool
+nvme_qpair_stripes_disconnected(struct spdk_nvme_qpair *qpair)
+{
+	uint16_t i;
+
+	for (i = 0; i < qpair->num_stripes; i++) {
+		if (nvme_qpair_get_state(qpair->stripes[i]) != NVME_QPAIR_DISCONNECTED &&
+		    nvme_qpair_get_state(qpair->stripes[i]) != NVME_QPAIR_DESTROYING) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int
+spdk_nvme_qpair_enable_latency_tracking(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_qpair_latency *latency;
+	uint32_t num_ns;
+	uint16_t i;
+
+	if (nvme_qpair_is_admin_queue(qpair)) {
+		return -EINVAL;
+	}
+
+	if (qpair->latency != NULL) {
+		return 0;
+	}
+
+	num_ns = spdk_nvme_ctrlr_get_num_ns(qpair->ctrlr);
+	latency = calloc(1, sizeof(*latency) + (size_t)num_ns * SPDK_NVME_LATENCY_IO_NUM_TYPES *
+			 sizeof(latency->histograms[0]));
+	if (latency == NULL) {
+		return -ENOMEM;
+	}
+	latency->num_ns = num_ns;
+
+	/* The stripes are polled by the same thread, so they tally into the same histograms. */
+	qpair->latency = latency;
+	for (i = 0; i < qpair->num_stripes; i++) {
+		qpair->stripes[i]->latency = latency;
+	}
+
+	return 0;
+}
+
+void
+spdk_nvme_qpair_disable_latency_tracking(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_qpair_latency *latency = qpair->latency;
+	uint32_t i;
+
+	if (latency == NULL) {
+		return;
+	}
+
+	qpair->latency = NULL;
+	for (i = 0; i < qpair->num_stripes; i++) {
+		qpair->stripes[i]->latency = NULL;
+	}
+
+	for (i = 0; i < latency->num_ns * SPDK_NVME_LATENCY_IO_NUM_TYPES; i++) {
+		spdk_histogram_data_free(latency->histograms[i]);
+	}
+	free(latency);
+}
+
+static inline enum spdk_nvme_latency_io_type
+nvme_latency_io_type(uint8_t opc)
+{
+	switch (opc) {
+	case SPDK_NVME_OPC_READ:
+		return SPDK_NVME_LATENCY_IO_READ;
+	case SPDK_NVME_OPC_WRITE:
+		return SPDK_NVME_LATENCY_IO_WRITE;
+	default:
+		return SPDK_NVME_LATENCY_IO_OTHER;
+	}
+}
+
+const struct spdk_histogram_data *
+spdk_nvme_qpair_get_latency_histogram(struct spdk_nvme_qpair *qpair, uint32_t nsid,
+				      enum spdk_nvme_latency_io_type type)
+{
+	struct nvme_qpair_latency *latency = qpair->latency;
+
+	if (latency == NULL || nsid == 0 || nsid > latency->num_ns ||
+	    type >= SPDK_NVME_LATENCY_IO_NUM_TYPES) {
+		return NULL;
+	}
+
+	return latency->histograms[(nsid - 1) * SPDK_NVME_LATENCY_IO_NUM_TYPES + type];
+}
+
+void
+nvme_qpair_tally_latency(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	struct nvme_qpair_latency *latency = qpair->latency;
+	struct spdk_histogram_data **histogram;
+	uint32_t nsid = req->cmd.nsid;
+
+	/* The children of a split request are accounted for by their parent. */
+	if (req->parent != NULL || req->submit_tick == 0 || nsid == 0 || nsid > latency->num_ns) {
+		return;
+	}
+
+	histogram = &latency->histograms[(nsid - 1) * SPDK_NVME_LATENCY_IO_NUM_TYPES +
+					 nvme_latency_io_type(req->cmd.opc)];
+	if (spdk_unlikely(*histogram == NULL)) {
+		*histogram = spdk_histogram_data_alloc();
+		if (*histogram == NULL) {
+			return;
+		}
+	}
+
+	spdk_histogram_data_tally(*histogram, spdk_get_ticks() - req->submit_tick);
 }
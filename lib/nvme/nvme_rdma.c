@@ -75,6 +75,12 @@
 
 #define WC_PER_QPAIR(queue_depth)	(queue_depth * 2)
 
+/*
+ * A qpair attached to a shared receive queue only adds its send completions to the CQ,
+ * the receive completions are bounded by the size of the SRQ.
+ */
+#define WC_PER_SRQ_QPAIR(queue_depth)	(queue_depth)
+
 #define NVME_RDMA_POLL_GROUP_CHECK_QPN(_rqpair, qpn)				\
 	((_rqpair)->rdma_qp && (_rqpair)->rdma_qp->qp->qp_num == (qpn))	\
 
@@ -231,6 +237,9 @@ struct nvme_rdma_qpair {
 	/* Count of outstanding send objects */
 	uint16_t				current_num_sends;
 
+	/* Count of requests whose accel sequence is being executed */
+	uint16_t				current_num_accel;
+
 	/* Placed at the end of the struct since it is not used frequently */
 	struct rdma_cm_event			*evt;
 	struct nvme_rdma_poller			*poller;
@@ -255,12 +264,16 @@ enum NVME_RDMA_COMPLETION_FLAGS {
 struct spdk_nvme_rdma_req {
 	uint16_t				id;
 	uint16_t				completion_flags: 2;
-	uint16_t				reserved: 14;
+	uint16_t				in_progress_accel: 1;
+	uint16_t				reserved: 13;
 	/* if completion of RDMA_RECV received before RDMA_SEND, we will complete nvme request
 	 * during processing of RDMA_SEND. To complete the request we must know the response
 	 * received in RDMA_RECV, so store it in this field */
 	struct spdk_nvme_rdma_rsp		*rdma_rsp;
 
+	/* Completion of a read, kept while its accel sequence is executed */
+	struct spdk_nvme_cpl			cpl;
+
 	struct nvme_rdma_wr			rdma_wr;
 
 	struct ibv_send_wr			send_wr;
@@ -461,6 +474,37 @@ nvme_rdma_req_complete(struct spdk_nvme_rdma_req *rdma_req,
 	nvme_rdma_req_put(rqpair, rdma_req);
 }
 
+static inline void
+nvme_rdma_accel_finish_sequence(struct nvme_rdma_qpair *rqpair,
+				struct spdk_nvme_rdma_req *rdma_req,
+				spdk_nvme_accel_completion_cb cb_fn)
+{
+	struct spdk_nvme_poll_group *pg = rqpair->qpair.poll_group->group;
+
+	assert(!rdma_req->in_progress_accel);
+	rdma_req->in_progress_accel = 1;
+	rqpair->current_num_accel++;
+	pg->accel_fn_table.finish_sequence(rdma_req->req->accel_sequence, cb_fn, rdma_req);
+}
+
+static inline void
+nvme_rdma_accel_reverse_sequence(struct nvme_rdma_qpair *rqpair, void *seq)
+{
+	struct spdk_nvme_poll_group *pg = rqpair->qpair.poll_group->group;
+
+	pg->accel_fn_table.reverse_sequence(seq);
+}
+
+static inline void
+nvme_rdma_accel_sequence_done(struct nvme_rdma_qpair *rqpair, struct spdk_nvme_rdma_req *rdma_req)
+{
+	assert(rdma_req->in_progress_accel);
+	rdma_req->in_progress_accel = 0;
+	assert(rqpair->current_num_accel > 0);
+	rqpair->current_num_accel--;
+	rdma_req->req->accel_sequence = NULL;
+}
+
 static const char *
 nvme_rdma_cm_event_str_get(uint32_t event)
 {
@@ -675,12 +719,22 @@ exit:
 	return rqpair->evt_cb(rqpair, rc);
 }
 
+static inline int
+nvme_rdma_poller_num_wc(struct nvme_rdma_poller *poller, struct nvme_rdma_qpair *rqpair)
+{
+	if (poller->srq) {
+		return WC_PER_SRQ_QPAIR(rqpair->num_entries);
+	}
+
+	return WC_PER_QPAIR(rqpair->num_entries);
+}
+
 static int
 nvme_rdma_resize_cq(struct nvme_rdma_qpair *rqpair, struct nvme_rdma_poller *poller)
 {
 	int	current_num_wc, required_num_wc;
 
-	required_num_wc = poller->required_num_wc + WC_PER_QPAIR(rqpair->num_entries);
+	required_num_wc = poller->required_num_wc + nvme_rdma_poller_num_wc(poller, rqpair);
 	current_num_wc = poller->current_num_wc;
 	if (current_num_wc < required_num_wc) {
 		current_num_wc = spdk_max(current_num_wc * 2, required_num_wc);
@@ -716,11 +770,9 @@ nvme_rdma_qpair_set_poller(struct spdk_nvme_qpair *qpair)
 		return -EINVAL;
 	}
 
-	if (!poller->srq) {
-		if (nvme_rdma_resize_cq(rqpair, poller)) {
-			nvme_rdma_poll_group_put_poller(group, poller);
-			return -EPROTO;
-		}
+	if (nvme_rdma_resize_cq(rqpair, poller)) {
+		nvme_rdma_poll_group_put_poller(group, poller);
+		return -EPROTO;
 	}
 
 	rqpair->cq = poller->cq;
@@ -1895,11 +1947,16 @@ nvme_rdma_qpair_destroy(struct nvme_rdma_qpair *rqpair)
 
 	if (rqpair->poller) {
 		struct nvme_rdma_poll_group     *group;
+		struct nvme_rdma_poller         *poller;
 
 		assert(qpair->poll_group);
 		group = nvme_rdma_poll_group(qpair->poll_group);
 
-		nvme_rdma_poll_group_put_poller(group, rqpair->poller);
+		/* The CQ isn't shrunk, but the next qpairs can reuse the completions of this one */
+		poller = rqpair->poller;
+		assert(poller->required_num_wc >= nvme_rdma_poller_num_wc(poller, rqpair));
+		poller->required_num_wc -= nvme_rdma_poller_num_wc(poller, rqpair);
+		nvme_rdma_poll_group_put_poller(group, poller);
 
 		rqpair->poller = NULL;
 		rqpair->cq = NULL;
@@ -1944,7 +2001,7 @@ nvme_rdma_qpair_disconnected(struct nvme_rdma_qpair *rqpair, int ret)
 		goto quiet;
 	}
 
-	if (rqpair->need_destroy ||
+	if (rqpair->need_destroy || rqpair->current_num_accel != 0 ||
 	    (rqpair->current_num_sends != 0 ||
 	     (!rqpair->srq && rqpair->rsps->current_num_recvs != 0))) {
 		rqpair->state = NVME_RDMA_QPAIR_STATE_LINGERING;
@@ -1967,6 +2024,11 @@ quiet:
 static int
 nvme_rdma_qpair_wait_until_quiet(struct nvme_rdma_qpair *rqpair)
 {
+	/* The requests can't be freed while their accel sequence is being executed */
+	if (rqpair->current_num_accel != 0) {
+		return -EAGAIN;
+	}
+
 	if (spdk_get_ticks() < rqpair->evt_timeout_ticks &&
 	    (rqpair->current_num_sends != 0 ||
 	     (!rqpair->srq && rqpair->rsps->current_num_recvs != 0))) {
@@ -2224,6 +2286,10 @@ nvme_rdma_ctrlr_construct(const struct spdk_nvme_transport_id *trid,
 		return NULL;
 	}
 
+	/* Finishing the sequences here lets the last operation of a write sequence output its
+	 * data directly to the buffers posted to the NIC, possibly through a memory domain */
+	rctrlr->ctrlr.flags |= SPDK_NVME_CTRLR_ACCEL_SEQUENCE_SUPPORTED;
+
 	STAILQ_INIT(&rctrlr->pending_cm_events);
 	STAILQ_INIT(&rctrlr->free_cm_events);
 	rctrlr->cm_events = spdk_zmalloc(NVME_RDMA_NUM_CM_EVENTS * sizeof(*rctrlr->cm_events), 0, NULL,
@@ -2300,13 +2366,60 @@ nvme_rdma_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
 	return 0;
 }
 
+static int
+nvme_rdma_qpair_queue_send_wr(struct nvme_rdma_qpair *rqpair, struct ibv_send_wr *wr)
+{
+	assert(rqpair->current_num_sends < rqpair->num_entries);
+	rqpair->current_num_sends++;
+
+	wr->next = NULL;
+	nvme_rdma_trace_ibv_sge(wr->sg_list);
+
+	spdk_rdma_qp_queue_send_wrs(rqpair->rdma_qp, wr);
+
+	if (!rqpair->delay_cmd_submit) {
+		return nvme_rdma_qpair_submit_sends(rqpair);
+	}
+
+	return 0;
+}
+
+static void nvme_rdma_fail_qpair(struct spdk_nvme_qpair *qpair, int failure_reason);
+
+static void
+nvme_rdma_write_seq_cb(void *ctx, int status)
+{
+	struct spdk_nvme_rdma_req *rdma_req = ctx;
+	struct spdk_nvme_qpair *qpair = rdma_req->req->qpair;
+	struct nvme_rdma_qpair *rqpair = nvme_rdma_qpair(qpair);
+	struct spdk_nvme_cpl cpl = {};
+
+	nvme_rdma_accel_sequence_done(rqpair, rdma_req);
+	if (spdk_unlikely(status != 0 || rqpair->state != NVME_RDMA_QPAIR_STATE_RUNNING)) {
+		if (status != 0) {
+			SPDK_ERRLOG("Failed to execute accel sequence: %d\n", status);
+		}
+
+		cpl.sqid = qpair->id;
+		cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		cpl.status.sc = status != 0 ? SPDK_NVME_SC_INTERNAL_DEVICE_ERROR :
+				SPDK_NVME_SC_ABORTED_SQ_DELETION;
+		rqpair->num_completions++;
+		nvme_rdma_req_complete(rdma_req, &cpl, true);
+		return;
+	}
+
+	if (spdk_unlikely(nvme_rdma_qpair_queue_send_wr(rqpair, &rdma_req->send_wr) != 0)) {
+		nvme_rdma_fail_qpair(qpair, 0);
+	}
+}
+
 static int
 nvme_rdma_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 			       struct nvme_request *req)
 {
 	struct nvme_rdma_qpair *rqpair;
 	struct spdk_nvme_rdma_req *rdma_req;
-	struct ibv_send_wr *wr;
 
 	rqpair = nvme_rdma_qpair(qpair);
 	assert(rqpair != NULL);
@@ -2328,20 +2441,15 @@ nvme_rdma_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 		return -1;
 	}
 
-	assert(rqpair->current_num_sends < rqpair->num_entries);
-	rqpair->current_num_sends++;
-
-	wr = &rdma_req->send_wr;
-	wr->next = NULL;
-	nvme_rdma_trace_ibv_sge(wr->sg_list);
-
-	spdk_rdma_qp_queue_send_wrs(rqpair->rdma_qp, wr);
-
-	if (!rqpair->delay_cmd_submit) {
-		return nvme_rdma_qpair_submit_sends(rqpair);
+	/* Execute the sequence of a write right before posting it, so that its last operation
+	 * writes the data straight to the buffers translated above */
+	if (spdk_unlikely(req->accel_sequence != NULL) && req->payload_size > 0 &&
+	    spdk_nvme_opc_get_data_transfer(req->cmd.opc) == SPDK_NVME_DATA_HOST_TO_CONTROLLER) {
+		nvme_rdma_accel_finish_sequence(rqpair, rdma_req, nvme_rdma_write_seq_cb);
+		return 0;
 	}
 
-	return 0;
+	return nvme_rdma_qpair_queue_send_wr(rqpair, &rdma_req->send_wr);
 }
 
 static int
@@ -2374,6 +2482,11 @@ nvme_rdma_qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr)
 	}
 
 	TAILQ_FOREACH_SAFE(rdma_req, &rqpair->outstanding_reqs, link, tmp) {
+		/* We cannot abort requests with accel operations in progress */
+		if (rdma_req->in_progress_accel) {
+			continue;
+		}
+
 		nvme_rdma_req_complete(rdma_req, &cpl, true);
 	}
 }
@@ -2417,13 +2530,40 @@ nvme_rdma_qpair_check_timeout(struct spdk_nvme_qpair *qpair)
 	}
 }
 
+static void
+nvme_rdma_read_seq_cb(void *ctx, int status)
+{
+	struct spdk_nvme_rdma_req *rdma_req = ctx;
+	struct nvme_rdma_qpair *rqpair = nvme_rdma_qpair(rdma_req->req->qpair);
+
+	nvme_rdma_accel_sequence_done(rqpair, rdma_req);
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Failed to execute accel sequence: %d\n", status);
+		rdma_req->cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		rdma_req->cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	}
+
+	/* Let the poll group resubmit the requests queued while this one was outstanding */
+	rqpair->num_completions++;
+	nvme_rdma_req_complete(rdma_req, &rdma_req->cpl, true);
+}
+
 static inline void
 nvme_rdma_request_ready(struct nvme_rdma_qpair *rqpair, struct spdk_nvme_rdma_req *rdma_req)
 {
 	struct spdk_nvme_rdma_rsp *rdma_rsp = rdma_req->rdma_rsp;
 	struct ibv_recv_wr *recv_wr = rdma_rsp->recv_wr;
+	struct nvme_request *req = rdma_req->req;
 
-	nvme_rdma_req_complete(rdma_req, &rdma_rsp->cpl, true);
+	if (spdk_unlikely(req->accel_sequence != NULL && !spdk_nvme_cpl_is_error(&rdma_rsp->cpl))) {
+		/* The response buffer is reposted right away, keep the completion until the data
+		 * read into the request's buffers has been transformed */
+		rdma_req->cpl = rdma_rsp->cpl;
+		nvme_rdma_accel_reverse_sequence(rqpair, req->accel_sequence);
+		nvme_rdma_accel_finish_sequence(rqpair, rdma_req, nvme_rdma_read_seq_cb);
+	} else {
+		nvme_rdma_req_complete(rdma_req, &rdma_rsp->cpl, true);
+	}
 
 	assert(rqpair->rsps->current_num_recvs < rqpair->rsps->num_entries);
 	rqpair->rsps->current_num_recvs++;
@@ -2896,7 +3036,8 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 	struct ibv_device_attr dev_attr;
 	struct spdk_rdma_srq_init_attr srq_init_attr = {};
 	struct nvme_rdma_rsp_opts opts;
-	int num_cqe;
+	uint32_t srq_size;
+	int num_cqe, required_num_wc = 0;
 	int rc;
 
 	poller = calloc(1, sizeof(*poller));
@@ -2928,10 +3069,14 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 			goto fail;
 		}
 
+		/* The responses are indexed by a 16 bit counter, as for a qpair */
+		srq_size = spdk_min((uint32_t)dev_attr.max_srq_wr,
+				    g_spdk_nvme_transport_opts.rdma_srq_size);
+		srq_size = spdk_min(srq_size, UINT16_MAX);
+
 		srq_init_attr.stats = &poller->stats.rdma_stats.recv;
 		srq_init_attr.pd = poller->pd;
-		srq_init_attr.srq_init_attr.attr.max_wr = spdk_min((uint32_t)dev_attr.max_srq_wr,
-				g_spdk_nvme_transport_opts.rdma_srq_size);
+		srq_init_attr.srq_init_attr.attr.max_wr = srq_size;
 		srq_init_attr.srq_init_attr.attr.max_sge = spdk_min(dev_attr.max_sge,
 				NVME_RDMA_DEFAULT_RX_SGE);
 
@@ -2941,7 +3086,7 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 			goto fail;
 		}
 
-		opts.num_entries = g_spdk_nvme_transport_opts.rdma_srq_size;
+		opts.num_entries = srq_size;
 		opts.rqpair = NULL;
 		opts.srq = poller->srq;
 		opts.mr_map = poller->mr_map;
@@ -2959,11 +3104,13 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 		}
 
 		/*
-		 * When using an srq, fix the size of the completion queue at startup.
-		 * The initiator sends only send and recv WRs. Hence, the multiplier is 2.
-		 * (The target sends also data WRs. Hence, the multiplier is 3.)
+		 * When using an srq, the receive completions of all the qpairs sharing it fit in
+		 * srq_size entries of the completion queue. The initiator sends only send and recv
+		 * WRs, so leave as much room for the sends. The CQ is resized if the qpairs attached
+		 * to the poller have more send WRs than that.
 		 */
-		num_cqe = g_spdk_nvme_transport_opts.rdma_srq_size * 2;
+		num_cqe = srq_size * 2;
+		required_num_wc = srq_size;
 	} else {
 		num_cqe = DEFAULT_NVME_RDMA_CQ_SIZE;
 	}
@@ -2978,7 +3125,7 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 	STAILQ_INSERT_HEAD(&group->pollers, poller, link);
 	group->num_pollers++;
 	poller->current_num_wc = num_cqe;
-	poller->required_num_wc = 0;
+	poller->required_num_wc = required_num_wc;
 	return poller;
 
 fail:
@@ -3092,6 +3239,7 @@ nvme_rdma_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 	uint64_t				completions_per_poller = 0;
 	uint64_t				poller_completions = 0;
 	uint64_t				rdma_completions;
+	uint32_t				num_completions;
 
 	if (completions_per_qpair == 0) {
 		completions_per_qpair = MAX_COMPLETIONS_PER_POLL;
@@ -3107,7 +3255,6 @@ nvme_rdma_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 
 	STAILQ_FOREACH_SAFE(qpair, &tgroup->connected_qpairs, poll_group_stailq, tmp_qpair) {
 		rqpair = nvme_rdma_qpair(qpair);
-		rqpair->num_completions = 0;
 
 		if (spdk_unlikely(nvme_qpair_get_state(qpair) == NVME_QPAIR_CONNECTING)) {
 			rc = nvme_rdma_ctrlr_connect_qpair_poll(qpair->ctrlr, qpair);
@@ -3163,6 +3310,9 @@ nvme_rdma_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 
 	STAILQ_FOREACH_SAFE(qpair, &tgroup->connected_qpairs, poll_group_stailq, tmp_qpair) {
 		rqpair = nvme_rdma_qpair(qpair);
+		/* Also includes the requests completed by accel since the previous poll */
+		num_completions = rqpair->num_completions;
+		rqpair->num_completions = 0;
 
 		if (spdk_unlikely(rqpair->state <= NVME_RDMA_QPAIR_STATE_INITIALIZING)) {
 			continue;
@@ -3176,8 +3326,8 @@ nvme_rdma_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 		if (!rqpair->srq) {
 			nvme_rdma_qpair_submit_recvs(rqpair);
 		}
-		if (rqpair->num_completions > 0) {
-			nvme_qpair_resubmit_requests(qpair, rqpair->num_completions);
+		if (num_completions > 0) {
+			nvme_qpair_resubmit_requests(qpair, num_completions);
 		}
 	}
 
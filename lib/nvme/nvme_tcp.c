@@ -42,6 +42,12 @@
  */
 #define NVME_TCP_CTRLR_MAX_TRANSPORT_ACK_TIMEOUT	31
 
+/*
+ * Every PDU sent by a controller has a header at least this long, so the host
+ * can read that much at once without consuming any part of the next PDU.
+ */
+#define NVME_TCP_C2H_PDU_MIN_HLEN	sizeof(struct spdk_nvme_tcp_rsp)
+
 
 /* NVMe TCP transport extensions for spdk_nvme_ctrlr */
 struct nvme_tcp_ctrlr {
@@ -86,7 +92,8 @@ struct nvme_tcp_qpair {
 		uint16_t host_ddgst_enable: 1;
 		uint16_t icreq_send_ack: 1;
 		uint16_t in_connect_poll: 1;
-		uint16_t reserved: 12;
+		uint16_t zcopy_recv: 1;
+		uint16_t reserved: 11;
 	} flags;
 
 	/** Specifies the maximum number of PDU-Data bytes per H2C Data Transfer PDU */
@@ -1964,7 +1971,7 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 {
 	int rc = 0;
 	struct nvme_tcp_pdu *pdu;
-	uint32_t data_len;
+	uint32_t data_len, hdr_len;
 	enum nvme_tcp_pdu_recv_state prev_state;
 
 	*reaped = tqpair->async_complete;
@@ -1987,8 +1994,11 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 		/* Wait for the pdu common header */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH:
 			assert(pdu->ch_valid_bytes < sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
-			rc = nvme_tcp_read_data(tqpair->sock,
-						sizeof(struct spdk_nvme_tcp_common_pdu_hdr) - pdu->ch_valid_bytes,
+			/* Without a receive pipe each read is a system call, so read the
+			 * common header together with the start of the PDU specific header. */
+			hdr_len = tqpair->flags.zcopy_recv ? NVME_TCP_C2H_PDU_MIN_HLEN :
+				  sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+			rc = nvme_tcp_read_data(tqpair->sock, hdr_len - pdu->ch_valid_bytes,
 						(uint8_t *)&pdu->hdr.common + pdu->ch_valid_bytes);
 			if (rc < 0) {
 				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
@@ -1998,24 +2008,30 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 			if (pdu->ch_valid_bytes < sizeof(struct spdk_nvme_tcp_common_pdu_hdr)) {
 				return NVME_TCP_PDU_IN_PROGRESS;
 			}
+			if (pdu->ch_valid_bytes > sizeof(struct spdk_nvme_tcp_common_pdu_hdr)) {
+				pdu->psh_valid_bytes = pdu->ch_valid_bytes - sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+				pdu->ch_valid_bytes = sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+			}
 
 			/* The command header of this PDU has now been read from the socket. */
 			nvme_tcp_pdu_ch_handle(tqpair);
 			break;
 		/* Wait for the pdu specific header  */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH:
-			assert(pdu->psh_valid_bytes < pdu->psh_len);
-			rc = nvme_tcp_read_data(tqpair->sock,
-						pdu->psh_len - pdu->psh_valid_bytes,
-						(uint8_t *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
-			if (rc < 0) {
-				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
-				break;
-			}
-
-			pdu->psh_valid_bytes += rc;
+			assert(pdu->psh_valid_bytes <= pdu->psh_len);
 			if (pdu->psh_valid_bytes < pdu->psh_len) {
-				return NVME_TCP_PDU_IN_PROGRESS;
+				rc = nvme_tcp_read_data(tqpair->sock,
+							pdu->psh_len - pdu->psh_valid_bytes,
+							(uint8_t *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
+				if (rc < 0) {
+					nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
+					break;
+				}
+
+				pdu->psh_valid_bytes += rc;
+				if (pdu->psh_valid_bytes < pdu->psh_len) {
+					return NVME_TCP_PDU_IN_PROGRESS;
+				}
 			}
 
 			/* All header(ch, psh, head digist) of this PDU has now been read from the socket. */
@@ -2252,7 +2268,7 @@ nvme_tcp_qpair_connect_sock(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpai
 	struct nvme_tcp_qpair *tqpair;
 	int family;
 	long int port;
-	char *sock_impl_name;
+	const char *sock_impl_name;
 	struct spdk_sock_impl_opts impl_opts = {};
 	size_t impl_opts_size = sizeof(impl_opts);
 	struct spdk_sock_opts opts;
@@ -2304,8 +2320,24 @@ nvme_tcp_qpair_connect_sock(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpai
 	sock_impl_name = tcp_ctrlr->psk[0] ? "ssl" : NULL;
 	SPDK_DEBUGLOG(nvme, "sock_impl_name is %s\n", sock_impl_name);
 
+	tqpair->flags.zcopy_recv = 0;
+	if (g_spdk_nvme_transport_opts.tcp_zcopy_recv && !nvme_qpair_is_admin_queue(qpair)) {
+		/* The receive pipe can only be disabled through the options of a known
+		 * implementation, so without a default one the pipe is kept. */
+		if (sock_impl_name == NULL) {
+			sock_impl_name = spdk_sock_get_default_impl();
+		}
+		tqpair->flags.zcopy_recv = sock_impl_name != NULL;
+	}
+
 	if (sock_impl_name) {
 		spdk_sock_impl_get_opts(sock_impl_name, &impl_opts, &impl_opts_size);
+		if (tqpair->flags.zcopy_recv) {
+			impl_opts.enable_recv_pipe = false;
+		}
+	}
+
+	if (tcp_ctrlr->psk[0]) {
 		impl_opts.tls_version = SPDK_TLS_VERSION_1_3;
 		impl_opts.psk_identity = tcp_ctrlr->psk_identity;
 		impl_opts.psk_key = tcp_ctrlr->psk;
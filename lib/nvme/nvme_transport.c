@@ -27,6 +27,7 @@ int g_current_transport_index = 0;
 
 struct spdk_nvme_transport_opts g_spdk_nvme_transport_opts = {
 	.rdma_srq_size = 0,
+	.tcp_zcopy_recv = false,
 };
 
 const struct spdk_nvme_transport *
@@ -654,6 +655,18 @@ nvme_transport_poll_group_create(const struct spdk_nvme_transport *transport)
 	return group;
 }
 
+int
+nvme_transport_qpair_get_fd(struct spdk_nvme_qpair *qpair)
+{
+	const struct spdk_nvme_transport *transport = qpair->transport;
+
+	if (transport == NULL || transport->ops.qpair_get_fd == NULL) {
+		return -ENOTSUP;
+	}
+
+	return transport->ops.qpair_get_fd(qpair);
+}
+
 struct spdk_nvme_transport_poll_group *
 nvme_transport_qpair_get_optimal_poll_group(const struct spdk_nvme_transport *transport,
 		struct spdk_nvme_qpair *qpair)
@@ -818,6 +831,7 @@ spdk_nvme_transport_get_opts(struct spdk_nvme_transport_opts *opts, size_t opts_
 	} \
 
 	SET_FIELD(rdma_srq_size);
+	SET_FIELD(tcp_zcopy_recv);
 
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
@@ -845,6 +859,7 @@ spdk_nvme_transport_set_opts(const struct spdk_nvme_transport_opts *opts, size_t
 	} \
 
 	SET_FIELD(rdma_srq_size);
+	SET_FIELD(tcp_zcopy_recv);
 
 	g_spdk_nvme_transport_opts.opts_size = opts->opts_size;
 
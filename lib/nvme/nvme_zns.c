@@ -253,3 +253,811 @@ spdk_nvme_zns_set_zone_desc_ext(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair
 
 	return nvme_qpair_submit_request(qpair, req);
 }
+
+#define NVME_ZNS_ZONE_MGR_DEFAULT_MAX_REQUESTS		256
+#define NVME_ZNS_ZONE_MGR_DEFAULT_MAX_ZONE_INFLIGHT	4
+#define NVME_ZNS_ZONE_MGR_REPORT_ZONES			128
+
+struct nvme_zns_zone_mgr_req {
+	struct spdk_nvme_zns_zone_mgr			*mgr;
+	struct nvme_zns_zone				*zone;
+	void						*buffer;
+	uint32_t					lba_count;
+	uint32_t					io_flags;
+	uint8_t						zsa;
+	spdk_nvme_cmd_cb				cb_fn;
+	void						*cb_arg;
+
+	/* Requests (including this one) merged into the command submitted for this one */
+	STAILQ_HEAD(, nvme_zns_zone_mgr_req)		batch;
+	struct nvme_zns_zone_mgr_req			*sgl_req;
+	uint32_t					sgl_offset;
+
+	STAILQ_ENTRY(nvme_zns_zone_mgr_req)		stailq;
+};
+
+struct nvme_zns_zone {
+	uint64_t					wp;
+	uint64_t					zcap;
+	/* LBAs of the appends queued or outstanding */
+	uint64_t					pending_lbas;
+	uint32_t					num_inflight;
+	uint8_t						state;
+	STAILQ_HEAD(, nvme_zns_zone_mgr_req)		queued;
+};
+
+struct spdk_nvme_zns_zone_mgr {
+	struct spdk_nvme_ns				*ns;
+	struct spdk_nvme_qpair				*qpair;
+	struct spdk_nvme_zns_zone_mgr_opts		opts;
+
+	uint64_t					zone_size;
+	uint64_t					num_zones;
+	uint32_t					sector_size;
+	uint32_t					max_append_size;
+	uint32_t					max_segments;
+	uint32_t					max_open_zones;
+	uint32_t					max_active_zones;
+	uint32_t					num_open_zones;
+	uint32_t					num_active_zones;
+	uint32_t					num_outstanding;
+	bool						initialized;
+
+	/* Zone report in progress */
+	struct spdk_nvme_zns_zone_report		*report;
+	uint32_t					report_size;
+	uint64_t					report_slba;
+	spdk_nvme_zns_zone_mgr_refresh_cb		refresh_cb_fn;
+	void						*refresh_cb_arg;
+
+	struct nvme_zns_zone				*zones;
+	struct nvme_zns_zone_mgr_req			*reqs;
+	STAILQ_HEAD(, nvme_zns_zone_mgr_req)		free_reqs;
+};
+
+void
+spdk_nvme_zns_zone_mgr_get_default_opts(struct spdk_nvme_zns_zone_mgr_opts *opts, size_t opts_size)
+{
+	if (opts == NULL) {
+		SPDK_ERRLOG("opts should not be NULL.\n");
+		return;
+	}
+
+	if (opts_size == 0) {
+		SPDK_ERRLOG("opts_size should not be zero.\n");
+		return;
+	}
+
+	memset(opts, 0, opts_size);
+	opts->opts_size = opts_size;
+
+#define SET_FIELD(field, value) \
+	if (offsetof(struct spdk_nvme_zns_zone_mgr_opts, field) + sizeof(opts->field) <= opts_size) { \
+		opts->field = value; \
+	} \
+
+	SET_FIELD(max_requests, NVME_ZNS_ZONE_MGR_DEFAULT_MAX_REQUESTS);
+	SET_FIELD(max_zone_inflight, NVME_ZNS_ZONE_MGR_DEFAULT_MAX_ZONE_INFLIGHT);
+	SET_FIELD(max_open_zones, 0);
+	SET_FIELD(max_active_zones, 0);
+
+#undef SET_FIELD
+}
+
+static void
+nvme_zns_zone_mgr_opts_copy(struct spdk_nvme_zns_zone_mgr_opts *dst,
+			    const struct spdk_nvme_zns_zone_mgr_opts *src)
+{
+	spdk_nvme_zns_zone_mgr_get_default_opts(dst, sizeof(*dst));
+
+#define SET_FIELD(field) \
+	if (offsetof(struct spdk_nvme_zns_zone_mgr_opts, field) + sizeof(src->field) <= src->opts_size) { \
+		dst->field = src->field; \
+	} \
+
+	SET_FIELD(max_requests);
+	SET_FIELD(max_zone_inflight);
+	SET_FIELD(max_open_zones);
+	SET_FIELD(max_active_zones);
+
+	/* Do not remove this statement, you should always update this statement when you adding a new field,
+	 * and do not forget to add the SET_FIELD statement for your added field. */
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_zone_mgr_opts) == 24, "Incorrect size");
+
+#undef SET_FIELD
+}
+
+static uint32_t
+nvme_zns_zone_mgr_limit(uint32_t ns_limit, uint32_t opts_limit)
+{
+	/* 0 means no limit for both of them */
+	if (ns_limit == 0) {
+		return opts_limit;
+	}
+
+	return opts_limit == 0 ? ns_limit : spdk_min(ns_limit, opts_limit);
+}
+
+struct spdk_nvme_zns_zone_mgr *
+spdk_nvme_zns_zone_mgr_create(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			      const struct spdk_nvme_zns_zone_mgr_opts *opts)
+{
+	struct spdk_nvme_zns_zone_mgr *mgr;
+	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+	uint32_t max_xfer_size, num_descs, i;
+
+	if (spdk_nvme_ns_get_csi(ns) != SPDK_NVME_CSI_ZNS || ns->nsdata_zns == NULL) {
+		SPDK_ERRLOG("Namespace %u is not a zoned namespace\n", ns->id);
+		return NULL;
+	}
+
+	if (spdk_nvme_ns_get_md_size(ns) != 0 && !spdk_nvme_ns_supports_extended_lba(ns)) {
+		SPDK_ERRLOG("Namespaces with separate metadata are not supported\n");
+		return NULL;
+	}
+
+	mgr = calloc(1, sizeof(*mgr));
+	if (mgr == NULL) {
+		return NULL;
+	}
+
+	if (opts != NULL) {
+		nvme_zns_zone_mgr_opts_copy(&mgr->opts, opts);
+	} else {
+		spdk_nvme_zns_zone_mgr_get_default_opts(&mgr->opts, sizeof(mgr->opts));
+	}
+
+	if (mgr->opts.max_requests == 0 || mgr->opts.max_zone_inflight == 0) {
+		SPDK_ERRLOG("max_requests and max_zone_inflight must not be 0\n");
+		free(mgr);
+		return NULL;
+	}
+
+	mgr->ns = ns;
+	mgr->qpair = qpair;
+	mgr->zone_size = spdk_nvme_zns_ns_get_zone_size_sectors(ns);
+	mgr->num_zones = spdk_nvme_zns_ns_get_num_zones(ns);
+	mgr->sector_size = spdk_nvme_ns_get_extended_sector_size(ns);
+	mgr->max_append_size = spdk_nvme_zns_ctrlr_get_max_zone_append_size(ctrlr);
+	/* Appends with discontiguous buffers can only be merged with SGLs */
+	mgr->max_segments = (ctrlr->flags & SPDK_NVME_CTRLR_SGL_SUPPORTED) ?
+			    spdk_max(ctrlr->max_sges, 1) : 1;
+	mgr->max_open_zones = nvme_zns_zone_mgr_limit(spdk_nvme_zns_ns_get_max_open_zones(ns),
+			      mgr->opts.max_open_zones);
+	mgr->max_active_zones = nvme_zns_zone_mgr_limit(spdk_nvme_zns_ns_get_max_active_zones(ns),
+				mgr->opts.max_active_zones);
+
+	max_xfer_size = spdk_nvme_ns_get_max_io_xfer_size(ns);
+	num_descs = (max_xfer_size - sizeof(struct spdk_nvme_zns_zone_report)) /
+		    sizeof(struct spdk_nvme_zns_zone_desc);
+	num_descs = spdk_max(1, spdk_min(num_descs, NVME_ZNS_ZONE_MGR_REPORT_ZONES));
+	mgr->report_size = sizeof(struct spdk_nvme_zns_zone_report) +
+			   num_descs * sizeof(struct spdk_nvme_zns_zone_desc);
+	mgr->report = spdk_zmalloc(mgr->report_size, 0, NULL, SPDK_ENV_SOCKET_ID_ANY,
+				   SPDK_MALLOC_DMA);
+	mgr->zones = calloc(mgr->num_zones, sizeof(*mgr->zones));
+	mgr->reqs = calloc(mgr->opts.max_requests, sizeof(*mgr->reqs));
+	if (mgr->report == NULL || mgr->zones == NULL || mgr->reqs == NULL) {
+		spdk_free(mgr->report);
+		free(mgr->zones);
+		free(mgr->reqs);
+		free(mgr);
+		return NULL;
+	}
+
+	for (i = 0; i < mgr->num_zones; i++) {
+		STAILQ_INIT(&mgr->zones[i].queued);
+	}
+
+	STAILQ_INIT(&mgr->free_reqs);
+	for (i = 0; i < mgr->opts.max_requests; i++) {
+		mgr->reqs[i].mgr = mgr;
+		STAILQ_INSERT_TAIL(&mgr->free_reqs, &mgr->reqs[i], stailq);
+	}
+
+	return mgr;
+}
+
+int
+spdk_nvme_zns_zone_mgr_free(struct spdk_nvme_zns_zone_mgr *mgr)
+{
+	if (mgr == NULL) {
+		return 0;
+	}
+
+	if (mgr->num_outstanding != 0 || mgr->refresh_cb_fn != NULL) {
+		return -EBUSY;
+	}
+
+	spdk_free(mgr->report);
+	free(mgr->zones);
+	free(mgr->reqs);
+	free(mgr);
+
+	return 0;
+}
+
+static inline bool
+nvme_zns_zone_state_is_open(uint8_t state)
+{
+	return state == SPDK_NVME_ZONE_STATE_IOPEN || state == SPDK_NVME_ZONE_STATE_EOPEN;
+}
+
+static inline bool
+nvme_zns_zone_state_is_active(uint8_t state)
+{
+	return nvme_zns_zone_state_is_open(state) || state == SPDK_NVME_ZONE_STATE_CLOSED;
+}
+
+static void
+nvme_zns_zone_mgr_set_state(struct spdk_nvme_zns_zone_mgr *mgr, struct nvme_zns_zone *zone,
+			    uint8_t state)
+{
+	mgr->num_open_zones -= nvme_zns_zone_state_is_open(zone->state);
+	mgr->num_active_zones -= nvme_zns_zone_state_is_active(zone->state);
+	zone->state = state;
+	mgr->num_open_zones += nvme_zns_zone_state_is_open(zone->state);
+	mgr->num_active_zones += nvme_zns_zone_state_is_active(zone->state);
+}
+
+/* Check whether a zone can be moved to an open state without exceeding the limits */
+static bool
+nvme_zns_zone_mgr_can_open(struct spdk_nvme_zns_zone_mgr *mgr, struct nvme_zns_zone *zone)
+{
+	if (nvme_zns_zone_state_is_open(zone->state)) {
+		return true;
+	}
+
+	if (mgr->max_open_zones != 0 && mgr->num_open_zones >= mgr->max_open_zones) {
+		return false;
+	}
+
+	if (!nvme_zns_zone_state_is_active(zone->state) &&
+	    mgr->max_active_zones != 0 && mgr->num_active_zones >= mgr->max_active_zones) {
+		return false;
+	}
+
+	return true;
+}
+
+static struct nvme_zns_zone *
+nvme_zns_zone_mgr_get_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba)
+{
+	if (!mgr->initialized || zslba % mgr->zone_size != 0 ||
+	    zslba / mgr->zone_size >= mgr->num_zones) {
+		return NULL;
+	}
+
+	return &mgr->zones[zslba / mgr->zone_size];
+}
+
+static inline uint64_t
+nvme_zns_zone_mgr_get_zslba(struct spdk_nvme_zns_zone_mgr *mgr, struct nvme_zns_zone *zone)
+{
+	return (uint64_t)(zone - mgr->zones) * mgr->zone_size;
+}
+
+static struct nvme_zns_zone_mgr_req *
+nvme_zns_zone_mgr_get_req(struct spdk_nvme_zns_zone_mgr *mgr)
+{
+	struct nvme_zns_zone_mgr_req *req;
+
+	req = STAILQ_FIRST(&mgr->free_reqs);
+	if (req == NULL) {
+		return NULL;
+	}
+
+	STAILQ_REMOVE_HEAD(&mgr->free_reqs, stailq);
+	mgr->num_outstanding++;
+
+	return req;
+}
+
+static void
+nvme_zns_zone_mgr_put_req(struct spdk_nvme_zns_zone_mgr *mgr, struct nvme_zns_zone_mgr_req *req)
+{
+	assert(mgr->num_outstanding > 0);
+	mgr->num_outstanding--;
+	STAILQ_INSERT_HEAD(&mgr->free_reqs, req, stailq);
+}
+
+static void
+nvme_zns_zone_mgr_report_zones_done(void *cb_arg, const struct spdk_nvme_cpl *cpl);
+
+static int
+nvme_zns_zone_mgr_report_zones(struct spdk_nvme_zns_zone_mgr *mgr)
+{
+	memset(mgr->report, 0, mgr->report_size);
+
+	return spdk_nvme_zns_report_zones(mgr->ns, mgr->qpair, mgr->report, mgr->report_size,
+					  mgr->report_slba, SPDK_NVME_ZRA_LIST_ALL, true,
+					  nvme_zns_zone_mgr_report_zones_done, mgr);
+}
+
+static void
+nvme_zns_zone_mgr_refresh_done(struct spdk_nvme_zns_zone_mgr *mgr, int rc)
+{
+	spdk_nvme_zns_zone_mgr_refresh_cb cb_fn = mgr->refresh_cb_fn;
+	void *cb_arg = mgr->refresh_cb_arg;
+	uint64_t i;
+
+	mgr->refresh_cb_fn = NULL;
+	mgr->refresh_cb_arg = NULL;
+
+	if (rc == 0) {
+		mgr->num_open_zones = 0;
+		mgr->num_active_zones = 0;
+		for (i = 0; i < mgr->num_zones; i++) {
+			mgr->num_open_zones += nvme_zns_zone_state_is_open(mgr->zones[i].state);
+			mgr->num_active_zones += nvme_zns_zone_state_is_active(mgr->zones[i].state);
+		}
+	}
+
+	mgr->initialized = rc == 0;
+	cb_fn(cb_arg, rc);
+}
+
+static void
+nvme_zns_zone_mgr_report_zones_done(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_zns_zone_mgr *mgr = cb_arg;
+	struct spdk_nvme_zns_zone_desc *desc;
+	struct nvme_zns_zone *zone;
+	uint64_t i, num_descs, idx;
+	int rc;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_ERRLOG("Failed to report zones from LBA 0x%" PRIx64 "\n", mgr->report_slba);
+		nvme_zns_zone_mgr_refresh_done(mgr, -EIO);
+		return;
+	}
+
+	num_descs = spdk_min(mgr->report->nr_zones,
+			     (mgr->report_size - sizeof(*mgr->report)) / sizeof(*desc));
+	if (num_descs == 0) {
+		nvme_zns_zone_mgr_refresh_done(mgr, 0);
+		return;
+	}
+
+	for (i = 0; i < num_descs; i++) {
+		desc = &mgr->report->descs[i];
+		idx = desc->zslba / mgr->zone_size;
+		if (idx >= mgr->num_zones) {
+			break;
+		}
+
+		zone = &mgr->zones[idx];
+		zone->state = desc->zs;
+		zone->zcap = desc->zcap;
+		zone->wp = desc->wp;
+		zone->pending_lbas = 0;
+		mgr->report_slba = desc->zslba + mgr->zone_size;
+	}
+
+	if (mgr->report_slba / mgr->zone_size >= mgr->num_zones) {
+		nvme_zns_zone_mgr_refresh_done(mgr, 0);
+		return;
+	}
+
+	rc = nvme_zns_zone_mgr_report_zones(mgr);
+	if (rc != 0) {
+		nvme_zns_zone_mgr_refresh_done(mgr, rc);
+	}
+}
+
+int
+spdk_nvme_zns_zone_mgr_refresh(struct spdk_nvme_zns_zone_mgr *mgr,
+			       spdk_nvme_zns_zone_mgr_refresh_cb cb_fn, void *cb_arg)
+{
+	int rc;
+
+	if (mgr->num_outstanding != 0 || mgr->refresh_cb_fn != NULL) {
+		return -EBUSY;
+	}
+
+	/* The cached information can't be used until the refresh completes */
+	mgr->initialized = false;
+	mgr->report_slba = 0;
+	mgr->refresh_cb_fn = cb_fn;
+	mgr->refresh_cb_arg = cb_arg;
+
+	rc = nvme_zns_zone_mgr_report_zones(mgr);
+	if (rc != 0) {
+		mgr->refresh_cb_fn = NULL;
+		mgr->refresh_cb_arg = NULL;
+	}
+
+	return rc;
+}
+
+int
+spdk_nvme_zns_zone_mgr_get_zone_info(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				     struct spdk_nvme_zns_zone_info *info)
+{
+	struct nvme_zns_zone *zone;
+
+	zone = nvme_zns_zone_mgr_get_zone(mgr, zslba);
+	if (zone == NULL) {
+		return -EINVAL;
+	}
+
+	info->zslba = zslba;
+	info->write_pointer = zone->wp;
+	info->capacity = zone->zcap;
+	info->pending_lbas = zone->pending_lbas;
+	info->state = zone->state;
+
+	return 0;
+}
+
+static void
+nvme_zns_zone_mgr_reset_sgl(void *cb_arg, uint32_t offset)
+{
+	struct nvme_zns_zone_mgr_req *head = cb_arg;
+	struct spdk_nvme_zns_zone_mgr *mgr = head->mgr;
+	struct nvme_zns_zone_mgr_req *req;
+
+	STAILQ_FOREACH(req, &head->batch, stailq) {
+		if (offset < req->lba_count * mgr->sector_size) {
+			break;
+		}
+		offset -= req->lba_count * mgr->sector_size;
+	}
+
+	head->sgl_req = req;
+	head->sgl_offset = offset;
+}
+
+static int
+nvme_zns_zone_mgr_next_sge(void *cb_arg, void **address, uint32_t *length)
+{
+	struct nvme_zns_zone_mgr_req *head = cb_arg;
+	struct spdk_nvme_zns_zone_mgr *mgr = head->mgr;
+	struct nvme_zns_zone_mgr_req *req = head->sgl_req, *next;
+	uint32_t req_len;
+
+	assert(req != NULL);
+	req_len = req->lba_count * mgr->sector_size;
+	*address = (uint8_t *)req->buffer + head->sgl_offset;
+	*length = req_len - head->sgl_offset;
+
+	/* Coalesce the following requests whose buffers are contiguous */
+	next = STAILQ_NEXT(req, stailq);
+	while (next != NULL && next->buffer == (uint8_t *)req->buffer + req_len) {
+		req = next;
+		req_len = req->lba_count * mgr->sector_size;
+		*length += req_len;
+		next = STAILQ_NEXT(req, stailq);
+	}
+
+	head->sgl_req = next;
+	head->sgl_offset = 0;
+
+	return 0;
+}
+
+static void nvme_zns_zone_mgr_append_done(void *cb_arg, const struct spdk_nvme_cpl *cpl);
+
+/*
+ * Submit the appends queued to a zone, merging as many of them as the maximum zone append
+ * size and the number of segments allow into a single command.
+ */
+static int
+nvme_zns_zone_mgr_submit_appends(struct spdk_nvme_zns_zone_mgr *mgr, struct nvme_zns_zone *zone)
+{
+	struct nvme_zns_zone_mgr_req *head, *req, *last;
+	uint64_t lba_count;
+	uint32_t num_segments = 1;
+	int rc;
+
+	head = STAILQ_FIRST(&zone->queued);
+	assert(head != NULL);
+	STAILQ_REMOVE_HEAD(&zone->queued, stailq);
+	STAILQ_INIT(&head->batch);
+	STAILQ_INSERT_TAIL(&head->batch, head, stailq);
+	lba_count = head->lba_count;
+	last = head;
+
+	while ((req = STAILQ_FIRST(&zone->queued)) != NULL) {
+		if (req->io_flags != head->io_flags ||
+		    (lba_count + req->lba_count) * mgr->sector_size > mgr->max_append_size) {
+			break;
+		}
+
+		if (req->buffer != (uint8_t *)last->buffer + last->lba_count * mgr->sector_size) {
+			if (num_segments == mgr->max_segments) {
+				break;
+			}
+			num_segments++;
+		}
+
+		STAILQ_REMOVE_HEAD(&zone->queued, stailq);
+		STAILQ_INSERT_TAIL(&head->batch, req, stailq);
+		lba_count += req->lba_count;
+		last = req;
+	}
+
+	rc = spdk_nvme_zns_zone_appendv(mgr->ns, mgr->qpair, nvme_zns_zone_mgr_get_zslba(mgr, zone),
+					lba_count, nvme_zns_zone_mgr_append_done, head, head->io_flags,
+					nvme_zns_zone_mgr_reset_sgl, nvme_zns_zone_mgr_next_sge);
+	if (rc != 0) {
+		/* Put the requests back to the front of the queue, keeping their order */
+		STAILQ_CONCAT(&head->batch, &zone->queued);
+		STAILQ_INIT(&zone->queued);
+		STAILQ_CONCAT(&zone->queued, &head->batch);
+		return rc;
+	}
+
+	zone->num_inflight++;
+
+	return 0;
+}
+
+static void
+nvme_zns_zone_mgr_complete_batch(struct nvme_zns_zone_mgr_req *head,
+				 const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_zns_zone_mgr *mgr = head->mgr;
+	struct nvme_zns_zone *zone = head->zone;
+	struct nvme_zns_zone_mgr_req *req;
+	struct spdk_nvme_cpl req_cpl = *cpl;
+	uint64_t lba = (uint64_t)cpl->cdw1 << 32 | cpl->cdw0;
+	spdk_nvme_cmd_cb cb_fn;
+	void *cb_arg;
+
+	while ((req = STAILQ_FIRST(&head->batch)) != NULL) {
+		STAILQ_REMOVE_HEAD(&head->batch, stailq);
+		zone->pending_lbas -= req->lba_count;
+
+		if (!spdk_nvme_cpl_is_error(cpl)) {
+			req_cpl.cdw0 = (uint32_t)lba;
+			req_cpl.cdw1 = (uint32_t)(lba >> 32);
+			lba += req->lba_count;
+		}
+
+		cb_fn = req->cb_fn;
+		cb_arg = req->cb_arg;
+		nvme_zns_zone_mgr_put_req(mgr, req);
+		cb_fn(cb_arg, &req_cpl);
+	}
+}
+
+static void
+nvme_zns_zone_mgr_flush_zone(struct spdk_nvme_zns_zone_mgr *mgr, struct nvme_zns_zone *zone)
+{
+	struct nvme_zns_zone_mgr_req *head;
+	struct spdk_nvme_cpl cpl = {};
+	int rc;
+
+	while (!STAILQ_EMPTY(&zone->queued) && zone->num_inflight < mgr->opts.max_zone_inflight) {
+		rc = nvme_zns_zone_mgr_submit_appends(mgr, zone);
+		if (rc == 0) {
+			continue;
+		}
+
+		/* Retry when one of the outstanding commands completes */
+		if (zone->num_inflight > 0) {
+			break;
+		}
+
+		SPDK_ERRLOG("Failed to submit zone append: %d\n", rc);
+		head = STAILQ_FIRST(&zone->queued);
+		STAILQ_INIT(&head->batch);
+		STAILQ_CONCAT(&head->batch, &zone->queued);
+		cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		nvme_zns_zone_mgr_complete_batch(head, &cpl);
+		break;
+	}
+}
+
+static void
+nvme_zns_zone_mgr_append_done(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_zns_zone_mgr_req *head = cb_arg;
+	struct spdk_nvme_zns_zone_mgr *mgr = head->mgr;
+	struct nvme_zns_zone *zone = head->zone;
+	struct nvme_zns_zone_mgr_req *req;
+	uint64_t lba, zslba;
+
+	assert(zone->num_inflight > 0);
+	zone->num_inflight--;
+
+	if (!spdk_nvme_cpl_is_error(cpl)) {
+		lba = (uint64_t)cpl->cdw1 << 32 | cpl->cdw0;
+		STAILQ_FOREACH(req, &head->batch, stailq) {
+			lba += req->lba_count;
+		}
+
+		zslba = nvme_zns_zone_mgr_get_zslba(mgr, zone);
+		zone->wp = spdk_max(zone->wp, lba);
+		if (zone->wp >= zslba + zone->zcap) {
+			nvme_zns_zone_mgr_set_state(mgr, zone, SPDK_NVME_ZONE_STATE_FULL);
+		}
+	}
+
+	/* Submit the appends that were queued in the meantime before completing these */
+	nvme_zns_zone_mgr_flush_zone(mgr, zone);
+	nvme_zns_zone_mgr_complete_batch(head, cpl);
+}
+
+int
+spdk_nvme_zns_zone_mgr_append(struct spdk_nvme_zns_zone_mgr *mgr, void *buffer,
+			      uint64_t zslba, uint32_t lba_count,
+			      spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags)
+{
+	struct nvme_zns_zone *zone;
+	struct nvme_zns_zone_mgr_req *req;
+	uint8_t prev_state;
+	int rc;
+
+	zone = nvme_zns_zone_mgr_get_zone(mgr, zslba);
+	if (zone == NULL || lba_count == 0 ||
+	    (uint64_t)lba_count * mgr->sector_size > mgr->max_append_size) {
+		return -EINVAL;
+	}
+
+	switch (zone->state) {
+	case SPDK_NVME_ZONE_STATE_EMPTY:
+	case SPDK_NVME_ZONE_STATE_IOPEN:
+	case SPDK_NVME_ZONE_STATE_EOPEN:
+	case SPDK_NVME_ZONE_STATE_CLOSED:
+		break;
+	case SPDK_NVME_ZONE_STATE_FULL:
+		return -ENOSPC;
+	default:
+		return -EINVAL;
+	}
+
+	if (zone->wp + zone->pending_lbas + lba_count > zslba + zone->zcap) {
+		return -ENOSPC;
+	}
+
+	if (!nvme_zns_zone_mgr_can_open(mgr, zone)) {
+		return -EBUSY;
+	}
+
+	req = nvme_zns_zone_mgr_get_req(mgr);
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	req->zone = zone;
+	req->buffer = buffer;
+	req->lba_count = lba_count;
+	req->io_flags = io_flags;
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	/* Writing to an empty or closed zone implicitly opens it */
+	prev_state = zone->state;
+	if (!nvme_zns_zone_state_is_open(zone->state)) {
+		nvme_zns_zone_mgr_set_state(mgr, zone, SPDK_NVME_ZONE_STATE_IOPEN);
+	}
+
+	zone->pending_lbas += lba_count;
+	STAILQ_INSERT_TAIL(&zone->queued, req, stailq);
+	if (zone->num_inflight >= mgr->opts.max_zone_inflight) {
+		return 0;
+	}
+
+	rc = nvme_zns_zone_mgr_submit_appends(mgr, zone);
+	if (rc != 0 && zone->num_inflight == 0) {
+		/* Nothing else was queued if nothing is outstanding */
+		assert(STAILQ_FIRST(&zone->queued) == req);
+		STAILQ_REMOVE_HEAD(&zone->queued, stailq);
+		zone->pending_lbas -= lba_count;
+		nvme_zns_zone_mgr_set_state(mgr, zone, prev_state);
+		nvme_zns_zone_mgr_put_req(mgr, req);
+		return rc;
+	}
+
+	return 0;
+}
+
+static void
+nvme_zns_zone_mgr_mgmt_done(void *ctx, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_zns_zone_mgr_req *req = ctx;
+	struct spdk_nvme_zns_zone_mgr *mgr = req->mgr;
+	struct nvme_zns_zone *zone = req->zone;
+	uint64_t zslba = nvme_zns_zone_mgr_get_zslba(mgr, zone);
+	spdk_nvme_cmd_cb cb_fn = req->cb_fn;
+	void *cb_arg = req->cb_arg;
+
+	if (!spdk_nvme_cpl_is_error(cpl)) {
+		switch (req->zsa) {
+		case SPDK_NVME_ZONE_OPEN:
+			nvme_zns_zone_mgr_set_state(mgr, zone, SPDK_NVME_ZONE_STATE_EOPEN);
+			break;
+		case SPDK_NVME_ZONE_CLOSE:
+			/* A zone that was never written goes back to empty when it is closed */
+			nvme_zns_zone_mgr_set_state(mgr, zone, zone->wp == zslba ?
+						    SPDK_NVME_ZONE_STATE_EMPTY : SPDK_NVME_ZONE_STATE_CLOSED);
+			break;
+		case SPDK_NVME_ZONE_FINISH:
+			nvme_zns_zone_mgr_set_state(mgr, zone, SPDK_NVME_ZONE_STATE_FULL);
+			zone->wp = zslba + zone->zcap;
+			break;
+		case SPDK_NVME_ZONE_RESET:
+			nvme_zns_zone_mgr_set_state(mgr, zone, SPDK_NVME_ZONE_STATE_EMPTY);
+			zone->wp = zslba;
+			break;
+		default:
+			assert(0);
+			break;
+		}
+	}
+
+	nvme_zns_zone_mgr_put_req(mgr, req);
+	cb_fn(cb_arg, cpl);
+}
+
+static int
+nvme_zns_zone_mgr_mgmt_send(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+			    uint8_t zsa, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct nvme_zns_zone *zone;
+	struct nvme_zns_zone_mgr_req *req;
+	int rc;
+
+	zone = nvme_zns_zone_mgr_get_zone(mgr, zslba);
+	if (zone == NULL) {
+		return -EINVAL;
+	}
+
+	/* The cached state would not be predictable with appends in flight */
+	if (zone->pending_lbas != 0) {
+		return -EBUSY;
+	}
+
+	if (zsa == SPDK_NVME_ZONE_OPEN && !nvme_zns_zone_mgr_can_open(mgr, zone)) {
+		return -EBUSY;
+	}
+
+	req = nvme_zns_zone_mgr_get_req(mgr);
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	req->zone = zone;
+	req->zsa = zsa;
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	rc = nvme_zns_zone_mgmt_send(mgr->ns, mgr->qpair, zslba, false, zsa,
+				     nvme_zns_zone_mgr_mgmt_done, req);
+	if (rc != 0) {
+		nvme_zns_zone_mgr_put_req(mgr, req);
+	}
+
+	return rc;
+}
+
+int
+spdk_nvme_zns_zone_mgr_open_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				 spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgr_mgmt_send(mgr, zslba, SPDK_NVME_ZONE_OPEN, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_zone_mgr_close_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				  spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgr_mgmt_send(mgr, zslba, SPDK_NVME_ZONE_CLOSE, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_zone_mgr_finish_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				   spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgr_mgmt_send(mgr, zslba, SPDK_NVME_ZONE_FINISH, cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_zone_mgr_reset_zone(struct spdk_nvme_zns_zone_mgr *mgr, uint64_t zslba,
+				  spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgr_mgmt_send(mgr, zslba, SPDK_NVME_ZONE_RESET, cb_fn, cb_arg);
+}
@@ -43,6 +43,11 @@
 
 #define NVMF_ABORT_COMMAND_LIMIT 3
 
+/* Weight of the newest sample in the namespace latency average, as a power of 2 */
+#define NVMF_NS_LATENCY_EWMA_SHIFT 3
+/* Number of completions between two adjustments of the namespace I/O limit */
+#define NVMF_NS_LATENCY_WINDOW 32
+
 /*
  * Support for custom admin command handlers
  */
@@ -805,9 +810,13 @@ _nvmf_ctrlr_connect(struct spdk_nvmf_request *req)
 	if (0 == qpair->qid) {
 		qpair->group->stat.admin_qpairs++;
 		qpair->group->stat.current_admin_qpairs++;
+		nvmf_poll_group_update_metrics(qpair->group, NVMF_METRIC_ADMIN_QPAIRS, 1);
+		nvmf_poll_group_update_metrics(qpair->group, NVMF_METRIC_CURRENT_ADMIN_QPAIRS, 1);
 	} else {
 		qpair->group->stat.io_qpairs++;
 		qpair->group->stat.current_io_qpairs++;
+		nvmf_poll_group_update_metrics(qpair->group, NVMF_METRIC_IO_QPAIRS, 1);
+		nvmf_poll_group_update_metrics(qpair->group, NVMF_METRIC_CURRENT_IO_QPAIRS, 1);
 	}
 
 	if (cmd->qid == 0) {
@@ -2250,102 +2259,124 @@ nvmf_get_error_log_page(struct spdk_nvmf_ctrlr *ctrlr, struct iovec *iovs, int i
 	/* TODO: actually fill out log page data */
 }
 
-static void
-nvmf_get_ana_log_page(struct spdk_nvmf_ctrlr *ctrlr, struct iovec *iovs, int iovcnt,
-		      uint64_t offset, uint32_t length, uint32_t rae)
+/*
+ * Build the ANA log page of the controller into a newly allocated buffer. The namespaces
+ *  are visited once, each one written in the slot of its group's descriptor.
+ */
+static uint8_t *
+nvmf_ana_log_page_build(struct spdk_nvmf_ctrlr *ctrlr, size_t *len)
 {
+	struct spdk_nvmf_subsystem *subsystem = ctrlr->subsys;
 	struct spdk_nvme_ana_page ana_hdr;
 	struct spdk_nvme_ana_group_descriptor ana_desc;
-	size_t copy_len, copied_len;
-	uint32_t num_anagrp = 0, anagrpid;
+	uint32_t num_anagrp = 0, num_ns = 0, anagrpid;
 	struct spdk_nvmf_ns *ns;
-	struct spdk_iov_xfer ix;
+	size_t *nsid_pos, pos;
+	uint8_t *buf;
 
-	spdk_iov_xfer_init(&ix, iovs, iovcnt);
+	for (anagrpid = 1; anagrpid <= subsystem->max_nsid; anagrpid++) {
+		if (subsystem->ana_group[anagrpid - 1] > 0) {
+			num_anagrp++;
+			num_ns += subsystem->ana_group[anagrpid - 1];
+		}
+	}
 
-	if (length == 0) {
-		goto done;
+	*len = sizeof(ana_hdr) + num_anagrp * sizeof(ana_desc) + num_ns * sizeof(uint32_t);
+	buf = calloc(1, *len);
+	nsid_pos = calloc(spdk_max(subsystem->max_nsid, 1), sizeof(*nsid_pos));
+	if (buf == NULL || nsid_pos == NULL) {
+		free(buf);
+		free(nsid_pos);
+		return NULL;
 	}
 
-	if (offset >= sizeof(ana_hdr)) {
-		offset -= sizeof(ana_hdr);
-	} else {
-		for (anagrpid = 1; anagrpid <= ctrlr->subsys->max_nsid; anagrpid++) {
-			if (ctrlr->subsys->ana_group[anagrpid - 1] > 0) {
-				num_anagrp++;
-			}
-		}
+	memset(&ana_hdr, 0, sizeof(ana_hdr));
+	ana_hdr.num_ana_group_desc = num_anagrp;
+	/* TODO: Support Change Count. */
+	ana_hdr.change_count = 0;
+	memcpy(buf, &ana_hdr, sizeof(ana_hdr));
+	pos = sizeof(ana_hdr);
 
-		memset(&ana_hdr, 0, sizeof(ana_hdr));
+	for (anagrpid = 1; anagrpid <= subsystem->max_nsid; anagrpid++) {
+		if (subsystem->ana_group[anagrpid - 1] == 0) {
+			continue;
+		}
 
-		ana_hdr.num_ana_group_desc = num_anagrp;
-		/* TODO: Support Change Count. */
-		ana_hdr.change_count = 0;
+		memset(&ana_desc, 0, sizeof(ana_desc));
+		ana_desc.ana_group_id = anagrpid;
+		ana_desc.num_of_nsid = subsystem->ana_group[anagrpid - 1];
+		ana_desc.ana_state = nvmf_ctrlr_get_ana_state(ctrlr, anagrpid);
 
-		copy_len = spdk_min(sizeof(ana_hdr) - offset, length);
-		copied_len = spdk_iov_xfer_from_buf(&ix, (const char *)&ana_hdr + offset, copy_len);
-		assert(copied_len == copy_len);
-		length -= copied_len;
-		offset = 0;
+		/* The descriptors are only 4-byte aligned within the page */
+		memcpy(buf + pos, &ana_desc, sizeof(ana_desc));
+		pos += sizeof(ana_desc);
+		nsid_pos[anagrpid - 1] = pos;
+		pos += ana_desc.num_of_nsid * sizeof(uint32_t);
 	}
 
-	if (length == 0) {
-		goto done;
+	for (ns = spdk_nvmf_subsystem_get_first_ns(subsystem); ns != NULL;
+	     ns = spdk_nvmf_subsystem_get_next_ns(subsystem, ns)) {
+		assert(ns->anagrpid - 1 < subsystem->max_nsid);
+		assert(nsid_pos[ns->anagrpid - 1] + sizeof(uint32_t) <= *len);
+		memcpy(buf + nsid_pos[ns->anagrpid - 1], &ns->nsid, sizeof(uint32_t));
+		nsid_pos[ns->anagrpid - 1] += sizeof(uint32_t);
 	}
 
-	for (anagrpid = 1; anagrpid <= ctrlr->subsys->max_nsid; anagrpid++) {
-		if (ctrlr->subsys->ana_group[anagrpid - 1] == 0) {
-			continue;
-		}
-
-		if (offset >= sizeof(ana_desc)) {
-			offset -= sizeof(ana_desc);
-		} else {
-			memset(&ana_desc, 0, sizeof(ana_desc));
+	free(nsid_pos);
 
-			ana_desc.ana_group_id = anagrpid;
-			ana_desc.num_of_nsid = ctrlr->subsys->ana_group[anagrpid - 1];
-			ana_desc.ana_state = nvmf_ctrlr_get_ana_state(ctrlr, anagrpid);
-
-			copy_len = spdk_min(sizeof(ana_desc) - offset, length);
-			copied_len = spdk_iov_xfer_from_buf(&ix, (const char *)&ana_desc + offset,
-							    copy_len);
-			assert(copied_len == copy_len);
-			length -= copied_len;
-			offset = 0;
+	return buf;
+}
 
-			if (length == 0) {
-				goto done;
-			}
-		}
+static void
+nvmf_get_ana_log_page(struct spdk_nvmf_ctrlr *ctrlr, struct iovec *iovs, int iovcnt,
+		      uint64_t offset, uint32_t length, uint32_t rae)
+{
+	struct spdk_nvmf_subsystem *subsystem = ctrlr->subsys;
+	struct spdk_nvmf_subsystem_listener *listener = ctrlr->listener;
+	struct spdk_iov_xfer ix;
+	uint8_t *buf;
+	size_t len;
 
-		/* TODO: Revisit here about O(n^2) cost if we have subsystem with
-		 * many namespaces in the future.
-		 */
-		for (ns = spdk_nvmf_subsystem_get_first_ns(ctrlr->subsys); ns != NULL;
-		     ns = spdk_nvmf_subsystem_get_next_ns(ctrlr->subsys, ns)) {
-			if (ns->anagrpid != anagrpid) {
-				continue;
-			}
+	spdk_iov_xfer_init(&ix, iovs, iovcnt);
 
-			if (offset >= sizeof(uint32_t)) {
-				offset -= sizeof(uint32_t);
-				continue;
-			}
+	if (length == 0) {
+		goto done;
+	}
 
-			copy_len = spdk_min(sizeof(uint32_t) - offset, length);
-			copied_len = spdk_iov_xfer_from_buf(&ix, (const char *)&ns->nsid + offset,
-							    copy_len);
-			assert(copied_len == copy_len);
-			length -= copied_len;
-			offset = 0;
+	if (spdk_unlikely(listener == NULL)) {
+		/* Not worth caching, every group is inaccessible */
+		buf = nvmf_ana_log_page_build(ctrlr, &len);
+		if (buf != NULL && offset < len) {
+			spdk_iov_xfer_from_buf(&ix, buf + offset, spdk_min(len - offset, length));
+		}
+		free(buf);
+		goto done;
+	}
 
-			if (length == 0) {
-				goto done;
-			}
+	/*
+	 * Hosts poll this page, so it is only rebuilt when the ANA groups or states it
+	 *  reflects have changed since the last time.
+	 */
+	pthread_mutex_lock(&subsystem->mutex);
+	if (listener->ana_log.buf == NULL ||
+	    listener->ana_log.ana_group_change_count != subsystem->ana_group_change_count ||
+	    listener->ana_log.ana_state_change_count != listener->ana_state_change_count) {
+		buf = nvmf_ana_log_page_build(ctrlr, &len);
+		if (buf != NULL) {
+			free(listener->ana_log.buf);
+			listener->ana_log.buf = buf;
+			listener->ana_log.len = len;
+			listener->ana_log.ana_group_change_count = subsystem->ana_group_change_count;
+			listener->ana_log.ana_state_change_count = listener->ana_state_change_count;
 		}
 	}
 
+	if (listener->ana_log.buf != NULL && offset < listener->ana_log.len) {
+		spdk_iov_xfer_from_buf(&ix, listener->ana_log.buf + offset,
+				       spdk_min(listener->ana_log.len - offset, length));
+	}
+	pthread_mutex_unlock(&subsystem->mutex);
+
 done:
 	if (!rae) {
 		nvmf_ctrlr_unmask_aen(ctrlr, SPDK_NVME_ASYNC_EVENT_ANA_CHANGE_MASK_BIT);
@@ -4310,6 +4341,54 @@ spdk_nvmf_request_free(struct spdk_nvmf_request *req)
 	return 0;
 }
 
+/* Halve the number of I/O admitted to the namespace when its average latency exceeds the
+ * target, start raising it again once the latency has recovered.
+ */
+static void
+nvmf_ns_info_update_io_limit(struct spdk_nvmf_subsystem_pg_ns_info *ns_info, uint64_t latency)
+{
+	uint32_t max_limit;
+
+	if (ns_info->latency_ewma_ticks == 0) {
+		ns_info->latency_ewma_ticks = latency;
+	} else {
+		ns_info->latency_ewma_ticks -= ns_info->latency_ewma_ticks >> NVMF_NS_LATENCY_EWMA_SHIFT;
+		ns_info->latency_ewma_ticks += latency >> NVMF_NS_LATENCY_EWMA_SHIFT;
+	}
+
+	if (++ns_info->latency_samples < NVMF_NS_LATENCY_WINDOW) {
+		return;
+	}
+	ns_info->latency_samples = 0;
+
+	max_limit = ns_info->max_io_outstanding != 0 ? ns_info->max_io_outstanding : UINT32_MAX;
+	if (ns_info->latency_ewma_ticks > ns_info->latency_target_ticks) {
+		/* Shed from the current queue depth rather than from a possibly unbounded limit. */
+		ns_info->io_limit = spdk_max(spdk_min((uint64_t)ns_info->io_limit,
+						      ns_info->io_outstanding + 1) / 2, 1);
+	} else if (ns_info->io_limit < max_limit) {
+		ns_info->io_limit += spdk_min(spdk_max(ns_info->io_limit / 8, 1),
+					      max_limit - ns_info->io_limit);
+	}
+}
+
+static bool
+nvmf_ns_info_admit_io(struct spdk_nvmf_subsystem_pg_ns_info *ns_info,
+		      struct spdk_nvmf_request *req)
+{
+	if (spdk_likely(ns_info->max_io_outstanding == 0 && ns_info->latency_target_ticks == 0)) {
+		return true;
+	}
+
+	if (ns_info->io_outstanding >= ns_info->io_limit) {
+		req->admit_tsc = 0;
+		return false;
+	}
+
+	req->admit_tsc = ns_info->latency_target_ticks != 0 ? spdk_get_ticks() : 0;
+	return true;
+}
+
 static void
 _nvmf_request_complete(void *ctx)
 {
@@ -4336,6 +4415,8 @@ _nvmf_request_complete(void *ctx)
 		is_aer = req->cmd->nvme_cmd.opc == SPDK_NVME_OPC_ASYNC_EVENT_REQUEST;
 		if (spdk_likely(qpair->qid != 0)) {
 			qpair->group->stat.completed_nvme_io++;
+			nvmf_poll_group_update_metrics(qpair->group,
+						       NVMF_METRIC_COMPLETED_NVME_IO, 1);
 		}
 
 		/*
@@ -4397,7 +4478,13 @@ _nvmf_request_complete(void *ctx)
 
 				/* NOTE: This implicitly also checks for 0, since 0 - 1 wraps around to UINT32_MAX. */
 				if (spdk_likely(nsid - 1 < sgroup->num_ns)) {
-					sgroup->ns_info[nsid - 1].io_outstanding--;
+					ns_info = &sgroup->ns_info[nsid - 1];
+					ns_info->io_outstanding--;
+					if (spdk_unlikely(ns_info->latency_target_ticks != 0 &&
+							  req->admit_tsc != 0)) {
+						nvmf_ns_info_update_io_limit(ns_info,
+									     spdk_get_ticks() - req->admit_tsc);
+					}
 				}
 			}
 		}
@@ -4524,6 +4611,24 @@ nvmf_check_subsystem_active(struct spdk_nvmf_request *req)
 				return false;
 			}
 
+			if (spdk_unlikely(!nvmf_ns_info_admit_io(ns_info, req))) {
+				/* The namespace is overloaded. Instead of queueing the request,
+				 * ask the host to retry it later or, with multipath, on another path.
+				 */
+				if (qpair->ctrlr->subsys->flags.ana_reporting) {
+					req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_PATH;
+					req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_PATH_ERROR;
+				} else {
+					req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+					req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_COMMAND_INTERRUPTED;
+				}
+				req->rsp->nvme_cpl.status.dnr = 0;
+				TAILQ_INSERT_TAIL(&qpair->outstanding, req, link);
+				ns_info->io_outstanding++;
+				_nvmf_request_complete(req);
+				return false;
+			}
+
 			ns_info->io_outstanding++;
 		}
 
@@ -257,6 +257,7 @@ nvmf_bdev_ctrl_queue_io(struct spdk_nvmf_request *req, struct spdk_bdev *bdev,
 		assert(false);
 	}
 	req->qpair->group->stat.pending_bdev_io++;
+	nvmf_poll_group_update_metrics(req->qpair->group, NVMF_METRIC_PENDING_BDEV_IO, 1);
 }
 
 bool
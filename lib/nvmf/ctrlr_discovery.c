@@ -20,23 +20,126 @@
 
 #include "spdk/log.h"
 
-void
-nvmf_update_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn)
+/* How long the discovery log change notices are held back to batch the changes together */
+#define NVMF_DISCOVERY_AEN_DELAY_US	(100 * 1000)
+
+struct nvmf_discovery_entry {
+	struct spdk_nvmf_subsystem			*subsystem;
+	struct spdk_nvme_transport_id			trid;
+	struct spdk_nvmf_discovery_log_page_entry	entry;
+};
+
+struct nvmf_discovery_aen_host {
+	char					nqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+	SLIST_ENTRY(nvmf_discovery_aen_host)	link;
+};
+
+static void
+nvmf_discovery_aen_clear(struct spdk_nvmf_tgt *tgt)
+{
+	struct nvmf_discovery_aen_host *host;
+
+	while ((host = SLIST_FIRST(&tgt->discovery_aen.hosts)) != NULL) {
+		SLIST_REMOVE_HEAD(&tgt->discovery_aen.hosts, link);
+		free(host);
+	}
+
+	tgt->discovery_aen.all_hosts = false;
+}
+
+static bool
+nvmf_discovery_aen_host_pending(struct spdk_nvmf_tgt *tgt, const char *hostnqn)
+{
+	struct nvmf_discovery_aen_host *host;
+
+	if (tgt->discovery_aen.all_hosts) {
+		return true;
+	}
+
+	SLIST_FOREACH(host, &tgt->discovery_aen.hosts, link) {
+		if (strcmp(host->nqn, hostnqn) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+nvmf_discovery_aen_send(struct spdk_nvmf_tgt *tgt)
 {
 	struct spdk_nvmf_subsystem *discovery_subsystem;
 	struct spdk_nvmf_ctrlr *ctrlr;
 
-	tgt->discovery_genctr++;
 	discovery_subsystem = spdk_nvmf_tgt_find_subsystem(tgt, SPDK_NVMF_DISCOVERY_NQN);
-
 	if (discovery_subsystem) {
 		/** There is a change in discovery log for hosts with given hostnqn */
 		TAILQ_FOREACH(ctrlr, &discovery_subsystem->ctrlrs, link) {
-			if (hostnqn == NULL || strcmp(hostnqn, ctrlr->hostnqn) == 0) {
+			if (nvmf_discovery_aen_host_pending(tgt, ctrlr->hostnqn)) {
 				spdk_thread_send_msg(ctrlr->thread, nvmf_ctrlr_async_event_discovery_log_change_notice, ctrlr);
 			}
 		}
 	}
+
+	nvmf_discovery_aen_clear(tgt);
+}
+
+static int
+nvmf_discovery_aen_poll(void *ctx)
+{
+	struct spdk_nvmf_tgt *tgt = ctx;
+
+	spdk_poller_unregister(&tgt->discovery_aen.poller);
+	nvmf_discovery_aen_send(tgt);
+
+	return SPDK_POLLER_BUSY;
+}
+
+void
+nvmf_update_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn)
+{
+	struct nvmf_discovery_aen_host *host;
+
+	tgt->discovery_genctr++;
+
+	if (tgt->discovery_aen.stopped ||
+	    spdk_nvmf_tgt_find_subsystem(tgt, SPDK_NVMF_DISCOVERY_NQN) == NULL) {
+		return;
+	}
+
+	if (hostnqn == NULL) {
+		nvmf_discovery_aen_clear(tgt);
+		tgt->discovery_aen.all_hosts = true;
+	} else if (!nvmf_discovery_aen_host_pending(tgt, hostnqn)) {
+		host = calloc(1, sizeof(*host));
+		if (host == NULL) {
+			nvmf_discovery_aen_clear(tgt);
+			tgt->discovery_aen.all_hosts = true;
+		} else {
+			snprintf(host->nqn, sizeof(host->nqn), "%s", hostnqn);
+			SLIST_INSERT_HEAD(&tgt->discovery_aen.hosts, host, link);
+		}
+	}
+
+	/* Changes usually come in bursts (e.g. a subsystem being set up), so instead of notifying
+	 * the discovery controllers of each of them, notify them of all the changes made within
+	 * NVMF_DISCOVERY_AEN_DELAY_US at once.
+	 */
+	if (tgt->discovery_aen.poller == NULL) {
+		tgt->discovery_aen.poller = SPDK_POLLER_REGISTER(nvmf_discovery_aen_poll, tgt,
+					    NVMF_DISCOVERY_AEN_DELAY_US);
+		if (tgt->discovery_aen.poller == NULL) {
+			nvmf_discovery_aen_send(tgt);
+		}
+	}
+}
+
+void
+nvmf_discovery_aen_fini(struct spdk_nvmf_tgt *tgt)
+{
+	spdk_poller_unregister(&tgt->discovery_aen.poller);
+	nvmf_discovery_aen_clear(tgt);
+	tgt->discovery_aen.stopped = true;
 }
 
 static bool
@@ -64,110 +167,178 @@ nvmf_discovery_compare_tr_svcid(const struct spdk_nvme_transport_id *trid1,
 	return strcasecmp(trid1->trsvcid, trid2->trsvcid) == 0;
 }
 
-static struct spdk_nvmf_discovery_log_page *
-nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn, size_t *log_page_size,
-			    struct spdk_nvme_transport_id *cmd_source_trid)
+static bool
+nvmf_discovery_subsystem_visible(struct spdk_nvmf_subsystem *subsystem, const char *hostnqn)
+{
+	if ((subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE) ||
+	    (subsystem->state == SPDK_NVMF_SUBSYSTEM_DEACTIVATING)) {
+		return false;
+	}
+
+	return spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn);
+}
+
+static bool
+nvmf_discovery_entry_visible(struct spdk_nvmf_tgt *tgt, const struct nvmf_discovery_entry *entry,
+			     const struct spdk_nvme_transport_id *cmd_source_trid)
+{
+	const struct spdk_nvme_transport_id *trid = &entry->trid;
+
+	if (entry->subsystem->subtype == SPDK_NVMF_SUBTYPE_DISCOVERY) {
+		struct spdk_nvme_transport_id source_trid = *cmd_source_trid;
+		struct spdk_nvme_transport_id listener_trid = *trid;
+
+		/* Do not generate an entry for the transport ID for the listener
+		 * entry associated with the discovery controller that generated
+		 * this command.  We compare a copy of the trids, since the trids
+		 * here don't contain the subnqn, and the transport_id_compare()
+		 * function will compare the subnqns.
+		 */
+		source_trid.subnqn[0] = '\0';
+		listener_trid.subnqn[0] = '\0';
+		if (!spdk_nvme_transport_id_compare(&listener_trid, &source_trid)) {
+			return false;
+		}
+	}
+
+	if ((tgt->discovery_filter & SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_TYPE) != 0 &&
+	    !nvmf_discovery_compare_trtype(trid, cmd_source_trid)) {
+		SPDK_DEBUGLOG(nvmf, "ignore listener type %d (%s) due to type mismatch\n",
+			      trid->trtype, trid->trstring);
+		return false;
+	}
+	if ((tgt->discovery_filter & SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_ADDRESS) != 0 &&
+	    !nvmf_discovery_compare_tr_addr(trid, cmd_source_trid)) {
+		SPDK_DEBUGLOG(nvmf, "ignore listener addr %s due to addr mismatch\n",
+			      trid->traddr);
+		return false;
+	}
+	if ((tgt->discovery_filter & SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_SVCID) != 0 &&
+	    !nvmf_discovery_compare_tr_svcid(trid, cmd_source_trid)) {
+		SPDK_DEBUGLOG(nvmf, "ignore listener svcid %s due to svcid mismatch\n",
+			      trid->trsvcid);
+		return false;
+	}
+
+	return true;
+}
+
+/* Rebuild the entries of the discovery log if they're older than the discovery generation
+ * counter.  Must be called with the target's mutex held.
+ */
+static int
+nvmf_discovery_log_refresh(struct spdk_nvmf_tgt *tgt)
 {
-	uint64_t numrec = 0;
 	struct spdk_nvmf_subsystem *subsystem;
 	struct spdk_nvmf_subsystem_listener *listener;
-	struct spdk_nvmf_discovery_log_page_entry *entry;
-	struct spdk_nvmf_discovery_log_page *disc_log;
-	size_t cur_size;
+	struct nvmf_discovery_entry *entries, *entry;
+	uint32_t num_entries = 0;
+
+	if (tgt->discovery_log.valid && tgt->discovery_log.genctr == tgt->discovery_genctr) {
+		return 0;
+	}
 
 	SPDK_DEBUGLOG(nvmf, "Generating log page for genctr %" PRIu64 "\n",
 		      tgt->discovery_genctr);
 
-	cur_size = sizeof(struct spdk_nvmf_discovery_log_page);
-	disc_log = calloc(1, cur_size);
-	if (disc_log == NULL) {
+	for (subsystem = spdk_nvmf_subsystem_get_first(tgt);
+	     subsystem != NULL;
+	     subsystem = spdk_nvmf_subsystem_get_next(subsystem)) {
+		for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
+		     listener = spdk_nvmf_subsystem_get_next_listener(subsystem, listener)) {
+			num_entries++;
+		}
+	}
+
+	entries = calloc(spdk_max(num_entries, 1), sizeof(*entries));
+	if (entries == NULL) {
 		SPDK_ERRLOG("Discovery log page memory allocation error\n");
-		return NULL;
+		return -ENOMEM;
 	}
 
+	entry = entries;
 	for (subsystem = spdk_nvmf_subsystem_get_first(tgt);
 	     subsystem != NULL;
 	     subsystem = spdk_nvmf_subsystem_get_next(subsystem)) {
-		if ((subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE) ||
-		    (subsystem->state == SPDK_NVMF_SUBSYSTEM_DEACTIVATING)) {
-			continue;
+		for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
+		     listener = spdk_nvmf_subsystem_get_next_listener(subsystem, listener)) {
+			SPDK_DEBUGLOG(nvmf, "listener %s:%s trtype %s\n", listener->trid->traddr,
+				      listener->trid->trsvcid, listener->trid->trstring);
+
+			entry->subsystem = subsystem;
+			entry->trid = *listener->trid;
+			entry->entry.portid = listener->id;
+			entry->entry.cntlid = 0xffff;
+			entry->entry.asqsz = listener->transport->opts.max_aq_depth;
+			entry->entry.subtype = subsystem->subtype;
+			snprintf(entry->entry.subnqn, sizeof(entry->entry.subnqn), "%s",
+				 subsystem->subnqn);
+
+			nvmf_transport_listener_discover(listener->transport, listener->trid,
+							 &entry->entry);
+			entry++;
 		}
+	}
 
-		if (!spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn)) {
-			continue;
-		}
+	free(tgt->discovery_log.entries);
+	tgt->discovery_log.entries = entries;
+	tgt->discovery_log.num_entries = num_entries;
+	tgt->discovery_log.genctr = tgt->discovery_genctr;
+	tgt->discovery_log.valid = true;
 
-		for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
-		     listener = spdk_nvmf_subsystem_get_next_listener(subsystem, listener)) {
-			if (subsystem->subtype == SPDK_NVMF_SUBTYPE_DISCOVERY) {
-				struct spdk_nvme_transport_id source_trid = *cmd_source_trid;
-				struct spdk_nvme_transport_id listener_trid = *listener->trid;
-
-				/* Do not generate an entry for the transport ID for the listener
-				 * entry associated with the discovery controller that generated
-				 * this command.  We compare a copy of the trids, since the trids
-				 * here don't contain the subnqn, and the transport_id_compare()
-				 * function will compare the subnqns.
-				 */
-				source_trid.subnqn[0] = '\0';
-				listener_trid.subnqn[0] = '\0';
-				if (!spdk_nvme_transport_id_compare(&listener_trid, &source_trid)) {
-					continue;
-				}
-			}
+	return 0;
+}
 
-			if ((tgt->discovery_filter & SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_TYPE) != 0 &&
-			    !nvmf_discovery_compare_trtype(listener->trid, cmd_source_trid)) {
-				SPDK_DEBUGLOG(nvmf, "ignore listener type %d (%s) due to type mismatch\n",
-					      listener->trid->trtype, listener->trid->trstring);
-				continue;
-			}
-			if ((tgt->discovery_filter & SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_ADDRESS) != 0 &&
-			    !nvmf_discovery_compare_tr_addr(listener->trid, cmd_source_trid)) {
-				SPDK_DEBUGLOG(nvmf, "ignore listener addr %s due to addr mismatch\n",
-					      listener->trid->traddr);
-				continue;
-			}
-			if ((tgt->discovery_filter & SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_SVCID) != 0 &&
-			    !nvmf_discovery_compare_tr_svcid(listener->trid, cmd_source_trid)) {
-				SPDK_DEBUGLOG(nvmf, "ignore listener svcid %s due to svcid mismatch\n",
-					      listener->trid->trsvcid);
-				continue;
-			}
+struct nvmf_discovery_log_xfer {
+	struct spdk_iov_xfer	ix;
+	uint64_t		offset;
+	uint64_t		pos;
+	uint32_t		length;
+};
 
-			SPDK_DEBUGLOG(nvmf, "listener %s:%s trtype %s\n", listener->trid->traddr, listener->trid->trsvcid,
-				      listener->trid->trstring);
+/* Append a chunk of the log page, copying the part of it that overlaps the requested range */
+static bool
+nvmf_discovery_log_xfer(struct nvmf_discovery_log_xfer *xfer, const void *buf, size_t len)
+{
+	size_t skip, copy_len;
 
-			size_t new_size = cur_size + sizeof(*entry);
-			void *new_log_page = realloc(disc_log, new_size);
+	if (xfer->pos + len > xfer->offset) {
+		skip = xfer->offset > xfer->pos ? xfer->offset - xfer->pos : 0;
+		copy_len = spdk_min(len - skip, xfer->length);
 
-			if (new_log_page == NULL) {
-				SPDK_ERRLOG("Discovery log page memory allocation error\n");
-				break;
-			}
+		copy_len = spdk_iov_xfer_from_buf(&xfer->ix, (const char *)buf + skip, copy_len);
+		xfer->length -= copy_len;
+	}
 
-			disc_log = new_log_page;
-			cur_size = new_size;
+	xfer->pos += len;
 
-			entry = &disc_log->entries[numrec];
-			memset(entry, 0, sizeof(*entry));
-			entry->portid = listener->id;
-			entry->cntlid = 0xffff;
-			entry->asqsz = listener->transport->opts.max_aq_depth;
-			entry->subtype = subsystem->subtype;
-			snprintf(entry->subnqn, sizeof(entry->subnqn), "%s", subsystem->subnqn);
+	return xfer->length > 0;
+}
 
-			nvmf_transport_listener_discover(listener->transport, listener->trid, entry);
+static uint64_t
+nvmf_discovery_log_numrec(struct spdk_nvmf_tgt *tgt, const char *hostnqn,
+			  const struct spdk_nvme_transport_id *cmd_source_trid)
+{
+	struct spdk_nvmf_subsystem *subsystem = NULL;
+	struct nvmf_discovery_entry *entry;
+	uint64_t numrec = 0;
+	bool allowed = false;
+	uint32_t i;
+
+	for (i = 0; i < tgt->discovery_log.num_entries; i++) {
+		entry = &tgt->discovery_log.entries[i];
+		/* The entries are grouped by subsystem, so check the host once per subsystem */
+		if (entry->subsystem != subsystem) {
+			subsystem = entry->subsystem;
+			allowed = nvmf_discovery_subsystem_visible(subsystem, hostnqn);
+		}
 
+		if (allowed && nvmf_discovery_entry_visible(tgt, entry, cmd_source_trid)) {
 			numrec++;
 		}
 	}
 
-	disc_log->numrec = numrec;
-	disc_log->genctr = tgt->discovery_genctr;
-	*log_page_size = cur_size;
-
-	return disc_log;
+	return numrec;
 }
 
 void
@@ -175,38 +346,55 @@ nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn, stru
 			    uint32_t iovcnt, uint64_t offset, uint32_t length,
 			    struct spdk_nvme_transport_id *cmd_source_trid)
 {
-	size_t copy_len = 0;
-	size_t zero_len = 0;
-	struct iovec *tmp;
-	size_t log_page_size = 0;
-	struct spdk_nvmf_discovery_log_page *discovery_log_page;
-
-	discovery_log_page = nvmf_generate_discovery_log(tgt, hostnqn, &log_page_size, cmd_source_trid);
-
-	/* Copy the valid part of the discovery log page, if any */
-	if (discovery_log_page) {
-		for (tmp = iov; tmp < iov + iovcnt; tmp++) {
-			copy_len = spdk_min(tmp->iov_len, length);
-			copy_len = spdk_min(log_page_size - offset, copy_len);
-
-			memcpy(tmp->iov_base, (char *)discovery_log_page + offset, copy_len);
-
-			offset += copy_len;
-			length -= copy_len;
-			zero_len = tmp->iov_len - copy_len;
-			if (log_page_size <= offset || length == 0) {
+	struct spdk_nvmf_discovery_log_page header = {};
+	struct nvmf_discovery_log_xfer xfer = { .offset = offset, .length = length };
+	struct spdk_nvmf_subsystem *subsystem = NULL;
+	struct nvmf_discovery_entry *entry;
+	bool allowed = false;
+	uint32_t i;
+	int rc;
+
+	pthread_mutex_lock(&tgt->mutex);
+	rc = nvmf_discovery_log_refresh(tgt);
+	if (rc != 0) {
+		pthread_mutex_unlock(&tgt->mutex);
+		return;
+	}
+
+	spdk_iov_xfer_init(&xfer.ix, iov, iovcnt);
+
+	/* Only the requested part of the log page is built, so the records are counted only if
+	 * the header is read.
+	 */
+	if (offset < sizeof(header)) {
+		header.genctr = tgt->discovery_log.genctr;
+		header.numrec = nvmf_discovery_log_numrec(tgt, hostnqn, cmd_source_trid);
+	}
+
+	if (nvmf_discovery_log_xfer(&xfer, &header, sizeof(header))) {
+		for (i = 0; i < tgt->discovery_log.num_entries; i++) {
+			entry = &tgt->discovery_log.entries[i];
+			if (entry->subsystem != subsystem) {
+				subsystem = entry->subsystem;
+				allowed = nvmf_discovery_subsystem_visible(subsystem, hostnqn);
+			}
+
+			if (!allowed || !nvmf_discovery_entry_visible(tgt, entry, cmd_source_trid)) {
+				continue;
+			}
+
+			if (!nvmf_discovery_log_xfer(&xfer, &entry->entry, sizeof(entry->entry))) {
 				break;
 			}
 		}
-		/* Zero out the rest of the payload */
-		if (zero_len) {
-			memset((char *)tmp->iov_base + copy_len, 0, zero_len);
-		}
+	}
 
-		for (++tmp; tmp < iov + iovcnt; tmp++) {
-			memset((char *)tmp->iov_base, 0, tmp->iov_len);
-		}
+	pthread_mutex_unlock(&tgt->mutex);
+
+	/* Zero out the rest of the payload */
+	for (i = xfer.ix.cur_iov_idx; i < iovcnt; i++) {
+		size_t iov_offset = i == (uint32_t)xfer.ix.cur_iov_idx ? xfer.ix.cur_iov_offset : 0;
 
-		free(discovery_log_page);
+		memset((char *)iov[i].iov_base + iov_offset, 0, iov[i].iov_len - iov_offset);
 	}
 }
@@ -34,6 +34,11 @@
         DEV_VERIFY(spdk_get_thread() == nvmf_fc_get_main_thread());
 #endif
 
+#define NVMF_FC_POLL_GROUP_LOAD_PERIOD_US 100000
+
+/* hwqps without connections are only polled once in this many poll group polls */
+#define NVMF_FC_IDLE_HWQP_POLL_INTERVAL 64
+
 /*
  * PRLI service parameters
  */
@@ -444,9 +449,11 @@ nvmf_fc_assign_idlest_poll_group(struct spdk_nvmf_fc_hwqp *hwqp)
 	struct spdk_nvmf_fc_poll_group *ret_fgroup = NULL;
 
 	pthread_mutex_lock(&g_nvmf_ftransport->lock);
-	/* find poll group with least number of hwqp's assigned to it */
+	/* find poll group with least number of hwqp's assigned to it, and the least loaded
+	 * one among those */
 	TAILQ_FOREACH(fgroup, &g_nvmf_fgroups, link) {
-		if (fgroup->hwqp_count < max_count) {
+		if (fgroup->hwqp_count < max_count ||
+		    (fgroup->hwqp_count == max_count && fgroup->load < ret_fgroup->load)) {
 			ret_fgroup = fgroup;
 			max_count = fgroup->hwqp_count;
 		}
@@ -2077,6 +2084,46 @@ nvmf_fc_discover(struct spdk_nvmf_transport *transport,
 	spdk_strcpy_pad(entry->traddr, trid->traddr, sizeof(entry->traddr), ' ');
 }
 
+/*
+ * Place a new connection on the least loaded poll group among those polling a hwqp of the
+ * port it arrived on, and on the group whose hwqps have the fewest connections if the loads
+ * are equal.
+ */
+static struct spdk_nvmf_transport_poll_group *
+nvmf_fc_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
+{
+	struct spdk_nvmf_fc_conn *fc_conn;
+	struct spdk_nvmf_fc_port *fc_port;
+	struct spdk_nvmf_fc_hwqp *hwqp, *selected = NULL;
+	struct spdk_nvmf_fc_poll_group *fgroup;
+	uint32_t i;
+
+	fc_conn = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_fc_conn, qpair);
+	if (fc_conn->fc_assoc == NULL || fc_conn->fc_assoc->tgtport == NULL) {
+		return NULL;
+	}
+
+	fc_port = fc_conn->fc_assoc->tgtport->fc_port;
+
+	pthread_mutex_lock(&g_nvmf_ftransport->lock);
+	for (i = 0; i < fc_port->num_io_queues; i++) {
+		hwqp = &fc_port->io_queues[i];
+		fgroup = hwqp->fgroup;
+		if (fgroup == NULL || hwqp->state != SPDK_FC_HWQP_ONLINE) {
+			continue;
+		}
+
+		if (selected == NULL || fgroup->load < selected->fgroup->load ||
+		    (fgroup->load == selected->fgroup->load &&
+		     hwqp->num_conns < selected->num_conns)) {
+			selected = hwqp;
+		}
+	}
+	pthread_mutex_unlock(&g_nvmf_ftransport->lock);
+
+	return selected != NULL ? &selected->fgroup->group : NULL;
+}
+
 static struct spdk_nvmf_transport_poll_group *
 nvmf_fc_poll_group_create(struct spdk_nvmf_transport *transport,
 			  struct spdk_nvmf_poll_group *group)
@@ -2123,17 +2170,19 @@ nvmf_fc_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 {
 	struct spdk_nvmf_fc_poll_group *fgroup;
 	struct spdk_nvmf_fc_conn *fc_conn;
-	struct spdk_nvmf_fc_hwqp *hwqp = NULL;
+	struct spdk_nvmf_fc_hwqp *hwqp = NULL, *tmp;
 	struct spdk_nvmf_fc_ls_add_conn_api_data *api_data = NULL;
 	bool hwqp_found = false;
 
 	fgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_fc_poll_group, group);
 	fc_conn  = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_fc_conn, qpair);
 
-	TAILQ_FOREACH(hwqp, &fgroup->hwqp_list, link) {
-		if (fc_conn->fc_assoc->tgtport->fc_port == hwqp->fc_port) {
+	/* Spread the connections among the hwqps of the port polled by this group */
+	TAILQ_FOREACH(tmp, &fgroup->hwqp_list, link) {
+		if (fc_conn->fc_assoc->tgtport->fc_port == tmp->fc_port &&
+		    (!hwqp_found || tmp->num_conns < hwqp->num_conns)) {
+			hwqp = tmp;
 			hwqp_found = true;
-			break;
 		}
 	}
 
@@ -2163,6 +2212,26 @@ err:
 	return -1;
 }
 
+static inline void
+nvmf_fc_poll_group_update_load(struct spdk_nvmf_fc_poll_group *fgroup, bool busy)
+{
+	uint64_t now;
+
+	fgroup->load_polls++;
+	fgroup->load_busy_polls += busy;
+
+	now = spdk_get_ticks();
+	if (now - fgroup->load_tsc <
+	    spdk_get_ticks_hz() * NVMF_FC_POLL_GROUP_LOAD_PERIOD_US / SPDK_SEC_TO_USEC) {
+		return;
+	}
+
+	fgroup->load = fgroup->load_busy_polls * 100 / fgroup->load_polls;
+	fgroup->load_polls = 0;
+	fgroup->load_busy_polls = 0;
+	fgroup->load_tsc = now;
+}
+
 static int
 nvmf_fc_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 {
@@ -2174,10 +2243,20 @@ nvmf_fc_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 
 	TAILQ_FOREACH(hwqp, &fgroup->hwqp_list, link) {
 		if (hwqp->state == SPDK_FC_HWQP_ONLINE) {
+			/* The LLD queues can't raise interrupts, so back off polling the hwqps
+			 * that have no connections to send commands on. */
+			if (hwqp->num_conns == 0 &&
+			    ++hwqp->idle_polls < NVMF_FC_IDLE_HWQP_POLL_INTERVAL) {
+				continue;
+			}
+
+			hwqp->idle_polls = 0;
 			count += nvmf_fc_process_queue(hwqp);
 		}
 	}
 
+	nvmf_fc_poll_group_update_load(fgroup, count > 0);
+
 	return (int) count;
 }
 
@@ -2318,6 +2397,7 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_fc = {
 	.listener_discover = nvmf_fc_discover,
 
 	.poll_group_create = nvmf_fc_poll_group_create,
+	.get_optimal_poll_group = nvmf_fc_get_optimal_poll_group,
 	.poll_group_destroy = nvmf_fc_poll_group_destroy,
 	.poll_group_add = nvmf_fc_poll_group_add,
 	.poll_group_poll = nvmf_fc_poll_group_poll,
@@ -111,6 +111,8 @@ nvmf_tgt_cleanup_poll_group(struct spdk_nvmf_poll_group *group)
 	free(group->sgroups);
 
 	spdk_poller_unregister(&group->poller);
+	spdk_metrics_group_unregister(group->metrics);
+	group->metrics = NULL;
 
 	if (group->destroy_cb_fn) {
 		group->destroy_cb_fn(group->destroy_cb_arg, 0);
@@ -164,6 +166,31 @@ nvmf_poll_group_add_transport(struct spdk_nvmf_poll_group *group,
 	return 0;
 }
 
+static const struct spdk_metric_desc g_nvmf_poll_group_metrics[] = {
+	[NVMF_METRIC_ADMIN_QPAIRS] = {
+		"spdk_nvmf_admin_qpairs", "Admin qpairs connected", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[NVMF_METRIC_IO_QPAIRS] = {
+		"spdk_nvmf_io_qpairs", "I/O qpairs connected", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[NVMF_METRIC_CURRENT_ADMIN_QPAIRS] = {
+		"spdk_nvmf_current_admin_qpairs", "Admin qpairs currently connected",
+		SPDK_METRIC_TYPE_GAUGE,
+	},
+	[NVMF_METRIC_CURRENT_IO_QPAIRS] = {
+		"spdk_nvmf_current_io_qpairs", "I/O qpairs currently connected",
+		SPDK_METRIC_TYPE_GAUGE,
+	},
+	[NVMF_METRIC_PENDING_BDEV_IO] = {
+		"spdk_nvmf_pending_bdev_io", "Requests queued waiting for a bdev_io",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+	[NVMF_METRIC_COMPLETED_NVME_IO] = {
+		"spdk_nvmf_completed_nvme_io", "NVMe I/O commands completed",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+};
+
 static int
 nvmf_tgt_create_poll_group(void *io_device, void *ctx_buf)
 {
@@ -181,6 +208,9 @@ nvmf_tgt_create_poll_group(void *io_device, void *ctx_buf)
 	pthread_mutex_init(&group->mutex, NULL);
 
 	group->poller = SPDK_POLLER_REGISTER(nvmf_poll_group_poll, group, 0);
+	group->metrics = spdk_metrics_group_register(g_nvmf_poll_group_metrics,
+			 SPDK_COUNTOF(g_nvmf_poll_group_metrics),
+			 "poll_group", spdk_thread_get_name(thread));
 
 	SPDK_DTRACE_PROBE1_TICKS(nvmf_create_poll_group, spdk_thread_get_id(thread));
 
@@ -308,6 +338,7 @@ spdk_nvmf_tgt_create(struct spdk_nvmf_target_opts *opts)
 	}
 
 	tgt->discovery_genctr = 0;
+	SLIST_INIT(&tgt->discovery_aen.hosts);
 	TAILQ_INIT(&tgt->transports);
 	TAILQ_INIT(&tgt->poll_groups);
 	tgt->num_poll_groups = 0;
@@ -350,6 +381,7 @@ _nvmf_tgt_destroy_next_transport(void *ctx)
 		void *destroy_cb_arg = tgt->destroy_cb_arg;
 
 		pthread_mutex_destroy(&tgt->mutex);
+		free(tgt->discovery_log.entries);
 		free(tgt);
 
 		if (destroy_cb_fn) {
@@ -400,6 +432,9 @@ spdk_nvmf_tgt_destroy(struct spdk_nvmf_tgt *tgt,
 	tgt->destroy_cb_fn = cb_fn;
 	tgt->destroy_cb_arg = cb_arg;
 
+	/* Nobody is left to notify of the changes made while the subsystems are destroyed */
+	nvmf_discovery_aen_fini(tgt);
+
 	TAILQ_REMOVE(&g_nvmf_tgts, tgt, link);
 
 	spdk_io_device_unregister(tgt, nvmf_tgt_destroy_cb);
@@ -557,6 +592,14 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 			spdk_json_write_named_uint32(w, "anagrpid", ns_opts.anagrpid);
 		}
 
+		if (ns_opts.max_io_outstanding != 0) {
+			spdk_json_write_named_uint32(w, "max_io_outstanding", ns_opts.max_io_outstanding);
+		}
+
+		if (ns_opts.latency_target_us != 0) {
+			spdk_json_write_named_uint32(w, "latency_target_us", ns_opts.latency_target_us);
+		}
+
 		/*     "namespace" */
 		spdk_json_write_object_end(w);
 
@@ -1213,9 +1256,13 @@ _nvmf_qpair_destroy(void *ctx, int status)
 		if (0 == qpair->qid) {
 			assert(qpair->group->stat.current_admin_qpairs > 0);
 			qpair->group->stat.current_admin_qpairs--;
+			nvmf_poll_group_update_metrics(qpair->group,
+						       NVMF_METRIC_CURRENT_ADMIN_QPAIRS, -1);
 		} else {
 			assert(qpair->group->stat.current_io_qpairs > 0);
 			qpair->group->stat.current_io_qpairs--;
+			nvmf_poll_group_update_metrics(qpair->group,
+						       NVMF_METRIC_CURRENT_IO_QPAIRS, -1);
 		}
 	} else {
 		pthread_mutex_lock(&qpair->group->mutex);
@@ -1346,18 +1393,124 @@ spdk_nvmf_qpair_get_listen_trid(struct spdk_nvmf_qpair *qpair,
 }
 
 static int
-poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
-			    struct spdk_nvmf_subsystem *subsystem)
+poll_group_update_ns(struct spdk_nvmf_poll_group *group, struct spdk_nvmf_subsystem *subsystem,
+		     struct spdk_nvmf_subsystem_poll_group *sgroup, uint32_t i, bool *ns_changed)
 {
-	struct spdk_nvmf_subsystem_poll_group *sgroup;
-	uint32_t new_num_ns, old_num_ns;
-	uint32_t i, j;
 	struct spdk_nvmf_ns *ns;
 	struct spdk_nvmf_registrant *reg, *tmp;
 	struct spdk_io_channel *ch;
 	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	uint32_t j;
+
+	ns = subsystem->ns[i];
+	ns_info = &sgroup->ns_info[i];
+	ch = ns_info->channel;
+
+	if (ns == NULL && ch == NULL) {
+		/* Both NULL. Leave empty */
+	} else if (ns == NULL && ch != NULL) {
+		/* There was a channel here, but the namespace is gone. */
+		*ns_changed = true;
+		spdk_put_io_channel(ch);
+		ns_info->channel = NULL;
+	} else if (ns != NULL && ch == NULL) {
+		/* A namespace appeared but there is no channel yet */
+		*ns_changed = true;
+		ch = spdk_bdev_get_io_channel(ns->desc);
+		if (ch == NULL) {
+			SPDK_ERRLOG("Could not allocate I/O channel.\n");
+			return -ENOMEM;
+		}
+		ns_info->channel = ch;
+	} else if (spdk_uuid_compare(&ns_info->uuid, spdk_bdev_get_uuid(ns->bdev)) != 0) {
+		/* A namespace was here before, but was replaced by a new one. */
+		*ns_changed = true;
+		spdk_put_io_channel(ns_info->channel);
+		memset(ns_info, 0, sizeof(*ns_info));
+
+		ch = spdk_bdev_get_io_channel(ns->desc);
+		if (ch == NULL) {
+			SPDK_ERRLOG("Could not allocate I/O channel.\n");
+			return -ENOMEM;
+		}
+		ns_info->channel = ch;
+	} else if (ns_info->num_blocks != spdk_bdev_get_num_blocks(ns->bdev)) {
+		/* Namespace is still there but size has changed */
+		SPDK_DEBUGLOG(nvmf, "Namespace resized: subsystem_id %u,"
+			      " nsid %u, pg %p, old %" PRIu64 ", new %" PRIu64 "\n",
+			      subsystem->id,
+			      ns->nsid,
+			      group,
+			      ns_info->num_blocks,
+			      spdk_bdev_get_num_blocks(ns->bdev));
+		*ns_changed = true;
+	}
+
+	if (ns == NULL) {
+		memset(ns_info, 0, sizeof(*ns_info));
+	} else {
+		ns_info->uuid = *spdk_bdev_get_uuid(ns->bdev);
+		ns_info->num_blocks = spdk_bdev_get_num_blocks(ns->bdev);
+		ns_info->crkey = ns->crkey;
+		ns_info->rtype = ns->rtype;
+		ns_info->max_io_outstanding = ns->opts.max_io_outstanding;
+		ns_info->latency_target_ticks = (uint64_t)ns->opts.latency_target_us *
+						spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+		if (ns_info->io_limit == 0) {
+			ns_info->io_limit = ns_info->max_io_outstanding != 0 ?
+					    ns_info->max_io_outstanding : UINT32_MAX;
+		}
+		if (ns->holder) {
+			ns_info->holder_id = ns->holder->hostid;
+		}
+
+		memset(&ns_info->reg_hostid, 0, SPDK_NVMF_MAX_NUM_REGISTRANTS * sizeof(struct spdk_uuid));
+		j = 0;
+		TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, tmp) {
+			if (j >= SPDK_NVMF_MAX_NUM_REGISTRANTS) {
+				SPDK_ERRLOG("Maximum %u registrants can support.\n", SPDK_NVMF_MAX_NUM_REGISTRANTS);
+				return -EINVAL;
+			}
+			ns_info->reg_hostid[j++] = reg->hostid;
+		}
+	}
+
+	return 0;
+}
+
+static void
+poll_group_notify_ns_changed(struct spdk_nvmf_poll_group *group,
+			     struct spdk_nvmf_subsystem *subsystem)
+{
 	struct spdk_nvmf_ctrlr *ctrlr;
+
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		if (ctrlr->thread != spdk_get_thread()) {
+			continue;
+		}
+		/* It is possible that a ctrlr was added but the admin_qpair hasn't been
+		 * assigned yet.
+		 */
+		if (!ctrlr->admin_qpair) {
+			continue;
+		}
+		if (ctrlr->admin_qpair->group == group) {
+			nvmf_ctrlr_async_event_ns_notice(ctrlr);
+			nvmf_ctrlr_async_event_ana_change_notice(ctrlr);
+		}
+	}
+}
+
+static int
+poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
+			    struct spdk_nvmf_subsystem *subsystem)
+{
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	uint32_t new_num_ns, old_num_ns;
+	uint32_t i;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
 	bool ns_changed;
+	int rc;
 
 	/* Make sure our poll group has memory for this subsystem allocated */
 	if (subsystem->id >= group->num_sgroups) {
@@ -1425,89 +1578,14 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 
 	/* Detect bdevs that were added or removed */
 	for (i = 0; i < sgroup->num_ns; i++) {
-		ns = subsystem->ns[i];
-		ns_info = &sgroup->ns_info[i];
-		ch = ns_info->channel;
-
-		if (ns == NULL && ch == NULL) {
-			/* Both NULL. Leave empty */
-		} else if (ns == NULL && ch != NULL) {
-			/* There was a channel here, but the namespace is gone. */
-			ns_changed = true;
-			spdk_put_io_channel(ch);
-			ns_info->channel = NULL;
-		} else if (ns != NULL && ch == NULL) {
-			/* A namespace appeared but there is no channel yet */
-			ns_changed = true;
-			ch = spdk_bdev_get_io_channel(ns->desc);
-			if (ch == NULL) {
-				SPDK_ERRLOG("Could not allocate I/O channel.\n");
-				return -ENOMEM;
-			}
-			ns_info->channel = ch;
-		} else if (spdk_uuid_compare(&ns_info->uuid, spdk_bdev_get_uuid(ns->bdev)) != 0) {
-			/* A namespace was here before, but was replaced by a new one. */
-			ns_changed = true;
-			spdk_put_io_channel(ns_info->channel);
-			memset(ns_info, 0, sizeof(*ns_info));
-
-			ch = spdk_bdev_get_io_channel(ns->desc);
-			if (ch == NULL) {
-				SPDK_ERRLOG("Could not allocate I/O channel.\n");
-				return -ENOMEM;
-			}
-			ns_info->channel = ch;
-		} else if (ns_info->num_blocks != spdk_bdev_get_num_blocks(ns->bdev)) {
-			/* Namespace is still there but size has changed */
-			SPDK_DEBUGLOG(nvmf, "Namespace resized: subsystem_id %u,"
-				      " nsid %u, pg %p, old %" PRIu64 ", new %" PRIu64 "\n",
-				      subsystem->id,
-				      ns->nsid,
-				      group,
-				      ns_info->num_blocks,
-				      spdk_bdev_get_num_blocks(ns->bdev));
-			ns_changed = true;
-		}
-
-		if (ns == NULL) {
-			memset(ns_info, 0, sizeof(*ns_info));
-		} else {
-			ns_info->uuid = *spdk_bdev_get_uuid(ns->bdev);
-			ns_info->num_blocks = spdk_bdev_get_num_blocks(ns->bdev);
-			ns_info->crkey = ns->crkey;
-			ns_info->rtype = ns->rtype;
-			if (ns->holder) {
-				ns_info->holder_id = ns->holder->hostid;
-			}
-
-			memset(&ns_info->reg_hostid, 0, SPDK_NVMF_MAX_NUM_REGISTRANTS * sizeof(struct spdk_uuid));
-			j = 0;
-			TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, tmp) {
-				if (j >= SPDK_NVMF_MAX_NUM_REGISTRANTS) {
-					SPDK_ERRLOG("Maximum %u registrants can support.\n", SPDK_NVMF_MAX_NUM_REGISTRANTS);
-					return -EINVAL;
-				}
-				ns_info->reg_hostid[j++] = reg->hostid;
-			}
+		rc = poll_group_update_ns(group, subsystem, sgroup, i, &ns_changed);
+		if (rc != 0) {
+			return rc;
 		}
 	}
 
 	if (ns_changed) {
-		TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
-			if (ctrlr->thread != spdk_get_thread()) {
-				continue;
-			}
-			/* It is possible that a ctrlr was added but the admin_qpair hasn't been
-			 * assigned yet.
-			 */
-			if (!ctrlr->admin_qpair) {
-				continue;
-			}
-			if (ctrlr->admin_qpair->group == group) {
-				nvmf_ctrlr_async_event_ns_notice(ctrlr);
-				nvmf_ctrlr_async_event_ana_change_notice(ctrlr);
-			}
-		}
+		poll_group_notify_ns_changed(group, subsystem);
 	}
 
 	return 0;
@@ -1520,6 +1598,47 @@ nvmf_poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 	return poll_group_update_subsystem(group, subsystem);
 }
 
+int
+nvmf_poll_group_update_ns(struct spdk_nvmf_poll_group *group,
+			  struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	bool ns_changed = false;
+	int rc;
+
+	if (subsystem->id >= group->num_sgroups) {
+		return -ENOMEM;
+	}
+
+	sgroup = &group->sgroups[subsystem->id];
+
+	/* The subsystem isn't attached to this poll group yet.  It'll see the namespace once
+	 * it gets added.
+	 */
+	if (nsid == 0 || nsid > sgroup->num_ns) {
+		return 0;
+	}
+
+	rc = poll_group_update_ns(group, subsystem, sgroup, nsid - 1, &ns_changed);
+	if (rc != 0 || !ns_changed) {
+		return rc;
+	}
+
+	ns_info = &sgroup->ns_info[nsid - 1];
+	if (ns_info->channel != NULL) {
+		/* A namespace that showed up while the subsystem is being paused stays paused
+		 * until the subsystem is resumed.
+		 */
+		ns_info->state = sgroup->state == SPDK_NVMF_SUBSYSTEM_ACTIVE ?
+				 SPDK_NVMF_SUBSYSTEM_ACTIVE : SPDK_NVMF_SUBSYSTEM_PAUSED;
+	}
+
+	poll_group_notify_ns_changed(group, subsystem);
+
+	return 0;
+}
+
 int
 nvmf_poll_group_add_subsystem(struct spdk_nvmf_poll_group *group,
 			      struct spdk_nvmf_subsystem *subsystem,
@@ -277,6 +277,14 @@ struct spdk_nvmf_fc_poll_group {
 	uint32_t hwqp_count; /* number of hwqp's assigned to this pg */
 	TAILQ_HEAD(, spdk_nvmf_fc_hwqp) hwqp_list;
 
+	/* Percentage of the polls that found work in the last measurement period.
+	 * Written by the poll group thread, read when placing new connections.
+	 */
+	uint32_t load;
+	uint64_t load_polls;
+	uint64_t load_busy_polls;
+	uint64_t load_tsc;
+
 	TAILQ_ENTRY(spdk_nvmf_fc_poll_group) link;
 };
 
@@ -295,6 +303,7 @@ struct spdk_nvmf_fc_hwqp {
 
 	/* qpair (fc_connection) list */
 	uint32_t num_conns; /* number of connections to queue */
+	uint32_t idle_polls; /* poll group polls skipped while there are no connections */
 	struct rte_hash *connection_list_hash;
 	struct rte_hash *rport_list_hash;
 
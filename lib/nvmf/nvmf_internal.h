@@ -10,6 +10,7 @@
 #include "spdk/stdinc.h"
 
 #include "spdk/likely.h"
+#include "spdk/metrics.h"
 #include "spdk/nvmf.h"
 #include "spdk/nvmf_cmd.h"
 #include "spdk/nvmf_transport.h"
@@ -46,6 +47,9 @@ enum spdk_nvmf_subsystem_state {
 
 RB_HEAD(subsystem_tree, spdk_nvmf_subsystem);
 
+struct nvmf_discovery_entry;
+struct nvmf_discovery_aen_host;
+
 struct spdk_nvmf_tgt {
 	char					name[NVMF_TGT_NAME_MAX_LENGTH];
 
@@ -53,6 +57,24 @@ struct spdk_nvmf_tgt {
 
 	uint64_t				discovery_genctr;
 
+	/* Discovery log entries of all the listeners, built once per discovery_genctr under
+	 * the mutex and filtered per host when the log page is read.
+	 */
+	struct {
+		struct nvmf_discovery_entry	*entries;
+		uint32_t			num_entries;
+		uint64_t			genctr;
+		bool				valid;
+	} discovery_log;
+
+	/* Discovery log change notices are batched and sent once the changes settle */
+	struct {
+		struct spdk_poller		*poller;
+		bool				all_hosts;
+		bool				stopped;
+		SLIST_HEAD(, nvmf_discovery_aen_host) hosts;
+	} discovery_aen;
+
 	uint32_t				max_subsystems;
 
 	enum spdk_nvmf_tgt_discovery_filter	discovery_filter;
@@ -92,6 +114,15 @@ struct spdk_nvmf_subsystem_listener {
 	enum spdk_nvme_ana_state			*ana_state;
 	uint64_t					ana_state_change_count;
 	uint16_t					id;
+	/* ANA log page reported to the hosts connected through this listener. It's rebuilt,
+	 * under the subsystem's mutex, once the change counts it was built for are outdated.
+	 */
+	struct {
+		uint8_t					*buf;
+		size_t					len;
+		uint64_t				ana_group_change_count;
+		uint64_t				ana_state_change_count;
+	} ana_log;
 	struct spdk_nvmf_listener_opts			opts;
 	TAILQ_ENTRY(spdk_nvmf_subsystem_listener)	link;
 };
@@ -130,6 +161,16 @@ struct spdk_nvmf_subsystem_pg_ns_info {
 	/* I/O outstanding to this namespace */
 	uint64_t			io_outstanding;
 	enum spdk_nvmf_subsystem_state	state;
+
+	/* Admission control. io_limit is the number of I/O currently admitted, which is
+	 * at most max_io_outstanding and is lowered while latency_ewma_ticks exceeds
+	 * latency_target_ticks.
+	 */
+	uint32_t			max_io_outstanding;
+	uint32_t			io_limit;
+	uint64_t			latency_target_ticks;
+	uint64_t			latency_ewma_ticks;
+	uint32_t			latency_samples;
 };
 
 typedef void(*spdk_nvmf_poll_group_mod_done)(void *cb_arg, int status);
@@ -220,7 +261,7 @@ struct spdk_nvmf_ctrlr {
 	struct spdk_thread	*thread;
 	struct spdk_bit_array	*qpair_mask;
 
-	const struct spdk_nvmf_subsystem_listener	*listener;
+	struct spdk_nvmf_subsystem_listener	*listener;
 
 	struct spdk_nvmf_request *aer_req[SPDK_NVMF_MAX_ASYNC_EVENTS];
 	STAILQ_HEAD(, spdk_nvmf_async_event_completion) async_events;
@@ -319,6 +360,8 @@ struct spdk_nvmf_subsystem {
 	 * It will be enough for ANA group to use the same size as namespaces.
 	 */
 	uint32_t					*ana_group;
+	/* Incremented whenever the namespaces of the ANA groups change */
+	uint64_t					ana_group_change_count;
 };
 
 static int
@@ -331,6 +374,9 @@ RB_GENERATE_STATIC(subsystem_tree, spdk_nvmf_subsystem, link, subsystem_cmp);
 
 int nvmf_poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 				     struct spdk_nvmf_subsystem *subsystem);
+/* Refresh a single namespace of an active subsystem on a poll group, without pausing it */
+int nvmf_poll_group_update_ns(struct spdk_nvmf_poll_group *group,
+			      struct spdk_nvmf_subsystem *subsystem, uint32_t nsid);
 int nvmf_poll_group_add_subsystem(struct spdk_nvmf_poll_group *group,
 				  struct spdk_nvmf_subsystem *subsystem,
 				  spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
@@ -344,6 +390,7 @@ void nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 				      struct spdk_nvmf_subsystem *subsystem, spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
 
 void nvmf_update_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn);
+void nvmf_discovery_aen_fini(struct spdk_nvmf_tgt *tgt);
 void nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn, struct iovec *iov,
 				 uint32_t iovcnt, uint64_t offset, uint32_t length,
 				 struct spdk_nvme_transport_id *cmd_source_trid);
@@ -468,6 +515,35 @@ nvmf_qpair_is_admin_queue(struct spdk_nvmf_qpair *qpair)
 	return qpair->qid == 0;
 }
 
+enum nvmf_poll_group_metric {
+	NVMF_METRIC_ADMIN_QPAIRS,
+	NVMF_METRIC_IO_QPAIRS,
+	NVMF_METRIC_CURRENT_ADMIN_QPAIRS,
+	NVMF_METRIC_CURRENT_IO_QPAIRS,
+	NVMF_METRIC_PENDING_BDEV_IO,
+	NVMF_METRIC_COMPLETED_NVME_IO,
+};
+
+/* Mirror an update of the statistics of a poll group in its metrics */
+static inline void
+nvmf_poll_group_update_metrics(struct spdk_nvmf_poll_group *group,
+			       enum nvmf_poll_group_metric metric, int64_t value)
+{
+	if (spdk_likely(group->metrics == NULL)) {
+		return;
+	}
+
+	switch (metric) {
+	case NVMF_METRIC_CURRENT_ADMIN_QPAIRS:
+	case NVMF_METRIC_CURRENT_IO_QPAIRS:
+		spdk_metrics_gauge_add(group->metrics, metric, value);
+		break;
+	default:
+		spdk_metrics_counter_add(group->metrics, metric, value);
+		break;
+	}
+}
+
 /**
  * Initiates a zcopy start operation
  *
@@ -266,6 +266,14 @@ dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *s
 				spdk_json_write_named_uint32(w, "anagrpid", ns_opts.anagrpid);
 			}
 
+			if (ns_opts.max_io_outstanding != 0) {
+				spdk_json_write_named_uint32(w, "max_io_outstanding", ns_opts.max_io_outstanding);
+			}
+
+			if (ns_opts.latency_target_us != 0) {
+				spdk_json_write_named_uint32(w, "latency_target_us", ns_opts.latency_target_us);
+			}
+
 			spdk_json_write_object_end(w);
 		}
 		spdk_json_write_array_end(w);
@@ -277,11 +285,102 @@ SPDK_LOG_DEPRECATION_REGISTER(rpc_nvmf_get_subsystems,
 			      "listener.transport is deprecated in favor of trtype",
 			      "v24.01", 0);
 
+/* Number of subsystems written between flushes of the nvmf_get_subsystems response */
+#define RPC_NVMF_GET_SUBSYSTEMS_BATCH	64
+
+struct rpc_nvmf_get_subsystems_iter {
+	struct spdk_jsonrpc_request	*request;
+	struct spdk_json_write_ctx	*w;
+	struct spdk_poller		*poller;
+	char				*tgt_name;
+	/* NQN of the last subsystem written, the subsystems are ordered by their NQNs */
+	char				last_nqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+};
+
+static struct spdk_nvmf_subsystem *
+rpc_nvmf_get_subsystems_next(struct rpc_nvmf_get_subsystems_iter *iter,
+			     struct spdk_nvmf_tgt *tgt)
+{
+	struct spdk_nvmf_subsystem key, *subsystem;
+
+	if (iter->last_nqn[0] == '\0') {
+		return spdk_nvmf_subsystem_get_first(tgt);
+	}
+
+	/* The last subsystem might have been deleted in the meantime */
+	snprintf(key.subnqn, sizeof(key.subnqn), "%s", iter->last_nqn);
+	subsystem = RB_NFIND(subsystem_tree, &tgt->subsystems, &key);
+	if (subsystem != NULL && strcmp(subsystem->subnqn, iter->last_nqn) == 0) {
+		subsystem = spdk_nvmf_subsystem_get_next(subsystem);
+	}
+
+	return subsystem;
+}
+
+/* Returns true once all the subsystems have been written */
+static bool
+rpc_nvmf_get_subsystems_write(struct rpc_nvmf_get_subsystems_iter *iter, uint32_t count)
+{
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+	uint32_t i;
+
+	tgt = spdk_nvmf_get_tgt(iter->tgt_name);
+	if (tgt == NULL) {
+		/* The target was destroyed */
+		return true;
+	}
+
+	subsystem = rpc_nvmf_get_subsystems_next(iter, tgt);
+	for (i = 0; subsystem != NULL && i < count; i++) {
+		dump_nvmf_subsystem(iter->w, subsystem);
+		snprintf(iter->last_nqn, sizeof(iter->last_nqn), "%s",
+			 spdk_nvmf_subsystem_get_nqn(subsystem));
+		subsystem = spdk_nvmf_subsystem_get_next(subsystem);
+	}
+
+	return subsystem == NULL;
+}
+
+static void
+rpc_nvmf_get_subsystems_end(struct rpc_nvmf_get_subsystems_iter *iter)
+{
+	spdk_json_write_array_end(iter->w);
+	spdk_jsonrpc_end_result(iter->request, iter->w);
+
+	spdk_poller_unregister(&iter->poller);
+	free(iter->tgt_name);
+	free(iter);
+}
+
+static int
+rpc_nvmf_get_subsystems_poll(void *ctx)
+{
+	struct rpc_nvmf_get_subsystems_iter *iter = ctx;
+	int rc;
+
+	rc = spdk_jsonrpc_flush(iter->request);
+	if (rc == -EAGAIN) {
+		/* Wait for the client to receive the data sent so far */
+		return SPDK_POLLER_IDLE;
+	}
+
+	if (rc == 0 && !rpc_nvmf_get_subsystems_write(iter, RPC_NVMF_GET_SUBSYSTEMS_BATCH)) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	/* All the subsystems were written or the rest of the response can't be sent anyway */
+	rpc_nvmf_get_subsystems_end(iter);
+
+	return SPDK_POLLER_BUSY;
+}
+
 static void
 rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 			const struct spdk_json_val *params)
 {
 	struct rpc_get_subsystem req = { 0 };
+	struct rpc_nvmf_get_subsystems_iter *iter;
 	struct spdk_json_write_ctx *w;
 	struct spdk_nvmf_subsystem *subsystem = NULL;
 	struct spdk_nvmf_tgt *tgt;
@@ -322,22 +421,40 @@ rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 		}
 	}
 
-	w = spdk_jsonrpc_begin_result(request);
-	spdk_json_write_array_begin(w);
-
 	if (subsystem) {
+		w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_array_begin(w);
 		dump_nvmf_subsystem(w, subsystem);
-	} else {
-		for (subsystem = spdk_nvmf_subsystem_get_first(tgt); subsystem != NULL;
-		     subsystem = spdk_nvmf_subsystem_get_next(subsystem)) {
-			dump_nvmf_subsystem(w, subsystem);
-		}
+		spdk_json_write_array_end(w);
+		spdk_jsonrpc_end_result(request, w);
+		free(req.tgt_name);
+		free(req.nqn);
+		return;
 	}
 
-	spdk_json_write_array_end(w);
-	spdk_jsonrpc_end_result(request, w);
-	free(req.tgt_name);
-	free(req.nqn);
+	iter = calloc(1, sizeof(*iter));
+	if (iter == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		free(req.tgt_name);
+		return;
+	}
+
+	iter->request = request;
+	iter->tgt_name = req.tgt_name;
+	iter->w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(iter->w);
+
+	if (rpc_nvmf_get_subsystems_write(iter, RPC_NVMF_GET_SUBSYSTEMS_BATCH)) {
+		rpc_nvmf_get_subsystems_end(iter);
+		return;
+	}
+
+	/* Long lists are sent in batches, so that the app thread isn't blocked for too long */
+	iter->poller = SPDK_POLLER_REGISTER(rpc_nvmf_get_subsystems_poll, iter, 0);
+	if (iter->poller == NULL) {
+		rpc_nvmf_get_subsystems_write(iter, UINT32_MAX);
+		rpc_nvmf_get_subsystems_end(iter);
+	}
 }
 SPDK_RPC_REGISTER("nvmf_get_subsystems", rpc_nvmf_get_subsystems, SPDK_RPC_RUNTIME)
 
@@ -1118,6 +1235,8 @@ struct spdk_nvmf_ns_params {
 	char eui64[8];
 	struct spdk_uuid uuid;
 	uint32_t anagrpid;
+	uint32_t max_io_outstanding;
+	uint32_t latency_target_us;
 };
 
 static const struct spdk_json_object_decoder rpc_ns_params_decoders[] = {
@@ -1128,6 +1247,8 @@ static const struct spdk_json_object_decoder rpc_ns_params_decoders[] = {
 	{"eui64", offsetof(struct spdk_nvmf_ns_params, eui64), decode_ns_eui64, true},
 	{"uuid", offsetof(struct spdk_nvmf_ns_params, uuid), decode_ns_uuid, true},
 	{"anagrpid", offsetof(struct spdk_nvmf_ns_params, anagrpid), spdk_json_decode_uint32, true},
+	{"max_io_outstanding", offsetof(struct spdk_nvmf_ns_params, max_io_outstanding), spdk_json_decode_uint32, true},
+	{"latency_target_us", offsetof(struct spdk_nvmf_ns_params, latency_target_us), spdk_json_decode_uint32, true},
 };
 
 static int
@@ -1226,10 +1347,8 @@ nvmf_rpc_ns_resumed(struct spdk_nvmf_subsystem *subsystem,
 }
 
 static void
-nvmf_rpc_ns_paused(struct spdk_nvmf_subsystem *subsystem,
-		   void *cb_arg, int status)
+nvmf_rpc_ns_add(struct spdk_nvmf_subsystem *subsystem, struct nvmf_rpc_ns_ctx *ctx)
 {
-	struct nvmf_rpc_ns_ctx *ctx = cb_arg;
 	struct spdk_nvmf_ns_opts ns_opts;
 
 	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
@@ -1246,6 +1365,8 @@ nvmf_rpc_ns_paused(struct spdk_nvmf_subsystem *subsystem,
 	}
 
 	ns_opts.anagrpid = ctx->ns_params.anagrpid;
+	ns_opts.max_io_outstanding = ctx->ns_params.max_io_outstanding;
+	ns_opts.latency_target_us = ctx->ns_params.latency_target_us;
 
 	ctx->ns_params.nsid = spdk_nvmf_subsystem_add_ns_ext(subsystem, ctx->ns_params.bdev_name,
 			      &ns_opts, sizeof(ns_opts),
@@ -1255,10 +1376,17 @@ nvmf_rpc_ns_paused(struct spdk_nvmf_subsystem *subsystem,
 		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "Invalid parameters");
 		ctx->response_sent = true;
-		goto resume;
 	}
+}
+
+static void
+nvmf_rpc_ns_paused(struct spdk_nvmf_subsystem *subsystem,
+		   void *cb_arg, int status)
+{
+	struct nvmf_rpc_ns_ctx *ctx = cb_arg;
+
+	nvmf_rpc_ns_add(subsystem, ctx);
 
-resume:
 	if (spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_ns_resumed, ctx)) {
 		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
 		nvmf_rpc_ns_ctx_free(ctx);
@@ -1272,6 +1400,7 @@ rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 	struct nvmf_rpc_ns_ctx *ctx;
 	struct spdk_nvmf_subsystem *subsystem;
 	struct spdk_nvmf_tgt *tgt;
+	struct spdk_json_write_ctx *w;
 	int rc;
 
 	ctx = calloc(1, sizeof(*ctx));
@@ -1309,6 +1438,18 @@ rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
+	/* An active subsystem takes the new namespace without being paused */
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		nvmf_rpc_ns_add(subsystem, ctx);
+		if (!ctx->response_sent) {
+			w = spdk_jsonrpc_begin_result(request);
+			spdk_json_write_uint32(w, ctx->ns_params.nsid);
+			spdk_jsonrpc_end_result(request, w);
+		}
+		nvmf_rpc_ns_ctx_free(ctx);
+		return;
+	}
+
 	rc = spdk_nvmf_subsystem_pause(subsystem, ctx->ns_params.nsid, nvmf_rpc_ns_paused, ctx);
 	if (rc != 0) {
 		if (rc == -EBUSY) {
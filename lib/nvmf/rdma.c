@@ -42,6 +42,13 @@ SPDK_STATIC_ASSERT(NVMF_DEFAULT_MSDBD <= SPDK_NVMF_MAX_SGL_ENTRIES,
 #define DEFAULT_NVMF_RDMA_CQ_SIZE	4096
 #define MAX_WR_PER_QP(queue_depth)	(queue_depth * 3 + 2)
 
+/* Adaptive SRQ posting: lower bound of the number of receives kept posted to an SRQ */
+#define NVMF_RDMA_SRQ_MIN_POSTED_RECVS	64
+/* Adaptive SRQ posting: receives kept posted per receive consumed between two refills */
+#define NVMF_RDMA_SRQ_BURST_HEADROOM	4
+/* Adaptive SRQ posting: the number of posted receives may shrink once per period */
+#define NVMF_RDMA_SRQ_ADJUST_PERIOD_US	100000
+
 static int g_spdk_nvmf_ibv_query_mask =
 	IBV_QP_STATE |
 	IBV_QP_PKEY_INDEX |
@@ -69,6 +76,12 @@ enum spdk_nvmf_rdma_request_state {
 	/* The request is queued until a data buffer is available. */
 	RDMA_REQUEST_STATE_NEED_BUFFER,
 
+	/* The request is waiting for zcopy_start to finish */
+	RDMA_REQUEST_STATE_AWAITING_ZCOPY_START,
+
+	/* The request has received a zero-copy buffer */
+	RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED,
+
 	/* The request is waiting on RDMA queue depth availability
 	 * to transfer data from the host to the controller.
 	 */
@@ -102,6 +115,9 @@ enum spdk_nvmf_rdma_request_state {
 	 */
 	RDMA_REQUEST_STATE_COMPLETING,
 
+	/* The request is waiting for zcopy buffers to be released */
+	RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE,
+
 	/* The request completed and can be marked free. */
 	RDMA_REQUEST_STATE_COMPLETED,
 
@@ -118,6 +134,14 @@ SPDK_TRACE_REGISTER_FN(nvmf_trace, "nvmf_rdma", TRACE_GROUP_NVMF_RDMA)
 	spdk_trace_register_description("RDMA_REQ_NEED_BUFFER", TRACE_RDMA_REQUEST_STATE_NEED_BUFFER,
 					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
 					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("RDMA_REQ_ZCPY_START",
+					TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_START,
+					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("RDMA_REQ_ZCPY_START_CPL",
+					TRACE_RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED,
+					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
 	spdk_trace_register_description("RDMA_REQ_TX_PENDING_C2H",
 					TRACE_RDMA_REQUEST_STATE_DATA_TRANSFER_TO_HOST_PENDING,
 					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
@@ -154,6 +178,10 @@ SPDK_TRACE_REGISTER_FN(nvmf_trace, "nvmf_rdma", TRACE_GROUP_NVMF_RDMA)
 					TRACE_RDMA_REQUEST_STATE_COMPLETING,
 					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
 					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("RDMA_REQ_ZCPY_RELEASE",
+					TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_RELEASE,
+					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
 	spdk_trace_register_description("RDMA_REQ_COMPLETED",
 					TRACE_RDMA_REQUEST_STATE_COMPLETED,
 					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
@@ -203,6 +231,9 @@ struct spdk_nvmf_rdma_recv {
 
 	struct spdk_nvmf_rdma_qpair		*qpair;
 
+	/* Shared receive queue this recv belongs to, NULL if the qpair doesn't use an SRQ */
+	struct spdk_nvmf_rdma_srq		*srq;
+
 	/* In-capsule data buffer */
 	uint8_t					*buf;
 
@@ -252,7 +283,7 @@ struct spdk_nvmf_rdma_request {
 
 struct spdk_nvmf_rdma_resource_opts {
 	struct spdk_nvmf_rdma_qpair	*qpair;
-	/* qp points either to an ibv_qp object or an ibv_srq object depending on the value of shared. */
+	/* qp points either to an spdk_rdma_qp object or an spdk_nvmf_rdma_srq object depending on the value of shared. */
 	void				*qp;
 	struct spdk_rdma_mem_map	*map;
 	uint32_t			max_queue_depth;
@@ -289,6 +320,31 @@ struct spdk_nvmf_rdma_resources {
 	STAILQ_HEAD(, spdk_nvmf_rdma_request)	free_queue;
 };
 
+struct spdk_nvmf_rdma_srq {
+	struct spdk_rdma_srq			*rdma_srq;
+	struct spdk_nvmf_rdma_resources		*resources;
+
+	/* The number of qpairs attached to this SRQ */
+	uint32_t				num_qpairs;
+
+	/* The number of receives currently posted to the SRQ and the number of
+	 * receives that should be kept posted. The latter is equal to the SRQ depth
+	 * unless adaptive posting is enabled.
+	 */
+	uint32_t				posted_recvs;
+	uint32_t				target_recvs;
+
+	/* Adaptive posting: receives consumed since the last refill and the highest
+	 * demand seen in the current period.
+	 */
+	uint32_t				consumed_recvs;
+	uint32_t				peak_demand;
+	uint64_t				period_start_tsc;
+
+	/* Receives held back from the SRQ by adaptive posting */
+	STAILQ_HEAD(, spdk_nvmf_rdma_recv)	idle_recvs;
+};
+
 typedef void (*spdk_nvmf_rdma_qpair_ibv_event)(struct spdk_nvmf_rdma_qpair *rqpair);
 
 typedef void (*spdk_poller_destroy_cb)(void *ctx);
@@ -308,7 +364,7 @@ struct spdk_nvmf_rdma_qpair {
 
 	struct spdk_rdma_qp			*rdma_qp;
 	struct rdma_cm_id			*cm_id;
-	struct spdk_rdma_srq			*srq;
+	struct spdk_nvmf_rdma_srq		*srq;
 	struct rdma_cm_id			*listen_id;
 
 	/* Cache the QP number to improve QP search by RB tree. */
@@ -342,6 +398,9 @@ struct spdk_nvmf_rdma_qpair {
 	/* The maximum number of SGEs per WR on the recv queue */
 	uint32_t				max_recv_sge;
 
+	/* Responses are copied into the send WQE instead of being fetched by the NIC */
+	bool					inline_rsp;
+
 	struct spdk_nvmf_rdma_resources		*resources;
 
 	STAILQ_HEAD(, spdk_nvmf_rdma_request)	pending_rdma_read_queue;
@@ -403,14 +462,15 @@ struct spdk_nvmf_rdma_poller {
 	int					required_num_wr;
 	struct ibv_cq				*cq;
 
-	/* The maximum number of I/O outstanding on the shared receive queue at one time */
+	/* The maximum number of I/O outstanding on each shared receive queue at one time */
 	uint16_t				max_srq_depth;
 	bool					need_destroy;
 
-	/* Shared receive queue */
-	struct spdk_rdma_srq			*srq;
+	/* Shared receive queues, qpairs are spread among them */
+	struct spdk_nvmf_rdma_srq		*srqs;
+	uint32_t				num_srqs;
+	uint64_t				srq_adjust_period_ticks;
 
-	struct spdk_nvmf_rdma_resources		*resources;
 	struct spdk_nvmf_rdma_poller_stat	stat;
 
 	spdk_poller_destroy_cb			destroy_cb;
@@ -467,7 +527,9 @@ struct spdk_nvmf_rdma_port {
 struct rdma_transport_opts {
 	int		num_cqe;
 	uint32_t	max_srq_depth;
+	uint32_t	num_srqs;
 	bool		no_srq;
+	bool		adaptive_srq_posting;
 	bool		no_wr_batching;
 	int		acceptor_backlog;
 };
@@ -515,10 +577,18 @@ static const struct spdk_json_object_decoder rdma_transport_opts_decoder[] = {
 		"max_srq_depth", offsetof(struct rdma_transport_opts, max_srq_depth),
 		spdk_json_decode_uint32, true
 	},
+	{
+		"num_srqs", offsetof(struct rdma_transport_opts, num_srqs),
+		spdk_json_decode_uint32, true
+	},
 	{
 		"no_srq", offsetof(struct rdma_transport_opts, no_srq),
 		spdk_json_decode_bool, true
 	},
+	{
+		"adaptive_srq_posting", offsetof(struct rdma_transport_opts, adaptive_srq_posting),
+		spdk_json_decode_bool, true
+	},
 	{
 		"no_wr_batching", offsetof(struct rdma_transport_opts, no_wr_batching),
 		spdk_json_decode_bool, true
@@ -696,6 +766,70 @@ nvmf_rdma_dump_qpair_contents(struct spdk_nvmf_rdma_qpair *rqpair)
 	}
 }
 
+/* Queue a recv to its SRQ. The recv is kept aside instead if the SRQ already holds
+ * as many receives as adaptive posting wants it to. */
+static inline void
+nvmf_rdma_srq_queue_recv(struct spdk_nvmf_rdma_srq *rsrq, struct spdk_nvmf_rdma_recv *rdma_recv)
+{
+	if (rsrq->posted_recvs >= rsrq->target_recvs) {
+		STAILQ_INSERT_HEAD(&rsrq->idle_recvs, rdma_recv, link);
+		return;
+	}
+
+	rsrq->posted_recvs++;
+	spdk_rdma_srq_queue_recv_wrs(rsrq->rdma_srq, &rdma_recv->wr);
+}
+
+static void
+nvmf_rdma_srq_refill(struct spdk_nvmf_rdma_srq *rsrq)
+{
+	struct spdk_nvmf_rdma_recv *rdma_recv;
+
+	while (rsrq->posted_recvs < rsrq->target_recvs && !STAILQ_EMPTY(&rsrq->idle_recvs)) {
+		rdma_recv = STAILQ_FIRST(&rsrq->idle_recvs);
+		STAILQ_REMOVE_HEAD(&rsrq->idle_recvs, link);
+		nvmf_rdma_srq_queue_recv(rsrq, rdma_recv);
+	}
+}
+
+/*
+ * Recompute the number of receives to keep posted from the receives consumed since the
+ * last refill. The target grows right away to cover a burst, while it may only shrink
+ * once per period and by at most a half, so a short lull doesn't starve the next burst.
+ * cq_full means that the last poll reaped a full batch, so the CQ may hold more receive
+ * completions than were accounted for.
+ */
+static void
+nvmf_rdma_srq_update_target(struct spdk_nvmf_rdma_srq *rsrq, uint32_t max_depth, bool cq_full,
+			    uint64_t now, uint64_t period_ticks)
+{
+	uint32_t demand;
+
+	if (cq_full) {
+		demand = max_depth;
+	} else {
+		demand = spdk_max(rsrq->consumed_recvs * NVMF_RDMA_SRQ_BURST_HEADROOM,
+				  NVMF_RDMA_SRQ_MIN_POSTED_RECVS);
+		demand = spdk_min(demand, max_depth);
+	}
+	rsrq->consumed_recvs = 0;
+	rsrq->peak_demand = spdk_max(rsrq->peak_demand, demand);
+
+	if (demand > rsrq->target_recvs) {
+		rsrq->target_recvs = demand;
+	}
+
+	if (now - rsrq->period_start_tsc < period_ticks) {
+		return;
+	}
+
+	if (rsrq->peak_demand < rsrq->target_recvs) {
+		rsrq->target_recvs = spdk_max(rsrq->peak_demand, rsrq->target_recvs / 2);
+	}
+	rsrq->peak_demand = 0;
+	rsrq->period_start_tsc = now;
+}
+
 static void
 nvmf_rdma_resources_destroy(struct spdk_nvmf_rdma_resources *resources)
 {
@@ -715,7 +849,7 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 	struct spdk_nvmf_rdma_request		*rdma_req;
 	struct spdk_nvmf_rdma_recv		*rdma_recv;
 	struct spdk_rdma_qp			*qp = NULL;
-	struct spdk_rdma_srq			*srq = NULL;
+	struct spdk_nvmf_rdma_srq		*srq = NULL;
 	struct ibv_recv_wr			*bad_wr = NULL;
 	struct spdk_rdma_memory_translation	translation;
 	uint32_t				i;
@@ -763,7 +897,7 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 	STAILQ_INIT(&resources->free_queue);
 
 	if (opts->shared) {
-		srq = (struct spdk_rdma_srq *)opts->qp;
+		srq = (struct spdk_nvmf_rdma_srq *)opts->qp;
 	} else {
 		qp = (struct spdk_rdma_qp *)opts->qp;
 	}
@@ -771,6 +905,7 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 	for (i = 0; i < opts->max_queue_depth; i++) {
 		rdma_recv = &resources->recvs[i];
 		rdma_recv->qpair = opts->qpair;
+		rdma_recv->srq = srq;
 
 		/* Set up memory to receive commands */
 		if (resources->bufs) {
@@ -804,7 +939,7 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 		rdma_recv->wr.wr_id = (uintptr_t)&rdma_recv->rdma_wr;
 		rdma_recv->wr.sg_list = rdma_recv->sgl;
 		if (srq) {
-			spdk_rdma_srq_queue_recv_wrs(srq, &rdma_recv->wr);
+			nvmf_rdma_srq_queue_recv(srq, rdma_recv);
 		} else {
 			spdk_rdma_qp_queue_recv_wrs(qp, &rdma_recv->wr);
 		}
@@ -856,7 +991,7 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 	}
 
 	if (srq) {
-		rc = spdk_rdma_srq_flush_recv_wrs(srq, &bad_wr);
+		rc = spdk_rdma_srq_flush_recv_wrs(srq->rdma_srq, &bad_wr);
 	} else {
 		rc = spdk_rdma_qp_flush_recv_wrs(qp, &bad_wr);
 	}
@@ -925,13 +1060,18 @@ nvmf_rdma_qpair_destroy(struct spdk_nvmf_rdma_qpair *rqpair)
 	if (rqpair->poller) {
 		RB_REMOVE(qpairs_tree, &rqpair->poller->qpairs, rqpair);
 
+		if (rqpair->srq != NULL) {
+			assert(rqpair->srq->num_qpairs > 0);
+			rqpair->srq->num_qpairs--;
+		}
+
 		if (rqpair->srq != NULL && rqpair->resources != NULL) {
 			/* Drop all received but unprocessed commands for this queue and return them to SRQ */
 			STAILQ_FOREACH_SAFE(rdma_recv, &rqpair->resources->incoming_queue, link, recv_tmp) {
 				if (rqpair == rdma_recv->qpair) {
 					STAILQ_REMOVE(&rqpair->resources->incoming_queue, rdma_recv, spdk_nvmf_rdma_recv, link);
-					spdk_rdma_srq_queue_recv_wrs(rqpair->srq, &rdma_recv->wr);
-					rc = spdk_rdma_srq_flush_recv_wrs(rqpair->srq, &bad_recv_wr);
+					nvmf_rdma_srq_queue_recv(rqpair->srq, rdma_recv);
+					rc = spdk_rdma_srq_flush_recv_wrs(rqpair->srq->rdma_srq, &bad_recv_wr);
 					if (rc) {
 						SPDK_ERRLOG("Unable to re-post rx descriptor\n");
 					}
@@ -1034,7 +1174,7 @@ nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 	qp_init_attr.recv_cq	= rqpair->poller->cq;
 
 	if (rqpair->srq) {
-		qp_init_attr.srq		= rqpair->srq->srq;
+		qp_init_attr.srq		= rqpair->srq->rdma_srq->srq;
 	} else {
 		qp_init_attr.cap.max_recv_wr	= rqpair->max_queue_depth;
 	}
@@ -1043,6 +1183,7 @@ nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 	qp_init_attr.cap.max_send_wr	= (uint32_t)rqpair->max_queue_depth * 2;
 	qp_init_attr.cap.max_send_sge	= spdk_min((uint32_t)device->attr.max_sge, NVMF_DEFAULT_TX_SGE);
 	qp_init_attr.cap.max_recv_sge	= spdk_min((uint32_t)device->attr.max_sge, NVMF_DEFAULT_RX_SGE);
+	qp_init_attr.cap.max_inline_data	= sizeof(struct spdk_nvme_cpl);
 	qp_init_attr.stats		= &rqpair->poller->stat.qp_stats;
 
 	if (rqpair->srq == NULL && nvmf_rdma_resize_cq(rqpair, device) < 0) {
@@ -1061,10 +1202,11 @@ nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 					  qp_init_attr.cap.max_send_wr);
 	rqpair->max_send_sge = spdk_min(NVMF_DEFAULT_TX_SGE, qp_init_attr.cap.max_send_sge);
 	rqpair->max_recv_sge = spdk_min(NVMF_DEFAULT_RX_SGE, qp_init_attr.cap.max_recv_sge);
+	rqpair->inline_rsp = qp_init_attr.cap.max_inline_data >= sizeof(struct spdk_nvme_cpl);
 	spdk_trace_record(TRACE_RDMA_QP_CREATE, 0, 0, (uintptr_t)rqpair);
 	SPDK_DEBUGLOG(rdma, "New RDMA Connection: %p\n", qpair);
 
-	if (rqpair->poller->srq == NULL) {
+	if (rqpair->srq == NULL) {
 		rtransport = SPDK_CONTAINEROF(qpair->transport, struct spdk_nvmf_rdma_transport, transport);
 		transport = &rtransport->transport;
 
@@ -1083,7 +1225,7 @@ nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 			goto error;
 		}
 	} else {
-		rqpair->resources = rqpair->poller->resources;
+		rqpair->resources = rqpair->srq->resources;
 	}
 
 	rqpair->current_recv_depth = 0;
@@ -1098,18 +1240,17 @@ error:
 	return -1;
 }
 
-/* Append the given recv wr structure to the resource structs outstanding recvs list. */
-/* This function accepts either a single wr or the first wr in a linked list. */
+/* Append the given recv to the outstanding recvs list of its qpair or SRQ. */
 static void
-nvmf_rdma_qpair_queue_recv_wrs(struct spdk_nvmf_rdma_qpair *rqpair, struct ibv_recv_wr *first)
+nvmf_rdma_qpair_queue_recv(struct spdk_nvmf_rdma_qpair *rqpair, struct spdk_nvmf_rdma_recv *rdma_recv)
 {
 	struct spdk_nvmf_rdma_transport *rtransport = SPDK_CONTAINEROF(rqpair->qpair.transport,
 			struct spdk_nvmf_rdma_transport, transport);
 
 	if (rqpair->srq != NULL) {
-		spdk_rdma_srq_queue_recv_wrs(rqpair->srq, first);
+		nvmf_rdma_srq_queue_recv(rdma_recv->srq, rdma_recv);
 	} else {
-		if (spdk_rdma_qp_queue_recv_wrs(rqpair->rdma_qp, first)) {
+		if (spdk_rdma_qp_queue_recv_wrs(rqpair->rdma_qp, &rdma_recv->wr)) {
 			STAILQ_INSERT_TAIL(&rqpair->poller->qpairs_pending_recv, rqpair, recv_link);
 		}
 	}
@@ -1220,7 +1361,7 @@ request_transfer_out(struct spdk_nvmf_request *req, int *data_posted)
 	/* queue the capsule for the recv buffer */
 	assert(rdma_req->recv != NULL);
 
-	nvmf_rdma_qpair_queue_recv_wrs(rqpair, &rdma_req->recv->wr);
+	nvmf_rdma_qpair_queue_recv(rqpair, rdma_req->recv);
 
 	rdma_req->recv = NULL;
 	assert(rqpair->current_recv_depth > 0);
@@ -1231,6 +1372,14 @@ request_transfer_out(struct spdk_nvmf_request *req, int *data_posted)
 	 * containing the response.
 	 */
 	first = &rdma_req->rsp.wr;
+	/* The completion is small enough to be sent inline, which saves the NIC
+	 * a DMA read of the response buffer before the SEND goes out.
+	 */
+	if (rqpair->inline_rsp) {
+		rdma_req->rsp.wr.send_flags = IBV_SEND_SIGNALED | IBV_SEND_INLINE;
+	} else {
+		rdma_req->rsp.wr.send_flags = IBV_SEND_SIGNALED;
+	}
 
 	if (rsp->status.sc != SPDK_NVME_SC_SUCCESS) {
 		/* On failure, data was not read from the controller. So clear the
@@ -1877,6 +2026,32 @@ err_exit:
 	return rc;
 }
 
+/* Build the data WR on top of the buffers lent by the bdev through zcopy_start */
+static int
+nvmf_rdma_request_fill_zcopy_iovs(struct spdk_nvmf_rdma_transport *rtransport,
+				  struct spdk_nvmf_rdma_device *device,
+				  struct spdk_nvmf_rdma_request *rdma_req)
+{
+	struct spdk_nvmf_rdma_qpair		*rqpair;
+	struct ibv_send_wr			*wr = &rdma_req->data.wr;
+	int					rc;
+
+	rqpair = SPDK_CONTAINEROF(rdma_req->req.qpair, struct spdk_nvmf_rdma_qpair, qpair);
+
+	rdma_req->iovpos = 0;
+	rdma_req->offset = 0;
+	rc = nvmf_rdma_fill_wr_sgl(rqpair->poller->group, device, rdma_req, wr,
+				   rdma_req->req.length);
+	if (spdk_unlikely(rc != 0 || wr->num_sge > rqpair->max_send_sge)) {
+		nvmf_rdma_request_free_data(rdma_req, rtransport);
+		return rc != 0 ? rc : -EINVAL;
+	}
+
+	rdma_req->num_outstanding_data_wr = 1;
+
+	return 0;
+}
+
 static int
 nvmf_rdma_request_parse_sgl(struct spdk_nvmf_rdma_transport *rtransport,
 			    struct spdk_nvmf_rdma_device *device,
@@ -1914,6 +2089,17 @@ nvmf_rdma_request_parse_sgl(struct spdk_nvmf_rdma_transport *rtransport,
 		/* fill request length and populate iovs */
 		req->length = length;
 
+		/* Reads are served straight from the bdev's buffers, the data WR is filled once
+		 * zcopy_start completes.
+		 */
+		if (req->xfer == SPDK_NVME_DATA_CONTROLLER_TO_HOST && !req->dif_enabled &&
+		    nvmf_ctrlr_use_zcopy(req)) {
+			SPDK_DEBUGLOG(rdma, "Using zero-copy to execute request %p\n", rdma_req);
+			nvmf_rdma_setup_request(rdma_req);
+			req->data_from_pool = false;
+			return 0;
+		}
+
 		rc = nvmf_rdma_request_fill_iovs(rtransport, device, rdma_req);
 		if (spdk_unlikely(rc < 0)) {
 			if (rc == -EINVAL) {
@@ -2024,6 +2210,7 @@ _nvmf_rdma_request_free(struct spdk_nvmf_rdma_request *rdma_req,
 		rdma_req->fused_pair = NULL;
 	}
 	memset(&rdma_req->req.dif, 0, sizeof(rdma_req->req.dif));
+	rdma_req->req.zcopy_phase = NVMF_ZCOPY_PHASE_NONE;
 	rqpair->qd--;
 
 	STAILQ_INSERT_HEAD(&rqpair->resources->free_queue, rdma_req, state_link);
@@ -2103,8 +2290,11 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 	assert(rdma_req->state != RDMA_REQUEST_STATE_FREE);
 
 	/* If the queue pair is in an error state, force the request to the completed state
-	 * to release resources. */
-	if (rqpair->ibv_state == IBV_QPS_ERR || rqpair->qpair.state != SPDK_NVMF_QPAIR_ACTIVE) {
+	 * to release resources.  Requests waiting for the bdev to start or end a zcopy are
+	 * completed once the bdev calls back. */
+	if ((rqpair->ibv_state == IBV_QPS_ERR || rqpair->qpair.state != SPDK_NVMF_QPAIR_ACTIVE) &&
+	    rdma_req->state != RDMA_REQUEST_STATE_AWAITING_ZCOPY_START &&
+	    rdma_req->state != RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE) {
 		if (rdma_req->state == RDMA_REQUEST_STATE_NEED_BUFFER) {
 			STAILQ_REMOVE(&rgroup->group.pending_buf_queue, &rdma_req->req, spdk_nvmf_request, buf_link);
 		} else if (rdma_req->state == RDMA_REQUEST_STATE_DATA_TRANSFER_TO_CONTROLLER_PENDING) {
@@ -2191,6 +2381,14 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 				break;
 			}
 
+			/* Get a zcopy buffer if the request can be serviced through zcopy */
+			if (spdk_nvmf_request_using_zcopy(&rdma_req->req)) {
+				STAILQ_REMOVE_HEAD(&rgroup->group.pending_buf_queue, buf_link);
+				rdma_req->state = RDMA_REQUEST_STATE_AWAITING_ZCOPY_START;
+				spdk_nvmf_request_zcopy_start(&rdma_req->req);
+				break;
+			}
+
 			if (rdma_req->req.iovcnt == 0) {
 				/* No buffers available. */
 				rgroup->stat.pending_data_buffer++;
@@ -2211,6 +2409,35 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 
 			rdma_req->state = RDMA_REQUEST_STATE_READY_TO_EXECUTE;
 			break;
+		case RDMA_REQUEST_STATE_AWAITING_ZCOPY_START:
+			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_START, 0, 0,
+					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
+			/* Some external code must kick a request into
+			 * RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED to escape this state. */
+			break;
+		case RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED:
+			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED, 0, 0,
+					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
+			assert(rdma_req->req.xfer == SPDK_NVME_DATA_CONTROLLER_TO_HOST);
+			if (spdk_unlikely(spdk_nvme_cpl_is_error(rsp))) {
+				SPDK_DEBUGLOG(rdma, "Zero-copy start failed for req %p\n", rdma_req);
+				rdma_req->state = RDMA_REQUEST_STATE_READY_TO_COMPLETE;
+				break;
+			}
+
+			/* The data was read by zcopy_start, so the request is executed once the
+			 * RDMA WRITE is built on top of the buffers lent by the bdev. */
+			rc = nvmf_rdma_request_fill_zcopy_iovs(rtransport, device, rdma_req);
+			if (spdk_unlikely(rc != 0)) {
+				SPDK_ERRLOG("Failed to map zero-copy buffers of req %p\n", rdma_req);
+				rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+				rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+				rdma_req->state = RDMA_REQUEST_STATE_READY_TO_COMPLETE;
+				break;
+			}
+
+			rdma_req->state = RDMA_REQUEST_STATE_EXECUTED;
+			break;
 		case RDMA_REQUEST_STATE_DATA_TRANSFER_TO_CONTROLLER_PENDING:
 			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_DATA_TRANSFER_TO_CONTROLLER_PENDING, 0, 0,
 					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
@@ -2418,10 +2645,24 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 			/* Some external code must kick a request into RDMA_REQUEST_STATE_COMPLETED
 			 * to escape this state. */
 			break;
+		case RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE:
+			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_RELEASE, 0, 0,
+					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
+			/* Some external code must kick a request into RDMA_REQUEST_STATE_COMPLETED
+			 * to escape this state. */
+			break;
 		case RDMA_REQUEST_STATE_COMPLETED:
 			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_COMPLETED, 0, 0,
 					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
 
+			if (rdma_req->req.zcopy_bdev_io != NULL) {
+				/* Hand the buffers back to the bdev before the request is freed */
+				assert(spdk_nvmf_request_using_zcopy(&rdma_req->req));
+				rdma_req->state = RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE;
+				spdk_nvmf_request_zcopy_end(&rdma_req->req, false);
+				break;
+			}
+
 			rqpair->poller->stat.request_latency += spdk_get_ticks() - rdma_req->receive_tsc;
 			_nvmf_rdma_request_free(rdma_req, rtransport);
 			break;
@@ -2451,6 +2692,8 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 #define SPDK_NVMF_RDMA_DEFAULT_NUM_SHARED_BUFFERS 4095
 #define SPDK_NVMF_RDMA_DEFAULT_BUFFER_CACHE_SIZE UINT32_MAX
 #define SPDK_NVMF_RDMA_DEFAULT_NO_SRQ false
+#define SPDK_NVMF_RDMA_DEFAULT_NUM_SRQS 1
+#define SPDK_NVMF_RDMA_DEFAULT_ADAPTIVE_SRQ_POSTING false
 #define SPDK_NVMF_RDMA_DIF_INSERT_OR_STRIP false
 #define SPDK_NVMF_RDMA_ACCEPTOR_BACKLOG 100
 #define SPDK_NVMF_RDMA_DEFAULT_ABORT_TIMEOUT_SEC 1
@@ -2644,6 +2887,8 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 	rtransport->rdma_opts.num_cqe = DEFAULT_NVMF_RDMA_CQ_SIZE;
 	rtransport->rdma_opts.max_srq_depth = SPDK_NVMF_RDMA_DEFAULT_SRQ_DEPTH;
 	rtransport->rdma_opts.no_srq = SPDK_NVMF_RDMA_DEFAULT_NO_SRQ;
+	rtransport->rdma_opts.num_srqs = SPDK_NVMF_RDMA_DEFAULT_NUM_SRQS;
+	rtransport->rdma_opts.adaptive_srq_posting = SPDK_NVMF_RDMA_DEFAULT_ADAPTIVE_SRQ_POSTING;
 	rtransport->rdma_opts.acceptor_backlog = SPDK_NVMF_RDMA_ACCEPTOR_BACKLOG;
 	rtransport->rdma_opts.no_wr_batching = SPDK_NVMF_RDMA_DEFAULT_NO_WR_BATCHING;
 	if (opts->transport_specific != NULL &&
@@ -2660,6 +2905,7 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     "  max_io_qpairs_per_ctrlr=%d, io_unit_size=%d,\n"
 		     "  in_capsule_data_size=%d, max_aq_depth=%d,\n"
 		     "  num_shared_buffers=%d, num_cqe=%d, max_srq_depth=%d, no_srq=%d,"
+		     "  num_srqs=%u, adaptive_srq_posting=%d,"
 		     "  acceptor_backlog=%d, no_wr_batching=%d abort_timeout_sec=%d\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
@@ -2671,6 +2917,8 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     rtransport->rdma_opts.num_cqe,
 		     rtransport->rdma_opts.max_srq_depth,
 		     rtransport->rdma_opts.no_srq,
+		     rtransport->rdma_opts.num_srqs,
+		     rtransport->rdma_opts.adaptive_srq_posting,
 		     rtransport->rdma_opts.acceptor_backlog,
 		     rtransport->rdma_opts.no_wr_batching,
 		     opts->abort_timeout_sec);
@@ -2686,6 +2934,12 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		rtransport->rdma_opts.acceptor_backlog = SPDK_NVMF_RDMA_ACCEPTOR_BACKLOG;
 	}
 
+	if (rtransport->rdma_opts.num_srqs == 0) {
+		SPDK_ERRLOG("The number of SRQs cannot be less than 1, setting to the default value of (%d).\n",
+			    SPDK_NVMF_RDMA_DEFAULT_NUM_SRQS);
+		rtransport->rdma_opts.num_srqs = SPDK_NVMF_RDMA_DEFAULT_NUM_SRQS;
+	}
+
 	if (opts->num_shared_buffers < (SPDK_NVMF_MAX_SGL_ENTRIES * 2)) {
 		SPDK_ERRLOG("The number of shared data buffers (%d) is less than"
 			    "the minimum number required to guarantee that forward progress can be made (%d)\n",
@@ -2832,6 +3086,9 @@ nvmf_rdma_dump_opts(struct spdk_nvmf_transport *transport, struct spdk_json_writ
 	spdk_json_write_named_bool(w, "no_srq", rtransport->rdma_opts.no_srq);
 	if (rtransport->rdma_opts.no_srq == true) {
 		spdk_json_write_named_int32(w, "num_cqe", rtransport->rdma_opts.num_cqe);
+	} else {
+		spdk_json_write_named_uint32(w, "num_srqs", rtransport->rdma_opts.num_srqs);
+		spdk_json_write_named_bool(w, "adaptive_srq_posting", rtransport->rdma_opts.adaptive_srq_posting);
 	}
 	spdk_json_write_named_int32(w, "acceptor_backlog", rtransport->rdma_opts.acceptor_backlog);
 	spdk_json_write_named_bool(w, "no_wr_batching", rtransport->rdma_opts.no_wr_batching);
@@ -3937,8 +4194,10 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 			struct spdk_nvmf_rdma_poller **out_poller)
 {
 	struct spdk_nvmf_rdma_poller		*poller;
+	struct spdk_nvmf_rdma_srq		*rsrq;
 	struct spdk_rdma_srq_init_attr		srq_init_attr;
 	struct spdk_nvmf_rdma_resource_opts	opts;
+	uint32_t				num_srqs, i;
 	int					num_cqe;
 
 	poller = calloc(1, sizeof(*poller));
@@ -3964,40 +4223,62 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 		}
 		poller->max_srq_depth = spdk_min((int)rtransport->rdma_opts.max_srq_depth, device->attr.max_srq_wr);
 
-		device->num_srq++;
-		memset(&srq_init_attr, 0, sizeof(srq_init_attr));
-		srq_init_attr.pd = device->pd;
-		srq_init_attr.stats = &poller->stat.qp_stats.recv;
-		srq_init_attr.srq_init_attr.attr.max_wr = poller->max_srq_depth;
-		srq_init_attr.srq_init_attr.attr.max_sge = spdk_min(device->attr.max_sge, NVMF_DEFAULT_RX_SGE);
-		poller->srq = spdk_rdma_srq_create(&srq_init_attr);
-		if (!poller->srq) {
-			SPDK_ERRLOG("Unable to create shared receive queue, errno %d\n", errno);
-			return -1;
+		num_srqs = spdk_min(rtransport->rdma_opts.num_srqs, (uint32_t)(device->attr.max_srq - device->num_srq));
+		if (num_srqs < rtransport->rdma_opts.num_srqs) {
+			SPDK_WARNLOG("Requested %u SRQs per poller, only %u are available on dev %s\n",
+				     rtransport->rdma_opts.num_srqs, num_srqs, device->context->device->name);
 		}
 
-		opts.qp = poller->srq;
-		opts.map = device->map;
-		opts.qpair = NULL;
-		opts.shared = true;
-		opts.max_queue_depth = poller->max_srq_depth;
-		opts.in_capsule_data_size = rtransport->transport.opts.in_capsule_data_size;
-
-		poller->resources = nvmf_rdma_resources_create(&opts);
-		if (!poller->resources) {
-			SPDK_ERRLOG("Unable to allocate resources for shared receive queue.\n");
+		poller->srqs = calloc(num_srqs, sizeof(*poller->srqs));
+		if (!poller->srqs) {
+			SPDK_ERRLOG("Unable to allocate memory for shared receive queues\n");
 			return -1;
 		}
+		poller->num_srqs = num_srqs;
+		poller->srq_adjust_period_ticks = spdk_get_ticks_hz() * NVMF_RDMA_SRQ_ADJUST_PERIOD_US /
+						  SPDK_SEC_TO_USEC;
+
+		for (i = 0; i < num_srqs; i++) {
+			rsrq = &poller->srqs[i];
+			rsrq->target_recvs = poller->max_srq_depth;
+			rsrq->period_start_tsc = spdk_get_ticks();
+			STAILQ_INIT(&rsrq->idle_recvs);
+
+			device->num_srq++;
+			memset(&srq_init_attr, 0, sizeof(srq_init_attr));
+			srq_init_attr.pd = device->pd;
+			srq_init_attr.stats = &poller->stat.qp_stats.recv;
+			srq_init_attr.srq_init_attr.attr.max_wr = poller->max_srq_depth;
+			srq_init_attr.srq_init_attr.attr.max_sge = spdk_min(device->attr.max_sge, NVMF_DEFAULT_RX_SGE);
+			rsrq->rdma_srq = spdk_rdma_srq_create(&srq_init_attr);
+			if (!rsrq->rdma_srq) {
+				SPDK_ERRLOG("Unable to create shared receive queue, errno %d\n", errno);
+				return -1;
+			}
+
+			opts.qp = rsrq;
+			opts.map = device->map;
+			opts.qpair = NULL;
+			opts.shared = true;
+			opts.max_queue_depth = poller->max_srq_depth;
+			opts.in_capsule_data_size = rtransport->transport.opts.in_capsule_data_size;
+
+			rsrq->resources = nvmf_rdma_resources_create(&opts);
+			if (!rsrq->resources) {
+				SPDK_ERRLOG("Unable to allocate resources for shared receive queue.\n");
+				return -1;
+			}
+		}
 	}
 
 	/*
 	 * When using an srq, we can limit the completion queue at startup.
 	 * The following formula represents the calculation:
-	 * num_cqe = num_recv + num_data_wr + num_send_wr.
+	 * num_cqe = (num_recv + num_data_wr + num_send_wr) * num_srqs.
 	 * where num_recv=num_data_wr=and num_send_wr=poller->max_srq_depth
 	 */
-	if (poller->srq) {
-		num_cqe = poller->max_srq_depth * 3;
+	if (poller->num_srqs) {
+		num_cqe = poller->max_srq_depth * 3 * poller->num_srqs;
 	} else {
 		num_cqe = rtransport->rdma_opts.num_cqe;
 	}
@@ -4144,6 +4425,8 @@ static void
 nvmf_rdma_poller_destroy(struct spdk_nvmf_rdma_poller *poller)
 {
 	struct spdk_nvmf_rdma_qpair	*qpair, *tmp_qpair;
+	struct spdk_nvmf_rdma_srq	*rsrq;
+	uint32_t			i;
 	int				rc;
 
 	TAILQ_REMOVE(&poller->group->pollers, poller, link);
@@ -4151,13 +4434,17 @@ nvmf_rdma_poller_destroy(struct spdk_nvmf_rdma_poller *poller)
 		nvmf_rdma_qpair_destroy(qpair);
 	}
 
-	if (poller->srq) {
-		if (poller->resources) {
-			nvmf_rdma_resources_destroy(poller->resources);
+	for (i = 0; i < poller->num_srqs; i++) {
+		rsrq = &poller->srqs[i];
+		if (rsrq->resources) {
+			nvmf_rdma_resources_destroy(rsrq->resources);
+		}
+		if (rsrq->rdma_srq) {
+			spdk_rdma_srq_destroy(rsrq->rdma_srq);
+			SPDK_DEBUGLOG(rdma, "Destroyed RDMA shared queue %p\n", rsrq->rdma_srq);
 		}
-		spdk_rdma_srq_destroy(poller->srq);
-		SPDK_DEBUGLOG(rdma, "Destroyed RDMA shared queue %p\n", poller->srq);
 	}
+	free(poller->srqs);
 
 	if (poller->cq) {
 		rc = ibv_destroy_cq(poller->cq);
@@ -4222,6 +4509,22 @@ nvmf_rdma_qpair_reject_connection(struct spdk_nvmf_rdma_qpair *rqpair)
 	}
 }
 
+static struct spdk_nvmf_rdma_srq *
+nvmf_rdma_poller_get_srq(struct spdk_nvmf_rdma_poller *poller)
+{
+	struct spdk_nvmf_rdma_srq *rsrq = NULL;
+	uint32_t i;
+
+	/* Attach the qpair to the SRQ which serves the fewest qpairs */
+	for (i = 0; i < poller->num_srqs; i++) {
+		if (rsrq == NULL || poller->srqs[i].num_qpairs < rsrq->num_qpairs) {
+			rsrq = &poller->srqs[i];
+		}
+	}
+
+	return rsrq;
+}
+
 static int
 nvmf_rdma_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 			 struct spdk_nvmf_qpair *qpair)
@@ -4254,7 +4557,7 @@ nvmf_rdma_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 	}
 
 	rqpair->poller = poller;
-	rqpair->srq = rqpair->poller->srq;
+	rqpair->srq = nvmf_rdma_poller_get_srq(poller);
 
 	rc = nvmf_rdma_qpair_initialize(qpair);
 	if (rc < 0) {
@@ -4264,6 +4567,10 @@ nvmf_rdma_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 		return -1;
 	}
 
+	if (rqpair->srq != NULL) {
+		rqpair->srq->num_qpairs++;
+	}
+
 	RB_INSERT(qpairs_tree, &poller->qpairs, rqpair);
 
 	rc = nvmf_rdma_event_accept(rqpair->cm_id, rqpair);
@@ -4320,13 +4627,28 @@ nvmf_rdma_request_free(struct spdk_nvmf_request *req)
 		int rc;
 		struct ibv_recv_wr *bad_recv_wr;
 
-		spdk_rdma_srq_queue_recv_wrs(rqpair->srq, &rdma_req->recv->wr);
-		rc = spdk_rdma_srq_flush_recv_wrs(rqpair->srq, &bad_recv_wr);
+		nvmf_rdma_srq_queue_recv(rdma_req->recv->srq, rdma_req->recv);
+		rc = spdk_rdma_srq_flush_recv_wrs(rdma_req->recv->srq->rdma_srq, &bad_recv_wr);
 		if (rc) {
 			SPDK_ERRLOG("Unable to re-post rx descriptor\n");
 		}
 	}
 
+	if (rdma_req->req.zcopy_bdev_io != NULL) {
+		/* The zcopy buffers need to be released first.  If they're still being written
+		 * to the host, that's done once the RDMA operation completes. */
+		if (rdma_req->state != RDMA_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST &&
+		    rdma_req->state != RDMA_REQUEST_STATE_COMPLETING) {
+			if (rdma_req->state == RDMA_REQUEST_STATE_DATA_TRANSFER_TO_HOST_PENDING) {
+				STAILQ_REMOVE(&rqpair->pending_rdma_write_queue, rdma_req,
+					      spdk_nvmf_rdma_request, state_link);
+			}
+			rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+			nvmf_rdma_request_process(rtransport, rdma_req);
+		}
+		return 0;
+	}
+
 	_nvmf_rdma_request_free(rdma_req, rtransport);
 	return 0;
 }
@@ -4341,9 +4663,15 @@ nvmf_rdma_request_complete(struct spdk_nvmf_request *req)
 	struct spdk_nvmf_rdma_qpair     *rqpair = SPDK_CONTAINEROF(rdma_req->req.qpair,
 			struct spdk_nvmf_rdma_qpair, qpair);
 
-	if (rqpair->ibv_state != IBV_QPS_ERR) {
+	if (rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE) {
+		rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+	} else if (rqpair->ibv_state != IBV_QPS_ERR) {
 		/* The connection is alive, so process the request as normal */
-		rdma_req->state = RDMA_REQUEST_STATE_EXECUTED;
+		if (rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_START) {
+			rdma_req->state = RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED;
+		} else {
+			rdma_req->state = RDMA_REQUEST_STATE_EXECUTED;
+		}
 	} else {
 		/* The connection is dead. Move the request directly to the completed state. */
 		rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
@@ -4415,6 +4743,7 @@ _poller_reset_failed_recvs(struct spdk_nvmf_rdma_poller *rpoller, struct ibv_rec
 		bad_rdma_wr = (struct spdk_nvmf_rdma_wr *)bad_recv_wr->wr_id;
 		rdma_recv = SPDK_CONTAINEROF(bad_rdma_wr, struct spdk_nvmf_rdma_recv, rdma_wr);
 
+		rdma_recv->srq->posted_recvs--;
 		rdma_recv->qpair->current_recv_depth++;
 		bad_recv_wr = bad_recv_wr->next;
 		SPDK_ERRLOG("Failed to post a recv for the qpair %p with errno %d\n", rdma_recv->qpair, -rc);
@@ -4438,13 +4767,19 @@ _poller_submit_recvs(struct spdk_nvmf_rdma_transport *rtransport,
 		     struct spdk_nvmf_rdma_poller *rpoller)
 {
 	struct spdk_nvmf_rdma_qpair	*rqpair;
+	struct spdk_nvmf_rdma_srq	*rsrq;
 	struct ibv_recv_wr		*bad_recv_wr;
+	uint32_t			i;
 	int				rc;
 
-	if (rpoller->srq) {
-		rc = spdk_rdma_srq_flush_recv_wrs(rpoller->srq, &bad_recv_wr);
-		if (rc) {
-			_poller_reset_failed_recvs(rpoller, bad_recv_wr, rc);
+	if (rpoller->num_srqs) {
+		for (i = 0; i < rpoller->num_srqs; i++) {
+			rsrq = &rpoller->srqs[i];
+			nvmf_rdma_srq_refill(rsrq);
+			rc = spdk_rdma_srq_flush_recv_wrs(rsrq->rdma_srq, &bad_recv_wr);
+			if (rc) {
+				_poller_reset_failed_recvs(rpoller, bad_recv_wr, rc);
+			}
 		}
 	} else {
 		while (!STAILQ_EMPTY(&rpoller->qpairs_pending_recv)) {
@@ -4638,7 +4973,10 @@ nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 		case RDMA_WR_TYPE_RECV:
 			/* rdma_recv->qpair will be invalid if using an SRQ.  In that case we have to get the qpair from the wc. */
 			rdma_recv = SPDK_CONTAINEROF(rdma_wr, struct spdk_nvmf_rdma_recv, rdma_wr);
-			if (rpoller->srq != NULL) {
+			if (rpoller->num_srqs) {
+				assert(rdma_recv->srq->posted_recvs > 0);
+				rdma_recv->srq->posted_recvs--;
+				rdma_recv->srq->consumed_recvs++;
 				rdma_recv->qpair = get_rdma_qpair_from_wc(rpoller, &wc[i]);
 				/* It is possible that there are still some completions for destroyed QP
 				 * associated with SRQ. We just ignore these late completions and re-post
@@ -4648,8 +4986,8 @@ nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 					struct ibv_recv_wr *bad_wr;
 
 					rdma_recv->wr.next = NULL;
-					spdk_rdma_srq_queue_recv_wrs(rpoller->srq, &rdma_recv->wr);
-					rc = spdk_rdma_srq_flush_recv_wrs(rpoller->srq, &bad_wr);
+					nvmf_rdma_srq_queue_recv(rdma_recv->srq, rdma_recv);
+					rc = spdk_rdma_srq_flush_recv_wrs(rdma_recv->srq->rdma_srq, &bad_wr);
 					if (rc) {
 						SPDK_ERRLOG("Failed to re-post recv WR to SRQ, err %d\n", rc);
 					}
@@ -4747,6 +5085,14 @@ nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 		return -1;
 	}
 
+	if (rtransport->rdma_opts.adaptive_srq_posting) {
+		for (i = 0; i < (int)rpoller->num_srqs; i++) {
+			nvmf_rdma_srq_update_target(&rpoller->srqs[i], rpoller->max_srq_depth,
+						    reaped == (int)SPDK_COUNTOF(wc), poll_tsc,
+						    rpoller->srq_adjust_period_ticks);
+		}
+	}
+
 	/* submit outstanding work requests. */
 	_poller_submit_recvs(rtransport, rpoller);
 	_poller_submit_sends(rtransport, rpoller);
@@ -5035,6 +5381,8 @@ nvmf_rdma_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group,
 {
 	struct spdk_nvmf_rdma_poll_group *rgroup;
 	struct spdk_nvmf_rdma_poller *rpoller;
+	uint64_t posted_recvs, target_recvs;
+	uint32_t i;
 
 	assert(w != NULL);
 
@@ -5072,6 +5420,17 @@ nvmf_rdma_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group,
 					     rpoller->stat.qp_stats.recv.num_submitted_wrs);
 		spdk_json_write_named_uint64(w, "recv_doorbell_updates",
 					     rpoller->stat.qp_stats.recv.doorbell_updates);
+		if (rpoller->num_srqs) {
+			posted_recvs = 0;
+			target_recvs = 0;
+			for (i = 0; i < rpoller->num_srqs; i++) {
+				posted_recvs += rpoller->srqs[i].posted_recvs;
+				target_recvs += rpoller->srqs[i].target_recvs;
+			}
+			spdk_json_write_named_uint32(w, "srqs", rpoller->num_srqs);
+			spdk_json_write_named_uint64(w, "srq_posted_recvs", posted_recvs);
+			spdk_json_write_named_uint64(w, "srq_target_recvs", target_recvs);
+		}
 		spdk_json_write_object_end(w);
 	}
 
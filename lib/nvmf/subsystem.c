@@ -339,6 +339,7 @@ _nvmf_subsystem_remove_listener(struct spdk_nvmf_subsystem *subsystem,
 	TAILQ_REMOVE(&subsystem->listeners, listener, link);
 	nvmf_update_discovery_log(listener->subsystem->tgt, NULL);
 	free(listener->ana_state);
+	free(listener->ana_log.buf);
 	spdk_bit_array_clear(subsystem->used_listener_ids, listener->id);
 	free(listener);
 }
@@ -1354,6 +1355,8 @@ spdk_nvmf_subsystem_any_listener_allowed(struct spdk_nvmf_subsystem *subsystem)
 
 struct subsystem_update_ns_ctx {
 	struct spdk_nvmf_subsystem *subsystem;
+	/* Only refresh this namespace, 0 refreshes the whole subsystem */
+	uint32_t nsid;
 
 	spdk_nvmf_subsystem_state_change_done cb_fn;
 	void *cb_arg;
@@ -1377,12 +1380,27 @@ subsystem_update_ns_on_pg(struct spdk_io_channel_iter *i)
 	struct subsystem_update_ns_ctx *ctx;
 	struct spdk_nvmf_poll_group *group;
 	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ctrlr *ctrlr;
 
 	ctx = spdk_io_channel_iter_get_ctx(i);
 	group = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
 	subsystem = ctx->subsystem;
 
-	rc = nvmf_poll_group_update_subsystem(group, subsystem);
+	if (ctx->nsid != 0) {
+		/* The changed namespace list is owned by the controller's thread, update it
+		 * before the poll group sends out the AEN.
+		 */
+		TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+			if (ctrlr->thread == spdk_get_thread()) {
+				nvmf_ctrlr_ns_changed(ctrlr, ctx->nsid);
+			}
+		}
+
+		rc = nvmf_poll_group_update_ns(group, subsystem, ctx->nsid);
+	} else {
+		rc = nvmf_poll_group_update_subsystem(group, subsystem);
+	}
+
 	spdk_for_each_channel_continue(i, rc);
 }
 
@@ -1398,6 +1416,32 @@ nvmf_subsystem_update_ns(struct spdk_nvmf_subsystem *subsystem, spdk_channel_for
 	return 0;
 }
 
+/*
+ * Publish a change to a single namespace of an active subsystem.  Each poll group refreshes
+ * only that namespace the next time it polls, so I/O to the other namespaces (and to this
+ * one, if it's being resized) keeps flowing instead of the whole subsystem being paused.
+ */
+static int
+nvmf_subsystem_update_ns_live(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			      spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg)
+{
+	struct subsystem_update_ns_ctx *ctx;
+
+	assert(nsid != 0);
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->nsid = nsid;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	return nvmf_subsystem_update_ns(subsystem, subsystem_update_ns_done, ctx);
+}
+
 static void
 nvmf_subsystem_ns_changed(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
 {
@@ -1431,12 +1475,14 @@ spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t ns
 		return -1;
 	}
 
-	subsystem->ns[nsid - 1] = NULL;
-
 	assert(ns->anagrpid - 1 < subsystem->max_nsid);
 	assert(subsystem->ana_group[ns->anagrpid - 1] > 0);
 
+	pthread_mutex_lock(&subsystem->mutex);
+	subsystem->ns[nsid - 1] = NULL;
 	subsystem->ana_group[ns->anagrpid - 1]--;
+	subsystem->ana_group_change_count++;
+	pthread_mutex_unlock(&subsystem->mutex);
 
 	free(ns->ptpl_file);
 	nvmf_ns_reservation_clear_all_registrants(ns);
@@ -1554,6 +1600,14 @@ nvmf_ns_resize(void *event_ctx)
 	struct subsystem_ns_change_ctx *ns_ctx;
 	int rc;
 
+	/* Namespaces can only grow, so an active subsystem doesn't need to be paused at all.
+	 * Just let the poll groups pick up the new size.
+	 */
+	if (ns->subsystem->state == SPDK_NVMF_SUBSYSTEM_ACTIVE &&
+	    nvmf_subsystem_update_ns_live(ns->subsystem, ns->opts.nsid, NULL, NULL) == 0) {
+		return;
+	}
+
 	/* We have to allocate a new context because this op
 	 * is asynchronous and we could lose the ns in the middle.
 	 */
@@ -1642,6 +1696,8 @@ spdk_nvmf_ns_opts_get_defaults(struct spdk_nvmf_ns_opts *opts, size_t opts_size)
 		spdk_uuid_set_null(&opts->uuid);
 	}
 	SET_FIELD(anagrpid, 0);
+	SET_FIELD(max_io_outstanding, 0);
+	SET_FIELD(latency_target_us, 0);
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -1671,13 +1727,15 @@ nvmf_ns_opts_copy(struct spdk_nvmf_ns_opts *opts,
 		spdk_uuid_copy(&opts->uuid, &user_opts->uuid);
 	}
 	SET_FIELD(anagrpid);
+	SET_FIELD(max_io_outstanding);
+	SET_FIELD(latency_target_us);
 
 	opts->opts_size = user_opts->opts_size;
 
 	/* We should not remove this statement, but need to update the assert statement
 	 * if we add a new field, and also add a corresponding SET_FIELD statement.
 	 */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ns_opts) == 64, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ns_opts) == 72, "Incorrect size");
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -1706,7 +1764,8 @@ spdk_nvmf_subsystem_add_ns_ext(struct spdk_nvmf_subsystem *subsystem, const char
 	uint64_t max_zone_append_size_kib;
 
 	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
-	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
+	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED ||
+	      subsystem->state == SPDK_NVMF_SUBSYSTEM_ACTIVE)) {
 		return 0;
 	}
 
@@ -1828,10 +1887,8 @@ spdk_nvmf_subsystem_add_ns_ext(struct spdk_nvmf_subsystem *subsystem, const char
 
 	ns->opts = opts;
 	ns->subsystem = subsystem;
-	subsystem->ns[opts.nsid - 1] = ns;
 	ns->nsid = opts.nsid;
 	ns->anagrpid = opts.anagrpid;
-	subsystem->ana_group[ns->anagrpid - 1]++;
 	TAILQ_INIT(&ns->registrants);
 	if (ptpl_file) {
 		rc = nvmf_ns_load_reservation(ptpl_file, &info);
@@ -1860,23 +1917,55 @@ spdk_nvmf_subsystem_add_ns_ext(struct spdk_nvmf_subsystem *subsystem, const char
 		}
 	}
 
+	/* The namespace is only published once it's fully set up, as the admin commands of an
+	 * active subsystem may look it up from the poll group threads at any time.
+	 */
+	pthread_mutex_lock(&subsystem->mutex);
+	__atomic_store_n(&subsystem->ns[opts.nsid - 1], ns, __ATOMIC_RELEASE);
+	subsystem->ana_group[ns->anagrpid - 1]++;
+	subsystem->ana_group_change_count++;
+	pthread_mutex_unlock(&subsystem->mutex);
+
 	SPDK_DEBUGLOG(nvmf, "Subsystem %s: bdev %s assigned nsid %" PRIu32 "\n",
 		      spdk_nvmf_subsystem_get_nqn(subsystem),
 		      bdev_name,
 		      opts.nsid);
 
-	nvmf_subsystem_ns_changed(subsystem, opts.nsid);
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		/* The I/O path rejects the namespace until its poll group has opened a channel
+		 * for it, so there's no need to pause the subsystem.
+		 */
+		rc = nvmf_subsystem_update_ns_live(subsystem, opts.nsid, NULL, NULL);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to update the poll groups of subsystem %s\n",
+				    subsystem->subnqn);
+			goto err_update_ns;
+		}
+	} else {
+		nvmf_subsystem_ns_changed(subsystem, opts.nsid);
+	}
 
 	SPDK_DTRACE_PROBE2(nvmf_subsystem_add_ns, subsystem->subnqn, ns->nsid);
 
 	return opts.nsid;
 
+err_update_ns:
+	pthread_mutex_lock(&subsystem->mutex);
+	subsystem->ns[opts.nsid - 1] = NULL;
+	subsystem->ana_group[ns->anagrpid - 1]--;
+	subsystem->ana_group_change_count++;
+	pthread_mutex_unlock(&subsystem->mutex);
+	for (transport = spdk_nvmf_transport_get_first(subsystem->tgt); transport;
+	     transport = spdk_nvmf_transport_get_next(transport)) {
+		if (transport->ops->subsystem_remove_ns) {
+			transport->ops->subsystem_remove_ns(transport, subsystem, opts.nsid);
+		}
+	}
 err_subsystem_add_ns:
 	free(ns->ptpl_file);
 err_strdup:
 	nvmf_ns_reservation_clear_all_registrants(ns);
 err_ns_reservation_restore:
-	subsystem->ns[opts.nsid - 1] = NULL;
 	spdk_bdev_module_release_bdev(ns->bdev);
 	spdk_bdev_close(ns->desc);
 	free(ns);
@@ -3268,6 +3357,7 @@ spdk_nvmf_subsystem_set_ana_reporting(struct spdk_nvmf_subsystem *subsystem,
 	}
 
 	subsystem->flags.ana_reporting = ana_reporting;
+	subsystem->ana_group_change_count++;
 
 	return 0;
 }
@@ -3376,12 +3466,14 @@ nvmf_subsystem_set_ana_state(struct spdk_nvmf_subsystem *subsystem,
 		return;
 	}
 
+	pthread_mutex_lock(&subsystem->mutex);
 	for (i = 1; i <= subsystem->max_nsid; i++) {
 		if (anagrpid == 0 || i == anagrpid) {
 			listener->ana_state[i - 1] = ana_state;
 		}
 	}
 	listener->ana_state_change_count++;
+	pthread_mutex_unlock(&subsystem->mutex);
 
 	ctx->listener = listener;
 	ctx->cb_fn = cb_fn;
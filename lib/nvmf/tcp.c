@@ -29,6 +29,18 @@
 #define SPDK_NVMF_TCP_DEFAULT_SOCK_PRIORITY 0
 #define SPDK_NVMF_TCP_DEFAULT_CONTROL_MSG_NUM 32
 #define SPDK_NVMF_TCP_DEFAULT_SUCCESS_OPTIMIZATION true
+#define SPDK_NVMF_TCP_DEFAULT_ZERO_COPY_RECV false
+#define SPDK_NVMF_TCP_DEFAULT_DIGEST_ACCEL_THRESHOLD 4096
+#define SPDK_NVMF_TCP_DEFAULT_NUMA_PLACEMENT false
+#define SPDK_NVMF_TCP_DEFAULT_POLL_GROUP_LOAD_THRESHOLD 0
+#define SPDK_NVMF_TCP_DEFAULT_ICD_POOL_SIZE 0
+#define SPDK_NVMF_TCP_DEFAULT_ICD_MIN_BUFS_PER_QPAIR 4
+
+/* Period over which the load of a poll group is measured */
+#define NVMF_TCP_POLL_GROUP_LOAD_PERIOD_US 100000
+
+/* Smallest header of the PDUs sent by a host (H2C data and H2C termination request) */
+#define NVMF_TCP_PDU_MIN_HLEN 24
 
 #define SPDK_NVMF_TCP_MIN_IO_QUEUE_DEPTH 2
 #define SPDK_NVMF_TCP_MAX_IO_QUEUE_DEPTH 65535
@@ -234,6 +246,8 @@ struct spdk_nvmf_tcp_req  {
 	bool					pdu_in_use;
 	bool					has_in_capsule_data;
 	bool					fused_failed;
+	/* The in-capsule data buffer was borrowed from the poll group pool */
+	bool					icd_buf_borrowed;
 
 	/* transfer_tag */
 	uint16_t				ttag;
@@ -277,14 +291,21 @@ struct spdk_nvmf_tcp_qpair {
 	bool					host_hdgst_enable;
 	bool					host_ddgst_enable;
 
+	/* The socket has no receive pipe, data is read directly into the PDUs and requests */
+	bool					zero_copy_recv;
+
 	/* This is a spare PDU used for sending special management
 	 * operations. Primarily, this is used for the initial
 	 * connection response and c2h termination request. */
 	struct nvme_tcp_pdu			*mgmt_pdu;
 
 	/* Arrays of in-capsule buffers, requests, and pdus.
-	 * Each array is 'resource_count' number of elements */
+	 * Each array is 'resource_count' number of elements, except for the in-capsule
+	 * buffers when the poll group has an in-capsule data pool. The qpair then only
+	 * owns a few buffers, kept on icd_bufs, and borrows the others from the pool. */
 	void					*bufs;
+	STAILQ_HEAD(, spdk_nvmf_tcp_icd_buf)	icd_bufs;
+	bool					shared_icd;
 	struct spdk_nvmf_tcp_req		*reqs;
 	struct nvme_tcp_pdu			*pdus;
 	uint32_t				resource_count;
@@ -320,6 +341,20 @@ struct spdk_nvmf_tcp_control_msg_list {
 	STAILQ_HEAD(, spdk_nvmf_tcp_control_msg) free_msgs;
 };
 
+struct spdk_nvmf_tcp_icd_buf {
+	STAILQ_ENTRY(spdk_nvmf_tcp_icd_buf)	link;
+};
+
+struct spdk_nvmf_tcp_icd_pool {
+	void					*bufs;
+	STAILQ_HEAD(, spdk_nvmf_tcp_icd_buf)	free_bufs;
+	uint32_t				num_bufs;
+	/* Number of buffers each qpair keeps for itself */
+	uint32_t				min_qpair_bufs;
+	uint32_t				in_use;
+	uint32_t				max_in_use;
+};
+
 struct spdk_nvmf_tcp_poll_group {
 	struct spdk_nvmf_transport_poll_group	group;
 	struct spdk_sock_group			*sock_group;
@@ -329,6 +364,18 @@ struct spdk_nvmf_tcp_poll_group {
 
 	struct spdk_io_channel			*accel_channel;
 	struct spdk_nvmf_tcp_control_msg_list	*control_msg_list;
+	struct spdk_nvmf_tcp_icd_pool		icd_pool;
+
+	/* NUMA node of the core the poll group runs on */
+	int32_t					numa_id;
+
+	/* Percentage of the polls that found work in the last measurement period.
+	 * Written by the poll group thread, read when placing new qpairs.
+	 */
+	uint32_t				load;
+	uint64_t				load_polls;
+	uint64_t				load_busy_polls;
+	uint64_t				load_tsc;
 
 	TAILQ_ENTRY(spdk_nvmf_tcp_poll_group)	link;
 };
@@ -336,6 +383,8 @@ struct spdk_nvmf_tcp_poll_group {
 struct spdk_nvmf_tcp_port {
 	const struct spdk_nvme_transport_id	*trid;
 	struct spdk_sock			*listen_sock;
+	/* NUMA node of the network device the port listens on, -1 if unknown */
+	int32_t					numa_id;
 	TAILQ_ENTRY(spdk_nvmf_tcp_port)		link;
 };
 
@@ -343,6 +392,12 @@ struct tcp_transport_opts {
 	bool		c2h_success;
 	uint16_t	control_msg_num;
 	uint32_t	sock_priority;
+	bool		zero_copy_recv;
+	uint32_t	digest_accel_threshold;
+	bool		numa_placement;
+	uint32_t	poll_group_load_threshold;
+	uint32_t	icd_pool_size;
+	uint32_t	icd_min_bufs_per_qpair;
 };
 
 struct tcp_psk_entry {
@@ -385,6 +440,30 @@ static const struct spdk_json_object_decoder tcp_transport_opts_decoder[] = {
 		"sock_priority", offsetof(struct tcp_transport_opts, sock_priority),
 		spdk_json_decode_uint32, true
 	},
+	{
+		"zero_copy_recv", offsetof(struct tcp_transport_opts, zero_copy_recv),
+		spdk_json_decode_bool, true
+	},
+	{
+		"digest_accel_threshold", offsetof(struct tcp_transport_opts, digest_accel_threshold),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"numa_placement", offsetof(struct tcp_transport_opts, numa_placement),
+		spdk_json_decode_bool, true
+	},
+	{
+		"poll_group_load_threshold", offsetof(struct tcp_transport_opts, poll_group_load_threshold),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"icd_pool_size", offsetof(struct tcp_transport_opts, icd_pool_size),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"icd_min_bufs_per_qpair", offsetof(struct tcp_transport_opts, icd_min_bufs_per_qpair),
+		spdk_json_decode_uint32, true
+	},
 };
 
 static bool nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
@@ -595,6 +674,14 @@ nvmf_tcp_dump_opts(struct spdk_nvmf_transport *transport, struct spdk_json_write
 	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
 	spdk_json_write_named_bool(w, "c2h_success", ttransport->tcp_opts.c2h_success);
 	spdk_json_write_named_uint32(w, "sock_priority", ttransport->tcp_opts.sock_priority);
+	spdk_json_write_named_bool(w, "zero_copy_recv", ttransport->tcp_opts.zero_copy_recv);
+	spdk_json_write_named_uint32(w, "digest_accel_threshold", ttransport->tcp_opts.digest_accel_threshold);
+	spdk_json_write_named_bool(w, "numa_placement", ttransport->tcp_opts.numa_placement);
+	spdk_json_write_named_uint32(w, "poll_group_load_threshold",
+				     ttransport->tcp_opts.poll_group_load_threshold);
+	spdk_json_write_named_uint32(w, "icd_pool_size", ttransport->tcp_opts.icd_pool_size);
+	spdk_json_write_named_uint32(w, "icd_min_bufs_per_qpair",
+				     ttransport->tcp_opts.icd_min_bufs_per_qpair);
 }
 
 static int
@@ -644,6 +731,12 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 	ttransport->tcp_opts.c2h_success = SPDK_NVMF_TCP_DEFAULT_SUCCESS_OPTIMIZATION;
 	ttransport->tcp_opts.sock_priority = SPDK_NVMF_TCP_DEFAULT_SOCK_PRIORITY;
 	ttransport->tcp_opts.control_msg_num = SPDK_NVMF_TCP_DEFAULT_CONTROL_MSG_NUM;
+	ttransport->tcp_opts.zero_copy_recv = SPDK_NVMF_TCP_DEFAULT_ZERO_COPY_RECV;
+	ttransport->tcp_opts.digest_accel_threshold = SPDK_NVMF_TCP_DEFAULT_DIGEST_ACCEL_THRESHOLD;
+	ttransport->tcp_opts.numa_placement = SPDK_NVMF_TCP_DEFAULT_NUMA_PLACEMENT;
+	ttransport->tcp_opts.poll_group_load_threshold = SPDK_NVMF_TCP_DEFAULT_POLL_GROUP_LOAD_THRESHOLD;
+	ttransport->tcp_opts.icd_pool_size = SPDK_NVMF_TCP_DEFAULT_ICD_POOL_SIZE;
+	ttransport->tcp_opts.icd_min_bufs_per_qpair = SPDK_NVMF_TCP_DEFAULT_ICD_MIN_BUFS_PER_QPAIR;
 	if (opts->transport_specific != NULL &&
 	    spdk_json_decode_object_relaxed(opts->transport_specific, tcp_transport_opts_decoder,
 					    SPDK_COUNTOF(tcp_transport_opts_decoder),
@@ -661,7 +754,10 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     "  in_capsule_data_size=%d, max_aq_depth=%d\n"
 		     "  num_shared_buffers=%d, c2h_success=%d,\n"
 		     "  dif_insert_or_strip=%d, sock_priority=%d\n"
-		     "  abort_timeout_sec=%d, control_msg_num=%hu\n",
+		     "  abort_timeout_sec=%d, control_msg_num=%hu\n"
+		     "  zero_copy_recv=%d, digest_accel_threshold=%d\n"
+		     "  numa_placement=%d, poll_group_load_threshold=%d\n"
+		     "  icd_pool_size=%d, icd_min_bufs_per_qpair=%d\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
 		     opts->max_qpairs_per_ctrlr - 1,
@@ -673,7 +769,20 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     opts->dif_insert_or_strip,
 		     ttransport->tcp_opts.sock_priority,
 		     opts->abort_timeout_sec,
-		     ttransport->tcp_opts.control_msg_num);
+		     ttransport->tcp_opts.control_msg_num,
+		     ttransport->tcp_opts.zero_copy_recv,
+		     ttransport->tcp_opts.digest_accel_threshold,
+		     ttransport->tcp_opts.numa_placement,
+		     ttransport->tcp_opts.poll_group_load_threshold,
+		     ttransport->tcp_opts.icd_pool_size,
+		     ttransport->tcp_opts.icd_min_bufs_per_qpair);
+
+	if (ttransport->tcp_opts.poll_group_load_threshold > 100) {
+		SPDK_ERRLOG("Unsupported poll_group_load_threshold=%d, the range is: 0 to 100\n",
+			    ttransport->tcp_opts.poll_group_load_threshold);
+		free(ttransport);
+		return NULL;
+	}
 
 	if (ttransport->tcp_opts.sock_priority > SPDK_NVMF_TCP_DEFAULT_MAX_SOCK_PRIORITY) {
 		SPDK_ERRLOG("Unsupported socket_priority=%d, the current range is: 0 to %d\n"
@@ -865,6 +974,54 @@ tcp_sock_get_key(uint8_t *out, int out_len, const char **cipher, const char *psk
 	return -EINVAL;
 }
 
+/* Return the NUMA node of the network device that owns the address, -1 if it can't be found */
+static int32_t
+nvmf_tcp_get_addr_numa_id(const char *traddr)
+{
+	struct ifaddrs *ifaddrs, *ifa;
+	char addr[INET6_ADDRSTRLEN], path[PATH_MAX];
+	const void *sin_addr;
+	int32_t numa_id = -1;
+	FILE *file;
+
+	if (getifaddrs(&ifaddrs) != 0) {
+		return -1;
+	}
+
+	for (ifa = ifaddrs; ifa != NULL; ifa = ifa->ifa_next) {
+		if (ifa->ifa_addr == NULL) {
+			continue;
+		}
+
+		if (ifa->ifa_addr->sa_family == AF_INET) {
+			sin_addr = &((struct sockaddr_in *)ifa->ifa_addr)->sin_addr;
+		} else if (ifa->ifa_addr->sa_family == AF_INET6) {
+			sin_addr = &((struct sockaddr_in6 *)ifa->ifa_addr)->sin6_addr;
+		} else {
+			continue;
+		}
+
+		if (inet_ntop(ifa->ifa_addr->sa_family, sin_addr, addr, sizeof(addr)) == NULL ||
+		    strcmp(addr, traddr) != 0) {
+			continue;
+		}
+
+		snprintf(path, sizeof(path), "/sys/class/net/%s/device/numa_node", ifa->ifa_name);
+		file = fopen(path, "r");
+		if (file != NULL) {
+			if (fscanf(file, "%" SCNd32, &numa_id) != 1) {
+				numa_id = -1;
+			}
+			fclose(file);
+		}
+		break;
+	}
+
+	freeifaddrs(ifaddrs);
+
+	return numa_id;
+}
+
 static int
 nvmf_tcp_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_transport_id *trid,
 		struct spdk_nvmf_listen_opts *listen_opts)
@@ -898,6 +1055,7 @@ nvmf_tcp_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_tr
 	}
 
 	port->trid = trid;
+	port->numa_id = nvmf_tcp_get_addr_numa_id(trid->traddr);
 
 	sock_impl_name = NULL;
 
@@ -1089,6 +1247,18 @@ data_crc32_accel_done(void *cb_arg, int status)
 	_tcp_write_pdu(pdu);
 }
 
+static inline bool
+nvmf_tcp_pdu_use_accel_digest(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu)
+{
+	struct spdk_nvmf_tcp_transport *ttransport = SPDK_CONTAINEROF(tqpair->qpair.transport,
+			struct spdk_nvmf_tcp_transport, transport);
+
+	/* Only support this limitated case for the first step.  The digest of small PDUs is computed
+	 * inline, as the round trip through accel costs more than the computation itself. */
+	return !pdu->dif_ctx && (pdu->data_len % SPDK_NVME_TCP_DIGEST_ALIGNMENT == 0) &&
+	       pdu->data_len >= ttransport->tcp_opts.digest_accel_threshold && tqpair->group;
+}
+
 static void
 pdu_data_crc32_compute(struct nvme_tcp_pdu *pdu)
 {
@@ -1097,9 +1267,7 @@ pdu_data_crc32_compute(struct nvme_tcp_pdu *pdu)
 
 	/* Data Digest */
 	if (pdu->data_len > 0 && g_nvme_tcp_ddgst[pdu->hdr.common.pdu_type] && tqpair->host_ddgst_enable) {
-		/* Only support this limitated case for the first step */
-		if (spdk_likely(!pdu->dif_ctx && (pdu->data_len % SPDK_NVME_TCP_DIGEST_ALIGNMENT == 0)
-				&& tqpair->group)) {
+		if (spdk_likely(nvmf_tcp_pdu_use_accel_digest(tqpair, pdu))) {
 			rc = spdk_accel_submit_crc32cv(tqpair->group->accel_channel, &pdu->data_digest_crc32, pdu->data_iov,
 						       pdu->data_iovcnt, 0, data_crc32_accel_done, pdu);
 			if (spdk_likely(rc == 0)) {
@@ -1172,21 +1340,37 @@ nvmf_tcp_qpair_write_req_pdu(struct spdk_nvmf_tcp_qpair *tqpair,
 	nvmf_tcp_qpair_write_pdu(tqpair, pdu, cb_fn, cb_arg);
 }
 
+static uint32_t
+nvmf_tcp_get_icd_buf_size(const struct spdk_nvmf_transport_opts *opts)
+{
+	if (opts->dif_insert_or_strip) {
+		return SPDK_BDEV_BUF_SIZE_WITH_MD(opts->in_capsule_data_size);
+	}
+
+	return opts->in_capsule_data_size;
+}
+
 static int
-nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
+nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair,
+				 struct spdk_nvmf_tcp_poll_group *tgroup)
 {
 	uint32_t i;
 	struct spdk_nvmf_transport_opts *opts;
 	uint32_t in_capsule_data_size;
+	uint32_t num_bufs;
 
 	opts = &tqpair->qpair.transport->opts;
 
-	in_capsule_data_size = opts->in_capsule_data_size;
-	if (opts->dif_insert_or_strip) {
-		in_capsule_data_size = SPDK_BDEV_BUF_SIZE_WITH_MD(in_capsule_data_size);
-	}
+	in_capsule_data_size = nvmf_tcp_get_icd_buf_size(opts);
 
 	tqpair->resource_count = opts->max_queue_depth;
+	num_bufs = tqpair->resource_count;
+
+	STAILQ_INIT(&tqpair->icd_bufs);
+	if (tgroup != NULL && tgroup->icd_pool.num_bufs > 0) {
+		tqpair->shared_icd = true;
+		num_bufs = spdk_min(tgroup->icd_pool.min_qpair_bufs, tqpair->resource_count);
+	}
 
 	tqpair->reqs = calloc(tqpair->resource_count, sizeof(*tqpair->reqs));
 	if (!tqpair->reqs) {
@@ -1194,8 +1378,8 @@ nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
 		return -1;
 	}
 
-	if (in_capsule_data_size) {
-		tqpair->bufs = spdk_zmalloc(tqpair->resource_count * in_capsule_data_size, 0x1000,
+	if (in_capsule_data_size && num_bufs) {
+		tqpair->bufs = spdk_zmalloc(num_bufs * in_capsule_data_size, 0x1000,
 					    NULL, SPDK_ENV_LCORE_ID_ANY,
 					    SPDK_MALLOC_DMA);
 		if (!tqpair->bufs) {
@@ -1203,6 +1387,13 @@ nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
 			return -1;
 		}
 	}
+
+	if (tqpair->shared_icd) {
+		for (i = 0; tqpair->bufs && i < num_bufs; i++) {
+			STAILQ_INSERT_TAIL(&tqpair->icd_bufs, (struct spdk_nvmf_tcp_icd_buf *)
+					   ((uintptr_t)tqpair->bufs + i * in_capsule_data_size), link);
+		}
+	}
 	/* prepare memory space for receiving pdus and tcp_req */
 	/* Add additional 1 member, which will be used for mgmt_pdu owned by the tqpair */
 	tqpair->pdus = spdk_dma_zmalloc((2 * tqpair->resource_count + 1) * sizeof(*tqpair->pdus), 0x1000,
@@ -1221,8 +1412,8 @@ nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
 		tcp_req->pdu = &tqpair->pdus[i];
 		tcp_req->pdu->qpair = tqpair;
 
-		/* Set up memory to receive commands */
-		if (tqpair->bufs) {
+		/* Set up memory to receive commands, unless it is taken on demand */
+		if (tqpair->bufs && !tqpair->shared_icd) {
 			tcp_req->buf = (void *)((uintptr_t)tqpair->bufs + (i * in_capsule_data_size));
 		}
 
@@ -1439,6 +1630,30 @@ nvmf_tcp_control_msg_list_free(struct spdk_nvmf_tcp_control_msg_list *list)
 	free(list);
 }
 
+static int
+nvmf_tcp_icd_pool_create(struct spdk_nvmf_tcp_icd_pool *pool, uint32_t num_bufs,
+			 uint32_t buf_size, uint32_t min_qpair_bufs)
+{
+	uint32_t i;
+
+	STAILQ_INIT(&pool->free_bufs);
+	pool->bufs = spdk_zmalloc((size_t)num_bufs * buf_size, 0x1000, NULL,
+				  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (!pool->bufs) {
+		SPDK_ERRLOG("Failed to allocate memory for the in-capsule data pool\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_bufs; i++) {
+		STAILQ_INSERT_TAIL(&pool->free_bufs, (struct spdk_nvmf_tcp_icd_buf *)
+				   ((uintptr_t)pool->bufs + (size_t)i * buf_size), link);
+	}
+	pool->num_bufs = num_bufs;
+	pool->min_qpair_bufs = min_qpair_bufs;
+
+	return 0;
+}
+
 static struct spdk_nvmf_transport_poll_group *
 nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 			   struct spdk_nvmf_poll_group *group)
@@ -1459,6 +1674,9 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 	TAILQ_INIT(&tgroup->qpairs);
 	TAILQ_INIT(&tgroup->await_req);
 
+	tgroup->numa_id = (int32_t)spdk_env_get_socket_id(spdk_env_get_current_core());
+	tgroup->load_tsc = spdk_get_ticks();
+
 	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
 
 	if (transport->opts.in_capsule_data_size < SPDK_NVME_TCP_IN_CAPSULE_DATA_MAX_SIZE) {
@@ -1471,6 +1689,14 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 		}
 	}
 
+	if (ttransport->tcp_opts.icd_pool_size > 0 && transport->opts.in_capsule_data_size > 0) {
+		if (nvmf_tcp_icd_pool_create(&tgroup->icd_pool, ttransport->tcp_opts.icd_pool_size,
+					     nvmf_tcp_get_icd_buf_size(&transport->opts),
+					     ttransport->tcp_opts.icd_min_bufs_per_qpair)) {
+			goto cleanup;
+		}
+	}
+
 	tgroup->accel_channel = spdk_accel_get_io_channel();
 	if (spdk_unlikely(!tgroup->accel_channel)) {
 		SPDK_ERRLOG("Cannot create accel_channel for tgroup=%p\n", tgroup);
@@ -1489,13 +1715,62 @@ cleanup:
 	return NULL;
 }
 
+static inline bool
+nvmf_tcp_poll_group_is_overloaded(struct spdk_nvmf_tcp_transport *ttransport,
+				  struct spdk_nvmf_tcp_poll_group *tgroup)
+{
+	uint32_t threshold = ttransport->tcp_opts.poll_group_load_threshold;
+
+	return threshold != 0 && tgroup->load >= threshold;
+}
+
+/*
+ * Walk the poll groups in round-robin order, starting at next_pg, and return the first one
+ * that is local to the NIC the connection arrived on and isn't overloaded. If there is no such
+ * group, settle for the first local one, then for the first one that isn't overloaded.
+ * Without numa_placement and poll_group_load_threshold this is plain round-robin.
+ */
+static struct spdk_nvmf_tcp_poll_group *
+nvmf_tcp_select_poll_group(struct spdk_nvmf_tcp_transport *ttransport, int32_t numa_id)
+{
+	struct spdk_nvmf_tcp_poll_group *tgroup, *local = NULL, *idle = NULL;
+	bool is_local, is_overloaded;
+
+	tgroup = ttransport->next_pg;
+	do {
+		is_local = !ttransport->tcp_opts.numa_placement || numa_id < 0 ||
+			   tgroup->numa_id < 0 || tgroup->numa_id == numa_id;
+		is_overloaded = nvmf_tcp_poll_group_is_overloaded(ttransport, tgroup);
+		if (is_local && !is_overloaded) {
+			return tgroup;
+		}
+		if (is_local && local == NULL) {
+			local = tgroup;
+		}
+		if (!is_overloaded && idle == NULL) {
+			idle = tgroup;
+		}
+
+		tgroup = TAILQ_NEXT(tgroup, link);
+		if (tgroup == NULL) {
+			tgroup = TAILQ_FIRST(&ttransport->poll_groups);
+		}
+	} while (tgroup != ttransport->next_pg);
+
+	if (local != NULL) {
+		return local;
+	}
+
+	return idle != NULL ? idle : ttransport->next_pg;
+}
+
 static struct spdk_nvmf_transport_poll_group *
 nvmf_tcp_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 {
 	struct spdk_nvmf_tcp_transport *ttransport;
-	struct spdk_nvmf_tcp_poll_group **pg;
+	struct spdk_nvmf_tcp_poll_group *tgroup, *selected;
 	struct spdk_nvmf_tcp_qpair *tqpair;
-	struct spdk_sock_group *group = NULL, *hint = NULL;
+	struct spdk_sock_group *group = NULL;
 	int rc;
 
 	ttransport = SPDK_CONTAINEROF(qpair->transport, struct spdk_nvmf_tcp_transport, transport);
@@ -1504,26 +1779,30 @@ nvmf_tcp_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 		return NULL;
 	}
 
-	pg = &ttransport->next_pg;
-	assert(*pg != NULL);
-	hint = (*pg)->sock_group;
-
+	assert(ttransport->next_pg != NULL);
 	tqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_tcp_qpair, qpair);
-	rc = spdk_sock_get_optimal_sock_group(tqpair->sock, &group, hint);
+	selected = nvmf_tcp_select_poll_group(ttransport, tqpair->port ? tqpair->port->numa_id : -1);
+
+	rc = spdk_sock_get_optimal_sock_group(tqpair->sock, &group, selected->sock_group);
 	if (rc != 0) {
 		return NULL;
-	} else if (group != NULL) {
-		/* Optimal poll group was found */
-		return spdk_sock_group_get_ctx(group);
+	} else if (group != NULL && group != selected->sock_group) {
+		/* The sock layer assigned this placement_id to another poll group. Follow it
+		 * unless that group is overloaded. */
+		tgroup = SPDK_CONTAINEROF(spdk_sock_group_get_ctx(group), struct spdk_nvmf_tcp_poll_group,
+					  group);
+		if (!nvmf_tcp_poll_group_is_overloaded(ttransport, tgroup)) {
+			return &tgroup->group;
+		}
 	}
 
-	/* The hint was used for optimal poll group, advance next_pg. */
-	*pg = TAILQ_NEXT(*pg, link);
-	if (*pg == NULL) {
-		*pg = TAILQ_FIRST(&ttransport->poll_groups);
+	/* The selected poll group was used, continue the round-robin after it. */
+	ttransport->next_pg = TAILQ_NEXT(selected, link);
+	if (ttransport->next_pg == NULL) {
+		ttransport->next_pg = TAILQ_FIRST(&ttransport->poll_groups);
 	}
 
-	return spdk_sock_group_get_ctx(hint);
+	return &selected->group;
 }
 
 static void
@@ -1538,6 +1817,12 @@ nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 		nvmf_tcp_control_msg_list_free(tgroup->control_msg_list);
 	}
 
+	if (tgroup->icd_pool.in_use > 0) {
+		SPDK_ERRLOG("%u in-capsule data buffers of tgroup=%p are still in use\n",
+			    tgroup->icd_pool.in_use, tgroup);
+	}
+	spdk_free(tgroup->icd_pool.bufs);
+
 	if (tgroup->accel_channel) {
 		spdk_put_io_channel(tgroup->accel_channel);
 	}
@@ -2040,8 +2325,7 @@ nvmf_tcp_pdu_payload_handle(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_
 	SPDK_DEBUGLOG(nvmf_tcp, "enter\n");
 	/* check data digest if need */
 	if (pdu->ddgst_enable) {
-		if (tqpair->qpair.qid != 0 && !pdu->dif_ctx && tqpair->group &&
-		    (pdu->data_len % SPDK_NVME_TCP_DIGEST_ALIGNMENT == 0)) {
+		if (tqpair->qpair.qid != 0 && nvmf_tcp_pdu_use_accel_digest(tqpair, pdu)) {
 			rc = spdk_accel_submit_crc32cv(tqpair->group->accel_channel, &pdu->data_digest_crc32, pdu->data_iov,
 						       pdu->data_iovcnt, 0, data_crc32_calc_done, pdu);
 			if (spdk_likely(rc == 0)) {
@@ -2105,8 +2389,19 @@ nvmf_tcp_icreq_handle(struct spdk_nvmf_tcp_transport *ttransport,
 	}
 
 	tqpair->recv_buf_size = spdk_max(tqpair->recv_buf_size, MIN_SOCK_PIPE_SIZE);
+	if (ttransport->tcp_opts.zero_copy_recv) {
+		/* Without the receive pipe of the socket, the payload of the PDUs is read directly
+		 * into the buffers of the requests instead of being copied out of the pipe. */
+		if (spdk_sock_set_recvbuf(tqpair->sock, 0) == 0) {
+			tqpair->zero_copy_recv = true;
+		} else {
+			SPDK_WARNLOG("Unable to disable the receive buffer on tqpair=%p\n", tqpair);
+		}
+	}
+
 	/* Now that we know whether digests are enabled, properly size the receive buffer */
-	if (spdk_sock_set_recvbuf(tqpair->sock, tqpair->recv_buf_size) < 0) {
+	if (!tqpair->zero_copy_recv &&
+	    spdk_sock_set_recvbuf(tqpair->sock, tqpair->recv_buf_size) < 0) {
 		SPDK_WARNLOG("Unable to allocate enough memory for receive buffer on tqpair=%p with size=%d\n",
 			     tqpair,
 			     tqpair->recv_buf_size);
@@ -2289,7 +2584,7 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 	int rc = 0;
 	struct nvme_tcp_pdu *pdu;
 	enum nvme_tcp_pdu_recv_state prev_state;
-	uint32_t data_len;
+	uint32_t data_len, ch_len;
 	struct spdk_nvmf_tcp_transport *ttransport = SPDK_CONTAINEROF(tqpair->qpair.transport,
 			struct spdk_nvmf_tcp_transport, transport);
 
@@ -2320,8 +2615,11 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 				return rc;
 			}
 
-			rc = nvme_tcp_read_data(tqpair->sock,
-						sizeof(struct spdk_nvme_tcp_common_pdu_hdr) - pdu->ch_valid_bytes,
+			/* Without the receive pipe each read is a system call, so read the bytes that every
+			 * PDU header has at once.  That is the whole header of H2C data PDUs. */
+			ch_len = tqpair->zero_copy_recv ? NVMF_TCP_PDU_MIN_HLEN :
+				 sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+			rc = nvme_tcp_read_data(tqpair->sock, ch_len - pdu->ch_valid_bytes,
 						(void *)&pdu->hdr.common + pdu->ch_valid_bytes);
 			if (rc < 0) {
 				SPDK_DEBUGLOG(nvmf_tcp, "will disconnect tqpair=%p\n", tqpair);
@@ -2338,22 +2636,31 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 
 			/* The command header of this PDU has now been read from the socket. */
 			nvmf_tcp_pdu_ch_handle(tqpair);
+			if (pdu->ch_valid_bytes > sizeof(struct spdk_nvme_tcp_common_pdu_hdr)) {
+				/* The rest belongs to the PDU specific header, which is at least as long */
+				pdu->psh_valid_bytes = pdu->ch_valid_bytes - sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+				pdu->ch_valid_bytes = sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+				assert(tqpair->recv_state != NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH ||
+				       pdu->psh_valid_bytes <= pdu->psh_len);
+			}
 			break;
 		/* Wait for the pdu specific header  */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH:
-			rc = nvme_tcp_read_data(tqpair->sock,
-						pdu->psh_len - pdu->psh_valid_bytes,
-						(void *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
-			if (rc < 0) {
-				nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
-				break;
-			} else if (rc > 0) {
-				spdk_trace_record(TRACE_TCP_READ_FROM_SOCKET_DONE, tqpair->qpair.qid, rc, 0, tqpair);
-				pdu->psh_valid_bytes += rc;
-			}
-
 			if (pdu->psh_valid_bytes < pdu->psh_len) {
-				return NVME_TCP_PDU_IN_PROGRESS;
+				rc = nvme_tcp_read_data(tqpair->sock,
+							pdu->psh_len - pdu->psh_valid_bytes,
+							(void *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
+				if (rc < 0) {
+					nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
+					break;
+				} else if (rc > 0) {
+					spdk_trace_record(TRACE_TCP_READ_FROM_SOCKET_DONE, tqpair->qpair.qid, rc, 0, tqpair);
+					pdu->psh_valid_bytes += rc;
+				}
+
+				if (pdu->psh_valid_bytes < pdu->psh_len) {
+					return NVME_TCP_PDU_IN_PROGRESS;
+				}
 			}
 
 			/* All header(ch, psh, head digist) of this PDU has now been read from the socket. */
@@ -2446,6 +2753,50 @@ nvmf_tcp_control_msg_put(struct spdk_nvmf_tcp_control_msg_list *list, void *_msg
 	STAILQ_INSERT_HEAD(&list->free_msgs, msg, link);
 }
 
+static inline void *
+nvmf_tcp_icd_buf_get(struct spdk_nvmf_tcp_poll_group *tgroup, struct spdk_nvmf_tcp_qpair *tqpair,
+		     struct spdk_nvmf_tcp_req *tcp_req)
+{
+	struct spdk_nvmf_tcp_icd_pool *pool = &tgroup->icd_pool;
+	struct spdk_nvmf_tcp_icd_buf *buf;
+
+	buf = STAILQ_FIRST(&tqpair->icd_bufs);
+	if (buf) {
+		STAILQ_REMOVE_HEAD(&tqpair->icd_bufs, link);
+		return buf;
+	}
+
+	buf = STAILQ_FIRST(&pool->free_bufs);
+	if (!buf) {
+		SPDK_DEBUGLOG(nvmf_tcp, "Out of in-capsule data buffers in tgroup=%p\n", tgroup);
+		return NULL;
+	}
+	STAILQ_REMOVE_HEAD(&pool->free_bufs, link);
+	tcp_req->icd_buf_borrowed = true;
+	pool->in_use++;
+	pool->max_in_use = spdk_max(pool->max_in_use, pool->in_use);
+
+	return buf;
+}
+
+static inline void
+nvmf_tcp_icd_buf_put(struct spdk_nvmf_tcp_poll_group *tgroup, struct spdk_nvmf_tcp_qpair *tqpair,
+		     struct spdk_nvmf_tcp_req *tcp_req)
+{
+	struct spdk_nvmf_tcp_icd_buf *buf = (struct spdk_nvmf_tcp_icd_buf *)tcp_req->buf;
+
+	/* Borrowed buffers go back to the pool right away, so that other qpairs can use them */
+	if (tcp_req->icd_buf_borrowed) {
+		assert(tgroup->icd_pool.in_use > 0);
+		STAILQ_INSERT_HEAD(&tgroup->icd_pool.free_bufs, buf, link);
+		tgroup->icd_pool.in_use--;
+		tcp_req->icd_buf_borrowed = false;
+	} else {
+		STAILQ_INSERT_HEAD(&tqpair->icd_bufs, buf, link);
+	}
+	tcp_req->buf = NULL;
+}
+
 static int
 nvmf_tcp_req_parse_sgl(struct spdk_nvmf_tcp_req *tcp_req,
 		       struct spdk_nvmf_transport *transport,
@@ -2559,6 +2910,15 @@ nvmf_tcp_req_parse_sgl(struct spdk_nvmf_tcp_req *tcp_req,
 				goto fatal_err;
 			}
 		} else {
+			if (tqpair->shared_icd) {
+				tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
+				tcp_req->buf = nvmf_tcp_icd_buf_get(tgroup, tqpair, tcp_req);
+				if (!tcp_req->buf) {
+					/* No available buffers. Queue this request up. */
+					SPDK_DEBUGLOG(nvmf_tcp, "No available ICD buffers. Queueing request %p\n", tcp_req);
+					return 0;
+				}
+			}
 			req->iov[0].iov_base = tcp_req->buf;
 		}
 
@@ -3140,6 +3500,9 @@ nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 				SPDK_DEBUGLOG(nvmf_tcp, "Put buf to control msg list\n");
 				nvmf_tcp_control_msg_put(tgroup->control_msg_list,
 							 tcp_req->req.iov[0].iov_base);
+			} else if (tqpair->shared_icd && tcp_req->buf != NULL) {
+				tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
+				nvmf_tcp_icd_buf_put(tgroup, tqpair, tcp_req);
 			} else if (tcp_req->req.zcopy_bdev_io != NULL) {
 				/* If the request has an unreleased zcopy bdev_io, it's either a
 				 * read, a failed write, or the qpair is being disconnected */
@@ -3221,7 +3584,7 @@ nvmf_tcp_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 		return -1;
 	}
 
-	rc = nvmf_tcp_qpair_init_mem_resource(tqpair);
+	rc = nvmf_tcp_qpair_init_mem_resource(tqpair, tgroup);
 	if (rc < 0) {
 		SPDK_ERRLOG("Cannot init memory resource info for tqpair=%p\n", tqpair);
 		return -1;
@@ -3319,6 +3682,26 @@ nvmf_tcp_close_qpair(struct spdk_nvmf_qpair *qpair,
 	nvmf_tcp_qpair_destroy(tqpair);
 }
 
+static inline void
+nvmf_tcp_poll_group_update_load(struct spdk_nvmf_tcp_poll_group *tgroup, bool busy)
+{
+	uint64_t now;
+
+	tgroup->load_polls++;
+	tgroup->load_busy_polls += busy;
+
+	now = spdk_get_ticks();
+	if (now - tgroup->load_tsc <
+	    spdk_get_ticks_hz() * NVMF_TCP_POLL_GROUP_LOAD_PERIOD_US / SPDK_SEC_TO_USEC) {
+		return;
+	}
+
+	tgroup->load = tgroup->load_busy_polls * 100 / tgroup->load_polls;
+	tgroup->load_polls = 0;
+	tgroup->load_busy_polls = 0;
+	tgroup->load_tsc = now;
+}
+
 static int
 nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 {
@@ -3333,6 +3716,7 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
 
 	if (spdk_unlikely(TAILQ_EMPTY(&tgroup->qpairs) && TAILQ_EMPTY(&tgroup->await_req))) {
+		tgroup->load = 0;
 		return 0;
 	}
 
@@ -3347,6 +3731,7 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 	if (rc < 0) {
 		SPDK_ERRLOG("Failed to poll sock_group=%p\n", tgroup->sock_group);
 	}
+	nvmf_tcp_poll_group_update_load(tgroup, rc > 0);
 
 	TAILQ_FOREACH_SAFE(tqpair, &tgroup->await_req, link, tqpair_tmp) {
 		rc = nvmf_tcp_sock_process(tqpair);
@@ -3775,6 +4160,32 @@ nvmf_tcp_opts_init(struct spdk_nvmf_transport_opts *opts)
 	opts->transport_specific =      NULL;
 }
 
+static void
+nvmf_tcp_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group,
+			      struct spdk_json_write_ctx *w)
+{
+	struct spdk_nvmf_tcp_poll_group *tgroup;
+	struct spdk_sock_group_stats stats;
+
+	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
+	spdk_sock_group_get_stats(tgroup->sock_group, &stats);
+
+	spdk_json_write_named_uint64(w, "send_calls", stats.send_calls);
+	spdk_json_write_named_uint64(w, "bytes_sent", stats.bytes_sent);
+	spdk_json_write_named_uint64(w, "bytes_per_send_call",
+				     stats.send_calls ? stats.bytes_sent / stats.send_calls : 0);
+	spdk_json_write_named_uint64(w, "zcopy_notifications", stats.zcopy_notifications);
+	spdk_json_write_named_uint64(w, "zcopy_completed_reqs", stats.zcopy_completed_reqs);
+	spdk_json_write_named_uint64(w, "ktls_bytes_sent", stats.ktls_bytes_sent);
+	spdk_json_write_named_uint64(w, "ktls_bytes_received", stats.ktls_bytes_received);
+
+	if (tgroup->icd_pool.num_bufs > 0) {
+		spdk_json_write_named_uint32(w, "icd_pool_bufs", tgroup->icd_pool.num_bufs);
+		spdk_json_write_named_uint32(w, "icd_pool_in_use", tgroup->icd_pool.in_use);
+		spdk_json_write_named_uint32(w, "icd_pool_max_in_use", tgroup->icd_pool.max_in_use);
+	}
+}
+
 const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp = {
 	.name = "TCP",
 	.type = SPDK_NVME_TRANSPORT_TCP,
@@ -3794,6 +4205,7 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp = {
 	.poll_group_add = nvmf_tcp_poll_group_add,
 	.poll_group_remove = nvmf_tcp_poll_group_remove,
 	.poll_group_poll = nvmf_tcp_poll_group_poll,
+	.poll_group_dump_stat = nvmf_tcp_poll_group_dump_stat,
 
 	.req_free = nvmf_tcp_req_free,
 	.req_complete = nvmf_tcp_req_complete,
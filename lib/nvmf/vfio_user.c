@@ -348,6 +348,10 @@ struct nvmf_vfio_user_cq {
 
 	uint32_t				last_head;
 	uint32_t				last_trigger_irq_tail;
+
+	/* Completions posted since the last interrupt when interrupts are coalesced */
+	uint32_t				irq_pending;
+	uint64_t				irq_pending_tsc;
 };
 
 struct nvmf_vfio_user_poll_group {
@@ -356,6 +360,8 @@ struct nvmf_vfio_user_poll_group {
 	TAILQ_HEAD(, nvmf_vfio_user_sq)		sqs;
 	struct spdk_interrupt			*intr;
 	int					intr_fd;
+	/* Triggers the coalesced interrupts of the CQs, paused while none are pending */
+	struct spdk_poller			*irq_poller;
 	struct {
 
 		/*
@@ -409,6 +415,13 @@ struct nvmf_vfio_user_poll_group {
 		uint64_t poll_reqs_squared;
 		uint64_t cqh_admin_writes;
 		uint64_t cqh_io_writes;
+
+		/*
+		 * Completions posted to I/O CQs with coalesced interrupts, and
+		 * the number of interrupts actually triggered for them.
+		 */
+		uint64_t irq_coalesced_cpls;
+		uint64_t irq_coalesced_triggers;
 	} stats;
 };
 
@@ -516,6 +529,8 @@ struct nvmf_vfio_user_transport_opts {
 	bool					disable_shadow_doorbells;
 	bool					disable_compare;
 	bool					enable_intr_mode_sq_spreading;
+	uint32_t				irq_coalescing_threshold;
+	uint32_t				irq_coalescing_time_us;
 };
 
 struct nvmf_vfio_user_transport {
@@ -1237,6 +1252,16 @@ static const struct spdk_json_object_decoder vfio_user_transport_opts_decoder[]
 		offsetof(struct nvmf_vfio_user_transport, transport_opts.enable_intr_mode_sq_spreading),
 		spdk_json_decode_bool, true
 	},
+	{
+		"irq_coalescing_threshold",
+		offsetof(struct nvmf_vfio_user_transport, transport_opts.irq_coalescing_threshold),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"irq_coalescing_time_us",
+		offsetof(struct nvmf_vfio_user_transport, transport_opts.irq_coalescing_time_us),
+		spdk_json_decode_uint32, true
+	},
 };
 
 static struct spdk_nvmf_transport *
@@ -1317,6 +1342,10 @@ nvmf_vfio_user_create(struct spdk_nvmf_transport_opts *opts)
 		      vu_transport->transport_opts.disable_adaptive_irq);
 	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: disable_shadow_doorbells=%d\n",
 		      vu_transport->transport_opts.disable_shadow_doorbells);
+	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: irq_coalescing_threshold=%u\n",
+		      vu_transport->transport_opts.irq_coalescing_threshold);
+	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: irq_coalescing_time_us=%u\n",
+		      vu_transport->transport_opts.irq_coalescing_time_us);
 
 	return &vu_transport->transport;
 
@@ -1728,6 +1757,56 @@ cq_is_full(struct nvmf_vfio_user_cq *cq)
 	return free_cq_slots == 0;
 }
 
+static inline struct nvmf_vfio_user_poll_group *
+cq_to_poll_group(struct nvmf_vfio_user_cq *cq)
+{
+	return SPDK_CONTAINEROF(cq->group, struct nvmf_vfio_user_poll_group, group);
+}
+
+static int
+cq_trigger_coalesced_irq(struct nvmf_vfio_user_ctrlr *ctrlr, struct nvmf_vfio_user_cq *cq)
+{
+	int err;
+
+	cq->irq_pending = 0;
+	cq_to_poll_group(cq)->stats.irq_coalesced_triggers++;
+
+	err = vfu_irq_trigger(ctrlr->endpoint->vfu_ctx, cq->iv);
+	if (err != 0) {
+		SPDK_ERRLOG("%s: failed to trigger interrupt: %m\n",
+			    ctrlr_id(ctrlr));
+	}
+
+	return err;
+}
+
+/*
+ * Instead of sending an IRQ for every completion on an I/O CQ, send one once
+ * irq_coalescing_threshold completions are pending, or when the oldest pending
+ * completion is irq_coalescing_time_us old (see vfio_user_poll_group_irq()).
+ */
+static int
+cq_coalesce_irq(struct nvmf_vfio_user_ctrlr *ctrlr, struct nvmf_vfio_user_cq *cq)
+{
+	struct nvmf_vfio_user_poll_group *vu_group = cq_to_poll_group(cq);
+	uint32_t threshold = ctrlr->transport->transport_opts.irq_coalescing_threshold;
+
+	assert(spdk_get_thread() == cq->group->group->thread);
+
+	vu_group->stats.irq_coalesced_cpls++;
+
+	if (cq->irq_pending++ == 0) {
+		cq->irq_pending_tsc = spdk_get_ticks();
+		spdk_poller_resume(vu_group->irq_poller);
+	}
+
+	if (threshold != 0 && cq->irq_pending >= threshold) {
+		return cq_trigger_coalesced_irq(ctrlr, cq);
+	}
+
+	return 0;
+}
+
 /*
  * Posts a CQE in the completion queue.
  *
@@ -1802,6 +1881,10 @@ post_completion(struct nvmf_vfio_user_ctrlr *ctrlr, struct nvmf_vfio_user_cq *cq
 
 	if ((cq->qid == 0 || !ctrlr->adaptive_irqs_enabled) &&
 	    cq->ien && ctrlr_interrupt_enabled(ctrlr)) {
+		if (cq->qid != 0 && ctrlr->transport->transport_opts.irq_coalescing_time_us != 0) {
+			return cq_coalesce_irq(ctrlr, cq);
+		}
+
 		err = vfu_irq_trigger(ctrlr->endpoint->vfu_ctx, cq->iv);
 		if (err != 0) {
 			SPDK_ERRLOG("%s: failed to trigger interrupt: %m\n",
@@ -1831,6 +1914,7 @@ delete_cq_done(struct nvmf_vfio_user_ctrlr *ctrlr, struct nvmf_vfio_user_cq *cq)
 	cq->size = 0;
 	cq->cq_state = VFIO_USER_CQ_DELETED;
 	cq->group = NULL;
+	cq->irq_pending = 0;
 }
 
 /* Deletes a SQ, if this SQ is the last user of the associated CQ
@@ -4713,6 +4797,64 @@ vfio_user_poll_group_add_intr(struct nvmf_vfio_user_poll_group *vu_group,
 				       vu_group);
 }
 
+/*
+ * Send the coalesced IRQs whose oldest completion has waited for at least
+ * irq_coalescing_time_us. CQs sharing a vector are covered by the same IRQ.
+ */
+static int
+vfio_user_poll_group_irq(void *ctx)
+{
+	struct nvmf_vfio_user_poll_group *vu_group = ctx;
+	struct nvmf_vfio_user_transport *vu_transport;
+	struct nvmf_vfio_user_ctrlr *ctrlr;
+	struct nvmf_vfio_user_sq *sq, *other_sq;
+	struct nvmf_vfio_user_cq *cq, *other_cq;
+	uint64_t now, time_ticks;
+	bool pending = false;
+	int count = 0;
+
+	vu_transport = SPDK_CONTAINEROF(vu_group->group.transport, struct nvmf_vfio_user_transport,
+					transport);
+	time_ticks = vu_transport->transport_opts.irq_coalescing_time_us * spdk_get_ticks_hz() /
+		     SPDK_SEC_TO_USEC;
+	now = spdk_get_ticks();
+
+	TAILQ_FOREACH(sq, &vu_group->sqs, link) {
+		ctrlr = sq->ctrlr;
+		cq = ctrlr->cqs[sq->cqid];
+		if (cq == NULL || cq->group != &vu_group->group || cq->irq_pending == 0) {
+			continue;
+		}
+
+		if (now - cq->irq_pending_tsc < time_ticks) {
+			pending = true;
+			continue;
+		}
+
+		if (ctrlr_interrupt_enabled(ctrlr)) {
+			cq_trigger_coalesced_irq(ctrlr, cq);
+			count++;
+		}
+		cq->irq_pending = 0;
+
+		TAILQ_FOREACH(other_sq, &vu_group->sqs, link) {
+			if (other_sq->ctrlr != ctrlr) {
+				continue;
+			}
+			other_cq = ctrlr->cqs[other_sq->cqid];
+			if (other_cq != NULL && other_cq->iv == cq->iv) {
+				other_cq->irq_pending = 0;
+			}
+		}
+	}
+
+	if (!pending) {
+		spdk_poller_pause(vu_group->irq_poller);
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static struct spdk_nvmf_transport_poll_group *
 nvmf_vfio_user_poll_group_create(struct spdk_nvmf_transport *transport,
 				 struct spdk_nvmf_poll_group *group)
@@ -4737,6 +4879,12 @@ nvmf_vfio_user_poll_group_create(struct spdk_nvmf_transport *transport,
 
 	TAILQ_INIT(&vu_group->sqs);
 
+	if (vu_transport->transport_opts.irq_coalescing_time_us != 0) {
+		vu_group->irq_poller = SPDK_POLLER_REGISTER(vfio_user_poll_group_irq, vu_group,
+				       vu_transport->transport_opts.irq_coalescing_time_us);
+		spdk_poller_pause(vu_group->irq_poller);
+	}
+
 	pthread_mutex_lock(&vu_transport->pg_lock);
 	TAILQ_INSERT_TAIL(&vu_transport->poll_groups, vu_group, link);
 	if (vu_transport->next_pg == NULL) {
@@ -4838,6 +4986,8 @@ nvmf_vfio_user_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 		vfio_user_poll_group_del_intr(vu_group);
 	}
 
+	spdk_poller_unregister(&vu_group->irq_poller);
+
 	pthread_mutex_lock(&vu_transport->pg_lock);
 	next_tgroup = TAILQ_NEXT(vu_group, link);
 	TAILQ_REMOVE(&vu_transport->poll_groups, vu_group, link);
@@ -5845,6 +5995,9 @@ nvmf_vfio_user_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group
 
 	spdk_json_write_named_uint64(w, "cqh_admin_writes", vu_group->stats.cqh_admin_writes);
 	spdk_json_write_named_uint64(w, "cqh_io_writes", vu_group->stats.cqh_io_writes);
+	spdk_json_write_named_uint64(w, "irq_coalesced_cpls", vu_group->stats.irq_coalesced_cpls);
+	spdk_json_write_named_uint64(w, "irq_coalesced_triggers",
+				     vu_group->stats.irq_coalesced_triggers);
 }
 
 static void
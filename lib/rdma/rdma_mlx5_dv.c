@@ -249,7 +249,8 @@ spdk_rdma_qp_queue_send_wrs(struct spdk_rdma_qp *spdk_rdma_qp, struct ibv_send_w
 
 	for (tmp = first; tmp != NULL; tmp = tmp->next) {
 		mlx5_qp->qpex->wr_id = tmp->wr_id;
-		mlx5_qp->qpex->wr_flags = tmp->send_flags;
+		/* The WR API doesn't take IBV_SEND_INLINE, inline data is set explicitly below */
+		mlx5_qp->qpex->wr_flags = tmp->send_flags & ~IBV_SEND_INLINE;
 
 		switch (tmp->opcode) {
 		case IBV_WR_SEND:
@@ -269,7 +270,11 @@ spdk_rdma_qp_queue_send_wrs(struct spdk_rdma_qp *spdk_rdma_qp, struct ibv_send_w
 			assert(0);
 		}
 
-		ibv_wr_set_sge_list(mlx5_qp->qpex, tmp->num_sge, tmp->sg_list);
+		if ((tmp->send_flags & IBV_SEND_INLINE) && tmp->num_sge == 1) {
+			ibv_wr_set_inline_data(mlx5_qp->qpex, (void *)tmp->sg_list[0].addr, tmp->sg_list[0].length);
+		} else {
+			ibv_wr_set_sge_list(mlx5_qp->qpex, tmp->num_sge, tmp->sg_list);
+		}
 
 		spdk_rdma_qp->send_wrs.last = tmp;
 		spdk_rdma_qp->stats->send.num_submitted_wrs++;
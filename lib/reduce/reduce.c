@@ -26,14 +26,23 @@
 
 #define REDUCE_NUM_VOL_REQUESTS	256
 
+/* Number of recently written chunks kept decompressed, so that partial writes to the same chunks
+ *  can skip reading and decompressing them.
+ */
+#define REDUCE_NUM_CACHED_CHUNKS	8
+
 /* Structure written to offset 0 of both the pm file and the backing device. */
 struct spdk_reduce_vol_superblock {
 	uint8_t				signature[8];
 	struct spdk_reduce_vol_params	params;
-	uint8_t				reserved[4048];
+	uint32_t			flags;
+	uint8_t				reserved[4044];
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_reduce_vol_superblock) == 4096, "size incorrect");
 
+/* Metadata is stored at the end of the backing device instead of in a persistent memory file. */
+#define REDUCE_SUPER_FLAG_MD_ON_BACKING_DEV	(1u << 0)
+
 #define SPDK_REDUCE_SIGNATURE "SPDKREDU"
 /* null terminator counts one */
 SPDK_STATIC_ASSERT(sizeof(SPDK_REDUCE_SIGNATURE) - 1 ==
@@ -43,6 +52,9 @@ SPDK_STATIC_ASSERT(sizeof(SPDK_REDUCE_SIGNATURE) - 1 ==
 
 #define REDUCE_ZERO_BUF_SIZE 0x100000
 
+/* Maximum size of a single backing device I/O used to initialize or load the metadata. */
+#define REDUCE_MD_IO_SIZE	0x100000
+
 /**
  * Describes a persistent memory file used to hold metadata associated with a
  *  compressed volume.
@@ -63,6 +75,8 @@ struct spdk_reduce_chunk_map {
 	uint64_t		io_unit_index[0];
 };
 
+typedef void (*reduce_request_fn)(void *_req, int reduce_errno);
+
 struct spdk_reduce_vol_request {
 	/**
 	 *  Scratch buffer used for uncompressed chunk.  This is used for:
@@ -105,11 +119,28 @@ struct spdk_reduce_vol_request {
 	uint64_t				logical_map_index;
 	uint64_t				length;
 	uint64_t				chunk_map_index;
+	uint64_t				old_chunk_map_index;
 	struct spdk_reduce_chunk_map		*chunk;
 	spdk_reduce_vol_op_complete		cb_fn;
 	void					*cb_arg;
 	TAILQ_ENTRY(spdk_reduce_vol_request)	tailq;
 	struct spdk_reduce_vol_cb_args		backing_cb_args;
+	/* Called once the metadata updated by this request is written to the backing device */
+	reduce_request_fn			md_cb_fn;
+	TAILQ_ENTRY(spdk_reduce_vol_request)	md_tailq;
+};
+
+/* Write of a range of metadata blocks, issued by a metadata flush */
+struct reduce_md_write {
+	uint64_t				block;
+	uint32_t				num_blocks;
+	struct iovec				iov;
+};
+
+struct reduce_cached_chunk {
+	uint64_t				logical_map_index;
+	uint8_t					*buf;
+	TAILQ_ENTRY(reduce_cached_chunk)	tailq;
 };
 
 struct spdk_reduce_vol {
@@ -135,6 +166,29 @@ struct spdk_reduce_vol {
 	/* Single contiguous buffer used for all request buffers for this volume. */
 	uint8_t					*buf_mem;
 	struct iovec				*buf_iov_mem;
+
+	/* Most recently used chunks are kept at the head of the list. */
+	struct reduce_cached_chunk		*cached_chunk_mem;
+	uint8_t					*cached_chunk_buf_mem;
+	TAILQ_HEAD(reduce_cached_chunk_head, reduce_cached_chunk)	cached_chunks;
+
+	/* When the metadata is on the backing device, pm_file.pm_buf holds a copy of it in DRAM,
+	 *  located at md_offset (in backing device blocks).  Updates mark the blocks they modify
+	 *  as dirty and are batched, so that all the updates made while a flush is in progress are
+	 *  written by the next one.
+	 */
+	bool					md_on_backing_dev;
+	uint64_t				md_offset;
+	struct spdk_bit_array			*md_dirty_blocks;
+	uint64_t				*md_next_blocks;
+	uint64_t				*md_flush_blocks;
+	uint32_t				md_num_next_blocks;
+	struct reduce_md_write			*md_writes;
+	uint32_t				md_flush_outstanding;
+	int					md_flush_errno;
+	struct spdk_reduce_vol_cb_args		md_flush_cb_args;
+	TAILQ_HEAD(, spdk_reduce_vol_request)	md_pending_requests;
+	TAILQ_HEAD(, spdk_reduce_vol_request)	md_flushing_requests;
 };
 
 static void _start_readv_request(struct spdk_reduce_vol_request *req);
@@ -273,6 +327,22 @@ _get_pm_file_size(struct spdk_reduce_vol_params *params)
 	return total_pm_size;
 }
 
+/* Size of the metadata when it's stored on the backing device - same layout as the pm file. */
+static uint64_t
+_get_md_size(struct spdk_reduce_vol_params *params, uint32_t blocklen)
+{
+	return spdk_divide_round_up(_get_pm_file_size(params), blocklen) * blocklen;
+}
+
+/* The metadata on the backing device immediately follows the last chunk. */
+static uint64_t
+_get_md_offset(struct spdk_reduce_vol_params *params, uint32_t blocklen)
+{
+	uint64_t num_chunks = _get_total_chunks(params->vol_size, params->chunk_size);
+
+	return num_chunks * params->chunk_size / blocklen;
+}
+
 const struct spdk_uuid *
 spdk_reduce_vol_get_uuid(struct spdk_reduce_vol *vol)
 {
@@ -305,6 +375,9 @@ struct reduce_init_load_ctx {
 	void					*cb_arg;
 	struct iovec				iov[LOAD_IOV_COUNT];
 	void					*path;
+	uint64_t				md_io_offset;
+	bool					md_io_is_write;
+	spdk_reduce_vol_op_complete		md_io_cb_fn;
 };
 
 static inline bool
@@ -347,6 +420,39 @@ _set_buffer(uint8_t **vol_buffer, uint8_t **_addr, uint8_t *addr_range, size_t b
 	return 0;
 }
 
+static void
+_free_cached_chunks(struct spdk_reduce_vol *vol)
+{
+	free(vol->cached_chunk_mem);
+	free(vol->cached_chunk_buf_mem);
+	vol->cached_chunk_mem = NULL;
+	vol->cached_chunk_buf_mem = NULL;
+}
+
+static int
+_allocate_cached_chunks(struct spdk_reduce_vol *vol)
+{
+	struct reduce_cached_chunk *entry;
+	int i;
+
+	vol->cached_chunk_mem = calloc(REDUCE_NUM_CACHED_CHUNKS, sizeof(*entry));
+	vol->cached_chunk_buf_mem = calloc(REDUCE_NUM_CACHED_CHUNKS, vol->params.chunk_size);
+	if (vol->cached_chunk_mem == NULL || vol->cached_chunk_buf_mem == NULL) {
+		_free_cached_chunks(vol);
+		return -ENOMEM;
+	}
+
+	TAILQ_INIT(&vol->cached_chunks);
+	for (i = 0; i < REDUCE_NUM_CACHED_CHUNKS; i++) {
+		entry = &vol->cached_chunk_mem[i];
+		entry->logical_map_index = REDUCE_EMPTY_MAP_ENTRY;
+		entry->buf = &vol->cached_chunk_buf_mem[i * vol->params.chunk_size];
+		TAILQ_INSERT_TAIL(&vol->cached_chunks, entry, tailq);
+	}
+
+	return 0;
+}
+
 static int
 _allocate_vol_requests(struct spdk_reduce_vol *vol)
 {
@@ -392,6 +498,17 @@ _allocate_vol_requests(struct spdk_reduce_vol *vol)
 		return -ENOMEM;
 	}
 
+	rc = _allocate_cached_chunks(vol);
+	if (rc != 0) {
+		free(vol->buf_iov_mem);
+		free(vol->request_mem);
+		spdk_free(vol->buf_mem);
+		vol->buf_iov_mem = NULL;
+		vol->request_mem = NULL;
+		vol->buf_mem = NULL;
+		return rc;
+	}
+
 	buffer = vol->buf_mem;
 	buffer_end = buffer + VALUE_2MB * huge_pages_needed;
 
@@ -416,6 +533,7 @@ _allocate_vol_requests(struct spdk_reduce_vol *vol)
 	}
 
 	if (rc) {
+		_free_cached_chunks(vol);
 		free(vol->buf_iov_mem);
 		free(vol->request_mem);
 		spdk_free(vol->buf_mem);
@@ -436,7 +554,13 @@ _init_load_cleanup(struct spdk_reduce_vol *vol, struct reduce_init_load_ctx *ctx
 	}
 
 	if (vol != NULL) {
-		if (vol->pm_file.pm_buf != NULL) {
+		if (vol->md_on_backing_dev) {
+			spdk_free(vol->pm_file.pm_buf);
+			spdk_bit_array_free(&vol->md_dirty_blocks);
+			free(vol->md_next_blocks);
+			free(vol->md_flush_blocks);
+			free(vol->md_writes);
+		} else if (vol->pm_file.pm_buf != NULL) {
 			pmem_unmap(vol->pm_file.pm_buf, vol->pm_file.size);
 		}
 
@@ -446,6 +570,7 @@ _init_load_cleanup(struct spdk_reduce_vol *vol, struct reduce_init_load_ctx *ctx
 		free(vol->request_mem);
 		free(vol->buf_iov_mem);
 		spdk_free(vol->buf_mem);
+		_free_cached_chunks(vol);
 		free(vol);
 	}
 }
@@ -470,6 +595,81 @@ _alloc_zero_buff(void)
 	return rc;
 }
 
+static int
+_allocate_md_buf(struct spdk_reduce_vol *vol)
+{
+	uint32_t blocklen = vol->backing_dev->blocklen;
+	uint32_t max_blocks;
+
+	vol->md_on_backing_dev = true;
+	vol->md_offset = _get_md_offset(&vol->params, blocklen);
+	vol->pm_file.size = _get_md_size(&vol->params, blocklen);
+	TAILQ_INIT(&vol->md_pending_requests);
+	TAILQ_INIT(&vol->md_flushing_requests);
+
+	vol->pm_file.pm_buf = spdk_zmalloc(vol->pm_file.size, 0x1000, NULL,
+					   SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (vol->pm_file.pm_buf == NULL) {
+		return -ENOMEM;
+	}
+
+	/* A single update modifies at most the blocks spanned by one chunk map, and each request
+	 *  has at most one update waiting to be flushed.
+	 */
+	max_blocks = _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk) / blocklen;
+	max_blocks = (max_blocks + 2) * REDUCE_NUM_VOL_REQUESTS;
+	vol->md_dirty_blocks = spdk_bit_array_create(vol->pm_file.size / blocklen);
+	vol->md_next_blocks = calloc(max_blocks, sizeof(*vol->md_next_blocks));
+	vol->md_flush_blocks = calloc(max_blocks, sizeof(*vol->md_flush_blocks));
+	vol->md_writes = calloc(max_blocks, sizeof(*vol->md_writes));
+	if (vol->md_dirty_blocks == NULL || vol->md_next_blocks == NULL ||
+	    vol->md_flush_blocks == NULL || vol->md_writes == NULL) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/* Transfer the whole metadata between its DRAM copy and the backing device */
+static void
+_init_load_md_io_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *ctx = cb_arg;
+	struct spdk_reduce_vol *vol = ctx->vol;
+	uint32_t blocklen = vol->backing_dev->blocklen;
+	uint64_t lba, len;
+
+	if (reduce_errno != 0 || ctx->md_io_offset == vol->pm_file.size) {
+		ctx->md_io_cb_fn(ctx, reduce_errno);
+		return;
+	}
+
+	len = spdk_min(vol->pm_file.size - ctx->md_io_offset, REDUCE_MD_IO_SIZE);
+	lba = vol->md_offset + ctx->md_io_offset / blocklen;
+	ctx->iov[0].iov_base = (uint8_t *)vol->pm_file.pm_buf + ctx->md_io_offset;
+	ctx->iov[0].iov_len = len;
+	ctx->md_io_offset += len;
+	ctx->backing_cb_args.cb_fn = _init_load_md_io_cpl;
+	ctx->backing_cb_args.cb_arg = ctx;
+	if (ctx->md_io_is_write) {
+		vol->backing_dev->writev(vol->backing_dev, ctx->iov, 1, lba, len / blocklen,
+					 &ctx->backing_cb_args);
+	} else {
+		vol->backing_dev->readv(vol->backing_dev, ctx->iov, 1, lba, len / blocklen,
+					&ctx->backing_cb_args);
+	}
+}
+
+static void
+_init_load_md_io(struct reduce_init_load_ctx *ctx, bool is_write,
+		 spdk_reduce_vol_op_complete cb_fn)
+{
+	ctx->md_io_offset = 0;
+	ctx->md_io_is_write = is_write;
+	ctx->md_io_cb_fn = cb_fn;
+	_init_load_md_io_cpl(ctx, 0);
+}
+
 static void
 _init_write_super_cpl(void *cb_arg, int reduce_errno)
 {
@@ -512,11 +712,46 @@ _init_write_path_cpl(void *cb_arg, int reduce_errno)
 				 &init_ctx->backing_cb_args);
 }
 
+static void
+_init_write_path(struct reduce_init_load_ctx *init_ctx)
+{
+	struct spdk_reduce_vol *vol = init_ctx->vol;
+
+	memcpy(init_ctx->path, vol->pm_file.path, REDUCE_PATH_MAX);
+	init_ctx->iov[0].iov_base = init_ctx->path;
+	init_ctx->iov[0].iov_len = REDUCE_PATH_MAX;
+	init_ctx->backing_cb_args.cb_fn = _init_write_path_cpl;
+	init_ctx->backing_cb_args.cb_arg = init_ctx;
+	/* Write path to offset 4K on backing device - just after where the super
+	 *  block will be written.  We wait until this is committed before writing the
+	 *  super block to guarantee we don't get the super block written without the
+	 *  the path if the system crashed in the middle of a write operation.
+	 */
+	vol->backing_dev->writev(vol->backing_dev, init_ctx->iov, 1,
+				 REDUCE_BACKING_DEV_PATH_OFFSET / vol->backing_dev->blocklen,
+				 REDUCE_PATH_MAX / vol->backing_dev->blocklen,
+				 &init_ctx->backing_cb_args);
+}
+
+static void
+_init_write_md_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *init_ctx = cb_arg;
+
+	if (reduce_errno != 0) {
+		init_ctx->cb_fn(init_ctx->cb_arg, NULL, reduce_errno);
+		_init_load_cleanup(init_ctx->vol, init_ctx);
+		return;
+	}
+
+	_init_write_path(init_ctx);
+}
+
 static int
 _allocate_bit_arrays(struct spdk_reduce_vol *vol)
 {
 	uint64_t total_chunks, total_backing_io_units;
-	uint32_t i, num_metadata_io_units;
+	uint32_t num_metadata_io_units;
 
 	total_chunks = _get_total_chunks(vol->params.vol_size, vol->params.chunk_size);
 	vol->allocated_chunk_maps = spdk_bit_array_create(total_chunks);
@@ -530,9 +765,7 @@ _allocate_bit_arrays(struct spdk_reduce_vol *vol)
 	/* Set backing io unit bits associated with metadata. */
 	num_metadata_io_units = (sizeof(*vol->backing_super) + REDUCE_PATH_MAX) /
 				vol->backing_dev->blocklen;
-	for (i = 0; i < num_metadata_io_units; i++) {
-		spdk_bit_array_set(vol->allocated_backing_io_units, i);
-	}
+	spdk_bit_array_set_range(vol->allocated_backing_io_units, 0, num_metadata_io_units);
 
 	return 0;
 }
@@ -545,25 +778,27 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 {
 	struct spdk_reduce_vol *vol;
 	struct reduce_init_load_ctx *init_ctx;
-	uint64_t backing_dev_size;
+	uint64_t backing_dev_size, md_size;
 	size_t mapped_len;
-	int dir_len, max_dir_len, rc;
+	int dir_len = 0, max_dir_len, rc;
 
-	/* We need to append a path separator and the UUID to the supplied
-	 * path.
-	 */
-	max_dir_len = REDUCE_PATH_MAX - SPDK_UUID_STRING_LEN - 1;
-	dir_len = strnlen(pm_file_dir, max_dir_len);
-	/* Strip trailing slash if the user provided one - we will add it back
-	 * later when appending the filename.
-	 */
-	if (pm_file_dir[dir_len - 1] == '/') {
-		dir_len--;
-	}
-	if (dir_len == max_dir_len) {
-		SPDK_ERRLOG("pm_file_dir (%s) too long\n", pm_file_dir);
-		cb_fn(cb_arg, NULL, -EINVAL);
-		return;
+	if (pm_file_dir != NULL) {
+		/* We need to append a path separator and the UUID to the supplied
+		 * path.
+		 */
+		max_dir_len = REDUCE_PATH_MAX - SPDK_UUID_STRING_LEN - 1;
+		dir_len = strnlen(pm_file_dir, max_dir_len);
+		/* Strip trailing slash if the user provided one - we will add it back
+		 * later when appending the filename.
+		 */
+		if (pm_file_dir[dir_len - 1] == '/') {
+			dir_len--;
+		}
+		if (dir_len == max_dir_len) {
+			SPDK_ERRLOG("pm_file_dir (%s) too long\n", pm_file_dir);
+			cb_fn(cb_arg, NULL, -EINVAL);
+			return;
+		}
 	}
 
 	rc = _validate_vol_params(params);
@@ -575,6 +810,12 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 
 	backing_dev_size = backing_dev->blockcnt * backing_dev->blocklen;
 	params->vol_size = _get_vol_size(params->chunk_size, backing_dev_size);
+	if (pm_file_dir == NULL && params->vol_size != 0) {
+		/* Leave room for the metadata at the end of the backing device. */
+		md_size = _get_md_size(params, backing_dev->blocklen);
+		params->vol_size = md_size < backing_dev_size ?
+				   _get_vol_size(params->chunk_size, backing_dev_size - md_size) : 0;
+	}
 	if (params->vol_size == 0) {
 		SPDK_ERRLOG("backing device is too small\n");
 		cb_fn(cb_arg, NULL, -EINVAL);
@@ -625,28 +866,30 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 		spdk_uuid_generate(&params->uuid);
 	}
 
-	memcpy(vol->pm_file.path, pm_file_dir, dir_len);
-	vol->pm_file.path[dir_len] = '/';
-	spdk_uuid_fmt_lower(&vol->pm_file.path[dir_len + 1], SPDK_UUID_STRING_LEN,
-			    &params->uuid);
-	vol->pm_file.size = _get_pm_file_size(params);
-	vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, vol->pm_file.size,
-					    PMEM_FILE_CREATE | PMEM_FILE_EXCL, 0600,
-					    &mapped_len, &vol->pm_file.pm_is_pmem);
-	if (vol->pm_file.pm_buf == NULL) {
-		SPDK_ERRLOG("could not pmem_map_file(%s): %s\n",
-			    vol->pm_file.path, strerror(errno));
-		cb_fn(cb_arg, NULL, -errno);
-		_init_load_cleanup(vol, init_ctx);
-		return;
-	}
+	if (pm_file_dir != NULL) {
+		memcpy(vol->pm_file.path, pm_file_dir, dir_len);
+		vol->pm_file.path[dir_len] = '/';
+		spdk_uuid_fmt_lower(&vol->pm_file.path[dir_len + 1], SPDK_UUID_STRING_LEN,
+				    &params->uuid);
+		vol->pm_file.size = _get_pm_file_size(params);
+		vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, vol->pm_file.size,
+						    PMEM_FILE_CREATE | PMEM_FILE_EXCL, 0600,
+						    &mapped_len, &vol->pm_file.pm_is_pmem);
+		if (vol->pm_file.pm_buf == NULL) {
+			SPDK_ERRLOG("could not pmem_map_file(%s): %s\n",
+				    vol->pm_file.path, strerror(errno));
+			cb_fn(cb_arg, NULL, -errno);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
 
-	if (vol->pm_file.size != mapped_len) {
-		SPDK_ERRLOG("could not map entire pmem file (size=%" PRIu64 " mapped=%" PRIu64 ")\n",
-			    vol->pm_file.size, mapped_len);
-		cb_fn(cb_arg, NULL, -ENOMEM);
-		_init_load_cleanup(vol, init_ctx);
-		return;
+		if (vol->pm_file.size != mapped_len) {
+			SPDK_ERRLOG("could not map entire pmem file (size=%" PRIu64 " mapped=%" PRIu64 ")\n",
+				    vol->pm_file.size, mapped_len);
+			cb_fn(cb_arg, NULL, -ENOMEM);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
 	}
 
 	vol->backing_io_units_per_chunk = params->chunk_size / params->backing_io_unit_size;
@@ -663,6 +906,16 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 		return;
 	}
 
+	if (pm_file_dir == NULL) {
+		rc = _allocate_md_buf(vol);
+		if (rc != 0) {
+			cb_fn(cb_arg, NULL, rc);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
+		vol->backing_super->flags |= REDUCE_SUPER_FLAG_MD_ON_BACKING_DEV;
+	}
+
 	memcpy(vol->backing_super->signature, SPDK_REDUCE_SIGNATURE,
 	       sizeof(vol->backing_super->signature));
 	memcpy(&vol->backing_super->params, params, sizeof(*params));
@@ -674,42 +927,90 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 	 * Note that this writes 0xFF to not just the logical map but the chunk maps as well.
 	 */
 	memset(vol->pm_logical_map, 0xFF, vol->pm_file.size - sizeof(*vol->backing_super));
-	_reduce_persist(vol, vol->pm_file.pm_buf, vol->pm_file.size);
+	if (!vol->md_on_backing_dev) {
+		_reduce_persist(vol, vol->pm_file.pm_buf, vol->pm_file.size);
+	}
 
 	init_ctx->vol = vol;
 	init_ctx->cb_fn = cb_fn;
 	init_ctx->cb_arg = cb_arg;
 
-	memcpy(init_ctx->path, vol->pm_file.path, REDUCE_PATH_MAX);
-	init_ctx->iov[0].iov_base = init_ctx->path;
-	init_ctx->iov[0].iov_len = REDUCE_PATH_MAX;
-	init_ctx->backing_cb_args.cb_fn = _init_write_path_cpl;
-	init_ctx->backing_cb_args.cb_arg = init_ctx;
-	/* Write path to offset 4K on backing device - just after where the super
-	 *  block will be written.  We wait until this is committed before writing the
-	 *  super block to guarantee we don't get the super block written without the
-	 *  the path if the system crashed in the middle of a write operation.
-	 */
-	vol->backing_dev->writev(vol->backing_dev, init_ctx->iov, 1,
-				 REDUCE_BACKING_DEV_PATH_OFFSET / vol->backing_dev->blocklen,
-				 REDUCE_PATH_MAX / vol->backing_dev->blocklen,
-				 &init_ctx->backing_cb_args);
+	if (vol->md_on_backing_dev) {
+		/* Write the metadata before the path and the super block, so that a super block
+		 *  never refers to metadata that wasn't initialized.
+		 */
+		_init_load_md_io(init_ctx, true, _init_write_md_cpl);
+	} else {
+		_init_write_path(init_ctx);
+	}
 }
 
 static void destroy_load_cb(void *cb_arg, struct spdk_reduce_vol *vol, int reduce_errno);
 
 static void
-_load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
+_load_init_maps(struct reduce_init_load_ctx *load_ctx)
 {
-	struct reduce_init_load_ctx *load_ctx = cb_arg;
 	struct spdk_reduce_vol *vol = load_ctx->vol;
-	uint64_t backing_dev_size;
 	uint64_t i, num_chunks, logical_map_index;
 	struct spdk_reduce_chunk_map *chunk;
-	size_t mapped_len;
 	uint32_t j;
 	int rc;
 
+	rc = _allocate_vol_requests(vol);
+	if (rc != 0) {
+		load_ctx->cb_fn(load_ctx->cb_arg, NULL, rc);
+		_init_load_cleanup(vol, load_ctx);
+		return;
+	}
+
+	_initialize_vol_pm_pointers(vol);
+
+	num_chunks = vol->params.vol_size / vol->params.chunk_size;
+	for (i = 0; i < num_chunks; i++) {
+		logical_map_index = vol->pm_logical_map[i];
+		if (logical_map_index == REDUCE_EMPTY_MAP_ENTRY) {
+			continue;
+		}
+		spdk_bit_array_set(vol->allocated_chunk_maps, logical_map_index);
+		chunk = _reduce_vol_get_chunk_map(vol, logical_map_index);
+		for (j = 0; j < vol->backing_io_units_per_chunk; j++) {
+			if (chunk->io_unit_index[j] != REDUCE_EMPTY_MAP_ENTRY) {
+				spdk_bit_array_set(vol->allocated_backing_io_units, chunk->io_unit_index[j]);
+			}
+		}
+	}
+
+	load_ctx->cb_fn(load_ctx->cb_arg, vol, 0);
+	/* Only clean up the ctx - the vol has been passed to the application
+	 *  for use now that volume load was successful.
+	 */
+	_init_load_cleanup(NULL, load_ctx);
+}
+
+static void
+_load_read_md_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+
+	if (reduce_errno != 0) {
+		load_ctx->cb_fn(load_ctx->cb_arg, NULL, reduce_errno);
+		_init_load_cleanup(load_ctx->vol, load_ctx);
+		return;
+	}
+
+	_load_init_maps(load_ctx);
+}
+
+static void
+_load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	uint64_t backing_dev_size, md_end;
+	size_t mapped_len;
+	uint32_t blocklen;
+	int rc;
+
 	rc = _alloc_zero_buff();
 	if (rc) {
 		goto error;
@@ -753,6 +1054,25 @@ _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 		goto error;
 	}
 
+	if (vol->backing_super->flags & REDUCE_SUPER_FLAG_MD_ON_BACKING_DEV) {
+		blocklen = vol->backing_dev->blocklen;
+		md_end = _get_md_offset(&vol->params, blocklen) +
+			 _get_md_size(&vol->params, blocklen) / blocklen;
+		if (md_end > vol->backing_dev->blockcnt) {
+			SPDK_ERRLOG("backing device too small to hold the metadata\n");
+			rc = -EILSEQ;
+			goto error;
+		}
+
+		rc = _allocate_md_buf(vol);
+		if (rc != 0) {
+			goto error;
+		}
+
+		_init_load_md_io(load_ctx, false, _load_read_md_cpl);
+		return;
+	}
+
 	vol->pm_file.size = _get_pm_file_size(&vol->params);
 	vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, 0, 0, 0, &mapped_len,
 					    &vol->pm_file.pm_is_pmem);
@@ -769,33 +1089,7 @@ _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 		goto error;
 	}
 
-	rc = _allocate_vol_requests(vol);
-	if (rc != 0) {
-		goto error;
-	}
-
-	_initialize_vol_pm_pointers(vol);
-
-	num_chunks = vol->params.vol_size / vol->params.chunk_size;
-	for (i = 0; i < num_chunks; i++) {
-		logical_map_index = vol->pm_logical_map[i];
-		if (logical_map_index == REDUCE_EMPTY_MAP_ENTRY) {
-			continue;
-		}
-		spdk_bit_array_set(vol->allocated_chunk_maps, logical_map_index);
-		chunk = _reduce_vol_get_chunk_map(vol, logical_map_index);
-		for (j = 0; j < vol->backing_io_units_per_chunk; j++) {
-			if (chunk->io_unit_index[j] != REDUCE_EMPTY_MAP_ENTRY) {
-				spdk_bit_array_set(vol->allocated_backing_io_units, chunk->io_unit_index[j]);
-			}
-		}
-	}
-
-	load_ctx->cb_fn(load_ctx->cb_arg, vol, 0);
-	/* Only clean up the ctx - the vol has been passed to the application
-	 *  for use now that volume load was successful.
-	 */
-	_init_load_cleanup(NULL, load_ctx);
+	_load_init_maps(load_ctx);
 	return;
 
 error:
@@ -903,7 +1197,8 @@ destroy_unload_cpl(void *cb_arg, int reduce_errno)
 {
 	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
 
-	if (destroy_ctx->reduce_errno == 0) {
+	/* There's no pm file to remove if the metadata was kept on the backing device */
+	if (destroy_ctx->reduce_errno == 0 && destroy_ctx->pm_path[0] != '\0') {
 		if (unlink(destroy_ctx->pm_path)) {
 			SPDK_ERRLOG("%s could not be unlinked: %s\n",
 				    destroy_ctx->pm_path, strerror(errno));
@@ -987,7 +1282,63 @@ _request_spans_chunk_boundary(struct spdk_reduce_vol *vol, uint64_t offset, uint
 	return (start_chunk != end_chunk);
 }
 
-typedef void (*reduce_request_fn)(void *_req, int reduce_errno);
+static struct reduce_cached_chunk *
+_reduce_vol_get_cached_chunk(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
+{
+	struct reduce_cached_chunk *entry;
+
+	TAILQ_FOREACH(entry, &vol->cached_chunks, tailq) {
+		if (entry->logical_map_index == logical_map_index) {
+			TAILQ_REMOVE(&vol->cached_chunks, entry, tailq);
+			TAILQ_INSERT_HEAD(&vol->cached_chunks, entry, tailq);
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+_reduce_vol_invalidate_cached_chunk(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
+{
+	struct reduce_cached_chunk *entry;
+
+	TAILQ_FOREACH(entry, &vol->cached_chunks, tailq) {
+		if (entry->logical_map_index == logical_map_index) {
+			entry->logical_map_index = REDUCE_EMPTY_MAP_ENTRY;
+			TAILQ_REMOVE(&vol->cached_chunks, entry, tailq);
+			TAILQ_INSERT_TAIL(&vol->cached_chunks, entry, tailq);
+			break;
+		}
+	}
+}
+
+/* Keep the uncompressed data of a chunk that was just written.  The decomp_iov array still
+ *  describes the whole chunk that was passed to the compression engine.
+ */
+static void
+_reduce_vol_cache_chunk(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	struct reduce_cached_chunk *entry;
+	uint8_t *buf;
+	int i;
+
+	entry = _reduce_vol_get_cached_chunk(vol, req->logical_map_index);
+	if (entry == NULL) {
+		entry = TAILQ_LAST(&vol->cached_chunks, reduce_cached_chunk_head);
+		entry->logical_map_index = req->logical_map_index;
+		TAILQ_REMOVE(&vol->cached_chunks, entry, tailq);
+		TAILQ_INSERT_HEAD(&vol->cached_chunks, entry, tailq);
+	}
+
+	buf = entry->buf;
+	for (i = 0; i < req->decomp_iovcnt; i++) {
+		memcpy(buf, req->decomp_iov[i].iov_base, req->decomp_iov[i].iov_len);
+		buf += req->decomp_iov[i].iov_len;
+	}
+	assert(buf == entry->buf + vol->params.chunk_size);
+}
 
 static void
 _reduce_vol_complete_req(struct spdk_reduce_vol_request *req, int reduce_errno)
@@ -1014,14 +1365,192 @@ _reduce_vol_complete_req(struct spdk_reduce_vol_request *req, int reduce_errno)
 	TAILQ_INSERT_HEAD(&vol->free_requests, req, tailq);
 }
 
+static void
+_reduce_vol_release_chunk(struct spdk_reduce_vol *vol, uint64_t chunk_map_index)
+{
+	struct spdk_reduce_chunk_map *chunk;
+	uint32_t i;
+
+	if (chunk_map_index == REDUCE_EMPTY_MAP_ENTRY) {
+		return;
+	}
+
+	chunk = _reduce_vol_get_chunk_map(vol, chunk_map_index);
+	for (i = 0; i < vol->backing_io_units_per_chunk; i++) {
+		if (chunk->io_unit_index[i] == REDUCE_EMPTY_MAP_ENTRY) {
+			break;
+		}
+		assert(spdk_bit_array_get(vol->allocated_backing_io_units, chunk->io_unit_index[i]) == true);
+		spdk_bit_array_clear(vol->allocated_backing_io_units, chunk->io_unit_index[i]);
+		chunk->io_unit_index[i] = REDUCE_EMPTY_MAP_ENTRY;
+	}
+	spdk_bit_array_clear(vol->allocated_chunk_maps, chunk_map_index);
+}
+
+static int
+_reduce_md_block_cmp(const void *_a, const void *_b)
+{
+	uint64_t a = *(const uint64_t *)_a, b = *(const uint64_t *)_b;
+
+	return a < b ? -1 : a > b;
+}
+
+static void _reduce_vol_md_flush(struct spdk_reduce_vol *vol);
+
+static void
+_reduce_vol_md_flush_cpl(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+	struct spdk_reduce_vol_request *req, *tmp;
+	TAILQ_HEAD(, spdk_reduce_vol_request) requests = TAILQ_HEAD_INITIALIZER(requests);
+
+	if (reduce_errno != 0) {
+		vol->md_flush_errno = reduce_errno;
+	}
+
+	assert(vol->md_flush_outstanding > 0);
+	if (vol->md_flush_outstanding > 1) {
+		vol->md_flush_outstanding--;
+		return;
+	}
+
+	/* The flush is still considered in progress while the callbacks are executed, so that the
+	 *  updates they make are all batched into the next one.
+	 */
+	TAILQ_CONCAT(&requests, &vol->md_flushing_requests, md_tailq);
+	TAILQ_FOREACH_SAFE(req, &requests, md_tailq, tmp) {
+		TAILQ_REMOVE(&requests, req, md_tailq);
+		req->md_cb_fn(req, vol->md_flush_errno);
+	}
+
+	vol->md_flush_outstanding = 0;
+	_reduce_vol_md_flush(vol);
+}
+
+/* Write all the metadata blocks modified since the previous flush, merging adjacent ones.  Only
+ *  a single flush is in progress at a time, so writes of the same block never race each other.
+ */
+static void
+_reduce_vol_md_flush(struct spdk_reduce_vol *vol)
+{
+	struct reduce_md_write *write = NULL;
+	uint32_t blocklen = vol->backing_dev->blocklen;
+	uint32_t i, num_blocks, num_writes = 0;
+	uint64_t *blocks;
+
+	if (vol->md_flush_outstanding > 0 || TAILQ_EMPTY(&vol->md_pending_requests)) {
+		return;
+	}
+
+	blocks = vol->md_next_blocks;
+	num_blocks = vol->md_num_next_blocks;
+	vol->md_next_blocks = vol->md_flush_blocks;
+	vol->md_flush_blocks = blocks;
+	vol->md_num_next_blocks = 0;
+	TAILQ_CONCAT(&vol->md_flushing_requests, &vol->md_pending_requests, md_tailq);
+
+	qsort(blocks, num_blocks, sizeof(*blocks), _reduce_md_block_cmp);
+	for (i = 0; i < num_blocks; i++) {
+		spdk_bit_array_clear(vol->md_dirty_blocks, blocks[i]);
+		if (write != NULL && write->block + write->num_blocks == blocks[i]) {
+			write->num_blocks++;
+			continue;
+		}
+		write = &vol->md_writes[num_writes++];
+		write->block = blocks[i];
+		write->num_blocks = 1;
+	}
+
+	assert(num_writes > 0);
+	vol->md_flush_errno = 0;
+	vol->md_flush_outstanding = num_writes;
+	vol->md_flush_cb_args.cb_fn = _reduce_vol_md_flush_cpl;
+	vol->md_flush_cb_args.cb_arg = vol;
+	for (i = 0; i < num_writes; i++) {
+		write = &vol->md_writes[i];
+		write->iov.iov_base = (uint8_t *)vol->pm_file.pm_buf + write->block * blocklen;
+		write->iov.iov_len = write->num_blocks * blocklen;
+		vol->backing_dev->writev(vol->backing_dev, &write->iov, 1,
+					 vol->md_offset + write->block, write->num_blocks,
+					 &vol->md_flush_cb_args);
+	}
+}
+
+/* Persist a metadata update kept on the backing device and call cb_fn once it's written */
+static void
+_reduce_vol_md_persist(struct spdk_reduce_vol_request *req, const void *addr, size_t len,
+		       reduce_request_fn cb_fn)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	uint32_t blocklen = vol->backing_dev->blocklen;
+	uint64_t offset, block;
+
+	offset = (uintptr_t)addr - (uintptr_t)vol->pm_file.pm_buf;
+	for (block = offset / blocklen; block <= (offset + len - 1) / blocklen; block++) {
+		if (!spdk_bit_array_get(vol->md_dirty_blocks, block)) {
+			spdk_bit_array_set(vol->md_dirty_blocks, block);
+			vol->md_next_blocks[vol->md_num_next_blocks++] = block;
+		}
+	}
+
+	req->md_cb_fn = cb_fn;
+	TAILQ_INSERT_TAIL(&vol->md_pending_requests, req, md_tailq);
+	_reduce_vol_md_flush(vol);
+}
+
+static void
+_write_complete_req(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+
+	/* Only partially written chunks are likely to be modified again by small writes. */
+	if ((req->length * vol->params.logical_block_size) < vol->params.chunk_size) {
+		_reduce_vol_cache_chunk(req);
+	} else {
+		_reduce_vol_invalidate_cached_chunk(vol, req->logical_map_index);
+	}
+
+	_reduce_vol_complete_req(req, 0);
+}
+
+static void
+_write_logical_map_persisted(void *_req, int reduce_errno)
+{
+	struct spdk_reduce_vol_request *req = _req;
+
+	if (reduce_errno != 0) {
+		_reduce_vol_complete_req(req, reduce_errno);
+		return;
+	}
+
+	/* The old chunk isn't referenced on the backing device anymore, so it can be reused now */
+	_reduce_vol_release_chunk(req->vol, req->old_chunk_map_index);
+	_write_complete_req(req);
+}
+
+static void
+_write_chunk_map_persisted(void *_req, int reduce_errno)
+{
+	struct spdk_reduce_vol_request *req = _req;
+	struct spdk_reduce_vol *vol = req->vol;
+
+	if (reduce_errno != 0) {
+		_reduce_vol_complete_req(req, reduce_errno);
+		return;
+	}
+
+	req->old_chunk_map_index = vol->pm_logical_map[req->logical_map_index];
+	vol->pm_logical_map[req->logical_map_index] = req->chunk_map_index;
+	_reduce_vol_md_persist(req, &vol->pm_logical_map[req->logical_map_index], sizeof(uint64_t),
+			       _write_logical_map_persisted);
+}
+
 static void
 _write_write_done(void *_req, int reduce_errno)
 {
 	struct spdk_reduce_vol_request *req = _req;
 	struct spdk_reduce_vol *vol = req->vol;
-	uint64_t old_chunk_map_index;
-	struct spdk_reduce_chunk_map *old_chunk;
-	uint32_t i;
+	uint32_t chunk_map_size;
 
 	if (reduce_errno != 0) {
 		req->reduce_errno = reduce_errno;
@@ -1037,20 +1566,17 @@ _write_write_done(void *_req, int reduce_errno)
 		return;
 	}
 
-	old_chunk_map_index = vol->pm_logical_map[req->logical_map_index];
-	if (old_chunk_map_index != REDUCE_EMPTY_MAP_ENTRY) {
-		old_chunk = _reduce_vol_get_chunk_map(vol, old_chunk_map_index);
-		for (i = 0; i < vol->backing_io_units_per_chunk; i++) {
-			if (old_chunk->io_unit_index[i] == REDUCE_EMPTY_MAP_ENTRY) {
-				break;
-			}
-			assert(spdk_bit_array_get(vol->allocated_backing_io_units, old_chunk->io_unit_index[i]) == true);
-			spdk_bit_array_clear(vol->allocated_backing_io_units, old_chunk->io_unit_index[i]);
-			old_chunk->io_unit_index[i] = REDUCE_EMPTY_MAP_ENTRY;
-		}
-		spdk_bit_array_clear(vol->allocated_chunk_maps, old_chunk_map_index);
+	if (vol->md_on_backing_dev) {
+		/* Same ordering as below, but the old chunk can only be released once the logical
+		 *  map update is written, as it's otherwise still referenced on the backing device.
+		 */
+		chunk_map_size = _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk);
+		_reduce_vol_md_persist(req, req->chunk, chunk_map_size, _write_chunk_map_persisted);
+		return;
 	}
 
+	_reduce_vol_release_chunk(vol, vol->pm_logical_map[req->logical_map_index]);
+
 	/*
 	 * We don't need to persist the clearing of the old chunk map here.  The old chunk map
 	 * becomes invalid after we update the logical map, since the old chunk map will no
@@ -1065,7 +1591,22 @@ _write_write_done(void *_req, int reduce_errno)
 
 	_reduce_persist(vol, &vol->pm_logical_map[req->logical_map_index], sizeof(uint64_t));
 
-	_reduce_vol_complete_req(req, 0);
+	_write_complete_req(req);
+}
+
+/* Returns the number of io units, starting at the given one, stored contiguously on disk */
+static uint32_t
+_reduce_vol_get_io_unit_run(struct spdk_reduce_vol_request *req, uint32_t start)
+{
+	uint32_t i;
+
+	for (i = start + 1; i < req->num_io_units; i++) {
+		if (req->chunk->io_unit_index[i] != req->chunk->io_unit_index[i - 1] + 1) {
+			break;
+		}
+	}
+
+	return i - start;
 }
 
 static void
@@ -1074,7 +1615,8 @@ _issue_backing_ops(struct spdk_reduce_vol_request *req, struct spdk_reduce_vol *
 {
 	struct iovec *iov;
 	uint8_t *buf;
-	uint32_t i;
+	uint64_t lba;
+	uint32_t i, num_units, num_ops = 0;
 
 	if (req->chunk_is_compressed) {
 		iov = req->comp_buf_iov;
@@ -1084,20 +1626,31 @@ _issue_backing_ops(struct spdk_reduce_vol_request *req, struct spdk_reduce_vol *
 		buf = req->decomp_buf;
 	}
 
-	req->num_backing_ops = req->num_io_units;
+	/* Io units that are contiguous on the backing device are transferred with a single
+	 *  operation.  All of them need to be counted before any is issued, as the backing device
+	 *  may complete them immediately.
+	 */
+	for (i = 0; i < req->num_io_units; i += num_units) {
+		num_units = _reduce_vol_get_io_unit_run(req, i);
+		iov[num_ops].iov_base = buf + i * vol->params.backing_io_unit_size;
+		iov[num_ops].iov_len = num_units * vol->params.backing_io_unit_size;
+		num_ops++;
+	}
+
+	req->num_backing_ops = num_ops;
 	req->backing_cb_args.cb_fn = next_fn;
 	req->backing_cb_args.cb_arg = req;
-	for (i = 0; i < req->num_io_units; i++) {
-		iov[i].iov_base = buf + i * vol->params.backing_io_unit_size;
-		iov[i].iov_len = vol->params.backing_io_unit_size;
+	for (i = 0, num_ops = 0; i < req->num_io_units; i += num_units, num_ops++) {
+		num_units = iov[num_ops].iov_len / vol->params.backing_io_unit_size;
+		lba = req->chunk->io_unit_index[i] * vol->backing_lba_per_io_unit;
 		if (is_write) {
-			vol->backing_dev->writev(vol->backing_dev, &iov[i], 1,
-						 req->chunk->io_unit_index[i] * vol->backing_lba_per_io_unit,
-						 vol->backing_lba_per_io_unit, &req->backing_cb_args);
+			vol->backing_dev->writev(vol->backing_dev, &iov[num_ops], 1, lba,
+						 num_units * vol->backing_lba_per_io_unit,
+						 &req->backing_cb_args);
 		} else {
-			vol->backing_dev->readv(vol->backing_dev, &iov[i], 1,
-						req->chunk->io_unit_index[i] * vol->backing_lba_per_io_unit,
-						vol->backing_lba_per_io_unit, &req->backing_cb_args);
+			vol->backing_dev->readv(vol->backing_dev, &iov[num_ops], 1, lba,
+						num_units * vol->backing_lba_per_io_unit,
+						&req->backing_cb_args);
 		}
 	}
 }
@@ -1107,7 +1660,7 @@ _reduce_vol_write_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn n
 			uint32_t compressed_size)
 {
 	struct spdk_reduce_vol *vol = req->vol;
-	uint32_t i;
+	uint32_t i, start;
 	uint64_t chunk_offset, remainder, total_len = 0;
 	uint8_t *buf;
 	int j;
@@ -1156,7 +1709,12 @@ _reduce_vol_write_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn n
 	}
 
 	for (i = 0; i < req->num_io_units; i++) {
-		req->chunk->io_unit_index[i] = spdk_bit_array_find_first_clear(vol->allocated_backing_io_units, 0);
+		/* All io units below the previous one are in use, so continue the search from there,
+		 *  which also keeps the chunk's io units contiguous whenever possible.
+		 */
+		start = i == 0 ? 0 : req->chunk->io_unit_index[i - 1] + 1;
+		req->chunk->io_unit_index[i] =
+			spdk_bit_array_find_first_clear(vol->allocated_backing_io_units, start);
 		/* TODO: fail if no backing block found - but really this should also not
 		 * happen (see comment above).
 		 */
@@ -1629,6 +2187,7 @@ static void
 _start_writev_request(struct spdk_reduce_vol_request *req)
 {
 	struct spdk_reduce_vol *vol = req->vol;
+	struct reduce_cached_chunk *entry;
 
 	TAILQ_INSERT_TAIL(&req->vol->executing_requests, req, tailq);
 	if (vol->pm_logical_map[req->logical_map_index] != REDUCE_EMPTY_MAP_ENTRY) {
@@ -1637,6 +2196,13 @@ _start_writev_request(struct spdk_reduce_vol_request *req)
 			 *  operation.
 			 */
 			req->rmw = true;
+			entry = _reduce_vol_get_cached_chunk(vol, req->logical_map_index);
+			if (entry != NULL) {
+				memcpy(req->decomp_buf, entry->buf, vol->params.chunk_size);
+				_prepare_compress_chunk(req, false);
+				_reduce_vol_compress_chunk(req, _write_compress_done);
+				return;
+			}
 			_reduce_vol_read_chunk(req, _write_read_done);
 			return;
 		}
@@ -5,6 +5,7 @@
 
 #include "rocksdb/env.h"
 #include <set>
+#include <vector>
 #include <iostream>
 #include <stdexcept>
 
@@ -28,6 +29,11 @@ uint32_t g_lcore = 0;
 std::string g_bdev_name;
 volatile bool g_spdk_ready = false;
 volatile bool g_spdk_start_failure = false;
+struct spdk_thread *g_app_thread;
+/* Threads serving the reads of the files, one per reactor */
+std::vector<struct spdk_thread *> g_io_shards;
+std::vector<struct spdk_io_channel *> g_io_shard_channels;
+uint32_t g_io_shards_running;
 
 void SpdkInitializeThread(void);
 
@@ -82,6 +88,12 @@ __send_request(fs_request_fn fn, void *arg)
 	spdk_event_call(event);
 }
 
+static void
+__send_io_request(uint32_t shard, fs_request_fn fn, void *arg)
+{
+	spdk_thread_send_msg(g_io_shards[shard], fn, arg);
+}
+
 static std::string
 sanitize_path(const std::string &input, const std::string &mount_directory)
 {
@@ -615,12 +627,60 @@ void SpdkInitializeThread(void)
 	}
 }
 
+static void
+io_shard_start(void *arg)
+{
+	uintptr_t shard = (uintptr_t)arg;
+
+	/* The requests sent to the shard only take references on this channel */
+	g_io_shard_channels[shard] = spdk_fs_alloc_io_channel(g_fs);
+}
+
+/* With several reactors, the reads of the files are spread over one thread per
+ * reactor, so that concurrent RocksDB threads (e.g. compactions) don't all get
+ * serialized on g_lcore.
+ */
+static void
+start_io_shards(void)
+{
+	struct spdk_cpuset cpumask;
+	struct spdk_thread *thread;
+	char name[32];
+	uint32_t core;
+	uintptr_t shard;
+
+	if (spdk_env_get_core_count() < 2) {
+		return;
+	}
+
+	g_io_shard_channels.resize(spdk_env_get_core_count());
+	SPDK_ENV_FOREACH_CORE(core) {
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, core, true);
+		snprintf(name, sizeof(name), "blobfs_io%u", core);
+		thread = spdk_thread_create(name, &cpumask);
+		if (thread == NULL) {
+			printf("Could not create blobfs I/O thread on core %u\n", core);
+			break;
+		}
+
+		shard = g_io_shards.size();
+		g_io_shards.push_back(thread);
+		spdk_thread_send_msg(thread, io_shard_start, (void *)shard);
+	}
+
+	if (!g_io_shards.empty()) {
+		spdk_fs_set_io_shards(g_fs, g_io_shards.size(), __send_io_request);
+	}
+}
+
 static void
 fs_load_cb(__attribute__((unused)) void *ctx,
 	   struct spdk_filesystem *fs, int fserrno)
 {
 	if (fserrno == 0) {
 		g_fs = fs;
+		start_io_shards();
 	}
 	g_spdk_ready = true;
 }
@@ -646,6 +706,7 @@ rocksdb_run(__attribute__((unused)) void *arg1)
 	}
 
 	g_lcore = spdk_env_get_first_core();
+	g_app_thread = spdk_get_thread();
 
 	printf("using bdev %s\n", g_bdev_name.c_str());
 	spdk_fs_load(g_bs_dev, __send_request, fs_load_cb, NULL);
@@ -661,12 +722,44 @@ fs_unload_cb(__attribute__((unused)) void *ctx,
 }
 
 static void
-rocksdb_shutdown(void)
+io_shard_stopped(__attribute__((unused)) void *arg)
 {
-	if (g_fs != NULL) {
+	if (--g_io_shards_running == 0) {
+		g_io_shards.clear();
 		spdk_fs_unload(g_fs, fs_unload_cb, NULL);
-	} else {
+	}
+}
+
+static void
+io_shard_stop(void *arg)
+{
+	uintptr_t shard = (uintptr_t)arg;
+
+	spdk_fs_free_io_channel(g_io_shard_channels[shard]);
+	spdk_thread_exit(spdk_get_thread());
+	spdk_thread_send_msg(g_app_thread, io_shard_stopped, NULL);
+}
+
+static void
+rocksdb_shutdown(void)
+{
+	uintptr_t shard;
+
+	if (g_fs == NULL) {
 		fs_unload_cb(NULL, 0);
+		return;
+	}
+
+	if (g_io_shards.empty()) {
+		spdk_fs_unload(g_fs, fs_unload_cb, NULL);
+		return;
+	}
+
+	/* The I/O channels must be released before the blobstore is unloaded */
+	spdk_fs_set_io_shards(g_fs, 0, NULL);
+	g_io_shards_running = g_io_shards.size();
+	for (shard = 0; shard < g_io_shards.size(); shard++) {
+		spdk_thread_send_msg(g_io_shards[shard], io_shard_stop, (void *)shard);
 	}
 }
 
@@ -721,6 +814,20 @@ SpdkEnv::SpdkEnv(Env *base_env, const std::string &dir, const std::string &conf,
 	SpdkInitializeThread();
 }
 
+static void
+print_cache_stats(void)
+{
+	struct spdk_fs_cache_stats stats;
+	uint64_t reads;
+
+	spdk_fs_get_cache_stats(&stats);
+	reads = stats.hits + stats.misses;
+	printf("blobfs cache: hit ratio %.2f%% (%" PRIu64 " hits, %" PRIu64 " misses), "
+	       "read-ahead %" PRIu64 " buffers (%" PRIu64 " used), %" PRIu64 " buffers reclaimed\n",
+	       reads != 0 ? (double)stats.hits * 100 / reads : 0.0, stats.hits, stats.misses,
+	       stats.readahead, stats.readahead_hits, stats.reclaimed);
+}
+
 SpdkEnv::~SpdkEnv()
 {
 	/* This is a workaround for rocksdb test, we close the files if the rocksdb not
@@ -730,6 +837,8 @@ SpdkEnv::~SpdkEnv()
 		spdk_fs_iter iter;
 		struct spdk_file *file;
 
+		print_cache_stats();
+
 		if (!g_sync_args.channel) {
 			SpdkInitializeThread();
 		}
@@ -194,6 +194,9 @@ _scsi_lun_execute_task(struct spdk_scsi_lun *lun, struct spdk_scsi_task *task)
 					  SPDK_SCSI_ASCQ_CAPACITY_DATA_HAS_CHANGED);
 		lun->resizing = false;
 		rc = SPDK_SCSI_TASK_COMPLETE;
+	} else if (spdk_likely(lun->reservation.holder == NULL)) {
+		/* Neither a persistent nor an SPC2 reservation exists */
+		rc = bdev_scsi_execute(task);
 	} else {
 		/* Check the command is allowed or not when reservation is exist */
 		if (spdk_unlikely(lun->reservation.flags & SCSI_SPC2_RESERVE)) {
@@ -47,6 +47,16 @@ struct spdk_scsi_pr_registrant {
 	TAILQ_ENTRY(spdk_scsi_pr_registrant)	link;
 };
 
+#define SCSI_PR_NEXUS_CACHE_SIZE		16
+
+/* Cached registrant lookup for an I_T nexus */
+struct spdk_scsi_pr_nexus_cache {
+	struct spdk_scsi_port			*initiator_port;
+	struct spdk_scsi_port			*target_port;
+	struct spdk_scsi_pr_registrant		*reg;
+	uint32_t				generation;
+};
+
 #define SCSI_SPC2_RESERVE			0x00000001U
 
 /* Reservation with LU_SCOPE */
@@ -129,6 +139,10 @@ struct spdk_scsi_lun {
 	struct spdk_scsi_pr_reservation reservation;
 	/** Reservation holder for SPC2 RESERVE(6) and RESERVE(10) */
 	struct spdk_scsi_pr_registrant scsi2_holder;
+	/** Bumped whenever reg_head changes, invalidates pr_nexus_cache */
+	uint32_t pr_nexus_generation;
+	/** Registrant lookups by I_T nexus, so that commands don't walk reg_head */
+	struct spdk_scsi_pr_nexus_cache pr_nexus_cache[SCSI_PR_NEXUS_CACHE_SIZE];
 
 	/** List of open descriptors for this LUN. */
 	TAILQ_HEAD(, spdk_scsi_lun_desc) open_descs;
@@ -6,6 +6,24 @@
 #include "scsi_internal.h"
 
 #include "spdk/endian.h"
+#include "spdk/likely.h"
+
+static inline struct spdk_scsi_pr_nexus_cache *
+scsi_pr_nexus_cache_entry(struct spdk_scsi_lun *lun,
+			  struct spdk_scsi_port *initiator_port,
+			  struct spdk_scsi_port *target_port)
+{
+	uintptr_t key = (uintptr_t)initiator_port ^ ((uintptr_t)target_port >> 4);
+
+	return &lun->pr_nexus_cache[(key >> 6) % SCSI_PR_NEXUS_CACHE_SIZE];
+}
+
+/* Must be called whenever a registrant is added to or removed from reg_head */
+static inline void
+scsi_pr_nexus_cache_invalidate(struct spdk_scsi_lun *lun)
+{
+	lun->pr_nexus_generation++;
+}
 
 /* Get registrant by I_T nexus */
 static struct spdk_scsi_pr_registrant *
@@ -13,16 +31,32 @@ scsi_pr_get_registrant(struct spdk_scsi_lun *lun,
 		       struct spdk_scsi_port *initiator_port,
 		       struct spdk_scsi_port *target_port)
 {
+	struct spdk_scsi_pr_nexus_cache *entry;
 	struct spdk_scsi_pr_registrant *reg, *tmp;
 
+	/* Every command is checked against the reservation, so the result of the lookup,
+	 * including a miss, is cached until the registrants change.
+	 */
+	entry = scsi_pr_nexus_cache_entry(lun, initiator_port, target_port);
+	if (spdk_likely(entry->generation == lun->pr_nexus_generation &&
+			entry->initiator_port == initiator_port &&
+			entry->target_port == target_port)) {
+		return entry->reg;
+	}
+
 	TAILQ_FOREACH_SAFE(reg, &lun->reg_head, link, tmp) {
 		if (initiator_port == reg->initiator_port &&
 		    target_port == reg->target_port) {
-			return reg;
+			break;
 		}
 	}
 
-	return NULL;
+	entry->initiator_port = initiator_port;
+	entry->target_port = target_port;
+	entry->reg = reg;
+	entry->generation = lun->pr_nexus_generation;
+
+	return reg;
 }
 
 static bool
@@ -102,6 +136,7 @@ scsi_pr_register_registrant(struct spdk_scsi_lun *lun,
 	}
 	reg->rkey = sa_rkey;
 	TAILQ_INSERT_TAIL(&lun->reg_head, reg, link);
+	scsi_pr_nexus_cache_invalidate(lun);
 	lun->pr_generation++;
 
 	return 0;
@@ -143,6 +178,7 @@ scsi_pr_unregister_registrant(struct spdk_scsi_lun *lun,
 	SPDK_DEBUGLOG(scsi, "REGISTER: unregister registrant\n");
 
 	TAILQ_REMOVE(&lun->reg_head, reg, link);
+	scsi_pr_nexus_cache_invalidate(lun);
 	if (scsi_pr_registrant_is_holder(lun, reg)) {
 		scsi_pr_release_reservation(lun, reg);
 	}
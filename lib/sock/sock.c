@@ -10,6 +10,8 @@
 #include "spdk_internal/sock.h"
 #include "spdk/log.h"
 #include "spdk/env.h"
+#include "spdk/likely.h"
+#include "spdk/metrics.h"
 #include "spdk/util.h"
 
 #define SPDK_SOCK_DEFAULT_PRIORITY 0
@@ -21,6 +23,49 @@
 static STAILQ_HEAD(, spdk_net_impl) g_net_impls = STAILQ_HEAD_INITIALIZER(g_net_impls);
 static struct spdk_net_impl *g_default_impl;
 
+enum sock_metric {
+	SOCK_METRIC_SEND_CALLS,
+	SOCK_METRIC_BYTES_SENT,
+	SOCK_METRIC_ZCOPY_NOTIFICATIONS,
+	SOCK_METRIC_ZCOPY_COMPLETED_REQS,
+	SOCK_METRIC_KTLS_BYTES_SENT,
+	SOCK_METRIC_KTLS_BYTES_RECEIVED,
+	SOCK_METRIC_RECV_CALLS,
+	SOCK_METRIC_BYTES_RECEIVED,
+};
+
+static const struct spdk_metric_desc g_sock_metrics[] = {
+	[SOCK_METRIC_SEND_CALLS] = {
+		"spdk_sock_send_calls", "System calls that sent data", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[SOCK_METRIC_BYTES_SENT] = {
+		"spdk_sock_bytes_sent", "Bytes sent", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[SOCK_METRIC_ZCOPY_NOTIFICATIONS] = {
+		"spdk_sock_zcopy_notifications", "Zero copy completion notifications",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+	[SOCK_METRIC_ZCOPY_COMPLETED_REQS] = {
+		"spdk_sock_zcopy_completed_reqs", "Requests completed by zero copy notifications",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+	[SOCK_METRIC_KTLS_BYTES_SENT] = {
+		"spdk_sock_ktls_bytes_sent", "Bytes sent with kernel TLS", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[SOCK_METRIC_KTLS_BYTES_RECEIVED] = {
+		"spdk_sock_ktls_bytes_received", "Bytes received with kernel TLS",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+	[SOCK_METRIC_RECV_CALLS] = {
+		"spdk_sock_recv_calls", "System calls that received data", SPDK_METRIC_TYPE_COUNTER,
+	},
+	[SOCK_METRIC_BYTES_RECEIVED] = {
+		"spdk_sock_bytes_received", "Bytes received", SPDK_METRIC_TYPE_COUNTER,
+	},
+};
+
+static pthread_mutex_t g_sock_metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 struct spdk_sock_placement_id_entry {
 	int placement_id;
 	uint32_t ref;
@@ -562,6 +607,73 @@ spdk_sock_is_connected(struct spdk_sock *sock)
 	return sock->net_impl->is_connected(sock);
 }
 
+/*
+ * The metrics of an implementation are registered with its first group and unregistered with
+ * its last one, so they are gone once the users of the sockets have closed their groups, before
+ * the sock subsystem is finished.
+ */
+static void
+sock_impl_get_metrics(struct spdk_net_impl *impl)
+{
+	/* The groups are created and closed on their own threads */
+	pthread_mutex_lock(&g_sock_metrics_mutex);
+	if (impl->metrics_groups++ == 0 && spdk_metrics_enabled()) {
+		impl->metrics = spdk_metrics_group_register(g_sock_metrics,
+				SPDK_COUNTOF(g_sock_metrics), "impl", impl->name);
+	}
+	pthread_mutex_unlock(&g_sock_metrics_mutex);
+}
+
+static void
+sock_impl_put_metrics(struct spdk_net_impl *impl)
+{
+	pthread_mutex_lock(&g_sock_metrics_mutex);
+	assert(impl->metrics_groups > 0);
+	if (--impl->metrics_groups == 0) {
+		spdk_metrics_group_unregister(impl->metrics);
+		impl->metrics = NULL;
+	}
+	pthread_mutex_unlock(&g_sock_metrics_mutex);
+}
+
+static inline void
+sock_metrics_update(struct spdk_sock_group_impl *group_impl, uint32_t metric, uint64_t value,
+		    uint64_t *prev)
+{
+	if (value != *prev) {
+		spdk_metrics_counter_add(group_impl->net_impl->metrics, metric, value - *prev);
+		*prev = value;
+	}
+}
+
+/*
+ * The socket modules update the statistics of their groups in many places, so the metrics
+ * are updated with the difference since the previous poll instead.
+ */
+static void
+sock_group_impl_update_metrics(struct spdk_sock_group_impl *group_impl)
+{
+	struct spdk_sock_group_stats *stats = &group_impl->stats;
+	struct spdk_sock_group_stats *prev = &group_impl->metrics_stats;
+
+	sock_metrics_update(group_impl, SOCK_METRIC_SEND_CALLS, stats->send_calls,
+			    &prev->send_calls);
+	sock_metrics_update(group_impl, SOCK_METRIC_BYTES_SENT, stats->bytes_sent,
+			    &prev->bytes_sent);
+	sock_metrics_update(group_impl, SOCK_METRIC_ZCOPY_NOTIFICATIONS, stats->zcopy_notifications,
+			    &prev->zcopy_notifications);
+	sock_metrics_update(group_impl, SOCK_METRIC_ZCOPY_COMPLETED_REQS,
+			    stats->zcopy_completed_reqs, &prev->zcopy_completed_reqs);
+	sock_metrics_update(group_impl, SOCK_METRIC_KTLS_BYTES_SENT, stats->ktls_bytes_sent,
+			    &prev->ktls_bytes_sent);
+	sock_metrics_update(group_impl, SOCK_METRIC_KTLS_BYTES_RECEIVED, stats->ktls_bytes_received,
+			    &prev->ktls_bytes_received);
+	sock_metrics_update(group_impl, SOCK_METRIC_RECV_CALLS, stats->recv_calls,
+			    &prev->recv_calls);
+	sock_metrics_update(group_impl, SOCK_METRIC_BYTES_RECEIVED, stats->bytes_received,
+			    &prev->bytes_received);
+}
+
 struct spdk_sock_group *
 spdk_sock_group_create(void *ctx)
 {
@@ -584,6 +696,7 @@ spdk_sock_group_create(void *ctx)
 			TAILQ_INIT(&group_impl->socks);
 			group_impl->net_impl = impl;
 			group_impl->group = group;
+			sock_impl_get_metrics(impl);
 		}
 	}
 
@@ -711,6 +824,10 @@ sock_group_impl_poll_count(struct spdk_sock_group_impl *group_impl,
 	struct spdk_sock *socks[MAX_EVENTS_PER_POLL];
 	int num_events, i;
 
+	if (spdk_unlikely(group_impl->net_impl->metrics != NULL)) {
+		sock_group_impl_update_metrics(group_impl);
+	}
+
 	if (TAILQ_EMPTY(&group_impl->socks)) {
 		return 0;
 	}
@@ -762,10 +879,30 @@ spdk_sock_group_poll_count(struct spdk_sock_group *group, int max_events)
 	return num_events;
 }
 
+void
+spdk_sock_group_get_stats(struct spdk_sock_group *group, struct spdk_sock_group_stats *stats)
+{
+	struct spdk_sock_group_impl *group_impl;
+
+	memset(stats, 0, sizeof(*stats));
+
+	STAILQ_FOREACH(group_impl, &group->group_impls, link) {
+		stats->send_calls += group_impl->stats.send_calls;
+		stats->bytes_sent += group_impl->stats.bytes_sent;
+		stats->zcopy_notifications += group_impl->stats.zcopy_notifications;
+		stats->zcopy_completed_reqs += group_impl->stats.zcopy_completed_reqs;
+		stats->ktls_bytes_sent += group_impl->stats.ktls_bytes_sent;
+		stats->ktls_bytes_received += group_impl->stats.ktls_bytes_received;
+		stats->recv_calls += group_impl->stats.recv_calls;
+		stats->bytes_received += group_impl->stats.bytes_received;
+	}
+}
+
 int
 spdk_sock_group_close(struct spdk_sock_group **group)
 {
 	struct spdk_sock_group_impl *group_impl = NULL, *tmp;
+	struct spdk_net_impl *net_impl;
 	int rc;
 
 	if (*group == NULL) {
@@ -781,10 +918,15 @@ spdk_sock_group_close(struct spdk_sock_group **group)
 	}
 
 	STAILQ_FOREACH_SAFE(group_impl, &(*group)->group_impls, link, tmp) {
-		rc = group_impl->net_impl->group_impl_close(group_impl);
+		if (group_impl->net_impl->metrics != NULL) {
+			sock_group_impl_update_metrics(group_impl);
+		}
+		net_impl = group_impl->net_impl;
+		rc = net_impl->group_impl_close(group_impl);
 		if (rc != 0) {
 			SPDK_ERRLOG("group_impl_close for net failed\n");
 		}
+		sock_impl_put_metrics(net_impl);
 	}
 
 	free(*group);
@@ -897,6 +1039,8 @@ spdk_sock_write_config_json(struct spdk_json_write_ctx *w)
 			spdk_json_write_named_uint32(w, "zerocopy_threshold", opts.zerocopy_threshold);
 			spdk_json_write_named_uint32(w, "tls_version", opts.tls_version);
 			spdk_json_write_named_bool(w, "enable_ktls", opts.enable_ktls);
+			spdk_json_write_named_uint32(w, "busy_poll_usecs", opts.busy_poll_usecs);
+			spdk_json_write_named_uint32(w, "busy_poll_budget", opts.busy_poll_budget);
 			spdk_json_write_object_end(w);
 			spdk_json_write_object_end(w);
 		} else {
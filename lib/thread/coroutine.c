@@ -0,0 +1,250 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/coroutine.h"
+#include "spdk/log.h"
+#include "spdk/queue.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+
+#include <ucontext.h>
+
+/* Maximum number of coroutines (along with their stacks) kept for reuse */
+#define COROUTINE_POOL_SIZE	64
+
+struct spdk_coroutine {
+	ucontext_t			context;
+	/* Context of whoever started or resumed the coroutine */
+	ucontext_t			caller;
+	spdk_coroutine_fn		fn;
+	void				*ctx;
+	struct spdk_thread		*thread;
+	/* Used to resume the coroutine, so that waking it up can't fail due to lack of memory */
+	struct spdk_thread_msg		msg;
+	/* Mapping of the stack, which starts with a guard page */
+	void				*stack;
+	size_t				stack_size;
+	int				status;
+	bool				suspended;
+	bool				finished;
+	TAILQ_ENTRY(spdk_coroutine)	tailq;
+};
+
+static pthread_mutex_t g_coroutine_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static TAILQ_HEAD(, spdk_coroutine) g_coroutine_pool = TAILQ_HEAD_INITIALIZER(g_coroutine_pool);
+static uint32_t g_coroutine_pool_count;
+
+static __thread struct spdk_coroutine *tls_coroutine;
+
+static struct spdk_coroutine *
+coroutine_alloc(void)
+{
+	struct spdk_coroutine *co;
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	co = calloc(1, sizeof(*co));
+	if (co == NULL) {
+		return NULL;
+	}
+
+	co->stack_size = page_size + SPDK_COROUTINE_STACK_SIZE;
+	co->stack = mmap(NULL, co->stack_size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (co->stack == MAP_FAILED) {
+		free(co);
+		return NULL;
+	}
+
+	/* Catch stack overflows instead of silently corrupting memory */
+	if (mprotect(co->stack, page_size, PROT_NONE) != 0) {
+		munmap(co->stack, co->stack_size);
+		free(co);
+		return NULL;
+	}
+
+	return co;
+}
+
+static void
+coroutine_free(struct spdk_coroutine *co)
+{
+	munmap(co->stack, co->stack_size);
+	free(co);
+}
+
+static struct spdk_coroutine *
+coroutine_get(void)
+{
+	struct spdk_coroutine *co;
+
+	pthread_mutex_lock(&g_coroutine_pool_lock);
+	co = TAILQ_FIRST(&g_coroutine_pool);
+	if (co != NULL) {
+		TAILQ_REMOVE(&g_coroutine_pool, co, tailq);
+		g_coroutine_pool_count--;
+	}
+	pthread_mutex_unlock(&g_coroutine_pool_lock);
+
+	if (co == NULL) {
+		co = coroutine_alloc();
+	}
+
+	return co;
+}
+
+static void
+coroutine_put(struct spdk_coroutine *co)
+{
+	pthread_mutex_lock(&g_coroutine_pool_lock);
+	if (g_coroutine_pool_count < COROUTINE_POOL_SIZE) {
+		TAILQ_INSERT_HEAD(&g_coroutine_pool, co, tailq);
+		g_coroutine_pool_count++;
+		co = NULL;
+	}
+	pthread_mutex_unlock(&g_coroutine_pool_lock);
+
+	if (co != NULL) {
+		coroutine_free(co);
+	}
+}
+
+static void
+coroutine_entry(void)
+{
+	struct spdk_coroutine *co = tls_coroutine;
+
+	co->fn(co->ctx);
+	co->finished = true;
+
+	/* The stack isn't used after switching back, so it's safe to reuse the coroutine then */
+	setcontext(&co->caller);
+	SPDK_ERRLOG("Failed to switch out of a finished coroutine\n");
+	abort();
+}
+
+/* Switch to the coroutine until it finishes or suspends itself */
+static void
+coroutine_run(struct spdk_coroutine *co)
+{
+	struct spdk_coroutine *prev = tls_coroutine;
+
+	assert(co->thread == spdk_get_thread());
+
+	tls_coroutine = co;
+	co->suspended = false;
+	if (swapcontext(&co->caller, &co->context) != 0) {
+		SPDK_ERRLOG("Failed to switch to a coroutine: %s\n", spdk_strerror(errno));
+		abort();
+	}
+	tls_coroutine = prev;
+
+	if (co->finished) {
+		coroutine_put(co);
+	}
+}
+
+static void
+coroutine_resume(void *ctx)
+{
+	struct spdk_coroutine *co = ctx;
+
+	assert(co->suspended);
+	coroutine_run(co);
+}
+
+int
+spdk_coroutine_start(spdk_coroutine_fn fn, void *ctx)
+{
+	struct spdk_coroutine *co;
+	struct spdk_thread *thread;
+
+	thread = spdk_get_thread();
+	if (thread == NULL) {
+		SPDK_ERRLOG("Coroutines must be started from an SPDK thread\n");
+		return -EINVAL;
+	}
+
+	co = coroutine_get();
+	if (co == NULL) {
+		SPDK_ERRLOG("Failed to allocate a coroutine\n");
+		return -ENOMEM;
+	}
+
+	co->fn = fn;
+	co->ctx = ctx;
+	co->thread = thread;
+	co->status = 0;
+	co->finished = false;
+
+	if (getcontext(&co->context) != 0) {
+		SPDK_ERRLOG("Failed to get the coroutine context: %s\n", spdk_strerror(errno));
+		coroutine_put(co);
+		return -errno;
+	}
+
+	co->context.uc_stack.ss_sp = (char *)co->stack + co->stack_size - SPDK_COROUTINE_STACK_SIZE;
+	co->context.uc_stack.ss_size = SPDK_COROUTINE_STACK_SIZE;
+	co->context.uc_link = NULL;
+	makecontext(&co->context, coroutine_entry, 0);
+
+	coroutine_run(co);
+
+	return 0;
+}
+
+struct spdk_coroutine *
+spdk_coroutine_get_current(void)
+{
+	return tls_coroutine;
+}
+
+int
+spdk_coroutine_await(void)
+{
+	struct spdk_coroutine *co = tls_coroutine;
+
+	assert(co != NULL);
+
+	co->suspended = true;
+	if (swapcontext(&co->context, &co->caller) != 0) {
+		SPDK_ERRLOG("Failed to switch out of a coroutine: %s\n", spdk_strerror(errno));
+		abort();
+	}
+
+	return co->status;
+}
+
+void
+spdk_coroutine_wake(struct spdk_coroutine *co, int status)
+{
+	int rc;
+
+	co->status = status;
+	rc = spdk_thread_send_msg_embedded(co->thread, &co->msg, coroutine_resume, co);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to wake up a coroutine on thread %s\n",
+			    spdk_thread_get_name(co->thread));
+		assert(false);
+	}
+}
+
+void
+spdk_coroutine_wake_cb(void *cb_arg, int status)
+{
+	spdk_coroutine_wake(cb_arg, status);
+}
+
+void
+spdk_coroutine_yield(void)
+{
+	struct spdk_coroutine *co = tls_coroutine;
+
+	assert(co != NULL);
+
+	spdk_coroutine_wake(co, 0);
+	spdk_coroutine_await();
+}
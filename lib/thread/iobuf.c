@@ -7,6 +7,7 @@
 #include "spdk/util.h"
 #include "spdk/likely.h"
 #include "spdk/log.h"
+#include "spdk/metrics.h"
 #include "spdk/thread.h"
 
 #define IOBUF_MIN_SMALL_POOL_SIZE	64
@@ -26,21 +27,63 @@
 SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_buffer) <= IOBUF_MIN_SMALL_BUFSIZE,
 		   "Invalid data offset");
 
+/* Index of each buffer class within a node's pools, the medium classes follow the large one */
+#define IOBUF_POOL_SMALL		0
+#define IOBUF_POOL_LARGE		1
+#define IOBUF_POOL_MEDIUM		2
+#define IOBUF_NUM_POOLS			(IOBUF_POOL_MEDIUM + SPDK_IOBUF_MAX_MEDIUM_POOLS)
+#define IOBUF_MAX_NODES			8
+
 struct iobuf_channel {
 	spdk_iobuf_entry_stailq_t small_queue;
 	spdk_iobuf_entry_stailq_t large_queue;
+	spdk_iobuf_entry_stailq_t medium_queue[SPDK_IOBUF_MAX_MEDIUM_POOLS];
+	TAILQ_HEAD(, spdk_iobuf_channel) channels;
+	/* Index of the NUMA node local to the thread owning the channel */
+	uint32_t node;
 };
 
 struct iobuf_module {
 	char				*name;
+	struct spdk_metrics_group	*metrics;
 	TAILQ_ENTRY(iobuf_module)	tailq;
 };
 
+enum iobuf_metric {
+	IOBUF_METRIC_CACHE,
+	IOBUF_METRIC_MAIN,
+	IOBUF_METRIC_RETRY,
+};
+
+static const struct spdk_metric_desc g_iobuf_metrics[] = {
+	[IOBUF_METRIC_CACHE] = {
+		"spdk_iobuf_cache", "Buffers retrieved from the channels' caches",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+	[IOBUF_METRIC_MAIN] = {
+		"spdk_iobuf_main", "Batches of buffers retrieved from the global pools",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+	[IOBUF_METRIC_RETRY] = {
+		"spdk_iobuf_retry", "Requests that had to wait for a buffer",
+		SPDK_METRIC_TYPE_COUNTER,
+	},
+};
+
+struct iobuf_node_pool {
+	struct spdk_ring		*ring;
+	void				*base;
+};
+
+struct iobuf_node {
+	int32_t				socket_id;
+	struct iobuf_node_pool		pools[IOBUF_NUM_POOLS];
+};
+
 struct iobuf {
-	struct spdk_ring		*small_pool;
-	struct spdk_ring		*large_pool;
-	void				*small_pool_base;
-	void				*large_pool_base;
+	struct iobuf_node		nodes[IOBUF_MAX_NODES];
+	uint32_t			num_nodes;
+	uint32_t			num_medium;
 	struct spdk_iobuf_opts		opts;
 	TAILQ_HEAD(, iobuf_module)	modules;
 	spdk_iobuf_finish_cb		finish_cb;
@@ -49,10 +92,6 @@ struct iobuf {
 
 static struct iobuf g_iobuf = {
 	.modules = TAILQ_HEAD_INITIALIZER(g_iobuf.modules),
-	.small_pool = NULL,
-	.large_pool = NULL,
-	.small_pool_base = NULL,
-	.large_pool_base = NULL,
 	.opts = {
 		.small_pool_count = IOBUF_DEFAULT_SMALL_POOL_SIZE,
 		.large_pool_count = IOBUF_DEFAULT_LARGE_POOL_SIZE,
@@ -61,13 +100,93 @@ static struct iobuf g_iobuf = {
 	},
 };
 
+static const char *
+iobuf_pool_name(uint32_t idx)
+{
+	switch (idx) {
+	case IOBUF_POOL_SMALL:
+		return "small";
+	case IOBUF_POOL_LARGE:
+		return "large";
+	default:
+		return "medium";
+	}
+}
+
+static uint32_t
+iobuf_pool_bufsize(uint32_t idx)
+{
+	switch (idx) {
+	case IOBUF_POOL_SMALL:
+		return g_iobuf.opts.small_bufsize;
+	case IOBUF_POOL_LARGE:
+		return g_iobuf.opts.large_bufsize;
+	default:
+		return g_iobuf.opts.medium_bufsize[idx - IOBUF_POOL_MEDIUM];
+	}
+}
+
+/* Number of buffers of a given class allocated on each node */
+static uint64_t
+iobuf_pool_node_count(uint32_t idx)
+{
+	uint64_t count;
+
+	switch (idx) {
+	case IOBUF_POOL_SMALL:
+		count = g_iobuf.opts.small_pool_count;
+		break;
+	case IOBUF_POOL_LARGE:
+		count = g_iobuf.opts.large_pool_count;
+		break;
+	default:
+		count = g_iobuf.opts.medium_pool_count[idx - IOBUF_POOL_MEDIUM];
+		break;
+	}
+
+	return SPDK_CEIL_DIV(count, g_iobuf.num_nodes);
+}
+
+static uint32_t
+iobuf_pool_index(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool)
+{
+	if (pool == &ch->small) {
+		return IOBUF_POOL_SMALL;
+	} else if (pool == &ch->large) {
+		return IOBUF_POOL_LARGE;
+	}
+
+	return IOBUF_POOL_MEDIUM + (pool - ch->medium);
+}
+
+static uint32_t
+iobuf_get_socket_node(int32_t socket_id)
+{
+	uint32_t i;
+
+	for (i = 0; i < g_iobuf.num_nodes; i++) {
+		if (g_iobuf.nodes[i].socket_id == socket_id) {
+			return i;
+		}
+	}
+
+	/* Threads running outside of any of the app's sockets use the first node */
+	return 0;
+}
+
 static int
 iobuf_channel_create_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch = ctx;
+	uint32_t i;
 
 	STAILQ_INIT(&ch->small_queue);
 	STAILQ_INIT(&ch->large_queue);
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_POOLS; i++) {
+		STAILQ_INIT(&ch->medium_queue[i]);
+	}
+	TAILQ_INIT(&ch->channels);
+	ch->node = iobuf_get_socket_node(spdk_env_get_socket_id(spdk_env_get_current_core()));
 
 	return 0;
 }
@@ -76,63 +195,145 @@ static void
 iobuf_channel_destroy_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch __attribute__((unused)) = ctx;
+	uint32_t i __attribute__((unused));
 
 	assert(STAILQ_EMPTY(&ch->small_queue));
 	assert(STAILQ_EMPTY(&ch->large_queue));
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_POOLS; i++) {
+		assert(STAILQ_EMPTY(&ch->medium_queue[i]));
+	}
+	assert(TAILQ_EMPTY(&ch->channels));
 }
 
-int
-spdk_iobuf_initialize(void)
+static uint32_t
+iobuf_get_num_medium(const struct spdk_iobuf_opts *opts)
 {
-	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
-	int rc = 0;
-	uint64_t i;
+	uint32_t i;
+
+	for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_POOLS; i++) {
+		if (opts->medium_pool_count[i] == 0) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+/* Find the NUMA nodes of the cores the app is running on, each one gets its own set of pools */
+static void
+iobuf_init_nodes(void)
+{
+	int32_t socket_id;
+	uint32_t core, i;
+
+	g_iobuf.num_nodes = 0;
+	SPDK_ENV_FOREACH_CORE(core) {
+		socket_id = (int32_t)spdk_env_get_socket_id(core);
+		if (socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+			continue;
+		}
+
+		for (i = 0; i < g_iobuf.num_nodes; i++) {
+			if (g_iobuf.nodes[i].socket_id == socket_id) {
+				break;
+			}
+		}
+
+		if (i == g_iobuf.num_nodes && g_iobuf.num_nodes < IOBUF_MAX_NODES) {
+			g_iobuf.nodes[g_iobuf.num_nodes++].socket_id = socket_id;
+		}
+	}
+
+	if (g_iobuf.num_nodes == 0) {
+		g_iobuf.nodes[0].socket_id = SPDK_ENV_SOCKET_ID_ANY;
+		g_iobuf.num_nodes = 1;
+	}
+}
+
+static int
+iobuf_pool_create(struct iobuf_node *node, uint32_t idx)
+{
+	struct iobuf_node_pool *pool = &node->pools[idx];
 	struct spdk_iobuf_buffer *buf;
+	uint64_t i, count = iobuf_pool_node_count(idx);
+	uint32_t bufsize = iobuf_pool_bufsize(idx);
 
-	g_iobuf.small_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->small_pool_count,
-					      SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.small_pool) {
-		SPDK_ERRLOG("Failed to create small iobuf pool\n");
-		rc = -ENOMEM;
-		goto error;
+	pool->ring = spdk_ring_create(SPDK_RING_TYPE_MP_MC, count, node->socket_id);
+	if (pool->ring == NULL) {
+		SPDK_ERRLOG("Failed to create %s iobuf pool on socket %"PRId32"\n",
+			    iobuf_pool_name(idx), node->socket_id);
+		return -ENOMEM;
 	}
 
-	/* Round up to the nearest alignment so that each element remains aligned */
-	opts->small_bufsize = SPDK_ALIGN_CEIL(opts->small_bufsize, IOBUF_ALIGNMENT);
-	g_iobuf.small_pool_base = spdk_malloc(opts->small_bufsize * opts->small_pool_count, IOBUF_ALIGNMENT,
-					      NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (g_iobuf.small_pool_base == NULL) {
-		SPDK_ERRLOG("Unable to allocate requested small iobuf pool size\n");
-		rc = -ENOMEM;
-		goto error;
+	pool->base = spdk_malloc(bufsize * count, IOBUF_ALIGNMENT, NULL, node->socket_id,
+				 SPDK_MALLOC_DMA);
+	if (pool->base == NULL) {
+		SPDK_ERRLOG("Unable to allocate requested %s iobuf pool size on socket %"PRId32"\n",
+			    iobuf_pool_name(idx), node->socket_id);
+		return -ENOMEM;
 	}
 
-	g_iobuf.large_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->large_pool_count,
-					      SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.large_pool) {
-		SPDK_ERRLOG("Failed to create large iobuf pool\n");
-		rc = -ENOMEM;
-		goto error;
+	for (i = 0; i < count; i++) {
+		buf = pool->base + i * bufsize;
+		spdk_ring_enqueue(pool->ring, (void **)&buf, 1, NULL);
 	}
 
-	/* Round up to the nearest alignment so that each element remains aligned */
-	opts->large_bufsize = SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT);
-	g_iobuf.large_pool_base = spdk_malloc(opts->large_bufsize * opts->large_pool_count, IOBUF_ALIGNMENT,
-					      NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (g_iobuf.large_pool_base == NULL) {
-		SPDK_ERRLOG("Unable to allocate requested large iobuf pool size\n");
-		rc = -ENOMEM;
-		goto error;
+	return 0;
+}
+
+static void
+iobuf_pool_free(struct iobuf_node *node, uint32_t idx)
+{
+	struct iobuf_node_pool *pool = &node->pools[idx];
+	uint64_t count = iobuf_pool_node_count(idx);
+
+	if (pool->ring != NULL && spdk_ring_count(pool->ring) != count) {
+		SPDK_ERRLOG("%s iobuf pool count is %zu, expected %"PRIu64"\n",
+			    iobuf_pool_name(idx), spdk_ring_count(pool->ring), count);
 	}
 
-	for (i = 0; i < opts->small_pool_count; i++) {
-		buf = g_iobuf.small_pool_base + i * opts->small_bufsize;
-		spdk_ring_enqueue(g_iobuf.small_pool, (void **)&buf, 1, NULL);
+	spdk_free(pool->base);
+	pool->base = NULL;
+	spdk_ring_free(pool->ring);
+	pool->ring = NULL;
+}
+
+static void
+iobuf_free_pools(void)
+{
+	uint32_t i, idx;
+
+	for (i = 0; i < g_iobuf.num_nodes; i++) {
+		for (idx = 0; idx < IOBUF_POOL_MEDIUM + g_iobuf.num_medium; idx++) {
+			iobuf_pool_free(&g_iobuf.nodes[i], idx);
+		}
+	}
+	g_iobuf.num_medium = 0;
+}
+
+int
+spdk_iobuf_initialize(void)
+{
+	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
+	int rc = 0;
+	uint32_t i, idx;
+
+	/* Round up to the nearest alignment so that each element remains aligned */
+	opts->small_bufsize = SPDK_ALIGN_CEIL(opts->small_bufsize, IOBUF_ALIGNMENT);
+	opts->large_bufsize = SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT);
+	g_iobuf.num_medium = iobuf_get_num_medium(opts);
+	for (i = 0; i < g_iobuf.num_medium; i++) {
+		opts->medium_bufsize[i] = SPDK_ALIGN_CEIL(opts->medium_bufsize[i], IOBUF_ALIGNMENT);
 	}
 
-	for (i = 0; i < opts->large_pool_count; i++) {
-		buf = g_iobuf.large_pool_base + i * opts->large_bufsize;
-		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
+	iobuf_init_nodes();
+	for (i = 0; i < g_iobuf.num_nodes; i++) {
+		for (idx = 0; idx < IOBUF_POOL_MEDIUM + g_iobuf.num_medium; idx++) {
+			rc = iobuf_pool_create(&g_iobuf.nodes[i], idx);
+			if (rc != 0) {
+				goto error;
+			}
+		}
 	}
 
 	spdk_io_device_register(&g_iobuf, iobuf_channel_create_cb, iobuf_channel_destroy_cb,
@@ -140,10 +341,7 @@ spdk_iobuf_initialize(void)
 
 	return 0;
 error:
-	spdk_free(g_iobuf.small_pool_base);
-	spdk_ring_free(g_iobuf.small_pool);
-	spdk_free(g_iobuf.large_pool_base);
-	spdk_ring_free(g_iobuf.large_pool);
+	iobuf_free_pools();
 
 	return rc;
 }
@@ -156,29 +354,12 @@ iobuf_unregister_cb(void *io_device)
 	while (!TAILQ_EMPTY(&g_iobuf.modules)) {
 		module = TAILQ_FIRST(&g_iobuf.modules);
 		TAILQ_REMOVE(&g_iobuf.modules, module, tailq);
+		spdk_metrics_group_unregister(module->metrics);
 		free(module->name);
 		free(module);
 	}
 
-	if (spdk_ring_count(g_iobuf.small_pool) != g_iobuf.opts.small_pool_count) {
-		SPDK_ERRLOG("small iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_ring_count(g_iobuf.small_pool), g_iobuf.opts.small_pool_count);
-	}
-
-	if (spdk_ring_count(g_iobuf.large_pool) != g_iobuf.opts.large_pool_count) {
-		SPDK_ERRLOG("large iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_ring_count(g_iobuf.large_pool), g_iobuf.opts.large_pool_count);
-	}
-
-	spdk_free(g_iobuf.small_pool_base);
-	g_iobuf.small_pool_base = NULL;
-	spdk_ring_free(g_iobuf.small_pool);
-	g_iobuf.small_pool = NULL;
-
-	spdk_free(g_iobuf.large_pool_base);
-	g_iobuf.large_pool_base = NULL;
-	spdk_ring_free(g_iobuf.large_pool);
-	g_iobuf.large_pool = NULL;
+	iobuf_free_pools();
 
 	if (g_iobuf.finish_cb != NULL) {
 		g_iobuf.finish_cb(g_iobuf.finish_arg);
@@ -197,6 +378,8 @@ spdk_iobuf_finish(spdk_iobuf_finish_cb cb_fn, void *cb_arg)
 int
 spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 {
+	uint32_t i, num_medium, bufsize, prev_bufsize, max_bufsize;
+
 	if (opts->small_pool_count < IOBUF_MIN_SMALL_POOL_SIZE) {
 		SPDK_ERRLOG("small_pool_count must be at least %" PRIu32 "\n",
 			    IOBUF_MIN_SMALL_POOL_SIZE);
@@ -208,6 +391,22 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 		return -EINVAL;
 	}
 
+	num_medium = iobuf_get_num_medium(opts);
+	prev_bufsize = SPDK_ALIGN_CEIL(spdk_max(opts->small_bufsize, IOBUF_MIN_SMALL_BUFSIZE),
+				       IOBUF_ALIGNMENT);
+	max_bufsize = SPDK_ALIGN_CEIL(spdk_max(opts->large_bufsize, IOBUF_MIN_LARGE_BUFSIZE),
+				      IOBUF_ALIGNMENT);
+	for (i = 0; i < num_medium; i++) {
+		bufsize = SPDK_ALIGN_CEIL(opts->medium_bufsize[i], IOBUF_ALIGNMENT);
+		if (bufsize <= prev_bufsize || bufsize >= max_bufsize) {
+			SPDK_ERRLOG("medium_bufsize[%"PRIu32"] (%"PRIu32") must be larger than the "
+				    "previous buffer size and smaller than large_bufsize\n",
+				    i, opts->medium_bufsize[i]);
+			return -EINVAL;
+		}
+		prev_bufsize = bufsize;
+	}
+
 	g_iobuf.opts = *opts;
 
 	if (opts->small_bufsize < IOBUF_MIN_SMALL_BUFSIZE) {
@@ -222,6 +421,12 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 		g_iobuf.opts.large_bufsize = IOBUF_MIN_LARGE_BUFSIZE;
 	}
 
+	/* Clear the classes following the first disabled one, so they're not reported back */
+	for (i = num_medium; i < SPDK_IOBUF_MAX_MEDIUM_POOLS; i++) {
+		g_iobuf.opts.medium_pool_count[i] = 0;
+		g_iobuf.opts.medium_bufsize[i] = 0;
+	}
+
 	return 0;
 }
 
@@ -231,6 +436,164 @@ spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts)
 	*opts = g_iobuf.opts;
 }
 
+int
+spdk_iobuf_get_pool_regions(struct iovec *iovs, int iovcnt)
+{
+	struct iobuf_node_pool *pool;
+	int count = 0;
+	uint32_t i, idx;
+
+	for (i = 0; i < g_iobuf.num_nodes; i++) {
+		for (idx = 0; idx < IOBUF_POOL_MEDIUM + g_iobuf.num_medium; idx++) {
+			pool = &g_iobuf.nodes[i].pools[idx];
+			if (count >= iovcnt || pool->base == NULL) {
+				continue;
+			}
+
+			iovs[count].iov_base = pool->base;
+			iovs[count].iov_len = iobuf_pool_bufsize(idx) * iobuf_pool_node_count(idx);
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/* Dequeue buffers from the channel's local node, falling back to the remote ones once it's
+ * exhausted */
+static size_t
+iobuf_pool_dequeue(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool, void **bufs,
+		   size_t count)
+{
+	struct iobuf_channel *iobuf_ch;
+	uint32_t i, idx, node;
+	size_t sz;
+
+	sz = spdk_ring_dequeue(pool->pool, bufs, count);
+	if (spdk_likely(sz > 0 || g_iobuf.num_nodes == 1)) {
+		return sz;
+	}
+
+	iobuf_ch = spdk_io_channel_get_ctx(ch->parent);
+	idx = iobuf_pool_index(ch, pool);
+	for (i = 1; i < g_iobuf.num_nodes; i++) {
+		node = (iobuf_ch->node + i) % g_iobuf.num_nodes;
+		sz = spdk_ring_dequeue(g_iobuf.nodes[node].pools[idx].ring, bufs, count);
+		if (sz > 0) {
+			pool->stats.remote += sz;
+			break;
+		}
+	}
+
+	return sz;
+}
+
+static uint32_t
+iobuf_get_buf_node(uint32_t idx, void *buf)
+{
+	uint64_t size = iobuf_pool_bufsize(idx) * iobuf_pool_node_count(idx);
+	void *base;
+	uint32_t i;
+
+	for (i = 0; i < g_iobuf.num_nodes; i++) {
+		base = g_iobuf.nodes[i].pools[idx].base;
+		if (buf >= base && buf < base + size) {
+			return i;
+		}
+	}
+
+	assert(0 && "buffer doesn't belong to any of the pools");
+	return 0;
+}
+
+/* Return buffers to the pools of the nodes they were allocated from */
+static void
+iobuf_pool_enqueue(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool, void **bufs,
+		   size_t count)
+{
+	struct iobuf_channel *iobuf_ch;
+	uint32_t idx, node;
+	size_t i, num_local = 0;
+
+	if (spdk_likely(g_iobuf.num_nodes == 1)) {
+		spdk_ring_enqueue(pool->pool, bufs, count, NULL);
+		return;
+	}
+
+	iobuf_ch = spdk_io_channel_get_ctx(ch->parent);
+	idx = iobuf_pool_index(ch, pool);
+	for (i = 0; i < count; i++) {
+		node = iobuf_get_buf_node(idx, bufs[i]);
+		if (node == iobuf_ch->node) {
+			bufs[num_local++] = bufs[i];
+		} else {
+			spdk_ring_enqueue(g_iobuf.nodes[node].pools[idx].ring, &bufs[i], 1, NULL);
+		}
+	}
+
+	if (num_local > 0) {
+		spdk_ring_enqueue(pool->pool, bufs, num_local, NULL);
+	}
+}
+
+static void
+iobuf_channel_pool_init(struct spdk_iobuf_pool *pool, struct spdk_ring *ring,
+			spdk_iobuf_entry_stailq_t *queue, uint32_t bufsize, uint32_t cache_size)
+{
+	pool->pool = ring;
+	pool->queue = queue;
+	pool->bufsize = bufsize;
+	pool->cache_size = cache_size;
+	pool->cache_count = 0;
+	memset(&pool->stats, 0, sizeof(pool->stats));
+	STAILQ_INIT(&pool->cache);
+}
+
+static int
+iobuf_channel_pool_fill(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool,
+			const char *name, const char *opt, uint64_t pool_count)
+{
+	struct spdk_iobuf_buffer *buf;
+	uint32_t i;
+
+	for (i = 0; i < pool->cache_size; ++i) {
+		if (iobuf_pool_dequeue(ch, pool, (void **)&buf, 1) == 0) {
+			SPDK_ERRLOG("Failed to populate iobuf %s buffer cache. "
+				    "You may need to increase spdk_iobuf_opts.%s (%"PRIu64")\n",
+				    name, opt, pool_count);
+			SPDK_ERRLOG("See scripts/calc-iobuf.py for guidance on how to calculate "
+				    "this value.\n");
+			return -ENOMEM;
+		}
+		STAILQ_INSERT_TAIL(&pool->cache, buf, stailq);
+		pool->cache_count++;
+	}
+
+	return 0;
+}
+
+static void
+iobuf_channel_pool_release(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool)
+{
+	struct spdk_iobuf_entry *entry __attribute__((unused));
+	struct spdk_iobuf_buffer *buf;
+
+	/* Make sure none of the wait queue entries are coming from this module */
+	STAILQ_FOREACH(entry, pool->queue, stailq) {
+		assert(entry->module != ch->module);
+	}
+
+	/* Release cached buffers back to the pool */
+	while (!STAILQ_EMPTY(&pool->cache)) {
+		buf = STAILQ_FIRST(&pool->cache);
+		STAILQ_REMOVE_HEAD(&pool->cache, stailq);
+		iobuf_pool_enqueue(ch, pool, (void **)&buf, 1);
+		pool->cache_count--;
+	}
+
+	assert(pool->cache_count == 0);
+}
+
 int
 spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 			uint32_t small_cache_size, uint32_t large_cache_size)
@@ -238,8 +601,10 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	struct spdk_io_channel *ioch;
 	struct iobuf_channel *iobuf_ch;
 	struct iobuf_module *module;
-	struct spdk_iobuf_buffer *buf;
+	struct iobuf_node *node;
+	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
 	uint32_t i;
+	int rc;
 
 	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
 		if (strcmp(name, module->name) == 0) {
@@ -259,85 +624,62 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	}
 
 	iobuf_ch = spdk_io_channel_get_ctx(ioch);
+	node = &g_iobuf.nodes[iobuf_ch->node];
 
-	ch->small.queue = &iobuf_ch->small_queue;
-	ch->large.queue = &iobuf_ch->large_queue;
-	ch->small.pool = g_iobuf.small_pool;
-	ch->large.pool = g_iobuf.large_pool;
-	ch->small.bufsize = g_iobuf.opts.small_bufsize;
-	ch->large.bufsize = g_iobuf.opts.large_bufsize;
 	ch->parent = ioch;
 	ch->module = module;
-	ch->small.cache_size = small_cache_size;
-	ch->large.cache_size = large_cache_size;
-	ch->small.cache_count = 0;
-	ch->large.cache_count = 0;
-
-	STAILQ_INIT(&ch->small.cache);
-	STAILQ_INIT(&ch->large.cache);
-
-	for (i = 0; i < small_cache_size; ++i) {
-		if (spdk_ring_dequeue(g_iobuf.small_pool, (void **)&buf, 1) == 0) {
-			SPDK_ERRLOG("Failed to populate iobuf small buffer cache. "
-				    "You may need to increase spdk_iobuf_opts.small_pool_count (%"PRIu64")\n",
-				    g_iobuf.opts.small_pool_count);
-			SPDK_ERRLOG("See scripts/calc-iobuf.py for guidance on how to calculate "
-				    "this value.\n");
-			goto error;
-		}
-		STAILQ_INSERT_TAIL(&ch->small.cache, buf, stailq);
-		ch->small.cache_count++;
-	}
-	for (i = 0; i < large_cache_size; ++i) {
-		if (spdk_ring_dequeue(g_iobuf.large_pool, (void **)&buf, 1) == 0) {
-			SPDK_ERRLOG("Failed to populate iobuf large buffer cache. "
-				    "You may need to increase spdk_iobuf_opts.large_pool_count (%"PRIu64")\n",
-				    g_iobuf.opts.large_pool_count);
-			SPDK_ERRLOG("See scripts/calc-iobuf.py for guidance on how to calculate "
-				    "this value.\n");
+	ch->num_medium = g_iobuf.num_medium;
+
+	iobuf_channel_pool_init(&ch->small, node->pools[IOBUF_POOL_SMALL].ring,
+				&iobuf_ch->small_queue, opts->small_bufsize, small_cache_size);
+	iobuf_channel_pool_init(&ch->large, node->pools[IOBUF_POOL_LARGE].ring,
+				&iobuf_ch->large_queue, opts->large_bufsize, large_cache_size);
+	for (i = 0; i < ch->num_medium; i++) {
+		iobuf_channel_pool_init(&ch->medium[i], node->pools[IOBUF_POOL_MEDIUM + i].ring,
+					&iobuf_ch->medium_queue[i], opts->medium_bufsize[i],
+					large_cache_size);
+	}
+
+	TAILQ_INSERT_TAIL(&iobuf_ch->channels, ch, tailq);
+
+	rc = iobuf_channel_pool_fill(ch, &ch->small, "small", "small_pool_count",
+				     opts->small_pool_count);
+	if (rc != 0) {
+		goto error;
+	}
+	rc = iobuf_channel_pool_fill(ch, &ch->large, "large", "large_pool_count",
+				     opts->large_pool_count);
+	if (rc != 0) {
+		goto error;
+	}
+	for (i = 0; i < ch->num_medium; i++) {
+		rc = iobuf_channel_pool_fill(ch, &ch->medium[i], "medium", "medium_pool_count",
+					     opts->medium_pool_count[i]);
+		if (rc != 0) {
 			goto error;
 		}
-		STAILQ_INSERT_TAIL(&ch->large.cache, buf, stailq);
-		ch->large.cache_count++;
 	}
 
 	return 0;
 error:
 	spdk_iobuf_channel_fini(ch);
 
-	return -ENOMEM;
+	return rc;
 }
 
 void
 spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch)
 {
-	struct spdk_iobuf_entry *entry __attribute__((unused));
-	struct spdk_iobuf_buffer *buf;
+	struct iobuf_channel *iobuf_ch = spdk_io_channel_get_ctx(ch->parent);
+	uint32_t i;
 
-	/* Make sure none of the wait queue entries are coming from this module */
-	STAILQ_FOREACH(entry, ch->small.queue, stailq) {
-		assert(entry->module != ch->module);
-	}
-	STAILQ_FOREACH(entry, ch->large.queue, stailq) {
-		assert(entry->module != ch->module);
+	iobuf_channel_pool_release(ch, &ch->small);
+	iobuf_channel_pool_release(ch, &ch->large);
+	for (i = 0; i < ch->num_medium; i++) {
+		iobuf_channel_pool_release(ch, &ch->medium[i]);
 	}
 
-	/* Release cached buffers back to the pool */
-	while (!STAILQ_EMPTY(&ch->small.cache)) {
-		buf = STAILQ_FIRST(&ch->small.cache);
-		STAILQ_REMOVE_HEAD(&ch->small.cache, stailq);
-		spdk_ring_enqueue(g_iobuf.small_pool, (void **)&buf, 1, NULL);
-		ch->small.cache_count--;
-	}
-	while (!STAILQ_EMPTY(&ch->large.cache)) {
-		buf = STAILQ_FIRST(&ch->large.cache);
-		STAILQ_REMOVE_HEAD(&ch->large.cache, stailq);
-		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
-		ch->large.cache_count--;
-	}
-
-	assert(ch->small.cache_count == 0);
-	assert(ch->large.cache_count == 0);
+	TAILQ_REMOVE(&iobuf_ch->channels, ch, tailq);
 
 	spdk_put_io_channel(ch->parent);
 	ch->parent = NULL;
@@ -365,6 +707,8 @@ spdk_iobuf_register_module(const char *name)
 		return -ENOMEM;
 	}
 
+	module->metrics = spdk_metrics_group_register(g_iobuf_metrics,
+			  SPDK_COUNTOF(g_iobuf_metrics), "module", name);
 	TAILQ_INSERT_TAIL(&g_iobuf.modules, module, tailq);
 
 	return 0;
@@ -378,6 +722,7 @@ spdk_iobuf_unregister_module(const char *name)
 	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
 		if (strcmp(name, module->name) == 0) {
 			TAILQ_REMOVE(&g_iobuf.modules, module, tailq);
+			spdk_metrics_group_unregister(module->metrics);
 			free(module->name);
 			free(module);
 			return 0;
@@ -409,24 +754,47 @@ spdk_iobuf_for_each_entry(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool
 	return 0;
 }
 
-void
-spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entry,
-		       uint64_t len)
+/* Select the pool with the smallest buffer size that can fit len */
+static inline struct spdk_iobuf_pool *
+iobuf_get_pool(struct spdk_iobuf_channel *ch, uint64_t len)
 {
-	struct spdk_iobuf_pool *pool;
+	uint32_t i;
 
 	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
+		return &ch->small;
+	}
+
+	for (i = 0; i < ch->num_medium; i++) {
+		if (len <= ch->medium[i].bufsize) {
+			return &ch->medium[i];
+		}
 	}
 
+	assert(len <= ch->large.bufsize);
+	return &ch->large;
+}
+
+void
+spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entry,
+		       uint64_t len)
+{
+	struct spdk_iobuf_pool *pool = iobuf_get_pool(ch, len);
+
 	STAILQ_REMOVE(pool->queue, entry, spdk_iobuf_entry, stailq);
 }
 
 #define IOBUF_BATCH_SIZE 32
 
+static inline void
+iobuf_update_metrics(struct spdk_iobuf_channel *ch, enum iobuf_metric metric)
+{
+	const struct iobuf_module *module = ch->module;
+
+	if (spdk_unlikely(module->metrics != NULL)) {
+		spdk_metrics_counter_add(module->metrics, metric, 1);
+	}
+}
+
 void *
 spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 	       struct spdk_iobuf_entry *entry, spdk_iobuf_get_cb cb_fn)
@@ -435,35 +803,39 @@ spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 	void *buf;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
-	}
+	pool = iobuf_get_pool(ch, len);
 
 	buf = (void *)STAILQ_FIRST(&pool->cache);
 	if (buf) {
 		STAILQ_REMOVE_HEAD(&pool->cache, stailq);
 		assert(pool->cache_count > 0);
 		pool->cache_count--;
+		pool->stats.cache++;
+		iobuf_update_metrics(ch, IOBUF_METRIC_CACHE);
 	} else {
 		struct spdk_iobuf_buffer *bufs[IOBUF_BATCH_SIZE];
 		size_t sz, i;
 
 		/* If we're going to dequeue, we may as well dequeue a batch. */
-		sz = spdk_ring_dequeue(pool->pool, (void **)bufs, spdk_min(IOBUF_BATCH_SIZE,
-				       spdk_max(pool->cache_size, 1)));
+		sz = iobuf_pool_dequeue(ch, pool, (void **)bufs, spdk_min(IOBUF_BATCH_SIZE,
+					spdk_max(pool->cache_size, 1)));
 		if (sz == 0) {
 			if (entry) {
 				STAILQ_INSERT_TAIL(pool->queue, entry, stailq);
 				entry->module = ch->module;
 				entry->cb_fn = cb_fn;
+				entry->stats = &pool->stats;
+				entry->tsc = spdk_get_ticks();
+				pool->stats.retry++;
+				iobuf_update_metrics(ch, IOBUF_METRIC_RETRY);
 			}
 
 			return NULL;
 		}
 
+		pool->stats.main++;
+		iobuf_update_metrics(ch, IOBUF_METRIC_MAIN);
+
 		for (i = 0; i < (sz - 1); i++) {
 			STAILQ_INSERT_HEAD(&pool->cache, bufs[i], stailq);
 			pool->cache_count++;
@@ -473,6 +845,8 @@ spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 		buf = bufs[i];
 	}
 
+	pool->stats.outstanding++;
+
 	return (char *)buf;
 }
 
@@ -485,15 +859,12 @@ spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 	size_t sz;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		pool = &ch->large;
-	}
+	pool = iobuf_get_pool(ch, len);
+	pool->stats.outstanding--;
 
 	if (STAILQ_EMPTY(pool->queue)) {
 		if (pool->cache_size == 0) {
-			spdk_ring_enqueue(pool->pool, (void **)&buf, 1, NULL);
+			iobuf_pool_enqueue(ch, pool, (void **)&buf, 1);
 			return;
 		}
 
@@ -517,11 +888,109 @@ spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 				pool->cache_count--;
 			}
 
-			spdk_ring_enqueue(pool->pool, (void **)bufs, sz, NULL);
+			iobuf_pool_enqueue(ch, pool, (void **)bufs, sz);
 		}
 	} else {
 		entry = STAILQ_FIRST(pool->queue);
 		STAILQ_REMOVE_HEAD(pool->queue, stailq);
+		entry->stats->outstanding++;
+		entry->stats->wait_ticks += spdk_get_ticks() - entry->tsc;
 		entry->cb_fn(entry, buf);
 	}
 }
+
+struct iobuf_get_stats_ctx {
+	struct spdk_iobuf_module_stats	*modules;
+	uint32_t			num_modules;
+	spdk_iobuf_get_stats_cb		cb_fn;
+	void				*cb_arg;
+};
+
+static void
+iobuf_add_pool_stats(struct spdk_iobuf_pool_stats *stats, const struct spdk_iobuf_pool *pool)
+{
+	stats->cache += pool->stats.cache;
+	stats->main += pool->stats.main;
+	stats->retry += pool->stats.retry;
+	stats->remote += pool->stats.remote;
+	stats->outstanding += pool->stats.outstanding;
+	stats->wait_ticks += pool->stats.wait_ticks;
+}
+
+static void
+iobuf_get_channel_stats_done(struct spdk_io_channel_iter *iter, int status)
+{
+	struct iobuf_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(iter);
+
+	ctx->cb_fn(ctx->modules, ctx->num_modules, ctx->cb_arg);
+	free(ctx->modules);
+	free(ctx);
+}
+
+static void
+iobuf_get_channel_stats(struct spdk_io_channel_iter *iter)
+{
+	struct iobuf_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(iter);
+	struct spdk_io_channel *ioch = spdk_io_channel_iter_get_channel(iter);
+	struct iobuf_channel *iobuf_ch = spdk_io_channel_get_ctx(ioch);
+	struct spdk_iobuf_module_stats *stats;
+	struct spdk_iobuf_channel *ch;
+	const struct iobuf_module *module;
+	uint32_t i, j;
+
+	TAILQ_FOREACH(ch, &iobuf_ch->channels, tailq) {
+		module = ch->module;
+		for (i = 0; i < ctx->num_modules; i++) {
+			stats = &ctx->modules[i];
+			if (stats->module != module->name) {
+				continue;
+			}
+
+			iobuf_add_pool_stats(&stats->small_pool, &ch->small);
+			iobuf_add_pool_stats(&stats->large_pool, &ch->large);
+			for (j = 0; j < ch->num_medium; j++) {
+				iobuf_add_pool_stats(&stats->medium_pool[j], &ch->medium[j]);
+			}
+			break;
+		}
+	}
+
+	spdk_for_each_channel_continue(iter, 0);
+}
+
+int
+spdk_iobuf_get_stats(spdk_iobuf_get_stats_cb cb_fn, void *cb_arg)
+{
+	struct iobuf_get_stats_ctx *ctx;
+	struct iobuf_module *module;
+	uint32_t i;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
+		ctx->num_modules++;
+	}
+
+	ctx->modules = calloc(ctx->num_modules, sizeof(struct spdk_iobuf_module_stats));
+	if (ctx->modules == NULL) {
+		free(ctx);
+		return -ENOMEM;
+	}
+
+	i = 0;
+	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
+		ctx->modules[i].module = module->name;
+		ctx->modules[i].num_medium = g_iobuf.num_medium;
+		i++;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_for_each_channel(&g_iobuf, iobuf_get_channel_stats, ctx,
+			      iobuf_get_channel_stats_done);
+	return 0;
+}
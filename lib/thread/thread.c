@@ -14,6 +14,7 @@
 #include "spdk/trace.h"
 #include "spdk/util.h"
 #include "spdk/fd_group.h"
+#include "spdk/histogram_data.h"
 
 #include "spdk/log.h"
 #include "spdk_internal/thread.h"
@@ -32,8 +33,10 @@
 #endif
 
 #define SPDK_MSG_BATCH_SIZE		8
+#define SPDK_STEALABLE_MSG_RING_SIZE	4096
 #define SPDK_MAX_DEVICE_NAME_LEN	256
 #define SPDK_THREAD_EXIT_TIMEOUT_SEC	5
+#define SPDK_THREAD_INTR_MAX_BATCHES	16
 #define SPDK_MAX_POLLER_NAME_LEN	256
 #define SPDK_MAX_THREAD_NAME_LEN	256
 
@@ -71,6 +74,8 @@ enum spdk_poller_state {
 struct spdk_poller {
 	TAILQ_ENTRY(spdk_poller)	tailq;
 	RB_ENTRY(spdk_poller)		node;
+	/* List of the timer wheel the poller is on, if the thread uses a timer wheel */
+	struct timer_wheel_list		*wheel_list;
 
 	/* Current state of the poller; should only be accessed from the poller's thread. */
 	enum spdk_poller_state		state;
@@ -79,6 +84,10 @@ struct spdk_poller {
 	uint64_t			next_run_tick;
 	uint64_t			run_count;
 	uint64_t			busy_count;
+	/* Execution time statistics, only collected while poller timing is enabled */
+	uint64_t			max_run_tsc;
+	uint64_t			slow_run_count;
+	struct spdk_histogram_data	*histogram;
 	uint64_t			id;
 	spdk_poller_fn			fn;
 	void				*arg;
@@ -103,9 +112,19 @@ enum spdk_thread_state {
 	SPDK_THREAD_STATE_EXITED,
 };
 
+/* Busy runs are counted in power of two buckets of their length in ticks */
+#define THREAD_BUSY_RUN_BUCKETS		64
+
 struct spdk_thread {
 	uint64_t			tsc_last;
 	struct spdk_thread_stats	stats;
+	/* Length of the busy run in progress, i.e. of the consecutive busy iterations */
+	uint64_t			busy_run_tsc;
+	/* Burst statistics collected since the last spdk_thread_collect_burst_stats() */
+	uint32_t			busy_runs[THREAD_BUSY_RUN_BUCKETS];
+	uint64_t			msg_count;
+	enum spdk_thread_latency_class	latency_class;
+	int32_t				numa_affinity;
 	/*
 	 * Contains pollers actively running on this thread.  Pollers
 	 *  are run round-robin. The thread takes one poller from the head
@@ -118,6 +137,10 @@ struct spdk_thread {
 	 */
 	RB_HEAD(timed_pollers_tree, spdk_poller)	timed_pollers;
 	struct spdk_poller				*first_timed_poller;
+	/*
+	 * Used instead of the timed_pollers tree if the timer wheel is enabled.
+	 */
+	struct timer_wheel				*timer_wheel;
 	/*
 	 * Contains paused pollers.  Pollers on this queue are waiting until
 	 * they are resumed (in which case they're put onto the active/timer
@@ -125,9 +148,12 @@ struct spdk_thread {
 	 */
 	TAILQ_HEAD(paused_pollers_head, spdk_poller)	paused_pollers;
 	struct spdk_ring		*messages;
+	/* Messages which can be executed by other threads */
+	struct spdk_ring		*stealable_msgs;
 	int				msg_fd;
-	SLIST_HEAD(, spdk_msg)		msg_cache;
+	SLIST_HEAD(, spdk_thread_msg)	msg_cache;
 	size_t				msg_cache_count;
+	uint32_t			msg_batch_size;
 	spdk_msg_fn			critical_msg;
 	uint64_t			id;
 	uint64_t			next_poller_id;
@@ -149,6 +175,8 @@ struct spdk_thread {
 	/* Indicates whether this spdk_thread currently runs in interrupt. */
 	bool				in_interrupt;
 	bool				poller_unregistered;
+	/* Set once msg_fd is notified, until the thread acknowledges the notification */
+	bool				msg_notified;
 	struct spdk_fd_group		*fgrp;
 
 	/* User context allocated at the end */
@@ -271,15 +299,11 @@ io_channel_cmp(struct spdk_io_channel *ch1, struct spdk_io_channel *ch2)
 
 RB_GENERATE_STATIC(io_channel_tree, spdk_io_channel, node, io_channel_cmp);
 
-struct spdk_msg {
-	spdk_msg_fn		fn;
-	void			*arg;
-
-	SLIST_ENTRY(spdk_msg)	link;
-};
-
 static struct spdk_mempool *g_spdk_msg_mempool = NULL;
 
+/* Number of stealable messages pending across all threads */
+static uint64_t g_stealable_msg_count = 0;
+
 static TAILQ_HEAD(, spdk_thread) g_threads = TAILQ_HEAD_INITIALIZER(g_threads);
 static uint32_t g_thread_count = 0;
 
@@ -320,6 +344,301 @@ timed_poller_compare(struct spdk_poller *poller1, struct spdk_poller *poller2)
 
 RB_GENERATE_STATIC(timed_pollers_tree, spdk_poller, node, timed_poller_compare);
 
+#define TIMER_WHEEL_SLOT_BITS	6
+#define TIMER_WHEEL_SLOTS	(1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK	(TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS	8
+#define TIMER_WHEEL_MAX_TIMEOUT	((1ULL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+TAILQ_HEAD(timer_wheel_list, spdk_poller);
+
+/*
+ * Hierarchical timing wheel.  Each level consists of 64 slots, with a slot on level N spanning
+ * 64^N wheel ticks.  Pollers are put on the level matching the time remaining until they expire
+ * and are moved down to the lower levels as the wheel advances, so both scheduling and expiring
+ * a poller take constant time.  The non-empty slots of each level are tracked by a bitmap, which
+ * allows to quickly find the slots that need to be processed.
+ */
+struct timer_wheel {
+	/* Number of ticks per wheel tick */
+	uint64_t			resolution;
+	/* Current time of the wheel in wheel ticks */
+	uint64_t			now;
+	uint64_t			pending[TIMER_WHEEL_LEVELS];
+	struct timer_wheel_list		slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	/* Pollers that have expired, but haven't been executed yet */
+	struct timer_wheel_list		expired;
+};
+
+static bool g_timer_wheel = false;
+
+/* Precision of the poller execution time histograms, 1/8 of each power of two */
+#define POLLER_BUCKET_SHIFT		3
+
+static bool g_poller_histograms = false;
+/* Execution time of a poller above which a warning is logged, 0 if disabled */
+static uint64_t g_poller_watchdog_tsc = 0;
+
+static inline uint64_t
+timer_wheel_rotl(uint64_t value, uint32_t count)
+{
+	count &= 63;
+
+	return count ? (value << count) | (value >> (64 - count)) : value;
+}
+
+static inline uint64_t
+timer_wheel_rotr(uint64_t value, uint32_t count)
+{
+	count &= 63;
+
+	return count ? (value >> count) | (value << (64 - count)) : value;
+}
+
+static struct timer_wheel *
+timer_wheel_create(void)
+{
+	struct timer_wheel *wheel;
+	uint32_t level, slot;
+
+	wheel = calloc(1, sizeof(*wheel));
+	if (wheel == NULL) {
+		return NULL;
+	}
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+			TAILQ_INIT(&wheel->slots[level][slot]);
+		}
+	}
+	TAILQ_INIT(&wheel->expired);
+
+	wheel->resolution = spdk_max(spdk_get_ticks_hz() / SPDK_SEC_TO_USEC, 1);
+	wheel->now = spdk_get_ticks() / wheel->resolution;
+
+	return wheel;
+}
+
+static void
+timer_wheel_insert(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	struct timer_wheel_list *list;
+	uint64_t expires, remaining;
+	uint32_t level, slot;
+
+	/* Round the expiration up, so that a poller never runs before its next_run_tick */
+	expires = spdk_divide_round_up(poller->next_run_tick, wheel->resolution);
+	if (expires <= wheel->now) {
+		list = &wheel->expired;
+	} else {
+		/* Pollers expiring beyond the range of the wheel are put on the last level and
+		 * rescheduled each time that level's slot is processed.
+		 */
+		remaining = spdk_min(expires - wheel->now, TIMER_WHEEL_MAX_TIMEOUT);
+		level = (63 - __builtin_clzll(remaining)) / TIMER_WHEEL_SLOT_BITS;
+		/* A poller on an upper level is one rotation of the levels below ahead, so it's put
+		 * in the preceding slot to get moved down once that rotation is done.
+		 */
+		slot = TIMER_WHEEL_SLOT_MASK &
+		       ((expires >> (level * TIMER_WHEEL_SLOT_BITS)) - !!level);
+		list = &wheel->slots[level][slot];
+		wheel->pending[level] |= 1ULL << slot;
+	}
+
+	TAILQ_INSERT_TAIL(list, poller, tailq);
+	poller->wheel_list = list;
+}
+
+static void
+timer_wheel_remove(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	struct timer_wheel_list *list = poller->wheel_list;
+	uint32_t index;
+
+	assert(list != NULL);
+	TAILQ_REMOVE(list, poller, tailq);
+	poller->wheel_list = NULL;
+
+	if (list != &wheel->expired && TAILQ_EMPTY(list)) {
+		index = list - &wheel->slots[0][0];
+		wheel->pending[index / TIMER_WHEEL_SLOTS] &= ~(1ULL << (index % TIMER_WHEEL_SLOTS));
+	}
+}
+
+/* Advance the wheel to the current time, moving the pollers that expired to the expired list */
+static void
+timer_wheel_advance(struct timer_wheel *wheel, uint64_t now)
+{
+	struct timer_wheel_list todo = TAILQ_HEAD_INITIALIZER(todo);
+	struct spdk_poller *poller;
+	uint64_t elapsed, passed, mask;
+	uint32_t level, shift, slot, old_slot, new_slot, num_slots;
+
+	now /= wheel->resolution;
+	if (now <= wheel->now) {
+		return;
+	}
+
+	elapsed = now - wheel->now;
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		shift = level * TIMER_WHEEL_SLOT_BITS;
+		/* Find the slots that were passed on this level since the last update */
+		if ((elapsed >> shift) > TIMER_WHEEL_SLOT_MASK) {
+			passed = UINT64_MAX;
+		} else {
+			num_slots = elapsed >> shift;
+			mask = (1ULL << num_slots) - 1;
+			old_slot = TIMER_WHEEL_SLOT_MASK & (wheel->now >> shift);
+			new_slot = TIMER_WHEEL_SLOT_MASK & (now >> shift);
+			passed = timer_wheel_rotl(mask, old_slot);
+			passed |= timer_wheel_rotr(timer_wheel_rotl(mask, new_slot), num_slots);
+			passed |= 1ULL << new_slot;
+		}
+
+		while (passed & wheel->pending[level]) {
+			slot = __builtin_ctzll(passed & wheel->pending[level]);
+			TAILQ_CONCAT(&todo, &wheel->slots[level][slot], tailq);
+			wheel->pending[level] &= ~(1ULL << slot);
+		}
+
+		/* The upper levels only need to be processed if this one wrapped around */
+		if (!(passed & 1)) {
+			break;
+		}
+
+		elapsed = spdk_max(elapsed, (uint64_t)TIMER_WHEEL_SLOTS << shift);
+	}
+
+	wheel->now = now;
+
+	/* Reschedule the pollers from the processed slots.  Those which expired are put on the
+	 * expired list, while the others are moved down to the lower levels.
+	 */
+	while ((poller = TAILQ_FIRST(&todo)) != NULL) {
+		TAILQ_REMOVE(&todo, poller, tailq);
+		timer_wheel_insert(wheel, poller);
+	}
+}
+
+static uint64_t
+timer_wheel_next_expiration(struct timer_wheel *wheel)
+{
+	uint64_t timeout = UINT64_MAX, level_timeout, pending, passed_mask = 0;
+	uint32_t level, shift, slot;
+
+	if (!TAILQ_EMPTY(&wheel->expired)) {
+		return TAILQ_FIRST(&wheel->expired)->next_run_tick;
+	}
+
+	/*
+	 * The first pending slot of each level bounds the expiration of the pollers on it.  For
+	 * the upper levels, that's the time the slot is moved down, so the result might be earlier
+	 * than the actual expiration of any poller.
+	 */
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		shift = level * TIMER_WHEEL_SLOT_BITS;
+		if (wheel->pending[level] != 0) {
+			slot = TIMER_WHEEL_SLOT_MASK & (wheel->now >> shift);
+			pending = timer_wheel_rotr(wheel->pending[level], slot);
+			level_timeout = (uint64_t)(__builtin_ctzll(pending) + !!level) << shift;
+			level_timeout -= passed_mask & wheel->now;
+			timeout = spdk_min(timeout, level_timeout);
+		}
+		passed_mask = (passed_mask << TIMER_WHEEL_SLOT_BITS) | TIMER_WHEEL_SLOT_MASK;
+	}
+
+	if (timeout == UINT64_MAX) {
+		return 0;
+	}
+
+	return (wheel->now + timeout) * wheel->resolution;
+}
+
+/* Find the first poller in the wheel, starting from a given slot index */
+static struct spdk_poller *
+timer_wheel_first_poller(struct timer_wheel *wheel, uint32_t index)
+{
+	uint32_t level, slot;
+	uint64_t pending;
+
+	for (level = index / TIMER_WHEEL_SLOTS, slot = index % TIMER_WHEEL_SLOTS;
+	     level < TIMER_WHEEL_LEVELS; level++, slot = 0) {
+		pending = wheel->pending[level] & (UINT64_MAX << slot);
+		if (pending != 0) {
+			return TAILQ_FIRST(&wheel->slots[level][__builtin_ctzll(pending)]);
+		}
+	}
+
+	return NULL;
+}
+
+static struct spdk_poller *
+timer_wheel_next_poller(struct timer_wheel *wheel, struct spdk_poller *prev)
+{
+	struct spdk_poller *poller;
+
+	poller = TAILQ_NEXT(prev, tailq);
+	if (poller != NULL) {
+		return poller;
+	}
+
+	if (prev->wheel_list == &wheel->expired) {
+		return timer_wheel_first_poller(wheel, 0);
+	}
+
+	return timer_wheel_first_poller(wheel, prev->wheel_list - &wheel->slots[0][0] + 1);
+}
+
+static bool
+timer_wheel_is_empty(struct timer_wheel *wheel)
+{
+	uint32_t level;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		if (wheel->pending[level] != 0) {
+			return false;
+		}
+	}
+
+	return TAILQ_EMPTY(&wheel->expired);
+}
+
+static struct spdk_poller *
+thread_first_timed_poller(struct spdk_thread *thread)
+{
+	struct spdk_poller *poller;
+
+	if (thread->timer_wheel != NULL) {
+		poller = TAILQ_FIRST(&thread->timer_wheel->expired);
+		if (poller != NULL) {
+			return poller;
+		}
+
+		return timer_wheel_first_poller(thread->timer_wheel, 0);
+	}
+
+	return RB_MIN(timed_pollers_tree, &thread->timed_pollers);
+}
+
+static struct spdk_poller *
+thread_next_timed_poller(struct spdk_thread *thread, struct spdk_poller *prev)
+{
+	if (thread->timer_wheel != NULL) {
+		return timer_wheel_next_poller(thread->timer_wheel, prev);
+	}
+
+	return RB_NEXT(timed_pollers_tree, &thread->timed_pollers, prev);
+}
+
+#define THREAD_FOREACH_TIMED_POLLER(poller, thread)				\
+	for ((poller) = thread_first_timed_poller(thread); (poller) != NULL;	\
+	     (poller) = thread_next_timed_poller(thread, poller))
+
+#define THREAD_FOREACH_TIMED_POLLER_SAFE(poller, thread, tmp)			\
+	for ((poller) = thread_first_timed_poller(thread);			\
+	     (poller) != NULL && ((tmp) = thread_next_timed_poller(thread, poller), 1);	\
+	     (poller) = (tmp))
+
 static inline struct spdk_thread *
 _get_thread(void)
 {
@@ -335,7 +654,7 @@ _thread_lib_init(size_t ctx_sz, size_t msg_mempool_sz)
 
 	snprintf(mempool_name, sizeof(mempool_name), "msgpool_%d", getpid());
 	g_spdk_msg_mempool = spdk_mempool_create(mempool_name, msg_mempool_sz,
-			     sizeof(struct spdk_msg),
+			     sizeof(struct spdk_thread_msg),
 			     0, /* No cache. We do our own. */
 			     SPDK_ENV_SOCKET_ID_ANY);
 
@@ -352,12 +671,20 @@ _thread_lib_init(size_t ctx_sz, size_t msg_mempool_sz)
 
 static void thread_interrupt_destroy(struct spdk_thread *thread);
 static int thread_interrupt_create(struct spdk_thread *thread);
+static inline void poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller);
+
+static void
+poller_free(struct spdk_poller *poller)
+{
+	spdk_histogram_data_free(poller->histogram);
+	free(poller);
+}
 
 static void
 _free_thread(struct spdk_thread *thread)
 {
 	struct spdk_io_channel *ch;
-	struct spdk_msg *msg;
+	struct spdk_thread_msg *msg;
 	struct spdk_poller *poller, *ptmp;
 
 	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
@@ -371,22 +698,22 @@ _free_thread(struct spdk_thread *thread)
 				     poller->name);
 		}
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, ptmp) {
+	THREAD_FOREACH_TIMED_POLLER_SAFE(poller, thread, ptmp) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_WARNLOG("timed_poller %s still registered at thread exit\n",
 				     poller->name);
 		}
-		RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
-		free(poller);
+		poller_remove_timer(thread, poller);
+		poller_free(poller);
 	}
 
 	TAILQ_FOREACH_SAFE(poller, &thread->paused_pollers, tailq, ptmp) {
 		SPDK_WARNLOG("paused_poller %s still registered at thread exit\n", poller->name);
 		TAILQ_REMOVE(&thread->paused_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 	}
 
 	pthread_mutex_lock(&g_devlist_mutex);
@@ -408,11 +735,21 @@ _free_thread(struct spdk_thread *thread)
 
 	assert(thread->msg_cache_count == 0);
 
+	/* Only forcefully exited threads can still have stealable messages at this point */
+	if (thread->stealable_msgs != NULL) {
+		while (spdk_ring_dequeue(thread->stealable_msgs, (void **)&msg, 1) == 1) {
+			__atomic_fetch_sub(&g_stealable_msg_count, 1, __ATOMIC_RELAXED);
+			spdk_mempool_put(g_spdk_msg_mempool, msg);
+		}
+	}
+
 	if (spdk_interrupt_mode_is_enabled()) {
 		thread_interrupt_destroy(thread);
 	}
 
 	spdk_ring_free(thread->messages);
+	spdk_ring_free(thread->stealable_msgs);
+	free(thread->timer_wheel);
 	free(thread);
 }
 
@@ -468,6 +805,9 @@ spdk_thread_lib_fini(void)
 	g_thread_op_fn = NULL;
 	g_thread_op_supported_fn = NULL;
 	g_ctx_sz = 0;
+	g_timer_wheel = false;
+	g_poller_histograms = false;
+	g_poller_watchdog_tsc = 0;
 	if (g_app_thread != NULL) {
 		_free_thread(g_app_thread);
 		g_app_thread = NULL;
@@ -479,11 +819,36 @@ spdk_thread_lib_fini(void)
 	}
 }
 
+int
+spdk_thread_lib_enable_timer_wheel(void)
+{
+	if (g_spdk_msg_mempool) {
+		SPDK_ERRLOG("Failed due to threading library is already initialized.\n");
+		return -EBUSY;
+	}
+
+	g_timer_wheel = true;
+
+	return 0;
+}
+
+void
+spdk_thread_lib_enable_poller_histograms(bool enable)
+{
+	g_poller_histograms = enable;
+}
+
+void
+spdk_thread_lib_set_poller_watchdog(uint64_t threshold_us)
+{
+	g_poller_watchdog_tsc = threshold_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+}
+
 struct spdk_thread *
 spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 {
 	struct spdk_thread *thread, *null_thread;
-	struct spdk_msg *msgs[SPDK_MSG_MEMPOOL_CACHE_SIZE];
+	struct spdk_thread_msg *msgs[SPDK_MSG_MEMPOOL_CACHE_SIZE];
 	int rc = 0, i;
 
 	thread = calloc(1, sizeof(*thread) + g_ctx_sz);
@@ -504,6 +869,8 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 	TAILQ_INIT(&thread->paused_pollers);
 	SLIST_INIT(&thread->msg_cache);
 	thread->msg_cache_count = 0;
+	thread->msg_batch_size = SPDK_MSG_BATCH_SIZE;
+	thread->numa_affinity = SPDK_ENV_SOCKET_ID_ANY;
 
 	thread->tsc_last = spdk_get_ticks();
 
@@ -512,9 +879,29 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 	 */
 	thread->next_poller_id = 1;
 
+	if (g_timer_wheel) {
+		thread->timer_wheel = timer_wheel_create();
+		if (!thread->timer_wheel) {
+			SPDK_ERRLOG("Unable to allocate memory for timer wheel\n");
+			free(thread);
+			return NULL;
+		}
+	}
+
 	thread->messages = spdk_ring_create(SPDK_RING_TYPE_MP_SC, 65536, SPDK_ENV_SOCKET_ID_ANY);
 	if (!thread->messages) {
 		SPDK_ERRLOG("Unable to allocate memory for message ring\n");
+		free(thread->timer_wheel);
+		free(thread);
+		return NULL;
+	}
+
+	thread->stealable_msgs = spdk_ring_create(SPDK_RING_TYPE_MP_MC, SPDK_STEALABLE_MSG_RING_SIZE,
+				 SPDK_ENV_SOCKET_ID_ANY);
+	if (!thread->stealable_msgs) {
+		SPDK_ERRLOG("Unable to allocate memory for stealable message ring\n");
+		spdk_ring_free(thread->messages);
+		free(thread->timer_wheel);
 		free(thread);
 		return NULL;
 	}
@@ -630,7 +1017,8 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		goto exited;
 	}
 
-	if (spdk_ring_count(thread->messages) > 0) {
+	if (spdk_ring_count(thread->messages) > 0 ||
+	    spdk_ring_count(thread->stealable_msgs) > 0) {
 		SPDK_INFOLOG(thread, "thread %s still has messages\n", thread->name);
 		return;
 	}
@@ -644,7 +1032,7 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		}
 	}
 
-	RB_FOREACH(poller, timed_pollers_tree, &thread->timed_pollers) {
+	THREAD_FOREACH_TIMED_POLLER(poller, thread) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_INFOLOG(thread,
 				     "thread %s still has active timed poller %s\n",
@@ -796,14 +1184,74 @@ spdk_thread_get_from_ctx(void *ctx)
 	return SPDK_CONTAINEROF(ctx, struct spdk_thread, ctx);
 }
 
-static inline uint32_t
-msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
+static inline void
+thread_execute_msgs(struct spdk_thread *thread, void **messages, uint32_t count)
+{
+	uint32_t i;
+
+	thread->msg_count += count;
+
+	for (i = 0; i < count; i++) {
+		struct spdk_thread_msg *msg = messages[i];
+		bool embedded;
+
+		assert(msg != NULL);
+
+		SPDK_DTRACE_PROBE2(msg_exec, msg->fn, msg->arg);
+
+		/* An embedded message is owned by the caller, which may reuse or free it as soon
+		 * as its callback starts executing, so it can't be touched after that. */
+		embedded = msg->embedded;
+		msg->fn(msg->arg);
+
+		SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
+
+		if (embedded) {
+			continue;
+		}
+
+		if (thread->msg_cache_count < SPDK_MSG_MEMPOOL_CACHE_SIZE) {
+			/* Insert the messages at the head. We want to re-use the hot
+			 * ones. */
+			SLIST_INSERT_HEAD(&thread->msg_cache, msg, link);
+			thread->msg_cache_count++;
+		} else {
+			spdk_mempool_put(g_spdk_msg_mempool, msg);
+		}
+	}
+}
+
+/*
+ * Notify the thread about new messages, unless a notification is already pending, so that a
+ * burst of messages only costs a single write to its eventfd.  The flag is cleared by the thread
+ * after acknowledging the notification and before processing the messages.
+ */
+static int
+thread_notify_msg_fd(struct spdk_thread *thread)
 {
-	unsigned count, i;
-	void *messages[SPDK_MSG_BATCH_SIZE];
 	uint64_t notify = 1;
 	int rc;
 
+	if (__atomic_exchange_n(&thread->msg_notified, true, __ATOMIC_SEQ_CST)) {
+		return 0;
+	}
+
+	rc = write(thread->msg_fd, &notify, sizeof(notify));
+	if (rc < 0) {
+		__atomic_store_n(&thread->msg_notified, false, __ATOMIC_SEQ_CST);
+		SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static inline uint32_t
+msg_queue_run_batch(struct spdk_thread *thread, struct spdk_ring *ring, uint32_t max_msgs)
+{
+	unsigned count;
+	void *messages[SPDK_THREAD_MAX_MSG_BATCH_SIZE];
+
 #ifdef DEBUG
 	/*
 	 * spdk_ring_dequeue() fills messages and returns how many entries it wrote,
@@ -814,43 +1262,94 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 #endif
 
 	if (max_msgs > 0) {
-		max_msgs = spdk_min(max_msgs, SPDK_MSG_BATCH_SIZE);
+		max_msgs = spdk_min(max_msgs, thread->msg_batch_size);
 	} else {
-		max_msgs = SPDK_MSG_BATCH_SIZE;
+		max_msgs = thread->msg_batch_size;
 	}
 
-	count = spdk_ring_dequeue(thread->messages, messages, max_msgs);
+	count = spdk_ring_dequeue(ring, messages, max_msgs);
 	if (spdk_unlikely(thread->in_interrupt) &&
-	    spdk_ring_count(thread->messages) != 0) {
-		rc = write(thread->msg_fd, &notify, sizeof(notify));
-		if (rc < 0) {
-			SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
-		}
+	    spdk_ring_count(ring) != 0) {
+		thread_notify_msg_fd(thread);
 	}
 	if (count == 0) {
 		return 0;
 	}
 
-	for (i = 0; i < count; i++) {
-		struct spdk_msg *msg = messages[i];
+	thread_execute_msgs(thread, messages, count);
 
-		assert(msg != NULL);
+	return count;
+}
 
-		SPDK_DTRACE_PROBE2(msg_exec, msg->fn, msg->arg);
+static inline uint32_t
+stealable_msgs_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
+{
+	uint32_t count;
 
-		msg->fn(msg->arg);
+	if (spdk_likely(__atomic_load_n(&g_stealable_msg_count, __ATOMIC_RELAXED) == 0)) {
+		return 0;
+	}
 
-		SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
+	count = msg_queue_run_batch(thread, thread->stealable_msgs, max_msgs);
+	if (count > 0) {
+		__atomic_fetch_sub(&g_stealable_msg_count, count, __ATOMIC_RELAXED);
+	}
 
-		if (thread->msg_cache_count < SPDK_MSG_MEMPOOL_CACHE_SIZE) {
-			/* Insert the messages at the head. We want to re-use the hot
-			 * ones. */
-			SLIST_INSERT_HEAD(&thread->msg_cache, msg, link);
-			thread->msg_cache_count++;
-		} else {
-			spdk_mempool_put(g_spdk_msg_mempool, msg);
+	return count;
+}
+
+/*
+ * Steal messages from another thread's stealable queue.  Called by idle threads, so that
+ * messages which aren't bound to any thread don't have to wait for a busy thread to get to them.
+ */
+static uint32_t
+thread_steal_msgs(struct spdk_thread *thread)
+{
+	struct spdk_thread *victim;
+	void *messages[SPDK_THREAD_MAX_MSG_BATCH_SIZE];
+	uint32_t count = 0, pending;
+
+	if (spdk_likely(__atomic_load_n(&g_stealable_msg_count, __ATOMIC_RELAXED) == 0)) {
+		return 0;
+	}
+
+	/* Don't wait for the thread list, there'll be another chance in the next poll */
+	if (pthread_mutex_trylock(&g_devlist_mutex) != 0) {
+		return 0;
+	}
+
+	/* Go over the other threads, starting with the one following this thread, so that
+	 * the idle threads don't all compete for the same victim.
+	 */
+	for (victim = TAILQ_NEXT(thread, tailq); victim != thread;
+	     victim = TAILQ_NEXT(victim, tailq)) {
+		if (victim == NULL) {
+			victim = TAILQ_FIRST(&g_threads);
+			if (victim == thread) {
+				break;
+			}
+		}
+
+		pending = spdk_ring_count(victim->stealable_msgs);
+		if (pending == 0) {
+			continue;
+		}
+
+		/* Take up to half of the pending messages, leaving the rest to their owner */
+		count = spdk_min(spdk_max(pending / 2, 1), thread->msg_batch_size);
+		count = spdk_ring_dequeue(victim->stealable_msgs, messages, count);
+		if (count > 0) {
+			break;
 		}
 	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	if (count == 0) {
+		return 0;
+	}
+
+	__atomic_fetch_sub(&g_stealable_msg_count, count, __ATOMIC_RELAXED);
+	thread_execute_msgs(thread, messages, count);
 
 	return count;
 }
@@ -862,6 +1361,11 @@ poller_insert_timer(struct spdk_thread *thread, struct spdk_poller *poller, uint
 
 	poller->next_run_tick = now + poller->period_ticks;
 
+	if (thread->timer_wheel != NULL) {
+		timer_wheel_insert(thread->timer_wheel, poller);
+		return;
+	}
+
 	/*
 	 * Insert poller in the thread's timed_pollers tree by next scheduled run time
 	 * as its key.
@@ -884,6 +1388,11 @@ poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller)
 {
 	struct spdk_poller *tmp __attribute__((unused));
 
+	if (thread->timer_wheel != NULL) {
+		timer_wheel_remove(thread->timer_wheel, poller);
+		return;
+	}
+
 	tmp = RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
 	assert(tmp != NULL);
 
@@ -912,23 +1421,62 @@ thread_update_stats(struct spdk_thread *thread, uint64_t end,
 	if (rc == 0) {
 		/* Poller status idle */
 		thread->stats.idle_tsc += end - start;
+		if (thread->busy_run_tsc != 0) {
+			thread->busy_runs[spdk_u64log2(thread->busy_run_tsc)]++;
+			thread->busy_run_tsc = 0;
+		}
 	} else if (rc > 0) {
 		/* Poller status busy */
 		thread->stats.busy_tsc += end - start;
+		thread->busy_run_tsc += end - start;
 	}
 	/* Store end time to use it as start time of the next spdk_thread_poll(). */
 	thread->tsc_last = end;
 }
 
+static inline bool
+poller_timing_enabled(void)
+{
+	return g_poller_histograms || g_poller_watchdog_tsc != 0;
+}
+
+static void
+poller_account_run_time(struct spdk_thread *thread, struct spdk_poller *poller, uint64_t run_tsc)
+{
+	uint64_t run_us, threshold_us;
+
+	poller->max_run_tsc = spdk_max(poller->max_run_tsc, run_tsc);
+
+	if (g_poller_histograms) {
+		/* Histograms are only allocated for pollers that run while they're enabled */
+		if (spdk_unlikely(poller->histogram == NULL)) {
+			poller->histogram = spdk_histogram_data_alloc_sized(POLLER_BUCKET_SHIFT);
+		}
+		if (spdk_likely(poller->histogram != NULL)) {
+			spdk_histogram_data_tally(poller->histogram, run_tsc);
+		}
+	}
+
+	if (g_poller_watchdog_tsc != 0 && run_tsc > g_poller_watchdog_tsc) {
+		poller->slow_run_count++;
+		run_us = run_tsc * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+		threshold_us = g_poller_watchdog_tsc * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+		SPDK_WARNLOG("Poller %s on thread %s ran for %" PRIu64 " us, exceeding %" PRIu64
+			     " us\n", poller->name, thread->name, run_us, threshold_us);
+	}
+}
+
 static inline int
 thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 {
+	bool timed = poller_timing_enabled();
+	uint64_t start = 0;
 	int rc;
 
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 		return 0;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
@@ -943,7 +1491,13 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
+	if (spdk_unlikely(timed)) {
+		start = spdk_get_ticks();
+	}
 	rc = poller->fn(poller->arg);
+	if (spdk_unlikely(timed)) {
+		poller_account_run_time(thread, poller, spdk_get_ticks() - start);
+	}
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -961,7 +1515,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 		break;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
@@ -986,11 +1540,13 @@ static inline int
 thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poller,
 			    uint64_t now)
 {
+	bool timed = poller_timing_enabled();
+	uint64_t start = 0;
 	int rc;
 
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
-		free(poller);
+		poller_free(poller);
 		return 0;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_INSERT_TAIL(&thread->paused_pollers, poller, tailq);
@@ -1004,7 +1560,13 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
+	if (spdk_unlikely(timed)) {
+		start = spdk_get_ticks();
+	}
 	rc = poller->fn(poller->arg);
+	if (spdk_unlikely(timed)) {
+		poller_account_run_time(thread, poller, spdk_get_ticks() - start);
+	}
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -1021,7 +1583,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
-		free(poller);
+		poller_free(poller);
 		break;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_INSERT_TAIL(&thread->paused_pollers, poller, tailq);
@@ -1043,6 +1605,28 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	return rc;
 }
 
+static int
+thread_execute_expired_pollers(struct spdk_thread *thread, uint64_t now)
+{
+	struct timer_wheel *wheel = thread->timer_wheel;
+	struct spdk_poller *poller;
+	int rc = 0, timer_rc;
+
+	timer_wheel_advance(wheel, now);
+
+	/* Executed pollers are rescheduled into the future, so this loop is bounded */
+	while ((poller = TAILQ_FIRST(&wheel->expired)) != NULL) {
+		timer_wheel_remove(wheel, poller);
+
+		timer_rc = thread_execute_timed_poller(thread, poller, now);
+		if (timer_rc > rc) {
+			rc = timer_rc;
+		}
+	}
+
+	return rc;
+}
+
 static int
 thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 {
@@ -1060,7 +1644,12 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 		rc = 1;
 	}
 
-	msg_count = msg_queue_run_batch(thread, max_msgs);
+	msg_count = msg_queue_run_batch(thread, thread->messages, max_msgs);
+	if (msg_count) {
+		rc = 1;
+	}
+
+	msg_count = stealable_msgs_run_batch(thread, max_msgs);
 	if (msg_count) {
 		rc = 1;
 	}
@@ -1075,6 +1664,10 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 		}
 	}
 
+	if (thread->timer_wheel != NULL) {
+		return spdk_max(rc, thread_execute_expired_pollers(thread, now));
+	}
+
 	poller = thread->first_timed_poller;
 	while (poller != NULL) {
 		int timer_rc = 0;
@@ -1115,14 +1708,14 @@ _thread_remove_pollers(void *ctx)
 				   active_pollers_head, tailq, tmp) {
 		if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 			TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-			free(poller);
+			poller_free(poller);
 		}
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	THREAD_FOREACH_TIMED_POLLER_SAFE(poller, thread, tmp) {
 		if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 			poller_remove_timer(thread, poller);
-			free(poller);
+			poller_free(poller);
 		}
 	}
 
@@ -1162,6 +1755,11 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 			rc = thread_poll(thread, max_msgs, now);
 		}
 
+		if (rc == 0 && thread->state == SPDK_THREAD_STATE_RUNNING &&
+		    thread_steal_msgs(thread) > 0) {
+			rc = 1;
+		}
+
 		if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITING)) {
 			thread_exit(thread, now);
 		}
@@ -1182,6 +1780,10 @@ spdk_thread_next_poller_expiration(struct spdk_thread *thread)
 {
 	struct spdk_poller *poller;
 
+	if (thread->timer_wheel != NULL) {
+		return timer_wheel_next_expiration(thread->timer_wheel);
+	}
+
 	poller = thread->first_timed_poller;
 	if (poller) {
 		return poller->next_run_tick;
@@ -1200,7 +1802,8 @@ static bool
 thread_has_unpaused_pollers(struct spdk_thread *thread)
 {
 	if (TAILQ_EMPTY(&thread->active_pollers) &&
-	    RB_EMPTY(&thread->timed_pollers)) {
+	    (thread->timer_wheel != NULL ? timer_wheel_is_empty(thread->timer_wheel) :
+	     RB_EMPTY(&thread->timed_pollers))) {
 		return false;
 	}
 
@@ -1222,6 +1825,7 @@ bool
 spdk_thread_is_idle(struct spdk_thread *thread)
 {
 	if (spdk_ring_count(thread->messages) ||
+	    spdk_ring_count(thread->stealable_msgs) ||
 	    thread_has_unpaused_pollers(thread) ||
 	    thread->critical_msg != NULL) {
 		return false;
@@ -1298,6 +1902,57 @@ spdk_thread_get_stats(struct spdk_thread_stats *stats)
 	return 0;
 }
 
+void
+spdk_thread_collect_burst_stats(struct spdk_thread *thread, struct spdk_thread_burst_stats *stats)
+{
+	uint64_t total = 0, so_far = 0;
+	uint32_t i;
+
+	for (i = 0; i < THREAD_BUSY_RUN_BUCKETS; i++) {
+		total += thread->busy_runs[i];
+	}
+
+	stats->busy_runs = total;
+	stats->busy_run_p99_tsc = 0;
+	for (i = 0; i < THREAD_BUSY_RUN_BUCKETS && total != 0; i++) {
+		so_far += thread->busy_runs[i];
+		if (so_far * 100 >= total * 99) {
+			/* Runs in bucket i are shorter than 2^(i + 1) ticks */
+			stats->busy_run_p99_tsc = i < 63 ? 1ULL << (i + 1) : UINT64_MAX;
+			break;
+		}
+	}
+	stats->msg_count = thread->msg_count;
+
+	memset(thread->busy_runs, 0, sizeof(thread->busy_runs));
+	thread->msg_count = 0;
+}
+
+void
+spdk_thread_set_latency_class(struct spdk_thread *thread,
+			      enum spdk_thread_latency_class latency_class)
+{
+	thread->latency_class = latency_class;
+}
+
+enum spdk_thread_latency_class
+spdk_thread_get_latency_class(struct spdk_thread *thread)
+{
+	return thread->latency_class;
+}
+
+void
+spdk_thread_set_numa_affinity(struct spdk_thread *thread, int32_t socket_id)
+{
+	thread->numa_affinity = socket_id;
+}
+
+int32_t
+spdk_thread_get_numa_affinity(struct spdk_thread *thread)
+{
+	return thread->numa_affinity;
+}
+
 uint64_t
 spdk_thread_get_last_tsc(struct spdk_thread *thread)
 {
@@ -1311,9 +1966,6 @@ spdk_thread_get_last_tsc(struct spdk_thread *thread)
 static inline int
 thread_send_msg_notification(const struct spdk_thread *target_thread)
 {
-	uint64_t notify = 1;
-	int rc;
-
 	/* Not necessary to do notification if interrupt facility is not enabled */
 	if (spdk_likely(!spdk_interrupt_mode_is_enabled())) {
 		return 0;
@@ -1324,33 +1976,19 @@ thread_send_msg_notification(const struct spdk_thread *target_thread)
 	 * interrupt mode and then decide whether do event notification.
 	 */
 	if (spdk_unlikely(target_thread->in_interrupt)) {
-		rc = write(target_thread->msg_fd, &notify, sizeof(notify));
-		if (rc < 0) {
-			SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
-			return -EIO;
-		}
+		return thread_notify_msg_fd((struct spdk_thread *)target_thread);
 	}
 
 	return 0;
 }
 
-int
-spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+static inline struct spdk_thread_msg *
+thread_get_msg(spdk_msg_fn fn, void *ctx)
 {
 	struct spdk_thread *local_thread;
-	struct spdk_msg *msg;
-	int rc;
-
-	assert(thread != NULL);
-
-	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
-		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
-		return -EIO;
-	}
+	struct spdk_thread_msg *msg = NULL;
 
 	local_thread = _get_thread();
-
-	msg = NULL;
 	if (local_thread != NULL) {
 		if (local_thread->msg_cache_count > 0) {
 			msg = SLIST_FIRST(&local_thread->msg_cache);
@@ -1364,23 +2002,122 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 		msg = spdk_mempool_get(g_spdk_msg_mempool);
 		if (!msg) {
 			SPDK_ERRLOG("msg could not be allocated\n");
-			return -ENOMEM;
+			return NULL;
 		}
 	}
 
 	msg->fn = fn;
 	msg->arg = ctx;
+	msg->embedded = false;
+
+	return msg;
+}
 
-	rc = spdk_ring_enqueue(thread->messages, (void **)&msg, 1, NULL);
+static int
+thread_enqueue_msg(const struct spdk_thread *thread, struct spdk_ring *ring,
+		   struct spdk_thread_msg *msg)
+{
+	int rc;
+
+	rc = spdk_ring_enqueue(ring, (void **)&msg, 1, NULL);
 	if (rc != 1) {
 		SPDK_ERRLOG("msg could not be enqueued\n");
-		spdk_mempool_put(g_spdk_msg_mempool, msg);
 		return -EIO;
 	}
 
 	return thread_send_msg_notification(thread);
 }
 
+int
+spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+{
+	struct spdk_thread_msg *msg;
+	int rc;
+
+	assert(thread != NULL);
+
+	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
+		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
+		return -EIO;
+	}
+
+	msg = thread_get_msg(fn, ctx);
+	if (!msg) {
+		return -ENOMEM;
+	}
+
+	rc = thread_enqueue_msg(thread, thread->messages, msg);
+	if (rc != 0) {
+		spdk_mempool_put(g_spdk_msg_mempool, msg);
+	}
+
+	return rc;
+}
+
+int
+spdk_thread_send_stealable_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+{
+	struct spdk_thread_msg *msg;
+	int rc;
+
+	assert(thread != NULL);
+
+	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
+		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
+		return -EIO;
+	}
+
+	msg = thread_get_msg(fn, ctx);
+	if (!msg) {
+		return -ENOMEM;
+	}
+
+	/* Account for the message before it's visible to the other threads */
+	__atomic_fetch_add(&g_stealable_msg_count, 1, __ATOMIC_RELAXED);
+	rc = thread_enqueue_msg(thread, thread->stealable_msgs, msg);
+	if (rc != 0) {
+		__atomic_fetch_sub(&g_stealable_msg_count, 1, __ATOMIC_RELAXED);
+		spdk_mempool_put(g_spdk_msg_mempool, msg);
+	}
+
+	return rc;
+}
+
+int
+spdk_thread_send_msg_embedded(const struct spdk_thread *thread, struct spdk_thread_msg *msg,
+			      spdk_msg_fn fn, void *ctx)
+{
+	assert(thread != NULL);
+	assert(msg != NULL);
+
+	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
+		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
+		return -EIO;
+	}
+
+	msg->fn = fn;
+	msg->arg = ctx;
+	msg->embedded = true;
+
+	return thread_enqueue_msg(thread, thread->messages, msg);
+}
+
+int
+spdk_thread_set_msg_batch_size(struct spdk_thread *thread, uint32_t batch_size)
+{
+	assert(thread != NULL);
+
+	if (batch_size == 0 || batch_size > SPDK_THREAD_MAX_MSG_BATCH_SIZE) {
+		SPDK_ERRLOG("Invalid message batch size %"PRIu32", must be within [1, %u]\n",
+			    batch_size, SPDK_THREAD_MAX_MSG_BATCH_SIZE);
+		return -EINVAL;
+	}
+
+	thread->msg_batch_size = batch_size;
+
+	return 0;
+}
+
 int
 spdk_thread_send_critical_msg(struct spdk_thread *thread, spdk_msg_fn fn)
 {
@@ -1675,7 +2412,7 @@ poller_register(spdk_poller_fn fn,
 			rc = period_poller_interrupt_init(poller);
 			if (rc < 0) {
 				SPDK_ERRLOG("Failed to register interruptfd for periodic poller: %s\n", spdk_strerror(-rc));
-				free(poller);
+				poller_free(poller);
 				return NULL;
 			}
 
@@ -1689,7 +2426,7 @@ poller_register(spdk_poller_fn fn,
 			rc = busy_poller_interrupt_init(poller);
 			if (rc > 0) {
 				SPDK_ERRLOG("Failed to register interruptfd for busy poller: %s\n", spdk_strerror(-rc));
-				free(poller);
+				poller_free(poller);
 				return NULL;
 			}
 
@@ -1909,6 +2646,14 @@ spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stat
 {
 	stats->run_count = poller->run_count;
 	stats->busy_count = poller->busy_count;
+	stats->max_run_tsc = poller->max_run_tsc;
+	stats->slow_run_count = poller->slow_run_count;
+}
+
+const struct spdk_histogram_data *
+spdk_poller_get_histogram(struct spdk_poller *poller)
+{
+	return poller->histogram;
 }
 
 struct spdk_poller *
@@ -1926,13 +2671,13 @@ spdk_thread_get_next_active_poller(struct spdk_poller *prev)
 struct spdk_poller *
 spdk_thread_get_first_timed_poller(struct spdk_thread *thread)
 {
-	return RB_MIN(timed_pollers_tree, &thread->timed_pollers);
+	return thread_first_timed_poller(thread);
 }
 
 struct spdk_poller *
 spdk_thread_get_next_timed_poller(struct spdk_poller *prev)
 {
-	return RB_NEXT(timed_pollers_tree, &thread->timed_pollers, prev);
+	return thread_next_timed_poller(prev->thread, prev);
 }
 
 struct spdk_poller *
@@ -2071,7 +2816,7 @@ spdk_thread_set_interrupt_mode(bool enable_interrupt)
 	}
 
 	/* Set pollers to expected mode */
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	THREAD_FOREACH_TIMED_POLLER_SAFE(poller, thread, tmp) {
 		poller_set_interrupt_mode(poller, enable_interrupt);
 	}
 	TAILQ_FOREACH_SAFE(poller, &thread->active_pollers, tailq, tmp) {
@@ -2679,6 +3424,7 @@ thread_interrupt_msg_process(void *arg)
 	spdk_msg_fn critical_msg;
 	int rc = 0;
 	uint64_t notify = 1;
+	int i;
 
 	assert(spdk_interrupt_mode_is_enabled());
 
@@ -2693,6 +3439,10 @@ thread_interrupt_msg_process(void *arg)
 	if (rc < 0 && errno != EAGAIN) {
 		SPDK_ERRLOG("failed to acknowledge msg event: %s.\n", spdk_strerror(errno));
 	}
+	/* Producers skip the eventfd write while the flag is set, so it must be cleared only
+	 * after the notification has been consumed and before the ring is checked.
+	 */
+	__atomic_store_n(&thread->msg_notified, false, __ATOMIC_SEQ_CST);
 
 	critical_msg = thread->critical_msg;
 	if (spdk_unlikely(critical_msg != NULL)) {
@@ -2701,7 +3451,21 @@ thread_interrupt_msg_process(void *arg)
 		rc = 1;
 	}
 
-	msg_count = msg_queue_run_batch(thread, 0);
+	/* Drain several batches per wakeup rather than going back to epoll for each of them.
+	 * Anything left over is picked up on the next wakeup, as msg_queue_run_batch() re-arms
+	 * the notification in that case.
+	 */
+	for (i = 0; i < SPDK_THREAD_INTR_MAX_BATCHES; i++) {
+		msg_count = msg_queue_run_batch(thread, thread->messages, 0);
+		if (msg_count) {
+			rc = 1;
+		}
+		if (msg_count < thread->msg_batch_size || !thread->in_interrupt) {
+			break;
+		}
+	}
+
+	msg_count = stealable_msgs_run_batch(thread, 0);
 	if (msg_count) {
 		rc = 1;
 	}
@@ -2715,6 +3479,7 @@ thread_interrupt_msg_process(void *arg)
 		if (rc < 0 && errno != EAGAIN) {
 			SPDK_ERRLOG("failed to acknowledge msg queue: %s.\n", spdk_strerror(errno));
 		}
+		__atomic_store_n(&thread->msg_notified, false, __ATOMIC_SEQ_CST);
 	}
 
 	spdk_set_thread(orig_thread);
@@ -20,33 +20,200 @@ static char g_shm_name[64];
 
 struct spdk_trace_histories *g_trace_histories;
 
-static inline struct spdk_trace_entry *
-get_trace_entry(struct spdk_trace_history *history, uint64_t offset)
+/* Histories reserved for threads that don't run on any of the lcores */
+static pthread_mutex_t g_user_thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct spdk_trace_history *g_user_thread_histories[SPDK_TRACE_MAX_LCORE];
+static bool g_user_thread_used[SPDK_TRACE_MAX_LCORE];
+static uint32_t g_num_user_threads;
+static pthread_key_t g_user_thread_key;
+static bool g_user_thread_key_valid;
+
+/* Minimum interval between two trace captures */
+#define TRACE_CAPTURE_MIN_INTERVAL_SEC	1
+
+static uint32_t g_trace_sample_rate = 1;
+
+uint64_t g_trace_capture_threshold;
+static pthread_mutex_t g_trace_capture_lock = PTHREAD_MUTEX_INITIALIZER;
+static char g_trace_capture_path[PATH_MAX];
+static uint32_t g_trace_capture_index;
+static uint64_t g_trace_capture_tsc;
+static bool g_trace_capture_in_progress;
+
+static __thread struct spdk_trace_history *t_user_thread_history;
+/* Set once claiming a history has failed, so that it's not retried on each trace */
+static __thread bool t_user_thread_claim_failed;
+
+static void
+user_thread_history_release(struct spdk_trace_history *history)
 {
-	return &history->entries[offset & (history->num_entries - 1)];
+	uint32_t i;
+
+	pthread_mutex_lock(&g_user_thread_lock);
+	for (i = 0; i < g_num_user_threads; i++) {
+		if (g_user_thread_histories[i] == history) {
+			g_user_thread_used[i] = false;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_user_thread_lock);
+}
+
+static void
+user_thread_exit(void *ctx)
+{
+	user_thread_history_release(ctx);
+}
+
+int
+spdk_trace_register_user_thread(void)
+{
+	struct spdk_trace_history *history = NULL;
+	uint32_t i;
+
+	if (g_trace_histories == NULL || !g_user_thread_key_valid) {
+		return -ENOENT;
+	}
+
+	if (spdk_env_get_current_core() < SPDK_TRACE_MAX_LCORE) {
+		return -EINVAL;
+	}
+
+	if (t_user_thread_history != NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&g_user_thread_lock);
+	for (i = 0; i < g_num_user_threads; i++) {
+		if (!g_user_thread_used[i]) {
+			g_user_thread_used[i] = true;
+			history = g_user_thread_histories[i];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_user_thread_lock);
+
+	if (history == NULL) {
+		t_user_thread_claim_failed = true;
+		return -ENOMEM;
+	}
+
+	/* Release the history once the thread exits */
+	if (pthread_setspecific(g_user_thread_key, history) != 0) {
+		user_thread_history_release(history);
+		t_user_thread_claim_failed = true;
+		return -ENOMEM;
+	}
+
+	t_user_thread_history = history;
+	t_user_thread_claim_failed = false;
+
+	return 0;
+}
+
+int
+spdk_trace_unregister_user_thread(void)
+{
+	struct spdk_trace_history *history = t_user_thread_history;
+
+	if (history == NULL) {
+		return -ENOENT;
+	}
+
+	pthread_setspecific(g_user_thread_key, NULL);
+	t_user_thread_history = NULL;
+	user_thread_history_release(history);
+
+	return 0;
 }
 
+static inline struct spdk_trace_history *
+get_trace_history(void)
+{
+	unsigned lcore;
+
+	lcore = spdk_env_get_current_core();
+	if (spdk_likely(lcore < SPDK_TRACE_MAX_LCORE)) {
+		return spdk_get_per_lcore_history(g_trace_histories, lcore);
+	}
+
+	if (spdk_unlikely(t_user_thread_history == NULL)) {
+		if (t_user_thread_claim_failed || spdk_trace_register_user_thread() != 0) {
+			return NULL;
+		}
+	}
+
+	return t_user_thread_history;
+}
+
+static inline uint8_t *
+trace_encode_varint(uint8_t *buf, uint64_t value)
+{
+	while (value >= 0x80) {
+		*buf++ = (uint8_t)value | 0x80;
+		value >>= 7;
+	}
+	*buf++ = (uint8_t)value;
+
+	return buf;
+}
+
+static inline uint32_t
+trace_varint_size(uint64_t value)
+{
+	uint32_t size = 1;
+
+	while (value >= 0x80) {
+		value >>= 7;
+		size++;
+	}
+
+	return size;
+}
+
+static inline uint64_t
+trace_encode_tsc_delta(uint64_t tsc, uint64_t prev_tsc)
+{
+	int64_t delta = (int64_t)(tsc - prev_tsc);
+
+	/* Zigzag encoding, so that small negative deltas are encoded in few bytes too */
+	return ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+}
+
+/* Objects are usually pointers, so mix all of their bits before sampling them */
+static inline uint64_t
+trace_hash_object_id(uint64_t object_id)
+{
+	object_id ^= object_id >> 33;
+	object_id *= 0xff51afd7ed558ccdULL;
+	object_id ^= object_id >> 33;
+	object_id *= 0xc4ceb9fe1a85ec53ULL;
+	object_id ^= object_id >> 33;
+
+	return object_id;
+}
+
+/* poller_id, size and object_id, followed by up to 8 strings (length + characters) */
+#define TRACE_MAX_RECORD_BODY_SIZE	(3 + 5 + 10 + SPDK_TRACE_MAX_ARGS_COUNT * (2 + UINT8_MAX))
+
 void
 _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_t size,
 		   uint64_t object_id, int num_args, ...)
 {
 	struct spdk_trace_history *lcore_history;
-	struct spdk_trace_entry *next_entry;
-	struct spdk_trace_entry_buffer *buffer;
 	struct spdk_trace_tpoint *tpoint;
 	struct spdk_trace_argument *argument;
-	unsigned lcore, i, offset, num_entries, arglen, argoff, curlen;
-	uint64_t intval;
-	void *argval;
+	uint8_t body[TRACE_MAX_RECORD_BODY_SIZE], *buf;
+	uint64_t intval, consumer_offset, frame_size, frame_offset, buffer_size, delta;
+	uint32_t i, arglen, body_len, len, pad = 0;
+	const char *strval;
 	va_list vl;
 
-	lcore = spdk_env_get_current_core();
-	if (spdk_unlikely(lcore >= SPDK_TRACE_MAX_LCORE)) {
+	lcore_history = get_trace_history();
+	if (spdk_unlikely(lcore_history == NULL)) {
 		return;
 	}
 
-	lcore_history = spdk_get_per_lcore_history(g_trace_histories, lcore);
-
 	if (tsc == 0) {
 		tsc = spdk_get_ticks();
 	}
@@ -60,29 +227,28 @@ _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_
 		return;
 	}
 
-	/* Get next entry index in the circular buffer */
-	next_entry = get_trace_entry(lcore_history, lcore_history->next_entry);
-	next_entry->tsc = tsc;
-	next_entry->tpoint_id = tpoint_id;
-	next_entry->poller_id = poller_id;
-	next_entry->size = size;
-	next_entry->object_id = object_id;
+	if (spdk_unlikely(g_trace_sample_rate > 1) && tpoint->object_type != OBJECT_NONE &&
+	    trace_hash_object_id(object_id) % g_trace_sample_rate != 0) {
+		return;
+	}
 
-	num_entries = 1;
-	buffer = (struct spdk_trace_entry_buffer *)next_entry;
-	/* The initial offset needs to be adjusted by the fields present in the first entry
-	 * (poller_id, size, etc.).
-	 */
-	offset = offsetof(struct spdk_trace_entry, args) -
-		 offsetof(struct spdk_trace_entry_buffer, data);
+	buf = trace_encode_varint(body, poller_id);
+	buf = trace_encode_varint(buf, size);
+	buf = trace_encode_varint(buf, object_id);
 
 	va_start(vl, num_args);
 	for (i = 0; i < tpoint->num_args; ++i) {
 		argument = &tpoint->args[i];
 		switch (argument->type) {
 		case SPDK_TRACE_ARG_TYPE_STR:
-			argval = va_arg(vl, void *);
-			arglen = strnlen((const char *)argval, argument->size - 1) + 1;
+			/* Strings longer than the size defined in the tracepoint's description are
+			 * truncated, shorter ones only take as much space as they need.
+			 */
+			strval = va_arg(vl, const char *);
+			arglen = strnlen(strval, argument->size - 1);
+			buf = trace_encode_varint(buf, arglen);
+			memcpy(buf, strval, arglen);
+			buf += arglen;
 			break;
 		case SPDK_TRACE_ARG_TYPE_INT:
 		case SPDK_TRACE_ARG_TYPE_PTR:
@@ -91,62 +257,64 @@ _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_
 			} else {
 				intval = va_arg(vl, uint32_t);
 			}
-			argval = &intval;
-			arglen = argument->size;
+			buf = trace_encode_varint(buf, intval);
 			break;
 		default:
+			va_end(vl);
 			assert(0 && "Invalid trace argument type");
 			return;
 		}
+	}
+	va_end(vl);
 
-		/* Copy argument's data. For some argument types (strings) user is allowed to pass a
-		 * value that is either larger or smaller than what's defined in the tracepoint's
-		 * description. If the value is larger, we'll truncate it, while if it's smaller,
-		 * we'll only fill portion of the buffer, without touching the rest. For instance,
-		 * if the definition marks an argument as 40B and user passes 12B string, we'll only
-		 * copy 13B (accounting for the NULL terminator).
-		 */
-		argoff = 0;
-		while (argoff < argument->size) {
-			/* Current buffer is full, we need to acquire another one */
-			if (spdk_unlikely(offset == sizeof(buffer->data))) {
-				buffer = (struct spdk_trace_entry_buffer *) get_trace_entry(
-						 lcore_history,
-						 lcore_history->next_entry + num_entries);
-				buffer->tpoint_id = SPDK_TRACE_MAX_TPOINT_ID;
-				buffer->tsc = tsc;
-				num_entries++;
-				offset = 0;
-			}
+	body_len = buf - body;
+	frame_size = lcore_history->frame_size;
+	frame_offset = lcore_history->next_offset & (frame_size - 1);
+
+	/* The first record of a frame stores the absolute tsc */
+	delta = trace_encode_tsc_delta(tsc, frame_offset == 0 ? 0 : lcore_history->last_tsc);
+	len = trace_varint_size(tpoint_id + 1) + trace_varint_size(delta) + body_len;
+	if (frame_offset != 0 && len > frame_size - frame_offset) {
+		/* Records never cross frame boundaries, skip the rest of the current one */
+		pad = frame_size - frame_offset;
+		delta = trace_encode_tsc_delta(tsc, 0);
+		len = trace_varint_size(tpoint_id + 1) + trace_varint_size(delta) + body_len;
+	}
 
-			curlen = spdk_min(sizeof(buffer->data) - offset, argument->size - argoff);
-			if (spdk_likely(argoff < arglen)) {
-				assert(argval != NULL);
-				memcpy(&buffer->data[offset], (uint8_t *)argval + argoff,
-				       spdk_min(curlen, arglen - argoff));
-			}
+	buffer_size = spdk_get_trace_history_buffer_size(lcore_history);
+	if (spdk_unlikely(len > frame_size)) {
+		lcore_history->num_dropped++;
+		return;
+	}
 
-			offset += curlen;
-			argoff += curlen;
+	/* Don't overwrite the data that the consumer hasn't read yet */
+	if (spdk_unlikely(lcore_history->consumer_attached)) {
+		consumer_offset = __atomic_load_n(&lcore_history->consumer_offset, __ATOMIC_ACQUIRE);
+		if (lcore_history->next_offset + pad + len - consumer_offset > buffer_size) {
+			lcore_history->num_dropped++;
+			return;
 		}
+	}
 
-		/* Make sure that truncated strings are NULL-terminated */
-		if (spdk_unlikely(argument->type == SPDK_TRACE_ARG_TYPE_STR)) {
-			assert(offset > 0);
-			buffer->data[offset - 1] = '\0';
-		}
+	if (pad != 0) {
+		lcore_history->data[lcore_history->next_offset & (buffer_size - 1)] = 0;
 	}
-	va_end(vl);
 
-	/* Ensure all elements of the trace entry are visible to outside trace tools */
+	buf = &lcore_history->data[(lcore_history->next_offset + pad) & (buffer_size - 1)];
+	buf = trace_encode_varint(buf, tpoint_id + 1);
+	buf = trace_encode_varint(buf, delta);
+	memcpy(buf, body, body_len);
+	lcore_history->last_tsc = tsc;
+
+	/* Ensure all elements of the trace record are visible to outside trace tools */
 	spdk_smp_wmb();
-	lcore_history->next_entry += num_entries;
+	lcore_history->next_offset += pad + len;
 }
 
 int
-spdk_trace_init(const char *shm_name, uint64_t num_entries)
+spdk_trace_init(const char *shm_name, uint64_t num_entries, uint32_t num_threads)
 {
-	uint32_t i = 0;
+	uint32_t i = 0, num_user_threads = 0;
 	int histories_size;
 	uint64_t lcore_offsets[SPDK_TRACE_MAX_LCORE + 1] = { 0 };
 	struct spdk_cpuset cpuset = {};
@@ -163,6 +331,20 @@ spdk_trace_init(const char *shm_name, uint64_t num_entries)
 		lcore_offsets[i] = histories_size;
 		histories_size += spdk_get_trace_history_size(num_entries);
 	}
+
+	/* Place the histories of non-lcore threads in unused lcore slots, starting from the end */
+	for (i = SPDK_TRACE_MAX_LCORE; i > 0 && num_user_threads < num_threads; i--) {
+		if (lcore_offsets[i - 1] != 0) {
+			continue;
+		}
+		lcore_offsets[i - 1] = histories_size;
+		histories_size += spdk_get_trace_history_size(num_entries);
+		num_user_threads++;
+	}
+	if (num_user_threads < num_threads) {
+		SPDK_WARNLOG("Reserved only %u of %u trace histories for non-lcore threads\n",
+			     num_user_threads, num_threads);
+	}
 	lcore_offsets[SPDK_TRACE_MAX_LCORE] = histories_size;
 
 	snprintf(g_shm_name, sizeof(g_shm_name), "%s", shm_name);
@@ -174,6 +356,12 @@ spdk_trace_init(const char *shm_name, uint64_t num_entries)
 		return 1;
 	}
 
+	if (pthread_key_create(&g_user_thread_key, user_thread_exit) != 0) {
+		SPDK_ERRLOG("could not create trace thread key\n");
+		goto trace_init_err;
+	}
+	g_user_thread_key_valid = true;
+
 	if (ftruncate(g_trace_fd, histories_size) != 0) {
 		SPDK_ERRLOG("could not truncate shm\n");
 		goto trace_init_err;
@@ -206,6 +394,7 @@ spdk_trace_init(const char *shm_name, uint64_t num_entries)
 
 	g_trace_flags->tsc_rate = spdk_get_ticks_hz();
 
+	g_num_user_threads = 0;
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		struct spdk_trace_history *lcore_history;
 
@@ -213,11 +402,17 @@ spdk_trace_init(const char *shm_name, uint64_t num_entries)
 		if (lcore_offsets[i] == 0) {
 			continue;
 		}
-		assert(spdk_cpuset_get_cpu(&cpuset, i));
 		lcore_history = spdk_get_per_lcore_history(g_trace_histories, i);
 		lcore_history->lcore = i;
 		lcore_history->num_entries = num_entries;
+		lcore_history->frame_size = spdk_min(SPDK_TRACE_FRAME_SIZE, num_entries *
+						     sizeof(struct spdk_trace_entry));
+		if (!spdk_cpuset_get_cpu(&cpuset, i)) {
+			g_user_thread_used[g_num_user_threads] = false;
+			g_user_thread_histories[g_num_user_threads++] = lcore_history;
+		}
 	}
+	assert(g_num_user_threads == num_user_threads);
 	g_trace_flags->lcore_history_offsets[SPDK_TRACE_MAX_LCORE] = lcore_offsets[SPDK_TRACE_MAX_LCORE];
 
 	spdk_trace_flags_init();
@@ -228,6 +423,10 @@ trace_init_err:
 	if (g_trace_histories != MAP_FAILED) {
 		munmap(g_trace_histories, histories_size);
 	}
+	if (g_user_thread_key_valid) {
+		pthread_key_delete(g_user_thread_key);
+		g_user_thread_key_valid = false;
+	}
 	close(g_trace_fd);
 	g_trace_fd = -1;
 	shm_unlink(shm_name);
@@ -248,6 +447,12 @@ spdk_trace_cleanup(void)
 		return;
 	}
 
+	/* Wait for an outstanding capture to finish writing the histories */
+	g_trace_capture_threshold = 0;
+	while (__atomic_load_n(&g_trace_capture_in_progress, __ATOMIC_ACQUIRE)) {
+		usleep(1000);
+	}
+
 	/*
 	 * Only unlink the shm if there were no trace_entry recorded. This ensures the file
 	 * can be used after this process exits/crashes for debugging.
@@ -258,12 +463,18 @@ spdk_trace_cleanup(void)
 		if (lcore_history == NULL) {
 			continue;
 		}
-		unlink = lcore_history->entries[0].tsc == 0;
+		unlink = lcore_history->next_offset == 0;
 		if (!unlink) {
 			break;
 		}
 	}
 
+	if (g_user_thread_key_valid) {
+		pthread_key_delete(g_user_thread_key);
+		g_user_thread_key_valid = false;
+	}
+	g_num_user_threads = 0;
+
 	munmap(g_trace_histories, sizeof(struct spdk_trace_histories));
 	g_trace_histories = NULL;
 	close(g_trace_fd);
@@ -273,6 +484,132 @@ spdk_trace_cleanup(void)
 	}
 }
 
+void
+spdk_trace_set_sample_rate(uint32_t rate)
+{
+	g_trace_sample_rate = spdk_max(rate, 1);
+}
+
+uint32_t
+spdk_trace_get_sample_rate(void)
+{
+	return g_trace_sample_rate;
+}
+
+int
+spdk_trace_set_capture_trigger(uint64_t latency_us, const char *path)
+{
+	if (latency_us == 0) {
+		g_trace_capture_threshold = 0;
+		return 0;
+	}
+
+	if (path == NULL || path[0] == '\0' || strlen(path) >= sizeof(g_trace_capture_path) - 16) {
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&g_trace_capture_lock);
+	snprintf(g_trace_capture_path, sizeof(g_trace_capture_path), "%s", path);
+	g_trace_capture_index = 0;
+	pthread_mutex_unlock(&g_trace_capture_lock);
+
+	g_trace_capture_threshold = spdk_max(latency_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC, 1);
+
+	return 0;
+}
+
+static void *
+trace_capture_thread(void *ctx)
+{
+	char *filename = ctx;
+	uint64_t size, offset = 0;
+	ssize_t rc;
+	int fd;
+
+	fd = open(filename, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+	if (fd < 0) {
+		SPDK_ERRLOG("Could not open trace capture file %s: %s\n", filename,
+			    spdk_strerror(errno));
+		goto out;
+	}
+
+	/* The histories keep being updated, but the frames that get overwritten in the meantime
+	 * will be skipped when parsing the capture.
+	 */
+	size = spdk_get_trace_histories_size(g_trace_histories);
+	while (offset < size) {
+		rc = write(fd, (uint8_t *)g_trace_histories + offset, size - offset);
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			SPDK_ERRLOG("Could not write trace capture file %s: %s\n", filename,
+				    spdk_strerror(errno));
+			break;
+		}
+		offset += rc;
+	}
+	close(fd);
+
+	if (offset == size) {
+		SPDK_NOTICELOG("Traces captured to %s\n", filename);
+	}
+out:
+	free(filename);
+	__atomic_store_n(&g_trace_capture_in_progress, false, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+int
+spdk_trace_capture(void)
+{
+	pthread_attr_t attr;
+	pthread_t tid;
+	char *filename;
+	uint64_t tsc;
+	int rc;
+
+	if (g_trace_histories == NULL || g_trace_capture_threshold == 0) {
+		return -ENOENT;
+	}
+
+	tsc = spdk_get_ticks();
+	if (g_trace_capture_tsc != 0 &&
+	    tsc - g_trace_capture_tsc < TRACE_CAPTURE_MIN_INTERVAL_SEC * spdk_get_ticks_hz()) {
+		return -EAGAIN;
+	}
+
+	if (__atomic_exchange_n(&g_trace_capture_in_progress, true, __ATOMIC_ACQ_REL)) {
+		return -EBUSY;
+	}
+
+	g_trace_capture_tsc = tsc;
+
+	pthread_mutex_lock(&g_trace_capture_lock);
+	filename = spdk_sprintf_alloc("%s.%" PRIu32, g_trace_capture_path, g_trace_capture_index++);
+	pthread_mutex_unlock(&g_trace_capture_lock);
+	if (filename == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	/* Write the file on a separate thread, so that the caller isn't blocked */
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	rc = -pthread_create(&tid, &attr, trace_capture_thread, filename);
+	pthread_attr_destroy(&attr);
+	if (rc != 0) {
+		free(filename);
+		goto err;
+	}
+
+	return 0;
+err:
+	__atomic_store_n(&g_trace_capture_in_progress, false, __ATOMIC_RELEASE);
+	return rc;
+}
+
 const char *
 trace_get_shm_name(void)
 {
@@ -7,6 +7,7 @@
 #include "spdk/util.h"
 #include "spdk/trace.h"
 #include "spdk/log.h"
+#include "spdk/string.h"
 #include "trace_internal.h"
 
 struct rpc_tpoint_group {
@@ -261,3 +262,69 @@ rpc_trace_get_info(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("trace_get_info", rpc_trace_get_info,
 		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+struct rpc_trace_sample_rate {
+	uint32_t rate;
+};
+
+static const struct spdk_json_object_decoder rpc_trace_sample_rate_decoders[] = {
+	{"rate", offsetof(struct rpc_trace_sample_rate, rate), spdk_json_decode_uint32},
+};
+
+static void
+rpc_trace_set_sample_rate(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_trace_sample_rate req = {};
+
+	if (spdk_json_decode_object(params, rpc_trace_sample_rate_decoders,
+				    SPDK_COUNTOF(rpc_trace_sample_rate_decoders), &req)) {
+		SPDK_DEBUGLOG(trace, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		return;
+	}
+
+	spdk_trace_set_sample_rate(req.rate);
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("trace_set_sample_rate", rpc_trace_set_sample_rate,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+struct rpc_trace_capture_trigger {
+	uint64_t latency_us;
+	char *path;
+};
+
+static const struct spdk_json_object_decoder rpc_trace_capture_trigger_decoders[] = {
+	{"latency_us", offsetof(struct rpc_trace_capture_trigger, latency_us), spdk_json_decode_uint64},
+	{"path", offsetof(struct rpc_trace_capture_trigger, path), spdk_json_decode_string, true},
+};
+
+static void
+rpc_trace_set_capture_trigger(struct spdk_jsonrpc_request *request,
+			      const struct spdk_json_val *params)
+{
+	struct rpc_trace_capture_trigger req = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_trace_capture_trigger_decoders,
+				    SPDK_COUNTOF(rpc_trace_capture_trigger_decoders), &req)) {
+		SPDK_DEBUGLOG(trace, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto out;
+	}
+
+	rc = spdk_trace_set_capture_trigger(req.latency_us, req.path);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto out;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+out:
+	free(req.path);
+}
+SPDK_RPC_REGISTER("trace_set_capture_trigger", rpc_trace_set_capture_trigger,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
@@ -9,6 +9,7 @@
 #include "spdk/trace_parser.h"
 #include "spdk/util.h"
 
+#include <deque>
 #include <exception>
 #include <map>
 #include <new>
@@ -32,25 +33,20 @@ public:
 	}
 };
 
-typedef std::map<entry_key, spdk_trace_entry *, compare_entry_key> entry_map;
+/* Decoded trace record, its arguments are only decoded once it's returned to the user */
+struct trace_record {
+	spdk_trace_entry	entry;
+	const uint8_t		*args;
+	const uint8_t		*end;
+};
 
-struct argument_context {
-	spdk_trace_entry	*entry;
-	spdk_trace_entry_buffer	*buffer;
-	uint16_t		lcore;
-	size_t			offset;
+typedef std::map<entry_key, trace_record *, compare_entry_key> entry_map;
 
-	argument_context(spdk_trace_entry *entry, uint16_t lcore) :
-		entry(entry), lcore(lcore)
-	{
-		buffer = reinterpret_cast<spdk_trace_entry_buffer *>(entry);
+struct argument_context {
+	const uint8_t	*buf;
+	const uint8_t	*end;
 
-		/* The first argument resides within the spdk_trace_entry structure, so the initial
-		 * offset needs to be adjusted to the start of the spdk_trace_entry.args array
-		 */
-		offset = offsetof(spdk_trace_entry, args) -
-			 offsetof(spdk_trace_entry_buffer, data);
-	}
+	argument_context(const trace_record *record) : buf(record->args), end(record->end) {}
 };
 
 struct object_stats {
@@ -71,10 +67,11 @@ struct spdk_trace_parser {
 	bool next_entry(spdk_trace_parser_entry *entry);
 	uint64_t entry_count(uint16_t lcore) const;
 private:
-	spdk_trace_entry_buffer *get_next_buffer(spdk_trace_entry_buffer *buf, uint16_t lcore);
 	bool build_arg(argument_context *argctx, const spdk_trace_argument *arg, int argid,
 		       spdk_trace_parser_entry *pe);
-	void populate_events(spdk_trace_history *history, int num_entries);
+	bool decode_record(const uint8_t *buf, const uint8_t *end, uint64_t prev_tsc,
+			   trace_record *record);
+	void populate_events(spdk_trace_history *history);
 	bool init(const spdk_trace_parser_opts *opts);
 	void cleanup();
 
@@ -82,6 +79,8 @@ private:
 	size_t			_map_size;
 	int			_fd;
 	uint64_t		_tsc_offset;
+	std::deque<trace_record>	_records;
+	uint64_t		_record_count[SPDK_TRACE_MAX_LCORE];
 	entry_map		_entries;
 	entry_map::iterator	_iter;
 	object_stats		_stats[SPDK_TRACE_MAX_OBJECT];
@@ -90,66 +89,56 @@ private:
 uint64_t
 spdk_trace_parser::entry_count(uint16_t lcore) const
 {
-	spdk_trace_history *history;
-
 	if (lcore >= SPDK_TRACE_MAX_LCORE) {
 		return 0;
 	}
 
-	history = spdk_get_per_lcore_history(_histories, lcore);
-
-	return history == NULL ? 0 : history->num_entries;
+	return _record_count[lcore];
 }
 
-spdk_trace_entry_buffer *
-spdk_trace_parser::get_next_buffer(spdk_trace_entry_buffer *buf, uint16_t lcore)
+static bool
+decode_varint(const uint8_t **buf, const uint8_t *end, uint64_t *value)
 {
-	spdk_trace_history *history;
-
-	history = spdk_get_per_lcore_history(_histories, lcore);
-	assert(history);
-
-	if (spdk_unlikely(static_cast<void *>(buf) ==
-			  static_cast<void *>(&history->entries[history->num_entries - 1]))) {
-		return reinterpret_cast<spdk_trace_entry_buffer *>(&history->entries[0]);
-	} else {
-		return buf + 1;
+	const uint8_t *ptr = *buf;
+	uint32_t shift = 0;
+
+	*value = 0;
+	while (ptr < end && shift < 64) {
+		*value |= static_cast<uint64_t>(*ptr & 0x7f) << shift;
+		if (!(*ptr++ & 0x80)) {
+			*buf = ptr;
+			return true;
+		}
+		shift += 7;
 	}
+
+	return false;
 }
 
 bool
 spdk_trace_parser::build_arg(argument_context *argctx, const spdk_trace_argument *arg, int argid,
 			     spdk_trace_parser_entry *pe)
 {
-	spdk_trace_entry *entry = argctx->entry;
-	spdk_trace_entry_buffer *buffer = argctx->buffer;
-	size_t curlen, argoff;
-
-	argoff = 0;
-	/* Make sure that if we only copy a 4-byte integer, that the upper bytes have already been
-	 * zeroed.
-	 */
-	pe->args[argid].integer = 0;
-	while (argoff < arg->size) {
-		if (argctx->offset == sizeof(buffer->data)) {
-			buffer = get_next_buffer(buffer, argctx->lcore);
-			if (spdk_unlikely(buffer->tpoint_id != SPDK_TRACE_MAX_TPOINT_ID ||
-					  buffer->tsc != entry->tsc)) {
-				return false;
-			}
+	uint64_t value;
+	size_t len;
 
-			argctx->offset = 0;
-			argctx->buffer = buffer;
-		}
+	if (!decode_varint(&argctx->buf, argctx->end, &value)) {
+		return false;
+	}
 
-		curlen = spdk_min(sizeof(buffer->data) - argctx->offset, arg->size - argoff);
-		if (argoff < sizeof(pe->args[0])) {
-			memcpy(&pe->args[argid].string[argoff], &buffer->data[argctx->offset],
-			       spdk_min(curlen, sizeof(pe->args[0]) - argoff));
+	switch (arg->type) {
+	case SPDK_TRACE_ARG_TYPE_STR:
+		if (value > static_cast<uint64_t>(argctx->end - argctx->buf)) {
+			return false;
 		}
-
-		argctx->offset += curlen;
-		argoff += curlen;
+		len = spdk_min(value, sizeof(pe->args[0].string) - 1);
+		memcpy(pe->args[argid].string, argctx->buf, len);
+		pe->args[argid].string[len] = '\0';
+		argctx->buf += value;
+		break;
+	default:
+		pe->args[argid].integer = value;
+		break;
 	}
 
 	return true;
@@ -167,7 +156,7 @@ spdk_trace_parser::next_entry(spdk_trace_parser_entry *pe)
 		return false;
 	}
 
-	pe->entry = entry = _iter->second;
+	pe->entry = entry = &_iter->second->entry;
 	pe->lcore = _iter->first.lcore;
 	/* Set related index to the max value to indicate "empty" state */
 	pe->related_index = UINT64_MAX;
@@ -190,7 +179,7 @@ spdk_trace_parser::next_entry(spdk_trace_parser_entry *pe)
 		}
 	}
 
-	argument_context argctx(entry, pe->lcore);
+	argument_context argctx(_iter->second);
 	for (uint8_t i = 0; i < tpoint->num_args; ++i) {
 		if (!build_arg(&argctx, &tpoint->args[i], i, pe)) {
 			SPDK_ERRLOG("Failed to parse tracepoint argument\n");
@@ -220,58 +209,101 @@ spdk_trace_parser::next_entry(spdk_trace_parser_entry *pe)
 	return true;
 }
 
-void
-spdk_trace_parser::populate_events(spdk_trace_history *history, int num_entries)
+bool
+spdk_trace_parser::decode_record(const uint8_t *buf, const uint8_t *end, uint64_t prev_tsc,
+				 trace_record *record)
 {
-	int i, num_entries_filled;
-	spdk_trace_entry *e;
-	int first, last, lcore;
-
-	lcore = history->lcore;
-	e = history->entries;
-
-	num_entries_filled = num_entries;
-	while (e[num_entries_filled - 1].tsc == 0) {
-		num_entries_filled--;
+	const spdk_trace_tpoint *tpoint;
+	spdk_trace_parser_entry pe;
+	uint64_t tpoint_id, delta, poller_id, size, object_id;
+
+	if (!decode_varint(&buf, end, &tpoint_id) || tpoint_id == 0 ||
+	    tpoint_id > SPDK_TRACE_MAX_TPOINT_ID || !decode_varint(&buf, end, &delta) ||
+	    !decode_varint(&buf, end, &poller_id) || !decode_varint(&buf, end, &size) ||
+	    !decode_varint(&buf, end, &object_id)) {
+		return false;
 	}
 
-	if (num_entries == num_entries_filled) {
-		first = last = 0;
-		for (i = 1; i < num_entries; i++) {
-			if (e[i].tsc < e[first].tsc) {
-				first = i;
-			}
-			if (e[i].tsc > e[last].tsc) {
-				last = i;
-			}
+	memset(&record->entry, 0, sizeof(record->entry));
+	record->entry.tpoint_id = tpoint_id - 1;
+	record->entry.tsc = prev_tsc + ((delta >> 1) ^ -(delta & 1));
+	record->entry.poller_id = poller_id;
+	record->entry.size = size;
+	record->entry.object_id = object_id;
+	record->args = buf;
+	record->end = end;
+
+	/* Find the end of the record, the arguments themselves are decoded once requested */
+	argument_context argctx(record);
+	tpoint = &_histories->flags.tpoint[record->entry.tpoint_id];
+	for (uint8_t i = 0; i < tpoint->num_args; ++i) {
+		if (!build_arg(&argctx, &tpoint->args[i], i, &pe)) {
+			return false;
 		}
-	} else {
-		first = 0;
-		last = num_entries_filled - 1;
 	}
+	record->end = argctx.buf;
+
+	return true;
+}
 
-	/*
-	 * We keep track of the highest first TSC out of all reactors.
-	 *  We will ignore any events that occurred before this TSC on any
-	 *  other reactors.  This will ensure we only print data for the
-	 *  subset of time where we have data across all reactors.
-	 */
-	if (e[first].tsc > _tsc_offset) {
-		_tsc_offset = e[first].tsc;
+void
+spdk_trace_parser::populate_events(spdk_trace_history *history)
+{
+	const uint8_t *buf;
+	uint64_t buffer_size, frame_size, offset, next_offset, frame_offset, len, prev_tsc = 0;
+	trace_record record;
+	uint16_t lcore;
+	bool first = true;
+
+	lcore = history->lcore;
+	buffer_size = spdk_get_trace_history_buffer_size(history);
+	frame_size = history->frame_size;
+	next_offset = history->next_offset;
+	if (frame_size == 0) {
+		SPDK_ERRLOG("Invalid frame size of lcore %d trace history\n", lcore);
+		return;
+	}
+
+	/* Once the buffer has wrapped, start at the first frame that hasn't been overwritten */
+	offset = 0;
+	if (next_offset > buffer_size) {
+		offset = spdk_divide_round_up(next_offset - buffer_size, frame_size) * frame_size;
 	}
 
-	i = first;
-	while (1) {
-		if (e[i].tpoint_id != SPDK_TRACE_MAX_TPOINT_ID) {
-			_entries[entry_key(lcore, e[i].tsc)] = &e[i];
+	while (offset < next_offset) {
+		frame_offset = offset % frame_size;
+		if (frame_offset == 0) {
+			prev_tsc = 0;
 		}
-		if (i == last) {
-			break;
+
+		/* Frames never cross the end of the buffer, so each one is contiguous */
+		buf = &history->data[offset % buffer_size];
+		len = spdk_min(frame_size - frame_offset, next_offset - offset);
+		if (*buf == 0 || !decode_record(buf, buf + len, prev_tsc, &record)) {
+			/* Either the rest of the frame is unused or it's been overwritten while
+			 * being parsed.  Either way, move on to the next one.
+			 */
+			offset += frame_size - frame_offset;
+			continue;
 		}
-		i++;
-		if (i == num_entries_filled) {
-			i = 0;
+
+		/*
+		 * We keep track of the highest first TSC out of all reactors.
+		 *  We will ignore any events that occurred before this TSC on any
+		 *  other reactors.  This will ensure we only print data for the
+		 *  subset of time where we have data across all reactors.
+		 */
+		if (first && record.entry.tsc > _tsc_offset) {
+			_tsc_offset = record.entry.tsc;
 		}
+		first = false;
+
+		prev_tsc = record.entry.tsc;
+		_records.push_back(record);
+		_entries[entry_key(lcore, record.entry.tsc)] = &_records.back();
+		_record_count[lcore]++;
+
+		offset += record.end - buf;
 	}
 }
 
@@ -339,11 +371,12 @@ spdk_trace_parser::init(const spdk_trace_parser_opts *opts)
 	if (opts->lcore == SPDK_TRACE_MAX_LCORE) {
 		for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 			history = spdk_get_per_lcore_history(_histories, i);
-			if (history == NULL || history->num_entries == 0 || history->entries[0].tsc == 0) {
+			if (history == NULL || history->num_entries == 0 ||
+			    history->next_offset == 0) {
 				continue;
 			}
 
-			populate_events(history, history->num_entries);
+			populate_events(history);
 		}
 	} else {
 		history = spdk_get_per_lcore_history(_histories, opts->lcore);
@@ -352,8 +385,8 @@ spdk_trace_parser::init(const spdk_trace_parser_opts *opts)
 				    opts->filename, opts->lcore);
 			return false;
 		}
-		if (history->num_entries > 0 && history->entries[0].tsc != 0) {
-			populate_events(history, history->num_entries);
+		if (history->num_entries > 0 && history->next_offset != 0) {
+			populate_events(history);
 		}
 	}
 
@@ -377,7 +410,8 @@ spdk_trace_parser::spdk_trace_parser(const spdk_trace_parser_opts *opts) :
 	_histories(NULL),
 	_map_size(0),
 	_fd(-1),
-	_tsc_offset(0)
+	_tsc_offset(0),
+	_record_count()
 {
 	if (!init(opts)) {
 		cleanup();
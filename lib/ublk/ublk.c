@@ -4,6 +4,7 @@
  */
 
 #include <liburing.h>
+#include <sys/syscall.h>
 
 #include "spdk/stdinc.h"
 #include "spdk/string.h"
@@ -102,10 +103,22 @@ struct ublk_queue {
 	struct ublksrv_io_desc	*io_cmd_buf;
 	/* ring depth == dev_info->queue_depth. */
 	struct io_uring		ring;
+	/* The ring was set up with IORING_SETUP_COOP_TASKRUN */
+	bool			coop_taskrun;
 	struct spdk_ublk_dev	*dev;
 	struct ublk_poll_group	*poll_group;
 	struct spdk_io_channel	*bdev_ch;
 
+	/* Updated on the poll group's thread only, read without synchronization by RPCs */
+	struct {
+		uint64_t	num_read_ops;
+		uint64_t	bytes_read;
+		uint64_t	num_write_ops;
+		uint64_t	bytes_written;
+		uint64_t	num_other_ops;
+		uint64_t	num_errors;
+	} stats;
+
 	TAILQ_ENTRY(ublk_queue)	tailq;
 };
 
@@ -142,6 +155,8 @@ struct ublk_poll_group {
 	struct spdk_poller		*ublk_poller;
 	struct spdk_iobuf_channel	iobuf_ch;
 	TAILQ_HEAD(, ublk_queue)	queue_list;
+	/* Number of queues assigned to this poll group, including the ones still starting */
+	uint32_t			num_queues;
 };
 
 struct ublk_tgt {
@@ -177,6 +192,27 @@ ublk_setup_ring(uint32_t depth, struct io_uring *r, unsigned flags)
 	return io_uring_queue_init_params(depth, r, &p);
 }
 
+/*
+ * With IORING_SETUP_COOP_TASKRUN, the kernel doesn't interrupt the thread to post the
+ *  completions of commands, but waits until the ring is entered.  Submitting commands enters it
+ *  anyway, so only enter it without submitting anything if the kernel flagged pending work.
+ */
+static inline void
+ublk_uring_get_events(struct ublk_queue *q)
+{
+	int rc;
+
+	if (!q->coop_taskrun ||
+	    !(__atomic_load_n(q->ring.sq.kflags, __ATOMIC_RELAXED) & IORING_SQ_TASKRUN)) {
+		return;
+	}
+
+	rc = syscall(__NR_io_uring_enter, q->ring.ring_fd, 0, 0, IORING_ENTER_GETEVENTS, NULL, 0);
+	if (spdk_unlikely(rc < 0)) {
+		SPDK_ERRLOG("Failed to get events of queue %u: %s\n", q->q_id, spdk_strerror(errno));
+	}
+}
+
 static inline struct io_uring_sqe *
 ublk_uring_get_sqe(struct io_uring *r, uint32_t idx)
 {
@@ -830,6 +866,35 @@ ublk_dev_get_num_queues(struct spdk_ublk_dev *ublk)
 	return ublk->num_queues;
 }
 
+void
+ublk_dev_dump_queues_json(struct spdk_ublk_dev *ublk, struct spdk_json_write_ctx *w)
+{
+	struct ublk_poll_group *poll_group;
+	struct ublk_queue *q;
+	uint32_t q_id;
+
+	spdk_json_write_named_array_begin(w, "queues");
+	for (q_id = 0; q_id < ublk->num_queues; q_id++) {
+		q = &ublk->queues[q_id];
+		poll_group = q->poll_group;
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "q_id", q->q_id);
+		if (poll_group != NULL) {
+			spdk_json_write_named_string(w, "thread",
+						     spdk_thread_get_name(poll_group->ublk_thread));
+		}
+		spdk_json_write_named_uint64(w, "num_read_ops", q->stats.num_read_ops);
+		spdk_json_write_named_uint64(w, "bytes_read", q->stats.bytes_read);
+		spdk_json_write_named_uint64(w, "num_write_ops", q->stats.num_write_ops);
+		spdk_json_write_named_uint64(w, "bytes_written", q->stats.bytes_written);
+		spdk_json_write_named_uint64(w, "num_other_ops", q->stats.num_other_ops);
+		spdk_json_write_named_uint64(w, "num_errors", q->stats.num_errors);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+}
+
 const char *
 ublk_dev_get_bdev_name(struct spdk_ublk_dev *ublk)
 {
@@ -976,6 +1041,7 @@ ublk_try_close_queue(struct ublk_queue *q)
 	}
 
 	TAILQ_REMOVE(&q->poll_group->queue_list, q, tailq);
+	__atomic_fetch_sub(&q->poll_group->num_queues, 1, __ATOMIC_RELAXED);
 	spdk_put_io_channel(q->bdev_ch);
 	q->bdev_ch = NULL;
 
@@ -1027,6 +1093,7 @@ ublk_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 		res = io->result;
 	} else {
 		res = -EIO;
+		q->stats.num_errors++;
 	}
 
 	ublk_mark_io_done(io, res);
@@ -1220,9 +1287,13 @@ ublk_submit_bdev_io(struct ublk_queue *q, struct ublk_io *io)
 	ublk_op = ublksrv_get_op(iod);
 	switch (ublk_op) {
 	case UBLK_IO_OP_READ:
+		q->stats.num_read_ops++;
+		q->stats.bytes_read += io->result;
 		ublk_io_get_buffer(io, iobuf_ch, read_get_buffer_done);
 		break;
 	case UBLK_IO_OP_WRITE:
+		q->stats.num_write_ops++;
+		q->stats.bytes_written += io->result;
 		if (g_ublk_tgt.user_copy) {
 			ublk_io_get_buffer(io, iobuf_ch, user_copy_write_get_buffer_done);
 		} else {
@@ -1230,6 +1301,7 @@ ublk_submit_bdev_io(struct ublk_queue *q, struct ublk_io *io)
 		}
 		break;
 	default:
+		q->stats.num_other_ops++;
 		_ublk_submit_bdev_io(q, io);
 		break;
 	}
@@ -1358,6 +1430,8 @@ ublk_io_recv(struct ublk_queue *q)
 		return 0;
 	}
 
+	ublk_uring_get_events(q);
+
 	iobuf_ch = &q->poll_group->iobuf_ch;
 	io_uring_for_each_cqe(&q->ring, head, cqe) {
 		tag = user_data_to_tag(cqe->user_data);
@@ -1502,7 +1576,14 @@ ublk_dev_queue_init(struct ublk_queue *q)
 		q->ios[j].iod = &q->io_cmd_buf[j];
 	}
 
-	rc = ublk_setup_ring(q->q_depth, &q->ring, IORING_SETUP_SQE128);
+	/* Avoid interrupting the ublk thread for each completion, it polls the ring anyway */
+	rc = ublk_setup_ring(q->q_depth, &q->ring, IORING_SETUP_SQE128 | IORING_SETUP_COOP_TASKRUN |
+			     IORING_SETUP_TASKRUN_FLAG);
+	q->coop_taskrun = rc == 0;
+	if (rc == -EINVAL) {
+		/* Kernels older than 5.19 */
+		rc = ublk_setup_ring(q->q_depth, &q->ring, IORING_SETUP_SQE128);
+	}
 	if (rc < 0) {
 		SPDK_ERRLOG("Failed at setup uring: %s\n", spdk_strerror(-rc));
 		munmap(q->io_cmd_buf, ublk_queue_cmd_buf_sz(q->q_depth));
@@ -1858,6 +1939,37 @@ ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 	return rc;
 }
 
+/*
+ * Pick the poll group with the fewest queues.  ublk threads are bound to their cores, as the
+ *  io_uring commands of a queue have to be issued by the same task, so queues can't be moved
+ *  once started.  Balancing on the number of queues keeps the poll groups even as disks are
+ *  started and stopped, which plain round-robin doesn't.
+ */
+static struct ublk_poll_group *
+ublk_get_poll_group(void)
+{
+	struct ublk_poll_group *poll_group, *min_poll_group = NULL;
+	uint32_t i, num_queues, min_num_queues = UINT32_MAX;
+
+	/* Start with the next poll group in round-robin order to break ties evenly */
+	for (i = 0; i < g_num_ublk_poll_groups; i++) {
+		poll_group = &g_ublk_tgt.poll_groups[(g_next_ublk_poll_group + i) %
+						     g_num_ublk_poll_groups];
+		num_queues = __atomic_load_n(&poll_group->num_queues, __ATOMIC_RELAXED);
+		if (num_queues < min_num_queues) {
+			min_poll_group = poll_group;
+			min_num_queues = num_queues;
+		}
+	}
+
+	assert(min_poll_group != NULL);
+	g_next_ublk_poll_group = (min_poll_group - g_ublk_tgt.poll_groups + 1) %
+				 g_num_ublk_poll_groups;
+	__atomic_fetch_add(&min_poll_group->num_queues, 1, __ATOMIC_RELAXED);
+
+	return min_poll_group;
+}
+
 static void
 ublk_finish_start(struct spdk_ublk_dev *ublk)
 {
@@ -1890,13 +2002,9 @@ ublk_finish_start(struct spdk_ublk_dev *ublk)
 
 	/* Send queue to different spdk_threads for load balance */
 	for (q_id = 0; q_id < ublk->num_queues; q_id++) {
-		ublk->queues[q_id].poll_group = &g_ublk_tgt.poll_groups[g_next_ublk_poll_group];
-		ublk_thread = g_ublk_tgt.poll_groups[g_next_ublk_poll_group].ublk_thread;
+		ublk->queues[q_id].poll_group = ublk_get_poll_group();
+		ublk_thread = ublk->queues[q_id].poll_group->ublk_thread;
 		spdk_thread_send_msg(ublk_thread, ublk_queue_run, &ublk->queues[q_id]);
-		g_next_ublk_poll_group++;
-		if (g_next_ublk_poll_group == g_num_ublk_poll_groups) {
-			g_next_ublk_poll_group = 0;
-		}
 	}
 
 	goto out;
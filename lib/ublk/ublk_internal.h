@@ -24,6 +24,18 @@
 #define UBLK_U_CMD_GET_FEATURES	_IOR('u', 0x13, struct ublksrv_ctrl_cmd)
 #endif
 
+#ifndef IORING_SETUP_COOP_TASKRUN
+#define IORING_SETUP_COOP_TASKRUN	(1U << 8)
+#endif
+
+#ifndef IORING_SETUP_TASKRUN_FLAG
+#define IORING_SETUP_TASKRUN_FLAG	(1U << 9)
+#endif
+
+#ifndef IORING_SQ_TASKRUN
+#define IORING_SQ_TASKRUN	(1U << 1)
+#endif
+
 #ifndef UBLKSRV_IO_BUF_OFFSET
 #define UBLKSRV_IO_BUF_OFFSET	0x80000000
 #endif
@@ -68,6 +80,7 @@ struct spdk_ublk_dev *ublk_dev_first(void);
 struct spdk_ublk_dev *ublk_dev_next(struct spdk_ublk_dev *prev);
 uint32_t ublk_dev_get_queue_depth(struct spdk_ublk_dev *ublk);
 uint32_t ublk_dev_get_num_queues(struct spdk_ublk_dev *ublk);
+void ublk_dev_dump_queues_json(struct spdk_ublk_dev *ublk, struct spdk_json_write_ctx *w);
 
 #ifdef __cplusplus
 }
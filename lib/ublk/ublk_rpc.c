@@ -230,6 +230,7 @@ rpc_dump_ublk_info(struct spdk_json_write_ctx *w,
 	spdk_json_write_named_uint32(w, "queue_depth", ublk_dev_get_queue_depth(ublk));
 	spdk_json_write_named_uint32(w, "num_queues", ublk_dev_get_num_queues(ublk));
 	spdk_json_write_named_string(w, "bdev_name", ublk_dev_get_bdev_name(ublk));
+	ublk_dev_dump_queues_json(ublk, w);
 
 	spdk_json_write_object_end(w);
 }
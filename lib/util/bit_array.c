@@ -21,8 +21,15 @@ typedef uint64_t spdk_bit_array_word;
 #define SPDK_BIT_ARRAY_WORD_INDEX_SHIFT	spdk_u32log2(SPDK_BIT_ARRAY_WORD_BITS)
 #define SPDK_BIT_ARRAY_WORD_INDEX_MASK	((1u << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) - 1)
 
+/*
+ * The summaries hold one bit per word of words[], including the extra word past the end.  A bit
+ * of set_summary is set if the word has any bit set and a bit of clear_summary is set if the word
+ * has any bit cleared, so that the find_first functions can skip 64 words at a time.
+ */
 struct spdk_bit_array {
 	uint32_t bit_count;
+	spdk_bit_array_word *set_summary;
+	spdk_bit_array_word *clear_summary;
 	spdk_bit_array_word words[];
 };
 
@@ -47,6 +54,9 @@ spdk_bit_array_free(struct spdk_bit_array **bap)
 
 	ba = *bap;
 	*bap = NULL;
+	if (ba != NULL) {
+		free(ba->set_summary);
+	}
 	spdk_free(ba);
 }
 
@@ -63,11 +73,123 @@ bit_array_word_mask(uint32_t num_bits)
 	return (SPDK_BIT_ARRAY_WORD_C(1) << num_bits) - 1;
 }
 
+static inline uint32_t
+bit_array_summary_word_count(uint32_t word_count)
+{
+	/* Account for the extra word past the end */
+	return bit_array_word_count(word_count + 1);
+}
+
+static inline void
+bit_words_set(spdk_bit_array_word *words, uint32_t bit_index)
+{
+	words[bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT] |=
+		SPDK_BIT_ARRAY_WORD_C(1) << (bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+}
+
+static inline void
+bit_words_clear(spdk_bit_array_word *words, uint32_t bit_index)
+{
+	words[bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT] &=
+		~(SPDK_BIT_ARRAY_WORD_C(1) << (bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK));
+}
+
+static inline void
+bit_word_fill(spdk_bit_array_word *word, spdk_bit_array_word mask, bool value)
+{
+	if (value) {
+		*word |= mask;
+	} else {
+		*word &= ~mask;
+	}
+}
+
+/* Set or clear num_bits bits starting at start_bit_index, a whole word at a time */
+static void
+bit_words_fill(spdk_bit_array_word *words, uint32_t start_bit_index, uint32_t num_bits,
+	       bool value)
+{
+	uint32_t first_word_index, last_word_index, end_bit_index;
+	spdk_bit_array_word first_word_mask, last_word_mask;
+
+	if (num_bits == 0) {
+		return;
+	}
+
+	first_word_index = start_bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	last_word_index = (start_bit_index + num_bits - 1) >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	first_word_mask = ~bit_array_word_mask(start_bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+	end_bit_index = (start_bit_index + num_bits) & SPDK_BIT_ARRAY_WORD_INDEX_MASK;
+	last_word_mask = end_bit_index ? bit_array_word_mask(end_bit_index) :
+			 SPDK_BIT_ARRAY_WORD_C(-1);
+
+	if (first_word_index == last_word_index) {
+		bit_word_fill(&words[first_word_index], first_word_mask & last_word_mask, value);
+		return;
+	}
+
+	bit_word_fill(&words[first_word_index], first_word_mask, value);
+	memset(&words[first_word_index + 1], value ? 0xff : 0,
+	       (last_word_index - first_word_index - 1) * SPDK_BIT_ARRAY_WORD_BYTES);
+	bit_word_fill(&words[last_word_index], last_word_mask, value);
+}
+
+/* Find the first set bit at or after start_bit_index, which must exist */
+static inline uint32_t
+bit_words_find_first_set(const spdk_bit_array_word *words, uint32_t start_bit_index)
+{
+	const spdk_bit_array_word *cur_word;
+	spdk_bit_array_word word;
+
+	cur_word = &words[start_bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT];
+	word = *cur_word & ~bit_array_word_mask(start_bit_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+	while (word == 0) {
+		word = *++cur_word;
+	}
+
+	return (cur_word - words) * SPDK_BIT_ARRAY_WORD_BITS + SPDK_BIT_ARRAY_WORD_TZCNT(word);
+}
+
+static inline void
+bit_array_update_summary(struct spdk_bit_array *ba, uint32_t word_index)
+{
+	spdk_bit_array_word word = ba->words[word_index];
+
+	if (word != 0) {
+		bit_words_set(ba->set_summary, word_index);
+	} else {
+		bit_words_clear(ba->set_summary, word_index);
+	}
+
+	if (word != SPDK_BIT_ARRAY_WORD_C(-1)) {
+		bit_words_set(ba->clear_summary, word_index);
+	} else {
+		bit_words_clear(ba->clear_summary, word_index);
+	}
+}
+
+static void
+bit_array_rebuild_summary(struct spdk_bit_array *ba)
+{
+	uint32_t word_count, word_index;
+
+	word_count = bit_array_word_count(ba->bit_count);
+	memset(ba->set_summary, 0, bit_array_summary_word_count(word_count) *
+	       SPDK_BIT_ARRAY_WORD_BYTES);
+	memset(ba->clear_summary, 0, bit_array_summary_word_count(word_count) *
+	       SPDK_BIT_ARRAY_WORD_BYTES);
+
+	for (word_index = 0; word_index <= word_count; word_index++) {
+		bit_array_update_summary(ba, word_index);
+	}
+}
+
 int
 spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 {
 	struct spdk_bit_array *new_ba;
-	uint32_t old_word_count, new_word_count;
+	uint32_t old_word_count, new_word_count, summary_word_count;
+	spdk_bit_array_word *summary;
 	size_t new_size;
 
 	/*
@@ -87,8 +209,15 @@ spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 	 */
 	new_size += SPDK_BIT_ARRAY_WORD_BYTES;
 
+	summary_word_count = bit_array_summary_word_count(new_word_count);
+	summary = calloc(summary_word_count * 2, SPDK_BIT_ARRAY_WORD_BYTES);
+	if (!summary) {
+		return -ENOMEM;
+	}
+
 	new_ba = (struct spdk_bit_array *)spdk_realloc(*bap, new_size, 64);
 	if (!new_ba) {
+		free(summary);
 		return -ENOMEM;
 	}
 
@@ -106,8 +235,12 @@ spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 		new_ba->bit_count = 0;
 	} else {
 		old_word_count = bit_array_word_count(new_ba->bit_count);
+		free(new_ba->set_summary);
 	}
 
+	new_ba->set_summary = summary;
+	new_ba->clear_summary = summary + summary_word_count;
+
 	if (new_word_count > old_word_count) {
 		/* Zero out new entries */
 		memset(&new_ba->words[old_word_count], 0,
@@ -123,6 +256,7 @@ spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 	}
 
 	new_ba->bit_count = num_bits;
+	bit_array_rebuild_summary(new_ba);
 	*bap = new_ba;
 	return 0;
 }
@@ -169,6 +303,10 @@ spdk_bit_array_set(struct spdk_bit_array *ba, uint32_t bit_index)
 	}
 
 	ba->words[word_index] |= (SPDK_BIT_ARRAY_WORD_C(1) << word_bit_index);
+	bit_words_set(ba->set_summary, word_index);
+	if (spdk_unlikely(ba->words[word_index] == SPDK_BIT_ARRAY_WORD_C(-1))) {
+		bit_words_clear(ba->clear_summary, word_index);
+	}
 	return 0;
 }
 
@@ -186,6 +324,60 @@ spdk_bit_array_clear(struct spdk_bit_array *ba, uint32_t bit_index)
 	}
 
 	ba->words[word_index] &= ~(SPDK_BIT_ARRAY_WORD_C(1) << word_bit_index);
+	bit_words_set(ba->clear_summary, word_index);
+	if (spdk_unlikely(ba->words[word_index] == 0)) {
+		bit_words_clear(ba->set_summary, word_index);
+	}
+}
+
+static void
+bit_array_fill(struct spdk_bit_array *ba, uint32_t start_bit_index, uint32_t num_bits,
+	       bool value)
+{
+	uint32_t first_word_index, last_word_index;
+
+	if (num_bits == 0) {
+		return;
+	}
+
+	first_word_index = start_bit_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	last_word_index = (start_bit_index + num_bits - 1) >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+
+	bit_words_fill(ba->words, start_bit_index, num_bits, value);
+
+	bit_array_update_summary(ba, first_word_index);
+	bit_array_update_summary(ba, last_word_index);
+	if (last_word_index - first_word_index > 1) {
+		/* The words in between are now either all ones or all zeroes */
+		bit_words_fill(ba->set_summary, first_word_index + 1,
+			       last_word_index - first_word_index - 1, value);
+		bit_words_fill(ba->clear_summary, first_word_index + 1,
+			       last_word_index - first_word_index - 1, !value);
+	}
+}
+
+int
+spdk_bit_array_set_range(struct spdk_bit_array *ba, uint32_t start_bit_index, uint32_t num_bits)
+{
+	if (spdk_unlikely(start_bit_index > ba->bit_count ||
+			  num_bits > ba->bit_count - start_bit_index)) {
+		return -EINVAL;
+	}
+
+	bit_array_fill(ba, start_bit_index, num_bits, true);
+	return 0;
+}
+
+void
+spdk_bit_array_clear_range(struct spdk_bit_array *ba, uint32_t start_bit_index, uint32_t num_bits)
+{
+	if (start_bit_index >= ba->bit_count) {
+		return;
+	}
+
+	/* Bits past the end of the bit array are implicitly 0 */
+	num_bits = spdk_min(num_bits, ba->bit_count - start_bit_index);
+	bit_array_fill(ba, start_bit_index, num_bits, false);
 }
 
 static inline uint32_t
@@ -194,7 +386,7 @@ bit_array_find_first(const struct spdk_bit_array *ba, uint32_t start_bit_index,
 {
 	uint32_t word_index, first_word_bit_index;
 	spdk_bit_array_word word, first_word_mask;
-	const spdk_bit_array_word *words, *cur_word;
+	const spdk_bit_array_word *words, *cur_word, *summary;
 
 	if (spdk_unlikely(start_bit_index >= ba->bit_count)) {
 		return ba->bit_count;
@@ -215,10 +407,14 @@ bit_array_find_first(const struct spdk_bit_array *ba, uint32_t start_bit_index,
 
 	/*
 	 * spdk_bit_array_resize() guarantees that an extra word with a 1 and a 0 will always be
-	 * at the end of the words[] array, so just keep going until a word matches.
+	 * at the end of the words[] array, so the summary always has a matching word.
 	 */
-	while (word == 0) {
-		word = *++cur_word ^ xor_mask;
+	if (word == 0) {
+		summary = xor_mask ? ba->clear_summary : ba->set_summary;
+		word_index = bit_words_find_first_set(summary, word_index + 1);
+		cur_word = &words[word_index];
+		word = *cur_word ^ xor_mask;
+		assert(word != 0);
 	}
 
 	return ((uintptr_t)cur_word - (uintptr_t)words) * 8 + SPDK_BIT_ARRAY_WORD_TZCNT(word);
@@ -261,6 +457,35 @@ spdk_bit_array_find_first_clear(const struct spdk_bit_array *ba, uint32_t start_
 	return bit_index;
 }
 
+uint32_t
+spdk_bit_array_find_first_clear_range(const struct spdk_bit_array *ba, uint32_t start_bit_index,
+				      uint32_t num_bits)
+{
+	uint32_t bit_index = start_bit_index, end_bit_index;
+
+	if (num_bits == 0) {
+		return UINT32_MAX;
+	}
+
+	while (true) {
+		bit_index = spdk_bit_array_find_first_clear(ba, bit_index);
+		if (bit_index == UINT32_MAX || num_bits > ba->bit_count - bit_index) {
+			return UINT32_MAX;
+		}
+
+		end_bit_index = spdk_bit_array_find_first_set(ba, bit_index);
+		if (end_bit_index == UINT32_MAX) {
+			end_bit_index = ba->bit_count;
+		}
+
+		if (end_bit_index - bit_index >= num_bits) {
+			return bit_index;
+		}
+
+		bit_index = end_bit_index;
+	}
+}
+
 uint32_t
 spdk_bit_array_count_set(const struct spdk_bit_array *ba)
 {
@@ -319,6 +544,8 @@ spdk_bit_array_load_mask(struct spdk_bit_array *ba, const void *mask)
 			spdk_bit_array_clear(ba, i + size * CHAR_BIT);
 		}
 	}
+
+	bit_array_rebuild_summary(ba);
 }
 
 void
@@ -333,6 +560,8 @@ spdk_bit_array_clear_mask(struct spdk_bit_array *ba)
 	for (i = 0; i < num_bits % CHAR_BIT; i++) {
 		spdk_bit_array_clear(ba, i + size * CHAR_BIT);
 	}
+
+	bit_array_rebuild_summary(ba);
 }
 
 struct spdk_bit_pool {
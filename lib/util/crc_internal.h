@@ -19,4 +19,15 @@
 #include <x86intrin.h>
 #endif
 
+/* The multi-buffer CRC-32C kernel uses the CRC instructions directly, even when ISA-L is used
+ * for single buffers.
+ */
+#if defined(__x86_64__) && defined(__SSE4_2__)
+#include <x86intrin.h>
+#define crc32c_u64(crc, val)	_mm_crc32_u64(crc, val)
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define crc32c_u64(crc, val)	((uint64_t)__crc32cd((uint32_t)(crc), val))
+#endif
+
 #endif /* SPDK_CRC_INTERNAL_H */
@@ -602,24 +602,134 @@ _dif_generate(void *_dif, uint64_t guard, uint32_t offset_blocks,
 	}
 }
 
+/* Maximum number of blocks processed by a batch of the block aligned paths. The guards
+ * of a batch are computed in a first pass and the DIFs are applied in a second one, so
+ * that the CRC and the tag handling each run in a tight loop.
+ */
+#define DIF_BATCH_BLOCKS 16
+
+/* DIF image and mask shared by all blocks of a request. The flags, the DIF type and the
+ * PI format are resolved once when it is initialized, so that a block only needs its
+ * guard and its reference tag to be updated before the DIF is written or compared with
+ * a few masked 8 byte operations.
+ */
+struct _dif_batch {
+	struct spdk_dif	dif;
+	struct spdk_dif	mask;
+	uint32_t	dif_size;
+	uint64_t	ref_tag;
+	/* 0 for type 3, where the reference tag does not change across blocks */
+	uint32_t	ref_tag_incr;
+};
+
+static void
+_dif_batch_init(struct _dif_batch *batch, const struct spdk_dif_ctx *ctx, bool verify)
+{
+	memset(batch, 0, sizeof(*batch));
+	batch->dif_size = _dif_size(ctx->dif_pi_format);
+	batch->ref_tag = ctx->init_ref_tag + ctx->ref_tag_offset;
+	batch->ref_tag_incr = ctx->dif_type != SPDK_DIF_TYPE3 ? 1 : 0;
+
+	if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+		_dif_set_guard(&batch->mask, UINT64_MAX, ctx->dif_pi_format);
+	}
+
+	if (ctx->dif_flags & SPDK_DIF_FLAGS_APPTAG_CHECK) {
+		_dif_set_apptag(&batch->dif, ctx->app_tag, ctx->dif_pi_format);
+		_dif_set_apptag(&batch->mask, verify ? ctx->apptag_mask : UINT16_MAX,
+				ctx->dif_pi_format);
+	}
+
+	/* The Reference Tag field is not checked for type 3. */
+	if ((ctx->dif_flags & SPDK_DIF_FLAGS_REFTAG_CHECK) &&
+	    (!verify || ctx->dif_type != SPDK_DIF_TYPE3)) {
+		_dif_set_reftag(&batch->mask, UINT64_MAX, ctx->dif_pi_format);
+	}
+}
+
+static inline void
+_dif_batch_set(struct _dif_batch *batch, uint64_t guard, uint32_t offset_blocks,
+	       enum spdk_dif_pi_format dif_pi_format)
+{
+	_dif_set_guard(&batch->dif, guard, dif_pi_format);
+	_dif_set_reftag(&batch->dif, batch->ref_tag + batch->ref_tag_incr * offset_blocks,
+			dif_pi_format);
+}
+
+/* Write the fields of the DIF covered by the mask and leave the other bytes untouched. */
+static inline void
+_dif_batch_store(const struct _dif_batch *batch, uint8_t *dif)
+{
+	uint64_t val, img, mask;
+	uint32_t i;
+
+	for (i = 0; i < batch->dif_size; i += sizeof(uint64_t)) {
+		memcpy(&val, dif + i, sizeof(val));
+		memcpy(&img, (const uint8_t *)&batch->dif + i, sizeof(img));
+		memcpy(&mask, (const uint8_t *)&batch->mask + i, sizeof(mask));
+		val = (val & ~mask) | (img & mask);
+		memcpy(dif + i, &val, sizeof(val));
+	}
+}
+
+static inline bool
+_dif_batch_match(const struct _dif_batch *batch, const uint8_t *dif)
+{
+	uint64_t val, img, mask, diff = 0;
+	uint32_t i;
+
+	for (i = 0; i < batch->dif_size; i += sizeof(uint64_t)) {
+		memcpy(&val, dif + i, sizeof(val));
+		memcpy(&img, (const uint8_t *)&batch->dif + i, sizeof(img));
+		memcpy(&mask, (const uint8_t *)&batch->mask + i, sizeof(mask));
+		diff |= (val ^ img) & mask;
+	}
+
+	return diff == 0;
+}
+
+static void
+_dif_generate_batch(uint8_t *buf, uint32_t num_blocks, uint32_t offset_blocks,
+		    struct _dif_batch *batch, const struct spdk_dif_ctx *ctx)
+{
+	uint64_t guards[DIF_BATCH_BLOCKS] = {};
+	uint32_t i;
+
+	assert(num_blocks <= DIF_BATCH_BLOCKS);
+
+	if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+		for (i = 0; i < num_blocks; i++) {
+			guards[i] = _dif_generate_guard(ctx->guard_seed, buf + i * ctx->block_size,
+							ctx->guard_interval, ctx->dif_pi_format);
+		}
+	}
+
+	for (i = 0; i < num_blocks; i++) {
+		_dif_batch_set(batch, guards[i], offset_blocks + i, ctx->dif_pi_format);
+		_dif_batch_store(batch, buf + i * ctx->block_size + ctx->guard_interval);
+	}
+}
+
 static void
 dif_generate(struct _dif_sgl *sgl, uint32_t num_blocks, const struct spdk_dif_ctx *ctx)
 {
-	uint32_t offset_blocks = 0;
+	struct _dif_batch batch;
+	uint32_t offset_blocks = 0, buf_len, count;
 	uint8_t *buf;
-	uint64_t guard = 0;
+
+	_dif_batch_init(&batch, ctx, false);
 
 	while (offset_blocks < num_blocks) {
-		_dif_sgl_get_buf(sgl, &buf, NULL);
+		_dif_sgl_get_buf(sgl, &buf, &buf_len);
 
-		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
-			guard = _dif_generate_guard(ctx->guard_seed, buf, ctx->guard_interval, ctx->dif_pi_format);
-		}
+		/* Each iovec holds whole blocks, so a batch never crosses an iovec. */
+		count = spdk_min(buf_len / ctx->block_size, num_blocks - offset_blocks);
+		count = spdk_min(count, DIF_BATCH_BLOCKS);
 
-		_dif_generate(buf + ctx->guard_interval, guard, offset_blocks, ctx);
+		_dif_generate_batch(buf, count, offset_blocks, &batch, ctx);
 
-		_dif_sgl_advance(sgl, ctx->block_size);
-		offset_blocks++;
+		_dif_sgl_advance(sgl, count * ctx->block_size);
+		offset_blocks += count;
 	}
 }
 
@@ -846,29 +956,81 @@ _dif_verify(void *_dif, uint64_t guard, uint32_t offset_blocks,
 	return 0;
 }
 
+/* Compare the DIFs of a batch against the expected image and hand the blocks that do not
+ * match over to _dif_verify(), which applies the escape values of the Application and
+ * Reference Tags and reports the error.
+ */
+static inline int
+_dif_verify_batch_difs(uint8_t *buf, uint32_t stride, const uint64_t *guards,
+		       uint32_t num_blocks, uint32_t offset_blocks, struct _dif_batch *batch,
+		       const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err_blk)
+{
+	uint8_t *dif;
+	uint32_t i;
+	int rc;
+
+	for (i = 0; i < num_blocks; i++) {
+		dif = buf + i * stride + ctx->guard_interval;
+
+		_dif_batch_set(batch, guards[i], offset_blocks + i, ctx->dif_pi_format);
+		if (_dif_batch_match(batch, dif)) {
+			continue;
+		}
+
+		rc = _dif_verify(dif, guards[i], offset_blocks + i, ctx, err_blk);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+static int
+_dif_verify_batch(uint8_t *buf, uint32_t num_blocks, uint32_t offset_blocks,
+		  struct _dif_batch *batch, const struct spdk_dif_ctx *ctx,
+		  struct spdk_dif_error *err_blk)
+{
+	uint64_t guards[DIF_BATCH_BLOCKS] = {};
+	uint32_t i;
+
+	assert(num_blocks <= DIF_BATCH_BLOCKS);
+
+	if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+		for (i = 0; i < num_blocks; i++) {
+			guards[i] = _dif_generate_guard(ctx->guard_seed, buf + i * ctx->block_size,
+							ctx->guard_interval, ctx->dif_pi_format);
+		}
+	}
+
+	return _dif_verify_batch_difs(buf, ctx->block_size, guards, num_blocks, offset_blocks,
+				      batch, ctx, err_blk);
+}
+
 static int
 dif_verify(struct _dif_sgl *sgl, uint32_t num_blocks,
 	   const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err_blk)
 {
-	uint32_t offset_blocks = 0;
-	int rc;
+	struct _dif_batch batch;
+	uint32_t offset_blocks = 0, buf_len, count;
 	uint8_t *buf;
-	uint64_t guard = 0;
+	int rc;
+
+	_dif_batch_init(&batch, ctx, true);
 
 	while (offset_blocks < num_blocks) {
-		_dif_sgl_get_buf(sgl, &buf, NULL);
+		_dif_sgl_get_buf(sgl, &buf, &buf_len);
 
-		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
-			guard = _dif_generate_guard(ctx->guard_seed, buf, ctx->guard_interval, ctx->dif_pi_format);
-		}
+		count = spdk_min(buf_len / ctx->block_size, num_blocks - offset_blocks);
+		count = spdk_min(count, DIF_BATCH_BLOCKS);
 
-		rc = _dif_verify(buf + ctx->guard_interval, guard, offset_blocks, ctx, err_blk);
+		rc = _dif_verify_batch(buf, count, offset_blocks, &batch, ctx, err_blk);
 		if (rc != 0) {
 			return rc;
 		}
 
-		_dif_sgl_advance(sgl, ctx->block_size);
-		offset_blocks++;
+		_dif_sgl_advance(sgl, count * ctx->block_size);
+		offset_blocks += count;
 	}
 
 	return 0;
@@ -1074,35 +1236,65 @@ spdk_dif_update_crc32c(struct iovec *iovs, int iovcnt, uint32_t num_blocks,
 	return 0;
 }
 
+static void
+_dif_generate_copy_batch(uint8_t *dst, uint8_t *src, uint32_t num_blocks,
+			 uint32_t offset_blocks, struct _dif_batch *batch,
+			 const struct spdk_dif_ctx *ctx)
+{
+	uint64_t guards[DIF_BATCH_BLOCKS] = {};
+	uint32_t i, data_block_size;
+	uint8_t *_dst, *_src;
+
+	assert(num_blocks <= DIF_BATCH_BLOCKS);
+
+	data_block_size = ctx->block_size - ctx->md_size;
+
+	for (i = 0; i < num_blocks; i++) {
+		_dst = dst + i * ctx->block_size;
+		_src = src + i * data_block_size;
+
+		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+			guards[i] = _dif_generate_guard_copy(ctx->guard_seed, _dst, _src,
+							     data_block_size, ctx->dif_pi_format);
+			guards[i] = _dif_generate_guard(guards[i], _dst + data_block_size,
+							ctx->guard_interval - data_block_size,
+							ctx->dif_pi_format);
+		} else {
+			memcpy(_dst, _src, data_block_size);
+		}
+	}
+
+	for (i = 0; i < num_blocks; i++) {
+		_dif_batch_set(batch, guards[i], offset_blocks + i, ctx->dif_pi_format);
+		_dif_batch_store(batch, dst + i * ctx->block_size + ctx->guard_interval);
+	}
+}
+
 static void
 dif_generate_copy(struct _dif_sgl *src_sgl, struct _dif_sgl *dst_sgl,
 		  uint32_t num_blocks, const struct spdk_dif_ctx *ctx)
 {
-	uint32_t offset_blocks = 0, data_block_size;
+	struct _dif_batch batch;
+	uint32_t offset_blocks = 0, data_block_size, src_len, dst_len, count;
 	uint8_t *src, *dst;
-	uint64_t guard;
 
 	data_block_size = ctx->block_size - ctx->md_size;
 
+	_dif_batch_init(&batch, ctx, false);
+
 	while (offset_blocks < num_blocks) {
-		_dif_sgl_get_buf(src_sgl, &src, NULL);
-		_dif_sgl_get_buf(dst_sgl, &dst, NULL);
+		_dif_sgl_get_buf(src_sgl, &src, &src_len);
+		_dif_sgl_get_buf(dst_sgl, &dst, &dst_len);
 
-		guard = 0;
-		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
-			guard = _dif_generate_guard_copy(ctx->guard_seed, dst, src, data_block_size,
-							 ctx->dif_pi_format);
-			guard = _dif_generate_guard(guard, dst + data_block_size,
-						    ctx->guard_interval - data_block_size, ctx->dif_pi_format);
-		} else {
-			memcpy(dst, src, data_block_size);
-		}
+		count = spdk_min(src_len / data_block_size, dst_len / ctx->block_size);
+		count = spdk_min(count, num_blocks - offset_blocks);
+		count = spdk_min(count, DIF_BATCH_BLOCKS);
 
-		_dif_generate(dst + ctx->guard_interval, guard, offset_blocks, ctx);
+		_dif_generate_copy_batch(dst, src, count, offset_blocks, &batch, ctx);
 
-		_dif_sgl_advance(src_sgl, data_block_size);
-		_dif_sgl_advance(dst_sgl, ctx->block_size);
-		offset_blocks++;
+		_dif_sgl_advance(src_sgl, count * data_block_size);
+		_dif_sgl_advance(dst_sgl, count * ctx->block_size);
+		offset_blocks += count;
 	}
 }
 
@@ -1198,40 +1390,68 @@ spdk_dif_generate_copy(struct iovec *iovs, int iovcnt, struct iovec *bounce_iovs
 	return 0;
 }
 
+static int
+_dif_verify_copy_batch(uint8_t *dst, uint8_t *src, uint32_t num_blocks,
+		       uint32_t offset_blocks, struct _dif_batch *batch,
+		       const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err_blk)
+{
+	uint64_t guards[DIF_BATCH_BLOCKS] = {};
+	uint32_t i, data_block_size;
+	uint8_t *_dst, *_src;
+
+	assert(num_blocks <= DIF_BATCH_BLOCKS);
+
+	data_block_size = ctx->block_size - ctx->md_size;
+
+	for (i = 0; i < num_blocks; i++) {
+		_dst = dst + i * data_block_size;
+		_src = src + i * ctx->block_size;
+
+		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
+			guards[i] = _dif_generate_guard_copy(ctx->guard_seed, _dst, _src,
+							     data_block_size, ctx->dif_pi_format);
+			guards[i] = _dif_generate_guard(guards[i], _src + data_block_size,
+							ctx->guard_interval - data_block_size,
+							ctx->dif_pi_format);
+		} else {
+			memcpy(_dst, _src, data_block_size);
+		}
+	}
+
+	return _dif_verify_batch_difs(src, ctx->block_size, guards, num_blocks, offset_blocks,
+				      batch, ctx, err_blk);
+}
+
 static int
 dif_verify_copy(struct _dif_sgl *src_sgl, struct _dif_sgl *dst_sgl,
 		uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
 		struct spdk_dif_error *err_blk)
 {
-	uint32_t offset_blocks = 0, data_block_size;
+	struct _dif_batch batch;
+	uint32_t offset_blocks = 0, data_block_size, src_len, dst_len, count;
 	uint8_t *src, *dst;
 	int rc;
-	uint64_t guard;
 
 	data_block_size = ctx->block_size - ctx->md_size;
 
+	_dif_batch_init(&batch, ctx, true);
+
 	while (offset_blocks < num_blocks) {
-		_dif_sgl_get_buf(src_sgl, &src, NULL);
-		_dif_sgl_get_buf(dst_sgl, &dst, NULL);
+		_dif_sgl_get_buf(src_sgl, &src, &src_len);
+		_dif_sgl_get_buf(dst_sgl, &dst, &dst_len);
 
-		guard = 0;
-		if (ctx->dif_flags & SPDK_DIF_FLAGS_GUARD_CHECK) {
-			guard = _dif_generate_guard_copy(ctx->guard_seed, dst, src, data_block_size,
-							 ctx->dif_pi_format);
-			guard = _dif_generate_guard(guard, src + data_block_size,
-						    ctx->guard_interval - data_block_size, ctx->dif_pi_format);
-		} else {
-			memcpy(dst, src, data_block_size);
-		}
+		count = spdk_min(src_len / ctx->block_size, dst_len / data_block_size);
+		count = spdk_min(count, num_blocks - offset_blocks);
+		count = spdk_min(count, DIF_BATCH_BLOCKS);
 
-		rc = _dif_verify(src + ctx->guard_interval, guard, offset_blocks, ctx, err_blk);
+		rc = _dif_verify_copy_batch(dst, src, count, offset_blocks, &batch, ctx, err_blk);
 		if (rc != 0) {
 			return rc;
 		}
 
-		_dif_sgl_advance(src_sgl, ctx->block_size);
-		_dif_sgl_advance(dst_sgl, data_block_size);
-		offset_blocks++;
+		_dif_sgl_advance(src_sgl, count * ctx->block_size);
+		_dif_sgl_advance(dst_sgl, count * data_block_size);
+		offset_blocks += count;
 	}
 
 	return 0;
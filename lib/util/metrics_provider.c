@@ -0,0 +1,69 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/metrics.h"
+
+static const struct spdk_metrics_provider *g_metrics_provider;
+
+void
+spdk_metrics_set_provider(const struct spdk_metrics_provider *provider)
+{
+	assert(g_metrics_provider == NULL || g_metrics_provider == provider);
+	__atomic_store_n(&g_metrics_provider, provider, __ATOMIC_RELEASE);
+}
+
+bool
+spdk_metrics_enabled(void)
+{
+	return __atomic_load_n(&g_metrics_provider, __ATOMIC_ACQUIRE) != NULL;
+}
+
+struct spdk_metrics_group *
+spdk_metrics_group_register(const struct spdk_metric_desc *descs, uint32_t num_descs,
+			    const char *label_name, const char *label_value)
+{
+	const struct spdk_metrics_provider *provider;
+
+	provider = __atomic_load_n(&g_metrics_provider, __ATOMIC_ACQUIRE);
+	if (provider == NULL) {
+		return NULL;
+	}
+
+	return provider->group_register(descs, num_descs, label_name, label_value);
+}
+
+/*
+ * A group is only registered once a provider is set, and the provider is never changed
+ * afterwards, so the functions taking a group can use it directly.
+ */
+void
+spdk_metrics_group_unregister(struct spdk_metrics_group *group)
+{
+	if (group == NULL) {
+		return;
+	}
+
+	g_metrics_provider->group_unregister(group);
+}
+
+void
+spdk_metrics_counter_add(struct spdk_metrics_group *group, uint32_t idx, uint64_t value)
+{
+	g_metrics_provider->counter_add(group, idx, value);
+}
+
+void
+spdk_metrics_gauge_add(struct spdk_metrics_group *group, uint32_t idx, int64_t value)
+{
+	g_metrics_provider->gauge_add(group, idx, value);
+}
+
+void
+spdk_metrics_histogram_observe(struct spdk_metrics_group *group, uint32_t idx, uint64_t value)
+{
+	g_metrics_provider->histogram_observe(group, idx, value);
+}
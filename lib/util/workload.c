@@ -0,0 +1,450 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/workload.h"
+#include "spdk/zipf.h"
+
+#define WORKLOAD_MAX_REGIONS	16
+#define WORKLOAD_MAX_SIZES	16
+#define WORKLOAD_SECTOR_SIZE	512
+
+enum workload_dist {
+	WORKLOAD_DIST_UNIFORM,
+	WORKLOAD_DIST_SEQ,
+	WORKLOAD_DIST_ZIPF,
+	WORKLOAD_DIST_PARETO,
+	WORKLOAD_DIST_HOTCOLD,
+	WORKLOAD_DIST_REPLAY,
+};
+
+struct workload_region {
+	uint64_t	start;
+	uint64_t	end;
+	uint32_t	read_percentage;
+};
+
+struct workload_size {
+	uint64_t	size;
+	uint32_t	weight;
+};
+
+struct workload_record {
+	uint64_t	offset;
+	uint64_t	size;
+	bool		is_read;
+};
+
+struct spdk_workload {
+	enum workload_dist		dist;
+	uint64_t			range;
+	uint32_t			unit_size;
+	uint32_t			read_percentage;
+	uint32_t			seed;
+
+	/* seq */
+	uint64_t			next_offset;
+	uint32_t			jump_percentage;
+
+	/* zipf */
+	struct spdk_zipf		*zipf;
+
+	/* pareto */
+	double				pareto_pow;
+
+	/* hotcold */
+	uint64_t			hot_range;
+	uint32_t			hot_access_percentage;
+
+	/* replay */
+	struct workload_record		*records;
+	size_t				num_records;
+	size_t				next_record;
+
+	struct workload_region		regions[WORKLOAD_MAX_REGIONS];
+	uint32_t			num_regions;
+
+	struct workload_size		sizes[WORKLOAD_MAX_SIZES];
+	uint32_t			num_sizes;
+	uint64_t			total_weight;
+};
+
+static inline uint64_t
+workload_rand(struct spdk_workload *workload, uint64_t range)
+{
+	uint64_t val;
+
+	/* RAND_MAX is only INT32_MAX, so use 2 calls to rand_r to cover large ranges */
+	val = (uint64_t)rand_r(&workload->seed) * RAND_MAX + rand_r(&workload->seed);
+
+	return val % range;
+}
+
+static inline bool
+workload_percent(struct spdk_workload *workload, uint32_t percentage)
+{
+	return percentage == 100 ||
+	       (percentage != 0 && (uint32_t)(rand_r(&workload->seed) % 100) < percentage);
+}
+
+static int
+workload_parse_percentage(const char *str, char **endptr, uint32_t *percentage)
+{
+	unsigned long val;
+
+	errno = 0;
+	val = strtoul(str, endptr, 10);
+	if (errno || *endptr == str || val > 100) {
+		return -EINVAL;
+	}
+
+	*percentage = val;
+	return 0;
+}
+
+static int
+workload_load_trace(struct spdk_workload *workload, const char *path)
+{
+	struct workload_record *records, *record;
+	size_t max_records = 0;
+	char line[256], op[16];
+	uint64_t sector, sectors;
+	FILE *file;
+	int rc;
+
+	file = fopen(path, "r");
+	if (file == NULL) {
+		rc = -errno;
+		SPDK_ERRLOG("Could not open trace %s: %s\n", path, spdk_strerror(-rc));
+		return rc;
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (sscanf(line, "%15s %" SCNu64 " %" SCNu64, op, &sector, &sectors) != 3) {
+			continue;
+		}
+		if (strchr(op, 'R') == NULL && strchr(op, 'W') == NULL) {
+			continue;
+		}
+
+		if (workload->num_records == max_records) {
+			max_records = spdk_max(max_records * 2, 1024);
+			records = realloc(workload->records, max_records * sizeof(*records));
+			if (records == NULL) {
+				fclose(file);
+				return -ENOMEM;
+			}
+			workload->records = records;
+		}
+
+		record = &workload->records[workload->num_records++];
+		record->offset = sector * WORKLOAD_SECTOR_SIZE / workload->unit_size;
+		record->size = spdk_max(spdk_divide_round_up(sectors * WORKLOAD_SECTOR_SIZE,
+					workload->unit_size), 1);
+		record->is_read = strchr(op, 'R') != NULL;
+	}
+
+	fclose(file);
+
+	if (workload->num_records == 0) {
+		SPDK_ERRLOG("No read or write I/O in trace %s\n", path);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+workload_parse_dist(struct spdk_workload *workload, char *str)
+{
+	char *param, *endptr;
+	double val;
+	uint32_t hot;
+	int rc;
+
+	param = strchr(str, ':');
+	if (param != NULL) {
+		*param++ = '\0';
+	}
+
+	if (strcmp(str, "uniform") == 0 && param == NULL) {
+		workload->dist = WORKLOAD_DIST_UNIFORM;
+	} else if (strcmp(str, "seq") == 0) {
+		workload->dist = WORKLOAD_DIST_SEQ;
+		if (param != NULL) {
+			rc = workload_parse_percentage(param, &endptr, &workload->jump_percentage);
+			if (rc != 0 || *endptr != '\0') {
+				return -EINVAL;
+			}
+		}
+	} else if (strcmp(str, "zipf") == 0 && param != NULL) {
+		workload->dist = WORKLOAD_DIST_ZIPF;
+		errno = 0;
+		val = strtod(param, &endptr);
+		if (errno || endptr == param || *endptr != '\0' || val <= 0 || val == 1.0) {
+			return -EINVAL;
+		}
+		workload->zipf = spdk_zipf_create(workload->range, val, workload->seed);
+		if (workload->zipf == NULL) {
+			return -ENOMEM;
+		}
+	} else if (strcmp(str, "pareto") == 0 && param != NULL) {
+		workload->dist = WORKLOAD_DIST_PARETO;
+		errno = 0;
+		val = strtod(param, &endptr);
+		if (errno || endptr == param || *endptr != '\0' || val <= 0 || val >= 1.0) {
+			return -EINVAL;
+		}
+		workload->pareto_pow = log(val) / log(1.0 - val);
+	} else if (strcmp(str, "hotcold") == 0 && param != NULL) {
+		workload->dist = WORKLOAD_DIST_HOTCOLD;
+		rc = workload_parse_percentage(param, &endptr, &hot);
+		if (rc != 0 || *endptr != '/' || hot == 0 || hot == 100) {
+			return -EINVAL;
+		}
+		param = endptr + 1;
+		rc = workload_parse_percentage(param, &endptr, &workload->hot_access_percentage);
+		if (rc != 0 || *endptr != '\0') {
+			return -EINVAL;
+		}
+		workload->hot_range = spdk_max(workload->range * hot / 100, 1);
+	} else if (strcmp(str, "replay") == 0 && param != NULL) {
+		workload->dist = WORKLOAD_DIST_REPLAY;
+		return workload_load_trace(workload, param);
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+workload_parse_region(struct spdk_workload *workload, char *str)
+{
+	struct workload_region *region;
+	uint32_t start, end, read_percentage;
+	char *endptr;
+
+	if (workload->num_regions == WORKLOAD_MAX_REGIONS) {
+		return -ENOSPC;
+	}
+
+	if (workload_parse_percentage(str, &endptr, &start) != 0 || *endptr != '-') {
+		return -EINVAL;
+	}
+	str = endptr + 1;
+	if (workload_parse_percentage(str, &endptr, &end) != 0 || *endptr != ':' || end <= start) {
+		return -EINVAL;
+	}
+	str = endptr + 1;
+	if (workload_parse_percentage(str, &endptr, &read_percentage) != 0 || *endptr != '\0') {
+		return -EINVAL;
+	}
+
+	region = &workload->regions[workload->num_regions++];
+	region->start = workload->range * start / 100;
+	region->end = workload->range * end / 100;
+	region->read_percentage = read_percentage;
+
+	return 0;
+}
+
+static int
+workload_parse(struct spdk_workload *workload, const char *spec)
+{
+	char *str, *tok, *sp = NULL;
+	int rc;
+
+	str = strdup(spec);
+	if (str == NULL) {
+		return -ENOMEM;
+	}
+
+	tok = strtok_r(str, ",", &sp);
+	if (tok == NULL) {
+		free(str);
+		return -EINVAL;
+	}
+
+	rc = workload_parse_dist(workload, tok);
+	while (rc == 0 && (tok = strtok_r(NULL, ",", &sp)) != NULL) {
+		if (strncmp(tok, "rw=", 3) == 0) {
+			rc = workload_parse_region(workload, tok + 3);
+		} else {
+			rc = -EINVAL;
+		}
+	}
+
+	free(str);
+	return rc;
+}
+
+struct spdk_workload *
+spdk_workload_create(const char *spec, const struct spdk_workload_opts *opts)
+{
+	struct spdk_workload *workload;
+	int rc;
+
+	if (opts->range == 0 || opts->unit_size == 0 || opts->read_percentage > 100) {
+		SPDK_ERRLOG("Invalid workload options\n");
+		return NULL;
+	}
+
+	workload = calloc(1, sizeof(*workload));
+	if (workload == NULL) {
+		return NULL;
+	}
+
+	workload->range = opts->range;
+	workload->unit_size = opts->unit_size;
+	workload->read_percentage = opts->read_percentage;
+	workload->seed = opts->seed;
+
+	rc = workload_parse(workload, spec);
+	if (rc != 0) {
+		SPDK_ERRLOG("Invalid workload %s: %s\n", spec, spdk_strerror(-rc));
+		spdk_workload_free(&workload);
+		return NULL;
+	}
+
+	return workload;
+}
+
+void
+spdk_workload_free(struct spdk_workload **workloadp)
+{
+	struct spdk_workload *workload;
+
+	assert(workloadp != NULL);
+	workload = *workloadp;
+	if (workload == NULL) {
+		return;
+	}
+
+	spdk_zipf_free(&workload->zipf);
+	free(workload->records);
+	free(workload);
+	*workloadp = NULL;
+}
+
+int
+spdk_workload_add_size(struct spdk_workload *workload, uint64_t size, uint32_t weight)
+{
+	struct workload_size *wsize;
+
+	if (size == 0 || weight == 0 || size > workload->range) {
+		return -EINVAL;
+	}
+
+	if (workload->num_sizes == WORKLOAD_MAX_SIZES) {
+		return -ENOSPC;
+	}
+
+	wsize = &workload->sizes[workload->num_sizes++];
+	wsize->size = size;
+	wsize->weight = weight;
+	workload->total_weight += weight;
+
+	return 0;
+}
+
+static uint64_t
+workload_get_size(struct spdk_workload *workload)
+{
+	uint64_t val;
+	uint32_t i;
+
+	if (workload->num_sizes == 0) {
+		return 1;
+	}
+
+	val = workload_rand(workload, workload->total_weight);
+	for (i = 0; i < workload->num_sizes - 1; i++) {
+		if (val < workload->sizes[i].weight) {
+			break;
+		}
+		val -= workload->sizes[i].weight;
+	}
+
+	return workload->sizes[i].size;
+}
+
+static uint64_t
+workload_get_offset(struct spdk_workload *workload, uint64_t size)
+{
+	uint64_t offset;
+
+	switch (workload->dist) {
+	case WORKLOAD_DIST_SEQ:
+		offset = workload->next_offset;
+		if (workload->jump_percentage != 0 &&
+		    workload_percent(workload, workload->jump_percentage)) {
+			offset = workload_rand(workload, workload->range);
+		}
+		if (offset > workload->range - size) {
+			offset = 0;
+		}
+		workload->next_offset = offset + size;
+		return offset;
+	case WORKLOAD_DIST_ZIPF:
+		return spdk_zipf_generate(workload->zipf);
+	case WORKLOAD_DIST_PARETO:
+		return (workload->range - 1) *
+		       pow((double)rand_r(&workload->seed) / RAND_MAX, workload->pareto_pow);
+	case WORKLOAD_DIST_HOTCOLD:
+		if (workload->hot_range == workload->range ||
+		    workload_percent(workload, workload->hot_access_percentage)) {
+			return workload_rand(workload, workload->hot_range);
+		}
+		return workload->hot_range +
+		       workload_rand(workload, workload->range - workload->hot_range);
+	case WORKLOAD_DIST_UNIFORM:
+	default:
+		return workload_rand(workload, workload->range);
+	}
+}
+
+static bool
+workload_is_read(struct spdk_workload *workload, uint64_t offset)
+{
+	struct workload_region *region;
+	uint32_t i;
+
+	for (i = 0; i < workload->num_regions; i++) {
+		region = &workload->regions[i];
+		if (offset >= region->start && offset < region->end) {
+			return workload_percent(workload, region->read_percentage);
+		}
+	}
+
+	return workload_percent(workload, workload->read_percentage);
+}
+
+void
+spdk_workload_next(struct spdk_workload *workload, struct spdk_workload_io *io)
+{
+	struct workload_record *record;
+	uint64_t offset;
+
+	if (workload->dist == WORKLOAD_DIST_REPLAY) {
+		record = &workload->records[workload->next_record];
+		if (++workload->next_record == workload->num_records) {
+			workload->next_record = 0;
+		}
+
+		io->size = spdk_min(record->size, workload->range);
+		io->offset = spdk_min(record->offset % workload->range, workload->range - io->size);
+		io->is_read = record->is_read;
+		return;
+	}
+
+	io->size = workload_get_size(workload);
+	offset = workload_get_offset(workload, io->size);
+	io->offset = spdk_min(offset, workload->range - io->size);
+	io->is_read = workload_is_read(workload, io->offset);
+}
@@ -84,6 +84,246 @@ xor_gen_basic(void *dest, void **sources, uint32_t n, uint32_t len)
 	}
 }
 
+/* GF(2^8) log/exp tables for the polynomial 0x11d */
+static uint8_t g_gf_log[256];
+static uint8_t g_gf_exp[510];
+
+__attribute__((constructor)) static void
+xor_gf_tables_init(void)
+{
+	uint32_t i, x = 1;
+
+	for (i = 0; i < 255; i++) {
+		g_gf_exp[i] = x;
+		g_gf_exp[i + 255] = x;
+		g_gf_log[x] = i;
+		x <<= 1;
+		if (x & 0x100) {
+			x ^= 0x11d;
+		}
+	}
+}
+
+static inline uint8_t
+gf_mul(uint8_t a, uint8_t b)
+{
+	if (a == 0 || b == 0) {
+		return 0;
+	}
+
+	return g_gf_exp[g_gf_log[a] + g_gf_log[b]];
+}
+
+static inline uint8_t
+gf_inv(uint8_t a)
+{
+	assert(a != 0);
+	return g_gf_exp[255 - g_gf_log[a]];
+}
+
+/* g^e for the generator {02} */
+static inline uint8_t
+gf_pow2(int e)
+{
+	return g_gf_exp[((e % 255) + 255) % 255];
+}
+
+/* Multiply each byte of a word by {02} */
+static inline uint64_t
+gf_mul2_word(uint64_t w)
+{
+	return ((w << 1) & 0xfefefefefefefefeULL) ^ (((w >> 7) & 0x0101010101010101ULL) * 0x1d);
+}
+
+static inline uint8_t
+gf_mul2(uint8_t b)
+{
+	return (b << 1) ^ ((b & 0x80) ? 0x1d : 0);
+}
+
+/*
+ * Calculate P and/or Q of the sources, treating the sources at indexes skip1 and
+ * skip2 as zero-filled. Either p or q may be NULL if it's not needed.
+ */
+static void
+pq_gen_basic(void *p, void *q, void **sources, uint32_t n, uint32_t len,
+	     uint32_t skip1, uint32_t skip2)
+{
+	uint32_t i, len_div, len_rem;
+	int j;
+
+	len_div = 0;
+	if (buffers_aligned(p ? p : sources[0], sources, n, sizeof(uint64_t)) &&
+	    (q == NULL || is_aligned(q, sizeof(uint64_t)))) {
+		len_div = len / sizeof(uint64_t);
+	}
+	len_rem = len_div * sizeof(uint64_t);
+
+	for (i = 0; i < len_div; i++) {
+		uint64_t wp = 0, wq = 0;
+
+		for (j = n - 1; j >= 0; j--) {
+			wq = gf_mul2_word(wq);
+			if ((uint32_t)j != skip1 && (uint32_t)j != skip2) {
+				uint64_t d = ((uint64_t *)sources[j])[i];
+
+				wp ^= d;
+				wq ^= d;
+			}
+		}
+		if (p) {
+			((uint64_t *)p)[i] = wp;
+		}
+		if (q) {
+			((uint64_t *)q)[i] = wq;
+		}
+	}
+
+	for (i = len_rem; i < len; i++) {
+		uint8_t bp = 0, bq = 0;
+
+		for (j = n - 1; j >= 0; j--) {
+			bq = gf_mul2(bq);
+			if ((uint32_t)j != skip1 && (uint32_t)j != skip2) {
+				uint8_t d = ((uint8_t *)sources[j])[i];
+
+				bp ^= d;
+				bq ^= d;
+			}
+		}
+		if (p) {
+			((uint8_t *)p)[i] = bp;
+		}
+		if (q) {
+			((uint8_t *)q)[i] = bq;
+		}
+	}
+}
+
+#if defined(__AVX512F__)
+#define XOR_VEC_SIZE	64
+#elif defined(__AVX2__)
+#define XOR_VEC_SIZE	32
+#else
+#define XOR_VEC_SIZE	16
+#endif
+
+/*
+ * Vector of the widest SIMD registers enabled at build time. The compiler lowers the operations
+ * on it to AVX-512, AVX2, SSE2 or NEON instructions, depending on the target.
+ */
+typedef uint64_t xor_vec_t __attribute__((vector_size(XOR_VEC_SIZE)));
+
+static inline xor_vec_t
+xor_vec_load(const void *ptr)
+{
+	xor_vec_t v;
+
+	memcpy(&v, ptr, sizeof(v));
+	return v;
+}
+
+static inline void
+xor_vec_store(void *ptr, xor_vec_t v)
+{
+	memcpy(ptr, &v, sizeof(v));
+}
+
+/* Multiply each byte of a vector by {02}, same as gf_mul2_word() */
+static inline xor_vec_t
+gf_mul2_vec(xor_vec_t v)
+{
+	xor_vec_t hi = (v >> 7) & 0x0101010101010101ULL;
+
+	/* hi * 0x1d, without the 64-bit multiplication missing from most SIMD instruction sets */
+	return ((v << 1) & 0xfefefefefefefefeULL) ^ hi ^ (hi << 2) ^ (hi << 3) ^ (hi << 4);
+}
+
+/* Multiply each byte of a vector by the constant c */
+static inline xor_vec_t
+gf_mul_vec(xor_vec_t v, uint8_t c)
+{
+	xor_vec_t r = {};
+
+	while (c != 0) {
+		if (c & 1) {
+			r ^= v;
+		}
+		v = gf_mul2_vec(v);
+		c >>= 1;
+	}
+
+	return r;
+}
+
+static void
+xor_gen_vec(void *dest, void **sources, uint32_t n, uint32_t len)
+{
+	void *sources2[SPDK_XOR_MAX_SRC];
+	uint32_t i, j, len_vec;
+	xor_vec_t v;
+
+	len_vec = SPDK_ALIGN_FLOOR(len, XOR_VEC_SIZE);
+
+	for (i = 0; i < len_vec; i += XOR_VEC_SIZE) {
+		v = xor_vec_load((uint8_t *)sources[0] + i);
+		for (j = 1; j < n; j++) {
+			v ^= xor_vec_load((uint8_t *)sources[j] + i);
+		}
+		xor_vec_store((uint8_t *)dest + i, v);
+	}
+
+	if (len_vec < len) {
+		for (j = 0; j < n; j++) {
+			sources2[j] = (uint8_t *)sources[j] + len_vec;
+		}
+
+		xor_gen_basic((uint8_t *)dest + len_vec, sources2, n, len - len_vec);
+	}
+}
+
+/* Same as pq_gen_basic(), using the SIMD registers */
+static void
+pq_gen_vec(void *p, void *q, void **sources, uint32_t n, uint32_t len,
+	   uint32_t skip1, uint32_t skip2)
+{
+	void *sources2[SPDK_XOR_MAX_SRC];
+	uint32_t i, len_vec;
+	xor_vec_t vp, vq, d;
+	int j;
+
+	len_vec = SPDK_ALIGN_FLOOR(len, XOR_VEC_SIZE);
+
+	for (i = 0; i < len_vec; i += XOR_VEC_SIZE) {
+		vp = (xor_vec_t) {};
+		vq = (xor_vec_t) {};
+
+		for (j = n - 1; j >= 0; j--) {
+			vq = gf_mul2_vec(vq);
+			if ((uint32_t)j != skip1 && (uint32_t)j != skip2) {
+				d = xor_vec_load((uint8_t *)sources[j] + i);
+				vp ^= d;
+				vq ^= d;
+			}
+		}
+		if (p) {
+			xor_vec_store((uint8_t *)p + i, vp);
+		}
+		if (q) {
+			xor_vec_store((uint8_t *)q + i, vq);
+		}
+	}
+
+	if (len_vec < len) {
+		for (j = 0; j < (int)n; j++) {
+			sources2[j] = (uint8_t *)sources[j] + len_vec;
+		}
+
+		pq_gen_basic(p ? (uint8_t *)p + len_vec : NULL, q ? (uint8_t *)q + len_vec : NULL,
+			     sources2, n, len - len_vec, skip1, skip2);
+	}
+}
+
 #ifdef SPDK_CONFIG_ISAL
 #include "isa-l/include/raid.h"
 
@@ -106,7 +346,28 @@ do_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 			return -EINVAL;
 		}
 	} else {
-		xor_gen_basic(dest, sources, n, len);
+		xor_gen_vec(dest, sources, n, len);
+	}
+
+	return 0;
+}
+
+static int
+do_pq_gen(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	if (len % SPDK_XOR_BUF_ALIGN == 0 && is_aligned(q, SPDK_XOR_BUF_ALIGN) &&
+	    buffers_aligned(p, sources, n, SPDK_XOR_BUF_ALIGN)) {
+		void *buffers[SPDK_XOR_MAX_SRC + 2];
+
+		memcpy(buffers, sources, n * sizeof(buffers[0]));
+		buffers[n] = p;
+		buffers[n + 1] = q;
+
+		if (pq_gen(n + 2, len, buffers)) {
+			return -EINVAL;
+		}
+	} else {
+		pq_gen_vec(p, q, sources, n, len, UINT32_MAX, UINT32_MAX);
 	}
 
 	return 0;
@@ -114,12 +375,19 @@ do_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 
 #else
 
-#define SPDK_XOR_BUF_ALIGN sizeof(uint64_t)
+#define SPDK_XOR_BUF_ALIGN XOR_VEC_SIZE
 
 static inline int
 do_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 {
-	xor_gen_basic(dest, sources, n, len);
+	xor_gen_vec(dest, sources, n, len);
+	return 0;
+}
+
+static inline int
+do_pq_gen(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	pq_gen_vec(p, q, sources, n, len, UINT32_MAX, UINT32_MAX);
 	return 0;
 }
 
@@ -135,6 +403,126 @@ spdk_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len)
 	return do_xor_gen(dest, sources, n, len);
 }
 
+int
+spdk_xor_gen_pq(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	if (n < 2 || n > SPDK_XOR_MAX_SRC) {
+		return -EINVAL;
+	}
+
+	return do_pq_gen(p, q, sources, n, len);
+}
+
+/* Recover data buffer x using P, when Q is lost or not needed */
+static int
+recover_data_p(void **bufs, uint32_t n, uint32_t x, uint32_t len)
+{
+	void *sources[SPDK_XOR_MAX_SRC];
+	uint32_t i, c = 0;
+
+	for (i = 0; i <= n; i++) {
+		if (i != x) {
+			sources[c++] = bufs[i];
+		}
+	}
+
+	return spdk_xor_gen(bufs[x], sources, n, len);
+}
+
+/* Recover data buffer x using Q, when P is lost */
+static void
+recover_data_q(void **bufs, uint32_t n, uint32_t x, uint32_t len)
+{
+	uint8_t *dx = bufs[x];
+	uint8_t *q = bufs[n + 1];
+	uint8_t coef = gf_inv(gf_pow2(x));
+	uint32_t i, len_vec;
+
+	/* Calculate Q of the remaining data into the lost buffer */
+	pq_gen_vec(NULL, dx, bufs, n, len, x, UINT32_MAX);
+
+	len_vec = SPDK_ALIGN_FLOOR(len, XOR_VEC_SIZE);
+	for (i = 0; i < len_vec; i += XOR_VEC_SIZE) {
+		xor_vec_store(dx + i, gf_mul_vec(xor_vec_load(q + i) ^ xor_vec_load(dx + i), coef));
+	}
+
+	for (; i < len; i++) {
+		dx[i] = gf_mul(q[i] ^ dx[i], coef);
+	}
+}
+
+/* Recover data buffers x and y using both P and Q */
+static void
+recover_data_pq(void **bufs, uint32_t n, uint32_t x, uint32_t y, uint32_t len)
+{
+	uint8_t *dx = bufs[x];
+	uint8_t *dy = bufs[y];
+	uint8_t *p = bufs[n];
+	uint8_t *q = bufs[n + 1];
+	uint8_t gyx, denom, a, b;
+	uint32_t i, len_vec;
+
+	gyx = gf_pow2(y - x);
+	denom = gf_inv(gyx ^ 1);
+	a = gf_mul(gyx, denom);
+	b = gf_mul(gf_inv(gf_pow2(x)), denom);
+
+	/* Calculate P and Q of the remaining data into the lost buffers */
+	pq_gen_vec(dx, dy, bufs, n, len, x, y);
+
+	len_vec = SPDK_ALIGN_FLOOR(len, XOR_VEC_SIZE);
+	for (i = 0; i < len_vec; i += XOR_VEC_SIZE) {
+		xor_vec_t pxy = xor_vec_load(p + i) ^ xor_vec_load(dx + i);
+		xor_vec_t qxy = xor_vec_load(q + i) ^ xor_vec_load(dy + i);
+		xor_vec_t vx = gf_mul_vec(pxy, a) ^ gf_mul_vec(qxy, b);
+
+		xor_vec_store(dx + i, vx);
+		xor_vec_store(dy + i, pxy ^ vx);
+	}
+
+	for (; i < len; i++) {
+		uint8_t pxy = p[i] ^ dx[i];
+		uint8_t qxy = q[i] ^ dy[i];
+
+		dx[i] = gf_mul(pxy, a) ^ gf_mul(qxy, b);
+		dy[i] = pxy ^ dx[i];
+	}
+}
+
+int
+spdk_xor_recover_pq(void **bufs, uint32_t n, uint32_t lost1, uint32_t lost2, uint32_t len)
+{
+	int rc;
+
+	if (n < 2 || n > SPDK_XOR_MAX_SRC - 1 || lost1 >= lost2 || lost2 > n + 1) {
+		return -EINVAL;
+	}
+
+	if (lost1 == n) {
+		/* Both parities lost */
+		return spdk_xor_gen_pq(bufs[n], bufs[n + 1], bufs, n, len);
+	}
+
+	if (lost2 == n + 1) {
+		/* Data and Q lost */
+		rc = recover_data_p(bufs, n, lost1, len);
+		if (rc == 0) {
+			pq_gen_vec(NULL, bufs[n + 1], bufs, n, len, UINT32_MAX, UINT32_MAX);
+		}
+		return rc;
+	}
+
+	if (lost2 == n) {
+		/* Data and P lost */
+		recover_data_q(bufs, n, lost1, len);
+		return spdk_xor_gen(bufs[n], bufs, n, len);
+	}
+
+	recover_data_pq(bufs, n, lost1, lost2, len);
+
+	return 0;
+}
+
 size_t
 spdk_xor_get_optimal_alignment(void)
 {
@@ -159,6 +159,29 @@ vhost_log_used_vring_idx(struct spdk_vhost_session *vsession,
 	rte_vhost_log_used_vring(vsession->vid, vq_idx, offset, len);
 }
 
+/*
+ * With VIRTIO_RING_F_EVENT_IDX, the guest kicks the virtqueue once the avail index moves past
+ * the value stored right after the used ring.
+ */
+static inline void
+vhost_vq_set_avail_event(struct spdk_vhost_virtqueue *virtqueue, uint16_t avail_event)
+{
+	struct spdk_vhost_session *vsession = virtqueue->vsession;
+	struct vring_used *used = virtqueue->vring.used;
+	uint64_t offset;
+
+	*(volatile uint16_t *)&used->ring[virtqueue->vring.size] = avail_event;
+	if (spdk_unlikely(vhost_dev_has_feature(vsession, VHOST_F_LOG_ALL))) {
+		offset = offsetof(struct vring_used, ring) +
+			 virtqueue->vring.size * sizeof(used->ring[0]);
+		rte_vhost_log_used_vring(vsession->vid, virtqueue - vsession->virtqueue, offset,
+					 sizeof(avail_event));
+	}
+
+	/* Make the event index visible before the avail ring is checked again */
+	spdk_smp_mb();
+}
+
 /*
  * Get available requests from avail ring.
  */
@@ -173,10 +196,15 @@ vhost_vq_avail_ring_get(struct spdk_vhost_virtqueue *virtqueue, uint16_t *reqs,
 	uint16_t count, i;
 	int rc;
 	uint64_t u64_value;
+	bool kick_driven;
 
 	spdk_smp_rmb();
 
-	if (virtqueue->vsession && spdk_unlikely(virtqueue->vsession->interrupt_mode)) {
+	/* Kicks are only relied upon when the virtqueue isn't being polled */
+	kick_driven = virtqueue->vsession && spdk_unlikely(virtqueue->vsession->interrupt_mode) &&
+		      virtqueue->poller == NULL;
+
+	if (kick_driven) {
 		/* Read to clear vring's kickfd */
 		rc = read(vring->kickfd, &u64_value, sizeof(u64_value));
 		if (rc < 0) {
@@ -200,8 +228,13 @@ vhost_vq_avail_ring_get(struct spdk_vhost_virtqueue *virtqueue, uint16_t *reqs,
 	count = spdk_min(count, reqs_len);
 
 	virtqueue->last_avail_idx += count;
+	if (kick_driven && virtqueue->event_idx) {
+		/* Ask for a kick on the next request */
+		vhost_vq_set_avail_event(virtqueue, virtqueue->last_avail_idx);
+	}
+
 	/* Check whether there are unprocessed reqs in vq, then kick vq manually */
-	if (virtqueue->vsession && spdk_unlikely(virtqueue->vsession->interrupt_mode)) {
+	if (kick_driven) {
 		/* If avail_idx is larger than virtqueue's last_avail_idx, then there is unprocessed reqs.
 		 * avail_idx should get updated here from memory, in case of race condition with guest.
 		 */
@@ -346,22 +379,85 @@ vhost_inflight_queue_get_desc(struct spdk_vhost_session *vsession,
 	return 0;
 }
 
+/* Publish the used ring entries added since the last call */
+static inline void
+vhost_vq_used_ring_flush(struct spdk_vhost_session *vsession,
+			 struct spdk_vhost_virtqueue *virtqueue)
+{
+	struct vring_used *used = virtqueue->vring.used;
+
+	if (!virtqueue->batch_used || virtqueue->vring.desc == NULL ||
+	    used->idx == virtqueue->last_used_idx) {
+		return;
+	}
+
+	* (volatile uint16_t *) &used->idx = virtqueue->last_used_idx;
+	vhost_log_used_vring_idx(vsession, virtqueue);
+}
+
+/* Check whether the guest asked for an interrupt with VIRTIO_RING_F_EVENT_IDX */
+static inline bool
+vhost_vq_event_idx_need_signal(struct spdk_vhost_virtqueue *virtqueue)
+{
+	uint16_t used_event;
+
+	if (spdk_unlikely(!virtqueue->signalled_used_valid)) {
+		return true;
+	}
+
+	/* Make sure used->idx is visible before reading the event index */
+	spdk_smp_mb();
+	used_event = *(volatile uint16_t *)&virtqueue->vring.avail->ring[virtqueue->vring.size];
+
+	return vring_need_event(used_event, virtqueue->last_used_idx, virtqueue->signalled_used);
+}
+
+static int
+vhost_vq_call(struct spdk_vhost_session *vsession, struct spdk_vhost_virtqueue *virtqueue)
+{
+	uint64_t num_events = 1;
+
+	if (!virtqueue->event_idx) {
+		return rte_vhost_vring_call(vsession->vid, virtqueue->vring_idx);
+	}
+
+	/* rte_vhost_vring_call() would check the event index against its own used index, which
+	 * isn't updated as the used ring is managed here.
+	 */
+	if (virtqueue->vring.callfd < 0 ||
+	    write(virtqueue->vring.callfd, &num_events, sizeof(num_events)) < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
 int
 vhost_vq_used_signal(struct spdk_vhost_session *vsession,
 		     struct spdk_vhost_virtqueue *virtqueue)
 {
+	vhost_vq_used_ring_flush(vsession, virtqueue);
+
 	if (virtqueue->used_req_cnt == 0) {
 		return 0;
 	}
 
+	if (virtqueue->event_idx && !vhost_vq_event_idx_need_signal(virtqueue)) {
+		/* The guest doesn't want an interrupt yet */
+		return 0;
+	}
+
 	SPDK_DEBUGLOG(vhost_ring,
 		      "Queue %td - USED RING: sending IRQ: last used %"PRIu16"\n",
 		      virtqueue - vsession->virtqueue, virtqueue->last_used_idx);
 
-	if (rte_vhost_vring_call(vsession->vid, virtqueue->vring_idx) == 0) {
+	if (vhost_vq_call(vsession, virtqueue) == 0) {
 		/* interrupt signalled */
 		virtqueue->req_cnt += virtqueue->used_req_cnt;
 		virtqueue->used_req_cnt = 0;
+		virtqueue->signalled_used = virtqueue->last_used_idx;
+		virtqueue->signalled_used_valid = true;
+		virtqueue->stats_interrupts++;
 		return 1;
 	} else {
 		/* interrupt not signalled */
@@ -394,17 +490,23 @@ static void
 check_session_vq_io_stats(struct spdk_vhost_session *vsession,
 			  struct spdk_vhost_virtqueue *virtqueue, uint64_t now)
 {
-	if (now < vsession->next_stats_check_time) {
+	/* Tracked per virtqueue, as virtqueues of a session may be polled by different threads */
+	if (now < virtqueue->next_stats_check_time) {
 		return;
 	}
 
-	vsession->next_stats_check_time = now + vsession->stats_check_interval;
+	virtqueue->next_stats_check_time = now + vsession->stats_check_interval;
 	session_vq_io_stats_update(vsession, virtqueue, now);
 }
 
 static inline bool
 vhost_vq_event_is_suppressed(struct spdk_vhost_virtqueue *vq)
 {
+	if (vq->event_idx) {
+		/* The flags are ignored, the event index is checked when signalling */
+		return false;
+	}
+
 	if (spdk_unlikely(vq->packed.packed_ring)) {
 		if (vq->vring.driver_event->flags & VRING_PACKED_EVENT_FLAG_DISABLE) {
 			return true;
@@ -424,6 +526,9 @@ vhost_session_vq_used_signal(struct spdk_vhost_virtqueue *virtqueue)
 	struct spdk_vhost_session *vsession = virtqueue->vsession;
 	uint64_t now;
 
+	/* The entries are published even if the interrupt is delayed, the guest might be polling */
+	vhost_vq_used_ring_flush(vsession, virtqueue);
+
 	if (vsession->coalescing_delay_time_base == 0) {
 		if (virtqueue->vring.desc == NULL) {
 			return;
@@ -486,12 +591,15 @@ vhost_vq_used_ring_enqueue(struct spdk_vhost_session *vsession,
 	rte_vhost_set_last_inflight_io_split(vsession->vid, vq_idx, id);
 
 	vhost_log_used_vring_elem(vsession, virtqueue, last_idx);
-	* (volatile uint16_t *) &used->idx = virtqueue->last_used_idx;
-	vhost_log_used_vring_idx(vsession, virtqueue);
+	if (!virtqueue->batch_used || vsession->interrupt_mode) {
+		* (volatile uint16_t *) &used->idx = virtqueue->last_used_idx;
+		vhost_log_used_vring_idx(vsession, virtqueue);
+	}
 
 	rte_vhost_clr_inflight_desc_split(vsession->vid, vq_idx, virtqueue->last_used_idx, id);
 
 	virtqueue->used_req_cnt++;
+	virtqueue->stats_completions++;
 
 	if (vsession->interrupt_mode) {
 		if (virtqueue->vring.desc == NULL || vhost_vq_event_is_suppressed(virtqueue)) {
@@ -502,6 +610,23 @@ vhost_vq_used_ring_enqueue(struct spdk_vhost_session *vsession,
 	}
 }
 
+void
+vhost_vq_set_guest_notification(struct spdk_vhost_virtqueue *vq, bool enable)
+{
+	if (vq->event_idx) {
+		/* The flags are ignored, the guest kicks once it passes the avail event index */
+		vhost_vq_set_avail_event(vq, enable ? vq->last_avail_idx : vq->last_avail_idx - 1);
+	} else if (vq->packed.packed_ring) {
+		vq->vring.device_event->flags = enable ? VRING_PACKED_EVENT_FLAG_ENABLE :
+						VRING_PACKED_EVENT_FLAG_DISABLE;
+	} else {
+		vq->vring.used->flags = enable ? 0 : VRING_USED_F_NO_NOTIFY;
+	}
+
+	/* Make the flags visible before the caller checks the avail ring again */
+	spdk_smp_mb();
+}
+
 void
 vhost_vq_packed_ring_enqueue(struct spdk_vhost_session *vsession,
 			     struct spdk_vhost_virtqueue *virtqueue,
@@ -568,6 +693,7 @@ vhost_vq_packed_ring_enqueue(struct spdk_vhost_session *vsession,
 	}
 
 	virtqueue->used_req_cnt++;
+	virtqueue->stats_completions++;
 }
 
 bool
@@ -967,7 +1093,6 @@ new_connection(int vid)
 	}
 	vsession->started = false;
 	vsession->starting = false;
-	vsession->next_stats_check_time = 0;
 	vsession->stats_check_interval = SPDK_VHOST_STATS_CHECK_INTERVAL_MS *
 					 spdk_get_ticks_hz() / 1000UL;
 	TAILQ_INSERT_TAIL(&user_dev->vsessions, vsession, tailq);
@@ -1103,6 +1228,9 @@ enable_device_vq(struct spdk_vhost_session *vsession, uint16_t qid)
 			q->vring.device_event->flags = VRING_PACKED_EVENT_FLAG_ENABLE;
 		}
 	} else {
+		q->event_idx = vhost_dev_has_feature(vsession, VIRTIO_RING_F_EVENT_IDX);
+		q->batch_used = q->vring_inflight.inflight_split == NULL;
+
 		if (!spdk_interrupt_mode_is_enabled()) {
 			/* Disable I/O submission notifications, we'll be polling. */
 			q->vring.used->flags = VRING_USED_F_NO_NOTIFY;
@@ -1110,6 +1238,10 @@ enable_device_vq(struct spdk_vhost_session *vsession, uint16_t qid)
 			/* Enable I/O submission notifications, we'll be interrupting. */
 			q->vring.used->flags = 0;
 		}
+
+		if (q->event_idx) {
+			vhost_vq_set_guest_notification(q, spdk_interrupt_mode_is_enabled());
+		}
 	}
 
 	if (spdk_interrupt_mode_is_enabled() && backend->register_vq_interrupt) {
@@ -1952,6 +2084,29 @@ vhost_user_fini(spdk_vhost_fini_cb vhost_cb)
 	pthread_detach(tid);
 }
 
+static void
+vhost_session_vq_stats_json(struct spdk_vhost_session *vsession, struct spdk_json_write_ctx *w)
+{
+	struct spdk_vhost_virtqueue *vq;
+	uint16_t i;
+
+	spdk_json_write_named_array_begin(w, "virtqueues");
+	for (i = 0; vsession->started && i < vsession->max_queues; i++) {
+		vq = &vsession->virtqueue[i];
+		if (vq->vring.desc == NULL) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "id", i);
+		spdk_json_write_named_bool(w, "event_idx", vq->event_idx);
+		spdk_json_write_named_uint64(w, "completions", vq->stats_completions);
+		spdk_json_write_named_uint64(w, "interrupts", vq->stats_interrupts);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+}
+
 void
 vhost_session_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *w)
 {
@@ -1968,6 +2123,7 @@ vhost_session_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 		spdk_json_write_named_bool(w, "started", vsession->started);
 		spdk_json_write_named_uint32(w, "max_queues", vsession->max_queues);
 		spdk_json_write_named_uint32(w, "inflight_task_cnt", vsession->task_cnt);
+		vhost_session_vq_stats_json(vsession, w);
 		spdk_json_write_object_end(w);
 	}
 	pthread_mutex_unlock(&user_dev->lock);
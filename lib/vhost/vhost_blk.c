@@ -37,6 +37,9 @@
 
 #define VIRTIO_BLK_DEFAULT_TRANSPORT "vhost_user_blk"
 
+/* Number of requests received with a single kick that switches a virtqueue to polling */
+#define VHOST_BLK_VQ_POLL_BURST 2
+
 struct spdk_vhost_user_blk_task {
 	struct spdk_vhost_blk_task blk_task;
 	struct spdk_vhost_blk_session *bvsession;
@@ -58,6 +61,25 @@ struct spdk_vhost_blk_dev {
 	const struct spdk_virtio_blk_transport_ops *ops;
 
 	bool readonly;
+
+	/* Number of threads polling the virtqueues of each session, including vdev->thread */
+	uint32_t num_vq_threads;
+	/* Additional threads, virtqueue N is polled by vq_threads[N % num_vq_threads - 1] */
+	struct spdk_thread **vq_threads;
+
+	/* Number of idle polls after which a busy virtqueue goes back to interrupts, 0 disables
+	 * polling of busy virtqueues in interrupt mode.
+	 */
+	uint32_t vq_poll_idle_count;
+};
+
+/* Polls the virtqueues assigned to one of the additional threads of a session */
+struct vhost_blk_vq_poller {
+	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_poller *poller;
+	struct spdk_io_channel *io_channel;
+	/* Index of the thread, 1..num_vq_threads - 1 */
+	uint32_t index;
 };
 
 struct spdk_vhost_blk_session {
@@ -67,6 +89,11 @@ struct spdk_vhost_blk_session {
 	struct spdk_poller *requestq_poller;
 	struct spdk_io_channel *io_channel;
 	struct spdk_poller *stop_poller;
+
+	/* Pollers of the additional threads, num_vq_threads - 1 entries */
+	struct vhost_blk_vq_poller *vq_pollers;
+	/* Number of additional pollers that haven't released their resources yet */
+	uint32_t active_vq_pollers;
 };
 
 /* forward declaration */
@@ -75,14 +102,33 @@ static const struct spdk_vhost_dev_backend vhost_blk_device_backend;
 static void vhost_user_blk_request_finish(uint8_t status, struct spdk_vhost_blk_task *task,
 		void *cb_arg);
 
+static inline uint32_t
+blk_vq_thread_index(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_virtqueue *vq)
+{
+	return (uint32_t)(vq - bvsession->vsession.virtqueue) % bvsession->bvdev->num_vq_threads;
+}
+
+static struct spdk_io_channel *
+blk_task_get_io_channel(struct spdk_vhost_user_blk_task *task)
+{
+	struct spdk_vhost_blk_session *bvsession = task->bvsession;
+	uint32_t index = blk_vq_thread_index(bvsession, task->vq);
+
+	if (index == 0) {
+		return bvsession->io_channel;
+	}
+
+	return bvsession->vq_pollers[index - 1].io_channel;
+}
+
 static int
 vhost_user_process_blk_request(struct spdk_vhost_user_blk_task *user_task)
 {
 	struct spdk_vhost_blk_session *bvsession = user_task->bvsession;
 	struct spdk_vhost_dev *vdev = &bvsession->bvdev->vdev;
 
-	return virtio_blk_process_request(vdev, bvsession->io_channel, &user_task->blk_task,
-					  vhost_user_blk_request_finish, NULL);
+	return virtio_blk_process_request(vdev, blk_task_get_io_channel(user_task),
+					  &user_task->blk_task, vhost_user_blk_request_finish, NULL);
 }
 
 static struct spdk_vhost_blk_dev *
@@ -117,17 +163,26 @@ to_blk_session(struct spdk_vhost_session *vsession)
 	return (struct spdk_vhost_blk_session *)vsession;
 }
 
+/* The task count is shared by all the threads polling the virtqueues of a session */
 static inline void
 blk_task_inc_task_cnt(struct spdk_vhost_user_blk_task *task)
 {
-	task->bvsession->vsession.task_cnt++;
+	__atomic_fetch_add(&task->bvsession->vsession.task_cnt, 1, __ATOMIC_RELAXED);
 }
 
 static inline void
 blk_task_dec_task_cnt(struct spdk_vhost_user_blk_task *task)
 {
-	assert(task->bvsession->vsession.task_cnt > 0);
-	task->bvsession->vsession.task_cnt--;
+	int prev __attribute__((unused));
+
+	prev = __atomic_fetch_sub(&task->bvsession->vsession.task_cnt, 1, __ATOMIC_RELEASE);
+	assert(prev > 0);
+}
+
+static inline int
+blk_session_get_task_cnt(struct spdk_vhost_blk_session *bvsession)
+{
+	return __atomic_load_n(&bvsession->vsession.task_cnt, __ATOMIC_ACQUIRE);
 }
 
 static void
@@ -929,12 +984,82 @@ _vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
 
 }
 
+static int
+vdev_vq_poller(void *arg)
+{
+	struct spdk_vhost_virtqueue *vq = arg;
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vq->vsession->vdev);
+	uint64_t num_events = 1;
+
+	if (_vdev_vq_worker(vq) > 0) {
+		vq->idle_polls = 0;
+		return SPDK_POLLER_BUSY;
+	}
+
+	if (++vq->idle_polls < bvdev->vq_poll_idle_count) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	SPDK_DEBUGLOG(vhost_blk, "%s: vq %"PRIu32" is idle, switching to interrupts\n",
+		      vq->vsession->name, vq->vring_idx);
+	vhost_vq_set_guest_notification(vq, true);
+	spdk_poller_unregister(&vq->poller);
+
+	/* Requests submitted before the guest saw the notifications enabled weren't kicked */
+	if (write(vq->vring.kickfd, &num_events, sizeof(num_events)) < 0) {
+		SPDK_ERRLOG("failed to kick vring: %s.\n", spdk_strerror(errno));
+	}
+
+	return SPDK_POLLER_IDLE;
+}
+
+static void
+vhost_blk_vq_start_polling(struct spdk_vhost_virtqueue *vq)
+{
+	vq->idle_polls = 0;
+	vq->poller = SPDK_POLLER_REGISTER(vdev_vq_poller, vq, 0);
+	if (vq->poller == NULL) {
+		SPDK_ERRLOG("%s: failed to register poller for vq %"PRIu32"\n",
+			    vq->vsession->name, vq->vring_idx);
+		return;
+	}
+
+	SPDK_DEBUGLOG(vhost_blk, "%s: vq %"PRIu32" is busy, switching to polling\n",
+		      vq->vsession->name, vq->vring_idx);
+	vhost_vq_set_guest_notification(vq, false);
+}
+
+static void
+vhost_blk_vq_stop_polling(struct spdk_vhost_virtqueue *vq)
+{
+	if (vq->poller == NULL) {
+		return;
+	}
+
+	spdk_poller_unregister(&vq->poller);
+	vhost_vq_set_guest_notification(vq, true);
+}
+
 static int
 vdev_vq_worker(void *arg)
 {
 	struct spdk_vhost_virtqueue *vq = arg;
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vq->vsession->vdev);
+	uint64_t u64_value;
+	int rc;
+
+	if (vq->poller != NULL) {
+		/* Kick sent before the guest saw notifications disabled, the poller handles it */
+		rc = read(vq->vring.kickfd, &u64_value, sizeof(u64_value));
+		return rc < 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
+	}
 
-	return _vdev_vq_worker(vq);
+	rc = _vdev_vq_worker(vq);
+	if (rc >= VHOST_BLK_VQ_POLL_BURST && bvdev->vq_poll_idle_count > 0) {
+		vhost_blk_vq_start_polling(vq);
+	}
+
+	return rc;
 }
 
 static int
@@ -945,7 +1070,24 @@ vdev_worker(void *arg)
 	uint16_t q_idx;
 	int rc = 0;
 
-	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	for (q_idx = 0; q_idx < vsession->max_queues; q_idx += bvsession->bvdev->num_vq_threads) {
+		rc += _vdev_vq_worker(&vsession->virtqueue[q_idx]);
+	}
+
+	return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static int
+vdev_vq_poller_worker(void *arg)
+{
+	struct vhost_blk_vq_poller *vq_poller = arg;
+	struct spdk_vhost_blk_session *bvsession = vq_poller->bvsession;
+	struct spdk_vhost_session *vsession = &bvsession->vsession;
+	uint16_t q_idx;
+	int rc = 0;
+
+	for (q_idx = vq_poller->index; q_idx < vsession->max_queues;
+	     q_idx += bvsession->bvdev->num_vq_threads) {
 		rc += _vdev_vq_worker(&vsession->virtqueue[q_idx]);
 	}
 
@@ -1016,23 +1158,28 @@ no_bdev_process_packed_vq(struct spdk_vhost_blk_session *bvsession, struct spdk_
 				     task->inflight_head);
 }
 
-static int
-_no_bdev_vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
+static void
+no_bdev_vdev_vq_worker_process(struct spdk_vhost_blk_session *bvsession,
+			       struct spdk_vhost_virtqueue *vq)
 {
-	struct spdk_vhost_session *vsession = vq->vsession;
-	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
-	bool packed_ring;
-
-	packed_ring = vq->packed.packed_ring;
-	if (packed_ring) {
+	if (vq->packed.packed_ring) {
 		no_bdev_process_packed_vq(bvsession, vq);
 	} else {
 		no_bdev_process_vq(bvsession, vq);
 	}
 
 	vhost_session_vq_used_signal(vq);
+}
+
+static int
+_no_bdev_vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
+{
+	struct spdk_vhost_session *vsession = vq->vsession;
+	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+
+	no_bdev_vdev_vq_worker_process(bvsession, vq);
 
-	if (vsession->task_cnt == 0 && bvsession->io_channel) {
+	if (blk_session_get_task_cnt(bvsession) == 0 && bvsession->io_channel) {
 		vhost_blk_put_io_channel(bvsession->io_channel);
 		bvsession->io_channel = NULL;
 	}
@@ -1055,13 +1202,34 @@ no_bdev_vdev_worker(void *arg)
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	uint16_t q_idx;
 
-	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	for (q_idx = 0; q_idx < vsession->max_queues; q_idx += bvsession->bvdev->num_vq_threads) {
 		_no_bdev_vdev_vq_worker(&vsession->virtqueue[q_idx]);
 	}
 
 	return SPDK_POLLER_BUSY;
 }
 
+static int
+no_bdev_vdev_vq_poller_worker(void *arg)
+{
+	struct vhost_blk_vq_poller *vq_poller = arg;
+	struct spdk_vhost_blk_session *bvsession = vq_poller->bvsession;
+	struct spdk_vhost_session *vsession = &bvsession->vsession;
+	uint16_t q_idx;
+
+	for (q_idx = vq_poller->index; q_idx < vsession->max_queues;
+	     q_idx += bvsession->bvdev->num_vq_threads) {
+		no_bdev_vdev_vq_worker_process(bvsession, &vsession->virtqueue[q_idx]);
+	}
+
+	if (blk_session_get_task_cnt(bvsession) == 0 && vq_poller->io_channel) {
+		vhost_blk_put_io_channel(vq_poller->io_channel);
+		vq_poller->io_channel = NULL;
+	}
+
+	return SPDK_POLLER_BUSY;
+}
+
 static void
 vhost_blk_session_unregister_interrupts(struct spdk_vhost_blk_session *bvsession)
 {
@@ -1076,6 +1244,7 @@ vhost_blk_session_unregister_interrupts(struct spdk_vhost_blk_session *bvsession
 			break;
 		}
 
+		vhost_blk_vq_stop_polling(vq);
 		SPDK_DEBUGLOG(vhost_blk, "unregister vq[%d]'s kickfd is %d\n",
 			      i, vq->vring.kickfd);
 		spdk_interrupt_unregister(&vq->intr);
@@ -1146,6 +1315,72 @@ vhost_blk_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bo
 	vhost_user_session_set_interrupt_mode(&bvsession->vsession, interrupt_mode);
 }
 
+static void
+vhost_blk_vq_poller_start(void *arg)
+{
+	struct vhost_blk_vq_poller *vq_poller = arg;
+	struct spdk_vhost_blk_session *bvsession = vq_poller->bvsession;
+	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
+
+	if (bvdev->bdev) {
+		vq_poller->io_channel = vhost_blk_get_io_channel(&bvdev->vdev);
+		if (!vq_poller->io_channel) {
+			/* Fail the requests instead of leaving the virtqueues unserved */
+			SPDK_ERRLOG("%s: I/O channel allocation failed on thread %s\n",
+				    bvsession->vsession.name,
+				    spdk_thread_get_name(spdk_get_thread()));
+		}
+	}
+
+	if (vq_poller->io_channel) {
+		vq_poller->poller = SPDK_POLLER_REGISTER(vdev_vq_poller_worker, vq_poller, 0);
+	} else {
+		vq_poller->poller = SPDK_POLLER_REGISTER(no_bdev_vdev_vq_poller_worker,
+				    vq_poller, 0);
+	}
+}
+
+static void
+vhost_blk_vq_poller_remove_bdev(void *arg)
+{
+	struct vhost_blk_vq_poller *vq_poller = arg;
+
+	spdk_poller_unregister(&vq_poller->poller);
+	vq_poller->poller = SPDK_POLLER_REGISTER(no_bdev_vdev_vq_poller_worker,
+			    vq_poller, 0);
+}
+
+static int
+vhost_blk_vq_poller_drain(void *arg)
+{
+	struct vhost_blk_vq_poller *vq_poller = arg;
+	struct spdk_vhost_blk_session *bvsession = vq_poller->bvsession;
+
+	if (blk_session_get_task_cnt(bvsession) > 0) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	if (vq_poller->io_channel) {
+		vhost_blk_put_io_channel(vq_poller->io_channel);
+		vq_poller->io_channel = NULL;
+	}
+
+	spdk_poller_unregister(&vq_poller->poller);
+	__atomic_fetch_sub(&bvsession->active_vq_pollers, 1, __ATOMIC_RELEASE);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+vhost_blk_vq_poller_stop(void *arg)
+{
+	struct vhost_blk_vq_poller *vq_poller = arg;
+
+	/* The I/O channel can only be released once all the outstanding requests complete */
+	spdk_poller_unregister(&vq_poller->poller);
+	vq_poller->poller = SPDK_POLLER_REGISTER(vhost_blk_vq_poller_drain, vq_poller, 1000);
+}
+
 static void
 bdev_event_cpl_cb(struct spdk_vhost_dev *vdev, void *ctx)
 {
@@ -1190,9 +1425,12 @@ vhost_user_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
 				  void *ctx)
 {
 	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_vhost_blk_dev *bvdev;
+	uint32_t i;
 	int rc;
 
 	bvsession = to_blk_session(vsession);
+	bvdev = bvsession->bvdev;
 	if (bvsession->requestq_poller) {
 		spdk_poller_unregister(&bvsession->requestq_poller);
 		if (vsession->interrupt_mode) {
@@ -1207,6 +1445,11 @@ vhost_user_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
 		bvsession->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, bvsession, 0);
 		spdk_poller_register_interrupt(bvsession->requestq_poller, vhost_blk_poller_set_interrupt_mode,
 					       bvsession);
+
+		for (i = 0; i < bvdev->num_vq_threads - 1; i++) {
+			spdk_thread_send_msg(bvdev->vq_threads[i], vhost_blk_vq_poller_remove_bdev,
+					     &bvsession->vq_pollers[i]);
+		}
 	}
 
 	return 0;
@@ -1354,9 +1597,21 @@ vhost_blk_start(struct spdk_vhost_dev *vdev,
 	assert(bvdev != NULL);
 	bvsession->bvdev = bvdev;
 
+	if (bvdev->num_vq_threads > 1) {
+		bvsession->vq_pollers = calloc(bvdev->num_vq_threads - 1,
+					       sizeof(*bvsession->vq_pollers));
+		if (!bvsession->vq_pollers) {
+			free_task_pool(bvsession);
+			SPDK_ERRLOG("%s: virtqueue pollers allocation failed\n", vsession->name);
+			return -ENOMEM;
+		}
+	}
+
 	if (bvdev->bdev) {
 		bvsession->io_channel = vhost_blk_get_io_channel(vdev);
 		if (!bvsession->io_channel) {
+			free(bvsession->vq_pollers);
+			bvsession->vq_pollers = NULL;
 			free_task_pool(bvsession);
 			SPDK_ERRLOG("%s: I/O channel allocation failed\n", vsession->name);
 			return -1;
@@ -1374,6 +1629,14 @@ vhost_blk_start(struct spdk_vhost_dev *vdev,
 	spdk_poller_register_interrupt(bvsession->requestq_poller, vhost_blk_poller_set_interrupt_mode,
 				       bvsession);
 
+	bvsession->active_vq_pollers = bvdev->num_vq_threads - 1;
+	for (i = 0; i < (int)bvdev->num_vq_threads - 1; i++) {
+		bvsession->vq_pollers[i].bvsession = bvsession;
+		bvsession->vq_pollers[i].index = i + 1;
+		spdk_thread_send_msg(bvdev->vq_threads[i], vhost_blk_vq_poller_start,
+				     &bvsession->vq_pollers[i]);
+	}
+
 	return 0;
 }
 
@@ -1385,12 +1648,14 @@ destroy_session_poller_cb(void *arg)
 	struct spdk_vhost_user_dev *user_dev = to_user_dev(vsession->vdev);
 	int i;
 
-	if (vsession->task_cnt > 0 || (pthread_mutex_trylock(&user_dev->lock) != 0)) {
+	if (blk_session_get_task_cnt(bvsession) > 0 ||
+	    __atomic_load_n(&bvsession->active_vq_pollers, __ATOMIC_ACQUIRE) > 0 ||
+	    (pthread_mutex_trylock(&user_dev->lock) != 0)) {
 		assert(vsession->stop_retry_count > 0);
 		vsession->stop_retry_count--;
 		if (vsession->stop_retry_count == 0) {
 			SPDK_ERRLOG("%s: Timedout when destroy session (task_cnt %d)\n", vsession->name,
-				    vsession->task_cnt);
+				    blk_session_get_task_cnt(bvsession));
 			spdk_poller_unregister(&bvsession->stop_poller);
 			vhost_user_session_stop_done(vsession, -ETIMEDOUT);
 		}
@@ -1411,6 +1676,8 @@ destroy_session_poller_cb(void *arg)
 		bvsession->io_channel = NULL;
 	}
 
+	free(bvsession->vq_pollers);
+	bvsession->vq_pollers = NULL;
 	free_task_pool(bvsession);
 	spdk_poller_unregister(&bvsession->stop_poller);
 	vhost_user_session_stop_done(vsession, 0);
@@ -1424,6 +1691,8 @@ vhost_blk_stop(struct spdk_vhost_dev *vdev,
 	       struct spdk_vhost_session *vsession, void *unused)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
+	uint32_t i;
 
 	/* return if stop is already in progress */
 	if (bvsession->stop_poller) {
@@ -1433,6 +1702,13 @@ vhost_blk_stop(struct spdk_vhost_dev *vdev,
 	spdk_poller_unregister(&bvsession->requestq_poller);
 	vhost_blk_session_unregister_interrupts(bvsession);
 
+	if (bvsession->vq_pollers) {
+		for (i = 0; i < bvdev->num_vq_threads - 1; i++) {
+			spdk_thread_send_msg(bvdev->vq_threads[i], vhost_blk_vq_poller_stop,
+					     &bvsession->vq_pollers[i]);
+		}
+	}
+
 	/* vhost_user_session_send_event timeout is 3 seconds, here set retry within 4 seconds */
 	bvsession->vsession.stop_retry_count = 4000;
 	bvsession->stop_poller = SPDK_POLLER_REGISTER(destroy_session_poller_cb,
@@ -1451,6 +1727,8 @@ vhost_blk_dump_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 	spdk_json_write_named_object_begin(w, "block");
 
 	spdk_json_write_named_bool(w, "readonly", bvdev->readonly);
+	spdk_json_write_named_uint32(w, "num_vq_threads", bvdev->num_vq_threads);
+	spdk_json_write_named_uint32(w, "vq_poll_idle_count", bvdev->vq_poll_idle_count);
 
 	spdk_json_write_name(w, "bdev");
 	if (bvdev->bdev) {
@@ -1484,6 +1762,12 @@ vhost_blk_write_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_
 	spdk_json_write_named_string(w, "cpumask",
 				     spdk_cpuset_fmt(spdk_thread_get_cpumask(vdev->thread)));
 	spdk_json_write_named_bool(w, "readonly", bvdev->readonly);
+	if (bvdev->num_vq_threads > 1) {
+		spdk_json_write_named_uint32(w, "num_vq_threads", bvdev->num_vq_threads);
+	}
+	if (bvdev->vq_poll_idle_count > 0) {
+		spdk_json_write_named_uint32(w, "vq_poll_idle_count", bvdev->vq_poll_idle_count);
+	}
 	spdk_json_write_named_string(w, "transport", bvdev->ops->name);
 	spdk_json_write_object_end(w);
 
@@ -1659,6 +1943,7 @@ spdk_vhost_blk_construct(const char *name, const char *cpumask, const char *dev_
 
 	bvdev->bdev = bdev;
 	bvdev->readonly = false;
+	bvdev->num_vq_threads = 1;
 	ret = vhost_dev_register(vdev, name, cpumask, params, &vhost_blk_device_backend,
 				 &vhost_blk_user_device_backend);
 	if (ret != 0) {
@@ -1755,22 +2040,90 @@ vhost_user_blk_destroy(struct spdk_virtio_blk_transport *transport,
 struct rpc_vhost_blk {
 	bool readonly;
 	bool packed_ring;
+	uint32_t num_vq_threads;
+	uint32_t vq_poll_idle_count;
 };
 
 static const struct spdk_json_object_decoder rpc_construct_vhost_blk[] = {
 	{"readonly", offsetof(struct rpc_vhost_blk, readonly), spdk_json_decode_bool, true},
 	{"packed_ring", offsetof(struct rpc_vhost_blk, packed_ring), spdk_json_decode_bool, true},
+	{"num_vq_threads", offsetof(struct rpc_vhost_blk, num_vq_threads), spdk_json_decode_uint32,
+	 true},
+	{"vq_poll_idle_count", offsetof(struct rpc_vhost_blk, vq_poll_idle_count),
+	 spdk_json_decode_uint32, true},
 };
 
+static void
+vhost_blk_vq_thread_exit(void *arg)
+{
+	spdk_thread_exit(spdk_get_thread());
+}
+
+static void
+vhost_user_blk_free_vq_threads(struct spdk_vhost_blk_dev *bvdev)
+{
+	uint32_t i;
+
+	for (i = 0; i < bvdev->num_vq_threads - 1; i++) {
+		if (bvdev->vq_threads[i] != NULL) {
+			spdk_thread_send_msg(bvdev->vq_threads[i], vhost_blk_vq_thread_exit, NULL);
+		}
+	}
+
+	free(bvdev->vq_threads);
+	bvdev->vq_threads = NULL;
+	bvdev->num_vq_threads = 1;
+}
+
+static int
+vhost_user_blk_alloc_vq_threads(struct spdk_vhost_blk_dev *bvdev, struct spdk_cpuset *cpumask,
+				uint32_t num_vq_threads)
+{
+	char *name;
+	uint32_t i;
+
+	bvdev->num_vq_threads = num_vq_threads;
+	if (num_vq_threads == 1) {
+		return 0;
+	}
+
+	bvdev->vq_threads = calloc(num_vq_threads - 1, sizeof(*bvdev->vq_threads));
+	if (bvdev->vq_threads == NULL) {
+		bvdev->num_vq_threads = 1;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_vq_threads - 1; i++) {
+		name = spdk_sprintf_alloc("%s_vq%"PRIu32, bvdev->vdev.name, i + 1);
+		if (name == NULL) {
+			vhost_user_blk_free_vq_threads(bvdev);
+			return -ENOMEM;
+		}
+
+		bvdev->vq_threads[i] = spdk_thread_create(name, cpumask);
+		if (bvdev->vq_threads[i] == NULL) {
+			SPDK_ERRLOG("Failed to create thread %s\n", name);
+			free(name);
+			vhost_user_blk_free_vq_threads(bvdev);
+			return -EIO;
+		}
+		free(name);
+	}
+
+	return 0;
+}
+
 static int
 vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpumask,
 			    const char *address, const struct spdk_json_val *params, void *custom_opts)
 {
 	struct rpc_vhost_blk req = {0};
 	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+	int rc;
 
 	assert(bvdev != NULL);
 
+	req.num_vq_threads = 1;
 	if (spdk_json_decode_object_relaxed(params, rpc_construct_vhost_blk,
 					    SPDK_COUNTOF(rpc_construct_vhost_blk),
 					    &req)) {
@@ -1778,6 +2131,17 @@ vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpu
 		return -EINVAL;
 	}
 
+	if (req.num_vq_threads == 0 || req.num_vq_threads > SPDK_VHOST_MAX_VQUEUES) {
+		SPDK_ERRLOG("%s: num_vq_threads must be within 1 and %d\n", vdev->name,
+			    SPDK_VHOST_MAX_VQUEUES);
+		return -EINVAL;
+	}
+
+	if (req.num_vq_threads > 1 && spdk_interrupt_mode_is_enabled()) {
+		SPDK_ERRLOG("%s: num_vq_threads isn't supported in interrupt mode\n", vdev->name);
+		return -ENOTSUP;
+	}
+
 	if (req.packed_ring) {
 		vdev->virtio_features |= (uint64_t)req.packed_ring << VIRTIO_F_RING_PACKED;
 	}
@@ -1786,13 +2150,35 @@ vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpu
 		bvdev->readonly = req.readonly;
 	}
 
-	return vhost_user_dev_register(vdev, address, cpumask, custom_opts);
+	bvdev->vq_poll_idle_count = req.vq_poll_idle_count;
+
+	rc = vhost_user_blk_alloc_vq_threads(bvdev, cpumask, req.num_vq_threads);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = vhost_user_dev_register(vdev, address, cpumask, custom_opts);
+	if (rc != 0) {
+		vhost_user_blk_free_vq_threads(bvdev);
+	}
+
+	return rc;
 }
 
 static int
 vhost_user_blk_destroy_ctrlr(struct spdk_vhost_dev *vdev)
 {
-	return vhost_user_dev_unregister(vdev);
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+	int rc;
+
+	assert(bvdev != NULL);
+
+	rc = vhost_user_dev_unregister(vdev);
+	if (rc == 0) {
+		vhost_user_blk_free_vq_threads(bvdev);
+	}
+
+	return rc;
 }
 
 static void
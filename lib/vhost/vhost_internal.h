@@ -94,12 +94,38 @@ struct spdk_vhost_virtqueue {
 	/* Next time when we need to send event */
 	uint64_t next_event_time;
 
+	/* Next time when stats for event coalescing will be checked. */
+	uint64_t next_stats_check_time;
+
 	/* Associated vhost_virtqueue in the virtio device's virtqueue list */
 	uint32_t vring_idx;
 
 	struct spdk_vhost_session *vsession;
 
 	struct spdk_interrupt *intr;
+
+	/* Polls the virtqueue while it's busy in interrupt mode, with guest notifications off */
+	struct spdk_poller *poller;
+
+	/* Number of consecutive polls of the above poller that found no requests */
+	uint32_t idle_polls;
+
+	/* VIRTIO_RING_F_EVENT_IDX was negotiated for this (split) virtqueue */
+	bool event_idx;
+
+	/* Used ring entries are published to the guest (used->idx) once per poll instead of
+	 * once per request.  Not possible if inflight I/O is tracked, as it allows only a single
+	 * used ring update to be in progress.
+	 */
+	bool batch_used;
+
+	/* Used index at the time of the last interrupt, for VIRTIO_RING_F_EVENT_IDX */
+	bool signalled_used_valid;
+	uint16_t signalled_used;
+
+	/* Number of completed requests and interrupts sent to the guest since the vq was enabled */
+	uint64_t stats_completions;
+	uint64_t stats_interrupts;
 } __attribute((aligned(SPDK_CACHE_LINE_SIZE)));
 
 struct spdk_vhost_session {
@@ -129,9 +155,6 @@ struct spdk_vhost_session {
 	uint32_t coalescing_delay_time_base;
 	uint32_t coalescing_io_rate_threshold;
 
-	/* Next time when stats for event coalescing will be checked. */
-	uint64_t next_stats_check_time;
-
 	/* Interval used for event coalescing checking. */
 	uint64_t stats_check_interval;
 
@@ -319,6 +342,13 @@ void vhost_vq_used_ring_enqueue(struct spdk_vhost_session *vsession,
 				struct spdk_vhost_virtqueue *vq,
 				uint16_t id, uint32_t len);
 
+/**
+ * Enable or disable the notifications (kicks) sent by the guest when it submits requests.
+ * \param vq virtqueue
+ * \param enable true to enable the notifications, false to ask the guest to suppress them
+ */
+void vhost_vq_set_guest_notification(struct spdk_vhost_virtqueue *vq, bool enable);
+
 /**
  * Enqueue the entry to the used ring when device complete the request.
  * \param vsession vhost session
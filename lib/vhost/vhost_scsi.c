@@ -27,8 +27,10 @@
 /* Features that are specified in VIRTIO SCSI but currently not supported:
  * - Live migration not supported yet
  * - T10 PI
+ * VIRTIO_RING_F_EVENT_IDX, disabled by default, is supported for vhost-scsi.
  */
-#define SPDK_VHOST_SCSI_DISABLED_FEATURES	(SPDK_VHOST_DISABLED_FEATURES | \
+#define SPDK_VHOST_SCSI_DISABLED_FEATURES	((SPDK_VHOST_DISABLED_FEATURES & \
+						 ~(1ULL << VIRTIO_RING_F_EVENT_IDX)) | \
 						(1ULL << VIRTIO_SCSI_F_T10_PI ))
 
 /* Vhost-user-scsi support protocol features */
@@ -115,10 +115,12 @@ virtio_init_queue(struct virtio_dev *dev, uint16_t vtpci_queue_idx)
 		      size, vq->vq_ring_size);
 
 	vq->owner_thread = NULL;
+	pthread_spin_init(&vq->lock, PTHREAD_PROCESS_PRIVATE);
 
 	rc = virtio_dev_backend_ops(dev)->setup_queue(dev, vq);
 	if (rc < 0) {
 		SPDK_ERRLOG("setup_queue failed\n");
+		pthread_spin_destroy(&vq->lock);
 		free(vq);
 		dev->vqs[vtpci_queue_idx] = NULL;
 		return rc;
@@ -152,6 +154,7 @@ virtio_free_queues(struct virtio_dev *dev)
 
 		virtio_dev_backend_ops(dev)->del_queue(dev, vq);
 
+		pthread_spin_destroy(&vq->lock);
 		free(vq);
 		dev->vqs[i] = NULL;
 	}
@@ -576,6 +579,34 @@ virtio_dev_find_and_acquire_queue(struct virtio_dev *vdev, uint16_t start_index)
 	return i;
 }
 
+int32_t
+virtio_dev_find_and_share_queue(struct virtio_dev *vdev, uint16_t start_index)
+{
+	struct virtqueue *vq, *shared_vq = NULL;
+	uint16_t i;
+
+	pthread_mutex_lock(&vdev->mutex);
+	for (i = start_index; i < vdev->max_queues; ++i) {
+		vq = vdev->vqs[i];
+		if (vq == NULL || vq->owner_thread == NULL) {
+			continue;
+		}
+		if (shared_vq == NULL || vq->shared_cnt < shared_vq->shared_cnt) {
+			shared_vq = vq;
+		}
+	}
+
+	if (shared_vq == NULL) {
+		SPDK_ERRLOG("no acquired virtio queues with idx >= %"PRIu16".\n", start_index);
+		pthread_mutex_unlock(&vdev->mutex);
+		return -1;
+	}
+
+	shared_vq->shared_cnt++;
+	pthread_mutex_unlock(&vdev->mutex);
+	return shared_vq->vq_queue_index;
+}
+
 struct spdk_thread *
 virtio_dev_queue_get_thread(struct virtio_dev *vdev, uint16_t index)
 {
@@ -619,8 +650,13 @@ virtio_dev_release_queue(struct virtio_dev *vdev, uint16_t index)
 		return;
 	}
 
-	assert(vq->owner_thread == spdk_get_thread());
-	vq->owner_thread = NULL;
+	if (vq->shared_cnt > 0) {
+		/* The queue stays acquired until all of its users release it */
+		vq->shared_cnt--;
+	} else {
+		assert(vq->owner_thread != NULL);
+		vq->owner_thread = NULL;
+	}
 	pthread_mutex_unlock(&vdev->mutex);
 }
 
@@ -562,6 +562,8 @@ vmd_init_hotplug(struct vmd_pci_device *dev, struct vmd_pci_bus *bus)
 		TAILQ_INSERT_TAIL(&hp->unused_mem_queue, &hp->mem[mem_id], tailq);
 	}
 
+	TAILQ_INSERT_TAIL(&vmd->hp_bus_list, bus, hp_tailq);
+
 	SPDK_INFOLOG(vmd, "%s: mem_base:mem_limit = %x : %x\n", __func__,
 		     bus->self->header->one.mem_base, bus->self->header->one.mem_limit);
 }
@@ -1239,6 +1241,10 @@ vmd_find_device(const struct spdk_pci_addr *addr)
 	uint32_t i;
 
 	for (i = 0; i < g_vmd_container.count; ++i) {
+		if (g_vmd_container.vmd[i].domain != addr->domain) {
+			continue;
+		}
+
 		TAILQ_FOREACH(bus, &g_vmd_container.vmd[i].bus_list, tailq) {
 			if (bus->self) {
 				if (spdk_pci_addr_compare(&bus->self->pci.addr, addr) == 0) {
@@ -1279,6 +1285,7 @@ vmd_enum_cb(void *ctx, struct spdk_pci_device *pci_dev)
 	vmd_c->vmd[i].domain =
 		(pci_dev->addr.bus << 16) | (pci_dev->addr.dev << 8) | pci_dev->addr.func;
 	TAILQ_INIT(&vmd_c->vmd[i].bus_list);
+	TAILQ_INIT(&vmd_c->vmd[i].hp_bus_list);
 
 	if (vmd_map_bars(&vmd_c->vmd[i], pci_dev) == -1) {
 		return -1;
@@ -1393,17 +1400,22 @@ spdk_vmd_hotplug_monitor(void)
 {
 	struct vmd_pci_bus *bus;
 	struct vmd_pci_device *device;
+	union express_slot_status_register slot_status;
 	int num_hotplugs = 0;
 	uint32_t i;
 
 	for (i = 0; i < g_vmd_container.count; ++i) {
-		TAILQ_FOREACH(bus, &g_vmd_container.vmd[i].bus_list, tailq) {
+		/* Only the slots found hotplug-capable during enumeration can report a change, so
+		 * there's no need to walk the whole hierarchy.  The data link layer state changed
+		 * bit is latched by the port, so a single config space read per slot is enough to
+		 * tell whether anything happened since the last call.
+		 */
+		TAILQ_FOREACH(bus, &g_vmd_container.vmd[i].hp_bus_list, hp_tailq) {
 			device = bus->self;
-			if (device == NULL || !device->hotplug_capable) {
-				continue;
-			}
+			assert(device != NULL && device->hotplug_capable);
 
-			if (device->pcie_cap->slot_status.bit_field.datalink_state_changed != 1) {
+			slot_status.as_uint16_t = device->pcie_cap->slot_status.as_uint16_t;
+			if (spdk_likely(slot_status.bit_field.datalink_state_changed != 1)) {
 				continue;
 			}
 
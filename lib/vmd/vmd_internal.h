@@ -43,6 +43,7 @@ struct vmd_pci_bus {
 
 	TAILQ_HEAD(, vmd_pci_device) dev_list;	/* list of pci end device attached to this bus */
 	TAILQ_ENTRY(vmd_pci_bus) tailq;		/* link for all buses found during scan */
+	TAILQ_ENTRY(vmd_pci_bus) hp_tailq;	/* link for hotplug-capable buses */
 };
 
 /*
@@ -142,6 +143,8 @@ struct vmd_adapter {
 	struct vmd_pci_bus vmd_bus;
 
 	TAILQ_HEAD(, vmd_pci_bus) bus_list;
+	/* subset of bus_list behind hotplug-capable slots, checked by the hotplug monitor */
+	TAILQ_HEAD(, vmd_pci_bus) hp_bus_list;
 
 	struct event_fifo *hp_queue;
 };
@@ -23,6 +23,7 @@ DEPDIRS-ioat := log
 DEPDIRS-idxd := log util
 DEPDIRS-sock := log $(JSON_LIBS)
 DEPDIRS-util := log
+DEPDIRS-metrics := log util
 DEPDIRS-vmd := log util
 DEPDIRS-dma := log
 DEPDIRS-trace_parser := log
@@ -78,7 +79,7 @@ DEPDIRS-mlx5 = log rdma util
 endif
 DEPDIRS-scsi := log util thread $(JSON_LIBS) trace bdev
 
-DEPDIRS-iscsi := log sock util conf thread $(JSON_LIBS) trace scsi
+DEPDIRS-iscsi := accel log sock util conf thread $(JSON_LIBS) trace scsi
 DEPDIRS-vhost = log util thread $(JSON_LIBS) bdev scsi
 
 # ------------------------------------------------------------------------
@@ -101,9 +102,10 @@ endif
 
 # module/accel
 DEPDIRS-accel_ioat := log ioat thread jsonrpc rpc accel
-DEPDIRS-accel_dsa := log idxd thread $(JSON_LIBS) accel trace
+DEPDIRS-accel_dsa := log idxd thread $(JSON_LIBS) accel trace util
 DEPDIRS-accel_iaa := log idxd thread $(JSON_LIBS) accel trace
 DEPDIRS-accel_dpdk_cryptodev := log thread $(JSON_LIBS) accel util
+DEPDIRS-accel_ipsec_mb := log thread $(JSON_LIBS) accel util
 DEPDIRS-accel_dpdk_compressdev := log thread $(JSON_LIBS) accel util
 
 ifeq ($(CONFIG_RDMA_PROV),mlx5_dv)
@@ -145,6 +147,8 @@ DEPDIRS-bdev_null := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_nvme = $(BDEV_DEPS_THREAD) accel nvme trace
 DEPDIRS-bdev_ocf := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_passthru := $(BDEV_DEPS_THREAD)
+DEPDIRS-bdev_cache := $(BDEV_DEPS_THREAD)
+DEPDIRS-bdev_shm := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_raid := $(BDEV_DEPS_THREAD) accel
 DEPDIRS-bdev_rbd := $(BDEV_DEPS_THREAD)
 DEPDIRS-bdev_uring := $(BDEV_DEPS_THREAD)
@@ -178,6 +182,7 @@ DEPDIRS-event_vhost_scsi := init vhost event_scheduler event_scsi
 DEPDIRS-event_sock := init sock
 DEPDIRS-event_vfu_tgt := init vfu_tgt
 DEPDIRS-event_iobuf := init log thread util $(JSON_LIBS)
+DEPDIRS-event_metrics := init log metrics util $(JSON_LIBS)
 
 # module/vfu_device
 
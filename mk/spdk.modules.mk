@@ -6,11 +6,12 @@
 
 BLOCKDEV_MODULES_LIST = bdev_malloc bdev_null bdev_nvme bdev_passthru bdev_lvol
 BLOCKDEV_MODULES_LIST += bdev_raid bdev_error bdev_gpt bdev_split bdev_delay
-BLOCKDEV_MODULES_LIST += bdev_zone_block
+BLOCKDEV_MODULES_LIST += bdev_zone_block bdev_cache bdev_shm
 BLOCKDEV_MODULES_LIST += blobfs blobfs_bdev blob_bdev blob lvol vmd nvme
 
 # Some bdev modules don't have pollers, so they can directly run in interrupt mode
 INTR_BLOCKDEV_MODULES_LIST = bdev_malloc bdev_passthru bdev_error bdev_gpt bdev_split bdev_raid
+INTR_BLOCKDEV_MODULES_LIST += bdev_cache
 # Logical volume, blobstore and blobfs can directly run in both interrupt mode and poll mode.
 INTR_BLOCKDEV_MODULES_LIST += bdev_lvol blobfs blobfs_bdev blob_bdev blob lvol
 
@@ -103,6 +104,9 @@ endif
 ifeq ($(CONFIG_CRYPTO),y)
 ACCEL_MODULES_LIST += accel_dpdk_cryptodev
 endif
+ifeq ($(CONFIG_IPSEC_MB),y)
+ACCEL_MODULES_LIST += accel_ipsec_mb
+endif
 ifeq ($(CONFIG_DPDK_COMPRESSDEV),y)
 ACCEL_MODULES_LIST += accel_dpdk_compressdev
 endif
@@ -120,7 +124,7 @@ ifeq ($(CONFIG_VFIO_USER),y)
 VFU_DEVICE_MODULES_LIST = vfu_device
 endif
 
-EVENT_BDEV_SUBSYSTEM = event_bdev event_accel event_vmd event_sock event_iobuf
+EVENT_BDEV_SUBSYSTEM = event_bdev event_accel event_vmd event_sock event_iobuf event_metrics
 
 ALL_MODULES_LIST = $(BLOCKDEV_MODULES_LIST) $(ACCEL_MODULES_LIST) $(SCHEDULER_MODULES_LIST) $(SOCK_MODULES_LIST)
 ALL_MODULES_LIST += $(VFU_DEVICE_MODULES_LIST)
@@ -38,6 +38,7 @@ static bool g_compressdev_initialized = false;
 
 #define NUM_MAX_XFORMS		2
 #define NUM_MAX_INFLIGHT_OPS	128
+#define NUM_MAX_ENQ_BURST	32
 #define DEFAULT_WINDOW_SIZE	15
 #define MBUF_SPLIT		(1UL << DEFAULT_WINDOW_SIZE)
 #define QAT_PMD			"compress_qat"
@@ -75,6 +76,11 @@ struct compress_io_channel {
 	struct rte_mbuf			**src_mbufs;
 	struct rte_mbuf			**dst_mbufs;
 	TAILQ_HEAD(, spdk_accel_task)	queued_tasks;
+	/* Ops waiting to be enqueued to the queue pair in the next burst */
+	struct rte_comp_op		*enq_ops[NUM_MAX_ENQ_BURST];
+	uint16_t			num_enq_ops;
+	/* Ops enqueued to the queue pair and not dequeued yet */
+	uint32_t			num_inflight;
 };
 
 /* Shared mempools between all devices on this system */
@@ -419,6 +425,54 @@ _setup_compress_mbuf(struct rte_mbuf **mbufs, int *mbuf_total, uint64_t *total_l
 	return 0;
 }
 
+/* Enqueue the ops collected on the channel to its queue pair in a single burst */
+static int
+compress_enqueue_ops(struct compress_io_channel *chan)
+{
+	struct rte_comp_op *comp_op;
+	struct spdk_accel_task *task = NULL;
+	uint16_t num_enq, num_left;
+
+	if (chan->num_enq_ops == 0) {
+		return 0;
+	}
+
+	num_enq = rte_compressdev_enqueue_burst(chan->device_qp->device->cdev_id,
+						chan->device_qp->qp, chan->enq_ops,
+						chan->num_enq_ops);
+	assert(num_enq <= chan->num_enq_ops);
+	chan->num_inflight += num_enq;
+	num_left = chan->num_enq_ops - num_enq;
+
+	if (num_left > 0) {
+		comp_op = chan->enq_ops[num_enq];
+		if (comp_op->status != RTE_COMP_OP_STATUS_NOT_PROCESSED) {
+			/* There was an error sending the op to the device, most
+			 * likely with the parameters.
+			 */
+			SPDK_ERRLOG("Compression API returned 0x%x\n", comp_op->status);
+			task = (struct spdk_accel_task *)*RTE_MBUF_DYNFIELD(comp_op->m_src,
+					g_mbuf_offset, uint64_t *);
+			rte_pktmbuf_free(comp_op->m_src);
+			rte_pktmbuf_free(comp_op->m_dst);
+			rte_comp_op_free(comp_op);
+			num_enq++;
+			num_left--;
+		}
+
+		/* The queue pair is full, the rest is retried in the next burst */
+		memmove(chan->enq_ops, &chan->enq_ops[num_enq], num_left * sizeof(chan->enq_ops[0]));
+	}
+	chan->num_enq_ops = num_left;
+
+	/* Completing the task may submit new ones, so only do it once the burst is done with */
+	if (spdk_unlikely(task != NULL)) {
+		spdk_accel_task_complete(task, -EINVAL);
+	}
+
+	return num_enq;
+}
+
 static int
 _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *task)
 {
@@ -427,16 +481,19 @@ _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *t
 	int src_iovcnt = task->s.iovcnt;
 	struct iovec *src_iovs = task->s.iovs;
 	struct rte_comp_op *comp_op;
-	uint8_t cdev_id;
 	uint64_t total_length = 0;
 	int rc = 0, i;
 	int src_mbuf_total = 0;
 	int dst_mbuf_total = 0;
-	bool device_error = false;
 	bool compress = (task->op_code == SPDK_ACCEL_OPC_COMPRESS);
 
 	assert(chan->device_qp->device != NULL);
-	cdev_id = chan->device_qp->device->cdev_id;
+
+	if (spdk_unlikely(chan->num_enq_ops == NUM_MAX_ENQ_BURST)) {
+		/* The queue pair didn't take the last burst, wait until it has room again */
+		rc = -EAGAIN;
+		goto error_get_op;
+	}
 
 	/* calc our mbuf totals based on max MBUF size allowed so we can pre-alloc mbufs in bulk */
 	for (i = 0 ; i < src_iovcnt; i++) {
@@ -511,18 +568,16 @@ _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *t
 	comp_op->op_type = RTE_COMP_OP_STATELESS;
 	comp_op->flush_flag = RTE_COMP_FLUSH_FINAL;
 
-	rc = rte_compressdev_enqueue_burst(cdev_id, chan->device_qp->qp, &comp_op, 1);
-	assert(rc <= 1);
-
-	/* We always expect 1 got queued, if 0 then we need to queue it up. */
-	if (rc == 1) {
-		return 0;
-	} else if (comp_op->status == RTE_COMP_OP_STATUS_NOT_PROCESSED) {
-		rc = -EAGAIN;
-	} else {
-		device_error = true;
+	/* Ops are enqueued in bursts, either by the poller or once a full burst is collected, so
+	 * that the doorbell of the queue pair is only rung once for all of them.
+	 */
+	chan->enq_ops[chan->num_enq_ops++] = comp_op;
+	if (chan->num_enq_ops == NUM_MAX_ENQ_BURST) {
+		compress_enqueue_ops(chan);
 	}
 
+	return 0;
+
 	/* Error cleanup paths. */
 error_src_dst:
 	rte_pktmbuf_free_bulk(chan->dst_mbufs, dst_iovcnt);
@@ -532,13 +587,6 @@ error_get_src:
 	rte_comp_op_free(comp_op);
 error_get_op:
 
-	if (device_error == true) {
-		/* There was an error sending the op to the device, most
-		 * likely with the parameters.
-		 */
-		SPDK_ERRLOG("Compression API returned 0x%x\n", comp_op->status);
-		return -EINVAL;
-	}
 	if (rc != -ENOMEM && rc != -EAGAIN) {
 		return rc;
 	}
@@ -554,15 +602,23 @@ comp_dev_poller(void *args)
 	struct compress_io_channel *chan = args;
 	uint8_t cdev_id;
 	struct rte_comp_op *deq_ops[NUM_MAX_INFLIGHT_OPS];
-	uint16_t num_deq;
+	uint16_t num_deq = 0;
 	struct spdk_accel_task *task, *task_to_resubmit;
-	int rc, i, status;
+	int rc, i, status, num_enq;
 
 	assert(chan->device_qp->device != NULL);
 	cdev_id = chan->device_qp->device->cdev_id;
 
-	num_deq = rte_compressdev_dequeue_burst(cdev_id, chan->device_qp->qp, deq_ops,
-						NUM_MAX_INFLIGHT_OPS);
+	/* Only ask for as many ops as are outstanding, and don't touch the device at all when
+	 * nothing is.
+	 */
+	if (chan->num_inflight > 0) {
+		num_deq = spdk_min(chan->num_inflight, NUM_MAX_INFLIGHT_OPS);
+		num_deq = rte_compressdev_dequeue_burst(cdev_id, chan->device_qp->qp, deq_ops,
+							num_deq);
+		assert(num_deq <= chan->num_inflight);
+		chan->num_inflight -= num_deq;
+	}
 	for (i = 0; i < num_deq; i++) {
 
 		/* We store this off regardless of success/error so we know how to contruct the
@@ -600,14 +656,18 @@ comp_dev_poller(void *args)
 		 */
 		if (!TAILQ_EMPTY(&chan->queued_tasks)) {
 			task_to_resubmit = TAILQ_FIRST(&chan->queued_tasks);
+			TAILQ_REMOVE(&chan->queued_tasks, task_to_resubmit, link);
 			rc = _compress_operation(chan, task_to_resubmit);
-			if (rc == 0) {
-				TAILQ_REMOVE(&chan->queued_tasks, task_to_resubmit, link);
+			if (rc != 0) {
+				spdk_accel_task_complete(task_to_resubmit, rc);
 			}
 		}
 	}
 
-	return num_deq == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
+	/* Send everything submitted since the last poll in one burst */
+	num_enq = compress_enqueue_ops(chan);
+
+	return num_deq == 0 && num_enq == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
 }
 
 static int
@@ -796,6 +856,8 @@ compress_destroy_cb(void *io_device, void *ctx_buf)
 	struct compress_io_channel *chan = ctx_buf;
 	struct comp_device_qp *device_qp = chan->device_qp;
 
+	assert(chan->num_enq_ops == 0);
+
 	spdk_free(chan->src_mbufs);
 	spdk_free(chan->dst_mbufs);
 
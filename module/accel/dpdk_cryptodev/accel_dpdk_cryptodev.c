@@ -1350,6 +1350,32 @@ accel_dpdk_cryptodev_key_handle_configure(struct spdk_accel_crypto_key *key,
 		return -EINVAL;
 	}
 
+	return 0;
+}
+
+static void
+accel_dpdk_cryptodev_key_unbind(struct spdk_accel_crypto_key *key)
+{
+	struct accel_dpdk_cryptodev_key_priv *priv = key->priv;
+	struct accel_dpdk_cryptodev_key_handle *key_handle;
+
+	TAILQ_FOREACH(key_handle, &priv->dev_keys, link) {
+		if (key_handle->session_encrypt) {
+			accel_dpdk_cryptodev_key_handle_session_free(key_handle->device,
+					key_handle->session_encrypt);
+			key_handle->session_encrypt = NULL;
+		}
+		if (key_handle->session_decrypt) {
+			accel_dpdk_cryptodev_key_handle_session_free(key_handle->device,
+					key_handle->session_decrypt);
+			key_handle->session_decrypt = NULL;
+		}
+	}
+}
+
+static int
+accel_dpdk_cryptodev_key_handle_bind(struct accel_dpdk_cryptodev_key_handle *key_handle)
+{
 	key_handle->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_ENCRYPT;
 	key_handle->session_encrypt = accel_dpdk_cryptodev_key_handle_session_create(key_handle->device,
 				      &key_handle->cipher_xform);
@@ -1364,21 +1390,61 @@ accel_dpdk_cryptodev_key_handle_configure(struct spdk_accel_crypto_key *key,
 	if (!key_handle->session_decrypt) {
 		SPDK_ERRLOG("Failed to init decrypt session:");
 		accel_dpdk_cryptodev_key_handle_session_free(key_handle->device, key_handle->session_encrypt);
+		key_handle->session_encrypt = NULL;
 		return -EINVAL;
 	}
 
 	return 0;
 }
 
+/* Sessions are only created once the key gets used, as their number is limited */
+static int
+accel_dpdk_cryptodev_key_bind(struct spdk_accel_crypto_key *key)
+{
+	struct accel_dpdk_cryptodev_key_priv *priv = key->priv;
+	struct accel_dpdk_cryptodev_key_handle *key_handle;
+	int rc;
+
+	TAILQ_FOREACH(key_handle, &priv->dev_keys, link) {
+		rc = accel_dpdk_cryptodev_key_handle_bind(key_handle);
+		if (rc) {
+			accel_dpdk_cryptodev_key_unbind(key);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static uint32_t
+accel_dpdk_cryptodev_get_max_bound_keys(void)
+{
+	struct accel_dpdk_cryptodev_device *device;
+	uint32_t num_devices = 0;
+
+	/* MLX5_PCI keys need sessions on each device, other drivers on a single one */
+	if (g_dpdk_cryptodev_driver == ACCEL_DPDK_CRYPTODEV_DRIVER_MLX5_PCI) {
+		pthread_mutex_lock(&g_device_lock);
+		TAILQ_FOREACH(device, &g_crypto_devices, link) {
+			if (device->type == ACCEL_DPDK_CRYPTODEV_DRIVER_MLX5_PCI) {
+				num_devices++;
+			}
+		}
+		pthread_mutex_unlock(&g_device_lock);
+	}
+
+	/* Each key uses a session for encryption and another one for decryption */
+	return ACCEL_DPDK_CRYPTODEV_NUM_SESSIONS / (2 * spdk_max(num_devices, 1u));
+}
+
 static void
 accel_dpdk_cryptodev_key_deinit(struct spdk_accel_crypto_key *key)
 {
 	struct accel_dpdk_cryptodev_key_handle *key_handle, *key_handle_tmp;
 	struct accel_dpdk_cryptodev_key_priv *priv = key->priv;
 
+	accel_dpdk_cryptodev_key_unbind(key);
 	TAILQ_FOREACH_SAFE(key_handle, &priv->dev_keys, link, key_handle_tmp) {
-		accel_dpdk_cryptodev_key_handle_session_free(key_handle->device, key_handle->session_encrypt);
-		accel_dpdk_cryptodev_key_handle_session_free(key_handle->device, key_handle->session_decrypt);
 		TAILQ_REMOVE(&priv->dev_keys, key_handle, link);
 		spdk_memset_s(key_handle, sizeof(*key_handle), 0, sizeof(*key_handle));
 		free(key_handle);
@@ -1535,6 +1601,9 @@ static struct spdk_accel_module_if g_accel_dpdk_cryptodev_module = {
 	.submit_tasks		= accel_dpdk_cryptodev_submit_tasks,
 	.crypto_key_init	= accel_dpdk_cryptodev_key_init,
 	.crypto_key_deinit	= accel_dpdk_cryptodev_key_deinit,
+	.crypto_key_bind	= accel_dpdk_cryptodev_key_bind,
+	.crypto_key_unbind	= accel_dpdk_cryptodev_key_unbind,
+	.crypto_get_max_bound_keys = accel_dpdk_cryptodev_get_max_bound_keys,
 	.crypto_supports_cipher	= accel_dpdk_cryptodev_supports_cipher,
 	.get_operation_info	= accel_dpdk_cryptodev_get_operation_info,
 };
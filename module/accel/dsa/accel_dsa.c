@@ -12,6 +12,7 @@
 #include "spdk/log.h"
 #include "spdk_internal/idxd.h"
 
+#include "spdk/dif.h"
 #include "spdk/env.h"
 #include "spdk/event.h"
 #include "spdk/likely.h"
@@ -52,17 +53,17 @@ struct idxd_io_channel {
 	enum channel_state		state;
 	struct spdk_poller		*poller;
 	uint32_t			num_outstanding;
+	uint32_t			core;
 	TAILQ_HEAD(, spdk_accel_task)	queued_tasks;
 };
 
 static struct spdk_io_channel *dsa_get_io_channel(void);
 
 static struct idxd_device *
-idxd_select_device(struct idxd_io_channel *chan)
+idxd_select_device(int socket_id, struct spdk_idxd_io_channel **ichan)
 {
 	uint32_t count = 0;
 	struct idxd_device *dev;
-	uint32_t socket_id = spdk_env_get_socket_id(spdk_env_get_current_core());
 
 	/*
 	 * We allow channels to share underlying devices,
@@ -79,7 +80,8 @@ idxd_select_device(struct idxd_io_channel *chan)
 		dev = g_next_dev;
 		pthread_mutex_unlock(&g_dev_lock);
 
-		if (socket_id != spdk_idxd_get_socket(dev->dsa)) {
+		if (socket_id != SPDK_ENV_SOCKET_ID_ANY &&
+		    socket_id != (int)spdk_idxd_get_socket(dev->dsa)) {
 			continue;
 		}
 
@@ -88,31 +90,77 @@ idxd_select_device(struct idxd_io_channel *chan)
 		 * allow a specific number of channels to share a device
 		 * to limit outstanding IO for flow control purposes.
 		 */
-		chan->chan = spdk_idxd_get_channel(dev->dsa);
-		if (chan->chan != NULL) {
+		*ichan = spdk_idxd_get_channel(dev->dsa);
+		if (*ichan != NULL) {
 			SPDK_DEBUGLOG(accel_dsa, "On socket %d using device on socket %d\n",
 				      socket_id, spdk_idxd_get_socket(dev->dsa));
 			return dev;
 		}
 	} while (count++ < g_num_devices);
 
-	/* We are out of available channels and/or devices for the local socket. We fix the number
-	 * of channels that we allocate per device and only allocate devices on the same socket
-	 * that the current thread is on. If on a 2 socket system it may be possible to avoid
-	 * this situation by spreading threads across the sockets.
-	 */
-	SPDK_ERRLOG("No more DSA devices available on the local socket.\n");
 	return NULL;
 }
 
+/*
+ * The scheduler may move the thread owning a channel to a core on another socket. Once the
+ * channel has drained, move it over to a device local to its new socket.
+ */
+static void
+dsa_check_socket(struct idxd_io_channel *chan)
+{
+	struct spdk_idxd_io_channel *ichan;
+	struct idxd_device *dev;
+	uint32_t core;
+	int socket_id;
+
+	core = spdk_env_get_current_core();
+	if (spdk_likely(core == chan->core)) {
+		return;
+	}
+
+	if (!TAILQ_EMPTY(&chan->queued_tasks) || spdk_idxd_has_outstanding(chan->chan)) {
+		return;
+	}
+
+	chan->core = core;
+	socket_id = spdk_env_get_socket_id(core);
+	if (socket_id == SPDK_ENV_SOCKET_ID_ANY ||
+	    socket_id == (int)spdk_idxd_get_socket(chan->dev->dsa)) {
+		return;
+	}
+
+	dev = idxd_select_device(socket_id, &ichan);
+	if (dev == NULL) {
+		/* Nothing available on the new socket, keep using the current device. */
+		return;
+	}
+
+	SPDK_DEBUGLOG(accel_dsa, "Channel moved to core %u, switching to device on socket %d\n",
+		      core, socket_id);
+	spdk_idxd_put_channel(chan->chan);
+	chan->chan = ichan;
+	chan->dev = dev;
+}
+
 static void
 dsa_done(void *cb_arg, int status)
 {
 	struct idxd_task *idxd_task = cb_arg;
+	struct spdk_accel_task *task = &idxd_task->task;
 	struct idxd_io_channel *chan;
 
 	chan = idxd_task->chan;
 
+	/* The device only tells which check failed, so run the verification again in software to
+	 * report the same error information as the software module */
+	if (spdk_unlikely(status == -EIO && task->op_code == SPDK_ACCEL_OPC_DIF_VERIFY)) {
+		status = spdk_dif_verify(task->s.iovs, task->s.iovcnt, task->dif.num_blocks,
+					 task->dif.ctx, task->dif.err);
+		if (status == 0) {
+			status = -EIO;
+		}
+	}
+
 	assert(chan->num_outstanding > 0);
 	spdk_trace_record(TRACE_ACCEL_DSA_OP_COMPLETE, 0, 0, 0, chan->num_outstanding - 1);
 	chan->num_outstanding--;
@@ -139,6 +187,23 @@ idxd_submit_dualcast(struct idxd_io_channel *ch, struct idxd_task *idxd_task, in
 					 task->d.iovs[0].iov_len, flags, dsa_done, idxd_task);
 }
 
+/* Used for the DIF formats and buffer layouts the device can't handle */
+static int
+dsa_dif_sw_fallback(struct spdk_accel_task *task)
+{
+	switch (task->op_code) {
+	case SPDK_ACCEL_OPC_DIF_VERIFY:
+		return spdk_dif_verify(task->s.iovs, task->s.iovcnt, task->dif.num_blocks,
+				       task->dif.ctx, task->dif.err);
+	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
+		return spdk_dif_generate_copy(task->s.iovs, task->s.iovcnt, task->d.iovs,
+					      task->d.iovcnt, task->dif.num_blocks, task->dif.ctx);
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+}
+
 static int
 _process_single_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
 {
@@ -176,6 +241,17 @@ _process_single_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
 						  task->seed, task->crc_dst, flags,
 						  dsa_done, idxd_task);
 		break;
+	case SPDK_ACCEL_OPC_DIF_VERIFY:
+		rc = spdk_idxd_submit_dif_check(chan->chan, task->s.iovs, task->s.iovcnt,
+						task->dif.num_blocks, task->dif.ctx, flags,
+						dsa_done, idxd_task);
+		break;
+	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
+		rc = spdk_idxd_submit_dif_insert(chan->chan, task->d.iovs, task->d.iovcnt,
+						 task->s.iovs, task->s.iovcnt,
+						 task->dif.num_blocks, task->dif.ctx, flags,
+						 dsa_done, idxd_task);
+		break;
 	default:
 		assert(false);
 		rc = -EINVAL;
@@ -185,6 +261,10 @@ _process_single_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
 	if (rc == 0) {
 		chan->num_outstanding++;
 		spdk_trace_record(TRACE_ACCEL_DSA_OP_SUBMIT, 0, 0, 0, chan->num_outstanding);
+	} else if (rc == -EOPNOTSUPP) {
+		SPDK_DEBUGLOG(accel_dsa, "Executing DIF operation in software\n");
+		spdk_accel_task_complete(task, dsa_dif_sw_fallback(task));
+		rc = 0;
 	}
 
 	return rc;
@@ -253,6 +333,8 @@ idxd_poll(void *arg)
 
 	/* Check if there are any pending ops to process if the channel is active */
 	if (chan->state == IDXD_CHANNEL_ACTIVE) {
+		dsa_check_socket(chan);
+
 		/* Submit queued tasks */
 		if (!TAILQ_EMPTY(&chan->queued_tasks)) {
 			task = TAILQ_FIRST(&chan->queued_tasks);
@@ -262,6 +344,13 @@ idxd_poll(void *arg)
 
 			dsa_submit_tasks(spdk_io_channel_from_ctx(idxd_task->chan), task);
 		}
+
+		/* Tasks submitted to the channel are gathered into a single batch descriptor,
+		 * flush it now rather than waiting for the next poll.
+		 */
+		if (spdk_idxd_flush(chan->chan) > 0) {
+			count++;
+		}
 	}
 
 	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
@@ -288,6 +377,8 @@ dsa_supports_opcode(enum spdk_accel_opcode opc)
 	case SPDK_ACCEL_OPC_COMPARE:
 	case SPDK_ACCEL_OPC_CRC32C:
 	case SPDK_ACCEL_OPC_COPY_CRC32C:
+	case SPDK_ACCEL_OPC_DIF_VERIFY:
+	case SPDK_ACCEL_OPC_DIF_GENERATE_COPY:
 		return true;
 	default:
 		return false;
@@ -314,8 +405,22 @@ dsa_create_cb(void *io_device, void *ctx_buf)
 {
 	struct idxd_io_channel *chan = ctx_buf;
 	struct idxd_device *dsa;
+	int socket_id;
+
+	chan->core = spdk_env_get_current_core();
+	socket_id = spdk_env_get_socket_id(chan->core);
+
+	dsa = idxd_select_device(socket_id, &chan->chan);
+	if (dsa == NULL && socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+		/* We are out of available channels and/or devices for the local socket. Rather than
+		 * failing, fall back to a device on another socket at the cost of cross-socket traffic.
+		 * Spreading threads across the sockets avoids this situation.
+		 */
+		SPDK_NOTICELOG("No more DSA devices available on socket %d, using a remote one.\n",
+			       socket_id);
+		dsa = idxd_select_device(SPDK_ENV_SOCKET_ID_ANY, &chan->chan);
+	}
 
-	dsa = idxd_select_device(chan);
 	if (dsa == NULL) {
 		SPDK_ERRLOG("Failed to get an idxd channel\n");
 		return -EINVAL;
@@ -22,6 +22,12 @@
 #include "spdk_internal/trace_defs.h"
 
 static bool g_iaa_enable = false;
+static enum accel_iaa_huffman_mode g_iaa_huffman_mode = ACCEL_IAA_HUFFMAN_FIXED;
+
+/* Number of Huffman tables each channel can use for two-pass compression at the same time */
+#define IAA_NUM_DYNAMIC_TABLES		32
+/* Number of operations whose statistics are used to train a channel's canned table */
+#define IAA_CANNED_TRAINING_OPS		64
 
 enum channel_state {
 	IDXD_CHANNEL_ACTIVE,
@@ -40,9 +46,15 @@ static struct idxd_device *g_next_dev = NULL;
 static uint32_t g_num_devices = 0;
 static pthread_mutex_t g_dev_lock = PTHREAD_MUTEX_INITIALIZER;
 
+struct iaa_table {
+	struct spdk_idxd_huffman_table	*table;
+	STAILQ_ENTRY(iaa_table)		link;
+};
+
 struct idxd_task {
 	struct spdk_accel_task	task;
 	struct idxd_io_channel	*chan;
+	struct iaa_table	*table;
 };
 
 struct idxd_io_channel {
@@ -51,17 +63,23 @@ struct idxd_io_channel {
 	enum channel_state		state;
 	struct spdk_poller		*poller;
 	uint32_t			num_outstanding;
+	uint32_t			core;
 	TAILQ_HEAD(, spdk_accel_task)	queued_tasks;
+	struct iaa_table		*tables;
+	STAILQ_HEAD(, iaa_table)	free_tables;
+	/* Canned table, built once enough statistics were gathered */
+	struct spdk_idxd_huffman_table	*canned;
+	struct spdk_idxd_huffman_histogram	training;
+	uint32_t			num_trained;
 };
 
 static struct spdk_io_channel *iaa_get_io_channel(void);
 
 static struct idxd_device *
-idxd_select_device(struct idxd_io_channel *chan)
+idxd_select_device(int socket_id, struct spdk_idxd_io_channel **ichan)
 {
 	uint32_t count = 0;
 	struct idxd_device *dev;
-	uint32_t socket_id = spdk_env_get_socket_id(spdk_env_get_current_core());
 
 	/*
 	 * We allow channels to share underlying devices,
@@ -78,7 +96,8 @@ idxd_select_device(struct idxd_io_channel *chan)
 		dev = g_next_dev;
 		pthread_mutex_unlock(&g_dev_lock);
 
-		if (socket_id != spdk_idxd_get_socket(dev->iaa)) {
+		if (socket_id != SPDK_ENV_SOCKET_ID_ANY &&
+		    socket_id != (int)spdk_idxd_get_socket(dev->iaa)) {
 			continue;
 		}
 
@@ -87,23 +106,58 @@ idxd_select_device(struct idxd_io_channel *chan)
 		 * allow a specific number of channels to share a device
 		 * to limit outstanding IO for flow control purposes.
 		 */
-		chan->chan = spdk_idxd_get_channel(dev->iaa);
-		if (chan->chan != NULL) {
+		*ichan = spdk_idxd_get_channel(dev->iaa);
+		if (*ichan != NULL) {
 			SPDK_DEBUGLOG(accel_iaa, "On socket %d using device on socket %d\n",
 				      socket_id, spdk_idxd_get_socket(dev->iaa));
 			return dev;
 		}
 	} while (count++ < g_num_devices);
 
-	/* We are out of available channels and/or devices for the local socket. We fix the number
-	 * of channels that we allocate per device and only allocate devices on the same socket
-	 * that the current thread is on. If on a 2 socket system it may be possible to avoid
-	 * this situation by spreading threads across the sockets.
-	 */
-	SPDK_ERRLOG("No more IAA devices available on the local socket.\n");
 	return NULL;
 }
 
+/*
+ * The scheduler may move the thread owning a channel to a core on another socket. Once the
+ * channel has drained, move it over to a device local to its new socket.
+ */
+static void
+iaa_check_socket(struct idxd_io_channel *chan)
+{
+	struct spdk_idxd_io_channel *ichan;
+	struct idxd_device *dev;
+	uint32_t core;
+	int socket_id;
+
+	core = spdk_env_get_current_core();
+	if (spdk_likely(core == chan->core)) {
+		return;
+	}
+
+	if (!TAILQ_EMPTY(&chan->queued_tasks) || spdk_idxd_has_outstanding(chan->chan)) {
+		return;
+	}
+
+	chan->core = core;
+	socket_id = spdk_env_get_socket_id(core);
+	if (socket_id == SPDK_ENV_SOCKET_ID_ANY ||
+	    socket_id == (int)spdk_idxd_get_socket(chan->dev->iaa)) {
+		return;
+	}
+
+	dev = idxd_select_device(socket_id, &ichan);
+	if (dev == NULL) {
+		/* Nothing available on the new socket, keep using the current device. */
+		return;
+	}
+
+	SPDK_DEBUGLOG(accel_iaa, "Channel moved to core %u, switching to device on socket %d\n",
+		      core, socket_id);
+	spdk_idxd_put_channel(chan->chan);
+	chan->chan = ichan;
+	chan->dev = dev;
+}
+
 static void
 iaa_done(void *cb_arg, int status)
 {
@@ -119,6 +173,137 @@ iaa_done(void *cb_arg, int status)
 	spdk_accel_task_complete(&idxd_task->task, status);
 }
 
+static void
+iaa_put_table(struct idxd_task *idxd_task)
+{
+	struct idxd_io_channel *chan = idxd_task->chan;
+
+	if (idxd_task->table != NULL) {
+		STAILQ_INSERT_HEAD(&chan->free_tables, idxd_task->table, link);
+		idxd_task->table = NULL;
+	}
+}
+
+static void
+iaa_compress_done(void *cb_arg, int status)
+{
+	struct idxd_task *idxd_task = cb_arg;
+
+	iaa_put_table(idxd_task);
+	iaa_done(idxd_task, status);
+}
+
+static void
+iaa_train_canned(struct idxd_io_channel *chan, const struct spdk_idxd_huffman_histogram *hist)
+{
+	struct spdk_idxd_huffman_table *canned;
+	uint32_t i;
+
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_LL_SYMBOLS; i++) {
+		chan->training.ll[i] += hist->ll[i];
+	}
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_D_SYMBOLS; i++) {
+		chan->training.d[i] += hist->d[i];
+	}
+
+	if (++chan->num_trained < IAA_CANNED_TRAINING_OPS) {
+		return;
+	}
+
+	canned = spdk_idxd_huffman_table_alloc();
+	if (canned == NULL) {
+		return;
+	}
+
+	/* The table will be applied to other data, so every symbol needs a code */
+	if (spdk_idxd_huffman_table_build(canned, &chan->training, true)) {
+		SPDK_ERRLOG("Failed to build canned Huffman table, restarting training\n");
+		spdk_idxd_huffman_table_free(canned);
+		chan->num_trained = 0;
+		memset(&chan->training, 0, sizeof(chan->training));
+		return;
+	}
+
+	SPDK_DEBUGLOG(accel_iaa, "Canned Huffman table trained on %u operations\n",
+		      chan->num_trained);
+	chan->canned = canned;
+}
+
+/* Second pass of dynamic Huffman compression: build the table and compress the data with it */
+static void
+iaa_stats_done(void *cb_arg, int status)
+{
+	struct idxd_task *idxd_task = cb_arg;
+	struct idxd_io_channel *chan = idxd_task->chan;
+	struct spdk_accel_task *task = &idxd_task->task;
+	struct spdk_idxd_huffman_histogram hist;
+	struct spdk_idxd_huffman_table *table = idxd_task->table->table;
+	int rc;
+
+	if (spdk_unlikely(status != 0)) {
+		iaa_compress_done(idxd_task, status);
+		return;
+	}
+
+	spdk_idxd_huffman_table_get_histogram(table, &hist);
+	if (g_iaa_huffman_mode == ACCEL_IAA_HUFFMAN_CANNED && chan->canned == NULL) {
+		iaa_train_canned(chan, &hist);
+	}
+
+	if (spdk_idxd_huffman_table_build(table, &hist, false)) {
+		/* The header describing the table doesn't fit, use the fixed table instead */
+		table = NULL;
+	}
+
+	rc = spdk_idxd_submit_compress_table(chan->chan, task->d.iovs[0].iov_base,
+					     task->d.iovs[0].iov_len, task->s.iovs, task->s.iovcnt,
+					     task->output_size, table, 0, iaa_compress_done,
+					     idxd_task);
+	if (spdk_unlikely(rc == -EBUSY)) {
+		/* Start over once there's room on the channel */
+		iaa_put_table(idxd_task);
+		chan->num_outstanding--;
+		TAILQ_INSERT_TAIL(&chan->queued_tasks, task, link);
+	} else if (spdk_unlikely(rc != 0)) {
+		iaa_compress_done(idxd_task, rc);
+	}
+}
+
+static int
+iaa_submit_compress(struct idxd_io_channel *chan, struct idxd_task *idxd_task, int flags)
+{
+	struct spdk_accel_task *task = &idxd_task->task;
+	struct iaa_table *table;
+	int rc;
+
+	if (g_iaa_huffman_mode == ACCEL_IAA_HUFFMAN_FIXED || chan->canned != NULL) {
+		return spdk_idxd_submit_compress_table(chan->chan, task->d.iovs[0].iov_base,
+						       task->d.iovs[0].iov_len, task->s.iovs,
+						       task->s.iovcnt, task->output_size,
+						       chan->canned, flags, iaa_done, idxd_task);
+	}
+
+	/* Gather the statistics of the data first, the compression is submitted once they're
+	 * known.  If all tables are in use, don't wait for one, just use the fixed table.
+	 */
+	table = STAILQ_FIRST(&chan->free_tables);
+	if (table == NULL) {
+		return spdk_idxd_submit_compress(chan->chan, task->d.iovs[0].iov_base,
+						 task->d.iovs[0].iov_len, task->s.iovs,
+						 task->s.iovcnt, task->output_size, flags,
+						 iaa_done, idxd_task);
+	}
+
+	rc = spdk_idxd_submit_compress_stats(chan->chan, task->s.iovs, task->s.iovcnt, table->table,
+					     flags, iaa_stats_done, idxd_task);
+	if (rc == 0) {
+		STAILQ_REMOVE_HEAD(&chan->free_tables, link);
+		idxd_task->table = table;
+	}
+
+	return rc;
+}
+
 static int
 _process_single_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
 {
@@ -129,6 +314,7 @@ _process_single_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
 
 	idxd_task = SPDK_CONTAINEROF(task, struct idxd_task, task);
 	idxd_task->chan = chan;
+	idxd_task->table = NULL;
 
 	/* TODO: iovec supprot */
 	if (task->d.iovcnt > 1 || task->s.iovcnt > 1) {
@@ -138,9 +324,7 @@ _process_single_task(struct spdk_io_channel *ch, struct spdk_accel_task *task)
 
 	switch (task->op_code) {
 	case SPDK_ACCEL_OPC_COMPRESS:
-		rc = spdk_idxd_submit_compress(chan->chan, task->d.iovs[0].iov_base, task->d.iovs[0].iov_len,
-					       task->s.iovs, task->s.iovcnt, task->output_size, flags,
-					       iaa_done, idxd_task);
+		rc = iaa_submit_compress(chan, idxd_task, flags);
 		break;
 	case SPDK_ACCEL_OPC_DECOMPRESS:
 		rc = spdk_idxd_submit_decompress(chan->chan, task->d.iovs, task->d.iovcnt, task->s.iovs,
@@ -223,6 +407,8 @@ idxd_poll(void *arg)
 
 	/* Check if there are any pending ops to process if the channel is active */
 	if (chan->state == IDXD_CHANNEL_ACTIVE) {
+		iaa_check_socket(chan);
+
 		/* Submit queued tasks */
 		if (!TAILQ_EMPTY(&chan->queued_tasks)) {
 			task = TAILQ_FIRST(&chan->queued_tasks);
@@ -274,18 +460,82 @@ static struct spdk_accel_module_if g_iaa_module = {
 	.submit_tasks		= iaa_submit_tasks
 };
 
+static void
+iaa_free_tables(struct idxd_io_channel *chan)
+{
+	uint32_t i;
+
+	if (chan->tables != NULL) {
+		for (i = 0; i < IAA_NUM_DYNAMIC_TABLES; i++) {
+			spdk_idxd_huffman_table_free(chan->tables[i].table);
+		}
+		free(chan->tables);
+		chan->tables = NULL;
+	}
+
+	spdk_idxd_huffman_table_free(chan->canned);
+	chan->canned = NULL;
+	STAILQ_INIT(&chan->free_tables);
+}
+
+static int
+iaa_alloc_tables(struct idxd_io_channel *chan)
+{
+	uint32_t i;
+
+	chan->tables = calloc(IAA_NUM_DYNAMIC_TABLES, sizeof(*chan->tables));
+	if (chan->tables == NULL) {
+		SPDK_ERRLOG("Failed to allocate Huffman tables\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < IAA_NUM_DYNAMIC_TABLES; i++) {
+		chan->tables[i].table = spdk_idxd_huffman_table_alloc();
+		if (chan->tables[i].table == NULL) {
+			SPDK_ERRLOG("Failed to allocate Huffman tables\n");
+			iaa_free_tables(chan);
+			return -ENOMEM;
+		}
+		STAILQ_INSERT_TAIL(&chan->free_tables, &chan->tables[i], link);
+	}
+
+	return 0;
+}
+
 static int
 idxd_create_cb(void *io_device, void *ctx_buf)
 {
 	struct idxd_io_channel *chan = ctx_buf;
 	struct idxd_device *iaa;
+	int socket_id;
+
+	chan->core = spdk_env_get_current_core();
+	socket_id = spdk_env_get_socket_id(chan->core);
+
+	iaa = idxd_select_device(socket_id, &chan->chan);
+	if (iaa == NULL && socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+		/* We are out of available channels and/or devices for the local socket. Rather than
+		 * failing, fall back to a device on another socket at the cost of cross-socket traffic.
+		 * Spreading threads across the sockets avoids this situation.
+		 */
+		SPDK_NOTICELOG("No more IAA devices available on socket %d, using a remote one.\n",
+			       socket_id);
+		iaa = idxd_select_device(SPDK_ENV_SOCKET_ID_ANY, &chan->chan);
+	}
 
-	iaa = idxd_select_device(chan);
 	if (iaa == NULL) {
 		SPDK_ERRLOG("Failed to get an idxd channel\n");
 		return -EINVAL;
 	}
 
+	STAILQ_INIT(&chan->free_tables);
+	if (g_iaa_huffman_mode != ACCEL_IAA_HUFFMAN_FIXED) {
+		if (iaa_alloc_tables(chan)) {
+			spdk_idxd_put_channel(chan->chan);
+			return -ENOMEM;
+		}
+	}
+
 	chan->dev = iaa;
 	chan->poller = SPDK_POLLER_REGISTER(idxd_poll, chan, 0);
 	TAILQ_INIT(&chan->queued_tasks);
@@ -302,6 +552,7 @@ idxd_destroy_cb(void *io_device, void *ctx_buf)
 
 	spdk_poller_unregister(&chan->poller);
 	spdk_idxd_put_channel(chan->chan);
+	iaa_free_tables(chan);
 }
 
 static struct spdk_io_channel *
@@ -331,9 +582,10 @@ attach_cb(void *cb_ctx, struct spdk_idxd_device *iaa)
 }
 
 void
-accel_iaa_enable_probe(void)
+accel_iaa_enable_probe(enum accel_iaa_huffman_mode huffman_mode)
 {
 	g_iaa_enable = true;
+	g_iaa_huffman_mode = huffman_mode;
 	/* TODO initially only support user mode w/IAA */
 	spdk_idxd_set_config(false);
 	spdk_accel_module_list_add(&g_iaa_module);
@@ -349,6 +601,34 @@ caller_probe_cb(void *cb_ctx, struct spdk_pci_device *dev)
 	return false;
 }
 
+static const char *g_huffman_mode_names[] = {
+	[ACCEL_IAA_HUFFMAN_FIXED]	= "fixed",
+	[ACCEL_IAA_HUFFMAN_DYNAMIC]	= "dynamic",
+	[ACCEL_IAA_HUFFMAN_CANNED]	= "canned",
+};
+
+const char *
+accel_iaa_huffman_mode_name(enum accel_iaa_huffman_mode mode)
+{
+	assert(mode < SPDK_COUNTOF(g_huffman_mode_names));
+	return g_huffman_mode_names[mode];
+}
+
+int
+accel_iaa_parse_huffman_mode(const char *name, enum accel_iaa_huffman_mode *mode)
+{
+	size_t i;
+
+	for (i = 0; i < SPDK_COUNTOF(g_huffman_mode_names); i++) {
+		if (strcmp(name, g_huffman_mode_names[i]) == 0) {
+			*mode = i;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
 static int
 accel_iaa_init(void)
 {
@@ -399,6 +679,9 @@ accel_iaa_write_config_json(struct spdk_json_write_ctx *w)
 	if (g_iaa_enable) {
 		spdk_json_write_object_begin(w);
 		spdk_json_write_named_string(w, "method", "iaa_scan_accel_module");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "huffman_mode",
+					     accel_iaa_huffman_mode_name(g_iaa_huffman_mode));
 		spdk_json_write_object_end(w);
 		spdk_json_write_object_end(w);
 	}
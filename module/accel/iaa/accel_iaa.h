@@ -8,6 +8,18 @@
 
 #include "spdk/stdinc.h"
 
-void accel_iaa_enable_probe(void);
+enum accel_iaa_huffman_mode {
+	/* Compress with the fixed Huffman table defined by RFC-1951 */
+	ACCEL_IAA_HUFFMAN_FIXED,
+	/* Gather the statistics of each buffer and compress it with a table built for it */
+	ACCEL_IAA_HUFFMAN_DYNAMIC,
+	/* Like dynamic for the first operations on a channel, then use a table built from
+	 * their statistics for all further operations */
+	ACCEL_IAA_HUFFMAN_CANNED,
+};
+
+void accel_iaa_enable_probe(enum accel_iaa_huffman_mode huffman_mode);
+const char *accel_iaa_huffman_mode_name(enum accel_iaa_huffman_mode mode);
+int accel_iaa_parse_huffman_mode(const char *name, enum accel_iaa_huffman_mode *mode);
 
 #endif /* SPDK_ACCEL_MODULE_IAA_H */
@@ -11,19 +11,44 @@
 #include "spdk/stdinc.h"
 #include "spdk/env.h"
 
+struct rpc_iaa_scan_accel_module {
+	char *huffman_mode;
+};
+
+static const struct spdk_json_object_decoder rpc_iaa_scan_accel_module_decoder[] = {
+	{"huffman_mode", offsetof(struct rpc_iaa_scan_accel_module, huffman_mode), spdk_json_decode_string, true},
+};
+
 static void
 rpc_iaa_scan_accel_module(struct spdk_jsonrpc_request *request,
 			  const struct spdk_json_val *params)
 {
+	struct rpc_iaa_scan_accel_module req = {};
+	enum accel_iaa_huffman_mode mode = ACCEL_IAA_HUFFMAN_FIXED;
+
 	if (params != NULL) {
-		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
-						 "iaa_scan_accel_module requires no parameters");
-		return;
+		if (spdk_json_decode_object(params, rpc_iaa_scan_accel_module_decoder,
+					    SPDK_COUNTOF(rpc_iaa_scan_accel_module_decoder),
+					    &req)) {
+			SPDK_ERRLOG("spdk_json_decode_object() failed\n");
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							 "Invalid parameters");
+			goto cleanup;
+		}
+	}
+
+	if (req.huffman_mode != NULL && accel_iaa_parse_huffman_mode(req.huffman_mode, &mode)) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "Invalid huffman_mode: %s", req.huffman_mode);
+		goto cleanup;
 	}
 
-	SPDK_NOTICELOG("Enabling IAA user-mode\n");
-	accel_iaa_enable_probe();
+	SPDK_NOTICELOG("Enabling IAA user-mode, %s Huffman tables\n",
+		       accel_iaa_huffman_mode_name(mode));
+	accel_iaa_enable_probe(mode);
 	spdk_jsonrpc_send_bool_response(request, true);
+cleanup:
+	free(req.huffman_mode);
 }
 SPDK_RPC_REGISTER("iaa_scan_accel_module", rpc_iaa_scan_accel_module, SPDK_RPC_STARTUP)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(iaa_scan_accel_module, iaa_scan_accel_engine)
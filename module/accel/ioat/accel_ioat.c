@@ -41,6 +41,8 @@ struct ioat_io_channel {
 	struct spdk_ioat_chan		*ioat_ch;
 	struct ioat_device		*ioat_dev;
 	struct spdk_poller		*poller;
+	/* Number of requests built since the last doorbell write */
+	uint32_t			num_unflushed;
 };
 
 static struct ioat_device *
@@ -103,10 +105,22 @@ ioat_done(void *cb_arg)
 static int
 ioat_poll(void *arg)
 {
-	struct spdk_ioat_chan *chan = arg;
+	struct ioat_io_channel *ch = arg;
+	int rc;
+
+	rc = spdk_ioat_process_events(ch->ioat_ch);
+
+	/*
+	 * Everything built since the previous poll, including the requests submitted from the
+	 * completion callbacks above, is submitted with a single doorbell write.
+	 */
+	if (ch->num_unflushed > 0) {
+		spdk_ioat_flush(ch->ioat_ch);
+		ch->num_unflushed = 0;
+		return SPDK_POLLER_BUSY;
+	}
 
-	return spdk_ioat_process_events(chan) != 0 ? SPDK_POLLER_BUSY :
-	       SPDK_POLLER_IDLE;
+	return rc != 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
 static struct spdk_io_channel *ioat_get_io_channel(void);
@@ -143,17 +157,14 @@ ioat_submit_fill(struct ioat_io_channel *ioat_ch, struct spdk_accel_task *task)
 static int
 ioat_submit_copy(struct ioat_io_channel *ioat_ch, struct spdk_accel_task *task)
 {
-	if (spdk_unlikely(task->d.iovcnt != 1 || task->s.iovcnt != 1)) {
-		return -EINVAL;
-	}
-
-	if (spdk_unlikely(task->d.iovs[0].iov_len != task->s.iovs[0].iov_len)) {
+	if (spdk_unlikely(task->d.iovcnt == 1 && task->s.iovcnt == 1 &&
+			  task->d.iovs[0].iov_len != task->s.iovs[0].iov_len)) {
 		return -EINVAL;
 	}
 
-	return spdk_ioat_build_copy(ioat_ch->ioat_ch, task, ioat_done,
-				    task->d.iovs[0].iov_base, task->s.iovs[0].iov_base,
-				    task->d.iovs[0].iov_len);
+	return spdk_ioat_build_copyv(ioat_ch->ioat_ch, task, ioat_done,
+				     task->d.iovs, task->d.iovcnt,
+				     task->s.iovs, task->s.iovcnt);
 }
 
 static int
@@ -181,13 +192,14 @@ ioat_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_task
 		/* Report any build errors via the callback now. */
 		if (rc) {
 			spdk_accel_task_complete(accel_task, rc);
+		} else {
+			ioat_ch->num_unflushed++;
 		}
 
 		accel_task = tmp;
 	} while (accel_task);
 
-	spdk_ioat_flush(ioat_ch->ioat_ch);
-
+	/* The descriptors are submitted by the poller, see ioat_poll() */
 	return 0;
 }
 
@@ -204,7 +216,8 @@ ioat_create_cb(void *io_device, void *ctx_buf)
 
 	ch->ioat_dev = ioat_dev;
 	ch->ioat_ch = ioat_dev->ioat;
-	ch->poller = SPDK_POLLER_REGISTER(ioat_poll, ch->ioat_ch, 0);
+	ch->num_unflushed = 0;
+	ch->poller = SPDK_POLLER_REGISTER(ioat_poll, ch, 0);
 
 	return 0;
 }
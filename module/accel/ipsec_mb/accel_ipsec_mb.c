@@ -0,0 +1,529 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "accel_ipsec_mb.h"
+
+#include "spdk/stdinc.h"
+
+#include "spdk/accel_module.h"
+#include "spdk/json.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+#include "spdk_internal/sgl.h"
+
+#include <intel-ipsec-mb.h>
+
+#define ACCEL_IPSEC_MB_AES_BLOCK_SIZE	16
+#define ACCEL_IPSEC_MB_IV_LENGTH	16
+/* Size of the expanded round keys of AES-256, the largest key supported */
+#define ACCEL_IPSEC_MB_ROUND_KEYS_SIZE	(15 * ACCEL_IPSEC_MB_AES_BLOCK_SIZE)
+
+static bool g_ipsec_mb_enable = false;
+static bool g_ipsec_mb_initialized = false;
+
+/* Only used to expand the keys, which doesn't touch the job state of the manager */
+static IMB_MGR *g_ipsec_mb_key_mgr;
+
+struct accel_ipsec_mb_key_priv {
+	uint8_t		enc_keys[ACCEL_IPSEC_MB_ROUND_KEYS_SIZE] __attribute__((aligned(16)));
+	uint8_t		dec_keys[ACCEL_IPSEC_MB_ROUND_KEYS_SIZE] __attribute__((aligned(16)));
+};
+
+struct accel_ipsec_mb_io_channel {
+	IMB_MGR				*mgr;
+	struct spdk_poller		*poller;
+	/* Tasks submitted since the last poll, their jobs are submitted to the manager together */
+	TAILQ_HEAD(, spdk_accel_task)	tasks;
+	/*
+	 * IVs of the jobs.  The manager hands out the jobs of its ring in order and only once the
+	 * previous job using the same slot has been returned, so the IVs are used the same way.
+	 */
+	uint64_t			ivs[IMB_MAX_JOBS][2];
+	uint32_t			iv_idx;
+	/* Used for the blocks which aren't contiguous in the source or the destination */
+	uint8_t				*bounce_buf;
+	uint32_t			bounce_buf_size;
+};
+
+static struct spdk_accel_module_if g_ipsec_mb_module;
+
+static IMB_MGR *
+accel_ipsec_mb_mgr_create(void)
+{
+	IMB_MGR *mgr;
+
+	mgr = alloc_mb_mgr(0);
+	if (mgr == NULL) {
+		return NULL;
+	}
+
+	/* Picks the best implementation for the CPU, i.e. SSE, AVX, AVX2 or AVX512 */
+	init_mb_mgr_auto(mgr, NULL);
+	if (imb_get_errno(mgr) != 0) {
+		SPDK_ERRLOG("Failed to initialize the multi-buffer manager: %s\n",
+			    imb_get_strerror(imb_get_errno(mgr)));
+		free_mb_mgr(mgr);
+		return NULL;
+	}
+
+	return mgr;
+}
+
+static void
+accel_ipsec_mb_job_done(IMB_JOB *job)
+{
+	struct spdk_accel_task *task = job->user_data;
+
+	if (spdk_unlikely(job->status != IMB_STATUS_COMPLETED)) {
+		SPDK_ERRLOG("Crypto job failed with status %d\n", job->status);
+		task->status = -EIO;
+	}
+}
+
+static void
+accel_ipsec_mb_flush_jobs(struct accel_ipsec_mb_io_channel *ch)
+{
+	IMB_JOB *job;
+
+	while ((job = IMB_FLUSH_JOB(ch->mgr)) != NULL) {
+		accel_ipsec_mb_job_done(job);
+	}
+}
+
+static void
+accel_ipsec_mb_submit_job(struct accel_ipsec_mb_io_channel *ch, struct spdk_accel_task *task,
+			  uint8_t *src, uint8_t *dst, uint32_t len, uint64_t iv)
+{
+	struct spdk_accel_crypto_key *key = task->crypto_key;
+	struct accel_ipsec_mb_key_priv *priv = key->priv;
+	uint64_t *job_iv;
+	IMB_JOB *job;
+
+	job = IMB_GET_NEXT_JOB(ch->mgr);
+
+	/* The LBA is used as the IV, like the DPDK cryptodev module does */
+	job_iv = ch->ivs[ch->iv_idx];
+	ch->iv_idx = (ch->iv_idx + 1) % IMB_MAX_JOBS;
+	job_iv[0] = iv;
+	job_iv[1] = 0;
+
+	job->cipher_mode = IMB_CIPHER_CBC;
+	job->hash_alg = IMB_AUTH_NULL;
+	if (task->op_code == SPDK_ACCEL_OPC_ENCRYPT) {
+		job->cipher_direction = IMB_DIR_ENCRYPT;
+		job->chain_order = IMB_ORDER_CIPHER_HASH;
+	} else {
+		job->cipher_direction = IMB_DIR_DECRYPT;
+		job->chain_order = IMB_ORDER_HASH_CIPHER;
+	}
+	job->enc_keys = priv->enc_keys;
+	job->dec_keys = priv->dec_keys;
+	job->key_len_in_bytes = key->key_size;
+	job->src = src;
+	job->dst = dst;
+	job->cipher_start_src_offset_in_bytes = 0;
+	job->msg_len_to_cipher_in_bytes = len;
+	job->iv = (const uint8_t *)job_iv;
+	job->iv_len_in_bytes = ACCEL_IPSEC_MB_IV_LENGTH;
+	job->user_data = task;
+
+	/* The manager only processes the jobs once enough of them are gathered */
+	job = IMB_SUBMIT_JOB(ch->mgr);
+	while (job != NULL) {
+		accel_ipsec_mb_job_done(job);
+		job = IMB_GET_COMPLETED_JOB(ch->mgr);
+	}
+}
+
+static void
+accel_ipsec_mb_copy_from_sgl(uint8_t *buf, struct spdk_iov_sgl *sgl, uint32_t len)
+{
+	uint32_t copy_len;
+
+	while (len > 0) {
+		copy_len = spdk_min(len, sgl->iov->iov_len - sgl->iov_offset);
+		memcpy(buf, (uint8_t *)sgl->iov->iov_base + sgl->iov_offset, copy_len);
+		spdk_iov_sgl_advance(sgl, copy_len);
+		buf += copy_len;
+		len -= copy_len;
+	}
+}
+
+static void
+accel_ipsec_mb_copy_to_sgl(struct spdk_iov_sgl *sgl, uint8_t *buf, uint32_t len)
+{
+	uint32_t copy_len;
+
+	while (len > 0) {
+		copy_len = spdk_min(len, sgl->iov->iov_len - sgl->iov_offset);
+		memcpy((uint8_t *)sgl->iov->iov_base + sgl->iov_offset, buf, copy_len);
+		spdk_iov_sgl_advance(sgl, copy_len);
+		buf += copy_len;
+		len -= copy_len;
+	}
+}
+
+static int
+accel_ipsec_mb_bounce_block(struct accel_ipsec_mb_io_channel *ch, struct spdk_accel_task *task,
+			    struct spdk_iov_sgl *src, struct spdk_iov_sgl *dst, uint64_t iv)
+{
+	uint32_t block_size = task->block_size;
+	uint8_t *buf;
+
+	if (ch->bounce_buf_size < block_size) {
+		buf = realloc(ch->bounce_buf, block_size);
+		if (buf == NULL) {
+			return -ENOMEM;
+		}
+		ch->bounce_buf = buf;
+		ch->bounce_buf_size = block_size;
+	}
+
+	/* The bounce buffer is shared by the whole channel, so the job is processed right away */
+	accel_ipsec_mb_copy_from_sgl(ch->bounce_buf, src, block_size);
+	accel_ipsec_mb_submit_job(ch, task, ch->bounce_buf, ch->bounce_buf, block_size, iv);
+	accel_ipsec_mb_flush_jobs(ch);
+	accel_ipsec_mb_copy_to_sgl(dst, ch->bounce_buf, block_size);
+
+	return 0;
+}
+
+static int
+accel_ipsec_mb_submit_task(struct accel_ipsec_mb_io_channel *ch, struct spdk_accel_task *task)
+{
+	uint32_t block_size = task->block_size;
+	struct spdk_iov_sgl src, dst;
+	uint64_t iv = task->iv;
+	int rc;
+
+	spdk_iov_sgl_init(&src, task->s.iovs, task->s.iovcnt, 0);
+	if (task->d.iovcnt) {
+		spdk_iov_sgl_init(&dst, task->d.iovs, task->d.iovcnt, 0);
+	} else {
+		/* inplace operation */
+		spdk_iov_sgl_init(&dst, task->s.iovs, task->s.iovcnt, 0);
+	}
+
+	/* Each logical block is encrypted separately, with its LBA as the IV */
+	while (src.iovcnt > 0) {
+		if (spdk_likely(src.iov->iov_len - src.iov_offset >= block_size &&
+				dst.iov->iov_len - dst.iov_offset >= block_size)) {
+			accel_ipsec_mb_submit_job(ch, task,
+						  (uint8_t *)src.iov->iov_base + src.iov_offset,
+						  (uint8_t *)dst.iov->iov_base + dst.iov_offset,
+						  block_size, iv);
+			spdk_iov_sgl_advance(&src, block_size);
+			spdk_iov_sgl_advance(&dst, block_size);
+		} else {
+			rc = accel_ipsec_mb_bounce_block(ch, task, &src, &dst, iv);
+			if (spdk_unlikely(rc != 0)) {
+				return rc;
+			}
+		}
+		iv++;
+	}
+
+	return 0;
+}
+
+static uint64_t
+accel_ipsec_mb_get_iovlen(struct iovec *iovs, uint32_t iovcnt)
+{
+	uint64_t result = 0;
+	uint32_t i;
+
+	for (i = 0; i < iovcnt; i++) {
+		result += iovs[i].iov_len;
+	}
+
+	return result;
+}
+
+static int
+accel_ipsec_mb_check_task(struct spdk_accel_task *task)
+{
+	struct spdk_accel_crypto_key *key = task->crypto_key;
+	uint64_t src_len, dst_len;
+
+	if (spdk_unlikely(key->module_if != &g_ipsec_mb_module || !key->priv)) {
+		return -EINVAL;
+	}
+	if (spdk_unlikely(task->block_size == 0 ||
+			  task->block_size % ACCEL_IPSEC_MB_AES_BLOCK_SIZE != 0)) {
+		SPDK_ERRLOG("Block size %u is not a multiple of the AES block size\n",
+			    task->block_size);
+		return -EINVAL;
+	}
+
+	src_len = accel_ipsec_mb_get_iovlen(task->s.iovs, task->s.iovcnt);
+	if (task->d.iovcnt) {
+		dst_len = accel_ipsec_mb_get_iovlen(task->d.iovs, task->d.iovcnt);
+		if (spdk_unlikely(src_len != dst_len)) {
+			return -ERANGE;
+		}
+	}
+	if (spdk_unlikely(src_len == 0 || src_len % task->block_size != 0)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+accel_ipsec_mb_poll(void *arg)
+{
+	struct accel_ipsec_mb_io_channel *ch = arg;
+	TAILQ_HEAD(, spdk_accel_task) tasks;
+	struct spdk_accel_task *task;
+	int rc;
+
+	if (TAILQ_EMPTY(&ch->tasks)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	TAILQ_INIT(&tasks);
+	TAILQ_SWAP(&tasks, &ch->tasks, spdk_accel_task, link);
+
+	/*
+	 * The jobs of all the tasks are submitted before flushing the manager, so that it can
+	 * process as many buffers in parallel as possible.
+	 */
+	TAILQ_FOREACH(task, &tasks, link) {
+		if (spdk_unlikely(task->status != 0)) {
+			continue;
+		}
+		rc = accel_ipsec_mb_submit_task(ch, task);
+		if (spdk_unlikely(rc != 0)) {
+			task->status = rc;
+		}
+	}
+	accel_ipsec_mb_flush_jobs(ch);
+
+	while ((task = TAILQ_FIRST(&tasks))) {
+		TAILQ_REMOVE(&tasks, task, link);
+		spdk_accel_task_complete(task, task->status);
+	}
+
+	return SPDK_POLLER_BUSY;
+}
+
+static int
+accel_ipsec_mb_submit_tasks(struct spdk_io_channel *_ch, struct spdk_accel_task *task)
+{
+	struct accel_ipsec_mb_io_channel *ch = spdk_io_channel_get_ctx(_ch);
+	struct spdk_accel_task *tmp;
+	int rc;
+
+	do {
+		tmp = TAILQ_NEXT(task, link);
+
+		switch (task->op_code) {
+		case SPDK_ACCEL_OPC_ENCRYPT:
+		case SPDK_ACCEL_OPC_DECRYPT:
+			rc = accel_ipsec_mb_check_task(task);
+			break;
+		default:
+			assert(false);
+			rc = -EINVAL;
+			break;
+		}
+
+		/* The tasks are processed and completed by the poller, see accel_ipsec_mb_poll() */
+		task->status = rc;
+		TAILQ_INSERT_TAIL(&ch->tasks, task, link);
+
+		task = tmp;
+	} while (task);
+
+	return 0;
+}
+
+static bool
+accel_ipsec_mb_supports_opcode(enum spdk_accel_opcode opc)
+{
+	if (!g_ipsec_mb_initialized) {
+		assert(0);
+		return false;
+	}
+
+	switch (opc) {
+	case SPDK_ACCEL_OPC_ENCRYPT:
+	case SPDK_ACCEL_OPC_DECRYPT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool
+accel_ipsec_mb_supports_cipher(enum spdk_accel_cipher cipher, size_t key_size)
+{
+	switch (cipher) {
+	case SPDK_ACCEL_CIPHER_AES_CBC:
+		return key_size == IMB_KEY_128_BYTES || key_size == IMB_KEY_256_BYTES;
+	default:
+		return false;
+	}
+}
+
+static int
+accel_ipsec_mb_key_init(struct spdk_accel_crypto_key *key)
+{
+	struct accel_ipsec_mb_key_priv *priv;
+	int rc;
+
+	if (!accel_ipsec_mb_supports_cipher(key->cipher, key->key_size)) {
+		return -EINVAL;
+	}
+
+	rc = posix_memalign((void **)&priv, 16, sizeof(*priv));
+	if (rc != 0) {
+		SPDK_ERRLOG("Memory allocation failed\n");
+		return -ENOMEM;
+	}
+
+	if (key->key_size == IMB_KEY_128_BYTES) {
+		IMB_AES_KEYEXP_128(g_ipsec_mb_key_mgr, key->key, priv->enc_keys, priv->dec_keys);
+	} else {
+		IMB_AES_KEYEXP_256(g_ipsec_mb_key_mgr, key->key, priv->enc_keys, priv->dec_keys);
+	}
+	key->priv = priv;
+
+	return 0;
+}
+
+static void
+accel_ipsec_mb_key_deinit(struct spdk_accel_crypto_key *key)
+{
+	struct accel_ipsec_mb_key_priv *priv = key->priv;
+
+	if (priv == NULL) {
+		return;
+	}
+
+	spdk_memset_s(priv, sizeof(*priv), 0, sizeof(*priv));
+	free(priv);
+	key->priv = NULL;
+}
+
+static int
+accel_ipsec_mb_create_cb(void *io_device, void *ctx_buf)
+{
+	struct accel_ipsec_mb_io_channel *ch = ctx_buf;
+
+	ch->mgr = accel_ipsec_mb_mgr_create();
+	if (ch->mgr == NULL) {
+		return -ENOMEM;
+	}
+
+	TAILQ_INIT(&ch->tasks);
+	ch->iv_idx = 0;
+	ch->bounce_buf = NULL;
+	ch->bounce_buf_size = 0;
+	ch->poller = SPDK_POLLER_REGISTER(accel_ipsec_mb_poll, ch, 0);
+
+	return 0;
+}
+
+static void
+accel_ipsec_mb_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct accel_ipsec_mb_io_channel *ch = ctx_buf;
+
+	assert(TAILQ_EMPTY(&ch->tasks));
+
+	spdk_poller_unregister(&ch->poller);
+	free(ch->bounce_buf);
+	free_mb_mgr(ch->mgr);
+}
+
+static struct spdk_io_channel *
+accel_ipsec_mb_get_io_channel(void)
+{
+	return spdk_get_io_channel(&g_ipsec_mb_module);
+}
+
+static size_t
+accel_ipsec_mb_get_ctx_size(void)
+{
+	return sizeof(struct spdk_accel_task);
+}
+
+void
+accel_ipsec_mb_enable(void)
+{
+	g_ipsec_mb_enable = true;
+	spdk_accel_module_list_add(&g_ipsec_mb_module);
+}
+
+static int
+accel_ipsec_mb_init(void)
+{
+	if (!g_ipsec_mb_enable) {
+		assert(0);
+		return 0;
+	}
+
+	g_ipsec_mb_key_mgr = accel_ipsec_mb_mgr_create();
+	if (g_ipsec_mb_key_mgr == NULL) {
+		SPDK_ERRLOG("Failed to create the multi-buffer manager\n");
+		return -ENOMEM;
+	}
+
+	SPDK_NOTICELOG("Using intel-ipsec-mb %s\n", imb_get_version_str());
+
+	g_ipsec_mb_initialized = true;
+	spdk_io_device_register(&g_ipsec_mb_module, accel_ipsec_mb_create_cb,
+				accel_ipsec_mb_destroy_cb, sizeof(struct accel_ipsec_mb_io_channel),
+				"accel_ipsec_mb");
+
+	return 0;
+}
+
+static void
+accel_ipsec_mb_unregister_cb(void *io_device)
+{
+	free_mb_mgr(g_ipsec_mb_key_mgr);
+	g_ipsec_mb_key_mgr = NULL;
+	g_ipsec_mb_initialized = false;
+
+	spdk_accel_module_finish();
+}
+
+static void
+accel_ipsec_mb_fini(void *ctx)
+{
+	if (g_ipsec_mb_initialized) {
+		spdk_io_device_unregister(&g_ipsec_mb_module, accel_ipsec_mb_unregister_cb);
+	} else {
+		spdk_accel_module_finish();
+	}
+}
+
+static void
+accel_ipsec_mb_write_config_json(struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "ipsec_mb_scan_accel_module");
+	spdk_json_write_object_end(w);
+}
+
+static struct spdk_accel_module_if g_ipsec_mb_module = {
+	.module_init		= accel_ipsec_mb_init,
+	.module_fini		= accel_ipsec_mb_fini,
+	.write_config_json	= accel_ipsec_mb_write_config_json,
+	.get_ctx_size		= accel_ipsec_mb_get_ctx_size,
+	.name			= "ipsec_mb",
+	.supports_opcode	= accel_ipsec_mb_supports_opcode,
+	.get_io_channel		= accel_ipsec_mb_get_io_channel,
+	.submit_tasks		= accel_ipsec_mb_submit_tasks,
+	.crypto_key_init	= accel_ipsec_mb_key_init,
+	.crypto_key_deinit	= accel_ipsec_mb_key_deinit,
+	.crypto_supports_cipher	= accel_ipsec_mb_supports_cipher,
+};
+
+SPDK_LOG_REGISTER_COMPONENT(accel_ipsec_mb)
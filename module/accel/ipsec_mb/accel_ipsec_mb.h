@@ -0,0 +1,13 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_ACCEL_IPSEC_MB_H
+#define SPDK_ACCEL_IPSEC_MB_H
+
+#include "spdk/stdinc.h"
+
+void accel_ipsec_mb_enable(void);
+
+#endif /* SPDK_ACCEL_IPSEC_MB_H */
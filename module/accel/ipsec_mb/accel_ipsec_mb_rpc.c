@@ -0,0 +1,24 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "accel_ipsec_mb.h"
+
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+
+static void
+rpc_ipsec_mb_scan_accel_module(struct spdk_jsonrpc_request *request,
+			       const struct spdk_json_val *params)
+{
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "No parameters expected");
+		return;
+	}
+
+	accel_ipsec_mb_enable();
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("ipsec_mb_scan_accel_module", rpc_ipsec_mb_scan_accel_module, SPDK_RPC_STARTUP)
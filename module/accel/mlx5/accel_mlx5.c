@@ -3,6 +3,8 @@
  */
 
 #include "spdk/env.h"
+#include "spdk/crc32.h"
+#include "spdk/endian.h"
 #include "spdk/thread.h"
 #include "spdk/queue.h"
 #include "spdk/log.h"
@@ -28,6 +30,8 @@
 #define ACCEL_MLX5_MAX_SGE (16u)
 #define ACCEL_MLX5_MAX_WC (64u)
 #define ACCEL_MLX5_ALLOC_REQS_IN_BATCH (16u)
+/* Bit-reflected CRC-32C (Castagnoli) polynomial */
+#define ACCEL_MLX5_CRC32C_POLY (0x82F63B78u)
 
 struct accel_mlx5_io_channel;
 struct accel_mlx5_task;
@@ -44,6 +48,9 @@ struct accel_mlx5_module {
 	struct accel_mlx5_crypto_dev_ctx *crypto_ctxs;
 	uint32_t num_crypto_ctxs;
 	struct accel_mlx5_attr attr;
+	/* Signature block sizes (MLX5DV_BLOCK_SIZE_CAP_*) supported by all devices for CRC-32C */
+	uint64_t crc32c_block_size_caps;
+	bool crc32c_supported;
 	bool enabled;
 };
 
@@ -60,9 +67,12 @@ struct accel_mlx5_req {
 	struct accel_mlx5_task *task;
 	struct mlx5dv_mkey *mkey;
 	struct ibv_sge src_sg[ACCEL_MLX5_MAX_SGE];
-	struct ibv_sge dst_sg[ACCEL_MLX5_MAX_SGE];
+	/* One extra entry for the CRC-32C signature generated at the end of the block */
+	struct ibv_sge dst_sg[ACCEL_MLX5_MAX_SGE + 1];
 	uint16_t src_sg_count;
 	uint16_t dst_sg_count;
+	/* CRC-32C of the block written by the device, big endian */
+	uint32_t crc;
 	struct accel_mlx5_wrid mkey_wrid;
 	struct accel_mlx5_wrid write_wrid;
 	TAILQ_ENTRY(accel_mlx5_req) link;
@@ -79,12 +89,26 @@ struct accel_mlx5_task {
 	struct spdk_iov_sgl src;
 	struct spdk_iov_sgl dst;
 	struct accel_mlx5_req *cur_req;
+	uint64_t nbytes;
+	/* Each request handles a single block of this size */
+	uint32_t block_size;
+	/* CRC-32C result and seed, NULL if the task doesn't compute a CRC */
+	uint32_t *crc_dst;
+	uint32_t seed;
+	/* Standard CRC-32C of the blocks completed so far */
+	uint32_t crc;
+	/* x^(8 * block_size) mod P, used to append a block's CRC to the running one */
+	uint32_t crc_shift;
+	enum mlx5dv_block_size sig_block_size;
 	/* If set, memory data will be encrypted during TX and wire data will be
 	  decrypted during RX.
 	  If not set, memory data will be decrypted during TX and wire data will
 	  be encrypted during RX. */
 	bool encrypt_on_tx;
 	bool inplace;
+	bool crypto;
+	/* CRC-32C of each block is generated by the signature offload */
+	bool crc_offload;
 	TAILQ_ENTRY(accel_mlx5_task) link;
 };
 
@@ -126,6 +150,7 @@ struct accel_mlx5_io_channel {
 
 struct accel_mlx5_req_init_ctx {
 	struct ibv_pd *pd;
+	bool signature;
 	int rc;
 };
 
@@ -256,6 +281,72 @@ accel_mlx5_get_qp_state(struct ibv_qp *qp) {
 	return qp_attr.qp_state;
 }
 
+/* Multiplies two polynomials modulo the CRC-32C polynomial, a must not be 0 */
+static uint32_t
+accel_mlx5_crc32c_multmodp(uint32_t a, uint32_t b)
+{
+	uint32_t m = UINT32_C(1) << 31, p = 0;
+
+	for (;;) {
+		if (a & m) {
+			p ^= b;
+			if ((a & (m - 1)) == 0) {
+				break;
+			}
+		}
+		m >>= 1;
+		b = b & 1 ? (b >> 1) ^ ACCEL_MLX5_CRC32C_POLY : b >> 1;
+	}
+
+	return p;
+}
+
+/* Returns x^(8 * len) modulo the CRC-32C polynomial, i.e. the operator feeding len zero bytes */
+static uint32_t
+accel_mlx5_crc32c_x8nmodp(uint64_t len)
+{
+	uint32_t p = UINT32_C(1) << 31, sq = UINT32_C(1) << 30;
+	uint64_t n = len * 8;
+
+	while (n) {
+		if (n & 1) {
+			p = accel_mlx5_crc32c_multmodp(sq, p);
+		}
+		sq = accel_mlx5_crc32c_multmodp(sq, sq);
+		n >>= 1;
+	}
+
+	return p;
+}
+
+static inline void
+accel_mlx5_task_set_crc(struct accel_mlx5_task *task)
+{
+	struct spdk_accel_task *base = &task->base;
+
+	if (!task->crc_offload) {
+		/* The signature offload can't handle this block size, checksum the result */
+		if (task->inplace) {
+			*task->crc_dst = spdk_crc32c_iov_update(base->s.iovs, base->s.iovcnt,
+							       ~task->seed);
+		} else {
+			*task->crc_dst = spdk_crc32c_iov_update(base->d.iovs, base->d.iovcnt,
+							       ~task->seed);
+		}
+		return;
+	}
+
+	/* task->crc is the standard CRC-32C (initial value and final xor of ~0) of the data, while
+	 * accel expects the CRC register after processing the data starting from ~seed.  Since the
+	 * register is linear in its initial value, the two differ by ~0 and by the seed shifted
+	 * over the length of the data. */
+	*task->crc_dst = ~task->crc;
+	if (task->seed != 0) {
+		*task->crc_dst ^= accel_mlx5_crc32c_multmodp(accel_mlx5_crc32c_x8nmodp(task->nbytes),
+				  task->seed);
+	}
+}
+
 static inline void
 accel_mlx5_task_complete(struct accel_mlx5_task *task)
 {
@@ -267,6 +358,9 @@ accel_mlx5_task_complete(struct accel_mlx5_task *task)
 	TAILQ_FOREACH(req, &task->reqs, link) {
 		spdk_mempool_put(task->dev->dev_ctx->requests_pool, req);
 	}
+	if (task->crc_dst != NULL && task->rc == 0) {
+		accel_mlx5_task_set_crc(task);
+	}
 	spdk_accel_task_complete(&task->base, task->rc);
 }
 
@@ -306,7 +400,7 @@ accel_mlx5_fill_block_sge(struct accel_mlx5_req *req, struct ibv_sge *sge,
 {
 	struct spdk_rdma_memory_translation translation;
 	void *addr;
-	uint32_t remaining = req->task->base.block_size;
+	uint32_t remaining = req->task->block_size;
 	uint32_t size;
 	int i = 0;
 	int rc;
@@ -331,6 +425,26 @@ accel_mlx5_fill_block_sge(struct accel_mlx5_req *req, struct ibv_sge *sge,
 	return i;
 }
 
+static inline int
+accel_mlx5_fill_crc_sge(struct accel_mlx5_req *req, struct ibv_sge *sge)
+{
+	struct spdk_rdma_memory_translation translation;
+	int rc;
+
+	rc = spdk_rdma_get_translation(req->task->dev->mmap, &req->crc, sizeof(req->crc),
+				       &translation);
+	if (spdk_unlikely(rc)) {
+		SPDK_ERRLOG("Memory translation failed, addr %p, length %zu\n", &req->crc,
+			    sizeof(req->crc));
+		return rc;
+	}
+	sge->lkey = spdk_rdma_memory_translation_get_lkey(&translation);
+	sge->addr = (uint64_t)&req->crc;
+	sge->length = sizeof(req->crc);
+
+	return 0;
+}
+
 static inline bool
 accel_mlx5_compare_iovs(struct iovec *v1, struct iovec *v2, uint32_t iovcnt)
 {
@@ -387,12 +501,27 @@ accel_mlx5_task_process(struct accel_mlx5_task *mlx5_task)
 	struct mlx5dv_qp_ex *mqpx = qp->mqpx;
 	struct mlx5dv_mkey_conf_attr mkey_attr = {};
 	struct mlx5dv_crypto_attr cattr;
+	struct mlx5dv_sig_crc sig_crc = {
+		.type = MLX5DV_SIG_CRC_TYPE_CRC32C,
+		.seed = UINT32_MAX,
+	};
+	/* The CRC is generated into memory after each block, nothing is expected on the wire */
+	struct mlx5dv_sig_block_domain sig_mem = {
+		.sig_type = MLX5DV_SIG_TYPE_CRC,
+		.sig.crc = &sig_crc,
+		.block_size = mlx5_task->sig_block_size,
+	};
+	struct mlx5dv_sig_block_attr sig_attr = {
+		.mem = &sig_mem,
+	};
 	struct accel_mlx5_req *req;
+	struct ibv_sge *layout;
 	uint64_t iv;
-	uint32_t num_setters = 3; /* access flags, layout, crypto */
+	uint32_t num_setters = 2; /* access flags, layout */
 	int rc;
 
 	iv = task->iv + mlx5_task->num_completed_reqs;
+	num_setters += mlx5_task->crypto + mlx5_task->crc_offload;
 
 	if (!qp->wr_started) {
 		ibv_wr_start(qpx);
@@ -421,7 +550,8 @@ accel_mlx5_task_process(struct accel_mlx5_task *mlx5_task)
 		mlx5dv_wr_set_mkey_access_flags(mqpx,
 						IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE | IBV_ACCESS_REMOTE_READ);
 		if (mlx5_task->inplace) {
-			mlx5dv_wr_set_mkey_layout_list(mqpx, req->src_sg_count, req->src_sg);
+			layout = req->src_sg;
+			req->dst_sg_count = req->src_sg_count;
 		} else {
 			rc = accel_mlx5_fill_block_sge(req, req->dst_sg, &mlx5_task->dst);
 			if (spdk_unlikely(rc <= 0)) {
@@ -433,18 +563,44 @@ accel_mlx5_task_process(struct accel_mlx5_task *mlx5_task)
 				goto err_out;
 			}
 			req->dst_sg_count = rc;
-			mlx5dv_wr_set_mkey_layout_list(mqpx, req->dst_sg_count, req->dst_sg);
+			layout = req->dst_sg;
 		}
-		SPDK_DEBUGLOG(accel_mlx5, "req %p, task %p crypto_attr: bs %u, iv %"PRIu64", enc_on_tx %d\n",
-			      req, req->task, task->block_size, iv, mlx5_task->encrypt_on_tx);
-		rc = spdk_mlx5_crypto_set_attr(&cattr, task->crypto_key->priv, dev->dev_ctx->pd, task->block_size,
-					       iv++, mlx5_task->encrypt_on_tx);
-		if (spdk_unlikely(rc)) {
-			SPDK_ERRLOG("failed to set crypto attr, rc %d\n", rc);
-			mlx5_task->rc = rc;
-			goto err_out;
+		if (mlx5_task->crc_offload) {
+			/* The device writes the block's CRC right after its data, so append an entry
+			 * pointing to the request's CRC to the layout */
+			if (layout != req->dst_sg) {
+				memcpy(req->dst_sg, layout, sizeof(*layout) * req->dst_sg_count);
+				layout = req->dst_sg;
+			}
+			rc = accel_mlx5_fill_crc_sge(req, &req->dst_sg[req->dst_sg_count]);
+			if (spdk_unlikely(rc)) {
+				mlx5_task->rc = rc;
+				goto err_out;
+			}
+			req->dst_sg_count++;
+		}
+		mlx5dv_wr_set_mkey_layout_list(mqpx, req->dst_sg_count, layout);
+		if (mlx5_task->crypto) {
+			SPDK_DEBUGLOG(accel_mlx5, "req %p, task %p crypto_attr: bs %u, iv %"PRIu64
+				      ", enc_on_tx %d\n", req, req->task, mlx5_task->block_size, iv,
+				      mlx5_task->encrypt_on_tx);
+			rc = spdk_mlx5_crypto_set_attr(&cattr, task->crypto_key->priv,
+						       dev->dev_ctx->pd, mlx5_task->block_size, iv++,
+						       mlx5_task->encrypt_on_tx);
+			if (spdk_unlikely(rc)) {
+				SPDK_ERRLOG("failed to set crypto attr, rc %d\n", rc);
+				mlx5_task->rc = rc;
+				goto err_out;
+			}
+			/* The CRC is generated on the memory side, so it has to cover the data as
+			 * it's stored in memory, i.e. after the crypto engine when writing to it */
+			cattr.signature_crypto_order =
+				MLX5DV_SIGNATURE_CRYPTO_ORDER_SIGNATURE_BEFORE_CRYPTO_ON_TX;
+			mlx5dv_wr_set_mkey_crypto(mqpx, &cattr);
+		}
+		if (mlx5_task->crc_offload) {
+			mlx5dv_wr_set_mkey_sig_block(mqpx, &sig_attr);
 		}
-		mlx5dv_wr_set_mkey_crypto(mqpx, &cattr);
 
 		/* Prepare WRITE, use rkey from mkey, remote addr is always 0 - start of the mkey */
 		qpx->wr_flags = IBV_SEND_SIGNALED;
@@ -505,6 +661,59 @@ accel_mlx5_task_continue(struct accel_mlx5_task *task)
 	return accel_mlx5_task_process(task);
 }
 
+static bool
+accel_mlx5_sig_block_size(uint32_t block_size, enum mlx5dv_block_size *bs)
+{
+	uint64_t cap;
+
+	switch (block_size) {
+	case 512:
+		*bs = MLX5DV_BLOCK_SIZE_512;
+		cap = MLX5DV_BLOCK_SIZE_CAP_512;
+		break;
+	case 520:
+		*bs = MLX5DV_BLOCK_SIZE_520;
+		cap = MLX5DV_BLOCK_SIZE_CAP_520;
+		break;
+	case 4048:
+		*bs = MLX5DV_BLOCK_SIZE_4048;
+		cap = MLX5DV_BLOCK_SIZE_CAP_4048;
+		break;
+	case 4096:
+		*bs = MLX5DV_BLOCK_SIZE_4096;
+		cap = MLX5DV_BLOCK_SIZE_CAP_4096;
+		break;
+	case 4160:
+		*bs = MLX5DV_BLOCK_SIZE_4160;
+		cap = MLX5DV_BLOCK_SIZE_CAP_4160;
+		break;
+	default:
+		return false;
+	}
+
+	return (g_accel_mlx5.crc32c_block_size_caps & cap) != 0;
+}
+
+/* Returns the largest signature block size that evenly divides a crc32c's data, or 0 if there's
+ * none */
+static uint32_t
+accel_mlx5_crc32c_block_size(uint64_t nbytes)
+{
+	enum mlx5dv_block_size bs;
+
+	if (nbytes == 0) {
+		return 0;
+	}
+	if (nbytes % 4096 == 0 && accel_mlx5_sig_block_size(4096, &bs)) {
+		return 4096;
+	}
+	if (nbytes % 512 == 0 && accel_mlx5_sig_block_size(512, &bs)) {
+		return 512;
+	}
+
+	return 0;
+}
+
 static inline int
 accel_mlx5_task_init(struct accel_mlx5_task *mlx5_task, struct accel_mlx5_dev *dev)
 {
@@ -512,12 +721,29 @@ accel_mlx5_task_init(struct accel_mlx5_task *mlx5_task, struct accel_mlx5_dev *d
 	size_t src_nbytes = 0, dst_nbytes = 0;
 	uint32_t i;
 
+	mlx5_task->crypto = true;
+	mlx5_task->crc_dst = NULL;
+	mlx5_task->crc_offload = false;
+
 	switch (task->op_code) {
 	case SPDK_ACCEL_OPC_ENCRYPT:
 		mlx5_task->encrypt_on_tx = true;
+		mlx5_task->block_size = task->block_size;
 		break;
 	case SPDK_ACCEL_OPC_DECRYPT:
 		mlx5_task->encrypt_on_tx = false;
+		mlx5_task->block_size = task->block_size;
+		break;
+	case SPDK_ACCEL_OPC_ENCRYPT_CRC32C:
+		mlx5_task->encrypt_on_tx = true;
+		mlx5_task->block_size = task->block_size;
+		mlx5_task->crc_dst = task->fused_crc_dst;
+		mlx5_task->seed = task->fused_seed;
+		break;
+	case SPDK_ACCEL_OPC_CRC32C:
+		mlx5_task->crypto = false;
+		mlx5_task->crc_dst = task->crc_dst;
+		mlx5_task->seed = task->seed;
 		break;
 	default:
 		SPDK_ERRLOG("Unsupported accel opcode %d\n", task->op_code);
@@ -528,23 +754,39 @@ accel_mlx5_task_init(struct accel_mlx5_task *mlx5_task, struct accel_mlx5_dev *d
 		src_nbytes += task->s.iovs[i].iov_len;
 	}
 
-	for (i = 0; i < task->d.iovcnt; i++) {
-		dst_nbytes += task->d.iovs[i].iov_len;
-	}
+	if (!mlx5_task->crypto) {
+		/* crc32c doesn't have a destination, the data is written back in place */
+		mlx5_task->block_size = accel_mlx5_crc32c_block_size(src_nbytes);
+		assert(mlx5_task->block_size != 0);
+	} else {
+		for (i = 0; i < task->d.iovcnt; i++) {
+			dst_nbytes += task->d.iovs[i].iov_len;
+		}
 
-	if (spdk_unlikely(src_nbytes != dst_nbytes)) {
-		return -EINVAL;
+		if (spdk_unlikely(src_nbytes != dst_nbytes)) {
+			return -EINVAL;
+		}
 	}
-	if (spdk_unlikely(src_nbytes % mlx5_task->base.block_size != 0)) {
+	if (spdk_unlikely(src_nbytes % mlx5_task->block_size != 0)) {
 		return -EINVAL;
 	}
 
+	if (mlx5_task->crc_dst != NULL) {
+		mlx5_task->crc_offload = accel_mlx5_sig_block_size(mlx5_task->block_size,
+					 &mlx5_task->sig_block_size);
+		mlx5_task->crc = 0;
+		if (mlx5_task->crc_offload) {
+			mlx5_task->crc_shift = accel_mlx5_crc32c_x8nmodp(mlx5_task->block_size);
+		}
+	}
+
 	mlx5_task->dev = dev;
 	mlx5_task->rc = 0;
 	mlx5_task->num_completed_reqs = 0;
 	mlx5_task->num_submitted_reqs = 0;
 	mlx5_task->cur_req = NULL;
-	mlx5_task->num_reqs = src_nbytes / mlx5_task->base.block_size;
+	mlx5_task->nbytes = src_nbytes;
+	mlx5_task->num_reqs = src_nbytes / mlx5_task->block_size;
 	spdk_iov_sgl_init(&mlx5_task->src, task->s.iovs, task->s.iovcnt, 0);
 	if (task->d.iovcnt == 0 || (task->d.iovcnt == task->s.iovcnt &&
 				    accel_mlx5_compare_iovs(task->d.iovs, task->s.iovs, task->s.iovcnt))) {
@@ -577,9 +819,20 @@ accel_mlx5_submit_tasks(struct spdk_io_channel *_ch, struct spdk_accel_task *tas
 	struct accel_mlx5_dev *dev;
 	int rc;
 
-	if (!g_accel_mlx5.enabled || !task->crypto_key ||
-	    task->crypto_key->module_if != &g_accel_mlx5.module ||
-	    !task->crypto_key->priv) {
+	if (!g_accel_mlx5.enabled) {
+		return -EINVAL;
+	}
+	if (task->op_code == SPDK_ACCEL_OPC_CRC32C) {
+		if (spdk_unlikely(accel_mlx5_crc32c_block_size(task->nbytes) == 0)) {
+			/* Checksum data that can't be split into signature blocks on the CPU */
+			SPDK_DEBUGLOG(accel_mlx5, "Executing crc32c in software\n");
+			*task->crc_dst = spdk_crc32c_iov_update(task->s.iovs, task->s.iovcnt,
+							       ~task->seed);
+			spdk_accel_task_complete(task, 0);
+			return 0;
+		}
+	} else if (!task->crypto_key || task->crypto_key->module_if != &g_accel_mlx5.module ||
+		   !task->crypto_key->priv) {
 		return -EINVAL;
 	}
 	dev = &ch->devs[ch->dev_idx];
@@ -602,6 +855,27 @@ accel_mlx5_submit_tasks(struct spdk_io_channel *_ch, struct spdk_accel_task *tas
 	return accel_mlx5_task_process(mlx5_task);
 }
 
+/* Called in order of completion, appends the CRC of the request's block to the task's CRC */
+static inline int
+accel_mlx5_req_get_crc(struct accel_mlx5_req *req)
+{
+	struct accel_mlx5_task *task = req->task;
+	struct mlx5dv_mkey_err err;
+	int rc;
+
+	/* The signature status of a MKEY has to be checked before it's configured again */
+	rc = mlx5dv_mkey_check(req->mkey, &err);
+	if (spdk_unlikely(rc != 0 || err.err_type != MLX5DV_MKEY_NO_ERR)) {
+		SPDK_ERRLOG("Signature error on req %p, task %p, rc %d, type %d\n", req, task, rc,
+			    err.err_type);
+		return -EIO;
+	}
+
+	task->crc = accel_mlx5_crc32c_multmodp(task->crc_shift, task->crc) ^ from_be32(&req->crc);
+
+	return 0;
+}
+
 static inline int64_t
 accel_mlx5_poll_cq(struct accel_mlx5_dev *dev)
 {
@@ -649,6 +923,13 @@ accel_mlx5_poll_cq(struct accel_mlx5_dev *dev)
 				}
 			}
 
+			if (task->crc_offload && !wc[i].status) {
+				rc = accel_mlx5_req_get_crc(req);
+				if (spdk_unlikely(rc) && !task->rc) {
+					task->rc = rc;
+				}
+			}
+
 			task->num_completed_reqs++;
 			assert(dev->reqs_submitted);
 			dev->reqs_submitted--;
@@ -730,7 +1011,10 @@ accel_mlx5_supports_opcode(enum spdk_accel_opcode opc)
 	switch (opc) {
 	case SPDK_ACCEL_OPC_ENCRYPT:
 	case SPDK_ACCEL_OPC_DECRYPT:
+	case SPDK_ACCEL_OPC_ENCRYPT_CRC32C:
 		return true;
+	case SPDK_ACCEL_OPC_CRC32C:
+		return g_accel_mlx5.crc32c_supported;
 	default:
 		return false;
 	}
@@ -991,7 +1275,8 @@ accel_mlx5_configure_crypto_req(struct spdk_mempool *mp, void *cb_arg, void *_re
 	struct accel_mlx5_req_init_ctx *ctx = cb_arg;
 	struct mlx5dv_mkey_init_attr mkey_attr = {
 		.pd = ctx->pd,
-		.max_entries = ACCEL_MLX5_MAX_SGE, /* This MKEY refers to N base MKEYs/buffers */
+		/* This MKEY refers to N base MKEYs/buffers and to the CRC */
+		.max_entries = ACCEL_MLX5_MAX_SGE + 1,
 		.create_flags = MLX5DV_MKEY_INIT_ATTR_FLAGS_INDIRECT | /* This MKEY refers to another MKEYs */
 		MLX5DV_MKEY_INIT_ATTR_FLAGS_CRYPTO
 	};
@@ -1000,6 +1285,9 @@ accel_mlx5_configure_crypto_req(struct spdk_mempool *mp, void *cb_arg, void *_re
 	if (ctx->rc) {
 		return;
 	}
+	if (ctx->signature) {
+		mkey_attr.create_flags |= MLX5DV_MKEY_INIT_ATTR_FLAGS_BLOCK_SIGNATURE;
+	}
 
 	req->mkey = mlx5dv_create_mkey(&mkey_attr);
 	if (!req->mkey) {
@@ -1016,7 +1304,10 @@ static int
 accel_mlx5_crypto_ctx_mempool_create(struct accel_mlx5_crypto_dev_ctx *crypto_dev_ctx,
 				     size_t num_entries)
 {
-	struct accel_mlx5_req_init_ctx init_ctx = {.pd = crypto_dev_ctx->pd };
+	struct accel_mlx5_req_init_ctx init_ctx = {
+		.pd = crypto_dev_ctx->pd,
+		.signature = g_accel_mlx5.crc32c_supported,
+	};
 	char pool_name[32];
 	int rc;
 
@@ -1043,6 +1334,26 @@ accel_mlx5_crypto_ctx_mempool_create(struct accel_mlx5_crypto_dev_ctx *crypto_de
 	return 0;
 }
 
+/* Returns the signature block sizes for which the device can generate CRC-32C, 0 if none */
+static uint64_t
+accel_mlx5_dev_crc32c_caps(struct ibv_context *dev)
+{
+	struct mlx5dv_context dv_attr = {
+		.comp_mask = MLX5DV_CONTEXT_MASK_SIGNATURE_OFFLOAD,
+	};
+
+	if (mlx5dv_query_device(dev, &dv_attr) != 0 ||
+	    !(dv_attr.comp_mask & MLX5DV_CONTEXT_MASK_SIGNATURE_OFFLOAD)) {
+		return 0;
+	}
+	if (!(dv_attr.sig_caps.block_prot & MLX5DV_SIG_PROT_CAP_CRC) ||
+	    !(dv_attr.sig_caps.crc_type & MLX5DV_SIG_CRC_TYPE_CAP_CRC32C)) {
+		return 0;
+	}
+
+	return dv_attr.sig_caps.block_size;
+}
+
 static int
 accel_mlx5_init(void)
 {
@@ -1061,6 +1372,14 @@ accel_mlx5_init(void)
 		return -ENOTSUP;
 	}
 
+	/* CRC-32C is only offloaded if every device can generate it */
+	g_accel_mlx5.crc32c_block_size_caps = UINT64_MAX;
+	for (i = 0; i < num_devs; i++) {
+		g_accel_mlx5.crc32c_block_size_caps &= accel_mlx5_dev_crc32c_caps(rdma_devs[i]);
+	}
+	g_accel_mlx5.crc32c_supported = (g_accel_mlx5.crc32c_block_size_caps &
+					 MLX5DV_BLOCK_SIZE_CAP_512) != 0;
+
 	g_accel_mlx5.crypto_ctxs = calloc(num_devs, sizeof(*g_accel_mlx5.crypto_ctxs));
 	if (!g_accel_mlx5.crypto_ctxs) {
 		SPDK_ERRLOG("Memory allocation failed\n");
@@ -1086,7 +1405,8 @@ accel_mlx5_init(void)
 		}
 	}
 
-	SPDK_NOTICELOG("Accel framework mlx5 initialized, found %d devices.\n", num_devs);
+	SPDK_NOTICELOG("Accel framework mlx5 initialized, found %d devices, crc32c offload %s.\n",
+		       num_devs, g_accel_mlx5.crc32c_supported ? "enabled" : "disabled");
 	spdk_io_device_register(&g_accel_mlx5, accel_mlx5_create_cb, accel_mlx5_destroy_cb,
 				sizeof(struct accel_mlx5_io_channel), "accel_mlx5");
 
@@ -1175,6 +1495,35 @@ accel_mlx5_crypto_supports_cipher(enum spdk_accel_cipher cipher, size_t key_size
 	}
 }
 
+static bool
+accel_mlx5_can_access_memory_domain(struct spdk_memory_domain *domain)
+{
+	struct spdk_memory_domain_ctx *ctx;
+	struct spdk_memory_domain_rdma_ctx *rdma_ctx;
+	uint32_t i;
+
+	/* Buffers of an RDMA memory domain using the same protection domain as one of our devices
+	 * are local memory registered with it, so they can be translated through our memory maps
+	 * without being bounced. */
+	if (spdk_memory_domain_get_dma_device_type(domain) != SPDK_DMA_DEVICE_TYPE_RDMA) {
+		return false;
+	}
+
+	ctx = spdk_memory_domain_get_context(domain);
+	if (ctx == NULL || ctx->user_ctx == NULL) {
+		return false;
+	}
+
+	rdma_ctx = ctx->user_ctx;
+	for (i = 0; i < g_accel_mlx5.num_crypto_ctxs; i++) {
+		if (g_accel_mlx5.crypto_ctxs[i].pd == rdma_ctx->ibv_pd) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static struct accel_mlx5_module g_accel_mlx5 = {
 	.module = {
 		.module_init		= accel_mlx5_init,
@@ -1188,6 +1537,7 @@ static struct accel_mlx5_module g_accel_mlx5 = {
 		.crypto_key_init	= accel_mlx5_crypto_key_init,
 		.crypto_key_deinit	= accel_mlx5_crypto_key_deinit,
 		.crypto_supports_cipher	= accel_mlx5_crypto_supports_cipher,
+		.can_access_memory_domain = accel_mlx5_can_access_memory_domain,
 	}
 };
 
@@ -27,12 +27,13 @@
 #include <libaio.h>
 #endif
 
+/* Maximum number of iocbs passed to a single io_submit() within a batch */
+#define AIO_BATCH_MAX_IOS 32
+
 struct bdev_aio_io_channel {
 	uint64_t				io_inflight;
 #ifdef __FreeBSD__
 	int					kqfd;
-#else
-	io_context_t				io_ctx;
 #endif
 	struct bdev_aio_group_channel		*group_ch;
 	TAILQ_ENTRY(bdev_aio_io_channel)	link;
@@ -46,6 +47,18 @@ struct bdev_aio_group_channel {
 	struct spdk_interrupt			*intr;
 	struct spdk_poller			*poller;
 	TAILQ_HEAD(, bdev_aio_io_channel)	io_ch_head;
+#ifndef __FreeBSD__
+	/* A single context is shared by all aio bdevs on a thread, so that their iocbs can be
+	 * submitted and reaped together.
+	 */
+	io_context_t				io_ctx;
+	/* iocbs waiting to be submitted with a single io_submit().  In polling mode, these are
+	 * collected from all the bdevs until the next poll.
+	 */
+	struct iocb				*batch[AIO_BATCH_MAX_IOS];
+	int					batch_count;
+	bool					batching;
+#endif
 };
 
 struct bdev_aio_task {
@@ -90,6 +103,8 @@ static void aio_free_disk(struct file_disk *fdisk);
 static TAILQ_HEAD(, file_disk) g_aio_disk_head = TAILQ_HEAD_INITIALIZER(g_aio_disk_head);
 
 #define SPDK_AIO_QUEUE_DEPTH 128
+/* Depth of the context shared by all aio bdevs on a thread */
+#define SPDK_AIO_GROUP_QUEUE_DEPTH 512
 #define MAX_EVENTS_PER_POLL 32
 
 static int
@@ -151,6 +166,47 @@ bdev_aio_close(struct file_disk *disk)
 	return 0;
 }
 
+#ifndef __FreeBSD__
+static void
+bdev_aio_submit_batch(struct bdev_aio_group_channel *group_ch)
+{
+	struct iocb *rejected[AIO_BATCH_MAX_IOS];
+	struct bdev_aio_task *aio_task;
+	struct spdk_bdev_io *bdev_io;
+	int i, rc = 0, submitted = 0, batch_count = group_ch->batch_count;
+
+	while (submitted < batch_count) {
+		rc = io_submit(group_ch->io_ctx, batch_count - submitted,
+			       &group_ch->batch[submitted]);
+		if (rc <= 0) {
+			break;
+		}
+		submitted += rc;
+	}
+
+	/* Completing the rejected iocbs may submit new requests, which start a new batch */
+	memcpy(&rejected[submitted], &group_ch->batch[submitted],
+	       (batch_count - submitted) * sizeof(rejected[0]));
+	group_ch->batch_count = 0;
+
+	/* Complete the rejected iocbs from the last one, so that the bdev layer queues them
+	 * for retry in their submission order.  Only the first one is known to have failed,
+	 * the remaining ones are simply retried.
+	 */
+	for (i = batch_count - 1; i >= submitted; i--) {
+		aio_task = rejected[i]->data;
+		bdev_io = spdk_bdev_io_from_ctx(aio_task);
+		aio_task->ch->io_inflight--;
+		if (i == submitted && rc != -EAGAIN && rc < 0) {
+			SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
+			spdk_bdev_io_complete_aio_status(bdev_io, rc);
+		} else {
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+		}
+	}
+}
+#endif
+
 #ifdef __FreeBSD__
 static int
 bdev_aio_submit_io(enum spdk_bdev_io_type type, struct file_disk *fdisk,
@@ -186,6 +242,7 @@ bdev_aio_submit_io(enum spdk_bdev_io_type type, struct file_disk *fdisk,
 {
 	struct iocb *iocb = &aio_task->iocb;
 	struct bdev_aio_io_channel *aio_ch = spdk_io_channel_get_ctx(ch);
+	struct bdev_aio_group_channel *group_ch = aio_ch->group_ch;
 
 	if (type == SPDK_BDEV_IO_TYPE_READ) {
 		io_prep_preadv(iocb, fdisk->fd, iov, iovcnt, offset);
@@ -193,14 +250,23 @@ bdev_aio_submit_io(enum spdk_bdev_io_type type, struct file_disk *fdisk,
 		io_prep_pwritev(iocb, fdisk->fd, iov, iovcnt, offset);
 	}
 
-	if (aio_ch->group_ch->efd >= 0) {
-		io_set_eventfd(iocb, aio_ch->group_ch->efd);
+	if (group_ch->efd >= 0) {
+		io_set_eventfd(iocb, group_ch->efd);
 	}
 	iocb->data = aio_task;
 	aio_task->len = nbytes;
 	aio_task->ch = aio_ch;
 
-	return io_submit(aio_ch->io_ctx, 1, &iocb);
+	/* In polling mode, the group poller submits the iocbs of all bdevs together */
+	if (group_ch->batching || group_ch->efd < 0) {
+		if (group_ch->batch_count == AIO_BATCH_MAX_IOS) {
+			bdev_aio_submit_batch(group_ch);
+		}
+		group_ch->batch[group_ch->batch_count++] = iocb;
+		return 0;
+	}
+
+	return io_submit(group_ch->io_ctx, 1, &iocb);
 }
 #endif
 
@@ -386,13 +452,13 @@ bdev_user_io_getevents(io_context_t io_ctx, unsigned int max, struct io_event *u
 }
 
 static int
-bdev_aio_io_channel_poll(struct bdev_aio_io_channel *io_ch)
+bdev_aio_group_reap(struct bdev_aio_group_channel *group_ch)
 {
 	int nr, i, res = 0;
 	struct bdev_aio_task *aio_task;
 	struct io_event events[SPDK_AIO_QUEUE_DEPTH];
 
-	nr = bdev_user_io_getevents(io_ch->io_ctx, SPDK_AIO_QUEUE_DEPTH, events);
+	nr = bdev_user_io_getevents(group_ch->io_ctx, SPDK_AIO_QUEUE_DEPTH, events);
 	if (nr < 0) {
 		return 0;
 	}
@@ -426,12 +492,21 @@ static int
 bdev_aio_group_poll(void *arg)
 {
 	struct bdev_aio_group_channel *group_ch = arg;
-	struct bdev_aio_io_channel *io_ch;
 	int nr = 0;
+#ifdef __FreeBSD__
+	struct bdev_aio_io_channel *io_ch;
 
 	TAILQ_FOREACH(io_ch, &group_ch->io_ch_head, link) {
 		nr += bdev_aio_io_channel_poll(io_ch);
 	}
+#else
+	if (group_ch->batch_count > 0) {
+		nr += group_ch->batch_count;
+		bdev_aio_submit_batch(group_ch);
+	}
+
+	nr += bdev_aio_group_reap(group_ch);
+#endif
 
 	return nr > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
@@ -590,6 +665,28 @@ bdev_aio_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io
 	}
 }
 
+#ifndef __FreeBSD__
+static void
+bdev_aio_submit_request_batch(struct spdk_io_channel *ch, struct spdk_bdev_io **bdev_ios,
+			      uint32_t num_ios)
+{
+	struct bdev_aio_io_channel *aio_ch = spdk_io_channel_get_ctx(ch);
+	struct bdev_aio_group_channel *group_ch = aio_ch->group_ch;
+	uint32_t i;
+
+	group_ch->batching = true;
+	for (i = 0; i < num_ios; i++) {
+		bdev_aio_submit_request(ch, bdev_ios[i]);
+	}
+	group_ch->batching = false;
+
+	/* In polling mode, leave the batch to the poller, so that other bdevs can join it */
+	if (group_ch->efd >= 0 && group_ch->batch_count > 0) {
+		bdev_aio_submit_batch(group_ch);
+	}
+}
+#endif
+
 static bool
 bdev_aio_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 {
@@ -624,22 +721,16 @@ bdev_aio_destroy_io(struct bdev_aio_io_channel *ch)
 	close(ch->kqfd);
 }
 #else
+/* The io context is shared by all channels of a thread, see bdev_aio_group_create_cb() */
 static int
 bdev_aio_create_io(struct bdev_aio_io_channel *ch)
 {
-	if (io_setup(SPDK_AIO_QUEUE_DEPTH, &ch->io_ctx) < 0) {
-		SPDK_ERRLOG("Async I/O context setup failure, likely due to exceeding kernel limit.\n");
-		SPDK_ERRLOG("This limit may be increased using 'sysctl -w fs.aio-max-nr'.\n");
-		return -1;
-	}
-
 	return 0;
 }
 
 static void
 bdev_aio_destroy_io(struct bdev_aio_io_channel *ch)
 {
-	io_destroy(ch->io_ctx);
 }
 #endif
 
@@ -724,6 +815,9 @@ bdev_aio_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w
 static const struct spdk_bdev_fn_table aio_fn_table = {
 	.destruct		= bdev_aio_destruct,
 	.submit_request		= bdev_aio_submit_request,
+#ifndef __FreeBSD__
+	.submit_request_batch	= bdev_aio_submit_request_batch,
+#endif
 	.io_type_supported	= bdev_aio_io_type_supported,
 	.get_io_channel		= bdev_aio_get_io_channel,
 	.dump_info_json		= bdev_aio_dump_info_json,
@@ -784,10 +878,21 @@ bdev_aio_group_create_cb(void *io_device, void *ctx_buf)
 	TAILQ_INIT(&ch->io_ch_head);
 	/* Initialize ch->efd to be invalid and unused. */
 	ch->efd = -1;
+#ifndef __FreeBSD__
+	if (io_setup(SPDK_AIO_GROUP_QUEUE_DEPTH, &ch->io_ctx) < 0) {
+		SPDK_ERRLOG("Async I/O context setup failure, likely due to exceeding kernel "
+			    "limit.\n");
+		SPDK_ERRLOG("This limit may be increased using 'sysctl -w fs.aio-max-nr'.\n");
+		return -1;
+	}
+#endif
 	if (spdk_interrupt_mode_is_enabled()) {
 		rc = bdev_aio_register_interrupt(ch);
 		if (rc < 0) {
 			SPDK_ERRLOG("Failed to prepare intr resource to bdev_aio\n");
+#ifndef __FreeBSD__
+			io_destroy(ch->io_ctx);
+#endif
 			return rc;
 		}
 	}
@@ -811,6 +916,10 @@ bdev_aio_group_destroy_cb(void *io_device, void *ctx_buf)
 	if (spdk_interrupt_mode_is_enabled()) {
 		bdev_aio_unregister_interrupt(ch);
 	}
+#ifndef __FreeBSD__
+	assert(ch->batch_count == 0);
+	io_destroy(ch->io_ctx);
+#endif
 }
 
 int
@@ -0,0 +1,1518 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Read cache virtual bdev.  Data read from the base bdev is kept in lines of a fixed size,
+ * allocated from a single hugepage arena shared by all threads.  Lines are evicted according
+ * to the adaptive replacement cache (ARC) policy, which balances recency and frequency, so
+ * that a single sequential scan doesn't flush the frequently read data out of the cache.
+ *
+ * The cache is split into shards, each protected by its own spinlock and managing its own ARC
+ * lists, so that threads reading different lines rarely contend with each other.  Writes are
+ * passed through to the base bdev, invalidating the cached lines they overlap.  Concurrent
+ * misses on the same line issue only a single read to the base bdev; the other readers wait
+ * for it to complete.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "vbdev_cache.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "spdk/bdev_module.h"
+#include "spdk/log.h"
+
+/* This namespace UUID was generated using uuid_generate() method. */
+#define BDEV_CACHE_NAMESPACE_UUID "4c1e0b0d-9a3e-4a2f-b7c5-2f8f3e61d0a9"
+
+/* Maximum number of shards, each one having its own lock and ARC lists */
+#define CACHE_MAX_SHARDS		16
+#define CACHE_MIN_LINES_PER_SHARD	64
+/* Reads spanning more lines than this are passed through to the base bdev */
+#define CACHE_MAX_LINES_PER_IO		8
+/* Entries allocated on top of the ARC directory (resident + ghost lines), used by lines that
+ * were invalidated while still being read from.
+ */
+#define CACHE_ENTRY_SLACK		64
+
+enum cache_list {
+	/* Resident lines accessed once */
+	CACHE_LIST_T1,
+	/* Resident lines accessed at least twice */
+	CACHE_LIST_T2,
+	/* Ghost lines recently evicted from T1 */
+	CACHE_LIST_B1,
+	/* Ghost lines recently evicted from T2 */
+	CACHE_LIST_B2,
+	CACHE_LIST_COUNT,
+	CACHE_LIST_NONE = CACHE_LIST_COUNT,
+};
+
+enum cache_entry_state {
+	CACHE_ENTRY_FREE,
+	/* Data is being read from the base bdev */
+	CACHE_ENTRY_FILLING,
+	CACHE_ENTRY_VALID,
+	/* Only the line's history is kept, its data was evicted */
+	CACHE_ENTRY_GHOST,
+	/* Line was invalidated, but it's still being read from */
+	CACHE_ENTRY_STALE,
+};
+
+struct cache_bdev_io;
+struct cache_shard;
+
+/* Reader waiting for a line to be filled */
+struct cache_waiter {
+	struct cache_bdev_io		*io_ctx;
+	struct spdk_thread_msg		msg;
+	bool				failed;
+	TAILQ_ENTRY(cache_waiter)	link;
+};
+
+struct cache_entry {
+	uint64_t			line;
+	void				*buf;
+	struct cache_shard		*shard;
+	/* Number of readers using the buffer, pinned entries cannot be evicted */
+	uint32_t			refs;
+	uint8_t				state;
+	uint8_t				list;
+	TAILQ_HEAD(, cache_waiter)	waiters;
+	LIST_ENTRY(cache_entry)		hash_link;
+	TAILQ_ENTRY(cache_entry)	lru_link;
+};
+
+struct cache_shard {
+	pthread_spinlock_t		lock;
+	/* Lists are ordered from the most to the least recently used entry */
+	TAILQ_HEAD(cache_entry_list, cache_entry) lists[CACHE_LIST_COUNT];
+	uint32_t			sizes[CACHE_LIST_COUNT];
+	/* Maximum number of resident lines */
+	uint32_t			capacity;
+	/* Adaptive target size of T1 */
+	uint32_t			target;
+	LIST_HEAD(, cache_entry)	*buckets;
+	uint32_t			bucket_mask;
+	struct cache_entry		*entries;
+	TAILQ_HEAD(, cache_entry)	free_entries;
+	void				**free_bufs;
+	uint32_t			num_free_bufs;
+	uint64_t			hits;
+	uint64_t			misses;
+	uint64_t			evictions;
+	uint64_t			invalidations;
+};
+
+struct vbdev_cache {
+	struct spdk_bdev		*base_bdev;
+	struct spdk_bdev_desc		*base_desc;
+	struct spdk_bdev		cache_bdev;
+	struct spdk_thread		*thread;
+	uint64_t			size_mb;
+	uint32_t			line_size_kb;
+	uint32_t			line_size;
+	uint32_t			line_blocks;
+	uint32_t			num_lines;
+	void				*arena;
+	struct cache_shard		*shards;
+	uint32_t			num_shards;
+	TAILQ_ENTRY(vbdev_cache)	link;
+};
+
+struct cache_io_channel {
+	struct spdk_io_channel		*base_ch;
+};
+
+struct cache_bdev_io {
+	struct spdk_io_channel		*ch;
+	struct spdk_bdev_io		*bdev_io;
+	struct spdk_thread		*thread;
+	uint32_t			num_lines;
+	uint32_t			pending;
+	bool				bypass;
+	/* Line whose buffer is lent to a zcopy read */
+	struct cache_entry		*zcopy_entry;
+	struct cache_entry		*entries[CACHE_MAX_LINES_PER_IO];
+	struct cache_waiter		waiters[CACHE_MAX_LINES_PER_IO];
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+};
+
+struct bdev_names {
+	char			*vbdev_name;
+	char			*bdev_name;
+	struct spdk_uuid	uuid;
+	uint64_t		size_mb;
+	uint32_t		line_size_kb;
+	TAILQ_ENTRY(bdev_names)	link;
+};
+
+static TAILQ_HEAD(, bdev_names) g_bdev_names = TAILQ_HEAD_INITIALIZER(g_bdev_names);
+static TAILQ_HEAD(, vbdev_cache) g_cache_nodes = TAILQ_HEAD_INITIALIZER(g_cache_nodes);
+
+static int vbdev_cache_init(void);
+static int vbdev_cache_get_ctx_size(void);
+static void vbdev_cache_examine(struct spdk_bdev *bdev);
+static void vbdev_cache_finish(void);
+static int vbdev_cache_config_json(struct spdk_json_write_ctx *w);
+
+static struct spdk_bdev_module cache_if = {
+	.name = "cache",
+	.module_init = vbdev_cache_init,
+	.get_ctx_size = vbdev_cache_get_ctx_size,
+	.examine_config = vbdev_cache_examine,
+	.module_fini = vbdev_cache_finish,
+	.config_json = vbdev_cache_config_json
+};
+
+SPDK_BDEV_MODULE_REGISTER(cache, &cache_if)
+
+static void vbdev_cache_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io);
+static void cache_read_base(struct vbdev_cache *node, struct spdk_bdev_io *bdev_io);
+
+static inline uint64_t
+cache_hash(uint64_t line)
+{
+	uint64_t hash = line * 0x9e3779b97f4a7c15ULL;
+
+	return hash ^ (hash >> 32);
+}
+
+static inline struct cache_shard *
+cache_get_shard(struct vbdev_cache *node, uint64_t line)
+{
+	return &node->shards[cache_hash(line) & (node->num_shards - 1)];
+}
+
+static inline uint32_t
+cache_get_bucket(struct cache_shard *shard, uint64_t line)
+{
+	return (cache_hash(line) >> 8) & shard->bucket_mask;
+}
+
+static struct cache_entry *
+cache_lookup(struct cache_shard *shard, uint64_t line)
+{
+	struct cache_entry *entry;
+
+	LIST_FOREACH(entry, &shard->buckets[cache_get_bucket(shard, line)], hash_link) {
+		if (entry->line == line) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+cache_list_remove(struct cache_shard *shard, struct cache_entry *entry)
+{
+	if (entry->list != CACHE_LIST_NONE) {
+		TAILQ_REMOVE(&shard->lists[entry->list], entry, lru_link);
+		shard->sizes[entry->list]--;
+		entry->list = CACHE_LIST_NONE;
+	}
+}
+
+/* Move the entry to the MRU position of a given list */
+static void
+cache_list_move(struct cache_shard *shard, struct cache_entry *entry, enum cache_list list)
+{
+	cache_list_remove(shard, entry);
+	TAILQ_INSERT_HEAD(&shard->lists[list], entry, lru_link);
+	shard->sizes[list]++;
+	entry->list = list;
+}
+
+static void
+cache_entry_free(struct cache_shard *shard, struct cache_entry *entry)
+{
+	assert(entry->refs == 0);
+	assert(TAILQ_EMPTY(&entry->waiters));
+
+	if (entry->buf != NULL) {
+		shard->free_bufs[shard->num_free_bufs++] = entry->buf;
+		entry->buf = NULL;
+	}
+
+	entry->state = CACHE_ENTRY_FREE;
+	TAILQ_INSERT_HEAD(&shard->free_entries, entry, lru_link);
+}
+
+/* Forget the least recently used ghost line of a given list */
+static bool
+cache_drop_ghost(struct cache_shard *shard, enum cache_list list)
+{
+	struct cache_entry *entry;
+
+	entry = TAILQ_LAST(&shard->lists[list], cache_entry_list);
+	if (entry == NULL) {
+		return false;
+	}
+
+	assert(entry->state == CACHE_ENTRY_GHOST);
+	cache_list_remove(shard, entry);
+	LIST_REMOVE(entry, hash_link);
+	cache_entry_free(shard, entry);
+
+	return true;
+}
+
+/* Keep the ARC directory bounded: |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c */
+static void
+cache_trim_ghosts(struct cache_shard *shard)
+{
+	uint32_t *sizes = shard->sizes;
+
+	while (sizes[CACHE_LIST_T1] + sizes[CACHE_LIST_B1] > shard->capacity) {
+		if (!cache_drop_ghost(shard, CACHE_LIST_B1)) {
+			break;
+		}
+	}
+
+	while (sizes[CACHE_LIST_T1] + sizes[CACHE_LIST_T2] + sizes[CACHE_LIST_B1] +
+	       sizes[CACHE_LIST_B2] > 2 * shard->capacity) {
+		if (!cache_drop_ghost(shard, CACHE_LIST_B2) &&
+		    !cache_drop_ghost(shard, CACHE_LIST_B1)) {
+			break;
+		}
+	}
+}
+
+static struct cache_entry *
+cache_lru_unpinned(struct cache_shard *shard, enum cache_list list)
+{
+	struct cache_entry *entry;
+
+	TAILQ_FOREACH_REVERSE(entry, &shard->lists[list], cache_entry_list, lru_link) {
+		if (entry->refs == 0) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* ARC's REPLACE: evict a resident line to its ghost list and return its buffer */
+static void *
+cache_replace(struct cache_shard *shard, bool ghost_hit_b2)
+{
+	struct cache_entry *entry = NULL;
+	uint32_t t1_size = shard->sizes[CACHE_LIST_T1];
+	void *buf;
+
+	if (t1_size > 0 &&
+	    (t1_size > shard->target || (ghost_hit_b2 && t1_size == shard->target))) {
+		entry = cache_lru_unpinned(shard, CACHE_LIST_T1);
+	}
+	if (entry == NULL) {
+		entry = cache_lru_unpinned(shard, CACHE_LIST_T2);
+	}
+	if (entry == NULL) {
+		entry = cache_lru_unpinned(shard, CACHE_LIST_T1);
+	}
+	if (entry == NULL) {
+		/* Every resident line is being read from */
+		return NULL;
+	}
+
+	assert(entry->state == CACHE_ENTRY_VALID);
+	buf = entry->buf;
+	entry->buf = NULL;
+	entry->state = CACHE_ENTRY_GHOST;
+	cache_list_move(shard, entry, entry->list == CACHE_LIST_T1 ? CACHE_LIST_B1 : CACHE_LIST_B2);
+	shard->evictions++;
+
+	return buf;
+}
+
+static void *
+cache_get_buf(struct cache_shard *shard, bool ghost_hit_b2)
+{
+	if (shard->num_free_bufs > 0) {
+		return shard->free_bufs[--shard->num_free_bufs];
+	}
+
+	return cache_replace(shard, ghost_hit_b2);
+}
+
+/* Make a line that's not resident in the cache resident, adapting the target size of T1 if
+ * it's found in one of the ghost lists.
+ */
+static struct cache_entry *
+cache_miss(struct cache_shard *shard, uint64_t line, struct cache_entry *ghost)
+{
+	struct cache_entry *entry;
+	uint32_t *sizes = shard->sizes;
+	uint32_t delta;
+	void *buf;
+
+	if (ghost != NULL) {
+		if (ghost->list == CACHE_LIST_B1) {
+			delta = spdk_max(sizes[CACHE_LIST_B2] / sizes[CACHE_LIST_B1], 1);
+			shard->target = spdk_min(shard->target + delta, shard->capacity);
+		} else {
+			delta = spdk_max(sizes[CACHE_LIST_B1] / sizes[CACHE_LIST_B2], 1);
+			shard->target -= spdk_min(delta, shard->target);
+		}
+
+		buf = cache_get_buf(shard, ghost->list == CACHE_LIST_B2);
+		if (buf == NULL) {
+			return NULL;
+		}
+
+		ghost->buf = buf;
+		cache_list_move(shard, ghost, CACHE_LIST_T2);
+		cache_trim_ghosts(shard);
+
+		return ghost;
+	}
+
+	buf = cache_get_buf(shard, false);
+	if (buf == NULL) {
+		return NULL;
+	}
+
+	entry = TAILQ_FIRST(&shard->free_entries);
+	if (entry == NULL) {
+		if (cache_drop_ghost(shard, CACHE_LIST_B1) ||
+		    cache_drop_ghost(shard, CACHE_LIST_B2)) {
+			entry = TAILQ_FIRST(&shard->free_entries);
+		}
+		if (entry == NULL) {
+			shard->free_bufs[shard->num_free_bufs++] = buf;
+			return NULL;
+		}
+	}
+
+	TAILQ_REMOVE(&shard->free_entries, entry, lru_link);
+	entry->line = line;
+	entry->buf = buf;
+	entry->list = CACHE_LIST_NONE;
+	LIST_INSERT_HEAD(&shard->buckets[cache_get_bucket(shard, line)], entry, hash_link);
+	cache_list_move(shard, entry, CACHE_LIST_T1);
+	cache_trim_ghosts(shard);
+
+	return entry;
+}
+
+/* Remove a resident line from the cache.  Its buffer is released once it's no longer read. */
+static void
+cache_invalidate_entry(struct cache_shard *shard, struct cache_entry *entry)
+{
+	if (entry->state != CACHE_ENTRY_VALID && entry->state != CACHE_ENTRY_FILLING) {
+		return;
+	}
+
+	LIST_REMOVE(entry, hash_link);
+	cache_list_remove(shard, entry);
+	entry->state = CACHE_ENTRY_STALE;
+	shard->invalidations++;
+
+	if (entry->refs == 0) {
+		cache_entry_free(shard, entry);
+	}
+}
+
+static void
+cache_invalidate(struct vbdev_cache *node, uint64_t offset_blocks, uint64_t num_blocks)
+{
+	struct cache_shard *shard;
+	struct cache_entry *entry, *tmp;
+	uint64_t first, last, line;
+	uint32_t i;
+
+	if (num_blocks == 0) {
+		return;
+	}
+
+	first = offset_blocks / node->line_blocks;
+	last = (offset_blocks + num_blocks - 1) / node->line_blocks;
+
+	if (last - first < node->num_lines) {
+		for (line = first; line <= last; line++) {
+			shard = cache_get_shard(node, line);
+			pthread_spin_lock(&shard->lock);
+			entry = cache_lookup(shard, line);
+			if (entry != NULL) {
+				cache_invalidate_entry(shard, entry);
+			}
+			pthread_spin_unlock(&shard->lock);
+		}
+		return;
+	}
+
+	/* The range is larger than the cache, so it's cheaper to go through the resident lines */
+	for (i = 0; i < node->num_shards; i++) {
+		shard = &node->shards[i];
+		pthread_spin_lock(&shard->lock);
+		TAILQ_FOREACH_SAFE(entry, &shard->lists[CACHE_LIST_T1], lru_link, tmp) {
+			if (entry->line >= first && entry->line <= last) {
+				cache_invalidate_entry(shard, entry);
+			}
+		}
+		TAILQ_FOREACH_SAFE(entry, &shard->lists[CACHE_LIST_T2], lru_link, tmp) {
+			if (entry->line >= first && entry->line <= last) {
+				cache_invalidate_entry(shard, entry);
+			}
+		}
+		pthread_spin_unlock(&shard->lock);
+	}
+}
+
+/* Find a line in the cache and pin it.  If it isn't resident, it's inserted into the cache and
+ * needs to be filled by the caller.  If it's not valid yet, the waiter is queued on it.
+ */
+static struct cache_entry *
+cache_get_line(struct vbdev_cache *node, uint64_t line, struct cache_waiter *waiter,
+	       bool *wait, bool *fill)
+{
+	struct cache_shard *shard = cache_get_shard(node, line);
+	struct cache_entry *entry;
+
+	*wait = false;
+	*fill = false;
+
+	pthread_spin_lock(&shard->lock);
+	entry = cache_lookup(shard, line);
+	if (entry != NULL && entry->state != CACHE_ENTRY_GHOST) {
+		shard->hits++;
+		cache_list_move(shard, entry, CACHE_LIST_T2);
+	} else {
+		shard->misses++;
+		entry = cache_miss(shard, line, entry);
+		if (entry != NULL) {
+			entry->state = CACHE_ENTRY_FILLING;
+			*fill = true;
+		}
+	}
+
+	if (entry != NULL) {
+		entry->refs++;
+		if (entry->state == CACHE_ENTRY_FILLING) {
+			TAILQ_INSERT_TAIL(&entry->waiters, waiter, link);
+			*wait = true;
+		}
+	}
+	pthread_spin_unlock(&shard->lock);
+
+	return entry;
+}
+
+/* Pin a line, but only if it's valid, so that its buffer can be lent to the caller */
+static struct cache_entry *
+cache_lend_line(struct vbdev_cache *node, uint64_t line)
+{
+	struct cache_shard *shard = cache_get_shard(node, line);
+	struct cache_entry *entry;
+
+	pthread_spin_lock(&shard->lock);
+	entry = cache_lookup(shard, line);
+	if (entry != NULL && entry->state == CACHE_ENTRY_VALID) {
+		shard->hits++;
+		cache_list_move(shard, entry, CACHE_LIST_T2);
+		entry->refs++;
+	} else {
+		entry = NULL;
+	}
+	pthread_spin_unlock(&shard->lock);
+
+	return entry;
+}
+
+static void
+cache_put_line(struct cache_entry *entry)
+{
+	struct cache_shard *shard = entry->shard;
+
+	pthread_spin_lock(&shard->lock);
+	assert(entry->refs > 0);
+	if (--entry->refs == 0 && entry->state == CACHE_ENTRY_STALE) {
+		cache_entry_free(shard, entry);
+	}
+	pthread_spin_unlock(&shard->lock);
+}
+
+static void
+_cache_complete_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *orig_io = cb_arg;
+	int status = success ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED;
+
+	spdk_bdev_io_complete(orig_io, status);
+	spdk_bdev_free_io(bdev_io);
+}
+
+/* Writes invalidate the lines they overlap both when they're submitted and when they complete,
+ * so that a line filled while the write was in progress isn't left in the cache.
+ */
+static void
+_cache_complete_write(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *orig_io = cb_arg;
+	struct vbdev_cache *node = SPDK_CONTAINEROF(orig_io->bdev, struct vbdev_cache, cache_bdev);
+
+	cache_invalidate(node, orig_io->u.bdev.offset_blocks, orig_io->u.bdev.num_blocks);
+	_cache_complete_io(bdev_io, success, cb_arg);
+}
+
+static void
+vbdev_cache_resubmit_io(void *arg)
+{
+	struct spdk_bdev_io *bdev_io = (struct spdk_bdev_io *)arg;
+	struct cache_bdev_io *io_ctx = (struct cache_bdev_io *)bdev_io->driver_ctx;
+	struct vbdev_cache *node = SPDK_CONTAINEROF(bdev_io->bdev, struct vbdev_cache, cache_bdev);
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_ZCOPY && bdev_io->u.bdev.zcopy.start) {
+		/* The buffer is already there, only the read from the base bdev is retried */
+		cache_read_base(node, bdev_io);
+		return;
+	}
+
+	vbdev_cache_submit_request(io_ctx->ch, bdev_io);
+}
+
+static void
+vbdev_cache_queue_io(struct spdk_bdev_io *bdev_io)
+{
+	struct cache_bdev_io *io_ctx = (struct cache_bdev_io *)bdev_io->driver_ctx;
+	struct cache_io_channel *cache_ch = spdk_io_channel_get_ctx(io_ctx->ch);
+	int rc;
+
+	io_ctx->bdev_io_wait.bdev = bdev_io->bdev;
+	io_ctx->bdev_io_wait.cb_fn = vbdev_cache_resubmit_io;
+	io_ctx->bdev_io_wait.cb_arg = bdev_io;
+
+	rc = spdk_bdev_queue_io_wait(bdev_io->bdev, cache_ch->base_ch, &io_ctx->bdev_io_wait);
+	if (rc != 0) {
+		SPDK_ERRLOG("Queue io failed in vbdev_cache_queue_io, rc=%d.\n", rc);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+cache_read_base(struct vbdev_cache *node, struct spdk_bdev_io *bdev_io)
+{
+	struct cache_bdev_io *io_ctx = (struct cache_bdev_io *)bdev_io->driver_ctx;
+	struct cache_io_channel *cache_ch = spdk_io_channel_get_ctx(io_ctx->ch);
+	int rc;
+
+	rc = spdk_bdev_readv_blocks(node->base_desc, cache_ch->base_ch, bdev_io->u.bdev.iovs,
+				    bdev_io->u.bdev.iovcnt, bdev_io->u.bdev.offset_blocks,
+				    bdev_io->u.bdev.num_blocks, _cache_complete_io, bdev_io);
+	if (rc == -ENOMEM) {
+		SPDK_ERRLOG("No memory, start to queue io for cache.\n");
+		vbdev_cache_queue_io(bdev_io);
+	} else if (rc != 0) {
+		SPDK_ERRLOG("ERROR on bdev_io submission!\n");
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+/* Called once all the lines of a read are either valid or failed to be filled */
+static void
+cache_read_done(struct cache_bdev_io *io_ctx)
+{
+	struct spdk_bdev_io *bdev_io = io_ctx->bdev_io;
+	struct vbdev_cache *node = SPDK_CONTAINEROF(bdev_io->bdev, struct vbdev_cache, cache_bdev);
+	uint64_t offset = bdev_io->u.bdev.offset_blocks;
+	uint64_t end = offset + bdev_io->u.bdev.num_blocks;
+	uint64_t line_offset, start, stop;
+	struct spdk_iov_xfer ix;
+	struct cache_entry *entry;
+	uint32_t i;
+
+	if (io_ctx->bypass) {
+		for (i = 0; i < io_ctx->num_lines; i++) {
+			if (io_ctx->entries[i] != NULL) {
+				cache_put_line(io_ctx->entries[i]);
+			}
+		}
+		cache_read_base(node, bdev_io);
+		return;
+	}
+
+	spdk_iov_xfer_init(&ix, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt);
+	for (i = 0; i < io_ctx->num_lines; i++) {
+		entry = io_ctx->entries[i];
+		line_offset = entry->line * node->line_blocks;
+		start = spdk_max(offset, line_offset);
+		stop = spdk_min(end, line_offset + node->line_blocks);
+		spdk_iov_xfer_from_buf(&ix, (char *)entry->buf + (start - line_offset) *
+				       node->cache_bdev.blocklen,
+				       (stop - start) * node->cache_bdev.blocklen);
+		cache_put_line(entry);
+	}
+
+	spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+cache_read_put_pending(struct cache_bdev_io *io_ctx)
+{
+	assert(io_ctx->pending > 0);
+	if (--io_ctx->pending == 0) {
+		cache_read_done(io_ctx);
+	}
+}
+
+static void
+cache_waiter_done(void *ctx)
+{
+	struct cache_waiter *waiter = ctx;
+
+	if (waiter->failed) {
+		waiter->io_ctx->bypass = true;
+	}
+	cache_read_put_pending(waiter->io_ctx);
+}
+
+static void
+cache_fill_complete(struct cache_entry *entry, bool success)
+{
+	struct cache_shard *shard = entry->shard;
+	TAILQ_HEAD(, cache_waiter) waiters = TAILQ_HEAD_INITIALIZER(waiters);
+	struct cache_waiter *waiter;
+	int rc;
+
+	pthread_spin_lock(&shard->lock);
+	if (entry->state == CACHE_ENTRY_FILLING) {
+		if (success) {
+			entry->state = CACHE_ENTRY_VALID;
+		} else {
+			cache_invalidate_entry(shard, entry);
+		}
+	}
+	TAILQ_SWAP(&waiters, &entry->waiters, cache_waiter, link);
+	pthread_spin_unlock(&shard->lock);
+
+	/* Readers are always resumed on their own threads, also the one that filled the line */
+	while ((waiter = TAILQ_FIRST(&waiters)) != NULL) {
+		TAILQ_REMOVE(&waiters, waiter, link);
+		waiter->failed = !success;
+		rc = spdk_thread_send_msg_embedded(waiter->io_ctx->thread, &waiter->msg,
+						   cache_waiter_done, waiter);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to resume a read waiting for a cache line\n");
+			assert(false);
+		}
+	}
+}
+
+static void
+cache_fill_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	spdk_bdev_free_io(bdev_io);
+	cache_fill_complete(cb_arg, success);
+}
+
+static void
+cache_fill_line(struct vbdev_cache *node, struct cache_io_channel *cache_ch,
+		struct cache_entry *entry)
+{
+	uint64_t offset_blocks = entry->line * node->line_blocks;
+	uint64_t num_blocks;
+	int rc;
+
+	num_blocks = spdk_min(node->line_blocks, node->cache_bdev.blockcnt - offset_blocks);
+	rc = spdk_bdev_read_blocks(node->base_desc, cache_ch->base_ch, entry->buf, offset_blocks,
+				   num_blocks, cache_fill_done, entry);
+	if (rc != 0) {
+		/* The readers will retry on their own, directly from the base bdev */
+		cache_fill_complete(entry, false);
+	}
+}
+
+static void
+cache_read(struct vbdev_cache *node, struct cache_io_channel *cache_ch,
+	   struct spdk_bdev_io *bdev_io)
+{
+	struct cache_bdev_io *io_ctx = (struct cache_bdev_io *)bdev_io->driver_ctx;
+	struct cache_entry *fill[CACHE_MAX_LINES_PER_IO];
+	uint64_t first, last;
+	uint32_t i, num_fill = 0;
+	bool wait, needs_fill;
+
+	first = bdev_io->u.bdev.offset_blocks / node->line_blocks;
+	last = (bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks - 1) / node->line_blocks;
+	if (last - first >= CACHE_MAX_LINES_PER_IO) {
+		cache_read_base(node, bdev_io);
+		return;
+	}
+
+	io_ctx->bdev_io = bdev_io;
+	io_ctx->thread = spdk_get_thread();
+	io_ctx->num_lines = last - first + 1;
+	io_ctx->bypass = false;
+	/* Hold a reference, so that the read isn't completed before all lines are looked up */
+	io_ctx->pending = 1;
+
+	for (i = 0; i < io_ctx->num_lines; i++) {
+		io_ctx->waiters[i].io_ctx = io_ctx;
+		io_ctx->entries[i] = cache_get_line(node, first + i, &io_ctx->waiters[i],
+						    &wait, &needs_fill);
+		if (io_ctx->entries[i] == NULL) {
+			/* No line could be evicted, read the data directly */
+			io_ctx->bypass = true;
+			continue;
+		}
+		if (wait) {
+			io_ctx->pending++;
+		}
+		if (needs_fill) {
+			fill[num_fill++] = io_ctx->entries[i];
+		}
+	}
+
+	for (i = 0; i < num_fill; i++) {
+		cache_fill_line(node, cache_ch, fill[i]);
+	}
+
+	cache_read_put_pending(io_ctx);
+}
+
+static void
+cache_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io, bool success)
+{
+	struct vbdev_cache *node = SPDK_CONTAINEROF(bdev_io->bdev, struct vbdev_cache, cache_bdev);
+
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	cache_read(node, spdk_io_channel_get_ctx(ch), bdev_io);
+}
+
+static void
+cache_zcopy_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io, bool success)
+{
+	struct vbdev_cache *node = SPDK_CONTAINEROF(bdev_io->bdev, struct vbdev_cache, cache_bdev);
+
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (bdev_io->u.bdev.zcopy.populate) {
+		cache_read(node, spdk_io_channel_get_ctx(ch), bdev_io);
+	} else {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+}
+
+/* Reads contained in a single resident line get the line's buffer, which stays pinned until
+ * the zcopy ends.  Other reads and writes use a regular data buffer.
+ */
+static void
+cache_zcopy_start(struct vbdev_cache *node, struct spdk_bdev_io *bdev_io)
+{
+	struct cache_bdev_io *io_ctx = (struct cache_bdev_io *)bdev_io->driver_ctx;
+	uint64_t offset = bdev_io->u.bdev.offset_blocks;
+	uint64_t num_blocks = bdev_io->u.bdev.num_blocks;
+	uint64_t line = offset / node->line_blocks;
+	uint32_t blocklen = node->cache_bdev.blocklen;
+
+	/* The caller's iovec only describes where to put the buffer, it doesn't point to one */
+	if (bdev_io->u.bdev.iovs == NULL) {
+		bdev_io->u.bdev.iovs = &bdev_io->iov;
+	}
+	bdev_io->u.bdev.iovs[0].iov_base = NULL;
+	bdev_io->u.bdev.iovs[0].iov_len = 0;
+	bdev_io->u.bdev.iovcnt = 1;
+
+	io_ctx->zcopy_entry = NULL;
+	if (bdev_io->u.bdev.zcopy.populate &&
+	    (offset + num_blocks - 1) / node->line_blocks == line) {
+		io_ctx->zcopy_entry = cache_lend_line(node, line);
+	}
+
+	if (io_ctx->zcopy_entry != NULL) {
+		spdk_bdev_io_set_buf(bdev_io, (char *)io_ctx->zcopy_entry->buf +
+				     (offset - line * node->line_blocks) * blocklen,
+				     num_blocks * blocklen);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		return;
+	}
+
+	spdk_bdev_io_get_buf(bdev_io, cache_zcopy_get_buf_cb, num_blocks * blocklen);
+}
+
+static void
+cache_zcopy_release(struct cache_bdev_io *io_ctx)
+{
+	if (io_ctx->zcopy_entry != NULL) {
+		cache_put_line(io_ctx->zcopy_entry);
+		io_ctx->zcopy_entry = NULL;
+	}
+}
+
+static void
+_cache_complete_zcopy_commit(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *orig_io = cb_arg;
+
+	cache_zcopy_release((struct cache_bdev_io *)orig_io->driver_ctx);
+	_cache_complete_write(bdev_io, success, cb_arg);
+}
+
+static int
+cache_zcopy_end(struct vbdev_cache *node, struct cache_io_channel *cache_ch,
+		struct spdk_bdev_io *bdev_io)
+{
+	struct cache_bdev_io *io_ctx = (struct cache_bdev_io *)bdev_io->driver_ctx;
+
+	if (!bdev_io->u.bdev.zcopy.commit) {
+		cache_zcopy_release(io_ctx);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		return 0;
+	}
+
+	/* A lent line is only released once the data is written, as it's the source buffer */
+	cache_invalidate(node, bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks);
+	return spdk_bdev_writev_blocks(node->base_desc, cache_ch->base_ch, bdev_io->u.bdev.iovs,
+				       bdev_io->u.bdev.iovcnt, bdev_io->u.bdev.offset_blocks,
+				       bdev_io->u.bdev.num_blocks, _cache_complete_zcopy_commit,
+				       bdev_io);
+}
+
+static void
+vbdev_cache_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct vbdev_cache *node = SPDK_CONTAINEROF(bdev_io->bdev, struct vbdev_cache, cache_bdev);
+	struct cache_io_channel *cache_ch = spdk_io_channel_get_ctx(ch);
+	struct cache_bdev_io *io_ctx = (struct cache_bdev_io *)bdev_io->driver_ctx;
+	int rc = 0;
+
+	io_ctx->ch = ch;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		spdk_bdev_io_get_buf(bdev_io, cache_read_get_buf_cb,
+				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		cache_invalidate(node, bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks);
+		rc = spdk_bdev_writev_blocks(node->base_desc, cache_ch->base_ch,
+					     bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					     bdev_io->u.bdev.offset_blocks,
+					     bdev_io->u.bdev.num_blocks, _cache_complete_write,
+					     bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		cache_invalidate(node, bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks);
+		rc = spdk_bdev_write_zeroes_blocks(node->base_desc, cache_ch->base_ch,
+						   bdev_io->u.bdev.offset_blocks,
+						   bdev_io->u.bdev.num_blocks,
+						   _cache_complete_write, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		cache_invalidate(node, bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks);
+		rc = spdk_bdev_unmap_blocks(node->base_desc, cache_ch->base_ch,
+					    bdev_io->u.bdev.offset_blocks,
+					    bdev_io->u.bdev.num_blocks,
+					    _cache_complete_write, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		rc = spdk_bdev_flush_blocks(node->base_desc, cache_ch->base_ch,
+					    bdev_io->u.bdev.offset_blocks,
+					    bdev_io->u.bdev.num_blocks,
+					    _cache_complete_io, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_RESET:
+		rc = spdk_bdev_reset(node->base_desc, cache_ch->base_ch,
+				     _cache_complete_io, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		if (bdev_io->u.bdev.zcopy.start) {
+			cache_zcopy_start(node, bdev_io);
+		} else {
+			rc = cache_zcopy_end(node, cache_ch, bdev_io);
+		}
+		break;
+	default:
+		SPDK_ERRLOG("cache: unknown I/O type %d\n", bdev_io->type);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (rc == -ENOMEM) {
+		SPDK_ERRLOG("No memory, start to queue io for cache.\n");
+		vbdev_cache_queue_io(bdev_io);
+	} else if (rc != 0) {
+		SPDK_ERRLOG("ERROR on bdev_io submission!\n");
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static bool
+vbdev_cache_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	struct vbdev_cache *node = (struct vbdev_cache *)ctx;
+
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_RESET:
+		return spdk_bdev_io_type_supported(node->base_bdev, io_type);
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		/* Emulated on top of the cache lines and regular reads and writes */
+		return spdk_bdev_io_type_supported(node->base_bdev, SPDK_BDEV_IO_TYPE_WRITE);
+	default:
+		return false;
+	}
+}
+
+static struct spdk_io_channel *
+vbdev_cache_get_io_channel(void *ctx)
+{
+	return spdk_get_io_channel(ctx);
+}
+
+static int
+vbdev_cache_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct vbdev_cache *node = (struct vbdev_cache *)ctx;
+	struct cache_shard *shard;
+	uint64_t hits = 0, misses = 0, evictions = 0, invalidations = 0;
+	uint64_t resident = 0, ghost = 0;
+	uint32_t i;
+
+	for (i = 0; i < node->num_shards; i++) {
+		shard = &node->shards[i];
+		pthread_spin_lock(&shard->lock);
+		hits += shard->hits;
+		misses += shard->misses;
+		evictions += shard->evictions;
+		invalidations += shard->invalidations;
+		resident += shard->sizes[CACHE_LIST_T1] + shard->sizes[CACHE_LIST_T2];
+		ghost += shard->sizes[CACHE_LIST_B1] + shard->sizes[CACHE_LIST_B2];
+		pthread_spin_unlock(&shard->lock);
+	}
+
+	spdk_json_write_name(w, "cache");
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&node->cache_bdev));
+	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(node->base_bdev));
+	spdk_json_write_named_uint64(w, "size_mb", node->size_mb);
+	spdk_json_write_named_uint32(w, "line_size_kb", node->line_size_kb);
+	spdk_json_write_named_uint32(w, "num_lines", node->num_lines);
+	spdk_json_write_named_uint32(w, "num_shards", node->num_shards);
+	spdk_json_write_named_uint64(w, "resident_lines", resident);
+	spdk_json_write_named_uint64(w, "ghost_lines", ghost);
+	spdk_json_write_named_uint64(w, "hits", hits);
+	spdk_json_write_named_uint64(w, "misses", misses);
+	spdk_json_write_named_uint64(w, "evictions", evictions);
+	spdk_json_write_named_uint64(w, "invalidations", invalidations);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+static int
+vbdev_cache_config_json(struct spdk_json_write_ctx *w)
+{
+	struct vbdev_cache *node;
+	char uuid_str[SPDK_UUID_STRING_LEN];
+
+	TAILQ_FOREACH(node, &g_cache_nodes, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_cache_create");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "base_bdev_name",
+					     spdk_bdev_get_name(node->base_bdev));
+		spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&node->cache_bdev));
+		spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &node->cache_bdev.uuid);
+		spdk_json_write_named_string(w, "uuid", uuid_str);
+		spdk_json_write_named_uint64(w, "size_mb", node->size_mb);
+		spdk_json_write_named_uint32(w, "line_size_kb", node->line_size_kb);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+	return 0;
+}
+
+static int
+cache_bdev_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	struct cache_io_channel *cache_ch = ctx_buf;
+	struct vbdev_cache *node = io_device;
+
+	cache_ch->base_ch = spdk_bdev_get_io_channel(node->base_desc);
+	if (cache_ch->base_ch == NULL) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+cache_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct cache_io_channel *cache_ch = ctx_buf;
+
+	spdk_put_io_channel(cache_ch->base_ch);
+}
+
+static void
+vbdev_cache_free_shards(struct vbdev_cache *node)
+{
+	struct cache_shard *shard;
+	uint32_t i;
+
+	if (node->shards != NULL) {
+		for (i = 0; i < node->num_shards; i++) {
+			shard = &node->shards[i];
+			pthread_spin_destroy(&shard->lock);
+			free(shard->buckets);
+			free(shard->entries);
+			free(shard->free_bufs);
+		}
+		free(node->shards);
+	}
+
+	spdk_free(node->arena);
+}
+
+/* Carve the arena into lines and distribute them evenly across the shards */
+static int
+vbdev_cache_alloc_shards(struct vbdev_cache *node)
+{
+	struct cache_shard *shard;
+	uint32_t i, j, num_entries, num_buckets, lines_per_shard;
+
+	node->num_shards = CACHE_MAX_SHARDS;
+	while (node->num_shards > 1 &&
+	       node->num_lines / node->num_shards < CACHE_MIN_LINES_PER_SHARD) {
+		node->num_shards /= 2;
+	}
+	lines_per_shard = node->num_lines / node->num_shards;
+	node->num_lines = lines_per_shard * node->num_shards;
+
+	node->arena = spdk_zmalloc((uint64_t)node->num_lines * node->line_size, node->line_size,
+				   NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (node->arena == NULL) {
+		SPDK_ERRLOG("could not allocate %" PRIu64 "MiB of cache memory\n", node->size_mb);
+		return -ENOMEM;
+	}
+
+	node->shards = calloc(node->num_shards, sizeof(*node->shards));
+	if (node->shards == NULL) {
+		return -ENOMEM;
+	}
+
+	num_entries = lines_per_shard * 2 + CACHE_ENTRY_SLACK;
+	num_buckets = spdk_align32pow2(lines_per_shard * 2);
+
+	for (i = 0; i < node->num_shards; i++) {
+		shard = &node->shards[i];
+		pthread_spin_init(&shard->lock, PTHREAD_PROCESS_PRIVATE);
+		for (j = 0; j < CACHE_LIST_COUNT; j++) {
+			TAILQ_INIT(&shard->lists[j]);
+		}
+		TAILQ_INIT(&shard->free_entries);
+		shard->capacity = lines_per_shard;
+		shard->bucket_mask = num_buckets - 1;
+
+		shard->buckets = calloc(num_buckets, sizeof(*shard->buckets));
+		shard->entries = calloc(num_entries, sizeof(*shard->entries));
+		shard->free_bufs = calloc(lines_per_shard, sizeof(*shard->free_bufs));
+		if (shard->buckets == NULL || shard->entries == NULL || shard->free_bufs == NULL) {
+			/* Make sure all locks are initialized before freeing the shards */
+			node->num_shards = i + 1;
+			return -ENOMEM;
+		}
+
+		for (j = 0; j < num_entries; j++) {
+			shard->entries[j].shard = shard;
+			shard->entries[j].list = CACHE_LIST_NONE;
+			TAILQ_INIT(&shard->entries[j].waiters);
+			TAILQ_INSERT_TAIL(&shard->free_entries, &shard->entries[j], lru_link);
+		}
+
+		for (j = 0; j < lines_per_shard; j++) {
+			shard->free_bufs[j] = (char *)node->arena +
+					      ((uint64_t)i * lines_per_shard + j) * node->line_size;
+		}
+		shard->num_free_bufs = lines_per_shard;
+	}
+
+	return 0;
+}
+
+static void
+vbdev_cache_free(struct vbdev_cache *node)
+{
+	vbdev_cache_free_shards(node);
+	free(node->cache_bdev.name);
+	free(node);
+}
+
+static void
+_device_unregister_cb(void *io_device)
+{
+	vbdev_cache_free(io_device);
+}
+
+static void
+_vbdev_cache_destruct(void *ctx)
+{
+	struct spdk_bdev_desc *desc = ctx;
+
+	spdk_bdev_close(desc);
+}
+
+static int
+vbdev_cache_destruct(void *ctx)
+{
+	struct vbdev_cache *node = (struct vbdev_cache *)ctx;
+
+	TAILQ_REMOVE(&g_cache_nodes, node, link);
+
+	spdk_bdev_module_release_bdev(node->base_bdev);
+
+	/* Close the underlying bdev on its same opened thread. */
+	if (node->thread && node->thread != spdk_get_thread()) {
+		spdk_thread_send_msg(node->thread, _vbdev_cache_destruct, node->base_desc);
+	} else {
+		spdk_bdev_close(node->base_desc);
+	}
+
+	spdk_io_device_unregister(node, _device_unregister_cb);
+
+	return 0;
+}
+
+static const struct spdk_bdev_fn_table vbdev_cache_fn_table = {
+	.destruct		= vbdev_cache_destruct,
+	.submit_request		= vbdev_cache_submit_request,
+	.io_type_supported	= vbdev_cache_io_type_supported,
+	.get_io_channel		= vbdev_cache_get_io_channel,
+	.dump_info_json		= vbdev_cache_dump_info_json,
+};
+
+static void
+vbdev_cache_base_bdev_hotremove_cb(struct spdk_bdev *bdev_find)
+{
+	struct vbdev_cache *node, *tmp;
+
+	TAILQ_FOREACH_SAFE(node, &g_cache_nodes, link, tmp) {
+		if (bdev_find == node->base_bdev) {
+			spdk_bdev_unregister(&node->cache_bdev, NULL, NULL);
+		}
+	}
+}
+
+static void
+vbdev_cache_base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+			       void *event_ctx)
+{
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		vbdev_cache_base_bdev_hotremove_cb(bdev);
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+static struct bdev_names *
+vbdev_cache_find_name(const char *vbdev_name)
+{
+	struct bdev_names *name;
+
+	TAILQ_FOREACH(name, &g_bdev_names, link) {
+		if (strcmp(name->vbdev_name, vbdev_name) == 0) {
+			return name;
+		}
+	}
+
+	return NULL;
+}
+
+static int
+vbdev_cache_insert_name(const char *bdev_name, const char *vbdev_name,
+			const struct spdk_uuid *uuid, uint64_t size_mb, uint32_t line_size_kb)
+{
+	struct bdev_names *name;
+
+	if (vbdev_cache_find_name(vbdev_name) != NULL) {
+		SPDK_ERRLOG("cache bdev %s already exists\n", vbdev_name);
+		return -EEXIST;
+	}
+
+	name = calloc(1, sizeof(struct bdev_names));
+	if (!name) {
+		SPDK_ERRLOG("could not allocate bdev_names\n");
+		return -ENOMEM;
+	}
+
+	name->bdev_name = strdup(bdev_name);
+	name->vbdev_name = strdup(vbdev_name);
+	if (!name->bdev_name || !name->vbdev_name) {
+		SPDK_ERRLOG("could not allocate bdev names\n");
+		free(name->bdev_name);
+		free(name->vbdev_name);
+		free(name);
+		return -ENOMEM;
+	}
+
+	if (uuid) {
+		spdk_uuid_copy(&name->uuid, uuid);
+	}
+	name->size_mb = size_mb;
+	name->line_size_kb = line_size_kb;
+
+	TAILQ_INSERT_TAIL(&g_bdev_names, name, link);
+
+	return 0;
+}
+
+static void
+vbdev_cache_remove_name(struct bdev_names *name)
+{
+	TAILQ_REMOVE(&g_bdev_names, name, link);
+	free(name->bdev_name);
+	free(name->vbdev_name);
+	free(name);
+}
+
+static int
+vbdev_cache_register(const char *bdev_name)
+{
+	struct bdev_names *name;
+	struct vbdev_cache *node;
+	struct spdk_bdev *bdev;
+	struct spdk_uuid ns_uuid;
+	int rc = 0;
+
+	spdk_uuid_parse(&ns_uuid, BDEV_CACHE_NAMESPACE_UUID);
+
+	TAILQ_FOREACH(name, &g_bdev_names, link) {
+		if (strcmp(name->bdev_name, bdev_name) != 0) {
+			continue;
+		}
+
+		node = calloc(1, sizeof(struct vbdev_cache));
+		if (!node) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate cache node\n");
+			break;
+		}
+
+		node->cache_bdev.name = strdup(name->vbdev_name);
+		if (!node->cache_bdev.name) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate cache_bdev name\n");
+			free(node);
+			break;
+		}
+		node->cache_bdev.product_name = "cache";
+
+		rc = spdk_bdev_open_ext(bdev_name, true, vbdev_cache_base_bdev_event_cb,
+					NULL, &node->base_desc);
+		if (rc) {
+			if (rc != -ENODEV) {
+				SPDK_ERRLOG("could not open bdev %s\n", bdev_name);
+			}
+			vbdev_cache_free(node);
+			break;
+		}
+
+		bdev = spdk_bdev_desc_get_bdev(node->base_desc);
+		node->base_bdev = bdev;
+		node->size_mb = name->size_mb;
+		node->line_size_kb = name->line_size_kb;
+		node->line_size = name->line_size_kb * 1024;
+
+		/* Lines are copied as a whole, so separate metadata can't be cached */
+		if (bdev->md_len != 0 && !bdev->md_interleave) {
+			SPDK_ERRLOG("cache bdev doesn't support separate metadata of bdev %s\n",
+				    bdev_name);
+			rc = -ENOTSUP;
+		} else if (node->line_size % bdev->blocklen != 0 ||
+			   spdk_bdev_get_buf_align(bdev) > node->line_size) {
+			SPDK_ERRLOG("cache line size %" PRIu32 "KiB is incompatible with bdev %s\n",
+				    node->line_size_kb, bdev_name);
+			rc = -EINVAL;
+		} else if (name->size_mb * 1024 * 1024 / node->line_size == 0 ||
+			   name->size_mb * 1024 * 1024 / node->line_size > UINT32_MAX) {
+			SPDK_ERRLOG("invalid cache size %" PRIu64 "MiB\n", name->size_mb);
+			rc = -EINVAL;
+		}
+		if (rc) {
+			spdk_bdev_close(node->base_desc);
+			vbdev_cache_free(node);
+			break;
+		}
+
+		node->line_blocks = node->line_size / bdev->blocklen;
+		node->num_lines = name->size_mb * 1024 * 1024 / node->line_size;
+		rc = vbdev_cache_alloc_shards(node);
+		if (rc) {
+			spdk_bdev_close(node->base_desc);
+			vbdev_cache_free(node);
+			break;
+		}
+
+		if (!spdk_mem_all_zero(&name->uuid, sizeof(name->uuid))) {
+			spdk_uuid_copy(&node->cache_bdev.uuid, &name->uuid);
+		} else {
+			/* Generate UUID based on namespace UUID + base bdev UUID. */
+			rc = spdk_uuid_generate_sha1(&node->cache_bdev.uuid, &ns_uuid,
+						     (const char *)&bdev->uuid,
+						     sizeof(struct spdk_uuid));
+			if (rc) {
+				SPDK_ERRLOG("Unable to generate new UUID for cache bdev\n");
+				spdk_bdev_close(node->base_desc);
+				vbdev_cache_free(node);
+				break;
+			}
+		}
+
+		node->cache_bdev.write_cache = bdev->write_cache;
+		node->cache_bdev.required_alignment = bdev->required_alignment;
+		node->cache_bdev.optimal_io_boundary = bdev->optimal_io_boundary;
+		node->cache_bdev.blocklen = bdev->blocklen;
+		node->cache_bdev.blockcnt = bdev->blockcnt;
+
+		node->cache_bdev.md_interleave = bdev->md_interleave;
+		node->cache_bdev.md_len = bdev->md_len;
+		node->cache_bdev.dif_type = bdev->dif_type;
+		node->cache_bdev.dif_is_head_of_md = bdev->dif_is_head_of_md;
+		node->cache_bdev.dif_check_flags = bdev->dif_check_flags;
+
+		node->cache_bdev.ctxt = node;
+		node->cache_bdev.fn_table = &vbdev_cache_fn_table;
+		node->cache_bdev.module = &cache_if;
+		TAILQ_INSERT_TAIL(&g_cache_nodes, node, link);
+
+		spdk_io_device_register(node, cache_bdev_ch_create_cb, cache_bdev_ch_destroy_cb,
+					sizeof(struct cache_io_channel), name->vbdev_name);
+
+		/* Save the thread where the base device is opened */
+		node->thread = spdk_get_thread();
+
+		rc = spdk_bdev_module_claim_bdev(bdev, node->base_desc, node->cache_bdev.module);
+		if (rc) {
+			SPDK_ERRLOG("could not claim bdev %s\n", bdev_name);
+			spdk_bdev_close(node->base_desc);
+			TAILQ_REMOVE(&g_cache_nodes, node, link);
+			spdk_io_device_unregister(node, _device_unregister_cb);
+			break;
+		}
+
+		rc = spdk_bdev_register(&node->cache_bdev);
+		if (rc) {
+			SPDK_ERRLOG("could not register cache_bdev\n");
+			spdk_bdev_module_release_bdev(bdev);
+			spdk_bdev_close(node->base_desc);
+			TAILQ_REMOVE(&g_cache_nodes, node, link);
+			spdk_io_device_unregister(node, _device_unregister_cb);
+			break;
+		}
+		SPDK_NOTICELOG("created cache bdev %s on %s: %" PRIu32 " lines of %" PRIu32 "KiB\n",
+			       name->vbdev_name, bdev_name, node->num_lines, node->line_size_kb);
+	}
+
+	return rc;
+}
+
+int
+bdev_cache_create_disk(const char *bdev_name, const char *vbdev_name,
+		       const struct spdk_uuid *uuid, uint64_t size_mb, uint32_t line_size_kb)
+{
+	int rc;
+
+	if (size_mb == 0) {
+		SPDK_ERRLOG("cache size must be greater than 0\n");
+		return -EINVAL;
+	}
+
+	if (line_size_kb == 0) {
+		line_size_kb = VBDEV_CACHE_DEFAULT_LINE_SIZE_KB;
+	} else if (!spdk_u32_is_pow2(line_size_kb)) {
+		SPDK_ERRLOG("cache line size must be a power of two\n");
+		return -EINVAL;
+	}
+
+	rc = vbdev_cache_insert_name(bdev_name, vbdev_name, uuid, size_mb, line_size_kb);
+	if (rc) {
+		return rc;
+	}
+
+	rc = vbdev_cache_register(bdev_name);
+	if (rc == -ENODEV) {
+		/* This is not an error, we tracked the name above and it still
+		 * may show up later.
+		 */
+		SPDK_NOTICELOG("vbdev creation deferred pending base bdev arrival\n");
+		rc = 0;
+	} else if (rc) {
+		/* Don't retry creating the bdev once its base bdev shows up again */
+		vbdev_cache_remove_name(vbdev_cache_find_name(vbdev_name));
+	}
+
+	return rc;
+}
+
+void
+bdev_cache_delete_disk(const char *vbdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	struct bdev_names *name;
+	int rc;
+
+	rc = spdk_bdev_unregister_by_name(vbdev_name, &cache_if, cb_fn, cb_arg);
+	if (rc == 0) {
+		/* Remove the association (vbdev, bdev) from g_bdev_names, so that the vbdev
+		 * isn't re-created if the same bdev is constructed at some other time.
+		 */
+		name = vbdev_cache_find_name(vbdev_name);
+		if (name != NULL) {
+			vbdev_cache_remove_name(name);
+		}
+	} else {
+		cb_fn(cb_arg, rc);
+	}
+}
+
+static int
+vbdev_cache_init(void)
+{
+	return 0;
+}
+
+static void
+vbdev_cache_finish(void)
+{
+	struct bdev_names *name;
+
+	while ((name = TAILQ_FIRST(&g_bdev_names))) {
+		vbdev_cache_remove_name(name);
+	}
+}
+
+static int
+vbdev_cache_get_ctx_size(void)
+{
+	return sizeof(struct cache_bdev_io);
+}
+
+static void
+vbdev_cache_examine(struct spdk_bdev *bdev)
+{
+	vbdev_cache_register(bdev->name);
+
+	spdk_bdev_module_examine_done(&cache_if);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(vbdev_cache)
@@ -0,0 +1,40 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_VBDEV_CACHE_H
+#define SPDK_VBDEV_CACHE_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+
+/* Default size of a single cache line, in KiB */
+#define VBDEV_CACHE_DEFAULT_LINE_SIZE_KB	16
+
+/**
+ * Create new cache bdev.
+ *
+ * \param bdev_name Bdev on which cache vbdev will be created.
+ * \param vbdev_name Name of the cache bdev.
+ * \param uuid UUID of the cache bdev (optional).
+ * \param size_mb Size of the memory used to cache data, in MiB.
+ * \param line_size_kb Size of a single cache line, in KiB. Must be a power of two.
+ * \return 0 on success, other on failure.
+ */
+int bdev_cache_create_disk(const char *bdev_name, const char *vbdev_name,
+			   const struct spdk_uuid *uuid, uint64_t size_mb, uint32_t line_size_kb);
+
+/**
+ * Delete cache bdev.
+ *
+ * \param vbdev_name Name of the cache bdev.
+ * \param cb_fn Function to call after deletion.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_cache_delete_disk(const char *vbdev_name, spdk_bdev_unregister_cb cb_fn,
+			    void *cb_arg);
+
+#endif /* SPDK_VBDEV_CACHE_H */
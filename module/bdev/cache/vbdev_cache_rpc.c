@@ -0,0 +1,125 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "vbdev_cache.h"
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/string.h"
+#include "spdk/log.h"
+
+struct rpc_construct_cache {
+	char *base_bdev_name;
+	char *name;
+	char *uuid;
+	uint64_t size_mb;
+	uint32_t line_size_kb;
+};
+
+static void
+free_rpc_construct_cache(struct rpc_construct_cache *r)
+{
+	free(r->base_bdev_name);
+	free(r->name);
+	free(r->uuid);
+}
+
+static const struct spdk_json_object_decoder rpc_construct_cache_decoders[] = {
+	{"base_bdev_name", offsetof(struct rpc_construct_cache, base_bdev_name), spdk_json_decode_string},
+	{"name", offsetof(struct rpc_construct_cache, name), spdk_json_decode_string},
+	{"uuid", offsetof(struct rpc_construct_cache, uuid), spdk_json_decode_string, true},
+	{"size_mb", offsetof(struct rpc_construct_cache, size_mb), spdk_json_decode_uint64},
+	{"line_size_kb", offsetof(struct rpc_construct_cache, line_size_kb), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_bdev_cache_create(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_construct_cache req = {NULL};
+	struct spdk_json_write_ctx *w;
+	struct spdk_uuid *uuid = NULL;
+	struct spdk_uuid decoded_uuid;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_construct_cache_decoders,
+				    SPDK_COUNTOF(rpc_construct_cache_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(vbdev_cache, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	if (req.uuid) {
+		if (spdk_uuid_parse(&decoded_uuid, req.uuid)) {
+			spdk_jsonrpc_send_error_response(request, -EINVAL,
+							 "Failed to parse bdev UUID");
+			goto cleanup;
+		}
+		uuid = &decoded_uuid;
+	}
+
+	rc = bdev_cache_create_disk(req.base_bdev_name, req.name, uuid, req.size_mb,
+				    req.line_size_kb);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_string(w, req.name);
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_construct_cache(&req);
+}
+SPDK_RPC_REGISTER("bdev_cache_create", rpc_bdev_cache_create, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_cache_delete {
+	char *name;
+};
+
+static void
+free_rpc_bdev_cache_delete(struct rpc_bdev_cache_delete *req)
+{
+	free(req->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_cache_delete_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_cache_delete, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_cache_delete_cb(void *cb_arg, int bdeverrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (bdeverrno == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, bdeverrno, spdk_strerror(-bdeverrno));
+	}
+}
+
+static void
+rpc_bdev_cache_delete(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_cache_delete req = {NULL};
+
+	if (spdk_json_decode_object(params, rpc_bdev_cache_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_cache_delete_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev_cache_delete_disk(req.name, rpc_bdev_cache_delete_cb, request);
+
+cleanup:
+	free_rpc_bdev_cache_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_cache_delete", rpc_bdev_cache_delete, SPDK_RPC_RUNTIME)
@@ -533,6 +533,14 @@ crypto_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 
 	crypto_ch->crypto_key = crypto_bdev->opts->key;
 
+	/* Load the key into a hardware key slot before the volume starts doing I/O.  It isn't
+	 * fatal, the key is bound by accel on first use anyway.
+	 */
+	if (spdk_accel_crypto_key_prefetch(crypto_ch->crypto_key) != 0) {
+		SPDK_NOTICELOG("Failed to prefetch crypto key (bdev: %s)\n",
+			       crypto_bdev->crypto_bdev.name);
+	}
+
 	return 0;
 }
 
@@ -29,6 +29,23 @@ rpc_bdev_ftl_decode_uuid(const struct spdk_json_val *val, void *out)
 	return ret;
 }
 
+static int
+rpc_bdev_ftl_decode_gc_policy(const struct spdk_json_val *val, void *out)
+{
+	uint32_t *gc_policy = out;
+	char *name;
+
+	name = spdk_json_strdup(val);
+	if (!name) {
+		return -ENOMEM;
+	}
+
+	*gc_policy = spdk_ftl_gc_policy_from_name(name);
+	free(name);
+
+	return *gc_policy < SPDK_FTL_GC_POLICY_MAX ? 0 : -EINVAL;
+}
+
 static const struct spdk_json_object_decoder rpc_bdev_ftl_create_decoders[] = {
 	{"name", offsetof(struct spdk_ftl_conf, name), spdk_json_decode_string},
 	{"base_bdev", offsetof(struct spdk_ftl_conf, base_bdev), spdk_json_decode_string},
@@ -50,6 +67,14 @@ static const struct spdk_json_object_decoder rpc_bdev_ftl_create_decoders[] = {
 		"fast_shutdown", offsetof(struct spdk_ftl_conf, fast_shutdown),
 		spdk_json_decode_bool, true
 	},
+	{
+		"gc_policy", offsetof(struct spdk_ftl_conf, gc_policy),
+		rpc_bdev_ftl_decode_gc_policy, true
+	},
+	{
+		"nv_cache_bypass", offsetof(struct spdk_ftl_conf, nv_cache_bypass),
+		spdk_json_decode_bool, true
+	},
 };
 
 static void
@@ -228,6 +253,20 @@ static const struct spdk_json_object_decoder rpc_ftl_stats_decoders[] = {
 	{"name", offsetof(struct rpc_ftl_stats, name), spdk_json_decode_string},
 };
 
+/* Write amplification of the base device caused by the data compacted from the NV cache */
+static double
+rpc_bdev_ftl_get_waf(const struct ftl_stats *stats)
+{
+	uint64_t write_user, write_total;
+
+	write_user = stats->entries[FTL_STATS_TYPE_CMP].write.blocks;
+	write_total = write_user +
+		      stats->entries[FTL_STATS_TYPE_GC].write.blocks +
+		      stats->entries[FTL_STATS_TYPE_MD_BASE].write.blocks;
+
+	return write_user ? (double)write_total / (double)write_user : 0.0;
+}
+
 static void
 _rpc_bdev_ftl_get_stats(void *cntx)
 {
@@ -287,6 +326,20 @@ _rpc_bdev_ftl_get_stats(void *cntx)
 		spdk_json_write_object_end(w);
 	}
 
+	spdk_json_write_named_object_begin(w, "gc_victims");
+	spdk_json_write_named_string(w, "policy", spdk_ftl_gc_policy_get_name(stats->gc.policy));
+	spdk_json_write_named_uint64(w, "bands", stats->gc.bands);
+	spdk_json_write_named_uint64(w, "valid_blocks", stats->gc.valid_blocks);
+	spdk_json_write_named_double(w, "waf", rpc_bdev_ftl_get_waf(stats));
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_named_object_begin(w, "l2p_cache");
+	spdk_json_write_named_uint64(w, "hits", stats->l2p_cache.hits);
+	spdk_json_write_named_uint64(w, "misses", stats->l2p_cache.misses);
+	spdk_json_write_named_uint64(w, "prefetches", stats->l2p_cache.prefetches);
+	spdk_json_write_named_uint64(w, "prefetch_hits", stats->l2p_cache.prefetch_hits);
+	spdk_json_write_object_end(w);
+
 	spdk_json_write_object_end(w);
 	spdk_jsonrpc_end_result(request, w);
 
@@ -681,6 +681,108 @@ vbdev_lvol_destroy(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb
 	_vbdev_lvol_destroy(lvol, cb_fn, cb_arg);
 }
 
+static void
+_vbdev_lvol_merge_snapshot_cb(void *cb_arg, int lvolerrno)
+{
+	struct vbdev_lvol_destroy_ctx *ctx = cb_arg;
+
+	if (lvolerrno != 0) {
+		ctx->cb_fn(ctx->cb_arg, lvolerrno);
+	} else {
+		/* With at most a single clone left, deleting the snapshot only updates metadata */
+		vbdev_lvol_destroy(ctx->lvol, ctx->cb_fn, ctx->cb_arg);
+	}
+
+	free(ctx);
+}
+
+void
+vbdev_lvol_merge_snapshot(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct vbdev_lvol_destroy_ctx *ctx;
+
+	if (spdk_lvol_is_degraded(lvol) || !spdk_blob_is_snapshot(lvol->blob)) {
+		SPDK_ERRLOG("lvol %s is not an available snapshot\n", lvol->unique_id);
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->lvol = lvol;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_lvol_decouple_clones(lvol, _vbdev_lvol_merge_snapshot_cb, ctx);
+}
+
+struct vbdev_lvol_shallow_copy_ctx {
+	struct spdk_bs_dev *ext_dev;
+	spdk_lvol_op_complete cb_fn;
+	void *cb_arg;
+};
+
+static void
+vbdev_lvol_shallow_copy_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+				      void *event_ctx)
+{
+	/* A removed bdev is only released once the copy completes */
+	SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+}
+
+static void
+_vbdev_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
+{
+	struct vbdev_lvol_shallow_copy_ctx *ctx = cb_arg;
+
+	ctx->ext_dev->destroy(ctx->ext_dev);
+	ctx->cb_fn(ctx->cb_arg, lvolerrno);
+	free(ctx);
+}
+
+void
+vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_lvol *base, const char *bdev_name,
+			uint32_t queue_depth, spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct vbdev_lvol_shallow_copy_ctx *ctx;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	rc = spdk_bdev_create_bs_dev_ext(bdev_name, vbdev_lvol_shallow_copy_bdev_event_cb, NULL,
+					 &ctx->ext_dev);
+	if (rc != 0) {
+		SPDK_ERRLOG("Cannot create blobstore device for bdev %s\n", bdev_name);
+		free(ctx);
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	/* Nobody else should write to the bdev while it's being written */
+	rc = spdk_bs_bdev_claim(ctx->ext_dev, &g_lvol_if);
+	if (rc != 0) {
+		SPDK_ERRLOG("Cannot claim bdev %s\n", bdev_name);
+		ctx->ext_dev->destroy(ctx->ext_dev);
+		free(ctx);
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_lvol_shallow_copy(lvol, base, ctx->ext_dev, queue_depth, _vbdev_lvol_shallow_copy_cb,
+			       ctx);
+}
+
 static char *
 vbdev_lvol_find_name(struct spdk_lvol *lvol, spdk_blob_id blob_id)
 {
@@ -937,6 +1039,36 @@ lvol_reset(struct spdk_bdev_io *bdev_io)
 	return 0;
 }
 
+/*
+ * Reads and writes contained in a single cluster allocated to the lvol are passed straight to
+ * the bdev of the lvol store, at the LBA the cluster map of the blob translates them to, so
+ * that they don't go through the request sets of the blobstore.
+ */
+static bool
+lvol_forward_io(struct spdk_lvol *lvol, struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_desc *desc;
+	struct spdk_io_channel *dev_ch;
+	uint64_t lba;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE && spdk_blob_is_read_only(lvol->blob)) {
+		return false;
+	}
+
+	if (spdk_blob_io_get_dev_lba(lvol->blob, ch, bdev_io->u.bdev.offset_blocks,
+				     bdev_io->u.bdev.num_blocks, &dev_ch, &lba) != 0) {
+		return false;
+	}
+
+	desc = spdk_bs_bdev_get_desc(lvol->lvol_store->bs_dev);
+	if (desc == NULL) {
+		return false;
+	}
+
+	return spdk_bdev_io_forward_blocks(desc, dev_ch, bdev_io,
+					   lba - bdev_io->u.bdev.offset_blocks) == 0;
+}
+
 static void
 lvol_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io, bool success)
 {
@@ -955,10 +1087,16 @@ vbdev_lvol_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
+		if (lvol_forward_io(lvol, ch, bdev_io)) {
+			break;
+		}
 		spdk_bdev_io_get_buf(bdev_io, lvol_get_buf_cb,
 				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
+		if (lvol_forward_io(lvol, ch, bdev_io)) {
+			break;
+		}
 		lvol_write(lvol, ch, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_RESET:
@@ -1949,6 +2087,7 @@ vbdev_lvol_esnap_dev_create(void *bs_ctx, void *blob_ctx, struct spdk_blob *blob
 	struct spdk_lvol_store	*lvs = bs_ctx;
 	struct spdk_lvol	*lvol = blob_ctx;
 	struct spdk_bs_dev	*bs_dev = NULL;
+	struct spdk_bs_dev	*cache_dev;
 	struct spdk_uuid	uuid;
 	int			rc;
 	char			uuid_str[SPDK_UUID_STRING_LEN] = { 0 };
@@ -1992,6 +2131,15 @@ vbdev_lvol_esnap_dev_create(void *bs_ctx, void *blob_ctx, struct spdk_blob *blob
 		goto fail;
 	}
 
+	/* Share the data read from the external snapshot among all of its clones */
+	rc = spdk_bs_esnap_cache_dev_create(bs_dev, uuid_str, sizeof(uuid_str), &cache_dev);
+	if (rc == 0) {
+		bs_dev = cache_dev;
+	} else {
+		SPDK_NOTICELOG("lvol %s: reads of esnap bdev '%s' will not be cached: %d\n",
+			       lvol->unique_id, uuid_str, rc);
+	}
+
 	*_bs_dev = bs_dev;
 	return 0;
 
@@ -77,6 +77,29 @@ void vbdev_lvol_rename(struct spdk_lvol *lvol, const char *new_lvol_name,
  */
 void vbdev_lvol_destroy(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Merge a snapshot into its clones and destroy it.  The clusters of the snapshot are copied only
+ * to the clones that need to be decoupled first, see spdk_lvol_decouple_clones().
+ * \param lvol Handle to the snapshot lvol
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void vbdev_lvol_merge_snapshot(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn,
+			       void *cb_arg);
+
+/**
+ * Copy the clusters of a read only lvol to another bdev, see spdk_lvol_shallow_copy().
+ * \param lvol Handle to the read only lvol
+ * \param base Handle to an older snapshot already copied, NULL to copy the whole chain
+ * \param bdev_name Name of the bdev to copy the lvol to, claimed during the copy
+ * \param queue_depth Maximum number of clusters copied in parallel
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_lvol *base,
+			     const char *bdev_name, uint32_t queue_depth,
+			     spdk_lvol_op_complete cb_fn, void *cb_arg);
+
 /**
  * \brief Renames given lvolstore.
  *
@@ -812,6 +812,248 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_lvol_decouple_parent", rpc_bdev_lvol_decouple_parent, SPDK_RPC_RUNTIME)
 
+static void
+rpc_bdev_lvol_merge_snapshot(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_inflate req = {};
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+
+	SPDK_INFOLOG(lvol_rpc, "Merging snapshot\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_inflate_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_inflate_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_get_by_name(req.name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	vbdev_lvol_merge_snapshot(lvol, rpc_bdev_lvol_inflate_cb, request);
+
+cleanup:
+	free_rpc_bdev_lvol_inflate(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_merge_snapshot", rpc_bdev_lvol_merge_snapshot, SPDK_RPC_RUNTIME)
+
+/* Upper bound of the number of extents returned by a single call */
+#define RPC_LVOL_CHANGED_EXTENTS_MAX	4096
+
+struct rpc_bdev_lvol_get_changed_extents {
+	char *name;
+	char *base_name;
+	uint64_t offset;
+	uint32_t max_extents;
+};
+
+static void
+free_rpc_bdev_lvol_get_changed_extents(struct rpc_bdev_lvol_get_changed_extents *req)
+{
+	free(req->name);
+	free(req->base_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_get_changed_extents_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_lvol_get_changed_extents, name), spdk_json_decode_string},
+	{"base_name", offsetof(struct rpc_bdev_lvol_get_changed_extents, base_name),
+		spdk_json_decode_string, true},
+	{"offset", offsetof(struct rpc_bdev_lvol_get_changed_extents, offset),
+		spdk_json_decode_uint64, true},
+	{"max_extents", offsetof(struct rpc_bdev_lvol_get_changed_extents, max_extents),
+		spdk_json_decode_uint32, true},
+};
+
+static struct spdk_lvol *
+rpc_bdev_lvol_get_by_bdev_name(const char *name)
+{
+	struct spdk_bdev *bdev;
+
+	bdev = spdk_bdev_get_by_name(name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", name);
+		return NULL;
+	}
+
+	return vbdev_lvol_get_from_bdev(bdev);
+}
+
+static void
+rpc_bdev_lvol_get_changed_extents(struct spdk_jsonrpc_request *request,
+				  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_get_changed_extents req = {
+		.max_extents = 1024,
+	};
+	struct spdk_json_write_ctx *w;
+	struct spdk_blob_extent *extents = NULL;
+	struct spdk_lvol *lvol, *base = NULL;
+	spdk_blob_id base_id = SPDK_BLOBID_INVALID;
+	uint64_t io_unit_size;
+	uint32_t i, num;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_get_changed_extents_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_get_changed_extents_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	lvol = rpc_bdev_lvol_get_by_bdev_name(req.name);
+	if (req.base_name != NULL) {
+		base = rpc_bdev_lvol_get_by_bdev_name(req.base_name);
+	}
+	if (lvol == NULL || (req.base_name != NULL && base == NULL)) {
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	if (base != NULL) {
+		if (base->lvol_store != lvol->lvol_store) {
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							 "Base lvol is in a different lvol store");
+			goto cleanup;
+		}
+		base_id = base->blob_id;
+	}
+
+	io_unit_size = spdk_bs_get_io_unit_size(lvol->lvol_store->blobstore);
+	if (req.offset % io_unit_size != 0 || req.max_extents == 0 ||
+	    req.max_extents > RPC_LVOL_CHANGED_EXTENTS_MAX) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(EINVAL));
+		goto cleanup;
+	}
+
+	extents = calloc(req.max_extents, sizeof(*extents));
+	if (extents == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	num = req.max_extents;
+	rc = spdk_blob_get_changed_extents(lvol->blob, base_id, req.offset / io_unit_size,
+					   extents, &num);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_array_begin(w, "extents");
+	for (i = 0; i < num; i++) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint64(w, "offset", extents[i].offset * io_unit_size);
+		spdk_json_write_named_uint64(w, "length", extents[i].length * io_unit_size);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free(extents);
+	free_rpc_bdev_lvol_get_changed_extents(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_get_changed_extents", rpc_bdev_lvol_get_changed_extents,
+		  SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_lvol_shallow_copy {
+	char *src_lvol_name;
+	char *dst_bdev_name;
+	char *base_name;
+	uint32_t queue_depth;
+};
+
+static void
+free_rpc_bdev_lvol_shallow_copy(struct rpc_bdev_lvol_shallow_copy *req)
+{
+	free(req->src_lvol_name);
+	free(req->dst_bdev_name);
+	free(req->base_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_shallow_copy_decoders[] = {
+	{"src_lvol_name", offsetof(struct rpc_bdev_lvol_shallow_copy, src_lvol_name),
+		spdk_json_decode_string},
+	{"dst_bdev_name", offsetof(struct rpc_bdev_lvol_shallow_copy, dst_bdev_name),
+		spdk_json_decode_string},
+	{"base_name", offsetof(struct rpc_bdev_lvol_shallow_copy, base_name),
+		spdk_json_decode_string, true},
+	{"queue_depth", offsetof(struct rpc_bdev_lvol_shallow_copy, queue_depth),
+		spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_bdev_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (lvolerrno != 0) {
+		spdk_jsonrpc_send_error_response(request, lvolerrno, spdk_strerror(-lvolerrno));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+static void
+rpc_bdev_lvol_shallow_copy(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_shallow_copy req = {
+		.queue_depth = 4,
+	};
+	struct spdk_lvol *lvol, *base = NULL;
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_shallow_copy_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_shallow_copy_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	lvol = rpc_bdev_lvol_get_by_bdev_name(req.src_lvol_name);
+	if (req.base_name != NULL) {
+		base = rpc_bdev_lvol_get_by_bdev_name(req.base_name);
+	}
+	if (lvol == NULL || (req.base_name != NULL && base == NULL)) {
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	vbdev_lvol_shallow_copy(lvol, base, req.dst_bdev_name, req.queue_depth,
+				rpc_bdev_lvol_shallow_copy_cb, request);
+
+cleanup:
+	free_rpc_bdev_lvol_shallow_copy(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_shallow_copy", rpc_bdev_lvol_shallow_copy, SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_lvol_resize {
 	char *name;
 	uint64_t size;
@@ -1341,3 +1583,92 @@ cleanup:
 	free_rpc_bdev_lvol_grow_lvstore(&req);
 }
 SPDK_RPC_REGISTER("bdev_lvol_grow_lvstore", rpc_bdev_lvol_grow_lvstore, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_lvol_set_copy_rate_limit {
+	char *uuid;
+	char *lvs_name;
+	uint64_t clusters_per_sec;
+};
+
+static void
+free_rpc_bdev_lvol_set_copy_rate_limit(struct rpc_bdev_lvol_set_copy_rate_limit *req)
+{
+	free(req->uuid);
+	free(req->lvs_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_set_copy_rate_limit_decoders[] = {
+	{"uuid", offsetof(struct rpc_bdev_lvol_set_copy_rate_limit, uuid),
+		spdk_json_decode_string, true},
+	{"lvs_name", offsetof(struct rpc_bdev_lvol_set_copy_rate_limit, lvs_name),
+		spdk_json_decode_string, true},
+	{"clusters_per_sec", offsetof(struct rpc_bdev_lvol_set_copy_rate_limit, clusters_per_sec),
+		spdk_json_decode_uint64},
+};
+
+static void
+rpc_bdev_lvol_set_copy_rate_limit(struct spdk_jsonrpc_request *request,
+				  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_set_copy_rate_limit req = {};
+	struct spdk_lvol_store *lvs = NULL;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_set_copy_rate_limit_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_set_copy_rate_limit_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = vbdev_get_lvol_store_by_uuid_xor_name(req.uuid, req.lvs_name, &lvs);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bs_set_copy_rate_limit(lvs->blobstore, req.clusters_per_sec);
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_bdev_lvol_set_copy_rate_limit(&req);
+}
+SPDK_RPC_REGISTER("bdev_lvol_set_copy_rate_limit", rpc_bdev_lvol_set_copy_rate_limit,
+		  SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_lvol_set_esnap_cache_size {
+	uint64_t size_mib;
+};
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_set_esnap_cache_size_decoders[] = {
+	{"size_mib", offsetof(struct rpc_bdev_lvol_set_esnap_cache_size, size_mib),
+		spdk_json_decode_uint64},
+};
+
+static void
+rpc_bdev_lvol_set_esnap_cache_size(struct spdk_jsonrpc_request *request,
+				   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_set_esnap_cache_size req = {};
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_set_esnap_cache_size_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_set_esnap_cache_size_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		return;
+	}
+
+	if (req.size_mib > UINT64_MAX / (1024 * 1024)) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL, spdk_strerror(EINVAL));
+		return;
+	}
+
+	spdk_bs_esnap_cache_set_size(req.size_mib * 1024 * 1024);
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("bdev_lvol_set_esnap_cache_size", rpc_bdev_lvol_set_esnap_cache_size,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
@@ -16,10 +16,20 @@
 
 #include "spdk/log.h"
 
+/* Size of the stripes of a buffer interleaved across NUMA nodes, one huge page */
+#define MALLOC_STRIPE_SIZE	(2 * 1024 * 1024)
+#define MALLOC_MAX_NUMA_NODES	64
+
 struct malloc_disk {
 	struct spdk_bdev		disk;
 	void				*malloc_buf;
 	void				*malloc_md_buf;
+	/* Stripes of the buffer when it's interleaved across NUMA nodes, malloc_buf is NULL then */
+	void				**stripes;
+	uint64_t			num_stripes;
+	uint64_t			stripe_blocks;
+	int32_t				numa_node;
+	uint32_t			inline_copy_threshold;
 	TAILQ_ENTRY(malloc_disk)	link;
 };
 
@@ -140,6 +150,30 @@ malloc_complete_task(struct malloc_task *task, struct malloc_channel *mch,
 
 static TAILQ_HEAD(, malloc_disk) g_malloc_disks = TAILQ_HEAD_INITIALIZER(g_malloc_disks);
 
+static inline void *
+malloc_get_buf(struct malloc_disk *mdisk, uint64_t offset_blocks)
+{
+	uint32_t blocklen = mdisk->disk.blocklen;
+
+	if (spdk_likely(mdisk->stripes == NULL)) {
+		return (char *)mdisk->malloc_buf + offset_blocks * blocklen;
+	}
+
+	return (char *)mdisk->stripes[offset_blocks / mdisk->stripe_blocks] +
+	       (offset_blocks % mdisk->stripe_blocks) * blocklen;
+}
+
+/* Number of blocks starting at offset_blocks that are contiguous in memory */
+static inline uint64_t
+malloc_get_contig_blocks(struct malloc_disk *mdisk, uint64_t offset_blocks, uint64_t num_blocks)
+{
+	if (spdk_likely(mdisk->stripes == NULL)) {
+		return num_blocks;
+	}
+
+	return spdk_min(num_blocks, mdisk->stripe_blocks - offset_blocks % mdisk->stripe_blocks);
+}
+
 int malloc_disk_count = 0;
 
 static int bdev_malloc_initialize(void);
@@ -164,6 +198,8 @@ SPDK_BDEV_MODULE_REGISTER(malloc, &malloc_if)
 static void
 malloc_disk_free(struct malloc_disk *malloc_disk)
 {
+	uint64_t i;
+
 	if (!malloc_disk) {
 		return;
 	}
@@ -171,6 +207,12 @@ malloc_disk_free(struct malloc_disk *malloc_disk)
 	free(malloc_disk->disk.name);
 	spdk_free(malloc_disk->malloc_buf);
 	spdk_free(malloc_disk->malloc_md_buf);
+	if (malloc_disk->stripes != NULL) {
+		for (i = 0; i < malloc_disk->num_stripes; i++) {
+			spdk_free(malloc_disk->stripes[i]);
+		}
+		free(malloc_disk->stripes);
+	}
 	free(malloc_disk);
 }
 
@@ -229,12 +271,11 @@ static void
 bdev_malloc_readv(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 		  struct malloc_task *task, struct spdk_bdev_io *bdev_io)
 {
-	uint64_t len, offset, md_offset;
+	uint64_t len, md_offset;
 	int res = 0;
 	size_t md_len;
 
 	len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
-	offset = bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen;
 
 	if (bdev_malloc_check_iov_len(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, len)) {
 		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(task),
@@ -244,11 +285,12 @@ bdev_malloc_readv(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
 	task->num_outstanding = 0;
-	task->iov.iov_base = mdisk->malloc_buf + offset;
+	task->iov.iov_base = malloc_get_buf(mdisk, bdev_io->u.bdev.offset_blocks);
 	task->iov.iov_len = len;
 
 	SPDK_DEBUGLOG(bdev_malloc, "read %zu bytes from offset %#" PRIx64 ", iovcnt=%d\n",
-		      len, offset, bdev_io->u.bdev.iovcnt);
+		      len, bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen,
+		      bdev_io->u.bdev.iovcnt);
 
 	task->num_outstanding++;
 	res = spdk_accel_append_copy(&bdev_io->u.bdev.accel_sequence, ch,
@@ -286,12 +328,11 @@ static void
 bdev_malloc_writev(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 		   struct malloc_task *task, struct spdk_bdev_io *bdev_io)
 {
-	uint64_t len, offset, md_offset;
+	uint64_t len, md_offset;
 	int res = 0;
 	size_t md_len;
 
 	len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
-	offset = bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen;
 
 	if (bdev_malloc_check_iov_len(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, len)) {
 		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(task),
@@ -301,11 +342,12 @@ bdev_malloc_writev(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
 	task->num_outstanding = 0;
-	task->iov.iov_base = mdisk->malloc_buf + offset;
+	task->iov.iov_base = malloc_get_buf(mdisk, bdev_io->u.bdev.offset_blocks);
 	task->iov.iov_len = len;
 
 	SPDK_DEBUGLOG(bdev_malloc, "wrote %zu bytes to offset %#" PRIx64 ", iovcnt=%d\n",
-		      len, offset, bdev_io->u.bdev.iovcnt);
+		      len, bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen,
+		      bdev_io->u.bdev.iovcnt);
 
 	task->num_outstanding++;
 	res = spdk_accel_append_copy(&bdev_io->u.bdev.accel_sequence, ch, &task->iov, 1, NULL, NULL,
@@ -341,27 +383,58 @@ static int
 bdev_malloc_unmap(struct malloc_disk *mdisk,
 		  struct spdk_io_channel *ch,
 		  struct malloc_task *task,
-		  uint64_t offset,
-		  uint64_t byte_count)
+		  uint64_t offset_blocks,
+		  uint64_t num_blocks)
 {
+	uint32_t block_size = mdisk->disk.blocklen;
+	uint64_t contig_blocks;
+	int rc;
+
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
 	task->num_outstanding = 1;
 
-	return spdk_accel_submit_fill(ch, mdisk->malloc_buf + offset, 0,
-				      byte_count, 0, malloc_done, task);
+	contig_blocks = malloc_get_contig_blocks(mdisk, offset_blocks, num_blocks);
+	if (spdk_likely(contig_blocks == num_blocks)) {
+		return spdk_accel_submit_fill(ch, malloc_get_buf(mdisk, offset_blocks), 0,
+					      num_blocks * block_size, 0, malloc_done, task);
+	}
+
+	/* The range spans several stripes, fill each of them separately.  The extra reference
+	 * keeps the task from completing before all of the fills are submitted.
+	 */
+	while (num_blocks > 0) {
+		contig_blocks = malloc_get_contig_blocks(mdisk, offset_blocks, num_blocks);
+
+		task->num_outstanding++;
+		rc = spdk_accel_submit_fill(ch, malloc_get_buf(mdisk, offset_blocks), 0,
+					    contig_blocks * block_size, 0, malloc_done, task);
+		if (rc != 0) {
+			malloc_done(task, rc);
+			break;
+		}
+
+		offset_blocks += contig_blocks;
+		num_blocks -= contig_blocks;
+	}
+
+	malloc_done(task, 0);
+
+	return 0;
 }
 
 static void
 bdev_malloc_copy(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 		 struct malloc_task *task,
-		 uint64_t dst_offset, uint64_t src_offset, size_t len)
+		 uint64_t dst_offset_blocks, uint64_t src_offset_blocks, uint64_t num_blocks)
 {
 	int64_t res = 0;
-	void *dst = mdisk->malloc_buf + dst_offset;
-	void *src = mdisk->malloc_buf + src_offset;
+	void *dst = malloc_get_buf(mdisk, dst_offset_blocks);
+	void *src = malloc_get_buf(mdisk, src_offset_blocks);
+	size_t len = num_blocks * mdisk->disk.blocklen;
 
 	SPDK_DEBUGLOG(bdev_malloc, "Copy %zu bytes from offset %#" PRIx64 " to offset %#" PRIx64 "\n",
-		      len, src_offset, dst_offset);
+		      len, src_offset_blocks * mdisk->disk.blocklen,
+		      dst_offset_blocks * mdisk->disk.blocklen);
 
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
 	task->num_outstanding = 1;
@@ -372,6 +445,58 @@ bdev_malloc_copy(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 	}
 }
 
+static bool
+bdev_malloc_copy_inline(struct malloc_disk *mdisk, struct spdk_bdev_io *bdev_io)
+{
+	uint64_t len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+
+	/* Data in other memory domains or with accel operations pending has to go through accel */
+	return len <= mdisk->inline_copy_threshold &&
+	       bdev_io->u.bdev.memory_domain == NULL &&
+	       bdev_io->u.bdev.accel_sequence == NULL;
+}
+
+static void
+bdev_malloc_rw_inline(struct malloc_disk *mdisk, struct malloc_channel *mch,
+		      struct malloc_task *task, struct spdk_bdev_io *bdev_io)
+{
+	enum spdk_bdev_io_status status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	uint64_t len, md_offset;
+	void *buf, *md_buf = NULL;
+	size_t md_len = 0;
+
+	len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+	if (bdev_malloc_check_iov_len(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, len)) {
+		malloc_complete_task(task, mch, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	buf = malloc_get_buf(mdisk, bdev_io->u.bdev.offset_blocks);
+	if (bdev_io->u.bdev.md_buf != NULL) {
+		md_len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->md_len;
+		md_offset = bdev_io->u.bdev.offset_blocks * bdev_io->bdev->md_len;
+		md_buf = (char *)mdisk->malloc_md_buf + md_offset;
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		spdk_copy_buf_to_iovs(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, buf, len);
+		if (md_buf != NULL) {
+			memcpy(bdev_io->u.bdev.md_buf, md_buf, md_len);
+		}
+
+		if (bdev_io->bdev->dif_type != SPDK_DIF_DISABLE && malloc_verify_pi(bdev_io) != 0) {
+			status = SPDK_BDEV_IO_STATUS_FAILED;
+		}
+	} else {
+		spdk_copy_iovs_to_buf(buf, len, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt);
+		if (md_buf != NULL) {
+			memcpy(md_buf, bdev_io->u.bdev.md_buf, md_len);
+		}
+	}
+
+	malloc_complete_task(task, mch, status);
+}
+
 static int
 _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bdev_io)
 {
@@ -386,12 +511,17 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 			assert(bdev_io->u.bdev.iovcnt == 1);
 			assert(bdev_io->u.bdev.memory_domain == NULL);
 			bdev_io->u.bdev.iovs[0].iov_base =
-				disk->malloc_buf + bdev_io->u.bdev.offset_blocks * block_size;
+				malloc_get_buf(disk, bdev_io->u.bdev.offset_blocks);
 			bdev_io->u.bdev.iovs[0].iov_len = bdev_io->u.bdev.num_blocks * block_size;
 			malloc_complete_task(task, mch, SPDK_BDEV_IO_STATUS_SUCCESS);
 			return 0;
 		}
 
+		if (bdev_malloc_copy_inline(disk, bdev_io)) {
+			bdev_malloc_rw_inline(disk, mch, task, bdev_io);
+			return 0;
+		}
+
 		bdev_malloc_readv(disk, mch->accel_channel, task, bdev_io);
 		return 0;
 
@@ -404,6 +534,11 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 			}
 		}
 
+		if (bdev_malloc_copy_inline(disk, bdev_io)) {
+			bdev_malloc_rw_inline(disk, mch, task, bdev_io);
+			return 0;
+		}
+
 		bdev_malloc_writev(disk, mch->accel_channel, task, bdev_io);
 		return 0;
 
@@ -417,21 +552,21 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 
 	case SPDK_BDEV_IO_TYPE_UNMAP:
 		return bdev_malloc_unmap(disk, mch->accel_channel, task,
-					 bdev_io->u.bdev.offset_blocks * block_size,
-					 bdev_io->u.bdev.num_blocks * block_size);
+					 bdev_io->u.bdev.offset_blocks,
+					 bdev_io->u.bdev.num_blocks);
 
 	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
 		/* bdev_malloc_unmap is implemented with a call to mem_cpy_fill which zeroes out all of the requested bytes. */
 		return bdev_malloc_unmap(disk, mch->accel_channel, task,
-					 bdev_io->u.bdev.offset_blocks * block_size,
-					 bdev_io->u.bdev.num_blocks * block_size);
+					 bdev_io->u.bdev.offset_blocks,
+					 bdev_io->u.bdev.num_blocks);
 
 	case SPDK_BDEV_IO_TYPE_ZCOPY:
 		if (bdev_io->u.bdev.zcopy.start) {
 			void *buf;
 			size_t len;
 
-			buf = disk->malloc_buf + bdev_io->u.bdev.offset_blocks * block_size;
+			buf = malloc_get_buf(disk, bdev_io->u.bdev.offset_blocks);
 			len = bdev_io->u.bdev.num_blocks * block_size;
 			spdk_bdev_io_set_buf(bdev_io, buf, len);
 
@@ -443,9 +578,9 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 		return 0;
 	case SPDK_BDEV_IO_TYPE_COPY:
 		bdev_malloc_copy(disk, mch->accel_channel, task,
-				 bdev_io->u.bdev.offset_blocks * block_size,
-				 bdev_io->u.bdev.copy.src_offset_blocks * block_size,
-				 bdev_io->u.bdev.num_blocks * block_size);
+				 bdev_io->u.bdev.offset_blocks,
+				 bdev_io->u.bdev.copy.src_offset_blocks,
+				 bdev_io->u.bdev.num_blocks);
 		return 0;
 
 	default:
@@ -468,6 +603,8 @@ bdev_malloc_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev
 static bool
 bdev_malloc_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 {
+	struct malloc_disk *mdisk = ctx;
+
 	switch (io_type) {
 	case SPDK_BDEV_IO_TYPE_READ:
 	case SPDK_BDEV_IO_TYPE_WRITE:
@@ -475,11 +612,14 @@ bdev_malloc_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 	case SPDK_BDEV_IO_TYPE_RESET:
 	case SPDK_BDEV_IO_TYPE_UNMAP:
 	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
-	case SPDK_BDEV_IO_TYPE_ZCOPY:
 	case SPDK_BDEV_IO_TYPE_ABORT:
-	case SPDK_BDEV_IO_TYPE_COPY:
 		return true;
 
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		/* These aren't split on stripe boundaries by the bdev layer */
+		return mdisk->stripes == NULL;
+
 	default:
 		return false;
 	}
@@ -494,6 +634,7 @@ bdev_malloc_get_io_channel(void *ctx)
 static void
 bdev_malloc_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 {
+	struct malloc_disk *mdisk = bdev->ctxt;
 	char uuid_str[SPDK_UUID_STRING_LEN];
 
 	spdk_json_write_object_begin(w);
@@ -508,6 +649,15 @@ bdev_malloc_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx
 	spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &bdev->uuid);
 	spdk_json_write_named_string(w, "uuid", uuid_str);
 	spdk_json_write_named_uint32(w, "optimal_io_boundary", bdev->optimal_io_boundary);
+	if (mdisk->stripes != NULL) {
+		spdk_json_write_named_bool(w, "numa_interleave", true);
+	} else if (mdisk->numa_node != SPDK_ENV_SOCKET_ID_ANY) {
+		spdk_json_write_named_int32(w, "numa_node", mdisk->numa_node);
+	}
+	if (mdisk->inline_copy_threshold != 0) {
+		spdk_json_write_named_uint32(w, "inline_copy_threshold",
+					     mdisk->inline_copy_threshold);
+	}
 
 	spdk_json_write_object_end(w);
 
@@ -570,7 +720,8 @@ malloc_disk_setup_pi(struct malloc_disk *mdisk)
 {
 	struct spdk_bdev *bdev = &mdisk->disk;
 	struct spdk_dif_ctx dif_ctx;
-	struct iovec iov, md_iov;
+	struct iovec iov, *iovs = &iov, md_iov;
+	uint64_t i, offset_blocks, iovcnt = 1;
 	int rc;
 	struct spdk_dif_ctx_init_ext_opts dif_opts;
 
@@ -590,25 +741,105 @@ malloc_disk_setup_pi(struct malloc_disk *mdisk)
 		return rc;
 	}
 
-	iov.iov_base = mdisk->malloc_buf;
-	iov.iov_len = bdev->blockcnt * bdev->blocklen;
+	if (mdisk->stripes != NULL) {
+		iovcnt = mdisk->num_stripes;
+		iovs = calloc(iovcnt, sizeof(*iovs));
+		if (iovs == NULL) {
+			return -ENOMEM;
+		}
+
+		for (i = 0; i < iovcnt; i++) {
+			offset_blocks = i * mdisk->stripe_blocks;
+			iovs[i].iov_base = mdisk->stripes[i];
+			iovs[i].iov_len = malloc_get_contig_blocks(mdisk, offset_blocks,
+					  bdev->blockcnt - offset_blocks) * bdev->blocklen;
+		}
+	} else {
+		iov.iov_base = mdisk->malloc_buf;
+		iov.iov_len = bdev->blockcnt * bdev->blocklen;
+	}
 
 	if (mdisk->disk.md_interleave) {
-		rc = spdk_dif_generate(&iov, 1, bdev->blockcnt, &dif_ctx);
+		rc = spdk_dif_generate(iovs, iovcnt, bdev->blockcnt, &dif_ctx);
 	} else {
 		md_iov.iov_base = mdisk->malloc_md_buf;
 		md_iov.iov_len = bdev->blockcnt * bdev->md_len;
 
-		rc = spdk_dix_generate(&iov, 1, &md_iov, bdev->blockcnt, &dif_ctx);
+		rc = spdk_dix_generate(iovs, iovcnt, &md_iov, bdev->blockcnt, &dif_ctx);
 	}
 
 	if (rc != 0) {
 		SPDK_ERRLOG("Formatting by DIF/DIX failed\n");
 	}
 
+	if (iovs != &iov) {
+		free(iovs);
+	}
+
 	return rc;
 }
 
+static int
+malloc_get_numa_nodes(int32_t *nodes, int max_nodes)
+{
+	uint32_t core;
+	int32_t node;
+	int i, num_nodes = 0;
+
+	SPDK_ENV_FOREACH_CORE(core) {
+		node = spdk_env_get_socket_id(core);
+		for (i = 0; i < num_nodes; i++) {
+			if (nodes[i] == node) {
+				break;
+			}
+		}
+
+		if (i == num_nodes && num_nodes < max_nodes) {
+			nodes[num_nodes++] = node;
+		}
+	}
+
+	return num_nodes;
+}
+
+/* Allocate the buffer in huge page sized stripes, placed round-robin on the NUMA nodes */
+static int
+malloc_disk_alloc_stripes(struct malloc_disk *mdisk, uint64_t num_blocks, uint32_t block_size)
+{
+	int32_t nodes[MALLOC_MAX_NUMA_NODES];
+	uint64_t i, stripe_size;
+	int num_nodes;
+
+	num_nodes = malloc_get_numa_nodes(nodes, MALLOC_MAX_NUMA_NODES);
+	if (num_nodes == 0) {
+		nodes[num_nodes++] = SPDK_ENV_SOCKET_ID_ANY;
+	}
+
+	mdisk->stripe_blocks = spdk_max(MALLOC_STRIPE_SIZE / block_size, 1);
+	mdisk->num_stripes = spdk_divide_round_up(num_blocks, mdisk->stripe_blocks);
+	mdisk->stripes = calloc(mdisk->num_stripes, sizeof(*mdisk->stripes));
+	if (mdisk->stripes == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < mdisk->num_stripes; i++) {
+		stripe_size = spdk_min(mdisk->stripe_blocks, num_blocks - i * mdisk->stripe_blocks) *
+			      block_size;
+		mdisk->stripes[i] = spdk_zmalloc(stripe_size, MALLOC_STRIPE_SIZE, NULL,
+						 nodes[i % num_nodes], SPDK_MALLOC_DMA);
+		if (mdisk->stripes[i] == NULL) {
+			SPDK_ERRLOG("Failed to allocate stripe %" PRIu64 " on NUMA node %d\n",
+				    i, nodes[i % num_nodes]);
+			return -ENOMEM;
+		}
+	}
+
+	SPDK_DEBUGLOG(bdev_malloc, "Interleaved %" PRIu64 " stripes of %" PRIu64 " blocks across "
+		      "%d NUMA nodes\n", mdisk->num_stripes, mdisk->stripe_blocks, num_nodes);
+
+	return 0;
+}
+
 int
 create_malloc_disk(struct spdk_bdev **bdev, const struct malloc_bdev_opts *opts)
 {
@@ -662,29 +893,48 @@ create_malloc_disk(struct spdk_bdev **bdev, const struct malloc_bdev_opts *opts)
 		return -EINVAL;
 	}
 
+	if (opts->numa_interleave && opts->numa_node != SPDK_ENV_SOCKET_ID_ANY) {
+		SPDK_ERRLOG("NUMA node can't be specified along with NUMA interleaving\n");
+		return -EINVAL;
+	}
+
 	mdisk = calloc(1, sizeof(*mdisk));
 	if (!mdisk) {
 		SPDK_ERRLOG("mdisk calloc() failed\n");
 		return -ENOMEM;
 	}
 
-	/*
-	 * Allocate the large backend memory buffer from pinned memory.
-	 *
-	 * TODO: need to pass a hint so we know which socket to allocate
-	 *  from on multi-socket systems.
-	 */
-	mdisk->malloc_buf = spdk_zmalloc(opts->num_blocks * block_size, 2 * 1024 * 1024, NULL,
-					 SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-	if (!mdisk->malloc_buf) {
-		SPDK_ERRLOG("malloc_buf spdk_zmalloc() failed\n");
-		malloc_disk_free(mdisk);
-		return -ENOMEM;
+	mdisk->numa_node = opts->numa_node;
+	mdisk->inline_copy_threshold = opts->inline_copy_threshold;
+
+	/* Allocate the large backend memory buffer from pinned memory. */
+	if (opts->numa_interleave) {
+		rc = malloc_disk_alloc_stripes(mdisk, opts->num_blocks, block_size);
+		if (rc != 0) {
+			malloc_disk_free(mdisk);
+			return rc;
+		}
+
+		if (opts->optimal_io_boundary != 0 &&
+		    mdisk->stripe_blocks % opts->optimal_io_boundary != 0) {
+			SPDK_ERRLOG("Optimal I/O boundary must divide the stripe size of %" PRIu64
+				    " blocks\n", mdisk->stripe_blocks);
+			malloc_disk_free(mdisk);
+			return -EINVAL;
+		}
+	} else {
+		mdisk->malloc_buf = spdk_zmalloc(opts->num_blocks * block_size, 2 * 1024 * 1024,
+						 NULL, opts->numa_node, SPDK_MALLOC_DMA);
+		if (!mdisk->malloc_buf) {
+			SPDK_ERRLOG("malloc_buf spdk_zmalloc() failed\n");
+			malloc_disk_free(mdisk);
+			return -ENOMEM;
+		}
 	}
 
 	if (!opts->md_interleave && opts->md_size != 0) {
 		mdisk->malloc_md_buf = spdk_zmalloc(opts->num_blocks * opts->md_size, 2 * 1024 * 1024, NULL,
-						    SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+						    opts->numa_node, SPDK_MALLOC_DMA);
 		if (!mdisk->malloc_md_buf) {
 			SPDK_ERRLOG("malloc_md_buf spdk_zmalloc() failed\n");
 			malloc_disk_free(mdisk);
@@ -742,6 +992,10 @@ create_malloc_disk(struct spdk_bdev **bdev, const struct malloc_bdev_opts *opts)
 	if (opts->optimal_io_boundary) {
 		mdisk->disk.optimal_io_boundary = opts->optimal_io_boundary;
 		mdisk->disk.split_on_optimal_io_boundary = true;
+	} else if (mdisk->stripes != NULL) {
+		/* Reads and writes must not cross stripes */
+		mdisk->disk.optimal_io_boundary = mdisk->stripe_blocks;
+		mdisk->disk.split_on_optimal_io_boundary = true;
 	}
 	if (!spdk_uuid_is_null(&opts->uuid)) {
 		spdk_uuid_copy(&mdisk->disk.uuid, &opts->uuid);
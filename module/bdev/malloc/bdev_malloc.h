@@ -24,6 +24,14 @@ struct malloc_bdev_opts {
 	bool md_interleave;
 	enum spdk_dif_type dif_type;
 	bool dif_is_head_of_md;
+	/* NUMA node to allocate the buffer on, or SPDK_ENV_SOCKET_ID_ANY */
+	int32_t numa_node;
+	/* Stripe the buffer across the NUMA nodes of the application's cores */
+	bool numa_interleave;
+	/* Reads and writes up to this many bytes are copied on the submitting thread,
+	 * without going through the accel framework. 0 disables the inline copy.
+	 */
+	uint32_t inline_copy_threshold;
 };
 
 int create_malloc_disk(struct spdk_bdev **bdev, const struct malloc_bdev_opts *opts);
@@ -17,14 +17,48 @@
 
 #include "bdev_null.h"
 
+/* z-score of the 99th percentile of the standard normal distribution */
+#define NULL_MODEL_P99_Z	2.3263478740
+
+struct null_bdev_model {
+	/* Options the model was created with, histogram is replaced by the copy below */
+	struct spdk_null_bdev_model		opts;
+	uint64_t				bandwidth_bytes_per_sec;
+	/* Median service latencies and shapes of their lognormal distributions */
+	uint64_t				read_latency_ticks;
+	uint64_t				write_latency_ticks;
+	double					read_sigma;
+	double					write_sigma;
+	/* Replayed histogram, with cumulative counts */
+	struct spdk_null_bdev_latency_bucket	*histogram;
+	uint32_t				num_buckets;
+
+	/* State of the emulated device, shared by all threads submitting I/O to it */
+	pthread_mutex_t				lock;
+	/* Time at which each of the device's channels is done with the I/O it's servicing */
+	uint64_t				*channel_free_tsc;
+	/* Time at which the data of all I/Os accepted so far has been transferred */
+	uint64_t				bandwidth_free_tsc;
+	uint64_t				rand_state;
+	uint32_t				outstanding;
+};
+
 struct null_bdev {
 	struct spdk_bdev	bdev;
+	struct null_bdev_model	*model;
 	TAILQ_ENTRY(null_bdev)	tailq;
 };
 
+struct null_bdev_io {
+	/* Time at which the emulated device completes the I/O */
+	uint64_t	complete_tsc;
+};
+
 struct null_io_channel {
-	struct spdk_poller		*poller;
-	TAILQ_HEAD(, spdk_bdev_io)	io;
+	struct spdk_poller				*poller;
+	TAILQ_HEAD(, spdk_bdev_io)			io;
+	/* I/Os held by the device model, sorted by their completion time */
+	TAILQ_HEAD(null_delayed_io_head, spdk_bdev_io)	delayed_io;
 };
 
 static TAILQ_HEAD(, null_bdev) g_null_bdev_head = TAILQ_HEAD_INITIALIZER(g_null_bdev_head);
@@ -33,21 +67,249 @@ static void *g_null_read_buf;
 static int bdev_null_initialize(void);
 static void bdev_null_finish(void);
 
+static int
+bdev_null_get_ctx_size(void)
+{
+	return sizeof(struct null_bdev_io);
+}
+
 static struct spdk_bdev_module null_if = {
 	.name = "null",
 	.module_init = bdev_null_initialize,
 	.module_fini = bdev_null_finish,
+	.get_ctx_size = bdev_null_get_ctx_size,
 	.async_fini = true,
 };
 
 SPDK_BDEV_MODULE_REGISTER(null, &null_if)
 
+static void
+null_model_free(struct null_bdev_model *model)
+{
+	if (model == NULL) {
+		return;
+	}
+
+	pthread_mutex_destroy(&model->lock);
+	free(model->channel_free_tsc);
+	free(model->histogram);
+	free(model);
+}
+
+static double
+null_model_sigma(uint32_t latency_us, uint32_t p99_latency_us)
+{
+	if (latency_us == 0 || p99_latency_us <= latency_us) {
+		return 0;
+	}
+
+	return log((double)p99_latency_us / latency_us) / NULL_MODEL_P99_Z;
+}
+
+static int
+null_model_create(const struct spdk_null_bdev_model *opts, struct null_bdev_model **_model)
+{
+	struct null_bdev_model *model;
+	uint64_t ticks_hz = spdk_get_ticks_hz(), total = 0;
+	uint32_t i;
+
+	*_model = NULL;
+	if (opts->num_channels == 0) {
+		return 0;
+	}
+
+	if (opts->num_buckets > SPDK_NULL_BDEV_MAX_LATENCY_BUCKETS ||
+	    (opts->num_buckets != 0 && opts->histogram == NULL)) {
+		SPDK_ERRLOG("Invalid latency histogram\n");
+		return -EINVAL;
+	}
+
+	model = calloc(1, sizeof(*model));
+	if (model == NULL) {
+		return -ENOMEM;
+	}
+
+	model->channel_free_tsc = calloc(opts->num_channels, sizeof(*model->channel_free_tsc));
+	if (model->channel_free_tsc == NULL) {
+		free(model);
+		return -ENOMEM;
+	}
+
+	if (opts->num_buckets != 0) {
+		model->histogram = calloc(opts->num_buckets, sizeof(*model->histogram));
+		if (model->histogram == NULL) {
+			free(model->channel_free_tsc);
+			free(model);
+			return -ENOMEM;
+		}
+
+		for (i = 0; i < opts->num_buckets; i++) {
+			total += opts->histogram[i].count;
+			model->histogram[i].latency_us = opts->histogram[i].latency_us;
+			model->histogram[i].count = total;
+		}
+
+		if (total == 0) {
+			SPDK_ERRLOG("Latency histogram is empty\n");
+			free(model->histogram);
+			free(model->channel_free_tsc);
+			free(model);
+			return -EINVAL;
+		}
+		model->num_buckets = opts->num_buckets;
+	}
+
+	model->opts = *opts;
+	model->opts.histogram = NULL;
+	model->bandwidth_bytes_per_sec = (uint64_t)opts->bandwidth_mbps * 1024 * 1024;
+	model->read_latency_ticks = opts->read_latency_us * ticks_hz / SPDK_SEC_TO_USEC;
+	model->write_latency_ticks = opts->write_latency_us * ticks_hz / SPDK_SEC_TO_USEC;
+	model->read_sigma = null_model_sigma(opts->read_latency_us, opts->read_p99_latency_us);
+	model->write_sigma = null_model_sigma(opts->write_latency_us, opts->write_p99_latency_us);
+	/* Fixed seed, so that runs with the same workload are reproducible */
+	model->rand_state = 0x9e3779b97f4a7c15ULL;
+	pthread_mutex_init(&model->lock, NULL);
+
+	*_model = model;
+
+	return 0;
+}
+
+static uint64_t
+null_model_rand(struct null_bdev_model *model)
+{
+	/* xorshift64* */
+	model->rand_state ^= model->rand_state >> 12;
+	model->rand_state ^= model->rand_state << 25;
+	model->rand_state ^= model->rand_state >> 27;
+
+	return model->rand_state * 0x2545f4914f6cdd1dULL;
+}
+
+/* Uniformly distributed in (0, 1] */
+static double
+null_model_rand_double(struct null_bdev_model *model)
+{
+	return ((null_model_rand(model) >> 11) + 1) * (1.0 / (1ULL << 53));
+}
+
+static uint64_t
+null_model_get_latency(struct null_bdev_model *model, enum spdk_bdev_io_type type)
+{
+	uint64_t latency_ticks, sample;
+	double sigma, z;
+	uint32_t i;
+
+	if (model->histogram != NULL) {
+		sample = null_model_rand(model) % model->histogram[model->num_buckets - 1].count;
+		for (i = 0; i < model->num_buckets - 1; i++) {
+			if (sample < model->histogram[i].count) {
+				break;
+			}
+		}
+
+		return model->histogram[i].latency_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	}
+
+	if (type == SPDK_BDEV_IO_TYPE_READ) {
+		latency_ticks = model->read_latency_ticks;
+		sigma = model->read_sigma;
+	} else {
+		latency_ticks = model->write_latency_ticks;
+		sigma = model->write_sigma;
+	}
+
+	if (sigma == 0) {
+		return latency_ticks;
+	}
+
+	/* Box-Muller transform of two uniform samples into a standard normal one */
+	z = sqrt(-2.0 * log(null_model_rand_double(model))) *
+	    cos(2.0 * M_PI * null_model_rand_double(model));
+
+	return latency_ticks * exp(sigma * z);
+}
+
+/* Get the time at which the emulated device completes the I/O submitted now */
+static uint64_t
+null_model_schedule_io(struct null_bdev_model *model, struct spdk_bdev_io *bdev_io)
+{
+	uint64_t now = spdk_get_ticks(), start, complete, transfer;
+	uint32_t i, channel = 0;
+
+	pthread_mutex_lock(&model->lock);
+
+	/* The I/O waits for the first channel of the device to become available */
+	for (i = 1; i < model->opts.num_channels; i++) {
+		if (model->channel_free_tsc[i] < model->channel_free_tsc[channel]) {
+			channel = i;
+		}
+	}
+	start = spdk_max(now, model->channel_free_tsc[channel]);
+
+	complete = start + null_model_get_latency(model, bdev_io->type) +
+		   (uint64_t)model->opts.qd_latency_ns * model->outstanding * spdk_get_ticks_hz() /
+		   SPDK_SEC_TO_NSEC;
+
+	/* The data of all I/Os is transferred one at a time at the device's bandwidth */
+	if (model->bandwidth_bytes_per_sec != 0 && bdev_io->type != SPDK_BDEV_IO_TYPE_WRITE_ZEROES) {
+		transfer = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+		transfer = transfer * spdk_get_ticks_hz() / model->bandwidth_bytes_per_sec;
+		model->bandwidth_free_tsc = spdk_max(start, model->bandwidth_free_tsc) + transfer;
+		complete = spdk_max(complete, model->bandwidth_free_tsc);
+	}
+
+	model->channel_free_tsc[channel] = complete;
+	model->outstanding++;
+
+	pthread_mutex_unlock(&model->lock);
+
+	return complete;
+}
+
+static void
+null_model_complete_io(struct null_bdev_model *model)
+{
+	pthread_mutex_lock(&model->lock);
+	assert(model->outstanding > 0);
+	model->outstanding--;
+	pthread_mutex_unlock(&model->lock);
+}
+
+static void
+bdev_null_queue_io(struct null_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct null_bdev *null_disk = bdev_io->bdev->ctxt;
+	struct null_bdev_io *null_io = (struct null_bdev_io *)bdev_io->driver_ctx;
+	struct null_bdev_io *tmp_io;
+	struct spdk_bdev_io *tmp;
+
+	if (null_disk->model == NULL) {
+		TAILQ_INSERT_TAIL(&ch->io, bdev_io, module_link);
+		return;
+	}
+
+	null_io->complete_tsc = null_model_schedule_io(null_disk->model, bdev_io);
+
+	/* Completion times mostly increase, so look for the I/O's position from the tail */
+	TAILQ_FOREACH_REVERSE(tmp, &ch->delayed_io, null_delayed_io_head, module_link) {
+		tmp_io = (struct null_bdev_io *)tmp->driver_ctx;
+		if (tmp_io->complete_tsc <= null_io->complete_tsc) {
+			TAILQ_INSERT_AFTER(&ch->delayed_io, tmp, bdev_io, module_link);
+			return;
+		}
+	}
+
+	TAILQ_INSERT_HEAD(&ch->delayed_io, bdev_io, module_link);
+}
+
 static int
 bdev_null_destruct(void *ctx)
 {
 	struct null_bdev *bdev = ctx;
 
 	TAILQ_REMOVE(&g_null_bdev_head, bdev, tailq);
+	null_model_free(bdev->model);
 	free(bdev->bdev.name);
 	free(bdev);
 
@@ -58,6 +320,7 @@ static bool
 bdev_null_abort_io(struct null_io_channel *ch, struct spdk_bdev_io *bio_to_abort)
 {
 	struct spdk_bdev_io *bdev_io;
+	struct null_bdev *null_disk;
 
 	TAILQ_FOREACH(bdev_io, &ch->io, module_link) {
 		if (bdev_io == bio_to_abort) {
@@ -67,6 +330,16 @@ bdev_null_abort_io(struct null_io_channel *ch, struct spdk_bdev_io *bio_to_abort
 		}
 	}
 
+	TAILQ_FOREACH(bdev_io, &ch->delayed_io, module_link) {
+		if (bdev_io == bio_to_abort) {
+			null_disk = bio_to_abort->bdev->ctxt;
+			TAILQ_REMOVE(&ch->delayed_io, bio_to_abort, module_link);
+			null_model_complete_io(null_disk->model);
+			spdk_bdev_io_complete(bio_to_abort, SPDK_BDEV_IO_STATUS_ABORTED);
+			return true;
+		}
+	}
+
 	return false;
 }
 
@@ -128,7 +401,7 @@ bdev_null_submit_request(struct spdk_io_channel *_ch, struct spdk_bdev_io *bdev_
 				return;
 			}
 		}
-		TAILQ_INSERT_TAIL(&ch->io, bdev_io, module_link);
+		bdev_null_queue_io(ch, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
 		if (SPDK_DIF_DISABLE != bdev->dif_type) {
@@ -147,9 +420,11 @@ bdev_null_submit_request(struct spdk_io_channel *_ch, struct spdk_bdev_io *bdev_
 				return;
 			}
 		}
-		TAILQ_INSERT_TAIL(&ch->io, bdev_io, module_link);
+		bdev_null_queue_io(ch, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		bdev_null_queue_io(ch, bdev_io);
+		break;
 	case SPDK_BDEV_IO_TYPE_RESET:
 		TAILQ_INSERT_TAIL(&ch->io, bdev_io, module_link);
 		break;
@@ -191,9 +466,40 @@ bdev_null_get_io_channel(void *ctx)
 	return spdk_get_io_channel(&g_null_bdev_head);
 }
 
+static void
+bdev_null_write_model_json(struct null_bdev_model *model, struct spdk_json_write_ctx *w)
+{
+	struct spdk_null_bdev_latency_bucket *bucket;
+	uint64_t count = 0;
+	uint32_t i;
+
+	spdk_json_write_named_object_begin(w, "model");
+	spdk_json_write_named_uint32(w, "num_channels", model->opts.num_channels);
+	spdk_json_write_named_uint32(w, "bandwidth_mbps", model->opts.bandwidth_mbps);
+	spdk_json_write_named_uint32(w, "read_latency_us", model->opts.read_latency_us);
+	spdk_json_write_named_uint32(w, "write_latency_us", model->opts.write_latency_us);
+	spdk_json_write_named_uint32(w, "read_p99_latency_us", model->opts.read_p99_latency_us);
+	spdk_json_write_named_uint32(w, "write_p99_latency_us", model->opts.write_p99_latency_us);
+	spdk_json_write_named_uint32(w, "qd_latency_ns", model->opts.qd_latency_ns);
+	if (model->histogram != NULL) {
+		spdk_json_write_named_array_begin(w, "histogram");
+		for (i = 0; i < model->num_buckets; i++) {
+			bucket = &model->histogram[i];
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_uint32(w, "latency_us", bucket->latency_us);
+			spdk_json_write_named_uint64(w, "count", bucket->count - count);
+			spdk_json_write_object_end(w);
+			count = bucket->count;
+		}
+		spdk_json_write_array_end(w);
+	}
+	spdk_json_write_object_end(w);
+}
+
 static void
 bdev_null_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 {
+	struct null_bdev *null_disk = bdev->ctxt;
 	char uuid_str[SPDK_UUID_STRING_LEN];
 
 	spdk_json_write_object_begin(w);
@@ -210,6 +516,9 @@ bdev_null_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *
 	spdk_json_write_named_bool(w, "dif_is_head_of_md", bdev->dif_is_head_of_md);
 	spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &bdev->uuid);
 	spdk_json_write_named_string(w, "uuid", uuid_str);
+	if (null_disk->model != NULL) {
+		bdev_null_write_model_json(null_disk->model, w);
+	}
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -265,8 +574,15 @@ bdev_null_create(struct spdk_bdev **bdev, const struct spdk_null_bdev_opts *opts
 		return -ENOMEM;
 	}
 
+	rc = null_model_create(&opts->model, &null_disk->model);
+	if (rc != 0) {
+		free(null_disk);
+		return rc;
+	}
+
 	null_disk->bdev.name = strdup(opts->name);
 	if (!null_disk->bdev.name) {
+		null_model_free(null_disk->model);
 		free(null_disk);
 		return -ENOMEM;
 	}
@@ -306,6 +622,7 @@ bdev_null_create(struct spdk_bdev **bdev, const struct spdk_null_bdev_opts *opts
 
 	rc = spdk_bdev_register(&null_disk->bdev);
 	if (rc) {
+		null_model_free(null_disk->model);
 		free(null_disk->bdev.name);
 		free(null_disk);
 		return rc;
@@ -335,21 +652,38 @@ null_io_poll(void *arg)
 	struct null_io_channel		*ch = arg;
 	TAILQ_HEAD(, spdk_bdev_io)	io;
 	struct spdk_bdev_io		*bdev_io;
+	struct null_bdev		*null_disk;
+	uint64_t			now;
+	int				rc = SPDK_POLLER_IDLE;
 
 	TAILQ_INIT(&io);
 	TAILQ_SWAP(&ch->io, &io, spdk_bdev_io, module_link);
 
-	if (TAILQ_EMPTY(&io)) {
-		return SPDK_POLLER_IDLE;
-	}
-
 	while (!TAILQ_EMPTY(&io)) {
 		bdev_io = TAILQ_FIRST(&io);
 		TAILQ_REMOVE(&io, bdev_io, module_link);
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		rc = SPDK_POLLER_BUSY;
+	}
+
+	if (TAILQ_EMPTY(&ch->delayed_io)) {
+		return rc;
+	}
+
+	now = spdk_get_ticks();
+	while ((bdev_io = TAILQ_FIRST(&ch->delayed_io)) != NULL) {
+		if (((struct null_bdev_io *)bdev_io->driver_ctx)->complete_tsc > now) {
+			break;
+		}
+
+		null_disk = bdev_io->bdev->ctxt;
+		TAILQ_REMOVE(&ch->delayed_io, bdev_io, module_link);
+		null_model_complete_io(null_disk->model);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		rc = SPDK_POLLER_BUSY;
 	}
 
-	return SPDK_POLLER_BUSY;
+	return rc;
 }
 
 static int
@@ -358,6 +692,7 @@ null_bdev_create_cb(void *io_device, void *ctx_buf)
 	struct null_io_channel *ch = ctx_buf;
 
 	TAILQ_INIT(&ch->io);
+	TAILQ_INIT(&ch->delayed_io);
 	ch->poller = SPDK_POLLER_REGISTER(null_io_poll, ch, 0);
 
 	return 0;
@@ -13,6 +13,40 @@ typedef void (*spdk_delete_null_complete)(void *cb_arg, int bdeverrno);
 struct spdk_bdev;
 struct spdk_uuid;
 
+/* Maximum number of buckets of a replayed latency histogram */
+#define SPDK_NULL_BDEV_MAX_LATENCY_BUCKETS	64
+
+struct spdk_null_bdev_latency_bucket {
+	/* Latency of the I/Os in this bucket, in microseconds */
+	uint32_t latency_us;
+	/* Relative number of I/Os with that latency */
+	uint64_t count;
+};
+
+/*
+ * Model of the device emulated by a null bdev. I/Os are held until they would have been completed
+ * by a device servicing num_channels of them at a time, with the given latencies and bandwidth.
+ */
+struct spdk_null_bdev_model {
+	/* Number of I/Os serviced in parallel, 0 disables the model */
+	uint32_t num_channels;
+	/* Bandwidth shared by all I/Os, in MiB/s, 0 for unlimited */
+	uint32_t bandwidth_mbps;
+	/* Median service latencies, in microseconds */
+	uint32_t read_latency_us;
+	uint32_t write_latency_us;
+	/* 99th percentile of the service latencies, in microseconds. If greater than the median,
+	 * latencies follow a lognormal distribution, otherwise they're fixed.
+	 */
+	uint32_t read_p99_latency_us;
+	uint32_t write_p99_latency_us;
+	/* Service latency added for each I/O already outstanding on the device, in nanoseconds */
+	uint32_t qd_latency_ns;
+	/* Histogram to replay the service latencies of all I/Os from, instead of the above */
+	const struct spdk_null_bdev_latency_bucket *histogram;
+	uint32_t num_buckets;
+};
+
 struct spdk_null_bdev_opts {
 	const char *name;
 	const struct spdk_uuid *uuid;
@@ -23,6 +57,7 @@ struct spdk_null_bdev_opts {
 	bool md_interleave;
 	enum spdk_dif_type dif_type;
 	bool dif_is_head_of_md;
+	struct spdk_null_bdev_model model;
 };
 
 int bdev_null_create(struct spdk_bdev **bdev, const struct spdk_null_bdev_opts *opts);
@@ -11,6 +11,12 @@
 
 #include "bdev_null.h"
 
+struct rpc_null_model {
+	struct spdk_null_bdev_model		model;
+	struct spdk_null_bdev_latency_bucket	histogram[SPDK_NULL_BDEV_MAX_LATENCY_BUCKETS];
+	size_t					num_buckets;
+};
+
 struct rpc_construct_null {
 	char *name;
 	char *uuid;
@@ -20,6 +26,7 @@ struct rpc_construct_null {
 	uint32_t md_size;
 	int32_t dif_type;
 	bool dif_is_head_of_md;
+	struct rpc_null_model model;
 };
 
 static void
@@ -29,6 +36,46 @@ free_rpc_construct_null(struct rpc_construct_null *req)
 	free(req->uuid);
 }
 
+static const struct spdk_json_object_decoder rpc_null_latency_bucket_decoders[] = {
+	{"latency_us", offsetof(struct spdk_null_bdev_latency_bucket, latency_us), spdk_json_decode_uint32},
+	{"count", offsetof(struct spdk_null_bdev_latency_bucket, count), spdk_json_decode_uint64},
+};
+
+static int
+rpc_decode_null_latency_bucket(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object(val, rpc_null_latency_bucket_decoders,
+				       SPDK_COUNTOF(rpc_null_latency_bucket_decoders), out);
+}
+
+static int
+rpc_decode_null_histogram(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_null_model *model = SPDK_CONTAINEROF(out, struct rpc_null_model, histogram);
+
+	return spdk_json_decode_array(val, rpc_decode_null_latency_bucket, model->histogram,
+				      SPDK_NULL_BDEV_MAX_LATENCY_BUCKETS, &model->num_buckets,
+				      sizeof(struct spdk_null_bdev_latency_bucket));
+}
+
+static const struct spdk_json_object_decoder rpc_null_model_decoders[] = {
+	{"num_channels", offsetof(struct rpc_null_model, model.num_channels), spdk_json_decode_uint32},
+	{"bandwidth_mbps", offsetof(struct rpc_null_model, model.bandwidth_mbps), spdk_json_decode_uint32, true},
+	{"read_latency_us", offsetof(struct rpc_null_model, model.read_latency_us), spdk_json_decode_uint32, true},
+	{"write_latency_us", offsetof(struct rpc_null_model, model.write_latency_us), spdk_json_decode_uint32, true},
+	{"read_p99_latency_us", offsetof(struct rpc_null_model, model.read_p99_latency_us), spdk_json_decode_uint32, true},
+	{"write_p99_latency_us", offsetof(struct rpc_null_model, model.write_p99_latency_us), spdk_json_decode_uint32, true},
+	{"qd_latency_ns", offsetof(struct rpc_null_model, model.qd_latency_ns), spdk_json_decode_uint32, true},
+	{"histogram", offsetof(struct rpc_null_model, histogram), rpc_decode_null_histogram, true},
+};
+
+static int
+rpc_decode_null_model(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object(val, rpc_null_model_decoders,
+				       SPDK_COUNTOF(rpc_null_model_decoders), out);
+}
+
 static const struct spdk_json_object_decoder rpc_construct_null_decoders[] = {
 	{"name", offsetof(struct rpc_construct_null, name), spdk_json_decode_string},
 	{"uuid", offsetof(struct rpc_construct_null, uuid), spdk_json_decode_string, true},
@@ -38,6 +85,7 @@ static const struct spdk_json_object_decoder rpc_construct_null_decoders[] = {
 	{"md_size", offsetof(struct rpc_construct_null, md_size), spdk_json_decode_uint32, true},
 	{"dif_type", offsetof(struct rpc_construct_null, dif_type), spdk_json_decode_int32, true},
 	{"dif_is_head_of_md", offsetof(struct rpc_construct_null, dif_is_head_of_md), spdk_json_decode_bool, true},
+	{"model", offsetof(struct rpc_construct_null, model), rpc_decode_null_model, true},
 };
 
 static void
@@ -114,6 +162,9 @@ rpc_bdev_null_create(struct spdk_jsonrpc_request *request,
 	opts.md_interleave = true;
 	opts.dif_type = req.dif_type;
 	opts.dif_is_head_of_md = req.dif_is_head_of_md;
+	opts.model = req.model.model;
+	opts.model.histogram = req.model.histogram;
+	opts.model.num_buckets = req.model.num_buckets;
 	rc = bdev_null_create(&bdev, &opts);
 	if (rc) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
@@ -92,6 +92,12 @@ struct nvme_bdev_io {
 	/* How many times the current I/O was retried. */
 	int32_t retry_count;
 
+	/* How many times the current I/O was resubmitted to another I/O path. */
+	uint32_t failover_count;
+
+	/* The qpair the I/O is accounted to by the queue depth limit of its controller. */
+	struct nvme_qpair *qd_qpair;
+
 	/* Current tsc at submit time. */
 	uint64_t submit_tsc;
 };
@@ -128,6 +134,12 @@ static struct spdk_bdev_nvme_opts g_opts = {
 	.transport_tos = 0,
 	.nvme_error_stat = false,
 	.io_path_stat = false,
+	.io_queue_connections = 1,
+	.tcp_zcopy_recv = false,
+	.latency_histograms = false,
+	.io_path_failover_count = 0,
+	.io_path_error_threshold = 0,
+	.discovery_attach_max_concurrency = 32,
 };
 
 #define NVME_HOTPLUG_POLL_PERIOD_MAX			10000000ULL
@@ -860,6 +872,21 @@ nvme_io_path_is_available(struct nvme_io_path *io_path)
 	return true;
 }
 
+/* An I/O path considered failed is selected again once it wasn't used for this long. */
+#define BDEV_NVME_IO_PATH_FAILED_PROBE_MS	1000
+
+/* Return true if the I/O path got io_path_error_threshold path errors in a row recently. */
+static inline bool
+nvme_io_path_is_failed(struct nvme_io_path *io_path)
+{
+	if (spdk_likely(io_path->failed_tsc == 0)) {
+		return false;
+	}
+
+	return spdk_get_ticks() - io_path->failed_tsc <
+	       spdk_get_ticks_hz() * BDEV_NVME_IO_PATH_FAILED_PROBE_MS / 1000;
+}
+
 static inline bool
 nvme_ctrlr_is_failed(struct nvme_ctrlr *nvme_ctrlr)
 {
@@ -942,7 +969,8 @@ _bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 	io_path = start;
 	do {
 		if (spdk_likely(nvme_qpair_is_connected(io_path->qpair) &&
-				!io_path->nvme_ns->ana_state_updating)) {
+				!io_path->nvme_ns->ana_state_updating &&
+				!nvme_io_path_is_failed(io_path))) {
 			switch (io_path->nvme_ns->ana_state) {
 			case SPDK_NVME_ANA_OPTIMIZED_STATE:
 				nbdev_ch->current_io_path = io_path;
@@ -983,7 +1011,8 @@ _bdev_nvme_find_io_path_min_qd(struct nvme_bdev_channel *nbdev_ch)
 			continue;
 		}
 
-		if (spdk_unlikely(io_path->nvme_ns->ana_state_updating)) {
+		if (spdk_unlikely(io_path->nvme_ns->ana_state_updating ||
+				  nvme_io_path_is_failed(io_path))) {
 			continue;
 		}
 
@@ -1014,6 +1043,80 @@ _bdev_nvme_find_io_path_min_qd(struct nvme_bdev_channel *nbdev_ch)
 	return non_optimized;
 }
 
+/* Weight of a new sample in the I/O path latency EWMA is 1 / 2^BDEV_NVME_LATENCY_EWMA_SHIFT. */
+#define BDEV_NVME_LATENCY_EWMA_SHIFT		3
+/* An I/O path not selected for this long is selected once to refresh its latency. */
+#define BDEV_NVME_LATENCY_PROBE_INTERVAL_MS	100
+
+static struct nvme_io_path *
+_bdev_nvme_find_io_path_min_latency(struct nvme_bdev_channel *nbdev_ch)
+{
+	struct nvme_io_path *io_path;
+	struct nvme_io_path *optimized = NULL, *non_optimized = NULL;
+	struct nvme_io_path *opt_probe = NULL, *non_opt_probe = NULL;
+	uint64_t opt_min_cost = UINT64_MAX, non_opt_min_cost = UINT64_MAX;
+	uint64_t now = spdk_get_ticks();
+	uint64_t probe_ticks = spdk_get_ticks_hz() * BDEV_NVME_LATENCY_PROBE_INTERVAL_MS / 1000;
+	uint32_t num_outstanding_reqs;
+	uint64_t cost;
+	bool probe;
+
+	STAILQ_FOREACH(io_path, &nbdev_ch->io_path_list, stailq) {
+		if (spdk_unlikely(!nvme_qpair_is_connected(io_path->qpair))) {
+			/* The device is currently resetting. */
+			continue;
+		}
+
+		if (spdk_unlikely(io_path->nvme_ns->ana_state_updating ||
+				  nvme_io_path_is_failed(io_path))) {
+			continue;
+		}
+
+		/* Estimate the time to complete an I/O submitted now. An I/O path is
+		 * treated as 1 tick latency until its first I/O completes.
+		 */
+		num_outstanding_reqs = spdk_nvme_qpair_get_num_outstanding_reqs(io_path->qpair->qpair);
+		cost = (io_path->latency_ewma_ticks + 1) * (num_outstanding_reqs + 1);
+		probe = now - io_path->last_selected_tsc >= probe_ticks;
+
+		switch (io_path->nvme_ns->ana_state) {
+		case SPDK_NVME_ANA_OPTIMIZED_STATE:
+			if (cost < opt_min_cost) {
+				opt_min_cost = cost;
+				optimized = io_path;
+			}
+			if (probe && opt_probe == NULL) {
+				opt_probe = io_path;
+			}
+			break;
+		case SPDK_NVME_ANA_NON_OPTIMIZED_STATE:
+			if (cost < non_opt_min_cost) {
+				non_opt_min_cost = cost;
+				non_optimized = io_path;
+			}
+			if (probe && non_opt_probe == NULL) {
+				non_opt_probe = io_path;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	/* don't cache io path for BDEV_NVME_MP_SELECTOR_LATENCY selector */
+	if (optimized != NULL) {
+		io_path = opt_probe != NULL ? opt_probe : optimized;
+	} else if (non_optimized != NULL) {
+		io_path = non_opt_probe != NULL ? non_opt_probe : non_optimized;
+	} else {
+		return NULL;
+	}
+
+	io_path->last_selected_tsc = now;
+
+	return io_path;
+}
+
 static inline struct nvme_io_path *
 bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 {
@@ -1031,8 +1134,10 @@ bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 	if (nbdev_ch->mp_policy == BDEV_NVME_MP_POLICY_ACTIVE_PASSIVE ||
 	    nbdev_ch->mp_selector == BDEV_NVME_MP_SELECTOR_ROUND_ROBIN) {
 		return _bdev_nvme_find_io_path(nbdev_ch);
-	} else {
+	} else if (nbdev_ch->mp_selector == BDEV_NVME_MP_SELECTOR_QUEUE_DEPTH) {
 		return _bdev_nvme_find_io_path_min_qd(nbdev_ch);
+	} else {
+		return _bdev_nvme_find_io_path_min_latency(nbdev_ch);
 	}
 }
 
@@ -1302,6 +1407,209 @@ bdev_nvme_update_io_path_stat(struct nvme_bdev_io *bio)
 	}
 }
 
+static inline void
+bdev_nvme_update_io_path_latency(struct nvme_bdev_io *bio)
+{
+	struct nvme_io_path *io_path = bio->io_path;
+	uint64_t tsc_diff = spdk_get_ticks() - bio->submit_tsc;
+
+	if (io_path->latency_ewma_ticks == 0) {
+		io_path->latency_ewma_ticks = tsc_diff;
+	} else {
+		io_path->latency_ewma_ticks = io_path->latency_ewma_ticks -
+					      (io_path->latency_ewma_ticks >> BDEV_NVME_LATENCY_EWMA_SHIFT) +
+					      (tsc_diff >> BDEV_NVME_LATENCY_EWMA_SHIFT);
+	}
+}
+
+/* The queue depth limit of a controller is adjusted at most once per this interval. */
+#define BDEV_NVME_QD_ADJUST_INTERVAL_US		1000
+
+static inline bool
+bdev_nvme_io_type_is_qd_limited(enum spdk_bdev_io_type io_type)
+{
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_COMPARE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Account an I/O to the queue depth limit of its controller, return false if it has to wait.
+ *
+ * Each qpair of the controller is always allowed its fair share of the limit, so that the
+ * threads which submit more I/O can't starve the others.  A qpair can go beyond its share as
+ * long as the controller as a whole is below the limit.
+ */
+static inline bool
+bdev_nvme_io_qd_admit(struct nvme_bdev_io *bio)
+{
+	struct nvme_qpair *nvme_qpair = bio->io_path->qpair;
+	struct nvme_ctrlr *nvme_ctrlr = nvme_qpair->ctrlr;
+	uint32_t limit, num_qpairs, fair_share;
+
+	limit = __atomic_load_n(&nvme_ctrlr->io_qd_limit, __ATOMIC_RELAXED);
+	if (spdk_likely(limit == 0)) {
+		return true;
+	}
+
+	num_qpairs = __atomic_load_n(&nvme_ctrlr->num_io_qpairs, __ATOMIC_RELAXED);
+	fair_share = spdk_max(limit / spdk_max(num_qpairs, 1), 1);
+	if (nvme_qpair->num_outstanding_io >= fair_share &&
+	    __atomic_load_n(&nvme_ctrlr->io_outstanding, __ATOMIC_RELAXED) >= limit) {
+		return false;
+	}
+
+	nvme_qpair->num_outstanding_io++;
+	__atomic_fetch_add(&nvme_ctrlr->io_outstanding, 1, __ATOMIC_RELAXED);
+	bio->qd_qpair = nvme_qpair;
+
+	return true;
+}
+
+/* Adjust the queue depth limit of a controller to its target latency: additive increase while the
+ * latency seen by this qpair is below the target, multiplicative decrease once it's above.
+ */
+static void
+bdev_nvme_io_qd_adjust(struct nvme_qpair *nvme_qpair, uint64_t tsc_diff)
+{
+	struct nvme_ctrlr *nvme_ctrlr = nvme_qpair->ctrlr;
+	uint64_t ewma = nvme_qpair->latency_ewma_ticks;
+	uint64_t now, last_tsc, ticks_hz, target_ticks;
+	uint32_t limit;
+
+	if (ewma == 0) {
+		ewma = tsc_diff;
+	} else {
+		ewma = ewma - (ewma >> BDEV_NVME_LATENCY_EWMA_SHIFT) +
+		       (tsc_diff >> BDEV_NVME_LATENCY_EWMA_SHIFT);
+	}
+	nvme_qpair->latency_ewma_ticks = ewma;
+
+	now = spdk_get_ticks();
+	ticks_hz = spdk_get_ticks_hz();
+	last_tsc = __atomic_load_n(&nvme_ctrlr->io_qd_adjust_tsc, __ATOMIC_RELAXED);
+	if (now - last_tsc < ticks_hz * BDEV_NVME_QD_ADJUST_INTERVAL_US / SPDK_SEC_TO_USEC) {
+		return;
+	}
+
+	/* Only one thread adjusts the limit per interval */
+	if (!__atomic_compare_exchange_n(&nvme_ctrlr->io_qd_adjust_tsc, &last_tsc, now, false,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		return;
+	}
+
+	limit = __atomic_load_n(&nvme_ctrlr->io_qd_limit, __ATOMIC_RELAXED);
+	target_ticks = ticks_hz * nvme_ctrlr->opts.io_target_latency_us / SPDK_SEC_TO_USEC;
+	if (ewma > target_ticks) {
+		limit = spdk_max(limit - limit / 4, 1);
+	} else if (limit < nvme_ctrlr->opts.io_queue_depth_limit) {
+		limit++;
+	}
+	__atomic_store_n(&nvme_ctrlr->io_qd_limit, limit, __ATOMIC_RELAXED);
+}
+
+static inline void
+bdev_nvme_io_qd_release(struct nvme_bdev_io *bio, bool success)
+{
+	struct nvme_qpair *nvme_qpair = bio->qd_qpair;
+
+	if (spdk_likely(nvme_qpair == NULL)) {
+		return;
+	}
+
+	bio->qd_qpair = NULL;
+	nvme_qpair->num_outstanding_io--;
+	__atomic_fetch_sub(&nvme_qpair->ctrlr->io_outstanding, 1, __ATOMIC_RELAXED);
+
+	if (success && nvme_qpair->ctrlr->opts.io_target_latency_us != 0) {
+		bdev_nvme_io_qd_adjust(nvme_qpair, spdk_get_ticks() - bio->submit_tsc);
+	}
+}
+
+static inline void
+bdev_nvme_io_path_clear_errors(struct nvme_io_path *io_path)
+{
+	io_path->num_consecutive_errors = 0;
+	io_path->failed_tsc = 0;
+}
+
+static void
+bdev_nvme_io_path_add_error(struct nvme_bdev_channel *nbdev_ch, struct nvme_io_path *io_path)
+{
+	if (g_opts.io_path_error_threshold == 0 ||
+	    ++io_path->num_consecutive_errors < g_opts.io_path_error_threshold) {
+		return;
+	}
+
+	if (io_path->failed_tsc == 0) {
+		SPDK_DEBUGLOG(bdev_nvme, "I/O path of %s to cntlid %u failed %u times in a row\n",
+			      io_path->nvme_ns->bdev->disk.name,
+			      spdk_nvme_ctrlr_get_data(io_path->qpair->ctrlr->ctrlr)->cntlid,
+			      io_path->num_consecutive_errors);
+	}
+
+	io_path->failed_tsc = spdk_get_ticks();
+	if (nbdev_ch->current_io_path == io_path) {
+		bdev_nvme_clear_current_io_path(nbdev_ch);
+	}
+}
+
+/* Find an I/O path other than failed_path to resubmit an I/O to, preferring optimized ones. */
+static struct nvme_io_path *
+bdev_nvme_find_failover_io_path(struct nvme_bdev_channel *nbdev_ch,
+				struct nvme_io_path *failed_path)
+{
+	struct nvme_io_path *io_path, *non_optimized = NULL;
+
+	STAILQ_FOREACH(io_path, &nbdev_ch->io_path_list, stailq) {
+		if (io_path == failed_path || !nvme_io_path_is_available(io_path) ||
+		    nvme_io_path_is_failed(io_path)) {
+			continue;
+		}
+
+		if (io_path->nvme_ns->ana_state == SPDK_NVME_ANA_OPTIMIZED_STATE) {
+			return io_path;
+		}
+
+		if (non_optimized == NULL) {
+			non_optimized = io_path;
+		}
+	}
+
+	return non_optimized;
+}
+
+/* Resubmit an I/O which failed on failed_path to another I/O path right away, if there is one. */
+static bool
+bdev_nvme_failover_io(struct nvme_bdev_channel *nbdev_ch, struct nvme_bdev_io *bio,
+		      struct nvme_io_path *failed_path)
+{
+	struct nvme_io_path *io_path;
+
+	if (bio->failover_count >= g_opts.io_path_failover_count) {
+		return false;
+	}
+
+	io_path = bdev_nvme_find_failover_io_path(nbdev_ch, failed_path);
+	if (io_path == NULL) {
+		return false;
+	}
+
+	bio->failover_count++;
+	bio->io_path = io_path;
+	bio->submit_tsc = spdk_get_ticks();
+	_bdev_nvme_submit_request(nbdev_ch, spdk_bdev_io_from_ctx(bio));
+
+	return true;
+}
+
 static bool
 bdev_nvme_check_retry_io(struct nvme_bdev_io *bio,
 			 const struct spdk_nvme_cpl *cpl,
@@ -1318,6 +1626,7 @@ bdev_nvme_check_retry_io(struct nvme_bdev_io *bio,
 	    !nvme_ctrlr_is_available(nvme_ctrlr)) {
 		bdev_nvme_clear_current_io_path(nbdev_ch);
 		bio->io_path = NULL;
+		bdev_nvme_io_path_add_error(nbdev_ch, io_path);
 		if (spdk_nvme_cpl_is_ana_error(cpl)) {
 			if (nvme_ctrlr_read_ana_log_page(nvme_ctrlr) == 0) {
 				io_path->nvme_ns->ana_state_updating = true;
@@ -1348,12 +1657,23 @@ bdev_nvme_io_complete_nvme_status(struct nvme_bdev_io *bio,
 {
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
 	struct nvme_bdev_channel *nbdev_ch;
+	struct nvme_io_path *failed_path;
 	uint64_t delay_ms;
 
 	assert(!bdev_nvme_io_type_is_admin(bdev_io->type));
 
+	bdev_nvme_io_qd_release(bio, spdk_nvme_cpl_is_success(cpl));
+
 	if (spdk_likely(spdk_nvme_cpl_is_success(cpl))) {
+		if (spdk_unlikely(bio->io_path->num_consecutive_errors != 0)) {
+			bdev_nvme_io_path_clear_errors(bio->io_path);
+		}
 		bdev_nvme_update_io_path_stat(bio);
+
+		nbdev_ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+		if (nbdev_ch->mp_selector == BDEV_NVME_MP_SELECTOR_LATENCY) {
+			bdev_nvme_update_io_path_latency(bio);
+		}
 		goto complete;
 	}
 
@@ -1374,14 +1694,20 @@ bdev_nvme_io_complete_nvme_status(struct nvme_bdev_io *bio,
 	}
 
 	nbdev_ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+	failed_path = bio->io_path;
 
 	if (bdev_nvme_check_retry_io(bio, cpl, nbdev_ch, &delay_ms)) {
+		/* The I/O path was dropped if the I/O failed because of it */
+		if (bio->io_path == NULL && bdev_nvme_failover_io(nbdev_ch, bio, failed_path)) {
+			return;
+		}
 		bdev_nvme_queue_retry_io(nbdev_ch, bio, delay_ms);
 		return;
 	}
 
 complete:
 	bio->retry_count = 0;
+	bio->failover_count = 0;
 	bio->submit_tsc = 0;
 	bdev_io->u.bdev.accel_sequence = NULL;
 	__bdev_nvme_io_complete(bdev_io, 0, cpl);
@@ -1392,10 +1718,13 @@ bdev_nvme_io_complete(struct nvme_bdev_io *bio, int rc)
 {
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
 	struct nvme_bdev_channel *nbdev_ch;
+	struct nvme_io_path *failed_path;
 	enum spdk_bdev_io_status io_status;
 
 	assert(!bdev_nvme_io_type_is_admin(bdev_io->type));
 
+	bdev_nvme_io_qd_release(bio, false);
+
 	switch (rc) {
 	case 0:
 		io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
@@ -1405,10 +1734,15 @@ bdev_nvme_io_complete(struct nvme_bdev_io *bio, int rc)
 		break;
 	case -ENXIO:
 		nbdev_ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+		failed_path = bio->io_path;
 
 		bdev_nvme_clear_current_io_path(nbdev_ch);
 		bio->io_path = NULL;
 
+		if (failed_path != NULL && bdev_nvme_failover_io(nbdev_ch, bio, failed_path)) {
+			return;
+		}
+
 		if (any_io_path_may_become_available(nbdev_ch)) {
 			bdev_nvme_queue_retry_io(nbdev_ch, bio, 1000ULL);
 			return;
@@ -1423,6 +1757,7 @@ bdev_nvme_io_complete(struct nvme_bdev_io *bio, int rc)
 	}
 
 	bio->retry_count = 0;
+	bio->failover_count = 0;
 	bio->submit_tsc = 0;
 	__bdev_nvme_io_complete(bdev_io, io_status, NULL);
 }
@@ -1731,12 +2066,22 @@ bdev_nvme_create_qpair(struct nvme_qpair *nvme_qpair)
 	opts.async_mode = true;
 	opts.io_queue_requests = spdk_max(g_opts.io_queue_requests, opts.io_queue_requests);
 	g_opts.io_queue_requests = opts.io_queue_requests;
+	if (spdk_nvme_ctrlr_is_fabrics(nvme_ctrlr->ctrlr)) {
+		opts.num_connections = g_opts.io_queue_connections;
+	}
 
 	qpair = spdk_nvme_ctrlr_alloc_io_qpair(nvme_ctrlr->ctrlr, &opts, sizeof(opts));
 	if (qpair == NULL) {
 		return -1;
 	}
 
+	if (g_opts.latency_histograms) {
+		rc = spdk_nvme_qpair_enable_latency_tracking(qpair);
+		if (rc != 0) {
+			SPDK_WARNLOG("Unable to track the latency of I/O qpair: %s\n", spdk_strerror(-rc));
+		}
+	}
+
 	SPDK_DTRACE_PROBE3(bdev_nvme_create_qpair, nvme_ctrlr->nbdev_ctrlr->name,
 			   spdk_nvme_qpair_get_id(qpair), spdk_thread_get_id(nvme_ctrlr->thread));
 
@@ -2917,6 +3262,12 @@ _bdev_nvme_submit_request(struct nvme_bdev_channel *nbdev_ch, struct spdk_bdev_i
 	struct nvme_bdev_io *nbdev_io_to_abort;
 	int rc = 0;
 
+	if (bdev_nvme_io_type_is_qd_limited(bdev_io->type) &&
+	    spdk_unlikely(!bdev_nvme_io_qd_admit(nbdev_io))) {
+		bdev_nvme_io_complete(nbdev_io, -ENOMEM);
+		return;
+	}
+
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
 		if (bdev_io->u.bdev.iovs && bdev_io->u.bdev.iovs[0].iov_base) {
@@ -3203,6 +3554,7 @@ nvme_qpair_create(struct nvme_ctrlr *nvme_ctrlr, struct nvme_ctrlr_channel *ctrl
 	TAILQ_INSERT_TAIL(&nvme_qpair->group->qpair_list, nvme_qpair, tailq);
 
 	ctrlr_ch->qpair = nvme_qpair;
+	__atomic_fetch_add(&nvme_ctrlr->num_io_qpairs, 1, __ATOMIC_RELAXED);
 
 	pthread_mutex_lock(&nvme_qpair->ctrlr->mutex);
 	nvme_qpair->ctrlr->ref++;
@@ -3211,6 +3563,29 @@ nvme_qpair_create(struct nvme_ctrlr *nvme_ctrlr, struct nvme_ctrlr_channel *ctrl
 	return 0;
 }
 
+/* Let schedulers keep the thread on the socket of the first PCIe controller it does I/O to. */
+static void
+nvme_ctrlr_set_thread_numa_affinity(struct nvme_ctrlr *nvme_ctrlr)
+{
+	struct spdk_thread *thread = spdk_get_thread();
+	struct spdk_pci_device *pci_dev;
+	int socket_id;
+
+	if (spdk_thread_get_numa_affinity(thread) != SPDK_ENV_SOCKET_ID_ANY) {
+		return;
+	}
+
+	pci_dev = spdk_nvme_ctrlr_get_pci_device(nvme_ctrlr->ctrlr);
+	if (pci_dev == NULL) {
+		return;
+	}
+
+	socket_id = spdk_pci_device_get_socket_id(pci_dev);
+	if (socket_id >= 0) {
+		spdk_thread_set_numa_affinity(thread, socket_id);
+	}
+}
+
 static int
 bdev_nvme_create_ctrlr_channel_cb(void *io_device, void *ctx_buf)
 {
@@ -3218,6 +3593,7 @@ bdev_nvme_create_ctrlr_channel_cb(void *io_device, void *ctx_buf)
 	struct nvme_ctrlr_channel *ctrlr_ch = ctx_buf;
 
 	TAILQ_INIT(&ctrlr_ch->pending_resets);
+	nvme_ctrlr_set_thread_numa_affinity(nvme_ctrlr);
 
 	return nvme_qpair_create(nvme_ctrlr, ctrlr_ch);
 }
@@ -3238,6 +3614,7 @@ nvme_qpair_delete(struct nvme_qpair *nvme_qpair)
 
 	spdk_put_io_channel(spdk_io_channel_from_ctx(nvme_qpair->group));
 
+	__atomic_fetch_sub(&nvme_qpair->ctrlr->num_io_qpairs, 1, __ATOMIC_RELAXED);
 	nvme_ctrlr_release(nvme_qpair->ctrlr);
 
 	free(nvme_qpair);
@@ -3548,6 +3925,17 @@ nvme_ctrlr_info_json(struct spdk_json_write_ctx *w, struct nvme_ctrlr *nvme_ctrl
 	spdk_json_write_named_string(w, "svcid", opts->src_svcid);
 	spdk_json_write_object_end(w);
 
+	if (nvme_ctrlr->opts.io_queue_depth_limit != 0) {
+		spdk_json_write_named_object_begin(w, "io_queue_depth");
+		spdk_json_write_named_uint32(w, "limit",
+					     __atomic_load_n(&nvme_ctrlr->io_qd_limit,
+							     __ATOMIC_RELAXED));
+		spdk_json_write_named_uint32(w, "outstanding",
+					     __atomic_load_n(&nvme_ctrlr->io_outstanding,
+							     __ATOMIC_RELAXED));
+		spdk_json_write_object_end(w);
+	}
+
 	spdk_json_write_object_end(w);
 }
 
@@ -5303,6 +5691,7 @@ nvme_ctrlr_create(struct spdk_nvme_ctrlr *ctrlr,
 	} else {
 		bdev_nvme_get_default_ctrlr_opts(&nvme_ctrlr->opts);
 	}
+	nvme_ctrlr->io_qd_limit = nvme_ctrlr->opts.io_queue_depth_limit;
 
 	nvme_ctrlr->adminq_timer_poller = SPDK_POLLER_REGISTER(bdev_nvme_poll_adminq, nvme_ctrlr,
 					  g_opts.nvme_adminq_poll_period_us);
@@ -5353,6 +5742,8 @@ bdev_nvme_get_default_ctrlr_opts(struct nvme_ctrlr_opts *opts)
 	opts->ctrlr_loss_timeout_sec = g_opts.ctrlr_loss_timeout_sec;
 	opts->reconnect_delay_sec = g_opts.reconnect_delay_sec;
 	opts->fast_io_fail_timeout_sec = g_opts.fast_io_fail_timeout_sec;
+	opts->io_queue_depth_limit = 0;
+	opts->io_target_latency_us = 0;
 }
 
 static void
@@ -5504,6 +5895,11 @@ bdev_nvme_validate_opts(const struct spdk_bdev_nvme_opts *opts)
 		return -EINVAL;
 	}
 
+	if (opts->io_queue_connections == 0 || opts->io_queue_connections > UINT16_MAX) {
+		SPDK_WARNLOG("Invalid option: io_queue_connections must be between 1 and %u.\n", UINT16_MAX);
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -5524,11 +5920,14 @@ bdev_nvme_set_opts(const struct spdk_bdev_nvme_opts *opts)
 		}
 	}
 
-	if (opts->rdma_srq_size != 0) {
+	if (opts->rdma_srq_size != 0 || opts->tcp_zcopy_recv != g_opts.tcp_zcopy_recv) {
 		struct spdk_nvme_transport_opts drv_opts;
 
 		spdk_nvme_transport_get_opts(&drv_opts, sizeof(drv_opts));
-		drv_opts.rdma_srq_size = opts->rdma_srq_size;
+		if (opts->rdma_srq_size != 0) {
+			drv_opts.rdma_srq_size = opts->rdma_srq_size;
+		}
+		drv_opts.tcp_zcopy_recv = opts->tcp_zcopy_recv;
 
 		ret = spdk_nvme_transport_set_opts(&drv_opts, sizeof(drv_opts));
 		if (ret) {
@@ -5911,6 +6310,12 @@ bdev_nvme_create(struct spdk_nvme_transport_id *trid,
 		return -EINVAL;
 	}
 
+	if (bdev_opts != NULL && bdev_opts->io_target_latency_us != 0 &&
+	    bdev_opts->io_queue_depth_limit == 0) {
+		SPDK_ERRLOG("io_target_latency_us requires io_queue_depth_limit to be set.\n");
+		return -EINVAL;
+	}
+
 	ctx = calloc(1, sizeof(*ctx));
 	if (!ctx) {
 		return -ENOMEM;
@@ -6131,6 +6536,7 @@ struct discovery_entry_ctx {
 	struct spdk_nvmf_discovery_log_page_entry	entry;
 	TAILQ_ENTRY(discovery_entry_ctx)		tailq;
 	struct discovery_ctx				*ctx;
+	uint64_t					start_ticks;
 };
 
 struct discovery_ctx {
@@ -6150,6 +6556,8 @@ struct discovery_ctx {
 	TAILQ_ENTRY(discovery_ctx)		tailq;
 	TAILQ_HEAD(, discovery_entry_ctx)	nvm_entry_ctxs;
 	TAILQ_HEAD(, discovery_entry_ctx)	discovery_entry_ctxs;
+	/* Newly discovered NVM subsystems waiting for an attach slot. */
+	TAILQ_HEAD(, discovery_entry_ctx)	pending_entry_ctxs;
 	int					rc;
 	bool					wait_for_attach;
 	uint64_t				timeout_ticks;
@@ -6180,6 +6588,13 @@ struct discovery_ctx {
 	struct spdk_thread			*calling_thread;
 	uint32_t				index;
 	uint32_t				attach_in_progress;
+	/* Summary of the attaches started by the current discovery log page. */
+	struct {
+		uint64_t			start_ticks;
+		uint32_t			num_ctrlrs;
+		uint32_t			num_failed;
+		size_t				num_bdevs;
+	} attach_batch;
 	char					*hostnqn;
 
 	/* Denotes if the discovery service was started by the mdns discovery.
@@ -6286,9 +6701,18 @@ _stop_discovery(void *_ctx)
 static void
 stop_discovery(struct discovery_ctx *ctx, spdk_bdev_nvme_stop_discovery_fn cb_fn, void *cb_ctx)
 {
+	struct discovery_entry_ctx *entry_ctx;
+
 	ctx->stop_cb_fn = cb_fn;
 	ctx->cb_ctx = cb_ctx;
 
+	/* Attaches which haven't been started yet are simply dropped */
+	while (!TAILQ_EMPTY(&ctx->pending_entry_ctxs)) {
+		entry_ctx = TAILQ_FIRST(&ctx->pending_entry_ctxs);
+		TAILQ_REMOVE(&ctx->pending_entry_ctxs, entry_ctx, tailq);
+		free(entry_ctx);
+	}
+
 	if (ctx->attach_in_progress > 0) {
 		DISCOVERY_INFOLOG(ctx, "stopping discovery with attach_in_progress: %"PRIu32"\n",
 				  ctx->attach_in_progress);
@@ -6378,15 +6802,79 @@ complete_discovery_start(struct discovery_ctx *ctx, int status)
 	}
 }
 
+static void discovery_attach_controller_done(void *cb_ctx, size_t bdev_count, int rc);
+
+/* Start attaching the pending NVM subsystems, keeping at most discovery_attach_max_concurrency
+ * of them in progress at a time.
+ */
+static void
+discovery_attach_pending_controllers(struct discovery_ctx *ctx)
+{
+	struct discovery_entry_ctx *entry_ctx;
+	int rc;
+
+	while (!TAILQ_EMPTY(&ctx->pending_entry_ctxs)) {
+		if (g_opts.discovery_attach_max_concurrency != 0 &&
+		    ctx->attach_in_progress >= g_opts.discovery_attach_max_concurrency) {
+			break;
+		}
+
+		entry_ctx = TAILQ_FIRST(&ctx->pending_entry_ctxs);
+		TAILQ_REMOVE(&ctx->pending_entry_ctxs, entry_ctx, tailq);
+		entry_ctx->start_ticks = spdk_get_ticks();
+		rc = bdev_nvme_create(&entry_ctx->trid, entry_ctx->name, NULL, 0,
+				      discovery_attach_controller_done, entry_ctx,
+				      &entry_ctx->drv_opts, &ctx->bdev_opts, true);
+		if (rc == 0) {
+			TAILQ_INSERT_TAIL(&ctx->nvm_entry_ctxs, entry_ctx, tailq);
+			ctx->attach_in_progress++;
+		} else {
+			DISCOVERY_ERRLOG(ctx, "bdev_nvme_create failed (%s)\n", spdk_strerror(-rc));
+			ctx->attach_batch.num_failed++;
+			free(entry_ctx);
+		}
+	}
+}
+
+static void
+discovery_attach_batch_done(struct discovery_ctx *ctx)
+{
+	uint64_t elapsed_us;
+
+	if (ctx->attach_batch.num_ctrlrs == 0 && ctx->attach_batch.num_failed == 0) {
+		return;
+	}
+
+	elapsed_us = (spdk_get_ticks() - ctx->attach_batch.start_ticks) * SPDK_SEC_TO_USEC /
+		     spdk_get_ticks_hz();
+	DISCOVERY_INFOLOG(ctx, "attached %"PRIu32" controllers (%"PRIu32" failed) with %zu bdevs "
+			  "in %"PRIu64" us\n", ctx->attach_batch.num_ctrlrs,
+			  ctx->attach_batch.num_failed, ctx->attach_batch.num_bdevs, elapsed_us);
+	memset(&ctx->attach_batch, 0, sizeof(ctx->attach_batch));
+}
+
 static void
 discovery_attach_controller_done(void *cb_ctx, size_t bdev_count, int rc)
 {
 	struct discovery_entry_ctx *entry_ctx = cb_ctx;
 	struct discovery_ctx *ctx = entry_ctx->ctx;
+	uint64_t elapsed_us;
+
+	elapsed_us = (spdk_get_ticks() - entry_ctx->start_ticks) * SPDK_SEC_TO_USEC /
+		     spdk_get_ticks_hz();
+	DISCOVERY_INFOLOG(ctx, "attach %s done in %"PRIu64" us: %zu bdevs, rc %d\n",
+			  entry_ctx->name, elapsed_us, bdev_count, rc);
+	if (rc == 0) {
+		ctx->attach_batch.num_ctrlrs++;
+		ctx->attach_batch.num_bdevs += bdev_count;
+	} else {
+		ctx->attach_batch.num_failed++;
+	}
 
-	DISCOVERY_INFOLOG(ctx, "attach %s done\n", entry_ctx->name);
 	ctx->attach_in_progress--;
+	discovery_attach_pending_controllers(ctx);
 	if (ctx->attach_in_progress == 0) {
+		discovery_attach_batch_done(ctx);
 		complete_discovery_start(ctx, ctx->rc);
 		if (ctx->initializing && ctx->rc != 0) {
 			DISCOVERY_ERRLOG(ctx, "stopping discovery due to errors: %d\n", ctx->rc);
@@ -6477,6 +6965,15 @@ discovery_log_page_cb(void *cb_arg, int rc, const struct spdk_nvme_cpl *cpl,
 					break;
 				}
 			}
+			/* Another path of a subsystem found earlier in this log page */
+			if (subnqn_ctx == NULL) {
+				TAILQ_FOREACH(subnqn_ctx, &ctx->pending_entry_ctxs, tailq) {
+					if (!memcmp(subnqn_ctx->entry.subnqn, new_entry->subnqn,
+						    sizeof(new_entry->subnqn))) {
+						break;
+					}
+				}
+			}
 
 			new_ctx = calloc(1, sizeof(*new_ctx));
 			if (new_ctx == NULL) {
@@ -6500,19 +6997,14 @@ discovery_log_page_cb(void *cb_arg, int rc, const struct spdk_nvme_cpl *cpl,
 			}
 			spdk_nvme_ctrlr_get_default_ctrlr_opts(&new_ctx->drv_opts, sizeof(new_ctx->drv_opts));
 			snprintf(new_ctx->drv_opts.hostnqn, sizeof(new_ctx->drv_opts.hostnqn), "%s", ctx->hostnqn);
-			rc = bdev_nvme_create(&new_ctx->trid, new_ctx->name, NULL, 0,
-					      discovery_attach_controller_done, new_ctx,
-					      &new_ctx->drv_opts, &ctx->bdev_opts, true);
-			if (rc == 0) {
-				TAILQ_INSERT_TAIL(&ctx->nvm_entry_ctxs, new_ctx, tailq);
-				ctx->attach_in_progress++;
-			} else {
-				DISCOVERY_ERRLOG(ctx, "bdev_nvme_create failed (%s)\n", spdk_strerror(-rc));
-			}
+			TAILQ_INSERT_TAIL(&ctx->pending_entry_ctxs, new_ctx, tailq);
 		}
 	}
 
+	ctx->attach_batch.start_ticks = spdk_get_ticks();
+	discovery_attach_pending_controllers(ctx);
 	if (ctx->attach_in_progress == 0) {
+		discovery_attach_batch_done(ctx);
 		discovery_remove_controllers(ctx);
 	}
 }
@@ -6751,6 +7243,7 @@ bdev_nvme_start_discovery(struct spdk_nvme_transport_id *trid,
 				     spdk_get_ticks_hz() / 1000ull;
 	}
 	TAILQ_INIT(&ctx->nvm_entry_ctxs);
+	TAILQ_INIT(&ctx->pending_entry_ctxs);
 	TAILQ_INIT(&ctx->discovery_entry_ctxs);
 	memcpy(&ctx->trid, trid, sizeof(*trid));
 	/* Even if user did not specify hostnqn, we can still strdup("\0"); */
@@ -7870,6 +8363,13 @@ bdev_nvme_opts_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_bool(w, "generate_uuids", g_opts.generate_uuids);
 	spdk_json_write_named_uint8(w, "transport_tos", g_opts.transport_tos);
 	spdk_json_write_named_bool(w, "io_path_stat", g_opts.io_path_stat);
+	spdk_json_write_named_uint32(w, "io_queue_connections", g_opts.io_queue_connections);
+	spdk_json_write_named_bool(w, "tcp_zcopy_recv", g_opts.tcp_zcopy_recv);
+	spdk_json_write_named_bool(w, "latency_histograms", g_opts.latency_histograms);
+	spdk_json_write_named_uint32(w, "io_path_failover_count", g_opts.io_path_failover_count);
+	spdk_json_write_named_uint32(w, "io_path_error_threshold", g_opts.io_path_error_threshold);
+	spdk_json_write_named_uint32(w, "discovery_attach_max_concurrency",
+				     g_opts.discovery_attach_max_concurrency);
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -7934,6 +8434,10 @@ nvme_ctrlr_config_json(struct spdk_json_write_ctx *w,
 	spdk_json_write_named_uint32(w, "reconnect_delay_sec", nvme_ctrlr->opts.reconnect_delay_sec);
 	spdk_json_write_named_uint32(w, "fast_io_fail_timeout_sec",
 				     nvme_ctrlr->opts.fast_io_fail_timeout_sec);
+	spdk_json_write_named_uint32(w, "io_queue_depth_limit",
+				     nvme_ctrlr->opts.io_queue_depth_limit);
+	spdk_json_write_named_uint32(w, "io_target_latency_us",
+				     nvme_ctrlr->opts.io_target_latency_us);
 	if (nvme_ctrlr->opts.psk_path[0] != '\0') {
 		spdk_json_write_named_string(w, "psk", nvme_ctrlr->opts.psk_path);
 	}
@@ -8034,6 +8538,7 @@ nvme_io_path_info_json(struct spdk_json_write_ctx *w, struct nvme_io_path *io_pa
 				   io_path == io_path->nbdev_ch->current_io_path);
 	spdk_json_write_named_bool(w, "connected", nvme_qpair_is_connected(io_path->qpair));
 	spdk_json_write_named_bool(w, "accessible", nvme_ns_is_accessible(nvme_ns));
+	spdk_json_write_named_bool(w, "failed", nvme_io_path_is_failed(io_path));
 
 	spdk_json_write_named_object_begin(w, "transport");
 	spdk_json_write_named_string(w, "trtype", trid->trstring);
@@ -31,6 +31,7 @@ enum bdev_nvme_multipath_policy {
 enum bdev_nvme_multipath_selector {
 	BDEV_NVME_MP_SELECTOR_ROUND_ROBIN = 1,
 	BDEV_NVME_MP_SELECTOR_QUEUE_DEPTH,
+	BDEV_NVME_MP_SELECTOR_LATENCY,
 };
 
 typedef void (*spdk_bdev_create_nvme_fn)(void *ctx, size_t bdev_count, int rc);
@@ -45,6 +46,10 @@ struct nvme_ctrlr_opts {
 	bool from_discovery_service;
 	/* Path to the file containing PSK, used for dumping configuration. */
 	char psk_path[PATH_MAX];
+	/* Maximum number of I/O outstanding on the controller across all threads, 0 for no limit. */
+	uint32_t io_queue_depth_limit;
+	/* Latency the queue depth limit is adjusted to, 0 to keep io_queue_depth_limit as is. */
+	uint32_t io_target_latency_us;
 };
 
 struct nvme_async_probe_ctx {
@@ -155,6 +160,12 @@ struct nvme_ctrlr {
 
 	struct nvme_async_probe_ctx		*probe_ctx;
 
+	/* The following are shared by all threads to limit the I/O outstanding on the controller. */
+	uint32_t				io_qd_limit;
+	uint32_t				io_outstanding;
+	uint32_t				num_io_qpairs;
+	uint64_t				io_qd_adjust_tsc;
+
 	pthread_mutex_t				mutex;
 };
 
@@ -194,6 +205,10 @@ struct nvme_qpair {
 	/* The following is used to update io_path cache of nvme_bdev_channels. */
 	TAILQ_HEAD(, nvme_io_path)	io_path_list;
 
+	/* The following are used by the queue depth limit of the controller. */
+	uint32_t			num_outstanding_io;
+	uint64_t			latency_ewma_ticks;
+
 	TAILQ_ENTRY(nvme_qpair)		tailq;
 };
 
@@ -216,6 +231,14 @@ struct nvme_io_path {
 
 	/* allocation of stat is decided by option io_path_stat of RPC bdev_nvme_set_options */
 	struct spdk_bdev_io_stat	*stat;
+
+	/* The following are used by the latency selector. */
+	uint64_t			latency_ewma_ticks;
+	uint64_t			last_selected_tsc;
+
+	/* The following are used to detect a failing I/O path before its qpair is disconnected. */
+	uint32_t			num_consecutive_errors;
+	uint64_t			failed_tsc;
 };
 
 struct nvme_bdev_channel {
@@ -296,6 +319,22 @@ struct spdk_bdev_nvme_opts {
 	bool nvme_error_stat;
 	uint32_t rdma_srq_size;
 	bool io_path_stat;
+	/* The number of connections each I/O qpair of a fabrics controller is striped across. */
+	uint32_t io_queue_connections;
+	/* Receive C2H data of TCP I/O qpairs directly into the I/O buffers. */
+	bool tcp_zcopy_recv;
+	/* Track the latency of the I/O completed by each qpair. */
+	bool latency_histograms;
+	/* The number of times an I/O failing with a path error is resubmitted to another I/O path
+	 * right away instead of waiting to be retried.
+	 */
+	uint32_t io_path_failover_count;
+	/* The number of consecutive path errors after which an I/O path isn't selected anymore. */
+	uint32_t io_path_error_threshold;
+	/* The number of NVM subsystems found by a discovery service that are attached in parallel.
+	 * 0 means unlimited.
+	 */
+	uint32_t discovery_attach_max_concurrency;
 };
 
 struct spdk_nvme_qpair *bdev_nvme_get_io_qpair(struct spdk_io_channel *ctrlr_io_ch);
@@ -20,6 +20,8 @@
 
 #include "spdk/log.h"
 #include "spdk/bdev_module.h"
+#include "spdk/base64.h"
+#include "spdk/histogram_data.h"
 
 #define TCP_PSK_INVALID_PERMISSIONS 0177
 
@@ -70,6 +72,12 @@ static const struct spdk_json_object_decoder rpc_bdev_nvme_options_decoders[] =
 	{"nvme_error_stat", offsetof(struct spdk_bdev_nvme_opts, nvme_error_stat), spdk_json_decode_bool, true},
 	{"rdma_srq_size", offsetof(struct spdk_bdev_nvme_opts, rdma_srq_size), spdk_json_decode_uint32, true},
 	{"io_path_stat", offsetof(struct spdk_bdev_nvme_opts, io_path_stat), spdk_json_decode_bool, true},
+	{"io_queue_connections", offsetof(struct spdk_bdev_nvme_opts, io_queue_connections), spdk_json_decode_uint32, true},
+	{"tcp_zcopy_recv", offsetof(struct spdk_bdev_nvme_opts, tcp_zcopy_recv), spdk_json_decode_bool, true},
+	{"latency_histograms", offsetof(struct spdk_bdev_nvme_opts, latency_histograms), spdk_json_decode_bool, true},
+	{"io_path_failover_count", offsetof(struct spdk_bdev_nvme_opts, io_path_failover_count), spdk_json_decode_uint32, true},
+	{"io_path_error_threshold", offsetof(struct spdk_bdev_nvme_opts, io_path_error_threshold), spdk_json_decode_uint32, true},
+	{"discovery_attach_max_concurrency", offsetof(struct spdk_bdev_nvme_opts, discovery_attach_max_concurrency), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -261,6 +269,8 @@ static const struct spdk_json_object_decoder rpc_bdev_nvme_attach_controller_dec
 	{"ctrlr_loss_timeout_sec", offsetof(struct rpc_bdev_nvme_attach_controller, bdev_opts.ctrlr_loss_timeout_sec), spdk_json_decode_int32, true},
 	{"reconnect_delay_sec", offsetof(struct rpc_bdev_nvme_attach_controller, bdev_opts.reconnect_delay_sec), spdk_json_decode_uint32, true},
 	{"fast_io_fail_timeout_sec", offsetof(struct rpc_bdev_nvme_attach_controller, bdev_opts.fast_io_fail_timeout_sec), spdk_json_decode_uint32, true},
+	{"io_queue_depth_limit", offsetof(struct rpc_bdev_nvme_attach_controller, bdev_opts.io_queue_depth_limit), spdk_json_decode_uint32, true},
+	{"io_target_latency_us", offsetof(struct rpc_bdev_nvme_attach_controller, bdev_opts.io_target_latency_us), spdk_json_decode_uint32, true},
 	{"psk", offsetof(struct rpc_bdev_nvme_attach_controller, psk), spdk_json_decode_string, true},
 	{"max_bdevs", offsetof(struct rpc_bdev_nvme_attach_controller, max_bdevs), spdk_json_decode_uint32, true},
 };
@@ -2169,6 +2179,189 @@ rpc_bdev_nvme_get_io_paths(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("bdev_nvme_get_io_paths", rpc_bdev_nvme_get_io_paths, SPDK_RPC_RUNTIME)
 
+struct rpc_get_latency_histograms {
+	char *name;
+};
+
+static void
+free_rpc_get_latency_histograms(struct rpc_get_latency_histograms *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_get_latency_histograms_decoders[] = {
+	{"name", offsetof(struct rpc_get_latency_histograms, name), spdk_json_decode_string},
+};
+
+static const char *const g_latency_io_type_names[SPDK_NVME_LATENCY_IO_NUM_TYPES] = {
+	[SPDK_NVME_LATENCY_IO_READ] = "read",
+	[SPDK_NVME_LATENCY_IO_WRITE] = "write",
+	[SPDK_NVME_LATENCY_IO_OTHER] = "other",
+};
+
+struct rpc_get_latency_histograms_ctx {
+	struct rpc_get_latency_histograms req;
+	struct spdk_jsonrpc_request *request;
+	struct spdk_histogram_data *histograms[SPDK_NVME_LATENCY_IO_NUM_TYPES];
+};
+
+static void
+free_rpc_get_latency_histograms_ctx(struct rpc_get_latency_histograms_ctx *ctx)
+{
+	int type;
+
+	for (type = 0; type < SPDK_NVME_LATENCY_IO_NUM_TYPES; type++) {
+		spdk_histogram_data_free(ctx->histograms[type]);
+	}
+	free_rpc_get_latency_histograms(&ctx->req);
+	free(ctx);
+}
+
+static void
+rpc_bdev_nvme_get_latency_histograms_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct rpc_get_latency_histograms_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_json_write_ctx *w;
+	char *encoded[SPDK_NVME_LATENCY_IO_NUM_TYPES] = {};
+	size_t src_len, dst_len;
+	int type, rc = 0;
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(ctx->histograms[0]) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	for (type = 0; type < SPDK_NVME_LATENCY_IO_NUM_TYPES; type++) {
+		encoded[type] = malloc(dst_len);
+		if (encoded[type] == NULL) {
+			rc = -ENOMEM;
+			break;
+		}
+
+		rc = spdk_base64_encode(encoded[type], ctx->histograms[type]->bucket, src_len);
+		if (rc != 0) {
+			break;
+		}
+	}
+
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-rc));
+		goto exit;
+	}
+
+	w = spdk_jsonrpc_begin_result(ctx->request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", ctx->req.name);
+
+	for (type = 0; type < SPDK_NVME_LATENCY_IO_NUM_TYPES; type++) {
+		spdk_json_write_named_object_begin(w, g_latency_io_type_names[type]);
+		spdk_json_write_named_string(w, "histogram", encoded[type]);
+		spdk_json_write_named_int64(w, "bucket_shift", ctx->histograms[type]->bucket_shift);
+		spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+		spdk_json_write_object_end(w);
+	}
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(ctx->request, w);
+
+exit:
+	for (type = 0; type < SPDK_NVME_LATENCY_IO_NUM_TYPES; type++) {
+		free(encoded[type]);
+	}
+	free_rpc_get_latency_histograms_ctx(ctx);
+}
+
+static void
+_rpc_bdev_nvme_get_latency_histograms(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+	struct nvme_poll_group *group = spdk_io_channel_get_ctx(_ch);
+	struct rpc_get_latency_histograms_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	const struct spdk_histogram_data *histogram;
+	struct nvme_qpair *qpair;
+	struct nvme_io_path *io_path;
+	int type;
+
+	TAILQ_FOREACH(qpair, &group->qpair_list, tailq) {
+		if (qpair->qpair == NULL) {
+			continue;
+		}
+
+		TAILQ_FOREACH(io_path, &qpair->io_path_list, tailq) {
+			if (strcmp(ctx->req.name, io_path->nvme_ns->bdev->disk.name) != 0) {
+				continue;
+			}
+
+			for (type = 0; type < SPDK_NVME_LATENCY_IO_NUM_TYPES; type++) {
+				histogram = spdk_nvme_qpair_get_latency_histogram(qpair->qpair,
+						io_path->nvme_ns->id, type);
+				if (histogram != NULL) {
+					spdk_histogram_data_merge(ctx->histograms[type], histogram);
+				}
+			}
+		}
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+rpc_bdev_nvme_get_latency_histograms(struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *params)
+{
+	struct rpc_get_latency_histograms_ctx *ctx;
+	struct spdk_bdev_nvme_opts opts;
+	struct spdk_bdev *bdev;
+	int type;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		return;
+	}
+
+	if (spdk_json_decode_object(params, rpc_get_latency_histograms_decoders,
+				    SPDK_COUNTOF(rpc_get_latency_histograms_decoders),
+				    &ctx->req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		goto err;
+	}
+
+	bdev_nvme_get_opts(&opts);
+	if (!opts.latency_histograms) {
+		spdk_jsonrpc_send_error_response(request, -ENOTSUP,
+						 "Latency histograms are disabled by bdev_nvme_set_options");
+		goto err;
+	}
+
+	bdev = spdk_bdev_get_by_name(ctx->req.name);
+	if (bdev == NULL || strcmp(spdk_bdev_get_module_name(bdev), "nvme") != 0) {
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto err;
+	}
+
+	for (type = 0; type < SPDK_NVME_LATENCY_IO_NUM_TYPES; type++) {
+		ctx->histograms[type] = spdk_histogram_data_alloc();
+		if (ctx->histograms[type] == NULL) {
+			spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+			goto err;
+		}
+	}
+
+	ctx->request = request;
+
+	spdk_for_each_channel(&g_nvme_bdev_ctrlrs,
+			      _rpc_bdev_nvme_get_latency_histograms,
+			      ctx,
+			      rpc_bdev_nvme_get_latency_histograms_done);
+	return;
+
+err:
+	free_rpc_get_latency_histograms_ctx(ctx);
+}
+SPDK_RPC_REGISTER("bdev_nvme_get_latency_histograms", rpc_bdev_nvme_get_latency_histograms,
+		  SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_nvme_set_preferred_path {
 	char *name;
 	uint16_t cntlid;
@@ -2278,6 +2471,8 @@ rpc_decode_mp_selector(const struct spdk_json_val *val, void *out)
 		*selector = BDEV_NVME_MP_SELECTOR_ROUND_ROBIN;
 	} else if (spdk_json_strequal(val, "queue_depth") == true) {
 		*selector = BDEV_NVME_MP_SELECTOR_QUEUE_DEPTH;
+	} else if (spdk_json_strequal(val, "latency") == true) {
+		*selector = BDEV_NVME_MP_SELECTOR_LATENCY;
 	} else {
 		SPDK_NOTICELOG("Invalid parameter value: selector\n");
 		return -EINVAL;
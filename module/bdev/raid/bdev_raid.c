@@ -11,9 +11,75 @@
 #include "spdk/string.h"
 #include "spdk/util.h"
 #include "spdk/json.h"
+#include "spdk/likely.h"
+
+#define RAID_OFFSET_BLOCKS_INVALID	UINT64_MAX
+#define RAID_BDEV_PROCESS_WINDOW_SIZE_KB_DEFAULT	1024
+#define RAID_BDEV_PROCESS_MAX_BANDWIDTH_MB_SEC_DEFAULT	0
+#define RAID_BDEV_PROCESS_QOS_TIMESLICE_US	1000
 
 static bool g_shutdown_started = false;
 
+static struct raid_bdev_opts g_opts = {
+	.process_window_size_kb = RAID_BDEV_PROCESS_WINDOW_SIZE_KB_DEFAULT,
+	.process_max_bandwidth_mb_sec = RAID_BDEV_PROCESS_MAX_BANDWIDTH_MB_SEC_DEFAULT,
+	.stripe_cache_size = 0,
+};
+
+enum raid_bdev_process_state {
+	RAID_PROCESS_STATE_INIT,
+	RAID_PROCESS_STATE_RUNNING,
+	RAID_PROCESS_STATE_STOPPING,
+	RAID_PROCESS_STATE_STOPPED,
+};
+
+/*
+ * A background process walks the raid bdev from the first to the last block,
+ * one window at a time. Each window is quiesced while the raid module handles
+ * it, so foreground IO to it is held for no longer than it takes to process
+ * one window. IO below the processed offset already includes the target base
+ * bdev, see raid_bdev_io_get_channel().
+ */
+struct raid_bdev_process {
+	struct raid_bdev		*raid_bdev;
+	enum raid_process_type		type;
+	enum raid_bdev_process_state	state;
+	struct spdk_thread		*thread;
+
+	/* Keeps the raid bdev from being destructed while the process runs */
+	struct spdk_bdev_desc		*desc;
+
+	/* Raid bdev channel of the process thread, without the target */
+	struct spdk_io_channel		*raid_ch;
+	struct raid_base_bdev_info	*target;
+
+	/* Everything below this offset has been processed */
+	uint64_t			offset;
+
+	/* The window currently being processed */
+	uint64_t			window_offset;
+	uint64_t			window_size;
+	uint64_t			window_remaining;
+	int				window_status;
+	uint64_t			max_window_size;
+
+	/* Buffers used by the raid module for process requests */
+	void				*buf;
+	void				*md_buf;
+	struct raid_bdev_process_request request;
+
+	struct {
+		/* Bytes that can still be processed, may go below zero */
+		int64_t			bytes_available;
+		int64_t			bytes_per_timeslice;
+		bool			waiting;
+		struct spdk_poller	*poller;
+	} qos;
+
+	int				status;
+	bool				quiesced;
+};
+
 /* List of all raid bdevs */
 struct raid_all_tailq g_raid_bdev_list = TAILQ_HEAD_INITIALIZER(g_raid_bdev_list);
 
@@ -50,6 +116,28 @@ static void	raid_bdev_examine(struct spdk_bdev *bdev);
 static int	raid_bdev_init(void);
 static void	raid_bdev_deconfigure(struct raid_bdev *raid_bdev,
 				      raid_bdev_destruct_cb cb_fn, void *cb_arg);
+static void	raid_bdev_process_stop(struct raid_bdev_process *process, int status);
+static int	raid_bdev_ch_process_setup(struct raid_bdev_io_channel *raid_ch,
+		struct raid_bdev_process *process);
+static void	raid_bdev_ch_process_cleanup(struct raid_bdev_io_channel *raid_ch);
+
+void
+raid_bdev_get_opts(struct raid_bdev_opts *opts)
+{
+	*opts = g_opts;
+}
+
+int
+raid_bdev_set_opts(const struct raid_bdev_opts *opts)
+{
+	if (opts->process_window_size_kb == 0) {
+		return -EINVAL;
+	}
+
+	g_opts = *opts;
+
+	return 0;
+}
 
 /*
  * brief:
@@ -91,7 +179,8 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		 * split logic to send the respective child bdev ios to respective base
 		 * bdev io channel.
 		 */
-		if (raid_bdev->base_bdev_info[i].desc == NULL) {
+		if (raid_bdev->base_bdev_info[i].desc == NULL ||
+		    raid_bdev->base_bdev_info[i].is_process_target) {
 			continue;
 		}
 		raid_ch->base_channel[i] = spdk_bdev_get_io_channel(
@@ -112,7 +201,21 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		}
 	}
 
+	raid_ch->process.offset = RAID_OFFSET_BLOCKS_INVALID;
+	if (!ret) {
+		spdk_spin_lock(&raid_bdev->base_bdev_lock);
+		if (raid_bdev->process != NULL &&
+		    raid_bdev->process->state < RAID_PROCESS_STATE_STOPPED) {
+			ret = raid_bdev_ch_process_setup(raid_ch, raid_bdev->process);
+		}
+		spdk_spin_unlock(&raid_bdev->base_bdev_lock);
+	}
+
 	if (ret) {
+		if (raid_ch->module_channel != NULL) {
+			spdk_put_io_channel(raid_ch->module_channel);
+			raid_ch->module_channel = NULL;
+		}
 		for (i = 0; i < raid_ch->num_channels; i++) {
 			if (raid_ch->base_channel[i] != NULL) {
 				spdk_put_io_channel(raid_ch->base_channel[i]);
@@ -145,6 +248,8 @@ raid_bdev_destroy_cb(void *io_device, void *ctx_buf)
 	assert(raid_ch != NULL);
 	assert(raid_ch->base_channel);
 
+	raid_bdev_ch_process_cleanup(raid_ch);
+
 	if (raid_ch->module_channel) {
 		spdk_put_io_channel(raid_ch->module_channel);
 	}
@@ -229,6 +334,12 @@ raid_bdev_free_base_bdev_resource(struct raid_base_bdev_info *base_info)
 	spdk_bdev_close(base_info->desc);
 	base_info->desc = NULL;
 
+	if (base_info->is_process_target) {
+		/* A process target is not counted as discovered until the process completes */
+		base_info->is_process_target = false;
+		return;
+	}
+
 	assert(raid_bdev->num_base_bdevs_discovered);
 	raid_bdev->num_base_bdevs_discovered--;
 }
@@ -264,6 +375,7 @@ _raid_bdev_destruct(void *ctxt)
 	struct raid_base_bdev_info *base_info;
 
 	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_destruct\n");
+	assert(raid_bdev->process == NULL);
 
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		/*
@@ -458,6 +570,34 @@ raid_bdev_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
 	raid_io->raid_bdev->module->submit_rw_request(raid_io);
 }
 
+/*
+ * While a background process is running, IO touching the part of the raid bdev
+ * that the process has already handled must also reach the process target.
+ * Reads can only be served from the target when they fit entirely below the
+ * processed offset. Writes and requests without payload are sent to the target
+ * whenever they start below it - going ahead of the process is harmless as the
+ * process rewrites that range when it gets there.
+ */
+static inline struct raid_bdev_io_channel *
+raid_bdev_io_get_channel(struct raid_bdev_io_channel *raid_ch, struct spdk_bdev_io *bdev_io)
+{
+	uint64_t offset = raid_ch->process.offset;
+
+	if (spdk_likely(offset == RAID_OFFSET_BLOCKS_INVALID)) {
+		return raid_ch;
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		if (bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks <= offset) {
+			return raid_ch->process.ch_processed;
+		}
+	} else if (bdev_io->u.bdev.offset_blocks < offset) {
+		return raid_ch->process.ch_processed;
+	}
+
+	return raid_ch;
+}
+
 /*
  * brief:
  * raid_bdev_submit_request function is the submit_request function pointer of
@@ -479,13 +619,16 @@ raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 	raid_io->base_bdev_io_remaining = 0;
 	raid_io->base_bdev_io_submitted = 0;
 	raid_io->base_bdev_io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	raid_io->module_private = NULL;
 
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
+		raid_io->raid_ch = raid_bdev_io_get_channel(raid_io->raid_ch, bdev_io);
 		spdk_bdev_io_get_buf(bdev_io, raid_bdev_get_buf_cb,
 				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
+		raid_io->raid_ch = raid_bdev_io_get_channel(raid_io->raid_ch, bdev_io);
 		raid_io->raid_bdev->module->submit_rw_request(raid_io);
 		break;
 
@@ -495,6 +638,7 @@ raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 
 	case SPDK_BDEV_IO_TYPE_FLUSH:
 	case SPDK_BDEV_IO_TYPE_UNMAP:
+		raid_io->raid_ch = raid_bdev_io_get_channel(raid_io->raid_ch, bdev_io);
 		raid_io->raid_bdev->module->submit_null_payload_request(raid_io);
 		break;
 
@@ -603,6 +747,10 @@ raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ct
 	spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
 	spdk_json_write_named_string(w, "state", raid_bdev_state_to_str(raid_bdev->state));
 	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
+	if (raid_bdev->module->read_policy_supported) {
+		spdk_json_write_named_string(w, "read_policy",
+					     raid_bdev_read_policy_to_str(raid_bdev->read_policy));
+	}
 	spdk_json_write_named_uint32(w, "num_base_bdevs", raid_bdev->num_base_bdevs);
 	spdk_json_write_named_uint32(w, "num_base_bdevs_discovered", raid_bdev->num_base_bdevs_discovered);
 	spdk_json_write_name(w, "base_bdevs_list");
@@ -615,6 +763,20 @@ raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ct
 		}
 	}
 	spdk_json_write_array_end(w);
+
+	if (raid_bdev->process != NULL) {
+		struct raid_bdev_process *process = raid_bdev->process;
+		uint64_t offset = process->offset;
+
+		spdk_json_write_named_object_begin(w, "process");
+		spdk_json_write_named_string(w, "type", raid_bdev_process_to_str(process->type));
+		spdk_json_write_named_string(w, "target", process->target->name);
+		spdk_json_write_named_object_begin(w, "progress");
+		spdk_json_write_named_uint64(w, "blocks", offset);
+		spdk_json_write_named_uint32(w, "percent", offset * 100 / raid_bdev->bdev.blockcnt);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
 }
 
 /*
@@ -667,10 +829,14 @@ raid_bdev_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *
 	spdk_json_write_named_string(w, "name", bdev->name);
 	spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
 	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
+	if (raid_bdev->module->read_policy_supported) {
+		spdk_json_write_named_string(w, "read_policy",
+					     raid_bdev_read_policy_to_str(raid_bdev->read_policy));
+	}
 
 	spdk_json_write_named_array_begin(w, "base_bdevs");
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		if (base_info->desc) {
+		if (base_info->desc && !base_info->is_process_target) {
 			spdk_json_write_string(w, spdk_bdev_desc_get_bdev(base_info->desc)->name);
 		}
 	}
@@ -763,8 +929,12 @@ static struct {
 	{ "0", RAID0 },
 	{ "raid1", RAID1 },
 	{ "1", RAID1 },
+	{ "raid10", RAID10 },
+	{ "10", RAID10 },
 	{ "raid5f", RAID5F },
 	{ "5f", RAID5F },
+	{ "raid6f", RAID6F },
+	{ "6f", RAID6F },
 	{ "concat", CONCAT },
 	{ }
 };
@@ -779,9 +949,26 @@ static struct {
 	{ }
 };
 
+static struct {
+	const char *name;
+	enum raid_bdev_read_policy value;
+} g_raid_read_policy_names[] = {
+	{ "round_robin", RAID_BDEV_READ_POLICY_ROUND_ROBIN },
+	{ "least_outstanding", RAID_BDEV_READ_POLICY_LEAST_OUTSTANDING },
+	{ "lba_shard", RAID_BDEV_READ_POLICY_LBA_SHARD },
+	{ }
+};
+
+static const char *g_raid_process_type_names[] = {
+	[RAID_PROCESS_NONE]	= "none",
+	[RAID_PROCESS_REBUILD]	= "rebuild",
+	[RAID_PROCESS_MAX]	= NULL
+};
+
 /* We have to use the typedef in the function declaration to appease astyle. */
 typedef enum raid_level raid_level_t;
 typedef enum raid_bdev_state raid_bdev_state_t;
+typedef enum raid_bdev_read_policy raid_bdev_read_policy_t;
 
 raid_level_t
 raid_bdev_str_to_level(const char *str)
@@ -844,6 +1031,46 @@ raid_bdev_state_to_str(enum raid_bdev_state state)
 	return "";
 }
 
+raid_bdev_read_policy_t
+raid_bdev_str_to_read_policy(const char *str)
+{
+	unsigned int i;
+
+	assert(str != NULL);
+
+	for (i = 0; g_raid_read_policy_names[i].name != NULL; i++) {
+		if (strcasecmp(g_raid_read_policy_names[i].name, str) == 0) {
+			return g_raid_read_policy_names[i].value;
+		}
+	}
+
+	return RAID_BDEV_READ_POLICY_MAX;
+}
+
+const char *
+raid_bdev_read_policy_to_str(enum raid_bdev_read_policy policy)
+{
+	unsigned int i;
+
+	for (i = 0; g_raid_read_policy_names[i].name != NULL; i++) {
+		if (g_raid_read_policy_names[i].value == policy) {
+			return g_raid_read_policy_names[i].name;
+		}
+	}
+
+	return "";
+}
+
+const char *
+raid_bdev_process_to_str(enum raid_process_type value)
+{
+	if (value >= RAID_PROCESS_MAX) {
+		return "";
+	}
+
+	return g_raid_process_type_names[value];
+}
+
 /*
  * brief:
  * raid_bdev_fini_start is called when bdev layer is starting the
@@ -896,6 +1123,25 @@ raid_bdev_get_ctx_size(void)
 	return sizeof(struct raid_bdev_io);
 }
 
+static int
+raid_bdev_config_json(struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_string(w, "method", "bdev_raid_set_options");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_uint32(w, "process_window_size_kb", g_opts.process_window_size_kb);
+	spdk_json_write_named_uint32(w, "process_max_bandwidth_mb_sec",
+				     g_opts.process_max_bandwidth_mb_sec);
+	spdk_json_write_named_uint32(w, "stripe_cache_size", g_opts.stripe_cache_size);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
 static struct spdk_bdev_module g_raid_if = {
 	.name = "raid",
 	.module_init = raid_bdev_init,
@@ -903,6 +1149,7 @@ static struct spdk_bdev_module g_raid_if = {
 	.module_fini = raid_bdev_exit,
 	.get_ctx_size = raid_bdev_get_ctx_size,
 	.examine_config = raid_bdev_examine,
+	.config_json = raid_bdev_config_json,
 	.async_init = false,
 	.async_fini = false,
 };
@@ -931,6 +1178,7 @@ raid_bdev_init(void)
  * strip_size - strip size in KB
  * num_base_bdevs - number of base bdevs
  * level - raid level
+ * read_policy - policy used to balance reads across base bdevs
  * raid_bdev_out - the created raid bdev
  * returns:
  * 0 - success
@@ -938,7 +1186,8 @@ raid_bdev_init(void)
  */
 int
 raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
-		 enum raid_level level, struct raid_bdev **raid_bdev_out, const struct spdk_uuid *uuid)
+		 enum raid_level level, enum raid_bdev_read_policy read_policy,
+		 struct raid_bdev **raid_bdev_out, const struct spdk_uuid *uuid)
 {
 	struct raid_bdev *raid_bdev;
 	struct spdk_bdev *raid_bdev_gen;
@@ -967,6 +1216,16 @@ raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 		return -EINVAL;
 	}
 
+	if (read_policy >= RAID_BDEV_READ_POLICY_MAX) {
+		SPDK_ERRLOG("Invalid read policy '%d'\n", read_policy);
+		return -EINVAL;
+	}
+
+	if (read_policy != RAID_BDEV_READ_POLICY_ROUND_ROBIN && !module->read_policy_supported) {
+		SPDK_ERRLOG("Read policy is not supported by %s\n", raid_bdev_level_to_str(level));
+		return -EINVAL;
+	}
+
 	assert(module->base_bdevs_min != 0);
 	if (num_base_bdevs < module->base_bdevs_min) {
 		SPDK_ERRLOG("At least %u base devices required for %s\n",
@@ -1031,6 +1290,7 @@ raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 	raid_bdev->strip_size_kb = strip_size;
 	raid_bdev->state = RAID_BDEV_STATE_CONFIGURING;
 	raid_bdev->level = level;
+	raid_bdev->read_policy = read_policy;
 	raid_bdev->min_base_bdevs_operational = min_operational;
 
 	raid_bdev_gen = &raid_bdev->bdev;
@@ -1283,6 +1543,10 @@ raid_bdev_channel_remove_base_bdev(struct spdk_io_channel_iter *i)
 		raid_ch->base_channel[idx] = NULL;
 	}
 
+	if (raid_ch->process.ch_processed != NULL) {
+		raid_ch->process.ch_processed->base_channel[idx] = NULL;
+	}
+
 	spdk_for_each_channel_continue(i, 0);
 }
 
@@ -1357,7 +1621,13 @@ raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev, raid_bdev_remove_base_bd
 	base_info->remove_cb = cb_fn;
 	base_info->remove_cb_ctx = cb_ctx;
 
-	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+	if (base_info->is_process_target) {
+		/*
+		 * The process target is not used by the raid bdev yet. Stopping the
+		 * process releases it and completes the removal.
+		 */
+		raid_bdev_process_stop(raid_bdev->process, -ENODEV);
+	} else if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
 		/*
 		 * As raid bdev is not registered yet or already unregistered,
 		 * so cleanup should be done here itself.
@@ -1507,9 +1777,8 @@ raid_bdev_delete(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn, void
 }
 
 static int
-raid_bdev_configure_base_bdev(struct raid_base_bdev_info *base_info)
+raid_bdev_open_base_bdev(struct raid_base_bdev_info *base_info, struct spdk_bdev_desc **_desc)
 {
-	struct raid_bdev *raid_bdev = base_info->raid_bdev;
 	struct spdk_bdev_desc *desc;
 	struct spdk_bdev *bdev;
 	int rc;
@@ -1537,6 +1806,26 @@ raid_bdev_configure_base_bdev(struct raid_base_bdev_info *base_info)
 
 	SPDK_DEBUGLOG(bdev_raid, "bdev %s is claimed\n", bdev->name);
 
+	*_desc = desc;
+
+	return 0;
+}
+
+static int
+raid_bdev_configure_base_bdev(struct raid_base_bdev_info *base_info)
+{
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	struct spdk_bdev_desc *desc;
+	struct spdk_bdev *bdev;
+	int rc;
+
+	rc = raid_bdev_open_base_bdev(base_info, &desc);
+	if (rc != 0) {
+		return rc;
+	}
+
+	bdev = spdk_bdev_desc_get_bdev(desc);
+
 	assert(raid_bdev->state != RAID_BDEV_STATE_ONLINE);
 
 	base_info->desc = desc;
@@ -1631,5 +1920,756 @@ raid_bdev_examine(struct spdk_bdev *bdev)
 	spdk_bdev_module_examine_done(&g_raid_if);
 }
 
+static int
+raid_bdev_ch_process_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bdev_process *process)
+{
+	struct raid_base_bdev_info *target = process->target;
+	struct raid_bdev_io_channel *raid_ch_processed;
+	uint8_t slot = target - process->raid_bdev->base_bdev_info;
+
+	raid_ch->process.offset = process->offset;
+
+	raid_ch->process.target_ch = spdk_bdev_get_io_channel(target->desc);
+	if (raid_ch->process.target_ch == NULL) {
+		goto err;
+	}
+
+	raid_ch_processed = calloc(1, sizeof(*raid_ch_processed));
+	if (raid_ch_processed == NULL) {
+		goto err;
+	}
+	raid_ch->process.ch_processed = raid_ch_processed;
+
+	raid_ch_processed->base_channel = calloc(raid_ch->num_channels,
+					  sizeof(struct spdk_io_channel *));
+	if (raid_ch_processed->base_channel == NULL) {
+		goto err;
+	}
+
+	memcpy(raid_ch_processed->base_channel, raid_ch->base_channel,
+	       raid_ch->num_channels * sizeof(struct spdk_io_channel *));
+	raid_ch_processed->base_channel[slot] = raid_ch->process.target_ch;
+	raid_ch_processed->num_channels = raid_ch->num_channels;
+	raid_ch_processed->module_channel = raid_ch->module_channel;
+	raid_ch_processed->process.offset = RAID_OFFSET_BLOCKS_INVALID;
+
+	return 0;
+err:
+	SPDK_ERRLOG("Unable to set up io channel for raid bdev process\n");
+	raid_bdev_ch_process_cleanup(raid_ch);
+	return -ENOMEM;
+}
+
+static void
+raid_bdev_ch_process_cleanup(struct raid_bdev_io_channel *raid_ch)
+{
+	raid_ch->process.offset = RAID_OFFSET_BLOCKS_INVALID;
+
+	if (raid_ch->process.target_ch != NULL) {
+		spdk_put_io_channel(raid_ch->process.target_ch);
+		raid_ch->process.target_ch = NULL;
+	}
+
+	if (raid_ch->process.ch_processed != NULL) {
+		/* The base channels of the processed channel are only borrowed */
+		free(raid_ch->process.ch_processed->base_channel);
+		free(raid_ch->process.ch_processed);
+		raid_ch->process.ch_processed = NULL;
+	}
+}
+
+static void
+raid_bdev_process_free(struct raid_bdev_process *process)
+{
+	spdk_dma_free(process->buf);
+	spdk_dma_free(process->md_buf);
+	free(process);
+}
+
+static void
+raid_bdev_process_finish_unquiesced(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_base_bdev_info *target = process->target;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to unquiesce raid bdev %s: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
+
+	if (process->request.target_ch != NULL) {
+		spdk_put_io_channel(process->request.target_ch);
+	}
+	if (process->raid_ch != NULL) {
+		spdk_put_io_channel(process->raid_ch);
+	}
+
+	spdk_spin_lock(&raid_bdev->base_bdev_lock);
+	raid_bdev->process = NULL;
+	if (process->status != 0) {
+		raid_bdev_free_base_bdev_resource(target);
+	}
+	spdk_spin_unlock(&raid_bdev->base_bdev_lock);
+
+	if (process->status != 0 && target->remove_scheduled) {
+		target->remove_scheduled = false;
+		if (target->remove_cb != NULL) {
+			target->remove_cb(target->remove_cb_ctx, 0);
+			target->remove_cb = NULL;
+		}
+	}
+
+	/* Closing the descriptor lets a pending unregister of the raid bdev proceed */
+	if (process->desc != NULL) {
+		spdk_bdev_close(process->desc);
+	}
+
+	raid_bdev_process_free(process);
+}
+
+static void
+raid_bdev_channel_finish_process(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	uint8_t slot = process->target - process->raid_bdev->base_bdev_info;
+
+	if (process->status == 0 && raid_ch->process.target_ch != NULL) {
+		/* The target becomes a regular member of the raid bdev */
+		assert(raid_ch->base_channel[slot] == NULL);
+		raid_ch->base_channel[slot] = raid_ch->process.target_ch;
+		raid_ch->process.target_ch = NULL;
+	}
+
+	raid_bdev_ch_process_cleanup(raid_ch);
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_channels_finish_process_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	int rc;
+
+	if (process->quiesced) {
+		rc = spdk_bdev_unquiesce(&raid_bdev->bdev, &g_raid_if,
+					 raid_bdev_process_finish_unquiesced, process);
+		if (rc == 0) {
+			return;
+		}
+		status = rc;
+	}
+
+	raid_bdev_process_finish_unquiesced(process, status);
+}
+
+static void
+raid_bdev_process_finish_quiesced(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to quiesce raid bdev %s: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	} else {
+		process->quiesced = true;
+	}
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_finish_process, process,
+			      raid_bdev_channels_finish_process_done);
+}
+
+/*
+ * Detach the process from the raid bdev. The raid bdev is quiesced so that no
+ * IO is using the processed channels while they are released.
+ */
+static void
+raid_bdev_process_finish(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	int rc;
+
+	spdk_poller_unregister(&process->qos.poller);
+
+	if (process->status == 0) {
+		SPDK_NOTICELOG("Finished %s on raid bdev %s\n",
+			       raid_bdev_process_to_str(process->type), raid_bdev->bdev.name);
+	} else {
+		SPDK_WARNLOG("Finished %s on raid bdev %s with error: %s\n",
+			     raid_bdev_process_to_str(process->type), raid_bdev->bdev.name,
+			     spdk_strerror(-process->status));
+	}
+
+	spdk_spin_lock(&raid_bdev->base_bdev_lock);
+	process->state = RAID_PROCESS_STATE_STOPPED;
+	if (process->status == 0) {
+		/* From now on, new channels open the target like any other base bdev */
+		process->target->is_process_target = false;
+		raid_bdev->num_base_bdevs_discovered++;
+	}
+	spdk_spin_unlock(&raid_bdev->base_bdev_lock);
+
+	rc = spdk_bdev_quiesce(&raid_bdev->bdev, &g_raid_if, raid_bdev_process_finish_quiesced,
+			       process);
+	if (rc != 0) {
+		raid_bdev_process_finish_quiesced(process, rc);
+	}
+}
+
+static void raid_bdev_process_thread_run(struct raid_bdev_process *process);
+
+static void
+raid_bdev_process_window_range_unlocked(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to unquiesce range on raid bdev %s: %s\n",
+			    process->raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev_process_stop(process, status);
+	}
+
+	if (process->offset != process->window_offset) {
+		process->qos.bytes_available -= (int64_t)(process->window_size *
+						process->raid_bdev->bdev.blocklen);
+		process->window_offset = process->offset;
+	}
+
+	raid_bdev_process_thread_run(process);
+}
+
+static void
+raid_bdev_process_unlock_window_range(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	int rc;
+
+	rc = spdk_bdev_unquiesce_range(&raid_bdev->bdev, &g_raid_if, process->window_offset,
+				       process->window_size, raid_bdev_process_window_range_unlocked,
+				       process);
+	if (rc != 0) {
+		raid_bdev_process_window_range_unlocked(process, rc);
+	}
+}
+
+static void
+raid_bdev_process_channel_update(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+
+	raid_ch->process.offset = process->offset;
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_process_channels_update_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+
+	raid_bdev_process_unlock_window_range(process);
+}
+
+static void
+raid_bdev_process_window_done(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	if (process->window_status != 0) {
+		raid_bdev_process_stop(process, process->window_status);
+		raid_bdev_process_unlock_window_range(process);
+		return;
+	}
+
+	/*
+	 * The window stays quiesced until all channels use the new offset, so
+	 * channels created in the meantime can already start from it.
+	 */
+	spdk_spin_lock(&raid_bdev->base_bdev_lock);
+	process->offset = process->window_offset + process->window_size;
+	spdk_spin_unlock(&raid_bdev->base_bdev_lock);
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_process_channel_update, process,
+			      raid_bdev_process_channels_update_done);
+}
+
+static void
+raid_bdev_process_submit_request(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_process_request *process_req = &process->request;
+	int rc;
+
+	process_req->offset_blocks = process->window_offset + process->window_size -
+				     process->window_remaining;
+	process_req->num_blocks = process->window_remaining;
+	process_req->iov.iov_base = process->buf;
+	process_req->iov.iov_len = process_req->num_blocks * raid_bdev->bdev.blocklen;
+	process_req->md_buf = process->md_buf;
+
+	rc = raid_bdev->module->submit_process_request(process_req);
+	if (rc != 0) {
+		raid_bdev_process_request_complete(process_req, rc);
+	}
+}
+
+static void
+_raid_bdev_process_submit_request(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+
+	raid_bdev_process_submit_request(process);
+}
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	struct raid_bdev_process *process = process_req->process;
+	int rc;
+
+	assert(spdk_get_thread() == process->thread);
+	assert(process_req->num_blocks <= process->window_remaining);
+
+	if (status != 0) {
+		SPDK_ERRLOG("Process request failed on raid bdev %s at offset %" PRIu64 ": %s\n",
+			    process->raid_bdev->bdev.name, process_req->offset_blocks,
+			    spdk_strerror(-status));
+		process->window_status = status;
+		process->window_remaining = 0;
+	} else {
+		process->window_remaining -= process_req->num_blocks;
+	}
+
+	if (process->window_remaining == 0) {
+		raid_bdev_process_window_done(process);
+		return;
+	}
+
+	/* The module may complete synchronously, don't recurse through the whole window */
+	rc = spdk_thread_send_msg(process->thread, _raid_bdev_process_submit_request, process);
+	if (rc != 0) {
+		process->window_status = rc;
+		process->window_remaining = 0;
+		raid_bdev_process_window_done(process);
+	}
+}
+
+static void
+raid_bdev_process_window_range_locked(void *ctx, int status)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to quiesce range on raid bdev %s: %s\n",
+			    process->raid_bdev->bdev.name, spdk_strerror(-status));
+		process->window_size = 0;
+		process->window_remaining = 0;
+		raid_bdev_process_stop(process, status);
+		raid_bdev_process_thread_run(process);
+		return;
+	}
+
+	if (process->state == RAID_PROCESS_STATE_STOPPING) {
+		process->window_status = -ECANCELED;
+		process->window_remaining = 0;
+		raid_bdev_process_window_done(process);
+		return;
+	}
+
+	raid_bdev_process_submit_request(process);
+}
+
+static void
+raid_bdev_process_lock_window_range(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	int rc;
+
+	process->window_size = spdk_min(process->max_window_size,
+					raid_bdev->bdev.blockcnt - process->window_offset);
+	process->window_remaining = process->window_size;
+	process->window_status = 0;
+
+	rc = spdk_bdev_quiesce_range(&raid_bdev->bdev, &g_raid_if, process->window_offset,
+				     process->window_size, raid_bdev_process_window_range_locked,
+				     process);
+	if (rc != 0) {
+		raid_bdev_process_window_range_locked(process, rc);
+	}
+}
+
+static void
+raid_bdev_process_thread_run(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	assert(spdk_get_thread() == process->thread);
+	assert(process->window_remaining == 0);
+
+	if (process->state == RAID_PROCESS_STATE_STOPPING ||
+	    process->window_offset == raid_bdev->bdev.blockcnt) {
+		raid_bdev_process_finish(process);
+		return;
+	}
+
+	if (process->qos.poller != NULL && process->qos.bytes_available <= 0) {
+		/* Over the bandwidth limit, the qos poller resumes the process */
+		process->qos.waiting = true;
+		return;
+	}
+
+	raid_bdev_process_lock_window_range(process);
+}
+
+static int
+raid_bdev_process_qos_poll(void *arg)
+{
+	struct raid_bdev_process *process = arg;
+
+	process->qos.bytes_available = spdk_min(process->qos.bytes_available +
+				       process->qos.bytes_per_timeslice,
+				       process->qos.bytes_per_timeslice);
+
+	if (process->qos.waiting && process->qos.bytes_available > 0) {
+		process->qos.waiting = false;
+		raid_bdev_process_thread_run(process);
+		return SPDK_POLLER_BUSY;
+	}
+
+	return SPDK_POLLER_IDLE;
+}
+
+/*
+ * Request the process to stop. A window that is being processed is completed
+ * first, the process then detaches itself from the raid bdev.
+ */
+static void
+raid_bdev_process_stop(struct raid_bdev_process *process, int status)
+{
+	assert(spdk_get_thread() == process->thread);
+	assert(status != 0);
+
+	if (process->status == 0) {
+		process->status = status;
+	}
+
+	if (process->state >= RAID_PROCESS_STATE_STOPPING) {
+		return;
+	}
+
+	process->state = RAID_PROCESS_STATE_STOPPING;
+
+	if (process->qos.waiting) {
+		process->qos.waiting = false;
+		raid_bdev_process_thread_run(process);
+	}
+}
+
+static void
+raid_bdev_process_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+			   void *event_ctx)
+{
+	struct raid_bdev_process *process = event_ctx;
+
+	if (type == SPDK_BDEV_EVENT_REMOVE) {
+		raid_bdev_process_stop(process, -ECANCELED);
+	}
+}
+
+static void
+raid_bdev_channel_start_process(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	int rc = 0;
+
+	/* Channels created after the process was attached are already set up */
+	if (raid_ch->process.ch_processed == NULL) {
+		rc = raid_bdev_ch_process_setup(raid_ch, process);
+	}
+
+	spdk_for_each_channel_continue(i, rc);
+}
+
+static void
+raid_bdev_channels_start_process_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to start %s on raid bdev %s: %s\n",
+			    raid_bdev_process_to_str(process->type), raid_bdev->bdev.name,
+			    spdk_strerror(-status));
+		raid_bdev_process_stop(process, status);
+	} else if (process->state == RAID_PROCESS_STATE_INIT) {
+		SPDK_NOTICELOG("Started %s on raid bdev %s with target %s\n",
+			       raid_bdev_process_to_str(process->type), raid_bdev->bdev.name,
+			       process->target->name);
+		process->state = RAID_PROCESS_STATE_RUNNING;
+	}
+
+	raid_bdev_process_thread_run(process);
+}
+
+static struct raid_bdev_process *
+raid_bdev_process_alloc(struct raid_bdev *raid_bdev, enum raid_process_type type,
+			struct raid_base_bdev_info *target)
+{
+	struct raid_bdev_process *process;
+	uint32_t write_unit_size = spdk_max(raid_bdev->bdev.write_unit_size, 1);
+	size_t align = spdk_bdev_get_buf_align(&raid_bdev->bdev);
+	uint64_t window_size;
+
+	process = calloc(1, sizeof(*process));
+	if (process == NULL) {
+		return NULL;
+	}
+
+	process->raid_bdev = raid_bdev;
+	process->type = type;
+	process->state = RAID_PROCESS_STATE_INIT;
+	process->thread = spdk_get_thread();
+	process->target = target;
+	process->request.process = process;
+	process->request.target = target;
+
+	/* A window must consist of whole write units, e.g. full raid5f stripes */
+	window_size = spdk_divide_round_up((uint64_t)g_opts.process_window_size_kb * 1024,
+					   raid_bdev->bdev.blocklen);
+	process->max_window_size = spdk_divide_round_up(window_size, write_unit_size) * write_unit_size;
+
+	process->buf = spdk_dma_malloc(process->max_window_size * raid_bdev->bdev.blocklen, align,
+				       NULL);
+	if (process->buf == NULL) {
+		goto err;
+	}
+
+	if (raid_bdev->bdev.md_len != 0 && !raid_bdev->bdev.md_interleave) {
+		process->md_buf = spdk_dma_malloc(process->max_window_size * raid_bdev->bdev.md_len,
+						  align, NULL);
+		if (process->md_buf == NULL) {
+			goto err;
+		}
+	}
+
+	if (g_opts.process_max_bandwidth_mb_sec != 0) {
+		process->qos.bytes_per_timeslice = (uint64_t)g_opts.process_max_bandwidth_mb_sec * 1024 *
+						   1024 * RAID_BDEV_PROCESS_QOS_TIMESLICE_US / SPDK_SEC_TO_USEC;
+		process->qos.bytes_available = process->qos.bytes_per_timeslice;
+	}
+
+	return process;
+err:
+	raid_bdev_process_free(process);
+	return NULL;
+}
+
+static int
+raid_bdev_process_start(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	int rc;
+
+	assert(raid_bdev->module->submit_process_request != NULL);
+
+	rc = spdk_bdev_open_ext(raid_bdev->bdev.name, false, raid_bdev_process_event_cb, process,
+				&process->desc);
+	if (rc != 0) {
+		return rc;
+	}
+
+	process->raid_ch = spdk_get_io_channel(raid_bdev);
+	if (process->raid_ch == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	process->request.raid_ch = spdk_io_channel_get_ctx(process->raid_ch);
+
+	process->request.target_ch = spdk_bdev_get_io_channel(process->target->desc);
+	if (process->request.target_ch == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	if (process->qos.bytes_per_timeslice != 0) {
+		process->qos.poller = SPDK_POLLER_REGISTER(raid_bdev_process_qos_poll, process,
+				      RAID_BDEV_PROCESS_QOS_TIMESLICE_US);
+		if (process->qos.poller == NULL) {
+			rc = -ENOMEM;
+			goto err;
+		}
+	}
+
+	spdk_spin_lock(&raid_bdev->base_bdev_lock);
+	raid_bdev->process = process;
+	spdk_spin_unlock(&raid_bdev->base_bdev_lock);
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_start_process, process,
+			      raid_bdev_channels_start_process_done);
+
+	return 0;
+err:
+	spdk_poller_unregister(&process->qos.poller);
+	if (process->request.target_ch != NULL) {
+		spdk_put_io_channel(process->request.target_ch);
+		process->request.target_ch = NULL;
+	}
+	if (process->raid_ch != NULL) {
+		spdk_put_io_channel(process->raid_ch);
+		process->raid_ch = NULL;
+	}
+	spdk_bdev_close(process->desc);
+	process->desc = NULL;
+
+	return rc;
+}
+
+static int
+raid_bdev_start_rebuild(struct raid_base_bdev_info *target)
+{
+	struct raid_bdev_process *process;
+	int rc;
+
+	process = raid_bdev_process_alloc(target->raid_bdev, RAID_PROCESS_REBUILD, target);
+	if (process == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = raid_bdev_process_start(process);
+	if (rc != 0) {
+		raid_bdev_process_free(process);
+	}
+
+	return rc;
+}
+
+/*
+ * brief:
+ * raid_bdev_add_base_bdev adds a base bdev to a free slot of a raid bdev. If the
+ * raid bdev is online, the new base bdev is rebuilt in the background and
+ * becomes a regular member once the rebuild completes.
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * name - name of the base bdev
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
+int
+raid_bdev_add_base_bdev(struct raid_bdev *raid_bdev, const char *name)
+{
+	struct raid_base_bdev_info *base_info, *iter;
+	struct spdk_bdev_desc *desc;
+	struct spdk_bdev *bdev;
+	uint64_t min_blockcnt = UINT64_MAX;
+	int rc;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (raid_bdev->destroy_started) {
+		return -ENODEV;
+	}
+
+	base_info = NULL;
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, iter) {
+		if (iter->name == NULL && iter->desc == NULL) {
+			if (base_info == NULL) {
+				base_info = iter;
+			}
+		} else if (iter->desc != NULL && !iter->is_process_target) {
+			min_blockcnt = spdk_min(min_blockcnt, iter->blockcnt);
+		}
+	}
+
+	if (base_info == NULL) {
+		SPDK_ERRLOG("No free slot for base bdev '%s' on raid bdev '%s'\n", name,
+			    raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+
+	if (raid_bdev->state == RAID_BDEV_STATE_CONFIGURING) {
+		return raid_bdev_add_base_device(raid_bdev, name, base_info - raid_bdev->base_bdev_info);
+	}
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+		return -EBUSY;
+	}
+
+	if (raid_bdev->module->submit_process_request == NULL) {
+		SPDK_ERRLOG("Raid level '%s' does not support rebuild\n",
+			    raid_bdev_level_to_str(raid_bdev->level));
+		return -ENOTSUP;
+	}
+
+	if (raid_bdev->process != NULL) {
+		SPDK_ERRLOG("A %s is already running on raid bdev '%s'\n",
+			    raid_bdev_process_to_str(raid_bdev->process->type), raid_bdev->bdev.name);
+		return -EBUSY;
+	}
+
+	base_info->name = strdup(name);
+	if (base_info->name == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = raid_bdev_open_base_bdev(base_info, &desc);
+	if (rc != 0) {
+		free(base_info->name);
+		base_info->name = NULL;
+		return rc;
+	}
+
+	bdev = spdk_bdev_desc_get_bdev(desc);
+
+	base_info->remove_scheduled = false;
+	base_info->remove_cb = NULL;
+	base_info->blockcnt = bdev->blockcnt;
+
+	spdk_spin_lock(&raid_bdev->base_bdev_lock);
+	base_info->desc = desc;
+	base_info->is_process_target = true;
+	spdk_spin_unlock(&raid_bdev->base_bdev_lock);
+
+	if (bdev->blocklen != raid_bdev->bdev.blocklen ||
+	    spdk_bdev_get_md_size(bdev) != raid_bdev->bdev.md_len ||
+	    spdk_bdev_is_md_interleaved(bdev) != raid_bdev->bdev.md_interleave) {
+		SPDK_ERRLOG("Base bdev '%s' block or metadata format does not match raid bdev '%s'\n",
+			    name, raid_bdev->bdev.name);
+		rc = -EINVAL;
+		goto err;
+	}
+
+	if (bdev->blockcnt < min_blockcnt) {
+		SPDK_ERRLOG("Base bdev '%s' is smaller than the other base bdevs of raid bdev '%s'\n",
+			    name, raid_bdev->bdev.name);
+		rc = -EINVAL;
+		goto err;
+	}
+
+	rc = raid_bdev_start_rebuild(base_info);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to start rebuild of base bdev '%s': %s\n", name, spdk_strerror(-rc));
+		goto err;
+	}
+
+	return 0;
+err:
+	spdk_spin_lock(&raid_bdev->base_bdev_lock);
+	raid_bdev_free_base_bdev_resource(base_info);
+	spdk_spin_unlock(&raid_bdev->base_bdev_lock);
+
+	return rc;
+}
+
 /* Log component for bdev raid bdev module */
 SPDK_LOG_REGISTER_COMPONENT(bdev_raid)
@@ -13,10 +13,30 @@ enum raid_level {
 	INVALID_RAID_LEVEL	= -1,
 	RAID0			= 0,
 	RAID1			= 1,
+	RAID10			= 10,
 	RAID5F			= 95, /* 0x5f */
+	RAID6F			= 111, /* 0x6f */
 	CONCAT			= 99,
 };
 
+/*
+ * Read policy describes how reads are distributed among the base bdevs of
+ * raid levels that keep full copies of the data (e.g. raid1 and raid10).
+ */
+enum raid_bdev_read_policy {
+	/* Spread reads evenly, one after another, over all available base bdevs */
+	RAID_BDEV_READ_POLICY_ROUND_ROBIN,
+
+	/* Send each read to the base bdev with the fewest outstanding reads */
+	RAID_BDEV_READ_POLICY_LEAST_OUTSTANDING,
+
+	/* Pick the base bdev based on the LBA range of the read */
+	RAID_BDEV_READ_POLICY_LBA_SHARD,
+
+	/* raid bdev read policy max, new policies should be added before this */
+	RAID_BDEV_READ_POLICY_MAX
+};
+
 /*
  * Raid state describes the state of the raid. This raid bdev can be either in
  * configured list or configuring list
@@ -41,6 +61,22 @@ enum raid_bdev_state {
 	RAID_BDEV_STATE_MAX
 };
 
+/*
+ * Background process types. A process runs over the whole raid bdev, window by
+ * window, while the raid bdev stays online.
+ */
+enum raid_process_type {
+	RAID_PROCESS_NONE,
+
+	/* Reconstruct the data of a base bdev added to a degraded raid bdev */
+	RAID_PROCESS_REBUILD,
+
+	/* raid process type max, new types should be added before this */
+	RAID_PROCESS_MAX
+};
+
+struct raid_bdev_process;
+
 typedef void (*raid_bdev_remove_base_bdev_cb)(void *ctx, int status);
 
 /*
@@ -73,6 +109,13 @@ struct raid_base_bdev_info {
 
 	/* Hold the number of blocks to know how large the base bdev is resized. */
 	uint64_t		blockcnt;
+
+	/*
+	 * Set while this base bdev is the target of a background process. Such a
+	 * base bdev is not counted in num_base_bdevs_discovered and is only used
+	 * for the part of the raid bdev that the process has already handled.
+	 */
+	bool			is_process_target;
 };
 
 /*
@@ -143,6 +186,9 @@ struct raid_bdev {
 	/* Raid Level of this raid bdev */
 	enum raid_level			level;
 
+	/* Policy used to balance reads across base bdevs */
+	enum raid_bdev_read_policy	read_policy;
+
 	/* Set to true if destroy of this raid bdev is started. */
 	bool				destroy_started;
 
@@ -151,6 +197,9 @@ struct raid_bdev {
 
 	/* Private data for the raid module */
 	void				*module_private;
+
+	/* Background process currently running on this raid bdev */
+	struct raid_bdev_process	*process;
 };
 
 #define RAID_FOR_EACH_BASE_BDEV(r, i) \
@@ -169,6 +218,61 @@ struct raid_bdev_io_channel {
 
 	/* Private raid module IO channel */
 	struct spdk_io_channel	*module_channel;
+
+	/* Background process data */
+	struct {
+		/* Offset up to which the process has handled the raid bdev */
+		uint64_t offset;
+
+		/* IO channel of the process target base bdev */
+		struct spdk_io_channel *target_ch;
+
+		/* Channel used for IO to the part of the raid bdev below offset */
+		struct raid_bdev_io_channel *ch_processed;
+	} process;
+};
+
+/*
+ * raid_bdev_process_request describes a range of the raid bdev that a background
+ * process asks the raid module to handle. The range is quiesced for the duration
+ * of the request.
+ */
+struct raid_bdev_process_request {
+	/* The process that issued this request */
+	struct raid_bdev_process	*process;
+
+	/* Raid bdev channel of the process thread, does not include the target */
+	struct raid_bdev_io_channel	*raid_ch;
+
+	/* The base bdev being rebuilt and its IO channel on the process thread */
+	struct raid_base_bdev_info	*target;
+	struct spdk_io_channel		*target_ch;
+
+	/* Range of the raid bdev, the module may reduce num_blocks */
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+
+	/* Data buffer of the size of num_blocks, metadata buffer if md is used */
+	struct iovec			iov;
+	void				*md_buf;
+
+	/* WaitQ entry, for the module to retry on ENOMEM */
+	struct spdk_bdev_io_wait_entry	waitq_entry;
+};
+
+/* Global options of the raid bdev module */
+struct raid_bdev_opts {
+	/* Size of the range the background process handles at once, in KiB */
+	uint32_t process_window_size_kb;
+
+	/* Bandwidth limit of the background process in MiB/s, 0 means unlimited */
+	uint32_t process_max_bandwidth_mb_sec;
+
+	/*
+	 * Number of stripes cached by each raid5f/raid6f bdev to merge writes smaller
+	 * than a stripe, 0 disables the cache. Applies to raid bdevs started afterwards.
+	 */
+	uint32_t stripe_cache_size;
 };
 
 /* TAIL head for raid bdev list */
@@ -179,7 +283,8 @@ extern struct raid_all_tailq		g_raid_bdev_list;
 typedef void (*raid_bdev_destruct_cb)(void *cb_ctx, int rc);
 
 int raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
-		     enum raid_level level, struct raid_bdev **raid_bdev_out, const struct spdk_uuid *uuid);
+		     enum raid_level level, enum raid_bdev_read_policy read_policy,
+		     struct raid_bdev **raid_bdev_out, const struct spdk_uuid *uuid);
 void raid_bdev_delete(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn, void *cb_ctx);
 int raid_bdev_add_base_device(struct raid_bdev *raid_bdev, const char *name, uint8_t slot);
 struct raid_bdev *raid_bdev_find_by_name(const char *name);
@@ -187,9 +292,15 @@ enum raid_level raid_bdev_str_to_level(const char *str);
 const char *raid_bdev_level_to_str(enum raid_level level);
 enum raid_bdev_state raid_bdev_str_to_state(const char *str);
 const char *raid_bdev_state_to_str(enum raid_bdev_state state);
+enum raid_bdev_read_policy raid_bdev_str_to_read_policy(const char *str);
+const char *raid_bdev_read_policy_to_str(enum raid_bdev_read_policy policy);
 void raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w);
 int raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev, raid_bdev_remove_base_bdev_cb cb_fn,
 			       void *cb_ctx);
+int raid_bdev_add_base_bdev(struct raid_bdev *raid_bdev, const char *name);
+const char *raid_bdev_process_to_str(enum raid_process_type value);
+void raid_bdev_get_opts(struct raid_bdev_opts *opts);
+int raid_bdev_set_opts(const struct raid_bdev_opts *opts);
 
 /*
  * RAID module descriptor
@@ -217,6 +328,9 @@ struct raid_bdev_module {
 	/* Set to true if this module supports memory domains. */
 	bool memory_domains_supported;
 
+	/* Set to true if this module honors raid_bdev->read_policy. */
+	bool read_policy_supported;
+
 	/*
 	 * Called when the raid is starting, right before changing the state to
 	 * online and registering the bdev. Parameters of the bdev like blockcnt
@@ -254,6 +368,17 @@ struct raid_bdev_module {
 	 */
 	void (*resize)(struct raid_bdev *raid_bdev);
 
+	/*
+	 * Handler for background process requests. Optional, a raid level without
+	 * it does not support rebuild. Called on the process thread.
+	 *
+	 * The module may trim process_req->num_blocks before starting any IO, e.g.
+	 * to stay within a strip or stripe. Returns 0 if the request was started,
+	 * in which case raid_bdev_process_request_complete() must be called when it
+	 * is done, or a negative errno otherwise.
+	 */
+	int (*submit_process_request)(struct raid_bdev_process_request *process_req);
+
 	TAILQ_ENTRY(raid_bdev_module) link;
 };
 
@@ -271,9 +396,38 @@ __RAID_MODULE_REGISTER(__LINE__)(void)					\
 
 bool raid_bdev_io_complete_part(struct raid_bdev_io *raid_io, uint64_t completed,
 				enum spdk_bdev_io_status status);
+
+/*
+ * Fill dst with the part of the payload described by iovs that starts at offset
+ * and is len bytes long. dst must have room for iovcnt entries. Returns the
+ * number of entries of dst used.
+ */
+static inline int
+raid_bdev_iovs_slice(struct iovec *dst, const struct iovec *iovs, int iovcnt,
+		     uint64_t offset, uint64_t len)
+{
+	int i, cnt = 0;
+
+	for (i = 0; i < iovcnt && len > 0; i++) {
+		if (offset >= iovs[i].iov_len) {
+			offset -= iovs[i].iov_len;
+			continue;
+		}
+
+		dst[cnt].iov_base = (uint8_t *)iovs[i].iov_base + offset;
+		dst[cnt].iov_len = spdk_min(iovs[i].iov_len - offset, len);
+		len -= dst[cnt].iov_len;
+		offset = 0;
+		cnt++;
+	}
+	assert(len == 0);
+
+	return cnt;
+}
 void raid_bdev_queue_io_wait(struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
 			     struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn);
 void raid_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status);
 void raid_bdev_module_stop_done(struct raid_bdev *raid_bdev);
+void raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status);
 
 #endif /* SPDK_BDEV_RAID_INTERNAL_H */
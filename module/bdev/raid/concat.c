@@ -44,6 +44,7 @@ concat_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_a
 }
 
 static void concat_submit_rw_request(struct raid_bdev_io *raid_io);
+static void concat_submit_multi_disk_rw_request(struct raid_bdev_io *raid_io, int start_idx);
 
 static void
 _concat_submit_rw_request(void *_raid_io)
@@ -89,6 +90,10 @@ concat_submit_rw_request(struct raid_bdev_io *raid_io)
 	assert(bdev_io->u.bdev.offset_blocks >= block_range[pd_idx].start);
 	pd_lba = bdev_io->u.bdev.offset_blocks - block_range[pd_idx].start;
 	pd_blocks = bdev_io->u.bdev.num_blocks;
+	if (pd_lba + pd_blocks > block_range[pd_idx].length) {
+		concat_submit_multi_disk_rw_request(raid_io, pd_idx);
+		return;
+	}
 	base_info = &raid_bdev->base_bdev_info[pd_idx];
 	if (base_info->desc == NULL) {
 		SPDK_ERRLOG("base bdev desc null for pd_idx %u\n", pd_idx);
@@ -134,6 +139,186 @@ concat_submit_rw_request(struct raid_bdev_io *raid_io)
 	}
 }
 
+/* Payload of the base bdev IOs of a read or write spanning several base bdevs */
+struct concat_io_iovs {
+	/* Number of entries of iovs used by the base bdev IOs submitted so far */
+	int		used;
+	struct iovec	iovs[];
+};
+
+static bool
+concat_multi_disk_complete_part(struct raid_bdev_io *raid_io, uint64_t completed,
+				enum spdk_bdev_io_status status)
+{
+	if (raid_io->base_bdev_io_remaining == completed) {
+		free(raid_io->module_private);
+		raid_io->module_private = NULL;
+	}
+
+	return raid_bdev_io_complete_part(raid_io, completed, status);
+}
+
+static void
+concat_multi_disk_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	concat_multi_disk_complete_part(raid_io, 1, success ?
+					SPDK_BDEV_IO_STATUS_SUCCESS :
+					SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+_concat_submit_multi_disk_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io		*raid_io = _raid_io;
+	struct spdk_bdev_io		*bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct concat_block_range	*block_range = raid_io->raid_bdev->module_private;
+	int				i;
+
+	for (i = raid_io->raid_bdev->num_base_bdevs - 1; i > 0; i--) {
+		if (block_range[i].start <= bdev_io->u.bdev.offset_blocks) {
+			break;
+		}
+	}
+
+	concat_submit_multi_disk_rw_request(raid_io, i);
+}
+
+/*
+ * brief:
+ * concat_submit_multi_disk_rw_request submits a read or write spanning several
+ * base bdevs as one IO per base bdev, each with its part of the payload. It will
+ * submit as many as possible unless one base io request fails with -ENOMEM, in
+ * which case it will queue itself for later submission.
+ * params:
+ * raid_io
+ * start_idx - index of the base bdev the IO starts on
+ * returns:
+ * none
+ */
+static void
+concat_submit_multi_disk_rw_request(struct raid_bdev_io *raid_io, int start_idx)
+{
+	struct spdk_bdev_io		*bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct spdk_bdev_ext_io_opts	io_opts = {};
+	struct raid_bdev		*raid_bdev = raid_io->raid_bdev;
+	struct concat_block_range	*block_range = raid_bdev->module_private;
+	struct concat_io_iovs		*io_iovs;
+	struct raid_base_bdev_info	*base_info;
+	struct spdk_io_channel		*base_ch;
+	uint64_t			offset_blocks = bdev_io->u.bdev.offset_blocks;
+	uint64_t			num_blocks = bdev_io->u.bdev.num_blocks;
+	uint64_t			pd_lba;
+	uint64_t			pd_blocks;
+	uint64_t			io_offset;
+	uint32_t			blocklen = raid_bdev->bdev.blocklen;
+	struct iovec			*iovs;
+	int				iovcnt;
+	int				n_disks;
+	int				i;
+	int				ret;
+
+	for (i = start_idx, n_disks = 0; num_blocks > 0; i++, n_disks++) {
+		assert(i < raid_bdev->num_base_bdevs);
+		pd_lba = offset_blocks - block_range[i].start;
+		pd_blocks = spdk_min(num_blocks, block_range[i].length - pd_lba);
+		offset_blocks += pd_blocks;
+		num_blocks -= pd_blocks;
+	}
+
+	io_iovs = raid_io->module_private;
+	if (io_iovs == NULL) {
+		/* Each base bdev boundary splits at most one iovec of the payload in two */
+		iovcnt = bdev_io->u.bdev.iovcnt + n_disks - 1;
+		io_iovs = malloc(sizeof(*io_iovs) + iovcnt * sizeof(struct iovec));
+		if (io_iovs == NULL) {
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_NOMEM);
+			return;
+		}
+		io_iovs->used = 0;
+		raid_io->module_private = io_iovs;
+		raid_io->base_bdev_io_remaining = n_disks;
+	}
+
+	io_opts.size = sizeof(io_opts);
+	io_opts.memory_domain = bdev_io->u.bdev.memory_domain;
+	io_opts.memory_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
+
+	offset_blocks = bdev_io->u.bdev.offset_blocks;
+	num_blocks = bdev_io->u.bdev.num_blocks;
+	for (i = start_idx; i < start_idx + n_disks; i++) {
+		pd_lba = offset_blocks - block_range[i].start;
+		pd_blocks = spdk_min(num_blocks, block_range[i].length - pd_lba);
+		/* Offset of this base bdev's part in the payload of the raid IO */
+		io_offset = offset_blocks - bdev_io->u.bdev.offset_blocks;
+		offset_blocks += pd_blocks;
+		num_blocks -= pd_blocks;
+		/*
+		 * Skip the IOs we have submitted
+		 */
+		if (i < start_idx + raid_io->base_bdev_io_submitted) {
+			continue;
+		}
+
+		base_info = &raid_bdev->base_bdev_info[i];
+		base_ch = raid_io->raid_ch->base_channel[i];
+
+		iovs = &io_iovs->iovs[io_iovs->used];
+		iovcnt = raid_bdev_iovs_slice(iovs, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					      io_offset * blocklen, pd_blocks * blocklen);
+		/*
+		 * Claim the entries before submitting, the last base bdev IO may complete
+		 * and release io_iovs before the submit function returns.
+		 */
+		io_iovs->used += iovcnt;
+		io_opts.metadata = NULL;
+		if (bdev_io->u.bdev.md_buf != NULL) {
+			io_opts.metadata = (uint8_t *)bdev_io->u.bdev.md_buf +
+					   io_offset * raid_bdev->bdev.md_len;
+		}
+
+		if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+			ret = spdk_bdev_readv_blocks_ext(base_info->desc, base_ch, iovs, iovcnt,
+							 pd_lba, pd_blocks,
+							 concat_multi_disk_io_completion, raid_io,
+							 &io_opts);
+		} else if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+			ret = spdk_bdev_writev_blocks_ext(base_info->desc, base_ch, iovs, iovcnt,
+							  pd_lba, pd_blocks,
+							  concat_multi_disk_io_completion, raid_io,
+							  &io_opts);
+		} else {
+			SPDK_ERRLOG("Recvd not supported io type %u\n", bdev_io->type);
+			assert(0);
+			ret = -EIO;
+		}
+
+		if (ret == 0) {
+			raid_io->base_bdev_io_submitted++;
+			continue;
+		}
+
+		io_iovs->used -= iovcnt;
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, _concat_submit_multi_disk_rw_request);
+			return;
+		} else {
+			SPDK_ERRLOG("bdev io submit error not due to ENOMEM, "
+				    "it should not happen\n");
+			assert(false);
+			/* Complete the raid IO once the base bdev IOs already submitted are done */
+			concat_multi_disk_complete_part(raid_io, n_disks -
+							raid_io->base_bdev_io_submitted,
+							SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+	}
+}
+
 static void concat_submit_null_payload_request(struct raid_bdev_io *raid_io);
 
 static void
@@ -303,8 +488,9 @@ concat_start(struct raid_bdev *raid_bdev)
 		      total_blockcnt, raid_bdev->num_base_bdevs, raid_bdev->strip_size_shift);
 	raid_bdev->bdev.blockcnt = total_blockcnt;
 
+	/* Reads and writes spanning several base bdevs are sent as one IO per base bdev */
 	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
-	raid_bdev->bdev.split_on_optimal_io_boundary = true;
+	raid_bdev->bdev.split_on_optimal_io_boundary = false;
 
 	return 0;
 }
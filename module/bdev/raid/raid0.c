@@ -39,6 +39,7 @@ raid0_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_ar
 }
 
 static void raid0_submit_rw_request(struct raid_bdev_io *raid_io);
+static void raid0_submit_multi_strip_rw_request(struct raid_bdev_io *raid_io);
 
 static void
 _raid0_submit_rw_request(void *_raid_io)
@@ -79,9 +80,7 @@ raid0_submit_rw_request(struct raid_bdev_io *raid_io)
 	end_strip = (bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks - 1) >>
 		    raid_bdev->strip_size_shift;
 	if (start_strip != end_strip && raid_bdev->num_base_bdevs > 1) {
-		assert(false);
-		SPDK_ERRLOG("I/O spans strip boundary!\n");
-		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		raid0_submit_multi_strip_rw_request(raid_io);
 		return;
 	}
 
@@ -233,6 +232,195 @@ _raid0_split_io_range(struct raid_bdev_io_range *io_range, uint8_t disk_idx,
 	*_nblocks_in_disk = nblocks_in_disk;
 }
 
+/* Payload of the base bdev IOs of a read or write spanning several strips */
+struct raid0_io_iovs {
+	/* Number of entries of iovs used by the base bdev IOs submitted so far */
+	int		used;
+	struct iovec	iovs[];
+};
+
+static bool
+raid0_multi_strip_complete_part(struct raid_bdev_io *raid_io, uint64_t completed,
+				enum spdk_bdev_io_status status)
+{
+	if (raid_io->base_bdev_io_remaining == completed) {
+		free(raid_io->module_private);
+		raid_io->module_private = NULL;
+	}
+
+	return raid_bdev_io_complete_part(raid_io, completed, status);
+}
+
+static void
+raid0_multi_strip_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid0_multi_strip_complete_part(raid_io, 1, success ?
+					SPDK_BDEV_IO_STATUS_SUCCESS :
+					SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+/*
+ * Gather the parts of the payload of the raid IO that belong to the strips of
+ * base bdev disk_idx. They are contiguous on the base bdev, so they can be sent
+ * to it as a single IO.
+ */
+static int
+raid0_get_disk_iovs(struct raid_bdev_io *raid_io, struct raid_bdev_io_range *io_range,
+		    uint8_t disk_idx, struct iovec *iovs)
+{
+	struct spdk_bdev_io	*bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev	*raid_bdev = raid_io->raid_bdev;
+	uint64_t		start = bdev_io->u.bdev.offset_blocks;
+	uint64_t		end = start + bdev_io->u.bdev.num_blocks;
+	uint64_t		start_strip = start >> raid_bdev->strip_size_shift;
+	uint64_t		end_strip = (end - 1) >> raid_bdev->strip_size_shift;
+	uint64_t		strip, seg_start, seg_end;
+	uint32_t		blocklen = raid_bdev->bdev.blocklen;
+	int			iovcnt = 0;
+
+	strip = start_strip + (disk_idx + raid_bdev->num_base_bdevs - io_range->start_disk) %
+		raid_bdev->num_base_bdevs;
+	for (; strip <= end_strip; strip += raid_bdev->num_base_bdevs) {
+		seg_start = spdk_max(start, strip << raid_bdev->strip_size_shift);
+		seg_end = spdk_min(end, (strip + 1) << raid_bdev->strip_size_shift);
+
+		iovcnt += raid_bdev_iovs_slice(&iovs[iovcnt], bdev_io->u.bdev.iovs,
+					       bdev_io->u.bdev.iovcnt,
+					       (seg_start - start) * blocklen,
+					       (seg_end - seg_start) * blocklen);
+	}
+
+	return iovcnt;
+}
+
+static void
+_raid0_submit_multi_strip_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid0_submit_multi_strip_rw_request(raid_io);
+}
+
+/*
+ * brief:
+ * raid0_submit_multi_strip_rw_request submits a read or write spanning several
+ * strips as one IO per base bdev involved, each gathering the parts of the
+ * payload that belong to the strips of its base bdev. It will submit as many as
+ * possible unless one base io request fails with -ENOMEM, in which case it will
+ * queue itself for later submission.
+ * params:
+ * raid_io
+ * returns:
+ * none
+ */
+static void
+raid0_submit_multi_strip_rw_request(struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev_io		*bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct spdk_bdev_ext_io_opts	io_opts = {};
+	struct raid_bdev		*raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev_io_range	io_range;
+	struct raid0_io_iovs		*io_iovs;
+	struct raid_base_bdev_info	*base_info;
+	struct spdk_io_channel		*base_ch;
+	struct iovec			*iovs;
+	int				iovcnt;
+	int				ret;
+
+	/* Separate metadata can't be gathered, such IOs are split on strip boundaries */
+	assert(bdev_io->u.bdev.md_buf == NULL);
+
+	_raid0_get_io_range(&io_range, raid_bdev->num_base_bdevs,
+			    raid_bdev->strip_size, raid_bdev->strip_size_shift,
+			    bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks);
+
+	io_iovs = raid_io->module_private;
+	if (io_iovs == NULL) {
+		/*
+		 * Each strip boundary splits at most one iovec of the payload in two,
+		 * so this is enough for the base bdev IOs of all the base bdevs.
+		 */
+		iovcnt = bdev_io->u.bdev.iovcnt +
+			 ((bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks - 1) >>
+			  raid_bdev->strip_size_shift) -
+			 (bdev_io->u.bdev.offset_blocks >> raid_bdev->strip_size_shift);
+		io_iovs = malloc(sizeof(*io_iovs) + iovcnt * sizeof(struct iovec));
+		if (io_iovs == NULL) {
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_NOMEM);
+			return;
+		}
+		io_iovs->used = 0;
+		raid_io->module_private = io_iovs;
+		raid_io->base_bdev_io_remaining = io_range.n_disks_involved;
+	}
+
+	io_opts.size = sizeof(io_opts);
+	io_opts.memory_domain = bdev_io->u.bdev.memory_domain;
+	io_opts.memory_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
+
+	while (raid_io->base_bdev_io_submitted < io_range.n_disks_involved) {
+		uint8_t disk_idx;
+		uint64_t offset_in_disk;
+		uint64_t nblocks_in_disk;
+
+		disk_idx = (io_range.start_disk + raid_io->base_bdev_io_submitted) %
+			   raid_bdev->num_base_bdevs;
+		base_info = &raid_bdev->base_bdev_info[disk_idx];
+		base_ch = raid_io->raid_ch->base_channel[disk_idx];
+
+		_raid0_split_io_range(&io_range, disk_idx, &offset_in_disk, &nblocks_in_disk);
+
+		iovs = &io_iovs->iovs[io_iovs->used];
+		iovcnt = raid0_get_disk_iovs(raid_io, &io_range, disk_idx, iovs);
+		/*
+		 * Claim the entries before submitting, the last base bdev IO may complete
+		 * and release io_iovs before the submit function returns.
+		 */
+		io_iovs->used += iovcnt;
+
+		if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+			ret = spdk_bdev_readv_blocks_ext(base_info->desc, base_ch, iovs, iovcnt,
+							 offset_in_disk, nblocks_in_disk,
+							 raid0_multi_strip_io_completion, raid_io,
+							 &io_opts);
+		} else if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+			ret = spdk_bdev_writev_blocks_ext(base_info->desc, base_ch, iovs, iovcnt,
+							  offset_in_disk, nblocks_in_disk,
+							  raid0_multi_strip_io_completion, raid_io,
+							  &io_opts);
+		} else {
+			SPDK_ERRLOG("Recvd not supported io type %u\n", bdev_io->type);
+			assert(0);
+			ret = -EIO;
+		}
+
+		if (ret == 0) {
+			raid_io->base_bdev_io_submitted++;
+			continue;
+		}
+
+		io_iovs->used -= iovcnt;
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, _raid0_submit_multi_strip_rw_request);
+			return;
+		} else {
+			SPDK_ERRLOG("bdev io submit error not due to ENOMEM, "
+				    "it should not happen\n");
+			assert(false);
+			/* Complete the raid IO once the base bdev IOs already submitted are done */
+			raid0_multi_strip_complete_part(raid_io, io_range.n_disks_involved -
+							raid_io->base_bdev_io_submitted,
+							SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+	}
+}
+
 static void raid0_submit_null_payload_request(struct raid_bdev_io *raid_io);
 
 static void
@@ -364,8 +552,13 @@ raid0_start(struct raid_bdev *raid_bdev)
 	raid_bdev->bdev.blockcnt = raid0_calculate_blockcnt(raid_bdev);
 
 	if (raid_bdev->num_base_bdevs > 1) {
+		/*
+		 * Reads and writes spanning several strips are sent as one IO per base
+		 * bdev, unless their separate metadata would have to be gathered too.
+		 */
 		raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
-		raid_bdev->bdev.split_on_optimal_io_boundary = true;
+		raid_bdev->bdev.split_on_optimal_io_boundary = raid_bdev->bdev.md_len != 0 &&
+				!raid_bdev->bdev.md_interleave;
 	} else {
 		/* Do not need to split reads/writes on single bdev RAID modules. */
 		raid_bdev->bdev.optimal_io_boundary = 0;
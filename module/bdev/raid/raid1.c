@@ -5,12 +5,28 @@
 
 #include "bdev_raid.h"
 
+#include "spdk/thread.h"
+#include "spdk/util.h"
 #include "spdk/likely.h"
 #include "spdk/log.h"
 
+/* Size of the LBA range mapped to a single base bdev by the lba_shard read policy */
+#define RAID1_READ_SHARD_SIZE_KB 1024
+
 struct raid1_info {
 	/* The parent raid bdev */
 	struct raid_bdev *raid_bdev;
+
+	/* Shift converting an LBA to a read shard index for the lba_shard policy */
+	uint32_t read_shard_shift;
+};
+
+struct raid1_io_channel {
+	/* Base bdev index to start the next round-robin search from */
+	uint8_t read_rr_idx;
+
+	/* Number of reads currently outstanding on each base bdev from this channel */
+	uint64_t read_outstanding[];
 };
 
 static void
@@ -25,6 +41,19 @@ raid1_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_ar
 				   SPDK_BDEV_IO_STATUS_FAILED);
 }
 
+static void
+raid1_read_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+	struct raid1_io_channel *r1ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+
+	/* For reads, base_bdev_io_submitted holds the index of the selected base bdev */
+	assert(r1ch->read_outstanding[raid_io->base_bdev_io_submitted] > 0);
+	r1ch->read_outstanding[raid_io->base_bdev_io_submitted]--;
+
+	raid1_bdev_io_completion(bdev_io, success, cb_arg);
+}
+
 static void raid1_submit_rw_request(struct raid_bdev_io *raid_io);
 
 static void
@@ -45,44 +74,114 @@ raid1_init_ext_io_opts(struct spdk_bdev_io *bdev_io, struct spdk_bdev_ext_io_opt
 	opts->metadata = bdev_io->u.bdev.md_buf;
 }
 
+/*
+ * Return the first base bdev with an open channel, searching circularly from 'start'.
+ * Returns num_base_bdevs if no base bdev is available.
+ */
+static uint8_t
+raid1_channel_next_available(struct raid_bdev_io_channel *raid_ch, uint8_t start)
+{
+	uint8_t i, idx;
+
+	for (i = 0; i < raid_ch->num_channels; i++) {
+		idx = (start + i) % raid_ch->num_channels;
+		if (raid_ch->base_channel[idx] != NULL) {
+			return idx;
+		}
+	}
+
+	return raid_ch->num_channels;
+}
+
+static uint8_t
+raid1_channel_least_outstanding(struct raid_bdev_io_channel *raid_ch,
+				struct raid1_io_channel *r1ch)
+{
+	uint8_t i, idx = raid_ch->num_channels;
+	uint64_t min_outstanding = UINT64_MAX;
+
+	/*
+	 * Start the scan from the round-robin position so that ties are broken
+	 * fairly instead of always favoring the lowest index.
+	 */
+	for (i = 0; i < raid_ch->num_channels; i++) {
+		uint8_t j = (r1ch->read_rr_idx + i) % raid_ch->num_channels;
+
+		if (raid_ch->base_channel[j] != NULL && r1ch->read_outstanding[j] < min_outstanding) {
+			min_outstanding = r1ch->read_outstanding[j];
+			idx = j;
+		}
+	}
+
+	return idx;
+}
+
+static uint8_t
+raid1_select_read_base_bdev(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid1_info *r1info = raid_bdev->module_private;
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct raid1_io_channel *r1ch = spdk_io_channel_get_ctx(raid_ch->module_channel);
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	uint64_t shard;
+	uint8_t idx;
+
+	switch (raid_bdev->read_policy) {
+	case RAID_BDEV_READ_POLICY_LEAST_OUTSTANDING:
+		idx = raid1_channel_least_outstanding(raid_ch, r1ch);
+		r1ch->read_rr_idx = (r1ch->read_rr_idx + 1) % raid_ch->num_channels;
+		break;
+	case RAID_BDEV_READ_POLICY_LBA_SHARD:
+		shard = bdev_io->u.bdev.offset_blocks >> r1info->read_shard_shift;
+		idx = raid1_channel_next_available(raid_ch, shard % raid_ch->num_channels);
+		break;
+	case RAID_BDEV_READ_POLICY_ROUND_ROBIN:
+	default:
+		idx = raid1_channel_next_available(raid_ch, r1ch->read_rr_idx);
+		r1ch->read_rr_idx = (idx + 1) % raid_ch->num_channels;
+		break;
+	}
+
+	return idx;
+}
+
 static int
 raid1_submit_read_request(struct raid_bdev_io *raid_io)
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid1_io_channel *r1ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
 	struct spdk_bdev_ext_io_opts io_opts;
-	uint8_t idx = 0;
+	uint8_t idx;
 	struct raid_base_bdev_info *base_info;
-	struct spdk_io_channel *base_ch = NULL;
+	struct spdk_io_channel *base_ch;
 	uint64_t pd_lba, pd_blocks;
 	int ret;
 
-	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
-		base_ch = raid_io->raid_ch->base_channel[idx];
-		if (base_ch != NULL) {
-			break;
-		}
-		idx++;
-	}
-
-	if (base_ch == NULL) {
+	idx = raid1_select_read_base_bdev(raid_io);
+	if (spdk_unlikely(idx >= raid_bdev->num_base_bdevs)) {
 		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
 		return 0;
 	}
 
+	base_info = &raid_bdev->base_bdev_info[idx];
+	base_ch = raid_io->raid_ch->base_channel[idx];
+
 	pd_lba = bdev_io->u.bdev.offset_blocks;
 	pd_blocks = bdev_io->u.bdev.num_blocks;
 
 	raid_io->base_bdev_io_remaining = 1;
+	raid_io->base_bdev_io_submitted = idx;
 
 	raid1_init_ext_io_opts(bdev_io, &io_opts);
 	ret = spdk_bdev_readv_blocks_ext(base_info->desc, base_ch,
 					 bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
-					 pd_lba, pd_blocks, raid1_bdev_io_completion,
+					 pd_lba, pd_blocks, raid1_read_bdev_io_completion,
 					 raid_io, &io_opts);
 
 	if (spdk_likely(ret == 0)) {
-		raid_io->base_bdev_io_submitted++;
+		r1ch->read_outstanding[idx]++;
 	} else if (spdk_unlikely(ret == -ENOMEM)) {
 		raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
 					base_ch, _raid1_submit_rw_request);
@@ -175,12 +274,138 @@ raid1_submit_rw_request(struct raid_bdev_io *raid_io)
 	}
 }
 
+static void
+raid1_init_process_io_opts(struct raid_bdev_process_request *process_req,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->metadata = process_req->md_buf;
+}
+
+static void
+raid1_process_queue_io_wait(struct raid_bdev_process_request *process_req,
+			    struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    spdk_bdev_io_wait_cb cb_fn)
+{
+	process_req->waitq_entry.bdev = spdk_bdev_desc_get_bdev(desc);
+	process_req->waitq_entry.cb_fn = cb_fn;
+	process_req->waitq_entry.cb_arg = process_req;
+	spdk_bdev_queue_io_wait(process_req->waitq_entry.bdev, ch, &process_req->waitq_entry);
+}
+
+static void
+raid1_process_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void
+raid1_process_submit_write(void *_process_req)
+{
+	struct raid_bdev_process_request *process_req = _process_req;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid1_init_process_io_opts(process_req, &io_opts);
+	ret = spdk_bdev_writev_blocks_ext(process_req->target->desc, process_req->target_ch,
+					  &process_req->iov, 1, process_req->offset_blocks,
+					  process_req->num_blocks, raid1_process_write_completed,
+					  process_req, &io_opts);
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid1_process_queue_io_wait(process_req, process_req->target->desc,
+					    process_req->target_ch, raid1_process_submit_write);
+	} else if (spdk_unlikely(ret != 0)) {
+		raid_bdev_process_request_complete(process_req, ret);
+	}
+}
+
+static void
+raid1_process_read_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		raid_bdev_process_request_complete(process_req, -EIO);
+		return;
+	}
+
+	raid1_process_submit_write(process_req);
+}
+
+static void
+raid1_process_submit_read(void *_process_req)
+{
+	struct raid_bdev_process_request *process_req = _process_req;
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = process_req->raid_ch;
+	struct raid1_io_channel *r1ch = spdk_io_channel_get_ctx(raid_ch->module_channel);
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	uint8_t idx;
+	int ret;
+
+	/* Copy the range from the next in-sync base bdev to the target */
+	idx = raid1_channel_next_available(raid_ch, r1ch->read_rr_idx);
+	if (spdk_unlikely(idx >= raid_bdev->num_base_bdevs)) {
+		raid_bdev_process_request_complete(process_req, -ENODEV);
+		return;
+	}
+	r1ch->read_rr_idx = (idx + 1) % raid_ch->num_channels;
+	base_info = &raid_bdev->base_bdev_info[idx];
+
+	raid1_init_process_io_opts(process_req, &io_opts);
+	ret = spdk_bdev_readv_blocks_ext(base_info->desc, raid_ch->base_channel[idx],
+					 &process_req->iov, 1, process_req->offset_blocks,
+					 process_req->num_blocks, raid1_process_read_completed,
+					 process_req, &io_opts);
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid1_process_queue_io_wait(process_req, base_info->desc, raid_ch->base_channel[idx],
+					    raid1_process_submit_read);
+	} else if (spdk_unlikely(ret != 0)) {
+		raid_bdev_process_request_complete(process_req, ret);
+	}
+}
+
+static int
+raid1_submit_process_request(struct raid_bdev_process_request *process_req)
+{
+	raid1_process_submit_read(process_req);
+
+	return 0;
+}
+
+static int
+raid1_ioch_create(void *io_device, void *ctx_buf)
+{
+	struct raid1_io_channel *r1ch = ctx_buf;
+	struct raid1_info *r1info = io_device;
+
+	memset(r1ch->read_outstanding, 0,
+	       r1info->raid_bdev->num_base_bdevs * sizeof(r1ch->read_outstanding[0]));
+	r1ch->read_rr_idx = 0;
+
+	return 0;
+}
+
+static void
+raid1_ioch_destroy(void *io_device, void *ctx_buf)
+{
+}
+
 static int
 raid1_start(struct raid_bdev *raid_bdev)
 {
 	uint64_t min_blockcnt = UINT64_MAX;
 	struct raid_base_bdev_info *base_info;
 	struct raid1_info *r1info;
+	uint32_t shard_blocks;
 
 	r1info = calloc(1, sizeof(*r1info));
 	if (!r1info) {
@@ -193,20 +418,45 @@ raid1_start(struct raid_bdev *raid_bdev)
 		min_blockcnt = spdk_min(min_blockcnt, spdk_bdev_desc_get_bdev(base_info->desc)->blockcnt);
 	}
 
+	shard_blocks = spdk_max(RAID1_READ_SHARD_SIZE_KB * 1024 >> raid_bdev->blocklen_shift, 1);
+	r1info->read_shard_shift = spdk_u32log2(shard_blocks);
+
 	raid_bdev->bdev.blockcnt = min_blockcnt;
 	raid_bdev->module_private = r1info;
 
+	spdk_io_device_register(r1info, raid1_ioch_create, raid1_ioch_destroy,
+				sizeof(struct raid1_io_channel) +
+				raid_bdev->num_base_bdevs * sizeof(uint64_t), NULL);
+
 	return 0;
 }
 
+static void
+raid1_io_device_unregister_done(void *io_device)
+{
+	struct raid1_info *r1info = io_device;
+
+	raid_bdev_module_stop_done(r1info->raid_bdev);
+
+	free(r1info);
+}
+
 static bool
 raid1_stop(struct raid_bdev *raid_bdev)
 {
 	struct raid1_info *r1info = raid_bdev->module_private;
 
-	free(r1info);
+	spdk_io_device_unregister(r1info, raid1_io_device_unregister_done);
+
+	return false;
+}
+
+static struct spdk_io_channel *
+raid1_get_io_channel(struct raid_bdev *raid_bdev)
+{
+	struct raid1_info *r1info = raid_bdev->module_private;
 
-	return true;
+	return spdk_get_io_channel(r1info);
 }
 
 static struct raid_bdev_module g_raid1_module = {
@@ -214,9 +464,12 @@ static struct raid_bdev_module g_raid1_module = {
 	.base_bdevs_min = 2,
 	.base_bdevs_constraint = {CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL, 1},
 	.memory_domains_supported = true,
+	.read_policy_supported = true,
 	.start = raid1_start,
 	.stop = raid1_stop,
 	.submit_rw_request = raid1_submit_rw_request,
+	.get_io_channel = raid1_get_io_channel,
+	.submit_process_request = raid1_submit_process_request,
 };
 RAID_MODULE_REGISTER(&g_raid1_module)
 
@@ -0,0 +1,710 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "bdev_raid.h"
+
+#include "spdk/thread.h"
+#include "spdk/util.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+
+/*
+ * raid10 uses the "near 2" layout: base bdevs are grouped into mirrored pairs
+ * {0, 1}, {2, 3}, ... and data is striped across the pairs like raid0.
+ */
+#define RAID10_MIRRORS 2
+
+/* Size of the LBA range mapped to a single mirror by the lba_shard read policy */
+#define RAID10_READ_SHARD_SIZE_KB 1024
+
+struct raid10_info {
+	/* The parent raid bdev */
+	struct raid_bdev *raid_bdev;
+
+	/* Number of mirrored pairs the data is striped across */
+	uint8_t num_legs;
+
+	/* Shift converting a base bdev LBA to a read shard index for the lba_shard policy */
+	uint32_t read_shard_shift;
+};
+
+struct raid10_io_channel {
+	/* Mirror to select for the next round-robin read */
+	uint8_t read_rr_idx;
+
+	/* Number of reads currently outstanding on each base bdev from this channel */
+	uint64_t read_outstanding[];
+};
+
+static inline uint8_t
+raid10_leg_to_base_bdev(uint8_t leg, uint8_t mirror)
+{
+	return leg * RAID10_MIRRORS + mirror;
+}
+
+static void
+raid10_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_io_complete_part(raid_io, 1, success ?
+				   SPDK_BDEV_IO_STATUS_SUCCESS :
+				   SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+raid10_read_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+	struct raid10_io_channel *r10ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+
+	/* For reads, base_bdev_io_submitted holds the index of the selected base bdev */
+	assert(r10ch->read_outstanding[raid_io->base_bdev_io_submitted] > 0);
+	r10ch->read_outstanding[raid_io->base_bdev_io_submitted]--;
+
+	raid10_bdev_io_completion(bdev_io, success, cb_arg);
+}
+
+static void raid10_submit_rw_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid10_submit_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid10_submit_rw_request(raid_io);
+}
+
+static void
+raid10_init_ext_io_opts(struct spdk_bdev_io *bdev_io, struct spdk_bdev_ext_io_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->memory_domain = bdev_io->u.bdev.memory_domain;
+	opts->memory_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
+	opts->metadata = bdev_io->u.bdev.md_buf;
+}
+
+/*
+ * Select the mirror of a leg to read from according to the read policy.
+ * Returns the base bdev index or num_base_bdevs if neither mirror is available.
+ */
+static uint8_t
+raid10_select_read_base_bdev(struct raid_bdev_io *raid_io, uint8_t leg, uint64_t pd_lba)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid10_info *r10info = raid_bdev->module_private;
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct raid10_io_channel *r10ch = spdk_io_channel_get_ctx(raid_ch->module_channel);
+	uint8_t idx0 = raid10_leg_to_base_bdev(leg, 0);
+	uint8_t idx1 = raid10_leg_to_base_bdev(leg, 1);
+	uint8_t mirror;
+
+	if (raid_ch->base_channel[idx0] == NULL) {
+		return raid_ch->base_channel[idx1] != NULL ? idx1 : raid_bdev->num_base_bdevs;
+	} else if (raid_ch->base_channel[idx1] == NULL) {
+		return idx0;
+	}
+
+	switch (raid_bdev->read_policy) {
+	case RAID_BDEV_READ_POLICY_LEAST_OUTSTANDING:
+		if (r10ch->read_outstanding[idx0] == r10ch->read_outstanding[idx1]) {
+			mirror = r10ch->read_rr_idx;
+			r10ch->read_rr_idx ^= 1;
+		} else {
+			mirror = r10ch->read_outstanding[idx0] > r10ch->read_outstanding[idx1];
+		}
+		break;
+	case RAID_BDEV_READ_POLICY_LBA_SHARD:
+		mirror = (pd_lba >> r10info->read_shard_shift) % RAID10_MIRRORS;
+		break;
+	case RAID_BDEV_READ_POLICY_ROUND_ROBIN:
+	default:
+		mirror = r10ch->read_rr_idx;
+		r10ch->read_rr_idx ^= 1;
+		break;
+	}
+
+	return raid10_leg_to_base_bdev(leg, mirror);
+}
+
+static int
+raid10_submit_read_request(struct raid_bdev_io *raid_io, uint8_t leg, uint64_t pd_lba)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid10_io_channel *r10ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint8_t idx;
+	int ret;
+
+	idx = raid10_select_read_base_bdev(raid_io, leg, pd_lba);
+	if (spdk_unlikely(idx >= raid_bdev->num_base_bdevs)) {
+		return -ENODEV;
+	}
+
+	base_info = &raid_bdev->base_bdev_info[idx];
+	base_ch = raid_io->raid_ch->base_channel[idx];
+
+	raid_io->base_bdev_io_remaining = 1;
+	raid_io->base_bdev_io_submitted = idx;
+
+	raid10_init_ext_io_opts(bdev_io, &io_opts);
+	ret = spdk_bdev_readv_blocks_ext(base_info->desc, base_ch,
+					 bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					 pd_lba, bdev_io->u.bdev.num_blocks,
+					 raid10_read_bdev_io_completion, raid_io, &io_opts);
+
+	if (spdk_likely(ret == 0)) {
+		r10ch->read_outstanding[idx]++;
+	} else if (spdk_unlikely(ret == -ENOMEM)) {
+		raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+					base_ch, _raid10_submit_rw_request);
+		return 0;
+	}
+
+	return ret;
+}
+
+static int
+raid10_submit_write_request(struct raid_bdev_io *raid_io, uint8_t leg, uint64_t pd_lba)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint8_t mirror, idx;
+	int ret;
+
+	if (raid_io->base_bdev_io_submitted == 0) {
+		raid_io->base_bdev_io_remaining = RAID10_MIRRORS;
+	}
+
+	raid10_init_ext_io_opts(bdev_io, &io_opts);
+	for (mirror = raid_io->base_bdev_io_submitted; mirror < RAID10_MIRRORS; mirror++) {
+		idx = raid10_leg_to_base_bdev(leg, mirror);
+		base_info = &raid_bdev->base_bdev_info[idx];
+		base_ch = raid_io->raid_ch->base_channel[idx];
+
+		if (base_ch == NULL) {
+			/* skip a missing base bdev's slot */
+			raid_io->base_bdev_io_submitted++;
+			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			continue;
+		}
+
+		ret = spdk_bdev_writev_blocks_ext(base_info->desc, base_ch,
+						  bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+						  pd_lba, bdev_io->u.bdev.num_blocks,
+						  raid10_bdev_io_completion, raid_io, &io_opts);
+		if (spdk_unlikely(ret != 0)) {
+			if (spdk_unlikely(ret == -ENOMEM)) {
+				raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+							base_ch, _raid10_submit_rw_request);
+				return 0;
+			}
+
+			raid_bdev_io_complete_part(raid_io, RAID10_MIRRORS - raid_io->base_bdev_io_submitted,
+						   SPDK_BDEV_IO_STATUS_FAILED);
+			return 0;
+		}
+
+		raid_io->base_bdev_io_submitted++;
+	}
+
+	return 0;
+}
+
+/*
+ * brief:
+ * raid10_submit_rw_request function maps the I/O to a mirrored pair the same way
+ * raid0 maps it to a base bdev, then reads from one of the mirrors or writes to both.
+ * params:
+ * raid_io
+ * returns:
+ * none
+ */
+static void
+raid10_submit_rw_request(struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t start_strip, end_strip, pd_strip, pd_lba;
+	uint32_t offset_in_strip;
+	uint8_t leg;
+	int ret;
+
+	start_strip = bdev_io->u.bdev.offset_blocks >> raid_bdev->strip_size_shift;
+	end_strip = (bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks - 1) >>
+		    raid_bdev->strip_size_shift;
+	if (start_strip != end_strip) {
+		assert(false);
+		SPDK_ERRLOG("I/O spans strip boundary!\n");
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	pd_strip = start_strip / r10info->num_legs;
+	leg = start_strip % r10info->num_legs;
+	offset_in_strip = bdev_io->u.bdev.offset_blocks & (raid_bdev->strip_size - 1);
+	pd_lba = (pd_strip << raid_bdev->strip_size_shift) + offset_in_strip;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		ret = raid10_submit_read_request(raid_io, leg, pd_lba);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		ret = raid10_submit_write_request(raid_io, leg, pd_lba);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret != 0)) {
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+/* raid10 IO range, in terms of mirrored pairs */
+struct raid10_io_range {
+	uint64_t	strip_size;
+	uint64_t	start_strip_in_disk;
+	uint64_t	end_strip_in_disk;
+	uint64_t	start_offset_in_strip;
+	uint64_t	end_offset_in_strip;
+	uint8_t		start_leg;
+	uint8_t		end_leg;
+	uint8_t		n_legs_involved;
+};
+
+static inline void
+_raid10_get_io_range(struct raid10_io_range *io_range,
+		     uint8_t num_legs, uint64_t strip_size, uint64_t strip_size_shift,
+		     uint64_t offset_blocks, uint64_t num_blocks)
+{
+	uint64_t	start_strip;
+	uint64_t	end_strip;
+	uint64_t	total_blocks;
+
+	io_range->strip_size = strip_size;
+	total_blocks = offset_blocks + num_blocks - (num_blocks > 0);
+
+	start_strip = offset_blocks >> strip_size_shift;
+	end_strip = total_blocks >> strip_size_shift;
+	io_range->start_strip_in_disk = start_strip / num_legs;
+	io_range->end_strip_in_disk = end_strip / num_legs;
+
+	io_range->start_offset_in_strip = offset_blocks % strip_size;
+	io_range->end_offset_in_strip = total_blocks % strip_size;
+
+	io_range->start_leg = start_strip % num_legs;
+	io_range->end_leg = end_strip % num_legs;
+
+	io_range->n_legs_involved = spdk_min((end_strip - start_strip + 1), num_legs);
+}
+
+static inline void
+_raid10_split_io_range(struct raid10_io_range *io_range, uint8_t leg,
+		       uint64_t *_offset_in_disk, uint64_t *_nblocks_in_disk)
+{
+	uint64_t n_strips_in_disk;
+	uint64_t start_offset_in_disk;
+	uint64_t end_offset_in_disk;
+	uint64_t start_strip_in_disk;
+	uint64_t end_strip_in_disk;
+
+	start_strip_in_disk = io_range->start_strip_in_disk;
+	if (leg < io_range->start_leg) {
+		start_strip_in_disk += 1;
+	}
+
+	end_strip_in_disk = io_range->end_strip_in_disk;
+	if (leg > io_range->end_leg) {
+		end_strip_in_disk -= 1;
+	}
+
+	assert(end_strip_in_disk >= start_strip_in_disk);
+	n_strips_in_disk = end_strip_in_disk - start_strip_in_disk + 1;
+
+	start_offset_in_disk = leg == io_range->start_leg ? io_range->start_offset_in_strip : 0;
+	end_offset_in_disk = leg == io_range->end_leg ? io_range->end_offset_in_strip :
+			     io_range->strip_size - 1;
+
+	*_offset_in_disk = start_offset_in_disk + start_strip_in_disk * io_range->strip_size;
+	*_nblocks_in_disk = (n_strips_in_disk - 1) * io_range->strip_size
+			    + end_offset_in_disk - start_offset_in_disk + 1;
+}
+
+static void raid10_submit_null_payload_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid10_submit_null_payload_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid10_submit_null_payload_request(raid_io);
+}
+
+/*
+ * brief:
+ * raid10_submit_null_payload_request function submits io requests with range
+ * but without payload, like FLUSH and UNMAP, to both mirrors of every involved pair.
+ * params:
+ * raid_io
+ * returns:
+ * none
+ */
+static void
+raid10_submit_null_payload_request(struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev_io		*bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev		*raid_bdev = raid_io->raid_bdev;
+	struct raid10_info		*r10info = raid_bdev->module_private;
+	struct raid10_io_range		io_range;
+	struct raid_base_bdev_info	*base_info;
+	struct spdk_io_channel		*base_ch;
+	uint64_t			n_ios;
+	int				ret;
+
+	_raid10_get_io_range(&io_range, r10info->num_legs,
+			     raid_bdev->strip_size, raid_bdev->strip_size_shift,
+			     bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks);
+
+	n_ios = io_range.n_legs_involved * RAID10_MIRRORS;
+	if (raid_io->base_bdev_io_remaining == 0) {
+		raid_io->base_bdev_io_remaining = n_ios;
+	}
+
+	while (raid_io->base_bdev_io_submitted < n_ios) {
+		uint8_t leg, idx;
+		uint64_t offset_in_disk;
+		uint64_t nblocks_in_disk;
+
+		leg = (io_range.start_leg + raid_io->base_bdev_io_submitted / RAID10_MIRRORS) %
+		      r10info->num_legs;
+		idx = raid10_leg_to_base_bdev(leg, raid_io->base_bdev_io_submitted % RAID10_MIRRORS);
+		base_info = &raid_bdev->base_bdev_info[idx];
+		base_ch = raid_io->raid_ch->base_channel[idx];
+
+		if (base_ch == NULL) {
+			raid_io->base_bdev_io_submitted++;
+			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			continue;
+		}
+
+		_raid10_split_io_range(&io_range, leg, &offset_in_disk, &nblocks_in_disk);
+
+		switch (bdev_io->type) {
+		case SPDK_BDEV_IO_TYPE_UNMAP:
+			ret = spdk_bdev_unmap_blocks(base_info->desc, base_ch,
+						     offset_in_disk, nblocks_in_disk,
+						     raid10_bdev_io_completion, raid_io);
+			break;
+
+		case SPDK_BDEV_IO_TYPE_FLUSH:
+			ret = spdk_bdev_flush_blocks(base_info->desc, base_ch,
+						     offset_in_disk, nblocks_in_disk,
+						     raid10_bdev_io_completion, raid_io);
+			break;
+
+		default:
+			SPDK_ERRLOG("submit request, invalid io type with null payload %u\n", bdev_io->type);
+			assert(false);
+			ret = -EIO;
+		}
+
+		if (ret == 0) {
+			raid_io->base_bdev_io_submitted++;
+		} else if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, _raid10_submit_null_payload_request);
+			return;
+		} else {
+			SPDK_ERRLOG("bdev io submit error not due to ENOMEM, it should not happen\n");
+			assert(false);
+			raid_bdev_io_complete_part(raid_io, n_ios - raid_io->base_bdev_io_submitted,
+						   SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+	}
+}
+
+static void
+raid10_init_process_io_opts(struct raid_bdev_process_request *process_req,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->metadata = process_req->md_buf;
+}
+
+static void
+raid10_process_queue_io_wait(struct raid_bdev_process_request *process_req,
+			     struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			     spdk_bdev_io_wait_cb cb_fn)
+{
+	process_req->waitq_entry.bdev = spdk_bdev_desc_get_bdev(desc);
+	process_req->waitq_entry.cb_fn = cb_fn;
+	process_req->waitq_entry.cb_arg = process_req;
+	spdk_bdev_queue_io_wait(process_req->waitq_entry.bdev, ch, &process_req->waitq_entry);
+}
+
+static inline uint64_t
+raid10_process_pd_lba(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t strip = process_req->offset_blocks >> raid_bdev->strip_size_shift;
+
+	return ((strip / r10info->num_legs) << raid_bdev->strip_size_shift) +
+	       (process_req->offset_blocks & (raid_bdev->strip_size - 1));
+}
+
+static void
+raid10_process_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void
+raid10_process_submit_write(void *_process_req)
+{
+	struct raid_bdev_process_request *process_req = _process_req;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid10_init_process_io_opts(process_req, &io_opts);
+	ret = spdk_bdev_writev_blocks_ext(process_req->target->desc, process_req->target_ch,
+					  &process_req->iov, 1, raid10_process_pd_lba(process_req),
+					  process_req->num_blocks, raid10_process_write_completed,
+					  process_req, &io_opts);
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid10_process_queue_io_wait(process_req, process_req->target->desc,
+					     process_req->target_ch, raid10_process_submit_write);
+	} else if (spdk_unlikely(ret != 0)) {
+		raid_bdev_process_request_complete(process_req, ret);
+	}
+}
+
+static void
+raid10_process_read_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		raid_bdev_process_request_complete(process_req, -EIO);
+		return;
+	}
+
+	raid10_process_submit_write(process_req);
+}
+
+static void
+raid10_process_submit_read(void *_process_req)
+{
+	struct raid_bdev_process_request *process_req = _process_req;
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	uint8_t target_idx = process_req->target - raid_bdev->base_bdev_info;
+	uint8_t idx = target_idx ^ 1;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[idx];
+	struct spdk_io_channel *base_ch = process_req->raid_ch->base_channel[idx];
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	/* The only copy of the target's data is on the other mirror of its leg */
+	if (spdk_unlikely(base_ch == NULL)) {
+		raid_bdev_process_request_complete(process_req, -ENODEV);
+		return;
+	}
+
+	raid10_init_process_io_opts(process_req, &io_opts);
+	ret = spdk_bdev_readv_blocks_ext(base_info->desc, base_ch, &process_req->iov, 1,
+					 raid10_process_pd_lba(process_req), process_req->num_blocks,
+					 raid10_process_read_completed, process_req, &io_opts);
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid10_process_queue_io_wait(process_req, base_info->desc, base_ch,
+					     raid10_process_submit_read);
+	} else if (spdk_unlikely(ret != 0)) {
+		raid_bdev_process_request_complete(process_req, ret);
+	}
+}
+
+static int
+raid10_submit_process_request(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint8_t target_leg = (process_req->target - raid_bdev->base_bdev_info) / RAID10_MIRRORS;
+	uint64_t strip = process_req->offset_blocks >> raid_bdev->strip_size_shift;
+	uint64_t offset_in_strip = process_req->offset_blocks & (raid_bdev->strip_size - 1);
+	uint8_t leg = strip % r10info->num_legs;
+	uint64_t num_strips;
+
+	if (leg != target_leg) {
+		/* Skip the strips up to the next one on the target's leg */
+		num_strips = (target_leg + r10info->num_legs - leg) % r10info->num_legs;
+		process_req->num_blocks = spdk_min(process_req->num_blocks,
+						   (num_strips << raid_bdev->strip_size_shift) - offset_in_strip);
+		raid_bdev_process_request_complete(process_req, 0);
+		return 0;
+	}
+
+	process_req->num_blocks = spdk_min(process_req->num_blocks,
+					   raid_bdev->strip_size - offset_in_strip);
+	process_req->iov.iov_len = process_req->num_blocks * raid_bdev->bdev.blocklen;
+
+	raid10_process_submit_read(process_req);
+
+	return 0;
+}
+
+static uint64_t
+raid10_calculate_blockcnt(struct raid_bdev *raid_bdev)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+	uint64_t min_blockcnt = UINT64_MAX;
+	struct raid_base_bdev_info *base_info;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		min_blockcnt = spdk_min(min_blockcnt, spdk_bdev_desc_get_bdev(base_info->desc)->blockcnt);
+	}
+
+	return ((min_blockcnt >> raid_bdev->strip_size_shift) <<
+		raid_bdev->strip_size_shift) * r10info->num_legs;
+}
+
+static int
+raid10_ioch_create(void *io_device, void *ctx_buf)
+{
+	struct raid10_io_channel *r10ch = ctx_buf;
+	struct raid10_info *r10info = io_device;
+
+	memset(r10ch->read_outstanding, 0,
+	       r10info->raid_bdev->num_base_bdevs * sizeof(r10ch->read_outstanding[0]));
+	r10ch->read_rr_idx = 0;
+
+	return 0;
+}
+
+static void
+raid10_ioch_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+static int
+raid10_start(struct raid_bdev *raid_bdev)
+{
+	struct raid10_info *r10info;
+	uint32_t shard_blocks;
+
+	if (raid_bdev->num_base_bdevs % RAID10_MIRRORS != 0) {
+		SPDK_ERRLOG("raid10 requires an even number of base bdevs\n");
+		return -EINVAL;
+	}
+
+	r10info = calloc(1, sizeof(*r10info));
+	if (!r10info) {
+		SPDK_ERRLOG("Failed to allocate RAID10 info device structure\n");
+		return -ENOMEM;
+	}
+	r10info->raid_bdev = raid_bdev;
+	r10info->num_legs = raid_bdev->num_base_bdevs / RAID10_MIRRORS;
+
+	shard_blocks = spdk_max(RAID10_READ_SHARD_SIZE_KB * 1024 >> raid_bdev->blocklen_shift, 1);
+	r10info->read_shard_shift = spdk_u32log2(shard_blocks);
+
+	raid_bdev->module_private = r10info;
+	raid_bdev->bdev.blockcnt = raid10_calculate_blockcnt(raid_bdev);
+	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
+	raid_bdev->bdev.split_on_optimal_io_boundary = true;
+
+	spdk_io_device_register(r10info, raid10_ioch_create, raid10_ioch_destroy,
+				sizeof(struct raid10_io_channel) +
+				raid_bdev->num_base_bdevs * sizeof(uint64_t), NULL);
+
+	return 0;
+}
+
+static void
+raid10_io_device_unregister_done(void *io_device)
+{
+	struct raid10_info *r10info = io_device;
+
+	raid_bdev_module_stop_done(r10info->raid_bdev);
+
+	free(r10info);
+}
+
+static bool
+raid10_stop(struct raid_bdev *raid_bdev)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+
+	spdk_io_device_unregister(r10info, raid10_io_device_unregister_done);
+
+	return false;
+}
+
+static struct spdk_io_channel *
+raid10_get_io_channel(struct raid_bdev *raid_bdev)
+{
+	struct raid10_info *r10info = raid_bdev->module_private;
+
+	return spdk_get_io_channel(r10info);
+}
+
+static void
+raid10_resize(struct raid_bdev *raid_bdev)
+{
+	uint64_t blockcnt;
+	int rc;
+
+	blockcnt = raid10_calculate_blockcnt(raid_bdev);
+
+	if (blockcnt == raid_bdev->bdev.blockcnt) {
+		return;
+	}
+
+	SPDK_NOTICELOG("raid10 '%s': min blockcount was changed from %" PRIu64 " to %" PRIu64 "\n",
+		       raid_bdev->bdev.name,
+		       raid_bdev->bdev.blockcnt,
+		       blockcnt);
+
+	rc = spdk_bdev_notify_blockcnt_change(&raid_bdev->bdev, blockcnt);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to notify blockcount change\n");
+	}
+}
+
+static struct raid_bdev_module g_raid10_module = {
+	.level = RAID10,
+	.base_bdevs_min = 4,
+	.base_bdevs_constraint = {CONSTRAINT_MAX_BASE_BDEVS_REMOVED, 1},
+	.memory_domains_supported = true,
+	.read_policy_supported = true,
+	.start = raid10_start,
+	.stop = raid10_stop,
+	.submit_rw_request = raid10_submit_rw_request,
+	.submit_null_payload_request = raid10_submit_null_payload_request,
+	.get_io_channel = raid10_get_io_channel,
+	.resize = raid10_resize,
+	.submit_process_request = raid10_submit_process_request,
+};
+RAID_MODULE_REGISTER(&g_raid10_module)
+
+SPDK_LOG_REGISTER_COMPONENT(bdev_raid10)
@@ -12,10 +12,15 @@
 #include "spdk/likely.h"
 #include "spdk/log.h"
 #include "spdk/accel.h"
+#include "spdk/xor.h"
+#include "spdk/bit_array.h"
 
 /* Maximum concurrent full stripe writes per io channel */
 #define RAID5F_MAX_STRIPES 32
 
+/* Time after which a partially written stripe is written back from the stripe cache */
+#define RAID5F_STRIPE_CACHE_WRITEBACK_DELAY_US 100
+
 struct chunk {
 	/* Corresponds to base_bdev index */
 	uint8_t index;
@@ -39,6 +44,75 @@ struct chunk {
 struct stripe_request;
 typedef void (*stripe_req_xor_cb)(struct stripe_request *stripe_req, int status);
 
+struct raid5f_info;
+struct raid5f_io_channel;
+
+/*
+ * An entry of the stripe cache. It collects the data of writes smaller than a
+ * stripe, which are completed once the stripe is written back. The entry also
+ * serializes the write-back with degraded reads of the stripe, which depend on
+ * the parity being consistent.
+ */
+struct stripe_cache_entry {
+	struct raid5f_info *r5f_info;
+
+	/* The stripe's index in the raid array */
+	uint64_t stripe_index;
+
+	enum stripe_cache_entry_state {
+		STRIPE_CACHE_ENTRY_FREE,
+		STRIPE_CACHE_ENTRY_ACTIVE,
+		STRIPE_CACHE_ENTRY_WRITEBACK,
+	} state;
+
+	/* Number of writes copying data to the entry and requests locking the stripe */
+	uint32_t refs;
+
+	/* Set to write back the entry without waiting for it to fill up or age */
+	bool writeback_requested;
+
+	/* Data of the stripe's data chunks, in stripe order, and its io metadata */
+	void *buf;
+	void *md_buf;
+
+	/* Blocks of buf that hold written data */
+	struct spdk_bit_array *valid;
+	uint64_t num_valid;
+
+	/* Writes held until the write-back, linked with spdk_bdev_io module_link */
+	TAILQ_HEAD(, spdk_bdev_io) writes;
+
+	/* IOs waiting for the write-back to complete */
+	TAILQ_HEAD(, spdk_bdev_io) waiting;
+
+	/* The channel of the first held write, that writes back the entry unless it fills up */
+	struct raid5f_io_channel *owner;
+	uint64_t first_write_tsc;
+	TAILQ_ENTRY(stripe_cache_entry) owner_link;
+
+	/* State of the write-back */
+	struct {
+		/* The held write whose channel is used for the write-back */
+		struct raid_bdev_io *raid_io;
+
+		/* Buffers for all chunks, to read the blocks of the stripe not in buf */
+		void *buf;
+		void *md_buf;
+		struct iovec *iovs;
+
+		/* Read the whole stripe to reconstruct a missing data chunk */
+		bool degraded;
+		uint8_t next_chunk;
+		uint8_t reads_remaining;
+		int status;
+	} writeback;
+
+	RB_ENTRY(stripe_cache_entry) node;
+
+	/* Link in the free or the in-use list */
+	TAILQ_ENTRY(stripe_cache_entry) link;
+};
+
 struct stripe_request {
 	enum stripe_request_type {
 		STRIPE_REQ_WRITE,
@@ -56,13 +130,25 @@ struct stripe_request {
 	/* The stripe's parity chunk */
 	struct chunk *parity_chunk;
 
+	/* The stripe's Q parity chunk, only used by raid6f */
+	struct chunk *q_chunk;
+
 	union {
 		struct {
+			/* Stripe cache entry written back by this request, NULL for regular writes */
+			struct stripe_cache_entry *cache_entry;
+
 			/* Buffer for stripe parity */
 			void *parity_buf;
 
 			/* Buffer for stripe io metadata parity */
 			void *parity_md_buf;
+
+			/* Buffer for stripe Q parity */
+			void *q_buf;
+
+			/* Buffer for stripe io metadata Q parity */
+			void *q_md_buf;
 		} write;
 
 		struct {
@@ -75,11 +161,21 @@ struct stripe_request {
 			/* Chunk to reconstruct from parity */
 			struct chunk *chunk;
 
+			/*
+			 * Second chunk that is not read: a missing chunk also recovered from
+			 * parity or, when only one chunk is lost, the unused Q parity chunk.
+			 * Only used by raid6f.
+			 */
+			struct chunk *chunk2;
+
 			/* Offset from chunk start */
 			uint64_t chunk_offset;
 		} reconstruct;
 	};
 
+	/* Stripe cache entry locking the stripe for this request, if the cache is enabled */
+	struct stripe_cache_entry *cache_lock;
+
 	/* Array of iovec iterators for each chunk */
 	struct spdk_ioviter *chunk_iov_iters;
 
@@ -115,6 +211,40 @@ struct raid5f_info {
 
 	/* Alignment for buffer allocation */
 	size_t buf_alignment;
+
+	/* The stripe being rebuilt by a background process, one at a time */
+	struct {
+		/* Buffers for all chunks of a stripe, allocated on first use */
+		void *buf;
+		void *md_buf;
+		struct iovec *iovs;
+
+		struct raid_bdev_process_request *process_req;
+		uint64_t stripe_index;
+		uint8_t next_chunk;
+		uint8_t reads_remaining;
+		int status;
+	} process;
+
+	/* Stripe cache for writes smaller than a stripe, num_entries is 0 if disabled */
+	struct {
+		struct stripe_cache_entry *entries;
+		uint32_t num_entries;
+		uint64_t writeback_delay_ticks;
+
+		/* Protects the cache, which is shared by all io channels */
+		struct spdk_spinlock lock;
+
+		/* Entries in use, by stripe index */
+		RB_HEAD(stripe_cache_tree, stripe_cache_entry) tree;
+
+		/* Entries in use, oldest first, and free entries */
+		TAILQ_HEAD(, stripe_cache_entry) in_use;
+		TAILQ_HEAD(, stripe_cache_entry) free;
+
+		/* IOs waiting for a free entry */
+		TAILQ_HEAD(, spdk_bdev_io) waiting;
+	} cache;
 };
 
 struct raid5f_io_channel {
@@ -134,6 +264,17 @@ struct raid5f_io_channel {
 	void **chunk_xor_buffers;
 	struct iovec **chunk_xor_iovs;
 	size_t *chunk_xor_iovcnt;
+
+	struct {
+		/* Stripe cache entries owned by this channel, oldest first */
+		TAILQ_HEAD(, stripe_cache_entry) entries;
+
+		/* Entries being written back that wait for a free stripe request */
+		TAILQ_HEAD(, stripe_cache_entry) writeback_retry;
+
+		/* Writes back aged and evicted entries */
+		struct spdk_poller *poller;
+	} cache;
 };
 
 #define __CHUNK_IN_RANGE(req, c) \
@@ -145,12 +286,19 @@ struct raid5f_io_channel {
 #define FOR_EACH_CHUNK(req, c) \
 	FOR_EACH_CHUNK_FROM(req, c, req->chunks)
 
-#define __NEXT_DATA_CHUNK(req, c) \
-	c == req->parity_chunk ? c+1 : c
-
 #define FOR_EACH_DATA_CHUNK(req, c) \
-	for (c = __NEXT_DATA_CHUNK(req, req->chunks); __CHUNK_IN_RANGE(req, c); \
-	     c = __NEXT_DATA_CHUNK(req, c+1))
+	for (c = raid5f_next_data_chunk(req, req->chunks); __CHUNK_IN_RANGE(req, c); \
+	     c = raid5f_next_data_chunk(req, c+1))
+
+static inline struct chunk *
+raid5f_next_data_chunk(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	while (chunk == stripe_req->parity_chunk || chunk == stripe_req->q_chunk) {
+		chunk++;
+	}
+
+	return chunk;
+}
 
 static inline struct raid5f_info *
 raid5f_ch_to_r5f_info(struct raid5f_io_channel *r5ch)
@@ -170,15 +318,183 @@ raid5f_stripe_data_chunks_num(const struct raid_bdev *raid_bdev)
 	return raid_bdev->min_base_bdevs_operational;
 }
 
+static inline bool
+raid5f_is_raid6f(const struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->level == RAID6F;
+}
+
 static inline uint8_t
 raid5f_stripe_parity_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
 {
-	return raid5f_stripe_data_chunks_num(raid_bdev) - stripe_index % raid_bdev->num_base_bdevs;
+	return raid_bdev->num_base_bdevs - 1 - stripe_index % raid_bdev->num_base_bdevs;
+}
+
+/* raid6f places the Q parity chunk right after the P parity chunk, wrapping around */
+static inline uint8_t
+raid5f_stripe_q_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	return (raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index) + 1) %
+	       raid_bdev->num_base_bdevs;
+}
+
+static inline uint8_t
+raid5f_stripe_data_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index,
+			       uint8_t chunk_data_idx)
+{
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx;
+
+	if (!raid5f_is_raid6f(raid_bdev)) {
+		return chunk_data_idx < p_idx ? chunk_data_idx : chunk_data_idx + 1;
+	}
+
+	q_idx = raid5f_stripe_q_chunk_index(raid_bdev, stripe_index);
+	if (q_idx < p_idx) {
+		/* Q wrapped around to the first chunk, P is the last one */
+		return chunk_data_idx + 1;
+	}
+
+	return chunk_data_idx < p_idx ? chunk_data_idx : chunk_data_idx + 2;
+}
+
+/*
+ * Recover the chunks of a stripe flagged in missing[] from the other chunks.
+ * The buffers are indexed by base bdev and hold len bytes of data, md_bufs
+ * may be NULL if there is no separate io metadata.
+ */
+static int
+raid5f_recover_chunks(struct raid_bdev *raid_bdev, uint64_t stripe_index, void **bufs,
+		      void **md_bufs, const bool *missing, size_t len, size_t md_len)
+{
+	uint8_t n = raid_bdev->num_base_bdevs;
+	uint8_t n_data = raid5f_stripe_data_chunks_num(raid_bdev);
+	void *src[n], *md_src[n];
+	uint32_t lost[2] = { UINT32_MAX, UINT32_MAX };
+	uint8_t i, c;
+	int ret;
+
+	if (!raid5f_is_raid6f(raid_bdev)) {
+		uint8_t lost_idx = UINT8_MAX;
+
+		for (i = 0, c = 0; i < n; i++) {
+			if (missing[i]) {
+				if (lost_idx != UINT8_MAX) {
+					return -EIO;
+				}
+				lost_idx = i;
+			} else {
+				src[c] = bufs[i];
+				md_src[c] = md_bufs != NULL ? md_bufs[i] : NULL;
+				c++;
+			}
+		}
+
+		if (lost_idx == UINT8_MAX) {
+			return 0;
+		}
+
+		ret = spdk_xor_gen(bufs[lost_idx], src, n - 1, len);
+		if (ret == 0 && md_bufs != NULL) {
+			ret = spdk_xor_gen(md_bufs[lost_idx], md_src, n - 1, md_len);
+		}
+
+		return ret;
+	}
+
+	/* Order the chunks as the data chunks followed by P and Q */
+	for (c = 0; c < n; c++) {
+		if (c < n_data) {
+			i = raid5f_stripe_data_chunk_index(raid_bdev, stripe_index, c);
+		} else if (c == n_data) {
+			i = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+		} else {
+			i = raid5f_stripe_q_chunk_index(raid_bdev, stripe_index);
+		}
+
+		src[c] = bufs[i];
+		md_src[c] = md_bufs != NULL ? md_bufs[i] : NULL;
+
+		if (missing[i]) {
+			if (lost[1] != UINT32_MAX) {
+				return -EIO;
+			}
+			lost[lost[0] == UINT32_MAX ? 0 : 1] = c;
+		}
+	}
+
+	if (lost[0] == UINT32_MAX) {
+		return 0;
+	}
+
+	if (lost[1] == UINT32_MAX) {
+		/* Only one chunk is missing, recover it along with Q or, for Q itself, with P */
+		if (lost[0] == n_data + 1u) {
+			lost[0] = n_data;
+		}
+		lost[1] = n_data + 1;
+	}
+
+	ret = spdk_xor_recover_pq(src, n_data, lost[0], lost[1], len);
+	if (ret == 0 && md_bufs != NULL) {
+		ret = spdk_xor_recover_pq(md_src, n_data, lost[0], lost[1], md_len);
+	}
+
+	return ret;
+}
+
+static inline bool
+raid5f_stripe_request_has_md(struct stripe_request *stripe_req)
+{
+	if (stripe_req->type == STRIPE_REQ_WRITE && stripe_req->write.cache_entry != NULL) {
+		return stripe_req->write.cache_entry->md_buf != NULL;
+	}
+
+	return spdk_bdev_io_get_md_buf(spdk_bdev_io_from_ctx(stripe_req->raid_io)) != NULL;
+}
+
+static void raid5f_stripe_cache_writeback_done(struct stripe_cache_entry *entry, int status);
+
+/*
+ * Complete a part of the stripe request's raid_io. The raid_io of a stripe cache
+ * write-back is a held write, only used to track the progress of the write-back.
+ */
+static bool
+raid5f_stripe_request_complete_part(struct stripe_request *stripe_req, uint64_t completed,
+				    enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	if (spdk_likely(stripe_req->type != STRIPE_REQ_WRITE || stripe_req->write.cache_entry == NULL)) {
+		return raid_bdev_io_complete_part(raid_io, completed, status);
+	}
+
+	assert(raid_io->base_bdev_io_remaining >= completed);
+	raid_io->base_bdev_io_remaining -= completed;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		raid_io->base_bdev_io_status = status;
+	}
+
+	if (raid_io->base_bdev_io_remaining == 0) {
+		raid5f_stripe_cache_writeback_done(stripe_req->write.cache_entry,
+						   raid_io->base_bdev_io_status == SPDK_BDEV_IO_STATUS_SUCCESS ? 0 : -EIO);
+		return true;
+	}
+
+	return false;
 }
 
+static void raid5f_stripe_cache_unlock_stripe(struct stripe_cache_entry *entry);
+
 static inline void
 raid5f_stripe_request_release(struct stripe_request *stripe_req)
 {
+	if (stripe_req->cache_lock != NULL) {
+		raid5f_stripe_cache_unlock_stripe(stripe_req->cache_lock);
+		stripe_req->cache_lock = NULL;
+	}
+
 	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
 		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.write, stripe_req, link);
 	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
@@ -277,6 +593,94 @@ raid5f_xor_stripe_continue(struct stripe_request *stripe_req)
 	}
 }
 
+/*
+ * Calculate P and Q parity of a raid6f stripe or recover two of its chunks.
+ * The accel framework has no P+Q operation, so this is done synchronously.
+ */
+static void
+raid5f_pq_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
+{
+	struct raid5f_io_channel *r5ch = stripe_req->r5ch;
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	uint8_t n_data = raid5f_stripe_data_chunks_num(raid_bdev);
+	void **md_bufs = stripe_req->chunk_xor_md_buffers;
+	uint32_t lost[2] = { UINT32_MAX, UINT32_MAX };
+	uint32_t n_lost = 0;
+	struct chunk *chunk;
+	uint64_t num_blocks;
+	size_t len;
+	uint8_t c;
+	int ret = 0;
+
+	if (stripe_req->type == STRIPE_REQ_WRITE) {
+		num_blocks = raid_bdev->strip_size;
+	} else {
+		num_blocks = bdev_io->u.bdev.num_blocks;
+	}
+
+	/* Order the chunks as the data chunks followed by P and Q */
+	c = 0;
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		r5ch->chunk_xor_iovs[c] = chunk->iovs;
+		r5ch->chunk_xor_iovcnt[c] = chunk->iovcnt;
+		md_bufs[c] = chunk->md_buf;
+		c++;
+	}
+	r5ch->chunk_xor_iovs[c] = stripe_req->parity_chunk->iovs;
+	r5ch->chunk_xor_iovcnt[c] = stripe_req->parity_chunk->iovcnt;
+	md_bufs[c] = stripe_req->parity_chunk->md_buf;
+	c++;
+	r5ch->chunk_xor_iovs[c] = stripe_req->q_chunk->iovs;
+	r5ch->chunk_xor_iovcnt[c] = stripe_req->q_chunk->iovcnt;
+	md_bufs[c] = stripe_req->q_chunk->md_buf;
+
+	if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		c = 0;
+		FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+			if (chunk == stripe_req->reconstruct.chunk || chunk == stripe_req->reconstruct.chunk2) {
+				lost[n_lost++] = c;
+			}
+			c++;
+		}
+		if (stripe_req->reconstruct.chunk2 == stripe_req->parity_chunk) {
+			lost[n_lost++] = n_data;
+		}
+		assert(n_lost == 2);
+	}
+
+	for (len = spdk_ioviter_firstv(stripe_req->chunk_iov_iters, raid_bdev->num_base_bdevs,
+				       r5ch->chunk_xor_iovs, r5ch->chunk_xor_iovcnt,
+				       r5ch->chunk_xor_buffers);
+	     len > 0 && ret == 0;
+	     len = spdk_ioviter_nextv(stripe_req->chunk_iov_iters, r5ch->chunk_xor_buffers)) {
+		void **bufs = r5ch->chunk_xor_buffers;
+
+		if (stripe_req->type == STRIPE_REQ_WRITE) {
+			ret = spdk_xor_gen_pq(bufs[n_data], bufs[n_data + 1], bufs, n_data, len);
+		} else {
+			ret = spdk_xor_recover_pq(bufs, n_data, lost[0], lost[1], len);
+		}
+	}
+
+	if (ret == 0 && raid5f_stripe_request_has_md(stripe_req)) {
+		len = num_blocks * spdk_bdev_get_md_size(&raid_bdev->bdev);
+
+		if (stripe_req->type == STRIPE_REQ_WRITE) {
+			ret = spdk_xor_gen_pq(md_bufs[n_data], md_bufs[n_data + 1], md_bufs, n_data, len);
+		} else {
+			ret = spdk_xor_recover_pq(md_bufs, n_data, lost[0], lost[1], len);
+		}
+	}
+
+	if (ret != 0) {
+		SPDK_ERRLOG("stripe p+q calculation failed: %s\n", spdk_strerror(-ret));
+	}
+
+	cb(stripe_req, ret);
+}
+
 static void
 raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 {
@@ -286,6 +690,7 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
 	struct chunk *chunk;
 	struct chunk *dest_chunk;
+	struct chunk *skip_chunk = NULL;
 	uint64_t num_blocks;
 	uint8_t c;
 
@@ -294,16 +699,25 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
 		num_blocks = raid_bdev->strip_size;
 		dest_chunk = stripe_req->parity_chunk;
+		if (stripe_req->q_chunk != NULL) {
+			raid5f_pq_stripe(stripe_req, cb);
+			return;
+		}
 	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
 		num_blocks = bdev_io->u.bdev.num_blocks;
 		dest_chunk = stripe_req->reconstruct.chunk;
+		skip_chunk = stripe_req->reconstruct.chunk2;
+		if (skip_chunk != NULL && skip_chunk != stripe_req->q_chunk) {
+			raid5f_pq_stripe(stripe_req, cb);
+			return;
+		}
 	} else {
 		assert(false);
 	}
 
 	c = 0;
 	FOR_EACH_CHUNK(stripe_req, chunk) {
-		if (chunk == dest_chunk) {
+		if (chunk == dest_chunk || chunk == skip_chunk) {
 			continue;
 		}
 		r5ch->chunk_xor_iovs[c] = chunk->iovs;
@@ -314,7 +728,7 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	r5ch->chunk_xor_iovcnt[c] = dest_chunk->iovcnt;
 
 	stripe_req->xor.len = spdk_ioviter_firstv(stripe_req->chunk_iov_iters,
-			      raid_bdev->num_base_bdevs,
+			      c + 1,
 			      r5ch->chunk_xor_iovs,
 			      r5ch->chunk_xor_iovcnt,
 			      r5ch->chunk_xor_buffers);
@@ -322,7 +736,7 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	stripe_req->xor.status = 0;
 	stripe_req->xor.cb = cb;
 
-	if (spdk_bdev_io_get_md_buf(bdev_io)) {
+	if (raid5f_stripe_request_has_md(stripe_req)) {
 		uint8_t n_src = raid5f_stripe_data_chunks_num(raid_bdev);
 		uint64_t len = num_blocks * spdk_bdev_get_md_size(&raid_bdev->bdev);
 		int ret;
@@ -331,7 +745,7 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 
 		c = 0;
 		FOR_EACH_CHUNK(stripe_req, chunk) {
-			if (chunk != dest_chunk) {
+			if (chunk != dest_chunk && chunk != skip_chunk) {
 				stripe_req->chunk_xor_md_buffers[c] = chunk->md_buf;
 				c++;
 			}
@@ -368,7 +782,7 @@ static void
 raid5f_stripe_request_chunk_write_complete(struct stripe_request *stripe_req,
 		enum spdk_bdev_io_status status)
 {
-	if (raid_bdev_io_complete_part(stripe_req->raid_io, 1, status)) {
+	if (raid5f_stripe_request_complete_part(stripe_req, 1, status)) {
 		raid5f_stripe_request_release(stripe_req);
 	}
 }
@@ -462,7 +876,7 @@ raid5f_chunk_submit(struct chunk *chunk)
 	switch (stripe_req->type) {
 	case STRIPE_REQ_WRITE:
 		if (base_ch == NULL) {
-			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			raid5f_stripe_request_complete_part(stripe_req, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
 			return 0;
 		}
 
@@ -472,7 +886,7 @@ raid5f_chunk_submit(struct chunk *chunk)
 						  &chunk->ext_opts);
 		break;
 	case STRIPE_REQ_RECONSTRUCT:
-		if (chunk == stripe_req->reconstruct.chunk) {
+		if (chunk == stripe_req->reconstruct.chunk || chunk == stripe_req->reconstruct.chunk2) {
 			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
 			return 0;
 		}
@@ -501,18 +915,11 @@ raid5f_chunk_submit(struct chunk *chunk)
 			 * these means there are no more to complete for the stripe request, we can
 			 * release the stripe request as well.
 			 */
-			uint64_t base_bdev_io_not_submitted;
-
-			if (stripe_req->type == STRIPE_REQ_WRITE) {
-				base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
-							     raid_io->base_bdev_io_submitted;
-			} else {
-				base_bdev_io_not_submitted = raid5f_stripe_data_chunks_num(raid_bdev) -
-							     raid_io->base_bdev_io_submitted;
-			}
+			uint64_t base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
+							      raid_io->base_bdev_io_submitted;
 
-			if (raid_bdev_io_complete_part(raid_io, base_bdev_io_not_submitted,
-						       SPDK_BDEV_IO_STATUS_FAILED)) {
+			if (raid5f_stripe_request_complete_part(stripe_req, base_bdev_io_not_submitted,
+								SPDK_BDEV_IO_STATUS_FAILED)) {
 				raid5f_stripe_request_release(stripe_req);
 			}
 		}
@@ -539,6 +946,24 @@ raid5f_chunk_set_iovcnt(struct chunk *chunk, int iovcnt)
 	return 0;
 }
 
+static void
+raid5f_stripe_request_map_parity(struct stripe_request *stripe_req)
+{
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+
+	stripe_req->parity_chunk->iovs[0].iov_base = stripe_req->write.parity_buf;
+	stripe_req->parity_chunk->iovs[0].iov_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	stripe_req->parity_chunk->iovcnt = 1;
+	stripe_req->parity_chunk->md_buf = stripe_req->write.parity_md_buf;
+
+	if (stripe_req->q_chunk != NULL) {
+		stripe_req->q_chunk->iovs[0].iov_base = stripe_req->write.q_buf;
+		stripe_req->q_chunk->iovs[0].iov_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+		stripe_req->q_chunk->iovcnt = 1;
+		stripe_req->q_chunk->md_buf = stripe_req->write.q_md_buf;
+	}
+}
+
 static int
 raid5f_stripe_request_map_iovecs(struct stripe_request *stripe_req)
 {
@@ -601,10 +1026,7 @@ raid5f_stripe_request_map_iovecs(struct stripe_request *stripe_req)
 		}
 	}
 
-	stripe_req->parity_chunk->iovs[0].iov_base = stripe_req->write.parity_buf;
-	stripe_req->parity_chunk->iovs[0].iov_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
-	stripe_req->parity_chunk->iovcnt = 1;
-	stripe_req->parity_chunk->md_buf = stripe_req->write.parity_md_buf;
+	raid5f_stripe_request_map_parity(stripe_req);
 
 	return 0;
 }
@@ -631,21 +1053,36 @@ raid5f_stripe_request_init(struct stripe_request *stripe_req, struct raid_bdev_i
 	stripe_req->stripe_index = stripe_index;
 	stripe_req->parity_chunk = &stripe_req->chunks[raid5f_stripe_parity_chunk_index(raid_io->raid_bdev,
 				   stripe_index)];
+	if (raid5f_is_raid6f(raid_io->raid_bdev)) {
+		stripe_req->q_chunk = &stripe_req->chunks[raid5f_stripe_q_chunk_index(raid_io->raid_bdev,
+				      stripe_index)];
+	} else {
+		stripe_req->q_chunk = NULL;
+	}
+	stripe_req->cache_lock = NULL;
 }
 
 static void
 raid5f_stripe_write_request_xor_done(struct stripe_request *stripe_req, int status)
 {
 	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct stripe_cache_entry *cache_entry = stripe_req->write.cache_entry;
 
 	if (status != 0) {
 		raid5f_stripe_request_release(stripe_req);
-		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		if (cache_entry != NULL) {
+			raid5f_stripe_cache_writeback_done(cache_entry, status);
+		} else {
+			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+		}
 	} else {
 		raid5f_stripe_request_submit_chunks(stripe_req);
 	}
 }
 
+static int raid5f_stripe_cache_lock_stripe(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+		struct stripe_cache_entry **_entry);
+
 static int
 raid5f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
 {
@@ -660,18 +1097,26 @@ raid5f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
 	}
 
 	raid5f_stripe_request_init(stripe_req, raid_io, stripe_index);
+	stripe_req->write.cache_entry = NULL;
 
 	ret = raid5f_stripe_request_map_iovecs(stripe_req);
 	if (spdk_unlikely(ret)) {
 		return ret;
 	}
 
+	if (raid5f_stripe_cache_lock_stripe(raid_io, stripe_index, &stripe_req->cache_lock) != 0) {
+		/* Resubmitted when the stripe is written back */
+		return 0;
+	}
+
 	TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
 
 	raid_io->module_private = stripe_req;
 	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
 
-	if (raid_io->raid_ch->base_channel[stripe_req->parity_chunk->index] != NULL) {
+	if (raid_io->raid_ch->base_channel[stripe_req->parity_chunk->index] != NULL ||
+	    (stripe_req->q_chunk != NULL &&
+	     raid_io->raid_ch->base_channel[stripe_req->q_chunk->index] != NULL)) {
 		raid5f_xor_stripe(stripe_req, raid5f_stripe_write_request_xor_done);
 	} else {
 		raid5f_stripe_write_request_xor_done(stripe_req, 0);
@@ -702,58 +1147,697 @@ _raid5f_submit_rw_request(void *_raid_io)
 }
 
 static int
-raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
-			       uint8_t chunk_idx, uint64_t chunk_offset)
+stripe_cache_entry_cmp(struct stripe_cache_entry *entry1, struct stripe_cache_entry *entry2)
 {
-	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
-	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
-	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
-	void *bdev_io_md = spdk_bdev_io_get_md_buf(bdev_io);
-	struct stripe_request *stripe_req;
-	struct chunk *chunk;
-	int buf_idx;
+	return entry1->stripe_index < entry2->stripe_index ? -1 :
+	       entry1->stripe_index > entry2->stripe_index;
+}
 
-	stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.reconstruct);
-	if (!stripe_req) {
-		return -ENOMEM;
-	}
+RB_GENERATE_STATIC(stripe_cache_tree, stripe_cache_entry, node, stripe_cache_entry_cmp);
 
-	raid5f_stripe_request_init(stripe_req, raid_io, stripe_index);
+static inline bool
+raid5f_stripe_cache_enabled(struct raid5f_info *r5f_info)
+{
+	return r5f_info->cache.num_entries > 0;
+}
 
-	stripe_req->reconstruct.chunk = &stripe_req->chunks[chunk_idx];
-	stripe_req->reconstruct.chunk_offset = chunk_offset;
-	buf_idx = 0;
+static struct stripe_cache_entry *
+raid5f_stripe_cache_find_locked(struct raid5f_info *r5f_info, uint64_t stripe_index)
+{
+	struct stripe_cache_entry find = { .stripe_index = stripe_index };
 
-	FOR_EACH_CHUNK(stripe_req, chunk) {
-		if (chunk == stripe_req->reconstruct.chunk) {
-			int i;
-			int ret;
+	return RB_FIND(stripe_cache_tree, &r5f_info->cache.tree, &find);
+}
 
-			ret = raid5f_chunk_set_iovcnt(chunk, bdev_io->u.bdev.iovcnt);
-			if (ret) {
-				return ret;
-			}
+static struct stripe_cache_entry *
+raid5f_stripe_cache_get_locked(struct raid5f_info *r5f_info, uint64_t stripe_index)
+{
+	struct stripe_cache_entry *entry;
 
-			for (i = 0; i < bdev_io->u.bdev.iovcnt; i++) {
-				chunk->iovs[i] = bdev_io->u.bdev.iovs[i];
-			}
+	entry = raid5f_stripe_cache_find_locked(r5f_info, stripe_index);
+	if (entry != NULL) {
+		return entry;
+	}
 
-			chunk->md_buf = bdev_io_md;
-		} else {
-			struct iovec *iov = &chunk->iovs[0];
+	entry = TAILQ_FIRST(&r5f_info->cache.free);
+	if (entry == NULL) {
+		return NULL;
+	}
 
-			iov->iov_base = stripe_req->reconstruct.chunk_buffers[buf_idx];
-			iov->iov_len = bdev_io->u.bdev.num_blocks << raid_bdev->blocklen_shift;
-			chunk->iovcnt = 1;
+	assert(entry->state == STRIPE_CACHE_ENTRY_FREE);
+	TAILQ_REMOVE(&r5f_info->cache.free, entry, link);
+	TAILQ_INSERT_TAIL(&r5f_info->cache.in_use, entry, link);
+	entry->stripe_index = stripe_index;
+	entry->state = STRIPE_CACHE_ENTRY_ACTIVE;
+	RB_INSERT(stripe_cache_tree, &r5f_info->cache.tree, entry);
 
-			if (bdev_io_md) {
-				chunk->md_buf = stripe_req->reconstruct.chunk_md_buffers[buf_idx];
-			}
+	return entry;
+}
+
+/* Move the waiting IOs to the list and return the entry to the free list */
+static void
+raid5f_stripe_cache_put_locked(struct stripe_cache_entry *entry, void *_waiting)
+{
+	struct raid5f_info *r5f_info = entry->r5f_info;
+	TAILQ_HEAD(, spdk_bdev_io) *waiting = _waiting;
+
+	assert(entry->refs == 0);
+	assert(TAILQ_EMPTY(&entry->writes));
+
+	TAILQ_CONCAT(waiting, &entry->waiting, module_link);
+	TAILQ_CONCAT(waiting, &r5f_info->cache.waiting, module_link);
+
+	RB_REMOVE(stripe_cache_tree, &r5f_info->cache.tree, entry);
+	TAILQ_REMOVE(&r5f_info->cache.in_use, entry, link);
+	spdk_bit_array_clear_mask(entry->valid);
+	entry->num_valid = 0;
+	entry->owner = NULL;
+	entry->writeback_requested = false;
+	entry->state = STRIPE_CACHE_ENTRY_FREE;
+	TAILQ_INSERT_HEAD(&r5f_info->cache.free, entry, link);
+}
+
+/* Queue the IO until an entry is freed and make the oldest entry with writes free up */
+static void
+raid5f_stripe_cache_wait_for_entry_locked(struct raid5f_info *r5f_info,
+		struct raid_bdev_io *raid_io)
+{
+	struct stripe_cache_entry *entry;
+
+	TAILQ_INSERT_TAIL(&r5f_info->cache.waiting, spdk_bdev_io_from_ctx(raid_io), module_link);
+
+	TAILQ_FOREACH(entry, &r5f_info->cache.in_use, link) {
+		if (entry->state == STRIPE_CACHE_ENTRY_ACTIVE && !TAILQ_EMPTY(&entry->writes)) {
+			entry->writeback_requested = true;
+			break;
+		}
+	}
+}
+
+static void
+raid5f_stripe_cache_resubmit(void *_waiting)
+{
+	TAILQ_HEAD(, spdk_bdev_io) *waiting = _waiting;
+	struct spdk_bdev_io *bdev_io;
+
+	while ((bdev_io = TAILQ_FIRST(waiting))) {
+		TAILQ_REMOVE(waiting, bdev_io, module_link);
+		spdk_thread_send_msg(spdk_bdev_io_get_thread(bdev_io), _raid5f_submit_rw_request,
+				     bdev_io->driver_ctx);
+	}
+}
+
+static void
+_raid5f_stripe_cache_complete_write(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid_bdev_io_complete(raid_io, raid_io->base_bdev_io_status);
+}
+
+static void
+raid5f_stripe_cache_writeback_done(struct stripe_cache_entry *entry, int status)
+{
+	struct raid5f_info *r5f_info = entry->r5f_info;
+	TAILQ_HEAD(, spdk_bdev_io) writes = TAILQ_HEAD_INITIALIZER(writes);
+	TAILQ_HEAD(, spdk_bdev_io) waiting = TAILQ_HEAD_INITIALIZER(waiting);
+	struct spdk_bdev_io *bdev_io;
+	struct raid_bdev_io *raid_io;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write back stripe %" PRIu64 ": %s\n", entry->stripe_index,
+			    spdk_strerror(-status));
+	}
+
+	spdk_spin_lock(&r5f_info->cache.lock);
+	TAILQ_CONCAT(&writes, &entry->writes, module_link);
+	raid5f_stripe_cache_put_locked(entry, &waiting);
+	spdk_spin_unlock(&r5f_info->cache.lock);
+
+	while ((bdev_io = TAILQ_FIRST(&writes))) {
+		TAILQ_REMOVE(&writes, bdev_io, module_link);
+		raid_io = (struct raid_bdev_io *)bdev_io->driver_ctx;
+		raid_io->base_bdev_io_status = status == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS :
+					       SPDK_BDEV_IO_STATUS_FAILED;
+
+		if (spdk_bdev_io_get_thread(bdev_io) == spdk_get_thread()) {
+			_raid5f_stripe_cache_complete_write(raid_io);
+		} else {
+			spdk_thread_send_msg(spdk_bdev_io_get_thread(bdev_io),
+					     _raid5f_stripe_cache_complete_write, raid_io);
+		}
+	}
+
+	raid5f_stripe_cache_resubmit(&waiting);
+}
+
+static void
+raid5f_stripe_cache_write_stripe(struct stripe_cache_entry *entry)
+{
+	struct raid_bdev_io *raid_io = entry->writeback.raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	size_t chunk_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	size_t chunk_md_len = raid_bdev->strip_size * spdk_bdev_get_md_size(&raid_bdev->bdev);
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	uint8_t i = 0;
+
+	stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.write);
+	if (!stripe_req) {
+		/* Retried by the channel's stripe cache poller */
+		TAILQ_INSERT_TAIL(&r5ch->cache.writeback_retry, entry, owner_link);
+		return;
+	}
+
+	raid5f_stripe_request_init(stripe_req, raid_io, entry->stripe_index);
+	stripe_req->write.cache_entry = entry;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		chunk->iovs[0].iov_base = (uint8_t *)entry->buf + i * chunk_len;
+		chunk->iovs[0].iov_len = chunk_len;
+		chunk->iovcnt = 1;
+		chunk->md_buf = entry->md_buf != NULL ? (uint8_t *)entry->md_buf + i * chunk_md_len : NULL;
+		i++;
+	}
+
+	raid5f_stripe_request_map_parity(stripe_req);
+
+	TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
+
+	raid_io->module_private = stripe_req;
+	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
+	raid_io->base_bdev_io_submitted = 0;
+	raid_io->base_bdev_io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	if (raid_io->raid_ch->base_channel[stripe_req->parity_chunk->index] != NULL ||
+	    (stripe_req->q_chunk != NULL &&
+	     raid_io->raid_ch->base_channel[stripe_req->q_chunk->index] != NULL)) {
+		raid5f_xor_stripe(stripe_req, raid5f_stripe_write_request_xor_done);
+	} else {
+		raid5f_stripe_write_request_xor_done(stripe_req, 0);
+	}
+}
+
+static inline bool
+raid5f_stripe_cache_chunk_is_full(struct stripe_cache_entry *entry, uint8_t data_idx)
+{
+	uint32_t strip_size = entry->r5f_info->raid_bdev->strip_size;
+	uint32_t first_clear;
+
+	first_clear = spdk_bit_array_find_first_clear(entry->valid, data_idx * strip_size);
+
+	return first_clear == UINT32_MAX || first_clear >= (data_idx + 1) * strip_size;
+}
+
+/* Check if the chunk at base bdev index idx has to be read to fill up the entry */
+static bool
+raid5f_stripe_cache_fill_chunk_needed(struct stripe_cache_entry *entry, uint8_t idx)
+{
+	struct raid_bdev *raid_bdev = entry->r5f_info->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = entry->writeback.raid_io->raid_ch;
+	uint8_t i;
+
+	if (raid_ch->base_channel[idx] == NULL) {
+		return false;
+	}
+
+	if (entry->writeback.degraded) {
+		return true;
+	}
+
+	for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
+		if (raid5f_stripe_data_chunk_index(raid_bdev, entry->stripe_index, i) == idx) {
+			return !raid5f_stripe_cache_chunk_is_full(entry, i);
+		}
+	}
+
+	/* A parity chunk */
+	return false;
+}
+
+/* Copy the blocks not written to the entry from the chunks read from the base bdevs */
+static int
+raid5f_stripe_cache_merge_chunks(struct stripe_cache_entry *entry)
+{
+	struct raid_bdev *raid_bdev = entry->r5f_info->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = entry->writeback.raid_io->raid_ch;
+	uint32_t md_size = spdk_bdev_get_md_size(&raid_bdev->bdev);
+	size_t chunk_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	size_t chunk_md_len = raid_bdev->strip_size * md_size;
+	uint8_t n = raid_bdev->num_base_bdevs;
+	void *bufs[n], *md_bufs[n];
+	bool missing[n];
+	uint32_t block, end, next_valid;
+	uint8_t i, idx;
+	int ret;
+
+	for (i = 0; i < n; i++) {
+		bufs[i] = (uint8_t *)entry->writeback.buf + i * chunk_len;
+		md_bufs[i] = entry->md_buf != NULL ? (uint8_t *)entry->writeback.md_buf + i * chunk_md_len : NULL;
+		missing[i] = raid_ch->base_channel[i] == NULL;
+	}
+
+	if (entry->writeback.degraded) {
+		ret = raid5f_recover_chunks(raid_bdev, entry->stripe_index, bufs,
+					    entry->md_buf != NULL ? md_bufs : NULL, missing, chunk_len,
+					    chunk_md_len);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
+		idx = raid5f_stripe_data_chunk_index(raid_bdev, entry->stripe_index, i);
+		end = (i + 1) * raid_bdev->strip_size;
+
+		for (block = spdk_bit_array_find_first_clear(entry->valid, i * raid_bdev->strip_size);
+		     block < end;
+		     block = spdk_bit_array_find_first_clear(entry->valid, next_valid)) {
+			uint32_t chunk_offset = block - i * raid_bdev->strip_size;
+			uint32_t num_blocks;
+
+			next_valid = spdk_min(spdk_bit_array_find_first_set(entry->valid, block), end);
+			num_blocks = next_valid - block;
+
+			memcpy((uint8_t *)entry->buf + ((uint64_t)block << raid_bdev->blocklen_shift),
+			       (uint8_t *)bufs[idx] + ((uint64_t)chunk_offset << raid_bdev->blocklen_shift),
+			       (uint64_t)num_blocks << raid_bdev->blocklen_shift);
+			if (entry->md_buf != NULL) {
+				memcpy((uint8_t *)entry->md_buf + (uint64_t)block * md_size,
+				       (uint8_t *)md_bufs[idx] + (uint64_t)chunk_offset * md_size,
+				       (uint64_t)num_blocks * md_size);
+			}
+
+			if (next_valid == end) {
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void
+raid5f_stripe_cache_fill_read_complete(struct stripe_cache_entry *entry, int status)
+{
+	if (status != 0) {
+		entry->writeback.status = status;
+	}
+
+	assert(entry->writeback.reads_remaining > 0);
+	if (--entry->writeback.reads_remaining > 0) {
+		return;
+	}
+
+	if (entry->writeback.status == 0) {
+		entry->writeback.status = raid5f_stripe_cache_merge_chunks(entry);
+	}
+
+	if (entry->writeback.status != 0) {
+		raid5f_stripe_cache_writeback_done(entry, entry->writeback.status);
+		return;
+	}
+
+	raid5f_stripe_cache_write_stripe(entry);
+}
+
+static void
+raid5f_stripe_cache_fill_read_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct stripe_cache_entry *entry = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid5f_stripe_cache_fill_read_complete(entry, success ? 0 : -EIO);
+}
+
+static void
+raid5f_stripe_cache_submit_fill_reads(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct stripe_cache_entry *entry = raid_io->module_private;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	size_t chunk_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	size_t chunk_md_len = raid_bdev->strip_size * spdk_bdev_get_md_size(&raid_bdev->bdev);
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	struct iovec *iov;
+	uint8_t i;
+	int ret;
+
+	for (i = entry->writeback.next_chunk; i < raid_bdev->num_base_bdevs; i++) {
+		if (!raid5f_stripe_cache_fill_chunk_needed(entry, i)) {
+			continue;
+		}
+
+		base_info = &raid_bdev->base_bdev_info[i];
+		base_ch = raid_io->raid_ch->base_channel[i];
+
+		iov = &entry->writeback.iovs[i];
+		iov->iov_base = (uint8_t *)entry->writeback.buf + i * chunk_len;
+		iov->iov_len = chunk_len;
+
+		memset(&io_opts, 0, sizeof(io_opts));
+		io_opts.size = sizeof(io_opts);
+		io_opts.metadata = entry->md_buf != NULL ?
+				   (uint8_t *)entry->writeback.md_buf + i * chunk_md_len : NULL;
+
+		ret = spdk_bdev_readv_blocks_ext(base_info->desc, base_ch, iov, 1,
+						 entry->stripe_index << raid_bdev->strip_size_shift,
+						 raid_bdev->strip_size, raid5f_stripe_cache_fill_read_completed,
+						 entry, &io_opts);
+		if (spdk_unlikely(ret != 0)) {
+			if (ret == -ENOMEM) {
+				entry->writeback.next_chunk = i;
+				raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+							base_ch, raid5f_stripe_cache_submit_fill_reads);
+				return;
+			}
+
+			/* Fail the chunks that were not submitted */
+			entry->writeback.status = ret;
+			for (i++; i < raid_bdev->num_base_bdevs; i++) {
+				if (raid5f_stripe_cache_fill_chunk_needed(entry, i)) {
+					entry->writeback.reads_remaining--;
+				}
+			}
+			raid5f_stripe_cache_fill_read_complete(entry, ret);
+			return;
+		}
+	}
+
+	entry->writeback.next_chunk = i;
+}
+
+/*
+ * Write back the entry using the channel of raid_io, one of the held writes
+ * submitted on the current thread. The blocks of the stripe that were not
+ * written are read from the base bdevs first.
+ */
+static void
+raid5f_stripe_cache_writeback(struct stripe_cache_entry *entry, struct raid_bdev_io *raid_io)
+{
+	struct raid5f_info *r5f_info = entry->r5f_info;
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint8_t i;
+
+	assert(entry->state == STRIPE_CACHE_ENTRY_WRITEBACK);
+
+	entry->writeback.raid_io = raid_io;
+	entry->writeback.status = 0;
+
+	if (entry->num_valid == r5f_info->stripe_blocks) {
+		raid5f_stripe_cache_write_stripe(entry);
+		return;
+	}
+
+	/* Read the whole stripe if a chunk that has to be read is missing */
+	entry->writeback.degraded = false;
+	for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
+		if (!raid5f_stripe_cache_chunk_is_full(entry, i) &&
+		    raid_io->raid_ch->base_channel[raid5f_stripe_data_chunk_index(raid_bdev,
+				    entry->stripe_index, i)] == NULL) {
+			entry->writeback.degraded = true;
+			break;
+		}
+	}
+
+	entry->writeback.reads_remaining = 0;
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (raid5f_stripe_cache_fill_chunk_needed(entry, i)) {
+			entry->writeback.reads_remaining++;
+		}
+	}
+
+	if (entry->writeback.degraded &&
+	    entry->writeback.reads_remaining < raid5f_stripe_data_chunks_num(raid_bdev)) {
+		raid5f_stripe_cache_writeback_done(entry, -EIO);
+		return;
+	}
+
+	raid_io->module_private = entry;
+	entry->writeback.next_chunk = 0;
+	raid5f_stripe_cache_submit_fill_reads(raid_io);
+}
+
+static void
+raid5f_stripe_cache_start_writeback_locked(struct stripe_cache_entry *entry)
+{
+	assert(entry->state == STRIPE_CACHE_ENTRY_ACTIVE);
+	assert(entry->refs == 0);
+
+	entry->state = STRIPE_CACHE_ENTRY_WRITEBACK;
+	TAILQ_REMOVE(&entry->owner->cache.entries, entry, owner_link);
+}
+
+static int
+raid5f_stripe_cache_poll(void *ctx)
+{
+	struct raid5f_io_channel *r5ch = ctx;
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	TAILQ_HEAD(, stripe_cache_entry) writeback = TAILQ_HEAD_INITIALIZER(writeback);
+	struct stripe_cache_entry *entry, *tmp;
+	uint64_t now = spdk_get_ticks();
+
+	TAILQ_CONCAT(&writeback, &r5ch->cache.writeback_retry, owner_link);
+	while ((entry = TAILQ_FIRST(&writeback))) {
+		TAILQ_REMOVE(&writeback, entry, owner_link);
+		raid5f_stripe_cache_write_stripe(entry);
+	}
+
+	spdk_spin_lock(&r5f_info->cache.lock);
+	TAILQ_FOREACH_SAFE(entry, &r5ch->cache.entries, owner_link, tmp) {
+		if (entry->refs > 0) {
+			continue;
+		}
+
+		if (entry->writeback_requested || entry->num_valid == r5f_info->stripe_blocks ||
+		    now - entry->first_write_tsc >= r5f_info->cache.writeback_delay_ticks) {
+			raid5f_stripe_cache_start_writeback_locked(entry);
+			TAILQ_INSERT_TAIL(&writeback, entry, owner_link);
+		}
+	}
+	spdk_spin_unlock(&r5f_info->cache.lock);
+
+	if (TAILQ_EMPTY(&writeback)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	while ((entry = TAILQ_FIRST(&writeback))) {
+		TAILQ_REMOVE(&writeback, entry, owner_link);
+		/* The first held write was submitted on this channel */
+		raid5f_stripe_cache_writeback(entry,
+					      (struct raid_bdev_io *)TAILQ_FIRST(&entry->writes)->driver_ctx);
+	}
+
+	return SPDK_POLLER_BUSY;
+}
+
+/*
+ * Copy a write within a stripe to the stripe cache. The write completes when
+ * the stripe is written back: right away if it fills up the stripe, otherwise
+ * when the entry ages or is evicted to make room for another stripe.
+ */
+static void
+raid5f_stripe_cache_write(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			  uint64_t stripe_offset)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	uint64_t num_blocks = bdev_io->u.bdev.num_blocks;
+	void *md_buf = spdk_bdev_io_get_md_buf(bdev_io);
+	struct stripe_cache_entry *entry;
+	bool writeback = false;
+	uint64_t i;
+
+	assert(stripe_offset + num_blocks <= r5f_info->stripe_blocks);
+
+	spdk_spin_lock(&r5f_info->cache.lock);
+	entry = raid5f_stripe_cache_get_locked(r5f_info, stripe_index);
+	if (entry == NULL) {
+		raid5f_stripe_cache_wait_for_entry_locked(r5f_info, raid_io);
+		spdk_spin_unlock(&r5f_info->cache.lock);
+		return;
+	}
+
+	if (entry->state == STRIPE_CACHE_ENTRY_WRITEBACK) {
+		TAILQ_INSERT_TAIL(&entry->waiting, bdev_io, module_link);
+		spdk_spin_unlock(&r5f_info->cache.lock);
+		return;
+	}
+
+	entry->refs++;
+	TAILQ_INSERT_TAIL(&entry->writes, bdev_io, module_link);
+	if (entry->owner == NULL) {
+		entry->owner = r5ch;
+		entry->first_write_tsc = spdk_get_ticks();
+		TAILQ_INSERT_TAIL(&r5ch->cache.entries, entry, owner_link);
+	}
+	spdk_spin_unlock(&r5f_info->cache.lock);
+
+	spdk_copy_iovs_to_buf((uint8_t *)entry->buf + (stripe_offset << raid_bdev->blocklen_shift),
+			      num_blocks << raid_bdev->blocklen_shift,
+			      bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt);
+	if (entry->md_buf != NULL && md_buf != NULL) {
+		uint32_t md_size = spdk_bdev_get_md_size(&raid_bdev->bdev);
+
+		memcpy((uint8_t *)entry->md_buf + stripe_offset * md_size, md_buf, num_blocks * md_size);
+	}
+
+	spdk_spin_lock(&r5f_info->cache.lock);
+	for (i = stripe_offset; i < stripe_offset + num_blocks; i++) {
+		if (!spdk_bit_array_get(entry->valid, i)) {
+			spdk_bit_array_set(entry->valid, i);
+			entry->num_valid++;
+		}
+	}
+
+	entry->refs--;
+	if (entry->refs == 0 && entry->num_valid == r5f_info->stripe_blocks) {
+		raid5f_stripe_cache_start_writeback_locked(entry);
+		writeback = true;
+	}
+	spdk_spin_unlock(&r5f_info->cache.lock);
+
+	if (writeback) {
+		raid5f_stripe_cache_writeback(entry, raid_io);
+	}
+}
+
+/*
+ * Keep the stripe from being written back while a full stripe write or a
+ * degraded read, which reads the parity, is in progress. Returns -EAGAIN if the
+ * IO was queued until the stripe is written back or an entry is freed.
+ */
+static int
+raid5f_stripe_cache_lock_stripe(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+				struct stripe_cache_entry **_entry)
+{
+	struct raid5f_info *r5f_info = raid_io->raid_bdev->module_private;
+	struct stripe_cache_entry *entry;
+	int ret = 0;
+
+	if (!raid5f_stripe_cache_enabled(r5f_info)) {
+		return 0;
+	}
+
+	spdk_spin_lock(&r5f_info->cache.lock);
+	entry = raid5f_stripe_cache_get_locked(r5f_info, stripe_index);
+	if (entry == NULL) {
+		raid5f_stripe_cache_wait_for_entry_locked(r5f_info, raid_io);
+		ret = -EAGAIN;
+	} else if (entry->state == STRIPE_CACHE_ENTRY_WRITEBACK) {
+		TAILQ_INSERT_TAIL(&entry->waiting, spdk_bdev_io_from_ctx(raid_io), module_link);
+		ret = -EAGAIN;
+	} else {
+		entry->refs++;
+		*_entry = entry;
+	}
+	spdk_spin_unlock(&r5f_info->cache.lock);
+
+	return ret;
+}
+
+static void
+raid5f_stripe_cache_unlock_stripe(struct stripe_cache_entry *entry)
+{
+	struct raid5f_info *r5f_info = entry->r5f_info;
+	TAILQ_HEAD(, spdk_bdev_io) waiting = TAILQ_HEAD_INITIALIZER(waiting);
+
+	spdk_spin_lock(&r5f_info->cache.lock);
+	assert(entry->refs > 0);
+	entry->refs--;
+	if (entry->refs == 0 && TAILQ_EMPTY(&entry->writes)) {
+		raid5f_stripe_cache_put_locked(entry, &waiting);
+	}
+	spdk_spin_unlock(&r5f_info->cache.lock);
+
+	raid5f_stripe_cache_resubmit(&waiting);
+}
+
+static int
+raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			       uint8_t chunk_idx, uint64_t chunk_offset)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	void *bdev_io_md = spdk_bdev_io_get_md_buf(bdev_io);
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	int buf_idx;
+
+	stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.reconstruct);
+	if (!stripe_req) {
+		return -ENOMEM;
+	}
+
+	raid5f_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	stripe_req->reconstruct.chunk = &stripe_req->chunks[chunk_idx];
+	stripe_req->reconstruct.chunk_offset = chunk_offset;
+	stripe_req->reconstruct.chunk2 = NULL;
+
+	if (stripe_req->q_chunk != NULL) {
+		FOR_EACH_CHUNK(stripe_req, chunk) {
+			if (chunk == stripe_req->reconstruct.chunk ||
+			    raid_io->raid_ch->base_channel[chunk->index] != NULL) {
+				continue;
+			}
+			if (stripe_req->reconstruct.chunk2 != NULL) {
+				SPDK_ERRLOG("More than two chunks of stripe %" PRIu64 " are missing\n", stripe_index);
+				return -EIO;
+			}
+			stripe_req->reconstruct.chunk2 = chunk;
+		}
+
+		if (stripe_req->reconstruct.chunk2 == NULL) {
+			/* Only one chunk is missing, recover it using P */
+			stripe_req->reconstruct.chunk2 = stripe_req->q_chunk;
+		}
+	}
+
+	buf_idx = 0;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		if (chunk == stripe_req->reconstruct.chunk) {
+			int i;
+			int ret;
+
+			ret = raid5f_chunk_set_iovcnt(chunk, bdev_io->u.bdev.iovcnt);
+			if (ret) {
+				return ret;
+			}
+
+			for (i = 0; i < bdev_io->u.bdev.iovcnt; i++) {
+				chunk->iovs[i] = bdev_io->u.bdev.iovs[i];
+			}
+
+			chunk->md_buf = bdev_io_md;
+		} else {
+			struct iovec *iov = &chunk->iovs[0];
+
+			iov->iov_base = stripe_req->reconstruct.chunk_buffers[buf_idx];
+			iov->iov_len = bdev_io->u.bdev.num_blocks << raid_bdev->blocklen_shift;
+			chunk->iovcnt = 1;
+
+			if (bdev_io_md) {
+				chunk->md_buf = stripe_req->reconstruct.chunk_md_buffers[buf_idx];
+			}
 
 			buf_idx++;
 		}
 	}
 
+	if (raid5f_stripe_cache_lock_stripe(raid_io, stripe_index, &stripe_req->cache_lock) != 0) {
+		/* Resubmitted when the stripe is written back */
+		return 0;
+	}
+
 	raid_io->module_private = stripe_req;
 	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
 
@@ -770,8 +1854,7 @@ raid5f_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
 	uint8_t chunk_data_idx = stripe_offset >> raid_bdev->strip_size_shift;
-	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
-	uint8_t chunk_idx = chunk_data_idx < p_idx ? chunk_data_idx : chunk_data_idx + 1;
+	uint8_t chunk_idx = raid5f_stripe_data_chunk_index(raid_bdev, stripe_index, chunk_data_idx);
 	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk_idx];
 	struct spdk_io_channel *base_ch = raid_io->raid_ch->base_channel[chunk_idx];
 	uint64_t chunk_offset = stripe_offset - (chunk_data_idx << raid_bdev->strip_size_shift);
@@ -816,6 +1899,13 @@ raid5f_submit_rw_request(struct raid_bdev_io *raid_io)
 		ret = raid5f_submit_read_request(raid_io, stripe_index, stripe_offset);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
+		if (bdev_io->u.bdev.num_blocks < r5f_info->stripe_blocks) {
+			assert(raid5f_stripe_cache_enabled(r5f_info));
+			assert(stripe_offset + bdev_io->u.bdev.num_blocks <= r5f_info->stripe_blocks);
+			raid5f_stripe_cache_write(raid_io, stripe_index, stripe_offset);
+			ret = 0;
+			break;
+		}
 		assert(stripe_offset == 0);
 		assert(bdev_io->u.bdev.num_blocks == r5f_info->stripe_blocks);
 		ret = raid5f_submit_write_request(raid_io, stripe_index);
@@ -843,20 +1933,22 @@ raid5f_stripe_request_free(struct stripe_request *stripe_req)
 	if (stripe_req->type == STRIPE_REQ_WRITE) {
 		spdk_dma_free(stripe_req->write.parity_buf);
 		spdk_dma_free(stripe_req->write.parity_md_buf);
+		spdk_dma_free(stripe_req->write.q_buf);
+		spdk_dma_free(stripe_req->write.q_md_buf);
 	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
 		struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
 		struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
 		uint8_t i;
 
 		if (stripe_req->reconstruct.chunk_buffers) {
-			for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
+			for (i = 0; i < raid_bdev->num_base_bdevs - 1; i++) {
 				spdk_dma_free(stripe_req->reconstruct.chunk_buffers[i]);
 			}
 			free(stripe_req->reconstruct.chunk_buffers);
 		}
 
 		if (stripe_req->reconstruct.chunk_md_buffers) {
-			for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
+			for (i = 0; i < raid_bdev->num_base_bdevs - 1; i++) {
 				spdk_dma_free(stripe_req->reconstruct.chunk_md_buffers[i]);
 			}
 			free(stripe_req->reconstruct.chunk_md_buffers);
@@ -914,8 +2006,24 @@ raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_
 				goto err;
 			}
 		}
+
+		if (raid5f_is_raid6f(raid_bdev)) {
+			stripe_req->write.q_buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+			if (!stripe_req->write.q_buf) {
+				goto err;
+			}
+
+			if (raid_io_md_size != 0) {
+				stripe_req->write.q_md_buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size,
+							     r5f_info->buf_alignment, NULL);
+				if (!stripe_req->write.q_md_buf) {
+					goto err;
+				}
+			}
+		}
 	} else if (type == STRIPE_REQ_RECONSTRUCT) {
-		uint8_t n = raid5f_stripe_data_chunks_num(raid_bdev);
+		/* Buffers for all chunks except the one being reconstructed */
+		uint8_t n = raid_bdev->num_base_bdevs - 1;
 		void *buf;
 		uint8_t i;
 
@@ -962,7 +2070,7 @@ raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_
 		goto err;
 	}
 
-	stripe_req->chunk_xor_md_buffers = calloc(raid5f_stripe_data_chunks_num(raid_bdev),
+	stripe_req->chunk_xor_md_buffers = calloc(raid_bdev->num_base_bdevs,
 					   sizeof(stripe_req->chunk_xor_md_buffers[0]));
 	if (!stripe_req->chunk_xor_md_buffers) {
 		goto err;
@@ -974,6 +2082,276 @@ err:
 	return NULL;
 }
 
+static inline size_t
+raid5f_process_chunk_len(struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->strip_size << raid_bdev->blocklen_shift;
+}
+
+static inline size_t
+raid5f_process_chunk_md_len(struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->strip_size * spdk_bdev_get_md_size(&raid_bdev->bdev);
+}
+
+static int
+raid5f_process_alloc_buffers(struct raid5f_info *r5f_info)
+{
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint8_t n = raid_bdev->num_base_bdevs;
+
+	if (r5f_info->process.buf != NULL) {
+		return 0;
+	}
+
+	r5f_info->process.iovs = calloc(n, sizeof(struct iovec));
+	r5f_info->process.buf = spdk_dma_malloc(n * raid5f_process_chunk_len(raid_bdev),
+						r5f_info->buf_alignment, NULL);
+	if (r5f_info->process.iovs == NULL || r5f_info->process.buf == NULL) {
+		return -ENOMEM;
+	}
+
+	if (raid_bdev->bdev.md_len != 0 && !raid_bdev->bdev.md_interleave) {
+		r5f_info->process.md_buf = spdk_dma_malloc(n * raid5f_process_chunk_md_len(raid_bdev),
+					   r5f_info->buf_alignment, NULL);
+		if (r5f_info->process.md_buf == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static void
+raid5f_process_free_buffers(struct raid5f_info *r5f_info)
+{
+	free(r5f_info->process.iovs);
+	spdk_dma_free(r5f_info->process.buf);
+	spdk_dma_free(r5f_info->process.md_buf);
+}
+
+static inline void *
+raid5f_process_chunk_md_buf(struct raid5f_info *r5f_info, uint8_t idx)
+{
+	if (r5f_info->process.md_buf == NULL) {
+		return NULL;
+	}
+
+	return (uint8_t *)r5f_info->process.md_buf +
+	       idx * raid5f_process_chunk_md_len(r5f_info->raid_bdev);
+}
+
+static void
+raid5f_process_init_io_opts(struct raid5f_info *r5f_info, uint8_t idx,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->metadata = raid5f_process_chunk_md_buf(r5f_info, idx);
+}
+
+static void
+raid5f_process_queue_io_wait(struct raid5f_info *r5f_info, struct spdk_bdev_desc *desc,
+			     struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn)
+{
+	struct raid_bdev_process_request *process_req = r5f_info->process.process_req;
+
+	process_req->waitq_entry.bdev = spdk_bdev_desc_get_bdev(desc);
+	process_req->waitq_entry.cb_fn = cb_fn;
+	process_req->waitq_entry.cb_arg = r5f_info;
+	spdk_bdev_queue_io_wait(process_req->waitq_entry.bdev, ch, &process_req->waitq_entry);
+}
+
+/* Reconstruct the target's chunk of the stripe from the other chunks */
+static int
+raid5f_process_reconstruct_chunk(struct raid5f_info *r5f_info)
+{
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	struct raid_bdev_process_request *process_req = r5f_info->process.process_req;
+	uint8_t n = raid_bdev->num_base_bdevs;
+	size_t len = raid5f_process_chunk_len(raid_bdev);
+	void *bufs[n], *md_bufs[n];
+	bool missing[n];
+	uint8_t i;
+
+	for (i = 0; i < n; i++) {
+		bufs[i] = (uint8_t *)r5f_info->process.buf + i * len;
+		md_bufs[i] = raid5f_process_chunk_md_buf(r5f_info, i);
+		missing[i] = &raid_bdev->base_bdev_info[i] == process_req->target ||
+			     process_req->raid_ch->base_channel[i] == NULL;
+	}
+
+	return raid5f_recover_chunks(raid_bdev, r5f_info->process.stripe_index, bufs,
+				     r5f_info->process.md_buf != NULL ? md_bufs : NULL, missing, len,
+				     raid5f_process_chunk_md_len(raid_bdev));
+}
+
+static void
+raid5f_process_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid5f_info *r5f_info = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_process_request_complete(r5f_info->process.process_req, success ? 0 : -EIO);
+}
+
+static void
+raid5f_process_submit_write(void *_r5f_info)
+{
+	struct raid5f_info *r5f_info = _r5f_info;
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	struct raid_bdev_process_request *process_req = r5f_info->process.process_req;
+	uint8_t target_idx = process_req->target - raid_bdev->base_bdev_info;
+	struct iovec *iov = &r5f_info->process.iovs[target_idx];
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	iov->iov_base = (uint8_t *)r5f_info->process.buf + target_idx * raid5f_process_chunk_len(raid_bdev);
+	iov->iov_len = raid5f_process_chunk_len(raid_bdev);
+
+	raid5f_process_init_io_opts(r5f_info, target_idx, &io_opts);
+	ret = spdk_bdev_writev_blocks_ext(process_req->target->desc, process_req->target_ch, iov, 1,
+					  r5f_info->process.stripe_index << raid_bdev->strip_size_shift,
+					  raid_bdev->strip_size, raid5f_process_write_completed,
+					  r5f_info, &io_opts);
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid5f_process_queue_io_wait(r5f_info, process_req->target->desc,
+					     process_req->target_ch, raid5f_process_submit_write);
+	} else if (spdk_unlikely(ret != 0)) {
+		raid_bdev_process_request_complete(process_req, ret);
+	}
+}
+
+static void
+raid5f_process_chunk_read_complete(struct raid5f_info *r5f_info, int status)
+{
+	struct raid_bdev_process_request *process_req = r5f_info->process.process_req;
+	int ret;
+
+	if (status != 0) {
+		r5f_info->process.status = status;
+	}
+
+	assert(r5f_info->process.reads_remaining > 0);
+	if (--r5f_info->process.reads_remaining > 0) {
+		return;
+	}
+
+	if (r5f_info->process.status != 0) {
+		raid_bdev_process_request_complete(process_req, r5f_info->process.status);
+		return;
+	}
+
+	ret = raid5f_process_reconstruct_chunk(r5f_info);
+	if (ret != 0) {
+		SPDK_ERRLOG("Failed to reconstruct chunk of stripe %" PRIu64 ": %s\n",
+			    r5f_info->process.stripe_index, spdk_strerror(-ret));
+		raid_bdev_process_request_complete(process_req, ret);
+		return;
+	}
+
+	raid5f_process_submit_write(r5f_info);
+}
+
+static void
+raid5f_process_read_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid5f_info *r5f_info = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid5f_process_chunk_read_complete(r5f_info, success ? 0 : -EIO);
+}
+
+static void
+raid5f_process_submit_reads(void *_r5f_info)
+{
+	struct raid5f_info *r5f_info = _r5f_info;
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	struct raid_bdev_process_request *process_req = r5f_info->process.process_req;
+	struct raid_bdev_io_channel *raid_ch = process_req->raid_ch;
+	struct spdk_bdev_ext_io_opts io_opts;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	struct iovec *iov;
+	uint8_t i;
+	int ret;
+
+	for (i = r5f_info->process.next_chunk; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+		base_ch = raid_ch->base_channel[i];
+
+		if (base_ch == NULL) {
+			/* Covers the target as well, which is not in the process' raid channel */
+			continue;
+		}
+
+		iov = &r5f_info->process.iovs[i];
+		iov->iov_base = (uint8_t *)r5f_info->process.buf + i * raid5f_process_chunk_len(raid_bdev);
+		iov->iov_len = raid5f_process_chunk_len(raid_bdev);
+
+		raid5f_process_init_io_opts(r5f_info, i, &io_opts);
+		ret = spdk_bdev_readv_blocks_ext(base_info->desc, base_ch, iov, 1,
+						 r5f_info->process.stripe_index << raid_bdev->strip_size_shift,
+						 raid_bdev->strip_size, raid5f_process_read_completed,
+						 r5f_info, &io_opts);
+		if (spdk_unlikely(ret != 0)) {
+			if (ret == -ENOMEM) {
+				r5f_info->process.next_chunk = i;
+				raid5f_process_queue_io_wait(r5f_info, base_info->desc, base_ch,
+							     raid5f_process_submit_reads);
+				return;
+			}
+
+			/* Fail the chunks that were not submitted */
+			r5f_info->process.status = ret;
+			r5f_info->process.reads_remaining -= raid_bdev->num_base_bdevs - 1 - i;
+			raid5f_process_chunk_read_complete(r5f_info, ret);
+			return;
+		}
+	}
+
+	r5f_info->process.next_chunk = i;
+}
+
+static int
+raid5f_submit_process_request(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint8_t i;
+	int ret;
+
+	ret = raid5f_process_alloc_buffers(r5f_info);
+	if (ret != 0) {
+		return ret;
+	}
+
+	/* Windows are made of full stripes, rebuild one stripe per request */
+	assert(process_req->offset_blocks % r5f_info->stripe_blocks == 0);
+	process_req->num_blocks = spdk_min(process_req->num_blocks, r5f_info->stripe_blocks);
+
+	r5f_info->process.process_req = process_req;
+	r5f_info->process.stripe_index = process_req->offset_blocks / r5f_info->stripe_blocks;
+	r5f_info->process.next_chunk = 0;
+	r5f_info->process.status = 0;
+	r5f_info->process.reads_remaining = 0;
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (process_req->raid_ch->base_channel[i] != NULL) {
+			r5f_info->process.reads_remaining++;
+		}
+	}
+
+	if (r5f_info->process.reads_remaining < raid5f_stripe_data_chunks_num(raid_bdev)) {
+		return -EIO;
+	}
+
+	raid5f_process_submit_reads(r5f_info);
+
+	return 0;
+}
+
 static void
 raid5f_ioch_destroy(void *io_device, void *ctx_buf)
 {
@@ -981,6 +2359,10 @@ raid5f_ioch_destroy(void *io_device, void *ctx_buf)
 	struct stripe_request *stripe_req;
 
 	assert(TAILQ_EMPTY(&r5ch->xor_retry_queue));
+	assert(TAILQ_EMPTY(&r5ch->cache.entries));
+	assert(TAILQ_EMPTY(&r5ch->cache.writeback_retry));
+
+	spdk_poller_unregister(&r5ch->cache.poller);
 
 	while ((stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.write))) {
 		TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
@@ -1013,6 +2395,8 @@ raid5f_ioch_create(void *io_device, void *ctx_buf)
 	TAILQ_INIT(&r5ch->free_stripe_requests.write);
 	TAILQ_INIT(&r5ch->free_stripe_requests.reconstruct);
 	TAILQ_INIT(&r5ch->xor_retry_queue);
+	TAILQ_INIT(&r5ch->cache.entries);
+	TAILQ_INIT(&r5ch->cache.writeback_retry);
 
 	for (i = 0; i < RAID5F_MAX_STRIPES; i++) {
 		stripe_req = raid5f_stripe_request_alloc(r5ch, STRIPE_REQ_WRITE);
@@ -1053,6 +2437,14 @@ raid5f_ioch_create(void *io_device, void *ctx_buf)
 		goto err;
 	}
 
+	if (raid5f_stripe_cache_enabled(r5f_info)) {
+		r5ch->cache.poller = SPDK_POLLER_REGISTER(raid5f_stripe_cache_poll, r5ch,
+				     RAID5F_STRIPE_CACHE_WRITEBACK_DELAY_US);
+		if (!r5ch->cache.poller) {
+			goto err;
+		}
+	}
+
 	return 0;
 err:
 	SPDK_ERRLOG("Failed to initialize io channel\n");
@@ -1060,13 +2452,104 @@ err:
 	return -ENOMEM;
 }
 
+static void
+raid5f_stripe_cache_free(struct raid5f_info *r5f_info)
+{
+	struct stripe_cache_entry *entry;
+	uint32_t i;
+
+	if (r5f_info->cache.entries == NULL) {
+		return;
+	}
+
+	for (i = 0; i < r5f_info->cache.num_entries; i++) {
+		entry = &r5f_info->cache.entries[i];
+
+		assert(entry->state == STRIPE_CACHE_ENTRY_FREE);
+		spdk_dma_free(entry->buf);
+		spdk_dma_free(entry->md_buf);
+		spdk_dma_free(entry->writeback.buf);
+		spdk_dma_free(entry->writeback.md_buf);
+		free(entry->writeback.iovs);
+		spdk_bit_array_free(&entry->valid);
+	}
+
+	free(r5f_info->cache.entries);
+	r5f_info->cache.entries = NULL;
+	spdk_spin_destroy(&r5f_info->cache.lock);
+}
+
+static int
+raid5f_stripe_cache_init(struct raid5f_info *r5f_info, uint32_t num_entries)
+{
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint8_t n = raid_bdev->num_base_bdevs;
+	size_t chunk_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	size_t chunk_md_len = raid_bdev->strip_size * spdk_bdev_get_md_size(&raid_bdev->bdev);
+	bool separate_md = raid_bdev->bdev.md_len != 0 && !raid_bdev->bdev.md_interleave;
+	size_t data_chunks = raid5f_stripe_data_chunks_num(raid_bdev);
+	struct stripe_cache_entry *entry;
+	uint32_t i;
+
+	spdk_spin_init(&r5f_info->cache.lock);
+	RB_INIT(&r5f_info->cache.tree);
+	TAILQ_INIT(&r5f_info->cache.in_use);
+	TAILQ_INIT(&r5f_info->cache.free);
+	TAILQ_INIT(&r5f_info->cache.waiting);
+	r5f_info->cache.writeback_delay_ticks = RAID5F_STRIPE_CACHE_WRITEBACK_DELAY_US *
+						spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+
+	r5f_info->cache.entries = calloc(num_entries, sizeof(*r5f_info->cache.entries));
+	if (r5f_info->cache.entries == NULL) {
+		spdk_spin_destroy(&r5f_info->cache.lock);
+		return -ENOMEM;
+	}
+	r5f_info->cache.num_entries = num_entries;
+
+	for (i = 0; i < num_entries; i++) {
+		entry = &r5f_info->cache.entries[i];
+
+		entry->r5f_info = r5f_info;
+		entry->state = STRIPE_CACHE_ENTRY_FREE;
+		TAILQ_INIT(&entry->writes);
+		TAILQ_INIT(&entry->waiting);
+		TAILQ_INSERT_TAIL(&r5f_info->cache.free, entry, link);
+
+		entry->buf = spdk_dma_malloc(data_chunks * chunk_len, r5f_info->buf_alignment, NULL);
+		entry->writeback.buf = spdk_dma_malloc(n * chunk_len, r5f_info->buf_alignment, NULL);
+		entry->writeback.iovs = calloc(n, sizeof(struct iovec));
+		entry->valid = spdk_bit_array_create(r5f_info->stripe_blocks);
+		if (entry->buf == NULL || entry->writeback.buf == NULL || entry->writeback.iovs == NULL ||
+		    entry->valid == NULL) {
+			goto err;
+		}
+
+		if (separate_md) {
+			entry->md_buf = spdk_dma_malloc(data_chunks * chunk_md_len, r5f_info->buf_alignment, NULL);
+			entry->writeback.md_buf = spdk_dma_malloc(n * chunk_md_len, r5f_info->buf_alignment, NULL);
+			if (entry->md_buf == NULL || entry->writeback.md_buf == NULL) {
+				goto err;
+			}
+		}
+	}
+
+	return 0;
+err:
+	SPDK_ERRLOG("Failed to allocate the stripe cache\n");
+	raid5f_stripe_cache_free(r5f_info);
+	r5f_info->cache.num_entries = 0;
+	return -ENOMEM;
+}
+
 static int
 raid5f_start(struct raid_bdev *raid_bdev)
 {
 	uint64_t min_blockcnt = UINT64_MAX;
 	struct raid_base_bdev_info *base_info;
 	struct raid5f_info *r5f_info;
+	struct raid_bdev_opts opts;
 	size_t alignment = 0;
+	int ret;
 
 	r5f_info = calloc(1, sizeof(*r5f_info));
 	if (!r5f_info) {
@@ -1093,6 +2576,21 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	raid_bdev->bdev.write_unit_size = r5f_info->stripe_blocks;
 	raid_bdev->bdev.split_on_write_unit = true;
 
+	raid_bdev_get_opts(&opts);
+	if (opts.stripe_cache_size > 0) {
+		ret = raid5f_stripe_cache_init(r5f_info, opts.stripe_cache_size);
+		if (ret != 0) {
+			free(r5f_info);
+			return ret;
+		}
+
+		/*
+		 * Writes smaller than a stripe go through the stripe cache and are
+		 * only split on strip boundaries.
+		 */
+		raid_bdev->bdev.split_on_write_unit = false;
+	}
+
 	raid_bdev->module_private = r5f_info;
 
 	spdk_io_device_register(r5f_info, raid5f_ioch_create, raid5f_ioch_destroy,
@@ -1108,6 +2606,8 @@ raid5f_io_device_unregister_done(void *io_device)
 
 	raid_bdev_module_stop_done(r5f_info->raid_bdev);
 
+	raid5f_process_free_buffers(r5f_info);
+	raid5f_stripe_cache_free(r5f_info);
 	free(r5f_info);
 }
 
@@ -1137,7 +2637,20 @@ static struct raid_bdev_module g_raid5f_module = {
 	.stop = raid5f_stop,
 	.submit_rw_request = raid5f_submit_rw_request,
 	.get_io_channel = raid5f_get_io_channel,
+	.submit_process_request = raid5f_submit_process_request,
 };
 RAID_MODULE_REGISTER(&g_raid5f_module)
 
+static struct raid_bdev_module g_raid6f_module = {
+	.level = RAID6F,
+	.base_bdevs_min = 4,
+	.base_bdevs_constraint = {CONSTRAINT_MAX_BASE_BDEVS_REMOVED, 2},
+	.start = raid5f_start,
+	.stop = raid5f_stop,
+	.submit_rw_request = raid5f_submit_rw_request,
+	.get_io_channel = raid5f_get_io_channel,
+	.submit_process_request = raid5f_submit_process_request,
+};
+RAID_MODULE_REGISTER(&g_raid6f_module)
+
 SPDK_LOG_REGISTER_COMPONENT(bdev_raid5f)
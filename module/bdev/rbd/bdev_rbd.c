@@ -9,6 +9,7 @@
 
 #include <rbd/librbd.h>
 #include <rados/librados.h>
+#include <sys/eventfd.h>
 
 #include "spdk/env.h"
 #include "spdk/bdev.h"
@@ -23,6 +24,9 @@
 
 static int bdev_rbd_count = 0;
 
+/* Maximum number of completions reaped from a channel's image at once */
+#define SPDK_RBD_MAX_EVENTS	32
+
 struct bdev_rbd_pool_ctx {
 	rados_t *cluster_p;
 	char *name;
@@ -51,6 +55,8 @@ struct bdev_rbd {
 	} rados_ctx;
 
 	rbd_image_t image;
+	/* Open the image for each channel and poll its completions from the channel's thread */
+	bool image_per_channel;
 
 	rbd_image_info_t info;
 	struct spdk_thread *destruct_td;
@@ -63,6 +69,12 @@ struct bdev_rbd {
 struct bdev_rbd_io_channel {
 	struct bdev_rbd *disk;
 	struct spdk_io_channel *group_ch;
+	/* The fields below are only used when image_per_channel is set */
+	rbd_image_t image;
+	/* eventfd librbd signals once an I/O of the channel's image has completed */
+	int efd;
+	struct spdk_poller *poller;
+	struct spdk_interrupt *intr;
 };
 
 struct bdev_rbd_io {
@@ -500,10 +512,18 @@ _bdev_rbd_start_aio(struct bdev_rbd *disk, struct spdk_bdev_io *bdev_io,
 {
 	int ret;
 	struct bdev_rbd_io *rbd_io = (struct bdev_rbd_io *)bdev_io->driver_ctx;
+	struct bdev_rbd_io_channel *ch;
 	rbd_image_t image = disk->image;
+	rbd_callback_t cb_fn = bdev_rbd_finish_aiocb;
 
-	ret = rbd_aio_create_completion(bdev_io, bdev_rbd_finish_aiocb,
-					&rbd_io->comp);
+	if (disk->image_per_channel) {
+		/* The completion is reaped by the channel's poller, on the submitting thread */
+		ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+		image = ch->image;
+		cb_fn = NULL;
+	}
+
+	ret = rbd_aio_create_completion(bdev_io, cb_fn, &rbd_io->comp);
 	if (ret < 0) {
 		goto err;
 	}
@@ -776,13 +796,140 @@ bdev_rbd_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 	}
 }
 
+static int
+bdev_rbd_channel_poll(void *arg)
+{
+	struct bdev_rbd_io_channel *ch = arg;
+	rbd_completion_t comps[SPDK_RBD_MAX_EVENTS];
+	int i, num_events;
+
+	num_events = rbd_poll_io_events(ch->image, comps, SPDK_RBD_MAX_EVENTS);
+	if (num_events < 0) {
+		SPDK_ERRLOG("Failed to poll rbd image events: %s\n", spdk_strerror(-num_events));
+		return SPDK_POLLER_IDLE;
+	}
+
+	/* We're on the submitting thread, so the I/Os are completed without a message */
+	for (i = 0; i < num_events; i++) {
+		bdev_rbd_finish_aiocb(comps[i], NULL);
+	}
+
+	return num_events > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static int
+bdev_rbd_channel_interrupt(void *arg)
+{
+	struct bdev_rbd_io_channel *ch = arg;
+	uint64_t num_events;
+	int rc;
+
+	rc = read(ch->efd, &num_events, sizeof(num_events));
+	if (rc < 0 && errno != EAGAIN) {
+		SPDK_ERRLOG("Failed to acknowledge rbd image events: %s\n", spdk_strerror(errno));
+		return -errno;
+	}
+
+	rc = bdev_rbd_channel_poll(ch);
+	if (rc == SPDK_POLLER_BUSY) {
+		/* There may be more completions than a single poll reaps, so come back for them */
+		num_events = 1;
+		if (write(ch->efd, &num_events, sizeof(num_events)) < 0) {
+			SPDK_ERRLOG("Failed to notify rbd channel: %s\n", spdk_strerror(errno));
+		}
+	}
+
+	return rc;
+}
+
+static void *
+bdev_rbd_open_channel_image(void *arg)
+{
+	struct bdev_rbd_io_channel *ch = arg;
+	struct bdev_rbd *disk = ch->disk;
+	rados_ioctx_t io_ctx;
+
+	if (disk->cluster_name) {
+		io_ctx = disk->rados_ctx.ctx->io_ctx;
+	} else {
+		io_ctx = disk->rados_ctx.io_ctx;
+	}
+
+	if (rbd_open(io_ctx, disk->rbd_name, &ch->image, NULL) < 0) {
+		SPDK_ERRLOG("Failed to open rbd image %s for channel\n", disk->rbd_name);
+		return NULL;
+	}
+
+	return arg;
+}
+
+static int
+bdev_rbd_channel_image_init(struct bdev_rbd_io_channel *ch)
+{
+	int rc;
+
+	/* rbd_open may spawn librbd threads, don't let them inherit the SPDK thread's affinity */
+	if (spdk_call_unaffinitized(bdev_rbd_open_channel_image, ch) == NULL) {
+		return -EIO;
+	}
+
+	ch->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ch->efd < 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Failed to create eventfd: %s\n", spdk_strerror(errno));
+		goto err_close;
+	}
+
+	rc = rbd_set_image_notification(ch->image, ch->efd, EVENT_TYPE_EVENTFD);
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed to set rbd image notification: %s\n", spdk_strerror(-rc));
+		goto err_efd;
+	}
+
+	if (spdk_interrupt_mode_is_enabled()) {
+		ch->intr = SPDK_INTERRUPT_REGISTER(ch->efd, bdev_rbd_channel_interrupt, ch);
+		if (ch->intr == NULL) {
+			rc = -ENOMEM;
+			goto err_efd;
+		}
+	} else {
+		/* In polling mode the eventfd is never read, rbd_poll_io_events() is enough */
+		ch->poller = SPDK_POLLER_REGISTER(bdev_rbd_channel_poll, ch, 0);
+	}
+
+	return 0;
+
+err_efd:
+	close(ch->efd);
+err_close:
+	rbd_close(ch->image);
+	return rc;
+}
+
+static void
+bdev_rbd_channel_image_fini(struct bdev_rbd_io_channel *ch)
+{
+	spdk_poller_unregister(&ch->poller);
+	spdk_interrupt_unregister(&ch->intr);
+	rbd_close(ch->image);
+	close(ch->efd);
+}
+
 static int
 bdev_rbd_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_rbd_io_channel *ch = ctx_buf;
 	struct bdev_rbd *disk = io_device;
+	int rc;
 
 	ch->disk = disk;
+	if (disk->image_per_channel) {
+		rc = bdev_rbd_channel_image_init(ch);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
 	ch->group_ch = spdk_get_io_channel(&rbd_if);
 	assert(ch->group_ch != NULL);
 
@@ -794,6 +941,10 @@ bdev_rbd_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_rbd_io_channel *ch = ctx_buf;
 
+	if (ch->disk->image_per_channel) {
+		bdev_rbd_channel_image_fini(ch);
+	}
+
 	spdk_put_io_channel(ch->group_ch);
 }
 
@@ -854,6 +1005,8 @@ bdev_rbd_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 
 	spdk_json_write_named_string(w, "rbd_name", rbd_bdev->rbd_name);
 
+	spdk_json_write_named_bool(w, "image_per_channel", rbd_bdev->image_per_channel);
+
 	if (rbd_bdev->cluster_name) {
 		bdev_rbd_cluster_dump_entry(rbd_bdev->cluster_name, w);
 		goto end;
@@ -913,6 +1066,10 @@ bdev_rbd_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w
 	spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &bdev->uuid);
 	spdk_json_write_named_string(w, "uuid", uuid_str);
 
+	if (rbd->image_per_channel) {
+		spdk_json_write_named_bool(w, "image_per_channel", true);
+	}
+
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -1249,7 +1406,8 @@ bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		const char *rbd_name,
 		uint32_t block_size,
 		const char *cluster_name,
-		const struct spdk_uuid *uuid)
+		const struct spdk_uuid *uuid,
+		bool image_per_channel)
 {
 	struct bdev_rbd *rbd;
 	int ret;
@@ -1319,6 +1477,7 @@ bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 	rbd->disk.product_name = "Ceph Rbd Disk";
 	bdev_rbd_count++;
 
+	rbd->image_per_channel = image_per_channel;
 	rbd->disk.write_cache = 0;
 	rbd->disk.blocklen = block_size;
 	rbd->disk.blockcnt = rbd->info.size / rbd->disk.blocklen;
@@ -25,10 +25,26 @@ char **bdev_rbd_dup_config(const char *const *config);
 
 typedef void (*spdk_delete_rbd_complete)(void *cb_arg, int bdeverrno);
 
+/**
+ * Create rbd bdev.
+ *
+ * \param bdev Output parameter for the created bdev.
+ * \param name Name of rbd bdev, or NULL to generate one.
+ * \param user_id Ceph user name, or NULL.
+ * \param pool_name Name of the Ceph pool.
+ * \param config Map of rados configuration keys to values, or NULL.
+ * \param rbd_name Name of the rbd image.
+ * \param block_size Block size of the bdev.
+ * \param cluster_name Name of a registered Rados cluster, or NULL.
+ * \param uuid UUID of the bdev, or NULL to generate one.
+ * \param image_per_channel Open the image separately for each I/O channel and poll its
+ * completions from the channel's thread instead of getting them from librbd threads.
+ */
 int bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		    const char *pool_name,
 		    const char *const *config,
-		    const char *rbd_name, uint32_t block_size, const char *cluster_name, const struct spdk_uuid *uuid);
+		    const char *rbd_name, uint32_t block_size, const char *cluster_name,
+		    const struct spdk_uuid *uuid, bool image_per_channel);
 /**
  * Delete rbd bdev.
  *
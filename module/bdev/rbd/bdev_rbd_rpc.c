@@ -18,6 +18,7 @@ struct rpc_create_rbd {
 	char **config;
 	char *cluster_name;
 	char *uuid;
+	bool image_per_channel;
 };
 
 static void
@@ -82,7 +83,11 @@ static const struct spdk_json_object_decoder rpc_create_rbd_decoders[] = {
 	{"block_size", offsetof(struct rpc_create_rbd, block_size), spdk_json_decode_uint32},
 	{"config", offsetof(struct rpc_create_rbd, config), bdev_rbd_decode_config, true},
 	{"cluster_name", offsetof(struct rpc_create_rbd, cluster_name), spdk_json_decode_string, true},
-	{"uuid", offsetof(struct rpc_create_rbd, uuid), spdk_json_decode_string, true}
+	{"uuid", offsetof(struct rpc_create_rbd, uuid), spdk_json_decode_string, true},
+	{
+		"image_per_channel", offsetof(struct rpc_create_rbd, image_per_channel),
+		spdk_json_decode_bool, true
+	}
 };
 
 static void
@@ -117,7 +122,7 @@ rpc_bdev_rbd_create(struct spdk_jsonrpc_request *request,
 	rc = bdev_rbd_create(&bdev, req.name, req.user_id, req.pool_name,
 			     (const char *const *)req.config,
 			     req.rbd_name,
-			     req.block_size, req.cluster_name, uuid);
+			     req.block_size, req.cluster_name, uuid, req.image_per_channel);
 	if (rc) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
 		goto cleanup;
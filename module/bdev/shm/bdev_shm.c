@@ -0,0 +1,564 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "bdev_shm.h"
+
+#include "spdk/env.h"
+#include "spdk/json.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+struct shm_bdev {
+	struct spdk_bdev		bdev;
+	char				*export_name;
+	struct bdev_shm_region		*region;
+	TAILQ_ENTRY(shm_bdev)		link;
+};
+
+struct shm_bdev_io {
+	uint32_t			slot;
+};
+
+struct shm_io_channel {
+	struct shm_bdev			*sbdev;
+	struct bdev_shm_queue		*queue;
+	/* I/O owning each of the queue pair's slots */
+	struct spdk_bdev_io		**slots;
+	uint32_t			*free_slots;
+	uint32_t			num_free;
+	/* I/Os waiting for a free slot */
+	TAILQ_HEAD(, spdk_bdev_io)	pending;
+	struct spdk_poller		*poller;
+};
+
+static TAILQ_HEAD(, shm_bdev) g_shm_bdevs = TAILQ_HEAD_INITIALIZER(g_shm_bdevs);
+
+static int bdev_shm_initialize(void);
+static void bdev_shm_finish(void);
+static int bdev_shm_config_json(struct spdk_json_write_ctx *w);
+static void bdev_shm_examine(struct spdk_bdev *bdev);
+
+static int
+bdev_shm_get_ctx_size(void)
+{
+	return sizeof(struct shm_bdev_io);
+}
+
+static struct spdk_bdev_module shm_if = {
+	.name = "shm",
+	.module_init = bdev_shm_initialize,
+	.module_fini = bdev_shm_finish,
+	.config_json = bdev_shm_config_json,
+	.examine_config = bdev_shm_examine,
+	.get_ctx_size = bdev_shm_get_ctx_size,
+};
+
+SPDK_BDEV_MODULE_REGISTER(shm, &shm_if)
+
+static struct bdev_shm_region *
+shm_region_lookup(const char *export_name)
+{
+	char mz_name[SPDK_MAX_MEMZONE_NAME_LEN];
+	struct bdev_shm_region *region;
+
+	snprintf(mz_name, sizeof(mz_name), "%s%s", BDEV_SHM_MEMZONE_PREFIX, export_name);
+	region = spdk_memzone_lookup(mz_name);
+	if (region == NULL) {
+		return NULL;
+	}
+
+	if (region->magic != BDEV_SHM_MAGIC || region->version != BDEV_SHM_VERSION) {
+		SPDK_ERRLOG("Memzone %s isn't a bdev_shm export of version %u\n", mz_name,
+			    BDEV_SHM_VERSION);
+		return NULL;
+	}
+
+	return region;
+}
+
+static inline bool
+shm_region_ready(struct bdev_shm_region *region)
+{
+	return __atomic_load_n(&region->state, __ATOMIC_ACQUIRE) == BDEV_SHM_STATE_READY;
+}
+
+static void
+shm_release_slot(struct shm_io_channel *ch, uint32_t slot)
+{
+	ch->slots[slot] = NULL;
+	ch->free_slots[ch->num_free++] = slot;
+}
+
+static void
+shm_push_cmd(struct shm_io_channel *ch, struct spdk_bdev_io *bdev_io, enum bdev_shm_opc opc)
+{
+	struct bdev_shm_region *region = ch->sbdev->region;
+	struct shm_bdev_io *io = (struct shm_bdev_io *)bdev_io->driver_ctx;
+	struct bdev_shm_cmd *cmd = bdev_shm_get_cmd(region, ch->queue, io->slot);
+
+	cmd->opc = opc;
+	cmd->status = 0;
+	cmd->offset_blocks = bdev_io->u.bdev.offset_blocks;
+	cmd->num_blocks = bdev_io->u.bdev.num_blocks;
+
+	bdev_shm_ring_push(region, &ch->queue->sq, io->slot);
+}
+
+/* Returns false if there is no free slot to submit the I/O to */
+static bool
+_shm_submit_request(struct shm_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_shm_region *region = ch->sbdev->region;
+	struct shm_bdev_io *io = (struct shm_bdev_io *)bdev_io->driver_ctx;
+	uint64_t len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+	enum bdev_shm_opc opc;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_ZCOPY && !bdev_io->u.bdev.zcopy.start) {
+		/* The slot is still held by the start of the zero copy operation */
+		if (bdev_io->u.bdev.zcopy.commit) {
+			shm_push_cmd(ch, bdev_io, BDEV_SHM_OPC_WRITE);
+		} else {
+			shm_release_slot(ch, io->slot);
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		}
+		return true;
+	}
+
+	if (ch->num_free == 0) {
+		return false;
+	}
+
+	io->slot = ch->free_slots[--ch->num_free];
+	ch->slots[io->slot] = bdev_io;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		opc = BDEV_SHM_OPC_READ;
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		spdk_copy_iovs_to_buf(bdev_shm_get_buf(region, ch->queue, io->slot), len,
+				      bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt);
+		opc = BDEV_SHM_OPC_WRITE;
+		break;
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		if (!bdev_io->u.bdev.zcopy.populate) {
+			spdk_bdev_io_set_buf(bdev_io, bdev_shm_get_buf(region, ch->queue, io->slot),
+					     len);
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+			return true;
+		}
+		opc = BDEV_SHM_OPC_READ;
+		break;
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		opc = BDEV_SHM_OPC_FLUSH;
+		break;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		opc = BDEV_SHM_OPC_UNMAP;
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		opc = BDEV_SHM_OPC_WRITE_ZEROES;
+		break;
+	default:
+		assert(false);
+		shm_release_slot(ch, io->slot);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return true;
+	}
+
+	shm_push_cmd(ch, bdev_io, opc);
+
+	return true;
+}
+
+static void
+shm_submit_request(struct shm_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	/* Keep the submission order while waiting for slots */
+	if (!TAILQ_EMPTY(&ch->pending) || !_shm_submit_request(ch, bdev_io)) {
+		TAILQ_INSERT_TAIL(&ch->pending, bdev_io, module_link);
+	}
+}
+
+static void
+shm_get_buf_cb(struct spdk_io_channel *_ch, struct spdk_bdev_io *bdev_io, bool success)
+{
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	shm_submit_request(spdk_io_channel_get_ctx(_ch), bdev_io);
+}
+
+static void
+bdev_shm_submit_request(struct spdk_io_channel *_ch, struct spdk_bdev_io *bdev_io)
+{
+	struct shm_io_channel *ch = spdk_io_channel_get_ctx(_ch);
+	struct bdev_shm_region *region = ch->sbdev->region;
+	uint64_t len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_RESET:
+		/* The exporter doesn't hold any I/O that a reset could abort */
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		return;
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		/* Read and writes are split on the I/O size, zero copy operations aren't */
+		if (spdk_unlikely(len > region->io_size)) {
+			SPDK_ERRLOG("%s: %" PRIu64 " bytes I/O exceeds the export's I/O size\n",
+				    ch->sbdev->bdev.name, len);
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (spdk_unlikely(!shm_region_ready(region))) {
+		if (bdev_io->type == SPDK_BDEV_IO_TYPE_ZCOPY && !bdev_io->u.bdev.zcopy.start) {
+			shm_release_slot(ch, ((struct shm_bdev_io *)bdev_io->driver_ctx)->slot);
+		}
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ && bdev_io->u.bdev.iovs[0].iov_base == NULL) {
+		spdk_bdev_io_get_buf(bdev_io, shm_get_buf_cb, len);
+		return;
+	}
+
+	shm_submit_request(ch, bdev_io);
+}
+
+static void
+shm_complete_cmd(struct shm_io_channel *ch, uint32_t slot)
+{
+	struct bdev_shm_region *region = ch->sbdev->region;
+	struct spdk_bdev_io *bdev_io = ch->slots[slot];
+	struct bdev_shm_cmd *cmd = bdev_shm_get_cmd(region, ch->queue, slot);
+	void *buf = bdev_shm_get_buf(region, ch->queue, slot);
+	uint64_t len;
+
+	if (spdk_unlikely(bdev_io == NULL)) {
+		SPDK_ERRLOG("%s: completion of unused slot %u\n", ch->sbdev->bdev.name, slot);
+		return;
+	}
+
+	len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		if (cmd->status == 0) {
+			spdk_copy_buf_to_iovs(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, buf,
+					      len);
+		}
+		shm_release_slot(ch, slot);
+		break;
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		if (bdev_io->u.bdev.zcopy.start && cmd->status == 0) {
+			/* The user keeps the slot until the end of the zero copy operation */
+			spdk_bdev_io_set_buf(bdev_io, buf, len);
+		} else {
+			shm_release_slot(ch, slot);
+		}
+		break;
+	default:
+		shm_release_slot(ch, slot);
+		break;
+	}
+
+	spdk_bdev_io_complete(bdev_io, cmd->status == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS :
+			      SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static int
+shm_io_poll(void *arg)
+{
+	struct shm_io_channel *ch = arg;
+	struct bdev_shm_region *region = ch->sbdev->region;
+	struct spdk_bdev_io *bdev_io;
+	uint32_t slot;
+	int count = 0;
+
+	while (bdev_shm_ring_pop(region, &ch->queue->cq, &slot)) {
+		shm_complete_cmd(ch, slot);
+		count++;
+	}
+
+	while ((bdev_io = TAILQ_FIRST(&ch->pending)) != NULL) {
+		if (!_shm_submit_request(ch, bdev_io)) {
+			break;
+		}
+		TAILQ_REMOVE(&ch->pending, bdev_io, module_link);
+		count++;
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static bool
+bdev_shm_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	struct shm_bdev *sbdev = ctx;
+
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_RESET:
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		return true;
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		return sbdev->region->opc_mask & (1U << BDEV_SHM_OPC_FLUSH);
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		return sbdev->region->opc_mask & (1U << BDEV_SHM_OPC_UNMAP);
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		return sbdev->region->opc_mask & (1U << BDEV_SHM_OPC_WRITE_ZEROES);
+	default:
+		return false;
+	}
+}
+
+static struct spdk_io_channel *
+bdev_shm_get_io_channel(void *ctx)
+{
+	return spdk_get_io_channel(ctx);
+}
+
+static int
+shm_bdev_create_cb(void *io_device, void *ctx_buf)
+{
+	struct shm_bdev *sbdev = io_device;
+	struct shm_io_channel *ch = ctx_buf;
+	struct bdev_shm_region *region = sbdev->region;
+	uint32_t qid, i;
+
+	/* The export may have gone away since the bdev was created */
+	if (shm_region_lookup(sbdev->export_name) != region || !shm_region_ready(region)) {
+		SPDK_ERRLOG("%s: export %s is gone\n", sbdev->bdev.name, sbdev->export_name);
+		return -ENODEV;
+	}
+
+	for (qid = 0; qid < region->num_queues; qid++) {
+		uint32_t unclaimed = 0;
+
+		if (__atomic_compare_exchange_n(&region->queues[qid].claimed, &unclaimed, 1, false,
+						__ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	if (qid == region->num_queues) {
+		SPDK_ERRLOG("%s: all %u queues of export %s are in use\n", sbdev->bdev.name,
+			    region->num_queues, sbdev->export_name);
+		return -EBUSY;
+	}
+
+	ch->sbdev = sbdev;
+	ch->queue = &region->queues[qid];
+	TAILQ_INIT(&ch->pending);
+
+	ch->slots = calloc(region->queue_depth, sizeof(*ch->slots));
+	ch->free_slots = calloc(region->queue_depth, sizeof(*ch->free_slots));
+	if (ch->slots == NULL || ch->free_slots == NULL) {
+		goto err;
+	}
+
+	for (i = 0; i < region->queue_depth; i++) {
+		ch->free_slots[i] = region->queue_depth - 1 - i;
+	}
+	ch->num_free = region->queue_depth;
+
+	ch->poller = SPDK_POLLER_REGISTER(shm_io_poll, ch, 0);
+	if (ch->poller == NULL) {
+		goto err;
+	}
+
+	return 0;
+
+err:
+	free(ch->slots);
+	free(ch->free_slots);
+	__atomic_store_n(&ch->queue->claimed, 0, __ATOMIC_RELEASE);
+
+	return -ENOMEM;
+}
+
+static void
+shm_bdev_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct shm_io_channel *ch = ctx_buf;
+
+	assert(TAILQ_EMPTY(&ch->pending));
+	assert(ch->num_free == ch->sbdev->region->queue_depth);
+
+	spdk_poller_unregister(&ch->poller);
+	free(ch->slots);
+	free(ch->free_slots);
+	__atomic_store_n(&ch->queue->claimed, 0, __ATOMIC_RELEASE);
+}
+
+static void
+shm_bdev_free(void *io_device)
+{
+	struct shm_bdev *sbdev = io_device;
+
+	free(sbdev->export_name);
+	free(sbdev->bdev.name);
+	free(sbdev);
+}
+
+static int
+bdev_shm_destruct(void *ctx)
+{
+	struct shm_bdev *sbdev = ctx;
+
+	TAILQ_REMOVE(&g_shm_bdevs, sbdev, link);
+	spdk_io_device_unregister(sbdev, shm_bdev_free);
+
+	return 0;
+}
+
+static int
+bdev_shm_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct shm_bdev *sbdev = ctx;
+
+	spdk_json_write_named_object_begin(w, "shm");
+	spdk_json_write_named_string(w, "export_name", sbdev->export_name);
+	spdk_json_write_named_uint32(w, "num_queues", sbdev->region->num_queues);
+	spdk_json_write_named_uint32(w, "queue_depth", sbdev->region->queue_depth);
+	spdk_json_write_named_uint32(w, "io_size", sbdev->region->io_size);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+static void
+bdev_shm_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	struct shm_bdev *sbdev = bdev->ctxt;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "bdev_shm_create");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "name", bdev->name);
+	spdk_json_write_named_string(w, "export_name", sbdev->export_name);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
+static const struct spdk_bdev_fn_table shm_fn_table = {
+	.destruct		= bdev_shm_destruct,
+	.submit_request		= bdev_shm_submit_request,
+	.io_type_supported	= bdev_shm_io_type_supported,
+	.get_io_channel		= bdev_shm_get_io_channel,
+	.dump_info_json		= bdev_shm_dump_info_json,
+	.write_config_json	= bdev_shm_write_config_json,
+};
+
+int
+bdev_shm_create(const char *name, const char *export_name, struct spdk_bdev **bdev)
+{
+	struct bdev_shm_region *region;
+	struct shm_bdev *sbdev;
+	int rc;
+
+	region = shm_region_lookup(export_name);
+	if (region == NULL) {
+		SPDK_ERRLOG("Export %s not found\n", export_name);
+		return -ENODEV;
+	}
+
+	if (!shm_region_ready(region)) {
+		SPDK_ERRLOG("Export %s isn't ready\n", export_name);
+		return -ENODEV;
+	}
+
+	sbdev = calloc(1, sizeof(*sbdev));
+	if (sbdev == NULL) {
+		return -ENOMEM;
+	}
+
+	sbdev->region = region;
+	sbdev->export_name = strdup(export_name);
+	sbdev->bdev.name = strdup(name);
+	if (sbdev->export_name == NULL || sbdev->bdev.name == NULL) {
+		shm_bdev_free(sbdev);
+		return -ENOMEM;
+	}
+
+	sbdev->bdev.product_name = "Shared memory disk";
+	sbdev->bdev.write_cache = 0;
+	sbdev->bdev.blocklen = region->block_size;
+	sbdev->bdev.blockcnt = region->num_blocks;
+	/* Each read and write has to fit in a slot buffer */
+	sbdev->bdev.optimal_io_boundary = region->io_size / region->block_size;
+	sbdev->bdev.split_on_optimal_io_boundary = true;
+	sbdev->bdev.ctxt = sbdev;
+	sbdev->bdev.fn_table = &shm_fn_table;
+	sbdev->bdev.module = &shm_if;
+
+	spdk_io_device_register(sbdev, shm_bdev_create_cb, shm_bdev_destroy_cb,
+				sizeof(struct shm_io_channel), sbdev->bdev.name);
+
+	rc = spdk_bdev_register(&sbdev->bdev);
+	if (rc != 0) {
+		spdk_io_device_unregister(sbdev, shm_bdev_free);
+		return rc;
+	}
+
+	TAILQ_INSERT_TAIL(&g_shm_bdevs, sbdev, link);
+	*bdev = &sbdev->bdev;
+
+	return 0;
+}
+
+void
+bdev_shm_delete(const char *name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	int rc;
+
+	rc = spdk_bdev_unregister_by_name(name, &shm_if, cb_fn, cb_arg);
+	if (rc != 0) {
+		cb_fn(cb_arg, rc);
+	}
+}
+
+static int
+bdev_shm_initialize(void)
+{
+	return 0;
+}
+
+static void
+bdev_shm_finish(void)
+{
+	bdev_shm_export_fini();
+}
+
+static int
+bdev_shm_config_json(struct spdk_json_write_ctx *w)
+{
+	bdev_shm_export_write_config_json(w);
+
+	return 0;
+}
+
+static void
+bdev_shm_examine(struct spdk_bdev *bdev)
+{
+	bdev_shm_export_examine(bdev);
+	spdk_bdev_module_examine_done(&shm_if);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(bdev_shm)
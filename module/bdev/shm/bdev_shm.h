@@ -0,0 +1,197 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_BDEV_SHM_H
+#define SPDK_BDEV_SHM_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+
+/*
+ * Shared memory transport between the bdev layers of two SPDK processes on the same host.
+ *
+ * A process exports one of its bdevs as a memzone named BDEV_SHM_MEMZONE_PREFIX<export name>,
+ * holding a header, then one queue pair per consumer channel.  Each queue pair has a submission
+ * and a completion ring of slot indices, one command per slot and one data buffer per slot.  Both
+ * rings are single producer, single consumer: the consumer channel owning the queue pair pushes
+ * submissions and pops completions, the exporter's poller does the opposite.  A queue pair has as
+ * many slots as ring entries, so neither ring can overflow.
+ *
+ * The consumer process imports the export as a bdev of its own.  Data is moved through the slot
+ * buffers, which the exporter passes to its bdev as is.  With ZCOPY, the consumer's user reads and
+ * writes the slot buffers directly, so the data isn't copied at all.
+ *
+ * The memzone is only visible to processes sharing the same DPDK memory, i.e. both applications
+ * must be started with the same shared memory id (-i).
+ */
+
+#define BDEV_SHM_MEMZONE_PREFIX		"bdev_shm_"
+#define BDEV_SHM_MAX_NAME_LEN		\
+	(SPDK_MAX_MEMZONE_NAME_LEN - sizeof(BDEV_SHM_MEMZONE_PREFIX))
+
+#define BDEV_SHM_MAGIC			0x4d48534b44505300ULL
+#define BDEV_SHM_VERSION		1
+
+#define BDEV_SHM_DEFAULT_NUM_QUEUES	4
+#define BDEV_SHM_MAX_NUM_QUEUES		64
+#define BDEV_SHM_DEFAULT_QUEUE_DEPTH	64
+#define BDEV_SHM_MAX_QUEUE_DEPTH	1024
+#define BDEV_SHM_DEFAULT_IO_SIZE	(128 * 1024)
+#define BDEV_SHM_MAX_IO_SIZE		(1024 * 1024)
+#define BDEV_SHM_BUF_ALIGN		4096
+
+enum bdev_shm_state {
+	BDEV_SHM_STATE_INIT = 0,
+	BDEV_SHM_STATE_READY,
+	/* The exported bdev was removed, all commands fail with -ENODEV */
+	BDEV_SHM_STATE_REMOVED,
+};
+
+enum bdev_shm_opc {
+	BDEV_SHM_OPC_READ = 0,
+	BDEV_SHM_OPC_WRITE,
+	BDEV_SHM_OPC_FLUSH,
+	BDEV_SHM_OPC_UNMAP,
+	BDEV_SHM_OPC_WRITE_ZEROES,
+};
+
+struct bdev_shm_cmd {
+	uint8_t		opc;
+	uint8_t		reserved[3];
+	/* Set by the exporter before completing the command, 0 or a negative errno */
+	int32_t		status;
+	uint64_t	offset_blocks;
+	uint64_t	num_blocks;
+};
+
+struct bdev_shm_ring {
+	/* Written by the producer only */
+	uint32_t	head __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
+	/* Written by the consumer only */
+	uint32_t	tail __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
+	/* Offset of the ring's entries from the start of the region */
+	uint64_t	entries_offset;
+};
+
+struct bdev_shm_queue {
+	struct bdev_shm_ring	sq;
+	struct bdev_shm_ring	cq;
+	/* Set by the consumer channel using the queue pair */
+	uint32_t		claimed __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
+	/* Offsets of the commands and data buffers of the slots from the start of the region */
+	uint64_t		cmds_offset;
+	uint64_t		data_offset;
+};
+
+struct bdev_shm_region {
+	uint64_t		magic;
+	uint32_t		version;
+	/* enum bdev_shm_state */
+	uint32_t		state;
+	uint64_t		size;
+	uint64_t		num_blocks;
+	uint32_t		block_size;
+	uint32_t		num_queues;
+	uint32_t		queue_depth;
+	uint32_t		io_size;
+	/* Bit mask of the enum bdev_shm_opc supported by the exported bdev */
+	uint32_t		opc_mask;
+	uint32_t		reserved;
+	struct bdev_shm_queue	queues[];
+};
+
+static inline struct bdev_shm_cmd *
+bdev_shm_get_cmd(struct bdev_shm_region *region, struct bdev_shm_queue *queue, uint32_t slot)
+{
+	return (struct bdev_shm_cmd *)((uint8_t *)region + queue->cmds_offset) + slot;
+}
+
+static inline void *
+bdev_shm_get_buf(struct bdev_shm_region *region, struct bdev_shm_queue *queue, uint32_t slot)
+{
+	return (uint8_t *)region + queue->data_offset + (uint64_t)slot * region->io_size;
+}
+
+/* Publish a slot to the other side.  The command must be written before. */
+static inline void
+bdev_shm_ring_push(struct bdev_shm_region *region, struct bdev_shm_ring *ring, uint32_t slot)
+{
+	uint32_t *entries = (uint32_t *)((uint8_t *)region + ring->entries_offset);
+	uint32_t head = ring->head;
+
+	entries[head & (region->queue_depth - 1)] = slot;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static inline bool
+bdev_shm_ring_pop(struct bdev_shm_region *region, struct bdev_shm_ring *ring, uint32_t *slot)
+{
+	uint32_t *entries = (uint32_t *)((uint8_t *)region + ring->entries_offset);
+	uint32_t tail = ring->tail;
+
+	if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+		return false;
+	}
+
+	*slot = entries[tail & (region->queue_depth - 1)];
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+struct bdev_shm_export_opts {
+	/* Name of the export, the consumers import it by this name */
+	const char	*name;
+	const char	*bdev_name;
+	uint32_t	num_queues;
+	uint32_t	queue_depth;
+	uint32_t	io_size;
+};
+
+/**
+ * Export a bdev through shared memory.  If the bdev doesn't exist yet, it's exported once it's
+ * registered.
+ *
+ * \param opts Options of the export.  Zeroed counts and sizes are replaced by their defaults.
+ * \return 0 on success, negative errno on failure.
+ */
+int bdev_shm_export(const struct bdev_shm_export_opts *opts);
+
+/**
+ * Stop exporting a bdev and free its shared memory.
+ *
+ * \param name Name of the export.
+ * \return 0 on success, -ENOENT if there is no such export, -EBUSY if a consumer is still
+ * attached to it.
+ */
+int bdev_shm_unexport(const char *name);
+
+/**
+ * Create a bdev from a bdev exported by another process.
+ *
+ * \param name Name of the bdev to create.
+ * \param export_name Name of the export.
+ * \param bdev Created bdev.
+ * \return 0 on success, negative errno on failure.
+ */
+int bdev_shm_create(const char *name, const char *export_name, struct spdk_bdev **bdev);
+
+/**
+ * Delete a bdev created by bdev_shm_create().
+ *
+ * \param name Name of the bdev.
+ * \param cb_fn Function to call after deletion.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_shm_delete(const char *name, spdk_bdev_unregister_cb cb_fn, void *cb_arg);
+
+/* Internal functions shared by the exporter and the consumer sides of the module */
+void bdev_shm_export_examine(struct spdk_bdev *bdev);
+void bdev_shm_export_write_config_json(struct spdk_json_write_ctx *w);
+void bdev_shm_export_fini(void);
+
+#endif /* SPDK_BDEV_SHM_H */
@@ -0,0 +1,542 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "bdev_shm.h"
+
+#include "spdk/env.h"
+#include "spdk/json.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+struct shm_export;
+
+struct shm_export_io {
+	struct shm_export		*exp;
+	struct bdev_shm_queue		*queue;
+	uint32_t			slot;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+};
+
+struct shm_export {
+	char				*name;
+	char				*bdev_name;
+	uint32_t			num_queues;
+	uint32_t			queue_depth;
+	uint32_t			io_size;
+
+	/* Set once the bdev is exported */
+	struct bdev_shm_region		*region;
+	struct spdk_bdev_desc		*desc;
+	struct spdk_io_channel		*ch;
+	struct spdk_poller		*poller;
+	struct shm_export_io		*ios;
+	uint32_t			outstanding;
+	bool				removed;
+
+	TAILQ_ENTRY(shm_export)		link;
+};
+
+static TAILQ_HEAD(, shm_export) g_shm_exports = TAILQ_HEAD_INITIALIZER(g_shm_exports);
+
+static void
+shm_export_memzone_name(const char *name, char *buf, size_t size)
+{
+	snprintf(buf, size, "%s%s", BDEV_SHM_MEMZONE_PREFIX, name);
+}
+
+static struct shm_export *
+shm_export_find(const char *name)
+{
+	struct shm_export *exp;
+
+	TAILQ_FOREACH(exp, &g_shm_exports, link) {
+		if (strcmp(exp->name, name) == 0) {
+			return exp;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+shm_export_complete(struct shm_export *exp, struct bdev_shm_queue *queue, uint32_t slot,
+		    int status)
+{
+	bdev_shm_get_cmd(exp->region, queue, slot)->status = status;
+	bdev_shm_ring_push(exp->region, &queue->cq, slot);
+}
+
+static void
+shm_export_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct shm_export_io *io = cb_arg;
+	struct shm_export *exp = io->exp;
+
+	spdk_bdev_free_io(bdev_io);
+
+	exp->outstanding--;
+	shm_export_complete(exp, io->queue, io->slot, success ? 0 : -EIO);
+}
+
+static int
+shm_export_submit(struct shm_export_io *io)
+{
+	struct shm_export *exp = io->exp;
+	struct bdev_shm_cmd *cmd = bdev_shm_get_cmd(exp->region, io->queue, io->slot);
+	uint64_t len = cmd->num_blocks * exp->region->block_size;
+	void *buf = bdev_shm_get_buf(exp->region, io->queue, io->slot);
+
+	switch (cmd->opc) {
+	case BDEV_SHM_OPC_READ:
+		if (len > exp->io_size) {
+			return -EINVAL;
+		}
+		return spdk_bdev_read_blocks(exp->desc, exp->ch, buf, cmd->offset_blocks,
+					     cmd->num_blocks, shm_export_io_done, io);
+	case BDEV_SHM_OPC_WRITE:
+		if (len > exp->io_size) {
+			return -EINVAL;
+		}
+		return spdk_bdev_write_blocks(exp->desc, exp->ch, buf, cmd->offset_blocks,
+					      cmd->num_blocks, shm_export_io_done, io);
+	case BDEV_SHM_OPC_FLUSH:
+		return spdk_bdev_flush_blocks(exp->desc, exp->ch, cmd->offset_blocks,
+					      cmd->num_blocks, shm_export_io_done, io);
+	case BDEV_SHM_OPC_UNMAP:
+		return spdk_bdev_unmap_blocks(exp->desc, exp->ch, cmd->offset_blocks,
+					      cmd->num_blocks, shm_export_io_done, io);
+	case BDEV_SHM_OPC_WRITE_ZEROES:
+		return spdk_bdev_write_zeroes_blocks(exp->desc, exp->ch, cmd->offset_blocks,
+						     cmd->num_blocks, shm_export_io_done, io);
+	default:
+		return -EINVAL;
+	}
+}
+
+static void
+shm_export_resubmit(void *arg)
+{
+	struct shm_export_io *io = arg;
+	struct shm_export *exp = io->exp;
+	int rc;
+
+	rc = shm_export_submit(io);
+	if (rc == -ENOMEM) {
+		spdk_bdev_queue_io_wait(spdk_bdev_desc_get_bdev(exp->desc), exp->ch,
+					&io->bdev_io_wait);
+	} else if (rc != 0) {
+		exp->outstanding--;
+		shm_export_complete(exp, io->queue, io->slot, rc);
+	}
+}
+
+static void
+shm_export_process(struct shm_export *exp, uint32_t qid, uint32_t slot)
+{
+	struct bdev_shm_queue *queue = &exp->region->queues[qid];
+	struct shm_export_io *io;
+	int rc;
+
+	if (slot >= exp->queue_depth) {
+		SPDK_ERRLOG("%s: invalid slot %u submitted on queue %u\n", exp->name, slot, qid);
+		return;
+	}
+
+	if (exp->removed) {
+		shm_export_complete(exp, queue, slot, -ENODEV);
+		return;
+	}
+
+	io = &exp->ios[qid * exp->queue_depth + slot];
+	exp->outstanding++;
+
+	rc = shm_export_submit(io);
+	if (rc == -ENOMEM) {
+		spdk_bdev_queue_io_wait(spdk_bdev_desc_get_bdev(exp->desc), exp->ch,
+					&io->bdev_io_wait);
+	} else if (rc != 0) {
+		exp->outstanding--;
+		shm_export_complete(exp, queue, slot, rc);
+	}
+}
+
+static void
+shm_export_close_bdev(struct shm_export *exp)
+{
+	if (exp->ch != NULL) {
+		spdk_put_io_channel(exp->ch);
+		exp->ch = NULL;
+	}
+
+	if (exp->desc != NULL) {
+		spdk_bdev_close(exp->desc);
+		exp->desc = NULL;
+	}
+}
+
+static int
+shm_export_poll(void *arg)
+{
+	struct shm_export *exp = arg;
+	struct bdev_shm_region *region = exp->region;
+	uint32_t qid, slot;
+	int count = 0;
+
+	for (qid = 0; qid < exp->num_queues; qid++) {
+		while (bdev_shm_ring_pop(region, &region->queues[qid].sq, &slot)) {
+			shm_export_process(exp, qid, slot);
+			count++;
+		}
+	}
+
+	/* Release the removed bdev once the I/Os submitted to it are done */
+	if (exp->removed && exp->outstanding == 0 && exp->desc != NULL) {
+		shm_export_close_bdev(exp);
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+shm_export_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void *event_ctx)
+{
+	struct shm_export *exp = event_ctx;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		SPDK_NOTICELOG("%s: exported bdev %s removed\n", exp->name, exp->bdev_name);
+		exp->removed = true;
+		__atomic_store_n(&exp->region->state, BDEV_SHM_STATE_REMOVED, __ATOMIC_RELEASE);
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+static uint32_t
+shm_export_opc_mask(struct spdk_bdev *bdev)
+{
+	uint32_t mask = (1U << BDEV_SHM_OPC_READ) | (1U << BDEV_SHM_OPC_WRITE);
+
+	if (spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_FLUSH)) {
+		mask |= 1U << BDEV_SHM_OPC_FLUSH;
+	}
+	if (spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_UNMAP)) {
+		mask |= 1U << BDEV_SHM_OPC_UNMAP;
+	}
+	if (spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_WRITE_ZEROES)) {
+		mask |= 1U << BDEV_SHM_OPC_WRITE_ZEROES;
+	}
+
+	return mask;
+}
+
+/* Lay out the queue pairs after the header: rings, commands, then the page aligned data */
+static uint64_t
+shm_export_layout(struct shm_export *exp, struct bdev_shm_region *region)
+{
+	uint64_t offset, rings_size, cmds_size;
+	uint32_t qid;
+
+	rings_size = SPDK_ALIGN_CEIL((uint64_t)exp->queue_depth * sizeof(uint32_t),
+				     SPDK_CACHE_LINE_SIZE);
+	cmds_size = SPDK_ALIGN_CEIL((uint64_t)exp->queue_depth * sizeof(struct bdev_shm_cmd),
+				    SPDK_CACHE_LINE_SIZE);
+
+	offset = sizeof(*region) + exp->num_queues * sizeof(struct bdev_shm_queue);
+	for (qid = 0; qid < exp->num_queues; qid++) {
+		offset = SPDK_ALIGN_CEIL(offset, SPDK_CACHE_LINE_SIZE);
+		if (region != NULL) {
+			region->queues[qid].sq.entries_offset = offset;
+			region->queues[qid].cq.entries_offset = offset + rings_size;
+			region->queues[qid].cmds_offset = offset + 2 * rings_size;
+		}
+		offset += 2 * rings_size + cmds_size;
+	}
+
+	for (qid = 0; qid < exp->num_queues; qid++) {
+		offset = SPDK_ALIGN_CEIL(offset, BDEV_SHM_BUF_ALIGN);
+		if (region != NULL) {
+			region->queues[qid].data_offset = offset;
+		}
+		offset += (uint64_t)exp->queue_depth * exp->io_size;
+	}
+
+	return offset;
+}
+
+static int
+shm_export_start(struct shm_export *exp)
+{
+	char mz_name[SPDK_MAX_MEMZONE_NAME_LEN];
+	struct bdev_shm_region *region;
+	struct spdk_bdev *bdev;
+	uint64_t size;
+	uint32_t i;
+	int rc;
+
+	rc = spdk_bdev_open_ext(exp->bdev_name, true, shm_export_event_cb, exp, &exp->desc);
+	if (rc != 0) {
+		return rc;
+	}
+
+	bdev = spdk_bdev_desc_get_bdev(exp->desc);
+	if (spdk_bdev_get_md_size(bdev) != 0) {
+		SPDK_ERRLOG("%s: bdev %s with metadata can't be exported\n", exp->name,
+			    exp->bdev_name);
+		rc = -ENOTSUP;
+		goto err;
+	}
+
+	if (exp->io_size % spdk_bdev_get_block_size(bdev) != 0) {
+		SPDK_ERRLOG("%s: I/O size %u is not a multiple of the block size of %s\n",
+			    exp->name, exp->io_size, exp->bdev_name);
+		rc = -EINVAL;
+		goto err;
+	}
+
+	exp->ios = calloc((size_t)exp->num_queues * exp->queue_depth, sizeof(*exp->ios));
+	if (exp->ios == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	size = shm_export_layout(exp, NULL);
+	shm_export_memzone_name(exp->name, mz_name, sizeof(mz_name));
+	region = spdk_memzone_reserve_aligned(mz_name, size, SPDK_ENV_SOCKET_ID_ANY,
+					      SPDK_MEMZONE_NO_IOVA_CONTIG, BDEV_SHM_BUF_ALIGN);
+	if (region == NULL) {
+		SPDK_ERRLOG("%s: failed to reserve %" PRIu64 " bytes of shared memory\n", exp->name,
+			    size);
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	memset(region, 0, sizeof(*region) + exp->num_queues * sizeof(struct bdev_shm_queue));
+	region->magic = BDEV_SHM_MAGIC;
+	region->version = BDEV_SHM_VERSION;
+	region->size = size;
+	region->num_blocks = spdk_bdev_get_num_blocks(bdev);
+	region->block_size = spdk_bdev_get_block_size(bdev);
+	region->num_queues = exp->num_queues;
+	region->queue_depth = exp->queue_depth;
+	region->io_size = exp->io_size;
+	region->opc_mask = shm_export_opc_mask(bdev);
+	shm_export_layout(exp, region);
+	exp->region = region;
+
+	for (i = 0; i < exp->num_queues * exp->queue_depth; i++) {
+		exp->ios[i].exp = exp;
+		exp->ios[i].queue = &region->queues[i / exp->queue_depth];
+		exp->ios[i].slot = i % exp->queue_depth;
+		exp->ios[i].bdev_io_wait.bdev = bdev;
+		exp->ios[i].bdev_io_wait.cb_fn = shm_export_resubmit;
+		exp->ios[i].bdev_io_wait.cb_arg = &exp->ios[i];
+	}
+
+	exp->ch = spdk_bdev_get_io_channel(exp->desc);
+	if (exp->ch == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	exp->poller = SPDK_POLLER_REGISTER(shm_export_poll, exp, 0);
+	if (exp->poller == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	/* Make the layout visible before the consumers can see the export as ready */
+	__atomic_store_n(&region->state, BDEV_SHM_STATE_READY, __ATOMIC_RELEASE);
+
+	SPDK_NOTICELOG("Exported bdev %s as %s: %u queues of %u slots of %u bytes\n",
+		       exp->bdev_name, exp->name, exp->num_queues, exp->queue_depth, exp->io_size);
+
+	return 0;
+
+err:
+	shm_export_close_bdev(exp);
+	if (exp->region != NULL) {
+		spdk_memzone_free(mz_name);
+		exp->region = NULL;
+	}
+	free(exp->ios);
+	exp->ios = NULL;
+
+	return rc;
+}
+
+static void
+shm_export_stop(struct shm_export *exp)
+{
+	char mz_name[SPDK_MAX_MEMZONE_NAME_LEN];
+
+	if (exp->region == NULL) {
+		return;
+	}
+
+	spdk_poller_unregister(&exp->poller);
+	shm_export_close_bdev(exp);
+
+	shm_export_memzone_name(exp->name, mz_name, sizeof(mz_name));
+	spdk_memzone_free(mz_name);
+	exp->region = NULL;
+
+	free(exp->ios);
+	exp->ios = NULL;
+}
+
+static void
+shm_export_free(struct shm_export *exp)
+{
+	free(exp->name);
+	free(exp->bdev_name);
+	free(exp);
+}
+
+void
+bdev_shm_export_examine(struct spdk_bdev *bdev)
+{
+	struct shm_export *exp;
+	int rc;
+
+	TAILQ_FOREACH(exp, &g_shm_exports, link) {
+		if (exp->region != NULL || strcmp(exp->bdev_name, spdk_bdev_get_name(bdev)) != 0) {
+			continue;
+		}
+
+		rc = shm_export_start(exp);
+		if (rc != 0) {
+			SPDK_ERRLOG("%s: failed to export bdev %s: %s\n", exp->name, exp->bdev_name,
+				    spdk_strerror(-rc));
+		}
+	}
+}
+
+int
+bdev_shm_export(const struct bdev_shm_export_opts *opts)
+{
+	struct shm_export *exp;
+	int rc;
+
+	if (opts->name == NULL || opts->bdev_name == NULL) {
+		return -EINVAL;
+	}
+
+	if (strlen(opts->name) == 0 || strlen(opts->name) > BDEV_SHM_MAX_NAME_LEN) {
+		SPDK_ERRLOG("Export name must be 1 to %zu characters long\n",
+			    BDEV_SHM_MAX_NAME_LEN);
+		return -EINVAL;
+	}
+
+	if (shm_export_find(opts->name) != NULL) {
+		SPDK_ERRLOG("Export %s already exists\n", opts->name);
+		return -EEXIST;
+	}
+
+	exp = calloc(1, sizeof(*exp));
+	if (exp == NULL) {
+		return -ENOMEM;
+	}
+
+	exp->num_queues = opts->num_queues ? opts->num_queues : BDEV_SHM_DEFAULT_NUM_QUEUES;
+	exp->queue_depth = opts->queue_depth ? opts->queue_depth : BDEV_SHM_DEFAULT_QUEUE_DEPTH;
+	exp->io_size = opts->io_size ? opts->io_size : BDEV_SHM_DEFAULT_IO_SIZE;
+
+	if (exp->num_queues > BDEV_SHM_MAX_NUM_QUEUES ||
+	    exp->queue_depth > BDEV_SHM_MAX_QUEUE_DEPTH || !spdk_u32_is_pow2(exp->queue_depth) ||
+	    exp->io_size > BDEV_SHM_MAX_IO_SIZE || exp->io_size % BDEV_SHM_BUF_ALIGN != 0) {
+		SPDK_ERRLOG("Invalid export options: at most %u queues, a power of two depth "
+			    "up to %u and a multiple of %u bytes up to %u bytes for the I/O size\n",
+			    BDEV_SHM_MAX_NUM_QUEUES, BDEV_SHM_MAX_QUEUE_DEPTH, BDEV_SHM_BUF_ALIGN,
+			    BDEV_SHM_MAX_IO_SIZE);
+		free(exp);
+		return -EINVAL;
+	}
+
+	exp->name = strdup(opts->name);
+	exp->bdev_name = strdup(opts->bdev_name);
+	if (exp->name == NULL || exp->bdev_name == NULL) {
+		shm_export_free(exp);
+		return -ENOMEM;
+	}
+
+	rc = shm_export_start(exp);
+	if (rc == -ENODEV) {
+		/* The bdev may still show up, it's exported when it's examined */
+		SPDK_NOTICELOG("%s: export deferred pending bdev %s arrival\n", exp->name,
+			       exp->bdev_name);
+		rc = 0;
+	} else if (rc != 0) {
+		shm_export_free(exp);
+		return rc;
+	}
+
+	TAILQ_INSERT_TAIL(&g_shm_exports, exp, link);
+
+	return 0;
+}
+
+int
+bdev_shm_unexport(const char *name)
+{
+	struct shm_export *exp;
+	uint32_t qid;
+
+	exp = shm_export_find(name);
+	if (exp == NULL) {
+		return -ENOENT;
+	}
+
+	/* The consumers map the memzone, it can't go away under them */
+	for (qid = 0; exp->region != NULL && qid < exp->num_queues; qid++) {
+		if (__atomic_load_n(&exp->region->queues[qid].claimed, __ATOMIC_ACQUIRE)) {
+			SPDK_ERRLOG("%s: queue %u is still in use by a consumer\n", name, qid);
+			return -EBUSY;
+		}
+	}
+
+	TAILQ_REMOVE(&g_shm_exports, exp, link);
+	shm_export_stop(exp);
+	shm_export_free(exp);
+
+	return 0;
+}
+
+void
+bdev_shm_export_write_config_json(struct spdk_json_write_ctx *w)
+{
+	struct shm_export *exp;
+
+	TAILQ_FOREACH(exp, &g_shm_exports, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_shm_export");
+
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "name", exp->name);
+		spdk_json_write_named_string(w, "bdev_name", exp->bdev_name);
+		spdk_json_write_named_uint32(w, "num_queues", exp->num_queues);
+		spdk_json_write_named_uint32(w, "queue_depth", exp->queue_depth);
+		spdk_json_write_named_uint32(w, "io_size", exp->io_size);
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+}
+
+void
+bdev_shm_export_fini(void)
+{
+	struct shm_export *exp;
+
+	while ((exp = TAILQ_FIRST(&g_shm_exports)) != NULL) {
+		TAILQ_REMOVE(&g_shm_exports, exp, link);
+		shm_export_stop(exp);
+		shm_export_free(exp);
+	}
+}
@@ -0,0 +1,208 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "bdev_shm.h"
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/string.h"
+#include "spdk/log.h"
+
+struct rpc_bdev_shm_export {
+	char *name;
+	char *bdev_name;
+	uint32_t num_queues;
+	uint32_t queue_depth;
+	uint32_t io_size;
+};
+
+static void
+free_rpc_bdev_shm_export(struct rpc_bdev_shm_export *r)
+{
+	free(r->name);
+	free(r->bdev_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_shm_export_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_shm_export, name), spdk_json_decode_string},
+	{"bdev_name", offsetof(struct rpc_bdev_shm_export, bdev_name), spdk_json_decode_string},
+	{"num_queues", offsetof(struct rpc_bdev_shm_export, num_queues), spdk_json_decode_uint32, true},
+	{"queue_depth", offsetof(struct rpc_bdev_shm_export, queue_depth), spdk_json_decode_uint32, true},
+	{"io_size", offsetof(struct rpc_bdev_shm_export, io_size), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_bdev_shm_export(struct spdk_jsonrpc_request *request,
+		    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_shm_export req = {NULL};
+	struct bdev_shm_export_opts opts = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_shm_export_decoders,
+				    SPDK_COUNTOF(rpc_bdev_shm_export_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(bdev_shm, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	opts.name = req.name;
+	opts.bdev_name = req.bdev_name;
+	opts.num_queues = req.num_queues;
+	opts.queue_depth = req.queue_depth;
+	opts.io_size = req.io_size;
+
+	rc = bdev_shm_export(&opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_bdev_shm_export(&req);
+}
+SPDK_RPC_REGISTER("bdev_shm_export", rpc_bdev_shm_export, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_shm_unexport {
+	char *name;
+};
+
+static void
+free_rpc_bdev_shm_unexport(struct rpc_bdev_shm_unexport *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_shm_unexport_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_shm_unexport, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_shm_unexport(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_shm_unexport req = {NULL};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_shm_unexport_decoders,
+				    SPDK_COUNTOF(rpc_bdev_shm_unexport_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_shm_unexport(req.name);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_bdev_shm_unexport(&req);
+}
+SPDK_RPC_REGISTER("bdev_shm_unexport", rpc_bdev_shm_unexport, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_shm_create {
+	char *name;
+	char *export_name;
+};
+
+static void
+free_rpc_bdev_shm_create(struct rpc_bdev_shm_create *r)
+{
+	free(r->name);
+	free(r->export_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_shm_create_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_shm_create, name), spdk_json_decode_string},
+	{"export_name", offsetof(struct rpc_bdev_shm_create, export_name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_shm_create(struct spdk_jsonrpc_request *request,
+		    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_shm_create req = {NULL};
+	struct spdk_json_write_ctx *w;
+	struct spdk_bdev *bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_shm_create_decoders,
+				    SPDK_COUNTOF(rpc_bdev_shm_create_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(bdev_shm, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_shm_create(req.name, req.export_name, &bdev);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_string(w, spdk_bdev_get_name(bdev));
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_shm_create(&req);
+}
+SPDK_RPC_REGISTER("bdev_shm_create", rpc_bdev_shm_create, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_shm_delete {
+	char *name;
+};
+
+static void
+free_rpc_bdev_shm_delete(struct rpc_bdev_shm_delete *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_shm_delete_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_shm_delete, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_shm_delete_cb(void *cb_arg, int bdeverrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (bdeverrno == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, bdeverrno, spdk_strerror(-bdeverrno));
+	}
+}
+
+static void
+rpc_bdev_shm_delete(struct spdk_jsonrpc_request *request,
+		    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_shm_delete req = {NULL};
+
+	if (spdk_json_decode_object(params, rpc_bdev_shm_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_shm_delete_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev_shm_delete(req.name, rpc_bdev_shm_delete_cb, request);
+
+cleanup:
+	free_rpc_bdev_shm_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_shm_delete", rpc_bdev_shm_delete, SPDK_RPC_RUNTIME)
@@ -31,8 +31,17 @@ struct bdev_uring_zoned_dev {
 	uint32_t		lba_shift;
 };
 
+#define SPDK_URING_QUEUE_DEPTH 512
+#define MAX_EVENTS_PER_POLL 32
+#define SPDK_URING_FIXED_FILES 64
+#define SPDK_URING_MAX_FIXED_BUFS 16
+/* The kernel limits the size of a single fixed buffer to 1GiB */
+#define SPDK_URING_FIXED_BUF_MAX_LEN (1ULL << 30)
+
 struct bdev_uring_io_channel {
 	struct bdev_uring_group_channel		*group_ch;
+	/* Index in the registered file table of the ring, -1 if the file is not registered */
+	int					file_index;
 };
 
 struct bdev_uring_group_channel {
@@ -40,6 +49,10 @@ struct bdev_uring_group_channel {
 	uint64_t				io_pending;
 	struct spdk_poller			*poller;
 	struct io_uring				uring;
+	bool					files_registered;
+	int					files[SPDK_URING_FIXED_FILES];
+	int					num_fixed_bufs;
+	struct iovec				fixed_bufs[SPDK_URING_MAX_FIXED_BUFS];
 };
 
 struct bdev_uring_task {
@@ -59,10 +72,15 @@ struct bdev_uring {
 static int bdev_uring_init(void);
 static void bdev_uring_fini(void);
 static void uring_free_bdev(struct bdev_uring *uring);
+static int bdev_uring_config_json(struct spdk_json_write_ctx *w);
 static TAILQ_HEAD(, bdev_uring) g_uring_bdev_head = TAILQ_HEAD_INITIALIZER(g_uring_bdev_head);
 
-#define SPDK_URING_QUEUE_DEPTH 512
-#define MAX_EVENTS_PER_POLL 32
+static struct bdev_uring_opts g_opts = {
+	.sqpoll = false,
+	.sqpoll_idle_ms = 1000,
+	.fixed_files = true,
+	.fixed_buffers = true,
+};
 
 static int
 bdev_uring_get_ctx_size(void)
@@ -74,6 +92,7 @@ static struct spdk_bdev_module uring_if = {
 	.name		= "uring",
 	.module_init	= bdev_uring_init,
 	.module_fini	= bdev_uring_fini,
+	.config_json	= bdev_uring_config_json,
 	.get_ctx_size	= bdev_uring_get_ctx_size,
 };
 
@@ -122,6 +141,77 @@ bdev_uring_close(struct bdev_uring *bdev)
 	return 0;
 }
 
+void
+bdev_uring_get_opts(struct bdev_uring_opts *opts)
+{
+	*opts = g_opts;
+}
+
+int
+bdev_uring_set_opts(const struct bdev_uring_opts *opts)
+{
+	if (opts->sqpoll && opts->sqpoll_idle_ms == 0) {
+		SPDK_ERRLOG("sqpoll_idle_ms must be greater than 0\n");
+		return -EINVAL;
+	}
+
+	g_opts = *opts;
+
+	return 0;
+}
+
+static int
+bdev_uring_get_fixed_buf_index(struct bdev_uring_group_channel *group_ch, struct iovec *iov)
+{
+	uintptr_t base, start = (uintptr_t)iov->iov_base;
+	int i;
+
+	for (i = 0; i < group_ch->num_fixed_bufs; i++) {
+		base = (uintptr_t)group_ch->fixed_bufs[i].iov_base;
+		if (start >= base && start + iov->iov_len <= base + group_ch->fixed_bufs[i].iov_len) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static void
+bdev_uring_prep_rw(struct bdev_uring *uring, struct bdev_uring_io_channel *uring_ch,
+		   struct io_uring_sqe *sqe, bool write, struct iovec *iov, int iovcnt,
+		   uint64_t offset)
+{
+	int fd = uring->fd, buf_index = -1;
+
+	if (uring_ch->file_index >= 0) {
+		fd = uring_ch->file_index;
+	}
+
+	/* Data in the iobuf pools can use the fixed buffers registered with the ring, which
+	 * saves the kernel from mapping the pages on each I/O. */
+	if (iovcnt == 1) {
+		buf_index = bdev_uring_get_fixed_buf_index(uring_ch->group_ch, iov);
+	}
+
+	if (buf_index >= 0) {
+		if (write) {
+			io_uring_prep_write_fixed(sqe, fd, iov->iov_base, iov->iov_len, offset, buf_index);
+		} else {
+			io_uring_prep_read_fixed(sqe, fd, iov->iov_base, iov->iov_len, offset, buf_index);
+		}
+	} else {
+		if (write) {
+			io_uring_prep_writev(sqe, fd, iov, iovcnt, offset);
+		} else {
+			io_uring_prep_readv(sqe, fd, iov, iovcnt, offset);
+		}
+	}
+
+	if (uring_ch->file_index >= 0) {
+		io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+	}
+}
+
 static int64_t
 bdev_uring_readv(struct bdev_uring *uring, struct spdk_io_channel *ch,
 		 struct bdev_uring_task *uring_task,
@@ -137,7 +227,7 @@ bdev_uring_readv(struct bdev_uring *uring, struct spdk_io_channel *ch,
 		return -ENOMEM;
 	}
 
-	io_uring_prep_readv(sqe, uring->fd, iov, iovcnt, offset);
+	bdev_uring_prep_rw(uring, uring_ch, sqe, false, iov, iovcnt, offset);
 	io_uring_sqe_set_data(sqe, uring_task);
 	uring_task->len = nbytes;
 	uring_task->ch = uring_ch;
@@ -164,7 +254,7 @@ bdev_uring_writev(struct bdev_uring *uring, struct spdk_io_channel *ch,
 		return -ENOMEM;
 	}
 
-	io_uring_prep_writev(sqe, uring->fd, iov, iovcnt, offset);
+	bdev_uring_prep_rw(uring, uring_ch, sqe, true, iov, iovcnt, offset);
 	io_uring_sqe_set_data(sqe, uring_task);
 	uring_task->len = nbytes;
 	uring_task->ch = uring_ch;
@@ -228,26 +318,38 @@ bdev_uring_reap(struct io_uring *ring, int max)
 }
 
 static int
-bdev_uring_group_poll(void *arg)
+bdev_uring_group_submit(struct bdev_uring_group_channel *group_ch)
 {
-	struct bdev_uring_group_channel *group_ch = arg;
-	int to_complete, to_submit;
-	int count, ret;
-
-	to_submit = group_ch->io_pending;
+	int to_submit = group_ch->io_pending;
+	int ret;
 
 	if (to_submit > 0) {
 		/* If there are I/O to submit, use io_uring_submit here.
 		 * It will automatically call spdk_io_uring_enter appropriately. */
 		ret = io_uring_submit(&group_ch->uring);
 		if (ret < 0) {
-			return SPDK_POLLER_BUSY;
+			return ret;
 		}
 
 		group_ch->io_pending = 0;
 		group_ch->io_inflight += to_submit;
 	}
 
+	return to_submit;
+}
+
+static int
+bdev_uring_group_poll(void *arg)
+{
+	struct bdev_uring_group_channel *group_ch = arg;
+	int to_complete, to_submit;
+	int count;
+
+	to_submit = bdev_uring_group_submit(group_ch);
+	if (to_submit < 0) {
+		return SPDK_POLLER_BUSY;
+	}
+
 	to_complete = group_ch->io_inflight;
 	count = 0;
 	if (to_complete > 0) {
@@ -617,6 +719,21 @@ bdev_uring_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 	}
 }
 
+static void
+bdev_uring_submit_request_batch(struct spdk_io_channel *ch, struct spdk_bdev_io **bdev_ios,
+				uint32_t num_ios)
+{
+	struct bdev_uring_io_channel *uring_ch = spdk_io_channel_get_ctx(ch);
+	uint32_t i;
+
+	for (i = 0; i < num_ios; i++) {
+		bdev_uring_submit_request(ch, bdev_ios[i]);
+	}
+
+	/* Don't wait for the poller, the whole batch is already prepared on the ring */
+	bdev_uring_group_submit(uring_ch->group_ch);
+}
+
 static bool
 bdev_uring_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 {
@@ -633,12 +750,58 @@ bdev_uring_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 	}
 }
 
+static int
+bdev_uring_group_add_file(struct bdev_uring_group_channel *group_ch, int fd)
+{
+	int i, rc;
+
+	if (!group_ch->files_registered) {
+		return -1;
+	}
+
+	for (i = 0; i < SPDK_URING_FIXED_FILES; i++) {
+		if (group_ch->files[i] == -1) {
+			break;
+		}
+	}
+
+	if (i == SPDK_URING_FIXED_FILES) {
+		SPDK_DEBUGLOG(uring, "no free slot in the registered file table\n");
+		return -1;
+	}
+
+	rc = io_uring_register_files_update(&group_ch->uring, i, &fd, 1);
+	if (rc != 1) {
+		SPDK_DEBUGLOG(uring, "failed to register fd %d: %d\n", fd, rc);
+		return -1;
+	}
+
+	group_ch->files[i] = fd;
+
+	return i;
+}
+
+static void
+bdev_uring_group_remove_file(struct bdev_uring_group_channel *group_ch, int index)
+{
+	int fd = -1;
+
+	if (index < 0) {
+		return;
+	}
+
+	io_uring_register_files_update(&group_ch->uring, index, &fd, 1);
+	group_ch->files[index] = -1;
+}
+
 static int
 bdev_uring_create_cb(void *io_device, void *ctx_buf)
 {
+	struct bdev_uring *uring = io_device;
 	struct bdev_uring_io_channel *ch = ctx_buf;
 
 	ch->group_ch = spdk_io_channel_get_ctx(spdk_get_io_channel(&uring_if));
+	ch->file_index = bdev_uring_group_add_file(ch->group_ch, uring->fd);
 
 	return 0;
 }
@@ -648,6 +811,7 @@ bdev_uring_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_io_channel *ch = ctx_buf;
 
+	bdev_uring_group_remove_file(ch->group_ch, ch->file_index);
 	spdk_put_io_channel(spdk_io_channel_from_ctx(ch->group_ch));
 }
 
@@ -694,6 +858,7 @@ bdev_uring_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx
 static const struct spdk_bdev_fn_table uring_fn_table = {
 	.destruct		= bdev_uring_destruct,
 	.submit_request		= bdev_uring_submit_request,
+	.submit_request_batch	= bdev_uring_submit_request_batch,
 	.io_type_supported	= bdev_uring_io_type_supported,
 	.get_io_channel		= bdev_uring_get_io_channel,
 	.dump_info_json		= bdev_uring_dump_info_json,
@@ -711,18 +876,92 @@ uring_free_bdev(struct bdev_uring *uring)
 	free(uring);
 }
 
+static void
+bdev_uring_group_register_files(struct bdev_uring_group_channel *ch)
+{
+	int i, rc;
+
+	for (i = 0; i < SPDK_URING_FIXED_FILES; i++) {
+		ch->files[i] = -1;
+	}
+
+	if (!g_opts.fixed_files) {
+		return;
+	}
+
+	/* Register a sparse table, the slots are filled in as the bdev channels are created */
+	rc = io_uring_register_files(&ch->uring, ch->files, SPDK_URING_FIXED_FILES);
+	if (rc < 0) {
+		SPDK_NOTICELOG("Unable to register files with uring, errno %d: %s\n",
+			       -rc, spdk_strerror(-rc));
+		return;
+	}
+
+	ch->files_registered = true;
+}
+
+static void
+bdev_uring_group_register_buffers(struct bdev_uring_group_channel *ch)
+{
+	struct iovec regions[2];
+	uint64_t offset, len;
+	int i, num_regions, rc;
+
+	ch->num_fixed_bufs = 0;
+
+	if (!g_opts.fixed_buffers) {
+		return;
+	}
+
+	num_regions = spdk_iobuf_get_pool_regions(regions, SPDK_COUNTOF(regions));
+	for (i = 0; i < num_regions; i++) {
+		for (offset = 0; offset < regions[i].iov_len; offset += len) {
+			if (ch->num_fixed_bufs == SPDK_URING_MAX_FIXED_BUFS) {
+				break;
+			}
+
+			len = spdk_min(regions[i].iov_len - offset, SPDK_URING_FIXED_BUF_MAX_LEN);
+			ch->fixed_bufs[ch->num_fixed_bufs].iov_base = (char *)regions[i].iov_base + offset;
+			ch->fixed_bufs[ch->num_fixed_bufs].iov_len = len;
+			ch->num_fixed_bufs++;
+		}
+	}
+
+	if (ch->num_fixed_bufs == 0) {
+		return;
+	}
+
+	rc = io_uring_register_buffers(&ch->uring, ch->fixed_bufs, ch->num_fixed_bufs);
+	if (rc < 0) {
+		SPDK_NOTICELOG("Unable to register iobuf buffers with uring, errno %d: %s\n",
+			       -rc, spdk_strerror(-rc));
+		ch->num_fixed_bufs = 0;
+	}
+}
+
 static int
 bdev_uring_group_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_group_channel *ch = ctx_buf;
+	struct io_uring_params params = {};
+	int rc;
+
+	if (g_opts.sqpoll) {
+		params.flags |= IORING_SETUP_SQPOLL;
+		params.sq_thread_idle = g_opts.sqpoll_idle_ms;
+	}
 
 	/* Do not use IORING_SETUP_IOPOLL until the Linux kernel can support not only
 	 * local devices but also devices attached from remote target */
-	if (io_uring_queue_init(SPDK_URING_QUEUE_DEPTH, &ch->uring, 0) < 0) {
-		SPDK_ERRLOG("uring I/O context setup failure\n");
+	rc = io_uring_queue_init_params(SPDK_URING_QUEUE_DEPTH, &ch->uring, &params);
+	if (rc < 0) {
+		SPDK_ERRLOG("uring I/O context setup failure, errno %d: %s\n", -rc, spdk_strerror(-rc));
 		return -1;
 	}
 
+	bdev_uring_group_register_files(ch);
+	bdev_uring_group_register_buffers(ch);
+
 	ch->poller = SPDK_POLLER_REGISTER(bdev_uring_group_poll, ch, 0);
 	return 0;
 }
@@ -874,6 +1113,25 @@ delete_uring_bdev(const char *name, spdk_delete_uring_complete cb_fn, void *cb_a
 	}
 }
 
+static int
+bdev_uring_config_json(struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_string(w, "method", "bdev_uring_set_options");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_bool(w, "sqpoll", g_opts.sqpoll);
+	spdk_json_write_named_uint32(w, "sqpoll_idle_ms", g_opts.sqpoll_idle_ms);
+	spdk_json_write_named_bool(w, "fixed_files", g_opts.fixed_files);
+	spdk_json_write_named_bool(w, "fixed_buffers", g_opts.fixed_buffers);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
 static int
 bdev_uring_init(void)
 {
@@ -15,6 +15,25 @@
 
 typedef void (*spdk_delete_uring_complete)(void *cb_arg, int bdeverrno);
 
+struct bdev_uring_opts {
+	/* Use a kernel thread to poll the submission queue */
+	bool		sqpoll;
+	/* Idle time of the submission queue polling thread before it goes to sleep */
+	uint32_t	sqpoll_idle_ms;
+	/* Register the files of the uring bdevs with the rings */
+	bool		fixed_files;
+	/* Register the iobuf pools with the rings as fixed buffers */
+	bool		fixed_buffers;
+};
+
+void bdev_uring_get_opts(struct bdev_uring_opts *opts);
+
+/*
+ * The options are applied to the rings created after this call, so they should be set
+ * before any uring bdev is opened.
+ */
+int bdev_uring_set_opts(const struct bdev_uring_opts *opts);
+
 struct spdk_bdev *create_uring_bdev(const char *name, const char *filename, uint32_t block_size);
 
 void delete_uring_bdev(const char *name, spdk_delete_uring_complete cb_fn, void *cb_arg);
@@ -43,7 +43,10 @@ struct virtio_blk_io_ctx {
 struct bdev_virtio_blk_io_channel {
 	struct virtio_dev		*vdev;
 
-	/** Virtqueue exclusively assigned to this channel. */
+	/**
+	 * Virtqueue assigned to this channel.  If there are more channels than queues, it may be
+	 * shared with other channels, so it's always accessed under vq->lock.
+	 */
 	struct virtqueue		*vq;
 
 	/** Virtio response poller. */
@@ -117,7 +120,12 @@ bdev_virtio_blk_send_io(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io
 	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
 	int rc;
 
+	pthread_spin_lock(&vq->lock);
 	rc = virtqueue_req_start(vq, bdev_io, bdev_io->u.bdev.iovcnt + 2);
+	if (rc != 0) {
+		pthread_spin_unlock(&vq->lock);
+	}
+
 	if (rc == -ENOMEM) {
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
 		return;
@@ -137,6 +145,7 @@ bdev_virtio_blk_send_io(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io
 	virtqueue_req_add_iovs(vq, &io_ctx->iov_resp, 1, SPDK_VIRTIO_DESC_WR);
 
 	virtqueue_req_flush(vq);
+	pthread_spin_unlock(&vq->lock);
 }
 
 static void
@@ -322,17 +331,35 @@ bdev_virtio_io_cpl(struct spdk_bdev_io *bdev_io)
 			      SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
 }
 
+static void
+bdev_virtio_io_cpl_msg(void *ctx)
+{
+	bdev_virtio_io_cpl(ctx);
+}
+
 static int
 bdev_virtio_poll(void *arg)
 {
 	struct bdev_virtio_blk_io_channel *ch = arg;
 	void *io[32];
 	uint32_t io_len[32];
+	struct spdk_thread *thread = spdk_get_thread();
+	struct spdk_bdev_io *bdev_io;
 	uint16_t i, cnt;
 
+	pthread_spin_lock(&ch->vq->lock);
 	cnt = virtio_recv_pkts(ch->vq, io, io_len, SPDK_COUNTOF(io));
+	pthread_spin_unlock(&ch->vq->lock);
+
 	for (i = 0; i < cnt; ++i) {
-		bdev_virtio_io_cpl(io[i]);
+		bdev_io = io[i];
+		/* A shared queue may return requests submitted by other channels */
+		if (spdk_unlikely(spdk_bdev_io_get_thread(bdev_io) != thread)) {
+			spdk_thread_send_msg(spdk_bdev_io_get_thread(bdev_io),
+					     bdev_virtio_io_cpl_msg, bdev_io);
+			continue;
+		}
+		bdev_virtio_io_cpl(bdev_io);
 	}
 
 	return cnt;
@@ -349,8 +376,12 @@ bdev_virtio_blk_ch_create_cb(void *io_device, void *ctx_buf)
 
 	queue_idx = virtio_dev_find_and_acquire_queue(vdev, 0);
 	if (queue_idx < 0) {
-		SPDK_ERRLOG("Couldn't get an unused queue for the io_channel.\n");
-		return -1;
+		/* There are more threads than queues, share the least used one */
+		queue_idx = virtio_dev_find_and_share_queue(vdev, 0);
+		if (queue_idx < 0) {
+			SPDK_ERRLOG("Couldn't get a queue for the io_channel.\n");
+			return -1;
+		}
 	}
 
 	vq = vdev->vqs[queue_idx];
@@ -265,13 +265,14 @@ bdev_xnvme_poll(void *arg)
 	struct bdev_xnvme_io_channel *ch = arg;
 	int rc;
 
+	/* Reap all the available completions at once */
 	rc = xnvme_queue_poke(ch->queue, 0);
 	if (rc < 0) {
 		SPDK_ERRLOG("xnvme_queue_poke failure rc : %d\n", rc);
 		return SPDK_POLLER_BUSY;
 	}
 
-	return xnvme_queue_get_outstanding(ch->queue) ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+	return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
 static int
@@ -331,6 +332,15 @@ create_xnvme_bdev(const char *name, const char *filename, const char *io_mechani
 		goto error_return;
 	}
 
+	/* Register the device with the ring, so that the kernel doesn't look up the file for each
+	 * submission. For io_uring_cmd this makes NVMe passthrough commands as cheap to submit as
+	 * possible, along with the submission queue polling thread enabled below.
+	 */
+	if (!strcmp(xnvme->io_mechanism, "io_uring") ||
+	    !strcmp(xnvme->io_mechanism, "io_uring_cmd")) {
+		opts.register_files = 1;
+	}
+
 	if (!conserve_cpu) {
 		if (!strcmp(xnvme->io_mechanism, "libaio")) {
 			opts.poll_io = 1;
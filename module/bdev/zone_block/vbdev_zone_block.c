@@ -13,6 +13,7 @@
 #include "spdk/bdev_zone.h"
 
 #include "spdk/log.h"
+#include "spdk/thread.h"
 
 /* This namespace UUID was generated using uuid_generate() method. */
 #define BDEV_ZONE_BLOCK_NAMESPACE_UUID "5f3f485a-d6bb-4443-9de7-023683b77389"
@@ -64,8 +65,24 @@ struct bdev_zone_block {
 };
 static TAILQ_HEAD(, bdev_zone_block) g_bdev_nodes = TAILQ_HEAD_INITIALIZER(g_bdev_nodes);
 
+/* Maximum number of zone appends merged into a single write to the base bdev */
+#define ZONE_BLOCK_APPEND_BATCH_SIZE	32
+/* Maximum number of iovecs of such a merged write */
+#define ZONE_BLOCK_APPEND_BATCH_IOVS	64
+
 struct zone_block_io_channel {
 	struct spdk_io_channel	*base_ch; /* IO channel of base device */
+	/* Zone appends waiting to be merged, submitted once the current poll is done */
+	struct spdk_bdev_io	*appends[ZONE_BLOCK_APPEND_BATCH_SIZE];
+	uint32_t		num_appends;
+};
+
+struct zone_block_append_batch {
+	uint64_t		lba;
+	uint32_t		num_ios;
+	int			iovcnt;
+	struct spdk_bdev_io	*ios[ZONE_BLOCK_APPEND_BATCH_SIZE];
+	struct iovec		iovs[ZONE_BLOCK_APPEND_BATCH_IOVS];
 };
 
 struct zone_block_io {
@@ -358,26 +375,15 @@ _zone_block_complete_write(struct spdk_bdev_io *bdev_io, bool success, void *cb_
 	spdk_bdev_free_io(bdev_io);
 }
 
+/* Check that a write of len blocks at *lba fits the zone and advance its write pointer. For
+ * appends, *lba is set to the current write pointer.
+ */
 static int
-zone_block_write(struct bdev_zone_block *bdev_node, struct zone_block_io_channel *ch,
-		 struct spdk_bdev_io *bdev_io)
+zone_block_reserve_blocks(struct block_zone *zone, bool is_append, uint64_t *_lba, uint64_t len)
 {
-	struct block_zone *zone;
-	uint64_t len = bdev_io->u.bdev.num_blocks;
-	uint64_t lba = bdev_io->u.bdev.offset_blocks;
+	uint64_t lba = *_lba;
 	uint64_t num_blocks_left, wp;
 	int rc = 0;
-	bool is_append = bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_APPEND;
-
-	if (is_append) {
-		zone = zone_block_get_zone_by_slba(bdev_node, lba);
-	} else {
-		zone = zone_block_get_zone_containing_lba(bdev_node, lba);
-	}
-	if (!zone) {
-		SPDK_ERRLOG("Trying to write to invalid zone (lba 0x%" PRIx64 ")\n", lba);
-		return -EINVAL;
-	}
 
 	pthread_spin_lock(&zone->lock);
 
@@ -413,26 +419,210 @@ zone_block_write(struct bdev_zone_block *bdev_node, struct zone_block_io_channel
 		goto write_fail;
 	}
 
-	zone->zone_info.write_pointer += bdev_io->u.bdev.num_blocks;
+	zone->zone_info.write_pointer += len;
 	assert(zone->zone_info.write_pointer <= zone->zone_info.zone_id + zone->zone_info.capacity);
 	if (zone->zone_info.write_pointer == zone->zone_info.zone_id + zone->zone_info.capacity) {
 		zone->zone_info.state = SPDK_BDEV_ZONE_STATE_FULL;
 	}
-	pthread_spin_unlock(&zone->lock);
-
-	rc = spdk_bdev_writev_blocks_with_md(bdev_node->base_desc, ch->base_ch,
-					     bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
-					     bdev_io->u.bdev.md_buf,
-					     lba, bdev_io->u.bdev.num_blocks,
-					     _zone_block_complete_write, bdev_io);
-
-	return rc;
+	*_lba = lba;
 
 write_fail:
 	pthread_spin_unlock(&zone->lock);
 	return rc;
 }
 
+static int
+zone_block_write(struct bdev_zone_block *bdev_node, struct zone_block_io_channel *ch,
+		 struct spdk_bdev_io *bdev_io)
+{
+	struct block_zone *zone;
+	uint64_t len = bdev_io->u.bdev.num_blocks;
+	uint64_t lba = bdev_io->u.bdev.offset_blocks;
+	int rc;
+	bool is_append = bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_APPEND;
+
+	if (is_append) {
+		zone = zone_block_get_zone_by_slba(bdev_node, lba);
+	} else {
+		zone = zone_block_get_zone_containing_lba(bdev_node, lba);
+	}
+	if (!zone) {
+		SPDK_ERRLOG("Trying to write to invalid zone (lba 0x%" PRIx64 ")\n", lba);
+		return -EINVAL;
+	}
+
+	rc = zone_block_reserve_blocks(zone, is_append, &lba, len);
+	if (rc != 0) {
+		return rc;
+	}
+
+	return spdk_bdev_writev_blocks_with_md(bdev_node->base_desc, ch->base_ch,
+					       bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					       bdev_io->u.bdev.md_buf,
+					       lba, len,
+					       _zone_block_complete_write, bdev_io);
+}
+
+static void
+zone_block_io_fail(struct spdk_bdev_io *bdev_io, int rc)
+{
+	if (rc == -ENOMEM) {
+		SPDK_WARNLOG("ENOMEM, start to queue io for vbdev.\n");
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	} else {
+		SPDK_ERRLOG("ERROR on bdev_io submission!\n");
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+_zone_block_complete_append_batch(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct zone_block_append_batch *batch = cb_arg;
+	int status = success ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED;
+	uint64_t lba = batch->lba;
+	uint32_t i;
+
+	spdk_bdev_free_io(bdev_io);
+
+	for (i = 0; i < batch->num_ios; i++) {
+		batch->ios[i]->u.bdev.offset_blocks = lba;
+		lba += batch->ios[i]->u.bdev.num_blocks;
+		spdk_bdev_io_complete(batch->ios[i], status);
+	}
+
+	free(batch);
+}
+
+static bool
+zone_block_append_can_batch(struct spdk_bdev_io *bdev_io)
+{
+	/* Separate metadata buffers can't be merged */
+	return bdev_io->u.bdev.md_buf == NULL;
+}
+
+/* Merge the appends to the zone of ios[0] into a single write. The appends that were submitted,
+ * merged or not, are cleared from ios.
+ */
+static void
+zone_block_submit_append_batch(struct bdev_zone_block *bdev_node,
+			       struct zone_block_io_channel *ch,
+			       struct spdk_bdev_io **ios, uint32_t num_ios)
+{
+	struct spdk_bdev_io *first = ios[0], *bdev_io;
+	struct zone_block_append_batch *batch;
+	struct block_zone *zone;
+	uint64_t zone_id = first->u.bdev.offset_blocks;
+	uint64_t len = 0;
+	uint32_t idx[ZONE_BLOCK_APPEND_BATCH_SIZE];
+	uint32_t i;
+	int rc;
+
+	zone = zone_block_get_zone_by_slba(bdev_node, zone_id);
+	if (zone == NULL || !zone_block_append_can_batch(first)) {
+		goto single;
+	}
+
+	batch = calloc(1, sizeof(*batch));
+	if (batch == NULL) {
+		goto single;
+	}
+
+	for (i = 0; i < num_ios; i++) {
+		bdev_io = ios[i];
+		if (bdev_io == NULL || bdev_io->u.bdev.offset_blocks != zone_id ||
+		    !zone_block_append_can_batch(bdev_io)) {
+			continue;
+		}
+		if (batch->iovcnt + bdev_io->u.bdev.iovcnt > ZONE_BLOCK_APPEND_BATCH_IOVS) {
+			break;
+		}
+
+		memcpy(&batch->iovs[batch->iovcnt], bdev_io->u.bdev.iovs,
+		       bdev_io->u.bdev.iovcnt * sizeof(struct iovec));
+		batch->iovcnt += bdev_io->u.bdev.iovcnt;
+		idx[batch->num_ios] = i;
+		batch->ios[batch->num_ios++] = bdev_io;
+		len += bdev_io->u.bdev.num_blocks;
+	}
+
+	/* If the merged appends don't fit, let each of them be checked on its own */
+	if (batch->num_ios < 2 || zone_block_reserve_blocks(zone, true, &batch->lba, len) != 0) {
+		free(batch);
+		goto single;
+	}
+
+	for (i = 0; i < batch->num_ios; i++) {
+		ios[idx[i]] = NULL;
+	}
+
+	rc = spdk_bdev_writev_blocks(bdev_node->base_desc, ch->base_ch, batch->iovs, batch->iovcnt,
+				     batch->lba, len, _zone_block_complete_append_batch, batch);
+	if (rc != 0) {
+		for (i = 0; i < batch->num_ios; i++) {
+			zone_block_io_fail(batch->ios[i], rc);
+		}
+		free(batch);
+	}
+	return;
+
+single:
+	ios[0] = NULL;
+	rc = zone_block_write(bdev_node, ch, first);
+	if (rc != 0) {
+		zone_block_io_fail(first, rc);
+	}
+}
+
+static void
+zone_block_flush_appends(void *ctx)
+{
+	struct zone_block_io_channel *ch = ctx;
+	struct spdk_bdev_io *ios[ZONE_BLOCK_APPEND_BATCH_SIZE];
+	struct bdev_zone_block *bdev_node;
+	uint32_t num_ios = ch->num_appends;
+	uint32_t i;
+
+	/* Appends submitted from the completion callbacks start a new batch */
+	memcpy(ios, ch->appends, num_ios * sizeof(ios[0]));
+	ch->num_appends = 0;
+
+	for (i = 0; i < num_ios; i++) {
+		if (ios[i] == NULL) {
+			continue;
+		}
+		bdev_node = SPDK_CONTAINEROF(ios[i]->bdev, struct bdev_zone_block, bdev);
+		zone_block_submit_append_batch(bdev_node, ch, &ios[i], num_ios - i);
+	}
+}
+
+/* Zone appends are held until the end of the current poll of the thread, so that the appends to
+ * the same zone submitted in the meantime are written to the base bdev at once.
+ */
+static void
+zone_block_queue_append(struct bdev_zone_block *bdev_node, struct zone_block_io_channel *ch,
+			struct spdk_bdev_io *bdev_io)
+{
+	int rc;
+
+	if (ch->num_appends == 0) {
+		rc = spdk_thread_send_msg(spdk_get_thread(), zone_block_flush_appends, ch);
+		if (rc != 0) {
+			rc = zone_block_write(bdev_node, ch, bdev_io);
+			if (rc != 0) {
+				zone_block_io_fail(bdev_io, rc);
+			}
+			return;
+		}
+	}
+
+	ch->appends[ch->num_appends++] = bdev_io;
+	if (ch->num_appends == ZONE_BLOCK_APPEND_BATCH_SIZE) {
+		/* The message sent above finds nothing left to submit */
+		zone_block_flush_appends(ch);
+	}
+}
+
 static void
 _zone_block_complete_read(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
@@ -490,9 +680,11 @@ zone_block_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 		rc = zone_block_zone_management(bdev_node, dev_ch, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
-	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
 		rc = zone_block_write(bdev_node, dev_ch, bdev_io);
 		break;
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+		zone_block_queue_append(bdev_node, dev_ch, bdev_io);
+		break;
 	case SPDK_BDEV_IO_TYPE_READ:
 		rc = zone_block_read(bdev_node, dev_ch, bdev_io);
 		break;
@@ -503,13 +695,7 @@ zone_block_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 	}
 
 	if (rc != 0) {
-		if (rc == -ENOMEM) {
-			SPDK_WARNLOG("ENOMEM, start to queue io for vbdev.\n");
-			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
-		} else {
-			SPDK_ERRLOG("ERROR on bdev_io submission!\n");
-			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
-		}
+		zone_block_io_fail(bdev_io, rc);
 	}
 }
 
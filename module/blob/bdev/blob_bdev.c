@@ -528,3 +528,13 @@ spdk_bdev_create_bs_dev_ext(const char *bdev_name, spdk_bdev_event_cb_t event_cb
 {
 	return spdk_bdev_create_bs_dev(bdev_name, true, NULL, 0, event_cb, event_ctx, bs_dev);
 }
+
+struct spdk_bdev_desc *
+spdk_bs_bdev_get_desc(struct spdk_bs_dev *bs_dev)
+{
+	if (bs_dev->create_channel != bdev_blob_create_channel) {
+		return NULL;
+	}
+
+	return __get_desc(bs_dev);
+}
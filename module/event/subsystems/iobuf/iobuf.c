@@ -38,6 +38,7 @@ static void
 iobuf_write_config_json(struct spdk_json_write_ctx *w)
 {
 	struct spdk_iobuf_opts opts;
+	uint32_t i;
 
 	spdk_iobuf_get_opts(&opts);
 
@@ -51,6 +52,16 @@ iobuf_write_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_uint64(w, "large_pool_count", opts.large_pool_count);
 	spdk_json_write_named_uint32(w, "small_bufsize", opts.small_bufsize);
 	spdk_json_write_named_uint32(w, "large_bufsize", opts.large_bufsize);
+	if (opts.medium_pool_count[0] != 0) {
+		spdk_json_write_named_array_begin(w, "medium_pools");
+		for (i = 0; i < SPDK_IOBUF_MAX_MEDIUM_POOLS && opts.medium_pool_count[i] != 0; i++) {
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_uint64(w, "count", opts.medium_pool_count[i]);
+			spdk_json_write_named_uint32(w, "bufsize", opts.medium_bufsize[i]);
+			spdk_json_write_object_end(w);
+		}
+		spdk_json_write_array_end(w);
+	}
 	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 
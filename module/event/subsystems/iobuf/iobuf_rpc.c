@@ -4,34 +4,91 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/env.h"
 #include "spdk/thread.h"
 #include "spdk/rpc.h"
 #include "spdk/string.h"
+#include "spdk/util.h"
 #include "spdk_internal/init.h"
 
+struct rpc_iobuf_medium_pool {
+	uint64_t	count;
+	uint32_t	bufsize;
+};
+
+struct rpc_iobuf_medium_pools {
+	struct rpc_iobuf_medium_pool	pools[SPDK_IOBUF_MAX_MEDIUM_POOLS];
+	size_t				num_pools;
+};
+
+struct rpc_iobuf_set_options {
+	struct spdk_iobuf_opts		opts;
+	struct rpc_iobuf_medium_pools	medium;
+	bool				medium_set;
+};
+
+static const struct spdk_json_object_decoder rpc_iobuf_medium_pool_decoders[] = {
+	{"count", offsetof(struct rpc_iobuf_medium_pool, count), spdk_json_decode_uint64},
+	{"bufsize", offsetof(struct rpc_iobuf_medium_pool, bufsize), spdk_json_decode_uint32},
+};
+
+static int
+rpc_decode_iobuf_medium_pool(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object(val, rpc_iobuf_medium_pool_decoders,
+				       SPDK_COUNTOF(rpc_iobuf_medium_pool_decoders), out);
+}
+
+static int
+rpc_decode_iobuf_medium_pools(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_iobuf_set_options *req = SPDK_CONTAINEROF(out, struct rpc_iobuf_set_options,
+					    medium);
+
+	req->medium_set = true;
+
+	return spdk_json_decode_array(val, rpc_decode_iobuf_medium_pool, req->medium.pools,
+				      SPDK_IOBUF_MAX_MEDIUM_POOLS, &req->medium.num_pools,
+				      sizeof(struct rpc_iobuf_medium_pool));
+}
+
 static const struct spdk_json_object_decoder rpc_iobuf_set_options_decoders[] = {
-	{"small_pool_count", offsetof(struct spdk_iobuf_opts, small_pool_count), spdk_json_decode_uint64, true},
-	{"large_pool_count", offsetof(struct spdk_iobuf_opts, large_pool_count), spdk_json_decode_uint64, true},
-	{"small_bufsize", offsetof(struct spdk_iobuf_opts, small_bufsize), spdk_json_decode_uint32, true},
-	{"large_bufsize", offsetof(struct spdk_iobuf_opts, large_bufsize), spdk_json_decode_uint32, true},
+	{"small_pool_count", offsetof(struct rpc_iobuf_set_options, opts.small_pool_count), spdk_json_decode_uint64, true},
+	{"large_pool_count", offsetof(struct rpc_iobuf_set_options, opts.large_pool_count), spdk_json_decode_uint64, true},
+	{"small_bufsize", offsetof(struct rpc_iobuf_set_options, opts.small_bufsize), spdk_json_decode_uint32, true},
+	{"large_bufsize", offsetof(struct rpc_iobuf_set_options, opts.large_bufsize), spdk_json_decode_uint32, true},
+	{"medium_pools", offsetof(struct rpc_iobuf_set_options, medium), rpc_decode_iobuf_medium_pools, true},
 };
 
 static void
 rpc_iobuf_set_options(struct spdk_jsonrpc_request *request, const struct spdk_json_val *params)
 {
-	struct spdk_iobuf_opts opts;
+	struct rpc_iobuf_set_options req = {};
+	struct spdk_iobuf_opts *opts = &req.opts;
+	size_t i;
 	int rc;
 
-	spdk_iobuf_get_opts(&opts);
+	spdk_iobuf_get_opts(opts);
 	rc = spdk_json_decode_object(params, rpc_iobuf_set_options_decoders,
-				     SPDK_COUNTOF(rpc_iobuf_set_options_decoders), &opts);
+				     SPDK_COUNTOF(rpc_iobuf_set_options_decoders), &req);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "spdk_json_decode_object failed");
 		return;
 	}
 
-	rc = spdk_iobuf_set_opts(&opts);
+	/* The medium pools are replaced as a whole when specified */
+	for (i = 0; req.medium_set && i < SPDK_IOBUF_MAX_MEDIUM_POOLS; i++) {
+		if (i < req.medium.num_pools && req.medium.pools[i].count == 0) {
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							 "medium pool count must be non-zero");
+			return;
+		}
+		opts->medium_pool_count[i] = req.medium.pools[i].count;
+		opts->medium_bufsize[i] = req.medium.pools[i].bufsize;
+	}
+
+	rc = spdk_iobuf_set_opts(opts);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
 		return;
@@ -40,3 +97,75 @@ rpc_iobuf_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 	spdk_jsonrpc_send_bool_response(request, true);
 }
 SPDK_RPC_REGISTER("iobuf_set_options", rpc_iobuf_set_options, SPDK_RPC_STARTUP)
+
+static void
+rpc_iobuf_write_pool_stats(struct spdk_json_write_ctx *w, const struct spdk_iobuf_pool_stats *stats)
+{
+	spdk_json_write_named_uint64(w, "cache", stats->cache);
+	spdk_json_write_named_uint64(w, "main", stats->main);
+	spdk_json_write_named_uint64(w, "retry", stats->retry);
+	spdk_json_write_named_uint64(w, "remote", stats->remote);
+	spdk_json_write_named_uint64(w, "outstanding", stats->outstanding);
+	spdk_json_write_named_uint64(w, "wait_time_us",
+				     stats->wait_ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz());
+}
+
+static void
+rpc_iobuf_get_stats_done(struct spdk_iobuf_module_stats *modules, uint32_t num_modules,
+			 void *cb_arg)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+	struct spdk_json_write_ctx *w;
+	struct spdk_iobuf_opts opts;
+	uint32_t i, j;
+
+	spdk_iobuf_get_opts(&opts);
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(w);
+
+	for (i = 0; i < num_modules; ++i) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "module", modules[i].module);
+
+		spdk_json_write_named_object_begin(w, "small_pool");
+		rpc_iobuf_write_pool_stats(w, &modules[i].small_pool);
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_named_array_begin(w, "medium_pools");
+		for (j = 0; j < modules[i].num_medium; ++j) {
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_uint32(w, "bufsize", opts.medium_bufsize[j]);
+			rpc_iobuf_write_pool_stats(w, &modules[i].medium_pool[j]);
+			spdk_json_write_object_end(w);
+		}
+		spdk_json_write_array_end(w);
+
+		spdk_json_write_named_object_begin(w, "large_pool");
+		rpc_iobuf_write_pool_stats(w, &modules[i].large_pool);
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+
+	spdk_json_write_array_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_iobuf_get_stats(struct spdk_jsonrpc_request *request, const struct spdk_json_val *params)
+{
+	int rc;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "iobuf_get_stats requires no parameters");
+		return;
+	}
+
+	rc = spdk_iobuf_get_stats(rpc_iobuf_get_stats_done, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+}
+SPDK_RPC_REGISTER("iobuf_get_stats", rpc_iobuf_get_stats, SPDK_RPC_RUNTIME)
@@ -0,0 +1,113 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/log.h"
+#include "spdk/metrics.h"
+#include "spdk/rpc.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk_internal/init.h"
+
+#define METRICS_DEFAULT_LISTEN_ADDRESS	"127.0.0.1"
+#define METRICS_DEFAULT_LISTEN_PORT	9464
+
+static struct {
+	char		*listen_address;
+	uint16_t	listen_port;
+} g_metrics_exporter;
+
+static void
+metrics_subsystem_init(void)
+{
+	int rc = 0;
+
+	if (spdk_metrics_enabled()) {
+		rc = spdk_metrics_exporter_start(g_metrics_exporter.listen_address,
+						 g_metrics_exporter.listen_port);
+	}
+
+	spdk_subsystem_init_next(rc);
+}
+
+static void
+metrics_subsystem_fini(void)
+{
+	spdk_metrics_exporter_stop();
+	free(g_metrics_exporter.listen_address);
+	g_metrics_exporter.listen_address = NULL;
+	spdk_subsystem_fini_next();
+}
+
+static void
+metrics_subsystem_write_config_json(struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_array_begin(w);
+	if (spdk_metrics_enabled()) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "metrics_enable_exporter");
+
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "listen_address", g_metrics_exporter.listen_address);
+		spdk_json_write_named_uint32(w, "listen_port", g_metrics_exporter.listen_port);
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+}
+
+static struct spdk_subsystem g_subsystem_metrics = {
+	.name = "metrics",
+	.init = metrics_subsystem_init,
+	.fini = metrics_subsystem_fini,
+	.write_config_json = metrics_subsystem_write_config_json,
+};
+
+SPDK_SUBSYSTEM_REGISTER(g_subsystem_metrics);
+
+struct rpc_metrics_enable_exporter {
+	char		*listen_address;
+	uint16_t	listen_port;
+};
+
+static const struct spdk_json_object_decoder rpc_metrics_enable_exporter_decoders[] = {
+	{"listen_address", offsetof(struct rpc_metrics_enable_exporter, listen_address), spdk_json_decode_string, true},
+	{"listen_port", offsetof(struct rpc_metrics_enable_exporter, listen_port), spdk_json_decode_uint16, true},
+};
+
+static void
+rpc_metrics_enable_exporter(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_metrics_enable_exporter req = {
+		.listen_port = METRICS_DEFAULT_LISTEN_PORT,
+	};
+
+	if (params != NULL &&
+	    spdk_json_decode_object(params, rpc_metrics_enable_exporter_decoders,
+				    SPDK_COUNTOF(rpc_metrics_enable_exporter_decoders), &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		free(req.listen_address);
+		return;
+	}
+
+	if (req.listen_address == NULL) {
+		req.listen_address = strdup(METRICS_DEFAULT_LISTEN_ADDRESS);
+		if (req.listen_address == NULL) {
+			spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+			return;
+		}
+	}
+
+	free(g_metrics_exporter.listen_address);
+	g_metrics_exporter.listen_address = req.listen_address;
+	g_metrics_exporter.listen_port = req.listen_port;
+	spdk_metrics_enable();
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("metrics_enable_exporter", rpc_metrics_enable_exporter, SPDK_RPC_STARTUP)
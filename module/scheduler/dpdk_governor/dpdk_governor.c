@@ -64,6 +64,8 @@ _set_core_freq_min(uint32_t lcore_id)
 static int
 _get_core_capabilities(uint32_t lcore_id, struct spdk_governor_capabilities *capabilities)
 {
+	const uint32_t MAX_CORE_FREQ_NUM = 64;
+	uint32_t freqs[MAX_CORE_FREQ_NUM];
 	struct rte_power_core_capabilities caps;
 	int rc;
 
@@ -73,6 +75,10 @@ _get_core_capabilities(uint32_t lcore_id, struct spdk_governor_capabilities *cap
 	}
 
 	capabilities->priority = caps.priority == 0 ? false : true;
+	/* Frequencies are listed in descending order */
+	if (rte_power_freqs(lcore_id, freqs, MAX_CORE_FREQ_NUM) > 0) {
+		capabilities->max_freq = freqs[0];
+	}
 
 	return 0;
 }
@@ -20,6 +20,11 @@ struct core_stats {
 	uint64_t busy;
 	uint64_t idle;
 	uint32_t thread_count;
+	/* Number of latency sensitive and bursty threads, only counted in latency aware mode */
+	uint32_t sensitive_count;
+	uint32_t bursty_count;
+	/* Core can't be slowed down any further to meet the power cap */
+	bool at_min_freq;
 };
 
 static struct core_stats *g_cores;
@@ -27,6 +32,13 @@ static struct core_stats *g_cores;
 uint8_t g_scheduler_load_limit = 20;
 uint8_t g_scheduler_core_limit = 80;
 uint8_t g_scheduler_core_busy = 95;
+bool g_scheduler_latency_aware = false;
+uint32_t g_scheduler_burst_limit = 100;
+uint32_t g_scheduler_msg_rate_limit = 100000;
+bool g_scheduler_power_aware = false;
+uint8_t g_scheduler_power_cap = 0;
+bool g_scheduler_numa_aware = false;
+uint8_t g_scheduler_numa_cross_limit = 95;
 
 static uint8_t
 _busy_pct(uint64_t busy, uint64_t idle)
@@ -50,6 +62,114 @@ _get_thread_load(struct spdk_scheduler_thread_info *thread_info)
 	return _busy_pct(busy, idle);
 }
 
+/* Latency sensitive threads are only kept apart in latency aware mode */
+static bool
+_is_thread_sensitive(struct spdk_scheduler_thread_info *thread_info)
+{
+	return g_scheduler_latency_aware &&
+	       thread_info->latency_class == SPDK_THREAD_LATENCY_CLASS_SENSITIVE;
+}
+
+/* A thread doing its work in long bursts or handling a high rate of messages delays the other
+ * threads on its core more than its busy percentage suggests. */
+static bool
+_is_thread_bursty(struct spdk_scheduler_thread_info *thread_info)
+{
+	uint64_t burst_limit_tsc, tsc, msg_rate;
+
+	if (!g_scheduler_latency_aware) {
+		return false;
+	}
+
+	burst_limit_tsc = g_scheduler_burst_limit * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	if (thread_info->burst_stats.busy_run_p99_tsc > burst_limit_tsc) {
+		return true;
+	}
+
+	tsc = thread_info->current_stats.busy_tsc + thread_info->current_stats.idle_tsc;
+	if (tsc == 0) {
+		return false;
+	}
+
+	msg_rate = thread_info->burst_stats.msg_count * spdk_get_ticks_hz() / tsc;
+
+	return msg_rate > g_scheduler_msg_rate_limit;
+}
+
+/* Check if placing the thread on a core would put a latency sensitive thread together with
+ * another latency sensitive or bursty one. */
+static bool
+_has_latency_conflict(struct spdk_scheduler_thread_info *thread_info, uint32_t core_id)
+{
+	struct core_stats *core = &g_cores[core_id];
+	uint32_t sensitive_count = core->sensitive_count;
+	uint32_t bursty_count = core->bursty_count;
+	bool sensitive = _is_thread_sensitive(thread_info);
+	bool bursty = _is_thread_bursty(thread_info);
+
+	/* Don't count the thread itself */
+	if (thread_info->lcore == core_id) {
+		sensitive_count -= sensitive;
+		bursty_count -= bursty;
+	}
+
+	if (sensitive) {
+		return sensitive_count + bursty_count > 0;
+	}
+
+	return bursty && sensitive_count > 0;
+}
+
+static void
+_count_latency_thread(struct spdk_scheduler_thread_info *thread_info)
+{
+	struct core_stats *core = &g_cores[thread_info->lcore];
+
+	core->sensitive_count += _is_thread_sensitive(thread_info);
+	core->bursty_count += _is_thread_bursty(thread_info);
+}
+
+/* Check if all cores of a socket are loaded over g_scheduler_numa_cross_limit, which allows
+ * moving threads preferring that socket to other ones.  Cores in interrupt mode don't update
+ * stats and are always considered available. */
+static bool
+_is_socket_at_limit(uint32_t socket_id)
+{
+	struct core_stats *core;
+	uint32_t i;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		core = &g_cores[i];
+		if (spdk_env_get_socket_id(i) != socket_id) {
+			continue;
+		}
+		if (_busy_pct(core->busy, core->idle) < g_scheduler_numa_cross_limit) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Check if placing the thread on a core would move it away from its preferred socket while
+ * that socket can still take it. */
+static bool
+_has_numa_conflict(struct spdk_scheduler_thread_info *thread_info, uint32_t core_id)
+{
+	uint32_t socket_id;
+
+	if (!g_scheduler_numa_aware || thread_info->numa_affinity == SPDK_ENV_SOCKET_ID_ANY) {
+		return false;
+	}
+
+	socket_id = (uint32_t)thread_info->numa_affinity;
+	if (spdk_env_get_socket_id(core_id) == socket_id) {
+		return false;
+	}
+
+	return !_is_socket_at_limit(socket_id);
+}
+
 typedef void (*_foreach_fn)(struct spdk_scheduler_thread_info *thread_info);
 
 static void
@@ -110,9 +230,28 @@ _move_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t dst_core)
 	assert(src->thread_count > 0);
 	src->thread_count--;
 
+	if (_is_thread_sensitive(thread_info)) {
+		assert(src->sensitive_count > 0);
+		src->sensitive_count--;
+		dst->sensitive_count++;
+	}
+	if (_is_thread_bursty(thread_info)) {
+		assert(src->bursty_count > 0);
+		src->bursty_count--;
+		dst->bursty_count++;
+	}
+
 	thread_info->lcore = dst_core;
 }
 
+/* In power aware mode, threads are packed onto cores until they're almost fully busy, so that the
+ * remaining cores can be put to sleep. */
+static uint8_t
+_get_core_limit(void)
+{
+	return g_scheduler_power_aware ? g_scheduler_core_busy : g_scheduler_core_limit;
+}
+
 static bool
 _is_core_at_limit(uint32_t core_id)
 {
@@ -133,7 +272,7 @@ _is_core_at_limit(uint32_t core_id)
 	}
 
 	/* Work done was less than the limit */
-	if (_busy_pct(busy, idle) < g_scheduler_core_limit) {
+	if (_busy_pct(busy, idle) < _get_core_limit()) {
 		return false;
 	}
 
@@ -151,6 +290,11 @@ _can_core_fit_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t ds
 		return true;
 	}
 
+	if (_has_latency_conflict(thread_info, dst_core) ||
+	    _has_numa_conflict(thread_info, dst_core)) {
+		return false;
+	}
+
 	/* Reactors in interrupt mode do not update stats,
 	 * a thread can always fit into reactor in interrupt mode. */
 	if (dst->busy + dst->idle == 0) {
@@ -172,7 +316,7 @@ _can_core_fit_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t ds
 
 	/* Core cannot fit this thread if it would put it over the
 	 * g_scheduler_core_limit. */
-	return _busy_pct(new_busy_tsc, new_idle_tsc) < g_scheduler_core_limit;
+	return _busy_pct(new_busy_tsc, new_idle_tsc) < _get_core_limit();
 }
 
 static uint32_t
@@ -183,7 +327,9 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 	uint32_t least_busy_lcore = thread_info->lcore;
 	struct spdk_thread *thread;
 	struct spdk_cpuset *cpumask;
-	bool core_at_limit = _is_core_at_limit(current_lcore);
+	bool core_at_limit = _is_core_at_limit(current_lcore) ||
+			     _has_latency_conflict(thread_info, current_lcore) ||
+			     _has_numa_conflict(thread_info, current_lcore);
 
 	thread = spdk_thread_get_by_id(thread_info->thread_id);
 	if (thread == NULL) {
@@ -199,7 +345,9 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 		}
 
 		/* Search for least busy core. */
-		if (g_cores[i].busy < g_cores[least_busy_lcore].busy) {
+		if (g_cores[i].busy < g_cores[least_busy_lcore].busy &&
+		    !_has_latency_conflict(thread_info, i) &&
+		    !_has_numa_conflict(thread_info, i)) {
 			least_busy_lcore = i;
 		}
 
@@ -263,7 +411,13 @@ deinit(void)
 static void
 _balance_idle(struct spdk_scheduler_thread_info *thread_info)
 {
-	if (_get_thread_load(thread_info) >= g_scheduler_load_limit) {
+	/* Bursty threads are balanced like active ones regardless of their load. */
+	if (_get_thread_load(thread_info) >= g_scheduler_load_limit ||
+	    _is_thread_bursty(thread_info)) {
+		return;
+	}
+	if (_has_latency_conflict(thread_info, g_main_lcore) ||
+	    _has_numa_conflict(thread_info, g_main_lcore)) {
 		return;
 	}
 	/* This thread is idle, move it to the main core. */
@@ -275,7 +429,12 @@ _balance_active(struct spdk_scheduler_thread_info *thread_info)
 {
 	uint32_t target_lcore;
 
-	if (_get_thread_load(thread_info) < g_scheduler_load_limit) {
+	/* Idle threads are only moved if they can't share their core because of latency or are
+	 * away from their preferred socket. */
+	if (_get_thread_load(thread_info) < g_scheduler_load_limit &&
+	    !_is_thread_bursty(thread_info) &&
+	    !_has_latency_conflict(thread_info, thread_info->lcore) &&
+	    !_has_numa_conflict(thread_info, thread_info->lcore)) {
 		return;
 	}
 
@@ -284,6 +443,98 @@ _balance_active(struct spdk_scheduler_thread_info *thread_info)
 	_move_thread(thread_info, target_lcore);
 }
 
+/* Lower the frequency of the least busy cores until the sum of the frequencies of the cores
+ * still polling fits within g_scheduler_power_cap percent of the sum of maximum frequencies of
+ * all cores.  Cores in interrupt mode are assumed to be in deep C-states, not drawing power. */
+static void
+_enforce_power_cap(struct spdk_governor *governor)
+{
+	struct spdk_governor_capabilities capabilities;
+	uint64_t budget = 0, used = 0;
+	uint32_t i, core_id, freq;
+	int rc;
+
+	if (g_scheduler_power_cap == 0 || governor->get_core_curr_freq == NULL) {
+		return;
+	}
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		memset(&capabilities, 0, sizeof(capabilities));
+		rc = governor->get_core_capabilities(i, &capabilities);
+		if (rc != 0 || capabilities.max_freq == 0) {
+			SPDK_ERRLOG("Unable to get maximum frequency of core %u\n", i);
+			return;
+		}
+		budget += capabilities.max_freq;
+		if (g_cores[i].thread_count != 0) {
+			used += governor->get_core_curr_freq(i);
+		}
+	}
+	budget = budget * g_scheduler_power_cap / 100;
+
+	while (used > budget) {
+		core_id = UINT32_MAX;
+		SPDK_ENV_FOREACH_CORE(i) {
+			if (g_cores[i].thread_count == 0 || g_cores[i].at_min_freq) {
+				continue;
+			}
+			if (core_id == UINT32_MAX || g_cores[i].busy < g_cores[core_id].busy) {
+				core_id = i;
+			}
+		}
+		if (core_id == UINT32_MAX) {
+			SPDK_NOTICELOG("Unable to fit within the power cap of %u%%\n",
+				       g_scheduler_power_cap);
+			break;
+		}
+
+		freq = governor->get_core_curr_freq(core_id);
+		rc = governor->core_freq_down(core_id);
+		if (rc <= 0) {
+			g_cores[core_id].at_min_freq = true;
+			continue;
+		}
+		used -= spdk_min(used, freq - spdk_min(freq, governor->get_core_curr_freq(core_id)));
+	}
+}
+
+/* Drive the loaded cores at high frequency and the vacated ones at the lowest, leaving the
+ * turbo headroom to the cores doing the work. */
+static void
+_balance_power(struct spdk_governor *governor)
+{
+	struct core_stats *core;
+	uint32_t i;
+	int rc;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		core = &g_cores[i];
+		if (core->thread_count == 0) {
+			rc = governor->set_core_freq_min(i);
+			if (rc < 0) {
+				SPDK_ERRLOG("setting minimal frequency for core %u failed\n", i);
+			}
+		} else if (_busy_pct(core->busy, core->idle) >= g_scheduler_core_limit) {
+			rc = governor->set_core_freq_max(i);
+			if (rc < 0) {
+				SPDK_ERRLOG("setting default frequency for core %u failed\n", i);
+			}
+		} else if (core->busy > core->idle) {
+			rc = governor->core_freq_up(i);
+			if (rc < 0) {
+				SPDK_ERRLOG("increasing frequency for core %u failed\n", i);
+			}
+		} else {
+			rc = governor->core_freq_down(i);
+			if (rc < 0) {
+				SPDK_ERRLOG("lowering frequency for core %u failed\n", i);
+			}
+		}
+	}
+
+	_enforce_power_cap(governor);
+}
+
 static void
 balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 {
@@ -301,10 +552,15 @@ balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 		g_cores[i].thread_count = cores_info[i].threads_count;
 		g_cores[i].busy = cores_info[i].current_busy_tsc;
 		g_cores[i].idle = cores_info[i].current_idle_tsc;
+		g_cores[i].sensitive_count = 0;
+		g_cores[i].bursty_count = 0;
+		g_cores[i].at_min_freq = false;
 		SPDK_DTRACE_PROBE2(dynsched_core_info, i, &cores_info[i]);
 	}
 	main_core = &g_cores[g_main_lcore];
 
+	_foreach_thread(cores_info, _count_latency_thread);
+
 	/* Distribute threads in two passes, to make sure updated core stats are considered on each pass.
 	 * 1) Move all idle threads to main core. */
 	_foreach_thread(cores_info, _balance_idle);
@@ -336,6 +592,11 @@ balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 		return;
 	}
 
+	if (g_scheduler_power_aware) {
+		_balance_power(governor);
+		return;
+	}
+
 	/* Change main core frequency if needed */
 	if (busy_threads_present) {
 		rc = governor->set_core_freq_max(g_main_lcore);
@@ -359,12 +620,26 @@ struct json_scheduler_opts {
 	uint8_t load_limit;
 	uint8_t core_limit;
 	uint8_t core_busy;
+	bool latency_aware;
+	uint32_t burst_limit;
+	uint32_t msg_rate_limit;
+	bool power_aware;
+	uint8_t power_cap;
+	bool numa_aware;
+	uint8_t numa_cross_limit;
 };
 
 static const struct spdk_json_object_decoder sched_decoders[] = {
 	{"load_limit", offsetof(struct json_scheduler_opts, load_limit), spdk_json_decode_uint8, true},
 	{"core_limit", offsetof(struct json_scheduler_opts, core_limit), spdk_json_decode_uint8, true},
 	{"core_busy", offsetof(struct json_scheduler_opts, core_busy), spdk_json_decode_uint8, true},
+	{"latency_aware", offsetof(struct json_scheduler_opts, latency_aware), spdk_json_decode_bool, true},
+	{"burst_limit", offsetof(struct json_scheduler_opts, burst_limit), spdk_json_decode_uint32, true},
+	{"msg_rate_limit", offsetof(struct json_scheduler_opts, msg_rate_limit), spdk_json_decode_uint32, true},
+	{"power_aware", offsetof(struct json_scheduler_opts, power_aware), spdk_json_decode_bool, true},
+	{"power_cap", offsetof(struct json_scheduler_opts, power_cap), spdk_json_decode_uint8, true},
+	{"numa_aware", offsetof(struct json_scheduler_opts, numa_aware), spdk_json_decode_bool, true},
+	{"numa_cross_limit", offsetof(struct json_scheduler_opts, numa_cross_limit), spdk_json_decode_uint8, true},
 };
 
 static int
@@ -375,6 +650,13 @@ set_opts(const struct spdk_json_val *opts)
 	scheduler_opts.load_limit = g_scheduler_load_limit;
 	scheduler_opts.core_limit = g_scheduler_core_limit;
 	scheduler_opts.core_busy = g_scheduler_core_busy;
+	scheduler_opts.latency_aware = g_scheduler_latency_aware;
+	scheduler_opts.burst_limit = g_scheduler_burst_limit;
+	scheduler_opts.msg_rate_limit = g_scheduler_msg_rate_limit;
+	scheduler_opts.power_aware = g_scheduler_power_aware;
+	scheduler_opts.power_cap = g_scheduler_power_cap;
+	scheduler_opts.numa_aware = g_scheduler_numa_aware;
+	scheduler_opts.numa_cross_limit = g_scheduler_numa_cross_limit;
 
 	if (opts != NULL) {
 		if (spdk_json_decode_object_relaxed(opts, sched_decoders,
@@ -384,12 +666,43 @@ set_opts(const struct spdk_json_val *opts)
 		}
 	}
 
+	if (scheduler_opts.power_cap > 100) {
+		SPDK_ERRLOG("Power cap has to be a percentage, got %u\n", scheduler_opts.power_cap);
+		return -1;
+	}
+
+	if (scheduler_opts.numa_cross_limit > 100) {
+		SPDK_ERRLOG("NUMA cross limit has to be a percentage, got %u\n",
+			    scheduler_opts.numa_cross_limit);
+		return -1;
+	}
+
 	SPDK_NOTICELOG("Setting scheduler load limit to %d\n", scheduler_opts.load_limit);
 	g_scheduler_load_limit = scheduler_opts.load_limit;
 	SPDK_NOTICELOG("Setting scheduler core limit to %d\n", scheduler_opts.core_limit);
 	g_scheduler_core_limit = scheduler_opts.core_limit;
 	SPDK_NOTICELOG("Setting scheduler core busy to %d\n", scheduler_opts.core_busy);
 	g_scheduler_core_busy = scheduler_opts.core_busy;
+	SPDK_NOTICELOG("Setting scheduler latency aware mode to %s\n",
+		       scheduler_opts.latency_aware ? "enabled" : "disabled");
+	g_scheduler_latency_aware = scheduler_opts.latency_aware;
+	SPDK_NOTICELOG("Setting scheduler burst limit to %" PRIu32 " us\n",
+		       scheduler_opts.burst_limit);
+	g_scheduler_burst_limit = scheduler_opts.burst_limit;
+	SPDK_NOTICELOG("Setting scheduler message rate limit to %" PRIu32 "\n",
+		       scheduler_opts.msg_rate_limit);
+	g_scheduler_msg_rate_limit = scheduler_opts.msg_rate_limit;
+	SPDK_NOTICELOG("Setting scheduler power aware mode to %s\n",
+		       scheduler_opts.power_aware ? "enabled" : "disabled");
+	g_scheduler_power_aware = scheduler_opts.power_aware;
+	SPDK_NOTICELOG("Setting scheduler power cap to %u%%\n", scheduler_opts.power_cap);
+	g_scheduler_power_cap = scheduler_opts.power_cap;
+	SPDK_NOTICELOG("Setting scheduler NUMA aware mode to %s\n",
+		       scheduler_opts.numa_aware ? "enabled" : "disabled");
+	g_scheduler_numa_aware = scheduler_opts.numa_aware;
+	SPDK_NOTICELOG("Setting scheduler NUMA cross limit to %u%%\n",
+		       scheduler_opts.numa_cross_limit);
+	g_scheduler_numa_cross_limit = scheduler_opts.numa_cross_limit;
 
 	return 0;
 }
@@ -400,6 +713,13 @@ get_opts(struct spdk_json_write_ctx *ctx)
 	spdk_json_write_named_uint8(ctx, "load_limit", g_scheduler_load_limit);
 	spdk_json_write_named_uint8(ctx, "core_limit", g_scheduler_core_limit);
 	spdk_json_write_named_uint8(ctx, "core_busy", g_scheduler_core_busy);
+	spdk_json_write_named_bool(ctx, "latency_aware", g_scheduler_latency_aware);
+	spdk_json_write_named_uint32(ctx, "burst_limit", g_scheduler_burst_limit);
+	spdk_json_write_named_uint32(ctx, "msg_rate_limit", g_scheduler_msg_rate_limit);
+	spdk_json_write_named_bool(ctx, "power_aware", g_scheduler_power_aware);
+	spdk_json_write_named_uint8(ctx, "power_cap", g_scheduler_power_cap);
+	spdk_json_write_named_bool(ctx, "numa_aware", g_scheduler_numa_aware);
+	spdk_json_write_named_uint8(ctx, "numa_cross_limit", g_scheduler_numa_cross_limit);
 }
 
 static struct spdk_scheduler scheduler_dynamic = {
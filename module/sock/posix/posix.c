@@ -55,6 +55,10 @@ struct spdk_posix_sock {
 
 	SSL_CTX			*ctx;
 	SSL			*ssl;
+	/* Set once the handshake is done and the kernel took over the TLS records */
+	bool			ktls_checked;
+	bool			ktls_send;
+	bool			ktls_recv;
 
 	TAILQ_ENTRY(spdk_posix_sock)	link;
 };
@@ -84,7 +88,9 @@ static struct spdk_sock_impl_opts g_posix_impl_opts = {
 	.psk_identity = NULL,
 	.get_key = NULL,
 	.get_key_ctx = NULL,
-	.tls_cipher_suites = NULL
+	.tls_cipher_suites = NULL,
+	.busy_poll_usecs = 0,
+	.busy_poll_budget = 0
 };
 
 static struct spdk_sock_impl_opts g_ssl_impl_opts = {
@@ -99,7 +105,9 @@ static struct spdk_sock_impl_opts g_ssl_impl_opts = {
 	.tls_version = 0,
 	.enable_ktls = false,
 	.psk_key = NULL,
-	.psk_identity = NULL
+	.psk_identity = NULL,
+	.busy_poll_usecs = 0,
+	.busy_poll_budget = 0
 };
 
 static struct spdk_sock_map g_map = {
@@ -145,6 +153,8 @@ posix_sock_copy_impl_opts(struct spdk_sock_impl_opts *dest, const struct spdk_so
 	SET_FIELD(get_key);
 	SET_FIELD(get_key_ctx);
 	SET_FIELD(tls_cipher_suites);
+	SET_FIELD(busy_poll_usecs);
+	SET_FIELD(busy_poll_budget);
 
 #undef SET_FIELD
 #undef FIELD_OK
@@ -458,6 +468,7 @@ posix_sock_init(struct spdk_posix_sock *sock, bool enable_zero_copy)
 
 	spdk_sock_get_placement_id(sock->fd, sock->base.impl_opts.enable_placement_id,
 				   &sock->placement_id);
+	spdk_sock_set_busy_poll(sock->fd, &sock->base.impl_opts);
 
 	if (sock->base.impl_opts.enable_placement_id == PLACEMENT_MARK) {
 		/* Save placement_id */
@@ -936,6 +947,86 @@ SSL_writev(SSL *ssl, struct iovec *iov, int iovcnt)
 	}
 }
 
+static void
+posix_sock_check_ktls(struct spdk_posix_sock *sock)
+{
+	if (spdk_likely(sock->ktls_checked) || !SSL_is_init_finished(sock->ssl)) {
+		return;
+	}
+
+	sock->ktls_checked = true;
+	sock->ktls_send = BIO_get_ktls_send(SSL_get_wbio(sock->ssl));
+	sock->ktls_recv = BIO_get_ktls_recv(SSL_get_rbio(sock->ssl));
+	SPDK_DEBUGLOG(sock_posix, "kTLS on sock %p: send %s, receive %s\n", sock,
+		      sock->ktls_send ? "enabled" : "disabled", sock->ktls_recv ? "enabled" : "disabled");
+}
+
+/*
+ * Once the kernel (or the NIC) handles the TLS records, the application data is read and written
+ * directly on the socket, so that a whole iovec goes into a single system call instead of one
+ * SSL_read()/SSL_write() per element.  OpenSSL is only used when it still has some state pending,
+ * or for the records that are not application data, which make readv() fail with EIO.
+ */
+static ssize_t
+posix_sock_ssl_readv(struct spdk_posix_sock *sock, struct iovec *iov, int iovcnt)
+{
+	ssize_t rc;
+
+	posix_sock_check_ktls(sock);
+	if (sock->ktls_recv && SSL_want_nothing(sock->ssl) && !SSL_has_pending(sock->ssl)) {
+		rc = readv(sock->fd, iov, iovcnt);
+		if (rc > 0 && sock->base.group_impl != NULL) {
+			sock->base.group_impl->stats.ktls_bytes_received += rc;
+		}
+		if (rc >= 0 || errno != EIO) {
+			return rc;
+		}
+	}
+
+	return SSL_readv(sock->ssl, iov, iovcnt);
+}
+
+/* Read from the socket itself, bypassing the receive pipe */
+static ssize_t
+posix_sock_readv_fd(struct spdk_posix_sock *sock, struct iovec *iov, int iovcnt)
+{
+	ssize_t rc;
+
+	if (sock->ssl) {
+		rc = posix_sock_ssl_readv(sock, iov, iovcnt);
+	} else {
+		rc = readv(sock->fd, iov, iovcnt);
+	}
+
+	if (rc > 0 && sock->base.group_impl != NULL) {
+		sock->base.group_impl->stats.recv_calls++;
+		sock->base.group_impl->stats.bytes_received += rc;
+	}
+
+	return rc;
+}
+
+static ssize_t
+posix_sock_ssl_writev(struct spdk_posix_sock *sock, struct iovec *iov, int iovcnt, int flags)
+{
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = iovcnt,
+	};
+	ssize_t rc;
+
+	posix_sock_check_ktls(sock);
+	if (sock->ktls_send && SSL_want_nothing(sock->ssl)) {
+		rc = sendmsg(sock->fd, &msg, flags);
+		if (rc > 0 && sock->base.group_impl != NULL) {
+			sock->base.group_impl->stats.ktls_bytes_sent += rc;
+		}
+		return rc;
+	}
+
+	return SSL_writev(sock->ssl, iov, iovcnt);
+}
+
 static struct spdk_sock *
 posix_sock_create(const char *ip, int port,
 		  enum posix_sock_create_type type,
@@ -1231,9 +1322,6 @@ _sock_check_zcopy(struct spdk_sock *sock)
 	ssize_t rc;
 	struct sock_extended_err *serr;
 	struct cmsghdr *cm;
-	uint32_t idx;
-	struct spdk_sock_request *req, *treq;
-	bool found;
 
 	msgh.msg_control = buf;
 	msgh.msg_controllen = sizeof(buf);
@@ -1268,43 +1356,14 @@ _sock_check_zcopy(struct spdk_sock *sock)
 			return 0;
 		}
 
-		/* Most of the time, the pending_reqs array is in the exact
-		 * order we need such that all of the requests to complete are
-		 * in order, in the front. It is guaranteed that all requests
-		 * belonging to the same sendmsg call are sequential, so once
-		 * we encounter one match we can stop looping as soon as a
-		 * non-match is found.
-		 */
-		idx = serr->ee_info;
-		while (true) {
-			found = false;
-			TAILQ_FOREACH_SAFE(req, &sock->pending_reqs, internal.link, treq) {
-				if (!req->internal.is_zcopy) {
-					/* This wasn't a zcopy request. It was just waiting in line to complete */
-					rc = spdk_sock_request_put(sock, req, 0);
-					if (rc < 0) {
-						return rc;
-					}
-				} else if (req->internal.offset == idx) {
-					found = true;
-					rc = spdk_sock_request_put(sock, req, 0);
-					if (rc < 0) {
-						return rc;
-					}
-				} else if (found) {
-					break;
-				}
-			}
-
-			if (idx == serr->ee_data) {
-				break;
-			}
+		rc = spdk_sock_complete_zcopy_reqs(sock, serr->ee_info, serr->ee_data);
+		if (rc < 0) {
+			return rc;
+		}
 
-			if (idx == UINT32_MAX) {
-				idx = 0;
-			} else {
-				idx++;
-			}
+		if (sock->group_impl != NULL) {
+			sock->group_impl->stats.zcopy_notifications++;
+			sock->group_impl->stats.zcopy_completed_reqs += rc;
 		}
 	}
 
@@ -1357,7 +1416,7 @@ _sock_flush(struct spdk_sock *sock)
 	msg.msg_iovlen = iovcnt;
 
 	if (psock->ssl) {
-		rc = SSL_writev(psock->ssl, iovs, iovcnt);
+		rc = posix_sock_ssl_writev(psock, iovs, iovcnt, flags);
 	} else {
 		rc = sendmsg(psock->fd, &msg, flags);
 	}
@@ -1370,6 +1429,11 @@ _sock_flush(struct spdk_sock *sock)
 
 	sent = rc;
 
+	if (sock->group_impl != NULL) {
+		sock->group_impl->stats.send_calls++;
+		sock->group_impl->stats.bytes_sent += sent;
+	}
+
 	if (is_zcopy) {
 		/* Handling overflow case, because we use psock->sendmsg_idx - 1 for the
 		 * req->internal.offset, so sendmsg_idx should not be zero  */
@@ -1505,11 +1569,7 @@ posix_sock_read(struct spdk_posix_sock *sock)
 		return bytes_avail;
 	}
 
-	if (sock->ssl) {
-		bytes_recvd = SSL_readv(sock->ssl, iov, 2);
-	} else {
-		bytes_recvd = readv(sock->fd, iov, 2);
-	}
+	bytes_recvd = posix_sock_readv_fd(sock, iov, 2);
 
 	assert(sock->pipe_has_data == false);
 
@@ -1556,11 +1616,7 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 			sock->socket_has_data = false;
 			TAILQ_REMOVE(&group->socks_with_data, sock, link);
 		}
-		if (sock->ssl) {
-			return SSL_readv(sock->ssl, iov, iovcnt);
-		} else {
-			return readv(sock->fd, iov, iovcnt);
-		}
+		return posix_sock_readv_fd(sock, iov, iovcnt);
 	}
 
 	/* If the socket is not in a group, we must assume it always has
@@ -1575,11 +1631,7 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 
 		if (len >= MIN_SOCK_PIPE_SIZE) {
 			/* TODO: Should this detect if kernel socket is drained? */
-			if (sock->ssl) {
-				return SSL_readv(sock->ssl, iov, iovcnt);
-			} else {
-				return readv(sock->fd, iov, iovcnt);
-			}
+			return posix_sock_readv_fd(sock, iov, iovcnt);
 		}
 
 		/* Otherwise, do a big read into our pipe */
@@ -1623,7 +1675,7 @@ posix_sock_writev(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 	}
 
 	if (sock->ssl) {
-		return SSL_writev(sock->ssl, iov, iovcnt);
+		return posix_sock_ssl_writev(sock, iov, iovcnt, MSG_NOSIGNAL);
 	} else {
 		return writev(sock->fd, iov, iovcnt);
 	}
@@ -50,6 +50,26 @@ enum uring_task_type {
 /* We use 1 just so it's not zero and we can validate it's right. */
 #define URING_BUF_GROUP_ID 1
 
+/* Multishot receive keeps a single recv armed on each socket, which posts a completion for every
+ * buffer it fills until it runs out of buffers, instead of being resubmitted after each one. */
+#ifdef IORING_RECV_MULTISHOT
+#define URING_RECV_MULTISHOT
+#endif
+
+/* With IORING_OP_SENDMSG_ZC, the kernel posts the notification that the buffers of a zero copy
+ * send can be reused as a second completion of the send itself, so the error queue doesn't need
+ * to be polled. */
+#if defined(SPDK_ZEROCOPY) && defined(IORING_CQE_F_NOTIF)
+#define URING_SENDMSG_ZC
+
+/* Maximum number of zero copy sends per group waiting for their notification */
+#define URING_ZC_NOTIF_POOL_SIZE 1024
+
+/* Set in the user_data of zero copy sends, which point to their notification tracker instead of
+ * the write task. */
+#define URING_ZC_NOTIF_TAG 1ULL
+#endif
+
 enum spdk_uring_sock_task_status {
 	SPDK_URING_SOCK_TASK_NOT_IN_USE = 0,
 	SPDK_URING_SOCK_TASK_IN_PROCESS,
@@ -64,6 +84,9 @@ struct spdk_uring_task {
 	int					iov_cnt;
 	struct spdk_sock_request		*last_req;
 	bool					is_zcopy;
+#ifdef URING_SENDMSG_ZC
+	struct spdk_uring_zc_notif		*zc_notif;
+#endif
 	STAILQ_ENTRY(spdk_uring_task)		link;
 };
 
@@ -88,6 +111,8 @@ struct spdk_uring_sock {
 	int					connection_status;
 	int					placement_id;
 	uint8_t					buf[SPDK_SOCK_CMG_INFO_SIZE];
+	/* Number of zero copy sends still waiting for their notification */
+	uint32_t				zc_notifs_pending;
 	TAILQ_ENTRY(spdk_uring_sock)		link;
 };
 
@@ -102,6 +127,18 @@ struct spdk_uring_buf_tracker {
 	STAILQ_ENTRY(spdk_uring_buf_tracker)	link;
 };
 
+#ifdef URING_SENDMSG_ZC
+/* Tracks a zero copy send until the kernel notifies that its buffers were released */
+struct spdk_uring_zc_notif {
+	/* NULL if the socket left the group before the notification came */
+	struct spdk_uring_sock			*sock;
+	uint32_t				sendmsg_idx;
+	/* Cleared if the send failed, so there are no requests to complete */
+	bool					valid;
+	STAILQ_ENTRY(spdk_uring_zc_notif)	link;
+};
+#endif
+
 struct spdk_uring_sock_group_impl {
 	struct spdk_sock_group_impl		base;
 	struct io_uring				uring;
@@ -114,6 +151,14 @@ struct spdk_uring_sock_group_impl {
 	uint32_t				buf_ring_count;
 	struct spdk_uring_buf_tracker		*trackers;
 	STAILQ_HEAD(, spdk_uring_buf_tracker)	free_trackers;
+	/* Cleared if the kernel turns out not to support multishot receive */
+	bool					recv_multishot;
+#ifdef URING_SENDMSG_ZC
+	/* Cleared if the kernel turns out not to support IORING_OP_SENDMSG_ZC */
+	bool					sendmsg_zc;
+	struct spdk_uring_zc_notif		*zc_notifs;
+	STAILQ_HEAD(, spdk_uring_zc_notif)	free_zc_notifs;
+#endif
 };
 
 static struct spdk_sock_impl_opts g_spdk_uring_sock_impl_opts = {
@@ -128,7 +173,9 @@ static struct spdk_sock_impl_opts g_spdk_uring_sock_impl_opts = {
 	.tls_version = 0,
 	.enable_ktls = false,
 	.psk_key = NULL,
-	.psk_identity = NULL
+	.psk_identity = NULL,
+	.busy_poll_usecs = 0,
+	.busy_poll_budget = 0
 };
 
 static struct spdk_sock_map g_map = {
@@ -171,6 +218,8 @@ uring_sock_copy_impl_opts(struct spdk_sock_impl_opts *dest, const struct spdk_so
 	SET_FIELD(enable_ktls);
 	SET_FIELD(psk_key);
 	SET_FIELD(psk_identity);
+	SET_FIELD(busy_poll_usecs);
+	SET_FIELD(busy_poll_budget);
 
 #undef SET_FIELD
 #undef FIELD_OK
@@ -458,6 +507,7 @@ uring_sock_alloc(int fd, struct spdk_sock_impl_opts *impl_opts, bool enable_zero
 
 	spdk_sock_get_placement_id(sock->fd, sock->base.impl_opts.enable_placement_id,
 				   &sock->placement_id);
+	spdk_sock_set_busy_poll(sock->fd, &sock->base.impl_opts);
 #ifdef SPDK_ZEROCOPY
 	/* Try to turn on zero copy sends */
 	flag = 1;
@@ -794,14 +844,21 @@ uring_sock_recv_from_pipe(struct spdk_uring_sock *sock, struct iovec *diov, int
 }
 
 static inline ssize_t
-sock_readv(int fd, struct iovec *iov, int iovcnt)
+sock_readv(struct spdk_uring_sock *sock, struct iovec *iov, int iovcnt)
 {
 	struct msghdr msg = {
 		.msg_iov = iov,
 		.msg_iovlen = iovcnt,
 	};
+	ssize_t rc;
+
+	rc = recvmsg(sock->fd, &msg, MSG_DONTWAIT);
+	if (rc > 0 && sock->base.group_impl != NULL) {
+		sock->base.group_impl->stats.recv_calls++;
+		sock->base.group_impl->stats.bytes_received += rc;
+	}
 
-	return recvmsg(fd, &msg, MSG_DONTWAIT);
+	return rc;
 }
 
 static inline ssize_t
@@ -814,7 +871,7 @@ uring_sock_read(struct spdk_uring_sock *sock)
 	bytes = spdk_pipe_writer_get_buffer(sock->recv_pipe, sock->recv_buf_sz, iov);
 
 	if (bytes > 0) {
-		bytes = sock_readv(sock->fd, iov, 2);
+		bytes = sock_readv(sock, iov, 2);
 		if (bytes > 0) {
 			spdk_pipe_writer_advance(sock->recv_pipe, bytes);
 			if (sock->base.group_impl && !sock->pending_recv) {
@@ -892,7 +949,7 @@ uring_sock_readv_no_pipe(struct spdk_sock *_sock, struct iovec *iovs, int iovcnt
 
 	if (_sock->group_impl == NULL) {
 		/* If not in a group just read from the socket the regular way. */
-		return sock_readv(sock->fd, iovs, iovcnt);
+		return sock_readv(sock, iovs, iovcnt);
 	}
 
 	if (STAILQ_EMPTY(&sock->recv_stream)) {
@@ -905,7 +962,7 @@ uring_sock_readv_no_pipe(struct spdk_sock *_sock, struct iovec *iovs, int iovcnt
 				TAILQ_REMOVE(&(__uring_group_impl(_sock->group_impl))->pending_recv, sock, link);
 			}
 
-			return sock_readv(sock->fd, iovs, iovcnt);
+			return sock_readv(sock, iovs, iovcnt);
 		}
 
 		errno = EAGAIN;
@@ -978,7 +1035,7 @@ uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 		/* If the user is receiving a sufficiently large amount of data,
 		 * receive directly to their buffers. */
 		if (len >= MIN_SOCK_PIPE_SIZE) {
-			return sock_readv(sock->fd, iov, iovcnt);
+			return sock_readv(sock, iov, iovcnt);
 		}
 
 		/* Otherwise, do a big read into our pipe */
@@ -1057,6 +1114,11 @@ sock_complete_write_reqs(struct spdk_sock *_sock, ssize_t rc, bool is_zcopy)
 	struct spdk_sock_request *req;
 	int retval;
 
+	if (_sock->group_impl != NULL) {
+		_sock->group_impl->stats.send_calls++;
+		_sock->group_impl->stats.bytes_sent += rc;
+	}
+
 	if (is_zcopy) {
 		/* Handling overflow case, because we use psock->sendmsg_idx - 1 for the
 		 * req->internal.offset, so sendmsg_idx should not be zero */
@@ -1112,9 +1174,6 @@ _sock_check_zcopy(struct spdk_sock *_sock, int status)
 	ssize_t rc;
 	struct sock_extended_err *serr;
 	struct cmsghdr *cm;
-	uint32_t idx;
-	struct spdk_sock_request *req, *treq;
-	bool found;
 
 	assert(sock->zcopy == true);
 	if (spdk_unlikely(status) < 0) {
@@ -1140,32 +1199,14 @@ _sock_check_zcopy(struct spdk_sock *_sock, int status)
 		return 0;
 	}
 
-	/* Most of the time, the pending_reqs array is in the exact
-	 * order we need such that all of the requests to complete are
-	 * in order, in the front. It is guaranteed that all requests
-	 * belonging to the same sendmsg call are sequential, so once
-	 * we encounter one match we can stop looping as soon as a
-	 * non-match is found.
-	 */
-	for (idx = serr->ee_info; idx <= serr->ee_data; idx++) {
-		found = false;
-		TAILQ_FOREACH_SAFE(req, &_sock->pending_reqs, internal.link, treq) {
-			if (!req->internal.is_zcopy) {
-				/* This wasn't a zcopy request. It was just waiting in line to complete */
-				rc = spdk_sock_request_put(_sock, req, 0);
-				if (rc < 0) {
-					return rc;
-				}
-			} else if (req->internal.offset == idx) {
-				found = true;
-				rc = spdk_sock_request_put(_sock, req, 0);
-				if (rc < 0) {
-					return rc;
-				}
-			} else if (found) {
-				break;
-			}
-		}
+	rc = spdk_sock_complete_zcopy_reqs(_sock, serr->ee_info, serr->ee_data);
+	if (rc < 0) {
+		return rc;
+	}
+
+	if (_sock->group_impl != NULL) {
+		_sock->group_impl->stats.zcopy_notifications++;
+		_sock->group_impl->stats.zcopy_completed_reqs += rc;
 	}
 
 	return 0;
@@ -1197,6 +1238,63 @@ _sock_prep_errqueue(struct spdk_sock *_sock)
 
 #endif
 
+#ifdef URING_SENDMSG_ZC
+static inline void *
+uring_zc_notif_user_data(struct spdk_uring_zc_notif *notif)
+{
+	return (void *)((uintptr_t)notif | URING_ZC_NOTIF_TAG);
+}
+
+static void
+uring_zc_notif_put(struct spdk_uring_sock_group_impl *group, struct spdk_uring_zc_notif *notif)
+{
+	if (notif->sock != NULL) {
+		assert(notif->sock->zc_notifs_pending > 0);
+		notif->sock->zc_notifs_pending--;
+	}
+
+	notif->sock = NULL;
+	STAILQ_INSERT_HEAD(&group->free_zc_notifs, notif, link);
+}
+
+static void
+uring_zc_notif_complete(struct spdk_uring_sock_group_impl *group,
+			struct spdk_uring_zc_notif *notif)
+{
+	struct spdk_sock *_sock;
+	int rc;
+
+	if (notif->sock != NULL && notif->valid) {
+		_sock = &notif->sock->base;
+		rc = spdk_sock_complete_zcopy_reqs(_sock, notif->sendmsg_idx, notif->sendmsg_idx);
+		if (rc > 0) {
+			group->base.stats.zcopy_notifications++;
+			group->base.stats.zcopy_completed_reqs += rc;
+		}
+	}
+
+	uring_zc_notif_put(group, notif);
+}
+
+static void
+uring_sock_group_disable_sendmsg_zc(struct spdk_uring_sock_group_impl *group)
+{
+	struct spdk_uring_sock *sock;
+	struct spdk_sock *_sock;
+
+	SPDK_NOTICELOG("IORING_OP_SENDMSG_ZC is not supported, polling the error queue instead\n");
+	group->sendmsg_zc = false;
+
+	/* The zero copy notifications of the sockets now come through their error queue */
+	TAILQ_FOREACH(_sock, &group->base.socks, link) {
+		sock = __uring_sock(_sock);
+		if (sock->zcopy) {
+			_sock_prep_errqueue(_sock);
+		}
+	}
+}
+#endif
+
 static void
 _sock_flush(struct spdk_sock *_sock)
 {
@@ -1234,6 +1332,32 @@ _sock_flush(struct spdk_sock *_sock)
 	sock->group->io_queued++;
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
+#ifdef URING_SENDMSG_ZC
+	if (task->is_zcopy && sock->group->sendmsg_zc) {
+		struct spdk_uring_zc_notif *notif;
+
+		notif = STAILQ_FIRST(&sock->group->free_zc_notifs);
+		if (spdk_likely(notif != NULL)) {
+			STAILQ_REMOVE_HEAD(&sock->group->free_zc_notifs, link);
+			notif->sock = sock;
+			notif->valid = true;
+			/* The index sock_complete_write_reqs() gives to the requests of this send */
+			notif->sendmsg_idx = sock->sendmsg_idx == UINT32_MAX ? 0 : sock->sendmsg_idx;
+			sock->zc_notifs_pending++;
+			task->zc_notif = notif;
+
+			io_uring_prep_sendmsg_zc(sqe, sock->fd, &sock->write_task.msg,
+						 flags & ~MSG_ZEROCOPY);
+			io_uring_sqe_set_data(sqe, uring_zc_notif_user_data(notif));
+			task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
+			return;
+		}
+
+		/* Too many notifications outstanding, copy the data instead */
+		task->is_zcopy = false;
+		flags &= ~MSG_ZEROCOPY;
+	}
+#endif
 	io_uring_prep_sendmsg(sqe, sock->fd, &sock->write_task.msg, flags);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
@@ -1259,7 +1383,16 @@ _sock_prep_read(struct spdk_sock *_sock)
 	sock->group->io_queued++;
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
+#ifdef URING_RECV_MULTISHOT
+	if (sock->group->recv_multishot) {
+		/* The size of each receive is given by the provided buffer it lands in */
+		io_uring_prep_recv_multishot(sqe, sock->fd, NULL, 0, 0);
+	} else {
+		io_uring_prep_recv(sqe, sock->fd, NULL, URING_MAX_RECV_SIZE, 0);
+	}
+#else
 	io_uring_prep_recv(sqe, sock->fd, NULL, URING_MAX_RECV_SIZE, 0);
+#endif
 	sqe->buf_group = URING_BUF_GROUP_ID;
 	sqe->flags |= IOSQE_BUFFER_SELECT;
 	io_uring_sqe_set_data(sqe, task);
@@ -1311,10 +1444,15 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 	struct io_uring_cqe *cqe;
 	struct spdk_uring_sock *sock, *tmp;
 	struct spdk_uring_task *task;
+#ifdef URING_SENDMSG_ZC
+	struct spdk_uring_zc_notif *notif;
+#endif
 	int status, bid, flags;
 	bool is_zcopy;
 
-	for (i = 0; i < max; i++) {
+	/* Only the final completion of a task counts against max, a multishot receive may post any
+	 * number of completions before that. */
+	for (i = 0; i < max;) {
 		ret = io_uring_peek_cqe(&group->uring, &cqe);
 		if (ret != 0) {
 			break;
@@ -1324,23 +1462,57 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 			break;
 		}
 
-		task = (struct spdk_uring_task *)cqe->user_data;
+#ifdef URING_SENDMSG_ZC
+		if (cqe->user_data & URING_ZC_NOTIF_TAG) {
+			notif = (struct spdk_uring_zc_notif *)(uintptr_t)(cqe->user_data &
+					~URING_ZC_NOTIF_TAG);
+			if (cqe->flags & IORING_CQE_F_NOTIF) {
+				/* The buffers of the send are released, this ends the send */
+				io_uring_cqe_seen(&group->uring, cqe);
+				group->io_inflight--;
+				group->io_avail++;
+				i++;
+				uring_zc_notif_complete(group, notif);
+				continue;
+			}
+
+			/* This is the result of the send itself */
+			assert(notif->sock != NULL);
+			task = &notif->sock->write_task;
+			assert(task->zc_notif == notif);
+		} else
+#endif
+			task = (struct spdk_uring_task *)cqe->user_data;
 		assert(task != NULL);
 		sock = task->sock;
 		assert(sock != NULL);
 		assert(sock->group != NULL);
 		assert(sock->group == group);
-		sock->group->io_inflight--;
-		sock->group->io_avail++;
 		status = cqe->res;
 		flags = cqe->flags;
 		io_uring_cqe_seen(&group->uring, cqe);
 
-		task->status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+		/* A multishot receive stays armed as long as the kernel says there's more to
+		 * come.  A zero copy send is over once its notification comes, but the write
+		 * task can be reused right away. */
+		if (!(flags & IORING_CQE_F_MORE)) {
+			sock->group->io_inflight--;
+			sock->group->io_avail++;
+			task->status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+			i++;
+		} else if (task->type != URING_TASK_READ) {
+			task->status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+		}
 
 		switch (task->type) {
 		case URING_TASK_READ:
-			if (status == -EAGAIN || status == -EWOULDBLOCK) {
+			if (spdk_unlikely(status == -EINVAL && group->recv_multishot)) {
+				/* The kernel doesn't know about multishot receive, fall back to
+				 * resubmitting a single receive after each completion. */
+				SPDK_NOTICELOG("Multishot receive is not supported, disabling it\n");
+				group->recv_multishot = false;
+				_sock_prep_read(&sock->base);
+			} else if (status == -EAGAIN || status == -EWOULDBLOCK) {
 				/* This likely shouldn't happen, but would indicate that the
 				 * kernel didn't have enough resources to queue a task internally. */
 				_sock_prep_read(&sock->base);
@@ -1369,6 +1541,9 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 				assert(tracker->buf != NULL);
 				assert(tracker->len != 0);
 
+				sock->base.group_impl->stats.recv_calls++;
+				sock->base.group_impl->stats.bytes_received += status;
+
 				/* Append this data to the stream */
 				tracker->len = status;
 				STAILQ_INSERT_TAIL(&sock->recv_stream, tracker, link);
@@ -1385,6 +1560,32 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 			}
 			break;
 		case URING_TASK_WRITE:
+#ifdef URING_SENDMSG_ZC
+			notif = task->zc_notif;
+			if (notif != NULL) {
+				task->zc_notif = NULL;
+				if (status <= 0) {
+					/* Nothing was sent, so the notification has nothing
+					 * to complete */
+					notif->valid = false;
+				}
+				if (!(flags & IORING_CQE_F_MORE)) {
+					/* No notification follows */
+					notif->valid = false;
+					uring_zc_notif_put(group, notif);
+					if (status > 0) {
+						/* The data was copied after all */
+						task->is_zcopy = false;
+					}
+				}
+				if (spdk_unlikely(status == -EINVAL && group->sendmsg_zc)) {
+					/* The requests are still queued and will be resent without
+					 * IORING_OP_SENDMSG_ZC */
+					uring_sock_group_disable_sendmsg_zc(group);
+					continue;
+				}
+			}
+#endif
 			if (status == -EAGAIN || status == -EWOULDBLOCK ||
 			    (status == -ENOBUFS && sock->zcopy) ||
 			    status == -ECANCELED) {
@@ -1676,6 +1877,28 @@ uring_sock_group_impl_buf_pool_alloc(struct spdk_uring_sock_group_impl *group_im
 	return 0;
 }
 
+#ifdef URING_SENDMSG_ZC
+static int
+uring_sock_group_impl_zc_notifs_alloc(struct spdk_uring_sock_group_impl *group_impl)
+{
+	int i;
+
+	group_impl->zc_notifs = calloc(URING_ZC_NOTIF_POOL_SIZE, sizeof(struct spdk_uring_zc_notif));
+	if (group_impl->zc_notifs == NULL) {
+		return -ENOMEM;
+	}
+
+	STAILQ_INIT(&group_impl->free_zc_notifs);
+	for (i = 0; i < URING_ZC_NOTIF_POOL_SIZE; i++) {
+		STAILQ_INSERT_TAIL(&group_impl->free_zc_notifs, &group_impl->zc_notifs[i], link);
+	}
+
+	group_impl->sendmsg_zc = true;
+
+	return 0;
+}
+#endif
+
 static struct spdk_sock_group_impl *
 uring_sock_group_impl_create(void)
 {
@@ -1696,6 +1919,9 @@ uring_sock_group_impl_create(void)
 	}
 
 	TAILQ_INIT(&group_impl->pending_recv);
+#ifdef URING_RECV_MULTISHOT
+	group_impl->recv_multishot = true;
+#endif
 
 	if (uring_sock_group_impl_buf_pool_alloc(group_impl) < 0) {
 		SPDK_ERRLOG("Failed to create buffer ring. Your kernel is likely not new enough. "
@@ -1705,6 +1931,30 @@ uring_sock_group_impl_create(void)
 		return NULL;
 	}
 
+#ifdef IORING_REGISTER_NAPI
+	if (g_spdk_uring_sock_impl_opts.busy_poll_usecs != 0) {
+		struct io_uring_napi napi = {
+			.busy_poll_to = g_spdk_uring_sock_impl_opts.busy_poll_usecs,
+			.prefer_busy_poll = 1,
+		};
+
+		/* Let the ring busy poll the NAPI contexts of its sockets when reaping */
+		if (io_uring_register_napi(&group_impl->uring, &napi) != 0) {
+			SPDK_NOTICELOG("io_uring NAPI busy polling is not supported\n");
+		}
+	}
+#endif
+
+#ifdef URING_SENDMSG_ZC
+	if (uring_sock_group_impl_zc_notifs_alloc(group_impl) != 0) {
+		SPDK_ERRLOG("Failed to allocate the zero copy notifications\n");
+		uring_sock_group_impl_buf_pool_free(group_impl);
+		io_uring_queue_exit(&group_impl->uring);
+		free(group_impl);
+		return NULL;
+	}
+#endif
+
 	if (g_spdk_uring_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
 		spdk_sock_map_insert(&g_map, spdk_env_get_current_core(), &group_impl->base);
 	}
@@ -1754,7 +2004,11 @@ uring_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group,
 	/* We get an async read going immediately */
 	_sock_prep_read(&sock->base);
 #ifdef SPDK_ZEROCOPY
+#ifdef URING_SENDMSG_ZC
+	if (sock->zcopy && !group->sendmsg_zc) {
+#else
 	if (sock->zcopy) {
+#endif
 		_sock_prep_errqueue(_sock);
 	}
 #endif
@@ -1855,7 +2109,14 @@ uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 	sock->pending_group_remove = true;
 
 	if (sock->write_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
-		_sock_prep_cancel_task(_sock, &sock->write_task);
+#ifdef URING_SENDMSG_ZC
+		struct spdk_uring_zc_notif *notif = sock->write_task.zc_notif;
+
+		if (notif != NULL) {
+			_sock_prep_cancel_task(_sock, uring_zc_notif_user_data(notif));
+		} else
+#endif
+			_sock_prep_cancel_task(_sock, &sock->write_task);
 		/* Since spdk_sock_group_remove_sock is not asynchronous interface, so
 		 * currently can use a while loop here. */
 		while ((sock->write_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) ||
@@ -1900,6 +2161,22 @@ uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 	 * to that so we couldn't release it. */
 	assert(STAILQ_EMPTY(&sock->recv_stream));
 
+#ifdef URING_SENDMSG_ZC
+	/* The notifications may take as long as the peer takes to acknowledge the data, so don't
+	 * wait for them.  The requests still waiting on them are aborted when the socket is closed,
+	 * just like with the error queue. */
+	if (sock->zc_notifs_pending > 0) {
+		uint32_t i;
+
+		for (i = 0; i < URING_ZC_NOTIF_POOL_SIZE; i++) {
+			if (group->zc_notifs[i].sock == sock) {
+				group->zc_notifs[i].sock = NULL;
+			}
+		}
+		sock->zc_notifs_pending = 0;
+	}
+#endif
+
 	if (sock->placement_id != -1) {
 		spdk_sock_map_release(&g_map, sock->placement_id);
 	}
@@ -1922,6 +2199,9 @@ uring_sock_group_impl_close(struct spdk_sock_group_impl *_group)
 	assert(group->io_avail == SPDK_SOCK_GROUP_QUEUE_DEPTH);
 
 	uring_sock_group_impl_buf_pool_free(group);
+#ifdef URING_SENDMSG_ZC
+	free(group->zc_notifs);
+#endif
 
 	io_uring_queue_exit(&group->uring);
 
@@ -1958,6 +2238,13 @@ uring_sock_flush(struct spdk_sock *_sock)
 		return -1;
 	}
 
+#ifdef URING_SENDMSG_ZC
+	/* The error queue isn't polled when the group gets its notifications from io_uring */
+	if (sock->group != NULL && sock->group->sendmsg_zc) {
+		flags &= ~MSG_ZEROCOPY;
+	}
+#endif
+
 	/* Gather an iov */
 	iovcnt = spdk_sock_prep_reqs(_sock, iovs, 0, NULL, &flags);
 	if (iovcnt == 0) {
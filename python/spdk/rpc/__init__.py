@@ -20,6 +20,7 @@ from . import ioat
 from . import iscsi
 from . import log
 from . import lvol
+from . import metrics
 from . import nbd
 from . import ublk
 from . import notify
@@ -33,6 +34,7 @@ from . import sock
 from . import vfio_user
 from . import iobuf
 from . import dpdk_cryptodev
+from . import ipsec_mb
 from . import mlx5
 from . import client as rpc_client
 
@@ -34,6 +34,31 @@ def accel_assign_opc(client, opname, module):
     return client.call('accel_assign_opc', params)
 
 
+def accel_assign_opc_route(client, opname, small_module=None, small_threshold=None,
+                           spill_module=None, spill_qd=None):
+    """Route some of the operations of an opcode to other modules.
+
+    Args:
+        opname: name of operation
+        small_module: name of module executing operations smaller than small_threshold (optional)
+        small_threshold: size (in bytes) below which operations are sent to small_module (optional)
+        spill_module: name of module executing operations once the assigned module's queue is full (optional)
+        spill_qd: number of outstanding operations on the assigned module above which operations are sent to spill_module (optional)
+    """
+    params = {'opname': opname}
+
+    if small_module is not None:
+        params['small_module'] = small_module
+    if small_threshold is not None:
+        params['small_threshold'] = small_threshold
+    if spill_module is not None:
+        params['spill_module'] = spill_module
+    if spill_qd is not None:
+        params['spill_qd'] = spill_qd
+
+    return client.call('accel_assign_opc_route', params)
+
+
 def accel_crypto_key_create(client, cipher, key, key2, tweak_mode, name):
     """Create Data Encryption Key Identifier.
 
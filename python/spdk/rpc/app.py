@@ -38,12 +38,21 @@ def framework_get_reactors(client):
 
 
 def framework_set_scheduler(client, name, period=None, load_limit=None, core_limit=None,
-                            core_busy=None):
+                            core_busy=None, latency_aware=None, burst_limit=None,
+                            msg_rate_limit=None, power_aware=None, power_cap=None,
+                            numa_aware=None, numa_cross_limit=None):
     """Select threads scheduler that will be activated and its period.
 
     Args:
         name: Name of a scheduler
         period: Scheduler period in microseconds
+        latency_aware: Keep latency sensitive threads apart (dynamic only)
+        burst_limit: Busy run length in microseconds above which a thread is bursty (dynamic only)
+        msg_rate_limit: Message rate per second above which a thread is bursty (dynamic only)
+        power_aware: Pack threads onto fewer cores and manage their frequency (dynamic only)
+        power_cap: Limit of the polling cores' frequencies in % of the maximum (dynamic only)
+        numa_aware: Keep threads on cores of their preferred socket (dynamic only)
+        numa_cross_limit: Load in % of a socket's cores allowing threads to leave it (dynamic only)
     Returns:
         True or False
     """
@@ -56,6 +65,20 @@ def framework_set_scheduler(client, name, period=None, load_limit=None, core_lim
         params['core_limit'] = core_limit
     if core_busy is not None:
         params['core_busy'] = core_busy
+    if latency_aware is not None:
+        params['latency_aware'] = latency_aware
+    if burst_limit is not None:
+        params['burst_limit'] = burst_limit
+    if msg_rate_limit is not None:
+        params['msg_rate_limit'] = msg_rate_limit
+    if power_aware is not None:
+        params['power_aware'] = power_aware
+    if power_cap is not None:
+        params['power_cap'] = power_cap
+    if numa_aware is not None:
+        params['numa_aware'] = numa_aware
+    if numa_cross_limit is not None:
+        params['numa_cross_limit'] = numa_cross_limit
     return client.call('framework_set_scheduler', params)
 
 
@@ -68,6 +91,16 @@ def framework_get_scheduler(client):
     return client.call('framework_get_scheduler')
 
 
+def framework_set_interrupt_spin_time(client, spin_time_us):
+    """Set the time reactors in interrupt mode spin before going to sleep.
+
+    Args:
+        spin_time_us: spin time in microseconds, 0 to disable spinning
+    """
+    params = {'spin_time_us': spin_time_us}
+    return client.call('framework_set_interrupt_spin_time', params)
+
+
 def thread_get_stats(client):
     """Query threads statistics.
 
@@ -113,6 +146,19 @@ def thread_get_pollers(client):
     return client.call('thread_get_pollers')
 
 
+def thread_set_poller_timing(client, histograms, watchdog_threshold_us=None):
+    """Enable measuring the execution time of pollers.
+
+    Args:
+        histograms: collect a histogram of the execution time of each poller
+        watchdog_threshold_us: log a warning when a poller runs longer than this (optional)
+    """
+    params = {'histograms': histograms}
+    if watchdog_threshold_us is not None:
+        params['watchdog_threshold_us'] = watchdog_threshold_us
+    return client.call('thread_set_poller_timing', params)
+
+
 def thread_get_io_channels(client):
     """Query current IO channels.
 
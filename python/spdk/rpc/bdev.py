@@ -5,13 +5,15 @@
 
 
 def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None,
-                     bdev_auto_examine=None):
+                     bdev_auto_examine=None, qos_distributed=None, examine_max_in_progress=None):
     """Set parameters for the bdev subsystem.
 
     Args:
         bdev_io_pool_size: number of bdev_io structures in shared buffer pool (optional)
         bdev_io_cache_size: maximum number of bdev_io structures cached per thread (optional)
         bdev_auto_examine: if set to false, the bdev layer will not examine every disks automatically (optional)
+        qos_distributed: if set to true, rate limited I/O is submitted on the thread of the channel (optional)
+        examine_max_in_progress: maximum number of bdevs examined at the same time by each bdev module, 0 for no limit (optional)
     """
     params = {}
 
@@ -21,6 +23,10 @@ def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None,
         params['bdev_io_cache_size'] = bdev_io_cache_size
     if bdev_auto_examine is not None:
         params["bdev_auto_examine"] = bdev_auto_examine
+    if qos_distributed is not None:
+        params["qos_distributed"] = qos_distributed
+    if examine_max_in_progress is not None:
+        params["examine_max_in_progress"] = examine_max_in_progress
     return client.call('bdev_set_options', params)
 
 
@@ -43,18 +49,27 @@ def bdev_wait_for_examine(client):
     return client.call('bdev_wait_for_examine')
 
 
-def bdev_compress_create(client, base_bdev_name, pm_path, lb_size):
+def bdev_get_examine_stats(client):
+    """Get examine statistics of the bdev modules
+    """
+    return client.call('bdev_get_examine_stats')
+
+
+def bdev_compress_create(client, base_bdev_name, pm_path=None, lb_size=None):
     """Construct a compress virtual block device.
 
     Args:
         base_bdev_name: name of the underlying base bdev
-        pm_path: path to persistent memory
+        pm_path: path to persistent memory (optional, metadata is stored on the base bdev if not set)
         lb_size: logical block size for the compressed vol in bytes.  Must be 4K or 512.
 
     Returns:
         Name of created virtual block device.
     """
-    params = {'base_bdev_name': base_bdev_name, 'pm_path': pm_path}
+    params = {'base_bdev_name': base_bdev_name}
+
+    if pm_path:
+        params['pm_path'] = pm_path
 
     if lb_size:
         params['lb_size'] = lb_size
@@ -277,7 +292,8 @@ def bdev_ocf_flush_status(client, name):
 
 
 def bdev_malloc_create(client, num_blocks, block_size, physical_block_size=None, name=None, uuid=None, optimal_io_boundary=None,
-                       md_size=None, md_interleave=None, dif_type=None, dif_is_head_of_md=None):
+                       md_size=None, md_interleave=None, dif_type=None, dif_is_head_of_md=None, numa_node=None,
+                       numa_interleave=None, inline_copy_threshold=None):
     """Construct a malloc block device.
 
     Args:
@@ -291,6 +307,9 @@ def bdev_malloc_create(client, num_blocks, block_size, physical_block_size=None,
         md_interleave: metadata location, interleaved if set, and separated if omitted (optional)
         dif_type: protection information type (optional)
         dif_is_head_of_md: protection information is in the first 8 bytes of metadata (optional)
+        numa_node: NUMA node to allocate the buffer on (optional)
+        numa_interleave: stripe the buffer across the NUMA nodes of the application (optional)
+        inline_copy_threshold: copy reads and writes up to this size without accel, default 0 (disabled, optional)
 
     Returns:
         Name of created block device.
@@ -312,6 +331,12 @@ def bdev_malloc_create(client, num_blocks, block_size, physical_block_size=None,
         params['dif_type'] = dif_type
     if dif_is_head_of_md:
         params['dif_is_head_of_md'] = dif_is_head_of_md
+    if numa_node is not None:
+        params['numa_node'] = numa_node
+    if numa_interleave:
+        params['numa_interleave'] = numa_interleave
+    if inline_copy_threshold is not None:
+        params['inline_copy_threshold'] = inline_copy_threshold
 
     return client.call('bdev_malloc_create', params)
 
@@ -327,7 +352,7 @@ def bdev_malloc_delete(client, name):
 
 
 def bdev_null_create(client, num_blocks, block_size, name, physical_block_size=None, uuid=None, md_size=None,
-                     dif_type=None, dif_is_head_of_md=None):
+                     dif_type=None, dif_is_head_of_md=None, model=None):
     """Construct a null block device.
 
     Args:
@@ -339,6 +364,8 @@ def bdev_null_create(client, num_blocks, block_size, name, physical_block_size=N
         md_size: metadata size of device (optional)
         dif_type: protection information type (optional)
         dif_is_head_of_md: protection information is in the first 8 bytes of metadata (optional)
+        model: map describing the emulated device: num_channels, bandwidth_mbps, read_latency_us,
+        write_latency_us, read_p99_latency_us, write_p99_latency_us, qd_latency_ns and histogram (optional)
 
     Returns:
         Name of created block device.
@@ -355,6 +382,8 @@ def bdev_null_create(client, num_blocks, block_size, name, physical_block_size=N
         params['dif_type'] = dif_type
     if dif_is_head_of_md:
         params['dif_is_head_of_md'] = dif_is_head_of_md
+    if model:
+        params['model'] = model
     return client.call('bdev_null_create', params)
 
 
@@ -395,16 +424,18 @@ def bdev_raid_get_bdevs(client, category):
     return client.call('bdev_raid_get_bdevs', params)
 
 
-def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size=None, strip_size_kb=None, uuid=None):
+def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size=None, strip_size_kb=None, uuid=None,
+                     read_policy=None):
     """Create raid bdev. Either strip size arg will work but one is required.
 
     Args:
         name: user defined raid bdev name
         strip_size (deprecated): strip size of raid bdev in KB, supported values like 8, 16, 32, 64, 128, 256, etc
         strip_size_kb: strip size of raid bdev in KB, supported values like 8, 16, 32, 64, 128, 256, etc
-        raid_level: raid level of raid bdev, supported values 0
+        raid_level: raid level of raid bdev, supported values 0, 1, 10, 5f, 6f and concat
         base_bdevs: Space separated names of Nvme bdevs in double quotes, like "Nvme0n1 Nvme1n1 Nvme2n1"
         uuid: UUID for this raid bdev (optional)
+        read_policy: read balancing policy: round_robin, least_outstanding or lba_shard (raid1 and raid10 only, optional)
 
     Returns:
         None
@@ -420,6 +451,9 @@ def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size=None, stri
     if uuid:
         params['uuid'] = uuid
 
+    if read_policy:
+        params['read_policy'] = read_policy
+
     return client.call('bdev_raid_create', params)
 
 
@@ -449,6 +483,41 @@ def bdev_raid_remove_base_bdev(client, name):
     return client.call('bdev_raid_remove_base_bdev', params)
 
 
+def bdev_raid_add_base_bdev(client, base_bdev, raid_bdev):
+    """Add base bdev to existing raid bdev
+
+    Args:
+        base_bdev: base bdev name
+        raid_bdev: raid bdev name
+
+    Returns:
+        None
+    """
+    params = {'base_bdev': base_bdev, 'raid_bdev': raid_bdev}
+    return client.call('bdev_raid_add_base_bdev', params)
+
+
+def bdev_raid_set_options(client, process_window_size_kb=None, process_max_bandwidth_mb_sec=None,
+                          stripe_cache_size=None):
+    """Set options for bdev raid.
+
+    Args:
+        process_window_size_kb: Background process (e.g. rebuild) window size in KiB (optional)
+        process_max_bandwidth_mb_sec: Background process bandwidth limit in MiB/s, 0 means unlimited (optional)
+        stripe_cache_size: Number of stripes cached by raid5f/raid6f bdevs for partial stripe writes, 0 disables (optional)
+    """
+    params = {}
+
+    if process_window_size_kb is not None:
+        params['process_window_size_kb'] = process_window_size_kb
+    if process_max_bandwidth_mb_sec is not None:
+        params['process_max_bandwidth_mb_sec'] = process_max_bandwidth_mb_sec
+    if stripe_cache_size is not None:
+        params['stripe_cache_size'] = stripe_cache_size
+
+    return client.call('bdev_raid_set_options', params)
+
+
 def bdev_aio_create(client, filename, name, block_size=None, readonly=False):
     """Construct a Linux AIO block device.
 
@@ -493,6 +562,30 @@ def bdev_aio_delete(client, name):
     return client.call('bdev_aio_delete', params)
 
 
+def bdev_uring_set_options(client, sqpoll=None, sqpoll_idle_ms=None, fixed_files=None,
+                           fixed_buffers=None):
+    """Set options for the uring bdev module.
+
+    Args:
+        sqpoll: use a kernel thread to poll the submission queue (optional)
+        sqpoll_idle_ms: idle time of the polling thread before it sleeps, in milliseconds (optional)
+        fixed_files: register the files of the uring bdevs with the rings (optional)
+        fixed_buffers: register the iobuf pools with the rings as fixed buffers (optional)
+    """
+    params = {}
+
+    if sqpoll is not None:
+        params['sqpoll'] = sqpoll
+    if sqpoll_idle_ms is not None:
+        params['sqpoll_idle_ms'] = sqpoll_idle_ms
+    if fixed_files is not None:
+        params['fixed_files'] = fixed_files
+    if fixed_buffers is not None:
+        params['fixed_buffers'] = fixed_buffers
+
+    return client.call('bdev_uring_set_options', params)
+
+
 def bdev_uring_create(client, filename, name, block_size=None):
     """Create a bdev with Linux io_uring backend.
 
@@ -563,7 +656,10 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
                           delay_cmd_submit=None, transport_retry_count=None, bdev_retry_count=None,
                           transport_ack_timeout=None, ctrlr_loss_timeout_sec=None, reconnect_delay_sec=None,
                           fast_io_fail_timeout_sec=None, disable_auto_failback=None, generate_uuids=None,
-                          transport_tos=None, nvme_error_stat=None, rdma_srq_size=None, io_path_stat=None):
+                          transport_tos=None, nvme_error_stat=None, rdma_srq_size=None, io_path_stat=None,
+                          io_queue_connections=None, tcp_zcopy_recv=None, latency_histograms=None,
+                          io_path_failover_count=None, io_path_error_threshold=None,
+                          discovery_attach_max_concurrency=None):
     """Set options for the bdev nvme. This is startup command.
 
     Args:
@@ -608,6 +704,12 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
         nvme_error_stat: Enable collecting NVMe error counts. (optional)
         rdma_srq_size: Set the size of a shared rdma receive queue. Default: 0 (disabled) (optional)
         io_path_stat: Enable collection I/O path stat of each io path. (optional)
+        io_queue_connections: The number of connections each I/O queue of an NVMe-oF controller is striped across. Default: 1 (optional)
+        tcp_zcopy_recv: Receive the data of TCP I/O queues directly into the I/O buffers, bypassing the socket receive pipe. (optional)
+        latency_histograms: Track the latency of the I/O completed by each I/O queue in per namespace histograms. (optional)
+        io_path_failover_count: The number of times an I/O failing with a path error is resubmitted to another I/O path right away. Default: 0 (optional)
+        io_path_error_threshold: The number of path errors in a row after which an I/O path is not selected for a while. Default: 0 (disabled) (optional)
+        discovery_attach_max_concurrency: The number of subsystems found by a discovery service that are attached in parallel. 0 means unlimited. Default: 32 (optional)
 
     """
     params = {}
@@ -688,6 +790,24 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
     if io_path_stat is not None:
         params['io_path_stat'] = io_path_stat
 
+    if io_queue_connections is not None:
+        params['io_queue_connections'] = io_queue_connections
+
+    if tcp_zcopy_recv is not None:
+        params['tcp_zcopy_recv'] = tcp_zcopy_recv
+
+    if latency_histograms is not None:
+        params['latency_histograms'] = latency_histograms
+
+    if io_path_failover_count is not None:
+        params['io_path_failover_count'] = io_path_failover_count
+
+    if io_path_error_threshold is not None:
+        params['io_path_error_threshold'] = io_path_error_threshold
+
+    if discovery_attach_max_concurrency is not None:
+        params['discovery_attach_max_concurrency'] = discovery_attach_max_concurrency
+
     return client.call('bdev_nvme_set_options', params)
 
 
@@ -711,7 +831,8 @@ def bdev_nvme_attach_controller(client, name, trtype, traddr, adrfam=None, trsvc
                                 hostsvcid=None, prchk_reftag=None, prchk_guard=None,
                                 hdgst=None, ddgst=None, fabrics_timeout=None, multipath=None, num_io_queues=None,
                                 ctrlr_loss_timeout_sec=None, reconnect_delay_sec=None,
-                                fast_io_fail_timeout_sec=None, psk=None, max_bdevs=None):
+                                fast_io_fail_timeout_sec=None, psk=None, max_bdevs=None,
+                                io_queue_depth_limit=None, io_target_latency_us=None):
     """Construct block device for each NVMe namespace in the attached controller.
 
     Args:
@@ -748,6 +869,10 @@ def bdev_nvme_attach_controller(client, name, trtype, traddr, adrfam=None, trsvc
         ctrlr_loss_timeout_sec if ctrlr_loss_timeout_sec is not -1. (optional)
         psk: Set PSK file path and enable TCP SSL socket implementation (optional)
         max_bdevs: Size of the name array for newly created bdevs. Default is 128. (optional)
+        io_queue_depth_limit: Maximum number of outstanding I/Os on the controller, shared fairly
+        across I/O channels. 0 means no limit. (optional)
+        io_target_latency_us: Target I/O latency. If set, the queue depth limit is lowered while
+        the observed latency is above it and raised back otherwise. (optional)
 
     Returns:
         Names of created block devices.
@@ -813,6 +938,12 @@ def bdev_nvme_attach_controller(client, name, trtype, traddr, adrfam=None, trsvc
     if max_bdevs is not None:
         params['max_bdevs'] = max_bdevs
 
+    if io_queue_depth_limit is not None:
+        params['io_queue_depth_limit'] = io_queue_depth_limit
+
+    if io_target_latency_us is not None:
+        params['io_target_latency_us'] = io_target_latency_us
+
     return client.call('bdev_nvme_attach_controller', params)
 
 
@@ -1003,6 +1134,19 @@ def bdev_nvme_get_io_paths(client, name):
     return client.call('bdev_nvme_get_io_paths', params)
 
 
+def bdev_nvme_get_latency_histograms(client, name):
+    """Get the latency histograms of an NVMe bdev, measured in the NVMe driver
+
+    Args:
+        name: Name of the NVMe bdev
+
+    Returns:
+        Histograms of read, write and other commands
+    """
+    params = {'name': name}
+    return client.call('bdev_nvme_get_latency_histograms', params)
+
+
 def bdev_nvme_set_preferred_path(client, name, cntlid):
     """Set the preferred I/O path for an NVMe bdev when in multipath mode
 
@@ -1023,7 +1167,7 @@ def bdev_nvme_set_multipath_policy(client, name, policy, selector, rr_min_io):
     Args:
         name: NVMe bdev name
         policy: Multipath policy (active_passive or active_active)
-        selector: Multipath selector (round_robin, queue_depth)
+        selector: Multipath selector (round_robin, queue_depth, latency)
         rr_min_io: Number of IO to route to a path before switching to another one (optional)
     """
 
@@ -1158,7 +1302,8 @@ def bdev_rbd_get_clusters_info(client, name):
     return client.call('bdev_rbd_get_clusters_info', params)
 
 
-def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=None, config=None, cluster_name=None, uuid=None):
+def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=None, config=None, cluster_name=None, uuid=None,
+                    image_per_channel=None):
     """Create a Ceph RBD block device.
 
     Args:
@@ -1170,6 +1315,7 @@ def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=Non
         config: map of config keys to values (optional)
         cluster_name: Name to identify Rados cluster (optional)
         uuid: UUID of block device (optional)
+        image_per_channel: open the image separately for each I/O channel and poll its completions (optional)
 
     Returns:
         Name of created block device.
@@ -1192,6 +1338,8 @@ def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=Non
         print("WARNING:bdev_rbd_create should be used with specifying -c to have a cluster name after bdev_rbd_register_cluster.")
     if uuid is not None:
         params['uuid'] = uuid
+    if image_per_channel is not None:
+        params['image_per_channel'] = image_per_channel
 
     return client.call('bdev_rbd_create', params)
 
@@ -1373,6 +1521,101 @@ def bdev_passthru_delete(client, name):
     return client.call('bdev_passthru_delete', params)
 
 
+def bdev_cache_create(client, base_bdev_name, name, size_mb, line_size_kb=None, uuid=None):
+    """Construct a read cache block device.
+
+    Args:
+        base_bdev_name: name of the existing bdev
+        name: name of block device
+        size_mb: size of the memory used to cache data, in MiB
+        line_size_kb: size of a single cache line, in KiB (optional)
+        uuid: UUID of block device (optional)
+
+    Returns:
+        Name of created block device.
+    """
+    params = {
+        'base_bdev_name': base_bdev_name,
+        'name': name,
+        'size_mb': size_mb,
+    }
+    if line_size_kb is not None:
+        params['line_size_kb'] = line_size_kb
+    if uuid:
+        params['uuid'] = uuid
+    return client.call('bdev_cache_create', params)
+
+
+def bdev_cache_delete(client, name):
+    """Remove read cache bdev from the system.
+
+    Args:
+        name: name of read cache bdev to delete
+    """
+    params = {'name': name}
+    return client.call('bdev_cache_delete', params)
+
+
+def bdev_shm_export(client, name, bdev_name, num_queues=None, queue_depth=None, io_size=None):
+    """Export a bdev to other SPDK processes through shared memory.
+
+    Args:
+        name: name of the export
+        bdev_name: name of the bdev to export
+        num_queues: number of queue pairs, i.e. of consumer channels (optional)
+        queue_depth: number of slots of each queue pair, power of two (optional)
+        io_size: size of the data buffer of each slot, in bytes (optional)
+    """
+    params = {
+        'name': name,
+        'bdev_name': bdev_name,
+    }
+    if num_queues is not None:
+        params['num_queues'] = num_queues
+    if queue_depth is not None:
+        params['queue_depth'] = queue_depth
+    if io_size is not None:
+        params['io_size'] = io_size
+    return client.call('bdev_shm_export', params)
+
+
+def bdev_shm_unexport(client, name):
+    """Stop exporting a bdev through shared memory.
+
+    Args:
+        name: name of the export
+    """
+    params = {'name': name}
+    return client.call('bdev_shm_unexport', params)
+
+
+def bdev_shm_create(client, name, export_name):
+    """Construct a bdev from a bdev exported by another SPDK process.
+
+    Args:
+        name: name of block device
+        export_name: name of the export
+
+    Returns:
+        Name of created block device.
+    """
+    params = {
+        'name': name,
+        'export_name': export_name,
+    }
+    return client.call('bdev_shm_create', params)
+
+
+def bdev_shm_delete(client, name):
+    """Remove a shared memory bdev from the system.
+
+    Args:
+        name: name of shared memory bdev to delete
+    """
+    params = {'name': name}
+    return client.call('bdev_shm_delete', params)
+
+
 def bdev_opal_create(client, nvme_ctrlr_name, nsid, locking_range_id, range_start, range_length, password):
     """Create opal virtual block devices from a base nvme bdev.
 
@@ -1650,6 +1893,20 @@ def bdev_enable_histogram(client, name, enable):
     return client.call('bdev_enable_histogram', params)
 
 
+def bdev_set_io_merge(client, name, hold_us, max_size_kb=None):
+    """Set merging of adjacent reads and writes for specified bdev.
+
+    Args:
+        name: name of bdev
+        hold_us: maximum time in microseconds a request may be held to be merged (0 to disable)
+        max_size_kb: maximum size of a merged request in KiB (optional)
+    """
+    params = {'name': name, 'hold_us': hold_us}
+    if max_size_kb is not None:
+        params['max_size_kb'] = max_size_kb
+    return client.call('bdev_set_io_merge', params)
+
+
 def bdev_get_histogram(client, name):
     """Get histogram for specified bdev.
 
@@ -1660,6 +1917,26 @@ def bdev_get_histogram(client, name):
     return client.call('bdev_get_histogram', params)
 
 
+def bdev_get_split_histogram(client, name):
+    """Get histograms split by I/O type and size for specified bdev.
+
+    Args:
+        name: name of bdev
+    """
+    params = {'name': name}
+    return client.call('bdev_get_split_histogram', params)
+
+
+def bdev_reset_histogram(client, name):
+    """Reset histogram data collected for specified bdev.
+
+    Args:
+        name: name of bdev
+    """
+    params = {'name': name}
+    return client.call('bdev_reset_histogram', params)
+
+
 def bdev_error_inject_error(client, name, io_type, error_type, num,
                             queue_depth, corrupt_offset, corrupt_value):
     """Inject an error via an error bdev.
@@ -1734,6 +2011,100 @@ def bdev_set_qos_limit(
     return client.call('bdev_set_qos_limit', params)
 
 
+def bdev_qos_group_create(
+        client,
+        name,
+        rw_ios_per_sec=None,
+        rw_mbytes_per_sec=None,
+        r_mbytes_per_sec=None,
+        w_mbytes_per_sec=None,
+        burst_ms=None):
+    """Create a QoS group whose rate limits are shared by its block devices.
+
+    Args:
+        name: name of QoS group
+        rw_ios_per_sec: R/W IOs per second limit (>=1000, example: 20000). 0 means unlimited.
+        rw_mbytes_per_sec: R/W megabytes per second limit (>=10, example: 100). 0 means unlimited.
+        r_mbytes_per_sec: Read megabytes per second limit (>=10, example: 100). 0 means unlimited.
+        w_mbytes_per_sec: Write megabytes per second limit (>=10, example: 100). 0 means unlimited.
+        burst_ms: time in milliseconds for which unused rate accumulates (optional)
+    """
+    params = {}
+    params['name'] = name
+    if rw_ios_per_sec is not None:
+        params['rw_ios_per_sec'] = rw_ios_per_sec
+    if rw_mbytes_per_sec is not None:
+        params['rw_mbytes_per_sec'] = rw_mbytes_per_sec
+    if r_mbytes_per_sec is not None:
+        params['r_mbytes_per_sec'] = r_mbytes_per_sec
+    if w_mbytes_per_sec is not None:
+        params['w_mbytes_per_sec'] = w_mbytes_per_sec
+    if burst_ms is not None:
+        params['burst_ms'] = burst_ms
+    return client.call('bdev_qos_group_create', params)
+
+
+def bdev_qos_group_delete(client, name):
+    """Delete a QoS group.
+
+    Args:
+        name: name of QoS group
+    """
+    params = {'name': name}
+    return client.call('bdev_qos_group_delete', params)
+
+
+def bdev_qos_group_add_bdev(
+        client,
+        group_name,
+        name,
+        min_rw_ios_per_sec=None,
+        min_rw_mbytes_per_sec=None,
+        min_r_mbytes_per_sec=None,
+        min_w_mbytes_per_sec=None):
+    """Add a block device to a QoS group.
+
+    Args:
+        group_name: name of QoS group
+        name: name of block device
+        min_rw_ios_per_sec: R/W IOs per second guaranteed to the block device. 0 means no guarantee.
+        min_rw_mbytes_per_sec: R/W megabytes per second guaranteed to the block device. 0 means no guarantee.
+        min_r_mbytes_per_sec: Read megabytes per second guaranteed to the block device. 0 means no guarantee.
+        min_w_mbytes_per_sec: Write megabytes per second guaranteed to the block device. 0 means no guarantee.
+    """
+    params = {}
+    params['group_name'] = group_name
+    params['name'] = name
+    if min_rw_ios_per_sec is not None:
+        params['min_rw_ios_per_sec'] = min_rw_ios_per_sec
+    if min_rw_mbytes_per_sec is not None:
+        params['min_rw_mbytes_per_sec'] = min_rw_mbytes_per_sec
+    if min_r_mbytes_per_sec is not None:
+        params['min_r_mbytes_per_sec'] = min_r_mbytes_per_sec
+    if min_w_mbytes_per_sec is not None:
+        params['min_w_mbytes_per_sec'] = min_w_mbytes_per_sec
+    return client.call('bdev_qos_group_add_bdev', params)
+
+
+def bdev_qos_group_remove_bdev(client, name):
+    """Remove a block device from its QoS group.
+
+    Args:
+        name: name of block device
+    """
+    params = {'name': name}
+    return client.call('bdev_qos_group_remove_bdev', params)
+
+
+def bdev_get_qos_groups(client):
+    """Get the QoS groups.
+
+    Returns:
+        List of QoS groups with their rate limits and block devices.
+    """
+    return client.call('bdev_get_qos_groups')
+
+
 def bdev_nvme_apply_firmware(client, bdev_name, filename):
     """Download and commit firmware to NVMe device.
 
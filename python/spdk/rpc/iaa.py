@@ -6,7 +6,14 @@ from spdk.rpc.helpers import deprecated_alias
 
 
 @deprecated_alias('iaa_scan_accel_engine')
-def iaa_scan_accel_module(client):
+def iaa_scan_accel_module(client, huffman_mode=None):
     """Scan and enable IAA accel module.
+
+    Args:
+        huffman_mode: Huffman tables used for compression: fixed, dynamic or canned. (optional)
     """
-    return client.call('iaa_scan_accel_module')
+    params = {}
+
+    if huffman_mode is not None:
+        params['huffman_mode'] = huffman_mode
+    return client.call('iaa_scan_accel_module', params)
@@ -3,7 +3,8 @@
 #  All rights reserved.
 
 
-def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize):
+def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize,
+                      medium_pools=None):
     """Set iobuf pool options.
 
     Args:
@@ -11,6 +12,7 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         large_pool_count: number of large buffers in the global pool
         small_bufsize: size of a small buffer
         large_bufsize: size of a large buffer
+        medium_pools: list of {'count': ..., 'bufsize': ...} medium size classes (optional)
     """
     params = {}
 
@@ -22,5 +24,12 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         params['small_bufsize'] = small_bufsize
     if large_bufsize is not None:
         params['large_bufsize'] = large_bufsize
+    if medium_pools is not None:
+        params['medium_pools'] = medium_pools
 
     return client.call('iobuf_set_options', params)
+
+
+def iobuf_get_stats(client):
+    """Get iobuf pool statistics of each module."""
+    return client.call('iobuf_get_stats')
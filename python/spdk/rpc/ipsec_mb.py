@@ -0,0 +1,9 @@
+#  SPDX-License-Identifier: BSD-3-Clause
+#  Copyright (C) 2023 Intel Corporation.
+#  All rights reserved.
+
+
+def ipsec_mb_scan_accel_module(client):
+    """Enable intel-ipsec-mb accel module.
+    """
+    return client.call('ipsec_mb_scan_accel_module')
@@ -223,6 +223,87 @@ def bdev_lvol_decouple_parent(client, name):
     return client.call('bdev_lvol_decouple_parent', params)
 
 
+def bdev_lvol_merge_snapshot(client, name):
+    """Merge a snapshot into its clones and delete it.
+
+    Args:
+        name: name of the snapshot logical volume to merge
+    """
+    params = {
+        'name': name,
+    }
+    return client.call('bdev_lvol_merge_snapshot', params)
+
+
+def bdev_lvol_get_changed_extents(client, name, base_name=None, offset=None, max_extents=None):
+    """Get the extents of a logical volume that may differ from an older snapshot in its chain.
+
+    Args:
+        name: name of logical volume or snapshot
+        base_name: name of the older snapshot to compare with, all allocated extents if not set (optional)
+        offset: offset in bytes to start from (optional)
+        max_extents: maximum number of extents to return (optional)
+    """
+    params = {'name': name}
+    if base_name:
+        params['base_name'] = base_name
+    if offset is not None:
+        params['offset'] = offset
+    if max_extents is not None:
+        params['max_extents'] = max_extents
+    return client.call('bdev_lvol_get_changed_extents', params)
+
+
+def bdev_lvol_shallow_copy(client, src_lvol_name, dst_bdev_name, base_name=None, queue_depth=None):
+    """Copy the clusters of a read only logical volume to another bdev.
+
+    Args:
+        src_lvol_name: name of the read only logical volume, e.g. a snapshot
+        dst_bdev_name: name of the bdev to copy to
+        base_name: name of an older snapshot in the chain already copied to the bdev (optional)
+        queue_depth: maximum number of clusters copied in parallel (optional)
+    """
+    params = {
+        'src_lvol_name': src_lvol_name,
+        'dst_bdev_name': dst_bdev_name,
+    }
+    if base_name:
+        params['base_name'] = base_name
+    if queue_depth is not None:
+        params['queue_depth'] = queue_depth
+    return client.call('bdev_lvol_shallow_copy', params)
+
+
+def bdev_lvol_set_copy_rate_limit(client, clusters_per_sec, uuid=None, lvs_name=None):
+    """Limit the rate at which inflate, decouple and merge copy clusters.
+
+    Args:
+        clusters_per_sec: maximum number of clusters copied per second by each operation, 0 for no limit
+        uuid: UUID of logical volume store (optional)
+        lvs_name: name of logical volume store (optional)
+
+    Either uuid or lvs_name must be specified, but not both.
+    """
+    if (uuid and lvs_name) or (not uuid and not lvs_name):
+        raise ValueError("Exactly one of uuid or lvs_name must be specified")
+    params = {'clusters_per_sec': clusters_per_sec}
+    if uuid:
+        params['uuid'] = uuid
+    if lvs_name:
+        params['lvs_name'] = lvs_name
+    return client.call('bdev_lvol_set_copy_rate_limit', params)
+
+
+def bdev_lvol_set_esnap_cache_size(client, size_mib):
+    """Set the size of the cache of data read from external snapshots.
+
+    Args:
+        size_mib: size of the cache in MiB, 0 to disable caching
+    """
+    params = {'size_mib': size_mib}
+    return client.call('bdev_lvol_set_esnap_cache_size', params)
+
+
 def bdev_lvol_delete_lvstore(client, uuid=None, lvs_name=None):
     """Destroy a logical volume store.
 
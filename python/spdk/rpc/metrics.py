@@ -0,0 +1,20 @@
+#  SPDX-License-Identifier: BSD-3-Clause
+#  Copyright (C) 2023 Intel Corporation.
+#  All rights reserved.
+
+
+def metrics_enable_exporter(client, listen_address=None, listen_port=None):
+    """Enable the metrics and serve them in the OpenMetrics text format over HTTP.
+
+    Args:
+        listen_address: IP address to listen on (optional, default: 127.0.0.1)
+        listen_port: TCP port to listen on (optional, default: 9464)
+    """
+    params = {}
+
+    if listen_address is not None:
+        params['listen_address'] = listen_address
+    if listen_port is not None:
+        params['listen_port'] = listen_port
+
+    return client.call('metrics_enable_exporter', params)
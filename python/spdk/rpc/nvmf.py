@@ -114,15 +114,25 @@ def nvmf_create_transport(client, **params):
         num_cqe: The number of CQ entries to configure CQ size. Only used when no_srq=true - RDMA specific (optional)
         max_srq_depth: Max number of outstanding I/O per shared receive queue - RDMA specific (optional)
         no_srq: Boolean flag to disable SRQ even for devices that support it - RDMA specific (optional)
+        num_srqs: The number of shared receive queues per device in each poll group - RDMA specific (optional)
+        adaptive_srq_posting: Post receives to the SRQs based on the observed receive rate - RDMA specific (optional)
         c2h_success: Boolean flag to disable the C2H success optimization - TCP specific (optional)
         dif_insert_or_strip: Boolean flag to enable DIF insert/strip for I/O - TCP specific (optional)
         acceptor_backlog: Pending connections allowed at one time - RDMA specific (optional)
         abort_timeout_sec: Abort execution timeout value, in seconds (optional)
         no_wr_batching: Boolean flag to disable work requests batching - RDMA specific (optional)
         control_msg_num: The number of control messages per poll group - TCP specific (optional)
+        zero_copy_recv: Receive data directly into the I/O buffers, bypassing the socket receive pipe - TCP specific (optional)
+        digest_accel_threshold: Minimum PDU data size, in bytes, for which the data digest is offloaded to accel - TCP specific (optional)
+        numa_placement: Place new qpairs on poll groups local to the NUMA node of the network device - TCP specific (optional)
+        poll_group_load_threshold: Percentage of busy polls above which a poll group gets no new qpairs - TCP specific (optional)
+        icd_pool_size: The number of in-capsule data buffers shared by the qpairs of each poll group - TCP specific (optional)
+        icd_min_bufs_per_qpair: The number of in-capsule data buffers owned by each qpair when icd_pool_size is set - TCP specific (optional)
         disable_mappable_bar0: disable client mmap() of BAR0 - VFIO-USER specific (optional)
         disable_adaptive_irq: Disable adaptive interrupt feature - VFIO-USER specific (optional)
         disable_shadow_doorbells: disable shadow doorbell support - VFIO-USER specific (optional)
+        irq_coalescing_time_us: Maximum time an I/O completion may wait for its interrupt - VFIO-USER specific (optional)
+        irq_coalescing_threshold: Number of pending completions that trigger a coalesced interrupt - VFIO-USER specific (optional)
         acceptor_poll_rate: Acceptor poll period in microseconds (optional)
     Returns:
         True or False
@@ -358,7 +368,9 @@ def nvmf_subsystem_add_ns(client,
                           nguid=None,
                           eui64=None,
                           uuid=None,
-                          anagrpid=None):
+                          anagrpid=None,
+                          max_io_outstanding=None,
+                          latency_target_us=None):
     """Add a namespace to a subsystem.
 
     Args:
@@ -370,6 +382,8 @@ def nvmf_subsystem_add_ns(client,
         eui64: 8-byte namespace EUI-64 in hexadecimal (e.g. "ABCDEF0123456789") (optional).
         uuid: Namespace UUID (optional).
         anagrpid: ANA group ID (optional).
+        max_io_outstanding: Maximum number of I/O outstanding to the namespace on each poll group (optional).
+        latency_target_us: Target I/O latency of the namespace in microseconds (optional).
 
     Returns:
         The namespace ID
@@ -394,6 +408,12 @@ def nvmf_subsystem_add_ns(client,
     if anagrpid:
         ns['anagrpid'] = anagrpid
 
+    if max_io_outstanding:
+        ns['max_io_outstanding'] = max_io_outstanding
+
+    if latency_target_us:
+        ns['latency_target_us'] = latency_target_us
+
     params = {'nqn': nqn,
               'namespace': ns}
 
@@ -27,7 +27,9 @@ def sock_impl_set_options(client,
                           enable_zerocopy_send_client=None,
                           zerocopy_threshold=None,
                           tls_version=None,
-                          enable_ktls=None):
+                          enable_ktls=None,
+                          busy_poll_usecs=None,
+                          busy_poll_budget=None):
     """Set parameters for the socket layer implementation.
 
     Args:
@@ -42,6 +44,8 @@ def sock_impl_set_options(client,
         zerocopy_threshold: set zerocopy_threshold in bytes(optional)
         tls_version: set TLS protocol version (optional)
         enable_ktls: enable or disable Kernel TLS (optional)
+        busy_poll_usecs: set SO_BUSY_POLL in microseconds, 0 disables busy polling (optional)
+        busy_poll_budget: set SO_BUSY_POLL_BUDGET in packets, 0 keeps the kernel default (optional)
     """
     params = {}
 
@@ -66,6 +70,10 @@ def sock_impl_set_options(client,
         params['tls_version'] = tls_version
     if enable_ktls is not None:
         params['enable_ktls'] = enable_ktls
+    if busy_poll_usecs is not None:
+        params['busy_poll_usecs'] = busy_poll_usecs
+    if busy_poll_budget is not None:
+        params['busy_poll_budget'] = busy_poll_budget
 
     return client.call('sock_impl_set_options', params)
 
@@ -63,3 +63,26 @@ def trace_get_info(client):
         Name of shared memory file and list of the available trace point groups
     """
     return client.call('trace_get_info')
+
+
+def trace_set_sample_rate(client, rate):
+    """Only record the traces of 1 in rate objects.
+
+    Args:
+        rate: sampling rate, 0 or 1 disables sampling
+    """
+    params = {'rate': rate}
+    return client.call('trace_set_sample_rate', params)
+
+
+def trace_set_capture_trigger(client, latency_us, path=None):
+    """Capture the traces once a bdev I/O takes longer than latency_us to complete.
+
+    Args:
+        latency_us: latency threshold in microseconds, 0 disables the capture
+        path: prefix of the capture file names (optional if latency_us is 0)
+    """
+    params = {'latency_us': latency_us}
+    if path is not None:
+        params['path'] = path
+    return client.call('trace_set_capture_trigger', params)
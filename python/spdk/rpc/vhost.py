@@ -99,6 +99,8 @@ def vhost_create_blk_controller(client, **params):
         transport: virtio blk transport name (default: vhost_user_blk)
         readonly: set controller as read-only
         packed_ring: support controller packed_ring
+        num_vq_threads: number of threads polling the virtqueues of each session (default: 1)
+        vq_poll_idle_count: idle polls before a busy virtqueue returns to interrupts (default: 0)
     """
     strip_globals(params)
     remove_null(params)
@@ -167,7 +167,14 @@ if __name__ == "__main__":
                                         period=args.period,
                                         load_limit=args.load_limit,
                                         core_limit=args.core_limit,
-                                        core_busy=args.core_busy)
+                                        core_busy=args.core_busy,
+                                        latency_aware=args.latency_aware,
+                                        burst_limit=args.burst_limit,
+                                        msg_rate_limit=args.msg_rate_limit,
+                                        power_aware=args.power_aware,
+                                        power_cap=args.power_cap,
+                                        numa_aware=args.numa_aware,
+                                        numa_cross_limit=args.numa_cross_limit)
 
     p = subparsers.add_parser(
         'framework_set_scheduler', help='Select thread scheduler that will be activated and its period (experimental)')
@@ -176,6 +183,20 @@ if __name__ == "__main__":
     p.add_argument('--load-limit', help="Scheduler load limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-limit', help="Scheduler core limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-busy', help="Scheduler core busy limit. Reserved for dynamic schedler", type=int, required=False)
+    p.add_argument('--latency-aware', help="Keep latency sensitive threads apart from each other and from bursty threads. "
+                   "Reserved for dynamic scheduler", action='store_true', default=None)
+    p.add_argument('--burst-limit', help="Busy run length in microseconds above which a thread is considered bursty. "
+                   "Reserved for dynamic scheduler", type=int, required=False)
+    p.add_argument('--msg-rate-limit', help="Message rate per second above which a thread is considered bursty. "
+                   "Reserved for dynamic scheduler", type=int, required=False)
+    p.add_argument('--power-aware', help="Pack threads onto fewer cores and manage the frequency of all cores. "
+                   "Reserved for dynamic scheduler", action='store_true', default=None)
+    p.add_argument('--power-cap', help="Limit of the sum of polling cores' frequencies in percent of the maximum. "
+                   "Reserved for dynamic scheduler", type=int, required=False)
+    p.add_argument('--numa-aware', help="Keep threads with a NUMA affinity on cores of their preferred socket. "
+                   "Reserved for dynamic scheduler", action='store_true', default=None)
+    p.add_argument('--numa-cross-limit', help="Load in percent of all cores of a socket above which threads can be "
+                   "moved to other sockets. Reserved for dynamic scheduler", type=int, required=False)
     p.set_defaults(func=framework_set_scheduler)
 
     def framework_get_scheduler(args):
@@ -185,6 +206,14 @@ if __name__ == "__main__":
         'framework_get_scheduler', help='Display currently set scheduler and its properties.')
     p.set_defaults(func=framework_get_scheduler)
 
+    def framework_set_interrupt_spin_time(args):
+        rpc.app.framework_set_interrupt_spin_time(args.client, spin_time_us=args.spin_time_us)
+
+    p = subparsers.add_parser('framework_set_interrupt_spin_time',
+                              help='Set the time reactors in interrupt mode spin before sleeping.')
+    p.add_argument('spin_time_us', help='Spin time in microseconds, 0 to disable', type=int)
+    p.set_defaults(func=framework_set_interrupt_spin_time)
+
     def framework_disable_cpumask_locks(args):
         rpc.framework_disable_cpumask_locks(args.client)
 
@@ -204,7 +233,9 @@ if __name__ == "__main__":
         rpc.bdev.bdev_set_options(args.client,
                                   bdev_io_pool_size=args.bdev_io_pool_size,
                                   bdev_io_cache_size=args.bdev_io_cache_size,
-                                  bdev_auto_examine=args.bdev_auto_examine)
+                                  bdev_auto_examine=args.bdev_auto_examine,
+                                  qos_distributed=args.qos_distributed,
+                                  examine_max_in_progress=args.examine_max_in_progress)
 
     p = subparsers.add_parser('bdev_set_options',
                               help="""Set options of bdev subsystem""")
@@ -214,6 +245,10 @@ if __name__ == "__main__":
     group.add_argument('-e', '--enable-auto-examine', dest='bdev_auto_examine', help='Allow to auto examine', action='store_true')
     group.add_argument('-d', '--disable-auto-examine', dest='bdev_auto_examine', help='Not allow to auto examine', action='store_false')
     p.set_defaults(bdev_auto_examine=True)
+    p.add_argument('--qos-distributed', help='Submit rate limited I/O on the thread of the channel, '
+                   'instead of sending it to the QoS thread', action='store_true')
+    p.add_argument('--examine-max-in-progress', help='Maximum number of bdevs examined at the same time '
+                   'by each bdev module, 0 for no limit', type=int)
     p.set_defaults(func=bdev_set_options)
 
     def bdev_examine(args):
@@ -232,6 +267,13 @@ if __name__ == "__main__":
                               help="""Report when all bdevs have been examined""")
     p.set_defaults(func=bdev_wait_for_examine)
 
+    def bdev_get_examine_stats(args):
+        print_dict(rpc.bdev.bdev_get_examine_stats(args.client))
+
+    p = subparsers.add_parser('bdev_get_examine_stats',
+                              help="""Display examine statistics of the bdev modules""")
+    p.set_defaults(func=bdev_get_examine_stats)
+
     def bdev_compress_create(args):
         print_json(rpc.bdev.bdev_compress_create(args.client,
                                                  base_bdev_name=args.base_bdev_name,
@@ -240,7 +282,7 @@ if __name__ == "__main__":
 
     p = subparsers.add_parser('bdev_compress_create', help='Add a compress vbdev')
     p.add_argument('-b', '--base-bdev-name', help="Name of the base bdev")
-    p.add_argument('-p', '--pm-path', help="Path to persistent memory")
+    p.add_argument('-p', '--pm-path', help="Path to persistent memory (optional, metadata is stored on the base bdev if not set)")
     p.add_argument('-l', '--lb-size', help="Compressed vol logical block size (optional, if used must be 512 or 4096)", type=int)
     p.set_defaults(func=bdev_compress_create)
 
@@ -390,7 +432,10 @@ if __name__ == "__main__":
                                                md_size=args.md_size,
                                                md_interleave=args.md_interleave,
                                                dif_type=args.dif_type,
-                                               dif_is_head_of_md=args.dif_is_head_of_md))
+                                               dif_is_head_of_md=args.dif_is_head_of_md,
+                                               numa_node=args.numa_node,
+                                               numa_interleave=args.numa_interleave,
+                                               inline_copy_threshold=args.inline_copy_threshold))
     p = subparsers.add_parser('bdev_malloc_create', help='Create a bdev with malloc backend')
     p.add_argument('-b', '--name', help="Name of the bdev")
     p.add_argument('-u', '--uuid', help="UUID of the bdev")
@@ -409,6 +454,12 @@ if __name__ == "__main__":
                         'to be set along --dif-type. Default=0 - no protection.')
     p.add_argument('-d', '--dif-is-head-of-md', action='store_true',
                    help='Protection information is in the first 8 bytes of metadata. Default=false.')
+    p.add_argument('-n', '--numa-node', type=int,
+                   help='NUMA node to allocate the buffer on. Default: any node.')
+    p.add_argument('--numa-interleave', action='store_true',
+                   help='Stripe the buffer across the NUMA nodes of the application, one huge page at a time.')
+    p.add_argument('--inline-copy-threshold', type=int,
+                   help='Copy reads and writes up to this many bytes without the accel framework. Default=0 (disabled).')
     p.set_defaults(func=bdev_malloc_create)
 
     def bdev_malloc_delete(args):
@@ -424,6 +475,18 @@ if __name__ == "__main__":
         if args.dif_type and not args.md_size:
             print("ERROR: --md-size must be > 0 when --dif-type is > 0")
             exit(1)
+        model = None
+        if args.model_channels:
+            model = {'num_channels': args.model_channels}
+            for key in ['bandwidth_mbps', 'read_latency_us', 'write_latency_us', 'read_p99_latency_us',
+                        'write_p99_latency_us', 'qd_latency_ns']:
+                if getattr(args, 'model_' + key) is not None:
+                    model[key] = getattr(args, 'model_' + key)
+            if args.model_histogram:
+                model['histogram'] = []
+                for bucket in args.model_histogram.split(','):
+                    latency_us, count = bucket.split(':')
+                    model['histogram'].append({'latency_us': int(latency_us), 'count': int(count)})
         print_json(rpc.bdev.bdev_null_create(args.client,
                                              num_blocks=num_blocks,
                                              block_size=args.block_size,
@@ -432,7 +495,8 @@ if __name__ == "__main__":
                                              uuid=args.uuid,
                                              md_size=args.md_size,
                                              dif_type=args.dif_type,
-                                             dif_is_head_of_md=args.dif_is_head_of_md))
+                                             dif_is_head_of_md=args.dif_is_head_of_md,
+                                             model=model))
 
     p = subparsers.add_parser('bdev_null_create', help='Add a bdev with null backend')
     p.add_argument('name', help='Block device name')
@@ -448,6 +512,17 @@ if __name__ == "__main__":
                         'to be set along --dif-type. Default=0 - no protection.')
     p.add_argument('-d', '--dif-is-head-of-md', action='store_true',
                    help='Protection information is in the first 8 bytes of metadata. Default=false.')
+    p.add_argument('--model-channels', type=int,
+                   help='Emulate a device servicing this many I/Os in parallel. Default=0 - complete I/Os immediately.')
+    p.add_argument('--model-bandwidth-mbps', type=int, help='Bandwidth of the emulated device in MiB/s.')
+    p.add_argument('--model-read-latency-us', type=int, help='Median read latency of the emulated device.')
+    p.add_argument('--model-write-latency-us', type=int, help='Median write latency of the emulated device.')
+    p.add_argument('--model-read-p99-latency-us', type=int, help='99th percentile of the read latency.')
+    p.add_argument('--model-write-p99-latency-us', type=int, help='99th percentile of the write latency.')
+    p.add_argument('--model-qd-latency-ns', type=int,
+                   help='Latency added for each I/O outstanding on the emulated device.')
+    p.add_argument('--model-histogram', help='Latency histogram to replay instead, as latency_us:count pairs '
+                   'separated by commas.')
     p.set_defaults(func=bdev_null_create)
 
     def bdev_null_delete(args):
@@ -499,6 +574,24 @@ if __name__ == "__main__":
     p.add_argument('name', help='aio bdev name')
     p.set_defaults(func=bdev_aio_delete)
 
+    def bdev_uring_set_options(args):
+        rpc.bdev.bdev_uring_set_options(args.client,
+                                        sqpoll=args.sqpoll,
+                                        sqpoll_idle_ms=args.sqpoll_idle_ms,
+                                        fixed_files=args.fixed_files,
+                                        fixed_buffers=args.fixed_buffers)
+
+    p = subparsers.add_parser('bdev_uring_set_options', help='Set options for the uring bdev module')
+    p.add_argument('--sqpoll', action='store_true', help='Use a kernel thread to poll the submission queue',
+                   default=None)
+    p.add_argument('--sqpoll-idle-ms', help='Idle time of the submission queue polling thread in milliseconds',
+                   type=int)
+    p.add_argument('--disable-fixed-files', dest='fixed_files', action='store_false',
+                   help='Do not register the files of the uring bdevs with the rings', default=None)
+    p.add_argument('--disable-fixed-buffers', dest='fixed_buffers', action='store_false',
+                   help='Do not register the iobuf pools with the rings as fixed buffers', default=None)
+    p.set_defaults(func=bdev_uring_set_options)
+
     def bdev_uring_create(args):
         print_json(rpc.bdev.bdev_uring_create(args.client,
                                               filename=args.filename,
@@ -566,7 +659,13 @@ if __name__ == "__main__":
                                        transport_tos=args.transport_tos,
                                        nvme_error_stat=args.nvme_error_stat,
                                        rdma_srq_size=args.rdma_srq_size,
-                                       io_path_stat=args.io_path_stat)
+                                       io_path_stat=args.io_path_stat,
+                                       io_queue_connections=args.io_queue_connections,
+                                       tcp_zcopy_recv=args.tcp_zcopy_recv,
+                                       latency_histograms=args.latency_histograms,
+                                       io_path_failover_count=args.io_path_failover_count,
+                                       io_path_error_threshold=args.io_path_error_threshold,
+                                       discovery_attach_max_concurrency=args.discovery_attach_max_concurrency)
 
     p = subparsers.add_parser('bdev_nvme_set_options',
                               help='Set options for the bdev nvme type. This is startup command.')
@@ -644,6 +743,24 @@ if __name__ == "__main__":
     p.add_argument('--io-path-stat',
                    help="""Enable collecting I/O path stat of each io path.""",
                    action='store_true')
+    p.add_argument('--io-queue-connections',
+                   help='The number of connections each I/O queue of an NVMe-oF controller is striped across. Default: 1',
+                   type=int)
+    p.add_argument('--tcp-zcopy-recv',
+                   help='Receive the data of TCP I/O queues directly into the I/O buffers, bypassing the socket receive pipe.',
+                   action='store_true')
+    p.add_argument('--latency-histograms',
+                   help='Track the latency of the I/O completed by each I/O queue in per namespace histograms.',
+                   action='store_true')
+    p.add_argument('--io-path-failover-count',
+                   help='The number of times an I/O failing with a path error is resubmitted to another I/O path right away. Default: 0',
+                   type=int)
+    p.add_argument('--io-path-error-threshold',
+                   help='The number of path errors in a row after which an I/O path is not selected for a while. Default: 0 (disabled)',
+                   type=int)
+    p.add_argument('--discovery-attach-max-concurrency',
+                   help='The number of subsystems found by a discovery service that are attached in parallel. 0 means unlimited. Default: 32',
+                   type=int)
 
     p.set_defaults(func=bdev_nvme_set_options)
 
@@ -680,7 +797,9 @@ if __name__ == "__main__":
                                                          reconnect_delay_sec=args.reconnect_delay_sec,
                                                          fast_io_fail_timeout_sec=args.fast_io_fail_timeout_sec,
                                                          psk=args.psk,
-                                                         max_bdevs=args.max_bdevs))
+                                                         max_bdevs=args.max_bdevs,
+                                                         io_queue_depth_limit=args.io_queue_depth_limit,
+                                                         io_target_latency_us=args.io_target_latency_us))
 
     p = subparsers.add_parser('bdev_nvme_attach_controller', help='Add bdevs with nvme backend')
     p.add_argument('-b', '--name', help="Name of the NVMe controller, prefix for each bdev name", required=True)
@@ -735,6 +854,10 @@ if __name__ == "__main__":
                    help='Set PSK file path and enable TCP SSL socket implementation.')
     p.add_argument('-m', '--max-bdevs', type=int,
                    help='The size of the name array for newly created bdevs. Default is 128',)
+    p.add_argument('--io-queue-depth-limit', type=int,
+                   help='Maximum number of outstanding I/Os on the controller. 0 means no limit.')
+    p.add_argument('--io-target-latency-us', type=int,
+                   help='Target I/O latency used to adjust the queue depth limit. 0 means disabled.')
 
     p.set_defaults(func=bdev_nvme_attach_controller)
 
@@ -882,6 +1005,14 @@ if __name__ == "__main__":
     p.add_argument('-n', '--name', help="Name of the NVMe bdev", required=False)
     p.set_defaults(func=bdev_nvme_get_io_paths)
 
+    def bdev_nvme_get_latency_histograms(args):
+        print_dict(rpc.bdev.bdev_nvme_get_latency_histograms(args.client, name=args.name))
+
+    p = subparsers.add_parser('bdev_nvme_get_latency_histograms',
+                              help='Get the latency histograms of an NVMe bdev, measured in the NVMe driver')
+    p.add_argument('-b', '--name', help="Name of the NVMe bdev", required=True)
+    p.set_defaults(func=bdev_nvme_get_latency_histograms)
+
     def bdev_nvme_set_preferred_path(args):
         rpc.bdev.bdev_nvme_set_preferred_path(args.client,
                                               name=args.name,
@@ -904,7 +1035,7 @@ if __name__ == "__main__":
                               help="""Set multipath policy of the NVMe bdev""")
     p.add_argument('-b', '--name', help='Name of the NVMe bdev', required=True)
     p.add_argument('-p', '--policy', help='Multipath policy (active_passive or active_active)', required=True)
-    p.add_argument('-s', '--selector', help='Multipath selector (round_robin, queue_depth)', required=False)
+    p.add_argument('-s', '--selector', help='Multipath selector (round_robin, queue_depth, latency)', required=False)
     p.add_argument('-r', '--rr-min-io',
                    help='Number of IO to route to a path before switching to another for round-robin',
                    type=int, required=False)
@@ -1024,7 +1155,8 @@ if __name__ == "__main__":
                                             rbd_name=args.rbd_name,
                                             block_size=args.block_size,
                                             cluster_name=args.cluster_name,
-                                            uuid=args.uuid))
+                                            uuid=args.uuid,
+                                            image_per_channel=args.image_per_channel))
 
     p = subparsers.add_parser('bdev_rbd_create', help='Add a bdev with ceph rbd backend')
     p.add_argument('-b', '--name', help="Name of the bdev", required=False)
@@ -1036,6 +1168,8 @@ if __name__ == "__main__":
     p.add_argument('block_size', help='rbd block size', type=int)
     p.add_argument('-c', '--cluster-name', help="cluster name to identify the Rados cluster", required=False)
     p.add_argument('-u', '--uuid', help="UUID of the bdev")
+    p.add_argument('--image-per-channel', help="Open the image separately for each I/O channel and poll its "
+                   "completions from the channel's thread", action='store_true')
     p.set_defaults(func=bdev_rbd_create)
 
     def bdev_rbd_delete(args):
@@ -1169,6 +1303,72 @@ if __name__ == "__main__":
     p.add_argument('name', help='pass through bdev name')
     p.set_defaults(func=bdev_passthru_delete)
 
+    def bdev_cache_create(args):
+        print_json(rpc.bdev.bdev_cache_create(args.client,
+                                              base_bdev_name=args.base_bdev_name,
+                                              name=args.name,
+                                              size_mb=args.size_mb,
+                                              line_size_kb=args.line_size_kb,
+                                              uuid=args.uuid))
+
+    p = subparsers.add_parser('bdev_cache_create', help='Add a read cache bdev on existing bdev')
+    p.add_argument('-b', '--base-bdev-name', help="Name of the existing bdev", required=True)
+    p.add_argument('-c', '--name', help="Name of the read cache bdev", required=True)
+    p.add_argument('-s', '--size-mb', help="Size of the memory used to cache data, in MiB", required=True, type=int)
+    p.add_argument('-l', '--line-size-kb', help="Size of a single cache line, in KiB (power of two, default 16)", type=int)
+    p.add_argument('-u', '--uuid', help="UUID of the bdev")
+    p.set_defaults(func=bdev_cache_create)
+
+    def bdev_cache_delete(args):
+        rpc.bdev.bdev_cache_delete(args.client,
+                                   name=args.name)
+
+    p = subparsers.add_parser('bdev_cache_delete', help='Delete a read cache bdev')
+    p.add_argument('name', help='read cache bdev name')
+    p.set_defaults(func=bdev_cache_delete)
+
+    def bdev_shm_export(args):
+        rpc.bdev.bdev_shm_export(args.client,
+                                 name=args.name,
+                                 bdev_name=args.bdev_name,
+                                 num_queues=args.num_queues,
+                                 queue_depth=args.queue_depth,
+                                 io_size=args.io_size)
+
+    p = subparsers.add_parser('bdev_shm_export', help='Export a bdev to other SPDK processes through shared memory')
+    p.add_argument('-b', '--bdev-name', help="Name of the bdev to export", required=True)
+    p.add_argument('-n', '--name', help="Name of the export", required=True)
+    p.add_argument('-q', '--num-queues', help="Number of queue pairs (default 4)", type=int)
+    p.add_argument('-d', '--queue-depth', help="Number of slots of each queue pair (power of two, default 64)", type=int)
+    p.add_argument('-s', '--io-size', help="Size of the data buffer of each slot, in bytes (default 131072)", type=int)
+    p.set_defaults(func=bdev_shm_export)
+
+    def bdev_shm_unexport(args):
+        rpc.bdev.bdev_shm_unexport(args.client,
+                                   name=args.name)
+
+    p = subparsers.add_parser('bdev_shm_unexport', help='Stop exporting a bdev through shared memory')
+    p.add_argument('name', help='export name')
+    p.set_defaults(func=bdev_shm_unexport)
+
+    def bdev_shm_create(args):
+        print_json(rpc.bdev.bdev_shm_create(args.client,
+                                            name=args.name,
+                                            export_name=args.export_name))
+
+    p = subparsers.add_parser('bdev_shm_create', help='Add a bdev on a bdev exported by another SPDK process')
+    p.add_argument('-b', '--name', help="Name of the bdev", required=True)
+    p.add_argument('-e', '--export-name', help="Name of the export", required=True)
+    p.set_defaults(func=bdev_shm_create)
+
+    def bdev_shm_delete(args):
+        rpc.bdev.bdev_shm_delete(args.client,
+                                 name=args.name)
+
+    p = subparsers.add_parser('bdev_shm_delete', help='Delete a shared memory bdev')
+    p.add_argument('name', help='shared memory bdev name')
+    p.set_defaults(func=bdev_shm_delete)
+
     def bdev_get_bdevs(args):
         print_dict(rpc.bdev.bdev_get_bdevs(args.client,
                                            name=args.name, timeout=args.timeout_ms))
@@ -1213,6 +1413,18 @@ if __name__ == "__main__":
     p.add_argument('name', help='bdev name')
     p.set_defaults(func=bdev_enable_histogram)
 
+    def bdev_set_io_merge(args):
+        rpc.bdev.bdev_set_io_merge(args.client, name=args.name, hold_us=args.hold_us,
+                                   max_size_kb=args.max_size_kb)
+
+    p = subparsers.add_parser('bdev_set_io_merge',
+                              help='Set merging of adjacent reads and writes for specified bdev')
+    p.add_argument('name', help='bdev name')
+    p.add_argument('-u', '--hold-us', help='Maximum time in microseconds a request may be held to be merged, 0 disables merging',
+                   type=int, required=True)
+    p.add_argument('-s', '--max-size-kb', help='Maximum size of a merged request in KiB (default: 128)', type=int)
+    p.set_defaults(func=bdev_set_io_merge)
+
     def bdev_get_histogram(args):
         print_dict(rpc.bdev.bdev_get_histogram(args.client, name=args.name))
 
@@ -1221,6 +1433,22 @@ if __name__ == "__main__":
     p.add_argument('name', help='bdev name')
     p.set_defaults(func=bdev_get_histogram)
 
+    def bdev_get_split_histogram(args):
+        print_dict(rpc.bdev.bdev_get_split_histogram(args.client, name=args.name))
+
+    p = subparsers.add_parser('bdev_get_split_histogram',
+                              help='Get histograms split by I/O type and size for specified bdev')
+    p.add_argument('name', help='bdev name')
+    p.set_defaults(func=bdev_get_split_histogram)
+
+    def bdev_reset_histogram(args):
+        print_dict(rpc.bdev.bdev_reset_histogram(args.client, name=args.name))
+
+    p = subparsers.add_parser('bdev_reset_histogram',
+                              help='Reset histogram data collected for specified bdev')
+    p.add_argument('name', help='bdev name')
+    p.set_defaults(func=bdev_reset_histogram)
+
     def bdev_set_qd_sampling_period(args):
         rpc.bdev.bdev_set_qd_sampling_period(args.client,
                                              name=args.name,
@@ -1259,6 +1487,81 @@ if __name__ == "__main__":
                    type=int, required=False)
     p.set_defaults(func=bdev_set_qos_limit)
 
+    def bdev_qos_group_create(args):
+        rpc.bdev.bdev_qos_group_create(args.client,
+                                       name=args.name,
+                                       rw_ios_per_sec=args.rw_ios_per_sec,
+                                       rw_mbytes_per_sec=args.rw_mbytes_per_sec,
+                                       r_mbytes_per_sec=args.r_mbytes_per_sec,
+                                       w_mbytes_per_sec=args.w_mbytes_per_sec,
+                                       burst_ms=args.burst_ms)
+
+    p = subparsers.add_parser('bdev_qos_group_create',
+                              help='Create a QoS group whose rate limits are shared by its blockdevs')
+    p.add_argument('name', help='QoS group name. Example: tenant0')
+    p.add_argument('--rw-ios-per-sec',
+                   help='R/W IOs per second limit (>=1000, example: 20000). 0 means unlimited.',
+                   type=int, required=False)
+    p.add_argument('--rw-mbytes-per-sec',
+                   help="R/W megabytes per second limit (>=10, example: 100). 0 means unlimited.",
+                   type=int, required=False)
+    p.add_argument('--r-mbytes-per-sec',
+                   help="Read megabytes per second limit (>=10, example: 100). 0 means unlimited.",
+                   type=int, required=False)
+    p.add_argument('--w-mbytes-per-sec',
+                   help="Write megabytes per second limit (>=10, example: 100). 0 means unlimited.",
+                   type=int, required=False)
+    p.add_argument('--burst-ms',
+                   help="Time in milliseconds for which unused rate accumulates. Default: 1",
+                   type=int, required=False)
+    p.set_defaults(func=bdev_qos_group_create)
+
+    def bdev_qos_group_delete(args):
+        rpc.bdev.bdev_qos_group_delete(args.client, name=args.name)
+
+    p = subparsers.add_parser('bdev_qos_group_delete', help='Delete a QoS group')
+    p.add_argument('name', help='QoS group name. Example: tenant0')
+    p.set_defaults(func=bdev_qos_group_delete)
+
+    def bdev_qos_group_add_bdev(args):
+        rpc.bdev.bdev_qos_group_add_bdev(args.client,
+                                         group_name=args.group_name,
+                                         name=args.name,
+                                         min_rw_ios_per_sec=args.min_rw_ios_per_sec,
+                                         min_rw_mbytes_per_sec=args.min_rw_mbytes_per_sec,
+                                         min_r_mbytes_per_sec=args.min_r_mbytes_per_sec,
+                                         min_w_mbytes_per_sec=args.min_w_mbytes_per_sec)
+
+    p = subparsers.add_parser('bdev_qos_group_add_bdev', help='Add a blockdev to a QoS group')
+    p.add_argument('group_name', help='QoS group name. Example: tenant0')
+    p.add_argument('name', help='Blockdev name. Example: Malloc0')
+    p.add_argument('--min-rw-ios-per-sec',
+                   help='R/W IOs per second guaranteed to the blockdev. 0 means no guarantee.',
+                   type=int, required=False)
+    p.add_argument('--min-rw-mbytes-per-sec',
+                   help="R/W megabytes per second guaranteed to the blockdev. 0 means no guarantee.",
+                   type=int, required=False)
+    p.add_argument('--min-r-mbytes-per-sec',
+                   help="Read megabytes per second guaranteed to the blockdev. 0 means no guarantee.",
+                   type=int, required=False)
+    p.add_argument('--min-w-mbytes-per-sec',
+                   help="Write megabytes per second guaranteed to the blockdev. 0 means no guarantee.",
+                   type=int, required=False)
+    p.set_defaults(func=bdev_qos_group_add_bdev)
+
+    def bdev_qos_group_remove_bdev(args):
+        rpc.bdev.bdev_qos_group_remove_bdev(args.client, name=args.name)
+
+    p = subparsers.add_parser('bdev_qos_group_remove_bdev', help='Remove a blockdev from its QoS group')
+    p.add_argument('name', help='Blockdev name. Example: Malloc0')
+    p.set_defaults(func=bdev_qos_group_remove_bdev)
+
+    def bdev_get_qos_groups(args):
+        print_dict(rpc.bdev.bdev_get_qos_groups(args.client))
+
+    p = subparsers.add_parser('bdev_get_qos_groups', help='Display QoS groups')
+    p.set_defaults(func=bdev_get_qos_groups)
+
     def bdev_error_inject_error(args):
         rpc.bdev.bdev_error_inject_error(args.client,
                                          name=args.name,
@@ -1875,6 +2178,25 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                               help='get name of shared memory file and list of the available trace point groups')
     p.set_defaults(func=trace_get_info)
 
+    def trace_set_sample_rate(args):
+        rpc.trace.trace_set_sample_rate(args.client, rate=args.rate)
+
+    p = subparsers.add_parser('trace_set_sample_rate',
+                              help='only record the traces of 1 in rate objects (e.g. requests)')
+    p.add_argument('rate', help='sampling rate, 0 or 1 disables sampling', type=int)
+    p.set_defaults(func=trace_set_sample_rate)
+
+    def trace_set_capture_trigger(args):
+        rpc.trace.trace_set_capture_trigger(args.client, latency_us=args.latency_us,
+                                            path=args.path)
+
+    p = subparsers.add_parser('trace_set_capture_trigger',
+                              help='capture the traces once a bdev I/O exceeds a latency threshold')
+    p.add_argument('latency_us', help='latency threshold in microseconds, 0 disables the capture',
+                   type=int)
+    p.add_argument('-p', '--path', help='prefix of the capture file names')
+    p.set_defaults(func=trace_set_capture_trigger)
+
     # log
     def log_set_flag(args):
         rpc.log.log_set_flag(args.client, flag=args.flag)
@@ -2041,6 +2363,68 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('name', help='lvol bdev name')
     p.set_defaults(func=bdev_lvol_decouple_parent)
 
+    def bdev_lvol_merge_snapshot(args):
+        rpc.lvol.bdev_lvol_merge_snapshot(args.client,
+                                          name=args.name)
+
+    p = subparsers.add_parser('bdev_lvol_merge_snapshot',
+                              help='Merge a snapshot into its clones and delete it')
+    p.add_argument('name', help='snapshot lvol bdev name')
+    p.set_defaults(func=bdev_lvol_merge_snapshot)
+
+    def bdev_lvol_get_changed_extents(args):
+        print_json(rpc.lvol.bdev_lvol_get_changed_extents(args.client,
+                                                          name=args.name,
+                                                          base_name=args.base_name,
+                                                          offset=args.offset,
+                                                          max_extents=args.max_extents))
+
+    p = subparsers.add_parser('bdev_lvol_get_changed_extents',
+                              help='Get the extents of an lvol that may differ from an older snapshot')
+    p.add_argument('name', help='lvol bdev name')
+    p.add_argument('-b', '--base-name', help='name of the older snapshot to compare with')
+    p.add_argument('-o', '--offset', help='offset in bytes to start from', type=int)
+    p.add_argument('-m', '--max-extents', help='maximum number of extents returned', type=int)
+    p.set_defaults(func=bdev_lvol_get_changed_extents)
+
+    def bdev_lvol_shallow_copy(args):
+        rpc.lvol.bdev_lvol_shallow_copy(args.client,
+                                        src_lvol_name=args.src_lvol_name,
+                                        dst_bdev_name=args.dst_bdev_name,
+                                        base_name=args.base_name,
+                                        queue_depth=args.queue_depth)
+
+    p = subparsers.add_parser('bdev_lvol_shallow_copy',
+                              help='Copy the clusters of a read only lvol to another bdev')
+    p.add_argument('src_lvol_name', help='read only lvol bdev name, e.g. a snapshot')
+    p.add_argument('dst_bdev_name', help='name of the bdev to copy to')
+    p.add_argument('-b', '--base-name', help='name of an older snapshot already copied to the bdev')
+    p.add_argument('-q', '--queue-depth', help='maximum number of clusters copied in parallel', type=int)
+    p.set_defaults(func=bdev_lvol_shallow_copy)
+
+    def bdev_lvol_set_copy_rate_limit(args):
+        rpc.lvol.bdev_lvol_set_copy_rate_limit(args.client,
+                                               clusters_per_sec=args.clusters_per_sec,
+                                               uuid=args.uuid,
+                                               lvs_name=args.lvs_name)
+
+    p = subparsers.add_parser('bdev_lvol_set_copy_rate_limit',
+                              help='Limit the rate of cluster copies done by inflate, decouple and merge')
+    p.add_argument('-u', '--uuid', help='lvol store UUID', required=False)
+    p.add_argument('-l', '--lvs-name', help='lvol store name', required=False)
+    p.add_argument('clusters_per_sec', help='Maximum number of clusters copied per second, 0 for no limit',
+                   type=int)
+    p.set_defaults(func=bdev_lvol_set_copy_rate_limit)
+
+    def bdev_lvol_set_esnap_cache_size(args):
+        rpc.lvol.bdev_lvol_set_esnap_cache_size(args.client,
+                                                size_mib=args.size_mib)
+
+    p = subparsers.add_parser('bdev_lvol_set_esnap_cache_size',
+                              help='Set the size of the cache of data read from external snapshots')
+    p.add_argument('size_mib', help='Size of the cache in MiB, 0 to disable caching', type=int)
+    p.set_defaults(func=bdev_lvol_set_esnap_cache_size)
+
     def bdev_lvol_resize(args):
         rpc.lvol.bdev_lvol_resize(args.client,
                                   name=args.name,
@@ -2120,13 +2504,16 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                   strip_size_kb=args.strip_size_kb,
                                   raid_level=args.raid_level,
                                   base_bdevs=base_bdevs,
-                                  uuid=args.uuid)
+                                  uuid=args.uuid,
+                                  read_policy=args.read_policy)
     p = subparsers.add_parser('bdev_raid_create', help='Create new raid bdev')
     p.add_argument('-n', '--name', help='raid bdev name', required=True)
     p.add_argument('-z', '--strip-size-kb', help='strip size in KB', type=int)
-    p.add_argument('-r', '--raid-level', help='raid level, raid0, raid1 and a special level concat are supported', required=True)
+    p.add_argument('-r', '--raid-level', help='raid level, raid0, raid1, raid10, raid5f, raid6f and a special level concat are supported', required=True)
     p.add_argument('-b', '--base-bdevs', help='base bdevs name, whitespace separated list in quotes', required=True)
     p.add_argument('--uuid', help='UUID for this raid bdev', required=False)
+    p.add_argument('-p', '--read-policy', help='read balancing policy (raid1 and raid10 only)',
+                   choices=['round_robin', 'least_outstanding', 'lba_shard'], required=False)
     p.set_defaults(func=bdev_raid_create)
 
     def bdev_raid_delete(args):
@@ -2143,6 +2530,29 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('name', help='base bdev name')
     p.set_defaults(func=bdev_raid_remove_base_bdev)
 
+    def bdev_raid_add_base_bdev(args):
+        rpc.bdev.bdev_raid_add_base_bdev(args.client,
+                                         base_bdev=args.base_bdev,
+                                         raid_bdev=args.raid_bdev)
+    p = subparsers.add_parser('bdev_raid_add_base_bdev', help='Add base bdev to existing raid bdev')
+    p.add_argument('raid_bdev', help='raid bdev name')
+    p.add_argument('base_bdev', help='base bdev name')
+    p.set_defaults(func=bdev_raid_add_base_bdev)
+
+    def bdev_raid_set_options(args):
+        rpc.bdev.bdev_raid_set_options(args.client,
+                                       process_window_size_kb=args.process_window_size_kb,
+                                       process_max_bandwidth_mb_sec=args.process_max_bandwidth_mb_sec,
+                                       stripe_cache_size=args.stripe_cache_size)
+    p = subparsers.add_parser('bdev_raid_set_options', help='Set options for bdev raid.')
+    p.add_argument('-w', '--process-window-size-kb', type=int,
+                   help="Background process (e.g. rebuild) window size in KiB")
+    p.add_argument('-b', '--process-max-bandwidth-mb-sec', type=int,
+                   help="Background process bandwidth limit in MiB/s, 0 means unlimited")
+    p.add_argument('-s', '--stripe-cache-size', type=int,
+                   help="Number of stripes cached by raid5f/raid6f bdevs for partial stripe writes, 0 disables")
+    p.set_defaults(func=bdev_raid_set_options)
+
     # split
     def bdev_split_create(args):
         print_array(rpc.bdev.bdev_split_create(args.client,
@@ -2178,7 +2588,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                             overprovisioning=args.overprovisioning,
                                             l2p_dram_limit=args.l2p_dram_limit,
                                             core_mask=args.core_mask,
-                                            fast_shutdown=args.fast_shutdown))
+                                            fast_shutdown=args.fast_shutdown,
+                                            gc_policy=args.gc_policy,
+                                            nv_cache_bypass=args.nv_cache_bypass))
 
     p = subparsers.add_parser('bdev_ftl_create', help='Add FTL bdev')
     p.add_argument('-b', '--name', help="Name of the bdev", required=True)
@@ -2195,6 +2607,10 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--core-mask', help='CPU core mask - which cores will be used for ftl core thread, '
                    'by default core thread will be set to the main application core (optional)')
     p.add_argument('-f', '--fast-shutdown', help="Enable fast shutdown", action='store_true')
+    p.add_argument('--gc-policy', help='Policy of picking bands for garbage collection (optional); '
+                   'default greedy', choices=['greedy', 'cost_benefit'])
+    p.add_argument('--nv-cache-bypass', help='Write full, aligned transfers directly to the base device, '
+                   'bypassing the NV cache', action='store_true')
     p.set_defaults(func=bdev_ftl_create)
 
     def bdev_ftl_load(args):
@@ -2206,7 +2622,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                           overprovisioning=args.overprovisioning,
                                           l2p_dram_limit=args.l2p_dram_limit,
                                           core_mask=args.core_mask,
-                                          fast_shutdown=args.fast_shutdown))
+                                          fast_shutdown=args.fast_shutdown,
+                                          gc_policy=args.gc_policy,
+                                          nv_cache_bypass=args.nv_cache_bypass))
 
     p = subparsers.add_parser('bdev_ftl_load', help='Load FTL bdev')
     p.add_argument('-b', '--name', help="Name of the bdev", required=True)
@@ -2222,6 +2640,10 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--core-mask', help='CPU core mask - which cores will be used for ftl core thread, '
                    'by default core thread will be set to the main application core (optional)')
     p.add_argument('-f', '--fast-shutdown', help="Enable fast shutdown", action='store_true')
+    p.add_argument('--gc-policy', help='Policy of picking bands for garbage collection (optional); '
+                   'default greedy', choices=['greedy', 'cost_benefit'])
+    p.add_argument('--nv-cache-bypass', help='Write full, aligned transfers directly to the base device, '
+                   'bypassing the NV cache', action='store_true')
     p.set_defaults(func=bdev_ftl_load)
 
     def bdev_ftl_unload(args):
@@ -2330,12 +2752,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     def nbd_start_disk(args):
         print(rpc.nbd.nbd_start_disk(args.client,
                                      bdev_name=args.bdev_name,
-                                     nbd_device=args.nbd_device))
+                                     nbd_device=args.nbd_device,
+                                     num_connections=args.num_connections))
 
     p = subparsers.add_parser('nbd_start_disk',
                               help='Export a bdev as an nbd disk')
     p.add_argument('bdev_name', help='Blockdev name to be exported. Example: Malloc0.')
     p.add_argument('nbd_device', help='Nbd device name to be assigned. Example: /dev/nbd0.', nargs='?')
+    p.add_argument('-c', '--num-connections', type=int,
+                   help='Number of connections to the kernel, each served by its own thread. Default: 1.')
     p.set_defaults(func=nbd_start_disk)
 
     def nbd_stop_disk(args):
@@ -2400,6 +2825,10 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     Relevant only for RDMA transport""", type=int)
     p.add_argument('-s', '--max-srq-depth', help='Max number of outstanding I/O per SRQ. Relevant only for RDMA transport', type=int)
     p.add_argument('-r', '--no-srq', action='store_true', help='Disable per-thread shared receive queue. Relevant only for RDMA transport')
+    p.add_argument('--num-srqs', help="""The number of shared receive queues per device in each poll group.
+    Relevant only for RDMA transport""", type=int)
+    p.add_argument('--adaptive-srq-posting', action='store_true', help="""Post receives to the shared receive queues
+    based on the observed receive rate. Relevant only for RDMA transport""")
     p.add_argument('-o', '--c2h-success', action='store_false', help='Disable C2H success optimization. Relevant only for TCP transport')
     p.add_argument('-f', '--dif-insert-or-strip', action='store_true', help='Enable DIF insert/strip. Relevant only for TCP transport')
     p.add_argument('-y', '--sock-priority', help='The sock priority of the tcp connection. Relevant only for TCP transport', type=int)
@@ -2408,12 +2837,28 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-w', '--no-wr-batching', action='store_true', help='Disable work requests batching. Relevant only for RDMA transport')
     p.add_argument('-e', '--control-msg-num', help="""The number of control messages per poll group.
     Relevant only for TCP transport""", type=int)
+    p.add_argument('--zero-copy-recv', action='store_true', help="""Receive data directly into the I/O buffers,
+    bypassing the socket receive pipe. Relevant only for TCP transport""")
+    p.add_argument('--digest-accel-threshold', help="""Minimum PDU data size, in bytes, for which the data digest
+    is offloaded to accel. Relevant only for TCP transport""", type=int)
+    p.add_argument('--numa-placement', action='store_true', help="""Place new qpairs on poll groups local to
+    the NUMA node of the network device. Relevant only for TCP transport""")
+    p.add_argument('--poll-group-load-threshold', help="""Percentage of busy polls above which a poll group
+    gets no new qpairs, 0 disables the check. Relevant only for TCP transport""", type=int)
+    p.add_argument('--icd-pool-size', help="""The number of in-capsule data buffers shared by the qpairs
+    of each poll group, 0 gives each qpair its own buffers. Relevant only for TCP transport""", type=int)
+    p.add_argument('--icd-min-bufs-per-qpair', help="""The number of in-capsule data buffers owned by each qpair
+    when --icd-pool-size is set. Relevant only for TCP transport""", type=int)
     p.add_argument('-M', '--disable-mappable-bar0', action='store_true', help="""Disable mmap() of BAR0.
     Relevant only for VFIO-USER transport""")
     p.add_argument('-I', '--disable-adaptive-irq', action='store_true', help="""Disable adaptive interrupt feature.
     Relevant only for VFIO-USER transport""")
     p.add_argument('-S', '--disable-shadow-doorbells', action='store_true', help="""Disable shadow doorbell support.
     Relevant only for VFIO-USER transport""")
+    p.add_argument('--irq-coalescing-time-us', help="""Maximum time an I/O completion may wait for its interrupt,
+    0 disables interrupt coalescing. Relevant only for VFIO-USER transport""", type=int)
+    p.add_argument('--irq-coalescing-threshold', help="""Number of pending completions that trigger a coalesced
+    interrupt early. Relevant only for VFIO-USER transport""", type=int)
     p.add_argument('--acceptor-poll-rate', help='Polling interval of the acceptor for incoming connections (usec)', type=int)
     p.set_defaults(func=nvmf_create_transport)
 
@@ -2536,7 +2981,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        nguid=args.nguid,
                                        eui64=args.eui64,
                                        uuid=args.uuid,
-                                       anagrpid=args.anagrpid)
+                                       anagrpid=args.anagrpid,
+                                       max_io_outstanding=args.max_io_outstanding,
+                                       latency_target_us=args.latency_target_us)
 
     p = subparsers.add_parser('nvmf_subsystem_add_ns', help='Add a namespace to an NVMe-oF subsystem')
     p.add_argument('nqn', help='NVMe-oF subsystem NQN')
@@ -2548,6 +2995,10 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-e', '--eui64', help='Namespace EUI-64 identifier (optional)')
     p.add_argument('-u', '--uuid', help='Namespace UUID (optional)')
     p.add_argument('-a', '--anagrpid', help='ANA group ID (optional)', type=int)
+    p.add_argument('-m', '--max-io-outstanding', help="""Maximum number of I/O outstanding to the namespace on each poll group.
+    I/O above the limit is completed with a retryable status (optional)""", type=int)
+    p.add_argument('-l', '--latency-target-us', help="""Target I/O latency of the namespace in microseconds.
+    Fewer I/O are admitted while the latency is above the target (optional)""", type=int)
     p.set_defaults(func=nvmf_subsystem_add_ns)
 
     def nvmf_subsystem_remove_ns(args):
@@ -2741,6 +3192,11 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--transport', help='virtio blk transport name (default: vhost_user_blk)')
     p.add_argument("-r", "--readonly", action='store_true', help='Set controller as read-only')
     p.add_argument("-p", "--packed_ring", action='store_true', help='Set controller as packed ring supported')
+    p.add_argument("--num-vq-threads", dest='num_vq_threads', type=int,
+                   help='Number of threads polling the virtqueues of each session (default: 1)')
+    p.add_argument("--vq-poll-idle-count", dest='vq_poll_idle_count', type=int,
+                   help='In interrupt mode, number of idle polls before a busy virtqueue returns to '
+                   'interrupts, 0 disables polling (default: 0)')
     p.set_defaults(func=vhost_create_blk_controller)
 
     def vhost_get_controllers(args):
@@ -2901,6 +3357,24 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-m', '--module', help='name of module')
     p.set_defaults(func=accel_assign_opc)
 
+    def accel_assign_opc_route(args):
+        rpc.accel.accel_assign_opc_route(args.client, opname=args.opname,
+                                         small_module=args.small_module,
+                                         small_threshold=args.small_threshold,
+                                         spill_module=args.spill_module,
+                                         spill_qd=args.spill_qd)
+
+    p = subparsers.add_parser('accel_assign_opc_route',
+                              help='Route small or spillover operations of an opcode to other modules.')
+    p.add_argument('-o', '--opname', help='opname', required=True)
+    p.add_argument('-s', '--small-module', help='name of module executing small operations')
+    p.add_argument('-t', '--small-threshold', help='size (in bytes) below which operations are sent to the small module',
+                   type=int)
+    p.add_argument('-p', '--spill-module', help='name of module executing spillover operations')
+    p.add_argument('-q', '--spill-qd', help='outstanding operations on the assigned module above which operations spill over',
+                   type=int)
+    p.set_defaults(func=accel_assign_opc_route)
+
     def accel_crypto_key_create(args):
         print_dict(rpc.accel.accel_crypto_key_create(args.client,
                                                      cipher=args.cipher,
@@ -2987,10 +3461,12 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
 
     # iaa
     def iaa_scan_accel_module(args):
-        rpc.iaa.iaa_scan_accel_module(args.client)
+        rpc.iaa.iaa_scan_accel_module(args.client, huffman_mode=args.huffman_mode)
 
     p = subparsers.add_parser('iaa_scan_accel_module', aliases=['iaa_scan_accel_engine'],
                               help='Set config and enable iaa accel module offload.')
+    p.add_argument('-m', '--huffman-mode', help='Huffman tables used for compression',
+                   choices=['fixed', 'dynamic', 'canned'])
     p.set_defaults(func=iaa_scan_accel_module)
 
     def dpdk_cryptodev_scan_accel_module(args):
@@ -3015,6 +3491,14 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p = subparsers.add_parser('dpdk_cryptodev_get_driver', help='Get the DPDK cryptodev driver')
     p.set_defaults(func=dpdk_cryptodev_get_driver)
 
+    # ipsec_mb
+    def ipsec_mb_scan_accel_module(args):
+        rpc.ipsec_mb.ipsec_mb_scan_accel_module(args.client)
+
+    p = subparsers.add_parser('ipsec_mb_scan_accel_module',
+                              help='Enable intel-ipsec-mb accel module offload.')
+    p.set_defaults(func=ipsec_mb_scan_accel_module)
+
     # mlx5
     def mlx5_scan_accel_module(args):
         rpc.mlx5.mlx5_scan_accel_module(args.client,
@@ -3191,6 +3675,19 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
         'thread_get_pollers', help='Display current pollers of all the threads')
     p.set_defaults(func=thread_get_pollers)
 
+    def thread_set_poller_timing(args):
+        rpc.app.thread_set_poller_timing(args.client,
+                                         histograms=args.histograms,
+                                         watchdog_threshold_us=args.watchdog_threshold_us)
+
+    p = subparsers.add_parser('thread_set_poller_timing',
+                              help='Enable measuring the execution time of pollers')
+    p.add_argument('-H', '--histograms', action='store_true',
+                   help='Collect a histogram of the execution time of each poller')
+    p.add_argument('-w', '--watchdog-threshold-us', type=int,
+                   help='Log a warning when a poller runs longer than this many microseconds')
+    p.set_defaults(func=thread_set_poller_timing)
+
     def thread_get_io_channels(args):
         print_dict(rpc.app.thread_get_io_channels(args.client))
 
@@ -3264,7 +3761,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        enable_zerocopy_send_client=args.enable_zerocopy_send_client,
                                        zerocopy_threshold=args.zerocopy_threshold,
                                        tls_version=args.tls_version,
-                                       enable_ktls=args.enable_ktls)
+                                       enable_ktls=args.enable_ktls,
+                                       busy_poll_usecs=args.busy_poll_usecs,
+                                       busy_poll_budget=args.busy_poll_budget)
 
     p = subparsers.add_parser('sock_impl_set_options', help="""Set options of socket layer implementation""")
     p.add_argument('-i', '--impl', help='Socket implementation name, e.g. posix', required=True)
@@ -3293,9 +3792,12 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                    action='store_true', dest='enable_ktls')
     p.add_argument('--disable-ktls', help='Disable Kernel TLS',
                    action='store_false', dest='enable_ktls')
+    p.add_argument('--busy-poll-usecs', help='Set SO_BUSY_POLL in microseconds, 0 disables it', type=int)
+    p.add_argument('--busy-poll-budget', help='Set SO_BUSY_POLL_BUDGET in packets', type=int)
     p.set_defaults(func=sock_impl_set_options, enable_recv_pipe=None, enable_quickack=None,
                    enable_placement_id=None, enable_zerocopy_send_server=None, enable_zerocopy_send_client=None,
-                   zerocopy_threshold=None, tls_version=None, enable_ktls=None)
+                   zerocopy_threshold=None, tls_version=None, enable_ktls=None,
+                   busy_poll_usecs=None, busy_poll_budget=None)
 
     def sock_set_default_impl(args):
         print_json(rpc.sock.sock_set_default_impl(args.client,
@@ -3405,18 +3907,44 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.set_defaults(func=bdev_daos_resize)
 
     def iobuf_set_options(args):
+        medium_pools = None
+        if args.medium_pools is not None:
+            medium_pools = []
+            for pool in args.medium_pools.split(','):
+                bufsize, count = pool.split(':')
+                medium_pools.append({'bufsize': int(bufsize), 'count': int(count)})
         rpc.iobuf.iobuf_set_options(args.client,
                                     small_pool_count=args.small_pool_count,
                                     large_pool_count=args.large_pool_count,
                                     small_bufsize=args.small_bufsize,
-                                    large_bufsize=args.large_bufsize)
+                                    large_bufsize=args.large_bufsize,
+                                    medium_pools=medium_pools)
     p = subparsers.add_parser('iobuf_set_options', help='Set iobuf pool options')
     p.add_argument('--small-pool-count', help='number of small buffers in the global pool', type=int)
     p.add_argument('--large-pool-count', help='number of large buffers in the global pool', type=int)
     p.add_argument('--small-bufsize', help='size of a small buffer', type=int)
     p.add_argument('--large-bufsize', help='size of a large buffer', type=int)
+    p.add_argument('--medium-pools', help='comma separated list of bufsize:count medium size classes '
+                   'in ascending order of bufsize, e.g. 16384:4096,65536:1024')
     p.set_defaults(func=iobuf_set_options)
 
+    def iobuf_get_stats(args):
+        print_dict(rpc.iobuf.iobuf_get_stats(args.client))
+
+    p = subparsers.add_parser('iobuf_get_stats', help='Display iobuf pool statistics of each module')
+    p.set_defaults(func=iobuf_get_stats)
+
+    def metrics_enable_exporter(args):
+        rpc.metrics.metrics_enable_exporter(args.client,
+                                            listen_address=args.listen_address,
+                                            listen_port=args.listen_port)
+
+    p = subparsers.add_parser('metrics_enable_exporter',
+                              help='Enable the metrics and serve them in the OpenMetrics format over HTTP')
+    p.add_argument('-a', '--listen-address', help='IP address to listen on (default: 127.0.0.1)')
+    p.add_argument('-p', '--listen-port', help='TCP port to listen on (default: 9464)', type=int)
+    p.set_defaults(func=metrics_enable_exporter)
+
     def bdev_nvme_start_mdns_discovery(args):
         rpc.bdev.bdev_nvme_start_mdns_discovery(args.client,
                                                 name=args.name,
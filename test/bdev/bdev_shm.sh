@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+#  SPDX-License-Identifier: BSD-3-Clause
+#  Copyright (C) 2023 Intel Corporation.
+#  All rights reserved.
+#
+testdir=$(readlink -f $(dirname $0))
+rootdir=$(readlink -f $testdir/../..)
+export_server=/var/tmp/spdk-shm-export.sock
+import_server=/var/tmp/spdk-shm-import.sock
+tmp_file=$SPDK_TEST_STORAGE/shmrandtest
+
+source $rootdir/test/common/autotest_common.sh
+source $testdir/nbd_common.sh
+
+rpc_export="$rootdir/scripts/rpc.py -s $export_server"
+rpc_import="$rootdir/scripts/rpc.py -s $import_server"
+
+function cleanup() {
+	rm -f $tmp_file
+	if [ -n "$import_pid" ]; then
+		killprocess $import_pid
+	fi
+	if [ -n "$export_pid" ]; then
+		killprocess $export_pid
+	fi
+}
+
+# Both processes share the same memory through the shared memory id
+$rootdir/test/app/bdev_svc/bdev_svc -r $export_server -i 0 -m 0x1 -L bdev_shm &
+export_pid=$!
+trap 'cleanup; exit 1' SIGINT SIGTERM EXIT
+waitforlisten $export_pid $export_server
+
+$rpc_export bdev_malloc_create -b Malloc0 32 512
+$rpc_export bdev_shm_export -b Malloc0 -n shm_test -q 2 -d 16
+NOT $rpc_export bdev_shm_export -b Malloc0 -n shm_test
+NOT $rpc_export bdev_shm_export -b Malloc0 -n shm_bad_depth -d 3
+
+$rootdir/test/app/bdev_svc/bdev_svc -r $import_server -i 0 -m 0x2 -L bdev_shm &
+import_pid=$!
+waitforlisten $import_pid $import_server
+
+NOT $rpc_import bdev_shm_create -b Shm0 -e nonexistent
+$rpc_import bdev_shm_create -b Shm0 -e shm_test
+[[ $($rpc_import bdev_get_bdevs -b Shm0 | jq -r '.[0].num_blocks') == 65536 ]]
+[[ $($rpc_import bdev_get_bdevs -b Shm0 | jq -r '.[0].driver_specific.shm.export_name') == shm_test ]]
+
+if [[ -e /sys/module/nbd ]] || modprobe -q nbd; then
+	dd if=/dev/urandom of=$tmp_file bs=4096 count=256
+
+	# Write through the imported bdev and read the data back
+	nbd_start_disks $import_server Shm0 /dev/nbd0
+	dd if=$tmp_file of=/dev/nbd0 bs=4096 count=256 oflag=direct
+	cmp -b -n $((256 * 4096)) $tmp_file /dev/nbd0
+
+	# The export can't go away while a consumer channel is attached to it
+	NOT $rpc_export bdev_shm_unexport shm_test
+	nbd_stop_disks $import_server /dev/nbd0
+
+	# The data landed on the exported bdev
+	nbd_start_disks $export_server Malloc0 /dev/nbd1
+	cmp -b -n $((256 * 4096)) $tmp_file /dev/nbd1
+	nbd_stop_disks $export_server /dev/nbd1
+fi
+
+$rpc_import bdev_shm_delete Shm0
+NOT $rpc_import bdev_shm_delete Shm0
+$rpc_export bdev_shm_unexport shm_test
+NOT $rpc_export bdev_shm_unexport shm_test
+NOT $rpc_import bdev_shm_create -b Shm0 -e shm_test
+
+trap - SIGINT SIGTERM EXIT
+cleanup
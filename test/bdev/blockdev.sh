@@ -319,6 +319,7 @@ function nbd_function_test() {
 
 	nbd_rpc_start_stop_verify $rpc_server "${bdev_list[*]}"
 	nbd_rpc_data_verify $rpc_server "${bdev_list[*]}" "${nbd_list[*]}"
+	nbd_multi_conn_verify $rpc_server "${bdev_list[0]}" "${nbd_list[0]}"
 	nbd_with_lvol_verify $rpc_server "${nbd_list[*]}"
 
 	killprocess $nbd_pid
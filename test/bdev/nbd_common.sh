@@ -127,6 +127,51 @@ function nbd_rpc_start_stop_verify() {
 	return 0
 }
 
+function nbd_multi_conn_verify() {
+	local rpc_server=$1
+	local bdev_name=$2
+	local nbd_device=$3
+	local num_conns=4
+	local tmp_file=$SPDK_TEST_STORAGE/nbdmulticonn
+	local pids=()
+	local i pid
+
+	NOT $rootdir/scripts/rpc.py -s $rpc_server nbd_start_disk -c 65 $bdev_name $nbd_device
+
+	$rootdir/scripts/rpc.py -s $rpc_server nbd_start_disk -c $num_conns $bdev_name $nbd_device
+	waitfornbd $(basename $nbd_device)
+	[[ $($rootdir/scripts/rpc.py -s $rpc_server nbd_get_disks -n $nbd_device \
+		| jq -r '.[0].num_connections') == "$num_conns" ]]
+	$rootdir/scripts/rpc.py -s $rpc_server save_subsystem_config -n nbd \
+		| jq -e ".config[0].params.num_connections == $num_conns"
+
+	# Write disjoint ranges at the same time, so the kernel spreads them over the connections
+	dd if=/dev/urandom of=$tmp_file bs=4096 count=256
+	for ((i = 0; i < num_conns; i++)); do
+		dd if=$tmp_file of=$nbd_device bs=4096 count=64 skip=$((i * 64)) seek=$((i * 64)) \
+			oflag=direct conv=notrunc &
+		pids+=($!)
+	done
+	for pid in "${pids[@]}"; do
+		wait $pid
+	done
+	cmp -b -n 1M $tmp_file $nbd_device
+
+	# Buffered writes queue several requests on each connection before the flush
+	dd if=/dev/urandom of=$tmp_file bs=4096 count=256
+	dd if=$tmp_file of=$nbd_device bs=64k count=16 conv=fsync
+	cmp -b -n 1M $tmp_file <(dd if=$nbd_device bs=4096 count=256 iflag=direct)
+	rm $tmp_file
+
+	nbd_stop_disks $rpc_server $nbd_device
+	count=$(nbd_get_count $rpc_server)
+	if [ $count -ne 0 ]; then
+		return 1
+	fi
+
+	return 0
+}
+
 function nbd_with_lvol_verify() {
 	local rpc_server=$1
 	local nbd_list=($2)
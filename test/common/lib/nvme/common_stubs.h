@@ -96,6 +96,7 @@ DEFINE_STUB(nvme_fabric_qpair_connect_poll, int, (struct spdk_nvme_qpair *qpair)
 DEFINE_STUB_V(nvme_transport_ctrlr_disconnect_qpair, (struct spdk_nvme_ctrlr *ctrlr,
 		struct spdk_nvme_qpair *qpair));
 DEFINE_STUB(nvme_poll_group_disconnect_qpair, int, (struct spdk_nvme_qpair *qpair), 0);
+DEFINE_STUB_V(nvme_qpair_tally_latency, (struct spdk_nvme_qpair *qpair, struct nvme_request *req));
 
 int
 nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
@@ -14,9 +14,11 @@
 
 static uint32_t g_ut_num_cores;
 static bool *g_ut_cores;
+static uint32_t *g_ut_core_sockets;
 
 void allocate_cores(uint32_t num_cores);
 void free_cores(void);
+void set_core_socket(uint32_t core, uint32_t socket_id);
 
 DEFINE_STUB(spdk_process_is_primary, bool, (void), true)
 DEFINE_STUB(spdk_memzone_lookup, void *, (const char *name), NULL)
@@ -30,6 +32,7 @@ DEFINE_STUB_V(spdk_env_thread_wait_all, (void));
 DEFINE_STUB_V(spdk_env_opts_init, (struct spdk_env_opts *opts));
 DEFINE_STUB(spdk_env_init, int, (const struct spdk_env_opts *opts), 0);
 DEFINE_STUB_V(spdk_env_fini, (void));
+DEFINE_STUB_V(spdk_pause, (void));
 
 void
 allocate_cores(uint32_t num_cores)
@@ -41,16 +44,29 @@ allocate_cores(uint32_t num_cores)
 	g_ut_cores = calloc(num_cores, sizeof(bool));
 	assert(g_ut_cores != NULL);
 
+	g_ut_core_sockets = calloc(num_cores, sizeof(uint32_t));
+	assert(g_ut_core_sockets != NULL);
+
 	for (i = 0; i < num_cores; i++) {
 		g_ut_cores[i] = true;
+		g_ut_core_sockets[i] = SPDK_ENV_SOCKET_ID_ANY;
 	}
 }
 
+void
+set_core_socket(uint32_t core, uint32_t socket_id)
+{
+	assert(core < g_ut_num_cores);
+	g_ut_core_sockets[core] = socket_id;
+}
+
 void
 free_cores(void)
 {
 	free(g_ut_cores);
 	g_ut_cores = NULL;
+	free(g_ut_core_sockets);
+	g_ut_core_sockets = NULL;
 	g_ut_num_cores = 0;
 }
 
@@ -120,6 +136,10 @@ spdk_env_get_socket_id(uint32_t core)
 {
 	HANDLE_RETURN_MOCK(spdk_env_get_socket_id);
 
+	if (core < g_ut_num_cores) {
+		return g_ut_core_sockets[core];
+	}
+
 	return SPDK_ENV_SOCKET_ID_ANY;
 }
 
@@ -269,6 +289,37 @@ spdk_vtophys(const void *buf, uint64_t *size)
 }
 #endif
 
+#ifndef UNIT_TEST_NO_VTOPHYS_PAGES
+DEFINE_RETURN_MOCK(spdk_vtophys_pages, int);
+int
+spdk_vtophys_pages(const void *buf, uint64_t len, uint64_t page_size, uint64_t *paddrs,
+		   uint32_t count)
+{
+	uint64_t vaddr = (uint64_t)buf, end = vaddr + len, paddr = 0, size = 0, step;
+	uint32_t i;
+
+	HANDLE_RETURN_MOCK(spdk_vtophys_pages);
+
+	for (i = 0; i < count && vaddr < end; i++) {
+		if (size == 0) {
+			size = end - vaddr;
+			paddr = spdk_vtophys((const void *)vaddr, &size);
+			if (paddr == SPDK_VTOPHYS_ERROR) {
+				return i > 0 ? (int)i : -EFAULT;
+			}
+		}
+
+		paddrs[i] = paddr;
+		step = spdk_min(page_size - (vaddr & (page_size - 1)), size);
+		vaddr += step;
+		paddr += step;
+		size -= step;
+	}
+
+	return i;
+}
+#endif
+
 void
 spdk_memzone_dump(FILE *f)
 {
@@ -59,6 +59,7 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	ch->small.cache_size = small_cache_size;
 	ch->large.cache_count = large_cache_size;
 	ch->large.cache_size = large_cache_size;
+	ch->num_medium = 0;
 	return 0;
 }
 
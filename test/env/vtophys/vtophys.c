@@ -124,6 +124,41 @@ vtophys_spdk_malloc_test(void)
 	}
 }
 
+static void
+vtophys_pages_test(void)
+{
+	uint64_t paddrs[64], page_size = 0x1000, size = 0x80000;
+	char *buf, *p;
+	int count, i;
+
+	buf = spdk_zmalloc(size, 0x1000, NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	/* The pages of an unaligned buffer match their separate translations */
+	count = spdk_vtophys_pages(buf + 0x800, size - 0x800, page_size, paddrs,
+				   SPDK_COUNTOF(paddrs));
+	CU_ASSERT(count == SPDK_COUNTOF(paddrs));
+	CU_ASSERT(paddrs[0] == spdk_vtophys(buf + 0x800, NULL));
+	for (i = 1, p = buf + page_size; i < count; i++, p += page_size) {
+		CU_ASSERT(paddrs[i] == spdk_vtophys(p, NULL));
+	}
+
+	/* The array is larger than needed */
+	count = spdk_vtophys_pages(buf, 3 * page_size, page_size, paddrs, SPDK_COUNTOF(paddrs));
+	CU_ASSERT(count == 3);
+
+	count = spdk_vtophys_pages(buf, size, 3 * page_size, paddrs, SPDK_COUNTOF(paddrs));
+	CU_ASSERT(count == -EINVAL);
+
+	spdk_free(buf);
+
+	buf = malloc(page_size);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	count = spdk_vtophys_pages(buf, page_size, page_size, paddrs, SPDK_COUNTOF(paddrs));
+	CU_ASSERT(count == -EFAULT);
+	free(buf);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -155,7 +190,8 @@ main(int argc, char **argv)
 
 	if (
 		CU_add_test(suite, "vtophys_malloc_test", vtophys_malloc_test) == NULL ||
-		CU_add_test(suite, "vtophys_spdk_malloc_test", vtophys_spdk_malloc_test) == NULL
+		CU_add_test(suite, "vtophys_spdk_malloc_test", vtophys_spdk_malloc_test) == NULL ||
+		CU_add_test(suite, "vtophys_pages_test", vtophys_pages_test) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -189,5 +189,26 @@ trap - SIGINT SIGTERM EXIT
 
 killprocess $server_pid
 
-iscsitestfini
 timing_exit sock_server
+
+# ----------------
+# Test sock_perf
+# ----------------
+
+timing_enter sock_perf
+
+SOCK_PERF_APP="${TARGET_NS_CMD[*]} $SPDK_EXAMPLE_DIR/sock_perf"
+
+$SOCK_PERF_APP -H $TARGET_IP -P $ISCSI_PORT -S -N "posix" -m 0x1 &
+server_pid=$!
+trap 'killprocess $server_pid; iscsitestfini; exit 1' SIGINT SIGTERM EXIT
+waitforlisten $server_pid
+
+$SOCK_PERF_APP -H $TARGET_IP -P $ISCSI_PORT -N "posix" -C 2 -q 4 -t 2 -m 0x2
+
+trap - SIGINT SIGTERM EXIT
+
+killprocess $server_pid
+
+iscsitestfini
+timing_exit sock_perf
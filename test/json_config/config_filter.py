@@ -46,6 +46,7 @@ def filter_methods(do_remove_global_rpcs):
         'accel_set_options',
         'dpdk_cryptodev_scan_accel_module',
         'dpdk_cryptodev_set_driver',
+        'ipsec_mb_scan_accel_module',
         'virtio_blk_create_transport',
         'iobuf_set_options',
     ]
@@ -250,6 +250,7 @@ esnap_clone_io(void)
 	malloc_opts.name = "bs_malloc";
 	malloc_opts.num_blocks = bs_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
+	malloc_opts.numa_node = SPDK_ENV_SOCKET_ID_ANY;
 	rc = create_malloc_disk(&bs_bdev, &malloc_opts);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
 
@@ -268,6 +269,7 @@ esnap_clone_io(void)
 	malloc_opts.name = "esnap_malloc";
 	malloc_opts.num_blocks = esnap_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
+	malloc_opts.numa_node = SPDK_ENV_SOCKET_ID_ANY;
 	rc = create_malloc_disk(&esnap_bdev, &malloc_opts);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
 
@@ -392,6 +394,7 @@ esnap_hotplug(void)
 	malloc_opts.name = "esnap_malloc";
 	malloc_opts.num_blocks = esnap_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
+	malloc_opts.numa_node = SPDK_ENV_SOCKET_ID_ANY;
 	rc = create_malloc_disk(&malloc_bdev, &malloc_opts);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
 
@@ -492,6 +495,7 @@ esnap_remove_degraded(void)
 	malloc_opts.name = "esnap";
 	malloc_opts.num_blocks = esnap_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
+	malloc_opts.numa_node = SPDK_ENV_SOCKET_ID_ANY;
 	rc = create_malloc_disk(&malloc_bdev, &malloc_opts);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
 
@@ -0,0 +1,256 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/coroutine.h"
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+/*
+ * Compares the cost of a step of an asynchronous control path written as a callback chain,
+ * where each step allocates its context, with the same path written as a coroutine suspending
+ * itself on each step.  Each operation completes through a message sent to the current thread.
+ */
+
+static int g_time_in_sec;
+static uint64_t g_end_tsc;
+static uint64_t g_start_tsc;
+static uint64_t g_step_count;
+
+typedef void (*op_cb)(void *cb_arg, int status);
+
+struct op_ctx {
+	op_cb	cb_fn;
+	void	*cb_arg;
+};
+
+static void
+op_complete(void *arg)
+{
+	struct op_ctx *op = arg;
+
+	op->cb_fn(op->cb_arg, 0);
+	free(op);
+}
+
+/* Asynchronous operation, completing from the thread's message queue */
+static int
+op_submit(op_cb cb_fn, void *cb_arg)
+{
+	struct op_ctx *op;
+	int rc;
+
+	op = calloc(1, sizeof(*op));
+	if (op == NULL) {
+		return -ENOMEM;
+	}
+
+	op->cb_fn = cb_fn;
+	op->cb_arg = cb_arg;
+
+	rc = spdk_thread_send_msg(spdk_get_thread(), op_complete, op);
+	if (rc != 0) {
+		free(op);
+	}
+
+	return rc;
+}
+
+static void
+test_failed(const char *name, int rc)
+{
+	fprintf(stderr, "%s test failed: %s\n", name, spdk_strerror(-rc));
+	spdk_app_stop(rc);
+}
+
+static void
+print_result(const char *name)
+{
+	uint64_t cost_cyc, cost_nsec;
+
+	cost_cyc = (spdk_get_ticks() - g_start_tsc) / spdk_max(g_step_count, 1);
+	cost_nsec = cost_cyc * SPDK_SEC_TO_NSEC / spdk_get_ticks_hz();
+
+	printf("\r %-10s steps: %12" PRIu64 " cost: %6" PRIu64 " (cyc), %6" PRIu64 " (nsec)\n",
+	       name, g_step_count, cost_cyc, cost_nsec);
+}
+
+static void
+start_test(void)
+{
+	g_step_count = 0;
+	g_start_tsc = spdk_get_ticks();
+	g_end_tsc = g_start_tsc + g_time_in_sec * spdk_get_ticks_hz();
+}
+
+struct step_ctx {
+	uint64_t	step;
+};
+
+static void coroutine_test(void);
+
+static void
+callback_step_done(void *cb_arg, int status)
+{
+	struct step_ctx *ctx = cb_arg;
+	struct step_ctx *next;
+	int rc;
+
+	if (status != 0) {
+		free(ctx);
+		test_failed("callback", status);
+		return;
+	}
+
+	g_step_count++;
+	if (spdk_get_ticks() >= g_end_tsc) {
+		free(ctx);
+		print_result("callback");
+		coroutine_test();
+		return;
+	}
+
+	/* Each step of a callback chain keeps its state in a heap-allocated context */
+	next = calloc(1, sizeof(*next));
+	if (next == NULL) {
+		free(ctx);
+		test_failed("callback", -ENOMEM);
+		return;
+	}
+
+	next->step = ctx->step + 1;
+	free(ctx);
+
+	rc = op_submit(callback_step_done, next);
+	if (rc != 0) {
+		free(next);
+		test_failed("callback", rc);
+	}
+}
+
+static void
+callback_test(void)
+{
+	struct step_ctx *ctx;
+	int rc;
+
+	start_test();
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		test_failed("callback", -ENOMEM);
+		return;
+	}
+
+	rc = op_submit(callback_step_done, ctx);
+	if (rc != 0) {
+		free(ctx);
+		test_failed("callback", rc);
+	}
+}
+
+static void
+coroutine_fn(void *arg)
+{
+	uint64_t step = 0;
+	int rc;
+
+	while (spdk_get_ticks() < g_end_tsc) {
+		rc = op_submit(spdk_coroutine_wake_cb, spdk_coroutine_get_current());
+		if (rc == 0) {
+			rc = spdk_coroutine_await();
+		}
+		if (rc != 0) {
+			test_failed("coroutine", rc);
+			return;
+		}
+		step++;
+		g_step_count++;
+	}
+
+	print_result("coroutine");
+	spdk_app_stop(0);
+}
+
+static void
+coroutine_test(void)
+{
+	int rc;
+
+	start_test();
+
+	rc = spdk_coroutine_start(coroutine_fn, NULL);
+	if (rc != 0) {
+		test_failed("coroutine", rc);
+	}
+}
+
+static void
+coroutine_perf_start(void *arg1)
+{
+	printf("Running each test for %d seconds.\n", g_time_in_sec);
+	fflush(stdout);
+
+	callback_test();
+}
+
+static int
+coroutine_perf_parse_arg(int ch, char *arg)
+{
+	int tmp;
+
+	tmp = spdk_strtol(optarg, 10);
+	if (tmp < 0) {
+		fprintf(stderr, "Parse failed for the option %c.\n", ch);
+		return tmp;
+	}
+
+	switch (ch) {
+	case 't':
+		g_time_in_sec = tmp;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+coroutine_perf_usage(void)
+{
+	printf(" -t <time>              run time of each test in seconds\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts;
+	int rc;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "coroutine_perf";
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "t:", NULL,
+				 coroutine_perf_parse_arg, coroutine_perf_usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc;
+	}
+
+	if (g_time_in_sec <= 0) {
+		fprintf(stderr, "run time must be positive\n");
+		return -EINVAL;
+	}
+
+	rc = spdk_app_start(&opts, coroutine_perf_start, NULL);
+
+	spdk_app_fini();
+
+	return rc;
+}
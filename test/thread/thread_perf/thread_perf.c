@@ -0,0 +1,799 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/json.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+/*
+ * Measures the building blocks of the thread library, one test after another:
+ *  - the round trip latency of a message between the app thread and a thread on another core,
+ *    which is the wakeup latency of a sleeping reactor when running in interrupt mode,
+ *  - the throughput of messages forwarded around a ring of threads,
+ *  - the cost of spdk_for_each_channel() against the number of threads holding a channel,
+ *  - the dispatch cost of active and timed pollers.
+ * The results can be written as JSON, to track them between releases.
+ */
+
+#define POLLER_TIMED_PERIOD_USEC	1
+
+struct perf_thread {
+	struct spdk_thread	*thread;
+	uint32_t		core;
+	struct spdk_io_channel	*ch;
+	uint64_t		msgs;
+};
+
+struct perf_token {
+	uint32_t		idx;
+};
+
+struct latency_result {
+	uint64_t		round_trips;
+	uint64_t		total_ticks;
+	uint64_t		min_ticks;
+	uint64_t		max_ticks;
+};
+
+struct throughput_result {
+	uint64_t		msgs;
+	uint64_t		ticks;
+};
+
+struct channel_result {
+	uint32_t		num_threads;
+	uint64_t		iterations;
+	uint64_t		ticks;
+};
+
+struct poller_result {
+	const char		*type;
+	uint64_t		period_usec;
+	uint64_t		runs;
+	uint64_t		ticks;
+};
+
+static int g_time_in_sec = 1;
+static int g_queue_depth = 32;
+static int g_num_pollers = 100;
+static uint32_t g_num_threads;
+static const char *g_json_file;
+static int g_rc;
+
+static struct spdk_thread *g_app_thread;
+static struct perf_thread *g_threads;
+static struct perf_thread *g_peer;
+static uint64_t g_start_tsc;
+static uint64_t g_end_tsc;
+static uint64_t g_msg_tsc;
+
+static uint32_t g_num_tokens;
+static bool g_stop;
+
+static int g_io_device;
+static bool g_io_device_registered;
+static uint32_t g_num_channels;
+static uint32_t g_pending_channels;
+
+static struct spdk_poller *g_timer;
+static struct spdk_poller **g_pollers;
+static uint64_t g_poller_runs;
+
+static uint32_t g_pending_exits;
+
+static struct latency_result g_latency = { .min_ticks = UINT64_MAX };
+static struct throughput_result g_throughput;
+static struct channel_result *g_channel_results;
+static uint32_t g_num_channel_results;
+static struct poller_result g_poller_results[] = {
+	{ "active", 0 },
+	{ "timed", POLLER_TIMED_PERIOD_USEC },
+};
+static uint32_t g_num_poller_results;
+
+static void throughput_test(void);
+static void channel_test(void);
+static void poller_test(void);
+static void thread_perf_finish(void);
+
+/* The tests can't make progress without their messages, failing to send one is fatal */
+static void
+send_msg(struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+{
+	int rc;
+
+	rc = spdk_thread_send_msg(thread, fn, ctx);
+	if (rc != 0) {
+		fprintf(stderr, "Failed to send a message: %s\n", spdk_strerror(-rc));
+		abort();
+	}
+}
+
+static double
+ticks_to_nsec(uint64_t ticks, uint64_t ops)
+{
+	return (double)ticks * SPDK_SEC_TO_NSEC / spdk_get_ticks_hz() / spdk_max(ops, 1);
+}
+
+static double
+rate_per_sec(uint64_t count, uint64_t ticks)
+{
+	return (double)count * spdk_get_ticks_hz() / spdk_max(ticks, 1);
+}
+
+static void
+start_test(void)
+{
+	g_start_tsc = spdk_get_ticks();
+	g_end_tsc = g_start_tsc + g_time_in_sec * spdk_get_ticks_hz();
+}
+
+static const char *
+latency_name(void)
+{
+	return spdk_interrupt_mode_is_enabled() ? "wakeup_latency" : "msg_latency";
+}
+
+static void latency_ping(void *arg);
+
+static void
+latency_pong(void *arg)
+{
+	uint64_t now, ticks;
+
+	now = spdk_get_ticks();
+	ticks = now - g_msg_tsc;
+
+	g_latency.round_trips++;
+	g_latency.total_ticks += ticks;
+	g_latency.min_ticks = spdk_min(g_latency.min_ticks, ticks);
+	g_latency.max_ticks = spdk_max(g_latency.max_ticks, ticks);
+
+	if (now >= g_end_tsc) {
+		printf("%-16s round trips: %10" PRIu64 " avg: %10.1f min: %10.1f max: %10.1f"
+		       " (nsec)\n", latency_name(), g_latency.round_trips,
+		       ticks_to_nsec(g_latency.total_ticks, g_latency.round_trips),
+		       ticks_to_nsec(g_latency.min_ticks, 1),
+		       ticks_to_nsec(g_latency.max_ticks, 1));
+		throughput_test();
+		return;
+	}
+
+	g_msg_tsc = spdk_get_ticks();
+	send_msg(g_peer->thread, latency_ping, NULL);
+}
+
+static void
+latency_ping(void *arg)
+{
+	send_msg(g_app_thread, latency_pong, NULL);
+}
+
+static void
+latency_test(void)
+{
+	printf("Measuring %s between core %u and core %u for %d seconds\n", latency_name(),
+	       spdk_env_get_current_core(), g_peer->core, g_time_in_sec);
+
+	start_test();
+	g_msg_tsc = spdk_get_ticks();
+	send_msg(g_peer->thread, latency_ping, NULL);
+}
+
+static void
+throughput_done(void *arg)
+{
+	uint32_t i;
+
+	for (i = 0; i < g_num_threads; i++) {
+		g_throughput.msgs += g_threads[i].msgs;
+	}
+
+	printf("%-16s msgs: %10" PRIu64 " rate: %14.1f (msgs/s)\n", "msg_throughput",
+	       g_throughput.msgs, rate_per_sec(g_throughput.msgs, g_throughput.ticks));
+
+	channel_test();
+}
+
+static void
+throughput_token_free(struct perf_token *token)
+{
+	free(token);
+	if (__atomic_sub_fetch(&g_num_tokens, 1, __ATOMIC_SEQ_CST) == 0) {
+		send_msg(g_app_thread, throughput_done, NULL);
+	}
+}
+
+static void
+throughput_token(void *arg)
+{
+	struct perf_token *token = arg;
+	int rc;
+
+	if (__atomic_load_n(&g_stop, __ATOMIC_RELAXED)) {
+		throughput_token_free(token);
+		return;
+	}
+
+	/* Each thread only counts the messages it received */
+	g_threads[token->idx].msgs++;
+	token->idx = (token->idx + 1) % g_num_threads;
+
+	rc = spdk_thread_send_msg(g_threads[token->idx].thread, throughput_token, token);
+	if (rc != 0) {
+		throughput_token_free(token);
+	}
+}
+
+static int
+throughput_stop(void *arg)
+{
+	spdk_poller_unregister(&g_timer);
+
+	g_throughput.ticks = spdk_get_ticks() - g_start_tsc;
+	__atomic_store_n(&g_stop, true, __ATOMIC_RELAXED);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+throughput_test(void)
+{
+	struct perf_token *token;
+	uint32_t i;
+	int j;
+
+	printf("Forwarding %d messages per thread around %u threads for %d seconds\n",
+	       g_queue_depth, g_num_threads, g_time_in_sec);
+
+	g_num_tokens = g_num_threads * g_queue_depth;
+	start_test();
+
+	for (i = 0; i < g_num_threads; i++) {
+		for (j = 0; j < g_queue_depth; j++) {
+			token = calloc(1, sizeof(*token));
+			if (token == NULL) {
+				fprintf(stderr, "Failed to allocate the message tokens\n");
+				abort();
+			}
+			token->idx = i;
+
+			send_msg(g_threads[i].thread, throughput_token, token);
+		}
+	}
+
+	g_timer = SPDK_POLLER_REGISTER(throughput_stop, NULL, g_time_in_sec * SPDK_SEC_TO_USEC);
+}
+
+static int
+channel_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+channel_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static void channel_step(void);
+
+static void
+channel_msg(struct spdk_io_channel_iter *i)
+{
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+channel_iter_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct channel_result *result = &g_channel_results[g_num_channel_results - 1];
+	uint64_t now;
+
+	result->iterations++;
+
+	now = spdk_get_ticks();
+	if (now < g_end_tsc) {
+		spdk_for_each_channel(&g_io_device, channel_msg, NULL, channel_iter_done);
+		return;
+	}
+
+	result->ticks = now - g_start_tsc;
+	printf("%-16s threads: %7u iterations: %10" PRIu64 " avg: %10.1f (nsec)\n",
+	       "for_each_channel", result->num_threads, result->iterations,
+	       ticks_to_nsec(result->ticks, result->iterations));
+
+	if (g_num_channels == g_num_threads) {
+		poller_test();
+		return;
+	}
+
+	channel_step();
+}
+
+static void
+channel_got(void *arg)
+{
+	struct channel_result *result;
+
+	if (--g_pending_channels > 0) {
+		return;
+	}
+
+	result = &g_channel_results[g_num_channel_results++];
+	result->num_threads = g_num_channels;
+
+	start_test();
+	spdk_for_each_channel(&g_io_device, channel_msg, NULL, channel_iter_done);
+}
+
+static void
+channel_get(void *arg)
+{
+	struct perf_thread *pt = arg;
+
+	pt->ch = spdk_get_io_channel(&g_io_device);
+	assert(pt->ch != NULL);
+
+	send_msg(g_app_thread, channel_got, NULL);
+}
+
+/* Double the number of threads holding a channel, up to all the threads */
+static void
+channel_step(void)
+{
+	uint32_t num_channels, i;
+
+	num_channels = spdk_min(spdk_max(g_num_channels * 2, 1), g_num_threads);
+	g_pending_channels = num_channels - g_num_channels;
+
+	for (i = g_num_channels; i < num_channels; i++) {
+		send_msg(g_threads[i].thread, channel_get, &g_threads[i]);
+	}
+
+	g_num_channels = num_channels;
+}
+
+static void
+channel_test(void)
+{
+	printf("Iterating over the channels of up to %u threads for %d seconds per step\n",
+	       g_num_threads, g_time_in_sec);
+
+	/* One step per power of two below the number of threads, plus one for all of them */
+	g_channel_results = calloc(spdk_u32log2(g_num_threads) + 2, sizeof(*g_channel_results));
+	if (g_channel_results == NULL) {
+		fprintf(stderr, "Failed to allocate the channel results\n");
+		g_rc = -ENOMEM;
+		thread_perf_finish();
+		return;
+	}
+
+	spdk_io_device_register(&g_io_device, channel_create_cb, channel_destroy_cb, 0,
+				"thread_perf");
+	g_io_device_registered = true;
+
+	channel_step();
+}
+
+static int
+poller_run(void *arg)
+{
+	g_poller_runs++;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+poller_done(void *arg)
+{
+	struct poller_result *result = arg;
+
+	printf("%-16s type: %-6s pollers: %5d runs: %12" PRIu64 " cost: %8.1f (nsec)\n",
+	       "pollers", result->type, g_num_pollers, result->runs,
+	       ticks_to_nsec(result->ticks, result->runs));
+
+	g_num_poller_results++;
+	poller_test();
+}
+
+static int
+poller_stop(void *arg)
+{
+	struct poller_result *result = arg;
+	int i;
+
+	result->ticks = spdk_get_ticks() - g_start_tsc;
+	result->runs = g_poller_runs;
+
+	spdk_poller_unregister(&g_timer);
+	for (i = 0; i < g_num_pollers; i++) {
+		spdk_poller_unregister(&g_pollers[i]);
+	}
+
+	send_msg(g_app_thread, poller_done, result);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+poller_start(void *arg)
+{
+	struct poller_result *result = arg;
+	int i;
+
+	g_poller_runs = 0;
+	for (i = 0; i < g_num_pollers; i++) {
+		g_pollers[i] = SPDK_POLLER_REGISTER(poller_run, NULL, result->period_usec);
+		assert(g_pollers[i] != NULL);
+	}
+
+	g_timer = SPDK_POLLER_REGISTER(poller_stop, result, g_time_in_sec * SPDK_SEC_TO_USEC);
+	g_start_tsc = spdk_get_ticks();
+}
+
+static void
+poller_test(void)
+{
+	struct poller_result *result;
+
+	/* Pollers of threads in interrupt mode are not dispatched by polling */
+	if (spdk_interrupt_mode_is_enabled() ||
+	    g_num_poller_results == SPDK_COUNTOF(g_poller_results)) {
+		thread_perf_finish();
+		return;
+	}
+
+	if (g_pollers == NULL) {
+		g_pollers = calloc(g_num_pollers, sizeof(*g_pollers));
+		if (g_pollers == NULL) {
+			fprintf(stderr, "Failed to allocate the pollers\n");
+			g_rc = -ENOMEM;
+			thread_perf_finish();
+			return;
+		}
+	}
+
+	result = &g_poller_results[g_num_poller_results];
+	printf("Running %d %s pollers on core %u for %d seconds\n", g_num_pollers,
+	       result->type, g_peer->core, g_time_in_sec);
+
+	send_msg(g_peer->thread, poller_start, result);
+}
+
+static int
+json_write_cb(void *cb_ctx, const void *data, size_t size)
+{
+	FILE *f = cb_ctx;
+	size_t rc;
+
+	rc = fwrite(data, 1, size, f);
+	return rc == size ? 0 : -1;
+}
+
+static int
+dump_results(void)
+{
+	struct spdk_json_write_ctx *w;
+	struct channel_result *channel;
+	struct poller_result *poller;
+	FILE *f;
+	uint32_t i;
+	int rc;
+
+	f = fopen(g_json_file, "w");
+	if (f == NULL) {
+		fprintf(stderr, "Failed to open %s: %s\n", g_json_file, spdk_strerror(errno));
+		return -errno;
+	}
+
+	w = spdk_json_write_begin(json_write_cb, f, SPDK_JSON_WRITE_FLAG_FORMATTED);
+	if (w == NULL) {
+		fclose(f);
+		return -ENOMEM;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "tsc_rate", spdk_get_ticks_hz());
+	spdk_json_write_named_int32(w, "time_in_sec", g_time_in_sec);
+	spdk_json_write_named_bool(w, "interrupt_mode", spdk_interrupt_mode_is_enabled());
+	spdk_json_write_named_uint32(w, "num_cores", spdk_env_get_core_count());
+	spdk_json_write_named_uint32(w, "num_threads", g_num_threads);
+
+	if (g_latency.round_trips > 0) {
+		spdk_json_write_named_object_begin(w, latency_name());
+		spdk_json_write_named_uint64(w, "round_trips", g_latency.round_trips);
+		spdk_json_write_named_double(w, "avg_nsec", ticks_to_nsec(g_latency.total_ticks,
+					     g_latency.round_trips));
+		spdk_json_write_named_double(w, "min_nsec", ticks_to_nsec(g_latency.min_ticks, 1));
+		spdk_json_write_named_double(w, "max_nsec", ticks_to_nsec(g_latency.max_ticks, 1));
+		spdk_json_write_object_end(w);
+	}
+
+	if (g_throughput.ticks > 0) {
+		spdk_json_write_named_object_begin(w, "msg_throughput");
+		spdk_json_write_named_int32(w, "queue_depth", g_queue_depth);
+		spdk_json_write_named_uint64(w, "msgs", g_throughput.msgs);
+		spdk_json_write_named_double(w, "msgs_per_sec",
+					     rate_per_sec(g_throughput.msgs, g_throughput.ticks));
+		spdk_json_write_object_end(w);
+	}
+
+	spdk_json_write_named_array_begin(w, "for_each_channel");
+	for (i = 0; i < g_num_channel_results; i++) {
+		channel = &g_channel_results[i];
+		if (channel->iterations == 0) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "num_threads", channel->num_threads);
+		spdk_json_write_named_uint64(w, "iterations", channel->iterations);
+		spdk_json_write_named_double(w, "avg_nsec",
+					     ticks_to_nsec(channel->ticks, channel->iterations));
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_named_array_begin(w, "pollers");
+	for (i = 0; i < g_num_poller_results; i++) {
+		poller = &g_poller_results[i];
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "type", poller->type);
+		spdk_json_write_named_uint64(w, "period_usec", poller->period_usec);
+		spdk_json_write_named_int32(w, "num_pollers", g_num_pollers);
+		spdk_json_write_named_uint64(w, "runs", poller->runs);
+		spdk_json_write_named_double(w, "nsec_per_run",
+					     ticks_to_nsec(poller->ticks, poller->runs));
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+
+	rc = spdk_json_write_end(w);
+	fputc('\n', f);
+	fclose(f);
+
+	return rc;
+}
+
+static void
+thread_perf_done(void)
+{
+	int rc;
+
+	if (g_io_device_registered) {
+		spdk_io_device_unregister(&g_io_device, NULL);
+	}
+
+	if (g_rc == 0 && g_json_file != NULL) {
+		rc = dump_results();
+		if (rc != 0) {
+			fprintf(stderr, "Failed to write the results to %s\n", g_json_file);
+			g_rc = rc;
+		}
+	}
+
+	free(g_pollers);
+	free(g_channel_results);
+	free(g_threads);
+
+	spdk_app_stop(g_rc);
+}
+
+static void
+worker_exited(void *arg)
+{
+	if (--g_pending_exits == 0) {
+		thread_perf_done();
+	}
+}
+
+static void
+worker_exit(void *arg)
+{
+	struct perf_thread *pt = arg;
+
+	if (pt->ch != NULL) {
+		spdk_put_io_channel(pt->ch);
+		pt->ch = NULL;
+	}
+
+	spdk_thread_exit(spdk_get_thread());
+
+	send_msg(g_app_thread, worker_exited, NULL);
+}
+
+static void
+thread_perf_finish(void)
+{
+	uint32_t i;
+
+	if (g_num_threads == 0) {
+		thread_perf_done();
+		return;
+	}
+
+	g_pending_exits = g_num_threads;
+	for (i = 0; i < g_num_threads; i++) {
+		send_msg(g_threads[i].thread, worker_exit, &g_threads[i]);
+	}
+}
+
+static int
+create_threads(void)
+{
+	struct spdk_cpuset cpumask;
+	struct perf_thread *pt;
+	char name[32];
+	uint32_t core, i, num_threads;
+
+	num_threads = g_num_threads;
+	g_num_threads = 0;
+
+	g_threads = calloc(num_threads, sizeof(*g_threads));
+	if (g_threads == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Spread the threads round-robin over the cores, starting after the main core */
+	core = spdk_env_get_next_core(spdk_env_get_current_core());
+	for (i = 0; i < num_threads; i++) {
+		if (core == UINT32_MAX) {
+			core = spdk_env_get_first_core();
+		}
+
+		pt = &g_threads[i];
+		pt->core = core;
+
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, core, true);
+		snprintf(name, sizeof(name), "thread_perf_%u", i);
+
+		pt->thread = spdk_thread_create(name, &cpumask);
+		if (pt->thread == NULL) {
+			return -ENOMEM;
+		}
+
+		g_num_threads++;
+		core = spdk_env_get_next_core(core);
+	}
+
+	return 0;
+}
+
+static void
+thread_perf_start(void *arg1)
+{
+	int rc;
+
+	g_app_thread = spdk_get_thread();
+
+	if (g_num_threads == 0) {
+		g_num_threads = spdk_env_get_core_count();
+	}
+
+	rc = create_threads();
+	if (rc != 0) {
+		fprintf(stderr, "Failed to create the threads: %s\n", spdk_strerror(-rc));
+		g_rc = rc;
+		thread_perf_finish();
+		return;
+	}
+
+	/* The first thread is on another core than the app thread, if there is another core */
+	g_peer = &g_threads[0];
+
+	printf("Running with %u threads on %u cores\n", g_num_threads, spdk_env_get_core_count());
+	latency_test();
+}
+
+static int
+thread_perf_parse_arg(int ch, char *arg)
+{
+	int tmp;
+
+	switch (ch) {
+	case 'E':
+		spdk_interrupt_mode_enable();
+		return 0;
+	case 'j':
+		g_json_file = arg;
+		return 0;
+	default:
+		break;
+	}
+
+	tmp = spdk_strtol(arg, 10);
+	if (tmp < 0) {
+		fprintf(stderr, "Parse failed for the option %c.\n", ch);
+		return tmp;
+	}
+
+	switch (ch) {
+	case 'b':
+		g_num_pollers = tmp;
+		break;
+	case 'q':
+		g_queue_depth = tmp;
+		break;
+	case 't':
+		g_time_in_sec = tmp;
+		break;
+	case 'T':
+		g_num_threads = tmp;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+thread_perf_usage(void)
+{
+	printf(" -b <number>            number of pollers (default: 100)\n");
+	printf(" -E                     run in interrupt mode\n");
+	printf(" -j <file>              write the results as JSON to the file\n");
+	printf(" -q <number>            messages in flight per thread (default: 32)\n");
+	printf(" -t <time>              run time of each test in seconds (default: 1)\n");
+	printf(" -T <number>            number of threads (default: one per core)\n");
+}
+
+static int
+thread_perf_verify_params(void)
+{
+	if (g_num_pollers <= 0) {
+		fprintf(stderr, "number of pollers must be positive\n");
+		return -EINVAL;
+	}
+
+	if (g_queue_depth <= 0) {
+		fprintf(stderr, "number of messages in flight must be positive\n");
+		return -EINVAL;
+	}
+
+	if (g_time_in_sec <= 0) {
+		fprintf(stderr, "run time must be positive\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts;
+	int rc;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "thread_perf";
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "b:Ej:q:t:T:", NULL,
+				 thread_perf_parse_arg, thread_perf_usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc;
+	}
+
+	rc = thread_perf_verify_params();
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = spdk_app_start(&opts, thread_perf_start, NULL);
+
+	spdk_app_fini();
+
+	return rc;
+}
@@ -142,6 +142,7 @@ test_setup(void)
 	g_sw_ch = (struct sw_accel_io_channel *)((char *)g_module_ch + sizeof(
 				struct spdk_io_channel));
 	TAILQ_INIT(&g_sw_ch->tasks_to_complete);
+	TAILQ_INIT(&g_sw_ch->crc32c_tasks);
 	g_module_if.supports_opcode = _supports_opcode;
 	return 0;
 }
@@ -406,6 +407,7 @@ test_spdk_accel_submit_crc32c(void)
 	struct spdk_accel_task task;
 	struct spdk_accel_task *expected_accel_task = NULL;
 
+	memset(src, 0x5a, sizeof(src));
 	TAILQ_INIT(&g_accel_ch->task_pool);
 
 	/* Fail with no tasks on _get_task() */
@@ -420,6 +422,12 @@ test_spdk_accel_submit_crc32c(void)
 	CU_ASSERT(task.crc_dst == &crc_dst);
 	CU_ASSERT(task.seed == seed);
 	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_CRC32C);
+	/* The software module checksums CRC-32C tasks together in its poller */
+	CU_ASSERT(TAILQ_EMPTY(&g_sw_ch->tasks_to_complete));
+	CU_ASSERT(TAILQ_FIRST(&g_sw_ch->crc32c_tasks) == &task);
+	_sw_accel_crc32c_tasks(g_sw_ch);
+	CU_ASSERT(TAILQ_EMPTY(&g_sw_ch->crc32c_tasks));
+	CU_ASSERT(crc_dst == spdk_crc32c_update(src, nbytes, ~seed));
 	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
 	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
 	CU_ASSERT(expected_accel_task == &task);
@@ -457,8 +465,8 @@ test_spdk_accel_submit_crc32cv(void)
 	CU_ASSERT(task.seed == seed);
 	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_CRC32C);
 	CU_ASSERT(task.cb_arg == cb_arg);
-	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
-	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->crc32c_tasks);
+	TAILQ_REMOVE(&g_sw_ch->crc32c_tasks, expected_accel_task, link);
 	CU_ASSERT(expected_accel_task == &task);
 
 	for (i = 0; i < iov_cnt; i++) {
@@ -497,8 +505,8 @@ test_spdk_accel_submit_copy_crc32c(void)
 	CU_ASSERT(task.seed == seed);
 	CU_ASSERT(task.flags == 0);
 	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_COPY_CRC32C);
-	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
-	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->crc32c_tasks);
+	TAILQ_REMOVE(&g_sw_ch->crc32c_tasks, expected_accel_task, link);
 	CU_ASSERT(expected_accel_task == &task);
 }
 
@@ -537,6 +545,278 @@ test_spdk_accel_submit_xor(void)
 	CU_ASSERT(expected_accel_task == &task);
 }
 
+#define TEST_DIF_BLOCK_SIZE 520
+#define TEST_DIF_MD_SIZE 8
+#define TEST_DIF_DATA_SIZE (TEST_DIF_BLOCK_SIZE - TEST_DIF_MD_SIZE)
+#define TEST_DIF_NUM_BLOCKS 2
+
+static void
+ut_dif_ctx_init(struct spdk_dif_ctx *ctx)
+{
+	struct spdk_dif_ctx_init_ext_opts dif_opts;
+	int rc;
+
+	dif_opts.size = SPDK_SIZEOF(&dif_opts, dif_pi_format);
+	dif_opts.dif_pi_format = SPDK_DIF_PI_FORMAT_16;
+	rc = spdk_dif_ctx_init(ctx, TEST_DIF_BLOCK_SIZE, TEST_DIF_MD_SIZE, true, false,
+			       SPDK_DIF_TYPE1, SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK |
+			       SPDK_DIF_FLAGS_REFTAG_CHECK, 0x10, 0xFFFF, 0x1234, 0, 0, &dif_opts);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+}
+
+static void
+test_spdk_accel_submit_dif_verify(void)
+{
+	uint8_t buf[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+	struct spdk_dif_ctx ctx;
+	struct spdk_dif_error err;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+	int rc;
+
+	ut_dif_ctx_init(&ctx);
+	memset(buf, 0xa5, sizeof(buf));
+	rc = spdk_dif_generate(&iov, 1, TEST_DIF_NUM_BLOCKS, &ctx);
+	CU_ASSERT(rc == 0);
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_dif_verify(g_ch, &iov, 1, TEST_DIF_NUM_BLOCKS, &ctx, &err, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* submission OK. */
+	rc = spdk_accel_submit_dif_verify(g_ch, &iov, 1, TEST_DIF_NUM_BLOCKS, &ctx, &err, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.s.iovs == &iov);
+	CU_ASSERT(task.s.iovcnt == 1);
+	CU_ASSERT(task.dif.ctx == &ctx);
+	CU_ASSERT(task.dif.err == &err);
+	CU_ASSERT(task.dif.num_blocks == TEST_DIF_NUM_BLOCKS);
+	CU_ASSERT(task.nbytes == sizeof(buf));
+	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_DIF_VERIFY);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+
+	/* Corrupt the data of the second block, the guard check should fail */
+	buf[TEST_DIF_BLOCK_SIZE] ^= 0xff;
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	memset(&err, 0, sizeof(err));
+
+	rc = spdk_accel_submit_dif_verify(g_ch, &iov, 1, TEST_DIF_NUM_BLOCKS, &ctx, &err, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status != 0);
+	CU_ASSERT(err.err_type == SPDK_DIF_GUARD_ERROR);
+	CU_ASSERT(err.err_offset == 1);
+}
+
+static void
+test_spdk_accel_submit_dif_generate(void)
+{
+	uint8_t buf[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+	struct spdk_dif_ctx ctx;
+	struct spdk_dif_error err;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+	int rc;
+
+	ut_dif_ctx_init(&ctx);
+	memset(buf, 0x5a, sizeof(buf));
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_dif_generate(g_ch, &iov, 1, TEST_DIF_NUM_BLOCKS, &ctx, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* submission OK. */
+	rc = spdk_accel_submit_dif_generate(g_ch, &iov, 1, TEST_DIF_NUM_BLOCKS, &ctx, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.s.iovs == &iov);
+	CU_ASSERT(task.s.iovcnt == 1);
+	CU_ASSERT(task.dif.ctx == &ctx);
+	CU_ASSERT(task.dif.num_blocks == TEST_DIF_NUM_BLOCKS);
+	CU_ASSERT(task.nbytes == sizeof(buf));
+	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_DIF_GENERATE);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+
+	/* The generated protection information must verify */
+	rc = spdk_dif_verify(&iov, 1, TEST_DIF_NUM_BLOCKS, &ctx, &err);
+	CU_ASSERT(rc == 0);
+}
+
+static void
+test_spdk_accel_submit_dif_generate_copy(void)
+{
+	uint8_t src[TEST_DIF_DATA_SIZE * TEST_DIF_NUM_BLOCKS];
+	uint8_t dst[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS] = {0};
+	struct iovec src_iov = { .iov_base = src, .iov_len = sizeof(src) };
+	struct iovec dst_iov = { .iov_base = dst, .iov_len = sizeof(dst) };
+	struct spdk_dif_ctx ctx;
+	struct spdk_dif_error err;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+	int rc;
+
+	ut_dif_ctx_init(&ctx);
+	memset(src, 0x3c, sizeof(src));
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_dif_generate_copy(g_ch, &dst_iov, 1, &src_iov, 1, TEST_DIF_NUM_BLOCKS,
+			&ctx, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* submission OK. */
+	rc = spdk_accel_submit_dif_generate_copy(g_ch, &dst_iov, 1, &src_iov, 1, TEST_DIF_NUM_BLOCKS,
+			&ctx, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.s.iovs == &src_iov);
+	CU_ASSERT(task.s.iovcnt == 1);
+	CU_ASSERT(task.d.iovs == &dst_iov);
+	CU_ASSERT(task.d.iovcnt == 1);
+	CU_ASSERT(task.dif.ctx == &ctx);
+	CU_ASSERT(task.dif.num_blocks == TEST_DIF_NUM_BLOCKS);
+	CU_ASSERT(task.nbytes == sizeof(src));
+	CU_ASSERT(task.op_code == SPDK_ACCEL_OPC_DIF_GENERATE_COPY);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+
+	/* The data must be copied and the protection information must verify */
+	CU_ASSERT(memcmp(dst, src, TEST_DIF_DATA_SIZE) == 0);
+	CU_ASSERT(memcmp(&dst[TEST_DIF_BLOCK_SIZE], &src[TEST_DIF_DATA_SIZE], TEST_DIF_DATA_SIZE) == 0);
+	rc = spdk_dif_verify(&dst_iov, 1, TEST_DIF_NUM_BLOCKS, &ctx, &err);
+	CU_ASSERT(rc == 0);
+}
+
+static TAILQ_HEAD(, spdk_accel_task) g_route_tasks = TAILQ_HEAD_INITIALIZER(g_route_tasks);
+
+static int
+ut_route_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+{
+	TAILQ_INSERT_TAIL(&g_route_tasks, task, link);
+
+	return 0;
+}
+
+static void
+test_accel_opc_route(void)
+{
+	struct spdk_accel_module_if small_module_if = {
+		.name = "small",
+		.submit_tasks = ut_route_submit_tasks,
+	};
+	struct spdk_accel_module_if spill_module_if = {
+		.name = "spill",
+		.submit_tasks = ut_route_submit_tasks,
+	};
+	struct accel_module *opc = &g_modules_opc[SPDK_ACCEL_OPC_COPY];
+	struct accel_operation_stats *stats = &g_accel_ch->stats.operations[SPDK_ACCEL_OPC_COPY];
+	struct spdk_accel_task tasks[3], *task;
+	uint8_t src[128] = {}, dst[128] = {};
+	uint32_t cb_arg = DUMMY_ARG;
+	int rc, i;
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+	for (i = 0; i < 3; i++) {
+		TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &tasks[i], link);
+	}
+	memset(&g_accel_ch->stats, 0, sizeof(g_accel_ch->stats));
+	g_accel_ch->outstanding[SPDK_ACCEL_OPC_COPY] = 0;
+
+	opc->small_module = &small_module_if;
+	opc->small_threshold = 64;
+	opc->spill_module = &spill_module_if;
+	opc->spill_qd = 1;
+	g_accel_ch->small_ch[SPDK_ACCEL_OPC_COPY] = g_module_ch;
+	g_accel_ch->spill_ch[SPDK_ACCEL_OPC_COPY] = g_module_ch;
+
+	/* Operations below the threshold go to the small module */
+	rc = spdk_accel_submit_copy(g_ch, dst, src, 32, 0, dummy_cb_fn, &cb_arg);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(tasks[0].route, ACCEL_ROUTE_SMALL);
+	CU_ASSERT_EQUAL(TAILQ_FIRST(&g_route_tasks), &tasks[0]);
+	CU_ASSERT_EQUAL(g_accel_ch->outstanding[SPDK_ACCEL_OPC_COPY], 0);
+
+	/* Larger ones go to the primary module until its queue is full... */
+	rc = spdk_accel_submit_copy(g_ch, dst, src, sizeof(src), 0, dummy_cb_fn, &cb_arg);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(tasks[1].route, ACCEL_ROUTE_PRIMARY);
+	CU_ASSERT_EQUAL(TAILQ_FIRST(&g_sw_ch->tasks_to_complete), &tasks[1]);
+	CU_ASSERT_EQUAL(g_accel_ch->outstanding[SPDK_ACCEL_OPC_COPY], 1);
+
+	/* ...and then spill over to the secondary module */
+	rc = spdk_accel_submit_copy(g_ch, dst, src, sizeof(src), 0, dummy_cb_fn, &cb_arg);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(tasks[2].route, ACCEL_ROUTE_SPILL);
+	CU_ASSERT_EQUAL(TAILQ_NEXT(&tasks[0], link), &tasks[2]);
+	CU_ASSERT_EQUAL(g_accel_ch->outstanding[SPDK_ACCEL_OPC_COPY], 1);
+
+	/* Complete everything and check the per-route stats */
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, &tasks[1], link);
+	spdk_accel_task_complete(&tasks[1], 0);
+	CU_ASSERT_EQUAL(g_accel_ch->outstanding[SPDK_ACCEL_OPC_COPY], 0);
+	while ((task = TAILQ_FIRST(&g_route_tasks)) != NULL) {
+		TAILQ_REMOVE(&g_route_tasks, task, link);
+		spdk_accel_task_complete(task, 0);
+	}
+
+	CU_ASSERT_EQUAL(stats->executed, 3);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_PRIMARY].executed, 1);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_SMALL].executed, 1);
+	CU_ASSERT_EQUAL(stats->routes[ACCEL_ROUTE_SPILL].executed, 1);
+	CU_ASSERT_STRING_EQUAL(_accel_get_route_module_name(SPDK_ACCEL_OPC_COPY, ACCEL_ROUTE_SMALL),
+			       "small");
+	CU_ASSERT_STRING_EQUAL(_accel_get_route_module_name(SPDK_ACCEL_OPC_COPY, ACCEL_ROUTE_SPILL),
+			       "spill");
+	CU_ASSERT_PTR_NULL(_accel_get_route_module_name(SPDK_ACCEL_OPC_FILL, ACCEL_ROUTE_SMALL));
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT_EQUAL(tasks[i].route, ACCEL_ROUTE_NONE);
+	}
+
+	/* Routing can't be configured for crypto operations or with invalid thresholds */
+	g_modules_started = false;
+	rc = spdk_accel_assign_opc_route(SPDK_ACCEL_OPC_ENCRYPT, "small", 64, NULL, 0);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	rc = spdk_accel_assign_opc_route(SPDK_ACCEL_OPC_COPY, "small", 0, NULL, 0);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	rc = spdk_accel_assign_opc_route(SPDK_ACCEL_OPC_COPY, NULL, 0, "spill", 0);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	rc = spdk_accel_assign_opc_route(SPDK_ACCEL_OPC_COPY, "small", 64, "spill", 8);
+	CU_ASSERT_EQUAL(rc, 0);
+	SPDK_CU_ASSERT_FATAL(g_modules_opc_route[SPDK_ACCEL_OPC_COPY] != NULL);
+	CU_ASSERT_STRING_EQUAL(g_modules_opc_route[SPDK_ACCEL_OPC_COPY]->small_module, "small");
+	CU_ASSERT_EQUAL(g_modules_opc_route[SPDK_ACCEL_OPC_COPY]->spill_qd, 8);
+	/* Passing no modules clears the routing */
+	rc = spdk_accel_assign_opc_route(SPDK_ACCEL_OPC_COPY, NULL, 0, NULL, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_PTR_NULL(g_modules_opc_route[SPDK_ACCEL_OPC_COPY]);
+
+	opc->small_module = NULL;
+	opc->spill_module = NULL;
+	g_accel_ch->small_ch[SPDK_ACCEL_OPC_COPY] = NULL;
+	g_accel_ch->spill_ch[SPDK_ACCEL_OPC_COPY] = NULL;
+}
+
 static void
 test_spdk_accel_module_find_by_name(void)
 {
@@ -2818,6 +3098,115 @@ ut_submit_decompress_memory_domain(struct spdk_io_channel *ch, struct spdk_accel
 	return 0;
 }
 
+static bool g_ut_can_access_domain;
+
+static bool
+ut_can_access_memory_domain(struct spdk_memory_domain *domain)
+{
+	return g_ut_can_access_domain && domain == g_ut_domain;
+}
+
+static void
+test_sequence_native_memory_domain(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct accel_io_channel *accel_ch;
+	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	struct accel_operation_stats *stats;
+	struct ut_sequence ut_seq;
+	struct ut_domain_ctx domctx[2];
+	struct iovec src_iovs[1], dst_iovs[1];
+	char srcbuf[4096], dstbuf[4096], expected[4096];
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+	accel_ch = spdk_io_channel_get_ctx(ioch);
+	stats = &accel_ch->stats.operations[SPDK_ACCEL_OPC_DECOMPRESS];
+
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	g_module_if.can_access_memory_domain = ut_can_access_memory_domain;
+	g_module.supports_memory_domains = false;
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+
+	/* The module can access the domain, so the buffers should be passed as is */
+	g_ut_can_access_domain = true;
+	memset(stats, 0, sizeof(*stats));
+	seq = NULL;
+	completed = 0;
+
+	src_iovs[0].iov_base = (void *)0xcafebabe;
+	src_iovs[0].iov_len = sizeof(srcbuf);
+	dst_iovs[0].iov_base = (void *)0xbeefdead;
+	dst_iovs[0].iov_len = sizeof(dstbuf);
+	ut_domain_ctx_init(&domctx[0], dstbuf, sizeof(dstbuf), &dst_iovs[0]);
+	ut_domain_ctx_init(&domctx[1], srcbuf, sizeof(srcbuf), &src_iovs[0]);
+
+	rc = spdk_accel_append_decompress(&seq, ioch, &dst_iovs[0], 1, g_ut_domain, &domctx[0],
+					  &src_iovs[0], 1, g_ut_domain, &domctx[1], 0,
+					  ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].src_iovs = &src_iovs[0];
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].src_iovcnt = 1;
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].src_domain = g_ut_domain;
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].src_domain_ctx = &domctx[1];
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].dst_iovs = &dst_iovs[0];
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].dst_iovcnt = 1;
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].dst_domain = g_ut_domain;
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].dst_domain_ctx = &domctx[0];
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 1);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].count, 1);
+	CU_ASSERT_EQUAL(stats->num_bounce_bufs, 0);
+	CU_ASSERT_EQUAL(stats->bounce_bytes, 0);
+	ut_clear_operations();
+
+	/* Now the module can't access it, so both buffers need to be bounced */
+	g_ut_can_access_domain = false;
+	g_seq_operations[SPDK_ACCEL_OPC_DECOMPRESS].submit = ut_submit_decompress;
+	memset(srcbuf, 0xa5, sizeof(srcbuf));
+	memset(expected, 0xa5, sizeof(expected));
+	memset(dstbuf, 0, sizeof(dstbuf));
+	seq = NULL;
+	completed = 0;
+
+	rc = spdk_accel_append_decompress(&seq, ioch, &dst_iovs[0], 1, g_ut_domain, &domctx[0],
+					  &src_iovs[0], 1, g_ut_domain, &domctx[1], 0,
+					  ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 1);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(memcmp(dstbuf, expected, sizeof(dstbuf)), 0);
+	CU_ASSERT_EQUAL(stats->num_bounce_bufs, 2);
+	CU_ASSERT_EQUAL(stats->bounce_bytes, sizeof(srcbuf) + sizeof(dstbuf));
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	g_module_if.can_access_memory_domain = NULL;
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
 static void
 test_sequence_module_memory_domain(void)
 {
@@ -3913,7 +4302,7 @@ test_sequence_crc32(void)
 	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
 
 	/* Check crc+copy - this time the copy cannot be removed, because there's no operation
-	 * before crc to change the buffer */
+	 * before crc to change the buffer, so both operations should be fused into copy_crc32c */
 	seq = NULL;
 	completed = 0;
 	crc = 0;
@@ -3942,12 +4331,12 @@ test_sequence_crc32(void)
 	CU_ASSERT_EQUAL(completed, 2);
 	CU_ASSERT(ut_seq.complete);
 	CU_ASSERT_EQUAL(ut_seq.status, 0);
-	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 1);
-	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count, 1);
 	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(tmp[0], sizeof(tmp[0]), ~0u));
 	CU_ASSERT_EQUAL(memcmp(buf, tmp[0], sizeof(buf)), 0);
-	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
-	g_seq_operations[SPDK_ACCEL_OPC_COPY].count = 0;
+	g_seq_operations[SPDK_ACCEL_OPC_COPY_CRC32C].count = 0;
 
 	/* Check a sequence with an operation at the beginning that can have its buffer changed, two
 	 * crc operations and a copy at the end.  The copy should be removed and the dst buffer of
@@ -4062,6 +4451,689 @@ test_sequence_crc32(void)
 	poll_threads();
 }
 
+static int
+ut_submit_encrypt_crc32c(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+{
+	spdk_iovmove(task->s.iovs, task->s.iovcnt, task->d.iovs, task->d.iovcnt);
+	*task->fused_crc_dst = spdk_crc32c_iov_update(task->d.iovs, task->d.iovcnt,
+			       ~task->fused_seed);
+
+	spdk_accel_task_complete(task, 0);
+
+	return 0;
+}
+
+static void
+test_sequence_encrypt_crc32c(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct spdk_accel_crypto_key key = {};
+	struct ut_sequence ut_seq;
+	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	char buf[4096], data[4096];
+	struct iovec src_iovs[2], dst_iovs[2];
+	uint32_t crc;
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Override the submit_tasks function */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_seq_operations[i].submit = sw_accel_submit_tasks;
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+	g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT].submit = ut_submit_crypto;
+	g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT_CRC32C].submit = ut_submit_encrypt_crc32c;
+
+	/* Check encrypt+crc32c of the encrypted data - both should be fused into encrypt_crc32c */
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	memset(buf, 0, sizeof(buf));
+	memset(data, 0xa5, sizeof(data));
+
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf);
+	src_iovs[0].iov_base = data;
+	src_iovs[0].iov_len = sizeof(data);
+	rc = spdk_accel_append_encrypt(&seq, ioch, &key, &dst_iovs[0], 1, NULL, NULL,
+				       &src_iovs[0], 1, NULL, NULL, 0, 4096, 0,
+				       ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	src_iovs[1].iov_base = buf;
+	src_iovs[1].iov_len = sizeof(buf);
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[1], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(memcmp(buf, data, sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(data, sizeof(data), ~0u));
+	g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT_CRC32C].count = 0;
+
+	/* Check that the operations aren't fused if crc32c isn't calculated over the encrypted
+	 * data */
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	memset(buf, 0, sizeof(buf));
+	memset(data, 0x5a, sizeof(data));
+
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf);
+	src_iovs[0].iov_base = data;
+	src_iovs[0].iov_len = sizeof(data);
+	rc = spdk_accel_append_encrypt(&seq, ioch, &key, &dst_iovs[0], 1, NULL, NULL,
+				       &src_iovs[0], 1, NULL, NULL, 0, 4096, 0,
+				       ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	src_iovs[1].iov_base = data;
+	src_iovs[1].iov_len = sizeof(data);
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[1], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(data, sizeof(data), ~0u));
+	g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT].count = 0;
+	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
+
+	/* Check that the operations aren't fused if encrypt_crc32c is handled by a different
+	 * module than encrypt */
+	g_modules_opc[SPDK_ACCEL_OPC_ENCRYPT_CRC32C] = modules[SPDK_ACCEL_OPC_ENCRYPT_CRC32C];
+	SPDK_CU_ASSERT_FATAL(g_modules_opc[SPDK_ACCEL_OPC_ENCRYPT_CRC32C].module != g_module.module);
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	memset(buf, 0, sizeof(buf));
+	memset(data, 0xfe, sizeof(data));
+
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf);
+	src_iovs[0].iov_base = data;
+	src_iovs[0].iov_len = sizeof(data);
+	rc = spdk_accel_append_encrypt(&seq, ioch, &key, &dst_iovs[0], 1, NULL, NULL,
+				       &src_iovs[0], 1, NULL, NULL, 0, 4096, 0,
+				       ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	src_iovs[1].iov_base = buf;
+	src_iovs[1].iov_len = sizeof(buf);
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[1], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(memcmp(buf, data, sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(data, sizeof(data), ~0u));
+	g_seq_operations[SPDK_ACCEL_OPC_ENCRYPT].count = 0;
+	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static int
+ut_submit_compress(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+{
+	/* Pretend the data is incompressible */
+	spdk_iovmove(task->s.iovs, task->s.iovcnt, task->d.iovs, task->d.iovcnt);
+	if (task->output_size != NULL) {
+		*task->output_size = (uint32_t)accel_get_iovlen(task->s.iovs, task->s.iovcnt);
+	}
+
+	spdk_accel_task_complete(task, 0);
+
+	return 0;
+}
+
+static void
+test_sequence_compress(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_seq;
+	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	char buf[4096], tmp[2][4096], expected[4096];
+	struct iovec src_iovs[3], dst_iovs[3];
+	uint32_t output_size;
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Override the submit_tasks function */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+	g_seq_operations[SPDK_ACCEL_OPC_COMPRESS].submit = ut_submit_compress;
+
+	/* Check a single compress operation */
+	seq = NULL;
+	completed = 0;
+	output_size = 0;
+	memset(expected, 0xa5, sizeof(expected));
+	memset(buf, 0, sizeof(buf));
+
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf);
+	src_iovs[0].iov_base = expected;
+	src_iovs[0].iov_len = sizeof(expected);
+	rc = spdk_accel_append_compress(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+					&src_iovs[0], 1, NULL, NULL, &output_size, 0,
+					ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 1);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COMPRESS].count, 1);
+	CU_ASSERT_EQUAL(output_size, sizeof(expected));
+	CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(buf)), 0);
+	g_seq_operations[SPDK_ACCEL_OPC_COMPRESS].count = 0;
+
+	/* Put the compress between two copies, both of them should be removed */
+	seq = NULL;
+	completed = 0;
+	output_size = 0;
+	memset(expected, 0x5a, sizeof(expected));
+	memset(buf, 0, sizeof(buf));
+
+	dst_iovs[0].iov_base = tmp[0];
+	dst_iovs[0].iov_len = sizeof(tmp[0]);
+	src_iovs[0].iov_base = expected;
+	src_iovs[0].iov_len = sizeof(expected);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	dst_iovs[1].iov_base = tmp[1];
+	dst_iovs[1].iov_len = sizeof(tmp[1]);
+	src_iovs[1].iov_base = tmp[0];
+	src_iovs[1].iov_len = sizeof(tmp[0]);
+	rc = spdk_accel_append_compress(&seq, ioch, &dst_iovs[1], 1, NULL, NULL,
+					&src_iovs[1], 1, NULL, NULL, &output_size, 0,
+					ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	dst_iovs[2].iov_base = buf;
+	dst_iovs[2].iov_len = sizeof(buf);
+	src_iovs[2].iov_base = tmp[1];
+	src_iovs[2].iov_len = sizeof(tmp[1]);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[2], 1, NULL, NULL,
+				    &src_iovs[2], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 3);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COMPRESS].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(output_size, sizeof(expected));
+	CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(buf)), 0);
+	g_seq_operations[SPDK_ACCEL_OPC_COMPRESS].count = 0;
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static void
+test_sequence_xor(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_seq;
+	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	char buf[4096], tmp[4096], src1[4096], src2[4096], expected[4096];
+	void *sources[] = { src1, src2 };
+	struct iovec src_iovs[2], dst_iovs[2];
+	uint32_t crc;
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Override the submit_tasks function */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_seq_operations[i].submit = sw_accel_submit_tasks;
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+
+	memset(src1, 0xa5, sizeof(src1));
+	memset(src2, 0x0f, sizeof(src2));
+	memset(expected, 0xa5 ^ 0x0f, sizeof(expected));
+
+	/* Check xor+crc+copy - the copy should be removed, the xor should write directly to the
+	 * final buffer and the crc should be calculated on it */
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	memset(buf, 0, sizeof(buf));
+	memset(tmp, 0, sizeof(tmp));
+
+	dst_iovs[0].iov_base = tmp;
+	dst_iovs[0].iov_len = sizeof(tmp);
+	rc = spdk_accel_append_xor(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				   sources, SPDK_COUNTOF(sources), ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	src_iovs[0].iov_base = tmp;
+	src_iovs[0].iov_len = sizeof(tmp);
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[0], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	dst_iovs[1].iov_base = buf;
+	dst_iovs[1].iov_len = sizeof(buf);
+	src_iovs[1].iov_base = tmp;
+	src_iovs[1].iov_len = sizeof(tmp);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[1], 1, NULL, NULL,
+				    &src_iovs[1], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 3);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_XOR].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(expected, sizeof(expected), ~0u));
+	g_seq_operations[SPDK_ACCEL_OPC_XOR].count = 0;
+	g_seq_operations[SPDK_ACCEL_OPC_CRC32C].count = 0;
+
+	/* Check that multiple destination buffers are rejected */
+	seq = NULL;
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf) / 2;
+	dst_iovs[1].iov_base = &buf[sizeof(buf) / 2];
+	dst_iovs[1].iov_len = sizeof(buf) / 2;
+	rc = spdk_accel_append_xor(&seq, ioch, dst_iovs, 2, NULL, NULL,
+				   sources, SPDK_COUNTOF(sources), ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	CU_ASSERT_PTR_NULL(seq);
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static void
+test_sequence_dif(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_seq;
+	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	uint8_t buf[TEST_DIF_DATA_SIZE * TEST_DIF_NUM_BLOCKS];
+	uint8_t tmp[TEST_DIF_DATA_SIZE * TEST_DIF_NUM_BLOCKS];
+	uint8_t dst[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS];
+	struct iovec src_iovs[2], dst_iovs[2];
+	struct spdk_dif_ctx ctx, bad_ctx;
+	struct spdk_dif_error err;
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Override the submit_tasks function */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_seq_operations[i].submit = sw_accel_submit_tasks;
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+
+	ut_dif_ctx_init(&ctx);
+
+	/* Check copy+generate_copy+verify - the copy should be removed and generate_copy should
+	 * read directly from the source buffer */
+	seq = NULL;
+	completed = 0;
+	memset(buf, 0xa5, sizeof(buf));
+	memset(tmp, 0, sizeof(tmp));
+	memset(dst, 0, sizeof(dst));
+
+	dst_iovs[0].iov_base = tmp;
+	dst_iovs[0].iov_len = sizeof(tmp);
+	src_iovs[0].iov_base = buf;
+	src_iovs[0].iov_len = sizeof(buf);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	dst_iovs[1].iov_base = dst;
+	dst_iovs[1].iov_len = sizeof(dst);
+	src_iovs[1].iov_base = tmp;
+	src_iovs[1].iov_len = sizeof(tmp);
+	rc = spdk_accel_append_dif_generate_copy(&seq, ioch, &dst_iovs[1], 1, NULL, NULL,
+			&src_iovs[1], 1, NULL, NULL, TEST_DIF_NUM_BLOCKS, &ctx,
+			ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_accel_append_dif_verify(&seq, ioch, &dst_iovs[1], 1, NULL, NULL,
+					  TEST_DIF_NUM_BLOCKS, &ctx, &err,
+					  ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 3);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_DIF_GENERATE_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_DIF_VERIFY].count, 1);
+	CU_ASSERT_EQUAL(memcmp(dst, buf, TEST_DIF_DATA_SIZE), 0);
+	CU_ASSERT_EQUAL(memcmp(&dst[TEST_DIF_BLOCK_SIZE], &buf[TEST_DIF_DATA_SIZE],
+			       TEST_DIF_DATA_SIZE), 0);
+	g_seq_operations[SPDK_ACCEL_OPC_DIF_GENERATE_COPY].count = 0;
+	g_seq_operations[SPDK_ACCEL_OPC_DIF_VERIFY].count = 0;
+
+	/* Check that an in-place generate followed by a verify of a corrupted block fails the
+	 * whole sequence */
+	seq = NULL;
+	completed = 0;
+	memset(dst, 0x5a, sizeof(dst));
+
+	rc = spdk_accel_append_dif_generate(&seq, ioch, &dst_iovs[1], 1, NULL, NULL,
+					    TEST_DIF_NUM_BLOCKS, &ctx,
+					    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Use a different context for the verify, so that the reference tag doesn't match */
+	bad_ctx = ctx;
+	bad_ctx.init_ref_tag++;
+	memset(&err, 0, sizeof(err));
+	rc = spdk_accel_append_dif_verify(&seq, ioch, &dst_iovs[1], 1, NULL, NULL,
+					  TEST_DIF_NUM_BLOCKS, &bad_ctx, &err,
+					  ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_NOT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(err.err_type, SPDK_DIF_REFTAG_ERROR);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_DIF_GENERATE].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[SPDK_ACCEL_OPC_DIF_VERIFY].count, 1);
+	g_seq_operations[SPDK_ACCEL_OPC_DIF_GENERATE].count = 0;
+	g_seq_operations[SPDK_ACCEL_OPC_DIF_VERIFY].count = 0;
+
+	/* In-place generate isn't allowed on buffers from a memory domain */
+	seq = NULL;
+	rc = spdk_accel_append_dif_generate(&seq, ioch, &dst_iovs[1], 1, g_ut_domain, NULL,
+					    TEST_DIF_NUM_BLOCKS, &ctx,
+					    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	CU_ASSERT_PTR_NULL(seq);
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static TAILQ_HEAD(, spdk_accel_task) g_ut_slot_tasks = TAILQ_HEAD_INITIALIZER(g_ut_slot_tasks);
+static uint32_t g_ut_num_bound_keys;
+static uint32_t g_ut_max_bound_keys;
+
+static int
+ut_key_slot_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+{
+	CU_ASSERT(task->crypto_key->slot.bound);
+	TAILQ_INSERT_TAIL(&g_ut_slot_tasks, task, link);
+
+	return 0;
+}
+
+static void
+ut_key_slot_complete_tasks(void)
+{
+	struct spdk_accel_task *task;
+
+	while ((task = TAILQ_FIRST(&g_ut_slot_tasks)) != NULL) {
+		TAILQ_REMOVE(&g_ut_slot_tasks, task, link);
+		spdk_accel_task_complete(task, 0);
+	}
+}
+
+static int
+ut_key_slot_bind(struct spdk_accel_crypto_key *key)
+{
+	/* The module can't bind more keys than the limit it reports */
+	if (g_ut_num_bound_keys == g_ut_max_bound_keys) {
+		return -ENOMEM;
+	}
+
+	g_ut_num_bound_keys++;
+
+	return 0;
+}
+
+static void
+ut_key_slot_unbind(struct spdk_accel_crypto_key *key)
+{
+	CU_ASSERT_EQUAL(key->slot.outstanding, 0);
+	g_ut_num_bound_keys--;
+}
+
+static uint32_t
+ut_key_slot_get_max_bound_keys(void)
+{
+	return g_ut_max_bound_keys;
+}
+
+static struct spdk_accel_module_if g_ut_key_slot_module = {
+	.name = "ut_key_slot",
+	.submit_tasks = ut_key_slot_submit_tasks,
+	.crypto_key_bind = ut_key_slot_bind,
+	.crypto_key_unbind = ut_key_slot_unbind,
+	.crypto_get_max_bound_keys = ut_key_slot_get_max_bound_keys,
+};
+
+static void
+ut_key_slot_encrypt_done(void *cb_arg, int status)
+{
+	CU_ASSERT_EQUAL(status, 0);
+}
+
+static int
+ut_key_slot_encrypt(struct spdk_io_channel *ioch, struct spdk_accel_crypto_key *key)
+{
+	static char buf[4096];
+	static struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+
+	return spdk_accel_submit_encrypt(ioch, key, &iov, 1, &iov, 1, 0, sizeof(buf), 0,
+					 ut_key_slot_encrypt_done, NULL);
+}
+
+static void
+test_crypto_key_slots(void)
+{
+	struct spdk_accel_crypto_key keys[3] = {};
+	struct spdk_io_channel *ioch;
+	struct accel_io_channel *accel_ch;
+	struct accel_module modules[SPDK_ACCEL_OPC_LAST];
+	struct accel_crypto_key_slot_stats stats;
+	int i, rc;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+	accel_ch = spdk_io_channel_get_ctx(ioch);
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		modules[i] = g_modules_opc[i];
+	}
+	g_modules_opc[SPDK_ACCEL_OPC_ENCRYPT].module = &g_ut_key_slot_module;
+	for (i = 0; i < 3; ++i) {
+		keys[i].module_if = &g_ut_key_slot_module;
+		keys[i].param.key_name = "ut_key";
+	}
+	g_ut_max_bound_keys = 2;
+	memset(&g_key_slot_stats, 0, sizeof(g_key_slot_stats));
+	memset(&accel_ch->stats, 0, sizeof(accel_ch->stats));
+
+	/* Keys are bound on first use */
+	rc = ut_key_slot_encrypt(ioch, &keys[0]);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = ut_key_slot_encrypt(ioch, &keys[1]);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = ut_key_slot_encrypt(ioch, &keys[0]);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(accel_ch->stats.crypto_key_misses, 2);
+	CU_ASSERT_EQUAL(accel_ch->stats.crypto_key_hits, 1);
+	CU_ASSERT_EQUAL(keys[0].slot.outstanding, 2);
+	CU_ASSERT_EQUAL(g_ut_num_bound_keys, 2);
+	ut_key_slot_complete_tasks();
+	CU_ASSERT_EQUAL(keys[0].slot.outstanding, 0);
+	CU_ASSERT_EQUAL(keys[1].slot.outstanding, 0);
+
+	/* The least recently used key is unbound, keys[0] was used after being bound */
+	rc = ut_key_slot_encrypt(ioch, &keys[2]);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT(keys[0].slot.bound);
+	CU_ASSERT(!keys[1].slot.bound);
+	CU_ASSERT(keys[2].slot.bound);
+	CU_ASSERT_EQUAL(g_key_slot_stats.evictions, 1);
+	CU_ASSERT_EQUAL(g_ut_num_bound_keys, 2);
+
+	/* Keys used by outstanding tasks can't be unbound */
+	rc = ut_key_slot_encrypt(ioch, &keys[0]);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = ut_key_slot_encrypt(ioch, &keys[1]);
+	CU_ASSERT_EQUAL(rc, -ENOMEM);
+	CU_ASSERT_EQUAL(keys[1].slot.outstanding, 0);
+	CU_ASSERT_EQUAL(g_key_slot_stats.bind_failures, 1);
+	CU_ASSERT(keys[0].slot.bound);
+	CU_ASSERT(keys[2].slot.bound);
+
+	ut_key_slot_complete_tasks();
+	rc = ut_key_slot_encrypt(ioch, &keys[1]);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT(keys[1].slot.bound);
+	CU_ASSERT_EQUAL(g_key_slot_stats.evictions, 2);
+	ut_key_slot_complete_tasks();
+
+	/* Prefetching binds a key without a task, keys that are already bound are skipped */
+	CU_ASSERT(!keys[0].slot.bound);
+	rc = spdk_accel_crypto_key_prefetch(&keys[1]);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_key_slot_stats.prefetches, 0);
+	rc = spdk_accel_crypto_key_prefetch(&keys[0]);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT(keys[0].slot.bound);
+	CU_ASSERT(keys[1].slot.bound);
+	CU_ASSERT(!keys[2].slot.bound);
+	CU_ASSERT_EQUAL(g_key_slot_stats.prefetches, 1);
+	CU_ASSERT_EQUAL(g_key_slot_stats.evictions, 3);
+
+	/* A prefetched key is kept until a task gets to use it */
+	rc = spdk_accel_crypto_key_prefetch(&keys[2]);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT(keys[0].slot.bound);
+	CU_ASSERT(!keys[1].slot.bound);
+	CU_ASSERT(keys[2].slot.bound);
+	CU_ASSERT_EQUAL(g_key_slot_stats.prefetches, 2);
+	CU_ASSERT_EQUAL(g_key_slot_stats.evictions, 4);
+
+	CU_ASSERT(accel_crypto_key_get_slot_stats(&stats));
+	CU_ASSERT_EQUAL(stats.max_bound, 2);
+	CU_ASSERT_EQUAL(stats.num_bound, 2);
+
+	spdk_spin_lock(&g_keyring_spin);
+	for (i = 0; i < 3; ++i) {
+		if (keys[i].slot.bound) {
+			accel_crypto_key_unbind(&keys[i]);
+		}
+	}
+	spdk_spin_unlock(&g_keyring_spin);
+	CU_ASSERT_EQUAL(g_ut_num_bound_keys, 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_bound_keys));
+
+	for (i = 0; i < SPDK_ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
 static int
 test_sequence_setup(void)
 {
@@ -4141,6 +5213,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(seq_suite, test_sequence_copy_elision);
 	CU_ADD_TEST(seq_suite, test_sequence_accel_buffers);
 	CU_ADD_TEST(seq_suite, test_sequence_memory_domain);
+	CU_ADD_TEST(seq_suite, test_sequence_native_memory_domain);
 	CU_ADD_TEST(seq_suite, test_sequence_module_memory_domain);
 #ifdef SPDK_CONFIG_ISAL_CRYPTO /* accel_sw requires isa-l-crypto for crypto operations */
 	CU_ADD_TEST(seq_suite, test_sequence_crypto);
@@ -4148,6 +5221,11 @@ main(int argc, char **argv)
 	CU_ADD_TEST(seq_suite, test_sequence_driver);
 	CU_ADD_TEST(seq_suite, test_sequence_same_iovs);
 	CU_ADD_TEST(seq_suite, test_sequence_crc32);
+	CU_ADD_TEST(seq_suite, test_sequence_encrypt_crc32c);
+	CU_ADD_TEST(seq_suite, test_sequence_compress);
+	CU_ADD_TEST(seq_suite, test_sequence_xor);
+	CU_ADD_TEST(seq_suite, test_sequence_dif);
+	CU_ADD_TEST(seq_suite, test_crypto_key_slots);
 
 	suite = CU_add_suite("accel", test_setup, test_cleanup);
 	CU_ADD_TEST(suite, test_spdk_accel_task_complete);
@@ -4160,8 +5238,12 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_accel_submit_crc32cv);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_copy_crc32c);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_xor);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_dif_verify);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_dif_generate);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_dif_generate_copy);
 	CU_ADD_TEST(suite, test_spdk_accel_module_find_by_name);
 	CU_ADD_TEST(suite, test_spdk_accel_module_register);
+	CU_ADD_TEST(suite, test_accel_opc_route);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
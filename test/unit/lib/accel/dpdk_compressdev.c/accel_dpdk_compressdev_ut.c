@@ -269,10 +269,15 @@ spdk_vtophys(const void *buf, uint64_t *size)
 }
 
 static uint16_t ut_rte_compressdev_dequeue_burst = 0;
+static int ut_dequeue_calls = 0;
+static uint16_t ut_dequeue_nb_ops = 0;
 uint16_t
 rte_compressdev_dequeue_burst(uint8_t dev_id, uint16_t qp_id, struct rte_comp_op **ops,
 			      uint16_t nb_op)
 {
+	ut_dequeue_calls++;
+	ut_dequeue_nb_ops = nb_op;
+
 	if (ut_rte_compressdev_dequeue_burst == 0) {
 		return 0;
 	}
@@ -315,6 +320,7 @@ _get_mbuf_array(struct rte_mbuf **mbuf_array, struct rte_mbuf *mbuf_head,
 #define FAKE_ENQUEUE_ERROR 128
 #define FAKE_ENQUEUE_BUSY 64
 static uint16_t ut_enqueue_value = FAKE_ENQUEUE_SUCCESS;
+static int ut_enqueue_calls = 0;
 static struct rte_comp_op ut_expected_op;
 uint16_t
 rte_compressdev_enqueue_burst(uint8_t dev_id, uint16_t qp_id, struct rte_comp_op **ops,
@@ -325,13 +331,15 @@ rte_compressdev_enqueue_burst(uint8_t dev_id, uint16_t qp_id, struct rte_comp_op
 	struct rte_mbuf *exp_mbuf[UT_MBUFS_PER_OP_BOUND_TEST];
 	int i, num_src_mbufs = UT_MBUFS_PER_OP;
 
+	ut_enqueue_calls++;
+
 	switch (ut_enqueue_value) {
 	case FAKE_ENQUEUE_BUSY:
 		op->status = RTE_COMP_OP_STATUS_NOT_PROCESSED;
 		return 0;
 	case FAKE_ENQUEUE_SUCCESS:
 		op->status = RTE_COMP_OP_STATUS_SUCCESS;
-		return 1;
+		return nb_ops;
 	case FAKE_ENQUEUE_ERROR:
 		op->status = RTE_COMP_OP_STATUS_ERROR;
 		return 0;
@@ -549,25 +557,32 @@ test_compress_operation(void)
 	CU_ASSERT(rc == 0);
 	ut_rte_pktmbuf_alloc_bulk = 0;
 
-	/* test enqueue failure busy */
+	/* test enqueue failure busy, the op is kept for the next burst */
 	ut_enqueue_value = FAKE_ENQUEUE_BUSY;
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	rc = _compress_operation(g_comp_ch, &task);
-	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == false);
-	while (!TAILQ_EMPTY(&g_comp_ch->queued_tasks)) {
-		task_p = TAILQ_FIRST(&g_comp_ch->queued_tasks);
-		TAILQ_REMOVE(&g_comp_ch->queued_tasks, task_p, link);
-	}
-	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == 0);
-	ut_enqueue_value = 1;
+	CU_ASSERT(g_comp_ch->num_enq_ops == 1);
+	rc = compress_enqueue_ops(g_comp_ch);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_comp_ch->num_enq_ops == 1);
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
+	ut_enqueue_value = FAKE_ENQUEUE_SUCCESS;
+	rc = compress_enqueue_ops(g_comp_ch);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(g_comp_ch->num_enq_ops == 0);
 
-	/* test enqueue failure error */
+	/* test enqueue failure error, the task is completed with an error */
 	ut_enqueue_value = FAKE_ENQUEUE_ERROR;
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	rc = _compress_operation(g_comp_ch, &task);
+	CU_ASSERT(rc == 0);
+	ut_expected_task_status = -EINVAL;
+	rc = compress_enqueue_ops(g_comp_ch);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(g_comp_ch->num_enq_ops == 0);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
-	CU_ASSERT(rc == -EINVAL);
+	ut_expected_task_status = 0;
 	ut_enqueue_value = FAKE_ENQUEUE_SUCCESS;
 
 	/* test success with 3 vector iovec */
@@ -602,6 +617,7 @@ test_compress_operation(void)
 	rc = _compress_operation(g_comp_ch, &task);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == 0);
+	CU_ASSERT(compress_enqueue_ops(g_comp_ch) == 1);
 
 	/* test sgl out failure */
 	g_device.sgl_out = false;
@@ -709,6 +725,7 @@ test_compress_operation_cross_boundary(void)
 	rc = _compress_operation(g_comp_ch, &task);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == 0);
+	CU_ASSERT(compress_enqueue_ops(g_comp_ch) == 1);
 
 	/* Now force the 2nd IOV to get partial length from spdk_vtophys */
 	g_small_size_counter = 0;
@@ -739,6 +756,7 @@ test_compress_operation_cross_boundary(void)
 	rc = _compress_operation(g_comp_ch, &task);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == 0);
+	CU_ASSERT(compress_enqueue_ops(g_comp_ch) == 1);
 
 	/* Finally force the 3rd IOV to get partial length from spdk_vtophys */
 	g_small_size_counter = 0;
@@ -768,6 +786,7 @@ test_compress_operation_cross_boundary(void)
 	rc = _compress_operation(g_comp_ch, &task);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == 0);
+	CU_ASSERT(compress_enqueue_ops(g_comp_ch) == 1);
 
 	/* Single input iov is split on page boundary, sgl_in is not supported */
 	g_device.sgl_in = false;
@@ -897,9 +916,11 @@ test_poller(void)
 	g_done_count = 0;
 	g_comp_op[0].status = RTE_COMP_OP_STATUS_NOT_PROCESSED;
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
+	g_comp_ch->num_inflight = 1;
 	rc = comp_dev_poller((void *)g_comp_ch);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == SPDK_POLLER_BUSY);
+	CU_ASSERT(g_comp_ch->num_inflight == 0);
 	ut_expected_task_status = RTE_COMP_OP_STATUS_SUCCESS;
 
 	/* Success from dequeue, 2 ops. nothing needing to be resubmitted.
@@ -915,9 +936,12 @@ test_poller(void)
 	g_done_count = 0;
 	ut_enqueue_value = FAKE_ENQUEUE_SUCCESS;
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
+	g_comp_ch->num_inflight = 2;
 	rc = comp_dev_poller((void *)g_comp_ch);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == SPDK_POLLER_BUSY);
+	CU_ASSERT(ut_dequeue_nb_ops == 2);
+	CU_ASSERT(g_comp_ch->num_inflight == 0);
 
 	/* One to dequeue, one op to be resubmitted. */
 	ut_rte_compressdev_dequeue_burst = 1;
@@ -967,14 +991,98 @@ test_poller(void)
 			  task_to_resubmit,
 			  link);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == false);
+	g_comp_ch->num_inflight = 1;
 	rc = comp_dev_poller((void *)g_comp_ch);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == SPDK_POLLER_BUSY);
+	/* the resubmitted op is enqueued at the end of the poll */
+	CU_ASSERT(g_comp_ch->num_enq_ops == 0);
+	CU_ASSERT(g_comp_ch->num_inflight == 1);
+
+	/* Nothing in flight, the device isn't polled. */
+	g_comp_ch->num_inflight = 0;
+	ut_dequeue_calls = 0;
+	rc = comp_dev_poller((void *)g_comp_ch);
+	CU_ASSERT(rc == SPDK_POLLER_IDLE);
+	CU_ASSERT(ut_dequeue_calls == 0);
 
+	MOCK_CLEAR(rte_comp_op_alloc);
 	free(task_to_resubmit);
 	free(args);
 }
 
+static void
+test_enqueue_burst(void)
+{
+	struct iovec src_iov = { .iov_base = (void *)0x10000000, .iov_len = 0x1000 };
+	struct iovec dst_iov = { .iov_base = (void *)0x20000000, .iov_len = 0x1000 };
+	struct spdk_accel_task task = {};
+	uint32_t output_size;
+	int rc, i;
+
+	task.cb_fn = _compress_done;
+	task.op_code = SPDK_ACCEL_OPC_COMPRESS;
+	task.output_size = &output_size;
+	task.s.iovs = &src_iov;
+	task.s.iovcnt = 1;
+	task.d.iovs = &dst_iov;
+	task.d.iovcnt = 1;
+	MOCK_SET(rte_comp_op_alloc, &g_comp_op[0]);
+	ut_rte_compressdev_dequeue_burst = 0;
+	ut_enqueue_value = FAKE_ENQUEUE_SUCCESS;
+	ut_enqueue_calls = 0;
+	g_comp_ch->num_inflight = 0;
+
+	/* Ops are held back until a full burst is collected. */
+	for (i = 0; i < NUM_MAX_ENQ_BURST - 1; i++) {
+		rc = _compress_operation(g_comp_ch, &task);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(ut_enqueue_calls == 0);
+	CU_ASSERT(g_comp_ch->num_enq_ops == NUM_MAX_ENQ_BURST - 1);
+	rc = _compress_operation(g_comp_ch, &task);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ut_enqueue_calls == 1);
+	CU_ASSERT(g_comp_ch->num_enq_ops == 0);
+	CU_ASSERT(g_comp_ch->num_inflight == NUM_MAX_ENQ_BURST);
+
+	/* Or until the next poll, which only asks for as many ops as are in flight. */
+	rc = _compress_operation(g_comp_ch, &task);
+	CU_ASSERT(rc == 0);
+	rc = comp_dev_poller((void *)g_comp_ch);
+	CU_ASSERT(rc == SPDK_POLLER_BUSY);
+	CU_ASSERT(ut_dequeue_nb_ops == NUM_MAX_ENQ_BURST);
+	CU_ASSERT(ut_enqueue_calls == 2);
+	CU_ASSERT(g_comp_ch->num_enq_ops == 0);
+	CU_ASSERT(g_comp_ch->num_inflight == NUM_MAX_ENQ_BURST + 1);
+
+	/* The qp is full, ops are kept and tasks are queued once the burst is full. */
+	ut_enqueue_value = FAKE_ENQUEUE_BUSY;
+	for (i = 0; i < NUM_MAX_ENQ_BURST; i++) {
+		rc = _compress_operation(g_comp_ch, &task);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(ut_enqueue_calls == 3);
+	CU_ASSERT(g_comp_ch->num_enq_ops == NUM_MAX_ENQ_BURST);
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
+	rc = _compress_operation(g_comp_ch, &task);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_FIRST(&g_comp_ch->queued_tasks) == &task);
+	TAILQ_REMOVE(&g_comp_ch->queued_tasks, &task, link);
+
+	/* The kept ops are sent by the next poll. */
+	ut_enqueue_value = FAKE_ENQUEUE_SUCCESS;
+	g_comp_ch->num_inflight = 0;
+	rc = comp_dev_poller((void *)g_comp_ch);
+	CU_ASSERT(rc == SPDK_POLLER_BUSY);
+	CU_ASSERT(ut_enqueue_calls == 4);
+	CU_ASSERT(g_comp_ch->num_enq_ops == 0);
+	CU_ASSERT(g_comp_ch->num_inflight == NUM_MAX_ENQ_BURST);
+
+	g_comp_ch->num_inflight = 0;
+	MOCK_CLEAR(rte_comp_op_alloc);
+}
+
 static void
 test_initdrivers(void)
 {
@@ -1047,6 +1155,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_setup_compress_mbuf);
 	CU_ADD_TEST(suite, test_initdrivers);
 	CU_ADD_TEST(suite, test_poller);
+	CU_ADD_TEST(suite, test_enqueue_burst);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -1288,6 +1288,70 @@ bdev_io_wait_test(void)
 	ut_fini_bdev();
 }
 
+static void
+bdev_io_pool_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_opts bdev_opts = {};
+	struct spdk_bdev_io_pool *pool;
+	int rc;
+
+	/* All cores are on socket 1, so a single pool is created on that socket. */
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	bdev_opts.bdev_io_pool_size = 4;
+	bdev_opts.bdev_io_cache_size = 2;
+	ut_init_bdev(&bdev_opts);
+
+	CU_ASSERT(g_bdev_mgr.num_bdev_io_pools == 1);
+	pool = &g_bdev_mgr.bdev_io_pools[0];
+	CU_ASSERT(pool->socket_id == 1);
+	CU_ASSERT(pool->size == 4);
+
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	/* The first two bdev_ios come from the per-thread cache, the next two from the pool. */
+	rc = spdk_bdev_read_blocks(desc, io_ch, NULL, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, io_ch, NULL, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_mempool_count(pool->mempool) == 2);
+	rc = spdk_bdev_read_blocks(desc, io_ch, NULL, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, io_ch, NULL, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_mempool_count(pool->mempool) == 0);
+	CU_ASSERT(pool->exhausted == 0);
+
+	rc = spdk_bdev_read_blocks(desc, io_ch, NULL, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(pool->exhausted == 1);
+
+	/* The per-thread cache is refilled first, then the bdev_ios go back to the pool. */
+	stub_complete_io(4);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	CU_ASSERT(spdk_mempool_count(pool->mempool) == 2);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+
+	MOCK_CLEAR(spdk_env_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_current_core);
+}
+
 static void
 bdev_io_spans_split_test(void)
 {
@@ -3574,6 +3638,356 @@ bdev_histograms(void)
 	ut_fini_bdev();
 }
 
+static void
+bdev_split_histograms(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ch;
+	struct spdk_histogram_data *histograms[SPDK_BDEV_HISTOGRAM_NUM_SPLIT] = {};
+	int write_4k, read_128k, i, rc;
+	uint8_t buf[64 * 512];
+
+	ut_init_bdev(NULL);
+
+	bdev = allocate_bdev("bdev");
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+
+	ch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Nothing is collected as long as histograms are disabled */
+	g_status = 0;
+	spdk_bdev_histogram_get_split(bdev, histograms, histogram_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == -EFAULT);
+
+	g_status = -1;
+	spdk_bdev_histogram_enable(bdev, histogram_status_cb, NULL, true);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+
+	/* A 512B write and two 32KiB reads */
+	rc = spdk_bdev_write_blocks(desc, ch, buf, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	for (i = 0; i < 2; i++) {
+		rc = spdk_bdev_read_blocks(desc, ch, buf, 0, 64, io_done, NULL);
+		CU_ASSERT(rc == 0);
+	}
+	spdk_delay_us(10);
+	stub_complete_io(3);
+	poll_threads();
+
+	g_status = -1;
+	spdk_bdev_histogram_get_split(bdev, histograms, histogram_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+
+	write_4k = SPDK_BDEV_IO_TYPE_WRITE * SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES +
+		   SPDK_BDEV_HISTOGRAM_SIZE_4K;
+	read_128k = SPDK_BDEV_IO_TYPE_READ * SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES +
+		    SPDK_BDEV_HISTOGRAM_SIZE_128K;
+	for (i = 0; i < SPDK_BDEV_HISTOGRAM_NUM_SPLIT; i++) {
+		if (i != write_4k && i != read_128k) {
+			CU_ASSERT(histograms[i] == NULL);
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(histograms[write_4k] != NULL);
+	SPDK_CU_ASSERT_FATAL(histograms[read_128k] != NULL);
+
+	g_count = 0;
+	spdk_histogram_data_iterate(histograms[write_4k], histogram_io_count, NULL);
+	CU_ASSERT(g_count == 1);
+	g_count = 0;
+	spdk_histogram_data_iterate(histograms[read_128k], histogram_io_count, NULL);
+	CU_ASSERT(g_count == 2);
+
+	/* Reset both the aggregated and the split histograms, which stay enabled */
+	g_status = -1;
+	spdk_bdev_histogram_reset(bdev, histogram_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(bdev->internal.histogram_enabled == true);
+
+	spdk_histogram_data_reset(histograms[write_4k]);
+	spdk_histogram_data_reset(histograms[read_128k]);
+	g_status = -1;
+	spdk_bdev_histogram_get_split(bdev, histograms, histogram_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+
+	g_count = 0;
+	spdk_histogram_data_iterate(histograms[write_4k], histogram_io_count, NULL);
+	spdk_histogram_data_iterate(histograms[read_128k], histogram_io_count, NULL);
+	CU_ASSERT(g_count == 0);
+
+	g_count = 0;
+	spdk_bdev_channel_get_histogram(ch, histogram_channel_data_cb, histogram_io_count);
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(g_count == 0);
+
+	for (i = 0; i < SPDK_BDEV_HISTOGRAM_NUM_SPLIT; i++) {
+		spdk_histogram_data_free(histograms[i]);
+	}
+
+	spdk_bdev_histogram_enable(bdev, histogram_status_cb, NULL, false);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+
+	spdk_put_io_channel(ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static int g_batch_count;
+static uint32_t g_batch_num_ios;
+
+static void
+stub_submit_request_batch(struct spdk_io_channel *_ch, struct spdk_bdev_io **bdev_ios,
+			  uint32_t num_ios)
+{
+	uint32_t i;
+
+	g_batch_count++;
+	g_batch_num_ios = num_ios;
+	for (i = 0; i < num_ios; i++) {
+		stub_submit_request(_ch, bdev_ios[i]);
+	}
+}
+
+static void
+bdev_submit_batch_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ch;
+	uint8_t buf[512];
+	int i, rc;
+
+	ut_init_bdev(NULL);
+	fn_table.submit_request_batch = stub_submit_request_batch;
+
+	bdev = allocate_bdev("bdev");
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+
+	ch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Reads and writes are held until the batch is submitted, other I/O is not */
+	g_batch_count = 0;
+	spdk_bdev_start_batch(ch);
+	for (i = 0; i < 3; i++) {
+		rc = spdk_bdev_read_blocks(desc, ch, buf, i, 1, io_done, NULL);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	rc = spdk_bdev_flush_blocks(desc, ch, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+
+	spdk_bdev_submit_batch(ch);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 4);
+	CU_ASSERT(g_batch_count == 1);
+	CU_ASSERT(g_batch_num_ios == 3);
+	CU_ASSERT(stub_complete_io(4) == 4);
+	poll_threads();
+
+	/* Without a batch callback, the requests are submitted one by one */
+	fn_table.submit_request_batch = NULL;
+	spdk_bdev_start_batch(ch);
+	for (i = 0; i < 2; i++) {
+		rc = spdk_bdev_write_blocks(desc, ch, buf, i, 1, io_done, NULL);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	spdk_bdev_submit_batch(ch);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	CU_ASSERT(g_batch_count == 1);
+	CU_ASSERT(stub_complete_io(2) == 2);
+	poll_threads();
+
+	/* Submitting an empty batch is fine */
+	spdk_bdev_start_batch(ch);
+	spdk_bdev_submit_batch(ch);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+
+	spdk_put_io_channel(ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static void
+merge_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	int *count = cb_arg;
+
+	CU_ASSERT(success);
+	(*count)++;
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+bdev_io_merge_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_channel *bdev_ch;
+	struct ut_expected_io *expected_io;
+	int count = 0, rc;
+
+	ut_init_bdev(NULL);
+
+	bdev = allocate_bdev("bdev");
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+
+	ch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	bdev_ch = spdk_io_channel_get_ctx(ch);
+
+	/* Hold requests for up to 100us, merge up to 8 KiB, i.e. 16 blocks */
+	g_status = -1;
+	spdk_bdev_set_io_merge(bdev, 100, 8, histogram_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(bdev_ch->flags & BDEV_CH_MERGE_ENABLED);
+	CU_ASSERT(bdev_ch->merge.max_blocks == 16);
+
+	/* Nothing is outstanding, so the first write is submitted immediately */
+	rc = spdk_bdev_write_blocks(desc, ch, (void *)0xF000, 0, 1, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+
+	/* The next two contiguous writes are held and merged into a single request */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 1, 3, 2);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0x10000, 512);
+	ut_expected_io_set_iov(expected_io, 1, (void *)0x20000, 2 * 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	rc = spdk_bdev_write_blocks(desc, ch, (void *)0x10000, 1, 1, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, ch, (void *)0x20000, 2, 2, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+
+	stub_complete_io(2);
+	poll_threads();
+	CU_ASSERT(count == 3);
+	CU_ASSERT(bdev_ch->stat->num_write_ops == 3);
+	CU_ASSERT(bdev_ch->stat->num_merged_ops == 1);
+
+	/* A request that isn't adjacent submits the held ones first */
+	count = 0;
+	rc = spdk_bdev_read_blocks(desc, ch, (void *)0xF000, 0, 1, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, ch, (void *)0x10000, 1, 1, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	rc = spdk_bdev_read_blocks(desc, ch, (void *)0x20000, 8, 1, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+
+	/* So does a write following reads, even if it's adjacent */
+	rc = spdk_bdev_write_blocks(desc, ch, (void *)0x30000, 9, 1, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+
+	/* Reaching the maximum size submits the merged request right away */
+	rc = spdk_bdev_write_blocks(desc, ch, (void *)0x40000, 10, 15, merge_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 4);
+
+	stub_complete_io(4);
+	poll_threads();
+	CU_ASSERT(count == 5);
+	CU_ASSERT(bdev_ch->stat->num_merged_ops == 2);
+
+	/* Disable merging */
+	spdk_bdev_set_io_merge(bdev, 0, 0, histogram_status_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(bdev_ch->flags == 0);
+	CU_ASSERT(bdev_ch->merge.poller == NULL);
+
+	spdk_put_io_channel(ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static void
+bdev_read_device_stat_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_channel *bdev_ch;
+	struct spdk_bdev_io_stat *stat;
+	char buf[4096];
+	int rc;
+
+	ut_init_bdev(NULL);
+
+	bdev = allocate_bdev("bdev");
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+
+	ch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	bdev_ch = spdk_io_channel_get_ctx(ch);
+	CU_ASSERT(TAILQ_FIRST(&bdev->internal.channels) == bdev_ch);
+
+	stat = bdev_alloc_io_stat(true);
+	SPDK_CU_ASSERT_FATAL(stat != NULL);
+
+	rc = spdk_bdev_write_blocks(desc, ch, buf, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, ch, buf, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	stub_complete_io(2);
+	poll_threads();
+
+	/* The channel's statistics are read without polling its thread */
+	spdk_bdev_read_device_stat(bdev, stat);
+	CU_ASSERT(stat->num_read_ops == 1);
+	CU_ASSERT(stat->num_write_ops == 1);
+	CU_ASSERT(stat->bytes_read == bdev->blocklen);
+	CU_ASSERT(bdev_ch->stat_seq % 2 == 0);
+	CU_ASSERT(bdev_ch->stat_seq != 0);
+
+	/* The statistics of a destroyed channel are kept by the bdev */
+	spdk_put_io_channel(ch);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.channels));
+
+	spdk_bdev_read_device_stat(bdev, stat);
+	CU_ASSERT(stat->num_read_ops == 1);
+	CU_ASSERT(stat->num_write_ops == 1);
+
+	bdev_free_io_stat(stat);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 _bdev_compare(bool emulated)
 {
@@ -4779,7 +5193,7 @@ lock_lba_range_check_ranges(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -4797,7 +5211,7 @@ lock_lba_range_check_ranges(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -4842,7 +5256,7 @@ lock_lba_range_with_io_outstanding(void)
 	 */
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -4855,7 +5269,7 @@ lock_lba_range_with_io_outstanding(void)
 	spdk_delay_us(100);
 	poll_threads();
 
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
 
 	/* Now try again, but with a write I/O. */
 	g_io_done = false;
@@ -4873,7 +5287,7 @@ lock_lba_range_with_io_outstanding(void)
 	 */
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == false);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -4891,7 +5305,73 @@ lock_lba_range_with_io_outstanding(void)
 	CU_ASSERT(rc == 0);
 	poll_threads();
 
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static void
+lock_lba_range_first_lock(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *channel;
+	char buf[4096];
+	int ctx1;
+	int rc;
+
+	ut_init_bdev(NULL);
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+	channel = spdk_io_channel_get_ctx(io_ch);
+
+	/* The bdev was never locked, so the write isn't accounted */
+	g_io_done = false;
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf, 20, 1, io_done, &ctx1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(channel->lba_lock_io[0][0] == 0);
+
+	/* The first lock has the channel account it, and then waits for it */
+	g_lock_lba_range_done = false;
+	rc = bdev_lock_lba_range(desc, io_ch, 20, 10, lock_lba_range_done, &ctx1);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+
+	CU_ASSERT(channel->lba_lock_io[0][0] + channel->lba_lock_io[1][0] == 1);
+	CU_ASSERT(g_io_done == false);
+	CU_ASSERT(g_lock_lba_range_done == false);
+
+	stub_complete_io(1);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(g_lock_lba_range_done == true);
+	CU_ASSERT(channel->lba_lock_io[0][0] + channel->lba_lock_io[1][0] == 0);
+
+	rc = bdev_unlock_lba_range(desc, io_ch, 20, 10, unlock_lba_range_done, &ctx1);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
+
+	/* The writes are accounted from now on */
+	g_io_done = false;
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf, 20, 1, io_done, &ctx1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(channel->lba_lock_io[0][0] + channel->lba_lock_io[1][0] == 1);
+	stub_complete_io(1);
+	poll_threads();
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(channel->lba_lock_io[0][0] + channel->lba_lock_io[1][0] == 0);
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -4928,10 +5408,11 @@ lock_lba_range_overlapped(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
+	CU_ASSERT(range->owner_ch == channel);
 
 	/* Try to lock range 25-39.  It should not lock immediately, since it overlaps with
 	 * 20-29.
@@ -4957,7 +5438,7 @@ lock_lba_range_overlapped(void)
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
 	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.pending_locked_ranges));
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 25);
 	CU_ASSERT(range->length == 15);
@@ -5054,7 +5535,6 @@ bdev_quiesce(void)
 	struct spdk_bdev *bdev;
 	struct spdk_bdev_desc *desc = NULL;
 	struct spdk_io_channel *io_ch;
-	struct spdk_bdev_channel *channel;
 	struct lba_range *range;
 	int ctx1;
 	int rc;
@@ -5068,7 +5548,6 @@ bdev_quiesce(void)
 	CU_ASSERT(bdev == spdk_bdev_desc_get_bdev(desc));
 	io_ch = spdk_bdev_get_io_channel(desc);
 	CU_ASSERT(io_ch != NULL);
-	channel = spdk_io_channel_get_ctx(io_ch);
 
 	g_lock_lba_range_done = false;
 	rc = spdk_bdev_quiesce(bdev, &bdev_ut_if, bdev_quiesce_done, &ctx1);
@@ -5076,7 +5555,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 0);
 	CU_ASSERT(range->length == bdev->blockcnt);
@@ -5094,7 +5573,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	g_lock_lba_range_done = false;
@@ -5103,7 +5582,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5126,7 +5605,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	spdk_put_io_channel(io_ch);
@@ -7195,6 +7674,60 @@ examine_claimed(void)
 	ut_testing_examine_claimed = false;
 }
 
+static struct spdk_bdev *g_examine_nested_bdev;
+static struct ut_examine_ctx g_examine_nested_ctx;
+
+static void
+examine_register_nested(struct spdk_bdev *bdev)
+{
+	/* vbdev_ut is still examining bdev0, so bdev1's examine_disk has to wait */
+	g_examine_nested_bdev = allocate_bdev_ctx("bdev1", &g_examine_nested_ctx);
+	CU_ASSERT(g_examine_nested_ctx.examine_config_count == 1);
+	CU_ASSERT(g_examine_nested_ctx.examine_disk_count == 0);
+	CU_ASSERT(vbdev_ut_if.internal.examine_in_progress == 1);
+	CU_ASSERT(!TAILQ_EMPTY(&g_bdev_mgr.examine_pending));
+}
+
+static void
+examine_max_in_progress(void)
+{
+	struct spdk_bdev_opts bdev_opts = {};
+	struct ut_examine_ctx ctx = { 0 };
+	struct spdk_bdev *bdev;
+	uint32_t saved_max;
+	uint64_t examine_count;
+	int rc;
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	saved_max = bdev_opts.examine_max_in_progress;
+	bdev_opts.examine_max_in_progress = 1;
+	rc = spdk_bdev_set_opts(&bdev_opts);
+	CU_ASSERT(rc == 0);
+
+	examine_count = vbdev_ut_if.internal.examine_count;
+	memset(&g_examine_nested_ctx, 0, sizeof(g_examine_nested_ctx));
+	ctx.examine_disk = examine_register_nested;
+	bdev = allocate_bdev_ctx("bdev0", &ctx);
+	CU_ASSERT(ctx.examine_config_count == 1);
+	CU_ASSERT(ctx.examine_disk_count == 1);
+
+	/* The deferred examine_disk ran once bdev0's examination completed */
+	SPDK_CU_ASSERT_FATAL(g_examine_nested_bdev != NULL);
+	CU_ASSERT(g_examine_nested_ctx.examine_disk_count == 1);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_mgr.examine_pending));
+	CU_ASSERT(vbdev_ut_if.internal.examine_in_progress == 0);
+	CU_ASSERT(vbdev_ut_if.internal.examine_count == examine_count + 4);
+	CU_ASSERT(bdev_module_all_actions_completed());
+
+	free_bdev(g_examine_nested_bdev);
+	g_examine_nested_bdev = NULL;
+	free_bdev(bdev);
+
+	bdev_opts.examine_max_in_progress = saved_max;
+	rc = spdk_bdev_set_opts(&bdev_opts);
+	CU_ASSERT(rc == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -7214,6 +7747,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, get_device_stat_test);
 	CU_ADD_TEST(suite, bdev_io_types_test);
 	CU_ADD_TEST(suite, bdev_io_wait_test);
+	CU_ADD_TEST(suite, bdev_io_pool_test);
 	CU_ADD_TEST(suite, bdev_io_spans_split_test);
 	CU_ADD_TEST(suite, bdev_io_boundary_split_test);
 	CU_ADD_TEST(suite, bdev_io_max_size_and_segment_split_test);
@@ -7223,6 +7757,10 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, bdev_io_alignment_with_boundary);
 	CU_ADD_TEST(suite, bdev_io_alignment);
 	CU_ADD_TEST(suite, bdev_histograms);
+	CU_ADD_TEST(suite, bdev_split_histograms);
+	CU_ADD_TEST(suite, bdev_submit_batch_test);
+	CU_ADD_TEST(suite, bdev_io_merge_test);
+	CU_ADD_TEST(suite, bdev_read_device_stat_test);
 	CU_ADD_TEST(suite, bdev_write_zeroes);
 	CU_ADD_TEST(suite, bdev_compare_and_write);
 	CU_ADD_TEST(suite, bdev_compare);
@@ -7238,6 +7776,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lba_range_overlap);
 	CU_ADD_TEST(suite, lock_lba_range_check_ranges);
 	CU_ADD_TEST(suite, lock_lba_range_with_io_outstanding);
+	CU_ADD_TEST(suite, lock_lba_range_first_lock);
 	CU_ADD_TEST(suite, lock_lba_range_overlapped);
 	CU_ADD_TEST(suite, bdev_quiesce);
 	CU_ADD_TEST(suite, bdev_io_abort);
@@ -7264,6 +7803,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, claim_v2_existing_v1);
 	CU_ADD_TEST(suite, claim_v1_existing_v2);
 	CU_ADD_TEST(suite, examine_claimed);
+	CU_ADD_TEST(suite, examine_max_in_progress);
 
 	allocate_cores(1);
 	allocate_threads(1);
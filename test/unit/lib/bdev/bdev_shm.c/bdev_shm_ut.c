@@ -0,0 +1,908 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "common/lib/ut_multithread.c"
+#include "spdk_internal/mock.h"
+#include "unit/lib/json_mock.c"
+
+#include "bdev/shm/bdev_shm.c"
+#include "bdev/shm/bdev_shm_export.c"
+
+#define BLOCK_SIZE	512
+#define BLOCK_CNT	1024
+#define NUM_QUEUES	2
+#define QUEUE_DEPTH	4
+#define IO_SIZE		8192
+#define IO_BLOCKS	(IO_SIZE / BLOCK_SIZE)
+
+DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
+DEFINE_STUB_V(spdk_bdev_module_examine_done, (struct spdk_bdev_module *module));
+DEFINE_STUB(spdk_bdev_io_type_supported, bool, (struct spdk_bdev *bdev,
+		enum spdk_bdev_io_type io_type), true);
+DEFINE_STUB(spdk_bdev_get_md_size, uint32_t, (const struct spdk_bdev *bdev), 0);
+
+/* I/O submitted by the exporter to its bdev, completed by ut_complete_base_ios() */
+struct ut_base_io {
+	enum spdk_bdev_io_type		type;
+	void				*buf;
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+	TAILQ_ENTRY(ut_base_io)		link;
+};
+
+static TAILQ_HEAD(, ut_base_io) g_base_ios = TAILQ_HEAD_INITIALIZER(g_base_ios);
+static uint32_t g_num_base_ios;
+static int g_base_io_rc;
+static struct spdk_bdev_io_wait_entry *g_io_wait_entry;
+static struct spdk_bdev g_base_bdev;
+static bool g_base_bdev_present;
+static bool g_base_bdev_open;
+static uint8_t g_base_data[BLOCK_CNT * BLOCK_SIZE];
+/* Backs the memzone of the export */
+static uint8_t g_region_buf[128 * 1024] __attribute__((aligned(BDEV_SHM_BUF_ALIGN)));
+static uint8_t g_io_buf[IO_SIZE];
+static struct spdk_bdev *g_registered_bdev;
+static struct spdk_io_channel *g_ch;
+
+int
+spdk_bdev_open_ext(const char *bdev_name, bool write, spdk_bdev_event_cb_t event_cb,
+		   void *event_ctx, struct spdk_bdev_desc **desc)
+{
+	if (!g_base_bdev_present || strcmp(bdev_name, g_base_bdev.name) != 0) {
+		return -ENODEV;
+	}
+
+	CU_ASSERT(!g_base_bdev_open);
+	g_base_bdev_open = true;
+	*desc = (struct spdk_bdev_desc *)&g_base_bdev;
+	return 0;
+}
+
+void
+spdk_bdev_close(struct spdk_bdev_desc *desc)
+{
+	CU_ASSERT(g_base_bdev_open);
+	g_base_bdev_open = false;
+}
+
+struct spdk_bdev *
+spdk_bdev_desc_get_bdev(struct spdk_bdev_desc *desc)
+{
+	return (struct spdk_bdev *)desc;
+}
+
+const char *
+spdk_bdev_get_name(const struct spdk_bdev *bdev)
+{
+	return bdev->name;
+}
+
+uint32_t
+spdk_bdev_get_block_size(const struct spdk_bdev *bdev)
+{
+	return bdev->blocklen;
+}
+
+uint64_t
+spdk_bdev_get_num_blocks(const struct spdk_bdev *bdev)
+{
+	return bdev->blockcnt;
+}
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	return spdk_get_io_channel(&g_base_bdev);
+}
+
+int
+spdk_bdev_queue_io_wait(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+			struct spdk_bdev_io_wait_entry *entry)
+{
+	CU_ASSERT(bdev == &g_base_bdev);
+	CU_ASSERT(g_io_wait_entry == NULL);
+	g_io_wait_entry = entry;
+
+	return 0;
+}
+
+int
+spdk_bdev_register(struct spdk_bdev *bdev)
+{
+	CU_ASSERT(g_registered_bdev == NULL);
+	g_registered_bdev = bdev;
+
+	return 0;
+}
+
+void
+spdk_bdev_unregister(struct spdk_bdev *bdev, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(bdev == g_registered_bdev);
+	g_registered_bdev = NULL;
+
+	bdev->fn_table->destruct(bdev->ctxt);
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+}
+
+int
+spdk_bdev_unregister_by_name(const char *bdev_name, struct spdk_bdev_module *module,
+			     spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(module == &shm_if);
+
+	if (g_registered_bdev == NULL || strcmp(g_registered_bdev->name, bdev_name) != 0) {
+		return -ENODEV;
+	}
+
+	spdk_bdev_unregister(g_registered_bdev, cb_fn, cb_arg);
+	return 0;
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(bdev_io);
+}
+
+void
+spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
+{
+	bdev_io->internal.status = status;
+}
+
+void
+spdk_bdev_io_get_buf(struct spdk_bdev_io *bdev_io, spdk_bdev_io_get_buf_cb cb, uint64_t len)
+{
+	CU_ASSERT(len <= sizeof(g_io_buf));
+	bdev_io->u.bdev.iovs[0].iov_base = g_io_buf;
+	bdev_io->u.bdev.iovs[0].iov_len = len;
+	cb(g_ch, bdev_io, true);
+}
+
+void
+spdk_bdev_io_set_buf(struct spdk_bdev_io *bdev_io, void *buf, size_t len)
+{
+	bdev_io->u.bdev.iovs[0].iov_base = buf;
+	bdev_io->u.bdev.iovs[0].iov_len = len;
+}
+
+static int
+ut_queue_base_io(enum spdk_bdev_io_type type, void *buf, uint64_t offset_blocks,
+		 uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct ut_base_io *io;
+
+	if (g_base_io_rc != 0) {
+		return g_base_io_rc;
+	}
+
+	CU_ASSERT(offset_blocks + num_blocks <= BLOCK_CNT);
+
+	io = calloc(1, sizeof(*io));
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	io->type = type;
+	io->buf = buf;
+	io->offset_blocks = offset_blocks;
+	io->num_blocks = num_blocks;
+	io->cb = cb;
+	io->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&g_base_ios, io, link);
+	g_num_base_ios++;
+
+	return 0;
+}
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		      uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		      void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_READ, buf, offset_blocks, num_blocks, cb,
+				cb_arg);
+}
+
+int
+spdk_bdev_write_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		       uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		       void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_WRITE, buf, offset_blocks, num_blocks, cb,
+				cb_arg);
+}
+
+int
+spdk_bdev_write_zeroes_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			      uint64_t offset_blocks, uint64_t num_blocks,
+			      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_WRITE_ZEROES, NULL, offset_blocks, num_blocks,
+				cb, cb_arg);
+}
+
+int
+spdk_bdev_unmap_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_UNMAP, NULL, offset_blocks, num_blocks, cb,
+				cb_arg);
+}
+
+int
+spdk_bdev_flush_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_FLUSH, NULL, offset_blocks, num_blocks, cb,
+				cb_arg);
+}
+
+/* Complete the I/O submitted to the exported bdev so far, moving the data to and from
+ * g_base_data, then let both sides of the queue pairs run */
+static void
+ut_complete_base_ios(bool success)
+{
+	TAILQ_HEAD(, ut_base_io) ios = TAILQ_HEAD_INITIALIZER(ios);
+	struct spdk_bdev_io *bdev_io;
+	struct ut_base_io *io;
+	uint8_t *data;
+	size_t len;
+
+	TAILQ_SWAP(&ios, &g_base_ios, ut_base_io, link);
+	while ((io = TAILQ_FIRST(&ios)) != NULL) {
+		TAILQ_REMOVE(&ios, io, link);
+
+		data = &g_base_data[io->offset_blocks * BLOCK_SIZE];
+		len = io->num_blocks * BLOCK_SIZE;
+		if (success && io->type == SPDK_BDEV_IO_TYPE_READ) {
+			memcpy(io->buf, data, len);
+		} else if (success && io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+			memcpy(data, io->buf, len);
+		} else if (success && io->type == SPDK_BDEV_IO_TYPE_WRITE_ZEROES) {
+			memset(data, 0, len);
+		}
+
+		bdev_io = calloc(1, sizeof(*bdev_io));
+		SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+		io->cb(bdev_io, success, io->cb_arg);
+		free(io);
+	}
+
+	poll_threads();
+}
+
+static struct spdk_bdev_io *
+ut_alloc_io(enum spdk_bdev_io_type type, uint64_t offset_blocks, uint64_t num_blocks,
+	    void *buf)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	bdev_io = calloc(1, sizeof(*bdev_io) + sizeof(struct shm_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = g_registered_bdev;
+	bdev_io->type = type;
+	bdev_io->u.bdev.offset_blocks = offset_blocks;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+	bdev_io->iov.iov_base = buf;
+	bdev_io->iov.iov_len = num_blocks * BLOCK_SIZE;
+	bdev_io->u.bdev.iovs = &bdev_io->iov;
+	bdev_io->u.bdev.iovcnt = 1;
+	bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
+
+	return bdev_io;
+}
+
+static void
+ut_resubmit_io(struct spdk_bdev_io *bdev_io)
+{
+	bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
+	bdev_shm_submit_request(g_ch, bdev_io);
+	poll_threads();
+}
+
+static struct spdk_bdev_io *
+ut_submit_io(enum spdk_bdev_io_type type, uint64_t offset_blocks, uint64_t num_blocks,
+	     void *buf)
+{
+	struct spdk_bdev_io *bdev_io = ut_alloc_io(type, offset_blocks, num_blocks, buf);
+
+	ut_resubmit_io(bdev_io);
+
+	return bdev_io;
+}
+
+static struct shm_io_channel *
+ut_get_ch(void)
+{
+	return spdk_io_channel_get_ctx(g_ch);
+}
+
+static int
+ut_base_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_base_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static int
+test_setup(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < sizeof(g_base_data); i++) {
+		g_base_data[i] = i / BLOCK_SIZE + i;
+	}
+
+	g_base_bdev.name = "base";
+	g_base_bdev.blocklen = BLOCK_SIZE;
+	g_base_bdev.blockcnt = BLOCK_CNT;
+	g_base_bdev_present = true;
+	spdk_io_device_register(&g_base_bdev, ut_base_ch_create_cb, ut_base_ch_destroy_cb, 0,
+				"base");
+
+	MOCK_SET(spdk_memzone_reserve_aligned, g_region_buf);
+
+	return 0;
+}
+
+static int
+test_cleanup(void)
+{
+	MOCK_CLEAR(spdk_memzone_reserve_aligned);
+	MOCK_CLEAR(spdk_memzone_lookup);
+
+	spdk_io_device_unregister(&g_base_bdev, NULL);
+	poll_threads();
+
+	return 0;
+}
+
+static struct bdev_shm_region *
+ut_region(void)
+{
+	return (struct bdev_shm_region *)g_region_buf;
+}
+
+static int
+ut_export(uint32_t num_queues)
+{
+	struct bdev_shm_export_opts opts = {
+		.name = "exp0",
+		.bdev_name = "base",
+		.num_queues = num_queues,
+		.queue_depth = QUEUE_DEPTH,
+		.io_size = IO_SIZE,
+	};
+	int rc;
+
+	rc = bdev_shm_export(&opts);
+	if (rc == 0 && TAILQ_FIRST(&g_shm_exports)->region != NULL) {
+		CU_ASSERT(ut_region()->size <= sizeof(g_region_buf));
+		/* The consumer finds the export in the memzone */
+		MOCK_SET(spdk_memzone_lookup, g_region_buf);
+	}
+
+	return rc;
+}
+
+static void
+ut_unexport(void)
+{
+	CU_ASSERT(bdev_shm_unexport("exp0") == 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_shm_exports));
+	CU_ASSERT(!g_base_bdev_open);
+	MOCK_SET(spdk_memzone_lookup, NULL);
+}
+
+static void
+ut_delete_cb(void *cb_arg, int bdeverrno)
+{
+	*(int *)cb_arg = bdeverrno;
+}
+
+/* Export the base bdev, then import it and get a channel to the imported bdev */
+static void
+ut_shm_create(void)
+{
+	struct spdk_bdev *bdev = NULL;
+	int rc;
+
+	rc = ut_export(NUM_QUEUES);
+	CU_ASSERT(rc == 0);
+
+	rc = bdev_shm_create("shm0", "exp0", &bdev);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(bdev != NULL);
+	CU_ASSERT(bdev == g_registered_bdev);
+
+	g_ch = spdk_get_io_channel(bdev->ctxt);
+	SPDK_CU_ASSERT_FATAL(g_ch != NULL);
+	g_num_base_ios = 0;
+}
+
+static void
+ut_shm_delete(void)
+{
+	int rc = -1;
+
+	spdk_put_io_channel(g_ch);
+	g_ch = NULL;
+	poll_threads();
+
+	bdev_shm_delete("shm0", ut_delete_cb, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_shm_bdevs));
+	CU_ASSERT(TAILQ_EMPTY(&g_base_ios));
+
+	ut_unexport();
+}
+
+static void
+test_export_create_delete(void)
+{
+	struct bdev_shm_export_opts opts = {};
+	struct bdev_shm_region *region = ut_region();
+	struct spdk_bdev *bdev = NULL;
+	struct spdk_io_channel *ch;
+	int rc;
+
+	/* Invalid options */
+	opts.bdev_name = "base";
+	rc = bdev_shm_export(&opts);
+	CU_ASSERT(rc == -EINVAL);
+	opts.name = "";
+	rc = bdev_shm_export(&opts);
+	CU_ASSERT(rc == -EINVAL);
+	opts.name = "exp0";
+	opts.queue_depth = 3;
+	rc = bdev_shm_export(&opts);
+	CU_ASSERT(rc == -EINVAL);
+	opts.queue_depth = 0;
+	opts.io_size = 1000;
+	rc = bdev_shm_export(&opts);
+	CU_ASSERT(rc == -EINVAL);
+	opts.io_size = 0;
+	opts.num_queues = BDEV_SHM_MAX_NUM_QUEUES + 1;
+	rc = bdev_shm_export(&opts);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(TAILQ_EMPTY(&g_shm_exports));
+
+	/* Bdevs with metadata can't be exported */
+	MOCK_SET(spdk_bdev_get_md_size, 8);
+	rc = ut_export(NUM_QUEUES);
+	CU_ASSERT(rc == -ENOTSUP);
+	CU_ASSERT(TAILQ_EMPTY(&g_shm_exports));
+	CU_ASSERT(!g_base_bdev_open);
+	MOCK_SET(spdk_bdev_get_md_size, 0);
+
+	/* Importing an export that doesn't exist fails */
+	rc = bdev_shm_create("shm0", "exp0", &bdev);
+	CU_ASSERT(rc == -ENODEV);
+	CU_ASSERT(g_registered_bdev == NULL);
+
+	/* Only the I/O types supported by the exported bdev are supported by the import */
+	MOCK_SET(spdk_bdev_io_type_supported, false);
+	rc = ut_export(NUM_QUEUES);
+	CU_ASSERT(rc == 0);
+	MOCK_SET(spdk_bdev_io_type_supported, true);
+	CU_ASSERT(g_base_bdev_open);
+	CU_ASSERT(region->magic == BDEV_SHM_MAGIC);
+	CU_ASSERT(region->state == BDEV_SHM_STATE_READY);
+	CU_ASSERT(region->num_blocks == BLOCK_CNT);
+	CU_ASSERT(region->block_size == BLOCK_SIZE);
+	CU_ASSERT(region->num_queues == NUM_QUEUES);
+	CU_ASSERT(region->queue_depth == QUEUE_DEPTH);
+	CU_ASSERT(region->io_size == IO_SIZE);
+
+	rc = ut_export(NUM_QUEUES);
+	CU_ASSERT(rc == -EEXIST);
+
+	rc = bdev_shm_create("shm0", "exp0", &bdev);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(bdev != NULL);
+	CU_ASSERT(bdev->blocklen == BLOCK_SIZE);
+	CU_ASSERT(bdev->blockcnt == BLOCK_CNT);
+	CU_ASSERT(bdev->optimal_io_boundary == IO_BLOCKS);
+	CU_ASSERT(bdev->split_on_optimal_io_boundary);
+	CU_ASSERT(bdev_shm_io_type_supported(bdev->ctxt, SPDK_BDEV_IO_TYPE_READ));
+	CU_ASSERT(bdev_shm_io_type_supported(bdev->ctxt, SPDK_BDEV_IO_TYPE_ZCOPY));
+	CU_ASSERT(!bdev_shm_io_type_supported(bdev->ctxt, SPDK_BDEV_IO_TYPE_UNMAP));
+	CU_ASSERT(!bdev_shm_io_type_supported(bdev->ctxt, SPDK_BDEV_IO_TYPE_FLUSH));
+	CU_ASSERT(!bdev_shm_io_type_supported(bdev->ctxt, SPDK_BDEV_IO_TYPE_WRITE_ZEROES));
+
+	/* The export can't go away while a channel of the import holds one of its queues */
+	ch = spdk_get_io_channel(bdev->ctxt);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	CU_ASSERT(region->queues[0].claimed == 1);
+	rc = bdev_shm_unexport("exp0");
+	CU_ASSERT(rc == -EBUSY);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+	CU_ASSERT(region->queues[0].claimed == 0);
+
+	rc = -1;
+	bdev_shm_delete("shm0", ut_delete_cb, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_registered_bdev == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&g_shm_bdevs));
+
+	rc = 0;
+	bdev_shm_delete("shm0", ut_delete_cb, &rc);
+	CU_ASSERT(rc == -ENODEV);
+
+	ut_unexport();
+	rc = bdev_shm_unexport("exp0");
+	CU_ASSERT(rc == -ENOENT);
+
+	/* A bdev that doesn't exist yet is exported once it's examined */
+	g_base_bdev_present = false;
+	rc = ut_export(NUM_QUEUES);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&g_shm_exports));
+	CU_ASSERT(TAILQ_FIRST(&g_shm_exports)->region == NULL);
+
+	g_base_bdev_present = true;
+	bdev_shm_examine(&g_base_bdev);
+	CU_ASSERT(TAILQ_FIRST(&g_shm_exports)->region == region);
+	CU_ASSERT(region->state == BDEV_SHM_STATE_READY);
+	CU_ASSERT(g_base_bdev_open);
+
+	ut_unexport();
+}
+
+static void
+test_read_write(void)
+{
+	struct spdk_bdev_io *bdev_io;
+	struct ut_base_io *io;
+	uint8_t buf[IO_SIZE];
+
+	ut_shm_create();
+
+	/* Writes are copied into the slot buffer and written by the exporter */
+	memset(buf, 0xa5, sizeof(buf));
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_WRITE, 32, IO_BLOCKS, buf);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(g_num_base_ios == 1);
+	io = TAILQ_FIRST(&g_base_ios);
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	CU_ASSERT(io->type == SPDK_BDEV_IO_TYPE_WRITE);
+	CU_ASSERT(io->offset_blocks == 32);
+	CU_ASSERT(io->num_blocks == IO_BLOCKS);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(&g_base_data[32 * BLOCK_SIZE], buf, sizeof(buf)) == 0);
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH);
+	free(bdev_io);
+
+	/* Reads are copied out of the slot buffer */
+	memset(buf, 0, sizeof(buf));
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 100, 8, buf);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, &g_base_data[100 * BLOCK_SIZE], 8 * BLOCK_SIZE) == 0);
+	free(bdev_io);
+
+	/* Reads without a buffer get one first */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 200, IO_BLOCKS, NULL);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bdev_io->u.bdev.iovs[0].iov_base == g_io_buf);
+	CU_ASSERT(memcmp(g_io_buf, &g_base_data[200 * BLOCK_SIZE], IO_SIZE) == 0);
+	free(bdev_io);
+
+	/* I/Os larger than a slot buffer fail without reaching the exporter */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 0, IO_BLOCKS + 1, buf);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(g_num_base_ios == 3);
+	free(bdev_io);
+
+	/* Resets complete right away */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_RESET, 0, 0, NULL);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_num_base_ios == 3);
+	free(bdev_io);
+
+	/* Commands without data */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_FLUSH, 0, BLOCK_CNT, NULL);
+	io = TAILQ_FIRST(&g_base_ios);
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	CU_ASSERT(io->type == SPDK_BDEV_IO_TYPE_FLUSH);
+	CU_ASSERT(io->num_blocks == BLOCK_CNT);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	free(bdev_io);
+
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_UNMAP, 64, 128, NULL);
+	io = TAILQ_FIRST(&g_base_ios);
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	CU_ASSERT(io->type == SPDK_BDEV_IO_TYPE_UNMAP);
+	CU_ASSERT(io->offset_blocks == 64);
+	CU_ASSERT(io->num_blocks == 128);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	free(bdev_io);
+
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_WRITE_ZEROES, 32, 4, NULL);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(spdk_mem_all_zero(&g_base_data[32 * BLOCK_SIZE], 4 * BLOCK_SIZE));
+	free(bdev_io);
+
+	/* Failures of the exported bdev are reported to the consumer */
+	memset(buf, 0, sizeof(buf));
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 0, 8, buf);
+	ut_complete_base_ios(false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(spdk_mem_all_zero(buf, 8 * BLOCK_SIZE));
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH);
+	free(bdev_io);
+
+	ut_shm_delete();
+}
+
+static void
+test_queue_full(void)
+{
+	struct spdk_bdev_io *bdev_io[QUEUE_DEPTH + 2];
+	uint8_t buf[QUEUE_DEPTH + 2][BLOCK_SIZE];
+	struct ut_base_io *io;
+	uint32_t i;
+
+	ut_shm_create();
+
+	/* The I/Os beyond the depth of the queue wait for a slot, in order */
+	for (i = 0; i < QUEUE_DEPTH + 2; i++) {
+		bdev_io[i] = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, i, 1, buf[i]);
+	}
+	CU_ASSERT(g_num_base_ios == QUEUE_DEPTH);
+	CU_ASSERT(ut_get_ch()->num_free == 0);
+	CU_ASSERT(TAILQ_FIRST(&ut_get_ch()->pending) == bdev_io[QUEUE_DEPTH]);
+
+	ut_complete_base_ios(true);
+	for (i = 0; i < QUEUE_DEPTH; i++) {
+		CU_ASSERT(bdev_io[i]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+	CU_ASSERT(TAILQ_EMPTY(&ut_get_ch()->pending));
+	CU_ASSERT(g_num_base_ios == QUEUE_DEPTH + 2);
+	i = QUEUE_DEPTH;
+	TAILQ_FOREACH(io, &g_base_ios, link) {
+		CU_ASSERT(io->offset_blocks == i++);
+	}
+
+	ut_complete_base_ios(true);
+	for (i = 0; i < QUEUE_DEPTH + 2; i++) {
+		CU_ASSERT(bdev_io[i]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+		CU_ASSERT(memcmp(buf[i], &g_base_data[i * BLOCK_SIZE], BLOCK_SIZE) == 0);
+		free(bdev_io[i]);
+	}
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH);
+
+	/* The exporter retries the commands its bdev is out of resources for */
+	g_base_io_rc = -ENOMEM;
+	bdev_io[0] = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 8, 1, buf[0]);
+	CU_ASSERT(g_num_base_ios == QUEUE_DEPTH + 2);
+	SPDK_CU_ASSERT_FATAL(g_io_wait_entry != NULL);
+	CU_ASSERT(TAILQ_FIRST(&g_shm_exports)->outstanding == 1);
+
+	g_base_io_rc = 0;
+	g_io_wait_entry->cb_fn(g_io_wait_entry->cb_arg);
+	g_io_wait_entry = NULL;
+	CU_ASSERT(g_num_base_ios == QUEUE_DEPTH + 3);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io[0]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf[0], &g_base_data[8 * BLOCK_SIZE], BLOCK_SIZE) == 0);
+	CU_ASSERT(TAILQ_FIRST(&g_shm_exports)->outstanding == 0);
+	free(bdev_io[0]);
+
+	/* Other errors fail the command */
+	g_base_io_rc = -EINVAL;
+	bdev_io[0] = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 8, 1, buf[0]);
+	CU_ASSERT(bdev_io[0]->internal.status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(TAILQ_FIRST(&g_shm_exports)->outstanding == 0);
+	g_base_io_rc = 0;
+	free(bdev_io[0]);
+
+	ut_shm_delete();
+}
+
+static void
+test_zcopy(void)
+{
+	struct spdk_bdev_io *bdev_io;
+	void *slot_buf;
+
+	ut_shm_create();
+
+	/* Zero copy writes hand out a slot buffer, then write it on commit */
+	bdev_io = ut_alloc_io(SPDK_BDEV_IO_TYPE_ZCOPY, 16, IO_BLOCKS, NULL);
+	bdev_io->u.bdev.zcopy.start = 1;
+	bdev_io->u.bdev.zcopy.populate = 0;
+	ut_resubmit_io(bdev_io);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_num_base_ios == 0);
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH - 1);
+	slot_buf = bdev_io->u.bdev.iovs[0].iov_base;
+	SPDK_CU_ASSERT_FATAL(slot_buf != NULL);
+	CU_ASSERT((uint8_t *)slot_buf >= g_region_buf &&
+		  (uint8_t *)slot_buf + IO_SIZE <= g_region_buf + ut_region()->size);
+	memset(slot_buf, 0x5a, IO_SIZE);
+
+	bdev_io->u.bdev.zcopy.start = 0;
+	bdev_io->u.bdev.zcopy.commit = 1;
+	ut_resubmit_io(bdev_io);
+	CU_ASSERT(g_num_base_ios == 1);
+	CU_ASSERT(TAILQ_FIRST(&g_base_ios)->buf == slot_buf);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(&g_base_data[16 * BLOCK_SIZE], slot_buf, IO_SIZE) == 0);
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH);
+	free(bdev_io);
+
+	/* Zero copy reads populate the slot buffer, which is released at the end */
+	bdev_io = ut_alloc_io(SPDK_BDEV_IO_TYPE_ZCOPY, 64, IO_BLOCKS, NULL);
+	bdev_io->u.bdev.zcopy.start = 1;
+	bdev_io->u.bdev.zcopy.populate = 1;
+	ut_resubmit_io(bdev_io);
+	CU_ASSERT(g_num_base_ios == 2);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	slot_buf = bdev_io->u.bdev.iovs[0].iov_base;
+	SPDK_CU_ASSERT_FATAL(slot_buf != NULL);
+	CU_ASSERT(memcmp(slot_buf, &g_base_data[64 * BLOCK_SIZE], IO_SIZE) == 0);
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH - 1);
+
+	bdev_io->u.bdev.zcopy.start = 0;
+	bdev_io->u.bdev.zcopy.commit = 0;
+	ut_resubmit_io(bdev_io);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_num_base_ios == 2);
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH);
+	free(bdev_io);
+
+	ut_shm_delete();
+}
+
+static void
+test_exported_bdev_hotremove(void)
+{
+	struct spdk_bdev_io *outstanding, *raced, *bdev_io;
+	struct spdk_bdev *bdev = NULL;
+	struct shm_export *exp;
+	uint8_t buf[2][BLOCK_SIZE];
+	uint32_t slot;
+	int rc;
+
+	ut_shm_create();
+	exp = TAILQ_FIRST(&g_shm_exports);
+
+	outstanding = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 0, 1, buf[0]);
+	CU_ASSERT(g_num_base_ios == 1);
+
+	/* A command submitted before the consumer sees the removal fails with -ENODEV */
+	raced = ut_alloc_io(SPDK_BDEV_IO_TYPE_READ, 1, 1, buf[1]);
+	bdev_shm_submit_request(g_ch, raced);
+	slot = ((struct shm_bdev_io *)raced->driver_ctx)->slot;
+	shm_export_event_cb(SPDK_BDEV_EVENT_REMOVE, &g_base_bdev, exp);
+	CU_ASSERT(ut_region()->state == BDEV_SHM_STATE_REMOVED);
+	poll_threads();
+	CU_ASSERT(raced->internal.status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(bdev_shm_get_cmd(ut_region(), ut_get_ch()->queue, slot)->status == -ENODEV);
+	CU_ASSERT(g_num_base_ios == 1);
+	free(raced);
+
+	/* Later I/Os fail without reaching the exporter */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 1, 1, buf[1]);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_FAILED);
+	CU_ASSERT(g_num_base_ios == 1);
+	free(bdev_io);
+
+	/* The exporter closes the bdev once the outstanding I/O is done */
+	CU_ASSERT(g_base_bdev_open);
+	CU_ASSERT(exp->outstanding == 1);
+	ut_complete_base_ios(true);
+	CU_ASSERT(outstanding->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(exp->outstanding == 0);
+	CU_ASSERT(!g_base_bdev_open);
+	CU_ASSERT(exp->desc == NULL);
+	CU_ASSERT(ut_get_ch()->num_free == QUEUE_DEPTH);
+	free(outstanding);
+
+	/* The removed export can't be imported anymore, nor get new channels */
+	spdk_put_io_channel(g_ch);
+	g_ch = NULL;
+	poll_threads();
+	CU_ASSERT(bdev_shm_create("shm1", "exp0", &bdev) == -ENODEV);
+	CU_ASSERT(spdk_get_io_channel(g_registered_bdev->ctxt) == NULL);
+
+	rc = -1;
+	bdev_shm_delete("shm0", ut_delete_cb, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	ut_unexport();
+}
+
+static void
+test_queues_claimed(void)
+{
+	struct spdk_io_channel *ch;
+	int rc;
+
+	/* A single queue pair, only one channel can use it at a time */
+	rc = ut_export(1);
+	CU_ASSERT(rc == 0);
+	rc = bdev_shm_create("shm0", "exp0", &g_registered_bdev);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_registered_bdev != NULL);
+
+	g_ch = spdk_get_io_channel(g_registered_bdev->ctxt);
+	SPDK_CU_ASSERT_FATAL(g_ch != NULL);
+
+	set_thread(1);
+	ch = spdk_get_io_channel(g_registered_bdev->ctxt);
+	CU_ASSERT(ch == NULL);
+
+	set_thread(0);
+	spdk_put_io_channel(g_ch);
+	poll_threads();
+	CU_ASSERT(ut_region()->queues[0].claimed == 0);
+
+	/* The queue pair is free again */
+	set_thread(1);
+	g_ch = spdk_get_io_channel(g_registered_bdev->ctxt);
+	SPDK_CU_ASSERT_FATAL(g_ch != NULL);
+	CU_ASSERT(ut_region()->queues[0].claimed == 1);
+	spdk_put_io_channel(g_ch);
+	g_ch = NULL;
+	poll_threads();
+	set_thread(0);
+
+	rc = -1;
+	bdev_shm_delete("shm0", ut_delete_cb, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	ut_unexport();
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("bdev_shm", test_setup, test_cleanup);
+	CU_ADD_TEST(suite, test_export_create_delete);
+	CU_ADD_TEST(suite, test_read_write);
+	CU_ADD_TEST(suite, test_queue_full);
+	CU_ADD_TEST(suite, test_zcopy);
+	CU_ADD_TEST(suite, test_exported_bdev_hotremove);
+	CU_ADD_TEST(suite, test_queues_claimed);
+
+	allocate_threads(2);
+	set_thread(0);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	free_threads();
+
+	CU_cleanup_registry();
+	return num_failures;
+}
@@ -55,6 +55,7 @@ DEFINE_STUB(spdk_bdev_register, int, (struct spdk_bdev *vbdev), 0);
 DEFINE_STUB_V(spdk_bdev_destruct_done, (struct spdk_bdev *bdev, int bdeverrno));
 
 DEFINE_STUB(spdk_accel_crypto_key_destroy, int, (struct spdk_accel_crypto_key *key), 0);
+DEFINE_STUB(spdk_accel_crypto_key_prefetch, int, (struct spdk_accel_crypto_key *key), 0);
 DEFINE_STUB(spdk_accel_append_decrypt, int,
 	    (struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
 	     struct spdk_accel_crypto_key *key, struct iovec *dst_iovs,
@@ -1234,6 +1234,81 @@ io_during_qos_queue(void)
 	teardown_test();
 }
 
+static void
+io_during_qos_distributed(void)
+{
+	struct spdk_io_channel *io_ch[2];
+	struct spdk_bdev_channel *bdev_ch[2];
+	struct spdk_bdev *bdev;
+	enum spdk_bdev_io_status status[3];
+	int rc, i;
+
+	setup_test();
+	MOCK_SET(spdk_get_ticks, 0);
+	g_bdev_opts.qos_distributed = true;
+
+	/* Enable QoS */
+	bdev = &g_bdev.bdev;
+	bdev->internal.qos = calloc(1, sizeof(*bdev->internal.qos));
+	SPDK_CU_ASSERT_FATAL(bdev->internal.qos != NULL);
+	TAILQ_INIT(&bdev->internal.qos->queued);
+	/* 2000 read/write I/O per second, or 2 per millisecond */
+	bdev->internal.qos->rate_limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT].limit = 2000;
+
+	g_get_io_channel = true;
+
+	/* Thread 0 becomes the QoS thread */
+	set_thread(0);
+	io_ch[0] = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch[0] = spdk_io_channel_get_ctx(io_ch[0]);
+	CU_ASSERT(bdev_ch[0]->flags == BDEV_CH_QOS_ENABLED);
+	CU_ASSERT(bdev->internal.qos->distributed == true);
+
+	set_thread(1);
+	io_ch[1] = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch[1] = spdk_io_channel_get_ctx(io_ch[1]);
+	CU_ASSERT(bdev_ch[1]->flags == BDEV_CH_QOS_ENABLED);
+
+	/* Send three I/Os on thread 1. Only two fit into the quota of the timeslice. */
+	for (i = 0; i < 3; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(g_desc, io_ch[1], NULL, 0, 1, io_during_io_done, &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+
+	/* The first two were submitted on thread 1 without going through the QoS thread */
+	CU_ASSERT(bdev_ch[1]->io_outstanding == 2);
+	stub_complete_io(g_bdev.io_target, 0);
+	poll_thread(1);
+	CU_ASSERT(status[0] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[1] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[2] == SPDK_BDEV_IO_STATUS_PENDING);
+
+	/* The third one was sent to the QoS thread, where it waits for the next timeslice */
+	poll_threads();
+	CU_ASSERT(bdev->internal.qos->ch == bdev_ch[0]);
+	CU_ASSERT(!TAILQ_EMPTY(&bdev->internal.qos->queued));
+
+	spdk_delay_us(1000);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.qos->queued));
+	/* Like in the non-distributed mode, it is sent back to thread 1 for submission */
+	CU_ASSERT(bdev_ch[1]->io_outstanding == 1);
+	set_thread(1);
+	stub_complete_io(g_bdev.io_target, 0);
+	poll_threads();
+	CU_ASSERT(status[2] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* Tear down the channels */
+	spdk_put_io_channel(io_ch[1]);
+	set_thread(0);
+	spdk_put_io_channel(io_ch[0]);
+	poll_threads();
+
+	g_bdev_opts.qos_distributed = false;
+	teardown_test();
+}
+
 static void
 io_during_qos_reset(void)
 {
@@ -1355,7 +1430,7 @@ enomem(void)
 		rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[i]);
 		CU_ASSERT(rc == 0);
 	}
-	CU_ASSERT(TAILQ_EMPTY(&shared_resource->nomem_io));
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->nomem_io));
 
 	/*
 	 * Next, submit one additional I/O.  This one should fail with ENOMEM and then go onto
@@ -1364,8 +1439,8 @@ enomem(void)
 	status[AVAIL] = SPDK_BDEV_IO_STATUS_PENDING;
 	rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[AVAIL]);
 	CU_ASSERT(rc == 0);
-	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&shared_resource->nomem_io));
-	first_io = TAILQ_FIRST(&shared_resource->nomem_io);
+	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&bdev_ch->nomem_io));
+	first_io = TAILQ_FIRST(&bdev_ch->nomem_io);
 
 	/*
 	 * Now submit a bunch more I/O.  These should all fail with ENOMEM and get queued behind
@@ -1378,9 +1453,9 @@ enomem(void)
 	}
 
 	/* Assert that first_io is still at the head of the list. */
-	CU_ASSERT(TAILQ_FIRST(&shared_resource->nomem_io) == first_io);
-	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) == (IO_ARRAY_SIZE - AVAIL));
-	nomem_cnt = bdev_io_tailq_cnt(&shared_resource->nomem_io);
+	CU_ASSERT(TAILQ_FIRST(&bdev_ch->nomem_io) == first_io);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) == (IO_ARRAY_SIZE - AVAIL));
+	nomem_cnt = bdev_io_tailq_cnt(&bdev_ch->nomem_io);
 	CU_ASSERT(shared_resource->nomem_threshold == (AVAIL - NOMEM_THRESHOLD_COUNT));
 
 	/*
@@ -1389,19 +1464,19 @@ enomem(void)
 	 *  list.
 	 */
 	stub_complete_io(g_bdev.io_target, 1);
-	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) == nomem_cnt);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) == nomem_cnt);
 
 	/*
 	 * Complete enough I/O to hit the nomem_threshold.  This should trigger retrying nomem_io,
 	 *  and we should see I/O get resubmitted to the test bdev module.
 	 */
 	stub_complete_io(g_bdev.io_target, NOMEM_THRESHOLD_COUNT - 1);
-	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) < nomem_cnt);
-	nomem_cnt = bdev_io_tailq_cnt(&shared_resource->nomem_io);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) < nomem_cnt);
+	nomem_cnt = bdev_io_tailq_cnt(&bdev_ch->nomem_io);
 
 	/* Complete 1 I/O only.  This should not trigger retrying the queued nomem_io. */
 	stub_complete_io(g_bdev.io_target, 1);
-	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) == nomem_cnt);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) == nomem_cnt);
 
 	/*
 	 * Send a reset and confirm that all I/O are completed, including the ones that
@@ -1414,7 +1489,7 @@ enomem(void)
 	/* This will complete the reset. */
 	stub_complete_io(g_bdev.io_target, 0);
 
-	CU_ASSERT(bdev_io_tailq_cnt(&shared_resource->nomem_io) == 0);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) == 0);
 	CU_ASSERT(shared_resource->io_outstanding == 0);
 
 	spdk_put_io_channel(io_ch);
@@ -1465,7 +1540,7 @@ enomem_multi_bdev(void)
 		rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[i]);
 		CU_ASSERT(rc == 0);
 	}
-	CU_ASSERT(TAILQ_EMPTY(&shared_resource->nomem_io));
+	CU_ASSERT(TAILQ_EMPTY(&shared_resource->nomem_channels));
 
 	/*
 	 * Now submit I/O through the second bdev. This should fail with ENOMEM
@@ -1474,12 +1549,12 @@ enomem_multi_bdev(void)
 	status[AVAIL] = SPDK_BDEV_IO_STATUS_PENDING;
 	rc = spdk_bdev_read_blocks(second_desc, second_ch, NULL, 0, 1, enomem_done, &status[AVAIL]);
 	CU_ASSERT(rc == 0);
-	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&shared_resource->nomem_channels));
 
 	/* Complete first bdev's I/O. This should retry sending second bdev's nomem_io */
 	stub_complete_io(g_bdev.io_target, AVAIL);
 
-	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&shared_resource->nomem_channels));
 	CU_ASSERT(shared_resource->io_outstanding == 1);
 
 	/* Now complete our retried I/O  */
@@ -1523,7 +1598,7 @@ enomem_multi_bdev_unregister(void)
 		rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[i]);
 		CU_ASSERT(rc == 0);
 	}
-	CU_ASSERT(TAILQ_EMPTY(&shared_resource->nomem_io));
+	CU_ASSERT(TAILQ_EMPTY(&shared_resource->nomem_channels));
 
 	/*
 	 * Now submit I/O through the bdev. This should fail with ENOMEM
@@ -1532,12 +1607,12 @@ enomem_multi_bdev_unregister(void)
 	status[AVAIL] = SPDK_BDEV_IO_STATUS_PENDING;
 	rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[AVAIL]);
 	CU_ASSERT(rc == 0);
-	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&shared_resource->nomem_channels));
 
 	/* Unregister the bdev to abort the IOs from nomem_io queue. */
 	unregister_bdev(&g_bdev);
 	CU_ASSERT(status[AVAIL] == SPDK_BDEV_IO_STATUS_FAILED);
-	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&shared_resource->nomem_channels));
 	SPDK_CU_ASSERT_FATAL(shared_resource->io_outstanding == AVAIL);
 
 	/* Complete the bdev's I/O. */
@@ -1549,6 +1624,145 @@ enomem_multi_bdev_unregister(void)
 	teardown_test();
 }
 
+static void
+enomem_multi_bdev_fairness(void)
+{
+	struct spdk_io_channel *io_ch, *second_ch;
+	struct spdk_bdev_channel *bdev_ch, *second_bdev_ch;
+	struct spdk_bdev_shared_resource *shared_resource;
+	struct ut_bdev_channel *ut_ch;
+	const uint32_t IO_ARRAY_SIZE = 8;
+	const uint32_t AVAIL = 4;
+	enum spdk_bdev_io_status status[IO_ARRAY_SIZE];
+	struct spdk_bdev_desc *second_desc = NULL;
+	struct ut_bdev *second_bdev;
+	struct spdk_bdev_io *bdev_io;
+	uint32_t i;
+	int rc;
+
+	setup_test();
+
+	second_bdev = calloc(1, sizeof(*second_bdev));
+	SPDK_CU_ASSERT_FATAL(second_bdev != NULL);
+	register_bdev(second_bdev, "ut_bdev2", g_bdev.io_target);
+	spdk_bdev_open_ext("ut_bdev2", true, _bdev_event_cb, NULL, &second_desc);
+	SPDK_CU_ASSERT_FATAL(second_desc != NULL);
+
+	set_thread(0);
+	io_ch = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch = spdk_io_channel_get_ctx(io_ch);
+	shared_resource = bdev_ch->shared_resource;
+	ut_ch = spdk_io_channel_get_ctx(bdev_ch->channel);
+	ut_ch->avail_cnt = AVAIL;
+
+	second_ch = spdk_bdev_get_io_channel(second_desc);
+	second_bdev_ch = spdk_io_channel_get_ctx(second_ch);
+	SPDK_CU_ASSERT_FATAL(shared_resource == second_bdev_ch->shared_resource);
+
+	/* Saturate io_target through bdev A and queue two more I/O on it */
+	for (i = 0; i < AVAIL + 2; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) == 2);
+
+	/* I/O to bdev B isn't queued behind bdev A's, it hits NOMEM on its own */
+	for (i = AVAIL + 2; i < IO_ARRAY_SIZE; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(second_desc, second_ch, NULL, 0, 1, enomem_done,
+					   &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(bdev_io_tailq_cnt(&second_bdev_ch->nomem_io) == 2);
+	CU_ASSERT(TAILQ_FIRST(&shared_resource->nomem_channels) == bdev_ch);
+	CU_ASSERT(bdev_ch->stat->num_nomem_ios == 1);
+	CU_ASSERT(second_bdev_ch->stat->num_nomem_ios == 1);
+
+	/* The queued I/O are retried alternating between the bdevs */
+	for (i = 0; i < AVAIL; i++) {
+		stub_complete_io(g_bdev.io_target, 1);
+	}
+	bdev_io = TAILQ_FIRST(&ut_ch->outstanding_io);
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	CU_ASSERT(bdev_io->internal.ch == bdev_ch);
+	bdev_io = TAILQ_NEXT(bdev_io, module_link);
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	CU_ASSERT(bdev_io->internal.ch == second_bdev_ch);
+	bdev_io = TAILQ_NEXT(bdev_io, module_link);
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	CU_ASSERT(bdev_io->internal.ch == bdev_ch);
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->nomem_io));
+	CU_ASSERT(bdev_io_tailq_cnt(&second_bdev_ch->nomem_io) == 1);
+	CU_ASSERT(second_bdev_ch->stat->num_nomem_retries > 0);
+
+	/* Complete everything */
+	while (shared_resource->io_outstanding > 0) {
+		stub_complete_io(g_bdev.io_target, 1);
+	}
+	CU_ASSERT(TAILQ_EMPTY(&shared_resource->nomem_channels));
+	for (i = 0; i < IO_ARRAY_SIZE; i++) {
+		CU_ASSERT(status[i] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+
+	spdk_put_io_channel(io_ch);
+	spdk_put_io_channel(second_ch);
+	spdk_bdev_close(second_desc);
+	unregister_bdev(second_bdev);
+	poll_threads();
+	free(second_bdev);
+	teardown_test();
+}
+
+static void
+enomem_timed_retry(void)
+{
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *bdev_ch;
+	struct spdk_bdev_shared_resource *shared_resource;
+	struct ut_bdev_channel *ut_ch;
+	enum spdk_bdev_io_status status;
+	int rc;
+
+	setup_test();
+
+	set_thread(0);
+	io_ch = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch = spdk_io_channel_get_ctx(io_ch);
+	shared_resource = bdev_ch->shared_resource;
+	ut_ch = spdk_io_channel_get_ctx(bdev_ch->channel);
+	ut_ch->avail_cnt = 0;
+
+	/* Nothing is outstanding, so no completion is going to retry this I/O */
+	status = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) == 1);
+	CU_ASSERT(shared_resource->nomem_poller != NULL);
+
+	/* Still no resources when the poller retries */
+	spdk_delay_us(NOMEM_RETRY_PERIOD_US);
+	poll_threads();
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch->nomem_io) == 1);
+	CU_ASSERT(shared_resource->nomem_poller != NULL);
+	CU_ASSERT(bdev_ch->stat->num_nomem_ios == 2);
+	CU_ASSERT(bdev_ch->stat->num_nomem_retries == 1);
+
+	ut_ch->avail_cnt = 1;
+	spdk_delay_us(NOMEM_RETRY_PERIOD_US);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->nomem_io));
+	CU_ASSERT(shared_resource->nomem_poller == NULL);
+	CU_ASSERT(shared_resource->io_outstanding == 1);
+
+	stub_complete_io(g_bdev.io_target, 1);
+	CU_ASSERT(status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	spdk_put_io_channel(io_ch);
+	poll_threads();
+	teardown_test();
+}
+
 static void
 enomem_multi_io_target(void)
 {
@@ -1594,13 +1808,13 @@ enomem_multi_io_target(void)
 		rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[i]);
 		CU_ASSERT(rc == 0);
 	}
-	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->shared_resource->nomem_io));
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->nomem_io));
 
 	/* Issue one more I/O to fill ENOMEM list. */
 	status[AVAIL] = SPDK_BDEV_IO_STATUS_PENDING;
 	rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, enomem_done, &status[AVAIL]);
 	CU_ASSERT(rc == 0);
-	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&bdev_ch->shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(!TAILQ_EMPTY(&bdev_ch->nomem_io));
 
 	/*
 	 * Now submit I/O through the second bdev. This should go through and complete
@@ -1609,17 +1823,17 @@ enomem_multi_io_target(void)
 	status[AVAIL] = SPDK_BDEV_IO_STATUS_PENDING;
 	rc = spdk_bdev_read_blocks(second_desc, second_ch, NULL, 0, 1, enomem_done, &status[AVAIL]);
 	CU_ASSERT(rc == 0);
-	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&second_bdev_ch->shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&second_bdev_ch->nomem_io));
 	stub_complete_io(second_bdev->io_target, 1);
 
 	/* Cleanup; Complete outstanding I/O. */
 	stub_complete_io(g_bdev.io_target, AVAIL);
-	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&bdev_ch->shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&bdev_ch->nomem_io));
 	/* Complete the ENOMEM I/O */
 	stub_complete_io(g_bdev.io_target, 1);
 	CU_ASSERT(bdev_ch->shared_resource->io_outstanding == 0);
 
-	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&bdev_ch->shared_resource->nomem_io));
+	SPDK_CU_ASSERT_FATAL(TAILQ_EMPTY(&bdev_ch->nomem_io));
 	CU_ASSERT(bdev_ch->shared_resource->io_outstanding == 0);
 	spdk_put_io_channel(io_ch);
 	spdk_put_io_channel(second_ch);
@@ -1818,6 +2032,161 @@ qos_dynamic_enable(void)
 	teardown_test();
 }
 
+static void
+qos_group(void)
+{
+	struct spdk_io_channel *io_ch[2];
+	struct spdk_bdev_channel *bdev_ch[2];
+	struct ut_bdev *second_bdev;
+	struct spdk_bdev_desc *second_desc = NULL;
+	enum spdk_bdev_io_status status[5];
+	uint64_t limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	int rc, i;
+
+	setup_test();
+	MOCK_SET(spdk_get_ticks, 0);
+
+	second_bdev = calloc(1, sizeof(*second_bdev));
+	SPDK_CU_ASSERT_FATAL(second_bdev != NULL);
+	register_bdev(second_bdev, "ut_bdev2", g_bdev.io_target);
+	spdk_bdev_open_ext("ut_bdev2", true, _bdev_event_cb, NULL, &second_desc);
+	SPDK_CU_ASSERT_FATAL(second_desc != NULL);
+
+	g_get_io_channel = true;
+
+	set_thread(0);
+	io_ch[0] = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch[0] = spdk_io_channel_get_ctx(io_ch[0]);
+	io_ch[1] = spdk_bdev_get_io_channel(second_desc);
+	bdev_ch[1] = spdk_io_channel_get_ctx(io_ch[1]);
+
+	/* A group without rate limits is rejected */
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limits[i] = UINT64_MAX;
+	}
+	rc = spdk_bdev_qos_group_create("group0", limits, 2);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* 2000 I/O per second, or 2 per millisecond, with up to 2 milliseconds of burst */
+	limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT] = 2000;
+	rc = spdk_bdev_qos_group_create("group0", limits, 2);
+	CU_ASSERT(rc == 0);
+	limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT] = 2000;
+	rc = spdk_bdev_qos_group_create("group0", limits, 2);
+	CU_ASSERT(rc == -EEXIST);
+
+	/* The first bdev is guaranteed 1000 I/O per second, the second one nothing */
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limits[i] = UINT64_MAX;
+	}
+	limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT] = 1000;
+	rc = -1;
+	spdk_bdev_qos_group_add_bdev("group0", &g_bdev.bdev, limits, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT((bdev_ch[0]->flags & BDEV_CH_QOS_ENABLED) != 0);
+
+	limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT] = UINT64_MAX;
+	rc = -1;
+	spdk_bdev_qos_group_add_bdev("group0", &second_bdev->bdev, limits, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT((bdev_ch[1]->flags & BDEV_CH_QOS_ENABLED) != 0);
+
+	/* A bdev can be in one group only */
+	rc = -1;
+	spdk_bdev_qos_group_add_bdev("group0", &second_bdev->bdev, limits, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == -EBUSY);
+
+	/* The second bdev uses up the rate of the group */
+	for (i = 0; i < 3; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(second_desc, io_ch[1], NULL, 0, 1, io_during_io_done, &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	poll_threads();
+	stub_complete_io(g_bdev.io_target, 0);
+	CU_ASSERT(status[0] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[1] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[2] == SPDK_BDEV_IO_STATUS_PENDING);
+
+	/* The first bdev can still issue its guaranteed I/O, but no more */
+	for (i = 3; i < 5; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(g_desc, io_ch[0], NULL, 0, 1, io_during_io_done, &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	poll_threads();
+	stub_complete_io(g_bdev.io_target, 0);
+	CU_ASSERT(status[2] == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(status[3] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[4] == SPDK_BDEV_IO_STATUS_PENDING);
+
+	/* Refill the group, which lets both queued I/O through */
+	spdk_delay_us(2000);
+	poll_threads();
+	stub_complete_io(g_bdev.io_target, 0);
+	CU_ASSERT(status[2] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[4] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* After being idle, the group allows a burst of 2 milliseconds worth of I/O */
+	spdk_delay_us(10000);
+	poll_threads();
+	for (i = 0; i < 5; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(second_desc, io_ch[1], NULL, 0, 1, io_during_io_done, &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	poll_threads();
+	stub_complete_io(g_bdev.io_target, 0);
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT(status[i] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+	CU_ASSERT(status[4] == SPDK_BDEV_IO_STATUS_PENDING);
+
+	spdk_delay_us(1000);
+	poll_threads();
+	stub_complete_io(g_bdev.io_target, 0);
+	CU_ASSERT(status[4] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* The group can't be deleted while it has bdevs */
+	rc = spdk_bdev_qos_group_delete("group0");
+	CU_ASSERT(rc == -EBUSY);
+
+	/* Removing the bdevs disables QoS as they have no rate limits of their own */
+	rc = -1;
+	spdk_bdev_qos_group_remove_bdev(&g_bdev.bdev, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT((bdev_ch[0]->flags & BDEV_CH_QOS_ENABLED) == 0);
+	CU_ASSERT(g_bdev.bdev.internal.qos == NULL);
+
+	rc = -1;
+	spdk_bdev_qos_group_remove_bdev(&second_bdev->bdev, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT((bdev_ch[1]->flags & BDEV_CH_QOS_ENABLED) == 0);
+
+	rc = -1;
+	spdk_bdev_qos_group_remove_bdev(&second_bdev->bdev, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == -ENOENT);
+
+	rc = spdk_bdev_qos_group_delete("group0");
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_qos_group_delete("group0");
+	CU_ASSERT(rc == -ENODEV);
+
+	spdk_put_io_channel(io_ch[0]);
+	spdk_put_io_channel(io_ch[1]);
+	spdk_bdev_close(second_desc);
+	unregister_bdev(second_bdev);
+	poll_threads();
+	free(second_bdev);
+	teardown_test();
+}
+
 static void
 histogram_status_cb(void *cb_arg, int status)
 {
@@ -2217,7 +2586,7 @@ lock_lba_range_then_submit_io(void)
 	 * write I/O.
 	 */
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&bdev_ch[0]->locked_ranges);
+	range = TAILQ_FIRST(&bdev_ch[0]->bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -2284,7 +2653,7 @@ lock_lba_range_then_submit_io(void)
 	rc = bdev_unlock_lba_range(desc, io_ch[0], 20, 10, unlock_lba_range_done, &ctx0);
 	CU_ASSERT(rc == 0);
 	poll_threads();
-	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[0]->locked_ranges));
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[0]->bdev->internal.locked_ranges));
 
 	/* The LBA range is unlocked, so the write IOs should now have started execution. */
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[1]->io_locked));
@@ -2626,12 +2995,16 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, io_during_reset);
 	CU_ADD_TEST(suite, reset_completions);
 	CU_ADD_TEST(suite, io_during_qos_queue);
+	CU_ADD_TEST(suite, io_during_qos_distributed);
 	CU_ADD_TEST(suite, io_during_qos_reset);
 	CU_ADD_TEST(suite, enomem);
 	CU_ADD_TEST(suite, enomem_multi_bdev);
 	CU_ADD_TEST(suite, enomem_multi_bdev_unregister);
+	CU_ADD_TEST(suite, enomem_multi_bdev_fairness);
+	CU_ADD_TEST(suite, enomem_timed_retry);
 	CU_ADD_TEST(suite, enomem_multi_io_target);
 	CU_ADD_TEST(suite, qos_dynamic_enable);
+	CU_ADD_TEST(suite, qos_group);
 	CU_ADD_TEST(suite, bdev_histograms_mt);
 	CU_ADD_TEST(suite, bdev_set_io_timeout_mt);
 	CU_ADD_TEST(suite, lock_lba_range_then_submit_io);
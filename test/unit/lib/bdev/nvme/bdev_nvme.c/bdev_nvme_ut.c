@@ -41,6 +41,11 @@ DEFINE_STUB_V(spdk_nvme_ctrlr_set_remove_cb, (struct spdk_nvme_ctrlr *ctrlr,
 
 DEFINE_STUB(spdk_nvme_ctrlr_get_flags, uint64_t, (struct spdk_nvme_ctrlr *ctrlr), 0);
 
+DEFINE_STUB(spdk_nvme_ctrlr_get_pci_device, struct spdk_pci_device *,
+	    (struct spdk_nvme_ctrlr *ctrlr), NULL);
+
+DEFINE_STUB(spdk_pci_device_get_socket_id, int, (struct spdk_pci_device *dev), 0);
+
 DEFINE_STUB(accel_channel_create, int, (void *io_device, void *ctx_buf), 0);
 DEFINE_STUB_V(accel_channel_destroy, (void *io_device, void *ctx_buf));
 
@@ -70,6 +75,7 @@ DEFINE_STUB_V(spdk_bdev_add_io_stat, (struct spdk_bdev_io_stat *total,
 				      struct spdk_bdev_io_stat *add));
 
 DEFINE_STUB_V(spdk_nvme_qpair_set_abort_dnr, (struct spdk_nvme_qpair *qpair, bool dnr));
+DEFINE_STUB(spdk_nvme_qpair_enable_latency_tracking, int, (struct spdk_nvme_qpair *qpair), 0);
 
 int
 spdk_nvme_ctrlr_get_memory_domains(const struct spdk_nvme_ctrlr *ctrlr,
@@ -4621,6 +4627,206 @@ test_retry_io_for_io_path_error(void)
 	g_opts.bdev_retry_count = 0;
 }
 
+static void
+test_failover_io_for_io_path_error(void)
+{
+	struct nvme_path_id path1 = {}, path2 = {};
+	struct spdk_nvme_ctrlr *ctrlr1, *ctrlr2;
+	struct nvme_bdev_ctrlr *nbdev_ctrlr;
+	struct nvme_ctrlr *nvme_ctrlr1, *nvme_ctrlr2;
+	const int STRING_SIZE = 32;
+	const char *attached_names[STRING_SIZE];
+	struct nvme_bdev *bdev;
+	struct spdk_bdev_io *bdev_io;
+	struct nvme_bdev_io *bio;
+	struct spdk_io_channel *ch;
+	struct nvme_bdev_channel *nbdev_ch;
+	struct nvme_io_path *io_path1, *io_path2;
+	struct nvme_qpair *nvme_qpair1;
+	struct ut_nvme_req *req;
+	struct spdk_uuid uuid1 = { .u.raw = { 0x1 } };
+	int rc;
+
+	memset(attached_names, 0, sizeof(char *) * STRING_SIZE);
+	ut_init_trid(&path1.trid);
+	ut_init_trid2(&path2.trid);
+
+	g_opts.bdev_retry_count = 1;
+	g_opts.io_path_failover_count = 1;
+	g_opts.io_path_error_threshold = 2;
+
+	set_thread(0);
+
+	g_ut_attach_ctrlr_status = 0;
+	g_ut_attach_bdev_count = 1;
+
+	ctrlr1 = ut_attach_ctrlr(&path1.trid, 1, true, true);
+	SPDK_CU_ASSERT_FATAL(ctrlr1 != NULL);
+
+	ctrlr1->ns[0].uuid = &uuid1;
+
+	rc = bdev_nvme_create(&path1.trid, "nvme0", attached_names, STRING_SIZE,
+			      attach_ctrlr_done, NULL, NULL, NULL, true);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(1000);
+	poll_threads();
+
+	ctrlr2 = ut_attach_ctrlr(&path2.trid, 1, true, true);
+	SPDK_CU_ASSERT_FATAL(ctrlr2 != NULL);
+
+	ctrlr2->ns[0].uuid = &uuid1;
+
+	rc = bdev_nvme_create(&path2.trid, "nvme0", attached_names, STRING_SIZE,
+			      attach_ctrlr_done, NULL, NULL, NULL, true);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(1000);
+	poll_threads();
+
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	nbdev_ctrlr = nvme_bdev_ctrlr_get_by_name("nvme0");
+	SPDK_CU_ASSERT_FATAL(nbdev_ctrlr != NULL);
+
+	nvme_ctrlr1 = nvme_bdev_ctrlr_get_ctrlr(nbdev_ctrlr, &path1.trid);
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr1 != NULL);
+
+	nvme_ctrlr2 = nvme_bdev_ctrlr_get_ctrlr(nbdev_ctrlr, &path2.trid);
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr2 != NULL);
+
+	bdev = nvme_bdev_ctrlr_get_bdev(nbdev_ctrlr, 1);
+	SPDK_CU_ASSERT_FATAL(bdev != NULL);
+
+	bdev_io = ut_alloc_bdev_io(SPDK_BDEV_IO_TYPE_WRITE, bdev, NULL);
+	ut_bdev_io_set_buf(bdev_io);
+
+	bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+
+	ch = spdk_get_io_channel(bdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	nbdev_ch = spdk_io_channel_get_ctx(ch);
+
+	io_path1 = ut_get_io_path_by_ctrlr(nbdev_ch, nvme_ctrlr1);
+	SPDK_CU_ASSERT_FATAL(io_path1 != NULL);
+	io_path2 = ut_get_io_path_by_ctrlr(nbdev_ch, nvme_ctrlr2);
+	SPDK_CU_ASSERT_FATAL(io_path2 != NULL);
+
+	nvme_qpair1 = io_path1->qpair;
+
+	bdev_io->internal.ch = (struct spdk_bdev_channel *)ch;
+
+	/* I/O got a path error on io_path1 and should be resubmitted to io_path2 right away. */
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	CU_ASSERT(bio->io_path == io_path1);
+	CU_ASSERT(nvme_qpair1->qpair->num_outstanding_reqs == 1);
+
+	req = ut_get_outstanding_nvme_request(nvme_qpair1->qpair, bio);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+
+	req->cpl.status.sc = SPDK_NVME_SC_INTERNAL_PATH_ERROR;
+	req->cpl.status.sct = SPDK_NVME_SCT_PATH;
+
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(nvme_qpair1->qpair->num_outstanding_reqs == 0);
+	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->retry_io_list));
+	CU_ASSERT(bio->io_path == io_path2);
+	CU_ASSERT(io_path1->num_consecutive_errors == 1);
+	CU_ASSERT(!nvme_io_path_is_failed(io_path1));
+
+	poll_threads();
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bio->failover_count == 0);
+
+	/* A second path error in a row on io_path1 marks it failed, so it isn't selected. */
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	CU_ASSERT(bio->io_path == io_path1);
+
+	req = ut_get_outstanding_nvme_request(nvme_qpair1->qpair, bio);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+
+	req->cpl.status.sc = SPDK_NVME_SC_INTERNAL_PATH_ERROR;
+	req->cpl.status.sct = SPDK_NVME_SCT_PATH;
+
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->retry_io_list));
+	CU_ASSERT(bio->io_path == io_path2);
+	CU_ASSERT(io_path1->num_consecutive_errors == 2);
+	CU_ASSERT(nvme_io_path_is_failed(io_path1));
+
+	poll_threads();
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	bdev_nvme_clear_current_io_path(nbdev_ch);
+	CU_ASSERT(bdev_nvme_find_io_path(nbdev_ch) == io_path2);
+
+	/* The failed I/O path is selected again once the probe interval passed. */
+	spdk_delay_us(BDEV_NVME_IO_PATH_FAILED_PROBE_MS * 1000);
+
+	CU_ASSERT(!nvme_io_path_is_failed(io_path1));
+	bdev_nvme_clear_current_io_path(nbdev_ch);
+	CU_ASSERT(bdev_nvme_find_io_path(nbdev_ch) == io_path1);
+
+	/* Without failover, a path error is retried through the retry list as before. */
+	g_opts.io_path_failover_count = 0;
+	bdev_nvme_clear_current_io_path(nbdev_ch);
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	CU_ASSERT(bio->io_path == io_path1);
+
+	req = ut_get_outstanding_nvme_request(nvme_qpair1->qpair, bio);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+
+	req->cpl.status.sc = SPDK_NVME_SC_INTERNAL_PATH_ERROR;
+	req->cpl.status.sct = SPDK_NVME_SCT_PATH;
+
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(nvme_qpair1->qpair->num_outstanding_reqs == 0);
+	CU_ASSERT(bdev_io == TAILQ_FIRST(&nbdev_ch->retry_io_list));
+
+	poll_threads();
+
+	CU_ASSERT(bio->io_path == io_path2);
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	free(bdev_io);
+
+	spdk_put_io_channel(ch);
+
+	poll_threads();
+
+	rc = bdev_nvme_delete("nvme0", &g_any_path);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(1000);
+	poll_threads();
+
+	CU_ASSERT(nvme_bdev_ctrlr_get_by_name("nvme0") == NULL);
+
+	g_opts.bdev_retry_count = 0;
+	g_opts.io_path_failover_count = 0;
+	g_opts.io_path_error_threshold = 0;
+}
+
 static void
 test_retry_io_count(void)
 {
@@ -6052,6 +6258,93 @@ test_find_io_path_min_qd(void)
 	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
 }
 
+static void
+test_find_io_path_min_latency(void)
+{
+	struct nvme_bdev_channel nbdev_ch = {
+		.io_path_list = STAILQ_HEAD_INITIALIZER(nbdev_ch.io_path_list),
+		.mp_policy = BDEV_NVME_MP_POLICY_ACTIVE_ACTIVE,
+		.mp_selector = BDEV_NVME_MP_SELECTOR_LATENCY,
+	};
+	struct spdk_nvme_qpair qpair1 = {}, qpair2 = {}, qpair3 = {};
+	struct spdk_nvme_ctrlr ctrlr1 = {}, ctrlr2 = {}, ctrlr3 = {};
+	struct nvme_ctrlr nvme_ctrlr1 = { .ctrlr = &ctrlr1, };
+	struct nvme_ctrlr nvme_ctrlr2 = { .ctrlr = &ctrlr2, };
+	struct nvme_ctrlr nvme_ctrlr3 = { .ctrlr = &ctrlr3, };
+	struct nvme_ctrlr_channel ctrlr_ch1 = {};
+	struct nvme_ctrlr_channel ctrlr_ch2 = {};
+	struct nvme_ctrlr_channel ctrlr_ch3 = {};
+	struct nvme_qpair nvme_qpair1 = { .ctrlr_ch = &ctrlr_ch1, .ctrlr = &nvme_ctrlr1, .qpair = &qpair1, };
+	struct nvme_qpair nvme_qpair2 = { .ctrlr_ch = &ctrlr_ch2, .ctrlr = &nvme_ctrlr2, .qpair = &qpair2, };
+	struct nvme_qpair nvme_qpair3 = { .ctrlr_ch = &ctrlr_ch3, .ctrlr = &nvme_ctrlr3, .qpair = &qpair3, };
+	struct nvme_ns nvme_ns1 = {}, nvme_ns2 = {}, nvme_ns3 = {};
+	struct nvme_io_path io_path1 = { .qpair = &nvme_qpair1, .nvme_ns = &nvme_ns1, };
+	struct nvme_io_path io_path2 = { .qpair = &nvme_qpair2, .nvme_ns = &nvme_ns2, };
+	struct nvme_io_path io_path3 = { .qpair = &nvme_qpair3, .nvme_ns = &nvme_ns3, };
+	struct nvme_bdev_io bio = {};
+	uint64_t now;
+
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path1, stailq);
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path2, stailq);
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path3, stailq);
+
+	nvme_ns1.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns3.ana_state = SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+
+	/* Pretend all I/O paths were selected recently, so none is probed. */
+	spdk_delay_us(1000 * 1000);
+	now = spdk_get_ticks();
+	io_path1.last_selected_tsc = now;
+	io_path2.last_selected_tsc = now;
+	io_path3.last_selected_tsc = now;
+
+	/* The optimized I/O path with the lowest latency is selected. */
+	io_path1.latency_ewma_ticks = 100;
+	io_path2.latency_ewma_ticks = 300;
+	io_path3.latency_ewma_ticks = 10;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	/* The latency is weighted by the queue depth. */
+	qpair1.num_outstanding_reqs = 3;
+	qpair2.num_outstanding_reqs = 0;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+
+	qpair1.num_outstanding_reqs = 1;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	/* The non-optimized I/O path is used only if no optimized I/O path is available. */
+	nvme_ns1.ana_state = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path3);
+
+	nvme_ns1.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+
+	/* An I/O path not selected for the probe interval is selected once. */
+	spdk_delay_us(BDEV_NVME_LATENCY_PROBE_INTERVAL_MS * 1000 / 2);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+	spdk_delay_us(BDEV_NVME_LATENCY_PROBE_INTERVAL_MS * 1000 / 2);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	/* The first completion sets the latency, later ones update the moving average. */
+	io_path2.latency_ewma_ticks = 0;
+	bio.io_path = &io_path2;
+	bio.submit_tsc = spdk_get_ticks();
+	spdk_delay_us(10);
+	bdev_nvme_update_io_path_latency(&bio);
+	now = io_path2.latency_ewma_ticks;
+	CU_ASSERT(now == spdk_get_ticks() - bio.submit_tsc);
+
+	bio.submit_tsc = spdk_get_ticks();
+	spdk_delay_us(90);
+	bdev_nvme_update_io_path_latency(&bio);
+	CU_ASSERT(io_path2.latency_ewma_ticks == now - (now >> BDEV_NVME_LATENCY_EWMA_SHIFT) +
+		  ((spdk_get_ticks() - bio.submit_tsc) >> BDEV_NVME_LATENCY_EWMA_SHIFT));
+	CU_ASSERT(io_path2.latency_ewma_ticks > now);
+}
+
 static void
 test_disable_auto_failback(void)
 {
@@ -7182,6 +7475,80 @@ test_disable_enable_ctrlr(void)
 	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
 }
 
+static void
+test_io_qd_limit(void)
+{
+	struct nvme_ctrlr nvme_ctrlr = {};
+	struct nvme_qpair nvme_qpair1 = {}, nvme_qpair2 = {};
+	struct nvme_io_path io_path1 = {}, io_path2 = {};
+	struct nvme_bdev_io bio[6] = {};
+	int i;
+
+	nvme_ctrlr.opts.io_queue_depth_limit = 4;
+	nvme_ctrlr.io_qd_limit = 4;
+	nvme_ctrlr.num_io_qpairs = 2;
+	nvme_qpair1.ctrlr = &nvme_ctrlr;
+	nvme_qpair2.ctrlr = &nvme_ctrlr;
+	io_path1.qpair = &nvme_qpair1;
+	io_path2.qpair = &nvme_qpair2;
+
+	/* A qpair may borrow the part of the limit left unused by the others. */
+	for (i = 0; i < 4; i++) {
+		bio[i].io_path = &io_path1;
+		CU_ASSERT(bdev_nvme_io_qd_admit(&bio[i]) == true);
+	}
+	CU_ASSERT(nvme_qpair1.num_outstanding_io == 4);
+	CU_ASSERT(nvme_ctrlr.io_outstanding == 4);
+
+	bio[4].io_path = &io_path1;
+	CU_ASSERT(bdev_nvme_io_qd_admit(&bio[4]) == false);
+	CU_ASSERT(bio[4].qd_qpair == NULL);
+
+	/* A qpair below its fair share is always admitted. */
+	bio[5].io_path = &io_path2;
+	CU_ASSERT(bdev_nvme_io_qd_admit(&bio[5]) == true);
+	CU_ASSERT(nvme_ctrlr.io_outstanding == 5);
+
+	bdev_nvme_io_qd_release(&bio[0], false);
+	CU_ASSERT(bdev_nvme_io_qd_admit(&bio[4]) == false);
+
+	bdev_nvme_io_qd_release(&bio[1], false);
+	CU_ASSERT(bdev_nvme_io_qd_admit(&bio[4]) == true);
+	CU_ASSERT(nvme_qpair1.num_outstanding_io == 3);
+
+	bdev_nvme_io_qd_release(&bio[2], false);
+	bdev_nvme_io_qd_release(&bio[3], false);
+	bdev_nvme_io_qd_release(&bio[4], false);
+	bdev_nvme_io_qd_release(&bio[5], false);
+	CU_ASSERT(nvme_ctrlr.io_outstanding == 0);
+	CU_ASSERT(nvme_qpair1.num_outstanding_io == 0);
+	CU_ASSERT(nvme_qpair2.num_outstanding_io == 0);
+
+	/* A released I/O is not accounted twice. */
+	bdev_nvme_io_qd_release(&bio[0], false);
+	CU_ASSERT(nvme_ctrlr.io_outstanding == 0);
+
+	/* The limit is decreased multiplicatively while the latency is above the target. */
+	nvme_ctrlr.opts.io_target_latency_us = 100;
+	spdk_delay_us(BDEV_NVME_QD_ADJUST_INTERVAL_US);
+	bdev_nvme_io_qd_adjust(&nvme_qpair1, 200);
+	CU_ASSERT(nvme_ctrlr.io_qd_limit == 3);
+
+	/* It is adjusted at most once per interval. */
+	bdev_nvme_io_qd_adjust(&nvme_qpair1, 200);
+	CU_ASSERT(nvme_ctrlr.io_qd_limit == 3);
+
+	/* It is increased additively up to the configured limit once below the target. */
+	nvme_qpair1.latency_ewma_ticks = 0;
+	spdk_delay_us(BDEV_NVME_QD_ADJUST_INTERVAL_US);
+	bdev_nvme_io_qd_adjust(&nvme_qpair1, 50);
+	CU_ASSERT(nvme_ctrlr.io_qd_limit == 4);
+
+	spdk_delay_us(BDEV_NVME_QD_ADJUST_INTERVAL_US);
+	bdev_nvme_io_qd_adjust(&nvme_qpair1, 50);
+	CU_ASSERT(nvme_ctrlr.io_qd_limit == 4);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -7217,6 +7584,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_find_io_path);
 	CU_ADD_TEST(suite, test_retry_io_if_ana_state_is_updating);
 	CU_ADD_TEST(suite, test_retry_io_for_io_path_error);
+	CU_ADD_TEST(suite, test_failover_io_for_io_path_error);
+	CU_ADD_TEST(suite, test_io_qd_limit);
 	CU_ADD_TEST(suite, test_retry_io_count);
 	CU_ADD_TEST(suite, test_concurrent_read_ana_log_page);
 	CU_ADD_TEST(suite, test_retry_io_for_ana_error);
@@ -7230,6 +7599,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_set_preferred_path);
 	CU_ADD_TEST(suite, test_find_next_io_path);
 	CU_ADD_TEST(suite, test_find_io_path_min_qd);
+	CU_ADD_TEST(suite, test_find_io_path_min_latency);
 	CU_ADD_TEST(suite, test_disable_auto_failback);
 	CU_ADD_TEST(suite, test_set_multipath_policy);
 	CU_ADD_TEST(suite, test_uuid_generation);
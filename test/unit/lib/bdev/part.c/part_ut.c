@@ -211,13 +211,36 @@ __io_type_supported(void *ctx, enum spdk_bdev_io_type type)
 	return true;
 }
 
+static void
+base_ut_submit_request(struct spdk_io_channel *_ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_ut_channel *ch = spdk_io_channel_get_ctx(_ch);
+
+	TAILQ_INSERT_TAIL(&ch->outstanding_io, bdev_io, module_link);
+	ch->outstanding_io_count++;
+}
+
+static struct spdk_bdev_io *g_part_io;
+
+static void
+part_ut_submit_request(struct spdk_io_channel *_ch, struct spdk_bdev_io *bdev_io)
+{
+	int rc;
+
+	g_part_io = bdev_io;
+	rc = spdk_bdev_part_submit_request(spdk_io_channel_get_ctx(_ch), bdev_io);
+	CU_ASSERT(rc == 0);
+}
+
 static struct spdk_bdev_fn_table base_fn_table = {
 	.destruct		= __destruct,
+	.submit_request		= base_ut_submit_request,
 	.get_io_channel = part_ut_get_io_channel,
 	.io_type_supported	= __io_type_supported,
 };
 static struct spdk_bdev_fn_table part_fn_table = {
 	.destruct		= __destruct,
+	.submit_request		= part_ut_submit_request,
 	.io_type_supported	= __io_type_supported,
 };
 
@@ -402,6 +425,108 @@ part_get_io_channel_test(void)
 	ut_fini_bdev();
 }
 
+static void
+part_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_part *part = cb_arg;
+
+	CU_ASSERT(success);
+	CU_ASSERT(bdev_io == g_part_io);
+	CU_ASSERT(bdev_io->bdev == &part->internal.bdev);
+	CU_ASSERT(bdev_io->u.bdev.offset_blocks == 10);
+	g_part_io = NULL;
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+part_remap_io_test(void)
+{
+	struct spdk_bdev_part_base	*base = NULL;
+	struct spdk_bdev_desc		*desc = NULL;
+	struct spdk_io_channel		*io_ch;
+	struct spdk_bdev_part		*part;
+	struct spdk_bdev		bdev_base = {};
+	struct spdk_bdev_io		*bdev_io;
+	SPDK_BDEV_PART_TAILQ		tailq = TAILQ_HEAD_INITIALIZER(tailq);
+	char				buf[8 * 512];
+	int rc;
+
+	ut_init_bdev();
+	bdev_base.name = "base";
+	bdev_base.blocklen = 512;
+	bdev_base.blockcnt = 1024;
+	bdev_base.fn_table = &base_fn_table;
+	bdev_base.module = &bdev_ut_if;
+	rc = spdk_bdev_register(&bdev_base);
+	CU_ASSERT(rc == 0);
+
+	rc = spdk_bdev_part_base_construct_ext("base", NULL, &vbdev_ut_if,
+					       &part_fn_table, &tailq, NULL,
+					       NULL, sizeof(struct spdk_bdev_part_channel),
+					       NULL, NULL, &base);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(base != NULL);
+
+	part = calloc(1, sizeof(*part));
+	SPDK_CU_ASSERT_FATAL(part != NULL);
+	rc = spdk_bdev_part_construct(part, base, "test", 100, 100, "test");
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	rc = spdk_bdev_open_ext("test", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(io_ch != NULL);
+	SPDK_CU_ASSERT_FATAL(g_bdev_ut_channel != NULL);
+
+	/* Reads and writes are passed to the base bdev without allocating a child I/O */
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 10, 8, part_io_done, part);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	bdev_io = TAILQ_FIRST(&g_bdev_ut_channel->outstanding_io);
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	CU_ASSERT(bdev_io == g_part_io);
+	CU_ASSERT(bdev_io->bdev == &bdev_base);
+	CU_ASSERT(bdev_io->u.bdev.offset_blocks == 110);
+	CU_ASSERT(spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io)) ==
+		  g_bdev_ut_channel);
+
+	TAILQ_REMOVE(&g_bdev_ut_channel->outstanding_io, bdev_io, module_link);
+	g_bdev_ut_channel->outstanding_io_count--;
+	spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	poll_threads();
+	CU_ASSERT(g_part_io == NULL);
+
+	/* Other I/O types still go through a child I/O */
+	rc = spdk_bdev_compare_blocks(desc, io_ch, buf, 10, 8, part_io_done, part);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	bdev_io = TAILQ_FIRST(&g_bdev_ut_channel->outstanding_io);
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	CU_ASSERT(bdev_io != g_part_io);
+	CU_ASSERT(bdev_io->bdev == &bdev_base);
+	CU_ASSERT(bdev_io->u.bdev.offset_blocks == 110);
+
+	TAILQ_REMOVE(&g_bdev_ut_channel->outstanding_io, bdev_io, module_link);
+	g_bdev_ut_channel->outstanding_io_count--;
+	spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	poll_threads();
+	CU_ASSERT(g_part_io == NULL);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	spdk_bdev_unregister(&part->internal.bdev, NULL, NULL);
+	poll_threads();
+
+	rc = spdk_bdev_part_free(part);
+	CU_ASSERT(rc == 1);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&tailq));
+
+	spdk_bdev_unregister(&bdev_base, NULL, NULL);
+	ut_fini_bdev();
+}
+
 static void
 part_construct_ext(void)
 {
@@ -458,6 +583,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, part_free_test);
 	CU_ADD_TEST(suite, part_get_io_channel_test);
 	CU_ADD_TEST(suite, part_construct_ext);
+	CU_ADD_TEST(suite, part_remap_io_test);
 
 	allocate_cores(1);
 	allocate_threads(1);
@@ -73,6 +73,12 @@ struct raid_io_ranges g_io_ranges[MAX_TEST_IO_RANGE];
 uint32_t g_io_range_idx;
 uint64_t g_lba_offset;
 struct spdk_io_channel g_io_channel;
+uint64_t g_quiesced_offset;
+uint64_t g_quiesced_length;
+uint32_t g_quiesce_range_count;
+/* Offset of this raid channel when the last range was unquiesced */
+struct raid_bdev_io_channel *g_process_raid_ch;
+uint64_t g_unquiesce_ch_offset;
 
 DEFINE_STUB_V(spdk_bdev_module_examine_done, (struct spdk_bdev_module *module));
 DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
@@ -109,6 +115,8 @@ DEFINE_STUB(spdk_json_write_named_array_begin, int, (struct spdk_json_write_ctx
 		const char *name), 0);
 DEFINE_STUB(spdk_json_write_bool, int, (struct spdk_json_write_ctx *w, bool val), 0);
 DEFINE_STUB(spdk_json_write_null, int, (struct spdk_json_write_ctx *w), 0);
+DEFINE_STUB(spdk_json_write_named_uint64, int, (struct spdk_json_write_ctx *w, const char *name,
+		uint64_t val), 0);
 DEFINE_STUB(spdk_strerror, const char *, (int errnum), NULL);
 DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 		struct spdk_bdev_io_wait_entry *entry), 0);
@@ -117,6 +125,7 @@ DEFINE_STUB(spdk_bdev_get_memory_domains, int, (struct spdk_bdev *bdev,
 DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "test_bdev");
 DEFINE_STUB(spdk_bdev_get_md_size, uint32_t, (const struct spdk_bdev *bdev), 0);
 DEFINE_STUB(spdk_bdev_is_md_interleaved, bool, (const struct spdk_bdev *bdev), false);
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
 DEFINE_STUB(spdk_bdev_get_dif_type, enum spdk_dif_type, (const struct spdk_bdev *bdev),
 	    SPDK_DIF_DISABLE);
 DEFINE_STUB(spdk_bdev_is_dif_head_of_md, bool, (const struct spdk_bdev *bdev), false);
@@ -611,6 +620,43 @@ spdk_bdev_unquiesce(struct spdk_bdev *bdev, struct spdk_bdev_module *module,
 	return 0;
 }
 
+int
+spdk_bdev_quiesce_range(struct spdk_bdev *bdev, struct spdk_bdev_module *module,
+			uint64_t offset, uint64_t length,
+			spdk_bdev_quiesce_cb cb_fn, void *cb_arg)
+{
+	/* Only one range is quiesced at a time */
+	CU_ASSERT(g_quiesced_length == 0);
+	g_quiesced_offset = offset;
+	g_quiesced_length = length;
+	g_quiesce_range_count++;
+
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+
+	return 0;
+}
+
+int
+spdk_bdev_unquiesce_range(struct spdk_bdev *bdev, struct spdk_bdev_module *module,
+			  uint64_t offset, uint64_t length,
+			  spdk_bdev_quiesce_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(offset == g_quiesced_offset);
+	CU_ASSERT(length == g_quiesced_length);
+	g_quiesced_length = 0;
+	if (g_process_raid_ch != NULL) {
+		g_unquiesce_ch_offset = g_process_raid_ch->process.offset;
+	}
+
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+
+	return 0;
+}
+
 static void
 bdev_io_cleanup(struct spdk_bdev_io *bdev_io)
 {
@@ -724,6 +770,54 @@ verify_io(struct spdk_bdev_io *bdev_io, uint8_t num_base_drives,
 	CU_ASSERT(g_io_comp_status == io_status);
 }
 
+static void
+verify_io_multi_strip(struct spdk_bdev_io *bdev_io, uint8_t num_base_drives,
+		      struct raid_bdev_io_channel *ch_ctx, struct raid_bdev *raid_bdev,
+		      uint32_t io_status)
+{
+	uint32_t strip_shift = spdk_u32log2(g_strip_size);
+	uint64_t start_strip = bdev_io->u.bdev.offset_blocks >> strip_shift;
+	uint64_t end_strip = (bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks - 1) >>
+			     strip_shift;
+	uint64_t n_disks = spdk_min(end_strip - start_strip + 1, num_base_drives);
+	uint64_t disk_lba[MAX_BASE_DRIVES];
+	uint64_t disk_blocks[MAX_BASE_DRIVES] = {};
+	uint64_t strip_lba, strip_blocks, lba, end_lba;
+	uint64_t strip;
+	uint8_t pd_idx;
+	uint32_t index;
+	struct io_output *output;
+
+	SPDK_CU_ASSERT_FATAL(num_base_drives <= MAX_BASE_DRIVES);
+
+	/* Each base bdev gets a single IO covering all its strips touched by the raid IO */
+	end_lba = bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks;
+	for (strip = start_strip; strip <= end_strip; strip++) {
+		pd_idx = strip % num_base_drives;
+		lba = spdk_max(strip << strip_shift, bdev_io->u.bdev.offset_blocks);
+		strip_lba = ((strip / num_base_drives) << strip_shift) + (lba & (g_strip_size - 1));
+		strip_blocks = spdk_min((strip + 1) << strip_shift, end_lba) - lba;
+		if (disk_blocks[pd_idx] == 0) {
+			disk_lba[pd_idx] = strip_lba;
+		} else {
+			CU_ASSERT(disk_lba[pd_idx] + disk_blocks[pd_idx] == strip_lba);
+		}
+		disk_blocks[pd_idx] += strip_blocks;
+	}
+
+	CU_ASSERT(g_io_output_index == n_disks);
+	for (index = 0; index < n_disks; index++) {
+		pd_idx = (start_strip + index) % num_base_drives;
+		output = &g_io_output[index];
+		CU_ASSERT(disk_lba[pd_idx] == output->offset_blocks);
+		CU_ASSERT(disk_blocks[pd_idx] == output->num_blocks);
+		CU_ASSERT(ch_ctx->base_channel[pd_idx] == output->ch);
+		CU_ASSERT(raid_bdev->base_bdev_info[pd_idx].desc == output->desc);
+		CU_ASSERT(bdev_io->type == output->iotype);
+	}
+	CU_ASSERT(g_io_comp_status == io_status);
+}
+
 static void
 verify_io_without_payload(struct spdk_bdev_io *bdev_io, uint8_t num_base_drives,
 			  struct raid_bdev_io_channel *ch_ctx, struct raid_bdev *raid_bdev,
@@ -901,7 +995,7 @@ verify_raid_bdev(struct rpc_bdev_raid_create *r, bool presence, uint32_t raid_st
 			CU_ASSERT(pbdev->bdev.blocklen == g_block_len);
 			if (pbdev->num_base_bdevs > 1) {
 				CU_ASSERT(pbdev->bdev.optimal_io_boundary == pbdev->strip_size);
-				CU_ASSERT(pbdev->bdev.split_on_optimal_io_boundary == true);
+				CU_ASSERT(pbdev->bdev.split_on_optimal_io_boundary == false);
 			} else {
 				CU_ASSERT(pbdev->bdev.optimal_io_boundary == 0);
 				CU_ASSERT(pbdev->bdev.split_on_optimal_io_boundary == false);
@@ -1337,6 +1431,91 @@ test_write_io(void)
 	reset_globals();
 }
 
+static void
+test_multi_strip_io(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct raid_bdev *pbdev;
+	struct spdk_io_channel *ch;
+	struct raid_bdev_io_channel *ch_ctx;
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_io_channel *ch_b;
+	struct spdk_bdev_channel *ch_b_ctx;
+	uint32_t max_io_size = g_max_io_size;
+	uint64_t io_lbas[3], io_lens[3];
+	int16_t iotype;
+	uint8_t i;
+
+	/* Allow IOs long enough to wrap around all the base bdevs more than once */
+	g_max_io_size = g_strip_size * g_max_base_drives * 3;
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0);
+	verify_raid_bdev_present("raid1", false);
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+	TAILQ_FOREACH(pbdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(pbdev->bdev.name, "raid1") == 0) {
+			break;
+		}
+	}
+	CU_ASSERT(pbdev != NULL);
+	ch = calloc(1, sizeof(struct spdk_io_channel) + sizeof(struct raid_bdev_io_channel));
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	ch_b = calloc(1, sizeof(struct spdk_io_channel) + sizeof(struct spdk_bdev_channel));
+	SPDK_CU_ASSERT_FATAL(ch_b != NULL);
+	ch_b_ctx = spdk_io_channel_get_ctx(ch_b);
+	ch_b_ctx->channel = ch;
+
+	ch_ctx = spdk_io_channel_get_ctx(ch);
+	SPDK_CU_ASSERT_FATAL(ch_ctx != NULL);
+
+	CU_ASSERT(raid_bdev_create_cb(pbdev, ch_ctx) == 0);
+
+	/* Two strips, fewer strips than base bdevs, and several strips per base bdev */
+	io_lbas[0] = g_strip_size / 2;
+	io_lens[0] = g_strip_size;
+	io_lbas[1] = g_strip_size * 3 + 1;
+	io_lens[1] = g_strip_size * (g_max_base_drives / 2);
+	io_lbas[2] = g_strip_size * g_max_base_drives - 1;
+	io_lens[2] = g_strip_size * g_max_base_drives * 2 + 2;
+
+	for (iotype = SPDK_BDEV_IO_TYPE_READ; iotype <= SPDK_BDEV_IO_TYPE_WRITE; iotype++) {
+		for (i = 0; i < SPDK_COUNTOF(io_lbas); i++) {
+			bdev_io = calloc(1, sizeof(struct spdk_bdev_io) +
+					 sizeof(struct raid_bdev_io));
+			SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+			bdev_io_initialize(bdev_io, ch_b, &pbdev->bdev, io_lbas[i], io_lens[i],
+					   iotype);
+			memset(g_io_output, 0, g_max_base_drives * sizeof(struct io_output));
+			g_io_output_index = 0;
+			raid_bdev_submit_request(ch, bdev_io);
+			verify_io_multi_strip(bdev_io, req.base_bdevs.num_base_bdevs, ch_ctx, pbdev,
+					      g_child_io_status_flag);
+			bdev_io_cleanup(bdev_io);
+		}
+	}
+
+	free_test_req(&req);
+	raid_bdev_destroy_cb(pbdev, ch_ctx);
+	CU_ASSERT(ch_ctx->base_channel == NULL);
+	free(ch);
+	free(ch_b);
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+	g_max_io_size = max_io_size;
+}
+
 static void
 test_read_io(void)
 {
@@ -1970,6 +2149,395 @@ test_raid_level_conversions(void)
 	CU_ASSERT(raid_str != NULL && strcmp(raid_str, "raid0") == 0);
 }
 
+static void
+test_raid_read_policy_conversions(void)
+{
+	const char *policy_str;
+
+	CU_ASSERT(raid_bdev_str_to_read_policy("abcd123") == RAID_BDEV_READ_POLICY_MAX);
+	CU_ASSERT(raid_bdev_str_to_read_policy("round_robin") == RAID_BDEV_READ_POLICY_ROUND_ROBIN);
+	CU_ASSERT(raid_bdev_str_to_read_policy("least_outstanding") ==
+		  RAID_BDEV_READ_POLICY_LEAST_OUTSTANDING);
+	CU_ASSERT(raid_bdev_str_to_read_policy("LBA_SHARD") == RAID_BDEV_READ_POLICY_LBA_SHARD);
+
+	policy_str = raid_bdev_read_policy_to_str(RAID_BDEV_READ_POLICY_MAX);
+	CU_ASSERT(policy_str != NULL && strlen(policy_str) == 0);
+	policy_str = raid_bdev_read_policy_to_str(RAID_BDEV_READ_POLICY_LBA_SHARD);
+	CU_ASSERT(policy_str != NULL && strcmp(policy_str, "lba_shard") == 0);
+}
+
+#define PROCESS_BLOCK_CNT 1024
+#define PROCESS_WINDOW_SIZE_KB 1024
+#define PROCESS_WINDOW_BLOCKS (PROCESS_WINDOW_SIZE_KB * 1024 / 4096)
+
+/* Raid module with a background process handler, keeping the process requests pending */
+struct raid_bdev_process_request *g_process_req;
+uint32_t g_process_req_count;
+uint64_t g_process_req_max_blocks;
+int g_process_submit_rc;
+int g_remove_cb_status;
+bool g_remove_cb_called;
+
+static int
+ut_process_module_start(struct raid_bdev *raid_bdev)
+{
+	struct raid_base_bdev_info *base_info;
+	uint64_t min_blockcnt = UINT64_MAX;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		min_blockcnt = spdk_min(min_blockcnt,
+					spdk_bdev_desc_get_bdev(base_info->desc)->blockcnt);
+	}
+	raid_bdev->bdev.blockcnt = min_blockcnt;
+
+	return 0;
+}
+
+static void
+ut_process_module_submit_rw_request(struct raid_bdev_io *raid_io)
+{
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static int
+ut_process_module_submit_process_request(struct raid_bdev_process_request *process_req)
+{
+	if (g_process_submit_rc != 0) {
+		return g_process_submit_rc;
+	}
+
+	CU_ASSERT(g_process_req == NULL);
+	CU_ASSERT(process_req->offset_blocks >= g_quiesced_offset);
+	CU_ASSERT(process_req->offset_blocks + process_req->num_blocks <=
+		  g_quiesced_offset + g_quiesced_length);
+	CU_ASSERT(process_req->iov.iov_len == process_req->num_blocks * 4096);
+
+	process_req->num_blocks = spdk_min(process_req->num_blocks, g_process_req_max_blocks);
+	g_process_req = process_req;
+	g_process_req_count++;
+
+	return 0;
+}
+
+static struct raid_bdev_module g_ut_process_module = {
+	.level = RAID1,
+	.base_bdevs_min = 2,
+	.base_bdevs_constraint = {CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL, 1},
+	.start = ut_process_module_start,
+	.submit_rw_request = ut_process_module_submit_rw_request,
+	.submit_process_request = ut_process_module_submit_process_request,
+};
+RAID_MODULE_REGISTER(&g_ut_process_module)
+
+static void
+ut_process_complete_request(int status)
+{
+	struct raid_bdev_process_request *process_req = g_process_req;
+
+	SPDK_CU_ASSERT_FATAL(process_req != NULL);
+	g_process_req = NULL;
+	raid_bdev_process_request_complete(process_req, status);
+	poll_threads();
+}
+
+static void
+ut_process_remove_cb(void *ctx, int status)
+{
+	g_remove_cb_called = true;
+	g_remove_cb_status = status;
+}
+
+static void
+ut_process_delete_cb(void *ctx, int status)
+{
+	CU_ASSERT(status == 0);
+	*(bool *)ctx = true;
+}
+
+/*
+ * Create a 2-way mirror degraded to its first base bdev, then add a third base bdev to it,
+ * which starts a rebuild. Returns the raid bdev channel that the test holds.
+ */
+static struct raid_bdev *
+ut_process_start(uint32_t max_bandwidth_mb_sec, struct spdk_io_channel **ch)
+{
+	struct raid_bdev_opts opts = {
+		.process_window_size_kb = PROCESS_WINDOW_SIZE_KB,
+		.process_max_bandwidth_mb_sec = max_bandwidth_mb_sec,
+	};
+	struct raid_bdev *raid_bdev;
+	struct spdk_bdev *base_bdev;
+	char name[16];
+	uint8_t i;
+	int rc;
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+	CU_ASSERT(raid_bdev_set_opts(&opts) == 0);
+	g_quiesced_length = 0;
+	g_quiesce_range_count = 0;
+	g_process_req = NULL;
+	g_process_req_count = 0;
+	g_process_req_max_blocks = UINT64_MAX;
+	g_process_submit_rc = 0;
+
+	for (i = 0; i < 3; i++) {
+		snprintf(name, sizeof(name), "Nvme%un1", i);
+		base_bdev = calloc(1, sizeof(*base_bdev));
+		SPDK_CU_ASSERT_FATAL(base_bdev != NULL);
+		base_bdev->name = strdup(name);
+		SPDK_CU_ASSERT_FATAL(base_bdev->name != NULL);
+		base_bdev->blocklen = g_block_len;
+		base_bdev->blockcnt = PROCESS_BLOCK_CNT;
+		TAILQ_INSERT_TAIL(&g_bdev_list, base_bdev, internal.link);
+	}
+
+	rc = raid_bdev_create("raid_process", 0, 2, RAID1, RAID_BDEV_READ_POLICY_ROUND_ROBIN,
+			      &raid_bdev, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(raid_bdev != NULL);
+	CU_ASSERT(raid_bdev_add_base_bdev(raid_bdev, "Nvme0n1") == 0);
+	CU_ASSERT(raid_bdev_add_base_bdev(raid_bdev, "Nvme1n1") == 0);
+	CU_ASSERT(raid_bdev->state == RAID_BDEV_STATE_ONLINE);
+	CU_ASSERT(raid_bdev->bdev.blockcnt == PROCESS_BLOCK_CNT);
+
+	/* The process opens the raid bdev by name */
+	TAILQ_INSERT_TAIL(&g_bdev_list, &raid_bdev->bdev, internal.link);
+
+	*ch = spdk_get_io_channel(raid_bdev);
+	SPDK_CU_ASSERT_FATAL(*ch != NULL);
+	g_process_raid_ch = spdk_io_channel_get_ctx(*ch);
+
+	g_remove_cb_called = false;
+	rc = raid_bdev_remove_base_bdev(spdk_bdev_get_by_name("Nvme1n1"), ut_process_remove_cb,
+					NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_remove_cb_called);
+	CU_ASSERT(raid_bdev->state == RAID_BDEV_STATE_ONLINE);
+	CU_ASSERT(raid_bdev->num_base_bdevs_discovered == 1);
+	CU_ASSERT(g_process_raid_ch->base_channel[1] == NULL);
+
+	rc = raid_bdev_add_base_bdev(raid_bdev, "Nvme2n1");
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(raid_bdev->process != NULL);
+	CU_ASSERT(raid_bdev->base_bdev_info[1].is_process_target);
+	CU_ASSERT(raid_bdev->num_base_bdevs_discovered == 1);
+
+	/* A second process can't be started */
+	CU_ASSERT(raid_bdev_add_base_bdev(raid_bdev, "Nvme1n1") == -EINVAL);
+
+	return raid_bdev;
+}
+
+static void
+ut_process_cleanup(struct raid_bdev *raid_bdev, struct spdk_io_channel *ch)
+{
+	struct raid_bdev_opts opts = {
+		.process_window_size_kb = RAID_BDEV_PROCESS_WINDOW_SIZE_KB_DEFAULT,
+		.process_max_bandwidth_mb_sec = RAID_BDEV_PROCESS_MAX_BANDWIDTH_MB_SEC_DEFAULT,
+	};
+	bool deleted = false;
+
+	g_process_raid_ch = NULL;
+	spdk_put_io_channel(ch);
+	poll_threads();
+
+	TAILQ_REMOVE(&g_bdev_list, &raid_bdev->bdev, internal.link);
+	raid_bdev_delete(raid_bdev, ut_process_delete_cb, &deleted);
+	poll_threads();
+	CU_ASSERT(deleted);
+	verify_raid_bdev_present("raid_process", false);
+
+	CU_ASSERT(raid_bdev_set_opts(&opts) == 0);
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+}
+
+static void
+test_process_window_advance(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_bdev_process *process;
+	struct spdk_io_channel *ch;
+	uint64_t window_offset;
+
+	raid_bdev = ut_process_start(0, &ch);
+	g_process_req_max_blocks = 100;
+	poll_threads();
+	process = raid_bdev->process;
+	SPDK_CU_ASSERT_FATAL(process != NULL);
+	CU_ASSERT(process->state == RAID_PROCESS_STATE_RUNNING);
+	CU_ASSERT(g_process_raid_ch->process.offset == 0);
+	CU_ASSERT(g_process_raid_ch->process.ch_processed != NULL);
+	CU_ASSERT(g_process_raid_ch->process.ch_processed->base_channel[1] == &g_io_channel);
+
+	for (window_offset = 0; window_offset < PROCESS_BLOCK_CNT;
+	     window_offset += PROCESS_WINDOW_BLOCKS) {
+		/* Only the window is quiesced, the module handles it in pieces */
+		CU_ASSERT(g_quiesce_range_count == window_offset / PROCESS_WINDOW_BLOCKS + 1);
+		CU_ASSERT(g_quiesced_offset == window_offset);
+		CU_ASSERT(g_quiesced_length == PROCESS_WINDOW_BLOCKS);
+
+		SPDK_CU_ASSERT_FATAL(g_process_req != NULL);
+		CU_ASSERT(g_process_req->offset_blocks == window_offset);
+		CU_ASSERT(g_process_req->num_blocks == 100);
+		CU_ASSERT(g_process_req->target == &raid_bdev->base_bdev_info[1]);
+		ut_process_complete_request(0);
+
+		SPDK_CU_ASSERT_FATAL(g_process_req != NULL);
+		CU_ASSERT(g_process_req->offset_blocks == window_offset + 100);
+		ut_process_complete_request(0);
+
+		SPDK_CU_ASSERT_FATAL(g_process_req != NULL);
+		CU_ASSERT(g_process_req->offset_blocks == window_offset + 200);
+		CU_ASSERT(g_process_req->num_blocks == PROCESS_WINDOW_BLOCKS - 200);
+		CU_ASSERT(g_process_raid_ch->process.offset == window_offset);
+
+		/* The channels move to the next window before the range is unquiesced */
+		ut_process_complete_request(0);
+		CU_ASSERT(g_unquiesce_ch_offset == window_offset + PROCESS_WINDOW_BLOCKS);
+	}
+
+	/* The target becomes a regular member once the whole raid bdev is processed */
+	CU_ASSERT(g_process_req_count == 3 * PROCESS_BLOCK_CNT / PROCESS_WINDOW_BLOCKS);
+	CU_ASSERT(g_quiesced_length == 0);
+	CU_ASSERT(raid_bdev->process == NULL);
+	CU_ASSERT(!raid_bdev->base_bdev_info[1].is_process_target);
+	CU_ASSERT(raid_bdev->base_bdev_info[1].desc != NULL);
+	CU_ASSERT(raid_bdev->num_base_bdevs_discovered == 2);
+	CU_ASSERT(g_process_raid_ch->process.offset == RAID_OFFSET_BLOCKS_INVALID);
+	CU_ASSERT(g_process_raid_ch->process.ch_processed == NULL);
+	CU_ASSERT(g_process_raid_ch->base_channel[1] == &g_io_channel);
+
+	ut_process_cleanup(raid_bdev, ch);
+}
+
+static void
+test_process_rate_limit(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_bdev_process *process;
+	struct spdk_io_channel *ch;
+	uint32_t i;
+
+	/* 100 MiB/s allows ~100 KiB per timeslice, a 1 MiB window takes 10 timeslices */
+	raid_bdev = ut_process_start(100, &ch);
+	poll_threads();
+	process = raid_bdev->process;
+	SPDK_CU_ASSERT_FATAL(process != NULL);
+	SPDK_CU_ASSERT_FATAL(process->qos.poller != NULL);
+	CU_ASSERT(process->qos.bytes_per_timeslice == 100 * 1024 * 1024 / 1000);
+
+	/* The first window starts right away */
+	CU_ASSERT(g_quiesce_range_count == 1);
+	ut_process_complete_request(0);
+	CU_ASSERT(g_process_raid_ch->process.offset == PROCESS_WINDOW_BLOCKS);
+
+	/* The next one waits until the bandwidth used by the first one is paid back */
+	CU_ASSERT(process->qos.waiting);
+	CU_ASSERT(g_quiesce_range_count == 1);
+	CU_ASSERT(g_process_req == NULL);
+
+	for (i = 0; i < 9; i++) {
+		spdk_delay_us(RAID_BDEV_PROCESS_QOS_TIMESLICE_US);
+		poll_threads();
+		CU_ASSERT(g_quiesce_range_count == 1);
+	}
+
+	spdk_delay_us(RAID_BDEV_PROCESS_QOS_TIMESLICE_US);
+	poll_threads();
+	CU_ASSERT(!process->qos.waiting);
+	CU_ASSERT(g_quiesce_range_count == 2);
+	CU_ASSERT(g_quiesced_offset == PROCESS_WINDOW_BLOCKS);
+	SPDK_CU_ASSERT_FATAL(g_process_req != NULL);
+	CU_ASSERT(g_process_req->offset_blocks == PROCESS_WINDOW_BLOCKS);
+
+	/* Stopping a process waiting for bandwidth doesn't wait for the poller */
+	ut_process_complete_request(0);
+	CU_ASSERT(process->qos.waiting);
+	g_remove_cb_called = false;
+	CU_ASSERT(raid_bdev_remove_base_bdev(spdk_bdev_get_by_name("Nvme2n1"),
+					     ut_process_remove_cb, NULL) == 0);
+	poll_threads();
+	CU_ASSERT(g_remove_cb_called);
+	CU_ASSERT(raid_bdev->process == NULL);
+	CU_ASSERT(g_quiesce_range_count == 2);
+
+	ut_process_cleanup(raid_bdev, ch);
+}
+
+static void
+test_process_base_bdev_removed(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_bdev_process *process;
+	struct raid_base_bdev_info *target;
+	struct spdk_io_channel *ch;
+	int rc;
+
+	raid_bdev = ut_process_start(0, &ch);
+	g_process_req_max_blocks = 100;
+	poll_threads();
+	process = raid_bdev->process;
+	SPDK_CU_ASSERT_FATAL(process != NULL);
+	target = &raid_bdev->base_bdev_info[1];
+
+	ut_process_complete_request(0);
+	ut_process_complete_request(0);
+	ut_process_complete_request(0);
+	CU_ASSERT(g_process_raid_ch->process.offset == PROCESS_WINDOW_BLOCKS);
+
+	/* Remove the target while the second window is being processed */
+	SPDK_CU_ASSERT_FATAL(g_process_req != NULL);
+	CU_ASSERT(g_quiesced_offset == PROCESS_WINDOW_BLOCKS);
+	g_remove_cb_called = false;
+	rc = raid_bdev_remove_base_bdev(spdk_bdev_get_by_name("Nvme2n1"), ut_process_remove_cb,
+					NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(process->state == RAID_PROCESS_STATE_STOPPING);
+	CU_ASSERT(!g_remove_cb_called);
+	CU_ASSERT(g_quiesced_length == PROCESS_WINDOW_BLOCKS);
+
+	/* The window being processed is completed first, then the process aborts */
+	ut_process_complete_request(0);
+	ut_process_complete_request(0);
+	SPDK_CU_ASSERT_FATAL(g_process_req != NULL);
+	CU_ASSERT(g_process_req->offset_blocks == PROCESS_WINDOW_BLOCKS + 200);
+	CU_ASSERT(!g_remove_cb_called);
+	ut_process_complete_request(0);
+	CU_ASSERT(g_process_req == NULL);
+	CU_ASSERT(g_quiesced_length == 0);
+	CU_ASSERT(g_quiesce_range_count == 2);
+	CU_ASSERT(g_remove_cb_called);
+	CU_ASSERT(g_remove_cb_status == 0);
+	CU_ASSERT(raid_bdev->process == NULL);
+	CU_ASSERT(target->desc == NULL);
+	CU_ASSERT(target->name == NULL);
+	CU_ASSERT(!target->is_process_target);
+	CU_ASSERT(raid_bdev->num_base_bdevs_discovered == 1);
+	CU_ASSERT(raid_bdev->state == RAID_BDEV_STATE_ONLINE);
+	CU_ASSERT(g_process_raid_ch->process.offset == RAID_OFFSET_BLOCKS_INVALID);
+	CU_ASSERT(g_process_raid_ch->process.ch_processed == NULL);
+	CU_ASSERT(g_process_raid_ch->base_channel[1] == NULL);
+
+	/* A failed process request aborts the rebuild as well */
+	rc = raid_bdev_add_base_bdev(raid_bdev, "Nvme2n1");
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	SPDK_CU_ASSERT_FATAL(raid_bdev->process != NULL);
+	ut_process_complete_request(-EIO);
+	CU_ASSERT(g_process_req == NULL);
+	CU_ASSERT(g_quiesced_length == 0);
+	CU_ASSERT(raid_bdev->process == NULL);
+	CU_ASSERT(target->desc == NULL);
+	CU_ASSERT(raid_bdev->num_base_bdevs_discovered == 1);
+
+	ut_process_cleanup(raid_bdev, ch);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1988,6 +2556,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_reset_io);
 	CU_ADD_TEST(suite, test_write_io);
 	CU_ADD_TEST(suite, test_read_io);
+	CU_ADD_TEST(suite, test_multi_strip_io);
 	CU_ADD_TEST(suite, test_unmap_io);
 	CU_ADD_TEST(suite, test_io_failure);
 	CU_ADD_TEST(suite, test_multi_raid_no_io);
@@ -1996,6 +2565,10 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid_json_dump_info);
 	CU_ADD_TEST(suite, test_context_size);
 	CU_ADD_TEST(suite, test_raid_level_conversions);
+	CU_ADD_TEST(suite, test_raid_read_policy_conversions);
+	CU_ADD_TEST(suite, test_process_window_advance);
+	CU_ADD_TEST(suite, test_process_rate_limit);
+	CU_ADD_TEST(suite, test_process_base_bdev_removed);
 
 	allocate_threads(1);
 	set_thread(0);
@@ -45,6 +45,9 @@ struct req_records {
 	uint64_t offset_blocks[MAX_RECORDS];
 	uint64_t num_blocks[MAX_RECORDS];
 	enum CONCAT_IO_TYPE io_type[MAX_RECORDS];
+	/* Start and length of the payload, for requests with one */
+	void *iov_base[MAX_RECORDS];
+	uint64_t iov_len[MAX_RECORDS];
 	int count;
 	void *md;
 } g_req_records;
@@ -69,6 +72,21 @@ DEFINE_STUB(raid_bdev_io_complete_part, bool,
 	     enum spdk_bdev_io_status status),
 	    true);
 
+static void
+record_iovs(int i, struct iovec *iov, int iovcnt)
+{
+	int j;
+
+	g_req_records.iov_base[i] = iov[0].iov_base;
+	g_req_records.iov_len[i] = 0;
+	for (j = 0; j < iovcnt; j++) {
+		/* The payload of each request must be contiguous in these tests */
+		CU_ASSERT((uint8_t *)iov[j].iov_base == (uint8_t *)iov[0].iov_base +
+			  g_req_records.iov_len[i]);
+		g_req_records.iov_len[i] += iov[j].iov_len;
+	}
+}
+
 int
 spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 			   struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
@@ -80,6 +98,7 @@ spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *
 		g_req_records.offset_blocks[i] = offset_blocks;
 		g_req_records.num_blocks[i] = num_blocks;
 		g_req_records.io_type[i] = CONCAT_READV;
+		record_iovs(i, iov, iovcnt);
 		g_req_records.count++;
 		cb(NULL, true, cb_arg);
 		g_req_records.md = opts->metadata;
@@ -100,6 +119,7 @@ spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel
 		g_req_records.offset_blocks[i] = offset_blocks;
 		g_req_records.num_blocks[i] = num_blocks;
 		g_req_records.io_type[i] = CONCAT_WRITEV;
+		record_iovs(i, iov, iovcnt);
 		g_req_records.count++;
 		cb(NULL, true, cb_arg);
 		g_req_records.md = opts->metadata;
@@ -382,6 +402,80 @@ test_concat_rw(void)
 	}
 }
 
+static void
+submit_and_verify_rw_multi_disk(enum CONCAT_IO_TYPE io_type, struct raid_params *params)
+{
+	struct raid_bdev *raid_bdev;
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_io_channel *ch;
+	struct raid_bdev_io *raid_io;
+	struct raid_bdev_io_channel *raid_ch;
+	uint64_t lba, blocks;
+	uint8_t *buf;
+
+	/* Start on the last block of the first bdev and end on the last block of the second one */
+	lba = params->base_bdev_blockcnt - 1;
+	blocks = params->base_bdev_blockcnt + 1;
+
+	init_globals();
+	raid_bdev = create_concat(params);
+	bdev_io = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	raid_io = (struct raid_bdev_io *)bdev_io->driver_ctx;
+	raid_ch = calloc(1, sizeof(struct raid_bdev_io_channel));
+	SPDK_CU_ASSERT_FATAL(raid_ch != NULL);
+	raid_ch->base_channel = calloc(params->num_base_bdevs,
+				       sizeof(struct spdk_io_channel));
+	SPDK_CU_ASSERT_FATAL(raid_ch->base_channel != NULL);
+	raid_io->raid_ch = raid_ch;
+	raid_io->raid_bdev = raid_bdev;
+	ch = calloc(1, sizeof(struct spdk_io_channel));
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	bdev_io_initialize(bdev_io, ch, &raid_bdev->bdev, lba, blocks, io_type == CONCAT_WRITEV ?
+			   SPDK_BDEV_IO_TYPE_WRITE : SPDK_BDEV_IO_TYPE_READ);
+	buf = bdev_io->u.bdev.iovs->iov_base;
+	concat_submit_rw_request(raid_io);
+
+	/* One request per base bdev, each with its own part of the payload */
+	CU_ASSERT(g_req_records.count == 2);
+	CU_ASSERT(g_req_records.offset_blocks[0] == params->base_bdev_blockcnt - 1);
+	CU_ASSERT(g_req_records.num_blocks[0] == 1);
+	CU_ASSERT(g_req_records.io_type[0] == io_type);
+	CU_ASSERT(g_req_records.iov_base[0] == buf);
+	CU_ASSERT(g_req_records.iov_len[0] == raid_bdev->bdev.blocklen);
+	CU_ASSERT(g_req_records.offset_blocks[1] == 0);
+	CU_ASSERT(g_req_records.num_blocks[1] == params->base_bdev_blockcnt);
+	CU_ASSERT(g_req_records.io_type[1] == io_type);
+	CU_ASSERT(g_req_records.iov_base[1] == buf + raid_bdev->bdev.blocklen);
+	CU_ASSERT(g_req_records.iov_len[1] ==
+		  params->base_bdev_blockcnt * raid_bdev->bdev.blocklen);
+	CU_ASSERT(g_req_records.md == (uint8_t *)0xAEDFEBAC + raid_bdev->bdev.md_len);
+
+	/* raid_bdev_io_complete_part() is stubbed, so the payload is never released */
+	free(raid_io->module_private);
+	bdev_io_cleanup(bdev_io);
+	free(ch);
+	free(raid_ch->base_channel);
+	free(raid_ch);
+	delete_concat(raid_bdev);
+}
+
+static void
+test_concat_rw_multi_disk(void)
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		/* The payload spans a whole base bdev */
+		if (params->base_bdev_blockcnt > 1024) {
+			continue;
+		}
+		submit_and_verify_rw_multi_disk(CONCAT_WRITEV, params);
+		submit_and_verify_rw_multi_disk(CONCAT_READV, params);
+	}
+}
+
 static void
 submit_and_verify_null_payload(enum CONCAT_IO_TYPE io_type, struct raid_params *params)
 {
@@ -492,6 +586,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("concat", test_setup, test_cleanup);
 	CU_ADD_TEST(suite, test_concat_start);
 	CU_ADD_TEST(suite, test_concat_rw);
+	CU_ADD_TEST(suite, test_concat_rw_multi_disk);
 	CU_ADD_TEST(suite, test_concat_null_payload);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
@@ -8,10 +8,13 @@
 #include "spdk/env.h"
 #include "spdk_internal/mock.h"
 
+#include "common/lib/ut_multithread.c"
+
 #include "bdev/raid/raid1.c"
 #include "../common.c"
 
 DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
+DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
 DEFINE_STUB_V(raid_bdev_io_complete, (struct raid_bdev_io *raid_io,
 				      enum spdk_bdev_io_status status));
 DEFINE_STUB(raid_bdev_io_complete_part, bool, (struct raid_bdev_io *raid_io, uint64_t completed,
@@ -19,6 +22,8 @@ DEFINE_STUB(raid_bdev_io_complete_part, bool, (struct raid_bdev_io *raid_io, uin
 DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
 DEFINE_STUB_V(raid_bdev_queue_io_wait, (struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
 					struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn));
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
 DEFINE_STUB(spdk_bdev_readv_blocks_with_md, int, (struct spdk_bdev_desc *desc,
 		struct spdk_io_channel *ch,
 		struct iovec *iov, int iovcnt, void *md,
@@ -29,14 +34,89 @@ DEFINE_STUB(spdk_bdev_writev_blocks_with_md, int, (struct spdk_bdev_desc *desc,
 		struct iovec *iov, int iovcnt, void *md,
 		uint64_t offset_blocks, uint64_t num_blocks,
 		spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
-DEFINE_STUB(spdk_bdev_readv_blocks_ext, int, (struct spdk_bdev_desc *desc,
-		struct spdk_io_channel *ch,
-		struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
-		spdk_bdev_io_completion_cb cb, void *cb_arg, struct spdk_bdev_ext_io_opts *opts), 0);
-DEFINE_STUB(spdk_bdev_writev_blocks_ext, int, (struct spdk_bdev_desc *desc,
-		struct spdk_io_channel *ch,
-		struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
-		spdk_bdev_io_completion_cb cb, void *cb_arg, struct spdk_bdev_ext_io_opts *opts), 0);
+
+struct raid1_test_write {
+	struct spdk_bdev_desc *desc;
+	uint64_t offset_blocks;
+	uint64_t num_blocks;
+	spdk_bdev_io_completion_cb cb;
+	void *cb_arg;
+};
+
+static struct raid1_test_write g_write;
+
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			    spdk_bdev_io_completion_cb cb, void *cb_arg,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	g_write.desc = desc;
+	g_write.offset_blocks = offset_blocks;
+	g_write.num_blocks = num_blocks;
+	g_write.cb = cb;
+	g_write.cb_arg = cb_arg;
+
+	return 0;
+}
+
+static int g_process_req_status;
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	g_process_req_status = status;
+}
+
+struct raid1_test_read {
+	struct spdk_bdev_desc *desc;
+	spdk_bdev_io_completion_cb cb;
+	void *cb_arg;
+	TAILQ_ENTRY(raid1_test_read) link;
+};
+
+static TAILQ_HEAD(raid1_test_reads, raid1_test_read) g_reads = TAILQ_HEAD_INITIALIZER(g_reads);
+
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			   spdk_bdev_io_completion_cb cb, void *cb_arg,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	struct raid1_test_read *read;
+
+	read = calloc(1, sizeof(*read));
+	SPDK_CU_ASSERT_FATAL(read != NULL);
+	read->desc = desc;
+	read->cb = cb;
+	read->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&g_reads, read, link);
+
+	return 0;
+}
+
+static void
+complete_read(struct raid1_test_read *read)
+{
+	TAILQ_REMOVE(&g_reads, read, link);
+	read->cb(NULL, true, read->cb_arg);
+	free(read);
+}
+
+static uint8_t
+read_base_bdev_idx(struct raid_bdev *raid_bdev, struct raid1_test_read *read)
+{
+	uint8_t i;
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (raid_bdev->base_bdev_info[i].desc == read->desc) {
+			return i;
+		}
+	}
+
+	CU_FAIL_FATAL("read submitted to unknown base bdev");
+	return UINT8_MAX;
+}
 
 static int
 test_setup(void)
@@ -98,6 +178,7 @@ delete_raid1(struct raid1_info *r1_info)
 	struct raid_bdev *raid_bdev = r1_info->raid_bdev;
 
 	raid1_stop(raid_bdev);
+	poll_threads();
 
 	raid_test_delete_raid_bdev(raid_bdev);
 }
@@ -122,6 +203,245 @@ test_raid1_start(void)
 	}
 }
 
+struct raid1_test_ctx {
+	struct raid1_info *r1_info;
+	struct raid_bdev_io_channel raid_ch;
+	struct spdk_bdev_io *bdev_io[32];
+};
+
+static void
+raid1_test_ctx_init(struct raid1_test_ctx *ctx, struct raid_params *params,
+		    enum raid_bdev_read_policy read_policy)
+{
+	uint8_t i;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->r1_info = create_raid1(params);
+	ctx->r1_info->raid_bdev->read_policy = read_policy;
+
+	ctx->raid_ch.num_channels = params->num_base_bdevs;
+	ctx->raid_ch.base_channel = calloc(params->num_base_bdevs, sizeof(struct spdk_io_channel *));
+	SPDK_CU_ASSERT_FATAL(ctx->raid_ch.base_channel != NULL);
+	for (i = 0; i < params->num_base_bdevs; i++) {
+		ctx->raid_ch.base_channel[i] = (void *)1;
+	}
+	ctx->raid_ch.module_channel = raid1_get_io_channel(ctx->r1_info->raid_bdev);
+	SPDK_CU_ASSERT_FATAL(ctx->raid_ch.module_channel != NULL);
+
+	for (i = 0; i < SPDK_COUNTOF(ctx->bdev_io); i++) {
+		ctx->bdev_io[i] = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+		SPDK_CU_ASSERT_FATAL(ctx->bdev_io[i] != NULL);
+	}
+}
+
+static void
+raid1_test_ctx_fini(struct raid1_test_ctx *ctx)
+{
+	uint8_t i;
+
+	CU_ASSERT(TAILQ_EMPTY(&g_reads));
+
+	for (i = 0; i < SPDK_COUNTOF(ctx->bdev_io); i++) {
+		free(ctx->bdev_io[i]);
+	}
+	spdk_put_io_channel(ctx->raid_ch.module_channel);
+	poll_threads();
+	free(ctx->raid_ch.base_channel);
+	delete_raid1(ctx->r1_info);
+}
+
+static uint8_t
+raid1_test_submit_read(struct raid1_test_ctx *ctx, uint8_t io_idx, uint64_t offset_blocks)
+{
+	struct spdk_bdev_io *bdev_io = ctx->bdev_io[io_idx];
+	struct raid_bdev_io *raid_io = (struct raid_bdev_io *)bdev_io->driver_ctx;
+	struct raid1_test_read *read;
+
+	bdev_io->type = SPDK_BDEV_IO_TYPE_READ;
+	bdev_io->u.bdev.offset_blocks = offset_blocks;
+	bdev_io->u.bdev.num_blocks = 1;
+
+	raid_io->raid_bdev = ctx->r1_info->raid_bdev;
+	raid_io->raid_ch = &ctx->raid_ch;
+	raid_io->base_bdev_io_remaining = 0;
+	raid_io->base_bdev_io_submitted = 0;
+	raid_io->base_bdev_io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	raid1_submit_rw_request(raid_io);
+
+	read = TAILQ_LAST(&g_reads, raid1_test_reads);
+	SPDK_CU_ASSERT_FATAL(read != NULL);
+	CU_ASSERT(read->cb_arg == raid_io);
+
+	return read_base_bdev_idx(ctx->r1_info->raid_bdev, read);
+}
+
+static void
+raid1_test_complete_reads(void)
+{
+	while (!TAILQ_EMPTY(&g_reads)) {
+		complete_read(TAILQ_FIRST(&g_reads));
+	}
+}
+
+static void
+test_raid1_read_round_robin(void)
+{
+	struct raid_params *params;
+	struct raid1_test_ctx ctx;
+	uint8_t i, idx;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		raid1_test_ctx_init(&ctx, params, RAID_BDEV_READ_POLICY_ROUND_ROBIN);
+
+		/* Consecutive reads are spread over all base bdevs */
+		for (i = 0; i < params->num_base_bdevs * 2; i++) {
+			idx = raid1_test_submit_read(&ctx, i, 0);
+			CU_ASSERT(idx == i % params->num_base_bdevs);
+		}
+		raid1_test_complete_reads();
+
+		/* A missing base bdev is skipped */
+		ctx.raid_ch.base_channel[0] = NULL;
+		for (i = 0; i < params->num_base_bdevs * 2; i++) {
+			idx = raid1_test_submit_read(&ctx, i, 0);
+			CU_ASSERT(idx != 0);
+		}
+		raid1_test_complete_reads();
+
+		raid1_test_ctx_fini(&ctx);
+	}
+}
+
+static void
+test_raid1_read_least_outstanding(void)
+{
+	struct raid_params *params;
+	struct raid1_test_ctx ctx;
+	struct raid1_io_channel *r1ch;
+	struct raid1_test_read *read, *tmp;
+	uint8_t i, idx, busy_idx;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		raid1_test_ctx_init(&ctx, params, RAID_BDEV_READ_POLICY_LEAST_OUTSTANDING);
+		r1ch = spdk_io_channel_get_ctx(ctx.raid_ch.module_channel);
+
+		/* Load one base bdev with outstanding reads */
+		busy_idx = raid1_test_submit_read(&ctx, 0, 0);
+		for (i = 1; i < params->num_base_bdevs; i++) {
+			idx = raid1_test_submit_read(&ctx, i, 0);
+			CU_ASSERT(idx != busy_idx);
+		}
+		/* Complete all reads except the ones on the busy base bdev */
+		TAILQ_FOREACH_SAFE(read, &g_reads, link, tmp) {
+			if (read_base_bdev_idx(ctx.r1_info->raid_bdev, read) != busy_idx) {
+				complete_read(read);
+			}
+		}
+		CU_ASSERT(r1ch->read_outstanding[busy_idx] == 1);
+
+		/* New reads must avoid the busy base bdev */
+		for (i = 0; i < params->num_base_bdevs - 1; i++) {
+			idx = raid1_test_submit_read(&ctx, params->num_base_bdevs + i, 0);
+			CU_ASSERT(idx != busy_idx);
+		}
+
+		raid1_test_complete_reads();
+		for (i = 0; i < params->num_base_bdevs; i++) {
+			CU_ASSERT(r1ch->read_outstanding[i] == 0);
+		}
+
+		raid1_test_ctx_fini(&ctx);
+	}
+}
+
+static void
+test_raid1_read_lba_shard(void)
+{
+	struct raid_params *params;
+	struct raid1_test_ctx ctx;
+	uint64_t shard_blocks;
+	uint8_t i, idx;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		raid1_test_ctx_init(&ctx, params, RAID_BDEV_READ_POLICY_LBA_SHARD);
+		shard_blocks = 1ULL << ctx.r1_info->read_shard_shift;
+		CU_ASSERT(shard_blocks * params->base_bdev_blocklen == RAID1_READ_SHARD_SIZE_KB * 1024);
+
+		/* Reads within a shard always go to the same base bdev */
+		for (i = 0; i < params->num_base_bdevs * 2; i++) {
+			idx = raid1_test_submit_read(&ctx, i, i * shard_blocks + i % shard_blocks);
+			CU_ASSERT(idx == i % params->num_base_bdevs);
+			idx = raid1_test_submit_read(&ctx, params->num_base_bdevs * 2 + i,
+						     i * shard_blocks + shard_blocks - 1);
+			CU_ASSERT(idx == i % params->num_base_bdevs);
+		}
+		raid1_test_complete_reads();
+
+		/* Shards of a missing base bdev are served by the next one */
+		ctx.raid_ch.base_channel[0] = NULL;
+		idx = raid1_test_submit_read(&ctx, 0, 0);
+		CU_ASSERT(idx == 1);
+		raid1_test_complete_reads();
+
+		raid1_test_ctx_fini(&ctx);
+	}
+}
+
+static void
+test_raid1_process_request(void)
+{
+	struct raid_params *params;
+	struct raid1_test_ctx ctx;
+	struct raid_bdev_process_request process_req;
+	struct raid_base_bdev_info *target;
+	struct raid1_test_read *read;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		raid1_test_ctx_init(&ctx, params, RAID_BDEV_READ_POLICY_ROUND_ROBIN);
+		target = &ctx.r1_info->raid_bdev->base_bdev_info[0];
+
+		/* The target is not part of the process' raid channel */
+		ctx.raid_ch.base_channel[0] = NULL;
+
+		memset(&process_req, 0, sizeof(process_req));
+		process_req.raid_ch = &ctx.raid_ch;
+		process_req.target = target;
+		process_req.target_ch = (void *)1;
+		process_req.offset_blocks = 0;
+		process_req.num_blocks = params->base_bdev_blockcnt;
+		memset(&g_write, 0, sizeof(g_write));
+		g_process_req_status = 1;
+
+		/* The range is read from an in-sync base bdev and written to the target */
+		CU_ASSERT(raid1_submit_process_request(&process_req) == 0);
+		read = TAILQ_FIRST(&g_reads);
+		SPDK_CU_ASSERT_FATAL(read != NULL);
+		CU_ASSERT(read_base_bdev_idx(ctx.r1_info->raid_bdev, read) != 0);
+		CU_ASSERT(read->cb_arg == &process_req);
+		complete_read(read);
+
+		CU_ASSERT(g_write.desc == target->desc);
+		CU_ASSERT(g_write.offset_blocks == 0);
+		CU_ASSERT(g_write.num_blocks == params->base_bdev_blockcnt);
+		SPDK_CU_ASSERT_FATAL(g_write.cb != NULL);
+		CU_ASSERT(g_process_req_status == 1);
+		g_write.cb(NULL, true, g_write.cb_arg);
+		CU_ASSERT(g_process_req_status == 0);
+
+		/* A read error fails the request */
+		CU_ASSERT(raid1_submit_process_request(&process_req) == 0);
+		read = TAILQ_FIRST(&g_reads);
+		SPDK_CU_ASSERT_FATAL(read != NULL);
+		TAILQ_REMOVE(&g_reads, read, link);
+		read->cb(NULL, false, read->cb_arg);
+		free(read);
+		CU_ASSERT(g_process_req_status == -EIO);
+
+		raid1_test_ctx_fini(&ctx);
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -132,8 +452,18 @@ main(int argc, char **argv)
 
 	suite = CU_add_suite("raid1", test_setup, test_cleanup);
 	CU_ADD_TEST(suite, test_raid1_start);
+	CU_ADD_TEST(suite, test_raid1_read_round_robin);
+	CU_ADD_TEST(suite, test_raid1_read_least_outstanding);
+	CU_ADD_TEST(suite, test_raid1_read_lba_shard);
+	CU_ADD_TEST(suite, test_raid1_process_request);
+
+	allocate_threads(1);
+	set_thread(0);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
+
+	free_threads();
+
 	return num_failures;
 }
@@ -0,0 +1,419 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+#include "spdk_internal/mock.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/raid/raid10.c"
+#include "../common.c"
+
+DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
+DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
+DEFINE_STUB_V(raid_bdev_io_complete, (struct raid_bdev_io *raid_io,
+				      enum spdk_bdev_io_status status));
+DEFINE_STUB(raid_bdev_io_complete_part, bool, (struct raid_bdev_io *raid_io, uint64_t completed,
+		enum spdk_bdev_io_status status), true);
+DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
+DEFINE_STUB_V(raid_bdev_queue_io_wait, (struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
+					struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn));
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+DEFINE_STUB_V(raid_bdev_process_request_complete, (struct raid_bdev_process_request *process_req,
+		int status));
+DEFINE_STUB(spdk_bdev_notify_blockcnt_change, int, (struct spdk_bdev *bdev, uint64_t size), 0);
+
+struct raid10_test_io {
+	enum spdk_bdev_io_type type;
+	struct spdk_bdev_desc *desc;
+	uint64_t offset_blocks;
+	uint64_t num_blocks;
+	spdk_bdev_io_completion_cb cb;
+	void *cb_arg;
+	TAILQ_ENTRY(raid10_test_io) link;
+};
+
+static TAILQ_HEAD(raid10_test_ios, raid10_test_io) g_ios = TAILQ_HEAD_INITIALIZER(g_ios);
+
+static int
+record_io(enum spdk_bdev_io_type type, struct spdk_bdev_desc *desc, uint64_t offset_blocks,
+	  uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct raid10_test_io *io;
+
+	io = calloc(1, sizeof(*io));
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	io->type = type;
+	io->desc = desc;
+	io->offset_blocks = offset_blocks;
+	io->num_blocks = num_blocks;
+	io->cb = cb;
+	io->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&g_ios, io, link);
+
+	return 0;
+}
+
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			   spdk_bdev_io_completion_cb cb, void *cb_arg,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	return record_io(SPDK_BDEV_IO_TYPE_READ, desc, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			    spdk_bdev_io_completion_cb cb, void *cb_arg,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	return record_io(SPDK_BDEV_IO_TYPE_WRITE, desc, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_unmap_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return record_io(SPDK_BDEV_IO_TYPE_UNMAP, desc, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_flush_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return record_io(SPDK_BDEV_IO_TYPE_FLUSH, desc, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+static uint8_t
+io_base_bdev_idx(struct raid_bdev *raid_bdev, struct raid10_test_io *io)
+{
+	uint8_t i;
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (raid_bdev->base_bdev_info[i].desc == io->desc) {
+			return i;
+		}
+	}
+
+	CU_FAIL_FATAL("io submitted to unknown base bdev");
+	return UINT8_MAX;
+}
+
+static void
+complete_ios(void)
+{
+	struct raid10_test_io *io;
+
+	while ((io = TAILQ_FIRST(&g_ios))) {
+		TAILQ_REMOVE(&g_ios, io, link);
+		io->cb(NULL, true, io->cb_arg);
+		free(io);
+	}
+}
+
+static int
+test_setup(void)
+{
+	uint8_t num_base_bdevs_values[] = { 4, 6, 8 };
+	uint64_t base_bdev_blockcnt_values[] = { 1024, 1024 * 1024 };
+	uint32_t base_bdev_blocklen_values[] = { 512, 4096 };
+	uint32_t strip_size_kb_values[] = { 4, 128 };
+	uint8_t *num_base_bdevs;
+	uint64_t *base_bdev_blockcnt;
+	uint32_t *base_bdev_blocklen;
+	uint32_t *strip_size_kb;
+	struct raid_params params;
+	uint64_t params_count;
+	int rc;
+
+	params_count = SPDK_COUNTOF(num_base_bdevs_values) *
+		       SPDK_COUNTOF(base_bdev_blockcnt_values) *
+		       SPDK_COUNTOF(base_bdev_blocklen_values) *
+		       SPDK_COUNTOF(strip_size_kb_values);
+	rc = raid_test_params_alloc(params_count);
+	if (rc) {
+		return rc;
+	}
+
+	ARRAY_FOR_EACH(num_base_bdevs_values, num_base_bdevs) {
+		ARRAY_FOR_EACH(base_bdev_blockcnt_values, base_bdev_blockcnt) {
+			ARRAY_FOR_EACH(base_bdev_blocklen_values, base_bdev_blocklen) {
+				ARRAY_FOR_EACH(strip_size_kb_values, strip_size_kb) {
+					params.num_base_bdevs = *num_base_bdevs;
+					params.base_bdev_blockcnt = *base_bdev_blockcnt;
+					params.base_bdev_blocklen = *base_bdev_blocklen;
+					params.strip_size = *strip_size_kb * 1024 / *base_bdev_blocklen;
+					params.md_len = 0;
+					if (params.strip_size == 0 ||
+					    params.strip_size > *base_bdev_blockcnt) {
+						continue;
+					}
+					raid_test_params_add(&params);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_cleanup(void)
+{
+	raid_test_params_free();
+	return 0;
+}
+
+static struct raid10_info *
+create_raid10(struct raid_params *params)
+{
+	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, &g_raid10_module);
+
+	SPDK_CU_ASSERT_FATAL(raid10_start(raid_bdev) == 0);
+
+	return raid_bdev->module_private;
+}
+
+static void
+delete_raid10(struct raid10_info *r10info)
+{
+	struct raid_bdev *raid_bdev = r10info->raid_bdev;
+
+	raid10_stop(raid_bdev);
+	poll_threads();
+
+	raid_test_delete_raid_bdev(raid_bdev);
+}
+
+static void
+test_raid10_start(void)
+{
+	struct raid_params *params, odd_params;
+	struct raid_bdev *raid_bdev;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid10_info *r10info;
+
+		r10info = create_raid10(params);
+
+		SPDK_CU_ASSERT_FATAL(r10info != NULL);
+
+		CU_ASSERT_EQUAL(r10info->num_legs, params->num_base_bdevs / 2);
+		CU_ASSERT_EQUAL(r10info->raid_bdev->bdev.blockcnt,
+				(params->base_bdev_blockcnt - params->base_bdev_blockcnt % params->strip_size) *
+				(params->num_base_bdevs / 2));
+		CU_ASSERT_EQUAL(r10info->raid_bdev->bdev.optimal_io_boundary, params->strip_size);
+		CU_ASSERT_TRUE(r10info->raid_bdev->bdev.split_on_optimal_io_boundary);
+
+		delete_raid10(r10info);
+	}
+
+	/* An odd number of base bdevs can't be paired into mirrors */
+	odd_params = g_params[0];
+	odd_params.num_base_bdevs = 5;
+	raid_bdev = raid_test_create_raid_bdev(&odd_params, &g_raid10_module);
+	CU_ASSERT(raid10_start(raid_bdev) == -EINVAL);
+	raid_test_delete_raid_bdev(raid_bdev);
+}
+
+struct raid10_test_ctx {
+	struct raid10_info *r10info;
+	struct raid_bdev_io_channel raid_ch;
+	struct spdk_bdev_io *bdev_io;
+};
+
+static void
+raid10_test_ctx_init(struct raid10_test_ctx *ctx, struct raid_params *params,
+		     enum raid_bdev_read_policy read_policy)
+{
+	uint8_t i;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->r10info = create_raid10(params);
+	ctx->r10info->raid_bdev->read_policy = read_policy;
+
+	ctx->raid_ch.num_channels = params->num_base_bdevs;
+	ctx->raid_ch.base_channel = calloc(params->num_base_bdevs, sizeof(struct spdk_io_channel *));
+	SPDK_CU_ASSERT_FATAL(ctx->raid_ch.base_channel != NULL);
+	for (i = 0; i < params->num_base_bdevs; i++) {
+		ctx->raid_ch.base_channel[i] = (void *)1;
+	}
+	ctx->raid_ch.module_channel = raid10_get_io_channel(ctx->r10info->raid_bdev);
+	SPDK_CU_ASSERT_FATAL(ctx->raid_ch.module_channel != NULL);
+
+	ctx->bdev_io = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(ctx->bdev_io != NULL);
+}
+
+static void
+raid10_test_ctx_fini(struct raid10_test_ctx *ctx)
+{
+	CU_ASSERT(TAILQ_EMPTY(&g_ios));
+
+	free(ctx->bdev_io);
+	spdk_put_io_channel(ctx->raid_ch.module_channel);
+	poll_threads();
+	free(ctx->raid_ch.base_channel);
+	delete_raid10(ctx->r10info);
+}
+
+static void
+raid10_test_submit(struct raid10_test_ctx *ctx, enum spdk_bdev_io_type type,
+		   uint64_t offset_blocks, uint64_t num_blocks)
+{
+	struct spdk_bdev_io *bdev_io = ctx->bdev_io;
+	struct raid_bdev_io *raid_io = (struct raid_bdev_io *)bdev_io->driver_ctx;
+
+	bdev_io->type = type;
+	bdev_io->u.bdev.offset_blocks = offset_blocks;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+
+	raid_io->raid_bdev = ctx->r10info->raid_bdev;
+	raid_io->raid_ch = &ctx->raid_ch;
+	raid_io->base_bdev_io_remaining = 0;
+	raid_io->base_bdev_io_submitted = 0;
+	raid_io->base_bdev_io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	if (type == SPDK_BDEV_IO_TYPE_READ || type == SPDK_BDEV_IO_TYPE_WRITE) {
+		raid10_submit_rw_request(raid_io);
+	} else {
+		raid10_submit_null_payload_request(raid_io);
+	}
+}
+
+static void
+test_raid10_submit_rw_request(void)
+{
+	struct raid_params *params;
+	struct raid10_test_ctx ctx;
+	struct raid10_test_io *io;
+	uint64_t strip, num_legs;
+	uint8_t idx, prev_idx;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		raid10_test_ctx_init(&ctx, params, RAID_BDEV_READ_POLICY_ROUND_ROBIN);
+		num_legs = ctx.r10info->num_legs;
+
+		for (strip = 0; strip < num_legs * 2; strip++) {
+			uint64_t offset_in_strip = params->strip_size > 1 ? 1 : 0;
+			uint64_t offset = strip * params->strip_size + offset_in_strip;
+			uint64_t pd_lba = (strip / num_legs) * params->strip_size + offset_in_strip;
+
+			/* A write goes to both mirrors of the leg */
+			raid10_test_submit(&ctx, SPDK_BDEV_IO_TYPE_WRITE, offset, 1);
+			io = TAILQ_FIRST(&g_ios);
+			SPDK_CU_ASSERT_FATAL(io != NULL);
+			CU_ASSERT(io_base_bdev_idx(ctx.r10info->raid_bdev, io) == (strip % num_legs) * 2);
+			CU_ASSERT(io->offset_blocks == pd_lba);
+			io = TAILQ_NEXT(io, link);
+			SPDK_CU_ASSERT_FATAL(io != NULL);
+			CU_ASSERT(io_base_bdev_idx(ctx.r10info->raid_bdev, io) == (strip % num_legs) * 2 + 1);
+			CU_ASSERT(io->offset_blocks == pd_lba);
+			CU_ASSERT(TAILQ_NEXT(io, link) == NULL);
+			complete_ios();
+
+			/* Consecutive reads alternate between the mirrors of the leg */
+			raid10_test_submit(&ctx, SPDK_BDEV_IO_TYPE_READ, offset, 1);
+			io = TAILQ_FIRST(&g_ios);
+			SPDK_CU_ASSERT_FATAL(io != NULL);
+			prev_idx = io_base_bdev_idx(ctx.r10info->raid_bdev, io);
+			CU_ASSERT(prev_idx / 2 == strip % num_legs);
+			CU_ASSERT(io->offset_blocks == pd_lba);
+			complete_ios();
+
+			raid10_test_submit(&ctx, SPDK_BDEV_IO_TYPE_READ, offset, 1);
+			io = TAILQ_FIRST(&g_ios);
+			SPDK_CU_ASSERT_FATAL(io != NULL);
+			idx = io_base_bdev_idx(ctx.r10info->raid_bdev, io);
+			CU_ASSERT(idx == (prev_idx ^ 1));
+			complete_ios();
+		}
+
+		/* Reads are served by the remaining mirror when one is missing */
+		ctx.raid_ch.base_channel[0] = NULL;
+		raid10_test_submit(&ctx, SPDK_BDEV_IO_TYPE_READ, 0, 1);
+		io = TAILQ_FIRST(&g_ios);
+		SPDK_CU_ASSERT_FATAL(io != NULL);
+		CU_ASSERT(io_base_bdev_idx(ctx.r10info->raid_bdev, io) == 1);
+		complete_ios();
+
+		raid10_test_submit(&ctx, SPDK_BDEV_IO_TYPE_WRITE, 0, 1);
+		io = TAILQ_FIRST(&g_ios);
+		SPDK_CU_ASSERT_FATAL(io != NULL);
+		CU_ASSERT(io_base_bdev_idx(ctx.r10info->raid_bdev, io) == 1);
+		CU_ASSERT(TAILQ_NEXT(io, link) == NULL);
+		complete_ios();
+
+		raid10_test_ctx_fini(&ctx);
+	}
+}
+
+static void
+test_raid10_submit_null_payload_request(void)
+{
+	struct raid_params *params;
+	struct raid10_test_ctx ctx;
+	struct raid10_test_io *io;
+	uint64_t blocks_per_base_bdev[UINT8_MAX] = {};
+	uint64_t num_legs, num_blocks;
+	uint8_t i;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		raid10_test_ctx_init(&ctx, params, RAID_BDEV_READ_POLICY_ROUND_ROBIN);
+		num_legs = ctx.r10info->num_legs;
+
+		/* Unmap spanning all legs, starting and ending in the middle of a strip */
+		num_blocks = num_legs * params->strip_size * 2;
+		raid10_test_submit(&ctx, SPDK_BDEV_IO_TYPE_UNMAP, 1, num_blocks);
+
+		memset(blocks_per_base_bdev, 0, sizeof(blocks_per_base_bdev));
+		TAILQ_FOREACH(io, &g_ios, link) {
+			CU_ASSERT(io->type == SPDK_BDEV_IO_TYPE_UNMAP);
+			blocks_per_base_bdev[io_base_bdev_idx(ctx.r10info->raid_bdev, io)] += io->num_blocks;
+		}
+
+		num_blocks = 0;
+		for (i = 0; i < params->num_base_bdevs; i += 2) {
+			/* Both mirrors receive the same range */
+			CU_ASSERT(blocks_per_base_bdev[i] == blocks_per_base_bdev[i + 1]);
+			num_blocks += blocks_per_base_bdev[i];
+		}
+		CU_ASSERT(num_blocks == num_legs * params->strip_size * 2);
+		complete_ios();
+
+		raid10_test_ctx_fini(&ctx);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("raid10", test_setup, test_cleanup);
+	CU_ADD_TEST(suite, test_raid10_start);
+	CU_ADD_TEST(suite, test_raid10_submit_rw_request);
+	CU_ADD_TEST(suite, test_raid10_submit_null_payload_request);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
@@ -15,12 +15,31 @@
 
 static void *g_accel_p = (void *)0xdeadbeaf;
 static bool g_test_degraded;
+static uint32_t g_stripe_cache_size;
+static struct raid_bdev_module *g_test_module = &g_raid5f_module;
 
 DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
 DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
 DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
 DEFINE_STUB(accel_channel_create, int, (void *io_device, void *ctx_buf), 0);
 DEFINE_STUB_V(accel_channel_destroy, (void *io_device, void *ctx_buf));
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+DEFINE_STUB_V(raid_bdev_process_request_complete, (struct raid_bdev_process_request *process_req,
+		int status));
+
+void
+raid_bdev_get_opts(struct raid_bdev_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->stripe_cache_size = g_stripe_cache_size;
+}
+
+struct spdk_thread *
+spdk_bdev_io_get_thread(struct spdk_bdev_io *bdev_io)
+{
+	return spdk_get_thread();
+}
 
 struct spdk_io_channel *
 spdk_accel_get_io_channel(void)
@@ -179,12 +198,14 @@ static void
 test_setup(void)
 {
 	g_test_degraded = false;
+	g_stripe_cache_size = 0;
+	g_test_module = &g_raid5f_module;
 }
 
 static struct raid5f_info *
 create_raid5f(struct raid_params *params)
 {
-	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, &g_raid5f_module);
+	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, g_test_module);
 
 	SPDK_CU_ASSERT_FATAL(raid5f_start(raid_bdev) == 0);
 
@@ -208,16 +229,22 @@ test_raid5f_start(void)
 
 	RAID_PARAMS_FOR_EACH(params) {
 		struct raid5f_info *r5f_info;
+		uint8_t data_chunks;
+
+		if (params->num_base_bdevs < g_test_module->base_bdevs_min) {
+			continue;
+		}
 
 		r5f_info = create_raid5f(params);
 
 		SPDK_CU_ASSERT_FATAL(r5f_info != NULL);
 
-		CU_ASSERT_EQUAL(r5f_info->stripe_blocks, params->strip_size * (params->num_base_bdevs - 1));
+		data_chunks = params->num_base_bdevs - g_test_module->base_bdevs_constraint.value;
+		CU_ASSERT_EQUAL(r5f_info->stripe_blocks, params->strip_size * data_chunks);
 		CU_ASSERT_EQUAL(r5f_info->total_stripes, params->base_bdev_blockcnt / params->strip_size);
 		CU_ASSERT_EQUAL(r5f_info->raid_bdev->bdev.blockcnt,
 				(params->base_bdev_blockcnt - params->base_bdev_blockcnt % params->strip_size) *
-				(params->num_base_bdevs - 1));
+				data_chunks);
 		CU_ASSERT_EQUAL(r5f_info->raid_bdev->bdev.optimal_io_boundary, params->strip_size);
 		CU_ASSERT_TRUE(r5f_info->raid_bdev->bdev.split_on_optimal_io_boundary);
 		CU_ASSERT_EQUAL(r5f_info->raid_bdev->bdev.write_unit_size, r5f_info->stripe_blocks);
@@ -253,6 +280,10 @@ struct raid_io_info {
 	void *parity_md_buf;
 	void *reference_md_parity;
 	size_t parity_md_buf_size;
+	void *q_buf;
+	void *reference_q;
+	void *q_md_buf;
+	void *reference_md_q;
 	void *degraded_buf;
 	void *degraded_md_buf;
 	enum spdk_bdev_io_status status;
@@ -440,6 +471,28 @@ process_io_completions(struct raid_io_info *io_info)
 
 #define DATA_OFFSET_TO_MD_OFFSET(raid_bdev, data_offset) ((data_offset >> raid_bdev->blocklen_shift) * raid_bdev->bdev.md_len)
 
+/* Returns the index of a chunk among the data chunks of a stripe or -1 for parity chunks */
+static int
+test_chunk_data_idx(struct raid_bdev *raid_bdev, uint64_t stripe_index, uint8_t chunk_idx)
+{
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid5f_is_raid6f(raid_bdev) ? raid5f_stripe_q_chunk_index(raid_bdev,
+			stripe_index) : p_idx;
+	int data_idx = chunk_idx;
+
+	if (chunk_idx == p_idx || chunk_idx == q_idx) {
+		return -1;
+	}
+	if (chunk_idx > p_idx) {
+		data_idx--;
+	}
+	if (q_idx != p_idx && chunk_idx > q_idx) {
+		data_idx--;
+	}
+
+	return data_idx;
+}
+
 int
 spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				struct iovec *iov, int iovcnt, void *md_buf,
@@ -471,8 +524,16 @@ spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chan
 		if (md_buf != NULL) {
 			dest_md_buf = io_info->parity_md_buf;
 		}
+	} else if (chunk == stripe_req->q_chunk) {
+		if (io_info->q_buf == NULL) {
+			goto submit;
+		}
+		dest.iov_base = io_info->q_buf;
+		if (md_buf != NULL) {
+			dest_md_buf = io_info->q_md_buf;
+		}
 	} else {
-		data_chunk_idx = chunk < stripe_req->parity_chunk ? chunk->index : chunk->index - 1;
+		data_chunk_idx = test_chunk_data_idx(raid_bdev, stripe_req->stripe_index, chunk->index);
 		data_offset = data_chunk_idx * raid_bdev->strip_size * raid_bdev->bdev.blocklen;
 		dest.iov_base = test_raid_bdev_io->buf + data_offset;
 		if (md_buf != NULL) {
@@ -516,8 +577,11 @@ spdk_bdev_readv_blocks_degraded(struct spdk_bdev_desc *desc, struct spdk_io_chan
 	if (chunk == stripe_req->parity_chunk) {
 		buf = io_info->reference_parity;
 		buf_md = io_info->reference_md_parity;
+	} else if (chunk == stripe_req->q_chunk) {
+		buf = io_info->reference_q;
+		buf_md = io_info->reference_md_q;
 	} else {
-		data_chunk_idx = chunk < stripe_req->parity_chunk ? chunk->index : chunk->index - 1;
+		data_chunk_idx = test_chunk_data_idx(raid_bdev, stripe_req->stripe_index, chunk->index);
 		buf = io_info->degraded_buf +
 		      data_chunk_idx * raid_bdev->strip_size * raid_bdev->bdev.blocklen;
 		buf_md = io_info->degraded_md_buf +
@@ -640,41 +704,49 @@ test_raid5f_write_request(struct raid_io_info *io_info)
 
 	if (g_test_degraded) {
 		struct raid_bdev *raid_bdev = io_info->r5f_info->raid_bdev;
-		uint8_t p_idx;
 		uint8_t i;
+		int data_idx;
 		off_t offset;
 		uint32_t strip_len;
+		bool parity_missing = false;
 
 		for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
-			if (io_info->raid_ch->base_channel[i] == NULL) {
-				break;
+			if (io_info->raid_ch->base_channel[i] != NULL) {
+				continue;
 			}
-		}
 
-		SPDK_CU_ASSERT_FATAL(i != raid_bdev->num_base_bdevs);
-
-		p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, io_info->stripe_index);
+			data_idx = test_chunk_data_idx(raid_bdev, io_info->stripe_index, i);
+			if (data_idx < 0) {
+				parity_missing = true;
+				continue;
+			}
 
-		if (i == p_idx) {
-			return;
-		}
+			/* The missing chunk was not written, fill in the expected data */
+			strip_len = raid_bdev->strip_size_kb * 1024;
+			offset = data_idx * strip_len;
 
-		if (i >= p_idx) {
-			i--;
+			memcpy(io_info->dest_buf + offset, io_info->src_buf + offset, strip_len);
+			if (io_info->dest_md_buf) {
+				strip_len = raid_bdev->strip_size * raid_bdev->bdev.md_len;
+				offset = data_idx * strip_len;
+				memcpy(io_info->dest_md_buf + offset, io_info->src_md_buf + offset, strip_len);
+			}
 		}
 
-		strip_len = raid_bdev->strip_size_kb * 1024;
-		offset = i * strip_len;
-
-		memcpy(io_info->dest_buf + offset, io_info->src_buf + offset, strip_len);
-		if (io_info->dest_md_buf) {
-			strip_len = raid_bdev->strip_size * raid_bdev->bdev.md_len;
-			offset = i * strip_len;
-			memcpy(io_info->dest_md_buf + offset, io_info->src_md_buf + offset, strip_len);
+		if (parity_missing) {
+			return;
 		}
 	}
 
 	if (io_info->status == SPDK_BDEV_IO_STATUS_SUCCESS) {
+		if (io_info->q_buf) {
+			CU_ASSERT(memcmp(io_info->q_buf, io_info->reference_q,
+					 io_info->parity_buf_size) == 0);
+		}
+		if (io_info->q_md_buf) {
+			CU_ASSERT(memcmp(io_info->q_md_buf, io_info->reference_md_q,
+					 io_info->parity_md_buf_size) == 0);
+		}
 		if (io_info->parity_buf) {
 			CU_ASSERT(memcmp(io_info->parity_buf, io_info->reference_parity,
 					 io_info->parity_buf_size) == 0);
@@ -716,6 +788,10 @@ deinit_io_info(struct raid_io_info *io_info)
 	free(io_info->reference_parity);
 	free(io_info->parity_md_buf);
 	free(io_info->reference_md_parity);
+	free(io_info->q_buf);
+	free(io_info->reference_q);
+	free(io_info->q_md_buf);
+	free(io_info->reference_md_q);
 	free(io_info->degraded_buf);
 	free(io_info->degraded_md_buf);
 }
@@ -789,6 +865,48 @@ init_io_info(struct raid_io_info *io_info, struct raid5f_info *r5f_info,
 	TAILQ_INIT(&io_info->bdev_io_wait_queue);
 }
 
+static void
+io_info_setup_q(struct raid_io_info *io_info, void *src, void *src_md)
+{
+	struct raid_bdev *raid_bdev = io_info->r5f_info->raid_bdev;
+	uint8_t n = raid5f_stripe_data_chunks_num(raid_bdev);
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = raid_bdev->strip_size * raid_bdev->bdev.md_len;
+	void *sources[n];
+	void *p;
+	unsigned i;
+
+	p = malloc(strip_len);
+	SPDK_CU_ASSERT_FATAL(p != NULL);
+
+	io_info->q_buf = calloc(1, strip_len);
+	SPDK_CU_ASSERT_FATAL(io_info->q_buf != NULL);
+
+	io_info->reference_q = calloc(1, strip_len);
+	SPDK_CU_ASSERT_FATAL(io_info->reference_q != NULL);
+
+	for (i = 0; i < n; i++) {
+		sources[i] = src + i * strip_len;
+	}
+	SPDK_CU_ASSERT_FATAL(spdk_xor_gen_pq(p, io_info->reference_q, sources, n, strip_len) == 0);
+
+	if (src_md) {
+		io_info->q_md_buf = calloc(1, strip_md_len);
+		SPDK_CU_ASSERT_FATAL(io_info->q_md_buf != NULL);
+
+		io_info->reference_md_q = calloc(1, strip_md_len);
+		SPDK_CU_ASSERT_FATAL(io_info->reference_md_q != NULL);
+
+		for (i = 0; i < n; i++) {
+			sources[i] = src_md + i * strip_md_len;
+		}
+		SPDK_CU_ASSERT_FATAL(spdk_xor_gen_pq(p, io_info->reference_md_q, sources, n,
+						     strip_md_len) == 0);
+	}
+
+	free(p);
+}
+
 static void
 io_info_setup_parity(struct raid_io_info *io_info, void *src, void *src_md)
 {
@@ -798,6 +916,10 @@ io_info_setup_parity(struct raid_io_info *io_info, void *src, void *src_md)
 	size_t strip_len = raid_bdev->strip_size * blocklen;
 	unsigned i;
 
+	if (raid5f_is_raid6f(raid_bdev)) {
+		io_info_setup_q(io_info, src, src_md);
+	}
+
 	io_info->parity_buf_size = strip_len;
 	io_info->parity_buf = calloc(1, io_info->parity_buf_size);
 	SPDK_CU_ASSERT_FATAL(io_info->parity_buf != NULL);
@@ -910,6 +1032,10 @@ run_for_each_raid5f_config(void (*test_fn)(struct raid_bdev *raid_bdev,
 		struct raid_bdev_io_channel raid_ch = { 0 };
 		int i;
 
+		if (params->num_base_bdevs < g_test_module->base_bdevs_min) {
+			continue;
+		}
+
 		r5f_info = create_raid5f(params);
 
 		raid_ch.num_channels = params->num_base_bdevs;
@@ -917,7 +1043,8 @@ run_for_each_raid5f_config(void (*test_fn)(struct raid_bdev *raid_bdev,
 		SPDK_CU_ASSERT_FATAL(raid_ch.base_channel != NULL);
 
 		for (i = 0; i < params->num_base_bdevs; i++) {
-			if (g_test_degraded && i == 0) {
+			/* Remove as many base bdevs as the raid level can tolerate */
+			if (g_test_degraded && i < g_test_module->base_bdevs_constraint.value) {
 				continue;
 			}
 			raid_ch.base_channel[i] = (void *)1;
@@ -1069,6 +1196,80 @@ test_raid5f_submit_full_stripe_write_request(void)
 	run_for_each_raid5f_config(__test_raid5f_submit_full_stripe_write_request);
 }
 
+static void
+__test_raid5f_submit_write_request_stripe_cache(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint32_t strip_size = raid_bdev->strip_size;
+	size_t strip_len = strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = strip_size * raid_bdev->bdev.md_len;
+	uint8_t data_chunks = raid5f_stripe_data_chunks_num(raid_bdev);
+	struct raid_io_info io_info;
+	struct raid_bdev_io *raid_io;
+	struct spdk_bdev_io *bdev_io;
+	uint64_t stripe_index;
+	uint8_t i;
+
+	CU_ASSERT(raid5f_stripe_cache_enabled(r5f_info));
+	CU_ASSERT_FALSE(raid_bdev->bdev.split_on_write_unit);
+
+	RAID5F_TEST_FOR_EACH_STRIPE(raid_bdev, stripe_index) {
+		init_io_info(&io_info, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE,
+			     stripe_index, 0, r5f_info->stripe_blocks);
+		io_info_setup_parity(&io_info, io_info.src_buf, io_info.src_md_buf);
+
+		/* Write the stripe one strip at a time, the writes are held until it fills up */
+		for (i = 0; i < data_chunks; i++) {
+			raid_io = get_raid_io(&io_info);
+			bdev_io = spdk_bdev_io_from_ctx(raid_io);
+			bdev_io->u.bdev.offset_blocks += i * strip_size;
+			bdev_io->u.bdev.num_blocks = strip_size;
+			bdev_io->u.bdev.iovcnt = 1;
+			bdev_io->u.bdev.iovs[0].iov_base = io_info.src_buf + i * strip_len;
+			bdev_io->u.bdev.iovs[0].iov_len = strip_len;
+			if (io_info.src_md_buf != NULL) {
+				bdev_io->u.bdev.md_buf = io_info.src_md_buf + i * strip_md_len;
+			}
+
+			raid5f_submit_rw_request(raid_io);
+			poll_threads();
+
+			if (i < data_chunks - 1) {
+				CU_ASSERT(TAILQ_EMPTY(&io_info.bdev_io_queue));
+				CU_ASSERT(io_info.status == SPDK_BDEV_IO_STATUS_PENDING);
+			}
+		}
+
+		process_io_completions(&io_info);
+		poll_threads();
+
+		CU_ASSERT(io_info.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+		CU_ASSERT(memcmp(io_info.src_buf, io_info.dest_buf, io_info.buf_size) == 0);
+		if (io_info.buf_md_size) {
+			CU_ASSERT(memcmp(io_info.src_md_buf, io_info.dest_md_buf, io_info.buf_md_size) == 0);
+		}
+		CU_ASSERT(memcmp(io_info.parity_buf, io_info.reference_parity,
+				 io_info.parity_buf_size) == 0);
+		if (io_info.parity_md_buf) {
+			CU_ASSERT(memcmp(io_info.parity_md_buf, io_info.reference_md_parity,
+					 io_info.parity_md_buf_size) == 0);
+		}
+		if (io_info.q_buf) {
+			CU_ASSERT(memcmp(io_info.q_buf, io_info.reference_q, io_info.parity_buf_size) == 0);
+		}
+		CU_ASSERT(TAILQ_EMPTY(&r5f_info->cache.in_use));
+
+		deinit_io_info(&io_info);
+	}
+}
+static void
+test_raid5f_submit_write_request_stripe_cache(void)
+{
+	g_stripe_cache_size = 1;
+	run_for_each_raid5f_config(__test_raid5f_submit_write_request_stripe_cache);
+}
+
 static void
 __test_raid5f_chunk_write_error(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
 {
@@ -1180,6 +1381,43 @@ test_raid5f_submit_read_request_degraded(void)
 	run_for_each_raid5f_config(__test_raid5f_submit_read_request);
 }
 
+static void
+test_raid6f_start(void)
+{
+	g_test_module = &g_raid6f_module;
+	test_raid5f_start();
+}
+
+static void
+test_raid6f_submit_read_request(void)
+{
+	g_test_module = &g_raid6f_module;
+	run_for_each_raid5f_config(__test_raid5f_submit_read_request);
+}
+
+static void
+test_raid6f_submit_full_stripe_write_request(void)
+{
+	g_test_module = &g_raid6f_module;
+	run_for_each_raid5f_config(__test_raid5f_submit_full_stripe_write_request);
+}
+
+static void
+test_raid6f_submit_full_stripe_write_request_degraded(void)
+{
+	g_test_degraded = true;
+	g_test_module = &g_raid6f_module;
+	run_for_each_raid5f_config(__test_raid5f_submit_full_stripe_write_request);
+}
+
+static void
+test_raid6f_submit_read_request_degraded(void)
+{
+	g_test_degraded = true;
+	g_test_module = &g_raid6f_module;
+	run_for_each_raid5f_config(__test_raid5f_submit_read_request);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1194,10 +1432,16 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid5f_submit_read_request);
 	CU_ADD_TEST(suite, test_raid5f_stripe_request_map_iovecs);
 	CU_ADD_TEST(suite, test_raid5f_submit_full_stripe_write_request);
+	CU_ADD_TEST(suite, test_raid5f_submit_write_request_stripe_cache);
 	CU_ADD_TEST(suite, test_raid5f_chunk_write_error);
 	CU_ADD_TEST(suite, test_raid5f_chunk_write_error_with_enomem);
 	CU_ADD_TEST(suite, test_raid5f_submit_full_stripe_write_request_degraded);
 	CU_ADD_TEST(suite, test_raid5f_submit_read_request_degraded);
+	CU_ADD_TEST(suite, test_raid6f_start);
+	CU_ADD_TEST(suite, test_raid6f_submit_read_request);
+	CU_ADD_TEST(suite, test_raid6f_submit_full_stripe_write_request);
+	CU_ADD_TEST(suite, test_raid6f_submit_full_stripe_write_request_degraded);
+	CU_ADD_TEST(suite, test_raid6f_submit_read_request_degraded);
 
 	allocate_threads(1);
 	set_thread(0);
@@ -0,0 +1,687 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "common/lib/ut_multithread.c"
+#include "spdk_internal/mock.h"
+#include "unit/lib/json_mock.c"
+
+#include "bdev/cache/vbdev_cache.c"
+
+#define BLOCK_SIZE	512
+#define BLOCK_CNT	8192
+/* A single shard of 64 lines of 32 blocks */
+#define CACHE_SIZE_MB	1
+#define LINE_SIZE_KB	16
+#define LINE_BLOCKS	(LINE_SIZE_KB * 1024 / BLOCK_SIZE)
+#define NUM_LINES	64
+
+DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
+DEFINE_STUB_V(spdk_bdev_module_examine_done, (struct spdk_bdev_module *module));
+DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
+DEFINE_STUB(spdk_bdev_module_claim_bdev, int, (struct spdk_bdev *bdev,
+		struct spdk_bdev_desc *desc, struct spdk_bdev_module *module), 0);
+DEFINE_STUB_V(spdk_bdev_module_release_bdev, (struct spdk_bdev *bdev));
+DEFINE_STUB(spdk_bdev_io_type_supported, bool, (struct spdk_bdev *bdev,
+		enum spdk_bdev_io_type io_type), true);
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 1);
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+
+/* I/O submitted to the base bdev, completed by ut_complete_base_ios() */
+struct ut_base_io {
+	enum spdk_bdev_io_type		type;
+	void				*buf;
+	struct iovec			*iovs;
+	int				iovcnt;
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+	TAILQ_ENTRY(ut_base_io)		link;
+};
+
+static TAILQ_HEAD(, ut_base_io) g_base_ios = TAILQ_HEAD_INITIALIZER(g_base_ios);
+static uint32_t g_num_base_ios;
+static struct spdk_bdev g_base_bdev;
+static bool g_base_bdev_present;
+static uint8_t g_base_data[BLOCK_CNT * BLOCK_SIZE];
+static struct spdk_bdev *g_registered_bdev;
+static struct vbdev_cache *g_node;
+static struct spdk_io_channel *g_ch;
+
+int
+spdk_bdev_open_ext(const char *bdev_name, bool write, spdk_bdev_event_cb_t event_cb,
+		   void *event_ctx, struct spdk_bdev_desc **desc)
+{
+	if (!g_base_bdev_present || strcmp(bdev_name, g_base_bdev.name) != 0) {
+		return -ENODEV;
+	}
+
+	*desc = (struct spdk_bdev_desc *)&g_base_bdev;
+	return 0;
+}
+
+struct spdk_bdev *
+spdk_bdev_desc_get_bdev(struct spdk_bdev_desc *desc)
+{
+	return (struct spdk_bdev *)desc;
+}
+
+const char *
+spdk_bdev_get_name(const struct spdk_bdev *bdev)
+{
+	return bdev->name;
+}
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	return spdk_get_io_channel(&g_base_bdev);
+}
+
+int
+spdk_bdev_register(struct spdk_bdev *bdev)
+{
+	CU_ASSERT(g_registered_bdev == NULL);
+	g_registered_bdev = bdev;
+
+	return 0;
+}
+
+void
+spdk_bdev_unregister(struct spdk_bdev *bdev, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(bdev == g_registered_bdev);
+	g_registered_bdev = NULL;
+
+	bdev->fn_table->destruct(bdev->ctxt);
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+}
+
+int
+spdk_bdev_unregister_by_name(const char *bdev_name, struct spdk_bdev_module *module,
+			     spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(module == &cache_if);
+
+	if (g_registered_bdev == NULL || strcmp(g_registered_bdev->name, bdev_name) != 0) {
+		return -ENODEV;
+	}
+
+	spdk_bdev_unregister(g_registered_bdev, cb_fn, cb_arg);
+	return 0;
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(bdev_io);
+}
+
+void
+spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
+{
+	bdev_io->internal.status = status;
+}
+
+void
+spdk_bdev_io_get_buf(struct spdk_bdev_io *bdev_io, spdk_bdev_io_get_buf_cb cb, uint64_t len)
+{
+	/* The tests always provide the buffers */
+	cb(g_ch, bdev_io, true);
+}
+
+void
+spdk_bdev_io_set_buf(struct spdk_bdev_io *bdev_io, void *buf, size_t len)
+{
+	bdev_io->u.bdev.iovs[0].iov_base = buf;
+	bdev_io->u.bdev.iovs[0].iov_len = len;
+}
+
+static int
+ut_queue_base_io(enum spdk_bdev_io_type type, void *buf, struct iovec *iovs, int iovcnt,
+		 uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		 void *cb_arg)
+{
+	struct ut_base_io *io;
+
+	CU_ASSERT(offset_blocks + num_blocks <= BLOCK_CNT);
+
+	io = calloc(1, sizeof(*io));
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+	io->type = type;
+	io->buf = buf;
+	io->iovs = iovs;
+	io->iovcnt = iovcnt;
+	io->offset_blocks = offset_blocks;
+	io->num_blocks = num_blocks;
+	io->cb = cb;
+	io->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&g_base_ios, io, link);
+	g_num_base_ios++;
+
+	return 0;
+}
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		      uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		      void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_READ, buf, NULL, 0, offset_blocks, num_blocks,
+				cb, cb_arg);
+}
+
+int
+spdk_bdev_readv_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_READ, NULL, iov, iovcnt, offset_blocks,
+				num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_writev_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_WRITE, NULL, iov, iovcnt, offset_blocks,
+				num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_write_zeroes_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			      uint64_t offset_blocks, uint64_t num_blocks,
+			      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_WRITE_ZEROES, NULL, NULL, 0, offset_blocks,
+				num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_unmap_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_UNMAP, NULL, NULL, 0, offset_blocks,
+				num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_flush_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_FLUSH, NULL, NULL, 0, offset_blocks,
+				num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_reset(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_queue_base_io(SPDK_BDEV_IO_TYPE_RESET, NULL, NULL, 0, 0, 0, cb, cb_arg);
+}
+
+/* Complete the I/O submitted to the base bdev so far, moving the data to and from g_base_data */
+static void
+ut_complete_base_ios(bool success)
+{
+	TAILQ_HEAD(, ut_base_io) ios = TAILQ_HEAD_INITIALIZER(ios);
+	struct spdk_bdev_io *bdev_io;
+	struct ut_base_io *io;
+	uint8_t *data;
+	size_t len;
+	int i;
+
+	TAILQ_SWAP(&ios, &g_base_ios, ut_base_io, link);
+	while ((io = TAILQ_FIRST(&ios)) != NULL) {
+		TAILQ_REMOVE(&ios, io, link);
+
+		data = &g_base_data[io->offset_blocks * BLOCK_SIZE];
+		len = io->num_blocks * BLOCK_SIZE;
+		if (success && io->type == SPDK_BDEV_IO_TYPE_READ) {
+			if (io->buf != NULL) {
+				memcpy(io->buf, data, len);
+			}
+			for (i = 0; i < io->iovcnt; i++) {
+				memcpy(io->iovs[i].iov_base, data, io->iovs[i].iov_len);
+				data += io->iovs[i].iov_len;
+			}
+		} else if (success && io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+			for (i = 0; i < io->iovcnt; i++) {
+				memcpy(data, io->iovs[i].iov_base, io->iovs[i].iov_len);
+				data += io->iovs[i].iov_len;
+			}
+		} else if (success && io->type == SPDK_BDEV_IO_TYPE_WRITE_ZEROES) {
+			memset(data, 0, len);
+		}
+
+		bdev_io = calloc(1, sizeof(*bdev_io));
+		SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+		io->cb(bdev_io, success, io->cb_arg);
+		free(io);
+	}
+
+	poll_threads();
+}
+
+static struct spdk_bdev_io *
+ut_submit_io(enum spdk_bdev_io_type type, uint64_t offset_blocks, uint64_t num_blocks,
+	     void *buf)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	bdev_io = calloc(1, sizeof(*bdev_io) + sizeof(struct cache_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = &g_node->cache_bdev;
+	bdev_io->type = type;
+	bdev_io->u.bdev.offset_blocks = offset_blocks;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+	bdev_io->iov.iov_base = buf;
+	bdev_io->iov.iov_len = num_blocks * BLOCK_SIZE;
+	bdev_io->u.bdev.iovs = &bdev_io->iov;
+	bdev_io->u.bdev.iovcnt = 1;
+	bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
+
+	vbdev_cache_submit_request(g_ch, bdev_io);
+	poll_threads();
+
+	return bdev_io;
+}
+
+/* Read a whole line, filling it from the base bdev if needed */
+static void
+ut_read_line(uint64_t line)
+{
+	struct spdk_bdev_io *bdev_io;
+	uint8_t buf[LINE_BLOCKS * BLOCK_SIZE];
+
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, line * LINE_BLOCKS, LINE_BLOCKS, buf);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, &g_base_data[line * LINE_BLOCKS * BLOCK_SIZE], sizeof(buf)) == 0);
+	free(bdev_io);
+}
+
+static struct cache_entry *
+ut_lookup_line(uint64_t line)
+{
+	return cache_lookup(cache_get_shard(g_node, line), line);
+}
+
+static bool
+ut_line_is_valid(uint64_t line)
+{
+	struct cache_entry *entry = ut_lookup_line(line);
+
+	return entry != NULL && entry->state == CACHE_ENTRY_VALID;
+}
+
+static int
+ut_base_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_base_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static int
+test_setup(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < sizeof(g_base_data); i++) {
+		g_base_data[i] = i / BLOCK_SIZE + i;
+	}
+
+	g_base_bdev.name = "base";
+	g_base_bdev.blocklen = BLOCK_SIZE;
+	g_base_bdev.blockcnt = BLOCK_CNT;
+	g_base_bdev_present = true;
+	spdk_io_device_register(&g_base_bdev, ut_base_ch_create_cb, ut_base_ch_destroy_cb, 0,
+				"base");
+
+	return 0;
+}
+
+static int
+test_cleanup(void)
+{
+	spdk_io_device_unregister(&g_base_bdev, NULL);
+	poll_threads();
+
+	return 0;
+}
+
+static void
+ut_cache_create(void)
+{
+	int rc;
+
+	rc = bdev_cache_create_disk("base", "cache", NULL, CACHE_SIZE_MB, LINE_SIZE_KB);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_registered_bdev != NULL);
+
+	g_node = TAILQ_FIRST(&g_cache_nodes);
+	SPDK_CU_ASSERT_FATAL(g_node != NULL);
+	CU_ASSERT(g_node->num_shards == 1);
+	CU_ASSERT(g_node->num_lines == NUM_LINES);
+	CU_ASSERT(g_node->line_blocks == LINE_BLOCKS);
+
+	g_ch = spdk_get_io_channel(g_node);
+	SPDK_CU_ASSERT_FATAL(g_ch != NULL);
+	g_num_base_ios = 0;
+}
+
+static void
+ut_delete_cb(void *cb_arg, int bdeverrno)
+{
+	*(int *)cb_arg = bdeverrno;
+}
+
+static void
+ut_cache_delete(void)
+{
+	int rc = -1;
+
+	spdk_put_io_channel(g_ch);
+	g_ch = NULL;
+	poll_threads();
+
+	bdev_cache_delete_disk("cache", ut_delete_cb, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_cache_nodes));
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_names));
+	CU_ASSERT(TAILQ_EMPTY(&g_base_ios));
+	g_node = NULL;
+}
+
+static void
+test_read_hit_miss(void)
+{
+	struct spdk_bdev_io *bdev_io;
+	struct cache_shard *shard;
+	uint8_t buf[16 * LINE_BLOCKS * BLOCK_SIZE];
+
+	ut_cache_create();
+	shard = &g_node->shards[0];
+
+	/* A miss fills the whole line from the base bdev */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 4, 8, buf);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(g_num_base_ios == 1);
+	CU_ASSERT(TAILQ_FIRST(&g_base_ios)->offset_blocks == 0);
+	CU_ASSERT(TAILQ_FIRST(&g_base_ios)->num_blocks == LINE_BLOCKS);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, &g_base_data[4 * BLOCK_SIZE], 8 * BLOCK_SIZE) == 0);
+	CU_ASSERT(shard->misses == 1);
+	CU_ASSERT(shard->hits == 0);
+	free(bdev_io);
+
+	/* A hit completes right away, without any I/O to the base bdev */
+	memset(buf, 0, sizeof(buf));
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 16, 16, buf);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_num_base_ios == 1);
+	CU_ASSERT(memcmp(buf, &g_base_data[16 * BLOCK_SIZE], 16 * BLOCK_SIZE) == 0);
+	CU_ASSERT(shard->hits == 1);
+	free(bdev_io);
+
+	/* A read spanning two lines only fills the missing one */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, LINE_BLOCKS - 2, 4, buf);
+	CU_ASSERT(g_num_base_ios == 2);
+	CU_ASSERT(TAILQ_FIRST(&g_base_ios)->offset_blocks == LINE_BLOCKS);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, &g_base_data[(LINE_BLOCKS - 2) * BLOCK_SIZE], 4 * BLOCK_SIZE) == 0);
+	CU_ASSERT(shard->hits == 2);
+	CU_ASSERT(shard->misses == 2);
+	free(bdev_io);
+
+	/* Reads spanning too many lines are passed through, without caching anything */
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 4 * LINE_BLOCKS,
+			       (CACHE_MAX_LINES_PER_IO + 1) * LINE_BLOCKS, buf);
+	CU_ASSERT(g_num_base_ios == 3);
+	CU_ASSERT(TAILQ_FIRST(&g_base_ios)->offset_blocks == 4 * LINE_BLOCKS);
+	CU_ASSERT(TAILQ_FIRST(&g_base_ios)->num_blocks ==
+		  (CACHE_MAX_LINES_PER_IO + 1) * LINE_BLOCKS);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(ut_lookup_line(4) == NULL);
+	CU_ASSERT(shard->hits == 2);
+	CU_ASSERT(shard->misses == 2);
+	free(bdev_io);
+
+	ut_cache_delete();
+}
+
+static void
+test_coalesced_miss(void)
+{
+	struct spdk_bdev_io *bdev_io1, *bdev_io2;
+	uint8_t buf1[LINE_BLOCKS * BLOCK_SIZE], buf2[LINE_BLOCKS * BLOCK_SIZE];
+
+	ut_cache_create();
+
+	/* Concurrent misses on the same line are served by a single read of the base bdev */
+	bdev_io1 = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 3 * LINE_BLOCKS, 4, buf1);
+	bdev_io2 = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 3 * LINE_BLOCKS + 8, 8, buf2);
+	CU_ASSERT(g_num_base_ios == 1);
+	CU_ASSERT(ut_lookup_line(3)->state == CACHE_ENTRY_FILLING);
+	CU_ASSERT(ut_lookup_line(3)->refs == 2);
+	CU_ASSERT(bdev_io1->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(bdev_io2->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io1->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bdev_io2->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf1, &g_base_data[3 * LINE_BLOCKS * BLOCK_SIZE], 4 * BLOCK_SIZE) == 0);
+	CU_ASSERT(memcmp(buf2, &g_base_data[(3 * LINE_BLOCKS + 8) * BLOCK_SIZE],
+			 8 * BLOCK_SIZE) == 0);
+	CU_ASSERT(ut_line_is_valid(3));
+	CU_ASSERT(ut_lookup_line(3)->refs == 0);
+	free(bdev_io1);
+	free(bdev_io2);
+
+	/* If the fill fails, the waiting readers read their data from the base bdev */
+	bdev_io1 = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 5 * LINE_BLOCKS, 4, buf1);
+	bdev_io2 = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 5 * LINE_BLOCKS + 4, 4, buf2);
+	CU_ASSERT(g_num_base_ios == 2);
+	ut_complete_base_ios(false);
+	CU_ASSERT(ut_lookup_line(5) == NULL);
+	CU_ASSERT(g_num_base_ios == 4);
+	CU_ASSERT(bdev_io1->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	CU_ASSERT(bdev_io2->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io1->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bdev_io2->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf1, &g_base_data[5 * LINE_BLOCKS * BLOCK_SIZE], 4 * BLOCK_SIZE) == 0);
+	CU_ASSERT(memcmp(buf2, &g_base_data[(5 * LINE_BLOCKS + 4) * BLOCK_SIZE],
+			 4 * BLOCK_SIZE) == 0);
+	free(bdev_io1);
+	free(bdev_io2);
+
+	ut_cache_delete();
+}
+
+static void
+test_eviction_order(void)
+{
+	struct cache_shard *shard;
+	uint64_t line;
+
+	ut_cache_create();
+	shard = &g_node->shards[0];
+
+	/* Fill the cache, then read line 1 again to make it frequently used */
+	for (line = 0; line < NUM_LINES; line++) {
+		ut_read_line(line);
+	}
+	ut_read_line(1);
+	CU_ASSERT(shard->sizes[CACHE_LIST_T1] == NUM_LINES - 1);
+	CU_ASSERT(shard->sizes[CACHE_LIST_T2] == 1);
+	CU_ASSERT(shard->num_free_bufs == 0);
+	CU_ASSERT(shard->evictions == 0);
+
+	/* A new line evicts the least recently used line accessed once */
+	ut_read_line(NUM_LINES);
+	CU_ASSERT(shard->evictions == 1);
+	CU_ASSERT(ut_lookup_line(0)->state == CACHE_ENTRY_GHOST);
+	CU_ASSERT(ut_lookup_line(0)->list == CACHE_LIST_B1);
+	CU_ASSERT(ut_line_is_valid(1));
+	CU_ASSERT(ut_line_is_valid(2));
+	CU_ASSERT(ut_line_is_valid(NUM_LINES));
+
+	/* A scan doesn't evict the frequently used line */
+	for (line = NUM_LINES + 1; line < 2 * NUM_LINES; line++) {
+		ut_read_line(line);
+	}
+	CU_ASSERT(shard->evictions == NUM_LINES);
+	CU_ASSERT(ut_line_is_valid(1));
+	for (line = 2; line < NUM_LINES; line++) {
+		CU_ASSERT(!ut_line_is_valid(line));
+	}
+
+	/* A line evicted recently comes back as frequently used, growing the target of T1 */
+	CU_ASSERT(shard->target == 0);
+	CU_ASSERT(ut_lookup_line(NUM_LINES)->list == CACHE_LIST_B1);
+	ut_read_line(NUM_LINES);
+	CU_ASSERT(ut_line_is_valid(NUM_LINES));
+	CU_ASSERT(ut_lookup_line(NUM_LINES)->list == CACHE_LIST_T2);
+	CU_ASSERT(shard->target == 1);
+	CU_ASSERT(ut_lookup_line(NUM_LINES + 1)->state == CACHE_ENTRY_GHOST);
+	CU_ASSERT(ut_line_is_valid(1));
+
+	ut_cache_delete();
+}
+
+static void
+test_write_invalidation(void)
+{
+	struct spdk_bdev_io *bdev_io, *read_io;
+	uint8_t buf[LINE_BLOCKS * BLOCK_SIZE], wbuf[2 * BLOCK_SIZE];
+
+	ut_cache_create();
+
+	/* A write invalidates the lines it overlaps as soon as it's submitted */
+	ut_read_line(0);
+	CU_ASSERT(ut_line_is_valid(0));
+	memset(wbuf, 0xa5, sizeof(wbuf));
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_WRITE, 4, 2, wbuf);
+	CU_ASSERT(ut_lookup_line(0) == NULL);
+	CU_ASSERT(g_node->shards[0].invalidations == 1);
+	ut_complete_base_ios(true);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	free(bdev_io);
+
+	/* The next read gets the new data from the base bdev */
+	ut_read_line(0);
+	CU_ASSERT(g_num_base_ios == 3);
+	CU_ASSERT(memcmp(&g_base_data[4 * BLOCK_SIZE], wbuf, sizeof(wbuf)) == 0);
+
+	/* A line written while it's being filled isn't kept, as it may hold the old data */
+	read_io = ut_submit_io(SPDK_BDEV_IO_TYPE_READ, 2 * LINE_BLOCKS, LINE_BLOCKS, buf);
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_WRITE, 2 * LINE_BLOCKS, 2, wbuf);
+	CU_ASSERT(ut_lookup_line(2) == NULL);
+	ut_complete_base_ios(true);
+	CU_ASSERT(read_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(ut_lookup_line(2) == NULL);
+	free(read_io);
+	free(bdev_io);
+
+	/* Write zeroes and unmaps invalidate the lines as well */
+	ut_read_line(2);
+	ut_read_line(3);
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_WRITE_ZEROES, 2 * LINE_BLOCKS, 1, NULL);
+	CU_ASSERT(ut_lookup_line(2) == NULL);
+	CU_ASSERT(ut_line_is_valid(3));
+	ut_complete_base_ios(true);
+	free(bdev_io);
+	bdev_io = ut_submit_io(SPDK_BDEV_IO_TYPE_UNMAP, 3 * LINE_BLOCKS, LINE_BLOCKS, NULL);
+	CU_ASSERT(ut_lookup_line(3) == NULL);
+	ut_complete_base_ios(true);
+	free(bdev_io);
+
+	ut_read_line(2);
+	CU_ASSERT(spdk_mem_all_zero(&g_base_data[2 * LINE_BLOCKS * BLOCK_SIZE], BLOCK_SIZE));
+
+	ut_cache_delete();
+}
+
+static void
+test_base_bdev_hotremove(void)
+{
+	int rc;
+
+	ut_cache_create();
+	ut_read_line(0);
+
+	spdk_put_io_channel(g_ch);
+	g_ch = NULL;
+	poll_threads();
+
+	/* Removing the base bdev unregisters the cache bdev */
+	g_base_bdev_present = false;
+	vbdev_cache_base_bdev_event_cb(SPDK_BDEV_EVENT_REMOVE, &g_base_bdev, NULL);
+	poll_threads();
+	CU_ASSERT(g_registered_bdev == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&g_cache_nodes));
+
+	/* The cache bdev is created again once the base bdev comes back */
+	CU_ASSERT(!TAILQ_EMPTY(&g_bdev_names));
+	g_base_bdev_present = true;
+	vbdev_cache_examine(&g_base_bdev);
+	CU_ASSERT(g_registered_bdev != NULL);
+	g_node = TAILQ_FIRST(&g_cache_nodes);
+	SPDK_CU_ASSERT_FATAL(g_node != NULL);
+	CU_ASSERT(ut_lookup_line(0) == NULL);
+
+	g_ch = spdk_get_io_channel(g_node);
+	ut_cache_delete();
+
+	/* Deleting a cache bdev that doesn't exist fails */
+	rc = 0;
+	bdev_cache_delete_disk("cache", ut_delete_cb, &rc);
+	CU_ASSERT(rc == -ENODEV);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("cache", test_setup, test_cleanup);
+	CU_ADD_TEST(suite, test_read_hit_miss);
+	CU_ADD_TEST(suite, test_coalesced_miss);
+	CU_ADD_TEST(suite, test_eviction_order);
+	CU_ADD_TEST(suite, test_write_invalidation);
+	CU_ADD_TEST(suite, test_base_bdev_hotremove);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	free_threads();
+
+	CU_cleanup_registry();
+	return num_failures;
+}
@@ -46,11 +46,24 @@ DEFINE_STUB(spdk_blob_get_esnap_id, int,
 DEFINE_STUB(spdk_blob_is_esnap_clone, bool, (const struct spdk_blob *blob), false);
 DEFINE_STUB(spdk_lvol_iter_immediate_clones, int,
 	    (struct spdk_lvol *lvol, spdk_lvol_iter_cb cb_fn, void *cb_arg), -ENOTSUP);
+DEFINE_STUB_V(spdk_lvol_decouple_clones,
+	      (struct spdk_lvol *snapshot, spdk_lvol_op_complete cb_fn, void *cb_arg));
+DEFINE_STUB_V(spdk_lvol_shallow_copy,
+	      (struct spdk_lvol *lvol, struct spdk_lvol *base, struct spdk_bs_dev *ext_dev,
+	       uint32_t queue_depth, spdk_lvol_op_complete cb_fn, void *cb_arg));
 DEFINE_STUB(spdk_lvs_esnap_missing_add, int,
 	    (struct spdk_lvol_store *lvs, struct spdk_lvol *lvol, const void *esnap_id,
 	     uint32_t id_len), -ENOTSUP);
 DEFINE_STUB(spdk_blob_get_esnap_bs_dev, struct spdk_bs_dev *, (const struct spdk_blob *blob), NULL);
 DEFINE_STUB(spdk_lvol_is_degraded, bool, (const struct spdk_lvol *lvol), false);
+DEFINE_STUB(spdk_blob_io_get_dev_lba, int,
+	    (struct spdk_blob *blob, struct spdk_io_channel *channel, uint64_t io_unit,
+	     uint64_t length, struct spdk_io_channel **dev_channel, uint64_t *lba), -ENOENT);
+DEFINE_STUB(spdk_bs_bdev_get_desc, struct spdk_bdev_desc *, (struct spdk_bs_dev *bs_dev),
+	    (struct spdk_bdev_desc *)0x1);
+DEFINE_STUB(spdk_bdev_io_forward_blocks, int,
+	    (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
+	     uint64_t offset_blocks), 0);
 
 struct spdk_blob {
 	uint64_t	id;
@@ -177,6 +190,14 @@ spdk_bdev_create_bs_dev(const char *bdev_name, bool write,
 	return 0;
 }
 
+int
+spdk_bs_esnap_cache_dev_create(struct spdk_bs_dev *back_dev, const void *esnap_id,
+			       uint32_t id_len, struct spdk_bs_dev **dev)
+{
+	*dev = back_dev;
+	return 0;
+}
+
 void
 spdk_lvs_grow(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg)
 {
@@ -1699,6 +1720,52 @@ ut_vbdev_lvol_submit_request(void)
 	free(g_base_bdev);
 }
 
+static void
+ut_vbdev_lvol_forward_io(void)
+{
+	struct spdk_lvol_store lvs = {};
+	struct spdk_lvol lvol = { .lvol_store = &lvs };
+
+	g_io = calloc(1, sizeof(struct spdk_bdev_io) + vbdev_lvs_get_ctx_size());
+	SPDK_CU_ASSERT_FATAL(g_io != NULL);
+	g_base_bdev = calloc(1, sizeof(struct spdk_bdev));
+	SPDK_CU_ASSERT_FATAL(g_base_bdev != NULL);
+	g_io->bdev = g_base_bdev;
+	g_base_bdev->ctxt = &lvol;
+	g_io->u.bdev.offset_blocks = 20;
+	g_io->u.bdev.num_blocks = 20;
+
+	/* Writes within an allocated cluster are forwarded to the lvol store's bdev */
+	MOCK_SET(spdk_blob_io_get_dev_lba, 0);
+	g_blob_is_read_only = false;
+	g_ext_api_called = false;
+	g_io->type = SPDK_BDEV_IO_TYPE_WRITE;
+	vbdev_lvol_submit_request(g_ch, g_io);
+	CU_ASSERT(g_ext_api_called == false);
+
+	/* Unless the lvol is read-only */
+	g_blob_is_read_only = true;
+	vbdev_lvol_submit_request(g_ch, g_io);
+	CU_ASSERT(g_ext_api_called == true);
+	g_blob_is_read_only = false;
+
+	/* Or the I/O can't be forwarded at the moment */
+	MOCK_SET(spdk_bdev_io_forward_blocks, -EAGAIN);
+	g_ext_api_called = false;
+	vbdev_lvol_submit_request(g_ch, g_io);
+	CU_ASSERT(g_ext_api_called == true);
+	MOCK_CLEAR(spdk_bdev_io_forward_blocks);
+
+	/* Or the I/O isn't contained in an allocated cluster */
+	MOCK_CLEAR(spdk_blob_io_get_dev_lba);
+	g_ext_api_called = false;
+	vbdev_lvol_submit_request(g_ch, g_io);
+	CU_ASSERT(g_ext_api_called == true);
+
+	free(g_io);
+	free(g_base_bdev);
+}
+
 static void
 ut_lvs_rename(void)
 {
@@ -1950,6 +2017,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, ut_vbdev_lvol_io_type_supported);
 	CU_ADD_TEST(suite, ut_lvol_read_write);
 	CU_ADD_TEST(suite, ut_vbdev_lvol_submit_request);
+	CU_ADD_TEST(suite, ut_vbdev_lvol_forward_io);
 	CU_ADD_TEST(suite, ut_lvol_examine_config);
 	CU_ADD_TEST(suite, ut_lvol_examine_disk);
 	CU_ADD_TEST(suite, ut_lvol_rename);
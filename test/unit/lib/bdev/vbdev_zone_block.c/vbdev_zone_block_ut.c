@@ -1063,6 +1063,8 @@ send_append_zone(struct bdev_zone_block *bdev, struct spdk_io_channel *ch, uint6
 
 	g_io_comp_status = !success;
 	zone_block_submit_request(ch, bdev_io);
+	/* Appends are submitted once the thread is done with the current poll */
+	while (spdk_thread_poll(g_thread, 0, 0) > 0) {}
 
 	CU_ASSERT(g_io_comp_status == success);
 	if (success) {
@@ -1465,6 +1467,72 @@ test_append_zone(void)
 	test_cleanup();
 }
 
+static void
+test_append_zone_batch(void)
+{
+	struct spdk_io_channel *ch;
+	struct bdev_zone_block *bdev;
+	struct spdk_bdev_io *bdev_io[4];
+	char *name = "Nvme0n1";
+	uint32_t num_zones = 20;
+	uint64_t zone_id[4], blocks[4] = { 2, 3, 4, 1 };
+	uint32_t output_index = 0;
+	int i;
+
+	init_test_globals(20 * 1024ul);
+	CU_ASSERT(zone_block_init() == 0);
+
+	/* Create zone dev */
+	bdev = create_and_get_vbdev("zone_dev1", name, num_zones, 1, true);
+
+	ch = calloc(1, sizeof(struct spdk_io_channel) + sizeof(struct zone_block_io_channel));
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	send_reset_zone(bdev, ch, 0, output_index, true);
+	send_reset_zone(bdev, ch, bdev->bdev.zone_size, output_index, true);
+
+	/* Appends to the same zone submitted within a poll are merged into a single write */
+	zone_id[0] = zone_id[1] = zone_id[2] = 0;
+	zone_id[3] = bdev->bdev.zone_size;
+	memset(g_io_output, 0, (g_max_io_size * sizeof(struct io_output)));
+	g_io_output_index = output_index;
+	for (i = 0; i < 4; i++) {
+		bdev_io[i] = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct zone_block_io));
+		SPDK_CU_ASSERT_FATAL(bdev_io[i] != NULL);
+		bdev_io_initialize(bdev_io[i], &bdev->bdev, zone_id[i], blocks[i],
+				   SPDK_BDEV_IO_TYPE_ZONE_APPEND);
+		zone_block_submit_request(ch, bdev_io[i]);
+	}
+	CU_ASSERT(g_io_output_index == 0);
+
+	g_io_comp_status = false;
+	while (spdk_thread_poll(g_thread, 0, 0) > 0) {}
+	CU_ASSERT(g_io_comp_status == true);
+	CU_ASSERT(g_io_output_index == 2);
+	CU_ASSERT(g_io_output[0].offset_blocks == 0);
+	CU_ASSERT(g_io_output[0].num_blocks == 9);
+	CU_ASSERT(g_io_output[1].offset_blocks == bdev->bdev.zone_size);
+	CU_ASSERT(g_io_output[1].num_blocks == 1);
+
+	CU_ASSERT(bdev_io[0]->u.bdev.offset_blocks == 0);
+	CU_ASSERT(bdev_io[1]->u.bdev.offset_blocks == 2);
+	CU_ASSERT(bdev_io[2]->u.bdev.offset_blocks == 5);
+	CU_ASSERT(bdev_io[3]->u.bdev.offset_blocks == bdev->bdev.zone_size);
+	for (i = 0; i < 4; i++) {
+		bdev_io_cleanup(bdev_io[i]);
+	}
+
+	send_zone_info(bdev, ch, 0, 9, SPDK_BDEV_ZONE_STATE_OPEN, output_index, true);
+
+	/* Delete zone dev */
+	send_delete_vbdev("zone_dev1", true);
+
+	while (spdk_thread_poll(g_thread, 0, 0) > 0) {}
+	free(ch);
+
+	test_cleanup();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1486,6 +1554,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_close_zone);
 	CU_ADD_TEST(suite, test_finish_zone);
 	CU_ADD_TEST(suite, test_append_zone);
+	CU_ADD_TEST(suite, test_append_zone_batch);
 
 	g_thread = spdk_thread_create("test", NULL);
 	spdk_set_thread(g_thread);
@@ -136,7 +136,7 @@ _get_snapshots_count(struct spdk_blob_store *bs)
 	struct spdk_blob_list *snapshot = NULL;
 	int count = 0;
 
-	TAILQ_FOREACH(snapshot, &bs->snapshots, link) {
+	RB_FOREACH(snapshot, spdk_blob_list_tree, &bs->snapshots) {
 		count += 1;
 	}
 
@@ -1157,6 +1157,67 @@ blob_inflate(void)
 	_blob_inflate(true);
 }
 
+static void
+blob_inflate_rate_limit(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob_opts opts;
+	struct spdk_blob *blob;
+	spdk_blob_id blobid, snapshotid;
+	struct spdk_io_channel *channel;
+	uint64_t free_clusters;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 4;
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	/* Move all the clusters to the snapshot, so that inflate needs to copy each of them */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	/* Copy one cluster per 10ms */
+	spdk_bs_set_copy_rate_limit(bs, 100);
+
+	g_bserrno = -1;
+	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -1);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
+
+	spdk_delay_us(5000);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -1);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
+
+	spdk_delay_us(5000);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -1);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
+
+	/* Removing the limit lets the operation in progress complete at full speed */
+	spdk_bs_set_copy_rate_limit(bs, 0);
+	spdk_delay_us(10000);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob) == false);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+}
+
 static void
 blob_delete(void)
 {
@@ -4024,79 +4085,644 @@ blob_thin_prov_alloc(void)
 	spdk_blob_close(blob, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-
-	ut_bs_reload(&bs, NULL);
-
-	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+
+	ut_bs_reload(&bs, NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	/* Check that clusters allocation and size is still the same */
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.num_clusters == 3);
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
+static void
+blob_insert_cluster_msg_test(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_blob_opts opts;
+	struct spdk_blob_md_page page = {};
+	spdk_blob_id blobid;
+	uint64_t free_clusters;
+	uint64_t new_cluster = 0;
+	uint32_t cluster_num = 3;
+	uint32_t extent_page = 0;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	/* Set blob as thin provisioned */
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 4;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	CU_ASSERT(blob->active.num_clusters == 4);
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 4);
+	CU_ASSERT(blob->active.clusters[cluster_num] == 0);
+
+	/* Specify cluster_num to allocate and new_cluster will be returned to insert on md_thread.
+	 * This is to simulate behaviour when cluster is allocated after blob creation.
+	 * Such as _spdk_bs_allocate_and_copy_cluster(). */
+	spdk_spin_lock(&bs->used_lock);
+	bs_allocate_cluster(blob, cluster_num, &new_cluster, &extent_page, false);
+	CU_ASSERT(blob->active.clusters[cluster_num] == 0);
+	spdk_spin_unlock(&bs->used_lock);
+
+	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page, &page,
+					 blob_op_complete, NULL);
+	poll_threads();
+
+	CU_ASSERT(blob->active.clusters[cluster_num] != 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	ut_bs_reload(&bs, NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	CU_ASSERT(blob->active.clusters[cluster_num] != 0);
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
+static void
+blob_load_extent_pages_batch(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *ch;
+	spdk_blob_id blobid;
+	uint8_t payload[4096] = {};
+	/* More allocated extent pages than are read in a single batch */
+	const uint32_t num_eps = BLOB_LOAD_EXTENT_PAGES_BATCH + 8;
+	uint64_t clusters[BLOB_LOAD_EXTENT_PAGES_BATCH + 9];
+	uint64_t cluster_num, pages_per_cluster, num_allocated = 0, i;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.cluster_sz = 16384;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	pages_per_cluster = bs_opts.cluster_sz / spdk_bs_get_page_size(bs);
+
+	ch = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = num_eps * SPDK_EXTENTS_PER_EP + 7;
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	/* Allocate a cluster in every other extent page and the last cluster of the blob */
+	for (i = 0; i <= num_eps; i++) {
+		cluster_num = i * SPDK_EXTENTS_PER_EP + (i % 2) * 3;
+		if (i == num_eps) {
+			cluster_num = opts.num_clusters - 1;
+		}
+		spdk_blob_io_write(blob, ch, payload, cluster_num * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		clusters[i] = blob->active.clusters[cluster_num];
+		CU_ASSERT(clusters[i] != 0);
+	}
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_free_io_channel(ch);
+	poll_threads();
+
+	ut_bs_reload(&bs, &bs_opts);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	CU_ASSERT(blob->active.num_clusters == opts.num_clusters);
+	CU_ASSERT(blob->active.cluster_array_size == opts.num_clusters);
+	for (i = 0; i < blob->active.num_clusters; i++) {
+		num_allocated += blob->active.clusters[i] != 0;
+	}
+	CU_ASSERT(num_allocated == num_eps + 1);
+	for (i = 0; i <= num_eps; i++) {
+		cluster_num = i * SPDK_EXTENTS_PER_EP + (i % 2) * 3;
+		if (i == num_eps) {
+			cluster_num = opts.num_clusters - 1;
+		}
+		CU_ASSERT(blob->active.clusters[cluster_num] == clusters[i]);
+	}
+
+	ut_blob_close_and_delete(bs, blob);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+ut_insert_cluster_done(void *cb_arg, int bserrno)
+{
+	int *num_done = cb_arg;
+
+	CU_ASSERT(bserrno == 0);
+	(*num_done)++;
+}
+
+static void
+ut_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, struct spdk_blob_md_page *page,
+		  int *num_done)
+{
+	uint64_t new_cluster = 0;
+	uint32_t extent_page = 0;
+
+	spdk_spin_lock(&blob->bs->used_lock);
+	bs_allocate_cluster(blob, cluster_num, &new_cluster, &extent_page, false);
+	spdk_spin_unlock(&blob->bs->used_lock);
+
+	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page, page,
+					 ut_insert_cluster_done, num_done);
+}
+
+static void
+blob_insert_cluster_group_commit(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	struct spdk_blob *blob1, *blob2;
+	struct spdk_blob_md_page pages[3] = {};
+	spdk_blob_id blobid1, blobid2;
+	uint64_t write_bytes, page_size;
+	int num_done = 0;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.md_commit_window_us = 100;
+	bs_opts.md_commit_max_pending = 3;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	page_size = spdk_bs_get_page_size(bs);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 4;
+	blob1 = ut_blob_create_and_open(bs, &opts);
+	blobid1 = spdk_blob_get_id(blob1);
+	blob2 = ut_blob_create_and_open(bs, &opts);
+	blobid2 = spdk_blob_get_id(blob2);
+
+	/* The insertion is visible right away, but only persisted once the window passes */
+	ut_insert_cluster(blob1, 0, &pages[0], &num_done);
+	poll_threads();
+	CU_ASSERT(blob1->active.clusters[0] != 0);
+	CU_ASSERT(num_done == 0);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(num_done == 1);
+	CU_ASSERT(bs->md_commit_num_pending == 0);
+
+	/* Reaching the limit of pending insertions commits the group immediately.  Insertions
+	 * into the same blob share a single metadata update. */
+	write_bytes = g_dev_write_bytes;
+	ut_insert_cluster(blob1, 1, &pages[0], &num_done);
+	ut_insert_cluster(blob1, 2, &pages[1], &num_done);
+	ut_insert_cluster(blob2, 0, &pages[2], &num_done);
+	poll_threads();
+	CU_ASSERT(num_done == 4);
+	CU_ASSERT(bs->md_commit_poller == NULL);
+	if (g_use_extent_table) {
+		/* Extent page of blob1, new extent page of blob2 and its extent table */
+		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 3);
+	} else {
+		CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 2);
+	}
+
+	spdk_blob_close(blob1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_close(blob2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* The clusters were persisted */
+	ut_bs_reload(&bs, &bs_opts);
+
+	spdk_bs_open_blob(bs, blobid1, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob1 = g_blob;
+	CU_ASSERT(blob1->active.clusters[0] != 0);
+	CU_ASSERT(blob1->active.clusters[1] != 0);
+	CU_ASSERT(blob1->active.clusters[2] != 0);
+	CU_ASSERT(blob1->active.clusters[3] == 0);
+
+	spdk_bs_open_blob(bs, blobid2, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob2 = g_blob;
+	CU_ASSERT(blob2->active.clusters[0] != 0);
+	CU_ASSERT(blob2->active.clusters[1] == 0);
+
+	ut_blob_close_and_delete(bs, blob1);
+	ut_blob_close_and_delete(bs, blob2);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+ut_write_cluster(struct spdk_blob *blob, struct spdk_io_channel *channel, uint64_t cluster)
+{
+	uint8_t payload[4096];
+
+	/* Make the data of each cluster distinct */
+	memset(payload, (uint8_t)cluster + 1, sizeof(payload));
+
+	spdk_blob_io_write(blob, channel, payload, cluster * bs_io_units_per_cluster(blob), 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+}
+
+static void
+blob_get_changed_extents(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot2;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	struct spdk_blob_extent extents[4];
+	spdk_blob_id snapshotid1, snapshotid2;
+	uint64_t cpc;
+	uint32_t num;
+	int rc;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 10;
+	blob = ut_blob_create_and_open(bs, &opts);
+	cpc = bs_io_units_per_cluster(blob);
+
+	/* snapshot1 <- snapshot2 <- blob, each of them with different clusters written */
+	ut_write_cluster(blob, channel, 1);
+	spdk_bs_create_snapshot(bs, spdk_blob_get_id(blob), NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid1 = g_blobid;
+
+	ut_write_cluster(blob, channel, 3);
+	ut_write_cluster(blob, channel, 4);
+	spdk_bs_create_snapshot(bs, spdk_blob_get_id(blob), NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid2 = g_blobid;
+
+	ut_write_cluster(blob, channel, 7);
+
+	spdk_bs_open_blob(bs, snapshotid2, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot2 = g_blob;
+
+	/* Changes since snapshot1 */
+	num = SPDK_COUNTOF(extents);
+	rc = spdk_blob_get_changed_extents(blob, snapshotid1, 0, extents, &num);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num == 2);
+	CU_ASSERT(extents[0].offset == 3 * cpc);
+	CU_ASSERT(extents[0].length == 2 * cpc);
+	CU_ASSERT(extents[1].offset == 7 * cpc);
+	CU_ASSERT(extents[1].length == cpc);
+
+	num = SPDK_COUNTOF(extents);
+	rc = spdk_blob_get_changed_extents(snapshot2, snapshotid1, 0, extents, &num);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num == 1);
+	CU_ASSERT(extents[0].offset == 3 * cpc);
+	CU_ASSERT(extents[0].length == 2 * cpc);
+
+	/* Everything allocated in the chain, returned one extent at a time */
+	num = 1;
+	rc = spdk_blob_get_changed_extents(blob, SPDK_BLOBID_INVALID, 0, extents, &num);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num == 1);
+	CU_ASSERT(extents[0].offset == cpc);
+	CU_ASSERT(extents[0].length == cpc);
+
+	num = 1;
+	rc = spdk_blob_get_changed_extents(blob, SPDK_BLOBID_INVALID, 2 * cpc, extents, &num);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num == 1);
+	CU_ASSERT(extents[0].offset == 3 * cpc);
+	CU_ASSERT(extents[0].length == 2 * cpc);
+
+	/* Starting in the middle of a cluster */
+	num = 1;
+	rc = spdk_blob_get_changed_extents(blob, SPDK_BLOBID_INVALID, 5 * cpc - 1, extents, &num);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num == 1);
+	CU_ASSERT(extents[0].offset == 5 * cpc - 1);
+	CU_ASSERT(extents[0].length == 1);
+
+	num = 1;
+	rc = spdk_blob_get_changed_extents(blob, SPDK_BLOBID_INVALID, 8 * cpc, extents, &num);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num == 0);
+
+	/* Nothing changed compared to the blob itself */
+	num = SPDK_COUNTOF(extents);
+	rc = spdk_blob_get_changed_extents(blob, spdk_blob_get_id(blob), 0, extents, &num);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num == 0);
+
+	/* The blob isn't an ancestor of snapshot2 */
+	rc = spdk_blob_get_changed_extents(snapshot2, spdk_blob_get_id(blob), 0, extents, &num);
+	CU_ASSERT(rc == -EINVAL);
+
+	spdk_blob_close(snapshot2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+	spdk_bs_delete_blob(bs, snapshotid2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_delete_blob(bs, snapshotid1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+}
+
+static uint8_t *g_ut_ext_dev_buf;
+static uint32_t g_ut_ext_dev_writes;
+
+static void
+ut_ext_dev_write(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+		 uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	memcpy(&g_ut_ext_dev_buf[lba * dev->blocklen], payload, lba_count * dev->blocklen);
+	g_ut_ext_dev_writes++;
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
+
+static void
+blob_shallow_copy(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	struct spdk_bs_dev ext_dev = {};
+	spdk_blob_id blobid, snapshotid1, snapshotid2;
+	uint64_t cluster_sz = spdk_bs_get_cluster_size(bs);
+	uint8_t pattern[4096];
+
+	ext_dev.create_channel = dev_create_channel;
+	ext_dev.destroy_channel = dev_destroy_channel;
+	ext_dev.write = ut_ext_dev_write;
+	ext_dev.blocklen = 512;
+	ext_dev.blockcnt = 10 * cluster_sz / ext_dev.blocklen;
+	g_ut_ext_dev_buf = calloc(10, cluster_sz);
+	SPDK_CU_ASSERT_FATAL(g_ut_ext_dev_buf != NULL);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 10;
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	ut_write_cluster(blob, channel, 1);
+	ut_write_cluster(blob, channel, 2);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid1 = g_blobid;
+
+	ut_write_cluster(blob, channel, 5);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid2 = g_blobid;
+
+	/* Only read only blobs can be copied */
+	spdk_bs_blob_shallow_copy(bs, channel, blobid, SPDK_BLOBID_INVALID, &ext_dev, 2,
+				  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EPERM);
+
+	spdk_bs_blob_shallow_copy(bs, channel, snapshotid1, SPDK_BLOBID_INVALID, &ext_dev, 0,
+				  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+
+	spdk_bs_blob_shallow_copy(bs, channel, snapshotid1, snapshotid2, &ext_dev, 2,
+				  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+
+	/* The whole chain of the first snapshot */
+	spdk_bs_blob_shallow_copy(bs, channel, snapshotid1, SPDK_BLOBID_INVALID, &ext_dev, 2,
+				  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_ut_ext_dev_writes == 2);
+	memset(pattern, 2, sizeof(pattern));
+	CU_ASSERT(memcmp(&g_ut_ext_dev_buf[cluster_sz], pattern, sizeof(pattern)) == 0);
+	memset(pattern, 3, sizeof(pattern));
+	CU_ASSERT(memcmp(&g_ut_ext_dev_buf[2 * cluster_sz], pattern, sizeof(pattern)) == 0);
+	CU_ASSERT(spdk_mem_all_zero(&g_ut_ext_dev_buf[5 * cluster_sz], cluster_sz));
+
+	/* Then only the changes made since then, with the copies rate limited */
+	spdk_bs_set_copy_rate_limit(bs, 100);
+	g_ut_ext_dev_writes = 0;
+	g_bserrno = -1;
+	spdk_bs_blob_shallow_copy(bs, channel, snapshotid2, snapshotid1, &ext_dev, 2,
+				  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_ut_ext_dev_writes == 1);
+	memset(pattern, 6, sizeof(pattern));
+	CU_ASSERT(memcmp(&g_ut_ext_dev_buf[5 * cluster_sz], pattern, sizeof(pattern)) == 0);
+	spdk_bs_set_copy_rate_limit(bs, 0);
+
+	/* The device is too small */
+	ext_dev.blockcnt = 9 * cluster_sz / ext_dev.blocklen;
+	spdk_bs_blob_shallow_copy(bs, channel, snapshotid2, SPDK_BLOBID_INVALID, &ext_dev, 2,
+				  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+	spdk_bs_delete_blob(bs, snapshotid2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_delete_blob(bs, snapshotid1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	blob = g_blob;
 
-	/* Check that clusters allocation and size is still the same */
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-	CU_ASSERT(blob->active.num_clusters == 3);
-
-	ut_blob_close_and_delete(bs, blob);
+	free(g_ut_ext_dev_buf);
+	g_ut_ext_dev_buf = NULL;
+	g_ut_ext_dev_writes = 0;
 }
 
 static void
-blob_insert_cluster_msg_test(void)
+blob_thin_prov_unmap_free_cluster(void)
 {
 	struct spdk_blob_store *bs = g_bs;
-	struct spdk_blob *blob;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
 	struct spdk_blob_opts opts;
-	struct spdk_blob_md_page page = {};
-	spdk_blob_id blobid;
-	uint64_t free_clusters;
-	uint64_t new_cluster = 0;
-	uint32_t cluster_num = 3;
-	uint32_t extent_page = 0;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t free_clusters, io_units_per_cluster;
+	uint8_t payload[4096];
 
 	free_clusters = spdk_bs_free_cluster_count(bs);
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
 
-	/* Set blob as thin provisioned */
 	ut_spdk_blob_opts_init(&opts);
 	opts.thin_provision = true;
 	opts.num_clusters = 4;
-
 	blob = ut_blob_create_and_open(bs, &opts);
 	blobid = spdk_blob_get_id(blob);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	io_units_per_cluster = bs_io_units_per_cluster(blob);
 
-	CU_ASSERT(blob->active.num_clusters == 4);
-	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 4);
-	CU_ASSERT(blob->active.clusters[cluster_num] == 0);
+	memset(payload, 0xE5, sizeof(payload));
+	spdk_blob_io_write(blob, channel, payload, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_io_write(blob, channel, payload, io_units_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
 
-	/* Specify cluster_num to allocate and new_cluster will be returned to insert on md_thread.
-	 * This is to simulate behaviour when cluster is allocated after blob creation.
-	 * Such as _spdk_bs_allocate_and_copy_cluster(). */
-	spdk_spin_lock(&bs->used_lock);
-	bs_allocate_cluster(blob, cluster_num, &new_cluster, &extent_page, false);
-	CU_ASSERT(blob->active.clusters[cluster_num] == 0);
-	spdk_spin_unlock(&bs->used_lock);
+	/* Unmapping a whole cluster releases it, a partial unmap doesn't */
+	spdk_blob_io_unmap(blob, channel, 0, io_units_per_cluster + 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->active.clusters[0] == 0);
+	CU_ASSERT(blob->active.clusters[1] != 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
 
-	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page, &page,
-					 blob_op_complete, NULL);
+	memset(payload, 0xFF, sizeof(payload));
+	spdk_blob_io_read(blob, channel, payload, 0, 1, blob_op_complete, NULL);
 	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_mem_all_zero(payload, bs->io_unit_size));
 
-	CU_ASSERT(blob->active.clusters[cluster_num] != 0);
+	/* The released cluster can be allocated again */
+	spdk_blob_io_write(blob, channel, payload, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
+
+	spdk_blob_io_unmap(blob, channel, 0, io_units_per_cluster, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
 
+	/* The release was persisted */
 	spdk_blob_close(blob, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
 
 	ut_bs_reload(&bs, NULL);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
 
 	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
 	blob = g_blob;
+	CU_ASSERT(blob->active.clusters[0] == 0);
+	CU_ASSERT(blob->active.clusters[1] != 0);
 
-	CU_ASSERT(blob->active.clusters[cluster_num] != 0);
+	/* Clusters of a clone aren't released, reading them would return the snapshot's data */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+	spdk_blob_io_write(blob, channel, payload, io_units_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	spdk_blob_io_unmap(blob, channel, io_units_per_cluster, io_units_per_cluster,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->active.clusters[1] != 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
 
 	ut_blob_close_and_delete(bs, blob);
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	ut_blob_close_and_delete(bs, snapshot);
 }
 
 static void
@@ -4332,6 +4958,89 @@ blob_thin_prov_write_count_io(void)
 	g_bs = NULL;
 }
 
+static void
+blob_thin_prov_reserved_clusters(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	uint8_t payload[4096];
+	uint64_t free_clusters;
+	uint32_t i;
+
+	/* Use small clusters, so that there's enough free ones to be reserved */
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.cluster_sz = SPDK_BS_PAGE_SIZE * 4;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	SPDK_CU_ASSERT_FATAL(free_clusters > BS_CHANNEL_RESERVED_CLUSTERS *
+			     BS_CHANNEL_RESERVATION_RATIO);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 4;
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	/* First writes to each cluster */
+	memset(payload, 0xE5, sizeof(payload));
+	for (i = 0; i < 4; i++) {
+		spdk_blob_io_write(blob, channel, payload, i * 4, 1, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	/* The reserved clusters aren't accounted as used */
+	CU_ASSERT(bs->num_reserved_clusters > 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+
+	/* Clusters allocated on a channel are contiguous */
+	for (i = 1; i < 4; i++) {
+		CU_ASSERT(blob->active.clusters[i] ==
+			  blob->active.clusters[i - 1] + bs_cluster_to_lba(bs, 1));
+	}
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Reservations aren't persisted as used clusters */
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_bs = NULL;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	spdk_bs_load(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+	CU_ASSERT(bs->num_reserved_clusters == 0);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
 static void
 blob_thin_prov_rle(void)
 {
@@ -5141,6 +5850,111 @@ blob_inflate_rw(void)
  *      |           |
  *   clone2      clone
  */
+static void
+blob_snapshot_overwrite_cluster(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id snapshotid;
+	uint64_t cluster_size, io_units_per_cluster;
+	uint64_t read_bytes_start, copy_bytes_start;
+	uint8_t *payload_read, *payload_write, *expected;
+
+	cluster_size = spdk_bs_get_cluster_size(bs);
+	io_units_per_cluster = cluster_size / spdk_bs_get_io_unit_size(bs);
+
+	payload_read = calloc(1, cluster_size);
+	payload_write = calloc(1, cluster_size);
+	expected = calloc(1, cluster_size);
+	SPDK_CU_ASSERT_FATAL(payload_read != NULL && payload_write != NULL && expected != NULL);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 2;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	/* Fill both clusters and create a snapshot */
+	memset(payload_write, 0xE5, cluster_size);
+	spdk_blob_io_write(blob, channel, payload_write, 0, io_units_per_cluster,
+			   blob_op_complete, NULL);
+	spdk_blob_io_write(blob, channel, payload_write, io_units_per_cluster,
+			   io_units_per_cluster, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, spdk_blob_get_id(blob), NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+
+	/* Overwriting the whole cluster doesn't need to copy it from the snapshot */
+	read_bytes_start = g_dev_read_bytes;
+	copy_bytes_start = g_dev_copy_bytes;
+	memset(payload_write, 0xAA, cluster_size);
+	spdk_blob_io_write(blob, channel, payload_write, 0, io_units_per_cluster,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes == read_bytes_start);
+	CU_ASSERT(g_dev_copy_bytes == copy_bytes_start);
+
+	spdk_blob_io_read(blob, channel, payload_read, 0, io_units_per_cluster,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, cluster_size) == 0);
+
+	/* Writing a part of the cluster still copies the rest of it */
+	read_bytes_start = g_dev_read_bytes;
+	copy_bytes_start = g_dev_copy_bytes;
+	spdk_blob_io_write(blob, channel, payload_write, io_units_per_cluster + 1, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes - read_bytes_start + g_dev_copy_bytes - copy_bytes_start ==
+		  cluster_size);
+
+	memset(expected, 0xE5, cluster_size);
+	memset(expected + spdk_bs_get_io_unit_size(bs), 0xAA, spdk_bs_get_io_unit_size(bs));
+	spdk_blob_io_read(blob, channel, payload_read, io_units_per_cluster, io_units_per_cluster,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(expected, payload_read, cluster_size) == 0);
+
+	/* Data on the snapshot didn't change */
+	memset(expected, 0xE5, cluster_size);
+	spdk_blob_io_read(snapshot, channel, payload_read, 0, io_units_per_cluster,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(expected, payload_read, cluster_size) == 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+
+	free(payload_read);
+	free(payload_write);
+	free(expected);
+}
+
 static void
 blob_relations(void)
 {
@@ -7450,6 +8264,62 @@ blob_seek_io_unit(void)
 	ut_blob_close_and_delete(bs, blob);
 }
 
+static void
+blob_io_get_dev_lba(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel, *dev_channel;
+	struct spdk_bs_channel *bs_channel;
+	struct spdk_blob_opts opts;
+	uint8_t payload[4096];
+	uint64_t io_units_per_cluster, lba;
+	int rc;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+	bs_channel = spdk_io_channel_get_ctx(channel);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 3;
+	blob = ut_blob_create_and_open(bs, &opts);
+	io_units_per_cluster = bs_io_units_per_cluster(blob);
+
+	/* Allocate the second cluster */
+	spdk_blob_io_write(blob, channel, payload, io_units_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Ranges within the allocated cluster are translated */
+	rc = spdk_blob_io_get_dev_lba(blob, channel, io_units_per_cluster + 1,
+				      io_units_per_cluster - 1, &dev_channel, &lba);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(dev_channel == bs_channel->dev_channel);
+	CU_ASSERT(lba == blob->active.clusters[1] + 1);
+
+	/* Ranges in unallocated clusters or crossing a cluster boundary aren't */
+	rc = spdk_blob_io_get_dev_lba(blob, channel, 0, 1, &dev_channel, &lba);
+	CU_ASSERT(rc == -ENOENT);
+	rc = spdk_blob_io_get_dev_lba(blob, channel, io_units_per_cluster + 1,
+				      io_units_per_cluster, &dev_channel, &lba);
+	CU_ASSERT(rc == -ENOENT);
+	rc = spdk_blob_io_get_dev_lba(blob, channel, 3 * io_units_per_cluster, 1,
+				      &dev_channel, &lba);
+	CU_ASSERT(rc == -ENOENT);
+
+	/* Nor are ranges of a blob with frozen I/O */
+	blob->frozen_refcnt++;
+	rc = spdk_blob_io_get_dev_lba(blob, channel, io_units_per_cluster, 1, &dev_channel, &lba);
+	CU_ASSERT(rc == -EBUSY);
+	blob->frozen_refcnt--;
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
 static void
 blob_esnap_create(void)
 {
@@ -8773,6 +9643,7 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_snapshot);
 		CU_ADD_TEST(suite_bs, blob_clone);
 		CU_ADD_TEST(suite_bs, blob_inflate);
+		CU_ADD_TEST(suite_bs, blob_inflate_rate_limit);
 		CU_ADD_TEST(suite_bs, blob_delete);
 		CU_ADD_TEST(suite_bs, blob_resize_test);
 		CU_ADD_TEST(suite, blob_read_only);
@@ -8810,13 +9681,20 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_set_xattrs_test);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_alloc);
 		CU_ADD_TEST(suite_bs, blob_insert_cluster_msg_test);
+		CU_ADD_TEST(suite, blob_load_extent_pages_batch);
+		CU_ADD_TEST(suite, blob_insert_cluster_group_commit);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rw);
+		CU_ADD_TEST(suite_bs, blob_thin_prov_unmap_free_cluster);
+		CU_ADD_TEST(suite_bs, blob_get_changed_extents);
+		CU_ADD_TEST(suite_bs, blob_shallow_copy);
 		CU_ADD_TEST(suite, blob_thin_prov_write_count_io);
+		CU_ADD_TEST(suite, blob_thin_prov_reserved_clusters);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rle);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rw_iov);
 		CU_ADD_TEST(suite, bs_load_iter_test);
 		CU_ADD_TEST(suite_bs, blob_snapshot_rw);
 		CU_ADD_TEST(suite_bs, blob_snapshot_rw_iov);
+		CU_ADD_TEST(suite_bs, blob_snapshot_overwrite_cluster);
 		CU_ADD_TEST(suite, blob_relations);
 		CU_ADD_TEST(suite, blob_relations2);
 		CU_ADD_TEST(suite, blob_relations3);
@@ -8833,6 +9711,7 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_persist_test);
 		CU_ADD_TEST(suite_bs, blob_decouple_snapshot);
 		CU_ADD_TEST(suite_bs, blob_seek_io_unit);
+		CU_ADD_TEST(suite_bs, blob_io_get_dev_lba);
 		CU_ADD_TEST(suite_esnap_bs, blob_esnap_create);
 		CU_ADD_TEST(suite_bs, blob_nested_freezes);
 		CU_ADD_TEST(suite, blob_ext_md_pages);
@@ -0,0 +1,321 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation. All rights reserved.
+ */
+
+#include "spdk_internal/cunit.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "blob/esnap_cache.c"
+
+#define UT_BLOCKLEN	512
+/* The last chunk is only partially backed by the device */
+#define UT_BLOCKCNT	(4 * ESNAP_CACHE_CHUNK_SIZE / UT_BLOCKLEN + 8)
+
+struct ut_back_dev {
+	struct spdk_bs_dev	bs_dev;
+	uint8_t			*data;
+	uint32_t		num_reads;
+	int			rc;
+	bool			destroyed;
+};
+
+struct ut_back_read {
+	struct spdk_bs_dev_cb_args	*cb_args;
+	int				rc;
+};
+
+static void
+ut_back_read_done(void *ctx)
+{
+	struct ut_back_read *read = ctx;
+
+	read->cb_args->cb_fn(read->cb_args->channel, read->cb_args->cb_arg, read->rc);
+	free(read);
+}
+
+/* Complete the reads asynchronously, so that concurrent misses can be coalesced */
+static void
+ut_back_dev_readv(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+		  struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+		  struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct ut_back_dev *bdev = SPDK_CONTAINEROF(dev, struct ut_back_dev, bs_dev);
+	struct ut_back_read *read;
+
+	SPDK_CU_ASSERT_FATAL(lba + lba_count <= dev->blockcnt);
+	spdk_copy_buf_to_iovs(iov, iovcnt, bdev->data + lba * dev->blocklen,
+			      (uint64_t)lba_count * dev->blocklen);
+	bdev->num_reads++;
+
+	read = calloc(1, sizeof(*read));
+	SPDK_CU_ASSERT_FATAL(read != NULL);
+	read->cb_args = cb_args;
+	read->rc = bdev->rc;
+	spdk_thread_send_msg(spdk_get_thread(), ut_back_read_done, read);
+}
+
+static void
+ut_back_dev_read(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+		 uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct iovec iov = {
+		.iov_base = payload,
+		.iov_len = (uint64_t)lba_count * dev->blocklen,
+	};
+
+	ut_back_dev_readv(dev, channel, &iov, 1, lba, lba_count, cb_args);
+}
+
+static void
+ut_back_dev_destroy(struct spdk_bs_dev *dev)
+{
+	struct ut_back_dev *bdev = SPDK_CONTAINEROF(dev, struct ut_back_dev, bs_dev);
+
+	bdev->destroyed = true;
+}
+
+static void
+ut_back_dev_init(struct ut_back_dev *bdev, uint8_t *data)
+{
+	memset(bdev, 0, sizeof(*bdev));
+	bdev->bs_dev.blocklen = UT_BLOCKLEN;
+	bdev->bs_dev.blockcnt = UT_BLOCKCNT;
+	bdev->bs_dev.read = ut_back_dev_read;
+	bdev->bs_dev.readv = ut_back_dev_readv;
+	bdev->bs_dev.destroy = ut_back_dev_destroy;
+	bdev->data = data;
+}
+
+struct ut_read {
+	uint8_t				*buf;
+	struct iovec			iov[2];
+	struct spdk_bs_dev_cb_args	cb_args;
+	struct spdk_thread		*thread;
+	bool				done;
+	int				rc;
+};
+
+static void
+ut_read_done(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct ut_read *read = cb_arg;
+
+	read->thread = spdk_get_thread();
+	read->done = true;
+	read->rc = bserrno;
+}
+
+/* Read into two iovs splitting the payload in half */
+static void
+ut_read(struct spdk_bs_dev *dev, struct ut_read *read, uint64_t lba, uint32_t lba_count)
+{
+	uint64_t length = (uint64_t)lba_count * UT_BLOCKLEN;
+
+	free(read->buf);
+	memset(read, 0, sizeof(*read));
+	read->buf = calloc(1, length);
+	SPDK_CU_ASSERT_FATAL(read->buf != NULL);
+	read->iov[0].iov_base = read->buf;
+	read->iov[0].iov_len = length / 2;
+	read->iov[1].iov_base = read->buf + length / 2;
+	read->iov[1].iov_len = length - length / 2;
+	read->cb_args.cb_fn = ut_read_done;
+	read->cb_args.cb_arg = read;
+
+	dev->readv(dev, NULL, read->iov, 2, lba, lba_count, &read->cb_args);
+}
+
+static uint8_t *
+ut_alloc_data(void)
+{
+	uint8_t *data;
+	uint64_t i;
+
+	data = malloc((uint64_t)UT_BLOCKCNT * UT_BLOCKLEN);
+	SPDK_CU_ASSERT_FATAL(data != NULL);
+	for (i = 0; i < (uint64_t)UT_BLOCKCNT * UT_BLOCKLEN; i++) {
+		data[i] = (uint8_t)(i * 7 + i / UT_BLOCKLEN);
+	}
+
+	return data;
+}
+
+static void
+esnap_cache_coalesce(void)
+{
+	struct ut_back_dev back1, back2;
+	struct spdk_bs_dev *dev1, *dev2;
+	struct ut_read read1 = {}, read2 = {};
+	uint64_t lba = ESNAP_CACHE_CHUNK_SIZE / UT_BLOCKLEN - 4;
+	uint8_t *data;
+	int rc;
+
+	allocate_threads(2);
+	set_thread(0);
+	data = ut_alloc_data();
+	spdk_bs_esnap_cache_set_size(4 * ESNAP_CACHE_CHUNK_SIZE);
+
+	/* Clones of the same external snapshot share the cache */
+	ut_back_dev_init(&back1, data);
+	ut_back_dev_init(&back2, data);
+	rc = spdk_bs_esnap_cache_dev_create(&back1.bs_dev, "esnap", 6, &dev1);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_bs_esnap_cache_dev_create(&back2.bs_dev, "esnap", 6, &dev2);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(dev1->blockcnt, UT_BLOCKCNT);
+	CU_ASSERT_EQUAL(dev1->blocklen, UT_BLOCKLEN);
+
+	/* Misses on the same chunks from different threads result in a single read of each */
+	ut_read(dev1, &read1, lba, 8);
+	set_thread(1);
+	ut_read(dev2, &read2, lba + 2, 4);
+	CU_ASSERT_EQUAL(back1.num_reads, 2);
+	CU_ASSERT_EQUAL(back2.num_reads, 0);
+	poll_threads();
+	CU_ASSERT(read1.done && read2.done);
+	CU_ASSERT_EQUAL(read1.rc, 0);
+	CU_ASSERT_EQUAL(read2.rc, 0);
+	/* Each read completes on the thread it was submitted from */
+	CU_ASSERT(read1.thread == g_ut_threads[0].thread);
+	CU_ASSERT(read2.thread == g_ut_threads[1].thread);
+	CU_ASSERT(memcmp(read1.buf, data + lba * UT_BLOCKLEN, 8 * UT_BLOCKLEN) == 0);
+	CU_ASSERT(memcmp(read2.buf, data + (lba + 2) * UT_BLOCKLEN, 4 * UT_BLOCKLEN) == 0);
+
+	/* Cached data is read without touching the backing device */
+	ut_read(dev2, &read2, lba + 1, 6);
+	CU_ASSERT(read2.done);
+	CU_ASSERT_EQUAL(read2.rc, 0);
+	CU_ASSERT(memcmp(read2.buf, data + (lba + 1) * UT_BLOCKLEN, 6 * UT_BLOCKLEN) == 0);
+	CU_ASSERT_EQUAL(back1.num_reads + back2.num_reads, 2);
+
+	/* The last chunk is shorter than the others */
+	ut_read(dev2, &read2, UT_BLOCKCNT - 8, 8);
+	poll_threads();
+	CU_ASSERT(read2.done);
+	CU_ASSERT_EQUAL(read2.rc, 0);
+	CU_ASSERT(memcmp(read2.buf, data + (UT_BLOCKCNT - 8) * UT_BLOCKLEN, 8 * UT_BLOCKLEN) == 0);
+	CU_ASSERT_EQUAL(back2.num_reads, 1);
+
+	/* Destroying the last device of an external snapshot drops its cached data */
+	dev1->destroy(dev1);
+	CU_ASSERT(back1.destroyed);
+	CU_ASSERT_EQUAL(g_esnap_cache_used, 3 * ESNAP_CACHE_CHUNK_SIZE);
+	dev2->destroy(dev2);
+	CU_ASSERT(back2.destroyed);
+	CU_ASSERT_EQUAL(g_esnap_cache_used, 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_esnap_caches));
+
+	spdk_bs_esnap_cache_set_size(0);
+	free(read1.buf);
+	free(read2.buf);
+	free(data);
+	free_threads();
+}
+
+static void
+esnap_cache_evict_lru(void)
+{
+	struct ut_back_dev back;
+	struct spdk_bs_dev *dev;
+	struct ut_read read = {};
+	uint32_t chunk_blocks = ESNAP_CACHE_CHUNK_SIZE / UT_BLOCKLEN;
+	uint8_t *data;
+	int rc;
+
+	allocate_threads(1);
+	set_thread(0);
+	data = ut_alloc_data();
+	spdk_bs_esnap_cache_set_size(2 * ESNAP_CACHE_CHUNK_SIZE);
+
+	ut_back_dev_init(&back, data);
+	rc = spdk_bs_esnap_cache_dev_create(&back.bs_dev, "esnap", 6, &dev);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Fill the cache with chunks 0 and 1, then use chunk 0 so that 1 is evicted first */
+	ut_read(dev, &read, 0, 1);
+	poll_threads();
+	ut_read(dev, &read, chunk_blocks, 1);
+	poll_threads();
+	ut_read(dev, &read, 1, 1);
+	CU_ASSERT(read.done);
+	CU_ASSERT_EQUAL(back.num_reads, 2);
+
+	ut_read(dev, &read, 2 * chunk_blocks, 1);
+	poll_threads();
+	CU_ASSERT(read.done);
+	CU_ASSERT(memcmp(read.buf, data + 2 * chunk_blocks * UT_BLOCKLEN, UT_BLOCKLEN) == 0);
+	CU_ASSERT_EQUAL(back.num_reads, 3);
+	CU_ASSERT_EQUAL(g_esnap_cache_used, 2 * ESNAP_CACHE_CHUNK_SIZE);
+
+	ut_read(dev, &read, 0, 1);
+	CU_ASSERT(read.done);
+	CU_ASSERT_EQUAL(back.num_reads, 3);
+	ut_read(dev, &read, chunk_blocks, 1);
+	poll_threads();
+	CU_ASSERT_EQUAL(back.num_reads, 4);
+
+	/* Lowering the size evicts the data right away */
+	spdk_bs_esnap_cache_set_size(ESNAP_CACHE_CHUNK_SIZE);
+	CU_ASSERT_EQUAL(g_esnap_cache_used, ESNAP_CACHE_CHUNK_SIZE);
+
+	/* Failed reads aren't cached */
+	back.rc = -EIO;
+	ut_read(dev, &read, 3 * chunk_blocks, 1);
+	poll_threads();
+	CU_ASSERT(read.done);
+	CU_ASSERT_EQUAL(read.rc, -EIO);
+	back.rc = 0;
+	ut_read(dev, &read, 3 * chunk_blocks, 1);
+	poll_threads();
+	CU_ASSERT_EQUAL(read.rc, 0);
+	CU_ASSERT_EQUAL(back.num_reads, 6);
+
+	/* A disabled cache passes the reads through */
+	spdk_bs_esnap_cache_set_size(0);
+	CU_ASSERT_EQUAL(g_esnap_cache_used, 0);
+	ut_read(dev, &read, 3 * chunk_blocks, 1);
+	poll_threads();
+	CU_ASSERT(read.done);
+	CU_ASSERT_EQUAL(back.num_reads, 7);
+
+	dev->destroy(dev);
+	free(read.buf);
+	free(data);
+	free_threads();
+}
+
+static void
+esnap_cache_bad_blocklen(void)
+{
+	struct ut_back_dev back;
+	struct spdk_bs_dev *dev = NULL;
+	int rc;
+
+	ut_back_dev_init(&back, NULL);
+	back.bs_dev.blocklen = 3 * 512;
+	rc = spdk_bs_esnap_cache_dev_create(&back.bs_dev, "esnap", 6, &dev);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	CU_ASSERT_PTR_NULL(dev);
+	CU_ASSERT(!back.destroyed);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("esnap_cache", NULL, NULL);
+
+	CU_ADD_TEST(suite, esnap_cache_coalesce);
+	CU_ADD_TEST(suite, esnap_cache_evict_lru);
+	CU_ADD_TEST(suite, esnap_cache_bad_blocklen);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	return num_failures;
+}
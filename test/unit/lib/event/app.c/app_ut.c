@@ -25,12 +25,13 @@ DEFINE_STUB(spdk_rpc_initialize, int, (const char *listen_addr,
 				       const struct spdk_rpc_opts *opts), 0);
 DEFINE_STUB_V(spdk_rpc_set_allowlist, (const char **rpc_allowlist));
 DEFINE_STUB_V(spdk_rpc_finish, (void));
-DEFINE_STUB_V(spdk_subsystem_init_from_json_config, (const char *json_config_file,
-		const char *rpc_addr,
+DEFINE_STUB_V(spdk_subsystem_init_from_json_config_ext, (const char *json_config_file,
+		const char *rpc_addr, uint32_t max_parallel,
 		spdk_subsystem_init_fn cb_fn, void *cb_arg, bool stop_on_error));
 DEFINE_STUB_V(spdk_reactors_start, (void));
 DEFINE_STUB_V(spdk_reactors_stop, (void *arg1));
 DEFINE_STUB(spdk_reactors_init, int, (size_t msg_mempool_size), 0);
+DEFINE_STUB(spdk_reactors_stats_init, int, (const char *shm_name), 0);
 DEFINE_STUB_V(spdk_reactors_fini, (void));
 bool g_scheduling_in_progress;
 
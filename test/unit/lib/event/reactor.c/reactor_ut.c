@@ -868,6 +868,237 @@ test_bind_thread(void)
 	free_cores();
 }
 
+/* Run the dynamic scheduler with all three threads starting on core 0 */
+static void
+ut_balance_from_core0(struct spdk_scheduler_core_info *cores_info,
+		      struct spdk_scheduler_thread_info *thread_infos)
+{
+	int i;
+
+	cores_info[0].threads_count = 3;
+	cores_info[0].current_busy_tsc = 30;
+	cores_info[0].current_idle_tsc = 270;
+	for (i = 0; i < 3; i++) {
+		thread_infos[i].lcore = 0;
+	}
+
+	scheduler_dynamic.balance(cores_info, 3);
+}
+
+static void
+test_scheduler_latency_aware(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread[3];
+	struct spdk_reactor *reactor;
+	struct spdk_scheduler_core_info cores_info[3] = {};
+	struct spdk_scheduler_thread_info thread_infos[3] = {};
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(3);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_scheduler_set("dynamic");
+
+	for (i = 0; i < 3; i++) {
+		spdk_cpuset_set_cpu(&g_reactor_core_mask, i, true);
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+	}
+
+	for (i = 0; i < 3; i++) {
+		thread[i] = spdk_thread_create(NULL, &cpuset);
+		SPDK_CU_ASSERT_FATAL(thread[i] != NULL);
+	}
+
+	for (i = 0; i < 3; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		MOCK_SET(spdk_env_get_current_core, i);
+		event_queue_run_batch(reactor);
+	}
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	/* All threads are mostly idle and placed on core 0.  The first two are latency sensitive,
+	 * while the last one runs in long bursts. */
+	cores_info[0].thread_infos = thread_infos;
+	for (i = 0; i < 3; i++) {
+		thread_infos[i].thread_id = spdk_thread_get_id(thread[i]);
+		thread_infos[i].current_stats.busy_tsc = 10;
+		thread_infos[i].current_stats.idle_tsc = 90;
+		thread_infos[i].burst_stats.busy_run_p99_tsc = 16;
+	}
+	thread_infos[0].latency_class = SPDK_THREAD_LATENCY_CLASS_SENSITIVE;
+	thread_infos[1].latency_class = SPDK_THREAD_LATENCY_CLASS_SENSITIVE;
+	thread_infos[2].burst_stats.busy_run_p99_tsc = 1024;
+
+	/* Without latency awareness, idle threads are consolidated on the main core */
+	ut_balance_from_core0(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 0);
+	CU_ASSERT(thread_infos[1].lcore == 0);
+	CU_ASSERT(thread_infos[2].lcore == 0);
+
+	/* Latency sensitive threads are separated from each other and from the bursty one */
+	g_scheduler_latency_aware = true;
+	ut_balance_from_core0(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 1);
+	CU_ASSERT(thread_infos[1].lcore == 2);
+	CU_ASSERT(thread_infos[2].lcore == 0);
+
+	/* A quiet thread can share the core with a latency sensitive one */
+	thread_infos[2].burst_stats.busy_run_p99_tsc = 16;
+	ut_balance_from_core0(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 1);
+	CU_ASSERT(thread_infos[1].lcore == 0);
+	CU_ASSERT(thread_infos[2].lcore == 0);
+
+	/* A high message rate makes the thread bursty as well */
+	thread_infos[2].burst_stats.msg_count = 20000;
+	ut_balance_from_core0(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 1);
+	CU_ASSERT(thread_infos[1].lcore == 2);
+	CU_ASSERT(thread_infos[2].lcore == 0);
+
+	g_scheduler_latency_aware = false;
+	g_reactor_state = SPDK_REACTOR_STATE_INITIALIZED;
+
+	/* Destroy threads */
+	for (i = 0; i < 3; i++) {
+		spdk_set_thread(thread[i]);
+		spdk_thread_exit(thread[i]);
+	}
+	for (i = 0; i < 3; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		reactor_run(reactor);
+	}
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
+static void
+ut_balance_numa(struct spdk_scheduler_core_info *cores_info,
+		struct spdk_scheduler_thread_info *thread_infos)
+{
+	int i;
+
+	cores_info[0].threads_count = 3;
+	cores_info[0].current_busy_tsc = 170;
+	cores_info[0].current_idle_tsc = 130;
+	/* Core 2 is polling without any threads */
+	cores_info[2].current_idle_tsc = 300;
+	for (i = 0; i < 3; i++) {
+		thread_infos[i].lcore = 0;
+	}
+
+	scheduler_dynamic.balance(cores_info, 3);
+}
+
+static void
+test_scheduler_numa_aware(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread[3];
+	struct spdk_reactor *reactor;
+	struct spdk_scheduler_core_info cores_info[3] = {};
+	struct spdk_scheduler_thread_info thread_infos[3] = {};
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(3);
+	/* Cores 0 and 1 are on socket 0, core 2 on socket 1 */
+	set_core_socket(0, 0);
+	set_core_socket(1, 0);
+	set_core_socket(2, 1);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_scheduler_set("dynamic");
+
+	for (i = 0; i < 3; i++) {
+		spdk_cpuset_set_cpu(&g_reactor_core_mask, i, true);
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+	}
+
+	for (i = 0; i < 3; i++) {
+		thread[i] = spdk_thread_create(NULL, &cpuset);
+		SPDK_CU_ASSERT_FATAL(thread[i] != NULL);
+	}
+
+	for (i = 0; i < 3; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		MOCK_SET(spdk_env_get_current_core, i);
+		event_queue_run_batch(reactor);
+	}
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	/* All threads are placed on core 0, which isn't over the core limit.  The first thread is
+	 * active and the last one idle, both prefer socket 1.  The second one has no preference. */
+	cores_info[0].thread_infos = thread_infos;
+	for (i = 0; i < 3; i++) {
+		thread_infos[i].thread_id = spdk_thread_get_id(thread[i]);
+		thread_infos[i].current_stats.busy_tsc = 80;
+		thread_infos[i].current_stats.idle_tsc = 20;
+		thread_infos[i].numa_affinity = 1;
+	}
+	thread_infos[1].numa_affinity = SPDK_ENV_SOCKET_ID_ANY;
+	thread_infos[2].current_stats.busy_tsc = 10;
+	thread_infos[2].current_stats.idle_tsc = 90;
+
+	/* Without NUMA awareness, the threads stay on the main core */
+	ut_balance_numa(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 0);
+	CU_ASSERT(thread_infos[1].lcore == 0);
+	CU_ASSERT(thread_infos[2].lcore == 0);
+
+	/* Threads preferring socket 1 are moved there, even the idle one */
+	g_scheduler_numa_aware = true;
+	ut_balance_numa(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 2);
+	CU_ASSERT(thread_infos[1].lcore == 0);
+	CU_ASSERT(thread_infos[2].lcore == 2);
+
+	/* Once socket 1 is considered loaded over the cross limit, any socket is fine */
+	g_scheduler_numa_cross_limit = 0;
+	ut_balance_numa(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 0);
+	CU_ASSERT(thread_infos[1].lcore == 0);
+	CU_ASSERT(thread_infos[2].lcore == 0);
+
+	g_scheduler_numa_aware = false;
+	g_scheduler_numa_cross_limit = 95;
+	g_reactor_state = SPDK_REACTOR_STATE_INITIALIZED;
+
+	/* Destroy threads */
+	for (i = 0; i < 3; i++) {
+		spdk_set_thread(thread[i]);
+		spdk_thread_exit(thread[i]);
+	}
+	for (i = 0; i < 3; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		reactor_run(reactor);
+	}
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 uint8_t g_curr_freq;
 
 static int
@@ -1085,6 +1316,192 @@ test_governor(void)
 	free_cores();
 }
 
+#define UT_MAX_FREQ	100
+#define UT_MIN_FREQ	10
+#define UT_FREQ_STEP	10
+
+static uint32_t g_core_freq[3];
+
+static uint32_t
+power_curr_freq(uint32_t lcore)
+{
+	return g_core_freq[lcore];
+}
+
+static int
+power_freq_up(uint32_t lcore)
+{
+	if (g_core_freq[lcore] == UT_MAX_FREQ) {
+		return 0;
+	}
+	g_core_freq[lcore] += UT_FREQ_STEP;
+
+	return 1;
+}
+
+static int
+power_freq_down(uint32_t lcore)
+{
+	if (g_core_freq[lcore] == UT_MIN_FREQ) {
+		return 0;
+	}
+	g_core_freq[lcore] -= UT_FREQ_STEP;
+
+	return 1;
+}
+
+static int
+power_freq_max(uint32_t lcore)
+{
+	g_core_freq[lcore] = UT_MAX_FREQ;
+
+	return 1;
+}
+
+static int
+power_freq_min(uint32_t lcore)
+{
+	g_core_freq[lcore] = UT_MIN_FREQ;
+
+	return 1;
+}
+
+static int
+power_caps(uint32_t lcore_id, struct spdk_governor_capabilities *capabilities)
+{
+	capabilities->max_freq = UT_MAX_FREQ;
+
+	return 0;
+}
+
+static struct spdk_governor power_governor = {
+	.name = "ut_power_governor",
+	.get_core_curr_freq = power_curr_freq,
+	.core_freq_up = power_freq_up,
+	.core_freq_down = power_freq_down,
+	.set_core_freq_max = power_freq_max,
+	.set_core_freq_min = power_freq_min,
+	.get_core_capabilities = power_caps,
+	.init = governor_init,
+	.deinit = governor_deinit,
+};
+
+/* Run the dynamic scheduler with one thread on each of the three cores, each 30% busy */
+static void
+ut_balance_spread(struct spdk_scheduler_core_info *cores_info,
+		  struct spdk_scheduler_thread_info *thread_infos)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		cores_info[i].thread_infos = &thread_infos[i];
+		cores_info[i].threads_count = 1;
+		cores_info[i].current_busy_tsc = 30;
+		cores_info[i].current_idle_tsc = 70;
+		thread_infos[i].lcore = i;
+		thread_infos[i].current_stats.busy_tsc = 30;
+		thread_infos[i].current_stats.idle_tsc = 70;
+		g_core_freq[i] = 50;
+	}
+
+	scheduler_dynamic.balance(cores_info, 3);
+}
+
+static void
+test_scheduler_power_aware(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread[3];
+	struct spdk_reactor *reactor;
+	struct spdk_scheduler_core_info cores_info[3] = {};
+	struct spdk_scheduler_thread_info thread_infos[3] = {};
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	spdk_governor_register(&power_governor);
+
+	allocate_cores(3);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_scheduler_set("dynamic");
+	CU_ASSERT(spdk_governor_set("ut_power_governor") == 0);
+
+	for (i = 0; i < 3; i++) {
+		spdk_cpuset_set_cpu(&g_reactor_core_mask, i, true);
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+	}
+
+	for (i = 0; i < 3; i++) {
+		thread[i] = spdk_thread_create(NULL, &cpuset);
+		SPDK_CU_ASSERT_FATAL(thread[i] != NULL);
+		thread_infos[i].thread_id = spdk_thread_get_id(thread[i]);
+	}
+
+	for (i = 0; i < 3; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		MOCK_SET(spdk_env_get_current_core, i);
+		event_queue_run_batch(reactor);
+	}
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	/* By default, cores are filled up to the core limit and only the main core's frequency
+	 * is managed */
+	ut_balance_spread(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 0);
+	CU_ASSERT(thread_infos[1].lcore == 0);
+	CU_ASSERT(thread_infos[2].lcore == 1);
+	CU_ASSERT(g_core_freq[0] == UT_MAX_FREQ);
+	CU_ASSERT(g_core_freq[1] == 50);
+	CU_ASSERT(g_core_freq[2] == 50);
+
+	/* In power aware mode, all threads are packed onto the main core running at the maximum
+	 * frequency, while the vacated cores are slowed down */
+	g_scheduler_power_aware = true;
+	ut_balance_spread(cores_info, thread_infos);
+	CU_ASSERT(thread_infos[0].lcore == 0);
+	CU_ASSERT(thread_infos[1].lcore == 0);
+	CU_ASSERT(thread_infos[2].lcore == 0);
+	CU_ASSERT(g_core_freq[0] == UT_MAX_FREQ);
+	CU_ASSERT(g_core_freq[1] == UT_MIN_FREQ);
+	CU_ASSERT(g_core_freq[2] == UT_MIN_FREQ);
+
+	/* Only the polling core counts towards the power cap */
+	g_scheduler_power_cap = 20;
+	ut_balance_spread(cores_info, thread_infos);
+	CU_ASSERT(g_core_freq[0] == 3 * UT_MAX_FREQ * 20 / 100);
+
+	/* Cores aren't slowed down below their minimum frequency if the cap can't be met */
+	g_scheduler_power_cap = 1;
+	ut_balance_spread(cores_info, thread_infos);
+	CU_ASSERT(g_core_freq[0] == UT_MIN_FREQ);
+
+	g_scheduler_power_cap = 0;
+	g_scheduler_power_aware = false;
+	g_reactor_state = SPDK_REACTOR_STATE_INITIALIZED;
+
+	/* Destroy threads */
+	for (i = 0; i < 3; i++) {
+		spdk_set_thread(thread[i]);
+		spdk_thread_exit(thread[i]);
+	}
+	for (i = 0; i < 3; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		reactor_run(reactor);
+	}
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1104,7 +1521,10 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_for_each_reactor);
 	CU_ADD_TEST(suite, test_reactor_stats);
 	CU_ADD_TEST(suite, test_scheduler);
+	CU_ADD_TEST(suite, test_scheduler_latency_aware);
+	CU_ADD_TEST(suite, test_scheduler_numa_aware);
 	CU_ADD_TEST(suite, test_governor);
+	CU_ADD_TEST(suite, test_scheduler_power_aware);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -91,6 +91,7 @@ DEFINE_STUB(ftl_nv_cache_chunks_busy, int, (struct ftl_nv_cache *nvc), true);
 DEFINE_STUB(ftl_nv_cache_full, bool, (struct ftl_nv_cache *nvc), true);
 DEFINE_STUB(ftl_l2p_is_halted, bool, (struct spdk_ftl_dev *dev), true);
 DEFINE_STUB(ftl_nv_cache_write, bool, (struct ftl_io *io), true);
+DEFINE_STUB(ftl_nv_cache_bypass_write, bool, (struct ftl_io *io), false);
 DEFINE_STUB_V(ftl_nv_cache_halt, (struct ftl_nv_cache *nvc));
 DEFINE_STUB_V(ftl_l2p_halt, (struct spdk_ftl_dev *dev));
 DEFINE_STUB(ftl_io_init, int, (struct spdk_io_channel *_ioch, struct ftl_io *io, uint64_t lba,
@@ -98,6 +99,15 @@ DEFINE_STUB(ftl_io_init, int, (struct spdk_io_channel *_ioch, struct ftl_io *io,
 			       struct iovec *iov, size_t iov_cnt, spdk_ftl_fn cb_fn, void *cb_ctx, int type), 0);
 DEFINE_STUB_V(ftl_mngt_next_step, (struct ftl_mngt_process *mngt));
 DEFINE_STUB_V(ftl_mngt_fail_step, (struct ftl_mngt_process *mngt));
+DEFINE_STUB_V(ftl_mngt_skip_step, (struct ftl_mngt_process *mngt));
+DEFINE_STUB_V(ftl_mngt_continue_step, (struct ftl_mngt_process *mngt));
+DEFINE_STUB(ftl_mngt_alloc_step_ctx, int, (struct ftl_mngt_process *mngt, size_t size), 0);
+DEFINE_STUB(ftl_mngt_get_step_ctx, void *, (struct ftl_mngt_process *mngt), NULL);
+DEFINE_STUB(spdk_bdev_get_max_open_zones, uint32_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_get_max_zone_append_size, uint32_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_get_zone_info, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		uint64_t zone_id, size_t num_zones, struct spdk_bdev_zone_info *info,
+		spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
 DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
 DEFINE_STUB(spdk_bdev_get_io_channel, struct spdk_io_channel *, (struct spdk_bdev_desc *bdev_desc),
 	    NULL);
@@ -119,7 +129,8 @@ DEFINE_STUB_V(ftl_l2p_pin, (struct spdk_ftl_dev *dev, uint64_t lba, uint64_t cou
 			    struct ftl_l2p_pin_ctx *pin_ctx));
 DEFINE_STUB_V(ftl_l2p_pin_skip, (struct spdk_ftl_dev *dev, ftl_l2p_pin_cb cb, void *cb_ctx,
 				 struct ftl_l2p_pin_ctx *pin_ctx));
-DEFINE_STUB(ftl_nv_cache_read, int, (struct ftl_io *io, ftl_addr addr, uint32_t num_blocks,
+DEFINE_STUB(ftl_nv_cache_read, int, (struct ftl_io *io, struct spdk_io_channel *ch,
+				     ftl_addr addr, uint32_t num_blocks,
 				     spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
 DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 		struct spdk_bdev_io_wait_entry *entry), 0);
@@ -129,12 +140,18 @@ DEFINE_STUB(ftl_writer_is_halted, bool, (struct ftl_writer *writer), true);
 DEFINE_STUB(ftl_mempool_claim_df, void *, (struct ftl_mempool *mpool, ftl_df_obj_id df_obj_id),
 	    NULL);
 DEFINE_STUB(ftl_bitmap_count_set, uint64_t, (struct ftl_bitmap *bitmap), 0);
+
+const size_t ftl_bitmap_buffer_alignment = sizeof(uint64_t);
 DEFINE_STUB(ftl_p2l_ckpt_region_type, enum ftl_layout_region_type,
 	    (const struct ftl_p2l_ckpt *ckpt), 0);
 DEFINE_STUB(ftl_md_get_buffer, void *, (struct ftl_md *md), NULL);
 DEFINE_STUB(ftl_md_get_vss_buffer, union ftl_md_vss *, (struct ftl_md *md), NULL);
 DEFINE_STUB(ftl_nv_cache_acquire_trim_seq_id, uint64_t, (struct ftl_nv_cache *nv_cache), 0);
 DEFINE_STUB_V(ftl_md_persist, (struct ftl_md *md));
+DEFINE_STUB_V(ftl_md_persist_entry, (struct ftl_md *md, uint64_t start_entry, void *buffer,
+				    void *vss_buffer, ftl_md_io_entry_cb cb, void *cb_arg,
+				    struct ftl_md_io_entry_ctx *ctx));
+DEFINE_STUB_V(ftl_band_free_empty, (struct spdk_ftl_dev *dev));
 DEFINE_STUB_V(spdk_bdev_io_get_nvme_status, (const struct spdk_bdev_io *bdev_io, uint32_t *cdw0,
 		int *sct, int *sc));
 DEFINE_STUB(ftl_nv_cache_throttle, bool, (struct spdk_ftl_dev *dev), true);
@@ -363,6 +380,61 @@ test_next_xfer_addr(void)
 	cleanup_band();
 }
 
+static void
+test_gc_pick_policy(void)
+{
+	struct ftl_superblock sb = {};
+	struct ftl_band *band;
+	uint64_t i, user_blocks;
+
+	g_dev = test_init_ftl_dev(&g_geo);
+	g_dev->sb = &sb;
+	g_dev->num_logical_bands_in_physical = 1;
+	for (i = 0; i < g_dev->num_bands; i++) {
+		band = &g_dev->bands[i];
+		band->dev = g_dev;
+		band->id = i;
+		band->phys_id = i;
+		band->md->state = FTL_BAND_STATE_FREE;
+	}
+
+	user_blocks = ftl_band_user_blocks(&g_dev->bands[0]);
+	sb.seq_id = 1000;
+
+	/* Band 1 holds the most invalid blocks, but it was closed just now */
+	band = &g_dev->bands[1];
+	band->md->state = FTL_BAND_STATE_CLOSED;
+	band->md->close_seq_id = 990;
+	band->p2l_map.num_valid = user_blocks / 2;
+
+	/* Band 3 holds less invalid blocks, which haven't been overwritten for a long time */
+	band = &g_dev->bands[3];
+	band->md->state = FTL_BAND_STATE_CLOSED;
+	band->md->close_seq_id = 100;
+	band->p2l_map.num_valid = user_blocks * 3 / 4;
+
+	/* Band 5 is the oldest one, but it has no invalid blocks */
+	band = &g_dev->bands[5];
+	band->md->state = FTL_BAND_STATE_CLOSED;
+	band->md->close_seq_id = 1;
+	band->p2l_map.num_valid = user_blocks;
+
+	CU_ASSERT_EQUAL(gc_pick_greedy(g_dev), 1);
+	CU_ASSERT_EQUAL(gc_pick_cost_benefit(g_dev), 3);
+
+	/* Once band 3 gets picked, the younger band comes next */
+	g_dev->bands[3].reloc = true;
+	CU_ASSERT_EQUAL(gc_pick_cost_benefit(g_dev), 1);
+
+	/* Bands under relocation aren't picked at all */
+	g_dev->bands[1].reloc = true;
+	CU_ASSERT_EQUAL(gc_pick_greedy(g_dev), FTL_BAND_PHYS_ID_INVALID);
+	CU_ASSERT_EQUAL(gc_pick_cost_benefit(g_dev), FTL_BAND_PHYS_ID_INVALID);
+
+	g_dev->sb = NULL;
+	test_free_ftl_dev(g_dev);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -380,6 +452,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_band_set_addr);
 	CU_ADD_TEST(suite, test_invalidate_addr);
 	CU_ADD_TEST(suite, test_next_xfer_addr);
+	CU_ADD_TEST(suite, test_gc_pick_policy);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -138,7 +138,7 @@ test_setup_sb_v3(uint64_t clean)
 	memset(&g_sb_buf, 0, sizeof(g_sb_buf));
 	ftl_mngt_init_default_sb(&g_dev, NULL);
 	sb->clean = clean;
-	sb->header.crc = get_sb_crc(sb);
+	sb->header.crc = ftl_superblock_get_crc(sb);
 }
 
 static void
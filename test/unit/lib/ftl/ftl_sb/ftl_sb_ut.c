@@ -96,7 +96,7 @@ test_setup_sb_ver(uint64_t ver, uint64_t clean)
 	sb->v2.clean = clean;
 	sb->v3.md_layout_head.type = 0;
 	sb->v3.md_layout_head.df_next = 0;
-	sb->header.crc = get_sb_crc(&sb->v3);
+	sb->header.crc = ftl_superblock_get_crc(&sb->v3);
 }
 
 static void
@@ -113,7 +113,7 @@ test_setup_sb_v3(uint64_t clean)
 	memset(&g_sb_buf, 0, sizeof(g_sb_buf));
 	ftl_mngt_init_default_sb(&g_dev, NULL);
 	sb->clean = clean;
-	sb->header.crc = get_sb_crc(sb);
+	sb->header.crc = ftl_superblock_get_crc(sb);
 }
 
 static void
@@ -127,15 +127,15 @@ test_sb_crc_v2(void)
 	crc = sb->header.crc;
 
 	sb->header.crc++;
-	sb->header.crc = get_sb_crc(&sb->v3);
+	sb->header.crc = ftl_superblock_get_crc(&sb->v3);
 	CU_ASSERT_EQUAL(crc, sb->header.crc);
 
 	g_sb_buf[sizeof(struct ftl_superblock_v2)]++;
-	sb->header.crc = get_sb_crc(&sb->v3);
+	sb->header.crc = ftl_superblock_get_crc(&sb->v3);
 	CU_ASSERT_EQUAL(crc, sb->header.crc);
 
 	g_sb_buf[sizeof(g_sb_buf) - 1]++;
-	sb->header.crc = get_sb_crc(&sb->v3);
+	sb->header.crc = ftl_superblock_get_crc(&sb->v3);
 	CU_ASSERT_EQUAL(crc, sb->header.crc);
 
 	sb->header.version += 0x19840514;
@@ -154,17 +154,17 @@ test_sb_crc_v3(void)
 	crc = sb->header.crc;
 
 	sb->header.crc++;
-	sb->header.crc = get_sb_crc(&sb->v3);
+	sb->header.crc = ftl_superblock_get_crc(&sb->v3);
 	CU_ASSERT_EQUAL(crc, sb->header.crc);
 	crc = sb->header.crc;
 
 	g_sb_buf[sizeof(struct ftl_superblock_v2)]++;
-	sb->header.crc = get_sb_crc(&sb->v3);
+	sb->header.crc = ftl_superblock_get_crc(&sb->v3);
 	CU_ASSERT_NOT_EQUAL(crc, sb->header.crc);
 	crc = sb->header.crc;
 
 	g_sb_buf[sizeof(g_sb_buf) - 1]++;
-	sb->header.crc = get_sb_crc(&sb->v3);
+	sb->header.crc = ftl_superblock_get_crc(&sb->v3);
 	CU_ASSERT_NOT_EQUAL(crc, sb->header.crc);
 	crc = sb->header.crc;
 
@@ -0,0 +1,261 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk_internal/cunit.h"
+#include "spdk_internal/mock.h"
+#include "common/lib/test_env.c"
+
+#include "idxd/idxd_huffman.c"
+
+SPDK_LOG_REGISTER_COMPONENT(idxd);
+
+struct ut_bit_reader {
+	const uint8_t	*buf;
+	uint32_t	pos;
+	uint32_t	num_bits;
+};
+
+static uint32_t
+ut_read_bits(struct ut_bit_reader *r, uint32_t num_bits)
+{
+	uint32_t value = 0, i;
+
+	for (i = 0; i < num_bits; i++, r->pos++) {
+		SPDK_CU_ASSERT_FATAL(r->pos < r->num_bits);
+		value |= ((r->buf[r->pos / 8] >> (r->pos % 8)) & 1) << i;
+	}
+
+	return value;
+}
+
+/* Decode a symbol bit by bit, walking the canonical code of each length */
+static uint32_t
+ut_read_symbol(struct ut_bit_reader *r, const uint8_t *lens, uint32_t num_syms)
+{
+	uint32_t code = 0, first = 0, len, sym, count;
+
+	for (len = 1; len <= HUFFMAN_MAX_BITS; len++) {
+		code |= ut_read_bits(r, 1);
+		count = 0;
+		for (sym = 0; sym < num_syms; sym++) {
+			if (lens[sym] != len) {
+				continue;
+			}
+			if (code - first == count) {
+				return sym;
+			}
+			count++;
+		}
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+
+	CU_FAIL("invalid code");
+	return UINT32_MAX;
+}
+
+/* Parse the dynamic block header written to the AECS and return the code lengths it describes */
+static void
+ut_parse_header(const struct iaa_aecs *aecs, uint8_t *ll_lens, uint8_t *d_lens)
+{
+	struct ut_bit_reader r = {
+		.buf = aecs->output_accum,
+		.num_bits = aecs->num_output_accum_bits,
+	};
+	uint8_t cl_lens[CL_SYMBOLS] = {};
+	uint8_t lens[SPDK_IDXD_HUFFMAN_LL_SYMBOLS + SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+	uint32_t num_ll, num_d, num_cl, i, sym, repeat;
+
+	CU_ASSERT_EQUAL(ut_read_bits(&r, 1), 1);
+	CU_ASSERT_EQUAL(ut_read_bits(&r, 2), DEFLATE_BTYPE_DYNAMIC);
+	num_ll = ut_read_bits(&r, 5) + 257;
+	num_d = ut_read_bits(&r, 5) + 1;
+	num_cl = ut_read_bits(&r, 4) + 4;
+	SPDK_CU_ASSERT_FATAL(num_ll <= SPDK_IDXD_HUFFMAN_LL_SYMBOLS);
+	SPDK_CU_ASSERT_FATAL(num_d <= SPDK_IDXD_HUFFMAN_D_SYMBOLS);
+
+	for (i = 0; i < num_cl; i++) {
+		cl_lens[g_cl_order[i]] = ut_read_bits(&r, 3);
+	}
+
+	i = 0;
+	while (i < num_ll + num_d) {
+		sym = ut_read_symbol(&r, cl_lens, CL_SYMBOLS);
+		switch (sym) {
+		case CL_REPEAT_PREV:
+			SPDK_CU_ASSERT_FATAL(i > 0);
+			repeat = ut_read_bits(&r, 2) + 3;
+			sym = lens[i - 1];
+			break;
+		case CL_REPEAT_ZERO_SHORT:
+			repeat = ut_read_bits(&r, 3) + 3;
+			sym = 0;
+			break;
+		case CL_REPEAT_ZERO_LONG:
+			repeat = ut_read_bits(&r, 7) + 11;
+			sym = 0;
+			break;
+		default:
+			SPDK_CU_ASSERT_FATAL(sym < 16);
+			repeat = 1;
+			break;
+		}
+		SPDK_CU_ASSERT_FATAL(i + repeat <= num_ll + num_d);
+		memset(&lens[i], sym, repeat);
+		i += repeat;
+	}
+
+	/* The whole header must have been consumed */
+	CU_ASSERT_EQUAL(r.pos, r.num_bits);
+
+	memset(ll_lens, 0, SPDK_IDXD_HUFFMAN_LL_SYMBOLS);
+	memset(d_lens, 0, SPDK_IDXD_HUFFMAN_D_SYMBOLS);
+	memcpy(ll_lens, lens, num_ll);
+	memcpy(d_lens, &lens[num_ll], num_d);
+}
+
+/* Verify the table against the header describing it and check that the codes are valid */
+static void
+ut_check_table(const struct spdk_idxd_huffman_table *table,
+	       const struct spdk_idxd_huffman_histogram *hist, bool complete)
+{
+	uint8_t ll_lens[SPDK_IDXD_HUFFMAN_LL_SYMBOLS], d_lens[SPDK_IDXD_HUFFMAN_D_SYMBOLS];
+	uint32_t i, len, kraft = 0, num_d = 0;
+
+	ut_parse_header(table->aecs, ll_lens, d_lens);
+
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_LL_SYMBOLS; i++) {
+		len = table->aecs->ll_sym[i] >> AECS_SYM_LEN_SHIFT;
+		CU_ASSERT_EQUAL(len, ll_lens[i]);
+		CU_ASSERT(len <= HUFFMAN_MAX_BITS);
+		if (complete || hist->ll[i] != 0 || i == DEFLATE_EOB) {
+			CU_ASSERT(len != 0);
+		} else {
+			CU_ASSERT_EQUAL(len, 0);
+		}
+		if (len != 0) {
+			kraft += 1u << (HUFFMAN_MAX_BITS - len);
+		}
+	}
+	/* The code must be complete, unless it has a single symbol */
+	CU_ASSERT(kraft == 1u << HUFFMAN_MAX_BITS || kraft == 1u << (HUFFMAN_MAX_BITS - 1));
+
+	kraft = 0;
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_D_SYMBOLS; i++) {
+		len = table->aecs->d_sym[i] >> AECS_SYM_LEN_SHIFT;
+		CU_ASSERT_EQUAL(len, d_lens[i]);
+		CU_ASSERT(len <= HUFFMAN_MAX_BITS);
+		CU_ASSERT_EQUAL(len != 0, complete || hist->d[i] != 0);
+		if (len != 0) {
+			kraft += 1u << (HUFFMAN_MAX_BITS - len);
+			num_d++;
+		}
+	}
+	if (num_d > 1) {
+		CU_ASSERT_EQUAL(kraft, 1u << HUFFMAN_MAX_BITS);
+	}
+}
+
+static void
+test_huffman_table_build(void)
+{
+	struct spdk_idxd_huffman_table *table;
+	struct spdk_idxd_huffman_histogram hist = {};
+	uint32_t i;
+	int rc;
+
+	table = spdk_idxd_huffman_table_alloc();
+	SPDK_CU_ASSERT_FATAL(table != NULL);
+
+	/* Skewed distribution of literals, lengths and distances */
+	for (i = 'a'; i <= 'z'; i++) {
+		hist.ll[i] = 1000 / (i - 'a' + 1);
+	}
+	hist.ll[' '] = 800;
+	for (i = 257; i < 270; i++) {
+		hist.ll[i] = 50 - 3 * (i - 257);
+	}
+	for (i = 0; i < 20; i += 2) {
+		hist.d[i] = 20 - i;
+	}
+
+	rc = spdk_idxd_huffman_table_build(table, &hist, false);
+	CU_ASSERT_EQUAL(rc, 0);
+	ut_check_table(table, &hist, false);
+	/* The most frequent literal can't have a longer code than a less frequent one */
+	CU_ASSERT((table->aecs->ll_sym['a'] >> AECS_SYM_LEN_SHIFT) <=
+		  (table->aecs->ll_sym['z'] >> AECS_SYM_LEN_SHIFT));
+
+	/* Canned tables need a code for each symbol */
+	rc = spdk_idxd_huffman_table_build(table, &hist, true);
+	CU_ASSERT_EQUAL(rc, 0);
+	ut_check_table(table, &hist, true);
+
+	/* Frequencies differing by orders of magnitude exceed the length limit, which needs to
+	 * be enforced */
+	memset(&hist, 0, sizeof(hist));
+	for (i = 0; i < 32; i++) {
+		hist.ll[i] = 1u << i;
+	}
+	rc = spdk_idxd_huffman_table_build(table, &hist, false);
+	CU_ASSERT_EQUAL(rc, 0);
+	ut_check_table(table, &hist, false);
+
+	/* Empty buffer - only the end of block is needed and no distances */
+	memset(&hist, 0, sizeof(hist));
+	rc = spdk_idxd_huffman_table_build(table, &hist, false);
+	CU_ASSERT_EQUAL(rc, 0);
+	ut_check_table(table, &hist, false);
+	CU_ASSERT_EQUAL(table->aecs->ll_sym[DEFLATE_EOB] >> AECS_SYM_LEN_SHIFT, 1);
+
+	spdk_idxd_huffman_table_free(table);
+}
+
+static void
+test_huffman_table_get_histogram(void)
+{
+	struct spdk_idxd_huffman_table *table;
+	struct spdk_idxd_huffman_histogram hist;
+	uint32_t i;
+
+	table = spdk_idxd_huffman_table_alloc();
+	SPDK_CU_ASSERT_FATAL(table != NULL);
+
+	/* Emulate the hardware writing the statistics */
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_LL_SYMBOLS; i++) {
+		table->aecs->ll_sym[i] = i * 3;
+	}
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_D_SYMBOLS; i++) {
+		table->aecs->d_sym[i] = i + 7;
+	}
+
+	spdk_idxd_huffman_table_get_histogram(table, &hist);
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_LL_SYMBOLS; i++) {
+		CU_ASSERT_EQUAL(hist.ll[i], i * 3);
+	}
+	for (i = 0; i < SPDK_IDXD_HUFFMAN_D_SYMBOLS; i++) {
+		CU_ASSERT_EQUAL(hist.d[i], i + 7);
+	}
+
+	spdk_idxd_huffman_table_free(table);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("idxd_huffman", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_huffman_table_build);
+	CU_ADD_TEST(suite, test_huffman_table_get_histogram);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+	return num_failures;
+}
@@ -0,0 +1,588 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_internal/cunit.h"
+
+#include "common/lib/ut_multithread.c"
+#include "init/json_config.c"
+
+#define UT_MAX_REQUESTS 32
+
+DEFINE_STUB_V(spdk_rpc_finish, (void));
+DEFINE_STUB(spdk_rpc_initialize, int, (const char *listen_addr,
+				       const struct spdk_rpc_opts *opts), 0);
+
+/* Client connected to the config socket, executes one request at a time */
+struct spdk_jsonrpc_client {
+	/* Index into g_requests of the request being executed, -1 if idle */
+	int request;
+	bool response_ready;
+	struct spdk_json_val error;
+	struct spdk_jsonrpc_client_response resp;
+};
+
+struct spdk_jsonrpc_client_request {
+	char buf[1024];
+	size_t len;
+};
+
+/* Request received by one of the clients */
+struct ut_request {
+	/* Value of the "name" or "nqn" param, method name if there's no such param */
+	char name[64];
+	struct spdk_jsonrpc_client *client;
+	bool completed;
+};
+
+static struct ut_request g_requests[UT_MAX_REQUESTS];
+static int g_num_requests;
+static uint32_t g_rpc_state;
+static bool g_subsystem_init_called;
+static bool g_load_done;
+static int g_load_rc;
+
+struct spdk_jsonrpc_client *
+spdk_jsonrpc_client_connect(const char *addr, int addr_family)
+{
+	struct spdk_jsonrpc_client *client;
+
+	client = calloc(1, sizeof(*client));
+	SPDK_CU_ASSERT_FATAL(client != NULL);
+	client->request = -1;
+
+	return client;
+}
+
+void
+spdk_jsonrpc_client_close(struct spdk_jsonrpc_client *client)
+{
+	free(client);
+}
+
+int
+spdk_jsonrpc_client_poll(struct spdk_jsonrpc_client *client, int timeout)
+{
+	return client->response_ready ? 1 : 0;
+}
+
+struct spdk_jsonrpc_client_response *
+spdk_jsonrpc_client_get_response(struct spdk_jsonrpc_client *client)
+{
+	SPDK_CU_ASSERT_FATAL(client->response_ready);
+	client->response_ready = false;
+	client->request = -1;
+
+	return &client->resp;
+}
+
+void
+spdk_jsonrpc_client_free_response(struct spdk_jsonrpc_client_response *resp)
+{
+}
+
+struct spdk_jsonrpc_client_request *
+spdk_jsonrpc_client_create_request(void)
+{
+	return calloc(1, sizeof(struct spdk_jsonrpc_client_request));
+}
+
+void
+spdk_jsonrpc_client_free_request(struct spdk_jsonrpc_client_request *req)
+{
+	free(req);
+}
+
+static int
+ut_request_write_cb(void *cb_ctx, const void *data, size_t size)
+{
+	struct spdk_jsonrpc_client_request *request = cb_ctx;
+
+	SPDK_CU_ASSERT_FATAL(request->len + size < sizeof(request->buf));
+	memcpy(request->buf + request->len, data, size);
+	request->len += size;
+
+	return 0;
+}
+
+struct spdk_json_write_ctx *
+spdk_jsonrpc_begin_request(struct spdk_jsonrpc_client_request *request, int32_t id,
+			   const char *method)
+{
+	struct spdk_json_write_ctx *w;
+
+	w = spdk_json_write_begin(ut_request_write_cb, request, 0);
+	SPDK_CU_ASSERT_FATAL(w != NULL);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_int32(w, "id", id);
+
+	return w;
+}
+
+void
+spdk_jsonrpc_end_request(struct spdk_jsonrpc_client_request *request,
+			 struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_object_end(w);
+	spdk_json_write_end(w);
+}
+
+static void
+ut_json_copy_string(char *buf, size_t size, const struct spdk_json_val *val)
+{
+	SPDK_CU_ASSERT_FATAL(val->len < size);
+	memcpy(buf, val->start, val->len);
+	buf[val->len] = '\0';
+}
+
+int
+spdk_jsonrpc_client_send_request(struct spdk_jsonrpc_client *client,
+				 struct spdk_jsonrpc_client_request *req)
+{
+	struct spdk_json_val values[64], *method, *params, *name;
+	struct ut_request *ut_req;
+	ssize_t rc;
+
+	/* The loader executes a single request per connection */
+	CU_ASSERT(client->request == -1);
+	SPDK_CU_ASSERT_FATAL(g_num_requests < UT_MAX_REQUESTS);
+
+	rc = spdk_json_parse(req->buf, req->len, values, SPDK_COUNTOF(values), NULL, 0);
+	SPDK_CU_ASSERT_FATAL(rc > 0);
+
+	ut_req = &g_requests[g_num_requests];
+	rc = spdk_json_find(values, "method", NULL, &method, SPDK_JSON_VAL_STRING);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	ut_json_copy_string(ut_req->name, sizeof(ut_req->name), method);
+
+	if (spdk_json_find(values, "params", NULL, &params, SPDK_JSON_VAL_OBJECT_BEGIN) == 0) {
+		if (spdk_json_find(params, "name", NULL, &name, SPDK_JSON_VAL_STRING) == 0 ||
+		    spdk_json_find(params, "nqn", NULL, &name, SPDK_JSON_VAL_STRING) == 0) {
+			ut_json_copy_string(ut_req->name, sizeof(ut_req->name), name);
+		}
+	}
+
+	ut_req->client = client;
+	ut_req->completed = false;
+	client->request = g_num_requests++;
+	free(req);
+
+	return 0;
+}
+
+int
+spdk_rpc_get_method_state_mask(const char *method, uint32_t *state_mask)
+{
+	if (strcmp(method, "ut_unknown") == 0) {
+		return -ENOENT;
+	}
+
+	if (strncmp(method, "ut_startup", strlen("ut_startup")) == 0) {
+		*state_mask = SPDK_RPC_STARTUP;
+	} else {
+		*state_mask = SPDK_RPC_RUNTIME;
+	}
+
+	return 0;
+}
+
+uint32_t
+spdk_rpc_get_state(void)
+{
+	return g_rpc_state;
+}
+
+void
+spdk_rpc_set_state(uint32_t state)
+{
+	g_rpc_state = state;
+}
+
+static int
+ut_num_inflight(void)
+{
+	int i, num = 0;
+
+	for (i = 0; i < g_num_requests; i++) {
+		num += !g_requests[i].completed;
+	}
+
+	return num;
+}
+
+void
+spdk_subsystem_init(spdk_subsystem_init_fn cb_fn, void *cb_arg)
+{
+	/* All the startup methods have completed */
+	CU_ASSERT(ut_num_inflight() == 0);
+	g_subsystem_init_called = true;
+	cb_fn(0, cb_arg);
+}
+
+static void
+ut_poll(void)
+{
+	spdk_delay_us(100);
+	poll_threads();
+}
+
+static void
+ut_load_done(int rc, void *ctx)
+{
+	g_load_done = true;
+	g_load_rc = rc;
+}
+
+static void
+ut_load(const char *config, uint32_t max_parallel, bool stop_on_error)
+{
+	char path[] = "/tmp/json_config_ut.XXXXXX";
+	int fd;
+
+	g_num_requests = 0;
+	g_rpc_state = SPDK_RPC_STARTUP;
+	g_subsystem_init_called = false;
+	g_load_done = false;
+	g_load_rc = 0;
+
+	fd = mkstemp(path);
+	SPDK_CU_ASSERT_FATAL(fd >= 0);
+	SPDK_CU_ASSERT_FATAL(write(fd, config, strlen(config)) == (ssize_t)strlen(config));
+	close(fd);
+
+	spdk_subsystem_init_from_json_config_ext(path, "/var/tmp/json_config_ut.sock",
+						 max_parallel, ut_load_done, NULL, stop_on_error);
+	unlink(path);
+
+	/* Connect the clients and send the first entries */
+	ut_poll();
+	ut_poll();
+}
+
+/* Check that the request for the given object has been sent and hasn't completed yet */
+static bool
+ut_inflight(const char *name)
+{
+	int i;
+
+	for (i = 0; i < g_num_requests; i++) {
+		if (strcmp(g_requests[i].name, name) == 0) {
+			return !g_requests[i].completed;
+		}
+	}
+
+	return false;
+}
+
+static bool
+ut_sent(const char *name)
+{
+	int i;
+
+	for (i = 0; i < g_num_requests; i++) {
+		if (strcmp(g_requests[i].name, name) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+ut_complete(const char *name, bool error)
+{
+	struct spdk_jsonrpc_client *client;
+	int i;
+
+	for (i = 0; i < g_num_requests; i++) {
+		if (strcmp(g_requests[i].name, name) == 0 && !g_requests[i].completed) {
+			break;
+		}
+	}
+
+	SPDK_CU_ASSERT_FATAL(i < g_num_requests);
+	client = g_requests[i].client;
+	g_requests[i].completed = true;
+
+	memset(&client->resp, 0, sizeof(client->resp));
+	if (error) {
+		client->error.type = SPDK_JSON_VAL_STRING;
+		client->error.start = "error";
+		client->error.len = strlen("error");
+		client->resp.error = &client->error;
+	}
+	client->response_ready = true;
+
+	ut_poll();
+	ut_poll();
+}
+
+static void
+test_load_sequential(void)
+{
+	const char *config =
+		"{\"subsystems\": [{\"subsystem\": \"bdev\", \"config\": ["
+		"{\"method\": \"ut_startup_opts\", \"params\": {\"pool_size\": 1024}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc0\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc1\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc2\"}}"
+		"]}]}";
+
+	ut_load(config, 1, true);
+
+	/* Startup methods run before the subsystems are initialized */
+	CU_ASSERT(ut_inflight("ut_startup_opts"));
+	CU_ASSERT(!g_subsystem_init_called);
+	CU_ASSERT(ut_num_inflight() == 1);
+	ut_complete("ut_startup_opts", false);
+	CU_ASSERT(g_subsystem_init_called);
+	CU_ASSERT(g_rpc_state == SPDK_RPC_RUNTIME);
+
+	/* A single connection executes the entries one by one, in the config order */
+	CU_ASSERT(ut_inflight("Malloc0"));
+	CU_ASSERT(ut_num_inflight() == 1);
+	ut_complete("Malloc0", false);
+	CU_ASSERT(ut_inflight("Malloc1"));
+	CU_ASSERT(ut_num_inflight() == 1);
+	ut_complete("Malloc1", false);
+	CU_ASSERT(ut_inflight("Malloc2"));
+	CU_ASSERT(ut_num_inflight() == 1);
+	CU_ASSERT(!g_load_done);
+	ut_complete("Malloc2", false);
+
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == 0);
+	CU_ASSERT(g_num_requests == 4);
+}
+
+static void
+test_load_parallel(void)
+{
+	const char *config =
+		"{\"subsystems\": [{\"subsystem\": \"bdev\", \"config\": ["
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc0\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc1\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc2\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc3\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc4\"}}"
+		"]}]}";
+
+	ut_load(config, 4, true);
+
+	/* Independent entries use all the connections */
+	CU_ASSERT(g_subsystem_init_called);
+	CU_ASSERT(ut_num_inflight() == 4);
+	CU_ASSERT(ut_inflight("Malloc0"));
+	CU_ASSERT(ut_inflight("Malloc3"));
+	CU_ASSERT(!ut_sent("Malloc4"));
+
+	/* Any completion frees a connection for the next entry */
+	ut_complete("Malloc2", false);
+	CU_ASSERT(ut_inflight("Malloc4"));
+	CU_ASSERT(ut_num_inflight() == 4);
+
+	ut_complete("Malloc4", false);
+	ut_complete("Malloc0", false);
+	ut_complete("Malloc3", false);
+	CU_ASSERT(!g_load_done);
+	ut_complete("Malloc1", false);
+
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == 0);
+
+	/* The number of connections is limited */
+	ut_load(config, JSON_CONFIG_MAX_PARALLEL + 1, true);
+	CU_ASSERT(ut_num_inflight() == 5);
+	ut_complete("Malloc0", false);
+	ut_complete("Malloc1", false);
+	ut_complete("Malloc2", false);
+	ut_complete("Malloc3", false);
+	ut_complete("Malloc4", false);
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == 0);
+}
+
+static void
+test_load_dependencies(void)
+{
+	const char *config =
+		"{\"subsystems\": [{\"subsystem\": \"bdev\", \"config\": ["
+		"{\"method\": \"ut_attach\", \"params\": {\"name\": \"Nvme0\", "
+		"\"trtype\": \"TCP\", \"traddr\": \"127.0.0.1\", \"subnqn\": \"nqn.0\"}},"
+		"{\"method\": \"ut_attach\", \"params\": {\"name\": \"Nvme1\", "
+		"\"trtype\": \"TCP\", \"traddr\": \"127.0.0.1\", \"subnqn\": \"nqn.1\"}},"
+		"{\"method\": \"ut_passthru\", \"params\": {\"name\": \"Pass0\", "
+		"\"base_bdev_name\": \"Nvme0n1\"}},"
+		"{\"method\": \"ut_passthru\", \"params\": {\"name\": \"Pass1\", "
+		"\"base_bdev_name\": \"Pass0\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc0\"}}"
+		"]}]}";
+
+	ut_load(config, 4, true);
+
+	/*
+	 * Controllers sharing the transport params don't depend on each other. Pass0 is built
+	 * on a namespace of Nvme0 and Pass1 on Pass0, so both wait, while Malloc0 can go ahead.
+	 */
+	CU_ASSERT(ut_inflight("Nvme0"));
+	CU_ASSERT(ut_inflight("Nvme1"));
+	CU_ASSERT(ut_inflight("Malloc0"));
+	CU_ASSERT(!ut_sent("Pass0"));
+	CU_ASSERT(!ut_sent("Pass1"));
+
+	ut_complete("Malloc0", false);
+	ut_complete("Nvme1", false);
+	CU_ASSERT(!ut_sent("Pass0"));
+	CU_ASSERT(!ut_sent("Pass1"));
+
+	/* Pass1 still depends on Pass0 */
+	ut_complete("Nvme0", false);
+	CU_ASSERT(ut_inflight("Pass0"));
+	CU_ASSERT(!ut_sent("Pass1"));
+
+	ut_complete("Pass0", false);
+	CU_ASSERT(ut_inflight("Pass1"));
+	ut_complete("Pass1", false);
+
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == 0);
+}
+
+static void
+test_load_barrier(void)
+{
+	const char *config =
+		"{\"subsystems\": [{\"subsystem\": \"bdev\", \"config\": ["
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc0\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc1\"}},"
+		"{\"method\": \"ut_wait_for_examine\"},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc2\"}}"
+		"]}]}";
+
+	ut_load(config, 4, true);
+
+	/* Entries without an object name wait for everything before them */
+	CU_ASSERT(ut_inflight("Malloc0"));
+	CU_ASSERT(ut_inflight("Malloc1"));
+	CU_ASSERT(!ut_sent("ut_wait_for_examine"));
+	CU_ASSERT(!ut_sent("Malloc2"));
+
+	ut_complete("Malloc1", false);
+	CU_ASSERT(!ut_sent("ut_wait_for_examine"));
+	ut_complete("Malloc0", false);
+
+	/* And nothing after them starts before they complete */
+	CU_ASSERT(ut_inflight("ut_wait_for_examine"));
+	CU_ASSERT(!ut_sent("Malloc2"));
+	ut_complete("ut_wait_for_examine", false);
+	CU_ASSERT(ut_inflight("Malloc2"));
+	ut_complete("Malloc2", false);
+
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == 0);
+}
+
+static void
+test_load_subsystems_order(void)
+{
+	const char *config =
+		"{\"subsystems\": ["
+		"{\"subsystem\": \"bdev\", \"config\": ["
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc0\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc1\"}}"
+		"]},"
+		"{\"subsystem\": \"nvmf\", \"config\": ["
+		"{\"method\": \"ut_create_subsystem\", \"params\": {\"nqn\": \"nqn.0\"}},"
+		"{\"method\": \"ut_create_subsystem\", \"params\": {\"nqn\": \"nqn.1\"}}"
+		"]}]}";
+
+	ut_load(config, 4, true);
+
+	/* Subsystems are configured one after another */
+	CU_ASSERT(ut_inflight("Malloc0"));
+	CU_ASSERT(ut_inflight("Malloc1"));
+	CU_ASSERT(!ut_sent("nqn.0"));
+
+	ut_complete("Malloc0", false);
+	CU_ASSERT(!ut_sent("nqn.0"));
+	ut_complete("Malloc1", false);
+	CU_ASSERT(ut_inflight("nqn.0"));
+	CU_ASSERT(ut_inflight("nqn.1"));
+
+	ut_complete("nqn.1", false);
+	ut_complete("nqn.0", false);
+
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == 0);
+}
+
+static void
+test_load_errors(void)
+{
+	const char *config =
+		"{\"subsystems\": [{\"subsystem\": \"bdev\", \"config\": ["
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc0\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc1\"}},"
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc2\"}}"
+		"]}]}";
+	const char *config_unknown =
+		"{\"subsystems\": [{\"subsystem\": \"bdev\", \"config\": ["
+		"{\"method\": \"ut_create\", \"params\": {\"name\": \"Malloc0\"}},"
+		"{\"method\": \"ut_unknown\"}"
+		"]}]}";
+
+	/* A failed entry stops the load, the ones in progress are abandoned */
+	ut_load(config, 2, true);
+	CU_ASSERT(ut_num_inflight() == 2);
+	ut_complete("Malloc1", true);
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == -EINVAL);
+	CU_ASSERT(!ut_sent("Malloc2"));
+
+	/* Unless the errors are ignored */
+	ut_load(config, 2, false);
+	ut_complete("Malloc1", true);
+	CU_ASSERT(!g_load_done);
+	CU_ASSERT(ut_inflight("Malloc2"));
+	ut_complete("Malloc0", false);
+	ut_complete("Malloc2", false);
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == 0);
+
+	/* An unknown method is found before anything is sent */
+	ut_load(config_unknown, 2, true);
+	CU_ASSERT(g_load_done);
+	CU_ASSERT(g_load_rc == -ENOENT);
+	CU_ASSERT(g_num_requests == 0);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("json_config", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_load_sequential);
+	CU_ADD_TEST(suite, test_load_parallel);
+	CU_ADD_TEST(suite, test_load_dependencies);
+	CU_ADD_TEST(suite, test_load_barrier);
+	CU_ADD_TEST(suite, test_load_subsystems_order);
+	CU_ADD_TEST(suite, test_load_errors);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
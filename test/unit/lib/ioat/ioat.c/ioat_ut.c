@@ -97,6 +97,78 @@ ioat_state_check(void)
 	CU_ASSERT(is_ioat_halted(7) == 0); /* reserved */
 }
 
+static void
+ut_copy_done(void *cb_arg)
+{
+}
+
+static void
+ioat_build_copyv(void)
+{
+	struct spdk_ioat_chan ioat = {};
+	struct ioat_descriptor ring[8] = {};
+	union spdk_ioat_hw_desc hw_ring[8] = {};
+	uint8_t src[48], dst[48];
+	struct iovec siov[2] = {
+		{ .iov_base = src, .iov_len = 40 },
+		{ .iov_base = src + 40, .iov_len = 8 },
+	};
+	struct iovec diov[2] = {
+		{ .iov_base = dst, .iov_len = 8 },
+		{ .iov_base = dst + 8, .iov_len = 40 },
+	};
+	int rc, i;
+
+	ioat.ring = ring;
+	ioat.hw_ring = hw_ring;
+	ioat.ring_size_order = 3;
+	ioat.max_xfer_size = 16;
+
+	/* The 32 bytes in the middle are split to fit max_xfer_size */
+	rc = spdk_ioat_build_copyv(&ioat, &ioat, ut_copy_done, diov, 2, siov, 2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ioat.head == 4);
+	CU_ASSERT(hw_ring[0].dma.src_addr == (uintptr_t)src);
+	CU_ASSERT(hw_ring[0].dma.dest_addr == (uintptr_t)dst);
+	CU_ASSERT(hw_ring[0].dma.size == 8);
+	CU_ASSERT(hw_ring[1].dma.src_addr == (uintptr_t)src + 8);
+	CU_ASSERT(hw_ring[1].dma.dest_addr == (uintptr_t)dst + 8);
+	CU_ASSERT(hw_ring[1].dma.size == 16);
+	CU_ASSERT(hw_ring[2].dma.src_addr == (uintptr_t)src + 24);
+	CU_ASSERT(hw_ring[2].dma.dest_addr == (uintptr_t)dst + 24);
+	CU_ASSERT(hw_ring[2].dma.size == 16);
+	CU_ASSERT(hw_ring[3].dma.src_addr == (uintptr_t)src + 40);
+	CU_ASSERT(hw_ring[3].dma.dest_addr == (uintptr_t)dst + 40);
+	CU_ASSERT(hw_ring[3].dma.size == 8);
+
+	/* Only the last descriptor completes the request */
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(ring[i].callback_fn == NULL);
+	}
+	CU_ASSERT(ring[3].callback_fn == ut_copy_done);
+	CU_ASSERT(ring[3].callback_arg == &ioat);
+
+	/* Not enough room left in the ring, nothing is built */
+	rc = spdk_ioat_build_copyv(&ioat, &ioat, ut_copy_done, diov, 2, siov, 2);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(ioat.head == 4);
+
+	/* A translation failure doesn't leave partial requests behind either */
+	ioat.tail = ioat.head;
+	MOCK_SET(spdk_vtophys, SPDK_VTOPHYS_ERROR);
+	rc = spdk_ioat_build_copyv(&ioat, &ioat, ut_copy_done, diov, 2, siov, 2);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(ioat.head == 4);
+	MOCK_CLEAR(spdk_vtophys);
+
+	/* An empty copy still gets a descriptor to complete it */
+	rc = spdk_ioat_build_copyv(&ioat, &ioat, ut_copy_done, diov, 0, siov, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ioat.head == 5);
+	CU_ASSERT(hw_ring[4].dma.u.control.null == 1);
+	CU_ASSERT(ring[4].callback_fn == ut_copy_done);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -108,6 +180,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("ioat", NULL, NULL);
 
 	CU_ADD_TEST(suite, ioat_state_check);
+	CU_ADD_TEST(suite, ioat_build_copyv);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
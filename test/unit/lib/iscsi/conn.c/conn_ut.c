@@ -24,6 +24,9 @@ DEFINE_STUB(iscsi_param_eq_val, int,
 DEFINE_STUB(iscsi_pdu_calc_data_digest, uint32_t, (struct spdk_iscsi_pdu *pdu), 0);
 DEFINE_STUB_V(spdk_sock_writev_async,
 	      (struct spdk_sock *sock, struct spdk_sock_request *req));
+DEFINE_STUB(spdk_accel_submit_crc32cv, int,
+	    (struct spdk_io_channel *ch, uint32_t *crc_dst, struct iovec *iovs, uint32_t iovcnt,
+	     uint32_t seed, spdk_accel_completion_cb cb_fn, void *cb_arg), 0);
 
 struct spdk_scsi_lun {
 	uint8_t reserved;
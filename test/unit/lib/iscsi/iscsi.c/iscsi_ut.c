@@ -2587,6 +2587,72 @@ immediate_data_and_data_out_pdu_sequence_test(void)
 	free(mobj.buf);
 }
 
+static void
+update_cmdsn_mcs_test(void)
+{
+	struct spdk_iscsi_sess sess = {};
+	struct spdk_iscsi_conn conn = {};
+	struct spdk_iscsi_pdu pdu = {};
+	struct iscsi_bhs_scsi_req *reqh;
+	int rc;
+
+	sess.session_type = SESSION_TYPE_NORMAL;
+	sess.connections = 2;
+	sess.ExpCmdSN = 10;
+	sess.MaxCmdSN = 20;
+	pthread_mutex_init(&sess.mutex, NULL);
+	conn.sess = &sess;
+
+	pdu.bhs.opcode = ISCSI_OP_SCSI;
+	reqh = (struct iscsi_bhs_scsi_req *)&pdu.bhs;
+
+	/* Case 1 - CmdSN 11 and 12 received on another connection before CmdSN 10 */
+	to_be32(&reqh->cmd_sn, 12);
+	rc = iscsi_update_cmdsn(&conn, &pdu);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sess.ExpCmdSN == 10);
+
+	to_be32(&reqh->cmd_sn, 11);
+	rc = iscsi_update_cmdsn(&conn, &pdu);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sess.ExpCmdSN == 10);
+
+	/* Case 2 - Immediate command ahead of the commands in flight is accepted */
+	reqh->immediate = 1;
+	to_be32(&reqh->cmd_sn, 13);
+	rc = iscsi_update_cmdsn(&conn, &pdu);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sess.ExpCmdSN == 10);
+	reqh->immediate = 0;
+
+	/* Case 3 - Receiving CmdSN 10 fills the gap */
+	to_be32(&reqh->cmd_sn, 10);
+	rc = iscsi_update_cmdsn(&conn, &pdu);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sess.ExpCmdSN == 13);
+
+	/* Case 4 - CmdSN outside of the window is still fatal */
+	to_be32(&reqh->cmd_sn, 21);
+	rc = iscsi_update_cmdsn(&conn, &pdu);
+	CU_ASSERT(rc == SPDK_PDU_FATAL);
+	CU_ASSERT(sess.ExpCmdSN == 13);
+
+	/* Case 5 - Window wraps around ISCSI_CMDSN_WINDOW_SIZE and 32 bits */
+	sess.ExpCmdSN = UINT32_MAX;
+	sess.MaxCmdSN = 20;
+	to_be32(&reqh->cmd_sn, 0);
+	rc = iscsi_update_cmdsn(&conn, &pdu);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sess.ExpCmdSN == UINT32_MAX);
+
+	to_be32(&reqh->cmd_sn, UINT32_MAX);
+	rc = iscsi_update_cmdsn(&conn, &pdu);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sess.ExpCmdSN == 1);
+
+	pthread_mutex_destroy(&sess.mutex);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -2621,6 +2687,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, pdu_payload_read_test);
 	CU_ADD_TEST(suite, data_out_pdu_sequence_test);
 	CU_ADD_TEST(suite, immediate_data_and_data_out_pdu_sequence_test);
+	CU_ADD_TEST(suite, update_cmdsn_mcs_test);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -872,6 +872,89 @@ test_parse_comment(void)
 	PARSE_FAIL_FLAGS("[0/", SPDK_JSON_PARSE_INCOMPLETE, SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS);
 }
 
+/* Set up a string of 80 characters with the special sequence inserted at pos */
+static size_t
+long_string_setup(size_t pos, const char *special)
+{
+	size_t len = 0;
+
+	memset(g_buf, 0, sizeof(g_buf));
+	g_buf[len++] = '"';
+	memset(&g_buf[len], 'x', pos);
+	len += pos;
+	memcpy(&g_buf[len], special, strlen(special));
+	len += strlen(special);
+	memset(&g_buf[len], 'x', 80 - pos);
+	len += 80 - pos;
+	g_buf[len++] = '"';
+	g_end = NULL;
+
+	return len;
+}
+
+static void
+test_parse_long_runs(void)
+{
+	const char *ws = " \n\t\r";
+	size_t pos, len, i;
+
+	/* The special characters are found at any position of strings longer than a vector */
+	for (pos = 0; pos <= 80; pos++) {
+		len = long_string_setup(pos, "\x01");
+		CU_ASSERT(spdk_json_parse(g_buf, len, NULL, 0, &g_end, 0) ==
+			  SPDK_JSON_PARSE_INVALID);
+		CU_ASSERT(g_end == g_buf + 1 + pos);
+
+		len = long_string_setup(pos, "\\n");
+		CU_ASSERT(spdk_json_parse(g_buf, len, g_vals, JSONVALUE_NUM, &g_end,
+					  SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE) == 1);
+		CU_ASSERT(g_end == g_buf + len);
+		CU_ASSERT(g_vals[0].len == 81);
+		CU_ASSERT(((uint8_t *)g_vals[0].start)[pos] == '\n');
+		CU_ASSERT(((uint8_t *)g_vals[0].start)[80] == (pos == 80 ? '\n' : 'x'));
+
+		len = long_string_setup(pos, "\xC3\xA9");
+		CU_ASSERT(spdk_json_parse(g_buf, len, g_vals, JSONVALUE_NUM, &g_end,
+					  SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE) == 1);
+		CU_ASSERT(g_vals[0].len == 82);
+		CU_ASSERT(memcmp((uint8_t *)g_vals[0].start + pos, "\xC3\xA9", 2) == 0);
+
+		/* Invalid UTF-8 */
+		len = long_string_setup(pos, "\xC3");
+		CU_ASSERT(spdk_json_parse(g_buf, len, NULL, 0, &g_end, 0) ==
+			  SPDK_JSON_PARSE_INVALID);
+
+		/* Unterminated string */
+		len = long_string_setup(pos, "");
+		CU_ASSERT(spdk_json_parse(g_buf, 1 + pos, NULL, 0, &g_end, 0) ==
+			  SPDK_JSON_PARSE_INCOMPLETE);
+	}
+
+	/* Long runs of whitespace between tokens */
+	for (pos = 0; pos <= 80; pos++) {
+		memset(g_buf, 0, sizeof(g_buf));
+		len = 0;
+		g_buf[len++] = '[';
+		for (i = 0; i < pos; i++) {
+			g_buf[len++] = ws[i % 4];
+		}
+		g_buf[len++] = '1';
+		for (i = 0; i < pos; i++) {
+			g_buf[len++] = ws[i % 4];
+		}
+		g_buf[len++] = ']';
+		for (i = 0; i < pos; i++) {
+			g_buf[len++] = ws[i % 4];
+		}
+		g_buf[len++] = 'x';
+
+		CU_ASSERT(spdk_json_parse(g_buf, len, g_vals, JSONVALUE_NUM, &g_end, 0) == 3);
+		CU_ASSERT(g_end == g_buf + len - 1);
+		CU_ASSERT(g_vals[1].type == SPDK_JSON_VAL_NUMBER);
+		CU_ASSERT(g_vals[1].start == g_buf + 1 + pos);
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -893,6 +976,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_parse_object);
 	CU_ADD_TEST(suite, test_parse_nesting);
 	CU_ADD_TEST(suite, test_parse_comment);
+	CU_ADD_TEST(suite, test_parse_long_runs);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
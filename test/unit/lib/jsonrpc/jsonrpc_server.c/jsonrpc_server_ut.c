@@ -162,6 +162,26 @@ jsonrpc_server_send_response(struct spdk_jsonrpc_request *request)
 {
 }
 
+static char g_stream_buf[256];
+static size_t g_stream_len;
+static ssize_t g_stream_rc;
+
+ssize_t
+jsonrpc_server_stream_response(struct spdk_jsonrpc_request *request)
+{
+	if (g_stream_rc < 0) {
+		return g_stream_rc;
+	}
+
+	SPDK_CU_ASSERT_FATAL(g_stream_len + request->send_len < sizeof(g_stream_buf));
+	memcpy(g_stream_buf + g_stream_len, request->send_buf, request->send_len);
+	g_stream_len += request->send_len;
+	g_stream_buf[g_stream_len] = '\0';
+	request->send_len = 0;
+
+	return g_stream_rc;
+}
+
 static void
 test_parse_request(void)
 {
@@ -360,6 +380,73 @@ test_parse_request_streaming(void)
 	free(server);
 }
 
+static void
+test_flush_response(void)
+{
+	struct spdk_jsonrpc_server *server;
+	struct spdk_jsonrpc_server_conn *conn;
+	struct spdk_json_write_ctx *w;
+
+	server = calloc(1, sizeof(*server));
+	SPDK_CU_ASSERT_FATAL(server != NULL);
+
+	conn = calloc(1, sizeof(*conn));
+	SPDK_CU_ASSERT_FATAL(conn != NULL);
+	pthread_spin_init(&conn->queue_lock, PTHREAD_PROCESS_PRIVATE);
+	STAILQ_INIT(&conn->outstanding_queue);
+
+	conn->server = server;
+
+	/* The flushed parts and the rest of the response make up the whole result */
+	PARSE_PASS("{\"jsonrpc\":\"2.0\",\"method\":\"a\",\"id\":1}", "");
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	w = spdk_jsonrpc_begin_result(g_request);
+	spdk_json_write_array_begin(w);
+	spdk_json_write_string(w, "first");
+	CU_ASSERT(spdk_jsonrpc_flush(g_request) == 0);
+	CU_ASSERT(strcmp(g_stream_buf, "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":[\"first\"") == 0);
+	CU_ASSERT(g_request->send_len == 0);
+
+	/* Too much data waiting to be sent */
+	spdk_json_write_string(w, "second");
+	g_stream_rc = SPDK_JSONRPC_STREAM_PENDING_MAX + 1;
+	CU_ASSERT(spdk_jsonrpc_flush(g_request) == -EAGAIN);
+	CU_ASSERT(strcmp(g_stream_buf, "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":[\"first\","
+			 "\"second\"") == 0);
+
+	/* Closed connection */
+	g_stream_rc = -ENOTCONN;
+	CU_ASSERT(spdk_jsonrpc_flush(g_request) == -ENOTCONN);
+	g_stream_rc = 0;
+
+	spdk_json_write_array_end(w);
+	spdk_jsonrpc_end_result(g_request, w);
+	g_request->send_buf[g_request->send_len] = '\0';
+	CU_ASSERT(strcmp((char *)g_request->send_buf, "]}\n") == 0);
+	jsonrpc_free_request(g_request);
+	g_request = NULL;
+	g_stream_len = 0;
+	g_stream_buf[0] = '\0';
+
+	/* Nothing is streamed for notifications */
+	PARSE_PASS("{\"jsonrpc\":\"2.0\",\"method\":\"b\"}", "");
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	w = spdk_jsonrpc_begin_result(g_request);
+	spdk_json_write_string(w, "result");
+	CU_ASSERT(spdk_jsonrpc_flush(g_request) == 0);
+	CU_ASSERT(g_stream_len == 0);
+	CU_ASSERT(g_request->send_len == 0);
+	spdk_jsonrpc_end_result(g_request, w);
+	jsonrpc_free_request(g_request);
+	g_request = NULL;
+
+	g_method = NULL;
+	g_params = NULL;
+	CU_ASSERT(conn->outstanding_requests == 0);
+	free(conn);
+	free(server);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -372,6 +459,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_parse_request);
 	CU_ADD_TEST(suite, test_parse_request_streaming);
+	CU_ADD_TEST(suite, test_flush_response);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 
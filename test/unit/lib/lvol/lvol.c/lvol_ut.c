@@ -92,13 +92,41 @@ spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
+static spdk_blob_id g_decoupled_blobids[4];
+static size_t g_decoupled_count;
+
 void
 spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 			     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
+	if (g_inflate_rc == 0 && g_decoupled_count < SPDK_COUNTOF(g_decoupled_blobids)) {
+		g_decoupled_blobids[g_decoupled_count++] = blobid;
+	}
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
+DEFINE_STUB_V(spdk_bs_blob_shallow_copy,
+	      (struct spdk_blob_store *bs, struct spdk_io_channel *channel, spdk_blob_id blobid,
+	       spdk_blob_id base_id, struct spdk_bs_dev *ext_dev, uint32_t queue_depth,
+	       spdk_blob_op_complete cb_fn, void *cb_arg));
+
+/* Blobs have a single cluster, allocated in snapshots and in g_allocated_blobid */
+static spdk_blob_id g_allocated_blobid = SPDK_BLOBID_INVALID;
+
+uint64_t
+spdk_blob_get_next_allocated_io_unit(struct spdk_blob *blob, uint64_t offset)
+{
+	return offset == 0 ? 0 : UINT64_MAX;
+}
+
+uint64_t
+spdk_blob_get_next_unallocated_io_unit(struct spdk_blob *blob, uint64_t offset)
+{
+	return offset == 0 && blob->id != g_allocated_blobid ? 0 : UINT64_MAX;
+}
+
+DEFINE_STUB(spdk_bs_get_io_unit_size, uint64_t, (struct spdk_blob_store *bs), 512);
+
 void
 spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *b,
 		  spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
@@ -2233,6 +2261,111 @@ lvol_inflate(void)
 	CU_ASSERT(g_io_channel == NULL);
 }
 
+static void
+lvol_decouple_clones(void)
+{
+	struct lvol_ut_bs_dev dev;
+	struct spdk_lvol *lvol, *snap, *clone1, *clone2;
+	struct spdk_lvs_opts opts;
+	spdk_blob_id mock_clones[3];
+	int rc = 0;
+
+	init_dev(&dev);
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+
+	spdk_lvol_create(g_lvol_store, "lvol", 10, true, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvol = g_lvol;
+
+	spdk_lvol_create_snapshot(lvol, "snap", lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	snap = g_lvol;
+
+	spdk_lvol_create_clone(snap, "clone1", lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	clone1 = g_lvol;
+
+	spdk_lvol_create_clone(snap, "clone2", lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	clone2 = g_lvol;
+
+	mock_clones[0] = lvol->blob_id;
+	mock_clones[1] = clone1->blob_id;
+	mock_clones[2] = clone2->blob_id;
+	g_spdk_blob_get_clones_ids = mock_clones;
+	g_spdk_blob_get_clones_snap_id = snap->blob_id;
+
+	/* Nothing to decouple with a single clone */
+	g_spdk_blob_get_clones_count = 1;
+	g_decoupled_count = 0;
+	g_lvserrno = -1;
+	spdk_lvol_decouple_clones(snap, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_decoupled_count == 0);
+
+	/* The lvol overwrote the snapshot's cluster, so the first clone sharing it is kept */
+	g_spdk_blob_get_clones_count = 3;
+	g_allocated_blobid = lvol->blob_id;
+	g_lvserrno = -1;
+	spdk_lvol_decouple_clones(snap, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_decoupled_count == 2);
+	CU_ASSERT(g_decoupled_blobids[0] == lvol->blob_id);
+	CU_ASSERT(g_decoupled_blobids[1] == clone2->blob_id);
+
+	/* All of them share the cluster, so the first one is kept */
+	g_allocated_blobid = SPDK_BLOBID_INVALID;
+	g_decoupled_count = 0;
+	g_lvserrno = -1;
+	spdk_lvol_decouple_clones(snap, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_decoupled_count == 2);
+	CU_ASSERT(g_decoupled_blobids[0] == clone2->blob_id);
+	CU_ASSERT(g_decoupled_blobids[1] == clone1->blob_id);
+
+	/* Errors stop the decoupling */
+	g_inflate_rc = -EIO;
+	g_lvserrno = 0;
+	spdk_lvol_decouple_clones(snap, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EIO);
+	g_inflate_rc = 0;
+
+	g_spdk_blob_get_clones_snap_id = 0xbad;
+	g_spdk_blob_get_clones_count = 0;
+	g_spdk_blob_get_clones_ids = NULL;
+	g_decoupled_count = 0;
+
+	spdk_lvol_close(clone2, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_close(clone1, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_close(snap, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_close(lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(g_lvol_store, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvol_store = NULL;
+
+	free_dev(&dev);
+}
+
 static void
 lvol_decouple_parent(void)
 {
@@ -3335,6 +3468,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lvs_rename);
 	CU_ADD_TEST(suite, lvol_inflate);
 	CU_ADD_TEST(suite, lvol_decouple_parent);
+	CU_ADD_TEST(suite, lvol_decouple_clones);
 	CU_ADD_TEST(suite, lvol_get_xattr);
 	CU_ADD_TEST(suite, lvol_esnap_reload);
 	CU_ADD_TEST(suite, lvol_esnap_create_bad_args);
@@ -0,0 +1,224 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "common/lib/test_env.c"
+#include "metrics/metrics.c"
+#include "metrics/exporter.c"
+
+DEFINE_STUB_V(spdk_unaffinitize_thread, (void));
+
+enum {
+	UT_METRIC_COUNTER,
+	UT_METRIC_GAUGE,
+	UT_METRIC_HISTOGRAM,
+};
+
+static const uint64_t g_ut_buckets[] = { 10, 100 };
+
+static const struct spdk_metric_desc g_ut_metrics[] = {
+	[UT_METRIC_COUNTER] = { "ut_ops", "Operations", SPDK_METRIC_TYPE_COUNTER },
+	[UT_METRIC_GAUGE] = { "ut_depth", "Queue\\depth", SPDK_METRIC_TYPE_GAUGE },
+	[UT_METRIC_HISTOGRAM] = {
+		"ut_latency", "Latency", SPDK_METRIC_TYPE_HISTOGRAM,
+		g_ut_buckets, SPDK_COUNTOF(g_ut_buckets),
+	},
+};
+
+static const struct spdk_metric_desc g_ut_other_metrics[] = {
+	{ "ut_other", "Other", SPDK_METRIC_TYPE_COUNTER },
+};
+
+static char *
+render(void)
+{
+	char *buf = NULL;
+	size_t len = 0;
+	int rc;
+
+	rc = spdk_metrics_render(&buf, &len);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	CU_ASSERT(strlen(buf) == len);
+
+	return buf;
+}
+
+static void
+metrics_disabled(void)
+{
+	struct spdk_metrics_group *group;
+	char *buf;
+
+	CU_ASSERT(!spdk_metrics_enabled());
+	group = spdk_metrics_group_register(g_ut_metrics, SPDK_COUNTOF(g_ut_metrics), "dev", "a");
+	CU_ASSERT(group == NULL);
+
+	buf = render();
+	CU_ASSERT(strcmp(buf, "# EOF\n") == 0);
+	free(buf);
+}
+
+static void
+metrics_update(void)
+{
+	struct spdk_metrics_group *a, *b, *other;
+	char *buf;
+
+	allocate_cores(2);
+	spdk_metrics_enable();
+	CU_ASSERT(spdk_metrics_enabled());
+	CU_ASSERT(g_metrics.num_slots == 3);
+
+	a = spdk_metrics_group_register(g_ut_metrics, SPDK_COUNTOF(g_ut_metrics), "dev", "a");
+	SPDK_CU_ASSERT_FATAL(a != NULL);
+	b = spdk_metrics_group_register(g_ut_metrics, SPDK_COUNTOF(g_ut_metrics), "dev", "b\"1");
+	SPDK_CU_ASSERT_FATAL(b != NULL);
+	other = spdk_metrics_group_register(g_ut_other_metrics, SPDK_COUNTOF(g_ut_other_metrics),
+					    NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(other != NULL);
+	CU_ASSERT(a->family == b->family);
+	CU_ASSERT(a->family != other->family);
+
+	/* Update the groups from both cores and from a thread outside of the cores */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	spdk_metrics_counter_add(a, UT_METRIC_COUNTER, 2);
+	spdk_metrics_gauge_add(a, UT_METRIC_GAUGE, 3);
+	spdk_metrics_histogram_observe(a, UT_METRIC_HISTOGRAM, 5);
+	spdk_metrics_histogram_observe(a, UT_METRIC_HISTOGRAM, 10);
+	MOCK_SET(spdk_env_get_current_core, 1);
+	spdk_metrics_counter_add(a, UT_METRIC_COUNTER, 3);
+	spdk_metrics_gauge_add(a, UT_METRIC_GAUGE, -5);
+	spdk_metrics_histogram_observe(a, UT_METRIC_HISTOGRAM, 50);
+	MOCK_SET(spdk_env_get_current_core, SPDK_ENV_LCORE_ID_ANY);
+	spdk_metrics_counter_add(b, UT_METRIC_COUNTER, 7);
+	spdk_metrics_histogram_observe(a, UT_METRIC_HISTOGRAM, 1000);
+	spdk_metrics_counter_add(other, 0, 1);
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	buf = render();
+	CU_ASSERT(strstr(buf, "# TYPE ut_ops counter\n# HELP ut_ops Operations\n"
+			 "ut_ops_total{dev=\"a\"} 5\n"
+			 "ut_ops_total{dev=\"b\\\"1\"} 7\n") != NULL);
+	CU_ASSERT(strstr(buf, "# TYPE ut_depth gauge\n# HELP ut_depth Queue\\\\depth\n"
+			 "ut_depth{dev=\"a\"} -2\n"
+			 "ut_depth{dev=\"b\\\"1\"} 0\n") != NULL);
+	CU_ASSERT(strstr(buf, "# TYPE ut_latency histogram\n# HELP ut_latency Latency\n"
+			 "ut_latency_bucket{dev=\"a\",le=\"10.0\"} 2\n"
+			 "ut_latency_bucket{dev=\"a\",le=\"100.0\"} 3\n"
+			 "ut_latency_bucket{dev=\"a\",le=\"+Inf\"} 4\n"
+			 "ut_latency_count{dev=\"a\"} 4\n"
+			 "ut_latency_sum{dev=\"a\"} 1065\n") != NULL);
+	CU_ASSERT(strstr(buf, "ut_other_total 1\n") != NULL);
+	CU_ASSERT(strcmp(buf + strlen(buf) - strlen("# EOF\n"), "# EOF\n") == 0);
+	free(buf);
+
+	/* Unregistering the last group of a family removes the family */
+	spdk_metrics_group_unregister(b);
+	spdk_metrics_group_unregister(other);
+	buf = render();
+	CU_ASSERT(strstr(buf, "dev=\"b") == NULL);
+	CU_ASSERT(strstr(buf, "ut_other") == NULL);
+	CU_ASSERT(strstr(buf, "ut_ops_total{dev=\"a\"} 5\n") != NULL);
+	free(buf);
+
+	spdk_metrics_group_unregister(a);
+	CU_ASSERT(TAILQ_EMPTY(&g_metrics.families));
+	free_cores();
+}
+
+static void
+http_get(uint16_t port, const char *request, char *response, size_t size)
+{
+	struct sockaddr_in addr = {};
+	size_t len = 0;
+	ssize_t rc;
+	int fd;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	SPDK_CU_ASSERT_FATAL(fd >= 0);
+	rc = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	rc = send(fd, request, strlen(request), 0);
+	CU_ASSERT(rc == (ssize_t)strlen(request));
+
+	/* The exporter closes the connection once the response is sent */
+	while (len < size - 1) {
+		rc = recv(fd, response + len, size - 1 - len, 0);
+		if (rc <= 0) {
+			break;
+		}
+		len += rc;
+	}
+
+	response[len] = '\0';
+	close(fd);
+}
+
+static void
+metrics_exporter(void)
+{
+	struct spdk_metrics_group *group;
+	struct sockaddr_in addr = {};
+	socklen_t addrlen = sizeof(addr);
+	char response[4096];
+	int rc;
+
+	spdk_metrics_enable();
+	group = spdk_metrics_group_register(g_ut_metrics, SPDK_COUNTOF(g_ut_metrics), "dev", "a");
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	spdk_metrics_counter_add(group, UT_METRIC_COUNTER, 1);
+
+	rc = spdk_metrics_exporter_start("127.0.0.1", 0);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	CU_ASSERT(spdk_metrics_exporter_start("127.0.0.1", 0) == -EALREADY);
+	rc = getsockname(g_exporter.listen_fd, (struct sockaddr *)&addr, &addrlen);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	http_get(ntohs(addr.sin_port), "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n",
+		 response, sizeof(response));
+	CU_ASSERT(strncmp(response, "HTTP/1.1 200 OK\r\n", strlen("HTTP/1.1 200 OK\r\n")) == 0);
+	CU_ASSERT(strstr(response, "Content-Type: application/openmetrics-text") != NULL);
+	CU_ASSERT(strstr(response, "\r\n\r\n# TYPE ut_ops counter\n") != NULL);
+	CU_ASSERT(strstr(response, "ut_ops_total{dev=\"a\"} 1\n") != NULL);
+	CU_ASSERT(strstr(response, "# EOF\n") != NULL);
+
+	http_get(ntohs(addr.sin_port), "GET / HTTP/1.1\r\n\r\n", response, sizeof(response));
+	CU_ASSERT(strncmp(response, "HTTP/1.1 404", strlen("HTTP/1.1 404")) == 0);
+
+	http_get(ntohs(addr.sin_port), "POST /metrics HTTP/1.1\r\n\r\n", response,
+		 sizeof(response));
+	CU_ASSERT(strncmp(response, "HTTP/1.1 405", strlen("HTTP/1.1 405")) == 0);
+
+	spdk_metrics_exporter_stop();
+	CU_ASSERT(!g_exporter.running);
+	CU_ASSERT(g_exporter.listen_fd == -1);
+
+	spdk_metrics_group_unregister(group);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("metrics", NULL, NULL);
+	CU_ADD_TEST(suite, metrics_disabled);
+	CU_ADD_TEST(suite, metrics_update);
+	CU_ADD_TEST(suite, metrics_exporter);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -54,6 +54,11 @@ DEFINE_STUB(spdk_nvme_ctrlr_cmd_security_send, int, (struct spdk_nvme_ctrlr *ctr
 		uint8_t secp, uint16_t spsp, uint8_t nssf, void *payload,
 		uint32_t payload_size, spdk_nvme_cmd_cb cb_fn, void *cb_arg), 0);
 DEFINE_STUB_V(nvme_qpair_abort_queued_reqs, (struct spdk_nvme_qpair *qpair));
+DEFINE_STUB(nvme_qpair_init_child_requests, int, (struct spdk_nvme_qpair *qpair,
+	    uint32_t num_child_requests), 0);
+DEFINE_STUB(nvme_qpair_init_submit_ring, int, (struct spdk_nvme_qpair *qpair,
+	    uint32_t submit_ring_size), 0);
+DEFINE_STUB_V(nvme_qpair_tally_latency, (struct spdk_nvme_qpair *qpair, struct nvme_request *req));
 
 DEFINE_RETURN_MOCK(nvme_transport_ctrlr_get_memory_domains, int);
 int
@@ -475,6 +480,30 @@ static uint32_t g_active_ns_list_length = 0;
 static struct spdk_nvme_ctrlr_data *g_cdata = NULL;
 static bool g_fail_next_identify = false;
 
+/* Identify IOCS specific commands are not completed until the test does so */
+struct ut_pending_identify {
+	spdk_nvme_cmd_cb	cb_fn;
+	void			*cb_arg;
+};
+static struct ut_pending_identify g_pending_identify[64];
+static uint32_t g_num_pending_identify;
+
+static void
+ut_complete_pending_identify(uint16_t sc)
+{
+	struct ut_pending_identify pending;
+
+	SPDK_CU_ASSERT_FATAL(g_num_pending_identify > 0);
+	pending = g_pending_identify[0];
+	g_num_pending_identify--;
+	memmove(&g_pending_identify[0], &g_pending_identify[1],
+		g_num_pending_identify * sizeof(g_pending_identify[0]));
+
+	fake_cpl.status.sc = sc;
+	pending.cb_fn(pending.cb_arg, &fake_cpl);
+	fake_cpl.status.sc = SPDK_NVME_SC_SUCCESS;
+}
+
 int
 nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cntid, uint32_t nsid,
 			uint8_t csi, void *payload, size_t payload_size,
@@ -520,6 +549,11 @@ nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cnt
 			memcpy(payload, g_cdata, sizeof(*g_cdata));
 		}
 	} else if (cns == SPDK_NVME_IDENTIFY_NS_IOCS) {
+		if (g_num_pending_identify < SPDK_COUNTOF(g_pending_identify)) {
+			g_pending_identify[g_num_pending_identify].cb_fn = cb_fn;
+			g_pending_identify[g_num_pending_identify].cb_arg = cb_arg;
+			g_num_pending_identify++;
+		}
 		return 0;
 	}
 
@@ -2985,85 +3019,98 @@ test_nvme_ctrlr_ns_attr_changed(void)
 }
 
 static void
-test_nvme_ctrlr_identify_namespaces_iocs_specific_next(void)
+test_nvme_ctrlr_identify_namespaces_pipelined(void)
 {
 	struct spdk_nvme_ctrlr ctrlr = {};
-	uint32_t prev_nsid;
-	struct spdk_nvme_ns ns[5] = {};
-	struct spdk_nvme_ctrlr ns_ctrlr[5] = {};
-	int rc = 0;
-	int i;
+	struct spdk_nvme_ns ns[40] = {};
+	uint32_t i;
+	int rc;
 
 	RB_INIT(&ctrlr.ns);
-	for (i = 0; i < 5; i++) {
-		ns[i].id = i + 1;
-		ns[i].active = true;
-	}
-
 	CU_ASSERT(pthread_mutex_init(&ctrlr.ctrlr_lock, NULL) == 0);
 
-	ctrlr.cdata.nn = 5;
-	/* case 1: No first/next active NS, move on to the next state, expect: pass */
-	prev_nsid = 0;
-	ctrlr.active_ns_count = 0;
+	ctrlr.cdata.nn = SPDK_COUNTOF(ns);
+	ctrlr.vs.raw = SPDK_NVME_VERSION(1, 3, 0);
+	ctrlr.cap.bits.css = SPDK_NVME_CAP_CSS_IOCS;
+	ctrlr.opts.command_set = SPDK_NVME_CC_CSS_IOCS;
+	ctrlr.opts.admin_queue_size = 32;
 	ctrlr.opts.admin_timeout_ms = NVME_TIMEOUT_INFINITE;
-	rc = nvme_ctrlr_identify_namespaces_iocs_specific_next(&ctrlr, prev_nsid);
+
+	/* No active namespaces, move on to the next state right away */
+	rc = nvme_ctrlr_identify_namespaces(&ctrlr);
 	CU_ASSERT(rc == 0);
-	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES);
-	CU_ASSERT(ctrlr.state_timeout_tsc == NVME_TIMEOUT_INFINITE);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_ID_DESCS);
 
-	/* case 2: move on to the next active NS, and no namespace with (supported) iocs specific data found , expect: pass */
-	memset(&ctrlr.state, 0x00, sizeof(ctrlr.state));
-	memset(&ctrlr.state_timeout_tsc, 0x00, sizeof(ctrlr.state_timeout_tsc));
-	prev_nsid = 1;
-	for (i = 0; i < 5; i++) {
+	for (i = 0; i < SPDK_COUNTOF(ns); i++) {
+		ns[i].id = i + 1;
+		ns[i].active = true;
+		ns[i].csi = (i % 4 == 0) ? SPDK_NVME_CSI_NVM : SPDK_NVME_CSI_ZNS;
 		RB_INSERT(nvme_ns_tree, &ctrlr.ns, &ns[i]);
 	}
-	ctrlr.active_ns_count = 5;
-	ns[1].csi = SPDK_NVME_CSI_NVM;
-	ns[1].id = 2;
-	rc = nvme_ctrlr_identify_namespaces_iocs_specific_next(&ctrlr, prev_nsid);
+
+	/* Commands completing from within the submission are all processed */
+	rc = nvme_ctrlr_identify_namespaces(&ctrlr);
 	CU_ASSERT(rc == 0);
-	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES);
-	CU_ASSERT(ctrlr.state_timeout_tsc == NVME_TIMEOUT_INFINITE);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_ID_DESCS);
+	CU_ASSERT(ctrlr.ns_init.outstanding == 0);
+	for (i = 0; i < SPDK_COUNTOF(ns); i++) {
+		CU_ASSERT(ns[i].ctrlr == &ctrlr);
+	}
 
-	/* case 3: ns.csi is SPDK_NVME_CSI_ZNS, do not loop, expect: pass */
-	memset(&ctrlr.state, 0x00, sizeof(ctrlr.state));
-	memset(&ctrlr.state_timeout_tsc, 0x00, sizeof(ctrlr.state_timeout_tsc));
-	ctrlr.opts.admin_timeout_ms = NVME_TIMEOUT_INFINITE;
-	prev_nsid = 0;
-	ctrlr.active_ns_count = 5;
+	/* 30 ZNS namespaces, but only half of the admin queue may be used at once */
+	rc = nvme_ctrlr_identify_namespaces_iocs_specific(&ctrlr);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC);
+	CU_ASSERT(ctrlr.ns_init.outstanding == 16);
+	CU_ASSERT(g_num_pending_identify == 16);
 
-	for (int i = 0; i < 5; i++) {
-		ns[i].csi = SPDK_NVME_CSI_NVM;
-		ns[i].id = i + 1;
-		ns[i].ctrlr = &ns_ctrlr[i];
+	/* Each completion submits the command for the next namespace */
+	ut_complete_pending_identify(SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(ctrlr.ns_init.outstanding == 16);
+	CU_ASSERT(g_num_pending_identify == 16);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC);
+
+	while (g_num_pending_identify > 0) {
+		ut_complete_pending_identify(SPDK_NVME_SC_SUCCESS);
+	}
+	CU_ASSERT(ctrlr.ns_init.outstanding == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES);
+	for (i = 0; i < SPDK_COUNTOF(ns); i++) {
+		CU_ASSERT((ns[i].nsdata_zns != NULL) == (ns[i].csi == SPDK_NVME_CSI_ZNS));
+		nvme_ns_free_zns_specific_data(&ns[i]);
 	}
-	ns[4].csi = SPDK_NVME_CSI_ZNS;
-	ns_ctrlr[4].opts.admin_timeout_ms = NVME_TIMEOUT_INFINITE;
 
-	rc = nvme_ctrlr_identify_namespaces_iocs_specific_next(&ctrlr, prev_nsid);
+	/* A failed command stops the phase and fails the controller once the others complete */
+	ctrlr.opts.admin_queue_size = 8;
+	rc = nvme_ctrlr_identify_namespaces_iocs_specific(&ctrlr);
 	CU_ASSERT(rc == 0);
-	CU_ASSERT(ctrlr.state == 0);
-	CU_ASSERT(ctrlr.state_timeout_tsc == NVME_TIMEOUT_INFINITE);
-	CU_ASSERT(ns_ctrlr[4].state == NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC);
-	CU_ASSERT(ns_ctrlr[4].state_timeout_tsc == NVME_TIMEOUT_INFINITE);
+	CU_ASSERT(g_num_pending_identify == 4);
+
+	ut_complete_pending_identify(SPDK_NVME_SC_INVALID_FIELD);
+	CU_ASSERT(g_num_pending_identify == 3);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS_IOCS_SPECIFIC);
 
-	for (int i = 0; i < 5; i++) {
+	while (g_num_pending_identify > 0) {
+		ut_complete_pending_identify(SPDK_NVME_SC_SUCCESS);
+	}
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ERROR);
+	for (i = 0; i < SPDK_COUNTOF(ns); i++) {
 		nvme_ns_free_zns_specific_data(&ns[i]);
 	}
 
-	/* case 4: nvme_ctrlr_identify_ns_iocs_specific_async return 1, expect: false */
-	memset(&ctrlr.state, 0x00, sizeof(ctrlr.state));
-	memset(&ctrlr.state_timeout_tsc, 0x00, sizeof(ctrlr.state_timeout_tsc));
-	prev_nsid = 1;
-	ctrlr.active_ns_count = 5;
-	ns[1].csi = SPDK_NVME_CSI_ZNS;
+	/* A failed NS ID Descriptor List stops the phase without failing the controller */
+	set_status_code = SPDK_NVME_SC_INVALID_FIELD;
+	rc = nvme_ctrlr_identify_id_desc_namespaces(&ctrlr);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC);
+	CU_ASSERT(ctrlr.ns_init.outstanding == 0);
+	set_status_code = SPDK_NVME_SC_SUCCESS;
+
+	/* Failing to submit a command fails the controller */
 	g_fail_next_identify = true;
-	rc = nvme_ctrlr_identify_namespaces_iocs_specific_next(&ctrlr, prev_nsid);
+	rc = nvme_ctrlr_identify_namespaces(&ctrlr);
 	CU_ASSERT(rc == 1);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ERROR);
-	CU_ASSERT(ctrlr.state_timeout_tsc == NVME_TIMEOUT_INFINITE);
 
 	CU_ASSERT(pthread_mutex_destroy(&ctrlr.ctrlr_lock) == 0);
 }
@@ -3408,7 +3455,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_ctrlr_reset);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_aer_callback);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_ns_attr_changed);
-	CU_ADD_TEST(suite, test_nvme_ctrlr_identify_namespaces_iocs_specific_next);
+	CU_ADD_TEST(suite, test_nvme_ctrlr_identify_namespaces_pipelined);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_set_supported_log_pages);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_set_intel_supported_log_pages);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_parse_ana_log_page);
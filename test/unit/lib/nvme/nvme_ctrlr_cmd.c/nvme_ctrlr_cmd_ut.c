@@ -53,6 +53,7 @@ DEFINE_STUB(nvme_qpair_abort_queued_reqs_with_cbarg, uint32_t,
 
 DEFINE_STUB(spdk_nvme_ctrlr_get_admin_qp_failure_reason, spdk_nvme_qp_failure_reason,
 	    (struct spdk_nvme_ctrlr *ctrlr), 0);
+DEFINE_STUB_V(nvme_qpair_tally_latency, (struct spdk_nvme_qpair *qpair, struct nvme_request *req));
 
 static int
 nvme_ns_cmp(struct spdk_nvme_ns *ns1, struct spdk_nvme_ns *ns2)
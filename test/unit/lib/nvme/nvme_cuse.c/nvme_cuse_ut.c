@@ -308,7 +308,21 @@ test_cuse_nvme_submit_passthru_cmd(void)
 	CU_ASSERT(g_ut_ctx->nvme_cmd.cdw14    == 0xc0de1414);
 	CU_ASSERT(g_ut_ctx->nvme_cmd.cdw15    == 0xc0de1515);
 
+	CU_ASSERT(g_ut_ctx->result64 == false);
+
+	cuse_io_ctx_free(g_ut_ctx);
+#ifdef NVME_IOCTL_IO64_CMD
+	/* 64-bit result variant of the IO Command IOCTL */
+	g_ut_ctx = NULL;
+	cuse_nvme_passthru_cmd_send(req, passthru_cmd, NULL, NULL, NVME_IOCTL_IO64_CMD);
+	SPDK_CU_ASSERT_FATAL(g_ut_ctx != NULL);
+	CU_ASSERT(g_ut_ctx->result64 == true);
+	CU_ASSERT(g_ut_ctx->nvme_cmd.opc      == SPDK_NVME_DATA_CONTROLLER_TO_HOST);
+	CU_ASSERT(g_ut_ctx->nvme_cmd.nsid     == 1);
+	CU_ASSERT(g_ut_ctx->nvme_cmd.cdw10    == 0xc0de1010);
+
 	cuse_io_ctx_free(g_ut_ctx);
+#endif
 	free(passthru_cmd);
 	free(g_cuse_device);
 }
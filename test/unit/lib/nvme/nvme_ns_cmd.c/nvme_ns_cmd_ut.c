@@ -62,6 +62,7 @@ DEFINE_STUB(nvme_ctrlr_get_current_process,
 	    struct spdk_nvme_ctrlr_process *,
 	    (struct spdk_nvme_ctrlr *ctrlr),
 	    (struct spdk_nvme_ctrlr_process *)(uintptr_t)0x1);
+DEFINE_STUB_V(nvme_qpair_tally_latency, (struct spdk_nvme_qpair *qpair, struct nvme_request *req));
 
 int
 spdk_pci_enumerate(struct spdk_pci_driver *driver, spdk_pci_enum_cb enum_cb, void *enum_ctx)
@@ -347,6 +348,69 @@ split_test2(void)
 	cleanup_after_test(&qpair);
 }
 
+static void
+split_test_child_arena(void)
+{
+	struct spdk_nvme_ns	ns;
+	struct spdk_nvme_ctrlr	ctrlr;
+	struct spdk_nvme_qpair	qpair;
+	struct nvme_request	*child, *req;
+	struct nvme_request	children[3] = {};
+	void			*payload;
+	uint32_t		lba_count, i;
+	int			rc;
+
+	/*
+	 * Controller has max xfer of 128 KB (256 blocks). Give the qpair an arena of three
+	 * child requests and check that children of split I/Os only come from the arena.
+	 */
+	prepare_for_test(&ns, &ctrlr, &qpair, 512, 0, 128 * 1024, 0, false);
+	for (i = 0; i < SPDK_COUNTOF(children); i++) {
+		children[i].qpair = &qpair;
+		STAILQ_INSERT_HEAD(&qpair.free_child_req, &children[i], stailq);
+	}
+	qpair.child_req_buf = children;
+	ctrlr.opts.io_queue_requests = 32;
+	qpair.num_child_reqs = SPDK_COUNTOF(children);
+	qpair.num_free_child_reqs = SPDK_COUNTOF(children);
+	payload = malloc(512 * 1024);
+	lba_count = (256 * 1024) / 512;
+
+	rc = spdk_nvme_ns_cmd_read(&ns, &qpair, payload, 0, lba_count, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->child_arena == 0);
+	CU_ASSERT(g_request->num_children == 2);
+	CU_ASSERT(qpair.num_free_child_reqs == 1);
+	TAILQ_FOREACH(child, &g_request->children, child_tailq) {
+		CU_ASSERT(child->child_arena == 1);
+		CU_ASSERT(child >= &children[0] && child <= &children[2]);
+	}
+	req = g_request;
+
+	/* The arena can't take both children of another I/O, it fails before splitting. */
+	g_request = NULL;
+	rc = spdk_nvme_ns_cmd_read(&ns, &qpair, payload, 0, lba_count, NULL, NULL, 0);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(g_request == NULL);
+	CU_ASSERT(qpair.num_free_child_reqs == 1);
+	CU_ASSERT(qpair.num_outstanding_reqs == 3);
+
+	/* An I/O that can never fit in the arena is rejected. */
+	rc = spdk_nvme_ns_cmd_read(&ns, &qpair, payload, 0, 2 * lba_count, NULL, NULL, 0);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(qpair.num_outstanding_reqs == 3);
+
+	/* The children return to the arena. */
+	nvme_request_free_children(req);
+	CU_ASSERT(qpair.num_free_child_reqs == 3);
+	nvme_free_request(req);
+	CU_ASSERT(qpair.num_outstanding_reqs == 0);
+
+	free(payload);
+	cleanup_after_test(&qpair);
+}
+
 static void
 split_test3(void)
 {
@@ -2327,6 +2391,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, split_test);
 	CU_ADD_TEST(suite, split_test2);
+	CU_ADD_TEST(suite, split_test_child_arena);
 	CU_ADD_TEST(suite, split_test3);
 	CU_ADD_TEST(suite, split_test4);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_flush);
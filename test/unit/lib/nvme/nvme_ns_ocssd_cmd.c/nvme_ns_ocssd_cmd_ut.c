@@ -59,6 +59,7 @@ DEFINE_STUB(nvme_ctrlr_get_current_process,
 	    struct spdk_nvme_ctrlr_process *,
 	    (struct spdk_nvme_ctrlr *ctrlr),
 	    (struct spdk_nvme_ctrlr_process *)(uintptr_t)0x1);
+DEFINE_STUB_V(nvme_qpair_tally_latency, (struct spdk_nvme_qpair *qpair, struct nvme_request *req));
 
 int
 nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
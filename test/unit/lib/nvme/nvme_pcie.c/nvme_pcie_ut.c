@@ -42,6 +42,13 @@ DEFINE_STUB(spdk_pci_device_cfg_write16, int, (struct spdk_pci_device *dev, uint
 DEFINE_STUB(spdk_pci_device_cfg_read16, int, (struct spdk_pci_device *dev, uint16_t *value,
 		uint32_t offset), 0);
 DEFINE_STUB(spdk_pci_device_get_id, struct spdk_pci_id, (struct spdk_pci_device *dev), {0});
+DEFINE_STUB(spdk_pci_device_cfg_read8, int, (struct spdk_pci_device *dev, uint8_t *value,
+		uint32_t offset), 0);
+DEFINE_STUB(spdk_pci_device_enable_interrupts, int, (struct spdk_pci_device *dev,
+		uint32_t efd_count), 0);
+DEFINE_STUB(spdk_pci_device_disable_interrupts, int, (struct spdk_pci_device *dev), 0);
+DEFINE_STUB(spdk_pci_device_get_interrupt_efd_by_index, int, (struct spdk_pci_device *dev,
+		uint32_t index), 0);
 DEFINE_STUB(spdk_pci_event_listen, int, (void), 0);
 DEFINE_STUB(spdk_pci_register_error_handler, int, (spdk_pci_error_handler sighandler, void *ctx),
 	    0);
@@ -122,13 +129,19 @@ DEFINE_STUB_V(spdk_nvme_qpair_print_command, (struct spdk_nvme_qpair *qpair,
 DEFINE_STUB_V(spdk_nvme_qpair_print_completion, (struct spdk_nvme_qpair *qpair,
 		struct spdk_nvme_cpl *cpl));
 
+static struct nvme_tracker_list g_tracker_list;
+
 static void
-prp_list_prep(struct nvme_tracker *tr, struct nvme_request *req, uint32_t *prp_index)
+prp_list_prep(struct nvme_pcie_qpair *pqpair, struct nvme_tracker *tr, struct nvme_request *req,
+	      uint32_t *prp_index)
 {
 	memset(req, 0, sizeof(*req));
 	memset(tr, 0, sizeof(*tr));
+	memset(&g_tracker_list, 0, sizeof(g_tracker_list));
 	tr->req = req;
-	tr->prp_sgl_bus_addr = 0xDEADBEEF;
+	g_tracker_list.bus_addr = 0xDEADBEEF;
+	STAILQ_INIT(&pqpair->free_lists);
+	STAILQ_INSERT_HEAD(&pqpair->free_lists, &g_tracker_list, stailq);
 	if (prp_index) {
 		*prp_index = 0;
 	}
@@ -137,143 +150,150 @@ prp_list_prep(struct nvme_tracker *tr, struct nvme_request *req, uint32_t *prp_i
 static void
 test_prp_list_append(void)
 {
+	struct nvme_pcie_qpair pqpair = {};
 	struct nvme_request req;
 	struct nvme_tracker tr;
 	struct spdk_nvme_ctrlr ctrlr = {};
 	uint32_t prp_index;
 
 	ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pqpair.qpair.ctrlr = &ctrlr;
 	/* Non-DWORD-aligned buffer (invalid) */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100001, 0x1000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100001, 0x1000,
 					    0x1000) == -EFAULT);
 
 	/* 512-byte buffer, 4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000, 0x200, 0x1000) == 0);
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000, 0x200,
+					    0x1000) == 0);
 	CU_ASSERT(prp_index == 1);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100000);
 
 	/* 512-byte buffer, non-4K-aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x108000, 0x200, 0x1000) == 0);
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x108000, 0x200,
+					    0x1000) == 0);
 	CU_ASSERT(prp_index == 1);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x108000);
 
 	/* 4K buffer, 4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000, 0x1000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000, 0x1000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 1);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100000);
 
 	/* 4K buffer, non-4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800, 0x1000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100800, 0x1000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 2);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100800);
 	CU_ASSERT(req.cmd.dptr.prp.prp2 == 0x101000);
+	CU_ASSERT(tr.list == NULL);
 
 	/* 8K buffer, 4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000, 0x2000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000, 0x2000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 2);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100000);
 	CU_ASSERT(req.cmd.dptr.prp.prp2 == 0x101000);
+	CU_ASSERT(tr.list == NULL);
 
 	/* 8K buffer, non-4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800, 0x2000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100800, 0x2000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 3);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100800);
-	CU_ASSERT(req.cmd.dptr.prp.prp2 == tr.prp_sgl_bus_addr);
-	CU_ASSERT(tr.u.prp[0] == 0x101000);
-	CU_ASSERT(tr.u.prp[1] == 0x102000);
+	CU_ASSERT(req.cmd.dptr.prp.prp2 == g_tracker_list.bus_addr);
+	CU_ASSERT(tr.list->u.prp[0] == 0x101000);
+	CU_ASSERT(tr.list->u.prp[1] == 0x102000);
 
 	/* 12K buffer, 4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000, 0x3000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000, 0x3000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 3);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100000);
-	CU_ASSERT(req.cmd.dptr.prp.prp2 == tr.prp_sgl_bus_addr);
-	CU_ASSERT(tr.u.prp[0] == 0x101000);
-	CU_ASSERT(tr.u.prp[1] == 0x102000);
+	CU_ASSERT(req.cmd.dptr.prp.prp2 == g_tracker_list.bus_addr);
+	CU_ASSERT(tr.list->u.prp[0] == 0x101000);
+	CU_ASSERT(tr.list->u.prp[1] == 0x102000);
 
 	/* 12K buffer, non-4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800, 0x3000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100800, 0x3000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 4);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100800);
-	CU_ASSERT(req.cmd.dptr.prp.prp2 == tr.prp_sgl_bus_addr);
-	CU_ASSERT(tr.u.prp[0] == 0x101000);
-	CU_ASSERT(tr.u.prp[1] == 0x102000);
-	CU_ASSERT(tr.u.prp[2] == 0x103000);
+	CU_ASSERT(req.cmd.dptr.prp.prp2 == g_tracker_list.bus_addr);
+	CU_ASSERT(tr.list->u.prp[0] == 0x101000);
+	CU_ASSERT(tr.list->u.prp[1] == 0x102000);
+	CU_ASSERT(tr.list->u.prp[2] == 0x103000);
 
 	/* Two 4K buffers, both 4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000, 0x1000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000, 0x1000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 1);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x900000, 0x1000,
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x900000, 0x1000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 2);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100000);
 	CU_ASSERT(req.cmd.dptr.prp.prp2 == 0x900000);
+	CU_ASSERT(tr.list == NULL);
 
 	/* Two 4K buffers, first non-4K aligned, second 4K aligned */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800, 0x1000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100800, 0x1000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 2);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x900000, 0x1000,
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x900000, 0x1000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 3);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100800);
-	CU_ASSERT(req.cmd.dptr.prp.prp2 == tr.prp_sgl_bus_addr);
-	CU_ASSERT(tr.u.prp[0] == 0x101000);
-	CU_ASSERT(tr.u.prp[1] == 0x900000);
+	CU_ASSERT(req.cmd.dptr.prp.prp2 == g_tracker_list.bus_addr);
+	CU_ASSERT(tr.list->u.prp[0] == 0x101000);
+	CU_ASSERT(tr.list->u.prp[1] == 0x900000);
 
 	/* Two 4K buffers, both non-4K aligned (invalid) */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800, 0x1000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100800, 0x1000,
 					    0x1000) == 0);
 	CU_ASSERT(prp_index == 2);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x900800, 0x1000,
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x900800, 0x1000,
 					    0x1000) == -EFAULT);
 	CU_ASSERT(prp_index == 2);
 
 	/* 4K buffer, 4K aligned, but vtophys fails */
 	MOCK_SET(spdk_vtophys, SPDK_VTOPHYS_ERROR);
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000, 0x1000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000, 0x1000,
 					    0x1000) == -EFAULT);
 	MOCK_CLEAR(spdk_vtophys);
 
 	/* Largest aligned buffer that can be described in NVME_MAX_PRP_LIST_ENTRIES (plus PRP1) */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000,
 					    (NVME_MAX_PRP_LIST_ENTRIES + 1) * 0x1000, 0x1000) == 0);
 	CU_ASSERT(prp_index == NVME_MAX_PRP_LIST_ENTRIES + 1);
 
 	/* Largest non-4K-aligned buffer that can be described in NVME_MAX_PRP_LIST_ENTRIES (plus PRP1) */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100800,
 					    NVME_MAX_PRP_LIST_ENTRIES * 0x1000, 0x1000) == 0);
 	CU_ASSERT(prp_index == NVME_MAX_PRP_LIST_ENTRIES + 1);
 
 	/* Buffer too large to be described in NVME_MAX_PRP_LIST_ENTRIES */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100000,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100000,
 					    (NVME_MAX_PRP_LIST_ENTRIES + 2) * 0x1000, 0x1000) == -EFAULT);
 
 	/* Non-4K-aligned buffer too large to be described in NVME_MAX_PRP_LIST_ENTRIES */
-	prp_list_prep(&tr, &req, &prp_index);
-	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800,
+	prp_list_prep(&pqpair, &tr, &req, &prp_index);
+	CU_ASSERT(nvme_pcie_prp_list_append(&pqpair.qpair, &tr, &prp_index, (void *)0x100800,
 					    (NVME_MAX_PRP_LIST_ENTRIES + 1) * 0x1000, 0x1000) == -EFAULT);
 }
 
@@ -415,6 +435,7 @@ test_build_contig_hw_sgl_request(void)
 	struct spdk_nvme_qpair qpair = {};
 	struct nvme_request req = {};
 	struct nvme_tracker tr = {};
+	struct nvme_tracker_list list = {};
 	struct spdk_nvme_ctrlr ctrlr = {};
 	int rc;
 
@@ -431,6 +452,7 @@ test_build_contig_hw_sgl_request(void)
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
 	CU_ASSERT(req.cmd.dptr.sgl1.address == 0xDEADBEEF);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.length == 100);
+	CU_ASSERT(tr.list == NULL);
 
 	MOCK_CLEAR(spdk_vtophys);
 	g_vtophys_size = 0;
@@ -451,6 +473,7 @@ test_build_contig_hw_sgl_request(void)
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
 	CU_ASSERT(req.cmd.dptr.sgl1.address == 0xDEADBEEF);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.length == 100);
+	CU_ASSERT(tr.list == NULL);
 
 	MOCK_CLEAR(spdk_vtophys);
 	g_vtophys_size = 0;
@@ -463,20 +486,21 @@ test_build_contig_hw_sgl_request(void)
 	req.payload_size = 100;
 	req.payload = NVME_PAYLOAD_CONTIG((void *)0xbeef0, NULL);
 	g_vtophys_size = 60;
-	tr.prp_sgl_bus_addr = 0xFF0FF;
+	tr.list = &list;
+	list.bus_addr = 0xFF0FF;
 	MOCK_SET(spdk_vtophys, 0xDEADBEEF);
 
 	rc = nvme_pcie_qpair_build_contig_hw_sgl_request(&qpair, &req, &tr, 0);
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.type == SPDK_NVME_SGL_TYPE_LAST_SEGMENT);
-	CU_ASSERT(req.cmd.dptr.sgl1.address == tr.prp_sgl_bus_addr);
+	CU_ASSERT(req.cmd.dptr.sgl1.address == list.bus_addr);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.length == 2 * sizeof(struct spdk_nvme_sgl_descriptor));
-	CU_ASSERT(tr.u.sgl[0].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
-	CU_ASSERT(tr.u.sgl[0].unkeyed.length == 60);
-	CU_ASSERT(tr.u.sgl[0].address == 0xDEADBEEF);
-	CU_ASSERT(tr.u.sgl[1].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
-	CU_ASSERT(tr.u.sgl[1].unkeyed.length == 40);
-	CU_ASSERT(tr.u.sgl[1].address == 0xDEADBEEF);
+	CU_ASSERT(list.u.sgl[0].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
+	CU_ASSERT(list.u.sgl[0].unkeyed.length == 60);
+	CU_ASSERT(list.u.sgl[0].address == 0xDEADBEEF);
+	CU_ASSERT(list.u.sgl[1].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
+	CU_ASSERT(list.u.sgl[1].unkeyed.length == 40);
+	CU_ASSERT(list.u.sgl[1].address == 0xDEADBEEF);
 
 	MOCK_CLEAR(spdk_vtophys);
 	g_vtophys_size = 0;
@@ -491,6 +515,7 @@ test_nvme_pcie_qpair_build_metadata(void)
 	struct nvme_pcie_qpair pqpair = {};
 	struct spdk_nvme_qpair *qpair = &pqpair.qpair;
 	struct nvme_tracker tr = {};
+	struct nvme_tracker_list list = {};
 	struct nvme_request req = {};
 	struct spdk_nvme_ctrlr	ctrlr = {};
 	int rc;
@@ -498,6 +523,8 @@ test_nvme_pcie_qpair_build_metadata(void)
 	ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
 	tr.req = &req;
 	qpair->ctrlr = &ctrlr;
+	STAILQ_INIT(&pqpair.free_lists);
+	STAILQ_INSERT_HEAD(&pqpair.free_lists, &list, stailq);
 
 	req.payload = NVME_PAYLOAD_CONTIG(NULL, (void *)0xDEADBEE0);
 	req.md_offset = 0;
@@ -508,16 +535,18 @@ test_nvme_pcie_qpair_build_metadata(void)
 	 * by this function. We need to verify if this indeed is the case.
 	 */
 	req.cmd.psdt = SPDK_NVME_PSDT_SGL_MPTR_CONTIG;
-	tr.prp_sgl_bus_addr = 0xDBADBEEF;
+	list.bus_addr = 0xDBADBEEF;
 	MOCK_SET(spdk_vtophys, 0xDCADBEE0);
 
 	rc = nvme_pcie_qpair_build_metadata(qpair, &tr, true, true, true);
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(req.cmd.psdt == SPDK_NVME_PSDT_SGL_MPTR_SGL);
-	CU_ASSERT(tr.meta_sgl.address == 0xDCADBEE0);
-	CU_ASSERT(tr.meta_sgl.unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
-	CU_ASSERT(tr.meta_sgl.unkeyed.length == 4096);
-	CU_ASSERT(tr.meta_sgl.unkeyed.subtype == 0);
+	CU_ASSERT(tr.list == &list);
+	CU_ASSERT(STAILQ_EMPTY(&pqpair.free_lists));
+	CU_ASSERT(list.meta_sgl.address == 0xDCADBEE0);
+	CU_ASSERT(list.meta_sgl.unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
+	CU_ASSERT(list.meta_sgl.unkeyed.length == 4096);
+	CU_ASSERT(list.meta_sgl.unkeyed.subtype == 0);
 	CU_ASSERT(req.cmd.mptr == (0xDBADBEEF - sizeof(struct spdk_nvme_sgl_descriptor)));
 
 	/* Non-IOVA contiguous metadata buffers should fail. */
@@ -537,15 +566,15 @@ test_nvme_pcie_qpair_build_metadata(void)
 	CU_ASSERT(req.cmd.mptr == 0xDDADBEE0);
 
 	/* Build non sgl metadata while sgls are supported */
-	memset(&tr.meta_sgl, 0, sizeof(tr.meta_sgl));
+	memset(&list.meta_sgl, 0, sizeof(list.meta_sgl));
 	/* If SGLs are supported, but not in metadata, the cmd.psdt
 	 * shall not be changed to SPDK_NVME_PSDT_SGL_MPTR_SGL
 	 */
 	req.cmd.psdt = SPDK_NVME_PSDT_SGL_MPTR_CONTIG;
 	rc = nvme_pcie_qpair_build_metadata(qpair, &tr, true, false, true);
 	CU_ASSERT(rc == 0);
-	CU_ASSERT(tr.meta_sgl.address == 0);
-	CU_ASSERT(tr.meta_sgl.unkeyed.length == 0);
+	CU_ASSERT(list.meta_sgl.address == 0);
+	CU_ASSERT(list.meta_sgl.unkeyed.length == 0);
 	CU_ASSERT(req.cmd.psdt == SPDK_NVME_PSDT_SGL_MPTR_CONTIG);
 	CU_ASSERT(req.cmd.mptr == 0xDDADBEE0);
 
@@ -625,6 +654,7 @@ test_nvme_pcie_qpair_build_hw_sgl_request(void)
 	struct spdk_nvme_qpair qpair = {};
 	struct nvme_request req = {};
 	struct nvme_tracker tr = {};
+	struct nvme_tracker_list list = {};
 	struct nvme_pcie_ut_bdev_io bio = {};
 	struct spdk_nvme_ctrlr ctrlr = {};
 	int rc;
@@ -633,7 +663,8 @@ test_nvme_pcie_qpair_build_hw_sgl_request(void)
 	qpair.ctrlr = &ctrlr;
 	req.payload = NVME_PAYLOAD_SGL(nvme_pcie_ut_reset_sgl, nvme_pcie_ut_next_sge, &bio, NULL);
 	req.cmd.opc = SPDK_NVME_OPC_WRITE;
-	tr.prp_sgl_bus_addr =  0xDAADBEE0;
+	tr.list = &list;
+	list.bus_addr = 0xDAADBEE0;
 	g_vtophys_size = 4096;
 
 	/* Multiple vectors, 2k + 4k + 2k */
@@ -648,17 +679,17 @@ test_nvme_pcie_qpair_build_hw_sgl_request(void)
 
 	rc = nvme_pcie_qpair_build_hw_sgl_request(&qpair, &req, &tr, true);
 	CU_ASSERT(rc == 0);
-	CU_ASSERT(tr.u.sgl[0].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
-	CU_ASSERT(tr.u.sgl[0].unkeyed.length == 2048);
-	CU_ASSERT(tr.u.sgl[0].address == 0xDBADBEE0);
-	CU_ASSERT(tr.u.sgl[0].unkeyed.subtype == 0);
-	CU_ASSERT(tr.u.sgl[1].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
-	CU_ASSERT(tr.u.sgl[1].unkeyed.length == 4096);
-	CU_ASSERT(tr.u.sgl[1].address == 0xDCADBEE0);
-	CU_ASSERT(tr.u.sgl[2].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
-	CU_ASSERT(tr.u.sgl[2].unkeyed.length == 2048);
-	CU_ASSERT(tr.u.sgl[2].unkeyed.length == 2048);
-	CU_ASSERT(tr.u.sgl[2].address == 0xDDADBEE0);
+	CU_ASSERT(list.u.sgl[0].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
+	CU_ASSERT(list.u.sgl[0].unkeyed.length == 2048);
+	CU_ASSERT(list.u.sgl[0].address == 0xDBADBEE0);
+	CU_ASSERT(list.u.sgl[0].unkeyed.subtype == 0);
+	CU_ASSERT(list.u.sgl[1].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
+	CU_ASSERT(list.u.sgl[1].unkeyed.length == 4096);
+	CU_ASSERT(list.u.sgl[1].address == 0xDCADBEE0);
+	CU_ASSERT(list.u.sgl[2].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
+	CU_ASSERT(list.u.sgl[2].unkeyed.length == 2048);
+	CU_ASSERT(list.u.sgl[2].unkeyed.length == 2048);
+	CU_ASSERT(list.u.sgl[2].address == 0xDDADBEE0);
 	CU_ASSERT(req.cmd.psdt == SPDK_NVME_PSDT_SGL_MPTR_CONTIG);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.subtype == 0);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.type == SPDK_NVME_SGL_TYPE_LAST_SEGMENT);
@@ -678,10 +709,7 @@ test_nvme_pcie_qpair_build_hw_sgl_request(void)
 
 	rc = nvme_pcie_qpair_build_hw_sgl_request(&qpair, &req, &tr, true);
 	CU_ASSERT(rc == 0);
-	CU_ASSERT(tr.u.sgl[0].unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
-	CU_ASSERT(tr.u.sgl[0].unkeyed.length == 4096);
-	CU_ASSERT(tr.u.sgl[0].address == 0xDBADBEE0);
-	CU_ASSERT(tr.u.sgl[0].unkeyed.subtype == 0);
+	CU_ASSERT(tr.list == NULL);
 	CU_ASSERT(req.cmd.psdt == SPDK_NVME_PSDT_SGL_MPTR_CONTIG);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.subtype == 0);
 	CU_ASSERT(req.cmd.dptr.sgl1.unkeyed.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK);
@@ -702,7 +730,7 @@ test_nvme_pcie_qpair_build_contig_request(void)
 	ctrlr.page_size = 0x1000;
 
 	/* 1 prp, 4k-aligned */
-	prp_list_prep(&tr, &req, NULL);
+	prp_list_prep(&pqpair, &tr, &req, NULL);
 	req.payload = NVME_PAYLOAD_CONTIG((void *)0x100000, NULL);
 	req.payload_size = 0x1000;
 
@@ -711,7 +739,7 @@ test_nvme_pcie_qpair_build_contig_request(void)
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100000);
 
 	/* 2 prps, non-4K-aligned */
-	prp_list_prep(&tr, &req, NULL);
+	prp_list_prep(&pqpair, &tr, &req, NULL);
 	req.payload = NVME_PAYLOAD_CONTIG((void *)0x100000, NULL);
 	req.payload_size = 0x1000;
 	req.payload_offset = 0x800;
@@ -720,21 +748,22 @@ test_nvme_pcie_qpair_build_contig_request(void)
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100800);
 	CU_ASSERT(req.cmd.dptr.prp.prp2 == 0x101000);
+	CU_ASSERT(tr.list == NULL);
 
 	/* 3 prps, 4k-aligned */
-	prp_list_prep(&tr, &req, NULL);
+	prp_list_prep(&pqpair, &tr, &req, NULL);
 	req.payload = NVME_PAYLOAD_CONTIG((void *)0x100000, NULL);
 	req.payload_size = 0x3000;
 
 	rc = nvme_pcie_qpair_build_contig_request(&pqpair.qpair, &req, &tr, true);
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x100000);
-	CU_ASSERT(req.cmd.dptr.prp.prp2 == tr.prp_sgl_bus_addr);
-	CU_ASSERT(tr.u.prp[0] == 0x101000);
-	CU_ASSERT(tr.u.prp[1] == 0x102000);
+	CU_ASSERT(req.cmd.dptr.prp.prp2 == g_tracker_list.bus_addr);
+	CU_ASSERT(tr.list->u.prp[0] == 0x101000);
+	CU_ASSERT(tr.list->u.prp[1] == 0x102000);
 
 	/* address not dword aligned */
-	prp_list_prep(&tr, &req, NULL);
+	prp_list_prep(&pqpair, &tr, &req, NULL);
 	req.payload = NVME_PAYLOAD_CONTIG((void *)0x100001, NULL);
 	req.payload_size = 0x3000;
 	req.qpair = &pqpair.qpair;
@@ -745,6 +774,173 @@ test_nvme_pcie_qpair_build_contig_request(void)
 	CU_ASSERT(rc == -EFAULT);
 }
 
+static void
+test_nvme_pcie_qpair_tracker_lists(void)
+{
+	struct nvme_pcie_qpair pqpair = {};
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct nvme_tracker tr = {};
+	struct nvme_tracker_list *list;
+	struct nvme_request req = {};
+	struct spdk_nvme_pcie_stat stat = {};
+	uint16_t count = 0;
+	int rc;
+
+	ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pqpair.qpair.ctrlr = &ctrlr;
+	pqpair.num_trackers = NVME_PCIE_TRACKER_LISTS_PER_CHUNK + 4;
+	STAILQ_INIT(&pqpair.free_lists);
+
+	/* The slab grows by a chunk at a time, up to one list per tracker */
+	rc = nvme_pcie_qpair_grow_lists(&pqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pqpair.num_lists == NVME_PCIE_TRACKER_LISTS_PER_CHUNK);
+	rc = nvme_pcie_qpair_grow_lists(&pqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pqpair.num_lists == NVME_PCIE_TRACKER_LISTS_PER_CHUNK + 4);
+	rc = nvme_pcie_qpair_grow_lists(&pqpair.qpair);
+	CU_ASSERT(rc == -ENOMEM);
+
+	STAILQ_FOREACH(list, &pqpair.free_lists, stailq) {
+		CU_ASSERT(list->bus_addr == (uintptr_t)list + offsetof(struct nvme_tracker_list, u.prp));
+		count++;
+	}
+	CU_ASSERT(count == pqpair.num_lists);
+
+	/* A tracker takes a list on first use and keeps it until it is put back */
+	list = nvme_pcie_tracker_get_list(&pqpair.qpair, &tr);
+	CU_ASSERT(list != NULL);
+	CU_ASSERT(tr.list == list);
+	CU_ASSERT(nvme_pcie_tracker_get_list(&pqpair.qpair, &tr) == list);
+	CU_ASSERT(STAILQ_FIRST(&pqpair.free_lists) != list);
+
+	nvme_pcie_tracker_put_list(&pqpair, &tr);
+	CU_ASSERT(tr.list == NULL);
+	CU_ASSERT(STAILQ_FIRST(&pqpair.free_lists) == list);
+
+	nvme_pcie_qpair_free_lists(&pqpair);
+	CU_ASSERT(pqpair.list_chunks == NULL);
+	CU_ASSERT(pqpair.num_lists == 0);
+	CU_ASSERT(STAILQ_EMPTY(&pqpair.free_lists));
+
+	/* A request needing a list fails when the slab can't grow, rather than being queued */
+	pqpair.qpair.id = 1;
+	pqpair.stat = &stat;
+	TAILQ_INIT(&pqpair.free_tr);
+	TAILQ_INIT(&pqpair.outstanding_tr);
+	TAILQ_INSERT_HEAD(&pqpair.free_tr, &tr, tq_list);
+	req.payload_size = 4096;
+	MOCK_SET(spdk_zmalloc, NULL);
+
+	rc = nvme_pcie_qpair_submit_request(&pqpair.qpair, &req);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(stat.queued_requests == 0);
+	CU_ASSERT(stat.submitted_requests == 0);
+	CU_ASSERT(TAILQ_FIRST(&pqpair.free_tr) == &tr);
+	MOCK_CLEAR(spdk_zmalloc);
+}
+
+static void
+test_nvme_pcie_qpair_doorbell_batch(void)
+{
+	struct nvme_pcie_ctrlr pctrlr = {};
+	struct nvme_pcie_qpair pqpair = {};
+	struct spdk_nvme_qpair *qpair = &pqpair.qpair;
+	struct spdk_nvme_pcie_stat stat = {};
+	struct spdk_nvme_cmd *cmd;
+	struct spdk_nvme_cpl cpl[8] = {};
+	struct nvme_tracker tr[8] = {};
+	struct nvme_request *req[5];
+	uint32_t sq_tdbl = 0, cq_hdbl = 0;
+	int i, rc;
+
+	/* Commands are copied with aligned vector instructions */
+	cmd = spdk_zmalloc(8 * sizeof(*cmd), 64, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	SPDK_CU_ASSERT_FATAL(cmd != NULL);
+
+	pctrlr.ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	qpair->ctrlr = &pctrlr.ctrlr;
+	qpair->id = 1;
+	nvme_qpair_set_state(qpair, NVME_QPAIR_CONNECTED);
+	STAILQ_INIT(&qpair->free_req);
+	pqpair.cmd = cmd;
+	pqpair.cpl = cpl;
+	pqpair.tr = tr;
+	pqpair.sq_tdbl = &sq_tdbl;
+	pqpair.cq_hdbl = &cq_hdbl;
+	pqpair.stat = &stat;
+	pqpair.num_entries = 8;
+	pqpair.max_completions_cap = 2;
+	pqpair.sq_head = 7;
+	pqpair.flags.phase = 1;
+	TAILQ_INIT(&pqpair.outstanding_tr);
+
+	for (i = 0; i < 5; i++) {
+		req[i] = spdk_zmalloc(sizeof(*req[i]), 64, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+		SPDK_CU_ASSERT_FATAL(req[i] != NULL);
+		tr[i].cid = i;
+		tr[i].req = req[i];
+		req[i]->cmd.cid = i;
+		req[i]->qpair = qpair;
+		qpair->num_outstanding_reqs++;
+		TAILQ_INSERT_TAIL(&pqpair.outstanding_tr, &tr[i], tq_list);
+	}
+
+	/* With delay_cmd_submit, the SQ doorbell is rung every sq_doorbell_batch commands */
+	pqpair.flags.delay_cmd_submit = 1;
+	pqpair.sq_doorbell_batch = 3;
+	nvme_pcie_qpair_submit_tracker(qpair, &tr[0]);
+	nvme_pcie_qpair_submit_tracker(qpair, &tr[1]);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 0);
+	nvme_pcie_qpair_submit_tracker(qpair, &tr[2]);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 1);
+	CU_ASSERT(sq_tdbl == 3);
+	nvme_pcie_qpair_submit_tracker(qpair, &tr[3]);
+	nvme_pcie_qpair_submit_tracker(qpair, &tr[4]);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 1);
+
+	/* The remaining commands are submitted when polling */
+	rc = nvme_pcie_qpair_process_completions(qpair, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 2);
+	CU_ASSERT(sq_tdbl == 5);
+	CU_ASSERT(stat.cq_mmio_doorbell_updates == 0);
+
+	/* The CQ head doorbell is written every cq_doorbell_batch completions */
+	pqpair.cq_doorbell_batch = 2;
+	for (i = 0; i < 3; i++) {
+		cpl[i].cid = i;
+		cpl[i].sqhd = 7;
+		cpl[i].status.p = 1;
+	}
+
+	rc = nvme_pcie_qpair_process_completions(qpair, 1);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(stat.cq_mmio_doorbell_updates == 0);
+	CU_ASSERT(pqpair.cq_doorbell_pending == 1);
+
+	rc = nvme_pcie_qpair_process_completions(qpair, 1);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(stat.cq_mmio_doorbell_updates == 1);
+	CU_ASSERT(cq_hdbl == 2);
+	CU_ASSERT(pqpair.cq_doorbell_pending == 0);
+
+	/* A poll without completions writes the doorbell for the pending ones */
+	rc = nvme_pcie_qpair_process_completions(qpair, 0);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(stat.cq_mmio_doorbell_updates == 1);
+	rc = nvme_pcie_qpair_process_completions(qpair, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(stat.cq_mmio_doorbell_updates == 2);
+	CU_ASSERT(cq_hdbl == 3);
+	CU_ASSERT(pqpair.cq_doorbell_pending == 0);
+
+	for (i = 0; i < 5; i++) {
+		spdk_free(req[i]);
+	}
+	spdk_free(cmd);
+}
+
 static void
 test_nvme_pcie_ctrlr_regs_get_set(void)
 {
@@ -1125,6 +1321,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_pcie_qpair_build_prps_sgl_request);
 	CU_ADD_TEST(suite, test_nvme_pcie_qpair_build_hw_sgl_request);
 	CU_ADD_TEST(suite, test_nvme_pcie_qpair_build_contig_request);
+	CU_ADD_TEST(suite, test_nvme_pcie_qpair_tracker_lists);
+	CU_ADD_TEST(suite, test_nvme_pcie_qpair_doorbell_batch);
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_regs_get_set);
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_map_unmap_cmb);
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_map_io_cmb);
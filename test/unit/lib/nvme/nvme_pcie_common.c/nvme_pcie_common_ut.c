@@ -52,6 +52,7 @@ DEFINE_STUB_V(nvme_ctrlr_disable, (struct spdk_nvme_ctrlr *ctrlr));
 DEFINE_STUB(nvme_ctrlr_disable_poll, int, (struct spdk_nvme_ctrlr *ctrlr), 0);
 
 DEFINE_STUB_V(nvme_transport_ctrlr_disconnect_qpair_done, (struct spdk_nvme_qpair *qpair));
+DEFINE_STUB_V(nvme_qpair_tally_latency, (struct spdk_nvme_qpair *qpair, struct nvme_request *req));
 
 int
 nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
@@ -129,6 +130,7 @@ test_nvme_pcie_qpair_construct_destroy(void)
 	cmb_offset = pctrlr.cmb.current_offset;
 	/* Make sure that CMB size is big enough and includes page alignment */
 	pctrlr.cmb.size = (1 << 16) + page_align;
+	pctrlr.cmb.sqs_supported = true;
 	pctrlr.doorbell_base = (void *)0xF7000000;
 	pctrlr.doorbell_stride_u32 = 1;
 
@@ -137,12 +139,14 @@ test_nvme_pcie_qpair_construct_destroy(void)
 			      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
 	SPDK_CU_ASSERT_FATAL(pqpair != NULL);
 	pqpair->qpair.ctrlr = &pctrlr.ctrlr;
+	pqpair->qpair.trtype = SPDK_NVME_TRANSPORT_PCIE;
 	pqpair->num_entries = 2;
 	pqpair->qpair.id = 1;
 	pqpair->cpl = cpl;
 
 	/* Enable submission queue in controller memory buffer. */
 	pctrlr.ctrlr.opts.use_cmb_sqs = true;
+	opts.use_cmb_sq = true;
 
 	rc = nvme_pcie_qpair_construct(&pqpair->qpair, &opts);
 	CU_ASSERT(rc == 0);
@@ -162,10 +166,51 @@ test_nvme_pcie_qpair_construct_destroy(void)
 	CU_ASSERT(pctrlr.cmb.current_offset == (uintptr_t)pqpair->cmd + (pqpair->num_entries * sizeof(
 				struct spdk_nvme_cmd)) - (uintptr_t)pctrlr.cmb.bar_va);
 	cmb_offset = pctrlr.cmb.current_offset;
+	CU_ASSERT(spdk_nvme_qpair_is_sq_in_cmb(&pqpair->qpair) == true);
 	nvme_pcie_qpair_destroy(&pqpair->qpair);
 
+	/* Per-qpair opt-in without the controller wide option. */
+	pctrlr.ctrlr.opts.use_cmb_sqs = false;
+	pqpair = spdk_zmalloc(sizeof(*pqpair), 64, NULL,
+			      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+	SPDK_CU_ASSERT_FATAL(pqpair != NULL);
+	pqpair->qpair.ctrlr = &pctrlr.ctrlr;
+	pqpair->num_entries = 2;
+	pqpair->qpair.id = 1;
+	pqpair->cpl = cpl;
+
+	rc = nvme_pcie_qpair_construct(&pqpair->qpair, &opts);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pqpair->sq_in_cmb == true);
+	CU_ASSERT(pqpair->cmd_bus_addr == (((pctrlr.cmb.bar_pa + cmb_offset) + page_align - 1) & ~
+					   (page_align - 1)));
+	cmb_offset = pctrlr.cmb.current_offset;
+	nvme_pcie_qpair_destroy(&pqpair->qpair);
+
+	/* No CMB space left, the SQ falls back to host memory. */
+	pctrlr.cmb.current_offset = pctrlr.cmb.size;
+	pqpair = spdk_zmalloc(sizeof(*pqpair), 64, NULL,
+			      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+	SPDK_CU_ASSERT_FATAL(pqpair != NULL);
+	pqpair->qpair.ctrlr = &pctrlr.ctrlr;
+	pqpair->qpair.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pqpair->num_entries = 2;
+	pqpair->qpair.id = 1;
+	pqpair->cpl = cpl;
+
+	rc = nvme_pcie_qpair_construct(&pqpair->qpair, &opts);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pqpair->sq_in_cmb == false);
+	CU_ASSERT(pqpair->cmd == (void *)0xDCADBEEF);
+	CU_ASSERT(pqpair->cmd_bus_addr == 0xDEADBEEF);
+	CU_ASSERT(pctrlr.cmb.current_offset == pctrlr.cmb.size);
+	CU_ASSERT(spdk_nvme_qpair_is_sq_in_cmb(&pqpair->qpair) == false);
+	nvme_pcie_qpair_destroy(&pqpair->qpair);
+	pctrlr.cmb.current_offset = cmb_offset;
+
 	/* Disable submission queue in controller memory buffer. */
 	pctrlr.ctrlr.opts.use_cmb_sqs = false;
+	opts.use_cmb_sq = false;
 	pqpair = spdk_zmalloc(sizeof(*pqpair), 64, NULL,
 			      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
 	SPDK_CU_ASSERT_FATAL(pqpair != NULL);
@@ -579,6 +624,60 @@ test_nvme_pcie_poll_group_get_stats(void)
 	CU_ASSERT(rc == 0);
 }
 
+static void
+dummy_timeout_cb(void *cb_arg, struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair,
+		 uint16_t cid)
+{
+}
+
+static void
+test_nvme_pcie_qpair_check_timeout(void)
+{
+	struct nvme_pcie_qpair pqpair = {};
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct spdk_nvme_ctrlr_process proc = {};
+	struct nvme_tracker tr = {};
+	struct nvme_request req = {};
+
+	ctrlr.state = NVME_CTRLR_STATE_READY;
+	pqpair.qpair.id = 1;
+	pqpair.qpair.ctrlr = &ctrlr;
+	pqpair.qpair.active_proc = &proc;
+	TAILQ_INIT(&pqpair.outstanding_tr);
+	proc.timeout_cb_fn = dummy_timeout_cb;
+	proc.timeout_io_ticks = 1600;
+	ut_spdk_get_ticks = 1000;
+
+	/* Nothing outstanding, the next check is due once a new request may time out */
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(pqpair.timeout_check_tick == 2600);
+	CU_ASSERT(pqpair.timeout_check_ticks == 1600);
+
+	/* The next check is due when the oldest request may time out, rounded up to its bucket */
+	req.submit_tick = 1010;
+	tr.req = &req;
+	TAILQ_INSERT_TAIL(&pqpair.outstanding_tr, &tr, tq_list);
+	MOCK_SET(nvme_request_check_timeout, 1);
+	pqpair.timeout_check_tick = 0;
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(pqpair.timeout_check_tick == 2700);
+
+	/* Changing the timeout takes effect before the next check is due */
+	proc.timeout_io_ticks = 800;
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(pqpair.timeout_check_tick == 1850);
+	CU_ASSERT(pqpair.timeout_check_ticks == 800);
+
+	/* Once the oldest request has timed out, the next one determines when to check again */
+	MOCK_SET(nvme_request_check_timeout, 0);
+	ut_spdk_get_ticks = 1850;
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(pqpair.timeout_check_tick == 2650);
+
+	MOCK_CLEAR(nvme_request_check_timeout);
+	ut_spdk_get_ticks = 0;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -594,6 +693,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_connect_qpair);
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_construct_admin_qpair);
 	CU_ADD_TEST(suite, test_nvme_pcie_poll_group_get_stats);
+	CU_ADD_TEST(suite, test_nvme_pcie_qpair_check_timeout);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
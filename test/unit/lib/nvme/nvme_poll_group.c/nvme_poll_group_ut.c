@@ -33,6 +33,7 @@ struct spdk_nvme_transport t4 = {
 };
 
 int64_t g_process_completions_return_value = 0;
+uint32_t g_process_completions_calls = 0;
 int g_destroy_return_value = 0;
 
 TAILQ_HEAD(nvme_transport_list, spdk_nvme_transport) g_spdk_nvme_transports =
@@ -47,6 +48,10 @@ DEFINE_STUB(nvme_transport_get_trtype,
 	    enum spdk_nvme_transport_type,
 	    (const struct spdk_nvme_transport *transport),
 	    SPDK_NVME_TRANSPORT_PCIE);
+DEFINE_STUB(spdk_nvme_qpair_get_fd, int, (struct spdk_nvme_qpair *qpair), -ENOTSUP);
+DEFINE_STUB_V(nvme_ctrlr_disconnect_qpair, (struct spdk_nvme_qpair *qpair));
+DEFINE_STUB(nvme_qpair_stripes_disconnected, bool, (struct spdk_nvme_qpair *qpair), true);
+DEFINE_STUB(nvme_qpair_process_msgs, int, (struct spdk_nvme_qpair *qpair), 0);
 
 int
 nvme_transport_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
@@ -193,6 +198,10 @@ int64_t
 nvme_transport_poll_group_process_completions(struct spdk_nvme_transport_poll_group *group,
 		uint32_t completions_per_qpair, spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb)
 {
+	/* Each poll takes 1us, so that hybrid polling windows expire. */
+	spdk_delay_us(1);
+	g_process_completions_calls++;
+
 	return g_process_completions_return_value;
 }
 
@@ -412,6 +421,68 @@ test_spdk_nvme_poll_group_process_completions(void)
 	TAILQ_REMOVE(&g_spdk_nvme_transports, &t3, link);
 }
 
+static void
+test_spdk_nvme_poll_group_interrupt(void)
+{
+	struct spdk_nvme_poll_group *group;
+	struct spdk_nvme_transport_poll_group *tgroup, *tmp_tgroup;
+	struct spdk_nvme_qpair qpair1_1 = {0};
+	struct pollfd pfd = {};
+	uint64_t count = 1;
+	int efd;
+
+	TAILQ_INSERT_TAIL(&g_spdk_nvme_transports, &t1, link);
+
+	group = spdk_nvme_poll_group_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+
+	pfd.fd = spdk_nvme_poll_group_get_fd(group);
+	CU_ASSERT(pfd.fd >= 0);
+	pfd.events = POLLIN;
+
+	/* The interrupt eventfd of the qpair is added to the group. */
+	efd = eventfd(0, EFD_NONBLOCK);
+	SPDK_CU_ASSERT_FATAL(efd >= 0);
+	MOCK_SET(spdk_nvme_qpair_get_fd, efd);
+	qpair1_1.state = NVME_QPAIR_DISCONNECTED;
+	qpair1_1.transport = &t1;
+	CU_ASSERT(spdk_nvme_poll_group_add(group, &qpair1_1) == 0);
+	qpair1_1.state = NVME_QPAIR_ENABLED;
+	CU_ASSERT(nvme_poll_group_connect_qpair(&qpair1_1) == 0);
+	CU_ASSERT(poll(&pfd, 1, 0) == 0);
+
+	/* An interrupt wakes the group up, waiting clears it and processes the completions. */
+	CU_ASSERT(write(efd, &count, sizeof(count)) == sizeof(count));
+	CU_ASSERT(poll(&pfd, 1, 0) == 1);
+	g_process_completions_return_value = 4;
+	CU_ASSERT(spdk_nvme_poll_group_wait(group, unit_test_disconnected_qpair_cb) == 4);
+	CU_ASSERT(poll(&pfd, 1, 0) == 0);
+	CU_ASSERT(read(efd, &count, sizeof(count)) < 0 && errno == EAGAIN);
+
+	/* Hybrid polling keeps polling for the window after the last completion. */
+	spdk_nvme_poll_group_set_hybrid_poll(group, 10);
+	CU_ASSERT(group->hybrid_poll_ticks == 10 * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC);
+	g_process_completions_return_value = 0;
+	g_process_completions_calls = 0;
+	CU_ASSERT(spdk_nvme_poll_group_wait(group, unit_test_disconnected_qpair_cb) == 0);
+	CU_ASSERT(g_process_completions_calls == 10);
+	spdk_nvme_poll_group_set_hybrid_poll(group, 0);
+
+	CU_ASSERT(spdk_nvme_poll_group_remove(group, &qpair1_1) == 0);
+	CU_ASSERT(write(efd, &count, sizeof(count)) == sizeof(count));
+	CU_ASSERT(poll(&pfd, 1, 0) == 0);
+	MOCK_SET(spdk_nvme_qpair_get_fd, -ENOTSUP);
+	close(efd);
+
+	STAILQ_FOREACH_SAFE(tgroup, &group->tgroups, link, tmp_tgroup) {
+		STAILQ_REMOVE(&group->tgroups, tgroup, spdk_nvme_transport_poll_group, link);
+		free(tgroup);
+	}
+	SPDK_CU_ASSERT_FATAL(spdk_nvme_poll_group_destroy(group) == 0);
+
+	TAILQ_REMOVE(&g_spdk_nvme_transports, &t1, link);
+}
+
 static void
 test_spdk_nvme_poll_group_destroy(void)
 {
@@ -502,6 +573,7 @@ main(int argc, char **argv)
 			    test_spdk_nvme_poll_group_add_remove) == NULL ||
 		CU_add_test(suite, "nvme_poll_group_process_completions",
 			    test_spdk_nvme_poll_group_process_completions) == NULL ||
+		CU_add_test(suite, "nvme_poll_group_interrupt", test_spdk_nvme_poll_group_interrupt) == NULL ||
 		CU_add_test(suite, "nvme_poll_group_destroy_test", test_spdk_nvme_poll_group_destroy) == NULL ||
 		CU_add_test(suite, "nvme_poll_group_get_free_stats",
 			    test_spdk_nvme_poll_group_get_free_stats) == NULL
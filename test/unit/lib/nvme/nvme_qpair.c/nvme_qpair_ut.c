@@ -26,10 +26,12 @@ struct nvme_driver _g_nvme_driver = {
 DEFINE_STUB_V(nvme_transport_qpair_abort_reqs, (struct spdk_nvme_qpair *qpair));
 DEFINE_STUB(nvme_transport_qpair_submit_request, int,
 	    (struct spdk_nvme_qpair *qpair, struct nvme_request *req), 0);
+DEFINE_STUB(nvme_transport_qpair_get_fd, int, (struct spdk_nvme_qpair *qpair), -ENOTSUP);
 DEFINE_STUB(spdk_nvme_ctrlr_free_io_qpair, int, (struct spdk_nvme_qpair *qpair), 0);
 DEFINE_STUB_V(nvme_transport_ctrlr_disconnect_qpair, (struct spdk_nvme_ctrlr *ctrlr,
 		struct spdk_nvme_qpair *qpair));
 DEFINE_STUB_V(nvme_ctrlr_disconnect_qpair, (struct spdk_nvme_qpair *qpair));
+DEFINE_STUB(spdk_nvme_ctrlr_get_num_ns, uint32_t, (struct spdk_nvme_ctrlr *ctrlr), 0);
 
 DEFINE_STUB_V(nvme_ctrlr_complete_queued_async_events, (struct spdk_nvme_ctrlr *ctrlr));
 DEFINE_STUB_V(nvme_ctrlr_abort_queued_aborts, (struct spdk_nvme_ctrlr *ctrlr));
@@ -596,7 +598,7 @@ test_nvme_qpair_resubmit_request_with_transport_failed(void)
 	g_num_cb_failed = 0;
 	MOCK_SET(nvme_transport_qpair_submit_request, -EINVAL);
 	rc = spdk_nvme_qpair_process_completions(&qpair, g_transport_process_completions_rc);
-	MOCK_CLEAR(nvme_transport_qpair_submit_request);
+	MOCK_SET(nvme_transport_qpair_submit_request, 0);
 	CU_ASSERT(rc == g_transport_process_completions_rc);
 	CU_ASSERT(STAILQ_EMPTY(&qpair.queued_req));
 	CU_ASSERT(g_num_cb_failed == 1);
@@ -744,6 +746,210 @@ test_nvme_get_sgl_print_info(void)
 			   NVME_CMD_DPTR_STR_SIZE));
 }
 
+static uint32_t
+ut_num_free_reqs(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_request *req;
+	uint32_t num_free_reqs = 0;
+
+	STAILQ_FOREACH(req, &qpair->free_req, stailq) {
+		CU_ASSERT(req->qpair == qpair);
+		num_free_reqs++;
+	}
+
+	return num_free_reqs;
+}
+
+static void
+test_nvme_qpair_submit_request_striped(void)
+{
+	struct spdk_nvme_qpair qpair = {}, stripe = {};
+	struct spdk_nvme_qpair *stripes[] = { &stripe };
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct nvme_request *req;
+
+	MOCK_SET(nvme_transport_qpair_submit_request, 0);
+
+	prepare_submit_request_test(&qpair, &ctrlr);
+	nvme_qpair_init(&stripe, 2, &ctrlr, 0, 32, false);
+	qpair.state = NVME_QPAIR_ENABLED;
+	stripe.state = NVME_QPAIR_ENABLED;
+	qpair.stripes = stripes;
+	qpair.num_stripes = 1;
+	stripe.stripe_parent = &qpair;
+
+	/* Requests alternate between the connections. */
+	req = nvme_allocate_request_null(&qpair, NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	CU_ASSERT(nvme_qpair_submit_request(&qpair, req) == 0);
+	CU_ASSERT(req->qpair == &qpair);
+	CU_ASSERT(qpair.num_outstanding_reqs == 1);
+	nvme_free_request(req);
+
+	req = nvme_allocate_request_null(&qpair, NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	CU_ASSERT(nvme_qpair_submit_request(&qpair, req) == 0);
+	CU_ASSERT(req->qpair == &stripe);
+	CU_ASSERT(qpair.num_outstanding_reqs == 0);
+	CU_ASSERT(stripe.num_outstanding_reqs == 1);
+	CU_ASSERT(spdk_nvme_qpair_get_num_outstanding_reqs(&qpair) == 1);
+
+	/* The connection gave one of its free requests to the user's qpair in exchange. */
+	CU_ASSERT(ut_num_free_reqs(&qpair) == 32);
+	CU_ASSERT(ut_num_free_reqs(&stripe) == 31);
+	nvme_free_request(req);
+	CU_ASSERT(ut_num_free_reqs(&stripe) == 32);
+	CU_ASSERT(spdk_nvme_qpair_get_num_outstanding_reqs(&qpair) == 0);
+
+	/* Connections that are not enabled are skipped. */
+	stripe.state = NVME_QPAIR_CONNECTING;
+	req = nvme_allocate_request_null(&qpair, NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	CU_ASSERT(nvme_qpair_submit_request(&qpair, req) == 0);
+	CU_ASSERT(req->qpair == &qpair);
+	nvme_free_request(req);
+
+	req = nvme_allocate_request_null(&qpair, NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	CU_ASSERT(nvme_qpair_submit_request(&qpair, req) == 0);
+	CU_ASSERT(req->qpair == &qpair);
+	nvme_free_request(req);
+
+	/* Fabrics commands stay on the qpair they were allocated from. */
+	stripe.state = NVME_QPAIR_ENABLED;
+	qpair.next_stripe = 1;
+	req = nvme_allocate_request_null(&qpair, NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	req->cmd.opc = SPDK_NVME_OPC_FABRIC;
+	CU_ASSERT(nvme_qpair_submit_request(&qpair, req) == 0);
+	CU_ASSERT(req->qpair == &qpair);
+	nvme_free_request(req);
+
+	cleanup_submit_request_test(&stripe);
+	cleanup_submit_request_test(&qpair);
+}
+
+static void
+ut_qpair_msg_fn(struct spdk_nvme_qpair *qpair, void *ctx)
+{
+	uint32_t *count = ctx;
+
+	(*count)++;
+}
+
+static void
+test_nvme_qpair_send_msg(void)
+{
+	struct spdk_nvme_qpair qpair = {};
+	struct spdk_nvme_ctrlr ctrlr = {};
+	uint32_t count = 0;
+	struct spdk_nvme_qpair_msg msg = { .fn = ut_qpair_msg_fn, .ctx = &count };
+
+	prepare_submit_request_test(&qpair, &ctrlr);
+
+	/* Messages need a submission ring. */
+	CU_ASSERT(spdk_nvme_qpair_send_msg(&qpair, &msg) == -ENOTSUP);
+
+	CU_ASSERT(nvme_qpair_init_submit_ring(&qpair, 8) == 0);
+	CU_ASSERT(spdk_nvme_qpair_send_msg(&qpair, &msg) == 0);
+	CU_ASSERT(spdk_nvme_qpair_send_msg(&qpair, &msg) == 0);
+	CU_ASSERT(count == 0);
+
+	/* Messages are executed when the qpair is polled. */
+	qpair.state = NVME_QPAIR_ENABLED;
+	g_transport_process_completions_rc = 0;
+	CU_ASSERT(spdk_nvme_qpair_process_completions(&qpair, 0) == 0);
+	CU_ASSERT(count == 2);
+	CU_ASSERT(nvme_qpair_process_msgs(&qpair) == 0);
+
+	spdk_ring_free(qpair.submit_ring);
+	cleanup_submit_request_test(&qpair);
+}
+
+struct ut_histogram_ctx {
+	uint64_t	latency;
+	uint64_t	count;
+};
+
+static void
+ut_histogram_count(void *_ctx, uint64_t start, uint64_t end, uint64_t count,
+		   uint64_t total, uint64_t so_far)
+{
+	struct ut_histogram_ctx *ctx = _ctx;
+
+	if (count != 0) {
+		CU_ASSERT(start <= ctx->latency && ctx->latency < end);
+		ctx->count += count;
+	}
+}
+
+static void
+test_nvme_qpair_latency_tracking(void)
+{
+	struct spdk_nvme_qpair qpair = {}, admin_qpair = {};
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct spdk_nvme_cpl cpl = {};
+	struct nvme_qpair_latency *latency;
+	const struct spdk_histogram_data *histogram;
+	struct nvme_request *req;
+	struct ut_histogram_ctx ctx = { .latency = 10 };
+
+	prepare_submit_request_test(&qpair, &ctrlr);
+	qpair.state = NVME_QPAIR_ENABLED;
+	MOCK_SET(spdk_nvme_ctrlr_get_num_ns, 2);
+	/* A submit tick of 0 means the request was not timed. */
+	spdk_delay_us(1);
+
+	/* Only I/O qpairs are tracked. */
+	admin_qpair.ctrlr = &ctrlr;
+	CU_ASSERT(spdk_nvme_qpair_enable_latency_tracking(&admin_qpair) == -EINVAL);
+
+	CU_ASSERT(spdk_nvme_qpair_enable_latency_tracking(&qpair) == 0);
+	latency = qpair.latency;
+	SPDK_CU_ASSERT_FATAL(latency != NULL);
+	CU_ASSERT(latency->num_ns == 2);
+	CU_ASSERT(spdk_nvme_qpair_enable_latency_tracking(&qpair) == 0);
+	CU_ASSERT(qpair.latency == latency);
+	CU_ASSERT(spdk_nvme_qpair_get_latency_histogram(&qpair, 1, SPDK_NVME_LATENCY_IO_READ) == NULL);
+
+	/* A read of namespace 1 taking 10 ticks. */
+	req = nvme_allocate_request_null(&qpair, expected_success_callback, NULL);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	req->cmd.opc = SPDK_NVME_OPC_READ;
+	req->cmd.nsid = 1;
+	CU_ASSERT(nvme_qpair_submit_request(&qpair, req) == 0);
+	CU_ASSERT(req->submit_tick != 0);
+	spdk_delay_us(10);
+	nvme_complete_request(req->cb_fn, req->cb_arg, &qpair, req, &cpl);
+	nvme_free_request(req);
+
+	histogram = spdk_nvme_qpair_get_latency_histogram(&qpair, 1, SPDK_NVME_LATENCY_IO_READ);
+	SPDK_CU_ASSERT_FATAL(histogram != NULL);
+	spdk_histogram_data_iterate(histogram, ut_histogram_count, &ctx);
+	CU_ASSERT(ctx.count == 1);
+	CU_ASSERT(spdk_nvme_qpair_get_latency_histogram(&qpair, 1, SPDK_NVME_LATENCY_IO_WRITE) == NULL);
+	CU_ASSERT(spdk_nvme_qpair_get_latency_histogram(&qpair, 2, SPDK_NVME_LATENCY_IO_READ) == NULL);
+	CU_ASSERT(spdk_nvme_qpair_get_latency_histogram(&qpair, 3, SPDK_NVME_LATENCY_IO_READ) == NULL);
+
+	/* Commands without a tracked namespace are ignored. */
+	req = nvme_allocate_request_null(&qpair, expected_success_callback, NULL);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	req->cmd.opc = SPDK_NVME_OPC_FLUSH;
+	req->cmd.nsid = 3;
+	CU_ASSERT(nvme_qpair_submit_request(&qpair, req) == 0);
+	nvme_complete_request(req->cb_fn, req->cb_arg, &qpair, req, &cpl);
+	nvme_free_request(req);
+	CU_ASSERT(spdk_nvme_qpair_get_latency_histogram(&qpair, 1, SPDK_NVME_LATENCY_IO_OTHER) == NULL);
+	CU_ASSERT(spdk_nvme_qpair_get_latency_histogram(&qpair, 2, SPDK_NVME_LATENCY_IO_OTHER) == NULL);
+
+	spdk_nvme_qpair_disable_latency_tracking(&qpair);
+	CU_ASSERT(qpair.latency == NULL);
+	CU_ASSERT(spdk_nvme_qpair_get_latency_histogram(&qpair, 1, SPDK_NVME_LATENCY_IO_READ) == NULL);
+
+	MOCK_CLEAR(spdk_nvme_ctrlr_get_num_ns);
+	cleanup_submit_request_test(&qpair);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -768,6 +974,9 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_qpair_manual_complete_request);
 	CU_ADD_TEST(suite, test_nvme_qpair_init_deinit);
 	CU_ADD_TEST(suite, test_nvme_get_sgl_print_info);
+	CU_ADD_TEST(suite, test_nvme_qpair_submit_request_striped);
+	CU_ADD_TEST(suite, test_nvme_qpair_send_msg);
+	CU_ADD_TEST(suite, test_nvme_qpair_latency_tracking);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
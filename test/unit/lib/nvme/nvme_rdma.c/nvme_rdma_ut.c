@@ -131,6 +131,7 @@ ibv_query_device(struct ibv_context *context,
 {
 	if (device_attr) {
 		device_attr->max_sge = NVME_RDMA_MAX_SGL_DESCRIPTORS;
+		device_attr->max_srq_wr = 1024;
 	}
 	HANDLE_RETURN_MOCK(ibv_query_device);
 
@@ -1046,6 +1047,126 @@ test_nvme_rdma_qpair_submit_request(void)
 	nvme_rdma_free_reqs(&rqpair);
 }
 
+static spdk_nvme_accel_completion_cb g_ut_seq_cb_fn;
+static void *g_ut_seq_cb_arg;
+static int g_ut_seq_reversed;
+static int g_ut_req_completed;
+
+static void
+ut_finish_sequence(void *seq, spdk_nvme_accel_completion_cb cb_fn, void *cb_arg)
+{
+	g_ut_seq_cb_fn = cb_fn;
+	g_ut_seq_cb_arg = cb_arg;
+}
+
+static void
+ut_reverse_sequence(void *seq)
+{
+	g_ut_seq_reversed++;
+}
+
+static void
+ut_abort_sequence(void *seq)
+{
+}
+
+static void
+ut_req_cb(void *ctx, const struct spdk_nvme_cpl *cpl)
+{
+	g_ut_req_completed++;
+	CU_ASSERT(!spdk_nvme_cpl_is_error(cpl));
+}
+
+static void
+test_nvme_rdma_accel_sequence(void)
+{
+	struct spdk_nvme_poll_group	group = {};
+	struct nvme_rdma_poll_group	rgroup = {};
+	struct nvme_rdma_qpair		rqpair = {};
+	struct spdk_nvme_ctrlr		ctrlr = {};
+	struct nvme_request		req = {};
+	struct spdk_nvme_rdma_rsp	rdma_rsp = {};
+	struct ibv_recv_wr		recv_wr = {};
+	struct nvme_rdma_rsps		rsps = {};
+	struct spdk_nvme_rdma_req	*rdma_req;
+	int				rc;
+
+	group.accel_fn_table.finish_sequence = ut_finish_sequence;
+	group.accel_fn_table.reverse_sequence = ut_reverse_sequence;
+	group.accel_fn_table.abort_sequence = ut_abort_sequence;
+	rgroup.group.group = &group;
+
+	rqpair.mr_map = (struct spdk_rdma_mem_map *)0xdeadbeef;
+	rqpair.rdma_qp = (struct spdk_rdma_qp *)0xdeadbeef;
+	rqpair.qpair.ctrlr = &ctrlr;
+	rqpair.qpair.poll_group = &rgroup.group;
+	rqpair.qpair.trtype = SPDK_NVME_TRANSPORT_RDMA;
+	rqpair.num_entries = 1;
+	rqpair.state = NVME_RDMA_QPAIR_STATE_RUNNING;
+	rqpair.rsps = &rsps;
+	STAILQ_INIT(&rqpair.qpair.free_req);
+	TAILQ_INIT(&rqpair.qpair.err_cmd_head);
+	rsps.num_entries = 1;
+
+	rc = nvme_rdma_create_reqs(&rqpair);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	rdma_req = TAILQ_FIRST(&rqpair.free_reqs);
+
+	/* The sequence of a write is finished before its command is sent */
+	req.cmd.opc = SPDK_NVME_OPC_WRITE;
+	req.payload = NVME_PAYLOAD_CONTIG((void *)0xdeadbeef, NULL);
+	req.payload_size = 0x1000;
+	req.qpair = &rqpair.qpair;
+	req.accel_sequence = (void *)0xfeedbeef;
+	req.cb_fn = ut_req_cb;
+
+	rc = nvme_rdma_qpair_submit_request(&rqpair.qpair, &req);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(rqpair.current_num_sends == 0);
+	CU_ASSERT(rqpair.current_num_accel == 1);
+	CU_ASSERT(rdma_req->in_progress_accel);
+	CU_ASSERT(g_ut_seq_cb_arg == rdma_req);
+
+	/* A request with its sequence in progress isn't aborted */
+	nvme_rdma_qpair_abort_reqs(&rqpair.qpair, 0);
+	CU_ASSERT(TAILQ_FIRST(&rqpair.outstanding_reqs) == rdma_req);
+
+	g_ut_seq_cb_fn(g_ut_seq_cb_arg, 0);
+	CU_ASSERT(rqpair.current_num_sends == 1);
+	CU_ASSERT(rqpair.current_num_accel == 0);
+	CU_ASSERT(!rdma_req->in_progress_accel);
+	CU_ASSERT(req.accel_sequence == NULL);
+
+	/* The sequence of a read is finished, in reverse, once the response was received */
+	rqpair.current_num_sends = 0;
+	req.cmd.opc = SPDK_NVME_OPC_READ;
+	req.accel_sequence = (void *)0xfeedbeef;
+	rdma_rsp.recv_wr = &recv_wr;
+	rdma_rsp.cpl.cdw0 = 0x1234;
+	rdma_req->rdma_rsp = &rdma_rsp;
+	rqpair.qpair.num_outstanding_reqs = 1;
+	g_ut_seq_cb_fn = NULL;
+
+	nvme_rdma_request_ready(&rqpair, rdma_req);
+	CU_ASSERT(g_ut_seq_reversed == 1);
+	CU_ASSERT(rqpair.current_num_accel == 1);
+	CU_ASSERT(rsps.current_num_recvs == 1);
+	CU_ASSERT(g_ut_req_completed == 0);
+	SPDK_CU_ASSERT_FATAL(g_ut_seq_cb_fn != NULL);
+
+	rdma_rsp.cpl.cdw0 = 0;
+	rqpair.num_completions = 0;
+	g_ut_seq_cb_fn(g_ut_seq_cb_arg, 0);
+	CU_ASSERT(g_ut_req_completed == 1);
+	CU_ASSERT(rqpair.current_num_accel == 0);
+	CU_ASSERT(rqpair.num_completions == 1);
+	CU_ASSERT(rdma_req->cpl.cdw0 == 0x1234);
+	CU_ASSERT(req.accel_sequence == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&rqpair.outstanding_reqs));
+
+	nvme_rdma_free_reqs(&rqpair);
+}
+
 static void
 test_nvme_rdma_memory_domain(void)
 {
@@ -1441,6 +1562,47 @@ test_nvme_rdma_qpair_set_poller(void)
 	nvme_rdma_poll_group_put_poller(group, rqpair.poller);
 	CU_ASSERT(STAILQ_EMPTY(&group->pollers));
 
+	rqpair.qpair.poll_group_tailq_head = &tgroup->connected_qpairs;
+
+	/* Test6: With an SRQ, the SRQ size is capped by the device and only the sends of the
+	 * qpairs are added to the CQ. */
+	g_spdk_nvme_transport_opts.rdma_srq_size = 4096;
+	MOCK_SET(spdk_rdma_get_pd, (struct ibv_pd *)0xFEEDBEEF);
+	MOCK_SET(spdk_rdma_create_mem_map, (struct spdk_rdma_mem_map *)0xFEEDBEEF);
+	rqpair.cq = NULL;
+	rqpair.num_entries = 1024;
+
+	rc = nvme_rdma_qpair_set_poller(&rqpair.qpair);
+	CU_ASSERT(rc == 0);
+
+	poller = STAILQ_FIRST(&group->pollers);
+	SPDK_CU_ASSERT_FATAL(poller != NULL);
+	SPDK_CU_ASSERT_FATAL(poller->rsps != NULL);
+	CU_ASSERT(poller->srq == &g_spdk_rdma_srq);
+	CU_ASSERT(poller->rsps->num_entries == 1024);
+	CU_ASSERT(poller->current_num_wc == 1024 * 2);
+	CU_ASSERT(poller->required_num_wc == 1024 + 1024);
+	CU_ASSERT(rqpair.srq == poller->srq);
+	CU_ASSERT(rqpair.rsps == poller->rsps);
+
+	/* A second qpair needs more send completions than the CQ has */
+	rqpair.cq = NULL;
+	rc = nvme_rdma_qpair_set_poller(&rqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(poller->refcnt == 2);
+	CU_ASSERT(poller->current_num_wc == 1024 * 4);
+	CU_ASSERT(poller->required_num_wc == 1024 * 3);
+
+	rqpair.qpair.poll_group_tailq_head = &tgroup->disconnected_qpairs;
+
+	nvme_rdma_poll_group_put_poller(group, poller);
+	nvme_rdma_poll_group_put_poller(group, poller);
+	CU_ASSERT(STAILQ_EMPTY(&group->pollers));
+
+	g_spdk_nvme_transport_opts.rdma_srq_size = 0;
+	MOCK_CLEAR(spdk_rdma_get_pd);
+	MOCK_CLEAR(spdk_rdma_create_mem_map);
+
 	rc = nvme_rdma_poll_group_destroy(tgroup);
 	CU_ASSERT(rc == 0);
 }
@@ -1470,6 +1632,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_rdma_parse_addr);
 	CU_ADD_TEST(suite, test_nvme_rdma_qpair_init);
 	CU_ADD_TEST(suite, test_nvme_rdma_qpair_submit_request);
+	CU_ADD_TEST(suite, test_nvme_rdma_accel_sequence);
 	CU_ADD_TEST(suite, test_nvme_rdma_memory_domain);
 	CU_ADD_TEST(suite, test_rdma_ctrlr_get_memory_domains);
 	CU_ADD_TEST(suite, test_rdma_get_memory_translation);
@@ -22,6 +22,8 @@ static void nvme_transport_ctrlr_disconnect_qpair_done_mocked(struct spdk_nvme_q
 
 SPDK_LOG_REGISTER_COMPONENT(nvme)
 
+struct spdk_nvme_transport_opts g_spdk_nvme_transport_opts = {};
+
 DEFINE_STUB(nvme_qpair_submit_request,
 	    int, (struct spdk_nvme_qpair *qpair, struct nvme_request *req), 0);
 
@@ -1091,6 +1093,49 @@ test_nvme_tcp_qpair_connect_sock(void)
 	SPDK_CU_ASSERT_FATAL(rc != 0);
 }
 
+static void
+test_nvme_tcp_qpair_connect_sock_zcopy_recv(void)
+{
+	struct nvme_tcp_ctrlr tctrlr = {};
+	struct spdk_nvme_ctrlr *ctrlr = &tctrlr.ctrlr;
+	struct nvme_tcp_qpair tqpair = {};
+	int rc;
+
+	tqpair.qpair.trtype = SPDK_NVME_TRANSPORT_TCP;
+	tqpair.qpair.id = 1;
+	ctrlr->trid.priority = 1;
+	ctrlr->trid.adrfam = SPDK_NVMF_ADRFAM_IPV4;
+	memcpy(ctrlr->trid.traddr, "192.168.1.78", sizeof("192.168.1.78"));
+	memcpy(ctrlr->trid.trsvcid, "23", sizeof("23"));
+
+	/* Disabled by default */
+	rc = nvme_tcp_qpair_connect_sock(ctrlr, &tqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tqpair.flags.zcopy_recv == 0);
+
+	/* Without a default sock implementation, the receive pipe is kept */
+	g_spdk_nvme_transport_opts.tcp_zcopy_recv = true;
+	rc = nvme_tcp_qpair_connect_sock(ctrlr, &tqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tqpair.flags.zcopy_recv == 0);
+
+	MOCK_SET(spdk_sock_get_default_impl, "posix");
+	rc = nvme_tcp_qpair_connect_sock(ctrlr, &tqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tqpair.flags.zcopy_recv == 1);
+
+	/* The admin queue always keeps the receive pipe, it doesn't use zcopy either */
+	MOCK_SET(spdk_sock_connect_ext, (struct spdk_sock *)0xDDADBEEF);
+	tqpair.qpair.id = 0;
+	rc = nvme_tcp_qpair_connect_sock(ctrlr, &tqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tqpair.flags.zcopy_recv == 0);
+
+	MOCK_CLEAR_P(spdk_sock_connect_ext);
+	MOCK_SET(spdk_sock_get_default_impl, NULL);
+	g_spdk_nvme_transport_opts.tcp_zcopy_recv = false;
+}
+
 static void
 test_nvme_tcp_qpair_icreq_send(void)
 {
@@ -1393,6 +1438,63 @@ test_nvme_tcp_capsule_resp_hdr_handle(void)
 	nvme_tcp_free_reqs(&tqpair);
 }
 
+static void
+test_nvme_tcp_read_pdu_zcopy_recv(void)
+{
+	struct nvme_tcp_qpair	tqpair = {};
+	struct spdk_nvme_ctrlr	ctrlr = {};
+	struct spdk_nvme_tcp_stat	stats = {};
+	struct nvme_request	req = {};
+	struct nvme_tcp_req	*tcp_req = NULL;
+	struct nvme_tcp_pdu	*pdu;
+	uint32_t		reaped = 0;
+	int			rc;
+
+	tqpair.num_entries = 1;
+	tqpair.stats = &stats;
+	tqpair.state = NVME_TCP_QPAIR_STATE_RUNNING;
+	tqpair.flags.zcopy_recv = 1;
+	req.qpair = &tqpair.qpair;
+	req.qpair->ctrlr = &ctrlr;
+	req.payload = NVME_PAYLOAD_CONTIG(NULL, NULL);
+
+	rc = nvme_tcp_alloc_reqs(&tqpair);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	tcp_req = nvme_tcp_req_get(&tqpair);
+	SPDK_CU_ASSERT_FATAL(tcp_req != NULL);
+	rc = nvme_tcp_req_init(&tqpair, &req, tcp_req);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	tcp_req->ordering.bits.send_ack = 1;
+	tqpair.qpair.num_outstanding_reqs = 1;
+
+	/* The socket mock does not touch the buffer, so the header is prepared in place */
+	pdu = tqpair.recv_pdu;
+	pdu->hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_CAPSULE_RESP;
+	pdu->hdr.common.hlen = sizeof(struct spdk_nvme_tcp_rsp);
+	pdu->hdr.common.plen = sizeof(struct spdk_nvme_tcp_rsp);
+	pdu->hdr.capsule_resp.rccqe.cid = 0;
+	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH;
+
+	/* The first read stops in the middle of the common header */
+	MOCK_SET(spdk_sock_recv, 4);
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped, 1);
+	CU_ASSERT(rc == NVME_TCP_PDU_IN_PROGRESS);
+	CU_ASSERT(pdu->ch_valid_bytes == 4);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH);
+
+	/* The second one returns the rest of the header, so the PDU specific header
+	 * does not need a read of its own */
+	MOCK_SET(spdk_sock_recv, sizeof(struct spdk_nvme_tcp_rsp) - 4);
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped, 1);
+	CU_ASSERT(reaped == 1);
+	CU_ASSERT(tcp_req->ordering.bits.data_recv == 1);
+	CU_ASSERT(tqpair.qpair.num_outstanding_reqs == 0);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+
+	MOCK_SET(spdk_sock_recv, 1);
+	nvme_tcp_free_reqs(&tqpair);
+}
+
 static void
 test_nvme_tcp_ctrlr_connect_qpair(void)
 {
@@ -1950,11 +2052,13 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_tcp_qpair_send_h2c_term_req);
 	CU_ADD_TEST(suite, test_nvme_tcp_pdu_ch_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_qpair_connect_sock);
+	CU_ADD_TEST(suite, test_nvme_tcp_qpair_connect_sock_zcopy_recv);
 	CU_ADD_TEST(suite, test_nvme_tcp_qpair_icreq_send);
 	CU_ADD_TEST(suite, test_nvme_tcp_c2h_payload_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_icresp_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_pdu_payload_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_capsule_resp_hdr_handle);
+	CU_ADD_TEST(suite, test_nvme_tcp_read_pdu_zcopy_recv);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_connect_qpair);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_disconnect_qpair);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_create_io_qpair);
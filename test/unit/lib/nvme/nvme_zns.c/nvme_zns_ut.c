@@ -0,0 +1,587 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk_internal/cunit.h"
+
+#include "spdk/env.h"
+
+#include "nvme/nvme_zns.c"
+
+#include "common/lib/test_env.c"
+
+SPDK_LOG_REGISTER_COMPONENT(nvme)
+
+pid_t g_spdk_nvme_pid;
+
+#define UT_ZONE_SIZE		64
+#define UT_NUM_ZONES		4
+#define UT_SECTOR_SIZE		512
+#define UT_MAX_APPEND_LBAS	16
+
+DEFINE_STUB(nvme_ns_cmd_zone_append_with_md, int,
+	    (struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair, void *buffer, void *metadata,
+	     uint64_t zslba, uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg,
+	     uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag), 0);
+DEFINE_STUB(spdk_nvme_ns_get_format_index, uint32_t, (const struct spdk_nvme_ns_data *nsdata), 0);
+DEFINE_STUB(spdk_nvme_ns_get_sector_size, uint32_t, (struct spdk_nvme_ns *ns), UT_SECTOR_SIZE);
+DEFINE_STUB(spdk_nvme_ns_get_extended_sector_size, uint32_t, (struct spdk_nvme_ns *ns),
+	    UT_SECTOR_SIZE);
+DEFINE_STUB(spdk_nvme_ns_get_num_sectors, uint64_t, (struct spdk_nvme_ns *ns),
+	    UT_ZONE_SIZE * UT_NUM_ZONES);
+DEFINE_STUB(spdk_nvme_ns_get_csi, enum spdk_nvme_csi, (const struct spdk_nvme_ns *ns),
+	    SPDK_NVME_CSI_ZNS);
+DEFINE_STUB(spdk_nvme_ns_get_md_size, uint32_t, (struct spdk_nvme_ns *ns), 0);
+DEFINE_STUB(spdk_nvme_ns_supports_extended_lba, bool, (struct spdk_nvme_ns *ns), false);
+/* Room for the report header and two zone descriptors */
+DEFINE_STUB(spdk_nvme_ns_get_max_io_xfer_size, uint32_t, (struct spdk_nvme_ns *ns), 192);
+
+const struct spdk_nvme_ns_data *
+spdk_nvme_ns_get_data(struct spdk_nvme_ns *ns)
+{
+	return &ns->nsdata;
+}
+
+/* Zones as seen by the controller */
+static struct spdk_nvme_zns_zone_desc g_ut_zones[UT_NUM_ZONES];
+
+struct ut_cmd {
+	spdk_nvme_cmd_cb		cb_fn;
+	void				*cb_arg;
+	uint8_t				opc;
+	uint64_t			slba;
+	uint32_t			lba_count;
+	uint8_t				zsa;
+	void				*report;
+	uint32_t			report_size;
+	spdk_nvme_req_reset_sgl_cb	reset_sgl_fn;
+	spdk_nvme_req_next_sge_cb	next_sge_fn;
+	TAILQ_ENTRY(ut_cmd)		link;
+};
+
+static TAILQ_HEAD(, ut_cmd) g_ut_cmds = TAILQ_HEAD_INITIALIZER(g_ut_cmds);
+static uint32_t g_ut_num_cmds;
+static int g_ut_submit_rc;
+
+static struct ut_cmd *
+ut_add_cmd(uint8_t opc, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct ut_cmd *cmd;
+
+	cmd = calloc(1, sizeof(*cmd));
+	SPDK_CU_ASSERT_FATAL(cmd != NULL);
+	cmd->opc = opc;
+	cmd->cb_fn = cb_fn;
+	cmd->cb_arg = cb_arg;
+	TAILQ_INSERT_TAIL(&g_ut_cmds, cmd, link);
+	g_ut_num_cmds++;
+
+	return cmd;
+}
+
+int
+nvme_ns_cmd_zone_appendv_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+				 uint64_t zslba, uint32_t lba_count,
+				 spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+				 spdk_nvme_req_reset_sgl_cb reset_sgl_fn,
+				 spdk_nvme_req_next_sge_cb next_sge_fn, void *metadata,
+				 uint16_t apptag_mask, uint16_t apptag)
+{
+	struct ut_cmd *cmd;
+
+	if (g_ut_submit_rc != 0) {
+		return g_ut_submit_rc;
+	}
+
+	cmd = ut_add_cmd(SPDK_NVME_OPC_ZONE_APPEND, cb_fn, cb_arg);
+	cmd->slba = zslba;
+	cmd->lba_count = lba_count;
+	cmd->reset_sgl_fn = reset_sgl_fn;
+	cmd->next_sge_fn = next_sge_fn;
+
+	return 0;
+}
+
+static struct nvme_request g_ut_req;
+
+struct nvme_request *
+nvme_allocate_request_user_copy(struct spdk_nvme_qpair *qpair, void *buffer,
+				uint32_t payload_size, spdk_nvme_cmd_cb cb_fn, void *cb_arg,
+				bool host_to_controller)
+{
+	memset(&g_ut_req, 0, sizeof(g_ut_req));
+	g_ut_req.cb_fn = cb_fn;
+	g_ut_req.cb_arg = cb_arg;
+	g_ut_req.user_buffer = buffer;
+	g_ut_req.payload_size = payload_size;
+
+	return &g_ut_req;
+}
+
+int
+nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	struct ut_cmd *cmd;
+
+	if (req != &g_ut_req) {
+		STAILQ_INSERT_HEAD(&qpair->free_req, req, stailq);
+	}
+
+	if (g_ut_submit_rc != 0) {
+		return g_ut_submit_rc;
+	}
+
+	cmd = ut_add_cmd(req->cmd.opc, req->cb_fn, req->cb_arg);
+	cmd->slba = *(uint64_t *)&req->cmd.cdw10;
+	cmd->zsa = req->cmd.cdw13 & 0xff;
+	cmd->report = req->user_buffer;
+	cmd->report_size = req->payload_size;
+
+	return 0;
+}
+
+/* Complete the oldest outstanding command the way the controller would */
+static void
+ut_complete_cmd(uint64_t alba, bool fail)
+{
+	struct spdk_nvme_zns_zone_report *report;
+	struct spdk_nvme_cpl cpl = {};
+	struct ut_cmd *cmd;
+	uint32_t i, idx, max_descs;
+
+	cmd = TAILQ_FIRST(&g_ut_cmds);
+	SPDK_CU_ASSERT_FATAL(cmd != NULL);
+	TAILQ_REMOVE(&g_ut_cmds, cmd, link);
+	g_ut_num_cmds--;
+
+	if (fail) {
+		cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	} else if (cmd->opc == SPDK_NVME_OPC_ZONE_MGMT_RECV) {
+		report = cmd->report;
+		max_descs = (cmd->report_size - sizeof(*report)) / sizeof(report->descs[0]);
+		idx = cmd->slba / UT_ZONE_SIZE;
+		for (i = 0; i < max_descs && idx + i < UT_NUM_ZONES; i++) {
+			report->descs[i] = g_ut_zones[idx + i];
+		}
+		report->nr_zones = i;
+	} else if (cmd->opc == SPDK_NVME_OPC_ZONE_APPEND) {
+		cpl.cdw0 = (uint32_t)alba;
+		cpl.cdw1 = (uint32_t)(alba >> 32);
+	}
+
+	cmd->cb_fn(cmd->cb_arg, &cpl);
+	free(cmd);
+}
+
+static struct spdk_nvme_ctrlr g_ut_ctrlr;
+static struct spdk_nvme_zns_ns_data g_ut_nsdata_zns;
+static struct spdk_nvme_ns g_ut_ns;
+static struct spdk_nvme_qpair g_ut_qpair;
+static struct nvme_request g_ut_qpair_reqs[8];
+
+static void
+ut_init(void)
+{
+	uint32_t i;
+
+	g_ut_ctrlr.max_zone_append_size = UT_MAX_APPEND_LBAS * UT_SECTOR_SIZE;
+	g_ut_ctrlr.flags = SPDK_NVME_CTRLR_SGL_SUPPORTED;
+	g_ut_ctrlr.max_sges = 2;
+
+	/* At most 2 open and 3 active zones */
+	g_ut_nsdata_zns.mor = 1;
+	g_ut_nsdata_zns.mar = 2;
+	g_ut_nsdata_zns.lbafe[0].zsze = UT_ZONE_SIZE;
+	g_ut_ns.ctrlr = &g_ut_ctrlr;
+	g_ut_ns.id = 1;
+	g_ut_ns.nsdata_zns = &g_ut_nsdata_zns;
+
+	STAILQ_INIT(&g_ut_qpair.free_req);
+	for (i = 0; i < SPDK_COUNTOF(g_ut_qpair_reqs); i++) {
+		STAILQ_INSERT_TAIL(&g_ut_qpair.free_req, &g_ut_qpair_reqs[i], stailq);
+	}
+
+	for (i = 0; i < UT_NUM_ZONES; i++) {
+		g_ut_zones[i].zs = SPDK_NVME_ZONE_STATE_EMPTY;
+		g_ut_zones[i].zslba = i * UT_ZONE_SIZE;
+		g_ut_zones[i].wp = i * UT_ZONE_SIZE;
+		g_ut_zones[i].zcap = UT_ZONE_SIZE - 8;
+	}
+}
+
+static void
+ut_refresh_done(void *cb_arg, int rc)
+{
+	*(int *)cb_arg = rc;
+}
+
+static struct spdk_nvme_zns_zone_mgr *
+ut_create_mgr(uint32_t max_requests, uint32_t max_zone_inflight)
+{
+	struct spdk_nvme_zns_zone_mgr_opts opts;
+	struct spdk_nvme_zns_zone_mgr *mgr;
+	int rc, refresh_rc = 1;
+
+	spdk_nvme_zns_zone_mgr_get_default_opts(&opts, sizeof(opts));
+	opts.max_requests = max_requests;
+	opts.max_zone_inflight = max_zone_inflight;
+
+	mgr = spdk_nvme_zns_zone_mgr_create(&g_ut_ns, &g_ut_qpair, &opts);
+	SPDK_CU_ASSERT_FATAL(mgr != NULL);
+
+	rc = spdk_nvme_zns_zone_mgr_refresh(mgr, ut_refresh_done, &refresh_rc);
+	CU_ASSERT(rc == 0);
+	while (g_ut_num_cmds > 0) {
+		ut_complete_cmd(0, false);
+	}
+	CU_ASSERT(refresh_rc == 0);
+
+	return mgr;
+}
+
+struct ut_append_ctx {
+	bool		done;
+	bool		failed;
+	uint64_t	lba;
+};
+
+static void
+ut_append_done(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct ut_append_ctx *ctx = cb_arg;
+
+	ctx->done = true;
+	ctx->failed = spdk_nvme_cpl_is_error(cpl);
+	ctx->lba = (uint64_t)cpl->cdw1 << 32 | cpl->cdw0;
+}
+
+static void
+test_zone_mgr_refresh(void)
+{
+	struct spdk_nvme_zns_zone_mgr *mgr;
+	struct spdk_nvme_zns_zone_mgr_opts opts;
+	struct spdk_nvme_zns_zone_info info;
+	int rc, refresh_rc = 1;
+
+	ut_init();
+	g_ut_zones[1].zs = SPDK_NVME_ZONE_STATE_IOPEN;
+	g_ut_zones[1].wp = UT_ZONE_SIZE + 10;
+	g_ut_zones[3].zs = SPDK_NVME_ZONE_STATE_FULL;
+
+	spdk_nvme_zns_zone_mgr_get_default_opts(&opts, sizeof(opts));
+	CU_ASSERT(opts.max_requests == NVME_ZNS_ZONE_MGR_DEFAULT_MAX_REQUESTS);
+	CU_ASSERT(opts.max_zone_inflight == NVME_ZNS_ZONE_MGR_DEFAULT_MAX_ZONE_INFLIGHT);
+
+	mgr = spdk_nvme_zns_zone_mgr_create(&g_ut_ns, &g_ut_qpair, NULL);
+	SPDK_CU_ASSERT_FATAL(mgr != NULL);
+	CU_ASSERT(mgr->num_zones == UT_NUM_ZONES);
+	CU_ASSERT(mgr->max_open_zones == 2);
+	CU_ASSERT(mgr->max_active_zones == 3);
+
+	/* Nothing is known before the zones were reported */
+	rc = spdk_nvme_zns_zone_mgr_get_zone_info(mgr, 0, &info);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Two zone descriptors fit in a report, so it takes two of them */
+	rc = spdk_nvme_zns_zone_mgr_refresh(mgr, ut_refresh_done, &refresh_rc);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_ut_num_cmds == 1);
+	rc = spdk_nvme_zns_zone_mgr_refresh(mgr, ut_refresh_done, &refresh_rc);
+	CU_ASSERT(rc == -EBUSY);
+	ut_complete_cmd(0, false);
+	CU_ASSERT(refresh_rc == 1);
+	CU_ASSERT(g_ut_num_cmds == 1);
+	CU_ASSERT(TAILQ_FIRST(&g_ut_cmds)->slba == 2 * UT_ZONE_SIZE);
+	ut_complete_cmd(0, false);
+	CU_ASSERT(refresh_rc == 0);
+	CU_ASSERT(g_ut_num_cmds == 0);
+
+	rc = spdk_nvme_zns_zone_mgr_get_zone_info(mgr, UT_ZONE_SIZE, &info);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(info.zslba == UT_ZONE_SIZE);
+	CU_ASSERT(info.state == SPDK_NVME_ZONE_STATE_IOPEN);
+	CU_ASSERT(info.write_pointer == UT_ZONE_SIZE + 10);
+	CU_ASSERT(info.capacity == UT_ZONE_SIZE - 8);
+	CU_ASSERT(mgr->num_open_zones == 1);
+	CU_ASSERT(mgr->num_active_zones == 1);
+
+	/* Not the start of a zone, or past the last one */
+	CU_ASSERT(spdk_nvme_zns_zone_mgr_get_zone_info(mgr, 1, &info) == -EINVAL);
+	CU_ASSERT(spdk_nvme_zns_zone_mgr_get_zone_info(mgr, UT_NUM_ZONES * UT_ZONE_SIZE,
+			&info) == -EINVAL);
+
+	/* A failed report is reported to the caller */
+	refresh_rc = 1;
+	rc = spdk_nvme_zns_zone_mgr_refresh(mgr, ut_refresh_done, &refresh_rc);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(0, true);
+	CU_ASSERT(refresh_rc == -EIO);
+	CU_ASSERT(spdk_nvme_zns_zone_mgr_get_zone_info(mgr, 0, &info) == -EINVAL);
+
+	CU_ASSERT(spdk_nvme_zns_zone_mgr_free(mgr) == 0);
+}
+
+static void
+test_zone_mgr_append_batching(void)
+{
+	struct spdk_nvme_zns_zone_mgr *mgr;
+	struct spdk_nvme_zns_zone_info info;
+	struct ut_append_ctx ctx[6] = {};
+	uint8_t buf[16 * UT_SECTOR_SIZE], other_buf[4 * UT_SECTOR_SIZE];
+	struct ut_cmd *cmd;
+	void *address;
+	uint32_t length;
+	int rc, i;
+
+	ut_init();
+	mgr = ut_create_mgr(16, 1);
+
+	/* Nothing outstanding to the zone, the append is submitted right away */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 4, ut_append_done, &ctx[0], 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_ut_num_cmds == 1);
+	CU_ASSERT(mgr->zones[0].state == SPDK_NVME_ZONE_STATE_IOPEN);
+	CU_ASSERT(mgr->num_open_zones == 1);
+
+	/* The next ones are queued, contiguous buffers and one more segment get merged */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf + 4 * UT_SECTOR_SIZE, 0, 4, ut_append_done,
+					   &ctx[1], 0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf + 8 * UT_SECTOR_SIZE, 0, 4, ut_append_done,
+					   &ctx[2], 0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, other_buf, 0, 4, ut_append_done, &ctx[3], 0);
+	CU_ASSERT(rc == 0);
+	/* Different flags, can't be merged */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf + 12 * UT_SECTOR_SIZE, 0, 4, ut_append_done,
+					   &ctx[4], SPDK_NVME_IO_FLAGS_FORCE_UNIT_ACCESS);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_ut_num_cmds == 1);
+
+	rc = spdk_nvme_zns_zone_mgr_get_zone_info(mgr, 0, &info);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(info.write_pointer == 0);
+	CU_ASSERT(info.pending_lbas == 20);
+
+	/* Larger than the maximum zone append size */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, UT_ZONE_SIZE, UT_MAX_APPEND_LBAS + 1,
+					   ut_append_done, &ctx[5], 0);
+	CU_ASSERT(rc == -EINVAL);
+
+	ut_complete_cmd(0, false);
+	CU_ASSERT(ctx[0].done && !ctx[0].failed);
+	CU_ASSERT(ctx[0].lba == 0);
+	CU_ASSERT(!ctx[1].done);
+
+	/* The three queued appends with the same flags were merged into one command */
+	CU_ASSERT(g_ut_num_cmds == 1);
+	cmd = TAILQ_FIRST(&g_ut_cmds);
+	SPDK_CU_ASSERT_FATAL(cmd != NULL);
+	CU_ASSERT(cmd->slba == 0);
+	CU_ASSERT(cmd->lba_count == 12);
+
+	cmd->reset_sgl_fn(cmd->cb_arg, 0);
+	CU_ASSERT(cmd->next_sge_fn(cmd->cb_arg, &address, &length) == 0);
+	CU_ASSERT(address == buf + 4 * UT_SECTOR_SIZE);
+	CU_ASSERT(length == 8 * UT_SECTOR_SIZE);
+	CU_ASSERT(cmd->next_sge_fn(cmd->cb_arg, &address, &length) == 0);
+	CU_ASSERT(address == other_buf);
+	CU_ASSERT(length == 4 * UT_SECTOR_SIZE);
+
+	cmd->reset_sgl_fn(cmd->cb_arg, 6 * UT_SECTOR_SIZE);
+	CU_ASSERT(cmd->next_sge_fn(cmd->cb_arg, &address, &length) == 0);
+	CU_ASSERT(address == buf + 10 * UT_SECTOR_SIZE);
+	CU_ASSERT(length == 2 * UT_SECTOR_SIZE);
+
+	/* Each merged append gets the LBA its data was written to */
+	ut_complete_cmd(4, false);
+	for (i = 1; i <= 3; i++) {
+		CU_ASSERT(ctx[i].done && !ctx[i].failed);
+		CU_ASSERT(ctx[i].lba == 4 * (uint64_t)i);
+	}
+	CU_ASSERT(g_ut_num_cmds == 1);
+	CU_ASSERT(TAILQ_FIRST(&g_ut_cmds)->lba_count == 4);
+
+	ut_complete_cmd(16, false);
+	CU_ASSERT(ctx[4].done && !ctx[4].failed);
+	CU_ASSERT(ctx[4].lba == 16);
+
+	rc = spdk_nvme_zns_zone_mgr_get_zone_info(mgr, 0, &info);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(info.write_pointer == 20);
+	CU_ASSERT(info.pending_lbas == 0);
+	CU_ASSERT(info.state == SPDK_NVME_ZONE_STATE_IOPEN);
+
+	/* Filling the zone up to its capacity makes it full */
+	for (i = 0; i < 2; i++) {
+		memset(&ctx[i], 0, sizeof(ctx[i]));
+		rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 16, ut_append_done, &ctx[i], 0);
+		CU_ASSERT(rc == 0);
+		ut_complete_cmd(20 + 16 * i, false);
+		CU_ASSERT(ctx[i].done);
+	}
+
+	/* Not enough capacity left for this one */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 8, ut_append_done, &ctx[2], 0);
+	CU_ASSERT(rc == -ENOSPC);
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 4, ut_append_done, &ctx[2], 0);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(52, false);
+	CU_ASSERT(ctx[2].done && ctx[2].lba == 52);
+	rc = spdk_nvme_zns_zone_mgr_get_zone_info(mgr, 0, &info);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(info.write_pointer == UT_ZONE_SIZE - 8);
+	CU_ASSERT(info.state == SPDK_NVME_ZONE_STATE_FULL);
+	CU_ASSERT(mgr->num_open_zones == 0);
+	CU_ASSERT(mgr->num_active_zones == 0);
+
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 1, ut_append_done, &ctx[0], 0);
+	CU_ASSERT(rc == -ENOSPC);
+
+	/* A submission failure with nothing outstanding is returned to the caller */
+	g_ut_submit_rc = -ENXIO;
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, UT_ZONE_SIZE, 1, ut_append_done, &ctx[0], 0);
+	CU_ASSERT(rc == -ENXIO);
+	g_ut_submit_rc = 0;
+	CU_ASSERT(mgr->zones[1].state == SPDK_NVME_ZONE_STATE_EMPTY);
+	CU_ASSERT(mgr->zones[1].pending_lbas == 0);
+	CU_ASSERT(mgr->num_outstanding == 0);
+
+	/* A failed append fails all the appends merged into it */
+	memset(ctx, 0, sizeof(ctx));
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, UT_ZONE_SIZE, 1, ut_append_done, &ctx[0], 0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf + UT_SECTOR_SIZE, UT_ZONE_SIZE, 1, ut_append_done,
+					   &ctx[1], 0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf + 2 * UT_SECTOR_SIZE, UT_ZONE_SIZE, 1,
+					   ut_append_done, &ctx[2], 0);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(UT_ZONE_SIZE, false);
+	CU_ASSERT(g_ut_num_cmds == 1);
+	ut_complete_cmd(0, true);
+	CU_ASSERT(ctx[1].done && ctx[1].failed);
+	CU_ASSERT(ctx[2].done && ctx[2].failed);
+	CU_ASSERT(mgr->zones[1].wp == UT_ZONE_SIZE + 1);
+	CU_ASSERT(mgr->zones[1].pending_lbas == 0);
+
+	CU_ASSERT(spdk_nvme_zns_zone_mgr_free(mgr) == 0);
+}
+
+static void
+ut_mgmt_done(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	*(int *)cb_arg = spdk_nvme_cpl_is_error(cpl) ? -EIO : 0;
+}
+
+static void
+test_zone_mgr_limits(void)
+{
+	struct spdk_nvme_zns_zone_mgr *mgr;
+	struct ut_append_ctx ctx[4] = {};
+	uint8_t buf[UT_SECTOR_SIZE];
+	int rc, mgmt_rc;
+
+	ut_init();
+	mgr = ut_create_mgr(2, 4);
+
+	/* Two zones can be open at once */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 1, ut_append_done, &ctx[0], 0);
+	CU_ASSERT(rc == 0);
+	rc = spdk_nvme_zns_zone_mgr_open_zone(mgr, UT_ZONE_SIZE, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == 0);
+	/* Out of requests */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 1, ut_append_done, &ctx[1], 0);
+	CU_ASSERT(rc == -ENOMEM);
+	/* Appends to the zone are outstanding */
+	rc = spdk_nvme_zns_zone_mgr_close_zone(mgr, 0, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == -EBUSY);
+
+	ut_complete_cmd(0, false);
+	mgmt_rc = 1;
+	ut_complete_cmd(0, false);
+	CU_ASSERT(mgmt_rc == 0);
+	CU_ASSERT(mgr->zones[1].state == SPDK_NVME_ZONE_STATE_EOPEN);
+	CU_ASSERT(mgr->num_open_zones == 2);
+	CU_ASSERT(mgr->num_active_zones == 2);
+
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 2 * UT_ZONE_SIZE, 1, ut_append_done, &ctx[1], 0);
+	CU_ASSERT(rc == -EBUSY);
+	rc = spdk_nvme_zns_zone_mgr_open_zone(mgr, 2 * UT_ZONE_SIZE, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == -EBUSY);
+
+	/* Closing a written zone keeps it active */
+	rc = spdk_nvme_zns_zone_mgr_close_zone(mgr, 0, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(0, false);
+	CU_ASSERT(mgr->zones[0].state == SPDK_NVME_ZONE_STATE_CLOSED);
+	CU_ASSERT(mgr->num_open_zones == 1);
+	CU_ASSERT(mgr->num_active_zones == 2);
+
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 2 * UT_ZONE_SIZE, 1, ut_append_done, &ctx[1], 0);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(2 * UT_ZONE_SIZE, false);
+	CU_ASSERT(mgr->num_open_zones == 2);
+	CU_ASSERT(mgr->num_active_zones == 3);
+
+	/* Closing an unwritten zone makes it empty again */
+	rc = spdk_nvme_zns_zone_mgr_close_zone(mgr, UT_ZONE_SIZE, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(0, false);
+	CU_ASSERT(mgr->zones[1].state == SPDK_NVME_ZONE_STATE_EMPTY);
+	CU_ASSERT(mgr->num_open_zones == 1);
+	CU_ASSERT(mgr->num_active_zones == 2);
+
+	/* Reopening the closed zone is within the limits now */
+	rc = spdk_nvme_zns_zone_mgr_append(mgr, buf, 0, 1, ut_append_done, &ctx[2], 0);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(1, false);
+	CU_ASSERT(mgr->zones[0].state == SPDK_NVME_ZONE_STATE_IOPEN);
+	CU_ASSERT(mgr->num_open_zones == 2);
+	CU_ASSERT(mgr->num_active_zones == 2);
+
+	/* Finish and reset release the resources of a zone */
+	rc = spdk_nvme_zns_zone_mgr_finish_zone(mgr, 0, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(0, false);
+	CU_ASSERT(mgr->zones[0].state == SPDK_NVME_ZONE_STATE_FULL);
+	CU_ASSERT(mgr->zones[0].wp == UT_ZONE_SIZE - 8);
+	CU_ASSERT(mgr->num_open_zones == 1);
+	CU_ASSERT(mgr->num_active_zones == 1);
+
+	rc = spdk_nvme_zns_zone_mgr_reset_zone(mgr, 0, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(0, false);
+	CU_ASSERT(mgr->zones[0].state == SPDK_NVME_ZONE_STATE_EMPTY);
+	CU_ASSERT(mgr->zones[0].wp == 0);
+
+	/* A failed command leaves the cached state alone */
+	rc = spdk_nvme_zns_zone_mgr_reset_zone(mgr, 2 * UT_ZONE_SIZE, ut_mgmt_done, &mgmt_rc);
+	CU_ASSERT(rc == 0);
+	ut_complete_cmd(0, true);
+	CU_ASSERT(mgmt_rc == -EIO);
+	CU_ASSERT(mgr->zones[2].state == SPDK_NVME_ZONE_STATE_IOPEN);
+
+	CU_ASSERT(spdk_nvme_zns_zone_mgr_free(mgr) == 0);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("nvme_zns", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_zone_mgr_refresh);
+	CU_ADD_TEST(suite, test_zone_mgr_append_batching);
+	CU_ADD_TEST(suite, test_zone_mgr_limits);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+	return num_failures;
+}
@@ -2091,6 +2091,27 @@ test_get_ana_log_page_one_ns_per_anagrp(void)
 
 	CU_ASSERT(memcmp(expected_page, actual_page, UT_ANA_LOG_PAGE_SIZE) == 0);
 
+	/* The page is cached until the ANA state of the listener changes */
+	SPDK_CU_ASSERT_FATAL(listener.ana_log.buf != NULL);
+	subsystem.flags.ana_reporting = 1;
+	listener.ana_state[1] = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	listener.ana_state_change_count++;
+
+	offset = sizeof(struct spdk_nvme_ana_page) + UT_ANA_DESC_SIZE;
+	memcpy(ana_desc, &expected_page[offset], UT_ANA_DESC_SIZE);
+	ana_desc->ana_state = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	memcpy(&expected_page[offset], ana_desc, UT_ANA_DESC_SIZE);
+
+	memset(&actual_page[0], 0, UT_ANA_LOG_PAGE_SIZE);
+	iov.iov_base = &actual_page[0];
+	iov.iov_len = UT_ANA_LOG_PAGE_SIZE;
+	nvmf_get_ana_log_page(&ctrlr, &iov, 1, 0, UT_ANA_LOG_PAGE_SIZE, 0);
+
+	CU_ASSERT(memcmp(expected_page, actual_page, UT_ANA_LOG_PAGE_SIZE) == 0);
+	CU_ASSERT(listener.ana_log.ana_state_change_count == listener.ana_state_change_count);
+
+	free(listener.ana_log.buf);
+
 #undef UT_ANA_DESC_SIZE
 #undef UT_ANA_LOG_PAGE_SIZE
 }
@@ -2188,6 +2209,8 @@ test_get_ana_log_page_multi_ns_per_anagrp(void)
 
 	CU_ASSERT(memcmp(expected_page, actual_page, UT_ANA_LOG_PAGE_SIZE) == 0);
 
+	free(listener.ana_log.buf);
+
 #undef UT_ANA_LOG_PAGE_SIZE
 }
 static void
@@ -3054,6 +3077,143 @@ test_nvmf_ctrlr_set_features_host_behavior_support(void)
 	CU_ASSERT(req.rsp->nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_FIELD);
 }
 
+static void
+test_ns_admission_control(void)
+{
+	struct spdk_nvmf_request req[3] = {};
+	struct spdk_nvme_cmd cmd[3] = {};
+	union nvmf_c2h_msg rsp[3] = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_transport transport = {};
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ns ns = {};
+	struct spdk_nvmf_ns *subsys_ns[1] = {};
+	enum spdk_nvme_ana_state ana_state[1];
+	struct spdk_nvmf_subsystem_listener listener = { .ana_state = ana_state };
+	struct spdk_bdev bdev = { .blockcnt = 100, .blocklen = 512};
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem_poll_group sgroups = {};
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+	struct spdk_io_channel io_ch = {};
+	int i;
+
+	ns.bdev = &bdev;
+	ns.anagrpid = 1;
+
+	subsystem.id = 0;
+	subsystem.max_nsid = 1;
+	subsys_ns[0] = &ns;
+	subsystem.ns = (struct spdk_nvmf_ns **)&subsys_ns;
+
+	listener.ana_state[0] = SPDK_NVME_ANA_OPTIMIZED_STATE;
+
+	ctrlr.vcprop.cc.bits.en = 1;
+	ctrlr.subsys = &subsystem;
+	ctrlr.listener = &listener;
+
+	group.thread = spdk_get_thread();
+	group.num_sgroups = 1;
+	sgroups.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	sgroups.num_ns = 1;
+	ns_info.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	ns_info.channel = &io_ch;
+	ns_info.max_io_outstanding = 2;
+	ns_info.io_limit = 2;
+	sgroups.ns_info = &ns_info;
+	TAILQ_INIT(&sgroups.queued);
+	group.sgroups = &sgroups;
+	TAILQ_INIT(&qpair.outstanding);
+
+	qpair.ctrlr = &ctrlr;
+	qpair.group = &group;
+	qpair.transport = &transport;
+	qpair.qid = 1;
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+
+	for (i = 0; i < 3; i++) {
+		cmd[i].nsid = 1;
+		cmd[i].opc = SPDK_NVME_OPC_READ;
+		req[i].qpair = &qpair;
+		req[i].cmd = (union nvmf_h2c_msg *)&cmd[i];
+		req[i].rsp = &rsp[i];
+	}
+
+	MOCK_SET(nvmf_bdev_ctrlr_read_cmd, SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+
+	/* I/O up to the limit is submitted to the bdev */
+	spdk_nvmf_request_exec(&req[0]);
+	spdk_nvmf_request_exec(&req[1]);
+	CU_ASSERT(ns_info.io_outstanding == 2);
+	CU_ASSERT(nvme_status_success(&rsp[0].nvme_cpl.status));
+	CU_ASSERT(nvme_status_success(&rsp[1].nvme_cpl.status));
+
+	/* I/O above the limit is completed with a retryable status */
+	spdk_nvmf_request_exec(&req[2]);
+	CU_ASSERT(ns_info.io_outstanding == 2);
+	CU_ASSERT(rsp[2].nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp[2].nvme_cpl.status.sc == SPDK_NVME_SC_COMMAND_INTERRUPTED);
+	CU_ASSERT(rsp[2].nvme_cpl.status.dnr == 0);
+
+	/* With ANA reporting, the host is asked to retry on another path */
+	subsystem.flags.ana_reporting = 1;
+	memset(&rsp[2], 0, sizeof(rsp[2]));
+	spdk_nvmf_request_exec(&req[2]);
+	CU_ASSERT(ns_info.io_outstanding == 2);
+	CU_ASSERT(rsp[2].nvme_cpl.status.sct == SPDK_NVME_SCT_PATH);
+	CU_ASSERT(rsp[2].nvme_cpl.status.sc == SPDK_NVME_SC_INTERNAL_PATH_ERROR);
+	CU_ASSERT(rsp[2].nvme_cpl.status.dnr == 0);
+	subsystem.flags.ana_reporting = 0;
+
+	/* Once an I/O completes, the next one is admitted again */
+	spdk_nvmf_request_complete(&req[0]);
+	poll_threads();
+	CU_ASSERT(ns_info.io_outstanding == 1);
+	memset(&rsp[2], 0, sizeof(rsp[2]));
+	spdk_nvmf_request_exec(&req[2]);
+	CU_ASSERT(ns_info.io_outstanding == 2);
+	CU_ASSERT(nvme_status_success(&rsp[2].nvme_cpl.status));
+
+	spdk_nvmf_request_complete(&req[1]);
+	spdk_nvmf_request_complete(&req[2]);
+	poll_threads();
+	CU_ASSERT(ns_info.io_outstanding == 0);
+	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
+
+	/* Latency above the target halves the limit after a window of completions */
+	ns_info.max_io_outstanding = 0;
+	ns_info.io_limit = UINT32_MAX;
+	ns_info.latency_target_ticks = 100;
+	for (i = 0; i < NVMF_NS_LATENCY_WINDOW; i++) {
+		spdk_nvmf_request_exec(&req[0]);
+		CU_ASSERT(nvme_status_success(&rsp[0].nvme_cpl.status));
+		ut_spdk_get_ticks += 200;
+		spdk_nvmf_request_complete(&req[0]);
+		poll_threads();
+	}
+	CU_ASSERT(ns_info.io_limit == 1);
+	CU_ASSERT(ns_info.latency_ewma_ticks == 200);
+
+	spdk_nvmf_request_exec(&req[0]);
+	spdk_nvmf_request_exec(&req[1]);
+	CU_ASSERT(ns_info.io_outstanding == 1);
+	CU_ASSERT(rsp[1].nvme_cpl.status.sc == SPDK_NVME_SC_COMMAND_INTERRUPTED);
+	spdk_nvmf_request_complete(&req[0]);
+	poll_threads();
+
+	/* The limit grows again once the latency is back under the target */
+	for (i = 0; i < NVMF_NS_LATENCY_WINDOW; i++) {
+		spdk_nvmf_request_exec(&req[0]);
+		spdk_nvmf_request_complete(&req[0]);
+		poll_threads();
+	}
+	CU_ASSERT(ns_info.latency_ewma_ticks < ns_info.latency_target_ticks);
+	CU_ASSERT(ns_info.io_limit == 2);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+
+	MOCK_CLEAR(nvmf_bdev_ctrlr_read_cmd);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -3093,6 +3253,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_property_set);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_get_features_host_behavior_support);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_set_features_host_behavior_support);
+	CU_ADD_TEST(suite, test_ns_admission_control);
 
 	allocate_threads(1);
 	set_thread(0);
@@ -211,6 +211,13 @@ nvmf_poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 	return 0;
 }
 
+int
+nvmf_poll_group_update_ns(struct spdk_nvmf_poll_group *group,
+			  struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	return 0;
+}
+
 int
 nvmf_poll_group_add_subsystem(struct spdk_nvmf_poll_group *group,
 			      struct spdk_nvmf_subsystem *subsystem,
@@ -347,6 +354,19 @@ test_discovery_log(void)
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1,
 				    offsetof(struct spdk_nvmf_discovery_log_page, entries[0]), sizeof(*entry), &trid);
 	CU_ASSERT(entry->trtype == 42);
+	CU_ASSERT(spdk_mem_all_zero(buffer + sizeof(*entry), sizeof(buffer) - sizeof(*entry)));
+
+	/* The entries are only rebuilt when the generation counter changes */
+	CU_ASSERT(tgt.discovery_log.valid);
+	CU_ASSERT(tgt.discovery_log.genctr == tgt.discovery_genctr);
+	CU_ASSERT(tgt.discovery_log.num_entries == 1);
+
+	/* Offset past the end of the log page */
+	memset(buffer, 0xCC, sizeof(buffer));
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1,
+				    offsetof(struct spdk_nvmf_discovery_log_page, entries[1]), sizeof(buffer),
+				    &trid);
+	CU_ASSERT(spdk_mem_all_zero(buffer, sizeof(buffer)));
 
 	/* remove the host and verify that the discovery log contains nothing */
 	rc = spdk_nvmf_subsystem_remove_host(subsystem, hostnqn);
@@ -373,6 +393,7 @@ test_discovery_log(void)
 	CU_ASSERT(disc_log->genctr != 0);
 	CU_ASSERT(disc_log->numrec == 0);
 
+	free(tgt.discovery_log.entries);
 	spdk_bit_array_free(&tgt.subsystem_ids);
 }
 
@@ -638,6 +659,7 @@ test_discovery_log_with_filters(void)
 
 	subsystem->state = SPDK_NVMF_SUBSYSTEM_INACTIVE;
 	spdk_nvmf_subsystem_destroy(subsystem, NULL, NULL);
+	free(tgt.discovery_log.entries);
 	spdk_bit_array_free(&tgt.subsystem_ids);
 }
 
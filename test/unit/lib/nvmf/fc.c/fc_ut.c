@@ -62,6 +62,7 @@ DEFINE_STUB(spdk_nvmf_request_complete, int, (struct spdk_nvmf_request *req),
 
 DEFINE_STUB_V(nvmf_update_discovery_log,
 	      (struct spdk_nvmf_tgt *tgt, const char *hostnqn));
+DEFINE_STUB_V(nvmf_discovery_aen_fini, (struct spdk_nvmf_tgt *tgt));
 
 DEFINE_STUB(rte_hash_create, struct rte_hash *, (const struct rte_hash_parameters *params),
 	    (void *)1);
@@ -348,8 +349,10 @@ poll_group_poll_test(void)
 	fc_port = nvmf_fc_port_lookup(g_fc_port_handle);
 	SPDK_CU_ASSERT_FATAL(fc_port != NULL);
 
+	/* hwqps without connections are polled less often, see hwqp_load_balancing_test */
 	for (i = 0; i < fc_port->num_io_queues; i++) {
 		fc_port->io_queues[i].lcore_id = 0;
+		fc_port->io_queues[i].num_conns = 1;
 	}
 
 	for (i = 0; i < poll_cnt; i++) {
@@ -360,6 +363,7 @@ poll_group_poll_test(void)
 	/* check if hwqp's lcore_id has been updated */
 	for (i = 0; i < fc_port->num_io_queues; i++) {
 		CU_ASSERT(fc_port->io_queues[i].lcore_id == poll_cnt);
+		fc_port->io_queues[i].num_conns = 0;
 	}
 }
 
@@ -381,6 +385,63 @@ remove_hwqps_from_poll_groups_test(void)
 	}
 }
 
+static void
+hwqp_load_balancing_test(void)
+{
+	struct spdk_nvmf_fc_poll_group fgroups[2] = {};
+	struct spdk_nvmf_fc_hwqp hwqps[2] = {};
+	struct spdk_nvmf_fc_port fc_port = {};
+	struct spdk_nvmf_fc_nport tgtport = {};
+	struct spdk_nvmf_fc_association assoc = {};
+	struct spdk_nvmf_fc_conn fc_conn = {};
+	unsigned i;
+
+	SPDK_CU_ASSERT_FATAL(g_nvmf_tprt != NULL);
+
+	fc_port.num_io_queues = 2;
+	fc_port.io_queues = hwqps;
+	tgtport.fc_port = &fc_port;
+	assoc.tgtport = &tgtport;
+	fc_conn.fc_assoc = &assoc;
+
+	for (i = 0; i < 2; i++) {
+		TAILQ_INIT(&fgroups[i].hwqp_list);
+		TAILQ_INSERT_TAIL(&fgroups[i].hwqp_list, &hwqps[i], link);
+		hwqps[i].fgroup = &fgroups[i];
+		hwqps[i].fc_port = &fc_port;
+		hwqps[i].state = SPDK_FC_HWQP_ONLINE;
+	}
+
+	/* New connections go to the least loaded poll group... */
+	fgroups[0].load = 50;
+	fgroups[1].load = 10;
+	CU_ASSERT(nvmf_fc_get_optimal_poll_group(&fc_conn.qpair) == &fgroups[1].group);
+
+	/* ...or to the one with the fewest connections on its hwqp if the loads are equal */
+	fgroups[0].load = 10;
+	hwqps[1].num_conns = 3;
+	CU_ASSERT(nvmf_fc_get_optimal_poll_group(&fc_conn.qpair) == &fgroups[0].group);
+
+	/* Offline hwqps aren't used */
+	hwqps[0].state = SPDK_FC_HWQP_OFFLINE;
+	CU_ASSERT(nvmf_fc_get_optimal_poll_group(&fc_conn.qpair) == &fgroups[1].group);
+	hwqps[0].state = SPDK_FC_HWQP_ONLINE;
+
+	/* hwqps without connections are polled less often */
+	hwqps[0].lcore_id = 0;
+	for (i = 0; i < NVMF_FC_IDLE_HWQP_POLL_INTERVAL - 1; i++) {
+		nvmf_fc_poll_group_poll(&fgroups[0].group);
+	}
+	CU_ASSERT(hwqps[0].lcore_id == 0);
+	nvmf_fc_poll_group_poll(&fgroups[0].group);
+	CU_ASSERT(hwqps[0].lcore_id == 1);
+
+	hwqps[0].num_conns = 1;
+	nvmf_fc_poll_group_poll(&fgroups[0].group);
+	nvmf_fc_poll_group_poll(&fgroups[0].group);
+	CU_ASSERT(hwqps[0].lcore_id == 3);
+}
+
 static void
 destroy_transport_test(void)
 {
@@ -431,6 +492,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, online_fc_port_test);
 	CU_ADD_TEST(suite, poll_group_poll_test);
 	CU_ADD_TEST(suite, remove_hwqps_from_poll_groups_test);
+	CU_ADD_TEST(suite, hwqp_load_balancing_test);
 	CU_ADD_TEST(suite, destroy_transport_test);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
@@ -16,6 +16,7 @@ DEFINE_STUB_V(nvmf_transport_qpair_fini, (struct spdk_nvmf_qpair *qpair,
 		void *cb_arg));
 DEFINE_STUB_V(nvmf_qpair_free_aer, (struct spdk_nvmf_qpair *qpair));
 DEFINE_STUB_V(nvmf_qpair_abort_pending_zcopy_reqs, (struct spdk_nvmf_qpair *qpair));
+DEFINE_STUB_V(nvmf_discovery_aen_fini, (struct spdk_nvmf_tgt *tgt));
 DEFINE_STUB(nvmf_transport_poll_group_create, struct spdk_nvmf_transport_poll_group *,
 	    (struct spdk_nvmf_transport *transport,
 	     struct spdk_nvmf_poll_group *group), NULL);
@@ -39,6 +39,9 @@ DEFINE_STUB_V(spdk_mem_map_free, (struct spdk_mem_map **pmap));
 
 DEFINE_STUB_V(spdk_nvmf_request_exec, (struct spdk_nvmf_request *req));
 DEFINE_STUB(spdk_nvmf_request_complete, int, (struct spdk_nvmf_request *req), 0);
+DEFINE_STUB(nvmf_ctrlr_use_zcopy, bool, (struct spdk_nvmf_request *req), false);
+DEFINE_STUB_V(spdk_nvmf_request_zcopy_start, (struct spdk_nvmf_request *req));
+DEFINE_STUB_V(spdk_nvmf_request_zcopy_end, (struct spdk_nvmf_request *req, bool commit));
 DEFINE_STUB(spdk_nvme_transport_id_compare, int, (const struct spdk_nvme_transport_id *trid1,
 		const struct spdk_nvme_transport_id *trid2), 0);
 DEFINE_STUB_V(spdk_nvmf_ctrlr_abort_aer, (struct spdk_nvmf_ctrlr *ctrlr));
@@ -551,6 +554,7 @@ test_spdk_nvmf_rdma_request_process(void)
 	CU_ASSERT(progress == true);
 	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST);
 	CU_ASSERT(rdma_req->recv == NULL);
+	CU_ASSERT(rdma_req->rsp.wr.send_flags == IBV_SEND_SIGNALED);
 	/* COMPLETED -> FREE */
 	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
 	progress = nvmf_rdma_request_process(&rtransport, rdma_req);
@@ -562,7 +566,8 @@ test_spdk_nvmf_rdma_request_process(void)
 	poller_reset(&poller, &group);
 	qpair_reset(&rqpair, &poller, &device, &resources, &rtransport.transport);
 
-	/* Test 2: single SGL WRITE request */
+	/* Test 2: single SGL WRITE request, the response is sent inline */
+	rqpair.inline_rsp = true;
 	rdma_recv = create_recv(&rqpair, SPDK_NVME_OPC_WRITE);
 	rdma_req = create_req(&rqpair, rdma_recv);
 	rqpair.current_recv_depth = 1;
@@ -583,6 +588,7 @@ test_spdk_nvmf_rdma_request_process(void)
 	CU_ASSERT(progress == true);
 	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_COMPLETING);
 	CU_ASSERT(rdma_req->recv == NULL);
+	CU_ASSERT(rdma_req->rsp.wr.send_flags == (IBV_SEND_SIGNALED | IBV_SEND_INLINE));
 	/* COMPLETED -> FREE */
 	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
 	progress = nvmf_rdma_request_process(&rtransport, rdma_req);
@@ -1246,20 +1252,33 @@ test_nvmf_rdma_resources_create(void)
 	static struct spdk_nvmf_rdma_resources *rdma_resource;
 	struct spdk_nvmf_rdma_resource_opts opts = {};
 	struct spdk_nvmf_rdma_qpair qpair = {};
+	struct spdk_nvmf_rdma_srq rsrq = {};
 	struct spdk_nvmf_rdma_recv *recv = NULL;
 	struct spdk_nvmf_rdma_request *req = NULL;
 	const int DEPTH = 128;
+	int num_idle = 0;
+
+	/* Only a half of the receives is posted to the SRQ, the rest is kept aside */
+	rsrq.target_recvs = DEPTH / 2;
+	STAILQ_INIT(&rsrq.idle_recvs);
 
 	opts.max_queue_depth = DEPTH;
 	opts.in_capsule_data_size = 4096;
 	opts.shared = true;
+	opts.qp = &rsrq;
 	opts.qpair = &qpair;
 
 	rdma_resource = nvmf_rdma_resources_create(&opts);
 	CU_ASSERT(rdma_resource != NULL);
+	CU_ASSERT(rsrq.posted_recvs == DEPTH / 2);
+	STAILQ_FOREACH(recv, &rsrq.idle_recvs, link) {
+		num_idle++;
+	}
+	CU_ASSERT(num_idle == DEPTH / 2);
 	/* Just check first and last entry */
 	recv = &rdma_resource->recvs[0];
 	req = &rdma_resource->reqs[0];
+	CU_ASSERT(recv->srq == &rsrq);
 	CU_ASSERT(recv->rdma_wr.type == RDMA_WR_TYPE_RECV);
 	CU_ASSERT((uintptr_t)recv->buf == (uintptr_t)(rdma_resource->bufs));
 	CU_ASSERT(recv->sgl[0].addr == (uintptr_t)&rdma_resource->cmds[0]);
@@ -1320,6 +1339,60 @@ test_nvmf_rdma_resources_create(void)
 	nvmf_rdma_resources_destroy(rdma_resource);
 }
 
+static void
+test_nvmf_rdma_srq_adaptive_posting(void)
+{
+	struct spdk_nvmf_rdma_srq rsrq = {};
+	struct spdk_nvmf_rdma_recv recvs[256] = {};
+	const uint32_t DEPTH = SPDK_COUNTOF(recvs);
+	const uint64_t PERIOD = 1000;
+	uint32_t i;
+
+	rsrq.target_recvs = DEPTH;
+	STAILQ_INIT(&rsrq.idle_recvs);
+	for (i = 0; i < DEPTH; i++) {
+		recvs[i].srq = &rsrq;
+		nvmf_rdma_srq_queue_recv(&rsrq, &recvs[i]);
+	}
+	CU_ASSERT(rsrq.posted_recvs == DEPTH);
+	CU_ASSERT(STAILQ_EMPTY(&rsrq.idle_recvs));
+
+	/* Low load: the target only shrinks once per period, by at most a half */
+	rsrq.consumed_recvs = 2;
+	nvmf_rdma_srq_update_target(&rsrq, DEPTH, false, PERIOD - 1, PERIOD);
+	CU_ASSERT(rsrq.target_recvs == DEPTH);
+	nvmf_rdma_srq_update_target(&rsrq, DEPTH, false, PERIOD, PERIOD);
+	CU_ASSERT(rsrq.target_recvs == DEPTH / 2);
+	CU_ASSERT(rsrq.period_start_tsc == PERIOD);
+	nvmf_rdma_srq_update_target(&rsrq, DEPTH, false, 2 * PERIOD, PERIOD);
+	CU_ASSERT(rsrq.target_recvs == NVMF_RDMA_SRQ_MIN_POSTED_RECVS);
+	nvmf_rdma_srq_update_target(&rsrq, DEPTH, false, 3 * PERIOD, PERIOD);
+	CU_ASSERT(rsrq.target_recvs == NVMF_RDMA_SRQ_MIN_POSTED_RECVS);
+
+	/* Consumed receives return to the idle list once the target is reached */
+	rsrq.posted_recvs = 0;
+	for (i = 0; i < DEPTH; i++) {
+		nvmf_rdma_srq_queue_recv(&rsrq, &recvs[i]);
+	}
+	CU_ASSERT(rsrq.posted_recvs == NVMF_RDMA_SRQ_MIN_POSTED_RECVS);
+	CU_ASSERT(!STAILQ_EMPTY(&rsrq.idle_recvs));
+
+	/* A burst grows the target right away and the refill posts idle receives */
+	rsrq.posted_recvs -= 30;
+	rsrq.consumed_recvs = 30;
+	nvmf_rdma_srq_update_target(&rsrq, DEPTH, false, 3 * PERIOD + 1, PERIOD);
+	CU_ASSERT(rsrq.target_recvs == 30 * NVMF_RDMA_SRQ_BURST_HEADROOM);
+	nvmf_rdma_srq_refill(&rsrq);
+	CU_ASSERT(rsrq.posted_recvs == 30 * NVMF_RDMA_SRQ_BURST_HEADROOM);
+
+	/* A full CQ poll means the demand is unknown, so post all receives which aren't in use */
+	nvmf_rdma_srq_update_target(&rsrq, DEPTH, true, 3 * PERIOD + 2, PERIOD);
+	CU_ASSERT(rsrq.target_recvs == DEPTH);
+	nvmf_rdma_srq_refill(&rsrq);
+	CU_ASSERT(rsrq.posted_recvs == DEPTH - 30);
+	CU_ASSERT(STAILQ_EMPTY(&rsrq.idle_recvs));
+}
+
 static void
 test_nvmf_rdma_qpair_compare(void)
 {
@@ -1426,6 +1499,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_rdma_request_free_data);
 	CU_ADD_TEST(suite, test_nvmf_rdma_update_ibv_state);
 	CU_ADD_TEST(suite, test_nvmf_rdma_resources_create);
+	CU_ADD_TEST(suite, test_nvmf_rdma_srq_adaptive_posting);
 	CU_ADD_TEST(suite, test_nvmf_rdma_qpair_compare);
 	CU_ADD_TEST(suite, test_nvmf_rdma_resize_cq);
 
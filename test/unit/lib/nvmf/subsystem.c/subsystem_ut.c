@@ -98,6 +98,15 @@ nvmf_poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 	return 0;
 }
 
+static uint32_t g_pg_updated_nsid = 0;
+int
+nvmf_poll_group_update_ns(struct spdk_nvmf_poll_group *group,
+			  struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	g_pg_updated_nsid = nsid;
+	return 0;
+}
+
 int
 nvmf_poll_group_add_subsystem(struct spdk_nvmf_poll_group *group,
 			      struct spdk_nvmf_subsystem *subsystem,
@@ -1301,6 +1310,7 @@ test_spdk_nvmf_ns_event(void)
 		.subsys = &subsystem
 	};
 	struct spdk_nvmf_ns_opts ns_opts;
+	struct spdk_io_channel *ch;
 	uint32_t nsid;
 	struct spdk_bdev *bdev;
 
@@ -1318,6 +1328,8 @@ test_spdk_nvmf_ns_event(void)
 				nvmf_tgt_destroy_poll_group,
 				sizeof(struct spdk_nvmf_poll_group),
 				NULL);
+	ch = spdk_get_io_channel(&tgt);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
 
 	/* Add one namespace */
 	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
@@ -1330,19 +1342,46 @@ test_spdk_nvmf_ns_event(void)
 
 	/* Add one controller */
 	TAILQ_INIT(&subsystem.ctrlrs);
+	ctrlr.thread = spdk_get_thread();
 	TAILQ_INSERT_TAIL(&subsystem.ctrlrs, &ctrlr, link);
 
-	/* Namespace resize event */
+	/* Namespace resize event doesn't pause an active subsystem */
 	subsystem.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
 	g_ns_changed_nsid = 0xFFFFFFFF;
 	g_ns_changed_ctrlr = NULL;
+	g_pg_updated_nsid = 0;
 	nvmf_ns_event(SPDK_BDEV_EVENT_RESIZE, bdev, subsystem.ns[0]);
-	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_PAUSING == subsystem.state);
+	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
 
 	poll_threads();
 	CU_ASSERT(1 == g_ns_changed_nsid);
 	CU_ASSERT(&ctrlr == g_ns_changed_ctrlr);
+	CU_ASSERT(1 == g_pg_updated_nsid);
+	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
+
+	/* A namespace can be added to an active subsystem without pausing it */
+	g_ns_changed_nsid = 0xFFFFFFFF;
+	g_ns_changed_ctrlr = NULL;
+	g_pg_updated_nsid = 0;
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	nsid = spdk_nvmf_subsystem_add_ns_ext(&subsystem, "bdev2", &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 2);
+	CU_ASSERT(subsystem.ns[1] != NULL);
+	CU_ASSERT(subsystem.ana_group[1] == 1);
 	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
+	CU_ASSERT(0xFFFFFFFF == g_ns_changed_nsid);
+
+	poll_threads();
+	CU_ASSERT(2 == g_ns_changed_nsid);
+	CU_ASSERT(&ctrlr == g_ns_changed_ctrlr);
+	CU_ASSERT(2 == g_pg_updated_nsid);
+
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	CU_ASSERT(spdk_nvmf_subsystem_remove_ns(&subsystem, 2) == 0);
+	CU_ASSERT(subsystem.ana_group[1] == 0);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
 
 	/* Namespace remove event */
 	subsystem.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
@@ -775,7 +775,7 @@ test_nvmf_tcp_qpair_init_mem_resource(void)
 	CU_ASSERT(tqpair->host_hdgst_enable == true);
 	CU_ASSERT(tqpair->host_ddgst_enable == true);
 
-	rc = nvmf_tcp_qpair_init_mem_resource(tqpair);
+	rc = nvmf_tcp_qpair_init_mem_resource(tqpair, NULL);
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(tqpair->resource_count == SPDK_NVMF_TCP_DEFAULT_MAX_IO_QUEUE_DEPTH);
 	CU_ASSERT(tqpair->reqs != NULL);
@@ -816,6 +816,84 @@ test_nvmf_tcp_qpair_init_mem_resource(void)
 	spdk_thread_destroy(thread);
 }
 
+static void
+test_nvmf_tcp_icd_pool(void)
+{
+	struct spdk_nvmf_tcp_qpair *tqpair;
+	struct spdk_nvmf_transport transport = {};
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
+	struct spdk_nvmf_tcp_req *tcp_req[4];
+	struct spdk_thread *thread;
+	void *buf[4];
+	int i, rc;
+
+	thread = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	spdk_set_thread(thread);
+
+	tqpair = calloc(1, sizeof(*tqpair));
+	SPDK_CU_ASSERT_FATAL(tqpair != NULL);
+	tqpair->qpair.transport = &transport;
+	nvmf_tcp_opts_init(&transport.opts);
+
+	/* Two buffers are shared by the poll group, one is owned by the qpair */
+	rc = nvmf_tcp_icd_pool_create(&tgroup.icd_pool, 2, transport.opts.in_capsule_data_size, 1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tgroup.icd_pool.num_bufs == 2);
+
+	rc = nvmf_tcp_qpair_init(&tqpair->qpair);
+	CU_ASSERT(rc == 0);
+	rc = nvmf_tcp_qpair_init_mem_resource(tqpair, &tgroup);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tqpair->shared_icd == true);
+	CU_ASSERT(tqpair->bufs != NULL);
+	CU_ASSERT(!STAILQ_EMPTY(&tqpair->icd_bufs));
+	CU_ASSERT(tqpair->reqs[0].buf == NULL);
+
+	for (i = 0; i < 4; i++) {
+		tcp_req[i] = &tqpair->reqs[i];
+		buf[i] = nvmf_tcp_icd_buf_get(&tgroup, tqpair, tcp_req[i]);
+		tcp_req[i]->buf = buf[i];
+	}
+
+	/* The qpair's own buffer is used first, then the pool */
+	CU_ASSERT(buf[0] == tqpair->bufs);
+	CU_ASSERT(tcp_req[0]->icd_buf_borrowed == false);
+	CU_ASSERT(buf[1] != NULL);
+	CU_ASSERT(tcp_req[1]->icd_buf_borrowed == true);
+	CU_ASSERT(buf[2] != NULL);
+	CU_ASSERT(tcp_req[2]->icd_buf_borrowed == true);
+	CU_ASSERT(buf[3] == NULL);
+	CU_ASSERT(tgroup.icd_pool.in_use == 2);
+	CU_ASSERT(tgroup.icd_pool.max_in_use == 2);
+
+	nvmf_tcp_icd_buf_put(&tgroup, tqpair, tcp_req[1]);
+	CU_ASSERT(tcp_req[1]->buf == NULL);
+	CU_ASSERT(tcp_req[1]->icd_buf_borrowed == false);
+	CU_ASSERT(tgroup.icd_pool.in_use == 1);
+	CU_ASSERT(tgroup.icd_pool.max_in_use == 2);
+
+	/* A returned buffer can be borrowed again */
+	tcp_req[3]->buf = nvmf_tcp_icd_buf_get(&tgroup, tqpair, tcp_req[3]);
+	CU_ASSERT(tcp_req[3]->buf == buf[1]);
+	CU_ASSERT(tgroup.icd_pool.in_use == 2);
+
+	nvmf_tcp_icd_buf_put(&tgroup, tqpair, tcp_req[0]);
+	nvmf_tcp_icd_buf_put(&tgroup, tqpair, tcp_req[2]);
+	nvmf_tcp_icd_buf_put(&tgroup, tqpair, tcp_req[3]);
+	CU_ASSERT(tgroup.icd_pool.in_use == 0);
+	CU_ASSERT(STAILQ_FIRST(&tqpair->icd_bufs) == tqpair->bufs);
+
+	nvmf_tcp_qpair_destroy(tqpair);
+	spdk_free(tgroup.icd_pool.bufs);
+
+	spdk_thread_exit(thread);
+	while (!spdk_thread_is_exited(thread)) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+	spdk_thread_destroy(thread);
+}
+
 static void
 test_nvmf_tcp_send_c2h_term_req(void)
 {
@@ -946,6 +1024,27 @@ test_nvmf_tcp_icreq_handle(void)
 	CU_ASSERT(ic_resp->dgst.bits.hdgst_enable == 0);
 	CU_ASSERT(ic_resp->dgst.bits.ddgst_enable == 0);
 	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+	CU_ASSERT(tqpair.zero_copy_recv == false);
+
+	/* case 4: Expect: PASS, the receive pipe is disabled. */
+	ttransport.tcp_opts.zero_copy_recv = true;
+	tqpair.state = NVME_TCP_QPAIR_STATE_INVALID;
+	nvmf_tcp_qpair_set_recv_state(&tqpair, NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+
+	nvmf_tcp_icreq_handle(&ttransport, &tqpair, &pdu);
+
+	CU_ASSERT(tqpair.zero_copy_recv == true);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+
+	/* case 5: Expect: PASS, the receive pipe could not be disabled. */
+	ttransport.tcp_opts.zero_copy_recv = true;
+	tqpair.zero_copy_recv = false;
+	MOCK_SET(spdk_sock_set_recvbuf, -ENOMEM);
+
+	nvmf_tcp_icreq_handle(&ttransport, &tqpair, &pdu);
+
+	CU_ASSERT(tqpair.zero_copy_recv == false);
+	MOCK_CLEAR(spdk_sock_set_recvbuf);
 }
 
 static void
@@ -1463,6 +1562,86 @@ test_nvmf_tcp_tls_generate_tls_psk(void)
 					  NVME_TCP_CIPHER_AES_128_GCM_SHA256) < 0);
 }
 
+static void
+test_nvmf_tcp_pdu_use_accel_digest(void)
+{
+	struct spdk_nvmf_tcp_transport ttransport = {};
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
+	struct spdk_nvmf_tcp_qpair tqpair = {};
+	struct nvme_tcp_pdu pdu = {};
+	struct spdk_dif_ctx dif_ctx = {};
+
+	ttransport.tcp_opts.digest_accel_threshold = 4096;
+	tqpair.qpair.transport = &ttransport.transport;
+	tqpair.group = &tgroup;
+
+	/* The data of the PDU reaches the threshold */
+	pdu.data_len = 4096;
+	CU_ASSERT(nvmf_tcp_pdu_use_accel_digest(&tqpair, &pdu) == true);
+
+	/* Small PDUs are computed inline */
+	pdu.data_len = 2048;
+	CU_ASSERT(nvmf_tcp_pdu_use_accel_digest(&tqpair, &pdu) == false);
+
+	ttransport.tcp_opts.digest_accel_threshold = 0;
+	CU_ASSERT(nvmf_tcp_pdu_use_accel_digest(&tqpair, &pdu) == true);
+
+	/* Unaligned length */
+	pdu.data_len = 2049;
+	CU_ASSERT(nvmf_tcp_pdu_use_accel_digest(&tqpair, &pdu) == false);
+
+	/* DIF */
+	pdu.data_len = 2048;
+	pdu.dif_ctx = &dif_ctx;
+	CU_ASSERT(nvmf_tcp_pdu_use_accel_digest(&tqpair, &pdu) == false);
+
+	/* No poll group */
+	pdu.dif_ctx = NULL;
+	tqpair.group = NULL;
+	CU_ASSERT(nvmf_tcp_pdu_use_accel_digest(&tqpair, &pdu) == false);
+}
+
+static void
+test_nvmf_tcp_select_poll_group(void)
+{
+	struct spdk_nvmf_tcp_transport ttransport = {};
+	struct spdk_nvmf_tcp_poll_group tgroups[3] = {};
+	int i;
+
+	TAILQ_INIT(&ttransport.poll_groups);
+	for (i = 0; i < 3; i++) {
+		tgroups[i].numa_id = i == 2 ? 1 : 0;
+		TAILQ_INSERT_TAIL(&ttransport.poll_groups, &tgroups[i], link);
+	}
+	ttransport.next_pg = &tgroups[1];
+
+	/* Without the policy options the next poll group in round-robin order is used */
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, 1) == &tgroups[1]);
+
+	/* Prefer poll groups on the NUMA node of the NIC */
+	ttransport.tcp_opts.numa_placement = true;
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, 1) == &tgroups[2]);
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, 0) == &tgroups[1]);
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, -1) == &tgroups[1]);
+
+	/* Skip overloaded poll groups, wrapping around the list */
+	ttransport.tcp_opts.poll_group_load_threshold = 80;
+	tgroups[1].load = 80;
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, 0) == &tgroups[0]);
+
+	/* A local but overloaded poll group beats a remote one */
+	tgroups[0].load = 90;
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, 0) == &tgroups[1]);
+
+	/* With no local poll group, take one that isn't overloaded */
+	tgroups[2].load = 10;
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, 2) == &tgroups[2]);
+
+	/* Everything is overloaded, fall back to round-robin */
+	tgroups[2].load = 100;
+	CU_ASSERT(nvmf_tcp_select_poll_group(&ttransport, 2) == &tgroups[1]);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1480,6 +1659,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_tcp_h2c_data_hdr_handle);
 	CU_ADD_TEST(suite, test_nvmf_tcp_in_capsule_data_handle);
 	CU_ADD_TEST(suite, test_nvmf_tcp_qpair_init_mem_resource);
+	CU_ADD_TEST(suite, test_nvmf_tcp_icd_pool);
 	CU_ADD_TEST(suite, test_nvmf_tcp_send_c2h_term_req);
 	CU_ADD_TEST(suite, test_nvmf_tcp_send_capsule_resp_pdu);
 	CU_ADD_TEST(suite, test_nvmf_tcp_icreq_handle);
@@ -1490,6 +1670,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_psk_id);
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_retained_psk);
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_tls_psk);
+	CU_ADD_TEST(suite, test_nvmf_tcp_pdu_use_accel_digest);
+	CU_ADD_TEST(suite, test_nvmf_tcp_select_poll_group);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
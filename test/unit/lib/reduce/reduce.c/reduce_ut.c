@@ -65,6 +65,7 @@ static bool g_defer_bdev_io = false;
 static TAILQ_HEAD(, ut_reduce_bdev_io) g_pending_bdev_io =
 	TAILQ_HEAD_INITIALIZER(g_pending_bdev_io);
 static uint32_t g_pending_bdev_io_count = 0;
+static uint32_t g_readv_count = 0;
 
 static void
 sync_pm_buf(const void *addr, size_t length)
@@ -273,6 +274,7 @@ static void
 backing_dev_readv(struct spdk_reduce_backing_dev *backing_dev, struct iovec *iov, int iovcnt,
 		  uint64_t lba, uint32_t lba_count, struct spdk_reduce_vol_cb_args *args)
 {
+	g_readv_count++;
 	if (g_defer_bdev_io == false) {
 		CU_ASSERT(g_pending_bdev_io_count == 0);
 		CU_ASSERT(TAILQ_EMPTY(&g_pending_bdev_io));
@@ -1818,6 +1820,203 @@ test_allocate_vol_requests(void)
 	}
 }
 
+static void
+cached_chunk(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct iovec iov;
+	char buf[16 * 1024]; /* chunk size */
+	char compare_buf[16 * 1024];
+	uint32_t readv_count;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, TEST_MD_PATH, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+
+	/* Write 0xAA to LBA 2-3 and 0xBB to LBA 4-5 of the first chunk */
+	memset(buf, 0xAA, 2 * params.logical_block_size);
+	iov.iov_base = buf;
+	iov.iov_len = 2 * params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, 2, 2, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	/* The chunk is cached, so the second write doesn't need to read it back */
+	readv_count = g_readv_count;
+	memset(buf, 0xBB, 2 * params.logical_block_size);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, 4, 2, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(g_readv_count == readv_count);
+
+	/* The whole chunk is read with a single backing operation, as its io units are contiguous */
+	memset(compare_buf, 0, sizeof(compare_buf));
+	memset(compare_buf + 2 * params.logical_block_size, 0xAA, 2 * params.logical_block_size);
+	memset(compare_buf + 4 * params.logical_block_size, 0xBB, 2 * params.logical_block_size);
+	memset(buf, 0xFF, sizeof(buf));
+	iov.iov_len = params.chunk_size;
+	readv_count = g_readv_count;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 0, params.chunk_size / params.logical_block_size,
+			      read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(g_readv_count == readv_count + 1);
+	CU_ASSERT(memcmp(buf, compare_buf, params.chunk_size) == 0);
+
+	/* Full chunk writes drop the cached copy, so the next partial write has to read the chunk */
+	memset(buf, 0xCC, sizeof(buf));
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, 0, params.chunk_size / params.logical_block_size,
+			       write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	readv_count = g_readv_count;
+	memset(buf, 0xDD, params.logical_block_size);
+	iov.iov_len = params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, 1, 1, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(g_readv_count > readv_count);
+
+	memset(compare_buf, 0xCC, sizeof(compare_buf));
+	memset(compare_buf + params.logical_block_size, 0xDD, params.logical_block_size);
+	memset(buf, 0xFF, sizeof(buf));
+	iov.iov_len = params.chunk_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 0, params.chunk_size / params.logical_block_size,
+			      read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, params.chunk_size) == 0);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	persistent_pm_buf_destroy();
+	backing_dev_destroy(&backing_dev);
+}
+
+static void
+md_on_backing_dev(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct spdk_reduce_vol_superblock *super;
+	struct iovec iov;
+	char buf[16 * 1024]; /* chunk size */
+	char compare_buf[16 * 1024];
+	uint64_t *logical_map, md_offset;
+	uint32_t i;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	/* Without a pm file directory, the metadata is placed at the end of the backing device */
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, NULL, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_persistent_pm_buf == NULL);
+	CU_ASSERT(params.vol_size < _get_vol_size(params.chunk_size, 4 * 1024 * 1024));
+
+	super = (struct spdk_reduce_vol_superblock *)g_backing_dev_buf;
+	CU_ASSERT(memcmp(super->signature, SPDK_REDUCE_SIGNATURE, 8) == 0);
+	CU_ASSERT(super->flags & REDUCE_SUPER_FLAG_MD_ON_BACKING_DEV);
+	md_offset = _get_md_offset(&params, backing_dev.blocklen) * backing_dev.blocklen;
+	CU_ASSERT(md_offset + _get_md_size(&params, backing_dev.blocklen) <= 4 * 1024 * 1024);
+	CU_ASSERT(memcmp(g_backing_dev_buf + md_offset, super, sizeof(*super)) == 0);
+	logical_map = (uint64_t *)(g_backing_dev_buf + md_offset + sizeof(*super));
+	CU_ASSERT(logical_map[0] == REDUCE_EMPTY_MAP_ENTRY);
+
+	/* Write 0xAA to LBA 2-3, the write completes once the maps are on the backing device */
+	memset(buf, 0xAA, 2 * params.logical_block_size);
+	iov.iov_base = buf;
+	iov.iov_len = 2 * params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, 2, 2, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(logical_map[0] != REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(logical_map[0] == g_vol->pm_logical_map[0]);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	/* Load the volume back and overwrite part of the chunk */
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_vol->params.vol_size == params.vol_size);
+
+	memset(buf, 0xBB, params.logical_block_size);
+	iov.iov_len = params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, 3, 1, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+
+	/* The old chunk map was released after the logical map got updated, so it's reused */
+	CU_ASSERT(spdk_bit_array_count_set(g_vol->allocated_chunk_maps) == 1);
+
+	memset(compare_buf, 0, sizeof(compare_buf));
+	memset(compare_buf + 2 * params.logical_block_size, 0xAA, params.logical_block_size);
+	memset(compare_buf + 3 * params.logical_block_size, 0xBB, params.logical_block_size);
+	for (i = 0; i < 2; i++) {
+		memset(buf, 0xFF, sizeof(buf));
+		iov.iov_len = params.chunk_size;
+		g_reduce_errno = -1;
+		spdk_reduce_vol_readv(g_vol, &iov, 1, i * params.chunk_size / params.logical_block_size,
+				      params.chunk_size / params.logical_block_size, read_cb, NULL);
+		CU_ASSERT(g_reduce_errno == 0);
+		if (i == 0) {
+			CU_ASSERT(memcmp(buf, compare_buf, params.chunk_size) == 0);
+		} else {
+			CU_ASSERT(spdk_mem_all_zero(buf, params.chunk_size));
+		}
+	}
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	/* There's no pm file to remove when destroying the volume */
+	g_reduce_errno = -1;
+	spdk_reduce_vol_destroy(&backing_dev, destroy_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_reduce_errno = 0;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == -EILSEQ);
+
+	backing_dev_destroy(&backing_dev);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1844,6 +2043,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_prepare_compress_chunk);
 	CU_ADD_TEST(suite, test_reduce_decompress_chunk);
 	CU_ADD_TEST(suite, test_allocate_vol_requests);
+	CU_ADD_TEST(suite, cached_chunk);
+	CU_ADD_TEST(suite, md_on_backing_dev);
 
 	g_unlink_path = g_path;
 	g_unlink_callback = unlink_cb;
@@ -63,6 +63,8 @@ ut_lun_deinit(void)
 		TAILQ_REMOVE(&g_lun.reg_head, reg, link);
 		free(reg);
 	}
+	/* The registrants were freed behind the back of the lookup cache */
+	g_lun.pr_nexus_generation++;
 	g_lun.reservation.rtype = 0;
 	g_lun.reservation.crkey = 0;
 	g_lun.reservation.holder = NULL;
@@ -623,6 +625,44 @@ test_pr_with_scsi2_reserve_release(void)
 	ut_deinit_reservation_test();
 }
 
+static void
+test_pr_nexus_cache(void)
+{
+	struct spdk_scsi_pr_registrant *reg_a, *reg_b;
+	int rc;
+
+	ut_init_reservation_test();
+
+	/* A miss is cached too, until a registrant is added */
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_a, &g_t_port_0) == NULL);
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_a, &g_t_port_0) == NULL);
+
+	rc = scsi_pr_register_registrant(&g_lun, &g_i_port_a, &g_t_port_0, 0xa);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	reg_a = scsi_pr_get_registrant(&g_lun, &g_i_port_a, &g_t_port_0);
+	SPDK_CU_ASSERT_FATAL(reg_a != NULL);
+	CU_ASSERT(reg_a->rkey == 0xa);
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_a, &g_t_port_0) == reg_a);
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_b, &g_t_port_0) == NULL);
+
+	rc = scsi_pr_register_registrant(&g_lun, &g_i_port_b, &g_t_port_0, 0xb);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	reg_b = scsi_pr_get_registrant(&g_lun, &g_i_port_b, &g_t_port_0);
+	SPDK_CU_ASSERT_FATAL(reg_b != NULL);
+	CU_ASSERT(reg_b->rkey == 0xb);
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_a, &g_t_port_0) == reg_a);
+
+	/* Neither nexus may see a registrant which was unregistered */
+	scsi_pr_unregister_registrant(&g_lun, reg_a);
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_a, &g_t_port_0) == NULL);
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_b, &g_t_port_0) == reg_b);
+	scsi_pr_unregister_registrant(&g_lun, reg_b);
+	CU_ASSERT(scsi_pr_get_registrant(&g_lun, &g_i_port_b, &g_t_port_0) == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&g_lun.reg_head));
+
+	ut_deinit_reservation_test();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -639,6 +679,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_reservation_cmds_conflict);
 	CU_ADD_TEST(suite, test_scsi2_reserve_release);
 	CU_ADD_TEST(suite, test_pr_with_scsi2_reserve_release);
+	CU_ADD_TEST(suite, test_pr_nexus_cache);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
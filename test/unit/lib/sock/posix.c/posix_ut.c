@@ -131,10 +131,56 @@ flush(void)
 	CU_ASSERT(cb_arg1 == true);
 	CU_ASSERT(TAILQ_EMPTY(&sock->queued_reqs));
 
+	/* Each sendmsg was accounted to the group */
+	CU_ASSERT(group.base.stats.send_calls == 6);
+	CU_ASSERT(group.base.stats.bytes_sent == 64 + 128 + 64 + 10 + 24 + 30);
+
 	free(req1);
 	free(req2);
 }
 
+static void
+zcopy_complete(void)
+{
+	struct spdk_posix_sock psock = {};
+	struct spdk_sock *sock = &psock.base;
+	struct spdk_sock_request reqs[4] = {};
+	bool cb_args[4] = {};
+	int i, rc;
+
+	TAILQ_INIT(&sock->queued_reqs);
+	TAILQ_INIT(&sock->pending_reqs);
+
+	/* Requests 0-2 were sent by zero copy sendmsg calls UINT32_MAX - 1, UINT32_MAX and 0, and
+	 * request 3 without zero copy after them. */
+	for (i = 0; i < 4; i++) {
+		reqs[i].cb_fn = _req_cb;
+		reqs[i].cb_arg = &cb_args[i];
+		spdk_sock_request_queue(sock, &reqs[i]);
+		spdk_sock_request_pend(sock, &reqs[i]);
+		reqs[i].internal.is_zcopy = i < 3;
+	}
+	reqs[0].internal.offset = UINT32_MAX - 1;
+	reqs[1].internal.offset = UINT32_MAX;
+	reqs[2].internal.offset = 0;
+
+	/* The request outside of the range and the one waiting behind it stay pending */
+	rc = spdk_sock_complete_zcopy_reqs(sock, UINT32_MAX - 1, UINT32_MAX);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(cb_args[0] == true);
+	CU_ASSERT(cb_args[1] == true);
+	CU_ASSERT(cb_args[2] == false);
+	CU_ASSERT(cb_args[3] == false);
+	CU_ASSERT(TAILQ_FIRST(&sock->pending_reqs) == &reqs[2]);
+
+	/* A range wrapping around completes the rest */
+	rc = spdk_sock_complete_zcopy_reqs(sock, UINT32_MAX, 0);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(cb_args[2] == true);
+	CU_ASSERT(cb_args[3] == true);
+	CU_ASSERT(TAILQ_EMPTY(&sock->pending_reqs));
+}
+
 int
 main(int argc, char **argv)
 {
@@ -146,6 +192,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("posix", NULL, NULL);
 
 	CU_ADD_TEST(suite, flush);
+	CU_ADD_TEST(suite, zcopy_complete);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
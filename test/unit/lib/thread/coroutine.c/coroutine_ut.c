@@ -0,0 +1,197 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation. All rights reserved.
+ */
+
+#include "spdk_internal/cunit.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "thread/coroutine.c"
+
+struct ut_coroutine_ctx {
+	int			step;
+	int			status[4];
+	struct spdk_thread	*thread[4];
+	bool			done;
+};
+
+struct ut_async_op {
+	struct spdk_coroutine	*co;
+	int			status;
+};
+
+static void
+ut_async_op_done(void *ctx)
+{
+	struct ut_async_op *op = ctx;
+
+	spdk_coroutine_wake_cb(op->co, op->status);
+	free(op);
+}
+
+/* Emulate an asynchronous operation completing on a given thread */
+static void
+ut_async_op(struct spdk_thread *thread, int status)
+{
+	struct ut_async_op *op;
+
+	op = calloc(1, sizeof(*op));
+	SPDK_CU_ASSERT_FATAL(op != NULL);
+	op->co = spdk_coroutine_get_current();
+	op->status = status;
+
+	spdk_thread_send_msg(thread, ut_async_op_done, op);
+}
+
+static void
+ut_sequential_fn(void *_ctx)
+{
+	struct ut_coroutine_ctx *ctx = _ctx;
+
+	CU_ASSERT_PTR_NOT_NULL(spdk_coroutine_get_current());
+
+	/* Completion on the coroutine's own thread */
+	ut_async_op(spdk_get_thread(), -EIO);
+	ctx->step = 1;
+	ctx->status[0] = spdk_coroutine_await();
+	ctx->thread[0] = spdk_get_thread();
+
+	/* Completion on a different thread, the coroutine still resumes on its own */
+	ut_async_op(g_ut_threads[1].thread, 5);
+	ctx->step = 2;
+	ctx->status[1] = spdk_coroutine_await();
+	ctx->thread[1] = spdk_get_thread();
+
+	/* Completion before the coroutine is suspended */
+	spdk_coroutine_wake(spdk_coroutine_get_current(), 7);
+	ctx->step = 3;
+	ctx->status[2] = spdk_coroutine_await();
+	ctx->thread[2] = spdk_get_thread();
+
+	ctx->done = true;
+}
+
+static void
+coroutine_sequential(void)
+{
+	struct ut_coroutine_ctx ctx = {};
+	int rc;
+
+	allocate_threads(2);
+
+	/* Coroutines can only be started on SPDK threads */
+	set_thread(INVALID_THREAD);
+	rc = spdk_coroutine_start(ut_sequential_fn, &ctx);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+
+	set_thread(0);
+	CU_ASSERT_PTR_NULL(spdk_coroutine_get_current());
+	rc = spdk_coroutine_start(ut_sequential_fn, &ctx);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_PTR_NULL(spdk_coroutine_get_current());
+
+	/* The coroutine returned control once it started waiting */
+	CU_ASSERT_EQUAL(ctx.step, 1);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(ctx.step, 2);
+	CU_ASSERT_EQUAL(ctx.status[0], -EIO);
+	CU_ASSERT(ctx.thread[0] == g_ut_threads[0].thread);
+
+	poll_thread(0);
+	CU_ASSERT_EQUAL(ctx.step, 2);
+	poll_thread(1);
+	CU_ASSERT_EQUAL(ctx.step, 2);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(ctx.status[1], 5);
+	CU_ASSERT(ctx.thread[1] == g_ut_threads[0].thread);
+
+	poll_threads();
+	CU_ASSERT(ctx.done);
+	CU_ASSERT_EQUAL(ctx.status[2], 7);
+	CU_ASSERT(ctx.thread[2] == g_ut_threads[0].thread);
+
+	/* The finished coroutine was returned to the pool */
+	CU_ASSERT_EQUAL(g_coroutine_pool_count, 1);
+
+	free_threads();
+}
+
+static int g_order[8];
+static int g_order_count;
+
+static void
+ut_yield_fn(void *ctx)
+{
+	int id = *(int *)ctx, i;
+
+	for (i = 0; i < 2; i++) {
+		g_order[g_order_count++] = id;
+		spdk_coroutine_yield();
+	}
+}
+
+static void
+ut_nested_fn(void *ctx)
+{
+	int id = 2;
+
+	g_order[g_order_count++] = *(int *)ctx;
+	/* A coroutine started from another one returns control to it once suspended */
+	spdk_coroutine_start(ut_yield_fn, &id);
+	g_order[g_order_count++] = *(int *)ctx;
+}
+
+static void
+coroutine_yield(void)
+{
+	int id0 = 0, id1 = 1, expected[] = { 0, 1, 0, 1 };
+	int rc;
+
+	allocate_threads(1);
+	set_thread(0);
+
+	g_order_count = 0;
+	rc = spdk_coroutine_start(ut_yield_fn, &id0);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_coroutine_start(ut_yield_fn, &id1);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_order_count, 2);
+
+	/* Both coroutines are interleaved */
+	poll_threads();
+	CU_ASSERT_EQUAL(g_order_count, 4);
+	CU_ASSERT(memcmp(g_order, expected, sizeof(expected)) == 0);
+
+	g_order_count = 0;
+	rc = spdk_coroutine_start(ut_nested_fn, &id1);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_order_count, 3);
+	CU_ASSERT_EQUAL(g_order[0], 1);
+	CU_ASSERT_EQUAL(g_order[1], 2);
+	CU_ASSERT_EQUAL(g_order[2], 1);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_order_count, 4);
+	CU_ASSERT_EQUAL(g_order[3], 2);
+	CU_ASSERT_PTR_NULL(spdk_coroutine_get_current());
+
+	free_threads();
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("coroutine", NULL, NULL);
+
+	CU_ADD_TEST(suite, coroutine_sequential);
+	CU_ADD_TEST(suite, coroutine_yield);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	return num_failures;
+}
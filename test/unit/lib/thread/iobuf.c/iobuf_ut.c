@@ -78,6 +78,7 @@ iobuf(void)
 		{ .thread_id = 1, .module = "ut_module1", },
 		{ .thread_id = 1, .module = "ut_module1", },
 	};
+	struct iovec regions[2];
 	int rc, finish = 0;
 	uint32_t i;
 
@@ -91,6 +92,16 @@ iobuf(void)
 	rc = spdk_iobuf_initialize();
 	CU_ASSERT_EQUAL(rc, 0);
 
+	/* Check that the pool regions are reported */
+	rc = spdk_iobuf_get_pool_regions(regions, SPDK_COUNTOF(regions));
+	CU_ASSERT_EQUAL(rc, 2);
+	CU_ASSERT_PTR_EQUAL(regions[0].iov_base, g_iobuf.nodes[0].pools[IOBUF_POOL_SMALL].base);
+	CU_ASSERT_EQUAL(regions[0].iov_len, opts.small_bufsize * opts.small_pool_count);
+	CU_ASSERT_PTR_EQUAL(regions[1].iov_base, g_iobuf.nodes[0].pools[IOBUF_POOL_LARGE].base);
+	CU_ASSERT_EQUAL(regions[1].iov_len, opts.large_bufsize * opts.large_pool_count);
+	rc = spdk_iobuf_get_pool_regions(regions, 1);
+	CU_ASSERT_EQUAL(rc, 1);
+
 	rc = spdk_iobuf_register_module("ut_module0");
 	CU_ASSERT_EQUAL(rc, 0);
 
@@ -615,6 +626,440 @@ iobuf_cache(void)
 	free_cores();
 }
 
+static bool
+ut_iobuf_buf_in_pool(void *buf, uint32_t node, uint32_t idx)
+{
+	void *base = g_iobuf.nodes[node].pools[idx].base;
+
+	return buf >= base && buf < base + iobuf_pool_bufsize(idx) * iobuf_pool_node_count(idx);
+}
+
+static void
+ut_iobuf_get_stats_cb(struct spdk_iobuf_module_stats *modules, uint32_t num_modules, void *cb_arg)
+{
+	struct spdk_iobuf_module_stats *stats = cb_arg;
+
+	SPDK_CU_ASSERT_FATAL(num_modules == 1);
+	*stats = modules[0];
+}
+
+static void
+ut_iobuf_get_all_stats_cb(struct spdk_iobuf_module_stats *modules, uint32_t num_modules,
+			  void *cb_arg)
+{
+	struct spdk_iobuf_module_stats *stats = cb_arg;
+
+	SPDK_CU_ASSERT_FATAL(num_modules == 2);
+	memcpy(stats, modules, sizeof(*modules) * num_modules);
+}
+
+static void
+iobuf_medium(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = 4 * SMALL_BUFSIZE,
+		.medium_pool_count = { 2, 2 },
+		.medium_bufsize = { 2 * SMALL_BUFSIZE, 3 * SMALL_BUFSIZE },
+	};
+	struct spdk_iobuf_module_stats stats = {};
+	struct spdk_iobuf_channel iobuf_ch;
+	struct ut_iobuf_entry entries[8] = {};
+	struct iovec regions[4];
+	uint64_t sizes[] = { 1, SMALL_BUFSIZE, SMALL_BUFSIZE + 1, 2 * SMALL_BUFSIZE,
+			     2 * SMALL_BUFSIZE + 1, 3 * SMALL_BUFSIZE, 3 * SMALL_BUFSIZE + 1,
+			     4 * SMALL_BUFSIZE
+			   };
+	uint32_t i;
+	int rc, finish = 0;
+
+	allocate_cores(1);
+	allocate_threads(1);
+
+	set_thread(0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_medium, 2);
+
+	/* The medium pool regions are reported after the small and large ones */
+	rc = spdk_iobuf_get_pool_regions(regions, SPDK_COUNTOF(regions));
+	CU_ASSERT_EQUAL(rc, 4);
+	CU_ASSERT_PTR_EQUAL(regions[2].iov_base, g_iobuf.nodes[0].pools[IOBUF_POOL_MEDIUM + 0].base);
+	CU_ASSERT_EQUAL(regions[2].iov_len, 4 * SMALL_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(regions[3].iov_base, g_iobuf.nodes[0].pools[IOBUF_POOL_MEDIUM + 1].base);
+	CU_ASSERT_EQUAL(regions[3].iov_len, 6 * SMALL_BUFSIZE);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_channel_init(&iobuf_ch, "ut_module0", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.num_medium, 2);
+
+	/* Each request should be served from the smallest pool that fits it */
+	for (i = 0; i < SPDK_COUNTOF(sizes); ++i) {
+		entries[i].buf = spdk_iobuf_get(&iobuf_ch, sizes[i], &entries[i].iobuf,
+						ut_iobuf_get_buf_cb);
+		SPDK_CU_ASSERT_FATAL(entries[i].buf != NULL);
+	}
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[0].buf, 0, IOBUF_POOL_SMALL));
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[1].buf, 0, IOBUF_POOL_SMALL));
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[2].buf, 0, IOBUF_POOL_MEDIUM + 0));
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[3].buf, 0, IOBUF_POOL_MEDIUM + 0));
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[4].buf, 0, IOBUF_POOL_MEDIUM + 1));
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[5].buf, 0, IOBUF_POOL_MEDIUM + 1));
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[6].buf, 0, IOBUF_POOL_LARGE));
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[7].buf, 0, IOBUF_POOL_LARGE));
+
+	/* Return the small buffers and verify that the exhausted medium pool doesn't borrow them */
+	spdk_iobuf_put(&iobuf_ch, entries[0].buf, sizes[0]);
+	spdk_iobuf_put(&iobuf_ch, entries[1].buf, sizes[1]);
+	entries[0].buf = spdk_iobuf_get(&iobuf_ch, sizes[2], &entries[0].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entries[0].buf);
+
+	/* Returning a buffer of the second medium class shouldn't satisfy it either */
+	spdk_iobuf_put(&iobuf_ch, entries[4].buf, sizes[4]);
+	CU_ASSERT_PTR_NULL(entries[0].buf);
+
+	/* Only a buffer of the same class should */
+	spdk_iobuf_put(&iobuf_ch, entries[2].buf, sizes[2]);
+	CU_ASSERT_PTR_NOT_NULL(entries[0].buf);
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[0].buf, 0, IOBUF_POOL_MEDIUM + 0));
+
+	/* Aborting a request removes it from the queue of its class */
+	entries[1].buf = spdk_iobuf_get(&iobuf_ch, sizes[3], &entries[1].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entries[1].buf);
+	CU_ASSERT_PTR_EQUAL(STAILQ_FIRST(iobuf_ch.medium[0].queue), &entries[1].iobuf);
+	spdk_iobuf_entry_abort(&iobuf_ch, &entries[1].iobuf, sizes[3]);
+	CU_ASSERT(STAILQ_EMPTY(iobuf_ch.medium[0].queue));
+
+	spdk_iobuf_put(&iobuf_ch, entries[0].buf, sizes[2]);
+	spdk_iobuf_put(&iobuf_ch, entries[3].buf, sizes[3]);
+	spdk_iobuf_put(&iobuf_ch, entries[5].buf, sizes[5]);
+	spdk_iobuf_put(&iobuf_ch, entries[6].buf, sizes[6]);
+	spdk_iobuf_put(&iobuf_ch, entries[7].buf, sizes[7]);
+
+	/* Check the statistics: the channel has no cache, so each buffer came from the pool */
+	rc = spdk_iobuf_get_stats(ut_iobuf_get_stats_cb, &stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_STRING_EQUAL(stats.module, "ut_module0");
+	CU_ASSERT_EQUAL(stats.num_medium, 2);
+	CU_ASSERT_EQUAL(stats.small_pool.cache, 0);
+	CU_ASSERT_EQUAL(stats.small_pool.main, 2);
+	CU_ASSERT_EQUAL(stats.small_pool.retry, 0);
+	CU_ASSERT_EQUAL(stats.medium_pool[0].main, 2);
+	CU_ASSERT_EQUAL(stats.medium_pool[0].retry, 2);
+	CU_ASSERT_EQUAL(stats.medium_pool[1].main, 2);
+	CU_ASSERT_EQUAL(stats.medium_pool[1].retry, 0);
+	CU_ASSERT_EQUAL(stats.large_pool.main, 2);
+	CU_ASSERT_EQUAL(stats.large_pool.retry, 0);
+
+	spdk_iobuf_channel_fini(&iobuf_ch);
+	poll_threads();
+
+	/* Medium pools with caches are filled using the large cache size */
+	rc = spdk_iobuf_channel_init(&iobuf_ch, "ut_module0", 1, 2);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.small.cache_count, 1);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[0].cache_count, 2);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[1].cache_count, 2);
+	CU_ASSERT_EQUAL(iobuf_ch.large.cache_count, 2);
+
+	entries[0].buf = spdk_iobuf_get(&iobuf_ch, sizes[2], &entries[0].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NOT_NULL(entries[0].buf);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[0].stats.cache, 1);
+	CU_ASSERT_EQUAL(iobuf_ch.medium[0].stats.main, 0);
+	spdk_iobuf_put(&iobuf_ch, entries[0].buf, sizes[2]);
+
+	spdk_iobuf_channel_fini(&iobuf_ch);
+	poll_threads();
+
+	rc = spdk_iobuf_unregister_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	/* Verify the medium size classes validation */
+	opts.small_pool_count = 64;
+	opts.large_pool_count = 8;
+	opts.medium_bufsize[1] = opts.medium_bufsize[0];
+	rc = spdk_iobuf_set_opts(&opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	opts.medium_bufsize[1] = opts.large_bufsize;
+	rc = spdk_iobuf_set_opts(&opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	opts.medium_bufsize[0] = opts.small_bufsize;
+	rc = spdk_iobuf_set_opts(&opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+
+	/* The classes following a disabled one are ignored */
+	opts.medium_bufsize[0] = 2 * SMALL_BUFSIZE;
+	opts.medium_pool_count[0] = 0;
+	rc = spdk_iobuf_set_opts(&opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.opts.medium_pool_count[1], 0);
+	CU_ASSERT_EQUAL(g_iobuf.opts.medium_bufsize[1], 0);
+
+	free_threads();
+	free_cores();
+}
+
+static void
+iobuf_numa(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 4,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+	};
+	struct spdk_iobuf_channel iobuf_ch[2];
+	struct ut_iobuf_entry entries[5] = {};
+	struct iovec regions[4];
+	uint32_t i;
+	int rc, finish = 0;
+
+	allocate_cores(2);
+	allocate_threads(2);
+	set_core_socket(0, 0);
+	set_core_socket(1, 1);
+
+	set_thread(0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* The pools should be split between the two nodes */
+	SPDK_CU_ASSERT_FATAL(g_iobuf.num_nodes == 2);
+	CU_ASSERT_EQUAL(g_iobuf.nodes[0].socket_id, 0);
+	CU_ASSERT_EQUAL(g_iobuf.nodes[1].socket_id, 1);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[0].pools[IOBUF_POOL_SMALL].ring), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[1].pools[IOBUF_POOL_SMALL].ring), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[0].pools[IOBUF_POOL_LARGE].ring), 1);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[1].pools[IOBUF_POOL_LARGE].ring), 1);
+
+	rc = spdk_iobuf_get_pool_regions(regions, SPDK_COUNTOF(regions));
+	CU_ASSERT_EQUAL(rc, 4);
+	CU_ASSERT_PTR_EQUAL(regions[2].iov_base, g_iobuf.nodes[1].pools[IOBUF_POOL_SMALL].base);
+	CU_ASSERT_EQUAL(regions[2].iov_len, 2 * SMALL_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(regions[3].iov_base, g_iobuf.nodes[1].pools[IOBUF_POOL_LARGE].base);
+	CU_ASSERT_EQUAL(regions[3].iov_len, LARGE_BUFSIZE);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Each channel should be bound to the node of its thread's core */
+	for (i = 0; i < 2; ++i) {
+		set_thread(i);
+		MOCK_SET(spdk_env_get_current_core, i);
+		rc = spdk_iobuf_channel_init(&iobuf_ch[i], "ut_module0", 0, 0);
+		CU_ASSERT_EQUAL(rc, 0);
+		CU_ASSERT_PTR_EQUAL(iobuf_ch[i].small.pool,
+				    g_iobuf.nodes[i].pools[IOBUF_POOL_SMALL].ring);
+	}
+
+	/* The local buffers are used first */
+	set_thread(0);
+	for (i = 0; i < 2; ++i) {
+		entries[i].buf = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, &entries[i].iobuf,
+						ut_iobuf_get_buf_cb);
+		CU_ASSERT(ut_iobuf_buf_in_pool(entries[i].buf, 0, IOBUF_POOL_SMALL));
+	}
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.stats.remote, 0);
+
+	/* Once they're exhausted, the remote node's buffers are used */
+	for (i = 2; i < 4; ++i) {
+		entries[i].buf = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, &entries[i].iobuf,
+						ut_iobuf_get_buf_cb);
+		CU_ASSERT(ut_iobuf_buf_in_pool(entries[i].buf, 1, IOBUF_POOL_SMALL));
+	}
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.stats.remote, 2);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.stats.main, 4);
+
+	/* Only once all of them are exhausted, the request needs to wait */
+	entries[4].buf = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, &entries[4].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entries[4].buf);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.stats.retry, 1);
+
+	spdk_iobuf_put(&iobuf_ch[0], entries[2].buf, SMALL_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(entries[4].buf, entries[2].buf);
+
+	/* Buffers should be returned to the node they were allocated from */
+	spdk_iobuf_put(&iobuf_ch[0], entries[0].buf, SMALL_BUFSIZE);
+	spdk_iobuf_put(&iobuf_ch[0], entries[3].buf, SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[0].pools[IOBUF_POOL_SMALL].ring), 1);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[1].pools[IOBUF_POOL_SMALL].ring), 1);
+
+	/* The second thread should get its local buffer */
+	set_thread(1);
+	entries[0].buf = spdk_iobuf_get(&iobuf_ch[1], SMALL_BUFSIZE, &entries[0].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT(ut_iobuf_buf_in_pool(entries[0].buf, 1, IOBUF_POOL_SMALL));
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.stats.remote, 0);
+	spdk_iobuf_put(&iobuf_ch[1], entries[0].buf, SMALL_BUFSIZE);
+
+	set_thread(0);
+	spdk_iobuf_put(&iobuf_ch[0], entries[1].buf, SMALL_BUFSIZE);
+	spdk_iobuf_put(&iobuf_ch[0], entries[4].buf, SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[0].pools[IOBUF_POOL_SMALL].ring), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[1].pools[IOBUF_POOL_SMALL].ring), 2);
+
+	/* Caches are filled from the remote node too, if the local one doesn't have enough */
+	spdk_iobuf_channel_fini(&iobuf_ch[0]);
+	poll_threads();
+	rc = spdk_iobuf_channel_init(&iobuf_ch[0], "ut_module0", 3, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.cache_count, 3);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.stats.remote, 1);
+	spdk_iobuf_channel_fini(&iobuf_ch[0]);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[0].pools[IOBUF_POOL_SMALL].ring), 2);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.nodes[1].pools[IOBUF_POOL_SMALL].ring), 2);
+
+	set_thread(1);
+	spdk_iobuf_channel_fini(&iobuf_ch[1]);
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+	free_threads();
+	free_cores();
+}
+
+static void
+iobuf_stats(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+	};
+	struct spdk_iobuf_module_stats stats[2];
+	struct spdk_iobuf_channel mod0_ch[2], mod1_ch[2];
+	struct ut_iobuf_entry entries[4] = {};
+	uint32_t i;
+	int rc, finish = 0;
+
+	allocate_cores(2);
+	allocate_threads(2);
+
+	set_thread(0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_iobuf_register_module("ut_module1");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	for (i = 0; i < 2; ++i) {
+		set_thread(i);
+		rc = spdk_iobuf_channel_init(&mod0_ch[i], "ut_module0", 0, 0);
+		CU_ASSERT_EQUAL(rc, 0);
+		rc = spdk_iobuf_channel_init(&mod1_ch[i], "ut_module1", 0, 0);
+		CU_ASSERT_EQUAL(rc, 0);
+	}
+
+	/* Exhaust the small pool from module0 and make module1 wait for a buffer */
+	set_thread(0);
+	for (i = 0; i < 2; ++i) {
+		entries[i].buf = spdk_iobuf_get(&mod0_ch[0], SMALL_BUFSIZE, &entries[i].iobuf,
+						ut_iobuf_get_buf_cb);
+		CU_ASSERT_PTR_NOT_NULL(entries[i].buf);
+	}
+	MOCK_SET(spdk_get_ticks, 100);
+	entries[2].buf = spdk_iobuf_get(&mod1_ch[0], SMALL_BUFSIZE, &entries[2].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entries[2].buf);
+
+	/* The wait time is accounted to the module that was waiting */
+	MOCK_SET(spdk_get_ticks, 350);
+	spdk_iobuf_put(&mod0_ch[0], entries[0].buf, SMALL_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(entries[2].buf, entries[0].buf);
+	CU_ASSERT_EQUAL(mod1_ch[0].small.stats.wait_ticks, 250);
+	CU_ASSERT_EQUAL(mod0_ch[0].small.stats.wait_ticks, 0);
+
+	/* Get a large buffer on the other thread */
+	set_thread(1);
+	entries[3].buf = spdk_iobuf_get(&mod0_ch[1], LARGE_BUFSIZE, &entries[3].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NOT_NULL(entries[3].buf);
+
+	/* The statistics should be aggregated over all the channels of each module */
+	rc = spdk_iobuf_get_stats(ut_iobuf_get_all_stats_cb, stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_STRING_EQUAL(stats[0].module, "ut_module0");
+	CU_ASSERT_EQUAL(stats[0].small_pool.main, 2);
+	CU_ASSERT_EQUAL(stats[0].small_pool.retry, 0);
+	CU_ASSERT_EQUAL(stats[0].small_pool.outstanding, 1);
+	CU_ASSERT_EQUAL(stats[0].small_pool.wait_ticks, 0);
+	CU_ASSERT_EQUAL(stats[0].large_pool.main, 1);
+	CU_ASSERT_EQUAL(stats[0].large_pool.outstanding, 1);
+	CU_ASSERT_STRING_EQUAL(stats[1].module, "ut_module1");
+	CU_ASSERT_EQUAL(stats[1].small_pool.main, 0);
+	CU_ASSERT_EQUAL(stats[1].small_pool.retry, 1);
+	CU_ASSERT_EQUAL(stats[1].small_pool.outstanding, 1);
+	CU_ASSERT_EQUAL(stats[1].small_pool.wait_ticks, 250);
+	CU_ASSERT_EQUAL(stats[1].large_pool.main, 0);
+	CU_ASSERT_EQUAL(stats[1].large_pool.outstanding, 0);
+
+	/* Release the buffers through other channels of the same modules than the ones they were
+	 * retrieved from, the modules shouldn't be holding any buffers afterwards.
+	 */
+	spdk_iobuf_put(&mod1_ch[1], entries[2].buf, SMALL_BUFSIZE);
+	spdk_iobuf_put(&mod0_ch[1], entries[1].buf, SMALL_BUFSIZE);
+	set_thread(0);
+	spdk_iobuf_put(&mod0_ch[0], entries[3].buf, LARGE_BUFSIZE);
+
+	rc = spdk_iobuf_get_stats(ut_iobuf_get_all_stats_cb, stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	for (i = 0; i < 2; ++i) {
+		CU_ASSERT_EQUAL(stats[i].small_pool.outstanding, 0);
+		CU_ASSERT_EQUAL(stats[i].large_pool.outstanding, 0);
+	}
+
+	for (i = 0; i < 2; ++i) {
+		set_thread(i);
+		spdk_iobuf_channel_fini(&mod0_ch[i]);
+		spdk_iobuf_channel_fini(&mod1_ch[i]);
+	}
+	poll_threads();
+
+	set_thread(0);
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	MOCK_CLEAR(spdk_get_ticks);
+	free_threads();
+	free_cores();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -626,6 +1071,9 @@ main(int argc, char **argv)
 	suite = CU_add_suite("io_channel", NULL, NULL);
 	CU_ADD_TEST(suite, iobuf);
 	CU_ADD_TEST(suite, iobuf_cache);
+	CU_ADD_TEST(suite, iobuf_medium);
+	CU_ADD_TEST(suite, iobuf_numa);
+	CU_ADD_TEST(suite, iobuf_stats);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
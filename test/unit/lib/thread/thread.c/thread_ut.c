@@ -146,6 +146,157 @@ thread_send_msg(void)
 	free_threads();
 }
 
+struct ut_embedded_msg {
+	struct spdk_thread_msg	msg;
+	struct spdk_thread	*thread;
+	int			count;
+	int			resend;
+};
+
+static void
+send_msg_embedded_cb(void *ctx)
+{
+	struct ut_embedded_msg *emsg = ctx;
+	int rc;
+
+	emsg->count++;
+	if (emsg->resend > 0) {
+		emsg->resend--;
+		/* The message can be sent again from within its own callback */
+		rc = spdk_thread_send_msg_embedded(emsg->thread, &emsg->msg, send_msg_embedded_cb,
+						   emsg);
+		CU_ASSERT_EQUAL(rc, 0);
+	}
+}
+
+static void
+send_msg_count_cb(void *ctx)
+{
+	int *count = ctx;
+
+	(*count)++;
+}
+
+static void
+thread_send_msg_embedded(void)
+{
+	struct spdk_thread *thread0;
+	struct ut_embedded_msg emsg = {};
+	int i, rc, count = 0;
+
+	allocate_threads(2);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+	emsg.thread = thread0;
+
+	set_thread(1);
+	rc = spdk_thread_send_msg_embedded(thread0, &emsg.msg, send_msg_embedded_cb, &emsg);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_thread(1);
+	CU_ASSERT_EQUAL(emsg.count, 0);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(emsg.count, 1);
+
+	/* Check that the message can be reused after its callback has been executed */
+	emsg.resend = 2;
+	rc = spdk_thread_send_msg_embedded(thread0, &emsg.msg, send_msg_embedded_cb, &emsg);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(emsg.count, 4);
+
+	/* Verify the batch size limits the number of messages executed per poll */
+	rc = spdk_thread_set_msg_batch_size(thread0, 0);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	rc = spdk_thread_set_msg_batch_size(thread0, SPDK_THREAD_MAX_MSG_BATCH_SIZE + 1);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	rc = spdk_thread_set_msg_batch_size(thread0, 3);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	for (i = 0; i < 10; i++) {
+		rc = spdk_thread_send_msg(thread0, send_msg_count_cb, &count);
+		CU_ASSERT_EQUAL(rc, 0);
+	}
+	spdk_thread_poll(thread0, 0, 0);
+	CU_ASSERT_EQUAL(count, 3);
+	spdk_thread_poll(thread0, 2, 0);
+	CU_ASSERT_EQUAL(count, 5);
+
+	rc = spdk_thread_set_msg_batch_size(thread0, SPDK_THREAD_MAX_MSG_BATCH_SIZE);
+	CU_ASSERT_EQUAL(rc, 0);
+	spdk_thread_poll(thread0, 0, 0);
+	CU_ASSERT_EQUAL(count, 10);
+
+	free_threads();
+}
+
+static void
+stealable_msg_cb(void *ctx)
+{
+	struct spdk_thread **thread = ctx;
+
+	*thread = spdk_get_thread();
+}
+
+static void
+thread_send_stealable_msg(void)
+{
+	struct spdk_thread *thread0, *thread1, *executed[8] = {};
+	bool done = false;
+	int i, rc, count;
+
+	allocate_threads(3);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+	set_thread(1);
+	thread1 = spdk_get_thread();
+
+	set_thread(2);
+	for (i = 0; i < 8; i++) {
+		rc = spdk_thread_send_stealable_msg(thread0, stealable_msg_cb, &executed[i]);
+		CU_ASSERT_EQUAL(rc, 0);
+	}
+	CU_ASSERT_EQUAL(g_stealable_msg_count, 8);
+	CU_ASSERT(!spdk_thread_is_idle(thread0));
+
+	/* A thread with work of its own doesn't steal any messages */
+	rc = spdk_thread_send_msg(thread1, send_msg_cb, &done);
+	CU_ASSERT_EQUAL(rc, 0);
+	set_thread(1);
+	rc = spdk_thread_poll(thread1, 0, 0);
+	CU_ASSERT_EQUAL(rc, 1);
+	CU_ASSERT(done);
+	CU_ASSERT_EQUAL(g_stealable_msg_count, 8);
+
+	/* An idle thread takes half of the pending messages */
+	rc = spdk_thread_poll(thread1, 0, 0);
+	CU_ASSERT_EQUAL(rc, 1);
+	CU_ASSERT_EQUAL(g_stealable_msg_count, 4);
+	for (i = 0, count = 0; i < 8; i++) {
+		if (executed[i] != NULL) {
+			CU_ASSERT(executed[i] == thread1);
+			count++;
+		}
+	}
+	CU_ASSERT_EQUAL(count, 4);
+
+	/* The rest is executed by the target thread */
+	set_thread(0);
+	rc = spdk_thread_poll(thread0, 0, 0);
+	CU_ASSERT_EQUAL(rc, 1);
+	CU_ASSERT_EQUAL(g_stealable_msg_count, 0);
+	for (i = 0; i < 8; i++) {
+		CU_ASSERT(executed[i] == thread0 || executed[i] == thread1);
+	}
+	CU_ASSERT(spdk_thread_is_idle(thread0));
+
+	/* Nothing is left to steal */
+	set_thread(1);
+	rc = spdk_thread_poll(thread1, 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	free_threads();
+}
+
 static int
 poller_run_done(void *ctx)
 {
@@ -1041,6 +1192,8 @@ thread_update_stats_test(void)
 {
 	struct spdk_poller	*poller;
 	struct spdk_thread	*thread;
+	struct spdk_thread_burst_stats burst_stats;
+	bool			done = false;
 
 	MOCK_SET(spdk_get_ticks, 10);
 
@@ -1097,6 +1250,38 @@ thread_update_stats_test(void)
 
 	spdk_poller_unregister(&poller);
 
+	/* The busy run ends with the next idle iteration */
+	spdk_thread_collect_burst_stats(thread, &burst_stats);
+	CU_ASSERT(burst_stats.busy_runs == 0);
+	CU_ASSERT(burst_stats.busy_run_p99_tsc == 0);
+
+	spdk_thread_send_msg(thread, send_msg_cb, &done);
+	poller = spdk_poller_register(poller_run_idle, (void *)1000, 0);
+	CU_ASSERT(poller != NULL);
+	/* Executing the message makes the first iteration busy */
+	poll_thread_times(0, 1);
+	CU_ASSERT(done);
+	poll_thread_times(0, 1);
+	spdk_poller_unregister(&poller);
+
+	spdk_thread_collect_burst_stats(thread, &burst_stats);
+	CU_ASSERT(burst_stats.busy_runs == 1);
+	CU_ASSERT(burst_stats.busy_run_p99_tsc == 1ULL << (spdk_u64log2(200000) + 1));
+	CU_ASSERT(burst_stats.msg_count == 1);
+
+	/* Stats are reset once collected */
+	spdk_thread_collect_burst_stats(thread, &burst_stats);
+	CU_ASSERT(burst_stats.busy_runs == 0);
+	CU_ASSERT(burst_stats.msg_count == 0);
+
+	CU_ASSERT(spdk_thread_get_latency_class(thread) == SPDK_THREAD_LATENCY_CLASS_DEFAULT);
+	spdk_thread_set_latency_class(thread, SPDK_THREAD_LATENCY_CLASS_SENSITIVE);
+	CU_ASSERT(spdk_thread_get_latency_class(thread) == SPDK_THREAD_LATENCY_CLASS_SENSITIVE);
+
+	CU_ASSERT(spdk_thread_get_numa_affinity(thread) == SPDK_ENV_SOCKET_ID_ANY);
+	spdk_thread_set_numa_affinity(thread, 1);
+	CU_ASSERT(spdk_thread_get_numa_affinity(thread) == 1);
+
 	MOCK_CLEAR(spdk_get_ticks);
 
 	free_threads();
@@ -1638,6 +1823,219 @@ multi_timed_pollers_have_same_expiration(void)
 	free_threads();
 }
 
+#define UT_WHEEL_NUM_POLLERS 256
+
+struct ut_wheel_poller {
+	struct spdk_poller	*poller;
+	uint64_t		period;
+	uint64_t		next_run_tick;
+	uint64_t		run_count;
+	uint64_t		expected_count;
+	bool			unregistered;
+};
+
+static int
+ut_wheel_poller_fn(void *ctx)
+{
+	struct ut_wheel_poller *p = ctx;
+
+	/* The wheel must never run a poller ahead of its expiration */
+	CU_ASSERT(spdk_get_ticks() >= p->next_run_tick);
+	p->run_count++;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+timer_wheel(void)
+{
+	struct ut_wheel_poller pollers[UT_WHEEL_NUM_POLLERS] = {};
+	struct spdk_thread *thread;
+	struct spdk_poller *poller;
+	uint64_t now, next, expiration, delay;
+	int i, j, rc, count;
+
+	srand(1);
+
+	rc = spdk_thread_lib_enable_timer_wheel();
+	CU_ASSERT_EQUAL(rc, 0);
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+	SPDK_CU_ASSERT_FATAL(thread->timer_wheel != NULL);
+
+	rc = spdk_thread_lib_enable_timer_wheel();
+	CU_ASSERT_EQUAL(rc, -EBUSY);
+	CU_ASSERT_EQUAL(spdk_thread_next_poller_expiration(thread), 0);
+
+	/* Use periods spanning multiple levels of the wheel */
+	for (i = 0; i < UT_WHEEL_NUM_POLLERS; i++) {
+		pollers[i].period = 1 + rand() % (1 << (1 + i % 24));
+		pollers[i].next_run_tick = spdk_get_ticks() + pollers[i].period;
+		pollers[i].poller = spdk_poller_register(ut_wheel_poller_fn, &pollers[i],
+				    pollers[i].period);
+		SPDK_CU_ASSERT_FATAL(pollers[i].poller != NULL);
+	}
+
+	for (i = 0; i < 4000; i++) {
+		/* The expiration reported by the wheel can be early, but never late */
+		next = UINT64_MAX;
+		for (j = 0; j < UT_WHEEL_NUM_POLLERS; j++) {
+			if (!pollers[j].unregistered) {
+				next = spdk_min(next, pollers[j].next_run_tick);
+			}
+		}
+		expiration = spdk_thread_next_poller_expiration(thread);
+		CU_ASSERT(expiration != 0);
+		CU_ASSERT(expiration <= next);
+
+		switch (rand() % 4) {
+		case 0:
+			/* Jump right to the next expiration */
+			delay = next - spdk_get_ticks();
+			break;
+		case 1:
+			delay = rand() % (1 << (rand() % 26));
+			break;
+		default:
+			delay = rand() % 64;
+			break;
+		}
+		spdk_delay_us(delay);
+		now = spdk_get_ticks();
+
+		/* Unregister some of the pollers halfway through */
+		if (i == 2000) {
+			for (j = 0; j < UT_WHEEL_NUM_POLLERS; j += 3) {
+				spdk_poller_unregister(&pollers[j].poller);
+				pollers[j].unregistered = true;
+			}
+		}
+
+		spdk_thread_poll(thread, 0, 0);
+
+		for (j = 0; j < UT_WHEEL_NUM_POLLERS; j++) {
+			if (!pollers[j].unregistered && now >= pollers[j].next_run_tick) {
+				pollers[j].expected_count++;
+				pollers[j].next_run_tick = now + pollers[j].period;
+			}
+			CU_ASSERT_EQUAL(pollers[j].run_count, pollers[j].expected_count);
+		}
+	}
+
+	/* The unregistered pollers were removed from the wheel */
+	count = 0;
+	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_timed_poller(poller)) {
+		count++;
+	}
+	CU_ASSERT_EQUAL(count, UT_WHEEL_NUM_POLLERS - (UT_WHEEL_NUM_POLLERS + 2) / 3);
+
+	for (i = 0; i < UT_WHEEL_NUM_POLLERS; i++) {
+		spdk_poller_unregister(&pollers[i].poller);
+	}
+
+	free_threads();
+}
+
+static uint64_t g_poller_run_us;
+
+static int
+poller_run_for(void *ctx)
+{
+	spdk_delay_us(g_poller_run_us);
+
+	return 1;
+}
+
+static uint64_t
+ut_histogram_count(const struct spdk_histogram_data *histogram, uint64_t datapoint)
+{
+	struct spdk_histogram_data *h = (struct spdk_histogram_data *)histogram;
+	uint32_t range, index;
+
+	range = __spdk_histogram_data_get_bucket_range(h, datapoint);
+	index = __spdk_histogram_data_get_bucket_index(h, datapoint, range);
+
+	return __spdk_histogram_get_count(histogram, range, index);
+}
+
+static void
+poller_timing(void)
+{
+	const struct spdk_histogram_data *histogram;
+	struct spdk_poller_stats stats;
+	struct spdk_poller *poller, *timed_poller;
+	uint64_t run_us[] = { 10, 100, 20 };
+	size_t i;
+
+	allocate_threads(1);
+	set_thread(0);
+
+	poller = spdk_poller_register(poller_run_for, NULL, 0);
+	SPDK_CU_ASSERT_FATAL(poller != NULL);
+
+	/* The execution time isn't measured by default */
+	g_poller_run_us = 10;
+	poll_thread_times(0, 1);
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT_EQUAL(stats.run_count, 1);
+	CU_ASSERT_EQUAL(stats.max_run_tsc, 0);
+	CU_ASSERT_PTR_NULL(spdk_poller_get_histogram(poller));
+
+	/* A tick is a microsecond in the unit tests */
+	spdk_thread_lib_enable_poller_histograms(true);
+	spdk_thread_lib_set_poller_watchdog(50);
+
+	for (i = 0; i < SPDK_COUNTOF(run_us); i++) {
+		g_poller_run_us = run_us[i];
+		poll_thread_times(0, 1);
+	}
+
+	spdk_poller_get_stats(poller, &stats);
+	CU_ASSERT_EQUAL(stats.run_count, 4);
+	CU_ASSERT_EQUAL(stats.max_run_tsc, 100);
+	CU_ASSERT_EQUAL(stats.slow_run_count, 1);
+	histogram = spdk_poller_get_histogram(poller);
+	SPDK_CU_ASSERT_FATAL(histogram != NULL);
+	for (i = 0; i < SPDK_COUNTOF(run_us); i++) {
+		CU_ASSERT_EQUAL(ut_histogram_count(histogram, run_us[i]), 1);
+	}
+
+	/* Timed pollers are measured too */
+	timed_poller = spdk_poller_register(poller_run_for, NULL, 1000);
+	SPDK_CU_ASSERT_FATAL(timed_poller != NULL);
+	spdk_poller_unregister(&poller);
+	g_poller_run_us = 60;
+	spdk_delay_us(1000);
+	poll_thread_times(0, 1);
+
+	spdk_poller_get_stats(timed_poller, &stats);
+	CU_ASSERT_EQUAL(stats.run_count, 1);
+	CU_ASSERT_EQUAL(stats.max_run_tsc, 60);
+	CU_ASSERT_EQUAL(stats.slow_run_count, 1);
+	histogram = spdk_poller_get_histogram(timed_poller);
+	SPDK_CU_ASSERT_FATAL(histogram != NULL);
+	CU_ASSERT_EQUAL(ut_histogram_count(histogram, 60), 1);
+
+	/* Nothing is updated once disabled, but the collected data is kept */
+	spdk_thread_lib_enable_poller_histograms(false);
+	spdk_thread_lib_set_poller_watchdog(0);
+	g_poller_run_us = 200;
+	spdk_delay_us(1000);
+	poll_thread_times(0, 1);
+
+	spdk_poller_get_stats(timed_poller, &stats);
+	CU_ASSERT_EQUAL(stats.run_count, 2);
+	CU_ASSERT_EQUAL(stats.max_run_tsc, 60);
+	CU_ASSERT_EQUAL(stats.slow_run_count, 1);
+	CU_ASSERT_EQUAL(ut_histogram_count(histogram, 60), 1);
+	CU_ASSERT_EQUAL(ut_histogram_count(histogram, 200), 0);
+
+	spdk_poller_unregister(&timed_poller);
+	free_threads();
+}
+
 static int
 dummy_create_cb(void *io_device, void *ctx_buf)
 {
@@ -1925,6 +2323,8 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, thread_alloc);
 	CU_ADD_TEST(suite, thread_send_msg);
+	CU_ADD_TEST(suite, thread_send_msg_embedded);
+	CU_ADD_TEST(suite, thread_send_stealable_msg);
 	CU_ADD_TEST(suite, thread_poller);
 	CU_ADD_TEST(suite, poller_pause);
 	CU_ADD_TEST(suite, thread_for_each);
@@ -1939,6 +2339,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, device_unregister_and_thread_exit_race);
 	CU_ADD_TEST(suite, cache_closest_timed_poller);
 	CU_ADD_TEST(suite, multi_timed_pollers_have_same_expiration);
+	CU_ADD_TEST(suite, timer_wheel);
+	CU_ADD_TEST(suite, poller_timing);
 	CU_ADD_TEST(suite, io_device_lookup);
 	CU_ADD_TEST(suite, spdk_spin);
 
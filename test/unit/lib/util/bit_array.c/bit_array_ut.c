@@ -317,6 +317,85 @@ test_mask_clear(void)
 	spdk_bit_array_free(&ba);
 }
 
+static uint32_t
+ref_find_first_clear_range(const bool *ref, uint32_t num_bits, uint32_t start, uint32_t count)
+{
+	uint32_t i, run = 0;
+
+	for (i = start; i < num_bits; i++) {
+		run = ref[i] ? 0 : run + 1;
+		if (run == count) {
+			return i - count + 1;
+		}
+	}
+
+	return UINT32_MAX;
+}
+
+static void
+test_range(void)
+{
+	struct spdk_bit_array *ba;
+	bool ref[64 * 70 + 13];
+	uint32_t num_bits = SPDK_COUNTOF(ref);
+	uint32_t i, j, start, count;
+
+	ba = spdk_bit_array_create(num_bits);
+	SPDK_CU_ASSERT_FATAL(ba != NULL);
+	memset(ref, 0, sizeof(ref));
+
+	/* Out of range */
+	CU_ASSERT(spdk_bit_array_set_range(ba, num_bits - 1, 2) == -EINVAL);
+	CU_ASSERT(spdk_bit_array_set_range(ba, num_bits + 1, 0) == -EINVAL);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 0) == UINT32_MAX);
+	spdk_bit_array_clear_range(ba, num_bits, 10);
+	CU_ASSERT(spdk_bit_array_find_first_clear_range(ba, 0, 0) == UINT32_MAX);
+	CU_ASSERT(spdk_bit_array_find_first_clear_range(ba, 0, num_bits) == 0);
+	CU_ASSERT(spdk_bit_array_find_first_clear_range(ba, 1, num_bits) == UINT32_MAX);
+
+	/* Whole array */
+	CU_ASSERT(spdk_bit_array_set_range(ba, 0, num_bits) == 0);
+	CU_ASSERT(spdk_bit_array_count_set(ba) == num_bits);
+	CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == UINT32_MAX);
+	spdk_bit_array_clear_range(ba, 0, UINT32_MAX);
+	CU_ASSERT(spdk_bit_array_count_set(ba) == 0);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 0) == UINT32_MAX);
+
+	/* Random ranges, checked against a reference array */
+	srand(0);
+	for (i = 0; i < 2000; i++) {
+		start = rand() % num_bits;
+		count = rand() % 4 == 0 ? rand() % (num_bits - start + 1) : (uint32_t)rand() % 130;
+		count = spdk_min(count, num_bits - start);
+
+		if (rand() % 2) {
+			CU_ASSERT(spdk_bit_array_set_range(ba, start, count) == 0);
+			memset(&ref[start], 1, count);
+		} else {
+			spdk_bit_array_clear_range(ba, start, count);
+			memset(&ref[start], 0, count);
+		}
+
+		start = rand() % num_bits;
+		count = rand() % 200 + 1;
+		CU_ASSERT(spdk_bit_array_find_first_clear_range(ba, start, count) ==
+			  ref_find_first_clear_range(ref, num_bits, start, count));
+
+		for (j = start; j < num_bits && ref[j]; j++) {}
+		j = j < num_bits ? j : UINT32_MAX;
+		CU_ASSERT(spdk_bit_array_find_first_clear(ba, start) == j);
+		for (j = start; j < num_bits && !ref[j]; j++) {}
+		j = j < num_bits ? j : UINT32_MAX;
+		CU_ASSERT(spdk_bit_array_find_first_set(ba, start) == j);
+	}
+
+	for (i = 0; i < num_bits; i++) {
+		CU_ASSERT(spdk_bit_array_get(ba, i) == ref[i]);
+	}
+
+	spdk_bit_array_free(&ba);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -335,6 +414,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_count);
 	CU_ADD_TEST(suite, test_mask_store_load);
 	CU_ADD_TEST(suite, test_mask_clear);
+	CU_ADD_TEST(suite, test_range);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
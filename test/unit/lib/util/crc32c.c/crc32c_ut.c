@@ -164,6 +164,36 @@ test_crc32c_nvme(void)
 	CU_ASSERT(crc == 0x214941A8);
 }
 
+static void
+test_crc32c_update_multi(void)
+{
+	/* Mix of lengths around the 8-byte word size and unaligned buffer offsets */
+	size_t lens[] = { 0, 1, 7, 8, 9, 63, 512, 4096, 4095, 17, 4 };
+	uint32_t crcs[SPDK_COUNTOF(lens)], expected[SPDK_COUNTOF(lens)];
+	const void *bufs[SPDK_COUNTOF(lens)];
+	uint8_t data[8192 + 64];
+	size_t i;
+	int count;
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)(i * 7 + 3);
+	}
+
+	/* Check every number of buffers, so that both full and partial groups of lanes are used */
+	for (count = 0; count <= (int)SPDK_COUNTOF(lens); count++) {
+		for (i = 0; i < (size_t)count; i++) {
+			bufs[i] = &data[i * 3];
+			crcs[i] = 0xFFFFFFFFu - (uint32_t)i;
+			expected[i] = spdk_crc32c_update(bufs[i], lens[i], crcs[i]);
+		}
+
+		spdk_crc32c_update_multi(bufs, lens, crcs, count);
+		for (i = 0; i < (size_t)count; i++) {
+			CU_ASSERT_EQUAL(crcs[i], expected[i]);
+		}
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -176,6 +206,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_crc32c);
 	CU_ADD_TEST(suite, test_crc32c_nvme);
+	CU_ADD_TEST(suite, test_crc32c_update_multi);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
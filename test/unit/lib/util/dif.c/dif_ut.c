@@ -4032,6 +4032,247 @@ dix_sec_4096_md_128_prchk_7_multi_iovs_complex_splits_remap_test(void)
 	_iov_free_buf(&md_iov);
 }
 
+/* Blocks of the iovecs used by the batch tests. The iovecs hold whole blocks, so the block
+ * aligned path is used, and their sizes make the batches stop at the iovec boundaries, at
+ * DIF_BATCH_BLOCKS and at the end of the request.
+ */
+static const uint32_t g_batch_iov_blocks[] = { 1, 17, 5, 20 };
+#define BATCH_NUM_BLOCKS	43
+#define BATCH_NUM_IOVS		SPDK_COUNTOF(g_batch_iov_blocks)
+
+static const uint32_t g_batch_inject_flags[] = {
+	SPDK_DIF_GUARD_ERROR, SPDK_DIF_APPTAG_ERROR, SPDK_DIF_REFTAG_ERROR, SPDK_DIF_DATA_ERROR,
+};
+
+static void
+_batch_set_aligned_iovs(struct iovec *iovs, uint8_t *buf, uint32_t block_size)
+{
+	uint32_t i;
+
+	for (i = 0; i < BATCH_NUM_IOVS; i++) {
+		_iov_set_buf(&iovs[i], buf, g_batch_iov_blocks[i] * block_size);
+		buf += g_batch_iov_blocks[i] * block_size;
+	}
+}
+
+/* Describe the same buffer with iovecs splitting a block in its data and another one in
+ * its metadata, which makes the whole request use the split path.
+ */
+static void
+_batch_set_split_iovs(struct iovec *iovs, uint8_t *buf, uint32_t block_size,
+		      uint32_t md_size)
+{
+	uint32_t len0, len1;
+
+	len0 = 10 * block_size + 100;
+	len1 = 30 * block_size + block_size - md_size / 2 - len0;
+
+	_iov_set_buf(&iovs[0], buf, len0);
+	_iov_set_buf(&iovs[1], buf + len0, len1);
+	_iov_set_buf(&iovs[2], buf + len0 + len1, BATCH_NUM_BLOCKS * block_size - len0 - len1);
+}
+
+static void
+_dif_batch_generate_and_verify(enum spdk_dif_type dif_type, enum spdk_dif_pi_format dif_pi_format,
+			       bool dif_loc)
+{
+	struct spdk_dif_ctx ctx = {};
+	struct spdk_dif_ctx_init_ext_opts dif_opts;
+	struct spdk_dif_error err_blk = {}, split_err_blk = {};
+	struct iovec aligned_iovs[BATCH_NUM_IOVS], split_iovs[3];
+	uint32_t block_size = 4096 + 128, md_size = 128, dif_flags, inject_offset, len, i;
+	uint8_t *buf, *expected;
+	int rc;
+
+	dif_flags = SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK;
+	if (dif_type != SPDK_DIF_TYPE3) {
+		dif_flags |= SPDK_DIF_FLAGS_REFTAG_CHECK;
+	}
+	len = BATCH_NUM_BLOCKS * block_size;
+
+	buf = calloc(1, len);
+	expected = calloc(1, len);
+	SPDK_CU_ASSERT_FATAL(buf != NULL && expected != NULL);
+
+	_batch_set_aligned_iovs(aligned_iovs, buf, block_size);
+	_batch_set_split_iovs(split_iovs, buf, block_size, md_size);
+
+	dif_opts.size = SPDK_SIZEOF(&dif_opts, dif_pi_format);
+	dif_opts.dif_pi_format = dif_pi_format;
+	rc = spdk_dif_ctx_init(&ctx, block_size, md_size, true, dif_loc, dif_type, dif_flags,
+			       22, 0xFFFF, 0x22, 0, GUARD_SEED, &dif_opts);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	/* The split path generates the reference image block by block. */
+	rc = ut_data_pattern_generate(split_iovs, 3, block_size, md_size, BATCH_NUM_BLOCKS);
+	CU_ASSERT(rc == 0);
+	rc = spdk_dif_generate(split_iovs, 3, BATCH_NUM_BLOCKS, &ctx);
+	CU_ASSERT(rc == 0);
+	memcpy(expected, buf, len);
+
+	/* Batches generate the same DIFs. */
+	rc = ut_data_pattern_generate(aligned_iovs, BATCH_NUM_IOVS, block_size, md_size,
+				      BATCH_NUM_BLOCKS);
+	CU_ASSERT(rc == 0);
+	rc = spdk_dif_generate(aligned_iovs, BATCH_NUM_IOVS, BATCH_NUM_BLOCKS, &ctx);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(memcmp(buf, expected, len) == 0);
+
+	rc = spdk_dif_verify(aligned_iovs, BATCH_NUM_IOVS, BATCH_NUM_BLOCKS, &ctx, &err_blk);
+	CU_ASSERT(rc == 0);
+	rc = spdk_dif_verify(split_iovs, 3, BATCH_NUM_BLOCKS, &ctx, &err_blk);
+	CU_ASSERT(rc == 0);
+
+	/* A corrupted block is reported the same way by both paths. */
+	for (i = 0; i < SPDK_COUNTOF(g_batch_inject_flags); i++) {
+		/* The Reference Tag is not checked for type 3. */
+		if (g_batch_inject_flags[i] == SPDK_DIF_REFTAG_ERROR &&
+		    dif_type == SPDK_DIF_TYPE3) {
+			continue;
+		}
+
+		memcpy(buf, expected, len);
+		rc = spdk_dif_inject_error(aligned_iovs, BATCH_NUM_IOVS, BATCH_NUM_BLOCKS, &ctx,
+					   g_batch_inject_flags[i], &inject_offset);
+		CU_ASSERT(rc == 0);
+
+		rc = spdk_dif_verify(aligned_iovs, BATCH_NUM_IOVS, BATCH_NUM_BLOCKS, &ctx,
+				     &err_blk);
+		CU_ASSERT(rc != 0);
+		CU_ASSERT(err_blk.err_offset == inject_offset);
+		rc = spdk_dif_verify(split_iovs, 3, BATCH_NUM_BLOCKS, &ctx, &split_err_blk);
+		CU_ASSERT(rc != 0);
+		CU_ASSERT(memcmp(&err_blk, &split_err_blk, sizeof(err_blk)) == 0);
+	}
+
+	free(buf);
+	free(expected);
+}
+
+static void
+_dif_batch_copy_generate_and_verify(enum spdk_dif_type dif_type,
+				    enum spdk_dif_pi_format dif_pi_format, bool dif_loc)
+{
+	struct spdk_dif_ctx ctx = {};
+	struct spdk_dif_ctx_init_ext_opts dif_opts;
+	struct spdk_dif_error err_blk = {}, split_err_blk = {};
+	struct iovec aligned_iovs[BATCH_NUM_IOVS], split_iovs[3], bounce_iovs[BATCH_NUM_IOVS];
+	uint32_t block_size = 4096 + 128, md_size = 128, data_block_size = 4096;
+	uint32_t dif_flags, inject_offset, len, i;
+	uint8_t *buf, *bounce, *expected;
+	int rc;
+
+	dif_flags = SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK;
+	if (dif_type != SPDK_DIF_TYPE3) {
+		dif_flags |= SPDK_DIF_FLAGS_REFTAG_CHECK;
+	}
+	len = BATCH_NUM_BLOCKS * block_size;
+
+	buf = calloc(1, BATCH_NUM_BLOCKS * data_block_size);
+	bounce = calloc(1, len);
+	expected = calloc(1, len);
+	SPDK_CU_ASSERT_FATAL(buf != NULL && bounce != NULL && expected != NULL);
+
+	_batch_set_aligned_iovs(aligned_iovs, buf, data_block_size);
+	_batch_set_split_iovs(split_iovs, buf, data_block_size, 0);
+	/* The bounce buffer always holds whole blocks, batches are bounded by both sides. */
+	_iov_set_buf(&bounce_iovs[0], bounce, 3 * block_size);
+	_iov_set_buf(&bounce_iovs[1], bounce + 3 * block_size, 30 * block_size);
+	_iov_set_buf(&bounce_iovs[2], bounce + 33 * block_size, 10 * block_size);
+
+	dif_opts.size = SPDK_SIZEOF(&dif_opts, dif_pi_format);
+	dif_opts.dif_pi_format = dif_pi_format;
+	rc = spdk_dif_ctx_init(&ctx, block_size, md_size, true, dif_loc, dif_type, dif_flags,
+			       22, 0xFFFF, 0x22, 0, GUARD_SEED, &dif_opts);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	rc = ut_data_pattern_generate(aligned_iovs, BATCH_NUM_IOVS, data_block_size, 0,
+				      BATCH_NUM_BLOCKS);
+	CU_ASSERT(rc == 0);
+
+	rc = spdk_dif_generate_copy(split_iovs, 3, bounce_iovs, 3, BATCH_NUM_BLOCKS, &ctx);
+	CU_ASSERT(rc == 0);
+	memcpy(expected, bounce, len);
+
+	memset(bounce, 0, len);
+	rc = spdk_dif_generate_copy(aligned_iovs, BATCH_NUM_IOVS, bounce_iovs, 3,
+				    BATCH_NUM_BLOCKS, &ctx);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(memcmp(bounce, expected, len) == 0);
+
+	memset(buf, 0, BATCH_NUM_BLOCKS * data_block_size);
+	rc = spdk_dif_verify_copy(aligned_iovs, BATCH_NUM_IOVS, bounce_iovs, 3, BATCH_NUM_BLOCKS,
+				  &ctx, &err_blk);
+	CU_ASSERT(rc == 0);
+	rc = ut_data_pattern_verify(aligned_iovs, BATCH_NUM_IOVS, data_block_size, 0,
+				    BATCH_NUM_BLOCKS);
+	CU_ASSERT(rc == 0);
+
+	memset(buf, 0, BATCH_NUM_BLOCKS * data_block_size);
+	rc = spdk_dif_verify_copy(split_iovs, 3, bounce_iovs, 3, BATCH_NUM_BLOCKS, &ctx,
+				  &err_blk);
+	CU_ASSERT(rc == 0);
+	rc = ut_data_pattern_verify(aligned_iovs, BATCH_NUM_IOVS, data_block_size, 0,
+				    BATCH_NUM_BLOCKS);
+	CU_ASSERT(rc == 0);
+
+	for (i = 0; i < SPDK_COUNTOF(g_batch_inject_flags); i++) {
+		/* The Reference Tag is not checked for type 3. */
+		if (g_batch_inject_flags[i] == SPDK_DIF_REFTAG_ERROR &&
+		    dif_type == SPDK_DIF_TYPE3) {
+			continue;
+		}
+
+		memcpy(bounce, expected, len);
+		rc = spdk_dif_inject_error(bounce_iovs, 3, BATCH_NUM_BLOCKS, &ctx,
+					   g_batch_inject_flags[i], &inject_offset);
+		CU_ASSERT(rc == 0);
+
+		rc = spdk_dif_verify_copy(aligned_iovs, BATCH_NUM_IOVS, bounce_iovs, 3,
+					  BATCH_NUM_BLOCKS, &ctx, &err_blk);
+		CU_ASSERT(rc != 0);
+		CU_ASSERT(err_blk.err_offset == inject_offset);
+		rc = spdk_dif_verify_copy(split_iovs, 3, bounce_iovs, 3, BATCH_NUM_BLOCKS, &ctx,
+					  &split_err_blk);
+		CU_ASSERT(rc != 0);
+		CU_ASSERT(memcmp(&err_blk, &split_err_blk, sizeof(err_blk)) == 0);
+	}
+
+	free(buf);
+	free(bounce);
+	free(expected);
+}
+
+static void
+dif_batch_generate_and_verify_test(void)
+{
+	enum spdk_dif_type dif_type;
+	enum spdk_dif_pi_format dif_pi_format;
+
+	for (dif_type = SPDK_DIF_TYPE1; dif_type <= SPDK_DIF_TYPE3; dif_type++) {
+		for (dif_pi_format = SPDK_DIF_PI_FORMAT_16; dif_pi_format <= SPDK_DIF_PI_FORMAT_64;
+		     dif_pi_format++) {
+			_dif_batch_generate_and_verify(dif_type, dif_pi_format, false);
+			_dif_batch_generate_and_verify(dif_type, dif_pi_format, true);
+		}
+	}
+}
+
+static void
+dif_batch_copy_generate_and_verify_test(void)
+{
+	enum spdk_dif_type dif_type;
+	enum spdk_dif_pi_format dif_pi_format;
+
+	for (dif_type = SPDK_DIF_TYPE1; dif_type <= SPDK_DIF_TYPE3; dif_type++) {
+		for (dif_pi_format = SPDK_DIF_PI_FORMAT_16; dif_pi_format <= SPDK_DIF_PI_FORMAT_64;
+		     dif_pi_format++) {
+			_dif_batch_copy_generate_and_verify(dif_type, dif_pi_format, false);
+			_dif_batch_copy_generate_and_verify(dif_type, dif_pi_format, true);
+		}
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -4120,6 +4361,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, dix_sec_4096_md_128_prchk_7_multi_iovs_remap);
 	CU_ADD_TEST(suite, dix_sec_512_md_8_prchk_7_multi_iovs_complex_splits_remap_pi_16_test);
 	CU_ADD_TEST(suite, dix_sec_4096_md_128_prchk_7_multi_iovs_complex_splits_remap_test);
+	CU_ADD_TEST(suite, dif_batch_generate_and_verify_test);
+	CU_ADD_TEST(suite, dif_batch_copy_generate_and_verify_test);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
@@ -0,0 +1,265 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_internal/cunit.h"
+
+#include "util/workload.c"
+
+#define UT_RANGE	1000
+#define UT_NUM_IO	10000
+
+static struct spdk_workload_opts g_opts = {
+	.range = UT_RANGE,
+	.unit_size = 4096,
+	.read_percentage = 50,
+	.seed = 1,
+};
+
+static void
+test_create_invalid(void)
+{
+	struct spdk_workload_opts opts = g_opts;
+	struct spdk_workload *workload;
+	const char *invalid[] = {
+		"", "random", "uniform:1", "seq:101", "zipf", "zipf:0", "zipf:1", "zipf:x",
+		"pareto:0", "pareto:1", "hotcold:0/90", "hotcold:100/90", "hotcold:10", "hotcold:10/101",
+		"uniform,rw=50-10:100", "uniform,rw=0-101:100", "uniform,rw=0-50", "uniform,bs=8",
+		"replay:/nonexistent/trace",
+	};
+	size_t i;
+
+	for (i = 0; i < SPDK_COUNTOF(invalid); i++) {
+		workload = spdk_workload_create(invalid[i], &opts);
+		CU_ASSERT(workload == NULL);
+	}
+
+	opts.range = 0;
+	workload = spdk_workload_create("uniform", &opts);
+	CU_ASSERT(workload == NULL);
+
+	opts = g_opts;
+	opts.read_percentage = 101;
+	workload = spdk_workload_create("uniform", &opts);
+	CU_ASSERT(workload == NULL);
+}
+
+static void
+test_distributions(void)
+{
+	const char *valid[] = {
+		"uniform", "seq", "seq:10", "zipf:1.2", "pareto:0.2", "hotcold:10/90",
+	};
+	struct spdk_workload *workload;
+	struct spdk_workload_io io;
+	size_t i, j;
+
+	for (i = 0; i < SPDK_COUNTOF(valid); i++) {
+		workload = spdk_workload_create(valid[i], &g_opts);
+		SPDK_CU_ASSERT_FATAL(workload != NULL);
+
+		for (j = 0; j < UT_NUM_IO; j++) {
+			spdk_workload_next(workload, &io);
+			CU_ASSERT(io.offset < UT_RANGE);
+			CU_ASSERT(io.size == 1);
+		}
+
+		spdk_workload_free(&workload);
+		CU_ASSERT(workload == NULL);
+	}
+}
+
+static void
+test_seq(void)
+{
+	struct spdk_workload *workload;
+	struct spdk_workload_io io;
+	size_t i;
+
+	workload = spdk_workload_create("seq", &g_opts);
+	SPDK_CU_ASSERT_FATAL(workload != NULL);
+
+	/* Offsets wrap around at the end of the range */
+	for (i = 0; i < UT_RANGE * 2; i++) {
+		spdk_workload_next(workload, &io);
+		CU_ASSERT(io.offset == i % UT_RANGE);
+	}
+
+	spdk_workload_free(&workload);
+}
+
+static void
+test_hotcold(void)
+{
+	struct spdk_workload *workload;
+	struct spdk_workload_io io;
+	uint32_t hot = 0;
+	size_t i;
+
+	workload = spdk_workload_create("hotcold:10/90", &g_opts);
+	SPDK_CU_ASSERT_FATAL(workload != NULL);
+
+	for (i = 0; i < UT_NUM_IO; i++) {
+		spdk_workload_next(workload, &io);
+		if (io.offset < UT_RANGE / 10) {
+			hot++;
+		}
+	}
+	CU_ASSERT(hot > UT_NUM_IO * 85 / 100 && hot < UT_NUM_IO * 95 / 100);
+
+	spdk_workload_free(&workload);
+
+	/* 20% of the range receives 80% of the accesses */
+	workload = spdk_workload_create("pareto:0.2", &g_opts);
+	SPDK_CU_ASSERT_FATAL(workload != NULL);
+
+	hot = 0;
+	for (i = 0; i < UT_NUM_IO; i++) {
+		spdk_workload_next(workload, &io);
+		if (io.offset < UT_RANGE / 5) {
+			hot++;
+		}
+	}
+	CU_ASSERT(hot > UT_NUM_IO * 75 / 100 && hot < UT_NUM_IO * 85 / 100);
+
+	spdk_workload_free(&workload);
+}
+
+static void
+test_regions(void)
+{
+	struct spdk_workload_opts opts = g_opts;
+	struct spdk_workload *workload;
+	struct spdk_workload_io io;
+	uint32_t reads = 0;
+	size_t i;
+
+	/* The first half is only read, the second half only written, the rest uses the default */
+	opts.read_percentage = 50;
+	workload = spdk_workload_create("uniform,rw=0-50:100,rw=50-90:0", &opts);
+	SPDK_CU_ASSERT_FATAL(workload != NULL);
+
+	for (i = 0; i < UT_NUM_IO; i++) {
+		spdk_workload_next(workload, &io);
+		if (io.offset < UT_RANGE / 2) {
+			CU_ASSERT(io.is_read);
+		} else if (io.offset < UT_RANGE * 9 / 10) {
+			CU_ASSERT(!io.is_read);
+		} else if (io.is_read) {
+			reads++;
+		}
+	}
+	CU_ASSERT(reads > 0);
+
+	spdk_workload_free(&workload);
+}
+
+static void
+test_sizes(void)
+{
+	struct spdk_workload *workload;
+	struct spdk_workload_io io;
+	uint32_t count[3] = {};
+	size_t i;
+	int rc;
+
+	workload = spdk_workload_create("seq", &g_opts);
+	SPDK_CU_ASSERT_FATAL(workload != NULL);
+
+	CU_ASSERT(spdk_workload_add_size(workload, 0, 1) == -EINVAL);
+	CU_ASSERT(spdk_workload_add_size(workload, 1, 0) == -EINVAL);
+	CU_ASSERT(spdk_workload_add_size(workload, UT_RANGE + 1, 1) == -EINVAL);
+
+	rc = spdk_workload_add_size(workload, 1, 1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_workload_add_size(workload, 8, 3);
+	CU_ASSERT(rc == 0);
+
+	for (i = 0; i < UT_NUM_IO; i++) {
+		spdk_workload_next(workload, &io);
+		CU_ASSERT(io.offset + io.size <= UT_RANGE);
+		if (io.size == 1) {
+			count[0]++;
+		} else if (io.size == 8) {
+			count[1]++;
+		} else {
+			count[2]++;
+		}
+	}
+	CU_ASSERT(count[2] == 0);
+	CU_ASSERT(count[1] > count[0] * 2 && count[1] < count[0] * 4);
+
+	spdk_workload_free(&workload);
+}
+
+static void
+test_replay(void)
+{
+	struct spdk_workload_opts opts = g_opts;
+	struct spdk_workload *workload;
+	struct spdk_workload_io io;
+	char path[] = "/tmp/workload_ut_XXXXXX";
+	char spec[64];
+	FILE *file;
+	int fd;
+
+	fd = mkstemp(path);
+	SPDK_CU_ASSERT_FATAL(fd >= 0);
+	file = fdopen(fd, "w");
+	SPDK_CU_ASSERT_FATAL(file != NULL);
+	fprintf(file, "R 8 8\n");
+	fprintf(file, "D 0 8\n");
+	fprintf(file, "garbage\n");
+	fprintf(file, "WS 16 16\n");
+	/* Beyond the range, wraps around */
+	fprintf(file, "R %u 1\n", UT_RANGE * 8 + 24);
+	fclose(file);
+
+	/* The directions of the trace take precedence over the read percentage */
+	opts.read_percentage = 0;
+	snprintf(spec, sizeof(spec), "replay:%s", path);
+	workload = spdk_workload_create(spec, &opts);
+	SPDK_CU_ASSERT_FATAL(workload != NULL);
+	CU_ASSERT(workload->num_records == 3);
+
+	spdk_workload_next(workload, &io);
+	CU_ASSERT(io.offset == 1 && io.size == 1 && io.is_read);
+	spdk_workload_next(workload, &io);
+	CU_ASSERT(io.offset == 2 && io.size == 2 && !io.is_read);
+	spdk_workload_next(workload, &io);
+	CU_ASSERT(io.offset == 3 && io.size == 1 && io.is_read);
+	/* The trace is replayed in a loop */
+	spdk_workload_next(workload, &io);
+	CU_ASSERT(io.offset == 1 && io.size == 1 && io.is_read);
+
+	spdk_workload_free(&workload);
+	unlink(path);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("workload", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_create_invalid);
+	CU_ADD_TEST(suite, test_distributions);
+	CU_ADD_TEST(suite, test_seq);
+	CU_ADD_TEST(suite, test_hotcold);
+	CU_ADD_TEST(suite, test_regions);
+	CU_ADD_TEST(suite, test_sizes);
+	CU_ADD_TEST(suite, test_replay);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -97,6 +97,127 @@ test_xor_gen(void)
 	free(ref);
 }
 
+static uint8_t
+ref_gf_mul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1) {
+			r ^= a;
+		}
+		a = (a << 1) ^ ((a & 0x80) ? 0x1d : 0);
+		b >>= 1;
+	}
+
+	return r;
+}
+
+static void
+test_xor_gen_pq(void)
+{
+	void *bufs[BUF_COUNT + 2];
+	void *bufs2[BUF_COUNT + 2];
+	uint8_t *ref_p, *ref_q, *saved[BUF_COUNT + 2];
+	uint8_t coef;
+	uint32_t n = BUF_COUNT, x, y;
+	int ret;
+	size_t i, j;
+
+	for (i = 0; i < n + 2; i++) {
+		ret = posix_memalign(&bufs[i], spdk_xor_get_optimal_alignment(), BUF_SIZE);
+		SPDK_CU_ASSERT_FATAL(ret == 0);
+		saved[i] = malloc(BUF_SIZE);
+		SPDK_CU_ASSERT_FATAL(saved[i] != NULL);
+
+		for (j = 0; j < BUF_SIZE; j++) {
+			((uint8_t *)bufs[i])[j] = rand();
+		}
+	}
+
+	/* prepare the reference buffers */
+	ref_p = calloc(1, BUF_SIZE);
+	ref_q = calloc(1, BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(ref_p != NULL && ref_q != NULL);
+
+	for (i = 0, coef = 1; i < n; i++, coef = ref_gf_mul(coef, 2)) {
+		for (j = 0; j < BUF_SIZE; j++) {
+			ref_p[j] ^= ((uint8_t *)bufs[i])[j];
+			ref_q[j] ^= ref_gf_mul(coef, ((uint8_t *)bufs[i])[j]);
+		}
+	}
+
+	/* generate P and Q, compare with the reference buffers */
+	ret = spdk_xor_gen_pq(bufs[n], bufs[n + 1], bufs, n, BUF_SIZE);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(memcmp(ref_p, bufs[n], BUF_SIZE) == 0);
+	CU_ASSERT(memcmp(ref_q, bufs[n + 1], BUF_SIZE) == 0);
+
+	/* unaligned buffers and len */
+	memcpy(bufs2, bufs, sizeof(bufs2));
+	bufs2[1] += 1;
+	memset(bufs[n], 0xba, BUF_SIZE);
+	memset(bufs[n + 1], 0xba, BUF_SIZE);
+	ret = spdk_xor_gen_pq(bufs[n], bufs[n + 1], bufs2, n, BUF_SIZE - 1);
+	CU_ASSERT(ret == 0);
+	ret = spdk_xor_gen_pq(ref_p, ref_q, bufs2, n, BUF_SIZE - 1);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(memcmp(ref_p, bufs[n], BUF_SIZE - 1) == 0);
+	CU_ASSERT(memcmp(ref_q, bufs[n + 1], BUF_SIZE - 1) == 0);
+
+	/* invalid number of sources */
+	ret = spdk_xor_gen_pq(bufs[n], bufs[n + 1], bufs, 1, BUF_SIZE);
+	CU_ASSERT(ret == -EINVAL);
+
+	ret = spdk_xor_gen_pq(bufs[n], bufs[n + 1], bufs, n, BUF_SIZE);
+	CU_ASSERT(ret == 0);
+	for (i = 0; i < n + 2; i++) {
+		memcpy(saved[i], bufs[i], BUF_SIZE);
+	}
+
+	/* recover every combination of lost buffers */
+	for (x = 0; x < n + 2; x++) {
+		for (y = x + 1; y < n + 2; y++) {
+			memset(bufs[x], 0xba, BUF_SIZE);
+			memset(bufs[y], 0xba, BUF_SIZE);
+
+			ret = spdk_xor_recover_pq(bufs, n, x, y, BUF_SIZE);
+			CU_ASSERT(ret == 0);
+			CU_ASSERT(memcmp(saved[x], bufs[x], BUF_SIZE) == 0);
+			CU_ASSERT(memcmp(saved[y], bufs[y], BUF_SIZE) == 0);
+		}
+	}
+
+	/* len not multiple of the vector size */
+	for (x = 0; x < n; x++) {
+		y = x + 1;
+		memset(bufs[x], 0xba, BUF_SIZE);
+		memset(bufs[y], 0xba, BUF_SIZE);
+
+		ret = spdk_xor_recover_pq(bufs, n, x, y, BUF_SIZE - 1);
+		CU_ASSERT(ret == 0);
+		CU_ASSERT(memcmp(saved[x], bufs[x], BUF_SIZE - 1) == 0);
+		CU_ASSERT(memcmp(saved[y], bufs[y], BUF_SIZE - 1) == 0);
+
+		memcpy(bufs[x], saved[x], BUF_SIZE);
+		memcpy(bufs[y], saved[y], BUF_SIZE);
+	}
+
+	/* invalid lost buffer indexes */
+	ret = spdk_xor_recover_pq(bufs, n, 1, 1, BUF_SIZE);
+	CU_ASSERT(ret == -EINVAL);
+	ret = spdk_xor_recover_pq(bufs, n, 1, n + 2, BUF_SIZE);
+	CU_ASSERT(ret == -EINVAL);
+
+	/* cleanup */
+	for (i = 0; i < n + 2; i++) {
+		free(bufs[i]);
+		free(saved[i]);
+	}
+	free(ref_p);
+	free(ref_q);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -108,6 +229,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("xor", NULL, NULL);
 
 	CU_ADD_TEST(suite, test_xor_gen);
+	CU_ADD_TEST(suite, test_xor_gen_pq);
 
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
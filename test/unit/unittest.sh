@@ -22,12 +22,15 @@ function unittest_bdev() {
 	$valgrind $testdir/lib/bdev/raid/bdev_raid.c/bdev_raid_ut
 	$valgrind $testdir/lib/bdev/raid/concat.c/concat_ut
 	$valgrind $testdir/lib/bdev/raid/raid1.c/raid1_ut
+	$valgrind $testdir/lib/bdev/raid/raid10.c/raid10_ut
 	$valgrind $testdir/lib/bdev/bdev_zone.c/bdev_zone_ut
 	$valgrind $testdir/lib/bdev/gpt/gpt.c/gpt_ut
 	$valgrind $testdir/lib/bdev/part.c/part_ut
 	$valgrind $testdir/lib/bdev/scsi_nvme.c/scsi_nvme_ut
 	$valgrind $testdir/lib/bdev/vbdev_lvol.c/vbdev_lvol_ut
 	$valgrind $testdir/lib/bdev/vbdev_zone_block.c/vbdev_zone_block_ut
+	$valgrind $testdir/lib/bdev/vbdev_cache.c/vbdev_cache_ut
+	$valgrind $testdir/lib/bdev/bdev_shm.c/bdev_shm_ut
 	$valgrind $testdir/lib/bdev/mt/bdev.c/bdev_ut
 }
 
@@ -38,6 +41,7 @@ function unittest_blob() {
 		$valgrind $testdir/lib/blob/blob.c/blob_ut
 	fi
 	$valgrind $testdir/lib/blob/blob_bdev.c/blob_bdev_ut
+	$valgrind $testdir/lib/blob/esnap_cache.c/esnap_cache_ut
 	$valgrind $testdir/lib/blobfs/tree.c/tree_ut
 	$valgrind $testdir/lib/blobfs/blobfs_async_ut/blobfs_async_ut
 	# blobfs_sync_ut hangs when run under valgrind, so don't use $valgrind
@@ -99,6 +103,7 @@ function unittest_nvme() {
 	$valgrind $testdir/lib/nvme/nvme_pcie_common.c/nvme_pcie_common_ut
 	$valgrind $testdir/lib/nvme/nvme_fabric.c/nvme_fabric_ut
 	$valgrind $testdir/lib/nvme/nvme_opal.c/nvme_opal_ut
+	$valgrind $testdir/lib/nvme/nvme_zns.c/nvme_zns_ut
 }
 
 function unittest_nvmf() {
@@ -140,11 +145,13 @@ function unittest_util() {
 	$valgrind $testdir/lib/util/iov.c/iov_ut
 	$valgrind $testdir/lib/util/math.c/math_ut
 	$valgrind $testdir/lib/util/pipe.c/pipe_ut
+	$valgrind $testdir/lib/util/workload.c/workload_ut
 	$valgrind $testdir/lib/util/xor.c/xor_ut
 }
 
 function unittest_init() {
 	$valgrind $testdir/lib/init/subsystem.c/subsystem_ut
+	$valgrind $testdir/lib/init/json_config.c/json_config_ut
 }
 
 if [ $SPDK_RUN_VALGRIND -eq 1 ] && [ $SPDK_RUN_ASAN -eq 1 ]; then
@@ -237,10 +244,12 @@ run_test "unittest_accel" $valgrind $testdir/lib/accel/accel.c/accel_ut
 run_test "unittest_ioat" $valgrind $testdir/lib/ioat/ioat.c/ioat_ut
 if grep -q '#define SPDK_CONFIG_IDXD 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_idxd_user" $valgrind $testdir/lib/idxd/idxd_user.c/idxd_user_ut
+	run_test "unittest_idxd_huffman" $valgrind $testdir/lib/idxd/idxd_huffman.c/idxd_huffman_ut
 fi
 run_test "unittest_iscsi" unittest_iscsi
 run_test "unittest_json" unittest_json
 run_test "unittest_rpc" unittest_rpc
+run_test "unittest_metrics" $valgrind $testdir/lib/metrics/metrics.c/metrics_ut
 run_test "unittest_notify" $valgrind $testdir/lib/notify/notify.c/notify_ut
 run_test "unittest_nvme" unittest_nvme
 run_test "unittest_log" $valgrind $testdir/lib/log/log.c/log_ut
@@ -277,6 +286,7 @@ if [ $(uname -s) = Linux ]; then
 fi
 run_test "unittest_thread" $valgrind $testdir/lib/thread/thread.c/thread_ut
 run_test "unittest_iobuf" $valgrind $testdir/lib/thread/iobuf.c/iobuf_ut
+run_test "unittest_coroutine" $valgrind $testdir/lib/thread/coroutine.c/coroutine_ut
 run_test "unittest_util" unittest_util
 if grep -q '#define SPDK_CONFIG_VHOST 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_vhost" $valgrind $testdir/lib/vhost/vhost.c/vhost_ut